@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef ADMISSION_LIMITER_H
+#define ADMISSION_LIMITER_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+    typedef struct ADMISSION_LIMITER_INSTANCE_TAG* ADMISSION_LIMITER_HANDLE;
+
+    /* A token bucket holding at most burst tokens, refilled with rate_per_second tokens per second and full when created.
+       Every admission takes one token, so bursts of up to burst arrivals are admitted and a sustained flood is cut down to
+       rate_per_second. It is given to a socket listener (SOCKET_LISTENER_OPTION_ADMISSION_LIMITER), a connection
+       (connection_set_session_admission_limiter) or a session (session_set_link_admission_limiter), which refuse what
+       the limiter does not admit before building anything for it. One limiter can be shared by several of them on one
+       thread. */
+    MOCKABLE_FUNCTION(, ADMISSION_LIMITER_HANDLE, admission_limiter_create, uint32_t, rate_per_second, uint32_t, burst);
+    MOCKABLE_FUNCTION(, void, admission_limiter_destroy, ADMISSION_LIMITER_HANDLE, admission_limiter);
+    /* returns true and takes a token when one is available, false otherwise */
+    MOCKABLE_FUNCTION(, bool, admission_limiter_try_acquire, ADMISSION_LIMITER_HANDLE, admission_limiter);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ADMISSION_LIMITER_H */
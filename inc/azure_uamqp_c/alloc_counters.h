@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef ALLOC_COUNTERS_H
+#define ALLOC_COUNTERS_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define ALLOC_SUBSYSTEM_VALUES \
+    ALLOC_SUBSYSTEM_AMQPVALUE, \
+    ALLOC_SUBSYSTEM_FRAME_CODEC, \
+    ALLOC_SUBSYSTEM_CONNECTION, \
+    ALLOC_SUBSYSTEM_SESSION, \
+    ALLOC_SUBSYSTEM_LINK, \
+    ALLOC_SUBSYSTEM_MESSAGE, \
+    ALLOC_SUBSYSTEM_MESSAGE_SENDER, \
+    ALLOC_SUBSYSTEM_MESSAGE_RECEIVER, \
+    ALLOC_SUBSYSTEM_COUNT
+
+DEFINE_ENUM(ALLOC_SUBSYSTEM, ALLOC_SUBSYSTEM_VALUES)
+
+    typedef struct ALLOC_COUNTERS_TAG
+    {
+        uint64_t allocation_count;
+        uint64_t allocated_bytes;
+        uint64_t free_count;
+    } ALLOC_COUNTERS;
+
+    /* Counters are only kept when the library is built with the alloc_counters CMake option, otherwise
+       alloc_counters_get and alloc_counters_get_total fail. Reallocations count as allocations. */
+    MOCKABLE_FUNCTION(, bool, alloc_counters_are_enabled);
+    MOCKABLE_FUNCTION(, int, alloc_counters_get, ALLOC_SUBSYSTEM, subsystem, ALLOC_COUNTERS*, counters);
+    MOCKABLE_FUNCTION(, int, alloc_counters_get_total, ALLOC_COUNTERS*, counters);
+    MOCKABLE_FUNCTION(, void, alloc_counters_reset);
+
+#define ALLOC_OBJECT_TYPE_VALUES \
+    ALLOC_OBJECT_TYPE_CONNECTION, \
+    ALLOC_OBJECT_TYPE_SESSION, \
+    ALLOC_OBJECT_TYPE_LINK, \
+    ALLOC_OBJECT_TYPE_PENDING_SEND, \
+    ALLOC_OBJECT_TYPE_PENDING_DELIVERY, \
+    ALLOC_OBJECT_TYPE_MESSAGE, \
+    ALLOC_OBJECT_TYPE_VALUE_NODE, \
+    ALLOC_OBJECT_TYPE_FRAME_BUFFER, \
+    ALLOC_OBJECT_TYPE_COUNT
+
+DEFINE_ENUM(ALLOC_OBJECT_TYPE, ALLOC_OBJECT_TYPE_VALUES)
+
+    typedef struct ALLOC_OBJECT_USAGE_TAG
+    {
+        uint64_t live_count;
+        uint64_t live_bytes;
+    } ALLOC_OBJECT_USAGE;
+
+    typedef struct ALLOC_OBJECT_SNAPSHOT_TAG
+    {
+        ALLOC_OBJECT_USAGE usage[ALLOC_OBJECT_TYPE_COUNT];
+    } ALLOC_OBJECT_SNAPSHOT;
+
+    /* The live objects per type, built with the alloc_counters CMake option too, so that the growth of a process can be
+       told apart between its pending sends (message sender), unsettled deliveries (link), decoded messages, AMQP_VALUE
+       nodes and frame buffers (received frames and outgoing batches). The bytes are those of the object itself, or of the
+       buffer for the frame buffers, not of what it refers to: a message does not count its body, which is in value nodes.
+       They are kept with an atomic add per object created or destroyed and are not cleared by alloc_counters_reset. */
+    MOCKABLE_FUNCTION(, int, alloc_counters_get_object_snapshot, ALLOC_OBJECT_SNAPSHOT*, snapshot);
+    MOCKABLE_FUNCTION(, void, alloc_counters_add_object, ALLOC_OBJECT_TYPE, object_type, size_t, size);
+    MOCKABLE_FUNCTION(, void, alloc_counters_remove_object, ALLOC_OBJECT_TYPE, object_type, size_t, size);
+    MOCKABLE_FUNCTION(, void, alloc_counters_resize_object, ALLOC_OBJECT_TYPE, object_type, size_t, old_size, size_t, new_size);
+
+/* the sources account their objects through these, which compile to nothing without the counters */
+#ifdef UAMQP_ALLOC_COUNTERS
+#define ALLOC_COUNTERS_ADD_OBJECT(object_type, size) alloc_counters_add_object((object_type), (size))
+#define ALLOC_COUNTERS_REMOVE_OBJECT(object_type, size) alloc_counters_remove_object((object_type), (size))
+#define ALLOC_COUNTERS_RESIZE_OBJECT(object_type, old_size, new_size) alloc_counters_resize_object((object_type), (old_size), (new_size))
+#else
+#define ALLOC_COUNTERS_ADD_OBJECT(object_type, size) ((void)0)
+#define ALLOC_COUNTERS_REMOVE_OBJECT(object_type, size) ((void)0)
+#define ALLOC_COUNTERS_RESIZE_OBJECT(object_type, old_size, new_size) ((void)0)
+#endif
+
+    MOCKABLE_FUNCTION(, void*, alloc_counters_malloc, ALLOC_SUBSYSTEM, subsystem, size_t, size);
+    MOCKABLE_FUNCTION(, void*, alloc_counters_calloc, ALLOC_SUBSYSTEM, subsystem, size_t, nmemb, size_t, size);
+    MOCKABLE_FUNCTION(, void*, alloc_counters_realloc, ALLOC_SUBSYSTEM, subsystem, void*, ptr, size_t, size);
+    MOCKABLE_FUNCTION(, void, alloc_counters_free, ALLOC_SUBSYSTEM, subsystem, void*, ptr);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ALLOC_COUNTERS_H */
+
+/* A source file attributes its allocations to a subsystem by defining ALLOC_COUNTERS_SUBSYSTEM and including this header
+   after all other headers (gballoc.h included), so that its malloc family calls go through the counters. */
+#if defined(UAMQP_ALLOC_COUNTERS) && defined(ALLOC_COUNTERS_SUBSYSTEM) && !defined(ALLOC_COUNTERS_REDIRECTED)
+#define ALLOC_COUNTERS_REDIRECTED
+
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+#define malloc(size) alloc_counters_malloc(ALLOC_COUNTERS_SUBSYSTEM, (size))
+#define calloc(nmemb, size) alloc_counters_calloc(ALLOC_COUNTERS_SUBSYSTEM, (nmemb), (size))
+#define realloc(ptr, size) alloc_counters_realloc(ALLOC_COUNTERS_SUBSYSTEM, (ptr), (size))
+#define free(ptr) alloc_counters_free(ALLOC_COUNTERS_SUBSYSTEM, (ptr))
+
+#endif
@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef AMQP_CONNECTION_POOL_H
+#define AMQP_CONNECTION_POOL_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/tls_session_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    typedef struct AMQP_CONNECTION_POOL_INSTANCE_TAG* AMQP_CONNECTION_POOL_HANDLE;
+
+    /* Returns the io stack (TLS, SASL, ...) for a new pooled connection, NULL if it cannot be created.
+       The pool owns the returned io and destroys it with the connection. */
+    typedef XIO_HANDLE(*ON_AMQP_CONNECTION_POOL_CREATE_IO)(void* context);
+
+    typedef struct AMQP_CONNECTION_POOL_CONFIG_TAG
+    {
+        const char* hostname;
+        const char* container_id;
+        /* connections the pool keeps open at most, failed connections waiting for their sessions to be released are not counted */
+        size_t max_connections;
+        /* sessions handed out on one connection before the pool opens another one */
+        size_t max_sessions_per_connection;
+        /* NULL to do a full TLS handshake for every connection, otherwise the io options of the last connection opened
+           to hostname are kept in it and set on the io of the next one. The cache is not owned by the pool and can be
+           shared by several pools. */
+        TLS_SESSION_CACHE_HANDLE tls_session_cache;
+    } AMQP_CONNECTION_POOL_CONFIG;
+
+    /* Sessions are handed out on the open connection with the fewest links, then the fewest sessions, that still has
+       room for a session. A connection that fails gets no new sessions and a replacement is opened on the next
+       acquire; its sessions fail through their own state callbacks and have to be released and acquired again.
+       Connections are kept open when their last session is released, so that the next acquire does not pay for a
+       new TLS and SASL handshake. */
+    MOCKABLE_FUNCTION(, AMQP_CONNECTION_POOL_HANDLE, amqp_connection_pool_create, const AMQP_CONNECTION_POOL_CONFIG*, config, ON_AMQP_CONNECTION_POOL_CREATE_IO, on_create_io, void*, on_create_io_context);
+    MOCKABLE_FUNCTION(, void, amqp_connection_pool_destroy, AMQP_CONNECTION_POOL_HANDLE, pool);
+    MOCKABLE_FUNCTION(, SESSION_HANDLE, amqp_connection_pool_acquire_session, AMQP_CONNECTION_POOL_HANDLE, pool, size_t, link_count, ON_LINK_ATTACHED, on_link_attached, void*, callback_context);
+    MOCKABLE_FUNCTION(, int, amqp_connection_pool_release_session, AMQP_CONNECTION_POOL_HANDLE, pool, SESSION_HANDLE, session);
+    MOCKABLE_FUNCTION(, void, amqp_connection_pool_dowork, AMQP_CONNECTION_POOL_HANDLE, pool);
+    MOCKABLE_FUNCTION(, size_t, amqp_connection_pool_get_connection_count, AMQP_CONNECTION_POOL_HANDLE, pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* AMQP_CONNECTION_POOL_H */
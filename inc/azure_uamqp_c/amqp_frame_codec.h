@@ -11,6 +11,7 @@ extern "C" {
 #else
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #endif /* __cplusplus */
 #include "azure_uamqp_c/frame_codec.h"
 
@@ -28,12 +29,19 @@ extern "C" {
 
 typedef struct AMQP_FRAME_CODEC_INSTANCE_TAG* AMQP_FRAME_CODEC_HANDLE;
 typedef void(*AMQP_EMPTY_FRAME_RECEIVED_CALLBACK)(void* context, uint16_t channel);
-typedef void(*AMQP_FRAME_RECEIVED_CALLBACK)(void* context, uint16_t channel, AMQP_VALUE performative, const unsigned char* payload_bytes, uint32_t frame_payload_size);
+/* performative_code is the already validated descriptor of the performative (AMQP_OPEN to AMQP_CLOSE) */
+typedef void(*AMQP_FRAME_RECEIVED_CALLBACK)(void* context, uint16_t channel, AMQP_VALUE performative, uint64_t performative_code, const unsigned char* payload_bytes, uint32_t frame_payload_size);
 typedef void(*AMQP_FRAME_CODEC_ERROR_CALLBACK)(void* context);
+/* performative_bytes are the encoded performative as received or sent, valid only during the call */
+typedef void(*ON_AMQP_PERFORMATIVE_BYTES)(void* context, bool is_outgoing, uint16_t channel, const unsigned char* performative_bytes, size_t performative_size, uint32_t payload_size);
 
 MOCKABLE_FUNCTION(, AMQP_FRAME_CODEC_HANDLE, amqp_frame_codec_create, FRAME_CODEC_HANDLE, frame_codec, AMQP_FRAME_RECEIVED_CALLBACK, frame_received_callback, AMQP_EMPTY_FRAME_RECEIVED_CALLBACK, empty_frame_received_callback, AMQP_FRAME_CODEC_ERROR_CALLBACK, amqp_frame_codec_error_callback, void*, callback_context);
 MOCKABLE_FUNCTION(, void, amqp_frame_codec_destroy, AMQP_FRAME_CODEC_HANDLE, amqp_frame_codec);
+/* bounds the performatives decoded by amqp_frame_codec, see amqpvalue_decoder_set_limits; 0 means no limit */
+MOCKABLE_FUNCTION(, int, amqp_frame_codec_set_on_performative_bytes, AMQP_FRAME_CODEC_HANDLE, amqp_frame_codec, ON_AMQP_PERFORMATIVE_BYTES, on_performative_bytes, void*, context);
+MOCKABLE_FUNCTION(, int, amqp_frame_codec_set_decoder_limits, AMQP_FRAME_CODEC_HANDLE, amqp_frame_codec, uint32_t, max_depth, size_t, max_element_count, size_t, max_allocated_bytes);
 MOCKABLE_FUNCTION(, int, amqp_frame_codec_encode_frame, AMQP_FRAME_CODEC_HANDLE, amqp_frame_codec, uint16_t, channel, AMQP_VALUE, performative, const PAYLOAD*, payloads, size_t, payload_count, ON_BYTES_ENCODED, on_bytes_encoded, void*, callback_context);
+MOCKABLE_FUNCTION(, int, amqp_frame_codec_encode_frame_with_encoded_performative, AMQP_FRAME_CODEC_HANDLE, amqp_frame_codec, uint16_t, channel, const unsigned char*, performative_bytes, size_t, performative_size, const PAYLOAD*, payloads, size_t, payload_count, ON_BYTES_ENCODED, on_bytes_encoded, void*, callback_context);
 MOCKABLE_FUNCTION(, int, amqp_frame_codec_encode_empty_frame, AMQP_FRAME_CODEC_HANDLE, amqp_frame_codec, uint16_t, channel, ON_BYTES_ENCODED, on_bytes_encoded, void*, callback_context);
 
 #ifdef __cplusplus
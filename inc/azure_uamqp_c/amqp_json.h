@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef AMQP_JSON_H
+#define AMQP_JSON_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    /* Transcoding between one encoded AMQP value and JSON text, straight from the bytes with the AMQP reader and straight to
+       the bytes with the AMQP writer, without AMQP_VALUEs being created. Both write into a caller buffer and fail when it is
+       too small, the JSON text written not being NUL terminated.
+
+       AMQP to JSON: lists and arrays become arrays and maps become objects, keys that are not strings or symbols being written
+       as strings (a key that is a list, map or array fails). Numbers, timestamps (in ms) included, become numbers, with NaN and
+       infinities written as null. Symbols, uuids and chars become strings and binaries become base64 strings. Described values
+       are written as their value, without their descriptor. Decimals cannot be written.
+
+       JSON to AMQP: objects become maps with string keys, arrays become lists, integers become longs (ulongs when they only fit
+       in one), other numbers become doubles, strings become strings, true and false become booleans and null becomes null.
+       Nesting is limited to AMQP_WRITER_MAX_DEPTH arrays and objects. */
+    MOCKABLE_FUNCTION(, int, amqp_json_from_amqp, const unsigned char*, bytes, size_t, length, char*, json, size_t, json_size, size_t*, json_length);
+    MOCKABLE_FUNCTION(, int, amqp_json_to_amqp, const char*, json, size_t, json_length, unsigned char*, buffer, size_t, buffer_size, size_t*, encoded_length);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* AMQP_JSON_H */
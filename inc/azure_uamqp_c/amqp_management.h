@@ -6,8 +6,10 @@
 
 #include <stdbool.h>
 #include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/session.h"
 #include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/timer_wheel.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,7 +21,8 @@ extern "C" {
     AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, \
     AMQP_MANAGEMENT_EXECUTE_OPERATION_ERROR, \
     AMQP_MANAGEMENT_EXECUTE_OPERATION_FAILED_BAD_STATUS, \
-    AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED
+    AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED, \
+    AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT
 
 DEFINE_ENUM(AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT_VALUES)
 
@@ -31,6 +34,7 @@ DEFINE_ENUM(AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT, AMQP_MANAGEMENT_EXECUTE_OP
 DEFINE_ENUM(AMQP_MANAGEMENT_OPEN_RESULT, AMQP_MANAGEMENT_OPEN_RESULT_VALUES)
 
     typedef struct AMQP_MANAGEMENT_INSTANCE_TAG* AMQP_MANAGEMENT_HANDLE;
+    typedef struct AMQP_MANAGEMENT_PREPARED_OPERATION_INSTANCE_TAG* AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE;
     typedef void(*ON_AMQP_MANAGEMENT_OPEN_COMPLETE)(void* context, AMQP_MANAGEMENT_OPEN_RESULT open_result);
     typedef void(*ON_AMQP_MANAGEMENT_ERROR)(void* context);
     typedef void(*ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE)(void* context, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result, unsigned int status_code, const char* status_description, MESSAGE_HANDLE message_handle);
@@ -43,6 +47,14 @@ DEFINE_ENUM(AMQP_MANAGEMENT_OPEN_RESULT, AMQP_MANAGEMENT_OPEN_RESULT_VALUES)
     MOCKABLE_FUNCTION(, void, amqp_management_set_trace, AMQP_MANAGEMENT_HANDLE, amqp_management, bool, trace_on);
     MOCKABLE_FUNCTION(, int, amqp_management_set_override_status_code_key_name, AMQP_MANAGEMENT_HANDLE, amqp_management, const char*, override_status_code_key_name);
     MOCKABLE_FUNCTION(, int, amqp_management_set_override_status_description_key_name, AMQP_MANAGEMENT_HANDLE, amqp_management, const char*, override_status_description_key_name);
+    MOCKABLE_FUNCTION(, int, amqp_management_set_operation_timeout, AMQP_MANAGEMENT_HANDLE, amqp_management, TIMER_WHEEL_HANDLE, timer_wheel, TICK_COUNTER_HANDLE, tick_counter, uint32_t, operation_timeout_ms);
+    MOCKABLE_FUNCTION(, int, amqp_management_set_max_outstanding_operations, AMQP_MANAGEMENT_HANDLE, amqp_management, size_t, max_outstanding_operations);
+    /* A prepared operation encodes the application properties of its requests (operation, type, locales and the pairs of the
+       optional application_properties map, e.g. the name of a CBS token) once, instead of with every request. Requests that
+       have application properties of their own get the prepared pairs merged in and are encoded in full. */
+    MOCKABLE_FUNCTION(, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, amqp_management_prepare_operation, const char*, operation, const char*, type, const char*, locales, AMQP_VALUE, application_properties);
+    MOCKABLE_FUNCTION(, void, amqp_management_destroy_prepared_operation, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, prepared_operation);
+    MOCKABLE_FUNCTION(, int, amqp_management_execute_prepared_operation_async, AMQP_MANAGEMENT_HANDLE, amqp_management, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, prepared_operation, MESSAGE_HANDLE, message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE, on_execute_operation_complete, void*, context);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef AMQP_MANAGEMENT_MUX_H
+#define AMQP_MANAGEMENT_MUX_H
+
+#include <stdbool.h>
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/amqp_management.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+    /* One AMQP management link pair and correlation table shared by many logical management clients.
+       Create one per connection and management node, on any session of the connection. */
+    typedef struct AMQP_MANAGEMENT_MUX_INSTANCE_TAG* AMQP_MANAGEMENT_MUX_HANDLE;
+    typedef struct AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE_TAG* AMQP_MANAGEMENT_MUX_CLIENT_HANDLE;
+
+    MOCKABLE_FUNCTION(, AMQP_MANAGEMENT_MUX_HANDLE, amqp_management_mux_create, SESSION_HANDLE, session, const char*, management_node);
+    MOCKABLE_FUNCTION(, void, amqp_management_mux_destroy, AMQP_MANAGEMENT_MUX_HANDLE, amqp_management_mux);
+    MOCKABLE_FUNCTION(, void, amqp_management_mux_set_trace, AMQP_MANAGEMENT_MUX_HANDLE, amqp_management_mux, bool, trace_on);
+    MOCKABLE_FUNCTION(, int, amqp_management_mux_set_override_status_code_key_name, AMQP_MANAGEMENT_MUX_HANDLE, amqp_management_mux, const char*, override_status_code_key_name);
+    MOCKABLE_FUNCTION(, int, amqp_management_mux_set_override_status_description_key_name, AMQP_MANAGEMENT_MUX_HANDLE, amqp_management_mux, const char*, override_status_description_key_name);
+
+    MOCKABLE_FUNCTION(, AMQP_MANAGEMENT_MUX_CLIENT_HANDLE, amqp_management_mux_client_create, AMQP_MANAGEMENT_MUX_HANDLE, amqp_management_mux);
+    MOCKABLE_FUNCTION(, void, amqp_management_mux_client_destroy, AMQP_MANAGEMENT_MUX_CLIENT_HANDLE, client);
+    MOCKABLE_FUNCTION(, int, amqp_management_mux_client_open_async, AMQP_MANAGEMENT_MUX_CLIENT_HANDLE, client, ON_AMQP_MANAGEMENT_OPEN_COMPLETE, on_amqp_management_open_complete, void*, on_amqp_management_open_complete_context, ON_AMQP_MANAGEMENT_ERROR, on_amqp_management_error, void*, on_amqp_management_error_context);
+    MOCKABLE_FUNCTION(, int, amqp_management_mux_client_close, AMQP_MANAGEMENT_MUX_CLIENT_HANDLE, client);
+    MOCKABLE_FUNCTION(, int, amqp_management_mux_client_execute_operation_async, AMQP_MANAGEMENT_MUX_CLIENT_HANDLE, client, const char*, operation, const char*, type, const char*, locales, MESSAGE_HANDLE, message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE, on_execute_operation_complete, void*, context);
+    MOCKABLE_FUNCTION(, int, amqp_management_mux_client_execute_prepared_operation_async, AMQP_MANAGEMENT_MUX_CLIENT_HANDLE, client, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, prepared_operation, MESSAGE_HANDLE, message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE, on_execute_operation_complete, void*, context);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* AMQP_MANAGEMENT_MUX_H */
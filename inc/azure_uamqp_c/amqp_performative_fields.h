@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef AMQP_PERFORMATIVE_FIELDS_H
+#define AMQP_PERFORMATIVE_FIELDS_H
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdint.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+    /* Plain struct views of the performatives that are received for every delivery.
+       Filling a view reads the fields in place from the decoded performative, without creating
+       a composite handle or cloning any item. Binary and AMQP_VALUE fields point into the
+       performative, so a view is only valid for as long as the performative it was read from.
+       Optional fields without a default in the AMQP specification have a matching has_ flag. */
+    typedef struct TRANSFER_FIELDS_TAG
+    {
+        uint32_t handle;
+        delivery_number delivery_id;
+        amqp_binary delivery_tag;
+        message_format message_format;
+        bool settled;
+        bool more;
+        receiver_settle_mode rcv_settle_mode;
+        AMQP_VALUE state;
+        bool resume;
+        bool aborted;
+        bool batchable;
+        bool has_delivery_id;
+        bool has_delivery_tag;
+        bool has_message_format;
+        bool has_settled;
+        bool has_rcv_settle_mode;
+    } TRANSFER_FIELDS;
+
+    typedef struct FLOW_FIELDS_TAG
+    {
+        transfer_number next_incoming_id;
+        uint32_t incoming_window;
+        transfer_number next_outgoing_id;
+        uint32_t outgoing_window;
+        uint32_t handle;
+        sequence_no delivery_count;
+        uint32_t link_credit;
+        uint32_t available;
+        bool drain;
+        bool echo;
+        AMQP_VALUE properties;
+        bool has_next_incoming_id;
+        bool has_handle;
+        bool has_delivery_count;
+        bool has_link_credit;
+        bool has_available;
+    } FLOW_FIELDS;
+
+    typedef struct DISPOSITION_FIELDS_TAG
+    {
+        bool role;
+        delivery_number first;
+        delivery_number last;
+        bool settled;
+        AMQP_VALUE state;
+        bool batchable;
+        bool has_last;
+    } DISPOSITION_FIELDS;
+
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_transfer_fields, AMQP_VALUE, value, TRANSFER_FIELDS*, transfer_fields);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_flow_fields, AMQP_VALUE, value, FLOW_FIELDS*, flow_fields);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_disposition_fields, AMQP_VALUE, value, DISPOSITION_FIELDS*, disposition_fields);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* AMQP_PERFORMATIVE_FIELDS_H */
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef AMQP_SERVER_H
+#define AMQP_SERVER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/admission_limiter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    typedef struct AMQP_SERVER_INSTANCE_TAG* AMQP_SERVER_HANDLE;
+
+    /* All callbacks run on the worker thread owning the connection: sessions and links created from them belong to
+       that thread and are driven by its reactor. on_connection_created returns the context given to the other two
+       callbacks for that connection (callback_context when on_connection_created is NULL). on_connection_closed is the
+       last chance to destroy the sessions and links, the connection is destroyed right after it returns. */
+    typedef void*(*ON_AMQP_SERVER_CONNECTION_CREATED)(void* context, CONNECTION_HANDLE connection, size_t worker_index);
+    typedef bool(*ON_AMQP_SERVER_NEW_SESSION_ENDPOINT)(void* connection_context, CONNECTION_HANDLE connection, ENDPOINT_HANDLE new_endpoint);
+    typedef void(*ON_AMQP_SERVER_CONNECTION_CLOSED)(void* connection_context, CONNECTION_HANDLE connection);
+
+    typedef struct AMQP_SERVER_CONFIG_TAG
+    {
+        int port;
+        /* NULL to listen on port over TCP, otherwise the path of the Unix domain socket to listen on (see socketlistener_create_unix) */
+        const char* unix_socket_path;
+        /* number of worker threads, each running a reactor with its share of the connections */
+        size_t worker_count;
+        /* listen backlog, 0 for the socket listener default */
+        int backlog;
+        /* lets several servers (for example one per process) share the port */
+        bool reuse_port;
+        /* NULL, or refuses the accepted sockets it does not admit before they reach a worker (see
+           SOCKET_LISTENER_OPTION_ADMISSION_LIMITER); it is used from the thread calling amqp_server_dowork */
+        ADMISSION_LIMITER_HANDLE connection_admission_limiter;
+        /* NULL leaves the worker threads to the scheduler, otherwise worker_count CPUs, worker i being pinned to
+           worker_cpus[i] (-1 leaving that worker unpinned). The array is not kept. */
+        const int* worker_cpus;
+        /* a pinned worker allocates from the NUMA node of its CPU (MPOL_LOCAL), so that its frame buffers, value nodes and
+           messages are local to it */
+        bool numa_local_memory;
+        /* an accepted socket goes to the least loaded worker pinned on the NUMA node of the CPU its packets are received
+           on (SO_INCOMING_CPU, the node of the NIC queue), or to the least loaded of all the workers when none is */
+        bool steer_to_numa_node;
+        /* 0 receives the frames in heap buffers, otherwise each worker has a buffer pool of receive_buffer_count buffers
+           of receive_buffer_size bytes shared by its connections (bigger frames still go to the heap), backed by huge
+           pages when receive_buffers_on_huge_pages is true and they can be had (see buffer_pool.h) */
+        size_t receive_buffer_count;
+        size_t receive_buffer_size;
+        bool receive_buffers_on_huge_pages;
+        const char* container_id;
+        ON_AMQP_SERVER_CONNECTION_CREATED on_connection_created;
+        ON_AMQP_SERVER_NEW_SESSION_ENDPOINT on_new_session_endpoint;
+        ON_AMQP_SERVER_CONNECTION_CLOSED on_connection_closed;
+        void* callback_context;
+    } AMQP_SERVER_CONFIG;
+
+    /* amqp_server_dowork accepts the pending connections and hands each one to the least loaded worker, where the
+       header_detect_io and connection stack is built. It is called from the application thread that started the server. */
+    MOCKABLE_FUNCTION(, AMQP_SERVER_HANDLE, amqp_server_create, const AMQP_SERVER_CONFIG*, config);
+    MOCKABLE_FUNCTION(, void, amqp_server_destroy, AMQP_SERVER_HANDLE, server);
+    MOCKABLE_FUNCTION(, int, amqp_server_start, AMQP_SERVER_HANDLE, server);
+    MOCKABLE_FUNCTION(, int, amqp_server_stop, AMQP_SERVER_HANDLE, server);
+    MOCKABLE_FUNCTION(, void, amqp_server_dowork, AMQP_SERVER_HANDLE, server);
+    MOCKABLE_FUNCTION(, size_t, amqp_server_get_connection_count, AMQP_SERVER_HANDLE, server);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* AMQP_SERVER_H */
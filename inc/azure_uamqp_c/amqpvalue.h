@@ -22,6 +22,8 @@ extern "C" {
     typedef unsigned char uuid[16];
     typedef int64_t timestamp;
 
+    typedef void(*ON_AMQPVALUE_RECLAIM)(void* context, AMQP_VALUE value);
+
     typedef struct amqp_binary_TAG
     {
         const void* bytes;
@@ -62,31 +64,153 @@ extern "C" {
     MOCKABLE_FUNCTION(, int, amqpvalue_get_binary, AMQP_VALUE, value, amqp_binary*, binary_value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_string, const char*, string_value);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_string, AMQP_VALUE, value, const char**, string_value);
+    /* length characters that need not be zero terminated and may include NULs; the value keeps a terminator after them */
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_string_n, const char*, string_value, size_t, length);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_string_n, AMQP_VALUE, value, const char**, string_value, size_t*, length);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_symbol, const char*, symbol_value);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_symbol, AMQP_VALUE, value, const char**, symbol_value);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_binary_borrowed, amqp_binary, binary_value);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_string_borrowed, const char*, string_value);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_symbol_borrowed, const char*, symbol_value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_list);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_list_with_capacity, uint32_t, capacity);
     MOCKABLE_FUNCTION(, int, amqpvalue_set_list_item_count, AMQP_VALUE, list, uint32_t, count);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_list_item_count, AMQP_VALUE, list, uint32_t*, count);
     MOCKABLE_FUNCTION(, int, amqpvalue_set_list_item, AMQP_VALUE, list, uint32_t, index, AMQP_VALUE, list_item_value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_list_item, AMQP_VALUE, list, size_t, index);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_map);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_map_with_capacity, uint32_t, capacity);
     MOCKABLE_FUNCTION(, int, amqpvalue_set_map_value, AMQP_VALUE, map, AMQP_VALUE, key, AMQP_VALUE, value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_map_value, AMQP_VALUE, map, AMQP_VALUE, key);
+    /* Same as amqpvalue_get_map_value and amqpvalue_set_map_value for string and symbol keys, comparing against the
+       characters of key directly instead of needing an AMQP value for it. A setter only creates the key when it adds a pair. */
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_map_value_by_string, AMQP_VALUE, map, const char*, key);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_map_value_by_symbol, AMQP_VALUE, map, const char*, key);
+    MOCKABLE_FUNCTION(, int, amqpvalue_set_map_value_by_string, AMQP_VALUE, map, const char*, key, AMQP_VALUE, value);
+    MOCKABLE_FUNCTION(, int, amqpvalue_set_map_value_by_symbol, AMQP_VALUE, map, const char*, key, AMQP_VALUE, value);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_map_pair_count, AMQP_VALUE, map, uint32_t*, pair_count);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_map_key_value_pair, AMQP_VALUE, map, uint32_t, index, AMQP_VALUE*, key, AMQP_VALUE*, value);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_map, AMQP_VALUE, from_value, AMQP_VALUE*, map);
     MOCKABLE_FUNCTION(, AMQP_TYPE, amqpvalue_get_type, AMQP_VALUE, value);
 
     MOCKABLE_FUNCTION(, void, amqpvalue_destroy, AMQP_VALUE, value);
+    /* Lists, maps and arrays of at least min_item_count items are not freed by the amqpvalue_destroy dropping their last
+       reference but passed to on_reclaim, for example to be queued to a thread that frees them with amqpvalue_reclaim,
+       so that the io thread does not pay for freeing big messages. Reference counts are atomic and a value is freed by
+       the thread that drops its last reference, so the values of such a tree may still be shared with values used on other
+       threads, each thread owning the references it drops. Process wide and not synchronized, set it before values are
+       destroyed. */
+    MOCKABLE_FUNCTION(, int, amqpvalue_set_reclaimer, uint32_t, min_item_count, ON_AMQPVALUE_RECLAIM, on_reclaim, void*, context);
+    MOCKABLE_FUNCTION(, void, amqpvalue_reclaim, AMQP_VALUE, value);
+    /* Frees the value nodes the calling thread keeps for reuse when the library is built with the value_node_cache
+       option, does nothing otherwise. Threads that create or destroy values call it before they exit. */
+    MOCKABLE_FUNCTION(, void, amqpvalue_free_thread_node_cache);
 
     MOCKABLE_FUNCTION(, bool, amqpvalue_are_equal, AMQP_VALUE, value1, AMQP_VALUE, value2);
+    MOCKABLE_FUNCTION(, uint32_t, amqpvalue_hash, AMQP_VALUE, value);
+    MOCKABLE_FUNCTION(, int, amqpvalue_compare, AMQP_VALUE, value1, AMQP_VALUE, value2);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_clone, AMQP_VALUE, value);
+    MOCKABLE_FUNCTION(, int, amqpvalue_make_writable, AMQP_VALUE*, value);
 
     /* encoding */
     typedef int (*AMQPVALUE_ENCODER_OUTPUT)(void* context, const unsigned char* bytes, size_t length);
 
     MOCKABLE_FUNCTION(, int, amqpvalue_encode, AMQP_VALUE, value, AMQPVALUE_ENCODER_OUTPUT, encoder_output, void*, context);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_encoded_size, AMQP_VALUE, value, size_t*, encoded_size);
+    MOCKABLE_FUNCTION(, int, amqpvalue_encode_to_buffer, AMQP_VALUE, value, unsigned char*, buffer, size_t, buffer_size, size_t*, encoded_size);
+
+    /* streaming writer, encoding straight into a buffer without building AMQP_VALUE trees */
+#define AMQP_WRITER_MAX_DEPTH 8
+
+    /* Owned by the caller, usually on the stack, and only touched through the amqp_writer functions. Lists and maps are
+       always written with their 32 bit encodings so that their size and count can be filled in when they end. */
+    typedef struct AMQP_WRITER_TAG
+    {
+        unsigned char* buffer;
+        size_t buffer_size;
+        size_t position;
+        /* offset of the constructor and number of items of every list or map that was begun and not ended yet */
+        size_t container_offsets[AMQP_WRITER_MAX_DEPTH];
+        uint32_t container_item_counts[AMQP_WRITER_MAX_DEPTH];
+        size_t depth;
+        bool is_described_value_pending;
+        bool is_failed;
+    } AMQP_WRITER;
+
+    MOCKABLE_FUNCTION(, int, amqp_writer_init, AMQP_WRITER*, writer, unsigned char*, buffer, size_t, buffer_size);
+    MOCKABLE_FUNCTION(, int, amqp_writer_begin_list, AMQP_WRITER*, writer);
+    MOCKABLE_FUNCTION(, int, amqp_writer_begin_map, AMQP_WRITER*, writer);
+    /* the next value, list or map written is the described value, e.g. the fields list of a performative */
+    MOCKABLE_FUNCTION(, int, amqp_writer_begin_described, AMQP_WRITER*, writer, uint64_t, descriptor);
+    MOCKABLE_FUNCTION(, int, amqp_writer_end, AMQP_WRITER*, writer);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_null, AMQP_WRITER*, writer);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_boolean, AMQP_WRITER*, writer, bool, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_ubyte, AMQP_WRITER*, writer, unsigned char, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_uint, AMQP_WRITER*, writer, uint32_t, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_ulong, AMQP_WRITER*, writer, uint64_t, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_int, AMQP_WRITER*, writer, int32_t, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_long, AMQP_WRITER*, writer, int64_t, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_timestamp, AMQP_WRITER*, writer, timestamp, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_double, AMQP_WRITER*, writer, double, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_string, AMQP_WRITER*, writer, const char*, value);
+    /* length characters, not NUL terminated */
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_string_n, AMQP_WRITER*, writer, const char*, value, size_t, length);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_symbol, AMQP_WRITER*, writer, const char*, value);
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_binary, AMQP_WRITER*, writer, const void*, bytes, uint32_t, length);
+    /* for the parts that already are AMQP_VALUEs */
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_value, AMQP_WRITER*, writer, AMQP_VALUE, value);
+    /* count values already encoded, e.g. kept from an earlier encoding, copied as they are */
+    MOCKABLE_FUNCTION(, int, amqp_writer_put_encoded, AMQP_WRITER*, writer, const unsigned char*, bytes, size_t, length, uint32_t, count);
+    MOCKABLE_FUNCTION(, int, amqp_writer_get_length, AMQP_WRITER*, writer, size_t*, length);
+
+    /* pull reader, walking encoded bytes without decoding them into AMQP_VALUEs and without allocating */
+#define AMQP_READER_MAX_DEPTH 16
+
+    typedef struct AMQP_READER_ITEM_TAG
+    {
+        /* AMQP_TYPE_UNKNOWN for the decimal types and unknown constructors, which are only given as bytes */
+        AMQP_TYPE type;
+        unsigned char constructor;
+        /* borrowed from the buffer given to amqp_reader_init, the bytes after the constructor and size: the characters,
+           not NUL terminated, of a string or symbol, the bytes of a binary or uuid, or the items of a list, map, array
+           or described value */
+        const unsigned char* bytes;
+        uint32_t length;
+        /* items of a list, map (keys and values both counted) or array, 2 for a described value */
+        uint32_t count;
+        union
+        {
+            bool bool_value;
+            /* ubyte, ushort, uint, ulong and char */
+            uint64_t unsigned_value;
+            /* byte, short, int, long and timestamp */
+            int64_t signed_value;
+            float float_value;
+            double double_value;
+        } value;
+    } AMQP_READER_ITEM;
+
+    /* Owned by the caller like AMQP_WRITER. amqp_reader_next returns the next item of the innermost container entered and
+       moves past it, a list, map, array or described value being skipped as a whole unless it is entered with
+       amqp_reader_enter right after. amqp_reader_leave skips whatever is left of the container. */
+    typedef struct AMQP_READER_TAG
+    {
+        const unsigned char* buffer;
+        size_t buffer_size;
+        size_t position;
+        /* end offset, items left and, for arrays, the constructor shared by the items of every container entered */
+        size_t container_ends[AMQP_READER_MAX_DEPTH];
+        uint32_t container_items_left[AMQP_READER_MAX_DEPTH];
+        unsigned char container_item_constructors[AMQP_READER_MAX_DEPTH];
+        bool container_is_array[AMQP_READER_MAX_DEPTH];
+        size_t depth;
+    } AMQP_READER;
+
+    MOCKABLE_FUNCTION(, int, amqp_reader_init, AMQP_READER*, reader, const unsigned char*, buffer, size_t, buffer_size);
+    MOCKABLE_FUNCTION(, bool, amqp_reader_has_next, AMQP_READER*, reader);
+    MOCKABLE_FUNCTION(, int, amqp_reader_next, AMQP_READER*, reader, AMQP_READER_ITEM*, item);
+    MOCKABLE_FUNCTION(, int, amqp_reader_enter, AMQP_READER*, reader, const AMQP_READER_ITEM*, item);
+    MOCKABLE_FUNCTION(, int, amqp_reader_leave, AMQP_READER*, reader);
 
     /* decoding */
     typedef struct AMQPVALUE_DECODER_HANDLE_DATA_TAG* AMQPVALUE_DECODER_HANDLE;
@@ -94,20 +218,54 @@ extern "C" {
 
     MOCKABLE_FUNCTION(, AMQPVALUE_DECODER_HANDLE, amqpvalue_decoder_create, ON_VALUE_DECODED, on_value_decoded, void*, callback_context);
     MOCKABLE_FUNCTION(, void, amqpvalue_decoder_destroy, AMQPVALUE_DECODER_HANDLE, handle);
+    MOCKABLE_FUNCTION(, int, amqpvalue_decoder_reset, AMQPVALUE_DECODER_HANDLE, handle);
     MOCKABLE_FUNCTION(, int, amqpvalue_decode_bytes, AMQPVALUE_DECODER_HANDLE, handle, const unsigned char*, buffer, size_t, size);
+    MOCKABLE_FUNCTION(, int, amqpvalue_decode_one, AMQPVALUE_DECODER_HANDLE, handle, const unsigned char*, buffer, size_t, size, size_t*, used_bytes);
+    MOCKABLE_FUNCTION(, int, amqpvalue_decoder_set_borrow_binaries, AMQPVALUE_DECODER_HANDLE, handle, bool, borrow_binaries);
+    MOCKABLE_FUNCTION(, int, amqpvalue_decoder_set_lazy_lists, AMQPVALUE_DECODER_HANDLE, handle, bool, lazy_lists);
+    MOCKABLE_FUNCTION(, int, amqpvalue_decoder_set_validate_strings, AMQPVALUE_DECODER_HANDLE, handle, bool, validate_strings);
+    /* Bounds the cost of decoding untrusted bytes: nesting depth, items declared by lists, maps and arrays and bytes allocated,
+       all counted per top level value. 0 means no limit, which is the default. */
+    MOCKABLE_FUNCTION(, int, amqpvalue_decoder_set_limits, AMQPVALUE_DECODER_HANDLE, handle, uint32_t, max_depth, size_t, max_element_count, size_t, max_allocated_bytes);
+
+    /* scanning encoded values without decoding them */
+    typedef void(*ON_DESCRIBED_VALUE_SCANNED)(void* context, uint64_t descriptor_code, const unsigned char* encoded_bytes, size_t encoded_size);
+
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_encoded_value_size, const unsigned char*, bytes, size_t, size, size_t*, encoded_value_size);
+    MOCKABLE_FUNCTION(, int, amqpvalue_scan_described_values, const unsigned char*, bytes, size_t, size, ON_DESCRIBED_VALUE_SCANNED, on_described_value_scanned, void*, callback_context);
+
+    /* arena allocation of decoded values */
+    typedef struct AMQPVALUE_ARENA_TAG* AMQPVALUE_ARENA_HANDLE;
+
+    MOCKABLE_FUNCTION(, AMQPVALUE_ARENA_HANDLE, amqpvalue_arena_create, size_t, block_size);
+    MOCKABLE_FUNCTION(, void, amqpvalue_arena_reset, AMQPVALUE_ARENA_HANDLE, arena);
+    MOCKABLE_FUNCTION(, void, amqpvalue_arena_destroy, AMQPVALUE_ARENA_HANDLE, arena);
+    MOCKABLE_FUNCTION(, int, amqpvalue_decoder_set_arena, AMQPVALUE_DECODER_HANDLE, handle, AMQPVALUE_ARENA_HANDLE, arena);
 
     /* misc for now */
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_array);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_array_with_capacity, uint32_t, capacity);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_array_item_count, AMQP_VALUE, value, uint32_t*, count);
     MOCKABLE_FUNCTION(, int, amqpvalue_add_array_item, AMQP_VALUE, value, AMQP_VALUE, array_item_value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_array_item, AMQP_VALUE, value, uint32_t, index);
     MOCKABLE_FUNCTION(, int, amqpvalue_get_array, AMQP_VALUE, value, AMQP_VALUE*, array_value);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_array_from_span, AMQP_TYPE, item_type, const void*, items, uint32_t, count);
+    /* packing is a change of the array, reading a packed or an unpacked array never packs or unpacks it */
+    MOCKABLE_FUNCTION(, int, amqpvalue_pack_array, AMQP_VALUE, value, AMQP_TYPE, item_type);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_array_span, AMQP_VALUE, value, AMQP_TYPE, item_type, const void**, items, uint32_t*, count);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_array_int_span, AMQP_VALUE, value, const int32_t**, items, uint32_t*, count);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_array_uint_span, AMQP_VALUE, value, const uint32_t**, items, uint32_t*, count);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_array_long_span, AMQP_VALUE, value, const int64_t**, items, uint32_t*, count);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_array_ulong_span, AMQP_VALUE, value, const uint64_t**, items, uint32_t*, count);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_array_float_span, AMQP_VALUE, value, const float**, items, uint32_t*, count);
+    MOCKABLE_FUNCTION(, int, amqpvalue_get_array_double_span, AMQP_VALUE, value, const double**, items, uint32_t*, count);
 
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_inplace_descriptor, AMQP_VALUE, value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_inplace_described_value, AMQP_VALUE, value);
 
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_composite, AMQP_VALUE, descriptor, uint32_t, list_size);
     MOCKABLE_FUNCTION(, int, amqpvalue_set_composite_item, AMQP_VALUE, value, uint32_t, index, AMQP_VALUE, item_value);
+    MOCKABLE_FUNCTION(, int, amqpvalue_set_composite_item_move, AMQP_VALUE, value, uint32_t, index, AMQP_VALUE, item_value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_get_composite_item, AMQP_VALUE, value, size_t, index);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_described, AMQP_VALUE, descriptor, AMQP_VALUE, value);
     MOCKABLE_FUNCTION(, AMQP_VALUE, amqpvalue_create_composite_with_ulong_descriptor, uint64_t, descriptor);
@@ -2,6 +2,13 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #ifndef AMQPVALUE_TO_STRING_H
+#define AMQPVALUE_TO_STRING_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
 
 #include "azure_uamqp_c/amqpvalue.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
@@ -11,6 +18,9 @@ extern "C" {
 #endif /* __cplusplus */
 
     MOCKABLE_FUNCTION(, char*, amqpvalue_to_string, AMQP_VALUE, amqp_value);
+    /* Same as amqpvalue_to_string, but produces at most max_length characters; a truncated string ends with "...".
+       max_length shall be at least 1. Below 3 a truncated string is made only of the dots that fit ("." or ".."). */
+    MOCKABLE_FUNCTION(, char*, amqpvalue_to_string_n, AMQP_VALUE, amqp_value, size_t, max_length);
 
 #ifdef __cplusplus
 }
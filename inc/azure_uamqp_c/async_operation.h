@@ -16,6 +16,7 @@ extern "C" {
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 typedef struct ASYNC_OPERATION_INSTANCE_TAG* ASYNC_OPERATION_HANDLE;
+typedef struct ASYNC_OPERATION_POOL_INSTANCE_TAG* ASYNC_OPERATION_POOL_HANDLE;
 
 typedef void(*ASYNC_OPERATION_CANCEL_HANDLER_FUNC)(ASYNC_OPERATION_HANDLE async_operation);
 
@@ -32,10 +33,20 @@ typedef struct C3(ASYNC_OPERATION_CONTEXT_STRUCT_, type, _TAG) \
 #define CREATE_ASYNC_OPERATION(type, async_operation_cancel_handler) \
     async_operation_create(async_operation_cancel_handler, sizeof(C2(ASYNC_OPERATION_CONTEXT_STRUCT_, type)))
 
+#define CREATE_ASYNC_OPERATION_POOL(type, max_free_count) \
+    async_operation_pool_create(sizeof(C2(ASYNC_OPERATION_CONTEXT_STRUCT_, type)), max_free_count)
+
 MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, async_operation_create, ASYNC_OPERATION_CANCEL_HANDLER_FUNC, async_operation_cancel_handler, size_t, context_size);
 MOCKABLE_FUNCTION(, void, async_operation_destroy, ASYNC_OPERATION_HANDLE, async_operation);
 MOCKABLE_FUNCTION(, int, async_operation_cancel, ASYNC_OPERATION_HANDLE, async_operation);
 
+/* A pool keeps the memory of destroyed operations of one context type for the next ones, so that an owner creating
+   an operation per message does not allocate for each. A pool is used from the thread that drives its owner, and
+   operations that outlive the pool are freed when they are destroyed. */
+MOCKABLE_FUNCTION(, ASYNC_OPERATION_POOL_HANDLE, async_operation_pool_create, size_t, context_size, size_t, max_free_count);
+MOCKABLE_FUNCTION(, void, async_operation_pool_destroy, ASYNC_OPERATION_POOL_HANDLE, async_operation_pool);
+MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, async_operation_create_from_pool, ASYNC_OPERATION_POOL_HANDLE, async_operation_pool, ASYNC_OPERATION_CANCEL_HANDLER_FUNC, async_operation_cancel_handler);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+    typedef struct BUFFER_POOL_INSTANCE_TAG* BUFFER_POOL_HANDLE;
+
+    /* buffer_count buffers of buffer_size bytes carved out of one region mapped when the pool is created, so that a
+       receiver going through megabytes of frames per second reuses the same memory instead of going to the heap for each
+       frame. With use_huge_pages the region is mapped with 2MB pages (MAP_HUGETLB on Linux, which needs pages reserved in
+       vm.nr_hugepages, MEM_LARGE_PAGES on Windows, which needs SeLockMemoryPrivilege) to cut down on TLB misses. When none
+       can be had the region is mapped with normal pages (asking Linux for transparent huge pages), and where there is
+       no mapping API it comes from malloc. The pool does not lock, it is meant to be used from one thread. */
+    MOCKABLE_FUNCTION(, BUFFER_POOL_HANDLE, buffer_pool_create, size_t, buffer_size, size_t, buffer_count, bool, use_huge_pages);
+    MOCKABLE_FUNCTION(, void, buffer_pool_destroy, BUFFER_POOL_HANDLE, buffer_pool);
+    /* returns NULL when size is bigger than the buffers of the pool or all of them are in use */
+    MOCKABLE_FUNCTION(, unsigned char*, buffer_pool_get, BUFFER_POOL_HANDLE, buffer_pool, size_t, size);
+    MOCKABLE_FUNCTION(, void, buffer_pool_release, BUFFER_POOL_HANDLE, buffer_pool, unsigned char*, buffer);
+    /* the buffer_size given at create, 0 for a NULL pool */
+    MOCKABLE_FUNCTION(, size_t, buffer_pool_get_buffer_size, BUFFER_POOL_HANDLE, buffer_pool);
+    /* whether the region actually got huge pages, transparent huge pages are not reported */
+    MOCKABLE_FUNCTION(, bool, buffer_pool_is_huge_page_backed, BUFFER_POOL_HANDLE, buffer_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BUFFER_POOL_H */
@@ -5,6 +5,7 @@
 #define CBS_H
 
 #include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/amqp_management_mux.h"
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -35,10 +36,15 @@ DEFINE_ENUM(CBS_OPEN_COMPLETE_RESULT, CBS_OPEN_COMPLETE_RESULT_VALUES)
     typedef void(*ON_CBS_OPERATION_COMPLETE)(void* context, CBS_OPERATION_RESULT complete_result, unsigned int status_code, const char* status_description);
 
     MOCKABLE_FUNCTION(, CBS_HANDLE, cbs_create, SESSION_HANDLE, session);
+    MOCKABLE_FUNCTION(, CBS_HANDLE, cbs_create_with_management_mux, AMQP_MANAGEMENT_MUX_HANDLE, amqp_management_mux);
     MOCKABLE_FUNCTION(, void, cbs_destroy, CBS_HANDLE, cbs);
     MOCKABLE_FUNCTION(, int, cbs_open_async, CBS_HANDLE, cbs, ON_CBS_OPEN_COMPLETE, on_cbs_open_complete, void*, on_cbs_open_complete_context, ON_CBS_ERROR, on_cbs_error, void*, on_cbs_error_context);
     MOCKABLE_FUNCTION(, int, cbs_close, CBS_HANDLE, cbs);
     MOCKABLE_FUNCTION(, int, cbs_put_token_async, CBS_HANDLE, cbs, const char*, type, const char*, audience, const char*, token, ON_CBS_OPERATION_COMPLETE, on_cbs_put_token_complete, void*, on_cbs_put_token_complete_context);
+    /* A put-token operation prepared for one (type, audience) pair, so that renewing that token only encodes the token and the
+       message id. Destroy it with amqp_management_destroy_prepared_operation. */
+    MOCKABLE_FUNCTION(, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, cbs_prepare_put_token, const char*, type, const char*, audience);
+    MOCKABLE_FUNCTION(, int, cbs_put_token_prepared_async, CBS_HANDLE, cbs, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, prepared_put_token, const char*, token, ON_CBS_OPERATION_COMPLETE, on_cbs_put_token_complete, void*, on_cbs_put_token_complete_context);
     MOCKABLE_FUNCTION(, int, cbs_delete_token_async, CBS_HANDLE, cbs, const char*, type, const char*, audience, ON_CBS_OPERATION_COMPLETE, on_cbs_delete_token_complete, void*, on_cbs_delete_token_complete_context);
     MOCKABLE_FUNCTION(, int, cbs_set_trace, CBS_HANDLE, cbs, bool, trace_on);
 
@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CBS_TOKEN_MANAGER_H
+#define CBS_TOKEN_MANAGER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_uamqp_c/cbs.h"
+#include "azure_uamqp_c/timer_wheel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    typedef struct CBS_TOKEN_MANAGER_INSTANCE_TAG* CBS_TOKEN_MANAGER_HANDLE;
+
+    /* All times are milliseconds of the tick counter given to cbs_token_manager_create, the same clock the caller
+       uses to advance the timer wheel. */
+    typedef struct CBS_TOKEN_MANAGER_CONFIG_TAG
+    {
+        /* a token is refreshed this long before it expires */
+        uint32_t refresh_ahead_ms;
+        /* each refresh is moved earlier by a random amount up to this, so that tokens put together expire apart */
+        uint32_t refresh_jitter_ms;
+        /* refreshes that are due are sent at most max_refreshes_per_batch every batch_interval_ms */
+        size_t max_refreshes_per_batch;
+        uint32_t batch_interval_ms;
+        /* delay before a failed refresh is attempted again */
+        uint32_t retry_interval_ms;
+    } CBS_TOKEN_MANAGER_CONFIG;
+
+    /* Returns a new token for audience and its expiry, NULL if none can be made now. The token only has to stay
+       valid until the callback is called again. */
+    typedef const char*(*ON_CBS_TOKEN_MANAGER_GET_TOKEN)(void* context, const char* audience, uint64_t* expiry_ms);
+
+    typedef struct CBS_TOKEN_MANAGER_TOKEN_REQUEST_TAG* CBS_TOKEN_MANAGER_TOKEN_REQUEST_HANDLE;
+
+    /* Asks for a new token for audience without waiting for it, for example from a thread signing the tokens. The token
+       is handed back by calling cbs_token_manager_complete_token_request with request, exactly once, from any thread.
+       audience stays valid until then. */
+    typedef void(*ON_CBS_TOKEN_MANAGER_REQUEST_TOKEN)(void* context, const char* audience, CBS_TOKEN_MANAGER_TOKEN_REQUEST_HANDLE request);
+
+    MOCKABLE_FUNCTION(, CBS_TOKEN_MANAGER_HANDLE, cbs_token_manager_create, CBS_HANDLE, cbs, TIMER_WHEEL_HANDLE, timer_wheel, TICK_COUNTER_HANDLE, tick_counter, const CBS_TOKEN_MANAGER_CONFIG*, config, ON_CBS_TOKEN_MANAGER_GET_TOKEN, on_get_token, void*, on_get_token_context);
+    MOCKABLE_FUNCTION(, void, cbs_token_manager_destroy, CBS_TOKEN_MANAGER_HANDLE, token_manager);
+    MOCKABLE_FUNCTION(, int, cbs_token_manager_put_token_async, CBS_TOKEN_MANAGER_HANDLE, token_manager, const char*, type, const char*, audience, const char*, token, uint64_t, expiry_ms, ON_CBS_OPERATION_COMPLETE, on_put_token_complete, void*, on_put_token_complete_context);
+    MOCKABLE_FUNCTION(, int, cbs_token_manager_remove_audience, CBS_TOKEN_MANAGER_HANDLE, token_manager, const char*, audience);
+    /* Refreshes ask on_request_token for their tokens instead of on_get_token (NULL goes back to on_get_token). Requests
+       count against max_refreshes_per_batch like other refreshes. */
+    MOCKABLE_FUNCTION(, int, cbs_token_manager_set_token_provider, CBS_TOKEN_MANAGER_HANDLE, token_manager, ON_CBS_TOKEN_MANAGER_REQUEST_TOKEN, on_request_token, void*, on_request_token_context);
+    /* token is NULL when none could be made, the refresh is then retried */
+    MOCKABLE_FUNCTION(, int, cbs_token_manager_complete_token_request, CBS_TOKEN_MANAGER_TOKEN_REQUEST_HANDLE, request, const char*, token, uint64_t, expiry_ms);
+    /* puts the tokens handed back since the last call, on the thread driving the token manager and its cbs instance */
+    MOCKABLE_FUNCTION(, void, cbs_token_manager_dowork, CBS_TOKEN_MANAGER_HANDLE, token_manager);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CBS_TOKEN_MANAGER_H */
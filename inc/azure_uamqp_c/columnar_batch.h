@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef COLUMNAR_BATCH_H
+#define COLUMNAR_BATCH_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_uamqp_c/amqp_definitions_sequence_no.h"
+#include "azure_uamqp_c/amqp_definitions_delivery_number.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define COLUMNAR_BATCH_SOURCE_VALUES \
+    COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION, \
+    COLUMNAR_BATCH_SOURCE_PROPERTY, \
+    COLUMNAR_BATCH_SOURCE_APPLICATION_PROPERTY
+
+DEFINE_ENUM(COLUMNAR_BATCH_SOURCE, COLUMNAR_BATCH_SOURCE_VALUES)
+
+#define COLUMNAR_BATCH_COLUMN_TYPE_VALUES \
+    COLUMNAR_BATCH_COLUMN_TYPE_INT64, \
+    COLUMNAR_BATCH_COLUMN_TYPE_DOUBLE, \
+    COLUMNAR_BATCH_COLUMN_TYPE_STRING
+
+DEFINE_ENUM(COLUMNAR_BATCH_COLUMN_TYPE, COLUMNAR_BATCH_COLUMN_TYPE_VALUES)
+
+    typedef struct COLUMNAR_BATCH_INSTANCE_TAG* COLUMNAR_BATCH_HANDLE;
+
+    /* Up to max_rows received messages laid out by column for processing in bulk, filled straight from their encoded bytes
+       with the AMQP reader, without a MESSAGE_HANDLE or AMQP_VALUE being created for them (see
+       messagereceiver_receive_columnar_batch_async). The bodies of all rows are in one buffer, row i going from
+       body_offsets[i] to body_offsets[i + 1]; a body is the concatenation of its data sections, or the bytes of an amqp-value
+       body holding a binary or a string, any other body is left empty. The other columns are chosen with
+       columnar_batch_add_column. The arrays returned by the getters are owned by the batch and valid until the next
+       append, clear or destroy. */
+    MOCKABLE_FUNCTION(, COLUMNAR_BATCH_HANDLE, columnar_batch_create, uint32_t, max_rows);
+    MOCKABLE_FUNCTION(, void, columnar_batch_destroy, COLUMNAR_BATCH_HANDLE, batch);
+    /* A column holding the message annotation, the properties field (by its name in the AMQP spec, e.g. "creation-time" or
+       "group-id") or the application property called name, for every row. Integers, timestamps included, go in INT64
+       columns, integers and floating point numbers in DOUBLE columns and strings and symbols in STRING columns; a row whose
+       value is missing or of another type is marked as not present. Only allowed while the batch is empty. */
+    MOCKABLE_FUNCTION(, int, columnar_batch_add_column, COLUMNAR_BATCH_HANDLE, batch, COLUMNAR_BATCH_SOURCE, source, const char*, name, COLUMNAR_BATCH_COLUMN_TYPE, column_type, size_t*, column_index);
+    /* adds a row for the message encoded in bytes (its sections, as carried by its transfers), no row is added when it fails */
+    MOCKABLE_FUNCTION(, int, columnar_batch_append_message, COLUMNAR_BATCH_HANDLE, batch, delivery_number, delivery_id, const unsigned char*, bytes, size_t, length);
+    /* removes all rows, the columns and the memory of the batch are kept */
+    MOCKABLE_FUNCTION(, void, columnar_batch_clear, COLUMNAR_BATCH_HANDLE, batch);
+    MOCKABLE_FUNCTION(, int, columnar_batch_get_row_count, COLUMNAR_BATCH_HANDLE, batch, uint32_t*, row_count);
+    MOCKABLE_FUNCTION(, int, columnar_batch_get_max_row_count, COLUMNAR_BATCH_HANDLE, batch, uint32_t*, max_row_count);
+    /* the delivery ids, to settle the rows with messagereceiver_send_message_disposition */
+    MOCKABLE_FUNCTION(, int, columnar_batch_get_delivery_ids, COLUMNAR_BATCH_HANDLE, batch, const delivery_number**, delivery_ids);
+    /* body_offsets has row count + 1 entries */
+    MOCKABLE_FUNCTION(, int, columnar_batch_get_bodies, COLUMNAR_BATCH_HANDLE, batch, const unsigned char**, body_bytes, const size_t**, body_offsets);
+    MOCKABLE_FUNCTION(, int, columnar_batch_get_int64_column, COLUMNAR_BATCH_HANDLE, batch, size_t, column_index, const int64_t**, values, const bool**, is_present);
+    MOCKABLE_FUNCTION(, int, columnar_batch_get_double_column, COLUMNAR_BATCH_HANDLE, batch, size_t, column_index, const double**, values, const bool**, is_present);
+    /* the strings are not NUL terminated, row i going from offsets[i] to offsets[i + 1] in characters */
+    MOCKABLE_FUNCTION(, int, columnar_batch_get_string_column, COLUMNAR_BATCH_HANDLE, batch, size_t, column_index, const char**, characters, const size_t**, offsets, const bool**, is_present);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* COLUMNAR_BATCH_H */
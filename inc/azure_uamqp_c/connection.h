@@ -10,6 +10,9 @@
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_uamqp_c/amqp_frame_codec.h"
+#include "azure_uamqp_c/frame_trace.h"
+#include "azure_uamqp_c/admission_limiter.h"
+#include "azure_uamqp_c/buffer_pool.h"
 #include "azure_uamqp_c/amqp_definitions_fields.h"
 #include "azure_uamqp_c/amqp_definitions_milliseconds.h"
 
@@ -68,13 +71,116 @@ extern "C" {
         CONNECTION_STATE_ERROR
     } CONNECTION_STATE;
 
-    typedef void(*ON_ENDPOINT_FRAME_RECEIVED)(void* context, AMQP_VALUE performative, uint32_t frame_payload_size, const unsigned char* payload_bytes);
+    /* performative_code is the descriptor of the performative (AMQP_OPEN to AMQP_CLOSE, see amqp_frame_codec.h), so receivers can dispatch on it without reading the descriptor again */
+    typedef void(*ON_ENDPOINT_FRAME_RECEIVED)(void* context, AMQP_VALUE performative, uint64_t performative_code, uint32_t frame_payload_size, const unsigned char* payload_bytes);
     typedef void(*ON_CONNECTION_STATE_CHANGED)(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state);
+    typedef void(*ON_SEND_QUEUE_DRAINED)(void* context);
+    typedef void(*ON_ENDPOINT_DOWORK)(void* context);
     typedef bool(*ON_NEW_ENDPOINT)(void* context, ENDPOINT_HANDLE new_endpoint);
 
+    /* counters kept since the connection was created, bytes are counted as they are handed to or received from the io */
+    typedef struct CONNECTION_STATS_TAG
+    {
+        uint64_t frames_sent;
+        uint64_t frames_received;
+        uint64_t bytes_sent;
+        uint64_t bytes_received;
+        uint64_t empty_frames_sent;
+        uint64_t empty_frames_received;
+        uint64_t send_queue_stalls;
+    } CONNECTION_STATS;
+
+    /* Allocator a connection uses for its own memory and for the bookkeeping of the frames it sends, so that
+       connections can be given their own heaps and their memory accounted separately. */
+    typedef struct CONNECTION_ALLOCATOR_TAG
+    {
+        void*(*malloc_function)(void* context, size_t size);
+        void*(*realloc_function)(void* context, void* ptr, size_t size);
+        void(*free_function)(void* context, void* ptr);
+        void* context;
+    } CONNECTION_ALLOCATOR;
+
+    /* Changes of what holds the senders of a connection back, reported to the flow observer as they happen so that
+       autoscaling or adaptive batching can react without polling the stats. */
+    typedef enum CONNECTION_FLOW_EVENT_TAG
+    {
+        /* a sender link refused a transfer for lack of credit, and got credit again from a flow */
+        CONNECTION_FLOW_EVENT_LINK_CREDIT_EXHAUSTED,
+        CONNECTION_FLOW_EVENT_LINK_CREDIT_AVAILABLE,
+        /* a session refused a transfer because the remote incoming window was 0, and a flow opened it again */
+        CONNECTION_FLOW_EVENT_SESSION_WINDOW_CLOSED,
+        CONNECTION_FLOW_EVENT_SESSION_WINDOW_OPENED,
+        /* the send queue went over its high water mark, and back down to its low water mark */
+        CONNECTION_FLOW_EVENT_SEND_QUEUE_FULL,
+        CONNECTION_FLOW_EVENT_SEND_QUEUE_DRAINED,
+        /* the messages queued in a message sender went over its queue depth threshold, and back to it */
+        CONNECTION_FLOW_EVENT_QUEUE_DEPTH_ABOVE,
+        CONNECTION_FLOW_EVENT_QUEUE_DEPTH_BELOW
+    } CONNECTION_FLOW_EVENT;
+
+    typedef struct CONNECTION_FLOW_EVENT_INFO_TAG
+    {
+        CONNECTION_FLOW_EVENT event;
+        /* tick counter of the connection when the event was reported */
+        uint64_t timestamp_ms;
+        /* the LINK_HANDLE, SESSION_HANDLE, CONNECTION_HANDLE or MESSAGE_SENDER_HANDLE the event is about */
+        const void* source;
+        /* the name of the link for link and message sender events, NULL otherwise */
+        const char* link_name;
+        /* the link credit, the queued bytes of the send queue, the pending sends of the sender or the remote incoming window
+           of the session (0 when it closes) */
+        uint64_t value;
+    } CONNECTION_FLOW_EVENT_INFO;
+
+    typedef void(*ON_CONNECTION_FLOW_EVENT)(void* context, const CONNECTION_FLOW_EVENT_INFO* event_info);
+
+    /* The application callbacks that run inside connection_dowork and are timed against the callback budget */
+    typedef enum CONNECTION_CALLBACK_TYPE_TAG
+    {
+        CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED,
+        CONNECTION_CALLBACK_TYPE_MESSAGE_SEND_COMPLETE,
+        CONNECTION_CALLBACK_TYPE_LINK_ATTACHED,
+        CONNECTION_CALLBACK_TYPE_COUNT
+    } CONNECTION_CALLBACK_TYPE;
+
+#define CONNECTION_SLOW_CALLBACK_MAX 8
+#define CONNECTION_SLOW_CALLBACK_LINK_NAME_SIZE 64
+
+    typedef struct CONNECTION_SLOW_CALLBACK_TAG
+    {
+        CONNECTION_CALLBACK_TYPE callback_type;
+        /* truncated to fit, empty when the link name could not be had */
+        char link_name[CONNECTION_SLOW_CALLBACK_LINK_NAME_SIZE];
+        uint64_t duration_ms;
+        /* tick counter of the connection when the callback returned */
+        uint64_t timestamp_ms;
+    } CONNECTION_SLOW_CALLBACK;
+
+    typedef struct CONNECTION_CALLBACK_STATS_TAG
+    {
+        uint64_t timed_callbacks;
+        /* the callbacks that took longer than the budget, per type */
+        uint64_t slow_callbacks[CONNECTION_CALLBACK_TYPE_COUNT];
+        /* the slowest callbacks over the budget, slowest first */
+        size_t worst_callback_count;
+        CONNECTION_SLOW_CALLBACK worst_callbacks[CONNECTION_SLOW_CALLBACK_MAX];
+    } CONNECTION_CALLBACK_STATS;
+
+    /* What an application event loop waits for on the socket under the io before calling connection_dowork again, see
+       connection_get_io_interest */
+    typedef struct CONNECTION_IO_INTEREST_TAG
+    {
+        bool want_read;
+        bool want_write;
+        /* milliseconds after which connection_dowork has to run even if the socket stays quiet, (uint64_t)-1 for never */
+        uint64_t timeout_ms;
+    } CONNECTION_IO_INTEREST;
+
     MOCKABLE_FUNCTION(, CONNECTION_HANDLE, connection_create, XIO_HANDLE, io, const char*, hostname, const char*, container_id, ON_NEW_ENDPOINT, on_new_endpoint, void*, callback_context);
     MOCKABLE_FUNCTION(, CONNECTION_HANDLE, connection_create2, XIO_HANDLE, xio, const char*, hostname, const char*, container_id, ON_NEW_ENDPOINT, on_new_endpoint, void*, callback_context, ON_CONNECTION_STATE_CHANGED, on_connection_state_changed, void*, on_connection_state_changed_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
+    MOCKABLE_FUNCTION(, CONNECTION_HANDLE, connection_create3, XIO_HANDLE, xio, const char*, hostname, const char*, container_id, ON_NEW_ENDPOINT, on_new_endpoint, void*, callback_context, ON_CONNECTION_STATE_CHANGED, on_connection_state_changed, void*, on_connection_state_changed_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context, const CONNECTION_ALLOCATOR*, allocator);
     MOCKABLE_FUNCTION(, void, connection_destroy, CONNECTION_HANDLE, connection);
+    MOCKABLE_FUNCTION(, int, connection_get_allocator, CONNECTION_HANDLE, connection, CONNECTION_ALLOCATOR*, allocator);
     MOCKABLE_FUNCTION(, int, connection_open, CONNECTION_HANDLE, connection);
     MOCKABLE_FUNCTION(, int, connection_listen, CONNECTION_HANDLE, connection);
     MOCKABLE_FUNCTION(, int, connection_close, CONNECTION_HANDLE, connection, const char*, condition_value, const char*, description);
@@ -87,16 +193,120 @@ extern "C" {
     MOCKABLE_FUNCTION(, int, connection_set_properties, CONNECTION_HANDLE, connection, fields, properties);
     MOCKABLE_FUNCTION(, int, connection_get_properties, CONNECTION_HANDLE, connection, fields*, properties);
     MOCKABLE_FUNCTION(, int, connection_get_remote_max_frame_size, CONNECTION_HANDLE, connection, uint32_t*, remote_max_frame_size);
+    /* A transfer that fits in one frame of the remote max frame size is always sent as one frame. A bigger one is split into frames
+       whose size is the largest multiple of the alignment that the peer accepts, e.g. 16384 so that over TLS each frame fills whole records. */
+    MOCKABLE_FUNCTION(, int, connection_set_frame_size_alignment, CONNECTION_HANDLE, connection, uint32_t, frame_size_alignment);
+    MOCKABLE_FUNCTION(, int, connection_get_split_frame_size, CONNECTION_HANDLE, connection, uint32_t*, split_frame_size);
     MOCKABLE_FUNCTION(, int, connection_set_remote_idle_timeout_empty_frame_send_ratio, CONNECTION_HANDLE, connection, double, idle_timeout_empty_frame_send_ratio);
+    /* Each flush of the outgoing batch is one xio_send call, so over a WebSocket IO many frames travel in one WebSocket
+       message instead of paying the framing and masking of a message per frame. */
+    MOCKABLE_FUNCTION(, int, connection_set_outgoing_batch_size, CONNECTION_HANDLE, connection, uint32_t, outgoing_batch_size);
+    MOCKABLE_FUNCTION(, int, connection_get_outgoing_batch_size, CONNECTION_HANDLE, connection, uint32_t*, outgoing_batch_size);
+    /* Holds a batch that did not reach the outgoing batch size for up to outgoing_batch_delay milliseconds across calls to
+       connection_dowork, trading latency for fewer and bigger writes. connection_flush still sends the batch right away. */
+    MOCKABLE_FUNCTION(, int, connection_set_outgoing_batch_delay, CONNECTION_HANDLE, connection, milliseconds, outgoing_batch_delay);
+    MOCKABLE_FUNCTION(, int, connection_get_outgoing_batch_delay, CONNECTION_HANDLE, connection, milliseconds*, outgoing_batch_delay);
+    MOCKABLE_FUNCTION(, int, connection_flush, CONNECTION_HANDLE, connection);
+    /* Between a hold and its release every frame encoded on the connection, such as the attach and detach frames of many
+       links being opened or closed, goes to the outgoing batch and the last release passes them all to the io in one
+       xio_send call. Holds nest, and connection_dowork does not flush a held batch. */
+    MOCKABLE_FUNCTION(, int, connection_hold_outgoing_batch, CONNECTION_HANDLE, connection);
+    MOCKABLE_FUNCTION(, int, connection_release_outgoing_batch, CONNECTION_HANDLE, connection);
+    /* Bounds the bytes handed to the io that it did not complete yet, which a slow peer would otherwise let grow without limit.
+       Above high_water_mark sessions stop sending new transfers, and they are told they can send again once the io completed
+       enough of them to get down to low_water_mark. A high_water_mark of 0 (the default) disables the limit. */
+    MOCKABLE_FUNCTION(, int, connection_set_send_queue_limits, CONNECTION_HANDLE, connection, size_t, high_water_mark, size_t, low_water_mark);
+    MOCKABLE_FUNCTION(, bool, connection_is_send_queue_full, CONNECTION_HANDLE, connection);
+    /* Bounds what one peer can make the connection hold: the frames being received and the buffers of its links are
+       charged against memory_quota, links issue as little credit as they can once less than low_memory_mark bytes are
+       left, and a charge that does not fit closes the connection with amqp:resource-limit-exceeded. Must be set before
+       the connection is opened. */
+    MOCKABLE_FUNCTION(, int, connection_set_memory_quota, CONNECTION_HANDLE, connection, size_t, memory_quota, size_t, low_memory_mark);
+    /* Receives the frames in buffers of buffer_pool (see buffer_pool.h, for instance backed by huge pages), falling back
+       to a buffer of the connection for frames bigger than the pool buffers or when they are all in use. Under a memory
+       quota a pool buffer is charged while it holds a frame. The pool is not owned by the connection and has to outlive
+       it, one pool can serve all the connections run by one thread. Must be set before the connection is opened, and is
+       not available with UAMQP_STATIC_POOLS. */
+    MOCKABLE_FUNCTION(, int, connection_set_receive_buffer_pool, CONNECTION_HANDLE, connection, BUFFER_POOL_HANDLE, buffer_pool);
+    MOCKABLE_FUNCTION(, int, connection_charge_memory, CONNECTION_HANDLE, connection, size_t, size);
+    MOCKABLE_FUNCTION(, void, connection_release_memory, CONNECTION_HANDLE, connection, size_t, size);
+    MOCKABLE_FUNCTION(, bool, connection_is_memory_low, CONNECTION_HANDLE, connection);
+    /* Endpoints add the bytes they hand to the application to the receive backlog and remove them once the application
+       settles them. While the backlog is over pause_backlog (0 turns it off) connection_dowork stops calling xio_dowork,
+       so the peer's bytes stay in the transport and its flow control pushes back on the peer, until the backlog is down
+       to resume_backlog. */
+    MOCKABLE_FUNCTION(, int, connection_set_receive_backlog_limits, CONNECTION_HANDLE, connection, size_t, pause_backlog, size_t, resume_backlog);
+    MOCKABLE_FUNCTION(, void, connection_add_receive_backlog, CONNECTION_HANDLE, connection, size_t, size);
+    MOCKABLE_FUNCTION(, void, connection_remove_receive_backlog, CONNECTION_HANDLE, connection, size_t, size);
+    MOCKABLE_FUNCTION(, bool, connection_is_receive_paused, CONNECTION_HANDLE, connection);
+    /* For driving the connection from an event loop (libuv, Asio, ...) instead of polling connection_dowork: after each
+       connection_dowork, and after the application sent from the loop's thread, the loop watches the socket for the interest
+       given here and calls connection_dowork when it is ready or timeout_ms passed. It handles the idle timeouts like
+       connection_handle_deadlines. Without send queue limits, want_write only says that bytes were handed to the io since
+       the previous call, not that the io still holds some. IOs with timers of their own (such as TLS handshakes) are not
+       covered. See uamqp_libuv.h and uamqp_asio.hpp. */
+    MOCKABLE_FUNCTION(, int, connection_get_io_interest, CONNECTION_HANDLE, connection, CONNECTION_IO_INTEREST*, io_interest);
+    /* Sends the open, and lets sessions and links send begin and attach, without waiting for the peer's header and open,
+       so that these frames leave in one write. Must be set before the connection is opened. */
+    MOCKABLE_FUNCTION(, int, connection_set_pipelined_open, CONNECTION_HANDLE, connection, bool, pipelined_open);
+    MOCKABLE_FUNCTION(, int, connection_get_pipelined_open, CONNECTION_HANDLE, connection, bool*, pipelined_open);
     MOCKABLE_FUNCTION(, uint64_t, connection_handle_deadlines, CONNECTION_HANDLE, connection);
     MOCKABLE_FUNCTION(, void, connection_dowork, CONNECTION_HANDLE, connection);
     MOCKABLE_FUNCTION(, ENDPOINT_HANDLE, connection_create_endpoint, CONNECTION_HANDLE, connection);
     MOCKABLE_FUNCTION(, int, connection_start_endpoint, ENDPOINT_HANDLE, endpoint, ON_ENDPOINT_FRAME_RECEIVED, on_frame_received, ON_CONNECTION_STATE_CHANGED, on_connection_state_changed, void*, context);
     MOCKABLE_FUNCTION(, int, connection_endpoint_get_incoming_channel, ENDPOINT_HANDLE, endpoint, uint16_t*, incoming_channel);
+    MOCKABLE_FUNCTION(, int, connection_endpoint_get_outgoing_channel, ENDPOINT_HANDLE, endpoint, uint16_t*, outgoing_channel);
+    MOCKABLE_FUNCTION(, int, connection_endpoint_set_on_send_queue_drained, ENDPOINT_HANDLE, endpoint, ON_SEND_QUEUE_DRAINED, on_send_queue_drained, void*, context);
+    /* Called once per connection_dowork, before the io does its work. The frames encoded from it by all the endpoints
+       are sent to the io together, in one write. */
+    MOCKABLE_FUNCTION(, int, connection_endpoint_set_on_dowork, ENDPOINT_HANDLE, endpoint, ON_ENDPOINT_DOWORK, on_dowork, void*, context);
     MOCKABLE_FUNCTION(, void, connection_destroy_endpoint, ENDPOINT_HANDLE, endpoint);
     MOCKABLE_FUNCTION(, int, connection_encode_frame, ENDPOINT_HANDLE, endpoint, AMQP_VALUE, performative, PAYLOAD*, payloads, size_t, payload_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+    MOCKABLE_FUNCTION(, int, connection_encode_frame_with_encoded_performative, ENDPOINT_HANDLE, endpoint, const unsigned char*, performative_bytes, size_t, performative_size, PAYLOAD*, payloads, size_t, payload_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
     MOCKABLE_FUNCTION(, void, connection_set_trace, CONNECTION_HANDLE, connection, bool, trace_on);
+    MOCKABLE_FUNCTION(, int, connection_get_stats, CONNECTION_HANDLE, connection, CONNECTION_STATS*, stats);
+
+    /* The frame trace is owned by the caller and shall outlive the connection or be removed before being destroyed.
+       Connections sharing a frame trace shall be driven from the same thread. */
+    MOCKABLE_FUNCTION(, int, connection_set_frame_trace, CONNECTION_HANDLE, connection, FRAME_TRACE_HANDLE, frame_trace);
+
+    /* Bounds the received performatives, see amqpvalue_decoder_set_limits; 0 means no limit. A frame breaching a limit
+       closes the connection with amqp:decode-error. */
+    MOCKABLE_FUNCTION(, int, connection_set_decoder_limits, CONNECTION_HANDLE, connection, uint32_t, max_depth, size_t, max_element_count, size_t, max_allocated_bytes);
+
+    /* The observer is called from the thread driving the connection, at the time the change happens, so it has to be
+       quick and shall not destroy the source of the event. Sessions, links and message senders report their changes to
+       the connection they are on with connection_report_flow_event, which does nothing without an observer. */
+    MOCKABLE_FUNCTION(, int, connection_set_flow_observer, CONNECTION_HANDLE, connection, ON_CONNECTION_FLOW_EVENT, on_flow_event, void*, context);
+    MOCKABLE_FUNCTION(, void, connection_report_flow_event, CONNECTION_HANDLE, connection, CONNECTION_FLOW_EVENT, event, const void*, source, const char*, link_name, uint64_t, value);
+
+    /* One slow application callback stalls every link of the connection. With a budget set, message receivers, message
+       senders and sessions time the callbacks they make with connection_begin_callback and connection_end_callback and the
+       ones that take longer than budget_ms are counted and the slowest kept, see connection_get_callback_stats.
+       The timing uses the tick counter of the connection, so it has its millisecond resolution. 0 (the default) turns the
+       timing off, connection_begin_callback then returns false without reading the tick counter. Setting a budget clears
+       the callback stats. */
+    MOCKABLE_FUNCTION(, int, connection_set_callback_budget, CONNECTION_HANDLE, connection, milliseconds, budget_ms);
+    MOCKABLE_FUNCTION(, bool, connection_begin_callback, CONNECTION_HANDLE, connection, uint64_t*, start_ms);
+    MOCKABLE_FUNCTION(, void, connection_end_callback, CONNECTION_HANDLE, connection, CONNECTION_CALLBACK_TYPE, callback_type, const char*, link_name, uint64_t, start_ms);
+    MOCKABLE_FUNCTION(, int, connection_get_callback_stats, CONNECTION_HANDLE, connection, CONNECTION_CALLBACK_STATS*, callback_stats);
+
+    /* A remote begin the limiter does not admit is answered with a begin and an end carrying amqp:resource-limit-exceeded
+       before on_new_endpoint is called, so no endpoint or session is built for it. The limiter is owned by the caller
+       and shall outlive the connection or be removed before being destroyed. */
+    MOCKABLE_FUNCTION(, int, connection_set_session_admission_limiter, CONNECTION_HANDLE, connection, ADMISSION_LIMITER_HANDLE, session_admission_limiter);
+
 
+    /* Hands an opened connection over to another process without renegotiating it: the old owner saves the negotiated values,
+       which only succeeds once no part of a frame is received and no frame is waiting to be sent, and passes them with the
+       socket (e.g. over a unix socket with SCM_RIGHTS), then stops using the connection and destroys its io without shutting
+       the socket down. The new owner creates a connection on an io wrapping the socket, restores the values before opening it
+       and connection_open resumes it in the OPENED state, without a protocol header or an open frame on the wire. Sessions and
+       links are handed over the same way, see session_save_handover_state and link_save_handover_state. */
+    MOCKABLE_FUNCTION(, int, connection_save_handover_state, CONNECTION_HANDLE, connection, unsigned char*, buffer, size_t, buffer_size, size_t*, length);
+    MOCKABLE_FUNCTION(, int, connection_restore_handover_state, CONNECTION_HANDLE, connection, const unsigned char*, bytes, size_t, length);
+    /* for the sessions resumed from a handover state, their endpoint takes the channels it had on the old owner */
+    MOCKABLE_FUNCTION(, int, connection_endpoint_restore_channels, ENDPOINT_HANDLE, endpoint, uint16_t, outgoing_channel, uint16_t, incoming_channel);
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
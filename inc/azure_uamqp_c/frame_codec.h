@@ -40,10 +40,17 @@ typedef struct PAYLOAD_TAG
     typedef void(*ON_FRAME_RECEIVED)(void* context, const unsigned char* type_specific, uint32_t type_specific_size, const unsigned char* frame_body, uint32_t frame_body_size);
     typedef void(*ON_FRAME_CODEC_ERROR)(void* context);
     typedef void(*ON_BYTES_ENCODED)(void* context, const unsigned char* bytes, size_t length, bool encode_complete);
+    typedef unsigned char*(*ON_FRAME_CODEC_GET_RECEIVE_BUFFER)(void* context, uint32_t size);
+    /* like realloc: returns a buffer of size bytes starting with the bytes of buffer, or NULL leaving buffer held and untouched */
+    typedef unsigned char*(*ON_FRAME_CODEC_GROW_RECEIVE_BUFFER)(void* context, unsigned char* buffer, uint32_t size);
+    typedef void(*ON_FRAME_CODEC_RELEASE_RECEIVE_BUFFER)(void* context, unsigned char* buffer);
 
     MOCKABLE_FUNCTION(, FRAME_CODEC_HANDLE, frame_codec_create, ON_FRAME_CODEC_ERROR, on_frame_codec_error, void*, callback_context);
     MOCKABLE_FUNCTION(, void, frame_codec_destroy, FRAME_CODEC_HANDLE, frame_codec);
     MOCKABLE_FUNCTION(, int, frame_codec_set_max_frame_size, FRAME_CODEC_HANDLE, frame_codec, uint32_t, max_frame_size);
+    MOCKABLE_FUNCTION(, int, frame_codec_set_receive_buffer_pool, FRAME_CODEC_HANDLE, frame_codec, ON_FRAME_CODEC_GET_RECEIVE_BUFFER, get_receive_buffer, ON_FRAME_CODEC_GROW_RECEIVE_BUFFER, grow_receive_buffer, ON_FRAME_CODEC_RELEASE_RECEIVE_BUFFER, release_receive_buffer, void*, pool_context);
+    /* true when no byte of a frame is pending, i.e. the bytes received so far end with a complete frame */
+    MOCKABLE_FUNCTION(, bool, frame_codec_is_at_frame_boundary, FRAME_CODEC_HANDLE, frame_codec);
     MOCKABLE_FUNCTION(, int, frame_codec_subscribe, FRAME_CODEC_HANDLE, frame_codec, uint8_t, type, ON_FRAME_RECEIVED, on_frame_received, void*, callback_context);
     MOCKABLE_FUNCTION(, int, frame_codec_unsubscribe, FRAME_CODEC_HANDLE, frame_codec, uint8_t, type);
     MOCKABLE_FUNCTION(, int, frame_codec_receive_bytes, FRAME_CODEC_HANDLE, frame_codec, const unsigned char*, buffer, size_t, size);
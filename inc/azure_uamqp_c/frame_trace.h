@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define FRAME_TRACE_DIRECTION_VALUES \
+    FRAME_TRACE_DIRECTION_INCOMING, \
+    FRAME_TRACE_DIRECTION_OUTGOING
+
+DEFINE_ENUM(FRAME_TRACE_DIRECTION, FRAME_TRACE_DIRECTION_VALUES)
+
+#define FRAME_TRACE_FRAME_TYPE_VALUES \
+    FRAME_TRACE_FRAME_TYPE_HEADER, \
+    FRAME_TRACE_FRAME_TYPE_EMPTY, \
+    FRAME_TRACE_FRAME_TYPE_PERFORMATIVE
+
+DEFINE_ENUM(FRAME_TRACE_FRAME_TYPE, FRAME_TRACE_FRAME_TYPE_VALUES)
+
+/* performatives longer than this are recorded truncated, transfer, flow and disposition frames fit */
+#define FRAME_TRACE_MAX_PERFORMATIVE_SIZE 256
+
+    typedef struct FRAME_TRACE_INSTANCE_TAG* FRAME_TRACE_HANDLE;
+
+    typedef struct FRAME_TRACE_RECORD_TAG
+    {
+        uint64_t timestamp_ms;
+        FRAME_TRACE_DIRECTION direction;
+        FRAME_TRACE_FRAME_TYPE frame_type;
+        uint16_t channel;
+        /* encoded size of the whole performative, of which only captured_size bytes are in performative_bytes */
+        uint32_t performative_size;
+        uint32_t captured_size;
+        uint32_t payload_size;
+        const unsigned char* performative_bytes;
+    } FRAME_TRACE_RECORD;
+
+    typedef int(*FRAME_TRACE_OUTPUT)(void* context, const unsigned char* bytes, size_t length);
+    typedef void(*ON_FRAME_TRACE_RECORD)(void* context, const FRAME_TRACE_RECORD* record);
+    typedef void(*ON_FRAME_TRACE_CAPTURE_CHUNK)(void* context, uint64_t timestamp_ms, const unsigned char* bytes, size_t length);
+
+    /* A frame trace keeps the last record_count frames in a preallocated ring, recording a frame copies its encoded
+       performative and never allocates or formats. A trace is not thread safe, it is fed from the dowork thread of the
+       connections it is attached to. frame_trace_save writes the records in a binary form that frame_trace_parse reads back,
+       the formatting with amqpvalue_to_string is left to the offline decoder. */
+    MOCKABLE_FUNCTION(, FRAME_TRACE_HANDLE, frame_trace_create, size_t, record_count);
+    MOCKABLE_FUNCTION(, void, frame_trace_destroy, FRAME_TRACE_HANDLE, frame_trace);
+    MOCKABLE_FUNCTION(, int, frame_trace_record_bytes, FRAME_TRACE_HANDLE, frame_trace, FRAME_TRACE_DIRECTION, direction, FRAME_TRACE_FRAME_TYPE, frame_type, uint16_t, channel, uint64_t, timestamp_ms, const unsigned char*, performative_bytes, size_t, performative_size, uint32_t, payload_size);
+    MOCKABLE_FUNCTION(, int, frame_trace_record_value, FRAME_TRACE_HANDLE, frame_trace, FRAME_TRACE_DIRECTION, direction, uint16_t, channel, uint64_t, timestamp_ms, AMQP_VALUE, performative, uint32_t, payload_size);
+    MOCKABLE_FUNCTION(, int, frame_trace_get_record_count, FRAME_TRACE_HANDLE, frame_trace, size_t*, record_count);
+    MOCKABLE_FUNCTION(, void, frame_trace_clear, FRAME_TRACE_HANDLE, frame_trace);
+    MOCKABLE_FUNCTION(, int, frame_trace_save, FRAME_TRACE_HANDLE, frame_trace, FRAME_TRACE_OUTPUT, output, void*, output_context);
+    MOCKABLE_FUNCTION(, int, frame_trace_parse, const unsigned char*, bytes, size_t, size, ON_FRAME_TRACE_RECORD, on_record, void*, on_record_context);
+
+    /* A capture goes next to the ring: while an output is set every byte the connections receive is written to it, as
+       timestamped chunks, so that a whole stream can be replayed through frame_codec and the session and link layers
+       without a network. Unlike recording, capturing writes as it goes and its cost is the output's. */
+    MOCKABLE_FUNCTION(, int, frame_trace_set_capture, FRAME_TRACE_HANDLE, frame_trace, FRAME_TRACE_OUTPUT, output, void*, output_context);
+    MOCKABLE_FUNCTION(, bool, frame_trace_is_capturing, FRAME_TRACE_HANDLE, frame_trace);
+    MOCKABLE_FUNCTION(, int, frame_trace_capture_bytes, FRAME_TRACE_HANDLE, frame_trace, uint64_t, timestamp_ms, const unsigned char*, bytes, size_t, length);
+    MOCKABLE_FUNCTION(, int, frame_trace_parse_capture, const unsigned char*, bytes, size_t, size, ON_FRAME_TRACE_CAPTURE_CHUNK, on_chunk, void*, on_chunk_context);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FRAME_TRACE_H */
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOCPIO_H
+#define IOCPIO_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "winsock2.h"
+#include "windows.h"
+#include "azure_c_shared_utility/xio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+    /* A completion port and the overlapped sockets associated with it (Windows only, built with use_iocp).
+       A port and everything on it is driven by one thread, which calls iocp_port_dowork; a small pool of threads
+       serves many connections by giving each thread its own port. */
+    typedef struct IOCP_PORT_INSTANCE_TAG* IOCP_PORT_HANDLE;
+
+    typedef struct IOCP_OPERATION_TAG IOCP_OPERATION;
+    typedef void(*ON_IOCP_OPERATION_COMPLETE)(void* context, IOCP_OPERATION* operation, bool succeeded, DWORD bytes_transferred);
+
+    /* the first member of every overlapped operation, so that the completion finds its way back to its owner */
+    struct IOCP_OPERATION_TAG
+    {
+        OVERLAPPED overlapped;
+        ON_IOCP_OPERATION_COMPLETE on_operation_complete;
+        void* context;
+    };
+
+    /* same layout as SOCKETIO_CONFIG followed by the port the accepted socket is to be associated with.
+       The socket listener hands out its own port, an application with a thread per port replaces it before xio_create. */
+    typedef struct IOCPIO_CONFIG_TAG
+    {
+        const char* hostname;
+        int port;
+        void* accepted_socket;
+        IOCP_PORT_HANDLE iocp_port;
+    } IOCPIO_CONFIG;
+
+    MOCKABLE_FUNCTION(, IOCP_PORT_HANDLE, iocp_port_create);
+    /* ports are refcounted, every io on a port keeps it alive */
+    MOCKABLE_FUNCTION(, IOCP_PORT_HANDLE, iocp_port_clone, IOCP_PORT_HANDLE, iocp_port);
+    MOCKABLE_FUNCTION(, void, iocp_port_destroy, IOCP_PORT_HANDLE, iocp_port);
+    MOCKABLE_FUNCTION(, int, iocp_port_associate, IOCP_PORT_HANDLE, iocp_port, SOCKET, socket);
+    /* hands back an operation whose owner is gone, it is freed when its completion comes (it has to be the start of a malloc'ed block) */
+    MOCKABLE_FUNCTION(, void, iocp_port_abandon_operation, IOCP_PORT_HANDLE, iocp_port, IOCP_OPERATION*, operation);
+    /* dequeues the completions of the port, waiting up to timeout_ms for the first one, and calls their owners */
+    MOCKABLE_FUNCTION(, int, iocp_port_dowork, IOCP_PORT_HANDLE, iocp_port, unsigned int, timeout_ms);
+
+    /* The io of a socket accepted by the socket listener, with overlapped WSARecv and WSASend on a completion port.
+       A receive is always posted and is posted again from its completion. xio_send only queues the bytes and each
+       xio_dowork posts everything queued as one gathered WSASend. Completions are only delivered by iocp_port_dowork. */
+    MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, iocpio_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* IOCPIO_H */
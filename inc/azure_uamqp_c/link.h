@@ -46,10 +46,47 @@ DEFINE_ENUM(LINK_TRANSFER_RESULT, LINK_TRANSFER_RESULT_VALUES)
 
 DEFINE_ENUM(LINK_DELIVERY_SETTLE_REASON, LINK_DELIVERY_SETTLE_REASON_VALUES)
 
+#define LINK_CREDIT_POLICY_VALUES \
+    LINK_CREDIT_POLICY_REFILL_AT_ZERO, \
+    LINK_CREDIT_POLICY_LOW_WATER_MARK
+
+DEFINE_ENUM(LINK_CREDIT_POLICY, LINK_CREDIT_POLICY_VALUES)
+
+#define LINK_DRAIN_RESULT_VALUES \
+    LINK_DRAIN_RESULT_CREDIT_USED, \
+    LINK_DRAIN_RESULT_DRAINED, \
+    LINK_DRAIN_RESULT_TIMEOUT
+
+DEFINE_ENUM(LINK_DRAIN_RESULT, LINK_DRAIN_RESULT_VALUES)
+
+#define LINK_SETTLE_LATENCY_BUCKET_COUNT 16
+
+/* the longest delivery tag a link produces, see link_set_delivery_tag_length */
+#define LINK_MAX_DELIVERY_TAG_LENGTH 8
+
+typedef struct LINK_STATS_TAG
+{
+    uint64_t transfers_sent;
+    uint64_t transfers_received;
+    uint64_t flows_received;
+    uint64_t dispositions_received;
+    /* unsettled deliveries settled by a disposition from the peer */
+    uint64_t deliveries_settled;
+    /* transfers refused with LINK_TRANSFER_BUSY because the link had no credit or the session window was exhausted */
+    uint64_t credit_stalls;
+    uint64_t session_window_stalls;
+    /* send to settle latency of deliveries_settled: bucket 0 counts latencies under 1 ms,
+       bucket i those in [2^(i-1), 2^i) ms and the last bucket everything longer */
+    uint64_t settle_latency_histogram[LINK_SETTLE_LATENCY_BUCKET_COUNT];
+} LINK_STATS;
+
 typedef void(*ON_DELIVERY_SETTLED)(void* context, delivery_number delivery_no, LINK_DELIVERY_SETTLE_REASON reason, AMQP_VALUE delivery_state);
 typedef AMQP_VALUE(*ON_TRANSFER_RECEIVED)(void* context, TRANSFER_HANDLE transfer, uint32_t payload_size, const unsigned char* payload_bytes);
+typedef AMQP_VALUE(*ON_TRANSFER_FRAME_RECEIVED)(void* context, TRANSFER_HANDLE transfer, bool more, uint32_t payload_size, const unsigned char* payload_bytes);
 typedef void(*ON_LINK_STATE_CHANGED)(void* context, LINK_STATE new_link_state, LINK_STATE previous_link_state);
 typedef void(*ON_LINK_FLOW_ON)(void* context);
+typedef void(*ON_LINK_DISPOSITION_PROCESSED)(void* context);
+typedef void(*ON_LINK_DRAINED)(void* context, LINK_DRAIN_RESULT drain_result);
 
 MOCKABLE_FUNCTION(, LINK_HANDLE, link_create, SESSION_HANDLE, session, const char*, name, role, role, AMQP_VALUE, source, AMQP_VALUE, target);
 MOCKABLE_FUNCTION(, LINK_HANDLE, link_create_from_endpoint, SESSION_HANDLE, session, LINK_ENDPOINT_HANDLE, link_endpoint, const char*, name, role, role, AMQP_VALUE, source, AMQP_VALUE, target);
@@ -63,14 +100,62 @@ MOCKABLE_FUNCTION(, int, link_get_initial_delivery_count, LINK_HANDLE, link, seq
 MOCKABLE_FUNCTION(, int, link_set_max_message_size, LINK_HANDLE, link, uint64_t, max_message_size);
 MOCKABLE_FUNCTION(, int, link_get_max_message_size, LINK_HANDLE, link, uint64_t*, max_message_size);
 MOCKABLE_FUNCTION(, int, link_get_peer_max_message_size, LINK_HANDLE, link, uint64_t*, peer_max_message_size);
+MOCKABLE_FUNCTION(, int, link_get_stats, LINK_HANDLE, link, LINK_STATS*, stats);
 MOCKABLE_FUNCTION(, int, link_set_attach_properties, LINK_HANDLE, link, fields, attach_properties);
+/* the unsettled map (delivery tag to delivery state) sent with the next attach, and the one the peer sent with its attach,
+   which stays owned by the link and is valid until the next attach is received or the link is destroyed (NULL if absent) */
+MOCKABLE_FUNCTION(, int, link_set_attach_unsettled, LINK_HANDLE, link, AMQP_VALUE, unsettled);
+MOCKABLE_FUNCTION(, int, link_get_peer_unsettled, LINK_HANDLE, link, AMQP_VALUE*, peer_unsettled);
+MOCKABLE_FUNCTION(, int, link_get_delivery_count, LINK_HANDLE, link, sequence_no*, delivery_count);
 MOCKABLE_FUNCTION(, int, link_set_max_link_credit, LINK_HANDLE, link, uint32_t, max_link_credit);
+MOCKABLE_FUNCTION(, int, link_set_credit_policy, LINK_HANDLE, link, LINK_CREDIT_POLICY, credit_policy, uint32_t, low_water_mark);
+/* bounds the bytes of the deliveries a receiver got and did not settle yet: credit is only issued again once they drop to
+   resume_buffered_bytes, and then as much as the average delivery size lets fit under max_buffered_bytes (0 turns it off) */
+MOCKABLE_FUNCTION(, int, link_set_max_buffered_bytes, LINK_HANDLE, link, uint64_t, max_buffered_bytes, uint64_t, resume_buffered_bytes);
+MOCKABLE_FUNCTION(, int, link_pause_flow, LINK_HANDLE, link);
+MOCKABLE_FUNCTION(, int, link_resume_flow, LINK_HANDLE, link);
+/* an attached receiver gives the sender link_credit with drain set, so the sender sends what it has available right away and
+   gives back the rest. on_link_drained is called once the last delivery the credit allowed has been indicated, once the sender
+   answered the drain or, with a non-zero timeout, after timeout ms (the credit is then withdrawn). The link flow is paused by a
+   drain, so no credit is issued after it until the next drain or link_resume_flow. A drain ends without on_link_drained being
+   called when the link detaches. */
+MOCKABLE_FUNCTION(, int, link_drain, LINK_HANDLE, link, uint32_t, link_credit, tickcounter_ms_t, timeout, ON_LINK_DRAINED, on_link_drained, void*, context);
+/* with a max_batch_size above 1, accepted and released dispositions are held back and sent as one disposition per range of
+   consecutive delivery ids with the same outcome, whatever the order the deliveries were settled in. They go out once
+   max_batch_size deliveries are held, max_delay ms after the first one (checked in connection_dowork and link_dowork), when a
+   delivery is settled too far from the held ones, before any other outcome and on detach. Ranges that cannot be sent stay held
+   and are sent again by the next of these. */
+MOCKABLE_FUNCTION(, int, link_set_disposition_batching, LINK_HANDLE, link, uint32_t, max_batch_size, tickcounter_ms_t, max_delay);
+/* the delivery state carried by the transfers started from now on, e.g. a transactional-state without outcome to send as part
+   of a transaction (see messaging_delivery_transactional), NULL to stop */
+MOCKABLE_FUNCTION(, int, link_set_transfer_state, LINK_HANDLE, link, AMQP_VALUE, transfer_state);
+MOCKABLE_FUNCTION(, int, link_set_delivery_tag_length, LINK_HANDLE, link, uint32_t, delivery_tag_length);
+MOCKABLE_FUNCTION(, int, link_set_on_transfer_frame_received, LINK_HANDLE, link, ON_TRANSFER_FRAME_RECEIVED, on_transfer_frame_received);
+MOCKABLE_FUNCTION(, int, link_set_on_disposition_processed, LINK_HANDLE, link, ON_LINK_DISPOSITION_PROCESSED, on_disposition_processed);
 MOCKABLE_FUNCTION(, int, link_get_name, LINK_HANDLE, link, const char**, link_name);
+/* message senders use it to report their flow events to the connection, connection is NULL if the session could not give it */
+MOCKABLE_FUNCTION(, int, link_get_connection, LINK_HANDLE, link, CONNECTION_HANDLE*, connection);
 MOCKABLE_FUNCTION(, int, link_get_received_message_id, LINK_HANDLE, link, delivery_number*, message_id);
 MOCKABLE_FUNCTION(, int, link_send_disposition, LINK_HANDLE, link, delivery_number, message_number, AMQP_VALUE, delivery_state);
+/* Saved once the link is attached and has no delivery, disposition or drain in flight, i.e. every delivery sent or received is
+   settled, restored on a link of the same name and role created on a restored session, before link_attach: the link then
+   takes the handles, delivery count and credit it had and is attached again without an attach frame when its session is
+   mapped, see connection_save_handover_state. The source, target and properties are not part of the state. */
+MOCKABLE_FUNCTION(, int, link_save_handover_state, LINK_HANDLE, link, unsigned char*, buffer, size_t, buffer_size, size_t*, length);
+MOCKABLE_FUNCTION(, int, link_restore_handover_state, LINK_HANDLE, link, const unsigned char*, bytes, size_t, length);
 MOCKABLE_FUNCTION(, int, link_attach, LINK_HANDLE, link, ON_TRANSFER_RECEIVED, on_transfer_received, ON_LINK_STATE_CHANGED, on_link_state_changed, ON_LINK_FLOW_ON, on_link_flow_on, void*, callback_context);
 MOCKABLE_FUNCTION(, int, link_detach, LINK_HANDLE, link, bool, close);
+/* the tag link_transfer_async gives the next delivery, delivery_tag_bytes must hold LINK_MAX_DELIVERY_TAG_LENGTH bytes */
+MOCKABLE_FUNCTION(, int, link_get_next_delivery_tag, LINK_HANDLE, link, unsigned char*, delivery_tag_bytes, uint32_t*, delivery_tag_length);
 MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, link_transfer_async, LINK_HANDLE, handle, message_format, message_format, PAYLOAD*, payloads, size_t, payload_count, ON_DELIVERY_SETTLED, on_delivery_settled, void*, callback_context, LINK_TRANSFER_RESULT*, link_transfer_result,tickcounter_ms_t, timeout);
+MOCKABLE_FUNCTION(, int, link_transfer_settled, LINK_HANDLE, link, message_format, message_format, PAYLOAD*, payloads, size_t, payload_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context, LINK_TRANSFER_RESULT*, link_transfer_result);
+/* a streamed delivery is sent in parts as they are produced: link_transfer_stream_async sends the first part and tracks the delivery
+   like link_transfer_async, link_transfer_stream_continue sends the following ones and the part sent with more set to false ends it.
+   on_part_sent is called once the I/O is done with each part, so that a producer can bound the parts it holds. No other transfer is
+   sent on the link until the delivery ends. Cancelling the returned operation, or the delivery timing out or being settled by the
+   peer before its last part, aborts the delivery. Only links with the unsettled sender settle mode stream deliveries. */
+MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, link_transfer_stream_async, LINK_HANDLE, link, message_format, message_format, PAYLOAD*, payloads, size_t, payload_count, bool, more, ON_SEND_COMPLETE, on_part_sent, void*, on_part_sent_context, ON_DELIVERY_SETTLED, on_delivery_settled, void*, callback_context, LINK_TRANSFER_RESULT*, link_transfer_result, tickcounter_ms_t, timeout);
+MOCKABLE_FUNCTION(, int, link_transfer_stream_continue, LINK_HANDLE, link, PAYLOAD*, payloads, size_t, payload_count, bool, more, ON_SEND_COMPLETE, on_part_sent, void*, on_part_sent_context);
 MOCKABLE_FUNCTION(, void, link_dowork, LINK_HANDLE, link);
 
 
@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef LOCK_FREE_STACK_H
+#define LOCK_FREE_STACK_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    /* An intrusive multiple producer, single consumer stack: any thread may push, one thread takes all the entries at once.
+       The entry is embedded as the first member of the structure being queued, which owns its memory. */
+    typedef struct LOCK_FREE_STACK_ENTRY_TAG
+    {
+        struct LOCK_FREE_STACK_ENTRY_TAG* next;
+    } LOCK_FREE_STACK_ENTRY;
+
+    typedef struct LOCK_FREE_STACK_TAG
+    {
+        LOCK_FREE_STACK_ENTRY* volatile head;
+    } LOCK_FREE_STACK;
+
+    MOCKABLE_FUNCTION(, void, lock_free_stack_init, LOCK_FREE_STACK*, stack);
+    MOCKABLE_FUNCTION(, void, lock_free_stack_push, LOCK_FREE_STACK*, stack, LOCK_FREE_STACK_ENTRY*, entry);
+    /* Returns the entries pushed so far, linked through next in the order they were pushed, and leaves the stack empty. */
+    MOCKABLE_FUNCTION(, LOCK_FREE_STACK_ENTRY*, lock_free_stack_take_all, LOCK_FREE_STACK*, stack);
+    MOCKABLE_FUNCTION(, bool, lock_free_stack_is_empty, LOCK_FREE_STACK*, stack);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOCK_FREE_STACK_H */
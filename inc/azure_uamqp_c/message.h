@@ -21,6 +21,7 @@ extern "C" {
 #else
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 #endif /* __cplusplus */
 
 #include "azure_c_shared_utility/umock_c_prod.h"
@@ -40,22 +41,58 @@ extern "C" {
         size_t length;
     } BINARY_DATA;
 
+    /* The message annotations brokers such as Event Hubs and Service Bus stamp on every received message */
+    typedef struct MESSAGE_BROKER_ANNOTATIONS_TAG
+    {
+        bool has_sequence_number;
+        /* x-opt-sequence-number */
+        int64_t sequence_number;
+        bool has_enqueued_time;
+        /* x-opt-enqueued-time */
+        timestamp enqueued_time;
+        /* x-opt-offset and x-opt-partition-key, NULL when absent */
+        const char* offset;
+        const char* partition_key;
+    } MESSAGE_BROKER_ANNOTATIONS;
+
+    /* Called once no message references the bytes of a data section added with message_add_body_amqp_data_external anymore,
+       for example to unmap the file region the bytes were mapped from. */
+    typedef void(*ON_BODY_AMQP_DATA_RELEASED)(void* context);
+
     MOCKABLE_FUNCTION(, MESSAGE_HANDLE, message_create);
     MOCKABLE_FUNCTION(, MESSAGE_HANDLE, message_clone, MESSAGE_HANDLE, source_message);
     MOCKABLE_FUNCTION(, void, message_destroy, MESSAGE_HANDLE, message);
+    MOCKABLE_FUNCTION(, int, message_reset, MESSAGE_HANDLE, message);
     MOCKABLE_FUNCTION(, int, message_set_header, MESSAGE_HANDLE, message, HEADER_HANDLE, message_header);
+    MOCKABLE_FUNCTION(, int, message_take_header, MESSAGE_HANDLE, message, HEADER_HANDLE, message_header);
     MOCKABLE_FUNCTION(, int, message_get_header, MESSAGE_HANDLE, message, HEADER_HANDLE*, message_header);
     MOCKABLE_FUNCTION(, int, message_set_delivery_annotations, MESSAGE_HANDLE, message, delivery_annotations, annotations);
     MOCKABLE_FUNCTION(, int, message_get_delivery_annotations, MESSAGE_HANDLE, message, delivery_annotations*, annotations);
     MOCKABLE_FUNCTION(, int, message_set_message_annotations, MESSAGE_HANDLE, message, message_annotations, annotations);
     MOCKABLE_FUNCTION(, int, message_get_message_annotations, MESSAGE_HANDLE, message, message_annotations*, annotations);
+    /* Reads the broker annotations without cloning the message annotations. They are looked up once and kept until the
+       message annotations change, the strings stay valid until then. Annotations of another type count as absent. */
+    MOCKABLE_FUNCTION(, int, message_get_broker_annotations, MESSAGE_HANDLE, message, MESSAGE_BROKER_ANNOTATIONS*, broker_annotations);
     MOCKABLE_FUNCTION(, int, message_set_properties, MESSAGE_HANDLE, message, PROPERTIES_HANDLE, properties);
+    MOCKABLE_FUNCTION(, int, message_take_properties, MESSAGE_HANDLE, message, PROPERTIES_HANDLE, properties);
     MOCKABLE_FUNCTION(, int, message_get_properties, MESSAGE_HANDLE, message, PROPERTIES_HANDLE*, properties);
     MOCKABLE_FUNCTION(, int, message_set_application_properties, MESSAGE_HANDLE, message, AMQP_VALUE, application_properties);
     MOCKABLE_FUNCTION(, int, message_get_application_properties, MESSAGE_HANDLE, message, AMQP_VALUE*, application_properties);
+    MOCKABLE_FUNCTION(, int, message_set_message_id_string, MESSAGE_HANDLE, message, const char*, message_id);
+    MOCKABLE_FUNCTION(, int, message_set_correlation_id_string, MESSAGE_HANDLE, message, const char*, correlation_id);
+    MOCKABLE_FUNCTION(, int, message_set_subject, MESSAGE_HANDLE, message, const char*, subject);
+    MOCKABLE_FUNCTION(, int, message_set_content_type, MESSAGE_HANDLE, message, const char*, content_type);
+    MOCKABLE_FUNCTION(, int, message_set_application_property_string, MESSAGE_HANDLE, message, const char*, name, const char*, value);
+    MOCKABLE_FUNCTION(, int, message_set_application_property_long, MESSAGE_HANDLE, message, const char*, name, int64_t, value);
     MOCKABLE_FUNCTION(, int, message_set_footer, MESSAGE_HANDLE, message, annotations, footer);
     MOCKABLE_FUNCTION(, int, message_get_footer, MESSAGE_HANDLE, message, annotations*, footer);
     MOCKABLE_FUNCTION(, int, message_add_body_amqp_data, MESSAGE_HANDLE, message, BINARY_DATA, amqp_data);
+    MOCKABLE_FUNCTION(, int, message_add_body_amqp_data_borrowed, MESSAGE_HANDLE, message, BINARY_DATA, amqp_data);
+    /* Copies the borrowed data sections of the body, so that the message no longer references the bytes it borrowed from. */
+    MOCKABLE_FUNCTION(, int, message_own_body_amqp_data, MESSAGE_HANDLE, message);
+    /* Adds a data section that is neither copied nor freed: clones of the message share the bytes, and on_released is called when the last of them is destroyed.
+       This lets large bodies such as memory-mapped file regions be sent without ever being copied into the heap. */
+    MOCKABLE_FUNCTION(, int, message_add_body_amqp_data_external, MESSAGE_HANDLE, message, BINARY_DATA, amqp_data, ON_BODY_AMQP_DATA_RELEASED, on_released, void*, on_released_context);
     MOCKABLE_FUNCTION(, int, message_get_body_amqp_data_in_place, MESSAGE_HANDLE, message, size_t, index, BINARY_DATA*, amqp_data);
     MOCKABLE_FUNCTION(, int, message_get_body_amqp_data_count, MESSAGE_HANDLE, message, size_t*, count);
     MOCKABLE_FUNCTION(, int, message_set_body_amqp_value, MESSAGE_HANDLE, message, AMQP_VALUE, body_amqp_value);
@@ -66,6 +103,7 @@ extern "C" {
     MOCKABLE_FUNCTION(, int, message_get_body_type, MESSAGE_HANDLE, message, MESSAGE_BODY_TYPE*, body_type);
     MOCKABLE_FUNCTION(, int, message_set_message_format, MESSAGE_HANDLE, message, uint32_t, message_format);
     MOCKABLE_FUNCTION(, int, message_get_message_format, MESSAGE_HANDLE, message, uint32_t*, message_format);
+    MOCKABLE_FUNCTION(, int, message_get_encoded_size, MESSAGE_HANDLE, message, size_t*, encoded_size);
 
 #ifdef __cplusplus
 }
@@ -7,6 +7,8 @@
 #include "azure_uamqp_c/link.h"
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/amqp_definitions_delivery_number.h"
+#include "azure_uamqp_c/columnar_batch.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/macro_utils.h"
 
@@ -25,9 +27,42 @@ extern "C" {
 
 DEFINE_ENUM(MESSAGE_RECEIVER_STATE, MESSAGE_RECEIVER_STATE_VALUES)
 
+#define MESSAGE_RECEIVER_BATCH_RESULT_VALUES \
+    MESSAGE_RECEIVER_BATCH_RESULT_OK, \
+    MESSAGE_RECEIVER_BATCH_RESULT_TIMEOUT, \
+    MESSAGE_RECEIVER_BATCH_RESULT_CANCELLED
+
+DEFINE_ENUM(MESSAGE_RECEIVER_BATCH_RESULT, MESSAGE_RECEIVER_BATCH_RESULT_VALUES)
+
+/* sections of the bare message that the message receiver decodes, see messagereceiver_set_decoded_sections */
+#define MESSAGE_RECEIVER_SECTION_HEADER                 0x01
+#define MESSAGE_RECEIVER_SECTION_DELIVERY_ANNOTATIONS   0x02
+#define MESSAGE_RECEIVER_SECTION_MESSAGE_ANNOTATIONS    0x04
+#define MESSAGE_RECEIVER_SECTION_PROPERTIES             0x08
+#define MESSAGE_RECEIVER_SECTION_APPLICATION_PROPERTIES 0x10
+#define MESSAGE_RECEIVER_SECTION_BODY                   0x20
+#define MESSAGE_RECEIVER_SECTION_FOOTER                 0x40
+#define MESSAGE_RECEIVER_SECTION_ALL                    0x7F
+
     typedef struct MESSAGE_RECEIVER_INSTANCE_TAG* MESSAGE_RECEIVER_HANDLE;
     typedef AMQP_VALUE (*ON_MESSAGE_RECEIVED)(const void* context, MESSAGE_HANDLE message);
+    /* called with the body data of a message as it arrives, see messagereceiver_set_on_body_data_received */
+    typedef void(*ON_MESSAGE_BODY_DATA_RECEIVED)(const void* context, MESSAGE_HANDLE message, const unsigned char* bytes, size_t length);
+    /* called with the encoded sections of a message as they were transferred, valid only during the call, see messagereceiver_set_on_raw_message_received */
+    typedef AMQP_VALUE(*ON_RAW_MESSAGE_RECEIVED)(const void* context, message_format message_format, const unsigned char* bytes, size_t length);
     typedef void(*ON_MESSAGE_RECEIVER_STATE_CHANGED)(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state);
+    /* messages and message_ids are only valid during the call, see messagereceiver_receive_batch_async */
+    typedef void(*ON_MESSAGE_BATCH_RECEIVED)(void* context, MESSAGE_RECEIVER_BATCH_RESULT batch_result, MESSAGE_HANDLE* messages, delivery_number* message_ids, uint32_t message_count);
+    /* the application owns batch again once this is called, see messagereceiver_receive_columnar_batch_async */
+    typedef void(*ON_COLUMNAR_BATCH_RECEIVED)(void* context, MESSAGE_RECEIVER_BATCH_RESULT batch_result, COLUMNAR_BATCH_HANDLE batch);
+    typedef struct MESSAGE_DISPATCH_INSTANCE_TAG* MESSAGE_DISPATCH_HANDLE;
+    /* hands message over to the application's worker threads, see messagereceiver_set_ordered_dispatch */
+    typedef void(*ON_MESSAGE_DISPATCH)(void* context, MESSAGE_DISPATCH_HANDLE dispatch, MESSAGE_HANDLE message);
+    /* decodes (typically decompresses) one data section into bytes, allocated with malloc and freed by the message.
+       Returning non-zero fails the decoding of the message. */
+    typedef int(*ON_MESSAGE_BODY_DECODE)(void* context, const unsigned char* encoded_bytes, size_t encoded_length, unsigned char** bytes, size_t* length);
+    /* deserializes (or reads in place) the body of message, valid only during the call, see messagereceiver_set_body_codec */
+    typedef AMQP_VALUE(*ON_MESSAGE_BODY_VIEW_RECEIVED)(void* context, MESSAGE_HANDLE message, const unsigned char* body, size_t body_length);
 
     MOCKABLE_FUNCTION(, MESSAGE_RECEIVER_HANDLE, messagereceiver_create, LINK_HANDLE, link, ON_MESSAGE_RECEIVER_STATE_CHANGED, on_message_receiver_state_changed, void*, context);
     MOCKABLE_FUNCTION(, void, messagereceiver_destroy, MESSAGE_RECEIVER_HANDLE, message_receiver);
@@ -37,6 +72,96 @@ DEFINE_ENUM(MESSAGE_RECEIVER_STATE, MESSAGE_RECEIVER_STATE_VALUES)
     MOCKABLE_FUNCTION(, int, messagereceiver_get_received_message_id, MESSAGE_RECEIVER_HANDLE, message_receiver, delivery_number*, message_number);
     MOCKABLE_FUNCTION(, int, messagereceiver_send_message_disposition, MESSAGE_RECEIVER_HANDLE, message_receiver, const char*, link_name, delivery_number, message_number, AMQP_VALUE, delivery_state);
     MOCKABLE_FUNCTION(, void, messagereceiver_set_trace, MESSAGE_RECEIVER_HANDLE, message_receiver, bool, trace_on);
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_decoded_sections, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, decoded_sections);
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_message_recycling, MESSAGE_RECEIVER_HANDLE, message_receiver, bool, recycle_messages);
+    /* bounds the decoding of the received messages, see amqpvalue_decoder_set_limits; 0 means no limit. A message breaching
+       a limit fails to decode like any malformed message. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_decoder_limits, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, max_depth, size_t, max_element_count, size_t, max_allocated_bytes);
+    /* only valid from within on_message_received: the application becomes the owner of message (and destroys it with message_destroy),
+       and can settle it later with messagereceiver_send_message_disposition by returning NULL from the callback */
+    MOCKABLE_FUNCTION(, int, messagereceiver_take_message, MESSAGE_RECEIVER_HANDLE, message_receiver, MESSAGE_HANDLE, message);
+    /* A message received with the batched message format (AMQP_BATCHED_MESSAGE_FORMAT, as sent by messagesender_send_batch_async
+       and by Event Hubs) carries one encoded message in each data section of its body. messagereceiver_get_batched_message_count
+       gives their number without decoding them (it fails for a message that is not a batch), and
+       messagereceiver_decode_batched_message decodes the one at index only when it is asked for. The data sections of the
+       returned message are not copied, they point into the body of batch_message: it is destroyed with message_destroy before
+       batch_message, and is only valid as long as batch_message is (so messagereceiver_take_message the batch to keep its
+       messages past on_message_received). It is decoded on the thread running the connection, with the body decoding of the
+       receiver, and is never checked for duplicates. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_get_batched_message_count, MESSAGE_HANDLE, batch_message, size_t*, count);
+    MOCKABLE_FUNCTION(, MESSAGE_HANDLE, messagereceiver_decode_batched_message, MESSAGE_RECEIVER_HANDLE, message_receiver, MESSAGE_HANDLE, batch_message, size_t, index);
+    /* once set, received messages are not decoded: each one is given to on_raw_message_received, with the callback context given
+       to messagereceiver_open, instead of on_message_received, and settled with the delivery state it returns. The bytes can be
+       forwarded as they are with messagesender_send_raw_async. Batches, duplicate detection, ordered dispatch and body decoding
+       do not apply to raw messages, and bodies cannot be streamed with messagereceiver_set_on_body_data_received at the same time.
+       Giving NULL turns it off. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_on_raw_message_received, MESSAGE_RECEIVER_HANDLE, message_receiver, ON_RAW_MESSAGE_RECEIVED, on_raw_message_received);
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_on_body_data_received, MESSAGE_RECEIVER_HANDLE, message_receiver, ON_MESSAGE_BODY_DATA_RECEIVED, on_body_data_received);
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_disposition_batching, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, max_batch_size, tickcounter_ms_t, max_delay);
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_prefetch, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, prefetch_count);
+    /* bounds the bytes of the received messages that are not settled yet, see link_set_max_buffered_bytes */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_max_buffered_bytes, MESSAGE_RECEIVER_HANDLE, message_receiver, uint64_t, max_buffered_bytes, uint64_t, resume_buffered_bytes);
+    MOCKABLE_FUNCTION(, int, messagereceiver_pause, MESSAGE_RECEIVER_HANDLE, message_receiver);
+    MOCKABLE_FUNCTION(, int, messagereceiver_resume, MESSAGE_RECEIVER_HANDLE, message_receiver);
+    /* pulls up to max_count messages with a drain: the link credit is set to max_count and the sender sends what it has right away.
+       The batch completes with MESSAGE_RECEIVER_BATCH_RESULT_OK once max_count messages arrived or the sender has no more, with
+       MESSAGE_RECEIVER_BATCH_RESULT_TIMEOUT after timeout ms (0 waits for the sender), or with MESSAGE_RECEIVER_BATCH_RESULT_CANCELLED
+       when the receiver closes or the link detaches. The messages of the batch are not given to on_message_received, the application
+       owns them (and destroys them with message_destroy) and settles them with messagereceiver_send_message_disposition and their
+       message_ids. No credit is issued after a batch until the next one or messagereceiver_resume. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_receive_batch_async, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, max_count, tickcounter_ms_t, timeout, ON_MESSAGE_BATCH_RECEIVED, on_batch_received, void*, context);
+    /* pulls messages like messagereceiver_receive_batch_async, as many as batch has rows, but lays each one out in batch (which
+       is cleared first) straight from its transfer, without creating a MESSAGE_HANDLE: on_message_received, duplicate detection,
+       ordered dispatch and body decoding do not apply to them. A message that cannot be read is rejected. The application
+       settles the rows with messagereceiver_send_message_disposition and their delivery ids, and does not touch batch until
+       on_columnar_batch_received is called. It cannot be used while bodies are streamed. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_receive_columnar_batch_async, MESSAGE_RECEIVER_HANDLE, message_receiver, COLUMNAR_BATCH_HANDLE, batch, tickcounter_ms_t, timeout, ON_COLUMNAR_BATCH_RECEIVED, on_columnar_batch_received, void*, context);
+    /* remembers the message-ids (properties message-id) of the last max_message_ids messages received within window ms (0 for no
+       time limit, tick_counter is then not needed). A message whose message-id is remembered is accepted without being given to
+       on_message_received or to a batch, and its sections after the properties are not decoded. The properties are decoded even
+       when messagereceiver_set_decoded_sections leaves them out. Messages without a message-id and messages whose body is streamed
+       with messagereceiver_set_on_body_data_received are not checked. A max_message_ids of 0 turns duplicate detection off. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_duplicate_detection, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, max_message_ids, tickcounter_ms_t, window, TICK_COUNTER_HANDLE, tick_counter);
+    /* once set, received messages are given to on_message_dispatch instead of on_message_received, on the thread running the
+       connection, for the application to process them on its own worker threads. At most max_in_flight messages are dispatched
+       and not completed at a time, and a message is only dispatched once the earlier ones with the same key completed. The key
+       is the message annotation named key_annotation, or the group-id when key_annotation is NULL; messages without a key are
+       not ordered. The receiver owns message until the worker calls messagereceiver_complete_dispatch, from any thread, with
+       the delivery state to settle it with; messagereceiver_dowork then settles it and dispatches the messages waiting for it.
+       No credit is issued while max_in_flight messages wait to be dispatched. All dispatched messages have to be completed
+       before the receiver is destroyed, and before the dispatch is changed. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_ordered_dispatch, MESSAGE_RECEIVER_HANDLE, message_receiver, ON_MESSAGE_DISPATCH, on_message_dispatch, void*, context, uint32_t, max_in_flight, const char*, key_annotation);
+    /* once set, the data sections of a message whose content-encoding property is content_encoding are given to the application
+       as decoded by on_body_decode (see messagesender_set_body_encoding), the content-encoding property being left as it is.
+       The properties are decoded even when messagereceiver_set_decoded_sections leaves them out. Bodies given to
+       on_body_data_received are not decoded. Giving a NULL content_encoding and on_body_decode turns it off. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_body_decoding, MESSAGE_RECEIVER_HANDLE, message_receiver, const char*, content_encoding, ON_MESSAGE_BODY_DECODE, on_body_decode, void*, context);
+    /* once set, a message whose content-type property is content_type and whose body is data sections is given to
+       on_body_view_received instead of on_message_received, and settled with the delivery state it returns. The body is given
+       as a view of the received payload when it is one data section (e.g. a FlatBuffers buffer that is then read in place),
+       so that a schema-based codec deserializes it without copying; several data sections are joined first. The view and the
+       message are only valid during the call, and the message cannot be taken. The properties, and the body of such a message,
+       are decoded even when messagereceiver_set_decoded_sections leaves them out. Messages going to a batch, to the receive
+       ring or to ordered dispatch are not given to it, and body decoding applies before it (see
+       messagesender_set_body_codec). Giving a NULL content_type and on_body_view_received turns it off. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_body_codec, MESSAGE_RECEIVER_HANDLE, message_receiver, const char*, content_type, ON_MESSAGE_BODY_VIEW_RECEIVED, on_body_view_received, void*, context);
+    /* once set with a capacity other than 0 (rounded up to a power of 2), received messages are not given to on_message_received
+       but put in a lock-free single producer single consumer ring of that capacity, for one application thread to pull them with
+       messagereceiver_try_receive, which gives NULL right away when the ring is empty, or messagereceiver_receive_wait, which
+       waits up to timeout ms for one (0 waits until one arrives) and also gives NULL when none came. The ring is filled on the
+       thread running the connection, which only takes a lock to wake up a thread waiting in messagereceiver_receive_wait. As
+       with ordered dispatch the receiver owns a pulled message until messagereceiver_complete_dispatch is called with its
+       dispatch, from any thread, and messagereceiver_dowork settles it. No credit is issued while the ring is more than half
+       full, so with a prefetch of at most half the capacity no message finds the ring full; one that does is released. Messages
+       left in the ring when the receiver is destroyed are not settled. The ring cannot be used with ordered dispatch, and is
+       only changed or turned off (capacity 0) once all the messages put in it were pulled and completed. */
+    MOCKABLE_FUNCTION(, int, messagereceiver_set_receive_ring, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, capacity);
+    MOCKABLE_FUNCTION(, int, messagereceiver_try_receive, MESSAGE_RECEIVER_HANDLE, message_receiver, MESSAGE_DISPATCH_HANDLE*, dispatch, MESSAGE_HANDLE*, message);
+    MOCKABLE_FUNCTION(, int, messagereceiver_receive_wait, MESSAGE_RECEIVER_HANDLE, message_receiver, uint32_t, timeout, MESSAGE_DISPATCH_HANDLE*, dispatch, MESSAGE_HANDLE*, message);
+    /* takes ownership of delivery_state */
+    MOCKABLE_FUNCTION(, int, messagereceiver_complete_dispatch, MESSAGE_DISPATCH_HANDLE, dispatch, AMQP_VALUE, delivery_state);
+    /* settles the completed dispatches and runs link_dowork */
+    MOCKABLE_FUNCTION(, void, messagereceiver_dowork, MESSAGE_RECEIVER_HANDLE, message_receiver);
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,7 @@
 #include "azure_uamqp_c/message.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_uamqp_c/async_operation.h"
+#include "azure_uamqp_c/timer_wheel.h"
 #include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/macro_utils.h"
@@ -21,7 +22,8 @@ extern "C" {
     MESSAGE_SEND_OK, \
     MESSAGE_SEND_ERROR, \
     MESSAGE_SEND_TIMEOUT, \
-    MESSAGE_SEND_CANCELLED
+    MESSAGE_SEND_CANCELLED, \
+    MESSAGE_SEND_EXPIRED
 
 DEFINE_ENUM(MESSAGE_SEND_RESULT, MESSAGE_SEND_RESULT_VALUES)
 
@@ -34,16 +36,128 @@ DEFINE_ENUM(MESSAGE_SEND_RESULT, MESSAGE_SEND_RESULT_VALUES)
 
 DEFINE_ENUM(MESSAGE_SENDER_STATE, MESSAGE_SENDER_STATE_VALUES)
 
+/* message format of a batch whose data sections each hold one complete encoded message */
+#define AMQP_BATCHED_MESSAGE_FORMAT 0x80013700
+
     typedef struct MESSAGE_SENDER_INSTANCE_TAG* MESSAGE_SENDER_HANDLE;
+    typedef struct ENCODED_MESSAGE_INSTANCE_TAG* ENCODED_MESSAGE_HANDLE;
+    typedef struct MESSAGE_TEMPLATE_INSTANCE_TAG* MESSAGE_TEMPLATE_HANDLE;
     typedef void(*ON_MESSAGE_SEND_COMPLETE)(void* context, MESSAGE_SEND_RESULT send_result);
     typedef void(*ON_MESSAGE_SENDER_STATE_CHANGED)(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state);
+    typedef void(*ON_MESSAGE_SENDER_READY)(void* context);
+    /* reads at most buffer_size bytes of a streamed body into buffer. Setting bytes_read to 0 without is_end means that nothing is
+       ready yet, the read is tried again by the next messagesender_dowork. Returning non-zero fails the send. */
+    typedef int(*ON_MESSAGE_BODY_READ)(void* context, unsigned char* buffer, size_t buffer_size, size_t* bytes_read, bool* is_end);
+    /* encodes (typically compresses) one data section into encoded_bytes, allocated with malloc and freed by the sender.
+       Returning non-zero fails the send. */
+    typedef int(*ON_MESSAGE_BODY_ENCODE)(void* context, const unsigned char* bytes, size_t length, unsigned char** encoded_bytes, size_t* encoded_length);
+    /* called with a NULL buffer to get in length the size of the serialized body, then with a buffer of that size to serialize
+       body into it, setting length to the bytes written. Returning non-zero fails the send. */
+    typedef int(*ON_MESSAGE_BODY_SERIALIZE)(void* context, const void* body, unsigned char* buffer, size_t buffer_size, size_t* length);
+
+    typedef struct MESSAGE_SEND_COMPLETION_TAG
+    {
+        void* context;
+        MESSAGE_SEND_RESULT send_result;
+    } MESSAGE_SEND_COMPLETION;
+
+    typedef void(*ON_MESSAGE_SEND_COMPLETE_BATCH)(void* context, const MESSAGE_SEND_COMPLETION* completions, size_t completion_count);
 
     MOCKABLE_FUNCTION(, MESSAGE_SENDER_HANDLE, messagesender_create, LINK_HANDLE, link, ON_MESSAGE_SENDER_STATE_CHANGED, on_message_sender_state_changed, void*, context);
     MOCKABLE_FUNCTION(, void, messagesender_destroy, MESSAGE_SENDER_HANDLE, message_sender);
     MOCKABLE_FUNCTION(, int, messagesender_open, MESSAGE_SENDER_HANDLE, message_sender);
     MOCKABLE_FUNCTION(, int, messagesender_close, MESSAGE_SENDER_HANDLE, message_sender);
+    /* closes an open sender without failing its pending sends: new sends are refused right away, while the pending ones keep
+       being transferred and settled by messagesender_dowork, which detaches the link once they are all done or drain_timeout
+       ms of tick_counter have passed (0 waits for them however long it takes). The sends still pending at the deadline fail as
+       with messagesender_close. To shut down in one write, hold the outgoing batch of the connection (see
+       connection_hold_outgoing_batch) around the last messagesender_dowork calls, session_end and connection_close. */
+    MOCKABLE_FUNCTION(, int, messagesender_close_drained, MESSAGE_SENDER_HANDLE, message_sender, TICK_COUNTER_HANDLE, tick_counter, tickcounter_ms_t, drain_timeout);
     MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, messagesender_send_async, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_HANDLE, message, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
+    MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, messagesender_send_encoded_async, MESSAGE_SENDER_HANDLE, message_sender, ENCODED_MESSAGE_HANDLE, encoded_message, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
+    /* sends length bytes of encoded message sections as they are, with message_format, typically the bytes and format given to
+       on_raw_message_received (see messagereceiver_set_on_raw_message_received), so that a proxy forwards a message without
+       decoding and encoding it again. The bytes are copied. The send has the default priority and does not expire. */
+    MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, messagesender_send_raw_async, MESSAGE_SENDER_HANDLE, message_sender, message_format, message_format, const unsigned char*, bytes, size_t, length, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
+    MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, messagesender_send_batch_async, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_HANDLE*, messages, size_t, message_count, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
+    /* sends message with a body read piece by piece from on_message_body_read by messagesender_dowork, each piece going out as a data
+       section of a transfer spanning several frames, so that the whole body never has to be in memory. No further piece is read while
+       two are waiting for the I/O. The body of message must be empty or data sections, which are sent before the streamed ones.
+       The link must use the unsettled sender settle mode, and a sender resuming on link loss does not stream bodies. */
+    MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, messagesender_send_streamed_async, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_HANDLE, message, ON_MESSAGE_BODY_READ, on_message_body_read, void*, body_read_context, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
+    MOCKABLE_FUNCTION(, int, messagesender_send_settled, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_HANDLE, message, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+    /* once set, completions are no longer indicated through each send's on_message_send_complete: the sends settled by one
+       disposition are handed over in a single call, as the callback contexts given to the send paired with their result,
+       and any other completion is handed over on its own. Sends made without an on_message_send_complete are not reported. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_batched_send_complete, MESSAGE_SENDER_HANDLE, message_sender, ON_MESSAGE_SEND_COMPLETE_BATCH, on_message_send_complete_batch, void*, context);
+    MOCKABLE_FUNCTION(, int, messagesender_set_max_in_flight, MESSAGE_SENDER_HANDLE, message_sender, size_t, max_in_flight, ON_MESSAGE_SENDER_READY, on_message_sender_ready, void*, context);
+    /* reports CONNECTION_FLOW_EVENT_QUEUE_DEPTH_ABOVE to the flow observer of the connection (see connection_set_flow_observer)
+       when the pending sends go over queue_depth_threshold, and CONNECTION_FLOW_EVENT_QUEUE_DEPTH_BELOW when they are back to
+       it, with the sender as source and the number of pending sends as value. 0 (the default) reports nothing. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_queue_depth_threshold, MESSAGE_SENDER_HANDLE, message_sender, size_t, queue_depth_threshold);
+    /* once set, messagesender_dowork tunes the outgoing batch size and delay of the connection of the link (see
+       connection_set_outgoing_batch_size and connection_set_outgoing_batch_delay) to batch as much as keeps the p99 send to
+       settle latency of the link under latency_target ms. Starting from the batching of the connection, every latency_target
+       ms (10 at least) of tick_counter it halves them when the p99 of the deliveries settled in that time was over the target,
+       and grows them by an eighth of max_batch_size and 1 ms, up to max_batch_size and max_batch_delay, when it was under it
+       with sends still pending; with no send pending the delay is halved. The current values are read back with
+       connection_get_outgoing_batch_size and connection_get_outgoing_batch_delay. A connection carrying several links should
+       have only one of their senders tune it. Giving a NULL tick_counter stops the tuning. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_adaptive_batching, MESSAGE_SENDER_HANDLE, message_sender, TICK_COUNTER_HANDLE, tick_counter, milliseconds, latency_target, uint32_t, max_batch_size, milliseconds, max_batch_delay);
+    MOCKABLE_FUNCTION(, ENCODED_MESSAGE_HANDLE, messagesender_create_encoded_message, MESSAGE_HANDLE, message);
+    MOCKABLE_FUNCTION(, ENCODED_MESSAGE_HANDLE, messagesender_clone_encoded_message, ENCODED_MESSAGE_HANDLE, encoded_message);
+    MOCKABLE_FUNCTION(, void, messagesender_destroy_encoded_message, ENCODED_MESSAGE_HANDLE, encoded_message);
+    /* encodes once the header, message annotations, properties and application properties of message, which are constant for the
+       messages sent from the template; the body of message is not used. */
+    MOCKABLE_FUNCTION(, MESSAGE_TEMPLATE_HANDLE, messagesender_create_message_template, MESSAGE_HANDLE, message);
+    MOCKABLE_FUNCTION(, MESSAGE_TEMPLATE_HANDLE, messagesender_clone_message_template, MESSAGE_TEMPLATE_HANDLE, message_template);
+    MOCKABLE_FUNCTION(, void, messagesender_destroy_message_template, MESSAGE_TEMPLATE_HANDLE, message_template);
+    /* sends message with the sections of message_template it does not have itself: only its own sections, typically the body and
+       the properties that change, are encoded, and the encoded sections of the template are transferred in place. The body is sent
+       as it is (see messagesender_set_body_encoding), and the priority and expiry of the send come from the header of message.
+       The pending send keeps a reference to the template. */
+    MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, messagesender_send_from_template_async, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_TEMPLATE_HANDLE, message_template, MESSAGE_HANDLE, message, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
+    /* once set, sends that are unsettled when the link fails or is detached by the peer are kept instead of failed, and the
+       sender moves to MESSAGE_SENDER_STATE_ERROR while still accepting sends. Messages are encoded once when queued so that
+       they are not encoded again when resent. messagesender_reattach then opens the sender on a new link, typically created
+       with the name of the old one (link_get_name) on a rebuilt connection and session, and resends the kept sends in order.
+       messagesender_dowork runs the current link, so the old one is destroyed only after the reattach. The new link announces
+       the tags of the sends in doubt in the unsettled map of its attach, and sends the peer reports with a terminal outcome
+       are completed with it rather than sent again; the others are resent, so the peer may receive a message twice.
+       The new link continues the delivery count of the old one, which keeps the default 4 byte delivery tags unique. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_resume_on_link_loss, MESSAGE_SENDER_HANDLE, message_sender, bool, resume_on_link_loss);
+    MOCKABLE_FUNCTION(, int, messagesender_reattach, MESSAGE_SENDER_HANDLE, message_sender, LINK_HANDLE, link);
+    /* once set, the sends waiting for link credit are sent highest header priority (0 to 9, 4 without a header) first and in the
+       order they were queued within a priority, so that urgent messages are not stuck behind bulk ones. Encoded messages keep
+       the priority of the message they were encoded from. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_priority_order, MESSAGE_SENDER_HANDLE, message_sender, bool, priority_order);
+    /* once set, a send still waiting for link credit when the header ttl (counted from the time it was queued) or the absolute
+       expiry time of its message has passed is completed with MESSAGE_SEND_EXPIRED instead of being encoded and transferred.
+       Each such send gets a timer on timer_wheel, whose owner advances it with the time of tick_counter; the wheel has to
+       outlive the sender. Giving a NULL timer_wheel turns expiry off for the sends queued afterwards. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_message_expiry, MESSAGE_SENDER_HANDLE, message_sender, TIMER_WHEEL_HANDLE, timer_wheel, TICK_COUNTER_HANDLE, tick_counter);
+    /* once set, messagesender_send_async sends the data sections of a body of at least min_body_size bytes as encoded by
+       on_body_encode, each on its own, and sets the content-encoding property to content_encoding, so that a receiver can
+       decode them (see messagereceiver_set_body_decoding). Bodies that already have a content-encoding, are not data
+       sections or do not get smaller are sent as they are. Giving a NULL content_encoding and on_body_encode turns it off. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_body_encoding, MESSAGE_SENDER_HANDLE, message_sender, const char*, content_encoding, size_t, min_body_size, ON_MESSAGE_BODY_ENCODE, on_body_encode, void*, context);
+    /* sets the codec of messagesender_send_object_async, which sends message with body_object serialized by on_body_serialize as
+       one data section straight into the buffer the message is encoded in, so that a schema-based body (e.g. protobuf) is not
+       serialized into a buffer of its own and copied into the message. message must not have a body, and its content-type
+       property must be content_type, for a receiver to pick its codec (see messagereceiver_set_body_codec). body_object is
+       serialized when the send is transferred and has to stay valid until the send completes, unless the sender resumes on
+       link loss, which serializes it when queued. Such bodies are not encoded by messagesender_set_body_encoding. A body
+       already in a buffer of its own (e.g. a finished FlatBuffers buffer) is sent without copying as an external data
+       section (message_add_body_amqp_data_external) with messagesender_send_async. Giving a NULL content_type and
+       on_body_serialize turns it off; it should not be turned off while sends of body objects are pending, they then fail. */
+    MOCKABLE_FUNCTION(, int, messagesender_set_body_codec, MESSAGE_SENDER_HANDLE, message_sender, const char*, content_type, ON_MESSAGE_BODY_SERIALIZE, on_body_serialize, void*, context);
+    MOCKABLE_FUNCTION(, ASYNC_OPERATION_HANDLE, messagesender_send_object_async, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_HANDLE, message, const void*, body_object, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
     MOCKABLE_FUNCTION(, void, messagesender_set_trace, MESSAGE_SENDER_HANDLE, message_sender, bool, traceOn);
+    /* messagesender_send_async_threadsafe may be called from any thread. It takes ownership of message, which the caller
+       must not use afterwards, and queues the send without locking. The queued sends are started, and their completions
+       delivered, by messagesender_dowork on the thread running the connection; messagesender_dowork also runs link_dowork. */
+    MOCKABLE_FUNCTION(, int, messagesender_send_async_threadsafe, MESSAGE_SENDER_HANDLE, message_sender, MESSAGE_HANDLE, message, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context, tickcounter_ms_t, timeout);
+    MOCKABLE_FUNCTION(, void, messagesender_dowork, MESSAGE_SENDER_HANDLE, message_sender);
 
 #ifdef __cplusplus
 }
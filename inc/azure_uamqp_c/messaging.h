@@ -19,10 +19,16 @@ extern "C" {
     MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_create_target, const char*, address);
 
     MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_delivery_received, uint32_t, section_number, uint64_t, section_offset);
+    /* The accepted and released outcomes are references to values shared by the whole process, each caller still destroys
+       the value it got. Use amqpvalue_make_writable before changing one. */
     MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_delivery_accepted);
     MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_delivery_rejected, const char*, error_condition, const char*, error_description);
     MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_delivery_released);
     MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_delivery_modified, bool, delivery_failed, bool, undeliverable_here, fields, message_annotations);
+    /* transactions (AMQP 1.0 part 4): the target of a link to the transaction coordinator, asking for local transactions, and the
+       transactional-state to settle (or, without outcome, to send) deliveries as part of the transaction txn_id */
+    MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_create_coordinator_target);
+    MOCKABLE_FUNCTION(, AMQP_VALUE, messaging_delivery_transactional, const unsigned char*, txn_id, uint32_t, txn_id_length, AMQP_VALUE, outcome);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PARTITIONED_SENDER_H
+#define PARTITIONED_SENDER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/message_sender.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    typedef struct PARTITIONED_SENDER_INSTANCE_TAG* PARTITIONED_SENDER_HANDLE;
+
+    typedef struct PARTITIONED_SENDER_CONFIG_TAG
+    {
+        /* each link is named link_name followed by a dash and the index of its partition */
+        const char* link_name;
+        AMQP_VALUE source;
+        /* the target of each partition, partition_count of them */
+        AMQP_VALUE* targets;
+        size_t partition_count;
+        /* sends handed to the message sender of a partition and not completed yet, at most */
+        size_t max_in_flight_per_partition;
+        /* NULL to create every link on the session given to partitioned_sender_create, otherwise the session of each
+           partition, partition_count of them. Sessions on different connections (see amqp_connection_pool) stripe the
+           sends over several TCP streams, each with its own session window; to stripe one address give every partition
+           the same target. */
+        SESSION_HANDLE* sessions;
+    } PARTITIONED_SENDER_CONFIG;
+
+    /* One link and message sender per partition of an entity, on one session or on a session per partition. A send with a partition key always
+       goes to the partition picked by hashing the key (FNV-1a of its characters modulo the partition count), so that the
+       sends of a key keep their order. A send without a key waits in a queue shared by all the partitions and goes to the
+       next open partition with room, round robin, so that room freed on any link is used right away and a slow partition
+       does not hold up the others. Each partition gets at most max_in_flight_per_partition sends at a time, the rest wait
+       in the partitioned sender rather than in the message sender of a single link. */
+    MOCKABLE_FUNCTION(, PARTITIONED_SENDER_HANDLE, partitioned_sender_create, SESSION_HANDLE, session, const PARTITIONED_SENDER_CONFIG*, config);
+    MOCKABLE_FUNCTION(, void, partitioned_sender_destroy, PARTITIONED_SENDER_HANDLE, partitioned_sender);
+    MOCKABLE_FUNCTION(, int, partitioned_sender_open, PARTITIONED_SENDER_HANDLE, partitioned_sender);
+    MOCKABLE_FUNCTION(, int, partitioned_sender_close, PARTITIONED_SENDER_HANDLE, partitioned_sender);
+    MOCKABLE_FUNCTION(, int, partitioned_sender_send_async, PARTITIONED_SENDER_HANDLE, partitioned_sender, MESSAGE_HANDLE, message, const char*, partition_key, ON_MESSAGE_SEND_COMPLETE, on_message_send_complete, void*, callback_context);
+    /* the link of a partition, for settings that have to be made before it is attached */
+    MOCKABLE_FUNCTION(, LINK_HANDLE, partitioned_sender_get_link, PARTITIONED_SENDER_HANDLE, partitioned_sender, size_t, partition_index);
+    MOCKABLE_FUNCTION(, void, partitioned_sender_dowork, PARTITIONED_SENDER_HANDLE, partitioned_sender);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PARTITIONED_SENDER_H */
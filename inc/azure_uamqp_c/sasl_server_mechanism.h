@@ -12,9 +12,19 @@ extern "C" {
 #include "stdbool.h"
 #endif /* __cplusplus */
 
+#include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
+#define SASL_SERVER_MECHANISM_OUTCOME_VALUES \
+    SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, \
+    SASL_SERVER_MECHANISM_OUTCOME_OK, \
+    SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED, \
+    SASL_SERVER_MECHANISM_OUTCOME_ERROR
+
+DEFINE_ENUM(SASL_SERVER_MECHANISM_OUTCOME, SASL_SERVER_MECHANISM_OUTCOME_VALUES)
+
     typedef struct SASL_SERVER_MECHANISM_INSTANCE_TAG* SASL_SERVER_MECHANISM_HANDLE;
+    typedef struct SASL_SERVER_VERDICT_CACHE_INSTANCE_TAG* SASL_SERVER_VERDICT_CACHE_HANDLE;
     typedef void* CONCRETE_SASL_SERVER_MECHANISM_HANDLE;
 
     typedef struct SASL_SERVER_MECHANISM_BYTES_TAG
@@ -29,6 +39,14 @@ extern "C" {
     typedef int(*SASL_SERVER_MECHANISM_HANDLE_RESPONSE)(CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* response_bytes, bool* send_next_challenge, SASL_SERVER_MECHANISM_BYTES* next_challenge_bytes);
     typedef const char*(*SASL_SERVER_MECHANISM_GET_MECHANISM_NAME)(void);
 
+    /* challenge_bytes is only given with SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE and is only valid during the call */
+    typedef void(*ON_SASL_SERVER_MECHANISM_COMPLETE)(void* context, SASL_SERVER_MECHANISM_OUTCOME outcome, const SASL_SERVER_MECHANISM_BYTES* challenge_bytes);
+    /* Returning 0 means on_complete is called exactly once, right away or later from the thread driving the server
+       (a check offloaded to another thread posts its verdict back, e.g. with uamqp_reactor_post). The response bytes
+       are only valid during the call. Once destroy is called on_complete must not be called anymore. */
+    typedef int(*SASL_SERVER_MECHANISM_HANDLE_INITIAL_RESPONSE_ASYNC)(CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, const char* hostname, ON_SASL_SERVER_MECHANISM_COMPLETE on_complete, void* on_complete_context);
+    typedef int(*SASL_SERVER_MECHANISM_HANDLE_RESPONSE_ASYNC)(CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* response_bytes, ON_SASL_SERVER_MECHANISM_COMPLETE on_complete, void* on_complete_context);
+
     typedef struct SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION_TAG
     {
         SASL_SERVER_MECHANISM_CREATE create;
@@ -36,6 +54,9 @@ extern "C" {
         SASL_SERVER_MECHANISM_HANDLE_INITIAL_RESPONSE handle_initial_response;
         SASL_SERVER_MECHANISM_HANDLE_RESPONSE handle_response;
         SASL_SERVER_MECHANISM_GET_MECHANISM_NAME get_mechanism_name;
+        /* optional, NULL for mechanisms that decide right away; the synchronous handlers are then used */
+        SASL_SERVER_MECHANISM_HANDLE_INITIAL_RESPONSE_ASYNC handle_initial_response_async;
+        SASL_SERVER_MECHANISM_HANDLE_RESPONSE_ASYNC handle_response_async;
     } SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION;
 
     MOCKABLE_FUNCTION(, SASL_SERVER_MECHANISM_HANDLE, sasl_server_mechanism_create, const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION*, sasl_server_mechanism_interface_description, void*, sasl_server_mechanism_create_parameters);
@@ -43,6 +64,13 @@ extern "C" {
     MOCKABLE_FUNCTION(, int, sasl_server_mechanism_handle_initial_response, SASL_SERVER_MECHANISM_HANDLE, sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES*, initial_response_bytes, const char*, hostname, bool*, send_challenge, SASL_SERVER_MECHANISM_BYTES*, challenge_bytes);
     MOCKABLE_FUNCTION(, int, sasl_server_mechanism_handle_response, SASL_SERVER_MECHANISM_HANDLE, sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES*, response_bytes, bool*, send_next_challenge, SASL_SERVER_MECHANISM_BYTES*, next_challenge_bytes);
     MOCKABLE_FUNCTION(, const char*, sasl_server_mechanism_get_mechanism_name, SASL_SERVER_MECHANISM_HANDLE, sasl_server_mechanism);
+    /* Like the synchronous calls, but the verdict comes through on_complete so a slow check (a remote token validation)
+       does not hold up the other connections on the thread. One call may be pending at a time on a mechanism. */
+    MOCKABLE_FUNCTION(, int, sasl_server_mechanism_handle_initial_response_async, SASL_SERVER_MECHANISM_HANDLE, sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES*, initial_response_bytes, const char*, hostname, ON_SASL_SERVER_MECHANISM_COMPLETE, on_complete, void*, on_complete_context);
+    MOCKABLE_FUNCTION(, int, sasl_server_mechanism_handle_response_async, SASL_SERVER_MECHANISM_HANDLE, sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES*, response_bytes, ON_SASL_SERVER_MECHANISM_COMPLETE, on_complete, void*, on_complete_context);
+    /* Final verdicts given to initial responses by sasl_server_mechanism_handle_initial_response_async are kept in and
+       first looked up in verdict_cache (NULL to stop). The cache is not owned and must outlive the mechanism. */
+    MOCKABLE_FUNCTION(, int, sasl_server_mechanism_set_verdict_cache, SASL_SERVER_MECHANISM_HANDLE, sasl_server_mechanism, SASL_SERVER_VERDICT_CACHE_HANDLE, verdict_cache);
 
 #ifdef __cplusplus
 }
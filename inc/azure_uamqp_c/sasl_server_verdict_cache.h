@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SASL_SERVER_VERDICT_CACHE_H
+#define SASL_SERVER_VERDICT_CACHE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_uamqp_c/sasl_server_mechanism.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+    /* Remembers for time_to_live_ms the final verdict (SASL_SERVER_MECHANISM_OUTCOME_OK or _AUTH_FAILED) given to an
+       initial response, keyed by mechanism name, hostname and the response bytes, so that a storm of connections
+       presenting the same credentials is checked once. At most max_entries verdicts are kept, the one expiring first
+       makes room for a new one. One cache can be shared by the mechanisms of all connections on one thread. */
+    MOCKABLE_FUNCTION(, SASL_SERVER_VERDICT_CACHE_HANDLE, sasl_server_verdict_cache_create, size_t, max_entries, tickcounter_ms_t, time_to_live_ms);
+    MOCKABLE_FUNCTION(, void, sasl_server_verdict_cache_destroy, SASL_SERVER_VERDICT_CACHE_HANDLE, sasl_server_verdict_cache);
+    /* returns true and fills outcome when an unexpired verdict is kept for the key */
+    MOCKABLE_FUNCTION(, bool, sasl_server_verdict_cache_lookup, SASL_SERVER_VERDICT_CACHE_HANDLE, sasl_server_verdict_cache, const char*, mechanism_name, const char*, hostname, const SASL_SERVER_MECHANISM_BYTES*, initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME*, outcome);
+    MOCKABLE_FUNCTION(, int, sasl_server_verdict_cache_store, SASL_SERVER_VERDICT_CACHE_HANDLE, sasl_server_verdict_cache, const char*, mechanism_name, const char*, hostname, const SASL_SERVER_MECHANISM_BYTES*, initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME, outcome);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SASL_SERVER_VERDICT_CACHE_H */
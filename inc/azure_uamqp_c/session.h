@@ -57,30 +57,97 @@ DEFINE_ENUM(SESSION_STATE, SESSION_STATE_VALUES)
 
 DEFINE_ENUM(SESSION_SEND_TRANSFER_RESULT, SESSION_SEND_TRANSFER_RESULT_VALUES)
 
-    typedef void(*LINK_ENDPOINT_FRAME_RECEIVED_CALLBACK)(void* context, AMQP_VALUE performative, uint32_t frame_payload_size, const unsigned char* payload_bytes);
+#define SESSION_WINDOW_POLICY_VALUES \
+    SESSION_WINDOW_POLICY_FIXED, \
+    SESSION_WINDOW_POLICY_ADAPTIVE
+
+DEFINE_ENUM(SESSION_WINDOW_POLICY, SESSION_WINDOW_POLICY_VALUES)
+
+#define SESSION_LINK_SCHEDULER_VALUES \
+    SESSION_LINK_SCHEDULER_ROUND_ROBIN, \
+    SESSION_LINK_SCHEDULER_WEIGHTED
+
+DEFINE_ENUM(SESSION_LINK_SCHEDULER, SESSION_LINK_SCHEDULER_VALUES)
+
+    typedef struct SESSION_STATS_TAG
+    {
+        uint64_t transfers_sent;
+        uint64_t transfers_received;
+        uint64_t flows_sent;
+        uint64_t flows_received;
+        uint64_t dispositions_sent;
+        uint64_t dispositions_received;
+        /* transfers refused with SESSION_SEND_TRANSFER_BUSY because the session window was exhausted */
+        uint64_t window_stalls;
+        /* transfers refused with SESSION_SEND_TRANSFER_BUSY because the send queue of the connection was full */
+        uint64_t send_queue_stalls;
+    } SESSION_STATS;
+
+    typedef void(*LINK_ENDPOINT_FRAME_RECEIVED_CALLBACK)(void* context, AMQP_VALUE performative, uint64_t performative_code, uint32_t frame_payload_size, const unsigned char* payload_bytes);
     typedef void(*ON_SESSION_STATE_CHANGED)(void* context, SESSION_STATE new_session_state, SESSION_STATE previous_session_state);
     typedef void(*ON_SESSION_FLOW_ON)(void* context);
+    typedef void(*ON_LINK_ENDPOINT_DOWORK)(void* context);
     typedef bool(*ON_LINK_ATTACHED)(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target);
 
     MOCKABLE_FUNCTION(, SESSION_HANDLE, session_create, CONNECTION_HANDLE, connection, ON_LINK_ATTACHED, on_link_attached, void*, callback_context);
     MOCKABLE_FUNCTION(, SESSION_HANDLE, session_create_from_endpoint, CONNECTION_HANDLE, connection, ENDPOINT_HANDLE, connection_endpoint, ON_LINK_ATTACHED, on_link_attached, void*, callback_context);
     MOCKABLE_FUNCTION(, int, session_set_incoming_window, SESSION_HANDLE, session, uint32_t, incoming_window);
+    MOCKABLE_FUNCTION(, int, session_set_link_scheduler, SESSION_HANDLE, session, SESSION_LINK_SCHEDULER, link_scheduler);
+    MOCKABLE_FUNCTION(, int, session_set_window_policy, SESSION_HANDLE, session, SESSION_WINDOW_POLICY, window_policy, uint32_t, max_window);
     MOCKABLE_FUNCTION(, int, session_get_incoming_window, SESSION_HANDLE, session, uint32_t*, incoming_window);
     MOCKABLE_FUNCTION(, int, session_set_outgoing_window, SESSION_HANDLE, session, uint32_t, outgoing_window);
     MOCKABLE_FUNCTION(, int, session_get_outgoing_window, SESSION_HANDLE, session, uint32_t*, outgoing_window);
     MOCKABLE_FUNCTION(, int, session_set_handle_max, SESSION_HANDLE, session, handle, handle_max);
     MOCKABLE_FUNCTION(, int, session_get_handle_max, SESSION_HANDLE, session, handle*, handle_max);
+    MOCKABLE_FUNCTION(, int, session_get_stats, SESSION_HANDLE, session, SESSION_STATS*, stats);
+    /* links use it to charge their buffers against the memory quota of the connection */
+    MOCKABLE_FUNCTION(, int, session_get_connection, SESSION_HANDLE, session, CONNECTION_HANDLE*, connection);
+    /* A new link attach the limiter does not admit is answered with an attach and a closing detach carrying
+       amqp:resource-limit-exceeded before on_link_attached is called, so no link is built for it. The limiter is owned
+       by the caller and shall outlive the session or be removed before being destroyed. */
+    MOCKABLE_FUNCTION(, int, session_set_link_admission_limiter, SESSION_HANDLE, session, ADMISSION_LIMITER_HANDLE, link_admission_limiter);
+    /* Link flows are then only recorded and sent from connection_dowork, the latest one of each link, together with
+       those of all the deferring sessions of the connection in one write. Drain flows are still sent right away.
+       Off by default. */
+    MOCKABLE_FUNCTION(, int, session_set_deferred_link_flows, SESSION_HANDLE, session, bool, deferred_link_flows);
+    MOCKABLE_FUNCTION(, int, session_get_pipelined_begin, SESSION_HANDLE, session, bool*, pipelined_begin);
+    /* Saved once the session is mapped and no delivery is sent in parts, restored on a session created on a connection that
+       was restored, before session_begin: the session is then mapped on the channels it had when the connection resumes,
+       without a begin, see connection_save_handover_state. */
+    MOCKABLE_FUNCTION(, int, session_save_handover_state, SESSION_HANDLE, session, unsigned char*, buffer, size_t, buffer_size, size_t*, length);
+    MOCKABLE_FUNCTION(, int, session_restore_handover_state, SESSION_HANDLE, session, const unsigned char*, bytes, size_t, length);
     MOCKABLE_FUNCTION(, void, session_destroy, SESSION_HANDLE, session);
     MOCKABLE_FUNCTION(, int, session_begin, SESSION_HANDLE, session);
     MOCKABLE_FUNCTION(, int, session_end, SESSION_HANDLE, session, const char*, condition_value, const char*, description);
     MOCKABLE_FUNCTION(, LINK_ENDPOINT_HANDLE, session_create_link_endpoint, SESSION_HANDLE, session, const char*, name);
     MOCKABLE_FUNCTION(, void, session_destroy_link_endpoint, LINK_ENDPOINT_HANDLE, link_endpoint);
+    MOCKABLE_FUNCTION(, int, session_set_link_endpoint_weight, LINK_ENDPOINT_HANDLE, link_endpoint, uint32_t, weight);
+    /* the name is kept once per link, by its endpoint */
+    MOCKABLE_FUNCTION(, int, session_get_link_endpoint_name, LINK_ENDPOINT_HANDLE, link_endpoint, const char**, name);
+    /* for the links handed over, the input handle is 0xFFFFFFFF while the peer has not attached */
+    MOCKABLE_FUNCTION(, int, session_get_link_endpoint_handles, LINK_ENDPOINT_HANDLE, link_endpoint, handle*, output_handle, handle*, input_handle);
+    /* on_dowork is called on every connection_dowork, for work a link has to do without its own dowork being called, NULL to stop */
+    MOCKABLE_FUNCTION(, int, session_set_link_endpoint_on_dowork, LINK_ENDPOINT_HANDLE, link_endpoint, ON_LINK_ENDPOINT_DOWORK, on_dowork, void*, context);
+    /* the delivery id the next transfer sent on the session will be given, so that a link can track a delivery before sending it */
+    MOCKABLE_FUNCTION(, int, session_get_next_delivery_id, LINK_ENDPOINT_HANDLE, link_endpoint, delivery_number*, delivery_id);
+    MOCKABLE_FUNCTION(, int, session_restore_link_endpoint_handles, LINK_ENDPOINT_HANDLE, link_endpoint, handle, output_handle, handle, input_handle);
     MOCKABLE_FUNCTION(, int, session_start_link_endpoint, LINK_ENDPOINT_HANDLE, link_endpoint, ON_ENDPOINT_FRAME_RECEIVED, frame_received_callback, ON_SESSION_STATE_CHANGED, on_session_state_changed, ON_SESSION_FLOW_ON, on_session_flow_on, void*, context);
     MOCKABLE_FUNCTION(, int, session_send_flow, LINK_ENDPOINT_HANDLE, link_endpoint, FLOW_HANDLE, flow);
+    MOCKABLE_FUNCTION(, int, session_send_link_flow, LINK_ENDPOINT_HANDLE, link_endpoint, sequence_no, delivery_count, uint32_t, link_credit);
+    /* asks the sender to use up link_credit with what it has available right away and then give back the rest */
+    MOCKABLE_FUNCTION(, int, session_send_link_drain_flow, LINK_ENDPOINT_HANDLE, link_endpoint, sequence_no, delivery_count, uint32_t, link_credit);
     MOCKABLE_FUNCTION(, int, session_send_attach, LINK_ENDPOINT_HANDLE, link_endpoint, ATTACH_HANDLE, attach);
+    /* sends an attach from the fields following name and handle (role, source, target, ...) already encoded by the link,
+       field_count of them, the session writing the name and output handle of the endpoint ahead of them */
+    MOCKABLE_FUNCTION(, int, session_send_encoded_attach, LINK_ENDPOINT_HANDLE, link_endpoint, const unsigned char*, encoded_fields, size_t, encoded_fields_size, uint32_t, field_count);
     MOCKABLE_FUNCTION(, int, session_send_disposition, LINK_ENDPOINT_HANDLE, link_endpoint, DISPOSITION_HANDLE, disposition);
+    MOCKABLE_FUNCTION(, int, session_send_delivery_disposition, LINK_ENDPOINT_HANDLE, link_endpoint, role, role_value, delivery_number, first, delivery_number, last, bool, settled, AMQP_VALUE, delivery_state);
     MOCKABLE_FUNCTION(, int, session_send_detach, LINK_ENDPOINT_HANDLE, link_endpoint, DETACH_HANDLE, detach);
     MOCKABLE_FUNCTION(, SESSION_SEND_TRANSFER_RESULT, session_send_transfer, LINK_ENDPOINT_HANDLE, link_endpoint, TRANSFER_HANDLE, transfer, PAYLOAD*, payloads, size_t, payload_count, delivery_number*, delivery_id, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+    MOCKABLE_FUNCTION(, SESSION_SEND_TRANSFER_RESULT, session_send_templated_transfer, LINK_ENDPOINT_HANDLE, link_endpoint, delivery_tag, delivery_tag_value, message_format, message_format_value, bool, settled, PAYLOAD*, payloads, size_t, payload_count, delivery_number*, delivery_id, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+    /* sends one part of a delivery that is produced piece by piece: the first part takes the next delivery id and a slot of the
+       session window, the following parts of the same link endpoint continue that delivery until one is sent with more set to false */
+    MOCKABLE_FUNCTION(, SESSION_SEND_TRANSFER_RESULT, session_send_transfer_part, LINK_ENDPOINT_HANDLE, link_endpoint, TRANSFER_HANDLE, transfer, bool, more, PAYLOAD*, payloads, size_t, payload_count, delivery_number*, delivery_id, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SHM_RING_IO_H
+#define SHM_RING_IO_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/xio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/* Option set with xio_setoption on an open io, value is a const unsigned int*: blocks the calling thread until the peer
+   writes (or closes) or the given milliseconds pass. The thread driving the connection calls it instead of sleeping. */
+#define SHM_RING_IO_OPTION_WAIT_FOR_DATA_MS "wait_for_data_ms"
+
+#define SHM_RING_IO_DEFAULT_RING_SIZE (4 * 1024 * 1024)
+
+    typedef struct SHM_RING_IO_CONFIG_TAG
+    {
+        /* a file on a memory backed file system both processes can reach, for example /dev/shm/<name> */
+        const char* path;
+        /* true on the peer that creates the rings (usually the one listening), false on the one attaching to them */
+        bool create;
+        /* payload bytes of each direction, a power of 2, 0 for SHM_RING_IO_DEFAULT_RING_SIZE; only used when creating */
+        size_t ring_size;
+    } SHM_RING_IO_CONFIG;
+
+    /* An io between two processes on the same host over a pair of single producer single consumer byte rings in shared
+       memory (Linux only). Bytes are copied once into the ring by xio_send and handed to on_bytes_received straight from
+       the ring by xio_dowork, without system calls. The peer is only woken (futex) when it waits in
+       SHM_RING_IO_OPTION_WAIT_FOR_DATA_MS. It goes under header_detect_io or connection like any other io. The creating
+       side opens right away, the attaching side fails to open until the rings exist. One attaching peer per file. */
+    MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, shm_ring_io_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SHM_RING_IO_H */
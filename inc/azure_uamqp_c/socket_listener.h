@@ -5,6 +5,7 @@
 #define SOCKETLISTENER_H
 
 #include "azure_c_shared_utility/xio.h"
+#include "azure_uamqp_c/admission_limiter.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,8 +16,26 @@ extern "C" {
     typedef struct SOCKET_LISTENER_INSTANCE_TAG* SOCKET_LISTENER_HANDLE;
     typedef void(*ON_SOCKET_ACCEPTED)(void* context, const IO_INTERFACE_DESCRIPTION* interface_description, void* io_parameters);
 
+/* Options are set with socketlistener_setoption before socketlistener_start:
+   - backlog (const int*): length of the pending connections queue passed to listen, SOMAXCONN by default
+   - reuse_port (const bool*): sets SO_REUSEPORT so that one listener per thread can share a port, not supported on Windows
+   - max_accepts_per_dowork (const int*): how many pending connections one socketlistener_dowork call accepts at most
+   - admission_limiter (ADMISSION_LIMITER_HANDLE, passed as the value itself): an accepted socket the limiter does not
+     admit is closed right away, without on_socket_accepted being called. The limiter has to outlive the listener. */
+#define SOCKET_LISTENER_OPTION_BACKLOG "backlog"
+#define SOCKET_LISTENER_OPTION_REUSE_PORT "reuse_port"
+#define SOCKET_LISTENER_OPTION_MAX_ACCEPTS_PER_DOWORK "max_accepts_per_dowork"
+#define SOCKET_LISTENER_OPTION_ADMISSION_LIMITER "admission_limiter"
+
+#define SOCKET_LISTENER_DEFAULT_MAX_ACCEPTS_PER_DOWORK 64
+
     MOCKABLE_FUNCTION(, SOCKET_LISTENER_HANDLE, socketlistener_create, int, port);
+    /* listens on a Unix domain socket bound to path instead of a TCP port, for local hops (for example a sidecar), where
+       the accepted sockets are still handed out as socketio. A stale socket file at path is removed when the listener
+       starts and the file is removed when it stops. reuse_port does not apply. Not supported on Windows. */
+    MOCKABLE_FUNCTION(, SOCKET_LISTENER_HANDLE, socketlistener_create_unix, const char*, path);
     MOCKABLE_FUNCTION(, void, socketlistener_destroy, SOCKET_LISTENER_HANDLE, socket_listener);
+    MOCKABLE_FUNCTION(, int, socketlistener_setoption, SOCKET_LISTENER_HANDLE, socket_listener, const char*, option_name, const void*, value);
     MOCKABLE_FUNCTION(, int, socketlistener_start, SOCKET_LISTENER_HANDLE, socket_listener, ON_SOCKET_ACCEPTED, on_socket_accepted, void*, callback_context);
     MOCKABLE_FUNCTION(, int, socketlistener_stop, SOCKET_LISTENER_HANDLE, socket_listener);
     MOCKABLE_FUNCTION(, void, socketlistener_dowork, SOCKET_LISTENER_HANDLE, socket_listener);
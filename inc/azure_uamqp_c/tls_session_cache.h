@@ -0,0 +1,34 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/xio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    typedef struct TLS_SESSION_CACHE_INSTANCE_TAG* TLS_SESSION_CACHE_HANDLE;
+
+    /* Keeps, for each host, the options retrieved from the io of an open connection (xio_retrieveoptions), so that they
+       can be set on the io of the next connection to that host before it is opened. A TLS io that hands out its session
+       or session ticket among its options then resumes the TLS session instead of doing a full handshake. A SASL client
+       io passes the options of its underlying io along (underlying_io_options), so the cache can be given the top of
+       the io stack. One cache can be shared by everything connecting from the process, on the thread running them. */
+    MOCKABLE_FUNCTION(, TLS_SESSION_CACHE_HANDLE, tls_session_cache_create);
+    MOCKABLE_FUNCTION(, void, tls_session_cache_destroy, TLS_SESSION_CACHE_HANDLE, tls_session_cache);
+    /* replaces the options kept for hostname with those of xio, typically once the connection is open */
+    MOCKABLE_FUNCTION(, int, tls_session_cache_save, TLS_SESSION_CACHE_HANDLE, tls_session_cache, const char*, hostname, XIO_HANDLE, xio);
+    /* sets the options kept for hostname on xio, which has not been opened yet. Nothing is set if none are kept. */
+    MOCKABLE_FUNCTION(, int, tls_session_cache_apply, TLS_SESSION_CACHE_HANDLE, tls_session_cache, const char*, hostname, XIO_HANDLE, xio);
+    /* drops the options kept for hostname, for instance when resuming with them keeps failing */
+    MOCKABLE_FUNCTION(, int, tls_session_cache_remove, TLS_SESSION_CACHE_HANDLE, tls_session_cache, const char*, hostname);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* TLS_SESSION_CACHE_H */
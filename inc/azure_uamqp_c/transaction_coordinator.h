@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef TRANSACTION_COORDINATOR_H
+#define TRANSACTION_COORDINATOR_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define TRANSACTION_COORDINATOR_RESULT_VALUES \
+    TRANSACTION_COORDINATOR_OK, \
+    TRANSACTION_COORDINATOR_ERROR, \
+    TRANSACTION_COORDINATOR_REJECTED
+
+DEFINE_ENUM(TRANSACTION_COORDINATOR_RESULT, TRANSACTION_COORDINATOR_RESULT_VALUES)
+
+    typedef struct TRANSACTION_COORDINATOR_INSTANCE_TAG* TRANSACTION_COORDINATOR_HANDLE;
+    typedef void(*ON_TRANSACTION_COORDINATOR_OPEN_COMPLETE)(void* context, TRANSACTION_COORDINATOR_RESULT open_result);
+    /* txn_id is only valid during the callback */
+    typedef void(*ON_TRANSACTION_DECLARED)(void* context, TRANSACTION_COORDINATOR_RESULT declare_result, const unsigned char* txn_id, uint32_t txn_id_length);
+    typedef void(*ON_TRANSACTION_DISCHARGED)(void* context, TRANSACTION_COORDINATOR_RESULT discharge_result);
+
+    /* A link to the transaction coordinator of the peer (AMQP 1.0 part 4), declaring and discharging local transactions. Work is
+       made part of a transaction with the transactional-state of messaging_delivery_transactional: as the delivery state of the
+       dispositions of received messages (messagereceiver_send_message_disposition) and as the transfer state of the links sending
+       (link_set_transfer_state). None of these wait for the transaction, which the peer applies or rolls back as a whole on
+       discharge, so a batch of any size is committed with one discharge round trip. REJECTED is given when the coordinator
+       refuses a declare or a discharge, e.g. for a transaction that it rolled back. */
+    MOCKABLE_FUNCTION(, TRANSACTION_COORDINATOR_HANDLE, transaction_coordinator_create, SESSION_HANDLE, session, const char*, link_name);
+    MOCKABLE_FUNCTION(, void, transaction_coordinator_destroy, TRANSACTION_COORDINATOR_HANDLE, transaction_coordinator);
+    MOCKABLE_FUNCTION(, int, transaction_coordinator_open_async, TRANSACTION_COORDINATOR_HANDLE, transaction_coordinator, ON_TRANSACTION_COORDINATOR_OPEN_COMPLETE, on_open_complete, void*, context);
+    MOCKABLE_FUNCTION(, int, transaction_coordinator_close, TRANSACTION_COORDINATOR_HANDLE, transaction_coordinator);
+    MOCKABLE_FUNCTION(, int, transaction_coordinator_declare_async, TRANSACTION_COORDINATOR_HANDLE, transaction_coordinator, ON_TRANSACTION_DECLARED, on_declared, void*, context);
+    /* fail set rolls the transaction back instead of committing it */
+    MOCKABLE_FUNCTION(, int, transaction_coordinator_discharge_async, TRANSACTION_COORDINATOR_HANDLE, transaction_coordinator, const unsigned char*, txn_id, uint32_t, txn_id_length, bool, fail, ON_TRANSACTION_DISCHARGED, on_discharged, void*, context);
+    /* the link to the coordinator, for settings that have to be made before it is attached */
+    MOCKABLE_FUNCTION(, LINK_HANDLE, transaction_coordinator_get_link, TRANSACTION_COORDINATOR_HANDLE, transaction_coordinator);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* TRANSACTION_COORDINATOR_H */
@@ -8,32 +8,48 @@
 Unless advanced cherrypicking of which functionality is to be used,
 a user can always inlcude this header */
 
+#include "azure_uamqp_c/admission_limiter.h"
+#include "azure_uamqp_c/alloc_counters.h"
+#include "azure_uamqp_c/amqp_connection_pool.h"
 #include "azure_uamqp_c/amqp_definitions.h"
 #include "azure_uamqp_c/amqp_frame_codec.h"
 #include "azure_uamqp_c/amqp_management.h"
+#include "azure_uamqp_c/amqp_management_mux.h"
+#include "azure_uamqp_c/amqp_server.h"
 #include "azure_uamqp_c/amqp_types.h"
 #include "azure_uamqp_c/amqpvalue.h"
 #include "azure_uamqp_c/amqpvalue_to_string.h"
 #include "azure_uamqp_c/cbs.h"
+#include "azure_uamqp_c/cbs_token_manager.h"
 #include "azure_uamqp_c/connection.h"
 #include "azure_uamqp_c/frame_codec.h"
+#include "azure_uamqp_c/frame_trace.h"
 #include "azure_uamqp_c/header_detect_io.h"
 #include "azure_uamqp_c/link.h"
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/message_receiver.h"
 #include "azure_uamqp_c/message_sender.h"
 #include "azure_uamqp_c/messaging.h"
+#include "azure_uamqp_c/partitioned_sender.h"
 #include "azure_uamqp_c/sasl_anonymous.h"
 #include "azure_uamqp_c/sasl_frame_codec.h"
 #include "azure_uamqp_c/sasl_mechanism.h"
 #include "azure_uamqp_c/sasl_server_mechanism.h"
+#include "azure_uamqp_c/sasl_server_verdict_cache.h"
 #include "azure_uamqp_c/sasl_mssbcbs.h"
 #include "azure_uamqp_c/sasl_plain.h"
 #include "azure_uamqp_c/saslclientio.h"
 #include "azure_uamqp_c/sasl_server_io.h"
 #include "azure_uamqp_c/server_protocol_io.h"
 #include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/shm_ring_io.h"
 #include "azure_uamqp_c/socket_listener.h"
+#include "azure_uamqp_c/timer_wheel.h"
+#include "azure_uamqp_c/tls_session_cache.h"
+#include "azure_uamqp_c/uamqp_reactor.h"
+#include "azure_uamqp_c/uamqp_tracepoints.h"
+#include "azure_uamqp_c/unix_socket_io.h"
+#include "azure_uamqp_c/uringio.h"
 
 #endif /* UAMQP_H */
 
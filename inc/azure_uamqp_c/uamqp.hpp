@@ -0,0 +1,753 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UAMQP_HPP
+#define UAMQP_HPP
+
+/* Header only C++17 layer over the C API. Owning classes are move-only and destroy their handle, views do not own
+   anything and are only good while the object they look at is. Accessors hand out std::string_view and span over the
+   bytes kept by the values and messages instead of copying them. Failures are reported like in the C API: factories
+   return an empty (false) object, accessors an empty std::optional and the other calls false. Everything stays
+   usable from C through get(), and an owning object gives up its handle with release(). Objects built on one another
+   have to be destroyed in reverse order: receivers, senders, management and cbs instances, then links, sessions and the
+   connection. With C++20 coroutines, sends, batch receives, management operations and token puts can be awaited. */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/message_sender.h"
+#include "azure_uamqp_c/message_receiver.h"
+#include "azure_uamqp_c/amqp_management.h"
+#include "azure_uamqp_c/cbs.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define UAMQP_HPP_COROUTINES
+#endif
+
+namespace azure_uamqp
+{
+#if defined(__cpp_lib_span)
+    template <typename T>
+    using span = std::span<T>;
+#else
+    /* the part of std::span the accessors need, until C++20 is there */
+    template <typename T>
+    class span
+    {
+    public:
+        constexpr span() noexcept : data_(nullptr), size_(0) {}
+        constexpr span(T* data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+        constexpr T* data() const noexcept { return data_; }
+        constexpr std::size_t size() const noexcept { return size_; }
+        constexpr bool empty() const noexcept { return size_ == 0; }
+        constexpr T* begin() const noexcept { return data_; }
+        constexpr T* end() const noexcept { return data_ + size_; }
+        constexpr T& operator[](std::size_t index) const noexcept { return data_[index]; }
+
+    private:
+        T* data_;
+        std::size_t size_;
+    };
+#endif
+
+    /* Owns a handle of the C API and destroys it with Destroy */
+    template <typename Handle, void(*Destroy)(Handle)>
+    class unique_handle
+    {
+    public:
+        unique_handle() noexcept : handle_(nullptr) {}
+        explicit unique_handle(Handle handle) noexcept : handle_(handle) {}
+        unique_handle(unique_handle&& other) noexcept : handle_(other.release()) {}
+        unique_handle(const unique_handle&) = delete;
+        unique_handle& operator=(const unique_handle&) = delete;
+        ~unique_handle() { reset(); }
+
+        unique_handle& operator=(unique_handle&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset(other.release());
+            }
+
+            return *this;
+        }
+
+        Handle get() const noexcept { return handle_; }
+        explicit operator bool() const noexcept { return handle_ != nullptr; }
+
+        Handle release() noexcept
+        {
+            Handle result = handle_;
+            handle_ = nullptr;
+            return result;
+        }
+
+        void reset(Handle handle = nullptr) noexcept
+        {
+            if (handle_ != nullptr)
+            {
+                Destroy(handle_);
+            }
+
+            handle_ = handle;
+        }
+
+    private:
+        Handle handle_;
+    };
+
+    class value;
+
+    /* Looks at an AMQP value owned by someone else, for example an item of a list or the body of a message */
+    class value_view
+    {
+    public:
+        value_view() noexcept : value_(nullptr) {}
+        value_view(AMQP_VALUE value) noexcept : value_(value) {}
+
+        AMQP_VALUE get() const noexcept { return value_; }
+        explicit operator bool() const noexcept { return value_ != nullptr; }
+
+        AMQP_TYPE type() const noexcept
+        {
+            return (value_ == nullptr) ? AMQP_TYPE_UNKNOWN : amqpvalue_get_type(value_);
+        }
+
+        std::optional<bool> as_bool() const noexcept
+        {
+            bool result;
+            return (amqpvalue_get_boolean(value_, &result) == 0) ? std::optional<bool>(result) : std::nullopt;
+        }
+
+        std::optional<uint32_t> as_uint() const noexcept
+        {
+            uint32_t result;
+            return (amqpvalue_get_uint(value_, &result) == 0) ? std::optional<uint32_t>(result) : std::nullopt;
+        }
+
+        std::optional<uint64_t> as_ulong() const noexcept
+        {
+            uint64_t result;
+            return (amqpvalue_get_ulong(value_, &result) == 0) ? std::optional<uint64_t>(result) : std::nullopt;
+        }
+
+        std::optional<int32_t> as_int() const noexcept
+        {
+            int32_t result;
+            return (amqpvalue_get_int(value_, &result) == 0) ? std::optional<int32_t>(result) : std::nullopt;
+        }
+
+        std::optional<int64_t> as_long() const noexcept
+        {
+            int64_t result;
+            return (amqpvalue_get_long(value_, &result) == 0) ? std::optional<int64_t>(result) : std::nullopt;
+        }
+
+        std::optional<int64_t> as_timestamp() const noexcept
+        {
+            int64_t result;
+            return (amqpvalue_get_timestamp(value_, &result) == 0) ? std::optional<int64_t>(result) : std::nullopt;
+        }
+
+        /* the characters stay in the value, embedded NULs included */
+        std::optional<std::string_view> as_string() const noexcept
+        {
+            const char* chars;
+            size_t length;
+            return (amqpvalue_get_string_n(value_, &chars, &length) == 0) ? std::optional<std::string_view>(std::string_view(chars, length)) : std::nullopt;
+        }
+
+        std::optional<std::string_view> as_symbol() const noexcept
+        {
+            const char* chars;
+            return (amqpvalue_get_symbol(value_, &chars) == 0) ? std::optional<std::string_view>(std::string_view(chars)) : std::nullopt;
+        }
+
+        std::optional<span<const unsigned char>> as_binary() const noexcept
+        {
+            amqp_binary binary;
+            return (amqpvalue_get_binary(value_, &binary) == 0) ?
+                std::optional<span<const unsigned char>>(span<const unsigned char>(static_cast<const unsigned char*>(binary.bytes), binary.length)) :
+                std::nullopt;
+        }
+
+        /* the items of an array of int, uint, long, ulong, float or double, stored packed in the value */
+        template <typename T>
+        std::optional<span<const T>> as_array() const noexcept
+        {
+            const void* items;
+            uint32_t count;
+            return (amqpvalue_get_array_span(value_, array_item_type<T>(), &items, &count) == 0) ?
+                std::optional<span<const T>>(span<const T>(static_cast<const T*>(items), count)) :
+                std::nullopt;
+        }
+
+        /* the number of items of a list or pairs of a map */
+        std::optional<uint32_t> size() const noexcept
+        {
+            uint32_t result;
+            int get_result = (type() == AMQP_TYPE_MAP) ? amqpvalue_get_map_pair_count(value_, &result) : amqpvalue_get_list_item_count(value_, &result);
+            return (get_result == 0) ? std::optional<uint32_t>(result) : std::nullopt;
+        }
+
+        /* an item of a list, which stays owned by the list */
+        value_view item(size_t index) const noexcept
+        {
+            return value_view(amqpvalue_get_list_item_in_place(value_, index));
+        }
+
+        /* the map value with a symbol key, for example an annotation or an application property */
+        inline value find(const char* symbol_key) const noexcept;
+        inline value clone() const noexcept;
+
+        bool operator==(const value_view& other) const noexcept { return amqpvalue_are_equal(value_, other.value_); }
+        bool operator!=(const value_view& other) const noexcept { return !amqpvalue_are_equal(value_, other.value_); }
+
+    private:
+        template <typename T>
+        static constexpr AMQP_TYPE array_item_type() noexcept
+        {
+            static_assert(std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value ||
+                std::is_same<T, int64_t>::value || std::is_same<T, uint64_t>::value ||
+                std::is_same<T, float>::value || std::is_same<T, double>::value,
+                "arrays are only stored packed for int, uint, long, ulong, float and double items");
+            return std::is_same<T, int32_t>::value ? AMQP_TYPE_INT :
+                std::is_same<T, uint32_t>::value ? AMQP_TYPE_UINT :
+                std::is_same<T, int64_t>::value ? AMQP_TYPE_LONG :
+                std::is_same<T, uint64_t>::value ? AMQP_TYPE_ULONG :
+                std::is_same<T, float>::value ? AMQP_TYPE_FLOAT : AMQP_TYPE_DOUBLE;
+        }
+
+        AMQP_VALUE value_;
+    };
+
+    /* Owns one reference to an AMQP value. Values are reference counted, so clone() is cheap and does not copy. */
+    class value : public unique_handle<AMQP_VALUE, amqpvalue_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        static value null() noexcept { return value(amqpvalue_create_null()); }
+        static value boolean(bool bool_value) noexcept { return value(amqpvalue_create_boolean(bool_value)); }
+        static value uint(uint32_t uint_value) noexcept { return value(amqpvalue_create_uint(uint_value)); }
+        static value ulong(uint64_t ulong_value) noexcept { return value(amqpvalue_create_ulong(ulong_value)); }
+        static value int_(int32_t int_value) noexcept { return value(amqpvalue_create_int(int_value)); }
+        static value long_(int64_t long_value) noexcept { return value(amqpvalue_create_long(long_value)); }
+        static value string(std::string_view chars) noexcept { return value(amqpvalue_create_string_n(chars.data(), chars.size())); }
+        /* symbols are looked up in the interned symbol table, so they are taken zero terminated */
+        static value symbol(const char* chars) noexcept { return value(amqpvalue_create_symbol(chars)); }
+        static value list() noexcept { return value(amqpvalue_create_list()); }
+        static value map() noexcept { return value(amqpvalue_create_map()); }
+
+        static value binary(span<const unsigned char> bytes) noexcept
+        {
+            amqp_binary binary;
+            binary.bytes = bytes.data();
+            binary.length = static_cast<uint32_t>(bytes.size());
+            return value(amqpvalue_create_binary(binary));
+        }
+
+        value_view view() const noexcept { return value_view(get()); }
+        operator value_view() const noexcept { return view(); }
+
+        /* the map and list setters keep their own reference to item */
+        bool set(value_view key, value_view item) noexcept { return amqpvalue_set_map_value(get(), key.get(), item.get()) == 0; }
+        bool set(uint32_t index, value_view item) noexcept { return amqpvalue_set_list_item(get(), index, item.get()) == 0; }
+    };
+
+    inline value value_view::find(const char* symbol_key) const noexcept
+    {
+        return value(amqpvalue_get_map_value_by_symbol(value_, symbol_key));
+    }
+
+    inline value value_view::clone() const noexcept
+    {
+        return value(amqpvalue_clone(value_));
+    }
+
+    /* Looks at a message owned by someone else, for example the one passed to an ON_MESSAGE_RECEIVED callback */
+    class message_view
+    {
+    public:
+        message_view() noexcept : message_(nullptr) {}
+        message_view(MESSAGE_HANDLE message) noexcept : message_(message) {}
+
+        MESSAGE_HANDLE get() const noexcept { return message_; }
+        explicit operator bool() const noexcept { return message_ != nullptr; }
+
+        std::optional<MESSAGE_BODY_TYPE> body_type() const noexcept
+        {
+            MESSAGE_BODY_TYPE result;
+            return (message_get_body_type(message_, &result) == 0) ? std::optional<MESSAGE_BODY_TYPE>(result) : std::nullopt;
+        }
+
+        std::optional<size_t> body_data_count() const noexcept
+        {
+            size_t result;
+            return (message_get_body_amqp_data_count(message_, &result) == 0) ? std::optional<size_t>(result) : std::nullopt;
+        }
+
+        /* a data section of the body, the bytes stay in the message */
+        std::optional<span<const unsigned char>> body_data(size_t index) const noexcept
+        {
+            BINARY_DATA binary_data;
+            return (message_get_body_amqp_data_in_place(message_, index, &binary_data) == 0) ?
+                std::optional<span<const unsigned char>>(span<const unsigned char>(binary_data.bytes, binary_data.length)) :
+                std::nullopt;
+        }
+
+        value_view body_value() const noexcept
+        {
+            AMQP_VALUE result;
+            return (message_get_body_amqp_value_in_place(message_, &result) == 0) ? value_view(result) : value_view();
+        }
+
+        std::optional<size_t> body_sequence_count() const noexcept
+        {
+            size_t result;
+            return (message_get_body_amqp_sequence_count(message_, &result) == 0) ? std::optional<size_t>(result) : std::nullopt;
+        }
+
+        value_view body_sequence(size_t index) const noexcept
+        {
+            AMQP_VALUE result;
+            return (message_get_body_amqp_sequence_in_place(message_, index, &result) == 0) ? value_view(result) : value_view();
+        }
+
+        value application_properties() const noexcept
+        {
+            AMQP_VALUE result;
+            return (message_get_application_properties(message_, &result) == 0) ? value(result) : value();
+        }
+
+        value message_annotations() const noexcept
+        {
+            AMQP_VALUE result;
+            return (message_get_message_annotations(message_, &result) == 0) ? value(result) : value();
+        }
+
+        /* offset and partition_key point into the message annotations */
+        std::optional<MESSAGE_BROKER_ANNOTATIONS> broker_annotations() const noexcept
+        {
+            MESSAGE_BROKER_ANNOTATIONS result;
+            return (message_get_broker_annotations(message_, &result) == 0) ? std::optional<MESSAGE_BROKER_ANNOTATIONS>(result) : std::nullopt;
+        }
+
+        std::optional<uint32_t> message_format() const noexcept
+        {
+            uint32_t result;
+            return (message_get_message_format(message_, &result) == 0) ? std::optional<uint32_t>(result) : std::nullopt;
+        }
+
+        std::optional<size_t> encoded_size() const noexcept
+        {
+            size_t result;
+            return (message_get_encoded_size(message_, &result) == 0) ? std::optional<size_t>(result) : std::nullopt;
+        }
+
+    private:
+        MESSAGE_HANDLE message_;
+    };
+
+    class message : public unique_handle<MESSAGE_HANDLE, message_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        static message create() noexcept { return message(message_create()); }
+
+        message_view view() const noexcept { return message_view(get()); }
+        operator message_view() const noexcept { return view(); }
+        message clone() const noexcept { return message(message_clone(get())); }
+
+        /* copies the bytes into the message */
+        bool add_body_data(span<const unsigned char> bytes) noexcept
+        {
+            BINARY_DATA binary_data;
+            binary_data.bytes = bytes.data();
+            binary_data.length = bytes.size();
+            return message_add_body_amqp_data(get(), binary_data) == 0;
+        }
+
+        /* only points to the bytes, which have to outlive the message and its sends */
+        bool add_body_data_borrowed(span<const unsigned char> bytes) noexcept
+        {
+            BINARY_DATA binary_data;
+            binary_data.bytes = bytes.data();
+            binary_data.length = bytes.size();
+            return message_add_body_amqp_data_borrowed(get(), binary_data) == 0;
+        }
+
+        bool set_body_value(value_view body_value) noexcept { return message_set_body_amqp_value(get(), body_value.get()) == 0; }
+        bool set_application_properties(value_view application_properties) noexcept { return message_set_application_properties(get(), application_properties.get()) == 0; }
+        bool set_message_annotations(value_view annotations) noexcept { return message_set_message_annotations(get(), annotations.get()) == 0; }
+        bool set_message_format(uint32_t message_format) noexcept { return message_set_message_format(get(), message_format) == 0; }
+    };
+
+#if defined(UAMQP_HPP_COROUTINES)
+    /* Awaiters for the asynchronous operations (C++20). Each awaiter is the callback context of its operation and lives in
+       the frame of the awaiting coroutine, so nothing is allocated per operation. The coroutine is resumed from within the
+       completion callback, that is on the thread running connection_dowork (or in the destroy or close cancelling the
+       operation); when the operation completes while being started, the coroutine simply does not suspend. Strings, views
+       and arrays handed back by an awaiter are only good until the coroutine suspends again. */
+    class operation_awaiter
+    {
+    public:
+        bool await_ready() const noexcept { return false; }
+
+    protected:
+        operation_awaiter() noexcept : starting_(false), completed_(false) {}
+        operation_awaiter(const operation_awaiter&) = delete;
+        operation_awaiter& operator=(const operation_awaiter&) = delete;
+
+        /* start has to return whether the operation was started, its callback is then expected to call complete once */
+        template <typename Start>
+        bool suspend(std::coroutine_handle<> awaiting, Start start) noexcept
+        {
+            awaiting_ = awaiting;
+            starting_ = true;
+            bool started = start();
+            starting_ = false;
+            return started && !completed_;
+        }
+
+        void complete() noexcept
+        {
+            if (starting_)
+            {
+                completed_ = true;
+            }
+            else
+            {
+                awaiting_.resume();
+            }
+        }
+
+    private:
+        std::coroutine_handle<> awaiting_;
+        bool starting_;
+        bool completed_;
+    };
+
+    class send_awaiter : public operation_awaiter
+    {
+    public:
+        send_awaiter(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, tickcounter_ms_t timeout) noexcept :
+            message_sender_(message_sender), message_(message), timeout_(timeout), send_result_(MESSAGE_SEND_ERROR)
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            return suspend(awaiting, [this]() { return messagesender_send_async(message_sender_, message_, on_send_complete, this, timeout_) != nullptr; });
+        }
+
+        MESSAGE_SEND_RESULT await_resume() const noexcept { return send_result_; }
+
+    private:
+        static void on_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+        {
+            send_awaiter* awaiter = static_cast<send_awaiter*>(context);
+            awaiter->send_result_ = send_result;
+            awaiter->complete();
+        }
+
+        MESSAGE_SENDER_HANDLE message_sender_;
+        MESSAGE_HANDLE message_;
+        tickcounter_ms_t timeout_;
+        MESSAGE_SEND_RESULT send_result_;
+    };
+
+    /* the messages belong to the application, which settles them with their message_ids */
+    struct received_batch
+    {
+        MESSAGE_RECEIVER_BATCH_RESULT batch_result;
+        span<MESSAGE_HANDLE> messages;
+        span<delivery_number> message_ids;
+    };
+
+    class receive_batch_awaiter : public operation_awaiter
+    {
+    public:
+        receive_batch_awaiter(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t max_count, tickcounter_ms_t timeout) noexcept :
+            message_receiver_(message_receiver), max_count_(max_count), timeout_(timeout), batch_{ MESSAGE_RECEIVER_BATCH_RESULT_CANCELLED, {}, {} }
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            return suspend(awaiting, [this]() { return messagereceiver_receive_batch_async(message_receiver_, max_count_, timeout_, on_batch_received, this) == 0; });
+        }
+
+        received_batch await_resume() const noexcept { return batch_; }
+
+    private:
+        static void on_batch_received(void* context, MESSAGE_RECEIVER_BATCH_RESULT batch_result, MESSAGE_HANDLE* messages, delivery_number* message_ids, uint32_t message_count)
+        {
+            receive_batch_awaiter* awaiter = static_cast<receive_batch_awaiter*>(context);
+            awaiter->batch_.batch_result = batch_result;
+            awaiter->batch_.messages = span<MESSAGE_HANDLE>(messages, message_count);
+            awaiter->batch_.message_ids = span<delivery_number>(message_ids, message_count);
+            awaiter->complete();
+        }
+
+        MESSAGE_RECEIVER_HANDLE message_receiver_;
+        uint32_t max_count_;
+        tickcounter_ms_t timeout_;
+        received_batch batch_;
+    };
+
+    /* status_description and response stay owned by the management instance */
+    struct management_response
+    {
+        AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result;
+        unsigned int status_code;
+        const char* status_description;
+        message_view response;
+    };
+
+    class execute_operation_awaiter : public operation_awaiter
+    {
+    public:
+        execute_operation_awaiter(AMQP_MANAGEMENT_HANDLE amqp_management, const char* operation, const char* type, const char* locales, MESSAGE_HANDLE message) noexcept :
+            amqp_management_(amqp_management), operation_(operation), type_(type), locales_(locales), message_(message),
+            response_{ AMQP_MANAGEMENT_EXECUTE_OPERATION_ERROR, 0, nullptr, message_view() }
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            return suspend(awaiting, [this]() { return amqp_management_execute_operation_async(amqp_management_, operation_, type_, locales_, message_, on_execute_operation_complete, this) == 0; });
+        }
+
+        management_response await_resume() const noexcept { return response_; }
+
+    private:
+        static void on_execute_operation_complete(void* context, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result, unsigned int status_code, const char* status_description, MESSAGE_HANDLE message_handle)
+        {
+            execute_operation_awaiter* awaiter = static_cast<execute_operation_awaiter*>(context);
+            awaiter->response_.execute_operation_result = execute_operation_result;
+            awaiter->response_.status_code = status_code;
+            awaiter->response_.status_description = status_description;
+            awaiter->response_.response = message_view(message_handle);
+            awaiter->complete();
+        }
+
+        AMQP_MANAGEMENT_HANDLE amqp_management_;
+        const char* operation_;
+        const char* type_;
+        const char* locales_;
+        MESSAGE_HANDLE message_;
+        management_response response_;
+    };
+
+    struct cbs_response
+    {
+        CBS_OPERATION_RESULT complete_result;
+        unsigned int status_code;
+        const char* status_description;
+    };
+
+    class put_token_awaiter : public operation_awaiter
+    {
+    public:
+        put_token_awaiter(CBS_HANDLE cbs, const char* type, const char* audience, const char* token) noexcept :
+            cbs_(cbs), type_(type), audience_(audience), token_(token), response_{ CBS_OPERATION_RESULT_OPERATION_FAILED, 0, nullptr }
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            return suspend(awaiting, [this]() { return cbs_put_token_async(cbs_, type_, audience_, token_, on_put_token_complete, this) == 0; });
+        }
+
+        cbs_response await_resume() const noexcept { return response_; }
+
+    private:
+        static void on_put_token_complete(void* context, CBS_OPERATION_RESULT complete_result, unsigned int status_code, const char* status_description)
+        {
+            put_token_awaiter* awaiter = static_cast<put_token_awaiter*>(context);
+            awaiter->response_.complete_result = complete_result;
+            awaiter->response_.status_code = status_code;
+            awaiter->response_.status_description = status_description;
+            awaiter->complete();
+        }
+
+        CBS_HANDLE cbs_;
+        const char* type_;
+        const char* audience_;
+        const char* token_;
+        cbs_response response_;
+    };
+#endif
+
+    class connection : public unique_handle<CONNECTION_HANDLE, connection_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        /* the connection does not own io, which has to outlive it */
+        static connection create(XIO_HANDLE io, const char* hostname, const char* container_id, ON_NEW_ENDPOINT on_new_endpoint = nullptr, void* callback_context = nullptr) noexcept
+        {
+            return connection(connection_create(io, hostname, container_id, on_new_endpoint, callback_context));
+        }
+
+        bool open() noexcept { return connection_open(get()) == 0; }
+        void dowork() noexcept { connection_dowork(get()); }
+    };
+
+    class session : public unique_handle<SESSION_HANDLE, session_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        static session create(const connection& connection, ON_LINK_ATTACHED on_link_attached = nullptr, void* callback_context = nullptr) noexcept
+        {
+            return session(session_create(connection.get(), on_link_attached, callback_context));
+        }
+
+        bool begin() noexcept { return session_begin(get()) == 0; }
+        bool set_incoming_window(uint32_t incoming_window) noexcept { return session_set_incoming_window(get(), incoming_window) == 0; }
+    };
+
+    class link : public unique_handle<LINK_HANDLE, link_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        /* the link keeps its own copies of source and target */
+        static link create(const session& session, const char* name, role link_role, value_view source, value_view target) noexcept
+        {
+            return link(link_create(session.get(), name, link_role, source.get(), target.get()));
+        }
+
+        std::optional<std::string_view> name() const noexcept
+        {
+            const char* result;
+            return (link_get_name(get(), &result) == 0) ? std::optional<std::string_view>(std::string_view(result)) : std::nullopt;
+        }
+    };
+
+    class message_sender : public unique_handle<MESSAGE_SENDER_HANDLE, messagesender_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        static message_sender create(const link& link, ON_MESSAGE_SENDER_STATE_CHANGED on_state_changed = nullptr, void* context = nullptr) noexcept
+        {
+            return message_sender(messagesender_create(link.get(), on_state_changed, context));
+        }
+
+        bool open() noexcept { return messagesender_open(get()) == 0; }
+        bool close() noexcept { return messagesender_close(get()) == 0; }
+
+        /* the sender encodes message before returning, the caller keeps its message; the returned operation is owned by the
+           sender and only good for cancelling the send until on_send_complete is called */
+        ASYNC_OPERATION_HANDLE send_async(message_view message, ON_MESSAGE_SEND_COMPLETE on_send_complete, void* callback_context, tickcounter_ms_t timeout = 0) noexcept
+        {
+            return messagesender_send_async(get(), message.get(), on_send_complete, callback_context, timeout);
+        }
+
+#if defined(UAMQP_HPP_COROUTINES)
+        /* co_await sender.send(message) gives the MESSAGE_SEND_RESULT */
+        send_awaiter send(message_view message, tickcounter_ms_t timeout = 0) noexcept { return send_awaiter(get(), message.get(), timeout); }
+#endif
+    };
+
+    class message_receiver : public unique_handle<MESSAGE_RECEIVER_HANDLE, messagereceiver_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        static message_receiver create(const link& link, ON_MESSAGE_RECEIVER_STATE_CHANGED on_state_changed = nullptr, void* context = nullptr) noexcept
+        {
+            return message_receiver(messagereceiver_create(link.get(), on_state_changed, context));
+        }
+
+        /* on_message_received gets messages owned by the receiver, wrap them in a message_view */
+        bool open(ON_MESSAGE_RECEIVED on_message_received, void* callback_context) noexcept { return messagereceiver_open(get(), on_message_received, callback_context) == 0; }
+        bool close() noexcept { return messagereceiver_close(get()) == 0; }
+
+        /* keeps the message being received from being reused, the caller owns it from then on */
+        message take(message_view received_message) noexcept
+        {
+            return (messagereceiver_take_message(get(), received_message.get()) == 0) ? message(received_message.get()) : message();
+        }
+
+        bool send_disposition(const char* link_name, delivery_number message_number, value_view delivery_state) noexcept
+        {
+            return messagereceiver_send_message_disposition(get(), link_name, message_number, delivery_state.get()) == 0;
+        }
+
+#if defined(UAMQP_HPP_COROUTINES)
+        /* co_await receiver.receive(max_count, timeout) gives the received_batch of messagereceiver_receive_batch_async */
+        receive_batch_awaiter receive(uint32_t max_count, tickcounter_ms_t timeout = 0) noexcept { return receive_batch_awaiter(get(), max_count, timeout); }
+#endif
+    };
+
+    class management : public unique_handle<AMQP_MANAGEMENT_HANDLE, amqp_management_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        static management create(const session& session, const char* management_node) noexcept
+        {
+            return management(amqp_management_create(session.get(), management_node));
+        }
+
+        bool open_async(ON_AMQP_MANAGEMENT_OPEN_COMPLETE on_open_complete, void* on_open_complete_context, ON_AMQP_MANAGEMENT_ERROR on_error, void* on_error_context) noexcept
+        {
+            return amqp_management_open_async(get(), on_open_complete, on_open_complete_context, on_error, on_error_context) == 0;
+        }
+
+        bool close() noexcept { return amqp_management_close(get()) == 0; }
+
+#if defined(UAMQP_HPP_COROUTINES)
+        /* co_await management.execute(...) gives the management_response; the strings have to stay valid until then */
+        execute_operation_awaiter execute(const char* operation, const char* type, const char* locales, message_view message) noexcept
+        {
+            return execute_operation_awaiter(get(), operation, type, locales, message.get());
+        }
+#endif
+    };
+
+    class cbs : public unique_handle<CBS_HANDLE, cbs_destroy>
+    {
+    public:
+        using unique_handle::unique_handle;
+
+        static cbs create(const session& session) noexcept { return cbs(cbs_create(session.get())); }
+
+        bool open_async(ON_CBS_OPEN_COMPLETE on_open_complete, void* on_open_complete_context, ON_CBS_ERROR on_error, void* on_error_context) noexcept
+        {
+            return cbs_open_async(get(), on_open_complete, on_open_complete_context, on_error, on_error_context) == 0;
+        }
+
+        bool close() noexcept { return cbs_close(get()) == 0; }
+
+#if defined(UAMQP_HPP_COROUTINES)
+        /* co_await cbs.put_token(...) gives the cbs_response; the strings have to stay valid until then */
+        put_token_awaiter put_token(const char* type, const char* audience, const char* token) noexcept
+        {
+            return put_token_awaiter(get(), type, audience, token);
+        }
+#endif
+    };
+}
+
+#endif /* UAMQP_HPP */
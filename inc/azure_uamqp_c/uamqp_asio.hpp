@@ -0,0 +1,178 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UAMQP_ASIO_HPP
+#define UAMQP_ASIO_HPP
+
+/* Header only driver running a connection from an Asio io_context (Boost.Asio, or standalone Asio when
+   UAMQP_ASIO_STANDALONE is defined), POSIX only: connection_dowork only runs when the socket under the connection's io
+   is ready for what connection_get_io_interest asks for, when the connection's next deadline is due or after signal().
+   The driver does not use a strand, so the io_context is to be run by one thread, which is where the application uses
+   the connection, its sessions and links. Sends from that thread are to be followed by signal(). stop() has to be
+   called before the connection is destroyed, the pending handlers then finish without touching the connection. The
+   socket is watched, never closed. */
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#if defined(UAMQP_ASIO_STANDALONE)
+#include <asio.hpp>
+#else
+#include <boost/asio.hpp>
+#endif
+
+#include "azure_uamqp_c/connection.h"
+
+namespace azure_uamqp
+{
+#if defined(UAMQP_ASIO_STANDALONE)
+    namespace asio_ns = ::asio;
+    using asio_error_code = std::error_code;
+#else
+    namespace asio_ns = ::boost::asio;
+    using asio_error_code = ::boost::system::error_code;
+#endif
+
+    class asio_connection_driver : public std::enable_shared_from_this<asio_connection_driver>
+    {
+    public:
+        /* fd is the socket under the connection's io, or -1 when the connection is only driven by its timers */
+        static std::shared_ptr<asio_connection_driver> create(asio_ns::io_context& io_context, CONNECTION_HANDLE connection, int fd)
+        {
+            std::shared_ptr<asio_connection_driver> result(new asio_connection_driver(io_context, connection, fd));
+            /* the first connection_dowork (which opens the io) happens from the io_context */
+            result->signal();
+            return result;
+        }
+
+        asio_connection_driver(const asio_connection_driver&) = delete;
+        asio_connection_driver& operator=(const asio_connection_driver&) = delete;
+
+        ~asio_connection_driver()
+        {
+            if (descriptor_.is_open())
+            {
+                /* the socket belongs to the io */
+                (void)descriptor_.release();
+            }
+        }
+
+        void signal()
+        {
+            if (!is_stopped_)
+            {
+                std::shared_ptr<asio_connection_driver> self = shared_from_this();
+                asio_ns::post(timer_.get_executor(), [self]() { self->run_connection(); });
+            }
+        }
+
+        void stop()
+        {
+            asio_error_code error;
+
+            is_stopped_ = true;
+            (void)timer_.cancel();
+            if (descriptor_.is_open())
+            {
+                (void)descriptor_.cancel(error);
+            }
+        }
+
+    private:
+        asio_connection_driver(asio_ns::io_context& io_context, CONNECTION_HANDLE connection, int fd) :
+            connection_(connection), timer_(io_context), descriptor_(io_context),
+            is_read_pending_(false), is_write_pending_(false), is_stopped_(false)
+        {
+            if (fd != -1)
+            {
+                descriptor_.assign(fd);
+            }
+        }
+
+        void run_connection()
+        {
+            if (!is_stopped_)
+            {
+                connection_dowork(connection_);
+
+                /* the callbacks of connection_dowork may have stopped the driver */
+                if (!is_stopped_)
+                {
+                    update_interest();
+                }
+            }
+        }
+
+        /* a wait that is no longer wanted is left to complete, costing one connection_dowork, rather than cancelled */
+        void update_interest()
+        {
+            CONNECTION_IO_INTEREST io_interest;
+
+            if (connection_get_io_interest(connection_, &io_interest) != 0)
+            {
+                /* run again as soon as possible rather than stall the connection */
+                io_interest.want_read = true;
+                io_interest.want_write = false;
+                io_interest.timeout_ms = 0;
+            }
+
+            if (descriptor_.is_open())
+            {
+                if (io_interest.want_read && !is_read_pending_)
+                {
+                    wait_for(asio_ns::posix::stream_descriptor::wait_read, is_read_pending_);
+                }
+
+                if (io_interest.want_write && !is_write_pending_)
+                {
+                    wait_for(asio_ns::posix::stream_descriptor::wait_write, is_write_pending_);
+                }
+            }
+
+            if (io_interest.timeout_ms == (uint64_t)-1)
+            {
+                (void)timer_.cancel();
+            }
+            else
+            {
+                std::shared_ptr<asio_connection_driver> self = shared_from_this();
+                (void)timer_.expires_after(std::chrono::milliseconds(io_interest.timeout_ms));
+                timer_.async_wait([self](const asio_error_code& error)
+                {
+                    if (error != asio_ns::error::operation_aborted)
+                    {
+                        self->run_connection();
+                    }
+                });
+            }
+        }
+
+        void wait_for(asio_ns::posix::stream_descriptor::wait_type wait_type, bool& is_pending)
+        {
+            std::shared_ptr<asio_connection_driver> self = shared_from_this();
+            bool* pending = &is_pending;
+
+            is_pending = true;
+            descriptor_.async_wait(wait_type, [self, pending](const asio_error_code& error)
+            {
+                *pending = false;
+
+                /* errors on the socket are for the io to find out in connection_dowork */
+                if (error != asio_ns::error::operation_aborted)
+                {
+                    self->run_connection();
+                }
+            });
+        }
+
+        CONNECTION_HANDLE connection_;
+        asio_ns::steady_timer timer_;
+        asio_ns::posix::stream_descriptor descriptor_;
+        bool is_read_pending_;
+        bool is_write_pending_;
+        bool is_stopped_;
+    };
+}
+
+#endif /* UAMQP_ASIO_HPP */
@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UAMQP_LIBUV_H
+#define UAMQP_LIBUV_H
+
+#include <uv.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_uamqp_c/connection.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    typedef struct UAMQP_LIBUV_CONNECTION_INSTANCE_TAG* UAMQP_LIBUV_CONNECTION_HANDLE;
+
+    /* Drives connection from a libuv loop (built with use_libuv): connection_dowork only runs when fd (the socket under
+       the connection's io, or -1 when there is none) is ready for what connection_get_io_interest asks for, when the
+       connection's next deadline is due or after uamqp_libuv_connection_signal. Everything happens on the loop's thread,
+       which is where the application uses the connection, its sessions and links. Sending from the loop thread is to be
+       followed by uamqp_libuv_connection_signal, so that the frames reach the io on the next loop iteration.
+       uamqp_libuv_connection_destroy closes the libuv handles and frees the driver once libuv is done with them, the
+       connection itself can be destroyed right after. */
+    MOCKABLE_FUNCTION(, UAMQP_LIBUV_CONNECTION_HANDLE, uamqp_libuv_connection_create, uv_loop_t*, loop, CONNECTION_HANDLE, connection, int, fd);
+    MOCKABLE_FUNCTION(, void, uamqp_libuv_connection_destroy, UAMQP_LIBUV_CONNECTION_HANDLE, libuv_connection);
+    MOCKABLE_FUNCTION(, int, uamqp_libuv_connection_signal, UAMQP_LIBUV_CONNECTION_HANDLE, libuv_connection);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UAMQP_LIBUV_H */
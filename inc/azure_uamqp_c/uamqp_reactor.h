@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UAMQP_REACTOR_H
+#define UAMQP_REACTOR_H
+
+#include <stdint.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_uamqp_c/connection.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    typedef struct UAMQP_REACTOR_INSTANCE_TAG* UAMQP_REACTOR_HANDLE;
+    typedef void(*ON_REACTOR_WORK)(void* context);
+
+    /* The reactor runs connection_dowork only for connections whose socket is readable or writable,
+       whose idle timers are due or that have been signalled with uamqp_reactor_signal_connection.
+       fd is the socket used by the connection's bottom IO, or -1 when the connection is only driven by
+       its timers and signals. IOs that buffer bytes internally (TLS) should signal after each send.
+       When the socket only exists once the IO is open, or is replaced on reconnect, the connection is added with -1
+       and uamqp_reactor_set_connection_fd sets or refreshes its socket later, -1 again dropping it. */
+    MOCKABLE_FUNCTION(, UAMQP_REACTOR_HANDLE, uamqp_reactor_create);
+    MOCKABLE_FUNCTION(, void, uamqp_reactor_destroy, UAMQP_REACTOR_HANDLE, reactor);
+    MOCKABLE_FUNCTION(, int, uamqp_reactor_add_connection, UAMQP_REACTOR_HANDLE, reactor, CONNECTION_HANDLE, connection, int, fd);
+    MOCKABLE_FUNCTION(, int, uamqp_reactor_remove_connection, UAMQP_REACTOR_HANDLE, reactor, CONNECTION_HANDLE, connection);
+    MOCKABLE_FUNCTION(, int, uamqp_reactor_set_connection_fd, UAMQP_REACTOR_HANDLE, reactor, CONNECTION_HANDLE, connection, int, fd);
+    MOCKABLE_FUNCTION(, int, uamqp_reactor_signal_connection, UAMQP_REACTOR_HANDLE, reactor, CONNECTION_HANDLE, connection);
+    MOCKABLE_FUNCTION(, int, uamqp_reactor_run_once, UAMQP_REACTOR_HANDLE, reactor, uint32_t, max_wait_ms);
+
+    /* A reactor and its connections belong to the thread calling uamqp_reactor_run_once. Spreading connections across
+       cores means one reactor per worker thread. uamqp_reactor_post is the only function that may be called from other
+       threads: on_work runs on the reactor thread on its next pass, in posting order, and is where application threads
+       call messagesender_send_async (then signal the connection). Work still pending at destroy is discarded. */
+    MOCKABLE_FUNCTION(, int, uamqp_reactor_post, UAMQP_REACTOR_HANDLE, reactor, ON_REACTOR_WORK, on_work, void*, on_work_context);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UAMQP_REACTOR_H */
@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UAMQP_STATIC_POOLS_H
+#define UAMQP_STATIC_POOLS_H
+
+/* Compile-time capacities of the static_pools build profile (UAMQP_STATIC_POOLS), meant for devices that must not
+   allocate from the heap once their links are attached. Each capacity can be overridden on the compiler command line,
+   the static_pools_* CMake cache variables do that for the library and its users.
+   - UAMQP_STATIC_MAX_FRAME_SIZE bounds the frames a connection accepts and sends, the frame codec holds a receive and
+     an encode buffer of that size instead of allocating them per frame.
+   - UAMQP_STATIC_MAX_LINKS bounds the links of a session (its handle max is UAMQP_STATIC_MAX_LINKS - 1).
+   - UAMQP_STATIC_MAX_PENDING_DELIVERIES is the number of delivery and send operations that links and message senders
+     keep ready in their pools, so unsettled deliveries up to that count do not allocate. */
+
+#ifndef UAMQP_STATIC_MAX_FRAME_SIZE
+#define UAMQP_STATIC_MAX_FRAME_SIZE 4096
+#endif
+
+#ifndef UAMQP_STATIC_MAX_LINKS
+#define UAMQP_STATIC_MAX_LINKS 4
+#endif
+
+#ifndef UAMQP_STATIC_MAX_PENDING_DELIVERIES
+#define UAMQP_STATIC_MAX_PENDING_DELIVERIES 16
+#endif
+
+#if UAMQP_STATIC_MAX_FRAME_SIZE < 512
+#error "UAMQP_STATIC_MAX_FRAME_SIZE cannot be less than the AMQP minimum max frame size of 512"
+#endif
+
+#if UAMQP_STATIC_MAX_LINKS < 1
+#error "UAMQP_STATIC_MAX_LINKS has to allow at least one link"
+#endif
+
+#endif /* UAMQP_STATIC_POOLS_H */
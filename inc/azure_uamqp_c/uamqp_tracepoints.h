@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UAMQP_TRACEPOINTS_H
+#define UAMQP_TRACEPOINTS_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/* Static tracepoints on the hot path, compiled in with the tracepoints CMake option. On Linux they are USDT probes of
+   the "uamqp" provider (for example uamqp:session_send_transfer, listed with "bpftrace -l 'usdt:<binary>:uamqp:*'"),
+   on Windows they are TraceLogging events of the "Microsoft.Azure.uAMQP" ETW provider, which is registered by
+   uamqp_tracepoints_init. When the option is OFF the macros expand to nothing and their arguments are not evaluated. */
+
+#if defined(UAMQP_TRACEPOINTS_USDT)
+
+#include <sys/sdt.h>
+
+#define UAMQP_TRACEPOINT1(name, arg1) \
+    DTRACE_PROBE1(uamqp, name, (uint64_t)(arg1))
+#define UAMQP_TRACEPOINT2(name, arg1, arg2) \
+    DTRACE_PROBE2(uamqp, name, (uint64_t)(arg1), (uint64_t)(arg2))
+#define UAMQP_TRACEPOINT3(name, arg1, arg2, arg3) \
+    DTRACE_PROBE3(uamqp, name, (uint64_t)(arg1), (uint64_t)(arg2), (uint64_t)(arg3))
+
+#elif defined(UAMQP_TRACEPOINTS_ETW)
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(uamqp_trace_provider);
+
+#define UAMQP_TRACEPOINT1(name, arg1) \
+    TraceLoggingWrite(uamqp_trace_provider, #name, TraceLoggingUInt64((uint64_t)(arg1), "arg1"))
+#define UAMQP_TRACEPOINT2(name, arg1, arg2) \
+    TraceLoggingWrite(uamqp_trace_provider, #name, TraceLoggingUInt64((uint64_t)(arg1), "arg1"), TraceLoggingUInt64((uint64_t)(arg2), "arg2"))
+#define UAMQP_TRACEPOINT3(name, arg1, arg2, arg3) \
+    TraceLoggingWrite(uamqp_trace_provider, #name, TraceLoggingUInt64((uint64_t)(arg1), "arg1"), TraceLoggingUInt64((uint64_t)(arg2), "arg2"), TraceLoggingUInt64((uint64_t)(arg3), "arg3"))
+
+#else
+
+#define UAMQP_TRACEPOINT1(name, arg1)
+#define UAMQP_TRACEPOINT2(name, arg1, arg2)
+#define UAMQP_TRACEPOINT3(name, arg1, arg2, arg3)
+
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    /* With ETW tracepoints the provider has to be registered before events are seen, elsewhere these do nothing */
+    MOCKABLE_FUNCTION(, int, uamqp_tracepoints_init);
+    MOCKABLE_FUNCTION(, void, uamqp_tracepoints_deinit);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UAMQP_TRACEPOINTS_H */
@@ -0,0 +1,30 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UNIX_SOCKET_IO_H
+#define UNIX_SOCKET_IO_H
+
+#include "azure_c_shared_utility/xio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+    typedef struct UNIX_SOCKET_IO_CONFIG_TAG
+    {
+        /* the path a listener made with socketlistener_create_unix is bound to */
+        const char* path;
+    } UNIX_SOCKET_IO_CONFIG;
+
+    /* The client side of a Unix domain socket, for local hops where loopback TCP is pure overhead. xio_open connects to
+       path (a local connect completes or fails right away) and from there on the socket is driven by a socketio, as an
+       accepted socket would be. Give it to connection_create2 (or a saslclientio) in place of a socketio. Not on Windows. */
+    MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, unix_socket_io_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UNIX_SOCKET_IO_H */
@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef URINGIO_H
+#define URINGIO_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/xio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#define URINGIO_DEFAULT_RECEIVE_BUFFER_SIZE 65536
+
+    typedef struct URINGIO_CONFIG_TAG
+    {
+        const char* hostname;
+        int port;
+        /* size of the receive buffer registered with the ring, 0 for URINGIO_DEFAULT_RECEIVE_BUFFER_SIZE */
+        size_t receive_buffer_size;
+    } URINGIO_CONFIG;
+
+    /* A TCP client io (Linux only, built with use_io_uring) that goes through an io_uring instead of non-blocking send/recv.
+       Give xio_create a URINGIO_CONFIG and pass the io to connection_create2 in place of a socketio (or below a tlsio).
+       Receives land in a buffer registered with the ring and are handed to on_bytes_received from it.
+       Sends are queued by xio_send and each xio_dowork submits everything queued as one gathered sendmsg, together with
+       the next receive, in a single io_uring_enter call. */
+    MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, uringio_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* URINGIO_H */
@@ -0,0 +1,279 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_uamqp_c/uamqp.h"
+
+/* Prints a frame trace written with frame_trace_save (for example by an application dumping the trace attached
+   with connection_set_frame_trace to a file) with the performatives formatted by amqpvalue_to_string. */
+
+typedef struct DECODE_CONTEXT_TAG
+{
+    unsigned int record_count;
+    unsigned int failed_record_count;
+} DECODE_CONTEXT;
+
+static const char* get_frame_type_as_string(FRAME_TRACE_FRAME_TYPE frame_type)
+{
+    const char* result;
+
+    switch (frame_type)
+    {
+    default:
+        result = "unknown";
+        break;
+
+    case FRAME_TRACE_FRAME_TYPE_HEADER:
+        result = "header";
+        break;
+
+    case FRAME_TRACE_FRAME_TYPE_EMPTY:
+        result = "empty frame";
+        break;
+
+    case FRAME_TRACE_FRAME_TYPE_PERFORMATIVE:
+        result = "frame";
+        break;
+    }
+
+    return result;
+}
+
+static const char* get_performative_name(AMQP_VALUE performative)
+{
+    const char* result;
+    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
+
+    if (descriptor == NULL)
+    {
+        result = "[Unknown]";
+    }
+    else if (is_open_type_by_descriptor(descriptor))
+    {
+        result = "[OPEN]";
+    }
+    else if (is_begin_type_by_descriptor(descriptor))
+    {
+        result = "[BEGIN]";
+    }
+    else if (is_attach_type_by_descriptor(descriptor))
+    {
+        result = "[ATTACH]";
+    }
+    else if (is_flow_type_by_descriptor(descriptor))
+    {
+        result = "[FLOW]";
+    }
+    else if (is_disposition_type_by_descriptor(descriptor))
+    {
+        result = "[DISPOSITION]";
+    }
+    else if (is_transfer_type_by_descriptor(descriptor))
+    {
+        result = "[TRANSFER]";
+    }
+    else if (is_detach_type_by_descriptor(descriptor))
+    {
+        result = "[DETACH]";
+    }
+    else if (is_end_type_by_descriptor(descriptor))
+    {
+        result = "[END]";
+    }
+    else if (is_close_type_by_descriptor(descriptor))
+    {
+        result = "[CLOSE]";
+    }
+    else
+    {
+        result = "[Unknown]";
+    }
+
+    return result;
+}
+
+static void on_performative_decoded(void* context, AMQP_VALUE decoded_value)
+{
+    /* the decoded value is owned by the decoder */
+    char* performative_as_string = amqpvalue_to_string(decoded_value);
+    (void)context;
+
+    (void)printf(" %s", get_performative_name(decoded_value));
+    if (performative_as_string == NULL)
+    {
+        (void)printf(" <cannot format performative>");
+    }
+    else
+    {
+        (void)printf(" %s", performative_as_string);
+        free(performative_as_string);
+    }
+}
+
+static void print_performative(DECODE_CONTEXT* decode_context, const FRAME_TRACE_RECORD* record)
+{
+    if (record->captured_size < record->performative_size)
+    {
+        /* a truncated performative cannot be decoded, only its leading bytes are shown */
+        uint32_t i;
+
+        (void)printf(" truncated, %u of %u bytes:", (unsigned int)record->captured_size, (unsigned int)record->performative_size);
+        for (i = 0; i < record->captured_size; i++)
+        {
+            (void)printf(" %02X", record->performative_bytes[i]);
+        }
+    }
+    else
+    {
+        AMQPVALUE_DECODER_HANDLE decoder = amqpvalue_decoder_create(on_performative_decoded, NULL);
+        if (decoder == NULL)
+        {
+            (void)printf(" <cannot create decoder>");
+            decode_context->failed_record_count++;
+        }
+        else
+        {
+            if (amqpvalue_decode_bytes(decoder, record->performative_bytes, record->captured_size) != 0)
+            {
+                (void)printf(" <cannot decode performative>");
+                decode_context->failed_record_count++;
+            }
+
+            amqpvalue_decoder_destroy(decoder);
+        }
+    }
+}
+
+static void on_record(void* context, const FRAME_TRACE_RECORD* record)
+{
+    DECODE_CONTEXT* decode_context = (DECODE_CONTEXT*)context;
+
+    (void)printf("%llu ms %s %s ch %u",
+        (unsigned long long)record->timestamp_ms,
+        (record->direction == FRAME_TRACE_DIRECTION_INCOMING) ? "<-" : "->",
+        get_frame_type_as_string(record->frame_type),
+        (unsigned int)record->channel);
+
+    if ((record->frame_type == FRAME_TRACE_FRAME_TYPE_PERFORMATIVE) &&
+        (record->captured_size > 0))
+    {
+        print_performative(decode_context, record);
+    }
+
+    if (record->payload_size > 0)
+    {
+        (void)printf(" + %u payload bytes", (unsigned int)record->payload_size);
+    }
+
+    (void)printf("\r\n");
+    decode_context->record_count++;
+}
+
+static unsigned char* read_file(const char* file_name, size_t* size)
+{
+    unsigned char* result;
+    FILE* file = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        (void)printf("Cannot open %s\r\n", file_name);
+        result = NULL;
+    }
+    else
+    {
+        size_t capacity = 64 * 1024;
+
+        *size = 0;
+        result = (unsigned char*)malloc(capacity);
+        while (result != NULL)
+        {
+            size_t read_size = fread(result + *size, 1, capacity - *size, file);
+            *size += read_size;
+
+            if (*size < capacity)
+            {
+                break;
+            }
+            else
+            {
+                unsigned char* new_result = (unsigned char*)realloc(result, capacity * 2);
+                if (new_result == NULL)
+                {
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result = new_result;
+                    capacity *= 2;
+                }
+            }
+        }
+
+        if (result == NULL)
+        {
+            (void)printf("Cannot allocate memory for reading %s\r\n", file_name);
+        }
+        else if (ferror(file))
+        {
+            (void)printf("Cannot read %s\r\n", file_name);
+            free(result);
+            result = NULL;
+        }
+
+        (void)fclose(file);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (argc != 2)
+    {
+        (void)printf("Usage: frame_trace_decoder <saved frame trace>\r\n");
+        result = -1;
+    }
+    else
+    {
+        size_t size;
+        unsigned char* bytes;
+
+        gballoc_init();
+
+        bytes = read_file(argv[1], &size);
+        if (bytes == NULL)
+        {
+            result = -1;
+        }
+        else
+        {
+            DECODE_CONTEXT decode_context;
+
+            decode_context.record_count = 0;
+            decode_context.failed_record_count = 0;
+
+            if (frame_trace_parse(bytes, size, on_record, &decode_context) != 0)
+            {
+                (void)printf("The frame trace is invalid after %u records\r\n", decode_context.record_count);
+                result = -1;
+            }
+            else
+            {
+                (void)printf("%u records, %u could not be decoded\r\n", decode_context.record_count, decode_context.failed_record_count);
+                result = (decode_context.failed_record_count == 0) ? 0 : -1;
+            }
+
+            free(bytes);
+        }
+
+        gballoc_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,245 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_uamqp_c/uamqp.h"
+
+/* An ingestion endpoint accepting any number of plain AMQP connections on port 5672 and spreading them over worker
+   threads with amqp_server. Each connection gets one session and up to MAX_LINKS receiving links, all messages are
+   accepted and counted. */
+
+#define WORKER_COUNT 4
+#define MAX_LINKS 16
+#define RUN_TIME_SECONDS 60
+
+typedef struct SAMPLE_CONNECTION_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    LINK_HANDLE links[MAX_LINKS];
+    MESSAGE_RECEIVER_HANDLE message_receivers[MAX_LINKS];
+    size_t link_count;
+} SAMPLE_CONNECTION;
+
+/* updated from all worker threads */
+static size_t received_messages = 0;
+
+static void on_message_receiver_state_changed(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state)
+{
+    (void)context;
+    (void)new_state;
+    (void)previous_state;
+}
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    (void)context;
+    (void)message;
+
+    (void)__atomic_add_fetch(&received_messages, 1, __ATOMIC_RELAXED);
+
+    return messaging_delivery_accepted();
+}
+
+static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    SAMPLE_CONNECTION* sample_connection = (SAMPLE_CONNECTION*)context;
+    bool result;
+
+    if (sample_connection->link_count == MAX_LINKS)
+    {
+        result = false;
+    }
+    else
+    {
+        LINK_HANDLE link = link_create_from_endpoint(sample_connection->session, new_link_endpoint, name, role, source, target);
+        if (link == NULL)
+        {
+            result = false;
+        }
+        else
+        {
+            MESSAGE_RECEIVER_HANDLE message_receiver;
+
+            (void)link_set_rcv_settle_mode(link, receiver_settle_mode_first);
+            message_receiver = messagereceiver_create(link, on_message_receiver_state_changed, NULL);
+            if (message_receiver == NULL)
+            {
+                link_destroy(link);
+                result = false;
+            }
+            else if (messagereceiver_open(message_receiver, on_message_received, NULL) != 0)
+            {
+                messagereceiver_destroy(message_receiver);
+                link_destroy(link);
+                result = false;
+            }
+            else
+            {
+                sample_connection->links[sample_connection->link_count] = link;
+                sample_connection->message_receivers[sample_connection->link_count] = message_receiver;
+                sample_connection->link_count++;
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void* on_connection_created(void* context, CONNECTION_HANDLE connection, size_t worker_index)
+{
+    SAMPLE_CONNECTION* sample_connection = (SAMPLE_CONNECTION*)malloc(sizeof(SAMPLE_CONNECTION));
+    (void)context;
+
+    if (sample_connection != NULL)
+    {
+        sample_connection->connection = connection;
+        sample_connection->session = NULL;
+        sample_connection->link_count = 0;
+    }
+
+    (void)printf("Connection accepted on worker %u\r\n", (unsigned int)worker_index);
+
+    return sample_connection;
+}
+
+static bool on_new_session_endpoint(void* connection_context, CONNECTION_HANDLE connection, ENDPOINT_HANDLE new_endpoint)
+{
+    SAMPLE_CONNECTION* sample_connection = (SAMPLE_CONNECTION*)connection_context;
+    bool result;
+
+    if ((sample_connection == NULL) ||
+        (sample_connection->session != NULL))
+    {
+        result = false;
+    }
+    else
+    {
+        sample_connection->session = session_create_from_endpoint(connection, new_endpoint, on_new_link_attached, sample_connection);
+        if (sample_connection->session == NULL)
+        {
+            result = false;
+        }
+        else
+        {
+            (void)session_set_incoming_window(sample_connection->session, 10000);
+            result = (session_begin(sample_connection->session) == 0);
+        }
+    }
+
+    return result;
+}
+
+static void on_connection_closed(void* connection_context, CONNECTION_HANDLE connection)
+{
+    SAMPLE_CONNECTION* sample_connection = (SAMPLE_CONNECTION*)connection_context;
+    (void)connection;
+
+    if (sample_connection != NULL)
+    {
+        size_t i;
+
+        for (i = 0; i < sample_connection->link_count; i++)
+        {
+            messagereceiver_destroy(sample_connection->message_receivers[i]);
+            link_destroy(sample_connection->links[i]);
+        }
+
+        if (sample_connection->session != NULL)
+        {
+            session_destroy(sample_connection->session);
+        }
+
+        free(sample_connection);
+    }
+
+    (void)printf("Connection closed\r\n");
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    (void)argc;
+    (void)argv;
+
+    if (platform_init() != 0)
+    {
+        result = -1;
+    }
+    else
+    {
+        AMQP_SERVER_CONFIG server_config;
+        AMQP_SERVER_HANDLE server;
+
+        gballoc_init();
+
+        server_config.port = 5672;
+        server_config.unix_socket_path = NULL;
+        server_config.worker_count = WORKER_COUNT;
+        server_config.backlog = 1024;
+        server_config.reuse_port = false;
+        server_config.connection_admission_limiter = NULL;
+        server_config.worker_cpus = NULL;
+        server_config.numa_local_memory = false;
+        server_config.steer_to_numa_node = false;
+        server_config.receive_buffer_count = 0;
+        server_config.receive_buffer_size = 0;
+        server_config.receive_buffers_on_huge_pages = false;
+        server_config.container_id = "multi-core-server";
+        server_config.on_connection_created = on_connection_created;
+        server_config.on_new_session_endpoint = on_new_session_endpoint;
+        server_config.on_connection_closed = on_connection_closed;
+        server_config.callback_context = NULL;
+
+        server = amqp_server_create(&server_config);
+        if (server == NULL)
+        {
+            (void)printf("Could not create the server\r\n");
+            result = -1;
+        }
+        else
+        {
+            if (amqp_server_start(server) != 0)
+            {
+                (void)printf("Could not start the server\r\n");
+                result = -1;
+            }
+            else
+            {
+                unsigned int i;
+
+                /* this thread only accepts, the connections run on the workers */
+                for (i = 0; i < RUN_TIME_SECONDS * 1000; i++)
+                {
+                    amqp_server_dowork(server);
+
+                    if ((i % 1000) == 0)
+                    {
+                        (void)printf("%u connections, %u messages received\r\n",
+                            (unsigned int)amqp_server_get_connection_count(server),
+                            (unsigned int)__atomic_load_n(&received_messages, __ATOMIC_RELAXED));
+                    }
+
+                    ThreadAPI_Sleep(1);
+                }
+
+                (void)amqp_server_stop(server);
+                result = 0;
+            }
+
+            amqp_server_destroy(server);
+        }
+
+        platform_deinit();
+        gballoc_deinit();
+    }
+
+    return result;
+}
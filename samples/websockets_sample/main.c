@@ -19,6 +19,9 @@
 #define IOT_HUB_DEVICE_KEY "<<<Replace with your own device key>>>"
 
 static const size_t msg_count = 1000;
+/* every xio_send on the WS IO becomes one WebSocket message, batching packs many AMQP frames into each of them */
+static const uint32_t ws_outgoing_batch_size = 65536;
+static const milliseconds ws_outgoing_batch_delay = 5;
 static unsigned int sent_messages = 0;
 static bool auth = false;
 
@@ -133,6 +136,8 @@ int main(int argc, char** argv)
         /* create the connection, session and link */
         connection = connection_create(sasl_io, IOT_HUB_HOST, "some", NULL, NULL);
         connection_set_trace(connection, true);
+        (void)connection_set_outgoing_batch_size(connection, ws_outgoing_batch_size);
+        (void)connection_set_outgoing_batch_delay(connection, ws_outgoing_batch_delay);
         session = session_create(connection, NULL, NULL);
         session_set_incoming_window(session, 2147483647);
         session_set_outgoing_window(session, 65536);
@@ -192,10 +197,13 @@ int main(int argc, char** argv)
             uint32_t i;
             bool keep_running = true;
 
+            /* the transfers of the whole burst go out in as few WebSocket messages as the batch size allows */
+            (void)connection_hold_outgoing_batch(connection);
             for (i = 0; i < msg_count; i++)
             {
                 (void)messagesender_send_async(message_sender, message, on_message_send_complete, message, 0);
             }
+            (void)connection_release_outgoing_batch(connection);
 
             message_destroy(message);
 
@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_uamqp_c/admission_limiter.h"
+
+/* tokens are kept in thousandths so that the refill of a few milliseconds is not rounded away */
+#define TOKEN_SCALE 1000
+
+typedef struct ADMISSION_LIMITER_INSTANCE_TAG
+{
+    TICK_COUNTER_HANDLE tick_counter;
+    uint64_t rate_per_second;
+    uint64_t max_scaled_tokens;
+    uint64_t scaled_tokens;
+    tickcounter_ms_t last_refill_ms;
+} ADMISSION_LIMITER_INSTANCE;
+
+static void refill(ADMISSION_LIMITER_INSTANCE* admission_limiter_instance)
+{
+    tickcounter_ms_t current_ms;
+
+    if (tickcounter_get_current_ms(admission_limiter_instance->tick_counter, &current_ms) != 0)
+    {
+        /* Codes_SRS_ADMISSION_LIMITER_01_010: [ If `tickcounter_get_current_ms` fails, `admission_limiter_try_acquire` shall use the tokens available without refilling them. ]*/
+        LogError("Cannot get the current time");
+    }
+    else if (current_ms > admission_limiter_instance->last_refill_ms)
+    {
+        uint64_t elapsed_ms = (uint64_t)(current_ms - admission_limiter_instance->last_refill_ms);
+
+        /* Codes_SRS_ADMISSION_LIMITER_01_009: [ Before taking a token, `admission_limiter_try_acquire` shall add `rate_per_second` tokens for each second elapsed since the last refill (proportionally for a fraction of a second), without exceeding `burst` tokens. ]*/
+        /* past the time it takes to fill an empty bucket the product could overflow, so the bucket is simply full */
+        if (elapsed_ms >= admission_limiter_instance->max_scaled_tokens / admission_limiter_instance->rate_per_second)
+        {
+            admission_limiter_instance->scaled_tokens = admission_limiter_instance->max_scaled_tokens;
+        }
+        else
+        {
+            admission_limiter_instance->scaled_tokens += elapsed_ms * admission_limiter_instance->rate_per_second;
+            if (admission_limiter_instance->scaled_tokens > admission_limiter_instance->max_scaled_tokens)
+            {
+                admission_limiter_instance->scaled_tokens = admission_limiter_instance->max_scaled_tokens;
+            }
+        }
+
+        admission_limiter_instance->last_refill_ms = current_ms;
+    }
+}
+
+ADMISSION_LIMITER_HANDLE admission_limiter_create(uint32_t rate_per_second, uint32_t burst)
+{
+    ADMISSION_LIMITER_INSTANCE* result;
+
+    if ((rate_per_second == 0) ||
+        (burst == 0))
+    {
+        /* Codes_SRS_ADMISSION_LIMITER_01_002: [ If `rate_per_second` or `burst` is 0, `admission_limiter_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: rate_per_second = %u, burst = %u",
+            (unsigned int)rate_per_second, (unsigned int)burst);
+        result = NULL;
+    }
+    else
+    {
+        result = (ADMISSION_LIMITER_INSTANCE*)malloc(sizeof(ADMISSION_LIMITER_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_ADMISSION_LIMITER_01_003: [ If allocating memory, `tickcounter_create` or `tickcounter_get_current_ms` fails, `admission_limiter_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the admission limiter");
+        }
+        else
+        {
+            /* Codes_SRS_ADMISSION_LIMITER_01_001: [ `admission_limiter_create` shall create a limiter holding `burst` tokens and a tick counter obtained by calling `tickcounter_create`, read the current time with `tickcounter_get_current_ms` and on success return a non-NULL handle to it. ]*/
+            result->tick_counter = tickcounter_create();
+            if (result->tick_counter == NULL)
+            {
+                /* Codes_SRS_ADMISSION_LIMITER_01_003: [ If allocating memory, `tickcounter_create` or `tickcounter_get_current_ms` fails, `admission_limiter_create` shall fail and return NULL. ]*/
+                LogError("Cannot create the tick counter");
+                free(result);
+                result = NULL;
+            }
+            else if (tickcounter_get_current_ms(result->tick_counter, &result->last_refill_ms) != 0)
+            {
+                /* Codes_SRS_ADMISSION_LIMITER_01_003: [ If allocating memory, `tickcounter_create` or `tickcounter_get_current_ms` fails, `admission_limiter_create` shall fail and return NULL. ]*/
+                LogError("Cannot get the current time");
+                tickcounter_destroy(result->tick_counter);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->rate_per_second = rate_per_second;
+                result->max_scaled_tokens = (uint64_t)burst * TOKEN_SCALE;
+                result->scaled_tokens = result->max_scaled_tokens;
+            }
+        }
+    }
+
+    return result;
+}
+
+void admission_limiter_destroy(ADMISSION_LIMITER_HANDLE admission_limiter)
+{
+    if (admission_limiter == NULL)
+    {
+        /* Codes_SRS_ADMISSION_LIMITER_01_005: [ If `admission_limiter` is NULL, `admission_limiter_destroy` shall do nothing. ]*/
+        LogError("NULL admission_limiter");
+    }
+    else
+    {
+        /* Codes_SRS_ADMISSION_LIMITER_01_004: [ `admission_limiter_destroy` shall destroy the tick counter and free all resources associated with `admission_limiter`. ]*/
+        tickcounter_destroy(admission_limiter->tick_counter);
+        free(admission_limiter);
+    }
+}
+
+bool admission_limiter_try_acquire(ADMISSION_LIMITER_HANDLE admission_limiter)
+{
+    bool result;
+
+    if (admission_limiter == NULL)
+    {
+        /* Codes_SRS_ADMISSION_LIMITER_01_006: [ If `admission_limiter` is NULL, `admission_limiter_try_acquire` shall return false. ]*/
+        LogError("NULL admission_limiter");
+        result = false;
+    }
+    else
+    {
+        refill(admission_limiter);
+
+        if (admission_limiter->scaled_tokens < TOKEN_SCALE)
+        {
+            /* Codes_SRS_ADMISSION_LIMITER_01_008: [ If less than one token is available, `admission_limiter_try_acquire` shall return false. ]*/
+            result = false;
+        }
+        else
+        {
+            /* Codes_SRS_ADMISSION_LIMITER_01_007: [ When at least one token is available, `admission_limiter_try_acquire` shall take one token and return true. ]*/
+            admission_limiter->scaled_tokens -= TOKEN_SCALE;
+            result = true;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,217 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/alloc_counters.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define ATOMIC_ADD_UINT64(target, value) (void)InterlockedExchangeAdd64((LONGLONG volatile*)(target), (LONGLONG)(value))
+#define ATOMIC_LOAD_UINT64(target) (uint64_t)InterlockedCompareExchange64((LONGLONG volatile*)(target), 0, 0)
+#define ATOMIC_STORE_UINT64(target, value) (void)InterlockedExchange64((LONGLONG volatile*)(target), (LONGLONG)(value))
+#else
+#define ATOMIC_ADD_UINT64(target, value) (void)__atomic_fetch_add((target), (uint64_t)(value), __ATOMIC_RELAXED)
+#define ATOMIC_LOAD_UINT64(target) __atomic_load_n((target), __ATOMIC_RELAXED)
+#define ATOMIC_STORE_UINT64(target, value) __atomic_store_n((target), (uint64_t)(value), __ATOMIC_RELAXED)
+#endif
+
+/* the allocations themselves go through gballoc.h, so memory_trace keeps working on top of the counters */
+static ALLOC_COUNTERS subsystem_counters[ALLOC_SUBSYSTEM_COUNT];
+/* a removal adds the two's complement of the size, so the counters stay unsigned */
+static ALLOC_OBJECT_USAGE object_usage[ALLOC_OBJECT_TYPE_COUNT];
+
+static void record_allocation(ALLOC_SUBSYSTEM subsystem, size_t size)
+{
+    if ((unsigned int)subsystem < ALLOC_SUBSYSTEM_COUNT)
+    {
+        ATOMIC_ADD_UINT64(&subsystem_counters[subsystem].allocation_count, 1);
+        ATOMIC_ADD_UINT64(&subsystem_counters[subsystem].allocated_bytes, size);
+    }
+}
+
+bool alloc_counters_are_enabled(void)
+{
+#ifdef UAMQP_ALLOC_COUNTERS
+    return true;
+#else
+    return false;
+#endif
+}
+
+int alloc_counters_get(ALLOC_SUBSYSTEM subsystem, ALLOC_COUNTERS* counters)
+{
+    int result;
+
+    if ((counters == NULL) ||
+        ((unsigned int)subsystem >= ALLOC_SUBSYSTEM_COUNT))
+    {
+        LogError("Bad arguments: counters = %p, subsystem = %d",
+            counters, (int)subsystem);
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef UAMQP_ALLOC_COUNTERS
+        counters->allocation_count = ATOMIC_LOAD_UINT64(&subsystem_counters[subsystem].allocation_count);
+        counters->allocated_bytes = ATOMIC_LOAD_UINT64(&subsystem_counters[subsystem].allocated_bytes);
+        counters->free_count = ATOMIC_LOAD_UINT64(&subsystem_counters[subsystem].free_count);
+        result = 0;
+#else
+        LogError("Allocation counters are not enabled in this build");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+int alloc_counters_get_total(ALLOC_COUNTERS* counters)
+{
+    int result;
+
+    if (counters == NULL)
+    {
+        LogError("NULL counters");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned int i;
+
+        counters->allocation_count = 0;
+        counters->allocated_bytes = 0;
+        counters->free_count = 0;
+        result = 0;
+
+        for (i = 0; i < ALLOC_SUBSYSTEM_COUNT; i++)
+        {
+            ALLOC_COUNTERS current_counters;
+
+            if (alloc_counters_get((ALLOC_SUBSYSTEM)i, &current_counters) != 0)
+            {
+                result = __FAILURE__;
+                break;
+            }
+
+            counters->allocation_count += current_counters.allocation_count;
+            counters->allocated_bytes += current_counters.allocated_bytes;
+            counters->free_count += current_counters.free_count;
+        }
+    }
+
+    return result;
+}
+
+void alloc_counters_reset(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < ALLOC_SUBSYSTEM_COUNT; i++)
+    {
+        ATOMIC_STORE_UINT64(&subsystem_counters[i].allocation_count, 0);
+        ATOMIC_STORE_UINT64(&subsystem_counters[i].allocated_bytes, 0);
+        ATOMIC_STORE_UINT64(&subsystem_counters[i].free_count, 0);
+    }
+}
+
+int alloc_counters_get_object_snapshot(ALLOC_OBJECT_SNAPSHOT* snapshot)
+{
+    int result;
+
+    if (snapshot == NULL)
+    {
+        LogError("NULL snapshot");
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef UAMQP_ALLOC_COUNTERS
+        unsigned int i;
+
+        for (i = 0; i < ALLOC_OBJECT_TYPE_COUNT; i++)
+        {
+            snapshot->usage[i].live_count = ATOMIC_LOAD_UINT64(&object_usage[i].live_count);
+            snapshot->usage[i].live_bytes = ATOMIC_LOAD_UINT64(&object_usage[i].live_bytes);
+        }
+
+        result = 0;
+#else
+        LogError("Allocation counters are not enabled in this build");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+void alloc_counters_add_object(ALLOC_OBJECT_TYPE object_type, size_t size)
+{
+    if ((unsigned int)object_type < ALLOC_OBJECT_TYPE_COUNT)
+    {
+        ATOMIC_ADD_UINT64(&object_usage[object_type].live_count, 1);
+        ATOMIC_ADD_UINT64(&object_usage[object_type].live_bytes, size);
+    }
+}
+
+void alloc_counters_remove_object(ALLOC_OBJECT_TYPE object_type, size_t size)
+{
+    if ((unsigned int)object_type < ALLOC_OBJECT_TYPE_COUNT)
+    {
+        ATOMIC_ADD_UINT64(&object_usage[object_type].live_count, (uint64_t)-1);
+        ATOMIC_ADD_UINT64(&object_usage[object_type].live_bytes, (uint64_t)0 - (uint64_t)size);
+    }
+}
+
+void alloc_counters_resize_object(ALLOC_OBJECT_TYPE object_type, size_t old_size, size_t new_size)
+{
+    if ((unsigned int)object_type < ALLOC_OBJECT_TYPE_COUNT)
+    {
+        /* a buffer growing from nothing becomes a live object, one shrinking to nothing stops being one */
+        if (old_size == 0)
+        {
+            if (new_size != 0)
+            {
+                ATOMIC_ADD_UINT64(&object_usage[object_type].live_count, 1);
+            }
+        }
+        else if (new_size == 0)
+        {
+            ATOMIC_ADD_UINT64(&object_usage[object_type].live_count, (uint64_t)-1);
+        }
+
+        ATOMIC_ADD_UINT64(&object_usage[object_type].live_bytes, (uint64_t)new_size - (uint64_t)old_size);
+    }
+}
+
+void* alloc_counters_malloc(ALLOC_SUBSYSTEM subsystem, size_t size)
+{
+    record_allocation(subsystem, size);
+    return malloc(size);
+}
+
+void* alloc_counters_calloc(ALLOC_SUBSYSTEM subsystem, size_t nmemb, size_t size)
+{
+    record_allocation(subsystem, nmemb * size);
+    return calloc(nmemb, size);
+}
+
+void* alloc_counters_realloc(ALLOC_SUBSYSTEM subsystem, void* ptr, size_t size)
+{
+    record_allocation(subsystem, size);
+    return realloc(ptr, size);
+}
+
+void alloc_counters_free(ALLOC_SUBSYSTEM subsystem, void* ptr)
+{
+    if ((ptr != NULL) &&
+        ((unsigned int)subsystem < ALLOC_SUBSYSTEM_COUNT))
+    {
+        ATOMIC_ADD_UINT64(&subsystem_counters[subsystem].free_count, 1);
+    }
+
+    free(ptr);
+}
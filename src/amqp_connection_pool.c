@@ -0,0 +1,500 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/tls_session_cache.h"
+#include "azure_uamqp_c/amqp_connection_pool.h"
+
+struct AMQP_CONNECTION_POOL_INSTANCE_TAG;
+
+typedef struct POOLED_CONNECTION_TAG
+{
+    struct AMQP_CONNECTION_POOL_INSTANCE_TAG* pool;
+    XIO_HANDLE xio;
+    CONNECTION_HANDLE connection;
+    size_t session_count;
+    size_t link_count;
+    /* set from the connection callbacks, the connection is only destroyed from amqp_connection_pool_dowork */
+    bool is_failed;
+} POOLED_CONNECTION;
+
+typedef struct POOLED_SESSION_TAG
+{
+    SESSION_HANDLE session;
+    POOLED_CONNECTION* pooled_connection;
+    size_t link_count;
+} POOLED_SESSION;
+
+typedef struct AMQP_CONNECTION_POOL_INSTANCE_TAG
+{
+    char* hostname;
+    char* container_id;
+    size_t max_connections;
+    size_t max_sessions_per_connection;
+    ON_AMQP_CONNECTION_POOL_CREATE_IO on_create_io;
+    void* on_create_io_context;
+    TLS_SESSION_CACHE_HANDLE tls_session_cache;
+    SINGLYLINKEDLIST_HANDLE connections;
+    SINGLYLINKEDLIST_HANDLE sessions;
+} AMQP_CONNECTION_POOL_INSTANCE;
+
+static void on_pooled_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
+{
+    POOLED_CONNECTION* pooled_connection = (POOLED_CONNECTION*)context;
+    (void)previous_connection_state;
+
+    if ((new_connection_state == CONNECTION_STATE_OPENED) &&
+        (pooled_connection->pool->tls_session_cache != NULL))
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_032: [ When a pooled connection reaches `CONNECTION_STATE_OPENED` and a `tls_session_cache` is configured, the options of its io shall be saved for the configured `hostname` by calling `tls_session_cache_save`. ]*/
+        if (tls_session_cache_save(pooled_connection->pool->tls_session_cache, pooled_connection->pool->hostname, pooled_connection->xio) != 0)
+        {
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_033: [ If `tls_session_cache_save` fails, the connection shall be used as is. ]*/
+            LogError("Cannot save the TLS session of the connection");
+        }
+    }
+
+    /* the pool never closes its connections, so reaching END means the peer closed it */
+    if ((new_connection_state == CONNECTION_STATE_ERROR) ||
+        (new_connection_state == CONNECTION_STATE_END))
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_029: [ When a pooled connection reaches `CONNECTION_STATE_ERROR` or `CONNECTION_STATE_END`, or its io reports an error, the connection shall be marked as failed and no more sessions shall be handed out on it. ]*/
+        pooled_connection->is_failed = true;
+    }
+}
+
+static void on_pooled_connection_io_error(void* context)
+{
+    POOLED_CONNECTION* pooled_connection = (POOLED_CONNECTION*)context;
+
+    /* Codes_SRS_AMQP_CONNECTION_POOL_01_029: [ When a pooled connection reaches `CONNECTION_STATE_ERROR` or `CONNECTION_STATE_END`, or its io reports an error, the connection shall be marked as failed and no more sessions shall be handed out on it. ]*/
+    pooled_connection->is_failed = true;
+}
+
+static void destroy_pooled_connection(POOLED_CONNECTION* pooled_connection)
+{
+    connection_destroy(pooled_connection->connection);
+    xio_destroy(pooled_connection->xio);
+    free(pooled_connection);
+}
+
+static POOLED_CONNECTION* create_pooled_connection(AMQP_CONNECTION_POOL_INSTANCE* pool)
+{
+    POOLED_CONNECTION* result = (POOLED_CONNECTION*)malloc(sizeof(POOLED_CONNECTION));
+    if (result == NULL)
+    {
+        LogError("Cannot allocate memory for the pooled connection");
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_016: [ The io of a new connection shall be obtained by calling `on_create_io` with `on_create_io_context`. ]*/
+        result->xio = pool->on_create_io(pool->on_create_io_context);
+        if (result->xio == NULL)
+        {
+            LogError("on_create_io failed");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->pool = pool;
+            result->session_count = 0;
+            result->link_count = 0;
+            result->is_failed = false;
+
+            if (pool->tls_session_cache != NULL)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_030: [ If a `tls_session_cache` is configured, the options saved for the configured `hostname` shall be set on the io of a new connection by calling `tls_session_cache_apply`, so that the TLS handshake can resume the session of an earlier connection. ]*/
+                if (tls_session_cache_apply(pool->tls_session_cache, pool->hostname, result->xio) != 0)
+                {
+                    /* Codes_SRS_AMQP_CONNECTION_POOL_01_031: [ If `tls_session_cache_apply` fails, the connection shall still be created and do a full TLS handshake. ]*/
+                    LogError("Cannot apply the cached TLS session, doing a full handshake");
+                }
+            }
+
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_017: [ The connection shall be created by calling `connection_create2` with the io, the configured `hostname` and `container_id`, and state changed and io error callbacks. ]*/
+            result->connection = connection_create2(result->xio, pool->hostname, pool->container_id, NULL, NULL, on_pooled_connection_state_changed, result, on_pooled_connection_io_error, result);
+            if (result->connection == NULL)
+            {
+                LogError("connection_create2 failed");
+                xio_destroy(result->xio);
+                free(result);
+                result = NULL;
+            }
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_018: [ The new connection shall be added to the pool by calling `singlylinkedlist_add`. ]*/
+            else if (singlylinkedlist_add(pool->connections, result) == NULL)
+            {
+                LogError("Cannot add the connection to the pool");
+                destroy_pooled_connection(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+static POOLED_CONNECTION* find_least_loaded_connection(AMQP_CONNECTION_POOL_INSTANCE* pool, size_t* healthy_connection_count)
+{
+    POOLED_CONNECTION* result = NULL;
+    LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(pool->connections);
+
+    *healthy_connection_count = 0;
+
+    while (list_item != NULL)
+    {
+        POOLED_CONNECTION* pooled_connection = (POOLED_CONNECTION*)singlylinkedlist_item_get_value(list_item);
+        if ((pooled_connection != NULL) &&
+            (!pooled_connection->is_failed))
+        {
+            (*healthy_connection_count)++;
+
+            if ((pooled_connection->session_count < pool->max_sessions_per_connection) &&
+                ((result == NULL) ||
+                 (pooled_connection->link_count < result->link_count) ||
+                 ((pooled_connection->link_count == result->link_count) && (pooled_connection->session_count < result->session_count))))
+            {
+                result = pooled_connection;
+            }
+        }
+
+        list_item = singlylinkedlist_get_next_item(list_item);
+    }
+
+    return result;
+}
+
+AMQP_CONNECTION_POOL_HANDLE amqp_connection_pool_create(const AMQP_CONNECTION_POOL_CONFIG* config, ON_AMQP_CONNECTION_POOL_CREATE_IO on_create_io, void* on_create_io_context)
+{
+    AMQP_CONNECTION_POOL_INSTANCE* result;
+
+    if ((config == NULL) ||
+        (config->hostname == NULL) ||
+        (config->container_id == NULL) ||
+        (config->max_connections == 0) ||
+        (config->max_sessions_per_connection == 0) ||
+        (on_create_io == NULL))
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_002: [ If `config` or `on_create_io` is NULL, if `hostname` or `container_id` in `config` is NULL, or if `max_connections` or `max_sessions_per_connection` is 0, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: config = %p, on_create_io = %p", config, on_create_io);
+        result = NULL;
+    }
+    else
+    {
+        result = (AMQP_CONNECTION_POOL_INSTANCE*)malloc(sizeof(AMQP_CONNECTION_POOL_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_004: [ If any error occurs, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the connection pool");
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_003: [ `amqp_connection_pool_create` shall copy `hostname` and `container_id` and create the lists of connections and sessions by calling `singlylinkedlist_create`. ]*/
+            if (mallocAndStrcpy_s(&result->hostname, config->hostname) != 0)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_004: [ If any error occurs, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+                LogError("Cannot copy hostname");
+                free(result);
+                result = NULL;
+            }
+            else if (mallocAndStrcpy_s(&result->container_id, config->container_id) != 0)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_004: [ If any error occurs, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+                LogError("Cannot copy container_id");
+                free(result->hostname);
+                free(result);
+                result = NULL;
+            }
+            else if ((result->connections = singlylinkedlist_create()) == NULL)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_004: [ If any error occurs, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+                LogError("Cannot create the connection list");
+                free(result->container_id);
+                free(result->hostname);
+                free(result);
+                result = NULL;
+            }
+            else if ((result->sessions = singlylinkedlist_create()) == NULL)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_004: [ If any error occurs, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+                LogError("Cannot create the session list");
+                singlylinkedlist_destroy(result->connections);
+                free(result->container_id);
+                free(result->hostname);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_001: [ `amqp_connection_pool_create` shall create a new connection pool and on success return a non-NULL handle to it. No connection shall be opened before a session is acquired. ]*/
+                result->max_connections = config->max_connections;
+                result->max_sessions_per_connection = config->max_sessions_per_connection;
+                result->on_create_io = on_create_io;
+                result->on_create_io_context = on_create_io_context;
+                result->tls_session_cache = config->tls_session_cache;
+            }
+        }
+    }
+
+    return result;
+}
+
+void amqp_connection_pool_destroy(AMQP_CONNECTION_POOL_HANDLE pool)
+{
+    if (pool == NULL)
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_006: [ If `pool` is NULL, `amqp_connection_pool_destroy` shall do nothing. ]*/
+        LogError("NULL pool");
+    }
+    else
+    {
+        LIST_ITEM_HANDLE list_item;
+
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_005: [ `amqp_connection_pool_destroy` shall destroy all the sessions still acquired by calling `session_destroy`, then all the connections by calling `connection_destroy` and `xio_destroy`, and free the pool. ]*/
+        while ((list_item = singlylinkedlist_get_head_item(pool->sessions)) != NULL)
+        {
+            POOLED_SESSION* pooled_session = (POOLED_SESSION*)singlylinkedlist_item_get_value(list_item);
+            if (pooled_session != NULL)
+            {
+                session_destroy(pooled_session->session);
+                free(pooled_session);
+            }
+
+            (void)singlylinkedlist_remove(pool->sessions, list_item);
+        }
+
+        while ((list_item = singlylinkedlist_get_head_item(pool->connections)) != NULL)
+        {
+            POOLED_CONNECTION* pooled_connection = (POOLED_CONNECTION*)singlylinkedlist_item_get_value(list_item);
+            if (pooled_connection != NULL)
+            {
+                destroy_pooled_connection(pooled_connection);
+            }
+
+            (void)singlylinkedlist_remove(pool->connections, list_item);
+        }
+
+        singlylinkedlist_destroy(pool->sessions);
+        singlylinkedlist_destroy(pool->connections);
+        free(pool->container_id);
+        free(pool->hostname);
+        free(pool);
+    }
+}
+
+SESSION_HANDLE amqp_connection_pool_acquire_session(AMQP_CONNECTION_POOL_HANDLE pool, size_t link_count, ON_LINK_ATTACHED on_link_attached, void* callback_context)
+{
+    SESSION_HANDLE result;
+
+    if (pool == NULL)
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_008: [ If `pool` is NULL, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+        LogError("NULL pool");
+        result = NULL;
+    }
+    else
+    {
+        size_t healthy_connection_count;
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_009: [ The session shall be created on the connection that is not failed, has less than `max_sessions_per_connection` sessions and has the fewest links, the fewest sessions breaking ties. ]*/
+        POOLED_CONNECTION* pooled_connection = find_least_loaded_connection(pool, &healthy_connection_count);
+
+        if (pooled_connection == NULL)
+        {
+            if (healthy_connection_count >= pool->max_connections)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_011: [ If no connection has room and the pool already has `max_connections` connections that are not failed, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+                LogError("All %u connections of the pool are full", (unsigned int)healthy_connection_count);
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_010: [ If no connection has room and the pool has less than `max_connections` connections that are not failed, a new connection shall be created. ]*/
+                pooled_connection = create_pooled_connection(pool);
+            }
+        }
+
+        if (pooled_connection == NULL)
+        {
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_013: [ If any error occurs, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+            result = NULL;
+        }
+        else
+        {
+            POOLED_SESSION* pooled_session = (POOLED_SESSION*)malloc(sizeof(POOLED_SESSION));
+            if (pooled_session == NULL)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_013: [ If any error occurs, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+                LogError("Cannot allocate memory for the pooled session");
+                result = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_012: [ The session shall be created by calling `session_create` with the connection, `on_link_attached` and `callback_context`. ]*/
+                pooled_session->session = session_create(pooled_connection->connection, on_link_attached, callback_context);
+                if (pooled_session->session == NULL)
+                {
+                    /* Codes_SRS_AMQP_CONNECTION_POOL_01_013: [ If any error occurs, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+                    LogError("session_create failed");
+                    free(pooled_session);
+                    result = NULL;
+                }
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_014: [ The session shall be added to the list of acquired sessions by calling `singlylinkedlist_add`. ]*/
+                else if (singlylinkedlist_add(pool->sessions, pooled_session) == NULL)
+                {
+                    /* Codes_SRS_AMQP_CONNECTION_POOL_01_013: [ If any error occurs, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+                    LogError("Cannot add the session to the pool");
+                    session_destroy(pooled_session->session);
+                    free(pooled_session);
+                    result = NULL;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQP_CONNECTION_POOL_01_015: [ `link_count` links shall be accounted to the connection until the session is released. ]*/
+                    pooled_session->pooled_connection = pooled_connection;
+                    pooled_session->link_count = link_count;
+                    pooled_connection->session_count++;
+                    pooled_connection->link_count += link_count;
+
+                    /* Codes_SRS_AMQP_CONNECTION_POOL_01_007: [ On success, `amqp_connection_pool_acquire_session` shall return the new session. ]*/
+                    result = pooled_session->session;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int amqp_connection_pool_release_session(AMQP_CONNECTION_POOL_HANDLE pool, SESSION_HANDLE session)
+{
+    int result;
+
+    if ((pool == NULL) ||
+        (session == NULL))
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_021: [ If `pool` or `session` is NULL, `amqp_connection_pool_release_session` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: pool = %p, session = %p", pool, session);
+        result = __FAILURE__;
+    }
+    else
+    {
+        POOLED_SESSION* pooled_session = NULL;
+        LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(pool->sessions);
+
+        while (list_item != NULL)
+        {
+            pooled_session = (POOLED_SESSION*)singlylinkedlist_item_get_value(list_item);
+            if ((pooled_session != NULL) &&
+                (pooled_session->session == session))
+            {
+                break;
+            }
+
+            list_item = singlylinkedlist_get_next_item(list_item);
+        }
+
+        if (list_item == NULL)
+        {
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_022: [ If `session` was not acquired from `pool`, `amqp_connection_pool_release_session` shall fail and return a non-zero value. ]*/
+            LogError("Session %p was not acquired from this pool", session);
+            result = __FAILURE__;
+        }
+        else if (singlylinkedlist_remove(pool->sessions, list_item) != 0)
+        {
+            LogError("Cannot remove the session from the pool");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_020: [ `amqp_connection_pool_release_session` shall destroy the session by calling `session_destroy` and take it and its links off the count of its connection. ]*/
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_023: [ The connection shall be kept when its last session is released. ]*/
+            session_destroy(pooled_session->session);
+            pooled_session->pooled_connection->session_count--;
+            pooled_session->pooled_connection->link_count -= pooled_session->link_count;
+            free(pooled_session);
+
+            /* Codes_SRS_AMQP_CONNECTION_POOL_01_019: [ On success, `amqp_connection_pool_release_session` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+void amqp_connection_pool_dowork(AMQP_CONNECTION_POOL_HANDLE pool)
+{
+    if (pool == NULL)
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_025: [ If `pool` is NULL, `amqp_connection_pool_dowork` shall do nothing. ]*/
+        LogError("NULL pool");
+    }
+    else
+    {
+        LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(pool->connections);
+
+        while (list_item != NULL)
+        {
+            POOLED_CONNECTION* pooled_connection = (POOLED_CONNECTION*)singlylinkedlist_item_get_value(list_item);
+            if (pooled_connection != NULL)
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_024: [ `amqp_connection_pool_dowork` shall call `connection_dowork` for each connection of the pool. ]*/
+                connection_dowork(pooled_connection->connection);
+            }
+
+            list_item = singlylinkedlist_get_next_item(list_item);
+        }
+
+        /* the callbacks of connection_dowork can acquire and release sessions, so failed connections are only
+           removed once all connections were worked */
+        list_item = singlylinkedlist_get_head_item(pool->connections);
+        while (list_item != NULL)
+        {
+            POOLED_CONNECTION* pooled_connection = (POOLED_CONNECTION*)singlylinkedlist_item_get_value(list_item);
+            LIST_ITEM_HANDLE next_list_item = singlylinkedlist_get_next_item(list_item);
+
+            if ((pooled_connection != NULL) &&
+                (pooled_connection->is_failed) &&
+                (pooled_connection->session_count == 0))
+            {
+                /* Codes_SRS_AMQP_CONNECTION_POOL_01_026: [ Failed connections that have no sessions left shall then be removed from the pool and destroyed by calling `connection_destroy` and `xio_destroy`. ]*/
+                if (singlylinkedlist_remove(pool->connections, list_item) != 0)
+                {
+                    LogError("Cannot remove the failed connection from the pool");
+                }
+                else
+                {
+                    destroy_pooled_connection(pooled_connection);
+                }
+            }
+
+            list_item = next_list_item;
+        }
+    }
+}
+
+size_t amqp_connection_pool_get_connection_count(AMQP_CONNECTION_POOL_HANDLE pool)
+{
+    size_t result;
+
+    if (pool == NULL)
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_028: [ If `pool` is NULL, `amqp_connection_pool_get_connection_count` shall return 0. ]*/
+        LogError("NULL pool");
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_CONNECTION_POOL_01_027: [ `amqp_connection_pool_get_connection_count` shall return the number of connections of the pool that are not failed. ]*/
+        (void)find_least_loaded_connection(pool, &result);
+    }
+
+    return result;
+}
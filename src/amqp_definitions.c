@@ -14,6 +14,9 @@
 #include <stdlib.h>
 #include <stdbool.h>
 
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_AMQPVALUE
+#include "azure_uamqp_c/alloc_counters.h"
+
 /* role */
 
 AMQP_VALUE amqpvalue_create_role(role value)
@@ -420,16 +423,17 @@ int error_set_condition(ERROR_HANDLE error, const char* condition_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(error_instance->composite_value, 0, condition_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&error_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(error_instance->composite_value, 0, condition_amqp_value) != 0))
             {
+                amqpvalue_destroy(condition_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns condition_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(condition_amqp_value);
         }
     }
 
@@ -503,16 +507,17 @@ int error_set_description(ERROR_HANDLE error, const char* description_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(error_instance->composite_value, 1, description_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&error_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(error_instance->composite_value, 1, description_amqp_value) != 0))
             {
+                amqpvalue_destroy(description_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns description_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(description_amqp_value);
         }
     }
 
@@ -586,16 +591,17 @@ int error_set_info(ERROR_HANDLE error, fields info_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(error_instance->composite_value, 2, info_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&error_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(error_instance->composite_value, 2, info_amqp_value) != 0))
             {
+                amqpvalue_destroy(info_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns info_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(info_amqp_value);
         }
     }
 
@@ -1157,16 +1163,17 @@ int open_set_container_id(OPEN_HANDLE open, const char* container_id_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 0, container_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 0, container_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(container_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns container_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(container_id_amqp_value);
         }
     }
 
@@ -1240,16 +1247,17 @@ int open_set_hostname(OPEN_HANDLE open, const char* hostname_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 1, hostname_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 1, hostname_amqp_value) != 0))
             {
+                amqpvalue_destroy(hostname_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns hostname_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(hostname_amqp_value);
         }
     }
 
@@ -1333,16 +1341,17 @@ int open_set_max_frame_size(OPEN_HANDLE open, uint32_t max_frame_size_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 2, max_frame_size_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 2, max_frame_size_amqp_value) != 0))
             {
+                amqpvalue_destroy(max_frame_size_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns max_frame_size_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(max_frame_size_amqp_value);
         }
     }
 
@@ -1426,16 +1435,17 @@ int open_set_channel_max(OPEN_HANDLE open, uint16_t channel_max_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 3, channel_max_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 3, channel_max_amqp_value) != 0))
             {
+                amqpvalue_destroy(channel_max_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns channel_max_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(channel_max_amqp_value);
         }
     }
 
@@ -1509,16 +1519,17 @@ int open_set_idle_time_out(OPEN_HANDLE open, milliseconds idle_time_out_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 4, idle_time_out_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 4, idle_time_out_amqp_value) != 0))
             {
+                amqpvalue_destroy(idle_time_out_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns idle_time_out_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(idle_time_out_amqp_value);
         }
     }
 
@@ -1656,16 +1667,17 @@ int open_set_outgoing_locales(OPEN_HANDLE open, AMQP_VALUE outgoing_locales_valu
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 5, outgoing_locales_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 5, outgoing_locales_amqp_value) != 0))
             {
+                amqpvalue_destroy(outgoing_locales_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns outgoing_locales_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(outgoing_locales_amqp_value);
         }
     }
 
@@ -1803,16 +1815,17 @@ int open_set_incoming_locales(OPEN_HANDLE open, AMQP_VALUE incoming_locales_valu
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 6, incoming_locales_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 6, incoming_locales_amqp_value) != 0))
             {
+                amqpvalue_destroy(incoming_locales_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns incoming_locales_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(incoming_locales_amqp_value);
         }
     }
 
@@ -1950,16 +1963,17 @@ int open_set_offered_capabilities(OPEN_HANDLE open, AMQP_VALUE offered_capabilit
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 7, offered_capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 7, offered_capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(offered_capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns offered_capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(offered_capabilities_amqp_value);
         }
     }
 
@@ -2097,16 +2111,17 @@ int open_set_desired_capabilities(OPEN_HANDLE open, AMQP_VALUE desired_capabilit
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 8, desired_capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 8, desired_capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(desired_capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns desired_capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(desired_capabilities_amqp_value);
         }
     }
 
@@ -2180,16 +2195,17 @@ int open_set_properties(OPEN_HANDLE open, fields properties_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(open_instance->composite_value, 9, properties_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&open_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(open_instance->composite_value, 9, properties_amqp_value) != 0))
             {
+                amqpvalue_destroy(properties_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns properties_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(properties_amqp_value);
         }
     }
 
@@ -2697,16 +2713,17 @@ int begin_set_remote_channel(BEGIN_HANDLE begin, uint16_t remote_channel_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 0, remote_channel_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 0, remote_channel_amqp_value) != 0))
             {
+                amqpvalue_destroy(remote_channel_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns remote_channel_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(remote_channel_amqp_value);
         }
     }
 
@@ -2780,16 +2797,17 @@ int begin_set_next_outgoing_id(BEGIN_HANDLE begin, transfer_number next_outgoing
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 1, next_outgoing_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 1, next_outgoing_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(next_outgoing_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns next_outgoing_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(next_outgoing_id_amqp_value);
         }
     }
 
@@ -2863,16 +2881,17 @@ int begin_set_incoming_window(BEGIN_HANDLE begin, uint32_t incoming_window_value
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 2, incoming_window_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 2, incoming_window_amqp_value) != 0))
             {
+                amqpvalue_destroy(incoming_window_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns incoming_window_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(incoming_window_amqp_value);
         }
     }
 
@@ -2946,16 +2965,17 @@ int begin_set_outgoing_window(BEGIN_HANDLE begin, uint32_t outgoing_window_value
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 3, outgoing_window_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 3, outgoing_window_amqp_value) != 0))
             {
+                amqpvalue_destroy(outgoing_window_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns outgoing_window_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(outgoing_window_amqp_value);
         }
     }
 
@@ -3039,16 +3059,17 @@ int begin_set_handle_max(BEGIN_HANDLE begin, handle handle_max_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 4, handle_max_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 4, handle_max_amqp_value) != 0))
             {
+                amqpvalue_destroy(handle_max_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns handle_max_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(handle_max_amqp_value);
         }
     }
 
@@ -3186,16 +3207,17 @@ int begin_set_offered_capabilities(BEGIN_HANDLE begin, AMQP_VALUE offered_capabi
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 5, offered_capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 5, offered_capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(offered_capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns offered_capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(offered_capabilities_amqp_value);
         }
     }
 
@@ -3333,16 +3355,17 @@ int begin_set_desired_capabilities(BEGIN_HANDLE begin, AMQP_VALUE desired_capabi
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 6, desired_capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 6, desired_capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(desired_capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns desired_capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(desired_capabilities_amqp_value);
         }
     }
 
@@ -3416,16 +3439,17 @@ int begin_set_properties(BEGIN_HANDLE begin, fields properties_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(begin_instance->composite_value, 7, properties_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&begin_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(begin_instance->composite_value, 7, properties_amqp_value) != 0))
             {
+                amqpvalue_destroy(properties_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns properties_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(properties_amqp_value);
         }
     }
 
@@ -4075,16 +4099,17 @@ int attach_set_name(ATTACH_HANDLE attach, const char* name_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 0, name_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 0, name_amqp_value) != 0))
             {
+                amqpvalue_destroy(name_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns name_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(name_amqp_value);
         }
     }
 
@@ -4158,16 +4183,17 @@ int attach_set_handle(ATTACH_HANDLE attach, handle handle_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 1, handle_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 1, handle_amqp_value) != 0))
             {
+                amqpvalue_destroy(handle_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns handle_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(handle_amqp_value);
         }
     }
 
@@ -4241,16 +4267,17 @@ int attach_set_role(ATTACH_HANDLE attach, role role_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 2, role_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 2, role_amqp_value) != 0))
             {
+                amqpvalue_destroy(role_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns role_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(role_amqp_value);
         }
     }
 
@@ -4334,16 +4361,17 @@ int attach_set_snd_settle_mode(ATTACH_HANDLE attach, sender_settle_mode snd_sett
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 3, snd_settle_mode_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 3, snd_settle_mode_amqp_value) != 0))
             {
+                amqpvalue_destroy(snd_settle_mode_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns snd_settle_mode_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(snd_settle_mode_amqp_value);
         }
     }
 
@@ -4427,16 +4455,17 @@ int attach_set_rcv_settle_mode(ATTACH_HANDLE attach, receiver_settle_mode rcv_se
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 4, rcv_settle_mode_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 4, rcv_settle_mode_amqp_value) != 0))
             {
+                amqpvalue_destroy(rcv_settle_mode_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns rcv_settle_mode_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(rcv_settle_mode_amqp_value);
         }
     }
 
@@ -4511,16 +4540,17 @@ int attach_set_source(ATTACH_HANDLE attach, AMQP_VALUE source_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 5, source_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 5, source_amqp_value) != 0))
             {
+                amqpvalue_destroy(source_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns source_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(source_amqp_value);
         }
     }
 
@@ -4595,16 +4625,17 @@ int attach_set_target(ATTACH_HANDLE attach, AMQP_VALUE target_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 6, target_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 6, target_amqp_value) != 0))
             {
+                amqpvalue_destroy(target_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns target_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(target_amqp_value);
         }
     }
 
@@ -4686,16 +4717,17 @@ int attach_set_unsettled(ATTACH_HANDLE attach, AMQP_VALUE unsettled_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 7, unsettled_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 7, unsettled_amqp_value) != 0))
             {
+                amqpvalue_destroy(unsettled_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns unsettled_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(unsettled_amqp_value);
         }
     }
 
@@ -4779,16 +4811,17 @@ int attach_set_incomplete_unsettled(ATTACH_HANDLE attach, bool incomplete_unsett
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 8, incomplete_unsettled_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 8, incomplete_unsettled_amqp_value) != 0))
             {
+                amqpvalue_destroy(incomplete_unsettled_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns incomplete_unsettled_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(incomplete_unsettled_amqp_value);
         }
     }
 
@@ -4862,16 +4895,17 @@ int attach_set_initial_delivery_count(ATTACH_HANDLE attach, sequence_no initial_
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 9, initial_delivery_count_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 9, initial_delivery_count_amqp_value) != 0))
             {
+                amqpvalue_destroy(initial_delivery_count_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns initial_delivery_count_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(initial_delivery_count_amqp_value);
         }
     }
 
@@ -4945,16 +4979,17 @@ int attach_set_max_message_size(ATTACH_HANDLE attach, uint64_t max_message_size_
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 10, max_message_size_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 10, max_message_size_amqp_value) != 0))
             {
+                amqpvalue_destroy(max_message_size_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns max_message_size_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(max_message_size_amqp_value);
         }
     }
 
@@ -5092,16 +5127,17 @@ int attach_set_offered_capabilities(ATTACH_HANDLE attach, AMQP_VALUE offered_cap
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 11, offered_capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 11, offered_capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(offered_capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns offered_capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(offered_capabilities_amqp_value);
         }
     }
 
@@ -5239,16 +5275,17 @@ int attach_set_desired_capabilities(ATTACH_HANDLE attach, AMQP_VALUE desired_cap
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 12, desired_capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 12, desired_capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(desired_capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns desired_capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(desired_capabilities_amqp_value);
         }
     }
 
@@ -5322,16 +5359,17 @@ int attach_set_properties(ATTACH_HANDLE attach, fields properties_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(attach_instance->composite_value, 13, properties_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&attach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(attach_instance->composite_value, 13, properties_amqp_value) != 0))
             {
+                amqpvalue_destroy(properties_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns properties_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(properties_amqp_value);
         }
     }
 
@@ -5922,16 +5960,17 @@ int flow_set_next_incoming_id(FLOW_HANDLE flow, transfer_number next_incoming_id
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 0, next_incoming_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 0, next_incoming_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(next_incoming_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns next_incoming_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(next_incoming_id_amqp_value);
         }
     }
 
@@ -6005,16 +6044,17 @@ int flow_set_incoming_window(FLOW_HANDLE flow, uint32_t incoming_window_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 1, incoming_window_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 1, incoming_window_amqp_value) != 0))
             {
+                amqpvalue_destroy(incoming_window_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns incoming_window_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(incoming_window_amqp_value);
         }
     }
 
@@ -6088,16 +6128,17 @@ int flow_set_next_outgoing_id(FLOW_HANDLE flow, transfer_number next_outgoing_id
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 2, next_outgoing_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 2, next_outgoing_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(next_outgoing_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns next_outgoing_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(next_outgoing_id_amqp_value);
         }
     }
 
@@ -6171,16 +6212,17 @@ int flow_set_outgoing_window(FLOW_HANDLE flow, uint32_t outgoing_window_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 3, outgoing_window_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 3, outgoing_window_amqp_value) != 0))
             {
+                amqpvalue_destroy(outgoing_window_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns outgoing_window_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(outgoing_window_amqp_value);
         }
     }
 
@@ -6254,16 +6296,17 @@ int flow_set_handle(FLOW_HANDLE flow, handle handle_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 4, handle_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 4, handle_amqp_value) != 0))
             {
+                amqpvalue_destroy(handle_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns handle_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(handle_amqp_value);
         }
     }
 
@@ -6337,16 +6380,17 @@ int flow_set_delivery_count(FLOW_HANDLE flow, sequence_no delivery_count_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 5, delivery_count_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 5, delivery_count_amqp_value) != 0))
             {
+                amqpvalue_destroy(delivery_count_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns delivery_count_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(delivery_count_amqp_value);
         }
     }
 
@@ -6420,16 +6464,17 @@ int flow_set_link_credit(FLOW_HANDLE flow, uint32_t link_credit_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 6, link_credit_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 6, link_credit_amqp_value) != 0))
             {
+                amqpvalue_destroy(link_credit_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns link_credit_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(link_credit_amqp_value);
         }
     }
 
@@ -6503,16 +6548,17 @@ int flow_set_available(FLOW_HANDLE flow, uint32_t available_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 7, available_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 7, available_amqp_value) != 0))
             {
+                amqpvalue_destroy(available_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns available_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(available_amqp_value);
         }
     }
 
@@ -6596,16 +6642,17 @@ int flow_set_drain(FLOW_HANDLE flow, bool drain_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 8, drain_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 8, drain_amqp_value) != 0))
             {
+                amqpvalue_destroy(drain_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns drain_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(drain_amqp_value);
         }
     }
 
@@ -6689,16 +6736,17 @@ int flow_set_echo(FLOW_HANDLE flow, bool echo_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 9, echo_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 9, echo_amqp_value) != 0))
             {
+                amqpvalue_destroy(echo_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns echo_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(echo_amqp_value);
         }
     }
 
@@ -6772,16 +6820,17 @@ int flow_set_properties(FLOW_HANDLE flow, fields properties_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(flow_instance->composite_value, 10, properties_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&flow_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(flow_instance->composite_value, 10, properties_amqp_value) != 0))
             {
+                amqpvalue_destroy(properties_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns properties_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(properties_amqp_value);
         }
     }
 
@@ -7320,16 +7369,17 @@ int transfer_set_handle(TRANSFER_HANDLE transfer, handle handle_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 0, handle_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 0, handle_amqp_value) != 0))
             {
+                amqpvalue_destroy(handle_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns handle_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(handle_amqp_value);
         }
     }
 
@@ -7403,16 +7453,17 @@ int transfer_set_delivery_id(TRANSFER_HANDLE transfer, delivery_number delivery_
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 1, delivery_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 1, delivery_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(delivery_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns delivery_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(delivery_id_amqp_value);
         }
     }
 
@@ -7486,16 +7537,17 @@ int transfer_set_delivery_tag(TRANSFER_HANDLE transfer, delivery_tag delivery_ta
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 2, delivery_tag_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 2, delivery_tag_amqp_value) != 0))
             {
+                amqpvalue_destroy(delivery_tag_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns delivery_tag_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(delivery_tag_amqp_value);
         }
     }
 
@@ -7569,16 +7621,17 @@ int transfer_set_message_format(TRANSFER_HANDLE transfer, message_format message
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 3, message_format_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 3, message_format_amqp_value) != 0))
             {
+                amqpvalue_destroy(message_format_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns message_format_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(message_format_amqp_value);
         }
     }
 
@@ -7652,16 +7705,17 @@ int transfer_set_settled(TRANSFER_HANDLE transfer, bool settled_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 4, settled_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 4, settled_amqp_value) != 0))
             {
+                amqpvalue_destroy(settled_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns settled_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(settled_amqp_value);
         }
     }
 
@@ -7745,16 +7799,17 @@ int transfer_set_more(TRANSFER_HANDLE transfer, bool more_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 5, more_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 5, more_amqp_value) != 0))
             {
+                amqpvalue_destroy(more_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns more_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(more_amqp_value);
         }
     }
 
@@ -7828,16 +7883,17 @@ int transfer_set_rcv_settle_mode(TRANSFER_HANDLE transfer, receiver_settle_mode
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 6, rcv_settle_mode_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 6, rcv_settle_mode_amqp_value) != 0))
             {
+                amqpvalue_destroy(rcv_settle_mode_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns rcv_settle_mode_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(rcv_settle_mode_amqp_value);
         }
     }
 
@@ -7912,16 +7968,17 @@ int transfer_set_state(TRANSFER_HANDLE transfer, AMQP_VALUE state_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 7, state_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 7, state_amqp_value) != 0))
             {
+                amqpvalue_destroy(state_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns state_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(state_amqp_value);
         }
     }
 
@@ -8005,16 +8062,17 @@ int transfer_set_resume(TRANSFER_HANDLE transfer, bool resume_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 8, resume_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 8, resume_amqp_value) != 0))
             {
+                amqpvalue_destroy(resume_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns resume_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(resume_amqp_value);
         }
     }
 
@@ -8098,16 +8156,17 @@ int transfer_set_aborted(TRANSFER_HANDLE transfer, bool aborted_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 9, aborted_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 9, aborted_amqp_value) != 0))
             {
+                amqpvalue_destroy(aborted_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns aborted_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(aborted_amqp_value);
         }
     }
 
@@ -8191,16 +8250,17 @@ int transfer_set_batchable(TRANSFER_HANDLE transfer, bool batchable_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(transfer_instance->composite_value, 10, batchable_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&transfer_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(transfer_instance->composite_value, 10, batchable_amqp_value) != 0))
             {
+                amqpvalue_destroy(batchable_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns batchable_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(batchable_amqp_value);
         }
     }
 
@@ -8612,16 +8672,17 @@ int disposition_set_role(DISPOSITION_HANDLE disposition, role role_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(disposition_instance->composite_value, 0, role_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&disposition_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(disposition_instance->composite_value, 0, role_amqp_value) != 0))
             {
+                amqpvalue_destroy(role_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns role_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(role_amqp_value);
         }
     }
 
@@ -8695,16 +8756,17 @@ int disposition_set_first(DISPOSITION_HANDLE disposition, delivery_number first_
         }
         else
         {
-            if (amqpvalue_set_composite_item(disposition_instance->composite_value, 1, first_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&disposition_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(disposition_instance->composite_value, 1, first_amqp_value) != 0))
             {
+                amqpvalue_destroy(first_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns first_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(first_amqp_value);
         }
     }
 
@@ -8778,16 +8840,17 @@ int disposition_set_last(DISPOSITION_HANDLE disposition, delivery_number last_va
         }
         else
         {
-            if (amqpvalue_set_composite_item(disposition_instance->composite_value, 2, last_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&disposition_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(disposition_instance->composite_value, 2, last_amqp_value) != 0))
             {
+                amqpvalue_destroy(last_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns last_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(last_amqp_value);
         }
     }
 
@@ -8871,16 +8934,17 @@ int disposition_set_settled(DISPOSITION_HANDLE disposition, bool settled_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(disposition_instance->composite_value, 3, settled_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&disposition_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(disposition_instance->composite_value, 3, settled_amqp_value) != 0))
             {
+                amqpvalue_destroy(settled_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns settled_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(settled_amqp_value);
         }
     }
 
@@ -8955,16 +9019,17 @@ int disposition_set_state(DISPOSITION_HANDLE disposition, AMQP_VALUE state_value
         }
         else
         {
-            if (amqpvalue_set_composite_item(disposition_instance->composite_value, 4, state_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&disposition_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(disposition_instance->composite_value, 4, state_amqp_value) != 0))
             {
+                amqpvalue_destroy(state_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns state_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(state_amqp_value);
         }
     }
 
@@ -9048,16 +9113,17 @@ int disposition_set_batchable(DISPOSITION_HANDLE disposition, bool batchable_val
         }
         else
         {
-            if (amqpvalue_set_composite_item(disposition_instance->composite_value, 5, batchable_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&disposition_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(disposition_instance->composite_value, 5, batchable_amqp_value) != 0))
             {
+                amqpvalue_destroy(batchable_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns batchable_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(batchable_amqp_value);
         }
     }
 
@@ -9384,16 +9450,17 @@ int detach_set_handle(DETACH_HANDLE detach, handle handle_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(detach_instance->composite_value, 0, handle_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&detach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(detach_instance->composite_value, 0, handle_amqp_value) != 0))
             {
+                amqpvalue_destroy(handle_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns handle_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(handle_amqp_value);
         }
     }
 
@@ -9477,16 +9544,17 @@ int detach_set_closed(DETACH_HANDLE detach, bool closed_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(detach_instance->composite_value, 1, closed_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&detach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(detach_instance->composite_value, 1, closed_amqp_value) != 0))
             {
+                amqpvalue_destroy(closed_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns closed_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(closed_amqp_value);
         }
     }
 
@@ -9560,16 +9628,17 @@ int detach_set_error(DETACH_HANDLE detach, ERROR_HANDLE error_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(detach_instance->composite_value, 2, error_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&detach_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(detach_instance->composite_value, 2, error_amqp_value) != 0))
             {
+                amqpvalue_destroy(error_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns error_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(error_amqp_value);
         }
     }
 
@@ -9814,16 +9883,17 @@ int end_set_error(END_HANDLE end, ERROR_HANDLE error_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(end_instance->composite_value, 0, error_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&end_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(end_instance->composite_value, 0, error_amqp_value) != 0))
             {
+                amqpvalue_destroy(error_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns error_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(error_amqp_value);
         }
     }
 
@@ -10068,16 +10138,17 @@ int close_set_error(CLOSE_HANDLE close, ERROR_HANDLE error_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(close_instance->composite_value, 0, error_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&close_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(close_instance->composite_value, 0, error_amqp_value) != 0))
             {
+                amqpvalue_destroy(error_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns error_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(error_amqp_value);
         }
     }
 
@@ -10415,16 +10486,17 @@ int sasl_mechanisms_set_sasl_server_mechanisms(SASL_MECHANISMS_HANDLE sasl_mecha
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_mechanisms_instance->composite_value, 0, sasl_server_mechanisms_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_mechanisms_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_mechanisms_instance->composite_value, 0, sasl_server_mechanisms_amqp_value) != 0))
             {
+                amqpvalue_destroy(sasl_server_mechanisms_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns sasl_server_mechanisms_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(sasl_server_mechanisms_amqp_value);
         }
     }
 
@@ -10747,16 +10819,17 @@ int sasl_init_set_mechanism(SASL_INIT_HANDLE sasl_init, const char* mechanism_va
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_init_instance->composite_value, 0, mechanism_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_init_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_init_instance->composite_value, 0, mechanism_amqp_value) != 0))
             {
+                amqpvalue_destroy(mechanism_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns mechanism_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(mechanism_amqp_value);
         }
     }
 
@@ -10830,16 +10903,17 @@ int sasl_init_set_initial_response(SASL_INIT_HANDLE sasl_init, amqp_binary initi
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_init_instance->composite_value, 1, initial_response_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_init_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_init_instance->composite_value, 1, initial_response_amqp_value) != 0))
             {
+                amqpvalue_destroy(initial_response_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns initial_response_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(initial_response_amqp_value);
         }
     }
 
@@ -10913,16 +10987,17 @@ int sasl_init_set_hostname(SASL_INIT_HANDLE sasl_init, const char* hostname_valu
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_init_instance->composite_value, 2, hostname_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_init_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_init_instance->composite_value, 2, hostname_amqp_value) != 0))
             {
+                amqpvalue_destroy(hostname_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns hostname_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(hostname_amqp_value);
         }
     }
 
@@ -11187,16 +11262,17 @@ int sasl_challenge_set_challenge(SASL_CHALLENGE_HANDLE sasl_challenge, amqp_bina
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_challenge_instance->composite_value, 0, challenge_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_challenge_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_challenge_instance->composite_value, 0, challenge_amqp_value) != 0))
             {
+                amqpvalue_destroy(challenge_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns challenge_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(challenge_amqp_value);
         }
     }
 
@@ -11461,16 +11537,17 @@ int sasl_response_set_response(SASL_RESPONSE_HANDLE sasl_response, amqp_binary r
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_response_instance->composite_value, 0, response_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_response_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_response_instance->composite_value, 0, response_amqp_value) != 0))
             {
+                amqpvalue_destroy(response_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns response_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(response_amqp_value);
         }
     }
 
@@ -11764,16 +11841,17 @@ int sasl_outcome_set_code(SASL_OUTCOME_HANDLE sasl_outcome, sasl_code code_value
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_outcome_instance->composite_value, 0, code_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_outcome_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_outcome_instance->composite_value, 0, code_amqp_value) != 0))
             {
+                amqpvalue_destroy(code_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns code_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(code_amqp_value);
         }
     }
 
@@ -11847,16 +11925,17 @@ int sasl_outcome_set_additional_data(SASL_OUTCOME_HANDLE sasl_outcome, amqp_bina
         }
         else
         {
-            if (amqpvalue_set_composite_item(sasl_outcome_instance->composite_value, 1, additional_data_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&sasl_outcome_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(sasl_outcome_instance->composite_value, 1, additional_data_amqp_value) != 0))
             {
+                amqpvalue_destroy(additional_data_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns additional_data_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(additional_data_amqp_value);
         }
     }
 
@@ -12388,16 +12467,17 @@ int source_set_address(SOURCE_HANDLE source, AMQP_VALUE address_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 0, address_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 0, address_amqp_value) != 0))
             {
+                amqpvalue_destroy(address_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns address_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(address_amqp_value);
         }
     }
 
@@ -12481,16 +12561,17 @@ int source_set_durable(SOURCE_HANDLE source, terminus_durability durable_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 1, durable_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 1, durable_amqp_value) != 0))
             {
+                amqpvalue_destroy(durable_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns durable_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(durable_amqp_value);
         }
     }
 
@@ -12574,16 +12655,17 @@ int source_set_expiry_policy(SOURCE_HANDLE source, terminus_expiry_policy expiry
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 2, expiry_policy_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 2, expiry_policy_amqp_value) != 0))
             {
+                amqpvalue_destroy(expiry_policy_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns expiry_policy_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(expiry_policy_amqp_value);
         }
     }
 
@@ -12667,16 +12749,17 @@ int source_set_timeout(SOURCE_HANDLE source, seconds timeout_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 3, timeout_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 3, timeout_amqp_value) != 0))
             {
+                amqpvalue_destroy(timeout_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns timeout_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(timeout_amqp_value);
         }
     }
 
@@ -12760,16 +12843,17 @@ int source_set_dynamic(SOURCE_HANDLE source, bool dynamic_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 4, dynamic_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 4, dynamic_amqp_value) != 0))
             {
+                amqpvalue_destroy(dynamic_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns dynamic_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(dynamic_amqp_value);
         }
     }
 
@@ -12843,16 +12927,17 @@ int source_set_dynamic_node_properties(SOURCE_HANDLE source, node_properties dyn
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 5, dynamic_node_properties_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 5, dynamic_node_properties_amqp_value) != 0))
             {
+                amqpvalue_destroy(dynamic_node_properties_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns dynamic_node_properties_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(dynamic_node_properties_amqp_value);
         }
     }
 
@@ -12926,16 +13011,17 @@ int source_set_distribution_mode(SOURCE_HANDLE source, const char* distribution_
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 6, distribution_mode_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 6, distribution_mode_amqp_value) != 0))
             {
+                amqpvalue_destroy(distribution_mode_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns distribution_mode_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(distribution_mode_amqp_value);
         }
     }
 
@@ -13009,16 +13095,17 @@ int source_set_filter(SOURCE_HANDLE source, filter_set filter_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 7, filter_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 7, filter_amqp_value) != 0))
             {
+                amqpvalue_destroy(filter_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns filter_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(filter_amqp_value);
         }
     }
 
@@ -13093,16 +13180,17 @@ int source_set_default_outcome(SOURCE_HANDLE source, AMQP_VALUE default_outcome_
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 8, default_outcome_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 8, default_outcome_amqp_value) != 0))
             {
+                amqpvalue_destroy(default_outcome_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns default_outcome_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(default_outcome_amqp_value);
         }
     }
 
@@ -13240,16 +13328,17 @@ int source_set_outcomes(SOURCE_HANDLE source, AMQP_VALUE outcomes_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 9, outcomes_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 9, outcomes_amqp_value) != 0))
             {
+                amqpvalue_destroy(outcomes_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns outcomes_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(outcomes_amqp_value);
         }
     }
 
@@ -13387,16 +13476,17 @@ int source_set_capabilities(SOURCE_HANDLE source, AMQP_VALUE capabilities_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(source_instance->composite_value, 10, capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&source_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(source_instance->composite_value, 10, capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(capabilities_amqp_value);
         }
     }
 
@@ -13798,16 +13888,17 @@ int target_set_address(TARGET_HANDLE target, AMQP_VALUE address_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(target_instance->composite_value, 0, address_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&target_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(target_instance->composite_value, 0, address_amqp_value) != 0))
             {
+                amqpvalue_destroy(address_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns address_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(address_amqp_value);
         }
     }
 
@@ -13891,16 +13982,17 @@ int target_set_durable(TARGET_HANDLE target, terminus_durability durable_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(target_instance->composite_value, 1, durable_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&target_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(target_instance->composite_value, 1, durable_amqp_value) != 0))
             {
+                amqpvalue_destroy(durable_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns durable_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(durable_amqp_value);
         }
     }
 
@@ -13984,16 +14076,17 @@ int target_set_expiry_policy(TARGET_HANDLE target, terminus_expiry_policy expiry
         }
         else
         {
-            if (amqpvalue_set_composite_item(target_instance->composite_value, 2, expiry_policy_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&target_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(target_instance->composite_value, 2, expiry_policy_amqp_value) != 0))
             {
+                amqpvalue_destroy(expiry_policy_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns expiry_policy_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(expiry_policy_amqp_value);
         }
     }
 
@@ -14077,16 +14170,17 @@ int target_set_timeout(TARGET_HANDLE target, seconds timeout_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(target_instance->composite_value, 3, timeout_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&target_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(target_instance->composite_value, 3, timeout_amqp_value) != 0))
             {
+                amqpvalue_destroy(timeout_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns timeout_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(timeout_amqp_value);
         }
     }
 
@@ -14170,16 +14264,17 @@ int target_set_dynamic(TARGET_HANDLE target, bool dynamic_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(target_instance->composite_value, 4, dynamic_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&target_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(target_instance->composite_value, 4, dynamic_amqp_value) != 0))
             {
+                amqpvalue_destroy(dynamic_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns dynamic_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(dynamic_amqp_value);
         }
     }
 
@@ -14253,16 +14348,17 @@ int target_set_dynamic_node_properties(TARGET_HANDLE target, node_properties dyn
         }
         else
         {
-            if (amqpvalue_set_composite_item(target_instance->composite_value, 5, dynamic_node_properties_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&target_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(target_instance->composite_value, 5, dynamic_node_properties_amqp_value) != 0))
             {
+                amqpvalue_destroy(dynamic_node_properties_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns dynamic_node_properties_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(dynamic_node_properties_amqp_value);
         }
     }
 
@@ -14400,16 +14496,17 @@ int target_set_capabilities(TARGET_HANDLE target, AMQP_VALUE capabilities_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(target_instance->composite_value, 6, capabilities_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&target_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(target_instance->composite_value, 6, capabilities_amqp_value) != 0))
             {
+                amqpvalue_destroy(capabilities_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns capabilities_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(capabilities_amqp_value);
         }
     }
 
@@ -14818,16 +14915,17 @@ int header_set_durable(HEADER_HANDLE header, bool durable_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(header_instance->composite_value, 0, durable_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&header_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(header_instance->composite_value, 0, durable_amqp_value) != 0))
             {
+                amqpvalue_destroy(durable_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns durable_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(durable_amqp_value);
         }
     }
 
@@ -14911,16 +15009,17 @@ int header_set_priority(HEADER_HANDLE header, uint8_t priority_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(header_instance->composite_value, 1, priority_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&header_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(header_instance->composite_value, 1, priority_amqp_value) != 0))
             {
+                amqpvalue_destroy(priority_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns priority_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(priority_amqp_value);
         }
     }
 
@@ -14994,16 +15093,17 @@ int header_set_ttl(HEADER_HANDLE header, milliseconds ttl_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(header_instance->composite_value, 2, ttl_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&header_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(header_instance->composite_value, 2, ttl_amqp_value) != 0))
             {
+                amqpvalue_destroy(ttl_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns ttl_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(ttl_amqp_value);
         }
     }
 
@@ -15087,16 +15187,17 @@ int header_set_first_acquirer(HEADER_HANDLE header, bool first_acquirer_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(header_instance->composite_value, 3, first_acquirer_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&header_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(header_instance->composite_value, 3, first_acquirer_amqp_value) != 0))
             {
+                amqpvalue_destroy(first_acquirer_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns first_acquirer_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(first_acquirer_amqp_value);
         }
     }
 
@@ -15180,16 +15281,17 @@ int header_set_delivery_count(HEADER_HANDLE header, uint32_t delivery_count_valu
         }
         else
         {
-            if (amqpvalue_set_composite_item(header_instance->composite_value, 4, delivery_count_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&header_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(header_instance->composite_value, 4, delivery_count_amqp_value) != 0))
             {
+                amqpvalue_destroy(delivery_count_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns delivery_count_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(delivery_count_amqp_value);
         }
     }
 
@@ -16051,16 +16153,17 @@ int properties_set_message_id(PROPERTIES_HANDLE properties, AMQP_VALUE message_i
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 0, message_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 0, message_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(message_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns message_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(message_id_amqp_value);
         }
     }
 
@@ -16134,16 +16237,17 @@ int properties_set_user_id(PROPERTIES_HANDLE properties, amqp_binary user_id_val
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 1, user_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 1, user_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(user_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns user_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(user_id_amqp_value);
         }
     }
 
@@ -16218,16 +16322,17 @@ int properties_set_to(PROPERTIES_HANDLE properties, AMQP_VALUE to_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 2, to_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 2, to_amqp_value) != 0))
             {
+                amqpvalue_destroy(to_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns to_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(to_amqp_value);
         }
     }
 
@@ -16301,16 +16406,17 @@ int properties_set_subject(PROPERTIES_HANDLE properties, const char* subject_val
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 3, subject_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 3, subject_amqp_value) != 0))
             {
+                amqpvalue_destroy(subject_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns subject_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(subject_amqp_value);
         }
     }
 
@@ -16385,16 +16491,17 @@ int properties_set_reply_to(PROPERTIES_HANDLE properties, AMQP_VALUE reply_to_va
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 4, reply_to_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 4, reply_to_amqp_value) != 0))
             {
+                amqpvalue_destroy(reply_to_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns reply_to_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(reply_to_amqp_value);
         }
     }
 
@@ -16469,16 +16576,17 @@ int properties_set_correlation_id(PROPERTIES_HANDLE properties, AMQP_VALUE corre
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 5, correlation_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 5, correlation_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(correlation_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns correlation_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(correlation_id_amqp_value);
         }
     }
 
@@ -16552,16 +16660,17 @@ int properties_set_content_type(PROPERTIES_HANDLE properties, const char* conten
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 6, content_type_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 6, content_type_amqp_value) != 0))
             {
+                amqpvalue_destroy(content_type_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns content_type_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(content_type_amqp_value);
         }
     }
 
@@ -16635,16 +16744,17 @@ int properties_set_content_encoding(PROPERTIES_HANDLE properties, const char* co
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 7, content_encoding_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 7, content_encoding_amqp_value) != 0))
             {
+                amqpvalue_destroy(content_encoding_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns content_encoding_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(content_encoding_amqp_value);
         }
     }
 
@@ -16718,16 +16828,17 @@ int properties_set_absolute_expiry_time(PROPERTIES_HANDLE properties, timestamp
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 8, absolute_expiry_time_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 8, absolute_expiry_time_amqp_value) != 0))
             {
+                amqpvalue_destroy(absolute_expiry_time_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns absolute_expiry_time_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(absolute_expiry_time_amqp_value);
         }
     }
 
@@ -16801,16 +16912,17 @@ int properties_set_creation_time(PROPERTIES_HANDLE properties, timestamp creatio
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 9, creation_time_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 9, creation_time_amqp_value) != 0))
             {
+                amqpvalue_destroy(creation_time_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns creation_time_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(creation_time_amqp_value);
         }
     }
 
@@ -16884,16 +16996,17 @@ int properties_set_group_id(PROPERTIES_HANDLE properties, const char* group_id_v
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 10, group_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 10, group_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(group_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns group_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(group_id_amqp_value);
         }
     }
 
@@ -16967,16 +17080,17 @@ int properties_set_group_sequence(PROPERTIES_HANDLE properties, sequence_no grou
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 11, group_sequence_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 11, group_sequence_amqp_value) != 0))
             {
+                amqpvalue_destroy(group_sequence_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns group_sequence_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(group_sequence_amqp_value);
         }
     }
 
@@ -17050,16 +17164,17 @@ int properties_set_reply_to_group_id(PROPERTIES_HANDLE properties, const char* r
         }
         else
         {
-            if (amqpvalue_set_composite_item(properties_instance->composite_value, 12, reply_to_group_id_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&properties_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(properties_instance->composite_value, 12, reply_to_group_id_amqp_value) != 0))
             {
+                amqpvalue_destroy(reply_to_group_id_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns reply_to_group_id_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(reply_to_group_id_amqp_value);
         }
     }
 
@@ -17371,16 +17486,17 @@ int received_set_section_number(RECEIVED_HANDLE received, uint32_t section_numbe
         }
         else
         {
-            if (amqpvalue_set_composite_item(received_instance->composite_value, 0, section_number_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&received_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(received_instance->composite_value, 0, section_number_amqp_value) != 0))
             {
+                amqpvalue_destroy(section_number_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns section_number_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(section_number_amqp_value);
         }
     }
 
@@ -17454,16 +17570,17 @@ int received_set_section_offset(RECEIVED_HANDLE received, uint64_t section_offse
         }
         else
         {
-            if (amqpvalue_set_composite_item(received_instance->composite_value, 1, section_offset_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&received_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(received_instance->composite_value, 1, section_offset_amqp_value) != 0))
             {
+                amqpvalue_destroy(section_offset_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns section_offset_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(section_offset_amqp_value);
         }
     }
 
@@ -17845,16 +17962,17 @@ int rejected_set_error(REJECTED_HANDLE rejected, ERROR_HANDLE error_value)
         }
         else
         {
-            if (amqpvalue_set_composite_item(rejected_instance->composite_value, 0, error_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&rejected_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(rejected_instance->composite_value, 0, error_amqp_value) != 0))
             {
+                amqpvalue_destroy(error_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns error_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(error_amqp_value);
         }
     }
 
@@ -18290,16 +18408,17 @@ int modified_set_delivery_failed(MODIFIED_HANDLE modified, bool delivery_failed_
         }
         else
         {
-            if (amqpvalue_set_composite_item(modified_instance->composite_value, 0, delivery_failed_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&modified_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(modified_instance->composite_value, 0, delivery_failed_amqp_value) != 0))
             {
+                amqpvalue_destroy(delivery_failed_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns delivery_failed_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(delivery_failed_amqp_value);
         }
     }
 
@@ -18373,16 +18492,17 @@ int modified_set_undeliverable_here(MODIFIED_HANDLE modified, bool undeliverable
         }
         else
         {
-            if (amqpvalue_set_composite_item(modified_instance->composite_value, 1, undeliverable_here_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&modified_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(modified_instance->composite_value, 1, undeliverable_here_amqp_value) != 0))
             {
+                amqpvalue_destroy(undeliverable_here_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns undeliverable_here_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(undeliverable_here_amqp_value);
         }
     }
 
@@ -18456,16 +18576,17 @@ int modified_set_message_annotations(MODIFIED_HANDLE modified, fields message_an
         }
         else
         {
-            if (amqpvalue_set_composite_item(modified_instance->composite_value, 2, message_annotations_amqp_value) != 0)
+            if ((amqpvalue_make_writable(&modified_instance->composite_value) != 0) ||
+                (amqpvalue_set_composite_item_move(modified_instance->composite_value, 2, message_annotations_amqp_value) != 0))
             {
+                amqpvalue_destroy(message_annotations_amqp_value);
                 result = __FAILURE__;
             }
             else
             {
+                /* the composite owns message_annotations_amqp_value from now on */
                 result = 0;
             }
-
-            amqpvalue_destroy(message_annotations_amqp_value);
         }
     }
 
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 #include "azure_c_shared_utility/optimize_size.h"
@@ -12,6 +13,9 @@
 #include "azure_uamqp_c/frame_codec.h"
 #include "azure_uamqp_c/amqpvalue.h"
 
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_FRAME_CODEC
+#include "azure_uamqp_c/alloc_counters.h"
+
 typedef enum AMQP_FRAME_DECODE_STATE_TAG
 {
     AMQP_FRAME_DECODE_FRAME,
@@ -30,8 +34,24 @@ typedef struct AMQP_FRAME_CODEC_INSTANCE_TAG
     AMQPVALUE_DECODER_HANDLE decoder;
     AMQP_FRAME_DECODE_STATE decode_state;
     AMQP_VALUE decoded_performative;
+    uint64_t decoded_performative_code;
+    ON_AMQP_PERFORMATIVE_BYTES on_performative_bytes;
+    void* on_performative_bytes_context;
 } AMQP_FRAME_CODEC_INSTANCE;
 
+static uint32_t get_payloads_size(const PAYLOAD* payloads, size_t payload_count)
+{
+    size_t total_size = 0;
+    size_t i;
+
+    for (i = 0; i < payload_count; i++)
+    {
+        total_size += payloads[i].length;
+    }
+
+    return (total_size > UINT32_MAX) ? UINT32_MAX : (uint32_t)total_size;
+}
+
 static void amqp_value_decoded(void* context, AMQP_VALUE decoded_value)
 {
     AMQP_FRAME_CODEC_INSTANCE* amqp_frame_codec_instance = (AMQP_FRAME_CODEC_INSTANCE*)context;
@@ -51,6 +71,7 @@ static void amqp_value_decoded(void* context, AMQP_VALUE decoded_value)
     else
     {
         amqp_frame_codec_instance->decoded_performative = decoded_value;
+        amqp_frame_codec_instance->decoded_performative_code = performative_descriptor_ulong;
     }
 }
 
@@ -91,23 +112,30 @@ static void frame_received(void* context, const unsigned char* type_specific, ui
             {
                 /* Codes_SRS_AMQP_FRAME_CODEC_01_051: [If the frame payload is greater than 0, amqp_frame_codec shall decode the performative as a described AMQP type.] */
                 /* Codes_SRS_AMQP_FRAME_CODEC_01_002: [The frame body is defined as a performative followed by an opaque payload.] */
+                size_t performative_size;
+
                 amqp_frame_codec_instance->decoded_performative = NULL;
 
-                while ((frame_body_size > 0) &&
-                       (amqp_frame_codec_instance->decoded_performative == NULL) &&
-                       (amqp_frame_codec_instance->decode_state != AMQP_FRAME_DECODE_ERROR))
+                /* Codes_SRS_AMQP_FRAME_CODEC_01_052: [Decoding the performative shall be done by feeding the bytes to the decoder create in amqp_frame_codec_create.] */
+                /* Codes_SRS_AMQP_FRAME_CODEC_01_075: [The performative shall be decoded with a single call to amqpvalue_decode_one, the bytes it reports as used separating the performative from the payload.] */
+                if (amqpvalue_decode_one(amqp_frame_codec_instance->decoder, frame_body, frame_body_size, &performative_size) != 0)
                 {
-                    /* Codes_SRS_AMQP_FRAME_CODEC_01_052: [Decoding the performative shall be done by feeding the bytes to the decoder create in amqp_frame_codec_create.] */
-                    if (amqpvalue_decode_bytes(amqp_frame_codec_instance->decoder, frame_body, 1) != 0)
-                    {
-                        /* Codes_SRS_AMQP_FRAME_CODEC_01_060: [If any error occurs while decoding a frame, the decoder shall switch to an error state where decoding shall not be possible anymore.] */
-                        amqp_frame_codec_instance->decode_state = AMQP_FRAME_DECODE_ERROR;
-                    }
-                    else
+                    /* Codes_SRS_AMQP_FRAME_CODEC_01_060: [If any error occurs while decoding a frame, the decoder shall switch to an error state where decoding shall not be possible anymore.] */
+                    amqp_frame_codec_instance->decode_state = AMQP_FRAME_DECODE_ERROR;
+
+                    /* a value decoded before the failure was destroyed when the decoder was reset */
+                    amqp_frame_codec_instance->decoded_performative = NULL;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQP_FRAME_CODEC_01_080: [When on_performative_bytes is set, it shall be called with the bytes of every performative decoded, the channel and the payload size before frame_received_callback is called.] */
+                    if (amqp_frame_codec_instance->on_performative_bytes != NULL)
                     {
-                        frame_body_size--;
-                        frame_body++;
+                        amqp_frame_codec_instance->on_performative_bytes(amqp_frame_codec_instance->on_performative_bytes_context, false, channel, frame_body, performative_size, frame_body_size - (uint32_t)performative_size);
                     }
+
+                    frame_body_size -= (uint32_t)performative_size;
+                    frame_body += performative_size;
                 }
 
                 if (amqp_frame_codec_instance->decode_state == AMQP_FRAME_DECODE_ERROR)
@@ -121,7 +149,8 @@ static void frame_received(void* context, const unsigned char* type_specific, ui
                     /* Codes_SRS_AMQP_FRAME_CODEC_01_067: [When the performative is decoded, the rest of the frame_bytes shall not be given to the AMQP decoder, but they shall be buffered so that later they are given to the frame_received callback.] */
                     /* Codes_SRS_AMQP_FRAME_CODEC_01_054: [Once the performative is decoded and all frame payload bytes are received, the callback frame_received_callback shall be called.] */
                     /* Codes_SRS_AMQP_FRAME_CODEC_01_068: [A pointer to all the payload bytes shall also be passed to frame_received_callback.] */
-                    amqp_frame_codec_instance->frame_received_callback(amqp_frame_codec_instance->callback_context, channel, amqp_frame_codec_instance->decoded_performative, frame_body, frame_body_size);
+                    /* Codes_SRS_AMQP_FRAME_CODEC_01_076: [The descriptor of the performative, validated while decoding it, shall also be passed to frame_received_callback as performative_code.] */
+                    amqp_frame_codec_instance->frame_received_callback(amqp_frame_codec_instance->callback_context, channel, amqp_frame_codec_instance->decoded_performative, amqp_frame_codec_instance->decoded_performative_code, frame_body, frame_body_size);
                 }
             }
         }
@@ -129,14 +158,6 @@ static void frame_received(void* context, const unsigned char* type_specific, ui
     }
 }
 
-static int encode_bytes(void* context, const unsigned char* bytes, size_t length)
-{
-    PAYLOAD* payload = (PAYLOAD*)context;
-    (void)memcpy((unsigned char*)payload->bytes + payload->length, bytes, length);
-    payload->length += length;
-    return 0;
-}
-
 /* Codes_SRS_AMQP_FRAME_CODEC_01_011: [amqp_frame_codec_create shall create an instance of an amqp_frame_codec and return a non-NULL handle to it.] */
 AMQP_FRAME_CODEC_HANDLE amqp_frame_codec_create(FRAME_CODEC_HANDLE frame_codec, AMQP_FRAME_RECEIVED_CALLBACK frame_received_callback,
     AMQP_EMPTY_FRAME_RECEIVED_CALLBACK empty_frame_received_callback, AMQP_FRAME_CODEC_ERROR_CALLBACK amqp_frame_codec_error_callback, void* callback_context)
@@ -169,6 +190,8 @@ AMQP_FRAME_CODEC_HANDLE amqp_frame_codec_create(FRAME_CODEC_HANDLE frame_codec,
             result->error_callback = amqp_frame_codec_error_callback;
             result->callback_context = callback_context;
             result->decode_state = AMQP_FRAME_DECODE_FRAME;
+            result->on_performative_bytes = NULL;
+            result->on_performative_bytes_context = NULL;
 
             /* Codes_SRS_AMQP_FRAME_CODEC_01_018: [amqp_frame_codec_create shall create a decoder to be used for decoding AMQP values.] */
             result->decoder = amqpvalue_decoder_create(amqp_value_decoded, result);
@@ -217,6 +240,52 @@ void amqp_frame_codec_destroy(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec)
     }
 }
 
+int amqp_frame_codec_set_decoder_limits(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, uint32_t max_depth, size_t max_element_count, size_t max_allocated_bytes)
+{
+    int result;
+
+    if (amqp_frame_codec == NULL)
+    {
+        /* Codes_SRS_AMQP_FRAME_CODEC_01_078: [If amqp_frame_codec is NULL, amqp_frame_codec_set_decoder_limits shall fail and return a non-zero value.] */
+        LogError("NULL amqp_frame_codec");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQP_FRAME_CODEC_01_077: [amqp_frame_codec_set_decoder_limits shall apply max_depth, max_element_count and max_allocated_bytes to the decoder created in amqp_frame_codec_create by calling amqpvalue_decoder_set_limits and return 0.] */
+    else if (amqpvalue_decoder_set_limits(amqp_frame_codec->decoder, max_depth, max_element_count, max_allocated_bytes) != 0)
+    {
+        /* Codes_SRS_AMQP_FRAME_CODEC_01_079: [If amqpvalue_decoder_set_limits fails, amqp_frame_codec_set_decoder_limits shall fail and return a non-zero value.] */
+        LogError("Could not set the decoder limits");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int amqp_frame_codec_set_on_performative_bytes(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, ON_AMQP_PERFORMATIVE_BYTES on_performative_bytes, void* context)
+{
+    int result;
+
+    if (amqp_frame_codec == NULL)
+    {
+        /* Codes_SRS_AMQP_FRAME_CODEC_01_083: [If amqp_frame_codec is NULL, amqp_frame_codec_set_on_performative_bytes shall fail and return a non-zero value.] */
+        LogError("NULL amqp_frame_codec");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_FRAME_CODEC_01_082: [amqp_frame_codec_set_on_performative_bytes shall make the amqp_frame_codec call on_performative_bytes with context for the performatives it decodes and encodes, a NULL on_performative_bytes stopping the calls, and return 0.] */
+        amqp_frame_codec->on_performative_bytes = on_performative_bytes;
+        amqp_frame_codec->on_performative_bytes_context = context;
+        result = 0;
+    }
+
+    return result;
+}
+
 int amqp_frame_codec_encode_frame(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, uint16_t channel, AMQP_VALUE performative, const PAYLOAD* payloads, size_t payload_count, ON_BYTES_ENCODED on_bytes_encoded, void* callback_context)
 {
     int result;
@@ -292,9 +361,10 @@ int amqp_frame_codec_encode_frame(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, uint
                         (void)memcpy(new_payloads + 1, payloads, sizeof(PAYLOAD) * payload_count);
                     }
 
-                    if (amqpvalue_encode(performative, encode_bytes, &new_payloads[0]) != 0)
+                    /* Codes_SRS_AMQP_FRAME_CODEC_01_030: [Encoding of the AMQP performative and its fields shall be done by calling amqpvalue_encode_to_buffer.] */
+                    if (amqpvalue_encode_to_buffer(performative, amqp_performative_bytes, encoded_size, &new_payloads[0].length) != 0)
                     {
-                        LogError("amqpvalue_encode failed");
+                        LogError("amqpvalue_encode_to_buffer failed");
                         result = __FAILURE__;
                     }
                     else
@@ -315,6 +385,12 @@ int amqp_frame_codec_encode_frame(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, uint
                         }
                         else
                         {
+                            /* Codes_SRS_AMQP_FRAME_CODEC_01_081: [When on_performative_bytes is set, it shall be called with the bytes of every performative encoded, the channel and the payload size once the frame is encoded.] */
+                            if (amqp_frame_codec->on_performative_bytes != NULL)
+                            {
+                                amqp_frame_codec->on_performative_bytes(amqp_frame_codec->on_performative_bytes_context, true, channel, amqp_performative_bytes, new_payloads[0].length, get_payloads_size(payloads, payload_count));
+                            }
+
                             /* Codes_SRS_AMQP_FRAME_CODEC_01_022: [amqp_frame_codec_begin_encode_frame shall encode the frame header and AMQP performative in an AMQP frame and on success it shall return 0.] */
                             result = 0;
                         }
@@ -331,6 +407,70 @@ int amqp_frame_codec_encode_frame(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, uint
     return result;
 }
 
+/* Codes_SRS_AMQP_FRAME_CODEC_01_071: [amqp_frame_codec_encode_frame_with_encoded_performative shall encode an AMQP frame whose performative is given as already encoded bytes and on success it shall return 0.] */
+int amqp_frame_codec_encode_frame_with_encoded_performative(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, uint16_t channel, const unsigned char* performative_bytes, size_t performative_size, const PAYLOAD* payloads, size_t payload_count, ON_BYTES_ENCODED on_bytes_encoded, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_AMQP_FRAME_CODEC_01_072: [If amqp_frame_codec, performative_bytes or on_bytes_encoded is NULL or performative_size is 0, amqp_frame_codec_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+    if ((amqp_frame_codec == NULL) ||
+        (performative_bytes == NULL) ||
+        (performative_size == 0) ||
+        (on_bytes_encoded == NULL))
+    {
+        LogError("Bad arguments: amqp_frame_codec = %p, performative_bytes = %p, performative_size = %u, on_bytes_encoded = %p",
+            amqp_frame_codec, performative_bytes, (unsigned int)performative_size, on_bytes_encoded);
+        result = __FAILURE__;
+    }
+    else
+    {
+        PAYLOAD* new_payloads = (PAYLOAD*)malloc(sizeof(PAYLOAD) * (payload_count + 1));
+        if (new_payloads == NULL)
+        {
+            /* Codes_SRS_AMQP_FRAME_CODEC_01_074: [If any error occurs during encoding, amqp_frame_codec_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+            LogError("Could not allocate frame payloads");
+            result = __FAILURE__;
+        }
+        else
+        {
+            unsigned char channel_bytes[2];
+
+            /* Codes_SRS_AMQP_FRAME_CODEC_01_073: [The payloads argument for frame_codec_encode_frame shall be made of the performative bytes followed by the payloads passed to amqp_frame_codec_encode_frame_with_encoded_performative.] */
+            new_payloads[0].bytes = performative_bytes;
+            new_payloads[0].length = performative_size;
+
+            if (payload_count > 0)
+            {
+                (void)memcpy(new_payloads + 1, payloads, sizeof(PAYLOAD) * payload_count);
+            }
+
+            channel_bytes[0] = channel >> 8;
+            channel_bytes[1] = channel & 0xFF;
+
+            if (frame_codec_encode_frame(amqp_frame_codec->frame_codec, FRAME_TYPE_AMQP, new_payloads, payload_count + 1, channel_bytes, sizeof(channel_bytes), on_bytes_encoded, callback_context) != 0)
+            {
+                /* Codes_SRS_AMQP_FRAME_CODEC_01_074: [If any error occurs during encoding, amqp_frame_codec_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+                LogError("frame_codec_encode_frame failed");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_FRAME_CODEC_01_081: [When on_performative_bytes is set, it shall be called with the bytes of every performative encoded, the channel and the payload size once the frame is encoded.] */
+                if (amqp_frame_codec->on_performative_bytes != NULL)
+                {
+                    amqp_frame_codec->on_performative_bytes(amqp_frame_codec->on_performative_bytes_context, true, channel, performative_bytes, performative_size, get_payloads_size(payloads, payload_count));
+                }
+
+                result = 0;
+            }
+
+            free(new_payloads);
+        }
+    }
+
+    return result;
+}
+
 /* Codes_SRS_AMQP_FRAME_CODEC_01_042: [amqp_frame_codec_encode_empty_frame shall encode a frame with no payload.] */
 /* Codes_SRS_AMQP_FRAME_CODEC_01_010: [An AMQP frame with no body MAY be used to generate artificial traffic as needed to satisfy any negotiated idle timeout interval ] */
 int amqp_frame_codec_encode_empty_frame(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, uint16_t channel, ON_BYTES_ENCODED on_bytes_encoded, void* callback_context)
@@ -0,0 +1,1202 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_json.h"
+
+/* longest number text that is parsed as a double, longer ones are not numbers anyone would send */
+#define MAX_NUMBER_LENGTH 64
+
+static const char hex_digits[] = "0123456789abcdef";
+static const char base64_characters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+typedef struct JSON_OUTPUT_TAG
+{
+    char* json;
+    size_t size;
+    size_t position;
+} JSON_OUTPUT;
+
+typedef struct JSON_INPUT_TAG
+{
+    const char* json;
+    size_t length;
+    size_t position;
+    /* scratch buffer for the strings that have escapes, the others are written straight from the JSON text */
+    char* unescaped;
+    size_t unescaped_size;
+} JSON_INPUT;
+
+static int output_chars(JSON_OUTPUT* output, const char* chars, size_t length)
+{
+    int result;
+
+    if (length > output->size - output->position)
+    {
+        /* Codes_SRS_AMQP_JSON_01_004: [ If the JSON text does not fit in `json_size` characters, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+        LogError("JSON text does not fit in %lu characters", (unsigned long)output->size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(output->json + output->position, chars, length);
+        output->position += length;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int output_unsigned(JSON_OUTPUT* output, uint64_t value, bool is_negative)
+{
+    /* 20 digits and the sign */
+    char digits[21];
+    size_t position = sizeof(digits);
+
+    do
+    {
+        digits[--position] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    if (is_negative)
+    {
+        digits[--position] = '-';
+    }
+
+    return output_chars(output, digits + position, sizeof(digits) - position);
+}
+
+static int output_signed(JSON_OUTPUT* output, int64_t value)
+{
+    return output_unsigned(output, (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value, value < 0);
+}
+
+static int output_floating(JSON_OUTPUT* output, double value, bool is_float)
+{
+    int result;
+
+    if ((value != value) ||
+        (value > DBL_MAX) ||
+        (value < -DBL_MAX))
+    {
+        /* Codes_SRS_AMQP_JSON_01_007: [ A float or double that is NaN or infinite shall be written as `null`. ]*/
+        result = output_chars(output, "null", 4);
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_JSON_01_006: [ A float or double shall be written as a number with the fewest digits that read back as the same value. ]*/
+        /* 9 digits always read back a float and 17 a double, fewer usually do */
+        char number[32];
+        int precision = is_float ? 6 : 15;
+        int max_precision = is_float ? 9 : 17;
+        int length;
+
+        for (;;)
+        {
+            double read_back;
+
+            length = snprintf(number, sizeof(number), "%.*g", precision, value);
+            read_back = strtod(number, NULL);
+            if ((precision == max_precision) ||
+                (is_float ? ((float)read_back == (float)value) : (read_back == value)))
+            {
+                break;
+            }
+
+            precision++;
+        }
+
+        if ((length < 0) ||
+            ((size_t)length >= sizeof(number)))
+        {
+            LogError("Cannot format %g", value);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = output_chars(output, number, (size_t)length);
+        }
+    }
+
+    return result;
+}
+
+static int output_json_string(JSON_OUTPUT* output, const char* chars, size_t length)
+{
+    int result = output_chars(output, "\"", 1);
+    size_t run_start = 0;
+    size_t i;
+
+    /* Codes_SRS_AMQP_JSON_01_008: [ In the strings written, `"`, `\` and the control characters shall be escaped. ]*/
+    /* runs of characters that need no escape are copied as a whole */
+    for (i = 0; (result == 0) && (i < length); i++)
+    {
+        unsigned char c = (unsigned char)chars[i];
+
+        if ((c == '"') ||
+            (c == '\\') ||
+            (c < 0x20))
+        {
+            char escape[6];
+            size_t escape_length = 2;
+
+            escape[0] = '\\';
+            switch (c)
+            {
+            case '"': escape[1] = '"'; break;
+            case '\\': escape[1] = '\\'; break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex_digits[c >> 4];
+                escape[5] = hex_digits[c & 0x0F];
+                escape_length = 6;
+                break;
+            }
+
+            if ((output_chars(output, chars + run_start, i - run_start) != 0) ||
+                (output_chars(output, escape, escape_length) != 0))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                run_start = i + 1;
+            }
+        }
+    }
+
+    if ((result == 0) &&
+        ((output_chars(output, chars + run_start, length - run_start) != 0) ||
+         (output_chars(output, "\"", 1) != 0)))
+    {
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static int output_base64_string(JSON_OUTPUT* output, const unsigned char* bytes, uint32_t length)
+{
+    int result;
+    size_t encoded_length = (((size_t)length + 2) / 3) * 4;
+
+    if (encoded_length + 2 > output->size - output->position)
+    {
+        /* Codes_SRS_AMQP_JSON_01_004: [ If the JSON text does not fit in `json_size` characters, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+        LogError("JSON text does not fit in %lu characters", (unsigned long)output->size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* encoded = output->json + output->position;
+        uint32_t i;
+
+        *(encoded++) = '"';
+        for (i = 0; i + 2 < length; i += 3)
+        {
+            *(encoded++) = base64_characters[bytes[i] >> 2];
+            *(encoded++) = base64_characters[((bytes[i] & 0x03) << 4) | (bytes[i + 1] >> 4)];
+            *(encoded++) = base64_characters[((bytes[i + 1] & 0x0F) << 2) | (bytes[i + 2] >> 6)];
+            *(encoded++) = base64_characters[bytes[i + 2] & 0x3F];
+        }
+
+        if (i < length)
+        {
+            *(encoded++) = base64_characters[bytes[i] >> 2];
+            if (i + 1 < length)
+            {
+                *(encoded++) = base64_characters[((bytes[i] & 0x03) << 4) | (bytes[i + 1] >> 4)];
+                *(encoded++) = base64_characters[(bytes[i + 1] & 0x0F) << 2];
+            }
+            else
+            {
+                *(encoded++) = base64_characters[(bytes[i] & 0x03) << 4];
+                *(encoded++) = '=';
+            }
+
+            *(encoded++) = '=';
+        }
+
+        *encoded = '"';
+        output->position += encoded_length + 2;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int output_uuid_string(JSON_OUTPUT* output, const unsigned char* bytes)
+{
+    char uuid[38];
+    size_t position = 0;
+    size_t i;
+
+    uuid[position++] = '"';
+    for (i = 0; i < 16; i++)
+    {
+        if ((i == 4) || (i == 6) || (i == 8) || (i == 10))
+        {
+            uuid[position++] = '-';
+        }
+
+        uuid[position++] = hex_digits[bytes[i] >> 4];
+        uuid[position++] = hex_digits[bytes[i] & 0x0F];
+    }
+    uuid[position++] = '"';
+
+    return output_chars(output, uuid, position);
+}
+
+static size_t encode_utf8(uint32_t code_point, char* bytes)
+{
+    size_t result;
+
+    if (code_point < 0x80)
+    {
+        bytes[0] = (char)code_point;
+        result = 1;
+    }
+    else if (code_point < 0x800)
+    {
+        bytes[0] = (char)(0xC0 | (code_point >> 6));
+        bytes[1] = (char)(0x80 | (code_point & 0x3F));
+        result = 2;
+    }
+    else if (code_point < 0x10000)
+    {
+        bytes[0] = (char)(0xE0 | (code_point >> 12));
+        bytes[1] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        bytes[2] = (char)(0x80 | (code_point & 0x3F));
+        result = 3;
+    }
+    else
+    {
+        bytes[0] = (char)(0xF0 | (code_point >> 18));
+        bytes[1] = (char)(0x80 | ((code_point >> 12) & 0x3F));
+        bytes[2] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        bytes[3] = (char)(0x80 | (code_point & 0x3F));
+        result = 4;
+    }
+
+    return result;
+}
+
+static int output_scalar(JSON_OUTPUT* output, const AMQP_READER_ITEM* item)
+{
+    int result;
+
+    switch (item->type)
+    {
+    default:
+        /* Codes_SRS_AMQP_JSON_01_011: [ If a decimal or a value of an unknown type is found, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+        LogError("AMQP value with constructor 0x%02x cannot be written as JSON", (unsigned int)item->constructor);
+        result = __FAILURE__;
+        break;
+
+    /* Codes_SRS_AMQP_JSON_01_005: [ null and booleans shall be written as `null`, `true` and `false`, integers and timestamps (in milliseconds) as numbers. ]*/
+    case AMQP_TYPE_NULL:
+        result = output_chars(output, "null", 4);
+        break;
+    case AMQP_TYPE_BOOL:
+        result = item->value.bool_value ? output_chars(output, "true", 4) : output_chars(output, "false", 5);
+        break;
+    case AMQP_TYPE_UBYTE:
+    case AMQP_TYPE_USHORT:
+    case AMQP_TYPE_UINT:
+    case AMQP_TYPE_ULONG:
+        result = output_unsigned(output, item->value.unsigned_value, false);
+        break;
+    case AMQP_TYPE_BYTE:
+    case AMQP_TYPE_SHORT:
+    case AMQP_TYPE_INT:
+    case AMQP_TYPE_LONG:
+    case AMQP_TYPE_TIMESTAMP:
+        result = output_signed(output, item->value.signed_value);
+        break;
+    case AMQP_TYPE_FLOAT:
+        result = output_floating(output, item->value.float_value, true);
+        break;
+    case AMQP_TYPE_DOUBLE:
+        result = output_floating(output, item->value.double_value, false);
+        break;
+
+    /* Codes_SRS_AMQP_JSON_01_009: [ Strings and symbols shall be written as strings, a char as a string holding its UTF-8 encoding and a uuid as a string in the 8-4-4-4-12 hexadecimal form. ]*/
+    case AMQP_TYPE_STRING:
+    case AMQP_TYPE_SYMBOL:
+        result = output_json_string(output, (const char*)item->bytes, item->length);
+        break;
+    case AMQP_TYPE_CHAR:
+    {
+        char utf8[4];
+
+        if ((item->value.unsigned_value > 0x10FFFF) ||
+            ((item->value.unsigned_value >= 0xD800) && (item->value.unsigned_value <= 0xDFFF)))
+        {
+            LogError("char 0x%lx is not a Unicode code point", (unsigned long)item->value.unsigned_value);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = output_json_string(output, utf8, encode_utf8((uint32_t)item->value.unsigned_value, utf8));
+        }
+        break;
+    }
+    case AMQP_TYPE_UUID:
+        result = output_uuid_string(output, item->bytes);
+        break;
+
+    /* Codes_SRS_AMQP_JSON_01_010: [ A binary shall be written as a string holding its base64 encoding. ]*/
+    case AMQP_TYPE_BINARY:
+        result = output_base64_string(output, item->bytes, item->length);
+        break;
+    }
+
+    return result;
+}
+
+static int output_key(JSON_OUTPUT* output, const AMQP_READER_ITEM* key)
+{
+    int result;
+
+    switch (key->type)
+    {
+    case AMQP_TYPE_LIST:
+    case AMQP_TYPE_MAP:
+    case AMQP_TYPE_ARRAY:
+    case AMQP_TYPE_DESCRIBED:
+        /* Codes_SRS_AMQP_JSON_01_014: [ If a map key is a list, map, array or described value, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+        LogError("A map key that is a list, map, array or described value cannot be written as JSON");
+        result = __FAILURE__;
+        break;
+
+    case AMQP_TYPE_STRING:
+    case AMQP_TYPE_SYMBOL:
+    case AMQP_TYPE_CHAR:
+    case AMQP_TYPE_UUID:
+    case AMQP_TYPE_BINARY:
+        result = output_scalar(output, key);
+        break;
+
+    default:
+        /* Codes_SRS_AMQP_JSON_01_013: [ Map keys that are not written as strings shall be written as their JSON text in a string. ]*/
+        if ((output_chars(output, "\"", 1) != 0) ||
+            (output_scalar(output, key) != 0) ||
+            (output_chars(output, "\"", 1) != 0))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+        break;
+    }
+
+    return result;
+}
+
+static int output_value(AMQP_READER* reader, const AMQP_READER_ITEM* item, JSON_OUTPUT* output)
+{
+    int result;
+
+    switch (item->type)
+    {
+    default:
+        result = output_scalar(output, item);
+        break;
+
+    case AMQP_TYPE_DESCRIBED:
+    {
+        AMQP_READER_ITEM descriptor;
+        AMQP_READER_ITEM value;
+
+        /* Codes_SRS_AMQP_JSON_01_015: [ A described value shall be written as its value, without its descriptor. ]*/
+        if ((amqp_reader_enter(reader, item) != 0) ||
+            (amqp_reader_next(reader, &descriptor) != 0) ||
+            (amqp_reader_next(reader, &value) != 0) ||
+            (output_value(reader, &value, output) != 0) ||
+            (amqp_reader_leave(reader) != 0))
+        {
+            LogError("Cannot write described value as JSON");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+        break;
+    }
+
+    case AMQP_TYPE_LIST:
+    case AMQP_TYPE_ARRAY:
+    case AMQP_TYPE_MAP:
+    {
+        bool is_map = (item->type == AMQP_TYPE_MAP);
+        bool is_first = true;
+
+        /* Codes_SRS_AMQP_JSON_01_012: [ Lists and arrays shall be written as JSON arrays and maps as JSON objects. ]*/
+        if ((amqp_reader_enter(reader, item) != 0) ||
+            (output_chars(output, is_map ? "{" : "[", 1) != 0))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+            while ((result == 0) &&
+                amqp_reader_has_next(reader))
+            {
+                AMQP_READER_ITEM child;
+
+                if ((!is_first && (output_chars(output, ",", 1) != 0)) ||
+                    (amqp_reader_next(reader, &child) != 0))
+                {
+                    result = __FAILURE__;
+                }
+                else if (is_map)
+                {
+                    AMQP_READER_ITEM value;
+
+                    if ((output_key(output, &child) != 0) ||
+                        (output_chars(output, ":", 1) != 0) ||
+                        (amqp_reader_next(reader, &value) != 0) ||
+                        (output_value(reader, &value, output) != 0))
+                    {
+                        result = __FAILURE__;
+                    }
+                }
+                else if (output_value(reader, &child, output) != 0)
+                {
+                    result = __FAILURE__;
+                }
+
+                is_first = false;
+            }
+
+            if ((result == 0) &&
+                ((output_chars(output, is_map ? "}" : "]", 1) != 0) ||
+                 (amqp_reader_leave(reader) != 0)))
+            {
+                result = __FAILURE__;
+            }
+        }
+        break;
+    }
+    }
+
+    return result;
+}
+
+int amqp_json_from_amqp(const unsigned char* bytes, size_t length, char* json, size_t json_size, size_t* json_length)
+{
+    int result;
+
+    if ((bytes == NULL) ||
+        (json == NULL) ||
+        (json_length == NULL))
+    {
+        /* Codes_SRS_AMQP_JSON_01_002: [ If `bytes`, `json` or `json_length` is NULL, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: bytes = %p, json = %p, json_length = %p",
+            bytes, json, json_length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_READER reader;
+        AMQP_READER_ITEM item;
+        JSON_OUTPUT output;
+
+        output.json = json;
+        output.size = json_size;
+        output.position = 0;
+
+        if ((amqp_reader_init(&reader, bytes, length) != 0) ||
+            !amqp_reader_has_next(&reader) ||
+            (amqp_reader_next(&reader, &item) != 0))
+        {
+            /* Codes_SRS_AMQP_JSON_01_003: [ If `bytes` does not hold exactly one well formed AMQP value, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+            LogError("No AMQP value in %lu bytes", (unsigned long)length);
+            result = __FAILURE__;
+        }
+        else if (output_value(&reader, &item, &output) != 0)
+        {
+            LogError("Cannot write AMQP value as JSON");
+            result = __FAILURE__;
+        }
+        else if (amqp_reader_has_next(&reader))
+        {
+            /* Codes_SRS_AMQP_JSON_01_003: [ If `bytes` does not hold exactly one well formed AMQP value, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+            LogError("Bytes found after the AMQP value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_JSON_01_001: [ `amqp_json_from_amqp` shall write the JSON text of the AMQP value encoded in `bytes` to `json`, not NUL terminated, set `json_length` to its number of characters and return 0, reading the encoding with the AMQP reader. ]*/
+            *json_length = output.position;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void skip_whitespace(JSON_INPUT* input)
+{
+    while ((input->position < input->length) &&
+        ((input->json[input->position] == ' ') ||
+         (input->json[input->position] == '\t') ||
+         (input->json[input->position] == '\n') ||
+         (input->json[input->position] == '\r')))
+    {
+        input->position++;
+    }
+}
+
+static bool is_digit_at(const JSON_INPUT* input, size_t position)
+{
+    return (position < input->length) &&
+        (input->json[position] >= '0') &&
+        (input->json[position] <= '9');
+}
+
+static int parse_literal(JSON_INPUT* input, const char* literal, size_t literal_length)
+{
+    int result;
+
+    if ((input->length - input->position < literal_length) ||
+        (memcmp(input->json + input->position, literal, literal_length) != 0))
+    {
+        LogError("Invalid JSON at character %lu", (unsigned long)input->position);
+        result = __FAILURE__;
+    }
+    else
+    {
+        input->position += literal_length;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int parse_hex4(JSON_INPUT* input, uint32_t* code_unit)
+{
+    int result;
+
+    if (input->length - input->position < 4)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+        *code_unit = 0;
+        for (i = 0; (result == 0) && (i < 4); i++)
+        {
+            char c = input->json[input->position + i];
+
+            if ((c >= '0') && (c <= '9'))
+            {
+                *code_unit = (*code_unit << 4) | (uint32_t)(c - '0');
+            }
+            else if ((c >= 'a') && (c <= 'f'))
+            {
+                *code_unit = (*code_unit << 4) | (uint32_t)(c - 'a' + 10);
+            }
+            else if ((c >= 'A') && (c <= 'F'))
+            {
+                *code_unit = (*code_unit << 4) | (uint32_t)(c - 'A' + 10);
+            }
+            else
+            {
+                result = __FAILURE__;
+            }
+        }
+
+        input->position += 4;
+    }
+
+    return result;
+}
+
+/* the code point of the \u escape the position is on (after the "\u"), a surrogate pair being read as one */
+static int parse_unicode_escape(JSON_INPUT* input, uint32_t* code_point)
+{
+    int result;
+    uint32_t low_surrogate;
+
+    if (parse_hex4(input, code_point) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if ((*code_point >= 0xDC00) && (*code_point <= 0xDFFF))
+    {
+        result = __FAILURE__;
+    }
+    else if ((*code_point < 0xD800) || (*code_point > 0xDBFF))
+    {
+        result = 0;
+    }
+    else if ((input->length - input->position < 2) ||
+        (input->json[input->position] != '\\') ||
+        (input->json[input->position + 1] != 'u'))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        input->position += 2;
+        if ((parse_hex4(input, &low_surrogate) != 0) ||
+            (low_surrogate < 0xDC00) ||
+            (low_surrogate > 0xDFFF))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            *code_point = 0x10000 + ((*code_point - 0xD800) << 10) + (low_surrogate - 0xDC00);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int parse_escaped_string(JSON_INPUT* input, AMQP_WRITER* writer, size_t start)
+{
+    int result;
+    size_t end = input->position;
+    size_t unescaped_length;
+
+    /* the closing quote, to size the scratch buffer: unescaping never makes a string longer */
+    while ((end < input->length) &&
+        (input->json[end] != '"'))
+    {
+        end += (input->json[end] == '\\') ? 2 : 1;
+    }
+
+    if (end >= input->length)
+    {
+        LogError("Unterminated JSON string at character %lu", (unsigned long)start);
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (input->unescaped_size < end - start)
+        {
+            char* new_unescaped = (char*)realloc(input->unescaped, end - start);
+            if (new_unescaped == NULL)
+            {
+                /* Codes_SRS_AMQP_JSON_01_026: [ If allocating the memory to unescape a string fails, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+                LogError("Cannot allocate memory to unescape a JSON string");
+                result = __FAILURE__;
+            }
+            else
+            {
+                input->unescaped = new_unescaped;
+                input->unescaped_size = end - start;
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if (result == 0)
+        {
+            unescaped_length = input->position - start;
+            (void)memcpy(input->unescaped, input->json + start, unescaped_length);
+
+            while ((result == 0) &&
+                (input->json[input->position] != '"'))
+            {
+                unsigned char c = (unsigned char)input->json[input->position];
+
+                if (c < 0x20)
+                {
+                    /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+                    LogError("Control character in JSON string at character %lu", (unsigned long)input->position);
+                    result = __FAILURE__;
+                }
+                else if (c != '\\')
+                {
+                    input->unescaped[unescaped_length++] = (char)c;
+                    input->position++;
+                }
+                else
+                {
+                    /* past the backslash and the escape character */
+                    input->position += 2;
+                    switch (input->json[input->position - 1])
+                    {
+                    default: result = __FAILURE__; break;
+                    case '"': input->unescaped[unescaped_length++] = '"'; break;
+                    case '\\': input->unescaped[unescaped_length++] = '\\'; break;
+                    case '/': input->unescaped[unescaped_length++] = '/'; break;
+                    case 'b': input->unescaped[unescaped_length++] = '\b'; break;
+                    case 'f': input->unescaped[unescaped_length++] = '\f'; break;
+                    case 'n': input->unescaped[unescaped_length++] = '\n'; break;
+                    case 'r': input->unescaped[unescaped_length++] = '\r'; break;
+                    case 't': input->unescaped[unescaped_length++] = '\t'; break;
+                    case 'u':
+                    {
+                        uint32_t code_point;
+
+                        /* Codes_SRS_AMQP_JSON_01_022: [ `\u` escapes, surrogate pairs included, shall be unescaped to their UTF-8 encoding. ]*/
+                        if (parse_unicode_escape(input, &code_point) != 0)
+                        {
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            unescaped_length += encode_utf8(code_point, input->unescaped + unescaped_length);
+                        }
+                        break;
+                    }
+                    }
+
+                    if (result != 0)
+                    {
+                        /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+                        LogError("Invalid escape in JSON string at character %lu", (unsigned long)input->position);
+                    }
+                }
+            }
+
+            if (result == 0)
+            {
+                /* past the closing quote */
+                input->position++;
+                if (amqp_writer_put_string_n(writer, input->unescaped, unescaped_length) != 0)
+                {
+                    result = __FAILURE__;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static int parse_string(JSON_INPUT* input, AMQP_WRITER* writer)
+{
+    int result;
+    size_t start;
+
+    /* past the opening quote */
+    input->position++;
+    start = input->position;
+
+    while ((input->position < input->length) &&
+        (input->json[input->position] != '"') &&
+        (input->json[input->position] != '\\') &&
+        ((unsigned char)input->json[input->position] >= 0x20))
+    {
+        input->position++;
+    }
+
+    if (input->position == input->length)
+    {
+        /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+        LogError("Unterminated JSON string at character %lu", (unsigned long)start);
+        result = __FAILURE__;
+    }
+    else if (input->json[input->position] == '"')
+    {
+        /* Codes_SRS_AMQP_JSON_01_021: [ A string without escapes shall be written straight from the JSON text. ]*/
+        input->position++;
+        result = amqp_writer_put_string_n(writer, input->json + start, input->position - 1 - start);
+    }
+    else if (input->json[input->position] != '\\')
+    {
+        /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+        LogError("Control character in JSON string at character %lu", (unsigned long)input->position);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = parse_escaped_string(input, writer, start);
+    }
+
+    return result;
+}
+
+static int parse_number(JSON_INPUT* input, AMQP_WRITER* writer)
+{
+    int result;
+    size_t start = input->position;
+    bool is_negative = false;
+    bool is_integer = true;
+
+    if (input->json[input->position] == '-')
+    {
+        is_negative = true;
+        input->position++;
+    }
+
+    if ((input->position < input->length) &&
+        (input->json[input->position] == '0'))
+    {
+        input->position++;
+        result = 0;
+    }
+    else if (is_digit_at(input, input->position))
+    {
+        while (is_digit_at(input, input->position))
+        {
+            input->position++;
+        }
+        result = 0;
+    }
+    else
+    {
+        result = __FAILURE__;
+    }
+
+    if ((result == 0) &&
+        (input->position < input->length) &&
+        (input->json[input->position] == '.'))
+    {
+        is_integer = false;
+        input->position++;
+        if (!is_digit_at(input, input->position))
+        {
+            result = __FAILURE__;
+        }
+        while (is_digit_at(input, input->position))
+        {
+            input->position++;
+        }
+    }
+
+    if ((result == 0) &&
+        (input->position < input->length) &&
+        ((input->json[input->position] == 'e') || (input->json[input->position] == 'E')))
+    {
+        is_integer = false;
+        input->position++;
+        if ((input->position < input->length) &&
+            ((input->json[input->position] == '+') || (input->json[input->position] == '-')))
+        {
+            input->position++;
+        }
+        if (!is_digit_at(input, input->position))
+        {
+            result = __FAILURE__;
+        }
+        while (is_digit_at(input, input->position))
+        {
+            input->position++;
+        }
+    }
+
+    if (result != 0)
+    {
+        /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+        LogError("Invalid JSON number at character %lu", (unsigned long)start);
+    }
+    else
+    {
+        bool is_written = false;
+
+        if (is_integer)
+        {
+            uint64_t magnitude = 0;
+            bool is_overflow = false;
+            size_t i;
+
+            for (i = start + (is_negative ? 1 : 0); i < input->position; i++)
+            {
+                uint64_t digit = (uint64_t)(input->json[i] - '0');
+
+                if (magnitude > (UINT64_MAX - digit) / 10)
+                {
+                    is_overflow = true;
+                    break;
+                }
+
+                magnitude = (magnitude * 10) + digit;
+            }
+
+            /* Codes_SRS_AMQP_JSON_01_019: [ A number without fraction or exponent shall be written as a long, or as a ulong when it only fits in one. ]*/
+            if (is_overflow)
+            {
+                /* written as a double below */
+            }
+            else if (!is_negative)
+            {
+                result = (magnitude <= (uint64_t)INT64_MAX) ?
+                    amqp_writer_put_long(writer, (int64_t)magnitude) :
+                    amqp_writer_put_ulong(writer, magnitude);
+                is_written = true;
+            }
+            else if (magnitude == (uint64_t)INT64_MAX + 1)
+            {
+                result = amqp_writer_put_long(writer, INT64_MIN);
+                is_written = true;
+            }
+            else if (magnitude <= (uint64_t)INT64_MAX)
+            {
+                result = amqp_writer_put_long(writer, -(int64_t)magnitude);
+                is_written = true;
+            }
+        }
+
+        if (!is_written)
+        {
+            /* Codes_SRS_AMQP_JSON_01_020: [ Any other number shall be written as a double. ]*/
+            char number[MAX_NUMBER_LENGTH];
+            size_t number_length = input->position - start;
+
+            if (number_length >= sizeof(number))
+            {
+                LogError("JSON number at character %lu is too long", (unsigned long)start);
+                result = __FAILURE__;
+            }
+            else
+            {
+                (void)memcpy(number, input->json + start, number_length);
+                number[number_length] = '\0';
+                result = amqp_writer_put_double(writer, strtod(number, NULL));
+            }
+        }
+    }
+
+    return result;
+}
+
+static int parse_value(JSON_INPUT* input, AMQP_WRITER* writer, size_t depth);
+
+static int parse_container(JSON_INPUT* input, AMQP_WRITER* writer, size_t depth, bool is_object)
+{
+    int result;
+    char closing_char = is_object ? '}' : ']';
+
+    if (depth == AMQP_WRITER_MAX_DEPTH)
+    {
+        /* Codes_SRS_AMQP_JSON_01_025: [ If arrays and objects are nested more than `AMQP_WRITER_MAX_DEPTH` deep, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+        LogError("JSON nested more than %d deep", AMQP_WRITER_MAX_DEPTH);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQP_JSON_01_018: [ An object shall be written as a map with string keys and an array as a list. ]*/
+    else if ((is_object ? amqp_writer_begin_map(writer) : amqp_writer_begin_list(writer)) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        input->position++;
+        skip_whitespace(input);
+
+        if ((input->position < input->length) &&
+            (input->json[input->position] == closing_char))
+        {
+            input->position++;
+            result = 0;
+        }
+        else
+        {
+            for (;;)
+            {
+                if (is_object)
+                {
+                    skip_whitespace(input);
+                    if ((input->position >= input->length) ||
+                        (input->json[input->position] != '"'))
+                    {
+                        LogError("Expected a string key at character %lu", (unsigned long)input->position);
+                        result = __FAILURE__;
+                        break;
+                    }
+                    else if (parse_string(input, writer) != 0)
+                    {
+                        result = __FAILURE__;
+                        break;
+                    }
+
+                    skip_whitespace(input);
+                    if ((input->position >= input->length) ||
+                        (input->json[input->position] != ':'))
+                    {
+                        LogError("Expected ':' at character %lu", (unsigned long)input->position);
+                        result = __FAILURE__;
+                        break;
+                    }
+
+                    input->position++;
+                }
+
+                if (parse_value(input, writer, depth + 1) != 0)
+                {
+                    result = __FAILURE__;
+                    break;
+                }
+
+                skip_whitespace(input);
+                if ((input->position < input->length) &&
+                    (input->json[input->position] == ','))
+                {
+                    input->position++;
+                }
+                else if ((input->position < input->length) &&
+                    (input->json[input->position] == closing_char))
+                {
+                    input->position++;
+                    result = 0;
+                    break;
+                }
+                else
+                {
+                    LogError("Expected ',' or '%c' at character %lu", closing_char, (unsigned long)input->position);
+                    result = __FAILURE__;
+                    break;
+                }
+            }
+        }
+
+        if ((result == 0) &&
+            (amqp_writer_end(writer) != 0))
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+static int parse_value(JSON_INPUT* input, AMQP_WRITER* writer, size_t depth)
+{
+    int result;
+
+    skip_whitespace(input);
+    if (input->position >= input->length)
+    {
+        /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+        LogError("JSON text ended where a value was expected");
+        result = __FAILURE__;
+    }
+    else
+    {
+        char c = input->json[input->position];
+
+        switch (c)
+        {
+        case '{':
+            result = parse_container(input, writer, depth, true);
+            break;
+        case '[':
+            result = parse_container(input, writer, depth, false);
+            break;
+        case '"':
+            result = parse_string(input, writer);
+            break;
+
+        /* Codes_SRS_AMQP_JSON_01_023: [ `true` and `false` shall be written as booleans and `null` as null. ]*/
+        case 't':
+            result = ((parse_literal(input, "true", 4) != 0) || (amqp_writer_put_boolean(writer, true) != 0)) ? __FAILURE__ : 0;
+            break;
+        case 'f':
+            result = ((parse_literal(input, "false", 5) != 0) || (amqp_writer_put_boolean(writer, false) != 0)) ? __FAILURE__ : 0;
+            break;
+        case 'n':
+            result = ((parse_literal(input, "null", 4) != 0) || (amqp_writer_put_null(writer) != 0)) ? __FAILURE__ : 0;
+            break;
+
+        default:
+            if ((c == '-') ||
+                ((c >= '0') && (c <= '9')))
+            {
+                result = parse_number(input, writer);
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+                LogError("Invalid JSON at character %lu", (unsigned long)input->position);
+                result = __FAILURE__;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+int amqp_json_to_amqp(const char* json, size_t json_length, unsigned char* buffer, size_t buffer_size, size_t* encoded_length)
+{
+    int result;
+
+    if ((json == NULL) ||
+        (buffer == NULL) ||
+        (encoded_length == NULL))
+    {
+        /* Codes_SRS_AMQP_JSON_01_017: [ If `json`, `buffer` or `encoded_length` is NULL, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: json = %p, buffer = %p, encoded_length = %p",
+            json, buffer, encoded_length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_WRITER writer;
+        JSON_INPUT input;
+
+        input.json = json;
+        input.length = json_length;
+        input.position = 0;
+        input.unescaped = NULL;
+        input.unescaped_size = 0;
+
+        if ((amqp_writer_init(&writer, buffer, buffer_size) != 0) ||
+            (parse_value(&input, &writer, 0) != 0))
+        {
+            LogError("Cannot write JSON as AMQP");
+            result = __FAILURE__;
+        }
+        else
+        {
+            skip_whitespace(&input);
+            if (input.position != input.length)
+            {
+                /* Codes_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+                LogError("Characters found after the JSON value at character %lu", (unsigned long)input.position);
+                result = __FAILURE__;
+            }
+            /* Codes_SRS_AMQP_JSON_01_027: [ If the encoding does not fit in `buffer_size` bytes, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+            else if (amqp_writer_get_length(&writer, encoded_length) != 0)
+            {
+                LogError("Cannot get the length of the AMQP encoding");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_JSON_01_016: [ `amqp_json_to_amqp` shall write the AMQP encoding of the JSON value in `json` to `buffer` with the AMQP writer, set `encoded_length` to its number of bytes and return 0. ]*/
+                result = 0;
+            }
+        }
+
+        if (input.unescaped != NULL)
+        {
+            free(input.unescaped);
+        }
+    }
+
+    return result;
+}
@@ -10,24 +10,41 @@
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/amqp_management.h"
 #include "azure_uamqp_c/link.h"
 #include "azure_uamqp_c/message_sender.h"
 #include "azure_uamqp_c/message_receiver.h"
 #include "azure_uamqp_c/messaging.h"
 #include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/async_operation.h"
+#include "azure_uamqp_c/timer_wheel.h"
 
 static const char sender_suffix[] = "-sender";
 static const char receiver_suffix[] = "-receiver";
 
 #define COUNT_CHARS(str) (sizeof(str) / sizeof((str)[0]) - 1)
 
+/* pending operations are indexed by message id in a ring whose size is a power of 2, message ids are increasing so
+   the ring only has to grow when the outstanding operations span more ids than it holds */
+#define INITIAL_PENDING_OPERATION_INDEX_SIZE 16
+#define MAX_PENDING_OPERATION_INDEX_SIZE 65536
+
 typedef struct OPERATION_MESSAGE_INSTANCE_TAG
 {
     ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete;
     void* callback_context;
     uint64_t message_id;
     AMQP_MANAGEMENT_HANDLE amqp_management;
+    /* the request while the operation waits for room in the outstanding operations window */
+    MESSAGE_HANDLE queued_message;
+    /* the application properties of a queued prepared operation */
+    MESSAGE_TEMPLATE_HANDLE queued_message_template;
+    LIST_ITEM_HANDLE queued_list_item;
+    ASYNC_OPERATION_HANDLE send_operation;
+    TIMER_WHEEL_TIMER_HANDLE timer;
+    bool is_send_complete;
+    bool is_timed_out;
 } OPERATION_MESSAGE_INSTANCE;
 
 typedef enum AMQP_MANAGEMENT_STATE_TAG
@@ -46,7 +63,17 @@ typedef struct AMQP_MANAGEMENT_INSTANCE_TAG
     MESSAGE_SENDER_HANDLE message_sender;
     MESSAGE_RECEIVER_HANDLE message_receiver;
     SINGLYLINKEDLIST_HANDLE pending_operations;
+    LIST_ITEM_HANDLE* pending_operation_index;
+    size_t pending_operation_index_size;
+    size_t unindexed_operation_count;
     uint64_t next_message_id;
+    /* operations submitted while max_outstanding_operations are pending, sent in order as pending ones complete */
+    SINGLYLINKEDLIST_HANDLE queued_operations;
+    size_t max_outstanding_operations;
+    size_t outstanding_operation_count;
+    TIMER_WHEEL_HANDLE timer_wheel;
+    TICK_COUNTER_HANDLE tick_counter;
+    uint32_t operation_timeout_ms;
     ON_AMQP_MANAGEMENT_OPEN_COMPLETE on_amqp_management_open_complete;
     void* on_amqp_management_open_complete_context;
     ON_AMQP_MANAGEMENT_ERROR on_amqp_management_error;
@@ -54,10 +81,431 @@ typedef struct AMQP_MANAGEMENT_INSTANCE_TAG
     AMQP_MANAGEMENT_STATE amqp_management_state;
     char* status_code_key_name;
     char* status_description_key_name;
+    /* built from the key names on the first response and kept until the names change */
+    AMQP_VALUE status_code_key;
+    AMQP_VALUE status_description_key;
     int sender_connected : 1;
     int receiver_connected : 1;
 } AMQP_MANAGEMENT_INSTANCE;
 
+typedef struct AMQP_MANAGEMENT_PREPARED_OPERATION_INSTANCE_TAG
+{
+    /* the application properties of the requests, encoded once */
+    MESSAGE_TEMPLATE_HANDLE message_template;
+    /* the same application properties, merged into requests that have application properties of their own */
+    AMQP_VALUE application_properties;
+} AMQP_MANAGEMENT_PREPARED_OPERATION_INSTANCE;
+
+static void index_pending_operation(AMQP_MANAGEMENT_HANDLE amqp_management, uint64_t message_id, LIST_ITEM_HANDLE list_item_handle)
+{
+    size_t slot = (size_t)(message_id & (amqp_management->pending_operation_index_size - 1));
+
+    if (amqp_management->pending_operation_index[slot] == NULL)
+    {
+        amqp_management->pending_operation_index[slot] = list_item_handle;
+    }
+    else
+    {
+        LIST_ITEM_HANDLE* new_index = NULL;
+        size_t new_size = amqp_management->pending_operation_index_size;
+
+        /* an older operation still holds the slot, double the ring until all outstanding ids fit */
+        while ((new_index == NULL) &&
+            (new_size < MAX_PENDING_OPERATION_INDEX_SIZE))
+        {
+            new_size *= 2;
+            new_index = (LIST_ITEM_HANDLE*)malloc(new_size * sizeof(LIST_ITEM_HANDLE));
+            if (new_index == NULL)
+            {
+                LogError("Cannot allocate memory for the pending operation index");
+                break;
+            }
+            else
+            {
+                size_t i;
+
+                (void)memset(new_index, 0, new_size * sizeof(LIST_ITEM_HANDLE));
+                new_index[message_id & (new_size - 1)] = list_item_handle;
+
+                for (i = 0; i < amqp_management->pending_operation_index_size; i++)
+                {
+                    if (amqp_management->pending_operation_index[i] != NULL)
+                    {
+                        OPERATION_MESSAGE_INSTANCE* operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value(amqp_management->pending_operation_index[i]);
+                        size_t new_slot = (size_t)(operation_message->message_id & (new_size - 1));
+                        if (new_index[new_slot] != NULL)
+                        {
+                            break;
+                        }
+
+                        new_index[new_slot] = amqp_management->pending_operation_index[i];
+                    }
+                }
+
+                if (i < amqp_management->pending_operation_index_size)
+                {
+                    free(new_index);
+                    new_index = NULL;
+                }
+            }
+        }
+
+        if (new_index == NULL)
+        {
+            /* the operation is still found by scanning the pending operations list */
+            amqp_management->unindexed_operation_count++;
+        }
+        else
+        {
+            free(amqp_management->pending_operation_index);
+            amqp_management->pending_operation_index = new_index;
+            amqp_management->pending_operation_index_size = new_size;
+        }
+    }
+}
+
+static void unindex_pending_operation(AMQP_MANAGEMENT_HANDLE amqp_management, uint64_t message_id, LIST_ITEM_HANDLE list_item_handle)
+{
+    size_t slot = (size_t)(message_id & (amqp_management->pending_operation_index_size - 1));
+
+    if (amqp_management->pending_operation_index[slot] == list_item_handle)
+    {
+        amqp_management->pending_operation_index[slot] = NULL;
+    }
+    else
+    {
+        amqp_management->unindexed_operation_count--;
+    }
+}
+
+static int find_pending_operation(AMQP_MANAGEMENT_HANDLE amqp_management, uint64_t correlation_id, LIST_ITEM_HANDLE* found_list_item_handle, OPERATION_MESSAGE_INSTANCE** found_operation_message)
+{
+    int result;
+    LIST_ITEM_HANDLE list_item_handle = amqp_management->pending_operation_index[correlation_id & (amqp_management->pending_operation_index_size - 1)];
+
+    *found_list_item_handle = NULL;
+    *found_operation_message = NULL;
+
+    if (list_item_handle != NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_116: [ Each pending operation item value shall be obtained by calling `singlylinkedlist_item_get_value`. ]*/
+        OPERATION_MESSAGE_INSTANCE* operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value(list_item_handle);
+        if (operation_message == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_117: [ If iterating through the pending operations list fails, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
+            LogError("Cannot obtain pending operation");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_112: [ `on_message_received` shall check if the correlation Id matches the stored message Id of any pending operation. ]*/
+            /* Codes_SRS_AMQP_MANAGEMENT_01_068: [ The correlation-id of the response message MUST be the correlation-id from the request message (if present) ]*/
+            /* Codes_SRS_AMQP_MANAGEMENT_01_069: [ else the message-id from the request message. ]*/
+            if (operation_message->message_id == correlation_id)
+            {
+                *found_list_item_handle = list_item_handle;
+                *found_operation_message = operation_message;
+            }
+
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if ((result == 0) &&
+        (*found_list_item_handle == NULL) &&
+        (amqp_management->unindexed_operation_count > 0))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_115: [ The pending operation shall be looked up by correlation Id in the pending operations index. Only when operations that did not fit in the index are pending and the index has no match, iterating through the pending operations shall be done by using `singlylinkedlist_get_head_item` and `singlylinkedlist_get_next_item` until the end of the pending operations singly linked list is reached. ]*/
+        list_item_handle = singlylinkedlist_get_head_item(amqp_management->pending_operations);
+        while (list_item_handle != NULL)
+        {
+            OPERATION_MESSAGE_INSTANCE* operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value(list_item_handle);
+            if (operation_message == NULL)
+            {
+                LogError("Cannot obtain pending operation");
+                result = __FAILURE__;
+                break;
+            }
+            else if (operation_message->message_id == correlation_id)
+            {
+                *found_list_item_handle = list_item_handle;
+                *found_operation_message = operation_message;
+                break;
+            }
+
+            list_item_handle = singlylinkedlist_get_next_item(list_item_handle);
+        }
+    }
+
+    return result;
+}
+
+static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result);
+
+static void complete_operation(OPERATION_MESSAGE_INSTANCE* operation_message, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result)
+{
+    operation_message->on_execute_operation_complete(operation_message->callback_context, execute_operation_result, 0, NULL, NULL);
+
+    if (operation_message->timer != NULL)
+    {
+        timer_wheel_destroy_timer(operation_message->timer);
+    }
+
+    free(operation_message);
+}
+
+static int send_operation_message(AMQP_MANAGEMENT_HANDLE amqp_management, OPERATION_MESSAGE_INSTANCE* operation_message, MESSAGE_HANDLE message, MESSAGE_TEMPLATE_HANDLE message_template)
+{
+    int result;
+
+    /* Codes_SRS_AMQP_MANAGEMENT_01_091: [ Once the request message has been sent, an entry shall be stored in the pending operations list by calling `singlylinkedlist_add`. ]*/
+    LIST_ITEM_HANDLE added_item = singlylinkedlist_add(amqp_management->pending_operations, operation_message);
+    if (added_item == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_092: [ If `singlylinkedlist_add` fails then `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Could not add the operation to the pending operations list.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        ASYNC_OPERATION_HANDLE send_operation;
+
+        index_pending_operation(amqp_management, operation_message->message_id, added_item);
+        amqp_management->outstanding_operation_count++;
+        operation_message->is_send_complete = false;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_01_088: [ `amqp_management_execute_operation_async` shall send the message by calling `messagesender_send_async`. ]*/
+        /* Codes_SRS_AMQP_MANAGEMENT_01_166: [ The `on_message_send_complete` callback shall be passed to the `messagesender_send_async` call. ]*/
+        if (message_template == NULL)
+        {
+            send_operation = messagesender_send_async(amqp_management->message_sender, message, on_message_send_complete, added_item, 0);
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_220: [ Such a request, whether sent right away or from the queue, shall be sent by calling `messagesender_send_from_template_async` with the message template of the prepared operation instead of `messagesender_send_async`, so that only its properties and body are encoded. ]*/
+            send_operation = messagesender_send_from_template_async(amqp_management->message_sender, message_template, message, on_message_send_complete, added_item, 0);
+        }
+        if (send_operation == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_089: [ If `messagesender_send_async` fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+            LogError("Could not send request message");
+            unindex_pending_operation(amqp_management, operation_message->message_id, added_item);
+            amqp_management->outstanding_operation_count--;
+            (void)singlylinkedlist_remove(amqp_management->pending_operations, added_item);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* a send settled before messagesender_send_async returns has already released its handle */
+            if (!operation_message->is_send_complete)
+            {
+                operation_message->send_operation = send_operation;
+            }
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int queue_operation_message(AMQP_MANAGEMENT_HANDLE amqp_management, OPERATION_MESSAGE_INSTANCE* operation_message, MESSAGE_HANDLE message, MESSAGE_TEMPLATE_HANDLE message_template)
+{
+    int result;
+
+    /* Codes_SRS_AMQP_MANAGEMENT_01_188: [ If `max_outstanding_operations` operations are already pending, `amqp_management_execute_operation_async` shall clone the request message by calling `message_clone` and add the operation to a queue by calling `singlylinkedlist_add` instead of sending it. ]*/
+    operation_message->queued_message = message_clone(message);
+    if (operation_message->queued_message == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_189: [ If queueing the operation fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Could not clone the request message for queueing it");
+        result = __FAILURE__;
+    }
+    else if ((operation_message->queued_list_item = singlylinkedlist_add(amqp_management->queued_operations, operation_message)) == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_189: [ If queueing the operation fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Could not add the operation to the queued operations list.");
+        message_destroy(operation_message->queued_message);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_215: [ A queued request of a prepared operation shall hold its own reference to the message template, obtained with `messagesender_clone_message_template`, so that the prepared operation can be destroyed while the request is queued. ]*/
+        operation_message->queued_message_template = (message_template == NULL) ? NULL : messagesender_clone_message_template(message_template);
+        result = 0;
+    }
+
+    return result;
+}
+
+static void release_queued_message(OPERATION_MESSAGE_INSTANCE* operation_message)
+{
+    message_destroy(operation_message->queued_message);
+    operation_message->queued_message = NULL;
+
+    if (operation_message->queued_message_template != NULL)
+    {
+        messagesender_destroy_message_template(operation_message->queued_message_template);
+        operation_message->queued_message_template = NULL;
+    }
+}
+
+static void dispatch_queued_operations(AMQP_MANAGEMENT_HANDLE amqp_management)
+{
+    /* operations still queued when closing are completed by amqp_management_close */
+    if ((amqp_management->queued_operations != NULL) &&
+        (amqp_management->amqp_management_state != AMQP_MANAGEMENT_STATE_CLOSING))
+    {
+        LIST_ITEM_HANDLE list_item_handle;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_01_192: [ Whenever a pending operation completes, queued operations shall be sent in the order they were started until `max_outstanding_operations` operations are pending again. ]*/
+        while (((amqp_management->max_outstanding_operations == 0) ||
+            (amqp_management->outstanding_operation_count < amqp_management->max_outstanding_operations)) &&
+            ((list_item_handle = singlylinkedlist_get_head_item(amqp_management->queued_operations)) != NULL))
+        {
+            OPERATION_MESSAGE_INSTANCE* operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value(list_item_handle);
+            if (singlylinkedlist_remove(amqp_management->queued_operations, list_item_handle) != 0)
+            {
+                LogError("Cannot remove queued operation");
+                break;
+            }
+            else if (operation_message == NULL)
+            {
+                LogError("Cannot obtain queued operation");
+            }
+            else
+            {
+                MESSAGE_HANDLE queued_message = operation_message->queued_message;
+                MESSAGE_TEMPLATE_HANDLE queued_message_template = operation_message->queued_message_template;
+
+                operation_message->queued_message = NULL;
+                operation_message->queued_message_template = NULL;
+                operation_message->queued_list_item = NULL;
+
+                if (send_operation_message(amqp_management, operation_message, queued_message, queued_message_template) != 0)
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_01_193: [ If sending a queued operation fails, its callback shall be called with `AMQP_MANAGEMENT_EXECUTE_OPERATION_ERROR`. ]*/
+                    LogError("Could not send queued request message");
+                    complete_operation(operation_message, AMQP_MANAGEMENT_EXECUTE_OPERATION_ERROR);
+                }
+
+                message_destroy(queued_message);
+                if (queued_message_template != NULL)
+                {
+                    messagesender_destroy_message_template(queued_message_template);
+                }
+            }
+        }
+    }
+}
+
+static void on_operation_timeout(void* context)
+{
+    OPERATION_MESSAGE_INSTANCE* operation_message = (OPERATION_MESSAGE_INSTANCE*)context;
+    AMQP_MANAGEMENT_HANDLE amqp_management = operation_message->amqp_management;
+
+    LogError("AMQP management operation timed out");
+
+    timer_wheel_destroy_timer(operation_message->timer);
+    operation_message->timer = NULL;
+    operation_message->is_timed_out = true;
+
+    if (operation_message->queued_message != NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_194: [ When the timeout of a queued operation expires, the operation shall be removed from the queue and its callback shall be called with `AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT`. ]*/
+        if (singlylinkedlist_remove(amqp_management->queued_operations, operation_message->queued_list_item) != 0)
+        {
+            LogError("Cannot remove queued operation");
+        }
+        else
+        {
+            release_queued_message(operation_message);
+            complete_operation(operation_message, AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT);
+        }
+    }
+    else if (operation_message->send_operation != NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_195: [ When the timeout of an operation whose request is still being sent expires, the send shall be cancelled by calling `async_operation_cancel` and the operation shall be completed with `AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT` from the resulting `on_message_send_complete`. ]*/
+        if (async_operation_cancel(operation_message->send_operation) != 0)
+        {
+            LogError("Cannot cancel the request send");
+        }
+    }
+    else
+    {
+        LIST_ITEM_HANDLE list_item_handle;
+        OPERATION_MESSAGE_INSTANCE* found_operation_message;
+
+        if ((find_pending_operation(amqp_management, operation_message->message_id, &list_item_handle, &found_operation_message) != 0) ||
+            (list_item_handle == NULL))
+        {
+            LogError("Cannot find the timed out pending operation");
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_196: [ When the timeout of an operation waiting for its response expires, the operation shall be removed from the pending operations and its callback shall be called with `AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT`. ]*/
+            unindex_pending_operation(amqp_management, operation_message->message_id, list_item_handle);
+            if (singlylinkedlist_remove(amqp_management->pending_operations, list_item_handle) != 0)
+            {
+                LogError("Cannot remove pending operation");
+                amqp_management->on_amqp_management_error(amqp_management->on_amqp_management_error_context);
+            }
+            else
+            {
+                amqp_management->outstanding_operation_count--;
+                complete_operation(operation_message, AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT);
+                dispatch_queued_operations(amqp_management);
+            }
+        }
+    }
+}
+
+static int start_operation_timer(AMQP_MANAGEMENT_HANDLE amqp_management, OPERATION_MESSAGE_INSTANCE* operation_message)
+{
+    int result;
+
+    if (amqp_management->operation_timeout_ms == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        tickcounter_ms_t current_ms;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_01_190: [ When an operation timeout is set, `amqp_management_execute_operation_async` shall create a timer on the timer wheel by calling `timer_wheel_create_timer` and start it by calling `timer_wheel_start_timer` with a deadline `operation_timeout_ms` after the current time of the tick counter. ]*/
+        if (tickcounter_get_current_ms(amqp_management->tick_counter, &current_ms) != 0)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_191: [ If creating or starting the timer fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot get the current time");
+            result = __FAILURE__;
+        }
+        else if ((operation_message->timer = timer_wheel_create_timer(amqp_management->timer_wheel, on_operation_timeout, operation_message)) == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_191: [ If creating or starting the timer fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot create the operation timer");
+            result = __FAILURE__;
+        }
+        else if (timer_wheel_start_timer(operation_message->timer, (uint64_t)current_ms + amqp_management->operation_timeout_ms) != 0)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_191: [ If creating or starting the timer fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot start the operation timer");
+            timer_wheel_destroy_timer(operation_message->timer);
+            operation_message->timer = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
 {
     AMQP_VALUE result;
@@ -139,9 +587,14 @@ static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE messag
                         }
                         else
                         {
-                            /* Codes_SRS_AMQP_MANAGEMENT_01_120: [ An AMQP value used to lookup the status code shall be created by calling `amqpvalue_create_string` with the status code key name (`statusCode`) as argument. ]*/
+                            /* Codes_SRS_AMQP_MANAGEMENT_01_120: [ An AMQP value used to lookup the status code shall be created by calling `amqpvalue_create_string` with the status code key name (`statusCode`) as argument. The value shall be created on the first response and reused until the status code key name is changed. ]*/
                             /* Codes_SRS_AMQP_MANAGEMENT_01_071: [ statusCode integer Yes HTTP response code [RFC2616] ]*/
-                            key = amqpvalue_create_string(amqp_management->status_code_key_name);
+                            if (amqp_management->status_code_key == NULL)
+                            {
+                                amqp_management->status_code_key = amqpvalue_create_string(amqp_management->status_code_key_name);
+                            }
+
+                            key = amqp_management->status_code_key;
                             if (key == NULL)
                             {
                                 /* Codes_SRS_AMQP_MANAGEMENT_01_132: [ If any functions manipulating AMQP values, application properties, etc., fail, an error shall be indicated to the consumer by calling the `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
@@ -176,9 +629,14 @@ static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE messag
                                     }
                                     else
                                     {
-                                        /* Codes_SRS_AMQP_MANAGEMENT_01_123: [ An AMQP value used to lookup the status description shall be created by calling `amqpvalue_create_string` with the status description key name (`statusDescription`) as argument. ]*/
+                                        /* Codes_SRS_AMQP_MANAGEMENT_01_123: [ An AMQP value used to lookup the status description shall be created by calling `amqpvalue_create_string` with the status description key name (`statusDescription`) as argument. The value shall be created on the first response and reused until the status description key name is changed. ]*/
                                         /* Codes_SRS_AMQP_MANAGEMENT_01_072: [ statusDescription string No Description of the status. ]*/
-                                        desc_key = amqpvalue_create_string(amqp_management->status_description_key_name);
+                                        if (amqp_management->status_description_key == NULL)
+                                        {
+                                            amqp_management->status_description_key = amqpvalue_create_string(amqp_management->status_description_key_name);
+                                        }
+
+                                        desc_key = amqp_management->status_description_key;
                                         if (desc_key == NULL)
                                         {
                                             /* Codes_SRS_AMQP_MANAGEMENT_01_132: [ If any functions manipulating AMQP values, application properties, etc., fail, an error shall be indicated to the consumer by calling the `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
@@ -191,8 +649,7 @@ static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE messag
                                         {
                                             const char* status_description = NULL;
                                             LIST_ITEM_HANDLE list_item_handle;
-                                            bool found = false;
-                                            bool is_error = false;
+                                            OPERATION_MESSAGE_INSTANCE* operation_message;
 
                                             /* Codes_SRS_AMQP_MANAGEMENT_01_124: [ The status description shall be looked up in the application properties by using `amqpvalue_get_map_value`. ]*/
                                             desc_value = amqpvalue_get_map_value(map, desc_key);
@@ -211,120 +668,99 @@ static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE messag
                                                 status_description = NULL;
                                             }
 
-                                            list_item_handle = singlylinkedlist_get_head_item(amqp_management->pending_operations);
-                                            while (list_item_handle != NULL)
+                                            if (find_pending_operation(amqp_management, correlation_id, &list_item_handle, &operation_message) != 0)
                                             {
-                                                /* Codes_SRS_AMQP_MANAGEMENT_01_116: [ Each pending operation item value shall be obtained by calling `singlylinkedlist_item_get_value`. ]*/
-                                                OPERATION_MESSAGE_INSTANCE* operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value(list_item_handle);
-                                                if (operation_message == NULL)
-                                                {
-                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_117: [ If iterating through the pending operations list fails, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
-                                                    LogError("Could not create status-description amqp value");
-                                                    amqp_management->on_amqp_management_error(amqp_management->on_amqp_management_error_context);
-                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_135: [ When an error occurs in creating AMQP values (for status code, etc.) `on_message_received` shall call `messaging_delivery_released` and return the created delivery AMQP value. ]*/
-                                                    result = messaging_delivery_released();
-                                                    break;
-                                                }
-                                                else
-                                                {
-                                                    AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result;
-
-                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_112: [ `on_message_received` shall check if the correlation Id matches the stored message Id of any pending operation. ]*/
-                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_068: [ The correlation-id of the response message MUST be the correlation-id from the request message (if present) ]*/
-                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_069: [ else the message-id from the request message. ]*/
-                                                    if (correlation_id == operation_message->message_id)
-                                                    {
-                                                        /* Codes_SRS_AMQP_MANAGEMENT_01_074: [ Successful operations MUST result in a statusCode in the 2xx range as defined in Section 10.2 of [RFC2616]. ]*/
-                                                        if ((status_code < 200) || (status_code > 299))
-                                                        {
-                                                            /* Codes_SRS_AMQP_MANAGEMENT_01_128: [ If the status indicates that the operation failed, the result callback argument shall be `AMQP_MANAGEMENT_EXECUTE_OPERATION_FAILED_BAD_STATUS`. ]*/
-                                                            /* Codes_SRS_AMQP_MANAGEMENT_01_075: [ Unsuccessful operations MUST NOT result in a statusCode in the 2xx range as defined in Section 10.2 of [RFC2616]. ]*/
-                                                            execute_operation_result = AMQP_MANAGEMENT_EXECUTE_OPERATION_FAILED_BAD_STATUS;
-                                                        }
-                                                        else
-                                                        {
-                                                            /* Codes_SRS_AMQP_MANAGEMENT_01_127: [ If the operation succeeded the result callback argument shall be `AMQP_MANAGEMENT_EXECUTE_OPERATION_OK`. ]*/
-                                                            execute_operation_result = AMQP_MANAGEMENT_EXECUTE_OPERATION_OK;
-                                                        }
-
-                                                        /* Codes_SRS_AMQP_MANAGEMENT_01_126: [ If a corresponding correlation Id is found in the pending operations list, the callback associated with the pending operation shall be called. ]*/
-                                                        /* Codes_SRS_AMQP_MANAGEMENT_01_166: [ The `message` shall be passed as argument to the callback. ]*/
-                                                        operation_message->on_execute_operation_complete(operation_message->callback_context, execute_operation_result, status_code, status_description, message);
-
-                                                        free(operation_message);
-
-                                                        /* Codes_SRS_AMQP_MANAGEMENT_01_129: [ After calling the callback, the pending operation shall be removed from the pending operations list by calling `singlylinkedlist_remove`. ]*/
-                                                        if (singlylinkedlist_remove(amqp_management->pending_operations, list_item_handle) != 0)
-                                                        {
-                                                            LogError("Cannot remove pending operation");
-                                                            is_error = true;
-                                                            break;
-                                                        }
-                                                        else
-                                                        {
-                                                            found = true;
-                                                        }
-
-                                                        break;
-                                                    }
-                                                }
-
-                                                /* Codes_SRS_AMQP_MANAGEMENT_01_115: [ Iterating through the pending operations shall be done by using `singlylinkedlist_get_head_item` and `singlylinkedlist_get_next_item` until the enm of the pending operations singly linked list is reached. ]*/
                                                 /* Codes_SRS_AMQP_MANAGEMENT_01_117: [ If iterating through the pending operations list fails, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
-                                                list_item_handle = singlylinkedlist_get_next_item(list_item_handle);
+                                                amqp_management->on_amqp_management_error(amqp_management->on_amqp_management_error_context);
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_135: [ When an error occurs in creating AMQP values (for status code, etc.) `on_message_received` shall call `messaging_delivery_released` and return the created delivery AMQP value. ]*/
+                                                result = messaging_delivery_released();
                                             }
-
-                                            if (is_error)
+                                            else if ((list_item_handle == NULL) &&
+                                                (amqp_management->operation_timeout_ms != 0) &&
+                                                (correlation_id < amqp_management->next_message_id))
                                             {
-                                                /* Codes_SRS_AMQP_MANAGEMENT_01_117: [ If iterating through the pending operations list fails, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_197: [ When an operation timeout is set and no pending operation matches a correlation Id that was already used for a request, the response shall be considered as arriving after the operation timed out: no error shall be indicated and `on_message_received` shall call `messaging_delivery_accepted` and return the created delivery AMQP value. ]*/
+                                                LogInfo("Dropping AMQP management response arriving after its operation timed out");
+                                                result = messaging_delivery_accepted();
+                                            }
+                                            else if (list_item_handle == NULL)
+                                            {
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_118: [ If no pending operation is found matching the correlation Id, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
+                                                LogError("Could not match AMQP management response to request");
                                                 amqp_management->on_amqp_management_error(amqp_management->on_amqp_management_error_context);
                                                 /* Codes_SRS_AMQP_MANAGEMENT_01_135: [ When an error occurs in creating AMQP values (for status code, etc.) `on_message_received` shall call `messaging_delivery_released` and return the created delivery AMQP value. ]*/
-                                                result = messaging_delivery_released();
+                                                result = messaging_delivery_rejected("amqp:internal-error", "Could not match AMQP management response to request");
                                             }
                                             else
                                             {
-                                                if (!found)
+                                                AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result;
+
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_074: [ Successful operations MUST result in a statusCode in the 2xx range as defined in Section 10.2 of [RFC2616]. ]*/
+                                                if ((status_code < 200) || (status_code > 299))
                                                 {
-                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_118: [ If no pending operation is found matching the correlation Id, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
-                                                    LogError("Could not match AMQP management response to request");
+                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_128: [ If the status indicates that the operation failed, the result callback argument shall be `AMQP_MANAGEMENT_EXECUTE_OPERATION_FAILED_BAD_STATUS`. ]*/
+                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_075: [ Unsuccessful operations MUST NOT result in a statusCode in the 2xx range as defined in Section 10.2 of [RFC2616]. ]*/
+                                                    execute_operation_result = AMQP_MANAGEMENT_EXECUTE_OPERATION_FAILED_BAD_STATUS;
+                                                }
+                                                else
+                                                {
+                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_127: [ If the operation succeeded the result callback argument shall be `AMQP_MANAGEMENT_EXECUTE_OPERATION_OK`. ]*/
+                                                    execute_operation_result = AMQP_MANAGEMENT_EXECUTE_OPERATION_OK;
+                                                }
+
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_126: [ If a corresponding correlation Id is found in the pending operations list, the callback associated with the pending operation shall be called. ]*/
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_166: [ The `message` shall be passed as argument to the callback. ]*/
+                                                operation_message->on_execute_operation_complete(operation_message->callback_context, execute_operation_result, status_code, status_description, message);
+
+                                                unindex_pending_operation(amqp_management, operation_message->message_id, list_item_handle);
+                                                amqp_management->outstanding_operation_count--;
+                                                if (operation_message->timer != NULL)
+                                                {
+                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_198: [ The timer of an operation shall be destroyed by calling `timer_wheel_destroy_timer` when the operation completes. ]*/
+                                                    timer_wheel_destroy_timer(operation_message->timer);
+                                                }
+
+                                                free(operation_message);
+
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_129: [ After calling the callback, the pending operation shall be removed from the pending operations list by calling `singlylinkedlist_remove`. ]*/
+                                                if (singlylinkedlist_remove(amqp_management->pending_operations, list_item_handle) != 0)
+                                                {
+                                                    /* Codes_SRS_AMQP_MANAGEMENT_01_117: [ If iterating through the pending operations list fails, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
+                                                    LogError("Cannot remove pending operation");
                                                     amqp_management->on_amqp_management_error(amqp_management->on_amqp_management_error_context);
                                                     /* Codes_SRS_AMQP_MANAGEMENT_01_135: [ When an error occurs in creating AMQP values (for status code, etc.) `on_message_received` shall call `messaging_delivery_released` and return the created delivery AMQP value. ]*/
-                                                    result = messaging_delivery_rejected("amqp:internal-error", "Could not match AMQP management response to request");
+                                                    result = messaging_delivery_released();
                                                 }
                                                 else
                                                 {
                                                     /* Codes_SRS_AMQP_MANAGEMENT_01_130: [ The `on_message_received` shall call `messaging_delivery_accepted` and return the created delivery AMQP value. ]*/
                                                     result = messaging_delivery_accepted();
                                                 }
+
+                                                dispatch_queued_operations(amqp_management);
                                             }
 
                                             if (desc_value != NULL)
                                             {
-                                                /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like AMQP values used as keys shall be freed before exiting the callback. ]*/
+                                                /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like the AMQP values obtained from the response shall be freed before exiting the callback. ]*/
                                                 amqpvalue_destroy(desc_value);
                                             }
-
-                                            /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like AMQP values used as keys shall be freed before exiting the callback. ]*/
-                                            amqpvalue_destroy(desc_key);
                                         }
                                     }
 
-                                    /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like AMQP values used as keys shall be freed before exiting the callback. ]*/
+                                    /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like the AMQP values obtained from the response shall be freed before exiting the callback. ]*/
                                     amqpvalue_destroy(value);
                                 }
-
-                                /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like AMQP values used as keys shall be freed before exiting the callback. ]*/
-                                amqpvalue_destroy(key);
                             }
                         }
                     }
                 }
 
-                /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like AMQP values used as keys shall be freed before exiting the callback. ]*/
+                /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like the AMQP values obtained from the response shall be freed before exiting the callback. ]*/
                 properties_destroy(response_properties);
             }
 
-            /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like AMQP values used as keys shall be freed before exiting the callback. ]*/
+            /* Codes_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like the AMQP values obtained from the response shall be freed before exiting the callback. ]*/
             application_properties_destroy(application_properties);
         }
     }
@@ -344,6 +780,17 @@ static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_res
         if (send_result == MESSAGE_SEND_OK)
         {
             /* Codes_SRS_AMQP_MANAGEMENT_01_170: [ If `send_result` is `MESSAGE_SEND_OK`, `on_message_send_complete` shall return. ]*/
+            /* Codes_SRS_AMQP_MANAGEMENT_01_199: [ If `send_result` is `MESSAGE_SEND_OK`, `on_message_send_complete` shall obtain the pending operation by calling `singlylinkedlist_item_get_value` and mark its request as sent, so that a timeout no longer cancels the send. ]*/
+            OPERATION_MESSAGE_INSTANCE* pending_operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value((LIST_ITEM_HANDLE)context);
+            if (pending_operation_message == NULL)
+            {
+                LogError("Cannot obtain pending operation");
+            }
+            else
+            {
+                pending_operation_message->is_send_complete = true;
+                pending_operation_message->send_operation = NULL;
+            }
         }
         else
         {
@@ -355,6 +802,10 @@ static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_res
             OPERATION_MESSAGE_INSTANCE* pending_operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value(pending_operation_list_item_handle);
             AMQP_MANAGEMENT_HANDLE amqp_management = pending_operation_message->amqp_management;
 
+            unindex_pending_operation(amqp_management, pending_operation_message->message_id, pending_operation_list_item_handle);
+            pending_operation_message->is_send_complete = true;
+            pending_operation_message->send_operation = NULL;
+
             /* Codes_SRS_AMQP_MANAGEMENT_01_171: [ - `on_message_send_complete` shall removed the pending operation from the pending operations list. ]*/
             if (singlylinkedlist_remove(amqp_management->pending_operations, pending_operation_list_item_handle) != 0)
             {
@@ -364,9 +815,12 @@ static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_res
             }
             else
             {
+                amqp_management->outstanding_operation_count--;
+
                 /* Codes_SRS_AMQP_MANAGEMENT_01_173: [ - The callback associated with the pending operation shall be called with `AMQP_MANAGEMENT_EXECUTE_OPERATION_ERROR`. ]*/
-                pending_operation_message->on_execute_operation_complete(pending_operation_message->callback_context, AMQP_MANAGEMENT_EXECUTE_OPERATION_ERROR, 0, NULL, NULL);
-                free(pending_operation_message);
+                /* Codes_SRS_AMQP_MANAGEMENT_01_200: [ - If the send was cancelled because the operation timed out, the callback shall be called with `AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT` instead. ]*/
+                complete_operation(pending_operation_message, pending_operation_message->is_timed_out ? AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT : AMQP_MANAGEMENT_EXECUTE_OPERATION_ERROR);
+                dispatch_queued_operations(amqp_management);
             }
         }
     }
@@ -679,6 +1133,12 @@ static int internal_set_status_code_key_name(AMQP_MANAGEMENT_HANDLE amqp_managem
             free(amqp_management->status_code_key_name);
         }
 
+        if (amqp_management->status_code_key != NULL)
+        {
+            amqpvalue_destroy(amqp_management->status_code_key);
+            amqp_management->status_code_key = NULL;
+        }
+
         amqp_management->status_code_key_name = copied_status_code_key_name;
         result = 0;
     }
@@ -702,6 +1162,12 @@ static int internal_set_status_description_key_name(AMQP_MANAGEMENT_HANDLE amqp_
             free(amqp_management->status_description_key_name);
         }
 
+        if (amqp_management->status_description_key != NULL)
+        {
+            amqpvalue_destroy(amqp_management->status_description_key);
+            amqp_management->status_description_key = NULL;
+        }
+
         amqp_management->status_description_key_name = copied_status_description_key_name;
         result = 0;
     }
@@ -746,6 +1212,16 @@ AMQP_MANAGEMENT_HANDLE amqp_management_create(SESSION_HANDLE session, const char
             amqp_management->amqp_management_state = AMQP_MANAGEMENT_STATE_IDLE;
             amqp_management->status_code_key_name = NULL;
             amqp_management->status_description_key_name = NULL;
+            amqp_management->status_code_key = NULL;
+            amqp_management->status_description_key = NULL;
+            amqp_management->pending_operation_index_size = INITIAL_PENDING_OPERATION_INDEX_SIZE;
+            amqp_management->unindexed_operation_count = 0;
+            amqp_management->queued_operations = NULL;
+            amqp_management->max_outstanding_operations = 0;
+            amqp_management->outstanding_operation_count = 0;
+            amqp_management->timer_wheel = NULL;
+            amqp_management->tick_counter = NULL;
+            amqp_management->operation_timeout_ms = 0;
 
             /* Codes_SRS_AMQP_MANAGEMENT_01_003: [ `amqp_management_create` shall create a singly linked list for pending operations by calling `singlylinkedlist_create`. ]*/
             amqp_management->pending_operations = singlylinkedlist_create();
@@ -754,8 +1230,17 @@ AMQP_MANAGEMENT_HANDLE amqp_management_create(SESSION_HANDLE session, const char
                 /* Codes_SRS_AMQP_MANAGEMENT_01_004: [ If `singlylinkedlist_create` fails, `amqp_management_create` shall fail and return NULL. ]*/
                 LogError("Cannot create pending operations list");
             }
+            /* Codes_SRS_AMQP_MANAGEMENT_01_183: [ `amqp_management_create` shall allocate an index of the pending operations keyed by message Id. ]*/
+            else if ((amqp_management->pending_operation_index = (LIST_ITEM_HANDLE*)malloc(INITIAL_PENDING_OPERATION_INDEX_SIZE * sizeof(LIST_ITEM_HANDLE))) == NULL)
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_01_184: [ If allocating memory for the pending operations index fails, `amqp_management_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate memory for the pending operation index");
+                singlylinkedlist_destroy(amqp_management->pending_operations);
+            }
             else
             {
+                (void)memset(amqp_management->pending_operation_index, 0, INITIAL_PENDING_OPERATION_INDEX_SIZE * sizeof(LIST_ITEM_HANDLE));
+
                 /* Codes_SRS_AMQP_MANAGEMENT_01_181: [ `amqp_management_create` shall set the status code key name to be used for parsing the status code to `statusCode`. ]*/
                 if (internal_set_status_code_key_name(amqp_management, "statusCode") != 0)
                 {
@@ -899,6 +1384,7 @@ AMQP_MANAGEMENT_HANDLE amqp_management_create(SESSION_HANDLE session, const char
                     free(amqp_management->status_code_key_name);
                 }
 
+                free(amqp_management->pending_operation_index);
                 singlylinkedlist_destroy(amqp_management->pending_operations);
             }
 
@@ -935,6 +1421,22 @@ void amqp_management_destroy(AMQP_MANAGEMENT_HANDLE amqp_management)
         link_destroy(amqp_management->receiver_link);
         free(amqp_management->status_code_key_name);
         free(amqp_management->status_description_key_name);
+        if (amqp_management->status_code_key != NULL)
+        {
+            amqpvalue_destroy(amqp_management->status_code_key);
+        }
+
+        if (amqp_management->status_description_key != NULL)
+        {
+            amqpvalue_destroy(amqp_management->status_description_key);
+        }
+
+        free(amqp_management->pending_operation_index);
+        if (amqp_management->queued_operations != NULL)
+        {
+            singlylinkedlist_destroy(amqp_management->queued_operations);
+        }
+
         /* Codes_SRS_AMQP_MANAGEMENT_01_026: [ `amqp_management_destroy` shall free the singly linked list by calling `singlylinkedlist_destroy`. ]*/
         singlylinkedlist_destroy(amqp_management->pending_operations);
         free(amqp_management);
@@ -1059,8 +1561,7 @@ int amqp_management_close(AMQP_MANAGEMENT_HANDLE amqp_management)
                 else
                 {
                     /* Codes_SRS_AMQP_MANAGEMENT_01_054: [ All pending operations shall be indicated complete with the code `AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED`. ]*/
-                    operation_message->on_execute_operation_complete(operation_message->callback_context, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED, 0, NULL, NULL);
-                    free(operation_message);
+                    complete_operation(operation_message, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED);
                 }
                 
                 if (singlylinkedlist_remove(amqp_management->pending_operations, list_item_handle) != 0)
@@ -1071,6 +1572,37 @@ int amqp_management_close(AMQP_MANAGEMENT_HANDLE amqp_management)
                 list_item_handle = singlylinkedlist_get_head_item(amqp_management->pending_operations);
             }
 
+            (void)memset(amqp_management->pending_operation_index, 0, amqp_management->pending_operation_index_size * sizeof(LIST_ITEM_HANDLE));
+            amqp_management->unindexed_operation_count = 0;
+            amqp_management->outstanding_operation_count = 0;
+
+            if (amqp_management->queued_operations != NULL)
+            {
+                list_item_handle = singlylinkedlist_get_head_item(amqp_management->queued_operations);
+                while (list_item_handle != NULL)
+                {
+                    OPERATION_MESSAGE_INSTANCE* operation_message = (OPERATION_MESSAGE_INSTANCE*)singlylinkedlist_item_get_value(list_item_handle);
+
+                    if (singlylinkedlist_remove(amqp_management->queued_operations, list_item_handle) != 0)
+                    {
+                        LogError("Cannot remove queued operation");
+                        break;
+                    }
+                    else if (operation_message == NULL)
+                    {
+                        LogError("Cannot obtain queued operation");
+                    }
+                    else
+                    {
+                        /* Codes_SRS_AMQP_MANAGEMENT_01_201: [ All queued operations shall be indicated complete with the code `AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED`. ]*/
+                        release_queued_message(operation_message);
+                        complete_operation(operation_message, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED);
+                    }
+
+                    list_item_handle = singlylinkedlist_get_head_item(amqp_management->queued_operations);
+                }
+            }
+
             amqp_management->amqp_management_state = AMQP_MANAGEMENT_STATE_IDLE;
 
             /* Codes_SRS_AMQP_MANAGEMENT_01_046: [ On success it shall return 0. ]*/
@@ -1081,6 +1613,128 @@ int amqp_management_close(AMQP_MANAGEMENT_HANDLE amqp_management)
     return result;
 }
 
+static int merge_map_pairs(AMQP_VALUE target_map, AMQP_VALUE source_map)
+{
+    int result;
+    uint32_t pair_count;
+
+    if (amqpvalue_get_map_pair_count(source_map, &pair_count) != 0)
+    {
+        LogError("Could not get the prepared application properties count");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t i;
+
+        result = 0;
+
+        for (i = 0; i < pair_count; i++)
+        {
+            AMQP_VALUE key;
+            AMQP_VALUE value;
+
+            if (amqpvalue_get_map_key_value_pair(source_map, i, &key, &value) != 0)
+            {
+                LogError("Could not get prepared application property %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
+            }
+            else
+            {
+                if (amqpvalue_set_map_value(target_map, key, value) != 0)
+                {
+                    LogError("Could not set prepared application property %u", (unsigned int)i);
+                    result = __FAILURE__;
+                }
+
+                amqpvalue_destroy(key);
+                amqpvalue_destroy(value);
+
+                if (result != 0)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static int start_operation(AMQP_MANAGEMENT_HANDLE amqp_management, MESSAGE_HANDLE message, MESSAGE_TEMPLATE_HANDLE message_template, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* on_execute_operation_complete_context)
+{
+    int result;
+
+    if (set_message_id(message, amqp_management->next_message_id) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        OPERATION_MESSAGE_INSTANCE* pending_operation_message = (OPERATION_MESSAGE_INSTANCE*)malloc(sizeof(OPERATION_MESSAGE_INSTANCE));
+        if (pending_operation_message == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            pending_operation_message->callback_context = on_execute_operation_complete_context;
+            pending_operation_message->on_execute_operation_complete = on_execute_operation_complete;
+            pending_operation_message->message_id = amqp_management->next_message_id;
+            pending_operation_message->amqp_management = amqp_management;
+            pending_operation_message->queued_message = NULL;
+            pending_operation_message->queued_message_template = NULL;
+            pending_operation_message->queued_list_item = NULL;
+            pending_operation_message->send_operation = NULL;
+            pending_operation_message->timer = NULL;
+            pending_operation_message->is_send_complete = false;
+            pending_operation_message->is_timed_out = false;
+
+            if (start_operation_timer(amqp_management, pending_operation_message) != 0)
+            {
+                free(pending_operation_message);
+                result = __FAILURE__;
+            }
+            else
+            {
+                int start_result;
+
+                if ((amqp_management->max_outstanding_operations > 0) &&
+                    (amqp_management->outstanding_operation_count >= amqp_management->max_outstanding_operations))
+                {
+                    start_result = queue_operation_message(amqp_management, pending_operation_message, message, message_template);
+                }
+                else
+                {
+                    start_result = send_operation_message(amqp_management, pending_operation_message, message, message_template);
+                }
+
+                if (start_result != 0)
+                {
+                    if (pending_operation_message->timer != NULL)
+                    {
+                        timer_wheel_destroy_timer(pending_operation_message->timer);
+                    }
+
+                    free(pending_operation_message);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_01_107: [ The message Id set on the message properties shall be incremented with each operation. ]*/
+                    amqp_management->next_message_id++;
+
+                    /* Codes_SRS_AMQP_MANAGEMENT_01_056: [ On success it shall return 0. ]*/
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
 int amqp_management_execute_operation_async(AMQP_MANAGEMENT_HANDLE amqp_management, const char* operation, const char* type, const char* locales, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* on_execute_operation_complete_context)
 {
     int result;
@@ -1176,56 +1830,9 @@ int amqp_management_execute_operation_async(AMQP_MANAGEMENT_HANDLE amqp_manageme
                             LogError("Could not set application properties");
                             result = __FAILURE__;
                         }
-                        else if (set_message_id(cloned_message, amqp_management->next_message_id) != 0)
-                        {
-                            result = __FAILURE__;
-                        }
                         else
                         {
-                            OPERATION_MESSAGE_INSTANCE* pending_operation_message = (OPERATION_MESSAGE_INSTANCE*)malloc(sizeof(OPERATION_MESSAGE_INSTANCE));
-                            if (pending_operation_message == NULL)
-                            {
-                                result = __FAILURE__;
-                            }
-                            else
-                            {
-                                LIST_ITEM_HANDLE added_item;
-                                pending_operation_message->callback_context = on_execute_operation_complete_context;
-                                pending_operation_message->on_execute_operation_complete = on_execute_operation_complete;
-                                pending_operation_message->message_id = amqp_management->next_message_id;
-                                pending_operation_message->amqp_management = amqp_management;
-
-                                /* Codes_SRS_AMQP_MANAGEMENT_01_091: [ Once the request message has been sent, an entry shall be stored in the pending operations list by calling `singlylinkedlist_add`. ]*/
-                                added_item = singlylinkedlist_add(amqp_management->pending_operations, pending_operation_message);
-                                if (added_item == NULL)
-                                {
-                                    /* Codes_SRS_AMQP_MANAGEMENT_01_092: [ If `singlylinkedlist_add` fails then `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
-                                    LogError("Could not add the operation to the pending operations list.");
-                                    free(pending_operation_message);
-                                    result = __FAILURE__;
-                                }
-                                else
-                                {
-                                    /* Codes_SRS_AMQP_MANAGEMENT_01_088: [ `amqp_management_execute_operation_async` shall send the message by calling `messagesender_send_async`. ]*/
-                                    /* Codes_SRS_AMQP_MANAGEMENT_01_166: [ The `on_message_send_complete` callback shall be passed to the `messagesender_send_async` call. ]*/
-                                    if (messagesender_send_async(amqp_management->message_sender, cloned_message, on_message_send_complete, added_item, 0) == NULL)
-                                    {
-                                        /* Codes_SRS_AMQP_MANAGEMENT_01_089: [ If `messagesender_send_async` fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
-                                        LogError("Could not send request message");
-                                        (void)singlylinkedlist_remove(amqp_management->pending_operations, added_item);
-                                        free(pending_operation_message);
-                                        result = __FAILURE__;
-                                    }
-                                    else
-                                    {
-                                        /* Codes_SRS_AMQP_MANAGEMENT_01_107: [ The message Id set on the message properties shall be incremented with each operation. ]*/
-                                        amqp_management->next_message_id++;
-
-                                        /* Codes_SRS_AMQP_MANAGEMENT_01_056: [ On success it shall return 0. ]*/
-                                        result = 0;
-                                    }
-                                }
-                            }
+                            result = start_operation(amqp_management, cloned_message, NULL, on_execute_operation_complete, on_execute_operation_complete_context);
                         }
                     }
 
@@ -1323,3 +1930,243 @@ int amqp_management_set_override_status_description_key_name(AMQP_MANAGEMENT_HAN
 
     return result;
 }
+
+int amqp_management_set_operation_timeout(AMQP_MANAGEMENT_HANDLE amqp_management, TIMER_WHEEL_HANDLE timer_wheel, TICK_COUNTER_HANDLE tick_counter, uint32_t operation_timeout_ms)
+{
+    int result;
+
+    /* Codes_SRS_AMQP_MANAGEMENT_01_186: [ If `amqp_management` is NULL, or `operation_timeout_ms` is not 0 and `timer_wheel` or `tick_counter` is NULL, `amqp_management_set_operation_timeout` shall fail and return a non-zero value. ]*/
+    if ((amqp_management == NULL) ||
+        ((operation_timeout_ms != 0) &&
+        ((timer_wheel == NULL) || (tick_counter == NULL))))
+    {
+        LogError("Bad arguments: amqp_management = %p, timer_wheel = %p, tick_counter = %p, operation_timeout_ms = %u",
+            amqp_management, timer_wheel, tick_counter, (unsigned int)operation_timeout_ms);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_185: [ `amqp_management_set_operation_timeout` shall set the timeout applied to the operations started after it by `amqp_management_execute_operation_async`, measured with `tick_counter` and expired by `timer_wheel`. A timeout of 0 disables the operation timeout. ]*/
+        amqp_management->timer_wheel = timer_wheel;
+        amqp_management->tick_counter = tick_counter;
+        amqp_management->operation_timeout_ms = operation_timeout_ms;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_01_187: [ On success, `amqp_management_set_operation_timeout` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int amqp_management_set_max_outstanding_operations(AMQP_MANAGEMENT_HANDLE amqp_management, size_t max_outstanding_operations)
+{
+    int result;
+
+    if (amqp_management == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_203: [ If `amqp_management` is NULL, `amqp_management_set_max_outstanding_operations` shall fail and return a non-zero value. ]*/
+        LogError("NULL amqp_management");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQP_MANAGEMENT_01_204: [ The first time a non-zero `max_outstanding_operations` is set, `amqp_management_set_max_outstanding_operations` shall create the queue of operations waiting to be sent by calling `singlylinkedlist_create`. ]*/
+    else if ((max_outstanding_operations > 0) &&
+        (amqp_management->queued_operations == NULL) &&
+        ((amqp_management->queued_operations = singlylinkedlist_create()) == NULL))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_205: [ If `singlylinkedlist_create` fails, `amqp_management_set_max_outstanding_operations` shall fail and return a non-zero value. ]*/
+        LogError("Cannot create queued operations list");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_202: [ `amqp_management_set_max_outstanding_operations` shall set the maximum number of operations waiting for their response, 0 meaning no limit. ]*/
+        amqp_management->max_outstanding_operations = max_outstanding_operations;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_01_206: [ If the new maximum leaves room for queued operations, they shall be sent. ]*/
+        dispatch_queued_operations(amqp_management);
+
+        /* Codes_SRS_AMQP_MANAGEMENT_01_207: [ On success, `amqp_management_set_max_outstanding_operations` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE amqp_management_prepare_operation(const char* operation, const char* type, const char* locales, AMQP_VALUE application_properties)
+{
+    AMQP_MANAGEMENT_PREPARED_OPERATION_INSTANCE* result;
+
+    if ((operation == NULL) ||
+        (type == NULL) ||
+        ((application_properties != NULL) && (amqpvalue_get_type(application_properties) != AMQP_TYPE_MAP)))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_209: [ If `operation` or `type` is NULL, or `application_properties` is not NULL and not a map, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+        LogError("Bad arguments: operation = %p, type = %p, application_properties = %p",
+            operation, type, application_properties);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_208: [ `amqp_management_prepare_operation` shall allocate and return a prepared operation that can be executed any number of times, on any AMQP management instance, with `amqp_management_execute_prepared_operation_async`. ]*/
+        result = (AMQP_MANAGEMENT_PREPARED_OPERATION_INSTANCE*)malloc(sizeof(AMQP_MANAGEMENT_PREPARED_OPERATION_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_212: [ If any API fails, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for prepared operation");
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_210: [ `amqp_management_prepare_operation` shall build the application properties map of the requests from a clone of `application_properties` (or a new map when it is NULL) with the `operation`, `type` and `locales` key/value pairs added as by `amqp_management_execute_operation_async`. ]*/
+            result->application_properties = (application_properties == NULL) ? amqpvalue_create_map() : amqpvalue_clone(application_properties);
+            if (result->application_properties == NULL)
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_01_212: [ If any API fails, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+                LogError("Could not create the prepared application properties");
+                free(result);
+                result = NULL;
+            }
+            else if ((add_string_key_value_pair_to_map(result->application_properties, "operation", operation) != 0) ||
+                (add_string_key_value_pair_to_map(result->application_properties, "type", type) != 0) ||
+                ((locales != NULL) && (add_string_key_value_pair_to_map(result->application_properties, "locales", locales) != 0)))
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_01_212: [ If any API fails, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+                amqpvalue_destroy(result->application_properties);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                MESSAGE_HANDLE template_message = message_create();
+                if (template_message == NULL)
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_01_212: [ If any API fails, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+                    LogError("Could not create the message of the prepared operation");
+                    amqpvalue_destroy(result->application_properties);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_01_211: [ The application properties shall be encoded once by setting them on a message and creating a message template from it with `messagesender_create_message_template`. ]*/
+                    if (message_set_application_properties(template_message, result->application_properties) != 0)
+                    {
+                        /* Codes_SRS_AMQP_MANAGEMENT_01_212: [ If any API fails, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+                        LogError("Could not set the application properties of the prepared operation");
+                        result->message_template = NULL;
+                    }
+                    else
+                    {
+                        result->message_template = messagesender_create_message_template(template_message);
+                        if (result->message_template == NULL)
+                        {
+                            /* Codes_SRS_AMQP_MANAGEMENT_01_212: [ If any API fails, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+                            LogError("Could not create the message template of the prepared operation");
+                        }
+                    }
+
+                    message_destroy(template_message);
+
+                    if (result->message_template == NULL)
+                    {
+                        amqpvalue_destroy(result->application_properties);
+                        free(result);
+                        result = NULL;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void amqp_management_destroy_prepared_operation(AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation)
+{
+    if (prepared_operation == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_214: [ If `prepared_operation` is NULL, `amqp_management_destroy_prepared_operation` shall do nothing. ]*/
+        LogError("NULL prepared_operation");
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_213: [ `amqp_management_destroy_prepared_operation` shall free the message template and the application properties of the prepared operation. Operations already started with it are not affected. ]*/
+        messagesender_destroy_message_template(prepared_operation->message_template);
+        amqpvalue_destroy(prepared_operation->application_properties);
+        free(prepared_operation);
+    }
+}
+
+int amqp_management_execute_prepared_operation_async(AMQP_MANAGEMENT_HANDLE amqp_management, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* on_execute_operation_complete_context)
+{
+    int result;
+
+    if ((amqp_management == NULL) ||
+        (prepared_operation == NULL) ||
+        (on_execute_operation_complete == NULL))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_216: [ If `amqp_management`, `prepared_operation` or `on_execute_operation_complete` is NULL, `amqp_management_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: amqp_management = %p, prepared_operation = %p, on_execute_operation_complete = %p",
+            amqp_management, prepared_operation, on_execute_operation_complete);
+        result = __FAILURE__;
+    }
+    else if ((amqp_management->amqp_management_state == AMQP_MANAGEMENT_STATE_IDLE) ||
+        (amqp_management->amqp_management_state == AMQP_MANAGEMENT_STATE_ERROR))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_01_217: [ If `amqp_management_execute_prepared_operation_async` is called when not OPEN or in error, it shall fail and return a non-zero value. ]*/
+        LogError("amqp_management_execute_prepared_operation_async called while not open or in error");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE application_properties;
+        MESSAGE_HANDLE cloned_message;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_01_218: [ `amqp_management_execute_prepared_operation_async` shall start the operation like `amqp_management_execute_operation_async`, on a new message if `message` is NULL or on a clone of `message` otherwise. ]*/
+        cloned_message = (message == NULL) ? message_create() : message_clone(message);
+        if (cloned_message == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_01_222: [ If any API fails, `amqp_management_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+            LogError("Could not create the request message");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message_get_application_properties(cloned_message, &application_properties) != 0)
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_01_222: [ If any API fails, `amqp_management_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+                LogError("Could not get application properties");
+                result = __FAILURE__;
+            }
+            else if (application_properties == NULL)
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_01_219: [ If the message has no application properties of its own, the encoded application properties of the prepared operation shall be used for the request. ]*/
+                result = start_operation(amqp_management, cloned_message, prepared_operation->message_template, on_execute_operation_complete, on_execute_operation_complete_context);
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_01_221: [ Otherwise the key/value pairs of the prepared operation shall be set in the application properties of the message, replacing those with the same keys, and the message shall be sent like by `amqp_management_execute_operation_async`. ]*/
+                if (merge_map_pairs(application_properties, prepared_operation->application_properties) != 0)
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_01_222: [ If any API fails, `amqp_management_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+                    result = __FAILURE__;
+                }
+                else if (message_set_application_properties(cloned_message, application_properties) != 0)
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_01_222: [ If any API fails, `amqp_management_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+                    LogError("Could not set application properties");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = start_operation(amqp_management, cloned_message, NULL, on_execute_operation_complete, on_execute_operation_complete_context);
+                }
+
+                amqpvalue_destroy(application_properties);
+            }
+
+            message_destroy(cloned_message);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,599 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqp_management.h"
+#include "azure_uamqp_c/amqp_management_mux.h"
+
+typedef enum MUX_STATE_TAG
+{
+    MUX_STATE_CLOSED,
+    MUX_STATE_OPENING,
+    MUX_STATE_OPEN,
+    MUX_STATE_ERROR
+} MUX_STATE;
+
+typedef struct MUX_OPERATION_TAG
+{
+    /* NULL once the client was closed, the operation is then only waiting for the AMQP management to complete it */
+    struct AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE_TAG* client;
+    LIST_ITEM_HANDLE list_item;
+    ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete;
+    void* on_execute_operation_complete_context;
+} MUX_OPERATION;
+
+typedef struct AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE_TAG
+{
+    struct AMQP_MANAGEMENT_MUX_INSTANCE_TAG* amqp_management_mux;
+    LIST_ITEM_HANDLE list_item;
+    MUX_STATE state;
+    ON_AMQP_MANAGEMENT_OPEN_COMPLETE on_amqp_management_open_complete;
+    void* on_amqp_management_open_complete_context;
+    ON_AMQP_MANAGEMENT_ERROR on_amqp_management_error;
+    void* on_amqp_management_error_context;
+    SINGLYLINKEDLIST_HANDLE pending_operations;
+} AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE;
+
+typedef struct AMQP_MANAGEMENT_MUX_INSTANCE_TAG
+{
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    MUX_STATE state;
+    SINGLYLINKEDLIST_HANDLE clients;
+    /* clients that are not CLOSED, the AMQP management is closed when the last of them closes */
+    size_t open_client_count;
+    bool is_notifying_clients;
+    bool is_destroy_requested;
+} AMQP_MANAGEMENT_MUX_INSTANCE;
+
+static void free_mux(AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux)
+{
+    amqp_management_destroy(amqp_management_mux->amqp_management);
+    singlylinkedlist_destroy(amqp_management_mux->clients);
+    free(amqp_management_mux);
+}
+
+static void free_mux_if_released(AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux)
+{
+    if ((amqp_management_mux->is_destroy_requested) &&
+        (!amqp_management_mux->is_notifying_clients) &&
+        (singlylinkedlist_get_head_item(amqp_management_mux->clients) == NULL))
+    {
+        free_mux(amqp_management_mux);
+    }
+}
+
+static AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE* find_client_in_state(AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux, MUX_STATE state)
+{
+    AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE* result = NULL;
+    LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(amqp_management_mux->clients);
+
+    while (list_item != NULL)
+    {
+        AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE* client = (AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE*)singlylinkedlist_item_get_value(list_item);
+        if ((client != NULL) &&
+            (client->state == state))
+        {
+            result = client;
+            break;
+        }
+
+        list_item = singlylinkedlist_get_next_item(list_item);
+    }
+
+    return result;
+}
+
+static void on_underlying_amqp_management_open_complete(void* context, AMQP_MANAGEMENT_OPEN_RESULT open_result)
+{
+    AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux = (AMQP_MANAGEMENT_MUX_INSTANCE*)context;
+    AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE* client;
+
+    amqp_management_mux->state = (open_result == AMQP_MANAGEMENT_OPEN_OK) ? MUX_STATE_OPEN : MUX_STATE_ERROR;
+    amqp_management_mux->is_notifying_clients = true;
+
+    /* the callbacks can close or destroy clients, so the list is searched again after each of them */
+    while ((client = find_client_in_state(amqp_management_mux, MUX_STATE_OPENING)) != NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_017: [ When the AMQP management open completes, `on_amqp_management_open_complete` shall be called for every OPENING client with the open result. ]*/
+        client->state = (open_result == AMQP_MANAGEMENT_OPEN_OK) ? MUX_STATE_OPEN : MUX_STATE_ERROR;
+        client->on_amqp_management_open_complete(client->on_amqp_management_open_complete_context, open_result);
+    }
+
+    amqp_management_mux->is_notifying_clients = false;
+    free_mux_if_released(amqp_management_mux);
+}
+
+static void on_underlying_amqp_management_error(void* context)
+{
+    AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux = (AMQP_MANAGEMENT_MUX_INSTANCE*)context;
+    AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE* client;
+
+    amqp_management_mux->state = MUX_STATE_ERROR;
+    amqp_management_mux->is_notifying_clients = true;
+
+    /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_018: [ When the AMQP management reports an error, every OPENING client shall be indicated with `on_amqp_management_open_complete` and `AMQP_MANAGEMENT_OPEN_ERROR` and every OPEN client with `on_amqp_management_error`. ]*/
+    while ((client = find_client_in_state(amqp_management_mux, MUX_STATE_OPENING)) != NULL)
+    {
+        client->state = MUX_STATE_ERROR;
+        client->on_amqp_management_open_complete(client->on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_ERROR);
+    }
+
+    while ((client = find_client_in_state(amqp_management_mux, MUX_STATE_OPEN)) != NULL)
+    {
+        client->state = MUX_STATE_ERROR;
+        client->on_amqp_management_error(client->on_amqp_management_error_context);
+    }
+
+    amqp_management_mux->is_notifying_clients = false;
+    free_mux_if_released(amqp_management_mux);
+}
+
+static void on_underlying_execute_operation_complete(void* context, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result, unsigned int status_code, const char* status_description, MESSAGE_HANDLE message)
+{
+    MUX_OPERATION* mux_operation = (MUX_OPERATION*)context;
+
+    if (mux_operation->client != NULL)
+    {
+        if (singlylinkedlist_remove(mux_operation->client->pending_operations, mux_operation->list_item) != 0)
+        {
+            LogError("Cannot remove operation from the client pending list");
+        }
+
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_025: [ When the AMQP management completes an operation of an open client, the `on_execute_operation_complete` given by the client shall be called with the result, status code, status description and message of the operation. ]*/
+        mux_operation->on_execute_operation_complete(mux_operation->on_execute_operation_complete_context, execute_operation_result, status_code, status_description, message);
+    }
+
+    free(mux_operation);
+}
+
+AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux_create(SESSION_HANDLE session, const char* management_node)
+{
+    AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux;
+
+    if ((session == NULL) ||
+        (management_node == NULL))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_002: [ If `session` or `management_node` is NULL, `amqp_management_mux_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: session = %p, management_node = %p", session, management_node);
+        amqp_management_mux = NULL;
+    }
+    else
+    {
+        amqp_management_mux = (AMQP_MANAGEMENT_MUX_INSTANCE*)malloc(sizeof(AMQP_MANAGEMENT_MUX_INSTANCE));
+        if (amqp_management_mux == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_004: [ If any error occurs, `amqp_management_mux_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the AMQP management mux");
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_003: [ `amqp_management_mux_create` shall create the list of clients by calling `singlylinkedlist_create`. ]*/
+            amqp_management_mux->clients = singlylinkedlist_create();
+            if (amqp_management_mux->clients == NULL)
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_004: [ If any error occurs, `amqp_management_mux_create` shall fail and return NULL. ]*/
+                LogError("Cannot create the client list");
+                free(amqp_management_mux);
+                amqp_management_mux = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_001: [ `amqp_management_mux_create` shall create the AMQP management instance shared by all clients by calling `amqp_management_create` with `session` and `management_node`, and on success return a non-NULL handle to the mux. ]*/
+                amqp_management_mux->amqp_management = amqp_management_create(session, management_node);
+                if (amqp_management_mux->amqp_management == NULL)
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_004: [ If any error occurs, `amqp_management_mux_create` shall fail and return NULL. ]*/
+                    LogError("Cannot create the shared AMQP management instance");
+                    singlylinkedlist_destroy(amqp_management_mux->clients);
+                    free(amqp_management_mux);
+                    amqp_management_mux = NULL;
+                }
+                else
+                {
+                    amqp_management_mux->state = MUX_STATE_CLOSED;
+                    amqp_management_mux->open_client_count = 0;
+                    amqp_management_mux->is_notifying_clients = false;
+                    amqp_management_mux->is_destroy_requested = false;
+                }
+            }
+        }
+    }
+
+    return amqp_management_mux;
+}
+
+void amqp_management_mux_destroy(AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux)
+{
+    if (amqp_management_mux == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_006: [ If `amqp_management_mux` is NULL, `amqp_management_mux_destroy` shall do nothing. ]*/
+        LogError("NULL amqp_management_mux");
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_005: [ `amqp_management_mux_destroy` shall free the mux and destroy the shared AMQP management instance by calling `amqp_management_destroy`. ]*/
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_007: [ If clients of the mux still exist, freeing the mux shall be deferred until the last of them is destroyed. ]*/
+        amqp_management_mux->is_destroy_requested = true;
+        free_mux_if_released(amqp_management_mux);
+    }
+}
+
+void amqp_management_mux_set_trace(AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux, bool trace_on)
+{
+    if (amqp_management_mux == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_009: [ If `amqp_management_mux` is NULL, `amqp_management_mux_set_trace` shall do nothing. ]*/
+        LogError("NULL amqp_management_mux");
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_008: [ `amqp_management_mux_set_trace` shall call `amqp_management_set_trace` on the shared AMQP management instance. ]*/
+        amqp_management_set_trace(amqp_management_mux->amqp_management, trace_on);
+    }
+}
+
+int amqp_management_mux_set_override_status_code_key_name(AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux, const char* override_status_code_key_name)
+{
+    int result;
+
+    if (amqp_management_mux == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_011: [ If `amqp_management_mux` is NULL, setting an override key name shall fail and return a non-zero value. ]*/
+        LogError("NULL amqp_management_mux");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_010: [ The override key names shall be set on the shared AMQP management instance by calling `amqp_management_set_override_status_code_key_name` and `amqp_management_set_override_status_description_key_name`, returning what they return. ]*/
+        result = amqp_management_set_override_status_code_key_name(amqp_management_mux->amqp_management, override_status_code_key_name);
+    }
+
+    return result;
+}
+
+int amqp_management_mux_set_override_status_description_key_name(AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux, const char* override_status_description_key_name)
+{
+    int result;
+
+    if (amqp_management_mux == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_011: [ If `amqp_management_mux` is NULL, setting an override key name shall fail and return a non-zero value. ]*/
+        LogError("NULL amqp_management_mux");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_010: [ The override key names shall be set on the shared AMQP management instance by calling `amqp_management_set_override_status_code_key_name` and `amqp_management_set_override_status_description_key_name`, returning what they return. ]*/
+        result = amqp_management_set_override_status_description_key_name(amqp_management_mux->amqp_management, override_status_description_key_name);
+    }
+
+    return result;
+}
+
+AMQP_MANAGEMENT_MUX_CLIENT_HANDLE amqp_management_mux_client_create(AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux)
+{
+    AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE* client;
+
+    if ((amqp_management_mux == NULL) ||
+        (amqp_management_mux->is_destroy_requested))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_013: [ If `amqp_management_mux` is NULL or is being destroyed, `amqp_management_mux_client_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: amqp_management_mux = %p", amqp_management_mux);
+        client = NULL;
+    }
+    else
+    {
+        client = (AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE*)malloc(sizeof(AMQP_MANAGEMENT_MUX_CLIENT_INSTANCE));
+        if (client == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_014: [ If any error occurs, `amqp_management_mux_client_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the AMQP management mux client");
+        }
+        else if ((client->pending_operations = singlylinkedlist_create()) == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_014: [ If any error occurs, `amqp_management_mux_client_create` shall fail and return NULL. ]*/
+            LogError("Cannot create the client pending operations list");
+            free(client);
+            client = NULL;
+        }
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_012: [ `amqp_management_mux_client_create` shall create a CLOSED client of the mux, add it to the list of clients by calling `singlylinkedlist_add` and on success return a non-NULL handle to it. ]*/
+        else if ((client->list_item = singlylinkedlist_add(amqp_management_mux->clients, client)) == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_014: [ If any error occurs, `amqp_management_mux_client_create` shall fail and return NULL. ]*/
+            LogError("Cannot add the client to the mux");
+            singlylinkedlist_destroy(client->pending_operations);
+            free(client);
+            client = NULL;
+        }
+        else
+        {
+            client->amqp_management_mux = amqp_management_mux;
+            client->state = MUX_STATE_CLOSED;
+            client->on_amqp_management_open_complete = NULL;
+            client->on_amqp_management_open_complete_context = NULL;
+            client->on_amqp_management_error = NULL;
+            client->on_amqp_management_error_context = NULL;
+        }
+    }
+
+    return client;
+}
+
+int amqp_management_mux_client_close(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client)
+{
+    int result;
+
+    if (client == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_031: [ If `client` is NULL, `amqp_management_mux_client_close` shall fail and return a non-zero value. ]*/
+        LogError("NULL client");
+        result = __FAILURE__;
+    }
+    else if (client->state == MUX_STATE_CLOSED)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_032: [ If the client is not open, `amqp_management_mux_client_close` shall fail and return a non-zero value. ]*/
+        LogError("Client not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux = client->amqp_management_mux;
+        MUX_STATE previous_state = client->state;
+        LIST_ITEM_HANDLE list_item;
+
+        client->state = MUX_STATE_CLOSED;
+        amqp_management_mux->open_client_count--;
+
+        if (previous_state == MUX_STATE_OPENING)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_029: [ If the client is OPENING, `on_amqp_management_open_complete` shall be called with `AMQP_MANAGEMENT_OPEN_CANCELLED`. ]*/
+            client->on_amqp_management_open_complete(client->on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_CANCELLED);
+        }
+
+        while ((list_item = singlylinkedlist_get_head_item(client->pending_operations)) != NULL)
+        {
+            MUX_OPERATION* mux_operation = (MUX_OPERATION*)singlylinkedlist_item_get_value(list_item);
+
+            if (singlylinkedlist_remove(client->pending_operations, list_item) != 0)
+            {
+                LogError("Cannot remove operation from the client pending list");
+                break;
+            }
+            else if (mux_operation != NULL)
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_028: [ All pending operations of the client shall be indicated complete with `AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED`, the operations themselves being left to complete on the shared links. ]*/
+                mux_operation->client = NULL;
+                mux_operation->on_execute_operation_complete(mux_operation->on_execute_operation_complete_context, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED, 0, NULL, NULL);
+            }
+        }
+
+        if ((amqp_management_mux->open_client_count == 0) &&
+            (amqp_management_mux->state != MUX_STATE_CLOSED))
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_030: [ When the last open client closes, the shared AMQP management instance shall be closed by calling `amqp_management_close`. ]*/
+            if (amqp_management_close(amqp_management_mux->amqp_management) != 0)
+            {
+                LogError("Cannot close the shared AMQP management instance");
+            }
+
+            amqp_management_mux->state = MUX_STATE_CLOSED;
+        }
+
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_027: [ On success, `amqp_management_mux_client_close` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+void amqp_management_mux_client_destroy(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client)
+{
+    if (client == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_016: [ If `client` is NULL, `amqp_management_mux_client_destroy` shall do nothing. ]*/
+        LogError("NULL client");
+    }
+    else
+    {
+        AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux = client->amqp_management_mux;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_015: [ `amqp_management_mux_client_destroy` shall close the client if it is not CLOSED, remove it from the list of clients by calling `singlylinkedlist_remove` and free it. ]*/
+        if (client->state != MUX_STATE_CLOSED)
+        {
+            (void)amqp_management_mux_client_close(client);
+        }
+
+        if (singlylinkedlist_remove(amqp_management_mux->clients, client->list_item) != 0)
+        {
+            LogError("Cannot remove the client from the mux");
+        }
+
+        singlylinkedlist_destroy(client->pending_operations);
+        free(client);
+
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_007: [ If clients of the mux still exist, freeing the mux shall be deferred until the last of them is destroyed. ]*/
+        free_mux_if_released(amqp_management_mux);
+    }
+}
+
+int amqp_management_mux_client_open_async(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client, ON_AMQP_MANAGEMENT_OPEN_COMPLETE on_amqp_management_open_complete, void* on_amqp_management_open_complete_context, ON_AMQP_MANAGEMENT_ERROR on_amqp_management_error, void* on_amqp_management_error_context)
+{
+    int result;
+
+    if ((client == NULL) ||
+        (on_amqp_management_open_complete == NULL) ||
+        (on_amqp_management_error == NULL))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_020: [ If `client`, `on_amqp_management_open_complete` or `on_amqp_management_error` is NULL, `amqp_management_mux_client_open_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: client = %p, on_amqp_management_open_complete = %p, on_amqp_management_error = %p",
+            client, on_amqp_management_open_complete, on_amqp_management_error);
+        result = __FAILURE__;
+    }
+    else if (client->state != MUX_STATE_CLOSED)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_021: [ If the client is not CLOSED, `amqp_management_mux_client_open_async` shall fail and return a non-zero value. ]*/
+        LogError("Client already open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_MANAGEMENT_MUX_INSTANCE* amqp_management_mux = client->amqp_management_mux;
+
+        client->on_amqp_management_open_complete = on_amqp_management_open_complete;
+        client->on_amqp_management_open_complete_context = on_amqp_management_open_complete_context;
+        client->on_amqp_management_error = on_amqp_management_error;
+        client->on_amqp_management_error_context = on_amqp_management_error_context;
+
+        if (amqp_management_mux->state == MUX_STATE_ERROR)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_023: [ If the shared AMQP management instance is in error, it shall be closed by calling `amqp_management_close` and opened again. ]*/
+            (void)amqp_management_close(amqp_management_mux->amqp_management);
+            amqp_management_mux->state = MUX_STATE_CLOSED;
+        }
+
+        if (amqp_management_mux->state == MUX_STATE_OPEN)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_024: [ If the shared AMQP management instance is already OPEN, the client shall become OPEN and `on_amqp_management_open_complete` shall be called with `AMQP_MANAGEMENT_OPEN_OK` before `amqp_management_mux_client_open_async` returns. ]*/
+            client->state = MUX_STATE_OPEN;
+            amqp_management_mux->open_client_count++;
+            on_amqp_management_open_complete(on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+            result = 0;
+        }
+        else
+        {
+            client->state = MUX_STATE_OPENING;
+            amqp_management_mux->open_client_count++;
+
+            if (amqp_management_mux->state == MUX_STATE_OPENING)
+            {
+                /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_019: [ On success, `amqp_management_mux_client_open_async` shall return 0. ]*/
+                result = 0;
+            }
+            else
+            {
+                amqp_management_mux->state = MUX_STATE_OPENING;
+
+                /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_022: [ The first client opening shall open the shared AMQP management instance by calling `amqp_management_open_async`, the other clients opening waiting for it to complete. ]*/
+                if (amqp_management_open_async(amqp_management_mux->amqp_management, on_underlying_amqp_management_open_complete, amqp_management_mux, on_underlying_amqp_management_error, amqp_management_mux) != 0)
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_026: [ If `amqp_management_open_async` fails, `amqp_management_mux_client_open_async` shall fail and return a non-zero value. ]*/
+                    LogError("Cannot open the shared AMQP management instance");
+                    amqp_management_mux->state = MUX_STATE_CLOSED;
+                    amqp_management_mux->open_client_count--;
+                    client->state = MUX_STATE_CLOSED;
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_019: [ On success, `amqp_management_mux_client_open_async` shall return 0. ]*/
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static int add_client_operation(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client, const char* operation, const char* type, const char* locales, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* on_execute_operation_complete_context)
+{
+    int result;
+    MUX_OPERATION* mux_operation = (MUX_OPERATION*)malloc(sizeof(MUX_OPERATION));
+    if (mux_operation == NULL)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_036: [ If any error occurs, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Cannot allocate memory for the operation");
+        result = __FAILURE__;
+    }
+    else
+    {
+        mux_operation->client = client;
+        mux_operation->on_execute_operation_complete = on_execute_operation_complete;
+        mux_operation->on_execute_operation_complete_context = on_execute_operation_complete_context;
+
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_037: [ The operation shall be added to the pending operations of the client by calling `singlylinkedlist_add`. ]*/
+        mux_operation->list_item = singlylinkedlist_add(client->pending_operations, mux_operation);
+        if (mux_operation->list_item == NULL)
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_036: [ If any error occurs, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot add the operation to the client pending list");
+            free(mux_operation);
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_033: [ `amqp_management_mux_client_execute_operation_async` shall execute the operation on the shared AMQP management instance by calling `amqp_management_execute_operation_async` with `operation`, `type`, `locales` and `message`. ]*/
+        else if (((prepared_operation == NULL) && (amqp_management_execute_operation_async(client->amqp_management_mux->amqp_management, operation, type, locales, message, on_underlying_execute_operation_complete, mux_operation) != 0)) ||
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_039: [ `amqp_management_mux_client_execute_prepared_operation_async` shall add the operation to the pending operations of the client and execute it on the shared AMQP management instance by calling `amqp_management_execute_prepared_operation_async` with `prepared_operation` and `message`. ]*/
+            ((prepared_operation != NULL) && (amqp_management_execute_prepared_operation_async(client->amqp_management_mux->amqp_management, prepared_operation, message, on_underlying_execute_operation_complete, mux_operation) != 0)))
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_036: [ If any error occurs, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot execute the operation on the shared AMQP management instance");
+            (void)singlylinkedlist_remove(client->pending_operations, mux_operation->list_item);
+            free(mux_operation);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_038: [ On success, `amqp_management_mux_client_execute_operation_async` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int amqp_management_mux_client_execute_operation_async(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client, const char* operation, const char* type, const char* locales, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* on_execute_operation_complete_context)
+{
+    int result;
+
+    if ((client == NULL) ||
+        (on_execute_operation_complete == NULL))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_034: [ If `client` or `on_execute_operation_complete` is NULL, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: client = %p, on_execute_operation_complete = %p", client, on_execute_operation_complete);
+        result = __FAILURE__;
+    }
+    else if (client->state != MUX_STATE_OPEN)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_035: [ If the client is not OPEN, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Client not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = add_client_operation(client, operation, type, locales, NULL, message, on_execute_operation_complete, on_execute_operation_complete_context);
+    }
+
+    return result;
+}
+
+int amqp_management_mux_client_execute_prepared_operation_async(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* on_execute_operation_complete_context)
+{
+    int result;
+
+    if ((client == NULL) ||
+        (prepared_operation == NULL) ||
+        (on_execute_operation_complete == NULL))
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_040: [ If `client`, `prepared_operation` or `on_execute_operation_complete` is NULL, `amqp_management_mux_client_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: client = %p, prepared_operation = %p, on_execute_operation_complete = %p", client, prepared_operation, on_execute_operation_complete);
+        result = __FAILURE__;
+    }
+    else if (client->state != MUX_STATE_OPEN)
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_041: [ If the client is not OPEN, `amqp_management_mux_client_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+        LogError("Client not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQP_MANAGEMENT_MUX_01_042: [ Errors and the completion of the operation shall be handled as for `amqp_management_mux_client_execute_operation_async`. ]*/
+        result = add_client_operation(client, NULL, NULL, NULL, prepared_operation, message, on_execute_operation_complete, on_execute_operation_complete_context);
+    }
+
+    return result;
+}
@@ -0,0 +1,331 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/amqp_frame_codec.h"
+#include "azure_uamqp_c/amqp_performative_fields.h"
+
+/* An absent trailing field and an explicit null both mean that the field is not set */
+static AMQP_VALUE get_field_in_place(AMQP_VALUE list_value, uint32_t item_count, uint32_t index)
+{
+    AMQP_VALUE result;
+
+    if (index >= item_count)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = amqpvalue_get_list_item_in_place(list_value, index);
+        if ((result != NULL) &&
+            (amqpvalue_get_type(result) == AMQP_TYPE_NULL))
+        {
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static int get_uint_field(AMQP_VALUE list_value, uint32_t item_count, uint32_t index, uint32_t* field_value, bool* is_set)
+{
+    int result;
+    AMQP_VALUE item_value = get_field_in_place(list_value, item_count, index);
+
+    if (item_value == NULL)
+    {
+        *is_set = false;
+        result = 0;
+    }
+    else if (amqpvalue_get_uint(item_value, field_value) != 0)
+    {
+        LogError("Field %u is not an uint", (unsigned int)index);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *is_set = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int get_boolean_field(AMQP_VALUE list_value, uint32_t item_count, uint32_t index, bool* field_value, bool* is_set)
+{
+    int result;
+    AMQP_VALUE item_value = get_field_in_place(list_value, item_count, index);
+
+    if (item_value == NULL)
+    {
+        *is_set = false;
+        result = 0;
+    }
+    else if (amqpvalue_get_boolean(item_value, field_value) != 0)
+    {
+        LogError("Field %u is not a boolean", (unsigned int)index);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *is_set = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int get_ubyte_field(AMQP_VALUE list_value, uint32_t item_count, uint32_t index, unsigned char* field_value, bool* is_set)
+{
+    int result;
+    AMQP_VALUE item_value = get_field_in_place(list_value, item_count, index);
+
+    if (item_value == NULL)
+    {
+        *is_set = false;
+        result = 0;
+    }
+    else if (amqpvalue_get_ubyte(item_value, field_value) != 0)
+    {
+        LogError("Field %u is not an ubyte", (unsigned int)index);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *is_set = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int get_binary_field(AMQP_VALUE list_value, uint32_t item_count, uint32_t index, amqp_binary* field_value, bool* is_set)
+{
+    int result;
+    AMQP_VALUE item_value = get_field_in_place(list_value, item_count, index);
+
+    if (item_value == NULL)
+    {
+        *is_set = false;
+        result = 0;
+    }
+    else if (amqpvalue_get_binary(item_value, field_value) != 0)
+    {
+        LogError("Field %u is not a binary", (unsigned int)index);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *is_set = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* fields with a default in the specification read as that default when they are not set */
+static int get_boolean_field_with_default(AMQP_VALUE list_value, uint32_t item_count, uint32_t index, bool default_value, bool* field_value)
+{
+    int result;
+    bool is_set;
+
+    if (get_boolean_field(list_value, item_count, index, field_value, &is_set) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (!is_set)
+        {
+            *field_value = default_value;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static AMQP_VALUE get_performative_list(AMQP_VALUE value, uint64_t descriptor_code, uint32_t* item_count)
+{
+    AMQP_VALUE result;
+    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(value);
+    uint64_t descriptor_ulong;
+
+    if ((descriptor == NULL) ||
+        (amqpvalue_get_ulong(descriptor, &descriptor_ulong) != 0) ||
+        (descriptor_ulong != descriptor_code))
+    {
+        LogError("Value is not the expected performative 0x%x", (unsigned int)descriptor_code);
+        result = NULL;
+    }
+    else if ((result = amqpvalue_get_inplace_described_value(value)) == NULL)
+    {
+        LogError("Cannot get performative fields list");
+    }
+    else if (amqpvalue_get_list_item_count(result, item_count) != 0)
+    {
+        LogError("Cannot get performative fields count");
+        result = NULL;
+    }
+    else
+    {
+        /* all good */
+    }
+
+    return result;
+}
+
+int amqpvalue_get_transfer_fields(AMQP_VALUE value, TRANSFER_FIELDS* transfer_fields)
+{
+    int result;
+
+    if ((value == NULL) ||
+        (transfer_fields == NULL))
+    {
+        LogError("Bad arguments: value = %p, transfer_fields = %p",
+            value, transfer_fields);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t item_count;
+        AMQP_VALUE list_value = get_performative_list(value, AMQP_TRANSFER, &item_count);
+        bool is_handle_set;
+
+        if (list_value == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else if ((get_uint_field(list_value, item_count, 0, &transfer_fields->handle, &is_handle_set) != 0) ||
+            (get_uint_field(list_value, item_count, 1, &transfer_fields->delivery_id, &transfer_fields->has_delivery_id) != 0) ||
+            (get_binary_field(list_value, item_count, 2, &transfer_fields->delivery_tag, &transfer_fields->has_delivery_tag) != 0) ||
+            (get_uint_field(list_value, item_count, 3, &transfer_fields->message_format, &transfer_fields->has_message_format) != 0) ||
+            (get_boolean_field(list_value, item_count, 4, &transfer_fields->settled, &transfer_fields->has_settled) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 5, false, &transfer_fields->more) != 0) ||
+            (get_ubyte_field(list_value, item_count, 6, &transfer_fields->rcv_settle_mode, &transfer_fields->has_rcv_settle_mode) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 8, false, &transfer_fields->resume) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 9, false, &transfer_fields->aborted) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 10, false, &transfer_fields->batchable) != 0))
+        {
+            LogError("Cannot decode transfer fields");
+            result = __FAILURE__;
+        }
+        else if (!is_handle_set)
+        {
+            LogError("Mandatory handle field missing from transfer");
+            result = __FAILURE__;
+        }
+        else
+        {
+            transfer_fields->state = get_field_in_place(list_value, item_count, 7);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_get_flow_fields(AMQP_VALUE value, FLOW_FIELDS* flow_fields)
+{
+    int result;
+
+    if ((value == NULL) ||
+        (flow_fields == NULL))
+    {
+        LogError("Bad arguments: value = %p, flow_fields = %p",
+            value, flow_fields);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t item_count;
+        AMQP_VALUE list_value = get_performative_list(value, AMQP_FLOW, &item_count);
+        bool is_incoming_window_set;
+        bool is_next_outgoing_id_set;
+        bool is_outgoing_window_set;
+
+        if (list_value == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else if ((get_uint_field(list_value, item_count, 0, &flow_fields->next_incoming_id, &flow_fields->has_next_incoming_id) != 0) ||
+            (get_uint_field(list_value, item_count, 1, &flow_fields->incoming_window, &is_incoming_window_set) != 0) ||
+            (get_uint_field(list_value, item_count, 2, &flow_fields->next_outgoing_id, &is_next_outgoing_id_set) != 0) ||
+            (get_uint_field(list_value, item_count, 3, &flow_fields->outgoing_window, &is_outgoing_window_set) != 0) ||
+            (get_uint_field(list_value, item_count, 4, &flow_fields->handle, &flow_fields->has_handle) != 0) ||
+            (get_uint_field(list_value, item_count, 5, &flow_fields->delivery_count, &flow_fields->has_delivery_count) != 0) ||
+            (get_uint_field(list_value, item_count, 6, &flow_fields->link_credit, &flow_fields->has_link_credit) != 0) ||
+            (get_uint_field(list_value, item_count, 7, &flow_fields->available, &flow_fields->has_available) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 8, false, &flow_fields->drain) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 9, false, &flow_fields->echo) != 0))
+        {
+            LogError("Cannot decode flow fields");
+            result = __FAILURE__;
+        }
+        else if (!is_incoming_window_set || !is_next_outgoing_id_set || !is_outgoing_window_set)
+        {
+            LogError("Mandatory field missing from flow");
+            result = __FAILURE__;
+        }
+        else
+        {
+            flow_fields->properties = get_field_in_place(list_value, item_count, 10);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_get_disposition_fields(AMQP_VALUE value, DISPOSITION_FIELDS* disposition_fields)
+{
+    int result;
+
+    if ((value == NULL) ||
+        (disposition_fields == NULL))
+    {
+        LogError("Bad arguments: value = %p, disposition_fields = %p",
+            value, disposition_fields);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t item_count;
+        AMQP_VALUE list_value = get_performative_list(value, AMQP_DISPOSITION, &item_count);
+        bool is_role_set;
+        bool is_first_set;
+
+        if (list_value == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else if ((get_boolean_field(list_value, item_count, 0, &disposition_fields->role, &is_role_set) != 0) ||
+            (get_uint_field(list_value, item_count, 1, &disposition_fields->first, &is_first_set) != 0) ||
+            (get_uint_field(list_value, item_count, 2, &disposition_fields->last, &disposition_fields->has_last) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 3, false, &disposition_fields->settled) != 0) ||
+            (get_boolean_field_with_default(list_value, item_count, 5, false, &disposition_fields->batchable) != 0))
+        {
+            LogError("Cannot decode disposition fields");
+            result = __FAILURE__;
+        }
+        else if (!is_role_set || !is_first_set)
+        {
+            LogError("Mandatory field missing from disposition");
+            result = __FAILURE__;
+        }
+        else
+        {
+            disposition_fields->state = get_field_in_place(list_value, item_count, 4);
+            result = 0;
+        }
+    }
+
+    return result;
+}
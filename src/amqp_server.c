@@ -0,0 +1,871 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* for sched_setaffinity and the CPU_SET macros */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_uamqp_c/amqp_server.h"
+#include "azure_uamqp_c/buffer_pool.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/header_detect_io.h"
+#include "azure_uamqp_c/socket_listener.h"
+#include "azure_uamqp_c/uamqp_reactor.h"
+
+/* upper bound for a worker to notice a stop request if its wakeup could not be posted */
+#define WORKER_WAIT_MS 100
+#define DEFAULT_CONTAINER_ID "uamqp-server"
+
+/* older libc headers do not have it */
+#ifndef SO_INCOMING_CPU
+#define SO_INCOMING_CPU 49
+#endif
+
+/* from linux/mempolicy.h, there is no libnuma dependency */
+#ifndef MPOL_LOCAL
+#define MPOL_LOCAL 4
+#endif
+
+typedef struct SERVER_CONNECTION_TAG
+{
+    struct SERVER_WORKER_TAG* worker;
+    CONNECTION_HANDLE connection;
+    void* connection_context;
+    XIO_HANDLE underlying_io;
+    XIO_HANDLE header_detect_io;
+    bool is_closing;
+    struct SERVER_CONNECTION_TAG* previous;
+    struct SERVER_CONNECTION_TAG* next;
+} SERVER_CONNECTION;
+
+typedef struct SERVER_WORKER_TAG
+{
+    struct AMQP_SERVER_INSTANCE_TAG* server;
+    size_t index;
+    /* -1 when the worker is not pinned or the node of its CPU is not known */
+    int cpu;
+    int numa_node;
+    UAMQP_REACTOR_HANDLE reactor;
+    THREAD_HANDLE thread;
+    /* only touched by the worker thread */
+    SERVER_CONNECTION* connections;
+    BUFFER_POOL_HANDLE receive_buffer_pool;
+    /* incremented when a socket is dispatched, decremented by the worker, read by the accepting thread */
+    size_t connection_count;
+    int is_stop_requested;
+} SERVER_WORKER;
+
+typedef struct ACCEPTED_SOCKET_TAG
+{
+    SERVER_WORKER* worker;
+    const IO_INTERFACE_DESCRIPTION* interface_description;
+    int socket;
+} ACCEPTED_SOCKET;
+
+typedef struct AMQP_SERVER_INSTANCE_TAG
+{
+    AMQP_SERVER_CONFIG config;
+    char* container_id;
+    char* unix_socket_path;
+    int* worker_cpus;
+    /* the NUMA node of each configured CPU, only built when accepted sockets are steered */
+    int* cpu_numa_nodes;
+    size_t cpu_count;
+    SOCKET_LISTENER_HANDLE socket_listener;
+    SERVER_WORKER* workers;
+    size_t started_worker_count;
+    bool is_started;
+} AMQP_SERVER_INSTANCE;
+
+static void destroy_server_connection(SERVER_CONNECTION* server_connection)
+{
+    SERVER_WORKER* worker = server_connection->worker;
+    AMQP_SERVER_INSTANCE* server = worker->server;
+
+    if (server->config.on_connection_closed != NULL)
+    {
+        server->config.on_connection_closed(server_connection->connection_context, server_connection->connection);
+    }
+
+    (void)uamqp_reactor_remove_connection(worker->reactor, server_connection->connection);
+    connection_destroy(server_connection->connection);
+    xio_destroy(server_connection->header_detect_io);
+    xio_destroy(server_connection->underlying_io);
+
+    if (server_connection->previous == NULL)
+    {
+        worker->connections = server_connection->next;
+    }
+    else
+    {
+        server_connection->previous->next = server_connection->next;
+    }
+
+    if (server_connection->next != NULL)
+    {
+        server_connection->next->previous = server_connection->previous;
+    }
+
+    (void)__atomic_sub_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+    free(server_connection);
+}
+
+static void on_close_connection_work(void* context)
+{
+    destroy_server_connection((SERVER_CONNECTION*)context);
+}
+
+static void schedule_close(SERVER_CONNECTION* server_connection)
+{
+    /* the connection is in the middle of its dowork, it is destroyed by the next reactor pass */
+    if (!server_connection->is_closing)
+    {
+        if (uamqp_reactor_post(server_connection->worker->reactor, on_close_connection_work, server_connection) != 0)
+        {
+            LogError("Cannot schedule the destruction of a closed connection, it is kept until the server stops");
+        }
+        else
+        {
+            server_connection->is_closing = true;
+        }
+    }
+}
+
+static void on_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
+{
+    SERVER_CONNECTION* server_connection = (SERVER_CONNECTION*)context;
+    (void)previous_connection_state;
+
+    if ((new_connection_state == CONNECTION_STATE_END) ||
+        (new_connection_state == CONNECTION_STATE_ERROR))
+    {
+        schedule_close(server_connection);
+    }
+}
+
+static void on_connection_io_error(void* context)
+{
+    schedule_close((SERVER_CONNECTION*)context);
+}
+
+static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    SERVER_CONNECTION* server_connection = (SERVER_CONNECTION*)context;
+    AMQP_SERVER_INSTANCE* server = server_connection->worker->server;
+    bool result;
+
+    if (server->config.on_new_session_endpoint == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        result = server->config.on_new_session_endpoint(server_connection->connection_context, server_connection->connection, new_endpoint);
+    }
+
+    return result;
+}
+
+static void on_socket_dispatched(void* context)
+{
+    ACCEPTED_SOCKET* accepted_socket = (ACCEPTED_SOCKET*)context;
+    SERVER_WORKER* worker = accepted_socket->worker;
+    AMQP_SERVER_INSTANCE* server = worker->server;
+    SERVER_CONNECTION* server_connection = (SERVER_CONNECTION*)malloc(sizeof(SERVER_CONNECTION));
+
+    if (server_connection == NULL)
+    {
+        LogError("Cannot allocate memory for the server connection");
+        (void)close(accepted_socket->socket);
+        (void)__atomic_sub_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        SOCKETIO_CONFIG socketio_config;
+
+        socketio_config.hostname = NULL;
+        socketio_config.port = server->config.port;
+        socketio_config.accepted_socket = &accepted_socket->socket;
+
+        server_connection->worker = worker;
+        server_connection->connection_context = server->config.callback_context;
+        server_connection->is_closing = false;
+
+        /* the socket IO owns the socket from here on */
+        server_connection->underlying_io = xio_create(accepted_socket->interface_description, &socketio_config);
+        if (server_connection->underlying_io == NULL)
+        {
+            LogError("Cannot create the socket IO for an accepted socket");
+            (void)close(accepted_socket->socket);
+            (void)__atomic_sub_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+            free(server_connection);
+        }
+        else
+        {
+            HEADER_DETECT_IO_CONFIG header_detect_io_config;
+            HEADER_DETECT_ENTRY header_detect_entries[1];
+            AMQP_HEADER amqp_header = header_detect_io_get_amqp_header();
+
+            /* there is no SASL server IO yet, so only plain AMQP connections are detected */
+            header_detect_entries[0].header.header_bytes = amqp_header.header_bytes;
+            header_detect_entries[0].header.header_size = amqp_header.header_size;
+            header_detect_entries[0].io_interface_description = NULL;
+
+            header_detect_io_config.underlying_io = server_connection->underlying_io;
+            header_detect_io_config.header_detect_entries = header_detect_entries;
+            header_detect_io_config.header_detect_entry_count = 1;
+
+            server_connection->header_detect_io = xio_create(header_detect_io_get_interface_description(), &header_detect_io_config);
+            if (server_connection->header_detect_io == NULL)
+            {
+                LogError("Cannot create the header detect IO");
+                xio_destroy(server_connection->underlying_io);
+                (void)__atomic_sub_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+                free(server_connection);
+            }
+            else
+            {
+                server_connection->connection = connection_create2(server_connection->header_detect_io, NULL, server->container_id,
+                    on_new_session_endpoint, server_connection,
+                    on_connection_state_changed, server_connection,
+                    on_connection_io_error, server_connection);
+                if (server_connection->connection == NULL)
+                {
+                    LogError("Cannot create the connection");
+                    xio_destroy(server_connection->header_detect_io);
+                    xio_destroy(server_connection->underlying_io);
+                    (void)__atomic_sub_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+                    free(server_connection);
+                }
+                else
+                {
+                    if ((worker->receive_buffer_pool != NULL) &&
+                        (connection_set_receive_buffer_pool(server_connection->connection, worker->receive_buffer_pool) != 0))
+                    {
+                        LogError("Cannot receive the frames of the connection in the buffer pool of worker %u, using the heap", (unsigned int)worker->index);
+                    }
+
+                    /* the application gets to set the connection limits before the peer's open is answered */
+                    if (server->config.on_connection_created != NULL)
+                    {
+                        server_connection->connection_context = server->config.on_connection_created(server->config.callback_context, server_connection->connection, worker->index);
+                    }
+
+                    if ((connection_listen(server_connection->connection) != 0) ||
+                        (uamqp_reactor_add_connection(worker->reactor, server_connection->connection, accepted_socket->socket) != 0))
+                    {
+                        LogError("Cannot start listening on the accepted connection");
+                        if (server->config.on_connection_closed != NULL)
+                        {
+                            server->config.on_connection_closed(server_connection->connection_context, server_connection->connection);
+                        }
+
+                        connection_destroy(server_connection->connection);
+                        xio_destroy(server_connection->header_detect_io);
+                        xio_destroy(server_connection->underlying_io);
+                        (void)__atomic_sub_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+                        free(server_connection);
+                    }
+                    else
+                    {
+                        server_connection->previous = NULL;
+                        server_connection->next = worker->connections;
+                        if (worker->connections != NULL)
+                        {
+                            worker->connections->previous = server_connection;
+                        }
+
+                        worker->connections = server_connection;
+                    }
+                }
+            }
+        }
+    }
+
+    free(accepted_socket);
+}
+
+static int get_cpu_numa_node(int cpu)
+{
+    int result = -1;
+    char path[64];
+    DIR* cpu_directory;
+
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    cpu_directory = opendir(path);
+    if (cpu_directory != NULL)
+    {
+        struct dirent* entry;
+
+        /* the node of the CPU shows as a nodeN link, there is none on a kernel without NUMA */
+        while ((result == -1) &&
+            ((entry = readdir(cpu_directory)) != NULL))
+        {
+            int node;
+            char trailing;
+
+            if ((strncmp(entry->d_name, "node", 4) == 0) &&
+                (sscanf(entry->d_name + 4, "%d%c", &node, &trailing) == 1))
+            {
+                result = node;
+            }
+        }
+
+        (void)closedir(cpu_directory);
+    }
+
+    return result;
+}
+
+static int get_incoming_numa_node(AMQP_SERVER_INSTANCE* server, int socket)
+{
+    int result = -1;
+
+    if (server->cpu_numa_nodes != NULL)
+    {
+        int incoming_cpu;
+        socklen_t length = sizeof(incoming_cpu);
+
+        if ((getsockopt(socket, SOL_SOCKET, SO_INCOMING_CPU, &incoming_cpu, &length) == 0) &&
+            (incoming_cpu >= 0) &&
+            ((size_t)incoming_cpu < server->cpu_count))
+        {
+            result = server->cpu_numa_nodes[incoming_cpu];
+        }
+    }
+
+    return result;
+}
+
+static SERVER_WORKER* choose_worker(AMQP_SERVER_INSTANCE* server, int numa_node)
+{
+    SERVER_WORKER* result = NULL;
+    size_t least_connection_count = 0;
+    size_t i;
+
+    /* the counters are only a hint, a worker finishing connections meanwhile only makes the choice slightly off */
+    for (i = 0; i < server->config.worker_count; i++)
+    {
+        if ((numa_node == -1) ||
+            (server->workers[i].numa_node == numa_node))
+        {
+            size_t connection_count = __atomic_load_n(&server->workers[i].connection_count, __ATOMIC_RELAXED);
+            if ((result == NULL) ||
+                (connection_count < least_connection_count))
+            {
+                least_connection_count = connection_count;
+                result = &server->workers[i];
+            }
+        }
+    }
+
+    /* no worker is pinned on that node */
+    if (result == NULL)
+    {
+        result = choose_worker(server, -1);
+    }
+
+    return result;
+}
+
+static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* interface_description, void* io_parameters)
+{
+    AMQP_SERVER_INSTANCE* server = (AMQP_SERVER_INSTANCE*)context;
+    SOCKETIO_CONFIG* socketio_config = (SOCKETIO_CONFIG*)io_parameters;
+    int socket = *(int*)socketio_config->accepted_socket;
+    SERVER_WORKER* worker = choose_worker(server, get_incoming_numa_node(server, socket));
+    ACCEPTED_SOCKET* accepted_socket;
+
+    accepted_socket = (ACCEPTED_SOCKET*)malloc(sizeof(ACCEPTED_SOCKET));
+    if (accepted_socket == NULL)
+    {
+        LogError("Cannot allocate memory for the accepted socket");
+        (void)close(socket);
+    }
+    else
+    {
+        accepted_socket->worker = worker;
+        accepted_socket->interface_description = interface_description;
+        accepted_socket->socket = socket;
+
+        (void)__atomic_add_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+
+        if (uamqp_reactor_post(worker->reactor, on_socket_dispatched, accepted_socket) != 0)
+        {
+            LogError("Cannot hand the accepted socket to worker %u", (unsigned int)worker->index);
+            (void)__atomic_sub_fetch(&worker->connection_count, 1, __ATOMIC_RELAXED);
+            (void)close(socket);
+            free(accepted_socket);
+        }
+    }
+}
+
+static void on_wakeup(void* context)
+{
+    (void)context;
+}
+
+static void pin_worker(SERVER_WORKER* worker)
+{
+    cpu_set_t cpu_set;
+
+    CPU_ZERO(&cpu_set);
+    CPU_SET(worker->cpu, &cpu_set);
+
+    /* done by the worker itself before it allocates anything, so that first touch places its memory on the node */
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0)
+    {
+        LogError("Cannot pin worker %u on CPU %d", (unsigned int)worker->index, worker->cpu);
+    }
+    else if (worker->server->config.numa_local_memory &&
+        (syscall(SYS_set_mempolicy, MPOL_LOCAL, NULL, 0) != 0))
+    {
+        LogError("Cannot set the local memory policy of worker %u", (unsigned int)worker->index);
+    }
+}
+
+static int worker_thread(void* arg)
+{
+    SERVER_WORKER* worker = (SERVER_WORKER*)arg;
+
+    if (worker->cpu != -1)
+    {
+        pin_worker(worker);
+    }
+
+    /* created by the worker after it is pinned, so that the buffers are first touched on its node */
+    if (worker->server->config.receive_buffer_count > 0)
+    {
+        worker->receive_buffer_pool = buffer_pool_create(worker->server->config.receive_buffer_size, worker->server->config.receive_buffer_count, worker->server->config.receive_buffers_on_huge_pages);
+        if (worker->receive_buffer_pool == NULL)
+        {
+            LogError("Cannot create the receive buffer pool of worker %u, frames are received in heap buffers", (unsigned int)worker->index);
+        }
+    }
+
+    while (!__atomic_load_n(&worker->is_stop_requested, __ATOMIC_ACQUIRE))
+    {
+        if (uamqp_reactor_run_once(worker->reactor, WORKER_WAIT_MS) != 0)
+        {
+            LogError("Reactor pass failed on worker %u", (unsigned int)worker->index);
+        }
+    }
+
+    /* sockets dispatched before the listener was stopped still end up as connections, so that they are released below */
+    (void)uamqp_reactor_run_once(worker->reactor, 0);
+
+    while (worker->connections != NULL)
+    {
+        destroy_server_connection(worker->connections);
+    }
+
+    if (worker->receive_buffer_pool != NULL)
+    {
+        buffer_pool_destroy(worker->receive_buffer_pool);
+        worker->receive_buffer_pool = NULL;
+    }
+
+    return 0;
+}
+
+static void stop_workers(AMQP_SERVER_INSTANCE* server)
+{
+    size_t i;
+
+    for (i = 0; i < server->started_worker_count; i++)
+    {
+        __atomic_store_n(&server->workers[i].is_stop_requested, 1, __ATOMIC_RELEASE);
+        (void)uamqp_reactor_post(server->workers[i].reactor, on_wakeup, NULL);
+    }
+
+    for (i = 0; i < server->started_worker_count; i++)
+    {
+        int thread_result;
+
+        if (ThreadAPI_Join(server->workers[i].thread, &thread_result) != THREADAPI_OK)
+        {
+            LogError("Cannot join worker %u", (unsigned int)i);
+        }
+
+        uamqp_reactor_destroy(server->workers[i].reactor);
+    }
+
+    server->started_worker_count = 0;
+}
+
+static bool are_worker_cpus_valid(const AMQP_SERVER_CONFIG* config)
+{
+    bool result = true;
+    size_t i;
+
+    if (config->worker_cpus != NULL)
+    {
+        for (i = 0; i < config->worker_count; i++)
+        {
+            if ((config->worker_cpus[i] < -1) ||
+                (config->worker_cpus[i] >= CPU_SETSIZE))
+            {
+                LogError("Bad CPU %d for worker %u", config->worker_cpus[i], (unsigned int)i);
+                result = false;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int copy_placement(AMQP_SERVER_INSTANCE* server, const AMQP_SERVER_CONFIG* config)
+{
+    int result;
+
+    server->worker_cpus = NULL;
+    server->cpu_numa_nodes = NULL;
+    server->cpu_count = 0;
+
+    if ((config->worker_cpus != NULL) &&
+        ((server->worker_cpus = (int*)malloc(config->worker_count * sizeof(int))) == NULL))
+    {
+        LogError("Cannot allocate memory for the worker CPUs");
+        result = __FAILURE__;
+    }
+    else
+    {
+        long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+
+        if (server->worker_cpus != NULL)
+        {
+            (void)memcpy(server->worker_cpus, config->worker_cpus, config->worker_count * sizeof(int));
+        }
+
+        if ((!config->steer_to_numa_node) ||
+            (cpu_count <= 0))
+        {
+            result = 0;
+        }
+        else if ((server->cpu_numa_nodes = (int*)malloc((size_t)cpu_count * sizeof(int))) == NULL)
+        {
+            LogError("Cannot allocate memory for the CPU to NUMA node table");
+            free(server->worker_cpus);
+            server->worker_cpus = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            int i;
+
+            /* read once, the sockets are steered on the accepting thread */
+            for (i = 0; i < (int)cpu_count; i++)
+            {
+                server->cpu_numa_nodes[i] = get_cpu_numa_node(i);
+            }
+
+            server->cpu_count = (size_t)cpu_count;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+AMQP_SERVER_HANDLE amqp_server_create(const AMQP_SERVER_CONFIG* config)
+{
+    AMQP_SERVER_INSTANCE* result;
+
+    if ((config == NULL) ||
+        (config->worker_count == 0) ||
+        (config->backlog < 0) ||
+        !are_worker_cpus_valid(config))
+    {
+        LogError("Bad arguments: config = %p, worker_count = %u, backlog = %d",
+            config,
+            (config == NULL) ? 0 : (unsigned int)config->worker_count,
+            (config == NULL) ? 0 : config->backlog);
+        result = NULL;
+    }
+    else
+    {
+        result = (AMQP_SERVER_INSTANCE*)malloc(sizeof(AMQP_SERVER_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for the server");
+        }
+        else
+        {
+            result->config = *config;
+            result->socket_listener = NULL;
+            result->started_worker_count = 0;
+            result->is_started = false;
+
+            if (mallocAndStrcpy_s(&result->container_id, (config->container_id == NULL) ? DEFAULT_CONTAINER_ID : config->container_id) != 0)
+            {
+                LogError("Cannot copy the container id");
+                free(result);
+                result = NULL;
+            }
+            else if ((config->unix_socket_path != NULL) &&
+                (mallocAndStrcpy_s(&result->unix_socket_path, config->unix_socket_path) != 0))
+            {
+                LogError("Cannot copy the Unix domain socket path");
+                free(result->container_id);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                /* the caller's strings are not kept */
+                result->config.container_id = NULL;
+                if (config->unix_socket_path == NULL)
+                {
+                    result->unix_socket_path = NULL;
+                }
+                result->config.unix_socket_path = NULL;
+                result->config.worker_cpus = NULL;
+
+                if (copy_placement(result, config) != 0)
+                {
+                    LogError("Cannot copy the worker placement");
+                    if (result->unix_socket_path != NULL)
+                    {
+                        free(result->unix_socket_path);
+                    }
+                    free(result->container_id);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->workers = (SERVER_WORKER*)calloc(config->worker_count, sizeof(SERVER_WORKER));
+                    if (result->workers == NULL)
+                    {
+                        LogError("Cannot allocate memory for the workers");
+                        if (result->cpu_numa_nodes != NULL)
+                        {
+                            free(result->cpu_numa_nodes);
+                        }
+                        if (result->worker_cpus != NULL)
+                        {
+                            free(result->worker_cpus);
+                        }
+                        if (result->unix_socket_path != NULL)
+                        {
+                            free(result->unix_socket_path);
+                        }
+                        free(result->container_id);
+                        free(result);
+                        result = NULL;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void amqp_server_destroy(AMQP_SERVER_HANDLE server)
+{
+    if (server == NULL)
+    {
+        LogError("NULL server");
+    }
+    else
+    {
+        if (server->is_started)
+        {
+            (void)amqp_server_stop(server);
+        }
+
+        free(server->workers);
+        if (server->cpu_numa_nodes != NULL)
+        {
+            free(server->cpu_numa_nodes);
+        }
+        if (server->worker_cpus != NULL)
+        {
+            free(server->worker_cpus);
+        }
+        if (server->unix_socket_path != NULL)
+        {
+            free(server->unix_socket_path);
+        }
+        free(server->container_id);
+        free(server);
+    }
+}
+
+int amqp_server_start(AMQP_SERVER_HANDLE server)
+{
+    int result;
+
+    if (server == NULL)
+    {
+        LogError("NULL server");
+        result = __FAILURE__;
+    }
+    else if (server->is_started)
+    {
+        LogError("Server already started");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+
+        for (i = 0; i < server->config.worker_count; i++)
+        {
+            SERVER_WORKER* worker = &server->workers[i];
+
+            worker->server = server;
+            worker->index = i;
+            worker->cpu = (server->worker_cpus == NULL) ? -1 : server->worker_cpus[i];
+            worker->numa_node = (worker->cpu == -1) ? -1 : get_cpu_numa_node(worker->cpu);
+            worker->connections = NULL;
+            worker->receive_buffer_pool = NULL;
+            worker->connection_count = 0;
+            worker->is_stop_requested = 0;
+
+            worker->reactor = uamqp_reactor_create();
+            if (worker->reactor == NULL)
+            {
+                LogError("Cannot create the reactor for worker %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
+            }
+            else if (ThreadAPI_Create(&worker->thread, worker_thread, worker) != THREADAPI_OK)
+            {
+                LogError("Cannot create the thread for worker %u", (unsigned int)i);
+                uamqp_reactor_destroy(worker->reactor);
+                result = __FAILURE__;
+                break;
+            }
+            else
+            {
+                server->started_worker_count++;
+            }
+        }
+
+        if (result == 0)
+        {
+            server->socket_listener = (server->unix_socket_path == NULL) ?
+                socketlistener_create(server->config.port) :
+                socketlistener_create_unix(server->unix_socket_path);
+            if (server->socket_listener == NULL)
+            {
+                LogError("Cannot create the socket listener");
+                result = __FAILURE__;
+            }
+            else if (((server->config.backlog > 0) &&
+                      (socketlistener_setoption(server->socket_listener, SOCKET_LISTENER_OPTION_BACKLOG, &server->config.backlog) != 0)) ||
+                     (server->config.reuse_port &&
+                      (server->unix_socket_path == NULL) &&
+                      (socketlistener_setoption(server->socket_listener, SOCKET_LISTENER_OPTION_REUSE_PORT, &server->config.reuse_port) != 0)) ||
+                     ((server->config.connection_admission_limiter != NULL) &&
+                      (socketlistener_setoption(server->socket_listener, SOCKET_LISTENER_OPTION_ADMISSION_LIMITER, server->config.connection_admission_limiter) != 0)))
+            {
+                LogError("Cannot set the socket listener options");
+                socketlistener_destroy(server->socket_listener);
+                server->socket_listener = NULL;
+                result = __FAILURE__;
+            }
+            else if (socketlistener_start(server->socket_listener, on_socket_accepted, server) != 0)
+            {
+                LogError("Cannot start the socket listener");
+                socketlistener_destroy(server->socket_listener);
+                server->socket_listener = NULL;
+                result = __FAILURE__;
+            }
+        }
+
+        if (result != 0)
+        {
+            stop_workers(server);
+        }
+        else
+        {
+            server->is_started = true;
+        }
+    }
+
+    return result;
+}
+
+int amqp_server_stop(AMQP_SERVER_HANDLE server)
+{
+    int result;
+
+    if (server == NULL)
+    {
+        LogError("NULL server");
+        result = __FAILURE__;
+    }
+    else if (!server->is_started)
+    {
+        LogError("Server not started");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* no socket is dispatched once the listener is gone, so the workers can drain and exit */
+        socketlistener_destroy(server->socket_listener);
+        server->socket_listener = NULL;
+
+        stop_workers(server);
+        server->is_started = false;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+void amqp_server_dowork(AMQP_SERVER_HANDLE server)
+{
+    if (server == NULL)
+    {
+        LogError("NULL server");
+    }
+    else if (server->is_started)
+    {
+        socketlistener_dowork(server->socket_listener);
+    }
+}
+
+size_t amqp_server_get_connection_count(AMQP_SERVER_HANDLE server)
+{
+    size_t result = 0;
+
+    if (server == NULL)
+    {
+        LogError("NULL server");
+    }
+    else if (server->is_started)
+    {
+        size_t i;
+
+        for (i = 0; i < server->config.worker_count; i++)
+        {
+            result += __atomic_load_n(&server->workers[i].connection_count, __ATOMIC_RELAXED);
+        }
+    }
+
+    return result;
+}
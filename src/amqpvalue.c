@@ -12,21 +12,62 @@
 #include "azure_uamqp_c/amqpvalue.h"
 #include "azure_c_shared_utility/refcount.h"
 
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_AMQPVALUE
+#include "azure_uamqp_c/alloc_counters.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define ATOMIC_INCREMENT_UINT64(target) (void)InterlockedIncrement64((LONGLONG volatile*)(target))
+#define ATOMIC_LOAD_UINT64(target) (uint64_t)InterlockedCompareExchange64((LONGLONG volatile*)(target), 0, 0)
+#define ATOMIC_LOAD_REFCOUNT(target) (uint32_t)InterlockedCompareExchange((LONG volatile*)(target), 0, 0)
+#define ATOMIC_LOAD_ACQUIRE_POINTER(target) InterlockedCompareExchangePointer((PVOID volatile*)(target), NULL, NULL)
+#define ATOMIC_COMPARE_EXCHANGE_POINTER(target, value, comparand) InterlockedCompareExchangePointer((PVOID volatile*)(target), (value), (comparand))
+#else
+#define ATOMIC_INCREMENT_UINT64(target) (void)__atomic_add_fetch((target), 1, __ATOMIC_ACQ_REL)
+#define ATOMIC_LOAD_UINT64(target) __atomic_load_n((target), __ATOMIC_ACQUIRE)
+#define ATOMIC_LOAD_REFCOUNT(target) (uint32_t)__atomic_load_n((target), __ATOMIC_ACQUIRE)
+#define ATOMIC_LOAD_ACQUIRE_POINTER(target) __atomic_load_n((target), __ATOMIC_ACQUIRE)
+#define ATOMIC_COMPARE_EXCHANGE_POINTER(target, value, comparand) atomic_compare_exchange_pointer((void* volatile*)(target), (value), (comparand))
+
+/* returns the value target had, like InterlockedCompareExchangePointer */
+static void* atomic_compare_exchange_pointer(void* volatile* target, void* value, void* comparand)
+{
+    (void)__atomic_compare_exchange_n(target, &comparand, value, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return comparand;
+}
+#endif
+
 /* Requirements satisfied by the current implementation without any code:
 Codes_SRS_AMQPVALUE_01_270: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>]
 Codes_SRS_AMQPVALUE_01_099: [Represents an approximate point in time using the Unix time t [IEEE1003] encoding of UTC, but with a precision of milliseconds.]
 */
 
+/* The items of a lazily decoded list stay encoded in the decoder input until they are asked for */
+typedef struct LAZY_LIST_ITEMS_TAG
+{
+    const unsigned char* bytes;
+    /* item i is encoded in bytes[item_offsets[i]] up to bytes[item_offsets[i + 1]] (count + 1 offsets, allocated with this structure) */
+    uint32_t* item_offsets;
+} LAZY_LIST_ITEMS;
+
 typedef struct AMQP_LIST_VALUE_TAG
 {
+    /* for lazily decoded lists, items that were not decoded yet are NULL */
     AMQP_VALUE* items;
     uint32_t count;
+    uint32_t capacity;
+    LAZY_LIST_ITEMS* lazy_items;
 } AMQP_LIST_VALUE;
 
 typedef struct AMQP_ARRAY_VALUE_TAG
 {
     AMQP_VALUE* items;
     uint32_t count;
+    uint32_t capacity;
+    /* arrays of fixed width primitives can be packed: the items are then kept back to back in host byte order in packed_items
+    (items is NULL) and AMQP values are only created for them when asked for. packed_item_type is AMQP_TYPE_UNKNOWN otherwise. */
+    AMQP_TYPE packed_item_type;
+    unsigned char* packed_items;
 } AMQP_ARRAY_VALUE;
 
 typedef struct AMQP_MAP_KEY_VALUE_PAIR_TAG
@@ -35,20 +76,43 @@ typedef struct AMQP_MAP_KEY_VALUE_PAIR_TAG
     AMQP_VALUE value;
 } AMQP_MAP_KEY_VALUE_PAIR;
 
+/* Maps with at least this many pairs get a hash index over their keys */
+#define MAP_INDEX_MIN_PAIR_COUNT 8
+
+typedef struct AMQP_MAP_INDEX_ENTRY_TAG
+{
+    uint32_t key_hash;
+    /* index of the pair plus one, 0 marks an empty slot */
+    uint32_t pair_index;
+} AMQP_MAP_INDEX_ENTRY;
+
 typedef struct AMQP_MAP_VALUE_TAG
 {
     AMQP_MAP_KEY_VALUE_PAIR* pairs;
     uint32_t pair_count;
+    uint32_t capacity;
+    AMQP_MAP_INDEX_ENTRY* index;
+    uint32_t index_size;
 } AMQP_MAP_VALUE;
 
+/* Strings and symbols shorter than this are stored in the value itself rather than in a separate allocation */
+#define INLINE_CHARS_SIZE 24
+
 typedef struct AMQP_STRING_VALUE_TAG
 {
+    /* points to inline_chars for short strings, always followed by a terminator */
     char* chars;
+    /* number of chars, which can include embedded NULs for strings created with amqpvalue_create_string_n */
+    uint32_t length;
+    char inline_chars[INLINE_CHARS_SIZE];
 } AMQP_STRING_VALUE;
 
 typedef struct AMQP_SYMBOL_VALUE_TAG
 {
+    /* points to inline_chars for short symbols, always followed by a terminator */
     char* chars;
+    uint32_t length;
+    char inline_chars[INLINE_CHARS_SIZE];
 } AMQP_SYMBOL_VALUE;
 
 typedef struct AMQP_BINARY_VALUE_TAG
@@ -163,10 +227,56 @@ typedef struct AMQP_VALUE_DATA_TAG
 {
     AMQP_TYPE type;
     AMQP_VALUE_UNION value;
+    bool is_arena_allocated;
+    bool is_borrowed;
+    /* set for symbols whose chars point into the interned symbol table */
+    bool is_interned;
+    /* encoded_size is only valid while encoded_size_generation matches the current generation */
+    size_t encoded_size;
+    uint64_t encoded_size_generation;
 } AMQP_VALUE_DATA;
 
 DEFINE_REFCOUNT_TYPE(AMQP_VALUE_DATA);
 
+/* Only reads the count: a caller holding one of the references can rely on it not dropping below that reference */
+static uint32_t get_value_reference_count(AMQP_VALUE_DATA* value_data)
+{
+    return ATOMIC_LOAD_REFCOUNT(&((REFCOUNT_TYPE(AMQP_VALUE_DATA)*)value_data)->count);
+}
+
+/* Values can be shared between containers, so changing one invalidates the cached encoded size of every container
+that holds it. Rather than tracking parents, any change to a list, map or array bumps this generation, which
+invalidates all cached sizes at once. Generation 0 is never current, so new values start with no cached size.
+The generation is shared by all threads, so it is only read and bumped atomically. */
+static volatile uint64_t current_encoded_size_generation = 1;
+
+static void invalidate_encoded_sizes(void)
+{
+    ATOMIC_INCREMENT_UINT64(&current_encoded_size_generation);
+}
+
+/* process wide, like the generation: set once before values are destroyed on several threads */
+static ON_AMQPVALUE_RECLAIM on_reclaim = NULL;
+static void* on_reclaim_context = NULL;
+static uint32_t reclaim_min_item_count = 0;
+
+/* Blocks are aligned so that any of the AMQP_VALUE_UNION members can be carved from them */
+#define ARENA_ALIGNMENT     sizeof(uint64_t)
+#define ARENA_ALIGN(size)   (((size) + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1))
+
+typedef struct ARENA_BLOCK_TAG
+{
+    struct ARENA_BLOCK_TAG* next;
+    size_t size;
+    size_t used;
+} ARENA_BLOCK;
+
+typedef struct AMQPVALUE_ARENA_TAG
+{
+    ARENA_BLOCK* blocks;
+    size_t block_size;
+} AMQPVALUE_ARENA;
+
 typedef enum DECODER_STATE_TAG
 {
     DECODER_STATE_CONSTRUCTOR,
@@ -175,6 +285,17 @@ typedef enum DECODER_STATE_TAG
     DECODER_STATE_ERROR
 } DECODER_STATE;
 
+/* Limits shared by all the nested decoders of a decoder, a limit of 0 meaning no limit.
+   The counts cover the top level value being decoded. */
+typedef struct DECODER_LIMITS_TAG
+{
+    uint32_t max_depth;
+    size_t max_element_count;
+    size_t max_allocated_bytes;
+    size_t element_count;
+    size_t allocated_bytes;
+} DECODER_LIMITS;
+
 typedef struct INTERNAL_DECODER_DATA_TAG* INTERNAL_DECODER_HANDLE;
 
 typedef struct INTERNAL_DECODER_DATA_TAG
@@ -186,20 +307,306 @@ typedef struct INTERNAL_DECODER_DATA_TAG
     uint8_t constructor_byte;
     AMQP_VALUE_DATA* decode_to_value;
     INTERNAL_DECODER_HANDLE inner_decoder;
+    INTERNAL_DECODER_HANDLE spare_inner_decoder;
     DECODE_VALUE_STATE_UNION decode_value_state;
     bool is_internal;
+    AMQPVALUE_ARENA* arena;
+    bool borrow_binaries;
+    bool lazy_lists;
+    bool validate_strings;
+    /* NULL for the decoders of lazily decoded list items, whose bytes were already checked */
+    DECODER_LIMITS* limits;
+    /* number of values the value being decoded is nested in */
+    uint32_t depth;
 } INTERNAL_DECODER_DATA;
 
 typedef struct AMQPVALUE_DECODER_HANDLE_DATA_TAG
 {
     INTERNAL_DECODER_DATA* internal_decoder;
     AMQP_VALUE_DATA* decode_to_value;
+    DECODER_LIMITS limits;
 } AMQPVALUE_DECODER_HANDLE_DATA;
 
+#ifdef UAMQP_VALUE_NODE_CACHE
+#if defined(_MSC_VER)
+#define NODE_CACHE_THREAD_LOCAL __declspec(thread)
+#else
+#define NODE_CACHE_THREAD_LOCAL __thread
+#endif
+
+#ifndef UAMQP_VALUE_NODE_CACHE_SIZE
+#define UAMQP_VALUE_NODE_CACHE_SIZE 256
+#endif
+
+/* A cached node is chained through its value data, its reference count is left at the 0 it dropped to */
+typedef struct CACHED_VALUE_NODE_TAG
+{
+    struct CACHED_VALUE_NODE_TAG* next;
+} CACHED_VALUE_NODE;
+
+/* Each thread reuses the nodes it frees, whichever thread allocated them, so no lock is taken */
+static NODE_CACHE_THREAD_LOCAL CACHED_VALUE_NODE* cached_value_nodes;
+static NODE_CACHE_THREAD_LOCAL uint32_t cached_value_node_count;
+#endif
+
+static AMQP_VALUE_DATA* allocate_value_node(void)
+{
+    AMQP_VALUE_DATA* result;
+
+#ifdef UAMQP_VALUE_NODE_CACHE
+    if (cached_value_nodes != NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_561: [ When built with UAMQP_VALUE_NODE_CACHE, creating a value shall reuse a node from the cache of the calling thread when it has one. ]*/
+        result = (AMQP_VALUE_DATA*)cached_value_nodes;
+        cached_value_nodes = cached_value_nodes->next;
+        cached_value_node_count--;
+        INC_REF(AMQP_VALUE_DATA, result);
+    }
+    else
+#endif
+    {
+        result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    }
+
+    if (result != NULL)
+    {
+        ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_VALUE_NODE, sizeof(REFCOUNT_TYPE(AMQP_VALUE_DATA)));
+    }
+
+    return result;
+}
+
+/* Called once the reference count of the node dropped to 0 and its contents were cleared */
+static void free_value_node(AMQP_VALUE_DATA* value_data)
+{
+    /* a node kept in the cache is not live anymore */
+    ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_VALUE_NODE, sizeof(REFCOUNT_TYPE(AMQP_VALUE_DATA)));
+
+#ifdef UAMQP_VALUE_NODE_CACHE
+    if (cached_value_node_count < UAMQP_VALUE_NODE_CACHE_SIZE)
+    {
+        /* Codes_SRS_AMQPVALUE_01_560: [ When built with UAMQP_VALUE_NODE_CACHE, destroying the last reference to a value shall keep its node in a cache of the calling thread, holding at most UAMQP_VALUE_NODE_CACHE_SIZE nodes, instead of freeing it. ]*/
+        CACHED_VALUE_NODE* cached_node = (CACHED_VALUE_NODE*)value_data;
+        cached_node->next = cached_value_nodes;
+        cached_value_nodes = cached_node;
+        cached_value_node_count++;
+    }
+    else
+#endif
+    {
+        free(value_data);
+    }
+}
+
+void amqpvalue_free_thread_node_cache(void)
+{
+#ifdef UAMQP_VALUE_NODE_CACHE
+    /* Codes_SRS_AMQPVALUE_01_562: [ amqpvalue_free_thread_node_cache shall free the nodes in the cache of the calling thread. ]*/
+    while (cached_value_nodes != NULL)
+    {
+        CACHED_VALUE_NODE* cached_node = cached_value_nodes;
+        cached_value_nodes = cached_node->next;
+        free(cached_node);
+    }
+
+    cached_value_node_count = 0;
+#else
+    /* Codes_SRS_AMQPVALUE_01_563: [ When not built with UAMQP_VALUE_NODE_CACHE, amqpvalue_free_thread_node_cache shall do nothing. ]*/
+#endif
+}
+
+static AMQP_VALUE_DATA* create_value_data(void)
+{
+    AMQP_VALUE_DATA* result = allocate_value_node();
+    if (result != NULL)
+    {
+        result->is_arena_allocated = false;
+        result->is_borrowed = false;
+        result->is_interned = false;
+        result->encoded_size_generation = 0;
+    }
+
+    return result;
+}
+
+/* Well-known symbols from the AMQP spec and the vendor extensions commonly seen in annotations and link properties.
+Symbols with these values share the table entry instead of a copy, so they can also be compared by identity.
+The table has to stay sorted (strcmp order) for the binary search in find_interned_symbol. */
+static const char* const interned_symbols[] =
+{
+    "ANONYMOUS",
+    "ANONYMOUS-RELAY",
+    "DELAYED_DELIVERY",
+    "EXTERNAL",
+    "MSSBCBS",
+    "PLAIN",
+    "amqp:accepted:list",
+    "amqp:connection:forced",
+    "amqp:connection:framing-error",
+    "amqp:connection:redirect",
+    "amqp:decode-error",
+    "amqp:frame-size-too-small",
+    "amqp:illegal-state",
+    "amqp:internal-error",
+    "amqp:invalid-field",
+    "amqp:jwt",
+    "amqp:link:detach-forced",
+    "amqp:link:message-size-exceeded",
+    "amqp:link:redirect",
+    "amqp:link:stolen",
+    "amqp:link:transfer-limit-exceeded",
+    "amqp:modified:list",
+    "amqp:not-allowed",
+    "amqp:not-found",
+    "amqp:not-implemented",
+    "amqp:precondition-failed",
+    "amqp:received:list",
+    "amqp:rejected:list",
+    "amqp:released:list",
+    "amqp:resource-deleted",
+    "amqp:resource-limit-exceeded",
+    "amqp:resource-locked",
+    "amqp:session:errant-link",
+    "amqp:session:handle-in-use",
+    "amqp:session:unattached-handle",
+    "amqp:session:window-violation",
+    "amqp:unauthorized-access",
+    "apache.org:legacy-amqp-direct-binding:string",
+    "apache.org:selector-filter:string",
+    "com.microsoft:client-version",
+    "com.microsoft:enable-receiver-runtime-metric",
+    "com.microsoft:entity-type",
+    "com.microsoft:epoch",
+    "com.microsoft:receiver-name",
+    "com.microsoft:session-filter",
+    "com.microsoft:timeout",
+    "com.microsoft:tracking-id",
+    "copy",
+    "move",
+    "x-opt-deadletter-source",
+    "x-opt-enqueue-sequence-number",
+    "x-opt-enqueued-time",
+    "x-opt-lock-token",
+    "x-opt-locked-until",
+    "x-opt-message-state",
+    "x-opt-offset",
+    "x-opt-partition-id",
+    "x-opt-partition-key",
+    "x-opt-publisher",
+    "x-opt-scheduled-enqueue-time",
+    "x-opt-sequence-number",
+};
+
+static const char* find_interned_symbol(const char* chars, size_t length)
+{
+    const char* result = NULL;
+    size_t low = 0;
+    size_t high = sizeof(interned_symbols) / sizeof(interned_symbols[0]);
+
+    while (low < high)
+    {
+        size_t middle = low + ((high - low) / 2);
+        const char* candidate = interned_symbols[middle];
+        size_t candidate_length = strlen(candidate);
+        /* chars is not NUL terminated and can hold NUL characters, so only length bytes of it are looked at */
+        int compare_result = memcmp(candidate, chars, (candidate_length < length) ? candidate_length : length);
+        if (compare_result == 0)
+        {
+            /* the shorter of two strings where one is a prefix of the other sorts first */
+            compare_result = (candidate_length < length) ? -1 : ((candidate_length > length) ? 1 : 0);
+        }
+
+        if (compare_result == 0)
+        {
+            result = candidate;
+            break;
+        }
+        else if (compare_result < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return result;
+}
+
+/* Returns room for length chars and the terminator, using the inline storage of the value when they fit in it */
+static char* allocate_chars(char* inline_chars, size_t length)
+{
+    char* result;
+
+    if (length < INLINE_CHARS_SIZE)
+    {
+        /* Codes_SRS_AMQPVALUE_01_456: [ Strings and symbols shorter than 24 characters shall be stored in the AMQP_VALUE itself, without allocating memory for the characters. ]*/
+        result = inline_chars;
+    }
+    else
+    {
+        result = (char*)malloc(length + 1);
+    }
+
+    return result;
+}
+
+/* Doubles the capacity of list, map and array storage when it is full, so that appending items one at a time does not realloc on every append */
+static uint32_t get_grown_capacity(uint32_t capacity, uint32_t required_count)
+{
+    uint32_t result;
+
+    if (capacity >= required_count)
+    {
+        result = capacity;
+    }
+    else
+    {
+        result = (capacity > (UINT32_MAX / 2)) ? UINT32_MAX : (capacity * 2);
+        if (result < required_count)
+        {
+            result = required_count;
+        }
+    }
+
+    return result;
+}
+
+/* Makes room for new_capacity items, leaving the storage untouched if it is already big enough. Returns NULL on failure. */
+static void* reserve_item_storage(void* items, uint32_t* capacity, uint32_t new_capacity, size_t item_size)
+{
+    void* result;
+
+    if (*capacity >= new_capacity)
+    {
+        result = items;
+    }
+    else if (new_capacity > (SIZE_MAX / item_size))
+    {
+        LogError("Capacity %u is too large", (unsigned int)new_capacity);
+        result = NULL;
+    }
+    else
+    {
+        result = realloc(items, new_capacity * item_size);
+        if (result == NULL)
+        {
+            LogError("Could not reallocate storage for %u items", (unsigned int)new_capacity);
+        }
+        else
+        {
+            *capacity = new_capacity;
+        }
+    }
+
+    return result;
+}
+
 /* Codes_SRS_AMQPVALUE_01_003: [1.6.1 null Indicates an empty value.] */
 AMQP_VALUE amqpvalue_create_null(void)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_002: [If allocating the AMQP_VALUE fails then amqpvalue_create_null shall return NULL.] */
@@ -217,7 +624,7 @@ AMQP_VALUE amqpvalue_create_null(void)
 /* Codes_SRS_AMQPVALUE_01_004: [1.6.2 boolean Represents a true or false value.] */
 AMQP_VALUE amqpvalue_create_boolean(bool value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_007: [If allocating the AMQP_VALUE fails then amqpvalue_create_boolean shall return NULL.] */
@@ -270,7 +677,7 @@ int amqpvalue_get_boolean(AMQP_VALUE value, bool* bool_value)
 /* Codes_SRS_AMQPVALUE_01_005: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_ubyte(unsigned char value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result != NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_032: [amqpvalue_create_ubyte shall return a handle to an AMQP_VALUE that stores a unsigned char value.] */
@@ -318,7 +725,7 @@ int amqpvalue_get_ubyte(AMQP_VALUE value, unsigned char* ubyte_value)
 /* Codes_SRS_AMQPVALUE_01_012: [1.6.4 ushort Integer in the range 0 to 216 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_ushort(uint16_t value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_039: [If allocating the AMQP_VALUE fails then amqpvalue_create_ushort shall return NULL.] */
@@ -371,7 +778,7 @@ int amqpvalue_get_ushort(AMQP_VALUE value, uint16_t* ushort_value)
 /* Codes_SRS_AMQPVALUE_01_013: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_uint(uint32_t value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_045: [If allocating the AMQP_VALUE fails then amqpvalue_create_uint shall return NULL.] */
@@ -424,7 +831,7 @@ int amqpvalue_get_uint(AMQP_VALUE value, uint32_t* uint_value)
 /* Codes_SRS_AMQPVALUE_01_014: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_ulong(uint64_t value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_050: [If allocating the AMQP_VALUE fails then amqpvalue_create_ulong shall return NULL.] */
@@ -477,7 +884,7 @@ int amqpvalue_get_ulong(AMQP_VALUE value, uint64_t* ulong_value)
 /* Codes_SRS_AMQPVALUE_01_015: [1.6.7 byte Integer in the range -(27) to 27 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_byte(char value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_056: [If allocating the AMQP_VALUE fails then amqpvalue_create_byte shall return NULL.] */
@@ -530,7 +937,7 @@ int amqpvalue_get_byte(AMQP_VALUE value, char* byte_value)
 /* Codes_SRS_AMQPVALUE_01_016: [1.6.8 short Integer in the range -(215) to 215 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_short(int16_t value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_062: [If allocating the AMQP_VALUE fails then amqpvalue_create_short shall return NULL.] */
@@ -582,7 +989,7 @@ int amqpvalue_get_short(AMQP_VALUE value, int16_t* short_value)
 /* Codes_SRS_AMQPVALUE_01_017: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_int(int32_t value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_068: [If allocating the AMQP_VALUE fails then amqpvalue_create_int shall return NULL.] */
@@ -635,7 +1042,7 @@ int amqpvalue_get_int(AMQP_VALUE value, int32_t* int_value)
 /* Codes_SRS_AMQPVALUE_01_018: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
 AMQP_VALUE amqpvalue_create_long(int64_t value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_074: [If allocating the AMQP_VALUE fails then amqpvalue_create_long shall return NULL.] */
@@ -688,7 +1095,7 @@ int amqpvalue_get_long(AMQP_VALUE value, int64_t* long_value)
 /* Codes_SRS_AMQPVALUE_01_019: [1.6.11 float 32-bit floating point number (IEEE 754-2008 binary32).]  */
 AMQP_VALUE amqpvalue_create_float(float value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_081: [If allocating the AMQP_VALUE fails then amqpvalue_create_float shall return NULL.] */
@@ -741,7 +1148,7 @@ int amqpvalue_get_float(AMQP_VALUE value, float* float_value)
 /* Codes_SRS_AMQPVALUE_01_020: [1.6.12 double 64-bit floating point number (IEEE 754-2008 binary64).] */
 AMQP_VALUE amqpvalue_create_double(double value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_087: [If allocating the AMQP_VALUE fails then amqpvalue_create_double shall return NULL.] */
@@ -804,7 +1211,7 @@ AMQP_VALUE amqpvalue_create_char(uint32_t value)
     }
     else
     {
-        result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+        result = create_value_data();
         if (result == NULL)
         {
             /* Codes_SRS_AMQPVALUE_01_093: [If allocating the AMQP_VALUE fails then amqpvalue_create_char shall return NULL.] */
@@ -858,7 +1265,7 @@ int amqpvalue_get_char(AMQP_VALUE value, uint32_t* char_value)
 /* Codes_SRS_AMQPVALUE_01_025: [1.6.17 timestamp An absolute point in time.] */
 AMQP_VALUE amqpvalue_create_timestamp(int64_t value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_108: [If allocating the AMQP_VALUE fails then amqpvalue_create_timestamp shall return NULL.] */
@@ -911,7 +1318,7 @@ int amqpvalue_get_timestamp(AMQP_VALUE value, int64_t* timestamp_value)
 /* Codes_SRS_AMQPVALUE_01_026: [1.6.18 uuid A universally unique identifier as defined by RFC-4122 section 4.1.2 .] */
 AMQP_VALUE amqpvalue_create_uuid(uuid value)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_114: [If allocating the AMQP_VALUE fails then amqpvalue_create_uuid shall return NULL.] */
@@ -974,7 +1381,7 @@ AMQP_VALUE amqpvalue_create_binary(amqp_binary value)
     }
     else
     {
-        result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+        result = create_value_data();
         if (result == NULL)
         {
             /* Codes_SRS_AMQPVALUE_01_128: [If allocating the AMQP_VALUE fails then amqpvalue_create_binary shall return NULL.] */
@@ -1015,6 +1422,37 @@ AMQP_VALUE amqpvalue_create_binary(amqp_binary value)
     return result;
 }
 
+AMQP_VALUE amqpvalue_create_binary_borrowed(amqp_binary value)
+{
+    AMQP_VALUE result;
+    if ((value.bytes == NULL) &&
+        (value.length > 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_421: [ If value.bytes is NULL and value.length is positive then amqpvalue_create_binary_borrowed shall return NULL. ]*/
+        LogError("NULL bytes with non-zero length");
+        result = NULL;
+    }
+    else
+    {
+        result = create_value_data();
+        if (result == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_422: [ If allocating the AMQP_VALUE fails then amqpvalue_create_binary_borrowed, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+            LogError("Could not allocate memory for AMQP value");
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_420: [ amqpvalue_create_binary_borrowed shall return a handle to an AMQP_VALUE that stores a sequence of bytes by pointing to value.bytes, without copying them. ]*/
+            result->type = AMQP_TYPE_BINARY;
+            result->value.binary_value.bytes = (value.length > 0) ? value.bytes : NULL;
+            result->value.binary_value.length = value.length;
+            result->is_borrowed = true;
+        }
+    }
+
+    return result;
+}
+
 int amqpvalue_get_binary(AMQP_VALUE value, amqp_binary* binary_value)
 {
     int result;
@@ -1051,19 +1489,18 @@ int amqpvalue_get_binary(AMQP_VALUE value, amqp_binary* binary_value)
 
 /* Codes_SRS_AMQPVALUE_01_135: [amqpvalue_create_string shall return a handle to an AMQP_VALUE that stores a sequence of Unicode characters.] */
 /* Codes_SRS_AMQPVALUE_01_028: [1.6.20 string A sequence of Unicode characters.] */
-AMQP_VALUE amqpvalue_create_string(const char* value)
+static AMQP_VALUE create_string_value(const char* value, size_t length)
 {
     AMQP_VALUE result;
-    if (value == NULL)
+
+    if (length > UINT32_MAX)
     {
-        LogError("NULL argument value");
+        LogError("string too long to be represented as an AMQP string");
         result = NULL;
     }
     else
     {
-        size_t length = strlen(value);
-        
-        result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+        result = create_value_data();
         if (result == NULL)
         {
             /* Codes_SRS_AMQPVALUE_01_136: [If allocating the AMQP_VALUE fails then amqpvalue_create_string shall return NULL.] */
@@ -1072,7 +1509,7 @@ AMQP_VALUE amqpvalue_create_string(const char* value)
         else
         {
             result->type = AMQP_TYPE_STRING;
-            result->value.string_value.chars = (char*)malloc(length + 1);
+            result->value.string_value.chars = allocate_chars(result->value.string_value.inline_chars, length);
             if (result->value.string_value.chars == NULL)
             {
                 /* Codes_SRS_AMQPVALUE_01_136: [If allocating the AMQP_VALUE fails then amqpvalue_create_string shall return NULL.] */
@@ -1082,7 +1519,9 @@ AMQP_VALUE amqpvalue_create_string(const char* value)
             }
             else
             {
-                (void)memcpy(result->value.string_value.chars, value, length + 1);
+                (void)memcpy(result->value.string_value.chars, value, length);
+                result->value.string_value.chars[length] = '\0';
+                result->value.string_value.length = (uint32_t)length;
             }
         }
     }
@@ -1090,6 +1529,72 @@ AMQP_VALUE amqpvalue_create_string(const char* value)
     return result;
 }
 
+AMQP_VALUE amqpvalue_create_string(const char* value)
+{
+    AMQP_VALUE result;
+    if (value == NULL)
+    {
+        LogError("NULL argument value");
+        result = NULL;
+    }
+    else
+    {
+        result = create_string_value(value, strlen(value));
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_create_string_n(const char* value, size_t length)
+{
+    AMQP_VALUE result;
+
+    /* Codes_SRS_AMQPVALUE_01_572: [ If value is NULL and length is not 0, amqpvalue_create_string_n shall fail and return NULL. ]*/
+    if ((value == NULL) &&
+        (length > 0))
+    {
+        LogError("Bad arguments: value = %p, length = %u", value, (unsigned int)length);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_571: [ amqpvalue_create_string_n shall create a string value holding the length characters at value, which need not be zero terminated and may include NUL characters. ]*/
+        result = create_string_value((length == 0) ? "" : value, length);
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_create_string_borrowed(const char* value)
+{
+    AMQP_VALUE result;
+    if (value == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_423: [ If value is NULL, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+        LogError("NULL argument value");
+        result = NULL;
+    }
+    else
+    {
+        result = create_value_data();
+        if (result == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_422: [ If allocating the AMQP_VALUE fails then amqpvalue_create_binary_borrowed, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+            LogError("Could not allocate memory for AMQP value");
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_428: [ amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return a handle to an AMQP_VALUE that points to the zero terminated value, without copying it. ]*/
+            result->type = AMQP_TYPE_STRING;
+            result->value.string_value.chars = (char*)value;
+            result->value.string_value.length = (uint32_t)strlen(value);
+            result->is_borrowed = true;
+        }
+    }
+
+    return result;
+}
+
 int amqpvalue_get_string(AMQP_VALUE value, const char** string_value)
 {
     int result;
@@ -1125,6 +1630,35 @@ int amqpvalue_get_string(AMQP_VALUE value, const char** string_value)
     return result;
 }
 
+int amqpvalue_get_string_n(AMQP_VALUE value, const char** string_value, size_t* length)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_574: [ If any of the arguments is NULL, or value is not a string, amqpvalue_get_string_n shall fail and return a non-zero value. ]*/
+    if ((value == NULL) ||
+        (string_value == NULL) ||
+        (length == NULL))
+    {
+        LogError("Bad arguments: value = %p, string_value = %p, length = %p",
+            value, string_value, length);
+        result = __FAILURE__;
+    }
+    else if (value->type != AMQP_TYPE_STRING)
+    {
+        LogError("Value is not of type STRING");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_573: [ amqpvalue_get_string_n shall yield the characters of the string and their number, without measuring them, and return 0. ]*/
+        *string_value = value->value.string_value.chars;
+        *length = value->value.string_value.length;
+        result = 0;
+    }
+
+    return result;
+}
+
 /* Codes_SRS_AMQPVALUE_01_029: [1.6.21 symbol Symbolic values from a constrained domain.] */
 AMQP_VALUE amqpvalue_create_symbol(const char* value)
 {
@@ -1147,7 +1681,7 @@ AMQP_VALUE amqpvalue_create_symbol(const char* value)
         else
         {
             /* Codes_SRS_AMQPVALUE_01_143: [If allocating the AMQP_VALUE fails then amqpvalue_create_symbol shall return NULL.] */
-            result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+            result = create_value_data();
             if (result == NULL)
             {
                 LogError("Cannot allocate memory for AMQP value");
@@ -1156,17 +1690,28 @@ AMQP_VALUE amqpvalue_create_symbol(const char* value)
             else
             {
                 /* Codes_SRS_AMQPVALUE_01_142: [amqpvalue_create_symbol shall return a handle to an AMQP_VALUE that stores a symbol (ASCII string) value.] */
+                const char* interned_symbol = find_interned_symbol(value, length);
                 result->type = AMQP_TYPE_SYMBOL;
-                result->value.symbol_value.chars = (char*)malloc(length + 1);
-                if (result->value.symbol_value.chars == NULL)
+                result->value.symbol_value.length = (uint32_t)length;
+                if (interned_symbol != NULL)
                 {
-                    LogError("Cannot allocate memory for symbol string");
-                    free(result);
-                    result = NULL;
+                    /* Codes_SRS_AMQPVALUE_01_457: [ If the value is one of the well-known symbols in the interned symbol table, amqpvalue_create_symbol shall point to the table entry instead of copying the characters. ]*/
+                    result->value.symbol_value.chars = (char*)interned_symbol;
+                    result->is_interned = true;
                 }
                 else
                 {
-                    (void)memcpy(result->value.symbol_value.chars, value, length + 1);
+                    result->value.symbol_value.chars = allocate_chars(result->value.symbol_value.inline_chars, length);
+                    if (result->value.symbol_value.chars == NULL)
+                    {
+                        LogError("Cannot allocate memory for symbol string");
+                        free(result);
+                        result = NULL;
+                    }
+                    else
+                    {
+                        (void)memcpy(result->value.symbol_value.chars, value, length + 1);
+                    }
                 }
             }
         }
@@ -1175,14 +1720,44 @@ AMQP_VALUE amqpvalue_create_symbol(const char* value)
     return result;
 }
 
-int amqpvalue_get_symbol(AMQP_VALUE value, const char** symbol_value)
+AMQP_VALUE amqpvalue_create_symbol_borrowed(const char* value)
 {
-    int result;
-
-    /* Codes_SRS_AMQPVALUE_01_147: [If any of the arguments is NULL then amqpvalue_get_symbol shall return a non-zero value.] */
-    if ((value == NULL) ||
-        (symbol_value == NULL))
-    {
+    AMQP_VALUE result;
+    if (value == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_423: [ If value is NULL, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+        LogError("NULL argument");
+        result = NULL;
+    }
+    else
+    {
+        result = create_value_data();
+        if (result == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_422: [ If allocating the AMQP_VALUE fails then amqpvalue_create_binary_borrowed, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+            LogError("Cannot allocate memory for AMQP value");
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_428: [ amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return a handle to an AMQP_VALUE that points to the zero terminated value, without copying it. ]*/
+            result->type = AMQP_TYPE_SYMBOL;
+            result->value.symbol_value.chars = (char*)value;
+            result->value.symbol_value.length = (uint32_t)strlen(value);
+            result->is_borrowed = true;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_get_symbol(AMQP_VALUE value, const char** symbol_value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_147: [If any of the arguments is NULL then amqpvalue_get_symbol shall return a non-zero value.] */
+    if ((value == NULL) ||
+        (symbol_value == NULL))
+    {
         LogError("Bad arguments: value = %p, symbol_value = %p",
             value, symbol_value);
         result = __FAILURE__;
@@ -1211,9 +1786,62 @@ int amqpvalue_get_symbol(AMQP_VALUE value, const char** symbol_value)
 }
 
 /* Codes_SRS_AMQPVALUE_01_030: [1.6.22 list A sequence of polymorphic values.] */
+/* defined with the decoder, decodes one item of a lazily decoded list */
+static AMQP_VALUE decode_lazy_list_item(AMQP_VALUE_DATA* list_data, uint32_t index);
+
+/* The const accessors reach this too, so several threads may read the same lazily decoded list: each decodes the
+item on its own and the first to publish it wins, the others destroying their copy. */
+static AMQP_VALUE get_list_item_data(AMQP_VALUE_DATA* list_data, uint32_t index)
+{
+    AMQP_VALUE result = (AMQP_VALUE)ATOMIC_LOAD_ACQUIRE_POINTER(&list_data->value.list_value.items[index]);
+
+    if (result == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_461: [ The items of a lazily decoded list shall be decoded the first time they are accessed. ]*/
+        AMQP_VALUE decoded_item = decode_lazy_list_item(list_data, index);
+        if (decoded_item != NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_584: [ Accessing an item of a lazily decoded list from several threads at once shall return the same item to all of them, the item published first being kept by the list. ]*/
+            result = (AMQP_VALUE)ATOMIC_COMPARE_EXCHANGE_POINTER(&list_data->value.list_value.items[index], decoded_item, NULL);
+            if (result == NULL)
+            {
+                result = decoded_item;
+            }
+            else
+            {
+                amqpvalue_destroy(decoded_item);
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Operations that need the whole list (changing, comparing or encoding it) decode all items first */
+static int decode_all_list_items(AMQP_VALUE_DATA* list_data)
+{
+    int result = 0;
+
+    if (list_data->value.list_value.lazy_items != NULL)
+    {
+        uint32_t i;
+        for (i = 0; i < list_data->value.list_value.count; i++)
+        {
+            if (get_list_item_data(list_data, i) == NULL)
+            {
+                LogError("Could not decode list item %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
 AMQP_VALUE amqpvalue_create_list(void)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE result = create_value_data();
     if (result == NULL)
     {
         /* Codes_SRS_AMQPVALUE_01_150: [If allocating the AMQP_VALUE fails then amqpvalue_create_list shall return NULL.] */
@@ -1227,6 +1855,36 @@ AMQP_VALUE amqpvalue_create_list(void)
         /* Codes_SRS_AMQPVALUE_01_151: [The list shall have an initial size of zero.] */
         result->value.list_value.count = 0;
         result->value.list_value.items = NULL;
+        result->value.list_value.capacity = 0;
+        result->value.list_value.lazy_items = NULL;
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_create_list_with_capacity(uint32_t capacity)
+{
+    /* Codes_SRS_AMQPVALUE_01_447: [ `amqpvalue_create_list_with_capacity` shall create an empty list, like amqpvalue_create_list, with storage allocated for `capacity` items. ]*/
+    AMQP_VALUE result = amqpvalue_create_list();
+    if (result == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+        LogError("Could not create list");
+    }
+    else if (capacity > 0)
+    {
+        AMQP_VALUE* items = (AMQP_VALUE*)reserve_item_storage(NULL, &result->value.list_value.capacity, capacity, sizeof(AMQP_VALUE));
+        if (items == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+            LogError("Could not allocate list storage");
+            amqpvalue_destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            result->value.list_value.items = items;
+        }
     }
 
     return result;
@@ -1251,14 +1909,27 @@ int amqpvalue_set_list_item_count(AMQP_VALUE value, uint32_t list_size)
             LogError("Value is not of type LIST");
             result = __FAILURE__;
         }
+        else if (value_data->is_arena_allocated)
+        {
+            /* Codes_SRS_AMQPVALUE_01_419: [ Values allocated from an arena shall not be modified. ]*/
+            LogError("Cannot modify a value allocated from an arena");
+            result = __FAILURE__;
+        }
+        else if (decode_all_list_items(value_data) != 0)
+        {
+            LogError("Could not decode list items");
+            result = __FAILURE__;
+        }
         else
         {
+            invalidate_encoded_sizes();
+
             if (value_data->value.list_value.count < list_size)
             {
                 AMQP_VALUE* new_list;
 
                 /* Codes_SRS_AMQPVALUE_01_152: [amqpvalue_set_list_item_count shall resize an AMQP list.] */
-                new_list = (AMQP_VALUE*)realloc(value_data->value.list_value.items, list_size * sizeof(AMQP_VALUE));
+                new_list = (AMQP_VALUE*)reserve_item_storage(value_data->value.list_value.items, &value_data->value.list_value.capacity, list_size, sizeof(AMQP_VALUE));
                 if (new_list == NULL)
                 {
                     /* Codes_SRS_AMQPVALUE_01_154: [If allocating memory for the list according to the new size fails, then amqpvalue_set_list_item_count shall return a non-zero value, while preserving the existing list contents.] */
@@ -1362,100 +2033,138 @@ int amqpvalue_get_list_item_count(AMQP_VALUE value, uint32_t* size)
     return result;
 }
 
-int amqpvalue_set_list_item(AMQP_VALUE value, uint32_t index, AMQP_VALUE list_item_value)
+/* stores item_value at index, growing the list with null items if needed; on failure the list is not altered and item_value still belongs to the caller */
+static int store_list_item(AMQP_VALUE_DATA* value_data, uint32_t index, AMQP_VALUE item_value)
 {
     int result;
 
-    /* Codes_SRS_AMQPVALUE_01_165: [If value or list_item_value is NULL, amqpvalue_set_list_item shall fail and return a non-zero value.] */
-    if (value == NULL)
-    {
-        LogError("NULL list value");
-        result = __FAILURE__;
-    }
-    else
+    if (index >= value_data->value.list_value.count)
     {
-        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
-        if (value_data->type != AMQP_TYPE_LIST)
+        AMQP_VALUE* new_list = (AMQP_VALUE*)reserve_item_storage(value_data->value.list_value.items, &value_data->value.list_value.capacity,
+            get_grown_capacity(value_data->value.list_value.capacity, index + 1), sizeof(AMQP_VALUE));
+        if (new_list == NULL)
         {
-            LogError("Value is not of type LIST");
+            /* Codes_SRS_AMQPVALUE_01_170: [When amqpvalue_set_list_item fails due to not being able to clone the item or grow the list, the list shall not be altered.] */
+            LogError("Could not reallocate list storage");
             result = __FAILURE__;
         }
         else
         {
-            /* Codes_SRS_AMQPVALUE_01_168: [The item stored at the index-th position in the list shall be a clone of list_item_value.] */
-            AMQP_VALUE cloned_item = amqpvalue_clone(list_item_value);
-            if (cloned_item == NULL)
+            uint32_t i;
+
+            value_data->value.list_value.items = new_list;
+
+            for (i = value_data->value.list_value.count; i < index; i++)
+            {
+                new_list[i] = amqpvalue_create_null();
+                if (new_list[i] == NULL)
+                {
+                    LogError("Could not allocate NULL value for list entries");
+                    break;
+                }
+            }
+
+            if (i < index)
             {
                 /* Codes_SRS_AMQPVALUE_01_170: [When amqpvalue_set_list_item fails due to not being able to clone the item or grow the list, the list shall not be altered.] */
-                /* Codes_SRS_AMQPVALUE_01_169: [If cloning the item fails, amqpvalue_set_list_item shall fail and return a non-zero value.] */
-                LogError("Could not clone list item");
+                uint32_t j;
+
+                for (j = value_data->value.list_value.count; j < i; j++)
+                {
+                    amqpvalue_destroy(new_list[j]);
+                }
+
+                /* Codes_SRS_AMQPVALUE_01_172: [If growing the list fails, then amqpvalue_set_list_item shall fail and return a non-zero value.] */
                 result = __FAILURE__;
             }
             else
             {
-                if (index >= value_data->value.list_value.count)
-                {
-                    AMQP_VALUE* new_list = (AMQP_VALUE*)realloc(value_data->value.list_value.items, (index + 1) * sizeof(AMQP_VALUE));
-                    if (new_list == NULL)
-                    {
-                        /* Codes_SRS_AMQPVALUE_01_170: [When amqpvalue_set_list_item fails due to not being able to clone the item or grow the list, the list shall not be altered.] */
-                        LogError("Could not reallocate list storage");
-                        amqpvalue_destroy(cloned_item);
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        uint32_t i;
+                value_data->value.list_value.count = index + 1;
+                value_data->value.list_value.items[index] = item_value;
 
-                        value_data->value.list_value.items = new_list;
+                /* Codes_SRS_AMQPVALUE_01_164: [On success amqpvalue_set_list_item shall return 0.] */
+                result = 0;
+            }
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_167: [Any previous value stored at the position index in the list shall be freed by using amqpvalue_destroy.] */
+        amqpvalue_destroy(value_data->value.list_value.items[index]);
 
-                        for (i = value_data->value.list_value.count; i < index; i++)
-                        {
-                            new_list[i] = amqpvalue_create_null();
-                            if (new_list[i] == NULL)
-                            {
-                                LogError("Could not allocate NULL value for list entries");
-                                break;
-                            }
-                        }
+        /* Codes_SRS_AMQPVALUE_01_163: [amqpvalue_set_list_item shall replace the item at the 0 based index-th position in the list identified by the value argument with the AMQP_VALUE specified by list_item_value.] */
+        value_data->value.list_value.items[index] = item_value;
 
-                        if (i < index)
-                        {
-                            /* Codes_SRS_AMQPVALUE_01_170: [When amqpvalue_set_list_item fails due to not being able to clone the item or grow the list, the list shall not be altered.] */
-                            uint32_t j;
+        /* Codes_SRS_AMQPVALUE_01_164: [On success amqpvalue_set_list_item shall return 0.] */
+        result = 0;
+    }
 
-                            for (j = value_data->value.list_value.count; j < i; j++)
-                            {
-                                amqpvalue_destroy(new_list[j]);
-                            }
+    return result;
+}
 
-                            amqpvalue_destroy(cloned_item);
+/* checks that value is a list that can be modified and has all its items decoded */
+static int prepare_list_for_update(AMQP_VALUE_DATA* value_data)
+{
+    int result;
 
-                            /* Codes_SRS_AMQPVALUE_01_172: [If growing the list fails, then amqpvalue_set_list_item shall fail and return a non-zero value.] */
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            value_data->value.list_value.count = index + 1;
-                            value_data->value.list_value.items[index] = cloned_item;
+    if (value_data->type != AMQP_TYPE_LIST)
+    {
+        LogError("Value is not of type LIST");
+        result = __FAILURE__;
+    }
+    else if (value_data->is_arena_allocated)
+    {
+        /* Codes_SRS_AMQPVALUE_01_419: [ Values allocated from an arena shall not be modified. ]*/
+        LogError("Cannot modify a value allocated from an arena");
+        result = __FAILURE__;
+    }
+    else if (decode_all_list_items(value_data) != 0)
+    {
+        LogError("Could not decode list items");
+        result = __FAILURE__;
+    }
+    else
+    {
+        invalidate_encoded_sizes();
+        result = 0;
+    }
 
-                            /* Codes_SRS_AMQPVALUE_01_164: [On success amqpvalue_set_list_item shall return 0.] */
-                            result = 0;
-                        }
-                    }
-                }
-                else
-                {
-                    /* Codes_SRS_AMQPVALUE_01_167: [Any previous value stored at the position index in the list shall be freed by using amqpvalue_destroy.] */
-                    amqpvalue_destroy(value_data->value.list_value.items[index]);
+    return result;
+}
 
-                    /* Codes_SRS_AMQPVALUE_01_163: [amqpvalue_set_list_item shall replace the item at the 0 based index-th position in the list identified by the value argument with the AMQP_VALUE specified by list_item_value.] */
-                    value_data->value.list_value.items[index] = cloned_item;
+int amqpvalue_set_list_item(AMQP_VALUE value, uint32_t index, AMQP_VALUE list_item_value)
+{
+    int result;
 
-                    /* Codes_SRS_AMQPVALUE_01_164: [On success amqpvalue_set_list_item shall return 0.] */
-                    result = 0;
-                }
-            }
+    /* Codes_SRS_AMQPVALUE_01_165: [If value or list_item_value is NULL, amqpvalue_set_list_item shall fail and return a non-zero value.] */
+    if (value == NULL)
+    {
+        LogError("NULL list value");
+        result = __FAILURE__;
+    }
+    else if (prepare_list_for_update((AMQP_VALUE_DATA*)value) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_168: [The item stored at the index-th position in the list shall be a clone of list_item_value.] */
+        AMQP_VALUE cloned_item = amqpvalue_clone(list_item_value);
+        if (cloned_item == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_170: [When amqpvalue_set_list_item fails due to not being able to clone the item or grow the list, the list shall not be altered.] */
+            /* Codes_SRS_AMQPVALUE_01_169: [If cloning the item fails, amqpvalue_set_list_item shall fail and return a non-zero value.] */
+            LogError("Could not clone list item");
+            result = __FAILURE__;
+        }
+        else if (store_list_item((AMQP_VALUE_DATA*)value, index, cloned_item) != 0)
+        {
+            amqpvalue_destroy(cloned_item);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
         }
     }
 
@@ -1492,7 +2201,17 @@ AMQP_VALUE amqpvalue_get_list_item(AMQP_VALUE value, size_t index)
         {
             /* Codes_SRS_AMQPVALUE_01_173: [amqpvalue_get_list_item shall return a copy of the AMQP_VALUE stored at the 0 based position index in the list identified by value.] */
             /* Codes_SRS_AMQPVALUE_01_176: [If cloning the item at position index fails, then amqpvalue_get_list_item shall fail and return NULL.] */
-            result = amqpvalue_clone(value_data->value.list_value.items[index]);
+            AMQP_VALUE item = get_list_item_data(value_data, (uint32_t)index);
+            if (item == NULL)
+            {
+                /* Codes_SRS_AMQPVALUE_01_462: [ If decoding a lazily decoded item fails, the list accessors shall fail and return NULL. ]*/
+                LogError("Could not decode list item %u", (unsigned int)index);
+                result = NULL;
+            }
+            else
+            {
+                result = amqpvalue_clone(item);
+            }
         }
     }
 
@@ -1501,86 +2220,268 @@ AMQP_VALUE amqpvalue_get_list_item(AMQP_VALUE value, size_t index)
 
 /* Codes_SRS_AMQPVALUE_01_178: [amqpvalue_create_map shall create an AMQP value that holds a map and return a handle to it.] */
 /* Codes_SRS_AMQPVALUE_01_031: [1.6.23 map A polymorphic mapping from distinct keys to values.] */
-AMQP_VALUE amqpvalue_create_map(void)
+static void insert_map_index_entry(AMQP_MAP_INDEX_ENTRY* index, uint32_t index_size, uint32_t key_hash, uint32_t pair_index)
+{
+    uint32_t slot = key_hash & (index_size - 1);
+
+    while (index[slot].pair_index != 0)
+    {
+        slot = (slot + 1) & (index_size - 1);
+    }
+
+    index[slot].key_hash = key_hash;
+    index[slot].pair_index = pair_index + 1;
+}
+
+static AMQP_MAP_INDEX_ENTRY* allocate_map_index(uint32_t pair_count, uint32_t* index_size)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_MAP_INDEX_ENTRY* result;
+
+    /* keep the index at most half full */
+    *index_size = 16;
+    while (*index_size < (pair_count * 2))
+    {
+        *index_size *= 2;
+    }
+
+    result = (AMQP_MAP_INDEX_ENTRY*)malloc(*index_size * sizeof(AMQP_MAP_INDEX_ENTRY));
     if (result == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_179: [If allocating memory for the map fails, then amqpvalue_create_map shall return NULL.] */
-        LogError("Could not allocate memory for AMQP value");
+        LogError("Could not allocate memory for map index");
     }
     else
     {
-        result->type = AMQP_TYPE_MAP;
-
-        /* Codes_SRS_AMQPVALUE_01_180: [The number of key/value pairs in the newly created map shall be zero.] */
-        result->value.map_value.pairs = NULL;
-        result->value.map_value.pair_count = 0;
+        (void)memset(result, 0, *index_size * sizeof(AMQP_MAP_INDEX_ENTRY));
     }
 
     return result;
 }
 
-int amqpvalue_set_map_value(AMQP_VALUE map, AMQP_VALUE key, AMQP_VALUE value)
+static int build_map_index(AMQP_VALUE_DATA* map_data)
 {
     int result;
+    uint32_t index_size;
+    AMQP_MAP_INDEX_ENTRY* index = allocate_map_index(map_data->value.map_value.pair_count, &index_size);
 
-    /* Codes_SRS_AMQPVALUE_01_183: [If any of the arguments are NULL, amqpvalue_set_map_value shall fail and return a non-zero value.] */
-    if ((map == NULL) ||
-        (key == NULL) ||
-        (value == NULL))
+    if (index == NULL)
     {
-        LogError("Bad arguments: map = %p, key = %p, value = %p",
-            map, key, value);
         result = __FAILURE__;
     }
     else
     {
-        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)map;
+        uint32_t i;
 
-        /* Codes_SRS_AMQPVALUE_01_196: [If the map argument is not an AMQP value created with the amqpvalue_create_map function than amqpvalue_set_map_value shall fail and return a non-zero value.] */
-        if (value_data->type != AMQP_TYPE_MAP)
+        for (i = 0; i < map_data->value.map_value.pair_count; i++)
         {
-            LogError("Value is not of type MAP");
-            result = __FAILURE__;
+            insert_map_index_entry(index, index_size, amqpvalue_hash(map_data->value.map_value.pairs[i].key), i);
         }
-        else
-        {
-            AMQP_VALUE cloned_value;
 
-            /* Codes_SRS_AMQPVALUE_01_185: [When storing the key or value, their contents shall be cloned.] */
-            cloned_value = amqpvalue_clone(value);
-            if (cloned_value == NULL)
-            {
-                /* Codes_SRS_AMQPVALUE_01_188: [If cloning the value fails, amqpvalue_set_map_value shall fail and return a non-zero value.] */
-                LogError("Could not clone value to set in the map");
-                result = __FAILURE__;
-            }
-            else
-            {
-                uint32_t i;
-                AMQP_VALUE cloned_key;
+        free(map_data->value.map_value.index);
+        map_data->value.map_value.index = index;
+        map_data->value.map_value.index_size = index_size;
+        result = 0;
+    }
 
-                for (i = 0; i < value_data->value.map_value.pair_count; i++)
-                {
-                    if (amqpvalue_are_equal(value_data->value.map_value.pairs[i].key, key))
-                    {
-                        LogError("Could not allocate NULL value for map entries");
-                        break;
-                    }
-                }
+    return result;
+}
 
-                if (i < value_data->value.map_value.pair_count)
-                {
-                    /* Codes_SRS_AMQPVALUE_01_184: [If the key already exists in the map, its value shall be replaced with the value provided by the value argument.] */
-                    /* Codes_SRS_AMQPVALUE_01_125: [A map in which there exist two identical key values is invalid.] */
-                    amqpvalue_destroy(value_data->value.map_value.pairs[i].value);
-                    value_data->value.map_value.pairs[i].value = cloned_value;
+/* Gives a map whose pairs are about to be filled in an index sized for pair_count with no entries */
+static int create_empty_map_index(AMQP_VALUE_DATA* map_data)
+{
+    int result;
+    uint32_t index_size;
+    AMQP_MAP_INDEX_ENTRY* index = allocate_map_index(map_data->value.map_value.pair_count, &index_size);
 
-                    /* Codes_SRS_AMQPVALUE_01_182: [On success amqpvalue_set_map_value shall return 0.] */
-                    result = 0;
-                }
-                else
+    if (index == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        map_data->value.map_value.index = index;
+        map_data->value.map_value.index_size = index_size;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Returns the index of the pair holding key, or pair_count if there is no such pair. Does not modify the map. */
+static uint32_t find_map_pair(AMQP_VALUE_DATA* map_data, AMQP_VALUE key, uint32_t key_hash)
+{
+    uint32_t result;
+
+    /* The index is built when the map is filled or decoded, never here. Arena maps are not indexed since their memory is never cleared. */
+    /* Codes_SRS_AMQPVALUE_01_591: [ The map lookups shall not modify the map, a map of at least 8 pairs whose hash index could not be allocated being searched linearly until a pair is added to it, so that a map can be looked up from several threads at once. ]*/
+    if (map_data->value.map_value.index == NULL)
+    {
+        for (result = 0; result < map_data->value.map_value.pair_count; result++)
+        {
+            if (amqpvalue_are_equal(map_data->value.map_value.pairs[result].key, key))
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        uint32_t slot = key_hash & (map_data->value.map_value.index_size - 1);
+
+        result = map_data->value.map_value.pair_count;
+        while (map_data->value.map_value.index[slot].pair_index != 0)
+        {
+            uint32_t pair_index = map_data->value.map_value.index[slot].pair_index - 1;
+            if ((map_data->value.map_value.index[slot].key_hash == key_hash) &&
+                amqpvalue_are_equal(map_data->value.map_value.pairs[pair_index].key, key))
+            {
+                result = pair_index;
+                break;
+            }
+
+            slot = (slot + 1) & (map_data->value.map_value.index_size - 1);
+        }
+    }
+
+    return result;
+}
+
+/* Called after a pair has been appended to the map */
+static void add_map_index_entry(AMQP_VALUE_DATA* map_data, uint32_t key_hash)
+{
+    if (map_data->value.map_value.index == NULL)
+    {
+        if (map_data->value.map_value.pair_count >= MAP_INDEX_MIN_PAIR_COUNT)
+        {
+            (void)build_map_index(map_data);
+        }
+    }
+    else if ((map_data->value.map_value.pair_count * 2) > map_data->value.map_value.index_size)
+    {
+        if (build_map_index(map_data) != 0)
+        {
+            /* a stale index cannot be kept, lookups go back to scanning until it can be rebuilt */
+            free(map_data->value.map_value.index);
+            map_data->value.map_value.index = NULL;
+            map_data->value.map_value.index_size = 0;
+        }
+    }
+    else
+    {
+        insert_map_index_entry(map_data->value.map_value.index, map_data->value.map_value.index_size, key_hash, map_data->value.map_value.pair_count - 1);
+    }
+}
+
+AMQP_VALUE amqpvalue_create_map(void)
+{
+    AMQP_VALUE result = create_value_data();
+    if (result == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_179: [If allocating memory for the map fails, then amqpvalue_create_map shall return NULL.] */
+        LogError("Could not allocate memory for AMQP value");
+    }
+    else
+    {
+        result->type = AMQP_TYPE_MAP;
+
+        /* Codes_SRS_AMQPVALUE_01_180: [The number of key/value pairs in the newly created map shall be zero.] */
+        result->value.map_value.pairs = NULL;
+        result->value.map_value.pair_count = 0;
+        result->value.map_value.capacity = 0;
+        result->value.map_value.index = NULL;
+        result->value.map_value.index_size = 0;
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_create_map_with_capacity(uint32_t capacity)
+{
+    /* Codes_SRS_AMQPVALUE_01_448: [ `amqpvalue_create_map_with_capacity` shall create an empty map, like amqpvalue_create_map, with storage allocated for `capacity` key/value pairs. ]*/
+    AMQP_VALUE result = amqpvalue_create_map();
+    if (result == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+        LogError("Could not create map");
+    }
+    else if (capacity > 0)
+    {
+        AMQP_MAP_KEY_VALUE_PAIR* pairs = (AMQP_MAP_KEY_VALUE_PAIR*)reserve_item_storage(NULL, &result->value.map_value.capacity, capacity, sizeof(AMQP_MAP_KEY_VALUE_PAIR));
+        if (pairs == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+            LogError("Could not allocate map storage");
+            amqpvalue_destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            result->value.map_value.pairs = pairs;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_set_map_value(AMQP_VALUE map, AMQP_VALUE key, AMQP_VALUE value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_183: [If any of the arguments are NULL, amqpvalue_set_map_value shall fail and return a non-zero value.] */
+    if ((map == NULL) ||
+        (key == NULL) ||
+        (value == NULL))
+    {
+        LogError("Bad arguments: map = %p, key = %p, value = %p",
+            map, key, value);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)map;
+
+        /* Codes_SRS_AMQPVALUE_01_196: [If the map argument is not an AMQP value created with the amqpvalue_create_map function than amqpvalue_set_map_value shall fail and return a non-zero value.] */
+        if (value_data->type != AMQP_TYPE_MAP)
+        {
+            LogError("Value is not of type MAP");
+            result = __FAILURE__;
+        }
+        else if (value_data->is_arena_allocated)
+        {
+            /* Codes_SRS_AMQPVALUE_01_419: [ Values allocated from an arena shall not be modified. ]*/
+            LogError("Cannot modify a value allocated from an arena");
+            result = __FAILURE__;
+        }
+        else
+        {
+            invalidate_encoded_sizes();
+
+            AMQP_VALUE cloned_value;
+
+            /* Codes_SRS_AMQPVALUE_01_185: [When storing the key or value, their contents shall be cloned.] */
+            cloned_value = amqpvalue_clone(value);
+            if (cloned_value == NULL)
+            {
+                /* Codes_SRS_AMQPVALUE_01_188: [If cloning the value fails, amqpvalue_set_map_value shall fail and return a non-zero value.] */
+                LogError("Could not clone value to set in the map");
+                result = __FAILURE__;
+            }
+            else
+            {
+                uint32_t key_hash = amqpvalue_hash(key);
+                uint32_t i = find_map_pair(value_data, key, key_hash);
+                AMQP_VALUE cloned_key;
+
+                if (i < value_data->value.map_value.pair_count)
+                {
+                    /* Codes_SRS_AMQPVALUE_01_184: [If the key already exists in the map, its value shall be replaced with the value provided by the value argument.] */
+                    /* Codes_SRS_AMQPVALUE_01_125: [A map in which there exist two identical key values is invalid.] */
+                    amqpvalue_destroy(value_data->value.map_value.pairs[i].value);
+                    value_data->value.map_value.pairs[i].value = cloned_value;
+
+                    /* Codes_SRS_AMQPVALUE_01_182: [On success amqpvalue_set_map_value shall return 0.] */
+                    result = 0;
+                }
+                else
                 {
                     /* Codes_SRS_AMQPVALUE_01_185: [When storing the key or value, their contents shall be cloned.] */
                     cloned_key = amqpvalue_clone(key);
@@ -1593,7 +2494,8 @@ int amqpvalue_set_map_value(AMQP_VALUE map, AMQP_VALUE key, AMQP_VALUE value)
                     }
                     else
                     {
-                        AMQP_MAP_KEY_VALUE_PAIR* new_pairs = (AMQP_MAP_KEY_VALUE_PAIR*)realloc(value_data->value.map_value.pairs, (value_data->value.map_value.pair_count + 1) * sizeof(AMQP_MAP_KEY_VALUE_PAIR));
+                        AMQP_MAP_KEY_VALUE_PAIR* new_pairs = (AMQP_MAP_KEY_VALUE_PAIR*)reserve_item_storage(value_data->value.map_value.pairs, &value_data->value.map_value.capacity,
+                            get_grown_capacity(value_data->value.map_value.capacity, value_data->value.map_value.pair_count + 1), sizeof(AMQP_MAP_KEY_VALUE_PAIR));
                         if (new_pairs == NULL)
                         {
                             /* Codes_SRS_AMQPVALUE_01_186: [If allocating memory to hold a new key/value pair fails, amqpvalue_set_map_value shall fail and return a non-zero value.] */
@@ -1611,6 +2513,9 @@ int amqpvalue_set_map_value(AMQP_VALUE map, AMQP_VALUE key, AMQP_VALUE value)
                             value_data->value.map_value.pairs[value_data->value.map_value.pair_count].value = cloned_value;
                             value_data->value.map_value.pair_count++;
 
+                            /* Codes_SRS_AMQPVALUE_01_438: [ New key/value pairs shall be appended to the map, so that the pairs keep their insertion order. ]*/
+                            add_map_index_entry(value_data, key_hash);
+
                             /* Codes_SRS_AMQPVALUE_01_182: [On success amqpvalue_set_map_value shall return 0.] */
                             result = 0;
                         }
@@ -1647,15 +2552,7 @@ AMQP_VALUE amqpvalue_get_map_value(AMQP_VALUE map, AMQP_VALUE key)
         }
         else
         {
-            uint32_t i;
-
-            for (i = 0; i < value_data->value.map_value.pair_count; i++)
-            {
-                if (amqpvalue_are_equal(value_data->value.map_value.pairs[i].key, key))
-                {
-                    break;
-                }
-            }
+            uint32_t i = find_map_pair(value_data, key, amqpvalue_hash(key));
 
             if (i == value_data->value.map_value.pair_count)
             {
@@ -1674,6 +2571,160 @@ AMQP_VALUE amqpvalue_get_map_value(AMQP_VALUE map, AMQP_VALUE key)
     return result;
 }
 
+/* A string or symbol key that lives on the caller's stack and borrows the caller's characters, only good for
+   comparing and hashing: it is never cloned, stored or destroyed */
+static void init_lookup_key(AMQP_VALUE_DATA* key_data, AMQP_TYPE type, const char* key)
+{
+    key_data->type = type;
+    if (type == AMQP_TYPE_STRING)
+    {
+        key_data->value.string_value.chars = (char*)key;
+        key_data->value.string_value.length = (uint32_t)strlen(key);
+    }
+    else
+    {
+        key_data->value.symbol_value.chars = (char*)key;
+        key_data->value.symbol_value.length = (uint32_t)strlen(key);
+    }
+    key_data->is_arena_allocated = false;
+    key_data->is_borrowed = true;
+    key_data->is_interned = false;
+    key_data->encoded_size = 0;
+    key_data->encoded_size_generation = 0;
+}
+
+static AMQP_VALUE get_map_value_by_chars(AMQP_VALUE map, AMQP_TYPE key_type, const char* key)
+{
+    AMQP_VALUE result;
+
+    /* Codes_SRS_AMQPVALUE_01_511: [ If `map` or `key` is NULL, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+    if ((map == NULL) ||
+        (key == NULL))
+    {
+        LogError("Bad arguments: map = %p, key = %p",
+            map, key);
+        result = NULL;
+    }
+    /* Codes_SRS_AMQPVALUE_01_512: [ If `map` is not a map, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+    else if (map->type != AMQP_TYPE_MAP)
+    {
+        LogError("Value is not of type MAP");
+        result = NULL;
+    }
+    else
+    {
+        AMQP_VALUE_DATA key_data;
+        uint32_t i;
+
+        /* Codes_SRS_AMQPVALUE_01_510: [ `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return a clone of the value whose key is the string, respectively symbol, with the characters of `key`, without creating an AMQP value for the key. ]*/
+        init_lookup_key(&key_data, key_type, key);
+        i = find_map_pair(map, &key_data, amqpvalue_hash(&key_data));
+
+        if (i == map->value.map_value.pair_count)
+        {
+            /* Codes_SRS_AMQPVALUE_01_513: [ If the key cannot be found, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+            result = NULL;
+        }
+        else
+        {
+            result = amqpvalue_clone(map->value.map_value.pairs[i].value);
+        }
+    }
+
+    return result;
+}
+
+static int set_map_value_by_chars(AMQP_VALUE map, AMQP_TYPE key_type, const char* key, AMQP_VALUE value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_516: [ If any of the arguments is NULL, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall fail and return a non-zero value. ]*/
+    if ((map == NULL) ||
+        (key == NULL) ||
+        (value == NULL))
+    {
+        LogError("Bad arguments: map = %p, key = %p, value = %p",
+            map, key, value);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQPVALUE_01_517: [ If `map` is not a map or was allocated from an arena, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall fail and return a non-zero value. ]*/
+    else if ((map->type != AMQP_TYPE_MAP) ||
+        map->is_arena_allocated)
+    {
+        LogError("Value is not a map that can be modified");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE_DATA key_data;
+        uint32_t i;
+
+        init_lookup_key(&key_data, key_type, key);
+        i = find_map_pair(map, &key_data, amqpvalue_hash(&key_data));
+
+        if (i < map->value.map_value.pair_count)
+        {
+            /* Codes_SRS_AMQPVALUE_01_514: [ When the key is already in the map, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall replace its value with a clone of `value`, without creating an AMQP value for the key. ]*/
+            AMQP_VALUE cloned_value = amqpvalue_clone(value);
+            if (cloned_value == NULL)
+            {
+                /* Codes_SRS_AMQPVALUE_01_518: [ If any of the calls made fails, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall fail and return a non-zero value. ]*/
+                LogError("Could not clone value to set in the map");
+                result = __FAILURE__;
+            }
+            else
+            {
+                invalidate_encoded_sizes();
+
+                amqpvalue_destroy(map->value.map_value.pairs[i].value);
+                map->value.map_value.pairs[i].value = cloned_value;
+
+                /* Codes_SRS_AMQPVALUE_01_519: [ On success `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_515: [ Otherwise the key shall be created as a string, respectively symbol, AMQP value and the pair added to the map like amqpvalue_set_map_value does. ]*/
+            /* a new pair keeps its key, so here it has to be created */
+            AMQP_VALUE key_value = (key_type == AMQP_TYPE_STRING) ? amqpvalue_create_string(key) : amqpvalue_create_symbol(key);
+            if (key_value == NULL)
+            {
+                /* Codes_SRS_AMQPVALUE_01_518: [ If any of the calls made fails, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall fail and return a non-zero value. ]*/
+                LogError("Could not create the key for the map");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = amqpvalue_set_map_value(map, key_value, value);
+                amqpvalue_destroy(key_value);
+            }
+        }
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_get_map_value_by_string(AMQP_VALUE map, const char* key)
+{
+    return get_map_value_by_chars(map, AMQP_TYPE_STRING, key);
+}
+
+AMQP_VALUE amqpvalue_get_map_value_by_symbol(AMQP_VALUE map, const char* key)
+{
+    return get_map_value_by_chars(map, AMQP_TYPE_SYMBOL, key);
+}
+
+int amqpvalue_set_map_value_by_string(AMQP_VALUE map, const char* key, AMQP_VALUE value)
+{
+    return set_map_value_by_chars(map, AMQP_TYPE_STRING, key, value);
+}
+
+int amqpvalue_set_map_value_by_symbol(AMQP_VALUE map, const char* key, AMQP_VALUE value)
+{
+    return set_map_value_by_chars(map, AMQP_TYPE_SYMBOL, key, value);
+}
+
 int amqpvalue_get_map_pair_count(AMQP_VALUE map, uint32_t* pair_count)
 {
     int result;
@@ -1799,18 +2850,339 @@ int amqpvalue_get_map(AMQP_VALUE value, AMQP_VALUE* map_value)
     return result;
 }
 
-AMQP_VALUE amqpvalue_create_array(void)
+/* Size of one item of a packed array of item_type in host representation (which is also its encoded width), 0 for the types
+   that cannot be packed */
+static size_t get_packed_array_item_size(AMQP_TYPE item_type)
 {
-    AMQP_VALUE result = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
-    if (result == NULL)
+    size_t result;
+
+    switch (item_type)
     {
-        LogError("Could not allocate memory for AMQP value");
+    default:
+        result = 0;
+        break;
+    case AMQP_TYPE_UBYTE:
+    case AMQP_TYPE_BYTE:
+        result = 1;
+        break;
+    case AMQP_TYPE_USHORT:
+    case AMQP_TYPE_SHORT:
+        result = 2;
+        break;
+    case AMQP_TYPE_UINT:
+    case AMQP_TYPE_INT:
+    case AMQP_TYPE_FLOAT:
+        result = 4;
+        break;
+    case AMQP_TYPE_ULONG:
+    case AMQP_TYPE_LONG:
+    case AMQP_TYPE_DOUBLE:
+    case AMQP_TYPE_TIMESTAMP:
+        result = 8;
+        break;
+    case AMQP_TYPE_UUID:
+        result = 16;
+        break;
     }
-    else
-    {
-        result->type = AMQP_TYPE_ARRAY;
-        result->value.array_value.items = NULL;
-        result->value.array_value.count = 0;
+
+    return result;
+}
+
+/* Converts items from network byte order to host byte order. The loops only use shifts and fixed size copies so that compilers
+   can turn them into wide byte swaps. */
+static void read_packed_array_items(unsigned char* host_items, const unsigned char* encoded_items, uint32_t count, size_t item_size)
+{
+    uint32_t i;
+
+    switch (item_size)
+    {
+    default:
+        /* single bytes and uuids are in the same order on the wire and in memory */
+        (void)memcpy(host_items, encoded_items, (size_t)count * item_size);
+        break;
+    case 2:
+        for (i = 0; i < count; i++)
+        {
+            const unsigned char* encoded_item = encoded_items + ((size_t)i * 2);
+            uint16_t item = (uint16_t)(((uint16_t)encoded_item[0] << 8) | encoded_item[1]);
+            (void)memcpy(host_items + ((size_t)i * 2), &item, sizeof(item));
+        }
+        break;
+    case 4:
+        for (i = 0; i < count; i++)
+        {
+            const unsigned char* encoded_item = encoded_items + ((size_t)i * 4);
+            uint32_t item = ((uint32_t)encoded_item[0] << 24) | ((uint32_t)encoded_item[1] << 16) | ((uint32_t)encoded_item[2] << 8) | encoded_item[3];
+            (void)memcpy(host_items + ((size_t)i * 4), &item, sizeof(item));
+        }
+        break;
+    case 8:
+        for (i = 0; i < count; i++)
+        {
+            const unsigned char* encoded_item = encoded_items + ((size_t)i * 8);
+            uint64_t item = ((uint64_t)encoded_item[0] << 56) | ((uint64_t)encoded_item[1] << 48) | ((uint64_t)encoded_item[2] << 40) | ((uint64_t)encoded_item[3] << 32) |
+                ((uint64_t)encoded_item[4] << 24) | ((uint64_t)encoded_item[5] << 16) | ((uint64_t)encoded_item[6] << 8) | encoded_item[7];
+            (void)memcpy(host_items + ((size_t)i * 8), &item, sizeof(item));
+        }
+        break;
+    }
+}
+
+/* Converts items from host byte order to network byte order */
+static void write_packed_array_items(unsigned char* encoded_items, const unsigned char* host_items, uint32_t count, size_t item_size)
+{
+    uint32_t i;
+
+    switch (item_size)
+    {
+    default:
+        (void)memcpy(encoded_items, host_items, (size_t)count * item_size);
+        break;
+    case 2:
+        for (i = 0; i < count; i++)
+        {
+            unsigned char* encoded_item = encoded_items + ((size_t)i * 2);
+            uint16_t item;
+            (void)memcpy(&item, host_items + ((size_t)i * 2), sizeof(item));
+            encoded_item[0] = (unsigned char)(item >> 8);
+            encoded_item[1] = (unsigned char)item;
+        }
+        break;
+    case 4:
+        for (i = 0; i < count; i++)
+        {
+            unsigned char* encoded_item = encoded_items + ((size_t)i * 4);
+            uint32_t item;
+            (void)memcpy(&item, host_items + ((size_t)i * 4), sizeof(item));
+            encoded_item[0] = (unsigned char)(item >> 24);
+            encoded_item[1] = (unsigned char)(item >> 16);
+            encoded_item[2] = (unsigned char)(item >> 8);
+            encoded_item[3] = (unsigned char)item;
+        }
+        break;
+    case 8:
+        for (i = 0; i < count; i++)
+        {
+            unsigned char* encoded_item = encoded_items + ((size_t)i * 8);
+            uint64_t item;
+            (void)memcpy(&item, host_items + ((size_t)i * 8), sizeof(item));
+            encoded_item[0] = (unsigned char)(item >> 56);
+            encoded_item[1] = (unsigned char)(item >> 48);
+            encoded_item[2] = (unsigned char)(item >> 40);
+            encoded_item[3] = (unsigned char)(item >> 32);
+            encoded_item[4] = (unsigned char)(item >> 24);
+            encoded_item[5] = (unsigned char)(item >> 16);
+            encoded_item[6] = (unsigned char)(item >> 8);
+            encoded_item[7] = (unsigned char)item;
+        }
+        break;
+    }
+}
+
+/* Creates an AMQP value for one item of a packed array. The fixed width members of the value union all start at its
+   beginning, so the host bytes of the item can be copied there whatever its type. */
+static AMQP_VALUE create_packed_array_item(const AMQP_ARRAY_VALUE* array_value, uint32_t index)
+{
+    AMQP_VALUE result = create_value_data();
+    if (result == NULL)
+    {
+        LogError("Could not allocate memory for array item");
+    }
+    else
+    {
+        size_t item_size = get_packed_array_item_size(array_value->packed_item_type);
+        result->type = array_value->packed_item_type;
+        (void)memcpy(&result->value, array_value->packed_items + ((size_t)index * item_size), item_size);
+    }
+
+    return result;
+}
+
+/* Returns the item at index for code that only reads it. For a packed array the item is copied into packed_item, which
+   needs no cleanup since fixed width values own no memory, and the array stays packed. */
+static AMQP_VALUE get_array_item_view(const AMQP_ARRAY_VALUE* array_value, uint32_t index, AMQP_VALUE_DATA* packed_item)
+{
+    AMQP_VALUE result;
+
+    if (array_value->packed_item_type == AMQP_TYPE_UNKNOWN)
+    {
+        result = array_value->items[index];
+    }
+    else
+    {
+        size_t item_size = get_packed_array_item_size(array_value->packed_item_type);
+        (void)memset(packed_item, 0, sizeof(AMQP_VALUE_DATA));
+        packed_item->type = array_value->packed_item_type;
+        (void)memcpy(&packed_item->value, array_value->packed_items + ((size_t)index * item_size), item_size);
+        result = packed_item;
+    }
+
+    return result;
+}
+
+/* Turns a packed array back into an array of AMQP values, so that it can be changed */
+static int unpack_array_items(AMQP_VALUE_DATA* array_data)
+{
+    int result;
+    AMQP_ARRAY_VALUE* array_value = &array_data->value.array_value;
+
+    if (array_value->packed_item_type == AMQP_TYPE_UNKNOWN)
+    {
+        result = 0;
+    }
+    else
+    {
+        AMQP_VALUE* items = (AMQP_VALUE*)malloc(sizeof(AMQP_VALUE) * ((array_value->count == 0) ? 1 : array_value->count));
+        if (items == NULL)
+        {
+            LogError("Could not allocate memory for array items");
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint32_t i;
+
+            for (i = 0; i < array_value->count; i++)
+            {
+                items[i] = create_packed_array_item(array_value, i);
+                if (items[i] == NULL)
+                {
+                    break;
+                }
+            }
+
+            if (i < array_value->count)
+            {
+                uint32_t j;
+                LogError("Could not unpack array item %u", (unsigned int)i);
+                for (j = 0; j < i; j++)
+                {
+                    amqpvalue_destroy(items[j]);
+                }
+
+                free(items);
+                result = __FAILURE__;
+            }
+            else
+            {
+                free(array_value->packed_items);
+                array_value->packed_items = NULL;
+                array_value->packed_item_type = AMQP_TYPE_UNKNOWN;
+                array_value->items = items;
+                array_value->capacity = (array_value->count == 0) ? 1 : array_value->count;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Turns an array of AMQP values of a fixed width primitive type into a packed array */
+static int pack_array_items(AMQP_VALUE_DATA* array_data, AMQP_TYPE item_type)
+{
+    int result;
+    AMQP_ARRAY_VALUE* array_value = &array_data->value.array_value;
+    size_t item_size = get_packed_array_item_size(item_type);
+
+    if (array_value->packed_item_type != AMQP_TYPE_UNKNOWN)
+    {
+        if (array_value->packed_item_type != item_type)
+        {
+            LogError("Array items are not of the requested type");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else if ((item_size == 0) ||
+        (array_value->count == 0) ||
+        (array_value->items[0]->type != item_type))
+    {
+        LogError("Array items are not of the requested type");
+        result = __FAILURE__;
+    }
+    else if (array_data->is_arena_allocated)
+    {
+        /* Codes_SRS_AMQPVALUE_01_419: [ Values allocated from an arena shall not be modified. ]*/
+        LogError("Cannot pack an array allocated from an arena");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned char* packed_items = (unsigned char*)malloc((size_t)array_value->count * item_size);
+        if (packed_items == NULL)
+        {
+            LogError("Could not allocate memory for packed array items");
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint32_t i;
+
+            for (i = 0; i < array_value->count; i++)
+            {
+                (void)memcpy(packed_items + ((size_t)i * item_size), &array_value->items[i]->value, item_size);
+                amqpvalue_destroy(array_value->items[i]);
+            }
+
+            free(array_value->items);
+            array_value->items = NULL;
+            array_value->capacity = 0;
+            array_value->packed_items = packed_items;
+            array_value->packed_item_type = item_type;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_create_array(void)
+{
+    AMQP_VALUE result = create_value_data();
+    if (result == NULL)
+    {
+        LogError("Could not allocate memory for AMQP value");
+    }
+    else
+    {
+        result->type = AMQP_TYPE_ARRAY;
+        result->value.array_value.items = NULL;
+        result->value.array_value.count = 0;
+        result->value.array_value.capacity = 0;
+        result->value.array_value.packed_item_type = AMQP_TYPE_UNKNOWN;
+        result->value.array_value.packed_items = NULL;
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_create_array_with_capacity(uint32_t capacity)
+{
+    /* Codes_SRS_AMQPVALUE_01_449: [ `amqpvalue_create_array_with_capacity` shall create an empty array, like amqpvalue_create_array, with storage allocated for `capacity` items. ]*/
+    AMQP_VALUE result = amqpvalue_create_array();
+    if (result == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+        LogError("Could not create array");
+    }
+    else if (capacity > 0)
+    {
+        AMQP_VALUE* items = (AMQP_VALUE*)reserve_item_storage(NULL, &result->value.array_value.capacity, capacity, sizeof(AMQP_VALUE));
+        if (items == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+            LogError("Could not allocate array storage");
+            amqpvalue_destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            result->value.array_value.items = items;
+        }
     }
 
     return result;
@@ -1863,8 +3235,22 @@ int amqpvalue_add_array_item(AMQP_VALUE value, AMQP_VALUE array_item_value)
             LogError("Value is not of type ARRAY");
             result = __FAILURE__;
         }
+        else if (value_data->is_arena_allocated)
+        {
+            /* Codes_SRS_AMQPVALUE_01_419: [ Values allocated from an arena shall not be modified. ]*/
+            LogError("Cannot modify a value allocated from an arena");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_AMQPVALUE_01_493: [ Adding an item to a packed array shall first turn its items into AMQP values. ]*/
+        else if (unpack_array_items(value_data) != 0)
+        {
+            LogError("Could not unpack array items");
+            result = __FAILURE__;
+        }
         else
         {
+            invalidate_encoded_sizes();
+
             AMQP_VALUE_DATA* array_item_value_data = (AMQP_VALUE_DATA*)array_item_value;
             if ((value_data->value.array_value.count > 0) &&
                 (array_item_value_data->type != value_data->value.array_value.items[0]->type))
@@ -1882,7 +3268,8 @@ int amqpvalue_add_array_item(AMQP_VALUE value, AMQP_VALUE array_item_value)
                 }
                 else
                 {
-                    AMQP_VALUE* new_array = (AMQP_VALUE*)realloc(value_data->value.array_value.items, (value_data->value.array_value.count + 1) * sizeof(AMQP_VALUE));
+                    AMQP_VALUE* new_array = (AMQP_VALUE*)reserve_item_storage(value_data->value.array_value.items, &value_data->value.array_value.capacity,
+                        get_grown_capacity(value_data->value.array_value.capacity, value_data->value.array_value.count + 1), sizeof(AMQP_VALUE));
                     if (new_array == NULL)
                     {
                         amqpvalue_destroy(cloned_item);
@@ -1929,6 +3316,11 @@ AMQP_VALUE amqpvalue_get_array_item(AMQP_VALUE value, uint32_t index)
             LogError("Index out of range: %u", (unsigned int)index);
             result = NULL;
         }
+        else if (value_data->value.array_value.packed_item_type != AMQP_TYPE_UNKNOWN)
+        {
+            /* Codes_SRS_AMQPVALUE_01_492: [ Getting an item of a packed array shall create a new AMQP value for it, the array stays packed. ]*/
+            result = create_packed_array_item(&value_data->value.array_value, index);
+        }
         else
         {
             result = amqpvalue_clone(value_data->value.array_value.items[index]);
@@ -1967,64 +3359,233 @@ int amqpvalue_get_array(AMQP_VALUE value, AMQP_VALUE* array_value)
     return result;
 }
 
-/* Codes_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-bool amqpvalue_are_equal(AMQP_VALUE value1, AMQP_VALUE value2)
+AMQP_VALUE amqpvalue_create_array_from_span(AMQP_TYPE item_type, const void* items, uint32_t count)
 {
-    bool result;
+    AMQP_VALUE result;
+    size_t item_size = get_packed_array_item_size(item_type);
 
-    /* Codes_SRS_AMQPVALUE_01_207: [If value1 and value2 are NULL, amqpvalue_are_equal shall return true.] */
-    if ((value1 == NULL) &&
-        (value2 == NULL))
+    /* Codes_SRS_AMQPVALUE_01_483: [ If `items` is NULL and `count` is not 0, or `item_type` is not a fixed width primitive type, `amqpvalue_create_array_from_span` shall fail and return NULL. ]*/
+    if ((item_size == 0) ||
+        ((items == NULL) && (count > 0)))
     {
-        LogError("Bad arguments: value1 = %p, value2 = %p",
-            value1, value2);
-        result = true;
+        LogError("Bad arguments: item_type = %d, items = %p, count = %u",
+            (int)item_type, items, (unsigned int)count);
+        result = NULL;
     }
-    /* Codes_SRS_AMQPVALUE_01_208: [If one of the arguments is NULL and the other is not, amqpvalue_are_equal shall return false.] */
-    else if ((value1 != value2) && ((value1 == NULL) || (value2 == NULL)))
+    else if ((size_t)count > (SIZE_MAX / item_size))
     {
-        result = false;
+        LogError("Too many array items: %u", (unsigned int)count);
+        result = NULL;
     }
     else
     {
-        AMQP_VALUE_DATA* value1_data = (AMQP_VALUE_DATA*)value1;
-        AMQP_VALUE_DATA* value2_data = (AMQP_VALUE_DATA*)value2;
-
-        /* Codes_SRS_AMQPVALUE_01_209: [If the types for value1 and value2 are different amqpvalue_are_equal shall return false.] */
-#if _MSC_VER
-#pragma warning(suppress: 28182) /* The compiler states that value2_data can be NULL, but it cannot. And there are tests for it. */
-#endif
-        if (value1_data->type != value2_data->type)
+        /* Codes_SRS_AMQPVALUE_01_482: [ `amqpvalue_create_array_from_span` shall create a packed array holding a copy of the `count` items of `item_type` in `items`, without creating an AMQP value per item. ]*/
+        result = amqpvalue_create_array();
+        if (result == NULL)
         {
-            result = false;
+            /* Codes_SRS_AMQPVALUE_01_484: [ If any allocation fails, `amqpvalue_create_array_from_span` shall fail and return NULL. ]*/
+            LogError("Could not create array");
         }
         else
         {
-            switch (value1_data->type)
+            unsigned char* packed_items = (unsigned char*)malloc((count == 0) ? 1 : (size_t)count * item_size);
+            if (packed_items == NULL)
             {
-            default:
-                result = false;
-                break;
+                /* Codes_SRS_AMQPVALUE_01_484: [ If any allocation fails, `amqpvalue_create_array_from_span` shall fail and return NULL. ]*/
+                LogError("Could not allocate memory for packed array items");
+                amqpvalue_destroy(result);
+                result = NULL;
+            }
+            else
+            {
+                if (count > 0)
+                {
+                    (void)memcpy(packed_items, items, (size_t)count * item_size);
+                }
 
-            case AMQP_TYPE_NULL:
-                /* Codes_SRS_AMQPVALUE_01_210: [- null: always equal.] */
-                result = true;
-                break;
+                result->value.array_value.packed_items = packed_items;
+                result->value.array_value.packed_item_type = item_type;
+                result->value.array_value.count = count;
+            }
+        }
+    }
 
-            case AMQP_TYPE_BOOL:
-                /* Codes_SRS_AMQPVALUE_01_211: [- boolean: compare the bool content.] */
-                result = (value1_data->value.bool_value == value2_data->value.bool_value);
-                break;
+    return result;
+}
 
-            case AMQP_TYPE_UBYTE:
-                /* Codes_SRS_AMQPVALUE_01_212: [- ubyte: compare the unsigned char content.] */
-                result = (value1_data->value.ubyte_value == value2_data->value.ubyte_value);
-                break;
+int amqpvalue_pack_array(AMQP_VALUE value, AMQP_TYPE item_type)
+{
+    int result;
 
-            case AMQP_TYPE_USHORT:
-                /* Codes_SRS_AMQPVALUE_01_213: [- ushort: compare the uint16_t content.] */
-                result = (value1_data->value.ushort_value == value2_data->value.ushort_value);
-                break;
+    if (value == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_586: [ If `value` is NULL, `amqpvalue_pack_array` shall fail and return a non-zero value. ]*/
+        LogError("NULL value");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
+        if (value_data->type != AMQP_TYPE_ARRAY)
+        {
+            /* Codes_SRS_AMQPVALUE_01_587: [ If `value` is not an array, `amqpvalue_pack_array` shall fail and return a non-zero value. ]*/
+            LogError("Value is not of type ARRAY");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_AMQPVALUE_01_585: [ `amqpvalue_pack_array` shall replace the items of an array of `item_type` values by a packed copy of them and return 0, an array already packed with items of `item_type` being left untouched. ]*/
+        /* Codes_SRS_AMQPVALUE_01_588: [ If the array is empty, its items are not of `item_type`, `item_type` is not a fixed width primitive type, the array was allocated from an arena or any allocation fails, `amqpvalue_pack_array` shall fail and return a non-zero value. ]*/
+        else if (pack_array_items(value_data, item_type) != 0)
+        {
+            LogError("Could not pack array items as type %d", (int)item_type);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_get_array_span(AMQP_VALUE value, AMQP_TYPE item_type, const void** items, uint32_t* count)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_486: [ If `value`, `items` or `count` is NULL, `amqpvalue_get_array_span` shall fail and return a non-zero value. ]*/
+    if ((value == NULL) ||
+        (items == NULL) ||
+        (count == NULL))
+    {
+        LogError("Bad arguments: value = %p, items = %p, count = %p",
+            value, items, count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
+        if (value_data->type != AMQP_TYPE_ARRAY)
+        {
+            /* Codes_SRS_AMQPVALUE_01_487: [ If `value` is not an array, `amqpvalue_get_array_span` shall fail and return a non-zero value. ]*/
+            LogError("Value is not of type ARRAY");
+            result = __FAILURE__;
+        }
+        else if ((value_data->value.array_value.count == 0) &&
+            (value_data->value.array_value.packed_item_type == AMQP_TYPE_UNKNOWN))
+        {
+            /* Codes_SRS_AMQPVALUE_01_489: [ For an empty array `amqpvalue_get_array_span` shall set `items` to NULL and `count` to 0. ]*/
+            *items = NULL;
+            *count = 0;
+            result = 0;
+        }
+        /* Codes_SRS_AMQPVALUE_01_488: [ If the items of the array are not of `item_type` or `item_type` is not a fixed width primitive type, `amqpvalue_get_array_span` shall fail and return a non-zero value. ]*/
+        /* Codes_SRS_AMQPVALUE_01_490: [ If the array is not packed, `amqpvalue_get_array_span` shall fail and return a non-zero value, leaving the array untouched. ]*/
+        else if (value_data->value.array_value.packed_item_type != item_type)
+        {
+            LogError("Array is not packed with items of type %d", (int)item_type);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_485: [ `amqpvalue_get_array_span` shall return in `items` a pointer to the items of a packed array of `item_type`, in host byte order, and their number in `count`. ]*/
+            *items = value_data->value.array_value.packed_items;
+            *count = value_data->value.array_value.count;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_get_array_int_span(AMQP_VALUE value, const int32_t** items, uint32_t* count)
+{
+    /* Codes_SRS_AMQPVALUE_01_491: [ The typed `amqpvalue_get_array_*_span` functions shall behave like amqpvalue_get_array_span for their item type. ]*/
+    return amqpvalue_get_array_span(value, AMQP_TYPE_INT, (const void**)items, count);
+}
+
+int amqpvalue_get_array_uint_span(AMQP_VALUE value, const uint32_t** items, uint32_t* count)
+{
+    return amqpvalue_get_array_span(value, AMQP_TYPE_UINT, (const void**)items, count);
+}
+
+int amqpvalue_get_array_long_span(AMQP_VALUE value, const int64_t** items, uint32_t* count)
+{
+    return amqpvalue_get_array_span(value, AMQP_TYPE_LONG, (const void**)items, count);
+}
+
+int amqpvalue_get_array_ulong_span(AMQP_VALUE value, const uint64_t** items, uint32_t* count)
+{
+    return amqpvalue_get_array_span(value, AMQP_TYPE_ULONG, (const void**)items, count);
+}
+
+int amqpvalue_get_array_float_span(AMQP_VALUE value, const float** items, uint32_t* count)
+{
+    return amqpvalue_get_array_span(value, AMQP_TYPE_FLOAT, (const void**)items, count);
+}
+
+int amqpvalue_get_array_double_span(AMQP_VALUE value, const double** items, uint32_t* count)
+{
+    return amqpvalue_get_array_span(value, AMQP_TYPE_DOUBLE, (const void**)items, count);
+}
+
+/* Codes_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+bool amqpvalue_are_equal(AMQP_VALUE value1, AMQP_VALUE value2)
+{
+    bool result;
+
+    /* Codes_SRS_AMQPVALUE_01_207: [If value1 and value2 are NULL, amqpvalue_are_equal shall return true.] */
+    if ((value1 == NULL) &&
+        (value2 == NULL))
+    {
+        LogError("Bad arguments: value1 = %p, value2 = %p",
+            value1, value2);
+        result = true;
+    }
+    /* Codes_SRS_AMQPVALUE_01_208: [If one of the arguments is NULL and the other is not, amqpvalue_are_equal shall return false.] */
+    else if ((value1 != value2) && ((value1 == NULL) || (value2 == NULL)))
+    {
+        result = false;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* value1_data = (AMQP_VALUE_DATA*)value1;
+        AMQP_VALUE_DATA* value2_data = (AMQP_VALUE_DATA*)value2;
+
+        /* Codes_SRS_AMQPVALUE_01_209: [If the types for value1 and value2 are different amqpvalue_are_equal shall return false.] */
+#if _MSC_VER
+#pragma warning(suppress: 28182) /* The compiler states that value2_data can be NULL, but it cannot. And there are tests for it. */
+#endif
+        if (value1_data->type != value2_data->type)
+        {
+            result = false;
+        }
+        else
+        {
+            switch (value1_data->type)
+            {
+            default:
+                result = false;
+                break;
+
+            case AMQP_TYPE_NULL:
+                /* Codes_SRS_AMQPVALUE_01_210: [- null: always equal.] */
+                result = true;
+                break;
+
+            case AMQP_TYPE_BOOL:
+                /* Codes_SRS_AMQPVALUE_01_211: [- boolean: compare the bool content.] */
+                result = (value1_data->value.bool_value == value2_data->value.bool_value);
+                break;
+
+            case AMQP_TYPE_UBYTE:
+                /* Codes_SRS_AMQPVALUE_01_212: [- ubyte: compare the unsigned char content.] */
+                result = (value1_data->value.ubyte_value == value2_data->value.ubyte_value);
+                break;
+
+            case AMQP_TYPE_USHORT:
+                /* Codes_SRS_AMQPVALUE_01_213: [- ushort: compare the uint16_t content.] */
+                result = (value1_data->value.ushort_value == value2_data->value.ushort_value);
+                break;
 
             case AMQP_TYPE_UINT:
                 /* Codes_SRS_AMQPVALUE_01_214: [- uint: compare the uint32_t content.] */
@@ -2089,18 +3650,34 @@ bool amqpvalue_are_equal(AMQP_VALUE value1, AMQP_VALUE value2)
 
             case AMQP_TYPE_STRING:
                 /* Codes_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
-                result = (strcmp(value1_data->value.string_value.chars, value2_data->value.string_value.chars) == 0);
+                result = (value1_data->value.string_value.length == value2_data->value.string_value.length) &&
+                    (memcmp(value1_data->value.string_value.chars, value2_data->value.string_value.chars, value1_data->value.string_value.length) == 0);
                 break;
 
             case AMQP_TYPE_SYMBOL:
                 /* Codes_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
-                result = (strcmp(value1_data->value.symbol_value.chars, value2_data->value.symbol_value.chars) == 0);
+                if (value1_data->value.symbol_value.chars == value2_data->value.symbol_value.chars)
+                {
+                    result = true;
+                }
+                else if (value1_data->is_interned && value2_data->is_interned)
+                {
+                    /* Codes_SRS_AMQPVALUE_01_459: [ Two interned symbols shall be compared by identity, without comparing their characters. ]*/
+                    result = false;
+                }
+                else
+                {
+                    result = (value1_data->value.symbol_value.length == value2_data->value.symbol_value.length) &&
+                        (memcmp(value1_data->value.symbol_value.chars, value2_data->value.symbol_value.chars, value1_data->value.symbol_value.length) == 0);
+                }
                 break;
 
             case AMQP_TYPE_LIST:
             {
                 /* Codes_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-                if (value1_data->value.list_value.count != value2_data->value.list_value.count)
+                if ((value1_data->value.list_value.count != value2_data->value.list_value.count) ||
+                    (decode_all_list_items(value1_data) != 0) ||
+                    (decode_all_list_items(value2_data) != 0))
                 {
                     result = false;
                 }
@@ -2149,6 +3726,51 @@ bool amqpvalue_are_equal(AMQP_VALUE value1, AMQP_VALUE value2)
 
                 break;
             }
+
+            case AMQP_TYPE_ARRAY:
+            {
+                /* Codes_SRS_AMQPVALUE_01_439: [- array: compare array item count and each element.] */
+                if (value1_data->value.array_value.count != value2_data->value.array_value.count)
+                {
+                    result = false;
+                }
+                else if ((value1_data->value.array_value.packed_item_type != AMQP_TYPE_UNKNOWN) &&
+                    (value1_data->value.array_value.packed_item_type == value2_data->value.array_value.packed_item_type) &&
+                    (value1_data->value.array_value.packed_item_type != AMQP_TYPE_FLOAT) &&
+                    (value1_data->value.array_value.packed_item_type != AMQP_TYPE_DOUBLE))
+                {
+                    /* integer and uuid items are equal exactly when their bytes are (floating point ones are not, think of NaN and -0.0) */
+                    result = (memcmp(value1_data->value.array_value.packed_items, value2_data->value.array_value.packed_items,
+                        (size_t)value1_data->value.array_value.count * get_packed_array_item_size(value1_data->value.array_value.packed_item_type)) == 0);
+                }
+                else
+                {
+                    /* Codes_SRS_AMQPVALUE_01_589: [ Comparing, checking the equality of or hashing a packed array shall read its items in place, the array stays packed. ]*/
+                    AMQP_VALUE_DATA packed_item1;
+                    AMQP_VALUE_DATA packed_item2;
+                    uint32_t i;
+
+                    for (i = 0; i < value1_data->value.array_value.count; i++)
+                    {
+                        if (!amqpvalue_are_equal(get_array_item_view(&value1_data->value.array_value, i, &packed_item1),
+                            get_array_item_view(&value2_data->value.array_value, i, &packed_item2)))
+                        {
+                            break;
+                        }
+                    }
+
+                    result = (i == value1_data->value.array_value.count);
+                }
+
+                break;
+            }
+
+            case AMQP_TYPE_DESCRIBED:
+            case AMQP_TYPE_COMPOSITE:
+                /* Codes_SRS_AMQPVALUE_01_440: [- described and composite: compare the descriptor and the described value.] */
+                result = amqpvalue_are_equal(value1_data->value.described_value.descriptor, value2_data->value.described_value.descriptor) &&
+                    amqpvalue_are_equal(value1_data->value.described_value.value, value2_data->value.described_value.value);
+                break;
             }
         }
     }
@@ -2156,760 +3778,4051 @@ bool amqpvalue_are_equal(AMQP_VALUE value1, AMQP_VALUE value2)
     return result;
 }
 
-AMQP_VALUE amqpvalue_clone(AMQP_VALUE value)
+static uint32_t hash_bytes(uint32_t hash, const void* bytes, size_t length)
 {
-    AMQP_VALUE result;
+    const unsigned char* current = (const unsigned char*)bytes;
+    size_t i;
 
-    if (value == NULL)
-    {
-        /* Codes_SRS_AMQPVALUE_01_402: [ If `value` is NULL, `amqpvalue_clone` shall return NULL. ]*/
-        LogError("NULL value");
-        result = NULL;
-    }
-    else
+    /* FNV-1a */
+    for (i = 0; i < length; i++)
     {
-        /* Codes_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-        INC_REF(AMQP_VALUE_DATA, value);
-        result = value;
+        hash ^= current[i];
+        hash *= 16777619U;
     }
 
-    return result;
-}
-
-AMQP_TYPE amqpvalue_get_type(AMQP_VALUE value)
-{
-    AMQP_VALUE_DATA* amqpvalue_data = (AMQP_VALUE_DATA*)value;
-    return amqpvalue_data->type;
+    return hash;
 }
 
-static int output_byte(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, unsigned char b)
+static uint32_t hash_uint64(uint32_t hash, uint64_t value)
 {
-    int result;
+    unsigned char bytes[8];
+    size_t i;
 
-    if (encoder_output != NULL)
-    {
-        /* Codes_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
-        /* Codes_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
-        result = encoder_output(context, &b, 1);
-    }
-    else
+    for (i = 0; i < sizeof(bytes); i++)
     {
-        result = 0;
+        bytes[i] = (unsigned char)(value >> (i * 8));
     }
 
-    return result;
+    return hash_bytes(hash, bytes, sizeof(bytes));
 }
 
-static int output_bytes(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const void* bytes, size_t length)
+uint32_t amqpvalue_hash(AMQP_VALUE value)
 {
-    int result;
+    uint32_t result;
 
-    if (encoder_output != NULL)
+    if (value == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
-        /* Codes_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
-        result = encoder_output(context, (const unsigned char*)bytes, length);
+        /* Codes_SRS_AMQPVALUE_01_442: [ If `value` is NULL, `amqpvalue_hash` shall return 0. ]*/
+        result = 0;
     }
     else
     {
-        result = 0;
-    }
+        /* Codes_SRS_AMQPVALUE_01_441: [ `amqpvalue_hash` shall return a hash of the type and contents of `value`, so that values for which amqpvalue_are_equal returns true have the same hash. ]*/
+        result = hash_uint64(2166136261U, (uint64_t)value->type);
 
-    return result;
-}
+        switch (value->type)
+        {
+        default:
+            break;
 
-static int encode_boolean(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, bool value)
-{
-    int result;
+        case AMQP_TYPE_BOOL:
+            result = hash_uint64(result, value->value.bool_value ? 1 : 0);
+            break;
 
-    if (value == false)
-    {
-        /* Codes_SRS_AMQPVALUE_01_273: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
-        if (output_byte(encoder_output, context, 0x42) != 0)
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding boolean");
-            result = __FAILURE__;
-        }
-        else
-        {
-            result = 0;
-        }
-    }
-    else
-    {
-        /* Codes_SRS_AMQPVALUE_01_272: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
-        if (output_byte(encoder_output, context, 0x41) != 0)
+        case AMQP_TYPE_UBYTE:
+            result = hash_uint64(result, value->value.ubyte_value);
+            break;
+
+        case AMQP_TYPE_USHORT:
+            result = hash_uint64(result, value->value.ushort_value);
+            break;
+
+        case AMQP_TYPE_UINT:
+            result = hash_uint64(result, value->value.uint_value);
+            break;
+
+        case AMQP_TYPE_ULONG:
+            result = hash_uint64(result, value->value.ulong_value);
+            break;
+
+        case AMQP_TYPE_BYTE:
+            result = hash_uint64(result, (uint64_t)(int64_t)value->value.byte_value);
+            break;
+
+        case AMQP_TYPE_SHORT:
+            result = hash_uint64(result, (uint64_t)(int64_t)value->value.short_value);
+            break;
+
+        case AMQP_TYPE_INT:
+            result = hash_uint64(result, (uint64_t)(int64_t)value->value.int_value);
+            break;
+
+        case AMQP_TYPE_LONG:
+            result = hash_uint64(result, (uint64_t)value->value.long_value);
+            break;
+
+        case AMQP_TYPE_FLOAT:
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding boolean");
-            result = __FAILURE__;
+            /* 0.0 and -0.0 compare equal, so they have to hash the same */
+            float float_value = (value->value.float_value == 0) ? 0 : value->value.float_value;
+            result = hash_bytes(result, &float_value, sizeof(float_value));
+            break;
         }
-        else
+
+        case AMQP_TYPE_DOUBLE:
         {
-            result = 0;
+            double double_value = (value->value.double_value == 0) ? 0 : value->value.double_value;
+            result = hash_bytes(result, &double_value, sizeof(double_value));
+            break;
         }
-    }
 
-    return result;
-}
+        case AMQP_TYPE_CHAR:
+            result = hash_uint64(result, value->value.char_value);
+            break;
 
-static int encode_ubyte(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, unsigned char value)
-{
-    int result;
+        case AMQP_TYPE_TIMESTAMP:
+            result = hash_uint64(result, (uint64_t)value->value.timestamp_value);
+            break;
 
-    /* Codes_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-    if ((output_byte(encoder_output, context, 0x50) != 0) ||
-        (output_byte(encoder_output, context, value) != 0))
-    {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failed encoding ubyte");
+        case AMQP_TYPE_UUID:
+            result = hash_bytes(result, value->value.uuid_value, sizeof(value->value.uuid_value));
+            break;
+
+        case AMQP_TYPE_BINARY:
+            result = hash_bytes(result, value->value.binary_value.bytes, value->value.binary_value.length);
+            break;
+
+        case AMQP_TYPE_STRING:
+            result = hash_bytes(result, value->value.string_value.chars, value->value.string_value.length);
+            break;
+
+        case AMQP_TYPE_SYMBOL:
+            result = hash_bytes(result, value->value.symbol_value.chars, value->value.symbol_value.length);
+            break;
+
+        case AMQP_TYPE_LIST:
+        {
+            uint32_t i;
+            for (i = 0; i < value->value.list_value.count; i++)
+            {
+                /* an item that cannot be decoded hashes like a NULL value */
+                result = hash_uint64(result, amqpvalue_hash(get_list_item_data(value, i)));
+            }
+            break;
+        }
+
+        case AMQP_TYPE_MAP:
+        {
+            uint32_t i;
+            for (i = 0; i < value->value.map_value.pair_count; i++)
+            {
+                result = hash_uint64(result, amqpvalue_hash(value->value.map_value.pairs[i].key));
+                result = hash_uint64(result, amqpvalue_hash(value->value.map_value.pairs[i].value));
+            }
+            break;
+        }
+
+        case AMQP_TYPE_ARRAY:
+        {
+            AMQP_VALUE_DATA packed_item;
+            uint32_t i;
+
+            for (i = 0; i < value->value.array_value.count; i++)
+            {
+                result = hash_uint64(result, amqpvalue_hash(get_array_item_view(&value->value.array_value, i, &packed_item)));
+            }
+            break;
+        }
+
+        case AMQP_TYPE_DESCRIBED:
+        case AMQP_TYPE_COMPOSITE:
+            result = hash_uint64(result, amqpvalue_hash(value->value.described_value.descriptor));
+            result = hash_uint64(result, amqpvalue_hash(value->value.described_value.value));
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int compare_bytes(const unsigned char* bytes1, uint32_t length1, const unsigned char* bytes2, uint32_t length2)
+{
+    int result = memcmp(bytes1, bytes2, (length1 < length2) ? length1 : length2);
+
+    if (result == 0)
+    {
+        result = (length1 < length2) ? -1 : ((length1 > length2) ? 1 : 0);
+    }
+
+    return result;
+}
+
+static int compare_value_arrays(const AMQP_VALUE* items1, uint32_t count1, const AMQP_VALUE* items2, uint32_t count2)
+{
+    int result = 0;
+    uint32_t i;
+
+    for (i = 0; (i < count1) && (i < count2) && (result == 0); i++)
+    {
+        result = amqpvalue_compare(items1[i], items2[i]);
+    }
+
+    if (result == 0)
+    {
+        result = (count1 < count2) ? -1 : ((count1 > count2) ? 1 : 0);
+    }
+
+    return result;
+}
+
+/* NaN has no place in the order of the other values, it is sorted after them and compares equal to itself */
+#define COMPARE_FLOATING_POINT(value1, value2) \
+    (((value1) != (value1)) ? (((value2) != (value2)) ? 0 : 1) : \
+    (((value2) != (value2)) ? -1 : \
+    (((value1) < (value2)) ? -1 : (((value1) > (value2)) ? 1 : 0))))
+
+#define COMPARE_INTEGER(value1, value2) \
+    (((value1) < (value2)) ? -1 : (((value1) > (value2)) ? 1 : 0))
+
+int amqpvalue_compare(AMQP_VALUE value1, AMQP_VALUE value2)
+{
+    int result;
+
+    if (value1 == value2)
+    {
+        /* Codes_SRS_AMQPVALUE_01_444: [ If `value1` and `value2` are the same value (or both NULL), `amqpvalue_compare` shall return 0. ]*/
+        result = 0;
+    }
+    else if (value1 == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_445: [ A NULL value shall be ordered before any other value. ]*/
+        result = -1;
+    }
+    else if (value2 == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_445: [ A NULL value shall be ordered before any other value. ]*/
+        result = 1;
+    }
+    else if (value1->type != value2->type)
+    {
+        /* Codes_SRS_AMQPVALUE_01_446: [ Values of different types shall be ordered by their AMQP_TYPE. ]*/
+        result = COMPARE_INTEGER(value1->type, value2->type);
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_443: [ `amqpvalue_compare` shall return a negative value, 0 or a positive value when `value1` is ordered before, equal to or after `value2`, returning 0 exactly when amqpvalue_are_equal returns true, except for NaN floating point values which compare equal to each other. ]*/
+        switch (value1->type)
+        {
+        default:
+        case AMQP_TYPE_NULL:
+            result = 0;
+            break;
+
+        case AMQP_TYPE_BOOL:
+            result = COMPARE_INTEGER(value1->value.bool_value ? 1 : 0, value2->value.bool_value ? 1 : 0);
+            break;
+
+        case AMQP_TYPE_UBYTE:
+            result = COMPARE_INTEGER(value1->value.ubyte_value, value2->value.ubyte_value);
+            break;
+
+        case AMQP_TYPE_USHORT:
+            result = COMPARE_INTEGER(value1->value.ushort_value, value2->value.ushort_value);
+            break;
+
+        case AMQP_TYPE_UINT:
+            result = COMPARE_INTEGER(value1->value.uint_value, value2->value.uint_value);
+            break;
+
+        case AMQP_TYPE_ULONG:
+            result = COMPARE_INTEGER(value1->value.ulong_value, value2->value.ulong_value);
+            break;
+
+        case AMQP_TYPE_BYTE:
+            result = COMPARE_INTEGER(value1->value.byte_value, value2->value.byte_value);
+            break;
+
+        case AMQP_TYPE_SHORT:
+            result = COMPARE_INTEGER(value1->value.short_value, value2->value.short_value);
+            break;
+
+        case AMQP_TYPE_INT:
+            result = COMPARE_INTEGER(value1->value.int_value, value2->value.int_value);
+            break;
+
+        case AMQP_TYPE_LONG:
+            result = COMPARE_INTEGER(value1->value.long_value, value2->value.long_value);
+            break;
+
+        case AMQP_TYPE_FLOAT:
+            result = COMPARE_FLOATING_POINT(value1->value.float_value, value2->value.float_value);
+            break;
+
+        case AMQP_TYPE_DOUBLE:
+            result = COMPARE_FLOATING_POINT(value1->value.double_value, value2->value.double_value);
+            break;
+
+        case AMQP_TYPE_CHAR:
+            result = COMPARE_INTEGER(value1->value.char_value, value2->value.char_value);
+            break;
+
+        case AMQP_TYPE_TIMESTAMP:
+            result = COMPARE_INTEGER(value1->value.timestamp_value, value2->value.timestamp_value);
+            break;
+
+        case AMQP_TYPE_UUID:
+            result = memcmp(value1->value.uuid_value, value2->value.uuid_value, sizeof(value1->value.uuid_value));
+            break;
+
+        case AMQP_TYPE_BINARY:
+            result = compare_bytes((const unsigned char*)value1->value.binary_value.bytes, value1->value.binary_value.length,
+                (const unsigned char*)value2->value.binary_value.bytes, value2->value.binary_value.length);
+            break;
+
+        case AMQP_TYPE_STRING:
+            result = compare_bytes((const unsigned char*)value1->value.string_value.chars, value1->value.string_value.length,
+                (const unsigned char*)value2->value.string_value.chars, value2->value.string_value.length);
+            break;
+
+        case AMQP_TYPE_SYMBOL:
+            result = (value1->value.symbol_value.chars == value2->value.symbol_value.chars) ? 0 :
+                compare_bytes((const unsigned char*)value1->value.symbol_value.chars, value1->value.symbol_value.length,
+                    (const unsigned char*)value2->value.symbol_value.chars, value2->value.symbol_value.length);
+            break;
+
+        case AMQP_TYPE_LIST:
+            /* items that cannot be decoded stay NULL and are ordered like NULL values */
+            (void)decode_all_list_items(value1);
+            (void)decode_all_list_items(value2);
+            result = compare_value_arrays(value1->value.list_value.items, value1->value.list_value.count,
+                value2->value.list_value.items, value2->value.list_value.count);
+            break;
+
+        case AMQP_TYPE_ARRAY:
+        {
+            AMQP_VALUE_DATA packed_item1;
+            AMQP_VALUE_DATA packed_item2;
+            uint32_t i;
+
+            result = 0;
+            for (i = 0; (i < value1->value.array_value.count) && (i < value2->value.array_value.count) && (result == 0); i++)
+            {
+                result = amqpvalue_compare(get_array_item_view(&value1->value.array_value, i, &packed_item1),
+                    get_array_item_view(&value2->value.array_value, i, &packed_item2));
+            }
+
+            if (result == 0)
+            {
+                result = COMPARE_INTEGER(value1->value.array_value.count, value2->value.array_value.count);
+            }
+            break;
+        }
+
+        case AMQP_TYPE_MAP:
+        {
+            uint32_t i;
+
+            result = 0;
+            for (i = 0; (i < value1->value.map_value.pair_count) && (i < value2->value.map_value.pair_count) && (result == 0); i++)
+            {
+                result = amqpvalue_compare(value1->value.map_value.pairs[i].key, value2->value.map_value.pairs[i].key);
+                if (result == 0)
+                {
+                    result = amqpvalue_compare(value1->value.map_value.pairs[i].value, value2->value.map_value.pairs[i].value);
+                }
+            }
+
+            if (result == 0)
+            {
+                result = COMPARE_INTEGER(value1->value.map_value.pair_count, value2->value.map_value.pair_count);
+            }
+            break;
+        }
+
+        case AMQP_TYPE_DESCRIBED:
+        case AMQP_TYPE_COMPOSITE:
+            result = amqpvalue_compare(value1->value.described_value.descriptor, value2->value.described_value.descriptor);
+            if (result == 0)
+            {
+                result = amqpvalue_compare(value1->value.described_value.value, value2->value.described_value.value);
+            }
+            break;
+        }
+
+        /* memcmp and strcmp may return any magnitude */
+        result = (result < 0) ? -1 : ((result > 0) ? 1 : 0);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE clone_value_contents(AMQP_VALUE_DATA* value_data)
+{
+    AMQP_VALUE result;
+
+    switch (value_data->type)
+    {
+    default:
+        result = create_value_data();
+        if (result == NULL)
+        {
+            LogError("Could not allocate memory for cloned value");
+        }
+        else
+        {
+            result->type = value_data->type;
+            result->value = value_data->value;
+        }
+        break;
+
+    case AMQP_TYPE_BINARY:
+        result = amqpvalue_create_binary(value_data->value.binary_value);
+        break;
+
+    case AMQP_TYPE_STRING:
+        result = create_string_value(value_data->value.string_value.chars, value_data->value.string_value.length);
+        break;
+
+    case AMQP_TYPE_SYMBOL:
+        result = amqpvalue_create_symbol(value_data->value.symbol_value.chars);
+        break;
+
+    case AMQP_TYPE_LIST:
+    {
+        result = amqpvalue_create_list_with_capacity(value_data->value.list_value.count);
+        if (result == NULL)
+        {
+            LogError("Could not create cloned list");
+        }
+        else
+        {
+            uint32_t i;
+            for (i = 0; i < value_data->value.list_value.count; i++)
+            {
+                /* Codes_SRS_AMQPVALUE_01_463: [ Cloning a lazily decoded list shall decode all its items, the clone does not reference the decoded bytes. ]*/
+                AMQP_VALUE item = get_list_item_data(value_data, i);
+                if ((item == NULL) ||
+                    (amqpvalue_set_list_item(result, i, item) != 0))
+                {
+                    LogError("Could not clone list item %u", (unsigned int)i);
+                    break;
+                }
+            }
+
+            if (i < value_data->value.list_value.count)
+            {
+                amqpvalue_destroy(result);
+                result = NULL;
+            }
+        }
+        break;
+    }
+
+    case AMQP_TYPE_MAP:
+    {
+        result = amqpvalue_create_map_with_capacity(value_data->value.map_value.pair_count);
+        if (result == NULL)
+        {
+            LogError("Could not create cloned map");
+        }
+        else
+        {
+            uint32_t i;
+            for (i = 0; i < value_data->value.map_value.pair_count; i++)
+            {
+                if (amqpvalue_set_map_value(result, value_data->value.map_value.pairs[i].key, value_data->value.map_value.pairs[i].value) != 0)
+                {
+                    LogError("Could not clone map pair %u", (unsigned int)i);
+                    break;
+                }
+            }
+
+            if (i < value_data->value.map_value.pair_count)
+            {
+                amqpvalue_destroy(result);
+                result = NULL;
+            }
+        }
+        break;
+    }
+
+    case AMQP_TYPE_ARRAY:
+    {
+        if (value_data->value.array_value.packed_item_type != AMQP_TYPE_UNKNOWN)
+        {
+            result = amqpvalue_create_array_from_span(value_data->value.array_value.packed_item_type, value_data->value.array_value.packed_items, value_data->value.array_value.count);
+            if (result == NULL)
+            {
+                LogError("Could not create cloned packed array");
+            }
+        }
+        else
+        {
+            result = amqpvalue_create_array_with_capacity(value_data->value.array_value.count);
+            if (result == NULL)
+            {
+                LogError("Could not create cloned array");
+            }
+            else
+            {
+                uint32_t i;
+                for (i = 0; i < value_data->value.array_value.count; i++)
+                {
+                    if (amqpvalue_add_array_item(result, value_data->value.array_value.items[i]) != 0)
+                    {
+                        LogError("Could not clone array item %u", (unsigned int)i);
+                        break;
+                    }
+                }
+
+                if (i < value_data->value.array_value.count)
+                {
+                    amqpvalue_destroy(result);
+                    result = NULL;
+                }
+            }
+        }
+        break;
+    }
+
+    case AMQP_TYPE_COMPOSITE:
+    case AMQP_TYPE_DESCRIBED:
+    {
+        AMQP_VALUE_DATA* cloned_value = create_value_data();
+        if (cloned_value == NULL)
+        {
+            LogError("Could not allocate memory for cloned described value");
+            result = NULL;
+        }
+        else
+        {
+            cloned_value->type = value_data->type;
+            cloned_value->value.described_value.descriptor = amqpvalue_clone(value_data->value.described_value.descriptor);
+            if (cloned_value->value.described_value.descriptor == NULL)
+            {
+                LogError("Could not clone descriptor");
+                free(cloned_value);
+                result = NULL;
+            }
+            else
+            {
+                cloned_value->value.described_value.value = amqpvalue_clone(value_data->value.described_value.value);
+                if (cloned_value->value.described_value.value == NULL)
+                {
+                    LogError("Could not clone described value");
+                    amqpvalue_destroy(cloned_value->value.described_value.descriptor);
+                    free(cloned_value);
+                    result = NULL;
+                }
+                else
+                {
+                    result = cloned_value;
+                }
+            }
+        }
+        break;
+    }
+    }
+
+    return result;
+}
+
+AMQP_VALUE amqpvalue_clone(AMQP_VALUE value)
+{
+    AMQP_VALUE result;
+
+    if (value == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_402: [ If `value` is NULL, `amqpvalue_clone` shall return NULL. ]*/
+        LogError("NULL value");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+        if (value->is_arena_allocated)
+        {
+            /* Codes_SRS_AMQPVALUE_01_418: [ Cloning a value allocated from an arena shall produce a copy that does not reference the arena. ]*/
+            result = clone_value_contents(value);
+        }
+        else if (value->is_borrowed)
+        {
+            /* Codes_SRS_AMQPVALUE_01_424: [ Cloning a borrowed value (or a value containing borrowed values) shall copy the borrowed bytes. ]*/
+            result = clone_value_contents(value);
+        }
+        else
+        {
+            INC_REF(AMQP_VALUE_DATA, value);
+            result = value;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_make_writable(AMQP_VALUE* value)
+{
+    int result;
+
+    if ((value == NULL) ||
+        (*value == NULL))
+    {
+        /* Codes_SRS_AMQPVALUE_01_433: [ If `value` or `*value` is NULL, `amqpvalue_make_writable` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: value = %p", value);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)*value;
+        bool is_shared;
+
+        if (value_data->is_arena_allocated)
+        {
+            /* Codes_SRS_AMQPVALUE_01_435: [ A value allocated from an arena shall always be copied. ]*/
+            is_shared = true;
+        }
+        else
+        {
+            /* the count is read, not changed, so other holders of the value never see it go through a wrong value */
+            is_shared = (get_value_reference_count(value_data) != 1);
+        }
+
+        if (!is_shared)
+        {
+            if ((value_data->type == AMQP_TYPE_COMPOSITE) ||
+                (value_data->type == AMQP_TYPE_DESCRIBED))
+            {
+                /* Codes_SRS_AMQPVALUE_01_436: [ For a described or composite value, the described value shall also be made writable. ]*/
+                result = amqpvalue_make_writable(&value_data->value.described_value.value);
+            }
+            else
+            {
+                /* Codes_SRS_AMQPVALUE_01_434: [ If the caller holds the only reference to `*value`, `amqpvalue_make_writable` shall leave it untouched and return 0. ]*/
+                result = 0;
+            }
+        }
+        else
+        {
+            AMQP_VALUE copy;
+
+            if ((value_data->type == AMQP_TYPE_COMPOSITE) ||
+                (value_data->type == AMQP_TYPE_DESCRIBED))
+            {
+                AMQP_VALUE descriptor = amqpvalue_clone(value_data->value.described_value.descriptor);
+                AMQP_VALUE described_value = amqpvalue_clone(value_data->value.described_value.value);
+                if ((descriptor == NULL) ||
+                    (described_value == NULL) ||
+                    (amqpvalue_make_writable(&described_value) != 0))
+                {
+                    LogError("Could not copy described value");
+                    copy = NULL;
+                }
+                else
+                {
+                    copy = amqpvalue_create_described(descriptor, described_value);
+                }
+
+                if (copy == NULL)
+                {
+                    if (descriptor != NULL)
+                    {
+                        amqpvalue_destroy(descriptor);
+                    }
+
+                    if (described_value != NULL)
+                    {
+                        amqpvalue_destroy(described_value);
+                    }
+                }
+                else
+                {
+                    copy->type = value_data->type;
+                }
+            }
+            else
+            {
+                /* the items of a copied list, map or array are shared with the original until they are replaced */
+                copy = clone_value_contents(value_data);
+            }
+
+            if (copy == NULL)
+            {
+                /* Codes_SRS_AMQPVALUE_01_437: [ If copying the value fails, `amqpvalue_make_writable` shall fail, leave `*value` untouched and return a non-zero value. ]*/
+                LogError("Could not copy shared value");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_AMQPVALUE_01_432: [ If `*value` is shared with other holders, `amqpvalue_make_writable` shall replace it with a copy that only the caller references, releasing the caller's reference to the original. ]*/
+                amqpvalue_destroy(*value);
+                *value = copy;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+AMQP_TYPE amqpvalue_get_type(AMQP_VALUE value)
+{
+    AMQP_VALUE_DATA* amqpvalue_data = (AMQP_VALUE_DATA*)value;
+    return amqpvalue_data->type;
+}
+
+typedef struct ENCODE_TO_BUFFER_CONTEXT_TAG
+{
+    unsigned char* buffer;
+    size_t size;
+    size_t position;
+} ENCODE_TO_BUFFER_CONTEXT;
+
+static int write_to_buffer(void* context, const unsigned char* bytes, size_t length)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT* encode_context = (ENCODE_TO_BUFFER_CONTEXT*)context;
+
+    if (length > (encode_context->size - encode_context->position))
+    {
+        LogError("Encoded value does not fit the buffer");
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(encode_context->buffer + encode_context->position, bytes, length);
+        encode_context->position += length;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int output_byte(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, unsigned char b)
+{
+    int result;
+
+    if (encoder_output == write_to_buffer)
+    {
+        /* encoding into a buffer, store the byte directly instead of going through the callback */
+        ENCODE_TO_BUFFER_CONTEXT* encode_context = (ENCODE_TO_BUFFER_CONTEXT*)context;
+        if (encode_context->position >= encode_context->size)
+        {
+            LogError("Encoded value does not fit the buffer");
+            result = __FAILURE__;
+        }
+        else
+        {
+            encode_context->buffer[encode_context->position++] = b;
+            result = 0;
+        }
+    }
+    else if (encoder_output != NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
+        /* Codes_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
+        result = encoder_output(context, &b, 1);
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int output_bytes(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const void* bytes, size_t length)
+{
+    int result;
+
+    if (encoder_output == write_to_buffer)
+    {
+        result = write_to_buffer(context, (const unsigned char*)bytes, length);
+    }
+    else if (encoder_output != NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
+        /* Codes_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
+        result = encoder_output(context, (const unsigned char*)bytes, length);
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Multi-byte fields are written in network byte order with one output call, rather than one call per byte */
+static int output_uint16(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint16_t value)
+{
+    unsigned char bytes[2];
+
+    bytes[0] = (unsigned char)(value >> 8);
+    bytes[1] = (unsigned char)(value & 0xFF);
+
+    return output_bytes(encoder_output, context, bytes, sizeof(bytes));
+}
+
+static int output_uint32(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t value)
+{
+    unsigned char bytes[4];
+
+    bytes[0] = (unsigned char)(value >> 24);
+    bytes[1] = (unsigned char)((value >> 16) & 0xFF);
+    bytes[2] = (unsigned char)((value >> 8) & 0xFF);
+    bytes[3] = (unsigned char)(value & 0xFF);
+
+    return output_bytes(encoder_output, context, bytes, sizeof(bytes));
+}
+
+static int output_uint64(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint64_t value)
+{
+    unsigned char bytes[8];
+
+    bytes[0] = (unsigned char)(value >> 56);
+    bytes[1] = (unsigned char)((value >> 48) & 0xFF);
+    bytes[2] = (unsigned char)((value >> 40) & 0xFF);
+    bytes[3] = (unsigned char)((value >> 32) & 0xFF);
+    bytes[4] = (unsigned char)((value >> 24) & 0xFF);
+    bytes[5] = (unsigned char)((value >> 16) & 0xFF);
+    bytes[6] = (unsigned char)((value >> 8) & 0xFF);
+    bytes[7] = (unsigned char)(value & 0xFF);
+
+    return output_bytes(encoder_output, context, bytes, sizeof(bytes));
+}
+
+static int encode_boolean(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, bool value)
+{
+    int result;
+
+    if (value == false)
+    {
+        /* Codes_SRS_AMQPVALUE_01_273: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
+        if (output_byte(encoder_output, context, 0x42) != 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding boolean");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_272: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
+        if (output_byte(encoder_output, context, 0x41) != 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding boolean");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_ubyte(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, unsigned char value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+    if ((output_byte(encoder_output, context, 0x50) != 0) ||
+        (output_byte(encoder_output, context, value) != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failed encoding ubyte");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_ushort(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint16_t value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+    if ((output_byte(encoder_output, context, 0x60) != 0) ||
+        (output_uint16(encoder_output, context, value) != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failed encoding ushort");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_uint(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t value)
+{
+    int result;
+
+    if (value == 0)
+    {
+        /* uint0 */
+        /* Codes_SRS_AMQPVALUE_01_279: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
+        if (output_byte(encoder_output, context, 0x43) != 0)
+        {
+            LogError("Failed encoding uint");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else if (value <= 255)
+    {
+        /* smalluint */
+        /* Codes_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
+        if ((output_byte(encoder_output, context, 0x52) != 0) ||
+            (output_byte(encoder_output, context, value & 0xFF) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding uint");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
+        if ((output_byte(encoder_output, context, 0x70) != 0) ||
+            (output_uint32(encoder_output, context, value) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding uint");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_ulong(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint64_t value)
+{
+    int result;
+    if (value == 0)
+    {
+        /* ulong0 */
+        /* Codes_SRS_AMQPVALUE_01_282: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
+        if (output_byte(encoder_output, context, 0x44) != 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding ulong");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else if (value <= 255)
+    {
+        /* smallulong */
+        /* Codes_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+        if ((output_byte(encoder_output, context, 0x53) != 0) ||
+            (output_byte(encoder_output, context, value & 0xFF) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding ulong");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
+        if ((output_byte(encoder_output, context, 0x80) != 0) ||
+            (output_uint64(encoder_output, context, value) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding ulong");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_byte(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, char value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+    if ((output_byte(encoder_output, context, 0x51) != 0) ||
+        (output_byte(encoder_output, context, value) != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failed encoding byte");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_short(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int16_t value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+    if ((output_byte(encoder_output, context, 0x61) != 0) ||
+        (output_uint16(encoder_output, context, (uint16_t)value) != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failed encoding short");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_int(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int32_t value)
+{
+    int result;
+
+    if ((value <= 127) && (value >= -128))
+    {
+        /* Codes_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+        if ((output_byte(encoder_output, context, 0x54) != 0) ||
+            (output_byte(encoder_output, context, value & 0xFF) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding int");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+        if ((output_byte(encoder_output, context, 0x71) != 0) ||
+            (output_uint32(encoder_output, context, (uint32_t)value) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding int");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_long(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int64_t value)
+{
+    int result;
+
+    if ((value <= 127) && (value >= -128))
+    {
+        /* Codes_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+        if ((output_byte(encoder_output, context, 0x55) != 0) ||
+            (output_byte(encoder_output, context, value & 0xFF) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding long");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
+        if ((output_byte(encoder_output, context, 0x81) != 0) ||
+            (output_uint64(encoder_output, context, (uint64_t)value) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding long");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_float(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, float value)
+{
+    int result;
+
+    uint32_t value_as_uint32 = *((uint32_t*)(void*)&value);
+    /* Codes_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>] */
+    if ((output_byte(encoder_output, context, 0x72) != 0) ||
+        (output_uint32(encoder_output, context, value_as_uint32) != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failure encoding bytes for float");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_double(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, double value)
+{
+    int result;
+
+    uint64_t value_as_uint64 = *((uint64_t*)(void*)&value);
+    /* Codes_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>] */
+    if ((output_byte(encoder_output, context, 0x82) != 0) ||
+        (output_uint64(encoder_output, context, value_as_uint64) != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failure encoding bytes for double");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_timestamp(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int64_t value)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+    if ((output_byte(encoder_output, context, 0x83) != 0) ||
+        (output_uint64(encoder_output, context, (uint64_t)value) != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failed encoding timestamp");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_uuid(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uuid uuid)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
+    if ((output_byte(encoder_output, context, 0x98) != 0) ||
+        (output_bytes(encoder_output, context, uuid, 16)  != 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        LogError("Failed encoding uuid");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_binary(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const unsigned char* value, uint32_t length)
+{
+    int result;
+    if (length <= 255)
+    {
+        /* Codes_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+        if ((output_byte(encoder_output, context, 0xA0) != 0) ||
+            (output_byte(encoder_output, context, (unsigned char)length) != 0) ||
+            ((length > 0) && (output_bytes(encoder_output, context, value, length) != 0)))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding binary");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_298: [<encoding name="vbin32" code="0xb0" category="variable" width="4" label="up to 2^32 - 1 octets of binary data"/>] */
+        if ((output_byte(encoder_output, context, 0xB0) != 0) ||
+            (output_uint32(encoder_output, context, length) != 0) ||
+            (output_bytes(encoder_output, context, value, length) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding binary");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_string(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value, size_t length)
+{
+    int result;
+
+    if (length <= 255)
+    {
+        /* Codes_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+        if ((output_byte(encoder_output, context, (unsigned char)0xA1) != 0) ||
+            (output_byte(encoder_output, context, (unsigned char)length) != 0) ||
+            (output_bytes(encoder_output, context, value, length) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding string");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_300: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+        if ((output_byte(encoder_output, context, 0xB1) != 0) ||
+            (output_uint32(encoder_output, context, (uint32_t)length) != 0) ||
+            (output_bytes(encoder_output, context, value, length) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding string");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_symbol(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value, size_t length)
+{
+    int result;
+
+    if (length <= 255)
+    {
+        /* Codes_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+        if ((output_byte(encoder_output, context, (unsigned char)0xA3) != 0) ||
+            (output_byte(encoder_output, context, (unsigned char)length) != 0) ||
+            (output_bytes(encoder_output, context, value, length) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding symbol");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_302: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+        if ((output_byte(encoder_output, context, 0xB3) != 0) ||
+            (output_uint32(encoder_output, context, (uint32_t)length) != 0) ||
+            /* Codes_SRS_AMQPVALUE_01_122: [Symbols are encoded as ASCII characters [ASCII].] */
+            (output_bytes(encoder_output, context, value, length) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failed encoding symbol");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int encode_list(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t count, AMQP_VALUE* items)
+{
+    size_t i;
+    int result;
+
+    if (count == 0)
+    {
+        /* Codes_SRS_AMQPVALUE_01_303: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
+        if (output_byte(encoder_output, context, 0x45) != 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Could not output list constructor byte");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = 0;
+        }
+    }
+    else
+    {
+        uint32_t size = 0;
+
+        /* get the size of all items in the list */
+        for (i = 0; i < count; i++)
+        {
+            size_t item_size;
+            if (amqpvalue_get_encoded_size(items[i], &item_size) != 0)
+            {
+                LogError("Could not get encoded size for element %u of the list", (unsigned int)i);
+                break;
+            }
+
+            if ((item_size > UINT32_MAX) ||
+                size + (uint32_t)item_size < size)
+            {
+                LogError("Overflow in list size computation");
+                break;
+            }
+
+            size = (uint32_t)(size + item_size);
+        }
+
+        if (i < count)
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            result = __FAILURE__;
+        }
+        else
+        {
+            if ((count <= 255) && (size < 255))
+            {
+                size++;
+
+                /* Codes_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+                if ((output_byte(encoder_output, context, 0xC0) != 0) ||
+                    /* size */
+                    (output_byte(encoder_output, context, (size & 0xFF)) != 0) ||
+                    /* count */
+                    (output_byte(encoder_output, context, (count & 0xFF)) != 0))
+                {
+                    /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+                    LogError("Failed encoding list");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+                    result = 0;
+                }
+            }
+            else
+            {
+                size += 4;
+
+                /* Codes_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+                if ((output_byte(encoder_output, context, 0xD0) != 0) ||
+                    /* size */
+                    (output_uint32(encoder_output, context, size) != 0) ||
+                    /* count */
+                    (output_uint32(encoder_output, context, count) != 0))
+                {
+                    /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+                    LogError("Failed encoding list");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+                    result = 0;
+                }
+            }
+
+            if (result == 0)
+            {
+                for (i = 0; i < count; i++)
+                {
+                    if (amqpvalue_encode(items[i], encoder_output, context) != 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (i < count)
+                {
+                    LogError("Failed encoding element %u of the list", (unsigned int)i);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static int encode_map(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t count, AMQP_MAP_KEY_VALUE_PAIR* pairs)
+{
+    size_t i;
+    int result;
+
+    uint32_t size = 0;
+
+    /* Codes_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
+    uint32_t elements = count * 2;
+
+    /* get the size of all items in the list */
+    for (i = 0; i < count; i++)
+    {
+        size_t item_size;
+        if (amqpvalue_get_encoded_size(pairs[i].key, &item_size) != 0)
+        {
+            LogError("Could not get encoded size for key element %u of the map", (unsigned int)i);
+            break;
+        }
+
+        if ((item_size > UINT32_MAX) ||
+            size + (uint32_t)item_size < size)
+        {
+            LogError("Encoded data is more than the max size for a map");
+            break;
+        }
+        
+        size = (uint32_t)(size + item_size);
+
+        if (amqpvalue_get_encoded_size(pairs[i].value, &item_size) != 0)
+        {
+            LogError("Could not get encoded size for value element %u of the map", (unsigned int)i);
+            break;
+        }
+
+        if ((item_size > UINT32_MAX) ||
+            size + (uint32_t)item_size < size)
+        {
+            LogError("Encoded data is more than the max size for a map");
+            break;
+        }
+
+        size = (uint32_t)(size + item_size);
+    }
+
+    if (i < count)
+    {
+        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((elements <= 255) && (size < 255))
+        {
+            size++;
+
+            /* Codes_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+            if ((output_byte(encoder_output, context, 0xC1) != 0) ||
+                /* size */
+                (output_byte(encoder_output, context, (size & 0xFF)) != 0) ||
+                /* count */
+                (output_byte(encoder_output, context, (elements & 0xFF)) != 0))
+            {
+                /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+                LogError("Could not encode map header");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+                result = 0;
+            }
+        }
+        else
+        {
+            size += 4;
+
+            /* Codes_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>] */
+            if ((output_byte(encoder_output, context, 0xD1) != 0) ||
+                /* size */
+                (output_uint32(encoder_output, context, size) != 0) ||
+                /* count */
+                (output_uint32(encoder_output, context, elements) != 0))
+            {
+                /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+                LogError("Could not encode map header");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+                result = 0;
+            }
+        }
+
+        if (result == 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
+            for (i = 0; i < count; i++)
+            {
+                if ((amqpvalue_encode(pairs[i].key, encoder_output, context) != 0) ||
+                    (amqpvalue_encode(pairs[i].value, encoder_output, context) != 0))
+                {
+                    LogError("Failed encoding map element %u", (unsigned int)i);
+                    break;
+                }
+            }
+
+            if (i < count)
+            {
+                LogError("Could not encode map");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static unsigned char get_array_item_constructor(AMQP_TYPE item_type)
+{
+    unsigned char result;
+
+    switch (item_type)
+    {
+    default:
+        result = 0x00;
+        break;
+    case AMQP_TYPE_UBYTE:
+        result = 0x50;
+        break;
+    case AMQP_TYPE_BYTE:
+        result = 0x51;
+        break;
+    case AMQP_TYPE_USHORT:
+        result = 0x60;
+        break;
+    case AMQP_TYPE_SHORT:
+        result = 0x61;
+        break;
+    case AMQP_TYPE_UINT:
+        result = 0x70;
+        break;
+    case AMQP_TYPE_INT:
+        result = 0x71;
+        break;
+    case AMQP_TYPE_FLOAT:
+        result = 0x72;
+        break;
+    case AMQP_TYPE_ULONG:
+        result = 0x80;
+        break;
+    case AMQP_TYPE_LONG:
+        result = 0x81;
+        break;
+    case AMQP_TYPE_DOUBLE:
+        result = 0x82;
+        break;
+    case AMQP_TYPE_TIMESTAMP:
+        result = 0x83;
+        break;
+    case AMQP_TYPE_UUID:
+        result = 0x98;
+        break;
+    }
+
+    return result;
+}
+
+/* Only arrays of fixed width primitives (packed or not) can be encoded: their items are all written with the wide encoding of
+   their type after a single constructor. Empty arrays are not encoded, since their item type is not known. */
+static int get_array_encoding(AMQP_VALUE_DATA* array_data, AMQP_TYPE* item_type, uint32_t* items_size)
+{
+    int result;
+    AMQP_ARRAY_VALUE* array_value = &array_data->value.array_value;
+    size_t item_size;
+
+    if (array_value->packed_item_type != AMQP_TYPE_UNKNOWN)
+    {
+        *item_type = array_value->packed_item_type;
+    }
+    else if (array_value->count > 0)
+    {
+        *item_type = array_value->items[0]->type;
+    }
+    else
+    {
+        *item_type = AMQP_TYPE_UNKNOWN;
+    }
+
+    item_size = get_packed_array_item_size(*item_type);
+    if ((item_size == 0) ||
+        (array_value->count == 0))
+    {
+        LogError("Cannot encode an array of type %d with %u items", (int)*item_type, (unsigned int)array_value->count);
+        result = __FAILURE__;
+    }
+    else if ((size_t)array_value->count > ((UINT32_MAX - 9) / item_size))
+    {
+        LogError("Array too large to encode");
+        result = __FAILURE__;
+    }
+    else
+    {
+        *items_size = array_value->count * (uint32_t)item_size;
+        result = 0;
+    }
+
+    return result;
+}
+
+static size_t get_array_encoded_size(uint32_t count, uint32_t items_size)
+{
+    size_t result;
+
+    if ((count <= 255) && (items_size <= 255 - 2))
+    {
+        /* constructor, size, count and item constructor bytes */
+        result = 4 + (size_t)items_size;
+    }
+    else
+    {
+        /* constructor, 4 bytes size, 4 bytes count and item constructor */
+        result = 10 + (size_t)items_size;
+    }
+
+    return result;
+}
+
+/* Items are byte swapped into a small buffer and written out a chunk at a time */
+#define ARRAY_ENCODE_CHUNK_SIZE 256
+
+static int encode_array(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, AMQP_VALUE_DATA* array_data)
+{
+    int result;
+    AMQP_ARRAY_VALUE* array_value = &array_data->value.array_value;
+    AMQP_TYPE item_type;
+    uint32_t items_size;
+
+    if (get_array_encoding(array_data, &item_type, &items_size) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t item_size = get_packed_array_item_size(item_type);
+        uint32_t chunk_item_count = (uint32_t)(ARRAY_ENCODE_CHUNK_SIZE / item_size);
+        uint32_t i;
+
+        if (get_array_encoded_size(array_value->count, items_size) == 4 + (size_t)items_size)
+        {
+            /* Codes_SRS_AMQPVALUE_01_494: [ An array of a fixed width primitive type shall be encoded as array8 when its count and size fit 1 byte and as array32 otherwise, with all items after a single constructor. ]*/
+            result = ((output_byte(encoder_output, context, 0xE0) != 0) ||
+                (output_byte(encoder_output, context, (unsigned char)(items_size + 2)) != 0) ||
+                (output_byte(encoder_output, context, (unsigned char)array_value->count) != 0)) ? __FAILURE__ : 0;
+        }
+        else
+        {
+            result = ((output_byte(encoder_output, context, 0xF0) != 0) ||
+                (output_uint32(encoder_output, context, items_size + 5) != 0) ||
+                (output_uint32(encoder_output, context, array_value->count) != 0)) ? __FAILURE__ : 0;
+        }
+
+        if ((result == 0) &&
+            (output_byte(encoder_output, context, get_array_item_constructor(item_type)) != 0))
+        {
+            result = __FAILURE__;
+        }
+
+        for (i = 0; (result == 0) && (i < array_value->count); i += chunk_item_count)
+        {
+            unsigned char encoded_items[ARRAY_ENCODE_CHUNK_SIZE];
+            uint32_t item_count = ((array_value->count - i) < chunk_item_count) ? (array_value->count - i) : chunk_item_count;
+
+            if (array_value->packed_item_type != AMQP_TYPE_UNKNOWN)
+            {
+                write_packed_array_items(encoded_items, array_value->packed_items + ((size_t)i * item_size), item_count, item_size);
+            }
+            else
+            {
+                unsigned char host_items[ARRAY_ENCODE_CHUNK_SIZE];
+                uint32_t j;
+
+                for (j = 0; j < item_count; j++)
+                {
+                    (void)memcpy(host_items + ((size_t)j * item_size), &array_value->items[i + j]->value, item_size);
+                }
+
+                write_packed_array_items(encoded_items, host_items, item_count, item_size);
+            }
+
+            if (output_bytes(encoder_output, context, encoded_items, (size_t)item_count * item_size) != 0)
+            {
+                result = __FAILURE__;
+            }
+        }
+
+        if (result != 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+            LogError("Failure encoding array");
+        }
+    }
+
+    return result;
+}
+
+static int encode_descriptor_header(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context)
+{
+    int result;
+
+    if (output_byte(encoder_output, context, 0x00) != 0)
+    {
+        LogError("Failed encoding descriptor header");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Codes_SRS_AMQPVALUE_01_265: [amqpvalue_encode shall encode the value per the ISO.] */
+int amqpvalue_encode(AMQP_VALUE value, AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_269: [If value or encoder_output are NULL, amqpvalue_encode shall fail and return a non-zero value.] */
+    if ((value == NULL) ||
+        (encoder_output == NULL))
+    {
+        LogError("Bad arguments: value = %p, encoder_output = %p",
+            value, encoder_output);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
+
+        switch (value_data->type)
+        {
+        default:
+            /* Codes_SRS_AMQPVALUE_01_271: [If encoding fails due to any error not specifically mentioned here, it shall return a non-zero value.] */
+            LogError("Invalid type: %d", (int)value_data->type);
+            result = __FAILURE__;
+            break;
+
+        case AMQP_TYPE_NULL:
+            /* Codes_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
+            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            result = output_byte(encoder_output, context, (unsigned char)0x40);
+            break;
+
+        case AMQP_TYPE_BOOL:
+            result = encode_boolean(encoder_output, context, value_data->value.bool_value);
+            break;
+
+        case AMQP_TYPE_UBYTE:
+            result = encode_ubyte(encoder_output, context, value_data->value.ubyte_value);
+            break;
+
+        case AMQP_TYPE_USHORT:
+            result = encode_ushort(encoder_output, context, value_data->value.ushort_value);
+            break;
+
+        case AMQP_TYPE_UINT:
+            result = encode_uint(encoder_output, context, value_data->value.uint_value);
+            break;
+
+        case AMQP_TYPE_ULONG:
+            result = encode_ulong(encoder_output, context, value_data->value.ulong_value);
+            break;
+
+        case AMQP_TYPE_BYTE:
+            result = encode_byte(encoder_output, context, value_data->value.byte_value);
+            break;
+
+        case AMQP_TYPE_SHORT:
+            result = encode_short(encoder_output, context, value_data->value.short_value);
+            break;
+
+        case AMQP_TYPE_INT:
+            result = encode_int(encoder_output, context, value_data->value.int_value);
+            break;
+
+        case AMQP_TYPE_LONG:
+            result = encode_long(encoder_output, context, value_data->value.long_value);
+            break;
+
+        case AMQP_TYPE_FLOAT:
+            result = encode_float(encoder_output, context, value_data->value.float_value);
+            break;
+
+        case AMQP_TYPE_DOUBLE:
+            result = encode_double(encoder_output, context, value_data->value.double_value);
+            break;
+
+        case AMQP_TYPE_TIMESTAMP:
+            result = encode_timestamp(encoder_output, context, value_data->value.timestamp_value);
+            break;
+
+        case AMQP_TYPE_UUID:
+            result = encode_uuid(encoder_output, context, value_data->value.uuid_value);
+            break;
+
+        case AMQP_TYPE_BINARY:
+            result = encode_binary(encoder_output, context, (const unsigned char*)value_data->value.binary_value.bytes, value_data->value.binary_value.length);
+            break;
+
+        case AMQP_TYPE_STRING:
+            result = encode_string(encoder_output, context, value_data->value.string_value.chars, value_data->value.string_value.length);
+            break;
+
+        case AMQP_TYPE_SYMBOL:
+            result = encode_symbol(encoder_output, context, value_data->value.symbol_value.chars, value_data->value.symbol_value.length);
+            break;
+
+        case AMQP_TYPE_LIST:
+            if (decode_all_list_items(value_data) != 0)
+            {
+                LogError("Could not decode list items");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = encode_list(encoder_output, context, value_data->value.list_value.count, value_data->value.list_value.items);
+            }
+            break;
+
+        case AMQP_TYPE_MAP:
+            result = encode_map(encoder_output, context, value_data->value.map_value.pair_count, value_data->value.map_value.pairs);
+            break;
+
+        case AMQP_TYPE_ARRAY:
+            result = encode_array(encoder_output, context, value_data);
+            break;
+
+        case AMQP_TYPE_COMPOSITE:
+        case AMQP_TYPE_DESCRIBED:
+        {
+            if ((encode_descriptor_header(encoder_output, context) != 0) ||
+                (amqpvalue_encode(value_data->value.described_value.descriptor, encoder_output, context) != 0) ||
+                (amqpvalue_encode(value_data->value.described_value.value, encoder_output, context) != 0))
+            {
+                LogError("Failed encoding described or composite type");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            break;
+        }
+        }
+    }
+
+    return result;
+}
+
+static int count_bytes(void* context, const unsigned char* bytes, size_t length)
+{
+    size_t* byte_count;
+    (void)bytes;
+
+    byte_count = (size_t*)context;
+    *byte_count += length;
+
+    return 0;
+}
+
+/* Adds the encoded sizes of the given values to *size, failing if the total does not fit the 32 bit size of a list or map */
+static int add_items_encoded_size(const AMQP_VALUE* items, uint32_t count, uint32_t* size)
+{
+    int result = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        size_t item_size;
+        if (amqpvalue_get_encoded_size(items[i], &item_size) != 0)
+        {
+            LogError("Could not get encoded size for element %u", (unsigned int)i);
+            result = __FAILURE__;
+            break;
+        }
+
+        if ((item_size > UINT32_MAX) ||
+            (*size + (uint32_t)item_size < *size))
+        {
+            LogError("Overflow in encoded size computation");
+            result = __FAILURE__;
+            break;
+        }
+
+        *size += (uint32_t)item_size;
+    }
+
+    return result;
+}
+
+/* Computes the encoded size of a compound value from the sizes of its elements, the same way encode_list and encode_map pick the list8/list32 and map8/map32 encodings */
+static size_t get_compound_encoded_size(uint32_t element_count, uint32_t elements_size)
+{
+    size_t result;
+
+    if ((element_count <= 255) && (elements_size < 255))
+    {
+        /* constructor, size and count bytes */
+        result = 3 + (size_t)elements_size;
+    }
+    else
+    {
+        /* constructor, 4 bytes size and 4 bytes count */
+        result = 9 + (size_t)elements_size;
+    }
+
+    return result;
+}
+
+int amqpvalue_get_encoded_size(AMQP_VALUE value, size_t* encoded_size)
+{
+    int result;
+    /* a size computed while another thread bumps the generation is cached for the generation it was computed in */
+    uint64_t encoded_size_generation = ATOMIC_LOAD_UINT64(&current_encoded_size_generation);
+
+    /* Codes_SRS_AMQPVALUE_01_309: [If any argument is NULL, amqpvalue_get_encoded_size shall return a non-zero value.] */
+    if ((value == NULL) ||
+        (encoded_size == NULL))
+    {
+        LogError("Bad arguments: value = %p, encoded_size = %p",
+            value, encoded_size);
+        result = __FAILURE__;
+    }
+    else if (value->encoded_size_generation == encoded_size_generation)
+    {
+        /* Codes_SRS_AMQPVALUE_01_451: [ The encoded size computed for a value shall be cached in the value and reused until a list, map or array is changed. ]*/
+        *encoded_size = value->encoded_size;
+        result = 0;
+    }
+    else
+    {
+        uint32_t elements_size = 0;
+
+        switch (value->type)
+        {
+        default:
+            *encoded_size = 0;
+            result = amqpvalue_encode(value, count_bytes, encoded_size);
+            break;
+
+        case AMQP_TYPE_STRING:
+        case AMQP_TYPE_SYMBOL:
+        {
+            /* Codes_SRS_AMQPVALUE_01_575: [ The encoded size of a string or symbol shall be computed from its stored length, without measuring or encoding its characters. ]*/
+            uint32_t length = (value->type == AMQP_TYPE_STRING) ? value->value.string_value.length : value->value.symbol_value.length;
+            /* str8/sym8 or str32/sym32 constructor and size */
+            *encoded_size = ((length <= 255) ? 2 : 5) + (size_t)length;
+            result = 0;
+            break;
+        }
+
+        case AMQP_TYPE_LIST:
+            if (value->value.list_value.count == 0)
+            {
+                /* list0 */
+                *encoded_size = 1;
+                result = 0;
+            }
+            else if ((decode_all_list_items(value) != 0) ||
+                (add_items_encoded_size(value->value.list_value.items, value->value.list_value.count, &elements_size) != 0))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                *encoded_size = get_compound_encoded_size(value->value.list_value.count, elements_size);
+                result = 0;
+            }
+            break;
+
+        case AMQP_TYPE_MAP:
+        {
+            uint32_t i;
+
+            result = 0;
+            for (i = 0; i < value->value.map_value.pair_count; i++)
+            {
+                if ((add_items_encoded_size(&value->value.map_value.pairs[i].key, 1, &elements_size) != 0) ||
+                    (add_items_encoded_size(&value->value.map_value.pairs[i].value, 1, &elements_size) != 0))
+                {
+                    result = __FAILURE__;
+                    break;
+                }
+            }
+
+            if (result == 0)
+            {
+                *encoded_size = get_compound_encoded_size(value->value.map_value.pair_count * 2, elements_size);
+            }
+            break;
+        }
+
+        case AMQP_TYPE_ARRAY:
+        {
+            AMQP_TYPE item_type;
+
+            if (get_array_encoding(value, &item_type, &elements_size) != 0)
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                *encoded_size = get_array_encoded_size(value->value.array_value.count, elements_size);
+                result = 0;
+            }
+            break;
+        }
+
+        case AMQP_TYPE_DESCRIBED:
+        case AMQP_TYPE_COMPOSITE:
+        {
+            size_t descriptor_size;
+            size_t described_value_size;
+
+            if ((amqpvalue_get_encoded_size(value->value.described_value.descriptor, &descriptor_size) != 0) ||
+                (amqpvalue_get_encoded_size(value->value.described_value.value, &described_value_size) != 0))
+            {
+                LogError("Could not get encoded size of described value");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* descriptor constructor byte */
+                *encoded_size = 1 + descriptor_size + described_value_size;
+                result = 0;
+            }
+            break;
+        }
+        }
+
+        if (result == 0)
+        {
+            value->encoded_size = *encoded_size;
+            value->encoded_size_generation = encoded_size_generation;
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_encode_to_buffer(AMQP_VALUE value, unsigned char* buffer, size_t buffer_size, size_t* encoded_size)
+{
+    int result;
+
+    if ((value == NULL) ||
+        (buffer == NULL) ||
+        (encoded_size == NULL))
+    {
+        /* Codes_SRS_AMQPVALUE_01_453: [ If `value`, `buffer` or `encoded_size` is NULL, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: value = %p, buffer = %p, encoded_size = %p",
+            value, buffer, encoded_size);
+        result = __FAILURE__;
+    }
+    else if (amqpvalue_get_encoded_size(value, encoded_size) != 0)
+    {
+        /* Codes_SRS_AMQPVALUE_01_455: [ If encoding fails, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value. ]*/
+        LogError("Could not get encoded size");
+        result = __FAILURE__;
+    }
+    else if (*encoded_size > buffer_size)
+    {
+        /* Codes_SRS_AMQPVALUE_01_454: [ If the encoded value does not fit in `buffer_size` bytes, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value, filling in `encoded_size` with the needed size. ]*/
+        LogError("Buffer of %u bytes is too small for an encoded value of %u bytes", (unsigned int)buffer_size, (unsigned int)*encoded_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        ENCODE_TO_BUFFER_CONTEXT encode_context;
+        encode_context.buffer = buffer;
+        encode_context.size = buffer_size;
+        encode_context.position = 0;
+
+        /* Codes_SRS_AMQPVALUE_01_452: [ `amqpvalue_encode_to_buffer` shall encode `value` into `buffer` and fill in `encoded_size` with the number of bytes written. ]*/
+        if (amqpvalue_encode(value, write_to_buffer, &encode_context) != 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_455: [ If encoding fails, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value. ]*/
+            LogError("Could not encode value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *encoded_size = encode_context.position;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void writer_set_uint32(unsigned char* bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value >> 24);
+    bytes[1] = (unsigned char)((value >> 16) & 0xFF);
+    bytes[2] = (unsigned char)((value >> 8) & 0xFF);
+    bytes[3] = (unsigned char)(value & 0xFF);
+}
+
+/* checks the writer, counts the value about to be written as an item of the innermost list or map and sets up encoding at the current position */
+static int writer_begin_value(AMQP_WRITER* writer, ENCODE_TO_BUFFER_CONTEXT* encode_context)
+{
+    int result;
+
+    if (writer == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_532: [ If `writer` is NULL, the `amqp_writer` functions shall fail and return a non-zero value. ]*/
+        LogError("NULL writer");
+        result = __FAILURE__;
+    }
+    else if (writer->is_failed)
+    {
+        /* Codes_SRS_AMQPVALUE_01_533: [ When an `amqp_writer` function fails on a non-NULL writer, for example because the encoded value does not fit in the rest of the buffer, the writer shall be failed and every later call other than `amqp_writer_init` shall fail and return a non-zero value. ]*/
+        LogError("The writer failed before");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (writer->is_described_value_pending)
+        {
+            /* the described value was counted when it was begun */
+            writer->is_described_value_pending = false;
+        }
+        else if (writer->depth > 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_536: [ Every value, list, map or described value written while a list or map is open shall be counted as one item of the innermost one, keys and values each counting as one item of a map. ]*/
+            writer->container_item_counts[writer->depth - 1]++;
+        }
+
+        encode_context->buffer = writer->buffer;
+        encode_context->size = writer->buffer_size;
+        encode_context->position = writer->position;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int writer_end_value(AMQP_WRITER* writer, const ENCODE_TO_BUFFER_CONTEXT* encode_context, int encode_result)
+{
+    int result;
+
+    if (encode_result != 0)
+    {
+        /* Codes_SRS_AMQPVALUE_01_533: [ When an `amqp_writer` function fails on a non-NULL writer, for example because the encoded value does not fit in the rest of the buffer, the writer shall be failed and every later call other than `amqp_writer_init` shall fail and return a non-zero value. ]*/
+        LogError("Cannot write the value");
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        writer->position = encode_context->position;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int writer_begin_container(AMQP_WRITER* writer, unsigned char constructor)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (writer->depth == AMQP_WRITER_MAX_DEPTH)
+    {
+        /* Codes_SRS_AMQPVALUE_01_540: [ If `AMQP_WRITER_MAX_DEPTH` lists and maps are already open, `amqp_writer_begin_list` and `amqp_writer_begin_map` shall fail and return a non-zero value. ]*/
+        LogError("More than %u nested lists and maps", (unsigned int)AMQP_WRITER_MAX_DEPTH);
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* size and count, filled in by amqp_writer_end */
+        static const unsigned char placeholder[8] = { 0 };
+        size_t container_offset = writer->position;
+
+        if ((output_byte(write_to_buffer, &encode_context, constructor) != 0) ||
+            (output_bytes(write_to_buffer, &encode_context, placeholder, sizeof(placeholder)) != 0))
+        {
+            result = writer_end_value(writer, &encode_context, __FAILURE__);
+        }
+        else if (writer_end_value(writer, &encode_context, 0) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            writer->container_offsets[writer->depth] = container_offset;
+            writer->container_item_counts[writer->depth] = 0;
+            writer->depth++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int amqp_writer_init(AMQP_WRITER* writer, unsigned char* buffer, size_t buffer_size)
+{
+    int result;
+
+    if ((writer == NULL) ||
+        (buffer == NULL))
+    {
+        /* Codes_SRS_AMQPVALUE_01_529: [ If `writer` or `buffer` is NULL, `amqp_writer_init` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: writer = %p, buffer = %p",
+            writer, buffer);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_528: [ `amqp_writer_init` shall set up `writer` to encode values into the `buffer_size` bytes of `buffer`, starting at its first byte, and return 0. ]*/
+        writer->buffer = buffer;
+        writer->buffer_size = buffer_size;
+        writer->position = 0;
+        writer->depth = 0;
+        writer->is_described_value_pending = false;
+        writer->is_failed = false;
+        result = 0;
+    }
+
+    return result;
+}
+
+int amqp_writer_begin_list(AMQP_WRITER* writer)
+{
+    /* Codes_SRS_AMQPVALUE_01_534: [ `amqp_writer_begin_list` shall write the list32 constructor 0xD0 and leave room for the size and the count of the list, which are filled in by `amqp_writer_end`. ]*/
+    return writer_begin_container(writer, 0xD0);
+}
+
+int amqp_writer_begin_map(AMQP_WRITER* writer)
+{
+    /* Codes_SRS_AMQPVALUE_01_535: [ `amqp_writer_begin_map` shall write the map32 constructor 0xD1 and leave room for the size and the count of the map, which are filled in by `amqp_writer_end`. ]*/
+    return writer_begin_container(writer, 0xD1);
+}
+
+int amqp_writer_begin_described(AMQP_WRITER* writer, uint64_t descriptor)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQPVALUE_01_541: [ `amqp_writer_begin_described` shall write the descriptor constructor 0x00 followed by `descriptor` encoded as an ulong, the next value, list or map written being the described value. ]*/
+    else if ((encode_descriptor_header(write_to_buffer, &encode_context) != 0) ||
+        (encode_ulong(write_to_buffer, &encode_context, descriptor) != 0))
+    {
+        result = writer_end_value(writer, &encode_context, __FAILURE__);
+    }
+    else
+    {
+        result = writer_end_value(writer, &encode_context, 0);
+        writer->is_described_value_pending = true;
+    }
+
+    return result;
+}
+
+int amqp_writer_end(AMQP_WRITER* writer)
+{
+    int result;
+
+    if (writer == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_532: [ If `writer` is NULL, the `amqp_writer` functions shall fail and return a non-zero value. ]*/
+        LogError("NULL writer");
+        result = __FAILURE__;
+    }
+    else if (writer->is_failed)
+    {
+        /* Codes_SRS_AMQPVALUE_01_533: [ When an `amqp_writer` function fails on a non-NULL writer, for example because the encoded value does not fit in the rest of the buffer, the writer shall be failed and every later call other than `amqp_writer_init` shall fail and return a non-zero value. ]*/
+        LogError("The writer failed before");
+        result = __FAILURE__;
+    }
+    else if ((writer->depth == 0) ||
+        (writer->is_described_value_pending))
+    {
+        /* Codes_SRS_AMQPVALUE_01_538: [ If no list or map is open, or if a described value was begun and its value was not written, `amqp_writer_end` shall fail and return a non-zero value. ]*/
+        LogError("Nothing to end: depth = %u, is_described_value_pending = %d",
+            (unsigned int)writer->depth, (int)writer->is_described_value_pending);
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t container_offset = writer->container_offsets[writer->depth - 1];
+        uint32_t item_count = writer->container_item_counts[writer->depth - 1];
+        /* the size counts the bytes after the size field, the count field included */
+        size_t container_size = writer->position - container_offset - 5;
+
+        if ((writer->buffer[container_offset] == 0xD1) &&
+            ((item_count % 2) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_539: [ If the map being ended has an odd number of items, `amqp_writer_end` shall fail and return a non-zero value. ]*/
+            LogError("Map ended with a key without a value");
+            writer->is_failed = true;
+            result = __FAILURE__;
+        }
+        else if (container_size > UINT32_MAX)
+        {
+            LogError("List or map too big for its encoding");
+            writer->is_failed = true;
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_537: [ `amqp_writer_end` shall end the innermost open list or map by filling in its size, the number of bytes after the size field, and its item count, and return 0. ]*/
+            writer_set_uint32(writer->buffer + container_offset + 1, (uint32_t)container_size);
+            writer_set_uint32(writer->buffer + container_offset + 5, item_count);
+            writer->depth--;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int amqp_writer_put_null(AMQP_WRITER* writer)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, output_byte(write_to_buffer, &encode_context, 0x40));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_boolean(AMQP_WRITER* writer, bool value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_boolean(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_ubyte(AMQP_WRITER* writer, unsigned char value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_ubyte(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_uint(AMQP_WRITER* writer, uint32_t value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_uint(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_ulong(AMQP_WRITER* writer, uint64_t value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_ulong(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_int(AMQP_WRITER* writer, int32_t value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_int(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_long(AMQP_WRITER* writer, int64_t value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_long(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_timestamp(AMQP_WRITER* writer, timestamp value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_timestamp(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_double(AMQP_WRITER* writer, double value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_double(write_to_buffer, &encode_context, value));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_string(AMQP_WRITER* writer, const char* value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (value == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_531: [ If `value` is NULL for `amqp_writer_put_string`, `amqp_writer_put_symbol` or `amqp_writer_put_value`, or if `bytes` is NULL and `length` is not 0 for `amqp_writer_put_binary`, the function shall fail and return a non-zero value. ]*/
+        LogError("NULL value");
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_string(write_to_buffer, &encode_context, value, strlen(value)));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_string_n(AMQP_WRITER* writer, const char* value, size_t length)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if ((value == NULL) &&
+        (length > 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_577: [ If `value` is NULL and `length` is not 0, `amqp_writer_put_string_n` shall fail and return a non-zero value. ]*/
+        LogError("NULL value with length %lu", (unsigned long)length);
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else if (length > UINT32_MAX)
+    {
+        /* Codes_SRS_AMQPVALUE_01_578: [ If `length` does not fit in the size of a str32, `amqp_writer_put_string_n` shall fail and return a non-zero value. ]*/
+        LogError("String too long: %lu characters", (unsigned long)length);
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_576: [ `amqp_writer_put_string_n` shall encode the `length` characters at `value`, which need not be NUL terminated, as a string. ]*/
+        result = writer_end_value(writer, &encode_context, encode_string(write_to_buffer, &encode_context, value, length));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_symbol(AMQP_WRITER* writer, const char* value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (value == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_531: [ If `value` is NULL for `amqp_writer_put_string`, `amqp_writer_put_symbol` or `amqp_writer_put_value`, or if `bytes` is NULL and `length` is not 0 for `amqp_writer_put_binary`, the function shall fail and return a non-zero value. ]*/
+        LogError("NULL value");
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_symbol(write_to_buffer, &encode_context, value, strlen(value)));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_binary(AMQP_WRITER* writer, const void* bytes, uint32_t length)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if ((bytes == NULL) &&
+        (length > 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_531: [ If `value` is NULL for `amqp_writer_put_string`, `amqp_writer_put_symbol` or `amqp_writer_put_value`, or if `bytes` is NULL and `length` is not 0 for `amqp_writer_put_binary`, the function shall fail and return a non-zero value. ]*/
+        LogError("NULL bytes with length %u", (unsigned int)length);
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+        result = writer_end_value(writer, &encode_context, encode_binary(write_to_buffer, &encode_context, (const unsigned char*)bytes, length));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_value(AMQP_WRITER* writer, AMQP_VALUE value)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (value == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_531: [ If `value` is NULL for `amqp_writer_put_string`, `amqp_writer_put_symbol` or `amqp_writer_put_value`, or if `bytes` is NULL and `length` is not 0 for `amqp_writer_put_binary`, the function shall fail and return a non-zero value. ]*/
+        LogError("NULL value");
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_542: [ `amqp_writer_put_value` shall encode `value` by calling `amqpvalue_encode`. ]*/
+        result = writer_end_value(writer, &encode_context, amqpvalue_encode(value, write_to_buffer, &encode_context));
+    }
+
+    return result;
+}
+
+int amqp_writer_put_encoded(AMQP_WRITER* writer, const unsigned char* bytes, size_t length, uint32_t count)
+{
+    int result;
+    ENCODE_TO_BUFFER_CONTEXT encode_context;
+
+    if (writer_begin_value(writer, &encode_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if ((bytes == NULL) ||
+        (length == 0) ||
+        (count == 0))
+    {
+        /* Codes_SRS_AMQPVALUE_01_580: [ If `bytes` is NULL, or `length` or `count` is 0, `amqp_writer_put_encoded` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: bytes = %p, length = %lu, count = %u",
+            bytes, (unsigned long)length, (unsigned int)count);
+        writer->is_failed = true;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_579: [ `amqp_writer_put_encoded` shall copy the `length` bytes at `bytes`, holding `count` encoded values, at the current position of the writer, without checking them. ]*/
+        /* Codes_SRS_AMQPVALUE_01_581: [ The `count` values shall be counted as `count` items of the innermost open list or map. ]*/
+        /* the first value was counted by writer_begin_value */
+        if (writer->depth > 0)
+        {
+            writer->container_item_counts[writer->depth - 1] += count - 1;
+        }
+
+        result = writer_end_value(writer, &encode_context, write_to_buffer(&encode_context, bytes, length));
+    }
+
+    return result;
+}
+
+int amqp_writer_get_length(AMQP_WRITER* writer, size_t* length)
+{
+    int result;
+
+    if ((writer == NULL) ||
+        (length == NULL))
+    {
+        /* Codes_SRS_AMQPVALUE_01_544: [ If `writer` or `length` is NULL, if the writer failed, or if a list, map or described value is not complete, `amqp_writer_get_length` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: writer = %p, length = %p",
+            writer, length);
+        result = __FAILURE__;
+    }
+    else if ((writer->is_failed) ||
+        (writer->depth > 0) ||
+        (writer->is_described_value_pending))
+    {
+        /* Codes_SRS_AMQPVALUE_01_544: [ If `writer` or `length` is NULL, if the writer failed, or if a list, map or described value is not complete, `amqp_writer_get_length` shall fail and return a non-zero value. ]*/
+        LogError("The writer did not write complete values: is_failed = %d, depth = %u",
+            (int)writer->is_failed, (unsigned int)writer->depth);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_543: [ `amqp_writer_get_length` shall fill in `length` with the number of bytes written and return 0. ]*/
+        *length = writer->position;
+        result = 0;
+    }
+
+    return result;
+}
+
+static uint32_t reader_get_uint32(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+static uint64_t reader_get_uint64(const unsigned char* bytes)
+{
+    return ((uint64_t)reader_get_uint32(bytes) << 32) | (uint64_t)reader_get_uint32(bytes + 4);
+}
+
+static int reader_set_fixed_value(AMQP_READER_ITEM* item)
+{
+    int result = 0;
+    const unsigned char* bytes = item->bytes;
+
+    switch (item->constructor)
+    {
+    default:
+        item->type = AMQP_TYPE_UNKNOWN;
+        break;
+    case 0x40:
+        item->type = AMQP_TYPE_NULL;
+        break;
+    case 0x41:
+    case 0x42:
+        item->type = AMQP_TYPE_BOOL;
+        item->value.bool_value = (item->constructor == 0x41);
+        break;
+    case 0x56:
+        if (bytes[0] > 1)
+        {
+            LogError("Invalid boolean value 0x%02x", bytes[0]);
+            result = __FAILURE__;
+        }
+        else
+        {
+            item->type = AMQP_TYPE_BOOL;
+            item->value.bool_value = (bytes[0] == 1);
+        }
+        break;
+    case 0x43:
+    case 0x52:
+    case 0x70:
+        item->type = AMQP_TYPE_UINT;
+        item->value.unsigned_value = (item->constructor == 0x43) ? 0 : ((item->constructor == 0x52) ? bytes[0] : reader_get_uint32(bytes));
+        break;
+    case 0x44:
+    case 0x53:
+    case 0x80:
+        item->type = AMQP_TYPE_ULONG;
+        item->value.unsigned_value = (item->constructor == 0x44) ? 0 : ((item->constructor == 0x53) ? bytes[0] : reader_get_uint64(bytes));
+        break;
+    case 0x45:
+        /* list0 */
+        item->type = AMQP_TYPE_LIST;
+        break;
+    case 0x50:
+        item->type = AMQP_TYPE_UBYTE;
+        item->value.unsigned_value = bytes[0];
+        break;
+    case 0x60:
+        item->type = AMQP_TYPE_USHORT;
+        item->value.unsigned_value = ((uint16_t)bytes[0] << 8) | bytes[1];
+        break;
+    case 0x73:
+        item->type = AMQP_TYPE_CHAR;
+        item->value.unsigned_value = reader_get_uint32(bytes);
+        break;
+    case 0x51:
+        item->type = AMQP_TYPE_BYTE;
+        item->value.signed_value = (int8_t)bytes[0];
+        break;
+    case 0x61:
+        item->type = AMQP_TYPE_SHORT;
+        item->value.signed_value = (int16_t)(((uint16_t)bytes[0] << 8) | bytes[1]);
+        break;
+    case 0x54:
+    case 0x71:
+        item->type = AMQP_TYPE_INT;
+        item->value.signed_value = (item->constructor == 0x54) ? (int8_t)bytes[0] : (int32_t)reader_get_uint32(bytes);
+        break;
+    case 0x55:
+    case 0x81:
+        item->type = AMQP_TYPE_LONG;
+        item->value.signed_value = (item->constructor == 0x55) ? (int8_t)bytes[0] : (int64_t)reader_get_uint64(bytes);
+        break;
+    case 0x83:
+        item->type = AMQP_TYPE_TIMESTAMP;
+        item->value.signed_value = (int64_t)reader_get_uint64(bytes);
+        break;
+    case 0x72:
+    {
+        uint32_t bits = reader_get_uint32(bytes);
+        item->type = AMQP_TYPE_FLOAT;
+        (void)memcpy(&item->value.float_value, &bits, sizeof(bits));
+        break;
+    }
+    case 0x82:
+    {
+        uint64_t bits = reader_get_uint64(bytes);
+        item->type = AMQP_TYPE_DOUBLE;
+        (void)memcpy(&item->value.double_value, &bits, sizeof(bits));
+        break;
+    }
+    case 0x98:
+        item->type = AMQP_TYPE_UUID;
+        break;
+    }
+
+    return result;
+}
+
+static int reader_parse_value(const unsigned char* buffer, size_t position, size_t limit, unsigned char constructor, size_t nesting, AMQP_READER_ITEM* item, size_t* value_end);
+
+static int reader_skip_value(const unsigned char* buffer, size_t position, size_t limit, size_t nesting, size_t* value_end)
+{
+    int result;
+    AMQP_READER_ITEM item;
+
+    if (nesting > AMQP_READER_MAX_DEPTH)
+    {
+        LogError("Described values nested more than %u deep", (unsigned int)AMQP_READER_MAX_DEPTH);
+        result = __FAILURE__;
+    }
+    else if (position >= limit)
+    {
+        LogError("Encoded value truncated");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = reader_parse_value(buffer, position + 1, limit, buffer[position], nesting, &item, value_end);
+    }
+
+    return result;
+}
+
+/* position is just after the constructor, the value has to end before limit */
+static int reader_parse_value(const unsigned char* buffer, size_t position, size_t limit, unsigned char constructor, size_t nesting, AMQP_READER_ITEM* item, size_t* value_end)
+{
+    static const uint32_t fixed_widths[] = { 0, 1, 2, 4, 8, 16 };
+    int result;
+    unsigned char category = constructor >> 4;
+    size_t available = limit - position;
+
+    item->type = AMQP_TYPE_UNKNOWN;
+    item->constructor = constructor;
+    item->bytes = buffer + position;
+    item->length = 0;
+    item->count = 0;
+    item->value.unsigned_value = 0;
+
+    if (constructor == 0x00)
+    {
+        size_t descriptor_end;
+
+        /* Codes_SRS_AMQPVALUE_01_551: [ A described value shall be returned as an item of type `AMQP_TYPE_DESCRIBED` with 2 items, its descriptor and its value. ]*/
+        if ((reader_skip_value(buffer, position, limit, nesting + 1, &descriptor_end) != 0) ||
+            (reader_skip_value(buffer, descriptor_end, limit, nesting + 1, value_end) != 0))
+        {
+            LogError("Cannot read described value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            item->type = AMQP_TYPE_DESCRIBED;
+            item->length = (uint32_t)(*value_end - position);
+            item->count = 2;
+            result = 0;
+        }
+    }
+    else if ((category >= 0x4) && (category <= 0x9))
+    {
+        uint32_t width = fixed_widths[category - 0x4];
+
+        if (available < width)
+        {
+            /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+            LogError("Encoded value truncated");
+            result = __FAILURE__;
+        }
+        else
+        {
+            item->length = width;
+            *value_end = position + width;
+            result = reader_set_fixed_value(item);
+        }
+    }
+    else if ((category == 0xA) || (category == 0xB))
+    {
+        size_t size_width = (category == 0xA) ? 1 : 4;
+
+        if (available < size_width)
+        {
+            /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+            LogError("Encoded value truncated");
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint32_t size = (size_width == 1) ? buffer[position] : reader_get_uint32(buffer + position);
+
+            if (available - size_width < size)
+            {
+                /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+                LogError("Encoded value truncated");
+                result = __FAILURE__;
+            }
+            else
+            {
+                unsigned char code = constructor & 0x0F;
+
+                item->type = (code == 0x0) ? AMQP_TYPE_BINARY : ((code == 0x1) ? AMQP_TYPE_STRING : ((code == 0x3) ? AMQP_TYPE_SYMBOL : AMQP_TYPE_UNKNOWN));
+                item->bytes = buffer + position + size_width;
+                item->length = size;
+                *value_end = position + size_width + size;
+                result = 0;
+            }
+        }
+    }
+    else if (category >= 0xC)
+    {
+        size_t size_width = ((category == 0xC) || (category == 0xE)) ? 1 : 4;
+
+        if (available < 2 * size_width)
+        {
+            /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+            LogError("Encoded value truncated");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* the size counts the count field */
+            uint32_t size = (size_width == 1) ? buffer[position] : reader_get_uint32(buffer + position);
+
+            if ((size < size_width) ||
+                (available - size_width < size))
+            {
+                /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+                LogError("Encoded value truncated");
+                result = __FAILURE__;
+            }
+            else
+            {
+                unsigned char code = constructor & 0x0F;
+
+                if (code == 0x0)
+                {
+                    item->type = (category >= 0xE) ? AMQP_TYPE_ARRAY : AMQP_TYPE_LIST;
+                }
+                else if ((code == 0x1) && (category <= 0xD))
+                {
+                    item->type = AMQP_TYPE_MAP;
+                }
+
+                item->count = (size_width == 1) ? buffer[position + 1] : reader_get_uint32(buffer + position + 4);
+                item->bytes = buffer + position + (2 * size_width);
+                item->length = size - (uint32_t)size_width;
+                *value_end = position + size_width + size;
+                result = 0;
+            }
+        }
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+        LogError("Invalid constructor 0x%02x", constructor);
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+int amqp_reader_init(AMQP_READER* reader, const unsigned char* buffer, size_t buffer_size)
+{
+    int result;
+
+    if ((reader == NULL) ||
+        (buffer == NULL))
+    {
+        /* Codes_SRS_AMQPVALUE_01_546: [ If `reader` or `buffer` is NULL, `amqp_reader_init` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: reader = %p, buffer = %p",
+            reader, buffer);
         result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        /* Codes_SRS_AMQPVALUE_01_545: [ `amqp_reader_init` shall set up `reader` to read the values encoded in the `buffer_size` bytes of `buffer`, starting at its first byte, and return 0. ]*/
+        reader->buffer = buffer;
+        reader->buffer_size = buffer_size;
+        reader->position = 0;
+        reader->depth = 0;
         result = 0;
     }
 
     return result;
 }
 
-static int encode_ushort(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint16_t value)
+bool amqp_reader_has_next(AMQP_READER* reader)
 {
-    int result;
+    bool result;
 
-    /* Codes_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-    if ((output_byte(encoder_output, context, 0x60) != 0) ||
-        (output_byte(encoder_output, context, (value >> 8) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value & 0xFF)) != 0))
+    if (reader == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failed encoding ushort");
-        result = __FAILURE__;
+        /* Codes_SRS_AMQPVALUE_01_548: [ If `reader` is NULL, `amqp_reader_has_next` shall return false. ]*/
+        LogError("NULL reader");
+        result = false;
+    }
+    else if (reader->depth == 0)
+    {
+        /* Codes_SRS_AMQPVALUE_01_547: [ `amqp_reader_has_next` shall return true when the innermost container entered has items left or, when no container is entered, when bytes are left in the buffer. ]*/
+        result = (reader->position < reader->buffer_size);
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-        result = 0;
+        /* Codes_SRS_AMQPVALUE_01_547: [ `amqp_reader_has_next` shall return true when the innermost container entered has items left or, when no container is entered, when bytes are left in the buffer. ]*/
+        result = (reader->container_items_left[reader->depth - 1] > 0);
     }
 
     return result;
 }
 
-static int encode_uint(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t value)
+int amqp_reader_next(AMQP_READER* reader, AMQP_READER_ITEM* item)
 {
     int result;
 
-    if (value == 0)
+    if ((reader == NULL) ||
+        (item == NULL))
     {
-        /* uint0 */
-        /* Codes_SRS_AMQPVALUE_01_279: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
-        if (output_byte(encoder_output, context, 0x43) != 0)
+        /* Codes_SRS_AMQPVALUE_01_552: [ If `reader` or `item` is NULL, or if `amqp_reader_has_next` would return false, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: reader = %p, item = %p",
+            reader, item);
+        result = __FAILURE__;
+    }
+    else if (!amqp_reader_has_next(reader))
+    {
+        /* Codes_SRS_AMQPVALUE_01_552: [ If `reader` or `item` is NULL, or if `amqp_reader_has_next` would return false, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+        LogError("No more items");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t limit = (reader->depth == 0) ? reader->buffer_size : reader->container_ends[reader->depth - 1];
+        size_t value_end;
+        int parse_result;
+
+        if ((reader->depth > 0) &&
+            (reader->container_is_array[reader->depth - 1]))
         {
-            LogError("Failed encoding uint");
-            result = __FAILURE__;
+            /* Codes_SRS_AMQPVALUE_01_553: [ The items of an array shall be read with the constructor the array gives once for all of them. ]*/
+            parse_result = reader_parse_value(reader->buffer, reader->position, limit, reader->container_item_constructors[reader->depth - 1], 0, item, &value_end);
+        }
+        else if (reader->position >= limit)
+        {
+            /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+            LogError("Container holds less items than its count");
+            parse_result = __FAILURE__;
         }
         else
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            parse_result = reader_parse_value(reader->buffer, reader->position + 1, limit, reader->buffer[reader->position], 0, item, &value_end);
         }
-    }
-    else if (value <= 255)
-    {
-        /* smalluint */
-        /* Codes_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
-        if ((output_byte(encoder_output, context, 0x52) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
+
+        if (parse_result != 0)
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding uint");
+            /* Codes_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+            LogError("Cannot read the next item");
             result = __FAILURE__;
         }
         else
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+            /* Codes_SRS_AMQPVALUE_01_549: [ `amqp_reader_next` shall fill in `item` with the type, constructor and a view of the next value, borrowed from the buffer, move past the value, a list, map, array or described value included, and return 0. ]*/
+            reader->position = value_end;
+            if (reader->depth > 0)
+            {
+                reader->container_items_left[reader->depth - 1]--;
+            }
+
             result = 0;
         }
     }
+
+    return result;
+}
+
+int amqp_reader_enter(AMQP_READER* reader, const AMQP_READER_ITEM* item)
+{
+    int result;
+
+    if ((reader == NULL) ||
+        (item == NULL))
+    {
+        /* Codes_SRS_AMQPVALUE_01_556: [ If `reader` or `item` is NULL, if `item` is not a list, map, array or described value, or if it is not the item the last call to `amqp_reader_next` returned, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: reader = %p, item = %p",
+            reader, item);
+        result = __FAILURE__;
+    }
+    else if (((item->type != AMQP_TYPE_LIST) && (item->type != AMQP_TYPE_MAP) && (item->type != AMQP_TYPE_ARRAY) && (item->type != AMQP_TYPE_DESCRIBED)) ||
+        (item->bytes + item->length != reader->buffer + reader->position))
+    {
+        /* Codes_SRS_AMQPVALUE_01_556: [ If `reader` or `item` is NULL, if `item` is not a list, map, array or described value, or if it is not the item the last call to `amqp_reader_next` returned, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+        LogError("Item cannot be entered");
+        result = __FAILURE__;
+    }
+    else if (reader->depth == AMQP_READER_MAX_DEPTH)
+    {
+        /* Codes_SRS_AMQPVALUE_01_557: [ If `AMQP_READER_MAX_DEPTH` containers are already entered, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+        LogError("More than %u nested containers", (unsigned int)AMQP_READER_MAX_DEPTH);
+        result = __FAILURE__;
+    }
+    else if ((item->type == AMQP_TYPE_ARRAY) &&
+        (((item->length == 0) && (item->count > 0)) ||
+         ((item->length > 0) && (item->bytes[0] == 0x00))))
+    {
+        /* Codes_SRS_AMQPVALUE_01_558: [ If the array has no item constructor, or if its items are described values, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+        LogError("Array items cannot be read");
+        result = __FAILURE__;
+    }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
-        if ((output_byte(encoder_output, context, 0x70) != 0) ||
-            (output_byte(encoder_output, context, (value >> 24) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 16) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 8) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding uint");
-            result = __FAILURE__;
-        }
-        else
+        /* Codes_SRS_AMQPVALUE_01_554: [ `amqp_reader_enter` shall make the items of `item`, which has to be the item just returned by `amqp_reader_next`, the next ones returned by `amqp_reader_next`, and return 0. ]*/
+        reader->container_ends[reader->depth] = reader->position;
+        reader->container_items_left[reader->depth] = item->count;
+        reader->container_is_array[reader->depth] = (item->type == AMQP_TYPE_ARRAY);
+        reader->position = (size_t)(item->bytes - reader->buffer);
+        if ((item->type == AMQP_TYPE_ARRAY) &&
+            (item->length > 0))
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            reader->container_item_constructors[reader->depth] = item->bytes[0];
+            reader->position++;
         }
+
+        reader->depth++;
+        result = 0;
     }
 
     return result;
 }
 
-static int encode_ulong(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint64_t value)
+int amqp_reader_leave(AMQP_READER* reader)
 {
     int result;
-    if (value == 0)
+
+    if (reader == NULL)
     {
-        /* ulong0 */
-        /* Codes_SRS_AMQPVALUE_01_282: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
-        if (output_byte(encoder_output, context, 0x44) != 0)
+        /* Codes_SRS_AMQPVALUE_01_559: [ If `reader` is NULL or no container is entered, `amqp_reader_leave` shall fail and return a non-zero value. ]*/
+        LogError("NULL reader");
+        result = __FAILURE__;
+    }
+    else if (reader->depth == 0)
+    {
+        /* Codes_SRS_AMQPVALUE_01_559: [ If `reader` is NULL or no container is entered, `amqp_reader_leave` shall fail and return a non-zero value. ]*/
+        LogError("No container entered");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_AMQPVALUE_01_555: [ `amqp_reader_leave` shall skip the items left in the innermost container entered, continue with the item after it and return 0. ]*/
+        reader->depth--;
+        reader->position = reader->container_ends[reader->depth];
+        result = 0;
+    }
+
+    return result;
+}
+
+/* The values whose last reference was dropped wait to be cleared chained through encoded_size_generation, which a
+   value nobody references anymore does not need, so destroying a tree takes neither recursion nor memory */
+static void queue_value_to_clear(AMQP_VALUE_DATA* value_data, AMQP_VALUE_DATA** values_to_clear)
+{
+    value_data->encoded_size_generation = (uint64_t)(uintptr_t)*values_to_clear;
+    *values_to_clear = value_data;
+}
+
+/* Drops the reference a value being cleared held on one of its items */
+static void release_item(AMQP_VALUE item, AMQP_VALUE_DATA** values_to_clear)
+{
+    if (item == NULL)
+    {
+        LogError("NULL value");
+    }
+    else if (item->is_arena_allocated)
+    {
+        /* Codes_SRS_AMQPVALUE_01_417: [ Values allocated from an arena shall not be freed by amqpvalue_destroy, their memory is released by resetting or destroying the arena. ]*/
+    }
+    /* Codes_SRS_AMQPVALUE_01_590: [ amqpvalue_destroy shall only free a nested value when the reference it drops on it is the last one, so that a value shared with trees still in use, on the calling thread or on other threads, stays valid for the holders of its other references. ]*/
+    else if (DEC_REF(AMQP_VALUE_DATA, item) == DEC_RETURN_ZERO)
+    {
+        queue_value_to_clear(item, values_to_clear);
+    }
+}
+
+static void amqpvalue_clear(AMQP_VALUE_DATA* value_data, AMQP_VALUE_DATA** values_to_clear)
+{
+    switch (value_data->type)
+    {
+    default:
+        break;
+
+    case AMQP_TYPE_BINARY:
+        /* Codes_SRS_AMQPVALUE_01_430: [ amqpvalue_destroy shall not free the bytes of borrowed binary, string and symbol values. ]*/
+        if ((value_data->value.binary_value.bytes != NULL) &&
+            (!value_data->is_borrowed))
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding ulong");
-            result = __FAILURE__;
+            free((void*)value_data->value.binary_value.bytes);
         }
-        else
+        break;
+    case AMQP_TYPE_STRING:
+        if ((value_data->value.string_value.chars != NULL) &&
+            (value_data->value.string_value.chars != value_data->value.string_value.inline_chars) &&
+            (!value_data->is_borrowed))
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            free(value_data->value.string_value.chars);
+        }
+        break;
+    case AMQP_TYPE_SYMBOL:
+        if ((value_data->value.symbol_value.chars != NULL) &&
+            (value_data->value.symbol_value.chars != value_data->value.symbol_value.inline_chars) &&
+            (!value_data->is_borrowed) &&
+            (!value_data->is_interned))
+        {
+            free(value_data->value.symbol_value.chars);
+        }
+        break;
+    case AMQP_TYPE_LIST:
+    {
+        size_t i;
+        /* a list whose decoding failed before its items were allocated has no items */
+        for (i = 0; (value_data->value.list_value.items != NULL) && (i < value_data->value.list_value.count); i++)
+        {
+            /* items of a lazily decoded list that were never accessed are NULL */
+            if (value_data->value.list_value.items[i] != NULL)
+            {
+                release_item(value_data->value.list_value.items[i], values_to_clear);
+            }
         }
+
+        free(value_data->value.list_value.items);
+        value_data->value.list_value.items = NULL;
+        value_data->value.list_value.capacity = 0;
+        free(value_data->value.list_value.lazy_items);
+        value_data->value.list_value.lazy_items = NULL;
+        break;
     }
-    else if (value <= 255)
+    case AMQP_TYPE_MAP:
     {
-        /* smallulong */
-        /* Codes_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-        if ((output_byte(encoder_output, context, 0x53) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
+        size_t i;
+        for (i = 0; (value_data->value.map_value.pairs != NULL) && (i < value_data->value.map_value.pair_count); i++)
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding ulong");
-            result = __FAILURE__;
+            release_item(value_data->value.map_value.pairs[i].key, values_to_clear);
+            release_item(value_data->value.map_value.pairs[i].value, values_to_clear);
         }
-        else
+
+        free(value_data->value.map_value.pairs);
+        value_data->value.map_value.pairs = NULL;
+        value_data->value.map_value.capacity = 0;
+        free(value_data->value.map_value.index);
+        value_data->value.map_value.index = NULL;
+        value_data->value.map_value.index_size = 0;
+        break;
+    }
+    case AMQP_TYPE_ARRAY:
+    {
+        size_t i;
+        /* packed arrays have no item values */
+        for (i = 0; (value_data->value.array_value.items != NULL) && (i < value_data->value.array_value.count); i++)
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            release_item(value_data->value.array_value.items[i], values_to_clear);
         }
+
+        free(value_data->value.array_value.items);
+        value_data->value.array_value.items = NULL;
+        value_data->value.array_value.capacity = 0;
+        free(value_data->value.array_value.packed_items);
+        value_data->value.array_value.packed_items = NULL;
+        value_data->value.array_value.packed_item_type = AMQP_TYPE_UNKNOWN;
+        break;
     }
-    else
+    case AMQP_TYPE_COMPOSITE:
+    case AMQP_TYPE_DESCRIBED:
+        release_item(value_data->value.described_value.descriptor, values_to_clear);
+        release_item(value_data->value.described_value.value, values_to_clear);
+        break;
+    }
+
+    value_data->type = AMQP_TYPE_UNKNOWN;
+}
+
+/* Called once the last reference to value_data was dropped */
+static void free_value_tree(AMQP_VALUE_DATA* value_data)
+{
+    AMQP_VALUE_DATA* values_to_clear = NULL;
+
+    /* Codes_SRS_AMQPVALUE_01_564: [ amqpvalue_destroy shall free the values nested in lists, maps, arrays and described values without recursing, whatever the nesting depth. ]*/
+    queue_value_to_clear(value_data, &values_to_clear);
+    while (values_to_clear != NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
-        if ((output_byte(encoder_output, context, 0x80) != 0) ||
-            (output_byte(encoder_output, context, (value >> 56) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 48) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 40) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 32) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 24) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 16) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 8) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
+        AMQP_VALUE_DATA* value_to_clear = values_to_clear;
+        values_to_clear = (AMQP_VALUE_DATA*)(uintptr_t)value_to_clear->encoded_size_generation;
+
+        /* Codes_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+        amqpvalue_clear(value_to_clear, &values_to_clear);
+        free_value_node(value_to_clear);
+    }
+}
+
+static uint32_t get_item_count(AMQP_VALUE_DATA* value_data)
+{
+    uint32_t result;
+
+    switch (value_data->type)
+    {
+    default:
+        result = 0;
+        break;
+    case AMQP_TYPE_LIST:
+        result = value_data->value.list_value.count;
+        break;
+    case AMQP_TYPE_MAP:
+        result = value_data->value.map_value.pair_count;
+        break;
+    case AMQP_TYPE_ARRAY:
+        result = value_data->value.array_value.count;
+        break;
+    }
+
+    return result;
+}
+
+void amqpvalue_destroy(AMQP_VALUE value)
+{
+    /* Codes_SRS_AMQPVALUE_01_315: [If the value argument is NULL, amqpvalue_destroy shall do nothing.] */
+    if (value == NULL)
+    {
+        LogError("NULL value");
+    }
+    else if (value->is_arena_allocated)
+    {
+        /* Codes_SRS_AMQPVALUE_01_417: [ Values allocated from an arena shall not be freed by amqpvalue_destroy, their memory is released by resetting or destroying the arena. ]*/
+    }
+    else if (DEC_REF(AMQP_VALUE_DATA, value) == DEC_RETURN_ZERO)
+    {
+        if ((on_reclaim != NULL) &&
+            (get_item_count(value) >= reclaim_min_item_count))
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding ulong");
-            result = __FAILURE__;
+            /* Codes_SRS_AMQPVALUE_01_567: [ When a reclaimer is set, amqpvalue_destroy shall not free a list, map or array holding at least min_item_count items when its last reference is dropped, but pass it with one reference to on_reclaim. ]*/
+            INC_REF(AMQP_VALUE_DATA, value);
+            on_reclaim(on_reclaim_context, value);
         }
         else
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            free_value_tree(value);
         }
     }
-
-    return result;
 }
 
-static int encode_byte(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, char value)
+int amqpvalue_set_reclaimer(uint32_t min_item_count, ON_AMQPVALUE_RECLAIM on_reclaim_callback, void* context)
 {
     int result;
 
-    /* Codes_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-    if ((output_byte(encoder_output, context, 0x51) != 0) ||
-        (output_byte(encoder_output, context, value) != 0))
+    /* Codes_SRS_AMQPVALUE_01_566: [ If on_reclaim is not NULL and min_item_count is 0, amqpvalue_set_reclaimer shall fail and return a non-zero value. ]*/
+    if ((on_reclaim_callback != NULL) &&
+        (min_item_count == 0))
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failed encoding byte");
+        LogError("Bad arguments: min_item_count = %u", (unsigned int)min_item_count);
         result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-        result = 0;
+        /* Codes_SRS_AMQPVALUE_01_565: [ amqpvalue_set_reclaimer shall set the callback amqpvalue_destroy passes large values to, a NULL on_reclaim removing it, and return 0. ]*/
+        on_reclaim = on_reclaim_callback;
+        on_reclaim_context = context;
+        reclaim_min_item_count = min_item_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+void amqpvalue_reclaim(AMQP_VALUE value)
+{
+    /* Codes_SRS_AMQPVALUE_01_568: [ If value is NULL, amqpvalue_reclaim shall do nothing. ]*/
+    if (value == NULL)
+    {
+        LogError("NULL value");
+    }
+    else if (value->is_arena_allocated)
+    {
+        /* Codes_SRS_AMQPVALUE_01_417: [ Values allocated from an arena shall not be freed by amqpvalue_destroy, their memory is released by resetting or destroying the arena. ]*/
+    }
+    /* Codes_SRS_AMQPVALUE_01_569: [ amqpvalue_reclaim shall drop a reference to value like amqpvalue_destroy, freeing it when it was the last one without passing it to the reclaimer. ]*/
+    else if (DEC_REF(AMQP_VALUE_DATA, value) == DEC_RETURN_ZERO)
+    {
+        free_value_tree(value);
+    }
+}
+
+static ARENA_BLOCK* arena_block_create(size_t size)
+{
+    ARENA_BLOCK* result = (ARENA_BLOCK*)malloc(ARENA_ALIGN(sizeof(ARENA_BLOCK)) + size);
+    if (result == NULL)
+    {
+        LogError("Could not allocate arena block of %u bytes", (unsigned int)size);
+    }
+    else
+    {
+        result->next = NULL;
+        result->size = size;
+        result->used = 0;
     }
 
     return result;
 }
 
-static int encode_short(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int16_t value)
+static void* arena_malloc(AMQPVALUE_ARENA* arena, size_t size)
 {
-    int result;
+    void* result;
+    size_t aligned_size = ARENA_ALIGN(size);
 
-    /* Codes_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-    if ((output_byte(encoder_output, context, 0x61) != 0) ||
-        (output_byte(encoder_output, context, (value >> 8) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value & 0xFF)) != 0))
+    if ((arena->blocks != NULL) &&
+        (arena->blocks->size - arena->blocks->used >= aligned_size))
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failed encoding short");
-        result = __FAILURE__;
+        result = (unsigned char*)arena->blocks + ARENA_ALIGN(sizeof(ARENA_BLOCK)) + arena->blocks->used;
+        arena->blocks->used += aligned_size;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-        result = 0;
+        ARENA_BLOCK* new_block = arena_block_create((aligned_size > arena->block_size) ? aligned_size : arena->block_size);
+        if (new_block == NULL)
+        {
+            result = NULL;
+        }
+        else
+        {
+            new_block->used = aligned_size;
+            result = (unsigned char*)new_block + ARENA_ALIGN(sizeof(ARENA_BLOCK));
+
+            if ((arena->blocks != NULL) &&
+                (aligned_size > arena->block_size))
+            {
+                /* oversized allocations get a dedicated block that is linked behind the current one,
+                so that the space left in the current block can still be used */
+                new_block->next = arena->blocks->next;
+                arena->blocks->next = new_block;
+            }
+            else
+            {
+                new_block->next = arena->blocks;
+                arena->blocks = new_block;
+            }
+        }
     }
 
     return result;
 }
 
-static int encode_int(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int32_t value)
+AMQPVALUE_ARENA_HANDLE amqpvalue_arena_create(size_t block_size)
 {
-    int result;
+    AMQPVALUE_ARENA* result;
 
-    if ((value <= 127) && (value >= -128))
+    /* Codes_SRS_AMQPVALUE_01_405: [ If `block_size` is 0, `amqpvalue_arena_create` shall fail and return NULL. ]*/
+    if (block_size == 0)
     {
-        /* Codes_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-        if ((output_byte(encoder_output, context, 0x54) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding int");
-            result = __FAILURE__;
-        }
-        else
-        {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
-        }
+        LogError("Zero arena block size");
+        result = NULL;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-        if ((output_byte(encoder_output, context, 0x71) != 0) ||
-            (output_byte(encoder_output, context, (value >> 24) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 16) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 8) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
+        /* Codes_SRS_AMQPVALUE_01_404: [ `amqpvalue_arena_create` shall create a new arena from which decoded AMQP values can be allocated in blocks of `block_size` bytes and return a non-NULL handle to it. ]*/
+        result = (AMQPVALUE_ARENA*)malloc(sizeof(AMQPVALUE_ARENA));
+        if (result == NULL)
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding int");
-            result = __FAILURE__;
+            /* Codes_SRS_AMQPVALUE_01_406: [ If allocating memory for the arena fails, `amqpvalue_arena_create` shall fail and return NULL. ]*/
+            LogError("Could not allocate memory for arena");
         }
         else
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            /* Codes_SRS_AMQPVALUE_01_407: [ No block shall be allocated until the first value is allocated from the arena. ]*/
+            result->blocks = NULL;
+            result->block_size = ARENA_ALIGN(block_size);
         }
     }
 
     return result;
 }
 
-static int encode_long(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int64_t value)
+void amqpvalue_arena_reset(AMQPVALUE_ARENA_HANDLE arena)
 {
-    int result;
-
-    if ((value <= 127) && (value >= -128))
+    if (arena == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-        if ((output_byte(encoder_output, context, 0x55) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding long");
-            result = __FAILURE__;
-        }
-        else
+        /* Codes_SRS_AMQPVALUE_01_409: [ If `arena` is NULL, `amqpvalue_arena_reset` shall do nothing. ]*/
+        LogError("NULL arena");
+    }
+    else if (arena->blocks != NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_408: [ `amqpvalue_arena_reset` shall release all values allocated from the arena at once, keeping one block for reuse. ]*/
+        ARENA_BLOCK* block = arena->blocks->next;
+        while (block != NULL)
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            ARENA_BLOCK* next_block = block->next;
+            free(block);
+            block = next_block;
         }
+
+        arena->blocks->next = NULL;
+        arena->blocks->used = 0;
+    }
+}
+
+void amqpvalue_arena_destroy(AMQPVALUE_ARENA_HANDLE arena)
+{
+    if (arena == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_411: [ If `arena` is NULL, `amqpvalue_arena_destroy` shall do nothing. ]*/
+        LogError("NULL arena");
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
-        if ((output_byte(encoder_output, context, 0x81) != 0) ||
-            (output_byte(encoder_output, context, (value >> 56) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 48) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 40) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 32) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 24) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 16) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (value >> 8) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, value & 0xFF) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding long");
-            result = __FAILURE__;
-        }
-        else
+        /* Codes_SRS_AMQPVALUE_01_410: [ `amqpvalue_arena_destroy` shall free all the blocks owned by the arena and the arena itself. ]*/
+        ARENA_BLOCK* block = arena->blocks;
+        while (block != NULL)
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            ARENA_BLOCK* next_block = block->next;
+            free(block);
+            block = next_block;
         }
-    }
 
-    return result;
+        free(arena);
+    }
 }
 
-static int encode_float(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, float value)
+/* Checked before allocating, so that a hostile encoding cannot make the decoder allocate more than allowed */
+static int charge_decoded_bytes(INTERNAL_DECODER_DATA* internal_decoder_data, size_t size)
 {
     int result;
+    DECODER_LIMITS* limits = internal_decoder_data->limits;
 
-    uint32_t value_as_uint32 = *((uint32_t*)(void*)&value);
-    /* Codes_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>] */
-    if ((output_byte(encoder_output, context, 0x72) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint32 >> 24) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint32 >> 16) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint32 >> 8) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint32) & 0xFF) != 0))
+    if (limits == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failure encoding bytes for float");
+        result = 0;
+    }
+    else if ((limits->max_allocated_bytes != 0) &&
+        (size > limits->max_allocated_bytes - limits->allocated_bytes))
+    {
+        /* Codes_SRS_AMQPVALUE_01_525: [ When decoding a value would exceed any of the limits, the decoder shall fail before allocating memory for the part that exceeds it and `amqpvalue_decode_bytes` and `amqpvalue_decode_one` shall return a non-zero value. ]*/
+        internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+        LogError("Decoding the value would allocate more than %u bytes", (unsigned int)limits->max_allocated_bytes);
         result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        limits->allocated_bytes += size;
         result = 0;
     }
 
     return result;
 }
 
-static int encode_double(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, double value)
+/* Charges the items declared by a list, map or array before anything is allocated for them */
+static int charge_decoded_elements(INTERNAL_DECODER_DATA* internal_decoder_data, uint32_t count)
 {
     int result;
+    DECODER_LIMITS* limits = internal_decoder_data->limits;
 
-    uint64_t value_as_uint64 = *((uint64_t*)(void*)&value);
-    /* Codes_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>] */
-    if ((output_byte(encoder_output, context, 0x82) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64 >> 56) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64 >> 48) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64 >> 40) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64 >> 32) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64 >> 24) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64 >> 16) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64 >> 8) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value_as_uint64) & 0xFF) != 0))
+    if (limits == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failure encoding bytes for double");
+        result = 0;
+    }
+    else if ((limits->max_element_count != 0) &&
+        (count > limits->max_element_count - limits->element_count))
+    {
+        /* Codes_SRS_AMQPVALUE_01_525: [ When decoding a value would exceed any of the limits, the decoder shall fail before allocating memory for the part that exceeds it and `amqpvalue_decode_bytes` and `amqpvalue_decode_one` shall return a non-zero value. ]*/
+        internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+        LogError("Decoding the value would exceed %u elements", (unsigned int)limits->max_element_count);
         result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+        limits->element_count += count;
         result = 0;
     }
 
     return result;
 }
 
-static int encode_timestamp(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, int64_t value)
+static void* decoder_malloc(INTERNAL_DECODER_DATA* internal_decoder_data, size_t size)
 {
-    int result;
+    void* result;
 
-    /* Codes_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-    if ((output_byte(encoder_output, context, 0x83) != 0) ||
-        (output_byte(encoder_output, context, (value >> 56) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value >> 48) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value >> 40) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value >> 32) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value >> 24) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value >> 16) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, (value >> 8) & 0xFF) != 0) ||
-        (output_byte(encoder_output, context, value & 0xFF) != 0))
+    if (charge_decoded_bytes(internal_decoder_data, size) != 0)
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failed encoding timestamp");
-        result = __FAILURE__;
+        result = NULL;
+    }
+    else if (internal_decoder_data->arena == NULL)
+    {
+        result = malloc(size);
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-        result = 0;
+        result = arena_malloc(internal_decoder_data->arena, size);
     }
 
     return result;
 }
 
-static int encode_uuid(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uuid uuid)
+static char* decoder_allocate_chars(INTERNAL_DECODER_DATA* internal_decoder_data, char* inline_chars, size_t length)
 {
-    int result;
+    char* result;
 
-    /* Codes_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
-    if ((output_byte(encoder_output, context, 0x98) != 0) ||
-        (output_bytes(encoder_output, context, uuid, 16)  != 0))
+    if (length < INLINE_CHARS_SIZE)
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-        LogError("Failed encoding uuid");
-        result = __FAILURE__;
+        /* Codes_SRS_AMQPVALUE_01_456: [ Strings and symbols shorter than 24 characters shall be stored in the AMQP_VALUE itself, without allocating memory for the characters. ]*/
+        result = inline_chars;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-        result = 0;
+        result = (char*)decoder_malloc(internal_decoder_data, length + 1);
     }
 
     return result;
 }
 
-static int encode_binary(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const unsigned char* value, uint32_t length)
+static AMQP_VALUE_DATA* decoder_create_value_data(INTERNAL_DECODER_DATA* internal_decoder_data)
 {
-    int result;
-    if (length <= 255)
+    AMQP_VALUE_DATA* result;
+
+    if (charge_decoded_bytes(internal_decoder_data, sizeof(AMQP_VALUE_DATA)) != 0)
     {
-        /* Codes_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-        if ((output_byte(encoder_output, context, 0xA0) != 0) ||
-            (output_byte(encoder_output, context, (unsigned char)length) != 0) ||
-            ((length > 0) && (output_bytes(encoder_output, context, value, length) != 0)))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding binary");
-            result = __FAILURE__;
-        }
-        else
-        {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
-        }
+        result = NULL;
+    }
+    else if (internal_decoder_data->arena == NULL)
+    {
+        result = create_value_data();
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_298: [<encoding name="vbin32" code="0xb0" category="variable" width="4" label="up to 2^32 - 1 octets of binary data"/>] */
-        if ((output_byte(encoder_output, context, 0xB0) != 0) ||
-            (output_byte(encoder_output, context, (length >> 24) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (length >> 16) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (length >> 8) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, length & 0xFF) != 0) ||
-            (output_bytes(encoder_output, context, value, length) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding binary");
-            result = __FAILURE__;
-        }
-        else
+        /* Arena values are never reference counted (clone copies them out of the arena and destroy leaves them alone),
+        but the full ref counted layout is carved so that the value looks the same as a heap one */
+        result = (AMQP_VALUE_DATA*)arena_malloc(internal_decoder_data->arena, sizeof(REFCOUNT_TYPE(AMQP_VALUE_DATA)));
+        if (result != NULL)
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            result->is_arena_allocated = true;
+            result->is_borrowed = false;
+            result->is_interned = false;
+            result->encoded_size_generation = 0;
         }
     }
 
     return result;
 }
 
-static int encode_string(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value)
+static void internal_decoder_init(INTERNAL_DECODER_DATA* internal_decoder_data, ON_VALUE_DECODED on_value_decoded, void* callback_context, AMQP_VALUE_DATA* value_data, bool is_internal, AMQPVALUE_ARENA* arena, bool borrow_binaries, bool lazy_lists, bool validate_strings)
 {
-    int result;
-    size_t length = strlen(value);
+    internal_decoder_data->is_internal = is_internal;
+    internal_decoder_data->on_value_decoded = on_value_decoded;
+    internal_decoder_data->on_value_decoded_context = callback_context;
+    internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+    internal_decoder_data->inner_decoder = NULL;
+    internal_decoder_data->decode_to_value = value_data;
+    internal_decoder_data->arena = arena;
+    internal_decoder_data->borrow_binaries = borrow_binaries;
+    internal_decoder_data->lazy_lists = lazy_lists;
+    internal_decoder_data->validate_strings = validate_strings;
+}
 
-    if (length <= 255)
+static INTERNAL_DECODER_DATA* internal_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context, AMQP_VALUE_DATA* value_data, bool is_internal, AMQPVALUE_ARENA* arena, bool borrow_binaries, bool lazy_lists, bool validate_strings)
+{
+    INTERNAL_DECODER_DATA* internal_decoder_data = (INTERNAL_DECODER_DATA*)malloc(sizeof(INTERNAL_DECODER_DATA));
+    if (internal_decoder_data == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-        if ((output_byte(encoder_output, context, (unsigned char)0xA1) != 0) ||
-            (output_byte(encoder_output, context, (unsigned char)length) != 0) ||
-            (output_bytes(encoder_output, context, value, length) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding string");
-            result = __FAILURE__;
-        }
-        else
-        {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
-        }
+        LogError("Cannot allocate memory for internal decoder structure");
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_300: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-        if ((output_byte(encoder_output, context, 0xB1) != 0) ||
-            (output_byte(encoder_output, context, (length >> 24) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (length >> 16) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (length >> 8) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, length & 0xFF) != 0) ||
-            (output_bytes(encoder_output, context, value, length) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding string");
-            result = __FAILURE__;
-        }
-        else
-        {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
-        }
+        internal_decoder_data->spare_inner_decoder = NULL;
+        internal_decoder_data->limits = NULL;
+        internal_decoder_data->depth = 0;
+        internal_decoder_init(internal_decoder_data, on_value_decoded, callback_context, value_data, is_internal, arena, borrow_binaries, lazy_lists, validate_strings);
     }
 
-    return result;
+    return internal_decoder_data;
 }
 
-static int encode_symbol(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value)
+static void internal_decoder_destroy(INTERNAL_DECODER_DATA* internal_decoder)
 {
-    int result;
-    size_t length = strlen(value);
+    if (internal_decoder != NULL)
+    {
+        internal_decoder_destroy(internal_decoder->inner_decoder);
+        internal_decoder_destroy(internal_decoder->spare_inner_decoder);
+        free(internal_decoder);
+    }
+}
 
-    if (length <= 255)
+static void inner_decoder_callback(void* context, AMQP_VALUE decoded_value)
+{
+    /* API issue: the decoded_value should be removed completely:
+    TODO: uAMQP: inner_decoder_callback in amqpvalue.c could probably do without the decoded_value ... */
+    INTERNAL_DECODER_DATA* internal_decoder_data = (INTERNAL_DECODER_DATA*)context;
+    INTERNAL_DECODER_DATA* inner_decoder = (INTERNAL_DECODER_DATA*)internal_decoder_data->inner_decoder;
+
+    /* a value holding borrowed items has to be copied when cloned, just like the items */
+    if (decoded_value->is_borrowed)
     {
-        /* Codes_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-        if ((output_byte(encoder_output, context, (unsigned char)0xA3) != 0) ||
-            (output_byte(encoder_output, context, (unsigned char)length) != 0) ||
-            (output_bytes(encoder_output, context, value, length) != 0))
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding symbol");
-            result = __FAILURE__;
-        }
-        else
-        {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
-        }
+        internal_decoder_data->decode_to_value->is_borrowed = true;
+    }
+
+    inner_decoder->decoder_state = DECODER_STATE_DONE;
+}
+
+/* Each nesting level keeps the inner decoder of its last item, so decoding the items of a
+   compound value (and decoding the next value after a reset) does not allocate decoders again */
+static INTERNAL_DECODER_DATA* inner_decoder_create(INTERNAL_DECODER_DATA* internal_decoder_data, AMQP_VALUE_DATA* value_data)
+{
+    INTERNAL_DECODER_DATA* result;
+
+    if ((internal_decoder_data->limits != NULL) &&
+        (internal_decoder_data->limits->max_depth != 0) &&
+        (internal_decoder_data->depth >= internal_decoder_data->limits->max_depth))
+    {
+        /* Codes_SRS_AMQPVALUE_01_525: [ When decoding a value would exceed any of the limits, the decoder shall fail before allocating memory for the part that exceeds it and `amqpvalue_decode_bytes` and `amqpvalue_decode_one` shall return a non-zero value. ]*/
+        LogError("Values nested deeper than %u levels", (unsigned int)internal_decoder_data->limits->max_depth);
+        result = NULL;
     }
     else
     {
-        /* Codes_SRS_AMQPVALUE_01_302: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-        if ((output_byte(encoder_output, context, 0xB3) != 0) ||
-            (output_byte(encoder_output, context, (length >> 24) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (length >> 16) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, (length >> 8) & 0xFF) != 0) ||
-            (output_byte(encoder_output, context, length & 0xFF) != 0) ||
-            /* Codes_SRS_AMQPVALUE_01_122: [Symbols are encoded as ASCII characters [ASCII].] */
-            (output_bytes(encoder_output, context, value, length) != 0))
+        if (internal_decoder_data->spare_inner_decoder != NULL)
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Failed encoding symbol");
-            result = __FAILURE__;
+            result = internal_decoder_data->spare_inner_decoder;
+            internal_decoder_data->spare_inner_decoder = NULL;
+            internal_decoder_init(result, inner_decoder_callback, internal_decoder_data, value_data, true, internal_decoder_data->arena, internal_decoder_data->borrow_binaries, internal_decoder_data->lazy_lists, internal_decoder_data->validate_strings);
         }
         else
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            result = internal_decoder_create(inner_decoder_callback, internal_decoder_data, value_data, true, internal_decoder_data->arena, internal_decoder_data->borrow_binaries, internal_decoder_data->lazy_lists, internal_decoder_data->validate_strings);
+        }
+
+        if (result != NULL)
+        {
+            result->limits = internal_decoder_data->limits;
+            result->depth = internal_decoder_data->depth + 1;
         }
     }
 
-    return result;
+    return result;
+}
+
+static void inner_decoder_release(INTERNAL_DECODER_DATA* internal_decoder_data, INTERNAL_DECODER_DATA* inner_decoder)
+{
+    if (internal_decoder_data->spare_inner_decoder == NULL)
+    {
+        internal_decoder_data->spare_inner_decoder = inner_decoder;
+    }
+    else
+    {
+        internal_decoder_destroy(inner_decoder);
+    }
+}
+
+static uint16_t read_uint16_from_span(const unsigned char* bytes)
+{
+    return (uint16_t)(((uint16_t)bytes[0] << 8) | bytes[1]);
 }
 
-static int encode_list(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t count, AMQP_VALUE* items)
+static uint32_t read_uint32_from_span(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+static uint64_t read_uint64_from_span(const unsigned char* bytes)
+{
+    return ((uint64_t)read_uint32_from_span(bytes) << 32) | read_uint32_from_span(bytes + 4);
+}
+
+static void complete_value_decode(INTERNAL_DECODER_DATA* internal_decoder_data)
+{
+    internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+    /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+    /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+    /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+    internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+}
+
+/* what decoding needs to know about a constructor byte, looked up instead of switched on */
+typedef enum CONSTRUCTOR_CLASS_TAG
+{
+    CONSTRUCTOR_CLASS_INVALID,
+    CONSTRUCTOR_CLASS_DESCRIBED,
+    /* fixed_byte_count bytes of value */
+    CONSTRUCTOR_CLASS_FIXED,
+    /* size_prefix_length bytes of size followed by that many bytes of binary, string or symbol */
+    CONSTRUCTOR_CLASS_VARIABLE,
+    /* size_prefix_length bytes of size followed by the count and the items (and for an array their constructor) */
+    CONSTRUCTOR_CLASS_COMPOUND
+} CONSTRUCTOR_CLASS;
+
+/* kept to 4 bytes so that the whole table is 1KB */
+typedef struct CONSTRUCTOR_INFO_TAG
+{
+    uint8_t constructor_class;
+    uint8_t size_prefix_length;
+    uint8_t fixed_byte_count;
+    uint8_t type;
+} CONSTRUCTOR_INFO;
+
+#define CI_NONE { CONSTRUCTOR_CLASS_INVALID, 0, 0, AMQP_TYPE_UNKNOWN }
+#define CI_DESCRIBED { CONSTRUCTOR_CLASS_DESCRIBED, 0, 0, AMQP_TYPE_DESCRIBED }
+#define CI_FIXED(byte_count, type) { CONSTRUCTOR_CLASS_FIXED, 0, byte_count, type }
+#define CI_VARIABLE(prefix_length, type) { CONSTRUCTOR_CLASS_VARIABLE, prefix_length, 0, type }
+#define CI_COMPOUND(prefix_length, type) { CONSTRUCTOR_CLASS_COMPOUND, prefix_length, 0, type }
+#define CI_NONE_4 CI_NONE, CI_NONE, CI_NONE, CI_NONE
+#define CI_NONE_16 CI_NONE_4, CI_NONE_4, CI_NONE_4, CI_NONE_4
+
+/* indexed by constructor byte, only the constructors the decoder supports are valid (the decimal types and char are not) */
+static const CONSTRUCTOR_INFO constructor_infos[256] =
+{
+    /* 0x00 */ CI_DESCRIBED, CI_NONE, CI_NONE, CI_NONE, CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0x10 */ CI_NONE_16,
+    /* 0x20 */ CI_NONE_16,
+    /* 0x30 */ CI_NONE_16,
+    /* 0x40 */ CI_FIXED(0, AMQP_TYPE_NULL), CI_FIXED(0, AMQP_TYPE_BOOL), CI_FIXED(0, AMQP_TYPE_BOOL), CI_FIXED(0, AMQP_TYPE_UINT),
+               CI_FIXED(0, AMQP_TYPE_ULONG), CI_FIXED(0, AMQP_TYPE_LIST), CI_NONE, CI_NONE, CI_NONE_4, CI_NONE_4,
+    /* 0x50 */ CI_FIXED(1, AMQP_TYPE_UBYTE), CI_FIXED(1, AMQP_TYPE_BYTE), CI_FIXED(1, AMQP_TYPE_UINT), CI_FIXED(1, AMQP_TYPE_ULONG),
+               CI_FIXED(1, AMQP_TYPE_INT), CI_FIXED(1, AMQP_TYPE_LONG), CI_FIXED(1, AMQP_TYPE_BOOL), CI_NONE, CI_NONE_4, CI_NONE_4,
+    /* 0x60 */ CI_FIXED(2, AMQP_TYPE_USHORT), CI_FIXED(2, AMQP_TYPE_SHORT), CI_NONE, CI_NONE, CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0x70 */ CI_FIXED(4, AMQP_TYPE_UINT), CI_FIXED(4, AMQP_TYPE_INT), CI_FIXED(4, AMQP_TYPE_FLOAT), CI_NONE, CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0x80 */ CI_FIXED(8, AMQP_TYPE_ULONG), CI_FIXED(8, AMQP_TYPE_LONG), CI_FIXED(8, AMQP_TYPE_DOUBLE), CI_FIXED(8, AMQP_TYPE_TIMESTAMP),
+               CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0x90 */ CI_NONE_4, CI_NONE_4, CI_FIXED(16, AMQP_TYPE_UUID), CI_NONE, CI_NONE, CI_NONE, CI_NONE_4,
+    /* 0xA0 */ CI_VARIABLE(1, AMQP_TYPE_BINARY), CI_VARIABLE(1, AMQP_TYPE_STRING), CI_NONE, CI_VARIABLE(1, AMQP_TYPE_SYMBOL), CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0xB0 */ CI_VARIABLE(4, AMQP_TYPE_BINARY), CI_VARIABLE(4, AMQP_TYPE_STRING), CI_NONE, CI_VARIABLE(4, AMQP_TYPE_SYMBOL), CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0xC0 */ CI_COMPOUND(1, AMQP_TYPE_LIST), CI_COMPOUND(1, AMQP_TYPE_MAP), CI_NONE, CI_NONE, CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0xD0 */ CI_COMPOUND(4, AMQP_TYPE_LIST), CI_COMPOUND(4, AMQP_TYPE_MAP), CI_NONE, CI_NONE, CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0xE0 */ CI_COMPOUND(1, AMQP_TYPE_ARRAY), CI_NONE, CI_NONE, CI_NONE, CI_NONE_4, CI_NONE_4, CI_NONE_4,
+    /* 0xF0 */ CI_COMPOUND(4, AMQP_TYPE_ARRAY), CI_NONE, CI_NONE, CI_NONE, CI_NONE_4, CI_NONE_4, CI_NONE_4
+};
+
+/* Gets the length of the encoded value at the start of bytes (constructor included) without decoding it */
+static int get_encoded_value_length(const unsigned char* bytes, size_t size, size_t* length)
 {
-    size_t i;
     int result;
 
-    if (count == 0)
+    if (size == 0)
     {
-        /* Codes_SRS_AMQPVALUE_01_303: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
-        if (output_byte(encoder_output, context, 0x45) != 0)
+        result = __FAILURE__;
+    }
+    else
+    {
+        const CONSTRUCTOR_INFO* constructor_info = &constructor_infos[bytes[0]];
+        size_t data_length = 0;
+        result = 0;
+
+        if (constructor_info->constructor_class == CONSTRUCTOR_CLASS_FIXED)
+        {
+            data_length = constructor_info->fixed_byte_count;
+        }
+        else if (constructor_info->constructor_class == CONSTRUCTOR_CLASS_DESCRIBED)
+        {
+            size_t descriptor_length;
+            size_t value_length;
+            if ((get_encoded_value_length(bytes + 1, size - 1, &descriptor_length) != 0) ||
+                (get_encoded_value_length(bytes + 1 + descriptor_length, size - 1 - descriptor_length, &value_length) != 0))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                data_length = descriptor_length + value_length;
+            }
+        }
+        else if (constructor_info->constructor_class == CONSTRUCTOR_CLASS_INVALID)
+        {
+            result = __FAILURE__;
+        }
+        /* variable and compound values are sized alike */
+        else if (size - 1 < constructor_info->size_prefix_length)
         {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-            LogError("Could not output list constructor byte");
             result = __FAILURE__;
         }
         else
         {
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = 0;
+            data_length = constructor_info->size_prefix_length +
+                ((constructor_info->size_prefix_length == 1) ? (size_t)bytes[1] : (size_t)read_uint32_from_span(bytes + 1));
         }
-    }
-    else
-    {
-        uint32_t size = 0;
 
-        /* get the size of all items in the list */
-        for (i = 0; i < count; i++)
+        if (result == 0)
         {
-            size_t item_size;
-            if (amqpvalue_get_encoded_size(items[i], &item_size) != 0)
+            if (size - 1 < data_length)
             {
-                LogError("Could not get encoded size for element %u of the list", (unsigned int)i);
-                break;
+                result = __FAILURE__;
             }
-
-            if ((item_size > UINT32_MAX) ||
-                size + (uint32_t)item_size < size)
+            else
             {
-                LogError("Overflow in list size computation");
-                break;
+                *length = 1 + data_length;
             }
-
-            size = (uint32_t)(size + item_size);
         }
+    }
 
-        if (i < count)
-        {
-            /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+    return result;
+}
+
+/* Records where each item of a list starts instead of decoding the items. is_lazy is left false (and the list
+is decoded as usual) when lazy lists are not enabled or the items do not add up to the list size. */
+static int decode_lazy_list_from_span(INTERNAL_DECODER_DATA* internal_decoder_data, const unsigned char* bytes, uint32_t length, bool* is_lazy)
+{
+    int result = 0;
+    uint32_t count = internal_decoder_data->decode_to_value->value.list_value.count;
+
+    *is_lazy = false;
+
+    /* Codes_SRS_AMQPVALUE_01_466: [ Only lists whose bytes are all in the buffer passed to amqpvalue_decode_bytes shall be decoded lazily, and only when no arena is set for the decoder. ]*/
+    /* Codes_SRS_AMQPVALUE_01_481: [ When string validation is enabled, lists shall not be decoded lazily, so that all the strings and symbols are validated when decoded. ]*/
+    if (internal_decoder_data->lazy_lists &&
+        !internal_decoder_data->validate_strings &&
+        (internal_decoder_data->arena == NULL) &&
+        (count > 0) &&
+        /* every item takes at least one byte */
+        (count <= length))
+    {
+        /* no arena is set, so this allocates from the heap */
+        LAZY_LIST_ITEMS* lazy_items = (LAZY_LIST_ITEMS*)decoder_malloc(internal_decoder_data, sizeof(LAZY_LIST_ITEMS) + (sizeof(uint32_t) * ((size_t)count + 1)));
+        if (lazy_items == NULL)
+        {
+            internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+            LogError("Could not allocate memory for lazily decoded list");
             result = __FAILURE__;
         }
         else
         {
-            if ((count <= 255) && (size < 255))
-            {
-                size++;
+            uint32_t offset = 0;
+            uint32_t i;
 
-                /* Codes_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-                if ((output_byte(encoder_output, context, 0xC0) != 0) ||
-                    /* size */
-                    (output_byte(encoder_output, context, (size & 0xFF)) != 0) ||
-                    /* count */
-                    (output_byte(encoder_output, context, (count & 0xFF)) != 0))
-                {
-                    /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-                    LogError("Failed encoding list");
-                    result = __FAILURE__;
-                }
-                else
+            lazy_items->bytes = bytes;
+            lazy_items->item_offsets = (uint32_t*)(lazy_items + 1);
+
+            for (i = 0; i < count; i++)
+            {
+                size_t item_length;
+                if (get_encoded_value_length(bytes + offset, length - offset, &item_length) != 0)
                 {
-                    /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-                    result = 0;
+                    break;
                 }
+
+                lazy_items->item_offsets[i] = offset;
+                offset += (uint32_t)item_length;
+            }
+
+            lazy_items->item_offsets[count] = offset;
+
+            if ((i < count) ||
+                (offset != length))
+            {
+                /* let the regular decoder deal with it (and report what is wrong) */
+                free(lazy_items);
+            }
+            else if (charge_decoded_elements(internal_decoder_data, count) != 0)
+            {
+                free(lazy_items);
+                result = __FAILURE__;
             }
             else
             {
-                size += 4;
-
-                /* Codes_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-                if ((output_byte(encoder_output, context, 0xD0) != 0) ||
-                    /* size */
-                    (output_byte(encoder_output, context, (size >> 24) & 0xFF) != 0) ||
-                    (output_byte(encoder_output, context, (size >> 16) & 0xFF) != 0) ||
-                    (output_byte(encoder_output, context, (size >> 8) & 0xFF) != 0) ||
-                    (output_byte(encoder_output, context, size & 0xFF) != 0) ||
-                    /* count */
-                    (output_byte(encoder_output, context, (count >> 24) & 0xFF) != 0) ||
-                    (output_byte(encoder_output, context, (count >> 16) & 0xFF) != 0) ||
-                    (output_byte(encoder_output, context, (count >> 8) & 0xFF) != 0) ||
-                    (output_byte(encoder_output, context, count & 0xFF) != 0))
+                AMQP_VALUE* items = (AMQP_VALUE*)decoder_malloc(internal_decoder_data, sizeof(AMQP_VALUE) * count);
+                if (items == NULL)
                 {
-                    /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-                    LogError("Failed encoding list");
+                    internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+                    LogError("Could not allocate memory for decoded list value");
+                    free(lazy_items);
                     result = __FAILURE__;
                 }
                 else
                 {
-                    /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-                    result = 0;
-                }
-            }
-
-            if (result == 0)
-            {
-                for (i = 0; i < count; i++)
-                {
-                    if (amqpvalue_encode(items[i], encoder_output, context) != 0)
+                    AMQP_VALUE_DATA* value_data = internal_decoder_data->decode_to_value;
+                    for (i = 0; i < count; i++)
                     {
-                        break;
+                        items[i] = NULL;
                     }
-                }
 
-                if (i < count)
-                {
-                    LogError("Failed encoding element %u of the list", (unsigned int)i);
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
+                    /* Codes_SRS_AMQPVALUE_01_460: [ When lazy lists are enabled, the items of decoded lists shall not be decoded until they are accessed. ]*/
+                    value_data->value.list_value.items = items;
+                    value_data->value.list_value.capacity = count;
+                    value_data->value.list_value.lazy_items = lazy_items;
+
+                    /* Codes_SRS_AMQPVALUE_01_467: [ A lazily decoded list shall be treated as borrowed, since it points to the bytes passed to amqpvalue_decode_bytes. ]*/
+                    value_data->is_borrowed = true;
+
+                    *is_lazy = true;
+                    complete_value_decode(internal_decoder_data);
                 }
             }
         }
@@ -2918,438 +7831,676 @@ static int encode_list(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, u
     return result;
 }
 
-static int encode_map(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t count, AMQP_MAP_KEY_VALUE_PAIR* pairs)
+static void lazy_list_item_decoded(void* context, AMQP_VALUE decoded_value)
 {
-    size_t i;
-    int result;
-
-    uint32_t size = 0;
+    bool* is_decoded = (bool*)context;
+    (void)decoded_value;
+    *is_decoded = true;
+}
 
-    /* Codes_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
-    uint32_t elements = count * 2;
+static int start_decoding_list_items(INTERNAL_DECODER_DATA* internal_decoder_data)
+{
+    int result;
 
-    /* get the size of all items in the list */
-    for (i = 0; i < count; i++)
+    if (internal_decoder_data->decode_to_value->value.list_value.count == 0)
     {
-        size_t item_size;
-        if (amqpvalue_get_encoded_size(pairs[i].key, &item_size) != 0)
+        complete_value_decode(internal_decoder_data);
+        result = 0;
+    }
+    else if (charge_decoded_elements(internal_decoder_data, internal_decoder_data->decode_to_value->value.list_value.count) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        internal_decoder_data->decode_to_value->value.list_value.items = (AMQP_VALUE*)decoder_malloc(internal_decoder_data, sizeof(AMQP_VALUE) * internal_decoder_data->decode_to_value->value.list_value.count);
+        if (internal_decoder_data->decode_to_value->value.list_value.items == NULL)
         {
-            LogError("Could not get encoded size for key element %u of the map", (unsigned int)i);
-            break;
+            LogError("Could not allocate memory for decoded list value");
+            result = __FAILURE__;
         }
-
-        if ((item_size > UINT32_MAX) ||
-            size + (uint32_t)item_size < size)
+        else
         {
-            LogError("Encoded data is more than the max size for a map");
-            break;
-        }
-        
-        size = (uint32_t)(size + item_size);
+            uint32_t i;
+            internal_decoder_data->decode_to_value->value.list_value.capacity = internal_decoder_data->decode_to_value->value.list_value.count;
+            for (i = 0; i < internal_decoder_data->decode_to_value->value.list_value.count; i++)
+            {
+                internal_decoder_data->decode_to_value->value.list_value.items[i] = NULL;
+            }
 
-        if (amqpvalue_get_encoded_size(pairs[i].value, &item_size) != 0)
-        {
-            LogError("Could not get encoded size for value element %u of the map", (unsigned int)i);
-            break;
+            internal_decoder_data->decode_value_state.list_value_state.list_value_state = DECODE_LIST_STEP_ITEMS;
+            internal_decoder_data->bytes_decoded = 0;
+            internal_decoder_data->inner_decoder = NULL;
+            internal_decoder_data->decode_value_state.list_value_state.item = 0;
+            result = 0;
         }
+    }
 
-        if ((item_size > UINT32_MAX) ||
-            size + (uint32_t)item_size < size)
-        {
-            LogError("Encoded data is more than the max size for a map");
-            break;
-        }
+    return result;
+}
 
-        size = (uint32_t)(size + item_size);
-    }
+static int start_decoding_map_pairs(INTERNAL_DECODER_DATA* internal_decoder_data)
+{
+    int result;
 
-    if (i < count)
+    if (internal_decoder_data->decode_to_value->value.map_value.pair_count == 0)
+    {
+        complete_value_decode(internal_decoder_data);
+        result = 0;
+    }
+    else if (charge_decoded_elements(internal_decoder_data, internal_decoder_data->decode_to_value->value.map_value.pair_count) != 0)
     {
-        /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
         result = __FAILURE__;
     }
     else
     {
-        if ((elements <= 255) && (size < 255))
-        {
-            size++;
+        internal_decoder_data->decode_to_value->value.map_value.pair_count /= 2;
 
-            /* Codes_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-            if ((output_byte(encoder_output, context, 0xC1) != 0) ||
-                /* size */
-                (output_byte(encoder_output, context, (size & 0xFF)) != 0) ||
-                /* count */
-                (output_byte(encoder_output, context, (elements & 0xFF)) != 0))
-            {
-                /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-                LogError("Could not encode map header");
-                result = __FAILURE__;
-            }
-            else
-            {
-                /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-                result = 0;
-            }
+        internal_decoder_data->decode_to_value->value.map_value.pairs = (AMQP_MAP_KEY_VALUE_PAIR*)decoder_malloc(internal_decoder_data, sizeof(AMQP_MAP_KEY_VALUE_PAIR) * (internal_decoder_data->decode_to_value->value.map_value.pair_count * 2));
+        if (internal_decoder_data->decode_to_value->value.map_value.pairs == NULL)
+        {
+            LogError("Could not allocate memory for map value items");
+            result = __FAILURE__;
         }
         else
         {
-            size += 4;
-
-            /* Codes_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>] */
-            if ((output_byte(encoder_output, context, 0xD1) != 0) ||
-                /* size */
-                (output_byte(encoder_output, context, (size >> 24) & 0xFF) != 0) ||
-                (output_byte(encoder_output, context, (size >> 16) & 0xFF) != 0) ||
-                (output_byte(encoder_output, context, (size >> 8) & 0xFF) != 0) ||
-                (output_byte(encoder_output, context, size & 0xFF) != 0) ||
-                /* count */
-                (output_byte(encoder_output, context, (elements >> 24) & 0xFF) != 0) ||
-                (output_byte(encoder_output, context, (elements >> 16) & 0xFF) != 0) ||
-                (output_byte(encoder_output, context, (elements >> 8) & 0xFF) != 0) ||
-                (output_byte(encoder_output, context, elements & 0xFF) != 0))
+            uint32_t i;
+            internal_decoder_data->decode_to_value->value.map_value.capacity = internal_decoder_data->decode_to_value->value.map_value.pair_count;
+            for (i = 0; i < internal_decoder_data->decode_to_value->value.map_value.pair_count; i++)
             {
-                /* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-                LogError("Could not encode map header");
-                result = __FAILURE__;
+                internal_decoder_data->decode_to_value->value.map_value.pairs[i].key = NULL;
+                internal_decoder_data->decode_to_value->value.map_value.pairs[i].value = NULL;
             }
-            else
+
+            /* Codes_SRS_AMQPVALUE_01_570: [ When decoding a map of at least 8 pairs, not into an arena, the decoder shall build the hash index of the map as its keys are decoded. ]*/
+            if ((internal_decoder_data->decode_to_value->value.map_value.pair_count >= MAP_INDEX_MIN_PAIR_COUNT) &&
+                (internal_decoder_data->arena == NULL))
             {
-                /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-                result = 0;
+                /* without an index the lookups scan the pairs until a pair added to the map builds it */
+                (void)create_empty_map_index(internal_decoder_data->decode_to_value);
             }
+
+            internal_decoder_data->decode_value_state.map_value_state.map_value_state = DECODE_MAP_STEP_PAIRS;
+            internal_decoder_data->bytes_decoded = 0;
+            internal_decoder_data->inner_decoder = NULL;
+            internal_decoder_data->decode_value_state.map_value_state.item = 0;
+            result = 0;
         }
+    }
 
-        if (result == 0)
-        {
-            /* Codes_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
-            for (i = 0; i < count; i++)
-            {
-                if ((amqpvalue_encode(pairs[i].key, encoder_output, context) != 0) ||
-                    (amqpvalue_encode(pairs[i].value, encoder_output, context) != 0))
-                {
-                    LogError("Failed encoding map element %u", (unsigned int)i);
-                    break;
-                }
-            }
+    return result;
+}
 
-            if (i < count)
+/* Decodes the items of an array of fixed width primitives straight into a packed array. is_packed is left false (and the array
+is decoded item by item) for other item types, when decoding into an arena or when the items do not add up to the array size. */
+static int decode_packed_array_from_span(INTERNAL_DECODER_DATA* internal_decoder_data, uint8_t item_constructor, const unsigned char* bytes, uint32_t items_size, bool* is_packed)
+{
+    int result = 0;
+    AMQP_VALUE_DATA* value_data = internal_decoder_data->decode_to_value;
+    uint32_t count = value_data->value.array_value.count;
+    const CONSTRUCTOR_INFO* item_constructor_info = &constructor_infos[item_constructor];
+    /* booleans and the constructors without value bytes are never packed */
+    AMQP_TYPE item_type = ((item_constructor_info->constructor_class == CONSTRUCTOR_CLASS_FIXED) &&
+        (item_constructor_info->fixed_byte_count > 0) &&
+        (item_constructor_info->type != AMQP_TYPE_BOOL)) ? (AMQP_TYPE)item_constructor_info->type : AMQP_TYPE_UNKNOWN;
+    /* smalluint, smallulong, smallint and smalllong items take 1 byte on the wire */
+    bool is_small = (item_type != AMQP_TYPE_UNKNOWN) &&
+        (item_constructor_info->fixed_byte_count < get_packed_array_item_size(item_type));
+
+    *is_packed = false;
+
+    if ((item_type != AMQP_TYPE_UNKNOWN) &&
+        (internal_decoder_data->arena == NULL) &&
+        (count > 0) &&
+        ((uint64_t)count * (is_small ? 1 : get_packed_array_item_size(item_type)) == items_size))
+    {
+        size_t item_size = get_packed_array_item_size(item_type);
+        unsigned char* packed_items;
+
+        if (charge_decoded_elements(internal_decoder_data, count) != 0)
+        {
+            result = __FAILURE__;
+        }
+        /* no arena is set, so this allocates from the heap */
+        else if ((packed_items = (unsigned char*)decoder_malloc(internal_decoder_data, (size_t)count * item_size)) == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+            internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+            LogError("Could not allocate memory for packed array items");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (!is_small)
             {
-                LogError("Could not encode map");
-                result = __FAILURE__;
+                read_packed_array_items(packed_items, bytes, count, item_size);
             }
             else
             {
-                result = 0;
+                uint32_t i;
+
+                for (i = 0; i < count; i++)
+                {
+                    if (item_type == AMQP_TYPE_UINT)
+                    {
+                        uint32_t item = bytes[i];
+                        (void)memcpy(packed_items + ((size_t)i * item_size), &item, item_size);
+                    }
+                    else if (item_type == AMQP_TYPE_ULONG)
+                    {
+                        uint64_t item = bytes[i];
+                        (void)memcpy(packed_items + ((size_t)i * item_size), &item, item_size);
+                    }
+                    else if (item_type == AMQP_TYPE_INT)
+                    {
+                        int32_t item = (int8_t)bytes[i];
+                        (void)memcpy(packed_items + ((size_t)i * item_size), &item, item_size);
+                    }
+                    else
+                    {
+                        int64_t item = (int8_t)bytes[i];
+                        (void)memcpy(packed_items + ((size_t)i * item_size), &item, item_size);
+                    }
+                }
             }
+
+            /* Codes_SRS_AMQPVALUE_01_495: [ When all the bytes of an array of fixed width primitives are in the buffer passed to amqpvalue_decode_bytes and no arena is set, the decoder shall decode it as a packed array. ]*/
+            value_data->value.array_value.packed_items = packed_items;
+            value_data->value.array_value.packed_item_type = item_type;
+            *is_packed = true;
+            complete_value_decode(internal_decoder_data);
         }
     }
 
     return result;
 }
 
-static int encode_descriptor_header(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context)
+static int start_decoding_array_items(INTERNAL_DECODER_DATA* internal_decoder_data)
 {
     int result;
 
-    if (output_byte(encoder_output, context, 0x00) != 0)
-    {
-        LogError("Failed encoding descriptor header");
-        result = __FAILURE__;
-    }
-    else
+    if (internal_decoder_data->decode_to_value->value.array_value.count == 0)
     {
+        complete_value_decode(internal_decoder_data);
         result = 0;
     }
-
-    return result;
-}
-
-/* Codes_SRS_AMQPVALUE_01_265: [amqpvalue_encode shall encode the value per the ISO.] */
-int amqpvalue_encode(AMQP_VALUE value, AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context)
-{
-    int result;
-
-    /* Codes_SRS_AMQPVALUE_01_269: [If value or encoder_output are NULL, amqpvalue_encode shall fail and return a non-zero value.] */
-    if ((value == NULL) ||
-        (encoder_output == NULL))
+    else if (charge_decoded_elements(internal_decoder_data, internal_decoder_data->decode_to_value->value.array_value.count) != 0)
     {
-        LogError("Bad arguments: value = %p, encoder_output = %p",
-            value, encoder_output);
         result = __FAILURE__;
     }
     else
     {
-        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
-
-        switch (value_data->type)
+        internal_decoder_data->decode_to_value->value.array_value.items = (AMQP_VALUE*)decoder_malloc(internal_decoder_data, sizeof(AMQP_VALUE) * internal_decoder_data->decode_to_value->value.array_value.count);
+        if (internal_decoder_data->decode_to_value->value.array_value.items == NULL)
         {
-        default:
-            /* Codes_SRS_AMQPVALUE_01_271: [If encoding fails due to any error not specifically mentioned here, it shall return a non-zero value.] */
-            LogError("Invalid type: %d", (int)value_data->type);
+            LogError("Could not allocate memory for array items");
             result = __FAILURE__;
-            break;
-
-        case AMQP_TYPE_NULL:
-            /* Codes_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
-            /* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-            result = output_byte(encoder_output, context, (unsigned char)0x40);
-            break;
-
-        case AMQP_TYPE_BOOL:
-            result = encode_boolean(encoder_output, context, value_data->value.bool_value);
-            break;
-
-        case AMQP_TYPE_UBYTE:
-            result = encode_ubyte(encoder_output, context, value_data->value.ubyte_value);
-            break;
-
-        case AMQP_TYPE_USHORT:
-            result = encode_ushort(encoder_output, context, value_data->value.ushort_value);
-            break;
-
-        case AMQP_TYPE_UINT:
-            result = encode_uint(encoder_output, context, value_data->value.uint_value);
-            break;
-
-        case AMQP_TYPE_ULONG:
-            result = encode_ulong(encoder_output, context, value_data->value.ulong_value);
-            break;
-
-        case AMQP_TYPE_BYTE:
-            result = encode_byte(encoder_output, context, value_data->value.byte_value);
-            break;
-
-        case AMQP_TYPE_SHORT:
-            result = encode_short(encoder_output, context, value_data->value.short_value);
-            break;
+        }
+        else
+        {
+            uint32_t i;
+            internal_decoder_data->decode_to_value->value.array_value.capacity = internal_decoder_data->decode_to_value->value.array_value.count;
+            for (i = 0; i < internal_decoder_data->decode_to_value->value.array_value.count; i++)
+            {
+                internal_decoder_data->decode_to_value->value.array_value.items[i] = NULL;
+            }
 
-        case AMQP_TYPE_INT:
-            result = encode_int(encoder_output, context, value_data->value.int_value);
-            break;
+            internal_decoder_data->decode_value_state.array_value_state.array_value_state = DECODE_ARRAY_STEP_ITEMS;
+            internal_decoder_data->bytes_decoded = 0;
+            internal_decoder_data->inner_decoder = NULL;
+            internal_decoder_data->decode_value_state.array_value_state.item = 0;
+            result = 0;
+        }
+    }
 
-        case AMQP_TYPE_LONG:
-            result = encode_long(encoder_output, context, value_data->value.long_value);
-            break;
+    return result;
+}
 
-        case AMQP_TYPE_FLOAT:
-            result = encode_float(encoder_output, context, value_data->value.float_value);
-            break;
+/* Returns how many bytes at the start of bytes are 7-bit ASCII. 8 bytes are checked at a time, so mostly ASCII text is scanned
+   at word speed. */
+static size_t get_ascii_prefix_length(const unsigned char* bytes, size_t length)
+{
+    size_t i = 0;
 
-        case AMQP_TYPE_DOUBLE:
-            result = encode_double(encoder_output, context, value_data->value.double_value);
+    while (length - i >= sizeof(uint64_t))
+    {
+        uint64_t word;
+        (void)memcpy(&word, bytes + i, sizeof(word));
+        if ((word & 0x8080808080808080ULL) != 0)
+        {
             break;
+        }
 
-        case AMQP_TYPE_TIMESTAMP:
-            result = encode_timestamp(encoder_output, context, value_data->value.timestamp_value);
-            break;
+        i += sizeof(uint64_t);
+    }
 
-        case AMQP_TYPE_UUID:
-            result = encode_uuid(encoder_output, context, value_data->value.uuid_value);
-            break;
+    while ((i < length) && (bytes[i] < 0x80))
+    {
+        i++;
+    }
 
-        case AMQP_TYPE_BINARY:
-            result = encode_binary(encoder_output, context, (const unsigned char*)value_data->value.binary_value.bytes, value_data->value.binary_value.length);
-            break;
+    return i;
+}
 
-        case AMQP_TYPE_STRING:
-            result = encode_string(encoder_output, context, value_data->value.string_value.chars);
-            break;
+/* UTF-8 as per RFC 3629: no overlong encodings, no surrogates and nothing above U+10FFFF */
+static bool is_valid_utf8(const unsigned char* bytes, size_t length)
+{
+    bool result = true;
+    size_t i = 0;
 
-        case AMQP_TYPE_SYMBOL:
-            result = encode_symbol(encoder_output, context, value_data->value.symbol_value.chars);
-            break;
+    while (i < length)
+    {
+        i += get_ascii_prefix_length(bytes + i, length - i);
+        if (i < length)
+        {
+            unsigned char lead_byte = bytes[i];
+            unsigned char min_second_byte = 0x80;
+            unsigned char max_second_byte = 0xBF;
+            size_t sequence_length;
+            size_t j;
 
-        case AMQP_TYPE_LIST:
-            result = encode_list(encoder_output, context, value_data->value.list_value.count, value_data->value.list_value.items);
-            break;
+            if ((lead_byte >= 0xC2) && (lead_byte <= 0xDF))
+            {
+                sequence_length = 2;
+            }
+            else if (lead_byte == 0xE0)
+            {
+                sequence_length = 3;
+                min_second_byte = 0xA0;
+            }
+            else if (lead_byte == 0xED)
+            {
+                sequence_length = 3;
+                max_second_byte = 0x9F;
+            }
+            else if ((lead_byte >= 0xE1) && (lead_byte <= 0xEF))
+            {
+                sequence_length = 3;
+            }
+            else if (lead_byte == 0xF0)
+            {
+                sequence_length = 4;
+                min_second_byte = 0x90;
+            }
+            else if ((lead_byte >= 0xF1) && (lead_byte <= 0xF3))
+            {
+                sequence_length = 4;
+            }
+            else if (lead_byte == 0xF4)
+            {
+                sequence_length = 4;
+                max_second_byte = 0x8F;
+            }
+            else
+            {
+                sequence_length = 0;
+            }
 
-        case AMQP_TYPE_MAP:
-            result = encode_map(encoder_output, context, value_data->value.map_value.pair_count, value_data->value.map_value.pairs);
-            break;
+            if ((sequence_length == 0) ||
+                (length - i < sequence_length) ||
+                (bytes[i + 1] < min_second_byte) ||
+                (bytes[i + 1] > max_second_byte))
+            {
+                result = false;
+                break;
+            }
 
-        case AMQP_TYPE_COMPOSITE:
-        case AMQP_TYPE_DESCRIBED:
-        {
-            if ((encode_descriptor_header(encoder_output, context) != 0) ||
-                (amqpvalue_encode(value_data->value.described_value.descriptor, encoder_output, context) != 0) ||
-                (amqpvalue_encode(value_data->value.described_value.value, encoder_output, context) != 0))
+            for (j = 2; j < sequence_length; j++)
             {
-                LogError("Failed encoding described or composite type");
-                result = __FAILURE__;
+                if ((bytes[i + j] & 0xC0) != 0x80)
+                {
+                    break;
+                }
             }
-            else
+
+            if (j < sequence_length)
             {
-                result = 0;
+                result = false;
+                break;
             }
 
-            break;
-        }
+            i += sequence_length;
         }
     }
 
     return result;
 }
 
-static int count_bytes(void* context, const unsigned char* bytes, size_t length)
+static int validate_decoded_chars(INTERNAL_DECODER_DATA* internal_decoder_data, const unsigned char* bytes, size_t length, bool is_symbol)
 {
-    size_t* byte_count;
-    (void)bytes;
+    int result;
 
-    byte_count = (size_t*)context;
-    *byte_count += length;
+    if (!internal_decoder_data->validate_strings)
+    {
+        result = 0;
+    }
+    /* Codes_SRS_AMQPVALUE_01_478: [ When string validation is enabled, a decoded symbol that contains characters that are not 7-bit ASCII shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+    else if (is_symbol && (get_ascii_prefix_length(bytes, length) != length))
+    {
+        internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+        LogError("Decoded symbol is not 7-bit ASCII");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQPVALUE_01_477: [ When string validation is enabled, a decoded string that is not valid UTF-8 shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+    else if (!is_symbol && !is_valid_utf8(bytes, length))
+    {
+        internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+        LogError("Decoded string is not valid UTF-8");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
 
-    return 0;
+    return result;
 }
 
-int amqpvalue_get_encoded_size(AMQP_VALUE value, size_t* encoded_size)
+static int decode_chars_from_span(INTERNAL_DECODER_DATA* internal_decoder_data, char** chars, uint32_t* chars_length, char* inline_chars, const unsigned char* bytes, uint32_t length)
 {
     int result;
 
-    /* Codes_SRS_AMQPVALUE_01_309: [If any argument is NULL, amqpvalue_get_encoded_size shall return a non-zero value.] */
-    if ((value == NULL) ||
-        (encoded_size == NULL))
+    *chars = decoder_allocate_chars(internal_decoder_data, inline_chars, length);
+    if (*chars == NULL)
     {
-        LogError("Bad arguments: value = %p, encoded_size = %p",
-            value, encoded_size);
+        /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+        internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+        LogError("Could not allocate memory for decoded string/symbol value");
         result = __FAILURE__;
     }
     else
     {
-        *encoded_size = 0;
-        result = amqpvalue_encode(value, count_bytes, encoded_size);
+        (void)memcpy(*chars, bytes, length);
+        (*chars)[length] = '\0';
+        *chars_length = length;
+        complete_value_decode(internal_decoder_data);
+        result = 0;
     }
 
     return result;
 }
 
-static void amqpvalue_clear(AMQP_VALUE_DATA* value_data)
+static int decode_symbol_from_span(INTERNAL_DECODER_DATA* internal_decoder_data, const unsigned char* bytes, uint32_t length)
 {
-    switch (value_data->type)
-    {
-    default:
-        break;
+    int result;
+    const char* interned_symbol = find_interned_symbol((const char*)bytes, length);
 
-    case AMQP_TYPE_BINARY:
-        if (value_data->value.binary_value.bytes != NULL)
-        {
-            free((void*)value_data->value.binary_value.bytes);
-        }
-        break;
-    case AMQP_TYPE_STRING:
-        if (value_data->value.string_value.chars != NULL)
-        {
-            free(value_data->value.string_value.chars);
-        }
-        break;
-    case AMQP_TYPE_SYMBOL:
-        if (value_data->value.symbol_value.chars != NULL)
-        {
-            free(value_data->value.symbol_value.chars);
-        }
-        break;
-    case AMQP_TYPE_LIST:
+    if (interned_symbol != NULL)
     {
-        size_t i;
-        for (i = 0; i < value_data->value.list_value.count; i++)
-        {
-            amqpvalue_destroy(value_data->value.list_value.items[i]);
-        }
-
-        free(value_data->value.list_value.items);
-        value_data->value.list_value.items = NULL;
-        break;
+        /* Codes_SRS_AMQPVALUE_01_458: [ A decoded symbol that is one of the well-known symbols in the interned symbol table shall point to the table entry instead of copying the characters. ]*/
+        internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)interned_symbol;
+        internal_decoder_data->decode_to_value->value.symbol_value.length = length;
+        internal_decoder_data->decode_to_value->is_interned = true;
+        complete_value_decode(internal_decoder_data);
+        result = 0;
     }
-    case AMQP_TYPE_MAP:
+    else if (validate_decoded_chars(internal_decoder_data, bytes, length, true) != 0)
     {
-        size_t i;
-        for (i = 0; i < value_data->value.map_value.pair_count; i++)
-        {
-            amqpvalue_destroy(value_data->value.map_value.pairs[i].key);
-            amqpvalue_destroy(value_data->value.map_value.pairs[i].value);
-        }
-
-        free(value_data->value.map_value.pairs);
-        value_data->value.map_value.pairs = NULL;
-        break;
+        result = __FAILURE__;
     }
-    case AMQP_TYPE_ARRAY:
+    else
     {
-        size_t i;
-        for (i = 0; i < value_data->value.array_value.count; i++)
-        {
-            amqpvalue_destroy(value_data->value.array_value.items[i]);
-        }
-
-        free(value_data->value.array_value.items);
-        value_data->value.array_value.items = NULL;
-        break;
-    }
-    case AMQP_TYPE_COMPOSITE:
-    case AMQP_TYPE_DESCRIBED:
-        amqpvalue_destroy(value_data->value.described_value.descriptor);
-        amqpvalue_destroy(value_data->value.described_value.value);
-        break;
+        result = decode_chars_from_span(internal_decoder_data, &internal_decoder_data->decode_to_value->value.symbol_value.chars, &internal_decoder_data->decode_to_value->value.symbol_value.length, internal_decoder_data->decode_to_value->value.symbol_value.inline_chars, bytes, length);
     }
 
-    value_data->type = AMQP_TYPE_UNKNOWN;
+    return result;
 }
 
-void amqpvalue_destroy(AMQP_VALUE value)
+static int decode_binary_from_span(INTERNAL_DECODER_DATA* internal_decoder_data, const unsigned char* bytes, uint32_t length, size_t allocation_size)
 {
-    /* Codes_SRS_AMQPVALUE_01_315: [If the value argument is NULL, amqpvalue_destroy shall do nothing.] */
-    if (value == NULL)
+    int result;
+
+    internal_decoder_data->decode_to_value->value.binary_value.length = length;
+    if (length == 0)
     {
-        LogError("NULL value");
+        internal_decoder_data->decode_to_value->value.binary_value.bytes = NULL;
+        complete_value_decode(internal_decoder_data);
+        result = 0;
+    }
+    else if (internal_decoder_data->borrow_binaries)
+    {
+        /* Codes_SRS_AMQPVALUE_01_427: [ When borrowing binaries is enabled and all the bytes of a binary value are in the buffer passed to amqpvalue_decode_bytes, the decoded binary value shall point to those bytes instead of copying them. ]*/
+        internal_decoder_data->decode_to_value->value.binary_value.bytes = bytes;
+        internal_decoder_data->decode_to_value->is_borrowed = true;
+        complete_value_decode(internal_decoder_data);
+        result = 0;
     }
     else
     {
-        if (DEC_REF(AMQP_VALUE_DATA, value) == DEC_RETURN_ZERO)
+        unsigned char* binary_bytes = (unsigned char*)decoder_malloc(internal_decoder_data, allocation_size);
+        if (binary_bytes == NULL)
+        {
+            /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+            internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+            LogError("Cannot allocate memory for decoded binary value");
+            result = __FAILURE__;
+        }
+        else
         {
-            /* Codes_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-            AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
-            amqpvalue_clear(value_data);
-            free(value);
+            (void)memcpy(binary_bytes, bytes, length);
+            internal_decoder_data->decode_to_value->value.binary_value.bytes = binary_bytes;
+            complete_value_decode(internal_decoder_data);
+            result = 0;
         }
     }
+
+    return result;
 }
 
-static INTERNAL_DECODER_DATA* internal_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context, AMQP_VALUE_DATA* value_data, bool is_internal)
+/* every member of the value union starts at its beginning and the fixed width types of 2 bytes and more are exactly as wide as
+   their encoding, so the bits are stored the same way whatever the type */
+static void read_fixed_value_from_span(AMQP_VALUE_UNION* value, const unsigned char* bytes, size_t byte_count)
 {
-    INTERNAL_DECODER_DATA* internal_decoder_data = (INTERNAL_DECODER_DATA*)malloc(sizeof(INTERNAL_DECODER_DATA));
-    if (internal_decoder_data == NULL)
+    if (byte_count == 2)
     {
-        LogError("Cannot allocate memory for internal decoder structure");
+        uint16_t bits = read_uint16_from_span(bytes);
+        (void)memcpy(value, &bits, sizeof(bits));
+    }
+    else if (byte_count == 4)
+    {
+        uint32_t bits = read_uint32_from_span(bytes);
+        (void)memcpy(value, &bits, sizeof(bits));
+    }
+    else if (byte_count == 8)
+    {
+        uint64_t bits = read_uint64_from_span(bytes);
+        (void)memcpy(value, &bits, sizeof(bits));
     }
     else
     {
-        internal_decoder_data->is_internal = is_internal;
-        internal_decoder_data->on_value_decoded = on_value_decoded;
-        internal_decoder_data->on_value_decoded_context = callback_context;
-        internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
-        internal_decoder_data->inner_decoder = NULL;
-        internal_decoder_data->decode_to_value = value_data;
+        /* uuid */
+        (void)memcpy(value, bytes, byte_count);
     }
-
-    return internal_decoder_data;
 }
 
-static void internal_decoder_destroy(INTERNAL_DECODER_DATA* internal_decoder)
+/* Fast path for the type data of a value: when the complete encoding of a fixed width or variable width value (or the size/count
+   header of a compound value) is already contiguous in the buffer it is decoded directly from the span instead of being fed
+   byte by byte through the state machine. span_used_bytes is set to 0 when the span is too short, in which case the incremental
+   decoding takes over. */
+static int decode_type_data_from_span(INTERNAL_DECODER_DATA* internal_decoder_data, const unsigned char* buffer, size_t size, size_t* span_used_bytes)
 {
-    if (internal_decoder != NULL)
+    int result = 0;
+    AMQP_VALUE_DATA* value_data = internal_decoder_data->decode_to_value;
+
+    *span_used_bytes = 0;
+
+    if (internal_decoder_data->bytes_decoded == 0)
     {
-        internal_decoder_destroy(internal_decoder->inner_decoder);
-        free(internal_decoder);
+        const CONSTRUCTOR_INFO* constructor_info = &constructor_infos[internal_decoder_data->constructor_byte];
+
+        /* 1 byte values are left to the incremental decoding, which widens them and checks booleans */
+        if ((constructor_info->constructor_class == CONSTRUCTOR_CLASS_FIXED) &&
+            (constructor_info->fixed_byte_count >= 2))
+        {
+            if (size >= constructor_info->fixed_byte_count)
+            {
+                read_fixed_value_from_span(&value_data->value, buffer, constructor_info->fixed_byte_count);
+                *span_used_bytes = constructor_info->fixed_byte_count;
+                complete_value_decode(internal_decoder_data);
+            }
+        }
+        else if (constructor_info->constructor_class == CONSTRUCTOR_CLASS_VARIABLE)
+        {
+            size_t size_prefix_length = constructor_info->size_prefix_length;
+
+            if (size >= size_prefix_length)
+            {
+                uint32_t length = (size_prefix_length == 1) ? buffer[0] : read_uint32_from_span(buffer);
+                if (size - size_prefix_length >= length)
+                {
+                    const unsigned char* bytes = buffer + size_prefix_length;
+
+                    *span_used_bytes = size_prefix_length + (size_t)length;
+                    if (constructor_info->type == AMQP_TYPE_BINARY)
+                    {
+                        /* allocated as the incremental decoding does, with one more byte for a vbin32 */
+                        result = decode_binary_from_span(internal_decoder_data, bytes, length, (size_prefix_length == 1) ? (size_t)length : (size_t)length + 1);
+                    }
+                    else if (constructor_info->type == AMQP_TYPE_SYMBOL)
+                    {
+                        result = decode_symbol_from_span(internal_decoder_data, bytes, length);
+                    }
+                    else if (validate_decoded_chars(internal_decoder_data, bytes, length, false) != 0)
+                    {
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        result = decode_chars_from_span(internal_decoder_data, &value_data->value.string_value.chars, &value_data->value.string_value.length, value_data->value.string_value.inline_chars, bytes, length);
+                    }
+                }
+            }
+        }
+        else switch (internal_decoder_data->constructor_byte)
+        {
+        default:
+            break;
+
+        /* for compound values only the size and count are taken from the span, the items still go through inner decoders */
+        case 0xC0:
+            if ((internal_decoder_data->decode_value_state.list_value_state.list_value_state == DECODE_LIST_STEP_SIZE) &&
+                (size >= 2))
+            {
+                bool is_lazy = false;
+                value_data->value.list_value.count = buffer[1];
+                if ((buffer[0] >= 1) &&
+                    (size - 1 >= buffer[0]))
+                {
+                    result = decode_lazy_list_from_span(internal_decoder_data, buffer + 2, buffer[0] - 1, &is_lazy);
+                }
+
+                if (is_lazy)
+                {
+                    *span_used_bytes = 1 + (size_t)buffer[0];
+                }
+                else if (result == 0)
+                {
+                    *span_used_bytes = 2;
+                    result = start_decoding_list_items(internal_decoder_data);
+                }
+            }
+            break;
+
+        case 0xD0:
+            if ((internal_decoder_data->decode_value_state.list_value_state.list_value_state == DECODE_LIST_STEP_SIZE) &&
+                (size >= 8))
+            {
+                bool is_lazy = false;
+                uint32_t list_size = read_uint32_from_span(buffer);
+                value_data->value.list_value.count = read_uint32_from_span(buffer + 4);
+                if ((list_size >= 4) &&
+                    (size - 4 >= list_size))
+                {
+                    result = decode_lazy_list_from_span(internal_decoder_data, buffer + 8, list_size - 4, &is_lazy);
+                }
+
+                if (is_lazy)
+                {
+                    *span_used_bytes = 4 + (size_t)list_size;
+                }
+                else if (result == 0)
+                {
+                    *span_used_bytes = 8;
+                    result = start_decoding_list_items(internal_decoder_data);
+                }
+            }
+            break;
+
+        case 0xC1:
+            if ((internal_decoder_data->decode_value_state.map_value_state.map_value_state == DECODE_MAP_STEP_SIZE) &&
+                (size >= 2))
+            {
+                value_data->value.map_value.pair_count = buffer[1];
+                *span_used_bytes = 2;
+                result = start_decoding_map_pairs(internal_decoder_data);
+            }
+            break;
+
+        case 0xD1:
+            if ((internal_decoder_data->decode_value_state.map_value_state.map_value_state == DECODE_MAP_STEP_SIZE) &&
+                (size >= 8))
+            {
+                value_data->value.map_value.pair_count = read_uint32_from_span(buffer + 4);
+                *span_used_bytes = 8;
+                result = start_decoding_map_pairs(internal_decoder_data);
+            }
+            break;
+
+        case 0xE0:
+            if ((internal_decoder_data->decode_value_state.array_value_state.array_value_state == DECODE_ARRAY_STEP_SIZE) &&
+                (size >= 2))
+            {
+                bool is_packed = false;
+
+                value_data->value.array_value.count = buffer[1];
+                /* size covers the count, the item constructor and the items */
+                if ((buffer[0] >= 2) &&
+                    (size - 1 >= buffer[0]))
+                {
+                    result = decode_packed_array_from_span(internal_decoder_data, buffer[2], buffer + 3, (uint32_t)buffer[0] - 2, &is_packed);
+                }
+
+                if (is_packed)
+                {
+                    *span_used_bytes = 1 + (size_t)buffer[0];
+                }
+                else if (result == 0)
+                {
+                    *span_used_bytes = 2;
+                    result = start_decoding_array_items(internal_decoder_data);
+                }
+            }
+            break;
+
+        case 0xF0:
+            if ((internal_decoder_data->decode_value_state.array_value_state.array_value_state == DECODE_ARRAY_STEP_SIZE) &&
+                (size >= 8))
+            {
+                bool is_packed = false;
+                uint32_t array_size = read_uint32_from_span(buffer);
+
+                value_data->value.array_value.count = read_uint32_from_span(buffer + 4);
+                if ((array_size >= 5) &&
+                    (size - 4 >= array_size))
+                {
+                    result = decode_packed_array_from_span(internal_decoder_data, buffer[8], buffer + 9, array_size - 5, &is_packed);
+                }
+
+                if (is_packed)
+                {
+                    *span_used_bytes = 4 + (size_t)array_size;
+                }
+                else if (result == 0)
+                {
+                    *span_used_bytes = 8;
+                    result = start_decoding_array_items(internal_decoder_data);
+                }
+            }
+            break;
+        }
     }
-}
 
-static void inner_decoder_callback(void* context, AMQP_VALUE decoded_value)
-{
-    /* API issue: the decoded_value should be removed completely:
-    TODO: uAMQP: inner_decoder_callback in amqpvalue.c could probably do without the decoded_value ... */
-    INTERNAL_DECODER_DATA* internal_decoder_data = (INTERNAL_DECODER_DATA*)context;
-    INTERNAL_DECODER_DATA* inner_decoder = (INTERNAL_DECODER_DATA*)internal_decoder_data->inner_decoder;
-    (void)decoded_value;
-    inner_decoder->decoder_state = DECODER_STATE_DONE;
+    return result;
 }
 
 static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data, const unsigned char* buffer, size_t size, size_t* used_bytes)
@@ -3378,15 +8529,27 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
             case DECODER_STATE_CONSTRUCTOR:
             {
+                if ((internal_decoder_data->limits != NULL) && (!internal_decoder_data->is_internal))
+                {
+                    /* Codes_SRS_AMQPVALUE_01_526: [ The element count and the allocated bytes shall be counted separately for each top level value decoded. ]*/
+                    internal_decoder_data->limits->element_count = 0;
+                    internal_decoder_data->limits->allocated_bytes = 0;
+                }
+
                 if ((internal_decoder_data->decode_to_value != NULL) && (!internal_decoder_data->is_internal))
                 {
-                    amqpvalue_destroy(internal_decoder_data->decode_to_value);
+                    /* a previously decoded arena value belongs to the arena (which might have been reset already) */
+                    if (internal_decoder_data->arena == NULL)
+                    {
+                        amqpvalue_destroy(internal_decoder_data->decode_to_value);
+                    }
+
                     internal_decoder_data->decode_to_value = NULL;
                 }
 
                 if (internal_decoder_data->decode_to_value == NULL)
                 {
-                    internal_decoder_data->decode_to_value = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+                    internal_decoder_data->decode_to_value = decoder_create_value_data(internal_decoder_data);
                 }
 
                 if (internal_decoder_data->decode_to_value == NULL)
@@ -3412,7 +8575,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                 {
                     AMQP_VALUE_DATA* descriptor;
                     internal_decoder_data->decode_to_value->type = AMQP_TYPE_DESCRIBED;
-                    descriptor = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+                    descriptor = decoder_create_value_data(internal_decoder_data);
                     if (descriptor == NULL)
                     {
                         internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -3423,7 +8586,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                     {
                         descriptor->type = AMQP_TYPE_UNKNOWN;
                         internal_decoder_data->decode_to_value->value.described_value.descriptor = descriptor;
-                        internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, descriptor, true);
+                        internal_decoder_data->inner_decoder = inner_decoder_create(internal_decoder_data, descriptor);
                         if (internal_decoder_data->inner_decoder == NULL)
                         {
                             internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -3746,6 +8909,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                     internal_decoder_data->decode_to_value->type = AMQP_TYPE_STRING;
                     internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
                     internal_decoder_data->decode_to_value->value.string_value.chars = NULL;
+                    internal_decoder_data->decode_to_value->value.string_value.length = 0;
                     internal_decoder_data->decode_value_state.string_value_state.length = 0;
                     internal_decoder_data->bytes_decoded = 0;
 
@@ -3762,6 +8926,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                     internal_decoder_data->decode_to_value->type = AMQP_TYPE_SYMBOL;
                     internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
                     internal_decoder_data->decode_to_value->value.symbol_value.chars = NULL;
+                    internal_decoder_data->decode_to_value->value.symbol_value.length = 0;
                     internal_decoder_data->decode_value_state.symbol_value_state.length = 0;
                     internal_decoder_data->bytes_decoded = 0;
 
@@ -3776,6 +8941,8 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                     internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
                     internal_decoder_data->decode_to_value->value.list_value.count = 0;
                     internal_decoder_data->decode_to_value->value.list_value.items = NULL;
+                    internal_decoder_data->decode_to_value->value.list_value.capacity = 0;
+                    internal_decoder_data->decode_to_value->value.list_value.lazy_items = NULL;
 
                     /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
                     /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
@@ -3791,6 +8958,8 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                     internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
                     internal_decoder_data->decode_to_value->value.list_value.count = 0;
                     internal_decoder_data->decode_to_value->value.list_value.items = NULL;
+                    internal_decoder_data->decode_to_value->value.list_value.capacity = 0;
+                    internal_decoder_data->decode_to_value->value.list_value.lazy_items = NULL;
                     internal_decoder_data->bytes_decoded = 0;
                     internal_decoder_data->decode_value_state.list_value_state.list_value_state = DECODE_LIST_STEP_SIZE;
 
@@ -3804,6 +8973,9 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                     internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
                     internal_decoder_data->decode_to_value->value.map_value.pair_count = 0;
                     internal_decoder_data->decode_to_value->value.map_value.pairs = NULL;
+                    internal_decoder_data->decode_to_value->value.map_value.capacity = 0;
+                    internal_decoder_data->decode_to_value->value.map_value.index = NULL;
+                    internal_decoder_data->decode_to_value->value.map_value.index_size = 0;
                     internal_decoder_data->bytes_decoded = 0;
                     internal_decoder_data->decode_value_state.map_value_state.map_value_state = DECODE_MAP_STEP_SIZE;
 
@@ -3816,6 +8988,9 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                     internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
                     internal_decoder_data->decode_to_value->value.array_value.count = 0;
                     internal_decoder_data->decode_to_value->value.array_value.items = NULL;
+                    internal_decoder_data->decode_to_value->value.array_value.capacity = 0;
+                    internal_decoder_data->decode_to_value->value.array_value.packed_item_type = AMQP_TYPE_UNKNOWN;
+                    internal_decoder_data->decode_to_value->value.array_value.packed_items = NULL;
                     internal_decoder_data->bytes_decoded = 0;
                     internal_decoder_data->decode_value_state.array_value_state.array_value_state = DECODE_ARRAY_STEP_SIZE;
 
@@ -3827,6 +9002,23 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
             case DECODER_STATE_TYPE_DATA:
             {
+                size_t span_used_bytes;
+
+                if (decode_type_data_from_span(internal_decoder_data, buffer, size, &span_used_bytes) != 0)
+                {
+                    LogError("Decoding value data from buffer failed");
+                    result = __FAILURE__;
+                    break;
+                }
+
+                if (span_used_bytes > 0)
+                {
+                    buffer += span_used_bytes;
+                    size -= span_used_bytes;
+                    result = 0;
+                    break;
+                }
+
                 switch (internal_decoder_data->constructor_byte)
                 {
                 default:
@@ -3861,9 +9053,9 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                             if (inner_decoder->decoder_state == DECODER_STATE_DONE)
                             {
                                 AMQP_VALUE described_value;
-                                internal_decoder_destroy(inner_decoder);
+                                inner_decoder_release(internal_decoder_data, inner_decoder);
 
-                                described_value = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+                                described_value = decoder_create_value_data(internal_decoder_data);
                                 if (described_value == NULL)
                                 {
                                     internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -3874,7 +9066,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                                 {
                                     described_value->type = AMQP_TYPE_UNKNOWN;
                                     internal_decoder_data->decode_to_value->value.described_value.value = (AMQP_VALUE)described_value;
-                                    internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, described_value, true);
+                                    internal_decoder_data->inner_decoder = inner_decoder_create(internal_decoder_data, described_value);
                                     if (internal_decoder_data->inner_decoder == NULL)
                                     {
                                         internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -3911,7 +9103,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                             if (inner_decoder->decoder_state == DECODER_STATE_DONE)
                             {
-                                internal_decoder_destroy(inner_decoder);
+                                inner_decoder_release(internal_decoder_data, inner_decoder);
                                 internal_decoder_data->inner_decoder = NULL;
 
                                 internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
@@ -4286,7 +9478,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                         }
                         else
                         {
-                            internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)malloc(internal_decoder_data->decode_to_value->value.binary_value.length);
+                            internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)decoder_malloc(internal_decoder_data, internal_decoder_data->decode_to_value->value.binary_value.length);
                             if (internal_decoder_data->decode_to_value->value.binary_value.bytes == NULL)
                             {
                                 /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
@@ -4353,7 +9545,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                             }
                             else
                             {
-                                internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)malloc(internal_decoder_data->decode_to_value->value.binary_value.length + 1);
+                                internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)decoder_malloc(internal_decoder_data, internal_decoder_data->decode_to_value->value.binary_value.length + 1);
                                 if (internal_decoder_data->decode_to_value->value.binary_value.bytes == NULL)
                                 {
                                     /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
@@ -4406,7 +9598,8 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                         buffer++;
                         size--;
 
-                        internal_decoder_data->decode_to_value->value.string_value.chars = (char*)malloc(internal_decoder_data->decode_value_state.string_value_state.length + 1);
+                        internal_decoder_data->decode_to_value->value.string_value.length = internal_decoder_data->decode_value_state.string_value_state.length;
+                        internal_decoder_data->decode_to_value->value.string_value.chars = decoder_allocate_chars(internal_decoder_data, internal_decoder_data->decode_to_value->value.string_value.inline_chars, internal_decoder_data->decode_value_state.string_value_state.length);
                         if (internal_decoder_data->decode_to_value->value.string_value.chars == NULL)
                         {
                             /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
@@ -4444,16 +9637,27 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == internal_decoder_data->decode_value_state.string_value_state.length + 1)
                         {
-                            internal_decoder_data->decode_to_value->value.string_value.chars[internal_decoder_data->decode_value_state.string_value_state.length] = 0;
-                            internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+                            if (validate_decoded_chars(internal_decoder_data, (const unsigned char*)internal_decoder_data->decode_to_value->value.string_value.chars, internal_decoder_data->decode_value_state.string_value_state.length, false) != 0)
+                            {
+                                result = __FAILURE__;
+                            }
+                            else
+                            {
+                                internal_decoder_data->decode_to_value->value.string_value.chars[internal_decoder_data->decode_value_state.string_value_state.length] = 0;
+                                internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
 
-                            /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-                            /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-                            /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-                            internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                        }
+                                /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+                                /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+                                /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+                                internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
 
-                        result = 0;
+                                result = 0;
+                            }
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
                     }
                     break;
                 }
@@ -4469,7 +9673,8 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == 4)
                         {
-                            internal_decoder_data->decode_to_value->value.string_value.chars = (char*)malloc(internal_decoder_data->decode_value_state.string_value_state.length + 1);
+                            internal_decoder_data->decode_to_value->value.string_value.length = internal_decoder_data->decode_value_state.string_value_state.length;
+                            internal_decoder_data->decode_to_value->value.string_value.chars = decoder_allocate_chars(internal_decoder_data, internal_decoder_data->decode_to_value->value.string_value.inline_chars, internal_decoder_data->decode_value_state.string_value_state.length);
                             if (internal_decoder_data->decode_to_value->value.string_value.chars == NULL)
                             {
                                 /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
@@ -4512,16 +9717,27 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == internal_decoder_data->decode_value_state.string_value_state.length + 4)
                         {
-                            internal_decoder_data->decode_to_value->value.string_value.chars[internal_decoder_data->decode_value_state.string_value_state.length] = '\0';
-                            internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+                            if (validate_decoded_chars(internal_decoder_data, (const unsigned char*)internal_decoder_data->decode_to_value->value.string_value.chars, internal_decoder_data->decode_value_state.string_value_state.length, false) != 0)
+                            {
+                                result = __FAILURE__;
+                            }
+                            else
+                            {
+                                internal_decoder_data->decode_to_value->value.string_value.chars[internal_decoder_data->decode_value_state.string_value_state.length] = '\0';
+                                internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
 
-                            /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-                            /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-                            /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-                            internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                        }
+                                /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+                                /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+                                /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+                                internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
 
-                        result = 0;
+                                result = 0;
+                            }
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
                     }
                     break;
                 }
@@ -4535,7 +9751,8 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                         buffer++;
                         size--;
 
-                        internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)malloc(internal_decoder_data->decode_value_state.symbol_value_state.length + 1);
+                        internal_decoder_data->decode_to_value->value.symbol_value.length = internal_decoder_data->decode_value_state.symbol_value_state.length;
+                        internal_decoder_data->decode_to_value->value.symbol_value.chars = decoder_allocate_chars(internal_decoder_data, internal_decoder_data->decode_to_value->value.symbol_value.inline_chars, internal_decoder_data->decode_value_state.symbol_value_state.length);
                         if (internal_decoder_data->decode_to_value->value.symbol_value.chars == NULL)
                         {
                             /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
@@ -4573,16 +9790,27 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == internal_decoder_data->decode_value_state.symbol_value_state.length + 1)
                         {
-                            internal_decoder_data->decode_to_value->value.symbol_value.chars[internal_decoder_data->decode_value_state.symbol_value_state.length] = 0;
-                            internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+                            if (validate_decoded_chars(internal_decoder_data, (const unsigned char*)internal_decoder_data->decode_to_value->value.symbol_value.chars, internal_decoder_data->decode_value_state.symbol_value_state.length, true) != 0)
+                            {
+                                result = __FAILURE__;
+                            }
+                            else
+                            {
+                                internal_decoder_data->decode_to_value->value.symbol_value.chars[internal_decoder_data->decode_value_state.symbol_value_state.length] = 0;
+                                internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
 
-                            /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-                            /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-                            /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-                            internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                        }
+                                /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+                                /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+                                /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+                                internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
 
-                        result = 0;
+                                result = 0;
+                            }
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
                     }
                     break;
                 }
@@ -4598,7 +9826,8 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == 4)
                         {
-                            internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)malloc(internal_decoder_data->decode_value_state.symbol_value_state.length + 1);
+                            internal_decoder_data->decode_to_value->value.symbol_value.length = internal_decoder_data->decode_value_state.symbol_value_state.length;
+                            internal_decoder_data->decode_to_value->value.symbol_value.chars = decoder_allocate_chars(internal_decoder_data, internal_decoder_data->decode_to_value->value.symbol_value.inline_chars, internal_decoder_data->decode_value_state.symbol_value_state.length);
                             if (internal_decoder_data->decode_to_value->value.symbol_value.chars == NULL)
                             {
                                 /* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
@@ -4641,16 +9870,27 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == internal_decoder_data->decode_value_state.symbol_value_state.length + 4)
                         {
-                            internal_decoder_data->decode_to_value->value.symbol_value.chars[internal_decoder_data->decode_value_state.symbol_value_state.length] = '\0';
-                            internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+                            if (validate_decoded_chars(internal_decoder_data, (const unsigned char*)internal_decoder_data->decode_to_value->value.symbol_value.chars, internal_decoder_data->decode_value_state.symbol_value_state.length, true) != 0)
+                            {
+                                result = __FAILURE__;
+                            }
+                            else
+                            {
+                                internal_decoder_data->decode_to_value->value.symbol_value.chars[internal_decoder_data->decode_value_state.symbol_value_state.length] = '\0';
+                                internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
 
-                            /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-                            /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-                            /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-                            internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                        }
+                                /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+                                /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+                                /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+                                internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
 
-                        result = 0;
+                                result = 0;
+                            }
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
                     }
                     break;
                 }
@@ -4706,82 +9946,17 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         internal_decoder_data->bytes_decoded++;
                         buffer++;
-                        size--;
-
-                        if (internal_decoder_data->constructor_byte == 0xC0)
-                        {
-                            if (internal_decoder_data->decode_to_value->value.list_value.count == 0)
-                            {
-                                internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
-
-                                /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-                                /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-                                /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-                                internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                                result = 0;
-                            }
-                            else
-                            {
-                                uint32_t i;
-                                internal_decoder_data->decode_to_value->value.list_value.items = (AMQP_VALUE*)malloc(sizeof(AMQP_VALUE) * internal_decoder_data->decode_to_value->value.list_value.count);
-                                if (internal_decoder_data->decode_to_value->value.list_value.items == NULL)
-                                {
-                                    LogError("Could not allocate memory for decoded list value");
-                                    result = __FAILURE__;
-                                }
-                                else
-                                {
-                                    for (i = 0; i < internal_decoder_data->decode_to_value->value.list_value.count; i++)
-                                    {
-                                        internal_decoder_data->decode_to_value->value.list_value.items[i] = NULL;
-                                    }
+                        size--;
 
-                                    internal_decoder_data->decode_value_state.list_value_state.list_value_state = DECODE_LIST_STEP_ITEMS;
-                                    internal_decoder_data->bytes_decoded = 0;
-                                    internal_decoder_data->inner_decoder = NULL;
-                                    internal_decoder_data->decode_value_state.list_value_state.item = 0;
-                                    result = 0;
-                                }
-                            }
+                        if (internal_decoder_data->constructor_byte == 0xC0)
+                        {
+                            result = start_decoding_list_items(internal_decoder_data);
                         }
                         else
                         {
                             if (internal_decoder_data->bytes_decoded == 4)
                             {
-                                if (internal_decoder_data->decode_to_value->value.list_value.count == 0)
-                                {
-                                    internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
-
-                                    /* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-                                    /* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-                                    /* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-                                    internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                                    result = 0;
-                                }
-                                else
-                                {
-                                    uint32_t i;
-
-                                    internal_decoder_data->decode_to_value->value.list_value.items = (AMQP_VALUE*)malloc(sizeof(AMQP_VALUE) * internal_decoder_data->decode_to_value->value.list_value.count);
-                                    if (internal_decoder_data->decode_to_value->value.list_value.items == NULL)
-                                    {
-                                        LogError("Could not allocate memory for decoded list value");
-                                        result = __FAILURE__;
-                                    }
-                                    else
-                                    {
-                                        for (i = 0; i < internal_decoder_data->decode_to_value->value.list_value.count; i++)
-                                        {
-                                            internal_decoder_data->decode_to_value->value.list_value.items[i] = NULL;
-                                        }
-
-                                        internal_decoder_data->decode_value_state.list_value_state.list_value_state = DECODE_LIST_STEP_ITEMS;
-                                        internal_decoder_data->bytes_decoded = 0;
-                                        internal_decoder_data->inner_decoder = NULL;
-                                        internal_decoder_data->decode_value_state.list_value_state.item = 0;
-                                        result = 0;
-                                    }
-                                }
+                                result = start_decoding_list_items(internal_decoder_data);
                             }
                             else
                             {
@@ -4796,7 +9971,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == 0)
                         {
-                            AMQP_VALUE_DATA* list_item = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+                            AMQP_VALUE_DATA* list_item = decoder_create_value_data(internal_decoder_data);
                             if (list_item == NULL)
                             {
                                 internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -4806,7 +9981,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                             {
                                 list_item->type = AMQP_TYPE_UNKNOWN;
                                 internal_decoder_data->decode_to_value->value.list_value.items[internal_decoder_data->decode_value_state.list_value_state.item] = list_item;
-                                internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, list_item, true);
+                                internal_decoder_data->inner_decoder = inner_decoder_create(internal_decoder_data, list_item);
                                 if (internal_decoder_data->inner_decoder == NULL)
                                 {
                                     LogError("Could not create inner decoder for list items");
@@ -4839,7 +10014,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                             if (inner_decoder->decoder_state == DECODER_STATE_DONE)
                             {
-                                internal_decoder_destroy(inner_decoder);
+                                inner_decoder_release(internal_decoder_data, inner_decoder);
                                 internal_decoder_data->inner_decoder = NULL;
                                 internal_decoder_data->bytes_decoded = 0;
 
@@ -4917,79 +10092,13 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->constructor_byte == 0xC1)
                         {
-                            if (internal_decoder_data->decode_to_value->value.map_value.pair_count == 0)
-                            {
-                                internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
-
-                                internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                                result = 0;
-                            }
-                            else
-                            {
-                                uint32_t i;
-
-                                internal_decoder_data->decode_to_value->value.map_value.pair_count /= 2;
-
-                                internal_decoder_data->decode_to_value->value.map_value.pairs = (AMQP_MAP_KEY_VALUE_PAIR*)malloc(sizeof(AMQP_MAP_KEY_VALUE_PAIR) * (internal_decoder_data->decode_to_value->value.map_value.pair_count * 2));
-                                if (internal_decoder_data->decode_to_value->value.map_value.pairs == NULL)
-                                {
-                                    LogError("Could not allocate memory for map value items");
-                                    result = __FAILURE__;
-                                }
-                                else
-                                {
-                                    for (i = 0; i < internal_decoder_data->decode_to_value->value.map_value.pair_count; i++)
-                                    {
-                                        internal_decoder_data->decode_to_value->value.map_value.pairs[i].key = NULL;
-                                        internal_decoder_data->decode_to_value->value.map_value.pairs[i].value = NULL;
-                                    }
-
-                                    internal_decoder_data->decode_value_state.map_value_state.map_value_state = DECODE_MAP_STEP_PAIRS;
-                                    internal_decoder_data->bytes_decoded = 0;
-                                    internal_decoder_data->inner_decoder = NULL;
-                                    internal_decoder_data->decode_value_state.map_value_state.item = 0;
-                                    result = 0;
-                                }
-                            }
+                            result = start_decoding_map_pairs(internal_decoder_data);
                         }
                         else
                         {
                             if (internal_decoder_data->bytes_decoded == 4)
                             {
-                                if (internal_decoder_data->decode_to_value->value.map_value.pair_count == 0)
-                                {
-                                    internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
-
-                                    internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                                    result = 0;
-                                }
-                                else
-                                {
-                                    uint32_t i;
-
-                                    internal_decoder_data->decode_to_value->value.map_value.pair_count /= 2;
-
-                                    internal_decoder_data->decode_to_value->value.map_value.pairs = (AMQP_MAP_KEY_VALUE_PAIR*)malloc(sizeof(AMQP_MAP_KEY_VALUE_PAIR) * (internal_decoder_data->decode_to_value->value.map_value.pair_count * 2));
-                                    if (internal_decoder_data->decode_to_value->value.map_value.pairs == NULL)
-                                    {
-                                        LogError("Could not allocate memory for map value items");
-                                        result = __FAILURE__;
-                                    }
-                                    else
-                                    {
-                                        for (i = 0; i < internal_decoder_data->decode_to_value->value.map_value.pair_count; i++)
-                                        {
-                                            internal_decoder_data->decode_to_value->value.map_value.pairs[i].key = NULL;
-                                            internal_decoder_data->decode_to_value->value.map_value.pairs[i].value = NULL;
-                                        }
-
-                                        internal_decoder_data->decode_value_state.map_value_state.map_value_state = DECODE_MAP_STEP_PAIRS;
-                                        internal_decoder_data->bytes_decoded = 0;
-                                        internal_decoder_data->inner_decoder = NULL;
-                                        internal_decoder_data->decode_value_state.map_value_state.item = 0;
-                                        result = 0;
-                                    }
-                                }
+                                result = start_decoding_map_pairs(internal_decoder_data);
                             }
                             else
                             {
@@ -5004,7 +10113,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->bytes_decoded == 0)
                         {
-                            AMQP_VALUE_DATA* map_item = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+                            AMQP_VALUE_DATA* map_item = decoder_create_value_data(internal_decoder_data);
                             if (map_item == NULL)
                             {
                                 LogError("Could not allocate memory for map item");
@@ -5022,7 +10131,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                                 {
                                     internal_decoder_data->decode_to_value->value.map_value.pairs[internal_decoder_data->decode_value_state.map_value_state.item].value = map_item;
                                 }
-                                internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, map_item, true);
+                                internal_decoder_data->inner_decoder = inner_decoder_create(internal_decoder_data, map_item);
                                 if (internal_decoder_data->inner_decoder == NULL)
                                 {
                                     LogError("Could not create inner decoder for map item");
@@ -5055,11 +10164,21 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                             if (inner_decoder->decoder_state == DECODER_STATE_DONE)
                             {
-                                internal_decoder_destroy(inner_decoder);
+                                inner_decoder_release(internal_decoder_data, inner_decoder);
                                 internal_decoder_data->inner_decoder = NULL;
                                 internal_decoder_data->bytes_decoded = 0;
 
-                                if (internal_decoder_data->decode_to_value->value.map_value.pairs[internal_decoder_data->decode_value_state.map_value_state.item].value != NULL)
+                                if (internal_decoder_data->decode_to_value->value.map_value.pairs[internal_decoder_data->decode_value_state.map_value_state.item].value == NULL)
+                                {
+                                    /* the key was just decoded, its hash is taken while its bytes are still hot */
+                                    if (internal_decoder_data->decode_to_value->value.map_value.index != NULL)
+                                    {
+                                        insert_map_index_entry(internal_decoder_data->decode_to_value->value.map_value.index, internal_decoder_data->decode_to_value->value.map_value.index_size,
+                                            amqpvalue_hash(internal_decoder_data->decode_to_value->value.map_value.pairs[internal_decoder_data->decode_value_state.map_value_state.item].key),
+                                            internal_decoder_data->decode_value_state.map_value_state.item);
+                                    }
+                                }
+                                else
                                 {
                                     internal_decoder_data->decode_value_state.map_value_state.item++;
                                     if (internal_decoder_data->decode_value_state.map_value_state.item == internal_decoder_data->decode_to_value->value.map_value.pair_count)
@@ -5133,69 +10252,13 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                         if (internal_decoder_data->constructor_byte == 0xE0)
                         {
-                            if (internal_decoder_data->decode_to_value->value.array_value.count == 0)
-                            {
-                                internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
-
-                                internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                                result = 0;
-                            }
-                            else
-                            {
-                                uint32_t i;
-                                internal_decoder_data->decode_to_value->value.array_value.items = (AMQP_VALUE*)malloc(sizeof(AMQP_VALUE) * internal_decoder_data->decode_to_value->value.array_value.count);
-                                if (internal_decoder_data->decode_to_value->value.array_value.items == NULL)
-                                {
-                                    LogError("Could not allocate memory for array items");
-                                    result = __FAILURE__;
-                                }
-                                else
-                                {
-                                    for (i = 0; i < internal_decoder_data->decode_to_value->value.array_value.count; i++)
-                                    {
-                                        internal_decoder_data->decode_to_value->value.array_value.items[i] = NULL;
-                                    }
-
-                                    internal_decoder_data->decode_value_state.array_value_state.array_value_state = DECODE_ARRAY_STEP_ITEMS;
-                                    internal_decoder_data->bytes_decoded = 0;
-                                    internal_decoder_data->inner_decoder = NULL;
-                                    internal_decoder_data->decode_value_state.array_value_state.item = 0;
-                                    result = 0;
-                                }
-                            }
+                            result = start_decoding_array_items(internal_decoder_data);
                         }
                         else
                         {
                             if (internal_decoder_data->bytes_decoded == 4)
                             {
-                                if (internal_decoder_data->decode_to_value->value.array_value.count == 0)
-                                {
-                                    internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
-                                    internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
-                                    result = 0;
-                                }
-                                else
-                                {
-                                    uint32_t i;
-                                    internal_decoder_data->decode_to_value->value.array_value.items = (AMQP_VALUE*)malloc(sizeof(AMQP_VALUE) * internal_decoder_data->decode_to_value->value.array_value.count);
-                                    if (internal_decoder_data->decode_to_value->value.array_value.items == NULL)
-                                    {
-                                        LogError("Could not allocate memory for array items");
-                                        result = __FAILURE__;
-                                    }
-                                    else
-                                    {
-                                        for (i = 0; i < internal_decoder_data->decode_to_value->value.array_value.count; i++)
-                                        {
-                                            internal_decoder_data->decode_to_value->value.array_value.items[i] = NULL;
-                                        }
-                                        internal_decoder_data->decode_value_state.array_value_state.array_value_state = DECODE_ARRAY_STEP_ITEMS;
-                                        internal_decoder_data->bytes_decoded = 0;
-                                        internal_decoder_data->inner_decoder = NULL;
-                                        internal_decoder_data->decode_value_state.array_value_state.item = 0;
-                                        result = 0;
-                                    }
-                                }
+                                result = start_decoding_array_items(internal_decoder_data);
                             }
                             else
                             {
@@ -5213,7 +10276,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                             AMQP_VALUE_DATA* array_item;
                             internal_decoder_data->decode_value_state.array_value_state.constructor_byte = buffer[0];
 
-                            array_item = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+                            array_item = decoder_create_value_data(internal_decoder_data);
                             if (array_item == NULL)
                             {
                                 LogError("Could not allocate memory for array item to be decoded");
@@ -5224,7 +10287,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                             {
                                 array_item->type = AMQP_TYPE_UNKNOWN;
                                 internal_decoder_data->decode_to_value->value.array_value.items[internal_decoder_data->decode_value_state.array_value_state.item] = array_item;
-                                internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, array_item, true);
+                                internal_decoder_data->inner_decoder = inner_decoder_create(internal_decoder_data, array_item);
                                 if (internal_decoder_data->inner_decoder == NULL)
                                 {
                                     internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -5257,7 +10320,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
 
                             if (inner_decoder->decoder_state == DECODER_STATE_DONE)
                             {
-                                internal_decoder_destroy(inner_decoder);
+                                inner_decoder_release(internal_decoder_data, inner_decoder);
                                 internal_decoder_data->inner_decoder = NULL;
 
                                 internal_decoder_data->decode_value_state.array_value_state.item++;
@@ -5270,7 +10333,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                                 }
                                 else
                                 {
-                                    AMQP_VALUE_DATA* array_item = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+                                    AMQP_VALUE_DATA* array_item = decoder_create_value_data(internal_decoder_data);
                                     if (array_item == NULL)
                                     {
                                         LogError("Could not allocate memory for array item");
@@ -5281,7 +10344,7 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
                                     {
                                         array_item->type = AMQP_TYPE_UNKNOWN;
                                         internal_decoder_data->decode_to_value->value.array_value.items[internal_decoder_data->decode_value_state.array_value_state.item] = array_item;
-                                        internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, array_item, true);
+                                        internal_decoder_data->inner_decoder = inner_decoder_create(internal_decoder_data, array_item);
                                         if (internal_decoder_data->inner_decoder == NULL)
                                         {
                                             LogError("Could not create inner decoder for array item");
@@ -5320,84 +10383,345 @@ static int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder
             }
             }
 
-            if (result != 0)
+            if (result != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    if (used_bytes != NULL)
+    {
+        *used_bytes = initial_size - size;
+    }
+
+    return result;
+}
+
+static AMQP_VALUE decode_lazy_list_item(AMQP_VALUE_DATA* list_data, uint32_t index)
+{
+    AMQP_VALUE result;
+    LAZY_LIST_ITEMS* lazy_items = list_data->value.list_value.lazy_items;
+
+    if (lazy_items == NULL)
+    {
+        LogError("List item %u is missing", (unsigned int)index);
+        result = NULL;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* item = create_value_data();
+        if (item == NULL)
+        {
+            LogError("Could not allocate memory for list item");
+            result = NULL;
+        }
+        else
+        {
+            bool is_decoded = false;
+            INTERNAL_DECODER_DATA* item_decoder;
+
+            /* the bytes are valid as long as the list is, so binaries and nested lists in the item can point into them too */
+            item->type = AMQP_TYPE_UNKNOWN;
+            item_decoder = internal_decoder_create(lazy_list_item_decoded, &is_decoded, item, true, NULL, true, true, false);
+            if (item_decoder == NULL)
+            {
+                LogError("Could not create decoder for list item");
+                amqpvalue_destroy(item);
+                result = NULL;
+            }
+            else
+            {
+                size_t used_bytes;
+                uint32_t item_offset = lazy_items->item_offsets[index];
+
+                if ((internal_decoder_decode_bytes(item_decoder, lazy_items->bytes + item_offset, lazy_items->item_offsets[index + 1] - item_offset, &used_bytes) != 0) ||
+                    (!is_decoded))
+                {
+                    LogError("Could not decode list item %u", (unsigned int)index);
+                    amqpvalue_destroy(item);
+                    result = NULL;
+                }
+                else
+                {
+                    result = item;
+                }
+
+                internal_decoder_destroy(item_decoder);
+            }
+        }
+    }
+
+    return result;
+}
+
+AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context)
+{
+    AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance;
+
+    /* Codes_SRS_AMQPVALUE_01_312: [If the on_value_decoded argument is NULL, amqpvalue_decoder_create shall return NULL.] */
+    if (on_value_decoded == NULL)
+    {
+        LogError("NULL on_value_decoded");
+        decoder_instance = NULL;
+    }
+    else
+    {
+        decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)malloc(sizeof(AMQPVALUE_DECODER_HANDLE_DATA));
+        /* Codes_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
+        if (decoder_instance == NULL)
+        {
+            LogError("Could not allocate memory for AMQP value decoder");
+        }
+        else
+        {
+            decoder_instance->decode_to_value = create_value_data();
+            if (decoder_instance->decode_to_value == NULL)
+            {
+                /* Codes_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
+                LogError("Could not allocate memory for decoded AMQP value");
+                free(decoder_instance);
+                decoder_instance = NULL;
+            }
+            else
+            {
+                decoder_instance->decode_to_value->type = AMQP_TYPE_UNKNOWN;
+                decoder_instance->internal_decoder = internal_decoder_create(on_value_decoded, callback_context, decoder_instance->decode_to_value, false, NULL, false, false, false);
+                if (decoder_instance->internal_decoder == NULL)
+                {
+                    /* Codes_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
+                    LogError("Could not create the internal decoder");
+                    free(decoder_instance->decode_to_value);
+                    free(decoder_instance);
+                    decoder_instance = NULL;
+                }
+                else
+                {
+                    /* Codes_SRS_AMQPVALUE_01_521: [ A limit of 0 shall mean that there is no limit, which is the default for all the limits. ]*/
+                    decoder_instance->limits.max_depth = 0;
+                    decoder_instance->limits.max_element_count = 0;
+                    decoder_instance->limits.max_allocated_bytes = 0;
+                    decoder_instance->limits.element_count = 0;
+                    decoder_instance->limits.allocated_bytes = 0;
+                    decoder_instance->internal_decoder->limits = &decoder_instance->limits;
+                }
+            }
+        }
+    }
+
+    /* Codes_SRS_AMQPVALUE_01_311: [amqpvalue_decoder_create shall create a new amqp value decoder and return a non-NULL handle to it.] */
+    return decoder_instance;
+}
+
+void amqpvalue_decoder_destroy(AMQPVALUE_DECODER_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_317: [If handle is NULL, amqpvalue_decoder_destroy shall do nothing.] */
+        LogError("NULL handle");
+    }
+    else
+    {
+        AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
+        /* Codes_SRS_AMQPVALUE_01_316: [amqpvalue_decoder_destroy shall free all resources associated with the amqpvalue_decoder.] */
+        if ((decoder_instance->internal_decoder->decode_to_value != NULL) &&
+            (decoder_instance->internal_decoder->arena == NULL))
+        {
+            amqpvalue_destroy(decoder_instance->internal_decoder->decode_to_value);
+        }
+
+        internal_decoder_destroy(decoder_instance->internal_decoder);
+        free(handle);
+    }
+}
+
+int amqpvalue_decoder_reset(AMQPVALUE_DECODER_HANDLE handle)
+{
+    int result;
+
+    if (handle == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_501: [ If `handle` is NULL, `amqpvalue_decoder_reset` shall fail and return a non-zero value. ]*/
+        LogError("NULL handle");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
+        INTERNAL_DECODER_DATA* internal_decoder_data = decoder_instance->internal_decoder;
+
+        /* Codes_SRS_AMQPVALUE_01_502: [ `amqpvalue_decoder_reset` shall discard any partially decoded value and the last decoded value, so that the next byte passed to `amqpvalue_decode_bytes` or `amqpvalue_decode_one` is treated as the constructor of a new value. ]*/
+        if (internal_decoder_data->inner_decoder != NULL)
+        {
+            internal_decoder_destroy(internal_decoder_data->inner_decoder);
+            internal_decoder_data->inner_decoder = NULL;
+        }
+
+        if ((internal_decoder_data->decode_to_value != NULL) &&
+            (internal_decoder_data->arena == NULL))
+        {
+            amqpvalue_destroy(internal_decoder_data->decode_to_value);
+        }
+
+        internal_decoder_data->decode_to_value = NULL;
+        internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+        /* Codes_SRS_AMQPVALUE_01_503: [ `amqpvalue_decoder_reset` shall keep the arena, borrow binaries, lazy lists and validate strings settings of the decoder. ]*/
+        /* Codes_SRS_AMQPVALUE_01_527: [ `amqpvalue_decoder_reset` shall keep the limits set with `amqpvalue_decoder_set_limits`. ]*/
+        /* Codes_SRS_AMQPVALUE_01_504: [ On success `amqpvalue_decoder_reset` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int amqpvalue_decoder_set_arena(AMQPVALUE_DECODER_HANDLE handle, AMQPVALUE_ARENA_HANDLE arena)
+{
+    int result;
+
+    if (handle == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_413: [ If `handle` is NULL, `amqpvalue_decoder_set_arena` shall fail and return a non-zero value. ]*/
+        LogError("NULL handle");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
+        INTERNAL_DECODER_DATA* internal_decoder_data = decoder_instance->internal_decoder;
+
+        if (internal_decoder_data->decoder_state != DECODER_STATE_CONSTRUCTOR)
+        {
+            /* Codes_SRS_AMQPVALUE_01_414: [ If the decoder is in the middle of decoding a value, `amqpvalue_decoder_set_arena` shall fail and return a non-zero value. ]*/
+            LogError("Cannot change the arena while a value is being decoded");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_412: [ `amqpvalue_decoder_set_arena` shall make all subsequently decoded values (and all their inner values and buffers) be allocated from `arena`. ]*/
+            /* Codes_SRS_AMQPVALUE_01_415: [ If `arena` is NULL, subsequently decoded values shall be allocated individually. ]*/
+            if ((internal_decoder_data->decode_to_value != NULL) &&
+                (internal_decoder_data->arena == NULL))
             {
-                break;
+                amqpvalue_destroy(internal_decoder_data->decode_to_value);
             }
+
+            internal_decoder_data->decode_to_value = NULL;
+            internal_decoder_data->arena = arena;
+
+            /* Codes_SRS_AMQPVALUE_01_416: [ On success `amqpvalue_decoder_set_arena` shall return 0. ]*/
+            result = 0;
         }
     }
 
-    if (used_bytes != NULL)
+    return result;
+}
+
+int amqpvalue_decoder_set_borrow_binaries(AMQPVALUE_DECODER_HANDLE handle, bool borrow_binaries)
+{
+    int result;
+
+    if (handle == NULL)
     {
-        *used_bytes = initial_size - size;
+        /* Codes_SRS_AMQPVALUE_01_426: [ If `handle` is NULL, `amqpvalue_decoder_set_borrow_binaries` shall fail and return a non-zero value. ]*/
+        LogError("NULL handle");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
+
+        /* Codes_SRS_AMQPVALUE_01_425: [ `amqpvalue_decoder_set_borrow_binaries` shall enable or disable borrowing the bytes of decoded binary values from the buffer passed to amqpvalue_decode_bytes. ]*/
+        decoder_instance->internal_decoder->borrow_binaries = borrow_binaries;
+
+        /* Codes_SRS_AMQPVALUE_01_429: [ On success `amqpvalue_decoder_set_borrow_binaries` shall return 0. ]*/
+        result = 0;
     }
 
     return result;
 }
 
-AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context)
+int amqpvalue_decoder_set_lazy_lists(AMQPVALUE_DECODER_HANDLE handle, bool lazy_lists)
 {
-    AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance;
+    int result;
 
-    /* Codes_SRS_AMQPVALUE_01_312: [If the on_value_decoded argument is NULL, amqpvalue_decoder_create shall return NULL.] */
-    if (on_value_decoded == NULL)
+    if (handle == NULL)
     {
-        LogError("NULL on_value_decoded");
-        decoder_instance = NULL;
+        /* Codes_SRS_AMQPVALUE_01_464: [ If `handle` is NULL, `amqpvalue_decoder_set_lazy_lists` shall fail and return a non-zero value. ]*/
+        LogError("NULL handle");
+        result = __FAILURE__;
     }
     else
     {
-        decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)malloc(sizeof(AMQPVALUE_DECODER_HANDLE_DATA));
-        /* Codes_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
-        if (decoder_instance == NULL)
+        AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
+
+        /* Codes_SRS_AMQPVALUE_01_460: [ When lazy lists are enabled, the items of decoded lists shall not be decoded until they are accessed. ]*/
+        decoder_instance->internal_decoder->lazy_lists = lazy_lists;
+
+        /* Codes_SRS_AMQPVALUE_01_465: [ On success `amqpvalue_decoder_set_lazy_lists` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int amqpvalue_decoder_set_limits(AMQPVALUE_DECODER_HANDLE handle, uint32_t max_depth, size_t max_element_count, size_t max_allocated_bytes)
+{
+    int result;
+
+    if (handle == NULL)
+    {
+        /* Codes_SRS_AMQPVALUE_01_522: [ If `handle` is NULL, `amqpvalue_decoder_set_limits` shall fail and return a non-zero value. ]*/
+        LogError("NULL handle");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
+
+        if (decoder_instance->internal_decoder->decoder_state != DECODER_STATE_CONSTRUCTOR)
         {
-            LogError("Could not allocate memory for AMQP value decoder");
+            /* Codes_SRS_AMQPVALUE_01_523: [ If the decoder is in the middle of decoding a value, `amqpvalue_decoder_set_limits` shall fail and return a non-zero value. ]*/
+            LogError("Cannot change the limits while a value is being decoded");
+            result = __FAILURE__;
         }
         else
         {
-            decoder_instance->decode_to_value = REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
-            if (decoder_instance->decode_to_value == NULL)
-            {
-                /* Codes_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
-                LogError("Could not allocate memory for decoded AMQP value");
-                free(decoder_instance);
-                decoder_instance = NULL;
-            }
-            else
-            {
-                decoder_instance->decode_to_value->type = AMQP_TYPE_UNKNOWN;
-                decoder_instance->internal_decoder = internal_decoder_create(on_value_decoded, callback_context, decoder_instance->decode_to_value, false);
-                if (decoder_instance->internal_decoder == NULL)
-                {
-                    /* Codes_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
-                    LogError("Could not create the internal decoder");
-                    free(decoder_instance->decode_to_value);
-                    free(decoder_instance);
-                    decoder_instance = NULL;
-                }
-            }
+            /* Codes_SRS_AMQPVALUE_01_520: [ `amqpvalue_decoder_set_limits` shall limit, for each value decoded, how many values deep its items can be nested (`max_depth`), the total number of items declared by its lists, maps and arrays (`max_element_count`) and the total number of bytes allocated for it (`max_allocated_bytes`). ]*/
+            decoder_instance->limits.max_depth = max_depth;
+            decoder_instance->limits.max_element_count = max_element_count;
+            decoder_instance->limits.max_allocated_bytes = max_allocated_bytes;
+
+            /* Codes_SRS_AMQPVALUE_01_524: [ On success `amqpvalue_decoder_set_limits` shall return 0. ]*/
+            result = 0;
         }
     }
 
-    /* Codes_SRS_AMQPVALUE_01_311: [amqpvalue_decoder_create shall create a new amqp value decoder and return a non-NULL handle to it.] */
-    return decoder_instance;
+    return result;
 }
 
-void amqpvalue_decoder_destroy(AMQPVALUE_DECODER_HANDLE handle)
+int amqpvalue_decoder_set_validate_strings(AMQPVALUE_DECODER_HANDLE handle, bool validate_strings)
 {
+    int result;
+
     if (handle == NULL)
     {
-        /* Codes_SRS_AMQPVALUE_01_317: [If handle is NULL, amqpvalue_decoder_destroy shall do nothing.] */
+        /* Codes_SRS_AMQPVALUE_01_479: [ If `handle` is NULL, `amqpvalue_decoder_set_validate_strings` shall fail and return a non-zero value. ]*/
         LogError("NULL handle");
+        result = __FAILURE__;
     }
     else
     {
         AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
-        /* Codes_SRS_AMQPVALUE_01_316: [amqpvalue_decoder_destroy shall free all resources associated with the amqpvalue_decoder.] */
-        amqpvalue_destroy(decoder_instance->internal_decoder->decode_to_value);
-        internal_decoder_destroy(decoder_instance->internal_decoder);
-        free(handle);
+
+        /* Codes_SRS_AMQPVALUE_01_476: [ `amqpvalue_decoder_set_validate_strings` shall enable or disable validating decoded strings as UTF-8 and decoded symbols as 7-bit ASCII. ]*/
+        decoder_instance->internal_decoder->validate_strings = validate_strings;
+
+        /* Codes_SRS_AMQPVALUE_01_480: [ On success `amqpvalue_decoder_set_validate_strings` shall return 0. ]*/
+        result = 0;
     }
+
+    return result;
 }
 
 /* Codes_SRS_AMQPVALUE_01_318: [amqpvalue_decode_bytes shall decode size bytes that are passed in the buffer argument.] */
@@ -5436,6 +10760,208 @@ int amqpvalue_decode_bytes(AMQPVALUE_DECODER_HANDLE handle, const unsigned char*
     return result;
 }
 
+/* wraps the callback of the decoder during amqpvalue_decode_one, so that no byte after the first value is decoded */
+typedef struct DECODE_ONE_CONTEXT_TAG
+{
+    INTERNAL_DECODER_DATA* internal_decoder;
+    ON_VALUE_DECODED on_value_decoded;
+    void* on_value_decoded_context;
+    uint32_t decoded_value_count;
+} DECODE_ONE_CONTEXT;
+
+static void decode_one_value_decoded(void* context, AMQP_VALUE decoded_value)
+{
+    DECODE_ONE_CONTEXT* decode_one_context = (DECODE_ONE_CONTEXT*)context;
+
+    decode_one_context->decoded_value_count++;
+    /* stops the decoding loop, bytes left when the declared size of the value disagrees with its content are not taken as a new value */
+    decode_one_context->internal_decoder->decoder_state = DECODER_STATE_DONE;
+    decode_one_context->on_value_decoded(decode_one_context->on_value_decoded_context, decoded_value);
+}
+
+int amqpvalue_decode_one(AMQPVALUE_DECODER_HANDLE handle, const unsigned char* buffer, size_t size, size_t* used_bytes)
+{
+    int result;
+
+    AMQPVALUE_DECODER_HANDLE_DATA* decoder_instance = (AMQPVALUE_DECODER_HANDLE_DATA*)handle;
+    /* Codes_SRS_AMQPVALUE_01_498: [ If `handle`, `buffer` or `used_bytes` is NULL or `size` is 0, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+    if ((decoder_instance == NULL) ||
+        (buffer == NULL) ||
+        (size == 0) ||
+        (used_bytes == NULL))
+    {
+        LogError("Bad arguments: decoder_instance = %p, buffer = %p, size = %u, used_bytes = %p",
+            decoder_instance, buffer, (unsigned int)size, used_bytes);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQPVALUE_01_499: [ If bytes of a previous value given to amqpvalue_decode_bytes are still pending, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+    else if (decoder_instance->internal_decoder->decoder_state != DECODER_STATE_CONSTRUCTOR)
+    {
+        LogError("A value is partially decoded");
+        result = __FAILURE__;
+    }
+    else
+    {
+        INTERNAL_DECODER_DATA* internal_decoder = decoder_instance->internal_decoder;
+        size_t value_size;
+        size_t decoded_bytes = 0;
+
+        /* Codes_SRS_AMQPVALUE_01_496: [ `amqpvalue_decode_one` shall decode the one complete value at the start of `buffer` in a single pass, calling on_value_decoded with it, and without touching the bytes that follow it. ]*/
+        /* Codes_SRS_AMQPVALUE_01_500: [ If the value is not complete in the `size` bytes or its constructor is not supported, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+        if (get_encoded_value_length(buffer, size, &value_size) != 0)
+        {
+            LogError("Buffer does not hold a complete value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            DECODE_ONE_CONTEXT decode_one_context;
+            int decode_result;
+
+            decode_one_context.internal_decoder = internal_decoder;
+            decode_one_context.on_value_decoded = internal_decoder->on_value_decoded;
+            decode_one_context.on_value_decoded_context = internal_decoder->on_value_decoded_context;
+            decode_one_context.decoded_value_count = 0;
+
+            internal_decoder->on_value_decoded = decode_one_value_decoded;
+            internal_decoder->on_value_decoded_context = &decode_one_context;
+            decode_result = internal_decoder_decode_bytes(internal_decoder, buffer, value_size, &decoded_bytes);
+            internal_decoder->on_value_decoded = decode_one_context.on_value_decoded;
+            internal_decoder->on_value_decoded_context = decode_one_context.on_value_decoded_context;
+
+            if (internal_decoder->decoder_state == DECODER_STATE_DONE)
+            {
+                internal_decoder->decoder_state = DECODER_STATE_CONSTRUCTOR;
+            }
+
+            if (decode_result != 0)
+            {
+                LogError("Failed decoding bytes");
+                result = __FAILURE__;
+            }
+            /* Codes_SRS_AMQPVALUE_01_582: [ If decoding the declared size of the value does not end exactly with one complete value, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+            else if ((decode_one_context.decoded_value_count != 1) ||
+                (decoded_bytes != value_size))
+            {
+                LogError("The declared size of the value (%u bytes) does not match its content (%u bytes decoded)",
+                    (unsigned int)value_size, (unsigned int)decoded_bytes);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_AMQPVALUE_01_497: [ On success `amqpvalue_decode_one` shall set `used_bytes` to the number of bytes taken by the value and return 0. ]*/
+                *used_bytes = value_size;
+                result = 0;
+            }
+        }
+
+        if (result != 0)
+        {
+            /* Codes_SRS_AMQPVALUE_01_583: [ On failure `amqpvalue_decode_one` shall reset the decoder as `amqpvalue_decoder_reset` does, so that the next value can be decoded. ]*/
+            (void)amqpvalue_decoder_reset(handle);
+        }
+    }
+
+    return result;
+}
+
+int amqpvalue_get_encoded_value_size(const unsigned char* bytes, size_t size, size_t* encoded_value_size)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_469: [ If `bytes` or `encoded_value_size` is NULL or `size` is 0, `amqpvalue_get_encoded_value_size` shall fail and return a non-zero value. ]*/
+    if ((bytes == NULL) ||
+        (size == 0) ||
+        (encoded_value_size == NULL))
+    {
+        LogError("Bad arguments: bytes = %p, size = %u, encoded_value_size = %p",
+            bytes, (unsigned int)size, encoded_value_size);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_AMQPVALUE_01_468: [ `amqpvalue_get_encoded_value_size` shall fill in `encoded_value_size` with the number of bytes taken by the encoded value at the start of `bytes`, without decoding it. ]*/
+    /* Codes_SRS_AMQPVALUE_01_470: [ If the value is not complete in the `size` bytes or its constructor is not supported, `amqpvalue_get_encoded_value_size` shall fail and return a non-zero value. ]*/
+    else if (get_encoded_value_length(bytes, size, encoded_value_size) != 0)
+    {
+        LogError("Cannot determine the encoded value size");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int amqpvalue_scan_described_values(const unsigned char* bytes, size_t size, ON_DESCRIBED_VALUE_SCANNED on_described_value_scanned, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_AMQPVALUE_01_472: [ If `bytes` or `on_described_value_scanned` is NULL or `size` is 0, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+    if ((bytes == NULL) ||
+        (size == 0) ||
+        (on_described_value_scanned == NULL))
+    {
+        LogError("Bad arguments: bytes = %p, size = %u, on_described_value_scanned = %p",
+            bytes, (unsigned int)size, on_described_value_scanned);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t offset = 0;
+        result = 0;
+
+        while (offset < size)
+        {
+            size_t value_size;
+            uint64_t descriptor_code;
+
+            if (get_encoded_value_length(bytes + offset, size - offset, &value_size) != 0)
+            {
+                /* Codes_SRS_AMQPVALUE_01_473: [ If a value is not complete in the `size` bytes or its constructor is not supported, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+                LogError("Cannot determine the size of the encoded value at offset %u", (unsigned int)offset);
+                result = __FAILURE__;
+                break;
+            }
+
+            /* Codes_SRS_AMQPVALUE_01_474: [ If a value is not a described value with an ulong descriptor, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+            if ((bytes[offset] != 0x00) || (value_size < 2))
+            {
+                LogError("Encoded value at offset %u is not a described value", (unsigned int)offset);
+                result = __FAILURE__;
+                break;
+            }
+
+            if (bytes[offset + 1] == 0x44)
+            {
+                descriptor_code = 0;
+            }
+            else if ((bytes[offset + 1] == 0x53) && (value_size >= 3))
+            {
+                descriptor_code = bytes[offset + 2];
+            }
+            else if ((bytes[offset + 1] == 0x80) && (value_size >= 10))
+            {
+                descriptor_code = read_uint64_from_span(bytes + offset + 2);
+            }
+            else
+            {
+                LogError("Encoded value at offset %u does not have an ulong descriptor", (unsigned int)offset);
+                result = __FAILURE__;
+                break;
+            }
+
+            /* Codes_SRS_AMQPVALUE_01_471: [ `amqpvalue_scan_described_values` shall call `on_described_value_scanned` for each described value encoded in `bytes`, in order, passing `callback_context`, the ulong descriptor and the span of the whole encoded value, without decoding the value. ]*/
+            on_described_value_scanned(callback_context, descriptor_code, bytes + offset, value_size);
+            offset += value_size;
+        }
+
+        /* Codes_SRS_AMQPVALUE_01_475: [ On success `amqpvalue_scan_described_values` shall return 0. ]*/
+    }
+
+    return result;
+}
+
 AMQP_VALUE amqpvalue_get_inplace_descriptor(AMQP_VALUE value)
 {
     AMQP_VALUE result;
@@ -5492,7 +11018,7 @@ AMQP_VALUE amqpvalue_get_inplace_described_value(AMQP_VALUE value)
 
 AMQP_VALUE amqpvalue_create_described(AMQP_VALUE descriptor, AMQP_VALUE value)
 {
-    AMQP_VALUE_DATA* result = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE_DATA* result = create_value_data();
     if (result == NULL)
     {
         LogError("Cannot allocate memory for described type");
@@ -5502,6 +11028,10 @@ AMQP_VALUE amqpvalue_create_described(AMQP_VALUE descriptor, AMQP_VALUE value)
         result->type = AMQP_TYPE_DESCRIBED;
         result->value.described_value.descriptor = descriptor;
         result->value.described_value.value = value;
+
+        /* Codes_SRS_AMQPVALUE_01_431: [ A described value whose descriptor or value is borrowed shall also be treated as borrowed. ]*/
+        result->is_borrowed = ((descriptor != NULL) && descriptor->is_borrowed) ||
+            ((value != NULL) && value->is_borrowed);
     }
 
     return result;
@@ -5509,7 +11039,7 @@ AMQP_VALUE amqpvalue_create_described(AMQP_VALUE descriptor, AMQP_VALUE value)
 
 AMQP_VALUE amqpvalue_create_composite(AMQP_VALUE descriptor, uint32_t list_size)
 {
-    AMQP_VALUE_DATA* result = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE_DATA* result = create_value_data();
     if (result == NULL)
     {
         LogError("Cannot allocate memory for composite type");
@@ -5553,7 +11083,7 @@ AMQP_VALUE amqpvalue_create_composite(AMQP_VALUE descriptor, uint32_t list_size)
 
 AMQP_VALUE amqpvalue_create_composite_with_ulong_descriptor(uint64_t descriptor)
 {
-    AMQP_VALUE_DATA* result = (AMQP_VALUE_DATA*)REFCOUNT_TYPE_CREATE(AMQP_VALUE_DATA);
+    AMQP_VALUE_DATA* result = create_value_data();
     if (result == NULL)
     {
         LogError("Cannot allocate memory for composite type");
@@ -5620,6 +11150,46 @@ int amqpvalue_set_composite_item(AMQP_VALUE value, uint32_t index, AMQP_VALUE it
     return result;
 }
 
+int amqpvalue_set_composite_item_move(AMQP_VALUE value, uint32_t index, AMQP_VALUE item_value)
+{
+    int result;
+
+    if ((value == NULL) ||
+        (item_value == NULL))
+    {
+        /* Codes_SRS_AMQPVALUE_01_505: [ If `value` or `item_value` is NULL, `amqpvalue_set_composite_item_move` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: value = %p, item_value = %p",
+            value, item_value);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
+        if ((value_data->type != AMQP_TYPE_COMPOSITE) &&
+            (value_data->type != AMQP_TYPE_DESCRIBED))
+        {
+            /* Codes_SRS_AMQPVALUE_01_506: [ If `value` is not a composite, `amqpvalue_set_composite_item_move` shall fail and return a non-zero value. ]*/
+            LogError("Attempt to set composite item on a non-composite type");
+            result = __FAILURE__;
+        }
+        else if ((prepare_list_for_update(value_data->value.described_value.value) != 0) ||
+            /* Codes_SRS_AMQPVALUE_01_507: [ `amqpvalue_set_composite_item_move` shall store `item_value` itself at the `index`-th position, without cloning it, and the composite shall own it from then on. ]*/
+            (store_list_item(value_data->value.described_value.value, index, item_value) != 0))
+        {
+            /* Codes_SRS_AMQPVALUE_01_508: [ On failure `amqpvalue_set_composite_item_move` shall leave the composite unchanged and `item_value` owned by the caller. ]*/
+            LogError("Cannot store composite item");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_AMQPVALUE_01_509: [ On success `amqpvalue_set_composite_item_move` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 AMQP_VALUE amqpvalue_get_composite_item(AMQP_VALUE value, size_t index)
 {
     AMQP_VALUE result;
@@ -5738,7 +11308,12 @@ AMQP_VALUE amqpvalue_get_list_item_in_place(AMQP_VALUE value, size_t index)
         }
         else
         {
-            result = value_data->value.list_value.items[index];
+            /* Codes_SRS_AMQPVALUE_01_462: [ If decoding a lazily decoded item fails, the list accessors shall fail and return NULL. ]*/
+            result = get_list_item_data(value_data, (uint32_t)index);
+            if (result == NULL)
+            {
+                LogError("Could not decode list item %u", (unsigned int)index);
+            }
         }
     }
 
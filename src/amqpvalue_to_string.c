@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include "azure_c_shared_utility/optimize_size.h"
@@ -19,700 +20,722 @@
 #define snprintf _snprintf
 #endif
 
-static int string_concat(char** string, const char* to_concat)
+#define DEFAULT_INITIAL_CAPACITY 64
+#define TRUNCATION_MARKER "..."
+
+/* the whole string is built with a single write cursor, the buffer only grows by doubling */
+typedef struct STRING_BUILDER_TAG
+{
+    char* buffer;
+    size_t length;
+    size_t capacity;
+    size_t max_length;
+    bool is_truncated;
+} STRING_BUILDER;
+
+static int ensure_capacity(STRING_BUILDER* builder, size_t needed_capacity)
+{
+    int result;
+
+    if (needed_capacity <= builder->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_capacity = (builder->capacity == 0) ? DEFAULT_INITIAL_CAPACITY : builder->capacity;
+        char* new_buffer;
+
+        while (new_capacity < needed_capacity)
+        {
+            new_capacity *= 2;
+        }
+
+        new_buffer = (char*)realloc(builder->buffer, new_capacity);
+        if (new_buffer == NULL)
+        {
+            LogError("Cannot allocate memory for the new string");
+            result = __FAILURE__;
+        }
+        else
+        {
+            builder->buffer = new_buffer;
+            builder->capacity = new_capacity;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int append_bytes(STRING_BUILDER* builder, const char* to_append, size_t length)
 {
     int result;
-    char* new_string;
-    size_t length = strlen(to_concat) + 1;
-    size_t src_length;
 
-    if (*string != NULL)
+    if (builder->is_truncated)
     {
-        src_length = strlen(*string);
+        /* everything past the maximum length is dropped */
+        result = 0;
     }
     else
     {
-        src_length = 0;
+        if (length > builder->max_length - builder->length)
+        {
+            length = builder->max_length - builder->length;
+            builder->is_truncated = true;
+        }
+
+        /* one more byte is always kept for the terminator */
+        if (ensure_capacity(builder, builder->length + length + 1) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memcpy(builder->buffer + builder->length, to_append, length);
+            builder->length += length;
+            result = 0;
+        }
     }
 
-    new_string = (char*)realloc(*string, src_length + length);
-    if (new_string == NULL)
+    return result;
+}
+
+static int append_string(STRING_BUILDER* builder, const char* to_append)
+{
+    return append_bytes(builder, to_append, strlen(to_append));
+}
+
+static int append_formatted(STRING_BUILDER* builder, int formatted_length, const char* formatted)
+{
+    int result;
+
+    if (formatted_length < 0)
     {
-        LogError("Cannot allocate memory for the new string");
+        LogError("Failure formatting value");
         result = __FAILURE__;
     }
     else
     {
-        *string = new_string;
-        (void)memcpy(*string + src_length, to_concat, length);
-        result = 0;
+        result = append_string(builder, formatted);
     }
 
     return result;
 }
 
-char* amqpvalue_to_string(AMQP_VALUE amqp_value)
+static int write_value(STRING_BUILDER* builder, AMQP_VALUE amqp_value);
+
+static int write_binary(STRING_BUILDER* builder, const amqp_binary* binary_value)
 {
-    char* result = NULL;
+    static const char hex_digits[] = "0123456789ABCDEF";
+    int result;
 
-    if (amqp_value != NULL)
+    if (append_bytes(builder, "<", 1) != 0)
     {
-        AMQP_TYPE amqp_type = amqpvalue_get_type(amqp_value);
-        switch (amqp_type)
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t i;
+
+        result = 0;
+
+        for (i = 0; (i < binary_value->length) && !builder->is_truncated; i++)
         {
-        default:
-            LogError("Unknown AMQP type");
-            result = NULL;
-            break;
+            unsigned char byte_value = ((const unsigned char*)binary_value->bytes)[i];
+            char str_value[3];
 
-        case AMQP_TYPE_NULL:
-            if (string_concat(&result, "NULL") != 0)
+            str_value[0] = ' ';
+            str_value[1] = hex_digits[byte_value >> 4];
+            str_value[2] = hex_digits[byte_value & 0x0F];
+
+            if (((i == 0) && (append_bytes(builder, str_value + 1, 2) != 0)) ||
+                ((i > 0) && (append_bytes(builder, str_value, 3) != 0)))
             {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
+                result = __FAILURE__;
+                break;
             }
-            break;
-        case AMQP_TYPE_BOOL:
+        }
+
+        if ((result == 0) &&
+            (append_bytes(builder, ">", 1) != 0))
         {
-            bool value;
-            if (amqpvalue_get_boolean(amqp_value, &value) != 0)
-            {
-                LogError("Failure getting bool value");
-                free(result);
-                result = NULL;
-            }
-            else if (string_concat(&result, (value == true) ? "true" : "false") != 0)
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            break;
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_UBYTE:
+    }
+
+    return result;
+}
+
+static int write_list(STRING_BUILDER* builder, AMQP_VALUE amqp_value)
+{
+    int result;
+    uint32_t count;
+
+    if (amqpvalue_get_list_item_count(amqp_value, &count) != 0)
+    {
+        LogError("Failure getting list item count value");
+        result = __FAILURE__;
+    }
+    else if (append_bytes(builder, "{", 1) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t i;
+
+        result = 0;
+
+        for (i = 0; (i < count) && !builder->is_truncated; i++)
         {
-            char str_value[4];
-            uint8_t value;
-            if (amqpvalue_get_ubyte(amqp_value, &value) != 0)
+            AMQP_VALUE item = amqpvalue_get_list_item(amqp_value, i);
+            if (item == NULL)
             {
-                LogError("Failure getting ubyte value");
-                free(result);
-                result = NULL;
+                LogError("Failure getting item %u from list", (unsigned int)i);
+                result = __FAILURE__;
+                break;
             }
-            else if ((sprintf(str_value, "%" PRIu8, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
+            else
             {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
+                if (((i > 0) && (append_bytes(builder, ",", 1) != 0)) ||
+                    (write_value(builder, item) != 0))
+                {
+                    LogError("Failure converting item %u to string", (unsigned int)i);
+                    result = __FAILURE__;
+                }
+
+                amqpvalue_destroy(item);
+
+                if (result != 0)
+                {
+                    break;
+                }
             }
-            break;
         }
-        case AMQP_TYPE_USHORT:
+
+        if ((result == 0) &&
+            (append_bytes(builder, "}", 1) != 0))
         {
-            char str_value[6];
-            uint16_t value;
-            if (amqpvalue_get_ushort(amqp_value, &value) != 0)
-            {
-                LogError("Failure getting ushort value");
-                free(result);
-                result = NULL;
-            }
-            else if ((sprintf(str_value, "%" PRIu16, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            break;
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_UINT:
+    }
+
+    return result;
+}
+
+static int write_map(STRING_BUILDER* builder, AMQP_VALUE amqp_value)
+{
+    int result;
+    uint32_t count;
+
+    if (amqpvalue_get_map_pair_count(amqp_value, &count) != 0)
+    {
+        LogError("Failure getting map pair count");
+        result = __FAILURE__;
+    }
+    else if (append_bytes(builder, "{", 1) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t i;
+
+        result = 0;
+
+        for (i = 0; (i < count) && !builder->is_truncated; i++)
         {
-            char str_value[11];
-            uint32_t value;
-            if (amqpvalue_get_uint(amqp_value, &value) != 0)
+            AMQP_VALUE key;
+            AMQP_VALUE value;
+            if (amqpvalue_get_map_key_value_pair(amqp_value, i, &key, &value) != 0)
             {
-                LogError("Failure getting uint value");
-                free(result);
-                result = NULL;
+                LogError("Failure getting key/value pair index %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
             }
-            else if ((sprintf(str_value, "%" PRIu32, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
+            else
             {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
+                if (((i > 0) && (append_bytes(builder, ",", 1) != 0)) ||
+                    (append_bytes(builder, "[", 1) != 0) ||
+                    (write_value(builder, key) != 0) ||
+                    (append_bytes(builder, ":", 1) != 0) ||
+                    (write_value(builder, value) != 0) ||
+                    (append_bytes(builder, "]", 1) != 0))
+                {
+                    LogError("Failure converting key/value pair index %u to string", (unsigned int)i);
+                    result = __FAILURE__;
+                }
+
+                amqpvalue_destroy(key);
+                amqpvalue_destroy(value);
+
+                if (result != 0)
+                {
+                    break;
+                }
             }
-            break;
         }
-        case AMQP_TYPE_ULONG:
+
+        if ((result == 0) &&
+            (append_bytes(builder, "}", 1) != 0))
         {
-            char str_value[21];
-            uint64_t value;
-            if (amqpvalue_get_ulong(amqp_value, &value) != 0)
-            {
-                LogError("Failure getting ulong value");
-                free(result);
-                result = NULL;
-            }
-            else if ((sprintf(str_value, "%" PRIu64, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            break;
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_BYTE:
+    }
+
+    return result;
+}
+
+static int write_array(STRING_BUILDER* builder, AMQP_VALUE amqp_value)
+{
+    int result;
+    uint32_t count;
+
+    if (amqpvalue_get_array_item_count(amqp_value, &count) != 0)
+    {
+        LogError("Failure getting array item count");
+        result = __FAILURE__;
+    }
+    else if (append_bytes(builder, "{", 1) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t i;
+
+        result = 0;
+
+        for (i = 0; (i < count) && !builder->is_truncated; i++)
         {
-            char str_value[5];
-            char value;
-            if (amqpvalue_get_byte(amqp_value, &value) != 0)
+            AMQP_VALUE item = amqpvalue_get_array_item(amqp_value, i);
+            if (item == NULL)
             {
-                LogError("Failure getting byte value");
-                free(result);
-                result = NULL;
+                LogError("Failure getting array item for index %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
             }
-            else if ((sprintf(str_value, "%" PRId8, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
+            else
             {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
+                if (((i > 0) && (append_bytes(builder, ",", 1) != 0)) ||
+                    (write_value(builder, item) != 0))
+                {
+                    LogError("Failure getting stringified array item value for index %u", (unsigned int)i);
+                    result = __FAILURE__;
+                }
+
+                amqpvalue_destroy(item);
+
+                if (result != 0)
+                {
+                    break;
+                }
             }
-            break;
         }
-        case AMQP_TYPE_SHORT:
+
+        if ((result == 0) &&
+            (append_bytes(builder, "}", 1) != 0))
         {
-            char str_value[7];
-            int16_t value;
-            if (amqpvalue_get_short(amqp_value, &value) != 0)
-            {
-                LogError("Failure getting short value");
-                free(result);
-                result = NULL;
-            }
-            else if ((sprintf(str_value, "%" PRId16, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            break;
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_INT:
+    }
+
+    return result;
+}
+
+static int write_value(STRING_BUILDER* builder, AMQP_VALUE amqp_value)
+{
+    int result;
+    AMQP_TYPE amqp_type = amqpvalue_get_type(amqp_value);
+    char str_value[25];
+
+    switch (amqp_type)
+    {
+    default:
+        LogError("Unknown AMQP type");
+        result = __FAILURE__;
+        break;
+
+    case AMQP_TYPE_NULL:
+        result = append_string(builder, "NULL");
+        break;
+
+    case AMQP_TYPE_BOOL:
+    {
+        bool value;
+        if (amqpvalue_get_boolean(amqp_value, &value) != 0)
         {
-            char str_value[12];
-            int32_t value;
-            if (amqpvalue_get_int(amqp_value, &value) != 0)
-            {
-                LogError("Failure getting int value");
-                free(result);
-                result = NULL;
-            }
-            else if ((sprintf(str_value, "%" PRId32, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            break;
+            LogError("Failure getting bool value");
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_LONG:
+        else
         {
-            char str_value[21];
-            int64_t value;
-            if (amqpvalue_get_long(amqp_value, &value) != 0)
-            {
-                LogError("Failure getting long value");
-                free(result);
-                result = NULL;
-            }
-            else if ((sprintf(str_value, "%" PRId64, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            break;
+            result = append_string(builder, (value == true) ? "true" : "false");
         }
-        case AMQP_TYPE_FLOAT:
+        break;
+    }
+    case AMQP_TYPE_UBYTE:
+    {
+        uint8_t value;
+        if (amqpvalue_get_ubyte(amqp_value, &value) != 0)
         {
-            float float_value;
-            if (amqpvalue_get_float(amqp_value, &float_value) != 0)
-            {
-                LogError("Failure getting float value");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                char str_value[25];
-                if ((snprintf(str_value, sizeof(str_value), "%.02f", float_value) < 0) ||
-                    (string_concat(&result, str_value) != 0))
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-            }
-            break;
+            LogError("Failure getting ubyte value");
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_DOUBLE:
+        else
         {
-            double double_value;
-            if (amqpvalue_get_double(amqp_value, &double_value) != 0)
-            {
-                LogError("Failure getting double value");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                char str_value[25];
-                if ((snprintf(str_value, sizeof(str_value), "%.02lf", double_value) < 0) ||
-                    (string_concat(&result, str_value) != 0))
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-            }
-            break;
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRIu8, value), str_value);
         }
-        case AMQP_TYPE_CHAR:
+        break;
+    }
+    case AMQP_TYPE_USHORT:
+    {
+        uint16_t value;
+        if (amqpvalue_get_ushort(amqp_value, &value) != 0)
         {
-            uint32_t char_code;
-            if (amqpvalue_get_char(amqp_value, &char_code) != 0)
-            {
-                LogError("Failure getting char value");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                char str_value[25];
-                if ((snprintf(str_value, sizeof(str_value), "U%02X%02X%02X%02X", char_code >> 24, (char_code >> 16) & 0xFF, (char_code >> 8) & 0xFF, char_code & 0xFF) < 0) ||
-                    (string_concat(&result, str_value) != 0))
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-            }
-            break;
+            LogError("Failure getting ushort value");
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_TIMESTAMP:
+        else
         {
-            char str_value[21];
-            int64_t value;
-            if (amqpvalue_get_timestamp(amqp_value, &value) != 0)
-            {
-                LogError("Failure getting timestamp value");
-                free(result);
-                result = NULL;
-            }
-            else if ((sprintf(str_value, "%" PRId64, value) < 0) ||
-                     (string_concat(&result, str_value) != 0))
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            break;
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRIu16, value), str_value);
         }
-        case AMQP_TYPE_UUID:
+        break;
+    }
+    case AMQP_TYPE_UINT:
+    {
+        uint32_t value;
+        if (amqpvalue_get_uint(amqp_value, &value) != 0)
         {
-            uuid uuid_value;
-            if (amqpvalue_get_uuid(amqp_value, &uuid_value) != 0)
-            {
-                LogError("Failure getting uuid value");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                char* uuid_string_value = UUID_to_string(&uuid_value);
-                if (uuid_string_value == NULL)
-                {
-                    LogError("Failure getting UUID stringified value");
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    if (string_concat(&result, uuid_string_value) != 0)
-                    {
-                        LogError("Failure building amqp value string");
-                        free(result);
-                        result = NULL;
-                    }
-
-                    free(uuid_string_value);
-                }
-            }
-
-            break;
+            LogError("Failure getting uint value");
+            result = __FAILURE__;
         }
-
-        case AMQP_TYPE_BINARY:
+        else
         {
-            amqp_binary binary_value;
-            if (amqpvalue_get_binary(amqp_value, &binary_value) != 0)
-            {
-                LogError("Failure getting binary value");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                if (string_concat(&result, "<") != 0)
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    uint64_t i;
-
-                    for (i = 0; i < binary_value.length; i++)
-                    {
-                        char str_value[4];
-                        if ((snprintf(str_value, sizeof(str_value), "%s%02X", (i > 0) ? " " : "", ((unsigned char*)binary_value.bytes)[i]) < 0) ||
-                            (string_concat(&result, str_value) != 0))
-                        {
-                            break;
-                        }
-                    }
-
-                    if ((i < binary_value.length) ||
-                        (string_concat(&result, ">") != 0))
-                    {
-                        LogError("Failure building amqp value string");
-                        free(result);
-                        result = NULL;
-                    }
-                }
-            }
-            break;
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRIu32, value), str_value);
         }
-        case AMQP_TYPE_STRING:
+        break;
+    }
+    case AMQP_TYPE_ULONG:
+    {
+        uint64_t value;
+        if (amqpvalue_get_ulong(amqp_value, &value) != 0)
         {
-            const char* string_value;
-            if (amqpvalue_get_string(amqp_value, &string_value) != 0)
-            {
-                LogError("Failure getting string value");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                if (string_concat(&result, string_value) != 0)
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-            }
-            break;
+            LogError("Failure getting ulong value");
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_SYMBOL:
+        else
         {
-            const char* string_value;
-            if (amqpvalue_get_symbol(amqp_value, &string_value) != 0)
-            {
-                LogError("Failure getting symbol value");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                if (string_concat(&result, string_value) != 0)
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-            }
-            break;
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRIu64, value), str_value);
         }
-        case AMQP_TYPE_LIST:
+        break;
+    }
+    case AMQP_TYPE_BYTE:
+    {
+        char value;
+        if (amqpvalue_get_byte(amqp_value, &value) != 0)
         {
-            uint32_t count;
-            if (amqpvalue_get_list_item_count(amqp_value, &count) != 0)
-            {
-                LogError("Failure getting list item count value");
-                free(result);
-                result = NULL;
-            }
-            else if (string_concat(&result, "{") != 0)
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                size_t i;
-                for (i = 0; i < count; i++)
-                {
-                    AMQP_VALUE item = amqpvalue_get_list_item(amqp_value, i);
-                    if (item == NULL)
-                    {
-                        LogError("Failure getting item %u from list", (unsigned int)i);
-                        break;
-                    }
-                    else
-                    {
-                        char* item_string = amqpvalue_to_string(item);
-                        if (item_string == NULL)
-                        {
-                            LogError("Failure converting item %u to string", (unsigned int)i);
-                            amqpvalue_destroy(item);
-                            break;
-                        }
-                        else
-                        {
-                            if (((i > 0) && (string_concat(&result, ",") != 0)) ||
-                                 (string_concat(&result, item_string) != 0))
-                            {
-                                LogError("Failure building amqp value string");
-                                free(result);
-                                result = NULL;
-                                break;
-                            }
-
-                            free(item_string);
-                        }
-
-                        amqpvalue_destroy(item);
-                    }
-                }
-
-                if (i < count)
-                {
-                    // no log here, we already logged the error
-                    free(result);
-                    result = NULL;
-                }
-                else if (string_concat(&result, "}") != 0)
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-            }
-            break;
+            LogError("Failure getting byte value");
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_MAP:
+        else
         {
-            uint32_t count;
-            if (amqpvalue_get_map_pair_count(amqp_value, &count) != 0)
-            {
-                LogError("Failure getting map pair count");
-                free(result);
-                result = NULL;
-            }
-            else if (string_concat(&result, "{") != 0)
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRId8, value), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_SHORT:
+    {
+        int16_t value;
+        if (amqpvalue_get_short(amqp_value, &value) != 0)
+        {
+            LogError("Failure getting short value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRId16, value), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_INT:
+    {
+        int32_t value;
+        if (amqpvalue_get_int(amqp_value, &value) != 0)
+        {
+            LogError("Failure getting int value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRId32, value), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_LONG:
+    {
+        int64_t value;
+        if (amqpvalue_get_long(amqp_value, &value) != 0)
+        {
+            LogError("Failure getting long value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRId64, value), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_FLOAT:
+    {
+        float float_value;
+        if (amqpvalue_get_float(amqp_value, &float_value) != 0)
+        {
+            LogError("Failure getting float value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%.02f", float_value), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_DOUBLE:
+    {
+        double double_value;
+        if (amqpvalue_get_double(amqp_value, &double_value) != 0)
+        {
+            LogError("Failure getting double value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%.02lf", double_value), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_CHAR:
+    {
+        uint32_t char_code;
+        if (amqpvalue_get_char(amqp_value, &char_code) != 0)
+        {
+            LogError("Failure getting char value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "U%02X%02X%02X%02X", char_code >> 24, (char_code >> 16) & 0xFF, (char_code >> 8) & 0xFF, char_code & 0xFF), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_TIMESTAMP:
+    {
+        int64_t value;
+        if (amqpvalue_get_timestamp(amqp_value, &value) != 0)
+        {
+            LogError("Failure getting timestamp value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_formatted(builder, snprintf(str_value, sizeof(str_value), "%" PRId64, value), str_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_UUID:
+    {
+        uuid uuid_value;
+        if (amqpvalue_get_uuid(amqp_value, &uuid_value) != 0)
+        {
+            LogError("Failure getting uuid value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            char* uuid_string_value = UUID_to_string(&uuid_value);
+            if (uuid_string_value == NULL)
             {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
+                LogError("Failure getting UUID stringified value");
+                result = __FAILURE__;
             }
             else
             {
-                uint32_t i;
-                for (i = 0; i < count; i++)
-                {
-                    AMQP_VALUE key;
-                    AMQP_VALUE value;
-                    if (amqpvalue_get_map_key_value_pair(amqp_value, i, &key, &value) != 0)
-                    {
-                        LogError("Failure getting key/value pair index %u", (unsigned int)i);
-                        break;
-                    }
-                    else
-                    {
-                        char* key_string = amqpvalue_to_string(key);
-                        if (key_string == NULL)
-                        {
-                            LogError("Failure getting stringified key value for index %u", (unsigned int)i);
-                            amqpvalue_destroy(key);
-                            amqpvalue_destroy(value);
-                            break;
-                        }
-                        else
-                        {
-                            char* value_string = amqpvalue_to_string(value);
-                            if (key_string == NULL)
-                            {
-                                LogError("Failure getting stringified value for index %u", (unsigned int)i);
-                                free(key_string);
-                                amqpvalue_destroy(key);
-                                amqpvalue_destroy(value);
-                                break;
-                            }
-                            else
-                            {
-                                if (((i > 0) && (string_concat(&result, ",") != 0)) ||
-                                    (string_concat(&result, "[") != 0) ||
-                                    (string_concat(&result, key_string) != 0) ||
-                                    (string_concat(&result, ":") != 0) ||
-                                    (string_concat(&result, value_string) != 0) ||
-                                    (string_concat(&result, "]") != 0))
-                                {
-                                    LogError("Failure building amqp value string");
-                                    free(key_string);
-                                    free(value_string);
-                                    amqpvalue_destroy(key);
-                                    amqpvalue_destroy(value);
-                                    break;
-                                }
-
-                                free(value_string);
-                            }
-
-                            free(key_string);
-                        }
-
-                        amqpvalue_destroy(key);
-                        amqpvalue_destroy(value);
-                    }
-                }
-
-                if (i < count)
-                {
-                    // no log here, we already logged the error
-                    free(result);
-                    result = NULL;
-                }
-                else if (string_concat(&result, "}") != 0)
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
+                result = append_string(builder, uuid_string_value);
+                free(uuid_string_value);
             }
-            break;
         }
-        case AMQP_TYPE_ARRAY:
+        break;
+    }
+    case AMQP_TYPE_BINARY:
+    {
+        amqp_binary binary_value;
+        if (amqpvalue_get_binary(amqp_value, &binary_value) != 0)
         {
-            uint32_t count;
-            if (amqpvalue_get_array_item_count(amqp_value, &count) != 0)
-            {
-                LogError("Failure getting array item count");
-                free(result);
-                result = NULL;
-            }
-            else if (string_concat(&result, "{") != 0)
-            {
-                LogError("Failure building amqp value string");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                uint32_t i;
-                for (i = 0; i < count; i++)
-                {
-                    AMQP_VALUE item = amqpvalue_get_array_item(amqp_value, i);
-                    if (item == NULL)
-                    {
-                        LogError("Failure getting array item for index %u", (unsigned int)i);
-                        break;
-                    }
-                    else
-                    {
-                        char* item_string = amqpvalue_to_string(item);
-                        if (item_string == NULL)
-                        {
-                            LogError("Failure getting stringified array item value for index %u", (unsigned int)i);
-                            amqpvalue_destroy(item);
-                            break;
-                        }
-                        else
-                        {
-                            if (((i > 0) && (string_concat(&result, ",") != 0)) ||
-                                 (string_concat(&result, item_string) != 0))
-                            {
-                                LogError("Failure building amqp value string");
-                                free(result);
-                                result = NULL;
-                                break;
-                            }
-
-                            free(item_string);
-                        }
-
-                        amqpvalue_destroy(item);
-                    }
-                }
+            LogError("Failure getting binary value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = write_binary(builder, &binary_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_STRING:
+    {
+        const char* string_value;
+        if (amqpvalue_get_string(amqp_value, &string_value) != 0)
+        {
+            LogError("Failure getting string value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_string(builder, string_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_SYMBOL:
+    {
+        const char* string_value;
+        if (amqpvalue_get_symbol(amqp_value, &string_value) != 0)
+        {
+            LogError("Failure getting symbol value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = append_string(builder, string_value);
+        }
+        break;
+    }
+    case AMQP_TYPE_LIST:
+        result = write_list(builder, amqp_value);
+        break;
 
-                if (i < count)
-                {
-                    // no log here, we already logged the error
-                    free(result);
-                    result = NULL;
-                }
-                else if (string_concat(&result, "}") != 0)
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-            }
-            break;
+    case AMQP_TYPE_MAP:
+        result = write_map(builder, amqp_value);
+        break;
+
+    case AMQP_TYPE_ARRAY:
+        result = write_array(builder, amqp_value);
+        break;
+
+    case AMQP_TYPE_COMPOSITE:
+    case AMQP_TYPE_DESCRIBED:
+    {
+        AMQP_VALUE described_value = amqpvalue_get_inplace_described_value(amqp_value);
+        if (described_value == NULL)
+        {
+            LogError("Failure getting described value");
+            result = __FAILURE__;
         }
-        case AMQP_TYPE_COMPOSITE:
-        case AMQP_TYPE_DESCRIBED:
+        else if ((append_bytes(builder, "* ", 2) != 0) ||
+            (write_value(builder, described_value) != 0))
         {
-            AMQP_VALUE described_value = amqpvalue_get_inplace_described_value(amqp_value);
-            if (described_value == NULL)
-            {
-                LogError("Failure getting described value");
-                free(result);
-                result = NULL;
-            }
-            else
+            LogError("Failure getting stringified described value");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+        break;
+    }
+    }
+
+    return result;
+}
+
+static char* value_to_string(AMQP_VALUE amqp_value, size_t max_length)
+{
+    char* result;
+    STRING_BUILDER builder;
+    size_t encoded_size;
+
+    builder.buffer = NULL;
+    builder.length = 0;
+    builder.capacity = 0;
+    builder.max_length = max_length;
+    builder.is_truncated = false;
+
+    /* the encoded size is a cheap estimate of the text size (binaries take 3 characters per byte), so most values need a single allocation */
+    if ((amqpvalue_get_encoded_size(amqp_value, &encoded_size) != 0) ||
+        (encoded_size > (SIZE_MAX / 4)))
+    {
+        encoded_size = DEFAULT_INITIAL_CAPACITY;
+    }
+    else
+    {
+        encoded_size = (encoded_size * 3) + 1;
+    }
+
+    if (encoded_size > max_length)
+    {
+        encoded_size = max_length + 1;
+    }
+
+    if (ensure_capacity(&builder, encoded_size) != 0)
+    {
+        result = NULL;
+    }
+    else if (write_value(&builder, amqp_value) != 0)
+    {
+        LogError("Failure building amqp value string");
+        free(builder.buffer);
+        result = NULL;
+    }
+    else
+    {
+        if (builder.is_truncated)
+        {
+            /* a max_length shorter than the marker still gets as much of the marker as fits */
+            size_t marker_length = sizeof(TRUNCATION_MARKER) - 1;
+            if (marker_length > builder.length)
             {
-                if (string_concat(&result, "* ") != 0)
-                {
-                    LogError("Failure building amqp value string");
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    char* described_value_string = amqpvalue_to_string(described_value);
-                    if (described_value_string == NULL)
-                    {
-                        LogError("Failure getting stringified described value");
-                        free(result);
-                        result = NULL;
-                    }
-                    else
-                    {
-                        if (string_concat(&result, described_value_string) != 0)
-                        {
-                            LogError("Failure building amqp value string");
-                            free(result);
-                            result = NULL;
-                        }
-
-                        free(described_value_string);
-                    }
-                }
+                marker_length = builder.length;
             }
-            break;
-        }
+
+            (void)memcpy(builder.buffer + builder.length - marker_length, TRUNCATION_MARKER, marker_length);
         }
+
+        builder.buffer[builder.length] = '\0';
+        result = builder.buffer;
+    }
+
+    return result;
+}
+
+char* amqpvalue_to_string(AMQP_VALUE amqp_value)
+{
+    char* result;
+
+    if (amqp_value == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = value_to_string(amqp_value, SIZE_MAX - 1);
+    }
+
+    return result;
+}
+
+char* amqpvalue_to_string_n(AMQP_VALUE amqp_value, size_t max_length)
+{
+    char* result;
+
+    if ((amqp_value == NULL) ||
+        (max_length == 0))
+    {
+        LogError("Bad arguments: amqp_value = %p, max_length = %u",
+            amqp_value, (unsigned int)max_length);
+        result = NULL;
+    }
+    else
+    {
+        result = value_to_string(amqp_value, max_length);
     }
 
     return result;
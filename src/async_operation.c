@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
+#include <stdbool.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
@@ -15,6 +16,66 @@ typedef struct ASYNC_OPERATION_INSTANCE_TAG
     ASYNC_OPERATION_CANCEL_HANDLER_FUNC async_operation_cancel_handler;
 } ASYNC_OPERATION_INSTANCE;
 
+/* Every operation is preceded by a header saying which pool it goes back to, NULL for operations that are freed.
+   While a pooled block is free the header links it to the next free block instead. The union keeps the operation
+   that follows the header aligned for any context. */
+typedef union ASYNC_OPERATION_HEADER_TAG
+{
+    struct ASYNC_OPERATION_POOL_INSTANCE_TAG* pool;
+    union ASYNC_OPERATION_HEADER_TAG* next_free_block;
+    uint64_t uint64_alignment;
+    double double_alignment;
+    void* pointer_alignment;
+} ASYNC_OPERATION_HEADER;
+
+typedef struct ASYNC_OPERATION_POOL_INSTANCE_TAG
+{
+    size_t context_size;
+    size_t max_free_count;
+    size_t free_count;
+    size_t outstanding_count;
+    ASYNC_OPERATION_HEADER* free_blocks;
+    bool is_destroyed;
+} ASYNC_OPERATION_POOL_INSTANCE;
+
+static ASYNC_OPERATION_INSTANCE* operation_from_header(ASYNC_OPERATION_HEADER* header)
+{
+    return (ASYNC_OPERATION_INSTANCE*)(header + 1);
+}
+
+static ASYNC_OPERATION_HEADER* header_from_operation(ASYNC_OPERATION_INSTANCE* async_operation)
+{
+    return ((ASYNC_OPERATION_HEADER*)async_operation) - 1;
+}
+
+static void release_to_pool(ASYNC_OPERATION_POOL_INSTANCE* pool, ASYNC_OPERATION_HEADER* header)
+{
+    pool->outstanding_count--;
+
+    if (pool->is_destroyed)
+    {
+        /* Codes_SRS_ASYNC_OPERATION_01_022: [ When the last operation of a destroyed pool is destroyed, the pool itself shall be freed. ]*/
+        free(header);
+
+        if (pool->outstanding_count == 0)
+        {
+            free(pool);
+        }
+    }
+    else if (pool->free_count < pool->max_free_count)
+    {
+        /* Codes_SRS_ASYNC_OPERATION_01_018: [ Destroying an operation created from a pool shall keep its memory in the pool for the next `async_operation_create_from_pool`, as long as the pool holds less than `max_free_count` free blocks. ]*/
+        header->next_free_block = pool->free_blocks;
+        pool->free_blocks = header;
+        pool->free_count++;
+    }
+    else
+    {
+        /* Codes_SRS_ASYNC_OPERATION_01_019: [ When the pool already holds `max_free_count` free blocks, destroying an operation created from it shall free its memory. ]*/
+        free(header);
+    }
+}
+
 ASYNC_OPERATION_HANDLE async_operation_create(ASYNC_OPERATION_CANCEL_HANDLER_FUNC async_operation_cancel_handler, size_t context_size)
 {
     ASYNC_OPERATION_INSTANCE* async_operation;
@@ -33,15 +94,18 @@ ASYNC_OPERATION_HANDLE async_operation_create(ASYNC_OPERATION_CANCEL_HANDLER_FUN
     }
     else
     {
-        async_operation = (ASYNC_OPERATION_INSTANCE*)malloc(context_size);
-        if (async_operation == NULL)
+        ASYNC_OPERATION_HEADER* header = (ASYNC_OPERATION_HEADER*)malloc(sizeof(ASYNC_OPERATION_HEADER) + context_size);
+        if (header == NULL)
         {
             /* Codes_SRS_ASYNC_OPERATION_01_004: [ If allocating memory for the new asynchronous operation instance fails, `async_operation_create` shall fail and return NULL.]*/
             LogError("Cannot allocate memory for async operation");
+            async_operation = NULL;
         }
         else
         {
             /* Codes_SRS_ASYNC_OPERATION_01_001: [ `async_operation_create` shall return a non-NULL handle to a newly created asynchronous operation instance.]*/
+            header->pool = NULL;
+            async_operation = operation_from_header(header);
             async_operation->async_operation_cancel_handler = async_operation_cancel_handler;
         }
     }
@@ -58,8 +122,17 @@ void async_operation_destroy(ASYNC_OPERATION_HANDLE async_operation)
     }
     else
     {
-        /* Codes_SRS_ASYNC_OPERATION_01_005: [ `async_operation_destroy` shall free all recources associated with the asyncronous operation instance.]*/
-        free(async_operation);
+        ASYNC_OPERATION_HEADER* header = header_from_operation(async_operation);
+
+        if (header->pool != NULL)
+        {
+            release_to_pool(header->pool, header);
+        }
+        else
+        {
+            /* Codes_SRS_ASYNC_OPERATION_01_005: [ `async_operation_destroy` shall free all recources associated with the asyncronous operation instance.]*/
+            free(header);
+        }
     }
 }
 
@@ -83,3 +156,138 @@ int async_operation_cancel(ASYNC_OPERATION_HANDLE async_operation)
 
     return result;
 }
+
+ASYNC_OPERATION_POOL_HANDLE async_operation_pool_create(size_t context_size, size_t max_free_count)
+{
+    ASYNC_OPERATION_POOL_INSTANCE* result;
+
+    if (context_size < sizeof(ASYNC_OPERATION_INSTANCE))
+    {
+        /* Codes_SRS_ASYNC_OPERATION_01_011: [ If `context_size` is less than the size of the cancel handler, `async_operation_pool_create` shall fail and return NULL. ]*/
+        LogError("Context size too small");
+        result = NULL;
+    }
+    else
+    {
+        result = (ASYNC_OPERATION_POOL_INSTANCE*)malloc(sizeof(ASYNC_OPERATION_POOL_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_ASYNC_OPERATION_01_012: [ If allocating memory for the pool fails, `async_operation_pool_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for async operation pool");
+        }
+        else
+        {
+            /* Codes_SRS_ASYNC_OPERATION_01_010: [ `async_operation_pool_create` shall create a pool of asynchronous operations of `context_size` bytes that keeps up to `max_free_count` of them for reuse, and return a non-NULL handle to it. ]*/
+            result->context_size = context_size;
+            result->max_free_count = max_free_count;
+            result->free_count = 0;
+            result->outstanding_count = 0;
+            result->free_blocks = NULL;
+            result->is_destroyed = false;
+
+#ifdef UAMQP_STATIC_POOLS
+            /* Codes_SRS_ASYNC_OPERATION_01_023: [ When built with UAMQP_STATIC_POOLS, `async_operation_pool_create` shall allocate its `max_free_count` free blocks up front, and fail and return NULL if it cannot. ]*/
+            while (result->free_count < max_free_count)
+            {
+                ASYNC_OPERATION_HEADER* header = (ASYNC_OPERATION_HEADER*)malloc(sizeof(ASYNC_OPERATION_HEADER) + context_size);
+                if (header == NULL)
+                {
+                    break;
+                }
+
+                header->next_free_block = result->free_blocks;
+                result->free_blocks = header;
+                result->free_count++;
+            }
+
+            if (result->free_count < max_free_count)
+            {
+                LogError("Cannot allocate the free blocks of the async operation pool");
+                async_operation_pool_destroy(result);
+                result = NULL;
+            }
+#endif
+        }
+    }
+
+    return result;
+}
+
+void async_operation_pool_destroy(ASYNC_OPERATION_POOL_HANDLE async_operation_pool)
+{
+    if (async_operation_pool == NULL)
+    {
+        /* Codes_SRS_ASYNC_OPERATION_01_020: [ If `async_operation_pool` is NULL, `async_operation_pool_destroy` shall do nothing. ]*/
+        LogError("NULL async_operation_pool");
+    }
+    else
+    {
+        /* Codes_SRS_ASYNC_OPERATION_01_021: [ `async_operation_pool_destroy` shall free the free blocks of the pool, and the pool itself once no operation created from it is left. ]*/
+        while (async_operation_pool->free_blocks != NULL)
+        {
+            ASYNC_OPERATION_HEADER* next_free_block = async_operation_pool->free_blocks->next_free_block;
+            free(async_operation_pool->free_blocks);
+            async_operation_pool->free_blocks = next_free_block;
+        }
+
+        async_operation_pool->free_count = 0;
+
+        if (async_operation_pool->outstanding_count == 0)
+        {
+            free(async_operation_pool);
+        }
+        else
+        {
+            /* operations still held by their owners go back to a destroyed pool, the last one frees it */
+            async_operation_pool->is_destroyed = true;
+        }
+    }
+}
+
+ASYNC_OPERATION_HANDLE async_operation_create_from_pool(ASYNC_OPERATION_POOL_HANDLE async_operation_pool, ASYNC_OPERATION_CANCEL_HANDLER_FUNC async_operation_cancel_handler)
+{
+    ASYNC_OPERATION_INSTANCE* async_operation;
+
+    if ((async_operation_pool == NULL) ||
+        (async_operation_cancel_handler == NULL))
+    {
+        /* Codes_SRS_ASYNC_OPERATION_01_014: [ If `async_operation_pool` or `async_operation_cancel_handler` is NULL, `async_operation_create_from_pool` shall fail and return NULL. ]*/
+        LogError("Bad arguments: async_operation_pool = %p, async_operation_cancel_handler = %p",
+            async_operation_pool, async_operation_cancel_handler);
+        async_operation = NULL;
+    }
+    else
+    {
+        ASYNC_OPERATION_HEADER* header;
+
+        if (async_operation_pool->free_blocks != NULL)
+        {
+            /* Codes_SRS_ASYNC_OPERATION_01_015: [ `async_operation_create_from_pool` shall reuse a free block of the pool when it has one, without allocating memory. ]*/
+            header = async_operation_pool->free_blocks;
+            async_operation_pool->free_blocks = header->next_free_block;
+            async_operation_pool->free_count--;
+        }
+        else
+        {
+            /* Codes_SRS_ASYNC_OPERATION_01_016: [ Otherwise `async_operation_create_from_pool` shall allocate memory for a new operation of the context size of the pool. ]*/
+            header = (ASYNC_OPERATION_HEADER*)malloc(sizeof(ASYNC_OPERATION_HEADER) + async_operation_pool->context_size);
+        }
+
+        if (header == NULL)
+        {
+            /* Codes_SRS_ASYNC_OPERATION_01_017: [ If allocating memory for the operation fails, `async_operation_create_from_pool` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for async operation");
+            async_operation = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_ASYNC_OPERATION_01_013: [ `async_operation_create_from_pool` shall return a non-NULL handle to an asynchronous operation that is destroyed with `async_operation_destroy` and cancelled with `async_operation_cancel` like any other. ]*/
+            header->pool = async_operation_pool;
+            async_operation_pool->outstanding_count++;
+            async_operation = operation_from_header(header);
+            async_operation->async_operation_cancel_handler = async_operation_cancel_handler;
+        }
+    }
+
+    return async_operation;
+}
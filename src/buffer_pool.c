@@ -0,0 +1,307 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/buffer_pool.h"
+
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+/* buffers start on a cache line so that two of them never share one */
+#define BUFFER_ALIGNMENT 64
+
+typedef struct FREE_BUFFER_TAG
+{
+    struct FREE_BUFFER_TAG* next;
+} FREE_BUFFER;
+
+typedef struct BUFFER_POOL_INSTANCE_TAG
+{
+    unsigned char* region;
+    size_t region_size;
+    size_t buffer_size;
+    size_t buffer_stride;
+    size_t buffer_count;
+    /* kept in the free buffers themselves, so the pool does not need memory of its own for them */
+    FREE_BUFFER* free_buffers;
+    bool is_huge_page_backed;
+    bool is_mapped;
+} BUFFER_POOL_INSTANCE;
+
+static size_t round_up(size_t size, size_t alignment)
+{
+    return ((size + alignment - 1) / alignment) * alignment;
+}
+
+static void map_region(BUFFER_POOL_INSTANCE* buffer_pool, size_t size, bool use_huge_pages)
+{
+    buffer_pool->region = NULL;
+    buffer_pool->is_huge_page_backed = false;
+    buffer_pool->is_mapped = false;
+
+#ifdef _WIN32
+    if (use_huge_pages)
+    {
+        SIZE_T large_page_size = GetLargePageMinimum();
+
+        /* 0 when the processor has no large pages */
+        if (large_page_size != 0)
+        {
+            size_t huge_size = round_up(size, (size_t)large_page_size);
+
+            buffer_pool->region = (unsigned char*)VirtualAlloc(NULL, huge_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (buffer_pool->region != NULL)
+            {
+                buffer_pool->region_size = huge_size;
+                buffer_pool->is_huge_page_backed = true;
+            }
+        }
+
+        if (buffer_pool->region == NULL)
+        {
+            LogInfo("Cannot get large pages for the buffer pool (SeLockMemoryPrivilege is needed), using normal pages");
+        }
+    }
+
+    if (buffer_pool->region == NULL)
+    {
+        buffer_pool->region = (unsigned char*)VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        buffer_pool->region_size = size;
+    }
+
+    buffer_pool->is_mapped = (buffer_pool->region != NULL);
+#elif defined(__linux__)
+    void* region;
+
+    if (use_huge_pages)
+    {
+        size_t huge_size = round_up(size, HUGE_PAGE_SIZE);
+
+        region = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region == MAP_FAILED)
+        {
+            LogInfo("Cannot get huge pages for the buffer pool (see vm.nr_hugepages), using normal pages");
+        }
+        else
+        {
+            buffer_pool->region = (unsigned char*)region;
+            buffer_pool->region_size = huge_size;
+            buffer_pool->is_huge_page_backed = true;
+        }
+    }
+
+    if (buffer_pool->region == NULL)
+    {
+        region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region != MAP_FAILED)
+        {
+            buffer_pool->region = (unsigned char*)region;
+            buffer_pool->region_size = size;
+
+#ifdef MADV_HUGEPAGE
+            /* the kernel can still back the region with transparent huge pages, it is only a hint */
+            if (use_huge_pages)
+            {
+                (void)madvise(region, size, MADV_HUGEPAGE);
+            }
+#endif
+        }
+    }
+
+    buffer_pool->is_mapped = (buffer_pool->region != NULL);
+#else
+    (void)use_huge_pages;
+#endif
+
+    if (buffer_pool->region == NULL)
+    {
+        buffer_pool->region = (unsigned char*)malloc(size);
+        buffer_pool->region_size = size;
+    }
+}
+
+static void unmap_region(BUFFER_POOL_INSTANCE* buffer_pool)
+{
+    if (!buffer_pool->is_mapped)
+    {
+        free(buffer_pool->region);
+    }
+    else
+    {
+#ifdef _WIN32
+        (void)VirtualFree(buffer_pool->region, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        (void)munmap(buffer_pool->region, buffer_pool->region_size);
+#endif
+    }
+}
+
+BUFFER_POOL_HANDLE buffer_pool_create(size_t buffer_size, size_t buffer_count, bool use_huge_pages)
+{
+    BUFFER_POOL_INSTANCE* result;
+
+    /* Codes_SRS_BUFFER_POOL_01_002: [ If `buffer_size` or `buffer_count` is 0, or the size of the region would not fit in a `size_t`, `buffer_pool_create` shall fail and return NULL. ]*/
+    if ((buffer_size == 0) ||
+        (buffer_count == 0) ||
+        (buffer_size > SIZE_MAX - BUFFER_ALIGNMENT) ||
+        (round_up(buffer_size, BUFFER_ALIGNMENT) > (SIZE_MAX - HUGE_PAGE_SIZE) / buffer_count))
+    {
+        LogError("Bad arguments: buffer_size = %lu, buffer_count = %lu",
+            (unsigned long)buffer_size, (unsigned long)buffer_count);
+        result = NULL;
+    }
+    else
+    {
+        result = (BUFFER_POOL_INSTANCE*)malloc(sizeof(BUFFER_POOL_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_BUFFER_POOL_01_003: [ If allocating the pool or its region fails, `buffer_pool_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the buffer pool");
+        }
+        else
+        {
+            result->buffer_size = buffer_size;
+            result->buffer_stride = round_up(buffer_size, BUFFER_ALIGNMENT);
+            result->buffer_count = buffer_count;
+
+            /* Codes_SRS_BUFFER_POOL_01_004: [ When `use_huge_pages` is true, `buffer_pool_create` shall map the region with huge pages, and map it with normal pages when huge pages cannot be had. ]*/
+            /* Codes_SRS_BUFFER_POOL_01_005: [ Where the platform has no API to map memory, the region shall be allocated with `malloc`. ]*/
+            map_region(result, result->buffer_stride * buffer_count, use_huge_pages);
+            if (result->region == NULL)
+            {
+                /* Codes_SRS_BUFFER_POOL_01_003: [ If allocating the pool or its region fails, `buffer_pool_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate %lu bytes for the buffers", (unsigned long)(result->buffer_stride * buffer_count));
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                size_t i;
+
+                /* Codes_SRS_BUFFER_POOL_01_001: [ `buffer_pool_create` shall create a pool of `buffer_count` buffers of at least `buffer_size` bytes carved out of one region and on success return a non-NULL handle to it. ]*/
+                /* lowest addresses first, so that a lightly used pool stays on few pages */
+                result->free_buffers = NULL;
+                for (i = buffer_count; i > 0; i--)
+                {
+                    FREE_BUFFER* free_buffer = (FREE_BUFFER*)(result->region + ((i - 1) * result->buffer_stride));
+                    free_buffer->next = result->free_buffers;
+                    result->free_buffers = free_buffer;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void buffer_pool_destroy(BUFFER_POOL_HANDLE buffer_pool)
+{
+    if (buffer_pool == NULL)
+    {
+        /* Codes_SRS_BUFFER_POOL_01_007: [ If `buffer_pool` is NULL, `buffer_pool_destroy` shall do nothing. ]*/
+        LogError("NULL buffer_pool");
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_POOL_01_006: [ `buffer_pool_destroy` shall unmap or free the region and free the pool. ]*/
+        unmap_region(buffer_pool);
+        free(buffer_pool);
+    }
+}
+
+unsigned char* buffer_pool_get(BUFFER_POOL_HANDLE buffer_pool, size_t size)
+{
+    unsigned char* result;
+
+    if (buffer_pool == NULL)
+    {
+        /* Codes_SRS_BUFFER_POOL_01_009: [ If `buffer_pool` is NULL, `buffer_pool_get` shall fail and return NULL. ]*/
+        LogError("NULL buffer_pool");
+        result = NULL;
+    }
+    else if ((size > buffer_pool->buffer_size) ||
+        (buffer_pool->free_buffers == NULL))
+    {
+        /* Codes_SRS_BUFFER_POOL_01_010: [ If `size` is bigger than the buffer size of the pool or all the buffers are in use, `buffer_pool_get` shall return NULL. ]*/
+        /* not logged, the caller is expected to fall back to the heap */
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_POOL_01_008: [ `buffer_pool_get` shall take a free buffer out of the pool and return it. ]*/
+        result = (unsigned char*)buffer_pool->free_buffers;
+        buffer_pool->free_buffers = buffer_pool->free_buffers->next;
+    }
+
+    return result;
+}
+
+void buffer_pool_release(BUFFER_POOL_HANDLE buffer_pool, unsigned char* buffer)
+{
+    if ((buffer_pool == NULL) ||
+        (buffer == NULL))
+    {
+        /* Codes_SRS_BUFFER_POOL_01_012: [ If `buffer_pool` or `buffer` is NULL, `buffer_pool_release` shall do nothing. ]*/
+        LogError("Bad arguments: buffer_pool = %p, buffer = %p", buffer_pool, buffer);
+    }
+    else if ((buffer < buffer_pool->region) ||
+        (buffer >= buffer_pool->region + (buffer_pool->buffer_stride * buffer_pool->buffer_count)) ||
+        (((size_t)(buffer - buffer_pool->region) % buffer_pool->buffer_stride) != 0))
+    {
+        /* Codes_SRS_BUFFER_POOL_01_013: [ If `buffer` was not obtained from `buffer_pool`, `buffer_pool_release` shall do nothing. ]*/
+        LogError("Buffer %p does not belong to the buffer pool", buffer);
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_POOL_01_011: [ `buffer_pool_release` shall give `buffer` back to the pool, most recently released buffers being handed out first. ]*/
+        FREE_BUFFER* free_buffer = (FREE_BUFFER*)buffer;
+        free_buffer->next = buffer_pool->free_buffers;
+        buffer_pool->free_buffers = free_buffer;
+    }
+}
+
+size_t buffer_pool_get_buffer_size(BUFFER_POOL_HANDLE buffer_pool)
+{
+    size_t result;
+
+    if (buffer_pool == NULL)
+    {
+        /* Codes_SRS_BUFFER_POOL_01_017: [ If `buffer_pool` is NULL, `buffer_pool_get_buffer_size` shall return 0. ]*/
+        LogError("NULL buffer_pool");
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_POOL_01_016: [ `buffer_pool_get_buffer_size` shall return the `buffer_size` passed to `buffer_pool_create`. ]*/
+        result = buffer_pool->buffer_size;
+    }
+
+    return result;
+}
+
+bool buffer_pool_is_huge_page_backed(BUFFER_POOL_HANDLE buffer_pool)
+{
+    bool result;
+
+    if (buffer_pool == NULL)
+    {
+        /* Codes_SRS_BUFFER_POOL_01_015: [ If `buffer_pool` is NULL, `buffer_pool_is_huge_page_backed` shall return false. ]*/
+        LogError("NULL buffer_pool");
+        result = false;
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_POOL_01_014: [ `buffer_pool_is_huge_page_backed` shall return whether the region was mapped with huge pages. ]*/
+        result = buffer_pool->is_huge_page_backed;
+    }
+
+    return result;
+}
@@ -11,6 +11,7 @@
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_uamqp_c/cbs.h"
 #include "azure_uamqp_c/amqp_management.h"
+#include "azure_uamqp_c/amqp_management_mux.h"
 #include "azure_uamqp_c/session.h"
 
 typedef enum CBS_STATE_TAG
@@ -30,7 +31,10 @@ typedef struct CBS_OPERATION_TAG
 
 typedef struct CBS_INSTANCE_TAG
 {
+    /* exactly one of amqp_management and amqp_management_mux_client is set */
     AMQP_MANAGEMENT_HANDLE amqp_management;
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux;
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE amqp_management_mux_client;
     CBS_STATE cbs_state;
     ON_CBS_OPEN_COMPLETE on_cbs_open_complete;
     void* on_cbs_open_complete_context;
@@ -81,6 +85,56 @@ static int add_string_key_value_pair_to_map(AMQP_VALUE map, const char* key, con
     return result;
 }
 
+static int close_underlying_amqp_management(CBS_INSTANCE* cbs)
+{
+    int result;
+
+    if (cbs->amqp_management_mux_client != NULL)
+    {
+        result = amqp_management_mux_client_close(cbs->amqp_management_mux_client);
+    }
+    else
+    {
+        result = amqp_management_close(cbs->amqp_management);
+    }
+
+    return result;
+}
+
+static int execute_underlying_amqp_management_operation(CBS_INSTANCE* cbs, const char* operation, const char* type, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* context)
+{
+    int result;
+
+    if (cbs->amqp_management_mux_client != NULL)
+    {
+        /* Codes_SRS_CBS_01_124: [ A CBS instance created with `cbs_create_with_management_mux` shall open, close and execute operations through its mux client by calling `amqp_management_mux_client_open_async`, `amqp_management_mux_client_close` and `amqp_management_mux_client_execute_operation_async` instead of the AMQP management functions. ]*/
+        result = amqp_management_mux_client_execute_operation_async(cbs->amqp_management_mux_client, operation, type, NULL, message, on_execute_operation_complete, context);
+    }
+    else
+    {
+        result = amqp_management_execute_operation_async(cbs->amqp_management, operation, type, NULL, message, on_execute_operation_complete, context);
+    }
+
+    return result;
+}
+
+static int execute_underlying_prepared_operation(CBS_INSTANCE* cbs, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* context)
+{
+    int result;
+
+    if (cbs->amqp_management_mux_client != NULL)
+    {
+        /* Codes_SRS_CBS_01_134: [ A CBS instance created with `cbs_create_with_management_mux` shall execute the prepared operation through its mux client by calling `amqp_management_mux_client_execute_prepared_operation_async`. ]*/
+        result = amqp_management_mux_client_execute_prepared_operation_async(cbs->amqp_management_mux_client, prepared_operation, message, on_execute_operation_complete, context);
+    }
+    else
+    {
+        result = amqp_management_execute_prepared_operation_async(cbs->amqp_management, prepared_operation, message, on_execute_operation_complete, context);
+    }
+
+    return result;
+}
+
 static void on_underlying_amqp_management_open_complete(void* context, AMQP_MANAGEMENT_OPEN_RESULT open_result)
 {
     if (context == NULL)
@@ -120,7 +174,7 @@ static void on_underlying_amqp_management_open_complete(void* context, AMQP_MANA
             case AMQP_MANAGEMENT_OPEN_ERROR:
                 cbs->cbs_state = CBS_STATE_CLOSED;
                 /* Codes_SRS_CBS_01_113: [ When `on_amqp_management_open_complete` reports a failure, the underlying AMQP management shall be closed by calling `amqp_management_close`. ]*/
-                (void)amqp_management_close(cbs->amqp_management);
+                (void)close_underlying_amqp_management(cbs);
                 /* Codes_SRS_CBS_01_107: [ If CBS is OPENING and `open_result` is `AMQP_MANAGEMENT_OPEN_ERROR` the callback `on_cbs_open_complete` shall be called with `CBS_OPEN_ERROR` and the `on_cbs_open_complete_context` shall be passed as argument. ]*/
                 cbs->on_cbs_open_complete(cbs->on_cbs_open_complete_context, CBS_OPEN_ERROR);
                 break;
@@ -128,7 +182,7 @@ static void on_underlying_amqp_management_open_complete(void* context, AMQP_MANA
             case AMQP_MANAGEMENT_OPEN_CANCELLED:
                 cbs->cbs_state = CBS_STATE_CLOSED;
                 /* Codes_SRS_CBS_01_113: [ When `on_amqp_management_open_complete` reports a failure, the underlying AMQP management shall be closed by calling `amqp_management_close`. ]*/
-                (void)amqp_management_close(cbs->amqp_management);
+                (void)close_underlying_amqp_management(cbs);
                 /* Codes_SRS_CBS_01_108: [ If CBS is OPENING and `open_result` is `AMQP_MANAGEMENT_OPEN_CANCELLED` the callback `on_cbs_open_complete` shall be called with `CBS_OPEN_CANCELLED` and the `on_cbs_open_complete_context` shall be passed as argument. ]*/
                 cbs->on_cbs_open_complete(cbs->on_cbs_open_complete_context, CBS_OPEN_CANCELLED);
                 break;
@@ -169,7 +223,7 @@ static void on_underlying_amqp_management_error(void* context)
         case CBS_STATE_OPENING:
             cbs->cbs_state = CBS_STATE_CLOSED;
             /* Codes_SRS_CBS_01_114: [ Additionally the underlying AMQP management shall be closed by calling `amqp_management_close`. ]*/
-            (void)amqp_management_close(cbs->amqp_management);
+            (void)close_underlying_amqp_management(cbs);
             /* Codes_SRS_CBS_01_111: [ If CBS is OPENING the callback `on_cbs_open_complete` shall be called with `CBS_OPEN_ERROR` and the `on_cbs_open_complete_context` shall be passed as argument. ]*/
             cbs->on_cbs_open_complete(cbs->on_cbs_open_complete_context, CBS_OPEN_ERROR);
             break;
@@ -286,6 +340,8 @@ CBS_HANDLE cbs_create(SESSION_HANDLE session)
                 /* Codes_SRS_CBS_01_034: [ `cbs_create` shall create an AMQP management handle by calling `amqp_management_create`. ]*/
                 /* Codes_SRS_CBS_01_002: [ Tokens are communicated between AMQP peers by sending specially-formatted AMQP messages to the Claims-based Security Node. ]*/
                 /* Codes_SRS_CBS_01_003: [ The mechanism follows the scheme defined in the AMQP Management specification [AMQPMAN]. ]*/
+                cbs->amqp_management_mux = NULL;
+                cbs->amqp_management_mux_client = NULL;
                 cbs->amqp_management = amqp_management_create(session, "$cbs");
                 if (cbs->amqp_management == NULL)
                 {
@@ -331,6 +387,73 @@ all_ok:
     return cbs;
 }
 
+CBS_HANDLE cbs_create_with_management_mux(AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux)
+{
+    CBS_INSTANCE* cbs;
+
+    if (amqp_management_mux == NULL)
+    {
+        /* Codes_SRS_CBS_01_120: [ If `amqp_management_mux` is NULL then `cbs_create_with_management_mux` shall fail and return NULL. ]*/
+        LogError("NULL amqp_management_mux");
+        cbs = NULL;
+    }
+    else
+    {
+        cbs = (CBS_INSTANCE*)malloc(sizeof(CBS_INSTANCE));
+        if (cbs == NULL)
+        {
+            /* Codes_SRS_CBS_01_123: [ If any error occurs, `cbs_create_with_management_mux` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for cbs instance.");
+        }
+        else
+        {
+            cbs->pending_operations = singlylinkedlist_create();
+            if (cbs->pending_operations == NULL)
+            {
+                /* Codes_SRS_CBS_01_123: [ If any error occurs, `cbs_create_with_management_mux` shall fail and return NULL. ]*/
+                LogError("Cannot allocate pending operations list.");
+            }
+            else
+            {
+                /* Codes_SRS_CBS_01_122: [ `cbs_create_with_management_mux` shall set the override status code and status description key names on the mux to `status-code` and `status-description` by calling `amqp_management_mux_set_override_status_code_key_name` and `amqp_management_mux_set_override_status_description_key_name`. ]*/
+                if ((amqp_management_mux_set_override_status_code_key_name(amqp_management_mux, "status-code") != 0) ||
+                    (amqp_management_mux_set_override_status_description_key_name(amqp_management_mux, "status-description") != 0))
+                {
+                    /* Codes_SRS_CBS_01_123: [ If any error occurs, `cbs_create_with_management_mux` shall fail and return NULL. ]*/
+                    LogError("Cannot set the override key names");
+                }
+                else
+                {
+                    /* Codes_SRS_CBS_01_121: [ `cbs_create_with_management_mux` shall create a client of the mux by calling `amqp_management_mux_client_create`. ]*/
+                    cbs->amqp_management_mux_client = amqp_management_mux_client_create(amqp_management_mux);
+                    if (cbs->amqp_management_mux_client == NULL)
+                    {
+                        /* Codes_SRS_CBS_01_123: [ If any error occurs, `cbs_create_with_management_mux` shall fail and return NULL. ]*/
+                        LogError("Cannot create AMQP management mux client");
+                    }
+                    else
+                    {
+                        /* Codes_SRS_CBS_01_119: [ `cbs_create_with_management_mux` shall create a new CBS instance sending its operations over the links shared by `amqp_management_mux` and on success return a non-NULL handle to it. ]*/
+                        cbs->amqp_management = NULL;
+                        cbs->amqp_management_mux = amqp_management_mux;
+                        cbs->cbs_state = CBS_STATE_CLOSED;
+
+                        goto all_ok;
+                    }
+                }
+
+                singlylinkedlist_destroy(cbs->pending_operations);
+            }
+
+            free(cbs);
+            cbs = NULL;
+        }
+    }
+
+all_ok:
+    return cbs;
+}
+
 void cbs_destroy(CBS_HANDLE cbs)
 {
     if (cbs == NULL)
@@ -345,12 +468,20 @@ void cbs_destroy(CBS_HANDLE cbs)
         /* Codes_SRS_CBS_01_100: [ If the CBS instance is not closed, all actions performed by `cbs_close` shall be performed. ]*/
         if (cbs->cbs_state != CBS_STATE_CLOSED)
         {
-            (void)amqp_management_close(cbs->amqp_management);
+            (void)close_underlying_amqp_management(cbs);
         }
 
         /* Codes_SRS_CBS_01_036: [ `cbs_destroy` shall free all resources associated with the handle `cbs`. ]*/
-        /* Codes_SRS_CBS_01_038: [ `cbs_destroy` shall free the AMQP management handle created in `cbs_create` by calling `amqp_management_destroy`. ]*/
-        amqp_management_destroy(cbs->amqp_management);
+        if (cbs->amqp_management_mux_client != NULL)
+        {
+            /* Codes_SRS_CBS_01_125: [ `cbs_destroy` shall free the mux client created in `cbs_create_with_management_mux` by calling `amqp_management_mux_client_destroy`. ]*/
+            amqp_management_mux_client_destroy(cbs->amqp_management_mux_client);
+        }
+        else
+        {
+            /* Codes_SRS_CBS_01_038: [ `cbs_destroy` shall free the AMQP management handle created in `cbs_create` by calling `amqp_management_destroy`. ]*/
+            amqp_management_destroy(cbs->amqp_management);
+        }
 
         /* Codes_SRS_CBS_01_099: [ All pending operations shall be freed. ]*/
         while ((first_pending_operation = singlylinkedlist_get_head_item(cbs->pending_operations)) != NULL)
@@ -371,6 +502,22 @@ void cbs_destroy(CBS_HANDLE cbs)
     }
 }
 
+static int open_underlying_amqp_management(CBS_INSTANCE* cbs)
+{
+    int result;
+
+    if (cbs->amqp_management_mux_client != NULL)
+    {
+        result = amqp_management_mux_client_open_async(cbs->amqp_management_mux_client, on_underlying_amqp_management_open_complete, cbs, on_underlying_amqp_management_error, cbs);
+    }
+    else
+    {
+        result = amqp_management_open_async(cbs->amqp_management, on_underlying_amqp_management_open_complete, cbs, on_underlying_amqp_management_error, cbs);
+    }
+
+    return result;
+}
+
 int cbs_open_async(CBS_HANDLE cbs, ON_CBS_OPEN_COMPLETE on_cbs_open_complete, void* on_cbs_open_complete_context, ON_CBS_ERROR on_cbs_error, void* on_cbs_error_context)
 {
     int result;
@@ -401,7 +548,7 @@ int cbs_open_async(CBS_HANDLE cbs, ON_CBS_OPEN_COMPLETE on_cbs_open_complete, vo
         cbs->on_cbs_error_context = on_cbs_error_context;
 
         /* Codes_SRS_CBS_01_039: [ `cbs_open_async` shall open the cbs communication by calling `amqp_management_open_async` on the AMQP management handle created in `cbs_create`. ]*/
-        if (amqp_management_open_async(cbs->amqp_management, on_underlying_amqp_management_open_complete, cbs, on_underlying_amqp_management_error, cbs) != 0)
+        if (open_underlying_amqp_management(cbs) != 0)
         {
             /* Codes_SRS_CBS_01_041: [ If `amqp_management_open_async` fails, shall fail and return a non-zero value. ]*/
             result = __FAILURE__;
@@ -436,7 +583,7 @@ int cbs_close(CBS_HANDLE cbs)
     else
     {
         /* Codes_SRS_CBS_01_044: [ `cbs_close` shall close the CBS instance by calling `amqp_management_close` on the underlying AMQP management handle. ]*/
-        if (amqp_management_close(cbs->amqp_management) != 0)
+        if (close_underlying_amqp_management(cbs) != 0)
         {
             /* Codes_SRS_CBS_01_046: [ If `amqp_management_close` fails, `cbs_close` shall fail and return a non-zero value. ]*/
             LogError("Failed closing AMQP management instance");
@@ -569,7 +716,7 @@ int cbs_put_token_async(CBS_HANDLE cbs, const char* type, const char* audience,
                                         /* Codes_SRS_CBS_01_005: [ operation    No    string    "put-token" ]*/
                                         /* Codes_SRS_CBS_01_006: [ Type    No    string    The type of the token being put, e.g., "amqp:jwt". ]*/
                                         /* Codes_SRS_CBS_01_007: [ name    No    string    The "audience" to which the token applies. ]*/
-                                        if (amqp_management_execute_operation_async(cbs->amqp_management, "put-token", type, NULL, message, on_amqp_management_execute_operation_complete, list_item) != 0)
+                                        if (execute_underlying_amqp_management_operation(cbs, "put-token", type, message, on_amqp_management_execute_operation_complete, list_item) != 0)
                                         {
                                             singlylinkedlist_remove(cbs->pending_operations, list_item);
                                             free(cbs_operation);
@@ -601,6 +748,148 @@ int cbs_put_token_async(CBS_HANDLE cbs, const char* type, const char* audience,
     return result;
 }
 
+AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE cbs_prepare_put_token(const char* type, const char* audience)
+{
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    if ((type == NULL) ||
+        (audience == NULL))
+    {
+        /* Codes_SRS_CBS_01_128: [ If `type` or `audience` is NULL, `cbs_prepare_put_token` shall fail and return NULL. ]*/
+        LogError("Bad arguments: type = %p, audience = %p", type, audience);
+        result = NULL;
+    }
+    else
+    {
+        AMQP_VALUE application_properties = amqpvalue_create_map();
+        if (application_properties == NULL)
+        {
+            /* Codes_SRS_CBS_01_129: [ If any API fails, `cbs_prepare_put_token` shall fail and return NULL. ]*/
+            LogError("Failed creating application properties map");
+            result = NULL;
+        }
+        else
+        {
+            if (add_string_key_value_pair_to_map(application_properties, "name", audience) != 0)
+            {
+                /* Codes_SRS_CBS_01_129: [ If any API fails, `cbs_prepare_put_token` shall fail and return NULL. ]*/
+                result = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_CBS_01_127: [ `cbs_prepare_put_token` shall prepare the `put-token` operation for `type` and `audience` by calling `amqp_management_prepare_operation` with `put-token`, `type`, NULL locales and an application properties map holding the `name` key with the `audience` value. ]*/
+                result = amqp_management_prepare_operation("put-token", type, NULL, application_properties);
+                if (result == NULL)
+                {
+                    /* Codes_SRS_CBS_01_129: [ If any API fails, `cbs_prepare_put_token` shall fail and return NULL. ]*/
+                    LogError("Failed preparing the put-token operation");
+                }
+            }
+
+            amqpvalue_destroy(application_properties);
+        }
+    }
+
+    return result;
+}
+
+int cbs_put_token_prepared_async(CBS_HANDLE cbs, AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_put_token, const char* token, ON_CBS_OPERATION_COMPLETE on_cbs_put_token_complete, void* on_cbs_put_token_complete_context)
+{
+    int result;
+
+    if ((cbs == NULL) ||
+        (prepared_put_token == NULL) ||
+        (token == NULL) ||
+        (on_cbs_put_token_complete == NULL))
+    {
+        /* Codes_SRS_CBS_01_131: [ If any of the arguments `cbs`, `prepared_put_token`, `token` or `on_cbs_put_token_complete` is NULL `cbs_put_token_prepared_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: cbs = %p, prepared_put_token = %p, token = %p, on_cbs_put_token_complete = %p",
+            cbs, prepared_put_token, token, on_cbs_put_token_complete);
+        result = __FAILURE__;
+    }
+    else if ((cbs->cbs_state == CBS_STATE_CLOSED) ||
+        (cbs->cbs_state == CBS_STATE_ERROR))
+    {
+        /* Codes_SRS_CBS_01_132: [ If `cbs_put_token_prepared_async` is called when the CBS instance is not yet open or in error, it shall fail and return a non-zero value. ]*/
+        LogError("put token called while closed or in error");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CBS_01_130: [ `cbs_put_token_prepared_async` shall construct a request message with only the token as amqp-value body and start it by calling `amqp_management_execute_prepared_operation_async` with `prepared_put_token`, so that the operation, type and name are not encoded again. ]*/
+        MESSAGE_HANDLE message = message_create();
+        if (message == NULL)
+        {
+            /* Codes_SRS_CBS_01_133: [ If constructing the message or starting the operation fails, `cbs_put_token_prepared_async` shall fail and return a non-zero value. ]*/
+            LogError("message_create failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            AMQP_VALUE token_value = amqpvalue_create_string(token);
+            if (token_value == NULL)
+            {
+                /* Codes_SRS_CBS_01_133: [ If constructing the message or starting the operation fails, `cbs_put_token_prepared_async` shall fail and return a non-zero value. ]*/
+                LogError("Failed creating token AMQP value");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (message_set_body_amqp_value(message, token_value) != 0)
+                {
+                    /* Codes_SRS_CBS_01_133: [ If constructing the message or starting the operation fails, `cbs_put_token_prepared_async` shall fail and return a non-zero value. ]*/
+                    LogError("Failed setting the token in the message body");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    CBS_OPERATION* cbs_operation = (CBS_OPERATION*)malloc(sizeof(CBS_OPERATION));
+                    if (cbs_operation == NULL)
+                    {
+                        LogError("Failed allocating CBS operation instance");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        LIST_ITEM_HANDLE list_item;
+
+                        cbs_operation->on_cbs_operation_complete = on_cbs_put_token_complete;
+                        cbs_operation->on_cbs_operation_complete_context = on_cbs_put_token_complete_context;
+                        cbs_operation->pending_operations = cbs->pending_operations;
+
+                        list_item = singlylinkedlist_add(cbs->pending_operations, cbs_operation);
+                        if (list_item == NULL)
+                        {
+                            free(cbs_operation);
+                            LogError("Failed adding pending operation to list");
+                            result = __FAILURE__;
+                        }
+                        else if (execute_underlying_prepared_operation(cbs, prepared_put_token, message, on_amqp_management_execute_operation_complete, list_item) != 0)
+                        {
+                            singlylinkedlist_remove(cbs->pending_operations, list_item);
+                            free(cbs_operation);
+                            /* Codes_SRS_CBS_01_133: [ If constructing the message or starting the operation fails, `cbs_put_token_prepared_async` shall fail and return a non-zero value. ]*/
+                            LogError("Failed starting AMQP management operation");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            /* Codes_SRS_CBS_01_135: [ On success `cbs_put_token_prepared_async` shall return 0. ]*/
+                            result = 0;
+                        }
+                    }
+                }
+
+                amqpvalue_destroy(token_value);
+            }
+
+            message_destroy(message);
+        }
+    }
+
+    return result;
+}
+
 int cbs_delete_token_async(CBS_HANDLE cbs, const char* type, const char* audience, ON_CBS_OPERATION_COMPLETE on_cbs_delete_token_complete, void* on_cbs_delete_token_complete_context)
 {
     int result;
@@ -694,7 +983,7 @@ int cbs_delete_token_async(CBS_HANDLE cbs, const char* type, const char* audienc
                                 /* Codes_SRS_CBS_01_022: [ operation    Yes    string    "delete-token" ]*/
                                 /* Codes_SRS_CBS_01_023: [ Type    Yes    string    The type of the token being deleted, e.g., "amqp:jwt". ]*/
                                 /* Codes_SRS_CBS_01_024: [ name    Yes    string    The "audience" of the token being deleted. ]*/
-                                if (amqp_management_execute_operation_async(cbs->amqp_management, "delete-token", type, NULL, message, on_amqp_management_execute_operation_complete, list_item) != 0)
+                                if (execute_underlying_amqp_management_operation(cbs, "delete-token", type, message, on_amqp_management_execute_operation_complete, list_item) != 0)
                                 {
                                     /* Codes_SRS_CBS_01_087: [ If `amqp_management_execute_operation_async` fails `cbs_put_token_async` shall fail and return a non-zero value. ]*/
                                     singlylinkedlist_remove(cbs->pending_operations, list_item);
@@ -734,7 +1023,15 @@ int cbs_set_trace(CBS_HANDLE cbs, bool trace_on)
     else
     {
         /* Codes_SRS_CBS_01_088: [ `cbs_set_trace` shall enable or disable tracing by calling `amqp_management_set_trace` to pass down the `trace_on` value. ]*/
-        amqp_management_set_trace(cbs->amqp_management, trace_on);
+        if (cbs->amqp_management_mux_client != NULL)
+        {
+            /* Codes_SRS_CBS_01_126: [ For a CBS instance created with `cbs_create_with_management_mux`, `cbs_set_trace` shall call `amqp_management_mux_set_trace`, which affects all clients of the mux. ]*/
+            amqp_management_mux_set_trace(cbs->amqp_management_mux, trace_on);
+        }
+        else
+        {
+            amqp_management_set_trace(cbs->amqp_management, trace_on);
+        }
 
         /* Codes_SRS_CBS_01_089: [ On success, `cbs_set_trace` shall return 0. ]*/
         result = 0;
@@ -0,0 +1,1289 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_uamqp_c/cbs_token_manager.h"
+
+/* audiences are kept in a hash table whose bucket count is a power of 2 doubled when it holds more audiences than buckets */
+#define INITIAL_BUCKET_COUNT 64
+
+typedef struct TOKEN_WAITER_TAG
+{
+    ON_CBS_OPERATION_COMPLETE on_put_token_complete;
+    void* on_put_token_complete_context;
+    struct TOKEN_WAITER_TAG* next;
+} TOKEN_WAITER;
+
+/* a put-token request and the callers waiting for its outcome */
+typedef struct TOKEN_PUT_TAG
+{
+    char* token;
+    uint64_t expiry_ms;
+    TOKEN_WAITER* first_waiter;
+    TOKEN_WAITER* last_waiter;
+} TOKEN_PUT;
+
+/* completed from any thread, so the completed requests go through a queue under a lock that cbs_token_manager_dowork empties */
+typedef struct TOKEN_REQUEST_QUEUE_TAG
+{
+    LOCK_HANDLE lock;
+    struct CBS_TOKEN_MANAGER_TOKEN_REQUEST_TAG* first_completed;
+    struct CBS_TOKEN_MANAGER_TOKEN_REQUEST_TAG* last_completed;
+    /* requests not taken back by cbs_token_manager_dowork yet, an orphaned queue is freed by the last one completed */
+    size_t outstanding_count;
+    bool is_orphaned;
+} TOKEN_REQUEST_QUEUE;
+
+typedef struct CBS_TOKEN_MANAGER_TOKEN_REQUEST_TAG
+{
+    TOKEN_REQUEST_QUEUE* queue;
+    /* only used on the thread driving the token manager, NULL once the audience was removed */
+    struct AUDIENCE_ENTRY_TAG* entry;
+    char* audience;
+    char* token;
+    uint64_t expiry_ms;
+    struct CBS_TOKEN_MANAGER_TOKEN_REQUEST_TAG* next;
+} CBS_TOKEN_MANAGER_TOKEN_REQUEST;
+
+typedef struct AUDIENCE_ENTRY_TAG
+{
+    struct AUDIENCE_ENTRY_TAG* next_in_bucket;
+    struct AUDIENCE_ENTRY_TAG* next_due;
+    struct CBS_TOKEN_MANAGER_INSTANCE_TAG* token_manager;
+    char* audience;
+    char* type;
+    uint32_t hash;
+    /* the token last put successfully, NULL until then */
+    char* token;
+    uint64_t expiry_ms;
+    TIMER_WHEEL_TIMER_HANDLE refresh_timer;
+    TOKEN_PUT in_flight_put;
+    /* the latest token asked for while a put is in flight, sent once it completes */
+    TOKEN_PUT next_put;
+    /* the token asked for from the token provider, NULL when none is outstanding */
+    CBS_TOKEN_MANAGER_TOKEN_REQUEST* token_request;
+    bool is_put_in_flight;
+    bool is_refresh_due;
+    bool is_removed;
+} AUDIENCE_ENTRY;
+
+typedef struct CBS_TOKEN_MANAGER_INSTANCE_TAG
+{
+    CBS_HANDLE cbs;
+    TIMER_WHEEL_HANDLE timer_wheel;
+    TICK_COUNTER_HANDLE tick_counter;
+    CBS_TOKEN_MANAGER_CONFIG config;
+    ON_CBS_TOKEN_MANAGER_GET_TOKEN on_get_token;
+    void* on_get_token_context;
+    ON_CBS_TOKEN_MANAGER_REQUEST_TOKEN on_request_token;
+    void* on_request_token_context;
+    TOKEN_REQUEST_QUEUE* token_request_queue;
+    AUDIENCE_ENTRY** buckets;
+    size_t bucket_count;
+    size_t audience_count;
+    /* refreshes waiting for room in a batch, in the order they became due */
+    AUDIENCE_ENTRY* first_due;
+    AUDIENCE_ENTRY* last_due;
+    TIMER_WHEEL_TIMER_HANDLE batch_timer;
+    bool is_batch_timer_started;
+    uint32_t jitter_state;
+} CBS_TOKEN_MANAGER_INSTANCE;
+
+static uint32_t hash_audience(const char* audience)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+
+    while (*audience != '\0')
+    {
+        hash ^= (unsigned char)*audience;
+        hash *= 16777619U;
+        audience++;
+    }
+
+    return hash;
+}
+
+static uint32_t next_jitter(CBS_TOKEN_MANAGER_INSTANCE* token_manager)
+{
+    /* xorshift32, the state is never 0 */
+    uint32_t x = token_manager->jitter_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    token_manager->jitter_state = x;
+    return x;
+}
+
+static int get_current_ms(CBS_TOKEN_MANAGER_INSTANCE* token_manager, uint64_t* current_ms)
+{
+    int result;
+    tickcounter_ms_t tick_ms;
+
+    if (tickcounter_get_current_ms(token_manager->tick_counter, &tick_ms) != 0)
+    {
+        LogError("Cannot get the current time");
+        result = __FAILURE__;
+    }
+    else
+    {
+        *current_ms = (uint64_t)tick_ms;
+        result = 0;
+    }
+
+    return result;
+}
+
+static AUDIENCE_ENTRY* find_audience_entry(CBS_TOKEN_MANAGER_INSTANCE* token_manager, const char* audience, uint32_t hash)
+{
+    AUDIENCE_ENTRY* entry = token_manager->buckets[hash & (token_manager->bucket_count - 1)];
+
+    while ((entry != NULL) &&
+        ((entry->hash != hash) || (strcmp(entry->audience, audience) != 0)))
+    {
+        entry = entry->next_in_bucket;
+    }
+
+    return entry;
+}
+
+static void grow_buckets(CBS_TOKEN_MANAGER_INSTANCE* token_manager)
+{
+    size_t new_bucket_count = token_manager->bucket_count * 2;
+    AUDIENCE_ENTRY** new_buckets = (AUDIENCE_ENTRY**)malloc(new_bucket_count * sizeof(AUDIENCE_ENTRY*));
+    if (new_buckets == NULL)
+    {
+        /* the table keeps working with longer chains */
+        LogError("Cannot grow the audience table");
+    }
+    else
+    {
+        size_t i;
+
+        (void)memset(new_buckets, 0, new_bucket_count * sizeof(AUDIENCE_ENTRY*));
+
+        for (i = 0; i < token_manager->bucket_count; i++)
+        {
+            AUDIENCE_ENTRY* entry = token_manager->buckets[i];
+            while (entry != NULL)
+            {
+                AUDIENCE_ENTRY* next_entry = entry->next_in_bucket;
+                size_t new_bucket = entry->hash & (new_bucket_count - 1);
+
+                entry->next_in_bucket = new_buckets[new_bucket];
+                new_buckets[new_bucket] = entry;
+                entry = next_entry;
+            }
+        }
+
+        free(token_manager->buckets);
+        token_manager->buckets = new_buckets;
+        token_manager->bucket_count = new_bucket_count;
+    }
+}
+
+static void unlink_audience_entry(CBS_TOKEN_MANAGER_INSTANCE* token_manager, AUDIENCE_ENTRY* entry)
+{
+    AUDIENCE_ENTRY** link = &token_manager->buckets[entry->hash & (token_manager->bucket_count - 1)];
+
+    while (*link != entry)
+    {
+        link = &(*link)->next_in_bucket;
+    }
+
+    *link = entry->next_in_bucket;
+    token_manager->audience_count--;
+}
+
+static void free_waiters(TOKEN_WAITER* waiter)
+{
+    while (waiter != NULL)
+    {
+        TOKEN_WAITER* next_waiter = waiter->next;
+        free(waiter);
+        waiter = next_waiter;
+    }
+}
+
+static void notify_waiters(TOKEN_WAITER* waiter, CBS_OPERATION_RESULT complete_result, unsigned int status_code, const char* status_description)
+{
+    while (waiter != NULL)
+    {
+        TOKEN_WAITER* next_waiter = waiter->next;
+        waiter->on_put_token_complete(waiter->on_put_token_complete_context, complete_result, status_code, status_description);
+        free(waiter);
+        waiter = next_waiter;
+    }
+}
+
+static int add_waiter(TOKEN_PUT* token_put, ON_CBS_OPERATION_COMPLETE on_put_token_complete, void* on_put_token_complete_context)
+{
+    int result;
+    TOKEN_WAITER* waiter = (TOKEN_WAITER*)malloc(sizeof(TOKEN_WAITER));
+    if (waiter == NULL)
+    {
+        LogError("Cannot allocate memory for the put token waiter");
+        result = __FAILURE__;
+    }
+    else
+    {
+        waiter->on_put_token_complete = on_put_token_complete;
+        waiter->on_put_token_complete_context = on_put_token_complete_context;
+        waiter->next = NULL;
+
+        if (token_put->last_waiter == NULL)
+        {
+            token_put->first_waiter = waiter;
+        }
+        else
+        {
+            token_put->last_waiter->next = waiter;
+        }
+
+        token_put->last_waiter = waiter;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void free_audience_entry(AUDIENCE_ENTRY* entry)
+{
+    if (entry->refresh_timer != NULL)
+    {
+        timer_wheel_destroy_timer(entry->refresh_timer);
+    }
+
+    free_waiters(entry->next_put.first_waiter);
+    if (entry->next_put.token != NULL)
+    {
+        free(entry->next_put.token);
+    }
+
+    if (entry->token != NULL)
+    {
+        free(entry->token);
+    }
+
+    free(entry->type);
+    free(entry->audience);
+    free(entry);
+}
+
+static void free_audience_entry_if_unused(AUDIENCE_ENTRY* entry)
+{
+    /* a removed entry stays alive while the CBS instance or the due queue still refer to it */
+    if ((entry->is_removed) &&
+        (!entry->is_put_in_flight) &&
+        (!entry->is_refresh_due))
+    {
+        free_audience_entry(entry);
+    }
+}
+
+static void on_cbs_put_token_complete(void* context, CBS_OPERATION_RESULT complete_result, unsigned int status_code, const char* status_description);
+static void on_refresh_timer_expired(void* context);
+
+/* takes ownership of token */
+static int start_put(AUDIENCE_ENTRY* entry, char* token, uint64_t expiry_ms)
+{
+    int result;
+
+    entry->in_flight_put.token = token;
+    entry->in_flight_put.expiry_ms = expiry_ms;
+    entry->is_put_in_flight = true;
+
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_014: [ A token shall be put by calling `cbs_put_token_async` with the type and audience of the audience entry. ]*/
+    if (cbs_put_token_async(entry->token_manager->cbs, entry->type, entry->audience, token, on_cbs_put_token_complete, entry) != 0)
+    {
+        LogError("Cannot put token");
+        entry->in_flight_put.token = NULL;
+        entry->is_put_in_flight = false;
+        free(token);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void schedule_refresh(AUDIENCE_ENTRY* entry, uint64_t refresh_ms)
+{
+    CBS_TOKEN_MANAGER_INSTANCE* token_manager = entry->token_manager;
+
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_024: [ If no `on_get_token` callback was given, tokens shall not be refreshed. ]*/
+    if ((token_manager->on_get_token != NULL) ||
+        (token_manager->on_request_token != NULL))
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_023: [ The refresh timer of an audience shall be created by calling `timer_wheel_create_timer` the first time a refresh is scheduled for it, and started by calling `timer_wheel_start_timer` with the refresh time. ]*/
+        if ((entry->refresh_timer == NULL) &&
+            ((entry->refresh_timer = timer_wheel_create_timer(token_manager->timer_wheel, on_refresh_timer_expired, entry)) == NULL))
+        {
+            LogError("Cannot create refresh timer, the token for %s will not be refreshed", entry->audience);
+        }
+        else if (timer_wheel_start_timer(entry->refresh_timer, refresh_ms) != 0)
+        {
+            LogError("Cannot start refresh timer, the token for %s will not be refreshed", entry->audience);
+        }
+    }
+}
+
+static void schedule_retry(AUDIENCE_ENTRY* entry)
+{
+    uint64_t current_ms;
+
+    if (get_current_ms(entry->token_manager, &current_ms) == 0)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_031: [ If refreshing a token fails, the refresh shall be attempted again `retry_interval_ms` later. ]*/
+        schedule_refresh(entry, current_ms + entry->token_manager->config.retry_interval_ms);
+    }
+}
+
+static void schedule_refresh_before_expiry(AUDIENCE_ENTRY* entry)
+{
+    CBS_TOKEN_MANAGER_INSTANCE* token_manager = entry->token_manager;
+    uint64_t current_ms;
+
+    if (get_current_ms(token_manager, &current_ms) == 0)
+    {
+        uint64_t refresh_ms;
+        uint64_t lead_ms = token_manager->config.refresh_ahead_ms;
+
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_021: [ After a token is put successfully, its refresh shall be scheduled `refresh_ahead_ms` before its expiry, moved earlier by a random amount between 0 and `refresh_jitter_ms`. ]*/
+        if (token_manager->config.refresh_jitter_ms > 0)
+        {
+            lead_ms += next_jitter(token_manager) % ((uint64_t)token_manager->config.refresh_jitter_ms + 1);
+        }
+
+        refresh_ms = (entry->expiry_ms > lead_ms) ? (entry->expiry_ms - lead_ms) : 0;
+
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_022: [ A refresh shall not be scheduled earlier than `retry_interval_ms` from the current time, so that tokens living shorter than the refresh lead are not refreshed in a tight loop. ]*/
+        if (refresh_ms < current_ms + token_manager->config.retry_interval_ms)
+        {
+            refresh_ms = current_ms + token_manager->config.retry_interval_ms;
+        }
+
+        schedule_refresh(entry, refresh_ms);
+    }
+}
+
+static void start_batch_timer(CBS_TOKEN_MANAGER_INSTANCE* token_manager, uint64_t deadline_ms)
+{
+    if (timer_wheel_start_timer(token_manager->batch_timer, deadline_ms) != 0)
+    {
+        LogError("Cannot start the refresh batch timer");
+    }
+    else
+    {
+        token_manager->is_batch_timer_started = true;
+    }
+}
+
+static void on_refresh_timer_expired(void* context)
+{
+    AUDIENCE_ENTRY* entry = (AUDIENCE_ENTRY*)context;
+    CBS_TOKEN_MANAGER_INSTANCE* token_manager = entry->token_manager;
+
+    if (!entry->is_refresh_due)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_025: [ When the refresh of a token is due, the audience shall be appended to the queue of due refreshes. ]*/
+        entry->is_refresh_due = true;
+        entry->next_due = NULL;
+
+        if (token_manager->last_due == NULL)
+        {
+            token_manager->first_due = entry;
+        }
+        else
+        {
+            token_manager->last_due->next_due = entry;
+        }
+
+        token_manager->last_due = entry;
+
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_026: [ If no batch is scheduled, the batch timer shall be started to expire on the next tick. ]*/
+        if (!token_manager->is_batch_timer_started)
+        {
+            uint64_t current_ms;
+            if (get_current_ms(token_manager, &current_ms) == 0)
+            {
+                start_batch_timer(token_manager, current_ms);
+            }
+        }
+    }
+}
+
+static void free_token_request(CBS_TOKEN_MANAGER_TOKEN_REQUEST* request)
+{
+    if (request->token != NULL)
+    {
+        free(request->token);
+    }
+
+    free(request->audience);
+    free(request);
+}
+
+static void free_token_request_queue(TOKEN_REQUEST_QUEUE* queue)
+{
+    (void)Lock_Deinit(queue->lock);
+    free(queue);
+}
+
+/* the request no longer refers to the audience, it is freed when it comes back */
+static void detach_token_request(AUDIENCE_ENTRY* entry)
+{
+    if (entry->token_request != NULL)
+    {
+        entry->token_request->entry = NULL;
+        entry->token_request = NULL;
+    }
+}
+
+static void request_token(AUDIENCE_ENTRY* entry)
+{
+    CBS_TOKEN_MANAGER_INSTANCE* token_manager = entry->token_manager;
+    TOKEN_REQUEST_QUEUE* queue = token_manager->token_request_queue;
+    CBS_TOKEN_MANAGER_TOKEN_REQUEST* request = (CBS_TOKEN_MANAGER_TOKEN_REQUEST*)malloc(sizeof(CBS_TOKEN_MANAGER_TOKEN_REQUEST));
+
+    if (request == NULL)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_040: [ If the token request cannot be created, the refresh shall be attempted again `retry_interval_ms` later. ]*/
+        LogError("Cannot allocate memory for the token request");
+        schedule_retry(entry);
+    }
+    else if (mallocAndStrcpy_s(&request->audience, entry->audience) != 0)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_040: [ If the token request cannot be created, the refresh shall be attempted again `retry_interval_ms` later. ]*/
+        LogError("Cannot copy the audience of the token request");
+        free(request);
+        schedule_retry(entry);
+    }
+    else if (Lock(queue->lock) != LOCK_OK)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_040: [ If the token request cannot be created, the refresh shall be attempted again `retry_interval_ms` later. ]*/
+        LogError("Cannot lock the token request queue");
+        free(request->audience);
+        free(request);
+        schedule_retry(entry);
+    }
+    else
+    {
+        queue->outstanding_count++;
+        (void)Unlock(queue->lock);
+
+        request->queue = queue;
+        request->entry = entry;
+        request->token = NULL;
+        request->expiry_ms = 0;
+        request->next = NULL;
+        entry->token_request = request;
+
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_039: [ With a token provider, a token shall be refreshed by calling `on_request_token` with a copy of the audience that stays valid until the request is completed and a new request handle, without waiting for the token. ]*/
+        token_manager->on_request_token(token_manager->on_request_token_context, request->audience, request);
+    }
+}
+
+/* the request is freed by the caller */
+static void put_requested_token(CBS_TOKEN_MANAGER_TOKEN_REQUEST* request)
+{
+    AUDIENCE_ENTRY* entry = request->entry;
+
+    if (entry == NULL)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_048: [ The token of a request made for an audience removed since, or by a token manager destroyed since, shall be discarded. ]*/
+    }
+    else
+    {
+        entry->token_request = NULL;
+
+        if (request->token == NULL)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_046: [ If a request was completed without a token, the refresh shall be attempted again `retry_interval_ms` later. ]*/
+            LogError("No token available for refreshing %s", entry->audience);
+            schedule_retry(entry);
+        }
+        else if (entry->is_put_in_flight)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_047: [ If a put was started for the audience while the token was requested, the requested token shall be discarded, the refresh being scheduled again when the put completes. ]*/
+        }
+        else
+        {
+            char* token = request->token;
+
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_045: [ `cbs_token_manager_dowork` shall put the tokens of the completed requests with their expiry. ]*/
+            request->token = NULL;
+            if (start_put(entry, token, request->expiry_ms) != 0)
+            {
+                schedule_retry(entry);
+            }
+        }
+    }
+}
+
+static void refresh_token(AUDIENCE_ENTRY* entry)
+{
+    CBS_TOKEN_MANAGER_INSTANCE* token_manager = entry->token_manager;
+    uint64_t expiry_ms;
+    const char* token;
+
+    if (token_manager->on_request_token != NULL)
+    {
+        request_token(entry);
+    }
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_028: [ A token shall be refreshed by calling `on_get_token` with the audience and putting the returned token with the returned expiry. ]*/
+    else if ((token_manager->on_get_token == NULL) ||
+        ((token = token_manager->on_get_token(token_manager->on_get_token_context, entry->audience, &expiry_ms)) == NULL))
+    {
+        LogError("No token available for refreshing %s", entry->audience);
+        schedule_retry(entry);
+    }
+    else
+    {
+        char* copied_token;
+
+        if (mallocAndStrcpy_s(&copied_token, token) != 0)
+        {
+            LogError("Cannot copy the refreshed token");
+            schedule_retry(entry);
+        }
+        else if (start_put(entry, copied_token, expiry_ms) != 0)
+        {
+            schedule_retry(entry);
+        }
+    }
+}
+
+static void on_batch_timer_expired(void* context)
+{
+    CBS_TOKEN_MANAGER_INSTANCE* token_manager = (CBS_TOKEN_MANAGER_INSTANCE*)context;
+    size_t refresh_count = 0;
+
+    token_manager->is_batch_timer_started = false;
+
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_027: [ When the batch timer expires, at most `max_refreshes_per_batch` due refreshes shall be started, in the order they became due. ]*/
+    while ((refresh_count < token_manager->config.max_refreshes_per_batch) &&
+        (token_manager->first_due != NULL))
+    {
+        AUDIENCE_ENTRY* entry = token_manager->first_due;
+
+        token_manager->first_due = entry->next_due;
+        if (token_manager->first_due == NULL)
+        {
+            token_manager->last_due = NULL;
+        }
+
+        entry->is_refresh_due = false;
+
+        if (entry->is_removed)
+        {
+            free_audience_entry_if_unused(entry);
+        }
+        else if (entry->is_put_in_flight)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_029: [ A due refresh for an audience that has a put in flight shall be skipped, the refresh being scheduled again when the put completes. ]*/
+        }
+        else if (entry->token_request != NULL)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_041: [ A due refresh for an audience whose token is being requested shall be skipped, the refresh being scheduled again when the request completes. ]*/
+        }
+        else
+        {
+            refresh_token(entry);
+            refresh_count++;
+        }
+    }
+
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_030: [ If due refreshes remain, the batch timer shall be started again `batch_interval_ms` later. ]*/
+    if (token_manager->first_due != NULL)
+    {
+        uint64_t current_ms;
+        if (get_current_ms(token_manager, &current_ms) == 0)
+        {
+            start_batch_timer(token_manager, current_ms + token_manager->config.batch_interval_ms);
+        }
+    }
+}
+
+static void on_cbs_put_token_complete(void* context, CBS_OPERATION_RESULT complete_result, unsigned int status_code, const char* status_description)
+{
+    AUDIENCE_ENTRY* entry = (AUDIENCE_ENTRY*)context;
+    TOKEN_WAITER* completed_waiters = entry->in_flight_put.first_waiter;
+    TOKEN_WAITER* failed_waiters = NULL;
+
+    entry->in_flight_put.first_waiter = NULL;
+    entry->in_flight_put.last_waiter = NULL;
+    entry->is_put_in_flight = false;
+
+    if (complete_result == CBS_OPERATION_RESULT_OK)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_015: [ When a put completes successfully, the token and its expiry shall be cached for the audience. ]*/
+        if (entry->token != NULL)
+        {
+            free(entry->token);
+        }
+
+        entry->token = entry->in_flight_put.token;
+        entry->expiry_ms = entry->in_flight_put.expiry_ms;
+    }
+    else
+    {
+        free(entry->in_flight_put.token);
+    }
+
+    entry->in_flight_put.token = NULL;
+
+    if (entry->token_manager == NULL)
+    {
+        /* the token manager was destroyed while the put was in flight */
+        free_audience_entry(entry);
+    }
+    else if (entry->next_put.token != NULL)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_018: [ When the put in flight completes and another token was asked for in the meantime, that token shall be put, its callers waiting for the new put. ]*/
+        TOKEN_WAITER* next_waiters = entry->next_put.first_waiter;
+        TOKEN_WAITER* next_last_waiter = entry->next_put.last_waiter;
+        char* next_token = entry->next_put.token;
+
+        entry->next_put.token = NULL;
+        entry->next_put.first_waiter = NULL;
+        entry->next_put.last_waiter = NULL;
+
+        if (start_put(entry, next_token, entry->next_put.expiry_ms) != 0)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_019: [ If putting that token fails, its callers shall be called with `CBS_OPERATION_RESULT_CBS_ERROR`. ]*/
+            failed_waiters = next_waiters;
+            if (entry->is_removed)
+            {
+                free_audience_entry_if_unused(entry);
+            }
+            else
+            {
+                schedule_retry(entry);
+            }
+        }
+        else
+        {
+            entry->in_flight_put.first_waiter = next_waiters;
+            entry->in_flight_put.last_waiter = next_last_waiter;
+        }
+    }
+    else if (entry->is_removed)
+    {
+        free_audience_entry_if_unused(entry);
+    }
+    else if (complete_result == CBS_OPERATION_RESULT_OK)
+    {
+        schedule_refresh_before_expiry(entry);
+    }
+    else
+    {
+        schedule_retry(entry);
+    }
+
+    /* the entry is not used past this point, a callback can remove the audience */
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_016: [ All callers waiting for the put shall be called with the result, status code and status description of the put. ]*/
+    notify_waiters(completed_waiters, complete_result, status_code, status_description);
+    notify_waiters(failed_waiters, CBS_OPERATION_RESULT_CBS_ERROR, 0, NULL);
+}
+
+CBS_TOKEN_MANAGER_HANDLE cbs_token_manager_create(CBS_HANDLE cbs, TIMER_WHEEL_HANDLE timer_wheel, TICK_COUNTER_HANDLE tick_counter, const CBS_TOKEN_MANAGER_CONFIG* config, ON_CBS_TOKEN_MANAGER_GET_TOKEN on_get_token, void* on_get_token_context)
+{
+    CBS_TOKEN_MANAGER_INSTANCE* token_manager;
+
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_002: [ If `cbs`, `timer_wheel`, `tick_counter` or `config` is NULL, `cbs_token_manager_create` shall fail and return NULL. ]*/
+    if ((cbs == NULL) ||
+        (timer_wheel == NULL) ||
+        (tick_counter == NULL) ||
+        (config == NULL))
+    {
+        LogError("Bad arguments: cbs = %p, timer_wheel = %p, tick_counter = %p, config = %p",
+            cbs, timer_wheel, tick_counter, config);
+        token_manager = NULL;
+    }
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_003: [ If `max_refreshes_per_batch` or `batch_interval_ms` is 0, `cbs_token_manager_create` shall fail and return NULL. ]*/
+    else if ((config->max_refreshes_per_batch == 0) ||
+        (config->batch_interval_ms == 0))
+    {
+        LogError("Bad config: max_refreshes_per_batch = %u, batch_interval_ms = %u",
+            (unsigned int)config->max_refreshes_per_batch, (unsigned int)config->batch_interval_ms);
+        token_manager = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_001: [ `cbs_token_manager_create` shall create a new token manager putting tokens through `cbs` and on success return a non-NULL handle to it. ]*/
+        token_manager = (CBS_TOKEN_MANAGER_INSTANCE*)malloc(sizeof(CBS_TOKEN_MANAGER_INSTANCE));
+        if (token_manager == NULL)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_004: [ If any error occurs, `cbs_token_manager_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the token manager");
+        }
+        else
+        {
+            uint64_t current_ms;
+
+            token_manager->cbs = cbs;
+            token_manager->timer_wheel = timer_wheel;
+            token_manager->tick_counter = tick_counter;
+            token_manager->config = *config;
+            token_manager->on_get_token = on_get_token;
+            token_manager->on_get_token_context = on_get_token_context;
+            token_manager->on_request_token = NULL;
+            token_manager->on_request_token_context = NULL;
+            token_manager->token_request_queue = NULL;
+            token_manager->bucket_count = INITIAL_BUCKET_COUNT;
+            token_manager->audience_count = 0;
+            token_manager->first_due = NULL;
+            token_manager->last_due = NULL;
+            token_manager->is_batch_timer_started = false;
+
+            if (get_current_ms(token_manager, &current_ms) != 0)
+            {
+                /* Codes_SRS_CBS_TOKEN_MANAGER_01_004: [ If any error occurs, `cbs_token_manager_create` shall fail and return NULL. ]*/
+                free(token_manager);
+                token_manager = NULL;
+            }
+            else if ((token_manager->buckets = (AUDIENCE_ENTRY**)malloc(INITIAL_BUCKET_COUNT * sizeof(AUDIENCE_ENTRY*))) == NULL)
+            {
+                /* Codes_SRS_CBS_TOKEN_MANAGER_01_004: [ If any error occurs, `cbs_token_manager_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate memory for the audience table");
+                free(token_manager);
+                token_manager = NULL;
+            }
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_005: [ `cbs_token_manager_create` shall create the timer driving the refresh batches by calling `timer_wheel_create_timer`. ]*/
+            else if ((token_manager->batch_timer = timer_wheel_create_timer(timer_wheel, on_batch_timer_expired, token_manager)) == NULL)
+            {
+                /* Codes_SRS_CBS_TOKEN_MANAGER_01_004: [ If any error occurs, `cbs_token_manager_create` shall fail and return NULL. ]*/
+                LogError("Cannot create the refresh batch timer");
+                free(token_manager->buckets);
+                free(token_manager);
+                token_manager = NULL;
+            }
+            else
+            {
+                (void)memset(token_manager->buckets, 0, INITIAL_BUCKET_COUNT * sizeof(AUDIENCE_ENTRY*));
+
+                /* the jitter of several token managers started together still differs with the time they are seeded at */
+                token_manager->jitter_state = (uint32_t)current_ms ^ 0x9E3779B9U;
+                if (token_manager->jitter_state == 0)
+                {
+                    token_manager->jitter_state = 1;
+                }
+            }
+        }
+    }
+
+    return token_manager;
+}
+
+void cbs_token_manager_destroy(CBS_TOKEN_MANAGER_HANDLE token_manager)
+{
+    if (token_manager == NULL)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_007: [ If `token_manager` is NULL, `cbs_token_manager_destroy` shall do nothing. ]*/
+        LogError("NULL token_manager");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_006: [ `cbs_token_manager_destroy` shall free all the resources of the token manager, destroying its timers by calling `timer_wheel_destroy_timer`. ]*/
+        while (token_manager->first_due != NULL)
+        {
+            AUDIENCE_ENTRY* entry = token_manager->first_due;
+            token_manager->first_due = entry->next_due;
+            entry->is_refresh_due = false;
+
+            if (entry->is_removed)
+            {
+                free_audience_entry_if_unused(entry);
+            }
+        }
+
+        for (i = 0; i < token_manager->bucket_count; i++)
+        {
+            AUDIENCE_ENTRY* entry = token_manager->buckets[i];
+            while (entry != NULL)
+            {
+                AUDIENCE_ENTRY* next_entry = entry->next_in_bucket;
+
+                detach_token_request(entry);
+
+                if (entry->is_put_in_flight)
+                {
+                    /* Codes_SRS_CBS_TOKEN_MANAGER_01_008: [ Audiences with a put in flight shall be freed when the put completes, without refreshing them. ]*/
+                    if (entry->refresh_timer != NULL)
+                    {
+                        timer_wheel_destroy_timer(entry->refresh_timer);
+                        entry->refresh_timer = NULL;
+                    }
+
+                    entry->token_manager = NULL;
+                    entry->is_removed = true;
+                }
+                else
+                {
+                    free_audience_entry(entry);
+                }
+
+                entry = next_entry;
+            }
+        }
+
+        if (token_manager->token_request_queue != NULL)
+        {
+            TOKEN_REQUEST_QUEUE* queue = token_manager->token_request_queue;
+
+            if (Lock(queue->lock) != LOCK_OK)
+            {
+                /* the queue is leaked rather than freed under a request being completed */
+                LogError("Cannot lock the token request queue");
+            }
+            else
+            {
+                CBS_TOKEN_MANAGER_TOKEN_REQUEST* request = queue->first_completed;
+                bool is_queue_unused;
+
+                /* Codes_SRS_CBS_TOKEN_MANAGER_01_048: [ The token of a request made for an audience removed since, or by a token manager destroyed since, shall be discarded. ]*/
+                queue->first_completed = NULL;
+                queue->last_completed = NULL;
+                queue->is_orphaned = true;
+                while (request != NULL)
+                {
+                    CBS_TOKEN_MANAGER_TOKEN_REQUEST* next_request = request->next;
+                    queue->outstanding_count--;
+                    free_token_request(request);
+                    request = next_request;
+                }
+
+                /* requests still outstanding free the queue when the last of them is completed */
+                is_queue_unused = (queue->outstanding_count == 0);
+                (void)Unlock(queue->lock);
+
+                if (is_queue_unused)
+                {
+                    free_token_request_queue(queue);
+                }
+            }
+        }
+
+        timer_wheel_destroy_timer(token_manager->batch_timer);
+        free(token_manager->buckets);
+        free(token_manager);
+    }
+}
+
+int cbs_token_manager_put_token_async(CBS_TOKEN_MANAGER_HANDLE token_manager, const char* type, const char* audience, const char* token, uint64_t expiry_ms, ON_CBS_OPERATION_COMPLETE on_put_token_complete, void* on_put_token_complete_context)
+{
+    int result;
+
+    /* Codes_SRS_CBS_TOKEN_MANAGER_01_010: [ If `token_manager`, `type`, `audience`, `token` or `on_put_token_complete` is NULL, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+    if ((token_manager == NULL) ||
+        (type == NULL) ||
+        (audience == NULL) ||
+        (token == NULL) ||
+        (on_put_token_complete == NULL))
+    {
+        LogError("Bad arguments: token_manager = %p, type = %p, audience = %p, token = %p, on_put_token_complete = %p",
+            token_manager, type, audience, token, on_put_token_complete);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t hash = hash_audience(audience);
+        AUDIENCE_ENTRY* entry = find_audience_entry(token_manager, audience, hash);
+
+        if (entry == NULL)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_011: [ The first put for an audience shall create an entry for it holding copies of `audience` and `type`. ]*/
+            entry = (AUDIENCE_ENTRY*)malloc(sizeof(AUDIENCE_ENTRY));
+            if (entry == NULL)
+            {
+                LogError("Cannot allocate memory for the audience entry");
+            }
+            else
+            {
+                (void)memset(entry, 0, sizeof(AUDIENCE_ENTRY));
+                entry->token_manager = token_manager;
+                entry->hash = hash;
+
+                if (mallocAndStrcpy_s(&entry->audience, audience) != 0)
+                {
+                    LogError("Cannot copy audience");
+                    free(entry);
+                    entry = NULL;
+                }
+                else if (mallocAndStrcpy_s(&entry->type, type) != 0)
+                {
+                    LogError("Cannot copy type");
+                    free(entry->audience);
+                    free(entry);
+                    entry = NULL;
+                }
+                else
+                {
+                    size_t bucket;
+
+                    if (token_manager->audience_count >= token_manager->bucket_count)
+                    {
+                        grow_buckets(token_manager);
+                    }
+
+                    bucket = hash & (token_manager->bucket_count - 1);
+                    entry->next_in_bucket = token_manager->buckets[bucket];
+                    token_manager->buckets[bucket] = entry;
+                    token_manager->audience_count++;
+                }
+            }
+        }
+        else if (strcmp(entry->type, type) != 0)
+        {
+            char* copied_type;
+
+            if (mallocAndStrcpy_s(&copied_type, type) != 0)
+            {
+                LogError("Cannot copy type");
+                entry = NULL;
+            }
+            else
+            {
+                free(entry->type);
+                entry->type = copied_type;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_020: [ If any error occurs, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+            result = __FAILURE__;
+        }
+        else if (entry->is_put_in_flight)
+        {
+            if (strcmp(entry->in_flight_put.token, token) == 0)
+            {
+                /* Codes_SRS_CBS_TOKEN_MANAGER_01_013: [ If the same token is already being put for the audience, no new request shall be sent and the caller shall wait for the put in flight. ]*/
+                if (add_waiter(&entry->in_flight_put, on_put_token_complete, on_put_token_complete_context) != 0)
+                {
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+            else
+            {
+                /* Codes_SRS_CBS_TOKEN_MANAGER_01_017: [ If another token is being put for the audience, the token shall replace any token waiting to be put after it, the callers waiting for the replaced token waiting for this one. ]*/
+                if ((entry->next_put.token == NULL) ||
+                    (strcmp(entry->next_put.token, token) != 0))
+                {
+                    char* copied_token;
+
+                    if (mallocAndStrcpy_s(&copied_token, token) != 0)
+                    {
+                        LogError("Cannot copy token");
+                        copied_token = NULL;
+                    }
+                    else
+                    {
+                        if (entry->next_put.token != NULL)
+                        {
+                            free(entry->next_put.token);
+                        }
+
+                        entry->next_put.token = copied_token;
+                        entry->next_put.expiry_ms = expiry_ms;
+                    }
+
+                    if (copied_token == NULL)
+                    {
+                        result = __FAILURE__;
+                    }
+                    else if (add_waiter(&entry->next_put, on_put_token_complete, on_put_token_complete_context) != 0)
+                    {
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+                else if (add_waiter(&entry->next_put, on_put_token_complete, on_put_token_complete_context) != 0)
+                {
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+        }
+        else
+        {
+            uint64_t current_ms;
+
+            if (get_current_ms(token_manager, &current_ms) != 0)
+            {
+                result = __FAILURE__;
+            }
+            else if ((entry->token != NULL) &&
+                (strcmp(entry->token, token) == 0) &&
+                (entry->expiry_ms == expiry_ms) &&
+                (current_ms < expiry_ms))
+            {
+                /* Codes_SRS_CBS_TOKEN_MANAGER_01_012: [ If the token is the one cached for the audience and has not expired, no request shall be sent and `on_put_token_complete` shall be called with `CBS_OPERATION_RESULT_OK`, status code 0 and a NULL status description. ]*/
+                on_put_token_complete(on_put_token_complete_context, CBS_OPERATION_RESULT_OK, 0, NULL);
+                result = 0;
+            }
+            else
+            {
+                char* copied_token;
+                TOKEN_PUT waiting_put = { NULL, 0, NULL, NULL };
+
+                if (add_waiter(&waiting_put, on_put_token_complete, on_put_token_complete_context) != 0)
+                {
+                    result = __FAILURE__;
+                }
+                else if (mallocAndStrcpy_s(&copied_token, token) != 0)
+                {
+                    LogError("Cannot copy token");
+                    free_waiters(waiting_put.first_waiter);
+                    result = __FAILURE__;
+                }
+                else if (start_put(entry, copied_token, expiry_ms) != 0)
+                {
+                    free_waiters(waiting_put.first_waiter);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    entry->in_flight_put.first_waiter = waiting_put.first_waiter;
+                    entry->in_flight_put.last_waiter = waiting_put.last_waiter;
+
+                    /* Codes_SRS_CBS_TOKEN_MANAGER_01_009: [ On success, `cbs_token_manager_put_token_async` shall return 0. ]*/
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int cbs_token_manager_remove_audience(CBS_TOKEN_MANAGER_HANDLE token_manager, const char* audience)
+{
+    int result;
+
+    if ((token_manager == NULL) ||
+        (audience == NULL))
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_033: [ If `token_manager` or `audience` is NULL, `cbs_token_manager_remove_audience` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: token_manager = %p, audience = %p", token_manager, audience);
+        result = __FAILURE__;
+    }
+    else
+    {
+        AUDIENCE_ENTRY* entry = find_audience_entry(token_manager, audience, hash_audience(audience));
+        if (entry == NULL)
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_034: [ If the audience is not known, `cbs_token_manager_remove_audience` shall fail and return a non-zero value. ]*/
+            LogError("Audience %s not found", audience);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_032: [ `cbs_token_manager_remove_audience` shall forget the cached token of the audience and stop refreshing it, puts already started completing normally. ]*/
+            unlink_audience_entry(token_manager, entry);
+            entry->is_removed = true;
+            detach_token_request(entry);
+
+            if (entry->refresh_timer != NULL)
+            {
+                timer_wheel_destroy_timer(entry->refresh_timer);
+                entry->refresh_timer = NULL;
+            }
+
+            free_audience_entry_if_unused(entry);
+
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_035: [ On success, `cbs_token_manager_remove_audience` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int cbs_token_manager_set_token_provider(CBS_TOKEN_MANAGER_HANDLE token_manager, ON_CBS_TOKEN_MANAGER_REQUEST_TOKEN on_request_token, void* on_request_token_context)
+{
+    int result;
+
+    if (token_manager == NULL)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_037: [ If `token_manager` is NULL, `cbs_token_manager_set_token_provider` shall fail and return a non-zero value. ]*/
+        LogError("NULL token_manager");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((on_request_token != NULL) &&
+            (token_manager->token_request_queue == NULL))
+        {
+            TOKEN_REQUEST_QUEUE* queue = (TOKEN_REQUEST_QUEUE*)malloc(sizeof(TOKEN_REQUEST_QUEUE));
+            if (queue == NULL)
+            {
+                LogError("Cannot allocate memory for the token request queue");
+            }
+            else if ((queue->lock = Lock_Init()) == NULL)
+            {
+                LogError("Cannot create the lock of the token request queue");
+                free(queue);
+            }
+            else
+            {
+                queue->first_completed = NULL;
+                queue->last_completed = NULL;
+                queue->outstanding_count = 0;
+                queue->is_orphaned = false;
+                token_manager->token_request_queue = queue;
+            }
+        }
+
+        if ((on_request_token != NULL) &&
+            (token_manager->token_request_queue == NULL))
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_038: [ If any error occurs, `cbs_token_manager_set_token_provider` shall fail and return a non-zero value. ]*/
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_036: [ `cbs_token_manager_set_token_provider` shall make the refreshes ask `on_request_token` for tokens instead of `on_get_token`, NULL going back to `on_get_token`, and return 0. ]*/
+            token_manager->on_request_token = on_request_token;
+            token_manager->on_request_token_context = on_request_token_context;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int cbs_token_manager_complete_token_request(CBS_TOKEN_MANAGER_TOKEN_REQUEST_HANDLE request, const char* token, uint64_t expiry_ms)
+{
+    int result;
+
+    if (request == NULL)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_043: [ If `request` is NULL, `cbs_token_manager_complete_token_request` shall fail and return a non-zero value. ]*/
+        LogError("NULL request");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TOKEN_REQUEST_QUEUE* queue = request->queue;
+
+        if ((token != NULL) &&
+            (mallocAndStrcpy_s(&request->token, token) != 0))
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_044: [ If the token cannot be copied, the request shall be completed without a token and `cbs_token_manager_complete_token_request` shall return a non-zero value. ]*/
+            LogError("Cannot copy the requested token");
+            request->token = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CBS_TOKEN_MANAGER_01_042: [ `cbs_token_manager_complete_token_request` shall hand `token` and `expiry_ms` back to the token manager, NULL `token` meaning that none could be made, and return 0. It may be called from any thread. ]*/
+            result = 0;
+        }
+
+        request->expiry_ms = expiry_ms;
+
+        if (Lock(queue->lock) != LOCK_OK)
+        {
+            LogError("Cannot lock the token request queue");
+            result = __FAILURE__;
+        }
+        else if (queue->is_orphaned)
+        {
+            bool is_queue_unused;
+
+            queue->outstanding_count--;
+            is_queue_unused = (queue->outstanding_count == 0);
+            (void)Unlock(queue->lock);
+
+            free_token_request(request);
+            if (is_queue_unused)
+            {
+                free_token_request_queue(queue);
+            }
+        }
+        else
+        {
+            request->next = NULL;
+            if (queue->last_completed == NULL)
+            {
+                queue->first_completed = request;
+            }
+            else
+            {
+                queue->last_completed->next = request;
+            }
+
+            queue->last_completed = request;
+            (void)Unlock(queue->lock);
+        }
+    }
+
+    return result;
+}
+
+void cbs_token_manager_dowork(CBS_TOKEN_MANAGER_HANDLE token_manager)
+{
+    if (token_manager == NULL)
+    {
+        /* Codes_SRS_CBS_TOKEN_MANAGER_01_049: [ If `token_manager` is NULL, `cbs_token_manager_dowork` shall do nothing. ]*/
+        LogError("NULL token_manager");
+    }
+    else if (token_manager->token_request_queue != NULL)
+    {
+        TOKEN_REQUEST_QUEUE* queue = token_manager->token_request_queue;
+
+        if (Lock(queue->lock) != LOCK_OK)
+        {
+            LogError("Cannot lock the token request queue");
+        }
+        else
+        {
+            CBS_TOKEN_MANAGER_TOKEN_REQUEST* request = queue->first_completed;
+            CBS_TOKEN_MANAGER_TOKEN_REQUEST* counted_request = request;
+
+            queue->first_completed = NULL;
+            queue->last_completed = NULL;
+            while (counted_request != NULL)
+            {
+                queue->outstanding_count--;
+                counted_request = counted_request->next;
+            }
+
+            (void)Unlock(queue->lock);
+
+            /* the tokens are put outside of the lock, so that the provider never waits for a put */
+            while (request != NULL)
+            {
+                CBS_TOKEN_MANAGER_TOKEN_REQUEST* next_request = request->next;
+                put_requested_token(request);
+                free_token_request(request);
+                request = next_request;
+            }
+        }
+    }
+}
@@ -0,0 +1,865 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/columnar_batch.h"
+
+#define MIN_BUFFER_SIZE 256
+
+/* the fields of the properties list, in order */
+static const char* property_names[] =
+{
+    "message-id", "user-id", "to", "subject", "reply-to", "correlation-id", "content-type", "content-encoding",
+    "absolute-expiry-time", "creation-time", "group-id", "group-sequence", "reply-to-group-id"
+};
+
+typedef struct COLUMN_TAG
+{
+    COLUMNAR_BATCH_SOURCE source;
+    COLUMNAR_BATCH_COLUMN_TYPE column_type;
+    char* name;
+    size_t name_length;
+    /* the field of the properties list, for COLUMNAR_BATCH_SOURCE_PROPERTY */
+    uint32_t property_index;
+    bool* is_present;
+    int64_t* int64_values;
+    double* double_values;
+    /* STRING columns, laid out like the bodies */
+    unsigned char* characters;
+    size_t characters_size;
+    size_t* offsets;
+} COLUMN;
+
+typedef struct COLUMNAR_BATCH_INSTANCE_TAG
+{
+    uint32_t max_rows;
+    uint32_t row_count;
+    delivery_number* delivery_ids;
+    unsigned char* body_bytes;
+    size_t body_bytes_size;
+    size_t* body_offsets;
+    COLUMN* columns;
+    size_t column_count;
+    /* so that the sections nobody asked for are skipped without walking them */
+    size_t source_column_counts[3];
+} COLUMNAR_BATCH_INSTANCE;
+
+static void free_column(COLUMN* column)
+{
+    free(column->name);
+    free(column->is_present);
+    free(column->int64_values);
+    free(column->double_values);
+    free(column->characters);
+    free(column->offsets);
+}
+
+/* appends to the bytes of the row being added, which end at offsets[row + 1] */
+static int append_row_bytes(unsigned char** buffer, size_t* buffer_size, size_t* offsets, uint32_t row, const unsigned char* bytes, size_t length)
+{
+    int result;
+    size_t used = offsets[row + 1];
+
+    if (length > SIZE_MAX - used)
+    {
+        LogError("Row too large");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (used + length > *buffer_size)
+        {
+            size_t new_size = (*buffer_size < MIN_BUFFER_SIZE) ? MIN_BUFFER_SIZE : *buffer_size;
+            unsigned char* new_buffer;
+
+            while (new_size < used + length)
+            {
+                new_size = (new_size > SIZE_MAX / 2) ? (used + length) : (new_size * 2);
+            }
+
+            new_buffer = (unsigned char*)realloc(*buffer, new_size);
+            if (new_buffer == NULL)
+            {
+                LogError("Cannot grow the batch buffer to %lu bytes", (unsigned long)new_size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                *buffer = new_buffer;
+                *buffer_size = new_size;
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if ((result == 0) &&
+            (length > 0))
+        {
+            (void)memcpy(*buffer + used, bytes, length);
+            offsets[row + 1] = used + length;
+        }
+    }
+
+    return result;
+}
+
+static int set_column_value(COLUMN* column, uint32_t row, const AMQP_READER_ITEM* item)
+{
+    int result = 0;
+
+    /* a value given twice (a repeated map key) keeps the first one */
+    if (!column->is_present[row])
+    {
+        switch (column->column_type)
+        {
+        default:
+            break;
+
+        case COLUMNAR_BATCH_COLUMN_TYPE_INT64:
+            if ((item->type == AMQP_TYPE_BYTE) ||
+                (item->type == AMQP_TYPE_SHORT) ||
+                (item->type == AMQP_TYPE_INT) ||
+                (item->type == AMQP_TYPE_LONG) ||
+                (item->type == AMQP_TYPE_TIMESTAMP))
+            {
+                column->int64_values[row] = item->value.signed_value;
+                column->is_present[row] = true;
+            }
+            else if (((item->type == AMQP_TYPE_UBYTE) ||
+                (item->type == AMQP_TYPE_USHORT) ||
+                (item->type == AMQP_TYPE_UINT) ||
+                (item->type == AMQP_TYPE_ULONG)) &&
+                (item->value.unsigned_value <= INT64_MAX))
+            {
+                column->int64_values[row] = (int64_t)item->value.unsigned_value;
+                column->is_present[row] = true;
+            }
+            break;
+
+        case COLUMNAR_BATCH_COLUMN_TYPE_DOUBLE:
+            if (item->type == AMQP_TYPE_DOUBLE)
+            {
+                column->double_values[row] = item->value.double_value;
+                column->is_present[row] = true;
+            }
+            else if (item->type == AMQP_TYPE_FLOAT)
+            {
+                column->double_values[row] = (double)item->value.float_value;
+                column->is_present[row] = true;
+            }
+            else if ((item->type == AMQP_TYPE_BYTE) ||
+                (item->type == AMQP_TYPE_SHORT) ||
+                (item->type == AMQP_TYPE_INT) ||
+                (item->type == AMQP_TYPE_LONG))
+            {
+                column->double_values[row] = (double)item->value.signed_value;
+                column->is_present[row] = true;
+            }
+            else if ((item->type == AMQP_TYPE_UBYTE) ||
+                (item->type == AMQP_TYPE_USHORT) ||
+                (item->type == AMQP_TYPE_UINT) ||
+                (item->type == AMQP_TYPE_ULONG))
+            {
+                column->double_values[row] = (double)item->value.unsigned_value;
+                column->is_present[row] = true;
+            }
+            break;
+
+        case COLUMNAR_BATCH_COLUMN_TYPE_STRING:
+            if ((item->type == AMQP_TYPE_STRING) ||
+                (item->type == AMQP_TYPE_SYMBOL))
+            {
+                if (append_row_bytes(&column->characters, &column->characters_size, column->offsets, row, item->bytes, item->length) != 0)
+                {
+                    LogError("Cannot add the string to column %s", column->name);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    column->is_present[row] = true;
+                }
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int read_map_columns(COLUMNAR_BATCH_INSTANCE* batch, uint32_t row, AMQP_READER* reader, const AMQP_READER_ITEM* map, COLUMNAR_BATCH_SOURCE source)
+{
+    int result;
+
+    if ((batch->source_column_counts[source] == 0) ||
+        (map->type == AMQP_TYPE_NULL))
+    {
+        result = 0;
+    }
+    else if ((map->type != AMQP_TYPE_MAP) ||
+        (amqp_reader_enter(reader, map) != 0))
+    {
+        LogError("Cannot read the map of the section");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+
+        while ((result == 0) &&
+            amqp_reader_has_next(reader))
+        {
+            AMQP_READER_ITEM key;
+            AMQP_READER_ITEM value;
+
+            if ((amqp_reader_next(reader, &key) != 0) ||
+                (amqp_reader_next(reader, &value) != 0))
+            {
+                LogError("Cannot read the map entry");
+                result = __FAILURE__;
+            }
+            else if ((key.type == AMQP_TYPE_SYMBOL) ||
+                (key.type == AMQP_TYPE_STRING))
+            {
+                size_t i;
+
+                for (i = 0; (result == 0) && (i < batch->column_count); i++)
+                {
+                    COLUMN* column = &batch->columns[i];
+
+                    if ((column->source == source) &&
+                        (column->name_length == key.length) &&
+                        (memcmp(column->name, key.bytes, key.length) == 0))
+                    {
+                        result = set_column_value(column, row, &value);
+                    }
+                }
+            }
+            else
+            {
+                /* keys of other types cannot be asked for */
+            }
+        }
+
+        if ((result == 0) &&
+            (amqp_reader_leave(reader) != 0))
+        {
+            LogError("Cannot leave the map of the section");
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+static int read_property_columns(COLUMNAR_BATCH_INSTANCE* batch, uint32_t row, AMQP_READER* reader, const AMQP_READER_ITEM* list)
+{
+    int result;
+
+    if (batch->source_column_counts[COLUMNAR_BATCH_SOURCE_PROPERTY] == 0)
+    {
+        result = 0;
+    }
+    else if ((list->type != AMQP_TYPE_LIST) ||
+        (amqp_reader_enter(reader, list) != 0))
+    {
+        LogError("Cannot read the properties list");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t property_index = 0;
+
+        result = 0;
+
+        while ((result == 0) &&
+            amqp_reader_has_next(reader))
+        {
+            AMQP_READER_ITEM field;
+
+            if (amqp_reader_next(reader, &field) != 0)
+            {
+                LogError("Cannot read the properties field %u", (unsigned int)property_index);
+                result = __FAILURE__;
+            }
+            else
+            {
+                size_t i;
+
+                for (i = 0; (result == 0) && (i < batch->column_count); i++)
+                {
+                    if ((batch->columns[i].source == COLUMNAR_BATCH_SOURCE_PROPERTY) &&
+                        (batch->columns[i].property_index == property_index))
+                    {
+                        result = set_column_value(&batch->columns[i], row, &field);
+                    }
+                }
+
+                property_index++;
+            }
+        }
+
+        if ((result == 0) &&
+            (amqp_reader_leave(reader) != 0))
+        {
+            LogError("Cannot leave the properties list");
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+static int read_sections(COLUMNAR_BATCH_INSTANCE* batch, uint32_t row, const unsigned char* bytes, size_t length)
+{
+    int result;
+    AMQP_READER reader;
+
+    if (amqp_reader_init(&reader, bytes, length) != 0)
+    {
+        LogError("Cannot read the message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+
+        while ((result == 0) &&
+            amqp_reader_has_next(&reader))
+        {
+            AMQP_READER_ITEM section;
+            AMQP_READER_ITEM descriptor;
+            AMQP_READER_ITEM value;
+
+            if ((amqp_reader_next(&reader, &section) != 0) ||
+                (section.type != AMQP_TYPE_DESCRIBED) ||
+                (amqp_reader_enter(&reader, &section) != 0) ||
+                (amqp_reader_next(&reader, &descriptor) != 0) ||
+                (amqp_reader_next(&reader, &value) != 0))
+            {
+                LogError("Cannot read the message section");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* sections described with a symbol are not laid out */
+                if (descriptor.type == AMQP_TYPE_ULONG)
+                {
+                    switch (descriptor.value.unsigned_value)
+                    {
+                    default:
+                        break;
+
+                    /* message-annotations */
+                    case 0x72:
+                        result = read_map_columns(batch, row, &reader, &value, COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION);
+                        break;
+                    /* properties */
+                    case 0x73:
+                        result = read_property_columns(batch, row, &reader, &value);
+                        break;
+                    /* application-properties */
+                    case 0x74:
+                        result = read_map_columns(batch, row, &reader, &value, COLUMNAR_BATCH_SOURCE_APPLICATION_PROPERTY);
+                        break;
+                    /* data */
+                    case 0x75:
+                        if (value.type != AMQP_TYPE_BINARY)
+                        {
+                            LogError("Data section not holding a binary");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            result = append_row_bytes(&batch->body_bytes, &batch->body_bytes_size, batch->body_offsets, row, value.bytes, value.length);
+                        }
+                        break;
+                    /* amqp-value */
+                    case 0x77:
+                        if ((value.type == AMQP_TYPE_BINARY) ||
+                            (value.type == AMQP_TYPE_STRING))
+                        {
+                            result = append_row_bytes(&batch->body_bytes, &batch->body_bytes_size, batch->body_offsets, row, value.bytes, value.length);
+                        }
+                        break;
+                    }
+                }
+
+                if ((result == 0) &&
+                    (amqp_reader_leave(&reader) != 0))
+                {
+                    LogError("Cannot leave the message section");
+                    result = __FAILURE__;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+COLUMNAR_BATCH_HANDLE columnar_batch_create(uint32_t max_rows)
+{
+    COLUMNAR_BATCH_INSTANCE* result;
+
+    if ((max_rows == 0) ||
+        (max_rows >= SIZE_MAX / sizeof(size_t)))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_002: [ If `max_rows` is 0 or too big for its columns to be allocated, `columnar_batch_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: max_rows = %u", (unsigned int)max_rows);
+        result = NULL;
+    }
+    else
+    {
+        result = (COLUMNAR_BATCH_INSTANCE*)malloc(sizeof(COLUMNAR_BATCH_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_COLUMNAR_BATCH_01_003: [ If any allocation fails, `columnar_batch_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the columnar batch");
+        }
+        else
+        {
+            result->delivery_ids = (delivery_number*)malloc(sizeof(delivery_number) * max_rows);
+            if (result->delivery_ids == NULL)
+            {
+                /* Codes_SRS_COLUMNAR_BATCH_01_003: [ If any allocation fails, `columnar_batch_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate the delivery ids");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->body_offsets = (size_t*)calloc((size_t)max_rows + 1, sizeof(size_t));
+                if (result->body_offsets == NULL)
+                {
+                    /* Codes_SRS_COLUMNAR_BATCH_01_003: [ If any allocation fails, `columnar_batch_create` shall fail and return NULL. ]*/
+                    LogError("Cannot allocate the body offsets");
+                    free(result->delivery_ids);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    /* Codes_SRS_COLUMNAR_BATCH_01_001: [ `columnar_batch_create` shall create an empty batch of at most `max_rows` rows, with the delivery id and body columns only, and on success return a non-NULL handle to it. ]*/
+                    result->max_rows = max_rows;
+                    result->row_count = 0;
+                    /* the bodies are allocated on the first append, when their size is known */
+                    result->body_bytes = NULL;
+                    result->body_bytes_size = 0;
+                    result->columns = NULL;
+                    result->column_count = 0;
+                    (void)memset(result->source_column_counts, 0, sizeof(result->source_column_counts));
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void columnar_batch_destroy(COLUMNAR_BATCH_HANDLE batch)
+{
+    if (batch == NULL)
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_005: [ If `batch` is NULL, `columnar_batch_destroy` shall do nothing. ]*/
+        LogError("NULL batch");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_COLUMNAR_BATCH_01_004: [ `columnar_batch_destroy` shall free the columns and the batch. ]*/
+        for (i = 0; i < batch->column_count; i++)
+        {
+            free_column(&batch->columns[i]);
+        }
+
+        free(batch->columns);
+        free(batch->body_bytes);
+        free(batch->body_offsets);
+        free(batch->delivery_ids);
+        free(batch);
+    }
+}
+
+int columnar_batch_add_column(COLUMNAR_BATCH_HANDLE batch, COLUMNAR_BATCH_SOURCE source, const char* name, COLUMNAR_BATCH_COLUMN_TYPE column_type, size_t* column_index)
+{
+    int result;
+
+    if ((batch == NULL) ||
+        (name == NULL) ||
+        (column_index == NULL) ||
+        ((source != COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION) && (source != COLUMNAR_BATCH_SOURCE_PROPERTY) && (source != COLUMNAR_BATCH_SOURCE_APPLICATION_PROPERTY)) ||
+        ((column_type != COLUMNAR_BATCH_COLUMN_TYPE_INT64) && (column_type != COLUMNAR_BATCH_COLUMN_TYPE_DOUBLE) && (column_type != COLUMNAR_BATCH_COLUMN_TYPE_STRING)))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_007: [ If `batch`, `name` or `column_index` is NULL, or `source` or `column_type` is not a known value, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, source = %d, name = %p, column_type = %d, column_index = %p",
+            batch, (int)source, name, (int)column_type, column_index);
+        result = __FAILURE__;
+    }
+    else if (batch->row_count > 0)
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_008: [ If the batch has rows, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+        LogError("Columns can only be added to an empty batch");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t property_index = 0;
+
+        if (source == COLUMNAR_BATCH_SOURCE_PROPERTY)
+        {
+            while ((property_index < sizeof(property_names) / sizeof(property_names[0])) &&
+                (strcmp(property_names[property_index], name) != 0))
+            {
+                property_index++;
+            }
+        }
+
+        if (property_index == sizeof(property_names) / sizeof(property_names[0]))
+        {
+            /* Codes_SRS_COLUMNAR_BATCH_01_009: [ If `source` is `COLUMNAR_BATCH_SOURCE_PROPERTY` and `name` is not the name of a field of the properties section, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+            LogError("Unknown properties field %s", name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            COLUMN* new_columns = (COLUMN*)realloc(batch->columns, sizeof(COLUMN) * (batch->column_count + 1));
+            if (new_columns == NULL)
+            {
+                /* Codes_SRS_COLUMNAR_BATCH_01_010: [ If any allocation fails, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+                LogError("Cannot grow the columns");
+                result = __FAILURE__;
+            }
+            else
+            {
+                COLUMN* column = &new_columns[batch->column_count];
+                size_t name_length = strlen(name);
+
+                batch->columns = new_columns;
+                (void)memset(column, 0, sizeof(COLUMN));
+                column->source = source;
+                column->column_type = column_type;
+                column->name_length = name_length;
+                column->property_index = property_index;
+                column->name = (char*)malloc(name_length + 1);
+                column->is_present = (bool*)calloc(batch->max_rows, sizeof(bool));
+
+                if (column_type == COLUMNAR_BATCH_COLUMN_TYPE_INT64)
+                {
+                    column->int64_values = (int64_t*)malloc(sizeof(int64_t) * batch->max_rows);
+                }
+                else if (column_type == COLUMNAR_BATCH_COLUMN_TYPE_DOUBLE)
+                {
+                    column->double_values = (double*)malloc(sizeof(double) * batch->max_rows);
+                }
+                else
+                {
+                    column->offsets = (size_t*)calloc((size_t)batch->max_rows + 1, sizeof(size_t));
+                }
+
+                if ((column->name == NULL) ||
+                    (column->is_present == NULL) ||
+                    ((column->int64_values == NULL) && (column->double_values == NULL) && (column->offsets == NULL)))
+                {
+                    /* Codes_SRS_COLUMNAR_BATCH_01_010: [ If any allocation fails, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+                    LogError("Cannot allocate column %s", name);
+                    free_column(column);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_COLUMNAR_BATCH_01_006: [ `columnar_batch_add_column` shall add a column of type `column_type` for the message annotation, properties field or application property `name`, as given by `source`, set `column_index` to its index and return 0. ]*/
+                    (void)memcpy(column->name, name, name_length + 1);
+                    batch->source_column_counts[source]++;
+                    *column_index = batch->column_count;
+                    batch->column_count++;
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int columnar_batch_append_message(COLUMNAR_BATCH_HANDLE batch, delivery_number delivery_id, const unsigned char* bytes, size_t length)
+{
+    int result;
+
+    if ((batch == NULL) ||
+        (bytes == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_012: [ If `batch` or `bytes` is NULL, `columnar_batch_append_message` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, bytes = %p",
+            batch, bytes);
+        result = __FAILURE__;
+    }
+    else if (batch->row_count == batch->max_rows)
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_013: [ If the batch holds `max_rows` rows, `columnar_batch_append_message` shall fail and return a non-zero value. ]*/
+        LogError("The batch is full");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t row = batch->row_count;
+        size_t i;
+
+        /* everything of the row is written after the end of the previous one, a failed row is simply overwritten by the next */
+        batch->body_offsets[row + 1] = batch->body_offsets[row];
+        for (i = 0; i < batch->column_count; i++)
+        {
+            batch->columns[i].is_present[row] = false;
+            if (batch->columns[i].offsets != NULL)
+            {
+                batch->columns[i].offsets[row + 1] = batch->columns[i].offsets[row];
+            }
+        }
+
+        /* Codes_SRS_COLUMNAR_BATCH_01_011: [ `columnar_batch_append_message` shall read the sections encoded in the `length` bytes of `bytes` with the AMQP reader, without decoding them into AMQP values, add a row holding `delivery_id`, the body and the value of every column and return 0. ]*/
+        /* Codes_SRS_COLUMNAR_BATCH_01_015: [ The body of the row shall be the concatenation of the data sections of the message, or the bytes of its amqp-value section if it holds a binary or a string, and shall be empty otherwise. ]*/
+        /* Codes_SRS_COLUMNAR_BATCH_01_016: [ A column value missing from the message, or of a type the column cannot hold, shall be marked as not present. ]*/
+        if (read_sections(batch, row, bytes, length) != 0)
+        {
+            /* Codes_SRS_COLUMNAR_BATCH_01_014: [ If the bytes cannot be read as message sections, or growing the bodies or a string column fails, `columnar_batch_append_message` shall fail, not add the row and return a non-zero value. ]*/
+            LogError("Cannot lay out the message in the batch");
+            result = __FAILURE__;
+        }
+        else
+        {
+            batch->delivery_ids[row] = delivery_id;
+            batch->row_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+void columnar_batch_clear(COLUMNAR_BATCH_HANDLE batch)
+{
+    if (batch == NULL)
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_018: [ If `batch` is NULL, `columnar_batch_clear` shall do nothing. ]*/
+        LogError("NULL batch");
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_017: [ `columnar_batch_clear` shall remove all the rows of the batch, keeping its columns. ]*/
+        batch->row_count = 0;
+    }
+}
+
+int columnar_batch_get_row_count(COLUMNAR_BATCH_HANDLE batch, uint32_t* row_count)
+{
+    int result;
+
+    if ((batch == NULL) ||
+        (row_count == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_020: [ If `batch` or `row_count` is NULL, `columnar_batch_get_row_count` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, row_count = %p",
+            batch, row_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_019: [ `columnar_batch_get_row_count` shall set `row_count` to the number of rows of the batch and return 0. ]*/
+        *row_count = batch->row_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+int columnar_batch_get_max_row_count(COLUMNAR_BATCH_HANDLE batch, uint32_t* max_row_count)
+{
+    int result;
+
+    if ((batch == NULL) ||
+        (max_row_count == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_022: [ If `batch` or `max_row_count` is NULL, `columnar_batch_get_max_row_count` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, max_row_count = %p",
+            batch, max_row_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_021: [ `columnar_batch_get_max_row_count` shall set `max_row_count` to the `max_rows` the batch was created with and return 0. ]*/
+        *max_row_count = batch->max_rows;
+        result = 0;
+    }
+
+    return result;
+}
+
+int columnar_batch_get_delivery_ids(COLUMNAR_BATCH_HANDLE batch, const delivery_number** delivery_ids)
+{
+    int result;
+
+    if ((batch == NULL) ||
+        (delivery_ids == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_024: [ If `batch` or `delivery_ids` is NULL, `columnar_batch_get_delivery_ids` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, delivery_ids = %p",
+            batch, delivery_ids);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_023: [ `columnar_batch_get_delivery_ids` shall set `delivery_ids` to the delivery ids of the rows and return 0. ]*/
+        *delivery_ids = batch->delivery_ids;
+        result = 0;
+    }
+
+    return result;
+}
+
+int columnar_batch_get_bodies(COLUMNAR_BATCH_HANDLE batch, const unsigned char** body_bytes, const size_t** body_offsets)
+{
+    int result;
+
+    if ((batch == NULL) ||
+        (body_bytes == NULL) ||
+        (body_offsets == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_026: [ If `batch`, `body_bytes` or `body_offsets` is NULL, `columnar_batch_get_bodies` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, body_bytes = %p, body_offsets = %p",
+            batch, body_bytes, body_offsets);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_025: [ `columnar_batch_get_bodies` shall set `body_bytes` to the buffer holding the bodies of all the rows and `body_offsets` to their row count + 1 offsets in it and return 0. ]*/
+        *body_bytes = batch->body_bytes;
+        *body_offsets = batch->body_offsets;
+        result = 0;
+    }
+
+    return result;
+}
+
+static COLUMN* get_typed_column(COLUMNAR_BATCH_INSTANCE* batch, size_t column_index, COLUMNAR_BATCH_COLUMN_TYPE column_type)
+{
+    COLUMN* result;
+
+    if (column_index >= batch->column_count)
+    {
+        LogError("No column %lu", (unsigned long)column_index);
+        result = NULL;
+    }
+    else if (batch->columns[column_index].column_type != column_type)
+    {
+        LogError("Column %lu is not of type %d", (unsigned long)column_index, (int)column_type);
+        result = NULL;
+    }
+    else
+    {
+        result = &batch->columns[column_index];
+    }
+
+    return result;
+}
+
+int columnar_batch_get_int64_column(COLUMNAR_BATCH_HANDLE batch, size_t column_index, const int64_t** values, const bool** is_present)
+{
+    int result;
+    COLUMN* column;
+
+    if ((batch == NULL) ||
+        (values == NULL) ||
+        (is_present == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_028: [ If `batch`, `values` or `is_present` is NULL, `columnar_batch_get_int64_column` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, values = %p, is_present = %p",
+            batch, values, is_present);
+        result = __FAILURE__;
+    }
+    else if ((column = get_typed_column(batch, column_index, COLUMNAR_BATCH_COLUMN_TYPE_INT64)) == NULL)
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_029: [ If there is no column `column_index`, or it is not of the type asked for, the column getters shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_027: [ `columnar_batch_get_int64_column` shall set `values` and `is_present` to the values of the INT64 column `column_index` and whether each row has one, and return 0. ]*/
+        *values = column->int64_values;
+        *is_present = column->is_present;
+        result = 0;
+    }
+
+    return result;
+}
+
+int columnar_batch_get_double_column(COLUMNAR_BATCH_HANDLE batch, size_t column_index, const double** values, const bool** is_present)
+{
+    int result;
+    COLUMN* column;
+
+    if ((batch == NULL) ||
+        (values == NULL) ||
+        (is_present == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_031: [ If `batch`, `values` or `is_present` is NULL, `columnar_batch_get_double_column` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, values = %p, is_present = %p",
+            batch, values, is_present);
+        result = __FAILURE__;
+    }
+    else if ((column = get_typed_column(batch, column_index, COLUMNAR_BATCH_COLUMN_TYPE_DOUBLE)) == NULL)
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_029: [ If there is no column `column_index`, or it is not of the type asked for, the column getters shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_030: [ `columnar_batch_get_double_column` shall set `values` and `is_present` to the values of the DOUBLE column `column_index` and whether each row has one, and return 0. ]*/
+        *values = column->double_values;
+        *is_present = column->is_present;
+        result = 0;
+    }
+
+    return result;
+}
+
+int columnar_batch_get_string_column(COLUMNAR_BATCH_HANDLE batch, size_t column_index, const char** characters, const size_t** offsets, const bool** is_present)
+{
+    int result;
+    COLUMN* column;
+
+    if ((batch == NULL) ||
+        (characters == NULL) ||
+        (offsets == NULL) ||
+        (is_present == NULL))
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_033: [ If `batch`, `characters`, `offsets` or `is_present` is NULL, `columnar_batch_get_string_column` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: batch = %p, characters = %p, offsets = %p, is_present = %p",
+            batch, characters, offsets, is_present);
+        result = __FAILURE__;
+    }
+    else if ((column = get_typed_column(batch, column_index, COLUMNAR_BATCH_COLUMN_TYPE_STRING)) == NULL)
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_029: [ If there is no column `column_index`, or it is not of the type asked for, the column getters shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_COLUMNAR_BATCH_01_032: [ `columnar_batch_get_string_column` shall set `characters`, `offsets` and `is_present` to the characters of the STRING column `column_index`, their row count + 1 offsets and whether each row has one, and return 0. ]*/
+        *characters = (const char*)column->characters;
+        *offsets = column->offsets;
+        *is_present = column->is_present;
+        result = 0;
+    }
+
+    return result;
+}
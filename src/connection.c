@@ -9,6 +9,7 @@
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/refcount.h"
 
 #include "azure_uamqp_c/connection.h"
 #include "azure_uamqp_c/frame_codec.h"
@@ -16,6 +17,14 @@
 #include "azure_uamqp_c/amqp_frame_codec.h"
 #include "azure_uamqp_c/amqp_definitions.h"
 #include "azure_uamqp_c/amqpvalue_to_string.h"
+#include "azure_uamqp_c/frame_trace.h"
+#include "azure_uamqp_c/admission_limiter.h"
+#include "azure_uamqp_c/buffer_pool.h"
+#include "azure_uamqp_c/uamqp_tracepoints.h"
+#include "azure_uamqp_c/uamqp_static_pools.h"
+
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_CONNECTION
+#include "azure_uamqp_c/alloc_counters.h"
 
 /* Requirements satisfied by the virtue of implementing the ISO:*/
 /* Codes_SRS_CONNECTION_01_088: [Any data appearing beyond the protocol header MUST match the version indicated by the protocol header.] */
@@ -24,6 +33,10 @@
 /* Codes_SRS_CONNECTION_01_087: [The protocol header consists of the upper case ASCII letters "AMQP" followed by a protocol id of zero, followed by three unsigned bytes representing the major, minor, and revision of the protocol version (currently 1 (MAJOR), 0 (MINOR), 0 (REVISION)). In total this is an 8-octet sequence] */
 static const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
 
+/* the handover state is a list of the version and the negotiated values, read back by a build that knows this version */
+#define CONNECTION_HANDOVER_STATE_VERSION 1
+#define CONNECTION_HANDOVER_STATE_FIELD_COUNT 6
+
 typedef enum RECEIVE_FRAME_STATE_TAG
 {
     RECEIVE_FRAME_STATE_FRAME_SIZE,
@@ -34,54 +47,187 @@ typedef struct ENDPOINT_INSTANCE_TAG
 {
     uint16_t incoming_channel;
     uint16_t outgoing_channel;
+    bool has_incoming_channel;
     ON_ENDPOINT_FRAME_RECEIVED on_endpoint_frame_received;
     ON_CONNECTION_STATE_CHANGED on_connection_state_changed;
     void* callback_context;
+    ON_SEND_QUEUE_DRAINED on_send_queue_drained;
+    void* on_send_queue_drained_context;
+    ON_ENDPOINT_DOWORK on_dowork;
+    void* on_dowork_context;
     CONNECTION_HANDLE connection;
 } ENDPOINT_INSTANCE;
 
+typedef struct SEND_COMPLETION_TAG
+{
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+} SEND_COMPLETION;
+
+/* the io can complete a batch send after the connection is gone, so the batch send keeps its own copy of the allocator */
+typedef struct OUTGOING_BATCH_SEND_TAG
+{
+    SEND_COMPLETION* completions;
+    size_t completion_count;
+    CONNECTION_ALLOCATOR allocator;
+} OUTGOING_BATCH_SEND;
+
+/* the bytes handed to the io and not completed yet, shared with the sends since the io can complete them after the connection is gone */
+typedef struct SEND_QUEUE_TAG
+{
+    size_t queued_bytes;
+    CONNECTION_ALLOCATOR allocator;
+} SEND_QUEUE;
+
+DEFINE_REFCOUNT_TYPE(SEND_QUEUE);
+
+typedef struct QUEUED_SEND_TAG
+{
+    SEND_QUEUE* send_queue;
+    size_t length;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+} QUEUED_SEND;
+
 typedef struct CONNECTION_INSTANCE_TAG
 {
-    XIO_HANDLE io;
-    size_t header_bytes_received;
+    /* hot: touched by every byte or frame received and every frame sent, kept together in the first cache lines */
     CONNECTION_STATE connection_state;
+    unsigned int is_underlying_io_open : 1;
+    unsigned int idle_timeout_specified : 1;
+    unsigned int is_remote_frame_received : 1;
+    unsigned int is_trace_on : 1;
+    unsigned int is_encoding_batched_frame : 1;
+    unsigned int is_pipelined_open : 1;
+    unsigned int is_send_queue_full : 1;
+    unsigned int is_memory_quota_exceeded : 1;
+    unsigned int is_receive_paused : 1;
+    XIO_HANDLE io;
     FRAME_CODEC_HANDLE frame_codec;
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec;
+    /* incoming channel -> endpoint table, grown on demand up to channel_max + 1 entries */
+    ENDPOINT_INSTANCE** endpoints_by_incoming_channel;
+    uint32_t incoming_channel_table_size;
+    /* while held, every encoded frame goes to the outgoing batch and is only sent once the last hold is released */
+    uint32_t outgoing_batch_hold_count;
+    FRAME_TRACE_HANDLE frame_trace;
+    /* read from the tick counter once per connection_handle_deadlines, idle timeouts do not need a fresher time for each frame */
+    tickcounter_ms_t coarse_current_ms;
+    tickcounter_ms_t last_frame_received_time;
+    tickcounter_ms_t last_frame_sent_time;
+    /* encoded endpoint frames waiting to be handed to the io in one xio_send, together with their send completions */
+    unsigned char* outgoing_batch;
+    size_t outgoing_batch_length;
+    size_t outgoing_batch_capacity;
+    uint32_t outgoing_batch_size;
+    uint32_t remote_max_frame_size;
+    SEND_QUEUE* send_queue;
+    /* 0 when there is no quota, otherwise the received frames and the buffers of the links are charged against it */
+    size_t memory_quota;
+    size_t memory_in_use;
+    /* bytes handed to the application and not settled yet, reads from the io are paused while they are over receive_pause_backlog */
+    size_t receive_backlog;
+    size_t receive_pause_backlog;
+    /* counted for every frame, right after the hot fields */
+    CONNECTION_STATS stats;
+
+    /* warm: per batch, per endpoint or per deadline */
+    SEND_COMPLETION* outgoing_batch_completions;
+    size_t outgoing_batch_completion_count;
+    size_t outgoing_batch_completion_capacity;
+    milliseconds outgoing_batch_delay;
+    tickcounter_ms_t outgoing_batch_start_time;
+    /* number of endpoints with an on_dowork callback, connection_dowork only holds the outgoing batch for them when there are some */
+    uint32_t dowork_endpoint_count;
+    uint32_t max_frame_size;
+    /* used for the connection itself, its endpoints and the frames it sends */
+    CONNECTION_ALLOCATOR allocator;
+    /* endpoints sorted by outgoing channel, the array grows by doubling and is only freed when it becomes empty */
     ENDPOINT_INSTANCE** endpoints;
     uint32_t endpoint_count;
-    char* host_name;
-    char* container_id;
+    uint32_t endpoint_capacity;
+    size_t send_queue_high_water_mark;
+    size_t send_queue_low_water_mark;
+    size_t low_memory_mark;
+    size_t receive_resume_backlog;
+    /* under a quota the frames are received in this buffer, kept and only grown so that it is charged once */
+    unsigned char* quota_receive_buffer;
+    uint32_t quota_receive_buffer_size;
+    uint32_t pool_receive_buffer_charge;
+    /* NULL when the frames are not received in pool buffers, the charge is the size of the frame held in one */
+    BUFFER_POOL_HANDLE receive_buffer_pool;
     TICK_COUNTER_HANDLE tick_counter;
-    uint32_t remote_max_frame_size;
+    milliseconds idle_timeout;
+    milliseconds remote_idle_timeout;
+    milliseconds remote_idle_timeout_send_frame_millisecond;
+    double idle_timeout_empty_frame_send_ratio;
+    /* 0 when the application callbacks are not timed */
+    milliseconds callback_budget;
+    /* bytes_sent when connection_get_io_interest was last called, to tell whether bytes went to the io since */
+    uint64_t io_interest_bytes_sent;
 
+    /* cold: configuration and callbacks only used when opening, closing or on connection level events */
     ON_SEND_COMPLETE on_send_complete;
     void* on_send_complete_callback_context;
-
     ON_NEW_ENDPOINT on_new_endpoint;
     void* on_new_endpoint_callback_context;
-
+    /* remote begins it does not admit are refused without creating an endpoint */
+    ADMISSION_LIMITER_HANDLE session_admission_limiter;
     ON_CONNECTION_STATE_CHANGED on_connection_state_changed;
     void* on_connection_state_changed_callback_context;
     ON_IO_ERROR on_io_error;
     void* on_io_error_callback_context;
-
-    /* options */
-    uint32_t max_frame_size;
-    uint16_t channel_max;
-    milliseconds idle_timeout;
-    milliseconds remote_idle_timeout;
-    milliseconds remote_idle_timeout_send_frame_millisecond;
-    double idle_timeout_empty_frame_send_ratio;
-    tickcounter_ms_t last_frame_received_time;
-    tickcounter_ms_t last_frame_sent_time;
+    ON_CONNECTION_FLOW_EVENT on_flow_event;
+    void* on_flow_event_context;
+    size_t header_bytes_received;
+    char* host_name;
+    char* container_id;
     fields properties;
-
-    unsigned int is_underlying_io_open : 1;
-    unsigned int idle_timeout_specified : 1;
-    unsigned int is_remote_frame_received : 1;
-    unsigned int is_trace_on : 1;
+    uint16_t channel_max;
+    uint32_t frame_size_alignment;
+    CONNECTION_CALLBACK_STATS callback_stats;
+    /* restored from a handover state, the next open of the io resumes the connection instead of negotiating it */
+    bool is_resuming_handover;
 } CONNECTION_INSTANCE;
 
+static void complete_outgoing_batch(CONNECTION_HANDLE connection, IO_SEND_RESULT send_result);
+
+/* true from the header being sent until the peer's open is received, when the connection pipelines its open */
+static bool is_pipelining_open(CONNECTION_HANDLE connection)
+{
+    return (connection->is_pipelined_open) &&
+        ((connection->connection_state == CONNECTION_STATE_HDR_SENT) ||
+        (connection->connection_state == CONNECTION_STATE_OPEN_PIPE) ||
+        (connection->connection_state == CONNECTION_STATE_OPEN_SENT));
+}
+
+/* callers check frame_trace first, so connections without a frame trace do not even read the tick counter */
+static void trace_frame_bytes(CONNECTION_HANDLE connection, FRAME_TRACE_DIRECTION direction, FRAME_TRACE_FRAME_TYPE frame_type, uint16_t channel, const unsigned char* performative_bytes, size_t performative_size, uint32_t payload_size)
+{
+    tickcounter_ms_t current_ms;
+
+    if (tickcounter_get_current_ms(connection->tick_counter, &current_ms) != 0)
+    {
+        LogError("Cannot get tickcounter value for the frame trace");
+    }
+    else if (frame_trace_record_bytes(connection->frame_trace, direction, frame_type, channel, (uint64_t)current_ms, performative_bytes, performative_size, payload_size) != 0)
+    {
+        LogError("Cannot add the frame to the frame trace");
+    }
+}
+
+/* the amqp_frame_codec hands over the performative bytes it decoded or encoded, so they are not encoded again for the trace */
+static void on_amqp_performative_bytes(void* context, bool is_outgoing, uint16_t channel, const unsigned char* performative_bytes, size_t performative_size, uint32_t payload_size)
+{
+    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
+
+    /* Codes_SRS_CONNECTION_01_311: [When a frame trace is set, every frame received and sent, protocol headers and empty frames included, shall be recorded in it.] */
+    if (connection->frame_trace != NULL)
+    {
+        trace_frame_bytes(connection, is_outgoing ? FRAME_TRACE_DIRECTION_OUTGOING : FRAME_TRACE_DIRECTION_INCOMING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, channel, performative_bytes, performative_size, payload_size);
+    }
+}
+
 /* Codes_SRS_CONNECTION_01_258: [on_connection_state_changed shall be invoked whenever the connection state changes.]*/
 static void connection_set_state(CONNECTION_HANDLE connection, CONNECTION_STATE connection_state)
 {
@@ -90,6 +236,12 @@ static void connection_set_state(CONNECTION_HANDLE connection, CONNECTION_STATE
     CONNECTION_STATE previous_state = connection->connection_state;
     connection->connection_state = connection_state;
 
+    if (connection_state == CONNECTION_STATE_END)
+    {
+        /* Codes_SRS_CONNECTION_01_281: [When the connection reaches the END state, the send completions of any frames still waiting in the outgoing batch shall be called with IO_SEND_CANCELLED and the frames shall be discarded.] */
+        complete_outgoing_batch(connection, IO_SEND_CANCELLED);
+    }
+
     /* Codes_SRS_CONNECTION_22_001: [If a connection state changed occurs and a callback is registered the callback shall be called.] */
     if (connection->on_connection_state_changed)
     {
@@ -112,13 +264,142 @@ static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result
     (void)send_result;
 }
 
+static int add_to_outgoing_batch(CONNECTION_HANDLE connection, const unsigned char* bytes, size_t length, bool encode_complete);
+
+/* the default allocator goes through the (possibly gballoc) malloc family, like the rest of the library */
+static void* default_malloc(void* context, size_t size)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void* default_realloc(void* context, void* ptr, size_t size)
+{
+    (void)context;
+    return realloc(ptr, size);
+}
+
+static void default_free(void* context, void* ptr)
+{
+    (void)context;
+    free(ptr);
+}
+
+static const CONNECTION_ALLOCATOR default_allocator = { default_malloc, default_realloc, default_free, NULL };
+
+static void* connection_malloc(CONNECTION_HANDLE connection, size_t size)
+{
+    return connection->allocator.malloc_function(connection->allocator.context, size);
+}
+
+static void* connection_realloc(CONNECTION_HANDLE connection, void* ptr, size_t size)
+{
+    return connection->allocator.realloc_function(connection->allocator.context, ptr, size);
+}
+
+static void connection_free(CONNECTION_HANDLE connection, void* ptr)
+{
+    /* free(NULL) is a no-op, custom allocators do not have to handle it */
+    if (ptr != NULL)
+    {
+        connection->allocator.free_function(connection->allocator.context, ptr);
+    }
+}
+
+static void release_send_queue(SEND_QUEUE* send_queue)
+{
+    if (DEC_REF(SEND_QUEUE, send_queue) == DEC_RETURN_ZERO)
+    {
+        free(send_queue);
+    }
+}
+
+static void on_queued_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    QUEUED_SEND* queued_send = (QUEUED_SEND*)context;
+
+    /* Codes_SRS_CONNECTION_01_337: [The bytes of a send shall stay in the send queue until the io indicates that the send completed, whatever its result.] */
+    queued_send->send_queue->queued_bytes -= queued_send->length;
+    queued_send->on_send_complete(queued_send->callback_context, send_result);
+
+    /* the queued send is freed before the send queue that holds the allocator */
+    queued_send->send_queue->allocator.free_function(queued_send->send_queue->allocator.context, queued_send);
+    release_send_queue(queued_send->send_queue);
+}
+
+static int send_to_io(CONNECTION_HANDLE connection, const unsigned char* bytes, size_t length, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (connection->send_queue_high_water_mark == 0)
+    {
+        result = xio_send(connection->io, bytes, length, on_send_complete, callback_context);
+    }
+    else
+    {
+        QUEUED_SEND* queued_send = (QUEUED_SEND*)connection_malloc(connection, sizeof(QUEUED_SEND));
+        if (queued_send == NULL)
+        {
+            LogError("Cannot allocate memory for the queued send");
+            result = __FAILURE__;
+        }
+        else
+        {
+            queued_send->send_queue = connection->send_queue;
+            queued_send->length = length;
+            queued_send->on_send_complete = on_send_complete;
+            queued_send->callback_context = callback_context;
+
+            /* counted before the send, the io is free to complete it before xio_send returns */
+            INC_REF(SEND_QUEUE, connection->send_queue);
+            connection->send_queue->queued_bytes += length;
+
+            if (xio_send(connection->io, bytes, length, on_queued_send_complete, queued_send) != 0)
+            {
+                connection->send_queue->queued_bytes -= length;
+                release_send_queue(connection->send_queue);
+                connection_free(connection, queued_send);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_CONNECTION_01_338: [When the send queue holds more bytes than the high water mark, the send queue shall be full.] */
+                if (!connection->is_send_queue_full &&
+                    (connection->send_queue->queued_bytes > connection->send_queue_high_water_mark))
+                {
+                    connection->is_send_queue_full = 1;
+                    connection->stats.send_queue_stalls++;
+
+                    /* Codes_SRS_CONNECTION_01_416: [When the send queue becomes full, the connection shall report CONNECTION_FLOW_EVENT_SEND_QUEUE_FULL with the connection as source and the queued bytes as value.] */
+                    connection_report_flow_event(connection, CONNECTION_FLOW_EVENT_SEND_QUEUE_FULL, connection, NULL, connection->send_queue->queued_bytes);
+                }
+
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
 static int send_header(CONNECTION_HANDLE connection)
 {
     int result;
+    int send_result;
 
     /* Codes_SRS_CONNECTION_01_093: [_ When the client opens a new socket connection to a server, it MUST send a protocol header with the client's preferred protocol version.] */
-    /* Codes_SRS_CONNECTION_01_104: [Sending the protocol header shall be done by using xio_send.] */
-    if (xio_send(connection->io, amqp_header, sizeof(amqp_header), unchecked_on_send_complete, NULL) != 0)
+    if (connection->is_pipelined_open)
+    {
+        /* Codes_SRS_CONNECTION_01_322: [When the open is pipelined, the protocol header, the open frame and the frames encoded until the peer's open frame is received shall be accumulated in the outgoing batch.] */
+        send_result = add_to_outgoing_batch(connection, amqp_header, sizeof(amqp_header), false);
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_104: [Sending the protocol header shall be done by using xio_send.] */
+        send_result = xio_send(connection->io, amqp_header, sizeof(amqp_header), unchecked_on_send_complete, NULL);
+    }
+
+    if (send_result != 0)
     {
         /* Codes_SRS_CONNECTION_01_106: [When sending the protocol header fails, the connection shall be immediately closed.] */
         if (xio_close(connection->io, NULL, NULL) != 0)
@@ -134,11 +415,18 @@ static int send_header(CONNECTION_HANDLE connection)
     }
     else
     {
+        connection->stats.bytes_sent += sizeof(amqp_header);
+
         if (connection->is_trace_on == 1)
         {
             LOG(AZ_LOG_TRACE, LOG_LINE, "-> Header (AMQP 0.1.0.0)");
         }
 
+        if (connection->frame_trace != NULL)
+        {
+            trace_frame_bytes(connection, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_HEADER, 0, amqp_header, sizeof(amqp_header), 0);
+        }
+
         /* Codes_SRS_CONNECTION_01_041: [HDR SENT In this state the connection header has been sent to the peer but no connection header has been received.] */
         connection_set_state(connection, CONNECTION_STATE_HDR_SENT);
         result = 0;
@@ -147,69 +435,72 @@ static int send_header(CONNECTION_HANDLE connection)
     return result;
 }
 
-static const char* get_frame_type_as_string(AMQP_VALUE descriptor)
+/* indexed by the performative code minus AMQP_OPEN */
+static const char* const frame_type_strings[] =
+{
+    "[OPEN]",
+    "[BEGIN]",
+    "[ATTACH]",
+    "[FLOW]",
+    "[TRANSFER]",
+    "[DISPOSITION]",
+    "[DETACH]",
+    "[END]",
+    "[CLOSE]"
+};
+
+static const char* get_frame_type_as_string(uint64_t performative_code)
 {
     const char* result;
 
-    if (is_open_type_by_descriptor(descriptor))
-    {
-        result = "[OPEN]";
-    }
-    else if (is_begin_type_by_descriptor(descriptor))
-    {
-        result = "[BEGIN]";
-    }
-    else if (is_attach_type_by_descriptor(descriptor))
-    {
-        result = "[ATTACH]";
-    }
-    else if (is_flow_type_by_descriptor(descriptor))
-    {
-        result = "[FLOW]";
-    }
-    else if (is_disposition_type_by_descriptor(descriptor))
+    if ((performative_code < AMQP_OPEN) ||
+        (performative_code > AMQP_CLOSE))
     {
-        result = "[DISPOSITION]";
-    }
-    else if (is_transfer_type_by_descriptor(descriptor))
-    {
-        result = "[TRANSFER]";
-    }
-    else if (is_detach_type_by_descriptor(descriptor))
-    {
-        result = "[DETACH]";
-    }
-    else if (is_end_type_by_descriptor(descriptor))
-    {
-        result = "[END]";
-    }
-    else if (is_close_type_by_descriptor(descriptor))
-    {
-        result = "[CLOSE]";
+        result = "[Unknown]";
     }
     else
     {
-        result = "[Unknown]";
+        result = frame_type_strings[performative_code - AMQP_OPEN];
     }
 
     return result;
 }
 
-static void log_incoming_frame(AMQP_VALUE performative)
+static void log_incoming_frame(AMQP_VALUE performative, uint64_t performative_code)
+{
+#ifdef NO_LOGGING
+    UNUSED(performative);
+    UNUSED(performative_code);
+#else
+    char* performative_as_string;
+    LOG(AZ_LOG_TRACE, 0, "<- ");
+    LOG(AZ_LOG_TRACE, 0, (char*)get_frame_type_as_string(performative_code));
+    performative_as_string = NULL;
+    LOG(AZ_LOG_TRACE, LOG_LINE, (performative_as_string = amqpvalue_to_string(performative)));
+    if (performative_as_string != NULL)
+    {
+        free(performative_as_string);
+    }
+#endif
+}
+
+static void log_outgoing_frame(AMQP_VALUE performative)
 {
 #ifdef NO_LOGGING
     UNUSED(performative);
 #else
     AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
-    if (descriptor == NULL)
+    uint64_t performative_code;
+    if ((descriptor == NULL) ||
+        (amqpvalue_get_ulong(descriptor, &performative_code) != 0))
     {
         LogError("Error getting performative descriptor");
     }
     else
     {
         char* performative_as_string;
-        LOG(AZ_LOG_TRACE, 0, "<- ");
-        LOG(AZ_LOG_TRACE, 0, (char*)get_frame_type_as_string(descriptor));
+        LOG(AZ_LOG_TRACE, 0, "-> ");
+        LOG(AZ_LOG_TRACE, 0, (char*)get_frame_type_as_string(performative_code));
         performative_as_string = NULL;
         LOG(AZ_LOG_TRACE, LOG_LINE, (performative_as_string = amqpvalue_to_string(performative)));
         if (performative_as_string != NULL)
@@ -220,92 +511,349 @@ static void log_incoming_frame(AMQP_VALUE performative)
 #endif
 }
 
-static void log_outgoing_frame(AMQP_VALUE performative)
+static void on_outgoing_performative_decoded(void* context, AMQP_VALUE decoded_value)
+{
+    (void)context;
+
+    /* the decoded value is owned by the decoder */
+    log_outgoing_frame(decoded_value);
+}
+
+static void log_outgoing_encoded_frame(const unsigned char* performative_bytes, size_t performative_size)
 {
 #ifdef NO_LOGGING
-    UNUSED(performative);
+    UNUSED(performative_bytes);
+    UNUSED(performative_size);
 #else
-    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
-    if (descriptor == NULL)
+    /* the performative is only decoded back when tracing, so the fast path pays nothing for it */
+    AMQPVALUE_DECODER_HANDLE decoder = amqpvalue_decoder_create(on_outgoing_performative_decoded, NULL);
+    if (decoder == NULL)
     {
-        LogError("Error getting performative descriptor");
+        LogError("Error creating decoder for tracing the performative");
     }
     else
     {
-        char* performative_as_string;
-        LOG(AZ_LOG_TRACE, 0, "-> ");
-        LOG(AZ_LOG_TRACE, 0, (char*)get_frame_type_as_string(descriptor));
-        performative_as_string = NULL;
-        LOG(AZ_LOG_TRACE, LOG_LINE, (performative_as_string = amqpvalue_to_string(performative)));
-        if (performative_as_string != NULL)
+        if (amqpvalue_decode_bytes(decoder, performative_bytes, performative_size) != 0)
         {
-            free(performative_as_string);
+            LogError("Error decoding the performative for tracing");
         }
+
+        amqpvalue_decoder_destroy(decoder);
     }
 #endif
 }
 
-static void on_bytes_encoded(void* context, const unsigned char* bytes, size_t length, bool encode_complete)
+static void complete_outgoing_batch(CONNECTION_HANDLE connection, IO_SEND_RESULT send_result)
 {
-    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
-    if (xio_send(connection->io, bytes, length, 
-        (encode_complete && connection->on_send_complete != NULL) ? connection->on_send_complete : unchecked_on_send_complete,
-        connection->on_send_complete_callback_context) != 0)
+    size_t i;
+    SEND_COMPLETION* completions = connection->outgoing_batch_completions;
+    size_t completion_count = connection->outgoing_batch_completion_count;
+
+    /* detach the completions first, a completion callback is free to encode new frames */
+    connection->outgoing_batch_completions = NULL;
+    connection->outgoing_batch_completion_count = 0;
+    connection->outgoing_batch_completion_capacity = 0;
+    connection->outgoing_batch_length = 0;
+
+    for (i = 0; i < completion_count; i++)
     {
-        LogError("Cannot send encoded bytes");
+        completions[i].on_send_complete(completions[i].callback_context, send_result);
+    }
 
-        if (xio_close(connection->io, NULL, NULL) != 0)
-        {
-            LogError("xio_close failed");
-        }
+    connection_free(connection, completions);
+}
 
-        connection_set_state(connection, CONNECTION_STATE_END);
+static void on_outgoing_batch_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    OUTGOING_BATCH_SEND* batch_send = (OUTGOING_BATCH_SEND*)context;
+    size_t i;
+
+    /* Codes_SRS_CONNECTION_01_279: [When the io indicates that the batch was sent, the send completions of all the frames in the batch shall be called in the order in which the frames were encoded, passing the send result.] */
+    for (i = 0; i < batch_send->completion_count; i++)
+    {
+        batch_send->completions[i].on_send_complete(batch_send->completions[i].callback_context, send_result);
     }
+
+    if (batch_send->completions != NULL)
+    {
+        batch_send->allocator.free_function(batch_send->allocator.context, batch_send->completions);
+    }
+
+    batch_send->allocator.free_function(batch_send->allocator.context, batch_send);
 }
 
-static int send_open_frame(CONNECTION_HANDLE connection)
+static int flush_outgoing_batch(CONNECTION_HANDLE connection)
 {
     int result;
 
-    /* Codes_SRS_CONNECTION_01_151: [The connection max_frame_size setting shall be passed down to the frame_codec when the Open frame is sent.] */
-    if (frame_codec_set_max_frame_size(connection->frame_codec, connection->max_frame_size) != 0)
+    if (connection->outgoing_batch_length == 0)
     {
-        LogError("Cannot set max frame size");
-
-        /* Codes_SRS_CONNECTION_01_207: [If frame_codec_set_max_frame_size fails the connection shall be closed and the state set to END.] */
-        if (xio_close(connection->io, NULL, NULL) != 0)
+        result = 0;
+    }
+    else if (connection->outgoing_batch_completion_count == 0)
+    {
+        /* Codes_SRS_CONNECTION_01_278: [Flushing the outgoing batch shall pass all the batched bytes to the io in one call to xio_send.] */
+        if (send_to_io(connection, connection->outgoing_batch, connection->outgoing_batch_length, unchecked_on_send_complete, NULL) != 0)
         {
-            LogError("xio_close failed");
+            LogError("Cannot send outgoing batch");
+            complete_outgoing_batch(connection, IO_SEND_ERROR);
+            result = __FAILURE__;
+        }
+        else
+        {
+            connection->outgoing_batch_length = 0;
+            result = 0;
         }
-
-        connection_set_state(connection, CONNECTION_STATE_END);
-        result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_CONNECTION_01_134: [The container id field shall be filled with the container id specified in connection_create.] */
-        OPEN_HANDLE open_performative = open_create(connection->container_id);
-        if (open_performative == NULL)
+        OUTGOING_BATCH_SEND* batch_send = (OUTGOING_BATCH_SEND*)connection_malloc(connection, sizeof(OUTGOING_BATCH_SEND));
+        if (batch_send == NULL)
         {
-            LogError("Cannot create OPEN performative");
-            
-            /* Codes_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
-            if (xio_close(connection->io, NULL, NULL) != 0)
-            {
-                LogError("xio_close failed");
-            }
-
-            connection_set_state(connection, CONNECTION_STATE_END);
+            /* Codes_SRS_CONNECTION_01_280: [If flushing the outgoing batch fails, the send completions of all the frames in the batch shall be called with IO_SEND_ERROR.] */
+            LogError("Cannot allocate memory for the outgoing batch send");
+            complete_outgoing_batch(connection, IO_SEND_ERROR);
             result = __FAILURE__;
         }
         else
         {
-            /* Codes_SRS_CONNECTION_01_137: [The max_frame_size connection setting shall be set in the open frame by using open_set_max_frame_size.] */
-            if (open_set_max_frame_size(open_performative, connection->max_frame_size) != 0)
-            {
-                LogError("Cannot set max frame size");
+            batch_send->completions = connection->outgoing_batch_completions;
+            batch_send->completion_count = connection->outgoing_batch_completion_count;
+            batch_send->allocator = connection->allocator;
 
-                /* Codes_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
+            /* Codes_SRS_CONNECTION_01_278: [Flushing the outgoing batch shall pass all the batched bytes to the io in one call to xio_send.] */
+            if (send_to_io(connection, connection->outgoing_batch, connection->outgoing_batch_length, on_outgoing_batch_send_complete, batch_send) != 0)
+            {
+                /* Codes_SRS_CONNECTION_01_280: [If flushing the outgoing batch fails, the send completions of all the frames in the batch shall be called with IO_SEND_ERROR.] */
+                LogError("Cannot send outgoing batch");
+                connection_free(connection, batch_send);
+                complete_outgoing_batch(connection, IO_SEND_ERROR);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* the completions now belong to the batch send */
+                connection->outgoing_batch_completions = NULL;
+                connection->outgoing_batch_completion_count = 0;
+                connection->outgoing_batch_completion_capacity = 0;
+                connection->outgoing_batch_length = 0;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int add_to_outgoing_batch(CONNECTION_HANDLE connection, const unsigned char* bytes, size_t length, bool encode_complete)
+{
+    int result;
+    bool has_completion = encode_complete && (connection->on_send_complete != NULL);
+
+    /* length is below outgoing_batch_size and the batch is flushed once it reaches it, so the new length cannot overflow */
+    if (connection->outgoing_batch_length + length > connection->outgoing_batch_capacity)
+    {
+        size_t new_capacity = connection->outgoing_batch_length + length;
+        unsigned char* new_batch;
+
+        if (new_capacity < connection->outgoing_batch_size)
+        {
+            new_capacity = connection->outgoing_batch_size;
+        }
+
+        new_batch = (unsigned char*)connection_realloc(connection, connection->outgoing_batch, new_capacity);
+        if (new_batch == NULL)
+        {
+            LogError("Cannot grow the outgoing batch");
+            result = __FAILURE__;
+        }
+        else
+        {
+            ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, connection->outgoing_batch_capacity, new_capacity);
+            connection->outgoing_batch = new_batch;
+            connection->outgoing_batch_capacity = new_capacity;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if ((result == 0) &&
+        has_completion &&
+        (connection->outgoing_batch_completion_count == connection->outgoing_batch_completion_capacity))
+    {
+        size_t new_capacity = (connection->outgoing_batch_completion_capacity == 0) ? 8 : connection->outgoing_batch_completion_capacity * 2;
+        SEND_COMPLETION* new_completions = (SEND_COMPLETION*)connection_realloc(connection, connection->outgoing_batch_completions, new_capacity * sizeof(SEND_COMPLETION));
+        if (new_completions == NULL)
+        {
+            LogError("Cannot grow the outgoing batch completions");
+            result = __FAILURE__;
+        }
+        else
+        {
+            connection->outgoing_batch_completions = new_completions;
+            connection->outgoing_batch_completion_capacity = new_capacity;
+        }
+    }
+
+    if ((result == 0) &&
+        (connection->outgoing_batch_length == 0) &&
+        (connection->outgoing_batch_delay > 0) &&
+        (tickcounter_get_current_ms(connection->tick_counter, &connection->outgoing_batch_start_time) != 0))
+    {
+        /* a batch whose start time is unknown is flushed on the next connection_dowork */
+        LogError("Cannot get tickcounter value for the outgoing batch");
+        connection->outgoing_batch_start_time = 0;
+    }
+
+    if (result == 0)
+    {
+        (void)memcpy(connection->outgoing_batch + connection->outgoing_batch_length, bytes, length);
+        connection->outgoing_batch_length += length;
+
+        if (has_completion)
+        {
+            connection->outgoing_batch_completions[connection->outgoing_batch_completion_count].on_send_complete = connection->on_send_complete;
+            connection->outgoing_batch_completions[connection->outgoing_batch_completion_count].callback_context = connection->on_send_complete_callback_context;
+            connection->outgoing_batch_completion_count++;
+        }
+    }
+
+    return result;
+}
+
+static bool is_outgoing_batch_due(CONNECTION_HANDLE connection)
+{
+    bool result;
+    tickcounter_ms_t current_ms;
+
+    if ((connection->outgoing_batch_delay == 0) ||
+        (connection->outgoing_batch_length == 0))
+    {
+        result = true;
+    }
+    else if (tickcounter_get_current_ms(connection->tick_counter, &current_ms) != 0)
+    {
+        /* Codes_SRS_CONNECTION_01_357: [If the current time cannot be obtained, connection_dowork shall flush the outgoing batch.] */
+        LogError("Cannot get tickcounter value for the outgoing batch");
+        result = true;
+    }
+    else
+    {
+        result = (current_ms - connection->outgoing_batch_start_time >= connection->outgoing_batch_delay);
+    }
+
+    return result;
+}
+
+static void on_bytes_encoded(void* context, const unsigned char* bytes, size_t length, bool encode_complete)
+{
+    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_306: [The bytes of every encoded frame shall be counted as sent, together with one frame once its last bytes are encoded.] */
+    connection->stats.bytes_sent += length;
+    if (encode_complete)
+    {
+        connection->stats.frames_sent++;
+    }
+
+    if (connection->is_encoding_batched_frame &&
+        ((length < connection->outgoing_batch_size) || is_pipelining_open(connection) || (connection->outgoing_batch_hold_count > 0)))
+    {
+        /* Codes_SRS_CONNECTION_01_276: [When an outgoing batch size is set, the bytes of frames encoded by connection_encode_frame shall be accumulated in an outgoing batch instead of being sent.] */
+        if (add_to_outgoing_batch(connection, bytes, length, encode_complete) != 0)
+        {
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_CONNECTION_01_277: [When the outgoing batch holds at least outgoing_batch_size bytes it shall be flushed.] */
+        /* Codes_SRS_CONNECTION_01_368: [While the outgoing batch is held, the frames encoded by connection_encode_frame and connection_encode_frame_with_encoded_performative shall be accumulated in the outgoing batch whatever their size, and the batch shall not be flushed when it reaches outgoing_batch_size nor by connection_dowork.] */
+        else if ((connection->outgoing_batch_size > 0) &&
+            (connection->outgoing_batch_hold_count == 0) &&
+            (connection->outgoing_batch_length >= connection->outgoing_batch_size) &&
+            (flush_outgoing_batch(connection) != 0))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    /* Codes_SRS_CONNECTION_01_282: [Before any bytes are sent without going through the outgoing batch, the outgoing batch shall be flushed so that frames are sent in the order in which they were encoded.] */
+    else if (flush_outgoing_batch(connection) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (send_to_io(connection, bytes, length,
+        (encode_complete && connection->on_send_complete != NULL) ? connection->on_send_complete : unchecked_on_send_complete,
+        connection->on_send_complete_callback_context) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result != 0)
+    {
+        LogError("Cannot send encoded bytes");
+
+        if (xio_close(connection->io, NULL, NULL) != 0)
+        {
+            LogError("xio_close failed");
+        }
+
+        connection_set_state(connection, CONNECTION_STATE_END);
+    }
+}
+
+static int send_open_frame(CONNECTION_HANDLE connection)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_151: [The connection max_frame_size setting shall be passed down to the frame_codec when the Open frame is sent.] */
+    if (frame_codec_set_max_frame_size(connection->frame_codec, connection->max_frame_size) != 0)
+    {
+        LogError("Cannot set max frame size");
+
+        /* Codes_SRS_CONNECTION_01_207: [If frame_codec_set_max_frame_size fails the connection shall be closed and the state set to END.] */
+        if (xio_close(connection->io, NULL, NULL) != 0)
+        {
+            LogError("xio_close failed");
+        }
+
+        connection_set_state(connection, CONNECTION_STATE_END);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_134: [The container id field shall be filled with the container id specified in connection_create.] */
+        OPEN_HANDLE open_performative = open_create(connection->container_id);
+        if (open_performative == NULL)
+        {
+            LogError("Cannot create OPEN performative");
+            
+            /* Codes_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
+            if (xio_close(connection->io, NULL, NULL) != 0)
+            {
+                LogError("xio_close failed");
+            }
+
+            connection_set_state(connection, CONNECTION_STATE_END);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CONNECTION_01_137: [The max_frame_size connection setting shall be set in the open frame by using open_set_max_frame_size.] */
+            if (open_set_max_frame_size(open_performative, connection->max_frame_size) != 0)
+            {
+                LogError("Cannot set max frame size");
+
+                /* Codes_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
                 if (xio_close(connection->io, NULL, NULL) != 0)
                 {
                     LogError("xio_close failed");
@@ -392,6 +940,8 @@ static int send_open_frame(CONNECTION_HANDLE connection)
                 }
                 else
                 {
+                    int encode_result;
+
                     /* Codes_SRS_CONNECTION_01_002: [Each AMQP connection begins with an exchange of capabilities and limitations, including the maximum frame size.] */
                     /* Codes_SRS_CONNECTION_01_004: [After establishing or accepting a TCP connection and sending the protocol header, each peer MUST send an open frame before sending any other frames.] */
                     /* Codes_SRS_CONNECTION_01_005: [The open frame describes the capabilities and limits of that peer.] */
@@ -399,7 +949,10 @@ static int send_open_frame(CONNECTION_HANDLE connection)
                     /* Codes_SRS_CONNECTION_01_006: [The open frame can only be sent on channel 0.] */
                     connection->on_send_complete = NULL;
                     connection->on_send_complete_callback_context = NULL;
-                    if (amqp_frame_codec_encode_frame(connection->amqp_frame_codec, 0, open_performative_value, NULL, 0, on_bytes_encoded, connection) != 0)
+                    connection->is_encoding_batched_frame = is_pipelining_open(connection) ? 1 : 0;
+                    encode_result = amqp_frame_codec_encode_frame(connection->amqp_frame_codec, 0, open_performative_value, NULL, 0, on_bytes_encoded, connection);
+                    connection->is_encoding_batched_frame = 0;
+                    if (encode_result != 0)
                     {
                         LogError("amqp_frame_codec_encode_frame failed");
 
@@ -419,8 +972,17 @@ static int send_open_frame(CONNECTION_HANDLE connection)
                             log_outgoing_frame(open_performative_value);
                         }
 
-                        /* Codes_SRS_CONNECTION_01_046: [OPEN SENT In this state the connection headers have been exchanged. An open frame has been sent to the peer but no open frame has yet been received.] */
-                        connection_set_state(connection, CONNECTION_STATE_OPEN_SENT);
+                        if (connection->connection_state == CONNECTION_STATE_HDR_SENT)
+                        {
+                            /* Codes_SRS_CONNECTION_01_043: [OPEN PIPE In this state both the connection header and the open frame have been sent but nothing has been received.] */
+                            connection_set_state(connection, CONNECTION_STATE_OPEN_PIPE);
+                        }
+                        else
+                        {
+                            /* Codes_SRS_CONNECTION_01_046: [OPEN SENT In this state the connection headers have been exchanged. An open frame has been sent to the peer but no open frame has yet been received.] */
+                            connection_set_state(connection, CONNECTION_STATE_OPEN_SENT);
+                        }
+
                         result = 0;
                     }
 
@@ -547,20 +1109,35 @@ static void close_connection_with_error(CONNECTION_HANDLE connection, const char
     }
 }
 
-static ENDPOINT_INSTANCE* find_session_endpoint_by_outgoing_channel(CONNECTION_HANDLE connection, uint16_t outgoing_channel)
+/* Returns the index of the first endpoint whose outgoing channel is not lower than outgoing_channel */
+static uint32_t get_endpoint_index_by_outgoing_channel(CONNECTION_HANDLE connection, uint16_t outgoing_channel)
 {
-    uint32_t i;
-    ENDPOINT_INSTANCE* result;
+    uint32_t low = 0;
+    uint32_t high = connection->endpoint_count;
 
-    for (i = 0; i < connection->endpoint_count; i++)
+    while (low < high)
     {
-        if (connection->endpoints[i]->outgoing_channel == outgoing_channel)
+        uint32_t middle = low + ((high - low) / 2);
+        if (connection->endpoints[middle]->outgoing_channel < outgoing_channel)
         {
-            break;
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
         }
     }
 
-    if (i == connection->endpoint_count)
+    return low;
+}
+
+static ENDPOINT_INSTANCE* find_session_endpoint_by_outgoing_channel(CONNECTION_HANDLE connection, uint16_t outgoing_channel)
+{
+    uint32_t i = get_endpoint_index_by_outgoing_channel(connection, outgoing_channel);
+    ENDPOINT_INSTANCE* result;
+
+    if ((i == connection->endpoint_count) ||
+        (connection->endpoints[i]->outgoing_channel != outgoing_channel))
     {
         LogError("Cannot find session endpoint for channel %u", (unsigned int)outgoing_channel);
         result = NULL;
@@ -575,25 +1152,90 @@ static ENDPOINT_INSTANCE* find_session_endpoint_by_outgoing_channel(CONNECTION_H
 
 static ENDPOINT_INSTANCE* find_session_endpoint_by_incoming_channel(CONNECTION_HANDLE connection, uint16_t incoming_channel)
 {
-    uint32_t i;
     ENDPOINT_INSTANCE* result;
 
-    for (i = 0; i < connection->endpoint_count; i++)
+    if ((incoming_channel >= connection->incoming_channel_table_size) ||
+        (connection->endpoints_by_incoming_channel[incoming_channel] == NULL))
+    {
+        LogError("Cannot find session endpoint for channel %u", (unsigned int)incoming_channel);
+        result = NULL;
+    }
+    else
+    {
+        result = connection->endpoints_by_incoming_channel[incoming_channel];
+    }
+
+    return result;
+}
+
+static void clear_endpoint_incoming_channel(CONNECTION_HANDLE connection, ENDPOINT_INSTANCE* endpoint)
+{
+    if (endpoint->has_incoming_channel)
     {
-        if (connection->endpoints[i]->incoming_channel == incoming_channel)
+        if ((endpoint->incoming_channel < connection->incoming_channel_table_size) &&
+            (connection->endpoints_by_incoming_channel[endpoint->incoming_channel] == endpoint))
         {
-            break;
+            connection->endpoints_by_incoming_channel[endpoint->incoming_channel] = NULL;
         }
+
+        endpoint->has_incoming_channel = false;
     }
+}
 
-    if (i == connection->endpoint_count)
+static int set_endpoint_incoming_channel(CONNECTION_HANDLE connection, ENDPOINT_INSTANCE* endpoint, uint16_t incoming_channel)
+{
+    int result;
+
+    if (incoming_channel > connection->channel_max)
     {
-        LogError("Cannot find session endpoint for channel %u", (unsigned int)incoming_channel);
-        result = NULL;
+        LogError("Incoming channel %u exceeds channel_max %u", (unsigned int)incoming_channel, (unsigned int)connection->channel_max);
+        result = __FAILURE__;
     }
     else
     {
-        result = connection->endpoints[i];
+        if (incoming_channel >= connection->incoming_channel_table_size)
+        {
+            uint32_t max_table_size = (uint32_t)connection->channel_max + 1;
+            uint32_t new_table_size = (connection->incoming_channel_table_size == 0) ? 8 : connection->incoming_channel_table_size;
+            ENDPOINT_INSTANCE** new_table;
+
+            while (new_table_size <= incoming_channel)
+            {
+                new_table_size *= 2;
+            }
+
+            if (new_table_size > max_table_size)
+            {
+                new_table_size = max_table_size;
+            }
+
+            new_table = (ENDPOINT_INSTANCE**)connection_realloc(connection, connection->endpoints_by_incoming_channel, sizeof(ENDPOINT_INSTANCE*) * new_table_size);
+            if (new_table == NULL)
+            {
+                LogError("Cannot allocate memory for the incoming channel table");
+                result = __FAILURE__;
+            }
+            else
+            {
+                (void)memset(new_table + connection->incoming_channel_table_size, 0, sizeof(ENDPOINT_INSTANCE*) * (new_table_size - connection->incoming_channel_table_size));
+                connection->endpoints_by_incoming_channel = new_table;
+                connection->incoming_channel_table_size = new_table_size;
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if (result == 0)
+        {
+            clear_endpoint_incoming_channel(connection, endpoint);
+
+            endpoint->incoming_channel = incoming_channel;
+            endpoint->has_incoming_channel = true;
+            connection->endpoints_by_incoming_channel[incoming_channel] = endpoint;
+        }
     }
 
     return result;
@@ -615,6 +1257,9 @@ static int connection_byte_received(CONNECTION_HANDLE connection, unsigned char
 
     /* Codes_SRS_CONNECTION_01_041: [HDR SENT In this state the connection header has been sent to the peer but no connection header has been received.] */
     case CONNECTION_STATE_HDR_SENT:
+
+    /* Codes_SRS_CONNECTION_01_043: [OPEN PIPE In this state both the connection header and the open frame have been sent but nothing has been received.] */
+    case CONNECTION_STATE_OPEN_PIPE:
         if (b != amqp_header[connection->header_bytes_received])
         {
             /* Codes_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
@@ -636,12 +1281,25 @@ static int connection_byte_received(CONNECTION_HANDLE connection, unsigned char
                     LOG(AZ_LOG_TRACE, LOG_LINE, "<- Header (AMQP 0.1.0.0)");
                 }
 
-                connection_set_state(connection, CONNECTION_STATE_HDR_EXCH);
+                if (connection->frame_trace != NULL)
+                {
+                    trace_frame_bytes(connection, FRAME_TRACE_DIRECTION_INCOMING, FRAME_TRACE_FRAME_TYPE_HEADER, 0, amqp_header, sizeof(amqp_header), 0);
+                }
 
-                if (send_open_frame(connection) != 0)
+                if (connection->connection_state == CONNECTION_STATE_OPEN_PIPE)
                 {
-                    LogError("Cannot send open frame");
-                    connection_set_state(connection, CONNECTION_STATE_END);
+                    /* Codes_SRS_CONNECTION_01_324: [When the peer's protocol header is received in the OPEN_PIPE state, the connection shall switch to the OPEN_SENT state without sending another open frame.] */
+                    connection_set_state(connection, CONNECTION_STATE_OPEN_SENT);
+                }
+                else
+                {
+                    connection_set_state(connection, CONNECTION_STATE_HDR_EXCH);
+
+                    if (send_open_frame(connection) != 0)
+                    {
+                        LogError("Cannot send open frame");
+                        connection_set_state(connection, CONNECTION_STATE_END);
+                    }
                 }
             }
 
@@ -686,11 +1344,32 @@ static int connection_byte_received(CONNECTION_HANDLE connection, unsigned char
 
 static void connection_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
+    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
     size_t i;
 
+    /* Codes_SRS_CONNECTION_01_307: [All bytes received from the io shall be counted as received.] */
+    connection->stats.bytes_received += size;
+
+    /* Codes_SRS_CONNECTION_01_410: [When the frame trace set on the connection is capturing, the bytes received from the io shall be passed to frame_trace_capture_bytes with the current time before being processed.] */
+    if ((connection->frame_trace != NULL) &&
+        frame_trace_is_capturing(connection->frame_trace))
+    {
+        tickcounter_ms_t current_ms;
+
+        /* Codes_SRS_CONNECTION_01_411: [If capturing the received bytes fails, the bytes shall still be processed.] */
+        if (tickcounter_get_current_ms(connection->tick_counter, &current_ms) != 0)
+        {
+            LogError("Cannot get tickcounter value for the frame capture");
+        }
+        else if (frame_trace_capture_bytes(connection->frame_trace, (uint64_t)current_ms, buffer, size) != 0)
+        {
+            LogError("Cannot capture the received bytes");
+        }
+    }
+
     for (i = 0; i < size; i++)
     {
-        if (connection_byte_received((CONNECTION_HANDLE)context, buffer[i]) != 0)
+        if (connection_byte_received(connection, buffer[i]) != 0)
         {
             LogError("Cannot process received bytes");
             break;
@@ -698,29 +1377,85 @@ static void connection_on_bytes_received(void* context, const unsigned char* buf
     }
 }
 
-static void connection_on_io_open_complete(void* context, IO_OPEN_RESULT io_open_result)
+static void resume_handed_over_connection(CONNECTION_HANDLE connection)
 {
-    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
+    tickcounter_ms_t current_ms;
 
-    if (io_open_result == IO_OPEN_OK)
+    connection->is_resuming_handover = false;
+
+    /* Codes_SRS_CONNECTION_01_442: [When the io of a connection restored from a handover state opens, the restored max frame size shall be passed to the frame_codec, the idle timeouts shall start from the current time and the connection shall switch to the OPENED state without sending a protocol header or an open frame.] */
+    if ((frame_codec_set_max_frame_size(connection->frame_codec, connection->max_frame_size) != 0) ||
+        (tickcounter_get_current_ms(connection->tick_counter, &current_ms) != 0))
     {
-        /* Codes_SRS_CONNECTION_01_084: [The connection_instance state machine implementing the protocol requirements shall be run as part of connection_dowork.] */
-        switch (connection->connection_state)
+        /* Codes_SRS_CONNECTION_01_443: [If resuming the connection fails, the io shall be closed and the state set to END.] */
+        LogError("Cannot resume the handed over connection");
+
+        if (xio_close(connection->io, NULL, NULL) != 0)
+        {
+            LogError("xio_close failed");
+        }
+
+        connection_set_state(connection, CONNECTION_STATE_END);
+    }
+    else
+    {
+        connection->header_bytes_received = sizeof(amqp_header);
+        connection->coarse_current_ms = current_ms;
+        connection->last_frame_received_time = current_ms;
+        connection->last_frame_sent_time = current_ms;
+        connection_set_state(connection, CONNECTION_STATE_OPENED);
+    }
+}
+
+static void connection_on_io_open_complete(void* context, IO_OPEN_RESULT io_open_result)
+{
+    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
+
+    if (io_open_result == IO_OPEN_OK)
+    {
+        /* Codes_SRS_CONNECTION_01_084: [The connection_instance state machine implementing the protocol requirements shall be run as part of connection_dowork.] */
+        switch (connection->connection_state)
         {
         default:
             LogError("Unknown connection state: %d", (int)connection->connection_state);
             break;
 
         case CONNECTION_STATE_START:
+            if (connection->is_resuming_handover)
+            {
+                resume_handed_over_connection(connection);
+            }
             /* Codes_SRS_CONNECTION_01_086: [Prior to sending any frames on a connection_instance, each peer MUST start by sending a protocol header that indicates the protocol version used on the connection_instance.] */
             /* Codes_SRS_CONNECTION_01_091: [The AMQP peer which acted in the role of the TCP client (i.e. the peer that actively opened the connection_instance) MUST immediately send its outgoing protocol header on establishment of the TCP connection_instance.] */
-            if (send_header(connection) != 0)
+            else if (send_header(connection) != 0)
             {
                 LogError("Cannot send header");
             }
+            else if (connection->is_pipelined_open)
+            {
+                /* Codes_SRS_CONNECTION_01_320: [When the open is pipelined, the open frame shall be sent right after the protocol header, without waiting for the peer's protocol header, and the connection shall switch to the OPEN_PIPE state.] */
+                if (send_open_frame(connection) != 0)
+                {
+                    LogError("Cannot send pipelined OPEN frame");
+                }
+                /* Codes_SRS_CONNECTION_01_323: [Once the open frame and the frames encoded by the endpoints when notified of the OPEN_PIPE state are batched, the outgoing batch shall be flushed so that they are passed to the io in one xio_send call.] */
+                else if (flush_outgoing_batch(connection) != 0)
+                {
+                    /* Codes_SRS_CONNECTION_01_325: [If flushing the pipelined frames fails, the connection shall be closed and its state set to END.] */
+                    LogError("Cannot flush the pipelined frames");
+
+                    if (xio_close(connection->io, NULL, NULL) != 0)
+                    {
+                        LogError("xio_close failed");
+                    }
+
+                    connection_set_state(connection, CONNECTION_STATE_END);
+                }
+            }
             break;
 
         case CONNECTION_STATE_HDR_SENT:
+        case CONNECTION_STATE_OPEN_PIPE:
         case CONNECTION_STATE_OPEN_SENT:
         case CONNECTION_STATE_OPENED:
             break;
@@ -773,71 +1508,238 @@ static void on_empty_amqp_frame_received(void* context, uint16_t channel)
     /* It does not matter on which channel we received the frame */
     (void)channel;
 
+    UAMQP_TRACEPOINT1(amqp_empty_frame_received, channel);
+
+    /* Codes_SRS_CONNECTION_01_308: [Every decoded frame received shall be counted as a received frame, empty frames being also counted as received empty frames.] */
+    connection->stats.frames_received++;
+    connection->stats.empty_frames_received++;
+
     if (connection->is_trace_on == 1)
     {
         LOG(AZ_LOG_TRACE, LOG_LINE, "<- Empty frame");
     }
-    if (tickcounter_get_current_ms(connection->tick_counter, &connection->last_frame_received_time) != 0)
+
+    if (connection->frame_trace != NULL)
     {
-        LogError("Cannot get tickcounter value");
+        trace_frame_bytes(connection, FRAME_TRACE_DIRECTION_INCOMING, FRAME_TRACE_FRAME_TYPE_EMPTY, channel, NULL, 0, 0);
     }
+    /* Codes_SRS_CONNECTION_01_375: [The time of the last frame received and sent shall be taken from the coarse clock refreshed by connection_handle_deadlines instead of reading the tick counter for every frame.] */
+    connection->last_frame_received_time = connection->coarse_current_ms;
 }
 
-static void on_amqp_frame_received(void* context, uint16_t channel, AMQP_VALUE performative, const unsigned char* payload_bytes, uint32_t payload_size)
+static uint32_t get_lowest_free_outgoing_channel(CONNECTION_HANDLE connection)
 {
-    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
+    uint32_t result = 0;
+    uint32_t high = connection->endpoint_count;
 
-    (void)channel;
+    /* the endpoint array is sorted by outgoing channel, so the first gap is the first index i with outgoing_channel > i,
+       which is also where an endpoint on that channel is inserted */
+    while (result < high)
+    {
+        uint32_t middle = result + ((high - result) / 2);
+        if (connection->endpoints[middle]->outgoing_channel > middle)
+        {
+            high = middle;
+        }
+        else
+        {
+            result = middle + 1;
+        }
+    }
+
+    return result;
+}
+
+static int send_unattached_frame(CONNECTION_HANDLE connection, uint16_t channel, AMQP_VALUE performative_value)
+{
+    int result;
 
-    if (tickcounter_get_current_ms(connection->tick_counter, &connection->last_frame_received_time) != 0)
+    connection->on_send_complete = NULL;
+    connection->on_send_complete_callback_context = NULL;
+    if (amqp_frame_codec_encode_frame(connection->amqp_frame_codec, channel, performative_value, NULL, 0, on_bytes_encoded, connection) != 0)
     {
-        LogError("Cannot get tickcounter value");
-        close_connection_with_error(connection, "amqp:internal-error", "cannot get current tick count");
+        LogError("amqp_frame_codec_encode_frame failed");
+        result = __FAILURE__;
     }
     else
     {
-        if (connection->is_underlying_io_open)
+        if (connection->is_trace_on == 1)
+        {
+            log_outgoing_frame(performative_value);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int refuse_session(CONNECTION_HANDLE connection, uint16_t remote_channel)
+{
+    int result;
+
+    if (connection->endpoint_count >= connection->channel_max)
+    {
+        LogError("No channel is left to refuse the session on");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the channel is only borrowed for the two frames, the peer's end comes on its own channel and is ignored like
+           any frame on a channel without an endpoint */
+        uint16_t channel = (uint16_t)get_lowest_free_outgoing_channel(connection);
+        BEGIN_HANDLE begin = begin_create(0, 0, 0);
+        if (begin == NULL)
+        {
+            LogError("Cannot create the begin performative");
+            result = __FAILURE__;
+        }
+        else
         {
-            switch (connection->connection_state)
+            AMQP_VALUE begin_performative_value;
+
+            if ((begin_set_remote_channel(begin, remote_channel) != 0) ||
+                ((begin_performative_value = amqpvalue_create_begin(begin)) == NULL))
+            {
+                LogError("Cannot create the begin performative value");
+                result = __FAILURE__;
+            }
+            else
             {
-            default:
-                if (performative == NULL)
+                if (send_unattached_frame(connection, channel, begin_performative_value) != 0)
                 {
-                    /* Codes_SRS_CONNECTION_01_223: [If the on_endpoint_frame_received is called with a NULL performative then the connection shall be closed with the error condition amqp:internal-error and an implementation defined error description.] */
-                    close_connection_with_error(connection, "amqp:internal-error", "connection_endpoint_frame_received::NULL performative");
-                    LogError("connection_endpoint_frame_received::NULL performative");
+                    LogError("Cannot send the begin");
+                    result = __FAILURE__;
                 }
                 else
                 {
-                    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
-                    uint64_t performative_ulong;
-
-                    if (connection->is_trace_on == 1)
+                    END_HANDLE end_performative = end_create();
+                    if (end_performative == NULL)
                     {
-                        log_incoming_frame(performative);
+                        LogError("Cannot create the end performative");
+                        result = __FAILURE__;
                     }
-
-                    if (is_open_type_by_descriptor(descriptor))
+                    else
                     {
-                        if (channel != 0)
+                        ERROR_HANDLE error_handle = error_create("amqp:resource-limit-exceeded");
+                        if (error_handle == NULL)
                         {
-                            /* Codes_SRS_CONNECTION_01_006: [The open frame can only be sent on channel 0.] */
-                            /* Codes_SRS_CONNECTION_01_222: [If an Open frame is received in a manner violating the ISO specification, the connection shall be closed with condition amqp:not-allowed and description being an implementation defined string.] */
-                            close_connection_with_error(connection, "amqp:not-allowed", "OPEN frame received on a channel that is not 0");
-                            LogError("OPEN frame received on a channel that is not 0");
+                            LogError("Cannot create the error");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            AMQP_VALUE end_performative_value;
+
+                            if ((error_set_description(error_handle, "Session admission limit reached") != 0) ||
+                                (end_set_error(end_performative, error_handle) != 0) ||
+                                ((end_performative_value = amqpvalue_create_end(end_performative)) == NULL))
+                            {
+                                LogError("Cannot create the end performative value");
+                                result = __FAILURE__;
+                            }
+                            else
+                            {
+                                if (send_unattached_frame(connection, channel, end_performative_value) != 0)
+                                {
+                                    LogError("Cannot send the end");
+                                    result = __FAILURE__;
+                                }
+                                else
+                                {
+                                    result = 0;
+                                }
+
+                                amqpvalue_destroy(end_performative_value);
+                            }
+
+                            error_destroy(error_handle);
                         }
 
-                        if (connection->connection_state == CONNECTION_STATE_OPENED)
+                        end_destroy(end_performative);
+                    }
+                }
+
+                amqpvalue_destroy(begin_performative_value);
+            }
+
+            begin_destroy(begin);
+        }
+    }
+
+    return result;
+}
+
+static void on_amqp_frame_received(void* context, uint16_t channel, AMQP_VALUE performative, uint64_t performative_code, const unsigned char* payload_bytes, uint32_t payload_size)
+{
+    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
+
+    (void)channel;
+
+    UAMQP_TRACEPOINT2(amqp_frame_received, channel, payload_size);
+
+    /* Codes_SRS_CONNECTION_01_308: [Every decoded frame received shall be counted as a received frame, empty frames being also counted as received empty frames.] */
+    connection->stats.frames_received++;
+
+    /* Codes_SRS_CONNECTION_01_375: [The time of the last frame received and sent shall be taken from the coarse clock refreshed by connection_handle_deadlines instead of reading the tick counter for every frame.] */
+    connection->last_frame_received_time = connection->coarse_current_ms;
+
+    if (connection->is_underlying_io_open)
+    {
+        switch (connection->connection_state)
+        {
+        default:
+            if (performative == NULL)
+            {
+                /* Codes_SRS_CONNECTION_01_223: [If the on_endpoint_frame_received is called with a NULL performative then the connection shall be closed with the error condition amqp:internal-error and an implementation defined error description.] */
+                close_connection_with_error(connection, "amqp:internal-error", "connection_endpoint_frame_received::NULL performative");
+                LogError("connection_endpoint_frame_received::NULL performative");
+            }
+            else
+            {
+                if (connection->is_trace_on == 1)
+                {
+                    log_incoming_frame(performative, performative_code);
+                }
+
+                if (performative_code == AMQP_OPEN)
+                {
+                    if (channel != 0)
+                    {
+                        /* Codes_SRS_CONNECTION_01_006: [The open frame can only be sent on channel 0.] */
+                        /* Codes_SRS_CONNECTION_01_222: [If an Open frame is received in a manner violating the ISO specification, the connection shall be closed with condition amqp:not-allowed and description being an implementation defined string.] */
+                        close_connection_with_error(connection, "amqp:not-allowed", "OPEN frame received on a channel that is not 0");
+                        LogError("OPEN frame received on a channel that is not 0");
+                    }
+
+                    if (connection->connection_state == CONNECTION_STATE_OPENED)
+                    {
+                        /* Codes_SRS_CONNECTION_01_239: [If an Open frame is received in the Opened state the connection shall be closed with condition amqp:illegal-state and description being an implementation defined string.] */
+                        close_connection_with_error(connection, "amqp:illegal-state", "OPEN frame received in the OPENED state");
+                        LogError("OPEN frame received in the OPENED state");
+                    }
+                    else if ((connection->connection_state == CONNECTION_STATE_OPEN_SENT) ||
+                        (connection->connection_state == CONNECTION_STATE_HDR_EXCH))
+                    {
+                        OPEN_HANDLE open_handle;
+                        if (amqpvalue_get_open(performative, &open_handle) != 0)
                         {
-                            /* Codes_SRS_CONNECTION_01_239: [If an Open frame is received in the Opened state the connection shall be closed with condition amqp:illegal-state and description being an implementation defined string.] */
-                            close_connection_with_error(connection, "amqp:illegal-state", "OPEN frame received in the OPENED state");
-                            LogError("OPEN frame received in the OPENED state");
+                            /* Codes_SRS_CONNECTION_01_143: [If any of the values in the received open frame are invalid then the connection shall be closed.] */
+                            /* Codes_SRS_CONNECTION_01_220: [The error amqp:invalid-field shall be set in the error.condition field of the CLOSE frame.] */
+                            close_connection_with_error(connection, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing OPEN frame");
+                            LogError("connection_endpoint_frame_received::failed parsing OPEN frame");
                         }
-                        else if ((connection->connection_state == CONNECTION_STATE_OPEN_SENT) ||
-                            (connection->connection_state == CONNECTION_STATE_HDR_EXCH))
+                        else
                         {
-                            OPEN_HANDLE open_handle;
-                            if (amqpvalue_get_open(performative, &open_handle) != 0)
+                            if (open_get_idle_time_out(open_handle, &connection->remote_idle_timeout) == 0)
+                            {
+                                /* since we obtained the remote_idle_timeout, compute at what millisecond we should send the empty frame */
+                                connection->remote_idle_timeout_send_frame_millisecond = (milliseconds)(connection->idle_timeout_empty_frame_send_ratio * connection->remote_idle_timeout);
+                            }
+
+                            if ((open_get_max_frame_size(open_handle, &connection->remote_max_frame_size) != 0) ||
+                                /* Codes_SRS_CONNECTION_01_167: [Both peers MUST accept frames of up to 512 (MIN-MAX-FRAME-SIZE) octets.] */
+                                (connection->remote_max_frame_size < 512))
                             {
                                 /* Codes_SRS_CONNECTION_01_143: [If any of the values in the received open frame are invalid then the connection shall be closed.] */
                                 /* Codes_SRS_CONNECTION_01_220: [The error amqp:invalid-field shall be set in the error.condition field of the CLOSE frame.] */
@@ -846,136 +1748,138 @@ static void on_amqp_frame_received(void* context, uint16_t channel, AMQP_VALUE p
                             }
                             else
                             {
-                                if (open_get_idle_time_out(open_handle, &connection->remote_idle_timeout) == 0)
+#ifdef UAMQP_STATIC_POOLS
+                                /* Codes_SRS_CONNECTION_01_365: [When built with UAMQP_STATIC_POOLS, a remote max frame size bigger than UAMQP_STATIC_MAX_FRAME_SIZE shall be used as UAMQP_STATIC_MAX_FRAME_SIZE, so that no frame bigger than the encode buffer of the frame codec is sent.] */
+                                if (connection->remote_max_frame_size > UAMQP_STATIC_MAX_FRAME_SIZE)
                                 {
-                                    /* since we obtained the remote_idle_timeout, compute at what millisecond we should send the empty frame */
-                                    connection->remote_idle_timeout_send_frame_millisecond = (milliseconds)(connection->idle_timeout_empty_frame_send_ratio * connection->remote_idle_timeout);
+                                    connection->remote_max_frame_size = UAMQP_STATIC_MAX_FRAME_SIZE;
                                 }
+#endif
 
-                                if ((open_get_max_frame_size(open_handle, &connection->remote_max_frame_size) != 0) ||
-                                    /* Codes_SRS_CONNECTION_01_167: [Both peers MUST accept frames of up to 512 (MIN-MAX-FRAME-SIZE) octets.] */
-                                    (connection->remote_max_frame_size < 512))
+                                if (connection->connection_state == CONNECTION_STATE_OPEN_SENT)
                                 {
-                                    /* Codes_SRS_CONNECTION_01_143: [If any of the values in the received open frame are invalid then the connection shall be closed.] */
-                                    /* Codes_SRS_CONNECTION_01_220: [The error amqp:invalid-field shall be set in the error.condition field of the CLOSE frame.] */
-                                    close_connection_with_error(connection, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing OPEN frame");
-                                    LogError("connection_endpoint_frame_received::failed parsing OPEN frame");
+                                    connection_set_state(connection, CONNECTION_STATE_OPENED);
                                 }
                                 else
                                 {
-                                    if (connection->connection_state == CONNECTION_STATE_OPEN_SENT)
+                                    if (send_open_frame(connection) != 0)
                                     {
-                                        connection_set_state(connection, CONNECTION_STATE_OPENED);
+                                        connection_set_state(connection, CONNECTION_STATE_END);
                                     }
                                     else
                                     {
-                                        if (send_open_frame(connection) != 0)
-                                        {
-                                            connection_set_state(connection, CONNECTION_STATE_END);
-                                        }
-                                        else
-                                        {
-                                            connection_set_state(connection, CONNECTION_STATE_OPENED);
-                                        }
+                                        connection_set_state(connection, CONNECTION_STATE_OPENED);
                                     }
                                 }
-
-                                open_destroy(open_handle);
                             }
+
+                            open_destroy(open_handle);
                         }
-                        else
+                    }
+                    else
+                    {
+                        /* do nothing for now ... */
+                    }
+                }
+                else if (performative_code == AMQP_CLOSE)
+                {
+                    /* Codes_SRS_CONNECTION_01_012: [A close frame MAY be received on any channel up to the maximum channel number negotiated in open.] */
+                    /* Codes_SRS_CONNECTION_01_242: [The connection module shall accept CLOSE frames even if they have extra payload bytes besides the Close performative.] */
+
+                    /* Codes_SRS_CONNECTION_01_225: [HDR_RCVD HDR OPEN] */
+                    if ((connection->connection_state == CONNECTION_STATE_HDR_RCVD) ||
+                        /* Codes_SRS_CONNECTION_01_227: [HDR_EXCH OPEN OPEN] */
+                        (connection->connection_state == CONNECTION_STATE_HDR_EXCH) ||
+                        /* Codes_SRS_CONNECTION_01_228: [OPEN_RCVD OPEN *] */
+                        (connection->connection_state == CONNECTION_STATE_OPEN_RCVD) ||
+                        /* Codes_SRS_CONNECTION_01_235: [CLOSE_SENT - * TCP Close for Write] */
+                        (connection->connection_state == CONNECTION_STATE_CLOSE_SENT) ||
+                        /* Codes_SRS_CONNECTION_01_236: [DISCARDING - * TCP Close for Write] */
+                        (connection->connection_state == CONNECTION_STATE_DISCARDING))
+                    {
+                        if (xio_close(connection->io, NULL, NULL) != 0)
                         {
-                            /* do nothing for now ... */
+                            LogError("xio_close failed");
                         }
                     }
-                    else if (is_close_type_by_descriptor(descriptor))
+                    else
                     {
+                        CLOSE_HANDLE close_handle;
+
                         /* Codes_SRS_CONNECTION_01_012: [A close frame MAY be received on any channel up to the maximum channel number negotiated in open.] */
-                        /* Codes_SRS_CONNECTION_01_242: [The connection module shall accept CLOSE frames even if they have extra payload bytes besides the Close performative.] */
-
-                        /* Codes_SRS_CONNECTION_01_225: [HDR_RCVD HDR OPEN] */
-                        if ((connection->connection_state == CONNECTION_STATE_HDR_RCVD) ||
-                            /* Codes_SRS_CONNECTION_01_227: [HDR_EXCH OPEN OPEN] */
-                            (connection->connection_state == CONNECTION_STATE_HDR_EXCH) ||
-                            /* Codes_SRS_CONNECTION_01_228: [OPEN_RCVD OPEN *] */
-                            (connection->connection_state == CONNECTION_STATE_OPEN_RCVD) ||
-                            /* Codes_SRS_CONNECTION_01_235: [CLOSE_SENT - * TCP Close for Write] */
-                            (connection->connection_state == CONNECTION_STATE_CLOSE_SENT) ||
-                            /* Codes_SRS_CONNECTION_01_236: [DISCARDING - * TCP Close for Write] */
-                            (connection->connection_state == CONNECTION_STATE_DISCARDING))
+                        if (channel > connection->channel_max)
                         {
-                            if (xio_close(connection->io, NULL, NULL) != 0)
-                            {
-                                LogError("xio_close failed");
-                            }
+                            close_connection_with_error(connection, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing CLOSE frame");
+                            LogError("connection_endpoint_frame_received::failed parsing CLOSE frame");
                         }
                         else
                         {
-                            CLOSE_HANDLE close_handle;
-
-                            /* Codes_SRS_CONNECTION_01_012: [A close frame MAY be received on any channel up to the maximum channel number negotiated in open.] */
-                            if (channel > connection->channel_max)
+                            if (amqpvalue_get_close(performative, &close_handle) != 0)
                             {
                                 close_connection_with_error(connection, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing CLOSE frame");
                                 LogError("connection_endpoint_frame_received::failed parsing CLOSE frame");
                             }
                             else
                             {
-                                if (amqpvalue_get_close(performative, &close_handle) != 0)
-                                {
-                                    close_connection_with_error(connection, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing CLOSE frame");
-                                    LogError("connection_endpoint_frame_received::failed parsing CLOSE frame");
-                                }
-                                else
-                                {
-                                    close_destroy(close_handle);
+                                close_destroy(close_handle);
 
-                                    connection_set_state(connection, CONNECTION_STATE_CLOSE_RCVD);
-
-                                    if (send_close_frame(connection, NULL) != 0)
-                                    {
-                                        LogError("Cannot send CLOSE frame");
-                                    }
+                                connection_set_state(connection, CONNECTION_STATE_CLOSE_RCVD);
 
-                                    /* Codes_SRS_CONNECTION_01_214: [If the close frame cannot be constructed or sent, the connection shall be closed and set to the END state.] */
-                                    if (xio_close(connection->io, NULL, NULL) != 0)
-                                    {
-                                        LogError("xio_close failed");
-                                    }
+                                if (send_close_frame(connection, NULL) != 0)
+                                {
+                                    LogError("Cannot send CLOSE frame");
+                                }
 
-                                    connection_set_state(connection, CONNECTION_STATE_END);
+                                /* Codes_SRS_CONNECTION_01_214: [If the close frame cannot be constructed or sent, the connection shall be closed and set to the END state.] */
+                                if (xio_close(connection->io, NULL, NULL) != 0)
+                                {
+                                    LogError("xio_close failed");
                                 }
+
+                                connection_set_state(connection, CONNECTION_STATE_END);
                             }
                         }
                     }
-                    else
+                }
+                else
+                {
+                    /* Codes_SRS_CONNECTION_01_326: [Received performatives shall be dispatched on the performative code passed by the AMQP frame codec, without reading the performative descriptor again.] */
+                    switch (performative_code)
                     {
-                        amqpvalue_get_ulong(descriptor, &performative_ulong);
+                    default:
+                        LogError("Bad performative: %02x", (unsigned int)performative_code);
+                        break;
 
-                        switch (performative_ulong)
-                        {
-                        default:
-                            LogError("Bad performative: %02x", performative);
-                            break;
+                    case AMQP_BEGIN:
+                    {
+                        BEGIN_HANDLE begin;
 
-                        case AMQP_BEGIN:
+                        if (amqpvalue_get_begin(performative, &begin) != 0)
+                        {
+                            LogError("Cannot get begin performative");
+                        }
+                        else
                         {
-                            BEGIN_HANDLE begin;
+                            uint16_t remote_channel;
+                            ENDPOINT_HANDLE new_endpoint = NULL;
+                            bool remote_begin = false;
 
-                            if (amqpvalue_get_begin(performative, &begin) != 0)
+                            if (begin_get_remote_channel(begin, &remote_channel) != 0)
                             {
-                                LogError("Cannot get begin performative");
-                            }
-                            else
-                            {
-                                uint16_t remote_channel;
-                                ENDPOINT_HANDLE new_endpoint = NULL;
-                                bool remote_begin = false;
-
-                                if (begin_get_remote_channel(begin, &remote_channel) != 0)
+                                remote_begin = true;
+                                if (connection->on_new_endpoint != NULL)
                                 {
-                                    remote_begin = true;
-                                    if (connection->on_new_endpoint != NULL)
+                                    if ((connection->session_admission_limiter != NULL) &&
+                                        (!admission_limiter_try_acquire(connection->session_admission_limiter)))
+                                    {
+                                        /* Codes_SRS_CONNECTION_01_379: [When a remote begin is received and the session admission limiter does not admit it, the connection shall, without creating an endpoint or calling on_new_endpoint, send on its lowest free outgoing channel a begin with the remote channel set to the channel of the received begin followed by an end with the error amqp:resource-limit-exceeded.] */
+                                        if (refuse_session(connection, channel) != 0)
+                                        {
+                                            /* Codes_SRS_CONNECTION_01_380: [If refusing the session fails, the connection shall be closed with the error amqp:internal-error.] */
+                                            close_connection_with_error(connection, "amqp:internal-error", "connection_endpoint_frame_received::cannot refuse session");
+                                        }
+                                    }
+                                    else
                                     {
                                         new_endpoint = connection_create_endpoint(connection);
                                         if (!connection->on_new_endpoint(connection->on_new_endpoint_callback_context, new_endpoint))
@@ -985,95 +1889,234 @@ static void on_amqp_frame_received(void* context, uint16_t channel, AMQP_VALUE p
                                         }
                                     }
                                 }
+                            }
 
-                                if (!remote_begin)
+                            if (!remote_begin)
+                            {
+                                ENDPOINT_INSTANCE* session_endpoint = find_session_endpoint_by_outgoing_channel(connection, remote_channel);
+                                if (session_endpoint == NULL)
                                 {
-                                    ENDPOINT_INSTANCE* session_endpoint = find_session_endpoint_by_outgoing_channel(connection, remote_channel);
-                                    if (session_endpoint == NULL)
-                                    {
-                                        LogError("Cannot create session endpoint");
-                                    }
-                                    else
-                                    {
-                                        session_endpoint->incoming_channel = channel;
-                                        session_endpoint->on_endpoint_frame_received(session_endpoint->callback_context, performative, payload_size, payload_bytes);
-                                    }
+                                    LogError("Cannot create session endpoint");
+                                }
+                                else if (set_endpoint_incoming_channel(connection, session_endpoint, channel) != 0)
+                                {
+                                    close_connection_with_error(connection, "amqp:internal-error", "connection_endpoint_frame_received::cannot map incoming channel");
+                                    LogError("Cannot map incoming channel %u", (unsigned int)channel);
                                 }
                                 else
                                 {
-                                    if (new_endpoint != NULL)
+                                    session_endpoint->on_endpoint_frame_received(session_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
+                                }
+                            }
+                            else
+                            {
+                                if (new_endpoint != NULL)
+                                {
+                                    if (set_endpoint_incoming_channel(connection, new_endpoint, channel) != 0)
+                                    {
+                                        close_connection_with_error(connection, "amqp:internal-error", "connection_endpoint_frame_received::cannot map incoming channel");
+                                        LogError("Cannot map incoming channel %u", (unsigned int)channel);
+                                    }
+                                    else
                                     {
-                                        new_endpoint->incoming_channel = channel;
-                                        new_endpoint->on_endpoint_frame_received(new_endpoint->callback_context, performative, payload_size, payload_bytes);
+                                        new_endpoint->on_endpoint_frame_received(new_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
                                     }
                                 }
-
-                                begin_destroy(begin);
                             }
 
-                            break;
+                            begin_destroy(begin);
                         }
 
-                        case AMQP_FLOW:
-                        case AMQP_TRANSFER:
-                        case AMQP_DISPOSITION:
-                        case AMQP_END:
-                        case AMQP_ATTACH:
-                        case AMQP_DETACH:
-                        {
-                            ENDPOINT_INSTANCE* session_endpoint = find_session_endpoint_by_incoming_channel(connection, channel);
-                            if (session_endpoint == NULL)
-                            {
-                                LogError("Cannot find session endpoint for channel %u", (unsigned int)channel);
-                            }
-                            else
-                            {
-                                session_endpoint->on_endpoint_frame_received(session_endpoint->callback_context, performative, payload_size, payload_bytes);
-                            }
+                        break;
+                    }
 
-                            break;
+                    case AMQP_FLOW:
+                    case AMQP_TRANSFER:
+                    case AMQP_DISPOSITION:
+                    case AMQP_END:
+                    case AMQP_ATTACH:
+                    case AMQP_DETACH:
+                    {
+                        ENDPOINT_INSTANCE* session_endpoint = find_session_endpoint_by_incoming_channel(connection, channel);
+                        if (session_endpoint == NULL)
+                        {
+                            LogError("Cannot find session endpoint for channel %u", (unsigned int)channel);
                         }
+                        else
+                        {
+                            session_endpoint->on_endpoint_frame_received(session_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
                         }
+
+                        break;
+                    }
                     }
                 }
-                break;
-
-            case CONNECTION_STATE_START:
-                /* Codes_SRS_CONNECTION_01_224: [START HDR HDR] */
-            case CONNECTION_STATE_HDR_SENT:
-                /* Codes_SRS_CONNECTION_01_226: [HDR_SENT OPEN HDR] */
-            case CONNECTION_STATE_OPEN_PIPE:
-                /* Codes_SRS_CONNECTION_01_230: [OPEN_PIPE ** HDR] */
-            case CONNECTION_STATE_OC_PIPE:
-                /* Codes_SRS_CONNECTION_01_232: [OC_PIPE - HDR TCP Close for Write] */
-            case CONNECTION_STATE_CLOSE_RCVD:
-                /* Codes_SRS_CONNECTION_01_234: [CLOSE_RCVD * - TCP Close for Read] */
-            case CONNECTION_STATE_END:
-                /* Codes_SRS_CONNECTION_01_237: [END - - TCP Close] */
-                if (xio_close(connection->io, NULL, NULL) != 0)
-                {
-                    LogError("xio_close failed");
-                }
-                break;
             }
+            break;
+
+        case CONNECTION_STATE_START:
+            /* Codes_SRS_CONNECTION_01_224: [START HDR HDR] */
+        case CONNECTION_STATE_HDR_SENT:
+            /* Codes_SRS_CONNECTION_01_226: [HDR_SENT OPEN HDR] */
+        case CONNECTION_STATE_OPEN_PIPE:
+            /* Codes_SRS_CONNECTION_01_230: [OPEN_PIPE ** HDR] */
+        case CONNECTION_STATE_OC_PIPE:
+            /* Codes_SRS_CONNECTION_01_232: [OC_PIPE - HDR TCP Close for Write] */
+        case CONNECTION_STATE_CLOSE_RCVD:
+            /* Codes_SRS_CONNECTION_01_234: [CLOSE_RCVD * - TCP Close for Read] */
+        case CONNECTION_STATE_END:
+            /* Codes_SRS_CONNECTION_01_237: [END - - TCP Close] */
+            if (xio_close(connection->io, NULL, NULL) != 0)
+            {
+                LogError("xio_close failed");
+            }
+            break;
         }
     }
 }
 
-static void frame_codec_error(void* context)
+static unsigned char* get_quota_receive_buffer(void* context, uint32_t size)
 {
-    /* Bug: some error handling should happen here 
-    Filed: uAMQP: frame_codec error and amqp_frame_codec_error should handle the errors */
-    LogError("A frame_codec_error occured");
-    (void)context;
-}
+    unsigned char* result;
+    CONNECTION_INSTANCE* connection = (CONNECTION_INSTANCE*)context;
 
-static void amqp_frame_codec_error(void* context)
-{
-    /* Bug: some error handling should happen here
-    Filed: uAMQP: frame_codec error and amqp_frame_codec_error should handle the errors */
-    LogError("An amqp_frame_codec_error occured");
-    (void)context;
+    if (size <= connection->quota_receive_buffer_size)
+    {
+        result = connection->quota_receive_buffer;
+    }
+    /* Codes_SRS_CONNECTION_01_386: [Under a memory quota, the connection shall receive frames in one buffer that it keeps, charging the memory quota when the buffer has to grow.] */
+    else if (connection_charge_memory(connection, size - connection->quota_receive_buffer_size) != 0)
+    {
+        LogError("Frame of %u bytes exceeds the memory quota", (unsigned int)size);
+        result = NULL;
+    }
+    else
+    {
+        /* the previous contents are not needed, but realloc keeps the old buffer when it fails */
+        result = (unsigned char*)connection_realloc(connection, connection->quota_receive_buffer, size);
+        if (result == NULL)
+        {
+            LogError("Cannot allocate %u bytes for the received frame", (unsigned int)size);
+            connection_release_memory(connection, size - connection->quota_receive_buffer_size);
+        }
+        else
+        {
+            ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, connection->quota_receive_buffer_size, size);
+            connection->quota_receive_buffer = result;
+            connection->quota_receive_buffer_size = size;
+        }
+    }
+
+    return result;
+}
+
+static unsigned char* grow_quota_receive_buffer(void* context, unsigned char* buffer, uint32_t size)
+{
+    /* the buffer is the one the connection keeps, which get_quota_receive_buffer reallocates keeping its bytes */
+    (void)buffer;
+    return get_quota_receive_buffer(context, size);
+}
+
+static void release_quota_receive_buffer(void* context, unsigned char* buffer)
+{
+    /* the buffer is kept for the next frame */
+    (void)context;
+    (void)buffer;
+}
+
+static unsigned char* get_pool_receive_buffer(void* context, uint32_t size)
+{
+    CONNECTION_INSTANCE* connection = (CONNECTION_INSTANCE*)context;
+    unsigned char* result = buffer_pool_get(connection->receive_buffer_pool, size);
+
+    if (result == NULL)
+    {
+        /* Codes_SRS_CONNECTION_01_431: [If the buffer pool cannot give a buffer for a frame, the frame shall be received in one buffer that the connection keeps, like under a memory quota.] */
+        result = get_quota_receive_buffer(context, size);
+    }
+    /* Codes_SRS_CONNECTION_01_430: [While a pool buffer holds a received frame, the bytes asked for by the frame codec shall be charged to the memory quota.] */
+    else if (connection_charge_memory(connection, size) != 0)
+    {
+        LogError("Frame of %u bytes exceeds the memory quota", (unsigned int)size);
+        buffer_pool_release(connection->receive_buffer_pool, result);
+        result = NULL;
+    }
+    else
+    {
+        connection->pool_receive_buffer_charge = size;
+    }
+
+    return result;
+}
+
+static unsigned char* grow_pool_receive_buffer(void* context, unsigned char* buffer, uint32_t size)
+{
+    unsigned char* result;
+    CONNECTION_INSTANCE* connection = (CONNECTION_INSTANCE*)context;
+
+    if (buffer == connection->quota_receive_buffer)
+    {
+        result = get_quota_receive_buffer(context, size);
+    }
+    else if (size <= buffer_pool_get_buffer_size(connection->receive_buffer_pool))
+    {
+        /* Codes_SRS_CONNECTION_01_456: [When the frame codec grows a pool buffer that is big enough, the buffer shall be kept and the memory quota charged for the added bytes.] */
+        if (connection_charge_memory(connection, size - connection->pool_receive_buffer_charge) != 0)
+        {
+            LogError("Frame of %u bytes exceeds the memory quota", (unsigned int)size);
+            result = NULL;
+        }
+        else
+        {
+            connection->pool_receive_buffer_charge = size;
+            result = buffer;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_457: [When the frame codec grows a pool buffer past the buffer size of the pool, the frame bytes shall be moved to the buffer that the connection keeps and the pool buffer released.] */
+        result = get_quota_receive_buffer(context, size);
+        if (result != NULL)
+        {
+            (void)memcpy(result, buffer, connection->pool_receive_buffer_charge);
+            connection_release_memory(connection, connection->pool_receive_buffer_charge);
+            connection->pool_receive_buffer_charge = 0;
+            buffer_pool_release(connection->receive_buffer_pool, buffer);
+        }
+    }
+
+    return result;
+}
+
+static void release_pool_receive_buffer(void* context, unsigned char* buffer)
+{
+    CONNECTION_INSTANCE* connection = (CONNECTION_INSTANCE*)context;
+
+    /* the connection's own buffer is kept for the next frame */
+    if (buffer != connection->quota_receive_buffer)
+    {
+        connection_release_memory(connection, connection->pool_receive_buffer_charge);
+        connection->pool_receive_buffer_charge = 0;
+        buffer_pool_release(connection->receive_buffer_pool, buffer);
+    }
+}
+
+static void frame_codec_error(void* context)
+{
+    /* Bug: some error handling should happen here 
+    Filed: uAMQP: frame_codec error and amqp_frame_codec_error should handle the errors */
+    LogError("A frame_codec_error occured");
+    (void)context;
+}
+
+static void amqp_frame_codec_error(void* context)
+{
+    CONNECTION_HANDLE connection = (CONNECTION_HANDLE)context;
+
+    LogError("An amqp_frame_codec_error occured");
+
+    /* Codes_SRS_CONNECTION_01_453: [When the amqp_frame_codec reports that a frame could not be decoded, a decoder limit breach included, the connection shall be closed with the error condition amqp:decode-error and an implementation defined error description.] */
+    close_connection_with_error(connection, "amqp:decode-error", "amqp_frame_codec_error::cannot decode frame");
 }
 
 /* Codes_SRS_CONNECTION_01_001: [connection_create shall open a new connection to a specified host/port.] */
@@ -1085,6 +2128,11 @@ CONNECTION_HANDLE connection_create(XIO_HANDLE xio, const char* hostname, const
 /* Codes_SRS_CONNECTION_01_001: [connection_create shall open a new connection to a specified host/port.] */
 /* Codes_SRS_CONNECTION_22_002: [connection_create shall allow registering connections state and io error callbacks.] */
 CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const char* container_id, ON_NEW_ENDPOINT on_new_endpoint, void* callback_context, ON_CONNECTION_STATE_CHANGED on_connection_state_changed, void* on_connection_state_changed_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    return connection_create3(xio, hostname, container_id, on_new_endpoint, callback_context, on_connection_state_changed, on_connection_state_changed_context, on_io_error, on_io_error_context, NULL);
+}
+
+CONNECTION_HANDLE connection_create3(XIO_HANDLE xio, const char* hostname, const char* container_id, ON_NEW_ENDPOINT on_new_endpoint, void* callback_context, ON_CONNECTION_STATE_CHANGED on_connection_state_changed, void* on_connection_state_changed_context, ON_IO_ERROR on_io_error, void* on_io_error_context, const CONNECTION_ALLOCATOR* allocator)
 {
     CONNECTION_HANDLE connection;
 
@@ -1096,9 +2144,23 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
             xio, container_id);
         connection = NULL;
     }
+    /* Codes_SRS_CONNECTION_01_361: [If `allocator` is not NULL and any of its functions is NULL, `connection_create3` shall fail and return NULL.] */
+    else if ((allocator != NULL) &&
+        ((allocator->malloc_function == NULL) ||
+        (allocator->realloc_function == NULL) ||
+        (allocator->free_function == NULL)))
+    {
+        LogError("Bad allocator: malloc_function = %p, realloc_function = %p, free_function = %p",
+            allocator->malloc_function, allocator->realloc_function, allocator->free_function);
+        connection = NULL;
+    }
     else
     {
-        connection = (CONNECTION_HANDLE)malloc(sizeof(CONNECTION_INSTANCE));
+        /* Codes_SRS_CONNECTION_01_359: [`connection_create3` shall allocate the connection, its host name, container id and endpoints, and the outgoing batch and send bookkeeping of its frames with the functions of `allocator`, passing them the allocator context.] */
+        /* Codes_SRS_CONNECTION_01_360: [If `allocator` is NULL, `connection_create3` shall behave like `connection_create2` and use the malloc family.] */
+        const CONNECTION_ALLOCATOR* connection_allocator = (allocator == NULL) ? &default_allocator : allocator;
+
+        connection = (CONNECTION_HANDLE)connection_allocator->malloc_function(connection_allocator->context, sizeof(CONNECTION_INSTANCE));
         /* Codes_SRS_CONNECTION_01_081: [If allocating the memory for the connection fails then connection_create shall return NULL.] */
         if (connection == NULL)
         {
@@ -1107,6 +2169,8 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
         else
         {
             connection->io = xio;
+            /* the allocator struct is copied, the caller does not have to keep it around */
+            connection->allocator = *connection_allocator;
 
             /* Codes_SRS_CONNECTION_01_082: [connection_create shall allocate a new frame_codec instance to be used for frame encoding/decoding.] */
             connection->frame_codec = frame_codec_create(frame_codec_error, connection);
@@ -1114,7 +2178,7 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
             {
                 /* Codes_SRS_CONNECTION_01_083: [If frame_codec_create fails then connection_create shall return NULL.] */
                 LogError("Cannot create frame_codec");
-                free(connection);
+                connection_free(connection, connection);
                 connection = NULL;
             }
             else
@@ -1125,7 +2189,7 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
                     /* Codes_SRS_CONNECTION_01_108: [If amqp_frame_codec_create fails, connection_create shall return NULL.] */
                     LogError("Cannot create amqp_frame_codec");
                     frame_codec_destroy(connection->frame_codec);
-                    free(connection);
+                    connection_free(connection, connection);
                     connection = NULL;
                 }
                 else
@@ -1133,14 +2197,14 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
                     if (hostname != NULL)
                     {
                         size_t hostname_length = strlen(hostname);
-                        connection->host_name = (char*)malloc(hostname_length + 1);
+                        connection->host_name = (char*)connection_malloc(connection, hostname_length + 1);
                         if (connection->host_name == NULL)
                         {
                             /* Codes_SRS_CONNECTION_01_081: [If allocating the memory for the connection fails then connection_create shall return NULL.] */
                             LogError("Cannot allocate memory for host name");
                             amqp_frame_codec_destroy(connection->amqp_frame_codec);
                             frame_codec_destroy(connection->frame_codec);
-                            free(connection);
+                            connection_free(connection, connection);
                             connection = NULL;
                         }
                         else
@@ -1156,15 +2220,15 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
                     if (connection != NULL)
                     {
                         size_t container_id_length = strlen(container_id);
-                        connection->container_id = (char*)malloc(container_id_length + 1);
+                        connection->container_id = (char*)connection_malloc(connection, container_id_length + 1);
                         if (connection->container_id == NULL)
                         {
                             /* Codes_SRS_CONNECTION_01_081: [If allocating the memory for the connection fails then connection_create shall return NULL.] */
                             LogError("Cannot allocate memory for container_id");
-                            free(connection->host_name);
+                            connection_free(connection, connection->host_name);
                             amqp_frame_codec_destroy(connection->amqp_frame_codec);
                             frame_codec_destroy(connection->frame_codec);
-                            free(connection);
+                            connection_free(connection, connection);
                             connection = NULL;
                         }
                         else
@@ -1173,19 +2237,24 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
                             if (connection->tick_counter == NULL)
                             {
                                 LogError("Cannot create tick counter");
-                                free(connection->container_id);
-                                free(connection->host_name);
+                                connection_free(connection, connection->container_id);
+                                connection_free(connection, connection->host_name);
                                 amqp_frame_codec_destroy(connection->amqp_frame_codec);
                                 frame_codec_destroy(connection->frame_codec);
-                                free(connection);
+                                connection_free(connection, connection);
                                 connection = NULL;
                             }
                             else
                             {
                                 (void)memcpy(connection->container_id, container_id, container_id_length + 1);
 
+#ifdef UAMQP_STATIC_POOLS
+                                /* Codes_SRS_CONNECTION_01_364: [When built with UAMQP_STATIC_POOLS, the max frame size of a new connection shall be UAMQP_STATIC_MAX_FRAME_SIZE and connection_set_max_frame_size shall fail for bigger values.] */
+                                connection->max_frame_size = UAMQP_STATIC_MAX_FRAME_SIZE;
+#else
                                 /* Codes_SRS_CONNECTION_01_173: [<field name="max-frame-size" type="uint" default="4294967295"/>] */
                                 connection->max_frame_size = 4294967295u;
+#endif
                                 /* Codes: [<field name="channel-max" type="ushort" default="65535"/>] */
                                 connection->channel_max = 65535;
 
@@ -1197,7 +2266,10 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
                                 connection->idle_timeout_empty_frame_send_ratio = 0.5;
 
                                 connection->endpoint_count = 0;
+                                connection->endpoint_capacity = 0;
                                 connection->endpoints = NULL;
+                                connection->endpoints_by_incoming_channel = NULL;
+                                connection->incoming_channel_table_size = 0;
                                 connection->header_bytes_received = 0;
                                 connection->is_remote_frame_received = 0;
                                 connection->properties = NULL;
@@ -1205,12 +2277,60 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
                                 connection->is_underlying_io_open = 0;
                                 connection->remote_max_frame_size = 512;
                                 connection->is_trace_on = 0;
+                                connection->is_encoding_batched_frame = 0;
+
+                                /* Codes_SRS_CONNECTION_01_284: [By default outgoing frames shall not be batched.] */
+                                connection->outgoing_batch_size = 0;
+                                /* Codes_SRS_CONNECTION_01_350: [By default the outgoing batch shall be flushed on every connection_dowork.] */
+                                connection->outgoing_batch_delay = 0;
+                                connection->outgoing_batch_start_time = 0;
+                                connection->outgoing_batch_hold_count = 0;
+                                connection->dowork_endpoint_count = 0;
+                                /* Codes_SRS_CONNECTION_01_329: [By default frames shall not be aligned.] */
+                                connection->frame_size_alignment = 0;
+                                /* Codes_SRS_CONNECTION_01_341: [By default the send queue shall not be limited.] */
+                                connection->send_queue = NULL;
+                                connection->send_queue_high_water_mark = 0;
+                                connection->send_queue_low_water_mark = 0;
+                                connection->is_send_queue_full = 0;
+                                /* Codes_SRS_CONNECTION_01_385: [By default the memory of a connection shall not be limited.] */
+                                connection->memory_quota = 0;
+                                connection->low_memory_mark = 0;
+                                connection->memory_in_use = 0;
+                                connection->quota_receive_buffer = NULL;
+                                connection->quota_receive_buffer_size = 0;
+                                connection->is_memory_quota_exceeded = 0;
+                                connection->receive_buffer_pool = NULL;
+                                connection->pool_receive_buffer_charge = 0;
+                                /* Codes_SRS_CONNECTION_01_395: [By default the reads from the io shall not be paused.] */
+                                connection->receive_backlog = 0;
+                                connection->receive_pause_backlog = 0;
+                                connection->receive_resume_backlog = 0;
+                                connection->is_receive_paused = 0;
+                                connection->io_interest_bytes_sent = 0;
+
+                                /* Codes_SRS_CONNECTION_01_312: [By default the open shall not be pipelined.] */
+                                connection->is_pipelined_open = 0;
+                                connection->is_resuming_handover = false;
+                                (void)memset(&connection->stats, 0, sizeof(connection->stats));
+                                connection->frame_trace = NULL;
+                                connection->on_flow_event = NULL;
+                                connection->on_flow_event_context = NULL;
+                                connection->callback_budget = 0;
+                                (void)memset(&connection->callback_stats, 0, sizeof(connection->callback_stats));
+                                connection->outgoing_batch = NULL;
+                                connection->outgoing_batch_length = 0;
+                                connection->outgoing_batch_capacity = 0;
+                                connection->outgoing_batch_completions = NULL;
+                                connection->outgoing_batch_completion_count = 0;
+                                connection->outgoing_batch_completion_capacity = 0;
 
                                 /* Mark that settings have not yet been set by the user */
                                 connection->idle_timeout_specified = 0;
 
                                 connection->on_new_endpoint = on_new_endpoint;
                                 connection->on_new_endpoint_callback_context = callback_context;
+                                connection->session_admission_limiter = NULL;
 
                                 connection->on_io_error = on_io_error;
                                 connection->on_io_error_callback_context = on_io_error_context;
@@ -1221,19 +2341,21 @@ CONNECTION_HANDLE connection_create2(XIO_HANDLE xio, const char* hostname, const
                                 {
                                     LogError("Could not retrieve time for last frame received time");
                                     tickcounter_destroy(connection->tick_counter);
-                                    free(connection->container_id);
-                                    free(connection->host_name);
+                                    connection_free(connection, connection->container_id);
+                                    connection_free(connection, connection->host_name);
                                     amqp_frame_codec_destroy(connection->amqp_frame_codec);
                                     frame_codec_destroy(connection->frame_codec);
-                                    free(connection);
+                                    connection_free(connection, connection);
                                     connection = NULL;
                                 }
                                 else
                                 {
                                     connection->last_frame_sent_time = connection->last_frame_received_time;
+                                    connection->coarse_current_ms = connection->last_frame_received_time;
 
                                     /* Codes_SRS_CONNECTION_01_072: [When connection_create succeeds, the state of the connection shall be CONNECTION_STATE_START.] */
                                     connection_set_state(connection, CONNECTION_STATE_START);
+                                    ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_CONNECTION, sizeof(CONNECTION_INSTANCE));
                                 }
                             }
                         }
@@ -1269,11 +2391,26 @@ void connection_destroy(CONNECTION_HANDLE connection)
             amqpvalue_destroy(connection->properties);
         }
 
-        free(connection->host_name);
-        free(connection->container_id);
+        connection_free(connection, connection->host_name);
+        connection_free(connection, connection->container_id);
+        connection_free(connection, connection->endpoints_by_incoming_channel);
+        ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, connection->quota_receive_buffer_size, 0);
+        connection_free(connection, connection->quota_receive_buffer);
+
+        /* Codes_SRS_CONNECTION_01_285: [connection_destroy shall call the send completions of any frames still waiting in the outgoing batch with IO_SEND_CANCELLED.] */
+        complete_outgoing_batch(connection, IO_SEND_CANCELLED);
+        ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, connection->outgoing_batch_capacity, 0);
+        connection_free(connection, connection->outgoing_batch);
+        connection_free(connection, connection->outgoing_batch_completions);
+
+        if (connection->send_queue != NULL)
+        {
+            release_send_queue(connection->send_queue);
+        }
 
         /* Codes_SRS_CONNECTION_01_074: [connection_destroy shall close the socket connection.] */
-        free(connection);
+        ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_CONNECTION, sizeof(CONNECTION_INSTANCE));
+        connection_free(connection, connection);
     }
 }
 
@@ -1406,6 +2543,14 @@ int connection_set_max_frame_size(CONNECTION_HANDLE connection, uint32_t max_fra
         LogError("max_frame_size too small");
         result = __FAILURE__;
     }
+#ifdef UAMQP_STATIC_POOLS
+    /* Codes_SRS_CONNECTION_01_364: [When built with UAMQP_STATIC_POOLS, the max frame size of a new connection shall be UAMQP_STATIC_MAX_FRAME_SIZE and connection_set_max_frame_size shall fail for bigger values.] */
+    else if (max_frame_size > UAMQP_STATIC_MAX_FRAME_SIZE)
+    {
+        LogError("max_frame_size bigger than the static max frame size %u", (unsigned int)UAMQP_STATIC_MAX_FRAME_SIZE);
+        result = __FAILURE__;
+    }
+#endif
     else
     {
         /* Codes_SRS_CONNECTION_01_157: [If connection_set_max_frame_size is called after the initial Open frame has been sent, it shall fail and return a non-zero value.] */
@@ -1696,10 +2841,67 @@ int connection_get_remote_max_frame_size(CONNECTION_HANDLE connection, uint32_t*
     return result;
 }
 
+int connection_set_frame_size_alignment(CONNECTION_HANDLE connection, uint32_t frame_size_alignment)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_330: [If connection is NULL, connection_set_frame_size_alignment shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_327: [connection_set_frame_size_alignment shall set the number of bytes that the size of the frames a transfer is split into shall be a multiple of.] */
+        /* Codes_SRS_CONNECTION_01_328: [Setting frame_size_alignment to 0 shall disable the alignment.] */
+        connection->frame_size_alignment = frame_size_alignment;
+
+        /* Codes_SRS_CONNECTION_01_331: [On success, connection_set_frame_size_alignment shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_get_split_frame_size(CONNECTION_HANDLE connection, uint32_t* split_frame_size)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_332: [If connection or split_frame_size is NULL, connection_get_split_frame_size shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (split_frame_size == NULL))
+    {
+        LogError("Bad arguments: connection = %p, split_frame_size = %p",
+            connection, split_frame_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_333: [connection_get_split_frame_size shall return in split_frame_size the largest multiple of the frame size alignment that is not bigger than the remote max frame size.] */
+        /* Codes_SRS_CONNECTION_01_334: [If no alignment is set or the alignment is bigger than the remote max frame size, connection_get_split_frame_size shall return the remote max frame size.] */
+        if ((connection->frame_size_alignment == 0) ||
+            (connection->frame_size_alignment > connection->remote_max_frame_size))
+        {
+            *split_frame_size = connection->remote_max_frame_size;
+        }
+        else
+        {
+            *split_frame_size = connection->remote_max_frame_size - (connection->remote_max_frame_size % connection->frame_size_alignment);
+        }
+
+        /* Codes_SRS_CONNECTION_01_335: [On success, connection_get_split_frame_size shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
 uint64_t connection_handle_deadlines(CONNECTION_HANDLE connection)
 {
     uint64_t local_deadline = (uint64_t)-1;
     uint64_t remote_deadline = (uint64_t)-1;
+    uint64_t batch_deadline = (uint64_t)-1;
 
     if (connection == NULL)
     {
@@ -1716,6 +2918,16 @@ uint64_t connection_handle_deadlines(CONNECTION_HANDLE connection)
         }
         else
         {
+            /* Codes_SRS_CONNECTION_01_376: [connection_handle_deadlines shall refresh the coarse clock with the time it gets from the tick counter.] */
+            connection->coarse_current_ms = current_ms;
+
+            /* Codes_SRS_CONNECTION_01_400: [While the reads are paused, the idle timeout of the connection shall not expire.] */
+            if (connection->is_receive_paused)
+            {
+                /* the frames of the peer are not read, so its silence is not a reason to close */
+                connection->last_frame_received_time = current_ms;
+            }
+
             if (connection->idle_timeout_specified && (connection->idle_timeout != 0))
             {
                 /* Calculate time until configured idle timeout expires */
@@ -1756,20 +2968,42 @@ uint64_t connection_handle_deadlines(CONNECTION_HANDLE connection)
                     }
                     else
                     {
+                        connection->stats.empty_frames_sent++;
+
                         if (connection->is_trace_on == 1)
                         {
                             LOG(AZ_LOG_TRACE, LOG_LINE, "-> Empty frame");
                         }
 
+                        if (connection->frame_trace != NULL)
+                        {
+                            trace_frame_bytes(connection, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, NULL, 0, 0);
+                        }
+
                         connection->last_frame_sent_time = current_ms;
 
                         remote_deadline = remote_idle_timeout;
                     }
                 }
             }
+
+            /* Codes_SRS_CONNECTION_01_358: [While the outgoing batch is held for an outgoing batch delay, connection_handle_deadlines shall return no more than the number of milliseconds left until it is due.] */
+            /* a batch that is already due is flushed by connection_dowork right after, so it does not shorten the deadline */
+            if ((local_deadline != 0) &&
+                (connection->outgoing_batch_delay > 0) &&
+                (connection->outgoing_batch_length > 0) &&
+                (current_ms - connection->outgoing_batch_start_time < connection->outgoing_batch_delay))
+            {
+                batch_deadline = connection->outgoing_batch_delay - (current_ms - connection->outgoing_batch_start_time);
+            }
         }
     }
 
+    if (remote_deadline > batch_deadline)
+    {
+        remote_deadline = batch_deadline;
+    }
+
     /* Return the shorter of each deadline, or 0 to indicate connection closed */
     return local_deadline > remote_deadline ? remote_deadline : local_deadline;
 }
@@ -1785,8 +3019,70 @@ void connection_dowork(CONNECTION_HANDLE connection)
     {
         if (connection_handle_deadlines(connection) > 0)
         {
+            /* Codes_SRS_CONNECTION_01_404: [connection_dowork shall call the on_dowork callback of every endpoint that set one while holding the outgoing batch, so that the frames the endpoints encode from these callbacks reach the io in one call to xio_send.] */
+            if ((connection->dowork_endpoint_count > 0) &&
+                (connection_hold_outgoing_batch(connection) == 0))
+            {
+                uint32_t i;
+
+                for (i = 0; i < connection->endpoint_count; i++)
+                {
+                    if (connection->endpoints[i]->on_dowork != NULL)
+                    {
+                        connection->endpoints[i]->on_dowork(connection->endpoints[i]->on_dowork_context);
+                    }
+                }
+
+                if (connection_release_outgoing_batch(connection) != 0)
+                {
+                    LogError("Cannot release the outgoing batch");
+                }
+            }
+
+            /* Codes_SRS_CONNECTION_01_283: [connection_dowork shall flush the outgoing batch before calling xio_dowork.] */
+            /* Codes_SRS_CONNECTION_01_356: [When an outgoing batch delay is set, connection_dowork shall only flush the outgoing batch once its oldest bytes were batched at least outgoing_batch_delay milliseconds ago.] */
+            /* Codes_SRS_CONNECTION_01_368: [While the outgoing batch is held, the frames encoded by connection_encode_frame and connection_encode_frame_with_encoded_performative shall be accumulated in the outgoing batch whatever their size, and the batch shall not be flushed when it reaches outgoing_batch_size nor by connection_dowork.] */
+            if ((connection->outgoing_batch_hold_count == 0) &&
+                is_outgoing_batch_due(connection) &&
+                (flush_outgoing_batch(connection) != 0))
+            {
+                LogError("Cannot flush the outgoing batch");
+
+                if (xio_close(connection->io, NULL, NULL) != 0)
+                {
+                    LogError("xio_close failed");
+                }
+
+                connection_set_state(connection, CONNECTION_STATE_END);
+            }
+
             /* Codes_SRS_CONNECTION_01_076: [connection_dowork shall schedule the underlying IO interface to do its work by calling xio_dowork.] */
-            xio_dowork(connection->io);
+            /* Codes_SRS_CONNECTION_01_399: [While the reads are paused, connection_dowork shall not call xio_dowork, so that the bytes of the peer stay in the transport and its flow control pushes back on the peer.] */
+            if (!connection->is_receive_paused)
+            {
+                xio_dowork(connection->io);
+            }
+
+            /* Codes_SRS_CONNECTION_01_339: [When the send queue is full and no more bytes than the low water mark are left in it, connection_dowork shall mark it as not full and call the on_send_queue_drained callback of every endpoint that set one.] */
+            if (connection->is_send_queue_full &&
+                ((connection->send_queue_high_water_mark == 0) ||
+                (connection->send_queue->queued_bytes <= connection->send_queue_low_water_mark)))
+            {
+                uint32_t i;
+
+                connection->is_send_queue_full = 0;
+
+                /* Codes_SRS_CONNECTION_01_417: [When connection_dowork marks the send queue as not full, the connection shall report CONNECTION_FLOW_EVENT_SEND_QUEUE_DRAINED with the connection as source and the queued bytes as value, before calling the on_send_queue_drained callbacks.] */
+                connection_report_flow_event(connection, CONNECTION_FLOW_EVENT_SEND_QUEUE_DRAINED, connection, NULL, connection->send_queue->queued_bytes);
+
+                for (i = 0; i < connection->endpoint_count; i++)
+                {
+                    if (connection->endpoints[i]->on_send_queue_drained != NULL)
+                    {
+                        connection->endpoints[i]->on_send_queue_drained(connection->endpoints[i]->on_send_queue_drained_context);
+                    }
+                }
+            }
         }
     }
 }
@@ -1811,20 +3107,11 @@ ENDPOINT_HANDLE connection_create_endpoint(CONNECTION_HANDLE connection)
         }
         else
         {
-            uint32_t i = 0;
-
             /* Codes_SRS_CONNECTION_01_128: [The lowest number outgoing channel shall be associated with the newly created endpoint.] */
-            for (i = 0; i < connection->endpoint_count; i++)
-            {
-                if (connection->endpoints[i]->outgoing_channel > i)
-                {
-                    /* found a gap in the sorted endpoint array */
-                    break;
-                }
-            }
+            uint32_t i = get_lowest_free_outgoing_channel(connection);
 
             /* Codes_SRS_CONNECTION_01_127: [On success, connection_create_endpoint shall return a non-NULL handle to the newly created endpoint.] */
-            result = (ENDPOINT_HANDLE)malloc(sizeof(ENDPOINT_INSTANCE));
+            result = (ENDPOINT_HANDLE)connection_malloc(connection, sizeof(ENDPOINT_INSTANCE));
             /* Codes_SRS_CONNECTION_01_196: [If memory cannot be allocated for the new endpoint, connection_create_endpoint shall fail and return NULL.] */
             if (result == NULL)
             {
@@ -1832,27 +3119,46 @@ ENDPOINT_HANDLE connection_create_endpoint(CONNECTION_HANDLE connection)
             }
             else
             {
-                ENDPOINT_HANDLE* new_endpoints;
-
                 result->on_endpoint_frame_received = NULL;
                 result->on_connection_state_changed = NULL;
                 result->callback_context = NULL;
+                result->on_send_queue_drained = NULL;
+                result->on_send_queue_drained_context = NULL;
+                result->on_dowork = NULL;
+                result->on_dowork_context = NULL;
+                result->incoming_channel = 0;
+                result->has_incoming_channel = false;
                 result->outgoing_channel = (uint16_t)i;
                 result->connection = connection;
 
                 /* Codes_SRS_CONNECTION_01_197: [The newly created endpoint shall be added to the endpoints list, so that it can be tracked.] */
-                new_endpoints = (ENDPOINT_HANDLE*)realloc(connection->endpoints, sizeof(ENDPOINT_HANDLE) * (connection->endpoint_count + 1));
-                if (new_endpoints == NULL)
+                if (connection->endpoint_count == connection->endpoint_capacity)
                 {
-                    /* Tests_SRS_CONNECTION_01_198: [If adding the endpoint to the endpoints list tracked by the connection fails, connection_create_endpoint shall fail and return NULL.] */
-                    LogError("Cannot reallocate memory for connection endpoints");
-                    free(result);
-                    result = NULL;
+                    uint32_t new_capacity = (connection->endpoint_capacity == 0) ? 4 : (connection->endpoint_capacity * 2);
+                    ENDPOINT_HANDLE* new_endpoints;
+
+                    if (new_capacity > (uint32_t)connection->channel_max + 1)
+                    {
+                        new_capacity = (uint32_t)connection->channel_max + 1;
+                    }
+
+                    new_endpoints = (ENDPOINT_HANDLE*)connection_realloc(connection, connection->endpoints, sizeof(ENDPOINT_HANDLE) * new_capacity);
+                    if (new_endpoints == NULL)
+                    {
+                        /* Tests_SRS_CONNECTION_01_198: [If adding the endpoint to the endpoints list tracked by the connection fails, connection_create_endpoint shall fail and return NULL.] */
+                        LogError("Cannot reallocate memory for connection endpoints");
+                        connection_free(connection, result);
+                        result = NULL;
+                    }
+                    else
+                    {
+                        connection->endpoints = new_endpoints;
+                        connection->endpoint_capacity = new_capacity;
+                    }
                 }
-                else
-                {
-                    connection->endpoints = new_endpoints;
 
+                if (result != NULL)
+                {
                     if (i < connection->endpoint_count)
                     {
                         (void)memmove(&connection->endpoints[i + 1], &connection->endpoints[i], sizeof(ENDPOINT_INSTANCE*) * (connection->endpoint_count - i));
@@ -1914,85 +3220,159 @@ int connection_endpoint_get_incoming_channel(ENDPOINT_HANDLE endpoint, uint16_t*
     return result;
 }
 
-/* Codes_SRS_CONNECTION_01_129: [connection_destroy_endpoint shall free all resources associated with an endpoint created by connection_create_endpoint.] */
-void connection_destroy_endpoint(ENDPOINT_HANDLE endpoint)
+int connection_endpoint_get_outgoing_channel(ENDPOINT_HANDLE endpoint, uint16_t* outgoing_channel)
 {
-    if (endpoint == NULL)
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_448: [If endpoint or outgoing_channel is NULL, connection_endpoint_get_outgoing_channel shall fail and return a non-zero value.] */
+    if ((endpoint == NULL) ||
+        (outgoing_channel == NULL))
     {
-        LogError("NULL endpoint");
+        LogError("Bad arguments: endpoint = %p, outgoing_channel = %p",
+            endpoint, outgoing_channel);
+        result = __FAILURE__;
     }
     else
     {
-        CONNECTION_HANDLE connection = (CONNECTION_HANDLE)endpoint->connection;
-        size_t i;
-
-        for (i = 0; i < connection->endpoint_count; i++)
-        {
-            if (connection->endpoints[i] == endpoint)
-            {
-                break;
-            }
-        }
-
-        /* Codes_SRS_CONNECTION_01_130: [The outgoing channel associated with the endpoint shall be released by removing the endpoint from the endpoint list.] */
-        /* Codes_SRS_CONNECTION_01_131: [Any incoming channel number associated with the endpoint shall be released.] */
-        if ((i < connection->endpoint_count) && (i > 0))
-        {
-            ENDPOINT_HANDLE* new_endpoints;
-            (void)memmove(connection->endpoints + i, connection->endpoints + i + 1, sizeof(ENDPOINT_HANDLE) * (connection->endpoint_count - i - 1));
+        /* Codes_SRS_CONNECTION_01_449: [connection_endpoint_get_outgoing_channel shall return in outgoing_channel the outgoing channel of the endpoint and return 0.] */
+        *outgoing_channel = endpoint->outgoing_channel;
+        result = 0;
+    }
 
-            new_endpoints = (ENDPOINT_HANDLE*)realloc(connection->endpoints, (connection->endpoint_count - 1) * sizeof(ENDPOINT_HANDLE));
-            if (new_endpoints != NULL)
-            {
-                connection->endpoints = new_endpoints;
-            }
+    return result;
+}
 
-            connection->endpoint_count--;
-        }
-        else if (connection->endpoint_count == 1)
-        {
-            free(connection->endpoints);
-            connection->endpoints = NULL;
-            connection->endpoint_count = 0;
-        }
+int connection_endpoint_set_on_send_queue_drained(ENDPOINT_HANDLE endpoint, ON_SEND_QUEUE_DRAINED on_send_queue_drained, void* context)
+{
+    int result;
 
-        free(endpoint);
+    /* Codes_SRS_CONNECTION_01_346: [If endpoint is NULL, connection_endpoint_set_on_send_queue_drained shall fail and return a non-zero value.] */
+    if (endpoint == NULL)
+    {
+        LogError("NULL endpoint");
+        result = __FAILURE__;
     }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_347: [connection_endpoint_set_on_send_queue_drained shall set the callback called with context when the send queue of the connection stops being full, a NULL callback removing it, and return 0.] */
+        endpoint->on_send_queue_drained = on_send_queue_drained;
+        endpoint->on_send_queue_drained_context = context;
+        result = 0;
+    }
+
+    return result;
 }
 
-/* Codes_SRS_CONNECTION_01_247: [connection_encode_frame shall send a frame for a certain endpoint.] */
-int connection_encode_frame(ENDPOINT_HANDLE endpoint, AMQP_VALUE performative, PAYLOAD* payloads, size_t payload_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+/* Codes_SRS_CONNECTION_01_129: [connection_destroy_endpoint shall free all resources associated with an endpoint created by connection_create_endpoint.] */
+int connection_endpoint_set_on_dowork(ENDPOINT_HANDLE endpoint, ON_ENDPOINT_DOWORK on_dowork, void* context)
 {
     int result;
 
-    /* Codes_SRS_CONNECTION_01_249: [If endpoint or performative are NULL, connection_encode_frame shall fail and return a non-zero value.] */
-    if ((endpoint == NULL) ||
-        (performative == NULL))
+    /* Codes_SRS_CONNECTION_01_402: [If endpoint is NULL, connection_endpoint_set_on_dowork shall fail and return a non-zero value.] */
+    if (endpoint == NULL)
     {
-        LogError("Bad arguments: endpoint = %p, performative = %p",
-            endpoint, performative);
+        LogError("NULL endpoint");
         result = __FAILURE__;
     }
     else
     {
-        CONNECTION_HANDLE connection = (CONNECTION_HANDLE)endpoint->connection;
-        AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = connection->amqp_frame_codec;
-
-        /* Codes_SRS_CONNECTION_01_254: [If connection_encode_frame is called before the connection is in the OPENED state, connection_encode_frame shall fail and return a non-zero value.] */
-        if (connection->connection_state != CONNECTION_STATE_OPENED)
+        /* Codes_SRS_CONNECTION_01_403: [connection_endpoint_set_on_dowork shall set the callback called with context once per connection_dowork, a NULL callback removing it, and return 0.] */
+        if ((endpoint->on_dowork == NULL) && (on_dowork != NULL))
         {
-            LogError("Connection not open");
-            result = __FAILURE__;
+            endpoint->connection->dowork_endpoint_count++;
         }
-        else
+        else if ((endpoint->on_dowork != NULL) && (on_dowork == NULL))
         {
-            /* Codes_SRS_CONNECTION_01_255: [The payload size shall be computed based on all the payload chunks passed as argument in payloads.] */
+            endpoint->connection->dowork_endpoint_count--;
+        }
+
+        endpoint->on_dowork = on_dowork;
+        endpoint->on_dowork_context = context;
+        result = 0;
+    }
+
+    return result;
+}
+
+void connection_destroy_endpoint(ENDPOINT_HANDLE endpoint)
+{
+    if (endpoint == NULL)
+    {
+        LogError("NULL endpoint");
+    }
+    else
+    {
+        CONNECTION_HANDLE connection = (CONNECTION_HANDLE)endpoint->connection;
+        uint32_t i = get_endpoint_index_by_outgoing_channel(connection, endpoint->outgoing_channel);
+
+        /* Codes_SRS_CONNECTION_01_131: [Any incoming channel number associated with the endpoint shall be released.] */
+        clear_endpoint_incoming_channel(connection, endpoint);
+
+        if (endpoint->on_dowork != NULL)
+        {
+            connection->dowork_endpoint_count--;
+        }
+
+        /* Codes_SRS_CONNECTION_01_130: [The outgoing channel associated with the endpoint shall be released by removing the endpoint from the endpoint list.] */
+        if ((i < connection->endpoint_count) &&
+            (connection->endpoints[i] == endpoint))
+        {
+            if (connection->endpoint_count == 1)
+            {
+                connection_free(connection, connection->endpoints);
+                connection->endpoints = NULL;
+                connection->endpoint_count = 0;
+                connection->endpoint_capacity = 0;
+            }
+            else
+            {
+                (void)memmove(connection->endpoints + i, connection->endpoints + i + 1, sizeof(ENDPOINT_HANDLE) * (connection->endpoint_count - i - 1));
+                connection->endpoint_count--;
+            }
+        }
+
+        connection_free(connection, endpoint);
+    }
+}
+
+/* Codes_SRS_CONNECTION_01_247: [connection_encode_frame shall send a frame for a certain endpoint.] */
+int connection_encode_frame(ENDPOINT_HANDLE endpoint, AMQP_VALUE performative, PAYLOAD* payloads, size_t payload_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_249: [If endpoint or performative are NULL, connection_encode_frame shall fail and return a non-zero value.] */
+    if ((endpoint == NULL) ||
+        (performative == NULL))
+    {
+        LogError("Bad arguments: endpoint = %p, performative = %p",
+            endpoint, performative);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CONNECTION_HANDLE connection = (CONNECTION_HANDLE)endpoint->connection;
+        AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = connection->amqp_frame_codec;
+
+        /* Codes_SRS_CONNECTION_01_254: [If connection_encode_frame is called before the connection is in the OPENED state, connection_encode_frame shall fail and return a non-zero value.] */
+        /* Codes_SRS_CONNECTION_01_321: [When the open is pipelined, connection_encode_frame and connection_encode_frame_with_encoded_performative shall also encode frames in the OPEN_PIPE and OPEN_SENT states.] */
+        if ((connection->connection_state != CONNECTION_STATE_OPENED) &&
+            (!is_pipelining_open(connection)))
+        {
+            LogError("Connection not open");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CONNECTION_01_255: [The payload size shall be computed based on all the payload chunks passed as argument in payloads.] */
             /* Codes_SRS_CONNECTION_01_250: [connection_encode_frame shall initiate the frame send by calling amqp_frame_codec_begin_encode_frame.] */
             /* Codes_SRS_CONNECTION_01_251: [The channel number passed to amqp_frame_codec_begin_encode_frame shall be the outgoing channel number associated with the endpoint by connection_create_endpoint.] */
             /* Codes_SRS_CONNECTION_01_252: [The performative passed to amqp_frame_codec_begin_encode_frame shall be the performative argument of connection_encode_frame.] */
             connection->on_send_complete = on_send_complete;
             connection->on_send_complete_callback_context = callback_context;
-            if (amqp_frame_codec_encode_frame(amqp_frame_codec, endpoint->outgoing_channel, performative, payloads, payload_count, on_bytes_encoded, connection) != 0)
+            connection->is_encoding_batched_frame = ((connection->outgoing_batch_size > 0) || is_pipelining_open(connection) || (connection->outgoing_batch_hold_count > 0)) ? 1 : 0;
+            result = amqp_frame_codec_encode_frame(amqp_frame_codec, endpoint->outgoing_channel, performative, payloads, payload_count, on_bytes_encoded, connection);
+            connection->is_encoding_batched_frame = 0;
+            if (result != 0)
             {
                 /* Codes_SRS_CONNECTION_01_253: [If amqp_frame_codec_begin_encode_frame or amqp_frame_codec_encode_payload_bytes fails, then connection_encode_frame shall fail and return a non-zero value.] */
                 LogError("Encoding AMQP frame failed");
@@ -2005,16 +3385,71 @@ int connection_encode_frame(ENDPOINT_HANDLE endpoint, AMQP_VALUE performative, P
                     log_outgoing_frame(performative);
                 }
 
-                if (tickcounter_get_current_ms(connection->tick_counter, &connection->last_frame_sent_time) != 0)
-                {
-                    LogError("Getting tick counter value failed");
-                    result = __FAILURE__;
-                }
-                else
+                /* Codes_SRS_CONNECTION_01_375: [The time of the last frame received and sent shall be taken from the coarse clock refreshed by connection_handle_deadlines instead of reading the tick counter for every frame.] */
+                connection->last_frame_sent_time = connection->coarse_current_ms;
+
+                /* Codes_SRS_CONNECTION_01_248: [On success it shall return 0.] */
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Codes_SRS_CONNECTION_01_298: [connection_encode_frame_with_encoded_performative shall send a frame for a certain endpoint, using performative_bytes as the already encoded performative.] */
+int connection_encode_frame_with_encoded_performative(ENDPOINT_HANDLE endpoint, const unsigned char* performative_bytes, size_t performative_size, PAYLOAD* payloads, size_t payload_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_299: [If endpoint or performative_bytes are NULL or performative_size is 0, connection_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+    if ((endpoint == NULL) ||
+        (performative_bytes == NULL) ||
+        (performative_size == 0))
+    {
+        LogError("Bad arguments: endpoint = %p, performative_bytes = %p, performative_size = %u",
+            endpoint, performative_bytes, (unsigned int)performative_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CONNECTION_HANDLE connection = (CONNECTION_HANDLE)endpoint->connection;
+        AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = connection->amqp_frame_codec;
+
+        /* Codes_SRS_CONNECTION_01_300: [If connection_encode_frame_with_encoded_performative is called before the connection is in the OPENED state, connection_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+        /* Codes_SRS_CONNECTION_01_321: [When the open is pipelined, connection_encode_frame and connection_encode_frame_with_encoded_performative shall also encode frames in the OPEN_PIPE and OPEN_SENT states.] */
+        if ((connection->connection_state != CONNECTION_STATE_OPENED) &&
+            (!is_pipelining_open(connection)))
+        {
+            LogError("Connection not open");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CONNECTION_01_301: [The frame shall be encoded by calling amqp_frame_codec_encode_frame_with_encoded_performative with the outgoing channel number of the endpoint, the performative bytes and the payloads.] */
+            connection->on_send_complete = on_send_complete;
+            connection->on_send_complete_callback_context = callback_context;
+            connection->is_encoding_batched_frame = ((connection->outgoing_batch_size > 0) || is_pipelining_open(connection) || (connection->outgoing_batch_hold_count > 0)) ? 1 : 0;
+            result = amqp_frame_codec_encode_frame_with_encoded_performative(amqp_frame_codec, endpoint->outgoing_channel, performative_bytes, performative_size, payloads, payload_count, on_bytes_encoded, connection);
+            connection->is_encoding_batched_frame = 0;
+            if (result != 0)
+            {
+                /* Codes_SRS_CONNECTION_01_302: [If amqp_frame_codec_encode_frame_with_encoded_performative fails, then connection_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+                LogError("Encoding AMQP frame failed");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (connection->is_trace_on == 1)
                 {
-                    /* Codes_SRS_CONNECTION_01_248: [On success it shall return 0.] */
-                    result = 0;
+                    log_outgoing_encoded_frame(performative_bytes, performative_size);
                 }
+
+                /* Codes_SRS_CONNECTION_01_375: [The time of the last frame received and sent shall be taken from the coarse clock refreshed by connection_handle_deadlines instead of reading the tick counter for every frame.] */
+                connection->last_frame_sent_time = connection->coarse_current_ms;
+
+                /* Codes_SRS_CONNECTION_01_303: [On success it shall return 0.] */
+                result = 0;
             }
         }
     }
@@ -2056,3 +3491,1148 @@ int connection_set_remote_idle_timeout_empty_frame_send_ratio(CONNECTION_HANDLE
 
     return result;
 }
+
+int connection_set_outgoing_batch_size(CONNECTION_HANDLE connection, uint32_t outgoing_batch_size)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_286: [If connection is NULL, connection_set_outgoing_batch_size shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_287: [Before changing the outgoing batch size, connection_set_outgoing_batch_size shall flush the outgoing batch.] */
+    else if (flush_outgoing_batch(connection) != 0)
+    {
+        /* Codes_SRS_CONNECTION_01_288: [If flushing the outgoing batch fails, connection_set_outgoing_batch_size shall fail and return a non-zero value.] */
+        LogError("Cannot flush the outgoing batch");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_275: [connection_set_outgoing_batch_size shall set the number of bytes of encoded frames that are accumulated before they are passed to the io in one xio_send call.] */
+        /* Codes_SRS_CONNECTION_01_289: [Setting outgoing_batch_size to 0 shall disable batching.] */
+        connection->outgoing_batch_size = outgoing_batch_size;
+
+        /* Codes_SRS_CONNECTION_01_290: [On success, connection_set_outgoing_batch_size shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_get_outgoing_batch_size(CONNECTION_HANDLE connection, uint32_t* outgoing_batch_size)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_291: [If connection or outgoing_batch_size are NULL, connection_get_outgoing_batch_size shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (outgoing_batch_size == NULL))
+    {
+        LogError("Bad arguments: connection = %p, outgoing_batch_size = %p",
+            connection, outgoing_batch_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_292: [connection_get_outgoing_batch_size shall return in the outgoing_batch_size argument the current outgoing batch size setting.] */
+        *outgoing_batch_size = connection->outgoing_batch_size;
+
+        /* Codes_SRS_CONNECTION_01_293: [On success, connection_get_outgoing_batch_size shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_set_send_queue_limits(CONNECTION_HANDLE connection, size_t high_water_mark, size_t low_water_mark)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_342: [If connection is NULL or low_water_mark is bigger than high_water_mark, connection_set_send_queue_limits shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (low_water_mark > high_water_mark))
+    {
+        LogError("Bad arguments: connection = %p, high_water_mark = %u, low_water_mark = %u",
+            connection, (unsigned int)high_water_mark, (unsigned int)low_water_mark);
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((high_water_mark > 0) &&
+            (connection->send_queue == NULL))
+        {
+            connection->send_queue = REFCOUNT_TYPE_CREATE(SEND_QUEUE);
+            if (connection->send_queue != NULL)
+            {
+                connection->send_queue->queued_bytes = 0;
+                connection->send_queue->allocator = connection->allocator;
+            }
+        }
+
+        if ((high_water_mark > 0) &&
+            (connection->send_queue == NULL))
+        {
+            /* Codes_SRS_CONNECTION_01_343: [If allocating the send queue fails, connection_set_send_queue_limits shall fail and return a non-zero value.] */
+            LogError("Cannot allocate memory for the send queue");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CONNECTION_01_336: [connection_set_send_queue_limits shall set the number of bytes handed to the io and not completed yet above which the send queue is full, and the number of bytes it has to drain down to before it stops being full.] */
+            /* Codes_SRS_CONNECTION_01_340: [Setting high_water_mark to 0 shall disable the send queue limit.] */
+            /* only the sends made while a limit is set are counted, a full send queue is drained on the next connection_dowork */
+            connection->send_queue_high_water_mark = high_water_mark;
+            connection->send_queue_low_water_mark = low_water_mark;
+
+            /* Codes_SRS_CONNECTION_01_344: [On success, connection_set_send_queue_limits shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int connection_set_memory_quota(CONNECTION_HANDLE connection, size_t memory_quota, size_t low_memory_mark)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_382: [If connection is NULL or low_memory_mark is bigger than memory_quota, connection_set_memory_quota shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (low_memory_mark > memory_quota))
+    {
+        LogError("Bad arguments: connection = %p, memory_quota = %u, low_memory_mark = %u",
+            connection, (unsigned int)memory_quota, (unsigned int)low_memory_mark);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_383: [If connection_set_memory_quota is called after the connection was opened, it shall fail and return a non-zero value.] */
+    else if (connection->connection_state != CONNECTION_STATE_START)
+    {
+        LogError("Connection already open");
+        result = __FAILURE__;
+    }
+#ifndef UAMQP_STATIC_POOLS
+    /* with static pools the frames are received in the static buffer of the frame codec, which is not charged */
+    else if ((memory_quota > 0) &&
+        (connection->receive_buffer_pool == NULL) &&
+        (frame_codec_set_receive_buffer_pool(connection->frame_codec, get_quota_receive_buffer, grow_quota_receive_buffer, release_quota_receive_buffer, connection) != 0))
+    {
+        /* Codes_SRS_CONNECTION_01_384: [If setting the receive buffer pool of the frame codec fails, connection_set_memory_quota shall fail and return a non-zero value.] */
+        LogError("Cannot set the receive buffer pool of the frame codec");
+        result = __FAILURE__;
+    }
+#endif
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_381: [connection_set_memory_quota shall limit to memory_quota bytes, 0 meaning no limit, the memory charged by the connection for the frames it receives and by its links for their buffers, and return 0.] */
+        connection->memory_quota = memory_quota;
+        connection->low_memory_mark = low_memory_mark;
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_set_receive_buffer_pool(CONNECTION_HANDLE connection, BUFFER_POOL_HANDLE buffer_pool)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_428: [If connection or buffer_pool is NULL, connection_set_receive_buffer_pool shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (buffer_pool == NULL))
+    {
+        LogError("Bad arguments: connection = %p, buffer_pool = %p", connection, buffer_pool);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_429: [If connection_set_receive_buffer_pool is called after the connection was opened, it shall fail and return a non-zero value.] */
+    else if (connection->connection_state != CONNECTION_STATE_START)
+    {
+        LogError("Connection already open");
+        result = __FAILURE__;
+    }
+#ifdef UAMQP_STATIC_POOLS
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_433: [When built with UAMQP_STATIC_POOLS, connection_set_receive_buffer_pool shall fail and return a non-zero value.] */
+        LogError("The frames are received in the static buffer of the frame codec");
+        result = __FAILURE__;
+    }
+#else
+    else if (frame_codec_set_receive_buffer_pool(connection->frame_codec, get_pool_receive_buffer, grow_pool_receive_buffer, release_pool_receive_buffer, connection) != 0)
+    {
+        /* Codes_SRS_CONNECTION_01_432: [If setting the receive buffer pool of the frame codec fails, connection_set_receive_buffer_pool shall fail and return a non-zero value.] */
+        LogError("Cannot set the receive buffer pool of the frame codec");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_427: [connection_set_receive_buffer_pool shall set the receive buffer pool of the frame codec so that the frames are received in buffers obtained with buffer_pool_get and given back with buffer_pool_release, and return 0.] */
+        connection->receive_buffer_pool = buffer_pool;
+        result = 0;
+    }
+#endif
+
+    return result;
+}
+
+int connection_charge_memory(CONNECTION_HANDLE connection, size_t size)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_387: [If connection is NULL, connection_charge_memory shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else if ((connection->memory_quota > 0) &&
+        ((connection->is_memory_quota_exceeded) ||
+         (size > connection->memory_quota - connection->memory_in_use)))
+    {
+        /* Codes_SRS_CONNECTION_01_389: [If the charge does not fit in the memory quota, connection_charge_memory shall fail, return a non-zero value and, the first time, close the connection with the error amqp:resource-limit-exceeded.] */
+        LogError("Memory quota of %u bytes exceeded", (unsigned int)connection->memory_quota);
+        if (!connection->is_memory_quota_exceeded)
+        {
+            connection->is_memory_quota_exceeded = 1;
+            close_connection_with_error(connection, "amqp:resource-limit-exceeded", "Connection memory quota exceeded");
+        }
+
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_388: [connection_charge_memory shall add size to the memory in use of the connection and return 0.] */
+        connection->memory_in_use += size;
+        result = 0;
+    }
+
+    return result;
+}
+
+void connection_release_memory(CONNECTION_HANDLE connection, size_t size)
+{
+    if (connection == NULL)
+    {
+        /* Codes_SRS_CONNECTION_01_391: [If connection is NULL, connection_release_memory shall do nothing.] */
+        LogError("NULL connection");
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_390: [connection_release_memory shall subtract size from the memory in use of the connection.] */
+        connection->memory_in_use = (size > connection->memory_in_use) ? 0 : connection->memory_in_use - size;
+    }
+}
+
+bool connection_is_memory_low(CONNECTION_HANDLE connection)
+{
+    bool result;
+
+    /* Codes_SRS_CONNECTION_01_392: [connection_is_memory_low shall return true when the connection has a memory quota and less than low_memory_mark bytes of it are left, and false otherwise, or when connection is NULL.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = false;
+    }
+    else
+    {
+        result = (connection->memory_quota > 0) &&
+            (connection->memory_quota - connection->memory_in_use < connection->low_memory_mark);
+    }
+
+    return result;
+}
+
+static void update_receive_paused(CONNECTION_HANDLE connection)
+{
+    if (connection->is_receive_paused)
+    {
+        if ((connection->receive_pause_backlog == 0) ||
+            (connection->receive_backlog <= connection->receive_resume_backlog))
+        {
+            connection->is_receive_paused = 0;
+        }
+    }
+    else if ((connection->receive_pause_backlog != 0) &&
+        (connection->receive_backlog > connection->receive_pause_backlog))
+    {
+        connection->is_receive_paused = 1;
+    }
+}
+
+int connection_set_receive_backlog_limits(CONNECTION_HANDLE connection, size_t pause_backlog, size_t resume_backlog)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_394: [If connection is NULL or resume_backlog is bigger than pause_backlog, connection_set_receive_backlog_limits shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (resume_backlog > pause_backlog))
+    {
+        LogError("Bad arguments: connection = %p, pause_backlog = %u, resume_backlog = %u",
+            connection, (unsigned int)pause_backlog, (unsigned int)resume_backlog);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_393: [connection_set_receive_backlog_limits shall set the receive backlog above which the reads from the io are paused, 0 meaning never, and the backlog it has to drain down to before they are resumed, and return 0.] */
+        connection->receive_pause_backlog = pause_backlog;
+        connection->receive_resume_backlog = resume_backlog;
+        update_receive_paused(connection);
+        result = 0;
+    }
+
+    return result;
+}
+
+void connection_add_receive_backlog(CONNECTION_HANDLE connection, size_t size)
+{
+    if (connection == NULL)
+    {
+        /* Codes_SRS_CONNECTION_01_398: [If connection is NULL, connection_add_receive_backlog and connection_remove_receive_backlog shall do nothing.] */
+        LogError("NULL connection");
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_396: [connection_add_receive_backlog shall add size to the receive backlog and pause the reads from the io once it is over the pause backlog.] */
+        connection->receive_backlog += size;
+        update_receive_paused(connection);
+    }
+}
+
+void connection_remove_receive_backlog(CONNECTION_HANDLE connection, size_t size)
+{
+    if (connection == NULL)
+    {
+        /* Codes_SRS_CONNECTION_01_398: [If connection is NULL, connection_add_receive_backlog and connection_remove_receive_backlog shall do nothing.] */
+        LogError("NULL connection");
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_397: [connection_remove_receive_backlog shall subtract size from the receive backlog and resume the paused reads once it is down to the resume backlog.] */
+        connection->receive_backlog = (size > connection->receive_backlog) ? 0 : connection->receive_backlog - size;
+        update_receive_paused(connection);
+    }
+}
+
+bool connection_is_receive_paused(CONNECTION_HANDLE connection)
+{
+    bool result;
+
+    /* Codes_SRS_CONNECTION_01_401: [connection_is_receive_paused shall return true while the reads from the io are paused and false otherwise, or when connection is NULL.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = false;
+    }
+    else
+    {
+        result = (connection->is_receive_paused != 0);
+    }
+
+    return result;
+}
+
+int connection_get_io_interest(CONNECTION_HANDLE connection, CONNECTION_IO_INTEREST* io_interest)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_405: [If connection or io_interest is NULL, connection_get_io_interest shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (io_interest == NULL))
+    {
+        LogError("Bad arguments: connection = %p, io_interest = %p",
+            connection, io_interest);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint64_t time_to_deadline;
+
+        if (connection->connection_state == CONNECTION_STATE_END)
+        {
+            /* Codes_SRS_CONNECTION_01_406: [Once the connection is in the END state, connection_get_io_interest shall indicate no interest in reading or writing and no timeout.] */
+            time_to_deadline = (uint64_t)-1;
+            io_interest->want_read = false;
+            io_interest->want_write = false;
+        }
+        else
+        {
+            /* Codes_SRS_CONNECTION_01_409: [connection_get_io_interest shall set timeout_ms to the milliseconds until the next idle timeout or outgoing batch deadline, 0 when an outgoing batch is due to be flushed and (uint64_t)-1 when there is no deadline.] */
+            time_to_deadline = connection_handle_deadlines(connection);
+            if ((connection->outgoing_batch_length > 0) &&
+                (connection->outgoing_batch_hold_count == 0) &&
+                is_outgoing_batch_due(connection))
+            {
+                time_to_deadline = 0;
+            }
+
+            /* Codes_SRS_CONNECTION_01_407: [connection_get_io_interest shall indicate an interest in reading unless the reads from the io are paused.] */
+            io_interest->want_read = (connection->is_receive_paused == 0);
+
+            /* Codes_SRS_CONNECTION_01_408: [connection_get_io_interest shall indicate an interest in writing while the io is being opened, when send queue limits are set and the send queue holds bytes, and otherwise when bytes were handed to the io since the previous call.] */
+            /* without a send queue the connection does not see what the io still buffers, a new write is the best hint */
+            io_interest->want_write = (connection->is_underlying_io_open == 0) ||
+                ((connection->send_queue_high_water_mark != 0) ? (connection->send_queue->queued_bytes > 0) : (connection->stats.bytes_sent != connection->io_interest_bytes_sent));
+
+            if (connection->connection_state == CONNECTION_STATE_END)
+            {
+                /* the idle timeout just closed it */
+                time_to_deadline = (uint64_t)-1;
+            }
+        }
+
+        connection->io_interest_bytes_sent = connection->stats.bytes_sent;
+        io_interest->timeout_ms = time_to_deadline;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+bool connection_is_send_queue_full(CONNECTION_HANDLE connection)
+{
+    bool result;
+
+    /* Codes_SRS_CONNECTION_01_345: [connection_is_send_queue_full shall return true when the send queue of the connection is full and false otherwise, or when connection is NULL.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = false;
+    }
+    else
+    {
+        result = connection->is_send_queue_full;
+    }
+
+    return result;
+}
+
+int connection_set_outgoing_batch_delay(CONNECTION_HANDLE connection, milliseconds outgoing_batch_delay)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_351: [If connection is NULL, connection_set_outgoing_batch_delay shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_348: [connection_set_outgoing_batch_delay shall set the number of milliseconds for which connection_dowork holds the bytes in the outgoing batch before flushing them.] */
+        /* Codes_SRS_CONNECTION_01_349: [Setting outgoing_batch_delay to 0 shall make connection_dowork flush the outgoing batch every time it is called.] */
+        /* bytes already in the batch are held from the time they were batched, the new delay applies to them too */
+        connection->outgoing_batch_delay = outgoing_batch_delay;
+
+        /* Codes_SRS_CONNECTION_01_352: [On success, connection_set_outgoing_batch_delay shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_get_outgoing_batch_delay(CONNECTION_HANDLE connection, milliseconds* outgoing_batch_delay)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_353: [If connection or outgoing_batch_delay are NULL, connection_get_outgoing_batch_delay shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (outgoing_batch_delay == NULL))
+    {
+        LogError("Bad arguments: connection = %p, outgoing_batch_delay = %p",
+            connection, outgoing_batch_delay);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_354: [connection_get_outgoing_batch_delay shall return in the outgoing_batch_delay argument the current outgoing batch delay setting.] */
+        *outgoing_batch_delay = connection->outgoing_batch_delay;
+
+        /* Codes_SRS_CONNECTION_01_355: [On success, connection_get_outgoing_batch_delay shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_flush(CONNECTION_HANDLE connection)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_294: [If connection is NULL, connection_flush shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_295: [connection_flush shall pass the bytes in the outgoing batch to the io by calling xio_send.] */
+    else if (flush_outgoing_batch(connection) != 0)
+    {
+        /* Codes_SRS_CONNECTION_01_296: [If flushing the outgoing batch fails, connection_flush shall close the connection, set the state to END and return a non-zero value.] */
+        LogError("Cannot flush the outgoing batch");
+
+        if (xio_close(connection->io, NULL, NULL) != 0)
+        {
+            LogError("xio_close failed");
+        }
+
+        connection_set_state(connection, CONNECTION_STATE_END);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_297: [On success, connection_flush shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_hold_outgoing_batch(CONNECTION_HANDLE connection)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_366: [If connection is NULL, connection_hold_outgoing_batch shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_367: [connection_hold_outgoing_batch shall hold the outgoing batch until a matching call to connection_release_outgoing_batch, holds can be nested.] */
+        connection->outgoing_batch_hold_count++;
+
+        /* Codes_SRS_CONNECTION_01_369: [On success, connection_hold_outgoing_batch shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_release_outgoing_batch(CONNECTION_HANDLE connection)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_370: [If connection is NULL, connection_release_outgoing_batch shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_371: [If the outgoing batch is not held, connection_release_outgoing_batch shall fail and return a non-zero value.] */
+    else if (connection->outgoing_batch_hold_count == 0)
+    {
+        LogError("The outgoing batch is not held");
+        result = __FAILURE__;
+    }
+    else
+    {
+        connection->outgoing_batch_hold_count--;
+
+        /* Codes_SRS_CONNECTION_01_372: [When the last hold is released, connection_release_outgoing_batch shall pass the bytes in the outgoing batch to the io in one call to xio_send.] */
+        if ((connection->outgoing_batch_hold_count == 0) &&
+            (flush_outgoing_batch(connection) != 0))
+        {
+            /* Codes_SRS_CONNECTION_01_373: [If flushing the outgoing batch fails, connection_release_outgoing_batch shall close the connection, set the state to END and return a non-zero value.] */
+            LogError("Cannot flush the outgoing batch");
+
+            if (xio_close(connection->io, NULL, NULL) != 0)
+            {
+                LogError("xio_close failed");
+            }
+
+            connection_set_state(connection, CONNECTION_STATE_END);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CONNECTION_01_374: [On success, connection_release_outgoing_batch shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int connection_set_pipelined_open(CONNECTION_HANDLE connection, bool pipelined_open)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_313: [If connection is NULL, connection_set_pipelined_open shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_314: [If connection_set_pipelined_open is called after the connection was opened, it shall fail and return a non-zero value.] */
+    else if (connection->is_underlying_io_open)
+    {
+        LogError("Connection already open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_315: [connection_set_pipelined_open shall set whether the open frame and the frames of the endpoints are sent without waiting for the peer's protocol header and open frame.] */
+        connection->is_pipelined_open = pipelined_open ? 1 : 0;
+
+        /* Codes_SRS_CONNECTION_01_316: [On success, connection_set_pipelined_open shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_get_pipelined_open(CONNECTION_HANDLE connection, bool* pipelined_open)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_317: [If connection or pipelined_open are NULL, connection_get_pipelined_open shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (pipelined_open == NULL))
+    {
+        LogError("Bad arguments: connection = %p, pipelined_open = %p",
+            connection, pipelined_open);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_318: [connection_get_pipelined_open shall return in the pipelined_open argument the current pipelined open setting.] */
+        *pipelined_open = connection->is_pipelined_open ? true : false;
+
+        /* Codes_SRS_CONNECTION_01_319: [On success, connection_get_pipelined_open shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_get_stats(CONNECTION_HANDLE connection, CONNECTION_STATS* stats)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_304: [If connection or stats are NULL, connection_get_stats shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (stats == NULL))
+    {
+        LogError("Bad arguments: connection = %p, stats = %p",
+            connection, stats);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_305: [connection_get_stats shall copy the counters kept since the connection was created to stats and return 0.] */
+        *stats = connection->stats;
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_get_allocator(CONNECTION_HANDLE connection, CONNECTION_ALLOCATOR* allocator)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_362: [If connection or allocator are NULL, connection_get_allocator shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (allocator == NULL))
+    {
+        LogError("Bad arguments: connection = %p, allocator = %p",
+            connection, allocator);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_363: [connection_get_allocator shall copy the allocator used by the connection to allocator and return 0, so that the owners of the connection can allocate their memory with it too.] */
+        *allocator = connection->allocator;
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_set_session_admission_limiter(CONNECTION_HANDLE connection, ADMISSION_LIMITER_HANDLE session_admission_limiter)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_378: [If connection is NULL, connection_set_session_admission_limiter shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_377: [connection_set_session_admission_limiter shall make the connection check the remote begins it receives against session_admission_limiter, a NULL session_admission_limiter admitting all of them, and return 0.] */
+        connection->session_admission_limiter = session_admission_limiter;
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_set_frame_trace(CONNECTION_HANDLE connection, FRAME_TRACE_HANDLE frame_trace)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_310: [If connection is NULL, connection_set_frame_trace shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_309: [connection_set_frame_trace shall make the connection record its frames in frame_trace, a NULL frame_trace stopping the recording, and return 0.] */
+        /* Codes_SRS_CONNECTION_01_454: [The performatives shall be recorded with the bytes the amqp_frame_codec decoded or encoded, obtained by calling amqp_frame_codec_set_on_performative_bytes.] */
+        if (amqp_frame_codec_set_on_performative_bytes(connection->amqp_frame_codec, (frame_trace == NULL) ? NULL : on_amqp_performative_bytes, connection) != 0)
+        {
+            /* Codes_SRS_CONNECTION_01_455: [If amqp_frame_codec_set_on_performative_bytes fails, connection_set_frame_trace shall fail and return a non-zero value.] */
+            LogError("Cannot get the performative bytes from the amqp_frame_codec");
+            result = __FAILURE__;
+        }
+        else
+        {
+            connection->frame_trace = frame_trace;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int connection_set_decoder_limits(CONNECTION_HANDLE connection, uint32_t max_depth, size_t max_element_count, size_t max_allocated_bytes)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_451: [If connection is NULL, connection_set_decoder_limits shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_450: [connection_set_decoder_limits shall apply max_depth, max_element_count and max_allocated_bytes to the decoding of the received performatives by calling amqp_frame_codec_set_decoder_limits and return 0.] */
+    else if (amqp_frame_codec_set_decoder_limits(connection->amqp_frame_codec, max_depth, max_element_count, max_allocated_bytes) != 0)
+    {
+        /* Codes_SRS_CONNECTION_01_452: [If amqp_frame_codec_set_decoder_limits fails, connection_set_decoder_limits shall fail and return a non-zero value.] */
+        LogError("Cannot set the decoder limits on the amqp_frame_codec");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_set_flow_observer(CONNECTION_HANDLE connection, ON_CONNECTION_FLOW_EVENT on_flow_event, void* context)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_413: [If connection is NULL, connection_set_flow_observer shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_412: [connection_set_flow_observer shall make the connection pass the flow events reported to it to on_flow_event with context, a NULL on_flow_event removing the observer, and return 0.] */
+        connection->on_flow_event = on_flow_event;
+        connection->on_flow_event_context = context;
+        result = 0;
+    }
+
+    return result;
+}
+
+void connection_report_flow_event(CONNECTION_HANDLE connection, CONNECTION_FLOW_EVENT event, const void* source, const char* link_name, uint64_t value)
+{
+    /* Codes_SRS_CONNECTION_01_415: [If connection is NULL or has no flow observer, connection_report_flow_event shall do nothing.] */
+    if ((connection != NULL) &&
+        (connection->on_flow_event != NULL))
+    {
+        CONNECTION_FLOW_EVENT_INFO event_info;
+        tickcounter_ms_t current_ms;
+
+        if (tickcounter_get_current_ms(connection->tick_counter, &current_ms) != 0)
+        {
+            LogError("Cannot get tickcounter value for the flow event");
+            current_ms = 0;
+        }
+
+        /* Codes_SRS_CONNECTION_01_414: [connection_report_flow_event shall call the flow observer with event, source, link_name, value and the current time of the tick counter of the connection as timestamp_ms (0 if it cannot be read).] */
+        event_info.event = event;
+        event_info.timestamp_ms = (uint64_t)current_ms;
+        event_info.source = source;
+        event_info.link_name = link_name;
+        event_info.value = value;
+        connection->on_flow_event(connection->on_flow_event_context, &event_info);
+    }
+}
+
+int connection_set_callback_budget(CONNECTION_HANDLE connection, milliseconds budget_ms)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_419: [If connection is NULL, connection_set_callback_budget shall fail and return a non-zero value.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_418: [connection_set_callback_budget shall make the connection time the application callbacks against budget_ms, 0 turning the timing off, clear the callback stats and return 0.] */
+        connection->callback_budget = budget_ms;
+        (void)memset(&connection->callback_stats, 0, sizeof(connection->callback_stats));
+        result = 0;
+    }
+
+    return result;
+}
+
+bool connection_begin_callback(CONNECTION_HANDLE connection, uint64_t* start_ms)
+{
+    bool result;
+
+    /* Codes_SRS_CONNECTION_01_420: [If connection or start_ms is NULL or the connection has no callback budget, connection_begin_callback shall return false without reading the tick counter.] */
+    if ((connection == NULL) ||
+        (start_ms == NULL) ||
+        (connection->callback_budget == 0))
+    {
+        result = false;
+    }
+    else
+    {
+        tickcounter_ms_t current_ms;
+
+        /* Codes_SRS_CONNECTION_01_421: [Otherwise connection_begin_callback shall set start_ms to the current time of the tick counter of the connection and return true, or return false if the tick counter cannot be read.] */
+        if (tickcounter_get_current_ms(connection->tick_counter, &current_ms) != 0)
+        {
+            LogError("Cannot get tickcounter value for the callback start");
+            result = false;
+        }
+        else
+        {
+            *start_ms = (uint64_t)current_ms;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static void keep_slow_callback(CONNECTION_CALLBACK_STATS* callback_stats, CONNECTION_CALLBACK_TYPE callback_type, const char* link_name, uint64_t duration_ms, uint64_t timestamp_ms)
+{
+    /* the list is kept slowest first, a full list only takes a callback slower than its last one */
+    if ((callback_stats->worst_callback_count < CONNECTION_SLOW_CALLBACK_MAX) ||
+        (callback_stats->worst_callbacks[CONNECTION_SLOW_CALLBACK_MAX - 1].duration_ms < duration_ms))
+    {
+        size_t index;
+
+        if (callback_stats->worst_callback_count < CONNECTION_SLOW_CALLBACK_MAX)
+        {
+            callback_stats->worst_callback_count++;
+        }
+
+        index = callback_stats->worst_callback_count - 1;
+        while ((index > 0) &&
+            (callback_stats->worst_callbacks[index - 1].duration_ms < duration_ms))
+        {
+            callback_stats->worst_callbacks[index] = callback_stats->worst_callbacks[index - 1];
+            index--;
+        }
+
+        callback_stats->worst_callbacks[index].callback_type = callback_type;
+        callback_stats->worst_callbacks[index].duration_ms = duration_ms;
+        callback_stats->worst_callbacks[index].timestamp_ms = timestamp_ms;
+        if (link_name == NULL)
+        {
+            callback_stats->worst_callbacks[index].link_name[0] = '\0';
+        }
+        else
+        {
+            (void)strncpy(callback_stats->worst_callbacks[index].link_name, link_name, CONNECTION_SLOW_CALLBACK_LINK_NAME_SIZE - 1);
+            callback_stats->worst_callbacks[index].link_name[CONNECTION_SLOW_CALLBACK_LINK_NAME_SIZE - 1] = '\0';
+        }
+    }
+}
+
+void connection_end_callback(CONNECTION_HANDLE connection, CONNECTION_CALLBACK_TYPE callback_type, const char* link_name, uint64_t start_ms)
+{
+    /* Codes_SRS_CONNECTION_01_424: [If connection is NULL or callback_type is not a callback type, connection_end_callback shall do nothing.] */
+    if (connection == NULL)
+    {
+        LogError("NULL connection");
+    }
+    else if (callback_type >= CONNECTION_CALLBACK_TYPE_COUNT)
+    {
+        LogError("Bad callback type %d", (int)callback_type);
+    }
+    else
+    {
+        tickcounter_ms_t current_ms;
+
+        if (tickcounter_get_current_ms(connection->tick_counter, &current_ms) != 0)
+        {
+            LogError("Cannot get tickcounter value for the callback end");
+        }
+        else
+        {
+            uint64_t duration_ms = ((uint64_t)current_ms > start_ms) ? (uint64_t)current_ms - start_ms : 0;
+
+            /* Codes_SRS_CONNECTION_01_422: [connection_end_callback shall count the callback as timed, with the time elapsed on the tick counter since start_ms as its duration.] */
+            connection->callback_stats.timed_callbacks++;
+
+            /* Codes_SRS_CONNECTION_01_423: [A callback whose duration is over the callback budget shall be counted as slow for callback_type and kept with its type, link_name and duration if it is among the CONNECTION_SLOW_CALLBACK_MAX slowest ones.] */
+            if ((connection->callback_budget != 0) &&
+                (duration_ms > connection->callback_budget))
+            {
+                connection->callback_stats.slow_callbacks[callback_type]++;
+                keep_slow_callback(&connection->callback_stats, callback_type, link_name, duration_ms, (uint64_t)current_ms);
+            }
+        }
+    }
+}
+
+int connection_get_callback_stats(CONNECTION_HANDLE connection, CONNECTION_CALLBACK_STATS* callback_stats)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_425: [If connection or callback_stats are NULL, connection_get_callback_stats shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (callback_stats == NULL))
+    {
+        LogError("Bad arguments: connection = %p, callback_stats = %p",
+            connection, callback_stats);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTION_01_426: [connection_get_callback_stats shall copy the callback stats kept since the callback budget was set to callback_stats and return 0.] */
+        *callback_stats = connection->callback_stats;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int read_handover_uint(AMQP_READER* reader, uint32_t* value)
+{
+    int result;
+    AMQP_READER_ITEM item;
+
+    if ((amqp_reader_next(reader, &item) != 0) ||
+        (item.type != AMQP_TYPE_UINT))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        *value = (uint32_t)item.value.unsigned_value;
+        result = 0;
+    }
+
+    return result;
+}
+
+int connection_save_handover_state(CONNECTION_HANDLE connection, unsigned char* buffer, size_t buffer_size, size_t* length)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_434: [If connection, buffer or length is NULL, connection_save_handover_state shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (buffer == NULL) ||
+        (length == NULL))
+    {
+        LogError("Bad arguments: connection = %p, buffer = %p, length = %p",
+            connection, buffer, length);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_435: [If the connection is not OPENED, connection_save_handover_state shall fail and return a non-zero value.] */
+    else if (connection->connection_state != CONNECTION_STATE_OPENED)
+    {
+        LogError("Only an opened connection can be handed over, state is %d", (int)connection->connection_state);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_436: [If part of a frame has been received, or frames are waiting in the outgoing batch or the send queue, connection_save_handover_state shall fail and return a non-zero value.] */
+    else if ((!frame_codec_is_at_frame_boundary(connection->frame_codec)) ||
+        (connection->outgoing_batch_length != 0) ||
+        (connection->outgoing_batch_hold_count != 0) ||
+        ((connection->send_queue != NULL) && (connection->send_queue->queued_bytes != 0)))
+    {
+        LogError("Cannot hand over a connection with part of a frame received or frames still to be sent");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_WRITER writer;
+
+        /* Codes_SRS_CONNECTION_01_437: [connection_save_handover_state shall encode in buffer, as an AMQP list, the negotiated max frame sizes, channel max and idle timeouts of the connection, set length to the number of bytes encoded and return 0.] */
+        if ((amqp_writer_init(&writer, buffer, buffer_size) != 0) ||
+            (amqp_writer_begin_list(&writer) != 0) ||
+            (amqp_writer_put_uint(&writer, CONNECTION_HANDOVER_STATE_VERSION) != 0) ||
+            (amqp_writer_put_uint(&writer, connection->max_frame_size) != 0) ||
+            (amqp_writer_put_uint(&writer, connection->remote_max_frame_size) != 0) ||
+            (amqp_writer_put_uint(&writer, connection->channel_max) != 0) ||
+            (amqp_writer_put_uint(&writer, connection->idle_timeout_specified ? connection->idle_timeout : 0) != 0) ||
+            (amqp_writer_put_uint(&writer, connection->remote_idle_timeout) != 0) ||
+            (amqp_writer_end(&writer) != 0) ||
+            (amqp_writer_get_length(&writer, length) != 0))
+        {
+            /* Codes_SRS_CONNECTION_01_438: [If the state does not fit in buffer_size bytes, connection_save_handover_state shall fail and return a non-zero value.] */
+            LogError("Cannot encode the connection handover state");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int connection_restore_handover_state(CONNECTION_HANDLE connection, const unsigned char* bytes, size_t length)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_439: [If connection or bytes is NULL, connection_restore_handover_state shall fail and return a non-zero value.] */
+    if ((connection == NULL) ||
+        (bytes == NULL))
+    {
+        LogError("Bad arguments: connection = %p, bytes = %p",
+            connection, bytes);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTION_01_440: [If the connection has already been opened, connection_restore_handover_state shall fail and return a non-zero value.] */
+    else if ((connection->is_underlying_io_open) ||
+        (connection->connection_state != CONNECTION_STATE_START))
+    {
+        LogError("A handover state can only be restored before the connection is opened");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_READER reader;
+        AMQP_READER_ITEM list;
+        uint32_t version;
+        uint32_t max_frame_size;
+        uint32_t remote_max_frame_size;
+        uint32_t channel_max;
+        uint32_t idle_timeout;
+        uint32_t remote_idle_timeout;
+
+        /* Codes_SRS_CONNECTION_01_441: [If bytes is not a connection handover state of this version, connection_restore_handover_state shall fail and return a non-zero value and leave the connection unchanged.] */
+        if ((amqp_reader_init(&reader, bytes, length) != 0) ||
+            (amqp_reader_next(&reader, &list) != 0) ||
+            (list.type != AMQP_TYPE_LIST) ||
+            (list.count != CONNECTION_HANDOVER_STATE_FIELD_COUNT) ||
+            (amqp_reader_enter(&reader, &list) != 0) ||
+            (read_handover_uint(&reader, &version) != 0) ||
+            (version != CONNECTION_HANDOVER_STATE_VERSION) ||
+            (read_handover_uint(&reader, &max_frame_size) != 0) ||
+            (read_handover_uint(&reader, &remote_max_frame_size) != 0) ||
+            (read_handover_uint(&reader, &channel_max) != 0) ||
+            (read_handover_uint(&reader, &idle_timeout) != 0) ||
+            (read_handover_uint(&reader, &remote_idle_timeout) != 0) ||
+            (max_frame_size < 512) ||
+            (remote_max_frame_size < 512) ||
+            (channel_max > UINT16_MAX))
+        {
+            LogError("Bad connection handover state");
+            result = __FAILURE__;
+        }
+        else
+        {
+#ifdef UAMQP_STATIC_POOLS
+            if (remote_max_frame_size > UAMQP_STATIC_MAX_FRAME_SIZE)
+            {
+                remote_max_frame_size = UAMQP_STATIC_MAX_FRAME_SIZE;
+            }
+#endif
+
+            /* Codes_SRS_CONNECTION_01_444: [On success, connection_restore_handover_state shall set the negotiated values of the connection from bytes and return 0, and the next connection_open shall resume the connection instead of negotiating it.] */
+            connection->max_frame_size = max_frame_size;
+            connection->remote_max_frame_size = remote_max_frame_size;
+            connection->channel_max = (uint16_t)channel_max;
+            connection->idle_timeout = idle_timeout;
+            connection->idle_timeout_specified = (idle_timeout != 0) ? 1 : 0;
+            connection->remote_idle_timeout = remote_idle_timeout;
+            connection->remote_idle_timeout_send_frame_millisecond = (milliseconds)(connection->idle_timeout_empty_frame_send_ratio * remote_idle_timeout);
+            connection->is_resuming_handover = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int connection_endpoint_restore_channels(ENDPOINT_HANDLE endpoint, uint16_t outgoing_channel, uint16_t incoming_channel)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTION_01_445: [If endpoint is NULL, connection_endpoint_restore_channels shall fail and return a non-zero value.] */
+    if (endpoint == NULL)
+    {
+        LogError("NULL endpoint");
+        result = __FAILURE__;
+    }
+    else
+    {
+        CONNECTION_HANDLE connection = endpoint->connection;
+        uint32_t index;
+        uint32_t insert_index = 0;
+        bool is_channel_used = false;
+
+        for (index = 0; index < connection->endpoint_count; index++)
+        {
+            if ((connection->endpoints[index] != endpoint) &&
+                (connection->endpoints[index]->outgoing_channel == outgoing_channel))
+            {
+                is_channel_used = true;
+            }
+        }
+
+        /* Codes_SRS_CONNECTION_01_446: [If outgoing_channel is used by another endpoint, is over the channel max, or incoming_channel cannot be mapped, connection_endpoint_restore_channels shall fail and return a non-zero value.] */
+        if ((is_channel_used) ||
+            (outgoing_channel > connection->channel_max) ||
+            (set_endpoint_incoming_channel(connection, endpoint, incoming_channel) != 0))
+        {
+            LogError("Cannot restore outgoing channel %u and incoming channel %u", (unsigned int)outgoing_channel, (unsigned int)incoming_channel);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_CONNECTION_01_447: [connection_endpoint_restore_channels shall move the endpoint to outgoing_channel, keeping the endpoints sorted by outgoing channel, map incoming_channel to it and return 0.] */
+            for (index = 0; connection->endpoints[index] != endpoint; index++)
+            {
+            }
+
+            if (index + 1 < connection->endpoint_count)
+            {
+                (void)memmove(&connection->endpoints[index], &connection->endpoints[index + 1], sizeof(ENDPOINT_INSTANCE*) * (connection->endpoint_count - index - 1));
+            }
+
+            while ((insert_index < connection->endpoint_count - 1) &&
+                (connection->endpoints[insert_index]->outgoing_channel < outgoing_channel))
+            {
+                insert_index++;
+            }
+
+            if (insert_index < connection->endpoint_count - 1)
+            {
+                (void)memmove(&connection->endpoints[insert_index + 1], &connection->endpoints[insert_index], sizeof(ENDPOINT_INSTANCE*) * (connection->endpoint_count - 1 - insert_index));
+            }
+
+            connection->endpoints[insert_index] = endpoint;
+            endpoint->outgoing_channel = outgoing_channel;
+            result = 0;
+        }
+    }
+
+    return result;
+}
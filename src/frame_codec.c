@@ -9,12 +9,22 @@
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_uamqp_c/frame_codec.h"
 #include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/uamqp_tracepoints.h"
+#include "azure_uamqp_c/uamqp_static_pools.h"
+
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_FRAME_CODEC
+#include "azure_uamqp_c/alloc_counters.h"
 
 #define FRAME_HEADER_SIZE 8
 #define MAX_TYPE_SPECIFIC_SIZE    ((255 * 4) - 6)
+/* payload segments at least this big are handed to on_bytes_encoded as they are instead of being copied in the frame buffer */
+#define MIN_GATHERED_PAYLOAD_SIZE 4096
+/* frames whose copied part fits in this many bytes are encoded on the stack */
+#define MAX_STACK_ENCODED_FRAME_SIZE 256
+/* at most this many bytes are allocated for a received frame before its bytes arrive, the buffer then grows as they do */
+#define RECEIVE_BUFFER_INITIAL_SIZE 4096
 
 typedef enum RECEIVE_FRAME_STATE_TAG
 {
@@ -26,9 +36,12 @@ typedef enum RECEIVE_FRAME_STATE_TAG
     RECEIVE_FRAME_STATE_ERROR
 } RECEIVE_FRAME_STATE;
 
+/* frame types are one byte, so subscriptions are kept in a table indexed by frame type */
+#define FRAME_TYPE_COUNT 256
+
 typedef struct SUBSCRIPTION_TAG
 {
-    uint8_t frame_type;
+    /* NULL when nobody is subscribed to the frame type */
     ON_FRAME_RECEIVED on_frame_received;
     void* callback_context;
 } SUBSCRIPTION;
@@ -36,7 +49,7 @@ typedef struct SUBSCRIPTION_TAG
 typedef struct FRAME_CODEC_INSTANCE_TAG
 {
     /* subscriptions */
-    SINGLYLINKEDLIST_HANDLE subscription_list;
+    SUBSCRIPTION subscriptions[FRAME_TYPE_COUNT];
 
     /* decode frame */
     RECEIVE_FRAME_STATE receive_frame_state;
@@ -47,26 +60,226 @@ typedef struct FRAME_CODEC_INSTANCE_TAG
     uint8_t receive_frame_type;
     SUBSCRIPTION* receive_frame_subscription;
     unsigned char* receive_frame_bytes;
+    uint32_t receive_frame_capacity;
+    unsigned char* receive_buffer;
+    uint32_t receive_buffer_size;
+    ON_FRAME_CODEC_GET_RECEIVE_BUFFER get_receive_buffer;
+    ON_FRAME_CODEC_GROW_RECEIVE_BUFFER grow_receive_buffer;
+    ON_FRAME_CODEC_RELEASE_RECEIVE_BUFFER release_receive_buffer;
+    void* receive_buffer_pool_context;
     ON_FRAME_CODEC_ERROR on_frame_codec_error;
     void* on_frame_codec_error_callback_context;
 
     /* configuration */
     uint32_t max_frame_size;
+
+#ifdef UAMQP_STATIC_POOLS
+    /* frames are received and encoded in these, frames that do not fit are refused */
+    unsigned char static_receive_buffer[UAMQP_STATIC_MAX_FRAME_SIZE];
+    unsigned char static_encode_buffer[UAMQP_STATIC_MAX_FRAME_SIZE];
+#endif
 } FRAME_CODEC_INSTANCE;
 
-static bool find_subscription_by_frame_type(LIST_ITEM_HANDLE list_item, const void* match_context)
+static int get_receive_frame_buffer(FRAME_CODEC_INSTANCE* frame_codec_data, uint32_t size)
 {
-    bool result;
-    SUBSCRIPTION* subscription = (SUBSCRIPTION*)singlylinkedlist_item_get_value(list_item);
+    int result;
 
-    if (subscription == NULL)
+    if (frame_codec_data->get_receive_buffer != NULL)
     {
-        LogError("Could not get subscription information from the list item");
-        result = false;
+        /* Codes_SRS_FRAME_CODEC_01_132: [When a receive buffer pool is set, get_receive_buffer shall be asked for at most 4096 bytes, and the buffer shall be grown as the frame bytes arrive by calling grow_receive_buffer, by doubling its size without exceeding the frame size.] */
+        if (size > RECEIVE_BUFFER_INITIAL_SIZE)
+        {
+            size = RECEIVE_BUFFER_INITIAL_SIZE;
+        }
+
+        /* Codes_SRS_FRAME_CODEC_01_115: [When a receive buffer pool is set, frame_codec_receive_bytes shall obtain the memory for each frame by calling get_receive_buffer with the pool_context and the number of bytes needed.] */
+        frame_codec_data->receive_frame_bytes = frame_codec_data->get_receive_buffer(frame_codec_data->receive_buffer_pool_context, size);
+        frame_codec_data->receive_frame_capacity = size;
+        result = (frame_codec_data->receive_frame_bytes == NULL) ? __FAILURE__ : 0;
+    }
+    else if (size <= frame_codec_data->receive_buffer_size)
+    {
+        /* Codes_SRS_FRAME_CODEC_01_114: [The memory holding the frame bytes shall be kept by the frame_codec instance and reused for subsequent frames, it shall only be allocated again when a frame needs more bytes than were previously allocated.] */
+        frame_codec_data->receive_frame_bytes = frame_codec_data->receive_buffer;
+        frame_codec_data->receive_frame_capacity = frame_codec_data->receive_buffer_size;
+        result = 0;
+    }
+#ifdef UAMQP_STATIC_POOLS
+    else
+    {
+        /* Codes_SRS_FRAME_CODEC_01_125: [ When built with UAMQP_STATIC_POOLS, frames shall be received in a buffer of UAMQP_STATIC_MAX_FRAME_SIZE bytes held by the frame_codec instance, and a frame that does not fit in it shall be treated as a decode error. ]*/
+        LogError("Frame of %" PRIu32 " bytes does not fit the static receive buffer", size);
+        frame_codec_data->receive_frame_bytes = NULL;
+        result = __FAILURE__;
+    }
+#else
+    else if (frame_codec_data->receive_buffer_size >= RECEIVE_BUFFER_INITIAL_SIZE)
+    {
+        /* Codes_SRS_FRAME_CODEC_01_128: [Memory for a frame shall not be allocated for more than 4096 bytes before the frame bytes are received, it shall be grown as they arrive, by doubling its size without exceeding the frame size.] */
+        frame_codec_data->receive_frame_bytes = frame_codec_data->receive_buffer;
+        frame_codec_data->receive_frame_capacity = frame_codec_data->receive_buffer_size;
+        result = 0;
     }
     else
     {
-        result = subscription->frame_type == *((uint8_t*)match_context) ? true : false;
+        /* Codes_SRS_FRAME_CODEC_01_128: [Memory for a frame shall not be allocated for more than 4096 bytes before the frame bytes are received, it shall be grown as they arrive, by doubling its size without exceeding the frame size.] */
+        if (size > RECEIVE_BUFFER_INITIAL_SIZE)
+        {
+            size = RECEIVE_BUFFER_INITIAL_SIZE;
+        }
+
+        /* the previous contents are not needed, so the buffer is not reallocated */
+        if (frame_codec_data->receive_buffer != NULL)
+        {
+            ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, frame_codec_data->receive_buffer_size, 0);
+            free(frame_codec_data->receive_buffer);
+            frame_codec_data->receive_buffer = NULL;
+            frame_codec_data->receive_buffer_size = 0;
+        }
+
+        frame_codec_data->receive_buffer = (unsigned char*)malloc(size);
+        if (frame_codec_data->receive_buffer == NULL)
+        {
+            frame_codec_data->receive_frame_bytes = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, 0, size);
+            frame_codec_data->receive_buffer_size = size;
+            frame_codec_data->receive_frame_bytes = frame_codec_data->receive_buffer;
+            frame_codec_data->receive_frame_capacity = size;
+            result = 0;
+        }
+    }
+
+#endif
+
+    return result;
+}
+
+static int grow_receive_frame_buffer(FRAME_CODEC_INSTANCE* frame_codec_data, uint32_t needed)
+{
+    int result;
+
+    if (needed <= frame_codec_data->receive_frame_capacity)
+    {
+        result = 0;
+    }
+#ifdef UAMQP_STATIC_POOLS
+    else if (frame_codec_data->receive_frame_bytes == frame_codec_data->receive_buffer)
+    {
+        LogError("Frame does not fit the static receive buffer");
+        result = __FAILURE__;
+    }
+#endif
+    else
+    {
+        uint32_t frame_bytes_size = frame_codec_data->receive_frame_size - 6;
+        uint32_t new_size = (frame_codec_data->receive_frame_capacity > (UINT32_MAX / 2)) ? frame_bytes_size : frame_codec_data->receive_frame_capacity * 2;
+        unsigned char* new_buffer;
+
+        if (new_size < needed)
+        {
+            new_size = needed;
+        }
+
+        if (new_size > frame_bytes_size)
+        {
+            new_size = frame_bytes_size;
+        }
+
+        if (frame_codec_data->receive_frame_bytes != frame_codec_data->receive_buffer)
+        {
+            /* Codes_SRS_FRAME_CODEC_01_132: [When a receive buffer pool is set, get_receive_buffer shall be asked for at most 4096 bytes, and the buffer shall be grown as the frame bytes arrive by calling grow_receive_buffer, by doubling its size without exceeding the frame size.] */
+            new_buffer = frame_codec_data->grow_receive_buffer(frame_codec_data->receive_buffer_pool_context, frame_codec_data->receive_frame_bytes, new_size);
+        }
+        else
+        {
+#ifdef UAMQP_STATIC_POOLS
+            new_buffer = NULL;
+#else
+            new_buffer = (unsigned char*)realloc(frame_codec_data->receive_buffer, new_size);
+            if (new_buffer != NULL)
+            {
+                ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, frame_codec_data->receive_buffer_size, new_size);
+                frame_codec_data->receive_buffer = new_buffer;
+                frame_codec_data->receive_buffer_size = new_size;
+            }
+#endif
+        }
+
+        if (new_buffer == NULL)
+        {
+            /* the buffer that was held is still held, it is given back when the frame_codec is destroyed */
+            LogError("Cannot grow the receive buffer to %" PRIu32 " bytes", new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            frame_codec_data->receive_frame_bytes = new_buffer;
+            frame_codec_data->receive_frame_capacity = new_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void release_receive_frame_buffer(FRAME_CODEC_INSTANCE* frame_codec_data)
+{
+    if (frame_codec_data->receive_frame_bytes != frame_codec_data->receive_buffer)
+    {
+        /* Codes_SRS_FRAME_CODEC_01_116: [After on_frame_received returns, a buffer obtained from the receive buffer pool shall be given back by calling release_receive_buffer.] */
+        frame_codec_data->release_receive_buffer(frame_codec_data->receive_buffer_pool_context, frame_codec_data->receive_frame_bytes);
+    }
+
+    frame_codec_data->receive_frame_bytes = NULL;
+    frame_codec_data->receive_frame_capacity = 0;
+}
+
+static int dispatch_complete_frame(FRAME_CODEC_INSTANCE* frame_codec_data, const unsigned char** buffer, size_t* size)
+{
+    int result;
+    const unsigned char* frame_bytes = *buffer;
+    uint32_t frame_size;
+    uint32_t frame_header_size;
+
+    if (*size < FRAME_HEADER_SIZE)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        frame_size = ((uint32_t)frame_bytes[0] << 24) | ((uint32_t)frame_bytes[1] << 16) | ((uint32_t)frame_bytes[2] << 8) | (uint32_t)frame_bytes[3];
+        frame_header_size = (uint32_t)frame_bytes[4] * 4;
+
+        /* anything that is not a well formed frame fully contained in the buffer is left to the byte by byte decoder */
+        if ((frame_size < FRAME_HEADER_SIZE) ||
+            (frame_size > frame_codec_data->max_frame_size) ||
+            (frame_size > *size) ||
+            (frame_header_size < FRAME_HEADER_SIZE) ||
+            (frame_header_size > frame_size))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint32_t frame_body_size = frame_size - frame_header_size;
+            SUBSCRIPTION* subscription = &frame_codec_data->subscriptions[frame_bytes[5]];
+
+            *buffer += frame_size;
+            *size -= frame_size;
+
+            if (subscription->on_frame_received != NULL)
+            {
+                /* Codes_SRS_FRAME_CODEC_01_122: [When a complete frame is contained in the bytes passed to frame_codec_receive_bytes, it shall be indicated to the upper layer without copying, by passing to on_frame_received pointers into the buffer argument.] */
+                /* Codes_SRS_FRAME_CODEC_01_100: [If the frame body size is 0, the frame_body pointer passed to on_frame_received shall be NULL.] */
+                subscription->on_frame_received(subscription->callback_context, frame_bytes + 6, frame_header_size - 6, (frame_body_size == 0) ? NULL : frame_bytes + frame_header_size, frame_body_size);
+            }
+
+            result = 0;
+        }
     }
 
     return result;
@@ -100,7 +313,19 @@ FRAME_CODEC_HANDLE frame_codec_create(ON_FRAME_CODEC_ERROR on_frame_codec_error,
             result->receive_frame_pos = 0;
             result->receive_frame_size = 0;
             result->receive_frame_bytes = NULL;
-            result->subscription_list = singlylinkedlist_create();
+            result->receive_frame_capacity = 0;
+#ifdef UAMQP_STATIC_POOLS
+            result->receive_buffer = result->static_receive_buffer;
+            result->receive_buffer_size = UAMQP_STATIC_MAX_FRAME_SIZE;
+#else
+            result->receive_buffer = NULL;
+            result->receive_buffer_size = 0;
+#endif
+            result->get_receive_buffer = NULL;
+            result->grow_receive_buffer = NULL;
+            result->release_receive_buffer = NULL;
+            result->receive_buffer_pool_context = NULL;
+            (void)memset(result->subscriptions, 0, sizeof(result->subscriptions));
 
             /* Codes_SRS_FRAME_CODEC_01_082: [The initial max_frame_size_shall be 512.] */
             result->max_frame_size = 512;
@@ -121,11 +346,20 @@ void frame_codec_destroy(FRAME_CODEC_HANDLE frame_codec)
     {
         FRAME_CODEC_INSTANCE* frame_codec_data = (FRAME_CODEC_INSTANCE*)frame_codec;
 
-        singlylinkedlist_destroy(frame_codec_data->subscription_list);
-        if (frame_codec_data->receive_frame_bytes != NULL)
+        if ((frame_codec_data->receive_frame_bytes != NULL) &&
+            (frame_codec_data->receive_frame_bytes != frame_codec_data->receive_buffer))
+        {
+            /* Codes_SRS_FRAME_CODEC_01_120: [If frame_codec_destroy is called while a buffer obtained from the receive buffer pool is held, the buffer shall be released by calling release_receive_buffer.] */
+            frame_codec_data->release_receive_buffer(frame_codec_data->receive_buffer_pool_context, frame_codec_data->receive_frame_bytes);
+        }
+
+#ifndef UAMQP_STATIC_POOLS
+        if (frame_codec_data->receive_buffer != NULL)
         {
-            free(frame_codec_data->receive_frame_bytes);
+            ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, frame_codec_data->receive_buffer_size, 0);
+            free(frame_codec_data->receive_buffer);
         }
+#endif
 
         /* Codes_SRS_FRAME_CODEC_01_023: [frame_codec_destroy shall free all resources associated with a frame_codec instance.] */
         free(frame_codec);
@@ -141,6 +375,10 @@ int frame_codec_set_max_frame_size(FRAME_CODEC_HANDLE frame_codec, uint32_t max_
     if ((frame_codec == NULL) ||
         /* Codes_SRS_FRAME_CODEC_01_078: [If max_frame_size is invalid according to the AMQP standard, frame_codec_set_max_frame_size shall return a non-zero value.] */
         (max_frame_size < FRAME_HEADER_SIZE) ||
+#ifdef UAMQP_STATIC_POOLS
+        /* Codes_SRS_FRAME_CODEC_01_127: [ When built with UAMQP_STATIC_POOLS, frame_codec_set_max_frame_size shall fail and return a non-zero value if max_frame_size is bigger than UAMQP_STATIC_MAX_FRAME_SIZE. ]*/
+        (max_frame_size > UAMQP_STATIC_MAX_FRAME_SIZE) ||
+#endif
         /* Codes_SRS_FRAME_CODEC_01_081: [If a frame being decoded already has a size bigger than the max_frame_size argument then frame_codec_set_max_frame_size shall return a non-zero value and the previous frame size shall be kept.] */
         ((max_frame_size < frame_codec_data->receive_frame_size) && (frame_codec_data->receive_frame_state != RECEIVE_FRAME_STATE_FRAME_SIZE)))
     {
@@ -194,6 +432,8 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
     }
     else
     {
+        UAMQP_TRACEPOINT1(frame_codec_receive_bytes, size);
+
         while (size > 0)
         {
             switch (frame_codec_data->receive_frame_state)
@@ -208,6 +448,13 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
 
                 /* Codes_SRS_FRAME_CODEC_01_008: [SIZE Bytes 0-3 of the frame header contain the frame size.] */
             case RECEIVE_FRAME_STATE_FRAME_SIZE:
+                if ((frame_codec_data->receive_frame_pos == 0) &&
+                    (dispatch_complete_frame(frame_codec_data, &buffer, &size) == 0))
+                {
+                    result = 0;
+                    break;
+                }
+
                 /* Codes_SRS_FRAME_CODEC_01_009: [This is an unsigned 32-bit integer that MUST contain the total frame size of the frame header, extended header, and frame body.] */
                 frame_codec_data->receive_frame_size += buffer[0] << (24 - frame_codec_data->receive_frame_pos * 8);
                 buffer++;
@@ -271,7 +518,6 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
 
             case RECEIVE_FRAME_STATE_FRAME_TYPE:
             {
-                LIST_ITEM_HANDLE item_handle;
                 frame_codec_data->type_specific_size = (frame_codec_data->receive_frame_doff * 4) - 6;
 
                 /* Codes_SRS_FRAME_CODEC_01_015: [TYPE Byte 5 of the frame header is a type code.] */
@@ -279,51 +525,37 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
                 buffer++;
                 size--;
 
+                frame_codec_data->receive_frame_pos = 0;
+
                 /* Codes_SRS_FRAME_CODEC_01_035: [After successfully registering a callback for a certain frame type, when subsequently that frame type is received the callbacks shall be invoked, passing to it the received frame and the callback_context value.] */
-                item_handle = singlylinkedlist_find(frame_codec_data->subscription_list, find_subscription_by_frame_type, &frame_codec_data->receive_frame_type);
-                if (item_handle == NULL)
+                frame_codec_data->receive_frame_subscription = &frame_codec_data->subscriptions[frame_codec_data->receive_frame_type];
+                if (frame_codec_data->receive_frame_subscription->on_frame_received == NULL)
                 {
                     frame_codec_data->receive_frame_subscription = NULL;
                     frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_TYPE_SPECIFIC;
                     result = 0;
                     break;
                 }
-                else
+                /* Codes_SRS_FRAME_CODEC_01_102: [frame_codec_receive_bytes shall allocate memory to hold the frame_body bytes of frames that are split across frame_codec_receive_bytes calls.] */
+                else if (get_receive_frame_buffer(frame_codec_data, frame_codec_data->receive_frame_size - 6) != 0)
                 {
-                    frame_codec_data->receive_frame_subscription = (SUBSCRIPTION*)singlylinkedlist_item_get_value(item_handle);
-                    if (frame_codec_data->receive_frame_subscription == NULL)
-                    {
-                        frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_TYPE_SPECIFIC;
-                        result = 0;
-                        break;
-                    }
-                    else
-                    {
-                        frame_codec_data->receive_frame_pos = 0;
-
-                        /* Codes_SRS_FRAME_CODEC_01_102: [frame_codec_receive_bytes shall allocate memory to hold the frame_body bytes.] */
-                        frame_codec_data->receive_frame_bytes = (unsigned char*)malloc(frame_codec_data->receive_frame_size - 6);
-                        if (frame_codec_data->receive_frame_bytes == NULL)
-                        {
-                            /* Codes_SRS_FRAME_CODEC_01_101: [If the memory for the frame_body bytes cannot be allocated, frame_codec_receive_bytes shall fail and return a non-zero value.] */
-                            /* Codes_SRS_FRAME_CODEC_01_030: [If a decoding error occurs, frame_codec_data_receive_bytes shall return a non-zero value.] */
-                            /* Codes_SRS_FRAME_CODEC_01_074: [If a decoding error is detected, any subsequent calls on frame_codec_data_receive_bytes shall fail.] */
-                            frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_ERROR;
+                    /* Codes_SRS_FRAME_CODEC_01_101: [If the memory for the frame_body bytes cannot be allocated, frame_codec_receive_bytes shall fail and return a non-zero value.] */
+                    /* Codes_SRS_FRAME_CODEC_01_030: [If a decoding error occurs, frame_codec_data_receive_bytes shall return a non-zero value.] */
+                    /* Codes_SRS_FRAME_CODEC_01_074: [If a decoding error is detected, any subsequent calls on frame_codec_data_receive_bytes shall fail.] */
+                    frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_ERROR;
 
-                            /* Codes_SRS_FRAME_CODEC_01_103: [Upon any decode error, if an error callback has been passed to frame_codec_create, then the error callback shall be called with the context argument being the on_frame_codec_error_callback_context argument passed to frame_codec_create.] */
-                            frame_codec_data->on_frame_codec_error(frame_codec_data->on_frame_codec_error_callback_context);
+                    /* Codes_SRS_FRAME_CODEC_01_103: [Upon any decode error, if an error callback has been passed to frame_codec_create, then the error callback shall be called with the context argument being the on_frame_codec_error_callback_context argument passed to frame_codec_create.] */
+                    frame_codec_data->on_frame_codec_error(frame_codec_data->on_frame_codec_error_callback_context);
 
-                            LogError("Cannot allocate memort for frame bytes");
-                            result = __FAILURE__;
-                            break;
-                        }
-                        else
-                        {
-                            frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_TYPE_SPECIFIC;
-                            result = 0;
-                            break;
-                        }
-                    }
+                    LogError("Cannot allocate memort for frame bytes");
+                    result = __FAILURE__;
+                    break;
+                }
+                else
+                {
+                    frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_TYPE_SPECIFIC;
+                    result = 0;
+                    break;
                 }
             }
 
@@ -361,8 +593,7 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
                             /* Codes_SRS_FRAME_CODEC_01_006: [The treatment of this area depends on the frame type.] */
                             /* Codes_SRS_FRAME_CODEC_01_100: [If the frame body size is 0, the frame_body pointer passed to on_frame_received shall be NULL.] */
                             frame_codec_data->receive_frame_subscription->on_frame_received(frame_codec_data->receive_frame_subscription->callback_context, frame_codec_data->receive_frame_bytes, frame_codec_data->type_specific_size, NULL, 0);
-                            free(frame_codec_data->receive_frame_bytes);
-                            frame_codec_data->receive_frame_bytes = NULL;
+                            release_receive_frame_buffer(frame_codec_data);
                         }
 
                         frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_FRAME_SIZE;
@@ -390,7 +621,24 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
                     to_copy = size;
                 }
 
-                (void)memcpy(frame_codec_data->receive_frame_bytes + frame_codec_data->receive_frame_pos + frame_codec_data->type_specific_size, buffer, to_copy);
+                if (frame_codec_data->receive_frame_subscription != NULL)
+                {
+                    /* Codes_SRS_FRAME_CODEC_01_128: [Memory for a frame shall not be allocated for more than 4096 bytes before the frame bytes are received, it shall be grown as they arrive, by doubling its size without exceeding the frame size.] */
+                    if (grow_receive_frame_buffer(frame_codec_data, (uint32_t)(frame_codec_data->type_specific_size + frame_codec_data->receive_frame_pos + to_copy)) != 0)
+                    {
+                        /* Codes_SRS_FRAME_CODEC_01_129: [If growing the memory for a frame fails, frame_codec_receive_bytes shall fail and return a non-zero value.] */
+                        /* Codes_SRS_FRAME_CODEC_01_074: [If a decoding error is detected, any subsequent calls on frame_codec_data_receive_bytes shall fail.] */
+                        frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_ERROR;
+
+                        /* Codes_SRS_FRAME_CODEC_01_103: [Upon any decode error, if an error callback has been passed to frame_codec_create, then the error callback shall be called with the context argument being the on_frame_codec_error_callback_context argument passed to frame_codec_create.] */
+                        frame_codec_data->on_frame_codec_error(frame_codec_data->on_frame_codec_error_callback_context);
+
+                        result = __FAILURE__;
+                        break;
+                    }
+
+                    (void)memcpy(frame_codec_data->receive_frame_bytes + frame_codec_data->receive_frame_pos + frame_codec_data->type_specific_size, buffer, to_copy);
+                }
 
                 buffer += to_copy;
                 size -= to_copy;
@@ -406,8 +654,7 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
                         /* Codes_SRS_FRAME_CODEC_01_006: [The treatment of this area depends on the frame type.] */
                         /* Codes_SRS_FRAME_CODEC_01_099: [A pointer to the frame_body bytes shall also be passed to the on_frame_received.] */
                         frame_codec_data->receive_frame_subscription->on_frame_received(frame_codec_data->receive_frame_subscription->callback_context, frame_codec_data->receive_frame_bytes, frame_codec_data->type_specific_size, frame_codec_data->receive_frame_bytes + frame_codec_data->type_specific_size, frame_body_size);
-                        free(frame_codec_data->receive_frame_bytes);
-                        frame_codec_data->receive_frame_bytes = NULL;
+                        release_receive_frame_buffer(frame_codec_data);
                     }
 
                     frame_codec_data->receive_frame_state = RECEIVE_FRAME_STATE_FRAME_SIZE;
@@ -425,6 +672,69 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
     return result;
 }
 
+int frame_codec_set_receive_buffer_pool(FRAME_CODEC_HANDLE frame_codec, ON_FRAME_CODEC_GET_RECEIVE_BUFFER get_receive_buffer, ON_FRAME_CODEC_GROW_RECEIVE_BUFFER grow_receive_buffer, ON_FRAME_CODEC_RELEASE_RECEIVE_BUFFER release_receive_buffer, void* pool_context)
+{
+    int result;
+
+    /* Codes_SRS_FRAME_CODEC_01_118: [If frame_codec is NULL or some but not all of get_receive_buffer, grow_receive_buffer and release_receive_buffer are NULL, frame_codec_set_receive_buffer_pool shall fail and return a non-zero value.] */
+    if ((frame_codec == NULL) ||
+        ((get_receive_buffer == NULL) != (release_receive_buffer == NULL)) ||
+        ((get_receive_buffer == NULL) != (grow_receive_buffer == NULL)))
+    {
+        LogError("Bad arguments: frame_codec = %p, get_receive_buffer = %p, grow_receive_buffer = %p, release_receive_buffer = %p",
+            frame_codec, get_receive_buffer, grow_receive_buffer, release_receive_buffer);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_FRAME_CODEC_01_119: [If a frame is being decoded, frame_codec_set_receive_buffer_pool shall fail and return a non-zero value.] */
+    else if (frame_codec->receive_frame_bytes != NULL)
+    {
+        LogError("Cannot change the receive buffer pool while a frame is being decoded");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_FRAME_CODEC_01_121: [Passing NULL for get_receive_buffer, grow_receive_buffer and release_receive_buffer shall revert to the receive buffer kept by the frame_codec instance.] */
+        if ((get_receive_buffer != NULL) &&
+            (frame_codec->receive_buffer != NULL))
+        {
+            ALLOC_COUNTERS_RESIZE_OBJECT(ALLOC_OBJECT_TYPE_FRAME_BUFFER, frame_codec->receive_buffer_size, 0);
+            free(frame_codec->receive_buffer);
+            frame_codec->receive_buffer = NULL;
+            frame_codec->receive_buffer_size = 0;
+        }
+
+        frame_codec->get_receive_buffer = get_receive_buffer;
+        frame_codec->grow_receive_buffer = grow_receive_buffer;
+        frame_codec->release_receive_buffer = release_receive_buffer;
+        frame_codec->receive_buffer_pool_context = pool_context;
+
+        /* Codes_SRS_FRAME_CODEC_01_117: [On success, frame_codec_set_receive_buffer_pool shall return 0.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+bool frame_codec_is_at_frame_boundary(FRAME_CODEC_HANDLE frame_codec)
+{
+    bool result;
+
+    if (frame_codec == NULL)
+    {
+        /* Codes_SRS_FRAME_CODEC_01_131: [If frame_codec is NULL, frame_codec_is_at_frame_boundary shall return false.] */
+        LogError("NULL frame_codec");
+        result = false;
+    }
+    else
+    {
+        /* Codes_SRS_FRAME_CODEC_01_130: [frame_codec_is_at_frame_boundary shall return true when no byte of a frame has been received since the last complete frame, and false otherwise, a frame_codec that had a decode error included.] */
+        result = (frame_codec->receive_frame_state == RECEIVE_FRAME_STATE_FRAME_SIZE) &&
+            (frame_codec->receive_frame_pos == 0);
+    }
+
+    return result;
+}
+
 /* Codes_SRS_FRAME_CODEC_01_033: [frame_codec_subscribe subscribes for a certain type of frame received by the frame_codec instance identified by frame_codec.] */
 int frame_codec_subscribe(FRAME_CODEC_HANDLE frame_codec, uint8_t type, ON_FRAME_RECEIVED on_frame_received, void* callback_context)
 {
@@ -441,60 +751,14 @@ int frame_codec_subscribe(FRAME_CODEC_HANDLE frame_codec, uint8_t type, ON_FRAME
     else
     {
         FRAME_CODEC_INSTANCE* frame_codec_data = (FRAME_CODEC_INSTANCE*)frame_codec;
-        SUBSCRIPTION* subscription;
 
         /* Codes_SRS_FRAME_CODEC_01_036: [Only one callback pair shall be allowed to be registered for a given frame type.] */
-        /* find the subscription for this frame type */
-        LIST_ITEM_HANDLE list_item = singlylinkedlist_find(frame_codec_data->subscription_list, find_subscription_by_frame_type, &type);
-        if (list_item != NULL)
-        {
-            subscription = (SUBSCRIPTION*)singlylinkedlist_item_get_value(list_item);
-            if (subscription == NULL)
-            {
-                /* Codes_SRS_FRAME_CODEC_01_037: [If any failure occurs while performing the subscribe operation, frame_codec_subscribe shall return a non-zero value.] */
-                LogError("Cannot retrieve subscription information from the list for type %u", (unsigned int)type);
-                result = __FAILURE__;
-            }
-            else
-            {
-                /* a subscription was found */
-                subscription->on_frame_received = on_frame_received;
-                subscription->callback_context = callback_context;
-
-                /* Codes_SRS_FRAME_CODEC_01_087: [On success, frame_codec_subscribe shall return zero.] */
-                result = 0;
-            }
-        }
-        else
-        {
-            /* add a new subscription */
-            subscription = (SUBSCRIPTION*)malloc(sizeof(SUBSCRIPTION));
-            /* Codes_SRS_FRAME_CODEC_01_037: [If any failure occurs while performing the subscribe operation, frame_codec_subscribe shall return a non-zero value.] */
-            if (subscription == NULL)
-            {
-                LogError("Cannot allocate memory for new subscription");
-                result = __FAILURE__;
-            }
-            else
-            {
-                subscription->on_frame_received = on_frame_received;
-                subscription->callback_context = callback_context;
-                subscription->frame_type = type;
+        /* Codes_SRS_FRAME_CODEC_01_123: [Subscriptions shall be kept in a table indexed by frame type, so that subscribing, unsubscribing and finding the subscription for a received frame do not depend on the number of subscriptions.] */
+        frame_codec_data->subscriptions[type].on_frame_received = on_frame_received;
+        frame_codec_data->subscriptions[type].callback_context = callback_context;
 
-                /* Codes_SRS_FRAME_CODEC_01_037: [If any failure occurs while performing the subscribe operation, frame_codec_subscribe shall return a non-zero value.] */
-                if (singlylinkedlist_add(frame_codec_data->subscription_list, subscription) == NULL)
-                {
-                    free(subscription);
-                    LogError("Cannot add subscription to list");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    /* Codes_SRS_FRAME_CODEC_01_087: [On success, frame_codec_subscribe shall return zero.] */
-                    result = 0;
-                }
-            }
-        }
+        /* Codes_SRS_FRAME_CODEC_01_087: [On success, frame_codec_subscribe shall return zero.] */
+        result = 0;
     }
 
     return result;
@@ -513,39 +777,19 @@ int frame_codec_unsubscribe(FRAME_CODEC_HANDLE frame_codec, uint8_t type)
     else
     {
         FRAME_CODEC_INSTANCE* frame_codec_data = (FRAME_CODEC_INSTANCE*)frame_codec;
-        LIST_ITEM_HANDLE list_item = singlylinkedlist_find(frame_codec_data->subscription_list, find_subscription_by_frame_type, &type);
 
-        if (list_item == NULL)
+        if (frame_codec_data->subscriptions[type].on_frame_received == NULL)
         {
             /* Codes_SRS_FRAME_CODEC_01_040: [If no subscription for the type frame type exists, frame_codec_unsubscribe shall return a non-zero value.] */
-            /* Codes_SRS_FRAME_CODEC_01_041: [If any failure occurs while performing the unsubscribe operation, frame_codec_unsubscribe shall return a non-zero value.] */
             LogError("Cannot find subscription for type %u", (unsigned int)type);
             result = __FAILURE__;
         }
         else
         {
-            SUBSCRIPTION* subscription = (SUBSCRIPTION*)singlylinkedlist_item_get_value(list_item);
-            if (subscription == NULL)
-            {
-                /* Codes_SRS_FRAME_CODEC_01_041: [If any failure occurs while performing the unsubscribe operation, frame_codec_unsubscribe shall return a non-zero value.] */
-                LogError("singlylinkedlist_item_get_value failed when unsubscribing");
-                result = __FAILURE__;
-            }
-            else
-            {
-                free(subscription);
-                if (singlylinkedlist_remove(frame_codec_data->subscription_list, list_item) != 0)
-                {
-                    /* Codes_SRS_FRAME_CODEC_01_041: [If any failure occurs while performing the unsubscribe operation, frame_codec_unsubscribe shall return a non-zero value.] */
-                    LogError("Cannot remove subscription from list");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    /* Codes_SRS_FRAME_CODEC_01_038: [frame_codec_unsubscribe removes a previous subscription for frames of type type and on success it shall return 0.] */
-                    result = 0;
-                }
-            }
+            /* Codes_SRS_FRAME_CODEC_01_038: [frame_codec_unsubscribe removes a previous subscription for frames of type type and on success it shall return 0.] */
+            frame_codec_data->subscriptions[type].on_frame_received = NULL;
+            frame_codec_data->subscriptions[type].callback_context = NULL;
+            result = 0;
         }
     }
 
@@ -587,6 +831,7 @@ int frame_codec_encode_frame(FRAME_CODEC_HANDLE frame_codec, uint8_t type, const
         size_t i;
         size_t frame_size;
         size_t frame_body_size = 0;
+        size_t gathered_payload_size = 0;
         frame_body_offset = doff * 4;
         padding_byte_count = (uint8_t)(frame_body_offset - type_specific_size - 6);
 
@@ -601,6 +846,11 @@ int frame_codec_encode_frame(FRAME_CODEC_HANDLE frame_codec, uint8_t type, const
             }
 
             frame_body_size += payloads[i].length;
+
+            if (payloads[i].length >= MIN_GATHERED_PAYLOAD_SIZE)
+            {
+                gathered_payload_size += payloads[i].length;
+            }
         }
 
         if (i < payload_count)
@@ -621,8 +871,32 @@ int frame_codec_encode_frame(FRAME_CODEC_HANDLE frame_codec, uint8_t type, const
             }
             else
             {
-                /* Codes_SRS_FRAME_CODEC_01_108: [ Memory shall be allocated to hold the entire frame. ]*/
-                unsigned char* encoded_frame = (unsigned char*)malloc(frame_size);
+                unsigned char stack_encoded_frame[MAX_STACK_ENCODED_FRAME_SIZE];
+                unsigned char* encoded_frame;
+
+                if (frame_size - gathered_payload_size <= MAX_STACK_ENCODED_FRAME_SIZE)
+                {
+                    /* Codes_SRS_FRAME_CODEC_01_124: [ When the bytes to be copied for a frame are not more than 256, no memory shall be allocated to encode the frame. ]*/
+                    encoded_frame = stack_encoded_frame;
+                }
+#ifdef UAMQP_STATIC_POOLS
+                else if (frame_size - gathered_payload_size <= UAMQP_STATIC_MAX_FRAME_SIZE)
+                {
+                    /* Codes_SRS_FRAME_CODEC_01_126: [ When built with UAMQP_STATIC_POOLS, frames shall be encoded in a buffer of UAMQP_STATIC_MAX_FRAME_SIZE bytes held by the frame_codec instance, and a frame that does not fit in it shall fail to encode. ]*/
+                    encoded_frame = frame_codec_data->static_encode_buffer;
+                }
+                else
+                {
+                    encoded_frame = NULL;
+                }
+#else
+                else
+                {
+                    /* Codes_SRS_FRAME_CODEC_01_108: [ Memory shall be allocated to hold the frame, except for the payload segments that are passed as they are to `on_bytes_encoded`. ]*/
+                    encoded_frame = (unsigned char*)malloc(frame_size - gathered_payload_size);
+                }
+#endif
+
                 if (encoded_frame == NULL)
                 {
                     /* Codes_SRS_FRAME_CODEC_01_109: [ If allocating memory fails, `frame_codec_encode_frame` shall fail and return a non-zero value. ]*/
@@ -643,6 +917,7 @@ int frame_codec_encode_frame(FRAME_CODEC_HANDLE frame_codec, uint8_t type, const
                     /* Codes_SRS_FRAME_CODEC_01_064: [The frame is malformed if the size is less than the size of the frame header (8 bytes).] */
                     unsigned char frame_header[6];
                     size_t current_pos = 0;
+                    size_t sent_pos = 0;
                     /* Codes_SRS_FRAME_CODEC_01_090: [If the type_specific_size - 2 does not divide by 4, frame_codec_encode_frame shall pad the type_specific bytes with zeroes so that type specific data is according to the AMQP ISO.] */
                     unsigned char padding_bytes[] = { 0x00, 0x00, 0x00 };
 
@@ -674,14 +949,38 @@ int frame_codec_encode_frame(FRAME_CODEC_HANDLE frame_codec, uint8_t type, const
                     /* Codes_SRS_FRAME_CODEC_01_106: [All payloads shall be encoded in order as part of the frame.] */
                     for (i = 0; i < payload_count; i++)
                     {
-                        (void)memcpy(encoded_frame + current_pos, payloads[i].bytes, payloads[i].length);
-                        current_pos += payloads[i].length;
+                        if (payloads[i].length >= MIN_GATHERED_PAYLOAD_SIZE)
+                        {
+                            /* Codes_SRS_FRAME_CODEC_01_112: [ A payload segment of at least 4096 bytes shall not be copied: the bytes encoded before it and the segment itself shall each be passed to `on_bytes_encoded`, in order. ]*/
+                            if (current_pos > sent_pos)
+                            {
+                                on_bytes_encoded(callback_context, encoded_frame + sent_pos, current_pos - sent_pos, false);
+                                sent_pos = current_pos;
+                            }
+
+                            /* Codes_SRS_FRAME_CODEC_01_113: [ Only the last call to `on_bytes_encoded` for a frame shall set the `encode complete` argument to true. ]*/
+                            on_bytes_encoded(callback_context, payloads[i].bytes, payloads[i].length, (i == payload_count - 1));
+                        }
+                        else
+                        {
+                            (void)memcpy(encoded_frame + current_pos, payloads[i].bytes, payloads[i].length);
+                            current_pos += payloads[i].length;
+                        }
                     }
 
-                    /* Codes_SRS_FRAME_CODEC_01_088: [Encoded bytes shall be passed to the `on_bytes_encoded` callback in a single call, while setting the `encode complete` argument to true.] */
-                    on_bytes_encoded(callback_context, encoded_frame, frame_size, true);
+                    if (current_pos > sent_pos)
+                    {
+                        /* Codes_SRS_FRAME_CODEC_01_088: [When no payload segment is passed as is, encoded bytes shall be passed to the `on_bytes_encoded` callback in a single call, while setting the `encode complete` argument to true.] */
+                        /* Codes_SRS_FRAME_CODEC_01_113: [ Only the last call to `on_bytes_encoded` for a frame shall set the `encode complete` argument to true. ]*/
+                        on_bytes_encoded(callback_context, encoded_frame + sent_pos, current_pos - sent_pos, true);
+                    }
 
-                    free(encoded_frame);
+#ifndef UAMQP_STATIC_POOLS
+                    if (encoded_frame != stack_encoded_frame)
+                    {
+                        free(encoded_frame);
+                    }
+#endif
 
                     /* Codes_SRS_FRAME_CODEC_01_043: [On success it shall return 0.] */
                     result = 0;
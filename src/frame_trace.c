@@ -0,0 +1,565 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/frame_trace.h"
+
+/* saved traces start with this magic, followed by the records from the oldest to the newest */
+static const unsigned char frame_trace_magic[] = { 'U', 'A', 'M', 'Q', 'P', 'F', 'T', '1' };
+
+/* timestamp (8), direction (1), frame type (1), channel (2), performative size (4), payload size (4), captured size (4), all big endian */
+#define SAVED_RECORD_HEADER_SIZE 24
+
+/* captures start with this magic, followed by the received bytes in chunks */
+static const unsigned char frame_capture_magic[] = { 'U', 'A', 'M', 'Q', 'P', 'F', 'C', '1' };
+
+/* timestamp (8), length (4), big endian */
+#define CAPTURE_CHUNK_HEADER_SIZE 12
+
+typedef struct FRAME_TRACE_SLOT_TAG
+{
+    uint64_t timestamp_ms;
+    uint32_t performative_size;
+    uint32_t captured_size;
+    uint32_t payload_size;
+    uint16_t channel;
+    unsigned char direction;
+    unsigned char frame_type;
+    unsigned char performative_bytes[FRAME_TRACE_MAX_PERFORMATIVE_SIZE];
+} FRAME_TRACE_SLOT;
+
+typedef struct FRAME_TRACE_INSTANCE_TAG
+{
+    FRAME_TRACE_SLOT* slots;
+    size_t slot_count;
+    /* index of the oldest record */
+    size_t head;
+    size_t record_count;
+    /* NULL when not capturing */
+    FRAME_TRACE_OUTPUT capture_output;
+    void* capture_output_context;
+} FRAME_TRACE_INSTANCE;
+
+typedef struct PERFORMATIVE_CAPTURE_TAG
+{
+    unsigned char bytes[FRAME_TRACE_MAX_PERFORMATIVE_SIZE];
+    size_t captured_size;
+    size_t encoded_size;
+} PERFORMATIVE_CAPTURE;
+
+static int capture_encoded_bytes(void* context, const unsigned char* bytes, size_t length)
+{
+    PERFORMATIVE_CAPTURE* capture = (PERFORMATIVE_CAPTURE*)context;
+
+    /* the encoding goes on past the capture size so that the full performative size is known */
+    if (capture->captured_size < FRAME_TRACE_MAX_PERFORMATIVE_SIZE)
+    {
+        size_t to_copy = FRAME_TRACE_MAX_PERFORMATIVE_SIZE - capture->captured_size;
+        if (to_copy > length)
+        {
+            to_copy = length;
+        }
+
+        (void)memcpy(capture->bytes + capture->captured_size, bytes, to_copy);
+        capture->captured_size += to_copy;
+    }
+
+    capture->encoded_size += length;
+
+    return 0;
+}
+
+static FRAME_TRACE_SLOT* add_record(FRAME_TRACE_INSTANCE* frame_trace)
+{
+    FRAME_TRACE_SLOT* result = &frame_trace->slots[(frame_trace->head + frame_trace->record_count) % frame_trace->slot_count];
+
+    if (frame_trace->record_count < frame_trace->slot_count)
+    {
+        frame_trace->record_count++;
+    }
+    else
+    {
+        /* the ring is full, the oldest record is overwritten */
+        frame_trace->head = (frame_trace->head + 1) % frame_trace->slot_count;
+    }
+
+    return result;
+}
+
+static void fill_record(FRAME_TRACE_SLOT* slot, FRAME_TRACE_DIRECTION direction, FRAME_TRACE_FRAME_TYPE frame_type, uint16_t channel, uint64_t timestamp_ms, const unsigned char* performative_bytes, size_t performative_size, uint32_t payload_size)
+{
+    size_t captured_size = (performative_size > FRAME_TRACE_MAX_PERFORMATIVE_SIZE) ? FRAME_TRACE_MAX_PERFORMATIVE_SIZE : performative_size;
+
+    slot->timestamp_ms = timestamp_ms;
+    slot->direction = (unsigned char)direction;
+    slot->frame_type = (unsigned char)frame_type;
+    slot->channel = channel;
+    slot->performative_size = (performative_size > UINT32_MAX) ? UINT32_MAX : (uint32_t)performative_size;
+    slot->captured_size = (uint32_t)captured_size;
+    slot->payload_size = payload_size;
+    if (captured_size > 0)
+    {
+        (void)memcpy(slot->performative_bytes, performative_bytes, captured_size);
+    }
+}
+
+static void write_uint16(unsigned char* bytes, uint16_t value)
+{
+    bytes[0] = (unsigned char)(value >> 8);
+    bytes[1] = (unsigned char)value;
+}
+
+static void write_uint32(unsigned char* bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value >> 24);
+    bytes[1] = (unsigned char)(value >> 16);
+    bytes[2] = (unsigned char)(value >> 8);
+    bytes[3] = (unsigned char)value;
+}
+
+static uint16_t read_uint16(const unsigned char* bytes)
+{
+    return (uint16_t)(((uint16_t)bytes[0] << 8) | bytes[1]);
+}
+
+static uint32_t read_uint32(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+FRAME_TRACE_HANDLE frame_trace_create(size_t record_count)
+{
+    FRAME_TRACE_INSTANCE* frame_trace;
+
+    if (record_count == 0)
+    {
+        /* Codes_SRS_FRAME_TRACE_01_002: [ If `record_count` is 0, `frame_trace_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: record_count = 0");
+        frame_trace = NULL;
+    }
+    else
+    {
+        frame_trace = (FRAME_TRACE_INSTANCE*)malloc(sizeof(FRAME_TRACE_INSTANCE));
+        if (frame_trace == NULL)
+        {
+            /* Codes_SRS_FRAME_TRACE_01_003: [ If allocating memory for the frame trace fails, `frame_trace_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the frame trace");
+        }
+        else
+        {
+            /* Codes_SRS_FRAME_TRACE_01_001: [ `frame_trace_create` shall create an empty frame trace holding at most `record_count` records, allocating all of them at once, and return a non-NULL handle to it. ]*/
+            frame_trace->slots = (FRAME_TRACE_SLOT*)malloc(sizeof(FRAME_TRACE_SLOT) * record_count);
+            if (frame_trace->slots == NULL)
+            {
+                /* Codes_SRS_FRAME_TRACE_01_003: [ If allocating memory for the frame trace fails, `frame_trace_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate memory for the frame trace records");
+                free(frame_trace);
+                frame_trace = NULL;
+            }
+            else
+            {
+                frame_trace->slot_count = record_count;
+                frame_trace->head = 0;
+                frame_trace->record_count = 0;
+                frame_trace->capture_output = NULL;
+                frame_trace->capture_output_context = NULL;
+            }
+        }
+    }
+
+    return frame_trace;
+}
+
+void frame_trace_destroy(FRAME_TRACE_HANDLE frame_trace)
+{
+    if (frame_trace == NULL)
+    {
+        /* Codes_SRS_FRAME_TRACE_01_005: [ If `frame_trace` is NULL, `frame_trace_destroy` shall do nothing. ]*/
+        LogError("NULL frame_trace");
+    }
+    else
+    {
+        /* Codes_SRS_FRAME_TRACE_01_004: [ `frame_trace_destroy` shall free all resources associated with the frame trace. ]*/
+        free(frame_trace->slots);
+        free(frame_trace);
+    }
+}
+
+int frame_trace_record_bytes(FRAME_TRACE_HANDLE frame_trace, FRAME_TRACE_DIRECTION direction, FRAME_TRACE_FRAME_TYPE frame_type, uint16_t channel, uint64_t timestamp_ms, const unsigned char* performative_bytes, size_t performative_size, uint32_t payload_size)
+{
+    int result;
+
+    if ((frame_trace == NULL) ||
+        ((performative_bytes == NULL) && (performative_size > 0)) ||
+        ((unsigned int)direction > (unsigned int)FRAME_TRACE_DIRECTION_OUTGOING) ||
+        ((unsigned int)frame_type > (unsigned int)FRAME_TRACE_FRAME_TYPE_PERFORMATIVE))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_007: [ If `frame_trace` is NULL, `performative_bytes` is NULL while `performative_size` is not 0, or `direction` or `frame_type` is not a known value, `frame_trace_record_bytes` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: frame_trace = %p, performative_bytes = %p, performative_size = %u, direction = %d, frame_type = %d",
+            frame_trace, performative_bytes, (unsigned int)performative_size, (int)direction, (int)frame_type);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_FRAME_TRACE_01_006: [ `frame_trace_record_bytes` shall add a record with `direction`, `frame_type`, `channel`, `timestamp_ms`, `payload_size`, the performative size and a copy of at most FRAME_TRACE_MAX_PERFORMATIVE_SIZE bytes of `performative_bytes`, and return 0. ]*/
+        /* Codes_SRS_FRAME_TRACE_01_008: [ When the trace already holds `record_count` records, the oldest record shall be overwritten. ]*/
+        fill_record(add_record(frame_trace), direction, frame_type, channel, timestamp_ms, performative_bytes, performative_size, payload_size);
+        result = 0;
+    }
+
+    return result;
+}
+
+int frame_trace_record_value(FRAME_TRACE_HANDLE frame_trace, FRAME_TRACE_DIRECTION direction, uint16_t channel, uint64_t timestamp_ms, AMQP_VALUE performative, uint32_t payload_size)
+{
+    int result;
+
+    if ((frame_trace == NULL) ||
+        (performative == NULL) ||
+        ((unsigned int)direction > (unsigned int)FRAME_TRACE_DIRECTION_OUTGOING))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_010: [ If `frame_trace` or `performative` is NULL or `direction` is not a known value, `frame_trace_record_value` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: frame_trace = %p, performative = %p, direction = %d",
+            frame_trace, performative, (int)direction);
+        result = __FAILURE__;
+    }
+    else
+    {
+        PERFORMATIVE_CAPTURE capture;
+
+        capture.captured_size = 0;
+        capture.encoded_size = 0;
+
+        /* Codes_SRS_FRAME_TRACE_01_009: [ `frame_trace_record_value` shall encode `performative` with `amqpvalue_encode` and record it as a FRAME_TRACE_FRAME_TYPE_PERFORMATIVE frame the way `frame_trace_record_bytes` does. ]*/
+        if (amqpvalue_encode(performative, capture_encoded_bytes, &capture) != 0)
+        {
+            /* Codes_SRS_FRAME_TRACE_01_011: [ If `amqpvalue_encode` fails, `frame_trace_record_value` shall fail, leave the trace unchanged and return a non-zero value. ]*/
+            LogError("Cannot encode the performative for the frame trace");
+            result = __FAILURE__;
+        }
+        else
+        {
+            FRAME_TRACE_SLOT* slot = add_record(frame_trace);
+
+            fill_record(slot, direction, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, channel, timestamp_ms, capture.bytes, capture.captured_size, payload_size);
+            slot->performative_size = (capture.encoded_size > UINT32_MAX) ? UINT32_MAX : (uint32_t)capture.encoded_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int frame_trace_get_record_count(FRAME_TRACE_HANDLE frame_trace, size_t* record_count)
+{
+    int result;
+
+    if ((frame_trace == NULL) ||
+        (record_count == NULL))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_013: [ If `frame_trace` or `record_count` is NULL, `frame_trace_get_record_count` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: frame_trace = %p, record_count = %p",
+            frame_trace, record_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_FRAME_TRACE_01_012: [ `frame_trace_get_record_count` shall store in `record_count` the number of records held by the trace and return 0. ]*/
+        *record_count = frame_trace->record_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+void frame_trace_clear(FRAME_TRACE_HANDLE frame_trace)
+{
+    if (frame_trace == NULL)
+    {
+        /* Codes_SRS_FRAME_TRACE_01_015: [ If `frame_trace` is NULL, `frame_trace_clear` shall do nothing. ]*/
+        LogError("NULL frame_trace");
+    }
+    else
+    {
+        /* Codes_SRS_FRAME_TRACE_01_014: [ `frame_trace_clear` shall remove all records from the trace. ]*/
+        frame_trace->head = 0;
+        frame_trace->record_count = 0;
+    }
+}
+
+int frame_trace_save(FRAME_TRACE_HANDLE frame_trace, FRAME_TRACE_OUTPUT output, void* output_context)
+{
+    int result;
+
+    if ((frame_trace == NULL) ||
+        (output == NULL))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_017: [ If `frame_trace` or `output` is NULL, `frame_trace_save` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: frame_trace = %p, output = %p",
+            frame_trace, output);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_FRAME_TRACE_01_016: [ `frame_trace_save` shall pass to `output` the trace magic followed by each record, from the oldest to the newest, and return 0. ]*/
+    else if (output(output_context, frame_trace_magic, sizeof(frame_trace_magic)) != 0)
+    {
+        /* Codes_SRS_FRAME_TRACE_01_018: [ If `output` fails, `frame_trace_save` shall fail and return a non-zero value. ]*/
+        LogError("Cannot output the frame trace magic");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+
+        for (i = 0; i < frame_trace->record_count; i++)
+        {
+            const FRAME_TRACE_SLOT* slot = &frame_trace->slots[(frame_trace->head + i) % frame_trace->slot_count];
+            unsigned char record_header[SAVED_RECORD_HEADER_SIZE];
+
+            write_uint32(record_header, (uint32_t)(slot->timestamp_ms >> 32));
+            write_uint32(record_header + 4, (uint32_t)slot->timestamp_ms);
+            record_header[8] = slot->direction;
+            record_header[9] = slot->frame_type;
+            write_uint16(record_header + 10, slot->channel);
+            write_uint32(record_header + 12, slot->performative_size);
+            write_uint32(record_header + 16, slot->payload_size);
+            write_uint32(record_header + 20, slot->captured_size);
+
+            if ((output(output_context, record_header, sizeof(record_header)) != 0) ||
+                ((slot->captured_size > 0) && (output(output_context, slot->performative_bytes, slot->captured_size) != 0)))
+            {
+                /* Codes_SRS_FRAME_TRACE_01_018: [ If `output` fails, `frame_trace_save` shall fail and return a non-zero value. ]*/
+                LogError("Cannot output frame trace record %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+int frame_trace_parse(const unsigned char* bytes, size_t size, ON_FRAME_TRACE_RECORD on_record, void* on_record_context)
+{
+    int result;
+
+    if ((bytes == NULL) ||
+        (on_record == NULL))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_020: [ If `bytes` or `on_record` is NULL, `frame_trace_parse` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: bytes = %p, on_record = %p",
+            bytes, on_record);
+        result = __FAILURE__;
+    }
+    else if ((size < sizeof(frame_trace_magic)) ||
+        (memcmp(bytes, frame_trace_magic, sizeof(frame_trace_magic)) != 0))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_021: [ If `bytes` does not start with the trace magic, `frame_trace_parse` shall fail and return a non-zero value. ]*/
+        LogError("Not a saved frame trace");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t position = sizeof(frame_trace_magic);
+
+        result = 0;
+
+        /* Codes_SRS_FRAME_TRACE_01_019: [ `frame_trace_parse` shall call `on_record` with `on_record_context` for each record saved by `frame_trace_save`, in the saved order, and return 0. ]*/
+        while (position < size)
+        {
+            FRAME_TRACE_RECORD record;
+
+            if (size - position < SAVED_RECORD_HEADER_SIZE)
+            {
+                /* Codes_SRS_FRAME_TRACE_01_022: [ If a record is truncated or carries invalid values, `frame_trace_parse` shall fail and return a non-zero value after reporting the records before it. ]*/
+                LogError("Truncated frame trace record header at offset %u", (unsigned int)position);
+                result = __FAILURE__;
+                break;
+            }
+
+            record.timestamp_ms = ((uint64_t)read_uint32(bytes + position) << 32) | read_uint32(bytes + position + 4);
+            record.direction = (FRAME_TRACE_DIRECTION)bytes[position + 8];
+            record.frame_type = (FRAME_TRACE_FRAME_TYPE)bytes[position + 9];
+            record.channel = read_uint16(bytes + position + 10);
+            record.performative_size = read_uint32(bytes + position + 12);
+            record.payload_size = read_uint32(bytes + position + 16);
+            record.captured_size = read_uint32(bytes + position + 20);
+            position += SAVED_RECORD_HEADER_SIZE;
+
+            if ((bytes[position - SAVED_RECORD_HEADER_SIZE + 8] > (unsigned char)FRAME_TRACE_DIRECTION_OUTGOING) ||
+                (bytes[position - SAVED_RECORD_HEADER_SIZE + 9] > (unsigned char)FRAME_TRACE_FRAME_TYPE_PERFORMATIVE) ||
+                (record.captured_size > record.performative_size) ||
+                (record.captured_size > FRAME_TRACE_MAX_PERFORMATIVE_SIZE) ||
+                (size - position < record.captured_size))
+            {
+                /* Codes_SRS_FRAME_TRACE_01_022: [ If a record is truncated or carries invalid values, `frame_trace_parse` shall fail and return a non-zero value after reporting the records before it. ]*/
+                LogError("Invalid frame trace record at offset %u", (unsigned int)(position - SAVED_RECORD_HEADER_SIZE));
+                result = __FAILURE__;
+                break;
+            }
+
+            record.performative_bytes = (record.captured_size > 0) ? bytes + position : NULL;
+            position += record.captured_size;
+
+            on_record(on_record_context, &record);
+        }
+    }
+
+    return result;
+}
+
+int frame_trace_set_capture(FRAME_TRACE_HANDLE frame_trace, FRAME_TRACE_OUTPUT output, void* output_context)
+{
+    int result;
+
+    if (frame_trace == NULL)
+    {
+        /* Codes_SRS_FRAME_TRACE_01_024: [ If `frame_trace` is NULL, `frame_trace_set_capture` shall fail and return a non-zero value. ]*/
+        LogError("NULL frame_trace");
+        result = __FAILURE__;
+    }
+    else if (output == NULL)
+    {
+        /* Codes_SRS_FRAME_TRACE_01_026: [ If `output` is NULL, `frame_trace_set_capture` shall stop the capture and return 0. ]*/
+        frame_trace->capture_output = NULL;
+        frame_trace->capture_output_context = NULL;
+        result = 0;
+    }
+    /* Codes_SRS_FRAME_TRACE_01_023: [ `frame_trace_set_capture` shall pass the capture magic to `output`, make the trace write the bytes given to `frame_trace_capture_bytes` to `output` from then on, and return 0. ]*/
+    else if (output(output_context, frame_capture_magic, sizeof(frame_capture_magic)) != 0)
+    {
+        /* Codes_SRS_FRAME_TRACE_01_025: [ If `output` fails, `frame_trace_set_capture` shall fail, stop any previous capture and return a non-zero value. ]*/
+        LogError("Cannot output the frame capture magic");
+        frame_trace->capture_output = NULL;
+        frame_trace->capture_output_context = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        frame_trace->capture_output = output;
+        frame_trace->capture_output_context = output_context;
+        result = 0;
+    }
+
+    return result;
+}
+
+bool frame_trace_is_capturing(FRAME_TRACE_HANDLE frame_trace)
+{
+    /* Codes_SRS_FRAME_TRACE_01_027: [ `frame_trace_is_capturing` shall return true when a capture output is set on `frame_trace` and false otherwise, `frame_trace` NULL included. ]*/
+    return (frame_trace != NULL) &&
+        (frame_trace->capture_output != NULL);
+}
+
+int frame_trace_capture_bytes(FRAME_TRACE_HANDLE frame_trace, uint64_t timestamp_ms, const unsigned char* bytes, size_t length)
+{
+    int result;
+
+    if ((frame_trace == NULL) ||
+        ((bytes == NULL) && (length > 0)) ||
+        (length > UINT32_MAX))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_029: [ If `frame_trace` is NULL, `bytes` is NULL while `length` is not 0, or `length` does not fit in 32 bits, `frame_trace_capture_bytes` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: frame_trace = %p, bytes = %p, length = %u",
+            frame_trace, bytes, (unsigned int)length);
+        result = __FAILURE__;
+    }
+    else if ((frame_trace->capture_output == NULL) ||
+        (length == 0))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_030: [ If the trace is not capturing or `length` is 0, `frame_trace_capture_bytes` shall do nothing and return 0. ]*/
+        result = 0;
+    }
+    else
+    {
+        unsigned char chunk_header[CAPTURE_CHUNK_HEADER_SIZE];
+
+        write_uint32(chunk_header, (uint32_t)(timestamp_ms >> 32));
+        write_uint32(chunk_header + 4, (uint32_t)timestamp_ms);
+        write_uint32(chunk_header + 8, (uint32_t)length);
+
+        /* Codes_SRS_FRAME_TRACE_01_028: [ `frame_trace_capture_bytes` shall pass to the capture output a chunk made of a 12 byte big endian header (`timestamp_ms` (8), `length` (4)) followed by `bytes`, and return 0. ]*/
+        if ((frame_trace->capture_output(frame_trace->capture_output_context, chunk_header, sizeof(chunk_header)) != 0) ||
+            (frame_trace->capture_output(frame_trace->capture_output_context, bytes, length) != 0))
+        {
+            /* Codes_SRS_FRAME_TRACE_01_031: [ If the capture output fails, `frame_trace_capture_bytes` shall stop the capture and return a non-zero value. ]*/
+            LogError("Cannot output captured bytes, stopping the capture");
+            frame_trace->capture_output = NULL;
+            frame_trace->capture_output_context = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int frame_trace_parse_capture(const unsigned char* bytes, size_t size, ON_FRAME_TRACE_CAPTURE_CHUNK on_chunk, void* on_chunk_context)
+{
+    int result;
+
+    if ((bytes == NULL) ||
+        (on_chunk == NULL))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_033: [ If `bytes` or `on_chunk` is NULL, `frame_trace_parse_capture` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: bytes = %p, on_chunk = %p",
+            bytes, on_chunk);
+        result = __FAILURE__;
+    }
+    else if ((size < sizeof(frame_capture_magic)) ||
+        (memcmp(bytes, frame_capture_magic, sizeof(frame_capture_magic)) != 0))
+    {
+        /* Codes_SRS_FRAME_TRACE_01_034: [ If `bytes` does not start with the capture magic, `frame_trace_parse_capture` shall fail and return a non-zero value. ]*/
+        LogError("Not a frame capture");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t position = sizeof(frame_capture_magic);
+
+        result = 0;
+
+        /* Codes_SRS_FRAME_TRACE_01_032: [ `frame_trace_parse_capture` shall call `on_chunk` with `on_chunk_context` for each chunk written by `frame_trace_capture_bytes`, in the captured order, and return 0. ]*/
+        while (position < size)
+        {
+            uint64_t timestamp_ms;
+            uint32_t length;
+
+            if (size - position < CAPTURE_CHUNK_HEADER_SIZE)
+            {
+                /* Codes_SRS_FRAME_TRACE_01_035: [ If a chunk is truncated, `frame_trace_parse_capture` shall fail and return a non-zero value after reporting the chunks before it. ]*/
+                LogError("Truncated frame capture chunk header at offset %u", (unsigned int)position);
+                result = __FAILURE__;
+                break;
+            }
+
+            timestamp_ms = ((uint64_t)read_uint32(bytes + position) << 32) | read_uint32(bytes + position + 4);
+            length = read_uint32(bytes + position + 8);
+            position += CAPTURE_CHUNK_HEADER_SIZE;
+
+            if (size - position < length)
+            {
+                /* Codes_SRS_FRAME_TRACE_01_035: [ If a chunk is truncated, `frame_trace_parse_capture` shall fail and return a non-zero value after reporting the chunks before it. ]*/
+                LogError("Truncated frame capture chunk at offset %u", (unsigned int)(position - CAPTURE_CHUNK_HEADER_SIZE));
+                result = __FAILURE__;
+                break;
+            }
+
+            on_chunk(on_chunk_context, timestamp_ms, bytes + position, length);
+            position += length;
+        }
+    }
+
+    return result;
+}
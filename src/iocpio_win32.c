@@ -0,0 +1,786 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "winsock2.h"
+#include "ws2tcpip.h"
+#include "windows.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_uamqp_c/iocpio.h"
+
+/* completions dequeued by one GetQueuedCompletionStatusEx call at most */
+#define IOCP_PORT_MAX_COMPLETIONS_PER_CALL 64
+#define IOCPIO_RECEIVE_BUFFER_SIZE 65536
+/* pending sends gathered into one WSASend at most */
+#define IOCPIO_MAX_SEND_BUFFERS 64
+/* how long a destroyed port waits for the completion of each abandoned operation */
+#define IOCP_PORT_ABANDONED_WAIT_MS 1000
+
+typedef struct IOCP_PORT_INSTANCE_TAG
+{
+    HANDLE completion_port;
+    size_t ref_count;
+    size_t abandoned_operation_count;
+} IOCP_PORT_INSTANCE;
+
+typedef enum IO_STATE_TAG
+{
+    IO_STATE_NOT_OPEN,
+    IO_STATE_OPEN,
+    IO_STATE_ERROR,
+    IO_STATE_CLOSED
+} IO_STATE;
+
+typedef struct PENDING_SEND_TAG
+{
+    struct PENDING_SEND_TAG* next;
+    size_t size;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    /* the bytes follow in the same allocation */
+} PENDING_SEND;
+
+typedef struct RECEIVE_OPERATION_TAG
+{
+    IOCP_OPERATION operation;
+    unsigned char buffer[IOCPIO_RECEIVE_BUFFER_SIZE];
+} RECEIVE_OPERATION;
+
+typedef struct SEND_OPERATION_TAG
+{
+    IOCP_OPERATION operation;
+    WSABUF buffers[IOCPIO_MAX_SEND_BUFFERS];
+    /* the sends carried by the operation, they stay with it until its completion */
+    PENDING_SEND* sends;
+    size_t total_size;
+} SEND_OPERATION;
+
+typedef struct IOCPIO_INSTANCE_TAG
+{
+    SOCKET socket;
+    IOCP_PORT_HANDLE iocp_port;
+    IO_STATE io_state;
+    RECEIVE_OPERATION* receive_operation;
+    bool is_receive_posted;
+    SEND_OPERATION* send_operation;
+    PENDING_SEND* pending_sends_head;
+    PENDING_SEND* pending_sends_tail;
+    ON_BYTES_RECEIVED on_bytes_received;
+    ON_IO_ERROR on_io_error;
+    void* on_bytes_received_context;
+    void* on_io_error_context;
+} IOCPIO_INSTANCE;
+
+static void on_abandoned_operation_complete(void* context, IOCP_OPERATION* operation, bool succeeded, DWORD bytes_transferred)
+{
+    IOCP_PORT_INSTANCE* iocp_port = (IOCP_PORT_INSTANCE*)context;
+
+    (void)succeeded;
+    (void)bytes_transferred;
+
+    iocp_port->abandoned_operation_count--;
+    free(operation);
+}
+
+static void on_abandoned_send_complete(void* context, IOCP_OPERATION* operation, bool succeeded, DWORD bytes_transferred)
+{
+    PENDING_SEND* sends = ((SEND_OPERATION*)operation)->sends;
+
+    while (sends != NULL)
+    {
+        PENDING_SEND* pending_send = sends;
+        sends = pending_send->next;
+        free(pending_send);
+    }
+
+    on_abandoned_operation_complete(context, operation, succeeded, bytes_transferred);
+}
+
+static int dequeue_completions(IOCP_PORT_INSTANCE* iocp_port, DWORD timeout_ms, ULONG* dequeued_count)
+{
+    int result;
+    OVERLAPPED_ENTRY entries[IOCP_PORT_MAX_COMPLETIONS_PER_CALL];
+    ULONG entry_count;
+
+    /* one call takes every completion that is ready, for all the sockets of the port */
+    if (!GetQueuedCompletionStatusEx(iocp_port->completion_port, entries, IOCP_PORT_MAX_COMPLETIONS_PER_CALL, &entry_count, timeout_ms, FALSE))
+    {
+        *dequeued_count = 0;
+        if (GetLastError() == WAIT_TIMEOUT)
+        {
+            result = 0;
+        }
+        else
+        {
+            LogError("GetQueuedCompletionStatusEx failed, error=%lu", (unsigned long)GetLastError());
+            result = __FAILURE__;
+        }
+    }
+    else
+    {
+        ULONG i;
+
+        for (i = 0; i < entry_count; i++)
+        {
+            IOCP_OPERATION* operation = (IOCP_OPERATION*)entries[i].lpOverlapped;
+
+            /* Internal holds the status of the operation, 0 when it succeeded */
+            operation->on_operation_complete(operation->context, operation, operation->overlapped.Internal == 0, entries[i].dwNumberOfBytesTransferred);
+        }
+
+        *dequeued_count = entry_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+IOCP_PORT_HANDLE iocp_port_create(void)
+{
+    IOCP_PORT_INSTANCE* result = (IOCP_PORT_INSTANCE*)malloc(sizeof(IOCP_PORT_INSTANCE));
+    if (result == NULL)
+    {
+        LogError("Cannot allocate memory for the completion port");
+    }
+    else
+    {
+        /* one thread drains the port */
+        result->completion_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+        if (result->completion_port == NULL)
+        {
+            LogError("CreateIoCompletionPort failed, error=%lu", (unsigned long)GetLastError());
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->ref_count = 1;
+            result->abandoned_operation_count = 0;
+        }
+    }
+
+    return result;
+}
+
+IOCP_PORT_HANDLE iocp_port_clone(IOCP_PORT_HANDLE iocp_port)
+{
+    if (iocp_port == NULL)
+    {
+        LogError("NULL iocp_port");
+    }
+    else
+    {
+        iocp_port->ref_count++;
+    }
+
+    return iocp_port;
+}
+
+void iocp_port_destroy(IOCP_PORT_HANDLE iocp_port)
+{
+    if (iocp_port == NULL)
+    {
+        LogError("NULL iocp_port");
+    }
+    else
+    {
+        iocp_port->ref_count--;
+        if (iocp_port->ref_count == 0)
+        {
+            /* the sockets are closed by now, so the abandoned operations complete shortly, and their memory is only free after that */
+            while (iocp_port->abandoned_operation_count > 0)
+            {
+                ULONG dequeued_count;
+
+                if ((dequeue_completions(iocp_port, IOCP_PORT_ABANDONED_WAIT_MS, &dequeued_count) != 0) ||
+                    (dequeued_count == 0))
+                {
+                    LogError("%u abandoned operations did not complete", (unsigned int)iocp_port->abandoned_operation_count);
+                    break;
+                }
+            }
+
+            (void)CloseHandle(iocp_port->completion_port);
+            free(iocp_port);
+        }
+    }
+}
+
+int iocp_port_associate(IOCP_PORT_HANDLE iocp_port, SOCKET socket)
+{
+    int result;
+
+    if ((iocp_port == NULL) ||
+        (socket == INVALID_SOCKET))
+    {
+        LogError("Bad arguments: iocp_port = %p, socket is %s",
+            iocp_port, (socket == INVALID_SOCKET) ? "invalid" : "valid");
+        result = __FAILURE__;
+    }
+    else if (CreateIoCompletionPort((HANDLE)socket, iocp_port->completion_port, 0, 0) == NULL)
+    {
+        LogError("Cannot associate the socket with the completion port, error=%lu", (unsigned long)GetLastError());
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+void iocp_port_abandon_operation(IOCP_PORT_HANDLE iocp_port, IOCP_OPERATION* operation)
+{
+    if ((iocp_port == NULL) ||
+        (operation == NULL))
+    {
+        LogError("Bad arguments: iocp_port = %p, operation = %p",
+            iocp_port, operation);
+    }
+    else
+    {
+        operation->on_operation_complete = on_abandoned_operation_complete;
+        operation->context = iocp_port;
+        iocp_port->abandoned_operation_count++;
+    }
+}
+
+int iocp_port_dowork(IOCP_PORT_HANDLE iocp_port, unsigned int timeout_ms)
+{
+    int result;
+
+    if (iocp_port == NULL)
+    {
+        LogError("NULL iocp_port");
+        result = __FAILURE__;
+    }
+    else
+    {
+        ULONG dequeued_count;
+
+        /* a callback may destroy the last io on the port */
+        iocp_port->ref_count++;
+
+        if (dequeue_completions(iocp_port, (DWORD)timeout_ms, &dequeued_count) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        iocp_port_destroy(iocp_port);
+    }
+
+    return result;
+}
+
+static void indicate_error(IOCPIO_INSTANCE* iocp_io)
+{
+    iocp_io->io_state = IO_STATE_ERROR;
+    iocp_io->on_io_error(iocp_io->on_io_error_context);
+}
+
+static void complete_sends(PENDING_SEND* sends, IO_SEND_RESULT send_result)
+{
+    while (sends != NULL)
+    {
+        PENDING_SEND* pending_send = sends;
+        sends = pending_send->next;
+
+        if (pending_send->on_send_complete != NULL)
+        {
+            pending_send->on_send_complete(pending_send->callback_context, send_result);
+        }
+
+        free(pending_send);
+    }
+}
+
+static int post_receive(IOCPIO_INSTANCE* iocp_io);
+
+static void on_receive_complete(void* context, IOCP_OPERATION* operation, bool succeeded, DWORD bytes_transferred)
+{
+    IOCPIO_INSTANCE* iocp_io = (IOCPIO_INSTANCE*)context;
+
+    (void)operation;
+
+    iocp_io->is_receive_posted = false;
+    if (iocp_io->io_state == IO_STATE_OPEN)
+    {
+        if (!succeeded)
+        {
+            LogError("Receive failed");
+            indicate_error(iocp_io);
+        }
+        else if (bytes_transferred == 0)
+        {
+            LogError("The connection was closed by the peer");
+            indicate_error(iocp_io);
+        }
+        else
+        {
+            iocp_io->on_bytes_received(iocp_io->on_bytes_received_context, iocp_io->receive_operation->buffer, bytes_transferred);
+
+            /* the callback may have closed the io */
+            if ((iocp_io->io_state == IO_STATE_OPEN) &&
+                (post_receive(iocp_io) != 0))
+            {
+                indicate_error(iocp_io);
+            }
+        }
+    }
+}
+
+static void on_send_complete(void* context, IOCP_OPERATION* operation, bool succeeded, DWORD bytes_transferred)
+{
+    IOCPIO_INSTANCE* iocp_io = (IOCPIO_INSTANCE*)context;
+    SEND_OPERATION* send_operation = (SEND_OPERATION*)operation;
+    PENDING_SEND* sends = send_operation->sends;
+    bool is_complete = succeeded && (bytes_transferred == send_operation->total_size);
+
+    iocp_io->send_operation = NULL;
+    free(send_operation);
+
+    /* an overlapped send on a stream socket takes everything or fails */
+    complete_sends(sends, is_complete ? IO_SEND_OK : IO_SEND_ERROR);
+
+    if ((!is_complete) &&
+        (iocp_io->io_state == IO_STATE_OPEN))
+    {
+        LogError("Send failed");
+        indicate_error(iocp_io);
+    }
+}
+
+static int post_receive(IOCPIO_INSTANCE* iocp_io)
+{
+    int result;
+    WSABUF buffer;
+    DWORD flags = 0;
+
+    (void)memset(&iocp_io->receive_operation->operation.overlapped, 0, sizeof(OVERLAPPED));
+    buffer.buf = (char*)iocp_io->receive_operation->buffer;
+    buffer.len = IOCPIO_RECEIVE_BUFFER_SIZE;
+
+    /* a receive that completes right away is still delivered through the port */
+    if ((WSARecv(iocp_io->socket, &buffer, 1, NULL, &flags, &iocp_io->receive_operation->operation.overlapped, NULL) == SOCKET_ERROR) &&
+        (WSAGetLastError() != WSA_IO_PENDING))
+    {
+        LogError("WSARecv failed, error=%d", WSAGetLastError());
+        result = __FAILURE__;
+    }
+    else
+    {
+        iocp_io->is_receive_posted = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int post_send(IOCPIO_INSTANCE* iocp_io)
+{
+    int result;
+    SEND_OPERATION* send_operation = (SEND_OPERATION*)malloc(sizeof(SEND_OPERATION));
+
+    if (send_operation == NULL)
+    {
+        LogError("Cannot allocate memory for the send operation");
+        result = __FAILURE__;
+    }
+    else
+    {
+        PENDING_SEND* last_send = NULL;
+        DWORD buffer_count = 0;
+
+        (void)memset(&send_operation->operation.overlapped, 0, sizeof(OVERLAPPED));
+        send_operation->operation.on_operation_complete = on_send_complete;
+        send_operation->operation.context = iocp_io;
+        send_operation->sends = iocp_io->pending_sends_head;
+        send_operation->total_size = 0;
+
+        /* everything queued since the last dowork (the encoded frames of the connection) goes as one WSASend */
+        while ((iocp_io->pending_sends_head != NULL) &&
+            (buffer_count < IOCPIO_MAX_SEND_BUFFERS))
+        {
+            last_send = iocp_io->pending_sends_head;
+            send_operation->buffers[buffer_count].buf = (char*)(last_send + 1);
+            send_operation->buffers[buffer_count].len = (ULONG)last_send->size;
+            send_operation->total_size += last_send->size;
+            buffer_count++;
+            iocp_io->pending_sends_head = last_send->next;
+        }
+
+        last_send->next = NULL;
+        if (iocp_io->pending_sends_head == NULL)
+        {
+            iocp_io->pending_sends_tail = NULL;
+        }
+
+        if ((WSASend(iocp_io->socket, send_operation->buffers, buffer_count, NULL, 0, &send_operation->operation.overlapped, NULL) == SOCKET_ERROR) &&
+            (WSAGetLastError() != WSA_IO_PENDING))
+        {
+            LogError("WSASend failed, error=%d", WSAGetLastError());
+            complete_sends(send_operation->sends, IO_SEND_ERROR);
+            free(send_operation);
+            result = __FAILURE__;
+        }
+        else
+        {
+            iocp_io->send_operation = send_operation;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void close_socket(IOCPIO_INSTANCE* iocp_io)
+{
+    /* closing the socket cancels what is posted, the operations are left to the port since the kernel may still use their memory */
+    (void)closesocket(iocp_io->socket);
+    iocp_io->socket = INVALID_SOCKET;
+
+    if (iocp_io->is_receive_posted)
+    {
+        iocp_port_abandon_operation(iocp_io->iocp_port, &iocp_io->receive_operation->operation);
+        iocp_io->receive_operation = NULL;
+        iocp_io->is_receive_posted = false;
+    }
+
+    if (iocp_io->send_operation != NULL)
+    {
+        PENDING_SEND* pending_send;
+
+        /* the callbacks are told now, the bytes stay with the operation until the kernel is done with them */
+        for (pending_send = iocp_io->send_operation->sends; pending_send != NULL; pending_send = pending_send->next)
+        {
+            if (pending_send->on_send_complete != NULL)
+            {
+                pending_send->on_send_complete(pending_send->callback_context, IO_SEND_CANCELLED);
+                pending_send->on_send_complete = NULL;
+            }
+        }
+
+        iocp_port_abandon_operation(iocp_io->iocp_port, &iocp_io->send_operation->operation);
+        iocp_io->send_operation->operation.on_operation_complete = on_abandoned_send_complete;
+        iocp_io->send_operation = NULL;
+    }
+}
+
+static void* iocpio_clone_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+    return NULL;
+}
+
+static void iocpio_destroy_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+}
+
+static int iocpio_setoption(CONCRETE_IO_HANDLE iocp_io, const char* option_name, const void* value)
+{
+    (void)value;
+
+    if ((iocp_io == NULL) ||
+        (option_name == NULL))
+    {
+        LogError("Bad arguments: iocp_io = %p, option_name = %p",
+            iocp_io, option_name);
+    }
+    else
+    {
+        LogError("Unknown option: %s", option_name);
+    }
+
+    return __FAILURE__;
+}
+
+static OPTIONHANDLER_HANDLE iocpio_retrieveoptions(CONCRETE_IO_HANDLE iocp_io)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (iocp_io == NULL)
+    {
+        LogError("NULL iocp_io");
+        result = NULL;
+    }
+    else
+    {
+        /* there are no options to carry over */
+        result = OptionHandler_Create(iocpio_clone_option, iocpio_destroy_option, iocpio_setoption);
+        if (result == NULL)
+        {
+            LogError("unable to OptionHandler_Create");
+        }
+    }
+
+    return result;
+}
+
+static CONCRETE_IO_HANDLE iocpio_create(void* io_create_parameters)
+{
+    IOCPIO_INSTANCE* result;
+    IOCPIO_CONFIG* iocp_io_config = (IOCPIO_CONFIG*)io_create_parameters;
+
+    if ((iocp_io_config == NULL) ||
+        (iocp_io_config->accepted_socket == NULL) ||
+        (iocp_io_config->iocp_port == NULL))
+    {
+        /* there is no connect, the io only takes accepted sockets */
+        LogError("Bad arguments: iocp_io_config = %p", iocp_io_config);
+        result = NULL;
+    }
+    else
+    {
+        result = (IOCPIO_INSTANCE*)malloc(sizeof(IOCPIO_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for the completion port io");
+        }
+        else if ((result->receive_operation = (RECEIVE_OPERATION*)malloc(sizeof(RECEIVE_OPERATION))) == NULL)
+        {
+            LogError("Cannot allocate memory for the receive operation");
+            free(result);
+            result = NULL;
+        }
+        else if (iocp_port_associate(iocp_io_config->iocp_port, *(SOCKET*)iocp_io_config->accepted_socket) != 0)
+        {
+            /* as with socketio, the socket stays with the caller when create fails */
+            LogError("Cannot associate the accepted socket with the completion port");
+            free(result->receive_operation);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->socket = *(SOCKET*)iocp_io_config->accepted_socket;
+            result->iocp_port = iocp_port_clone(iocp_io_config->iocp_port);
+            result->io_state = IO_STATE_NOT_OPEN;
+            result->receive_operation->operation.on_operation_complete = on_receive_complete;
+            result->receive_operation->operation.context = result;
+            result->is_receive_posted = false;
+            result->send_operation = NULL;
+            result->pending_sends_head = NULL;
+            result->pending_sends_tail = NULL;
+            result->on_bytes_received = NULL;
+            result->on_io_error = NULL;
+            result->on_bytes_received_context = NULL;
+            result->on_io_error_context = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void iocpio_destroy(CONCRETE_IO_HANDLE iocp_io)
+{
+    if (iocp_io == NULL)
+    {
+        LogError("NULL iocp_io");
+    }
+    else
+    {
+        IOCPIO_INSTANCE* iocp_io_instance = (IOCPIO_INSTANCE*)iocp_io;
+
+        if (iocp_io_instance->socket != INVALID_SOCKET)
+        {
+            close_socket(iocp_io_instance);
+        }
+
+        complete_sends(iocp_io_instance->pending_sends_head, IO_SEND_CANCELLED);
+        if (iocp_io_instance->receive_operation != NULL)
+        {
+            free(iocp_io_instance->receive_operation);
+        }
+
+        iocp_port_destroy(iocp_io_instance->iocp_port);
+        free(iocp_io_instance);
+    }
+}
+
+static int iocpio_open(CONCRETE_IO_HANDLE iocp_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    IOCPIO_INSTANCE* iocp_io_instance = (IOCPIO_INSTANCE*)iocp_io;
+
+    if ((iocp_io == NULL) ||
+        (on_bytes_received == NULL) ||
+        (on_io_error == NULL))
+    {
+        LogError("Bad arguments: iocp_io = %p, on_bytes_received = %p, on_io_error = %p",
+            iocp_io, on_bytes_received, on_io_error);
+        result = __FAILURE__;
+    }
+    else if (iocp_io_instance->io_state != IO_STATE_NOT_OPEN)
+    {
+        /* the accepted socket is closed with the io, so it is opened once */
+        LogError("The io is already open or was closed");
+        result = __FAILURE__;
+    }
+    else
+    {
+        iocp_io_instance->on_bytes_received = on_bytes_received;
+        iocp_io_instance->on_bytes_received_context = on_bytes_received_context;
+        iocp_io_instance->on_io_error = on_io_error;
+        iocp_io_instance->on_io_error_context = on_io_error_context;
+
+        if (post_receive(iocp_io_instance) != 0)
+        {
+            LogError("Cannot post the first receive");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* the socket is connected already */
+            iocp_io_instance->io_state = IO_STATE_OPEN;
+            if (on_io_open_complete != NULL)
+            {
+                on_io_open_complete(on_io_open_complete_context, IO_OPEN_OK);
+            }
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int iocpio_close(CONCRETE_IO_HANDLE iocp_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+    IOCPIO_INSTANCE* iocp_io_instance = (IOCPIO_INSTANCE*)iocp_io;
+
+    if (iocp_io == NULL)
+    {
+        LogError("NULL iocp_io");
+        result = __FAILURE__;
+    }
+    else if ((iocp_io_instance->io_state != IO_STATE_OPEN) &&
+        (iocp_io_instance->io_state != IO_STATE_ERROR))
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        PENDING_SEND* pending_sends = iocp_io_instance->pending_sends_head;
+
+        iocp_io_instance->io_state = IO_STATE_CLOSED;
+        close_socket(iocp_io_instance);
+
+        iocp_io_instance->pending_sends_head = NULL;
+        iocp_io_instance->pending_sends_tail = NULL;
+        complete_sends(pending_sends, IO_SEND_CANCELLED);
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int iocpio_send(CONCRETE_IO_HANDLE iocp_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    IOCPIO_INSTANCE* iocp_io_instance = (IOCPIO_INSTANCE*)iocp_io;
+
+    if ((iocp_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        LogError("Bad arguments: iocp_io = %p, buffer = %p, size = %u",
+            iocp_io, buffer, (unsigned int)size);
+        result = __FAILURE__;
+    }
+    else if (iocp_io_instance->io_state != IO_STATE_OPEN)
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + size);
+        if (pending_send == NULL)
+        {
+            LogError("Cannot allocate memory for the send");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* only queued, the next dowork posts it with whatever else was queued meanwhile */
+            (void)memcpy(pending_send + 1, buffer, size);
+            pending_send->next = NULL;
+            pending_send->size = size;
+            pending_send->on_send_complete = on_send_complete;
+            pending_send->callback_context = callback_context;
+
+            if (iocp_io_instance->pending_sends_tail == NULL)
+            {
+                iocp_io_instance->pending_sends_head = pending_send;
+            }
+            else
+            {
+                iocp_io_instance->pending_sends_tail->next = pending_send;
+            }
+            iocp_io_instance->pending_sends_tail = pending_send;
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void iocpio_dowork(CONCRETE_IO_HANDLE iocp_io)
+{
+    if (iocp_io == NULL)
+    {
+        LogError("NULL iocp_io");
+    }
+    else
+    {
+        IOCPIO_INSTANCE* iocp_io_instance = (IOCPIO_INSTANCE*)iocp_io;
+
+        /* completions are delivered by iocp_port_dowork, here the queued sends are only posted, one WSASend in flight at a time */
+        if ((iocp_io_instance->io_state == IO_STATE_OPEN) &&
+            (iocp_io_instance->send_operation == NULL) &&
+            (iocp_io_instance->pending_sends_head != NULL) &&
+            (post_send(iocp_io_instance) != 0))
+        {
+            indicate_error(iocp_io_instance);
+        }
+    }
+}
+
+static const IO_INTERFACE_DESCRIPTION iocpio_interface_description =
+{
+    iocpio_retrieveoptions,
+    iocpio_create,
+    iocpio_destroy,
+    iocpio_open,
+    iocpio_close,
+    iocpio_send,
+    iocpio_dowork,
+    iocpio_setoption
+};
+
+const IO_INTERFACE_DESCRIPTION* iocpio_get_interface_description(void)
+{
+    return &iocpio_interface_description;
+}
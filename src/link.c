@@ -8,16 +8,45 @@
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/link.h"
 #include "azure_uamqp_c/session.h"
 #include "azure_uamqp_c/amqpvalue.h"
 #include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/amqp_performative_fields.h"
 #include "azure_uamqp_c/amqp_frame_codec.h"
+#include "azure_uamqp_c/messaging.h"
 #include "azure_uamqp_c/async_operation.h"
+#include "azure_uamqp_c/uamqp_tracepoints.h"
+#include "azure_uamqp_c/uamqp_static_pools.h"
+
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_LINK
+#include "azure_uamqp_c/alloc_counters.h"
 
 #define DEFAULT_LINK_CREDIT 10000
+#ifdef UAMQP_STATIC_POOLS
+/* the pending deliveries and their operations are allocated once for the static capacity */
+#define PENDING_DELIVERIES_INITIAL_CAPACITY UAMQP_STATIC_MAX_PENDING_DELIVERIES
+#define DELIVERY_OPERATION_POOL_SIZE UAMQP_STATIC_MAX_PENDING_DELIVERIES
+#else
+#define PENDING_DELIVERIES_INITIAL_CAPACITY 16
+#define DELIVERY_OPERATION_POOL_SIZE 256
+#endif
+#define DEFAULT_DELIVERY_TAG_LENGTH 4
+#define MAX_DELIVERY_TAG_LENGTH LINK_MAX_DELIVERY_TAG_LENGTH
+#define RETAINED_RECEIVED_PAYLOAD_CAPACITY (64 * 1024)
+/* role, the settle modes and the other attach fields that are not kept encoded, at their largest */
+#define ATTACH_FIELDS_MAX_SIZE 32
+
+/* the handover state is a list of the version, the handles and the flow state of the link */
+#define LINK_HANDOVER_STATE_VERSION 1
+#define LINK_HANDOVER_STATE_FIELD_COUNT 12
+/* outcomes whose dispositions are batched, the ones carrying no fields */
+#define BATCHED_OUTCOME_ACCEPTED 0
+#define BATCHED_OUTCOME_RELEASED 1
+#define BATCHED_OUTCOME_COUNT 2
+#define MIN_DISPOSITION_WINDOW_SIZE 32
+#define MAX_DISPOSITION_WINDOW_SIZE (64 * 1024)
 
 typedef struct DELIVERY_INSTANCE_TAG
 {
@@ -29,864 +58,2389 @@ typedef struct DELIVERY_INSTANCE_TAG
     tickcounter_ms_t timeout;
 } DELIVERY_INSTANCE;
 
+/* a received delivery that the application has not settled yet, and the bytes it counts against the buffered bytes budget */
+typedef struct UNSETTLED_RECEIVED_DELIVERY_TAG
+{
+    uint64_t bytes;
+    delivery_number delivery_id;
+} UNSETTLED_RECEIVED_DELIVERY;
+
+/* Gateways can hold very many mostly idle links, so a link keeps its source and target encoded, shares its name with
+its endpoint, only allocates its pending deliveries with the first transfer and keeps its small fields together. */
 typedef struct LINK_INSTANCE_TAG
 {
-    SESSION_HANDLE session;
+    /* hot: touched by every transfer received or sent, kept together in the first cache lines */
     LINK_STATE link_state;
-    LINK_STATE previous_link_state;
-    AMQP_VALUE source;
-    AMQP_VALUE target;
-    handle handle;
-    LINK_ENDPOINT_HANDLE link_endpoint;
-    char* name;
-    SINGLYLINKEDLIST_HANDLE pending_deliveries;
-    sequence_no delivery_count;
     role role;
-    ON_LINK_STATE_CHANGED on_link_state_changed;
-    ON_LINK_FLOW_ON on_link_flow_on;
-    ON_TRANSFER_RECEIVED on_transfer_received;
-    void* callback_context;
     sender_settle_mode snd_settle_mode;
     receiver_settle_mode rcv_settle_mode;
-    sequence_no initial_delivery_count;
-    uint64_t max_message_size;
-    uint64_t peer_max_message_size;
     uint32_t current_link_credit;
-    uint32_t max_link_credit;
-    uint32_t available;
-    fields attach_properties;
-    bool is_underlying_session_begun;
-    bool is_closed;
+    sequence_no delivery_count;
+    LINK_ENDPOINT_HANDLE link_endpoint;
+    ON_TRANSFER_RECEIVED on_transfer_received;
+    ON_TRANSFER_FRAME_RECEIVED on_transfer_frame_received;
+    void* callback_context;
     unsigned char* received_payload;
     uint32_t received_payload_size;
+    uint32_t received_payload_capacity;
     delivery_number received_delivery_id;
+    bool is_received_delivery_settled;
+    bool is_receiving_streamed_delivery;
+    /* the rest of a delivery rejected for exceeding max_message_size is dropped as it arrives */
+    bool is_discarding_delivery;
+    /* a transfer was refused for lack of credit and no flow gave credit since */
+    bool is_credit_exhausted;
+    /* ring of outstanding deliveries indexed by the delivery id offset from the oldest pending delivery id */
+    ASYNC_OPERATION_HANDLE* pending_deliveries;
+    uint32_t pending_delivery_capacity;
+    uint32_t pending_delivery_head;
+    uint32_t pending_delivery_span;
+    delivery_number oldest_pending_delivery_id;
+    /* created on the first transfer, keeps the memory of settled deliveries for the next ones */
+    ASYNC_OPERATION_POOL_HANDLE delivery_operation_pool;
+    /* the delivery being sent in parts with link_transfer_stream_async, no other transfer is sent until it ends */
+    ASYNC_OPERATION_HANDLE streamed_delivery;
+    /* carried by every transfer started while it is set, e.g. the transactional-state of a transaction */
+    AMQP_VALUE transfer_state;
+    /* 8 byte delivery tags carry this 64 bit count of transfers, so they do not wrap with delivery_count */
+    uint64_t transfer_count;
+    uint32_t delivery_tag_length;
+    uint32_t max_link_credit;
+    uint64_t max_message_size;
+    uint64_t peer_max_message_size;
+    /* bytes received and not settled yet, credit is held back while they are over resume_buffered_bytes */
+    uint64_t max_buffered_bytes;
+    uint64_t buffered_bytes;
+    uint64_t received_delivery_bytes;
+    /* counted for every transfer, right after the hot fields */
+    LINK_STATS stats;
+
+    /* warm: per flow, per disposition or per settled delivery */
+    SESSION_HANDLE session;
+    /* the received payload is charged against its memory quota, NULL if it could not be obtained */
+    CONNECTION_HANDLE connection;
+    /* called once all the deliveries settled by a received disposition have been indicated */
+    ON_LINK_DISPOSITION_PROCESSED on_disposition_processed;
+    ON_LINK_FLOW_ON on_link_flow_on;
+    handle handle;
+    uint32_t credit_low_water_mark;
+    uint32_t available;
+    LINK_CREDIT_POLICY credit_policy;
+    bool is_flow_paused;
+    bool is_draining;
+    bool is_credit_held;
+    uint64_t resume_buffered_bytes;
+    uint64_t average_delivery_size;
+    /* ordered by delivery id, only kept while a buffered bytes budget is set */
+    UNSETTLED_RECEIVED_DELIVERY* unsettled_received_deliveries;
+    uint32_t unsettled_received_count;
+    uint32_t unsettled_received_capacity;
+    /* accepted and released deliveries are settled by as few dispositions as there are ranges of consecutive ids per outcome */
+    uint32_t disposition_batch_size;
+    uint32_t disposition_window_size;
+    uint32_t batched_disposition_count;
+    delivery_number batched_disposition_first;
+    delivery_number batched_disposition_last;
+    /* one per batched outcome, NULL while no delivery with that outcome is batched */
+    AMQP_VALUE batched_disposition_states[BATCHED_OUTCOME_COUNT];
+    /* a bit per delivery id for each batched outcome, delivery id i being bit i % disposition_window_size, so that deliveries
+       settled out of order are grouped in ranges as long as batched_disposition_first..batched_disposition_last fits the window */
+    uint32_t* batched_disposition_bits;
     TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t disposition_batch_max_delay;
+    tickcounter_ms_t batched_disposition_start_tick;
+
+    /* cold: configuration and callbacks only used when attaching, detaching or draining */
+    ON_LINK_STATE_CHANGED on_link_state_changed;
+    ON_LINK_DRAINED on_link_drained;
+    void* on_link_drained_context;
+    tickcounter_ms_t drain_timeout;
+    tickcounter_ms_t drain_start_tick;
+    LINK_STATE previous_link_state;
+    sequence_no initial_delivery_count;
+    /* the source followed by the target, encoded, copied as they are into every attach */
+    unsigned char* encoded_terminus;
+    uint32_t encoded_source_size;
+    uint32_t encoded_target_size;
+    /* encoded once when they are set, like the source and target */
+    unsigned char* encoded_attach_properties;
+    uint32_t encoded_attach_properties_size;
+    bool is_underlying_session_begun;
+    bool is_closed;
+    /* delivery tag to delivery state maps exchanged on attach to resume deliveries, see AMQP 1.0 section 3.4 */
+    AMQP_VALUE unsettled;
+    AMQP_VALUE peer_unsettled;
+    /* restored from a handover state, the link is attached again without an attach when its session is mapped */
+    bool is_resuming_handover;
 } LINK_INSTANCE;
 
 DEFINE_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE);
 
+static void report_flow_event(LINK_INSTANCE* link, CONNECTION_FLOW_EVENT event, uint64_t value)
+{
+    const char* link_name;
+
+    if (session_get_link_endpoint_name(link->link_endpoint, &link_name) != 0)
+    {
+        link_name = NULL;
+    }
+
+    connection_report_flow_event(link->connection, event, link, link_name, value);
+}
+
+/* the observer of the connection hears about the first refused transfer only, until a flow gives credit again */
+static void count_credit_stall(LINK_INSTANCE* link)
+{
+    link->stats.credit_stalls++;
+
+    if (!link->is_credit_exhausted)
+    {
+        link->is_credit_exhausted = true;
+        report_flow_event(link, CONNECTION_FLOW_EVENT_LINK_CREDIT_EXHAUSTED, 0);
+    }
+}
+
 static void set_link_state(LINK_INSTANCE* link_instance, LINK_STATE link_state)
 {
     link_instance->previous_link_state = link_instance->link_state;
     link_instance->link_state = link_state;
 
+    /* the credit of a drain does not outlive the attachment, the owner learns about the drain ending from the state change */
+    if ((link_state != LINK_STATE_ATTACHED) &&
+        (link_state != LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED))
+    {
+        link_instance->is_draining = false;
+    }
+
     if (link_instance->on_link_state_changed != NULL)
     {
         link_instance->on_link_state_changed(link_instance->callback_context, link_state, link_instance->previous_link_state);
     }
 }
 
-static void remove_all_pending_deliveries(LINK_INSTANCE* link, bool indicate_settled)
+static ASYNC_OPERATION_HANDLE* get_pending_delivery_slot(LINK_INSTANCE* link, delivery_number delivery_id)
 {
-    if (link->pending_deliveries != NULL)
-    {
-        LIST_ITEM_HANDLE item = singlylinkedlist_get_head_item(link->pending_deliveries);
-        while (item != NULL)
-        {
-            LIST_ITEM_HANDLE next_item = singlylinkedlist_get_next_item(item);
-            ASYNC_OPERATION_HANDLE pending_delivery_operation = (ASYNC_OPERATION_HANDLE)singlylinkedlist_item_get_value(item);
-            if (pending_delivery_operation != NULL)
-            {
-                DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
-                if (indicate_settled && (delivery_instance->on_delivery_settled != NULL))
-                {
-                    delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_NOT_DELIVERED, NULL);
-                }
-
-                async_operation_destroy(pending_delivery_operation);
-            }
-
-            item = next_item;
-        }
+    ASYNC_OPERATION_HANDLE* result;
+    uint32_t offset = delivery_id - link->oldest_pending_delivery_id;
 
-        singlylinkedlist_destroy(link->pending_deliveries);
-        link->pending_deliveries = NULL;
+    if (offset >= link->pending_delivery_span)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = &link->pending_deliveries[(link->pending_delivery_head + offset) & (link->pending_delivery_capacity - 1)];
     }
+
+    return result;
 }
 
-static int send_flow(LINK_INSTANCE* link)
+static int add_pending_delivery(LINK_INSTANCE* link, ASYNC_OPERATION_HANDLE pending_delivery_operation)
 {
     int result;
-    FLOW_HANDLE flow = flow_create(0, 0, 0);
+    DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
+    uint32_t offset = (link->pending_delivery_span == 0) ? 0 : (delivery_instance->delivery_id - link->oldest_pending_delivery_id);
 
-    if (flow == NULL)
+    /* delivery ids are assigned in increasing order by the session, deliveries of other links on the same session leave empty slots */
+    if ((link->pending_delivery_span != 0) &&
+        ((offset < link->pending_delivery_span) || (offset > INT32_MAX)))
     {
-        LogError("NULL flow performative");
+        LogError("Delivery id %u is not newer than the pending deliveries", (unsigned int)delivery_instance->delivery_id);
         result = __FAILURE__;
     }
     else
     {
-        if (flow_set_link_credit(flow, link->current_link_credit) != 0)
-        {
-            LogError("Cannot set link credit on flow performative");
-            result = __FAILURE__;
-        }
-        else if (flow_set_handle(flow, link->handle) != 0)
-        {
-            LogError("Cannot set handle on flow performative");
-            result = __FAILURE__;
-        }
-        else if (flow_set_delivery_count(flow, link->delivery_count) != 0)
-        {
-            LogError("Cannot set delivery count on flow performative");
-            result = __FAILURE__;
-        }
-        else
+        if (offset >= link->pending_delivery_capacity)
         {
-            if (session_send_flow(link->link_endpoint, flow) != 0)
+            uint32_t new_capacity = (link->pending_delivery_capacity == 0) ? PENDING_DELIVERIES_INITIAL_CAPACITY : link->pending_delivery_capacity;
+            ASYNC_OPERATION_HANDLE* new_pending_deliveries;
+
+            while (new_capacity <= offset)
+            {
+                new_capacity *= 2;
+            }
+
+            if (new_capacity > SIZE_MAX / sizeof(ASYNC_OPERATION_HANDLE))
+            {
+                new_pending_deliveries = NULL;
+            }
+            else
+            {
+                new_pending_deliveries = (ASYNC_OPERATION_HANDLE*)malloc(sizeof(ASYNC_OPERATION_HANDLE) * new_capacity);
+            }
+
+            if (new_pending_deliveries == NULL)
             {
-                LogError("Sending flow frame failed in session send");
+                LogError("Cannot allocate memory for pending deliveries");
                 result = __FAILURE__;
             }
             else
             {
+                uint32_t i;
+
+                /* unwrap the ring so that the oldest pending delivery lands in slot 0 */
+                for (i = 0; i < link->pending_delivery_span; i++)
+                {
+                    new_pending_deliveries[i] = link->pending_deliveries[(link->pending_delivery_head + i) & (link->pending_delivery_capacity - 1)];
+                }
+
+                (void)memset(new_pending_deliveries + link->pending_delivery_span, 0, sizeof(ASYNC_OPERATION_HANDLE) * (new_capacity - link->pending_delivery_span));
+
+                free(link->pending_deliveries);
+                link->pending_deliveries = new_pending_deliveries;
+                link->pending_delivery_capacity = new_capacity;
+                link->pending_delivery_head = 0;
                 result = 0;
             }
         }
+        else
+        {
+            result = 0;
+        }
+
+        if (result == 0)
+        {
+            if (link->pending_delivery_span == 0)
+            {
+                link->oldest_pending_delivery_id = delivery_instance->delivery_id;
+            }
 
-        flow_destroy(flow);
+            link->pending_deliveries[(link->pending_delivery_head + offset) & (link->pending_delivery_capacity - 1)] = pending_delivery_operation;
+            link->pending_delivery_span = offset + 1;
+            ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_PENDING_DELIVERY, sizeof(DELIVERY_INSTANCE));
+        }
     }
 
     return result;
 }
 
-static int send_disposition(LINK_INSTANCE* link_instance, delivery_number delivery_number, AMQP_VALUE delivery_state)
+static ASYNC_OPERATION_HANDLE remove_pending_delivery(LINK_INSTANCE* link, delivery_number delivery_id)
 {
-    int result;
+    ASYNC_OPERATION_HANDLE result;
+    ASYNC_OPERATION_HANDLE* slot = get_pending_delivery_slot(link, delivery_id);
 
-    DISPOSITION_HANDLE disposition = disposition_create(link_instance->role, delivery_number);
-    if (disposition == NULL)
+    if (slot == NULL)
     {
-        LogError("NULL disposition performative");
-        result = __FAILURE__;
+        result = NULL;
     }
     else
     {
-        if (disposition_set_last(disposition, delivery_number) != 0)
+        result = *slot;
+        *slot = NULL;
+        if (result != NULL)
         {
-            LogError("Failed setting last on disposition performative");
-            result = __FAILURE__;
-        }
-        else if (disposition_set_settled(disposition, true) != 0)
-        {
-            LogError("Failed setting settled on disposition performative");
-            result = __FAILURE__;
+            ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_PENDING_DELIVERY, sizeof(DELIVERY_INSTANCE));
         }
-        else if ((delivery_state != NULL) && (disposition_set_state(disposition, delivery_state) != 0))
-        {
-            LogError("Failed setting state on disposition performative");
-            result = __FAILURE__;
-        }
-        else
+
+        /* advance the oldest pending delivery past any settled slots */
+        while ((link->pending_delivery_span > 0) &&
+            (link->pending_deliveries[link->pending_delivery_head] == NULL))
         {
-            if (session_send_disposition(link_instance->link_endpoint, disposition) != 0)
-            {
-                LogError("Sending disposition failed in session send");
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
+            link->pending_delivery_head = (link->pending_delivery_head + 1) & (link->pending_delivery_capacity - 1);
+            link->oldest_pending_delivery_id++;
+            link->pending_delivery_span--;
         }
-
-        disposition_destroy(disposition);
     }
 
     return result;
 }
 
-static int send_detach(LINK_INSTANCE* link_instance, bool close, ERROR_HANDLE error_handle)
+static void remove_pending_delivery_operation(LINK_INSTANCE* link, ASYNC_OPERATION_HANDLE pending_delivery_operation)
 {
-    int result;
-    DETACH_HANDLE detach_performative;
+    DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
+    ASYNC_OPERATION_HANDLE* slot = get_pending_delivery_slot(link, delivery_instance->delivery_id);
 
-    detach_performative = detach_create(0);
-    if (detach_performative == NULL)
+    if ((slot != NULL) && (*slot == pending_delivery_operation))
     {
-        LogError("NULL detach performative");
-        result = __FAILURE__;
+        (void)remove_pending_delivery(link, delivery_instance->delivery_id);
     }
-    else
+}
+
+/* a streamed delivery that settles, times out or is cancelled before its last part is aborted, so the peer drops its parts */
+static void end_streamed_delivery(LINK_INSTANCE* link, ASYNC_OPERATION_HANDLE pending_delivery_operation)
+{
+    if ((link->streamed_delivery != NULL) &&
+        (link->streamed_delivery == pending_delivery_operation))
     {
-        if ((error_handle != NULL) &&
-            (detach_set_error(detach_performative, error_handle) != 0))
-        {
-            LogError("Failed setting error on detach frame");
-            result = __FAILURE__;
-        }
-        else if (close &&
-            (detach_set_closed(detach_performative, true) != 0))
-        {
-            LogError("Failed setting closed field on detach frame");
-            result = __FAILURE__;
-        }
-        else
+        link->streamed_delivery = NULL;
+
+        if (link->link_state == LINK_STATE_ATTACHED)
         {
-            if (session_send_detach(link_instance->link_endpoint, detach_performative) != 0)
+            delivery_number delivery_id;
+            TRANSFER_HANDLE transfer = transfer_create(link->handle);
+
+            if (transfer == NULL)
             {
-                LogError("Sending detach frame failed in session send");
-                result = __FAILURE__;
+                LogError("Cannot create the transfer aborting the streamed delivery");
             }
             else
             {
-                if (close)
+                if ((transfer_set_aborted(transfer, true) != 0) ||
+                    (transfer_set_settled(transfer, true) != 0) ||
+                    (session_send_transfer_part(link->link_endpoint, transfer, false, NULL, 0, &delivery_id, NULL, NULL) != SESSION_SEND_TRANSFER_OK))
                 {
-                    /* Declare link to be closed */
-                    link_instance->is_closed = true;
+                    LogError("Cannot abort the streamed delivery");
                 }
 
-                result = 0;
+                transfer_destroy(transfer);
             }
         }
-
-        detach_destroy(detach_performative);
     }
-
-    return result;
 }
 
-static int send_attach(LINK_INSTANCE* link, const char* name, handle handle, role role)
+static void record_settle_latency(LINK_INSTANCE* link, tickcounter_ms_t latency)
 {
-    int result;
-    ATTACH_HANDLE attach = attach_create(name, handle, role);
+    /* bucket 0 holds settles under 1 ms, bucket i the latencies in [2^(i-1), 2^i) ms and the last bucket everything above */
+    uint32_t bucket = 0;
 
-    if (attach == NULL)
+    while ((latency > 0) &&
+        (bucket < LINK_SETTLE_LATENCY_BUCKET_COUNT - 1))
     {
-        LogError("NULL attach performative");
-        result = __FAILURE__;
+        latency >>= 1;
+        bucket++;
     }
-    else
-    {
-        result = 0;
 
-        link->delivery_count = link->initial_delivery_count;
+    link->stats.settle_latency_histogram[bucket]++;
+}
 
-        attach_set_snd_settle_mode(attach, link->snd_settle_mode);
-        attach_set_rcv_settle_mode(attach, link->rcv_settle_mode);
-        attach_set_role(attach, role);
-        attach_set_source(attach, link->source);
-        attach_set_target(attach, link->target);
-        if (link->attach_properties != NULL)
-        {
-            (void)attach_set_properties(attach, link->attach_properties);
-        }
+static void settle_pending_deliveries(LINK_INSTANCE* link, delivery_number first, delivery_number last, AMQP_VALUE delivery_state)
+{
+    delivery_number delivery_id = first;
+    uint32_t remaining = last - first + 1;
+    tickcounter_ms_t current_tick;
+    bool has_current_tick = (tickcounter_get_current_ms(link->tick_counter, &current_tick) == 0);
 
-        if (role == role_sender)
+    /* only the part of the range covered by the ring is visited, ids settled meanwhile by callbacks are skipped */
+    while ((remaining > 0) &&
+        (link->pending_delivery_span > 0))
+    {
+        ASYNC_OPERATION_HANDLE pending_delivery_operation;
+
+        if ((int32_t)(link->oldest_pending_delivery_id - delivery_id) > 0)
         {
-            if (attach_set_initial_delivery_count(attach, link->delivery_count) != 0)
+            uint32_t skipped = link->oldest_pending_delivery_id - delivery_id;
+            if (skipped >= remaining)
             {
-                LogError("Cannot set attach initial delivery count");
-                result = __FAILURE__;
+                break;
             }
+
+            remaining -= skipped;
+            delivery_id = link->oldest_pending_delivery_id;
         }
 
-        if (result == 0)
+        if ((uint32_t)(delivery_id - link->oldest_pending_delivery_id) >= link->pending_delivery_span)
+        {
+            break;
+        }
+
+        pending_delivery_operation = remove_pending_delivery(link, delivery_id);
+        if (pending_delivery_operation != NULL)
         {
-            if (attach_set_max_message_size(attach, link->max_message_size) != 0)
+            DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
+
+            link->stats.deliveries_settled++;
+            if (has_current_tick)
             {
-                LogError("Cannot set max message size");
-                result = __FAILURE__;
+                record_settle_latency(link, current_tick - delivery_instance->start_tick);
             }
-            else if (session_send_attach(link->link_endpoint, attach) != 0)
+
+            /* ended first, so that the link can take the next transfer from within the callback */
+            end_streamed_delivery(link, pending_delivery_operation);
+
+            if (delivery_instance->on_delivery_settled != NULL)
             {
-                LogError("Sending attach failed in session send");
-                result = __FAILURE__;
+                delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED, delivery_state);
             }
-            else
+
+            async_operation_destroy(pending_delivery_operation);
+        }
+
+        delivery_id++;
+        remaining--;
+    }
+}
+
+static void remove_all_pending_deliveries(LINK_INSTANCE* link, bool indicate_settled)
+{
+    while (link->pending_delivery_span > 0)
+    {
+        ASYNC_OPERATION_HANDLE pending_delivery_operation = remove_pending_delivery(link, link->oldest_pending_delivery_id);
+        if (pending_delivery_operation != NULL)
+        {
+            DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
+            if (indicate_settled && (delivery_instance->on_delivery_settled != NULL))
             {
-                result = 0;
+                delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_NOT_DELIVERED, NULL);
             }
+
+            async_operation_destroy(pending_delivery_operation);
         }
+    }
+
+    /* the link is no longer attached, so the parts already sent are dropped by the peer without an abort */
+    link->streamed_delivery = NULL;
+    free(link->pending_deliveries);
+    link->pending_deliveries = NULL;
+    link->pending_delivery_capacity = 0;
+    link->pending_delivery_head = 0;
+}
 
-        attach_destroy(attach);
+static bool is_flow_issuing_receiver(LINK_INSTANCE* link)
+{
+    /* the receiver sends its first flow when the peer attach arrives, credit changes before that are picked up there */
+    return (link->role == role_receiver) &&
+        ((link->link_state == LINK_STATE_ATTACHED) ||
+        (link->link_state == LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED));
+}
+
+static int send_flow(LINK_INSTANCE* link)
+{
+    int result;
+
+    /* the session encodes the flow straight to bytes, no flow performative composite is built */
+    if (session_send_link_flow(link->link_endpoint, link->delivery_count, link->current_link_credit) != 0)
+    {
+        LogError("Sending flow frame failed in session send");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
     }
 
     return result;
 }
 
-static void link_frame_received(void* context, AMQP_VALUE performative, uint32_t payload_size, const unsigned char* payload_bytes)
+static uint32_t get_credit_to_issue(LINK_INSTANCE* link)
 {
-    LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
-    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
+    uint32_t result;
 
-    if (is_attach_type_by_descriptor(descriptor))
+    if (link->max_buffered_bytes == 0)
     {
-        ATTACH_HANDLE attach_handle;
-
-        if (amqpvalue_get_attach(performative, &attach_handle) != 0)
+        result = link->max_link_credit;
+    }
+    else if (link->buffered_bytes > link->resume_buffered_bytes)
+    {
+        result = 0;
+    }
+    else if (link->average_delivery_size == 0)
+    {
+        /* the first delivery tells how large the deliveries are */
+        result = 1;
+    }
+    else
+    {
+        /* as many deliveries of the average size as fit in what is left of the budget, at least one so that the link never stalls */
+        uint64_t credit = (link->max_buffered_bytes - link->buffered_bytes) / link->average_delivery_size;
+        if (credit == 0)
         {
-            LogError("Cannot get attach performative");
+            result = 1;
+        }
+        else if (credit > link->max_link_credit)
+        {
+            result = link->max_link_credit;
         }
         else
         {
-            if ((link_instance->role == role_receiver) &&
-                (attach_get_initial_delivery_count(attach_handle, &link_instance->delivery_count) != 0))
-            {
-                LogError("Cannot get initial delivery count");
-                remove_all_pending_deliveries(link_instance, true);
-                set_link_state(link_instance, LINK_STATE_DETACHED);
-            }
-            else
-            {
-                if (attach_get_max_message_size(attach_handle, &link_instance->peer_max_message_size) != 0)
-                {
-                    LogError("Could not retrieve peer_max_message_size from attach frame");
-                }
+            result = (uint32_t)credit;
+        }
+    }
 
-                if ((link_instance->link_state == LINK_STATE_DETACHED) ||
-                    (link_instance->link_state == LINK_STATE_HALF_ATTACHED_ATTACH_SENT))
-                {
-                    if (link_instance->role == role_receiver)
-                    {
-                        link_instance->current_link_credit = link_instance->max_link_credit;
-                        send_flow(link_instance);
-                    }
-                    else
-                    {
-                        link_instance->current_link_credit = 0;
-                    }
+    /* while the connection is short of memory deliveries are let in one at a time, so that the link does not stall */
+    if ((result > 1) &&
+        (link->connection != NULL) &&
+        connection_is_memory_low(link->connection))
+    {
+        result = 1;
+    }
 
-                    if (link_instance->link_state == LINK_STATE_DETACHED)
-                    {
-                        set_link_state(link_instance, LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED);
-                    }
-                    else
-                    {
-                        set_link_state(link_instance, LINK_STATE_ATTACHED);
-                    }
-                }
-            }
+    return result;
+}
 
-            attach_destroy(attach_handle);
-        }
+static int refill_link_credit(LINK_INSTANCE* link)
+{
+    int result;
+    uint32_t credit = get_credit_to_issue(link);
+
+    if (credit == 0)
+    {
+        /* issued once enough buffered bytes are settled */
+        link->is_credit_held = true;
+        result = 0;
     }
-    else if (is_flow_type_by_descriptor(descriptor))
+    else
     {
-        FLOW_HANDLE flow_handle;
-        if (amqpvalue_get_flow(performative, &flow_handle) != 0)
+        link->is_credit_held = false;
+        link->current_link_credit = credit;
+        result = send_flow(link);
+    }
+
+    return result;
+}
+
+/* the bytes buffered by the application are also its receive backlog on the connection, which pauses reading when it is too far behind */
+static void clear_buffered_bytes(LINK_INSTANCE* link)
+{
+    if ((link->connection != NULL) &&
+        (link->buffered_bytes > 0))
+    {
+        connection_remove_receive_backlog(link->connection, (size_t)link->buffered_bytes);
+    }
+
+    link->buffered_bytes = 0;
+}
+
+static void release_buffered_bytes(LINK_INSTANCE* link, uint64_t bytes)
+{
+    if (bytes > link->buffered_bytes)
+    {
+        bytes = link->buffered_bytes;
+    }
+
+    if ((link->connection != NULL) &&
+        (bytes > 0))
+    {
+        connection_remove_receive_backlog(link->connection, (size_t)bytes);
+    }
+
+    link->buffered_bytes -= bytes;
+
+    if (link->is_credit_held &&
+        (!link->is_flow_paused) &&
+        is_flow_issuing_receiver(link) &&
+        (link->buffered_bytes <= link->resume_buffered_bytes) &&
+        (refill_link_credit(link) != 0))
+    {
+        LogError("Cannot send flow with the credit held for buffered bytes");
+    }
+}
+
+/* called once a whole delivery was received, its bytes stay buffered until the application settles it */
+static void account_received_delivery(LINK_INSTANCE* link, bool is_settled)
+{
+    uint64_t bytes = link->received_delivery_bytes;
+
+    link->received_delivery_bytes = 0;
+    link->is_received_delivery_settled = false;
+
+    if (link->max_buffered_bytes != 0)
+    {
+        link->average_delivery_size = (link->average_delivery_size == 0) ? bytes : ((link->average_delivery_size * 7) + bytes) / 8;
+        if (link->average_delivery_size == 0)
         {
-            LogError("Cannot get flow performative");
+            link->average_delivery_size = 1;
+        }
+
+        if (is_settled)
+        {
+            release_buffered_bytes(link, bytes);
         }
         else
         {
-            if (link_instance->role == role_sender)
+            if (link->unsettled_received_count == link->unsettled_received_capacity)
             {
-                delivery_number rcv_delivery_count;
-                uint32_t rcv_link_credit;
-
-                if (flow_get_link_credit(flow_handle, &rcv_link_credit) != 0)
+                uint32_t new_capacity = (link->unsettled_received_capacity == 0) ? 16 : link->unsettled_received_capacity * 2;
+                UNSETTLED_RECEIVED_DELIVERY* new_deliveries = (UNSETTLED_RECEIVED_DELIVERY*)realloc(link->unsettled_received_deliveries, sizeof(UNSETTLED_RECEIVED_DELIVERY) * new_capacity);
+                if (new_deliveries != NULL)
                 {
-                    LogError("Cannot get link credit");
-                    remove_all_pending_deliveries(link_instance, true);
-                    set_link_state(link_instance, LINK_STATE_DETACHED);
-                }
-                else if (flow_get_delivery_count(flow_handle, &rcv_delivery_count) != 0)
-                {
-                    LogError("Cannot get delivery count");
-                    remove_all_pending_deliveries(link_instance, true);
-                    set_link_state(link_instance, LINK_STATE_DETACHED);
-                }
-                else
-                {
-                    link_instance->current_link_credit = rcv_delivery_count + rcv_link_credit - link_instance->delivery_count;
-                    if (link_instance->current_link_credit > 0)
-                    {
-                        link_instance->on_link_flow_on(link_instance->callback_context);
-                    }
+                    link->unsettled_received_deliveries = new_deliveries;
+                    link->unsettled_received_capacity = new_capacity;
                 }
             }
-        }
 
-        flow_destroy(flow_handle);
-    }
-    else if (is_transfer_type_by_descriptor(descriptor))
-    {
-        if (link_instance->on_transfer_received != NULL)
-        {
-            TRANSFER_HANDLE transfer_handle;
-            if (amqpvalue_get_transfer(performative, &transfer_handle) != 0)
+            if (link->unsettled_received_count == link->unsettled_received_capacity)
             {
-                LogError("Cannot get transfer performative");
+                /* the delivery cannot be tracked, so it is not counted rather than holding its bytes forever */
+                LogError("Cannot track the bytes of the received delivery");
+                release_buffered_bytes(link, bytes);
             }
             else
             {
-                AMQP_VALUE delivery_state;
-                bool more;
-                bool is_error;
+                link->unsettled_received_deliveries[link->unsettled_received_count].delivery_id = link->received_delivery_id;
+                link->unsettled_received_deliveries[link->unsettled_received_count].bytes = bytes;
+                link->unsettled_received_count++;
+            }
+        }
+    }
+}
 
-                link_instance->current_link_credit--;
-                link_instance->delivery_count++;
-                if (link_instance->current_link_credit == 0)
-                {
-                    link_instance->current_link_credit = link_instance->max_link_credit;
-                    send_flow(link_instance);
-                }
+static void settle_received_delivery(LINK_INSTANCE* link, delivery_number delivery_id)
+{
+    uint32_t i;
 
-                more = false;
-                /* Attempt to get more flag, default to false */
-                (void)transfer_get_more(transfer_handle, &more);
-                is_error = false;
+    /* deliveries are mostly settled in the order they arrived, so the search rarely goes past the first one */
+    for (i = 0; i < link->unsettled_received_count; i++)
+    {
+        if (link->unsettled_received_deliveries[i].delivery_id == delivery_id)
+        {
+            uint64_t bytes = link->unsettled_received_deliveries[i].bytes;
 
-                if (transfer_get_delivery_id(transfer_handle, &link_instance->received_delivery_id) != 0)
-                {
-                    /* is this not a continuation transfer? */
-                    if (link_instance->received_payload_size == 0)
-                    {
-                        LogError("Could not get the delivery Id from the transfer performative");
-                        is_error = true;
-                    }
-                }
-                    
-                if (!is_error)
+            (void)memmove(&link->unsettled_received_deliveries[i], &link->unsettled_received_deliveries[i + 1], sizeof(UNSETTLED_RECEIVED_DELIVERY) * (link->unsettled_received_count - i - 1));
+            link->unsettled_received_count--;
+            release_buffered_bytes(link, bytes);
+            break;
+        }
+    }
+}
+
+static void end_drain(LINK_INSTANCE* link, LINK_DRAIN_RESULT drain_result)
+{
+    /* cleared first, so that on_link_drained can start the next drain */
+    link->is_draining = false;
+    link->on_link_drained(link->on_link_drained_context, drain_result);
+}
+
+static uint32_t* get_batched_outcome_bits(LINK_INSTANCE* link_instance, int outcome)
+{
+    return link_instance->batched_disposition_bits + (outcome * (link_instance->disposition_window_size / 32));
+}
+
+/* the ranges that cannot be sent stay batched, so that the next flush tries them again */
+static int flush_batched_dispositions(LINK_INSTANCE* link_instance)
+{
+    int result;
+
+    if (link_instance->batched_disposition_count == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        uint32_t span = link_instance->batched_disposition_last - link_instance->batched_disposition_first + 1;
+        uint32_t kept_count = 0;
+        int outcome;
+
+        result = 0;
+
+        for (outcome = 0; outcome < BATCHED_OUTCOME_COUNT; outcome++)
+        {
+            if (link_instance->batched_disposition_states[outcome] != NULL)
+            {
+                uint32_t* bits = get_batched_outcome_bits(link_instance, outcome);
+                delivery_number range_first = 0;
+                bool is_in_range = false;
+                uint32_t outcome_kept_count = 0;
+                uint32_t i;
+
+                /* one past the span, so that the last range is ended */
+                for (i = 0; i <= span; i++)
                 {
-                    /* If this is a continuation transfer or if this is the first chunk of a multi frame transfer */
-                    if ((link_instance->received_payload_size > 0) || more)
+                    delivery_number delivery_id = link_instance->batched_disposition_first + i;
+                    uint32_t bit_index = delivery_id & (link_instance->disposition_window_size - 1);
+                    uint32_t bit = (uint32_t)1 << (bit_index % 32);
+
+                    if ((i < span) &&
+                        ((bits[bit_index / 32] & bit) != 0))
                     {
-                        unsigned char* new_received_payload = (unsigned char*)realloc(link_instance->received_payload, link_instance->received_payload_size + payload_size);
-                        if (new_received_payload == NULL)
-                        {
-                            LogError("Could not allocate memory for the received payload");
-                        }
-                        else
+                        if (!is_in_range)
                         {
-                            link_instance->received_payload = new_received_payload;
-                            (void)memcpy(link_instance->received_payload + link_instance->received_payload_size, payload_bytes, payload_size);
-                            link_instance->received_payload_size += payload_size;
+                            range_first = delivery_id;
+                            is_in_range = true;
                         }
                     }
-
-                    if (!more)
+                    else if (is_in_range)
                     {
-                        const unsigned char* indicate_payload_bytes;
-                        uint32_t indicate_payload_size;
+                        delivery_number range_delivery_id;
 
-                        /* if no previously stored chunks then simply report the current payload */
-                        if (link_instance->received_payload_size > 0)
+                        if (session_send_delivery_disposition(link_instance->link_endpoint, link_instance->role, range_first, delivery_id - 1, true, link_instance->batched_disposition_states[outcome]) != 0)
                         {
-                            indicate_payload_size = link_instance->received_payload_size;
-                            indicate_payload_bytes = link_instance->received_payload;
+                            LogError("Sending batched disposition failed in session send");
+                            outcome_kept_count += delivery_id - range_first;
+                            result = __FAILURE__;
                         }
                         else
                         {
-                            indicate_payload_size = payload_size;
-                            indicate_payload_bytes = payload_bytes;
-                        }
-
-                        delivery_state = link_instance->on_transfer_received(link_instance->callback_context, transfer_handle, indicate_payload_size, indicate_payload_bytes);
-
-                        if (link_instance->received_payload_size > 0)
-                        {
-                            free(link_instance->received_payload);
-                            link_instance->received_payload = NULL;
-                            link_instance->received_payload_size = 0;
-                        }
-
-                        if (delivery_state != NULL)
-                        {
-                            if (send_disposition(link_instance, link_instance->received_delivery_id, delivery_state) != 0)
+                            for (range_delivery_id = range_first; range_delivery_id != delivery_id; range_delivery_id++)
                             {
-                                LogError("Cannot send disposition frame");
+                                uint32_t range_bit_index = range_delivery_id & (link_instance->disposition_window_size - 1);
+                                bits[range_bit_index / 32] &= ~((uint32_t)1 << (range_bit_index % 32));
                             }
-
-                            amqpvalue_destroy(delivery_state);
                         }
+
+                        is_in_range = false;
                     }
                 }
 
-                transfer_destroy(transfer_handle);
+                if (outcome_kept_count == 0)
+                {
+                    amqpvalue_destroy(link_instance->batched_disposition_states[outcome]);
+                    link_instance->batched_disposition_states[outcome] = NULL;
+                }
+
+                kept_count += outcome_kept_count;
             }
         }
+
+        /* the kept deliveries are still within batched_disposition_first..batched_disposition_last */
+        link_instance->batched_disposition_count = kept_count;
     }
-    else if (is_disposition_type_by_descriptor(descriptor))
-    {
-        DISPOSITION_HANDLE disposition;
-        if (amqpvalue_get_disposition(performative, &disposition) != 0)
-        {
-            LogError("Cannot get disposition performative");
-        }
-        else
-        {
-            delivery_number first;
-            delivery_number last;
 
-            if (disposition_get_first(disposition, &first) != 0)
-            {
-                LogError("Cannot get first field");
-            }
-            else
-            {
-                bool settled;
+    return result;
+}
 
-                if (disposition_get_last(disposition, &last) != 0)
-                {
-                    last = first;
-                }
+/* the index of the batched outcome delivery_state is, -1 when it is not batched */
+static int get_batched_outcome(AMQP_VALUE delivery_state)
+{
+    int result;
+    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(delivery_state);
 
-                if (disposition_get_settled(disposition, &settled) != 0)
-                {
-                    settled = false;
-                }
+    if (descriptor == NULL)
+    {
+        result = -1;
+    }
+    else if (is_accepted_type_by_descriptor(descriptor))
+    {
+        result = BATCHED_OUTCOME_ACCEPTED;
+    }
+    else if (is_released_type_by_descriptor(descriptor))
+    {
+        result = BATCHED_OUTCOME_RELEASED;
+    }
+    else
+    {
+        result = -1;
+    }
 
-                if (settled)
-                {
-                    LIST_ITEM_HANDLE pending_delivery = singlylinkedlist_get_head_item(link_instance->pending_deliveries);
-                    while (pending_delivery != NULL)
-                    {
-                        LIST_ITEM_HANDLE next_pending_delivery = singlylinkedlist_get_next_item(pending_delivery);
-                        ASYNC_OPERATION_HANDLE pending_delivery_operation = (ASYNC_OPERATION_HANDLE)singlylinkedlist_item_get_value(pending_delivery);
-                        if (pending_delivery_operation == NULL)
-                        {
-                            LogError("Cannot obtain pending delivery");
-                            break;
-                        }
-                        else
-                        {
-                            DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
+    return result;
+}
 
-                            if ((delivery_instance->delivery_id >= first) && (delivery_instance->delivery_id <= last))
-                            {
-                                AMQP_VALUE delivery_state;
-                                if (disposition_get_state(disposition, &delivery_state) == 0)
-                                {
-                                    delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED, delivery_state);
-                                    async_operation_destroy(pending_delivery_operation);
-                                    if (singlylinkedlist_remove(link_instance->pending_deliveries, pending_delivery) != 0)
-                                    {
-                                        LogError("Cannot remove pending delivery");
-                                        break;
-                                    }
-
-                                    pending_delivery = next_pending_delivery;
-                                }
-                            }
-                            else
-                            {
-                                pending_delivery = next_pending_delivery;
-                            }
-                        }
-                    }
-                }
-            }
+static int batch_disposition(LINK_INSTANCE* link_instance, delivery_number delivery_id, AMQP_VALUE delivery_state, int outcome)
+{
+    int result;
+
+    if (link_instance->batched_disposition_count > 0)
+    {
+        delivery_number first = ((int32_t)(delivery_id - link_instance->batched_disposition_first) < 0) ? delivery_id : link_instance->batched_disposition_first;
+        delivery_number last = ((int32_t)(delivery_id - link_instance->batched_disposition_last) > 0) ? delivery_id : link_instance->batched_disposition_last;
 
-            disposition_destroy(disposition);
+        /* a delivery too far from the batched ones for the window ends the batch */
+        if (last - first >= link_instance->disposition_window_size)
+        {
+            if (flush_batched_dispositions(link_instance) != 0)
+            {
+                LogError("Cannot flush batched dispositions");
+            }
+        }
+        else
+        {
+            link_instance->batched_disposition_first = first;
+            link_instance->batched_disposition_last = last;
         }
     }
-    else if (is_detach_type_by_descriptor(descriptor))
-    {
-        DETACH_HANDLE detach;
 
-        /* Set link state appropriately based on whether we received detach condition */
-        if (amqpvalue_get_detach(performative, &detach) != 0)
+    if ((link_instance->batched_disposition_count > 0) &&
+        (delivery_id - link_instance->batched_disposition_first >= link_instance->disposition_window_size))
+    {
+        /* the kept ranges of a failed flush leave no room in the window for this delivery, so it is not batched */
+        if (session_send_delivery_disposition(link_instance->link_endpoint, link_instance->role, delivery_id, delivery_id, true, delivery_state) != 0)
         {
-            LogError("Cannot get detach performative");
+            LogError("Sending disposition failed in session send");
+            result = __FAILURE__;
         }
         else
         {
-            bool closed = false;
-            ERROR_HANDLE error;
+            result = 0;
+        }
+    }
+    else if ((link_instance->batched_disposition_states[outcome] == NULL) &&
+        ((link_instance->batched_disposition_states[outcome] = amqpvalue_clone(delivery_state)) == NULL))
+    {
+        LogError("Cannot clone the delivery state");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t bit_index = delivery_id & (link_instance->disposition_window_size - 1);
+        uint32_t bit = (uint32_t)1 << (bit_index % 32);
+        bool is_batched = false;
+        int i;
 
-            /* Received a detach while attached */
-            if (link_instance->link_state == LINK_STATE_ATTACHED)
+        if (link_instance->batched_disposition_count == 0)
+        {
+            if (tickcounter_get_current_ms(link_instance->tick_counter, &link_instance->batched_disposition_start_tick) != 0)
             {
-                /* Respond with ack */
-                if (send_detach(link_instance, closed, NULL) != 0)
-                {
-                    LogError("Failed sending detach frame");
-                }
+                /* the batch is still flushed by count or on dowork */
+                LogError("Cannot get current tick");
+                link_instance->batched_disposition_start_tick = 0;
             }
 
-            /* Received a closing detach after we sent a non-closing detach. */
-            else if (closed &&
-                ((link_instance->link_state == LINK_STATE_HALF_ATTACHED_ATTACH_SENT) || (link_instance->link_state == LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED)) &&
-                !link_instance->is_closed)
+            link_instance->batched_disposition_first = delivery_id;
+            link_instance->batched_disposition_last = delivery_id;
+        }
+
+        /* a delivery settled again only keeps its last outcome */
+        for (i = 0; i < BATCHED_OUTCOME_COUNT; i++)
+        {
+            uint32_t* bits = get_batched_outcome_bits(link_instance, i);
+            if ((bits[bit_index / 32] & bit) != 0)
             {
+                bits[bit_index / 32] &= ~bit;
+                is_batched = true;
+            }
+        }
 
-                /* In this case, we MUST signal that we closed by reattaching and then sending a closing detach.*/
-                if (send_attach(link_instance, link_instance->name, 0, link_instance->role) != 0)
-                {
-                    LogError("Failed sending attach frame");
-                }
+        get_batched_outcome_bits(link_instance, outcome)[bit_index / 32] |= bit;
+        if (!is_batched)
+        {
+            link_instance->batched_disposition_count++;
+        }
 
-                if (send_detach(link_instance, true, NULL) != 0)
-                {
-                    LogError("Failed sending detach frame");
-                }
-            }
+        if (link_instance->batched_disposition_count >= link_instance->disposition_batch_size)
+        {
+            result = flush_batched_dispositions(link_instance);
+        }
+        else
+        {
+            result = 0;
+        }
+    }
 
-            if (detach_get_error(detach, &error) == 0)
-            {
-                error_destroy(error);
+    return result;
+}
 
-                remove_all_pending_deliveries(link_instance, true);
-                set_link_state(link_instance, LINK_STATE_ERROR);
-            }
-            else 
-            {
-                (void)detach_get_closed(detach, &closed);
+static void flush_due_batched_dispositions(LINK_INSTANCE* link_instance, tickcounter_ms_t current_tick)
+{
+    /* without a max delay the batched dispositions are flushed on every dowork */
+    if ((link_instance->batched_disposition_count > 0) &&
+        ((link_instance->disposition_batch_max_delay == 0) ||
+        (current_tick - link_instance->batched_disposition_start_tick >= link_instance->disposition_batch_max_delay)) &&
+        (flush_batched_dispositions(link_instance) != 0))
+    {
+        LogError("Cannot flush batched dispositions");
+    }
+}
 
-                remove_all_pending_deliveries(link_instance, true);
-                set_link_state(link_instance, LINK_STATE_DETACHED);
-            }
+/* called from connection_dowork while dispositions are batched, as receivers do not have to call link_dowork */
+static void on_link_endpoint_dowork(void* context)
+{
+    LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
+    tickcounter_ms_t current_tick;
 
-            detach_destroy(detach);
+    if (link_instance->batched_disposition_count == 0)
+    {
+        /* nothing to flush */
+    }
+    else if (tickcounter_get_current_ms(link_instance->tick_counter, &current_tick) != 0)
+    {
+        LogError("Cannot get tick counter value");
+    }
+    else
+    {
+        flush_due_batched_dispositions(link_instance, current_tick);
+    }
+}
+
+static int send_disposition(LINK_INSTANCE* link_instance, delivery_number delivery_number, AMQP_VALUE delivery_state)
+{
+    int result;
+    int outcome;
+
+    if ((link_instance->disposition_batch_size > 1) &&
+        (delivery_state != NULL) &&
+        ((outcome = get_batched_outcome(delivery_state)) >= 0))
+    {
+        result = batch_disposition(link_instance, delivery_number, delivery_state, outcome);
+    }
+    else
+    {
+        /* anything that is not batched goes out after the batched ranges, so the peer sees the outcomes in order */
+        if (flush_batched_dispositions(link_instance) != 0)
+        {
+            LogError("Cannot flush batched dispositions");
+        }
+
+        if (session_send_delivery_disposition(link_instance->link_endpoint, link_instance->role, delivery_number, delivery_number, true, delivery_state) != 0)
+        {
+            LogError("Sending disposition failed in session send");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
         }
     }
+
+    return result;
 }
 
-static void on_session_state_changed(void* context, SESSION_STATE new_session_state, SESSION_STATE previous_session_state)
+static int send_detach(LINK_INSTANCE* link_instance, bool close, ERROR_HANDLE error_handle)
 {
-    LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
-    (void)previous_session_state;
+    int result;
+    DETACH_HANDLE detach_performative;
 
-    if (new_session_state == SESSION_STATE_MAPPED)
+    detach_performative = detach_create(0);
+    if (detach_performative == NULL)
     {
-        if ((link_instance->link_state == LINK_STATE_DETACHED) && (!link_instance->is_closed))
+        LogError("NULL detach performative");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((error_handle != NULL) &&
+            (detach_set_error(detach_performative, error_handle) != 0))
+        {
+            LogError("Failed setting error on detach frame");
+            result = __FAILURE__;
+        }
+        else if (close &&
+            (detach_set_closed(detach_performative, true) != 0))
+        {
+            LogError("Failed setting closed field on detach frame");
+            result = __FAILURE__;
+        }
+        else
         {
-            if (send_attach(link_instance, link_instance->name, 0, link_instance->role) == 0)
+            if (session_send_detach(link_instance->link_endpoint, detach_performative) != 0)
             {
-                set_link_state(link_instance, LINK_STATE_HALF_ATTACHED_ATTACH_SENT);
+                LogError("Sending detach frame failed in session send");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (close)
+                {
+                    /* Declare link to be closed */
+                    link_instance->is_closed = true;
+                }
+
+                result = 0;
             }
         }
+
+        detach_destroy(detach_performative);
     }
-    else if (new_session_state == SESSION_STATE_DISCARDING)
+
+    return result;
+}
+
+static int encode_terminus(LINK_INSTANCE* link, AMQP_VALUE source, AMQP_VALUE target)
+{
+    int result;
+    size_t source_size = 0;
+    size_t target_size = 0;
+
+    if (((source != NULL) && (amqpvalue_get_encoded_size(source, &source_size) != 0)) ||
+        ((target != NULL) && (amqpvalue_get_encoded_size(target, &target_size) != 0)) ||
+        (source_size > UINT32_MAX) ||
+        (target_size > UINT32_MAX - source_size))
     {
-        remove_all_pending_deliveries(link_instance, true);
-        set_link_state(link_instance, LINK_STATE_DETACHED);
+        LogError("Cannot get the encoded size of the link source and target");
+        result = __FAILURE__;
     }
-    else if (new_session_state == SESSION_STATE_ERROR)
+    else if ((source_size + target_size > 0) &&
+        ((link->encoded_terminus = (unsigned char*)malloc(source_size + target_size)) == NULL))
     {
-        remove_all_pending_deliveries(link_instance, true);
-        set_link_state(link_instance, LINK_STATE_ERROR);
+        LogError("Cannot allocate memory for the link source and target");
+        result = __FAILURE__;
+    }
+    else if (((source != NULL) && (amqpvalue_encode_to_buffer(source, link->encoded_terminus, source_size, &source_size) != 0)) ||
+        ((target != NULL) && (amqpvalue_encode_to_buffer(target, link->encoded_terminus + source_size, target_size, &target_size) != 0)))
+    {
+        LogError("Cannot encode the link source and target");
+        free(link->encoded_terminus);
+        link->encoded_terminus = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        link->encoded_source_size = (uint32_t)source_size;
+        link->encoded_target_size = (uint32_t)target_size;
+        result = 0;
     }
+
+    return result;
 }
 
-static void on_session_flow_on(void* context)
+/* the attach is written from the encoded source, target and properties kept by the link, so that mass reattaches
+   neither decode them nor build an attach performative */
+static int send_attach(LINK_INSTANCE* link, role role)
 {
-    LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
-    if (link_instance->role == role_sender)
+    int result;
+    size_t unsettled_size = 0;
+
+    if ((link->unsettled != NULL) &&
+        (amqpvalue_get_encoded_size(link->unsettled, &unsettled_size) != 0))
     {
-        link_instance->on_link_flow_on(link_instance->callback_context);
+        LogError("Cannot get the encoded size of the attach unsettled map");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t fields_size = ATTACH_FIELDS_MAX_SIZE + link->encoded_source_size + link->encoded_target_size + unsettled_size + link->encoded_attach_properties_size;
+        unsigned char* fields = (unsigned char*)malloc(fields_size);
+        if (fields == NULL)
+        {
+            LogError("Cannot allocate memory for the attach fields");
+            result = __FAILURE__;
+        }
+        else
+        {
+            AMQP_WRITER writer;
+            size_t fields_length;
+            /* the name and handle are written by the session, the capabilities are only written ahead of properties */
+            uint32_t field_count = (link->encoded_attach_properties != NULL) ? 12 : 9;
+
+            link->delivery_count = link->initial_delivery_count;
+
+            /* the writer fails for good on the first error, which amqp_writer_get_length reports */
+            (void)amqp_writer_init(&writer, fields, fields_size);
+            (void)amqp_writer_put_boolean(&writer, role);
+            (void)amqp_writer_put_ubyte(&writer, link->snd_settle_mode);
+            (void)amqp_writer_put_ubyte(&writer, link->rcv_settle_mode);
+            if (link->encoded_source_size > 0)
+            {
+                (void)amqp_writer_put_encoded(&writer, link->encoded_terminus, link->encoded_source_size, 1);
+            }
+            else
+            {
+                (void)amqp_writer_put_null(&writer);
+            }
+            if (link->encoded_target_size > 0)
+            {
+                (void)amqp_writer_put_encoded(&writer, link->encoded_terminus + link->encoded_source_size, link->encoded_target_size, 1);
+            }
+            else
+            {
+                (void)amqp_writer_put_null(&writer);
+            }
+            if (link->unsettled != NULL)
+            {
+                (void)amqp_writer_put_value(&writer, link->unsettled);
+            }
+            else
+            {
+                (void)amqp_writer_put_null(&writer);
+            }
+            /* incomplete-unsettled */
+            (void)amqp_writer_put_null(&writer);
+            if (role == role_sender)
+            {
+                (void)amqp_writer_put_uint(&writer, link->delivery_count);
+            }
+            else
+            {
+                (void)amqp_writer_put_null(&writer);
+            }
+            (void)amqp_writer_put_ulong(&writer, link->max_message_size);
+            if (link->encoded_attach_properties != NULL)
+            {
+                (void)amqp_writer_put_null(&writer);
+                (void)amqp_writer_put_null(&writer);
+                (void)amqp_writer_put_encoded(&writer, link->encoded_attach_properties, link->encoded_attach_properties_size, 1);
+            }
+
+            if (amqp_writer_get_length(&writer, &fields_length) != 0)
+            {
+                LogError("Cannot encode the attach fields");
+                result = __FAILURE__;
+            }
+            else if (session_send_encoded_attach(link->link_endpoint, fields, fields_length, field_count) != 0)
+            {
+                LogError("Sending attach failed in session send");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            free(fields);
+        }
     }
+
+    return result;
 }
 
-static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+static void release_received_payload_memory(LINK_INSTANCE* link)
 {
-    LIST_ITEM_HANDLE delivery_instance_list_item = (LIST_ITEM_HANDLE)context;
-    ASYNC_OPERATION_HANDLE pending_delivery_operation = (ASYNC_OPERATION_HANDLE)singlylinkedlist_item_get_value(delivery_instance_list_item);
-    DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
-    LINK_HANDLE link = (LINK_HANDLE)delivery_instance->link;
-    (void)send_result;
-    if (link->snd_settle_mode == sender_settle_mode_settled)
+    if (link->connection != NULL)
     {
-        delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_SETTLED, NULL);
-        async_operation_destroy(pending_delivery_operation);
-        (void)singlylinkedlist_remove(link->pending_deliveries, delivery_instance_list_item);
+        connection_release_memory(link->connection, link->received_payload_capacity);
     }
 }
 
-LINK_HANDLE link_create(SESSION_HANDLE session, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+/* empties the reassembly buffer once a multi frame delivery is done with */
+static void reset_received_payload(LINK_INSTANCE* link)
 {
-    LINK_INSTANCE* result = (LINK_INSTANCE*)malloc(sizeof(LINK_INSTANCE));
-    if (result == NULL)
+    /* a modest buffer is kept for the next multi frame delivery, a large one is given back */
+    if (link->received_payload_capacity > RETAINED_RECEIVED_PAYLOAD_CAPACITY)
     {
-        LogError("Cannot create link");
+        release_received_payload_memory(link);
+        free(link->received_payload);
+        link->received_payload = NULL;
+        link->received_payload_capacity = 0;
+    }
+
+    link->received_payload_size = 0;
+}
+
+static void reject_oversize_delivery(LINK_INSTANCE* link)
+{
+    AMQP_VALUE delivery_state = messaging_delivery_rejected("amqp:link:message-size-exceeded", "The delivery is larger than the max-message-size of the link");
+
+    LogError("Delivery %u exceeds the max message size of %u bytes, rejecting it",
+        (unsigned int)link->received_delivery_id, (unsigned int)link->max_message_size);
+
+    if (delivery_state == NULL)
+    {
+        LogError("Cannot create the rejected delivery state");
     }
     else
     {
-        result->link_state = LINK_STATE_DETACHED;
-        result->previous_link_state = LINK_STATE_DETACHED;
-        result->role = role;
-        result->source = amqpvalue_clone(source);
-        result->target = amqpvalue_clone(target);
-        result->session = session;
-        result->handle = 0;
-        result->snd_settle_mode = sender_settle_mode_unsettled;
-        result->rcv_settle_mode = receiver_settle_mode_first;
-        result->delivery_count = 0;
-        result->initial_delivery_count = 0;
-        result->max_message_size = 0;
-        result->max_link_credit = DEFAULT_LINK_CREDIT;
-        result->peer_max_message_size = 0;
-        result->is_underlying_session_begun = false;
-        result->is_closed = false;
-        result->attach_properties = NULL;
-        result->received_payload = NULL;
-        result->received_payload_size = 0;
-        result->received_delivery_id = 0;
+        if (send_disposition(link, link->received_delivery_id, delivery_state) != 0)
+        {
+            LogError("Cannot send disposition frame");
+        }
+
+        amqpvalue_destroy(delivery_state);
+    }
+
+    reset_received_payload(link);
+}
+
+/* grows the reassembly buffer geometrically, so that a message of n bytes is copied O(n) times overall rather than once per frame */
+static int reserve_received_payload(LINK_INSTANCE* link, uint32_t payload_size)
+{
+    int result;
+
+    if (payload_size > UINT32_MAX - link->received_payload_size)
+    {
+        LogError("Received payload too large");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t needed_capacity = link->received_payload_size + payload_size;
+
+        if (needed_capacity <= link->received_payload_capacity)
+        {
+            result = 0;
+        }
+        else
+        {
+            uint32_t new_capacity = (link->received_payload_capacity > UINT32_MAX / 2) ? UINT32_MAX : link->received_payload_capacity * 2;
+            unsigned char* new_received_payload;
+
+            if (new_capacity < needed_capacity)
+            {
+                new_capacity = needed_capacity;
+            }
+
+            /* a peer sending an endless multi frame delivery is stopped by the quota of the connection, which is closed */
+            if ((link->connection != NULL) &&
+                (connection_charge_memory(link->connection, new_capacity - link->received_payload_capacity) != 0))
+            {
+                LogError("The received payload of %u bytes exceeds the memory quota of the connection", (unsigned int)new_capacity);
+                result = __FAILURE__;
+            }
+            else if ((new_received_payload = (unsigned char*)realloc(link->received_payload, new_capacity)) == NULL)
+            {
+                LogError("Could not grow the received payload to %u bytes", (unsigned int)new_capacity);
+                if (link->connection != NULL)
+                {
+                    connection_release_memory(link->connection, new_capacity - link->received_payload_capacity);
+                }
+                result = __FAILURE__;
+            }
+            else
+            {
+                link->received_payload = new_received_payload;
+                link->received_payload_capacity = new_capacity;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void link_frame_received(void* context, AMQP_VALUE performative, uint64_t performative_code, uint32_t payload_size, const unsigned char* payload_bytes)
+{
+    LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
+
+    switch (performative_code)
+    {
+    default:
+        break;
+
+    case AMQP_ATTACH:
+    {
+        ATTACH_HANDLE attach_handle;
+
+        if (amqpvalue_get_attach(performative, &attach_handle) != 0)
+        {
+            LogError("Cannot get attach performative");
+        }
+        else
+        {
+            if ((link_instance->role == role_receiver) &&
+                (attach_get_initial_delivery_count(attach_handle, &link_instance->delivery_count) != 0))
+            {
+                LogError("Cannot get initial delivery count");
+                remove_all_pending_deliveries(link_instance, true);
+                set_link_state(link_instance, LINK_STATE_DETACHED);
+            }
+            else
+            {
+                AMQP_VALUE peer_unsettled;
+
+                if (attach_get_max_message_size(attach_handle, &link_instance->peer_max_message_size) != 0)
+                {
+                    LogError("Could not retrieve peer_max_message_size from attach frame");
+                }
+
+                if (link_instance->peer_unsettled != NULL)
+                {
+                    amqpvalue_destroy(link_instance->peer_unsettled);
+                    link_instance->peer_unsettled = NULL;
+                }
+
+                /* an absent or null unsettled map means the peer has no unsettled deliveries on this link */
+                if (attach_get_unsettled(attach_handle, &peer_unsettled) == 0)
+                {
+                    link_instance->peer_unsettled = amqpvalue_clone(peer_unsettled);
+                    if (link_instance->peer_unsettled == NULL)
+                    {
+                        LogError("Could not clone the peer unsettled map");
+                    }
+                }
+
+                if ((link_instance->link_state == LINK_STATE_DETACHED) ||
+                    (link_instance->link_state == LINK_STATE_HALF_ATTACHED_ATTACH_SENT))
+                {
+                    /* deliveries left unsettled by an earlier attachment can no longer be settled */
+                    link_instance->unsettled_received_count = 0;
+                    clear_buffered_bytes(link_instance);
+                    link_instance->received_delivery_bytes = 0;
+                    link_instance->is_credit_held = false;
+
+                    if ((link_instance->role == role_receiver) &&
+                        (!link_instance->is_flow_paused))
+                    {
+                        (void)refill_link_credit(link_instance);
+                    }
+                    else
+                    {
+                        link_instance->current_link_credit = 0;
+                    }
+
+                    if (link_instance->link_state == LINK_STATE_DETACHED)
+                    {
+                        set_link_state(link_instance, LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED);
+                    }
+                    else
+                    {
+                        set_link_state(link_instance, LINK_STATE_ATTACHED);
+                    }
+                }
+            }
+
+            attach_destroy(attach_handle);
+        }
+
+        break;
+    }
+
+    case AMQP_FLOW:
+    {
+        FLOW_HANDLE flow_handle;
+
+        link_instance->stats.flows_received++;
+        if (amqpvalue_get_flow(performative, &flow_handle) != 0)
+        {
+            LogError("Cannot get flow performative");
+        }
+        else
+        {
+            if (link_instance->role == role_sender)
+            {
+                delivery_number rcv_delivery_count;
+                uint32_t rcv_link_credit;
+
+                if (flow_get_link_credit(flow_handle, &rcv_link_credit) != 0)
+                {
+                    LogError("Cannot get link credit");
+                    remove_all_pending_deliveries(link_instance, true);
+                    set_link_state(link_instance, LINK_STATE_DETACHED);
+                }
+                else if (flow_get_delivery_count(flow_handle, &rcv_delivery_count) != 0)
+                {
+                    LogError("Cannot get delivery count");
+                    remove_all_pending_deliveries(link_instance, true);
+                    set_link_state(link_instance, LINK_STATE_DETACHED);
+                }
+                else
+                {
+                    link_instance->current_link_credit = rcv_delivery_count + rcv_link_credit - link_instance->delivery_count;
+                    if (link_instance->current_link_credit > 0)
+                    {
+                        if (link_instance->is_credit_exhausted)
+                        {
+                            link_instance->is_credit_exhausted = false;
+                            report_flow_event(link_instance, CONNECTION_FLOW_EVENT_LINK_CREDIT_AVAILABLE, link_instance->current_link_credit);
+                        }
+
+                        link_instance->on_link_flow_on(link_instance->callback_context);
+                    }
+                }
+            }
+            else if (link_instance->is_draining)
+            {
+                delivery_number rcv_delivery_count;
+                uint32_t rcv_link_credit;
+
+                /* the sender answers a drain by advancing its delivery count over the credit it could not use and sending no credit back */
+                if ((flow_get_link_credit(flow_handle, &rcv_link_credit) == 0) &&
+                    (rcv_link_credit == 0) &&
+                    (flow_get_delivery_count(flow_handle, &rcv_delivery_count) == 0))
+                {
+                    link_instance->delivery_count = rcv_delivery_count;
+                    link_instance->current_link_credit = 0;
+                    end_drain(link_instance, LINK_DRAIN_RESULT_DRAINED);
+                }
+            }
+        }
+
+        flow_destroy(flow_handle);
+
+        break;
+    }
+
+    case AMQP_TRANSFER:
+    {
+        link_instance->stats.transfers_received++;
+        if ((link_instance->on_transfer_received != NULL) ||
+            (link_instance->on_transfer_frame_received != NULL))
+        {
+            TRANSFER_HANDLE transfer_handle;
+            if (amqpvalue_get_transfer(performative, &transfer_handle) != 0)
+            {
+                LogError("Cannot get transfer performative");
+            }
+            else
+            {
+                AMQP_VALUE delivery_state;
+                bool more;
+                bool is_error;
+                bool is_settled = false;
+
+                if (link_instance->current_link_credit > 0)
+                {
+                    link_instance->current_link_credit--;
+                }
+
+                link_instance->delivery_count++;
+
+                if (link_instance->max_buffered_bytes != 0)
+                {
+                    bool sender_settled;
+
+                    link_instance->buffered_bytes += payload_size;
+                    link_instance->received_delivery_bytes += payload_size;
+                    if (link_instance->connection != NULL)
+                    {
+                        connection_add_receive_backlog(link_instance->connection, payload_size);
+                    }
+                    if ((transfer_get_settled(transfer_handle, &sender_settled) == 0) &&
+                        sender_settled)
+                    {
+                        link_instance->is_received_delivery_settled = true;
+                    }
+                }
+
+                /* with a low water mark the credit is topped up while the sender still has some left,
+                so that it does not stall for a round trip waiting for the flow at every window boundary */
+                if ((!link_instance->is_flow_paused) &&
+                    ((link_instance->current_link_credit == 0) ||
+                    ((link_instance->credit_policy == LINK_CREDIT_POLICY_LOW_WATER_MARK) &&
+                    (link_instance->current_link_credit <= link_instance->credit_low_water_mark))))
+                {
+                    (void)refill_link_credit(link_instance);
+                }
+
+                more = false;
+                /* Attempt to get more flag, default to false */
+                (void)transfer_get_more(transfer_handle, &more);
+                is_error = false;
+
+                if (transfer_get_delivery_id(transfer_handle, &link_instance->received_delivery_id) != 0)
+                {
+                    /* is this not a continuation transfer? */
+                    if ((link_instance->received_payload_size == 0) &&
+                        !link_instance->is_receiving_streamed_delivery &&
+                        !link_instance->is_discarding_delivery)
+                    {
+                        LogError("Could not get the delivery Id from the transfer performative");
+                        is_error = true;
+                    }
+                }
+                    
+                if (!is_error &&
+                    (link_instance->on_transfer_frame_received != NULL))
+                {
+                    /* streamed deliveries are handed over frame by frame instead of being reassembled,
+                    so that the receiver never holds more than one frame of a large message */
+                    delivery_state = link_instance->on_transfer_frame_received(link_instance->callback_context, transfer_handle, more, payload_size, payload_bytes);
+                    link_instance->is_receiving_streamed_delivery = more;
+
+                    if (delivery_state != NULL)
+                    {
+                        /* the outcome can only be settled once the whole delivery was received */
+                        if (!more &&
+                            (send_disposition(link_instance, link_instance->received_delivery_id, delivery_state) != 0))
+                        {
+                            LogError("Cannot send disposition frame");
+                        }
+
+                        is_settled = true;
+                        amqpvalue_destroy(delivery_state);
+                    }
+                }
+                else if (!is_error &&
+                    link_instance->is_discarding_delivery)
+                {
+                    link_instance->is_discarding_delivery = more;
+                    is_settled = true;
+                }
+                else if (!is_error &&
+                    (link_instance->max_message_size != 0) &&
+                    ((uint64_t)link_instance->received_payload_size + payload_size > link_instance->max_message_size))
+                {
+                    /* rejected as soon as the running total goes over the limit, before anything more is buffered */
+                    reject_oversize_delivery(link_instance);
+                    link_instance->is_discarding_delivery = more;
+                    is_settled = true;
+                }
+                else if (!is_error)
+                {
+                    /* If this is a continuation transfer or if this is the first chunk of a multi frame transfer */
+                    if ((link_instance->received_payload_size > 0) || more)
+                    {
+                        if (reserve_received_payload(link_instance, payload_size) != 0)
+                        {
+                            LogError("Could not allocate memory for the received payload");
+                        }
+                        else
+                        {
+                            (void)memcpy(link_instance->received_payload + link_instance->received_payload_size, payload_bytes, payload_size);
+                            link_instance->received_payload_size += payload_size;
+                        }
+                    }
+
+                    if (!more)
+                    {
+                        const unsigned char* indicate_payload_bytes;
+                        uint32_t indicate_payload_size;
+
+                        /* if no previously stored chunks then simply report the current payload */
+                        if (link_instance->received_payload_size > 0)
+                        {
+                            indicate_payload_size = link_instance->received_payload_size;
+                            indicate_payload_bytes = link_instance->received_payload;
+                        }
+                        else
+                        {
+                            indicate_payload_size = payload_size;
+                            indicate_payload_bytes = payload_bytes;
+                        }
+
+                        delivery_state = link_instance->on_transfer_received(link_instance->callback_context, transfer_handle, indicate_payload_size, indicate_payload_bytes);
+
+                        if (link_instance->received_payload_size > 0)
+                        {
+                            reset_received_payload(link_instance);
+                        }
+
+                        if (delivery_state != NULL)
+                        {
+                            if (send_disposition(link_instance, link_instance->received_delivery_id, delivery_state) != 0)
+                            {
+                                LogError("Cannot send disposition frame");
+                            }
+
+                            is_settled = true;
+                            amqpvalue_destroy(delivery_state);
+                        }
+                    }
+                }
+
+                if (!more)
+                {
+                    /* a delivery that could not be indicated is never settled by the application */
+                    account_received_delivery(link_instance, is_settled || is_error || link_instance->is_received_delivery_settled);
+                }
+
+                transfer_destroy(transfer_handle);
+
+                /* a drain ends once its credit is used up, after the last delivery it allowed has been indicated */
+                if (link_instance->is_draining &&
+                    !more &&
+                    (link_instance->current_link_credit == 0))
+                {
+                    end_drain(link_instance, LINK_DRAIN_RESULT_CREDIT_USED);
+                }
+            }
+        }
+
+        break;
+    }
+
+    case AMQP_DISPOSITION:
+    {
+        DISPOSITION_FIELDS disposition_fields;
+
+        link_instance->stats.dispositions_received++;
+
+        /* the session hands every disposition to all of its links, so the fields are only read in place */
+        if (amqpvalue_get_disposition_fields(performative, &disposition_fields) != 0)
+        {
+            LogError("Cannot get disposition performative");
+        }
+        else
+        {
+            delivery_number last = disposition_fields.has_last ? disposition_fields.last : disposition_fields.first;
+
+            UAMQP_TRACEPOINT3(link_disposition_received, disposition_fields.first, last, disposition_fields.settled);
+
+            if (disposition_fields.settled)
+            {
+                if (disposition_fields.state == NULL)
+                {
+                    LogError("Cannot get disposition delivery state");
+                }
+                else
+                {
+                    settle_pending_deliveries(link_instance, disposition_fields.first, last, disposition_fields.state);
+
+                    if (link_instance->on_disposition_processed != NULL)
+                    {
+                        link_instance->on_disposition_processed(link_instance->callback_context);
+                    }
+                }
+            }
+        }
+
+        break;
+    }
+
+    case AMQP_DETACH:
+    {
+        DETACH_HANDLE detach;
+
+        /* Set link state appropriately based on whether we received detach condition */
+        if (amqpvalue_get_detach(performative, &detach) != 0)
+        {
+            LogError("Cannot get detach performative");
+        }
+        else
+        {
+            bool closed = false;
+            ERROR_HANDLE error;
+
+            /* Received a detach while attached */
+            if (link_instance->link_state == LINK_STATE_ATTACHED)
+            {
+                /* Respond with ack */
+                if (send_detach(link_instance, closed, NULL) != 0)
+                {
+                    LogError("Failed sending detach frame");
+                }
+            }
+
+            /* Received a closing detach after we sent a non-closing detach. */
+            else if (closed &&
+                ((link_instance->link_state == LINK_STATE_HALF_ATTACHED_ATTACH_SENT) || (link_instance->link_state == LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED)) &&
+                !link_instance->is_closed)
+            {
+
+                /* In this case, we MUST signal that we closed by reattaching and then sending a closing detach.*/
+                if (send_attach(link_instance, link_instance->role) != 0)
+                {
+                    LogError("Failed sending attach frame");
+                }
+
+                if (send_detach(link_instance, true, NULL) != 0)
+                {
+                    LogError("Failed sending detach frame");
+                }
+            }
+
+            if (detach_get_error(detach, &error) == 0)
+            {
+                error_destroy(error);
+
+                remove_all_pending_deliveries(link_instance, true);
+                set_link_state(link_instance, LINK_STATE_ERROR);
+            }
+            else 
+            {
+                (void)detach_get_closed(detach, &closed);
+
+                remove_all_pending_deliveries(link_instance, true);
+                set_link_state(link_instance, LINK_STATE_DETACHED);
+            }
+
+            detach_destroy(detach);
+        }
+
+        break;
+    }
+    }
+}
+
+/* a link on a session whose BEGIN was pipelined behind the connection OPEN pipelines its ATTACH too */
+static bool is_session_begin_pipelined(LINK_INSTANCE* link_instance)
+{
+    bool result;
+
+    if (session_get_pipelined_begin(link_instance->session, &result) != 0)
+    {
+        LogError("Cannot get the pipelined begin setting of the session");
+        result = false;
+    }
+
+    return result;
+}
+
+static void on_session_state_changed(void* context, SESSION_STATE new_session_state, SESSION_STATE previous_session_state)
+{
+    LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
+    (void)previous_session_state;
+
+    if ((new_session_state == SESSION_STATE_MAPPED) ||
+        ((new_session_state == SESSION_STATE_BEGIN_SENT) && is_session_begin_pipelined(link_instance)))
+    {
+        if ((link_instance->link_state == LINK_STATE_DETACHED) && (!link_instance->is_closed))
+        {
+            if (link_instance->is_resuming_handover)
+            {
+                /* both ends are still attached, only this end changed process */
+                link_instance->is_resuming_handover = false;
+                set_link_state(link_instance, LINK_STATE_ATTACHED);
+            }
+            else if (send_attach(link_instance, link_instance->role) == 0)
+            {
+                set_link_state(link_instance, LINK_STATE_HALF_ATTACHED_ATTACH_SENT);
+            }
+        }
+    }
+    else if (new_session_state == SESSION_STATE_DISCARDING)
+    {
+        remove_all_pending_deliveries(link_instance, true);
+        set_link_state(link_instance, LINK_STATE_DETACHED);
+    }
+    else if (new_session_state == SESSION_STATE_ERROR)
+    {
+        remove_all_pending_deliveries(link_instance, true);
+        set_link_state(link_instance, LINK_STATE_ERROR);
+    }
+}
+
+static void on_session_flow_on(void* context)
+{
+    LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
+    if (link_instance->role == role_sender)
+    {
+        link_instance->on_link_flow_on(link_instance->callback_context);
+    }
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    ASYNC_OPERATION_HANDLE pending_delivery_operation = (ASYNC_OPERATION_HANDLE)context;
+    DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, pending_delivery_operation);
+    LINK_HANDLE link = (LINK_HANDLE)delivery_instance->link;
+    (void)send_result;
+    if (link->snd_settle_mode == sender_settle_mode_settled)
+    {
+        delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_SETTLED, NULL);
+        remove_pending_delivery_operation(link, pending_delivery_operation);
+        async_operation_destroy(pending_delivery_operation);
+    }
+}
+
+LINK_HANDLE link_create(SESSION_HANDLE session, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    LINK_INSTANCE* result = (LINK_INSTANCE*)malloc(sizeof(LINK_INSTANCE));
+    if (result == NULL)
+    {
+        LogError("Cannot create link");
+    }
+    else
+    {
+        result->link_state = LINK_STATE_DETACHED;
+        result->previous_link_state = LINK_STATE_DETACHED;
+        result->role = role;
+        result->session = session;
+        if (session_get_connection(session, &result->connection) != 0)
+        {
+            result->connection = NULL;
+        }
+        result->handle = 0;
+        result->snd_settle_mode = sender_settle_mode_unsettled;
+        result->transfer_count = 0;
+        result->delivery_tag_length = DEFAULT_DELIVERY_TAG_LENGTH;
+        result->rcv_settle_mode = receiver_settle_mode_first;
+        result->delivery_count = 0;
+        result->initial_delivery_count = 0;
+        result->max_message_size = 0;
+        result->max_link_credit = DEFAULT_LINK_CREDIT;
+        result->credit_policy = LINK_CREDIT_POLICY_REFILL_AT_ZERO;
+        result->credit_low_water_mark = 0;
+        result->is_flow_paused = false;
+        result->is_draining = false;
+        result->max_buffered_bytes = 0;
+        result->resume_buffered_bytes = 0;
+        result->buffered_bytes = 0;
+        result->received_delivery_bytes = 0;
+        result->average_delivery_size = 0;
+        result->unsettled_received_deliveries = NULL;
+        result->unsettled_received_count = 0;
+        result->unsettled_received_capacity = 0;
+        result->is_credit_held = false;
+        result->is_received_delivery_settled = false;
+        result->on_link_drained = NULL;
+        result->on_link_drained_context = NULL;
+        result->streamed_delivery = NULL;
+        result->peer_max_message_size = 0;
+        result->is_underlying_session_begun = false;
+        result->is_closed = false;
+        result->is_resuming_handover = false;
+        result->encoded_attach_properties = NULL;
+        result->encoded_attach_properties_size = 0;
+        result->unsettled = NULL;
+        result->peer_unsettled = NULL;
+        result->received_payload = NULL;
+        result->received_payload_size = 0;
+        result->received_payload_capacity = 0;
+        result->received_delivery_id = 0;
+        result->on_transfer_frame_received = NULL;
+        result->on_disposition_processed = NULL;
+        result->is_receiving_streamed_delivery = false;
+        result->is_discarding_delivery = false;
+        result->is_credit_exhausted = false;
+        result->disposition_batch_size = 0;
+        result->disposition_batch_max_delay = 0;
+        result->batched_disposition_count = 0;
+        result->batched_disposition_states[BATCHED_OUTCOME_ACCEPTED] = NULL;
+        result->batched_disposition_states[BATCHED_OUTCOME_RELEASED] = NULL;
+        result->batched_disposition_bits = NULL;
+        result->disposition_window_size = 0;
+        result->transfer_state = NULL;
+
+        result->encoded_terminus = NULL;
+        result->encoded_source_size = 0;
+        result->encoded_target_size = 0;
+        /* the pending deliveries are allocated by the first transfer */
+        result->pending_deliveries = NULL;
+        result->pending_delivery_capacity = 0;
+        result->pending_delivery_head = 0;
+        result->pending_delivery_span = 0;
+        result->oldest_pending_delivery_id = 0;
+        result->delivery_operation_pool = NULL;
+        result->on_link_state_changed = NULL;
+        result->callback_context = NULL;
+
+        (void)memset(&result->stats, 0, sizeof(result->stats));
+        result->tick_counter = tickcounter_create();
+        if (result->tick_counter == NULL)
+        {
+            LogError("Cannot create tick counter for link");
+            free(result);
+            result = NULL;
+        }
+        else if (encode_terminus(result, source, target) != 0)
+        {
+            LogError("Cannot keep the link source and target");
+            tickcounter_destroy(result->tick_counter);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            set_link_state(result, LINK_STATE_DETACHED);
+
+            /* the endpoint keeps the only copy of the name */
+            result->link_endpoint = session_create_link_endpoint(session, name);
+            if (result->link_endpoint == NULL)
+            {
+                LogError("Cannot create link endpoint");
+                tickcounter_destroy(result->tick_counter);
+                free(result->encoded_terminus);
+                free(result);
+                result = NULL;
+            }
+        }
+    }
+
+    if (result != NULL)
+    {
+        ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_LINK, sizeof(LINK_INSTANCE));
+    }
+
+    return result;
+}
+
+LINK_HANDLE link_create_from_endpoint(SESSION_HANDLE session, LINK_ENDPOINT_HANDLE link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    LINK_INSTANCE* result = (LINK_INSTANCE*)malloc(sizeof(LINK_INSTANCE));
+
+    /* the name is read from the endpoint, which was created with it */
+    (void)name;
+    if (result == NULL)
+    {
+        LogError("Cannot create link");
+    }
+    else
+    {
+        result->link_state = LINK_STATE_DETACHED;
+        result->previous_link_state = LINK_STATE_DETACHED;
+        result->session = session;
+        if (session_get_connection(session, &result->connection) != 0)
+        {
+            result->connection = NULL;
+        }
+        result->handle = 0;
+        result->snd_settle_mode = sender_settle_mode_unsettled;
+        result->transfer_count = 0;
+        result->delivery_tag_length = DEFAULT_DELIVERY_TAG_LENGTH;
+        result->rcv_settle_mode = receiver_settle_mode_first;
+        result->delivery_count = 0;
+        result->initial_delivery_count = 0;
+        result->max_message_size = 0;
+        result->max_link_credit = DEFAULT_LINK_CREDIT;
+        result->credit_policy = LINK_CREDIT_POLICY_REFILL_AT_ZERO;
+        result->credit_low_water_mark = 0;
+        result->is_flow_paused = false;
+        result->is_draining = false;
+        result->max_buffered_bytes = 0;
+        result->resume_buffered_bytes = 0;
+        result->buffered_bytes = 0;
+        result->received_delivery_bytes = 0;
+        result->average_delivery_size = 0;
+        result->unsettled_received_deliveries = NULL;
+        result->unsettled_received_count = 0;
+        result->unsettled_received_capacity = 0;
+        result->is_credit_held = false;
+        result->is_received_delivery_settled = false;
+        result->on_link_drained = NULL;
+        result->on_link_drained_context = NULL;
+        result->streamed_delivery = NULL;
+        result->peer_max_message_size = 0;
+        result->is_underlying_session_begun = false;
+        result->is_closed = false;
+        result->is_resuming_handover = false;
+        result->encoded_attach_properties = NULL;
+        result->encoded_attach_properties_size = 0;
+        result->unsettled = NULL;
+        result->peer_unsettled = NULL;
+        result->received_payload = NULL;
+        result->received_payload_size = 0;
+        result->received_payload_capacity = 0;
+        result->received_delivery_id = 0;
+        result->on_transfer_frame_received = NULL;
+        result->on_disposition_processed = NULL;
+        result->is_receiving_streamed_delivery = false;
+        result->is_discarding_delivery = false;
+        result->is_credit_exhausted = false;
+        result->disposition_batch_size = 0;
+        result->disposition_batch_max_delay = 0;
+        result->batched_disposition_count = 0;
+        result->batched_disposition_states[BATCHED_OUTCOME_ACCEPTED] = NULL;
+        result->batched_disposition_states[BATCHED_OUTCOME_RELEASED] = NULL;
+        result->batched_disposition_bits = NULL;
+        result->disposition_window_size = 0;
+        result->transfer_state = NULL;
+        if (role == role_sender)
+        {
+            result->role = role_receiver;
+        }
+        else
+        {
+            result->role = role_sender;
+        }
+
+        result->encoded_terminus = NULL;
+        result->encoded_source_size = 0;
+        result->encoded_target_size = 0;
+        /* the pending deliveries are allocated by the first transfer */
+        result->pending_deliveries = NULL;
+        result->pending_delivery_capacity = 0;
+        result->pending_delivery_head = 0;
+        result->pending_delivery_span = 0;
+        result->oldest_pending_delivery_id = 0;
+        result->delivery_operation_pool = NULL;
+        result->on_link_state_changed = NULL;
+        result->callback_context = NULL;
+        result->link_endpoint = link_endpoint;
+
+        (void)memset(&result->stats, 0, sizeof(result->stats));
+        result->tick_counter = tickcounter_create();
+        if (result->tick_counter == NULL)
+        {
+            LogError("Cannot create tick counter for link");
+            free(result);
+            result = NULL;
+        }
+        /* the source of the peer is the target of this link and the other way around */
+        else if (encode_terminus(result, target, source) != 0)
+        {
+            LogError("Cannot keep the link source and target");
+            tickcounter_destroy(result->tick_counter);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    if (result != NULL)
+    {
+        ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_LINK, sizeof(LINK_INSTANCE));
+    }
+
+    return result;
+}
+
+void link_destroy(LINK_HANDLE link)
+{
+    if (link == NULL)
+    {
+        LogError("NULL link");
+    }
+    else
+    {
+        int i;
+
+        remove_all_pending_deliveries((LINK_INSTANCE*)link, false);
+        tickcounter_destroy(link->tick_counter);
+
+        if (link->delivery_operation_pool != NULL)
+        {
+            async_operation_pool_destroy(link->delivery_operation_pool);
+        }
+
+        link->on_link_state_changed = NULL;
+        (void)link_detach(link, true);
+        session_destroy_link_endpoint(link->link_endpoint);
+        clear_buffered_bytes(link);
+
+        if (link->encoded_terminus != NULL)
+        {
+            free(link->encoded_terminus);
+        }
+
+        free(link->unsettled_received_deliveries);
+
+        if (link->encoded_attach_properties != NULL)
+        {
+            free(link->encoded_attach_properties);
+        }
+
+        if (link->unsettled != NULL)
+        {
+            amqpvalue_destroy(link->unsettled);
+        }
+
+        if (link->peer_unsettled != NULL)
+        {
+            amqpvalue_destroy(link->peer_unsettled);
+        }
+
+        if (link->received_payload != NULL)
+        {
+            release_received_payload_memory(link);
+            free(link->received_payload);
+        }
+
+        for (i = 0; i < BATCHED_OUTCOME_COUNT; i++)
+        {
+            if (link->batched_disposition_states[i] != NULL)
+            {
+                amqpvalue_destroy(link->batched_disposition_states[i]);
+            }
+        }
+
+        free(link->batched_disposition_bits);
+
+        if (link->transfer_state != NULL)
+        {
+            amqpvalue_destroy(link->transfer_state);
+        }
+
+        ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_LINK, sizeof(LINK_INSTANCE));
+        free(link);
+    }
+}
+
+int link_set_snd_settle_mode(LINK_HANDLE link, sender_settle_mode snd_settle_mode)
+{
+    int result;
+
+    if (link == NULL)
+    {
+        LogError("NULL link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        link->snd_settle_mode = snd_settle_mode;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_get_snd_settle_mode(LINK_HANDLE link, sender_settle_mode* snd_settle_mode)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (snd_settle_mode == NULL))
+    {
+        LogError("Bad arguments: link = %p, snd_settle_mode = %p",
+            link, snd_settle_mode);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *snd_settle_mode = link->snd_settle_mode;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_set_rcv_settle_mode(LINK_HANDLE link, receiver_settle_mode rcv_settle_mode)
+{
+    int result;
+
+    if (link == NULL)
+    {
+        LogError("NULL link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        link->rcv_settle_mode = rcv_settle_mode;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_get_rcv_settle_mode(LINK_HANDLE link, receiver_settle_mode* rcv_settle_mode)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (rcv_settle_mode == NULL))
+    {
+        LogError("Bad arguments: link = %p, rcv_settle_mode = %p",
+            link, rcv_settle_mode);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *rcv_settle_mode = link->rcv_settle_mode;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_set_initial_delivery_count(LINK_HANDLE link, sequence_no initial_delivery_count)
+{
+    int result;
+
+    if (link == NULL)
+    {
+        LogError("NULL link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        link->initial_delivery_count = initial_delivery_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_get_initial_delivery_count(LINK_HANDLE link, sequence_no* initial_delivery_count)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (initial_delivery_count == NULL))
+    {
+        LogError("Bad arguments: link = %p, initial_delivery_count = %p",
+            link, initial_delivery_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *initial_delivery_count = link->initial_delivery_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_set_max_message_size(LINK_HANDLE link, uint64_t max_message_size)
+{
+    int result;
+
+    if (link == NULL)
+    {
+        LogError("NULL link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        link->max_message_size = max_message_size;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_get_max_message_size(LINK_HANDLE link, uint64_t* max_message_size)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (max_message_size == NULL))
+    {
+        LogError("Bad arguments: link = %p, max_message_size = %p",
+            link, max_message_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *max_message_size = link->max_message_size;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_get_stats(LINK_HANDLE link, LINK_STATS* stats)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (stats == NULL))
+    {
+        LogError("Bad arguments: link = %p, stats = %p",
+            link, stats);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *stats = link->stats;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_get_peer_max_message_size(LINK_HANDLE link, uint64_t* peer_max_message_size)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (peer_max_message_size == NULL))
+    {
+        LogError("Bad arguments: link = %p, peer_max_message_size = %p",
+            link, peer_max_message_size);
+        result = __FAILURE__;
+    }
+    else if ((link->link_state != LINK_STATE_ATTACHED) &&
+        (link->link_state != LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED))
+    {
+        LogError("Attempting to read peer max message size before it was received");
+        result = __FAILURE__;
+    }
+    else
+    {
+        *peer_max_message_size = link->peer_max_message_size;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_set_attach_properties(LINK_HANDLE link, fields attach_properties)
+{
+    int result;
 
-        result->tick_counter = tickcounter_create();
-        if (result->tick_counter == NULL)
+    if (link == NULL)
+    {
+        LogError("NULL link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t encoded_size;
+        unsigned char* encoded_attach_properties;
+
+        if ((attach_properties == NULL) ||
+            (amqpvalue_get_encoded_size(attach_properties, &encoded_size) != 0) ||
+            (encoded_size == 0) ||
+            (encoded_size > UINT32_MAX))
         {
-            LogError("Cannot create tick counter for link");
-            free(result);
-            result = NULL;
+            LogError("Cannot get the encoded size of the attach properties");
+            result = __FAILURE__;
+        }
+        else if ((encoded_attach_properties = (unsigned char*)malloc(encoded_size)) == NULL)
+        {
+            LogError("Cannot allocate memory for the attach properties");
+            result = __FAILURE__;
+        }
+        else if (amqpvalue_encode_to_buffer(attach_properties, encoded_attach_properties, encoded_size, &encoded_size) != 0)
+        {
+            LogError("Cannot encode the attach properties");
+            free(encoded_attach_properties);
+            result = __FAILURE__;
         }
         else
         {
-            result->pending_deliveries = singlylinkedlist_create();
-            if (result->pending_deliveries == NULL)
+            if (link->encoded_attach_properties != NULL)
             {
-                LogError("Cannot create pending deliveries list");
-                tickcounter_destroy(result->tick_counter);
-                free(result);
-                result = NULL;
+                free(link->encoded_attach_properties);
             }
-            else
-            {
-                size_t name_length = strlen(name);
-                result->name = (char*)malloc(name_length + 1);
-                if (result->name == NULL)
-                {
-                    LogError("Cannot allocate memory for link name");
-                    tickcounter_destroy(result->tick_counter);
-                    singlylinkedlist_destroy(result->pending_deliveries);
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    result->on_link_state_changed = NULL;
-                    result->callback_context = NULL;
-                    set_link_state(result, LINK_STATE_DETACHED);
 
-                    (void)memcpy(result->name, name, name_length + 1);
-                    result->link_endpoint = session_create_link_endpoint(session, name);
-                    if (result->link_endpoint == NULL)
-                    {
-                        LogError("Cannot create link endpoint");
-                        tickcounter_destroy(result->tick_counter);
-                        singlylinkedlist_destroy(result->pending_deliveries);
-                        free(result->name);
-                        free(result);
-                        result = NULL;
-                    }
-                }
-            }
+            link->encoded_attach_properties = encoded_attach_properties;
+            link->encoded_attach_properties_size = (uint32_t)encoded_size;
+            result = 0;
         }
     }
 
     return result;
 }
 
-LINK_HANDLE link_create_from_endpoint(SESSION_HANDLE session, LINK_ENDPOINT_HANDLE link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+int link_set_attach_unsettled(LINK_HANDLE link, AMQP_VALUE unsettled)
 {
-    LINK_INSTANCE* result = (LINK_INSTANCE*)malloc(sizeof(LINK_INSTANCE));
-    if (result == NULL)
+    int result;
+
+    if (link == NULL)
     {
-        LogError("Cannot create link");
+        LogError("NULL link");
+        result = __FAILURE__;
     }
     else
     {
-        result->link_state = LINK_STATE_DETACHED;
-        result->previous_link_state = LINK_STATE_DETACHED;
-        result->session = session;
-        result->handle = 0;
-        result->snd_settle_mode = sender_settle_mode_unsettled;
-        result->rcv_settle_mode = receiver_settle_mode_first;
-        result->delivery_count = 0;
-        result->initial_delivery_count = 0;
-        result->max_message_size = 0;
-        result->max_link_credit = DEFAULT_LINK_CREDIT;
-        result->peer_max_message_size = 0;
-        result->is_underlying_session_begun = false;
-        result->is_closed = false;
-        result->attach_properties = NULL;
-        result->received_payload = NULL;
-        result->received_payload_size = 0;
-        result->received_delivery_id = 0;
-        result->source = amqpvalue_clone(target);
-        result->target = amqpvalue_clone(source);
-
-        if (role == role_sender)
-        {
-            result->role = role_receiver;
-        }
-        else
-        {
-            result->role = role_sender;
-        }
+        AMQP_VALUE new_unsettled;
 
-        result->tick_counter = tickcounter_create();
-        if (result->tick_counter == NULL)
+        if (unsettled == NULL)
         {
-            LogError("Cannot create tick counter for link");
-            free(result);
-            result = NULL;
+            new_unsettled = NULL;
+            result = 0;
         }
         else
         {
-            result->pending_deliveries = singlylinkedlist_create();
-            if (result->pending_deliveries == NULL)
+            new_unsettled = amqpvalue_clone(unsettled);
+            if (new_unsettled == NULL)
             {
-                LogError("Cannot create pending deliveries list");
-                tickcounter_destroy(result->tick_counter);
-                free(result);
-                result = NULL;
+                LogError("Failed cloning the unsettled map");
+                result = __FAILURE__;
             }
             else
             {
-                size_t name_length = strlen(name);
-                result->name = (char*)malloc(name_length + 1);
-                if (result->name == NULL)
-                {
-                    LogError("Cannot allocate memory for link name");
-                    tickcounter_destroy(result->tick_counter);
-                    singlylinkedlist_destroy(result->pending_deliveries);
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    (void)memcpy(result->name, name, name_length + 1);
-                    result->on_link_state_changed = NULL;
-                    result->callback_context = NULL;
-                    result->link_endpoint = link_endpoint;
-                }
+                result = 0;
             }
         }
+
+        if (result == 0)
+        {
+            if (link->unsettled != NULL)
+            {
+                amqpvalue_destroy(link->unsettled);
+            }
+
+            link->unsettled = new_unsettled;
+        }
     }
 
     return result;
 }
 
-void link_destroy(LINK_HANDLE link)
+int link_get_peer_unsettled(LINK_HANDLE link, AMQP_VALUE* peer_unsettled)
 {
-    if (link == NULL)
+    int result;
+
+    if ((link == NULL) ||
+        (peer_unsettled == NULL))
     {
-        LogError("NULL link");
+        LogError("Bad arguments: link = %p, peer_unsettled = %p",
+            link, peer_unsettled);
+        result = __FAILURE__;
     }
     else
     {
-        remove_all_pending_deliveries((LINK_INSTANCE*)link, false);
-        tickcounter_destroy(link->tick_counter);
+        *peer_unsettled = link->peer_unsettled;
+        result = 0;
+    }
 
-        link->on_link_state_changed = NULL;
-        (void)link_detach(link, true);
-        session_destroy_link_endpoint(link->link_endpoint);
-        amqpvalue_destroy(link->source);
-        amqpvalue_destroy(link->target);
+    return result;
+}
 
-        if (link->name != NULL)
-        {
-            free(link->name);
-        }
+int link_get_delivery_count(LINK_HANDLE link, sequence_no* delivery_count)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (delivery_count == NULL))
+    {
+        LogError("Bad arguments: link = %p, delivery_count = %p",
+            link, delivery_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *delivery_count = link->delivery_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_set_max_link_credit(LINK_HANDLE link, uint32_t max_link_credit)
+{
+    int result;
+
+    if (link == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        link->max_link_credit = max_link_credit;
 
-        if (link->attach_properties != NULL)
+        /* an attached receiver announces the new credit right away instead of waiting for the current one to run out */
+        if (is_flow_issuing_receiver(link) &&
+            (!link->is_flow_paused))
         {
-            amqpvalue_destroy(link->attach_properties);
+            if (refill_link_credit(link) != 0)
+            {
+                LogError("Cannot send flow with the new link credit");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
         }
-
-        if (link->received_payload != NULL)
+        else
         {
-            free(link->received_payload);
+            result = 0;
         }
-
-        free(link);
     }
+
+    return result;
 }
 
-int link_set_snd_settle_mode(LINK_HANDLE link, sender_settle_mode snd_settle_mode)
+int link_pause_flow(LINK_HANDLE link)
 {
     int result;
 
@@ -895,113 +2449,253 @@ int link_set_snd_settle_mode(LINK_HANDLE link, sender_settle_mode snd_settle_mod
         LogError("NULL link");
         result = __FAILURE__;
     }
+    else if (link->role != role_receiver)
+    {
+        LogError("Only a receiving link can pause its flow");
+        result = __FAILURE__;
+    }
     else
     {
-        link->snd_settle_mode = snd_settle_mode;
-        result = 0;
+        link->is_flow_paused = true;
+
+        /* withdraw the outstanding credit, transfers the sender already has in flight are still received */
+        if (is_flow_issuing_receiver(link) &&
+            (link->current_link_credit > 0))
+        {
+            link->current_link_credit = 0;
+            if (send_flow(link) != 0)
+            {
+                LogError("Cannot send flow withdrawing the link credit");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
     }
 
     return result;
 }
 
-int link_get_snd_settle_mode(LINK_HANDLE link, sender_settle_mode* snd_settle_mode)
+int link_resume_flow(LINK_HANDLE link)
 {
     int result;
 
-    if ((link == NULL) ||
-        (snd_settle_mode == NULL))
+    if (link == NULL)
     {
-        LogError("Bad arguments: link = %p, snd_settle_mode = %p",
-            link, snd_settle_mode);
+        LogError("NULL link");
+        result = __FAILURE__;
+    }
+    else if (link->role != role_receiver)
+    {
+        LogError("Only a receiving link can resume its flow");
         result = __FAILURE__;
     }
     else
     {
-        *snd_settle_mode = link->snd_settle_mode;
+        link->is_flow_paused = false;
 
-        result = 0;
+        if (is_flow_issuing_receiver(link))
+        {
+            if (refill_link_credit(link) != 0)
+            {
+                LogError("Cannot send flow restoring the link credit");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
     }
 
     return result;
 }
 
-int link_set_rcv_settle_mode(LINK_HANDLE link, receiver_settle_mode rcv_settle_mode)
+int link_drain(LINK_HANDLE link, uint32_t link_credit, tickcounter_ms_t timeout, ON_LINK_DRAINED on_link_drained, void* context)
 {
     int result;
 
-    if (link == NULL)
+    if ((link == NULL) ||
+        (link_credit == 0) ||
+        (on_link_drained == NULL))
     {
-        LogError("NULL link");
+        LogError("Bad arguments: link = %p, link_credit = %u, on_link_drained = %p",
+            link, (unsigned int)link_credit, on_link_drained);
+        result = __FAILURE__;
+    }
+    else if (!is_flow_issuing_receiver(link))
+    {
+        LogError("Only an attached receiving link can drain");
+        result = __FAILURE__;
+    }
+    else if (link->is_draining)
+    {
+        LogError("A drain is already in progress");
+        result = __FAILURE__;
+    }
+    else if ((timeout != 0) &&
+        (tickcounter_get_current_ms(link->tick_counter, &link->drain_start_tick) != 0))
+    {
+        LogError("Cannot get tick counter value");
+        result = __FAILURE__;
+    }
+    else if (session_send_link_drain_flow(link->link_endpoint, link->delivery_count, link_credit) != 0)
+    {
+        LogError("Cannot send drain flow");
         result = __FAILURE__;
     }
     else
     {
-        link->rcv_settle_mode = rcv_settle_mode;
+        /* the credit is not refilled as the drain uses it */
+        link->is_flow_paused = true;
+        link->current_link_credit = link_credit;
+        link->drain_timeout = timeout;
+        link->on_link_drained = on_link_drained;
+        link->on_link_drained_context = context;
+        link->is_draining = true;
         result = 0;
     }
 
     return result;
 }
 
-int link_get_rcv_settle_mode(LINK_HANDLE link, receiver_settle_mode* rcv_settle_mode)
+int link_set_max_buffered_bytes(LINK_HANDLE link, uint64_t max_buffered_bytes, uint64_t resume_buffered_bytes)
 {
     int result;
 
     if ((link == NULL) ||
-        (rcv_settle_mode == NULL))
+        (resume_buffered_bytes > max_buffered_bytes))
     {
-        LogError("Bad arguments: link = %p, rcv_settle_mode = %p",
-            link, rcv_settle_mode);
+        LogError("Bad arguments: link = %p, max_buffered_bytes = %llu, resume_buffered_bytes = %llu",
+            link, (unsigned long long)max_buffered_bytes, (unsigned long long)resume_buffered_bytes);
+        result = __FAILURE__;
+    }
+    else if (link->role != role_receiver)
+    {
+        LogError("Only a receiving link buffers received bytes");
         result = __FAILURE__;
     }
     else
     {
-        *rcv_settle_mode = link->rcv_settle_mode;
+        link->max_buffered_bytes = max_buffered_bytes;
+        link->resume_buffered_bytes = resume_buffered_bytes;
+
+        /* deliveries already received are not counted, the budget applies to the ones received from now on */
+        if (max_buffered_bytes == 0)
+        {
+            free(link->unsettled_received_deliveries);
+            link->unsettled_received_deliveries = NULL;
+            link->unsettled_received_capacity = 0;
+            link->unsettled_received_count = 0;
+            clear_buffered_bytes(link);
+            link->received_delivery_bytes = 0;
+
+            if (link->is_credit_held &&
+                (!link->is_flow_paused) &&
+                is_flow_issuing_receiver(link) &&
+                (refill_link_credit(link) != 0))
+            {
+                LogError("Cannot send flow with the held credit");
+            }
+        }
+
         result = 0;
     }
 
     return result;
 }
 
-int link_set_initial_delivery_count(LINK_HANDLE link, sequence_no initial_delivery_count)
+int link_set_credit_policy(LINK_HANDLE link, LINK_CREDIT_POLICY credit_policy, uint32_t low_water_mark)
 {
     int result;
 
-    if (link == NULL)
+    if ((link == NULL) ||
+        ((credit_policy != LINK_CREDIT_POLICY_REFILL_AT_ZERO) &&
+        (credit_policy != LINK_CREDIT_POLICY_LOW_WATER_MARK)))
     {
-        LogError("NULL link");
+        LogError("Bad arguments: link = %p, credit_policy = %d",
+            link, (int)credit_policy);
         result = __FAILURE__;
     }
     else
     {
-        link->initial_delivery_count = initial_delivery_count;
+        link->credit_policy = credit_policy;
+        link->credit_low_water_mark = (credit_policy == LINK_CREDIT_POLICY_LOW_WATER_MARK) ? low_water_mark : 0;
         result = 0;
     }
 
     return result;
 }
 
-int link_get_initial_delivery_count(LINK_HANDLE link, sequence_no* initial_delivery_count)
+int link_set_disposition_batching(LINK_HANDLE link, uint32_t max_batch_size, tickcounter_ms_t max_delay)
 {
     int result;
 
-    if ((link == NULL) ||
-        (initial_delivery_count == NULL))
+    if (link == NULL)
     {
-        LogError("Bad arguments: link = %p, initial_delivery_count = %p",
-            link, initial_delivery_count);
+        LogError("NULL link");
         result = __FAILURE__;
     }
     else
     {
-        *initial_delivery_count = link->initial_delivery_count;
-        result = 0;
+        uint32_t window_size = 0;
+        uint32_t* bits = NULL;
+
+        if (max_batch_size > 1)
+        {
+            /* a power of 2, so that delivery ids keep their bit when they wrap around */
+            window_size = MIN_DISPOSITION_WINDOW_SIZE;
+            while ((window_size < MAX_DISPOSITION_WINDOW_SIZE) &&
+                (window_size / 2 < max_batch_size))
+            {
+                window_size *= 2;
+            }
+        }
+
+        /* whatever was batched under the previous settings is settled right away */
+        if (flush_batched_dispositions(link) != 0)
+        {
+            LogError("Cannot flush batched dispositions");
+            result = __FAILURE__;
+        }
+        else if ((window_size > 0) &&
+            ((bits = (uint32_t*)calloc(BATCHED_OUTCOME_COUNT * (window_size / 32), sizeof(uint32_t))) == NULL))
+        {
+            LogError("Cannot allocate the disposition window");
+            result = __FAILURE__;
+        }
+        /* the batch is then also flushed from connection_dowork */
+        else if (session_set_link_endpoint_on_dowork(link->link_endpoint, (window_size > 0) ? on_link_endpoint_dowork : NULL, link) != 0)
+        {
+            LogError("Cannot set the dowork callback of the link endpoint");
+            free(bits);
+            result = __FAILURE__;
+        }
+        else
+        {
+            free(link->batched_disposition_bits);
+            link->batched_disposition_bits = bits;
+            link->disposition_window_size = window_size;
+            link->disposition_batch_size = max_batch_size;
+            link->disposition_batch_max_delay = max_delay;
+            result = 0;
+        }
     }
 
     return result;
 }
 
-int link_set_max_message_size(LINK_HANDLE link, uint64_t max_message_size)
+int link_set_transfer_state(LINK_HANDLE link, AMQP_VALUE transfer_state)
 {
     int result;
 
@@ -1012,60 +2706,75 @@ int link_set_max_message_size(LINK_HANDLE link, uint64_t max_message_size)
     }
     else
     {
-        link->max_message_size = max_message_size;
-        result = 0;
+        AMQP_VALUE cloned_transfer_state = NULL;
+
+        if ((transfer_state != NULL) &&
+            ((cloned_transfer_state = amqpvalue_clone(transfer_state)) == NULL))
+        {
+            LogError("Cannot clone the transfer state");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (link->transfer_state != NULL)
+            {
+                amqpvalue_destroy(link->transfer_state);
+            }
+
+            link->transfer_state = cloned_transfer_state;
+            result = 0;
+        }
     }
 
     return result;
 }
 
-int link_get_max_message_size(LINK_HANDLE link, uint64_t* max_message_size)
+int link_set_delivery_tag_length(LINK_HANDLE link, uint32_t delivery_tag_length)
 {
     int result;
 
     if ((link == NULL) ||
-        (max_message_size == NULL))
+        ((delivery_tag_length != sizeof(sequence_no)) && (delivery_tag_length != sizeof(uint64_t))))
     {
-        LogError("Bad arguments: link = %p, max_message_size = %p",
-            link, max_message_size);
+        LogError("Bad arguments: link = %p, delivery_tag_length = %u",
+            link, (unsigned int)delivery_tag_length);
         result = __FAILURE__;
     }
     else
     {
-        *max_message_size = link->max_message_size;
+        link->delivery_tag_length = delivery_tag_length;
         result = 0;
     }
 
     return result;
 }
 
-int link_get_peer_max_message_size(LINK_HANDLE link, uint64_t* peer_max_message_size)
+int link_set_on_transfer_frame_received(LINK_HANDLE link, ON_TRANSFER_FRAME_RECEIVED on_transfer_frame_received)
 {
     int result;
 
-    if ((link == NULL) ||
-        (peer_max_message_size == NULL))
+    if (link == NULL)
     {
-        LogError("Bad arguments: link = %p, peer_max_message_size = %p",
-            link, peer_max_message_size);
+        LogError("NULL link");
         result = __FAILURE__;
     }
-    else if ((link->link_state != LINK_STATE_ATTACHED) &&
-        (link->link_state != LINK_STATE_HALF_ATTACHED_ATTACH_RECEIVED))
+    else if (link->is_receiving_streamed_delivery ||
+        link->is_discarding_delivery ||
+        (link->received_payload_size > 0))
     {
-        LogError("Attempting to read peer max message size before it was received");
+        LogError("Cannot change how transfers are received in the middle of a delivery");
         result = __FAILURE__;
     }
     else
     {
-        *peer_max_message_size = link->peer_max_message_size;
+        link->on_transfer_frame_received = on_transfer_frame_received;
         result = 0;
     }
 
     return result;
 }
 
-int link_set_attach_properties(LINK_HANDLE link, fields attach_properties)
+int link_set_on_disposition_processed(LINK_HANDLE link, ON_LINK_DISPOSITION_PROCESSED on_disposition_processed)
 {
     int result;
 
@@ -1076,32 +2785,7 @@ int link_set_attach_properties(LINK_HANDLE link, fields attach_properties)
     }
     else
     {
-        link->attach_properties = amqpvalue_clone(attach_properties);
-        if (link->attach_properties == NULL)
-        {
-            LogError("Failed cloning attach properties");
-            result = __FAILURE__;
-        }
-        else
-        {
-            result = 0;
-        }
-    }
-
-    return result;
-}
-
-int link_set_max_link_credit(LINK_HANDLE link, uint32_t max_link_credit)
-{
-    int result;
-
-    if (link == NULL)
-    {
-        result = __FAILURE__;
-    }
-    else
-    {
-        link->max_link_credit = max_link_credit;
+        link->on_disposition_processed = on_disposition_processed;
         result = 0;
     }
 
@@ -1148,6 +2832,8 @@ int link_attach(LINK_HANDLE link, ON_TRANSFER_RECEIVED on_transfer_received, ON_
                 else
                 {
                     link->received_payload_size = 0;
+                    link->is_receiving_streamed_delivery = false;
+                    link->is_discarding_delivery = false;
 
                     result = 0;
                 }
@@ -1195,6 +2881,11 @@ int link_detach(LINK_HANDLE link, bool close)
             break;
 
         case LINK_STATE_ATTACHED:
+            if (flush_batched_dispositions(link) != 0)
+            {
+                LogError("Cannot flush batched dispositions before detaching");
+            }
+
             /* Send detach and wait for remote to respond */
             if (send_detach(link, close, NULL) != 0)
             {
@@ -1224,224 +2915,550 @@ int link_detach(LINK_HANDLE link, bool close)
     return result;
 }
 
-static bool remove_pending_delivery_condition_function(const void* item, const void* match_context, bool* continue_processing)
+static void link_transfer_cancel_handler(ASYNC_OPERATION_HANDLE link_transfer_operation)
 {
-    bool result;
+    DELIVERY_INSTANCE* pending_delivery = GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, link_transfer_operation);
+    end_streamed_delivery((LINK_INSTANCE*)pending_delivery->link, link_transfer_operation);
+
+    if (pending_delivery->on_delivery_settled != NULL)
+    {
+        pending_delivery->on_delivery_settled(pending_delivery->callback_context, pending_delivery->delivery_id, LINK_DELIVERY_SETTLE_REASON_CANCELLED, NULL);
+    }
+    
+    remove_pending_delivery_operation((LINK_INSTANCE*)pending_delivery->link, link_transfer_operation);
+
+    async_operation_destroy(link_transfer_operation);
+}
+
+static ASYNC_OPERATION_HANDLE create_delivery_operation(LINK_INSTANCE* link)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((link->delivery_operation_pool == NULL) &&
+        ((link->delivery_operation_pool = CREATE_ASYNC_OPERATION_POOL(DELIVERY_INSTANCE, DELIVERY_OPERATION_POOL_SIZE)) == NULL))
+    {
+        /* the delivery can still be sent, its memory is just not pooled */
+        LogError("Cannot create the delivery operation pool");
+        result = CREATE_ASYNC_OPERATION(DELIVERY_INSTANCE, link_transfer_cancel_handler);
+    }
+    else
+    {
+        result = async_operation_create_from_pool(link->delivery_operation_pool, link_transfer_cancel_handler);
+    }
+
+    return result;
+}
+
+/* the tag lives in caller provided stack bytes and is copied by the session straight into the encoded transfer */
+static void build_delivery_tag(LINK_INSTANCE* link, sequence_no delivery_count, unsigned char* delivery_tag_bytes, delivery_tag* delivery_tag_value)
+{
+    if (link->delivery_tag_length == sizeof(uint64_t))
+    {
+        uint64_t transfer_number = link->transfer_count + 1;
+        (void)memcpy(delivery_tag_bytes, &transfer_number, sizeof(transfer_number));
+    }
+    else
+    {
+        (void)memcpy(delivery_tag_bytes, &delivery_count, sizeof(delivery_count));
+    }
+
+    delivery_tag_value->bytes = delivery_tag_bytes;
+    delivery_tag_value->length = link->delivery_tag_length;
+}
+
+int link_get_next_delivery_tag(LINK_HANDLE link, unsigned char* delivery_tag_bytes, uint32_t* delivery_tag_length)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (delivery_tag_bytes == NULL) ||
+        (delivery_tag_length == NULL))
+    {
+        LogError("Bad arguments: link = %p, delivery_tag_bytes = %p, delivery_tag_length = %p",
+            link, delivery_tag_bytes, delivery_tag_length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        delivery_tag delivery_tag_value;
+
+        build_delivery_tag(link, link->delivery_count + 1, delivery_tag_bytes, &delivery_tag_value);
+        *delivery_tag_length = delivery_tag_value.length;
+        result = 0;
+    }
+
+    return result;
+}
+
+static SESSION_SEND_TRANSFER_RESULT send_delivery_transfer(LINK_INSTANCE* link, delivery_tag delivery_tag, message_format message_format, bool settled, PAYLOAD* payloads, size_t payload_count, delivery_number* delivery_id, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    SESSION_SEND_TRANSFER_RESULT result;
+
+    if (link->transfer_state == NULL)
+    {
+        /* the session keeps the encoded transfer performative of the link and only patches the per delivery fields */
+        result = session_send_templated_transfer(link->link_endpoint, delivery_tag, message_format, settled, payloads, payload_count, delivery_id, on_send_complete, callback_context);
+    }
+    else
+    {
+        /* the template has no state field, so these go through a transfer performative */
+        TRANSFER_HANDLE transfer = transfer_create(link->handle);
+        if (transfer == NULL)
+        {
+            LogError("Error creating transfer");
+            result = SESSION_SEND_TRANSFER_ERROR;
+        }
+        else
+        {
+            if ((transfer_set_delivery_tag(transfer, delivery_tag) != 0) ||
+                (transfer_set_message_format(transfer, message_format) != 0) ||
+                (transfer_set_settled(transfer, settled) != 0) ||
+                (transfer_set_state(transfer, link->transfer_state) != 0))
+            {
+                LogError("Cannot set the transfer fields");
+                result = SESSION_SEND_TRANSFER_ERROR;
+            }
+            else
+            {
+                result = session_send_transfer(link->link_endpoint, transfer, payloads, payload_count, delivery_id, on_send_complete, callback_context);
+            }
+
+            transfer_destroy(transfer);
+        }
+    }
+
+    return result;
+}
+
+ASYNC_OPERATION_HANDLE link_transfer_async(LINK_HANDLE link, message_format message_format, PAYLOAD* payloads, size_t payload_count, ON_DELIVERY_SETTLED on_delivery_settled, void* callback_context, LINK_TRANSFER_RESULT* link_transfer_error, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((link == NULL) ||
+        (link_transfer_error == NULL))
+    {
+        if (link_transfer_error != NULL)
+        {
+            *link_transfer_error = LINK_TRANSFER_ERROR;
+        }
+
+        LogError("Invalid arguments: link = %p, link_transfer_error = %p",
+            link, link_transfer_error);
+        result = NULL;
+    }
+    else
+    {
+        if (link->role != role_sender)
+        {
+            LogError("Link is not a sender link");
+            *link_transfer_error = LINK_TRANSFER_ERROR;
+            result = NULL;
+        }
+        else if (link->link_state != LINK_STATE_ATTACHED)
+        {
+            LogError("Link is not attached");
+            *link_transfer_error = LINK_TRANSFER_ERROR;
+            result = NULL;
+        }
+        else if (link->streamed_delivery != NULL)
+        {
+            *link_transfer_error = LINK_TRANSFER_BUSY;
+            result = NULL;
+        }
+        else if (link->current_link_credit == 0)
+        {
+            count_credit_stall(link);
+            *link_transfer_error = LINK_TRANSFER_BUSY;
+            result = NULL;
+        }
+        else
+        {
+            UAMQP_TRACEPOINT1(link_transfer_start, payload_count);
+
+            result = create_delivery_operation(link);
+            if (result == NULL)
+            {
+                LogError("Error creating async operation");
+                *link_transfer_error = LINK_TRANSFER_ERROR;
+            }
+            else
+            {
+                sequence_no delivery_count = link->delivery_count + 1;
+                unsigned char delivery_tag_bytes[MAX_DELIVERY_TAG_LENGTH];
+                delivery_tag delivery_tag;
+                bool settled;
+                DELIVERY_INSTANCE* pending_delivery;
+
+                build_delivery_tag(link, delivery_count, delivery_tag_bytes, &delivery_tag);
+
+                if (link->snd_settle_mode == sender_settle_mode_unsettled)
+                {
+                    settled = false;
+                }
+                else
+                {
+                    settled = true;
+                }
+
+                pending_delivery = GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, result);
+                if (pending_delivery == NULL)
+                {
+                    LogError("Failed getting pending delivery");
+                    *link_transfer_error = LINK_TRANSFER_ERROR;
+                    async_operation_destroy(result);
+                    result = NULL;
+                }
+                else
+                {
+                    if (tickcounter_get_current_ms(link->tick_counter, &pending_delivery->start_tick) != 0)
+                    {
+                        LogError("Failed getting current tick");
+                        *link_transfer_error = LINK_TRANSFER_ERROR;
+                        async_operation_destroy(result);
+                        result = NULL;
+                    }
+                    else
+                    {
+                        delivery_number delivery_id;
+
+                        pending_delivery->timeout = timeout;
+                        pending_delivery->on_delivery_settled = on_delivery_settled;
+                        pending_delivery->callback_context = callback_context;
+                        pending_delivery->link = link;
+
+                        /* the delivery is tracked before it is sent, as the send can complete (and release a settled delivery) before it returns */
+                        if ((session_get_next_delivery_id(link->link_endpoint, &pending_delivery->delivery_id) != 0) ||
+                            (add_pending_delivery(link, result) != 0))
+                        {
+                            LogError("Failed adding delivery to the pending deliveries");
+                            *link_transfer_error = LINK_TRANSFER_ERROR;
+                            async_operation_destroy(result);
+                            result = NULL;
+                        }
+                        else
+                        {
+                            switch (send_delivery_transfer(link, delivery_tag, message_format, settled, payloads, payload_count, &delivery_id, (settled) ? on_send_complete : NULL, result))
+                            {
+                            default:
+                            case SESSION_SEND_TRANSFER_ERROR:
+                                LogError("Failed session send transfer");
+                                *link_transfer_error = LINK_TRANSFER_ERROR;
+                                remove_pending_delivery_operation(link, result);
+                                async_operation_destroy(result);
+                                result = NULL;
+                                break;
+
+                            case SESSION_SEND_TRANSFER_BUSY:
+                                /* The delivery is not tracked since sender will attempt to transfer again on flow on */
+                                LogError("Failed session send transfer");
+                                link->stats.session_window_stalls++;
+                                *link_transfer_error = LINK_TRANSFER_BUSY;
+                                remove_pending_delivery_operation(link, result);
+                                async_operation_destroy(result);
+                                result = NULL;
+                                break;
+
+                            case SESSION_SEND_TRANSFER_OK:
+                                /* the delivery may already be settled and released here, so only the local delivery id is used */
+                                UAMQP_TRACEPOINT2(link_transfer_sent, delivery_id, settled);
+                                link->delivery_count = delivery_count;
+                                link->transfer_count++;
+                                link->stats.transfers_sent++;
+                                link->current_link_credit--;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int link_transfer_settled(LINK_HANDLE link, message_format message_format, PAYLOAD* payloads, size_t payload_count, ON_SEND_COMPLETE on_send_complete, void* callback_context, LINK_TRANSFER_RESULT* link_transfer_result)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (link_transfer_result == NULL))
+    {
+        if (link_transfer_result != NULL)
+        {
+            *link_transfer_result = LINK_TRANSFER_ERROR;
+        }
 
-    if (item == match_context)
+        LogError("Invalid arguments: link = %p, link_transfer_result = %p",
+            link, link_transfer_result);
+        result = __FAILURE__;
+    }
+    else if (link->role != role_sender)
+    {
+        LogError("Link is not a sender link");
+        *link_transfer_result = LINK_TRANSFER_ERROR;
+        result = __FAILURE__;
+    }
+    else if (link->snd_settle_mode == sender_settle_mode_unsettled)
+    {
+        LogError("Link sender settle mode does not allow settled transfers");
+        *link_transfer_result = LINK_TRANSFER_ERROR;
+        result = __FAILURE__;
+    }
+    else if (link->link_state != LINK_STATE_ATTACHED)
+    {
+        LogError("Link is not attached");
+        *link_transfer_result = LINK_TRANSFER_ERROR;
+        result = __FAILURE__;
+    }
+    else if (link->streamed_delivery != NULL)
+    {
+        *link_transfer_result = LINK_TRANSFER_BUSY;
+        result = __FAILURE__;
+    }
+    else if (link->current_link_credit == 0)
     {
-        result = true;
-        *continue_processing = false;
+        count_credit_stall(link);
+        *link_transfer_result = LINK_TRANSFER_BUSY;
+        result = __FAILURE__;
     }
     else
     {
-        result = false;
-        *continue_processing = true;
-    }
+        sequence_no delivery_count = link->delivery_count + 1;
+        unsigned char delivery_tag_bytes[MAX_DELIVERY_TAG_LENGTH];
+        delivery_tag delivery_tag;
+        delivery_number delivery_id;
 
-    return result;
-}
+        build_delivery_tag(link, delivery_count, delivery_tag_bytes, &delivery_tag);
 
-static void link_transfer_cancel_handler(ASYNC_OPERATION_HANDLE link_transfer_operation)
-{
-    DELIVERY_INSTANCE* pending_delivery = GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, link_transfer_operation);
-    if (pending_delivery->on_delivery_settled != NULL)
-    {
-        pending_delivery->on_delivery_settled(pending_delivery->callback_context, pending_delivery->delivery_id, LINK_DELIVERY_SETTLE_REASON_CANCELLED, NULL);
+        /* the delivery is settled on the wire, so nothing is tracked and only the I/O outcome is reported */
+        switch (send_delivery_transfer(link, delivery_tag, message_format, true, payloads, payload_count, &delivery_id, on_send_complete, callback_context))
+        {
+        default:
+        case SESSION_SEND_TRANSFER_ERROR:
+            LogError("Failed session send transfer");
+            *link_transfer_result = LINK_TRANSFER_ERROR;
+            result = __FAILURE__;
+            break;
+
+        case SESSION_SEND_TRANSFER_BUSY:
+            link->stats.session_window_stalls++;
+            *link_transfer_result = LINK_TRANSFER_BUSY;
+            result = __FAILURE__;
+            break;
+
+        case SESSION_SEND_TRANSFER_OK:
+            UAMQP_TRACEPOINT2(link_transfer_sent, delivery_id, true);
+            link->delivery_count = delivery_count;
+            link->transfer_count++;
+            link->stats.transfers_sent++;
+            link->current_link_credit--;
+            result = 0;
+            break;
+        }
     }
-    
-    (void)singlylinkedlist_remove_if(((LINK_HANDLE)pending_delivery->link)->pending_deliveries, remove_pending_delivery_condition_function, pending_delivery);
 
-    async_operation_destroy(link_transfer_operation);
+    return result;
 }
 
-ASYNC_OPERATION_HANDLE link_transfer_async(LINK_HANDLE link, message_format message_format, PAYLOAD* payloads, size_t payload_count, ON_DELIVERY_SETTLED on_delivery_settled, void* callback_context, LINK_TRANSFER_RESULT* link_transfer_error, tickcounter_ms_t timeout)
+ASYNC_OPERATION_HANDLE link_transfer_stream_async(LINK_HANDLE link, message_format message_format, PAYLOAD* payloads, size_t payload_count, bool more, ON_SEND_COMPLETE on_part_sent, void* on_part_sent_context, ON_DELIVERY_SETTLED on_delivery_settled, void* callback_context, LINK_TRANSFER_RESULT* link_transfer_result, tickcounter_ms_t timeout)
 {
     ASYNC_OPERATION_HANDLE result;
 
     if ((link == NULL) ||
-        (link_transfer_error == NULL))
+        (link_transfer_result == NULL))
     {
-        if (link_transfer_error != NULL)
+        if (link_transfer_result != NULL)
         {
-            *link_transfer_error = LINK_TRANSFER_ERROR;
+            *link_transfer_result = LINK_TRANSFER_ERROR;
         }
 
-        LogError("Invalid arguments: link = %p, link_transfer_error = %p",
-            link, link_transfer_error);
+        LogError("Invalid arguments: link = %p, link_transfer_result = %p",
+            link, link_transfer_result);
+        result = NULL;
+    }
+    else if (link->role != role_sender)
+    {
+        LogError("Link is not a sender link");
+        *link_transfer_result = LINK_TRANSFER_ERROR;
+        result = NULL;
+    }
+    else if (link->snd_settle_mode != sender_settle_mode_unsettled)
+    {
+        /* the parts report their own completions, so only deliveries settled by a disposition can be streamed */
+        LogError("Streamed transfers need a link with the unsettled sender settle mode");
+        *link_transfer_result = LINK_TRANSFER_ERROR;
+        result = NULL;
+    }
+    else if (link->link_state != LINK_STATE_ATTACHED)
+    {
+        LogError("Link is not attached");
+        *link_transfer_result = LINK_TRANSFER_ERROR;
+        result = NULL;
+    }
+    else if (link->streamed_delivery != NULL)
+    {
+        *link_transfer_result = LINK_TRANSFER_BUSY;
+        result = NULL;
+    }
+    else if (link->current_link_credit == 0)
+    {
+        count_credit_stall(link);
+        *link_transfer_result = LINK_TRANSFER_BUSY;
         result = NULL;
     }
     else
     {
-        if (link->role != role_sender)
+        TRANSFER_HANDLE transfer = transfer_create(link->handle);
+        if (transfer == NULL)
         {
-            LogError("Link is not a sender link");
-            *link_transfer_error = LINK_TRANSFER_ERROR;
-            result = NULL;
-        }
-        else if (link->link_state != LINK_STATE_ATTACHED)
-        {
-            LogError("Link is not attached");
-            *link_transfer_error = LINK_TRANSFER_ERROR;
-            result = NULL;
-        }
-        else if (link->current_link_credit == 0)
-        {
-            *link_transfer_error = LINK_TRANSFER_BUSY;
+            LogError("Cannot create the transfer");
+            *link_transfer_result = LINK_TRANSFER_ERROR;
             result = NULL;
         }
         else
         {
-            result = CREATE_ASYNC_OPERATION(DELIVERY_INSTANCE, link_transfer_cancel_handler);
+            sequence_no delivery_count = link->delivery_count + 1;
+            unsigned char delivery_tag_bytes[MAX_DELIVERY_TAG_LENGTH];
+            delivery_tag delivery_tag;
+
+            build_delivery_tag(link, delivery_count, delivery_tag_bytes, &delivery_tag);
+
+            result = create_delivery_operation(link);
             if (result == NULL)
             {
                 LogError("Error creating async operation");
-                *link_transfer_error = LINK_TRANSFER_ERROR;
+                *link_transfer_result = LINK_TRANSFER_ERROR;
             }
             else
             {
-                TRANSFER_HANDLE transfer = transfer_create(0);
-                if (transfer == NULL)
+                DELIVERY_INSTANCE* pending_delivery = GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, result);
+
+                if ((transfer_set_delivery_tag(transfer, delivery_tag) != 0) ||
+                    (transfer_set_message_format(transfer, message_format) != 0) ||
+                    (transfer_set_settled(transfer, false) != 0) ||
+                    ((link->transfer_state != NULL) && (transfer_set_state(transfer, link->transfer_state) != 0)))
                 {
-                    LogError("Error creating transfer");
-                    *link_transfer_error = LINK_TRANSFER_ERROR;
+                    LogError("Cannot set the transfer fields");
+                    *link_transfer_result = LINK_TRANSFER_ERROR;
+                    async_operation_destroy(result);
+                    result = NULL;
+                }
+                else if (tickcounter_get_current_ms(link->tick_counter, &pending_delivery->start_tick) != 0)
+                {
+                    LogError("Failed getting current tick");
+                    *link_transfer_result = LINK_TRANSFER_ERROR;
                     async_operation_destroy(result);
                     result = NULL;
                 }
                 else
                 {
-                    sequence_no delivery_count = link->delivery_count + 1;
-                    unsigned char delivery_tag_bytes[sizeof(delivery_count)];
-                    delivery_tag delivery_tag;
-                    bool settled;
-
-                    (void)memcpy(delivery_tag_bytes, &delivery_count, sizeof(delivery_count));
-
-                    delivery_tag.bytes = &delivery_tag_bytes;
-                    delivery_tag.length = sizeof(delivery_tag_bytes);
+                    pending_delivery->timeout = timeout;
+                    pending_delivery->on_delivery_settled = on_delivery_settled;
+                    pending_delivery->callback_context = callback_context;
+                    pending_delivery->link = link;
 
-                    if (link->snd_settle_mode == sender_settle_mode_unsettled)
-                    {
-                        settled = false;
-                    }
-                    else
-                    {
-                        settled = true;
-                    }
+                    delivery_number delivery_id;
 
-                    if (transfer_set_delivery_tag(transfer, delivery_tag) != 0)
-                    {
-                        LogError("Failed setting delivery tag");
-                        *link_transfer_error = LINK_TRANSFER_ERROR;
-                        async_operation_destroy(result);
-                        result = NULL;
-                    }
-                    else if (transfer_set_message_format(transfer, message_format) != 0)
-                    {
-                        LogError("Failed setting message format");
-                        *link_transfer_error = LINK_TRANSFER_ERROR;
-                        async_operation_destroy(result);
-                        result = NULL;
-                    }
-                    else if (transfer_set_settled(transfer, settled) != 0)
+                    /* the delivery is tracked before it is sent, as the first part can complete before the send returns */
+                    if ((session_get_next_delivery_id(link->link_endpoint, &pending_delivery->delivery_id) != 0) ||
+                        (add_pending_delivery(link, result) != 0))
                     {
-                        LogError("Failed setting settled flag");
-                        *link_transfer_error = LINK_TRANSFER_ERROR;
+                        LogError("Failed adding delivery to the pending deliveries");
+                        *link_transfer_result = LINK_TRANSFER_ERROR;
                         async_operation_destroy(result);
                         result = NULL;
                     }
                     else
                     {
-                        AMQP_VALUE transfer_value = amqpvalue_create_transfer(transfer);
-                        if (transfer_value == NULL)
+                        if (more)
                         {
-                            LogError("Failed creating transfer performative AMQP value");
-                            *link_transfer_error = LINK_TRANSFER_ERROR;
-                            async_operation_destroy(result);
-                            result = NULL;
+                            link->streamed_delivery = result;
                         }
-                        else
+
+                        switch (session_send_transfer_part(link->link_endpoint, transfer, more, payloads, payload_count, &delivery_id, on_part_sent, on_part_sent_context))
                         {
-                            DELIVERY_INSTANCE* pending_delivery = GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, result);
-                            if (pending_delivery == NULL)
-                            {
-                                LogError("Failed getting pending delivery");
-                                *link_transfer_error = LINK_TRANSFER_ERROR;
-                                async_operation_destroy(result);
-                                result = NULL;
-                            }
-                            else
-                            {
-                                if (tickcounter_get_current_ms(link->tick_counter, &pending_delivery->start_tick) != 0)
-                                {
-                                    LogError("Failed getting current tick");
-                                    *link_transfer_error = LINK_TRANSFER_ERROR;
-                                    async_operation_destroy(result);
-                                    result = NULL;
-                                }
-                                else
-                                {
-                                    LIST_ITEM_HANDLE delivery_instance_list_item;
-                                    pending_delivery->timeout = timeout;
-                                    pending_delivery->on_delivery_settled = on_delivery_settled;
-                                    pending_delivery->callback_context = callback_context;
-                                    pending_delivery->link = link;
-                                    delivery_instance_list_item = singlylinkedlist_add(link->pending_deliveries, result);
-
-                                    if (delivery_instance_list_item == NULL)
-                                    {
-                                        LogError("Failed adding delivery to list");
-                                        *link_transfer_error = LINK_TRANSFER_ERROR;
-                                        async_operation_destroy(result);
-                                        result = NULL;
-                                    }
-                                    else
-                                    {
-                                        /* here we should feed data to the transfer frame */
-                                        switch (session_send_transfer(link->link_endpoint, transfer, payloads, payload_count, &pending_delivery->delivery_id, (settled) ? on_send_complete : NULL, delivery_instance_list_item))
-                                        {
-                                        default:
-                                        case SESSION_SEND_TRANSFER_ERROR:
-                                            LogError("Failed session send transfer");
-                                            if (singlylinkedlist_remove(link->pending_deliveries, delivery_instance_list_item) != 0)
-                                            {
-                                                LogError("Error removing pending delivery from the list");
-                                            }
-
-                                            *link_transfer_error = LINK_TRANSFER_ERROR;
-                                            async_operation_destroy(result);
-                                            result = NULL;
-                                            break;
-
-                                        case SESSION_SEND_TRANSFER_BUSY:
-                                            /* Ensure we remove from list again since sender will attempt to transfer again on flow on */
-                                            LogError("Failed session send transfer");
-                                            if (singlylinkedlist_remove(link->pending_deliveries, delivery_instance_list_item) != 0)
-                                            {
-                                                LogError("Error removing pending delivery from the list");
-                                            }
-
-                                            *link_transfer_error = LINK_TRANSFER_BUSY;
-                                            async_operation_destroy(result);
-                                            result = NULL;
-                                            break;
-
-                                        case SESSION_SEND_TRANSFER_OK:
-                                            link->delivery_count = delivery_count;
-                                            link->current_link_credit--;
-                                            break;
-                                        }
-                                    }
-                                }
-                            }
+                        default:
+                        case SESSION_SEND_TRANSFER_ERROR:
+                            LogError("Failed sending the first transfer part");
+                            *link_transfer_result = LINK_TRANSFER_ERROR;
+                            link->streamed_delivery = NULL;
+                            remove_pending_delivery_operation(link, result);
+                            async_operation_destroy(result);
+                            result = NULL;
+                            break;
+
+                        case SESSION_SEND_TRANSFER_BUSY:
+                            link->stats.session_window_stalls++;
+                            *link_transfer_result = LINK_TRANSFER_BUSY;
+                            link->streamed_delivery = NULL;
+                            remove_pending_delivery_operation(link, result);
+                            async_operation_destroy(result);
+                            result = NULL;
+                            break;
 
-                            amqpvalue_destroy(transfer_value);
+                        case SESSION_SEND_TRANSFER_OK:
+                            UAMQP_TRACEPOINT2(link_transfer_sent, delivery_id, false);
+                            link->delivery_count = delivery_count;
+                            link->transfer_count++;
+                            link->stats.transfers_sent++;
+                            link->current_link_credit--;
+                            break;
                         }
                     }
+                }
+            }
+
+            transfer_destroy(transfer);
+        }
+    }
+
+    return result;
+}
+
+int link_transfer_stream_continue(LINK_HANDLE link, PAYLOAD* payloads, size_t payload_count, bool more, ON_SEND_COMPLETE on_part_sent, void* on_part_sent_context)
+{
+    int result;
+
+    if (link == NULL)
+    {
+        LogError("NULL link");
+        result = __FAILURE__;
+    }
+    else if (link->streamed_delivery == NULL)
+    {
+        LogError("No streamed delivery in progress on the link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRANSFER_HANDLE transfer = transfer_create(link->handle);
+        if (transfer == NULL)
+        {
+            LogError("Cannot create the transfer");
+            result = __FAILURE__;
+        }
+        else
+        {
+            delivery_number delivery_id;
 
-                    transfer_destroy(transfer);
+            /* a failed part leaves the delivery in progress, cancelling its async operation aborts it */
+            if (session_send_transfer_part(link->link_endpoint, transfer, more, payloads, payload_count, &delivery_id, on_part_sent, on_part_sent_context) != SESSION_SEND_TRANSFER_OK)
+            {
+                LogError("Failed sending the transfer part");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (!more)
+                {
+                    link->streamed_delivery = NULL;
                 }
+
+                result = 0;
             }
+
+            transfer_destroy(transfer);
         }
     }
 
@@ -1457,9 +3474,33 @@ int link_get_name(LINK_HANDLE link, const char** link_name)
         LogError("NULL link");
         result = __FAILURE__;
     }
+    else if (session_get_link_endpoint_name(link->link_endpoint, link_name) != 0)
+    {
+        LogError("Cannot get the link endpoint name");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_get_connection(LINK_HANDLE link, CONNECTION_HANDLE* connection)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (connection == NULL))
+    {
+        LogError("Bad arguments: link = %p, connection = %p",
+            link, connection);
+        result = __FAILURE__;
+    }
     else
     {
-        *link_name = link->name;
+        *connection = link->connection;
         result = 0;
     }
 
@@ -1500,6 +3541,10 @@ int link_send_disposition(LINK_HANDLE link, delivery_number message_id, AMQP_VAL
             LogError("Cannot send disposition frame");
             result = __FAILURE__;
         }
+        else
+        {
+            settle_received_delivery(link, message_id);
+        }
     }
 
     return result;
@@ -1521,32 +3566,223 @@ void link_dowork(LINK_HANDLE link)
         }
         else
         {
-            // go through all and find timed out deliveries
-            LIST_ITEM_HANDLE item = singlylinkedlist_get_head_item(link->pending_deliveries);
-            while (item != NULL)
+            if (link->is_draining &&
+                (link->drain_timeout != 0) &&
+                (current_tick - link->drain_start_tick >= link->drain_timeout))
             {
-                LIST_ITEM_HANDLE next_item = singlylinkedlist_get_next_item(item);
-                ASYNC_OPERATION_HANDLE delivery_instance_async_operation = (ASYNC_OPERATION_HANDLE)singlylinkedlist_item_get_value(item);
-                DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, delivery_instance_async_operation);
+                /* withdraw what is left of the drain credit, transfers the sender already has in flight are still received */
+                link->current_link_credit = 0;
+                if (send_flow(link) != 0)
+                {
+                    LogError("Cannot send flow withdrawing the drain credit");
+                }
 
-                if ((delivery_instance->timeout != 0) &&
-                    (current_tick - delivery_instance->start_tick >= delivery_instance->timeout))
+                end_drain(link, LINK_DRAIN_RESULT_TIMEOUT);
+            }
+
+            flush_due_batched_dispositions(link, current_tick);
+
+            // go through all and find timed out deliveries
+            delivery_number delivery_id = link->oldest_pending_delivery_id;
+            uint32_t pending_delivery_span = link->pending_delivery_span;
+            uint32_t i;
+
+            for (i = 0; i < pending_delivery_span; i++, delivery_id++)
+            {
+                ASYNC_OPERATION_HANDLE* slot = get_pending_delivery_slot(link, delivery_id);
+                if ((slot != NULL) && (*slot != NULL))
                 {
-                    if (delivery_instance->on_delivery_settled != NULL)
-                    {
-                        delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_TIMEOUT, NULL);
-                    }
+                    DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)GET_ASYNC_OPERATION_CONTEXT(DELIVERY_INSTANCE, *slot);
 
-                    if (singlylinkedlist_remove(link->pending_deliveries, item) != 0)
+                    if ((delivery_instance->timeout != 0) &&
+                        (current_tick - delivery_instance->start_tick >= delivery_instance->timeout))
                     {
-                        LogError("Cannot remove item from list");
-                    }
+                        ASYNC_OPERATION_HANDLE delivery_instance_async_operation = remove_pending_delivery(link, delivery_id);
 
-                    async_operation_destroy(delivery_instance_async_operation);
-                }
+                        end_streamed_delivery(link, delivery_instance_async_operation);
+
+                        if (delivery_instance->on_delivery_settled != NULL)
+                        {
+                            delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, LINK_DELIVERY_SETTLE_REASON_TIMEOUT, NULL);
+                        }
 
-                item = next_item;
+                        async_operation_destroy(delivery_instance_async_operation);
+                    }
+                }
             }
         }
     }
 }
+
+static int read_handover_unsigned(AMQP_READER* reader, AMQP_TYPE type, uint64_t* value)
+{
+    int result;
+    AMQP_READER_ITEM item;
+
+    if ((amqp_reader_next(reader, &item) != 0) ||
+        (item.type != type))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        *value = item.value.unsigned_value;
+        result = 0;
+    }
+
+    return result;
+}
+
+int link_save_handover_state(LINK_HANDLE link, unsigned char* buffer, size_t buffer_size, size_t* length)
+{
+    int result;
+    handle output_handle;
+    handle input_handle;
+
+    if ((link == NULL) ||
+        (buffer == NULL) ||
+        (length == NULL))
+    {
+        LogError("Bad arguments: link = %p, buffer = %p, length = %p",
+            link, buffer, length);
+        result = __FAILURE__;
+    }
+    else if (link->link_state != LINK_STATE_ATTACHED)
+    {
+        LogError("Only an attached link can be handed over, state is %d", (int)link->link_state);
+        result = __FAILURE__;
+    }
+    /* the deliveries in flight hold callbacks and payloads of this process, they have to be settled first */
+    else if ((link->pending_delivery_span != 0) ||
+        (link->streamed_delivery != NULL) ||
+        (link->received_payload_size != 0) ||
+        (link->is_receiving_streamed_delivery) ||
+        (link->is_discarding_delivery) ||
+        (link->unsettled_received_count != 0) ||
+        (link->batched_disposition_count != 0) ||
+        (link->is_draining))
+    {
+        LogError("Cannot hand over a link with deliveries, dispositions or a drain in flight");
+        result = __FAILURE__;
+    }
+    else if (session_get_link_endpoint_handles(link->link_endpoint, &output_handle, &input_handle) != 0)
+    {
+        LogError("Cannot get the handles of the link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_WRITER writer;
+
+        if ((amqp_writer_init(&writer, buffer, buffer_size) != 0) ||
+            (amqp_writer_begin_list(&writer) != 0) ||
+            (amqp_writer_put_uint(&writer, LINK_HANDOVER_STATE_VERSION) != 0) ||
+            (amqp_writer_put_uint(&writer, output_handle) != 0) ||
+            (amqp_writer_put_uint(&writer, input_handle) != 0) ||
+            (amqp_writer_put_ubyte(&writer, (link->role == role_receiver) ? 1 : 0) != 0) ||
+            (amqp_writer_put_ubyte(&writer, (unsigned char)link->snd_settle_mode) != 0) ||
+            (amqp_writer_put_ubyte(&writer, (unsigned char)link->rcv_settle_mode) != 0) ||
+            (amqp_writer_put_uint(&writer, link->initial_delivery_count) != 0) ||
+            (amqp_writer_put_uint(&writer, link->delivery_count) != 0) ||
+            (amqp_writer_put_uint(&writer, link->current_link_credit) != 0) ||
+            (amqp_writer_put_uint(&writer, link->available) != 0) ||
+            (amqp_writer_put_ulong(&writer, link->transfer_count) != 0) ||
+            (amqp_writer_put_ulong(&writer, link->peer_max_message_size) != 0) ||
+            (amqp_writer_end(&writer) != 0) ||
+            (amqp_writer_get_length(&writer, length) != 0))
+        {
+            LogError("Cannot encode the link handover state");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int link_restore_handover_state(LINK_HANDLE link, const unsigned char* bytes, size_t length)
+{
+    int result;
+
+    if ((link == NULL) ||
+        (bytes == NULL))
+    {
+        LogError("Bad arguments: link = %p, bytes = %p",
+            link, bytes);
+        result = __FAILURE__;
+    }
+    else if ((link->link_state != LINK_STATE_DETACHED) ||
+        (link->is_underlying_session_begun))
+    {
+        LogError("A handover state can only be restored before the link is attached");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_READER reader;
+        AMQP_READER_ITEM list;
+        uint64_t version;
+        uint64_t output_handle;
+        uint64_t input_handle;
+        uint64_t is_receiver;
+        uint64_t snd_settle_mode;
+        uint64_t rcv_settle_mode;
+        uint64_t initial_delivery_count;
+        uint64_t delivery_count;
+        uint64_t current_link_credit;
+        uint64_t available;
+        uint64_t transfer_count;
+        uint64_t peer_max_message_size;
+
+        if ((amqp_reader_init(&reader, bytes, length) != 0) ||
+            (amqp_reader_next(&reader, &list) != 0) ||
+            (list.type != AMQP_TYPE_LIST) ||
+            (list.count != LINK_HANDOVER_STATE_FIELD_COUNT) ||
+            (amqp_reader_enter(&reader, &list) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UINT, &version) != 0) ||
+            (version != LINK_HANDOVER_STATE_VERSION) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UINT, &output_handle) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UINT, &input_handle) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UBYTE, &is_receiver) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UBYTE, &snd_settle_mode) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UBYTE, &rcv_settle_mode) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UINT, &initial_delivery_count) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UINT, &delivery_count) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UINT, &current_link_credit) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_UINT, &available) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_ULONG, &transfer_count) != 0) ||
+            (read_handover_unsigned(&reader, AMQP_TYPE_ULONG, &peer_max_message_size) != 0))
+        {
+            LogError("Bad link handover state");
+            result = __FAILURE__;
+        }
+        else if ((is_receiver != 0) != (link->role == role_receiver))
+        {
+            LogError("The handover state is for a link of the other role");
+            result = __FAILURE__;
+        }
+        else if (session_restore_link_endpoint_handles(link->link_endpoint, (handle)output_handle, (handle)input_handle) != 0)
+        {
+            LogError("Cannot restore the handles of the link");
+            result = __FAILURE__;
+        }
+        else
+        {
+            link->snd_settle_mode = (sender_settle_mode)snd_settle_mode;
+            link->rcv_settle_mode = (receiver_settle_mode)rcv_settle_mode;
+            link->initial_delivery_count = (sequence_no)initial_delivery_count;
+            link->delivery_count = (sequence_no)delivery_count;
+            link->current_link_credit = (uint32_t)current_link_credit;
+            link->available = (uint32_t)available;
+            link->transfer_count = transfer_count;
+            link->peer_max_message_size = peer_max_message_size;
+            link->is_resuming_handover = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
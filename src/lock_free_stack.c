@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "azure_uamqp_c/lock_free_stack.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define ATOMIC_LOAD_ACQUIRE_POINTER(target) InterlockedCompareExchangePointer((PVOID volatile*)(target), NULL, NULL)
+#define ATOMIC_EXCHANGE_POINTER(target, value) InterlockedExchangePointer((PVOID volatile*)(target), (value))
+#define ATOMIC_COMPARE_EXCHANGE_POINTER(target, value, comparand) InterlockedCompareExchangePointer((PVOID volatile*)(target), (value), (comparand))
+#else
+#define ATOMIC_LOAD_ACQUIRE_POINTER(target) __atomic_load_n((target), __ATOMIC_ACQUIRE)
+#define ATOMIC_EXCHANGE_POINTER(target, value) __atomic_exchange_n((target), (value), __ATOMIC_ACQ_REL)
+#define ATOMIC_COMPARE_EXCHANGE_POINTER(target, value, comparand) atomic_compare_exchange_pointer((void* volatile*)(target), (value), (comparand))
+
+/* returns the value target had, like InterlockedCompareExchangePointer */
+static void* atomic_compare_exchange_pointer(void* volatile* target, void* value, void* comparand)
+{
+    (void)__atomic_compare_exchange_n(target, &comparand, value, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return comparand;
+}
+#endif
+
+void lock_free_stack_init(LOCK_FREE_STACK* stack)
+{
+    if (stack != NULL)
+    {
+        stack->head = NULL;
+    }
+}
+
+void lock_free_stack_push(LOCK_FREE_STACK* stack, LOCK_FREE_STACK_ENTRY* entry)
+{
+    if ((stack != NULL) &&
+        (entry != NULL))
+    {
+        LOCK_FREE_STACK_ENTRY* head;
+
+        /* the release ordering of the exchange publishes what the producer wrote in the queued structure */
+        do
+        {
+            head = (LOCK_FREE_STACK_ENTRY*)ATOMIC_LOAD_ACQUIRE_POINTER(&stack->head);
+            entry->next = head;
+        } while (ATOMIC_COMPARE_EXCHANGE_POINTER(&stack->head, entry, head) != head);
+    }
+}
+
+LOCK_FREE_STACK_ENTRY* lock_free_stack_take_all(LOCK_FREE_STACK* stack)
+{
+    LOCK_FREE_STACK_ENTRY* result = NULL;
+
+    if (stack != NULL)
+    {
+        LOCK_FREE_STACK_ENTRY* entry = (LOCK_FREE_STACK_ENTRY*)ATOMIC_EXCHANGE_POINTER(&stack->head, NULL);
+
+        /* the stack holds the most recent entry first, reverse it so the entries come out in push order */
+        while (entry != NULL)
+        {
+            LOCK_FREE_STACK_ENTRY* next = entry->next;
+            entry->next = result;
+            result = entry;
+            entry = next;
+        }
+    }
+
+    return result;
+}
+
+bool lock_free_stack_is_empty(LOCK_FREE_STACK* stack)
+{
+    return (stack == NULL) || (ATOMIC_LOAD_ACQUIRE_POINTER(&stack->head) == NULL);
+}
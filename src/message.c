@@ -4,23 +4,42 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/refcount.h"
 #include "azure_uamqp_c/amqp_definitions.h"
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/amqpvalue.h"
 
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_MESSAGE
+#include "azure_uamqp_c/alloc_counters.h"
+
+/* external bytes are shared by a message and all its clones, the owner is told when the last of them lets go */
+typedef struct EXTERNAL_BODY_DATA_TAG
+{
+    ON_BODY_AMQP_DATA_RELEASED on_released;
+    void* on_released_context;
+} EXTERNAL_BODY_DATA;
+
+DEFINE_REFCOUNT_TYPE(EXTERNAL_BODY_DATA);
+
 typedef struct BODY_AMQP_DATA_TAG
 {
     unsigned char* body_data_section_bytes;
     size_t body_data_section_length;
+    /* borrowed bytes belong to the caller (typically the received payload) and are never freed by the message */
+    bool is_borrowed;
+    EXTERNAL_BODY_DATA* external;
 } BODY_AMQP_DATA;
 
 typedef struct MESSAGE_INSTANCE_TAG
 {
     BODY_AMQP_DATA* body_amqp_data_items;
     size_t body_amqp_data_count;
+    /* message_reset keeps the data items array, so a reused message only grows it when it needs more items than before */
+    size_t body_amqp_data_capacity;
     AMQP_VALUE* body_amqp_sequence_items;
     size_t body_amqp_sequence_count;
     AMQP_VALUE body_amqp_value;
@@ -31,6 +50,14 @@ typedef struct MESSAGE_INSTANCE_TAG
     application_properties application_properties;
     annotations footer;
     uint32_t message_format;
+    /* cached by message_get_encoded_size, every change to the sections invalidates it */
+    size_t encoded_size;
+    bool is_encoded_size_valid;
+    /* looked up by message_get_broker_annotations, the string annotations are held so that their chars stay valid */
+    MESSAGE_BROKER_ANNOTATIONS broker_annotations;
+    AMQP_VALUE offset_annotation;
+    AMQP_VALUE partition_key_annotation;
+    bool are_broker_annotations_valid;
 } MESSAGE_INSTANCE;
 
 MESSAGE_BODY_TYPE internal_get_body_type(MESSAGE_HANDLE message)
@@ -57,23 +84,46 @@ MESSAGE_BODY_TYPE internal_get_body_type(MESSAGE_HANDLE message)
     return result;
 }
 
-static void free_all_body_data_items(MESSAGE_HANDLE message)
+static void release_external_body_data(EXTERNAL_BODY_DATA* external)
+{
+    if (DEC_REF(EXTERNAL_BODY_DATA, external) == DEC_RETURN_ZERO)
+    {
+        /* Codes_SRS_MESSAGE_01_206: [ When the last message referencing body AMQP data added with `message_add_body_amqp_data_external` is destroyed or reset, `on_released` shall be called with `on_released_context`. ]*/
+        external->on_released(external->on_released_context);
+        free(external);
+    }
+}
+
+static void clear_all_body_data_items(MESSAGE_HANDLE message)
 {
     size_t i;
 
     for (i = 0; i < message->body_amqp_data_count; i++)
     {
-        if (message->body_amqp_data_items[i].body_data_section_bytes != NULL)
+        if (message->body_amqp_data_items[i].external != NULL)
+        {
+            release_external_body_data(message->body_amqp_data_items[i].external);
+        }
+        /* Codes_SRS_MESSAGE_01_174: [ Body AMQP data added with `message_add_body_amqp_data_borrowed` shall not be freed when the message is destroyed. ]*/
+        else if ((message->body_amqp_data_items[i].body_data_section_bytes != NULL) &&
+            !message->body_amqp_data_items[i].is_borrowed)
         {
             free(message->body_amqp_data_items[i].body_data_section_bytes);
         }
     }
 
+    message->body_amqp_data_count = 0;
+}
+
+static void free_all_body_data_items(MESSAGE_HANDLE message)
+{
+    clear_all_body_data_items(message);
+
     if (message->body_amqp_data_items != NULL)
     {
         free(message->body_amqp_data_items);
     }
-    message->body_amqp_data_count = 0;
+    message->body_amqp_data_capacity = 0;
     message->body_amqp_data_items = NULL;
 }
 
@@ -98,6 +148,73 @@ static void free_all_body_sequence_items(MESSAGE_HANDLE message)
     message->body_amqp_sequence_items = NULL;
 }
 
+static void clear_broker_annotations(MESSAGE_HANDLE message)
+{
+    if (message->offset_annotation != NULL)
+    {
+        amqpvalue_destroy(message->offset_annotation);
+        message->offset_annotation = NULL;
+    }
+
+    if (message->partition_key_annotation != NULL)
+    {
+        amqpvalue_destroy(message->partition_key_annotation);
+        message->partition_key_annotation = NULL;
+    }
+
+    message->are_broker_annotations_valid = false;
+}
+
+/* Returns the string annotation stored under key, or NULL when it is absent or not a string */
+static AMQP_VALUE get_string_annotation(message_annotations annotations, const char* key, const char** chars)
+{
+    AMQP_VALUE result = amqpvalue_get_map_value_by_symbol(annotations, key);
+
+    if ((result != NULL) &&
+        (amqpvalue_get_string(result, chars) != 0))
+    {
+        amqpvalue_destroy(result);
+        result = NULL;
+    }
+
+    if (result == NULL)
+    {
+        *chars = NULL;
+    }
+
+    return result;
+}
+
+static void lookup_broker_annotations(MESSAGE_HANDLE message)
+{
+    message->broker_annotations.has_sequence_number = false;
+    message->broker_annotations.has_enqueued_time = false;
+    message->broker_annotations.offset = NULL;
+    message->broker_annotations.partition_key = NULL;
+
+    if (message->message_annotations != NULL)
+    {
+        AMQP_VALUE value = amqpvalue_get_map_value_by_symbol(message->message_annotations, "x-opt-sequence-number");
+        if (value != NULL)
+        {
+            message->broker_annotations.has_sequence_number = (amqpvalue_get_long(value, &message->broker_annotations.sequence_number) == 0);
+            amqpvalue_destroy(value);
+        }
+
+        value = amqpvalue_get_map_value_by_symbol(message->message_annotations, "x-opt-enqueued-time");
+        if (value != NULL)
+        {
+            message->broker_annotations.has_enqueued_time = (amqpvalue_get_timestamp(value, &message->broker_annotations.enqueued_time) == 0);
+            amqpvalue_destroy(value);
+        }
+
+        message->offset_annotation = get_string_annotation(message->message_annotations, "x-opt-offset", &message->broker_annotations.offset);
+        message->partition_key_annotation = get_string_annotation(message->message_annotations, "x-opt-partition-key", &message->broker_annotations.partition_key);
+    }
+
+    message->are_broker_annotations_valid = true;
+}
+
 MESSAGE_HANDLE message_create(void)
 {
     MESSAGE_HANDLE result = (MESSAGE_HANDLE)malloc(sizeof(MESSAGE_INSTANCE));
@@ -116,12 +233,19 @@ MESSAGE_HANDLE message_create(void)
         result->footer = NULL;
         result->body_amqp_data_items = NULL;
         result->body_amqp_data_count = 0;
+        result->body_amqp_data_capacity = 0;
         result->body_amqp_value = NULL;
         result->body_amqp_sequence_items = NULL;
         result->body_amqp_sequence_count = 0;
 
         /* Codes_SRS_MESSAGE_01_135: [ By default a message on which `message_set_message_format` was not called shall have message format set to 0. ]*/
         result->message_format = 0;
+        result->encoded_size = 0;
+        result->is_encoded_size_valid = false;
+        result->offset_annotation = NULL;
+        result->partition_key_annotation = NULL;
+        result->are_broker_annotations_valid = false;
+        ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_MESSAGE, sizeof(MESSAGE_INSTANCE));
     }
 
     /* Codes_SRS_MESSAGE_01_001: [`message_create` shall create a new AMQP message instance and on success it shall return a non-NULL handle for the newly created message instance.] */
@@ -150,6 +274,8 @@ MESSAGE_HANDLE message_clone(MESSAGE_HANDLE source_message)
         else
         {
             result->message_format = source_message->message_format;
+            result->encoded_size = source_message->encoded_size;
+            result->is_encoded_size_valid = source_message->is_encoded_size_valid;
 
             if (source_message->header != NULL)
             {
@@ -243,20 +369,33 @@ MESSAGE_HANDLE message_clone(MESSAGE_HANDLE source_message)
                 }
                 else
                 {
+                    result->body_amqp_data_capacity = source_message->body_amqp_data_count;
                     for (i = 0; i < source_message->body_amqp_data_count; i++)
                     {
                         result->body_amqp_data_items[i].body_data_section_length = source_message->body_amqp_data_items[i].body_data_section_length;
+                        /* Codes_SRS_MESSAGE_01_173: [ `message_clone` shall copy body AMQP data added with `message_add_body_amqp_data_borrowed`, so that the cloned message does not reference the borrowed bytes. ]*/
+                        result->body_amqp_data_items[i].is_borrowed = false;
+                        result->body_amqp_data_items[i].external = source_message->body_amqp_data_items[i].external;
 
-                        /* Codes_SRS_MESSAGE_01_011: [If an AMQP data has been set as message body on the source message it shall be cloned by allocating memory for the binary payload.] */
-                        result->body_amqp_data_items[i].body_data_section_bytes = (unsigned char*)malloc(source_message->body_amqp_data_items[i].body_data_section_length);
-                        if (result->body_amqp_data_items[i].body_data_section_bytes == NULL)
+                        if (result->body_amqp_data_items[i].external != NULL)
                         {
-                            LogError("Cannot allocate memory for body data section %u", (unsigned int)i);
-                            break;
+                            /* Codes_SRS_MESSAGE_01_205: [ `message_clone` shall not copy body AMQP data added with `message_add_body_amqp_data_external`, the cloned message shall reference the same bytes. ]*/
+                            INC_REF(EXTERNAL_BODY_DATA, result->body_amqp_data_items[i].external);
+                            result->body_amqp_data_items[i].body_data_section_bytes = source_message->body_amqp_data_items[i].body_data_section_bytes;
                         }
                         else
                         {
-                            (void)memcpy(result->body_amqp_data_items[i].body_data_section_bytes, source_message->body_amqp_data_items[i].body_data_section_bytes, result->body_amqp_data_items[i].body_data_section_length);
+                            /* Codes_SRS_MESSAGE_01_011: [If an AMQP data has been set as message body on the source message it shall be cloned by allocating memory for the binary payload.] */
+                            result->body_amqp_data_items[i].body_data_section_bytes = (unsigned char*)malloc(source_message->body_amqp_data_items[i].body_data_section_length);
+                            if (result->body_amqp_data_items[i].body_data_section_bytes == NULL)
+                            {
+                                LogError("Cannot allocate memory for body data section %u", (unsigned int)i);
+                                break;
+                            }
+                            else
+                            {
+                                (void)memcpy(result->body_amqp_data_items[i].body_data_section_bytes, source_message->body_amqp_data_items[i].body_data_section_bytes, result->body_amqp_data_items[i].body_data_section_length);
+                            }
                         }
                     }
 
@@ -323,6 +462,66 @@ MESSAGE_HANDLE message_clone(MESSAGE_HANDLE source_message)
     return result;
 }
 
+static void clear_message(MESSAGE_HANDLE message)
+{
+    if (message->header != NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_015: [ The message header shall be freed by calling `header_destroy`. ]*/
+        header_destroy(message->header);
+        message->header = NULL;
+    }
+
+    if (message->delivery_annotations != NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_016: [ The delivery annotations shall be freed by calling `annotations_destroy`. ]*/
+        annotations_destroy(message->delivery_annotations);
+        message->delivery_annotations = NULL;
+    }
+
+    if (message->message_annotations != NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_017: [ The message annotations shall be freed by calling `annotations_destroy`. ]*/
+        annotations_destroy(message->message_annotations);
+        message->message_annotations = NULL;
+    }
+
+    clear_broker_annotations(message);
+
+    if (message->properties != NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_018: [ The message properties shall be freed by calling `properties_destroy`. ]*/
+        properties_destroy(message->properties);
+        message->properties = NULL;
+    }
+
+    if (message->application_properties != NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_019: [ The application properties shall be freed by calling `amqpvalue_destroy`. ]*/
+        application_properties_destroy(message->application_properties);
+        message->application_properties = NULL;
+    }
+
+    if (message->footer != NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_020: [ The message footer shall be freed by calling `annotations_destroy`. ]*/
+        annotations_destroy(message->footer);
+        message->footer = NULL;
+    }
+
+    if (message->body_amqp_value != NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_021: [ If the message body is made of an AMQP value, the value shall be freed by calling `amqpvalue_destroy`. ]*/
+        amqpvalue_destroy(message->body_amqp_value);
+        message->body_amqp_value = NULL;
+    }
+
+    /* Codes_SRS_MESSAGE_01_136: [ If the message body is made of several AMQP sequences, they shall all be freed. ]*/
+    free_all_body_sequence_items(message);
+
+    message->message_format = 0;
+    message->is_encoded_size_valid = false;
+}
+
 void message_destroy(MESSAGE_HANDLE message)
 {
     if (message == NULL)
@@ -333,55 +532,38 @@ void message_destroy(MESSAGE_HANDLE message)
     else
     {
         /* Codes_SRS_MESSAGE_01_013: [ `message_destroy` shall free all resources allocated by the message instance identified by the `message` argument. ]*/
-        if (message->header != NULL)
-        {
-            /* Codes_SRS_MESSAGE_01_015: [ The message header shall be freed by calling `header_destroy`. ]*/
-            header_destroy(message->header);
-        }
-
-        if (message->delivery_annotations != NULL)
-        {
-            /* Codes_SRS_MESSAGE_01_016: [ The delivery annotations shall be freed by calling `annotations_destroy`. ]*/
-            annotations_destroy(message->delivery_annotations);
-        }
-
-        if (message->message_annotations != NULL)
-        {
-            /* Codes_SRS_MESSAGE_01_017: [ The message annotations shall be freed by calling `annotations_destroy`. ]*/
-            annotations_destroy(message->message_annotations);
-        }
-
-        if (message->properties != NULL)
-        {
-            /* Codes_SRS_MESSAGE_01_018: [ The message properties shall be freed by calling `properties_destroy`. ]*/
-            properties_destroy(message->properties);
-        }
+        clear_message(message);
 
-        if (message->application_properties != NULL)
-        {
-            /* Codes_SRS_MESSAGE_01_019: [ The application properties shall be freed by calling `amqpvalue_destroy`. ]*/
-            application_properties_destroy(message->application_properties);
-        }
+        /* Codes_SRS_MESSAGE_01_136: [ If the message body is made of several AMQP data items, they shall all be freed. ]*/
+        free_all_body_data_items(message);
+        ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_MESSAGE, sizeof(MESSAGE_INSTANCE));
+        free(message);
+    }
+}
 
-        if (message->footer != NULL)
-        {
-            /* Codes_SRS_MESSAGE_01_020: [ The message footer shall be freed by calling `annotations_destroy`. ]*/
-            annotations_destroy(message->footer);
-        }
+int message_reset(MESSAGE_HANDLE message)
+{
+    int result;
 
-        if (message->body_amqp_value != NULL)
-        {
-            /* Codes_SRS_MESSAGE_01_021: [ If the message body is made of an AMQP value, the value shall be freed by calling `amqpvalue_destroy`. ]*/
-            amqpvalue_destroy(message->body_amqp_value);
-        }
+    if (message == NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_177: [ If `message` is NULL, `message_reset` shall fail and return a non-zero value. ]*/
+        LogError("NULL message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_MESSAGE_01_175: [ `message_reset` shall free all sections and the body of the message identified by `message` and set its message format to 0, leaving it as if it had just been created. ]*/
+        clear_message(message);
 
-        /* Codes_SRS_MESSAGE_01_136: [ If the message body is made of several AMQP data items, they shall all be freed. ]*/
-        free_all_body_data_items(message);
+        /* Codes_SRS_MESSAGE_01_178: [ The memory holding the list of body AMQP data items shall be kept for reuse. ]*/
+        clear_all_body_data_items(message);
 
-        /* Codes_SRS_MESSAGE_01_136: [ If the message body is made of several AMQP sequences, they shall all be freed. ]*/
-        free_all_body_sequence_items(message);
-        free(message);
+        /* Codes_SRS_MESSAGE_01_176: [ On success it shall return 0. ]*/
+        result = 0;
     }
+
+    return result;
 }
 
 int message_set_header(MESSAGE_HANDLE message, HEADER_HANDLE header)
@@ -407,6 +589,8 @@ int message_set_header(MESSAGE_HANDLE message, HEADER_HANDLE header)
                 message->header = NULL;
             }
 
+            message->is_encoded_size_valid = false;
+
             /* Codes_SRS_MESSAGE_01_023: [ On success it shall return 0. ]*/
             result = 0;
         }
@@ -432,6 +616,8 @@ int message_set_header(MESSAGE_HANDLE message, HEADER_HANDLE header)
 
                 message->header = new_header;
 
+                message->is_encoded_size_valid = false;
+
                 /* Codes_SRS_MESSAGE_01_023: [ On success it shall return 0. ]*/
                 result = 0;
             }
@@ -441,6 +627,38 @@ int message_set_header(MESSAGE_HANDLE message, HEADER_HANDLE header)
     return result;
 }
 
+int message_take_header(MESSAGE_HANDLE message, HEADER_HANDLE message_header)
+{
+    int result;
+
+    if ((message == NULL) ||
+        (message_header == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_163: [ If `message` or `message_header` is NULL, `message_take_header` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, message_header = %p",
+            message, message_header);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_MESSAGE_01_164: [ The previously stored header shall be freed by calling `header_destroy`. ]*/
+        if (message->header != NULL)
+        {
+            header_destroy(message->header);
+        }
+
+        /* Codes_SRS_MESSAGE_01_161: [ `message_take_header` shall store `message_header` as the header for the message instance identified by `message` without cloning it, the message owning it from then on. ]*/
+        message->header = message_header;
+
+        message->is_encoded_size_valid = false;
+
+        /* Codes_SRS_MESSAGE_01_162: [ On success it shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
 int message_get_header(MESSAGE_HANDLE message, HEADER_HANDLE* header)
 {
     int result;
@@ -508,6 +726,8 @@ int message_set_delivery_annotations(MESSAGE_HANDLE message, delivery_annotation
                 message->delivery_annotations = NULL;
             }
         
+            message->is_encoded_size_valid = false;
+
             /* Codes_SRS_MESSAGE_01_033: [ On success it shall return 0. ]*/
             result = 0;
         }
@@ -533,6 +753,8 @@ int message_set_delivery_annotations(MESSAGE_HANDLE message, delivery_annotation
 
                 message->delivery_annotations = new_delivery_annotations;
 
+                message->is_encoded_size_valid = false;
+
                 /* Codes_SRS_MESSAGE_01_033: [ On success it shall return 0. ]*/
                 result = 0;
             }
@@ -607,6 +829,10 @@ int message_set_message_annotations(MESSAGE_HANDLE message, message_annotations
                 message->message_annotations = NULL;
             }
 
+            /* Codes_SRS_MESSAGE_01_211: [ Setting or clearing the message annotations shall drop the broker annotations looked up by `message_get_broker_annotations`. ]*/
+            clear_broker_annotations(message);
+            message->is_encoded_size_valid = false;
+
             /* Codes_SRS_MESSAGE_01_043: [ On success it shall return 0. ]*/
             result = 0;
         }
@@ -634,6 +860,10 @@ int message_set_message_annotations(MESSAGE_HANDLE message, message_annotations
 
                 message->message_annotations = new_message_annotations;
 
+                /* Codes_SRS_MESSAGE_01_211: [ Setting or clearing the message annotations shall drop the broker annotations looked up by `message_get_broker_annotations`. ]*/
+                clear_broker_annotations(message);
+                message->is_encoded_size_valid = false;
+
                 /* Codes_SRS_MESSAGE_01_043: [ On success it shall return 0. ]*/
                 result = 0;
             }
@@ -687,6 +917,36 @@ int message_get_message_annotations(MESSAGE_HANDLE message, annotations* message
     return result;
 }
 
+int message_get_broker_annotations(MESSAGE_HANDLE message, MESSAGE_BROKER_ANNOTATIONS* broker_annotations)
+{
+    int result;
+
+    if ((message == NULL) ||
+        (broker_annotations == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_210: [ If `message` or `broker_annotations` is NULL, `message_get_broker_annotations` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, broker_annotations = %p",
+            message, broker_annotations);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_MESSAGE_01_208: [ `message_get_broker_annotations` shall fill `broker_annotations` with the `x-opt-sequence-number` (long), `x-opt-enqueued-time` (timestamp), `x-opt-offset` (string) and `x-opt-partition-key` (string) message annotations, marking those absent or of another type as absent, without cloning the message annotations. ]*/
+        /* Codes_SRS_MESSAGE_01_209: [ The broker annotations shall be looked up on the first call and returned by later calls until the message annotations change. ]*/
+        if (!message->are_broker_annotations_valid)
+        {
+            lookup_broker_annotations(message);
+        }
+
+        *broker_annotations = message->broker_annotations;
+
+        /* Codes_SRS_MESSAGE_01_212: [ On success it shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
 int message_set_properties(MESSAGE_HANDLE message, PROPERTIES_HANDLE properties)
 {
     int result;
@@ -708,6 +968,8 @@ int message_set_properties(MESSAGE_HANDLE message, PROPERTIES_HANDLE properties)
                 message->properties = NULL;
             }
 
+            message->is_encoded_size_valid = false;
+
             /* Codes_SRS_MESSAGE_01_053: [ On success it shall return 0. ]*/
             result = 0;
         }
@@ -735,6 +997,8 @@ int message_set_properties(MESSAGE_HANDLE message, PROPERTIES_HANDLE properties)
 
                 message->properties = new_properties;
 
+                message->is_encoded_size_valid = false;
+
                 /* Codes_SRS_MESSAGE_01_053: [ On success it shall return 0. ]*/
                 result = 0;
             }
@@ -744,6 +1008,38 @@ int message_set_properties(MESSAGE_HANDLE message, PROPERTIES_HANDLE properties)
     return result;
 }
 
+int message_take_properties(MESSAGE_HANDLE message, PROPERTIES_HANDLE properties)
+{
+    int result;
+
+    if ((message == NULL) ||
+        (properties == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_167: [ If `message` or `properties` is NULL, `message_take_properties` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, properties = %p",
+            message, properties);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_MESSAGE_01_168: [ The previously stored message properties shall be freed by calling `properties_destroy`. ]*/
+        if (message->properties != NULL)
+        {
+            properties_destroy(message->properties);
+        }
+
+        /* Codes_SRS_MESSAGE_01_165: [ `message_take_properties` shall store `properties` as the message properties for the message instance identified by `message` without cloning them, the message owning them from then on. ]*/
+        message->properties = properties;
+
+        message->is_encoded_size_valid = false;
+
+        /* Codes_SRS_MESSAGE_01_166: [ On success it shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
 int message_get_properties(MESSAGE_HANDLE message, PROPERTIES_HANDLE* properties)
 {
     int result;
@@ -811,6 +1107,8 @@ int message_set_application_properties(MESSAGE_HANDLE message, AMQP_VALUE applic
                 message->application_properties = NULL;
             }
 
+            message->is_encoded_size_valid = false;
+
             /* Codes_SRS_MESSAGE_01_065: [ On success it shall return 0. ]*/
             result = 0;
         }
@@ -836,6 +1134,8 @@ int message_set_application_properties(MESSAGE_HANDLE message, AMQP_VALUE applic
 
                 message->application_properties = new_application_properties;
 
+                message->is_encoded_size_valid = false;
+
                 /* Codes_SRS_MESSAGE_01_065: [ On success it shall return 0. ]*/
                 result = 0;
             }
@@ -889,70 +1189,320 @@ int message_get_application_properties(MESSAGE_HANDLE message, AMQP_VALUE* appli
     return result;
 }
 
-int message_set_footer(MESSAGE_HANDLE message, annotations footer)
+/* the property setters below write straight into the properties of the message, creating them on first use */
+static PROPERTIES_HANDLE get_properties_for_update(MESSAGE_HANDLE message)
+{
+    message->is_encoded_size_valid = false;
+
+    if (message->properties == NULL)
+    {
+        message->properties = properties_create();
+    }
+
+    return message->properties;
+}
+
+static int set_message_id_property(MESSAGE_HANDLE message, const char* value, bool is_correlation_id)
 {
     int result;
+    PROPERTIES_HANDLE properties;
 
-    if (message == NULL)
+    if ((message == NULL) ||
+        (value == NULL))
     {
-        /* Codes_SRS_MESSAGE_01_077: [ If `message` is NULL, `message_set_footer` shall fail and return a non-zero value. ]*/
-        LogError("NULL message");
+        /* Codes_SRS_MESSAGE_01_181: [ If `message` or `message_id` is NULL, `message_set_message_id_string` shall fail and return a non-zero value. ]*/
+        /* Codes_SRS_MESSAGE_01_185: [ If `message` or `correlation_id` is NULL, `message_set_correlation_id_string` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, value = %p",
+            message, value);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_MESSAGE_01_180: [ If the message has no properties, they shall be created by calling `properties_create`. ]*/
+    else if ((properties = get_properties_for_update(message)) == NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_182: [ If any of the calls made by `message_set_message_id_string` or `message_set_correlation_id_string` fails, they shall fail and return a non-zero value. ]*/
+        LogError("Cannot create message properties");
         result = __FAILURE__;
     }
     else
     {
-        if (footer == NULL)
+        /* Codes_SRS_MESSAGE_01_179: [ `message_set_message_id_string` shall set the message id in the properties of `message` to a string value created by calling `amqpvalue_create_message_id_string`, without any intermediate properties handle. ]*/
+        /* Codes_SRS_MESSAGE_01_184: [ `message_set_correlation_id_string` shall set the correlation id in the properties of `message` to a string value created by calling `amqpvalue_create_message_id_string`, without any intermediate properties handle. ]*/
+        AMQP_VALUE id_value = amqpvalue_create_message_id_string(value);
+        if (id_value == NULL)
         {
-            /* Codes_SRS_MESSAGE_01_151: [ If `footer` is NULL, the previously stored footer associated with `message` shall be freed. ]*/
-            if (message->footer != NULL)
-            {
-                annotations_destroy(message->footer);
-                message->footer = NULL;
-            }
-
-            /* Codes_SRS_MESSAGE_01_076: [ On success it shall return 0. ]*/
-            result = 0;
+            LogError("Cannot create id value");
+            result = __FAILURE__;
         }
         else
         {
-            annotations new_footer;
-
-            /* Codes_SRS_MESSAGE_01_075: [ `message_set_footer` shall copy the contents of `footer` as the footer contents for the message instance identified by `message`. ]*/
-            /* Codes_SRS_MESSAGE_01_078: [ Cloning the footer shall be done by calling `annotations_clone`. ]*/
-            new_footer = annotations_clone(footer);
-            if (new_footer == NULL)
+            if (is_correlation_id)
             {
-                /* Codes_SRS_MESSAGE_01_079: [ If `annotations_clone` fails, `message_set_footer` shall fail and return a non-zero value. ]*/
-                LogError("Cannot clone message footer");
-                result = __FAILURE__;
+                result = properties_set_correlation_id(properties, id_value);
             }
             else
             {
-                /* Codes_SRS_MESSAGE_01_080: [ If setting the footer fails, the previous value shall be preserved. ]*/
-                /* Only do the free of the previous value if we could clone the new one*/
-                if (message->footer != NULL)
-                {
-                    annotations_destroy(message->footer);
-                }
-
-                message->footer = new_footer;
+                result = properties_set_message_id(properties, id_value);
+            }
 
-                /* Codes_SRS_MESSAGE_01_076: [ On success it shall return 0. ]*/
-                result = 0;
+            if (result != 0)
+            {
+                LogError("Cannot set id on message properties");
+                result = __FAILURE__;
             }
+
+            amqpvalue_destroy(id_value);
         }
     }
 
     return result;
 }
 
-int message_get_footer(MESSAGE_HANDLE message, annotations* footer)
+int message_set_message_id_string(MESSAGE_HANDLE message, const char* message_id)
 {
-    int result;
+    /* Codes_SRS_MESSAGE_01_183: [ On success it shall return 0. ]*/
+    return set_message_id_property(message, message_id, false);
+}
 
-    if ((message == NULL) ||
-        (footer == NULL))
-    {
+int message_set_correlation_id_string(MESSAGE_HANDLE message, const char* correlation_id)
+{
+    /* Codes_SRS_MESSAGE_01_183: [ On success it shall return 0. ]*/
+    return set_message_id_property(message, correlation_id, true);
+}
+
+int message_set_subject(MESSAGE_HANDLE message, const char* subject)
+{
+    int result;
+    PROPERTIES_HANDLE properties;
+
+    if ((message == NULL) ||
+        (subject == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_187: [ If `message` or `subject` is NULL, `message_set_subject` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, subject = %p",
+            message, subject);
+        result = __FAILURE__;
+    }
+    else if ((properties = get_properties_for_update(message)) == NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_188: [ If creating the properties or setting the subject fails, `message_set_subject` shall fail and return a non-zero value. ]*/
+        LogError("Cannot create message properties");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_MESSAGE_01_186: [ `message_set_subject` shall set the subject in the properties of `message` by calling `properties_set_subject`, creating the properties with `properties_create` if the message has none. ]*/
+    else if (properties_set_subject(properties, subject) != 0)
+    {
+        /* Codes_SRS_MESSAGE_01_188: [ If creating the properties or setting the subject fails, `message_set_subject` shall fail and return a non-zero value. ]*/
+        LogError("Cannot set subject on message properties");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int message_set_content_type(MESSAGE_HANDLE message, const char* content_type)
+{
+    int result;
+    PROPERTIES_HANDLE properties;
+
+    if ((message == NULL) ||
+        (content_type == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_190: [ If `message` or `content_type` is NULL, `message_set_content_type` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, content_type = %p",
+            message, content_type);
+        result = __FAILURE__;
+    }
+    else if ((properties = get_properties_for_update(message)) == NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_191: [ If creating the properties or setting the content type fails, `message_set_content_type` shall fail and return a non-zero value. ]*/
+        LogError("Cannot create message properties");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_MESSAGE_01_189: [ `message_set_content_type` shall set the content type in the properties of `message` by calling `properties_set_content_type`, creating the properties with `properties_create` if the message has none. ]*/
+    else if (properties_set_content_type(properties, content_type) != 0)
+    {
+        /* Codes_SRS_MESSAGE_01_191: [ If creating the properties or setting the content type fails, `message_set_content_type` shall fail and return a non-zero value. ]*/
+        LogError("Cannot set content type on message properties");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* takes ownership of value */
+static int set_application_property(MESSAGE_HANDLE message, const char* name, AMQP_VALUE value)
+{
+    int result;
+
+    message->is_encoded_size_valid = false;
+
+    if (value == NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_195: [ If any of the calls made fails, the application property setters shall fail and return a non-zero value. ]*/
+        LogError("Cannot create application property value");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE name_value;
+
+        /* Codes_SRS_MESSAGE_01_193: [ If the message has no application properties, they shall be created as an empty map by calling `amqpvalue_create_map`. ]*/
+        if ((message->application_properties == NULL) &&
+            ((message->application_properties = amqpvalue_create_map()) == NULL))
+        {
+            /* Codes_SRS_MESSAGE_01_195: [ If any of the calls made fails, the application property setters shall fail and return a non-zero value. ]*/
+            LogError("Cannot create application properties map");
+            result = __FAILURE__;
+        }
+        else if ((name_value = amqpvalue_create_string(name)) == NULL)
+        {
+            /* Codes_SRS_MESSAGE_01_195: [ If any of the calls made fails, the application property setters shall fail and return a non-zero value. ]*/
+            LogError("Cannot create application property name");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_MESSAGE_01_192: [ `message_set_application_property_string` and `message_set_application_property_long` shall set the property `name` in the application properties map of `message` by calling `amqpvalue_set_map_value`, without any intermediate map handle. ]*/
+            /* a map shared with clones of the message is copied before being changed */
+            if ((amqpvalue_make_writable(&message->application_properties) != 0) ||
+                (amqpvalue_set_map_value(message->application_properties, name_value, value) != 0))
+            {
+                /* Codes_SRS_MESSAGE_01_195: [ If any of the calls made fails, the application property setters shall fail and return a non-zero value. ]*/
+                LogError("Cannot set application property");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_MESSAGE_01_196: [ On success they shall return 0. ]*/
+                result = 0;
+            }
+
+            amqpvalue_destroy(name_value);
+        }
+
+        amqpvalue_destroy(value);
+    }
+
+    return result;
+}
+
+int message_set_application_property_string(MESSAGE_HANDLE message, const char* name, const char* value)
+{
+    int result;
+
+    if ((message == NULL) ||
+        (name == NULL) ||
+        (value == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_194: [ If `message`, `name` or the value is NULL, the application property setters shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, name = %p, value = %p",
+            message, name, value);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = set_application_property(message, name, amqpvalue_create_string(value));
+    }
+
+    return result;
+}
+
+int message_set_application_property_long(MESSAGE_HANDLE message, const char* name, int64_t value)
+{
+    int result;
+
+    if ((message == NULL) ||
+        (name == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_194: [ If `message`, `name` or the value is NULL, the application property setters shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, name = %p",
+            message, name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = set_application_property(message, name, amqpvalue_create_long(value));
+    }
+
+    return result;
+}
+
+int message_set_footer(MESSAGE_HANDLE message, annotations footer)
+{
+    int result;
+
+    if (message == NULL)
+    {
+        /* Codes_SRS_MESSAGE_01_077: [ If `message` is NULL, `message_set_footer` shall fail and return a non-zero value. ]*/
+        LogError("NULL message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (footer == NULL)
+        {
+            /* Codes_SRS_MESSAGE_01_151: [ If `footer` is NULL, the previously stored footer associated with `message` shall be freed. ]*/
+            if (message->footer != NULL)
+            {
+                annotations_destroy(message->footer);
+                message->footer = NULL;
+            }
+
+            message->is_encoded_size_valid = false;
+
+            /* Codes_SRS_MESSAGE_01_076: [ On success it shall return 0. ]*/
+            result = 0;
+        }
+        else
+        {
+            annotations new_footer;
+
+            /* Codes_SRS_MESSAGE_01_075: [ `message_set_footer` shall copy the contents of `footer` as the footer contents for the message instance identified by `message`. ]*/
+            /* Codes_SRS_MESSAGE_01_078: [ Cloning the footer shall be done by calling `annotations_clone`. ]*/
+            new_footer = annotations_clone(footer);
+            if (new_footer == NULL)
+            {
+                /* Codes_SRS_MESSAGE_01_079: [ If `annotations_clone` fails, `message_set_footer` shall fail and return a non-zero value. ]*/
+                LogError("Cannot clone message footer");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_MESSAGE_01_080: [ If setting the footer fails, the previous value shall be preserved. ]*/
+                /* Only do the free of the previous value if we could clone the new one*/
+                if (message->footer != NULL)
+                {
+                    annotations_destroy(message->footer);
+                }
+
+                message->footer = new_footer;
+
+                message->is_encoded_size_valid = false;
+
+                /* Codes_SRS_MESSAGE_01_076: [ On success it shall return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int message_get_footer(MESSAGE_HANDLE message, annotations* footer)
+{
+    int result;
+
+    if ((message == NULL) ||
+        (footer == NULL))
+    {
         /* Codes_SRS_MESSAGE_01_083: [ If `message` or `footer` is NULL, `message_get_footer` shall fail and return a non-zero value. ]*/
         LogError("Bad arguments: message = %p, footer = %p",
             message, footer);
@@ -990,11 +1540,12 @@ int message_get_footer(MESSAGE_HANDLE message, annotations* footer)
     return result;
 }
 
-int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
+static int add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data, bool borrow)
 {
     int result;
 
     /* Codes_SRS_MESSAGE_01_088: [ If `message` is NULL, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+    /* Codes_SRS_MESSAGE_01_171: [ If `message` is NULL or the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data_borrowed` shall fail and return a non-zero value. ]*/
     if ((message == NULL) ||
         /* Tests_SRS_MESSAGE_01_089: [ If the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
         ((amqp_data.bytes == NULL) &&
@@ -1011,13 +1562,28 @@ int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
             (body_type == MESSAGE_BODY_TYPE_VALUE))
         {
             /* Codes_SRS_MESSAGE_01_091: [ If the body was already set to an AMQP value or a list of AMQP sequences, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+            /* Codes_SRS_MESSAGE_01_172: [ If the body was already set to an AMQP value or a list of AMQP sequences, `message_add_body_amqp_data_borrowed` shall fail and return a non-zero value. ]*/
             LogError("Body type already set");
             result = __FAILURE__;
         }
         else
         {
             /* Codes_SRS_MESSAGE_01_086: [ `message_add_body_amqp_data` shall add the contents of `amqp_data` to the list of AMQP data values for the body of the message identified by `message`. ]*/
-            BODY_AMQP_DATA* new_body_amqp_data_items = (BODY_AMQP_DATA*)realloc(message->body_amqp_data_items, sizeof(BODY_AMQP_DATA) * (message->body_amqp_data_count + 1));
+            BODY_AMQP_DATA* new_body_amqp_data_items;
+
+            if (message->body_amqp_data_count < message->body_amqp_data_capacity)
+            {
+                new_body_amqp_data_items = message->body_amqp_data_items;
+            }
+            else
+            {
+                new_body_amqp_data_items = (BODY_AMQP_DATA*)realloc(message->body_amqp_data_items, sizeof(BODY_AMQP_DATA) * (message->body_amqp_data_count + 1));
+                if (new_body_amqp_data_items != NULL)
+                {
+                    message->body_amqp_data_capacity = message->body_amqp_data_count + 1;
+                }
+            }
+
             if (new_body_amqp_data_items == NULL)
             {
                 /* Codes_SRS_MESSAGE_01_153: [ If allocating memory to store the added AMQP data fails, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
@@ -1032,8 +1598,28 @@ int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
                 {
                     message->body_amqp_data_items[message->body_amqp_data_count].body_data_section_bytes = NULL;
                     message->body_amqp_data_items[message->body_amqp_data_count].body_data_section_length = 0;
+                    message->body_amqp_data_items[message->body_amqp_data_count].is_borrowed = false;
+                    message->body_amqp_data_items[message->body_amqp_data_count].external = NULL;
+                    message->body_amqp_data_count++;
+
+                    message->is_encoded_size_valid = false;
+
+                    /* Codes_SRS_MESSAGE_01_087: [ On success it shall return 0. ]*/
+                    result = 0;
+                }
+                else if (borrow)
+                {
+                    /* Codes_SRS_MESSAGE_01_169: [ `message_add_body_amqp_data_borrowed` shall add `amqp_data` to the list of AMQP data values for the body of the message identified by `message` without copying the bytes, which shall stay valid for as long as the message exists. ]*/
+                    message->body_amqp_data_items[message->body_amqp_data_count].body_data_section_bytes = (unsigned char*)amqp_data.bytes;
+                    message->body_amqp_data_items[message->body_amqp_data_count].body_data_section_length = amqp_data.length;
+                    message->body_amqp_data_items[message->body_amqp_data_count].is_borrowed = true;
+                    message->body_amqp_data_items[message->body_amqp_data_count].external = NULL;
                     message->body_amqp_data_count++;
 
+                    /* Codes_SRS_MESSAGE_01_170: [ On success it shall return 0. ]*/
+
+                    message->is_encoded_size_valid = false;
+
                     /* Codes_SRS_MESSAGE_01_087: [ On success it shall return 0. ]*/
                     result = 0;
                 }
@@ -1049,9 +1635,13 @@ int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
                     else
                     {
                         message->body_amqp_data_items[message->body_amqp_data_count].body_data_section_length = amqp_data.length;
+                        message->body_amqp_data_items[message->body_amqp_data_count].is_borrowed = false;
+                        message->body_amqp_data_items[message->body_amqp_data_count].external = NULL;
                         (void)memcpy(message->body_amqp_data_items[message->body_amqp_data_count].body_data_section_bytes, amqp_data.bytes, amqp_data.length);
                         message->body_amqp_data_count++;
 
+                        message->is_encoded_size_valid = false;
+
                         /* Codes_SRS_MESSAGE_01_087: [ On success it shall return 0. ]*/
                         result = 0;
                     }
@@ -1063,6 +1653,107 @@ int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
     return result;
 }
 
+int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
+{
+    return add_body_amqp_data(message, amqp_data, false);
+}
+
+int message_add_body_amqp_data_borrowed(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
+{
+    return add_body_amqp_data(message, amqp_data, true);
+}
+
+int message_own_body_amqp_data(MESSAGE_HANDLE message)
+{
+    int result;
+
+    /* Codes_SRS_MESSAGE_01_213: [ If `message` is NULL, `message_own_body_amqp_data` shall fail and return a non-zero value. ]*/
+    if (message == NULL)
+    {
+        LogError("NULL message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+
+        for (i = 0; i < message->body_amqp_data_count; i++)
+        {
+            if (message->body_amqp_data_items[i].is_borrowed)
+            {
+                /* Codes_SRS_MESSAGE_01_214: [ `message_own_body_amqp_data` shall copy the bytes of each body AMQP data added with `message_add_body_amqp_data_borrowed`, so that the message does not reference the borrowed bytes anymore, and return 0. ]*/
+                unsigned char* owned_bytes = (unsigned char*)malloc(message->body_amqp_data_items[i].body_data_section_length);
+                if (owned_bytes == NULL)
+                {
+                    /* Codes_SRS_MESSAGE_01_215: [ If allocating memory for the copies fails, `message_own_body_amqp_data` shall fail and return a non-zero value, the body AMQP data not copied yet staying borrowed. ]*/
+                    LogError("Cannot allocate memory for the borrowed body AMQP data");
+                    result = __FAILURE__;
+                    break;
+                }
+                else
+                {
+                    (void)memcpy(owned_bytes, message->body_amqp_data_items[i].body_data_section_bytes, message->body_amqp_data_items[i].body_data_section_length);
+                    message->body_amqp_data_items[i].body_data_section_bytes = owned_bytes;
+                    message->body_amqp_data_items[i].is_borrowed = false;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int message_add_body_amqp_data_external(MESSAGE_HANDLE message, BINARY_DATA amqp_data, ON_BODY_AMQP_DATA_RELEASED on_released, void* on_released_context)
+{
+    int result;
+
+    /* Codes_SRS_MESSAGE_01_203: [ If `message` or `on_released` is NULL, or the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data_external` shall fail and return a non-zero value. ]*/
+    if ((message == NULL) ||
+        (on_released == NULL) ||
+        ((amqp_data.bytes == NULL) &&
+         (amqp_data.length != 0)))
+    {
+        LogError("Bad arguments: message = %p, on_released = %p, bytes = %p, length = %u",
+            message, on_released, amqp_data.bytes, (unsigned int)amqp_data.length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        EXTERNAL_BODY_DATA* external = REFCOUNT_TYPE_CREATE(EXTERNAL_BODY_DATA);
+        if (external == NULL)
+        {
+            /* Codes_SRS_MESSAGE_01_204: [ If the body was already set to an AMQP value or a list of AMQP sequences, or any other error occurs, `message_add_body_amqp_data_external` shall fail, return a non-zero value and not call `on_released`. ]*/
+            LogError("Cannot allocate memory for the external body data");
+            result = __FAILURE__;
+        }
+        else
+        {
+            external->on_released = on_released;
+            external->on_released_context = on_released_context;
+
+            /* Codes_SRS_MESSAGE_01_202: [ `message_add_body_amqp_data_external` shall add `amqp_data` to the list of AMQP data values for the body of the message identified by `message` without copying the bytes, which shall stay valid until `on_released` is called. ]*/
+            if (add_body_amqp_data(message, amqp_data, true) != 0)
+            {
+                /* Codes_SRS_MESSAGE_01_204: [ If the body was already set to an AMQP value or a list of AMQP sequences, or any other error occurs, `message_add_body_amqp_data_external` shall fail, return a non-zero value and not call `on_released`. ]*/
+                LogError("Cannot add the external body data");
+                free(external);
+                result = __FAILURE__;
+            }
+            else
+            {
+                message->body_amqp_data_items[message->body_amqp_data_count - 1].external = external;
+
+                /* Codes_SRS_MESSAGE_01_207: [ On success it shall return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
 int message_get_body_amqp_data_in_place(MESSAGE_HANDLE message, size_t index, BINARY_DATA* amqp_data)
 {
     int result;
@@ -1183,6 +1874,8 @@ int message_set_body_amqp_value(MESSAGE_HANDLE message, AMQP_VALUE body_amqp_val
                 /* Codes_SRS_MESSAGE_01_101: [ `message_set_body_amqp_value` shall set the contents of body as being the AMQP value indicate by `body_amqp_value`. ]*/
                 message->body_amqp_value = new_amqp_value;
 
+                message->is_encoded_size_valid = false;
+
                 /* Codes_SRS_MESSAGE_01_102: [ On success it shall return 0. ]*/
                 result = 0;
             }
@@ -1275,6 +1968,8 @@ int message_add_body_amqp_sequence(MESSAGE_HANDLE message, AMQP_VALUE sequence_l
                     /* Codes_SRS_MESSAGE_01_114: [ If adding the AMQP sequence fails, the previous value shall be preserved. ]*/
                     message->body_amqp_sequence_count++;
 
+                    message->is_encoded_size_valid = false;
+
                     /* Codes_SRS_MESSAGE_01_111: [ On success it shall return 0. ]*/
                     result = 0;
                 }
@@ -1448,3 +2143,123 @@ int message_get_message_format(MESSAGE_HANDLE message, uint32_t *message_format)
 
     return result;
 }
+
+/* takes ownership of section_value */
+static int add_section_encoded_size(AMQP_VALUE section_value, size_t* total_encoded_size)
+{
+    int result;
+
+    if (section_value == NULL)
+    {
+        LogError("Cannot create section value");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t encoded_size;
+
+        if (amqpvalue_get_encoded_size(section_value, &encoded_size) != 0)
+        {
+            LogError("Cannot get section encoded size");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *total_encoded_size += encoded_size;
+            result = 0;
+        }
+
+        amqpvalue_destroy(section_value);
+    }
+
+    return result;
+}
+
+static int compute_encoded_size(MESSAGE_HANDLE message, size_t* encoded_size)
+{
+    int result = 0;
+    size_t total_encoded_size = 0;
+    size_t i;
+
+    /* the sections the message sender transfers: header, message annotations, properties, application properties and the body */
+    if (message->header != NULL)
+    {
+        result = add_section_encoded_size(amqpvalue_create_header(message->header), &total_encoded_size);
+    }
+
+    if ((result == 0) && (message->message_annotations != NULL))
+    {
+        result = add_section_encoded_size(amqpvalue_clone(message->message_annotations), &total_encoded_size);
+    }
+
+    if ((result == 0) && (message->properties != NULL))
+    {
+        result = add_section_encoded_size(amqpvalue_create_properties(message->properties), &total_encoded_size);
+    }
+
+    if ((result == 0) && (message->application_properties != NULL))
+    {
+        result = add_section_encoded_size(amqpvalue_create_application_properties(message->application_properties), &total_encoded_size);
+    }
+
+    if ((result == 0) && (message->body_amqp_value != NULL))
+    {
+        result = add_section_encoded_size(amqpvalue_create_amqp_value(message->body_amqp_value), &total_encoded_size);
+    }
+
+    for (i = 0; (result == 0) && (i < message->body_amqp_sequence_count); i++)
+    {
+        result = add_section_encoded_size(amqpvalue_create_amqp_sequence(message->body_amqp_sequence_items[i]), &total_encoded_size);
+    }
+
+    for (i = 0; (result == 0) && (i < message->body_amqp_data_count); i++)
+    {
+        /* a data section is the descriptor followed by a vbin8 or vbin32 */
+        size_t data_length = message->body_amqp_data_items[i].body_data_section_length;
+        total_encoded_size += ((data_length <= 255) ? 5 : 8) + data_length;
+    }
+
+    if (result == 0)
+    {
+        *encoded_size = total_encoded_size;
+    }
+
+    return result;
+}
+
+int message_get_encoded_size(MESSAGE_HANDLE message, size_t* encoded_size)
+{
+    int result;
+
+    if ((message == NULL) ||
+        (encoded_size == NULL))
+    {
+        /* Codes_SRS_MESSAGE_01_199: [ If `message` or `encoded_size` is NULL, `message_get_encoded_size` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: message = %p, encoded_size = %p",
+            message, encoded_size);
+        result = __FAILURE__;
+    }
+    else if (message->is_encoded_size_valid)
+    {
+        /* Codes_SRS_MESSAGE_01_198: [ The computed size shall be cached and returned by later calls until one of the setters changes the message. ]*/
+        *encoded_size = message->encoded_size;
+        result = 0;
+    }
+    /* Codes_SRS_MESSAGE_01_197: [ `message_get_encoded_size` shall compute the total AMQP encoded size of the header, message annotations, properties, application properties and body sections of `message`, as transferred by the message sender. ]*/
+    else if (compute_encoded_size(message, &message->encoded_size) != 0)
+    {
+        /* Codes_SRS_MESSAGE_01_200: [ If computing the encoded size of any section fails, `message_get_encoded_size` shall fail and return a non-zero value. ]*/
+        LogError("Cannot compute message encoded size");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message->is_encoded_size_valid = true;
+        *encoded_size = message->encoded_size;
+
+        /* Codes_SRS_MESSAGE_01_201: [ On success it shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
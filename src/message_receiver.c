@@ -2,15 +2,96 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 #include "azure_uamqp_c/link.h"
 #include "azure_uamqp_c/amqp_definitions.h"
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/message_receiver.h"
+#include "azure_uamqp_c/message_sender.h"
 #include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/messaging.h"
+#include "azure_uamqp_c/columnar_batch.h"
+#include "azure_uamqp_c/lock_free_stack.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define ATOMIC_LOAD_ACQUIRE_UINT32(target) ((uint32_t)InterlockedCompareExchange((LONG volatile*)(target), 0, 0))
+#define ATOMIC_STORE_RELEASE_UINT32(target, value) (void)InterlockedExchange((LONG volatile*)(target), (LONG)(value))
+#define ATOMIC_FULL_FENCE() MemoryBarrier()
+#else
+#define ATOMIC_LOAD_ACQUIRE_UINT32(target) __atomic_load_n((target), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE_RELEASE_UINT32(target, value) __atomic_store_n((target), (value), __ATOMIC_RELEASE)
+#define ATOMIC_FULL_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_MESSAGE_RECEIVER
+#include "azure_uamqp_c/alloc_counters.h"
+
+/* the head and the tail of the receive ring are kept on cache lines of their own */
+#define CACHE_LINE_SIZE 64
+
+/* 0x00, an ulong descriptor (at most 9 bytes), the value constructor and a 4 byte size */
+#define MAX_SECTION_HEADER_SIZE 15
+
+typedef enum STREAMED_SECTION_MODE_TAG
+{
+    STREAMED_SECTION_MODE_BUFFER,
+    STREAMED_SECTION_MODE_BODY_DATA,
+    STREAMED_SECTION_MODE_SKIP
+} STREAMED_SECTION_MODE;
+
+/* a message-id remembered by the duplicate detection, entries are kept in a ring in the order they were received */
+typedef struct RECEIVED_MESSAGE_ID_TAG
+{
+    AMQP_VALUE message_id;
+    uint32_t hash;
+    tickcounter_ms_t received_ms;
+    /* index + 1 of the next entry in the same bucket, 0 ends the chain */
+    uint32_t next_in_bucket;
+} RECEIVED_MESSAGE_ID;
+
+/* a message handed over with on_message_dispatch, in the waiting list, then in the in flight list until it is completed */
+typedef struct MESSAGE_DISPATCH_INSTANCE_TAG
+{
+    /* first member, pushed by messagereceiver_complete_dispatch and taken whole by messagereceiver_dowork */
+    LOCK_FREE_STACK_ENTRY completed_entry;
+    struct MESSAGE_RECEIVER_INSTANCE_TAG* message_receiver;
+    MESSAGE_HANDLE message;
+    delivery_number delivery_id;
+    /* NULL for a message without a key, which is not ordered with any other */
+    AMQP_VALUE key;
+    uint32_t key_hash;
+    AMQP_VALUE delivery_state;
+    struct MESSAGE_DISPATCH_INSTANCE_TAG* next;
+    /* went through the receive ring, it is in no list while it is not completed */
+    bool is_pulled;
+} MESSAGE_DISPATCH_INSTANCE;
+
+/* Single producer (the thread running the connection) single consumer (the thread pulling) ring of the dispatches of received
+   messages. The positions only grow and are taken modulo the capacity, a power of 2. The consumer only waits on the condition
+   after setting is_consumer_waiting under the lock, and the producer only takes the lock to wake it up when it is set. */
+typedef struct RECEIVE_RING_TAG
+{
+    uint32_t head;
+    unsigned char head_padding[CACHE_LINE_SIZE - sizeof(uint32_t)];
+    uint32_t tail;
+    unsigned char tail_padding[CACHE_LINE_SIZE - sizeof(uint32_t)];
+    uint32_t is_consumer_waiting;
+    uint32_t capacity;
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    /* the capacity entries, right after the ring in the same allocation */
+    MESSAGE_DISPATCH_INSTANCE** entries;
+} RECEIVE_RING;
 
 typedef struct MESSAGE_RECEIVER_INSTANCE_TAG
 {
@@ -22,6 +103,90 @@ typedef struct MESSAGE_RECEIVER_INSTANCE_TAG
     const void* callback_context;
     MESSAGE_HANDLE decoded_message;
     bool decode_error;
+    uint32_t decoded_sections;
+    AMQPVALUE_DECODER_HANDLE section_decoder;
+    /* decoder reused (and reset) for every transfer that is decoded as a whole message */
+    AMQPVALUE_DECODER_HANDLE message_decoder;
+    /* decoder for the messages batched in a received message, created on the first messagereceiver_decode_batched_message */
+    AMQPVALUE_DECODER_HANDLE batched_message_decoder;
+    /* limits applied to every decoder above, see messagereceiver_set_decoder_limits */
+    uint32_t decoder_max_depth;
+    size_t decoder_max_element_count;
+    size_t decoder_max_allocated_bytes;
+    ON_MESSAGE_BODY_DATA_RECEIVED on_body_data_received;
+    /* NULL unless messagereceiver_set_on_raw_message_received was called, the transfers are then not decoded */
+    ON_RAW_MESSAGE_RECEIVED on_raw_message_received;
+    /* state of the message being streamed, only used when on_body_data_received is set */
+    MESSAGE_HANDLE streamed_message;
+    AMQPVALUE_DECODER_HANDLE streamed_message_decoder;
+    bool is_discarding_streamed_message;
+    unsigned char section_header[MAX_SECTION_HEADER_SIZE];
+    size_t section_header_length;
+    size_t section_header_size;
+    uint64_t section_size;
+    uint64_t section_bytes_left;
+    STREAMED_SECTION_MODE section_mode;
+    unsigned char* section_bytes;
+    /* the message handed to on_message_received is reset and kept for the next transfer instead of being destroyed */
+    bool is_recycling_messages;
+    MESSAGE_HANDLE recycled_message;
+    /* the message being handed to on_message_received, or NULL once messagereceiver_take_message took it */
+    MESSAGE_HANDLE delivered_message;
+    bool is_delivering_message;
+    /* the batch being pulled with messagereceiver_receive_batch_async, on_batch_received is NULL when there is none */
+    ON_MESSAGE_BATCH_RECEIVED on_batch_received;
+    void* on_batch_received_context;
+    MESSAGE_HANDLE* batch_messages;
+    delivery_number* batch_message_ids;
+    uint32_t batch_max_count;
+    uint32_t batch_count;
+    /* the columnar batch being pulled with messagereceiver_receive_columnar_batch_async, NULL when there is none */
+    COLUMNAR_BATCH_HANDLE columnar_batch;
+    ON_COLUMNAR_BATCH_RECEIVED on_columnar_batch_received;
+    void* on_columnar_batch_received_context;
+    /* duplicate detection, received_message_ids is NULL when it is off */
+    RECEIVED_MESSAGE_ID* received_message_ids;
+    uint32_t max_received_message_ids;
+    uint32_t oldest_received_message_id;
+    uint32_t received_message_id_count;
+    /* index + 1 of the first entry of each bucket, the bucket count is a power of 2 */
+    uint32_t* message_id_buckets;
+    uint32_t message_id_bucket_count;
+    tickcounter_ms_t duplicate_detection_window;
+    TICK_COUNTER_HANDLE duplicate_detection_tick_counter;
+    /* the message-id of the message being decoded, in place in its properties */
+    AMQP_VALUE decoded_message_id;
+    bool is_duplicate_message;
+    /* ordered dispatch, on_message_dispatch is NULL when it is off */
+    ON_MESSAGE_DISPATCH on_message_dispatch;
+    void* on_message_dispatch_context;
+    uint32_t max_dispatches_in_flight;
+    /* the message annotation holding the key, NULL to use the group-id */
+    char* dispatch_key_annotation;
+    MESSAGE_DISPATCH_INSTANCE* first_waiting_dispatch;
+    MESSAGE_DISPATCH_INSTANCE* last_waiting_dispatch;
+    uint32_t waiting_dispatch_count;
+    MESSAGE_DISPATCH_INSTANCE* dispatches_in_flight;
+    uint32_t dispatch_in_flight_count;
+    LOCK_FREE_STACK completed_dispatches;
+    bool is_dispatch_flow_paused;
+    /* NULL unless messagereceiver_set_receive_ring was called, received messages are then pulled instead of dispatched */
+    RECEIVE_RING* receive_ring;
+    /* pushed to the ring and not completed yet */
+    uint32_t pulled_dispatch_count;
+    bool is_ring_flow_paused;
+    /* NULL unless messagereceiver_set_body_decoding was called */
+    ON_MESSAGE_BODY_DECODE on_body_decode;
+    void* on_body_decode_context;
+    char* body_content_encoding;
+    /* the properties of the message being decoded have the content-encoding of body_content_encoding */
+    bool is_decoded_body_encoded;
+    /* NULL unless messagereceiver_set_body_codec was called */
+    ON_MESSAGE_BODY_VIEW_RECEIVED on_body_view_received;
+    void* on_body_view_received_context;
+    char* body_content_type;
+    /* the properties of the message being decoded have the content-type of body_content_type */
+    bool is_decoded_body_viewed;
 } MESSAGE_RECEIVER_INSTANCE;
 
 static void set_message_receiver_state(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_RECEIVER_STATE new_state)
@@ -34,6 +199,44 @@ static void set_message_receiver_state(MESSAGE_RECEIVER_INSTANCE* message_receiv
     }
 }
 
+static void free_decoded_body_data(void* context)
+{
+    free(context);
+}
+
+static int add_decoded_body_data(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_HANDLE message, BINARY_DATA encoded_data)
+{
+    int result;
+    unsigned char* bytes = NULL;
+    size_t length = 0;
+
+    if (message_receiver->on_body_decode(message_receiver->on_body_decode_context, encoded_data.bytes, encoded_data.length, &bytes, &length) != 0)
+    {
+        LogError("Cannot decode body DATA with content encoding %s", message_receiver->body_content_encoding);
+        result = __FAILURE__;
+    }
+    else
+    {
+        BINARY_DATA binary_data;
+        binary_data.bytes = bytes;
+        binary_data.length = length;
+
+        /* the decoded bytes are handed over to the message, which frees them with its last reference */
+        if (message_add_body_amqp_data_external(message, binary_data, free_decoded_body_data, bytes) != 0)
+        {
+            LogError("Cannot add decoded body DATA");
+            free(bytes);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 static void decode_message_value_callback(void* context, AMQP_VALUE decoded_value)
 {
     MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
@@ -58,13 +261,37 @@ static void decode_message_value_callback(void* context, AMQP_VALUE decoded_valu
         }
         else
         {
-            if (message_set_properties(decoded_message, properties) != 0)
+            /* the freshly decoded properties are handed over rather than cloned */
+            if (message_take_properties(decoded_message, properties) != 0)
             {
                 LogError("Error setting message properties on received message");
+                properties_destroy(properties);
                 message_receiver->decode_error = true;
             }
+            else if ((message_receiver->received_message_ids != NULL) &&
+                (properties_get_message_id(properties, &message_receiver->decoded_message_id) != 0))
+            {
+                /* a message without a message-id is never a duplicate */
+                message_receiver->decoded_message_id = NULL;
+            }
 
-            properties_destroy(properties);
+            if (message_receiver->on_body_decode != NULL)
+            {
+                const char* content_encoding;
+
+                message_receiver->is_decoded_body_encoded =
+                    (properties_get_content_encoding(properties, &content_encoding) == 0) &&
+                    (strcmp(content_encoding, message_receiver->body_content_encoding) == 0);
+            }
+
+            if (message_receiver->on_body_view_received != NULL)
+            {
+                const char* content_type;
+
+                message_receiver->is_decoded_body_viewed =
+                    (properties_get_content_type(properties, &content_type) == 0) &&
+                    (strcmp(content_type, message_receiver->body_content_type) == 0);
+            }
         }
     }
     else if (is_delivery_annotations_type_by_descriptor(descriptor))
@@ -111,13 +338,12 @@ static void decode_message_value_callback(void* context, AMQP_VALUE decoded_valu
         }
         else
         {
-            if (message_set_header(decoded_message, header) != 0)
+            if (message_take_header(decoded_message, header) != 0)
             {
                 LogError("Error setting message header on received message");
+                header_destroy(header);
                 message_receiver->decode_error = true;
             }
-
-            header_destroy(header);
         }
     }
     else if (is_footer_type_by_descriptor(descriptor))
@@ -208,7 +434,24 @@ static void decode_message_value_callback(void* context, AMQP_VALUE decoded_valu
                         BINARY_DATA binary_data;
                         binary_data.bytes = (const unsigned char*)data_value.bytes;
                         binary_data.length = data_value.length;
-                        if (message_add_body_amqp_data(decoded_message, binary_data) != 0)
+                        int add_result;
+
+                        /* a whole payload outlives the message handed to on_message_received, so its data sections are referenced in place
+                        (and copied if the message is kept), while a streamed message outlives the frames it is decoded from and has to copy them */
+                        if (message_receiver->is_decoded_body_encoded)
+                        {
+                            add_result = add_decoded_body_data(message_receiver, decoded_message, binary_data);
+                        }
+                        else if (decoded_message == message_receiver->streamed_message)
+                        {
+                            add_result = message_add_body_amqp_data(decoded_message, binary_data);
+                        }
+                        else
+                        {
+                            add_result = message_add_body_amqp_data_borrowed(decoded_message, binary_data);
+                        }
+
+                        if (add_result != 0)
                         {
                             LogError("Error adding body DATA to received message");
                             message_receiver->decode_error = true;
@@ -220,241 +463,2364 @@ static void decode_message_value_callback(void* context, AMQP_VALUE decoded_valu
     }
 }
 
-static AMQP_VALUE on_transfer_received(void* context, TRANSFER_HANDLE transfer, uint32_t payload_size, const unsigned char* payload_bytes)
+static void remove_oldest_received_message_id(MESSAGE_RECEIVER_INSTANCE* message_receiver)
 {
-    AMQP_VALUE result = NULL;
-    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
+    RECEIVED_MESSAGE_ID* oldest = &message_receiver->received_message_ids[message_receiver->oldest_received_message_id];
+    uint32_t* link_to_oldest = &message_receiver->message_id_buckets[oldest->hash & (message_receiver->message_id_bucket_count - 1)];
 
-    (void)transfer;
-    if (message_receiver->on_message_received != NULL)
+    /* the oldest entry is at the end of its chain, since entries are added at the front */
+    while (*link_to_oldest != message_receiver->oldest_received_message_id + 1)
     {
-        MESSAGE_HANDLE message = message_create();
-        if (message == NULL)
+        link_to_oldest = &message_receiver->received_message_ids[*link_to_oldest - 1].next_in_bucket;
+    }
+
+    *link_to_oldest = oldest->next_in_bucket;
+    amqpvalue_destroy(oldest->message_id);
+
+    message_receiver->oldest_received_message_id = (message_receiver->oldest_received_message_id + 1) % message_receiver->max_received_message_ids;
+    message_receiver->received_message_id_count--;
+}
+
+static void clear_received_message_ids(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    while (message_receiver->received_message_id_count > 0)
+    {
+        remove_oldest_received_message_id(message_receiver);
+    }
+}
+
+/* returns true when message_id was received within the window, otherwise message_id is remembered */
+static bool check_received_message_id(MESSAGE_RECEIVER_INSTANCE* message_receiver, AMQP_VALUE message_id)
+{
+    bool result = false;
+    uint32_t hash = amqpvalue_hash(message_id);
+    tickcounter_ms_t current_ms = 0;
+    uint32_t entry_index;
+
+    if ((message_receiver->duplicate_detection_window > 0) &&
+        (tickcounter_get_current_ms(message_receiver->duplicate_detection_tick_counter, &current_ms) != 0))
+    {
+        LogError("Cannot get the current time, the remembered message-ids are not expired");
+    }
+    else
+    {
+        /* entries are in the order they were received, so only the oldest ones can be out of the window */
+        while ((message_receiver->duplicate_detection_window > 0) &&
+            (message_receiver->received_message_id_count > 0) &&
+            (current_ms - message_receiver->received_message_ids[message_receiver->oldest_received_message_id].received_ms >= message_receiver->duplicate_detection_window))
         {
-            LogError("Cannot create message");
-            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+            remove_oldest_received_message_id(message_receiver);
+        }
+    }
+
+    entry_index = message_receiver->message_id_buckets[hash & (message_receiver->message_id_bucket_count - 1)];
+    while (entry_index != 0)
+    {
+        RECEIVED_MESSAGE_ID* entry = &message_receiver->received_message_ids[entry_index - 1];
+
+        if ((entry->hash == hash) &&
+            amqpvalue_are_equal(entry->message_id, message_id))
+        {
+            result = true;
+            break;
+        }
+
+        entry_index = entry->next_in_bucket;
+    }
+
+    if (!result)
+    {
+        AMQP_VALUE cloned_message_id = amqpvalue_clone(message_id);
+
+        if (cloned_message_id == NULL)
+        {
+            LogError("Cannot remember the message-id of the received message");
         }
         else
         {
-            AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(decode_message_value_callback, message_receiver);
-            if (amqpvalue_decoder == NULL)
-            {
-                LogError("Cannot create AMQP value decoder");
-                set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
-            }
-            else
-            {
-                message_receiver->decoded_message = message;
-                message_receiver->decode_error = false;
-                if (amqpvalue_decode_bytes(amqpvalue_decoder, payload_bytes, payload_size) != 0)
-                {
-                    LogError("Cannot decode bytes");
-                    set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
-                }
-                else
-                {
-                    if (message_receiver->decode_error)
-                    {
-                        LogError("Error decoding message");
-                        set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
-                    }
-                    else
-                    {
-                        result = message_receiver->on_message_received(message_receiver->callback_context, message);
-                    }
-                }
+            uint32_t new_index;
+            uint32_t* bucket = &message_receiver->message_id_buckets[hash & (message_receiver->message_id_bucket_count - 1)];
 
-                amqpvalue_decoder_destroy(amqpvalue_decoder);
+            if (message_receiver->received_message_id_count == message_receiver->max_received_message_ids)
+            {
+                remove_oldest_received_message_id(message_receiver);
             }
 
-            message_destroy(message);
+            new_index = (message_receiver->oldest_received_message_id + message_receiver->received_message_id_count) % message_receiver->max_received_message_ids;
+            message_receiver->received_message_ids[new_index].message_id = cloned_message_id;
+            message_receiver->received_message_ids[new_index].hash = hash;
+            message_receiver->received_message_ids[new_index].received_ms = current_ms;
+            message_receiver->received_message_ids[new_index].next_in_bucket = *bucket;
+            *bucket = new_index + 1;
+            message_receiver->received_message_id_count++;
         }
     }
 
     return result;
 }
 
-static void on_link_state_changed(void* context, LINK_STATE new_link_state, LINK_STATE previous_link_state)
+static uint32_t get_section_by_descriptor_code(uint64_t descriptor_code)
 {
-    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
-    (void)previous_link_state;
+    uint32_t result;
 
-    switch (new_link_state)
+    switch (descriptor_code)
     {
     default:
+        result = 0;
         break;
-
-    case LINK_STATE_ATTACHED:
-        if (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPENING)
-        {
-            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_OPEN);
-        }
+    case 0x70:
+        result = MESSAGE_RECEIVER_SECTION_HEADER;
         break;
-    case LINK_STATE_DETACHED:
-        if ((message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPEN) ||
-            (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_CLOSING))
-        {
-            /* User initiated transition, we should be good */
-            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_IDLE);
-        }
-        else if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_IDLE)
-        {
-            /* Any other transition must be an error */
-            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
-        }
+    case 0x71:
+        result = MESSAGE_RECEIVER_SECTION_DELIVERY_ANNOTATIONS;
         break;
-    case LINK_STATE_ERROR:
-        if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_ERROR)
-        {
-            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
-        }
+    case 0x72:
+        result = MESSAGE_RECEIVER_SECTION_MESSAGE_ANNOTATIONS;
+        break;
+    case 0x73:
+        result = MESSAGE_RECEIVER_SECTION_PROPERTIES;
+        break;
+    case 0x74:
+        result = MESSAGE_RECEIVER_SECTION_APPLICATION_PROPERTIES;
+        break;
+    /* data, amqp-sequence and amqp-value */
+    case 0x75:
+    case 0x76:
+    case 0x77:
+        result = MESSAGE_RECEIVER_SECTION_BODY;
+        break;
+    case 0x78:
+        result = MESSAGE_RECEIVER_SECTION_FOOTER;
         break;
     }
+
+    return result;
 }
 
-MESSAGE_RECEIVER_HANDLE messagereceiver_create(LINK_HANDLE link, ON_MESSAGE_RECEIVER_STATE_CHANGED on_message_receiver_state_changed, void* context)
+static void on_message_section_scanned(void* context, uint64_t descriptor_code, const unsigned char* encoded_bytes, size_t encoded_size)
 {
-    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)malloc(sizeof(MESSAGE_RECEIVER_INSTANCE));
-    if (message_receiver == NULL)
+    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
+    uint32_t section = get_section_by_descriptor_code(descriptor_code);
+
+    if (message_receiver->is_duplicate_message)
     {
-        LogError("Error creating message receiver");
+        /* the rest of a duplicate is not decoded, it is accepted without being delivered */
     }
-    else
+    /* sections that were not asked for are skipped without being decoded, except the properties needed to detect duplicates
+       and to decode the body, and the body of a message given to the body codec */
+    else if ((((section & message_receiver->decoded_sections) != 0) ||
+        ((section == MESSAGE_RECEIVER_SECTION_PROPERTIES) &&
+         ((message_receiver->received_message_ids != NULL) || (message_receiver->on_body_decode != NULL) || (message_receiver->on_body_view_received != NULL))) ||
+        ((section == MESSAGE_RECEIVER_SECTION_BODY) && message_receiver->is_decoded_body_viewed)) &&
+        (amqpvalue_decode_bytes(message_receiver->section_decoder, encoded_bytes, encoded_size) != 0))
     {
-        message_receiver->link = link;
-        message_receiver->on_message_receiver_state_changed = on_message_receiver_state_changed;
-        message_receiver->on_message_receiver_state_changed_context = context;
-        message_receiver->message_receiver_state = MESSAGE_RECEIVER_STATE_IDLE;
+        LogError("Cannot decode message section");
+        message_receiver->decode_error = true;
     }
-
-    return message_receiver;
-}
-
-void messagereceiver_destroy(MESSAGE_RECEIVER_HANDLE message_receiver)
-{
-    if (message_receiver == NULL)
+    else if ((section == MESSAGE_RECEIVER_SECTION_PROPERTIES) &&
+        (message_receiver->decoded_message_id != NULL) &&
+        (!message_receiver->decode_error))
     {
-        LogError("NULL message_receiver");
+        message_receiver->is_duplicate_message = check_received_message_id(message_receiver, message_receiver->decoded_message_id);
     }
     else
     {
-        (void)messagereceiver_close(message_receiver);
-        free(message_receiver);
+        /* nothing more to do for this section */
     }
 }
 
-int messagereceiver_open(MESSAGE_RECEIVER_HANDLE message_receiver, ON_MESSAGE_RECEIVED on_message_received, void* callback_context)
+static int decode_message(MESSAGE_RECEIVER_INSTANCE* message_receiver, AMQPVALUE_DECODER_HANDLE amqpvalue_decoder, uint32_t payload_size, const unsigned char* payload_bytes)
 {
     int result;
 
-    if (message_receiver == NULL)
+    /* with duplicate detection the sections are scanned, so that the body of a duplicate is not decoded */
+    if ((message_receiver->decoded_sections == MESSAGE_RECEIVER_SECTION_ALL) &&
+        (message_receiver->received_message_ids == NULL))
     {
-        LogError("NULL message_receiver");
-        result = __FAILURE__;
+        result = amqpvalue_decode_bytes(amqpvalue_decoder, payload_bytes, payload_size);
     }
     else
     {
-        if (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_IDLE)
-        {
-            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_OPENING);
-            if (link_attach(message_receiver->link, on_transfer_received, on_link_state_changed, NULL, message_receiver) != 0)
-            {
-                LogError("Link attach failed");
-                result = __FAILURE__;
-                set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
-            }
-            else
-            {
-                message_receiver->on_message_received = on_message_received;
-                message_receiver->callback_context = callback_context;
-
-                result = 0;
-            }
-        }
-        else
-        {
-            result = 0;
-        }
+        message_receiver->section_decoder = amqpvalue_decoder;
+        result = amqpvalue_scan_described_values(payload_bytes, payload_size, on_message_section_scanned, message_receiver);
+        message_receiver->section_decoder = NULL;
     }
 
     return result;
 }
 
-int messagereceiver_close(MESSAGE_RECEIVER_HANDLE message_receiver)
+static void complete_batch(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_RECEIVER_BATCH_RESULT batch_result)
 {
-    int result;
+    ON_MESSAGE_BATCH_RECEIVED on_batch_received = message_receiver->on_batch_received;
+    MESSAGE_HANDLE* batch_messages = message_receiver->batch_messages;
+    delivery_number* batch_message_ids = message_receiver->batch_message_ids;
+    uint32_t batch_count = message_receiver->batch_count;
 
-    if (message_receiver == NULL)
+    /* cleared first, so that on_batch_received can pull the next batch */
+    message_receiver->on_batch_received = NULL;
+    message_receiver->batch_messages = NULL;
+    message_receiver->batch_message_ids = NULL;
+    message_receiver->batch_count = 0;
+
+    on_batch_received(message_receiver->on_batch_received_context, batch_result, batch_messages, batch_message_ids, batch_count);
+
+    free(batch_messages);
+    free(batch_message_ids);
+}
+
+static void complete_columnar_batch(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_RECEIVER_BATCH_RESULT batch_result)
+{
+    ON_COLUMNAR_BATCH_RECEIVED on_columnar_batch_received = message_receiver->on_columnar_batch_received;
+    COLUMNAR_BATCH_HANDLE columnar_batch = message_receiver->columnar_batch;
+
+    /* cleared first, so that on_columnar_batch_received can pull the next batch */
+    message_receiver->on_columnar_batch_received = NULL;
+    message_receiver->columnar_batch = NULL;
+
+    on_columnar_batch_received(message_receiver->on_columnar_batch_received_context, batch_result, columnar_batch);
+}
+
+/* completes the batch being pulled, whichever kind it is */
+static void complete_pending_batch(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_RECEIVER_BATCH_RESULT batch_result)
+{
+    if (message_receiver->on_batch_received != NULL)
     {
-        LogError("NULL message_receiver");
-        result = __FAILURE__;
+        complete_batch(message_receiver, batch_result);
+    }
+    else if (message_receiver->on_columnar_batch_received != NULL)
+    {
+        complete_columnar_batch(message_receiver, batch_result);
     }
     else
     {
-        if ((message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPENING) ||
-            (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPEN))
-        {
-            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_CLOSING);
-
-            if (link_detach(message_receiver->link, true) != 0)
-            {
-                LogError("link detach failed");
-                result = __FAILURE__;
-                set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
-            }
-            else
-            {
-                result = 0;
-            }
-        }
-        else
-        {
-            result = 0;
-        }
+        /* no batch is being pulled */
     }
+}
 
-    return result;
+static void on_link_drained(void* context, LINK_DRAIN_RESULT drain_result)
+{
+    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
+
+    complete_pending_batch(message_receiver, (drain_result == LINK_DRAIN_RESULT_TIMEOUT) ? MESSAGE_RECEIVER_BATCH_RESULT_TIMEOUT : MESSAGE_RECEIVER_BATCH_RESULT_OK);
 }
 
-int messagereceiver_get_link_name(MESSAGE_RECEIVER_HANDLE message_receiver, const char** link_name)
+/* returns true when the transfer went into the columnar batch being pulled, the application then settles it */
+static bool add_transfer_to_columnar_batch(MESSAGE_RECEIVER_INSTANCE* message_receiver, uint32_t payload_size, const unsigned char* payload_bytes, AMQP_VALUE* delivery_state)
 {
-    int result;
+    bool result;
+    uint32_t row_count;
+    uint32_t max_row_count;
+    delivery_number delivery_id;
 
-    if (message_receiver == NULL)
+    /* transfers the sender had in flight before the batch was asked for can go over its rows, they are delivered as usual */
+    if ((message_receiver->columnar_batch == NULL) ||
+        (columnar_batch_get_row_count(message_receiver->columnar_batch, &row_count) != 0) ||
+        (columnar_batch_get_max_row_count(message_receiver->columnar_batch, &max_row_count) != 0) ||
+        (row_count == max_row_count))
     {
-        LogError("NULL message_receiver");
-        result = __FAILURE__;
+        result = false;
+    }
+    else if (link_get_received_message_id(message_receiver->link, &delivery_id) != 0)
+    {
+        LogError("Cannot get the id of the message of the columnar batch");
+        result = false;
+    }
+    else if (columnar_batch_append_message(message_receiver->columnar_batch, delivery_id, payload_bytes, payload_size) != 0)
+    {
+        /* bytes that cannot be read as a message would fail the same way when delivered again */
+        LogError("Cannot add the message to the columnar batch");
+        *delivery_state = messaging_delivery_rejected("amqp:decode-error", "The message cannot be read");
+        result = true;
     }
     else
     {
-        if (link_get_name(message_receiver->link, link_name) != 0)
-        {
-            LogError("Getting link name failed");
-            result = __FAILURE__;
-        }
-        else
-        {
-            result = 0;
-        }
+        *delivery_state = NULL;
+        result = true;
     }
 
     return result;
 }
 
-int messagereceiver_get_received_message_id(MESSAGE_RECEIVER_HANDLE message_receiver, delivery_number* message_id)
+/* returns true when the message is kept in the batch being pulled, which the application owns once it completes */
+static bool add_message_to_batch(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_HANDLE message)
 {
-    int result;
+    bool result;
 
-    if (message_receiver == NULL)
+    /* transfers the sender had in flight before the batch was asked for can go over max_count, they are delivered as usual */
+    if ((message_receiver->on_batch_received == NULL) ||
+        (message_receiver->batch_count == message_receiver->batch_max_count))
+    {
+        result = false;
+    }
+    else if (link_get_received_message_id(message_receiver->link, &message_receiver->batch_message_ids[message_receiver->batch_count]) != 0)
+    {
+        LogError("Cannot get the id of the batched message");
+        result = false;
+    }
+    /* the batch outlives the payload the body data sections were borrowed from */
+    else if (message_own_body_amqp_data(message) != 0)
+    {
+        LogError("Cannot copy the body of the batched message");
+        result = false;
+    }
+    else
+    {
+        message_receiver->batch_messages[message_receiver->batch_count] = message;
+        message_receiver->batch_count++;
+        result = true;
+    }
+
+    return result;
+}
+
+static AMQP_VALUE get_dispatch_key(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_HANDLE message)
+{
+    AMQP_VALUE result = NULL;
+
+    if (message_receiver->dispatch_key_annotation != NULL)
+    {
+        message_annotations annotations;
+
+        if ((message_get_message_annotations(message, &annotations) == 0) &&
+            (annotations != NULL))
+        {
+            result = amqpvalue_get_map_value_by_symbol(annotations, message_receiver->dispatch_key_annotation);
+            amqpvalue_destroy(annotations);
+        }
+    }
+    else
+    {
+        PROPERTIES_HANDLE properties;
+
+        if ((message_get_properties(message, &properties) == 0) &&
+            (properties != NULL))
+        {
+            const char* group_id;
+
+            if (properties_get_group_id(properties, &group_id) == 0)
+            {
+                result = amqpvalue_create_string(group_id);
+            }
+
+            properties_destroy(properties);
+        }
+    }
+
+    return result;
+}
+
+static void destroy_dispatch(MESSAGE_DISPATCH_INSTANCE* dispatch)
+{
+    message_destroy(dispatch->message);
+    if (dispatch->key != NULL)
+    {
+        amqpvalue_destroy(dispatch->key);
+    }
+
+    if (dispatch->delivery_state != NULL)
+    {
+        amqpvalue_destroy(dispatch->delivery_state);
+    }
+
+    free(dispatch);
+}
+
+static bool is_dispatch_key_in_flight(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_DISPATCH_INSTANCE* dispatch)
+{
+    bool result = false;
+    MESSAGE_DISPATCH_INSTANCE* in_flight = message_receiver->dispatches_in_flight;
+
+    /* there are at most max_dispatches_in_flight of them */
+    while ((dispatch->key != NULL) &&
+        (in_flight != NULL))
+    {
+        if ((in_flight->key != NULL) &&
+            (in_flight->key_hash == dispatch->key_hash) &&
+            amqpvalue_are_equal(in_flight->key, dispatch->key))
+        {
+            result = true;
+            break;
+        }
+
+        in_flight = in_flight->next;
+    }
+
+    return result;
+}
+
+/* returns the connection of the link when it times the application callbacks, NULL otherwise */
+static CONNECTION_HANDLE begin_timed_callback(LINK_HANDLE link, uint64_t* start_ms)
+{
+    CONNECTION_HANDLE result;
+
+    if ((link_get_connection(link, &result) != 0) ||
+        (!connection_begin_callback(result, start_ms)))
+    {
+        result = NULL;
+    }
+
+    return result;
+}
+
+static void end_timed_callback(CONNECTION_HANDLE connection, LINK_HANDLE link, CONNECTION_CALLBACK_TYPE callback_type, uint64_t start_ms)
+{
+    if (connection != NULL)
+    {
+        const char* link_name;
+
+        if (link_get_name(link, &link_name) != 0)
+        {
+            link_name = NULL;
+        }
+
+        connection_end_callback(connection, callback_type, link_name, start_ms);
+    }
+}
+
+static void dispatch_waiting_messages(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    while (message_receiver->dispatch_in_flight_count < message_receiver->max_dispatches_in_flight)
+    {
+        /* the first waiting message whose key is free, a later message of the same key cannot overtake it */
+        MESSAGE_DISPATCH_INSTANCE* previous = NULL;
+        MESSAGE_DISPATCH_INSTANCE* dispatch = message_receiver->first_waiting_dispatch;
+        uint64_t start_ms;
+        CONNECTION_HANDLE timing_connection;
+
+        while ((dispatch != NULL) &&
+            is_dispatch_key_in_flight(message_receiver, dispatch))
+        {
+            previous = dispatch;
+            dispatch = dispatch->next;
+        }
+
+        if (dispatch == NULL)
+        {
+            break;
+        }
+
+        if (previous == NULL)
+        {
+            message_receiver->first_waiting_dispatch = dispatch->next;
+        }
+        else
+        {
+            previous->next = dispatch->next;
+        }
+
+        if (message_receiver->last_waiting_dispatch == dispatch)
+        {
+            message_receiver->last_waiting_dispatch = previous;
+        }
+
+        message_receiver->waiting_dispatch_count--;
+
+        dispatch->next = message_receiver->dispatches_in_flight;
+        message_receiver->dispatches_in_flight = dispatch;
+        message_receiver->dispatch_in_flight_count++;
+
+        timing_connection = begin_timed_callback(message_receiver->link, &start_ms);
+        message_receiver->on_message_dispatch(message_receiver->on_message_dispatch_context, dispatch, dispatch->message);
+        end_timed_callback(timing_connection, message_receiver->link, CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED, start_ms);
+    }
+}
+
+static int queue_dispatch(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_HANDLE message)
+{
+    int result;
+    MESSAGE_DISPATCH_INSTANCE* dispatch;
+
+    /* a dispatch can complete after the payload the body data sections were borrowed from is gone */
+    if (message_own_body_amqp_data(message) != 0)
+    {
+        LogError("Cannot copy the body of the dispatched message");
+        result = __FAILURE__;
+    }
+    else if ((dispatch = (MESSAGE_DISPATCH_INSTANCE*)malloc(sizeof(MESSAGE_DISPATCH_INSTANCE))) == NULL)
+    {
+        LogError("Cannot allocate the dispatch of the received message");
+        result = __FAILURE__;
+    }
+    else if (link_get_received_message_id(message_receiver->link, &dispatch->delivery_id) != 0)
+    {
+        LogError("Cannot get the id of the dispatched message");
+        free(dispatch);
+        result = __FAILURE__;
+    }
+    else
+    {
+        dispatch->message_receiver = message_receiver;
+        dispatch->message = message;
+        dispatch->key = get_dispatch_key(message_receiver, message);
+        dispatch->key_hash = amqpvalue_hash(dispatch->key);
+        dispatch->delivery_state = NULL;
+        dispatch->next = NULL;
+        dispatch->completed_entry.next = NULL;
+        dispatch->is_pulled = false;
+
+        if (message_receiver->last_waiting_dispatch == NULL)
+        {
+            message_receiver->first_waiting_dispatch = dispatch;
+        }
+        else
+        {
+            message_receiver->last_waiting_dispatch->next = dispatch;
+        }
+
+        message_receiver->last_waiting_dispatch = dispatch;
+        message_receiver->waiting_dispatch_count++;
+
+        dispatch_waiting_messages(message_receiver);
+
+        /* the credit already given can still bring messages in, no more is given while as many as can be in flight wait */
+        if ((!message_receiver->is_dispatch_flow_paused) &&
+            (message_receiver->waiting_dispatch_count >= message_receiver->max_dispatches_in_flight))
+        {
+            if (link_pause_flow(message_receiver->link) != 0)
+            {
+                LogError("Cannot pause the link flow while dispatched messages wait");
+            }
+            else
+            {
+                message_receiver->is_dispatch_flow_paused = true;
+            }
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static uint32_t get_receive_ring_count(RECEIVE_RING* receive_ring)
+{
+    /* called by the producer, the consumer only moves the head */
+    return receive_ring->tail - ATOMIC_LOAD_ACQUIRE_UINT32(&receive_ring->head);
+}
+
+static int push_to_receive_ring(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_HANDLE message)
+{
+    int result;
+    RECEIVE_RING* receive_ring = message_receiver->receive_ring;
+    MESSAGE_DISPATCH_INSTANCE* dispatch;
+
+    if (get_receive_ring_count(receive_ring) == receive_ring->capacity)
+    {
+        /* only the credit given before the flow was paused brings messages into a full ring */
+        LogError("The receive ring is full");
+        result = __FAILURE__;
+    }
+    /* the message is pulled after the payload the body data sections were borrowed from is gone */
+    else if (message_own_body_amqp_data(message) != 0)
+    {
+        LogError("Cannot copy the body of the received message");
+        result = __FAILURE__;
+    }
+    else if ((dispatch = (MESSAGE_DISPATCH_INSTANCE*)malloc(sizeof(MESSAGE_DISPATCH_INSTANCE))) == NULL)
+    {
+        LogError("Cannot allocate the dispatch of the received message");
+        result = __FAILURE__;
+    }
+    else if (link_get_received_message_id(message_receiver->link, &dispatch->delivery_id) != 0)
+    {
+        LogError("Cannot get the id of the received message");
+        free(dispatch);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t tail = receive_ring->tail;
+
+        dispatch->message_receiver = message_receiver;
+        dispatch->message = message;
+        dispatch->key = NULL;
+        dispatch->key_hash = 0;
+        dispatch->delivery_state = NULL;
+        dispatch->next = NULL;
+        dispatch->completed_entry.next = NULL;
+        dispatch->is_pulled = true;
+
+        receive_ring->entries[tail & (receive_ring->capacity - 1)] = dispatch;
+        ATOMIC_STORE_RELEASE_UINT32(&receive_ring->tail, tail + 1);
+        message_receiver->pulled_dispatch_count++;
+
+        /* pairs with the fence of messagereceiver_receive_wait: either the consumer sees the new tail or it is seen waiting */
+        ATOMIC_FULL_FENCE();
+        if (ATOMIC_LOAD_ACQUIRE_UINT32(&receive_ring->is_consumer_waiting) != 0)
+        {
+            if (Lock(receive_ring->lock) != LOCK_OK)
+            {
+                LogError("Cannot lock the receive ring");
+            }
+            else
+            {
+                (void)Condition_Post(receive_ring->condition);
+                (void)Unlock(receive_ring->lock);
+            }
+        }
+
+        /* the credit already given can still bring messages in, so no more is given once the ring is half full */
+        if ((!message_receiver->is_ring_flow_paused) &&
+            (get_receive_ring_count(receive_ring) > (receive_ring->capacity / 2)))
+        {
+            if (link_pause_flow(message_receiver->link) != 0)
+            {
+                LogError("Cannot pause the link flow while the receive ring is half full");
+            }
+            else
+            {
+                message_receiver->is_ring_flow_paused = true;
+            }
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+/* called by the consumer */
+static MESSAGE_DISPATCH_INSTANCE* take_from_receive_ring(RECEIVE_RING* receive_ring)
+{
+    MESSAGE_DISPATCH_INSTANCE* result;
+    uint32_t head = receive_ring->head;
+
+    if (ATOMIC_LOAD_ACQUIRE_UINT32(&receive_ring->tail) == head)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = receive_ring->entries[head & (receive_ring->capacity - 1)];
+        ATOMIC_STORE_RELEASE_UINT32(&receive_ring->head, head + 1);
+    }
+
+    return result;
+}
+
+static void resume_ring_flow(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    if (message_receiver->is_ring_flow_paused &&
+        (get_receive_ring_count(message_receiver->receive_ring) <= (message_receiver->receive_ring->capacity / 2)))
+    {
+        if (link_resume_flow(message_receiver->link) != 0)
+        {
+            LogError("Cannot resume the link flow after messages were taken from the receive ring");
+        }
+        else
+        {
+            message_receiver->is_ring_flow_paused = false;
+        }
+    }
+}
+
+static void destroy_receive_ring(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    RECEIVE_RING* receive_ring = message_receiver->receive_ring;
+    MESSAGE_DISPATCH_INSTANCE* dispatch;
+
+    /* messages that were never pulled are left unsettled, the peer redelivers them to another link */
+    while ((dispatch = take_from_receive_ring(receive_ring)) != NULL)
+    {
+        message_receiver->pulled_dispatch_count--;
+        destroy_dispatch(dispatch);
+    }
+
+    Condition_Deinit(receive_ring->condition);
+    (void)Lock_Deinit(receive_ring->lock);
+    free(receive_ring);
+    message_receiver->receive_ring = NULL;
+}
+
+static void settle_completed_dispatches(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    /* the dispatches are settled in completion order */
+    MESSAGE_DISPATCH_INSTANCE* dispatch = (MESSAGE_DISPATCH_INSTANCE*)lock_free_stack_take_all(&message_receiver->completed_dispatches);
+
+    while (dispatch != NULL)
+    {
+        MESSAGE_DISPATCH_INSTANCE* next = (MESSAGE_DISPATCH_INSTANCE*)dispatch->completed_entry.next;
+        MESSAGE_DISPATCH_INSTANCE** link_to_dispatch = &message_receiver->dispatches_in_flight;
+
+        while ((!dispatch->is_pulled) &&
+            (*link_to_dispatch != NULL) &&
+            (*link_to_dispatch != dispatch))
+        {
+            link_to_dispatch = &(*link_to_dispatch)->next;
+        }
+
+        if ((!dispatch->is_pulled) &&
+            (*link_to_dispatch == NULL))
+        {
+            LogError("Completed dispatch is not in flight");
+        }
+        else
+        {
+            if (dispatch->is_pulled)
+            {
+                message_receiver->pulled_dispatch_count--;
+            }
+            else
+            {
+                *link_to_dispatch = dispatch->next;
+                message_receiver->dispatch_in_flight_count--;
+            }
+
+            if (link_send_disposition(message_receiver->link, dispatch->delivery_id, dispatch->delivery_state) != 0)
+            {
+                LogError("Cannot settle the dispatched message %u", (unsigned int)dispatch->delivery_id);
+            }
+
+            destroy_dispatch(dispatch);
+        }
+
+        dispatch = next;
+    }
+
+    if (message_receiver->on_message_dispatch != NULL)
+    {
+        dispatch_waiting_messages(message_receiver);
+    }
+
+    if (message_receiver->is_dispatch_flow_paused &&
+        (message_receiver->waiting_dispatch_count < message_receiver->max_dispatches_in_flight))
+    {
+        if (link_resume_flow(message_receiver->link) != 0)
+        {
+            LogError("Cannot resume the link flow after dispatched messages completed");
+        }
+        else
+        {
+            message_receiver->is_dispatch_flow_paused = false;
+        }
+    }
+}
+
+static void discard_waiting_dispatches(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    /* messages that were never handed over are left unsettled, the peer redelivers them to another link */
+    while (message_receiver->first_waiting_dispatch != NULL)
+    {
+        MESSAGE_DISPATCH_INSTANCE* next = message_receiver->first_waiting_dispatch->next;
+        destroy_dispatch(message_receiver->first_waiting_dispatch);
+        message_receiver->first_waiting_dispatch = next;
+    }
+
+    message_receiver->last_waiting_dispatch = NULL;
+    message_receiver->waiting_dispatch_count = 0;
+}
+
+/* returns true when the application took ownership of the message from within the callback */
+/* gives the body codec the data sections of message in place when there is only one of them, joined otherwise;
+   returns false, without calling it, when the body is not data sections */
+static bool deliver_body_view(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_HANDLE message, AMQP_VALUE* delivery_state)
+{
+    bool result;
+    MESSAGE_BODY_TYPE body_type;
+    size_t body_data_count;
+
+    if ((message_get_body_type(message, &body_type) != 0) ||
+        (body_type != MESSAGE_BODY_TYPE_DATA) ||
+        (message_get_body_amqp_data_count(message, &body_data_count) != 0) ||
+        (body_data_count == 0))
+    {
+        result = false;
+    }
+    else
+    {
+        BINARY_DATA binary_data;
+        unsigned char* joined_bytes = NULL;
+
+        if (body_data_count == 1)
+        {
+            if (message_get_body_amqp_data_in_place(message, 0, &binary_data) != 0)
+            {
+                LogError("Cannot get body DATA");
+                result = false;
+            }
+            else
+            {
+                result = true;
+            }
+        }
+        else
+        {
+            size_t body_length = 0;
+            size_t i;
+
+            result = true;
+            for (i = 0; i < body_data_count; i++)
+            {
+                if (message_get_body_amqp_data_in_place(message, i, &binary_data) != 0)
+                {
+                    LogError("Cannot get body DATA %u", (unsigned int)i);
+                    result = false;
+                    break;
+                }
+
+                body_length += binary_data.length;
+            }
+
+            if (result)
+            {
+                joined_bytes = (unsigned char*)malloc(body_length > 0 ? body_length : 1);
+                if (joined_bytes == NULL)
+                {
+                    LogError("Cannot allocate the joined body DATA");
+                    result = false;
+                }
+                else
+                {
+                    size_t pos = 0;
+
+                    for (i = 0; i < body_data_count; i++)
+                    {
+                        (void)message_get_body_amqp_data_in_place(message, i, &binary_data);
+                        (void)memcpy(joined_bytes + pos, binary_data.bytes, binary_data.length);
+                        pos += binary_data.length;
+                    }
+
+                    binary_data.bytes = joined_bytes;
+                    binary_data.length = body_length;
+                }
+            }
+        }
+
+        if (result)
+        {
+            uint64_t start_ms;
+            CONNECTION_HANDLE timing_connection = begin_timed_callback(message_receiver->link, &start_ms);
+
+            *delivery_state = message_receiver->on_body_view_received(message_receiver->on_body_view_received_context, message, binary_data.bytes, binary_data.length);
+            end_timed_callback(timing_connection, message_receiver->link, CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED, start_ms);
+        }
+
+        if (joined_bytes != NULL)
+        {
+            free(joined_bytes);
+        }
+    }
+
+    return result;
+}
+
+static bool deliver_message(MESSAGE_RECEIVER_INSTANCE* message_receiver, MESSAGE_HANDLE message, AMQP_VALUE* delivery_state)
+{
+    bool result;
+
+    if (add_message_to_batch(message_receiver, message))
+    {
+        /* the message is settled later by the application */
+        *delivery_state = NULL;
+        result = true;
+    }
+    else if ((message_receiver->receive_ring != NULL) &&
+        (push_to_receive_ring(message_receiver, message) == 0))
+    {
+        /* the message is settled once the application pulled and completed it */
+        *delivery_state = NULL;
+        result = true;
+    }
+    else if (message_receiver->receive_ring != NULL)
+    {
+        /* the peer can deliver it again */
+        *delivery_state = messaging_delivery_released();
+        result = false;
+    }
+    else if ((message_receiver->on_message_dispatch != NULL) &&
+        (queue_dispatch(message_receiver, message) == 0))
+    {
+        /* the message is settled once its dispatch completes */
+        *delivery_state = NULL;
+        result = true;
+    }
+    else if (message_receiver->on_message_dispatch != NULL)
+    {
+        /* the peer can deliver it again */
+        *delivery_state = messaging_delivery_released();
+        result = false;
+    }
+    else if (message_receiver->is_decoded_body_viewed &&
+        deliver_body_view(message_receiver, message, delivery_state))
+    {
+        /* the view only lives during the call, the message stays with the receiver */
+        result = false;
+    }
+    else
+    {
+        uint64_t start_ms;
+        CONNECTION_HANDLE timing_connection = begin_timed_callback(message_receiver->link, &start_ms);
+
+        message_receiver->delivered_message = message;
+        message_receiver->is_delivering_message = true;
+        *delivery_state = message_receiver->on_message_received(message_receiver->callback_context, message);
+        message_receiver->is_delivering_message = false;
+        end_timed_callback(timing_connection, message_receiver->link, CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED, start_ms);
+        result = (message_receiver->delivered_message == NULL);
+        message_receiver->delivered_message = NULL;
+    }
+
+    return result;
+}
+
+static void set_received_message_format(MESSAGE_HANDLE message, TRANSFER_HANDLE transfer)
+{
+    message_format received_message_format;
+
+    if (transfer_get_message_format(transfer, &received_message_format) != 0)
+    {
+        /* the message-format field defaults to 0 */
+        received_message_format = 0;
+    }
+
+    /* so that the application can tell a batch (AMQP_BATCHED_MESSAGE_FORMAT) from a plain message */
+    if ((received_message_format != 0) &&
+        (message_set_message_format(message, received_message_format) != 0))
+    {
+        LogError("Cannot set the message format of the received message");
+    }
+}
+
+static int set_message_decoder_limits(MESSAGE_RECEIVER_INSTANCE* message_receiver, AMQPVALUE_DECODER_HANDLE decoder)
+{
+    return amqpvalue_decoder_set_limits(decoder, message_receiver->decoder_max_depth, message_receiver->decoder_max_element_count, message_receiver->decoder_max_allocated_bytes);
+}
+
+/* The bytes given to the message decoders outlive the decoding and whatever the message keeps is copied, so binaries can
+   point into them and list items can be decoded from them when they are read. */
+static int configure_message_decoder(MESSAGE_RECEIVER_INSTANCE* message_receiver, AMQPVALUE_DECODER_HANDLE decoder)
+{
+    int result;
+
+    if (amqpvalue_decoder_set_borrow_binaries(decoder, true) != 0)
+    {
+        LogError("Cannot enable borrowing binaries on the AMQP value decoder");
+        result = __FAILURE__;
+    }
+    else if (amqpvalue_decoder_set_lazy_lists(decoder, true) != 0)
+    {
+        LogError("Cannot enable lazy lists on the AMQP value decoder");
+        result = __FAILURE__;
+    }
+    else if (set_message_decoder_limits(message_receiver, decoder) != 0)
+    {
+        LogError("Cannot set the limits on the AMQP value decoder");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int create_message_decoder(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    int result;
+
+    message_receiver->message_decoder = amqpvalue_decoder_create(decode_message_value_callback, message_receiver);
+    if (message_receiver->message_decoder == NULL)
+    {
+        LogError("Cannot create AMQP value decoder");
+        result = __FAILURE__;
+    }
+    else if (configure_message_decoder(message_receiver, message_receiver->message_decoder) != 0)
+    {
+        LogError("Cannot configure the AMQP value decoder");
+        amqpvalue_decoder_destroy(message_receiver->message_decoder);
+        message_receiver->message_decoder = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static AMQP_VALUE on_transfer_received(void* context, TRANSFER_HANDLE transfer, uint32_t payload_size, const unsigned char* payload_bytes)
+{
+    AMQP_VALUE result = NULL;
+    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
+
+    if (add_transfer_to_columnar_batch(message_receiver, payload_size, payload_bytes, &result))
+    {
+        /* laid out straight from the payload, no message is created */
+    }
+    else if (message_receiver->on_raw_message_received != NULL)
+    {
+        message_format message_format;
+        uint64_t start_ms;
+        CONNECTION_HANDLE timing_connection;
+
+        /* the payload is handed over as it came, a proxy forwarding it does not have to decode and encode it again */
+        if (transfer_get_message_format(transfer, &message_format) != 0)
+        {
+            /* the message-format field defaults to 0 */
+            message_format = 0;
+        }
+
+        timing_connection = begin_timed_callback(message_receiver->link, &start_ms);
+        result = message_receiver->on_raw_message_received(message_receiver->callback_context, message_format, payload_bytes, payload_size);
+        end_timed_callback(timing_connection, message_receiver->link, CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED, start_ms);
+    }
+    else if (message_receiver->on_message_received != NULL)
+    {
+        MESSAGE_HANDLE message;
+
+        if (message_receiver->recycled_message != NULL)
+        {
+            message = message_receiver->recycled_message;
+            message_receiver->recycled_message = NULL;
+        }
+        else
+        {
+            message = message_create();
+        }
+
+        if (message == NULL)
+        {
+            LogError("Cannot create message");
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+        }
+        else
+        {
+            if ((message_receiver->message_decoder == NULL) &&
+                (create_message_decoder(message_receiver) != 0))
+            {
+                LogError("Cannot create AMQP value decoder");
+                set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+            }
+            else
+            {
+                set_received_message_format(message, transfer);
+                message_receiver->decoded_message = message;
+                message_receiver->decode_error = false;
+                message_receiver->decoded_message_id = NULL;
+                message_receiver->is_duplicate_message = false;
+                message_receiver->is_decoded_body_encoded = false;
+                message_receiver->is_decoded_body_viewed = false;
+                if (decode_message(message_receiver, message_receiver->message_decoder, payload_size, payload_bytes) != 0)
+                {
+                    LogError("Cannot decode bytes");
+                    set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+                }
+                else
+                {
+                    if (message_receiver->decode_error)
+                    {
+                        LogError("Error decoding message");
+                        set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+                    }
+                    else if (message_receiver->is_duplicate_message)
+                    {
+                        result = messaging_delivery_accepted();
+                        if (result == NULL)
+                        {
+                            LogError("Cannot create the accepted state of a duplicate message");
+                        }
+                    }
+                    else if (deliver_message(message_receiver, message, &result))
+                    {
+                        message = NULL;
+                    }
+                    else
+                    {
+                        /* the message stays with the receiver */
+                    }
+                }
+
+                /* drops the last decoded value (which borrows from the payload) and any partial value left by an error */
+                (void)amqpvalue_decoder_reset(message_receiver->message_decoder);
+            }
+
+            if (message == NULL)
+            {
+                /* the application owns the message now */
+            }
+            else if (message_receiver->is_recycling_messages &&
+                (message_reset(message) == 0))
+            {
+                message_receiver->recycled_message = message;
+            }
+            else
+            {
+                message_destroy(message);
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Works out from the first bytes of a section the size of its header (descriptor, value constructor and value size)
+and of the whole section. header_size is left 0 when more bytes are needed. */
+static int get_section_layout(const unsigned char* bytes, size_t size, size_t* header_size, uint64_t* section_size, uint64_t* descriptor_code, unsigned char* value_constructor)
+{
+    int result;
+
+    *header_size = 0;
+
+    if (size < 2)
+    {
+        result = 0;
+    }
+    else if (bytes[0] != 0x00)
+    {
+        LogError("Message section is not a described value");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t descriptor_size;
+
+        switch (bytes[1])
+        {
+        default:
+            descriptor_size = 0;
+            break;
+        case 0x44:
+            descriptor_size = 1;
+            break;
+        case 0x53:
+            descriptor_size = 2;
+            break;
+        case 0x80:
+            descriptor_size = 9;
+            break;
+        }
+
+        if (descriptor_size == 0)
+        {
+            LogError("Message section does not have an ulong descriptor");
+            result = __FAILURE__;
+        }
+        else if (size < 1 + descriptor_size + 1)
+        {
+            result = 0;
+        }
+        else
+        {
+            size_t value_offset = 1 + descriptor_size;
+            size_t size_field_width = 0;
+            uint64_t value_size = 0;
+
+            result = 0;
+
+            switch (bytes[value_offset])
+            {
+            default:
+                LogError("Unsupported value constructor 0x%02x in a streamed message section", bytes[value_offset]);
+                result = __FAILURE__;
+                break;
+
+            case 0x40: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45:
+                break;
+            case 0x50: case 0x51: case 0x52: case 0x53: case 0x54: case 0x55: case 0x56:
+                value_size = 1;
+                break;
+            case 0x60: case 0x61:
+                value_size = 2;
+                break;
+            case 0x70: case 0x71: case 0x72: case 0x73:
+                value_size = 4;
+                break;
+            case 0x80: case 0x81: case 0x82: case 0x83:
+                value_size = 8;
+                break;
+            case 0x98:
+                value_size = 16;
+                break;
+            case 0xA0: case 0xA1: case 0xA3: case 0xC0: case 0xC1: case 0xE0:
+                size_field_width = 1;
+                break;
+            case 0xB0: case 0xB1: case 0xB3: case 0xD0: case 0xD1: case 0xF0:
+                size_field_width = 4;
+                break;
+            }
+
+            if ((result == 0) &&
+                (size >= value_offset + 1 + size_field_width))
+            {
+                size_t i;
+
+                for (i = 0; i < size_field_width; i++)
+                {
+                    value_size = (value_size << 8) | bytes[value_offset + 1 + i];
+                }
+
+                *descriptor_code = 0;
+                for (i = 2; i <= descriptor_size; i++)
+                {
+                    *descriptor_code = (*descriptor_code << 8) | bytes[i];
+                }
+
+                *value_constructor = bytes[value_offset];
+                *header_size = value_offset + 1 + size_field_width;
+                *section_size = *header_size + value_size;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void reset_streamed_section(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    if (message_receiver->section_bytes != NULL)
+    {
+        free(message_receiver->section_bytes);
+        message_receiver->section_bytes = NULL;
+    }
+
+    message_receiver->section_header_length = 0;
+    message_receiver->section_header_size = 0;
+    message_receiver->section_size = 0;
+    message_receiver->section_bytes_left = 0;
+}
+
+static void end_streamed_message(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    reset_streamed_section(message_receiver);
+
+    if (message_receiver->streamed_message_decoder != NULL)
+    {
+        amqpvalue_decoder_destroy(message_receiver->streamed_message_decoder);
+        message_receiver->streamed_message_decoder = NULL;
+    }
+
+    if (message_receiver->streamed_message != NULL)
+    {
+        message_destroy(message_receiver->streamed_message);
+        message_receiver->streamed_message = NULL;
+    }
+}
+
+static int start_streamed_section(MESSAGE_RECEIVER_INSTANCE* message_receiver, uint64_t descriptor_code, unsigned char value_constructor)
+{
+    int result;
+
+    if ((get_section_by_descriptor_code(descriptor_code) & message_receiver->decoded_sections) == 0)
+    {
+        /* sections that were not asked for are skipped without being buffered */
+        message_receiver->section_mode = STREAMED_SECTION_MODE_SKIP;
+        result = 0;
+    }
+    else if ((descriptor_code == 0x75) &&
+        ((value_constructor == 0xA0) || (value_constructor == 0xB0)))
+    {
+        /* body data is handed to the application as it arrives */
+        message_receiver->section_mode = STREAMED_SECTION_MODE_BODY_DATA;
+        result = 0;
+    }
+    else if (message_receiver->section_size > SIZE_MAX)
+    {
+        LogError("Message section too large");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->section_bytes = (unsigned char*)malloc((size_t)message_receiver->section_size);
+        if (message_receiver->section_bytes == NULL)
+        {
+            LogError("Cannot allocate memory for message section");
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memcpy(message_receiver->section_bytes, message_receiver->section_header, message_receiver->section_header_size);
+            message_receiver->section_mode = STREAMED_SECTION_MODE_BUFFER;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int end_streamed_section(MESSAGE_RECEIVER_INSTANCE* message_receiver)
+{
+    int result;
+
+    if ((message_receiver->section_mode == STREAMED_SECTION_MODE_BUFFER) &&
+        (amqpvalue_decode_bytes(message_receiver->streamed_message_decoder, message_receiver->section_bytes, (size_t)message_receiver->section_size) != 0))
+    {
+        LogError("Cannot decode message section");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    reset_streamed_section(message_receiver);
+
+    return result;
+}
+
+/* Feeds the bytes of one transfer frame to the message being streamed. Sections can span frames: body data
+is indicated as it arrives and every other section is buffered until it is complete and then decoded. */
+static int stream_message_bytes(MESSAGE_RECEIVER_INSTANCE* message_receiver, const unsigned char* bytes, size_t length)
+{
+    int result = 0;
+
+    while ((result == 0) && (length > 0))
+    {
+        size_t consumed;
+
+        if (message_receiver->section_header_size == 0)
+        {
+            size_t header_length = message_receiver->section_header_length;
+            size_t copy_length = MAX_SECTION_HEADER_SIZE - header_length;
+            uint64_t descriptor_code;
+            unsigned char value_constructor;
+
+            if (copy_length > length)
+            {
+                copy_length = length;
+            }
+
+            (void)memcpy(message_receiver->section_header + header_length, bytes, copy_length);
+            if (get_section_layout(message_receiver->section_header, header_length + copy_length, &message_receiver->section_header_size,
+                &message_receiver->section_size, &descriptor_code, &value_constructor) != 0)
+            {
+                LogError("Cannot get message section layout");
+                result = __FAILURE__;
+                consumed = 0;
+            }
+            else if (message_receiver->section_header_size == 0)
+            {
+                message_receiver->section_header_length += copy_length;
+                consumed = copy_length;
+            }
+            else
+            {
+                /* only the header bytes are consumed, what was copied past the header belongs to the section value */
+                consumed = message_receiver->section_header_size - header_length;
+                message_receiver->section_header_length = message_receiver->section_header_size;
+                message_receiver->section_bytes_left = message_receiver->section_size - message_receiver->section_header_size;
+
+                if (start_streamed_section(message_receiver, descriptor_code, value_constructor) != 0)
+                {
+                    LogError("Cannot start message section");
+                    result = __FAILURE__;
+                }
+                else if ((message_receiver->section_bytes_left == 0) &&
+                    (end_streamed_section(message_receiver) != 0))
+                {
+                    LogError("Cannot end message section");
+                    result = __FAILURE__;
+                }
+            }
+        }
+        else
+        {
+            consumed = (message_receiver->section_bytes_left < length) ? (size_t)message_receiver->section_bytes_left : length;
+
+            switch (message_receiver->section_mode)
+            {
+            default:
+                break;
+            case STREAMED_SECTION_MODE_BODY_DATA:
+                message_receiver->on_body_data_received(message_receiver->callback_context, message_receiver->streamed_message, bytes, consumed);
+                break;
+            case STREAMED_SECTION_MODE_BUFFER:
+                (void)memcpy(message_receiver->section_bytes + (size_t)(message_receiver->section_size - message_receiver->section_bytes_left), bytes, consumed);
+                break;
+            }
+
+            message_receiver->section_bytes_left -= consumed;
+            if ((message_receiver->section_bytes_left == 0) &&
+                (end_streamed_section(message_receiver) != 0))
+            {
+                LogError("Cannot end message section");
+                result = __FAILURE__;
+            }
+        }
+
+        bytes += consumed;
+        length -= consumed;
+    }
+
+    if ((result == 0) &&
+        message_receiver->decode_error)
+    {
+        LogError("Error decoding message");
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static int start_streamed_message(MESSAGE_RECEIVER_INSTANCE* message_receiver, TRANSFER_HANDLE transfer)
+{
+    int result;
+
+    message_receiver->streamed_message = message_create();
+    if (message_receiver->streamed_message == NULL)
+    {
+        LogError("Cannot create message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->streamed_message_decoder = amqpvalue_decoder_create(decode_message_value_callback, message_receiver);
+        if (message_receiver->streamed_message_decoder == NULL)
+        {
+            LogError("Cannot create AMQP value decoder");
+            end_streamed_message(message_receiver);
+            result = __FAILURE__;
+        }
+        /* sections are decoded from buffers that outlive the decoding */
+        else if (configure_message_decoder(message_receiver, message_receiver->streamed_message_decoder) != 0)
+        {
+            LogError("Cannot configure the AMQP value decoder");
+            end_streamed_message(message_receiver);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* the first transfer of a message carries its message format */
+            set_received_message_format(message_receiver->streamed_message, transfer);
+            message_receiver->decoded_message = message_receiver->streamed_message;
+            message_receiver->decode_error = false;
+            message_receiver->is_decoded_body_encoded = false;
+            message_receiver->is_decoded_body_viewed = false;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static AMQP_VALUE on_transfer_frame_received(void* context, TRANSFER_HANDLE transfer, bool more, uint32_t payload_size, const unsigned char* payload_bytes)
+{
+    AMQP_VALUE result = NULL;
+    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
+
+    if (message_receiver->is_discarding_streamed_message)
+    {
+        /* the rest of a message that could not be received */
+        message_receiver->is_discarding_streamed_message = more;
+    }
+    else if (message_receiver->on_message_received != NULL)
+    {
+        if ((message_receiver->streamed_message == NULL) &&
+            (start_streamed_message(message_receiver, transfer) != 0))
+        {
+            LogError("Cannot start receiving message");
+            message_receiver->is_discarding_streamed_message = more;
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+        }
+        else if (stream_message_bytes(message_receiver, payload_bytes, payload_size) != 0)
+        {
+            LogError("Cannot decode message bytes");
+            end_streamed_message(message_receiver);
+            message_receiver->is_discarding_streamed_message = more;
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+        }
+        else if (!more)
+        {
+            if (message_receiver->section_header_length > 0)
+            {
+                LogError("Message ended in the middle of a section");
+                set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+            }
+            else if (deliver_message(message_receiver, message_receiver->streamed_message, &result))
+            {
+                message_receiver->streamed_message = NULL;
+            }
+            else
+            {
+                /* the message stays with the receiver */
+            }
+
+            end_streamed_message(message_receiver);
+        }
+    }
+
+    return result;
+}
+
+static void on_link_state_changed(void* context, LINK_STATE new_link_state, LINK_STATE previous_link_state)
+{
+    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)context;
+    (void)previous_link_state;
+
+    /* the link drops the drain when it detaches, the messages pulled so far are handed over */
+    if ((new_link_state == LINK_STATE_DETACHED) || (new_link_state == LINK_STATE_ERROR))
+    {
+        complete_pending_batch(message_receiver, MESSAGE_RECEIVER_BATCH_RESULT_CANCELLED);
+    }
+
+    switch (new_link_state)
+    {
+    default:
+        break;
+
+    case LINK_STATE_ATTACHED:
+        if (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPENING)
+        {
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_OPEN);
+        }
+        break;
+    case LINK_STATE_DETACHED:
+        if ((message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPEN) ||
+            (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_CLOSING))
+        {
+            /* User initiated transition, we should be good */
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_IDLE);
+        }
+        else if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_IDLE)
+        {
+            /* Any other transition must be an error */
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+        }
+        break;
+    case LINK_STATE_ERROR:
+        if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_ERROR)
+        {
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+        }
+        break;
+    }
+}
+
+MESSAGE_RECEIVER_HANDLE messagereceiver_create(LINK_HANDLE link, ON_MESSAGE_RECEIVER_STATE_CHANGED on_message_receiver_state_changed, void* context)
+{
+    MESSAGE_RECEIVER_INSTANCE* message_receiver = (MESSAGE_RECEIVER_INSTANCE*)malloc(sizeof(MESSAGE_RECEIVER_INSTANCE));
+    if (message_receiver == NULL)
+    {
+        LogError("Error creating message receiver");
+    }
+    else
+    {
+        message_receiver->link = link;
+        message_receiver->on_message_receiver_state_changed = on_message_receiver_state_changed;
+        message_receiver->on_message_receiver_state_changed_context = context;
+        message_receiver->message_receiver_state = MESSAGE_RECEIVER_STATE_IDLE;
+        message_receiver->decoded_sections = MESSAGE_RECEIVER_SECTION_ALL;
+        message_receiver->section_decoder = NULL;
+        message_receiver->message_decoder = NULL;
+        message_receiver->batched_message_decoder = NULL;
+        message_receiver->decoder_max_depth = 0;
+        message_receiver->decoder_max_element_count = 0;
+        message_receiver->decoder_max_allocated_bytes = 0;
+        message_receiver->on_body_data_received = NULL;
+        message_receiver->on_raw_message_received = NULL;
+        message_receiver->streamed_message = NULL;
+        message_receiver->streamed_message_decoder = NULL;
+        message_receiver->is_discarding_streamed_message = false;
+        message_receiver->section_header_length = 0;
+        message_receiver->section_header_size = 0;
+        message_receiver->section_size = 0;
+        message_receiver->section_bytes_left = 0;
+        message_receiver->section_mode = STREAMED_SECTION_MODE_BUFFER;
+        message_receiver->section_bytes = NULL;
+        message_receiver->is_recycling_messages = false;
+        message_receiver->recycled_message = NULL;
+        message_receiver->delivered_message = NULL;
+        message_receiver->is_delivering_message = false;
+        message_receiver->on_batch_received = NULL;
+        message_receiver->on_batch_received_context = NULL;
+        message_receiver->batch_messages = NULL;
+        message_receiver->batch_message_ids = NULL;
+        message_receiver->batch_max_count = 0;
+        message_receiver->batch_count = 0;
+        message_receiver->columnar_batch = NULL;
+        message_receiver->on_columnar_batch_received = NULL;
+        message_receiver->on_columnar_batch_received_context = NULL;
+        message_receiver->received_message_ids = NULL;
+        message_receiver->max_received_message_ids = 0;
+        message_receiver->oldest_received_message_id = 0;
+        message_receiver->received_message_id_count = 0;
+        message_receiver->message_id_buckets = NULL;
+        message_receiver->message_id_bucket_count = 0;
+        message_receiver->duplicate_detection_window = 0;
+        message_receiver->duplicate_detection_tick_counter = NULL;
+        message_receiver->decoded_message_id = NULL;
+        message_receiver->is_duplicate_message = false;
+        message_receiver->on_message_dispatch = NULL;
+        message_receiver->on_message_dispatch_context = NULL;
+        message_receiver->max_dispatches_in_flight = 0;
+        message_receiver->dispatch_key_annotation = NULL;
+        message_receiver->on_body_decode = NULL;
+        message_receiver->on_body_decode_context = NULL;
+        message_receiver->body_content_encoding = NULL;
+        message_receiver->is_decoded_body_encoded = false;
+        message_receiver->on_body_view_received = NULL;
+        message_receiver->on_body_view_received_context = NULL;
+        message_receiver->body_content_type = NULL;
+        message_receiver->is_decoded_body_viewed = false;
+        message_receiver->first_waiting_dispatch = NULL;
+        message_receiver->last_waiting_dispatch = NULL;
+        message_receiver->waiting_dispatch_count = 0;
+        message_receiver->dispatches_in_flight = NULL;
+        message_receiver->dispatch_in_flight_count = 0;
+        lock_free_stack_init(&message_receiver->completed_dispatches);
+        message_receiver->is_dispatch_flow_paused = false;
+        message_receiver->receive_ring = NULL;
+        message_receiver->pulled_dispatch_count = 0;
+        message_receiver->is_ring_flow_paused = false;
+    }
+
+    return message_receiver;
+}
+
+void messagereceiver_destroy(MESSAGE_RECEIVER_HANDLE message_receiver)
+{
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+    }
+    else
+    {
+        (void)messagereceiver_close(message_receiver);
+        complete_pending_batch(message_receiver, MESSAGE_RECEIVER_BATCH_RESULT_CANCELLED);
+
+        end_streamed_message(message_receiver);
+        if (message_receiver->recycled_message != NULL)
+        {
+            message_destroy(message_receiver->recycled_message);
+        }
+
+        if (message_receiver->message_decoder != NULL)
+        {
+            amqpvalue_decoder_destroy(message_receiver->message_decoder);
+        }
+
+        if (message_receiver->batched_message_decoder != NULL)
+        {
+            amqpvalue_decoder_destroy(message_receiver->batched_message_decoder);
+        }
+
+        if (message_receiver->received_message_ids != NULL)
+        {
+            clear_received_message_ids(message_receiver);
+            free(message_receiver->received_message_ids);
+            free(message_receiver->message_id_buckets);
+        }
+
+        /* the messages still in flight were completed before, as messagereceiver_set_ordered_dispatch requires */
+        message_receiver->on_message_dispatch = NULL;
+        message_receiver->is_dispatch_flow_paused = false;
+        settle_completed_dispatches(message_receiver);
+        discard_waiting_dispatches(message_receiver);
+        if (message_receiver->receive_ring != NULL)
+        {
+            destroy_receive_ring(message_receiver);
+        }
+
+        if ((message_receiver->dispatch_in_flight_count > 0) ||
+            (message_receiver->pulled_dispatch_count > 0))
+        {
+            LogError("Message receiver destroyed with %u dispatched messages not completed",
+                (unsigned int)(message_receiver->dispatch_in_flight_count + message_receiver->pulled_dispatch_count));
+        }
+
+        if (message_receiver->dispatch_key_annotation != NULL)
+        {
+            free(message_receiver->dispatch_key_annotation);
+        }
+
+        if (message_receiver->body_content_encoding != NULL)
+        {
+            free(message_receiver->body_content_encoding);
+        }
+
+        if (message_receiver->body_content_type != NULL)
+        {
+            free(message_receiver->body_content_type);
+        }
+
+        free(message_receiver);
+    }
+}
+
+int messagereceiver_open(MESSAGE_RECEIVER_HANDLE message_receiver, ON_MESSAGE_RECEIVED on_message_received, void* callback_context)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_IDLE)
+        {
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_OPENING);
+            if (link_attach(message_receiver->link, on_transfer_received, on_link_state_changed, NULL, message_receiver) != 0)
+            {
+                LogError("Link attach failed");
+                result = __FAILURE__;
+                set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+            }
+            else
+            {
+                message_receiver->on_message_received = on_message_received;
+                message_receiver->callback_context = callback_context;
+
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_close(MESSAGE_RECEIVER_HANDLE message_receiver)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPENING) ||
+            (message_receiver->message_receiver_state == MESSAGE_RECEIVER_STATE_OPEN))
+        {
+            set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_CLOSING);
+
+            complete_pending_batch(message_receiver, MESSAGE_RECEIVER_BATCH_RESULT_CANCELLED);
+
+            if (link_detach(message_receiver->link, true) != 0)
+            {
+                LogError("link detach failed");
+                result = __FAILURE__;
+                set_message_receiver_state(message_receiver, MESSAGE_RECEIVER_STATE_ERROR);
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_get_link_name(MESSAGE_RECEIVER_HANDLE message_receiver, const char** link_name)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (link_get_name(message_receiver->link, link_name) != 0)
+        {
+            LogError("Getting link name failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_get_received_message_id(MESSAGE_RECEIVER_HANDLE message_receiver, delivery_number* message_id)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (link_get_received_message_id(message_receiver->link, message_id) != 0)
+        {
+            LogError("Failed getting received message Id");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_send_message_disposition(MESSAGE_RECEIVER_HANDLE message_receiver, const char* link_name, delivery_number message_number, AMQP_VALUE delivery_state)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_OPEN)
+        {
+            LogError("Message received not open");
+            result = __FAILURE__;
+        }
+        else
+        {
+            const char* my_name;
+            if (link_get_name(message_receiver->link, &my_name) != 0)
+            {
+                LogError("Failed getting link name");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (strcmp(link_name, my_name) != 0)
+                {
+                    LogError("Link name does not match");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    if (link_send_disposition(message_receiver->link, message_number, delivery_state) != 0)
+                    {
+                        LogError("Seding disposition failed");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void messagereceiver_set_trace(MESSAGE_RECEIVER_HANDLE message_receiver, bool trace_on)
+{
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+    }
+    else
+    {
+        /* No tracing is yet implemented for message receiver */
+        (void)trace_on;
+    }
+}
+
+int messagereceiver_set_decoded_sections(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t decoded_sections)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->decoded_sections = decoded_sections & MESSAGE_RECEIVER_SECTION_ALL;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_set_decoder_limits(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t max_depth, size_t max_element_count, size_t max_allocated_bytes)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->decoder_max_depth = max_depth;
+        message_receiver->decoder_max_element_count = max_element_count;
+        message_receiver->decoder_max_allocated_bytes = max_allocated_bytes;
+
+        /* decoders are created lazily, the ones that already exist get the new limits right away */
+        if (((message_receiver->message_decoder != NULL) &&
+             (set_message_decoder_limits(message_receiver, message_receiver->message_decoder) != 0)) ||
+            ((message_receiver->batched_message_decoder != NULL) &&
+             (set_message_decoder_limits(message_receiver, message_receiver->batched_message_decoder) != 0)) ||
+            ((message_receiver->streamed_message_decoder != NULL) &&
+             (set_message_decoder_limits(message_receiver, message_receiver->streamed_message_decoder) != 0)))
+        {
+            LogError("Cannot set the limits on the AMQP value decoders");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_set_disposition_batching(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t max_batch_size, tickcounter_ms_t max_delay)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    /* consecutive accepted messages are then settled with one disposition, sent once max_batch_size messages were accepted,
+    once max_delay ms passed since the first one or, with a max_delay of 0, on the next connection_dowork */
+    else if (link_set_disposition_batching(message_receiver->link, max_batch_size, max_delay) != 0)
+    {
+        LogError("Cannot set the disposition batching on the link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_set_prefetch(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t prefetch_count)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        (prefetch_count == 0))
+    {
+        LogError("Bad arguments: message_receiver = %p, prefetch_count = %u",
+            message_receiver, (unsigned int)prefetch_count);
+        result = __FAILURE__;
+    }
+    /* the prefetch count is the link credit, an open receiver sends it to the peer right away */
+    else if (link_set_max_link_credit(message_receiver->link, prefetch_count) != 0)
+    {
+        LogError("Cannot set the link credit");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_set_max_buffered_bytes(MESSAGE_RECEIVER_HANDLE message_receiver, uint64_t max_buffered_bytes, uint64_t resume_buffered_bytes)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    /* messages settled from on_message_received free their bytes right away, the budget bounds the ones the application keeps */
+    else if (link_set_max_buffered_bytes(message_receiver->link, max_buffered_bytes, resume_buffered_bytes) != 0)
+    {
+        LogError("Cannot set the max buffered bytes on the link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_pause(MESSAGE_RECEIVER_HANDLE message_receiver)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else if (link_pause_flow(message_receiver->link) != 0)
+    {
+        LogError("Cannot pause the link flow");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_resume(MESSAGE_RECEIVER_HANDLE message_receiver)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else if (link_resume_flow(message_receiver->link) != 0)
+    {
+        LogError("Cannot resume the link flow");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_set_message_recycling(MESSAGE_RECEIVER_HANDLE message_receiver, bool recycle_messages)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->is_recycling_messages = recycle_messages;
+        if (!recycle_messages &&
+            (message_receiver->recycled_message != NULL))
+        {
+            message_destroy(message_receiver->recycled_message);
+            message_receiver->recycled_message = NULL;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_take_message(MESSAGE_RECEIVER_HANDLE message_receiver, MESSAGE_HANDLE message)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        (message == NULL))
+    {
+        LogError("Bad arguments: message_receiver = %p, message = %p",
+            message_receiver, message);
+        result = __FAILURE__;
+    }
+    else if ((!message_receiver->is_delivering_message) ||
+        (message_receiver->delivered_message != message))
+    {
+        LogError("Only the message being handed to on_message_received can be taken, and only once");
+        result = __FAILURE__;
+    }
+    /* the taken message outlives the payload its body data sections were borrowed from */
+    else if (message_own_body_amqp_data(message) != 0)
+    {
+        LogError("Cannot copy the body of the taken message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the receiver does not destroy or recycle the message once the callback returns */
+        message_receiver->delivered_message = NULL;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_get_batched_message_count(MESSAGE_HANDLE batch_message, size_t* count)
+{
+    int result;
+    uint32_t batch_message_format;
+
+    if ((batch_message == NULL) ||
+        (count == NULL))
+    {
+        LogError("Bad arguments: batch_message = %p, count = %p",
+            batch_message, count);
+        result = __FAILURE__;
+    }
+    else if ((message_get_message_format(batch_message, &batch_message_format) != 0) ||
+        (batch_message_format != AMQP_BATCHED_MESSAGE_FORMAT))
+    {
+        LogError("Not a batched message");
+        result = __FAILURE__;
+    }
+    else if (message_get_body_amqp_data_count(batch_message, count) != 0)
+    {
+        LogError("Cannot get the number of data sections of the batch");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+MESSAGE_HANDLE messagereceiver_decode_batched_message(MESSAGE_RECEIVER_HANDLE message_receiver, MESSAGE_HANDLE batch_message, size_t index)
+{
+    MESSAGE_HANDLE result;
+    BINARY_DATA encoded_message;
+
+    if ((message_receiver == NULL) ||
+        (batch_message == NULL))
+    {
+        LogError("Bad arguments: message_receiver = %p, batch_message = %p",
+            message_receiver, batch_message);
+        result = NULL;
+    }
+    else if (message_get_body_amqp_data_in_place(batch_message, index, &encoded_message) != 0)
+    {
+        LogError("Cannot get data section %u of the batch", (unsigned int)index);
+        result = NULL;
+    }
+    else if ((message_receiver->batched_message_decoder == NULL) &&
+        (((message_receiver->batched_message_decoder = amqpvalue_decoder_create(decode_message_value_callback, message_receiver)) == NULL) ||
+         /* the inner sections are decoded from the bytes of the batch, which outlive the decoding */
+         (configure_message_decoder(message_receiver, message_receiver->batched_message_decoder) != 0)))
+    {
+        LogError("Cannot create the AMQP value decoder for batched messages");
+        if (message_receiver->batched_message_decoder != NULL)
+        {
+            amqpvalue_decoder_destroy(message_receiver->batched_message_decoder);
+            message_receiver->batched_message_decoder = NULL;
+        }
+
+        result = NULL;
+    }
+    else if ((result = message_create()) == NULL)
+    {
+        LogError("Cannot create the batched message");
+    }
+    else
+    {
+        /* this can be called from on_message_received, while the state of the batch's own decoding is still around */
+        MESSAGE_HANDLE saved_decoded_message = message_receiver->decoded_message;
+        bool saved_decode_error = message_receiver->decode_error;
+        AMQP_VALUE saved_decoded_message_id = message_receiver->decoded_message_id;
+        bool saved_is_decoded_body_encoded = message_receiver->is_decoded_body_encoded;
+        bool saved_is_decoded_body_viewed = message_receiver->is_decoded_body_viewed;
+
+        message_receiver->decoded_message = result;
+        message_receiver->decode_error = false;
+        message_receiver->is_decoded_body_encoded = false;
+
+        if ((amqpvalue_decode_bytes(message_receiver->batched_message_decoder, encoded_message.bytes, encoded_message.length) != 0) ||
+            (message_receiver->decode_error))
+        {
+            LogError("Cannot decode batched message %u", (unsigned int)index);
+            message_destroy(result);
+            result = NULL;
+        }
+
+        /* drops the last decoded value, which borrows from the batch */
+        (void)amqpvalue_decoder_reset(message_receiver->batched_message_decoder);
+
+        message_receiver->decoded_message = saved_decoded_message;
+        message_receiver->decode_error = saved_decode_error;
+        message_receiver->decoded_message_id = saved_decoded_message_id;
+        message_receiver->is_decoded_body_encoded = saved_is_decoded_body_encoded;
+        message_receiver->is_decoded_body_viewed = saved_is_decoded_body_viewed;
+    }
+
+    return result;
+}
+
+int messagereceiver_set_on_raw_message_received(MESSAGE_RECEIVER_HANDLE message_receiver, ON_RAW_MESSAGE_RECEIVED on_raw_message_received)
+{
+    int result;
+
+    if (message_receiver == NULL)
+    {
+        LogError("NULL message_receiver");
+        result = __FAILURE__;
+    }
+    else if ((on_raw_message_received != NULL) &&
+        (message_receiver->on_body_data_received != NULL))
+    {
+        LogError("Raw messages cannot be received while bodies are streamed");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->on_raw_message_received = on_raw_message_received;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_set_on_body_data_received(MESSAGE_RECEIVER_HANDLE message_receiver, ON_MESSAGE_BODY_DATA_RECEIVED on_body_data_received)
+{
+    int result;
+
+    if (message_receiver == NULL)
     {
         LogError("NULL message_receiver");
         result = __FAILURE__;
     }
+    else if ((on_body_data_received != NULL) &&
+        (message_receiver->on_raw_message_received != NULL))
+    {
+        LogError("Bodies cannot be streamed while raw messages are received");
+        result = __FAILURE__;
+    }
+    else if (link_set_on_transfer_frame_received(message_receiver->link, (on_body_data_received == NULL) ? NULL : on_transfer_frame_received) != 0)
+    {
+        LogError("Cannot set how the link indicates transfers");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->on_body_data_received = on_body_data_received;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_receive_batch_async(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t max_count, tickcounter_ms_t timeout, ON_MESSAGE_BATCH_RECEIVED on_batch_received, void* context)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        (max_count == 0) ||
+        (on_batch_received == NULL))
+    {
+        LogError("Bad arguments: message_receiver = %p, max_count = %u, on_batch_received = %p",
+            message_receiver, (unsigned int)max_count, on_batch_received);
+        result = __FAILURE__;
+    }
+    else if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_OPEN)
+    {
+        LogError("Message receiver not open");
+        result = __FAILURE__;
+    }
+    else if ((message_receiver->on_batch_received != NULL) ||
+        (message_receiver->on_columnar_batch_received != NULL))
+    {
+        LogError("A batch is already being received");
+        result = __FAILURE__;
+    }
+    else if (max_count > SIZE_MAX / sizeof(MESSAGE_HANDLE))
+    {
+        LogError("Batch too large: max_count = %u", (unsigned int)max_count);
+        result = __FAILURE__;
+    }
+    else if ((message_receiver->batch_messages = (MESSAGE_HANDLE*)malloc(sizeof(MESSAGE_HANDLE) * max_count)) == NULL)
+    {
+        LogError("Cannot allocate the batch messages");
+        result = __FAILURE__;
+    }
+    else if ((message_receiver->batch_message_ids = (delivery_number*)malloc(sizeof(delivery_number) * max_count)) == NULL)
+    {
+        LogError("Cannot allocate the batch message ids");
+        free(message_receiver->batch_messages);
+        message_receiver->batch_messages = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_receiver->batch_max_count = max_count;
+        message_receiver->batch_count = 0;
+        message_receiver->on_batch_received_context = context;
+        message_receiver->on_batch_received = on_batch_received;
+
+        /* the drain keeps the credit to exactly what the batch can take, none is left idle with the sender afterwards */
+        if (link_drain(message_receiver->link, max_count, timeout, on_link_drained, message_receiver) != 0)
+        {
+            LogError("Cannot drain the link");
+            message_receiver->on_batch_received = NULL;
+            free(message_receiver->batch_messages);
+            message_receiver->batch_messages = NULL;
+            free(message_receiver->batch_message_ids);
+            message_receiver->batch_message_ids = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_receive_columnar_batch_async(MESSAGE_RECEIVER_HANDLE message_receiver, COLUMNAR_BATCH_HANDLE batch, tickcounter_ms_t timeout, ON_COLUMNAR_BATCH_RECEIVED on_columnar_batch_received, void* context)
+{
+    int result;
+    uint32_t max_row_count;
+
+    if ((message_receiver == NULL) ||
+        (batch == NULL) ||
+        (on_columnar_batch_received == NULL))
+    {
+        LogError("Bad arguments: message_receiver = %p, batch = %p, on_columnar_batch_received = %p",
+            message_receiver, batch, on_columnar_batch_received);
+        result = __FAILURE__;
+    }
+    else if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_OPEN)
+    {
+        LogError("Message receiver not open");
+        result = __FAILURE__;
+    }
+    else if ((message_receiver->on_batch_received != NULL) ||
+        (message_receiver->on_columnar_batch_received != NULL))
+    {
+        LogError("A batch is already being received");
+        result = __FAILURE__;
+    }
+    else if (message_receiver->on_body_data_received != NULL)
+    {
+        /* a streamed message never comes as one payload that could be laid out */
+        LogError("Columnar batches cannot be received while bodies are streamed");
+        result = __FAILURE__;
+    }
+    else if (columnar_batch_get_max_row_count(batch, &max_row_count) != 0)
+    {
+        LogError("Cannot get the number of rows of the columnar batch");
+        result = __FAILURE__;
+    }
     else
     {
-        if (link_get_received_message_id(message_receiver->link, message_id) != 0)
+        columnar_batch_clear(batch);
+        message_receiver->columnar_batch = batch;
+        message_receiver->on_columnar_batch_received_context = context;
+        message_receiver->on_columnar_batch_received = on_columnar_batch_received;
+
+        /* the credit is exactly the rows of the batch, as for messagereceiver_receive_batch_async */
+        if (link_drain(message_receiver->link, max_row_count, timeout, on_link_drained, message_receiver) != 0)
         {
-            LogError("Failed getting received message Id");
+            LogError("Cannot drain the link");
+            message_receiver->on_columnar_batch_received = NULL;
+            message_receiver->columnar_batch = NULL;
             result = __FAILURE__;
         }
         else
@@ -466,57 +2832,399 @@ int messagereceiver_get_received_message_id(MESSAGE_RECEIVER_HANDLE message_rece
     return result;
 }
 
-int messagereceiver_send_message_disposition(MESSAGE_RECEIVER_HANDLE message_receiver, const char* link_name, delivery_number message_number, AMQP_VALUE delivery_state)
+int messagereceiver_set_duplicate_detection(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t max_message_ids, tickcounter_ms_t window, TICK_COUNTER_HANDLE tick_counter)
 {
     int result;
 
-    if (message_receiver == NULL)
+    if ((message_receiver == NULL) ||
+        ((max_message_ids > 0) && (window > 0) && (tick_counter == NULL)) ||
+        (max_message_ids > (UINT32_MAX / 2) + 1))
     {
-        LogError("NULL message_receiver");
+        LogError("Bad arguments: message_receiver = %p, max_message_ids = %u, tick_counter = %p",
+            message_receiver, (unsigned int)max_message_ids, tick_counter);
         result = __FAILURE__;
     }
     else
     {
-        if (message_receiver->message_receiver_state != MESSAGE_RECEIVER_STATE_OPEN)
+        RECEIVED_MESSAGE_ID* received_message_ids = NULL;
+        uint32_t* message_id_buckets = NULL;
+        uint32_t bucket_count = 1;
+
+        /* at least as many buckets as entries keeps the chains short */
+        while (bucket_count < max_message_ids)
         {
-            LogError("Message received not open");
+            bucket_count *= 2;
+        }
+
+        if ((max_message_ids > 0) &&
+            (((received_message_ids = (RECEIVED_MESSAGE_ID*)malloc(sizeof(RECEIVED_MESSAGE_ID) * max_message_ids)) == NULL) ||
+            ((message_id_buckets = (uint32_t*)calloc(bucket_count, sizeof(uint32_t))) == NULL)))
+        {
+            LogError("Cannot allocate the duplicate detection cache");
+            free(received_message_ids);
             result = __FAILURE__;
         }
         else
         {
-            const char* my_name;
-            if (link_get_name(message_receiver->link, &my_name) != 0)
+            /* the message-ids remembered so far are forgotten */
+            if (message_receiver->received_message_ids != NULL)
             {
-                LogError("Failed getting link name");
-                result = __FAILURE__;
+                clear_received_message_ids(message_receiver);
+                free(message_receiver->received_message_ids);
+                free(message_receiver->message_id_buckets);
             }
-            else
+
+            message_receiver->received_message_ids = received_message_ids;
+            message_receiver->message_id_buckets = message_id_buckets;
+            message_receiver->message_id_bucket_count = bucket_count;
+            message_receiver->max_received_message_ids = max_message_ids;
+            message_receiver->oldest_received_message_id = 0;
+            message_receiver->received_message_id_count = 0;
+            message_receiver->duplicate_detection_window = window;
+            message_receiver->duplicate_detection_tick_counter = tick_counter;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_set_body_decoding(MESSAGE_RECEIVER_HANDLE message_receiver, const char* content_encoding, ON_MESSAGE_BODY_DECODE on_body_decode, void* context)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        ((content_encoding == NULL) != (on_body_decode == NULL)))
+    {
+        LogError("Bad arguments: message_receiver = %p, content_encoding = %p, on_body_decode = %p",
+            message_receiver, content_encoding, on_body_decode);
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* copied_content_encoding = NULL;
+
+        if ((content_encoding != NULL) &&
+            (mallocAndStrcpy_s(&copied_content_encoding, content_encoding) != 0))
+        {
+            LogError("Cannot copy the content encoding");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message_receiver->body_content_encoding != NULL)
             {
-                if (strcmp(link_name, my_name) != 0)
-                {
-                    LogError("Link name does not match");
-                    result = __FAILURE__;
-                }
-                else
+                free(message_receiver->body_content_encoding);
+            }
+
+            message_receiver->on_body_decode = on_body_decode;
+            message_receiver->on_body_decode_context = context;
+            message_receiver->body_content_encoding = copied_content_encoding;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_set_body_codec(MESSAGE_RECEIVER_HANDLE message_receiver, const char* content_type, ON_MESSAGE_BODY_VIEW_RECEIVED on_body_view_received, void* context)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        ((content_type == NULL) != (on_body_view_received == NULL)))
+    {
+        LogError("Bad arguments: message_receiver = %p, content_type = %p, on_body_view_received = %p",
+            message_receiver, content_type, on_body_view_received);
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* copied_content_type = NULL;
+
+        if ((content_type != NULL) &&
+            (mallocAndStrcpy_s(&copied_content_type, content_type) != 0))
+        {
+            LogError("Cannot copy the content type");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message_receiver->body_content_type != NULL)
+            {
+                free(message_receiver->body_content_type);
+            }
+
+            message_receiver->on_body_view_received = on_body_view_received;
+            message_receiver->on_body_view_received_context = context;
+            message_receiver->body_content_type = copied_content_type;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_set_ordered_dispatch(MESSAGE_RECEIVER_HANDLE message_receiver, ON_MESSAGE_DISPATCH on_message_dispatch, void* context, uint32_t max_in_flight, const char* key_annotation)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        ((on_message_dispatch != NULL) && (max_in_flight == 0)))
+    {
+        LogError("Bad arguments: message_receiver = %p, on_message_dispatch = %p, max_in_flight = %u",
+            message_receiver, on_message_dispatch, (unsigned int)max_in_flight);
+        result = __FAILURE__;
+    }
+    else if ((message_receiver->waiting_dispatch_count > 0) ||
+        (message_receiver->dispatch_in_flight_count > 0))
+    {
+        LogError("Cannot change the dispatch while %u dispatched messages are not completed",
+            (unsigned int)(message_receiver->waiting_dispatch_count + message_receiver->dispatch_in_flight_count));
+        result = __FAILURE__;
+    }
+    else if ((on_message_dispatch != NULL) &&
+        (message_receiver->receive_ring != NULL))
+    {
+        LogError("Cannot dispatch the received messages while they are pulled from the receive ring");
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* copied_key_annotation = NULL;
+
+        if ((key_annotation != NULL) &&
+            (mallocAndStrcpy_s(&copied_key_annotation, key_annotation) != 0))
+        {
+            LogError("Cannot copy the key annotation name");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message_receiver->dispatch_key_annotation != NULL)
+            {
+                free(message_receiver->dispatch_key_annotation);
+            }
+
+            message_receiver->on_message_dispatch = on_message_dispatch;
+            message_receiver->on_message_dispatch_context = context;
+            message_receiver->max_dispatches_in_flight = max_in_flight;
+            message_receiver->dispatch_key_annotation = copied_key_annotation;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_set_receive_ring(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t capacity)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        (capacity > 0x80000000))
+    {
+        LogError("Bad arguments: message_receiver = %p, capacity = %u", message_receiver, (unsigned int)capacity);
+        result = __FAILURE__;
+    }
+    else if (message_receiver->pulled_dispatch_count > 0)
+    {
+        LogError("Cannot change the receive ring while %u pulled messages are not completed", (unsigned int)message_receiver->pulled_dispatch_count);
+        result = __FAILURE__;
+    }
+    else if ((capacity > 0) &&
+        (message_receiver->on_message_dispatch != NULL))
+    {
+        LogError("Cannot pull the received messages while they are dispatched");
+        result = __FAILURE__;
+    }
+    else
+    {
+        RECEIVE_RING* receive_ring = NULL;
+        uint32_t ring_capacity = 1;
+
+        while (ring_capacity < capacity)
+        {
+            ring_capacity *= 2;
+        }
+
+        if ((capacity > 0) &&
+            ((receive_ring = (RECEIVE_RING*)malloc(sizeof(RECEIVE_RING) + (ring_capacity * sizeof(MESSAGE_DISPATCH_INSTANCE*)))) == NULL))
+        {
+            LogError("Cannot allocate the receive ring");
+            result = __FAILURE__;
+        }
+        else if ((receive_ring != NULL) &&
+            ((receive_ring->lock = Lock_Init()) == NULL))
+        {
+            LogError("Cannot create the lock of the receive ring");
+            free(receive_ring);
+            result = __FAILURE__;
+        }
+        else if ((receive_ring != NULL) &&
+            ((receive_ring->condition = Condition_Init()) == NULL))
+        {
+            LogError("Cannot create the condition of the receive ring");
+            (void)Lock_Deinit(receive_ring->lock);
+            free(receive_ring);
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (receive_ring != NULL)
+            {
+                receive_ring->head = 0;
+                receive_ring->tail = 0;
+                receive_ring->is_consumer_waiting = 0;
+                receive_ring->capacity = ring_capacity;
+                receive_ring->entries = (MESSAGE_DISPATCH_INSTANCE**)(receive_ring + 1);
+            }
+
+            if (message_receiver->receive_ring != NULL)
+            {
+                destroy_receive_ring(message_receiver);
+            }
+
+            if (message_receiver->is_ring_flow_paused)
+            {
+                if (link_resume_flow(message_receiver->link) != 0)
                 {
-                    if (link_send_disposition(message_receiver->link, message_number, delivery_state) != 0)
-                    {
-                        LogError("Seding disposition failed");
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        result = 0;
-                    }
+                    LogError("Cannot resume the link flow paused by the receive ring");
                 }
+
+                message_receiver->is_ring_flow_paused = false;
             }
+
+            message_receiver->receive_ring = receive_ring;
+            result = 0;
         }
     }
 
     return result;
 }
 
-void messagereceiver_set_trace(MESSAGE_RECEIVER_HANDLE message_receiver, bool trace_on)
+int messagereceiver_try_receive(MESSAGE_RECEIVER_HANDLE message_receiver, MESSAGE_DISPATCH_HANDLE* dispatch, MESSAGE_HANDLE* message)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        (dispatch == NULL) ||
+        (message == NULL))
+    {
+        LogError("Bad arguments: message_receiver = %p, dispatch = %p, message = %p",
+            message_receiver, dispatch, message);
+        result = __FAILURE__;
+    }
+    else if (message_receiver->receive_ring == NULL)
+    {
+        LogError("The received messages are not pulled");
+        result = __FAILURE__;
+    }
+    else
+    {
+        MESSAGE_DISPATCH_INSTANCE* received = take_from_receive_ring(message_receiver->receive_ring);
+
+        *dispatch = received;
+        *message = (received == NULL) ? NULL : received->message;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagereceiver_receive_wait(MESSAGE_RECEIVER_HANDLE message_receiver, uint32_t timeout, MESSAGE_DISPATCH_HANDLE* dispatch, MESSAGE_HANDLE* message)
+{
+    int result;
+
+    if ((message_receiver == NULL) ||
+        (timeout > INT32_MAX) ||
+        (dispatch == NULL) ||
+        (message == NULL))
+    {
+        LogError("Bad arguments: message_receiver = %p, timeout = %u, dispatch = %p, message = %p",
+            message_receiver, (unsigned int)timeout, dispatch, message);
+        result = __FAILURE__;
+    }
+    else if (message_receiver->receive_ring == NULL)
+    {
+        LogError("The received messages are not pulled");
+        result = __FAILURE__;
+    }
+    else
+    {
+        RECEIVE_RING* receive_ring = message_receiver->receive_ring;
+        MESSAGE_DISPATCH_INSTANCE* received = take_from_receive_ring(receive_ring);
+
+        if (received != NULL)
+        {
+            result = 0;
+        }
+        else if (Lock(receive_ring->lock) != LOCK_OK)
+        {
+            LogError("Cannot lock the receive ring");
+            result = __FAILURE__;
+        }
+        else
+        {
+            ATOMIC_STORE_RELEASE_UINT32(&receive_ring->is_consumer_waiting, 1);
+            /* pairs with the fence of push_to_receive_ring */
+            ATOMIC_FULL_FENCE();
+
+            /* the producer posts under the lock, which the wait only gives up once it waits */
+            if (((received = take_from_receive_ring(receive_ring)) == NULL) &&
+                (Condition_Wait(receive_ring->condition, receive_ring->lock, (int)timeout) == COND_ERROR))
+            {
+                LogError("Cannot wait on the receive ring");
+            }
+
+            ATOMIC_STORE_RELEASE_UINT32(&receive_ring->is_consumer_waiting, 0);
+            (void)Unlock(receive_ring->lock);
+
+            if (received == NULL)
+            {
+                received = take_from_receive_ring(receive_ring);
+            }
+
+            result = 0;
+        }
+
+        if (result == 0)
+        {
+            *dispatch = received;
+            *message = (received == NULL) ? NULL : received->message;
+        }
+    }
+
+    return result;
+}
+
+int messagereceiver_complete_dispatch(MESSAGE_DISPATCH_HANDLE dispatch, AMQP_VALUE delivery_state)
+{
+    int result;
+
+    if ((dispatch == NULL) ||
+        (delivery_state == NULL))
+    {
+        LogError("Bad arguments: dispatch = %p, delivery_state = %p",
+            dispatch, delivery_state);
+        result = __FAILURE__;
+    }
+    else
+    {
+        MESSAGE_RECEIVER_INSTANCE* message_receiver = dispatch->message_receiver;
+
+        /* the dispatch is only touched again by messagereceiver_dowork, which settles it */
+        dispatch->delivery_state = delivery_state;
+
+        lock_free_stack_push(&message_receiver->completed_dispatches, &dispatch->completed_entry);
+
+        result = 0;
+    }
+
+    return result;
+}
+
+void messagereceiver_dowork(MESSAGE_RECEIVER_HANDLE message_receiver)
 {
     if (message_receiver == NULL)
     {
@@ -524,7 +3232,12 @@ void messagereceiver_set_trace(MESSAGE_RECEIVER_HANDLE message_receiver, bool tr
     }
     else
     {
-        /* No tracing is yet implemented for message receiver */
-        (void)trace_on;
+        settle_completed_dispatches(message_receiver);
+        if (message_receiver->receive_ring != NULL)
+        {
+            resume_ring_flow(message_receiver);
+        }
+
+        link_dowork(message_receiver->link);
     }
 }
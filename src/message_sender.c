@@ -8,12 +8,40 @@
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/refcount.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_uamqp_c/link.h"
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/message_sender.h"
 #include "azure_uamqp_c/amqpvalue_to_string.h"
 #include "azure_uamqp_c/async_operation.h"
+#include "azure_uamqp_c/lock_free_stack.h"
 #include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/uamqp_tracepoints.h"
+#include "azure_uamqp_c/uamqp_static_pools.h"
+
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_MESSAGE_SENDER
+#include "azure_uamqp_c/alloc_counters.h"
+
+/* streamed bodies are read in pieces of at most this size, each sent as one data section */
+#define STREAMED_BODY_PIECE_SIZE (64 * 1024)
+/* parts of streamed bodies the I/O is not done with yet, no further piece is read until one of them completes */
+#define STREAMED_BODY_MAX_PARTS_IN_FLIGHT 2
+/* a data section header is a vbin8 or vbin32 constructor after the descriptor, 8 bytes at most */
+#define DATA_SECTION_HEADER_MAX_SIZE 8
+/* AMQP header priorities, a message without a header or a priority has the default one */
+#define MESSAGE_PRIORITY_COUNT 10
+#define DEFAULT_MESSAGE_PRIORITY 4
+/* the adaptive batching controller adjusts at most this often, a shorter latency target is still sampled over this period */
+#define ADAPTIVE_BATCHING_MIN_PERIOD_MS 10
+/* outgoing batch sizes the controller grows from and shrinks to before turning batching off */
+#define ADAPTIVE_BATCHING_MIN_BATCH_SIZE 4096
+#ifdef UAMQP_STATIC_POOLS
+#define SEND_OPERATION_POOL_SIZE UAMQP_STATIC_MAX_PENDING_DELIVERIES
+#else
+#define SEND_OPERATION_POOL_SIZE 256
+#endif
 
 typedef enum MESSAGE_SEND_STATE_TAG
 {
@@ -28,33 +56,253 @@ typedef enum SEND_ONE_MESSAGE_RESULT_TAG
     SEND_ONE_MESSAGE_BUSY
 } SEND_ONE_MESSAGE_RESULT;
 
+/* a message encoded once, shared by every send of it */
+typedef struct ENCODED_MESSAGE_INSTANCE_TAG
+{
+    unsigned char* bytes;
+    size_t length;
+    message_format message_format;
+    /* the header priority, kept for senders that send in priority order */
+    unsigned char priority;
+    /* kept for senders that expire queued sends, 0 when the message has no ttl or absolute expiry time */
+    milliseconds ttl;
+    timestamp absolute_expiry_time;
+} ENCODED_MESSAGE_INSTANCE;
+
+DEFINE_REFCOUNT_TYPE(ENCODED_MESSAGE_INSTANCE);
+
+/* the sections of a message template, in the order they are encoded */
+#define MESSAGE_TEMPLATE_SECTION_HEADER                 0
+#define MESSAGE_TEMPLATE_SECTION_MESSAGE_ANNOTATIONS    1
+#define MESSAGE_TEMPLATE_SECTION_PROPERTIES             2
+#define MESSAGE_TEMPLATE_SECTION_APPLICATION_PROPERTIES 3
+#define MESSAGE_TEMPLATE_SECTION_COUNT                  4
+
+/* constant sections encoded once, sent in place by every send from the template */
+typedef struct MESSAGE_TEMPLATE_INSTANCE_TAG
+{
+    unsigned char* bytes;
+    /* a length of 0 when the template does not have the section */
+    size_t section_offsets[MESSAGE_TEMPLATE_SECTION_COUNT];
+    size_t section_lengths[MESSAGE_TEMPLATE_SECTION_COUNT];
+} MESSAGE_TEMPLATE_INSTANCE;
+
+DEFINE_REFCOUNT_TYPE(MESSAGE_TEMPLATE_INSTANCE);
+
 typedef struct MESSAGE_WITH_CALLBACK_TAG
 {
     MESSAGE_HANDLE message;
+    ENCODED_MESSAGE_HANDLE encoded_message;
+    /* the sections message does not have are sent from the template */
+    MESSAGE_TEMPLATE_HANDLE message_template;
     ON_MESSAGE_SEND_COMPLETE on_message_send_complete;
     void* context;
     MESSAGE_SENDER_HANDLE message_sender;
     MESSAGE_SEND_STATE message_send_state;
     tickcounter_ms_t timeout;
+    /* set for a send whose body is read piece by piece while its transfer is in progress */
+    ON_MESSAGE_BODY_READ on_message_body_read;
+    void* body_read_context;
+    /* set for a send whose body is serialized by the body codec of the sender when it is encoded */
+    const void* body_object;
+    /* link delivery of a streamed send, kept until it settles so that cancelling the send aborts it */
+    ASYNC_OPERATION_HANDLE streamed_delivery;
+    unsigned int is_body_read_failed : 1;
+    unsigned int is_send_cancelled : 1;
+    /* set when the expiry timer fired after the send was transferred, a send kept on link loss is then not sent again */
+    unsigned int is_expired : 1;
+    TIMER_WHEEL_TIMER_HANDLE expiry_timer;
+    /* only read when the sender sends in priority order */
+    unsigned char priority;
+    /* tag of the last transfer, a sender resuming on link loss asks the peer about it when reattaching */
+    unsigned char delivery_tag_bytes[LINK_MAX_DELIVERY_TAG_LENGTH];
+    uint32_t delivery_tag_length;
+    /* pending sends are linked through their contexts so that enqueueing and settling are O(1) */
+    ASYNC_OPERATION_HANDLE previous;
+    ASYNC_OPERATION_HANDLE next;
 } MESSAGE_WITH_CALLBACK;
 
 DEFINE_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK);
 
+/* a send submitted by messagesender_send_async_threadsafe, waiting for messagesender_dowork */
+typedef struct THREADSAFE_SEND_TAG
+{
+    /* first member, so that the stack entries are the sends */
+    LOCK_FREE_STACK_ENTRY stack_entry;
+    MESSAGE_HANDLE message;
+    ON_MESSAGE_SEND_COMPLETE on_message_send_complete;
+    void* callback_context;
+    tickcounter_ms_t timeout;
+} THREADSAFE_SEND;
+
+/* shared by a sender and the streamed parts it has in flight, since the I/O may complete them after the sender is destroyed */
+typedef struct STREAMED_PARTS_TAG
+{
+    struct MESSAGE_SENDER_INSTANCE_TAG* message_sender;
+    size_t parts_in_flight;
+} STREAMED_PARTS;
+
+DEFINE_REFCOUNT_TYPE(STREAMED_PARTS);
+
 typedef struct MESSAGE_SENDER_INSTANCE_TAG
 {
     LINK_HANDLE link;
     size_t message_count;
-    ASYNC_OPERATION_HANDLE* messages;
+    ASYNC_OPERATION_HANDLE first_message;
+    ASYNC_OPERATION_HANDLE last_message;
     MESSAGE_SENDER_STATE message_sender_state;
     ON_MESSAGE_SENDER_STATE_CHANGED on_message_sender_state_changed;
     void* on_message_sender_state_changed_context;
+    /* 0 means the number of pending sends is not limited */
+    size_t max_in_flight;
+    /* 0 means crossing a queue depth is not reported */
+    size_t queue_depth_threshold;
+    ON_MESSAGE_SENDER_READY on_message_sender_ready;
+    void* on_message_sender_ready_context;
+    ON_MESSAGE_SEND_COMPLETE_BATCH on_message_send_complete_batch;
+    void* on_message_send_complete_batch_context;
+    /* completions of the disposition being processed, handed over together once the link is done with it */
+    MESSAGE_SEND_COMPLETION* batched_completions;
+    size_t batched_completion_count;
+    size_t batched_completion_capacity;
+    /* pushed by producer threads, taken whole by messagesender_dowork */
+    LOCK_FREE_STACK threadsafe_sends;
     unsigned int is_trace_on : 1;
+    unsigned int is_ready_notification_due : 1;
+    /* unsettled sends survive the loss of the link and are sent again once messagesender_reattach gives a new one */
+    unsigned int is_resume_on_link_loss : 1;
+    /* sends waiting for credit go out highest header priority first instead of in the order they were queued */
+    unsigned int is_priority_order_on : 1;
+    unsigned int is_queue_depth_above : 1;
+    /* the send whose body is being streamed, the link takes no other transfer until its last part is sent */
+    ASYNC_OPERATION_HANDLE streaming_send;
+    STREAMED_PARTS* streamed_parts;
+    unsigned char* streamed_piece_buffer;
+    unsigned int is_streamed_body_done : 1;
+    /* created on the first send, keeps the memory of completed sends for the next ones */
+    ASYNC_OPERATION_POOL_HANDLE send_operation_pool;
+    /* NULL unless messagesender_set_message_expiry was called, the wheel is advanced by its owner */
+    TIMER_WHEEL_HANDLE expiry_timer_wheel;
+    TICK_COUNTER_HANDLE expiry_tick_counter;
+    /* set by messagesender_close_drained, new sends are refused and the link is detached by messagesender_dowork once
+       the pending sends are done or drain_timeout has passed since drain_start_ms */
+    unsigned int is_draining : 1;
+    TICK_COUNTER_HANDLE drain_tick_counter;
+    tickcounter_ms_t drain_start_ms;
+    tickcounter_ms_t drain_timeout;
+    /* NULL unless messagesender_set_body_encoding was called */
+    ON_MESSAGE_BODY_ENCODE on_body_encode;
+    void* on_body_encode_context;
+    char* body_content_encoding;
+    size_t body_encoding_min_size;
+    /* NULL unless messagesender_set_body_codec was called */
+    ON_MESSAGE_BODY_SERIALIZE on_body_serialize;
+    void* on_body_serialize_context;
+    char* body_content_type;
+    /* NULL unless messagesender_set_adaptive_batching was called, the batch size and delay are those set on the connection */
+    TICK_COUNTER_HANDLE batching_tick_counter;
+    milliseconds batching_latency_target;
+    uint32_t max_batching_size;
+    milliseconds max_batching_delay;
+    uint32_t batching_size;
+    milliseconds batching_delay;
+    tickcounter_ms_t batching_period_start_ms;
+    /* the settle latency histogram of the link at the start of the period, the period's latencies are the difference */
+    uint64_t batching_settle_latencies[LINK_SETTLE_LATENCY_BUCKET_COUNT];
 } MESSAGE_SENDER_INSTANCE;
 
-static void remove_pending_message_by_index(MESSAGE_SENDER_HANDLE message_sender, size_t index)
+static void report_queue_depth(MESSAGE_SENDER_INSTANCE* message_sender, CONNECTION_FLOW_EVENT event)
+{
+    CONNECTION_HANDLE connection;
+    const char* link_name;
+
+    if (link_get_connection(message_sender->link, &connection) != 0)
+    {
+        LogError("Cannot get the connection of the link");
+    }
+    else
+    {
+        if (link_get_name(message_sender->link, &link_name) != 0)
+        {
+            link_name = NULL;
+        }
+
+        connection_report_flow_event(connection, event, message_sender, link_name, message_sender->message_count);
+    }
+}
+
+static void append_pending_message(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send)
+{
+    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+
+    message_with_callback->previous = message_sender->last_message;
+    message_with_callback->next = NULL;
+
+    if (message_sender->last_message == NULL)
+    {
+        message_sender->first_message = pending_send;
+    }
+    else
+    {
+        (GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, message_sender->last_message))->next = pending_send;
+    }
+
+    message_sender->last_message = pending_send;
+    message_sender->message_count++;
+    ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_PENDING_SEND, sizeof(MESSAGE_WITH_CALLBACK));
+
+    if ((message_sender->queue_depth_threshold != 0) &&
+        (!message_sender->is_queue_depth_above) &&
+        (message_sender->message_count > message_sender->queue_depth_threshold))
+    {
+        message_sender->is_queue_depth_above = 1;
+        report_queue_depth(message_sender, CONNECTION_FLOW_EVENT_QUEUE_DEPTH_ABOVE);
+    }
+}
+
+static void remove_pending_message(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send)
 {
-    ASYNC_OPERATION_HANDLE* new_messages;
-    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, message_sender->messages[index]);
+    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+
+    if (message_with_callback->previous == NULL)
+    {
+        message_sender->first_message = message_with_callback->next;
+    }
+    else
+    {
+        (GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, message_with_callback->previous))->next = message_with_callback->next;
+    }
+
+    if (message_with_callback->next == NULL)
+    {
+        message_sender->last_message = message_with_callback->previous;
+    }
+    else
+    {
+        (GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, message_with_callback->next))->previous = message_with_callback->previous;
+    }
+
+    message_sender->message_count--;
+    ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_PENDING_SEND, sizeof(MESSAGE_WITH_CALLBACK));
+
+    if ((message_sender->is_queue_depth_above) &&
+        (message_sender->message_count <= message_sender->queue_depth_threshold))
+    {
+        message_sender->is_queue_depth_above = 0;
+        report_queue_depth(message_sender, CONNECTION_FLOW_EVENT_QUEUE_DEPTH_BELOW);
+    }
+
+    if (message_sender->streaming_send == pending_send)
+    {
+        message_sender->streaming_send = NULL;
+        message_sender->is_streamed_body_done = 1;
+    }
+
+    if (message_with_callback->expiry_timer != NULL)
+    {
+        timer_wheel_destroy_timer(message_with_callback->expiry_timer);
+        message_with_callback->expiry_timer = NULL;
+    }
 
     if (message_with_callback->message != NULL)
     {
@@ -62,44 +310,166 @@ static void remove_pending_message_by_index(MESSAGE_SENDER_HANDLE message_sender
         message_with_callback->message = NULL;
     }
 
-    async_operation_destroy(message_sender->messages[index]);
+    if (message_with_callback->encoded_message != NULL)
+    {
+        messagesender_destroy_encoded_message(message_with_callback->encoded_message);
+        message_with_callback->encoded_message = NULL;
+    }
 
-    if (message_sender->message_count - index > 1)
+    if (message_with_callback->message_template != NULL)
     {
-        (void)memmove(&message_sender->messages[index], &message_sender->messages[index + 1], sizeof(ASYNC_OPERATION_HANDLE) * (message_sender->message_count - index - 1));
+        messagesender_destroy_message_template(message_with_callback->message_template);
+        message_with_callback->message_template = NULL;
     }
 
-    message_sender->message_count--;
+    async_operation_destroy(pending_send);
+}
 
-    if (message_sender->message_count > 0)
+static void notify_ready_if_room(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    /* only a producer that was turned away is told, and only once, when a completion makes room again */
+    if ((message_sender->is_ready_notification_due == 1) &&
+        (message_sender->message_count < message_sender->max_in_flight))
     {
-        new_messages = (ASYNC_OPERATION_HANDLE*)realloc(message_sender->messages, sizeof(ASYNC_OPERATION_HANDLE) * (message_sender->message_count));
-        if (new_messages != NULL)
+        message_sender->is_ready_notification_due = 0;
+        if (message_sender->on_message_sender_ready != NULL)
         {
-            message_sender->messages = new_messages;
+            message_sender->on_message_sender_ready(message_sender->on_message_sender_ready_context);
         }
     }
-    else
+}
+
+/* returns the connection of the link when it times the application callbacks, NULL otherwise */
+static CONNECTION_HANDLE begin_timed_callback(LINK_HANDLE link, uint64_t* start_ms)
+{
+    CONNECTION_HANDLE result;
+
+    if ((link_get_connection(link, &result) != 0) ||
+        (!connection_begin_callback(result, start_ms)))
     {
-        free(message_sender->messages);
-        message_sender->messages = NULL;
+        result = NULL;
     }
+
+    return result;
 }
 
-static void remove_pending_message(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send)
+static void end_timed_callback(CONNECTION_HANDLE connection, LINK_HANDLE link, CONNECTION_CALLBACK_TYPE callback_type, uint64_t start_ms)
 {
-    size_t i;
+    if (connection != NULL)
+    {
+        const char* link_name;
+
+        if (link_get_name(link, &link_name) != 0)
+        {
+            link_name = NULL;
+        }
+
+        connection_end_callback(connection, callback_type, link_name, start_ms);
+    }
+}
 
-    for (i = 0; i < message_sender->message_count; i++)
+static void flush_batched_completions(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    if (message_sender->batched_completion_count > 0)
     {
-        if (message_sender->messages[i] == pending_send)
+        /* the array is taken out so that completions produced from the callback start a new batch */
+        MESSAGE_SEND_COMPLETION* completions = message_sender->batched_completions;
+        size_t completion_count = message_sender->batched_completion_count;
+        size_t completion_capacity = message_sender->batched_completion_capacity;
+        uint64_t start_ms;
+        CONNECTION_HANDLE timing_connection;
+
+        message_sender->batched_completions = NULL;
+        message_sender->batched_completion_count = 0;
+        message_sender->batched_completion_capacity = 0;
+
+        timing_connection = begin_timed_callback(message_sender->link, &start_ms);
+        message_sender->on_message_send_complete_batch(message_sender->on_message_send_complete_batch_context, completions, completion_count);
+        end_timed_callback(timing_connection, message_sender->link, CONNECTION_CALLBACK_TYPE_MESSAGE_SEND_COMPLETE, start_ms);
+
+        if (message_sender->batched_completions == NULL)
         {
-            remove_pending_message_by_index(message_sender, i);
-            break;
+            message_sender->batched_completions = completions;
+            message_sender->batched_completion_capacity = completion_capacity;
+        }
+        else
+        {
+            free(completions);
+        }
+    }
+}
+
+static bool append_batched_completion(MESSAGE_SENDER_INSTANCE* message_sender, void* context, MESSAGE_SEND_RESULT send_result)
+{
+    bool result;
+
+    if (message_sender->batched_completion_count == message_sender->batched_completion_capacity)
+    {
+        size_t new_capacity = (message_sender->batched_completion_capacity == 0) ? 16 : message_sender->batched_completion_capacity * 2;
+        MESSAGE_SEND_COMPLETION* new_completions = (MESSAGE_SEND_COMPLETION*)realloc(message_sender->batched_completions, sizeof(MESSAGE_SEND_COMPLETION) * new_capacity);
+        if (new_completions == NULL)
+        {
+            LogError("Cannot grow the batched completions array");
+        }
+        else
+        {
+            message_sender->batched_completions = new_completions;
+            message_sender->batched_completion_capacity = new_capacity;
+        }
+    }
+
+    if (message_sender->batched_completion_count == message_sender->batched_completion_capacity)
+    {
+        result = false;
+    }
+    else
+    {
+        message_sender->batched_completions[message_sender->batched_completion_count].context = context;
+        message_sender->batched_completions[message_sender->batched_completion_count].send_result = send_result;
+        message_sender->batched_completion_count++;
+        result = true;
+    }
+
+    return result;
+}
+
+/* is_deferred is true for completions caused by a received disposition, those wait for the link to finish the disposition */
+static void complete_send(MESSAGE_SENDER_INSTANCE* message_sender, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* context, MESSAGE_SEND_RESULT send_result, bool is_deferred)
+{
+    if (on_message_send_complete != NULL)
+    {
+        if (message_sender->on_message_send_complete_batch == NULL)
+        {
+            uint64_t start_ms;
+            CONNECTION_HANDLE timing_connection = begin_timed_callback(message_sender->link, &start_ms);
+
+            on_message_send_complete(context, send_result);
+            end_timed_callback(timing_connection, message_sender->link, CONNECTION_CALLBACK_TYPE_MESSAGE_SEND_COMPLETE, start_ms);
+        }
+        else if ((!is_deferred) ||
+            (!append_batched_completion(message_sender, context, send_result)))
+        {
+            MESSAGE_SEND_COMPLETION completion;
+            uint64_t start_ms;
+            CONNECTION_HANDLE timing_connection;
+
+            /* keep the completions in order */
+            flush_batched_completions(message_sender);
+
+            completion.context = context;
+            completion.send_result = send_result;
+            timing_connection = begin_timed_callback(message_sender->link, &start_ms);
+            message_sender->on_message_send_complete_batch(message_sender->on_message_send_complete_batch_context, &completion, 1);
+            end_timed_callback(timing_connection, message_sender->link, CONNECTION_CALLBACK_TYPE_MESSAGE_SEND_COMPLETE, start_ms);
         }
     }
 }
 
+static void on_link_disposition_processed(void* context)
+{
+    flush_batched_completions((MESSAGE_SENDER_INSTANCE*)context);
+}
+
 static void on_delivery_settled(void* context, delivery_number delivery_no, LINK_DELIVERY_SETTLE_REASON reason, AMQP_VALUE delivery_state)
 {
     ASYNC_OPERATION_HANDLE pending_send = (ASYNC_OPERATION_HANDLE)context;
@@ -107,56 +477,108 @@ static void on_delivery_settled(void* context, delivery_number delivery_no, LINK
     MESSAGE_SENDER_INSTANCE* message_sender = (MESSAGE_SENDER_INSTANCE*)message_with_callback->message_sender;
     (void)delivery_no;
 
-    if (message_with_callback->on_message_send_complete != NULL)
+    UAMQP_TRACEPOINT2(message_sender_delivery_settled, delivery_no, reason);
+
+    if ((reason == LINK_DELIVERY_SETTLE_REASON_NOT_DELIVERED) &&
+        (message_sender->is_resume_on_link_loss == 1) &&
+        (message_with_callback->on_message_body_read == NULL) &&
+        ((message_with_callback->message != NULL) || (message_with_callback->encoded_message != NULL)))
     {
-        switch (reason)
+        if (message_with_callback->is_expired == 1)
         {
-        case LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED:
-            if (delivery_state == NULL)
-            {
-                LogError("delivery state not provided");
-            }
-            else
-            {
-                AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(delivery_state);
+            /* the send expired while in flight, it is not sent again on the next link */
+            complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_EXPIRED, false);
 
-                if (descriptor == NULL)
-                {
-                    LogError("Error getting descriptor for delivery state");
-                }
-                else if (is_accepted_type_by_descriptor(descriptor))
+            remove_pending_message(message_sender, pending_send);
+            notify_ready_if_room(message_sender);
+        }
+        else
+        {
+            /* the link went away with the delivery unsettled, keep the send for the next link */
+            message_with_callback->message_send_state = MESSAGE_SEND_STATE_NOT_SENT;
+        }
+    }
+    else
+    {
+        if (message_with_callback->on_message_send_complete != NULL)
+        {
+            switch (reason)
+            {
+            case LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED:
+                if (delivery_state == NULL)
                 {
-                    message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_OK);
+                    LogError("delivery state not provided");
                 }
                 else
                 {
-                    message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_ERROR);
+                    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(delivery_state);
+
+                    if (descriptor == NULL)
+                    {
+                        LogError("Error getting descriptor for delivery state");
+                    }
+                    else if (is_accepted_type_by_descriptor(descriptor))
+                    {
+                        complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_OK, true);
+                    }
+                    else
+                    {
+                        complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_ERROR, true);
+                    }
                 }
-            }
 
-            break;
-        case LINK_DELIVERY_SETTLE_REASON_SETTLED:
-            message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_OK);
-            break;
-        case LINK_DELIVERY_SETTLE_REASON_TIMEOUT:
-            message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_TIMEOUT);
-            break;
-        case LINK_DELIVERY_SETTLE_REASON_NOT_DELIVERED:
-        default:
-            message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_ERROR);
-            break;
+                break;
+            case LINK_DELIVERY_SETTLE_REASON_SETTLED:
+                complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_OK, false);
+                break;
+            case LINK_DELIVERY_SETTLE_REASON_TIMEOUT:
+                complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_TIMEOUT, false);
+                break;
+            case LINK_DELIVERY_SETTLE_REASON_CANCELLED:
+                /* the delivery of a streamed send is cancelled when the send is, or when its body cannot be read */
+                complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context,
+                    (message_with_callback->is_send_cancelled == 1) ? MESSAGE_SEND_CANCELLED : MESSAGE_SEND_ERROR, false);
+                break;
+            case LINK_DELIVERY_SETTLE_REASON_NOT_DELIVERED:
+            default:
+                complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_ERROR, false);
+                break;
+            }
         }
-    }
 
-    remove_pending_message(message_sender, pending_send);
+        remove_pending_message(message_sender, pending_send);
+        notify_ready_if_room(message_sender);
+    }
 }
 
-static int encode_bytes(void* context, const unsigned char* bytes, size_t length)
+/* A data section is the described type amqp:data:binary, the descriptor 0x75 encoded as a smallulong followed by the binary constructor for its length */
+static size_t encode_data_section_header(unsigned char* buffer, uint32_t data_length)
 {
-    PAYLOAD* payload = (PAYLOAD*)context;
-    (void)memcpy((unsigned char*)payload->bytes + payload->length, bytes, length);
-    payload->length += length;
-    return 0;
+    size_t result;
+
+    buffer[0] = 0x00;
+    buffer[1] = 0x53;
+    buffer[2] = 0x75;
+
+    if (data_length <= 255)
+    {
+        /* vbin8 */
+        buffer[3] = 0xA0;
+        buffer[4] = (unsigned char)data_length;
+        result = 5;
+    }
+    else
+    {
+        /* vbin32 */
+        buffer[3] = 0xB0;
+        buffer[4] = (unsigned char)(data_length >> 24);
+        buffer[5] = (unsigned char)((data_length >> 16) & 0xFF);
+        buffer[6] = (unsigned char)((data_length >> 8) & 0xFF);
+        buffer[7] = (unsigned char)(data_length & 0xFF);
+        result = 8;
+    }
+
+    return result;
 }
 
 static void log_message_chunk(MESSAGE_SENDER_INSTANCE* message_sender, const char* name, AMQP_VALUE value)
@@ -166,7 +588,7 @@ static void log_message_chunk(MESSAGE_SENDER_INSTANCE* message_sender, const cha
     UNUSED(name);
     UNUSED(value);
 #else
-    if (xlogging_get_log_function() != NULL && message_sender->is_trace_on == 1)
+    if (xlogging_get_log_function() != NULL && message_sender != NULL && message_sender->is_trace_on == 1)
     {
         char* value_as_string = NULL;
         LOG(AZ_LOG_TRACE, 0, "%s", P_OR_NULL(name));
@@ -179,20 +601,42 @@ static void log_message_chunk(MESSAGE_SENDER_INSTANCE* message_sender, const cha
 #endif
 }
 
-static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send, MESSAGE_HANDLE message)
+/* closes the payload holding the bytes encoded up to encoded_end and adds one for the section of the template, if it has it */
+static void add_template_section_payload(MESSAGE_TEMPLATE_INSTANCE* message_template, size_t section, PAYLOAD* payloads, size_t* payload_count, const unsigned char* encoded_end)
 {
-    SEND_ONE_MESSAGE_RESULT result;
+    if ((message_template != NULL) &&
+        (message_template->section_lengths[section] > 0))
+    {
+        payloads[*payload_count].length = (size_t)(encoded_end - payloads[*payload_count].bytes);
+        if (payloads[*payload_count].length > 0)
+        {
+            (*payload_count)++;
+        }
+
+        payloads[*payload_count].bytes = message_template->bytes + message_template->section_offsets[section];
+        payloads[*payload_count].length = message_template->section_lengths[section];
+        (*payload_count)++;
+        payloads[*payload_count].bytes = encoded_end;
+        payloads[*payload_count].length = 0;
+    }
+}
+
+/* on success the caller owns encoded_bytes and encoded_payloads, the payloads also point into the message body data so the message has to outlive them.
+A message whose body is streamed may have no body of its own, its data sections are then all streamed. The sections message does not have
+are taken from message_template when it is not NULL, the payloads then point into it as well. A message sent with a body_object has no body
+either, body_object is serialized by the body codec of the sender as one data section straight into encoded_bytes. */
+static int encode_message(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_HANDLE message, MESSAGE_TEMPLATE_INSTANCE* message_template, bool is_body_streamed, const void* body_object, unsigned char** encoded_bytes, PAYLOAD** encoded_payloads, size_t* encoded_payload_count)
+{
+    int result;
 
     size_t encoded_size;
     size_t total_encoded_size = 0;
     MESSAGE_BODY_TYPE message_body_type;
-    message_format message_format;
 
-    if ((message_get_body_type(message, &message_body_type) != 0) ||
-        (message_get_message_format(message, &message_format) != 0))
+    if (message_get_body_type(message, &message_body_type) != 0)
     {
-        LogError("Failure getting message body type and/or message format");
-        result = SEND_ONE_MESSAGE_ERROR;
+        LogError("Failure getting message body type");
+        result = __FAILURE__;
     }
     else
     {
@@ -205,6 +649,9 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
         AMQP_VALUE application_properties_value = NULL;
         AMQP_VALUE body_amqp_value = NULL;
         size_t body_data_count = 0;
+        size_t body_data_size = 0;
+        size_t serialized_body_size = 0;
+        size_t message_encoded_size;
         AMQP_VALUE msg_annotations = NULL;
         bool is_error = false;
 
@@ -218,35 +665,13 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
                 LogError("Cannot create header AMQP value");
                 is_error = true;
             }
-            else
-            {
-                if (amqpvalue_get_encoded_size(header_amqp_value, &encoded_size) != 0)
-                {
-                    LogError("Cannot obtain header encoded size");
-                    is_error = true;
-                }
-                else
-                {
-                    total_encoded_size += encoded_size;
-                }
-            }
 
         }
 
         // message annotations
-        if ((!is_error) &&
-            (message_get_message_annotations(message, &msg_annotations) == 0) &&
-            (msg_annotations != NULL))
+        if (!is_error)
         {
-            if (amqpvalue_get_encoded_size(msg_annotations, &encoded_size) != 0)
-            {
-                LogError("Cannot obtain message annotations encoded size");
-                is_error = true;
-            }
-            else
-            {
-                total_encoded_size += encoded_size;
-            }
+            (void)message_get_message_annotations(message, &msg_annotations);
         }
 
         // properties
@@ -260,18 +685,6 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
                 LogError("Cannot create message properties AMQP value");
                 is_error = true;
             }
-            else
-            {
-                if (amqpvalue_get_encoded_size(properties_amqp_value, &encoded_size) != 0)
-                {
-                    LogError("Cannot obtain message properties encoded size");
-                    is_error = true;
-                }
-                else
-                {
-                    total_encoded_size += encoded_size;
-                }
-            }
         }
 
         // application properties
@@ -285,43 +698,63 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
                 LogError("Cannot create application properties AMQP value");
                 is_error = true;
             }
-            else
-            {
-                if (amqpvalue_get_encoded_size(application_properties_value, &encoded_size) != 0)
-                {
-                    LogError("Cannot obtain application properties encoded size");
-                    is_error = true;
-                }
-                else
-                {
-                    total_encoded_size += encoded_size;
-                }
-            }
         }
 
         if (is_error)
         {
-            result = SEND_ONE_MESSAGE_ERROR;
+            result = __FAILURE__;
         }
         else
         {
-            result = SEND_ONE_MESSAGE_OK;
+            result = 0;
 
             // body - amqp data
             switch (message_body_type)
             {
             default:
                 LogError("Unknown body type");
-                result = SEND_ONE_MESSAGE_ERROR;
+                result = __FAILURE__;
+                break;
+
+            case MESSAGE_BODY_TYPE_NONE:
+                if (body_object != NULL)
+                {
+                    /* asked for first, so that the body is serialized in place of the data bytes */
+                    if (message_sender->on_body_serialize == NULL)
+                    {
+                        LogError("The body codec was turned off while the send was pending");
+                        result = __FAILURE__;
+                    }
+                    else if (message_sender->on_body_serialize(message_sender->on_body_serialize_context, body_object, NULL, 0, &serialized_body_size) != 0)
+                    {
+                        LogError("Cannot get the serialized size of the body");
+                        result = __FAILURE__;
+                    }
+                    else if (serialized_body_size > UINT32_MAX)
+                    {
+                        LogError("Serialized body is too big");
+                        result = __FAILURE__;
+                    }
+                }
+                else if (!is_body_streamed)
+                {
+                    LogError("Message has no body");
+                    result = __FAILURE__;
+                }
                 break;
 
             case MESSAGE_BODY_TYPE_VALUE:
             {
                 AMQP_VALUE message_body_amqp_value;
-                if (message_get_body_amqp_value_in_place(message, &message_body_amqp_value) != 0)
+                if (is_body_streamed)
+                {
+                    LogError("A streamed body can only follow data sections");
+                    result = __FAILURE__;
+                }
+                else if (message_get_body_amqp_value_in_place(message, &message_body_amqp_value) != 0)
                 {
                     LogError("Cannot obtain AMQP value from body");
-                    result = SEND_ONE_MESSAGE_ERROR;
+                    result = __FAILURE__;
                 }
                 else
                 {
@@ -329,19 +762,7 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
                     if (body_amqp_value == NULL)
                     {
                         LogError("Cannot create body AMQP value");
-                        result = SEND_ONE_MESSAGE_ERROR;
-                    }
-                    else
-                    {
-                        if (amqpvalue_get_encoded_size(body_amqp_value, &encoded_size) != 0)
-                        {
-                            LogError("Cannot get body AMQP value encoded size");
-                            result = SEND_ONE_MESSAGE_ERROR;
-                        }
-                        else
-                        {
-                            total_encoded_size += encoded_size;
-                        }
+                        result = __FAILURE__;
                     }
                 }
 
@@ -356,7 +777,7 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
                 if (message_get_body_amqp_data_count(message, &body_data_count) != 0)
                 {
                     LogError("Cannot get body AMQP data count");
-                    result = SEND_ONE_MESSAGE_ERROR;
+                    result = __FAILURE__;
                 }
                 else
                 {
@@ -365,34 +786,17 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
                         if (message_get_body_amqp_data_in_place(message, i, &binary_data) != 0)
                         {
                             LogError("Cannot get body AMQP data %u", (unsigned int)i);
-                            result = SEND_ONE_MESSAGE_ERROR;
+                            result = __FAILURE__;
+                        }
+                        else if (binary_data.length > UINT32_MAX)
+                        {
+                            LogError("Body AMQP data %u is too big", (unsigned int)i);
+                            result = __FAILURE__;
                         }
                         else
                         {
-                            AMQP_VALUE body_amqp_data;
-                            amqp_binary binary_value;
-                            binary_value.bytes = binary_data.bytes;
-                            binary_value.length = (uint32_t)binary_data.length;
-                            body_amqp_data = amqpvalue_create_data(binary_value);
-                            if (body_amqp_data == NULL)
-                            {
-                                LogError("Cannot create body AMQP data");
-                                result = SEND_ONE_MESSAGE_ERROR;
-                            }
-                            else
-                            {
-                                if (amqpvalue_get_encoded_size(body_amqp_data, &encoded_size) != 0)
-                                {
-                                    LogError("Cannot get body AMQP data encoded size");
-                                    result = SEND_ONE_MESSAGE_ERROR;
-                                }
-                                else
-                                {
-                                    total_encoded_size += encoded_size;
-                                }
-
-                                amqpvalue_destroy(body_amqp_data);
-                            }
+                            /* only the section header is encoded, the data bytes are sent from the message */
+                            body_data_size += binary_data.length;
                         }
                     }
                 }
@@ -400,148 +804,230 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
             }
             }
 
+            /* the message caches the size of its sections, so it is only worked out once however often the message is sent */
             if (result == 0)
             {
-                void* data_bytes = malloc(total_encoded_size);
-                PAYLOAD payload;
-                payload.bytes = (const unsigned char*)data_bytes;
-                payload.length = 0;
-                result = SEND_ONE_MESSAGE_OK;
-
-                if (header != NULL)
+                if (message_get_encoded_size(message, &message_encoded_size) != 0)
                 {
-                    if (amqpvalue_encode(header_amqp_value, encode_bytes, &payload) != 0)
+                    LogError("Cannot get message encoded size");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    total_encoded_size = message_encoded_size - body_data_size;
+                    if (body_object != NULL)
                     {
-                        LogError("Cannot encode header value");
-                        result = SEND_ONE_MESSAGE_ERROR;
+                        total_encoded_size += ((serialized_body_size <= 255) ? 5 : 8) + serialized_body_size;
                     }
-
-                    log_message_chunk(message_sender, "Header:", header_amqp_value);
                 }
+            }
 
-                if ((result == SEND_ONE_MESSAGE_OK) && (msg_annotations != NULL))
+            if (result == 0)
+            {
+                /* one payload for the encoded sections, then for each data section one for the data bytes and one for the encoding that follows them,
+                   and likewise for each section of the template */
+                size_t payload_count = 0;
+                unsigned char* data_bytes = (unsigned char*)malloc(total_encoded_size);
+                PAYLOAD* payloads = (PAYLOAD*)malloc(sizeof(PAYLOAD) * (1 + (body_data_count * 2) + ((message_template == NULL) ? 0 : (MESSAGE_TEMPLATE_SECTION_COUNT * 2))));
+                if (((data_bytes == NULL) && (total_encoded_size > 0)) ||
+                    (payloads == NULL))
+                {
+                    LogError("Cannot allocate memory for the encoded message");
+                    result = __FAILURE__;
+                }
+                else
                 {
-                    if (amqpvalue_encode(msg_annotations, encode_bytes, &payload) != 0)
+                    size_t encoded_pos = 0;
+                    payloads[0].bytes = data_bytes;
+                    payloads[0].length = 0;
+                    result = 0;
+
+                    if (header == NULL)
                     {
-                        LogError("Cannot encode message annotations value");
-                        result = SEND_ONE_MESSAGE_ERROR;
+                        add_template_section_payload(message_template, MESSAGE_TEMPLATE_SECTION_HEADER, payloads, &payload_count, data_bytes + encoded_pos);
                     }
+                    else
+                    {
+                        if (amqpvalue_encode_to_buffer(header_amqp_value, data_bytes + encoded_pos, total_encoded_size - encoded_pos, &encoded_size) != 0)
+                        {
+                            LogError("Cannot encode header value");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            encoded_pos += encoded_size;
+                        }
 
-                    log_message_chunk(message_sender, "Message Annotations:", msg_annotations);
-                }
+                        log_message_chunk(message_sender, "Header:", header_amqp_value);
+                    }
 
-                if ((result == SEND_ONE_MESSAGE_OK) && (properties != NULL))
-                {
-                    if (amqpvalue_encode(properties_amqp_value, encode_bytes, &payload) != 0)
+                    if (msg_annotations == NULL)
                     {
-                        LogError("Cannot encode message properties value");
-                        result = SEND_ONE_MESSAGE_ERROR;
+                        add_template_section_payload(message_template, MESSAGE_TEMPLATE_SECTION_MESSAGE_ANNOTATIONS, payloads, &payload_count, data_bytes + encoded_pos);
                     }
+                    else if (result == 0)
+                    {
+                        if (amqpvalue_encode_to_buffer(msg_annotations, data_bytes + encoded_pos, total_encoded_size - encoded_pos, &encoded_size) != 0)
+                        {
+                            LogError("Cannot encode message annotations value");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            encoded_pos += encoded_size;
+                        }
 
-                    log_message_chunk(message_sender, "Properties:", properties_amqp_value);
-                }
+                        log_message_chunk(message_sender, "Message Annotations:", msg_annotations);
+                    }
 
-                if ((result == SEND_ONE_MESSAGE_OK) && (application_properties != NULL))
-                {
-                    if (amqpvalue_encode(application_properties_value, encode_bytes, &payload) != 0)
+                    if (properties == NULL)
                     {
-                        LogError("Cannot encode application properties value");
-                        result = SEND_ONE_MESSAGE_ERROR;
+                        add_template_section_payload(message_template, MESSAGE_TEMPLATE_SECTION_PROPERTIES, payloads, &payload_count, data_bytes + encoded_pos);
                     }
+                    else if (result == 0)
+                    {
+                        if (amqpvalue_encode_to_buffer(properties_amqp_value, data_bytes + encoded_pos, total_encoded_size - encoded_pos, &encoded_size) != 0)
+                        {
+                            LogError("Cannot encode message properties value");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            encoded_pos += encoded_size;
+                        }
 
-                    log_message_chunk(message_sender, "Application properties:", application_properties_value);
-                }
+                        log_message_chunk(message_sender, "Properties:", properties_amqp_value);
+                    }
 
-                if (result == SEND_ONE_MESSAGE_OK)
-                {
-                    switch (message_body_type)
+                    if (application_properties == NULL)
                     {
-                    default:
-                        LogError("Unknown message type");
-                        result = SEND_ONE_MESSAGE_ERROR;
-                        break;
-
-                    case MESSAGE_BODY_TYPE_VALUE:
+                        add_template_section_payload(message_template, MESSAGE_TEMPLATE_SECTION_APPLICATION_PROPERTIES, payloads, &payload_count, data_bytes + encoded_pos);
+                    }
+                    else if (result == 0)
                     {
-                        if (amqpvalue_encode(body_amqp_value, encode_bytes, &payload) != 0)
+                        if (amqpvalue_encode_to_buffer(application_properties_value, data_bytes + encoded_pos, total_encoded_size - encoded_pos, &encoded_size) != 0)
+                        {
+                            LogError("Cannot encode application properties value");
+                            result = __FAILURE__;
+                        }
+                        else
                         {
-                            LogError("Cannot encode body AMQP value");
-                            result = SEND_ONE_MESSAGE_ERROR;
+                            encoded_pos += encoded_size;
                         }
 
-                        log_message_chunk(message_sender, "Body - amqp value:", body_amqp_value);
-                        break;
+                        log_message_chunk(message_sender, "Application properties:", application_properties_value);
                     }
-                    case MESSAGE_BODY_TYPE_DATA:
+
+                    if (result == 0)
                     {
-                        BINARY_DATA binary_data;
-                        size_t i;
+                        switch (message_body_type)
+                        {
+                        default:
+                            LogError("Unknown message type");
+                            result = __FAILURE__;
+                            break;
+
+                        case MESSAGE_BODY_TYPE_NONE:
+                            if (body_object != NULL)
+                            {
+                                size_t serialized_size;
+
+                                encoded_pos += encode_data_section_header(data_bytes + encoded_pos, (uint32_t)serialized_body_size);
+                                if (message_sender->on_body_serialize(message_sender->on_body_serialize_context, body_object, data_bytes + encoded_pos, serialized_body_size, &serialized_size) != 0)
+                                {
+                                    LogError("Cannot serialize the body");
+                                    result = __FAILURE__;
+                                }
+                                else if (serialized_size != serialized_body_size)
+                                {
+                                    LogError("Body serialized to %u bytes instead of %u", (unsigned int)serialized_size, (unsigned int)serialized_body_size);
+                                    result = __FAILURE__;
+                                }
+                                else
+                                {
+                                    encoded_pos += serialized_size;
+                                }
+                            }
 
-                        for (i = 0; i < body_data_count; i++)
+                            /* otherwise all the data sections of a streamed body follow in later parts */
+                            break;
+
+                        case MESSAGE_BODY_TYPE_VALUE:
                         {
-                            if (message_get_body_amqp_data_in_place(message, i, &binary_data) != 0)
+                            if (amqpvalue_encode_to_buffer(body_amqp_value, data_bytes + encoded_pos, total_encoded_size - encoded_pos, &encoded_size) != 0)
                             {
-                                LogError("Cannot get AMQP data %u", (unsigned int)i);
-                                result = SEND_ONE_MESSAGE_ERROR;
+                                LogError("Cannot encode body AMQP value");
+                                result = __FAILURE__;
                             }
                             else
                             {
-                                AMQP_VALUE body_amqp_data;
-                                amqp_binary binary_value;
-                                binary_value.bytes = binary_data.bytes;
-                                binary_value.length = (uint32_t)binary_data.length;
-                                body_amqp_data = amqpvalue_create_data(binary_value);
-                                if (body_amqp_data == NULL)
+                                encoded_pos += encoded_size;
+                            }
+
+                            log_message_chunk(message_sender, "Body - amqp value:", body_amqp_value);
+                            break;
+                        }
+                        case MESSAGE_BODY_TYPE_DATA:
+                        {
+                            BINARY_DATA binary_data;
+                            size_t i;
+
+                            for (i = 0; i < body_data_count; i++)
+                            {
+                                if (message_get_body_amqp_data_in_place(message, i, &binary_data) != 0)
                                 {
-                                    LogError("Cannot create body AMQP data %u", (unsigned int)i);
-                                    result = SEND_ONE_MESSAGE_ERROR;
+                                    LogError("Cannot get AMQP data %u", (unsigned int)i);
+                                    result = __FAILURE__;
+                                    break;
                                 }
                                 else
                                 {
-                                    if (amqpvalue_encode(body_amqp_data, encode_bytes, &payload) != 0)
+                                    encoded_pos += encode_data_section_header(data_bytes + encoded_pos, (uint32_t)binary_data.length);
+
+                                    if (binary_data.length > 0)
                                     {
-                                        LogError("Cannot encode body AMQP data %u", (unsigned int)i);
-                                        result = SEND_ONE_MESSAGE_ERROR;
-                                        break;
+                                        /* close the payload holding the encoded bytes so far and point the next one at the data bytes */
+                                        payloads[payload_count].length = (size_t)((data_bytes + encoded_pos) - payloads[payload_count].bytes);
+                                        payload_count++;
+                                        payloads[payload_count].bytes = binary_data.bytes;
+                                        payloads[payload_count].length = binary_data.length;
+                                        payload_count++;
+                                        payloads[payload_count].bytes = data_bytes + encoded_pos;
+                                        payloads[payload_count].length = 0;
                                     }
-
-                                    amqpvalue_destroy(body_amqp_data);
                                 }
                             }
+                            break;
+                        }
                         }
-                        break;
-                    }
                     }
-                }
 
-                if (result == SEND_ONE_MESSAGE_OK)
-                {
-                    ASYNC_OPERATION_HANDLE transfer_async_operation;
-                    LINK_TRANSFER_RESULT link_transfer_error;
-                    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
-                    message_with_callback->message_send_state = MESSAGE_SEND_STATE_PENDING;
-                    
-                    transfer_async_operation = link_transfer_async(message_sender->link, message_format, &payload, 1, on_delivery_settled, pending_send, &link_transfer_error, message_with_callback->timeout);
-                    if (transfer_async_operation == NULL)
+                    if (result == 0)
                     {
-                        if (link_transfer_error == LINK_TRANSFER_BUSY)
-                        {
-                            message_with_callback->message_send_state = MESSAGE_SEND_STATE_NOT_SENT;
-                            result = SEND_ONE_MESSAGE_BUSY;
-                        }
-                        else
+                        /* the last payload holds whatever was encoded after the last data bytes, drop it if that is nothing */
+                        payloads[payload_count].length = (size_t)((data_bytes + encoded_pos) - payloads[payload_count].bytes);
+                        if (payloads[payload_count].length > 0)
                         {
-                            LogError("Error in link transfer");
-                            result = SEND_ONE_MESSAGE_ERROR;
+                            payload_count++;
                         }
-                    }
-                    else
-                    {
-                        result = SEND_ONE_MESSAGE_OK;
+
+                        *encoded_bytes = data_bytes;
+                        *encoded_payloads = payloads;
+                        *encoded_payload_count = payload_count;
+                        data_bytes = NULL;
+                        payloads = NULL;
                     }
                 }
 
-                free(data_bytes);
+                if (payloads != NULL)
+                {
+                    free(payloads);
+                }
+
+                if (data_bytes != NULL)
+                {
+                    free(data_bytes);
+                }
 
                 if (body_amqp_value != NULL)
                 {
@@ -589,230 +1075,2498 @@ static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message
     return result;
 }
 
-static void send_all_pending_messages(MESSAGE_SENDER_HANDLE message_sender)
+static void release_streamed_parts(STREAMED_PARTS* streamed_parts)
 {
-    size_t i;
+    if (DEC_REF(STREAMED_PARTS, streamed_parts) == DEC_RETURN_ZERO)
+    {
+        free(streamed_parts);
+    }
+}
+
+/* only counts the part, the next pieces are read by messagesender_dowork since this can be called from within any I/O call */
+static void on_streamed_part_sent(void* context, IO_SEND_RESULT send_result)
+{
+    STREAMED_PARTS* streamed_parts = (STREAMED_PARTS*)context;
+    (void)send_result;
+
+    streamed_parts->parts_in_flight--;
+    release_streamed_parts(streamed_parts);
+}
+
+/* cancelling the delivery aborts it on the link, which then completes the send through on_delivery_settled */
+static void fail_streaming_send(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send)
+{
+    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
 
-    for (i = 0; i < message_sender->message_count; i++)
+    message_with_callback->is_body_read_failed = 1;
+    message_sender->streaming_send = NULL;
+    message_sender->is_streamed_body_done = 1;
+
+    if (async_operation_cancel(message_with_callback->streamed_delivery) != 0)
+    {
+        LogError("Cannot cancel the delivery of the streamed send");
+    }
+}
+
+/* reads the streamed body piece by piece, sending each as a data section, as long as fewer than STREAMED_BODY_MAX_PARTS_IN_FLIGHT parts are waiting for the I/O */
+static void send_streamed_body(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    while ((message_sender->streaming_send != NULL) &&
+        (message_sender->streamed_parts->parts_in_flight < STREAMED_BODY_MAX_PARTS_IN_FLIGHT))
     {
-        MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, message_sender->messages[i]);
-        if (message_with_callback->message_send_state == MESSAGE_SEND_STATE_NOT_SENT)
+        ASYNC_OPERATION_HANDLE pending_send = message_sender->streaming_send;
+        MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+        unsigned char* piece_bytes = message_sender->streamed_piece_buffer + DATA_SECTION_HEADER_MAX_SIZE;
+        size_t bytes_read = 0;
+        bool is_end = false;
+
+        if ((message_with_callback->on_message_body_read(message_with_callback->body_read_context, piece_bytes, STREAMED_BODY_PIECE_SIZE, &bytes_read, &is_end) != 0) ||
+            (bytes_read > STREAMED_BODY_PIECE_SIZE))
         {
-            switch (send_one_message(message_sender, message_sender->messages[i], message_with_callback->message))
-            {
-            default:
-                LogError("Invalid send one message result");
-                break;
+            LogError("Cannot read the streamed body");
+            fail_streaming_send(message_sender, pending_send);
+        }
+        else if ((bytes_read == 0) && !is_end)
+        {
+            /* nothing is ready yet, messagesender_dowork asks again */
+            break;
+        }
+        else
+        {
+            PAYLOAD payload;
+            size_t payload_count = 0;
 
-            case SEND_ONE_MESSAGE_ERROR:
+            if (bytes_read > 0)
             {
-                ON_MESSAGE_SEND_COMPLETE on_message_send_complete = message_with_callback->on_message_send_complete;
-                void* context = message_with_callback->context;
-                remove_pending_message_by_index(message_sender, i);
-
-                if (on_message_send_complete != NULL)
-                {
-                    on_message_send_complete(context, MESSAGE_SEND_ERROR);
-                }
+                /* the section header is encoded right in front of the piece, so that both go out as one payload */
+                size_t header_size = (bytes_read <= 255) ? 5 : DATA_SECTION_HEADER_MAX_SIZE;
 
-                i = message_sender->message_count;
-                break;
+                payload.bytes = piece_bytes - header_size;
+                payload.length = encode_data_section_header(piece_bytes - header_size, (uint32_t)bytes_read) + bytes_read;
+                payload_count = 1;
             }
-            case SEND_ONE_MESSAGE_BUSY:
-                i = message_sender->message_count + 1;
-                break;
 
-            case SEND_ONE_MESSAGE_OK:
-                break;
-            }
+            message_sender->streamed_parts->parts_in_flight++;
+            INC_REF(STREAMED_PARTS, message_sender->streamed_parts);
 
-            i--;
+            if (link_transfer_stream_continue(message_sender->link, (payload_count > 0) ? &payload : NULL, payload_count, !is_end, on_streamed_part_sent, message_sender->streamed_parts) != 0)
+            {
+                LogError("Cannot send a part of the streamed body");
+                message_sender->streamed_parts->parts_in_flight--;
+                release_streamed_parts(message_sender->streamed_parts);
+                fail_streaming_send(message_sender, pending_send);
+            }
+            else if (is_end)
+            {
+                /* the delivery now only waits for its disposition, the next sends can go */
+                message_sender->streaming_send = NULL;
+                message_sender->is_streamed_body_done = 1;
+            }
+            else
+            {
+                /* more pieces to come */
+            }
         }
     }
 }
 
-static void set_message_sender_state(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_SENDER_STATE new_state)
+static SEND_ONE_MESSAGE_RESULT transfer_message(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send, message_format message_format, PAYLOAD* payloads, size_t payload_count)
 {
-    MESSAGE_SENDER_STATE previous_state = message_sender->message_sender_state;
-    message_sender->message_sender_state = new_state;
-    if (message_sender->on_message_sender_state_changed != NULL)
+    SEND_ONE_MESSAGE_RESULT result;
+    ASYNC_OPERATION_HANDLE transfer_async_operation;
+    LINK_TRANSFER_RESULT link_transfer_error;
+    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+    message_with_callback->message_send_state = MESSAGE_SEND_STATE_PENDING;
+
+    if ((message_sender->is_resume_on_link_loss == 1) &&
+        (link_get_next_delivery_tag(message_sender->link, message_with_callback->delivery_tag_bytes, &message_with_callback->delivery_tag_length) != 0))
     {
-        message_sender->on_message_sender_state_changed(message_sender->on_message_sender_state_changed_context, new_state, previous_state);
+        LogError("Cannot get the delivery tag of the transfer");
+        message_with_callback->delivery_tag_length = 0;
     }
-}
-
-static void indicate_all_messages_as_error(MESSAGE_SENDER_INSTANCE* message_sender)
-{
-    size_t i;
 
-    for (i = 0; i < message_sender->message_count; i++)
+    if (message_with_callback->on_message_body_read == NULL)
     {
-        MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, message_sender->messages[i]);
-        if (message_with_callback->on_message_send_complete != NULL)
+        transfer_async_operation = link_transfer_async(message_sender->link, message_format, payloads, payload_count, on_delivery_settled, pending_send, &link_transfer_error, message_with_callback->timeout);
+    }
+    else
+    {
+        /* the encoded sections before the body go out as the first part, the body is then read and sent by send_streamed_body */
+        message_sender->streamed_parts->parts_in_flight++;
+        INC_REF(STREAMED_PARTS, message_sender->streamed_parts);
+
+        transfer_async_operation = link_transfer_stream_async(message_sender->link, message_format, payloads, payload_count, true, on_streamed_part_sent, message_sender->streamed_parts,
+            on_delivery_settled, pending_send, &link_transfer_error, message_with_callback->timeout);
+        if (transfer_async_operation == NULL)
         {
-            message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_ERROR);
+            message_sender->streamed_parts->parts_in_flight--;
+            release_streamed_parts(message_sender->streamed_parts);
         }
-
-        if (message_with_callback->message != NULL)
+        else
         {
-            message_destroy(message_with_callback->message);
+            message_with_callback->streamed_delivery = transfer_async_operation;
+            message_sender->streaming_send = pending_send;
         }
-        async_operation_destroy(message_sender->messages[i]);
     }
 
-    if (message_sender->messages != NULL)
+    if (transfer_async_operation == NULL)
     {
-        message_sender->message_count = 0;
+        message_with_callback->delivery_tag_length = 0;
 
-        free(message_sender->messages);
-        message_sender->messages = NULL;
+        if (link_transfer_error == LINK_TRANSFER_BUSY)
+        {
+            message_with_callback->message_send_state = MESSAGE_SEND_STATE_NOT_SENT;
+            result = SEND_ONE_MESSAGE_BUSY;
+        }
+        else
+        {
+            LogError("Error in link transfer");
+            result = SEND_ONE_MESSAGE_ERROR;
+        }
     }
+    else
+    {
+        result = SEND_ONE_MESSAGE_OK;
+    }
+
+    return result;
 }
 
-static void on_link_state_changed(void* context, LINK_STATE new_link_state, LINK_STATE previous_link_state)
+/* message is NULL for sends of an already encoded message */
+static SEND_ONE_MESSAGE_RESULT send_one_message(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send, MESSAGE_HANDLE message)
 {
-    MESSAGE_SENDER_INSTANCE* message_sender = (MESSAGE_SENDER_INSTANCE*)context;
-    (void)previous_link_state;
+    SEND_ONE_MESSAGE_RESULT result;
 
-    switch (new_link_state)
+    if (message == NULL)
     {
-    default:
-        break;
+        ENCODED_MESSAGE_INSTANCE* encoded_message = (GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send))->encoded_message;
+        PAYLOAD payload;
 
-    case LINK_STATE_ATTACHED:
-        if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPENING)
-        {
-            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_OPEN);
-        }
-        break;
-    case LINK_STATE_DETACHED:
-        if ((message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN) ||
-            (message_sender->message_sender_state == MESSAGE_SENDER_STATE_CLOSING))
+        payload.bytes = encoded_message->bytes;
+        payload.length = encoded_message->length;
+        result = transfer_message(message_sender, pending_send, encoded_message->message_format, &payload, 1);
+    }
+    else
+    {
+        message_format message_format;
+        unsigned char* data_bytes;
+        PAYLOAD* payloads;
+        size_t payload_count;
+
+        if (message_get_message_format(message, &message_format) != 0)
         {
-            /* User initiated transition, we should be good */
-            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_IDLE);
-            indicate_all_messages_as_error(message_sender);
+            LogError("Failure getting message format");
+            result = SEND_ONE_MESSAGE_ERROR;
         }
-        else if (message_sender->message_sender_state != MESSAGE_SENDER_STATE_IDLE)
+        else if (encode_message(message_sender, message, (GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send))->message_template, (GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send))->on_message_body_read != NULL, (GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send))->body_object, &data_bytes, &payloads, &payload_count) != 0)
         {
-            /* Any other transition must be an error */
-            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
+            LogError("Cannot encode message");
+            result = SEND_ONE_MESSAGE_ERROR;
         }
-        break;
-    case LINK_STATE_ERROR:
-        if (message_sender->message_sender_state != MESSAGE_SENDER_STATE_ERROR)
+        else
         {
-            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
-            indicate_all_messages_as_error(message_sender);
+            result = transfer_message(message_sender, pending_send, message_format, payloads, payload_count);
+
+            free(payloads);
+            if (data_bytes != NULL)
+            {
+                free(data_bytes);
+            }
         }
-        break;
     }
-}
 
-static void on_link_flow_on(void* context)
-{
-    MESSAGE_SENDER_HANDLE message_sender = (MESSAGE_SENDER_INSTANCE*)context;
-    send_all_pending_messages(message_sender);
+    return result;
 }
 
-MESSAGE_SENDER_HANDLE messagesender_create(LINK_HANDLE link, ON_MESSAGE_SENDER_STATE_CHANGED on_message_sender_state_changed, void* context)
+static unsigned char get_message_priority(MESSAGE_HANDLE message)
 {
-    MESSAGE_SENDER_INSTANCE* message_sender = (MESSAGE_SENDER_INSTANCE*)malloc(sizeof(MESSAGE_SENDER_INSTANCE));
-    if (message_sender == NULL)
-    {
-        LogError("Failed allocating message sender");
-    }
-    else
+    unsigned char result = DEFAULT_MESSAGE_PRIORITY;
+    HEADER_HANDLE header;
+
+    if ((message != NULL) &&
+        (message_get_header(message, &header) == 0) &&
+        (header != NULL))
     {
-        message_sender->messages = NULL;
-        message_sender->message_count = 0;
-        message_sender->link = link;
-        message_sender->on_message_sender_state_changed = on_message_sender_state_changed;
-        message_sender->on_message_sender_state_changed_context = context;
-        message_sender->message_sender_state = MESSAGE_SENDER_STATE_IDLE;
-        message_sender->is_trace_on = 0;
+        uint8_t priority;
+
+        /* priorities above the highest bucket share it */
+        if (header_get_priority(header, &priority) == 0)
+        {
+            result = (priority >= MESSAGE_PRIORITY_COUNT) ? (MESSAGE_PRIORITY_COUNT - 1) : priority;
+        }
+
+        header_destroy(header);
     }
 
-    return message_sender;
+    return result;
 }
 
-void messagesender_destroy(MESSAGE_SENDER_HANDLE message_sender)
+static void get_message_expiry(MESSAGE_HANDLE message, milliseconds* ttl, timestamp* absolute_expiry_time)
 {
-    if (message_sender == NULL)
+    HEADER_HANDLE header;
+    PROPERTIES_HANDLE properties;
+
+    *ttl = 0;
+    *absolute_expiry_time = 0;
+
+    if ((message_get_header(message, &header) == 0) &&
+        (header != NULL))
     {
-        LogError("NULL message_sender");
+        if (header_get_ttl(header, ttl) != 0)
+        {
+            *ttl = 0;
+        }
+
+        header_destroy(header);
     }
-    else
+
+    if ((message_get_properties(message, &properties) == 0) &&
+        (properties != NULL))
     {
-        (void)messagesender_close(message_sender);
-        indicate_all_messages_as_error(message_sender);
+        if (properties_get_absolute_expiry_time(properties, absolute_expiry_time) != 0)
+        {
+            *absolute_expiry_time = 0;
+        }
 
-        free(message_sender);
+        properties_destroy(properties);
     }
 }
 
-int messagesender_open(MESSAGE_SENDER_HANDLE message_sender)
+static void on_send_expired(void* context)
 {
-    int result;
-
+    ASYNC_OPERATION_HANDLE pending_send = (ASYNC_OPERATION_HANDLE)context;
+    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+    MESSAGE_SENDER_INSTANCE* message_sender = (MESSAGE_SENDER_INSTANCE*)message_with_callback->message_sender;
+
+    timer_wheel_destroy_timer(message_with_callback->expiry_timer);
+    message_with_callback->expiry_timer = NULL;
+
+    if (message_with_callback->message_send_state == MESSAGE_SEND_STATE_NOT_SENT)
+    {
+        ON_MESSAGE_SEND_COMPLETE on_message_send_complete = message_with_callback->on_message_send_complete;
+        void* callback_context = message_with_callback->context;
+
+        remove_pending_message(message_sender, pending_send);
+
+        complete_send(message_sender, on_message_send_complete, callback_context, MESSAGE_SEND_EXPIRED, false);
+
+        notify_ready_if_room(message_sender);
+    }
+    else
+    {
+        /* a transfer already started is left to the peer, which knows the ttl as well */
+        message_with_callback->is_expired = 1;
+    }
+}
+
+/* message is NULL for sends of an already encoded message. A send whose timer cannot be started is sent as if it did not expire */
+static void start_expiry_timer(MESSAGE_SENDER_INSTANCE* message_sender, ASYNC_OPERATION_HANDLE pending_send, MESSAGE_HANDLE message)
+{
+    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+    milliseconds ttl;
+    timestamp absolute_expiry_time;
+
+    if (message == NULL)
+    {
+        ttl = message_with_callback->encoded_message->ttl;
+        absolute_expiry_time = message_with_callback->encoded_message->absolute_expiry_time;
+    }
+    else
+    {
+        get_message_expiry(message, &ttl, &absolute_expiry_time);
+    }
+
+    if ((ttl > 0) || (absolute_expiry_time > 0))
+    {
+        tickcounter_ms_t current_ms;
+        uint64_t time_to_live_ms = (ttl > 0) ? ttl : UINT64_MAX;
+
+        if (absolute_expiry_time > 0)
+        {
+            /* the absolute expiry time is wall clock time in milliseconds since the Unix epoch, the timers run on the tick counter */
+            time_t now = get_time(NULL);
+
+            if (now == (time_t)-1)
+            {
+                LogError("Cannot get the current time, the absolute expiry time of the message is ignored");
+            }
+            else if (absolute_expiry_time <= (timestamp)now * 1000)
+            {
+                time_to_live_ms = 0;
+            }
+            else if ((uint64_t)(absolute_expiry_time - (timestamp)now * 1000) < time_to_live_ms)
+            {
+                time_to_live_ms = (uint64_t)(absolute_expiry_time - (timestamp)now * 1000);
+            }
+        }
+
+        if (time_to_live_ms == UINT64_MAX)
+        {
+            /* only an absolute expiry time that could not be used */
+        }
+        else if (tickcounter_get_current_ms(message_sender->expiry_tick_counter, &current_ms) != 0)
+        {
+            LogError("Cannot get the current time of the tick counter, the send does not expire");
+        }
+        else if ((message_with_callback->expiry_timer = timer_wheel_create_timer(message_sender->expiry_timer_wheel, on_send_expired, pending_send)) == NULL)
+        {
+            LogError("Cannot create the expiry timer, the send does not expire");
+        }
+        else if (timer_wheel_start_timer(message_with_callback->expiry_timer, (uint64_t)current_ms + time_to_live_ms) != 0)
+        {
+            LogError("Cannot start the expiry timer, the send does not expire");
+            timer_wheel_destroy_timer(message_with_callback->expiry_timer);
+            message_with_callback->expiry_timer = NULL;
+        }
+        else
+        {
+            /* expired sends are completed from timer_wheel_advance */
+        }
+    }
+}
+
+static ENCODED_MESSAGE_INSTANCE* create_encoded_message(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_HANDLE message, MESSAGE_TEMPLATE_INSTANCE* message_template, const void* body_object)
+{
+    ENCODED_MESSAGE_INSTANCE* result;
+    message_format message_format;
+    unsigned char* data_bytes;
+    PAYLOAD* payloads;
+    size_t payload_count;
+
+    if (message_get_message_format(message, &message_format) != 0)
+    {
+        LogError("Failure getting message format");
+        result = NULL;
+    }
+    else if (encode_message(message_sender, message, message_template, false, body_object, &data_bytes, &payloads, &payload_count) != 0)
+    {
+        LogError("Cannot encode message");
+        result = NULL;
+    }
+    else
+    {
+        result = REFCOUNT_TYPE_CREATE(ENCODED_MESSAGE_INSTANCE);
+        if (result == NULL)
+        {
+            LogError("Cannot allocate encoded message");
+        }
+        else
+        {
+            size_t i;
+
+            result->length = 0;
+            for (i = 0; i < payload_count; i++)
+            {
+                result->length += payloads[i].length;
+            }
+
+            /* the encoded sections and the data bytes they point at are gathered, so the message is no longer needed */
+            result->bytes = (unsigned char*)malloc(result->length > 0 ? result->length : 1);
+            if (result->bytes == NULL)
+            {
+                LogError("Cannot allocate encoded message bytes");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                size_t pos = 0;
+
+                for (i = 0; i < payload_count; i++)
+                {
+                    (void)memcpy(result->bytes + pos, payloads[i].bytes, payloads[i].length);
+                    pos += payloads[i].length;
+                }
+
+                result->message_format = message_format;
+                result->priority = get_message_priority(message);
+                get_message_expiry(message, &result->ttl, &result->absolute_expiry_time);
+            }
+        }
+
+        free(payloads);
+        if (data_bytes != NULL)
+        {
+            free(data_bytes);
+        }
+    }
+
+    return result;
+}
+
+/* sends the pending sends of the given priority (any priority when is_any_priority is set) in the order they were queued,
+   returns false once the link is busy or a send failed */
+static bool send_pending_messages(MESSAGE_SENDER_HANDLE message_sender, bool is_any_priority, unsigned char priority)
+{
+    bool result = true;
+    ASYNC_OPERATION_HANDLE pending_send = message_sender->first_message;
+
+    while (pending_send != NULL)
+    {
+        MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+
+        /* a send can settle and remove its own entry right away, so the next one is picked up first */
+        ASYNC_OPERATION_HANDLE next_pending_send = message_with_callback->next;
+
+        if ((message_with_callback->message_send_state == MESSAGE_SEND_STATE_NOT_SENT) &&
+            (is_any_priority || (message_with_callback->priority == priority)))
+        {
+            switch (send_one_message(message_sender, pending_send, message_with_callback->message))
+            {
+            default:
+                LogError("Invalid send one message result");
+                break;
+
+            case SEND_ONE_MESSAGE_ERROR:
+            {
+                ON_MESSAGE_SEND_COMPLETE on_message_send_complete = message_with_callback->on_message_send_complete;
+                void* context = message_with_callback->context;
+                remove_pending_message(message_sender, pending_send);
+
+                complete_send(message_sender, on_message_send_complete, context, MESSAGE_SEND_ERROR, false);
+
+                notify_ready_if_room(message_sender);
+                next_pending_send = NULL;
+                result = false;
+                break;
+            }
+            case SEND_ONE_MESSAGE_BUSY:
+                next_pending_send = NULL;
+                result = false;
+                break;
+
+            case SEND_ONE_MESSAGE_OK:
+                break;
+            }
+        }
+
+        pending_send = next_pending_send;
+    }
+
+    return result;
+}
+
+static void send_all_pending_messages(MESSAGE_SENDER_HANDLE message_sender)
+{
+    if (message_sender->is_priority_order_on == 0)
+    {
+        (void)send_pending_messages(message_sender, true, 0);
+    }
+    else
+    {
+        /* one pass over the pending sends per priority, each stopping as soon as the credit runs out */
+        unsigned char priority = MESSAGE_PRIORITY_COUNT;
+
+        while ((priority > 0) &&
+            send_pending_messages(message_sender, false, priority - 1))
+        {
+            priority--;
+        }
+    }
+}
+
+static void set_message_sender_state(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_SENDER_STATE new_state)
+{
+    MESSAGE_SENDER_STATE previous_state = message_sender->message_sender_state;
+    message_sender->message_sender_state = new_state;
+    if (message_sender->on_message_sender_state_changed != NULL)
+    {
+        message_sender->on_message_sender_state_changed(message_sender->on_message_sender_state_changed_context, new_state, previous_state);
+    }
+}
+
+static void indicate_all_messages_as_error(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    /* the list is detached first so that callbacks queueing new sends do not touch the entries being failed */
+    ASYNC_OPERATION_HANDLE pending_send = message_sender->first_message;
+
+    message_sender->first_message = NULL;
+    message_sender->last_message = NULL;
+    message_sender->message_count = 0;
+    message_sender->streaming_send = NULL;
+
+    if (message_sender->is_queue_depth_above)
+    {
+        message_sender->is_queue_depth_above = 0;
+        report_queue_depth(message_sender, CONNECTION_FLOW_EVENT_QUEUE_DEPTH_BELOW);
+    }
+
+    while (pending_send != NULL)
+    {
+        MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+        ASYNC_OPERATION_HANDLE next_pending_send = message_with_callback->next;
+
+        ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_PENDING_SEND, sizeof(MESSAGE_WITH_CALLBACK));
+
+        complete_send(message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_ERROR, false);
+
+        if (message_with_callback->expiry_timer != NULL)
+        {
+            timer_wheel_destroy_timer(message_with_callback->expiry_timer);
+        }
+
+        if (message_with_callback->message != NULL)
+        {
+            message_destroy(message_with_callback->message);
+        }
+
+        if (message_with_callback->encoded_message != NULL)
+        {
+            messagesender_destroy_encoded_message(message_with_callback->encoded_message);
+        }
+
+        if (message_with_callback->message_template != NULL)
+        {
+            messagesender_destroy_message_template(message_with_callback->message_template);
+        }
+        async_operation_destroy(pending_send);
+
+        pending_send = next_pending_send;
+    }
+}
+
+/* the unsettled map announced on reattach, holding the tags of the sends that were in doubt when the previous link was lost */
+static int create_unsettled_map(MESSAGE_SENDER_INSTANCE* message_sender, AMQP_VALUE* unsettled)
+{
+    int result = 0;
+    ASYNC_OPERATION_HANDLE pending_send = message_sender->first_message;
+
+    *unsettled = NULL;
+
+    while ((pending_send != NULL) &&
+        (result == 0))
+    {
+        MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+
+        if (message_with_callback->delivery_tag_length > 0)
+        {
+            if ((*unsettled == NULL) &&
+                ((*unsettled = amqpvalue_create_map()) == NULL))
+            {
+                LogError("Cannot create the unsettled map");
+                result = __FAILURE__;
+            }
+            else
+            {
+                amqp_binary delivery_tag_value;
+                AMQP_VALUE key;
+                AMQP_VALUE delivery_state;
+
+                delivery_tag_value.bytes = message_with_callback->delivery_tag_bytes;
+                delivery_tag_value.length = message_with_callback->delivery_tag_length;
+
+                key = amqpvalue_create_binary(delivery_tag_value);
+                delivery_state = amqpvalue_create_null();
+                if ((key == NULL) ||
+                    (delivery_state == NULL) ||
+                    (amqpvalue_set_map_value(*unsettled, key, delivery_state) != 0))
+                {
+                    LogError("Cannot add a delivery tag to the unsettled map");
+                    result = __FAILURE__;
+                }
+
+                if (key != NULL)
+                {
+                    amqpvalue_destroy(key);
+                }
+
+                if (delivery_state != NULL)
+                {
+                    amqpvalue_destroy(delivery_state);
+                }
+            }
+        }
+
+        pending_send = message_with_callback->next;
+    }
+
+    if ((result != 0) &&
+        (*unsettled != NULL))
+    {
+        amqpvalue_destroy(*unsettled);
+        *unsettled = NULL;
+    }
+
+    return result;
+}
+
+/* a send the peer reports with a terminal outcome in its unsettled map is completed with it instead of being sent again */
+static void complete_sends_settled_by_peer(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    AMQP_VALUE peer_unsettled;
+    ASYNC_OPERATION_HANDLE pending_send = message_sender->first_message;
+
+    if (link_get_peer_unsettled(message_sender->link, &peer_unsettled) != 0)
+    {
+        LogError("Cannot get the unsettled map of the peer");
+        peer_unsettled = NULL;
+    }
+
+    while (pending_send != NULL)
+    {
+        MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, pending_send);
+        ASYNC_OPERATION_HANDLE next_pending_send = message_with_callback->next;
+        AMQP_VALUE delivery_state = NULL;
+
+        if ((message_with_callback->delivery_tag_length > 0) &&
+            (peer_unsettled != NULL))
+        {
+            amqp_binary delivery_tag_value;
+            AMQP_VALUE key;
+
+            delivery_tag_value.bytes = message_with_callback->delivery_tag_bytes;
+            delivery_tag_value.length = message_with_callback->delivery_tag_length;
+
+            key = amqpvalue_create_binary_borrowed(delivery_tag_value);
+            if (key == NULL)
+            {
+                LogError("Cannot create the delivery tag key");
+            }
+            else
+            {
+                delivery_state = amqpvalue_get_map_value(peer_unsettled, key);
+                amqpvalue_destroy(key);
+            }
+        }
+
+        /* the send gets a new tag when it is sent again */
+        message_with_callback->delivery_tag_length = 0;
+
+        if (delivery_state != NULL)
+        {
+            AMQP_VALUE descriptor = (amqpvalue_get_type(delivery_state) == AMQP_TYPE_NULL) ? NULL : amqpvalue_get_inplace_descriptor(delivery_state);
+
+            if ((descriptor != NULL) &&
+                (is_accepted_type_by_descriptor(descriptor) ||
+                is_rejected_type_by_descriptor(descriptor) ||
+                is_released_type_by_descriptor(descriptor) ||
+                is_modified_type_by_descriptor(descriptor)))
+            {
+                ON_MESSAGE_SEND_COMPLETE on_message_send_complete = message_with_callback->on_message_send_complete;
+                void* callback_context = message_with_callback->context;
+                MESSAGE_SEND_RESULT send_result = is_accepted_type_by_descriptor(descriptor) ? MESSAGE_SEND_OK : MESSAGE_SEND_ERROR;
+
+                remove_pending_message(message_sender, pending_send);
+                complete_send(message_sender, on_message_send_complete, callback_context, send_result, false);
+            }
+
+            amqpvalue_destroy(delivery_state);
+        }
+
+        pending_send = next_pending_send;
+    }
+
+    (void)link_set_attach_unsettled(message_sender->link, NULL);
+    notify_ready_if_room(message_sender);
+}
+
+static void on_link_state_changed(void* context, LINK_STATE new_link_state, LINK_STATE previous_link_state)
+{
+    MESSAGE_SENDER_INSTANCE* message_sender = (MESSAGE_SENDER_INSTANCE*)context;
+    (void)previous_link_state;
+
+    switch (new_link_state)
+    {
+    default:
+        break;
+
+    case LINK_STATE_ATTACHED:
+        if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPENING)
+        {
+            if (message_sender->is_resume_on_link_loss == 1)
+            {
+                complete_sends_settled_by_peer(message_sender);
+            }
+
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_OPEN);
+        }
+        break;
+    case LINK_STATE_DETACHED:
+        if ((message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN) &&
+            (message_sender->is_resume_on_link_loss == 1))
+        {
+            /* the peer detached the link, the pending sends wait for messagesender_reattach */
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
+        }
+        else if ((message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN) ||
+            (message_sender->message_sender_state == MESSAGE_SENDER_STATE_CLOSING))
+        {
+            /* User initiated transition, we should be good */
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_IDLE);
+            indicate_all_messages_as_error(message_sender);
+        }
+        else if (message_sender->message_sender_state != MESSAGE_SENDER_STATE_IDLE)
+        {
+            /* Any other transition must be an error */
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
+        }
+        break;
+    case LINK_STATE_ERROR:
+        if (message_sender->message_sender_state != MESSAGE_SENDER_STATE_ERROR)
+        {
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
+            if (message_sender->is_resume_on_link_loss == 0)
+            {
+                indicate_all_messages_as_error(message_sender);
+            }
+        }
+        break;
+    }
+}
+
+static void on_link_flow_on(void* context)
+{
+    MESSAGE_SENDER_HANDLE message_sender = (MESSAGE_SENDER_INSTANCE*)context;
+    send_all_pending_messages(message_sender);
+}
+
+MESSAGE_SENDER_HANDLE messagesender_create(LINK_HANDLE link, ON_MESSAGE_SENDER_STATE_CHANGED on_message_sender_state_changed, void* context)
+{
+    MESSAGE_SENDER_INSTANCE* message_sender = (MESSAGE_SENDER_INSTANCE*)malloc(sizeof(MESSAGE_SENDER_INSTANCE));
+    if (message_sender == NULL)
+    {
+        LogError("Failed allocating message sender");
+    }
+    else
+    {
+        message_sender->first_message = NULL;
+        message_sender->last_message = NULL;
+        message_sender->message_count = 0;
+        message_sender->link = link;
+        message_sender->on_message_sender_state_changed = on_message_sender_state_changed;
+        message_sender->on_message_sender_state_changed_context = context;
+        message_sender->message_sender_state = MESSAGE_SENDER_STATE_IDLE;
+        message_sender->is_trace_on = 0;
+        message_sender->max_in_flight = 0;
+        message_sender->queue_depth_threshold = 0;
+        message_sender->on_message_sender_ready = NULL;
+        message_sender->on_message_sender_ready_context = NULL;
+        message_sender->is_ready_notification_due = 0;
+        message_sender->on_message_send_complete_batch = NULL;
+        message_sender->on_message_send_complete_batch_context = NULL;
+        message_sender->batched_completions = NULL;
+        message_sender->batched_completion_count = 0;
+        message_sender->batched_completion_capacity = 0;
+        lock_free_stack_init(&message_sender->threadsafe_sends);
+        message_sender->is_resume_on_link_loss = 0;
+        message_sender->is_priority_order_on = 0;
+        message_sender->is_queue_depth_above = 0;
+        message_sender->streaming_send = NULL;
+        message_sender->streamed_parts = NULL;
+        message_sender->streamed_piece_buffer = NULL;
+        message_sender->is_streamed_body_done = 0;
+        message_sender->send_operation_pool = NULL;
+        message_sender->expiry_timer_wheel = NULL;
+        message_sender->expiry_tick_counter = NULL;
+        message_sender->is_draining = 0;
+        message_sender->drain_tick_counter = NULL;
+        message_sender->on_body_encode = NULL;
+        message_sender->on_body_encode_context = NULL;
+        message_sender->body_content_encoding = NULL;
+        message_sender->body_encoding_min_size = 0;
+        message_sender->on_body_serialize = NULL;
+        message_sender->on_body_serialize_context = NULL;
+        message_sender->body_content_type = NULL;
+        message_sender->batching_tick_counter = NULL;
+    }
+
+    return message_sender;
+}
+
+void messagesender_destroy(MESSAGE_SENDER_HANDLE message_sender)
+{
+    if (message_sender == NULL)
+    {
+        LogError("NULL message_sender");
+    }
+    else
+    {
+        THREADSAFE_SEND* threadsafe_send;
+
+        (void)messagesender_close(message_sender);
+        indicate_all_messages_as_error(message_sender);
+
+        threadsafe_send = (THREADSAFE_SEND*)lock_free_stack_take_all(&message_sender->threadsafe_sends);
+        while (threadsafe_send != NULL)
+        {
+            THREADSAFE_SEND* next = (THREADSAFE_SEND*)threadsafe_send->stack_entry.next;
+
+            complete_send(message_sender, threadsafe_send->on_message_send_complete, threadsafe_send->callback_context, MESSAGE_SEND_ERROR, false);
+
+            message_destroy(threadsafe_send->message);
+            free(threadsafe_send);
+            threadsafe_send = next;
+        }
+
+        if (message_sender->batched_completions != NULL)
+        {
+            free(message_sender->batched_completions);
+        }
+
+        if (message_sender->body_content_encoding != NULL)
+        {
+            free(message_sender->body_content_encoding);
+        }
+
+        if (message_sender->body_content_type != NULL)
+        {
+            free(message_sender->body_content_type);
+        }
+
+        /* parts still in flight keep the tracking alive, their completions no longer reach the sender */
+        if (message_sender->streamed_parts != NULL)
+        {
+            message_sender->streamed_parts->message_sender = NULL;
+            release_streamed_parts(message_sender->streamed_parts);
+        }
+
+        if (message_sender->streamed_piece_buffer != NULL)
+        {
+            free(message_sender->streamed_piece_buffer);
+        }
+
+        if (message_sender->send_operation_pool != NULL)
+        {
+            async_operation_pool_destroy(message_sender->send_operation_pool);
+        }
+
+        free(message_sender);
+    }
+}
+
+int messagesender_open(MESSAGE_SENDER_HANDLE message_sender)
+{
+    int result;
+
+    if (message_sender == NULL)
+    {
+        LogError("NULL message_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_IDLE)
+        {
+            message_sender->is_draining = 0;
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_OPENING);
+            if (link_attach(message_sender->link, NULL, on_link_state_changed, on_link_flow_on, message_sender) != 0)
+            {
+                LogError("attach link failed");
+                result = __FAILURE__;
+                set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagesender_close(MESSAGE_SENDER_HANDLE message_sender)
+{
+    int result;
+
+    if (message_sender == NULL)
+    {
+        LogError("NULL message_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPENING) ||
+            (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN))
+        {
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_CLOSING);
+            if (link_detach(message_sender->link, true) != 0)
+            {
+                LogError("Detaching link failed");
+                result = __FAILURE__;
+                set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagesender_close_drained(MESSAGE_SENDER_HANDLE message_sender, TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t drain_timeout)
+{
+    int result;
+
+    if ((message_sender == NULL) ||
+        ((drain_timeout > 0) && (tick_counter == NULL)))
+    {
+        LogError("Bad arguments: message_sender = %p, tick_counter = %p, drain_timeout = %lu",
+            message_sender, tick_counter, (unsigned long)drain_timeout);
+        result = __FAILURE__;
+    }
+    else if ((message_sender->message_sender_state != MESSAGE_SENDER_STATE_OPEN) ||
+        (message_sender->message_count == 0))
+    {
+        /* nothing to drain */
+        result = messagesender_close(message_sender);
+    }
+    else if (message_sender->is_draining == 1)
+    {
+        result = 0;
+    }
+    else
+    {
+        tickcounter_ms_t current_ms = 0;
+
+        if ((drain_timeout > 0) &&
+            (tickcounter_get_current_ms(tick_counter, &current_ms) != 0))
+        {
+            LogError("Cannot get the current time for the drain deadline");
+            result = __FAILURE__;
+        }
+        else
+        {
+            message_sender->is_draining = 1;
+            message_sender->drain_tick_counter = tick_counter;
+            message_sender->drain_start_ms = current_ms;
+            message_sender->drain_timeout = drain_timeout;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static bool is_drain_done(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    bool result;
+
+    if (message_sender->message_count == 0)
+    {
+        result = true;
+    }
+    else if (message_sender->drain_timeout == 0)
+    {
+        result = false;
+    }
+    else
+    {
+        tickcounter_ms_t current_ms;
+
+        if (tickcounter_get_current_ms(message_sender->drain_tick_counter, &current_ms) != 0)
+        {
+            LogError("Cannot get the current time, closing without waiting for the pending sends");
+            result = true;
+        }
+        else
+        {
+            result = ((current_ms - message_sender->drain_start_ms) >= message_sender->drain_timeout);
+        }
+    }
+
+    return result;
+}
+
+static void messagesender_send_cancel_handler(ASYNC_OPERATION_HANDLE send_operation)
+{
+    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, send_operation);
+
+    if (message_with_callback->streamed_delivery != NULL)
+    {
+        /* the link aborts the streamed delivery and completes the send through on_delivery_settled */
+        message_with_callback->is_send_cancelled = 1;
+        if (async_operation_cancel(message_with_callback->streamed_delivery) != 0)
+        {
+            LogError("Cannot cancel the delivery of the streamed send");
+        }
+    }
+    else
+    {
+        complete_send(message_with_callback->message_sender, message_with_callback->on_message_send_complete, message_with_callback->context, MESSAGE_SEND_CANCELLED, false);
+
+        remove_pending_message(message_with_callback->message_sender, send_operation);
+        notify_ready_if_room(message_with_callback->message_sender);
+    }
+}
+
+static ASYNC_OPERATION_HANDLE create_send_operation(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((message_sender->send_operation_pool == NULL) &&
+        ((message_sender->send_operation_pool = CREATE_ASYNC_OPERATION_POOL(MESSAGE_WITH_CALLBACK, SEND_OPERATION_POOL_SIZE)) == NULL))
+    {
+        /* the message can still be sent, its memory is just not pooled */
+        LogError("Cannot create the send operation pool");
+        result = CREATE_ASYNC_OPERATION(MESSAGE_WITH_CALLBACK, messagesender_send_cancel_handler);
+    }
+    else
+    {
+        result = async_operation_create_from_pool(message_sender->send_operation_pool, messagesender_send_cancel_handler);
+    }
+
+    return result;
+}
+
+/* exactly one of message and encoded_message is given, message_template and on_message_body_read only with message */
+static ASYNC_OPERATION_HANDLE queue_send(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_HANDLE message, ENCODED_MESSAGE_HANDLE encoded_message, MESSAGE_TEMPLATE_HANDLE message_template, ON_MESSAGE_BODY_READ on_message_body_read, void* body_read_context, const void* body_object, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    /* a sender resuming on link loss keeps queueing while it waits for a new link */
+    if ((message_sender->message_sender_state == MESSAGE_SENDER_STATE_ERROR) &&
+        (message_sender->is_resume_on_link_loss == 0))
+    {
+        LogError("Message sender in ERROR state");
+        result = NULL;
+    }
+    else if (message_sender->is_draining == 1)
+    {
+        LogError("Message sender is being closed, it takes no new sends");
+        result = NULL;
+    }
+    else if ((message_sender->max_in_flight > 0) &&
+        (message_sender->message_count >= message_sender->max_in_flight))
+    {
+        LogError("Message sender has %u sends in flight, the maximum allowed", (unsigned int)message_sender->message_count);
+        message_sender->is_ready_notification_due = 1;
+        result = NULL;
+    }
+    else
+    {
+        result = create_send_operation(message_sender);
+        if (result == NULL)
+        {
+            LogError("Failed allocating context for send");
+        }
+        else
+        {
+            MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, result);
+
+            message_with_callback->timeout = timeout;
+            message_with_callback->delivery_tag_length = 0;
+            message_with_callback->on_message_body_read = on_message_body_read;
+            message_with_callback->body_read_context = body_read_context;
+            message_with_callback->body_object = body_object;
+            message_with_callback->streamed_delivery = NULL;
+            message_with_callback->is_body_read_failed = 0;
+            message_with_callback->is_send_cancelled = 0;
+            message_with_callback->is_expired = 0;
+            message_with_callback->expiry_timer = NULL;
+
+            if (message_sender->is_priority_order_on == 0)
+            {
+                message_with_callback->priority = DEFAULT_MESSAGE_PRIORITY;
+            }
+            else
+            {
+                message_with_callback->priority = (message == NULL) ? encoded_message->priority : get_message_priority(message);
+            }
+
+            message_with_callback->encoded_message = (encoded_message == NULL) ? NULL : messagesender_clone_encoded_message(encoded_message);
+            message_with_callback->message_template = (message_template == NULL) ? NULL : messagesender_clone_message_template(message_template);
+            if (message_sender->message_sender_state != MESSAGE_SENDER_STATE_OPEN)
+            {
+                message_with_callback->message = (message == NULL) ? NULL : message_clone(message);
+                if ((message != NULL) && (message_with_callback->message == NULL))
+                {
+                    LogError("Cannot clone message for placing it in the pending sends list");
+                    async_operation_destroy(result);
+                    result = NULL;
+                }
+
+                message_with_callback->message_send_state = MESSAGE_SEND_STATE_NOT_SENT;
+            }
+            else
+            {
+                message_with_callback->message = NULL;
+                message_with_callback->message_send_state = MESSAGE_SEND_STATE_PENDING;
+            }
+
+            if (result != NULL)
+            {
+                message_with_callback->on_message_send_complete = on_message_send_complete;
+                message_with_callback->context = callback_context;
+                message_with_callback->message_sender = message_sender;
+
+                append_pending_message(message_sender, result);
+
+                if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN)
+                {
+                    switch (send_one_message(message_sender, result, message))
+                    {
+                    default:
+                    case SEND_ONE_MESSAGE_ERROR:
+                        LogError("Error sending message");
+                        remove_pending_message(message_sender, result);
+                        result = NULL;
+                        break;
+
+                    case SEND_ONE_MESSAGE_BUSY:
+                        message_with_callback->message = (message == NULL) ? NULL : message_clone(message);
+                        if ((message != NULL) && (message_with_callback->message == NULL))
+                        {
+                            LogError("Error cloning message for placing it in the pending sends list");
+                            remove_pending_message(message_sender, result);
+                            result = NULL;
+                        }
+                        else
+                        {
+                            message_with_callback->message_send_state = MESSAGE_SEND_STATE_NOT_SENT;
+                        }
+                        break;
+
+                    case SEND_ONE_MESSAGE_OK:
+                        break;
+                    }
+                }
+
+                /* only sends left waiting for credit can expire before they are sent */
+                if ((result != NULL) &&
+                    (message_sender->expiry_timer_wheel != NULL) &&
+                    (message_with_callback->message_send_state == MESSAGE_SEND_STATE_NOT_SENT))
+                {
+                    start_expiry_timer(message_sender, result, message);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void free_encoded_body_data(void* context)
+{
+    free(context);
+}
+
+static int copy_message_sections(MESSAGE_HANDLE source_message, MESSAGE_HANDLE message)
+{
+    int result;
+    HEADER_HANDLE header;
+    delivery_annotations source_delivery_annotations;
+    message_annotations source_message_annotations;
+    AMQP_VALUE application_properties;
+    annotations footer;
+    uint32_t message_format;
+
+    /* every section but the body and the properties, which the caller sets */
+    if (message_get_header(source_message, &header) != 0)
+    {
+        LogError("Cannot get the message header");
+        result = __FAILURE__;
+    }
+    else if ((header != NULL) &&
+        (message_take_header(message, header) != 0))
+    {
+        LogError("Cannot set the message header");
+        header_destroy(header);
+        result = __FAILURE__;
+    }
+    else if (message_get_delivery_annotations(source_message, &source_delivery_annotations) != 0)
+    {
+        LogError("Cannot get the delivery annotations");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+
+        if (source_delivery_annotations != NULL)
+        {
+            if (message_set_delivery_annotations(message, source_delivery_annotations) != 0)
+            {
+                LogError("Cannot set the delivery annotations");
+                result = __FAILURE__;
+            }
+
+            annotations_destroy(source_delivery_annotations);
+        }
+
+        if ((result == 0) &&
+            (message_get_message_annotations(source_message, &source_message_annotations) != 0))
+        {
+            LogError("Cannot get the message annotations");
+            result = __FAILURE__;
+        }
+        else if ((result == 0) &&
+            (source_message_annotations != NULL))
+        {
+            if (message_set_message_annotations(message, source_message_annotations) != 0)
+            {
+                LogError("Cannot set the message annotations");
+                result = __FAILURE__;
+            }
+
+            annotations_destroy(source_message_annotations);
+        }
+
+        if ((result == 0) &&
+            (message_get_application_properties(source_message, &application_properties) != 0))
+        {
+            LogError("Cannot get the application properties");
+            result = __FAILURE__;
+        }
+        else if ((result == 0) &&
+            (application_properties != NULL))
+        {
+            if (message_set_application_properties(message, application_properties) != 0)
+            {
+                LogError("Cannot set the application properties");
+                result = __FAILURE__;
+            }
+
+            application_properties_destroy(application_properties);
+        }
+
+        if ((result == 0) &&
+            (message_get_footer(source_message, &footer) != 0))
+        {
+            LogError("Cannot get the message footer");
+            result = __FAILURE__;
+        }
+        else if ((result == 0) &&
+            (footer != NULL))
+        {
+            if (message_set_footer(message, footer) != 0)
+            {
+                LogError("Cannot set the message footer");
+                result = __FAILURE__;
+            }
+
+            annotations_destroy(footer);
+        }
+
+        if ((result == 0) &&
+            ((message_get_message_format(source_message, &message_format) != 0) ||
+             (message_set_message_format(message, message_format) != 0)))
+        {
+            LogError("Cannot copy the message format");
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+/* takes ownership of properties, the properties of message or NULL */
+static int create_body_encoded_message(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_HANDLE message, PROPERTIES_HANDLE properties, size_t body_data_count, size_t body_size, MESSAGE_HANDLE* encoded_body_message)
+{
+    int result;
+    MESSAGE_HANDLE encoded_message = message_create();
+
+    if (properties == NULL)
+    {
+        properties = properties_create();
+    }
+
+    if ((encoded_message == NULL) ||
+        (properties == NULL))
+    {
+        LogError("Cannot create the message with the encoded body");
+        result = __FAILURE__;
+    }
+    else if (copy_message_sections(message, encoded_message) != 0)
+    {
+        LogError("Cannot copy the message sections");
+        result = __FAILURE__;
+    }
+    else if (properties_set_content_encoding(properties, message_sender->body_content_encoding) != 0)
+    {
+        LogError("Cannot set the content encoding");
+        result = __FAILURE__;
+    }
+    else if (message_take_properties(encoded_message, properties) != 0)
+    {
+        LogError("Cannot set the message properties");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t encoded_body_size = 0;
+        size_t i;
+
+        properties = NULL;
+        result = 0;
+
+        for (i = 0; i < body_data_count; i++)
+        {
+            BINARY_DATA binary_data;
+            unsigned char* encoded_bytes = NULL;
+            size_t encoded_length = 0;
+
+            if (message_get_body_amqp_data_in_place(message, i, &binary_data) != 0)
+            {
+                LogError("Cannot get body AMQP data %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
+            }
+            else if (message_sender->on_body_encode(message_sender->on_body_encode_context, binary_data.bytes, binary_data.length, &encoded_bytes, &encoded_length) != 0)
+            {
+                LogError("Cannot encode body AMQP data %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
+            }
+            else
+            {
+                BINARY_DATA encoded_data;
+                encoded_data.bytes = encoded_bytes;
+                encoded_data.length = encoded_length;
+
+                if (message_add_body_amqp_data_external(encoded_message, encoded_data, free_encoded_body_data, encoded_bytes) != 0)
+                {
+                    LogError("Cannot add encoded body AMQP data %u", (unsigned int)i);
+                    free(encoded_bytes);
+                    result = __FAILURE__;
+                    break;
+                }
+                else
+                {
+                    encoded_body_size += encoded_length;
+                }
+            }
+        }
+
+        if (result == 0)
+        {
+            if (encoded_body_size < body_size)
+            {
+                *encoded_body_message = encoded_message;
+                encoded_message = NULL;
+            }
+            else
+            {
+                /* a body that does not get smaller is sent as it is */
+                *encoded_body_message = NULL;
+            }
+        }
+    }
+
+    if (properties != NULL)
+    {
+        properties_destroy(properties);
+    }
+
+    if (encoded_message != NULL)
+    {
+        message_destroy(encoded_message);
+    }
+
+    return result;
+}
+
+/* sets encoded_body_message to NULL when message is to be sent as it is */
+static int encode_message_body(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_HANDLE message, MESSAGE_HANDLE* encoded_body_message)
+{
+    int result;
+    MESSAGE_BODY_TYPE body_type;
+    PROPERTIES_HANDLE properties = NULL;
+    const char* content_encoding;
+    size_t body_data_count;
+
+    *encoded_body_message = NULL;
+
+    if ((message_get_body_type(message, &body_type) != 0) ||
+        (message_get_properties(message, &properties) != 0))
+    {
+        LogError("Cannot get the body type and properties of the message");
+        result = __FAILURE__;
+    }
+    /* only data sections are encoded, and a body that already has a content encoding is left alone */
+    else if ((body_type != MESSAGE_BODY_TYPE_DATA) ||
+        ((properties != NULL) && (properties_get_content_encoding(properties, &content_encoding) == 0)))
+    {
+        result = 0;
+    }
+    else if (message_get_body_amqp_data_count(message, &body_data_count) != 0)
+    {
+        LogError("Cannot get body AMQP data count");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t body_size = 0;
+        size_t i;
+
+        result = 0;
+
+        for (i = 0; i < body_data_count; i++)
+        {
+            BINARY_DATA binary_data;
+
+            if (message_get_body_amqp_data_in_place(message, i, &binary_data) != 0)
+            {
+                LogError("Cannot get body AMQP data %u", (unsigned int)i);
+                result = __FAILURE__;
+                break;
+            }
+            else
+            {
+                body_size += binary_data.length;
+            }
+        }
+
+        if ((result == 0) &&
+            (body_size >= message_sender->body_encoding_min_size))
+        {
+            result = create_body_encoded_message(message_sender, message, properties, body_data_count, body_size, encoded_body_message);
+            properties = NULL;
+        }
+    }
+
+    if (properties != NULL)
+    {
+        properties_destroy(properties);
+    }
+
+    return result;
+}
+
+ASYNC_OPERATION_HANDLE messagesender_send_async(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+    MESSAGE_HANDLE encoded_body_message = NULL;
+
+    if ((message_sender == NULL) ||
+        (message == NULL))
+    {
+        LogError("Bad parameters: message_sender = %p, message = %p", message_sender, message);
+        result = NULL;
+    }
+    else if ((message_sender->on_body_encode != NULL) &&
+        (encode_message_body(message_sender, message, &encoded_body_message) != 0))
+    {
+        LogError("Cannot encode the message body");
+        result = NULL;
+    }
+    else
+    {
+        if (encoded_body_message != NULL)
+        {
+            message = encoded_body_message;
+        }
+
+        if (message_sender->is_resume_on_link_loss == 1)
+        {
+            /* encoded once and kept until settled, so that sending it again on a new link does not encode it again */
+            ENCODED_MESSAGE_INSTANCE* encoded_message = create_encoded_message(message_sender, message, NULL, NULL);
+            if (encoded_message == NULL)
+            {
+                LogError("Cannot encode message");
+                result = NULL;
+            }
+            else
+            {
+                result = queue_send(message_sender, NULL, encoded_message, NULL, NULL, NULL, NULL, on_message_send_complete, callback_context, timeout);
+                messagesender_destroy_encoded_message(encoded_message);
+            }
+        }
+        else
+        {
+            result = queue_send(message_sender, message, NULL, NULL, NULL, NULL, NULL, on_message_send_complete, callback_context, timeout);
+        }
+
+        /* a pending send keeps a clone, which references the encoded bytes */
+        if (encoded_body_message != NULL)
+        {
+            message_destroy(encoded_body_message);
+        }
+    }
+
+    return result;
+}
+
+/* the receiver picks its codec from the content-type, so a body serialized by the codec of the sender has to carry it */
+static bool has_body_content_type(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_HANDLE message)
+{
+    bool result;
+    PROPERTIES_HANDLE properties;
+    const char* content_type;
+
+    if ((message_get_properties(message, &properties) != 0) ||
+        (properties == NULL))
+    {
+        result = false;
+    }
+    else
+    {
+        result = (properties_get_content_type(properties, &content_type) == 0) &&
+            (strcmp(content_type, message_sender->body_content_type) == 0);
+        properties_destroy(properties);
+    }
+
+    return result;
+}
+
+ASYNC_OPERATION_HANDLE messagesender_send_object_async(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, const void* body_object, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+    MESSAGE_BODY_TYPE body_type;
+
+    if ((message_sender == NULL) ||
+        (message == NULL) ||
+        (body_object == NULL))
+    {
+        LogError("Bad parameters: message_sender = %p, message = %p, body_object = %p", message_sender, message, body_object);
+        result = NULL;
+    }
+    else if (message_sender->on_body_serialize == NULL)
+    {
+        LogError("No body codec is set");
+        result = NULL;
+    }
+    else if ((message_get_body_type(message, &body_type) != 0) ||
+        (body_type != MESSAGE_BODY_TYPE_NONE))
+    {
+        LogError("The message of a body object cannot have a body");
+        result = NULL;
+    }
+    else if (!has_body_content_type(message_sender, message))
+    {
+        LogError("The message does not have the content type %s of the body codec", message_sender->body_content_type);
+        result = NULL;
+    }
+    else if (message_sender->is_resume_on_link_loss == 1)
+    {
+        /* serialized once when queued, so that sending it again on a new link does not need body_object */
+        ENCODED_MESSAGE_INSTANCE* encoded_message = create_encoded_message(message_sender, message, NULL, body_object);
+        if (encoded_message == NULL)
+        {
+            LogError("Cannot encode message");
+            result = NULL;
+        }
+        else
+        {
+            result = queue_send(message_sender, NULL, encoded_message, NULL, NULL, NULL, NULL, on_message_send_complete, callback_context, timeout);
+            messagesender_destroy_encoded_message(encoded_message);
+        }
+    }
+    else
+    {
+        result = queue_send(message_sender, message, NULL, NULL, NULL, NULL, body_object, on_message_send_complete, callback_context, timeout);
+    }
+
+    return result;
+}
+
+ASYNC_OPERATION_HANDLE messagesender_send_encoded_async(MESSAGE_SENDER_HANDLE message_sender, ENCODED_MESSAGE_HANDLE encoded_message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((message_sender == NULL) ||
+        (encoded_message == NULL))
+    {
+        LogError("Bad parameters: message_sender = %p, encoded_message = %p", message_sender, encoded_message);
+        result = NULL;
+    }
+    else
+    {
+        /* the pending send only takes a reference, the encoded bytes are never copied */
+        result = queue_send(message_sender, NULL, encoded_message, NULL, NULL, NULL, NULL, on_message_send_complete, callback_context, timeout);
+    }
+
+    return result;
+}
+
+ASYNC_OPERATION_HANDLE messagesender_send_streamed_async(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_BODY_READ on_message_body_read, void* body_read_context, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((message_sender == NULL) ||
+        (message == NULL) ||
+        (on_message_body_read == NULL))
+    {
+        LogError("Bad parameters: message_sender = %p, message = %p, on_message_body_read = %p",
+            message_sender, message, on_message_body_read);
+        result = NULL;
+    }
+    else if (message_sender->is_resume_on_link_loss == 1)
+    {
+        LogError("A streamed body is read only once, so its send cannot be resumed on a new link");
+        result = NULL;
+    }
+    else
+    {
+        /* the piece buffer is shared by the streamed sends of the sender, which go out one after the other */
+        if (message_sender->streamed_parts == NULL)
+        {
+            message_sender->streamed_parts = REFCOUNT_TYPE_CREATE(STREAMED_PARTS);
+            if (message_sender->streamed_parts == NULL)
+            {
+                LogError("Cannot allocate the streamed parts tracking");
+            }
+            else
+            {
+                message_sender->streamed_parts->message_sender = message_sender;
+                message_sender->streamed_parts->parts_in_flight = 0;
+            }
+        }
+
+        if ((message_sender->streamed_parts != NULL) &&
+            (message_sender->streamed_piece_buffer == NULL))
+        {
+            message_sender->streamed_piece_buffer = (unsigned char*)malloc(DATA_SECTION_HEADER_MAX_SIZE + STREAMED_BODY_PIECE_SIZE);
+            if (message_sender->streamed_piece_buffer == NULL)
+            {
+                LogError("Cannot allocate the streamed body piece buffer");
+            }
+        }
+
+        if (message_sender->streamed_piece_buffer == NULL)
+        {
+            result = NULL;
+        }
+        else
+        {
+            result = queue_send(message_sender, message, NULL, NULL, on_message_body_read, body_read_context, NULL, on_message_send_complete, callback_context, timeout);
+        }
+    }
+
+    return result;
+}
+
+int messagesender_send_settled(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((message_sender == NULL) ||
+        (message == NULL))
+    {
+        LogError("Bad parameters: message_sender = %p, message = %p", message_sender, message);
+        result = __FAILURE__;
+    }
+    else if ((message_sender->message_sender_state != MESSAGE_SENDER_STATE_OPEN) ||
+        (message_sender->is_draining == 1))
+    {
+        LogError("Message sender is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_format message_format;
+        unsigned char* data_bytes;
+        PAYLOAD* payloads;
+        size_t payload_count;
+
+        if (message_get_message_format(message, &message_format) != 0)
+        {
+            LogError("Failure getting message format");
+            result = __FAILURE__;
+        }
+        else if (encode_message(message_sender, message, NULL, false, NULL, &data_bytes, &payloads, &payload_count) != 0)
+        {
+            LogError("Cannot encode message");
+            result = __FAILURE__;
+        }
+        else
+        {
+            LINK_TRANSFER_RESULT link_transfer_result;
+
+            /* best effort: a message that finds no credit is dropped rather than queued */
+            if (link_transfer_settled(message_sender->link, message_format, payloads, payload_count, on_send_complete, callback_context, &link_transfer_result) != 0)
+            {
+                LogError("Cannot send settled message");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            free(payloads);
+            if (data_bytes != NULL)
+            {
+                free(data_bytes);
+            }
+        }
+    }
+
+    return result;
+}
+
+ASYNC_OPERATION_HANDLE messagesender_send_raw_async(MESSAGE_SENDER_HANDLE message_sender, message_format message_format, const unsigned char* bytes, size_t length, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((message_sender == NULL) ||
+        (bytes == NULL) ||
+        (length == 0))
+    {
+        LogError("Bad parameters: message_sender = %p, bytes = %p, length = %u", message_sender, bytes, (unsigned int)length);
+        result = NULL;
+    }
+    else
+    {
+        /* the bytes are copied as they are, the message they hold is never decoded */
+        ENCODED_MESSAGE_INSTANCE* encoded_message = REFCOUNT_TYPE_CREATE(ENCODED_MESSAGE_INSTANCE);
+        if (encoded_message == NULL)
+        {
+            LogError("Cannot allocate encoded message");
+            result = NULL;
+        }
+        else
+        {
+            encoded_message->bytes = (unsigned char*)malloc(length);
+            if (encoded_message->bytes == NULL)
+            {
+                LogError("Cannot allocate encoded message bytes");
+                free(encoded_message);
+                result = NULL;
+            }
+            else
+            {
+                (void)memcpy(encoded_message->bytes, bytes, length);
+                encoded_message->length = length;
+                encoded_message->message_format = message_format;
+                encoded_message->priority = DEFAULT_MESSAGE_PRIORITY;
+                encoded_message->ttl = 0;
+                encoded_message->absolute_expiry_time = 0;
+
+                result = queue_send(message_sender, NULL, encoded_message, NULL, NULL, NULL, NULL, on_message_send_complete, callback_context, timeout);
+
+                /* the pending send holds its own reference */
+                messagesender_destroy_encoded_message(encoded_message);
+            }
+        }
+    }
+
+    return result;
+}
+
+ENCODED_MESSAGE_HANDLE messagesender_create_encoded_message(MESSAGE_HANDLE message)
+{
+    ENCODED_MESSAGE_HANDLE result;
+
+    if (message == NULL)
+    {
+        LogError("NULL message");
+        result = NULL;
+    }
+    else
+    {
+        result = create_encoded_message(NULL, message, NULL, NULL);
+    }
+
+    return result;
+}
+
+ENCODED_MESSAGE_HANDLE messagesender_clone_encoded_message(ENCODED_MESSAGE_HANDLE encoded_message)
+{
+    if (encoded_message == NULL)
+    {
+        LogError("NULL encoded_message");
+    }
+    else
+    {
+        INC_REF(ENCODED_MESSAGE_INSTANCE, encoded_message);
+    }
+
+    return encoded_message;
+}
+
+void messagesender_destroy_encoded_message(ENCODED_MESSAGE_HANDLE encoded_message)
+{
+    if (encoded_message == NULL)
+    {
+        LogError("NULL encoded_message");
+    }
+    else if (DEC_REF(ENCODED_MESSAGE_INSTANCE, encoded_message) == DEC_RETURN_ZERO)
+    {
+        free(encoded_message->bytes);
+        free(encoded_message);
+    }
+}
+
+MESSAGE_TEMPLATE_HANDLE messagesender_create_message_template(MESSAGE_HANDLE message)
+{
+    MESSAGE_TEMPLATE_INSTANCE* result;
+
+    if (message == NULL)
+    {
+        LogError("NULL message");
+        result = NULL;
+    }
+    else
+    {
+        AMQP_VALUE section_values[MESSAGE_TEMPLATE_SECTION_COUNT] = { NULL, NULL, NULL, NULL };
+        HEADER_HANDLE header = NULL;
+        PROPERTIES_HANDLE properties = NULL;
+        AMQP_VALUE application_properties = NULL;
+        size_t section_sizes[MESSAGE_TEMPLATE_SECTION_COUNT] = { 0, 0, 0, 0 };
+        size_t total_size = 0;
+        bool is_error = false;
+        size_t i;
+
+        if ((message_get_header(message, &header) == 0) &&
+            (header != NULL))
+        {
+            section_values[MESSAGE_TEMPLATE_SECTION_HEADER] = amqpvalue_create_header(header);
+            is_error = (section_values[MESSAGE_TEMPLATE_SECTION_HEADER] == NULL);
+            header_destroy(header);
+        }
+
+        if (!is_error)
+        {
+            (void)message_get_message_annotations(message, &section_values[MESSAGE_TEMPLATE_SECTION_MESSAGE_ANNOTATIONS]);
+        }
+
+        if ((!is_error) &&
+            (message_get_properties(message, &properties) == 0) &&
+            (properties != NULL))
+        {
+            section_values[MESSAGE_TEMPLATE_SECTION_PROPERTIES] = amqpvalue_create_properties(properties);
+            is_error = (section_values[MESSAGE_TEMPLATE_SECTION_PROPERTIES] == NULL);
+            properties_destroy(properties);
+        }
+
+        if ((!is_error) &&
+            (message_get_application_properties(message, &application_properties) == 0) &&
+            (application_properties != NULL))
+        {
+            section_values[MESSAGE_TEMPLATE_SECTION_APPLICATION_PROPERTIES] = amqpvalue_create_application_properties(application_properties);
+            is_error = (section_values[MESSAGE_TEMPLATE_SECTION_APPLICATION_PROPERTIES] == NULL);
+            amqpvalue_destroy(application_properties);
+        }
+
+        for (i = 0; (!is_error) && (i < MESSAGE_TEMPLATE_SECTION_COUNT); i++)
+        {
+            if (section_values[i] != NULL)
+            {
+                if (amqpvalue_get_encoded_size(section_values[i], &section_sizes[i]) != 0)
+                {
+                    is_error = true;
+                }
+                else
+                {
+                    total_size += section_sizes[i];
+                }
+            }
+        }
+
+        if (is_error)
+        {
+            LogError("Cannot get the sections of the template message");
+            result = NULL;
+        }
+        else
+        {
+            result = REFCOUNT_TYPE_CREATE(MESSAGE_TEMPLATE_INSTANCE);
+            if (result == NULL)
+            {
+                LogError("Cannot allocate message template");
+            }
+            else
+            {
+                result->bytes = (unsigned char*)malloc(total_size > 0 ? total_size : 1);
+                if (result->bytes == NULL)
+                {
+                    LogError("Cannot allocate message template bytes");
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    size_t pos = 0;
+
+                    for (i = 0; i < MESSAGE_TEMPLATE_SECTION_COUNT; i++)
+                    {
+                        size_t encoded_size = 0;
+
+                        if ((section_values[i] != NULL) &&
+                            (amqpvalue_encode_to_buffer(section_values[i], result->bytes + pos, total_size - pos, &encoded_size) != 0))
+                        {
+                            LogError("Cannot encode section %u of the message template", (unsigned int)i);
+                            break;
+                        }
+
+                        result->section_offsets[i] = pos;
+                        result->section_lengths[i] = encoded_size;
+                        pos += encoded_size;
+                    }
+
+                    if (i < MESSAGE_TEMPLATE_SECTION_COUNT)
+                    {
+                        free(result->bytes);
+                        free(result);
+                        result = NULL;
+                    }
+                }
+            }
+        }
+
+        for (i = 0; i < MESSAGE_TEMPLATE_SECTION_COUNT; i++)
+        {
+            if (section_values[i] != NULL)
+            {
+                amqpvalue_destroy(section_values[i]);
+            }
+        }
+    }
+
+    return result;
+}
+
+MESSAGE_TEMPLATE_HANDLE messagesender_clone_message_template(MESSAGE_TEMPLATE_HANDLE message_template)
+{
+    if (message_template == NULL)
+    {
+        LogError("NULL message_template");
+    }
+    else
+    {
+        INC_REF(MESSAGE_TEMPLATE_INSTANCE, message_template);
+    }
+
+    return message_template;
+}
+
+void messagesender_destroy_message_template(MESSAGE_TEMPLATE_HANDLE message_template)
+{
+    if (message_template == NULL)
+    {
+        LogError("NULL message_template");
+    }
+    else if (DEC_REF(MESSAGE_TEMPLATE_INSTANCE, message_template) == DEC_RETURN_ZERO)
+    {
+        free(message_template->bytes);
+        free(message_template);
+    }
+}
+
+ASYNC_OPERATION_HANDLE messagesender_send_from_template_async(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_TEMPLATE_HANDLE message_template, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((message_sender == NULL) ||
+        (message_template == NULL) ||
+        (message == NULL))
+    {
+        LogError("Bad parameters: message_sender = %p, message_template = %p, message = %p", message_sender, message_template, message);
+        result = NULL;
+    }
+    else if (message_sender->is_resume_on_link_loss == 1)
+    {
+        /* encoded once and kept until settled, like the sends of messagesender_send_async */
+        ENCODED_MESSAGE_INSTANCE* encoded_message = create_encoded_message(message_sender, message, message_template, NULL);
+        if (encoded_message == NULL)
+        {
+            LogError("Cannot encode message");
+            result = NULL;
+        }
+        else
+        {
+            result = queue_send(message_sender, NULL, encoded_message, NULL, NULL, NULL, NULL, on_message_send_complete, callback_context, timeout);
+            messagesender_destroy_encoded_message(encoded_message);
+        }
+    }
+    else
+    {
+        result = queue_send(message_sender, message, NULL, message_template, NULL, NULL, NULL, on_message_send_complete, callback_context, timeout);
+    }
+
+    return result;
+}
+
+static int add_batched_message(MESSAGE_SENDER_INSTANCE* message_sender, MESSAGE_HANDLE batch_message, MESSAGE_HANDLE message)
+{
+    int result;
+    ENCODED_MESSAGE_INSTANCE* encoded_message = create_encoded_message(message_sender, message, NULL, NULL);
+
+    if (encoded_message == NULL)
+    {
+        LogError("Cannot encode batched message");
+        result = __FAILURE__;
+    }
+    else
+    {
+        BINARY_DATA binary_data;
+
+        /* each batched message is carried whole, all its sections encoded, as one data section of the batch */
+        binary_data.bytes = encoded_message->bytes;
+        binary_data.length = encoded_message->length;
+        if (message_add_body_amqp_data(batch_message, binary_data) != 0)
+        {
+            LogError("Cannot add batched message to the batch body");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        messagesender_destroy_encoded_message(encoded_message);
+    }
+
+    return result;
+}
+
+ASYNC_OPERATION_HANDLE messagesender_send_batch_async(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE* messages, size_t message_count, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    ASYNC_OPERATION_HANDLE result;
+
+    if ((message_sender == NULL) ||
+        (messages == NULL) ||
+        (message_count == 0))
+    {
+        LogError("Bad parameters: message_sender = %p, messages = %p, message_count = %u",
+            message_sender, messages, (unsigned int)message_count);
+        result = NULL;
+    }
+    else
+    {
+        MESSAGE_HANDLE batch_message = message_create();
+        if (batch_message == NULL)
+        {
+            LogError("Cannot create batch message");
+            result = NULL;
+        }
+        else
+        {
+            message_annotations annotations = NULL;
+
+            if (message_set_message_format(batch_message, AMQP_BATCHED_MESSAGE_FORMAT) != 0)
+            {
+                LogError("Cannot set batch message format");
+                result = NULL;
+            }
+            /* the batch envelope carries the message annotations of the first message, that is where brokers look for routing annotations such as a partition key */
+            else if ((message_get_message_annotations(messages[0], &annotations) != 0) ||
+                ((annotations != NULL) && (message_set_message_annotations(batch_message, annotations) != 0)))
+            {
+                LogError("Cannot set batch message annotations");
+                result = NULL;
+            }
+            else
+            {
+                size_t i;
+
+                for (i = 0; i < message_count; i++)
+                {
+                    if ((messages[i] == NULL) ||
+                        (add_batched_message(message_sender, batch_message, messages[i]) != 0))
+                    {
+                        LogError("Cannot add message %u to the batch", (unsigned int)i);
+                        break;
+                    }
+                }
+
+                if (i < message_count)
+                {
+                    result = NULL;
+                }
+                else
+                {
+                    /* the batch is one delivery, so the completion reports the outcome for all its messages */
+                    result = messagesender_send_async(message_sender, batch_message, on_message_send_complete, callback_context, timeout);
+                }
+            }
+
+            if (annotations != NULL)
+            {
+                annotations_destroy(annotations);
+            }
+
+            message_destroy(batch_message);
+        }
+    }
+
+    return result;
+}
+
+int messagesender_set_batched_send_complete(MESSAGE_SENDER_HANDLE message_sender, ON_MESSAGE_SEND_COMPLETE_BATCH on_message_send_complete_batch, void* context)
+{
+    int result;
+
+    if (message_sender == NULL)
+    {
+        LogError("NULL message_sender");
+        result = __FAILURE__;
+    }
+    else if (link_set_on_disposition_processed(message_sender->link, (on_message_send_complete_batch == NULL) ? NULL : on_link_disposition_processed) != 0)
+    {
+        LogError("Cannot set the disposition processed callback on the link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (message_sender->on_message_send_complete_batch != NULL)
+        {
+            flush_batched_completions(message_sender);
+        }
+
+        message_sender->on_message_send_complete_batch = on_message_send_complete_batch;
+        message_sender->on_message_send_complete_batch_context = context;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagesender_set_max_in_flight(MESSAGE_SENDER_HANDLE message_sender, size_t max_in_flight, ON_MESSAGE_SENDER_READY on_message_sender_ready, void* context)
+{
+    int result;
+
+    if (message_sender == NULL)
+    {
+        LogError("NULL message_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* sends queued before the sender opened count as well, so the limit also bounds the memory held for them */
+        message_sender->max_in_flight = max_in_flight;
+        message_sender->on_message_sender_ready = on_message_sender_ready;
+        message_sender->on_message_sender_ready_context = context;
+        if (max_in_flight == 0)
+        {
+            message_sender->is_ready_notification_due = 0;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagesender_set_queue_depth_threshold(MESSAGE_SENDER_HANDLE message_sender, size_t queue_depth_threshold)
+{
+    int result;
+
+    if (message_sender == NULL)
+    {
+        LogError("NULL message_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the next crossing is reported from the current depth, a change of threshold reports nothing itself */
+        message_sender->queue_depth_threshold = queue_depth_threshold;
+        message_sender->is_queue_depth_above = ((queue_depth_threshold != 0) && (message_sender->message_count > queue_depth_threshold)) ? 1 : 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagesender_set_adaptive_batching(MESSAGE_SENDER_HANDLE message_sender, TICK_COUNTER_HANDLE tick_counter, milliseconds latency_target, uint32_t max_batch_size, milliseconds max_batch_delay)
+{
+    int result;
+
+    if ((message_sender == NULL) ||
+        ((tick_counter != NULL) && (latency_target == 0)))
+    {
+        LogError("Bad arguments: message_sender = %p, tick_counter = %p, latency_target = %u",
+            message_sender, tick_counter, (unsigned int)latency_target);
+        result = __FAILURE__;
+    }
+    else if (tick_counter == NULL)
+    {
+        /* the connection keeps the batch size and delay last set */
+        message_sender->batching_tick_counter = NULL;
+        result = 0;
+    }
+    else
+    {
+        CONNECTION_HANDLE connection;
+        LINK_STATS link_stats;
+
+        if ((link_get_connection(message_sender->link, &connection) != 0) ||
+            (connection_get_outgoing_batch_size(connection, &message_sender->batching_size) != 0) ||
+            (connection_get_outgoing_batch_delay(connection, &message_sender->batching_delay) != 0) ||
+            (link_get_stats(message_sender->link, &link_stats) != 0) ||
+            (tickcounter_get_current_ms(tick_counter, &message_sender->batching_period_start_ms) != 0))
+        {
+            LogError("Cannot get the current batching of the connection");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* the controller starts from the batching of the connection */
+            (void)memcpy(message_sender->batching_settle_latencies, link_stats.settle_latency_histogram, sizeof(message_sender->batching_settle_latencies));
+            message_sender->batching_latency_target = latency_target;
+            message_sender->max_batching_size = max_batch_size;
+            message_sender->max_batching_delay = max_batch_delay;
+            message_sender->batching_tick_counter = tick_counter;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagesender_set_resume_on_link_loss(MESSAGE_SENDER_HANDLE message_sender, bool resume_on_link_loss)
+{
+    int result;
+
+    if (message_sender == NULL)
+    {
+        LogError("NULL message_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_sender->is_resume_on_link_loss = resume_on_link_loss ? 1 : 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagesender_set_priority_order(MESSAGE_SENDER_HANDLE message_sender, bool priority_order)
+{
+    int result;
+
     if (message_sender == NULL)
     {
-        LogError("NULL message_sender");
+        LogError("NULL message_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the priority of a send is read when it is queued, the sends already queued keep the default one */
+        message_sender->is_priority_order_on = priority_order ? 1 : 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagesender_set_message_expiry(MESSAGE_SENDER_HANDLE message_sender, TIMER_WHEEL_HANDLE timer_wheel, TICK_COUNTER_HANDLE tick_counter)
+{
+    int result;
+
+    if ((message_sender == NULL) ||
+        ((timer_wheel != NULL) && (tick_counter == NULL)))
+    {
+        LogError("Bad arguments: message_sender = %p, timer_wheel = %p, tick_counter = %p",
+            message_sender, timer_wheel, tick_counter);
         result = __FAILURE__;
     }
     else
     {
-        if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_IDLE)
+        /* the timers of the sends already queued stay on the wheel they were started on */
+        message_sender->expiry_timer_wheel = timer_wheel;
+        message_sender->expiry_tick_counter = tick_counter;
+        result = 0;
+    }
+
+    return result;
+}
+
+int messagesender_set_body_encoding(MESSAGE_SENDER_HANDLE message_sender, const char* content_encoding, size_t min_body_size, ON_MESSAGE_BODY_ENCODE on_body_encode, void* context)
+{
+    int result;
+
+    if ((message_sender == NULL) ||
+        ((content_encoding == NULL) != (on_body_encode == NULL)))
+    {
+        LogError("Bad arguments: message_sender = %p, content_encoding = %p, on_body_encode = %p",
+            message_sender, content_encoding, on_body_encode);
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* copied_content_encoding = NULL;
+
+        if ((content_encoding != NULL) &&
+            (mallocAndStrcpy_s(&copied_content_encoding, content_encoding) != 0))
         {
-            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_OPENING);
-            if (link_attach(message_sender->link, NULL, on_link_state_changed, on_link_flow_on, message_sender) != 0)
+            LogError("Cannot copy the content encoding");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message_sender->body_content_encoding != NULL)
             {
-                LogError("attach link failed");
-                result = __FAILURE__;
-                set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
+                free(message_sender->body_content_encoding);
             }
-            else
+
+            message_sender->on_body_encode = on_body_encode;
+            message_sender->on_body_encode_context = context;
+            message_sender->body_content_encoding = copied_content_encoding;
+            message_sender->body_encoding_min_size = min_body_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int messagesender_set_body_codec(MESSAGE_SENDER_HANDLE message_sender, const char* content_type, ON_MESSAGE_BODY_SERIALIZE on_body_serialize, void* context)
+{
+    int result;
+
+    if ((message_sender == NULL) ||
+        ((content_type == NULL) != (on_body_serialize == NULL)))
+    {
+        LogError("Bad arguments: message_sender = %p, content_type = %p, on_body_serialize = %p",
+            message_sender, content_type, on_body_serialize);
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* copied_content_type = NULL;
+
+        if ((content_type != NULL) &&
+            (mallocAndStrcpy_s(&copied_content_type, content_type) != 0))
+        {
+            LogError("Cannot copy the content type");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message_sender->body_content_type != NULL)
             {
-                result = 0;
+                free(message_sender->body_content_type);
             }
+
+            message_sender->on_body_serialize = on_body_serialize;
+            message_sender->on_body_serialize_context = context;
+            message_sender->body_content_type = copied_content_type;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/* the new link continues the delivery count of the old one, so its tags do not repeat those of the sends in doubt */
+static int announce_unsettled_sends(MESSAGE_SENDER_INSTANCE* message_sender, LINK_HANDLE link)
+{
+    int result;
+    sequence_no delivery_count;
+    AMQP_VALUE unsettled;
+
+    if ((link_get_delivery_count(message_sender->link, &delivery_count) != 0) ||
+        (link_set_initial_delivery_count(link, delivery_count) != 0))
+    {
+        LogError("Cannot carry the delivery count over to the new link");
+        result = __FAILURE__;
+    }
+    else if (create_unsettled_map(message_sender, &unsettled) != 0)
+    {
+        LogError("Cannot create the unsettled map");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (link_set_attach_unsettled(link, unsettled) != 0)
+        {
+            LogError("Cannot set the unsettled map on the link");
+            result = __FAILURE__;
         }
         else
         {
             result = 0;
         }
+
+        if (unsettled != NULL)
+        {
+            amqpvalue_destroy(unsettled);
+        }
     }
 
     return result;
 }
 
-int messagesender_close(MESSAGE_SENDER_HANDLE message_sender)
+int messagesender_reattach(MESSAGE_SENDER_HANDLE message_sender, LINK_HANDLE link)
 {
     int result;
 
+    if ((message_sender == NULL) ||
+        (link == NULL))
+    {
+        LogError("Bad arguments: message_sender = %p, link = %p",
+            message_sender, link);
+        result = __FAILURE__;
+    }
+    else if ((message_sender->message_sender_state != MESSAGE_SENDER_STATE_IDLE) &&
+        (message_sender->message_sender_state != MESSAGE_SENDER_STATE_ERROR))
+    {
+        LogError("Cannot reattach a message sender in state %d", (int)message_sender->message_sender_state);
+        result = __FAILURE__;
+    }
+    else if ((message_sender->on_message_send_complete_batch != NULL) &&
+        (link_set_on_disposition_processed(link, on_link_disposition_processed) != 0))
+    {
+        LogError("Cannot set the disposition processed callback on the link");
+        result = __FAILURE__;
+    }
+    else if ((message_sender->is_resume_on_link_loss == 1) &&
+        (announce_unsettled_sends(message_sender, link) != 0))
+    {
+        LogError("Cannot announce the unsettled sends on the new link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        message_sender->link = link;
+
+        if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_ERROR)
+        {
+            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_IDLE);
+        }
+
+        /* the pending sends are sent again once the new link gives credit */
+        result = messagesender_open(message_sender);
+    }
+
+    return result;
+}
+
+void messagesender_set_trace(MESSAGE_SENDER_HANDLE message_sender, bool traceOn)
+{
     if (message_sender == NULL)
     {
         LogError("NULL message_sender");
+    }
+    else
+    {
+        message_sender->is_trace_on = traceOn ? 1 : 0;
+    }
+}
+
+int messagesender_send_async_threadsafe(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    int result;
+
+    if ((message_sender == NULL) ||
+        (message == NULL))
+    {
+        LogError("Bad arguments: message_sender = %p, message = %p",
+            message_sender, message);
         result = __FAILURE__;
     }
     else
     {
-        if ((message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPENING) ||
-            (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN))
+        THREADSAFE_SEND* threadsafe_send = (THREADSAFE_SEND*)malloc(sizeof(THREADSAFE_SEND));
+        if (threadsafe_send == NULL)
         {
-            set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_CLOSING);
-            if (link_detach(message_sender->link, true) != 0)
-            {
-                LogError("Detaching link failed");
-                result = __FAILURE__;
-                set_message_sender_state(message_sender, MESSAGE_SENDER_STATE_ERROR);
-            }
-            else
-            {
-                result = 0;
-            }
+            LogError("Cannot allocate memory for the thread safe send");
+            result = __FAILURE__;
         }
         else
         {
+            /* the message is only touched again by messagesender_dowork, so it is not cloned on this thread */
+            threadsafe_send->message = message;
+            threadsafe_send->on_message_send_complete = on_message_send_complete;
+            threadsafe_send->callback_context = callback_context;
+            threadsafe_send->timeout = timeout;
+
+            lock_free_stack_push(&message_sender->threadsafe_sends, &threadsafe_send->stack_entry);
+
             result = 0;
         }
     }
@@ -820,121 +3574,165 @@ int messagesender_close(MESSAGE_SENDER_HANDLE message_sender)
     return result;
 }
 
-static void messagesender_send_cancel_handler(ASYNC_OPERATION_HANDLE send_operation)
+/* upper bound in ms of the bucket holding the 99th percentile of the latencies counted in settle_latencies, 0 if there are none */
+static uint64_t get_p99_settle_latency(const uint64_t* settle_latencies)
 {
-    MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, send_operation);
-    if (message_with_callback->on_message_send_complete != NULL)
+    uint64_t result = 0;
+    uint64_t total = 0;
+    size_t i;
+
+    for (i = 0; i < LINK_SETTLE_LATENCY_BUCKET_COUNT; i++)
     {
-        message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_CANCELLED);
+        total += settle_latencies[i];
+    }
+
+    if (total > 0)
+    {
+        /* the smallest count that is at least 99% of total */
+        uint64_t p99_count = total - (total / 100);
+        uint64_t count = 0;
+
+        for (i = 0; i < LINK_SETTLE_LATENCY_BUCKET_COUNT; i++)
+        {
+            count += settle_latencies[i];
+            if (count >= p99_count)
+            {
+                break;
+            }
+        }
+
+        /* bucket 0 is under 1 ms and bucket i under 2^i ms, the last bucket has no bound and counts as twice its start */
+        result = (uint64_t)1 << ((i < LINK_SETTLE_LATENCY_BUCKET_COUNT) ? i : (LINK_SETTLE_LATENCY_BUCKET_COUNT - 1));
     }
 
-    remove_pending_message(message_with_callback->message_sender, send_operation);
+    return result;
 }
 
-ASYNC_OPERATION_HANDLE messagesender_send_async(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+static void apply_batching(MESSAGE_SENDER_INSTANCE* message_sender, uint32_t batching_size, milliseconds batching_delay)
 {
-    ASYNC_OPERATION_HANDLE result;
+    CONNECTION_HANDLE connection;
 
-    if ((message_sender == NULL) ||
-        (message == NULL))
+    if (link_get_connection(message_sender->link, &connection) != 0)
     {
-        LogError("Bad parameters: message_sender = %p, message = %p");
-        result = NULL;
+        LogError("Cannot get the connection of the link");
     }
     else
     {
-        if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_ERROR)
+        /* setting the size flushes the outgoing batch, so it is only set when it changes */
+        if (batching_size != message_sender->batching_size)
         {
-            LogError("Message sender in ERROR state");
-            result = NULL;
+            if (connection_set_outgoing_batch_size(connection, batching_size) != 0)
+            {
+                LogError("Cannot set the outgoing batch size");
+            }
+            else
+            {
+                message_sender->batching_size = batching_size;
+            }
         }
-        else
+
+        if (batching_delay != message_sender->batching_delay)
         {
-            result = CREATE_ASYNC_OPERATION(MESSAGE_WITH_CALLBACK, messagesender_send_cancel_handler);
-            if (result == NULL)
+            if (connection_set_outgoing_batch_delay(connection, batching_delay) != 0)
             {
-                LogError("Failed allocating context for send");
+                LogError("Cannot set the outgoing batch delay");
             }
             else
             {
-                MESSAGE_WITH_CALLBACK* message_with_callback = GET_ASYNC_OPERATION_CONTEXT(MESSAGE_WITH_CALLBACK, result);
-                ASYNC_OPERATION_HANDLE* new_messages = (ASYNC_OPERATION_HANDLE*)realloc(message_sender->messages, sizeof(ASYNC_OPERATION_HANDLE) * (message_sender->message_count + 1));
-                if (new_messages == NULL)
+                message_sender->batching_delay = batching_delay;
+            }
+        }
+    }
+}
+
+/* Once per period, at least as long as the latency target, the p99 send to settle latency of the deliveries settled during
+   the period is compared to the target: over it the batch size and delay are halved, under it with sends still pending they
+   grow by an eighth of their maximum and 1 ms, which is how the most batching the target allows is found and followed as the
+   load changes. With nothing pending the delay is halved, holding writes only adds latency when no send waits behind them. */
+static void adapt_batching(MESSAGE_SENDER_INSTANCE* message_sender)
+{
+    tickcounter_ms_t current_ms;
+    milliseconds period = (message_sender->batching_latency_target < ADAPTIVE_BATCHING_MIN_PERIOD_MS) ? ADAPTIVE_BATCHING_MIN_PERIOD_MS : message_sender->batching_latency_target;
+
+    if (tickcounter_get_current_ms(message_sender->batching_tick_counter, &current_ms) != 0)
+    {
+        LogError("Cannot get the current time for adaptive batching");
+    }
+    else if ((current_ms - message_sender->batching_period_start_ms) >= period)
+    {
+        LINK_STATS link_stats;
+
+        if (link_get_stats(message_sender->link, &link_stats) != 0)
+        {
+            LogError("Cannot get the link stats for adaptive batching");
+        }
+        else
+        {
+            uint64_t period_latencies[LINK_SETTLE_LATENCY_BUCKET_COUNT];
+            uint64_t p99_latency;
+            uint32_t batching_size = message_sender->batching_size;
+            milliseconds batching_delay = message_sender->batching_delay;
+            size_t i;
+
+            for (i = 0; i < LINK_SETTLE_LATENCY_BUCKET_COUNT; i++)
+            {
+                period_latencies[i] = link_stats.settle_latency_histogram[i] - message_sender->batching_settle_latencies[i];
+                message_sender->batching_settle_latencies[i] = link_stats.settle_latency_histogram[i];
+            }
+
+            p99_latency = get_p99_settle_latency(period_latencies);
+
+            if (p99_latency > message_sender->batching_latency_target)
+            {
+                batching_size /= 2;
+                if (batching_size < ADAPTIVE_BATCHING_MIN_BATCH_SIZE)
                 {
-                    LogError("Failed allocating memory for pending sends");
-                    async_operation_destroy(result);
-                    result = NULL;
+                    batching_size = 0;
                 }
-                else
-                {
-                    message_with_callback->timeout = timeout;
-                    message_sender->messages = new_messages;
-                    if (message_sender->message_sender_state != MESSAGE_SENDER_STATE_OPEN)
-                    {
-                        message_with_callback->message = message_clone(message);
-                        if (message_with_callback->message == NULL)
-                        {
-                            LogError("Cannot clone message for placing it in the pending sends list");
-                            async_operation_destroy(result);
-                            result = NULL;
-                        }
-
-                        message_with_callback->message_send_state = MESSAGE_SEND_STATE_NOT_SENT;
-                    }
-                    else
-                    {
-                        message_with_callback->message = NULL;
-                        message_with_callback->message_send_state = MESSAGE_SEND_STATE_PENDING;
-                    }
 
-                    if (result != NULL)
-                    {
-                        message_with_callback->on_message_send_complete = on_message_send_complete;
-                        message_with_callback->context = callback_context;
-                        message_with_callback->message_sender = message_sender;
+                batching_delay /= 2;
+            }
+            else if (message_sender->message_count == 0)
+            {
+                batching_delay /= 2;
+            }
+            /* nothing settled while sends are pending says nothing about the latency, the batching is left as it is */
+            else if (p99_latency > 0)
+            {
+                uint32_t size_step = message_sender->max_batching_size / 8;
 
-                        message_sender->messages[message_sender->message_count] = result;
-                        message_sender->message_count++;
+                if (batching_size < ADAPTIVE_BATCHING_MIN_BATCH_SIZE)
+                {
+                    batching_size = ADAPTIVE_BATCHING_MIN_BATCH_SIZE;
+                }
+                else if ((message_sender->max_batching_size - batching_size) > size_step)
+                {
+                    batching_size += size_step;
+                }
+                else
+                {
+                    batching_size = message_sender->max_batching_size;
+                }
 
-                        if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN)
-                        {
-                            switch (send_one_message(message_sender, result, message))
-                            {
-                            default:
-                            case SEND_ONE_MESSAGE_ERROR:
-                                LogError("Error sending message");
-                                remove_pending_message_by_index(message_sender, message_sender->message_count - 1);
-                                result = NULL;
-                                break;
-
-                            case SEND_ONE_MESSAGE_BUSY:
-                                message_with_callback->message = message_clone(message);
-                                if (message_with_callback->message == NULL)
-                                {
-                                    LogError("Error cloning message for placing it in the pending sends list");
-                                    async_operation_destroy(result);
-                                    result = NULL;
-                                }
-                                else
-                                {
-                                    message_with_callback->message_send_state = MESSAGE_SEND_STATE_NOT_SENT;
-                                }
-                                break;
+                if (batching_size > message_sender->max_batching_size)
+                {
+                    batching_size = message_sender->max_batching_size;
+                }
 
-                            case SEND_ONE_MESSAGE_OK:
-                                break;
-                            }
-                        }
-                    }
+                if (batching_delay < message_sender->max_batching_delay)
+                {
+                    batching_delay++;
                 }
             }
+
+            apply_batching(message_sender, batching_size, batching_delay);
         }
-    }
 
-    return result;
+        message_sender->batching_period_start_ms = current_ms;
+    }
 }
 
-void messagesender_set_trace(MESSAGE_SENDER_HANDLE message_sender, bool traceOn)
+void messagesender_dowork(MESSAGE_SENDER_HANDLE message_sender)
 {
     if (message_sender == NULL)
     {
@@ -942,6 +3740,55 @@ void messagesender_set_trace(MESSAGE_SENDER_HANDLE message_sender, bool traceOn)
     }
     else
     {
-        message_sender->is_trace_on = traceOn ? 1 : 0;
+        THREADSAFE_SEND* threadsafe_send = (THREADSAFE_SEND*)lock_free_stack_take_all(&message_sender->threadsafe_sends);
+
+        while (threadsafe_send != NULL)
+        {
+            THREADSAFE_SEND* next = (THREADSAFE_SEND*)threadsafe_send->stack_entry.next;
+
+            if (messagesender_send_async(message_sender, threadsafe_send->message, threadsafe_send->on_message_send_complete, threadsafe_send->callback_context, threadsafe_send->timeout) == NULL)
+            {
+                LogError("Cannot send a message submitted from another thread");
+
+                complete_send(message_sender, threadsafe_send->on_message_send_complete, threadsafe_send->callback_context, MESSAGE_SEND_ERROR, false);
+            }
+
+            message_destroy(threadsafe_send->message);
+            free(threadsafe_send);
+            threadsafe_send = next;
+        }
+
+        if (message_sender->streaming_send != NULL)
+        {
+            send_streamed_body(message_sender);
+        }
+
+        /* sends queued behind a streamed one were refused by the link until its last part went out */
+        if (message_sender->is_streamed_body_done == 1)
+        {
+            message_sender->is_streamed_body_done = 0;
+            if (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN)
+            {
+                send_all_pending_messages(message_sender);
+            }
+        }
+
+        /* the sends left at the deadline are failed by the detach like those of messagesender_close */
+        if ((message_sender->is_draining == 1) &&
+            (message_sender->message_sender_state == MESSAGE_SENDER_STATE_OPEN) &&
+            is_drain_done(message_sender))
+        {
+            if (messagesender_close(message_sender) != 0)
+            {
+                LogError("Cannot close the drained message sender");
+            }
+        }
+
+        if (message_sender->batching_tick_counter != NULL)
+        {
+            adapt_batching(message_sender);
+        }
+
+        link_dowork(message_sender->link);
     }
 }
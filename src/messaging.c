@@ -8,6 +8,29 @@
 #include "azure_uamqp_c/amqpvalue.h"
 #include "azure_uamqp_c/amqp_definitions.h"
 
+/* descriptor codes of the transaction types, see AMQP 1.0 part 4 */
+#define COORDINATOR_DESCRIPTOR 0x30
+#define TRANSACTIONAL_STATE_DESCRIPTOR 0x34
+
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_MESSAGE
+#include "azure_uamqp_c/alloc_counters.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define ATOMIC_LOAD_ACQUIRE_POINTER(target) InterlockedCompareExchangePointer((PVOID volatile*)(target), NULL, NULL)
+#define ATOMIC_COMPARE_EXCHANGE_POINTER(target, value, comparand) InterlockedCompareExchangePointer((PVOID volatile*)(target), (value), (comparand))
+#else
+#define ATOMIC_LOAD_ACQUIRE_POINTER(target) __atomic_load_n((target), __ATOMIC_ACQUIRE)
+#define ATOMIC_COMPARE_EXCHANGE_POINTER(target, value, comparand) atomic_compare_exchange_pointer((void* volatile*)(target), (value), (comparand))
+
+/* returns the value target had, like InterlockedCompareExchangePointer */
+static void* atomic_compare_exchange_pointer(void* volatile* target, void* value, void* comparand)
+{
+    (void)__atomic_compare_exchange_n(target, &comparand, value, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return comparand;
+}
+#endif
+
 AMQP_VALUE messaging_create_source(const char* address)
 {
     AMQP_VALUE result;
@@ -129,7 +152,39 @@ AMQP_VALUE messaging_delivery_received(uint32_t section_number, uint64_t section
     return result;
 }
 
-AMQP_VALUE messaging_delivery_accepted(void)
+/* The accepted and released outcomes have no fields, so every delivery can be settled with a reference to the same value.
+   These are created the first time they are needed and are kept until the process exits. Threads racing to create one
+   publish it with a compare and exchange, the losers destroying theirs. */
+static AMQP_VALUE volatile shared_accepted_value = NULL;
+static AMQP_VALUE volatile shared_released_value = NULL;
+
+static AMQP_VALUE get_shared_value(AMQP_VALUE volatile* shared_value, AMQP_VALUE(*create_value)(void))
+{
+    AMQP_VALUE result = (AMQP_VALUE)ATOMIC_LOAD_ACQUIRE_POINTER(shared_value);
+
+    if (result == NULL)
+    {
+        AMQP_VALUE created_value = create_value();
+        if (created_value != NULL)
+        {
+            AMQP_VALUE published_value = (AMQP_VALUE)ATOMIC_COMPARE_EXCHANGE_POINTER(shared_value, created_value, NULL);
+            if (published_value == NULL)
+            {
+                result = created_value;
+            }
+            else
+            {
+                /* another thread published its value first */
+                amqpvalue_destroy(created_value);
+                result = published_value;
+            }
+        }
+    }
+
+    return result;
+}
+
+static AMQP_VALUE create_accepted_value(void)
 {
     AMQP_VALUE result;
     ACCEPTED_HANDLE accepted = accepted_create();
@@ -222,7 +277,25 @@ AMQP_VALUE messaging_delivery_rejected(const char* error_condition, const char*
     return result;
 }
 
-AMQP_VALUE messaging_delivery_released(void)
+AMQP_VALUE messaging_delivery_accepted(void)
+{
+    AMQP_VALUE result;
+    AMQP_VALUE shared_value = get_shared_value(&shared_accepted_value, create_accepted_value);
+
+    if (shared_value == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        /* cloning only takes a reference, nothing is allocated or encoded per delivery */
+        result = amqpvalue_clone(shared_value);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE create_released_value(void)
 {
     AMQP_VALUE result;
     RELEASED_HANDLE released = released_create();
@@ -249,6 +322,23 @@ AMQP_VALUE messaging_delivery_released(void)
     return result;
 }
 
+AMQP_VALUE messaging_delivery_released(void)
+{
+    AMQP_VALUE result;
+    AMQP_VALUE shared_value = get_shared_value(&shared_released_value, create_released_value);
+
+    if (shared_value == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = amqpvalue_clone(shared_value);
+    }
+
+    return result;
+}
+
 AMQP_VALUE messaging_delivery_modified(bool delivery_failed, bool undeliverable_here, fields message_annotations)
 {
     AMQP_VALUE result;
@@ -293,3 +383,81 @@ AMQP_VALUE messaging_delivery_modified(bool delivery_failed, bool undeliverable_
 
     return result;
 }
+
+AMQP_VALUE messaging_create_coordinator_target(void)
+{
+    AMQP_VALUE result = amqpvalue_create_composite_with_ulong_descriptor(COORDINATOR_DESCRIPTOR);
+
+    if (result == NULL)
+    {
+        LogError("Cannot create coordinator AMQP value");
+    }
+    else
+    {
+        AMQP_VALUE capabilities = amqpvalue_create_symbol("amqp:local-transactions");
+        if (capabilities == NULL)
+        {
+            LogError("Cannot create capabilities AMQP symbol");
+            amqpvalue_destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            if (amqpvalue_set_composite_item(result, 0, capabilities) != 0)
+            {
+                LogError("Cannot set capabilities on coordinator");
+                amqpvalue_destroy(result);
+                result = NULL;
+            }
+
+            amqpvalue_destroy(capabilities);
+        }
+    }
+
+    return result;
+}
+
+AMQP_VALUE messaging_delivery_transactional(const unsigned char* txn_id, uint32_t txn_id_length, AMQP_VALUE outcome)
+{
+    AMQP_VALUE result;
+
+    if ((txn_id == NULL) ||
+        (txn_id_length == 0))
+    {
+        LogError("Bad arguments: txn_id = %p, txn_id_length = %u", txn_id, (unsigned int)txn_id_length);
+        result = NULL;
+    }
+    else if ((result = amqpvalue_create_composite_with_ulong_descriptor(TRANSACTIONAL_STATE_DESCRIPTOR)) == NULL)
+    {
+        LogError("Cannot create transactional-state AMQP value");
+    }
+    else
+    {
+        amqp_binary txn_id_binary;
+        AMQP_VALUE txn_id_value;
+
+        txn_id_binary.bytes = txn_id;
+        txn_id_binary.length = txn_id_length;
+        txn_id_value = amqpvalue_create_binary(txn_id_binary);
+        if (txn_id_value == NULL)
+        {
+            LogError("Cannot create txn-id AMQP binary");
+            amqpvalue_destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            if ((amqpvalue_set_composite_item(result, 0, txn_id_value) != 0) ||
+                ((outcome != NULL) && (amqpvalue_set_composite_item(result, 1, outcome) != 0)))
+            {
+                LogError("Cannot set the fields of the transactional-state");
+                amqpvalue_destroy(result);
+                result = NULL;
+            }
+
+            amqpvalue_destroy(txn_id_value);
+        }
+    }
+
+    return result;
+}
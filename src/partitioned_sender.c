@@ -0,0 +1,559 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/message_sender.h"
+#include "azure_uamqp_c/partitioned_sender.h"
+
+typedef struct PARTITIONED_SEND_TAG
+{
+    /* the clone waiting to be handed to a message sender, NULL once it has been */
+    MESSAGE_HANDLE message;
+    ON_MESSAGE_SEND_COMPLETE on_message_send_complete;
+    void* callback_context;
+    struct PARTITION_TAG* partition;
+    struct PARTITIONED_SEND_TAG* next;
+} PARTITIONED_SEND;
+
+typedef struct SEND_QUEUE_TAG
+{
+    PARTITIONED_SEND* head;
+    PARTITIONED_SEND* tail;
+} SEND_QUEUE;
+
+typedef struct PARTITION_TAG
+{
+    struct PARTITIONED_SENDER_INSTANCE_TAG* partitioned_sender;
+    LINK_HANDLE link;
+    MESSAGE_SENDER_HANDLE message_sender;
+    bool is_open;
+    size_t in_flight_count;
+    /* sends whose key hashes to this partition, they cannot go anywhere else */
+    SEND_QUEUE keyed_sends;
+} PARTITION;
+
+typedef struct PARTITIONED_SENDER_INSTANCE_TAG
+{
+    PARTITION* partitions;
+    size_t partition_count;
+    size_t max_in_flight_per_partition;
+    /* sends without a key, taken by whichever partition has room first */
+    SEND_QUEUE unkeyed_sends;
+    size_t next_partition_index;
+    /* completions can come in while sends are being handed out, they only ask for another pass */
+    bool is_handing_out;
+    bool is_hand_out_pending;
+    bool is_destroying;
+} PARTITIONED_SENDER_INSTANCE;
+
+static void enqueue_send(SEND_QUEUE* send_queue, PARTITIONED_SEND* partitioned_send)
+{
+    partitioned_send->next = NULL;
+    if (send_queue->tail == NULL)
+    {
+        send_queue->head = partitioned_send;
+    }
+    else
+    {
+        send_queue->tail->next = partitioned_send;
+    }
+
+    send_queue->tail = partitioned_send;
+}
+
+static PARTITIONED_SEND* dequeue_send(SEND_QUEUE* send_queue)
+{
+    PARTITIONED_SEND* result = send_queue->head;
+    if (result != NULL)
+    {
+        send_queue->head = result->next;
+        if (send_queue->head == NULL)
+        {
+            send_queue->tail = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void complete_send(PARTITIONED_SEND* partitioned_send, MESSAGE_SEND_RESULT send_result)
+{
+    if (partitioned_send->on_message_send_complete != NULL)
+    {
+        partitioned_send->on_message_send_complete(partitioned_send->callback_context, send_result);
+    }
+
+    if (partitioned_send->message != NULL)
+    {
+        message_destroy(partitioned_send->message);
+    }
+
+    free(partitioned_send);
+}
+
+static void complete_queued_sends(SEND_QUEUE* send_queue, MESSAGE_SEND_RESULT send_result)
+{
+    PARTITIONED_SEND* partitioned_send;
+    while ((partitioned_send = dequeue_send(send_queue)) != NULL)
+    {
+        complete_send(partitioned_send, send_result);
+    }
+}
+
+/* FNV-1a, so that a key lands on the same partition in every process using this library */
+static size_t get_partition_index(PARTITIONED_SENDER_INSTANCE* partitioned_sender, const char* partition_key)
+{
+    uint32_t hash = 2166136261u;
+    const unsigned char* key_char = (const unsigned char*)partition_key;
+
+    while (*key_char != '\0')
+    {
+        hash ^= *key_char;
+        hash *= 16777619u;
+        key_char++;
+    }
+
+    return (size_t)(hash % partitioned_sender->partition_count);
+}
+
+static void hand_out_sends(PARTITIONED_SENDER_INSTANCE* partitioned_sender);
+
+static void on_partition_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+{
+    PARTITIONED_SEND* partitioned_send = (PARTITIONED_SEND*)context;
+    PARTITION* partition = partitioned_send->partition;
+    PARTITIONED_SENDER_INSTANCE* partitioned_sender = partition->partitioned_sender;
+
+    partition->in_flight_count--;
+
+    /* Codes_SRS_PARTITIONED_SENDER_01_020: [ When a send handed to a message sender completes, `on_message_send_complete` shall be called with `callback_context` and the send result, and the sends waiting for room shall be handed out again. ]*/
+    complete_send(partitioned_send, send_result);
+
+    if (!partitioned_sender->is_destroying)
+    {
+        hand_out_sends(partitioned_sender);
+    }
+}
+
+static void start_send(PARTITION* partition, PARTITIONED_SEND* partitioned_send)
+{
+    MESSAGE_HANDLE message = partitioned_send->message;
+
+    /* the message sender takes its own copy, the callback may run before messagesender_send_async returns */
+    partitioned_send->message = NULL;
+    partitioned_send->partition = partition;
+    partition->in_flight_count++;
+
+    /* Codes_SRS_PARTITIONED_SENDER_01_018: [ A waiting send shall be handed to the message sender of its partition by calling `messagesender_send_async` when that message sender is open and has fewer than `max_in_flight_per_partition` sends that have not completed, after which the clone of the message shall be destroyed. ]*/
+    if (messagesender_send_async(partition->message_sender, message, on_partition_send_complete, partitioned_send, 0) == NULL)
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_019: [ If `messagesender_send_async` fails, `on_message_send_complete` shall be called with `callback_context` and `MESSAGE_SEND_ERROR`. ]*/
+        LogError("messagesender_send_async failed");
+        partition->in_flight_count--;
+        complete_send(partitioned_send, MESSAGE_SEND_ERROR);
+    }
+
+    message_destroy(message);
+}
+
+static void hand_out_sends(PARTITIONED_SENDER_INSTANCE* partitioned_sender)
+{
+    if (partitioned_sender->is_handing_out)
+    {
+        partitioned_sender->is_hand_out_pending = true;
+    }
+    else
+    {
+        bool is_progress;
+
+        partitioned_sender->is_handing_out = true;
+        do
+        {
+            size_t i;
+
+            is_progress = false;
+            partitioned_sender->is_hand_out_pending = false;
+
+            /* one send per partition per round, so that sends without a key are spread over the partitions */
+            for (i = 0; i < partitioned_sender->partition_count; i++)
+            {
+                PARTITION* partition = &partitioned_sender->partitions[(partitioned_sender->next_partition_index + i) % partitioned_sender->partition_count];
+
+                if (partition->is_open &&
+                    (partition->in_flight_count < partitioned_sender->max_in_flight_per_partition))
+                {
+                    PARTITIONED_SEND* partitioned_send = dequeue_send(&partition->keyed_sends);
+                    if (partitioned_send == NULL)
+                    {
+                        partitioned_send = dequeue_send(&partitioned_sender->unkeyed_sends);
+                    }
+
+                    if (partitioned_send != NULL)
+                    {
+                        start_send(partition, partitioned_send);
+                        is_progress = true;
+                    }
+                }
+            }
+
+            partitioned_sender->next_partition_index = (partitioned_sender->next_partition_index + 1) % partitioned_sender->partition_count;
+        } while (is_progress || partitioned_sender->is_hand_out_pending);
+
+        partitioned_sender->is_handing_out = false;
+    }
+}
+
+static void on_partition_state_changed(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
+{
+    PARTITION* partition = (PARTITION*)context;
+    (void)previous_state;
+
+    partition->is_open = (new_state == MESSAGE_SENDER_STATE_OPEN);
+    if (new_state == MESSAGE_SENDER_STATE_ERROR)
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_022: [ When the message sender of a partition goes to `MESSAGE_SENDER_STATE_ERROR`, the sends waiting for that partition because of their key shall be completed with `MESSAGE_SEND_ERROR`. ]*/
+        complete_queued_sends(&partition->keyed_sends, MESSAGE_SEND_ERROR);
+    }
+    else if ((new_state == MESSAGE_SENDER_STATE_OPEN) &&
+        !partition->partitioned_sender->is_destroying)
+    {
+        hand_out_sends(partition->partitioned_sender);
+    }
+}
+
+static void destroy_partitions(PARTITIONED_SENDER_INSTANCE* partitioned_sender, size_t partition_count)
+{
+    size_t i;
+
+    for (i = 0; i < partition_count; i++)
+    {
+        messagesender_destroy(partitioned_sender->partitions[i].message_sender);
+        link_destroy(partitioned_sender->partitions[i].link);
+        complete_queued_sends(&partitioned_sender->partitions[i].keyed_sends, MESSAGE_SEND_CANCELLED);
+    }
+}
+
+static int create_partition(SESSION_HANDLE session, const PARTITIONED_SENDER_CONFIG* config, PARTITIONED_SENDER_INSTANCE* partitioned_sender, size_t partition_index)
+{
+    int result;
+    PARTITION* partition = &partitioned_sender->partitions[partition_index];
+    /* room for the dash and the decimal digits of any size_t */
+    size_t link_name_length = strlen(config->link_name) + 1 + 20 + 1;
+    char* link_name = (char*)malloc(link_name_length);
+
+    if (link_name == NULL)
+    {
+        LogError("Cannot allocate memory for the link name");
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)sprintf(link_name, "%s-%lu", config->link_name, (unsigned long)partition_index);
+
+        partition->partitioned_sender = partitioned_sender;
+        partition->is_open = false;
+        partition->in_flight_count = 0;
+        partition->keyed_sends.head = NULL;
+        partition->keyed_sends.tail = NULL;
+
+        if (config->sessions != NULL)
+        {
+            /* Codes_SRS_PARTITIONED_SENDER_01_027: [ If `sessions` in `config` is not NULL, the session of a partition shall be the item of `sessions` at the index of the partition, otherwise it shall be `session`. ]*/
+            session = config->sessions[partition_index];
+        }
+
+        /* Codes_SRS_PARTITIONED_SENDER_01_003: [ For each partition `partitioned_sender_create` shall create a sender link by calling `link_create` with the session of the partition, a name made of `link_name`, a dash and the partition index, `role_sender`, `source` and the target of the partition. ]*/
+        partition->link = link_create(session, link_name, role_sender, config->source, config->targets[partition_index]);
+        if (partition->link == NULL)
+        {
+            LogError("link_create failed for partition %lu", (unsigned long)partition_index);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_PARTITIONED_SENDER_01_004: [ For each partition `partitioned_sender_create` shall create a message sender on its link by calling `messagesender_create`. ]*/
+            partition->message_sender = messagesender_create(partition->link, on_partition_state_changed, partition);
+            if (partition->message_sender == NULL)
+            {
+                LogError("messagesender_create failed for partition %lu", (unsigned long)partition_index);
+                link_destroy(partition->link);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+
+        free(link_name);
+    }
+
+    return result;
+}
+
+PARTITIONED_SENDER_HANDLE partitioned_sender_create(SESSION_HANDLE session, const PARTITIONED_SENDER_CONFIG* config)
+{
+    PARTITIONED_SENDER_INSTANCE* result;
+
+    if ((config == NULL) ||
+        ((session == NULL) && (config->sessions == NULL)) ||
+        (config->link_name == NULL) ||
+        (config->targets == NULL) ||
+        (config->partition_count == 0) ||
+        (config->max_in_flight_per_partition == 0))
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_002: [ If `config` is NULL, `session` and `sessions` in `config` are both NULL, `link_name` or `targets` in `config` is NULL, or `partition_count` or `max_in_flight_per_partition` is 0, `partitioned_sender_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: session = %p, config = %p",
+            session, config);
+        result = NULL;
+    }
+    else
+    {
+        result = (PARTITIONED_SENDER_INSTANCE*)malloc(sizeof(PARTITIONED_SENDER_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_PARTITIONED_SENDER_01_005: [ If any error occurs, `partitioned_sender_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the partitioned sender");
+        }
+        else
+        {
+            result->partitions = (PARTITION*)malloc(sizeof(PARTITION) * config->partition_count);
+            if (result->partitions == NULL)
+            {
+                /* Codes_SRS_PARTITIONED_SENDER_01_005: [ If any error occurs, `partitioned_sender_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate memory for the partitions");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                size_t i;
+
+                result->partition_count = config->partition_count;
+                result->max_in_flight_per_partition = config->max_in_flight_per_partition;
+                result->unkeyed_sends.head = NULL;
+                result->unkeyed_sends.tail = NULL;
+                result->next_partition_index = 0;
+                result->is_handing_out = false;
+                result->is_hand_out_pending = false;
+                result->is_destroying = false;
+
+                for (i = 0; i < config->partition_count; i++)
+                {
+                    if (create_partition(session, config, result, i) != 0)
+                    {
+                        break;
+                    }
+                }
+
+                if (i < config->partition_count)
+                {
+                    /* Codes_SRS_PARTITIONED_SENDER_01_005: [ If any error occurs, `partitioned_sender_create` shall fail and return NULL. ]*/
+                    result->is_destroying = true;
+                    destroy_partitions(result, i);
+                    free(result->partitions);
+                    free(result);
+                    result = NULL;
+                }
+            }
+        }
+    }
+
+    /* Codes_SRS_PARTITIONED_SENDER_01_001: [ On success `partitioned_sender_create` shall return a non-NULL handle to a new partitioned sender. ]*/
+    return result;
+}
+
+void partitioned_sender_destroy(PARTITIONED_SENDER_HANDLE partitioned_sender)
+{
+    if (partitioned_sender == NULL)
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_007: [ If `partitioned_sender` is NULL, `partitioned_sender_destroy` shall do nothing. ]*/
+        LogError("NULL partitioned_sender");
+    }
+    else
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_006: [ `partitioned_sender_destroy` shall destroy the message sender and the link of each partition by calling `messagesender_destroy` and `link_destroy`, and complete the sends still waiting with `MESSAGE_SEND_CANCELLED`. ]*/
+        partitioned_sender->is_destroying = true;
+        destroy_partitions(partitioned_sender, partitioned_sender->partition_count);
+        complete_queued_sends(&partitioned_sender->unkeyed_sends, MESSAGE_SEND_CANCELLED);
+        free(partitioned_sender->partitions);
+        free(partitioned_sender);
+    }
+}
+
+int partitioned_sender_open(PARTITIONED_SENDER_HANDLE partitioned_sender)
+{
+    int result;
+
+    if (partitioned_sender == NULL)
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_009: [ If `partitioned_sender` is NULL, `partitioned_sender_open` shall fail and return a non-zero value. ]*/
+        LogError("NULL partitioned_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_PARTITIONED_SENDER_01_008: [ `partitioned_sender_open` shall open the message sender of each partition by calling `messagesender_open` and on success return 0. ]*/
+        for (i = 0; i < partitioned_sender->partition_count; i++)
+        {
+            if (messagesender_open(partitioned_sender->partitions[i].message_sender) != 0)
+            {
+                break;
+            }
+        }
+
+        if (i < partitioned_sender->partition_count)
+        {
+            /* Codes_SRS_PARTITIONED_SENDER_01_010: [ If `messagesender_open` fails, `partitioned_sender_open` shall fail and return a non-zero value. ]*/
+            LogError("messagesender_open failed for partition %lu", (unsigned long)i);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int partitioned_sender_close(PARTITIONED_SENDER_HANDLE partitioned_sender)
+{
+    int result;
+
+    if (partitioned_sender == NULL)
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_012: [ If `partitioned_sender` is NULL, `partitioned_sender_close` shall fail and return a non-zero value. ]*/
+        LogError("NULL partitioned_sender");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+
+        /* Codes_SRS_PARTITIONED_SENDER_01_011: [ `partitioned_sender_close` shall close the message sender of each partition by calling `messagesender_close` and on success return 0. ]*/
+        for (i = 0; i < partitioned_sender->partition_count; i++)
+        {
+            if (messagesender_close(partitioned_sender->partitions[i].message_sender) != 0)
+            {
+                /* Codes_SRS_PARTITIONED_SENDER_01_013: [ If `messagesender_close` fails for a partition, `partitioned_sender_close` shall still close the other partitions and then fail and return a non-zero value. ]*/
+                LogError("messagesender_close failed for partition %lu", (unsigned long)i);
+                result = __FAILURE__;
+            }
+        }
+    }
+
+    return result;
+}
+
+int partitioned_sender_send_async(PARTITIONED_SENDER_HANDLE partitioned_sender, MESSAGE_HANDLE message, const char* partition_key, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((partitioned_sender == NULL) ||
+        (message == NULL))
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_015: [ If `partitioned_sender` or `message` is NULL, `partitioned_sender_send_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: partitioned_sender = %p, message = %p",
+            partitioned_sender, message);
+        result = __FAILURE__;
+    }
+    else
+    {
+        PARTITIONED_SEND* partitioned_send = (PARTITIONED_SEND*)malloc(sizeof(PARTITIONED_SEND));
+        if (partitioned_send == NULL)
+        {
+            /* Codes_SRS_PARTITIONED_SENDER_01_021: [ If any error occurs, `partitioned_sender_send_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot allocate memory for the send");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_PARTITIONED_SENDER_01_014: [ `partitioned_sender_send_async` shall queue a clone of `message` obtained by calling `message_clone` and on success return 0. ]*/
+            partitioned_send->message = message_clone(message);
+            if (partitioned_send->message == NULL)
+            {
+                /* Codes_SRS_PARTITIONED_SENDER_01_021: [ If any error occurs, `partitioned_sender_send_async` shall fail and return a non-zero value. ]*/
+                LogError("Cannot clone the message");
+                free(partitioned_send);
+                result = __FAILURE__;
+            }
+            else
+            {
+                partitioned_send->on_message_send_complete = on_message_send_complete;
+                partitioned_send->callback_context = callback_context;
+                partitioned_send->partition = NULL;
+
+                if (partition_key != NULL)
+                {
+                    /* Codes_SRS_PARTITIONED_SENDER_01_016: [ If `partition_key` is not NULL, the send shall wait for the partition whose index is the FNV-1a hash of the characters of `partition_key` modulo the partition count. ]*/
+                    enqueue_send(&partitioned_sender->partitions[get_partition_index(partitioned_sender, partition_key)].keyed_sends, partitioned_send);
+                }
+                else
+                {
+                    /* Codes_SRS_PARTITIONED_SENDER_01_017: [ If `partition_key` is NULL, the send shall wait in a queue shared by all the partitions and be handed to the next open partition with room, going round robin over the partitions. ]*/
+                    enqueue_send(&partitioned_sender->unkeyed_sends, partitioned_send);
+                }
+
+                hand_out_sends(partitioned_sender);
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+LINK_HANDLE partitioned_sender_get_link(PARTITIONED_SENDER_HANDLE partitioned_sender, size_t partition_index)
+{
+    LINK_HANDLE result;
+
+    if ((partitioned_sender == NULL) ||
+        (partition_index >= partitioned_sender->partition_count))
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_024: [ If `partitioned_sender` is NULL or `partition_index` is not less than the partition count, `partitioned_sender_get_link` shall return NULL. ]*/
+        LogError("Bad arguments: partitioned_sender = %p, partition_index = %lu",
+            partitioned_sender, (unsigned long)partition_index);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_023: [ `partitioned_sender_get_link` shall return the link of the partition at `partition_index`. ]*/
+        result = partitioned_sender->partitions[partition_index].link;
+    }
+
+    return result;
+}
+
+void partitioned_sender_dowork(PARTITIONED_SENDER_HANDLE partitioned_sender)
+{
+    if (partitioned_sender == NULL)
+    {
+        /* Codes_SRS_PARTITIONED_SENDER_01_026: [ If `partitioned_sender` is NULL, `partitioned_sender_dowork` shall do nothing. ]*/
+        LogError("NULL partitioned_sender");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_PARTITIONED_SENDER_01_025: [ `partitioned_sender_dowork` shall call `messagesender_dowork` for the message sender of each partition. ]*/
+        for (i = 0; i < partitioned_sender->partition_count; i++)
+        {
+            messagesender_dowork(partitioned_sender->partitions[i].message_sender);
+        }
+    }
+}
@@ -100,29 +100,28 @@ static void frame_received(void* context, const unsigned char* type_specific, ui
             break;
 
         case SASL_FRAME_DECODE_FRAME:
+        {
+            size_t sasl_frame_value_size;
+
             sasl_frame_codec_instance->decoded_sasl_frame_value = NULL;
 
             /* Codes_SRS_SASL_FRAME_CODEC_01_039: [sasl_frame_codec shall decode the sasl-frame value as a described type.] */
             /* Codes_SRS_SASL_FRAME_CODEC_01_048: [Receipt of an empty frame is an irrecoverable error.] */
-            while ((frame_body_size > 0) &&
-                (sasl_frame_codec_instance->decoded_sasl_frame_value == NULL) &&
-                (sasl_frame_codec_instance->decode_state != SASL_FRAME_DECODE_ERROR))
+            /* Codes_SRS_SASL_FRAME_CODEC_01_040: [Decoding the sasl-frame type shall be done by feeding the bytes to the decoder create in sasl_frame_codec_create.] */
+            /* Codes_SRS_SASL_FRAME_CODEC_01_050: [The sasl-frame value shall be decoded with a single call to amqpvalue_decode_one.] */
+            if (amqpvalue_decode_one(sasl_frame_codec_instance->decoder, frame_body, frame_body_size, &sasl_frame_value_size) != 0)
             {
-                /* Codes_SRS_SASL_FRAME_CODEC_01_040: [Decoding the sasl-frame type shall be done by feeding the bytes to the decoder create in sasl_frame_codec_create.] */
-                if (amqpvalue_decode_bytes(sasl_frame_codec_instance->decoder, frame_body, 1) != 0)
-                {
-                    LogError("Could not decode SASL frame AMQP value");
-                    sasl_frame_codec_instance->decode_state = SASL_FRAME_DECODE_ERROR;
-                }
-                else
-                {
-                    frame_body_size--;
-                    frame_body++;
-                }
-            }
+                LogError("Could not decode SASL frame AMQP value");
+                sasl_frame_codec_instance->decode_state = SASL_FRAME_DECODE_ERROR;
 
+                /* a value decoded before the failure was destroyed when the decoder was reset */
+                sasl_frame_codec_instance->decoded_sasl_frame_value = NULL;
+
+                /* Codes_SRS_SASL_FRAME_CODEC_01_049: [If any error occurs while decoding a frame, the decoder shall call the on_sasl_frame_codec_error and pass to it the callback_context, both of those being the ones given to sasl_frame_codec_create.] */
+                sasl_frame_codec_instance->on_sasl_frame_codec_error(sasl_frame_codec_instance->callback_context);
+            }
             /* Codes_SRS_SASL_FRAME_CODEC_01_009: [The frame body of a SASL frame MUST contain exactly one AMQP type, whose type encoding MUST have provides="sasl-frame".] */
-            if (frame_body_size > 0)
+            else if (sasl_frame_value_size < frame_body_size)
             {
                 LogError("More than one AMQP value detected in SASL frame");
                 sasl_frame_codec_instance->decode_state = SASL_FRAME_DECODE_ERROR;
@@ -130,6 +129,10 @@ static void frame_received(void* context, const unsigned char* type_specific, ui
                 /* Codes_SRS_SASL_FRAME_CODEC_01_049: [If any error occurs while decoding a frame, the decoder shall call the on_sasl_frame_codec_error and pass to it the callback_context, both of those being the ones given to sasl_frame_codec_create.] */
                 sasl_frame_codec_instance->on_sasl_frame_codec_error(sasl_frame_codec_instance->callback_context);
             }
+            else
+            {
+                /* the whole frame body was the sasl-frame value */
+            }
 
             if (sasl_frame_codec_instance->decode_state != SASL_FRAME_DECODE_ERROR)
             {
@@ -139,6 +142,7 @@ static void frame_received(void* context, const unsigned char* type_specific, ui
             }
             break;
         }
+        }
     }
 }
 
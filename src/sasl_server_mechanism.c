@@ -2,17 +2,111 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_uamqp_c/sasl_server_mechanism.h"
+#include "azure_uamqp_c/sasl_server_verdict_cache.h"
 
 typedef struct SASL_SERVER_MECHANISM_INSTANCE_TAG
 {
     const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION* sasl_server_mechanism_interface_description;
     CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism;
+    SASL_SERVER_VERDICT_CACHE_HANDLE verdict_cache;
+    bool is_operation_pending;
+    ON_SASL_SERVER_MECHANISM_COMPLETE on_complete;
+    void* on_complete_context;
+    /* copy of the initial response being checked (followed by the hostname, if any) whose verdict goes to the cache */
+    unsigned char* pending_initial_response;
+    uint32_t pending_initial_response_length;
+    const char* pending_hostname;
 } SASL_SERVER_MECHANISM_INSTANCE;
 
+static void on_concrete_mechanism_complete(void* context, SASL_SERVER_MECHANISM_OUTCOME outcome, const SASL_SERVER_MECHANISM_BYTES* challenge_bytes)
+{
+    SASL_SERVER_MECHANISM_INSTANCE* sasl_server_mechanism = (SASL_SERVER_MECHANISM_INSTANCE*)context;
+    ON_SASL_SERVER_MECHANISM_COMPLETE on_complete = sasl_server_mechanism->on_complete;
+    void* on_complete_context = sasl_server_mechanism->on_complete_context;
+
+    if (sasl_server_mechanism->pending_initial_response != NULL)
+    {
+        if ((sasl_server_mechanism->verdict_cache != NULL) &&
+            ((outcome == SASL_SERVER_MECHANISM_OUTCOME_OK) ||
+             (outcome == SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED)))
+        {
+            SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+
+            initial_response_bytes.bytes = sasl_server_mechanism->pending_initial_response;
+            initial_response_bytes.length = sasl_server_mechanism->pending_initial_response_length;
+
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_032: [ When a verdict cache is set and the outcome of an initial response is `SASL_SERVER_MECHANISM_OUTCOME_OK` or `SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED`, the outcome shall be stored by calling `sasl_server_verdict_cache_store` with the mechanism name, the hostname and the initial response bytes. ]*/
+            if (sasl_server_verdict_cache_store(sasl_server_mechanism->verdict_cache, sasl_server_mechanism->sasl_server_mechanism_interface_description->get_mechanism_name(),
+                sasl_server_mechanism->pending_hostname, &initial_response_bytes, outcome) != 0)
+            {
+                /* Codes_SRS_SASL_SERVER_MECHANISM_01_033: [ If `sasl_server_verdict_cache_store` fails, the outcome shall still be indicated. ]*/
+                LogError("Cannot cache the SASL verdict");
+            }
+        }
+
+        free(sasl_server_mechanism->pending_initial_response);
+        sasl_server_mechanism->pending_initial_response = NULL;
+    }
+
+    /* Codes_SRS_SASL_SERVER_MECHANISM_01_031: [ When the concrete mechanism completes, the `on_complete` callback shall be called with `on_complete_context`, the outcome and the challenge bytes, after the mechanism stopped being busy so that the callback can hand in the next response. ]*/
+    sasl_server_mechanism->is_operation_pending = false;
+    on_complete(on_complete_context, outcome, challenge_bytes);
+}
+
+static void complete_synchronous_step(SASL_SERVER_MECHANISM_INSTANCE* sasl_server_mechanism, bool send_challenge, const SASL_SERVER_MECHANISM_BYTES* challenge_bytes)
+{
+    if (send_challenge)
+    {
+        on_concrete_mechanism_complete(sasl_server_mechanism, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, challenge_bytes);
+    }
+    else
+    {
+        on_concrete_mechanism_complete(sasl_server_mechanism, SASL_SERVER_MECHANISM_OUTCOME_OK, NULL);
+    }
+}
+
+static int copy_pending_initial_response(SASL_SERVER_MECHANISM_INSTANCE* sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, const char* hostname)
+{
+    int result;
+    size_t hostname_size = (hostname == NULL) ? 0 : strlen(hostname) + 1;
+
+    sasl_server_mechanism->pending_initial_response = (unsigned char*)malloc((size_t)initial_response_bytes->length + hostname_size + 1);
+    if (sasl_server_mechanism->pending_initial_response == NULL)
+    {
+        LogError("Cannot copy the initial response");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (initial_response_bytes->length > 0)
+        {
+            (void)memcpy(sasl_server_mechanism->pending_initial_response, initial_response_bytes->bytes, initial_response_bytes->length);
+        }
+
+        sasl_server_mechanism->pending_initial_response_length = initial_response_bytes->length;
+
+        if (hostname == NULL)
+        {
+            sasl_server_mechanism->pending_hostname = NULL;
+        }
+        else
+        {
+            (void)memcpy(sasl_server_mechanism->pending_initial_response + initial_response_bytes->length, hostname, hostname_size);
+            sasl_server_mechanism->pending_hostname = (const char*)sasl_server_mechanism->pending_initial_response + initial_response_bytes->length;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
 SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism_create(const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION* sasl_server_mechanism_interface_description, void* sasl_server_mechanism_create_parameters)
 {
     SASL_SERVER_MECHANISM_HANDLE result;
@@ -30,6 +124,7 @@ SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism_create(const SASL_SERVER_MECH
         (sasl_server_mechanism_interface_description->get_mechanism_name == NULL))
     {
         /* Codes_SRS_SASL_SERVER_MECHANISM_01_005: [ If any `sasl_server_mechanism_interface_description` member is NULL, `sasl_server_mechanism_create` shall fail and return NULL.]*/
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_023: [ The `handle_initial_response_async` and `handle_response_async` members are optional and may be NULL. ]*/
         LogError("Bad interface, create = %p, destroy = %p, handle_initial_response = %p, handle_response = %p, get_mechanism_name = %p",
             sasl_server_mechanism_interface_description->create,
             sasl_server_mechanism_interface_description->destroy,
@@ -50,6 +145,9 @@ SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism_create(const SASL_SERVER_MECH
         else
         {
             result->sasl_server_mechanism_interface_description = sasl_server_mechanism_interface_description;
+            result->verdict_cache = NULL;
+            result->is_operation_pending = false;
+            result->pending_initial_response = NULL;
 
             /* Codes_SRS_SASL_SERVER_MECHANISM_01_002: [ In order to instantiate the concrete SASL server mechanism implementation the function `create` from the `sasl_server_mechanism_interface_description` shall be called, passing the `sasl_server_mechanism_create_parameters` to it.]*/
             result->concrete_sasl_server_mechanism = result->sasl_server_mechanism_interface_description->create(sasl_server_mechanism_create_parameters);
@@ -78,6 +176,11 @@ void sasl_server_mechanism_destroy(SASL_SERVER_MECHANISM_HANDLE sasl_server_mech
         /* Codes_SRS_SASL_SERVER_MECHANISM_01_008: [ `sasl_server_mechanism_destroy` shall also call the `destroy` function that is member of the `sasl_mechanism_interface_description` argument passed to `sasl_server_mechanism_create`, while passing as argument to `destroy` the result of the underlying concrete SASL mechanism handle. ]*/
         sasl_server_mechanism->sasl_server_mechanism_interface_description->destroy(sasl_server_mechanism->concrete_sasl_server_mechanism);
         /* Codes_SRS_SASL_SERVER_MECHANISM_01_007: [ `sasl_server_mechanism_destroy` shall free all resources associated with the SASL mechanism handle. ]*/
+        if (sasl_server_mechanism->pending_initial_response != NULL)
+        {
+            free(sasl_server_mechanism->pending_initial_response);
+        }
+
         free(sasl_server_mechanism);
     }
 }
@@ -164,3 +267,163 @@ const char* sasl_server_mechanism_get_mechanism_name(SASL_SERVER_MECHANISM_HANDL
 
     return result;
 }
+
+int sasl_server_mechanism_handle_initial_response_async(SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, const char* hostname, ON_SASL_SERVER_MECHANISM_COMPLETE on_complete, void* on_complete_context)
+{
+    int result;
+    SASL_SERVER_MECHANISM_OUTCOME cached_outcome;
+
+    if ((sasl_server_mechanism == NULL) ||
+        (on_complete == NULL))
+    {
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_024: [ If the argument `sasl_server_mechanism` or `on_complete` is NULL, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: sasl_server_mechanism = %p, on_complete = %p",
+            sasl_server_mechanism, on_complete);
+        result = __FAILURE__;
+    }
+    else if (sasl_server_mechanism->is_operation_pending)
+    {
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_025: [ If a response is still being handled, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value. ]*/
+        LogError("A response is still being handled");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_SASL_SERVER_MECHANISM_01_026: [ If a verdict cache is set, `sasl_server_mechanism_handle_initial_response_async` shall look the initial response up by calling `sasl_server_verdict_cache_lookup` with the mechanism name, `hostname` and `initial_response_bytes`; when a verdict is found `on_complete` shall be called with it and 0 returned, without calling the concrete mechanism. ]*/
+    else if ((sasl_server_mechanism->verdict_cache != NULL) &&
+        (initial_response_bytes != NULL) &&
+        sasl_server_verdict_cache_lookup(sasl_server_mechanism->verdict_cache, sasl_server_mechanism->sasl_server_mechanism_interface_description->get_mechanism_name(), hostname, initial_response_bytes, &cached_outcome))
+    {
+        on_complete(on_complete_context, cached_outcome, NULL);
+        result = 0;
+    }
+    else if ((sasl_server_mechanism->verdict_cache != NULL) &&
+        (initial_response_bytes != NULL) &&
+        (copy_pending_initial_response(sasl_server_mechanism, initial_response_bytes, hostname) != 0))
+    {
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_030: [ If copying the initial response to cache its verdict fails, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        sasl_server_mechanism->is_operation_pending = true;
+        sasl_server_mechanism->on_complete = on_complete;
+        sasl_server_mechanism->on_complete_context = on_complete_context;
+
+        if (sasl_server_mechanism->sasl_server_mechanism_interface_description->handle_initial_response_async != NULL)
+        {
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_027: [ If the concrete mechanism has a `handle_initial_response_async`, `sasl_server_mechanism_handle_initial_response_async` shall call it, passing `initial_response_bytes`, `hostname` and a completion callback of its own. ]*/
+            result = sasl_server_mechanism->sasl_server_mechanism_interface_description->handle_initial_response_async(sasl_server_mechanism->concrete_sasl_server_mechanism, initial_response_bytes, hostname, on_concrete_mechanism_complete, sasl_server_mechanism);
+        }
+        else
+        {
+            bool send_challenge;
+            SASL_SERVER_MECHANISM_BYTES challenge_bytes;
+
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_028: [ Otherwise `sasl_server_mechanism_handle_initial_response_async` shall call `handle_initial_response` and complete right away, with `SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE` and the challenge bytes when a challenge is to be sent and with `SASL_SERVER_MECHANISM_OUTCOME_OK` otherwise. ]*/
+            result = sasl_server_mechanism->sasl_server_mechanism_interface_description->handle_initial_response(sasl_server_mechanism->concrete_sasl_server_mechanism, initial_response_bytes, hostname, &send_challenge, &challenge_bytes);
+            if (result == 0)
+            {
+                complete_synchronous_step(sasl_server_mechanism, send_challenge, &challenge_bytes);
+            }
+        }
+
+        if (result != 0)
+        {
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_029: [ If the underlying call fails, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value, without calling `on_complete`. ]*/
+            LogError("handle_initial_response failed");
+            sasl_server_mechanism->is_operation_pending = false;
+            if (sasl_server_mechanism->pending_initial_response != NULL)
+            {
+                free(sasl_server_mechanism->pending_initial_response);
+                sasl_server_mechanism->pending_initial_response = NULL;
+            }
+
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_034: [ On success, `sasl_server_mechanism_handle_initial_response_async` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int sasl_server_mechanism_handle_response_async(SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* response_bytes, ON_SASL_SERVER_MECHANISM_COMPLETE on_complete, void* on_complete_context)
+{
+    int result;
+
+    if ((sasl_server_mechanism == NULL) ||
+        (on_complete == NULL))
+    {
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_035: [ If the argument `sasl_server_mechanism` or `on_complete` is NULL, `sasl_server_mechanism_handle_response_async` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: sasl_server_mechanism = %p, on_complete = %p",
+            sasl_server_mechanism, on_complete);
+        result = __FAILURE__;
+    }
+    else if (sasl_server_mechanism->is_operation_pending)
+    {
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_036: [ If a response is still being handled, `sasl_server_mechanism_handle_response_async` shall fail and return a non-zero value. ]*/
+        LogError("A response is still being handled");
+        result = __FAILURE__;
+    }
+    else
+    {
+        sasl_server_mechanism->is_operation_pending = true;
+        sasl_server_mechanism->on_complete = on_complete;
+        sasl_server_mechanism->on_complete_context = on_complete_context;
+
+        if (sasl_server_mechanism->sasl_server_mechanism_interface_description->handle_response_async != NULL)
+        {
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_037: [ If the concrete mechanism has a `handle_response_async`, `sasl_server_mechanism_handle_response_async` shall call it, passing `response_bytes` and a completion callback of its own. ]*/
+            result = sasl_server_mechanism->sasl_server_mechanism_interface_description->handle_response_async(sasl_server_mechanism->concrete_sasl_server_mechanism, response_bytes, on_concrete_mechanism_complete, sasl_server_mechanism);
+        }
+        else
+        {
+            bool send_next_challenge;
+            SASL_SERVER_MECHANISM_BYTES next_challenge_bytes;
+
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_038: [ Otherwise `sasl_server_mechanism_handle_response_async` shall call `handle_response` and complete right away, with `SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE` and the challenge bytes when a challenge is to be sent and with `SASL_SERVER_MECHANISM_OUTCOME_OK` otherwise. ]*/
+            result = sasl_server_mechanism->sasl_server_mechanism_interface_description->handle_response(sasl_server_mechanism->concrete_sasl_server_mechanism, response_bytes, &send_next_challenge, &next_challenge_bytes);
+            if (result == 0)
+            {
+                complete_synchronous_step(sasl_server_mechanism, send_next_challenge, &next_challenge_bytes);
+            }
+        }
+
+        if (result != 0)
+        {
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_039: [ If the underlying call fails, `sasl_server_mechanism_handle_response_async` shall fail and return a non-zero value, without calling `on_complete`. ]*/
+            LogError("handle_response failed");
+            sasl_server_mechanism->is_operation_pending = false;
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_SASL_SERVER_MECHANISM_01_040: [ On success, `sasl_server_mechanism_handle_response_async` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int sasl_server_mechanism_set_verdict_cache(SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism, SASL_SERVER_VERDICT_CACHE_HANDLE verdict_cache)
+{
+    int result;
+
+    if (sasl_server_mechanism == NULL)
+    {
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_042: [ If the argument `sasl_server_mechanism` is NULL, `sasl_server_mechanism_set_verdict_cache` shall fail and return a non-zero value. ]*/
+        LogError("NULL sasl_server_mechanism");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_SASL_SERVER_MECHANISM_01_041: [ `sasl_server_mechanism_set_verdict_cache` shall make the following initial responses use `verdict_cache` (none when NULL) and return 0. ]*/
+        sasl_server_mechanism->verdict_cache = verdict_cache;
+        result = 0;
+    }
+
+    return result;
+}
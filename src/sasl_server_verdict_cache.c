@@ -0,0 +1,331 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_uamqp_c/sasl_server_verdict_cache.h"
+
+typedef struct CACHED_VERDICT_TAG
+{
+    /* mechanism name and hostname, both with their terminator, followed by the initial response bytes */
+    unsigned char* key;
+    size_t key_length;
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    tickcounter_ms_t expiry_ms;
+} CACHED_VERDICT;
+
+typedef struct SASL_SERVER_VERDICT_CACHE_INSTANCE_TAG
+{
+    TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t time_to_live_ms;
+    /* slots with a NULL key are free */
+    CACHED_VERDICT* verdicts;
+    size_t max_entries;
+} SASL_SERVER_VERDICT_CACHE_INSTANCE;
+
+static size_t get_key_length(const char* mechanism_name, const char* hostname, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes)
+{
+    return strlen(mechanism_name) + 1 + strlen(hostname) + 1 + initial_response_bytes->length;
+}
+
+static bool key_matches(const CACHED_VERDICT* cached_verdict, const char* mechanism_name, const char* hostname, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, size_t key_length)
+{
+    bool result;
+
+    if ((cached_verdict->key == NULL) ||
+        (cached_verdict->key_length != key_length))
+    {
+        result = false;
+    }
+    else
+    {
+        size_t mechanism_name_size = strlen(mechanism_name) + 1;
+        size_t hostname_size = strlen(hostname) + 1;
+
+        result = (memcmp(cached_verdict->key, mechanism_name, mechanism_name_size) == 0) &&
+            (memcmp(cached_verdict->key + mechanism_name_size, hostname, hostname_size) == 0) &&
+            ((initial_response_bytes->length == 0) ||
+             (memcmp(cached_verdict->key + mechanism_name_size + hostname_size, initial_response_bytes->bytes, initial_response_bytes->length) == 0));
+    }
+
+    return result;
+}
+
+static void free_cached_verdict(CACHED_VERDICT* cached_verdict)
+{
+    free(cached_verdict->key);
+    cached_verdict->key = NULL;
+}
+
+SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache_create(size_t max_entries, tickcounter_ms_t time_to_live_ms)
+{
+    SASL_SERVER_VERDICT_CACHE_INSTANCE* result;
+
+    if ((max_entries == 0) ||
+        (time_to_live_ms == 0))
+    {
+        /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_002: [ If `max_entries` or `time_to_live_ms` is 0, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: max_entries = %u, time_to_live_ms = %u",
+            (unsigned int)max_entries, (unsigned int)time_to_live_ms);
+        result = NULL;
+    }
+    else
+    {
+        result = (SASL_SERVER_VERDICT_CACHE_INSTANCE*)malloc(sizeof(SASL_SERVER_VERDICT_CACHE_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_003: [ If allocating memory or `tickcounter_create` fails, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the SASL server verdict cache");
+        }
+        else
+        {
+            /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_001: [ `sasl_server_verdict_cache_create` shall create an empty cache with room for `max_entries` verdicts and a tick counter obtained by calling `tickcounter_create`, and on success return a non-NULL handle to it. ]*/
+            result->verdicts = (CACHED_VERDICT*)malloc(sizeof(CACHED_VERDICT) * max_entries);
+            if (result->verdicts == NULL)
+            {
+                /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_003: [ If allocating memory or `tickcounter_create` fails, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate memory for the cached verdicts");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->tick_counter = tickcounter_create();
+                if (result->tick_counter == NULL)
+                {
+                    /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_003: [ If allocating memory or `tickcounter_create` fails, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+                    LogError("Cannot create the tick counter");
+                    free(result->verdicts);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    size_t i;
+
+                    for (i = 0; i < max_entries; i++)
+                    {
+                        result->verdicts[i].key = NULL;
+                    }
+
+                    result->max_entries = max_entries;
+                    result->time_to_live_ms = time_to_live_ms;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void sasl_server_verdict_cache_destroy(SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache)
+{
+    if (sasl_server_verdict_cache == NULL)
+    {
+        /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_005: [ If `sasl_server_verdict_cache` is NULL, `sasl_server_verdict_cache_destroy` shall do nothing. ]*/
+        LogError("NULL sasl_server_verdict_cache");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_004: [ `sasl_server_verdict_cache_destroy` shall free all cached verdicts, destroy the tick counter by calling `tickcounter_destroy` and free the cache. ]*/
+        for (i = 0; i < sasl_server_verdict_cache->max_entries; i++)
+        {
+            if (sasl_server_verdict_cache->verdicts[i].key != NULL)
+            {
+                free_cached_verdict(&sasl_server_verdict_cache->verdicts[i]);
+            }
+        }
+
+        tickcounter_destroy(sasl_server_verdict_cache->tick_counter);
+        free(sasl_server_verdict_cache->verdicts);
+        free(sasl_server_verdict_cache);
+    }
+}
+
+bool sasl_server_verdict_cache_lookup(SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache, const char* mechanism_name, const char* hostname, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME* outcome)
+{
+    bool result;
+    tickcounter_ms_t current_ms;
+
+    if ((sasl_server_verdict_cache == NULL) ||
+        (mechanism_name == NULL) ||
+        (initial_response_bytes == NULL) ||
+        ((initial_response_bytes->bytes == NULL) && (initial_response_bytes->length > 0)) ||
+        (outcome == NULL))
+    {
+        /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_006: [ If `sasl_server_verdict_cache`, `mechanism_name`, `initial_response_bytes` or `outcome` is NULL, or `initial_response_bytes` has a NULL `bytes` and a non-zero `length`, `sasl_server_verdict_cache_lookup` shall return false. ]*/
+        LogError("Bad arguments: sasl_server_verdict_cache = %p, mechanism_name = %p, initial_response_bytes = %p, outcome = %p",
+            sasl_server_verdict_cache, mechanism_name, initial_response_bytes, outcome);
+        result = false;
+    }
+    /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_007: [ `sasl_server_verdict_cache_lookup` shall get the current time by calling `tickcounter_get_current_ms`; if that fails it shall return false. ]*/
+    else if (tickcounter_get_current_ms(sasl_server_verdict_cache->tick_counter, &current_ms) != 0)
+    {
+        LogError("Cannot get the current time");
+        result = false;
+    }
+    else
+    {
+        size_t key_length;
+        size_t i;
+
+        if (hostname == NULL)
+        {
+            hostname = "";
+        }
+
+        key_length = get_key_length(mechanism_name, hostname, initial_response_bytes);
+
+        /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_010: [ If no verdict is kept for the same `mechanism_name`, `hostname` and `initial_response_bytes`, `sasl_server_verdict_cache_lookup` shall return false. ]*/
+        result = false;
+
+        for (i = 0; i < sasl_server_verdict_cache->max_entries; i++)
+        {
+            CACHED_VERDICT* cached_verdict = &sasl_server_verdict_cache->verdicts[i];
+
+            if (key_matches(cached_verdict, mechanism_name, hostname, initial_response_bytes, key_length))
+            {
+                if (cached_verdict->expiry_ms <= current_ms)
+                {
+                    /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_009: [ A verdict whose time to live has passed shall be dropped and `sasl_server_verdict_cache_lookup` shall return false. ]*/
+                    free_cached_verdict(cached_verdict);
+                }
+                else
+                {
+                    /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_008: [ If a verdict is kept for the same `mechanism_name`, `hostname` (NULL being the same as an empty hostname) and `initial_response_bytes`, `sasl_server_verdict_cache_lookup` shall fill `outcome` with it and return true. ]*/
+                    *outcome = cached_verdict->outcome;
+                    result = true;
+                }
+
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+int sasl_server_verdict_cache_store(SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache, const char* mechanism_name, const char* hostname, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME outcome)
+{
+    int result;
+    tickcounter_ms_t current_ms;
+
+    if ((sasl_server_verdict_cache == NULL) ||
+        (mechanism_name == NULL) ||
+        (initial_response_bytes == NULL) ||
+        ((initial_response_bytes->bytes == NULL) && (initial_response_bytes->length > 0)))
+    {
+        /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_012: [ If `sasl_server_verdict_cache`, `mechanism_name` or `initial_response_bytes` is NULL, or `initial_response_bytes` has a NULL `bytes` and a non-zero `length`, `sasl_server_verdict_cache_store` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: sasl_server_verdict_cache = %p, mechanism_name = %p, initial_response_bytes = %p",
+            sasl_server_verdict_cache, mechanism_name, initial_response_bytes);
+        result = __FAILURE__;
+    }
+    else if ((outcome != SASL_SERVER_MECHANISM_OUTCOME_OK) &&
+        (outcome != SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED))
+    {
+        /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_013: [ If `outcome` is neither `SASL_SERVER_MECHANISM_OUTCOME_OK` nor `SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED`, `sasl_server_verdict_cache_store` shall fail and return a non-zero value. ]*/
+        LogError("Only final verdicts can be cached, outcome = %d", (int)outcome);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_014: [ `sasl_server_verdict_cache_store` shall get the current time by calling `tickcounter_get_current_ms`; if that fails it shall fail and return a non-zero value. ]*/
+    else if (tickcounter_get_current_ms(sasl_server_verdict_cache->tick_counter, &current_ms) != 0)
+    {
+        LogError("Cannot get the current time");
+        result = __FAILURE__;
+    }
+    else
+    {
+        CACHED_VERDICT* cached_verdict = NULL;
+        size_t key_length;
+        size_t i;
+
+        if (hostname == NULL)
+        {
+            hostname = "";
+        }
+
+        key_length = get_key_length(mechanism_name, hostname, initial_response_bytes);
+
+        for (i = 0; i < sasl_server_verdict_cache->max_entries; i++)
+        {
+            if (key_matches(&sasl_server_verdict_cache->verdicts[i], mechanism_name, hostname, initial_response_bytes, key_length))
+            {
+                cached_verdict = &sasl_server_verdict_cache->verdicts[i];
+                break;
+            }
+        }
+
+        if (cached_verdict != NULL)
+        {
+            /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_015: [ If a verdict is already kept for the same key, its outcome shall be replaced and its time to live restarted. ]*/
+            cached_verdict->outcome = outcome;
+            cached_verdict->expiry_ms = current_ms + sasl_server_verdict_cache->time_to_live_ms;
+
+            /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_011: [ On success, `sasl_server_verdict_cache_store` shall return 0. ]*/
+            result = 0;
+        }
+        else
+        {
+            unsigned char* key = (unsigned char*)malloc(key_length);
+            if (key == NULL)
+            {
+                /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_017: [ If allocating memory fails, `sasl_server_verdict_cache_store` shall fail, return a non-zero value and leave the cache unchanged. ]*/
+                LogError("Cannot allocate memory for the verdict key");
+                result = __FAILURE__;
+            }
+            else
+            {
+                size_t mechanism_name_size = strlen(mechanism_name) + 1;
+                size_t hostname_size = strlen(hostname) + 1;
+
+                (void)memcpy(key, mechanism_name, mechanism_name_size);
+                (void)memcpy(key + mechanism_name_size, hostname, hostname_size);
+                if (initial_response_bytes->length > 0)
+                {
+                    (void)memcpy(key + mechanism_name_size + hostname_size, initial_response_bytes->bytes, initial_response_bytes->length);
+                }
+
+                /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_016: [ Otherwise the verdict shall be kept with a copy of the key in a free or expired entry, or when all entries are in use in place of the entry that expires first. ]*/
+                cached_verdict = &sasl_server_verdict_cache->verdicts[0];
+                for (i = 0; i < sasl_server_verdict_cache->max_entries; i++)
+                {
+                    CACHED_VERDICT* candidate = &sasl_server_verdict_cache->verdicts[i];
+
+                    if ((candidate->key == NULL) ||
+                        (candidate->expiry_ms <= current_ms))
+                    {
+                        cached_verdict = candidate;
+                        break;
+                    }
+
+                    if (candidate->expiry_ms < cached_verdict->expiry_ms)
+                    {
+                        cached_verdict = candidate;
+                    }
+                }
+
+                if (cached_verdict->key != NULL)
+                {
+                    free_cached_verdict(cached_verdict);
+                }
+
+                cached_verdict->key = key;
+                cached_verdict->key_length = key_length;
+                cached_verdict->outcome = outcome;
+                cached_verdict->expiry_ms = current_ms + sasl_server_verdict_cache->time_to_live_ms;
+
+                /* Codes_SRS_SASL_SERVER_VERDICT_CACHE_01_011: [ On success, `sasl_server_verdict_cache_store` shall return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
@@ -66,6 +66,9 @@ typedef struct SASL_CLIENT_IO_INSTANCE_TAG
     SASL_MECHANISM_HANDLE sasl_mechanism;
     unsigned int is_trace_on : 1;
     unsigned int is_trace_on_set : 1;
+    unsigned int is_optimistic_init : 1;
+    unsigned int is_optimistic_init_set : 1;
+    unsigned int are_server_mechanisms_checked : 1;
 } SASL_CLIENT_IO_INSTANCE;
 
 /* Codes_SRS_SASLCLIENTIO_01_002: [The protocol header consists of the upper case ASCII letters "AMQP" followed by a protocol id of three, followed by three unsigned bytes representing the major, minor, and revision of the specification version (currently 1 (SASL-MAJOR), 0 (SASLMINOR), 0 (SASL-REVISION)).] */
@@ -152,6 +155,35 @@ static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result
     (void)send_result;
 }
 
+static int send_sasl_init(SASL_CLIENT_IO_INSTANCE* sasl_client_io, const char* sasl_mechanism_name);
+
+static int send_optimistic_sasl_init(SASL_CLIENT_IO_INSTANCE* sasl_client_io_instance)
+{
+    int result;
+    const char* sasl_mechanism_name = saslmechanism_get_mechanism_name(sasl_client_io_instance->sasl_mechanism);
+
+    if (sasl_mechanism_name == NULL)
+    {
+        /* Codes_SRS_SASLCLIENTIO_01_148: [ If getting the mechanism name or sending the SASL init fails, the `on_io_open_complete` callback shall be triggered with `IO_OPEN_ERROR`. ]*/
+        LogError("Cannot get the mechanism name");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_SASLCLIENTIO_01_147: [ When the `sasl_optimistic_init` option is set to true, SASL client IO shall send the SASL init frame for the configured mechanism right after sending the SASL header, without waiting for the SASL header and the sasl-mechanisms frame from the server. ]*/
+    else if (send_sasl_init(sasl_client_io_instance, sasl_mechanism_name) != 0)
+    {
+        /* Codes_SRS_SASLCLIENTIO_01_148: [ If getting the mechanism name or sending the SASL init fails, the `on_io_open_complete` callback shall be triggered with `IO_OPEN_ERROR`. ]*/
+        LogError("Could not send optimistic SASL init");
+        result = __FAILURE__;
+    }
+    else
+    {
+        sasl_client_io_instance->sasl_client_negotiation_state = SASL_CLIENT_NEGOTIATION_INIT_SENT;
+        result = 0;
+    }
+
+    return result;
+}
+
 static int send_sasl_header(SASL_CLIENT_IO_INSTANCE* sasl_client_io_instance)
 {
     int result;
@@ -170,7 +202,15 @@ static int send_sasl_header(SASL_CLIENT_IO_INSTANCE* sasl_client_io_instance)
             LOG(AZ_LOG_TRACE, LOG_LINE, "-> Header (AMQP 3.1.0.0)");
         }
 
-        result = 0;
+        if ((sasl_client_io_instance->is_optimistic_init != 0) &&
+            (send_optimistic_sasl_init(sasl_client_io_instance) != 0))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
     }
 
     return result;
@@ -687,6 +727,16 @@ static void on_sasl_frame_received_callback(void* context, AMQP_VALUE sasl_frame
                         handle_error(sasl_client_io_instance);
                         break;
 
+                    case SASL_CLIENT_NEGOTIATION_INIT_SENT:
+                        if ((sasl_client_io_instance->is_optimistic_init == 0) ||
+                            (sasl_client_io_instance->are_server_mechanisms_checked != 0))
+                        {
+                            LogError("SASL mechanisms frame received in %s state", ENUM_TO_STRING(SASL_CLIENT_NEGOTIATION_STATE, sasl_client_io_instance->sasl_client_negotiation_state));
+                            handle_error(sasl_client_io_instance);
+                            break;
+                        }
+
+                        /* fall through */
                     case SASL_CLIENT_NEGOTIATION_NOT_STARTED:
                     {
                         SASL_MECHANISMS_HANDLE sasl_mechanisms_handle;
@@ -759,6 +809,11 @@ static void on_sasl_frame_received_callback(void* context, AMQP_VALUE sasl_frame
                                         LogError("Could not find desired SASL mechanism in the list presented by server");
                                         handle_error(sasl_client_io_instance);
                                     }
+                                    else if (sasl_client_io_instance->sasl_client_negotiation_state == SASL_CLIENT_NEGOTIATION_INIT_SENT)
+                                    {
+                                        /* Codes_SRS_SASLCLIENTIO_01_149: [ When the sasl-mechanisms frame is received after an optimistic SASL init was sent, SASL client IO shall check that the configured mechanism is in the list presented by the server and shall not send another SASL init. ]*/
+                                        sasl_client_io_instance->are_server_mechanisms_checked = 1;
+                                    }
                                     else
                                     {
                                         sasl_client_io_instance->sasl_client_negotiation_state = SASL_CLIENT_NEGOTIATION_MECH_RCVD;
@@ -799,6 +854,13 @@ static void on_sasl_frame_received_callback(void* context, AMQP_VALUE sasl_frame
                         LogError("SASL challenge received in a bad state: %s", ENUM_TO_STRING(SASL_CLIENT_NEGOTIATION_STATE, sasl_client_io_instance->sasl_client_negotiation_state));
                         handle_error(sasl_client_io_instance);
                     }
+                    else if ((sasl_client_io_instance->is_optimistic_init != 0) &&
+                        (sasl_client_io_instance->are_server_mechanisms_checked == 0))
+                    {
+                        /* Codes_SRS_SASLCLIENTIO_01_150: [ If a sasl-challenge or sasl-outcome frame is received after an optimistic SASL init was sent but before the sasl-mechanisms frame, the `on_io_open_complete` callback shall be triggered with `IO_OPEN_ERROR`. ]*/
+                        LogError("SASL challenge received before the SASL mechanisms");
+                        handle_error(sasl_client_io_instance);
+                    }
                     else
                     {
                         SASL_CHALLENGE_HANDLE sasl_challenge_handle;
@@ -864,6 +926,13 @@ static void on_sasl_frame_received_callback(void* context, AMQP_VALUE sasl_frame
                         LogError("SASL outcome received in a bad state: %s", ENUM_TO_STRING(SASL_CLIENT_NEGOTIATION_STATE, sasl_client_io_instance->sasl_client_negotiation_state));
                         handle_error(sasl_client_io_instance);
                     }
+                    else if ((sasl_client_io_instance->is_optimistic_init != 0) &&
+                        (sasl_client_io_instance->are_server_mechanisms_checked == 0))
+                    {
+                        /* Codes_SRS_SASLCLIENTIO_01_150: [ If a sasl-challenge or sasl-outcome frame is received after an optimistic SASL init was sent but before the sasl-mechanisms frame, the `on_io_open_complete` callback shall be triggered with `IO_OPEN_ERROR`. ]*/
+                        LogError("SASL outcome received before the SASL mechanisms");
+                        handle_error(sasl_client_io_instance);
+                    }
                     else
                     {
                         SASL_OUTCOME_HANDLE sasl_outcome;
@@ -1012,6 +1081,10 @@ CONCRETE_IO_HANDLE saslclientio_create(void* io_create_parameters)
                     result->on_io_close_complete_context = NULL;
                     result->on_io_error_context = NULL;
                     result->sasl_mechanism = sasl_client_io_config->sasl_mechanism;
+                    /* Codes_SRS_SASLCLIENTIO_01_146: [ By default the `sasl_optimistic_init` option shall be false. ]*/
+                    result->is_optimistic_init = 0;
+                    result->is_optimistic_init_set = 0;
+                    result->are_server_mechanisms_checked = 0;
 
                     result->io_state = IO_STATE_NOT_OPEN;
                 }
@@ -1080,6 +1153,7 @@ int saslclientio_open_async(CONCRETE_IO_HANDLE sasl_client_io, ON_IO_OPEN_COMPLE
             sasl_client_io_instance->io_state = IO_STATE_OPENING_UNDERLYING_IO;
             sasl_client_io_instance->is_trace_on = 0;
             sasl_client_io_instance->is_trace_on_set = 0;
+            sasl_client_io_instance->are_server_mechanisms_checked = 0;
 
             /* Codes_SRS_SASLCLIENTIO_01_009: [`saslclientio_open` shall call `xio_open` on the `underlying_io` passed to `saslclientio_create`.] */
             /* Codes_SRS_SASLCLIENTIO_01_013: [`saslclientio_open_async` shall pass to `xio_open` the `on_underlying_io_open_complete` as `on_io_open_complete` argument, `on_underlying_io_bytes_received` as `on_bytes_received` argument and `on_underlying_io_error` as `on_io_error` argument.] */
@@ -1244,6 +1318,30 @@ int saslclientio_setoption(CONCRETE_IO_HANDLE sasl_client_io, const char* option
             /* Codes_SRS_SASLCLIENTIO_01_128: [ On success, `saslclientio_setoption` shall return 0. ]*/
             result = 0;
         }
+        /* Codes_SRS_SASLCLIENTIO_01_145: [ - sasl_optimistic_init - bool. ]*/
+        else if (strcmp("sasl_optimistic_init", option_name) == 0)
+        {
+            sasl_client_io_instance->is_optimistic_init = *((bool*)value) == true ? 1 : 0;
+            sasl_client_io_instance->is_optimistic_init_set = 1;
+
+            /* Codes_SRS_SASLCLIENTIO_01_128: [ On success, `saslclientio_setoption` shall return 0. ]*/
+            result = 0;
+        }
+        /* Codes_SRS_SASLCLIENTIO_01_152: [ - underlying_io_options - OPTIONHANDLER_HANDLE, the options of the underlying IO, which shall be set on the underlying IO by calling `OptionHandler_FeedOptions`. ]*/
+        else if (strcmp("underlying_io_options", option_name) == 0)
+        {
+            if (OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)value, sasl_client_io_instance->underlying_io) != OPTIONHANDLER_OK)
+            {
+                /* Codes_SRS_SASLCLIENTIO_01_153: [ If `OptionHandler_FeedOptions` fails, `saslclientio_setoption` shall fail and return a non-zero value. ]*/
+                LogError("Cannot set the options of the underlying IO");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_SASLCLIENTIO_01_128: [ On success, `saslclientio_setoption` shall return 0. ]*/
+                result = 0;
+            }
+        }
         else
         {
             /* Codes_SRS_SASLCLIENTIO_03_001: [`saslclientio_setoption` shall forward all unhandled options to underlying io by calling `xio_setoption`.]*/
@@ -1266,16 +1364,44 @@ int saslclientio_setoption(CONCRETE_IO_HANDLE sasl_client_io, const char* option
 /*this function will clone an option given by name and value*/
 static void* saslclientio_clone_option(const char* name, const void* value)
 {
-    (void)name;
-    (void)value;
-    return NULL;
+    void* result;
+
+    if (strcmp("underlying_io_options", name) == 0)
+    {
+        result = OptionHandler_Clone((OPTIONHANDLER_HANDLE)value);
+        if (result == NULL)
+        {
+            LogError("unable to clone the underlying io options");
+        }
+    }
+    else
+    {
+        /* logtrace and sasl_optimistic_init are both bool */
+        result = malloc(sizeof(bool));
+        if (result == NULL)
+        {
+            LogError("unable to allocate memory for option %s", name);
+        }
+        else
+        {
+            *(bool*)result = *(const bool*)value;
+        }
+    }
+
+    return result;
 }
 
 /*this function destroys an option previously created*/
 static void saslclientio_destroy_option(const char* name, const void* value)
 {
-    (void)name;
-    (void)value;
+    if (strcmp("underlying_io_options", name) == 0)
+    {
+        OptionHandler_Destroy((OPTIONHANDLER_HANDLE)value);
+    }
+    else
+    {
+        free((void*)value);
+    }
 }
 
 static OPTIONHANDLER_HANDLE saslclientio_retrieveoptions(CONCRETE_IO_HANDLE sasl_client_io)
@@ -1314,6 +1440,40 @@ static OPTIONHANDLER_HANDLE saslclientio_retrieveoptions(CONCRETE_IO_HANDLE sasl
                     result = NULL;
                 }
             }
+
+            if ((result != NULL) &&
+                (sasl_client_io_instance->is_optimistic_init_set))
+            {
+                bool optimistic_init = sasl_client_io_instance->is_optimistic_init ? true : false;
+                /* Codes_SRS_SASLCLIENTIO_01_151: [ - sasl_optimistic_init - bool. ]*/
+                if (OptionHandler_AddOption(result, "sasl_optimistic_init", &optimistic_init) != 0)
+                {
+                    /* Codes_SRS_SASLCLIENTIO_01_138: [ If `OptionHandler_AddOption` or `OptionHandler_Create` fails then `saslclientio_retrieveoptions` shall fail and return NULL. ]*/
+                    LogError("unable to add sasl_optimistic_init option");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+            }
+
+            if (result != NULL)
+            {
+                /* Codes_SRS_SASLCLIENTIO_01_154: [ `saslclientio_retrieveoptions` shall get the options of the underlying IO by calling `xio_retrieveoptions` and add them as - underlying_io_options - OPTIONHANDLER_HANDLE. ]*/
+                /* Codes_SRS_SASLCLIENTIO_01_155: [ If `xio_retrieveoptions` returns NULL, no underlying IO options shall be added. ]*/
+                OPTIONHANDLER_HANDLE underlying_io_options = xio_retrieveoptions(sasl_client_io_instance->underlying_io);
+                if (underlying_io_options != NULL)
+                {
+                    if (OptionHandler_AddOption(result, "underlying_io_options", underlying_io_options) != 0)
+                    {
+                        /* Codes_SRS_SASLCLIENTIO_01_138: [ If `OptionHandler_AddOption` or `OptionHandler_Create` fails then `saslclientio_retrieveoptions` shall fail and return NULL. ]*/
+                        LogError("unable to add underlying_io_options option");
+                        OptionHandler_Destroy(result);
+                        result = NULL;
+                    }
+
+                    /* Codes_SRS_SASLCLIENTIO_01_156: [ The options retrieved from the underlying IO shall be destroyed by calling `OptionHandler_Destroy` once added. ]*/
+                    OptionHandler_Destroy(underlying_io_options);
+                }
+            }
         }
     }
 
@@ -3,51 +3,163 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/session.h"
 #include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/admission_limiter.h"
 #include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/amqp_performative_fields.h"
+#include "azure_uamqp_c/uamqp_tracepoints.h"
+#include "azure_uamqp_c/uamqp_static_pools.h"
 
+#define ALLOC_COUNTERS_SUBSYSTEM ALLOC_SUBSYSTEM_SESSION
+#include "azure_uamqp_c/alloc_counters.h"
+
+/* the delivery-tag is at most 32 octets long, this is enough for the templated transfer fields */
+#define TRANSFER_TEMPLATE_MAX_DELIVERY_TAG_LENGTH 32
+#define TRANSFER_TEMPLATE_MAX_SIZE (25 + TRANSFER_TEMPLATE_MAX_DELIVERY_TAG_LENGTH)
+
+/* offsets in the transfer template, all uint fields are encoded as 4 byte uints so that they can be patched */
+#define TRANSFER_TEMPLATE_HANDLE_OFFSET 7
+#define TRANSFER_TEMPLATE_DELIVERY_ID_OFFSET 12
+#define TRANSFER_TEMPLATE_DELIVERY_TAG_OFFSET 18
+
+/* a flow with all link fields takes at most 41 bytes, the rest is room for a disposition delivery state */
+#define ENCODED_PERFORMATIVE_MAX_SIZE 128
+
+/* transfers split across frames keep their encoded performatives and frame slices on the stack up to these sizes */
+#define SPLIT_TRANSFER_STACK_PERFORMATIVE_SIZE 256
+#define SPLIT_TRANSFER_STACK_PAYLOAD_COUNT 8
+
+typedef struct ENCODED_PERFORMATIVE_TAG
+{
+    unsigned char bytes[ENCODED_PERFORMATIVE_MAX_SIZE];
+    size_t size;
+} ENCODED_PERFORMATIVE;
+
+/* Sessions of gateways can hold very many mostly idle endpoints, so the name lives in the same allocation as the
+endpoint (and is shared with the link) and the transfer template is only allocated by the first templated transfer. */
 typedef struct LINK_ENDPOINT_INSTANCE_TAG
 {
-    char* name;
+    /* hot: used for every frame received or transfer sent on the link */
+    ON_ENDPOINT_FRAME_RECEIVED frame_received_callback;
+    void* callback_context;
+    SESSION_HANDLE session;
+    /* encoded transfer performative built once for the stable fields, the per delivery fields are patched in place */
+    unsigned char* transfer_template;
     handle input_handle;
     handle output_handle;
-    ON_ENDPOINT_FRAME_RECEIVED frame_received_callback;
+    /* input_handle was given by the peer's attach, it is only in the input handle table below INPUT_HANDLE_TABLE_MAX_SIZE */
+    bool has_input_handle;
+    uint32_t transfer_template_size;
+    uint32_t transfer_template_delivery_tag_length;
+    message_format transfer_template_message_format;
+    /* transfers this endpoint may still send while the session hands out a newly opened remote window */
+    uint32_t window_share;
+    /* a delivery sent with session_send_transfer_part is in progress, all its parts carry this delivery id */
+    delivery_number transfer_parts_delivery_id;
+    bool is_sending_transfer_parts;
+    /* refused by the link admission limiter, owned by the session until the peer's detach arrives */
+    bool is_refused;
+    /* the latest link flow state waiting for the next connection_dowork while the session defers link flows */
+    bool has_pending_flow;
+    sequence_no pending_flow_delivery_count;
+    uint32_t pending_flow_link_credit;
+    struct LINK_ENDPOINT_INSTANCE_TAG* next_pending_flow;
+
+    /* cold: only used when attaching, detaching, scheduling or on session state changes */
+    char* name;
+    struct LINK_ENDPOINT_INSTANCE_TAG* next_by_name;
+    uint32_t name_hash;
+    uint32_t scheduling_weight;
     ON_SESSION_STATE_CHANGED on_session_state_changed;
     ON_SESSION_FLOW_ON on_session_flow_on;
-    void* callback_context;
-    SESSION_HANDLE session;
+    /* NULL unless session_set_link_endpoint_on_dowork was called */
+    ON_LINK_ENDPOINT_DOWORK on_dowork;
+    void* on_dowork_context;
 } LINK_ENDPOINT_INSTANCE;
 
 typedef struct SESSION_INSTANCE_TAG
 {
-    ON_ENDPOINT_FRAME_RECEIVED frame_received_callback;
-    void* frame_received_callback_context;
+    /* hot: touched by every frame received or transfer sent on the session, kept together in the first cache lines */
     SESSION_STATE session_state;
-    SESSION_STATE previous_session_state;
+    int is_underlying_connection_open : 1;
     CONNECTION_HANDLE connection;
     ENDPOINT_HANDLE endpoint;
-    LINK_ENDPOINT_INSTANCE** link_endpoints;
-    uint32_t link_endpoint_count;
-
-    ON_LINK_ATTACHED on_link_attached;
-    void* on_link_attached_callback_context;
-
+    /* indexed by the input handle the peer picked when attaching */
+    LINK_ENDPOINT_INSTANCE** link_endpoints_by_input_handle;
+    uint32_t input_handle_table_size;
     /* Codes_SRS_SESSION_01_016: [next-outgoing-id The next-outgoing-id is the transfer-id to assign to the next transfer frame.] */
     transfer_number next_outgoing_id;
     transfer_number next_incoming_id;
     uint32_t desired_incoming_window;
     uint32_t incoming_window;
     uint32_t outgoing_window;
-    handle handle_max;
     uint32_t remote_incoming_window;
     uint32_t remote_outgoing_window;
-    int is_underlying_connection_open : 1;
+    SESSION_WINDOW_POLICY window_policy;
+    uint32_t max_incoming_window;
+    bool is_sharing_window;
+    /* link flows are only recorded on their endpoint and sent together from the dowork of the connection */
+    bool is_deferring_link_flows;
+    /* link endpoints with an on_dowork callback, the session endpoint has a dowork callback while this or is_deferring_link_flows is set */
+    uint32_t dowork_link_endpoint_count;
+    /* a transfer was refused on a remote incoming window of 0 and no flow opened it since */
+    bool is_remote_window_closed;
+    LINK_ENDPOINT_INSTANCE* first_pending_flow;
+    /* counted for every frame, right after the hot fields */
+    SESSION_STATS stats;
+
+    /* warm: per flow, per attach or per window sample */
+    /* sorted by output handle, the name hash buckets live in the same allocation right after the endpoints */
+    LINK_ENDPOINT_INSTANCE** link_endpoints;
+    LINK_ENDPOINT_INSTANCE** link_endpoints_by_name;
+    uint32_t link_endpoint_count;
+    uint32_t link_endpoint_capacity;
+    handle handle_max;
+    SESSION_LINK_SCHEDULER link_scheduler;
+    uint32_t next_flow_on_index;
+    uint32_t rate_sample_transfer_count;
+    /* only created for the adaptive window policy */
+    TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t begin_sent_time;
+    tickcounter_ms_t round_trip_time;
+    tickcounter_ms_t rate_sample_start_time;
+
+    /* cold: callbacks and state only used when beginning, ending or attaching */
+    ON_ENDPOINT_FRAME_RECEIVED frame_received_callback;
+    void* frame_received_callback_context;
+    SESSION_STATE previous_session_state;
+    /* the BEGIN was sent in the OPEN_PIPE state of the connection, links can attach without waiting for the peer's BEGIN */
+    bool is_begin_pipelined;
+    ON_LINK_ATTACHED on_link_attached;
+    void* on_link_attached_callback_context;
+    /* new link attaches it does not admit are refused without calling on_link_attached */
+    ADMISSION_LIMITER_HANDLE link_admission_limiter;
+    /* restored from a handover state, the session is mapped again without a BEGIN when the connection opens */
+    bool is_resuming_handover;
 } SESSION_INSTANCE;
 
+#define DEFAULT_SESSION_WINDOW 2048
+#ifdef UAMQP_STATIC_POOLS
+/* the handle max advertised to the peer also bounds the input handle table */
+#define DEFAULT_HANDLE_MAX (UAMQP_STATIC_MAX_LINKS - 1)
+#else
+#define DEFAULT_HANDLE_MAX 4294967295u
+#endif
+/* input handles up to this are looked up directly, a peer picking bigger ones costs a scan of the link endpoints */
+#define INPUT_HANDLE_TABLE_MAX_SIZE 1024
+#define ADAPTIVE_INITIAL_WINDOW 256
+#define ADAPTIVE_MIN_WINDOW 16
+
+/* the handover state is a list of the version, the channels and the transfer ids and windows of the session */
+#define SESSION_HANDOVER_STATE_VERSION 1
+#define SESSION_HANDOVER_STATE_FIELD_COUNT 11
+
 #define UNDERLYING_CONNECTION_NOT_OPEN 0
 #define UNDERLYING_CONNECTION_OPEN -1
 
@@ -144,6 +256,13 @@ static int send_begin(SESSION_INSTANCE* session_instance)
     int result;
     BEGIN_HANDLE begin = begin_create(session_instance->next_outgoing_id, session_instance->incoming_window, session_instance->outgoing_window);
 
+    /* the time until the peer BEGIN arrives is the round trip the adaptive window is sized from */
+    if ((session_instance->tick_counter != NULL) &&
+        (tickcounter_get_current_ms(session_instance->tick_counter, &session_instance->begin_sent_time) != 0))
+    {
+        LogError("Cannot get the BEGIN send time");
+    }
+
     if (begin == NULL)
     {
         result = __FAILURE__;
@@ -189,6 +308,123 @@ static int send_begin(SESSION_INSTANCE* session_instance)
     return result;
 }
 
+static void write_uint32(unsigned char* bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value >> 24);
+    bytes[1] = (unsigned char)(value >> 16);
+    bytes[2] = (unsigned char)(value >> 8);
+    bytes[3] = (unsigned char)value;
+}
+
+/* fixed shape performatives (flow, disposition) are written straight to bytes as a described list8 */
+static void begin_encoded_performative(ENCODED_PERFORMATIVE* performative, uint64_t descriptor, unsigned char field_count)
+{
+    performative->bytes[0] = 0x00;
+    performative->bytes[1] = 0x53;
+    performative->bytes[2] = (unsigned char)descriptor;
+    performative->bytes[3] = 0xC0;
+    performative->bytes[4] = 0;
+    performative->bytes[5] = field_count;
+    performative->size = 6;
+}
+
+static void add_encoded_uint_field(ENCODED_PERFORMATIVE* performative, uint32_t value)
+{
+    unsigned char* bytes = performative->bytes + performative->size;
+
+    if (value == 0)
+    {
+        /* uint0 */
+        bytes[0] = 0x43;
+        performative->size += 1;
+    }
+    else if (value <= 0xFF)
+    {
+        /* smalluint */
+        bytes[0] = 0x52;
+        bytes[1] = (unsigned char)value;
+        performative->size += 2;
+    }
+    else
+    {
+        bytes[0] = 0x70;
+        bytes[1] = (unsigned char)(value >> 24);
+        bytes[2] = (unsigned char)(value >> 16);
+        bytes[3] = (unsigned char)(value >> 8);
+        bytes[4] = (unsigned char)value;
+        performative->size += 5;
+    }
+}
+
+static void add_encoded_bool_field(ENCODED_PERFORMATIVE* performative, bool value)
+{
+    performative->bytes[performative->size] = value ? 0x41 : 0x42;
+    performative->size++;
+}
+
+static int add_encoded_value_field(ENCODED_PERFORMATIVE* performative, AMQP_VALUE value)
+{
+    int result;
+    size_t encoded_size;
+
+    if ((amqpvalue_get_encoded_size(value, &encoded_size) != 0) ||
+        (encoded_size > ENCODED_PERFORMATIVE_MAX_SIZE - performative->size))
+    {
+        result = __FAILURE__;
+    }
+    else if (amqpvalue_encode_to_buffer(value, performative->bytes + performative->size, encoded_size, &encoded_size) != 0)
+    {
+        LogError("Cannot encode performative field");
+        result = __FAILURE__;
+    }
+    else
+    {
+        performative->size += encoded_size;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* accepted and released carry an empty list, so once recognized they are written as their 4 known bytes:
+   descriptor constructor, smallulong constructor, descriptor code and list0 */
+static bool add_encoded_outcome_without_fields(ENCODED_PERFORMATIVE* performative, AMQP_VALUE value)
+{
+    bool result;
+    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(value);
+    AMQP_VALUE described_value;
+    uint64_t descriptor_code;
+    uint32_t item_count;
+
+    if ((descriptor == NULL) ||
+        (!is_accepted_type_by_descriptor(descriptor) && !is_released_type_by_descriptor(descriptor)) ||
+        (amqpvalue_get_ulong(descriptor, &descriptor_code) != 0) ||
+        ((described_value = amqpvalue_get_inplace_described_value(value)) == NULL) ||
+        (amqpvalue_get_list_item_count(described_value, &item_count) != 0) ||
+        (item_count != 0) ||
+        (performative->size + 4 > ENCODED_PERFORMATIVE_MAX_SIZE))
+    {
+        result = false;
+    }
+    else
+    {
+        performative->bytes[performative->size] = 0x00;
+        performative->bytes[performative->size + 1] = 0x53;
+        performative->bytes[performative->size + 2] = (unsigned char)descriptor_code;
+        performative->bytes[performative->size + 3] = 0x45;
+        performative->size += 4;
+        result = true;
+    }
+
+    return result;
+}
+
+static void end_encoded_performative(ENCODED_PERFORMATIVE* performative)
+{
+    /* the list8 size counts the bytes following the size byte */
+    performative->bytes[4] = (unsigned char)(performative->size - 5);
+}
+
 static int send_flow(SESSION_INSTANCE* session)
 {
     int result;
@@ -198,67 +434,200 @@ static int send_flow(SESSION_INSTANCE* session)
     }
     else
     {
-        FLOW_HANDLE flow = flow_create(session->incoming_window, session->next_outgoing_id, session->outgoing_window);
+        ENCODED_PERFORMATIVE flow;
+
+        begin_encoded_performative(&flow, AMQP_FLOW, 4);
+        add_encoded_uint_field(&flow, session->next_incoming_id);
+        add_encoded_uint_field(&flow, session->incoming_window);
+        add_encoded_uint_field(&flow, session->next_outgoing_id);
+        add_encoded_uint_field(&flow, session->outgoing_window);
+        end_encoded_performative(&flow);
 
-        if (flow == NULL)
+        if (connection_encode_frame_with_encoded_performative(session->endpoint, flow.bytes, flow.size, NULL, 0, NULL, NULL) != 0)
         {
             result = __FAILURE__;
         }
         else
         {
-            if (flow_set_next_incoming_id(flow, session->next_incoming_id) != 0)
+            session->stats.flows_sent++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void adapt_incoming_window(SESSION_INSTANCE* session_instance)
+{
+    tickcounter_ms_t current_time;
+
+    if (tickcounter_get_current_ms(session_instance->tick_counter, &current_time) != 0)
+    {
+        LogError("Cannot get the current time, keeping the incoming window");
+    }
+    else
+    {
+        tickcounter_ms_t elapsed = current_time - session_instance->rate_sample_start_time;
+
+        /* Codes_SRS_SESSION_01_089: [With the adaptive window policy the incoming window shall be sized to twice the number of transfers received in one round trip, measured between sending and receiving BEGIN, bounded by the maximum window given to session_set_window_policy.] */
+        if ((elapsed > 0) && (session_instance->round_trip_time > 0))
+        {
+            uint64_t window = ((uint64_t)session_instance->rate_sample_transfer_count * session_instance->round_trip_time * 2) / elapsed;
+
+            if (window < ADAPTIVE_MIN_WINDOW)
             {
-                result = __FAILURE__;
+                window = ADAPTIVE_MIN_WINDOW;
             }
-            else
-            {
-                AMQP_VALUE flow_performative_value = amqpvalue_create_flow(flow);
-                if (flow_performative_value == NULL)
-                {
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    if (connection_encode_frame(session->endpoint, flow_performative_value, NULL, 0, NULL, NULL) != 0)
-                    {
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        result = 0;
-                    }
 
-                    amqpvalue_destroy(flow_performative_value);
-                }
+            if (window > session_instance->max_incoming_window)
+            {
+                window = session_instance->max_incoming_window;
             }
 
-            flow_destroy(flow);
+            session_instance->desired_incoming_window = (uint32_t)window;
         }
+
+        session_instance->rate_sample_start_time = current_time;
+        session_instance->rate_sample_transfer_count = 0;
     }
+}
 
-    return result;
+static void notify_flow_on(SESSION_INSTANCE* session_instance)
+{
+    uint32_t start_index = session_instance->next_flow_on_index;
+    uint32_t i = 0;
+
+    /* the callbacks can send, so the window, the send queue and the endpoint count are reread on every step */
+    /* Codes_SRS_SESSION_01_117: [Link endpoints shall not be told that they can send while the send queue of the connection is full.] */
+    while ((session_instance->remote_incoming_window > 0) &&
+        !connection_is_send_queue_full(session_instance->connection) &&
+        (i < session_instance->link_endpoint_count))
+    {
+        LINK_ENDPOINT_INSTANCE* link_endpoint = session_instance->link_endpoints[(start_index + i) % session_instance->link_endpoint_count];
+
+        /* notify the caller that it can send here */
+        if (link_endpoint->on_session_flow_on != NULL)
+        {
+            link_endpoint->on_session_flow_on(link_endpoint->callback_context);
+        }
+
+        i++;
+    }
 }
 
-static LINK_ENDPOINT_INSTANCE* find_link_endpoint_by_name(SESSION_INSTANCE* session, const char* name)
+static void count_window_stall(SESSION_INSTANCE* session_instance)
 {
-    uint32_t i;
-    LINK_ENDPOINT_INSTANCE* result;
+    session_instance->stats.window_stalls++;
+
+    /* Codes_SRS_SESSION_01_145: [When a transfer is refused because the remote incoming window is 0, the session shall report CONNECTION_FLOW_EVENT_SESSION_WINDOW_CLOSED with connection_report_flow_event, the session as source, once until a flow opens the window again.] */
+    if ((session_instance->remote_incoming_window == 0) &&
+        !session_instance->is_remote_window_closed)
+    {
+        session_instance->is_remote_window_closed = true;
+        connection_report_flow_event(session_instance->connection, CONNECTION_FLOW_EVENT_SESSION_WINDOW_CLOSED, session_instance, NULL, 0);
+    }
+}
 
-    for (i = 0; i < session->link_endpoint_count; i++)
+static void share_remote_incoming_window(SESSION_INSTANCE* session_instance)
+{
+    if (session_instance->link_endpoint_count > 0)
     {
-        if (strcmp(session->link_endpoints[i]->name, name) == 0)
+        uint64_t total_weight = 0;
+        uint32_t i;
+
+        for (i = 0; i < session_instance->link_endpoint_count; i++)
+        {
+            total_weight += (session_instance->link_scheduler == SESSION_LINK_SCHEDULER_WEIGHTED) ? session_instance->link_endpoints[i]->scheduling_weight : 1;
+        }
+
+        /* Codes_SRS_SESSION_01_096: [When the remote incoming window opens, each link endpoint shall first be offered a share of the window proportional to its weight (1 for every endpoint with the round robin scheduler), at least one transfer.] */
+        for (i = 0; i < session_instance->link_endpoint_count; i++)
+        {
+            LINK_ENDPOINT_INSTANCE* link_endpoint = session_instance->link_endpoints[i];
+            uint64_t weight = (session_instance->link_scheduler == SESSION_LINK_SCHEDULER_WEIGHTED) ? link_endpoint->scheduling_weight : 1;
+            uint64_t share = ((uint64_t)session_instance->remote_incoming_window * weight) / total_weight;
+
+            link_endpoint->window_share = (share == 0) ? 1 : (uint32_t)share;
+        }
+
+        session_instance->is_sharing_window = true;
+        notify_flow_on(session_instance);
+        session_instance->is_sharing_window = false;
+
+        /* Codes_SRS_SESSION_01_097: [Any window left once every endpoint used its share shall be offered to the endpoints again without a share limit.] */
+        notify_flow_on(session_instance);
+
+        /* Codes_SRS_SESSION_01_098: [The endpoint notified first shall rotate every time the remote incoming window opens.] */
+        session_instance->next_flow_on_index++;
+        if (session_instance->next_flow_on_index >= session_instance->link_endpoint_count)
         {
-            break;
+            session_instance->next_flow_on_index = 0;
         }
     }
+}
+
+static uint32_t get_link_name_hash(const char* name)
+{
+    /* FNV-1a */
+    uint32_t result = 2166136261u;
+
+    while (*name != '\0')
+    {
+        result = (result ^ (unsigned char)*name) * 16777619u;
+        name++;
+    }
+
+    return result;
+}
+
+static void add_link_endpoint_to_name_buckets(SESSION_INSTANCE* session, LINK_ENDPOINT_INSTANCE* link_endpoint)
+{
+    LINK_ENDPOINT_INSTANCE** bucket = &session->link_endpoints_by_name[link_endpoint->name_hash & (session->link_endpoint_capacity - 1)];
+
+    /* appended, so that the endpoint created first wins when names are the same */
+    while (*bucket != NULL)
+    {
+        bucket = &(*bucket)->next_by_name;
+    }
+
+    link_endpoint->next_by_name = NULL;
+    *bucket = link_endpoint;
+}
+
+static void remove_link_endpoint_from_name_buckets(SESSION_INSTANCE* session, LINK_ENDPOINT_INSTANCE* link_endpoint)
+{
+    LINK_ENDPOINT_INSTANCE** bucket = &session->link_endpoints_by_name[link_endpoint->name_hash & (session->link_endpoint_capacity - 1)];
+
+    while ((*bucket != NULL) &&
+        (*bucket != link_endpoint))
+    {
+        bucket = &(*bucket)->next_by_name;
+    }
+
+    if (*bucket != NULL)
+    {
+        *bucket = link_endpoint->next_by_name;
+    }
+}
+
+static LINK_ENDPOINT_INSTANCE* find_link_endpoint_by_name(SESSION_INSTANCE* session, const char* name)
+{
+    LINK_ENDPOINT_INSTANCE* result;
 
-    if (i == session->link_endpoint_count)
+    if (session->link_endpoint_count == 0)
     {
         result = NULL;
     }
     else
     {
-        result = session->link_endpoints[i];
+        uint32_t name_hash = get_link_name_hash(name);
+
+        result = session->link_endpoints_by_name[name_hash & (session->link_endpoint_capacity - 1)];
+        while ((result != NULL) &&
+            ((result->name_hash != name_hash) || (strcmp(result->name, name) != 0)))
+        {
+            result = result->next_by_name;
+        }
     }
 
     return result;
@@ -266,38 +635,146 @@ static LINK_ENDPOINT_INSTANCE* find_link_endpoint_by_name(SESSION_INSTANCE* sess
 
 static LINK_ENDPOINT_INSTANCE* find_link_endpoint_by_input_handle(SESSION_INSTANCE* session, handle input_handle)
 {
-    uint32_t i;
     LINK_ENDPOINT_INSTANCE* result;
 
-    for (i = 0; i < session->link_endpoint_count; i++)
+    if (input_handle < session->input_handle_table_size)
+    {
+        result = session->link_endpoints_by_input_handle[input_handle];
+    }
+    else if (input_handle < INPUT_HANDLE_TABLE_MAX_SIZE)
+    {
+        /* the table always covers the mapped handles below its max size */
+        result = NULL;
+    }
+    else
     {
-        if (session->link_endpoints[i]->input_handle == input_handle)
+        uint32_t i;
+
+        result = NULL;
+        for (i = 0; i < session->link_endpoint_count; i++)
         {
-            break;
+            if ((session->link_endpoints[i]->has_input_handle) &&
+                (session->link_endpoints[i]->input_handle == input_handle))
+            {
+                result = session->link_endpoints[i];
+                break;
+            }
         }
     }
 
-    if (i == session->link_endpoint_count)
+    return result;
+}
+
+static int set_link_endpoint_input_handle(SESSION_INSTANCE* session, LINK_ENDPOINT_INSTANCE* link_endpoint, handle input_handle)
+{
+    int result;
+
+    if (input_handle > session->handle_max)
     {
-        result = NULL;
+        LogError("Input handle %u is above the handle max %u", (unsigned int)input_handle, (unsigned int)session->handle_max);
+        result = __FAILURE__;
     }
     else
     {
-        result = session->link_endpoints[i];
+        if ((input_handle >= session->input_handle_table_size) &&
+            (input_handle < INPUT_HANDLE_TABLE_MAX_SIZE))
+        {
+            /* grow geometrically, but never past handle_max or the table max size (handle_max + 1 can be 2^32) */
+            uint64_t new_table_size = (uint64_t)session->input_handle_table_size * 2;
+            LINK_ENDPOINT_INSTANCE** new_table;
+
+            if (new_table_size <= (uint64_t)input_handle)
+            {
+                new_table_size = (uint64_t)input_handle + 1;
+            }
+
+            if (new_table_size > (uint64_t)session->handle_max + 1)
+            {
+                new_table_size = (uint64_t)session->handle_max + 1;
+            }
+
+            if (new_table_size > INPUT_HANDLE_TABLE_MAX_SIZE)
+            {
+                new_table_size = INPUT_HANDLE_TABLE_MAX_SIZE;
+            }
+
+            new_table = (LINK_ENDPOINT_INSTANCE**)realloc(session->link_endpoints_by_input_handle, sizeof(LINK_ENDPOINT_INSTANCE*) * (size_t)new_table_size);
+            if (new_table == NULL)
+            {
+                LogError("Cannot allocate memory for the input handle table");
+            }
+            else
+            {
+                (void)memset(new_table + session->input_handle_table_size, 0, sizeof(LINK_ENDPOINT_INSTANCE*) * (size_t)(new_table_size - session->input_handle_table_size));
+                session->link_endpoints_by_input_handle = new_table;
+                session->input_handle_table_size = (uint32_t)new_table_size;
+            }
+        }
+
+        if ((input_handle >= session->input_handle_table_size) &&
+            (input_handle < INPUT_HANDLE_TABLE_MAX_SIZE))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* a re-attach can pick a different handle */
+            if ((link_endpoint->input_handle < session->input_handle_table_size) &&
+                (session->link_endpoints_by_input_handle[link_endpoint->input_handle] == link_endpoint))
+            {
+                session->link_endpoints_by_input_handle[link_endpoint->input_handle] = NULL;
+            }
+
+            link_endpoint->input_handle = input_handle;
+            link_endpoint->has_input_handle = true;
+            if (input_handle < session->input_handle_table_size)
+            {
+                session->link_endpoints_by_input_handle[input_handle] = link_endpoint;
+            }
+
+            result = 0;
+        }
     }
 
     return result;
 }
 
+static void on_send_queue_drained(void* context)
+{
+    SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)context;
+
+    /* Codes_SRS_SESSION_01_118: [When the send queue of the connection drains, the remote incoming window left shall be offered to the link endpoints as when it opens.] */
+    if ((session_instance->session_state == SESSION_STATE_MAPPED) &&
+        (session_instance->remote_incoming_window > 0))
+    {
+        share_remote_incoming_window(session_instance);
+    }
+}
+
 static void on_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
 {
     SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)context;
 
     /* Codes_SRS_SESSION_01_060: [If the previous connection state is not OPENED and the new connection state is OPENED, the BEGIN frame shall be sent out and the state shall be switched to BEGIN_SENT.] */
     if ((new_connection_state == CONNECTION_STATE_OPENED) && (previous_connection_state != CONNECTION_STATE_OPENED) && (session_instance->session_state == SESSION_STATE_UNMAPPED))
+    {
+        if (session_instance->is_resuming_handover)
+        {
+            /* Codes_SRS_SESSION_01_160: [When the connection of a session restored from a handover state is OPENED, the state shall be switched to MAPPED without sending a BEGIN frame.] */
+            session_instance->is_resuming_handover = false;
+            session_set_state(session_instance, SESSION_STATE_MAPPED);
+        }
+        else if (send_begin(session_instance) == 0)
+        {
+            session_set_state(session_instance, SESSION_STATE_BEGIN_SENT);
+        }
+    }
+    /* Codes_SRS_SESSION_01_103: [If the new connection state is OPEN_PIPE, the BEGIN frame shall be sent out right behind the pipelined OPEN frame and the state shall be switched to BEGIN_SENT.] */
+    else if ((new_connection_state == CONNECTION_STATE_OPEN_PIPE) && (session_instance->session_state == SESSION_STATE_UNMAPPED))
     {
         if (send_begin(session_instance) == 0)
         {
+            session_instance->is_begin_pipelined = true;
             session_set_state(session_instance, SESSION_STATE_BEGIN_SENT);
         }
     }
@@ -313,12 +790,112 @@ static void on_connection_state_changed(void* context, CONNECTION_STATE new_conn
     }
 }
 
-static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t payload_size, const unsigned char* payload_bytes)
+static void on_refused_link_frame_received(void* context, AMQP_VALUE performative, uint64_t performative_code, uint32_t frame_payload_size, const unsigned char* payload_bytes)
+{
+    (void)performative;
+    (void)frame_payload_size;
+    (void)payload_bytes;
+
+    /* Codes_SRS_SESSION_01_132: [The link endpoint of a refused link shall be kept, ignoring the frames received on it, until the peer's detach is received or the session is destroyed.] */
+    if (performative_code == AMQP_DETACH)
+    {
+        session_destroy_link_endpoint((LINK_ENDPOINT_HANDLE)context);
+    }
+}
+
+static int refuse_link(SESSION_INSTANCE* session_instance, const char* name, role remote_role, handle remote_handle)
+{
+    int result;
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session_instance, name);
+
+    if (link_endpoint == NULL)
+    {
+        LogError("Cannot create the link endpoint of the refused link");
+        result = __FAILURE__;
+    }
+    else if (set_link_endpoint_input_handle(session_instance, link_endpoint, remote_handle) != 0)
+    {
+        LogError("Cannot map the input handle of the refused link");
+        session_destroy_link_endpoint(link_endpoint);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the endpoint only takes the handles, so that the peer's detach finds it, no link is built for it */
+        ATTACH_HANDLE attach = attach_create(name, 0, (remote_role == role_sender) ? role_receiver : role_sender);
+
+        link_endpoint->is_refused = true;
+        link_endpoint->frame_received_callback = on_refused_link_frame_received;
+        link_endpoint->callback_context = link_endpoint;
+
+        if (attach == NULL)
+        {
+            LogError("Cannot create the attach performative");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (session_send_attach(link_endpoint, attach) != 0)
+            {
+                LogError("Cannot send the attach");
+                result = __FAILURE__;
+            }
+            else
+            {
+                DETACH_HANDLE detach = detach_create(0);
+                if (detach == NULL)
+                {
+                    LogError("Cannot create the detach performative");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    ERROR_HANDLE error_handle = error_create("amqp:resource-limit-exceeded");
+                    if (error_handle == NULL)
+                    {
+                        LogError("Cannot create the error");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        if ((error_set_description(error_handle, "Link admission limit reached") != 0) ||
+                            (detach_set_closed(detach, true) != 0) ||
+                            (detach_set_error(detach, error_handle) != 0) ||
+                            (session_send_detach(link_endpoint, detach) != 0))
+                        {
+                            LogError("Cannot send the detach");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
+
+                        error_destroy(error_handle);
+                    }
+
+                    detach_destroy(detach);
+                }
+            }
+
+            attach_destroy(attach);
+        }
+    }
+
+    return result;
+}
+
+static void on_frame_received(void* context, AMQP_VALUE performative, uint64_t performative_code, uint32_t payload_size, const unsigned char* payload_bytes)
 {
     SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)context;
-    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
 
-    if (is_begin_type_by_descriptor(descriptor))
+    /* Codes_SRS_SESSION_01_107: [Received performatives shall be dispatched on the performative code passed by the connection, without reading the performative descriptor again.] */
+    switch (performative_code)
+    {
+    default:
+        break;
+
+    case AMQP_BEGIN:
     {
         BEGIN_HANDLE begin_handle;
 
@@ -342,6 +919,15 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
 
                 if (session_instance->session_state == SESSION_STATE_BEGIN_SENT)
                 {
+                    tickcounter_ms_t current_time;
+
+                    if ((session_instance->tick_counter != NULL) &&
+                        (tickcounter_get_current_ms(session_instance->tick_counter, &current_time) == 0))
+                    {
+                        session_instance->round_trip_time = current_time - session_instance->begin_sent_time;
+                        session_instance->rate_sample_start_time = current_time;
+                    }
+
                     session_set_state(session_instance, SESSION_STATE_MAPPED);
                 }
                 else if(session_instance->session_state == SESSION_STATE_UNMAPPED)
@@ -359,8 +945,11 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
                 }
             }
         }
+
+        break;
     }
-    else if (is_attach_type_by_descriptor(descriptor))
+
+    case AMQP_ATTACH:
     {
         const char* name = NULL;
         ATTACH_HANDLE attach_handle;
@@ -394,23 +983,53 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
             else
             {
                 LINK_ENDPOINT_INSTANCE* link_endpoint = find_link_endpoint_by_name(session_instance, name);
+                handle remote_handle;
                 if (link_endpoint == NULL)
                 {
                     /* new link attach */
-                    if (session_instance->on_link_attached != NULL)
+                    if ((session_instance->on_link_attached != NULL) &&
+                        (session_instance->link_admission_limiter != NULL) &&
+                        (!admission_limiter_try_acquire(session_instance->link_admission_limiter)))
+                    {
+                        if (attach_get_handle(attach_handle, &remote_handle) != 0)
+                        {
+                            end_session_with_error(session_instance, "amqp:decode-error", "Cannot get input handle from ATTACH frame");
+                        }
+                        /* Codes_SRS_SESSION_01_131: [When a new link attach is received and the link admission limiter does not admit it, the session shall, without calling on_link_attached, answer with an attach of the opposite role without source and target followed by a detach with closed set to true and the error amqp:resource-limit-exceeded.] */
+                        else if (refuse_link(session_instance, name, role, remote_handle) != 0)
+                        {
+                            /* Codes_SRS_SESSION_01_133: [If refusing the link fails, the session shall be ended with the error amqp:internal-error.] */
+                            end_session_with_error(session_instance, "amqp:internal-error", "Cannot refuse link");
+                        }
+                    }
+                    else if (session_instance->on_link_attached != NULL)
                     {
                         LINK_ENDPOINT_HANDLE new_link_endpoint = session_create_link_endpoint(session_instance, name);
                         if (new_link_endpoint == NULL)
                         {
                             end_session_with_error(session_instance, "amqp:internal-error", "Cannot create link endpoint");
                         }
-                        else if (attach_get_handle(attach_handle, &new_link_endpoint->input_handle) != 0)
+                        else if (attach_get_handle(attach_handle, &remote_handle) != 0)
                         {
                             end_session_with_error(session_instance, "amqp:decode-error", "Cannot get input handle from ATTACH frame");
                         }
+                        else if (set_link_endpoint_input_handle(session_instance, new_link_endpoint, remote_handle) != 0)
+                        {
+                            end_session_with_error(session_instance, "amqp:internal-error", "Cannot map the input handle from ATTACH frame");
+                        }
                         else
                         {
-                            if (!session_instance->on_link_attached(session_instance->on_link_attached_callback_context, new_link_endpoint, name, role, source, target))
+                            uint64_t start_ms;
+                            bool is_timed = connection_begin_callback(session_instance->connection, &start_ms);
+                            bool is_accepted = session_instance->on_link_attached(session_instance->on_link_attached_callback_context, new_link_endpoint, name, role, source, target);
+
+                            /* Codes_SRS_SESSION_01_147: [The call to on_link_attached shall be timed with connection_begin_callback and connection_end_callback as a CONNECTION_CALLBACK_TYPE_LINK_ATTACHED callback of the link name.] */
+                            if (is_timed)
+                            {
+                                connection_end_callback(session_instance->connection, CONNECTION_CALLBACK_TYPE_LINK_ATTACHED, name, start_ms);
+                            }
+
+                            if (!is_accepted)
                             {
                                 session_destroy_link_endpoint(new_link_endpoint);
                                 new_link_endpoint = NULL;
@@ -419,7 +1038,7 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
                             {
                                 if (new_link_endpoint->frame_received_callback != NULL)
                                 {
-                                    new_link_endpoint->frame_received_callback(new_link_endpoint->callback_context, performative, payload_size, payload_bytes);
+                                    new_link_endpoint->frame_received_callback(new_link_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
                                 }
                             }
                         }
@@ -427,21 +1046,28 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
                 }
                 else
                 {
-                    if (attach_get_handle(attach_handle, &link_endpoint->input_handle) != 0)
+                    if (attach_get_handle(attach_handle, &remote_handle) != 0)
                     {
                         end_session_with_error(session_instance, "amqp:decode-error", "Cannot get input handle from ATTACH frame");
                     }
+                    else if (set_link_endpoint_input_handle(session_instance, link_endpoint, remote_handle) != 0)
+                    {
+                        end_session_with_error(session_instance, "amqp:internal-error", "Cannot map the input handle from ATTACH frame");
+                    }
                     else
                     {
-                        link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, payload_size, payload_bytes);
+                        link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
                     }
                 }
             }
 
             attach_destroy(attach_handle);
         }
+
+        break;
     }
-    else if (is_detach_type_by_descriptor(descriptor))
+
+    case AMQP_DETACH:
     {
         DETACH_HANDLE detach_handle;
 
@@ -470,26 +1096,36 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
                 }
                 else
                 {
-                    link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, payload_size, payload_bytes);
+                    link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
                 }
             }
         }
+
+        break;
     }
-    else if (is_flow_type_by_descriptor(descriptor))
+
+    case AMQP_FLOW:
     {
-        FLOW_HANDLE flow_handle;
+        FLOW_FIELDS flow_fields;
+
+        /* Codes_SRS_SESSION_01_101: [Each FLOW, TRANSFER and DISPOSITION frame received shall be counted in the session statistics.] */
+        session_instance->stats.flows_received++;
 
-        if (amqpvalue_get_flow(performative, &flow_handle) != 0)
+        /* Codes_SRS_SESSION_01_106: [The fields of a received FLOW and TRANSFER shall be read in place from the performative, without creating a flow or transfer handle.] */
+        if (amqpvalue_get_flow_fields(performative, &flow_fields) != 0)
         {
             end_session_with_error(session_instance, "amqp:decode-error", "Cannot decode FLOW frame");
         }
         else
         {
-            uint32_t remote_handle;
+            LINK_ENDPOINT_INSTANCE* link_endpoint_instance = NULL;
             transfer_number flow_next_incoming_id;
-            uint32_t flow_incoming_window;
 
-            if (flow_get_next_incoming_id(flow_handle, &flow_next_incoming_id) != 0)
+            if (flow_fields.has_next_incoming_id)
+            {
+                flow_next_incoming_id = flow_fields.next_incoming_id;
+            }
+            else
             {
                 /*
                 If the next-incoming-id field of the flow frame is not set, 
@@ -499,103 +1135,99 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
                 flow_next_incoming_id = session_instance->next_outgoing_id;
             }
 
-            if ((flow_get_next_outgoing_id(flow_handle, &session_instance->next_incoming_id) != 0) ||
-                (flow_get_incoming_window(flow_handle, &flow_incoming_window) != 0))
-            {
-                flow_destroy(flow_handle);
+            session_instance->next_incoming_id = flow_fields.next_outgoing_id;
+            session_instance->remote_incoming_window = flow_next_incoming_id + flow_fields.incoming_window - session_instance->next_outgoing_id;
 
-                end_session_with_error(session_instance, "amqp:decode-error", "Cannot decode FLOW frame");
-            }
-            else
+            /* Codes_SRS_SESSION_01_146: [When a flow gives a remote incoming window above 0 after the session reported the window closed, the session shall report CONNECTION_FLOW_EVENT_SESSION_WINDOW_OPENED with the session as source and the remote incoming window as value.] */
+            if (session_instance->is_remote_window_closed &&
+                (session_instance->remote_incoming_window > 0))
             {
-                LINK_ENDPOINT_INSTANCE* link_endpoint_instance = NULL;
-                size_t i;
-
-                session_instance->remote_incoming_window = flow_next_incoming_id + flow_incoming_window - session_instance->next_outgoing_id;
-
-                if (flow_get_handle(flow_handle, &remote_handle) == 0)
-                {
-                    link_endpoint_instance = find_link_endpoint_by_input_handle(session_instance, remote_handle);
-                }
-
-                flow_destroy(flow_handle);
-
-                if (link_endpoint_instance != NULL)
-                {
-                    link_endpoint_instance->frame_received_callback(link_endpoint_instance->callback_context, performative, payload_size, payload_bytes);
-                }
+                session_instance->is_remote_window_closed = false;
+                connection_report_flow_event(session_instance->connection, CONNECTION_FLOW_EVENT_SESSION_WINDOW_OPENED, session_instance, NULL, session_instance->remote_incoming_window);
+            }
 
-                i = 0;
-                while ((session_instance->remote_incoming_window > 0) && (i < session_instance->link_endpoint_count))
-                {
-                    /* notify the caller that it can send here */
-                    if (session_instance->link_endpoints[i]->on_session_flow_on != NULL)
-                    {
-                        session_instance->link_endpoints[i]->on_session_flow_on(session_instance->link_endpoints[i]->callback_context);
-                    }
+            if (flow_fields.has_handle)
+            {
+                link_endpoint_instance = find_link_endpoint_by_input_handle(session_instance, flow_fields.handle);
+            }
 
-                    i++;
-                }
+            if (link_endpoint_instance != NULL)
+            {
+                link_endpoint_instance->frame_received_callback(link_endpoint_instance->callback_context, performative, performative_code, payload_size, payload_bytes);
             }
+
+            share_remote_incoming_window(session_instance);
         }
+
+        break;
     }
-    else if (is_transfer_type_by_descriptor(descriptor))
+
+    case AMQP_TRANSFER:
     {
-        TRANSFER_HANDLE transfer_handle;
+        TRANSFER_FIELDS transfer_fields;
 
-        if (amqpvalue_get_transfer(performative, &transfer_handle) != 0)
+        session_instance->stats.transfers_received++;
+
+        if (amqpvalue_get_transfer_fields(performative, &transfer_fields) != 0)
         {
             end_session_with_error(session_instance, "amqp:decode-error", "Cannot decode TRANSFER frame");
         }
         else
         {
-            uint32_t remote_handle;
-            delivery_number delivery_id;
+            LINK_ENDPOINT_INSTANCE* link_endpoint;
 
-            transfer_get_delivery_id(transfer_handle, &delivery_id);
-            if (transfer_get_handle(transfer_handle, &remote_handle) != 0)
+            session_instance->next_incoming_id++;
+            session_instance->remote_outgoing_window--;
+            session_instance->incoming_window--;
+
+            link_endpoint = find_link_endpoint_by_input_handle(session_instance, transfer_fields.handle);
+            if (link_endpoint == NULL)
             {
-                transfer_destroy(transfer_handle);
-                end_session_with_error(session_instance, "amqp:decode-error", "Cannot get handle from TRANSFER frame");
+                end_session_with_error(session_instance, "amqp:session:unattached-handle", "");
             }
             else
             {
-                LINK_ENDPOINT_INSTANCE* link_endpoint;
-                transfer_destroy(transfer_handle);
-
-                session_instance->next_incoming_id++;
-                session_instance->remote_outgoing_window--;
-                session_instance->incoming_window--;
+                link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
+            }
 
-                link_endpoint = find_link_endpoint_by_input_handle(session_instance, remote_handle);
-                if (link_endpoint == NULL)
-                {
-                    end_session_with_error(session_instance, "amqp:session:unattached-handle", "");
-                }
-                else
-                {
-                    link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, payload_size, payload_bytes);
-                }
+            if (session_instance->window_policy == SESSION_WINDOW_POLICY_ADAPTIVE)
+            {
+                session_instance->rate_sample_transfer_count++;
 
-                if (session_instance->incoming_window == 0)
+                /* Codes_SRS_SESSION_01_090: [With the adaptive window policy the incoming window shall be reissued once half of it has been consumed.] */
+                if (session_instance->incoming_window <= session_instance->desired_incoming_window / 2)
                 {
+                    adapt_incoming_window(session_instance);
                     session_instance->incoming_window = session_instance->desired_incoming_window;
                     send_flow(session_instance);
                 }
             }
+            else if (session_instance->incoming_window == 0)
+            {
+                session_instance->incoming_window = session_instance->desired_incoming_window;
+                send_flow(session_instance);
+            }
         }
+
+        break;
     }
-    else if (is_disposition_type_by_descriptor(descriptor))
+
+    case AMQP_DISPOSITION:
     {
         uint32_t i;
 
+        session_instance->stats.dispositions_received++;
+
         for (i = 0; i < session_instance->link_endpoint_count; i++)
         {
             LINK_ENDPOINT_INSTANCE* link_endpoint = session_instance->link_endpoints[i];
-            link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, payload_size, payload_bytes);
+            link_endpoint->frame_received_callback(link_endpoint->callback_context, performative, performative_code, payload_size, payload_bytes);
         }
+
+        break;
     }
-    else if (is_end_type_by_descriptor(descriptor))
+
+    case AMQP_END:
     {
         END_HANDLE end_handle;
 
@@ -619,7 +1251,121 @@ static void on_frame_received(void* context, AMQP_VALUE performative, uint32_t p
                 session_set_state(session_instance, SESSION_STATE_DISCARDING);
             }
         }
+
+        break;
+    }
+    }
+}
+
+static int send_link_flow(LINK_ENDPOINT_INSTANCE* link_endpoint_instance, sequence_no delivery_count, uint32_t link_credit, bool drain)
+{
+    int result;
+    SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint_instance->session;
+    ENCODED_PERFORMATIVE flow;
+
+    /* a drain flow also carries available (left null) to get to the drain field */
+    begin_encoded_performative(&flow, AMQP_FLOW, drain ? 9 : 7);
+    add_encoded_uint_field(&flow, session_instance->next_incoming_id);
+    add_encoded_uint_field(&flow, session_instance->incoming_window);
+    add_encoded_uint_field(&flow, session_instance->next_outgoing_id);
+    add_encoded_uint_field(&flow, session_instance->outgoing_window);
+    add_encoded_uint_field(&flow, link_endpoint_instance->output_handle);
+    add_encoded_uint_field(&flow, delivery_count);
+    add_encoded_uint_field(&flow, link_credit);
+    if (drain)
+    {
+        flow.bytes[flow.size] = 0x40;
+        flow.size++;
+        add_encoded_bool_field(&flow, true);
+    }
+    end_encoded_performative(&flow);
+
+    if (connection_encode_frame_with_encoded_performative(session_instance->endpoint, flow.bytes, flow.size, NULL, 0, NULL, NULL) != 0)
+    {
+        LogError("Cannot send flow frame");
+        result = __FAILURE__;
+    }
+    else
+    {
+        session_instance->stats.flows_sent++;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void drop_pending_flow(LINK_ENDPOINT_INSTANCE* link_endpoint_instance)
+{
+    if (link_endpoint_instance->has_pending_flow)
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint_instance->session;
+        LINK_ENDPOINT_INSTANCE** pending_flow = &session_instance->first_pending_flow;
+
+        while (*pending_flow != link_endpoint_instance)
+        {
+            pending_flow = &(*pending_flow)->next_pending_flow;
+        }
+
+        *pending_flow = link_endpoint_instance->next_pending_flow;
+        link_endpoint_instance->next_pending_flow = NULL;
+        link_endpoint_instance->has_pending_flow = false;
+    }
+}
+
+static void send_pending_flows(SESSION_INSTANCE* session_instance)
+{
+    /* sending may end the session, so each endpoint leaves the list before its flow is sent */
+    while (session_instance->first_pending_flow != NULL)
+    {
+        LINK_ENDPOINT_INSTANCE* link_endpoint_instance = session_instance->first_pending_flow;
+
+        session_instance->first_pending_flow = link_endpoint_instance->next_pending_flow;
+        link_endpoint_instance->next_pending_flow = NULL;
+        link_endpoint_instance->has_pending_flow = false;
+
+        /* Codes_SRS_SESSION_01_141: [Pending link flows shall only be sent while the session is mapped or its BEGIN is pipelined, otherwise they shall be dropped.] */
+        if (((session_instance->session_state == SESSION_STATE_MAPPED) ||
+            ((session_instance->session_state == SESSION_STATE_BEGIN_SENT) && session_instance->is_begin_pipelined)) &&
+            (send_link_flow(link_endpoint_instance, link_endpoint_instance->pending_flow_delivery_count, link_endpoint_instance->pending_flow_link_credit, false) != 0))
+        {
+            LogError("Cannot send pending link flow");
+        }
+    }
+}
+
+static void on_session_endpoint_dowork(void* context)
+{
+    SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)context;
+    uint32_t i;
+
+    /* Codes_SRS_SESSION_01_140: [On every connection_dowork, the session shall send the pending link flows, one flow frame per link endpoint carrying the latest delivery_count and link_credit given for it.] */
+    send_pending_flows(session_instance);
+
+    /* Codes_SRS_SESSION_01_170: [On every connection_dowork, the session shall call the on_dowork callback of each link endpoint that has one.] */
+    for (i = 0; i < session_instance->link_endpoint_count; i++)
+    {
+        if (session_instance->link_endpoints[i]->on_dowork != NULL)
+        {
+            session_instance->link_endpoints[i]->on_dowork(session_instance->link_endpoints[i]->on_dowork_context);
+        }
+    }
+}
+
+static int update_session_endpoint_dowork(SESSION_INSTANCE* session_instance)
+{
+    int result;
+
+    if (session_instance->is_deferring_link_flows ||
+        (session_instance->dowork_link_endpoint_count > 0))
+    {
+        result = connection_endpoint_set_on_dowork(session_instance->endpoint, on_session_endpoint_dowork, session_instance);
     }
+    else
+    {
+        result = connection_endpoint_set_on_dowork(session_instance->endpoint, NULL, NULL);
+    }
+
+    return result;
 }
 
 SESSION_HANDLE session_create(CONNECTION_HANDLE connection, ON_LINK_ATTACHED on_link_attached, void* callback_context)
@@ -640,24 +1386,46 @@ SESSION_HANDLE session_create(CONNECTION_HANDLE connection, ON_LINK_ATTACHED on_
         {
             result->connection = connection;
             result->link_endpoints = NULL;
+            result->link_endpoints_by_name = NULL;
             result->link_endpoint_count = 0;
-            result->handle_max = 4294967295u;
+            result->link_endpoint_capacity = 0;
+            result->link_endpoints_by_input_handle = NULL;
+            result->input_handle_table_size = 0;
+            result->handle_max = DEFAULT_HANDLE_MAX;
 
             /* Codes_SRS_SESSION_01_057: [The delivery ids shall be assigned starting at 0.] */
             /* Codes_SRS_SESSION_01_017: [The nextoutgoing-id MAY be initialized to an arbitrary value ] */
             result->next_outgoing_id = 0;
 
-            result->desired_incoming_window = 1;
-            result->incoming_window = 1;
-            result->outgoing_window = 1;
-            result->handle_max = 4294967295u;
+            result->desired_incoming_window = DEFAULT_SESSION_WINDOW;
+            result->incoming_window = DEFAULT_SESSION_WINDOW;
+            result->outgoing_window = DEFAULT_SESSION_WINDOW;
+            result->handle_max = DEFAULT_HANDLE_MAX;
             result->remote_incoming_window = 0;
             result->remote_outgoing_window = 0;
+            result->link_scheduler = SESSION_LINK_SCHEDULER_ROUND_ROBIN;
+            result->next_flow_on_index = 0;
+            result->is_sharing_window = false;
+            result->window_policy = SESSION_WINDOW_POLICY_FIXED;
+            result->max_incoming_window = DEFAULT_SESSION_WINDOW;
+            result->tick_counter = NULL;
+            result->begin_sent_time = 0;
+            result->round_trip_time = 0;
+            (void)memset(&result->stats, 0, sizeof(result->stats));
+            result->rate_sample_start_time = 0;
+            result->rate_sample_transfer_count = 0;
             result->previous_session_state = SESSION_STATE_UNMAPPED;
             result->is_underlying_connection_open = UNDERLYING_CONNECTION_NOT_OPEN;
+            result->is_begin_pipelined = false;
+            result->is_resuming_handover = false;
             result->session_state = SESSION_STATE_UNMAPPED;
             result->on_link_attached = on_link_attached;
             result->on_link_attached_callback_context = callback_context;
+            result->link_admission_limiter = NULL;
+            result->is_deferring_link_flows = false;
+            result->is_remote_window_closed = false;
+            result->first_pending_flow = NULL;
+            result->dowork_link_endpoint_count = 0;
 
             /* Codes_SRS_SESSION_01_032: [session_create shall create a new session endpoint by calling connection_create_endpoint.] */
             result->endpoint = connection_create_endpoint(connection);
@@ -674,6 +1442,11 @@ SESSION_HANDLE session_create(CONNECTION_HANDLE connection, ON_LINK_ATTACHED on_
         }
     }
 
+    if (result != NULL)
+    {
+        ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_SESSION, sizeof(SESSION_INSTANCE));
+    }
+
     return result;
 }
 
@@ -692,28 +1465,55 @@ SESSION_HANDLE session_create_from_endpoint(CONNECTION_HANDLE connection, ENDPOI
         {
             result->connection = connection;
             result->link_endpoints = NULL;
+            result->link_endpoints_by_name = NULL;
             result->link_endpoint_count = 0;
-            result->handle_max = 4294967295u;
+            result->link_endpoint_capacity = 0;
+            result->link_endpoints_by_input_handle = NULL;
+            result->input_handle_table_size = 0;
+            result->handle_max = DEFAULT_HANDLE_MAX;
 
             result->next_outgoing_id = 0;
 
-            result->desired_incoming_window = 1;
-            result->incoming_window = 1;
-            result->outgoing_window = 1;
-            result->handle_max = 4294967295u;
+            result->desired_incoming_window = DEFAULT_SESSION_WINDOW;
+            result->incoming_window = DEFAULT_SESSION_WINDOW;
+            result->outgoing_window = DEFAULT_SESSION_WINDOW;
+            result->handle_max = DEFAULT_HANDLE_MAX;
             result->remote_incoming_window = 0;
             result->remote_outgoing_window = 0;
+            result->link_scheduler = SESSION_LINK_SCHEDULER_ROUND_ROBIN;
+            result->next_flow_on_index = 0;
+            result->is_sharing_window = false;
+            result->window_policy = SESSION_WINDOW_POLICY_FIXED;
+            result->max_incoming_window = DEFAULT_SESSION_WINDOW;
+            result->tick_counter = NULL;
+            result->begin_sent_time = 0;
+            result->round_trip_time = 0;
+            (void)memset(&result->stats, 0, sizeof(result->stats));
+            result->rate_sample_start_time = 0;
+            result->rate_sample_transfer_count = 0;
             result->previous_session_state = SESSION_STATE_UNMAPPED;
             result->is_underlying_connection_open = UNDERLYING_CONNECTION_NOT_OPEN;
+            result->is_begin_pipelined = false;
+            result->is_resuming_handover = false;
             result->session_state = SESSION_STATE_UNMAPPED;
             result->on_link_attached = on_link_attached;
             result->on_link_attached_callback_context = callback_context;
+            result->link_admission_limiter = NULL;
+            result->is_deferring_link_flows = false;
+            result->is_remote_window_closed = false;
+            result->first_pending_flow = NULL;
+            result->dowork_link_endpoint_count = 0;
 
             result->endpoint = endpoint;
             session_set_state(result, SESSION_STATE_UNMAPPED);
         }
     }
 
+    if (result != NULL)
+    {
+        ALLOC_COUNTERS_ADD_OBJECT(ALLOC_OBJECT_TYPE_SESSION, sizeof(SESSION_INSTANCE));
+    }
+
     return result;
 }
 
@@ -726,6 +1526,20 @@ void session_destroy(SESSION_HANDLE session)
 
         session_end(session, NULL, NULL);
 
+        /* Codes_SRS_SESSION_01_132: [The link endpoint of a refused link shall be kept, ignoring the frames received on it, until the peer's detach is received or the session is destroyed.] */
+        /* the other link endpoints belong to their links, destroying one does not move the ones before it */
+        {
+            uint32_t i = session_instance->link_endpoint_count;
+            while (i > 0)
+            {
+                i--;
+                if (session_instance->link_endpoints[i]->is_refused)
+                {
+                    session_destroy_link_endpoint(session_instance->link_endpoints[i]);
+                }
+            }
+        }
+
         /* Codes_SRS_SESSION_01_034: [session_destroy shall free all resources allocated by session_create.] */
         /* Codes_SRS_SESSION_01_035: [The endpoint created in session_create shall be freed by calling connection_destroy_endpoint.] */
         connection_destroy_endpoint(session_instance->endpoint);
@@ -734,6 +1548,17 @@ void session_destroy(SESSION_HANDLE session)
             free(session_instance->link_endpoints);
         }
 
+        if (session_instance->link_endpoints_by_input_handle != NULL)
+        {
+            free(session_instance->link_endpoints_by_input_handle);
+        }
+
+        if (session_instance->tick_counter != NULL)
+        {
+            tickcounter_destroy(session_instance->tick_counter);
+        }
+
+        ALLOC_COUNTERS_REMOVE_OBJECT(ALLOC_OBJECT_TYPE_SESSION, sizeof(SESSION_INSTANCE));
         free(session);
     }
 }
@@ -750,7 +1575,8 @@ int session_begin(SESSION_HANDLE session)
     {
         SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
 
-        if (connection_start_endpoint(session_instance->endpoint, on_frame_received, on_connection_state_changed, session_instance) != 0)
+        if ((connection_start_endpoint(session_instance->endpoint, on_frame_received, on_connection_state_changed, session_instance) != 0) ||
+            (connection_endpoint_set_on_send_queue_drained(session_instance->endpoint, on_send_queue_drained, session_instance) != 0))
         {
             result = __FAILURE__;
         }
@@ -861,53 +1687,87 @@ int session_set_incoming_window(SESSION_HANDLE session, uint32_t incoming_window
     return result;
 }
 
-int session_get_incoming_window(SESSION_HANDLE session, uint32_t* incoming_window)
+int session_set_link_scheduler(SESSION_HANDLE session, SESSION_LINK_SCHEDULER link_scheduler)
 {
     int result;
 
+    /* Codes_SRS_SESSION_01_092: [If session is NULL or link_scheduler is not a known scheduler, session_set_link_scheduler shall fail and return a non-zero value.] */
     if ((session == NULL) ||
-        (incoming_window == NULL))
+        ((link_scheduler != SESSION_LINK_SCHEDULER_ROUND_ROBIN) && (link_scheduler != SESSION_LINK_SCHEDULER_WEIGHTED)))
     {
+        LogError("Bad arguments: session = %p, link_scheduler = %d",
+            session, (int)link_scheduler);
         result = __FAILURE__;
     }
     else
     {
         SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
 
-        *incoming_window = session_instance->incoming_window;
-
+        /* Codes_SRS_SESSION_01_093: [On success, session_set_link_scheduler shall return 0.] */
+        session_instance->link_scheduler = link_scheduler;
         result = 0;
     }
 
     return result;
 }
 
-int session_set_outgoing_window(SESSION_HANDLE session, uint32_t outgoing_window)
+int session_set_window_policy(SESSION_HANDLE session, SESSION_WINDOW_POLICY window_policy, uint32_t max_window)
 {
     int result;
 
-    if (session == NULL)
+    /* Codes_SRS_SESSION_01_085: [If session is NULL, window_policy is not a known policy or max_window is 0, session_set_window_policy shall fail and return a non-zero value.] */
+    if ((session == NULL) ||
+        ((window_policy != SESSION_WINDOW_POLICY_FIXED) && (window_policy != SESSION_WINDOW_POLICY_ADAPTIVE)) ||
+        (max_window == 0))
     {
+        LogError("Bad arguments: session = %p, window_policy = %d, max_window = %u",
+            session, (int)window_policy, (unsigned int)max_window);
         result = __FAILURE__;
     }
     else
     {
         SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
 
-        session_instance->outgoing_window = outgoing_window;
+        /* Codes_SRS_SESSION_01_086: [For SESSION_WINDOW_POLICY_ADAPTIVE, session_set_window_policy shall create a tick counter by calling tickcounter_create if the session does not have one yet.] */
+        if ((window_policy == SESSION_WINDOW_POLICY_ADAPTIVE) &&
+            (session_instance->tick_counter == NULL) &&
+            ((session_instance->tick_counter = tickcounter_create()) == NULL))
+        {
+            /* Codes_SRS_SESSION_01_087: [If tickcounter_create fails, session_set_window_policy shall fail and return a non-zero value.] */
+            LogError("Cannot create tick counter for the adaptive window");
+            result = __FAILURE__;
+        }
+        else
+        {
+            session_instance->window_policy = window_policy;
+            session_instance->max_incoming_window = max_window;
 
-        result = 0;
+            /* Codes_SRS_SESSION_01_091: [For SESSION_WINDOW_POLICY_ADAPTIVE the incoming window shall start at 256 transfers or max_window if smaller.] */
+            if (window_policy == SESSION_WINDOW_POLICY_ADAPTIVE)
+            {
+                session_instance->desired_incoming_window = (max_window < ADAPTIVE_INITIAL_WINDOW) ? max_window : ADAPTIVE_INITIAL_WINDOW;
+                session_instance->incoming_window = session_instance->desired_incoming_window;
+                session_instance->rate_sample_transfer_count = 0;
+                if (tickcounter_get_current_ms(session_instance->tick_counter, &session_instance->rate_sample_start_time) != 0)
+                {
+                    session_instance->rate_sample_start_time = 0;
+                }
+            }
+
+            /* Codes_SRS_SESSION_01_088: [On success, session_set_window_policy shall return 0.] */
+            result = 0;
+        }
     }
 
     return result;
 }
 
-int session_get_outgoing_window(SESSION_HANDLE session, uint32_t* outgoing_window)
+int session_get_incoming_window(SESSION_HANDLE session, uint32_t* incoming_window)
 {
     int result;
 
     if ((session == NULL) ||
-        (outgoing_window == NULL))
+        (incoming_window == NULL))
     {
         result = __FAILURE__;
     }
@@ -915,7 +1775,7 @@ int session_get_outgoing_window(SESSION_HANDLE session, uint32_t* outgoing_windo
     {
         SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
 
-        *outgoing_window = session_instance->outgoing_window;
+        *incoming_window = session_instance->incoming_window;
 
         result = 0;
     }
@@ -923,7 +1783,7 @@ int session_get_outgoing_window(SESSION_HANDLE session, uint32_t* outgoing_windo
     return result;
 }
 
-int session_set_handle_max(SESSION_HANDLE session, handle handle_max)
+int session_set_outgoing_window(SESSION_HANDLE session, uint32_t outgoing_window)
 {
     int result;
 
@@ -935,7 +1795,7 @@ int session_set_handle_max(SESSION_HANDLE session, handle handle_max)
     {
         SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
 
-        session_instance->handle_max = handle_max;
+        session_instance->outgoing_window = outgoing_window;
 
         result = 0;
     }
@@ -943,12 +1803,12 @@ int session_set_handle_max(SESSION_HANDLE session, handle handle_max)
     return result;
 }
 
-int session_get_handle_max(SESSION_HANDLE session, handle* handle_max)
+int session_get_outgoing_window(SESSION_HANDLE session, uint32_t* outgoing_window)
 {
     int result;
 
     if ((session == NULL) ||
-        (handle_max == NULL))
+        (outgoing_window == NULL))
     {
         result = __FAILURE__;
     }
@@ -956,7 +1816,7 @@ int session_get_handle_max(SESSION_HANDLE session, handle* handle_max)
     {
         SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
 
-        *handle_max = session_instance->handle_max;
+        *outgoing_window = session_instance->outgoing_window;
 
         result = 0;
     }
@@ -964,13 +1824,202 @@ int session_get_handle_max(SESSION_HANDLE session, handle* handle_max)
     return result;
 }
 
-LINK_ENDPOINT_HANDLE session_create_link_endpoint(SESSION_HANDLE session, const char* name)
+int session_set_handle_max(SESSION_HANDLE session, handle handle_max)
 {
-    LINK_ENDPOINT_INSTANCE* result;
+    int result;
 
-    /* Codes_SRS_SESSION_01_044: [If session, name or frame_received_callback is NULL, session_create_link_endpoint shall fail and return NULL.] */
-    if ((session == NULL) ||
-        (name == NULL))
+    if (session == NULL)
+    {
+        result = __FAILURE__;
+    }
+#ifdef UAMQP_STATIC_POOLS
+    /* Codes_SRS_SESSION_01_120: [When built with UAMQP_STATIC_POOLS, the handle max of a new session shall be UAMQP_STATIC_MAX_LINKS - 1 and session_set_handle_max shall fail for bigger values.] */
+    else if (handle_max > DEFAULT_HANDLE_MAX)
+    {
+        LogError("handle_max bigger than the static link capacity %u", (unsigned int)UAMQP_STATIC_MAX_LINKS);
+        result = __FAILURE__;
+    }
+#endif
+    else
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
+
+        session_instance->handle_max = handle_max;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_get_handle_max(SESSION_HANDLE session, handle* handle_max)
+{
+    int result;
+
+    if ((session == NULL) ||
+        (handle_max == NULL))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
+
+        *handle_max = session_instance->handle_max;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_get_connection(SESSION_HANDLE session, CONNECTION_HANDLE* connection)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_135: [If session or connection is NULL, session_get_connection shall fail and return a non-zero value.] */
+    if ((session == NULL) ||
+        (connection == NULL))
+    {
+        LogError("Bad arguments: session = %p, connection = %p",
+            session, connection);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_SESSION_01_134: [session_get_connection shall return in connection the connection the session was created on and return 0.] */
+        *connection = session->connection;
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_set_link_admission_limiter(SESSION_HANDLE session, ADMISSION_LIMITER_HANDLE link_admission_limiter)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_130: [If session is NULL, session_set_link_admission_limiter shall fail and return a non-zero value.] */
+    if (session == NULL)
+    {
+        LogError("NULL session");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_SESSION_01_129: [session_set_link_admission_limiter shall make the session check the new link attaches it receives against link_admission_limiter, a NULL link_admission_limiter admitting all of them, and return 0.] */
+        session->link_admission_limiter = link_admission_limiter;
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_set_deferred_link_flows(SESSION_HANDLE session, bool deferred_link_flows)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_136: [If session is NULL, session_set_deferred_link_flows shall fail and return a non-zero value.] */
+    if (session == NULL)
+    {
+        LogError("NULL session");
+        result = __FAILURE__;
+    }
+    else if (deferred_link_flows)
+    {
+        /* Codes_SRS_SESSION_01_137: [When deferred_link_flows is true, session_set_deferred_link_flows shall register a callback with connection_endpoint_set_on_dowork that sends the pending link flows, and return 0.] */
+        session->is_deferring_link_flows = true;
+        if (update_session_endpoint_dowork(session) != 0)
+        {
+            /* Codes_SRS_SESSION_01_138: [If connection_endpoint_set_on_dowork fails, session_set_deferred_link_flows shall fail and return a non-zero value.] */
+            LogError("Cannot set the dowork callback of the session endpoint");
+            session->is_deferring_link_flows = false;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else
+    {
+        /* Codes_SRS_SESSION_01_144: [When deferred_link_flows is false, session_set_deferred_link_flows shall send the pending link flows right away, remove the callback with connection_endpoint_set_on_dowork and return 0.] */
+        session->is_deferring_link_flows = false;
+        send_pending_flows(session);
+
+        /* the callback stays while link endpoints have an on_dowork callback */
+        if (update_session_endpoint_dowork(session) != 0)
+        {
+            /* Codes_SRS_SESSION_01_138: [If connection_endpoint_set_on_dowork fails, session_set_deferred_link_flows shall fail and return a non-zero value.] */
+            LogError("Cannot remove the dowork callback of the session endpoint");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int session_get_stats(SESSION_HANDLE session, SESSION_STATS* stats)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_099: [If session or stats is NULL, session_get_stats shall fail and return a non-zero value.] */
+    if ((session == NULL) ||
+        (stats == NULL))
+    {
+        LogError("Bad arguments: session = %p, stats = %p",
+            session, stats);
+        result = __FAILURE__;
+    }
+    else
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
+
+        /* Codes_SRS_SESSION_01_100: [session_get_stats shall copy the session statistics counted since the session was created into stats and return 0.] */
+        *stats = session_instance->stats;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_get_pipelined_begin(SESSION_HANDLE session, bool* pipelined_begin)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_104: [If session or pipelined_begin is NULL, session_get_pipelined_begin shall fail and return a non-zero value.] */
+    if ((session == NULL) ||
+        (pipelined_begin == NULL))
+    {
+        LogError("Bad arguments: session = %p, pipelined_begin = %p",
+            session, pipelined_begin);
+        result = __FAILURE__;
+    }
+    else
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
+
+        /* Codes_SRS_SESSION_01_105: [session_get_pipelined_begin shall return in pipelined_begin whether the BEGIN frame was pipelined behind the OPEN frame of the connection, and return 0.] */
+        *pipelined_begin = session_instance->is_begin_pipelined;
+
+        result = 0;
+    }
+
+    return result;
+}
+
+LINK_ENDPOINT_HANDLE session_create_link_endpoint(SESSION_HANDLE session, const char* name)
+{
+    LINK_ENDPOINT_INSTANCE* result;
+
+    /* Codes_SRS_SESSION_01_044: [If session, name or frame_received_callback is NULL, session_create_link_endpoint shall fail and return NULL.] */
+    if ((session == NULL) ||
+        (name == NULL))
     {
         result = NULL;
     }
@@ -979,57 +2028,101 @@ LINK_ENDPOINT_HANDLE session_create_link_endpoint(SESSION_HANDLE session, const
         /* Codes_SRS_SESSION_01_043: [session_create_link_endpoint shall create a link endpoint associated with a given session and return a non-NULL handle to it.] */
         SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)session;
 
-        result = (LINK_ENDPOINT_INSTANCE*)malloc(sizeof(LINK_ENDPOINT_INSTANCE));
+        size_t name_length = strlen(name);
+
+        /* Codes_SRS_SESSION_01_121: [The name of the link endpoint shall be copied in the same allocation as the link endpoint.] */
+        result = (LINK_ENDPOINT_INSTANCE*)malloc(sizeof(LINK_ENDPOINT_INSTANCE) + name_length + 1);
         /* Codes_SRS_SESSION_01_045: [If allocating memory for the link endpoint fails, session_create_link_endpoint shall fail and return NULL.] */
         if (result != NULL)
         {
             /* Codes_SRS_SESSION_01_046: [An unused handle shall be assigned to the link endpoint.] */
-            handle selected_handle = 0;
-            size_t i;
-            size_t name_length;
-
-            for (i = 0; i < session_instance->link_endpoint_count; i++)
+            /* Codes_SRS_SESSION_01_047: [The lowest available handle shall be used.] */
+            /* the endpoints are sorted by their unique output handles, so the first endpoint whose handle is above
+            its index is right after the lowest free handle and can be found with a binary search */
+            uint32_t low = 0;
+            uint32_t high = session_instance->link_endpoint_count;
+            handle selected_handle;
+
+            while (low < high)
             {
-                if (session_instance->link_endpoints[i]->output_handle > selected_handle)
+                uint32_t middle = low + ((high - low) / 2);
+                if (session_instance->link_endpoints[middle]->output_handle > middle)
                 {
-                    break;
+                    high = middle;
+                }
+                else
+                {
+                    low = middle + 1;
                 }
-
-                selected_handle++;
             }
 
+            selected_handle = low;
+
             result->on_session_state_changed = NULL;
             result->on_session_flow_on = NULL;
             result->frame_received_callback = NULL;
             result->callback_context = NULL;
             result->output_handle = selected_handle;
             result->input_handle = 0xFFFFFFFF;
-            name_length = strlen(name);
-            result->name = (char*)malloc(name_length + 1);
-            if (result->name == NULL)
+            result->has_input_handle = false;
+            result->on_dowork = NULL;
+            result->on_dowork_context = NULL;
+            result->next_by_name = NULL;
+            result->transfer_template = NULL;
+            result->transfer_template_size = 0;
+            result->scheduling_weight = 1;
+            result->window_share = 0;
+            result->is_sending_transfer_parts = false;
+            result->is_refused = false;
+            result->has_pending_flow = false;
+            result->next_pending_flow = NULL;
+            result->name = (char*)(result + 1);
+
+            /* Codes_SRS_SESSION_01_048: [If no more handles are available, session_create_link_endpoint shall fail and return NULL.] */
+            if ((selected_handle > session_instance->handle_max) ||
+                (session_instance->link_endpoint_count == UINT32_MAX))
             {
-                /* Codes_SRS_SESSION_01_045: [If allocating memory for the link endpoint fails, session_create_link_endpoint shall fail and return NULL.] */
+                LogError("No more handles available for link endpoint");
                 free(result);
                 result = NULL;
             }
             else
             {
-                LINK_ENDPOINT_INSTANCE** new_link_endpoints;
                 (void)memcpy(result->name, name, name_length + 1);
+                result->name_hash = get_link_name_hash(name);
                 result->session = session;
 
-                new_link_endpoints = (LINK_ENDPOINT_INSTANCE**)realloc(session_instance->link_endpoints, sizeof(LINK_ENDPOINT_INSTANCE*) * (session_instance->link_endpoint_count + 1));
-                if (new_link_endpoints == NULL)
+                if (session_instance->link_endpoint_count == session_instance->link_endpoint_capacity)
                 {
-                    /* Codes_SRS_SESSION_01_045: [If allocating memory for the link endpoint fails, session_create_link_endpoint shall fail and return NULL.] */
-                    free(result->name);
-                    free(result);
-                    result = NULL;
+                    /* the capacity doubles (and stays a power of 2 for the name buckets) */
+                    uint32_t new_capacity = (session_instance->link_endpoint_capacity == 0) ? 4 : (session_instance->link_endpoint_capacity * 2);
+                    LINK_ENDPOINT_INSTANCE** new_link_endpoints = (new_capacity < session_instance->link_endpoint_capacity) ? NULL :
+                        (LINK_ENDPOINT_INSTANCE**)realloc(session_instance->link_endpoints, sizeof(LINK_ENDPOINT_INSTANCE*) * 2 * (size_t)new_capacity);
+                    if (new_link_endpoints == NULL)
+                    {
+                        /* Codes_SRS_SESSION_01_045: [If allocating memory for the link endpoint fails, session_create_link_endpoint shall fail and return NULL.] */
+                        free(result);
+                        result = NULL;
+                    }
+                    else
+                    {
+                        uint32_t i;
+
+                        session_instance->link_endpoints = new_link_endpoints;
+                        session_instance->link_endpoints_by_name = new_link_endpoints + new_capacity;
+                        session_instance->link_endpoint_capacity = new_capacity;
+
+                        /* the bucket of each endpoint depends on the capacity */
+                        (void)memset(session_instance->link_endpoints_by_name, 0, sizeof(LINK_ENDPOINT_INSTANCE*) * new_capacity);
+                        for (i = 0; i < session_instance->link_endpoint_count; i++)
+                        {
+                            add_link_endpoint_to_name_buckets(session_instance, session_instance->link_endpoints[i]);
+                        }
+                    }
                 }
-                else
-                {
-                    session_instance->link_endpoints = new_link_endpoints;
 
+                if (result != NULL)
+                {
                     if (session_instance->link_endpoint_count - selected_handle > 0)
                     {
                         (void)memmove(&session_instance->link_endpoints[selected_handle + 1], &session_instance->link_endpoints[selected_handle], (session_instance->link_endpoint_count - selected_handle) * sizeof(LINK_ENDPOINT_INSTANCE*));
@@ -1037,6 +2130,7 @@ LINK_ENDPOINT_HANDLE session_create_link_endpoint(SESSION_HANDLE session, const
 
                     session_instance->link_endpoints[selected_handle] = result;
                     session_instance->link_endpoint_count++;
+                    add_link_endpoint_to_name_buckets(session_instance, result);
                 }
             }
         }
@@ -1052,24 +2146,51 @@ void session_destroy_link_endpoint(LINK_ENDPOINT_HANDLE link_endpoint)
     {
         LINK_ENDPOINT_INSTANCE* endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
         SESSION_INSTANCE* session_instance = endpoint_instance->session;
-        uint64_t i;
+        uint32_t i = 0;
+        uint32_t high = session_instance->link_endpoint_count;
+
+        /* Codes_SRS_SESSION_01_143: [The flow pending for a link endpoint shall be dropped when a detach is sent for it or it is destroyed.] */
+        drop_pending_flow(endpoint_instance);
+
+        if (endpoint_instance->on_dowork != NULL)
+        {
+            endpoint_instance->on_dowork = NULL;
+            session_instance->dowork_link_endpoint_count--;
+            if (update_session_endpoint_dowork(session_instance) != 0)
+            {
+                LogError("Cannot update the dowork callback of the session endpoint");
+            }
+        }
 
         /* Codes_SRS_SESSION_01_049: [session_destroy_link_endpoint shall free all resources associated with the endpoint.] */
-        for (i = 0; i < session_instance->link_endpoint_count; i++)
+        /* the endpoints are sorted by output handle */
+        while (i < high)
         {
-            if (session_instance->link_endpoints[i] == link_endpoint)
+            uint32_t middle = i + ((high - i) / 2);
+            if (session_instance->link_endpoints[middle]->output_handle < endpoint_instance->output_handle)
             {
-                break;
+                i = middle + 1;
+            }
+            else
+            {
+                high = middle;
             }
         }
 
-        if (i < session_instance->link_endpoint_count)
+        if ((i < session_instance->link_endpoint_count) &&
+            (session_instance->link_endpoints[i] == endpoint_instance))
         {
-            LINK_ENDPOINT_INSTANCE** new_endpoints;
+            remove_link_endpoint_from_name_buckets(session_instance, endpoint_instance);
+
+            if ((endpoint_instance->input_handle < session_instance->input_handle_table_size) &&
+                (session_instance->link_endpoints_by_input_handle[endpoint_instance->input_handle] == endpoint_instance))
+            {
+                session_instance->link_endpoints_by_input_handle[endpoint_instance->input_handle] = NULL;
+            }
 
             if (i < (session_instance->link_endpoint_count - 1))
             {
-                (void)memmove(&session_instance->link_endpoints[i], &session_instance->link_endpoints[i + 1], (session_instance->link_endpoint_count - (uint32_t)i - 1) * sizeof(LINK_ENDPOINT_INSTANCE*));
+                (void)memmove(&session_instance->link_endpoints[i], &session_instance->link_endpoints[i + 1], (session_instance->link_endpoint_count - i - 1) * sizeof(LINK_ENDPOINT_INSTANCE*));
             }
 
             session_instance->link_endpoint_count--;
@@ -1078,26 +2199,64 @@ void session_destroy_link_endpoint(LINK_ENDPOINT_HANDLE link_endpoint)
             {
                 free(session_instance->link_endpoints);
                 session_instance->link_endpoints = NULL;
-            }
-            else
-            {
-                new_endpoints = (LINK_ENDPOINT_INSTANCE**)realloc(session_instance->link_endpoints, sizeof(LINK_ENDPOINT_INSTANCE*) * session_instance->link_endpoint_count);
-                if (new_endpoints != NULL)
-                {
-                    session_instance->link_endpoints = new_endpoints;
-                }
+                session_instance->link_endpoints_by_name = NULL;
+                session_instance->link_endpoint_capacity = 0;
             }
         }
 
-        if (endpoint_instance->name != NULL)
+        if (endpoint_instance->transfer_template != NULL)
         {
-            free(endpoint_instance->name);
+            free(endpoint_instance->transfer_template);
         }
 
         free(endpoint_instance);
     }
 }
 
+int session_set_link_endpoint_weight(LINK_ENDPOINT_HANDLE link_endpoint, uint32_t weight)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_094: [If link_endpoint is NULL or weight is 0, session_set_link_endpoint_weight shall fail and return a non-zero value.] */
+    if ((link_endpoint == NULL) ||
+        (weight == 0))
+    {
+        LogError("Bad arguments: link_endpoint = %p, weight = %u",
+            link_endpoint, (unsigned int)weight);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_SESSION_01_095: [On success, session_set_link_endpoint_weight shall return 0.] */
+        link_endpoint->scheduling_weight = weight;
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_get_link_endpoint_name(LINK_ENDPOINT_HANDLE link_endpoint, const char** name)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_123: [If link_endpoint or name is NULL, session_get_link_endpoint_name shall fail and return a non-zero value.] */
+    if ((link_endpoint == NULL) ||
+        (name == NULL))
+    {
+        LogError("Bad arguments: link_endpoint = %p, name = %p",
+            link_endpoint, name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_SESSION_01_124: [On success, session_get_link_endpoint_name shall return in name the name of the link endpoint, valid until the link endpoint is destroyed, and return 0.] */
+        *name = link_endpoint->name;
+        result = 0;
+    }
+
+    return result;
+}
+
 int session_start_link_endpoint(LINK_ENDPOINT_HANDLE link_endpoint, ON_ENDPOINT_FRAME_RECEIVED frame_received_callback, ON_SESSION_STATE_CHANGED on_session_state_changed, ON_SESSION_FLOW_ON on_session_flow_on, void* context)
 {
     int result;
@@ -1201,6 +2360,7 @@ int session_send_flow(LINK_ENDPOINT_HANDLE link_endpoint, FLOW_HANDLE flow)
                     }
                     else
                     {
+                        session_instance->stats.flows_sent++;
                         result = 0;
                     }
 
@@ -1213,62 +2373,234 @@ int session_send_flow(LINK_ENDPOINT_HANDLE link_endpoint, FLOW_HANDLE flow)
     return result;
 }
 
-int session_send_attach(LINK_ENDPOINT_HANDLE link_endpoint, ATTACH_HANDLE attach)
+/* Codes_SRS_SESSION_01_074: [session_send_link_flow shall send a flow frame carrying the session flow state, the handle of the link endpoint, delivery_count and link_credit.] */
+int session_send_link_flow(LINK_ENDPOINT_HANDLE link_endpoint, sequence_no delivery_count, uint32_t link_credit)
 {
     int result;
 
-    if ((link_endpoint == NULL) ||
-        (attach == NULL))
+    /* Codes_SRS_SESSION_01_075: [If link_endpoint is NULL, session_send_link_flow shall fail and return a non-zero value.] */
+    if (link_endpoint == NULL)
     {
+        LogError("NULL link_endpoint");
         result = __FAILURE__;
     }
-    else
+    else if (((SESSION_INSTANCE*)((LINK_ENDPOINT_INSTANCE*)link_endpoint)->session)->is_deferring_link_flows)
     {
         LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
 
-        if (attach_set_handle(attach, link_endpoint_instance->output_handle) != 0)
-        {
-            result = __FAILURE__;
-        }
-        else
+        /* Codes_SRS_SESSION_01_139: [While the session defers link flows, session_send_link_flow shall only record delivery_count and link_credit on the link endpoint, replacing the ones of a flow still pending for it, and return 0.] */
+        if (!link_endpoint_instance->has_pending_flow)
         {
-            AMQP_VALUE attach_performative_value = amqpvalue_create_attach(attach);
-            if (attach_performative_value == NULL)
-            {
-                result = __FAILURE__;
-            }
-            else
-            {
-                if (encode_frame(link_endpoint, attach_performative_value, NULL, 0) != 0)
-                {
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
-                }
+            SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint_instance->session;
 
-                amqpvalue_destroy(attach_performative_value);
-            }
+            link_endpoint_instance->next_pending_flow = session_instance->first_pending_flow;
+            session_instance->first_pending_flow = link_endpoint_instance;
+            link_endpoint_instance->has_pending_flow = true;
         }
+
+        link_endpoint_instance->pending_flow_delivery_count = delivery_count;
+        link_endpoint_instance->pending_flow_link_credit = link_credit;
+        result = 0;
+    }
+    /* Codes_SRS_SESSION_01_076: [The flow performative shall be encoded directly to bytes, without creating a flow performative AMQP value.] */
+    else if (send_link_flow((LINK_ENDPOINT_INSTANCE*)link_endpoint, delivery_count, link_credit, false) != 0)
+    {
+        /* Codes_SRS_SESSION_01_077: [If sending the frame fails, session_send_link_flow shall fail and return a non-zero value.] */
+        LogError("Cannot send link flow");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_SESSION_01_078: [On success, session_send_link_flow shall return 0.] */
+        result = 0;
     }
 
     return result;
 }
 
-int session_send_disposition(LINK_ENDPOINT_HANDLE link_endpoint, DISPOSITION_HANDLE disposition)
+/* Codes_SRS_SESSION_01_125: [session_send_link_drain_flow shall send a flow frame like session_send_link_flow, with the drain field set to true.] */
+int session_send_link_drain_flow(LINK_ENDPOINT_HANDLE link_endpoint, sequence_no delivery_count, uint32_t link_credit)
 {
     int result;
 
-    if ((link_endpoint == NULL) ||
-        (disposition == NULL))
+    /* Codes_SRS_SESSION_01_126: [If link_endpoint is NULL, session_send_link_drain_flow shall fail and return a non-zero value.] */
+    if (link_endpoint == NULL)
     {
+        LogError("NULL link_endpoint");
         result = __FAILURE__;
     }
     else
     {
-        AMQP_VALUE disposition_performative_value = amqpvalue_create_disposition(disposition);
-        if (disposition_performative_value == NULL)
+        /* Codes_SRS_SESSION_01_142: [A drain flow shall be sent right away and replace the flow pending for the link endpoint.] */
+        drop_pending_flow((LINK_ENDPOINT_INSTANCE*)link_endpoint);
+
+        if (send_link_flow((LINK_ENDPOINT_INSTANCE*)link_endpoint, delivery_count, link_credit, true) != 0)
+        {
+            /* Codes_SRS_SESSION_01_127: [If sending the frame fails, session_send_link_drain_flow shall fail and return a non-zero value.] */
+            LogError("Cannot send link drain flow");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_SESSION_01_128: [On success, session_send_link_drain_flow shall return 0.] */
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int session_send_attach(LINK_ENDPOINT_HANDLE link_endpoint, ATTACH_HANDLE attach)
+{
+    int result;
+
+    if ((link_endpoint == NULL) ||
+        (attach == NULL))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
+
+        if (attach_set_handle(attach, link_endpoint_instance->output_handle) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            AMQP_VALUE attach_performative_value = amqpvalue_create_attach(attach);
+            if (attach_performative_value == NULL)
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (encode_frame(link_endpoint, attach_performative_value, NULL, 0) != 0)
+                {
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+
+                amqpvalue_destroy(attach_performative_value);
+            }
+        }
+    }
+
+    return result;
+}
+
+int session_send_encoded_attach(LINK_ENDPOINT_HANDLE link_endpoint, const unsigned char* encoded_fields, size_t encoded_fields_size, uint32_t field_count)
+{
+    int result;
+
+    if ((link_endpoint == NULL) ||
+        (encoded_fields == NULL) ||
+        (encoded_fields_size == 0) ||
+        (field_count == 0))
+    {
+        /* Codes_SRS_SESSION_01_149: [If link_endpoint or encoded_fields is NULL, or encoded_fields_size or field_count is 0, session_send_encoded_attach shall fail and return a non-zero value.] */
+        LogError("Bad arguments: link_endpoint = %p, encoded_fields = %p, encoded_fields_size = %lu, field_count = %u",
+            link_endpoint, encoded_fields, (unsigned long)encoded_fields_size, (unsigned int)field_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint_instance->session;
+        size_t name_length = strlen(link_endpoint_instance->name);
+        /* descriptor, list32 header, str32 name and uint handle ahead of the fields of the link */
+        size_t attach_size = 3 + 9 + 5 + name_length + 5 + encoded_fields_size;
+
+        if ((name_length > UINT32_MAX) ||
+            (attach_size - 8 > UINT32_MAX) ||
+            (field_count > UINT32_MAX - 2))
+        {
+            LogError("Attach of %lu bytes is too big", (unsigned long)attach_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            unsigned char* attach_bytes = (unsigned char*)malloc(attach_size);
+            if (attach_bytes == NULL)
+            {
+                /* Codes_SRS_SESSION_01_150: [If allocating the attach or sending the frame fails, session_send_encoded_attach shall fail and return a non-zero value.] */
+                LogError("Cannot allocate memory for the attach performative");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_SESSION_01_148: [session_send_encoded_attach shall send an attach frame made of the name and output handle of the link endpoint followed by the field_count fields in encoded_fields, copied as they are, and return 0.] */
+                /* written by hand like the flow and disposition, the handle always as a full uint */
+                size_t position = 0;
+                uint32_t list_size;
+
+                attach_bytes[position++] = 0x00;
+                attach_bytes[position++] = 0x53;
+                attach_bytes[position++] = (unsigned char)AMQP_ATTACH;
+                attach_bytes[position++] = 0xD0;
+                /* the list32 size, filled in once the length is known */
+                position += 4;
+                write_uint32(attach_bytes + position, field_count + 2);
+                position += 4;
+                if (name_length <= 0xFF)
+                {
+                    attach_bytes[position++] = 0xA1;
+                    attach_bytes[position++] = (unsigned char)name_length;
+                }
+                else
+                {
+                    attach_bytes[position++] = 0xB1;
+                    write_uint32(attach_bytes + position, (uint32_t)name_length);
+                    position += 4;
+                }
+                (void)memcpy(attach_bytes + position, link_endpoint_instance->name, name_length);
+                position += name_length;
+                attach_bytes[position++] = 0x70;
+                write_uint32(attach_bytes + position, link_endpoint_instance->output_handle);
+                position += 4;
+                (void)memcpy(attach_bytes + position, encoded_fields, encoded_fields_size);
+                position += encoded_fields_size;
+
+                /* the list32 size counts the bytes following the size field */
+                list_size = (uint32_t)(position - 8);
+                write_uint32(attach_bytes + 4, list_size);
+
+                if (connection_encode_frame_with_encoded_performative(session_instance->endpoint, attach_bytes, position, NULL, 0, NULL, NULL) != 0)
+                {
+                    /* Codes_SRS_SESSION_01_150: [If allocating the attach or sending the frame fails, session_send_encoded_attach shall fail and return a non-zero value.] */
+                    LogError("Cannot send the attach frame");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+
+                free(attach_bytes);
+            }
+        }
+    }
+
+    return result;
+}
+
+int session_send_disposition(LINK_ENDPOINT_HANDLE link_endpoint, DISPOSITION_HANDLE disposition)
+{
+    int result;
+
+    if ((link_endpoint == NULL) ||
+        (disposition == NULL))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_VALUE disposition_performative_value = amqpvalue_create_disposition(disposition);
+        if (disposition_performative_value == NULL)
         {
             result = __FAILURE__;
         }
@@ -1280,6 +2612,8 @@ int session_send_disposition(LINK_ENDPOINT_HANDLE link_endpoint, DISPOSITION_HAN
             }
             else
             {
+                LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
+                ((SESSION_INSTANCE*)link_endpoint_instance->session)->stats.dispositions_sent++;
                 result = 0;
             }
 
@@ -1290,6 +2624,91 @@ int session_send_disposition(LINK_ENDPOINT_HANDLE link_endpoint, DISPOSITION_HAN
     return result;
 }
 
+static int send_disposition_from_fields(LINK_ENDPOINT_HANDLE link_endpoint, role role_value, delivery_number first, delivery_number last, bool settled, AMQP_VALUE delivery_state)
+{
+    int result;
+    DISPOSITION_HANDLE disposition = disposition_create(role_value, first);
+
+    if (disposition == NULL)
+    {
+        LogError("NULL disposition performative");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((disposition_set_last(disposition, last) != 0) ||
+            (disposition_set_settled(disposition, settled) != 0) ||
+            ((delivery_state != NULL) && (disposition_set_state(disposition, delivery_state) != 0)))
+        {
+            LogError("Failed setting the disposition fields");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = session_send_disposition(link_endpoint, disposition);
+        }
+
+        disposition_destroy(disposition);
+    }
+
+    return result;
+}
+
+/* Codes_SRS_SESSION_01_079: [session_send_delivery_disposition shall send a disposition frame with the role, first, last, settled and delivery_state values given as arguments.] */
+int session_send_delivery_disposition(LINK_ENDPOINT_HANDLE link_endpoint, role role_value, delivery_number first, delivery_number last, bool settled, AMQP_VALUE delivery_state)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_080: [If link_endpoint is NULL, session_send_delivery_disposition shall fail and return a non-zero value.] */
+    if (link_endpoint == NULL)
+    {
+        LogError("NULL link_endpoint");
+        result = __FAILURE__;
+    }
+    else
+    {
+        LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint_instance->session;
+        ENCODED_PERFORMATIVE disposition;
+
+        /* Codes_SRS_SESSION_01_081: [The disposition performative shall be encoded directly to bytes, without creating a disposition performative AMQP value.] */
+        begin_encoded_performative(&disposition, AMQP_DISPOSITION, (delivery_state == NULL) ? 4 : 5);
+        add_encoded_bool_field(&disposition, role_value);
+        add_encoded_uint_field(&disposition, first);
+        add_encoded_uint_field(&disposition, last);
+        add_encoded_bool_field(&disposition, settled);
+
+        /* Codes_SRS_SESSION_01_119: [An accepted or released delivery_state without fields shall be written as its encoded bytes without encoding the AMQP value.] */
+        if ((delivery_state != NULL) &&
+            !add_encoded_outcome_without_fields(&disposition, delivery_state) &&
+            (add_encoded_value_field(&disposition, delivery_state) != 0))
+        {
+            /* Codes_SRS_SESSION_01_082: [If the delivery_state cannot be encoded in the disposition bytes, session_send_delivery_disposition shall send the disposition by building a disposition performative and calling session_send_disposition.] */
+            result = send_disposition_from_fields(link_endpoint, role_value, first, last, settled, delivery_state);
+        }
+        else
+        {
+            end_encoded_performative(&disposition);
+
+            if (connection_encode_frame_with_encoded_performative(session_instance->endpoint, disposition.bytes, disposition.size, NULL, 0, NULL, NULL) != 0)
+            {
+                /* Codes_SRS_SESSION_01_083: [If sending the frame fails, session_send_delivery_disposition shall fail and return a non-zero value.] */
+                LogError("Cannot send disposition frame");
+                result = __FAILURE__;
+            }
+            else
+            {
+                session_instance->stats.dispositions_sent++;
+
+                /* Codes_SRS_SESSION_01_084: [On success, session_send_delivery_disposition shall return 0.] */
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
 int session_send_detach(LINK_ENDPOINT_HANDLE link_endpoint, DETACH_HANDLE detach)
 {
     int result;
@@ -1303,6 +2722,9 @@ int session_send_detach(LINK_ENDPOINT_HANDLE link_endpoint, DETACH_HANDLE detach
     {
         LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
 
+        /* Codes_SRS_SESSION_01_143: [The flow pending for a link endpoint shall be dropped when a detach is sent for it or it is destroyed.] */
+        drop_pending_flow(link_endpoint_instance);
+
         if (detach_set_handle(detach, link_endpoint_instance->output_handle) != 0)
         {
             result = __FAILURE__;
@@ -1334,6 +2756,132 @@ int session_send_detach(LINK_ENDPOINT_HANDLE link_endpoint, DETACH_HANDLE detach
 }
 
 /* Codes_SRS_SESSION_01_051: [session_send_transfer shall send a transfer frame with the performative indicated in the transfer argument.] */
+static int send_split_transfer(SESSION_INSTANCE* session_instance, TRANSFER_HANDLE transfer, AMQP_VALUE last_transfer_value, size_t last_encoded_size,
+    PAYLOAD* payloads, size_t payload_count, size_t payload_size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    AMQP_VALUE more_transfer_value;
+    size_t more_encoded_size;
+    uint32_t available_frame_size;
+
+    if (connection_get_split_frame_size(session_instance->connection, &available_frame_size) != 0)
+    {
+        LogError("Cannot get the split frame size");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_SESSION_01_115: [A transfer that does not fit in one frame shall be split into frames of the split frame size of the connection.] */
+    else if (available_frame_size <= last_encoded_size + 8)
+    {
+        LogError("No room for transfer payload in a frame");
+        result = __FAILURE__;
+    }
+    else if ((transfer_set_more(transfer, true) != 0) ||
+        ((more_transfer_value = amqpvalue_create_transfer(transfer)) == NULL))
+    {
+        LogError("Cannot create the continuation transfer performative");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned char performative_stack_buffer[SPLIT_TRANSFER_STACK_PERFORMATIVE_SIZE];
+        PAYLOAD frame_payloads_stack[SPLIT_TRANSFER_STACK_PAYLOAD_COUNT];
+        unsigned char* performative_bytes = NULL;
+        PAYLOAD* frame_payloads = NULL;
+
+        /* both encodings are made once per message, every continuation frame reuses the one with more set */
+        if (amqpvalue_get_encoded_size(more_transfer_value, &more_encoded_size) != 0)
+        {
+            LogError("Cannot get the continuation transfer encoded size");
+            result = __FAILURE__;
+        }
+        else if ((performative_bytes = (more_encoded_size + last_encoded_size <= sizeof(performative_stack_buffer)) ?
+            performative_stack_buffer : (unsigned char*)malloc(more_encoded_size + last_encoded_size)) == NULL)
+        {
+            LogError("Cannot allocate memory for the encoded transfer performatives");
+            result = __FAILURE__;
+        }
+        /* a frame never takes more slices than there are payloads */
+        else if ((frame_payloads = (payload_count <= SPLIT_TRANSFER_STACK_PAYLOAD_COUNT) ?
+            frame_payloads_stack : (PAYLOAD*)malloc(payload_count * sizeof(PAYLOAD))) == NULL)
+        {
+            LogError("Cannot allocate memory for the frame payloads");
+            result = __FAILURE__;
+        }
+        else if ((amqpvalue_encode_to_buffer(more_transfer_value, performative_bytes, more_encoded_size, &more_encoded_size) != 0) ||
+            (amqpvalue_encode_to_buffer(last_transfer_value, performative_bytes + more_encoded_size, last_encoded_size, &last_encoded_size) != 0))
+        {
+            LogError("Cannot encode the transfer performatives");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t current_payload_index = 0;
+            size_t current_payload_pos = 0;
+
+            /* more_encoded_size matches the size available_frame_size is reduced by, the more flag does not change the encoded size */
+            available_frame_size -= (uint32_t)last_encoded_size + 8;
+            while (payload_size > 0)
+            {
+                uint32_t frame_payload_size = (payload_size > available_frame_size) ? available_frame_size : (uint32_t)payload_size;
+                bool more = (payload_size > available_frame_size);
+                uint32_t byte_counter = frame_payload_size;
+                size_t frame_payload_count = 0;
+
+                /* slice the frame out of the payloads, continuing where the previous frame stopped */
+                while (byte_counter > 0)
+                {
+                    size_t remaining = payloads[current_payload_index].length - current_payload_pos;
+
+                    frame_payloads[frame_payload_count].bytes = payloads[current_payload_index].bytes + current_payload_pos;
+                    if (remaining > byte_counter)
+                    {
+                        frame_payloads[frame_payload_count].length = byte_counter;
+                        current_payload_pos += byte_counter;
+                        byte_counter = 0;
+                    }
+                    else
+                    {
+                        frame_payloads[frame_payload_count].length = remaining;
+                        byte_counter -= (uint32_t)remaining;
+                        current_payload_index++;
+                        current_payload_pos = 0;
+                    }
+
+                    frame_payload_count++;
+                }
+
+                /* only the last frame reports its completion, so that a caller hears about the transfer once */
+                if (connection_encode_frame_with_encoded_performative(session_instance->endpoint,
+                    more ? performative_bytes : performative_bytes + more_encoded_size,
+                    more ? more_encoded_size : last_encoded_size,
+                    frame_payloads, frame_payload_count, more ? NULL : on_send_complete, more ? NULL : callback_context) != 0)
+                {
+                    LogError("Cannot send transfer frame");
+                    break;
+                }
+
+                payload_size -= frame_payload_size;
+            }
+
+            result = (payload_size > 0) ? __FAILURE__ : 0;
+        }
+
+        if ((frame_payloads != NULL) && (frame_payloads != frame_payloads_stack))
+        {
+            free(frame_payloads);
+        }
+
+        if ((performative_bytes != NULL) && (performative_bytes != performative_stack_buffer))
+        {
+            free(performative_bytes);
+        }
+
+        amqpvalue_destroy(more_transfer_value);
+    }
+
+    return result;
+}
+
 SESSION_SEND_TRANSFER_RESULT session_send_transfer(LINK_ENDPOINT_HANDLE link_endpoint, TRANSFER_HANDLE transfer, PAYLOAD* payloads, size_t payload_count, delivery_number* delivery_id, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     SESSION_SEND_TRANSFER_RESULT result;
@@ -1377,8 +2925,16 @@ SESSION_SEND_TRANSFER_RESULT session_send_transfer(LINK_ENDPOINT_HANDLE link_end
             }
             else
             {
-                if (session_instance->remote_incoming_window == 0)
+                if ((session_instance->remote_incoming_window == 0) ||
+                    (session_instance->is_sharing_window && (link_endpoint_instance->window_share == 0)))
+                {
+                    count_window_stall(session_instance);
+                    result = SESSION_SEND_TRANSFER_BUSY;
+                }
+                /* Codes_SRS_SESSION_01_116: [A transfer that starts a new delivery shall be refused with SESSION_SEND_TRANSFER_BUSY while the send queue of the connection is full, and counted as a send queue stall.] */
+                else if (connection_is_send_queue_full(session_instance->connection))
                 {
+                    session_instance->stats.send_queue_stalls++;
                     result = SESSION_SEND_TRANSFER_BUSY;
                 }
                 else
@@ -1436,9 +2992,15 @@ SESSION_SEND_TRANSFER_RESULT session_send_transfer(LINK_ENDPOINT_HANDLE link_end
                                     else
                                     {
                                         /* Codes_SRS_SESSION_01_018: [is incremented after each successive transfer according to RFC-1982 [RFC1982] serial number arithmetic.] */
+                                        UAMQP_TRACEPOINT2(session_send_transfer, *delivery_id, payload_size);
                                         session_instance->next_outgoing_id++;
+                                        session_instance->stats.transfers_sent++;
                                         session_instance->remote_incoming_window--;
                                         session_instance->outgoing_window--;
+                                        if (link_endpoint_instance->window_share > 0)
+                                        {
+                                            link_endpoint_instance->window_share--;
+                                        }
 
                                         /* Codes_SRS_SESSION_01_053: [On success, session_send_transfer shall return 0.] */
                                         result = SESSION_SEND_TRANSFER_OK;
@@ -1446,131 +3008,754 @@ SESSION_SEND_TRANSFER_RESULT session_send_transfer(LINK_ENDPOINT_HANDLE link_end
                                 }
                                 else
                                 {
-                                    size_t current_payload_index = 0;
-                                    uint32_t current_payload_pos = 0;
-
-                                    /* break it down into different deliveries */
-                                    while (payload_size > 0)
+                                    if (send_split_transfer(session_instance, transfer, transfer_value, encoded_size, payloads, payload_count, payload_size, on_send_complete, callback_context) != 0)
+                                    {
+                                        result = SESSION_SEND_TRANSFER_ERROR;
+                                    }
+                                    else
                                     {
-                                        uint32_t transfer_frame_payload_count = 0;
-                                        uint32_t current_transfer_frame_payload_size = (uint32_t)payload_size;
-                                        uint32_t byte_counter;
-                                        size_t temp_current_payload_index = current_payload_index;
-                                        uint32_t temp_current_payload_pos = current_payload_pos;
-                                        AMQP_VALUE multi_transfer_amqp_value;
-                                        PAYLOAD* transfer_frame_payloads;
-                                        bool more;
-
-                                        if (current_transfer_frame_payload_size > available_frame_size)
+                                        /* Codes_SRS_SESSION_01_018: [is incremented after each successive transfer according to RFC-1982 [RFC1982] serial number arithmetic.] */
+                                        UAMQP_TRACEPOINT2(session_send_transfer, *delivery_id, payload_size);
+                                        session_instance->next_outgoing_id++;
+                                        session_instance->stats.transfers_sent++;
+                                        session_instance->remote_incoming_window--;
+                                        session_instance->outgoing_window--;
+                                        if (link_endpoint_instance->window_share > 0)
                                         {
-                                            current_transfer_frame_payload_size = available_frame_size;
+                                            link_endpoint_instance->window_share--;
                                         }
 
-                                        if (available_frame_size >= payload_size)
-                                        {
-                                            more = false;
-                                        }
-                                        else
-                                        {
-                                            more = true;
-                                        }
+                                        result = SESSION_SEND_TRANSFER_OK;
+                                    }
+                                }
+                            }
 
-                                        if (transfer_set_more(transfer, more) != 0)
-                                        {
-                                            break;
-                                        }
+                            amqpvalue_destroy(transfer_value);
+                        }
+                    }
+                }
+            }
+        }
+    }
 
-                                        multi_transfer_amqp_value = amqpvalue_create_transfer(transfer);
-                                        if (multi_transfer_amqp_value == NULL)
-                                        {
-                                            break;
-                                        }
+    return result;
+}
 
-                                        byte_counter = current_transfer_frame_payload_size;
-                                        while (byte_counter > 0)
-                                        {
-                                            if (payloads[temp_current_payload_index].length - temp_current_payload_pos >= byte_counter)
-                                            {
-                                                /* more data than we need */
-                                                temp_current_payload_pos += byte_counter;
-                                                byte_counter = 0;
-                                            }
-                                            else
-                                            {
-                                                byte_counter -= (uint32_t)payloads[temp_current_payload_index].length - temp_current_payload_pos;
-                                                temp_current_payload_index++;
-                                                temp_current_payload_pos = 0;
-                                            }
-                                        }
+SESSION_SEND_TRANSFER_RESULT session_send_transfer_part(LINK_ENDPOINT_HANDLE link_endpoint, TRANSFER_HANDLE transfer, bool more, PAYLOAD* payloads, size_t payload_count, delivery_number* delivery_id, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    SESSION_SEND_TRANSFER_RESULT result;
 
-                                        transfer_frame_payload_count = (uint32_t)(temp_current_payload_index - current_payload_index + 1);
-                                        transfer_frame_payloads = (PAYLOAD*)malloc(transfer_frame_payload_count * sizeof(PAYLOAD));
-                                        if (transfer_frame_payloads == NULL)
-                                        {
-                                            amqpvalue_destroy(multi_transfer_amqp_value);
-                                            break;
-                                        }
+    /* Codes_SRS_SESSION_01_108: [If link_endpoint, transfer or delivery_id is NULL, or payloads is NULL while payload_count is not 0, session_send_transfer_part shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+    if ((link_endpoint == NULL) ||
+        (transfer == NULL) ||
+        (delivery_id == NULL) ||
+        ((payloads == NULL) && (payload_count > 0)))
+    {
+        LogError("Bad arguments: link_endpoint = %p, transfer = %p, delivery_id = %p, payloads = %p, payload_count = %u",
+            link_endpoint, transfer, delivery_id, payloads, (unsigned int)payload_count);
+        result = SESSION_SEND_TRANSFER_ERROR;
+    }
+    else
+    {
+        LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint_instance->session;
+        bool is_first_part = !link_endpoint_instance->is_sending_transfer_parts;
+        size_t payload_size = 0;
+        size_t i;
 
-                                        /* copy data */
-                                        byte_counter = current_transfer_frame_payload_size;
-                                        transfer_frame_payload_count = 0;
+        for (i = 0; i < payload_count; i++)
+        {
+            if ((payloads[i].length > UINT32_MAX) ||
+                (payload_size + payloads[i].length < payload_size))
+            {
+                break;
+            }
 
-                                        while (byte_counter > 0)
-                                        {
-                                            if (payloads[current_payload_index].length - current_payload_pos > byte_counter)
-                                            {
-                                                /* more data than we need */
-                                                transfer_frame_payloads[transfer_frame_payload_count].bytes = payloads[current_payload_index].bytes + current_payload_pos;
-                                                transfer_frame_payloads[transfer_frame_payload_count].length = byte_counter;
-                                                current_payload_pos += byte_counter;
-                                                byte_counter = 0;
-                                            }
-                                            else
-                                            {
-                                                /* copy entire payload and move to the next */
-                                                transfer_frame_payloads[transfer_frame_payload_count].bytes = payloads[current_payload_index].bytes + current_payload_pos;
-                                                transfer_frame_payloads[transfer_frame_payload_count].length = payloads[current_payload_index].length - current_payload_pos;
-                                                byte_counter -= (uint32_t)payloads[current_payload_index].length - current_payload_pos;
-                                                current_payload_index++;
-                                                current_payload_pos = 0;
-                                            }
-
-                                            transfer_frame_payload_count++;
-                                        }
+            payload_size += payloads[i].length;
+        }
 
-                                        if (connection_encode_frame(session_instance->endpoint, multi_transfer_amqp_value, transfer_frame_payloads, transfer_frame_payload_count, on_send_complete, callback_context) != 0)
-                                        {
-                                            free(transfer_frame_payloads);
-                                            amqpvalue_destroy(multi_transfer_amqp_value);
-                                            break;
-                                        }
+        if (session_instance->session_state != SESSION_STATE_MAPPED)
+        {
+            LogError("Session not mapped");
+            result = SESSION_SEND_TRANSFER_ERROR;
+        }
+        else if ((i < payload_count) ||
+            (payload_size > UINT32_MAX))
+        {
+            LogError("Payload too large");
+            result = SESSION_SEND_TRANSFER_ERROR;
+        }
+        /* Codes_SRS_SESSION_01_109: [Only the first part of a delivery shall be subject to the outgoing session window, the following parts belong to a delivery already counted against it.] */
+        else if (is_first_part &&
+            ((session_instance->remote_incoming_window == 0) ||
+            (session_instance->is_sharing_window && (link_endpoint_instance->window_share == 0))))
+        {
+            count_window_stall(session_instance);
+            result = SESSION_SEND_TRANSFER_BUSY;
+        }
+        /* Codes_SRS_SESSION_01_116: [A transfer that starts a new delivery shall be refused with SESSION_SEND_TRANSFER_BUSY while the send queue of the connection is full, and counted as a send queue stall.] */
+        else if (is_first_part &&
+            connection_is_send_queue_full(session_instance->connection))
+        {
+            session_instance->stats.send_queue_stalls++;
+            result = SESSION_SEND_TRANSFER_BUSY;
+        }
+        else
+        {
+            AMQP_VALUE transfer_value;
 
-                                        free(transfer_frame_payloads);
-                                        amqpvalue_destroy(multi_transfer_amqp_value);
-                                        payload_size -= current_transfer_frame_payload_size;
-                                    }
+            /* Codes_SRS_SESSION_01_110: [The first part of a delivery shall be assigned the next outgoing delivery id, and every following part shall carry the same delivery id, until a part is sent with more set to false.] */
+            *delivery_id = is_first_part ? session_instance->next_outgoing_id : link_endpoint_instance->transfer_parts_delivery_id;
 
-                                    if (payload_size > 0)
-                                    {
-                                        result = SESSION_SEND_TRANSFER_ERROR;
-                                    }
-                                    else
-                                    {
-                                        /* Codes_SRS_SESSION_01_018: [is incremented after each successive transfer according to RFC-1982 [RFC1982] serial number arithmetic.] */
-                                        session_instance->next_outgoing_id++;
-                                        session_instance->remote_incoming_window--;
-                                        session_instance->outgoing_window--;
+            /* Codes_SRS_SESSION_01_111: [session_send_transfer_part shall set the handle of the link endpoint, the delivery id and the more flag on the transfer before encoding it.] */
+            if ((transfer_set_handle(transfer, link_endpoint_instance->output_handle) != 0) ||
+                (transfer_set_delivery_id(transfer, *delivery_id) != 0) ||
+                (transfer_set_more(transfer, more) != 0))
+            {
+                LogError("Cannot set the transfer part fields");
+                result = SESSION_SEND_TRANSFER_ERROR;
+            }
+            else if ((transfer_value = amqpvalue_create_transfer(transfer)) == NULL)
+            {
+                LogError("Cannot create the transfer performative");
+                result = SESSION_SEND_TRANSFER_ERROR;
+            }
+            else
+            {
+                uint32_t available_frame_size;
+                size_t encoded_size;
 
-                                        result = SESSION_SEND_TRANSFER_OK;
-                                    }
-                                }
-                            }
+                if ((connection_get_remote_max_frame_size(session_instance->connection, &available_frame_size) != 0) ||
+                    (amqpvalue_get_encoded_size(transfer_value, &encoded_size) != 0) ||
+                    (available_frame_size < encoded_size + 8))
+                {
+                    LogError("Cannot compute the room for the transfer part in a frame");
+                    result = SESSION_SEND_TRANSFER_ERROR;
+                }
+                else
+                {
+                    int send_result;
 
-                            amqpvalue_destroy(transfer_value);
+                    available_frame_size -= (uint32_t)encoded_size + 8;
+
+                    /* Codes_SRS_SESSION_01_112: [A part that does not fit in one frame shall be split across frames, all of them but the last with more set to true, and on_send_complete shall only be called for the last of them.] */
+                    if (available_frame_size >= payload_size)
+                    {
+                        send_result = connection_encode_frame(session_instance->endpoint, transfer_value, payloads, payload_count, on_send_complete, callback_context);
+                    }
+                    else
+                    {
+                        send_result = send_split_transfer(session_instance, transfer, transfer_value, encoded_size, payloads, payload_count, payload_size, on_send_complete, callback_context);
+                    }
+
+                    if (send_result != 0)
+                    {
+                        LogError("Cannot send the transfer part");
+                        result = SESSION_SEND_TRANSFER_ERROR;
+                    }
+                    else
+                    {
+                        if (is_first_part)
+                        {
+                            UAMQP_TRACEPOINT2(session_send_transfer, *delivery_id, payload_size);
+                            session_instance->next_outgoing_id++;
+                            session_instance->stats.transfers_sent++;
+                            session_instance->remote_incoming_window--;
+                            session_instance->outgoing_window--;
+                            if (link_endpoint_instance->window_share > 0)
+                            {
+                                link_endpoint_instance->window_share--;
+                            }
                         }
+
+                        /* Codes_SRS_SESSION_01_113: [On success session_send_transfer_part shall return SESSION_SEND_TRANSFER_OK.] */
+                        result = SESSION_SEND_TRANSFER_OK;
                     }
                 }
+
+                amqpvalue_destroy(transfer_value);
+            }
+
+            /* Codes_SRS_SESSION_01_114: [Once a part with more set to false has been sent, the next part shall start a new delivery.] */
+            if (result != SESSION_SEND_TRANSFER_OK)
+            {
+                /* a failed part leaves the delivery as it was, an unfinished one is ended by sending an aborted part */
+            }
+            else if (!more)
+            {
+                link_endpoint_instance->is_sending_transfer_parts = false;
+            }
+            else if (is_first_part)
+            {
+                link_endpoint_instance->is_sending_transfer_parts = true;
+                link_endpoint_instance->transfer_parts_delivery_id = *delivery_id;
+            }
+            else
+            {
+                /* the delivery goes on */
+            }
+        }
+    }
+
+    return result;
+}
+
+static void write_uint32_to_template(unsigned char* bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value >> 24);
+    bytes[1] = (unsigned char)(value >> 16);
+    bytes[2] = (unsigned char)(value >> 8);
+    bytes[3] = (unsigned char)value;
+}
+
+/* Lays out the transfer performative as descriptor, list8 header, handle, delivery-id, delivery-tag, message-format, settled and more.
+Only the delivery-id, delivery-tag bytes, settled and more change between deliveries of a link, so the template is only rebuilt
+when the delivery-tag length or the message format change. */
+static int build_transfer_template(LINK_ENDPOINT_INSTANCE* link_endpoint_instance, uint32_t delivery_tag_length, message_format message_format_value)
+{
+    int result;
+
+    if ((link_endpoint_instance->transfer_template == NULL) &&
+        ((link_endpoint_instance->transfer_template = (unsigned char*)malloc(TRANSFER_TEMPLATE_MAX_SIZE)) == NULL))
+    {
+        LogError("Cannot allocate memory for the transfer template");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned char* bytes = link_endpoint_instance->transfer_template;
+        uint32_t pos = TRANSFER_TEMPLATE_DELIVERY_TAG_OFFSET + delivery_tag_length;
+
+        /* described type with the smallulong transfer descriptor */
+        bytes[0] = 0x00;
+        bytes[1] = 0x53;
+        bytes[2] = (unsigned char)AMQP_TRANSFER;
+
+        /* list8 with 6 fields, the size counts the bytes following the size byte */
+        bytes[3] = 0xC0;
+        bytes[4] = (unsigned char)(pos + 7 - 5);
+        bytes[5] = 6;
+
+        bytes[TRANSFER_TEMPLATE_HANDLE_OFFSET - 1] = 0x70;
+        write_uint32_to_template(bytes + TRANSFER_TEMPLATE_HANDLE_OFFSET, link_endpoint_instance->output_handle);
+        bytes[TRANSFER_TEMPLATE_DELIVERY_ID_OFFSET - 1] = 0x70;
+        bytes[TRANSFER_TEMPLATE_DELIVERY_TAG_OFFSET - 2] = 0xA0;
+        bytes[TRANSFER_TEMPLATE_DELIVERY_TAG_OFFSET - 1] = (unsigned char)delivery_tag_length;
+        bytes[pos] = 0x70;
+        write_uint32_to_template(bytes + pos + 1, message_format_value);
+
+        /* the more flag is always false, since only transfers fitting in one frame are sent from the template */
+        bytes[pos + 6] = 0x42;
+
+        link_endpoint_instance->transfer_template_size = pos + 7;
+        link_endpoint_instance->transfer_template_delivery_tag_length = delivery_tag_length;
+        link_endpoint_instance->transfer_template_message_format = message_format_value;
+        result = 0;
+    }
+
+    return result;
+}
+
+static SESSION_SEND_TRANSFER_RESULT send_transfer_from_fields(LINK_ENDPOINT_INSTANCE* link_endpoint_instance, delivery_tag delivery_tag_value, message_format message_format_value, bool settled, PAYLOAD* payloads, size_t payload_count, delivery_number* delivery_id, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    SESSION_SEND_TRANSFER_RESULT result;
+    TRANSFER_HANDLE transfer = transfer_create(link_endpoint_instance->output_handle);
+
+    if (transfer == NULL)
+    {
+        LogError("Error creating transfer");
+        result = SESSION_SEND_TRANSFER_ERROR;
+    }
+    else
+    {
+        if ((transfer_set_delivery_tag(transfer, delivery_tag_value) != 0) ||
+            (transfer_set_message_format(transfer, message_format_value) != 0) ||
+            (transfer_set_settled(transfer, settled) != 0))
+        {
+            LogError("Failed setting the transfer fields");
+            result = SESSION_SEND_TRANSFER_ERROR;
+        }
+        else
+        {
+            result = session_send_transfer(link_endpoint_instance, transfer, payloads, payload_count, delivery_id, on_send_complete, callback_context);
+        }
+
+        transfer_destroy(transfer);
+    }
+
+    return result;
+}
+
+/* Codes_SRS_SESSION_01_064: [session_send_templated_transfer shall send a transfer frame with the handle of the link endpoint and the delivery-tag, message-format and settled values given as arguments.] */
+SESSION_SEND_TRANSFER_RESULT session_send_templated_transfer(LINK_ENDPOINT_HANDLE link_endpoint, delivery_tag delivery_tag_value, message_format message_format_value, bool settled, PAYLOAD* payloads, size_t payload_count, delivery_number* delivery_id, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    SESSION_SEND_TRANSFER_RESULT result;
+
+    /* Codes_SRS_SESSION_01_065: [If link_endpoint or delivery_id is NULL, session_send_templated_transfer shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+    if ((link_endpoint == NULL) ||
+        (delivery_id == NULL))
+    {
+        LogError("Bad arguments: link_endpoint = %p, delivery_id = %p",
+            link_endpoint, delivery_id);
+        result = SESSION_SEND_TRANSFER_ERROR;
+    }
+    else
+    {
+        LINK_ENDPOINT_INSTANCE* link_endpoint_instance = (LINK_ENDPOINT_INSTANCE*)link_endpoint;
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint_instance->session;
+        size_t payload_size = 0;
+        size_t i;
+
+        for (i = 0; i < payload_count; i++)
+        {
+            if ((payloads[i].length > UINT32_MAX) ||
+                (payload_size + payloads[i].length < payload_size))
+            {
+                break;
+            }
+
+            payload_size += payloads[i].length;
+        }
+
+        /* Codes_SRS_SESSION_01_066: [When session_send_templated_transfer is called while the session is not in the MAPPED state, session_send_templated_transfer shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+        if (session_instance->session_state != SESSION_STATE_MAPPED)
+        {
+            LogError("Session not mapped");
+            result = SESSION_SEND_TRANSFER_ERROR;
+        }
+        else if ((i < payload_count) ||
+            (payload_size > UINT32_MAX))
+        {
+            LogError("Payload too large");
+            result = SESSION_SEND_TRANSFER_ERROR;
+        }
+        else if ((session_instance->remote_incoming_window == 0) ||
+            (session_instance->is_sharing_window && (link_endpoint_instance->window_share == 0)))
+        {
+            /* Codes_SRS_SESSION_01_102: [Each transfer refused with SESSION_SEND_TRANSFER_BUSY because of the session window shall be counted as a window stall.] */
+            count_window_stall(session_instance);
+            result = SESSION_SEND_TRANSFER_BUSY;
+        }
+        /* Codes_SRS_SESSION_01_116: [A transfer that starts a new delivery shall be refused with SESSION_SEND_TRANSFER_BUSY while the send queue of the connection is full, and counted as a send queue stall.] */
+        else if (connection_is_send_queue_full(session_instance->connection))
+        {
+            session_instance->stats.send_queue_stalls++;
+            result = SESSION_SEND_TRANSFER_BUSY;
+        }
+        /* Codes_SRS_SESSION_01_067: [If the delivery-tag is longer than 32 bytes, session_send_templated_transfer shall send the transfer by building a transfer performative and calling session_send_transfer.] */
+        else if (delivery_tag_value.length > TRANSFER_TEMPLATE_MAX_DELIVERY_TAG_LENGTH)
+        {
+            result = send_transfer_from_fields(link_endpoint_instance, delivery_tag_value, message_format_value, settled, payloads, payload_count, delivery_id, on_send_complete, callback_context);
+        }
+        else
+        {
+            uint32_t available_frame_size;
+
+            /* Codes_SRS_SESSION_01_068: [The encoded transfer performative shall be kept by the link endpoint and shall only be rebuilt when the delivery-tag length or the message-format differ from the previous transfer.] */
+            if (((link_endpoint_instance->transfer_template_size == 0) ||
+                (link_endpoint_instance->transfer_template_delivery_tag_length != delivery_tag_value.length) ||
+                (link_endpoint_instance->transfer_template_message_format != message_format_value)) &&
+                (build_transfer_template(link_endpoint_instance, delivery_tag_value.length, message_format_value) != 0))
+            {
+                /* Codes_SRS_SESSION_01_122: [The memory of the encoded transfer performative shall only be allocated by the first templated transfer of the link endpoint, if allocating it fails the transfer shall be sent by building a transfer performative and calling session_send_transfer.] */
+                result = send_transfer_from_fields(link_endpoint_instance, delivery_tag_value, message_format_value, settled, payloads, payload_count, delivery_id, on_send_complete, callback_context);
+            }
+            else if (connection_get_remote_max_frame_size(session_instance->connection, &available_frame_size) != 0)
+            {
+                LogError("Cannot get the remote max frame size");
+                result = SESSION_SEND_TRANSFER_ERROR;
+            }
+            /* Codes_SRS_SESSION_01_069: [If the payloads do not fit in one frame, session_send_templated_transfer shall send the transfer by building a transfer performative and calling session_send_transfer.] */
+            else if ((available_frame_size < link_endpoint_instance->transfer_template_size + 8) ||
+                (available_frame_size - link_endpoint_instance->transfer_template_size - 8 < payload_size))
+            {
+                result = send_transfer_from_fields(link_endpoint_instance, delivery_tag_value, message_format_value, settled, payloads, payload_count, delivery_id, on_send_complete, callback_context);
             }
+            else
+            {
+                unsigned char* bytes = link_endpoint_instance->transfer_template;
+
+                /* Codes_SRS_SESSION_01_070: [The delivery-id, delivery-tag and settled fields shall be patched in the encoded transfer performative.] */
+                write_uint32_to_template(bytes + TRANSFER_TEMPLATE_DELIVERY_ID_OFFSET, session_instance->next_outgoing_id);
+                if (delivery_tag_value.length > 0)
+                {
+                    (void)memcpy(bytes + TRANSFER_TEMPLATE_DELIVERY_TAG_OFFSET, delivery_tag_value.bytes, delivery_tag_value.length);
+                }
+                bytes[link_endpoint_instance->transfer_template_size - 2] = settled ? 0x41 : 0x42;
+
+                /* Codes_SRS_SESSION_01_071: [The frame shall be sent by calling connection_encode_frame_with_encoded_performative with the encoded transfer performative and the payloads.] */
+                if (connection_encode_frame_with_encoded_performative(session_instance->endpoint, bytes, link_endpoint_instance->transfer_template_size, payloads, payload_count, on_send_complete, callback_context) != 0)
+                {
+                    /* Codes_SRS_SESSION_01_072: [If connection_encode_frame_with_encoded_performative fails then session_send_templated_transfer shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+                    LogError("Encoding the transfer frame failed");
+                    result = SESSION_SEND_TRANSFER_ERROR;
+                }
+                else
+                {
+                    *delivery_id = session_instance->next_outgoing_id;
+                    UAMQP_TRACEPOINT2(session_send_transfer, *delivery_id, payload_size);
+                    session_instance->next_outgoing_id++;
+                    session_instance->stats.transfers_sent++;
+                    session_instance->remote_incoming_window--;
+                    session_instance->outgoing_window--;
+                    if (link_endpoint_instance->window_share > 0)
+                    {
+                        link_endpoint_instance->window_share--;
+                    }
+
+                    /* Codes_SRS_SESSION_01_073: [On success, session_send_templated_transfer shall return SESSION_SEND_TRANSFER_OK.] */
+                    result = SESSION_SEND_TRANSFER_OK;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static int read_handover_uint(AMQP_READER* reader, uint32_t* value)
+{
+    int result;
+    AMQP_READER_ITEM item;
+
+    if ((amqp_reader_next(reader, &item) != 0) ||
+        (item.type != AMQP_TYPE_UINT))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        *value = (uint32_t)item.value.unsigned_value;
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_save_handover_state(SESSION_HANDLE session, unsigned char* buffer, size_t buffer_size, size_t* length)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_151: [If session, buffer or length is NULL, session_save_handover_state shall fail and return a non-zero value.] */
+    if ((session == NULL) ||
+        (buffer == NULL) ||
+        (length == NULL))
+    {
+        LogError("Bad arguments: session = %p, buffer = %p, length = %p",
+            session, buffer, length);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_SESSION_01_152: [If the session is not MAPPED, session_save_handover_state shall fail and return a non-zero value.] */
+    else if (session->session_state != SESSION_STATE_MAPPED)
+    {
+        LogError("Only a mapped session can be handed over, state is %d", (int)session->session_state);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t i;
+        uint16_t outgoing_channel;
+        uint16_t incoming_channel;
+
+        for (i = 0; i < session->link_endpoint_count; i++)
+        {
+            if (session->link_endpoints[i]->is_sending_transfer_parts)
+            {
+                break;
+            }
+        }
+
+        /* Codes_SRS_SESSION_01_153: [If a delivery is being sent in parts or link flows are waiting to be sent, session_save_handover_state shall fail and return a non-zero value.] */
+        if ((i < session->link_endpoint_count) ||
+            (session->first_pending_flow != NULL))
+        {
+            LogError("Cannot hand over a session with a delivery sent in parts or link flows still to be sent");
+            result = __FAILURE__;
+        }
+        else if ((connection_endpoint_get_outgoing_channel(session->endpoint, &outgoing_channel) != 0) ||
+            (connection_endpoint_get_incoming_channel(session->endpoint, &incoming_channel) != 0))
+        {
+            LogError("Cannot get the channels of the session");
+            result = __FAILURE__;
+        }
+        else
+        {
+            AMQP_WRITER writer;
+
+            /* Codes_SRS_SESSION_01_154: [session_save_handover_state shall encode in buffer, as an AMQP list, the channels, transfer ids, windows and handle max of the session, set length to the number of bytes encoded and return 0.] */
+            if ((amqp_writer_init(&writer, buffer, buffer_size) != 0) ||
+                (amqp_writer_begin_list(&writer) != 0) ||
+                (amqp_writer_put_uint(&writer, SESSION_HANDOVER_STATE_VERSION) != 0) ||
+                (amqp_writer_put_uint(&writer, outgoing_channel) != 0) ||
+                (amqp_writer_put_uint(&writer, incoming_channel) != 0) ||
+                (amqp_writer_put_uint(&writer, session->next_outgoing_id) != 0) ||
+                (amqp_writer_put_uint(&writer, session->next_incoming_id) != 0) ||
+                (amqp_writer_put_uint(&writer, session->desired_incoming_window) != 0) ||
+                (amqp_writer_put_uint(&writer, session->incoming_window) != 0) ||
+                (amqp_writer_put_uint(&writer, session->outgoing_window) != 0) ||
+                (amqp_writer_put_uint(&writer, session->remote_incoming_window) != 0) ||
+                (amqp_writer_put_uint(&writer, session->remote_outgoing_window) != 0) ||
+                (amqp_writer_put_uint(&writer, session->handle_max) != 0) ||
+                (amqp_writer_end(&writer) != 0) ||
+                (amqp_writer_get_length(&writer, length) != 0))
+            {
+                /* Codes_SRS_SESSION_01_155: [If the state does not fit in buffer_size bytes, session_save_handover_state shall fail and return a non-zero value.] */
+                LogError("Cannot encode the session handover state");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int session_restore_handover_state(SESSION_HANDLE session, const unsigned char* bytes, size_t length)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_156: [If session or bytes is NULL, session_restore_handover_state shall fail and return a non-zero value.] */
+    if ((session == NULL) ||
+        (bytes == NULL))
+    {
+        LogError("Bad arguments: session = %p, bytes = %p",
+            session, bytes);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_SESSION_01_157: [If the session has already been begun, session_restore_handover_state shall fail and return a non-zero value.] */
+    else if ((session->is_underlying_connection_open != UNDERLYING_CONNECTION_NOT_OPEN) ||
+        (session->session_state != SESSION_STATE_UNMAPPED))
+    {
+        LogError("A handover state can only be restored before the session is begun");
+        result = __FAILURE__;
+    }
+    else
+    {
+        AMQP_READER reader;
+        AMQP_READER_ITEM list;
+        uint32_t version;
+        uint32_t outgoing_channel;
+        uint32_t incoming_channel;
+        uint32_t next_outgoing_id;
+        uint32_t next_incoming_id;
+        uint32_t desired_incoming_window;
+        uint32_t incoming_window;
+        uint32_t outgoing_window;
+        uint32_t remote_incoming_window;
+        uint32_t remote_outgoing_window;
+        uint32_t handle_max;
+
+        /* Codes_SRS_SESSION_01_158: [If bytes is not a session handover state of this version or its channels cannot be restored on the endpoint of the session with connection_endpoint_restore_channels, session_restore_handover_state shall fail and return a non-zero value.] */
+        if ((amqp_reader_init(&reader, bytes, length) != 0) ||
+            (amqp_reader_next(&reader, &list) != 0) ||
+            (list.type != AMQP_TYPE_LIST) ||
+            (list.count != SESSION_HANDOVER_STATE_FIELD_COUNT) ||
+            (amqp_reader_enter(&reader, &list) != 0) ||
+            (read_handover_uint(&reader, &version) != 0) ||
+            (version != SESSION_HANDOVER_STATE_VERSION) ||
+            (read_handover_uint(&reader, &outgoing_channel) != 0) ||
+            (read_handover_uint(&reader, &incoming_channel) != 0) ||
+            (read_handover_uint(&reader, &next_outgoing_id) != 0) ||
+            (read_handover_uint(&reader, &next_incoming_id) != 0) ||
+            (read_handover_uint(&reader, &desired_incoming_window) != 0) ||
+            (read_handover_uint(&reader, &incoming_window) != 0) ||
+            (read_handover_uint(&reader, &outgoing_window) != 0) ||
+            (read_handover_uint(&reader, &remote_incoming_window) != 0) ||
+            (read_handover_uint(&reader, &remote_outgoing_window) != 0) ||
+            (read_handover_uint(&reader, &handle_max) != 0) ||
+            (outgoing_channel > UINT16_MAX) ||
+            (incoming_channel > UINT16_MAX))
+        {
+            LogError("Bad session handover state");
+            result = __FAILURE__;
+        }
+        else if (connection_endpoint_restore_channels(session->endpoint, (uint16_t)outgoing_channel, (uint16_t)incoming_channel) != 0)
+        {
+            LogError("Cannot restore the channels of the session");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_SESSION_01_159: [On success, session_restore_handover_state shall set the transfer ids, windows and handle max of the session from bytes and return 0, and the session shall resume when its connection is OPENED instead of sending a BEGIN frame.] */
+            session->next_outgoing_id = next_outgoing_id;
+            session->next_incoming_id = next_incoming_id;
+            session->desired_incoming_window = desired_incoming_window;
+            session->incoming_window = incoming_window;
+            session->outgoing_window = outgoing_window;
+            session->remote_incoming_window = remote_incoming_window;
+            session->remote_outgoing_window = remote_outgoing_window;
+            session->handle_max = handle_max;
+            session->is_resuming_handover = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int session_get_link_endpoint_handles(LINK_ENDPOINT_HANDLE link_endpoint, handle* output_handle, handle* input_handle)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_161: [If link_endpoint, output_handle or input_handle is NULL, session_get_link_endpoint_handles shall fail and return a non-zero value.] */
+    if ((link_endpoint == NULL) ||
+        (output_handle == NULL) ||
+        (input_handle == NULL))
+    {
+        LogError("Bad arguments: link_endpoint = %p, output_handle = %p, input_handle = %p",
+            link_endpoint, output_handle, input_handle);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_SESSION_01_162: [session_get_link_endpoint_handles shall return in output_handle and input_handle the handles of the link endpoint and return 0.] */
+        *output_handle = link_endpoint->output_handle;
+        *input_handle = link_endpoint->input_handle;
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_set_link_endpoint_on_dowork(LINK_ENDPOINT_HANDLE link_endpoint, ON_LINK_ENDPOINT_DOWORK on_dowork, void* context)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_168: [If link_endpoint is NULL, session_set_link_endpoint_on_dowork shall fail and return a non-zero value.] */
+    if (link_endpoint == NULL)
+    {
+        LogError("NULL link_endpoint");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint->session;
+        ON_LINK_ENDPOINT_DOWORK previous_on_dowork = link_endpoint->on_dowork;
+        void* previous_on_dowork_context = link_endpoint->on_dowork_context;
+        uint32_t previous_dowork_link_endpoint_count = session_instance->dowork_link_endpoint_count;
+
+        if ((previous_on_dowork == NULL) && (on_dowork != NULL))
+        {
+            session_instance->dowork_link_endpoint_count++;
+        }
+        else if ((previous_on_dowork != NULL) && (on_dowork == NULL))
+        {
+            session_instance->dowork_link_endpoint_count--;
+        }
+
+        link_endpoint->on_dowork = on_dowork;
+        link_endpoint->on_dowork_context = context;
+
+        /* Codes_SRS_SESSION_01_169: [session_set_link_endpoint_on_dowork shall set the callback called with context on every connection_dowork, a NULL callback removing it, registering the dowork callback of the session with connection_endpoint_set_on_dowork while any link endpoint has one, and return 0.] */
+        if (update_session_endpoint_dowork(session_instance) != 0)
+        {
+            /* Codes_SRS_SESSION_01_171: [If connection_endpoint_set_on_dowork fails, session_set_link_endpoint_on_dowork shall fail, keep the previous callback and return a non-zero value.] */
+            LogError("Cannot set the dowork callback of the session endpoint");
+            link_endpoint->on_dowork = previous_on_dowork;
+            link_endpoint->on_dowork_context = previous_on_dowork_context;
+            session_instance->dowork_link_endpoint_count = previous_dowork_link_endpoint_count;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int session_get_next_delivery_id(LINK_ENDPOINT_HANDLE link_endpoint, delivery_number* delivery_id)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_166: [If link_endpoint or delivery_id is NULL, session_get_next_delivery_id shall fail and return a non-zero value.] */
+    if ((link_endpoint == NULL) ||
+        (delivery_id == NULL))
+    {
+        LogError("Bad arguments: link_endpoint = %p, delivery_id = %p",
+            link_endpoint, delivery_id);
+        result = __FAILURE__;
+    }
+    else
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint->session;
+
+        /* Codes_SRS_SESSION_01_167: [session_get_next_delivery_id shall return in delivery_id the delivery id that the next transfer starting a delivery on the session will be given and return 0.] */
+        *delivery_id = session_instance->next_outgoing_id;
+        result = 0;
+    }
+
+    return result;
+}
+
+int session_restore_link_endpoint_handles(LINK_ENDPOINT_HANDLE link_endpoint, handle output_handle, handle input_handle)
+{
+    int result;
+
+    /* Codes_SRS_SESSION_01_163: [If link_endpoint is NULL, session_restore_link_endpoint_handles shall fail and return a non-zero value.] */
+    if (link_endpoint == NULL)
+    {
+        LogError("NULL link_endpoint");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SESSION_INSTANCE* session_instance = (SESSION_INSTANCE*)link_endpoint->session;
+        uint32_t index;
+        uint32_t insert_index = 0;
+        bool is_handle_used = false;
+
+        for (index = 0; index < session_instance->link_endpoint_count; index++)
+        {
+            if ((session_instance->link_endpoints[index] != link_endpoint) &&
+                (session_instance->link_endpoints[index]->output_handle == output_handle))
+            {
+                is_handle_used = true;
+            }
+        }
+
+        /* Codes_SRS_SESSION_01_164: [If output_handle is used by another link endpoint, is above the handle max, or input_handle cannot be mapped, session_restore_link_endpoint_handles shall fail and return a non-zero value.] */
+        if ((is_handle_used) ||
+            (output_handle > session_instance->handle_max) ||
+            (set_link_endpoint_input_handle(session_instance, link_endpoint, input_handle) != 0))
+        {
+            LogError("Cannot restore output handle %u and input handle %u", (unsigned int)output_handle, (unsigned int)input_handle);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_SESSION_01_165: [session_restore_link_endpoint_handles shall move the link endpoint to output_handle, keeping the link endpoints sorted by output handle, map input_handle to it and return 0.] */
+            for (index = 0; session_instance->link_endpoints[index] != link_endpoint; index++)
+            {
+            }
+
+            if (index + 1 < session_instance->link_endpoint_count)
+            {
+                (void)memmove(&session_instance->link_endpoints[index], &session_instance->link_endpoints[index + 1], sizeof(LINK_ENDPOINT_INSTANCE*) * (session_instance->link_endpoint_count - index - 1));
+            }
+
+            while ((insert_index < session_instance->link_endpoint_count - 1) &&
+                (session_instance->link_endpoints[insert_index]->output_handle < output_handle))
+            {
+                insert_index++;
+            }
+
+            if (insert_index < session_instance->link_endpoint_count - 1)
+            {
+                (void)memmove(&session_instance->link_endpoints[insert_index + 1], &session_instance->link_endpoints[insert_index], sizeof(LINK_ENDPOINT_INSTANCE*) * (session_instance->link_endpoint_count - 1 - insert_index));
+            }
+
+            session_instance->link_endpoints[insert_index] = link_endpoint;
+            link_endpoint->output_handle = output_handle;
+
+            /* the transfer template carries the output handle, it is rebuilt by the next templated transfer */
+            link_endpoint->transfer_template_size = 0;
+
+            result = 0;
         }
     }
 
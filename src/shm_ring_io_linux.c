@@ -0,0 +1,726 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_uamqp_c/shm_ring_io.h"
+
+#define SHM_RING_MAGIC 0x474E5251 /* "QRNG" */
+#define SHM_RING_VERSION 1
+#define CACHE_LINE_SIZE 64
+
+/* ring 0 carries the bytes of the creating peer, ring 1 those of the attaching peer */
+#define CREATOR_RING_INDEX 0
+#define ATTACHER_RING_INDEX 1
+
+/* the consumer and producer positions are on their own cache lines, positions only grow and are taken modulo the size */
+typedef struct SHM_RING_TAG
+{
+    uint64_t head;
+    unsigned char head_padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+    uint64_t tail;
+    unsigned char tail_padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+    uint32_t consumer_waiting;
+    uint32_t wakeup_sequence;
+    uint32_t producer_closed;
+    unsigned char flags_padding[CACHE_LINE_SIZE - (3 * sizeof(uint32_t))];
+} SHM_RING;
+
+typedef struct SHM_SEGMENT_HEADER_TAG
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ring_size;
+    uint32_t is_attached;
+    unsigned char padding[CACHE_LINE_SIZE - (2 * sizeof(uint32_t)) - sizeof(uint64_t) - sizeof(uint32_t)];
+    SHM_RING rings[2];
+    /* the bytes of the two rings follow, ring_size each */
+} SHM_SEGMENT_HEADER;
+
+typedef enum IO_STATE_TAG
+{
+    IO_STATE_NOT_OPEN,
+    IO_STATE_OPEN,
+    IO_STATE_ERROR
+} IO_STATE;
+
+typedef struct PENDING_SEND_TAG
+{
+    struct PENDING_SEND_TAG* next;
+    size_t size;
+    size_t written;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    /* the bytes follow in the same allocation */
+} PENDING_SEND;
+
+typedef struct SHM_RING_IO_INSTANCE_TAG
+{
+    char* path;
+    bool create;
+    size_t ring_size;
+    IO_STATE io_state;
+    int fd;
+    SHM_SEGMENT_HEADER* segment;
+    size_t segment_size;
+    SHM_RING* out_ring;
+    unsigned char* out_bytes;
+    SHM_RING* in_ring;
+    unsigned char* in_bytes;
+    PENDING_SEND* pending_sends_head;
+    PENDING_SEND* pending_sends_tail;
+    ON_BYTES_RECEIVED on_bytes_received;
+    ON_IO_ERROR on_io_error;
+    void* on_bytes_received_context;
+    void* on_io_error_context;
+} SHM_RING_IO_INSTANCE;
+
+static void wake_consumer(SHM_RING* ring)
+{
+    /* pairs with the fence in wait_for_data: either the consumer sees the new tail or we see it waiting */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->consumer_waiting, __ATOMIC_RELAXED) != 0)
+    {
+        (void)__atomic_add_fetch(&ring->wakeup_sequence, 1, __ATOMIC_RELEASE);
+        /* not FUTEX_PRIVATE_FLAG, the waiter is in another process */
+        (void)syscall(SYS_futex, &ring->wakeup_sequence, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+static size_t write_to_ring(SHM_RING_IO_INSTANCE* shm_ring_io, const unsigned char* bytes, size_t size)
+{
+    SHM_RING* ring = shm_ring_io->out_ring;
+    uint64_t tail = ring->tail;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t free_size = shm_ring_io->ring_size - (size_t)(tail - head);
+    size_t result = (size < free_size) ? size : free_size;
+
+    if (result > 0)
+    {
+        size_t offset = (size_t)(tail & (shm_ring_io->ring_size - 1));
+        size_t first_part = shm_ring_io->ring_size - offset;
+
+        if (first_part >= result)
+        {
+            (void)memcpy(shm_ring_io->out_bytes + offset, bytes, result);
+        }
+        else
+        {
+            (void)memcpy(shm_ring_io->out_bytes + offset, bytes, first_part);
+            (void)memcpy(shm_ring_io->out_bytes, bytes + first_part, result - first_part);
+        }
+
+        __atomic_store_n(&ring->tail, tail + result, __ATOMIC_RELEASE);
+        wake_consumer(ring);
+    }
+
+    return result;
+}
+
+static void indicate_error(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    shm_ring_io->io_state = IO_STATE_ERROR;
+    shm_ring_io->on_io_error(shm_ring_io->on_io_error_context);
+}
+
+static void flush_pending_sends(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    /* the list is looked at again after each callback, which may have queued more sends or closed the io */
+    while ((shm_ring_io->io_state == IO_STATE_OPEN) &&
+        (shm_ring_io->pending_sends_head != NULL))
+    {
+        PENDING_SEND* pending_send = shm_ring_io->pending_sends_head;
+
+        pending_send->written += write_to_ring(shm_ring_io, (const unsigned char*)(pending_send + 1) + pending_send->written, pending_send->size - pending_send->written);
+        if (pending_send->written < pending_send->size)
+        {
+            /* the ring is full, the peer has to catch up */
+            break;
+        }
+
+        shm_ring_io->pending_sends_head = pending_send->next;
+        if (shm_ring_io->pending_sends_head == NULL)
+        {
+            shm_ring_io->pending_sends_tail = NULL;
+        }
+
+        if (pending_send->on_send_complete != NULL)
+        {
+            pending_send->on_send_complete(pending_send->callback_context, IO_SEND_OK);
+        }
+
+        free(pending_send);
+    }
+}
+
+static void receive_from_ring(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    SHM_RING* ring = shm_ring_io->in_ring;
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (tail != head)
+    {
+        size_t available = (size_t)(tail - head);
+        size_t offset = (size_t)(head & (shm_ring_io->ring_size - 1));
+        size_t first_part = shm_ring_io->ring_size - offset;
+
+        if (first_part > available)
+        {
+            first_part = available;
+        }
+
+        /* straight from the ring, the frame codec copies what it keeps */
+        shm_ring_io->on_bytes_received(shm_ring_io->on_bytes_received_context, shm_ring_io->in_bytes + offset, first_part);
+
+        /* the callback may have closed the io and unmapped the ring */
+        if ((shm_ring_io->io_state == IO_STATE_OPEN) &&
+            (available > first_part))
+        {
+            shm_ring_io->on_bytes_received(shm_ring_io->on_bytes_received_context, shm_ring_io->in_bytes, available - first_part);
+        }
+
+        if (shm_ring_io->io_state != IO_STATE_NOT_OPEN)
+        {
+            __atomic_store_n(&ring->head, tail, __ATOMIC_RELEASE);
+        }
+    }
+    else if (__atomic_load_n(&ring->producer_closed, __ATOMIC_ACQUIRE) != 0)
+    {
+        /* everything the peer wrote before closing has been delivered */
+        LogError("The peer closed the shared memory rings");
+        indicate_error(shm_ring_io);
+    }
+}
+
+static void wait_for_data(SHM_RING_IO_INSTANCE* shm_ring_io, unsigned int timeout_ms)
+{
+    SHM_RING* ring = shm_ring_io->in_ring;
+    uint32_t wakeup_sequence = __atomic_load_n(&ring->wakeup_sequence, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(&ring->consumer_waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if ((__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ring->head) &&
+        (__atomic_load_n(&ring->producer_closed, __ATOMIC_ACQUIRE) == 0))
+    {
+        struct timespec timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+
+        /* returns right away if the producer bumped the sequence since it was read */
+        (void)syscall(SYS_futex, &ring->wakeup_sequence, FUTEX_WAIT, wakeup_sequence, &timeout, NULL, 0);
+    }
+
+    __atomic_store_n(&ring->consumer_waiting, 0, __ATOMIC_RELAXED);
+}
+
+static int map_segment(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    int result;
+
+    shm_ring_io->segment = (SHM_SEGMENT_HEADER*)mmap(NULL, shm_ring_io->segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_ring_io->fd, 0);
+    if (shm_ring_io->segment == MAP_FAILED)
+    {
+        LogError("Cannot map %s, errno %d", shm_ring_io->path, errno);
+        shm_ring_io->segment = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned char* ring_bytes = (unsigned char*)(shm_ring_io->segment + 1);
+        size_t out_index = shm_ring_io->create ? CREATOR_RING_INDEX : ATTACHER_RING_INDEX;
+        size_t in_index = shm_ring_io->create ? ATTACHER_RING_INDEX : CREATOR_RING_INDEX;
+
+        shm_ring_io->out_ring = &shm_ring_io->segment->rings[out_index];
+        shm_ring_io->out_bytes = ring_bytes + (out_index * shm_ring_io->ring_size);
+        shm_ring_io->in_ring = &shm_ring_io->segment->rings[in_index];
+        shm_ring_io->in_bytes = ring_bytes + (in_index * shm_ring_io->ring_size);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int create_segment(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    int result;
+
+    /* a file left by a previous run is replaced, a peer still attached to it keeps its own mapping */
+    (void)unlink(shm_ring_io->path);
+
+    shm_ring_io->segment_size = sizeof(SHM_SEGMENT_HEADER) + (2 * shm_ring_io->ring_size);
+    shm_ring_io->fd = open(shm_ring_io->path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (shm_ring_io->fd == -1)
+    {
+        LogError("Cannot create %s, errno %d", shm_ring_io->path, errno);
+        result = __FAILURE__;
+    }
+    else if (ftruncate(shm_ring_io->fd, (off_t)shm_ring_io->segment_size) != 0)
+    {
+        LogError("Cannot size %s, errno %d", shm_ring_io->path, errno);
+        (void)close(shm_ring_io->fd);
+        (void)unlink(shm_ring_io->path);
+        result = __FAILURE__;
+    }
+    else if (map_segment(shm_ring_io) != 0)
+    {
+        (void)close(shm_ring_io->fd);
+        (void)unlink(shm_ring_io->path);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the file starts zeroed, so the rings are empty; the magic goes last so that an attaching peer sees the rest set */
+        shm_ring_io->segment->version = SHM_RING_VERSION;
+        shm_ring_io->segment->ring_size = shm_ring_io->ring_size;
+        __atomic_store_n(&shm_ring_io->segment->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int attach_segment(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    int result;
+    struct stat file_stat;
+
+    shm_ring_io->fd = open(shm_ring_io->path, O_RDWR | O_CLOEXEC);
+    if (shm_ring_io->fd == -1)
+    {
+        LogError("Cannot open %s, errno %d", shm_ring_io->path, errno);
+        result = __FAILURE__;
+    }
+    else if ((fstat(shm_ring_io->fd, &file_stat) != 0) ||
+        ((size_t)file_stat.st_size < sizeof(SHM_SEGMENT_HEADER)))
+    {
+        LogError("%s is not a shared memory ring file", shm_ring_io->path);
+        (void)close(shm_ring_io->fd);
+        result = __FAILURE__;
+    }
+    else
+    {
+        shm_ring_io->segment_size = (size_t)file_stat.st_size;
+        shm_ring_io->ring_size = (shm_ring_io->segment_size - sizeof(SHM_SEGMENT_HEADER)) / 2;
+
+        if (map_segment(shm_ring_io) != 0)
+        {
+            (void)close(shm_ring_io->fd);
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint32_t not_attached = 0;
+
+            if ((__atomic_load_n(&shm_ring_io->segment->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC) ||
+                (shm_ring_io->segment->version != SHM_RING_VERSION) ||
+                (shm_ring_io->segment->ring_size != shm_ring_io->ring_size))
+            {
+                LogError("%s is not a shared memory ring file of this version", shm_ring_io->path);
+                result = __FAILURE__;
+            }
+            else if (!__atomic_compare_exchange_n(&shm_ring_io->segment->is_attached, &not_attached, 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                LogError("Another peer is attached to %s", shm_ring_io->path);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            if (result != 0)
+            {
+                (void)munmap(shm_ring_io->segment, shm_ring_io->segment_size);
+                shm_ring_io->segment = NULL;
+                (void)close(shm_ring_io->fd);
+            }
+        }
+    }
+
+    return result;
+}
+
+static void release_segment(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    /* the peer drains what is left in our ring and then sees the close */
+    __atomic_store_n(&shm_ring_io->out_ring->producer_closed, 1, __ATOMIC_RELEASE);
+    wake_consumer(shm_ring_io->out_ring);
+
+    (void)munmap(shm_ring_io->segment, shm_ring_io->segment_size);
+    shm_ring_io->segment = NULL;
+    (void)close(shm_ring_io->fd);
+    shm_ring_io->fd = -1;
+
+    if (shm_ring_io->create)
+    {
+        /* the attached peer keeps its mapping, the name is not needed anymore */
+        (void)unlink(shm_ring_io->path);
+    }
+}
+
+static void cancel_pending_sends(SHM_RING_IO_INSTANCE* shm_ring_io)
+{
+    while (shm_ring_io->pending_sends_head != NULL)
+    {
+        PENDING_SEND* pending_send = shm_ring_io->pending_sends_head;
+        shm_ring_io->pending_sends_head = pending_send->next;
+        if (shm_ring_io->pending_sends_head == NULL)
+        {
+            shm_ring_io->pending_sends_tail = NULL;
+        }
+
+        if (pending_send->on_send_complete != NULL)
+        {
+            pending_send->on_send_complete(pending_send->callback_context, IO_SEND_CANCELLED);
+        }
+
+        free(pending_send);
+    }
+}
+
+static void* shm_ring_io_clone_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+    return NULL;
+}
+
+static void shm_ring_io_destroy_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+}
+
+static int shm_ring_io_setoption(CONCRETE_IO_HANDLE shm_ring_io, const char* option_name, const void* value)
+{
+    int result;
+    SHM_RING_IO_INSTANCE* shm_ring_io_instance = (SHM_RING_IO_INSTANCE*)shm_ring_io;
+
+    if ((shm_ring_io == NULL) ||
+        (option_name == NULL) ||
+        (value == NULL))
+    {
+        LogError("Bad arguments: shm_ring_io = %p, option_name = %p, value = %p",
+            shm_ring_io, option_name, value);
+        result = __FAILURE__;
+    }
+    else if (strcmp(option_name, SHM_RING_IO_OPTION_WAIT_FOR_DATA_MS) == 0)
+    {
+        if (shm_ring_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("The io is not open");
+            result = __FAILURE__;
+        }
+        else
+        {
+            wait_for_data(shm_ring_io_instance, *(const unsigned int*)value);
+            result = 0;
+        }
+    }
+    else
+    {
+        LogError("Unknown option: %s", option_name);
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE shm_ring_io_retrieveoptions(CONCRETE_IO_HANDLE shm_ring_io)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (shm_ring_io == NULL)
+    {
+        LogError("NULL shm_ring_io");
+        result = NULL;
+    }
+    else
+    {
+        /* the wait is an action rather than a setting, there is nothing to carry over */
+        result = OptionHandler_Create(shm_ring_io_clone_option, shm_ring_io_destroy_option, shm_ring_io_setoption);
+        if (result == NULL)
+        {
+            LogError("unable to OptionHandler_Create");
+        }
+    }
+
+    return result;
+}
+
+static CONCRETE_IO_HANDLE shm_ring_io_create(void* io_create_parameters)
+{
+    SHM_RING_IO_INSTANCE* result;
+    SHM_RING_IO_CONFIG* shm_ring_io_config = (SHM_RING_IO_CONFIG*)io_create_parameters;
+    size_t ring_size = ((shm_ring_io_config == NULL) || (shm_ring_io_config->ring_size == 0)) ? SHM_RING_IO_DEFAULT_RING_SIZE : shm_ring_io_config->ring_size;
+
+    if ((shm_ring_io_config == NULL) ||
+        (shm_ring_io_config->path == NULL) ||
+        ((ring_size & (ring_size - 1)) != 0))
+    {
+        LogError("Bad arguments: shm_ring_io_config = %p, ring_size = %u",
+            shm_ring_io_config, (unsigned int)ring_size);
+        result = NULL;
+    }
+    else
+    {
+        result = (SHM_RING_IO_INSTANCE*)malloc(sizeof(SHM_RING_IO_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for the shared memory ring io");
+        }
+        else if (mallocAndStrcpy_s(&result->path, shm_ring_io_config->path) != 0)
+        {
+            LogError("Cannot copy the path");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->create = shm_ring_io_config->create;
+            result->ring_size = ring_size;
+            result->io_state = IO_STATE_NOT_OPEN;
+            result->fd = -1;
+            result->segment = NULL;
+            result->segment_size = 0;
+            result->out_ring = NULL;
+            result->out_bytes = NULL;
+            result->in_ring = NULL;
+            result->in_bytes = NULL;
+            result->pending_sends_head = NULL;
+            result->pending_sends_tail = NULL;
+            result->on_bytes_received = NULL;
+            result->on_io_error = NULL;
+            result->on_bytes_received_context = NULL;
+            result->on_io_error_context = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void shm_ring_io_destroy(CONCRETE_IO_HANDLE shm_ring_io)
+{
+    if (shm_ring_io == NULL)
+    {
+        LogError("NULL shm_ring_io");
+    }
+    else
+    {
+        SHM_RING_IO_INSTANCE* shm_ring_io_instance = (SHM_RING_IO_INSTANCE*)shm_ring_io;
+
+        if (shm_ring_io_instance->segment != NULL)
+        {
+            release_segment(shm_ring_io_instance);
+        }
+
+        cancel_pending_sends(shm_ring_io_instance);
+        free(shm_ring_io_instance->path);
+        free(shm_ring_io_instance);
+    }
+}
+
+static int shm_ring_io_open(CONCRETE_IO_HANDLE shm_ring_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    SHM_RING_IO_INSTANCE* shm_ring_io_instance = (SHM_RING_IO_INSTANCE*)shm_ring_io;
+
+    if ((shm_ring_io == NULL) ||
+        (on_bytes_received == NULL) ||
+        (on_io_error == NULL))
+    {
+        LogError("Bad arguments: shm_ring_io = %p, on_bytes_received = %p, on_io_error = %p",
+            shm_ring_io, on_bytes_received, on_io_error);
+        result = __FAILURE__;
+    }
+    else if (shm_ring_io_instance->io_state != IO_STATE_NOT_OPEN)
+    {
+        LogError("The io is already open");
+        result = __FAILURE__;
+    }
+    else if ((shm_ring_io_instance->create ? create_segment(shm_ring_io_instance) : attach_segment(shm_ring_io_instance)) != 0)
+    {
+        LogError("Cannot set up the shared memory rings");
+        result = __FAILURE__;
+    }
+    else
+    {
+        shm_ring_io_instance->on_bytes_received = on_bytes_received;
+        shm_ring_io_instance->on_bytes_received_context = on_bytes_received_context;
+        shm_ring_io_instance->on_io_error = on_io_error;
+        shm_ring_io_instance->on_io_error_context = on_io_error_context;
+        shm_ring_io_instance->io_state = IO_STATE_OPEN;
+
+        /* bytes written before the peer attaches simply wait in the ring */
+        if (on_io_open_complete != NULL)
+        {
+            on_io_open_complete(on_io_open_complete_context, IO_OPEN_OK);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int shm_ring_io_close(CONCRETE_IO_HANDLE shm_ring_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+    SHM_RING_IO_INSTANCE* shm_ring_io_instance = (SHM_RING_IO_INSTANCE*)shm_ring_io;
+
+    if (shm_ring_io == NULL)
+    {
+        LogError("NULL shm_ring_io");
+        result = __FAILURE__;
+    }
+    else if (shm_ring_io_instance->io_state == IO_STATE_NOT_OPEN)
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        shm_ring_io_instance->io_state = IO_STATE_NOT_OPEN;
+        release_segment(shm_ring_io_instance);
+        cancel_pending_sends(shm_ring_io_instance);
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int shm_ring_io_send(CONCRETE_IO_HANDLE shm_ring_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    SHM_RING_IO_INSTANCE* shm_ring_io_instance = (SHM_RING_IO_INSTANCE*)shm_ring_io;
+
+    if ((shm_ring_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        LogError("Bad arguments: shm_ring_io = %p, buffer = %p, size = %u",
+            shm_ring_io, buffer, (unsigned int)size);
+        result = __FAILURE__;
+    }
+    else if (shm_ring_io_instance->io_state != IO_STATE_OPEN)
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t written = 0;
+
+        /* sends queued before keep their order */
+        if (shm_ring_io_instance->pending_sends_head == NULL)
+        {
+            written = write_to_ring(shm_ring_io_instance, (const unsigned char*)buffer, size);
+        }
+
+        if (written == size)
+        {
+            if (on_send_complete != NULL)
+            {
+                on_send_complete(callback_context, IO_SEND_OK);
+            }
+
+            result = 0;
+        }
+        else
+        {
+            /* what does not fit waits for the peer to make room */
+            PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + (size - written));
+            if (pending_send == NULL)
+            {
+                LogError("Cannot allocate memory for the send");
+                result = __FAILURE__;
+            }
+            else
+            {
+                (void)memcpy(pending_send + 1, (const unsigned char*)buffer + written, size - written);
+                pending_send->next = NULL;
+                pending_send->size = size - written;
+                pending_send->written = 0;
+                pending_send->on_send_complete = on_send_complete;
+                pending_send->callback_context = callback_context;
+
+                if (shm_ring_io_instance->pending_sends_tail == NULL)
+                {
+                    shm_ring_io_instance->pending_sends_head = pending_send;
+                }
+                else
+                {
+                    shm_ring_io_instance->pending_sends_tail->next = pending_send;
+                }
+                shm_ring_io_instance->pending_sends_tail = pending_send;
+
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void shm_ring_io_dowork(CONCRETE_IO_HANDLE shm_ring_io)
+{
+    if (shm_ring_io == NULL)
+    {
+        LogError("NULL shm_ring_io");
+    }
+    else
+    {
+        SHM_RING_IO_INSTANCE* shm_ring_io_instance = (SHM_RING_IO_INSTANCE*)shm_ring_io;
+
+        if (shm_ring_io_instance->io_state == IO_STATE_OPEN)
+        {
+            flush_pending_sends(shm_ring_io_instance);
+        }
+
+        if (shm_ring_io_instance->io_state == IO_STATE_OPEN)
+        {
+            receive_from_ring(shm_ring_io_instance);
+        }
+    }
+}
+
+static const IO_INTERFACE_DESCRIPTION shm_ring_io_interface_description =
+{
+    shm_ring_io_retrieveoptions,
+    shm_ring_io_create,
+    shm_ring_io_destroy,
+    shm_ring_io_open,
+    shm_ring_io_close,
+    shm_ring_io_send,
+    shm_ring_io_dowork,
+    shm_ring_io_setoption
+};
+
+const IO_INTERFACE_DESCRIPTION* shm_ring_io_get_interface_description(void)
+{
+    return &shm_ring_io_interface_description;
+}
@@ -1,14 +1,26 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#ifdef __linux__
+/* for accept4 */
+#define _GNU_SOURCE
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <unistd.h>
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_uamqp_c/socket_listener.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/socketio.h"
@@ -16,7 +28,13 @@
 typedef struct SOCKET_LISTENER_INSTANCE_TAG
 {
     int port;
+    /* NULL for a TCP listener */
+    char* unix_path;
     int socket;
+    int backlog;
+    bool reuse_port;
+    int max_accepts_per_dowork;
+    ADMISSION_LIMITER_HANDLE admission_limiter;
     ON_SOCKET_ACCEPTED on_socket_accepted;
     void* callback_context;
 } SOCKET_LISTENER_INSTANCE;
@@ -24,9 +42,19 @@ typedef struct SOCKET_LISTENER_INSTANCE_TAG
 SOCKET_LISTENER_HANDLE socketlistener_create(int port)
 {
     SOCKET_LISTENER_INSTANCE* result = (SOCKET_LISTENER_INSTANCE*)malloc(sizeof(SOCKET_LISTENER_INSTANCE));
-    if (result != NULL)
+    if (result == NULL)
+    {
+        LogError("Cannot allocate memory for socket listener");
+    }
+    else
     {
         result->port = port;
+        result->unix_path = NULL;
+        result->socket = -1;
+        result->backlog = SOMAXCONN;
+        result->reuse_port = false;
+        result->max_accepts_per_dowork = SOCKET_LISTENER_DEFAULT_MAX_ACCEPTS_PER_DOWORK;
+        result->admission_limiter = NULL;
         result->on_socket_accepted = NULL;
         result->callback_context = NULL;
     }
@@ -34,15 +62,129 @@ SOCKET_LISTENER_HANDLE socketlistener_create(int port)
     return (SOCKET_LISTENER_HANDLE)result;
 }
 
+SOCKET_LISTENER_HANDLE socketlistener_create_unix(const char* path)
+{
+    SOCKET_LISTENER_INSTANCE* result;
+
+    if ((path == NULL) ||
+        (strlen(path) >= sizeof(((struct sockaddr_un*)NULL)->sun_path)))
+    {
+        LogError("Bad arguments: path = %p", path);
+        result = NULL;
+    }
+    else
+    {
+        result = (SOCKET_LISTENER_INSTANCE*)socketlistener_create(0);
+        if (result == NULL)
+        {
+            LogError("Cannot create socket listener");
+        }
+        else if (mallocAndStrcpy_s(&result->unix_path, path) != 0)
+        {
+            LogError("Cannot copy the socket path");
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return (SOCKET_LISTENER_HANDLE)result;
+}
+
+int socketlistener_setoption(SOCKET_LISTENER_HANDLE socket_listener, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((socket_listener == NULL) ||
+        (option_name == NULL) ||
+        (value == NULL))
+    {
+        LogError("Bad arguments: socket_listener = %p, option_name = %p, value = %p",
+            socket_listener, option_name, value);
+        result = __FAILURE__;
+    }
+    else if (socket_listener->socket != -1)
+    {
+        LogError("Options cannot be set on a started socket listener");
+        result = __FAILURE__;
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_BACKLOG) == 0)
+    {
+        int backlog = *(const int*)value;
+        if (backlog <= 0)
+        {
+            LogError("Invalid backlog %d", backlog);
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_listener->backlog = backlog;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_REUSE_PORT) == 0)
+    {
+#ifdef SO_REUSEPORT
+        socket_listener->reuse_port = *(const bool*)value;
+        result = 0;
+#else
+        LogError("SO_REUSEPORT is not supported on this platform");
+        result = __FAILURE__;
+#endif
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_MAX_ACCEPTS_PER_DOWORK) == 0)
+    {
+        int max_accepts_per_dowork = *(const int*)value;
+        if (max_accepts_per_dowork <= 0)
+        {
+            LogError("Invalid max accepts per dowork %d", max_accepts_per_dowork);
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_listener->max_accepts_per_dowork = max_accepts_per_dowork;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_ADMISSION_LIMITER) == 0)
+    {
+        socket_listener->admission_limiter = (ADMISSION_LIMITER_HANDLE)value;
+        result = 0;
+    }
+    else
+    {
+        LogError("Unknown option %s", option_name);
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
 void socketlistener_destroy(SOCKET_LISTENER_HANDLE socket_listener)
 {
     if (socket_listener != NULL)
     {
         socketlistener_stop(socket_listener);
+        if (socket_listener->unix_path != NULL)
+        {
+            free(socket_listener->unix_path);
+        }
         free(socket_listener);
     }
 }
 
+static void remove_stale_unix_socket(const char* path)
+{
+    struct stat path_stat;
+
+    /* only a leftover socket file is removed, anything else at path makes bind fail */
+    if ((lstat(path, &path_stat) == 0) &&
+        S_ISSOCK(path_stat.st_mode) &&
+        (unlink(path) != 0))
+    {
+        LogError("Cannot remove the stale socket %s, errno %d", path, errno);
+    }
+}
+
 int socketlistener_start(SOCKET_LISTENER_HANDLE socket_listener, ON_SOCKET_ACCEPTED on_socket_accepted, void* callback_context)
 {
     int result;
@@ -55,8 +197,9 @@ int socketlistener_start(SOCKET_LISTENER_HANDLE socket_listener, ON_SOCKET_ACCEP
     else
     {
         SOCKET_LISTENER_INSTANCE* socket_listener_instance = (SOCKET_LISTENER_INSTANCE*)socket_listener;
+        bool is_unix = (socket_listener_instance->unix_path != NULL);
 
-        socket_listener_instance->socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        socket_listener_instance->socket = is_unix ? socket(AF_UNIX, SOCK_STREAM, 0) : socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
         if (socket_listener_instance->socket == -1)
         {
             LogError("Creating socket failed");
@@ -65,15 +208,37 @@ int socketlistener_start(SOCKET_LISTENER_HANDLE socket_listener, ON_SOCKET_ACCEP
         else
         {
             struct sockaddr_in sa;
+            struct sockaddr_un sun;
+            const struct sockaddr* address;
+            socklen_t address_length;
 
             socket_listener_instance->on_socket_accepted = on_socket_accepted;
             socket_listener_instance->callback_context = callback_context;
 
-            sa.sin_family = AF_INET;
-            sa.sin_port = htons(socket_listener_instance->port);
-            sa.sin_addr.s_addr = htonl(INADDR_ANY);
+            if (is_unix)
+            {
+                (void)memset(&sun, 0, sizeof(sun));
+                sun.sun_family = AF_UNIX;
+                (void)strcpy(sun.sun_path, socket_listener_instance->unix_path);
+                address = (const struct sockaddr*)&sun;
+                address_length = (socklen_t)sizeof(sun);
+
+                remove_stale_unix_socket(socket_listener_instance->unix_path);
+            }
+            else
+            {
+                sa.sin_family = AF_INET;
+                sa.sin_port = htons(socket_listener_instance->port);
+                sa.sin_addr.s_addr = htonl(INADDR_ANY);
+                address = (const struct sockaddr*)&sa;
+                address_length = (socklen_t)sizeof(sa);
+            }
 
             int flags;
+            int reuse_address = 1;
+#ifdef SO_REUSEPORT
+            int reuse_port = 1;
+#endif
             if ((-1 == (flags = fcntl(socket_listener_instance->socket, F_GETFL, 0))) ||
                 (fcntl(socket_listener_instance->socket, F_SETFL, flags | O_NONBLOCK) == -1))
             {
@@ -82,7 +247,28 @@ int socketlistener_start(SOCKET_LISTENER_HANDLE socket_listener, ON_SOCKET_ACCEP
                 socket_listener_instance->socket = -1;
                 result = __FAILURE__;
             }
-            else if (bind(socket_listener_instance->socket, (const struct sockaddr*)&sa, sizeof(sa)) == -1)
+            /* a restarted server can bind while connections of the previous run are in TIME_WAIT */
+            else if ((!is_unix) &&
+                (setsockopt(socket_listener_instance->socket, SOL_SOCKET, SO_REUSEADDR, &reuse_address, sizeof(reuse_address)) == -1))
+            {
+                LogError("Failure: setting SO_REUSEADDR failed.");
+                (void)close(socket_listener_instance->socket);
+                socket_listener_instance->socket = -1;
+                result = __FAILURE__;
+            }
+#ifdef SO_REUSEPORT
+            /* several listeners (one per thread) on the same port get the incoming connections balanced by the kernel */
+            else if ((!is_unix) &&
+                socket_listener_instance->reuse_port &&
+                (setsockopt(socket_listener_instance->socket, SOL_SOCKET, SO_REUSEPORT, &reuse_port, sizeof(reuse_port)) == -1))
+            {
+                LogError("Failure: setting SO_REUSEPORT failed.");
+                (void)close(socket_listener_instance->socket);
+                socket_listener_instance->socket = -1;
+                result = __FAILURE__;
+            }
+#endif
+            else if (bind(socket_listener_instance->socket, address, address_length) == -1)
             {
                 LogError("bind socket failed");
                 (void)close(socket_listener_instance->socket);
@@ -91,11 +277,15 @@ int socketlistener_start(SOCKET_LISTENER_HANDLE socket_listener, ON_SOCKET_ACCEP
             }
             else
             {
-                if (listen(socket_listener_instance->socket, SOMAXCONN) == -1)
+                if (listen(socket_listener_instance->socket, socket_listener_instance->backlog) == -1)
                 {
                     LogError("listen on socket failed");
                     (void)close(socket_listener_instance->socket);
                     socket_listener_instance->socket = -1;
+                    if (is_unix)
+                    {
+                        (void)unlink(socket_listener_instance->unix_path);
+                    }
                     result = __FAILURE__;
                 }
                 else
@@ -125,8 +315,16 @@ int socketlistener_stop(SOCKET_LISTENER_HANDLE socket_listener)
         socket_listener_instance->on_socket_accepted = NULL;
         socket_listener_instance->callback_context = NULL;
 
-        (void)close(socket_listener_instance->socket);
-        socket_listener_instance->socket = -1;
+        if (socket_listener_instance->socket != -1)
+        {
+            (void)close(socket_listener_instance->socket);
+            socket_listener_instance->socket = -1;
+
+            if (socket_listener_instance->unix_path != NULL)
+            {
+                (void)unlink(socket_listener_instance->unix_path);
+            }
+        }
 
         result = 0;
     }
@@ -134,20 +332,63 @@ int socketlistener_stop(SOCKET_LISTENER_HANDLE socket_listener)
     return result;
 }
 
+static int accept_nonblocking(int listening_socket)
+{
+    int result;
+
+#ifdef __linux__
+    /* the accepted socket is made non-blocking by the same syscall */
+    result = accept4(listening_socket, NULL, NULL, SOCK_NONBLOCK);
+#else
+    result = accept(listening_socket, NULL, NULL);
+    if (result != -1)
+    {
+        int flags;
+        if ((-1 == (flags = fcntl(result, F_GETFL, 0))) ||
+            (fcntl(result, F_SETFL, flags | O_NONBLOCK) == -1))
+        {
+            LogError("Failure: fcntl failure on accepted socket.");
+            (void)close(result);
+            result = -1;
+            errno = EAGAIN;
+        }
+    }
+#endif
+
+    return result;
+}
+
 void socketlistener_dowork(SOCKET_LISTENER_HANDLE socket_listener)
 {
     if (socket_listener != NULL)
     {
         SOCKET_LISTENER_INSTANCE* socket_listener_instance = (SOCKET_LISTENER_INSTANCE*)socket_listener;
-        int accepted_socket = accept(socket_listener_instance->socket, NULL, NULL);
-        if (accepted_socket != -1)
+        int i;
+
+        /* the accept queue is drained (up to max_accepts_per_dowork) so that a burst of connections is absorbed in one pass */
+        for (i = 0; i < socket_listener_instance->max_accepts_per_dowork; i++)
         {
-            int flags;
-            if ((-1 == (flags = fcntl(accepted_socket, F_GETFL, 0))) ||
-                (fcntl(accepted_socket, F_SETFL, flags | O_NONBLOCK) == -1))
+            int accepted_socket = accept_nonblocking(socket_listener_instance->socket);
+            if (accepted_socket == -1)
+            {
+                if ((errno != EAGAIN) &&
+                    (errno != EWOULDBLOCK) &&
+                    (errno != EINTR) &&
+                    (errno != ECONNABORTED))
+                {
+                    LogError("accept failed with errno %d", errno);
+                }
+
+                if (errno != ECONNABORTED)
+                {
+                    break;
+                }
+            }
+            else if ((socket_listener_instance->admission_limiter != NULL) &&
+                (!admission_limiter_try_acquire(socket_listener_instance->admission_limiter)))
             {
-                LogError("Failure: fcntl failure on accepted socket.");
-                close(accepted_socket);
+                /* refused before any io or connection is built for it */
+                (void)close(accepted_socket);
             }
             else if (socket_listener_instance->on_socket_accepted != NULL)
             {
@@ -161,6 +402,12 @@ void socketlistener_dowork(SOCKET_LISTENER_HANDLE socket_listener)
             {
                 (void)close(accepted_socket);
             }
+
+            /* the callback may have stopped the listener */
+            if (socket_listener_instance->socket == -1)
+            {
+                break;
+            }
         }
     }
 }
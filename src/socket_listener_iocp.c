@@ -0,0 +1,435 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "winsock2.h"
+#include "ws2tcpip.h"
+#include "mswsock.h"
+#include "windows.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_uamqp_c/socket_listener.h"
+#include "azure_uamqp_c/iocpio.h"
+
+/* AcceptEx wants room for each address plus 16 bytes */
+#define ACCEPT_ADDRESS_SIZE (sizeof(SOCKADDR_STORAGE) + 16)
+
+typedef struct SOCKET_LISTENER_INSTANCE_TAG SOCKET_LISTENER_INSTANCE;
+
+typedef struct PENDING_ACCEPT_TAG
+{
+    IOCP_OPERATION operation;
+    SOCKET_LISTENER_INSTANCE* socket_listener;
+    SOCKET accepted_socket;
+    bool is_posted;
+    unsigned char addresses[2 * ACCEPT_ADDRESS_SIZE];
+} PENDING_ACCEPT;
+
+struct SOCKET_LISTENER_INSTANCE_TAG
+{
+    int port;
+    SOCKET socket;
+    int backlog;
+    int max_accepts_per_dowork;
+    ADMISSION_LIMITER_HANDLE admission_limiter;
+    IOCP_PORT_HANDLE iocp_port;
+    LPFN_ACCEPTEX accept_ex;
+    /* max_accepts_per_dowork of them, all posted while the listener runs */
+    PENDING_ACCEPT** pending_accepts;
+    ON_SOCKET_ACCEPTED on_socket_accepted;
+    void* callback_context;
+};
+
+static void on_accept_complete(void* context, IOCP_OPERATION* operation, bool succeeded, DWORD bytes_transferred);
+
+static int post_accept(SOCKET_LISTENER_INSTANCE* socket_listener, PENDING_ACCEPT* pending_accept)
+{
+    int result;
+    DWORD bytes_received;
+
+    pending_accept->accepted_socket = WSASocket(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+    if (pending_accept->accepted_socket == INVALID_SOCKET)
+    {
+        LogError("Cannot create the socket for AcceptEx, error=%d", WSAGetLastError());
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memset(&pending_accept->operation.overlapped, 0, sizeof(OVERLAPPED));
+        pending_accept->operation.on_operation_complete = on_accept_complete;
+        pending_accept->operation.context = pending_accept;
+
+        /* no data is received with the accept, the connection is handed out as soon as it is established */
+        if ((!socket_listener->accept_ex(socket_listener->socket, pending_accept->accepted_socket, pending_accept->addresses, 0,
+            ACCEPT_ADDRESS_SIZE, ACCEPT_ADDRESS_SIZE, &bytes_received, &pending_accept->operation.overlapped)) &&
+            (WSAGetLastError() != ERROR_IO_PENDING))
+        {
+            LogError("AcceptEx failed, error=%d", WSAGetLastError());
+            (void)closesocket(pending_accept->accepted_socket);
+            pending_accept->accepted_socket = INVALID_SOCKET;
+            result = __FAILURE__;
+        }
+        else
+        {
+            pending_accept->is_posted = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void on_accept_complete(void* context, IOCP_OPERATION* operation, bool succeeded, DWORD bytes_transferred)
+{
+    PENDING_ACCEPT* pending_accept = (PENDING_ACCEPT*)context;
+    SOCKET_LISTENER_INSTANCE* socket_listener = pending_accept->socket_listener;
+    SOCKET accepted_socket = pending_accept->accepted_socket;
+
+    (void)operation;
+    (void)bytes_transferred;
+
+    pending_accept->is_posted = false;
+    pending_accept->accepted_socket = INVALID_SOCKET;
+
+    if (!succeeded)
+    {
+        LogError("AcceptEx completed with an error");
+        (void)closesocket(accepted_socket);
+    }
+    else if (setsockopt(accepted_socket, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, (const char*)&socket_listener->socket, sizeof(socket_listener->socket)) != 0)
+    {
+        LogError("Cannot update the accept context, error=%d", WSAGetLastError());
+        (void)closesocket(accepted_socket);
+    }
+    else if ((socket_listener->admission_limiter != NULL) &&
+        (!admission_limiter_try_acquire(socket_listener->admission_limiter)))
+    {
+        /* refused before any io or connection is built for it, the accept is posted again below */
+        (void)closesocket(accepted_socket);
+    }
+    else
+    {
+        IOCPIO_CONFIG iocpio_config;
+        iocpio_config.hostname = NULL;
+        iocpio_config.port = socket_listener->port;
+        iocpio_config.accepted_socket = &accepted_socket;
+        /* the connection completes on the listener's port unless the application moves it to another thread's port */
+        iocpio_config.iocp_port = socket_listener->iocp_port;
+        socket_listener->on_socket_accepted(socket_listener->callback_context, iocpio_get_interface_description(), &iocpio_config);
+    }
+
+    /* the callback may have stopped the listener */
+    if ((socket_listener->socket != INVALID_SOCKET) &&
+        (post_accept(socket_listener, pending_accept) != 0))
+    {
+        LogError("Cannot post the next AcceptEx, socketlistener_dowork tries again");
+    }
+}
+
+static void abandon_pending_accepts(SOCKET_LISTENER_INSTANCE* socket_listener)
+{
+    int i;
+
+    for (i = 0; i < socket_listener->max_accepts_per_dowork; i++)
+    {
+        PENDING_ACCEPT* pending_accept = socket_listener->pending_accepts[i];
+
+        if (pending_accept->is_posted)
+        {
+            /* closing the accept socket cancels the AcceptEx, the port frees the operation once it completes */
+            (void)closesocket(pending_accept->accepted_socket);
+            iocp_port_abandon_operation(socket_listener->iocp_port, &pending_accept->operation);
+        }
+        else
+        {
+            free(pending_accept);
+        }
+    }
+
+    free(socket_listener->pending_accepts);
+    socket_listener->pending_accepts = NULL;
+}
+
+SOCKET_LISTENER_HANDLE socketlistener_create(int port)
+{
+    SOCKET_LISTENER_INSTANCE* result = (SOCKET_LISTENER_INSTANCE*)malloc(sizeof(SOCKET_LISTENER_INSTANCE));
+    if (result == NULL)
+    {
+        LogError("Cannot allocate memory for socket listener");
+    }
+    else
+    {
+        result->port = port;
+        result->socket = INVALID_SOCKET;
+        result->backlog = SOMAXCONN;
+        result->max_accepts_per_dowork = SOCKET_LISTENER_DEFAULT_MAX_ACCEPTS_PER_DOWORK;
+        result->admission_limiter = NULL;
+        result->iocp_port = NULL;
+        result->accept_ex = NULL;
+        result->pending_accepts = NULL;
+        result->on_socket_accepted = NULL;
+        result->callback_context = NULL;
+    }
+
+    return (SOCKET_LISTENER_HANDLE)result;
+}
+
+SOCKET_LISTENER_HANDLE socketlistener_create_unix(const char* path)
+{
+    (void)path;
+    LogError("Unix domain socket listeners are not supported on Windows");
+    return NULL;
+}
+
+int socketlistener_setoption(SOCKET_LISTENER_HANDLE socket_listener, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((socket_listener == NULL) ||
+        (option_name == NULL) ||
+        (value == NULL))
+    {
+        LogError("Bad arguments: socket_listener = %p, option_name = %p, value = %p",
+            socket_listener, option_name, value);
+        result = __FAILURE__;
+    }
+    else if (socket_listener->socket != INVALID_SOCKET)
+    {
+        LogError("Options cannot be set on a started socket listener");
+        result = __FAILURE__;
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_BACKLOG) == 0)
+    {
+        int backlog = *(const int*)value;
+        if (backlog <= 0)
+        {
+            LogError("Invalid backlog %d", backlog);
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_listener->backlog = backlog;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_MAX_ACCEPTS_PER_DOWORK) == 0)
+    {
+        /* with AcceptEx this is how many accepts are kept posted, and so how many connections one dowork hands out at most */
+        int max_accepts_per_dowork = *(const int*)value;
+        if (max_accepts_per_dowork <= 0)
+        {
+            LogError("Invalid max accepts per dowork %d", max_accepts_per_dowork);
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_listener->max_accepts_per_dowork = max_accepts_per_dowork;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_ADMISSION_LIMITER) == 0)
+    {
+        socket_listener->admission_limiter = (ADMISSION_LIMITER_HANDLE)value;
+        result = 0;
+    }
+    else
+    {
+        /* there is no SO_REUSEPORT load balancing with winsock, so reuse_port is not supported either */
+        LogError("Unknown option %s", option_name);
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+void socketlistener_destroy(SOCKET_LISTENER_HANDLE socket_listener)
+{
+    if (socket_listener != NULL)
+    {
+        socketlistener_stop(socket_listener);
+        free(socket_listener);
+    }
+}
+
+int socketlistener_start(SOCKET_LISTENER_HANDLE socket_listener, ON_SOCKET_ACCEPTED on_socket_accepted, void* callback_context)
+{
+    int result;
+
+    if ((socket_listener == NULL) ||
+        (on_socket_accepted == NULL))
+    {
+        LogError("Bad arguments: socket_listener = %p, on_socket_accepted = %p",
+            socket_listener, on_socket_accepted);
+        result = __FAILURE__;
+    }
+    else if (socket_listener->socket != INVALID_SOCKET)
+    {
+        LogError("The socket listener is already started");
+        result = __FAILURE__;
+    }
+    else if ((socket_listener->iocp_port = iocp_port_create()) == NULL)
+    {
+        LogError("Could not create the completion port");
+        result = __FAILURE__;
+    }
+    else
+    {
+        socket_listener->socket = WSASocket(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+        if (socket_listener->socket == INVALID_SOCKET)
+        {
+            LogError("Could not create socket");
+            iocp_port_destroy(socket_listener->iocp_port);
+            socket_listener->iocp_port = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            struct sockaddr_in service;
+            GUID accept_ex_guid = WSAID_ACCEPTEX;
+            DWORD bytes_returned;
+
+            socket_listener->on_socket_accepted = on_socket_accepted;
+            socket_listener->callback_context = callback_context;
+
+            service.sin_family = AF_INET;
+            service.sin_addr.s_addr = INADDR_ANY;
+            service.sin_port = htons((u_short)socket_listener->port);
+
+            if ((bind(socket_listener->socket, (SOCKADDR *)&service, sizeof(service)) == SOCKET_ERROR) ||
+                (listen(socket_listener->socket, socket_listener->backlog) == SOCKET_ERROR))
+            {
+                LogError("Could not start listening for connections");
+                result = __FAILURE__;
+            }
+            else if (iocp_port_associate(socket_listener->iocp_port, socket_listener->socket) != 0)
+            {
+                LogError("Could not associate the listening socket with the completion port");
+                result = __FAILURE__;
+            }
+            else if (WSAIoctl(socket_listener->socket, SIO_GET_EXTENSION_FUNCTION_POINTER, &accept_ex_guid, sizeof(accept_ex_guid),
+                &socket_listener->accept_ex, sizeof(socket_listener->accept_ex), &bytes_returned, NULL, NULL) == SOCKET_ERROR)
+            {
+                LogError("Could not get AcceptEx, error=%d", WSAGetLastError());
+                result = __FAILURE__;
+            }
+            else if ((socket_listener->pending_accepts = (PENDING_ACCEPT**)calloc((size_t)socket_listener->max_accepts_per_dowork, sizeof(PENDING_ACCEPT*))) == NULL)
+            {
+                LogError("Could not allocate the pending accepts");
+                result = __FAILURE__;
+            }
+            else
+            {
+                int i;
+
+                for (i = 0; i < socket_listener->max_accepts_per_dowork; i++)
+                {
+                    socket_listener->pending_accepts[i] = (PENDING_ACCEPT*)malloc(sizeof(PENDING_ACCEPT));
+                    if (socket_listener->pending_accepts[i] == NULL)
+                    {
+                        break;
+                    }
+
+                    socket_listener->pending_accepts[i]->socket_listener = socket_listener;
+                    socket_listener->pending_accepts[i]->accepted_socket = INVALID_SOCKET;
+                    socket_listener->pending_accepts[i]->is_posted = false;
+                }
+
+                if (i < socket_listener->max_accepts_per_dowork)
+                {
+                    LogError("Could not allocate the pending accepts");
+                    while (i > 0)
+                    {
+                        i--;
+                        free(socket_listener->pending_accepts[i]);
+                    }
+
+                    free(socket_listener->pending_accepts);
+                    socket_listener->pending_accepts = NULL;
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* a failed post is retried by socketlistener_dowork */
+                    for (i = 0; i < socket_listener->max_accepts_per_dowork; i++)
+                    {
+                        (void)post_accept(socket_listener, socket_listener->pending_accepts[i]);
+                    }
+
+                    result = 0;
+                }
+            }
+
+            if (result != 0)
+            {
+                (void)closesocket(socket_listener->socket);
+                socket_listener->socket = INVALID_SOCKET;
+                iocp_port_destroy(socket_listener->iocp_port);
+                socket_listener->iocp_port = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+int socketlistener_stop(SOCKET_LISTENER_HANDLE socket_listener)
+{
+    int result;
+
+    if (socket_listener == NULL)
+    {
+        LogError("NULL socket_listener");
+        result = __FAILURE__;
+    }
+    else
+    {
+        socket_listener->on_socket_accepted = NULL;
+        socket_listener->callback_context = NULL;
+
+        if (socket_listener->socket != INVALID_SOCKET)
+        {
+            (void)closesocket(socket_listener->socket);
+            socket_listener->socket = INVALID_SOCKET;
+
+            abandon_pending_accepts(socket_listener);
+
+            /* connections still on the port keep it, whoever drives them calls iocp_port_dowork from now on */
+            iocp_port_destroy(socket_listener->iocp_port);
+            socket_listener->iocp_port = NULL;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+void socketlistener_dowork(SOCKET_LISTENER_HANDLE socket_listener)
+{
+    if (socket_listener == NULL)
+    {
+        LogError("NULL socket_listener");
+    }
+    else if (socket_listener->socket != INVALID_SOCKET)
+    {
+        int i;
+
+        for (i = 0; i < socket_listener->max_accepts_per_dowork; i++)
+        {
+            if ((!socket_listener->pending_accepts[i]->is_posted) &&
+                (post_accept(socket_listener, socket_listener->pending_accepts[i]) != 0))
+            {
+                break;
+            }
+        }
+
+        /* one dequeue for the accepts and for the connections left on the listener's port */
+        if (iocp_port_dowork(socket_listener->iocp_port, 0) != 0)
+        {
+            LogError("Could not process the completions of the listener");
+        }
+    }
+}
@@ -2,6 +2,8 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
 #include "winsock2.h"
 #include "ws2tcpip.h"
 #include "windows.h"
@@ -15,6 +17,9 @@ typedef struct SOCKET_LISTENER_INSTANCE_TAG
 {
     int port;
     SOCKET socket;
+    int backlog;
+    int max_accepts_per_dowork;
+    ADMISSION_LIMITER_HANDLE admission_limiter;
     ON_SOCKET_ACCEPTED on_socket_accepted;
     void* callback_context;
 } SOCKET_LISTENER_INSTANCE;
@@ -29,6 +34,10 @@ SOCKET_LISTENER_HANDLE socketlistener_create(int port)
     else
     {
         result->port = port;
+        result->socket = INVALID_SOCKET;
+        result->backlog = SOMAXCONN;
+        result->max_accepts_per_dowork = SOCKET_LISTENER_DEFAULT_MAX_ACCEPTS_PER_DOWORK;
+        result->admission_limiter = NULL;
         result->on_socket_accepted = NULL;
         result->callback_context = NULL;
     }
@@ -36,6 +45,73 @@ SOCKET_LISTENER_HANDLE socketlistener_create(int port)
     return (SOCKET_LISTENER_HANDLE)result;
 }
 
+SOCKET_LISTENER_HANDLE socketlistener_create_unix(const char* path)
+{
+    (void)path;
+    LogError("Unix domain socket listeners are not supported on Windows");
+    return NULL;
+}
+
+int socketlistener_setoption(SOCKET_LISTENER_HANDLE socket_listener, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((socket_listener == NULL) ||
+        (option_name == NULL) ||
+        (value == NULL))
+    {
+        LogError("Bad arguments: socket_listener = %p, option_name = %p, value = %p",
+            socket_listener, option_name, value);
+        result = __FAILURE__;
+    }
+    else if (socket_listener->socket != INVALID_SOCKET)
+    {
+        LogError("Options cannot be set on a started socket listener");
+        result = __FAILURE__;
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_BACKLOG) == 0)
+    {
+        int backlog = *(const int*)value;
+        if (backlog <= 0)
+        {
+            LogError("Invalid backlog %d", backlog);
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_listener->backlog = backlog;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_MAX_ACCEPTS_PER_DOWORK) == 0)
+    {
+        int max_accepts_per_dowork = *(const int*)value;
+        if (max_accepts_per_dowork <= 0)
+        {
+            LogError("Invalid max accepts per dowork %d", max_accepts_per_dowork);
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_listener->max_accepts_per_dowork = max_accepts_per_dowork;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, SOCKET_LISTENER_OPTION_ADMISSION_LIMITER) == 0)
+    {
+        socket_listener->admission_limiter = (ADMISSION_LIMITER_HANDLE)value;
+        result = 0;
+    }
+    else
+    {
+        /* there is no SO_REUSEPORT load balancing with winsock, so reuse_port is not supported either */
+        LogError("Unknown option %s", option_name);
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
 void socketlistener_destroy(SOCKET_LISTENER_HANDLE socket_listener)
 {
     if (socket_listener != NULL)
@@ -94,7 +170,7 @@ int socketlistener_start(SOCKET_LISTENER_HANDLE socket_listener, ON_SOCKET_ACCEP
             }
             else
             {
-                if (listen(socket_listener->socket, SOMAXCONN) == SOCKET_ERROR)
+                if (listen(socket_listener->socket, socket_listener->backlog) == SOCKET_ERROR)
                 {
                     LogError("Could not start listening for connections");
                     (void)closesocket(socket_listener->socket);
@@ -126,8 +202,11 @@ int socketlistener_stop(SOCKET_LISTENER_HANDLE socket_listener)
         socket_listener->on_socket_accepted = NULL;
         socket_listener->callback_context = NULL;
 
-        (void)closesocket(socket_listener->socket);
-        socket_listener->socket = INVALID_SOCKET;
+        if (socket_listener->socket != INVALID_SOCKET)
+        {
+            (void)closesocket(socket_listener->socket);
+            socket_listener->socket = INVALID_SOCKET;
+        }
 
         result = 0;
     }
@@ -143,14 +222,30 @@ void socketlistener_dowork(SOCKET_LISTENER_HANDLE socket_listener)
     }
     else
     {
-        SOCKET accepted_socket = accept(socket_listener->socket, NULL, NULL);
-        if (accepted_socket != INVALID_SOCKET)
+        int i;
+
+        /* the accept queue is drained (up to max_accepts_per_dowork) so that a burst of connections is absorbed in one pass */
+        for (i = 0; (i < socket_listener->max_accepts_per_dowork) && (socket_listener->socket != INVALID_SOCKET); i++)
         {
-            SOCKETIO_CONFIG socketio_config;
-            socketio_config.hostname = NULL;
-            socketio_config.port = socket_listener->port;
-            socketio_config.accepted_socket = &accepted_socket;
-            socket_listener->on_socket_accepted(socket_listener->callback_context, socketio_get_interface_description(), &socketio_config);
+            SOCKET accepted_socket = accept(socket_listener->socket, NULL, NULL);
+            if (accepted_socket == INVALID_SOCKET)
+            {
+                break;
+            }
+            else if ((socket_listener->admission_limiter != NULL) &&
+                (!admission_limiter_try_acquire(socket_listener->admission_limiter)))
+            {
+                /* refused before any io or connection is built for it */
+                (void)closesocket(accepted_socket);
+            }
+            else
+            {
+                SOCKETIO_CONFIG socketio_config;
+                socketio_config.hostname = NULL;
+                socketio_config.port = socket_listener->port;
+                socketio_config.accepted_socket = &accepted_socket;
+                socket_listener->on_socket_accepted(socket_listener->callback_context, socketio_get_interface_description(), &socketio_config);
+            }
         }
     }
 }
@@ -0,0 +1,382 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/timer_wheel.h"
+
+/* circular doubly linked list node, each slot and the expired list have a sentinel node */
+typedef struct TIMER_LIST_ENTRY_TAG
+{
+    struct TIMER_LIST_ENTRY_TAG* next;
+    struct TIMER_LIST_ENTRY_TAG* previous;
+} TIMER_LIST_ENTRY;
+
+typedef struct TIMER_WHEEL_INSTANCE_TAG
+{
+    uint32_t tick_ms;
+    size_t slot_count;
+    TIMER_LIST_ENTRY* slots;
+    TIMER_LIST_ENTRY expired_timers;
+    /* all ticks up to and including this one have been processed */
+    uint64_t processed_tick;
+    size_t started_timer_count;
+    bool is_advancing;
+} TIMER_WHEEL_INSTANCE;
+
+typedef struct TIMER_WHEEL_TIMER_INSTANCE_TAG
+{
+    /* must stay the first member so that list entries can be cast back to timers */
+    TIMER_LIST_ENTRY list_entry;
+    TIMER_WHEEL_INSTANCE* timer_wheel;
+    uint64_t expiry_tick;
+    ON_TIMER_EXPIRED on_timer_expired;
+    void* on_timer_expired_context;
+} TIMER_WHEEL_TIMER_INSTANCE;
+
+static void initialize_list(TIMER_LIST_ENTRY* list)
+{
+    list->next = list;
+    list->previous = list;
+}
+
+static void insert_tail(TIMER_LIST_ENTRY* list, TIMER_LIST_ENTRY* entry)
+{
+    entry->next = list;
+    entry->previous = list->previous;
+    list->previous->next = entry;
+    list->previous = entry;
+}
+
+static void unlink_timer(TIMER_WHEEL_TIMER_INSTANCE* timer)
+{
+    if (timer->list_entry.next != NULL)
+    {
+        timer->list_entry.previous->next = timer->list_entry.next;
+        timer->list_entry.next->previous = timer->list_entry.previous;
+        timer->list_entry.next = NULL;
+        timer->list_entry.previous = NULL;
+
+        timer->timer_wheel->started_timer_count--;
+    }
+}
+
+TIMER_WHEEL_HANDLE timer_wheel_create(uint32_t tick_ms, size_t slot_count, uint64_t current_ms)
+{
+    TIMER_WHEEL_INSTANCE* timer_wheel;
+
+    if ((tick_ms == 0) ||
+        (slot_count == 0))
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_002: [ If `tick_ms` or `slot_count` is 0, `timer_wheel_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: tick_ms = %u, slot_count = %u",
+            (unsigned int)tick_ms, (unsigned int)slot_count);
+        timer_wheel = NULL;
+    }
+    else
+    {
+        timer_wheel = (TIMER_WHEEL_INSTANCE*)malloc(sizeof(TIMER_WHEEL_INSTANCE));
+        if (timer_wheel == NULL)
+        {
+            /* Codes_SRS_TIMER_WHEEL_01_003: [ If allocating memory for the timer wheel fails, `timer_wheel_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for timer wheel");
+        }
+        else
+        {
+            timer_wheel->slots = (TIMER_LIST_ENTRY*)malloc(sizeof(TIMER_LIST_ENTRY) * slot_count);
+            if (timer_wheel->slots == NULL)
+            {
+                /* Codes_SRS_TIMER_WHEEL_01_003: [ If allocating memory for the timer wheel fails, `timer_wheel_create` shall fail and return NULL. ]*/
+                LogError("Cannot allocate memory for timer wheel slots");
+                free(timer_wheel);
+                timer_wheel = NULL;
+            }
+            else
+            {
+                size_t i;
+
+                /* Codes_SRS_TIMER_WHEEL_01_001: [ `timer_wheel_create` shall create a timer wheel with `slot_count` slots of `tick_ms` milliseconds each, whose time starts at `current_ms`, and return a non-NULL handle to it. ]*/
+                for (i = 0; i < slot_count; i++)
+                {
+                    initialize_list(&timer_wheel->slots[i]);
+                }
+
+                initialize_list(&timer_wheel->expired_timers);
+                timer_wheel->tick_ms = tick_ms;
+                timer_wheel->slot_count = slot_count;
+                timer_wheel->processed_tick = current_ms / tick_ms;
+                timer_wheel->started_timer_count = 0;
+                timer_wheel->is_advancing = false;
+            }
+        }
+    }
+
+    return timer_wheel;
+}
+
+void timer_wheel_destroy(TIMER_WHEEL_HANDLE timer_wheel)
+{
+    if (timer_wheel == NULL)
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_005: [ If `timer_wheel` is NULL, `timer_wheel_destroy` shall do nothing. ]*/
+        LogError("NULL timer_wheel");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_TIMER_WHEEL_01_004: [ `timer_wheel_destroy` shall stop all started timers and free all resources associated with the timer wheel. ]*/
+        for (i = 0; i < timer_wheel->slot_count; i++)
+        {
+            while (timer_wheel->slots[i].next != &timer_wheel->slots[i])
+            {
+                unlink_timer((TIMER_WHEEL_TIMER_INSTANCE*)timer_wheel->slots[i].next);
+            }
+        }
+
+        free(timer_wheel->slots);
+        free(timer_wheel);
+    }
+}
+
+TIMER_WHEEL_TIMER_HANDLE timer_wheel_create_timer(TIMER_WHEEL_HANDLE timer_wheel, ON_TIMER_EXPIRED on_timer_expired, void* on_timer_expired_context)
+{
+    TIMER_WHEEL_TIMER_INSTANCE* timer;
+
+    if ((timer_wheel == NULL) ||
+        (on_timer_expired == NULL))
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_007: [ If `timer_wheel` or `on_timer_expired` is NULL, `timer_wheel_create_timer` shall fail and return NULL. ]*/
+        LogError("Bad arguments: timer_wheel = %p, on_timer_expired = %p",
+            timer_wheel, on_timer_expired);
+        timer = NULL;
+    }
+    else
+    {
+        timer = (TIMER_WHEEL_TIMER_INSTANCE*)malloc(sizeof(TIMER_WHEEL_TIMER_INSTANCE));
+        if (timer == NULL)
+        {
+            /* Codes_SRS_TIMER_WHEEL_01_008: [ If allocating memory for the timer fails, `timer_wheel_create_timer` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for timer");
+        }
+        else
+        {
+            /* Codes_SRS_TIMER_WHEEL_01_006: [ `timer_wheel_create_timer` shall create a stopped timer that calls `on_timer_expired` with `on_timer_expired_context` when it expires and return a non-NULL handle to it. ]*/
+            timer->list_entry.next = NULL;
+            timer->list_entry.previous = NULL;
+            timer->timer_wheel = timer_wheel;
+            timer->expiry_tick = 0;
+            timer->on_timer_expired = on_timer_expired;
+            timer->on_timer_expired_context = on_timer_expired_context;
+        }
+    }
+
+    return timer;
+}
+
+void timer_wheel_destroy_timer(TIMER_WHEEL_TIMER_HANDLE timer)
+{
+    if (timer == NULL)
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_010: [ If `timer` is NULL, `timer_wheel_destroy_timer` shall do nothing. ]*/
+        LogError("NULL timer");
+    }
+    else
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_009: [ `timer_wheel_destroy_timer` shall stop the timer and free it. ]*/
+        unlink_timer(timer);
+        free(timer);
+    }
+}
+
+int timer_wheel_start_timer(TIMER_WHEEL_TIMER_HANDLE timer, uint64_t deadline_ms)
+{
+    int result;
+
+    if (timer == NULL)
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_014: [ If `timer` is NULL, `timer_wheel_start_timer` shall fail and return a non-zero value. ]*/
+        LogError("NULL timer");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TIMER_WHEEL_INSTANCE* timer_wheel = timer->timer_wheel;
+        /* Codes_SRS_TIMER_WHEEL_01_011: [ `timer_wheel_start_timer` shall arm the timer to expire at `deadline_ms` rounded up to the next tick, rescheduling it if it was already started. ]*/
+        uint64_t expiry_tick = (deadline_ms / timer_wheel->tick_ms) + (((deadline_ms % timer_wheel->tick_ms) != 0) ? 1 : 0);
+
+        /* Codes_SRS_TIMER_WHEEL_01_012: [ If the deadline tick has already been processed, the timer shall expire on the next tick. ]*/
+        if (expiry_tick <= timer_wheel->processed_tick)
+        {
+            expiry_tick = timer_wheel->processed_tick + 1;
+        }
+
+        unlink_timer(timer);
+
+        timer->expiry_tick = expiry_tick;
+        insert_tail(&timer_wheel->slots[expiry_tick % timer_wheel->slot_count], &timer->list_entry);
+        timer_wheel->started_timer_count++;
+
+        /* Codes_SRS_TIMER_WHEEL_01_013: [ On success, `timer_wheel_start_timer` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int timer_wheel_stop_timer(TIMER_WHEEL_TIMER_HANDLE timer)
+{
+    int result;
+
+    if (timer == NULL)
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_017: [ If `timer` is NULL, `timer_wheel_stop_timer` shall fail and return a non-zero value. ]*/
+        LogError("NULL timer");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_015: [ `timer_wheel_stop_timer` shall stop the timer so that it does not expire. Stopping a timer that is not started shall not be an error. ]*/
+        unlink_timer(timer);
+
+        /* Codes_SRS_TIMER_WHEEL_01_016: [ On success, `timer_wheel_stop_timer` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int timer_wheel_advance(TIMER_WHEEL_HANDLE timer_wheel, uint64_t current_ms)
+{
+    int result;
+
+    if (timer_wheel == NULL)
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_022: [ If `timer_wheel` is NULL, `timer_wheel_advance` shall fail and return a non-zero value. ]*/
+        LogError("NULL timer_wheel");
+        result = __FAILURE__;
+    }
+    else if (timer_wheel->is_advancing)
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_023: [ If `timer_wheel_advance` is called from an `on_timer_expired` callback, it shall fail and return a non-zero value. ]*/
+        LogError("timer_wheel_advance called from a timer callback");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint64_t current_tick = current_ms / timer_wheel->tick_ms;
+
+        if (current_tick > timer_wheel->processed_tick)
+        {
+            uint64_t tick_count = current_tick - timer_wheel->processed_tick;
+            uint64_t i;
+
+            /* past one full rotation every slot is visited once */
+            if (tick_count > timer_wheel->slot_count)
+            {
+                tick_count = timer_wheel->slot_count;
+            }
+
+            /* Codes_SRS_TIMER_WHEEL_01_018: [ `timer_wheel_advance` shall expire all timers whose expiry tick is not after `current_ms`, only visiting the slots of the ticks elapsed since the previous call. ]*/
+            for (i = 1; i <= tick_count; i++)
+            {
+                TIMER_LIST_ENTRY* slot = &timer_wheel->slots[(timer_wheel->processed_tick + i) % timer_wheel->slot_count];
+                TIMER_LIST_ENTRY* entry = slot->next;
+
+                while (entry != slot)
+                {
+                    TIMER_WHEEL_TIMER_INSTANCE* timer = (TIMER_WHEEL_TIMER_INSTANCE*)entry;
+                    entry = entry->next;
+
+                    /* timers further than one rotation away stay in their slot */
+                    if (timer->expiry_tick <= current_tick)
+                    {
+                        timer->list_entry.previous->next = timer->list_entry.next;
+                        timer->list_entry.next->previous = timer->list_entry.previous;
+                        insert_tail(&timer_wheel->expired_timers, &timer->list_entry);
+                    }
+                }
+            }
+
+            /* Codes_SRS_TIMER_WHEEL_01_019: [ Timers started from an `on_timer_expired` callback shall not expire in the same `timer_wheel_advance` call. ]*/
+            timer_wheel->processed_tick = current_tick;
+            timer_wheel->is_advancing = true;
+
+            /* Codes_SRS_TIMER_WHEEL_01_020: [ A timer stopped or destroyed from an `on_timer_expired` callback before it expires shall not expire. ]*/
+            while (timer_wheel->expired_timers.next != &timer_wheel->expired_timers)
+            {
+                TIMER_WHEEL_TIMER_INSTANCE* timer = (TIMER_WHEEL_TIMER_INSTANCE*)timer_wheel->expired_timers.next;
+                unlink_timer(timer);
+                timer->on_timer_expired(timer->on_timer_expired_context);
+            }
+
+            timer_wheel->is_advancing = false;
+        }
+
+        /* Codes_SRS_TIMER_WHEEL_01_021: [ On success, `timer_wheel_advance` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int timer_wheel_get_next_expiry(TIMER_WHEEL_HANDLE timer_wheel, uint64_t* expiry_ms)
+{
+    int result;
+
+    if ((timer_wheel == NULL) ||
+        (expiry_ms == NULL))
+    {
+        /* Codes_SRS_TIMER_WHEEL_01_028: [ If `timer_wheel` or `expiry_ms` is NULL, `timer_wheel_get_next_expiry` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: timer_wheel = %p, expiry_ms = %p",
+            timer_wheel, expiry_ms);
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (timer_wheel->started_timer_count == 0)
+        {
+            /* Codes_SRS_TIMER_WHEEL_01_026: [ If no timer is started, `timer_wheel_get_next_expiry` shall return UINT64_MAX in `expiry_ms`. ]*/
+            *expiry_ms = UINT64_MAX;
+        }
+        else
+        {
+            size_t i;
+
+            /* Codes_SRS_TIMER_WHEEL_01_025: [ If no started timer expires within the next rotation, `timer_wheel_get_next_expiry` shall return the time one rotation after the last processed tick. ]*/
+            *expiry_ms = (timer_wheel->processed_tick + timer_wheel->slot_count) * timer_wheel->tick_ms;
+
+            /* Codes_SRS_TIMER_WHEEL_01_024: [ `timer_wheel_get_next_expiry` shall return in `expiry_ms` the time of the earliest tick in the next rotation at which a started timer expires. ]*/
+            for (i = 1; i <= timer_wheel->slot_count; i++)
+            {
+                uint64_t tick = timer_wheel->processed_tick + i;
+                TIMER_LIST_ENTRY* slot = &timer_wheel->slots[tick % timer_wheel->slot_count];
+                TIMER_LIST_ENTRY* entry;
+
+                for (entry = slot->next; entry != slot; entry = entry->next)
+                {
+                    if (((TIMER_WHEEL_TIMER_INSTANCE*)entry)->expiry_tick <= tick)
+                    {
+                        break;
+                    }
+                }
+
+                if (entry != slot)
+                {
+                    *expiry_ms = tick * timer_wheel->tick_ms;
+                    break;
+                }
+            }
+        }
+
+        /* Codes_SRS_TIMER_WHEEL_01_027: [ On success, `timer_wheel_get_next_expiry` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
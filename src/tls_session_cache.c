@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <string.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_uamqp_c/tls_session_cache.h"
+
+typedef struct CACHED_TLS_SESSION_TAG
+{
+    char* hostname;
+    OPTIONHANDLER_HANDLE io_options;
+} CACHED_TLS_SESSION;
+
+typedef struct TLS_SESSION_CACHE_INSTANCE_TAG
+{
+    /* a handful of hosts at most, so they are looked up one by one */
+    CACHED_TLS_SESSION* sessions;
+    size_t session_count;
+} TLS_SESSION_CACHE_INSTANCE;
+
+static CACHED_TLS_SESSION* find_cached_session(TLS_SESSION_CACHE_INSTANCE* tls_session_cache, const char* hostname)
+{
+    CACHED_TLS_SESSION* result = NULL;
+    size_t i;
+
+    for (i = 0; i < tls_session_cache->session_count; i++)
+    {
+        if (strcmp(tls_session_cache->sessions[i].hostname, hostname) == 0)
+        {
+            result = &tls_session_cache->sessions[i];
+            break;
+        }
+    }
+
+    return result;
+}
+
+TLS_SESSION_CACHE_HANDLE tls_session_cache_create(void)
+{
+    TLS_SESSION_CACHE_INSTANCE* result = (TLS_SESSION_CACHE_INSTANCE*)malloc(sizeof(TLS_SESSION_CACHE_INSTANCE));
+    if (result == NULL)
+    {
+        /* Codes_SRS_TLS_SESSION_CACHE_01_002: [ If allocating memory fails, `tls_session_cache_create` shall fail and return NULL. ]*/
+        LogError("Cannot allocate memory for the TLS session cache");
+    }
+    else
+    {
+        /* Codes_SRS_TLS_SESSION_CACHE_01_001: [ `tls_session_cache_create` shall create a new empty TLS session cache and on success return a non-NULL handle to it. ]*/
+        result->sessions = NULL;
+        result->session_count = 0;
+    }
+
+    return result;
+}
+
+void tls_session_cache_destroy(TLS_SESSION_CACHE_HANDLE tls_session_cache)
+{
+    if (tls_session_cache == NULL)
+    {
+        /* Codes_SRS_TLS_SESSION_CACHE_01_004: [ If `tls_session_cache` is NULL, `tls_session_cache_destroy` shall do nothing. ]*/
+        LogError("NULL tls_session_cache");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_TLS_SESSION_CACHE_01_003: [ `tls_session_cache_destroy` shall destroy the options kept for every host by calling `OptionHandler_Destroy` and free the cache. ]*/
+        for (i = 0; i < tls_session_cache->session_count; i++)
+        {
+            OptionHandler_Destroy(tls_session_cache->sessions[i].io_options);
+            free(tls_session_cache->sessions[i].hostname);
+        }
+
+        if (tls_session_cache->sessions != NULL)
+        {
+            free(tls_session_cache->sessions);
+        }
+
+        free(tls_session_cache);
+    }
+}
+
+int tls_session_cache_save(TLS_SESSION_CACHE_HANDLE tls_session_cache, const char* hostname, XIO_HANDLE xio)
+{
+    int result;
+
+    if ((tls_session_cache == NULL) ||
+        (hostname == NULL) ||
+        (xio == NULL))
+    {
+        /* Codes_SRS_TLS_SESSION_CACHE_01_006: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_save` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: tls_session_cache = %p, hostname = %p, xio = %p",
+            tls_session_cache, hostname, xio);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_TLS_SESSION_CACHE_01_007: [ `tls_session_cache_save` shall get the options of `xio` by calling `xio_retrieveoptions`. ]*/
+        OPTIONHANDLER_HANDLE io_options = xio_retrieveoptions(xio);
+        if (io_options == NULL)
+        {
+            /* Codes_SRS_TLS_SESSION_CACHE_01_010: [ If any error occurs, `tls_session_cache_save` shall fail, return a non-zero value and keep the options saved before for `hostname`. ]*/
+            LogError("Cannot retrieve the io options");
+            result = __FAILURE__;
+        }
+        else
+        {
+            CACHED_TLS_SESSION* cached_session = find_cached_session(tls_session_cache, hostname);
+            if (cached_session != NULL)
+            {
+                /* Codes_SRS_TLS_SESSION_CACHE_01_008: [ If options are already kept for `hostname`, they shall be destroyed by calling `OptionHandler_Destroy` and replaced. ]*/
+                OptionHandler_Destroy(cached_session->io_options);
+                cached_session->io_options = io_options;
+
+                /* Codes_SRS_TLS_SESSION_CACHE_01_005: [ On success, `tls_session_cache_save` shall return 0. ]*/
+                result = 0;
+            }
+            else
+            {
+                /* Codes_SRS_TLS_SESSION_CACHE_01_009: [ Otherwise an entry for `hostname` shall be added, with a copy of `hostname`. ]*/
+                CACHED_TLS_SESSION* new_sessions = (CACHED_TLS_SESSION*)realloc(tls_session_cache->sessions, sizeof(CACHED_TLS_SESSION) * (tls_session_cache->session_count + 1));
+                if (new_sessions == NULL)
+                {
+                    /* Codes_SRS_TLS_SESSION_CACHE_01_010: [ If any error occurs, `tls_session_cache_save` shall fail, return a non-zero value and keep the options saved before for `hostname`. ]*/
+                    LogError("Cannot grow the TLS session cache");
+                    OptionHandler_Destroy(io_options);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    tls_session_cache->sessions = new_sessions;
+
+                    if (mallocAndStrcpy_s(&new_sessions[tls_session_cache->session_count].hostname, hostname) != 0)
+                    {
+                        /* Codes_SRS_TLS_SESSION_CACHE_01_010: [ If any error occurs, `tls_session_cache_save` shall fail, return a non-zero value and keep the options saved before for `hostname`. ]*/
+                        LogError("Cannot copy the hostname");
+                        OptionHandler_Destroy(io_options);
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        new_sessions[tls_session_cache->session_count].io_options = io_options;
+                        tls_session_cache->session_count++;
+
+                        /* Codes_SRS_TLS_SESSION_CACHE_01_005: [ On success, `tls_session_cache_save` shall return 0. ]*/
+                        result = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int tls_session_cache_apply(TLS_SESSION_CACHE_HANDLE tls_session_cache, const char* hostname, XIO_HANDLE xio)
+{
+    int result;
+
+    if ((tls_session_cache == NULL) ||
+        (hostname == NULL) ||
+        (xio == NULL))
+    {
+        /* Codes_SRS_TLS_SESSION_CACHE_01_012: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_apply` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: tls_session_cache = %p, hostname = %p, xio = %p",
+            tls_session_cache, hostname, xio);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CACHED_TLS_SESSION* cached_session = find_cached_session(tls_session_cache, hostname);
+        if (cached_session == NULL)
+        {
+            /* Codes_SRS_TLS_SESSION_CACHE_01_014: [ If no options are kept for `hostname`, `tls_session_cache_apply` shall set nothing and return 0. ]*/
+            result = 0;
+        }
+        /* Codes_SRS_TLS_SESSION_CACHE_01_013: [ `tls_session_cache_apply` shall set the options kept for `hostname` on `xio` by calling `OptionHandler_FeedOptions`. ]*/
+        else if (OptionHandler_FeedOptions(cached_session->io_options, xio) != OPTIONHANDLER_OK)
+        {
+            /* Codes_SRS_TLS_SESSION_CACHE_01_015: [ If `OptionHandler_FeedOptions` fails, `tls_session_cache_apply` shall fail and return a non-zero value. ]*/
+            LogError("Cannot set the cached options on the io");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_TLS_SESSION_CACHE_01_011: [ On success, `tls_session_cache_apply` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int tls_session_cache_remove(TLS_SESSION_CACHE_HANDLE tls_session_cache, const char* hostname)
+{
+    int result;
+
+    if ((tls_session_cache == NULL) ||
+        (hostname == NULL))
+    {
+        /* Codes_SRS_TLS_SESSION_CACHE_01_017: [ If `tls_session_cache` or `hostname` is NULL, `tls_session_cache_remove` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: tls_session_cache = %p, hostname = %p",
+            tls_session_cache, hostname);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CACHED_TLS_SESSION* cached_session = find_cached_session(tls_session_cache, hostname);
+        if (cached_session != NULL)
+        {
+            /* Codes_SRS_TLS_SESSION_CACHE_01_018: [ `tls_session_cache_remove` shall destroy the options kept for `hostname` by calling `OptionHandler_Destroy` and drop its entry. ]*/
+            OptionHandler_Destroy(cached_session->io_options);
+            free(cached_session->hostname);
+
+            /* the last entry takes the place of the removed one */
+            tls_session_cache->session_count--;
+            *cached_session = tls_session_cache->sessions[tls_session_cache->session_count];
+        }
+
+        /* Codes_SRS_TLS_SESSION_CACHE_01_016: [ On success, `tls_session_cache_remove` shall return 0, also when no options are kept for `hostname`. ]*/
+        result = 0;
+    }
+
+    return result;
+}
@@ -0,0 +1,536 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/messaging.h"
+#include "azure_uamqp_c/transaction_coordinator.h"
+
+/* descriptor codes of the transaction types, see AMQP 1.0 part 4 */
+#define DECLARE_DESCRIPTOR 0x31
+#define DISCHARGE_DESCRIPTOR 0x32
+#define DECLARED_DESCRIPTOR 0x33
+#define AMQP_VALUE_SECTION_DESCRIPTOR 0x77
+#define MAX_TXN_ID_LENGTH 32
+/* the amqp-value section holding a discharge with the longest txn-id */
+#define MAX_CONTROL_MESSAGE_SIZE (6 + 3 + 2 + MAX_TXN_ID_LENGTH + 1)
+
+typedef enum TRANSACTION_COORDINATOR_STATE_TAG
+{
+    TRANSACTION_COORDINATOR_STATE_IDLE,
+    TRANSACTION_COORDINATOR_STATE_OPENING,
+    TRANSACTION_COORDINATOR_STATE_OPEN,
+    TRANSACTION_COORDINATOR_STATE_ERROR
+} TRANSACTION_COORDINATOR_STATE;
+
+typedef struct TRANSACTION_OPERATION_TAG
+{
+    struct TRANSACTION_COORDINATOR_INSTANCE_TAG* transaction_coordinator;
+    /* exactly one of them is set */
+    ON_TRANSACTION_DECLARED on_declared;
+    ON_TRANSACTION_DISCHARGED on_discharged;
+    void* context;
+    unsigned char message_bytes[MAX_CONTROL_MESSAGE_SIZE];
+    struct TRANSACTION_OPERATION_TAG* next;
+} TRANSACTION_OPERATION;
+
+typedef struct TRANSACTION_COORDINATOR_INSTANCE_TAG
+{
+    LINK_HANDLE link;
+    TRANSACTION_COORDINATOR_STATE state;
+    ON_TRANSACTION_COORDINATOR_OPEN_COMPLETE on_open_complete;
+    void* on_open_complete_context;
+    /* declares and discharges sent and not settled yet */
+    TRANSACTION_OPERATION* pending_operations;
+} TRANSACTION_COORDINATOR_INSTANCE;
+
+static void remove_pending_operation(TRANSACTION_COORDINATOR_INSTANCE* transaction_coordinator, TRANSACTION_OPERATION* operation)
+{
+    TRANSACTION_OPERATION** current = &transaction_coordinator->pending_operations;
+
+    while ((*current != NULL) &&
+        (*current != operation))
+    {
+        current = &(*current)->next;
+    }
+
+    if (*current != NULL)
+    {
+        *current = operation->next;
+    }
+}
+
+static uint64_t get_outcome_descriptor(AMQP_VALUE delivery_state)
+{
+    uint64_t result;
+    AMQP_VALUE descriptor = (delivery_state == NULL) ? NULL : amqpvalue_get_inplace_descriptor(delivery_state);
+
+    if ((descriptor == NULL) ||
+        (amqpvalue_get_ulong(descriptor, &result) != 0))
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void indicate_declared(TRANSACTION_OPERATION* operation, LINK_DELIVERY_SETTLE_REASON reason, AMQP_VALUE delivery_state)
+{
+    if (reason != LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_022: [ If the declare is settled without a disposition (e.g. the link detached), on_declared shall be called with TRANSACTION_COORDINATOR_ERROR, NULL and 0. ]*/
+        operation->on_declared(operation->context, TRANSACTION_COORDINATOR_ERROR, NULL, 0);
+    }
+    else if (is_rejected_type_by_descriptor(amqpvalue_get_inplace_descriptor(delivery_state)))
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_020: [ If the outcome is rejected, on_declared shall be called with TRANSACTION_COORDINATOR_REJECTED, NULL and 0. ]*/
+        operation->on_declared(operation->context, TRANSACTION_COORDINATOR_REJECTED, NULL, 0);
+    }
+    else
+    {
+        AMQP_VALUE txn_id_value;
+        amqp_binary txn_id;
+
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_019: [ When the declare is settled with a declared outcome, on_declared shall be called with TRANSACTION_COORDINATOR_OK and the bytes of its txn-id. ]*/
+        if ((get_outcome_descriptor(delivery_state) != DECLARED_DESCRIPTOR) ||
+            ((txn_id_value = amqpvalue_get_list_item_in_place(amqpvalue_get_inplace_described_value(delivery_state), 0)) == NULL) ||
+            (amqpvalue_get_binary(txn_id_value, &txn_id) != 0) ||
+            (txn_id.length == 0))
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_021: [ If the outcome is neither a declared outcome with a binary txn-id nor rejected, on_declared shall be called with TRANSACTION_COORDINATOR_ERROR, NULL and 0. ]*/
+            LogError("Declare settled without a declared outcome");
+            operation->on_declared(operation->context, TRANSACTION_COORDINATOR_ERROR, NULL, 0);
+        }
+        else
+        {
+            operation->on_declared(operation->context, TRANSACTION_COORDINATOR_OK, (const unsigned char*)txn_id.bytes, txn_id.length);
+        }
+    }
+}
+
+static void indicate_discharged(TRANSACTION_OPERATION* operation, LINK_DELIVERY_SETTLE_REASON reason, AMQP_VALUE delivery_state)
+{
+    TRANSACTION_COORDINATOR_RESULT discharge_result;
+
+    if (reason != LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_029: [ If the discharge is settled without a disposition or with another outcome, on_discharged shall be called with TRANSACTION_COORDINATOR_ERROR. ]*/
+        discharge_result = TRANSACTION_COORDINATOR_ERROR;
+    }
+    else
+    {
+        AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(delivery_state);
+
+        if (is_accepted_type_by_descriptor(descriptor))
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_027: [ When the discharge is settled with the accepted outcome, on_discharged shall be called with TRANSACTION_COORDINATOR_OK. ]*/
+            discharge_result = TRANSACTION_COORDINATOR_OK;
+        }
+        else if (is_rejected_type_by_descriptor(descriptor))
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_028: [ When the discharge is settled with the rejected outcome, on_discharged shall be called with TRANSACTION_COORDINATOR_REJECTED. ]*/
+            discharge_result = TRANSACTION_COORDINATOR_REJECTED;
+        }
+        else
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_029: [ If the discharge is settled without a disposition or with another outcome, on_discharged shall be called with TRANSACTION_COORDINATOR_ERROR. ]*/
+            LogError("Discharge settled with an unexpected outcome");
+            discharge_result = TRANSACTION_COORDINATOR_ERROR;
+        }
+    }
+
+    operation->on_discharged(operation->context, discharge_result);
+}
+
+static void on_control_delivery_settled(void* context, delivery_number delivery_no, LINK_DELIVERY_SETTLE_REASON reason, AMQP_VALUE delivery_state)
+{
+    TRANSACTION_OPERATION* operation = (TRANSACTION_OPERATION*)context;
+    (void)delivery_no;
+
+    remove_pending_operation(operation->transaction_coordinator, operation);
+
+    if (operation->on_declared != NULL)
+    {
+        indicate_declared(operation, reason, delivery_state);
+    }
+    else
+    {
+        indicate_discharged(operation, reason, delivery_state);
+    }
+
+    free(operation);
+}
+
+static void on_link_state_changed(void* context, LINK_STATE new_link_state, LINK_STATE previous_link_state)
+{
+    TRANSACTION_COORDINATOR_INSTANCE* transaction_coordinator = (TRANSACTION_COORDINATOR_INSTANCE*)context;
+    (void)previous_link_state;
+
+    if (new_link_state == LINK_STATE_ATTACHED)
+    {
+        if (transaction_coordinator->state == TRANSACTION_COORDINATOR_STATE_OPENING)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_010: [ When the link is attached, on_open_complete shall be called with TRANSACTION_COORDINATOR_OK. ]*/
+            transaction_coordinator->state = TRANSACTION_COORDINATOR_STATE_OPEN;
+            transaction_coordinator->on_open_complete(transaction_coordinator->on_open_complete_context, TRANSACTION_COORDINATOR_OK);
+        }
+    }
+    else if ((new_link_state == LINK_STATE_DETACHED) ||
+        (new_link_state == LINK_STATE_ERROR))
+    {
+        if (transaction_coordinator->state == TRANSACTION_COORDINATOR_STATE_OPENING)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_011: [ If the link detaches or fails before being attached, on_open_complete shall be called with TRANSACTION_COORDINATOR_ERROR. ]*/
+            transaction_coordinator->state = TRANSACTION_COORDINATOR_STATE_ERROR;
+            transaction_coordinator->on_open_complete(transaction_coordinator->on_open_complete_context, TRANSACTION_COORDINATOR_ERROR);
+        }
+        else if (transaction_coordinator->state == TRANSACTION_COORDINATOR_STATE_OPEN)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_012: [ Once the link has detached or failed, declares and discharges shall fail. ]*/
+            transaction_coordinator->state = TRANSACTION_COORDINATOR_STATE_ERROR;
+        }
+    }
+}
+
+static int send_control_message(TRANSACTION_COORDINATOR_INSTANCE* transaction_coordinator, TRANSACTION_OPERATION* operation, size_t message_size)
+{
+    int result;
+    PAYLOAD payload;
+    LINK_TRANSFER_RESULT link_transfer_result;
+
+    payload.bytes = operation->message_bytes;
+    payload.length = message_size;
+
+    /* added first, the settlement could be reported before link_transfer_async returns */
+    operation->transaction_coordinator = transaction_coordinator;
+    operation->next = transaction_coordinator->pending_operations;
+    transaction_coordinator->pending_operations = operation;
+
+    if (link_transfer_async(transaction_coordinator->link, 0, &payload, 1, on_control_delivery_settled, operation, &link_transfer_result, 0) == NULL)
+    {
+        LogError("Cannot send the control message, link transfer result = %d", (int)link_transfer_result);
+        remove_pending_operation(transaction_coordinator, operation);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+TRANSACTION_COORDINATOR_HANDLE transaction_coordinator_create(SESSION_HANDLE session, const char* link_name)
+{
+    TRANSACTION_COORDINATOR_INSTANCE* result;
+
+    if ((session == NULL) ||
+        (link_name == NULL))
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_002: [ If session or link_name is NULL, transaction_coordinator_create shall fail and return NULL. ]*/
+        LogError("Bad arguments: session = %p, link_name = %p", session, link_name);
+        result = NULL;
+    }
+    else
+    {
+        result = (TRANSACTION_COORDINATOR_INSTANCE*)malloc(sizeof(TRANSACTION_COORDINATOR_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_003: [ If any resource cannot be created, transaction_coordinator_create shall fail and return NULL. ]*/
+            LogError("Cannot allocate the transaction coordinator");
+        }
+        else
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_001: [ transaction_coordinator_create shall create a sender link named link_name on session, with a source whose address is link_name and the coordinator target created by messaging_create_coordinator_target. ]*/
+            AMQP_VALUE source = messaging_create_source(link_name);
+            AMQP_VALUE target = messaging_create_coordinator_target();
+
+            if ((source == NULL) ||
+                (target == NULL) ||
+                ((result->link = link_create(session, link_name, role_sender, source, target)) == NULL))
+            {
+                /* Codes_SRS_TRANSACTION_COORDINATOR_01_003: [ If any resource cannot be created, transaction_coordinator_create shall fail and return NULL. ]*/
+                LogError("Cannot create the coordinator link");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->state = TRANSACTION_COORDINATOR_STATE_IDLE;
+                result->on_open_complete = NULL;
+                result->on_open_complete_context = NULL;
+                result->pending_operations = NULL;
+            }
+
+            if (source != NULL)
+            {
+                amqpvalue_destroy(source);
+            }
+
+            if (target != NULL)
+            {
+                amqpvalue_destroy(target);
+            }
+        }
+    }
+
+    return result;
+}
+
+void transaction_coordinator_destroy(TRANSACTION_COORDINATOR_HANDLE transaction_coordinator)
+{
+    if (transaction_coordinator == NULL)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_005: [ If transaction_coordinator is NULL, transaction_coordinator_destroy shall do nothing. ]*/
+        LogError("NULL transaction_coordinator");
+    }
+    else
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_004: [ transaction_coordinator_destroy shall destroy the link and free the declares and discharges still pending, without calling their callbacks. ]*/
+        link_destroy(transaction_coordinator->link);
+
+        while (transaction_coordinator->pending_operations != NULL)
+        {
+            TRANSACTION_OPERATION* operation = transaction_coordinator->pending_operations;
+            transaction_coordinator->pending_operations = operation->next;
+            free(operation);
+        }
+
+        free(transaction_coordinator);
+    }
+}
+
+int transaction_coordinator_open_async(TRANSACTION_COORDINATOR_HANDLE transaction_coordinator, ON_TRANSACTION_COORDINATOR_OPEN_COMPLETE on_open_complete, void* context)
+{
+    int result;
+
+    if ((transaction_coordinator == NULL) ||
+        (on_open_complete == NULL))
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_007: [ If transaction_coordinator or on_open_complete is NULL, transaction_coordinator_open_async shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: transaction_coordinator = %p, on_open_complete = %p", transaction_coordinator, on_open_complete);
+        result = __FAILURE__;
+    }
+    else if (transaction_coordinator->state != TRANSACTION_COORDINATOR_STATE_IDLE)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_008: [ If the transaction coordinator is already open or opening, transaction_coordinator_open_async shall fail and return a non-zero value. ]*/
+        LogError("Transaction coordinator already opened");
+        result = __FAILURE__;
+    }
+    else
+    {
+        transaction_coordinator->on_open_complete = on_open_complete;
+        transaction_coordinator->on_open_complete_context = context;
+        transaction_coordinator->state = TRANSACTION_COORDINATOR_STATE_OPENING;
+
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_006: [ transaction_coordinator_open_async shall attach the link by calling link_attach. ]*/
+        if (link_attach(transaction_coordinator->link, NULL, on_link_state_changed, NULL, transaction_coordinator) != 0)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_009: [ If link_attach fails, transaction_coordinator_open_async shall fail and return a non-zero value. ]*/
+            LogError("Cannot attach the coordinator link");
+            transaction_coordinator->state = TRANSACTION_COORDINATOR_STATE_IDLE;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int transaction_coordinator_close(TRANSACTION_COORDINATOR_HANDLE transaction_coordinator)
+{
+    int result;
+
+    if (transaction_coordinator == NULL)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_014: [ If transaction_coordinator is NULL, transaction_coordinator_close shall fail and return a non-zero value. ]*/
+        LogError("NULL transaction_coordinator");
+        result = __FAILURE__;
+    }
+    else if (transaction_coordinator->state == TRANSACTION_COORDINATOR_STATE_IDLE)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_015: [ If the transaction coordinator is not open, transaction_coordinator_close shall fail and return a non-zero value. ]*/
+        LogError("Transaction coordinator not opened");
+        result = __FAILURE__;
+    }
+    else
+    {
+        bool is_opening = (transaction_coordinator->state == TRANSACTION_COORDINATOR_STATE_OPENING);
+
+        transaction_coordinator->state = TRANSACTION_COORDINATOR_STATE_IDLE;
+        if (is_opening)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_016: [ If the open has not completed yet, on_open_complete shall be called with TRANSACTION_COORDINATOR_ERROR. ]*/
+            transaction_coordinator->on_open_complete(transaction_coordinator->on_open_complete_context, TRANSACTION_COORDINATOR_ERROR);
+        }
+
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_013: [ transaction_coordinator_close shall close the link by calling link_detach with close set to true. ]*/
+        if (link_detach(transaction_coordinator->link, true) != 0)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_017: [ If link_detach fails, transaction_coordinator_close shall fail and return a non-zero value. ]*/
+            LogError("Cannot detach the coordinator link");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int transaction_coordinator_declare_async(TRANSACTION_COORDINATOR_HANDLE transaction_coordinator, ON_TRANSACTION_DECLARED on_declared, void* context)
+{
+    int result;
+
+    if ((transaction_coordinator == NULL) ||
+        (on_declared == NULL))
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_023: [ If transaction_coordinator or on_declared is NULL, transaction_coordinator_declare_async shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: transaction_coordinator = %p, on_declared = %p", transaction_coordinator, on_declared);
+        result = __FAILURE__;
+    }
+    else if (transaction_coordinator->state != TRANSACTION_COORDINATOR_STATE_OPEN)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_024: [ If the transaction coordinator is not open, transaction_coordinator_declare_async shall fail and return a non-zero value. ]*/
+        LogError("Transaction coordinator not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRANSACTION_OPERATION* operation = (TRANSACTION_OPERATION*)malloc(sizeof(TRANSACTION_OPERATION));
+        if (operation == NULL)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_025: [ If allocating memory or sending fails, transaction_coordinator_declare_async shall fail and return a non-zero value. ]*/
+            LogError("Cannot allocate the declare");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_018: [ transaction_coordinator_declare_async shall send, with link_transfer_async, a message whose amqp-value body is a declare without global-id. ]*/
+            static const unsigned char declare_message[] = { 0x00, 0x53, AMQP_VALUE_SECTION_DESCRIPTOR, 0x00, 0x53, DECLARE_DESCRIPTOR, 0x45 };
+
+            operation->on_declared = on_declared;
+            operation->on_discharged = NULL;
+            operation->context = context;
+            (void)memcpy(operation->message_bytes, declare_message, sizeof(declare_message));
+
+            if (send_control_message(transaction_coordinator, operation, sizeof(declare_message)) != 0)
+            {
+                /* Codes_SRS_TRANSACTION_COORDINATOR_01_025: [ If allocating memory or sending fails, transaction_coordinator_declare_async shall fail and return a non-zero value. ]*/
+                free(operation);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int transaction_coordinator_discharge_async(TRANSACTION_COORDINATOR_HANDLE transaction_coordinator, const unsigned char* txn_id, uint32_t txn_id_length, bool fail, ON_TRANSACTION_DISCHARGED on_discharged, void* context)
+{
+    int result;
+
+    if ((transaction_coordinator == NULL) ||
+        (txn_id == NULL) ||
+        (txn_id_length == 0) ||
+        (txn_id_length > MAX_TXN_ID_LENGTH) ||
+        (on_discharged == NULL))
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_030: [ If transaction_coordinator, txn_id or on_discharged is NULL, or txn_id_length is 0 or more than 32, transaction_coordinator_discharge_async shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: transaction_coordinator = %p, txn_id = %p, txn_id_length = %u, on_discharged = %p",
+            transaction_coordinator, txn_id, (unsigned int)txn_id_length, on_discharged);
+        result = __FAILURE__;
+    }
+    else if (transaction_coordinator->state != TRANSACTION_COORDINATOR_STATE_OPEN)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_031: [ If the transaction coordinator is not open, transaction_coordinator_discharge_async shall fail and return a non-zero value. ]*/
+        LogError("Transaction coordinator not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRANSACTION_OPERATION* operation = (TRANSACTION_OPERATION*)malloc(sizeof(TRANSACTION_OPERATION));
+        if (operation == NULL)
+        {
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_032: [ If allocating memory or sending fails, transaction_coordinator_discharge_async shall fail and return a non-zero value. ]*/
+            LogError("Cannot allocate the discharge");
+            result = __FAILURE__;
+        }
+        else
+        {
+            unsigned char* bytes = operation->message_bytes;
+            size_t message_size = 0;
+
+            /* Codes_SRS_TRANSACTION_COORDINATOR_01_026: [ transaction_coordinator_discharge_async shall send, with link_transfer_async, a message whose amqp-value body is a discharge of txn_id with fail. ]*/
+            bytes[message_size++] = 0x00;
+            bytes[message_size++] = 0x53;
+            bytes[message_size++] = AMQP_VALUE_SECTION_DESCRIPTOR;
+            bytes[message_size++] = 0x00;
+            bytes[message_size++] = 0x53;
+            bytes[message_size++] = DISCHARGE_DESCRIPTOR;
+            /* list8: count, the txn-id as a vbin8 and fail */
+            bytes[message_size++] = 0xC0;
+            bytes[message_size++] = (unsigned char)(1 + 2 + txn_id_length + 1);
+            bytes[message_size++] = 2;
+            bytes[message_size++] = 0xA0;
+            bytes[message_size++] = (unsigned char)txn_id_length;
+            (void)memcpy(bytes + message_size, txn_id, txn_id_length);
+            message_size += txn_id_length;
+            bytes[message_size++] = fail ? 0x41 : 0x42;
+
+            operation->on_declared = NULL;
+            operation->on_discharged = on_discharged;
+            operation->context = context;
+
+            if (send_control_message(transaction_coordinator, operation, message_size) != 0)
+            {
+                /* Codes_SRS_TRANSACTION_COORDINATOR_01_032: [ If allocating memory or sending fails, transaction_coordinator_discharge_async shall fail and return a non-zero value. ]*/
+                free(operation);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+LINK_HANDLE transaction_coordinator_get_link(TRANSACTION_COORDINATOR_HANDLE transaction_coordinator)
+{
+    LINK_HANDLE result;
+
+    if (transaction_coordinator == NULL)
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_034: [ If transaction_coordinator is NULL, transaction_coordinator_get_link shall return NULL. ]*/
+        LogError("NULL transaction_coordinator");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_TRANSACTION_COORDINATOR_01_033: [ transaction_coordinator_get_link shall return the link to the coordinator. ]*/
+        result = transaction_coordinator->link;
+    }
+
+    return result;
+}
@@ -0,0 +1,220 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <uv.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/uamqp_libuv.h"
+
+typedef struct UAMQP_LIBUV_CONNECTION_INSTANCE_TAG
+{
+    CONNECTION_HANDLE connection;
+    int fd;
+    uv_poll_t poll;
+    uv_timer_t timer;
+    /* UV_READABLE | UV_WRITABLE currently polled for, 0 when the poll is stopped */
+    int poll_events;
+    /* handles libuv still has to call back with uv_close, the instance is freed when it gets to 0 */
+    int open_handle_count;
+    bool is_destroyed;
+} UAMQP_LIBUV_CONNECTION_INSTANCE;
+
+static void on_handle_closed(uv_handle_t* handle)
+{
+    UAMQP_LIBUV_CONNECTION_INSTANCE* libuv_connection = (UAMQP_LIBUV_CONNECTION_INSTANCE*)handle->data;
+
+    libuv_connection->open_handle_count--;
+    if (libuv_connection->open_handle_count == 0)
+    {
+        free(libuv_connection);
+    }
+}
+
+static void on_timer_expired(uv_timer_t* timer);
+static void on_poll_event(uv_poll_t* poll, int status, int events);
+
+/* makes libuv wait for what the connection asks for since its last connection_dowork */
+static void update_interest(UAMQP_LIBUV_CONNECTION_INSTANCE* libuv_connection)
+{
+    CONNECTION_IO_INTEREST io_interest;
+
+    if (connection_get_io_interest(libuv_connection->connection, &io_interest) != 0)
+    {
+        /* run again as soon as possible rather than stall the connection */
+        LogError("Cannot get the io interest of the connection");
+        io_interest.want_read = true;
+        io_interest.want_write = false;
+        io_interest.timeout_ms = 0;
+    }
+
+    if (libuv_connection->fd != -1)
+    {
+        int poll_events = (io_interest.want_read ? UV_READABLE : 0) | (io_interest.want_write ? UV_WRITABLE : 0);
+
+        if (poll_events != libuv_connection->poll_events)
+        {
+            int poll_result = (poll_events == 0) ?
+                uv_poll_stop(&libuv_connection->poll) :
+                uv_poll_start(&libuv_connection->poll, poll_events, on_poll_event);
+            if (poll_result != 0)
+            {
+                LogError("Cannot change the events polled for, error = %s", uv_strerror(poll_result));
+            }
+            else
+            {
+                libuv_connection->poll_events = poll_events;
+            }
+        }
+    }
+
+    if (io_interest.timeout_ms == (uint64_t)-1)
+    {
+        (void)uv_timer_stop(&libuv_connection->timer);
+    }
+    else if (uv_timer_start(&libuv_connection->timer, on_timer_expired, io_interest.timeout_ms, 0) != 0)
+    {
+        LogError("Cannot start the connection timer");
+    }
+}
+
+static void run_connection(UAMQP_LIBUV_CONNECTION_INSTANCE* libuv_connection)
+{
+    connection_dowork(libuv_connection->connection);
+
+    /* the callbacks of connection_dowork may have destroyed the driver, its handles are then closing */
+    if (!libuv_connection->is_destroyed)
+    {
+        update_interest(libuv_connection);
+    }
+}
+
+static void on_timer_expired(uv_timer_t* timer)
+{
+    run_connection((UAMQP_LIBUV_CONNECTION_INSTANCE*)timer->data);
+}
+
+static void on_poll_event(uv_poll_t* poll, int status, int events)
+{
+    (void)events;
+
+    if (status < 0)
+    {
+        /* the socket error is for the io to find out in connection_dowork */
+        LogError("Polling the connection socket failed, error = %s", uv_strerror(status));
+    }
+
+    run_connection((UAMQP_LIBUV_CONNECTION_INSTANCE*)poll->data);
+}
+
+UAMQP_LIBUV_CONNECTION_HANDLE uamqp_libuv_connection_create(uv_loop_t* loop, CONNECTION_HANDLE connection, int fd)
+{
+    UAMQP_LIBUV_CONNECTION_INSTANCE* result;
+
+    if ((loop == NULL) ||
+        (connection == NULL) ||
+        (fd < -1))
+    {
+        LogError("Bad arguments: loop = %p, connection = %p, fd = %d",
+            loop, connection, fd);
+        result = NULL;
+    }
+    else
+    {
+        result = (UAMQP_LIBUV_CONNECTION_INSTANCE*)malloc(sizeof(UAMQP_LIBUV_CONNECTION_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for the libuv connection");
+        }
+        else
+        {
+            int uv_result;
+
+            result->connection = connection;
+            result->fd = fd;
+            result->poll_events = 0;
+            result->open_handle_count = 0;
+            result->is_destroyed = false;
+            result->timer.data = result;
+            result->poll.data = result;
+
+            if ((uv_result = uv_timer_init(loop, &result->timer)) != 0)
+            {
+                LogError("Cannot initialize the connection timer, error = %s", uv_strerror(uv_result));
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->open_handle_count++;
+
+                if ((fd != -1) &&
+                    ((uv_result = uv_poll_init(loop, &result->poll, fd)) != 0))
+                {
+                    LogError("Cannot poll the connection socket, error = %s", uv_strerror(uv_result));
+                    uv_close((uv_handle_t*)&result->timer, on_handle_closed);
+                    result = NULL;
+                }
+                else
+                {
+                    if (fd != -1)
+                    {
+                        result->open_handle_count++;
+                    }
+
+                    /* the first connection_dowork (which opens the io) happens on the next loop iteration */
+                    if (uv_timer_start(&result->timer, on_timer_expired, 0, 0) != 0)
+                    {
+                        LogError("Cannot start the connection timer");
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void uamqp_libuv_connection_destroy(UAMQP_LIBUV_CONNECTION_HANDLE libuv_connection)
+{
+    if (libuv_connection == NULL)
+    {
+        LogError("NULL libuv_connection");
+    }
+    else if (!libuv_connection->is_destroyed)
+    {
+        /* uv_close is asynchronous, the instance has to stay until both handles are closed */
+        libuv_connection->is_destroyed = true;
+        uv_close((uv_handle_t*)&libuv_connection->timer, on_handle_closed);
+        if (libuv_connection->fd != -1)
+        {
+            uv_close((uv_handle_t*)&libuv_connection->poll, on_handle_closed);
+        }
+    }
+}
+
+int uamqp_libuv_connection_signal(UAMQP_LIBUV_CONNECTION_HANDLE libuv_connection)
+{
+    int result;
+
+    if ((libuv_connection == NULL) ||
+        libuv_connection->is_destroyed)
+    {
+        LogError("Bad arguments: libuv_connection = %p", libuv_connection);
+        result = __FAILURE__;
+    }
+    else if (uv_timer_start(&libuv_connection->timer, on_timer_expired, 0, 0) != 0)
+    {
+        LogError("Cannot start the connection timer");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
@@ -0,0 +1,713 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_uamqp_c/lock_free_stack.h"
+#include "azure_uamqp_c/timer_wheel.h"
+#include "azure_uamqp_c/uamqp_reactor.h"
+
+/* number of readiness events picked up by a single epoll_wait */
+#define MAX_EVENTS_PER_WAIT 64
+/* idle timers only need coarse granularity, the wheel covers about 10 seconds per rotation */
+#define TIMER_TICK_MS 10
+#define TIMER_SLOT_COUNT 1024
+
+typedef struct REACTOR_CONNECTION_TAG
+{
+    struct UAMQP_REACTOR_INSTANCE_TAG* reactor;
+    CONNECTION_HANDLE connection;
+    int fd;
+    TIMER_WHEEL_TIMER_HANDLE timer;
+    struct REACTOR_CONNECTION_TAG* next_ready;
+    bool is_queued;
+    bool is_removed;
+} REACTOR_CONNECTION;
+
+typedef struct POSTED_WORK_TAG
+{
+    /* first member, so that the stack entries are the posted work items */
+    LOCK_FREE_STACK_ENTRY stack_entry;
+    ON_REACTOR_WORK on_work;
+    void* on_work_context;
+} POSTED_WORK;
+
+typedef struct READY_QUEUE_TAG
+{
+    REACTOR_CONNECTION* head;
+    REACTOR_CONNECTION* tail;
+} READY_QUEUE;
+
+typedef struct UAMQP_REACTOR_INSTANCE_TAG
+{
+    int epoll_fd;
+    /* written by uamqp_reactor_post to wake up epoll_wait, registered with a NULL event pointer */
+    int wakeup_fd;
+    /* pushed by any thread, taken whole by the reactor thread */
+    LOCK_FREE_STACK posted_work;
+    TICK_COUNTER_HANDLE tick_counter;
+    TIMER_WHEEL_HANDLE timer_wheel;
+    REACTOR_CONNECTION** connections;
+    size_t connection_count;
+    /* connections with work for the next pass */
+    READY_QUEUE ready_queue;
+    /* connections being run by the current pass */
+    READY_QUEUE running_queue;
+    /* connections removed during a pass, freed once the pass is done */
+    REACTOR_CONNECTION* removed_connections;
+    bool is_running;
+} UAMQP_REACTOR_INSTANCE;
+
+static REACTOR_CONNECTION* find_reactor_connection(UAMQP_REACTOR_INSTANCE* reactor, CONNECTION_HANDLE connection, size_t* index)
+{
+    REACTOR_CONNECTION* result = NULL;
+    size_t i;
+
+    for (i = 0; i < reactor->connection_count; i++)
+    {
+        if (reactor->connections[i]->connection == connection)
+        {
+            result = reactor->connections[i];
+            if (index != NULL)
+            {
+                *index = i;
+            }
+
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void enqueue_connection(READY_QUEUE* queue, REACTOR_CONNECTION* reactor_connection)
+{
+    if (!reactor_connection->is_queued)
+    {
+        reactor_connection->next_ready = NULL;
+        if (queue->tail == NULL)
+        {
+            queue->head = reactor_connection;
+        }
+        else
+        {
+            queue->tail->next_ready = reactor_connection;
+        }
+
+        queue->tail = reactor_connection;
+        reactor_connection->is_queued = true;
+    }
+}
+
+static void unlink_from_queue(READY_QUEUE* queue, REACTOR_CONNECTION* reactor_connection)
+{
+    REACTOR_CONNECTION* previous = NULL;
+    REACTOR_CONNECTION* current = queue->head;
+
+    while ((current != NULL) &&
+        (current != reactor_connection))
+    {
+        previous = current;
+        current = current->next_ready;
+    }
+
+    if (current != NULL)
+    {
+        if (previous == NULL)
+        {
+            queue->head = current->next_ready;
+        }
+        else
+        {
+            previous->next_ready = current->next_ready;
+        }
+
+        if (queue->tail == current)
+        {
+            queue->tail = previous;
+        }
+
+        current->is_queued = false;
+    }
+}
+
+static void on_connection_timer_expired(void* context)
+{
+    REACTOR_CONNECTION* reactor_connection = (REACTOR_CONNECTION*)context;
+    enqueue_connection(&reactor_connection->reactor->ready_queue, reactor_connection);
+}
+
+static void update_deadline(UAMQP_REACTOR_INSTANCE* reactor, REACTOR_CONNECTION* reactor_connection)
+{
+    tickcounter_ms_t current_ms;
+    /* connection_handle_deadlines returns the milliseconds until the next idle timer, (uint64_t)-1 when no timer runs
+    and 0 when the connection has been closed, in which case only IO readiness or a signal will run it again */
+    uint64_t time_to_deadline = connection_handle_deadlines(reactor_connection->connection);
+
+    if ((time_to_deadline == 0) ||
+        (time_to_deadline == (uint64_t)-1))
+    {
+        (void)timer_wheel_stop_timer(reactor_connection->timer);
+    }
+    else if (tickcounter_get_current_ms(reactor->tick_counter, &current_ms) != 0)
+    {
+        LogError("Could not get tick counter value");
+
+        /* run it on the next pass rather than losing the timer */
+        enqueue_connection(&reactor->ready_queue, reactor_connection);
+    }
+    else
+    {
+        (void)timer_wheel_start_timer(reactor_connection->timer, current_ms + time_to_deadline);
+    }
+}
+
+static void run_posted_work(UAMQP_REACTOR_INSTANCE* reactor)
+{
+    /* the work runs in posting order */
+    POSTED_WORK* posted_work = (POSTED_WORK*)lock_free_stack_take_all(&reactor->posted_work);
+
+    while (posted_work != NULL)
+    {
+        POSTED_WORK* next = (POSTED_WORK*)posted_work->stack_entry.next;
+        posted_work->on_work(posted_work->on_work_context);
+        free(posted_work);
+        posted_work = next;
+    }
+}
+
+static int register_connection_fd(UAMQP_REACTOR_INSTANCE* reactor, REACTOR_CONNECTION* reactor_connection, int fd)
+{
+    int result;
+    struct epoll_event event;
+
+    /* edge triggered: the socket IO reads until it would block on each dowork, and EPOLLOUT only
+    fires when a full send buffer drains, which is when pending writes can make progress */
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = reactor_connection;
+
+    if ((fd != -1) &&
+        (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0))
+    {
+        LogError("epoll_ctl failed, errno = %d", errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void unregister_connection_fd(UAMQP_REACTOR_INSTANCE* reactor, REACTOR_CONNECTION* reactor_connection)
+{
+    if ((reactor_connection->fd != -1) &&
+        (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, reactor_connection->fd, NULL) != 0))
+    {
+        /* the socket may already have been closed by the IO, which removes it from the epoll set */
+        LogError("epoll_ctl failed, errno = %d", errno);
+    }
+}
+
+static void destroy_reactor_fds(UAMQP_REACTOR_INSTANCE* reactor)
+{
+    if (reactor->wakeup_fd != -1)
+    {
+        (void)close(reactor->wakeup_fd);
+    }
+
+    (void)close(reactor->epoll_fd);
+}
+
+UAMQP_REACTOR_HANDLE uamqp_reactor_create(void)
+{
+    UAMQP_REACTOR_INSTANCE* result = (UAMQP_REACTOR_INSTANCE*)malloc(sizeof(UAMQP_REACTOR_INSTANCE));
+    if (result == NULL)
+    {
+        LogError("Cannot allocate memory for the reactor");
+    }
+    else
+    {
+        tickcounter_ms_t current_ms;
+        struct epoll_event event;
+
+        result->wakeup_fd = -1;
+        lock_free_stack_init(&result->posted_work);
+
+        event.events = EPOLLIN;
+        event.data.ptr = NULL;
+
+        result->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (result->epoll_fd == -1)
+        {
+            LogError("epoll_create1 failed, errno = %d", errno);
+            free(result);
+            result = NULL;
+        }
+        else if (((result->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) ||
+            (epoll_ctl(result->epoll_fd, EPOLL_CTL_ADD, result->wakeup_fd, &event) != 0))
+        {
+            LogError("Cannot create the wakeup eventfd, errno = %d", errno);
+            destroy_reactor_fds(result);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->tick_counter = tickcounter_create()) == NULL)
+        {
+            LogError("Cannot create tick counter");
+            destroy_reactor_fds(result);
+            free(result);
+            result = NULL;
+        }
+        else if (tickcounter_get_current_ms(result->tick_counter, &current_ms) != 0)
+        {
+            LogError("Could not get tick counter value");
+            tickcounter_destroy(result->tick_counter);
+            destroy_reactor_fds(result);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->timer_wheel = timer_wheel_create(TIMER_TICK_MS, TIMER_SLOT_COUNT, current_ms)) == NULL)
+        {
+            LogError("Cannot create timer wheel");
+            tickcounter_destroy(result->tick_counter);
+            destroy_reactor_fds(result);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->connections = NULL;
+            result->connection_count = 0;
+            result->ready_queue.head = NULL;
+            result->ready_queue.tail = NULL;
+            result->running_queue.head = NULL;
+            result->running_queue.tail = NULL;
+            result->removed_connections = NULL;
+            result->is_running = false;
+        }
+    }
+
+    return result;
+}
+
+void uamqp_reactor_destroy(UAMQP_REACTOR_HANDLE reactor)
+{
+    if (reactor == NULL)
+    {
+        LogError("NULL reactor");
+    }
+    else
+    {
+        size_t i;
+        POSTED_WORK* posted_work = (POSTED_WORK*)lock_free_stack_take_all(&reactor->posted_work);
+
+        /* work posted after the last pass is discarded */
+        while (posted_work != NULL)
+        {
+            POSTED_WORK* next = (POSTED_WORK*)posted_work->stack_entry.next;
+            free(posted_work);
+            posted_work = next;
+        }
+
+        for (i = 0; i < reactor->connection_count; i++)
+        {
+            timer_wheel_destroy_timer(reactor->connections[i]->timer);
+            free(reactor->connections[i]);
+        }
+
+        if (reactor->connections != NULL)
+        {
+            free(reactor->connections);
+        }
+
+        timer_wheel_destroy(reactor->timer_wheel);
+        tickcounter_destroy(reactor->tick_counter);
+        destroy_reactor_fds(reactor);
+        free(reactor);
+    }
+}
+
+int uamqp_reactor_add_connection(UAMQP_REACTOR_HANDLE reactor, CONNECTION_HANDLE connection, int fd)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        (connection == NULL) ||
+        (fd < -1))
+    {
+        LogError("Bad arguments: reactor = %p, connection = %p, fd = %d",
+            reactor, connection, fd);
+        result = __FAILURE__;
+    }
+    else if (find_reactor_connection(reactor, connection, NULL) != NULL)
+    {
+        LogError("Connection already added to the reactor");
+        result = __FAILURE__;
+    }
+    else
+    {
+        REACTOR_CONNECTION** new_connections = (REACTOR_CONNECTION**)realloc(reactor->connections, sizeof(REACTOR_CONNECTION*) * (reactor->connection_count + 1));
+        if (new_connections == NULL)
+        {
+            LogError("Cannot grow the reactor connection array");
+            result = __FAILURE__;
+        }
+        else
+        {
+            REACTOR_CONNECTION* reactor_connection;
+
+            reactor->connections = new_connections;
+
+            reactor_connection = (REACTOR_CONNECTION*)malloc(sizeof(REACTOR_CONNECTION));
+            if (reactor_connection == NULL)
+            {
+                LogError("Cannot allocate memory for the reactor connection");
+                result = __FAILURE__;
+            }
+            else if ((reactor_connection->timer = timer_wheel_create_timer(reactor->timer_wheel, on_connection_timer_expired, reactor_connection)) == NULL)
+            {
+                LogError("Cannot create the connection timer");
+                free(reactor_connection);
+                result = __FAILURE__;
+            }
+            else
+            {
+                reactor_connection->reactor = reactor;
+                reactor_connection->connection = connection;
+                reactor_connection->fd = fd;
+                reactor_connection->next_ready = NULL;
+                reactor_connection->is_queued = false;
+                reactor_connection->is_removed = false;
+
+                if (register_connection_fd(reactor, reactor_connection, fd) != 0)
+                {
+                    timer_wheel_destroy_timer(reactor_connection->timer);
+                    free(reactor_connection);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    reactor->connections[reactor->connection_count] = reactor_connection;
+                    reactor->connection_count++;
+
+                    /* run the connection once so that it can start opening */
+                    enqueue_connection(&reactor->ready_queue, reactor_connection);
+
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int uamqp_reactor_remove_connection(UAMQP_REACTOR_HANDLE reactor, CONNECTION_HANDLE connection)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        (connection == NULL))
+    {
+        LogError("Bad arguments: reactor = %p, connection = %p",
+            reactor, connection);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t index;
+        REACTOR_CONNECTION* reactor_connection = find_reactor_connection(reactor, connection, &index);
+        if (reactor_connection == NULL)
+        {
+            LogError("Connection not found in the reactor");
+            result = __FAILURE__;
+        }
+        else
+        {
+            unregister_connection_fd(reactor, reactor_connection);
+
+            unlink_from_queue(&reactor->ready_queue, reactor_connection);
+            unlink_from_queue(&reactor->running_queue, reactor_connection);
+            timer_wheel_destroy_timer(reactor_connection->timer);
+
+            reactor->connection_count--;
+            reactor->connections[index] = reactor->connections[reactor->connection_count];
+
+            if (reactor->is_running)
+            {
+                /* the pass may be running this very connection, free it once the pass is done */
+                reactor_connection->is_removed = true;
+                reactor_connection->next_ready = reactor->removed_connections;
+                reactor->removed_connections = reactor_connection;
+            }
+            else
+            {
+                free(reactor_connection);
+            }
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int uamqp_reactor_set_connection_fd(UAMQP_REACTOR_HANDLE reactor, CONNECTION_HANDLE connection, int fd)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        (connection == NULL) ||
+        (fd < -1))
+    {
+        LogError("Bad arguments: reactor = %p, connection = %p, fd = %d",
+            reactor, connection, fd);
+        result = __FAILURE__;
+    }
+    else
+    {
+        REACTOR_CONNECTION* reactor_connection = find_reactor_connection(reactor, connection, NULL);
+        if (reactor_connection == NULL)
+        {
+            LogError("Connection not found in the reactor");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* the previous socket is dropped even when fd has the same number, since a closed and reopened
+            socket is a new file for epoll that the old registration does not cover */
+            unregister_connection_fd(reactor, reactor_connection);
+
+            if (register_connection_fd(reactor, reactor_connection, fd) != 0)
+            {
+                /* the connection is left driven by its timers and signals only */
+                reactor_connection->fd = -1;
+                result = __FAILURE__;
+            }
+            else
+            {
+                reactor_connection->fd = fd;
+                result = 0;
+            }
+
+            /* run the connection so that it picks up whatever the new socket already has */
+            enqueue_connection(&reactor->ready_queue, reactor_connection);
+        }
+    }
+
+    return result;
+}
+
+int uamqp_reactor_signal_connection(UAMQP_REACTOR_HANDLE reactor, CONNECTION_HANDLE connection)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        (connection == NULL))
+    {
+        LogError("Bad arguments: reactor = %p, connection = %p",
+            reactor, connection);
+        result = __FAILURE__;
+    }
+    else
+    {
+        REACTOR_CONNECTION* reactor_connection = find_reactor_connection(reactor, connection, NULL);
+        if (reactor_connection == NULL)
+        {
+            LogError("Connection not found in the reactor");
+            result = __FAILURE__;
+        }
+        else
+        {
+            enqueue_connection(&reactor->ready_queue, reactor_connection);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int uamqp_reactor_run_once(UAMQP_REACTOR_HANDLE reactor, uint32_t max_wait_ms)
+{
+    int result;
+
+    if (reactor == NULL)
+    {
+        LogError("NULL reactor");
+        result = __FAILURE__;
+    }
+    else if (reactor->is_running)
+    {
+        LogError("uamqp_reactor_run_once called from a reactor callback");
+        result = __FAILURE__;
+    }
+    else
+    {
+        tickcounter_ms_t current_ms;
+        uint64_t next_expiry_ms;
+
+        if ((tickcounter_get_current_ms(reactor->tick_counter, &current_ms) != 0) ||
+            (timer_wheel_get_next_expiry(reactor->timer_wheel, &next_expiry_ms) != 0))
+        {
+            LogError("Could not get the time of the next timer");
+            result = __FAILURE__;
+        }
+        else
+        {
+            struct epoll_event events[MAX_EVENTS_PER_WAIT];
+            uint64_t wait_ms = max_wait_ms;
+            int event_count;
+
+            /* sleep no longer than the earliest idle timer, or not at all when a connection has work */
+            if ((reactor->ready_queue.head != NULL) ||
+                !lock_free_stack_is_empty(&reactor->posted_work))
+            {
+                wait_ms = 0;
+            }
+            else if (next_expiry_ms <= current_ms)
+            {
+                wait_ms = 0;
+            }
+            else if (next_expiry_ms - current_ms < wait_ms)
+            {
+                wait_ms = next_expiry_ms - current_ms;
+            }
+
+            if (wait_ms > INT32_MAX)
+            {
+                wait_ms = INT32_MAX;
+            }
+
+            event_count = epoll_wait(reactor->epoll_fd, events, MAX_EVENTS_PER_WAIT, (int)wait_ms);
+            if ((event_count < 0) &&
+                (errno != EINTR))
+            {
+                LogError("epoll_wait failed, errno = %d", errno);
+                result = __FAILURE__;
+            }
+            else if (tickcounter_get_current_ms(reactor->tick_counter, &current_ms) != 0)
+            {
+                LogError("Could not get tick counter value");
+                result = __FAILURE__;
+            }
+            else
+            {
+                int i;
+
+                for (i = 0; i < event_count; i++)
+                {
+                    if (events[i].data.ptr == NULL)
+                    {
+                        uint64_t wakeup_count;
+
+                        /* only resets the eventfd, the posted work is taken below */
+                        if (read(reactor->wakeup_fd, &wakeup_count, sizeof(wakeup_count)) < 0)
+                        {
+                            LogError("Reading the wakeup eventfd failed, errno = %d", errno);
+                        }
+                    }
+                    else
+                    {
+                        enqueue_connection(&reactor->ready_queue, (REACTOR_CONNECTION*)events[i].data.ptr);
+                    }
+                }
+
+                /* posted work typically sends and signals its connection, so it runs before the pass is taken */
+                run_posted_work(reactor);
+
+                /* only the connections whose timers fire are touched */
+                (void)timer_wheel_advance(reactor->timer_wheel, current_ms);
+
+                /* connections signalled while this pass runs are picked up by the next one */
+                reactor->running_queue = reactor->ready_queue;
+                reactor->ready_queue.head = NULL;
+                reactor->ready_queue.tail = NULL;
+                reactor->is_running = true;
+
+                while (reactor->running_queue.head != NULL)
+                {
+                    REACTOR_CONNECTION* reactor_connection = reactor->running_queue.head;
+
+                    reactor->running_queue.head = reactor_connection->next_ready;
+                    if (reactor->running_queue.head == NULL)
+                    {
+                        reactor->running_queue.tail = NULL;
+                    }
+
+                    reactor_connection->is_queued = false;
+
+                    connection_dowork(reactor_connection->connection);
+
+                    if (!reactor_connection->is_removed)
+                    {
+                        update_deadline(reactor, reactor_connection);
+                    }
+                }
+
+                reactor->is_running = false;
+
+                while (reactor->removed_connections != NULL)
+                {
+                    REACTOR_CONNECTION* reactor_connection = reactor->removed_connections;
+                    reactor->removed_connections = reactor_connection->next_ready;
+                    free(reactor_connection);
+                }
+
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int uamqp_reactor_post(UAMQP_REACTOR_HANDLE reactor, ON_REACTOR_WORK on_work, void* on_work_context)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        (on_work == NULL))
+    {
+        LogError("Bad arguments: reactor = %p, on_work = %p",
+            reactor, on_work);
+        result = __FAILURE__;
+    }
+    else
+    {
+        POSTED_WORK* posted_work = (POSTED_WORK*)malloc(sizeof(POSTED_WORK));
+        if (posted_work == NULL)
+        {
+            LogError("Cannot allocate memory for the posted work");
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint64_t wakeup_count = 1;
+
+            posted_work->on_work = on_work;
+            posted_work->on_work_context = on_work_context;
+            lock_free_stack_push(&reactor->posted_work, &posted_work->stack_entry);
+
+            /* a full eventfd counter still leaves it readable, so a failed write does not lose the wakeup */
+            if (write(reactor->wakeup_fd, &wakeup_count, sizeof(wakeup_count)) < 0)
+            {
+                LogError("Writing the wakeup eventfd failed, errno = %d", errno);
+            }
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
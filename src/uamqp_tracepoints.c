@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/uamqp_tracepoints.h"
+
+#if defined(UAMQP_TRACEPOINTS_ETW)
+
+/* 7caa581d-0d0d-432b-93b4-a426ba3a12c0 */
+TRACELOGGING_DEFINE_PROVIDER(uamqp_trace_provider, "Microsoft.Azure.uAMQP",
+    (0x7caa581d, 0x0d0d, 0x432b, 0x93, 0xb4, 0xa4, 0x26, 0xba, 0x3a, 0x12, 0xc0));
+
+int uamqp_tracepoints_init(void)
+{
+    int result;
+
+    if (TraceLoggingRegister(uamqp_trace_provider) != ERROR_SUCCESS)
+    {
+        LogError("Cannot register the ETW trace provider");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+void uamqp_tracepoints_deinit(void)
+{
+    TraceLoggingUnregister(uamqp_trace_provider);
+}
+
+#else
+
+int uamqp_tracepoints_init(void)
+{
+    /* USDT probes need no registration */
+    return 0;
+}
+
+void uamqp_tracepoints_deinit(void)
+{
+}
+
+#endif
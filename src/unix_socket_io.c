@@ -0,0 +1,325 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_uamqp_c/unix_socket_io.h"
+
+typedef struct UNIX_SOCKET_IO_INSTANCE_TAG
+{
+    char* path;
+    /* created on each open around the connected socket, socketio closes the socket with it */
+    XIO_HANDLE socket_io;
+    bool is_open;
+} UNIX_SOCKET_IO_INSTANCE;
+
+static int connect_unix_socket(const char* path)
+{
+    int result = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (result == -1)
+    {
+        LogError("Cannot create a Unix domain socket, errno %d", errno);
+    }
+    else
+    {
+        struct sockaddr_un sun;
+        int flags;
+
+        (void)memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        (void)strcpy(sun.sun_path, path);
+
+        /* the peer is local, so the connect is not worth an asynchronous state */
+        if (connect(result, (const struct sockaddr*)&sun, sizeof(sun)) == -1)
+        {
+            LogError("Cannot connect to %s, errno %d", path, errno);
+            (void)close(result);
+            result = -1;
+        }
+        else if ((-1 == (flags = fcntl(result, F_GETFL, 0))) ||
+            (fcntl(result, F_SETFL, flags | O_NONBLOCK) == -1))
+        {
+            LogError("Failure: fcntl failure.");
+            (void)close(result);
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+static void* unix_socket_io_clone_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+    return NULL;
+}
+
+static void unix_socket_io_destroy_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+}
+
+static int unix_socket_io_setoption(CONCRETE_IO_HANDLE unix_socket_io, const char* option_name, const void* value)
+{
+    int result;
+    UNIX_SOCKET_IO_INSTANCE* unix_socket_io_instance = (UNIX_SOCKET_IO_INSTANCE*)unix_socket_io;
+
+    if ((unix_socket_io == NULL) ||
+        (option_name == NULL))
+    {
+        LogError("Bad arguments: unix_socket_io = %p, option_name = %p",
+            unix_socket_io, option_name);
+        result = __FAILURE__;
+    }
+    else if (unix_socket_io_instance->socket_io == NULL)
+    {
+        LogError("Options can only be set on an opened io");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = xio_setoption(unix_socket_io_instance->socket_io, option_name, value);
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE unix_socket_io_retrieveoptions(CONCRETE_IO_HANDLE unix_socket_io)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (unix_socket_io == NULL)
+    {
+        LogError("NULL unix_socket_io");
+        result = NULL;
+    }
+    else
+    {
+        /* there are no options to carry over */
+        result = OptionHandler_Create(unix_socket_io_clone_option, unix_socket_io_destroy_option, unix_socket_io_setoption);
+        if (result == NULL)
+        {
+            LogError("unable to OptionHandler_Create");
+        }
+    }
+
+    return result;
+}
+
+static CONCRETE_IO_HANDLE unix_socket_io_create(void* io_create_parameters)
+{
+    UNIX_SOCKET_IO_INSTANCE* result;
+    UNIX_SOCKET_IO_CONFIG* unix_socket_io_config = (UNIX_SOCKET_IO_CONFIG*)io_create_parameters;
+
+    if ((unix_socket_io_config == NULL) ||
+        (unix_socket_io_config->path == NULL) ||
+        (strlen(unix_socket_io_config->path) >= sizeof(((struct sockaddr_un*)NULL)->sun_path)))
+    {
+        LogError("Bad arguments: unix_socket_io_config = %p", unix_socket_io_config);
+        result = NULL;
+    }
+    else
+    {
+        result = (UNIX_SOCKET_IO_INSTANCE*)malloc(sizeof(UNIX_SOCKET_IO_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for the Unix domain socket io");
+        }
+        else if (mallocAndStrcpy_s(&result->path, unix_socket_io_config->path) != 0)
+        {
+            LogError("Cannot copy the socket path");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->socket_io = NULL;
+            result->is_open = false;
+        }
+    }
+
+    return result;
+}
+
+static void unix_socket_io_destroy(CONCRETE_IO_HANDLE unix_socket_io)
+{
+    if (unix_socket_io == NULL)
+    {
+        LogError("NULL unix_socket_io");
+    }
+    else
+    {
+        UNIX_SOCKET_IO_INSTANCE* unix_socket_io_instance = (UNIX_SOCKET_IO_INSTANCE*)unix_socket_io;
+
+        if (unix_socket_io_instance->socket_io != NULL)
+        {
+            if (unix_socket_io_instance->is_open)
+            {
+                (void)xio_close(unix_socket_io_instance->socket_io, NULL, NULL);
+            }
+
+            xio_destroy(unix_socket_io_instance->socket_io);
+        }
+
+        free(unix_socket_io_instance->path);
+        free(unix_socket_io_instance);
+    }
+}
+
+static int unix_socket_io_open(CONCRETE_IO_HANDLE unix_socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    UNIX_SOCKET_IO_INSTANCE* unix_socket_io_instance = (UNIX_SOCKET_IO_INSTANCE*)unix_socket_io;
+
+    if (unix_socket_io == NULL)
+    {
+        LogError("NULL unix_socket_io");
+        result = __FAILURE__;
+    }
+    else if (unix_socket_io_instance->is_open)
+    {
+        LogError("The io is already open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        int connected_socket = connect_unix_socket(unix_socket_io_instance->path);
+        if (connected_socket == -1)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            SOCKETIO_CONFIG socketio_config;
+
+            /* the socketio of a previous open has closed its socket already */
+            if (unix_socket_io_instance->socket_io != NULL)
+            {
+                xio_destroy(unix_socket_io_instance->socket_io);
+            }
+
+            socketio_config.hostname = NULL;
+            socketio_config.port = 0;
+            socketio_config.accepted_socket = &connected_socket;
+            unix_socket_io_instance->socket_io = xio_create(socketio_get_interface_description(), &socketio_config);
+            if (unix_socket_io_instance->socket_io == NULL)
+            {
+                LogError("Cannot create the socket io");
+                (void)close(connected_socket);
+                result = __FAILURE__;
+            }
+            else if (xio_open(unix_socket_io_instance->socket_io, on_io_open_complete, on_io_open_complete_context, on_bytes_received, on_bytes_received_context, on_io_error, on_io_error_context) != 0)
+            {
+                LogError("Cannot open the socket io");
+                xio_destroy(unix_socket_io_instance->socket_io);
+                unix_socket_io_instance->socket_io = NULL;
+                result = __FAILURE__;
+            }
+            else
+            {
+                unix_socket_io_instance->is_open = true;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int unix_socket_io_close(CONCRETE_IO_HANDLE unix_socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+    UNIX_SOCKET_IO_INSTANCE* unix_socket_io_instance = (UNIX_SOCKET_IO_INSTANCE*)unix_socket_io;
+
+    if (unix_socket_io == NULL)
+    {
+        LogError("NULL unix_socket_io");
+        result = __FAILURE__;
+    }
+    else if (!unix_socket_io_instance->is_open)
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the socketio is kept until the next open or the destroy, its close may complete from its own dowork */
+        unix_socket_io_instance->is_open = false;
+        result = xio_close(unix_socket_io_instance->socket_io, on_io_close_complete, callback_context);
+    }
+
+    return result;
+}
+
+static int unix_socket_io_send(CONCRETE_IO_HANDLE unix_socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    UNIX_SOCKET_IO_INSTANCE* unix_socket_io_instance = (UNIX_SOCKET_IO_INSTANCE*)unix_socket_io;
+
+    if (unix_socket_io == NULL)
+    {
+        LogError("NULL unix_socket_io");
+        result = __FAILURE__;
+    }
+    else if (!unix_socket_io_instance->is_open)
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = xio_send(unix_socket_io_instance->socket_io, buffer, size, on_send_complete, callback_context);
+    }
+
+    return result;
+}
+
+static void unix_socket_io_dowork(CONCRETE_IO_HANDLE unix_socket_io)
+{
+    if (unix_socket_io == NULL)
+    {
+        LogError("NULL unix_socket_io");
+    }
+    else
+    {
+        UNIX_SOCKET_IO_INSTANCE* unix_socket_io_instance = (UNIX_SOCKET_IO_INSTANCE*)unix_socket_io;
+
+        if (unix_socket_io_instance->socket_io != NULL)
+        {
+            xio_dowork(unix_socket_io_instance->socket_io);
+        }
+    }
+}
+
+static const IO_INTERFACE_DESCRIPTION unix_socket_io_interface_description =
+{
+    unix_socket_io_retrieveoptions,
+    unix_socket_io_create,
+    unix_socket_io_destroy,
+    unix_socket_io_open,
+    unix_socket_io_close,
+    unix_socket_io_send,
+    unix_socket_io_dowork,
+    unix_socket_io_setoption
+};
+
+const IO_INTERFACE_DESCRIPTION* unix_socket_io_get_interface_description(void)
+{
+    return &unix_socket_io_interface_description;
+}
@@ -0,0 +1,956 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_uamqp_c/uringio.h"
+
+/* a connect, a receive, a send and their cancellations is all a ring ever holds */
+#define URINGIO_RING_ENTRIES 8
+/* pending sends gathered into one sendmsg at most */
+#define URINGIO_MAX_SEND_IOVECS 64
+
+/* the operation a completion belongs to, kept in user_data */
+#define URINGIO_OP_CONNECT 1
+#define URINGIO_OP_RECEIVE 2
+#define URINGIO_OP_SEND 3
+#define URINGIO_OP_CANCEL 4
+
+typedef enum IO_STATE_TAG
+{
+    IO_STATE_NOT_OPEN,
+    IO_STATE_OPENING,
+    IO_STATE_OPEN,
+    IO_STATE_CLOSING,
+    IO_STATE_ERROR
+} IO_STATE;
+
+typedef struct PENDING_SEND_TAG
+{
+    struct PENDING_SEND_TAG* next;
+    size_t size;
+    size_t sent;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    /* the bytes follow in the same allocation */
+} PENDING_SEND;
+
+typedef struct URING_TAG
+{
+    int ring_fd;
+    unsigned int sq_entries;
+    unsigned int* sq_head;
+    unsigned int* sq_tail;
+    unsigned int* sq_ring_mask;
+    unsigned int* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned int* cq_head;
+    unsigned int* cq_tail;
+    unsigned int* cq_ring_mask;
+    struct io_uring_cqe* cqes;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    /* tail of the entries prepared and not handed to the kernel yet */
+    unsigned int local_sq_tail;
+} URING;
+
+typedef struct URINGIO_INSTANCE_TAG
+{
+    char* hostname;
+    int port;
+    int socket;
+    IO_STATE io_state;
+    URING ring;
+    unsigned char* receive_buffer;
+    size_t receive_buffer_size;
+    struct sockaddr_storage address;
+    socklen_t address_length;
+    bool is_connect_in_flight;
+    bool is_receive_in_flight;
+    bool is_send_in_flight;
+    /* the sendmsg arguments have to stay put until its completion */
+    struct msghdr send_msghdr;
+    struct iovec send_iovecs[URINGIO_MAX_SEND_IOVECS];
+    PENDING_SEND* pending_sends_head;
+    PENDING_SEND* pending_sends_tail;
+    ON_BYTES_RECEIVED on_bytes_received;
+    ON_IO_ERROR on_io_error;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_bytes_received_context;
+    void* on_io_error_context;
+    void* on_io_open_complete_context;
+} URINGIO_INSTANCE;
+
+static int uring_init(URING* ring)
+{
+    int result;
+    struct io_uring_params params;
+
+    (void)memset(&params, 0, sizeof(params));
+    ring->ring_fd = (int)syscall(__NR_io_uring_setup, URINGIO_RING_ENTRIES, &params);
+    if (ring->ring_fd < 0)
+    {
+        LogError("io_uring_setup failed, errno=%d", errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        ring->sq_entries = params.sq_entries;
+        ring->sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+        ring->cq_ring_size = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+        ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+        {
+            /* both rings share one mapping */
+            if (ring->cq_ring_size > ring->sq_ring_size)
+            {
+                ring->sq_ring_size = ring->cq_ring_size;
+            }
+            ring->cq_ring_size = ring->sq_ring_size;
+        }
+
+        ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+        if (ring->sq_ring == MAP_FAILED)
+        {
+            LogError("Cannot map the submission ring, errno=%d", errno);
+            (void)close(ring->ring_fd);
+            result = __FAILURE__;
+        }
+        else
+        {
+            if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+            {
+                ring->cq_ring = ring->sq_ring;
+            }
+            else
+            {
+                ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING);
+            }
+
+            if (ring->cq_ring == MAP_FAILED)
+            {
+                LogError("Cannot map the completion ring, errno=%d", errno);
+                (void)munmap(ring->sq_ring, ring->sq_ring_size);
+                (void)close(ring->ring_fd);
+                result = __FAILURE__;
+            }
+            else
+            {
+                ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES);
+                if (ring->sqes == MAP_FAILED)
+                {
+                    LogError("Cannot map the submission entries, errno=%d", errno);
+                    if (ring->cq_ring != ring->sq_ring)
+                    {
+                        (void)munmap(ring->cq_ring, ring->cq_ring_size);
+                    }
+                    (void)munmap(ring->sq_ring, ring->sq_ring_size);
+                    (void)close(ring->ring_fd);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    unsigned char* sq_ring = (unsigned char*)ring->sq_ring;
+                    unsigned char* cq_ring = (unsigned char*)ring->cq_ring;
+
+                    ring->sq_head = (unsigned int*)(sq_ring + params.sq_off.head);
+                    ring->sq_tail = (unsigned int*)(sq_ring + params.sq_off.tail);
+                    ring->sq_ring_mask = (unsigned int*)(sq_ring + params.sq_off.ring_mask);
+                    ring->sq_array = (unsigned int*)(sq_ring + params.sq_off.array);
+                    ring->cq_head = (unsigned int*)(cq_ring + params.cq_off.head);
+                    ring->cq_tail = (unsigned int*)(cq_ring + params.cq_off.tail);
+                    ring->cq_ring_mask = (unsigned int*)(cq_ring + params.cq_off.ring_mask);
+                    ring->cqes = (struct io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+                    ring->local_sq_tail = *ring->sq_tail;
+
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void uring_deinit(URING* ring)
+{
+    (void)munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != ring->sq_ring)
+    {
+        (void)munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    (void)munmap(ring->sq_ring, ring->sq_ring_size);
+    (void)close(ring->ring_fd);
+}
+
+static struct io_uring_sqe* uring_get_sqe(URING* ring, uint64_t user_data)
+{
+    struct io_uring_sqe* result;
+    unsigned int head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (ring->local_sq_tail - head >= ring->sq_entries)
+    {
+        LogError("The submission ring is full");
+        result = NULL;
+    }
+    else
+    {
+        unsigned int index = ring->local_sq_tail & *ring->sq_ring_mask;
+
+        result = &ring->sqes[index];
+        (void)memset(result, 0, sizeof(struct io_uring_sqe));
+        result->user_data = user_data;
+        ring->sq_array[index] = index;
+        ring->local_sq_tail++;
+    }
+
+    return result;
+}
+
+/* hands the prepared entries to the kernel and waits for min_complete completions, one system call for all of them */
+static int uring_submit(URING* ring, unsigned int min_complete)
+{
+    int result;
+    unsigned int to_submit = ring->local_sq_tail - *ring->sq_tail;
+
+    __atomic_store_n(ring->sq_tail, ring->local_sq_tail, __ATOMIC_RELEASE);
+    if ((to_submit == 0) && (min_complete == 0))
+    {
+        /* completions are read from the shared ring, nothing to enter for */
+        result = 0;
+    }
+    else if (syscall(__NR_io_uring_enter, ring->ring_fd, to_submit, min_complete, (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0) < 0)
+    {
+        if (errno == EINTR)
+        {
+            result = 0;
+        }
+        else
+        {
+            LogError("io_uring_enter failed, errno=%d", errno);
+            result = __FAILURE__;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void indicate_error(URINGIO_INSTANCE* uring_io)
+{
+    uring_io->io_state = IO_STATE_ERROR;
+    if (uring_io->on_io_error != NULL)
+    {
+        uring_io->on_io_error(uring_io->on_io_error_context);
+    }
+}
+
+static void indicate_open_complete(URINGIO_INSTANCE* uring_io, IO_OPEN_RESULT open_result)
+{
+    if (uring_io->on_io_open_complete != NULL)
+    {
+        uring_io->on_io_open_complete(uring_io->on_io_open_complete_context, open_result);
+    }
+}
+
+static void complete_sent_bytes(URINGIO_INSTANCE* uring_io, size_t sent_bytes)
+{
+    /* the list is looked at again after each callback, which may have queued more sends or closed the io */
+    while ((sent_bytes > 0) &&
+        (uring_io->pending_sends_head != NULL))
+    {
+        PENDING_SEND* pending_send = uring_io->pending_sends_head;
+        size_t remaining = pending_send->size - pending_send->sent;
+
+        if (sent_bytes < remaining)
+        {
+            pending_send->sent += sent_bytes;
+            sent_bytes = 0;
+        }
+        else
+        {
+            sent_bytes -= remaining;
+            uring_io->pending_sends_head = pending_send->next;
+            if (uring_io->pending_sends_head == NULL)
+            {
+                uring_io->pending_sends_tail = NULL;
+            }
+
+            if (pending_send->on_send_complete != NULL)
+            {
+                pending_send->on_send_complete(pending_send->callback_context, IO_SEND_OK);
+            }
+
+            free(pending_send);
+        }
+    }
+}
+
+static void cancel_pending_sends(URINGIO_INSTANCE* uring_io)
+{
+    while (uring_io->pending_sends_head != NULL)
+    {
+        PENDING_SEND* pending_send = uring_io->pending_sends_head;
+        uring_io->pending_sends_head = pending_send->next;
+        if (uring_io->pending_sends_head == NULL)
+        {
+            uring_io->pending_sends_tail = NULL;
+        }
+
+        if (pending_send->on_send_complete != NULL)
+        {
+            pending_send->on_send_complete(pending_send->callback_context, IO_SEND_CANCELLED);
+        }
+
+        free(pending_send);
+    }
+}
+
+static void on_connect_complete(URINGIO_INSTANCE* uring_io, int res)
+{
+    uring_io->is_connect_in_flight = false;
+    if (uring_io->io_state == IO_STATE_OPENING)
+    {
+        if (res < 0)
+        {
+            LogError("Cannot connect to %s:%d, error=%d", uring_io->hostname, uring_io->port, -res);
+            (void)close(uring_io->socket);
+            uring_io->socket = -1;
+            uring_io->io_state = IO_STATE_NOT_OPEN;
+            indicate_open_complete(uring_io, IO_OPEN_ERROR);
+        }
+        else
+        {
+            uring_io->io_state = IO_STATE_OPEN;
+            indicate_open_complete(uring_io, IO_OPEN_OK);
+        }
+    }
+}
+
+static void on_receive_complete(URINGIO_INSTANCE* uring_io, int res)
+{
+    uring_io->is_receive_in_flight = false;
+    if (uring_io->io_state == IO_STATE_OPEN)
+    {
+        if (res > 0)
+        {
+            /* straight from the registered buffer, the frame codec copies what it keeps */
+            uring_io->on_bytes_received(uring_io->on_bytes_received_context, uring_io->receive_buffer, (size_t)res);
+        }
+        else if (res == 0)
+        {
+            LogError("The connection was closed by the peer");
+            indicate_error(uring_io);
+        }
+        else if ((res == -EAGAIN) || (res == -EINTR))
+        {
+            /* submitted again by the next dowork */
+        }
+        else
+        {
+            LogError("Receive failed, error=%d", -res);
+            indicate_error(uring_io);
+        }
+    }
+}
+
+static void on_send_complete(URINGIO_INSTANCE* uring_io, int res)
+{
+    uring_io->is_send_in_flight = false;
+    if (uring_io->io_state == IO_STATE_OPEN)
+    {
+        if (res >= 0)
+        {
+            complete_sent_bytes(uring_io, (size_t)res);
+        }
+        else if ((res == -EAGAIN) || (res == -EINTR))
+        {
+            /* the same bytes go again with the next dowork */
+        }
+        else
+        {
+            LogError("Send failed, error=%d", -res);
+            indicate_error(uring_io);
+        }
+    }
+}
+
+static void reap_completions(URINGIO_INSTANCE* uring_io)
+{
+    URING* ring = &uring_io->ring;
+    unsigned int head = *ring->cq_head;
+
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_ring_mask];
+        uint64_t user_data = cqe->user_data;
+        int res = cqe->res;
+
+        /* the entry is given back before its callback runs, so that a nested reap (close from a callback) does not see it twice */
+        head++;
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+        switch (user_data)
+        {
+        default:
+        case URINGIO_OP_CANCEL:
+            break;
+        case URINGIO_OP_CONNECT:
+            on_connect_complete(uring_io, res);
+            break;
+        case URINGIO_OP_RECEIVE:
+            on_receive_complete(uring_io, res);
+            break;
+        case URINGIO_OP_SEND:
+            on_send_complete(uring_io, res);
+            break;
+        }
+
+        head = *ring->cq_head;
+    }
+}
+
+static int prepare_receive(URINGIO_INSTANCE* uring_io)
+{
+    int result;
+    struct io_uring_sqe* sqe = uring_get_sqe(&uring_io->ring, URINGIO_OP_RECEIVE);
+
+    if (sqe == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = uring_io->socket;
+        sqe->addr = (uint64_t)(uintptr_t)uring_io->receive_buffer;
+        sqe->len = (uint32_t)uring_io->receive_buffer_size;
+        /* the one buffer registered at create */
+        sqe->buf_index = 0;
+        uring_io->is_receive_in_flight = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int prepare_send(URINGIO_INSTANCE* uring_io)
+{
+    int result;
+    struct io_uring_sqe* sqe = uring_get_sqe(&uring_io->ring, URINGIO_OP_SEND);
+
+    if (sqe == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        PENDING_SEND* pending_send = uring_io->pending_sends_head;
+        size_t iovec_count = 0;
+
+        /* everything queued since the last dowork (the encoded frames of the connection) goes as one sendmsg */
+        while ((pending_send != NULL) &&
+            (iovec_count < URINGIO_MAX_SEND_IOVECS))
+        {
+            uring_io->send_iovecs[iovec_count].iov_base = (unsigned char*)(pending_send + 1) + pending_send->sent;
+            uring_io->send_iovecs[iovec_count].iov_len = pending_send->size - pending_send->sent;
+            iovec_count++;
+            pending_send = pending_send->next;
+        }
+
+        (void)memset(&uring_io->send_msghdr, 0, sizeof(uring_io->send_msghdr));
+        uring_io->send_msghdr.msg_iov = uring_io->send_iovecs;
+        uring_io->send_msghdr.msg_iovlen = iovec_count;
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = uring_io->socket;
+        sqe->addr = (uint64_t)(uintptr_t)&uring_io->send_msghdr;
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        uring_io->is_send_in_flight = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void close_socket(URINGIO_INSTANCE* uring_io)
+{
+    static const uint64_t in_flight_ops[] = { URINGIO_OP_CONNECT, URINGIO_OP_RECEIVE, URINGIO_OP_SEND };
+    bool* in_flight[3];
+    size_t i;
+
+    in_flight[0] = &uring_io->is_connect_in_flight;
+    in_flight[1] = &uring_io->is_receive_in_flight;
+    in_flight[2] = &uring_io->is_send_in_flight;
+
+    uring_io->io_state = IO_STATE_CLOSING;
+
+    /* the kernel may still write into the receive buffer and read the send iovecs, so every operation is cancelled and waited for */
+    for (i = 0; i < sizeof(in_flight_ops) / sizeof(in_flight_ops[0]); i++)
+    {
+        if (*in_flight[i])
+        {
+            struct io_uring_sqe* sqe = uring_get_sqe(&uring_io->ring, URINGIO_OP_CANCEL);
+            if (sqe != NULL)
+            {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->addr = in_flight_ops[i];
+            }
+        }
+    }
+
+    (void)shutdown(uring_io->socket, SHUT_RDWR);
+
+    while (uring_io->is_connect_in_flight ||
+        uring_io->is_receive_in_flight ||
+        uring_io->is_send_in_flight)
+    {
+        if (uring_submit(&uring_io->ring, 1) != 0)
+        {
+            LogError("Cannot wait for the operations in flight");
+            break;
+        }
+
+        reap_completions(uring_io);
+    }
+
+    (void)close(uring_io->socket);
+    uring_io->socket = -1;
+    uring_io->io_state = IO_STATE_NOT_OPEN;
+}
+
+static void* uringio_clone_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+    return NULL;
+}
+
+static void uringio_destroy_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+}
+
+static int uringio_setoption(CONCRETE_IO_HANDLE uring_io, const char* option_name, const void* value)
+{
+    (void)value;
+
+    if ((uring_io == NULL) ||
+        (option_name == NULL))
+    {
+        LogError("Bad arguments: uring_io = %p, option_name = %p",
+            uring_io, option_name);
+    }
+    else
+    {
+        LogError("Unknown option: %s", option_name);
+    }
+
+    return __FAILURE__;
+}
+
+static OPTIONHANDLER_HANDLE uringio_retrieveoptions(CONCRETE_IO_HANDLE uring_io)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (uring_io == NULL)
+    {
+        LogError("NULL uring_io");
+        result = NULL;
+    }
+    else
+    {
+        /* there are no options to carry over */
+        result = OptionHandler_Create(uringio_clone_option, uringio_destroy_option, uringio_setoption);
+        if (result == NULL)
+        {
+            LogError("unable to OptionHandler_Create");
+        }
+    }
+
+    return result;
+}
+
+static CONCRETE_IO_HANDLE uringio_create(void* io_create_parameters)
+{
+    URINGIO_INSTANCE* result;
+    URINGIO_CONFIG* uring_io_config = (URINGIO_CONFIG*)io_create_parameters;
+
+    if ((uring_io_config == NULL) ||
+        (uring_io_config->hostname == NULL))
+    {
+        LogError("Bad arguments: uring_io_config = %p", uring_io_config);
+        result = NULL;
+    }
+    else
+    {
+        result = (URINGIO_INSTANCE*)malloc(sizeof(URINGIO_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for the io_uring io");
+        }
+        else
+        {
+            (void)memset(result, 0, sizeof(URINGIO_INSTANCE));
+            result->receive_buffer_size = (uring_io_config->receive_buffer_size == 0) ? URINGIO_DEFAULT_RECEIVE_BUFFER_SIZE : uring_io_config->receive_buffer_size;
+
+            if (mallocAndStrcpy_s(&result->hostname, uring_io_config->hostname) != 0)
+            {
+                LogError("Cannot copy the hostname");
+                free(result);
+                result = NULL;
+            }
+            else if ((result->receive_buffer = (unsigned char*)malloc(result->receive_buffer_size)) == NULL)
+            {
+                LogError("Cannot allocate the receive buffer");
+                free(result->hostname);
+                free(result);
+                result = NULL;
+            }
+            else if (uring_init(&result->ring) != 0)
+            {
+                LogError("Cannot set up the io_uring");
+                free(result->receive_buffer);
+                free(result->hostname);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                struct iovec receive_iovec;
+
+                /* registered once, the kernel keeps it pinned and mapped instead of looking it up on every receive */
+                receive_iovec.iov_base = result->receive_buffer;
+                receive_iovec.iov_len = result->receive_buffer_size;
+                if (syscall(__NR_io_uring_register, result->ring.ring_fd, IORING_REGISTER_BUFFERS, &receive_iovec, 1) < 0)
+                {
+                    LogError("Cannot register the receive buffer, errno=%d", errno);
+                    uring_deinit(&result->ring);
+                    free(result->receive_buffer);
+                    free(result->hostname);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->port = uring_io_config->port;
+                    result->socket = -1;
+                    result->io_state = IO_STATE_NOT_OPEN;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void uringio_destroy(CONCRETE_IO_HANDLE uring_io)
+{
+    if (uring_io == NULL)
+    {
+        LogError("NULL uring_io");
+    }
+    else
+    {
+        URINGIO_INSTANCE* uring_io_instance = (URINGIO_INSTANCE*)uring_io;
+
+        if (uring_io_instance->socket != -1)
+        {
+            close_socket(uring_io_instance);
+        }
+
+        cancel_pending_sends(uring_io_instance);
+        uring_deinit(&uring_io_instance->ring);
+        free(uring_io_instance->receive_buffer);
+        free(uring_io_instance->hostname);
+        free(uring_io_instance);
+    }
+}
+
+static int uringio_open(CONCRETE_IO_HANDLE uring_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    URINGIO_INSTANCE* uring_io_instance = (URINGIO_INSTANCE*)uring_io;
+
+    if ((uring_io == NULL) ||
+        (on_bytes_received == NULL) ||
+        (on_io_error == NULL))
+    {
+        LogError("Bad arguments: uring_io = %p, on_bytes_received = %p, on_io_error = %p",
+            uring_io, on_bytes_received, on_io_error);
+        result = __FAILURE__;
+    }
+    else if (uring_io_instance->io_state != IO_STATE_NOT_OPEN)
+    {
+        LogError("The io is already open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        struct addrinfo hints;
+        struct addrinfo* address_info;
+        char port_string[16];
+
+        (void)memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        (void)snprintf(port_string, sizeof(port_string), "%d", uring_io_instance->port);
+
+        /* resolving is as synchronous as in socketio, only the connect goes through the ring */
+        if (getaddrinfo(uring_io_instance->hostname, port_string, &hints, &address_info) != 0)
+        {
+            LogError("Cannot resolve %s", uring_io_instance->hostname);
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (address_info->ai_addrlen > sizeof(uring_io_instance->address))
+            {
+                LogError("Unexpected address length %u", (unsigned int)address_info->ai_addrlen);
+                result = __FAILURE__;
+            }
+            else if ((uring_io_instance->socket = socket(address_info->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+            {
+                LogError("Cannot create a socket, errno=%d", errno);
+                uring_io_instance->socket = -1;
+                result = __FAILURE__;
+            }
+            else
+            {
+                struct io_uring_sqe* sqe;
+                int no_delay = 1;
+
+                /* the connection coalesces frames itself */
+                (void)setsockopt(uring_io_instance->socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+                (void)memcpy(&uring_io_instance->address, address_info->ai_addr, address_info->ai_addrlen);
+                uring_io_instance->address_length = address_info->ai_addrlen;
+
+                sqe = uring_get_sqe(&uring_io_instance->ring, URINGIO_OP_CONNECT);
+                if (sqe == NULL)
+                {
+                    LogError("Cannot queue the connect");
+                    (void)close(uring_io_instance->socket);
+                    uring_io_instance->socket = -1;
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    sqe->opcode = IORING_OP_CONNECT;
+                    sqe->fd = uring_io_instance->socket;
+                    sqe->addr = (uint64_t)(uintptr_t)&uring_io_instance->address;
+                    sqe->off = uring_io_instance->address_length;
+
+                    uring_io_instance->on_io_open_complete = on_io_open_complete;
+                    uring_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+                    uring_io_instance->on_bytes_received = on_bytes_received;
+                    uring_io_instance->on_bytes_received_context = on_bytes_received_context;
+                    uring_io_instance->on_io_error = on_io_error;
+                    uring_io_instance->on_io_error_context = on_io_error_context;
+                    uring_io_instance->is_connect_in_flight = true;
+                    uring_io_instance->io_state = IO_STATE_OPENING;
+
+                    if (uring_submit(&uring_io_instance->ring, 0) != 0)
+                    {
+                        LogError("Cannot submit the connect");
+                        uring_io_instance->is_connect_in_flight = false;
+                        uring_io_instance->io_state = IO_STATE_NOT_OPEN;
+                        (void)close(uring_io_instance->socket);
+                        uring_io_instance->socket = -1;
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+            }
+
+            freeaddrinfo(address_info);
+        }
+    }
+
+    return result;
+}
+
+static int uringio_close(CONCRETE_IO_HANDLE uring_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+    URINGIO_INSTANCE* uring_io_instance = (URINGIO_INSTANCE*)uring_io;
+
+    if (uring_io == NULL)
+    {
+        LogError("NULL uring_io");
+        result = __FAILURE__;
+    }
+    else if ((uring_io_instance->io_state == IO_STATE_NOT_OPEN) ||
+        (uring_io_instance->io_state == IO_STATE_CLOSING))
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        IO_STATE previous_state = uring_io_instance->io_state;
+
+        close_socket(uring_io_instance);
+        if (previous_state == IO_STATE_OPENING)
+        {
+            indicate_open_complete(uring_io_instance, IO_OPEN_CANCELLED);
+        }
+
+        cancel_pending_sends(uring_io_instance);
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int uringio_send(CONCRETE_IO_HANDLE uring_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    URINGIO_INSTANCE* uring_io_instance = (URINGIO_INSTANCE*)uring_io;
+
+    if ((uring_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        LogError("Bad arguments: uring_io = %p, buffer = %p, size = %u",
+            uring_io, buffer, (unsigned int)size);
+        result = __FAILURE__;
+    }
+    else if (uring_io_instance->io_state != IO_STATE_OPEN)
+    {
+        LogError("The io is not open");
+        result = __FAILURE__;
+    }
+    else
+    {
+        PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + size);
+        if (pending_send == NULL)
+        {
+            LogError("Cannot allocate memory for the send");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* only queued, the next dowork submits it with whatever else was queued meanwhile */
+            (void)memcpy(pending_send + 1, buffer, size);
+            pending_send->next = NULL;
+            pending_send->size = size;
+            pending_send->sent = 0;
+            pending_send->on_send_complete = on_send_complete;
+            pending_send->callback_context = callback_context;
+
+            if (uring_io_instance->pending_sends_tail == NULL)
+            {
+                uring_io_instance->pending_sends_head = pending_send;
+            }
+            else
+            {
+                uring_io_instance->pending_sends_tail->next = pending_send;
+            }
+            uring_io_instance->pending_sends_tail = pending_send;
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void uringio_dowork(CONCRETE_IO_HANDLE uring_io)
+{
+    if (uring_io == NULL)
+    {
+        LogError("NULL uring_io");
+    }
+    else
+    {
+        URINGIO_INSTANCE* uring_io_instance = (URINGIO_INSTANCE*)uring_io;
+
+        if (uring_io_instance->io_state != IO_STATE_NOT_OPEN)
+        {
+            bool is_error = false;
+
+            if (uring_io_instance->io_state == IO_STATE_OPEN)
+            {
+                if ((!uring_io_instance->is_receive_in_flight) &&
+                    (prepare_receive(uring_io_instance) != 0))
+                {
+                    is_error = true;
+                }
+                else if ((!uring_io_instance->is_send_in_flight) &&
+                    (uring_io_instance->pending_sends_head != NULL) &&
+                    (prepare_send(uring_io_instance) != 0))
+                {
+                    is_error = true;
+                }
+            }
+
+            /* the receive and the send of this dowork go to the kernel together, completions are read without a system call */
+            if (is_error ||
+                (uring_submit(&uring_io_instance->ring, 0) != 0))
+            {
+                LogError("Cannot submit to the io_uring");
+                indicate_error(uring_io_instance);
+            }
+            else
+            {
+                reap_completions(uring_io_instance);
+            }
+        }
+    }
+}
+
+static const IO_INTERFACE_DESCRIPTION uringio_interface_description =
+{
+    uringio_retrieveoptions,
+    uringio_create,
+    uringio_destroy,
+    uringio_open,
+    uringio_close,
+    uringio_send,
+    uringio_dowork,
+    uringio_setoption
+};
+
+const IO_INTERFACE_DESCRIPTION* uringio_get_interface_description(void)
+{
+    return &uringio_interface_description;
+}
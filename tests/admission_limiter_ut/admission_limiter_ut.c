@@ -0,0 +1,368 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/admission_limiter.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static TICK_COUNTER_HANDLE test_tick_counter = (TICK_COUNTER_HANDLE)0x4200;
+static tickcounter_ms_t test_current_ms;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = test_current_ms;
+    return 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(admission_limiter_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, test_tick_counter);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    test_current_ms = 1000;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* admission_limiter_create */
+
+/* Tests_SRS_ADMISSION_LIMITER_01_001: [ `admission_limiter_create` shall create a limiter holding `burst` tokens and a tick counter obtained by calling `tickcounter_create`, read the current time with `tickcounter_get_current_ms` and on success return a non-NULL handle to it. ]*/
+TEST_FUNCTION(admission_limiter_create_returns_a_valid_handle)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    admission_limiter = admission_limiter_create(10, 5);
+
+    // assert
+    ASSERT_IS_NOT_NULL(admission_limiter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    admission_limiter_destroy(admission_limiter);
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_002: [ If `rate_per_second` or `burst` is 0, `admission_limiter_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(admission_limiter_create_with_0_rate_per_second_fails)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter;
+
+    // act
+    admission_limiter = admission_limiter_create(0, 5);
+
+    // assert
+    ASSERT_IS_NULL(admission_limiter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_002: [ If `rate_per_second` or `burst` is 0, `admission_limiter_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(admission_limiter_create_with_0_burst_fails)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter;
+
+    // act
+    admission_limiter = admission_limiter_create(10, 0);
+
+    // assert
+    ASSERT_IS_NULL(admission_limiter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_003: [ If allocating memory, `tickcounter_create` or `tickcounter_get_current_ms` fails, `admission_limiter_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_admission_limiter_create_fails)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    admission_limiter = admission_limiter_create(10, 5);
+
+    // assert
+    ASSERT_IS_NULL(admission_limiter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_003: [ If allocating memory, `tickcounter_create` or `tickcounter_get_current_ms` fails, `admission_limiter_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_tickcounter_create_fails_admission_limiter_create_fails)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    admission_limiter = admission_limiter_create(10, 5);
+
+    // assert
+    ASSERT_IS_NULL(admission_limiter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_003: [ If allocating memory, `tickcounter_create` or `tickcounter_get_current_ms` fails, `admission_limiter_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_admission_limiter_create_fails)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(tickcounter_destroy(test_tick_counter));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    admission_limiter = admission_limiter_create(10, 5);
+
+    // assert
+    ASSERT_IS_NULL(admission_limiter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* admission_limiter_destroy */
+
+/* Tests_SRS_ADMISSION_LIMITER_01_004: [ `admission_limiter_destroy` shall destroy the tick counter and free all resources associated with `admission_limiter`. ]*/
+TEST_FUNCTION(admission_limiter_destroy_frees_the_resources)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter = admission_limiter_create(10, 5);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_destroy(test_tick_counter));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    admission_limiter_destroy(admission_limiter);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_005: [ If `admission_limiter` is NULL, `admission_limiter_destroy` shall do nothing. ]*/
+TEST_FUNCTION(admission_limiter_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    admission_limiter_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* admission_limiter_try_acquire */
+
+/* Tests_SRS_ADMISSION_LIMITER_01_006: [ If `admission_limiter` is NULL, `admission_limiter_try_acquire` shall return false. ]*/
+TEST_FUNCTION(admission_limiter_try_acquire_with_NULL_returns_false)
+{
+    // arrange
+    bool result;
+
+    // act
+    result = admission_limiter_try_acquire(NULL);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_007: [ When at least one token is available, `admission_limiter_try_acquire` shall take one token and return true. ]*/
+/* Tests_SRS_ADMISSION_LIMITER_01_008: [ If less than one token is available, `admission_limiter_try_acquire` shall return false. ]*/
+TEST_FUNCTION(admission_limiter_try_acquire_admits_a_burst_and_refuses_past_it)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter = admission_limiter_create(10, 3);
+    bool result_1;
+    bool result_2;
+    bool result_3;
+    bool result_4;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    result_1 = admission_limiter_try_acquire(admission_limiter);
+    result_2 = admission_limiter_try_acquire(admission_limiter);
+    result_3 = admission_limiter_try_acquire(admission_limiter);
+    result_4 = admission_limiter_try_acquire(admission_limiter);
+
+    // assert
+    ASSERT_IS_TRUE(result_1);
+    ASSERT_IS_TRUE(result_2);
+    ASSERT_IS_TRUE(result_3);
+    ASSERT_IS_FALSE(result_4);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    admission_limiter_destroy(admission_limiter);
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_009: [ Before taking a token, `admission_limiter_try_acquire` shall add `rate_per_second` tokens for each second elapsed since the last refill (proportionally for a fraction of a second), without exceeding `burst` tokens. ]*/
+TEST_FUNCTION(admission_limiter_try_acquire_refills_proportionally_to_the_elapsed_time)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter = admission_limiter_create(10, 1);
+    bool result_before;
+    bool result_after;
+    (void)admission_limiter_try_acquire(admission_limiter);
+    umock_c_reset_all_calls();
+
+    // act
+    test_current_ms += 50;
+    result_before = admission_limiter_try_acquire(admission_limiter);
+    test_current_ms += 50;
+    result_after = admission_limiter_try_acquire(admission_limiter);
+
+    // assert
+    ASSERT_IS_FALSE(result_before);
+    ASSERT_IS_TRUE(result_after);
+
+    // cleanup
+    admission_limiter_destroy(admission_limiter);
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_009: [ Before taking a token, `admission_limiter_try_acquire` shall add `rate_per_second` tokens for each second elapsed since the last refill (proportionally for a fraction of a second), without exceeding `burst` tokens. ]*/
+TEST_FUNCTION(admission_limiter_try_acquire_does_not_refill_past_burst)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter = admission_limiter_create(10, 2);
+    bool result_1;
+    bool result_2;
+    bool result_3;
+    umock_c_reset_all_calls();
+
+    // act
+    test_current_ms += 3600000;
+    result_1 = admission_limiter_try_acquire(admission_limiter);
+    result_2 = admission_limiter_try_acquire(admission_limiter);
+    result_3 = admission_limiter_try_acquire(admission_limiter);
+
+    // assert
+    ASSERT_IS_TRUE(result_1);
+    ASSERT_IS_TRUE(result_2);
+    ASSERT_IS_FALSE(result_3);
+
+    // cleanup
+    admission_limiter_destroy(admission_limiter);
+}
+
+/* Tests_SRS_ADMISSION_LIMITER_01_010: [ If `tickcounter_get_current_ms` fails, `admission_limiter_try_acquire` shall use the tokens available without refilling them. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_admission_limiter_try_acquire_does_not_refill)
+{
+    // arrange
+    ADMISSION_LIMITER_HANDLE admission_limiter = admission_limiter_create(10, 1);
+    bool result_1;
+    bool result_2;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    test_current_ms += 1000;
+    result_1 = admission_limiter_try_acquire(admission_limiter);
+    result_2 = admission_limiter_try_acquire(admission_limiter);
+
+    // assert
+    ASSERT_IS_TRUE(result_1);
+    ASSERT_IS_FALSE(result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    admission_limiter_destroy(admission_limiter);
+}
+
+END_TEST_SUITE(admission_limiter_ut)
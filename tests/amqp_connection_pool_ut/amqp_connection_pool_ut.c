@@ -0,0 +1,1106 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umock_c_negative_tests.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+static int my_mallocAndStrcpy_s(char** destination, const char* source)
+{
+    size_t len = strlen(source);
+    *destination = (char*)my_gballoc_malloc(len + 1);
+    (void)strcpy(*destination, source);
+    return 0;
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/tls_session_cache.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/amqp_connection_pool.h"
+
+#define TEST_MAX_CONNECTIONS 4
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static XIO_HANDLE test_xio = (XIO_HANDLE)0x4200;
+static TLS_SESSION_CACHE_HANDLE test_tls_session_cache = (TLS_SESSION_CACHE_HANDLE)0x4201;
+static size_t created_connection_count;
+static size_t created_session_count;
+static ON_CONNECTION_STATE_CHANGED saved_on_connection_state_changed[TEST_MAX_CONNECTIONS];
+static void* saved_on_connection_state_changed_context[TEST_MAX_CONNECTIONS];
+static ON_IO_ERROR saved_on_io_error[TEST_MAX_CONNECTIONS];
+static void* saved_on_io_error_context[TEST_MAX_CONNECTIONS];
+
+MOCK_FUNCTION_WITH_CODE(, XIO_HANDLE, test_on_create_io, void*, context)
+MOCK_FUNCTION_END(test_xio);
+
+#define TEST_CONNECTION(index) ((CONNECTION_HANDLE)(0x6000 + (index) + 1))
+
+static CONNECTION_HANDLE my_connection_create2(XIO_HANDLE xio, const char* hostname, const char* container_id, ON_NEW_ENDPOINT on_new_endpoint, void* callback_context, ON_CONNECTION_STATE_CHANGED on_connection_state_changed, void* on_connection_state_changed_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    CONNECTION_HANDLE result;
+    (void)xio;
+    (void)hostname;
+    (void)container_id;
+    (void)on_new_endpoint;
+    (void)callback_context;
+    saved_on_connection_state_changed[created_connection_count] = on_connection_state_changed;
+    saved_on_connection_state_changed_context[created_connection_count] = on_connection_state_changed_context;
+    saved_on_io_error[created_connection_count] = on_io_error;
+    saved_on_io_error_context[created_connection_count] = on_io_error_context;
+    result = TEST_CONNECTION(created_connection_count);
+    created_connection_count++;
+    return result;
+}
+
+static SESSION_HANDLE my_session_create(CONNECTION_HANDLE connection, ON_LINK_ATTACHED on_link_attached, void* callback_context)
+{
+    (void)connection;
+    (void)on_link_attached;
+    (void)callback_context;
+    created_session_count++;
+    return (SESSION_HANDLE)(0x7000 + created_session_count);
+}
+
+/* the pool keeps a list of connections and a list of sessions, so the list fakes are a real list */
+typedef struct TEST_LIST_ITEM_TAG
+{
+    const void* value;
+    struct TEST_LIST_ITEM_TAG* next;
+} TEST_LIST_ITEM;
+
+typedef struct TEST_LIST_TAG
+{
+    TEST_LIST_ITEM* head;
+} TEST_LIST;
+
+static SINGLYLINKEDLIST_HANDLE my_singlylinkedlist_create(void)
+{
+    TEST_LIST* list = (TEST_LIST*)malloc(sizeof(TEST_LIST));
+    list->head = NULL;
+    return (SINGLYLINKEDLIST_HANDLE)list;
+}
+
+static void my_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list)
+{
+    TEST_LIST* test_list = (TEST_LIST*)list;
+    while (test_list->head != NULL)
+    {
+        TEST_LIST_ITEM* next = test_list->head->next;
+        free(test_list->head);
+        test_list->head = next;
+    }
+    free(test_list);
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
+{
+    TEST_LIST* test_list = (TEST_LIST*)list;
+    TEST_LIST_ITEM** last = &test_list->head;
+    TEST_LIST_ITEM* new_item = (TEST_LIST_ITEM*)malloc(sizeof(TEST_LIST_ITEM));
+    new_item->value = item;
+    new_item->next = NULL;
+    while (*last != NULL)
+    {
+        last = &(*last)->next;
+    }
+    *last = new_item;
+    return (LIST_ITEM_HANDLE)new_item;
+}
+
+static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
+{
+    TEST_LIST* test_list = (TEST_LIST*)list;
+    TEST_LIST_ITEM** current = &test_list->head;
+    int result = __LINE__;
+    while (*current != NULL)
+    {
+        if (*current == (TEST_LIST_ITEM*)item)
+        {
+            *current = (*current)->next;
+            free(item);
+            result = 0;
+            break;
+        }
+        current = &(*current)->next;
+    }
+    return result;
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
+{
+    return (LIST_ITEM_HANDLE)((TEST_LIST*)list)->head;
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle)
+{
+    return (LIST_ITEM_HANDLE)((TEST_LIST_ITEM*)item_handle)->next;
+}
+
+static const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
+{
+    return ((TEST_LIST_ITEM*)item_handle)->value;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static AMQP_CONNECTION_POOL_HANDLE create_pool_with_tls_session_cache(size_t max_connections, size_t max_sessions_per_connection, TLS_SESSION_CACHE_HANDLE tls_session_cache)
+{
+    AMQP_CONNECTION_POOL_CONFIG config;
+    config.hostname = "test_host";
+    config.container_id = "test_container";
+    config.max_connections = max_connections;
+    config.max_sessions_per_connection = max_sessions_per_connection;
+    config.tls_session_cache = tls_session_cache;
+    return amqp_connection_pool_create(&config, test_on_create_io, (void*)0x4242);
+}
+
+static AMQP_CONNECTION_POOL_HANDLE create_pool(size_t max_connections, size_t max_sessions_per_connection)
+{
+    return create_pool_with_tls_session_cache(max_connections, max_sessions_per_connection, NULL);
+}
+
+BEGIN_TEST_SUITE(amqp_connection_pool_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_HOOK(connection_create2, my_connection_create2);
+    REGISTER_GLOBAL_MOCK_HOOK(session_create, my_session_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, my_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, my_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, my_singlylinkedlist_get_next_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, my_singlylinkedlist_item_get_value);
+
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONNECTION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_NEW_ENDPOINT, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_CONNECTION_STATE_CHANGED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_LINK_ATTACHED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    created_connection_count = 0;
+    created_session_count = 0;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* amqp_connection_pool_create */
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_001: [ `amqp_connection_pool_create` shall create a new connection pool and on success return a non-NULL handle to it. No connection shall be opened before a session is acquired. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_003: [ `amqp_connection_pool_create` shall copy `hostname` and `container_id` and create the lists of connections and sessions by calling `singlylinkedlist_create`. ]*/
+TEST_FUNCTION(amqp_connection_pool_create_returns_a_valid_handle)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_host"));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_container"));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+
+    // act
+    pool = create_pool(2, 10);
+
+    // assert
+    ASSERT_IS_NOT_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_002: [ If `config` or `on_create_io` is NULL, if `hostname` or `container_id` in `config` is NULL, or if `max_connections` or `max_sessions_per_connection` is 0, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_connection_pool_create_with_NULL_config_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool;
+
+    // act
+    pool = amqp_connection_pool_create(NULL, test_on_create_io, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_002: [ If `config` or `on_create_io` is NULL, if `hostname` or `container_id` in `config` is NULL, or if `max_connections` or `max_sessions_per_connection` is 0, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_connection_pool_create_with_NULL_on_create_io_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_CONFIG config;
+    AMQP_CONNECTION_POOL_HANDLE pool;
+    config.hostname = "test_host";
+    config.container_id = "test_container";
+    config.max_connections = 2;
+    config.max_sessions_per_connection = 10;
+    config.tls_session_cache = NULL;
+
+    // act
+    pool = amqp_connection_pool_create(&config, NULL, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_002: [ If `config` or `on_create_io` is NULL, if `hostname` or `container_id` in `config` is NULL, or if `max_connections` or `max_sessions_per_connection` is 0, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_connection_pool_create_with_NULL_hostname_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_CONFIG config;
+    AMQP_CONNECTION_POOL_HANDLE pool;
+    config.hostname = NULL;
+    config.container_id = "test_container";
+    config.max_connections = 2;
+    config.max_sessions_per_connection = 10;
+    config.tls_session_cache = NULL;
+
+    // act
+    pool = amqp_connection_pool_create(&config, test_on_create_io, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_002: [ If `config` or `on_create_io` is NULL, if `hostname` or `container_id` in `config` is NULL, or if `max_connections` or `max_sessions_per_connection` is 0, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_connection_pool_create_with_0_max_connections_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool;
+
+    // act
+    pool = create_pool(0, 10);
+
+    // assert
+    ASSERT_IS_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_002: [ If `config` or `on_create_io` is NULL, if `hostname` or `container_id` in `config` is NULL, or if `max_connections` or `max_sessions_per_connection` is 0, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_connection_pool_create_with_0_max_sessions_per_connection_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool;
+
+    // act
+    pool = create_pool(2, 0);
+
+    // assert
+    ASSERT_IS_NULL(pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_004: [ If any error occurs, `amqp_connection_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_amqp_connection_pool_create_fails_then_amqp_connection_pool_create_fails)
+{
+    // arrange
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_host"))
+        .SetFailReturn(1);
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_container"))
+        .SetFailReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        char tmp_msg[128];
+        AMQP_CONNECTION_POOL_HANDLE pool;
+        (void)sprintf(tmp_msg, "Failure in test %u/%u", (unsigned int)(index + 1), (unsigned int)count);
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        pool = create_pool(2, 10);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(pool, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+/* amqp_connection_pool_destroy */
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_005: [ `amqp_connection_pool_destroy` shall destroy all the sessions still acquired by calling `session_destroy`, then all the connections by calling `connection_destroy` and `xio_destroy`, and free the pool. ]*/
+TEST_FUNCTION(amqp_connection_pool_destroy_frees_the_sessions_and_the_connections)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(session_destroy(session));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(connection_destroy(TEST_CONNECTION(0)));
+    STRICT_EXPECTED_CALL(xio_destroy(test_xio));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqp_connection_pool_destroy(pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_006: [ If `pool` is NULL, `amqp_connection_pool_destroy` shall do nothing. ]*/
+TEST_FUNCTION(amqp_connection_pool_destroy_with_NULL_pool_does_nothing)
+{
+    // arrange
+
+    // act
+    amqp_connection_pool_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_connection_pool_acquire_session */
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_007: [ On success, `amqp_connection_pool_acquire_session` shall return the new session. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_010: [ If no connection has room and the pool has less than `max_connections` connections that are not failed, a new connection shall be created. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_012: [ The session shall be created by calling `session_create` with the connection, `on_link_attached` and `callback_context`. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_014: [ The session shall be added to the list of acquired sessions by calling `singlylinkedlist_add`. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_016: [ The io of a new connection shall be obtained by calling `on_create_io` with `on_create_io_context`. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_017: [ The connection shall be created by calling `connection_create2` with the io, the configured `hostname` and `container_id`, and state changed and io error callbacks. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_018: [ The new connection shall be added to the pool by calling `singlylinkedlist_add`. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_on_an_empty_pool_creates_a_connection)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_create_io((void*)0x4242));
+    STRICT_EXPECTED_CALL(connection_create2(test_xio, "test_host", "test_container", NULL, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(0), NULL, (void*)0x4243));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, (void*)0x4243);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_009: [ The session shall be created on the connection that is not failed, has less than `max_sessions_per_connection` sessions and has the fewest links, the fewest sessions breaking ties. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_reuses_a_connection_that_has_room)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(0), NULL, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(size_t, 1, created_connection_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_010: [ If no connection has room and the pool has less than `max_connections` connections that are not failed, a new connection shall be created. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_when_the_connections_are_full_creates_a_new_connection)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 1);
+    SESSION_HANDLE session;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_create_io((void*)0x4242));
+    STRICT_EXPECTED_CALL(connection_create2(test_xio, "test_host", "test_container", NULL, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(1), NULL, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_011: [ If no connection has room and the pool already has `max_connections` connections that are not failed, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_when_the_pool_is_full_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(1, 1);
+    SESSION_HANDLE session;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_009: [ The session shall be created on the connection that is not failed, has less than `max_sessions_per_connection` sessions and has the fewest links, the fewest sessions breaking ties. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_015: [ `link_count` links shall be accounted to the connection until the session is released. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_picks_the_connection_with_the_fewest_links)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 2);
+    SESSION_HANDLE session;
+    SESSION_HANDLE session_to_release;
+    (void)amqp_connection_pool_acquire_session(pool, 5, NULL, NULL);
+    session_to_release = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    (void)amqp_connection_pool_release_session(pool, session_to_release);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(1), NULL, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_029: [ When a pooled connection reaches `CONNECTION_STATE_ERROR` or `CONNECTION_STATE_END`, or its io reports an error, the connection shall be marked as failed and no more sessions shall be handed out on it. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_after_a_connection_failed_replaces_the_connection)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(1, 10);
+    SESSION_HANDLE session;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    saved_on_connection_state_changed[0](saved_on_connection_state_changed_context[0], CONNECTION_STATE_ERROR, CONNECTION_STATE_OPENED);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_create_io((void*)0x4242));
+    STRICT_EXPECTED_CALL(connection_create2(test_xio, "test_host", "test_container", NULL, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(1), NULL, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_029: [ When a pooled connection reaches `CONNECTION_STATE_ERROR` or `CONNECTION_STATE_END`, or its io reports an error, the connection shall be marked as failed and no more sessions shall be handed out on it. ]*/
+TEST_FUNCTION(when_the_io_of_a_connection_reports_an_error_the_connection_is_not_counted_anymore)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    size_t connection_count;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    saved_on_io_error[0](saved_on_io_error_context[0]);
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    connection_count = amqp_connection_pool_get_connection_count(pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, connection_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_030: [ If a `tls_session_cache` is configured, the options saved for the configured `hostname` shall be set on the io of a new connection by calling `tls_session_cache_apply`, so that the TLS handshake can resume the session of an earlier connection. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_with_a_tls_session_cache_applies_the_cached_session_to_the_new_io)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool_with_tls_session_cache(2, 10, test_tls_session_cache);
+    SESSION_HANDLE session;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_create_io((void*)0x4242));
+    STRICT_EXPECTED_CALL(tls_session_cache_apply(test_tls_session_cache, "test_host", test_xio));
+    STRICT_EXPECTED_CALL(connection_create2(test_xio, "test_host", "test_container", NULL, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(0), NULL, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_031: [ If `tls_session_cache_apply` fails, the connection shall still be created and do a full TLS handshake. ]*/
+TEST_FUNCTION(when_tls_session_cache_apply_fails_amqp_connection_pool_acquire_session_still_creates_the_connection)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool_with_tls_session_cache(2, 10, test_tls_session_cache);
+    SESSION_HANDLE session;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_create_io((void*)0x4242));
+    STRICT_EXPECTED_CALL(tls_session_cache_apply(test_tls_session_cache, "test_host", test_xio))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(connection_create2(test_xio, "test_host", "test_container", NULL, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(0), NULL, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_032: [ When a pooled connection reaches `CONNECTION_STATE_OPENED` and a `tls_session_cache` is configured, the options of its io shall be saved for the configured `hostname` by calling `tls_session_cache_save`. ]*/
+TEST_FUNCTION(when_a_pooled_connection_opens_its_tls_session_is_saved_in_the_cache)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool_with_tls_session_cache(2, 10, test_tls_session_cache);
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tls_session_cache_save(test_tls_session_cache, "test_host", test_xio));
+
+    // act
+    saved_on_connection_state_changed[0](saved_on_connection_state_changed_context[0], CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_033: [ If `tls_session_cache_save` fails, the connection shall be used as is. ]*/
+TEST_FUNCTION(when_tls_session_cache_save_fails_the_connection_is_still_used)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool_with_tls_session_cache(1, 10, test_tls_session_cache);
+    SESSION_HANDLE session;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    STRICT_EXPECTED_CALL(tls_session_cache_save(test_tls_session_cache, "test_host", test_xio))
+        .SetReturn(1);
+    saved_on_connection_state_changed[0](saved_on_connection_state_changed_context[0], CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
+    umock_c_reset_all_calls();
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(session);
+    ASSERT_ARE_EQUAL(size_t, 1, amqp_connection_pool_get_connection_count(pool));
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_032: [ When a pooled connection reaches `CONNECTION_STATE_OPENED` and a `tls_session_cache` is configured, the options of its io shall be saved for the configured `hostname` by calling `tls_session_cache_save`. ]*/
+TEST_FUNCTION(when_no_tls_session_cache_is_configured_nothing_is_saved_when_a_pooled_connection_opens)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    saved_on_connection_state_changed[0](saved_on_connection_state_changed_context[0], CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_008: [ If `pool` is NULL, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_connection_pool_acquire_session_with_NULL_pool_fails)
+{
+    // arrange
+    SESSION_HANDLE session;
+
+    // act
+    session = amqp_connection_pool_acquire_session(NULL, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_013: [ If any error occurs, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_on_create_io_fails_then_amqp_connection_pool_acquire_session_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_create_io((void*)0x4242))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_013: [ If any error occurs, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_connection_create2_fails_then_amqp_connection_pool_acquire_session_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_create_io((void*)0x4242));
+    STRICT_EXPECTED_CALL(connection_create2(test_xio, "test_host", "test_container", NULL, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_destroy(test_xio));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_013: [ If any error occurs, `amqp_connection_pool_acquire_session` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_session_create_fails_then_amqp_connection_pool_acquire_session_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(session_create(TEST_CONNECTION(0), NULL, NULL))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(session);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* amqp_connection_pool_release_session */
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_019: [ On success, `amqp_connection_pool_release_session` shall return 0. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_020: [ `amqp_connection_pool_release_session` shall destroy the session by calling `session_destroy` and take it and its links off the count of its connection. ]*/
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_023: [ The connection shall be kept when its last session is released. ]*/
+TEST_FUNCTION(amqp_connection_pool_release_session_destroys_the_session_and_keeps_the_connection)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(session_destroy(session));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_connection_pool_release_session(pool, session);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, amqp_connection_pool_get_connection_count(pool));
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_021: [ If `pool` or `session` is NULL, `amqp_connection_pool_release_session` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_connection_pool_release_session_with_NULL_session_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_connection_pool_release_session(pool, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_022: [ If `session` was not acquired from `pool`, `amqp_connection_pool_release_session` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_connection_pool_release_session_with_a_session_not_from_the_pool_fails)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    int result;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_connection_pool_release_session(pool, (SESSION_HANDLE)0x4444);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* amqp_connection_pool_dowork */
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_024: [ `amqp_connection_pool_dowork` shall call `connection_dowork` for each connection of the pool. ]*/
+TEST_FUNCTION(amqp_connection_pool_dowork_works_all_connections)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 1);
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(connection_dowork(TEST_CONNECTION(0)));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(connection_dowork(TEST_CONNECTION(1)));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    amqp_connection_pool_dowork(pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_026: [ Failed connections that have no sessions left shall then be removed from the pool and destroyed by calling `connection_destroy` and `xio_destroy`. ]*/
+TEST_FUNCTION(amqp_connection_pool_dowork_destroys_a_failed_connection_without_sessions)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    SESSION_HANDLE session = amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    (void)amqp_connection_pool_release_session(pool, session);
+    saved_on_connection_state_changed[0](saved_on_connection_state_changed_context[0], CONNECTION_STATE_END, CONNECTION_STATE_CLOSE_RCVD);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(connection_dowork(TEST_CONNECTION(0)));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(connection_destroy(TEST_CONNECTION(0)));
+    STRICT_EXPECTED_CALL(xio_destroy(test_xio));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqp_connection_pool_dowork(pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_026: [ Failed connections that have no sessions left shall then be removed from the pool and destroyed by calling `connection_destroy` and `xio_destroy`. ]*/
+TEST_FUNCTION(amqp_connection_pool_dowork_keeps_a_failed_connection_that_still_has_sessions)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 10);
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    saved_on_connection_state_changed[0](saved_on_connection_state_changed_context[0], CONNECTION_STATE_ERROR, CONNECTION_STATE_OPENED);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(connection_dowork(TEST_CONNECTION(0)));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    amqp_connection_pool_dowork(pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_025: [ If `pool` is NULL, `amqp_connection_pool_dowork` shall do nothing. ]*/
+TEST_FUNCTION(amqp_connection_pool_dowork_with_NULL_pool_does_nothing)
+{
+    // arrange
+
+    // act
+    amqp_connection_pool_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_connection_pool_get_connection_count */
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_027: [ `amqp_connection_pool_get_connection_count` shall return the number of connections of the pool that are not failed. ]*/
+TEST_FUNCTION(amqp_connection_pool_get_connection_count_returns_the_number_of_connections)
+{
+    // arrange
+    AMQP_CONNECTION_POOL_HANDLE pool = create_pool(2, 1);
+    size_t connection_count;
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    (void)amqp_connection_pool_acquire_session(pool, 1, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    connection_count = amqp_connection_pool_get_connection_count(pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, connection_count);
+
+    // cleanup
+    amqp_connection_pool_destroy(pool);
+}
+
+/* Tests_SRS_AMQP_CONNECTION_POOL_01_028: [ If `pool` is NULL, `amqp_connection_pool_get_connection_count` shall return 0. ]*/
+TEST_FUNCTION(amqp_connection_pool_get_connection_count_with_NULL_pool_returns_0)
+{
+    // arrange
+    size_t connection_count;
+
+    // act
+    connection_count = amqp_connection_pool_get_connection_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, connection_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(amqp_connection_pool_ut)
@@ -56,7 +56,6 @@ static void* saved_callback_context;
 
 static ON_VALUE_DECODED saved_value_decoded_callback;
 static void* saved_value_decoded_callback_context;
-static size_t total_bytes;
 static PAYLOAD* actual_payloads;
 static size_t actual_payload_count;
 
@@ -279,44 +278,73 @@ static AMQPVALUE_DECODER_HANDLE my_amqpvalue_decoder_create(ON_VALUE_DECODED val
 {
     saved_value_decoded_callback = value_decoded_callback;
     saved_value_decoded_callback_context = value_decoded_callback_context;
-    total_bytes = 0;
     return TEST_DECODER_HANDLE;
 }
 
-static int my_amqpvalue_decode_bytes(AMQPVALUE_DECODER_HANDLE handle, const unsigned char* buffer, size_t size)
+static int my_amqpvalue_decode_one(AMQPVALUE_DECODER_HANDLE handle, const unsigned char* buffer, size_t size, size_t* used_bytes)
 {
-    unsigned char* new_bytes = (unsigned char*)my_gballoc_realloc(performative_decoded_bytes, performative_decoded_byte_count + size);
+    int result;
     (void)handle;
-    if (new_bytes != NULL)
+    if (size < sizeof(test_performative))
     {
-        performative_decoded_bytes = new_bytes;
-        (void)memcpy(performative_decoded_bytes + performative_decoded_byte_count, buffer, size);
-        performative_decoded_byte_count += size;
+        result = 1;
     }
-    total_bytes += size;
-    if (total_bytes == sizeof(test_performative))
+    else
     {
+        unsigned char* new_bytes = (unsigned char*)my_gballoc_realloc(performative_decoded_bytes, performative_decoded_byte_count + sizeof(test_performative));
+        if (new_bytes != NULL)
+        {
+            performative_decoded_bytes = new_bytes;
+            (void)memcpy(performative_decoded_bytes + performative_decoded_byte_count, buffer, sizeof(test_performative));
+            performative_decoded_byte_count += sizeof(test_performative);
+        }
+
+        *used_bytes = sizeof(test_performative);
         saved_value_decoded_callback(saved_value_decoded_callback_context, TEST_AMQP_VALUE);
-        total_bytes = 0;
+        result = 0;
     }
 
-    return 0;
+    return result;
 }
 
-static int my_amqpvalue_encode(AMQP_VALUE value, AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context)
+static int my_amqpvalue_encode_to_buffer(AMQP_VALUE value, unsigned char* buffer, size_t buffer_size, size_t* encoded_size)
 {
     (void)value;
-    encoder_output(context, test_encoded_bytes, sizeof(test_encoded_bytes));
+    (void)buffer_size;
+    (void)memcpy(buffer, test_encoded_bytes, sizeof(test_encoded_bytes));
+    *encoded_size = sizeof(test_encoded_bytes);
     return 0;
 }
 
 MOCK_FUNCTION_WITH_CODE(, void, amqp_empty_frame_received_callback_1, void*, context, uint16_t, channel);
 MOCK_FUNCTION_END();
-MOCK_FUNCTION_WITH_CODE(, void, amqp_frame_received_callback_1, void*, context, uint16_t, channel, AMQP_VALUE, performative, const unsigned char*, payload_bytes, uint32_t, frame_payload_size);
+MOCK_FUNCTION_WITH_CODE(, void, amqp_frame_received_callback_1, void*, context, uint16_t, channel, AMQP_VALUE, performative, uint64_t, performative_code, const unsigned char*, payload_bytes, uint32_t, frame_payload_size);
 MOCK_FUNCTION_END();
 MOCK_FUNCTION_WITH_CODE(, void, test_amqp_frame_codec_error, void*, context);
 MOCK_FUNCTION_END();
 
+static size_t test_on_performative_bytes_calls;
+static void* test_on_performative_bytes_context;
+static bool test_on_performative_bytes_is_outgoing;
+static uint16_t test_on_performative_bytes_channel;
+static unsigned char test_on_performative_bytes_bytes[16];
+static size_t test_on_performative_bytes_size;
+static uint32_t test_on_performative_bytes_payload_size;
+
+static void test_on_performative_bytes(void* context, bool is_outgoing, uint16_t channel, const unsigned char* performative_bytes, size_t performative_size, uint32_t payload_size)
+{
+    test_on_performative_bytes_calls++;
+    test_on_performative_bytes_context = context;
+    test_on_performative_bytes_is_outgoing = is_outgoing;
+    test_on_performative_bytes_channel = channel;
+    test_on_performative_bytes_size = performative_size;
+    test_on_performative_bytes_payload_size = payload_size;
+    if (performative_size <= sizeof(test_on_performative_bytes_bytes))
+    {
+        (void)memcpy(test_on_performative_bytes_bytes, performative_bytes, performative_size);
+    }
+}
+
 static void test_on_bytes_encoded(void* context, const unsigned char* bytes, size_t length, bool encode_complete)
 {
     (void)context;
@@ -358,8 +386,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(frame_codec_subscribe, my_frame_codec_subscribe);
     REGISTER_GLOBAL_MOCK_HOOK(frame_codec_encode_frame, my_frame_codec_encode_frame);
     REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_decoder_create, my_amqpvalue_decoder_create);
-    REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_decode_bytes, my_amqpvalue_decode_bytes);
-    REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_encode, my_amqpvalue_encode);
+    REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_decode_one, my_amqpvalue_decode_one);
+    REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_encode_to_buffer, my_amqpvalue_encode_to_buffer);
     
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_create_ulong, TEST_AMQP_VALUE);
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_inplace_descriptor, TEST_DESCRIPTOR_AMQP_VALUE);
@@ -628,13 +656,213 @@ TEST_FUNCTION(amqp_frame_codec_destroy_with_NULL_handle_does_nothing)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+/* amqp_frame_codec_set_decoder_limits */
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_077: [amqp_frame_codec_set_decoder_limits shall apply max_depth, max_element_count and max_allocated_bytes to the decoder created in amqp_frame_codec_create by calling amqpvalue_decoder_set_limits and return 0.] */
+TEST_FUNCTION(amqp_frame_codec_set_decoder_limits_sets_the_limits_on_the_decoder)
+{
+    // arrange
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_decoder_set_limits(TEST_DECODER_HANDLE, 16, 1000, 65536));
+
+    // act
+    result = amqp_frame_codec_set_decoder_limits(amqp_frame_codec, 16, 1000, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_078: [If amqp_frame_codec is NULL, amqp_frame_codec_set_decoder_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqp_frame_codec_set_decoder_limits_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_frame_codec_set_decoder_limits(NULL, 16, 1000, 65536);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_079: [If amqpvalue_decoder_set_limits fails, amqp_frame_codec_set_decoder_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_amqpvalue_decoder_set_limits_fails_amqp_frame_codec_set_decoder_limits_fails)
+{
+    // arrange
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_decoder_set_limits(TEST_DECODER_HANDLE, 16, 1000, 65536))
+        .SetReturn(1);
+
+    // act
+    result = amqp_frame_codec_set_decoder_limits(amqp_frame_codec, 16, 1000, 65536);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
+/* amqp_frame_codec_set_on_performative_bytes */
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_082: [amqp_frame_codec_set_on_performative_bytes shall make the amqp_frame_codec call on_performative_bytes with context for the performatives it decodes and encodes, a NULL on_performative_bytes stopping the calls, and return 0.] */
+TEST_FUNCTION(amqp_frame_codec_set_on_performative_bytes_succeeds)
+{
+    // arrange
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_frame_codec_set_on_performative_bytes(amqp_frame_codec, test_on_performative_bytes, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_083: [If amqp_frame_codec is NULL, amqp_frame_codec_set_on_performative_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqp_frame_codec_set_on_performative_bytes_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_frame_codec_set_on_performative_bytes(NULL, test_on_performative_bytes, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_080: [When on_performative_bytes is set, it shall be called with the bytes of every performative decoded, the channel and the payload size before frame_received_callback is called.] */
+TEST_FUNCTION(when_on_performative_bytes_is_set_the_decoded_performative_bytes_are_reported)
+{
+    // arrange
+    unsigned char channel_bytes[] = { 0x42, 0x43 };
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    uint64_t descriptor_ulong = AMQP_OPEN;
+    (void)amqp_frame_codec_set_on_performative_bytes(amqp_frame_codec, test_on_performative_bytes, (void*)0x4244);
+    test_on_performative_bytes_calls = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
+    STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &descriptor_ulong, sizeof(descriptor_ulong));
+    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, AMQP_OPEN, IGNORED_PTR_ARG, 2))
+        .ValidateArgumentBuffer(5, test_frame_payload_bytes, 2);
+
+    // act
+    saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, test_on_performative_bytes_calls);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4244, test_on_performative_bytes_context);
+    ASSERT_IS_FALSE(test_on_performative_bytes_is_outgoing);
+    ASSERT_ARE_EQUAL(uint32_t, 0x4243, (uint32_t)test_on_performative_bytes_channel);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_performative), test_on_performative_bytes_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(test_performative, test_on_performative_bytes_bytes, sizeof(test_performative)));
+    ASSERT_ARE_EQUAL(uint32_t, 2, test_on_performative_bytes_payload_size);
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_081: [When on_performative_bytes is set, it shall be called with the bytes of every performative encoded, the channel and the payload size once the frame is encoded.] */
+TEST_FUNCTION(when_on_performative_bytes_is_set_the_encoded_performative_bytes_are_reported)
+{
+    // arrange
+    int result;
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    size_t performative_size = 2;
+    (void)amqp_frame_codec_set_on_performative_bytes(amqp_frame_codec, test_on_performative_bytes, (void*)0x4244);
+    test_on_performative_bytes_calls = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
+    STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &performative_size, sizeof(performative_size));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_encode_to_buffer(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 2, test_on_bytes_encoded, (void*)0x4242));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_frame_codec_encode_frame(amqp_frame_codec, 0x4243, TEST_AMQP_VALUE, &test_user_payload, 1, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, test_on_performative_bytes_calls);
+    ASSERT_IS_TRUE(test_on_performative_bytes_is_outgoing);
+    ASSERT_ARE_EQUAL(uint32_t, 0x4243, (uint32_t)test_on_performative_bytes_channel);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_encoded_bytes), test_on_performative_bytes_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(test_encoded_bytes, test_on_performative_bytes_bytes, sizeof(test_encoded_bytes)));
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)test_user_payload.length, test_on_performative_bytes_payload_size);
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_081: [When on_performative_bytes is set, it shall be called with the bytes of every performative encoded, the channel and the payload size once the frame is encoded.] */
+TEST_FUNCTION(when_on_performative_bytes_is_set_the_already_encoded_performative_bytes_are_reported)
+{
+    // arrange
+    int result;
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    unsigned char performative_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+    (void)amqp_frame_codec_set_on_performative_bytes(amqp_frame_codec, test_on_performative_bytes, (void*)0x4244);
+    test_on_performative_bytes_calls = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 2, test_on_bytes_encoded, (void*)0x4242));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_frame_codec_encode_frame_with_encoded_performative(amqp_frame_codec, 1, performative_bytes, sizeof(performative_bytes), &test_user_payload, 1, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, test_on_performative_bytes_calls);
+    ASSERT_IS_TRUE(test_on_performative_bytes_is_outgoing);
+    ASSERT_ARE_EQUAL(uint32_t, 1, (uint32_t)test_on_performative_bytes_channel);
+    ASSERT_ARE_EQUAL(size_t, sizeof(performative_bytes), test_on_performative_bytes_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(performative_bytes, test_on_performative_bytes_bytes, sizeof(performative_bytes)));
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)test_user_payload.length, test_on_performative_bytes_payload_size);
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
 /* amqp_frame_codec_encode_frame */
 
 /* Tests_SRS_AMQP_FRAME_CODEC_01_022: [amqp_frame_codec_encode_frame shall encode the frame header and AMQP performative in an AMQP frame and on success it shall return 0.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_025: [amqp_frame_codec_encode_frame shall encode the frame header by using frame_codec_encode_frame.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_026: [The payload frame size shall be computed based on the encoded size of the performative and its fields plus the sum of the payload sizes passed via the payloads argument.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_027: [The encoded size of the performative and its fields shall be obtained by calling amqpvalue_get_encoded_size.] */
-/* Tests_SRS_AMQP_FRAME_CODEC_01_030: [Encoding of the AMQP performative and its fields shall be done by calling amqpvalue_encode.] */
+/* Tests_SRS_AMQP_FRAME_CODEC_01_030: [Encoding of the AMQP performative and its fields shall be done by calling amqpvalue_encode_to_buffer.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_028: [The encode result for the performative shall be placed in a PAYLOAD structure.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_070: [The payloads argument for frame_codec_encode_frame shall be made of the payload for the encoded performative and the payloads passed to amqp_frame_codec_encode_frame.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_005: [Bytes 6 and 7 of an AMQP frame contain the channel number ] */
@@ -656,7 +884,7 @@ TEST_FUNCTION(encoding_a_frame_succeeds)
         .CopyOutArgumentBuffer(2, &performative_size, sizeof(performative_size));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_encode_to_buffer(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 2, channel_bytes, sizeof(channel_bytes), test_on_bytes_encoded, (void*)0x4242))
         .ValidateArgumentBuffer(5, &channel_bytes, sizeof(channel_bytes));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -694,7 +922,7 @@ TEST_FUNCTION(using_channel_no_0x4243_passes_the_channel_number_as_type_specific
         .CopyOutArgumentBuffer(2, &performative_size, sizeof(performative_size));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_encode_to_buffer(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 2, channel_bytes, sizeof(channel_bytes), test_on_bytes_encoded, (void*)0x4242))
         .ValidateArgumentBuffer(5, &channel_bytes, sizeof(channel_bytes));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -729,7 +957,7 @@ TEST_FUNCTION(encoding_a_frame_with_no_payloads_send_down_to_frame_codec_just_th
         .CopyOutArgumentBuffer(2, &performative_size, sizeof(performative_size));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_encode_to_buffer(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 1, channel_bytes, sizeof(channel_bytes), test_on_bytes_encoded, (void*)0x4242))
         .ValidateArgumentBuffer(5, &channel_bytes, sizeof(channel_bytes));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -905,7 +1133,7 @@ TEST_FUNCTION(when_amqpvalue_encode_fails_then_amqp_frame_codec_encode_frame_fai
         .CopyOutArgumentBuffer(2, &performative_size, sizeof(performative_size));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+    STRICT_EXPECTED_CALL(amqpvalue_encode_to_buffer(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
         .SetReturn(1);
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -937,7 +1165,7 @@ TEST_FUNCTION(when_frame_codec_encode_frame_fails_then_amqp_frame_codec_encode_f
         .CopyOutArgumentBuffer(2, &performative_size, sizeof(performative_size));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_encode_to_buffer(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 2, channel_bytes, sizeof(channel_bytes), test_on_bytes_encoded, (void*)0x4242))
         .ValidateArgumentBuffer(5, &channel_bytes, sizeof(channel_bytes))
         .SetReturn(1);
@@ -982,7 +1210,7 @@ TEST_FUNCTION(amqp_performatives_are_encoded_successfully)
             .CopyOutArgumentBuffer(2, &performative_size, sizeof(performative_size));
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-        STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(amqpvalue_encode_to_buffer(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
         STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 1, channel_bytes, sizeof(channel_bytes), test_on_bytes_encoded, (void*)0x4242))
             .ValidateArgumentBuffer(5, &channel_bytes, sizeof(channel_bytes));
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1098,6 +1326,85 @@ TEST_FUNCTION(when_performative_ulong_is_0x19_amqp_frame_codec_encode_frame_fail
     amqp_frame_codec_destroy(amqp_frame_codec);
 }
 
+/* amqp_frame_codec_encode_frame_with_encoded_performative */
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_071: [amqp_frame_codec_encode_frame_with_encoded_performative shall encode an AMQP frame whose performative is given as already encoded bytes and on success it shall return 0.] */
+/* Tests_SRS_AMQP_FRAME_CODEC_01_073: [The payloads argument for frame_codec_encode_frame shall be made of the performative bytes followed by the payloads passed to amqp_frame_codec_encode_frame_with_encoded_performative.] */
+TEST_FUNCTION(amqp_frame_codec_encode_frame_with_encoded_performative_passes_the_performative_bytes_and_the_payloads_to_frame_codec)
+{
+    // arrange
+    int result;
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    unsigned char performative_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+    uint16_t channel = 0x4243;
+    unsigned char channel_bytes[] = { 0x42, 0x43 };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 2, channel_bytes, sizeof(channel_bytes), test_on_bytes_encoded, (void*)0x4242))
+        .ValidateArgumentBuffer(5, &channel_bytes, sizeof(channel_bytes));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_frame_codec_encode_frame_with_encoded_performative(amqp_frame_codec, channel, performative_bytes, sizeof(performative_bytes), &test_user_payload, 1, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(performative_bytes), actual_payloads[0].length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(performative_bytes, actual_payloads[0].bytes, actual_payloads[0].length));
+    ASSERT_ARE_EQUAL(size_t, test_user_payload.length, actual_payloads[1].length);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_072: [If amqp_frame_codec, performative_bytes or on_bytes_encoded is NULL or performative_size is 0, amqp_frame_codec_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqp_frame_codec_encode_frame_with_encoded_performative_with_NULL_performative_bytes_fails)
+{
+    // arrange
+    int result;
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_frame_codec_encode_frame_with_encoded_performative(amqp_frame_codec, 0, NULL, 4, &test_user_payload, 1, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
+/* Tests_SRS_AMQP_FRAME_CODEC_01_074: [If any error occurs during encoding, amqp_frame_codec_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_frame_codec_encode_frame_fails_then_amqp_frame_codec_encode_frame_with_encoded_performative_fails)
+{
+    // arrange
+    int result;
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
+    unsigned char performative_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+    unsigned char channel_bytes[] = { 0, 0 };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(frame_codec_encode_frame(TEST_FRAME_CODEC_HANDLE, FRAME_TYPE_AMQP, IGNORED_PTR_ARG, 1, channel_bytes, sizeof(channel_bytes), test_on_bytes_encoded, (void*)0x4242))
+        .ValidateArgumentBuffer(5, &channel_bytes, sizeof(channel_bytes))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_frame_codec_encode_frame_with_encoded_performative(amqp_frame_codec, 0, performative_bytes, sizeof(performative_bytes), NULL, 0, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_frame_codec_destroy(amqp_frame_codec);
+}
+
 /* amqp_frame_codec_encode_empty_frame */
 
 /* Tests_SRS_AMQP_FRAME_CODEC_01_042: [amqp_frame_codec_encode_empty_frame shall encode a frame with no payload.] */
@@ -1254,6 +1561,7 @@ TEST_FUNCTION(when_an_empty_frame_with_only_1_byte_of_type_specific_data_is_rece
 }
 
 /* Tests_SRS_AMQP_FRAME_CODEC_01_052: [Decoding the performative shall be done by feeding the bytes to the decoder create in amqp_frame_codec_create.] */
+/* Tests_SRS_AMQP_FRAME_CODEC_01_075: [The performative shall be decoded with a single call to amqpvalue_decode_one, the bytes it reports as used separating the performative from the payload.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_054: [Once the performative is decoded, the callback frame_received_callback shall be called.] */
 /* Tests_SRS_AMQP_FRAME_CODEC_01_055: [The decoded channel and performative shall be passed to frame_received_callback.]  */
 TEST_FUNCTION(when_all_performative_bytes_are_received_and_AMQP_frame_payload_is_0_callback_is_triggered)
@@ -1262,17 +1570,13 @@ TEST_FUNCTION(when_all_performative_bytes_are_received_and_AMQP_frame_payload_is
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
     uint64_t descriptor_ulong = AMQP_OPEN;
-    size_t i;
     umock_c_reset_all_calls();
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &descriptor_ulong, sizeof(descriptor_ulong));
-    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, AMQP_OPEN, IGNORED_PTR_ARG, 0));
 
     // act
     saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_performative, sizeof(test_performative));
@@ -1297,19 +1601,15 @@ TEST_FUNCTION(amqp_frame_with_1_payload_bytes_are_reported_via_the_amqp_frame_pa
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
     uint64_t descriptor_ulong = AMQP_OPEN;
-    size_t i;
     umock_c_reset_all_calls();
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &descriptor_ulong, sizeof(descriptor_ulong));
 
-    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, test_frame_payload_bytes, 1))
-        .ValidateArgumentBuffer(4, test_frame_payload_bytes, 1);
+    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, AMQP_OPEN, test_frame_payload_bytes, 1))
+        .ValidateArgumentBuffer(5, test_frame_payload_bytes, 1);
 
     // act
     saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_performative) + 1);
@@ -1331,19 +1631,15 @@ TEST_FUNCTION(amqp_frame_with_2_payload_bytes_are_reported_via_the_amqp_frame_pa
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
     uint64_t descriptor_ulong = AMQP_OPEN;
-    size_t i;
     umock_c_reset_all_calls();
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &descriptor_ulong, sizeof(descriptor_ulong));
 
-    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, test_frame_payload_bytes, 2))
-        .ValidateArgumentBuffer(4, test_frame_payload_bytes, 2);
+    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, AMQP_OPEN, test_frame_payload_bytes, 2))
+        .ValidateArgumentBuffer(5, test_frame_payload_bytes, 2);
 
     // act
     saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_performative) + 2);
@@ -1362,32 +1658,25 @@ TEST_FUNCTION(after_decoding_succesfully_a_second_frame_can_be_decoded)
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
     uint64_t descriptor_ulong = AMQP_OPEN;
-    size_t i;
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &descriptor_ulong, sizeof(descriptor_ulong));
 
-    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, test_frame_payload_bytes, 2))
-        .ValidateArgumentBuffer(4, test_frame_payload_bytes, 2);
+    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, AMQP_OPEN, test_frame_payload_bytes, 2))
+        .ValidateArgumentBuffer(5, test_frame_payload_bytes, 2);
 
     (void)saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_performative) + 2);
     umock_c_reset_all_calls();
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &descriptor_ulong, sizeof(descriptor_ulong));
 
-    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, test_frame_payload_bytes, 2))
-        .ValidateArgumentBuffer(4, test_frame_payload_bytes, 2);
+    STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, AMQP_OPEN, test_frame_payload_bytes, 2))
+        .ValidateArgumentBuffer(5, test_frame_payload_bytes, 2);
 
     // act
     saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_performative) + 2);
@@ -1400,6 +1689,7 @@ TEST_FUNCTION(after_decoding_succesfully_a_second_frame_can_be_decoded)
 }
 
 /* Tests_SRS_AMQP_FRAME_CODEC_01_003: [The performative MUST be one of those defined in section 2.7 and is encoded as a described type in the AMQP type system.] */
+/* Tests_SRS_AMQP_FRAME_CODEC_01_076: [The descriptor of the performative, validated while decoding it, shall also be passed to frame_received_callback as performative_code.] */
 TEST_FUNCTION(valid_performative_codes_trigger_callbacks)
 {
     // arrange
@@ -1410,21 +1700,17 @@ TEST_FUNCTION(valid_performative_codes_trigger_callbacks)
 
     for (i = 0; i < 2; i++)
     {
-        size_t j;
         umock_c_reset_all_calls();
 
         performative_ulong = valid_performatives[i];
 
-        for (j = 0; j < sizeof(test_performative); j++)
-        {
-            STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-        }
+        STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
         STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
         STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
             .CopyOutArgumentBuffer(2, &performative_ulong, sizeof(performative_ulong));
 
-        STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, test_frame_payload_bytes, 2))
-            .ValidateArgumentBuffer(4, test_frame_payload_bytes, 2);
+        STRICT_EXPECTED_CALL(amqp_frame_received_callback_1(TEST_CONTEXT, 0x4243, TEST_AMQP_VALUE, valid_performatives[i], test_frame_payload_bytes, 2))
+            .ValidateArgumentBuffer(5, test_frame_payload_bytes, 2);
 
         // act
         saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_performative) + 2);
@@ -1444,14 +1730,10 @@ TEST_FUNCTION(performative_0x09_can_not_be_decoded)
     // arrange
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
-    size_t i;
     umock_c_reset_all_calls();
     performative_ulong = 0x09;
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &performative_ulong, sizeof(performative_ulong));
@@ -1475,14 +1757,10 @@ TEST_FUNCTION(performative_0x19_can_not_be_decoded)
     // arrange
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
-    size_t i;
     umock_c_reset_all_calls();
     performative_ulong = 0x19;
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
@@ -1510,33 +1788,7 @@ TEST_FUNCTION(when_amqp_value_decoding_for_the_performative_fails_decoder_fails)
     umock_c_reset_all_calls();
 
     performative_ulong = AMQP_OPEN;
-    STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(1);
-
-    STRICT_EXPECTED_CALL(test_amqp_frame_codec_error(TEST_CONTEXT));
-
-    // act
-    saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_performative) + 2);
-
-    // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqp_frame_codec_destroy(amqp_frame_codec);
-}
-
-/* Tests_SRS_AMQP_FRAME_CODEC_01_060: [If any error occurs while decoding a frame, the decoder shall switch to an error state where decoding shall not be possible anymore.] */
-/* Tests_SRS_AMQP_FRAME_CODEC_01_069: [If any error occurs while decoding a frame, the decoder shall indicate the error by calling the amqp_frame_codec_error_callback  and passing to it the callback context argument that was given in amqp_frame_codec_create.] */
-TEST_FUNCTION(when_second_amqp_value_decoding_for_the_performative_fails_decoder_fails)
-{
-    // arrange
-    unsigned char channel_bytes[] = { 0x42, 0x43 };
-    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
-    umock_c_reset_all_calls();
-
-    performative_ulong = AMQP_OPEN;
-    STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
         .SetReturn(1);
 
     STRICT_EXPECTED_CALL(test_amqp_frame_codec_error(TEST_CONTEXT));
@@ -1558,14 +1810,10 @@ TEST_FUNCTION(when_getting_the_descriptor_fails_decoder_fails)
     // arrange
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
-    size_t i;
     umock_c_reset_all_calls();
     performative_ulong = AMQP_OPEN;
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE))
         .SetReturn(NULL);
@@ -1589,14 +1837,10 @@ TEST_FUNCTION(when_getting_the_ulong_value_of_the_descriptor_fails_decoder_fails
     // arrange
     unsigned char channel_bytes[] = { 0x42, 0x43 };
     AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(TEST_FRAME_CODEC_HANDLE, amqp_frame_received_callback_1, amqp_empty_frame_received_callback_1, test_amqp_frame_codec_error, TEST_CONTEXT);
-    size_t i;
     umock_c_reset_all_calls();
     performative_ulong = AMQP_OPEN;
 
-    for (i = 0; i < sizeof(test_performative); i++)
-    {
-        STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    }
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG))
@@ -1624,7 +1868,7 @@ TEST_FUNCTION(when_amqp_value_decoding_fails_subsequent_decoding_fails_even_if_t
     umock_c_reset_all_calls();
 
     performative_ulong = AMQP_OPEN;
-    STRICT_EXPECTED_CALL(amqpvalue_decode_bytes(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+    STRICT_EXPECTED_CALL(amqpvalue_decode_one(TEST_DECODER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
         .SetReturn(1);
 
     (void)saved_on_frame_received(saved_callback_context, channel_bytes, sizeof(channel_bytes), test_frame, sizeof(test_performative) + 2);
@@ -0,0 +1,484 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_json.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(amqp_json_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* amqp_json_from_amqp */
+
+/* Tests_SRS_AMQP_JSON_01_001: [ `amqp_json_from_amqp` shall write the JSON text of the AMQP value encoded in `bytes` to `json`, not NUL terminated, set `json_length` to its number of characters and return 0, reading the encoding with the AMQP reader. ]*/
+/* Tests_SRS_AMQP_JSON_01_005: [ null and booleans shall be written as `null`, `true` and `false`, integers and timestamps (in milliseconds) as numbers. ]*/
+/* Tests_SRS_AMQP_JSON_01_006: [ A float or double shall be written as a number with the fewest digits that read back as the same value. ]*/
+/* Tests_SRS_AMQP_JSON_01_012: [ Lists and arrays shall be written as JSON arrays and maps as JSON objects. ]*/
+/* Tests_SRS_AMQP_JSON_01_013: [ Map keys that are not written as strings shall be written as their JSON text in a string. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_writes_a_map_with_a_list)
+{
+    // arrange
+    unsigned char bytes[128];
+    AMQP_WRITER writer;
+    size_t length;
+    char json[128];
+    size_t json_length;
+    int result;
+    (void)amqp_writer_init(&writer, bytes, sizeof(bytes));
+    (void)amqp_writer_begin_map(&writer);
+    (void)amqp_writer_put_symbol(&writer, "a");
+    (void)amqp_writer_begin_list(&writer);
+    (void)amqp_writer_put_null(&writer);
+    (void)amqp_writer_put_boolean(&writer, true);
+    (void)amqp_writer_put_long(&writer, -42);
+    (void)amqp_writer_put_timestamp(&writer, 1000);
+    (void)amqp_writer_put_double(&writer, 0.1);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_put_uint(&writer, 7);
+    (void)amqp_writer_put_ulong(&writer, UINT64_MAX);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_get_length(&writer, &length);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_json_from_amqp(bytes, length, json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    json[json_length] = '\0';
+    ASSERT_ARE_EQUAL(char_ptr, "{\"a\":[null,true,-42,1000,0.1],\"7\":18446744073709551615}", json);
+}
+
+/* Tests_SRS_AMQP_JSON_01_008: [ In the strings written, `"`, `\` and the control characters shall be escaped. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_escapes_strings)
+{
+    // arrange
+    unsigned char bytes[64];
+    AMQP_WRITER writer;
+    size_t length;
+    char json[64];
+    size_t json_length;
+    int result;
+    (void)amqp_writer_init(&writer, bytes, sizeof(bytes));
+    (void)amqp_writer_put_string(&writer, "a\"b\\c\nd\x01");
+    (void)amqp_writer_get_length(&writer, &length);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_json_from_amqp(bytes, length, json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    json[json_length] = '\0';
+    ASSERT_ARE_EQUAL(char_ptr, "\"a\\\"b\\\\c\\nd\\u0001\"", json);
+}
+
+/* Tests_SRS_AMQP_JSON_01_010: [ A binary shall be written as a string holding its base64 encoding. ]*/
+/* Tests_SRS_AMQP_JSON_01_015: [ A described value shall be written as its value, without its descriptor. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_writes_a_described_binary_as_base64)
+{
+    // arrange
+    unsigned char bytes[64];
+    AMQP_WRITER writer;
+    size_t length;
+    char json[64];
+    size_t json_length;
+    int result;
+    (void)amqp_writer_init(&writer, bytes, sizeof(bytes));
+    (void)amqp_writer_begin_described(&writer, 0x75);
+    (void)amqp_writer_put_binary(&writer, "abcd", 4);
+    (void)amqp_writer_get_length(&writer, &length);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_json_from_amqp(bytes, length, json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    json[json_length] = '\0';
+    ASSERT_ARE_EQUAL(char_ptr, "\"YWJjZA==\"", json);
+}
+
+/* Tests_SRS_AMQP_JSON_01_007: [ A float or double that is NaN or infinite shall be written as `null`. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_writes_an_infinite_double_as_null)
+{
+    // arrange
+    unsigned char bytes[] = { 0x82, 0x7F, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    char json[16];
+    size_t json_length;
+    int result;
+
+    // act
+    result = amqp_json_from_amqp(bytes, sizeof(bytes), json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 4, json_length);
+    ASSERT_IS_TRUE(memcmp(json, "null", 4) == 0);
+}
+
+/* Tests_SRS_AMQP_JSON_01_002: [ If `bytes`, `json` or `json_length` is NULL, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_with_NULL_bytes_fails)
+{
+    // arrange
+    char json[16];
+    size_t json_length;
+    int result;
+
+    // act
+    result = amqp_json_from_amqp(NULL, 1, json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQP_JSON_01_003: [ If `bytes` does not hold exactly one well formed AMQP value, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_with_two_values_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x40, 0x40 };
+    char json[16];
+    size_t json_length;
+    int result;
+
+    // act
+    result = amqp_json_from_amqp(bytes, sizeof(bytes), json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQP_JSON_01_004: [ If the JSON text does not fit in `json_size` characters, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_with_a_too_small_json_buffer_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x41 };
+    char json[3];
+    size_t json_length;
+    int result;
+
+    // act
+    result = amqp_json_from_amqp(bytes, sizeof(bytes), json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQP_JSON_01_014: [ If a map key is a list, map, array or described value, `amqp_json_from_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_from_amqp_with_a_list_key_fails)
+{
+    // arrange
+    unsigned char bytes[64];
+    AMQP_WRITER writer;
+    size_t length;
+    char json[64];
+    size_t json_length;
+    int result;
+    (void)amqp_writer_init(&writer, bytes, sizeof(bytes));
+    (void)amqp_writer_begin_map(&writer);
+    (void)amqp_writer_begin_list(&writer);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_put_null(&writer);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_get_length(&writer, &length);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_json_from_amqp(bytes, length, json, sizeof(json), &json_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* amqp_json_to_amqp */
+
+/* Tests_SRS_AMQP_JSON_01_016: [ `amqp_json_to_amqp` shall write the AMQP encoding of the JSON value in `json` to `buffer` with the AMQP writer, set `encoded_length` to its number of bytes and return 0. ]*/
+/* Tests_SRS_AMQP_JSON_01_018: [ An object shall be written as a map with string keys and an array as a list. ]*/
+/* Tests_SRS_AMQP_JSON_01_019: [ A number without fraction or exponent shall be written as a long, or as a ulong when it only fits in one. ]*/
+/* Tests_SRS_AMQP_JSON_01_021: [ A string without escapes shall be written straight from the JSON text. ]*/
+/* Tests_SRS_AMQP_JSON_01_023: [ `true` and `false` shall be written as booleans and `null` as null. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_writes_an_object_with_an_array)
+{
+    // arrange
+    static const char json[] = " { \"a\" : [ 1, true, null ] } ";
+    unsigned char buffer[64];
+    unsigned char expected[64];
+    AMQP_WRITER writer;
+    size_t expected_length;
+    size_t encoded_length;
+    int result;
+    (void)amqp_writer_init(&writer, expected, sizeof(expected));
+    (void)amqp_writer_begin_map(&writer);
+    (void)amqp_writer_put_string(&writer, "a");
+    (void)amqp_writer_begin_list(&writer);
+    (void)amqp_writer_put_long(&writer, 1);
+    (void)amqp_writer_put_boolean(&writer, true);
+    (void)amqp_writer_put_null(&writer);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_get_length(&writer, &expected_length);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, expected_length, encoded_length);
+    ASSERT_IS_TRUE(memcmp(expected, buffer, encoded_length) == 0);
+}
+
+/* Tests_SRS_AMQP_JSON_01_019: [ A number without fraction or exponent shall be written as a long, or as a ulong when it only fits in one. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_writes_a_number_above_the_long_range_as_a_ulong)
+{
+    // arrange
+    static const char json[] = "18446744073709551615";
+    unsigned char buffer[16];
+    size_t encoded_length;
+    int result;
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 9, encoded_length);
+    ASSERT_ARE_EQUAL(uint8_t, 0x80, buffer[0]);
+}
+
+/* Tests_SRS_AMQP_JSON_01_020: [ Any other number shall be written as a double. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_writes_a_fraction_as_a_double)
+{
+    // arrange
+    static const char json[] = "1.5";
+    unsigned char buffer[16];
+    unsigned char expected[] = { 0x82, 0x3F, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    size_t encoded_length;
+    int result;
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected), encoded_length);
+    ASSERT_IS_TRUE(memcmp(expected, buffer, encoded_length) == 0);
+}
+
+/* Tests_SRS_AMQP_JSON_01_022: [ `\u` escapes, surrogate pairs included, shall be unescaped to their UTF-8 encoding. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_unescapes_a_string)
+{
+    // arrange
+    static const char json[] = "\"a\\n\\u00e9\\ud83d\\ude00\"";
+    unsigned char buffer[32];
+    unsigned char expected[] = { 0xA1, 0x08, 'a', '\n', 0xC3, 0xA9, 0xF0, 0x9F, 0x98, 0x80 };
+    size_t encoded_length;
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected), encoded_length);
+    ASSERT_IS_TRUE(memcmp(expected, buffer, encoded_length) == 0);
+}
+
+/* Tests_SRS_AMQP_JSON_01_026: [ If allocating the memory to unescape a string fails, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_unescape_buffer_fails_amqp_json_to_amqp_fails)
+{
+    // arrange
+    static const char json[] = "\"a\\n\"";
+    unsigned char buffer[32];
+    size_t encoded_length;
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_JSON_01_017: [ If `json`, `buffer` or `encoded_length` is NULL, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_with_NULL_json_fails)
+{
+    // arrange
+    unsigned char buffer[16];
+    size_t encoded_length;
+    int result;
+
+    // act
+    result = amqp_json_to_amqp(NULL, 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_with_a_trailing_comma_fails)
+{
+    // arrange
+    static const char json[] = "[1,]";
+    unsigned char buffer[32];
+    size_t encoded_length;
+    int result;
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQP_JSON_01_024: [ If the JSON text is not valid JSON, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_with_characters_after_the_value_fails)
+{
+    // arrange
+    static const char json[] = "{} x";
+    unsigned char buffer[32];
+    size_t encoded_length;
+    int result;
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQP_JSON_01_025: [ If arrays and objects are nested more than `AMQP_WRITER_MAX_DEPTH` deep, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_nested_too_deep_fails)
+{
+    // arrange
+    static const char json[] = "[[[[[[[[[1]]]]]]]]]";
+    unsigned char buffer[128];
+    size_t encoded_length;
+    int result;
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQP_JSON_01_027: [ If the encoding does not fit in `buffer_size` bytes, `amqp_json_to_amqp` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_json_to_amqp_with_a_too_small_buffer_fails)
+{
+    // arrange
+    static const char json[] = "\"abcdef\"";
+    unsigned char buffer[4];
+    size_t encoded_length;
+    int result;
+
+    // act
+    result = amqp_json_to_amqp(json, sizeof(json) - 1, buffer, sizeof(buffer), &encoded_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+END_TEST_SUITE(amqp_json_ut)
@@ -0,0 +1,1252 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umock_c_negative_tests.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/amqp_management.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/amqp_management_mux.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static SESSION_HANDLE test_session_handle = (SESSION_HANDLE)0x4200;
+static AMQP_MANAGEMENT_HANDLE test_amqp_management_handle = (AMQP_MANAGEMENT_HANDLE)0x4201;
+static MESSAGE_HANDLE test_message = (MESSAGE_HANDLE)0x4202;
+static MESSAGE_HANDLE test_response_message = (MESSAGE_HANDLE)0x4203;
+static ON_AMQP_MANAGEMENT_OPEN_COMPLETE saved_on_amqp_management_open_complete;
+static void* saved_on_amqp_management_open_complete_context;
+static ON_AMQP_MANAGEMENT_ERROR saved_on_amqp_management_error;
+static void* saved_on_amqp_management_error_context;
+static ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE saved_on_execute_operation_complete;
+static void* saved_on_execute_operation_complete_context;
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_amqp_management_open_complete, void*, context, AMQP_MANAGEMENT_OPEN_RESULT, open_result);
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_amqp_management_error, void*, context);
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_execute_operation_complete, void*, context, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT, execute_operation_result, unsigned int, status_code, const char*, status_description, MESSAGE_HANDLE, message);
+MOCK_FUNCTION_END();
+
+static int my_amqp_management_open_async(AMQP_MANAGEMENT_HANDLE amqp_management, ON_AMQP_MANAGEMENT_OPEN_COMPLETE on_amqp_management_open_complete, void* on_amqp_management_open_complete_context, ON_AMQP_MANAGEMENT_ERROR on_amqp_management_error, void* on_amqp_management_error_context)
+{
+    (void)amqp_management;
+    saved_on_amqp_management_open_complete = on_amqp_management_open_complete;
+    saved_on_amqp_management_open_complete_context = on_amqp_management_open_complete_context;
+    saved_on_amqp_management_error = on_amqp_management_error;
+    saved_on_amqp_management_error_context = on_amqp_management_error_context;
+    return 0;
+}
+
+static int my_amqp_management_execute_operation_async(AMQP_MANAGEMENT_HANDLE amqp_management, const char* operation, const char* type, const char* locales, MESSAGE_HANDLE message, ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE on_execute_operation_complete, void* on_execute_operation_complete_context)
+{
+    (void)amqp_management;
+    (void)operation;
+    (void)type;
+    (void)locales;
+    (void)message;
+    saved_on_execute_operation_complete = on_execute_operation_complete;
+    saved_on_execute_operation_complete_context = on_execute_operation_complete_context;
+    return 0;
+}
+
+/* the mux keeps several lists (the clients and the pending operations of each client), so the list fakes are a real list */
+typedef struct TEST_LIST_ITEM_TAG
+{
+    const void* value;
+    struct TEST_LIST_ITEM_TAG* next;
+} TEST_LIST_ITEM;
+
+typedef struct TEST_LIST_TAG
+{
+    TEST_LIST_ITEM* head;
+} TEST_LIST;
+
+static SINGLYLINKEDLIST_HANDLE my_singlylinkedlist_create(void)
+{
+    TEST_LIST* list = (TEST_LIST*)malloc(sizeof(TEST_LIST));
+    list->head = NULL;
+    return (SINGLYLINKEDLIST_HANDLE)list;
+}
+
+static void my_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list)
+{
+    TEST_LIST* test_list = (TEST_LIST*)list;
+    while (test_list->head != NULL)
+    {
+        TEST_LIST_ITEM* next = test_list->head->next;
+        free(test_list->head);
+        test_list->head = next;
+    }
+    free(test_list);
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
+{
+    TEST_LIST* test_list = (TEST_LIST*)list;
+    TEST_LIST_ITEM** last = &test_list->head;
+    TEST_LIST_ITEM* new_item = (TEST_LIST_ITEM*)malloc(sizeof(TEST_LIST_ITEM));
+    new_item->value = item;
+    new_item->next = NULL;
+    while (*last != NULL)
+    {
+        last = &(*last)->next;
+    }
+    *last = new_item;
+    return (LIST_ITEM_HANDLE)new_item;
+}
+
+static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
+{
+    TEST_LIST* test_list = (TEST_LIST*)list;
+    TEST_LIST_ITEM** current = &test_list->head;
+    int result = __LINE__;
+    while (*current != NULL)
+    {
+        if (*current == (TEST_LIST_ITEM*)item)
+        {
+            *current = (*current)->next;
+            free(item);
+            result = 0;
+            break;
+        }
+        current = &(*current)->next;
+    }
+    return result;
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
+{
+    return (LIST_ITEM_HANDLE)((TEST_LIST*)list)->head;
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle)
+{
+    return (LIST_ITEM_HANDLE)((TEST_LIST_ITEM*)item_handle)->next;
+}
+
+static const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
+{
+    return ((TEST_LIST_ITEM*)item_handle)->value;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+TEST_DEFINE_ENUM_TYPE(AMQP_MANAGEMENT_OPEN_RESULT, AMQP_MANAGEMENT_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(AMQP_MANAGEMENT_OPEN_RESULT, AMQP_MANAGEMENT_OPEN_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT_VALUES);
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static AMQP_MANAGEMENT_MUX_HANDLE create_mux(void)
+{
+    return amqp_management_mux_create(test_session_handle, "$management");
+}
+
+/* opens client_1 (contexts 0x4242/0x4243) and client_2 (contexts 0x4244/0x4245) on the shared links */
+static void open_two_clients(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1, AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2)
+{
+    (void)amqp_management_mux_client_open_async(client_1, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    (void)amqp_management_mux_client_open_async(client_2, test_on_amqp_management_open_complete, (void*)0x4244, test_on_amqp_management_error, (void*)0x4245);
+}
+
+BEGIN_TEST_SUITE(amqp_management_mux_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_RETURN(amqp_management_create, test_amqp_management_handle);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_management_open_async, my_amqp_management_open_async);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_management_execute_operation_async, my_amqp_management_execute_operation_async);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, my_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, my_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, my_singlylinkedlist_get_next_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, my_singlylinkedlist_item_get_value);
+    REGISTER_TYPE(AMQP_MANAGEMENT_OPEN_RESULT, AMQP_MANAGEMENT_OPEN_RESULT);
+    REGISTER_TYPE(AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT);
+
+    REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_MANAGEMENT_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_AMQP_MANAGEMENT_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_AMQP_MANAGEMENT_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_AMQP_MANAGEMENT_EXECUTE_OPERATION_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* amqp_management_mux_create */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_001: [ `amqp_management_mux_create` shall create the AMQP management instance shared by all clients by calling `amqp_management_create` with `session` and `management_node`, and on success return a non-NULL handle to the mux. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_003: [ `amqp_management_mux_create` shall create the list of clients by calling `singlylinkedlist_create`. ]*/
+TEST_FUNCTION(amqp_management_mux_create_returns_a_valid_handle)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(amqp_management_create(test_session_handle, "$management"));
+
+    // act
+    amqp_management_mux = amqp_management_mux_create(test_session_handle, "$management");
+
+    // assert
+    ASSERT_IS_NOT_NULL(amqp_management_mux);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_002: [ If `session` or `management_node` is NULL, `amqp_management_mux_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_management_mux_create_with_NULL_session_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux;
+
+    // act
+    amqp_management_mux = amqp_management_mux_create(NULL, "$management");
+
+    // assert
+    ASSERT_IS_NULL(amqp_management_mux);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_002: [ If `session` or `management_node` is NULL, `amqp_management_mux_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_management_mux_create_with_NULL_management_node_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux;
+
+    // act
+    amqp_management_mux = amqp_management_mux_create(test_session_handle, NULL);
+
+    // assert
+    ASSERT_IS_NULL(amqp_management_mux);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_004: [ If any error occurs, `amqp_management_mux_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_amqp_management_mux_create_fails_then_amqp_management_mux_create_fails)
+{
+    // arrange
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(amqp_management_create(test_session_handle, "$management"))
+        .SetFailReturn(NULL);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        char tmp_msg[128];
+        AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux;
+        (void)sprintf(tmp_msg, "Failure in test %u/%u", (unsigned int)(index + 1), (unsigned int)count);
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        amqp_management_mux = amqp_management_mux_create(test_session_handle, "$management");
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(amqp_management_mux, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+/* amqp_management_mux_destroy */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_005: [ `amqp_management_mux_destroy` shall free the mux and destroy the shared AMQP management instance by calling `amqp_management_destroy`. ]*/
+TEST_FUNCTION(amqp_management_mux_destroy_frees_all_resources)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_destroy(test_amqp_management_handle));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqp_management_mux_destroy(amqp_management_mux);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_006: [ If `amqp_management_mux` is NULL, `amqp_management_mux_destroy` shall do nothing. ]*/
+TEST_FUNCTION(amqp_management_mux_destroy_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    amqp_management_mux_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_007: [ If clients of the mux still exist, freeing the mux shall be deferred until the last of them is destroyed. ]*/
+TEST_FUNCTION(amqp_management_mux_destroy_with_a_client_defers_freeing_until_the_client_is_destroyed)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_destroy(test_amqp_management_handle));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqp_management_mux_destroy(amqp_management_mux);
+    amqp_management_mux_client_destroy(client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_management_mux_set_trace */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_008: [ `amqp_management_mux_set_trace` shall call `amqp_management_set_trace` on the shared AMQP management instance. ]*/
+TEST_FUNCTION(amqp_management_mux_set_trace_sets_the_trace_on_the_shared_instance)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_set_trace(test_amqp_management_handle, true));
+
+    // act
+    amqp_management_mux_set_trace(amqp_management_mux, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_009: [ If `amqp_management_mux` is NULL, `amqp_management_mux_set_trace` shall do nothing. ]*/
+TEST_FUNCTION(amqp_management_mux_set_trace_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    amqp_management_mux_set_trace(NULL, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_management_mux_set_override_status_code_key_name */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_010: [ The override key names shall be set on the shared AMQP management instance by calling `amqp_management_set_override_status_code_key_name` and `amqp_management_set_override_status_description_key_name`, returning what they return. ]*/
+TEST_FUNCTION(amqp_management_mux_set_override_status_code_key_name_sets_the_key_name_on_the_shared_instance)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_set_override_status_code_key_name(test_amqp_management_handle, "status-code"));
+
+    // act
+    result = amqp_management_mux_set_override_status_code_key_name(amqp_management_mux, "status-code");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_010: [ The override key names shall be set on the shared AMQP management instance by calling `amqp_management_set_override_status_code_key_name` and `amqp_management_set_override_status_description_key_name`, returning what they return. ]*/
+TEST_FUNCTION(when_amqp_management_set_override_status_description_key_name_fails_then_amqp_management_mux_set_override_status_description_key_name_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_set_override_status_description_key_name(test_amqp_management_handle, "status-description"))
+        .SetReturn(1);
+
+    // act
+    result = amqp_management_mux_set_override_status_description_key_name(amqp_management_mux, "status-description");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_011: [ If `amqp_management_mux` is NULL, setting an override key name shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_set_override_status_code_key_name_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_management_mux_set_override_status_code_key_name(NULL, "status-code");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_management_mux_client_create */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_012: [ `amqp_management_mux_client_create` shall create a CLOSED client of the mux, add it to the list of clients by calling `singlylinkedlist_add` and on success return a non-NULL handle to it. ]*/
+TEST_FUNCTION(amqp_management_mux_client_create_returns_a_valid_handle)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    client = amqp_management_mux_client_create(amqp_management_mux);
+
+    // assert
+    ASSERT_IS_NOT_NULL(client);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_013: [ If `amqp_management_mux` is NULL or is being destroyed, `amqp_management_mux_client_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_management_mux_client_create_with_NULL_mux_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client;
+
+    // act
+    client = amqp_management_mux_client_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(client);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_013: [ If `amqp_management_mux` is NULL or is being destroyed, `amqp_management_mux_client_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_management_mux_client_create_after_the_mux_destroy_was_requested_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1 = amqp_management_mux_client_create(amqp_management_mux);
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2;
+    amqp_management_mux_destroy(amqp_management_mux);
+    umock_c_reset_all_calls();
+
+    // act
+    client_2 = amqp_management_mux_client_create(amqp_management_mux);
+
+    // assert
+    ASSERT_IS_NULL(client_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client_1);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_014: [ If any error occurs, `amqp_management_mux_client_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_amqp_management_mux_client_create_fails_then_amqp_management_mux_client_create_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(NULL);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        char tmp_msg[128];
+        AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client;
+        (void)sprintf(tmp_msg, "Failure in test %u/%u", (unsigned int)(index + 1), (unsigned int)count);
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        client = amqp_management_mux_client_create(amqp_management_mux);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(client, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* amqp_management_mux_client_destroy */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_015: [ `amqp_management_mux_client_destroy` shall close the client if it is not CLOSED, remove it from the list of clients by calling `singlylinkedlist_remove` and free it. ]*/
+TEST_FUNCTION(amqp_management_mux_client_destroy_on_an_open_client_closes_and_frees_it)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_close(test_amqp_management_handle));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqp_management_mux_client_destroy(client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_016: [ If `client` is NULL, `amqp_management_mux_client_destroy` shall do nothing. ]*/
+TEST_FUNCTION(amqp_management_mux_client_destroy_with_NULL_client_does_nothing)
+{
+    // arrange
+
+    // act
+    amqp_management_mux_client_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_management_mux_client_open_async */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_019: [ On success, `amqp_management_mux_client_open_async` shall return 0. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_022: [ The first client opening shall open the shared AMQP management instance by calling `amqp_management_open_async`, the other clients opening waiting for it to complete. ]*/
+TEST_FUNCTION(amqp_management_mux_client_open_async_for_the_first_client_opens_the_shared_instance)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_open_async(test_amqp_management_handle, IGNORED_PTR_ARG, amqp_management_mux, IGNORED_PTR_ARG, amqp_management_mux));
+
+    // act
+    result = amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_022: [ The first client opening shall open the shared AMQP management instance by calling `amqp_management_open_async`, the other clients opening waiting for it to complete. ]*/
+TEST_FUNCTION(amqp_management_mux_client_open_async_while_the_shared_instance_is_opening_does_not_open_it_again)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1 = amqp_management_mux_client_create(amqp_management_mux);
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2 = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client_1, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_mux_client_open_async(client_2, test_on_amqp_management_open_complete, (void*)0x4244, test_on_amqp_management_error, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client_1);
+    amqp_management_mux_client_destroy(client_2);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_017: [ When the AMQP management open completes, `on_amqp_management_open_complete` shall be called for every OPENING client with the open result. ]*/
+TEST_FUNCTION(when_the_shared_instance_open_completes_all_opening_clients_are_indicated)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1 = amqp_management_mux_client_create(amqp_management_mux);
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2 = amqp_management_mux_client_create(amqp_management_mux);
+    (void)amqp_management_mux_client_open_async(client_1, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    (void)amqp_management_mux_client_open_async(client_2, test_on_amqp_management_open_complete, (void*)0x4244, test_on_amqp_management_error, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_amqp_management_open_complete((void*)0x4242, AMQP_MANAGEMENT_OPEN_OK));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_amqp_management_open_complete((void*)0x4244, AMQP_MANAGEMENT_OPEN_OK));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client_1);
+    amqp_management_mux_client_destroy(client_2);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_024: [ If the shared AMQP management instance is already OPEN, the client shall become OPEN and `on_amqp_management_open_complete` shall be called with `AMQP_MANAGEMENT_OPEN_OK` before `amqp_management_mux_client_open_async` returns. ]*/
+TEST_FUNCTION(amqp_management_mux_client_open_async_when_the_shared_instance_is_open_completes_immediately)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1 = amqp_management_mux_client_create(amqp_management_mux);
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2 = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client_1, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_amqp_management_open_complete((void*)0x4244, AMQP_MANAGEMENT_OPEN_OK));
+
+    // act
+    result = amqp_management_mux_client_open_async(client_2, test_on_amqp_management_open_complete, (void*)0x4244, test_on_amqp_management_error, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client_1);
+    amqp_management_mux_client_destroy(client_2);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_020: [ If `client`, `on_amqp_management_open_complete` or `on_amqp_management_error` is NULL, `amqp_management_mux_client_open_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_client_open_async_with_NULL_client_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_management_mux_client_open_async(NULL, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_020: [ If `client`, `on_amqp_management_open_complete` or `on_amqp_management_error` is NULL, `amqp_management_mux_client_open_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_client_open_async_with_NULL_callbacks_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result_1;
+    int result_2;
+    umock_c_reset_all_calls();
+
+    // act
+    result_1 = amqp_management_mux_client_open_async(client, NULL, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    result_2 = amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, NULL, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_021: [ If the client is not CLOSED, `amqp_management_mux_client_open_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_client_open_async_on_an_opening_client_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_026: [ If `amqp_management_open_async` fails, `amqp_management_mux_client_open_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_amqp_management_open_async_fails_then_amqp_management_mux_client_open_async_fails_and_the_client_can_be_opened_again)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result_1;
+    int result_2;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_open_async(test_amqp_management_handle, IGNORED_PTR_ARG, amqp_management_mux, IGNORED_PTR_ARG, amqp_management_mux))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(amqp_management_open_async(test_amqp_management_handle, IGNORED_PTR_ARG, amqp_management_mux, IGNORED_PTR_ARG, amqp_management_mux));
+
+    // act
+    result_1 = amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    result_2 = amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_023: [ If the shared AMQP management instance is in error, it shall be closed by calling `amqp_management_close` and opened again. ]*/
+TEST_FUNCTION(amqp_management_mux_client_open_async_after_an_error_reopens_the_shared_instance)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1 = amqp_management_mux_client_create(amqp_management_mux);
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2 = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    open_two_clients(client_1, client_2);
+    saved_on_amqp_management_error(saved_on_amqp_management_error_context);
+    (void)amqp_management_mux_client_close(client_1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_close(test_amqp_management_handle));
+    STRICT_EXPECTED_CALL(amqp_management_open_async(test_amqp_management_handle, IGNORED_PTR_ARG, amqp_management_mux, IGNORED_PTR_ARG, amqp_management_mux));
+
+    // act
+    result = amqp_management_mux_client_open_async(client_1, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client_1);
+    amqp_management_mux_client_destroy(client_2);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* on_amqp_management_error */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_018: [ When the AMQP management reports an error, every OPENING client shall be indicated with `on_amqp_management_open_complete` and `AMQP_MANAGEMENT_OPEN_ERROR` and every OPEN client with `on_amqp_management_error`. ]*/
+TEST_FUNCTION(when_the_shared_instance_reports_an_error_all_open_clients_are_indicated)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1 = amqp_management_mux_client_create(amqp_management_mux);
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2 = amqp_management_mux_client_create(amqp_management_mux);
+    open_two_clients(client_1, client_2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4243));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4245));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_amqp_management_error(saved_on_amqp_management_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client_1);
+    amqp_management_mux_client_destroy(client_2);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_018: [ When the AMQP management reports an error, every OPENING client shall be indicated with `on_amqp_management_open_complete` and `AMQP_MANAGEMENT_OPEN_ERROR` and every OPEN client with `on_amqp_management_error`. ]*/
+TEST_FUNCTION(when_the_shared_instance_reports_an_error_while_opening_the_opening_clients_get_an_open_error)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_amqp_management_open_complete((void*)0x4242, AMQP_MANAGEMENT_OPEN_ERROR));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_amqp_management_error(saved_on_amqp_management_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* amqp_management_mux_client_close */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_027: [ On success, `amqp_management_mux_client_close` shall return 0. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_030: [ When the last open client closes, the shared AMQP management instance shall be closed by calling `amqp_management_close`. ]*/
+TEST_FUNCTION(amqp_management_mux_client_close_for_the_last_open_client_closes_the_shared_instance)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_close(test_amqp_management_handle));
+
+    // act
+    result = amqp_management_mux_client_close(client);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_030: [ When the last open client closes, the shared AMQP management instance shall be closed by calling `amqp_management_close`. ]*/
+TEST_FUNCTION(amqp_management_mux_client_close_while_other_clients_are_open_leaves_the_shared_instance_open)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_1 = amqp_management_mux_client_create(amqp_management_mux);
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client_2 = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    open_two_clients(client_1, client_2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_management_mux_client_close(client_1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client_1);
+    amqp_management_mux_client_destroy(client_2);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_029: [ If the client is OPENING, `on_amqp_management_open_complete` shall be called with `AMQP_MANAGEMENT_OPEN_CANCELLED`. ]*/
+TEST_FUNCTION(amqp_management_mux_client_close_while_opening_indicates_open_cancelled)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_amqp_management_open_complete((void*)0x4242, AMQP_MANAGEMENT_OPEN_CANCELLED));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_close(test_amqp_management_handle));
+
+    // act
+    result = amqp_management_mux_client_close(client);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_028: [ All pending operations of the client shall be indicated complete with `AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED`, the operations themselves being left to complete on the shared links. ]*/
+TEST_FUNCTION(amqp_management_mux_client_close_indicates_the_pending_operations_as_instance_closed)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    (void)amqp_management_mux_client_execute_operation_async(client, "READ", "some_type", NULL, test_message, test_on_execute_operation_complete, (void*)0x4246);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_execute_operation_complete((void*)0x4246, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED, 0, NULL, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_close(test_amqp_management_handle));
+
+    // act
+    result = amqp_management_mux_client_close(client);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_execute_operation_complete(saved_on_execute_operation_complete_context, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED, 0, NULL, NULL);
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_031: [ If `client` is NULL, `amqp_management_mux_client_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_client_close_with_NULL_client_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_management_mux_client_close(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_032: [ If the client is not open, `amqp_management_mux_client_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_client_close_on_a_closed_client_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_mux_client_close(client);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* amqp_management_mux_client_execute_operation_async */
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_033: [ `amqp_management_mux_client_execute_operation_async` shall execute the operation on the shared AMQP management instance by calling `amqp_management_execute_operation_async` with `operation`, `type`, `locales` and `message`. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_037: [ The operation shall be added to the pending operations of the client by calling `singlylinkedlist_add`. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_038: [ On success, `amqp_management_mux_client_execute_operation_async` shall return 0. ]*/
+TEST_FUNCTION(amqp_management_mux_client_execute_operation_async_executes_the_operation_on_the_shared_instance)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_execute_operation_async(test_amqp_management_handle, "READ", "some_type", "en-US", test_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_management_mux_client_execute_operation_async(client, "READ", "some_type", "en-US", test_message, test_on_execute_operation_complete, (void*)0x4246);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    saved_on_execute_operation_complete(saved_on_execute_operation_complete_context, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED, 0, NULL, NULL);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_025: [ When the AMQP management completes an operation of an open client, the `on_execute_operation_complete` given by the client shall be called with the result, status code, status description and message of the operation. ]*/
+TEST_FUNCTION(when_the_shared_instance_completes_an_operation_the_client_callback_is_called)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    (void)amqp_management_mux_client_execute_operation_async(client, "READ", "some_type", NULL, test_message, test_on_execute_operation_complete, (void*)0x4246);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_execute_operation_complete((void*)0x4246, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, "OK", test_response_message));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_execute_operation_complete(saved_on_execute_operation_complete_context, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, "OK", test_response_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_028: [ All pending operations of the client shall be indicated complete with `AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED`, the operations themselves being left to complete on the shared links. ]*/
+TEST_FUNCTION(when_the_shared_instance_completes_an_operation_of_a_closed_client_the_operation_is_only_freed)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    (void)amqp_management_mux_client_execute_operation_async(client, "READ", "some_type", NULL, test_message, test_on_execute_operation_complete, (void*)0x4246);
+    (void)amqp_management_mux_client_close(client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_execute_operation_complete(saved_on_execute_operation_complete_context, AMQP_MANAGEMENT_EXECUTE_OPERATION_INSTANCE_CLOSED, 0, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_034: [ If `client` or `on_execute_operation_complete` is NULL, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_client_execute_operation_async_with_NULL_client_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_management_mux_client_execute_operation_async(NULL, "READ", "some_type", NULL, test_message, test_on_execute_operation_complete, (void*)0x4246);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_035: [ If the client is not OPEN, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_mux_client_execute_operation_async_while_opening_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int result;
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_mux_client_execute_operation_async(client, "READ", "some_type", NULL, test_message, test_on_execute_operation_complete, (void*)0x4246);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_MUX_01_036: [ If any error occurs, `amqp_management_mux_client_execute_operation_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_amqp_management_mux_client_execute_operation_async_fails_then_it_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_MUX_HANDLE amqp_management_mux = create_mux();
+    AMQP_MANAGEMENT_MUX_CLIENT_HANDLE client = amqp_management_mux_client_create(amqp_management_mux);
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    (void)amqp_management_mux_client_open_async(client, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(amqp_management_execute_operation_async(test_amqp_management_handle, "READ", "some_type", NULL, test_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(1);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        char tmp_msg[128];
+        int result;
+        (void)sprintf(tmp_msg, "Failure in test %u/%u", (unsigned int)(index + 1), (unsigned int)count);
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        result = amqp_management_mux_client_execute_operation_async(client, "READ", "some_type", NULL, test_message, test_on_execute_operation_complete, (void*)0x4246);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+    amqp_management_mux_client_destroy(client);
+    amqp_management_mux_destroy(amqp_management_mux);
+}
+
+END_TEST_SUITE(amqp_management_mux_ut)
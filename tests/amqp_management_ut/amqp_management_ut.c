@@ -53,6 +53,8 @@ static int my_mallocAndStrcpy_s(char** destination, const char* source)
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/async_operation.h"
 #include "azure_uamqp_c/amqp_definitions_message_id_ulong.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_uamqp_c/timer_wheel.h"
 
 #undef ENABLE_MOCKS
 
@@ -81,6 +83,10 @@ static AMQP_VALUE test_correlation_id_value = (AMQP_VALUE)0x430A;
 static AMQP_VALUE test_application_properties_map = (AMQP_VALUE)0x430B;
 static PROPERTIES_HANDLE test_properties = (PROPERTIES_HANDLE)0x430C;
 static ASYNC_OPERATION_HANDLE test_send_operation = (ASYNC_OPERATION_HANDLE)0x430D;
+static TIMER_WHEEL_HANDLE test_timer_wheel = (TIMER_WHEEL_HANDLE)0x430E;
+static TIMER_WHEEL_TIMER_HANDLE test_timer = (TIMER_WHEEL_TIMER_HANDLE)0x430F;
+static TICK_COUNTER_HANDLE test_tick_counter = (TICK_COUNTER_HANDLE)0x4310;
+static MESSAGE_TEMPLATE_HANDLE test_message_template = (MESSAGE_TEMPLATE_HANDLE)0x4311;
 
 static AMQP_VALUE test_status_code_key = (AMQP_VALUE)0x4400;
 static AMQP_VALUE test_status_code_value = (AMQP_VALUE)0x4401;
@@ -212,6 +218,8 @@ static ON_MESSAGE_RECEIVED saved_on_message_received;
 static void* saved_on_message_received_context;
 static ON_MESSAGE_SEND_COMPLETE saved_on_message_send_complete;
 static void* saved_on_message_send_complete_context;
+static ON_TIMER_EXPIRED saved_on_timer_expired;
+static void* saved_on_timer_expired_context;
 static MESSAGE_SENDER_STATE messagesender_close_on_message_sender_state_changed_new_state;
 static MESSAGE_SENDER_STATE messagesender_close_on_message_sender_state_changed_previous_state;
 
@@ -264,6 +272,21 @@ static ASYNC_OPERATION_HANDLE my_messagesender_send_async(MESSAGE_SENDER_HANDLE
     return test_send_operation;
 }
 
+static TIMER_WHEEL_TIMER_HANDLE my_timer_wheel_create_timer(TIMER_WHEEL_HANDLE timer_wheel, ON_TIMER_EXPIRED on_timer_expired, void* on_timer_expired_context)
+{
+    (void)timer_wheel;
+    saved_on_timer_expired = on_timer_expired;
+    saved_on_timer_expired_context = on_timer_expired_context;
+    return test_timer;
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = 1000;
+    return 0;
+}
+
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 {
     char temp_str[256];
@@ -330,6 +353,11 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_RETURN(messaging_delivery_rejected, test_delivery_rejected);
     REGISTER_GLOBAL_MOCK_RETURN(messaging_delivery_released, test_delivery_released);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_HOOK(timer_wheel_create_timer, my_timer_wheel_create_timer);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_RETURN(timer_wheel_start_timer, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(async_operation_cancel, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(messagesender_create_message_template, test_message_template);
 
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_MANAGEMENT_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
@@ -347,6 +375,12 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(ON_MESSAGE_SEND_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(message_id_ulong, uint64_t);
     REGISTER_UMOCK_ALIAS_TYPE(ASYNC_OPERATION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TIMER_WHEEL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TIMER_WHEEL_TIMER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_TIMER_EXPIRED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MESSAGE_TEMPLATE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, void*);
 
     /* boo, we need uint_fast32_t in umock */
     REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, uint32_t);
@@ -405,6 +439,7 @@ TEST_FUNCTION_CLEANUP(test_cleanup)
 /* Tests_SRS_AMQP_MANAGEMENT_01_020: [ The `target` argument shall be the value created by calling `messaging_create_target`. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_181: [ `amqp_management_create` shall set the status code key name to be used for parsing the status code to `statusCode`. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_182: [ `amqp_management_create` shall set the status description key name to be used for parsing the status description to `statusDescription`. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_183: [ `amqp_management_create` shall allocate an index of the pending operations keyed by message Id. ]*/
 TEST_FUNCTION(amqp_management_create_returns_a_valid_handle)
 {
     // arrange
@@ -412,6 +447,7 @@ TEST_FUNCTION(amqp_management_create_returns_a_valid_handle)
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "statusCode"));
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "statusDescription"));
     STRICT_EXPECTED_CALL(messaging_create_source("test_node"));
@@ -491,6 +527,7 @@ TEST_FUNCTION(amqp_management_create_with_empty_string_for_management_node_fails
 /* Tests_SRS_AMQP_MANAGEMENT_01_031: [ If `messagesender_create` fails then `amqp_management_create` shall fail and return NULL. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_032: [ If `messagereceiver_create` fails then `amqp_management_create` shall fail and return NULL. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_033: [ If any other error occurs `amqp_management_create` shall fail and return NULL. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_184: [ If allocating memory for the pending operations index fails, `amqp_management_create` shall fail and return NULL. ]*/
 TEST_FUNCTION(when_any_underlying_function_call_fails_amqp_management_create_fails)
 {
     // arrange
@@ -503,6 +540,8 @@ TEST_FUNCTION(when_any_underlying_function_call_fails_amqp_management_create_fai
         .SetFailReturn(NULL);
     STRICT_EXPECTED_CALL(singlylinkedlist_create())
         .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "statusCode"))
         .SetFailReturn(1);
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "statusDescription"))
@@ -562,6 +601,7 @@ TEST_FUNCTION(amqp_management_destroy_frees_all_the_allocated_resources)
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "statusCode"));
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "statusDescription"));
     STRICT_EXPECTED_CALL(messaging_create_source("test_node"));
@@ -581,6 +621,7 @@ TEST_FUNCTION(amqp_management_destroy_frees_all_the_allocated_resources)
     STRICT_EXPECTED_CALL(link_destroy(test_receiver_link));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); // status description key name
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); // status code key name
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); // pending operation index
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -1966,6 +2007,7 @@ TEST_FUNCTION(when_obtaining_the_list_item_payload_fails_an_error_is_indicated_t
 }
 
 /* Tests_SRS_AMQP_MANAGEMENT_01_170: [ If `send_result` is `MESSAGE_SEND_OK`, `on_message_send_complete` shall return. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_199: [ If `send_result` is `MESSAGE_SEND_OK`, `on_message_send_complete` shall obtain the pending operation by calling `singlylinkedlist_item_get_value` and mark its request as sent, so that a timeout no longer cancels the send. ]*/
 TEST_FUNCTION(when_on_send_message_complete_indicates_success_it_returns)
 {
     // arrange
@@ -1980,8 +2022,177 @@ TEST_FUNCTION(when_on_send_message_complete_indicates_success_it_returns)
     (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_message_send_complete(saved_on_message_send_complete_context, MESSAGE_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_190: [ When an operation timeout is set, `amqp_management_execute_operation_async` shall create a timer on the timer wheel by calling `timer_wheel_create_timer` and start it by calling `timer_wheel_start_timer` with a deadline `operation_timeout_ms` after the current time of the tick counter. ]*/
+TEST_FUNCTION(amqp_management_execute_operation_async_with_an_operation_timeout_starts_a_timer)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    (void)amqp_management_open_async(amqp_management, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_message_sender_state_changed(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    saved_on_message_receiver_state_changed(saved_on_message_receiver_state_changed_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_OPENING);
+    (void)amqp_management_set_operation_timeout(amqp_management, test_timer_wheel, test_tick_counter, 5000);
+    umock_c_reset_all_calls();
+
+    setup_calls_for_pending_operation_with_correlation_id(0);
+    STRICT_EXPECTED_CALL(properties_set_message_id(test_properties, test_message_id_value));
+    STRICT_EXPECTED_CALL(message_set_properties(test_cloned_message, test_properties));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_message_id_value));
+    STRICT_EXPECTED_CALL(properties_destroy(test_properties));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_timer, 6000));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(messagesender_send_async(test_message_sender, test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    result = amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_191: [ If creating or starting the timer fails, `amqp_management_execute_operation_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_starting_the_operation_timer_fails_amqp_management_execute_operation_async_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    (void)amqp_management_open_async(amqp_management, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_message_sender_state_changed(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    saved_on_message_receiver_state_changed(saved_on_message_receiver_state_changed_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_OPENING);
+    (void)amqp_management_set_operation_timeout(amqp_management, test_timer_wheel, test_tick_counter, 5000);
+    umock_c_reset_all_calls();
+
+    setup_calls_for_pending_operation_with_correlation_id(0);
+    STRICT_EXPECTED_CALL(properties_set_message_id(test_properties, test_message_id_value));
+    STRICT_EXPECTED_CALL(message_set_properties(test_cloned_message, test_properties));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_message_id_value));
+    STRICT_EXPECTED_CALL(properties_destroy(test_properties));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_timer, 6000))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(timer_wheel_destroy_timer(test_timer));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
     // act
+    result = amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_196: [ When the timeout of an operation waiting for its response expires, the operation shall be removed from the pending operations and its callback shall be called with `AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT`. ]*/
+TEST_FUNCTION(when_the_operation_timer_expires_after_the_request_was_sent_the_operation_completes_with_TIMEOUT)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    (void)amqp_management_open_async(amqp_management, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_message_sender_state_changed(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    saved_on_message_receiver_state_changed(saved_on_message_receiver_state_changed_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_OPENING);
+    (void)amqp_management_set_operation_timeout(amqp_management, test_timer_wheel, test_tick_counter, 5000);
+    (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
     saved_on_message_send_complete(saved_on_message_send_complete_context, MESSAGE_SEND_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_destroy_timer(test_timer));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT, 0, NULL, NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_timer_expired(saved_on_timer_expired_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_195: [ When the timeout of an operation whose request is still being sent expires, the send shall be cancelled by calling `async_operation_cancel` and the operation shall be completed with `AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT` from the resulting `on_message_send_complete`. ]*/
+TEST_FUNCTION(when_the_operation_timer_expires_while_the_request_is_being_sent_the_send_is_cancelled)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    (void)amqp_management_open_async(amqp_management, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_message_sender_state_changed(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    saved_on_message_receiver_state_changed(saved_on_message_receiver_state_changed_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_OPENING);
+    (void)amqp_management_set_operation_timeout(amqp_management, test_timer_wheel, test_tick_counter, 5000);
+    (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_destroy_timer(test_timer));
+    STRICT_EXPECTED_CALL(async_operation_cancel(test_send_operation));
+
+    // act
+    saved_on_timer_expired(saved_on_timer_expired_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_200: [ - If the send was cancelled because the operation timed out, the callback shall be called with `AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT` instead. ]*/
+TEST_FUNCTION(when_a_send_cancelled_by_the_operation_timeout_completes_the_operation_completes_with_TIMEOUT)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    (void)amqp_management_open_async(amqp_management, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_message_sender_state_changed(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    saved_on_message_receiver_state_changed(saved_on_message_receiver_state_changed_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_OPENING);
+    (void)amqp_management_set_operation_timeout(amqp_management, test_timer_wheel, test_tick_counter, 5000);
+    (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+    saved_on_timer_expired(saved_on_timer_expired_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_TIMEOUT, 0, NULL, NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_message_send_complete(saved_on_message_send_complete_context, MESSAGE_SEND_CANCELLED);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2031,7 +2242,7 @@ TEST_FUNCTION(on_message_received_with_NULL_context_does_nothing)
 /* Tests_SRS_AMQP_MANAGEMENT_01_134: [ The status description value shall be extracted from the value found in the map by using `amqpvalue_get_string`. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_127: [ If the operation succeeded the result callback argument shall be `AMQP_MANAGEMENT_EXECUTE_OPERATION_OK`. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_129: [ After calling the callback, the pending operation shall be removed from the pending operations list by calling `singlylinkedlist_remove`. ]*/
-/* Tests_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like AMQP values used as keys shall be freed before exiting the callback. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_131: [ All temporary values like the AMQP values obtained from the response shall be freed before exiting the callback. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_116: [ Each pending operation item value shall be obtained by calling `singlylinkedlist_item_get_value`. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_112: [ `on_message_received` shall check if the correlation Id matches the stored message Id of any pending operation. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_068: [ The correlation-id of the response message MUST be the correlation-id from the request message (if present) ]*/
@@ -2081,7 +2292,6 @@ TEST_FUNCTION(on_message_received_with_a_valid_message_indicates_the_operation_c
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, "my error ...", test_message));
     
@@ -2089,9 +2299,7 @@ TEST_FUNCTION(on_message_received_with_a_valid_message_indicates_the_operation_c
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -2107,7 +2315,7 @@ TEST_FUNCTION(on_message_received_with_a_valid_message_indicates_the_operation_c
 }
 
 /* Tests_SRS_AMQP_MANAGEMENT_01_126: [ If a corresponding correlation Id is found in the pending operations list, the callback associated with the pending operation shall be called. ]*/
-/* Tests_SRS_AMQP_MANAGEMENT_01_115: [ Iterating through the pending operations shall be done by using `singlylinkedlist_get_head_item` and `singlylinkedlist_get_next_item` until the enm of the pending operations singly linked list is reached. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_115: [ The pending operation shall be looked up by correlation Id in the pending operations index. Only when operations that did not fit in the index are pending and the index has no match, iterating through the pending operations shall be done by using `singlylinkedlist_get_head_item` and `singlylinkedlist_get_next_item` until the end of the pending operations singly linked list is reached. ]*/
 TEST_FUNCTION(on_message_received_for_the_second_pending_operation_with_a_valid_message_indicates_the_operation_complete)
 {
     // arrange
@@ -2153,9 +2361,6 @@ TEST_FUNCTION(on_message_received_for_the_second_pending_operation_with_a_valid_
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4245, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, "my error ...", test_message));
 
@@ -2163,9 +2368,7 @@ TEST_FUNCTION(on_message_received_for_the_second_pending_operation_with_a_valid_
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -2455,7 +2658,6 @@ TEST_FUNCTION(when_getting_the_map_value_for_status_code_fails_an_error_is_indic
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4243));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_correlation_id_value));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
@@ -2508,7 +2710,6 @@ TEST_FUNCTION(when_getting_status_code_int_value_fails_an_error_is_indicated)
         .SetReturn(1);
     STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4243));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_correlation_id_value));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
@@ -2562,7 +2763,6 @@ TEST_FUNCTION(when_creating_the_status_description_amqp_value_fails_an_error_is_
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4243));
     STRICT_EXPECTED_CALL(messaging_delivery_released());
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_correlation_id_value));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
@@ -2615,15 +2815,12 @@ TEST_FUNCTION(when_no_description_is_found_NULL_is_indicated_as_description)
         .SetReturn(test_status_description_key);
     STRICT_EXPECTED_CALL(amqpvalue_get_map_value(test_application_properties_map, test_status_description_key))
         .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, NULL, test_message));
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
@@ -2680,7 +2877,6 @@ TEST_FUNCTION(when_getting_the_string_for_the_description_fails_NULL_is_indicate
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description))
         .SetReturn(1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, NULL, test_message));
 
@@ -2688,9 +2884,7 @@ TEST_FUNCTION(when_getting_the_string_for_the_description_fails_NULL_is_indicate
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -2705,12 +2899,12 @@ TEST_FUNCTION(when_getting_the_string_for_the_description_fails_NULL_is_indicate
 }
 
 /* Tests_SRS_AMQP_MANAGEMENT_01_118: [ If no pending operation is found matching the correlation Id, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
-TEST_FUNCTION(when_getting_the_head_item_in_the_list_fails_an_error_is_indicated)
+TEST_FUNCTION(when_no_pending_operation_is_indexed_for_the_correlation_id_an_error_is_indicated)
 {
     // arrange
     AMQP_MANAGEMENT_HANDLE amqp_management;
     AMQP_VALUE result;
-    uint64_t correlation_id = 0;
+    uint64_t correlation_id = 1;
     int32_t status_code = 200;
     const char* test_status_description = "my oh my";
 
@@ -2745,15 +2939,11 @@ TEST_FUNCTION(when_getting_the_head_item_in_the_list_fails_an_error_is_indicated
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle))
-        .SetReturn(NULL);
     STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4243));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -2808,16 +2998,13 @@ TEST_FUNCTION(when_getting_the_list_item_content_fails_an_error_is_indicated)
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4243));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -2831,14 +3018,15 @@ TEST_FUNCTION(when_getting_the_list_item_content_fails_an_error_is_indicated)
     amqp_management_destroy(amqp_management);
 }
 
-/* Tests_SRS_AMQP_MANAGEMENT_01_117: [ If iterating through the pending operations list fails, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_112: [ `on_message_received` shall check if the correlation Id matches the stored message Id of any pending operation. ]*/
 /* Tests_SRS_AMQP_MANAGEMENT_01_118: [ If no pending operation is found matching the correlation Id, an error shall be indicated by calling `on_amqp_management_error` and passing the `on_amqp_management_error_context` to it. ]*/
-TEST_FUNCTION(when_getting_the_next_element_in_the_list_yields_NULL_an_error_is_indicated)
+TEST_FUNCTION(when_the_indexed_pending_operation_has_a_different_message_id_an_error_is_indicated)
 {
     // arrange
     AMQP_MANAGEMENT_HANDLE amqp_management;
     AMQP_VALUE result;
-    uint64_t correlation_id = 1;
+    /* same slot as message id 0 in the initial index */
+    uint64_t correlation_id = 16;
     int32_t status_code = 200;
     const char* test_status_description = "my oh my";
 
@@ -2873,17 +3061,12 @@ TEST_FUNCTION(when_getting_the_next_element_in_the_list_yields_NULL_an_error_is_
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG))
-        .SetReturn(NULL);
     STRICT_EXPECTED_CALL(test_on_amqp_management_error((void*)0x4243));
     STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -2940,7 +3123,6 @@ TEST_FUNCTION(when_removing_the_item_fails_an_error_is_indicated)
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
@@ -2948,9 +3130,7 @@ TEST_FUNCTION(when_removing_the_item_fails_an_error_is_indicated)
     STRICT_EXPECTED_CALL(messaging_delivery_released());
 
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -2966,7 +3146,7 @@ TEST_FUNCTION(when_removing_the_item_fails_an_error_is_indicated)
     amqp_management_destroy(amqp_management);
 }
 
-static void setup_calls_for_response_with_status_code_and_correlation_id(int status_code, uint64_t correlation_id)
+static void setup_calls_for_response_with_status_code_and_correlation_id(int status_code, uint64_t correlation_id, bool is_first_response)
 {
     static const char* test_status_description = "my error ...";
 
@@ -2980,19 +3160,24 @@ static void setup_calls_for_response_with_status_code_and_correlation_id(int sta
         .CopyOutArgumentBuffer_ulong_value(&correlation_id, sizeof(correlation_id));
     STRICT_EXPECTED_CALL(amqpvalue_get_inplace_described_value(test_application_properties))
         .SetReturn(test_application_properties_map);
-    STRICT_EXPECTED_CALL(amqpvalue_create_string("statusCode"))
-        .SetReturn(test_status_code_key);
+    if (is_first_response)
+    {
+        STRICT_EXPECTED_CALL(amqpvalue_create_string("statusCode"))
+            .SetReturn(test_status_code_key);
+    }
     STRICT_EXPECTED_CALL(amqpvalue_get_map_value(test_application_properties_map, test_status_code_key))
         .SetReturn(test_status_code_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_int(test_status_code_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_int_value(&status_code, sizeof(status_code));
-    STRICT_EXPECTED_CALL(amqpvalue_create_string("statusDescription"))
-        .SetReturn(test_status_description_key);
+    if (is_first_response)
+    {
+        STRICT_EXPECTED_CALL(amqpvalue_create_string("statusDescription"))
+            .SetReturn(test_status_description_key);
+    }
     STRICT_EXPECTED_CALL(amqpvalue_get_map_value(test_application_properties_map, test_status_description_key))
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
 }
 
@@ -3013,16 +3198,14 @@ TEST_FUNCTION(on_message_received_with_300_indicates_failure)
     (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
     umock_c_reset_all_calls();
 
-    setup_calls_for_response_with_status_code_and_correlation_id(300, 0);
+    setup_calls_for_response_with_status_code_and_correlation_id(300, 0, true);
 
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_FAILED_BAD_STATUS, 300, "my error ...", test_message));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -3054,16 +3237,14 @@ TEST_FUNCTION(on_message_received_with_199_indicates_failure)
     (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
     umock_c_reset_all_calls();
 
-    setup_calls_for_response_with_status_code_and_correlation_id(199, 0);
+    setup_calls_for_response_with_status_code_and_correlation_id(199, 0, true);
 
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_FAILED_BAD_STATUS, 199, "my error ...", test_message));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -3098,16 +3279,14 @@ TEST_FUNCTION(on_message_received_with_all_valid_codes_indicates_failure)
         (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
         umock_c_reset_all_calls();
 
-        setup_calls_for_response_with_status_code_and_correlation_id(i, i - 201);
+        setup_calls_for_response_with_status_code_and_correlation_id(i, i - 201, (i == 201));
 
         STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, i, "my error ...", test_message));
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
         STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
         STRICT_EXPECTED_CALL(messaging_delivery_accepted());
         STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-        STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
         STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-        STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
         STRICT_EXPECTED_CALL(properties_destroy(test_properties));
         STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -3123,6 +3302,51 @@ TEST_FUNCTION(on_message_received_with_all_valid_codes_indicates_failure)
     amqp_management_destroy(amqp_management);
 }
 
+/* Tests_SRS_AMQP_MANAGEMENT_01_115: [ The pending operation shall be looked up by correlation Id in the pending operations index. Only when operations that did not fit in the index are pending and the index has no match, iterating through the pending operations shall be done by using `singlylinkedlist_get_head_item` and `singlylinkedlist_get_next_item` until the end of the pending operations singly linked list is reached. ]*/
+TEST_FUNCTION(on_message_received_finds_a_pending_operation_after_the_index_has_grown)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    AMQP_VALUE result;
+    uint64_t i;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    (void)amqp_management_open_async(amqp_management, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_message_sender_state_changed(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    saved_on_message_receiver_state_changed(saved_on_message_receiver_state_changed_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_OPENING);
+
+    /* 17 outstanding operations do not fit in the initial index */
+    for (i = 0; i < 17; i++)
+    {
+        umock_c_reset_all_calls();
+        setup_calls_for_pending_operation_with_correlation_id(i);
+        (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)(0x5000 + (size_t)i));
+    }
+
+    umock_c_reset_all_calls();
+
+    setup_calls_for_response_with_status_code_and_correlation_id(200, 16, true);
+
+    STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x5010, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, "my error ...", test_message));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(messaging_delivery_accepted());
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
+    STRICT_EXPECTED_CALL(properties_destroy(test_properties));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
+
+    // act
+    result = saved_on_message_received(saved_on_message_received_context, test_message);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, test_delivery_accepted, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
 /* on_message_sender_state_changed */
 
 /* Tests_SRS_AMQP_MANAGEMENT_01_137: [ When `on_message_sender_state_changed` is called with NULL `context`, it shall do nothing. ]*/
@@ -4225,7 +4449,6 @@ TEST_FUNCTION(when_amqp_management_set_override_status_code_key_name_is_called_t
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, "my error ...", test_message));
 
@@ -4233,9 +4456,7 @@ TEST_FUNCTION(when_amqp_management_set_override_status_code_key_name_is_called_t
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -4250,6 +4471,40 @@ TEST_FUNCTION(when_amqp_management_set_override_status_code_key_name_is_called_t
     amqp_management_destroy(amqp_management);
 }
 
+/* Tests_SRS_AMQP_MANAGEMENT_01_120: [ An AMQP value used to lookup the status code shall be created by calling `amqpvalue_create_string` with the status code key name (`statusCode`) as argument. The value shall be created on the first response and reused until the status code key name is changed. ]*/
+TEST_FUNCTION(amqp_management_set_override_status_code_key_name_after_a_response_destroys_the_status_code_key)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    (void)amqp_management_open_async(amqp_management, test_on_amqp_management_open_complete, (void*)0x4242, test_on_amqp_management_error, (void*)0x4243);
+    saved_on_message_sender_state_changed(saved_on_message_sender_state_changed_context, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    saved_on_message_receiver_state_changed(saved_on_message_receiver_state_changed_context, MESSAGE_RECEIVER_STATE_OPEN, MESSAGE_RECEIVER_STATE_OPENING);
+    umock_c_reset_all_calls();
+    setup_calls_for_pending_operation_with_correlation_id(0);
+    (void)amqp_management_execute_operation_async(amqp_management, "some_operation", "some_type", "en-US", test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+    umock_c_reset_all_calls();
+    setup_calls_for_response_with_status_code_and_correlation_id(200, 0, true);
+    (void)saved_on_message_received(saved_on_message_received_context, test_message);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "xxx"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
+
+    // act
+    result = amqp_management_set_override_status_code_key_name(amqp_management, "xxx");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
 /* amqp_management_set_override_status_description_key_name */
 
 /* Tests_SRS_AMQP_MANAGEMENT_01_174: [ `amqp_management_set_override_status_description_key_name` shall set the status description key name used to parse the status description from the reply messages to `over ride_status_description_key_name`.]*/
@@ -4380,7 +4635,6 @@ TEST_FUNCTION(when_amqp_management_set_override_status_description_key_name_is_c
         .SetReturn(test_status_description_value);
     STRICT_EXPECTED_CALL(amqpvalue_get_string(test_status_description_value, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer_string_value(&test_status_description, sizeof(test_status_description));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
     STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_amqp_management_execute_operation_complete((void*)0x4244, AMQP_MANAGEMENT_EXECUTE_OPERATION_OK, 200, "my error ...", test_message));
 
@@ -4388,9 +4642,7 @@ TEST_FUNCTION(when_amqp_management_set_override_status_description_key_name_is_c
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(test_singlylinkedlist_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(messaging_delivery_accepted());
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_description_key));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_value));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_status_code_key));
     STRICT_EXPECTED_CALL(properties_destroy(test_properties));
     STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
 
@@ -4405,4 +4657,347 @@ TEST_FUNCTION(when_amqp_management_set_override_status_description_key_name_is_c
     amqp_management_destroy(amqp_management);
 }
 
+/* amqp_management_set_operation_timeout */
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_185: [ `amqp_management_set_operation_timeout` shall set the timeout applied to the operations started after it by `amqp_management_execute_operation_async`, measured with `tick_counter` and expired by `timer_wheel`. A timeout of 0 disables the operation timeout. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_187: [ On success, `amqp_management_set_operation_timeout` shall return 0. ]*/
+TEST_FUNCTION(amqp_management_set_operation_timeout_succeeds)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_set_operation_timeout(amqp_management, test_timer_wheel, test_tick_counter, 5000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_186: [ If `amqp_management` is NULL, or `operation_timeout_ms` is not 0 and `timer_wheel` or `tick_counter` is NULL, `amqp_management_set_operation_timeout` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_set_operation_timeout_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_management_set_operation_timeout(NULL, test_timer_wheel, test_tick_counter, 5000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_186: [ If `amqp_management` is NULL, or `operation_timeout_ms` is not 0 and `timer_wheel` or `tick_counter` is NULL, `amqp_management_set_operation_timeout` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_set_operation_timeout_with_NULL_timer_wheel_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_set_operation_timeout(amqp_management, NULL, test_tick_counter, 5000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_185: [ `amqp_management_set_operation_timeout` shall set the timeout applied to the operations started after it by `amqp_management_execute_operation_async`, measured with `tick_counter` and expired by `timer_wheel`. A timeout of 0 disables the operation timeout. ]*/
+TEST_FUNCTION(amqp_management_set_operation_timeout_with_0_and_NULL_timer_wheel_succeeds)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_set_operation_timeout(amqp_management, NULL, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* amqp_management_set_max_outstanding_operations */
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_202: [ `amqp_management_set_max_outstanding_operations` shall set the maximum number of operations waiting for their response, 0 meaning no limit. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_204: [ The first time a non-zero `max_outstanding_operations` is set, `amqp_management_set_max_outstanding_operations` shall create the queue of operations waiting to be sent by calling `singlylinkedlist_create`. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_207: [ On success, `amqp_management_set_max_outstanding_operations` shall return 0. ]*/
+TEST_FUNCTION(amqp_management_set_max_outstanding_operations_creates_the_queue)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist_handle));
+
+    // act
+    result = amqp_management_set_max_outstanding_operations(amqp_management, 4);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_205: [ If `singlylinkedlist_create` fails, `amqp_management_set_max_outstanding_operations` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_creating_the_queue_fails_amqp_management_set_max_outstanding_operations_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    int result;
+
+    amqp_management = amqp_management_create(test_session_handle, "test_node");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetReturn(NULL);
+
+    // act
+    result = amqp_management_set_max_outstanding_operations(amqp_management, 4);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_203: [ If `amqp_management` is NULL, `amqp_management_set_max_outstanding_operations` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_set_max_outstanding_operations_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqp_management_set_max_outstanding_operations(NULL, 4);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_management_prepare_operation */
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_208: [ `amqp_management_prepare_operation` shall allocate and return a prepared operation that can be executed any number of times, on any AMQP management instance, with `amqp_management_execute_prepared_operation_async`. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_210: [ `amqp_management_prepare_operation` shall build the application properties map of the requests from a clone of `application_properties` (or a new map when it is NULL) with the `operation`, `type` and `locales` key/value pairs added as by `amqp_management_execute_operation_async`. ]*/
+/* Tests_SRS_AMQP_MANAGEMENT_01_211: [ The application properties shall be encoded once by setting them on a message and creating a message template from it with `messagesender_create_message_template`. ]*/
+TEST_FUNCTION(amqp_management_prepare_operation_encodes_the_application_properties_in_a_message_template)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_create_map());
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("operation"))
+        .SetReturn(test_operation_key);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("some_operation"))
+        .SetReturn(test_operation_value);
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_application_properties, test_operation_key, test_operation_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_operation_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_operation_key));
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("type"))
+        .SetReturn(test_type_key);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("some_type"))
+        .SetReturn(test_type_value);
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_application_properties, test_type_key, test_type_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_type_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_type_key));
+    STRICT_EXPECTED_CALL(message_create());
+    STRICT_EXPECTED_CALL(message_set_application_properties(test_message, test_application_properties));
+    STRICT_EXPECTED_CALL(messagesender_create_message_template(test_message));
+    STRICT_EXPECTED_CALL(message_destroy(test_message));
+
+    // act
+    result = amqp_management_prepare_operation("some_operation", "some_type", NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy_prepared_operation(result);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_212: [ If any API fails, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_creating_the_message_template_fails_amqp_management_prepare_operation_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_create_map());
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("operation"));
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("some_operation"));
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_application_properties, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("type"));
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("some_type"));
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_application_properties, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(message_create());
+    STRICT_EXPECTED_CALL(message_set_application_properties(test_message, test_application_properties));
+    STRICT_EXPECTED_CALL(messagesender_create_message_template(test_message))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(message_destroy(test_message));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqp_management_prepare_operation("some_operation", "some_type", NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_209: [ If `operation` or `type` is NULL, or `application_properties` is not NULL and not a map, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_management_prepare_operation_with_NULL_operation_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    // act
+    result = amqp_management_prepare_operation(NULL, "some_type", NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_209: [ If `operation` or `type` is NULL, or `application_properties` is not NULL and not a map, `amqp_management_prepare_operation` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqp_management_prepare_operation_with_NULL_type_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    // act
+    result = amqp_management_prepare_operation("some_operation", NULL, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_management_destroy_prepared_operation */
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_213: [ `amqp_management_destroy_prepared_operation` shall free the message template and the application properties of the prepared operation. Operations already started with it are not affected. ]*/
+TEST_FUNCTION(amqp_management_destroy_prepared_operation_frees_the_template_and_the_application_properties)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation = amqp_management_prepare_operation("some_operation", "some_type", NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_destroy_message_template(test_message_template));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_application_properties));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqp_management_destroy_prepared_operation(prepared_operation);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_214: [ If `prepared_operation` is NULL, `amqp_management_destroy_prepared_operation` shall do nothing. ]*/
+TEST_FUNCTION(amqp_management_destroy_prepared_operation_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    amqp_management_destroy_prepared_operation(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqp_management_execute_prepared_operation_async */
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_216: [ If `amqp_management`, `prepared_operation` or `on_execute_operation_complete` is NULL, `amqp_management_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_execute_prepared_operation_async_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation = amqp_management_prepare_operation("some_operation", "some_type", NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_execute_prepared_operation_async(NULL, prepared_operation, test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy_prepared_operation(prepared_operation);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_216: [ If `amqp_management`, `prepared_operation` or `on_execute_operation_complete` is NULL, `amqp_management_execute_prepared_operation_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_execute_prepared_operation_async_with_NULL_prepared_operation_fails)
+{
+    // arrange
+    int result;
+    AMQP_MANAGEMENT_HANDLE amqp_management = amqp_management_create(test_session_handle, "test_node");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_execute_prepared_operation_async(amqp_management, NULL, test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy(amqp_management);
+}
+
+/* Tests_SRS_AMQP_MANAGEMENT_01_217: [ If `amqp_management_execute_prepared_operation_async` is called when not OPEN or in error, it shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_management_execute_prepared_operation_async_when_not_open_fails)
+{
+    // arrange
+    int result;
+    AMQP_MANAGEMENT_HANDLE amqp_management = amqp_management_create(test_session_handle, "test_node");
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE prepared_operation = amqp_management_prepare_operation("some_operation", "some_type", NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqp_management_execute_prepared_operation_async(amqp_management, prepared_operation, test_message, test_on_amqp_management_execute_operation_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqp_management_destroy_prepared_operation(prepared_operation);
+    amqp_management_destroy(amqp_management);
+}
+
 END_TEST_SUITE(amqp_management_ut)
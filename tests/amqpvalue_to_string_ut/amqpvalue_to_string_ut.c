@@ -0,0 +1,238 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/uuid.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqpvalue_to_string.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(amqpvalue_to_string_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_function_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_function_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* amqpvalue_to_string */
+
+TEST_FUNCTION(amqpvalue_to_string_with_NULL_value_fails)
+{
+    // arrange
+
+    // act
+    char* result = amqpvalue_to_string(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+TEST_FUNCTION(amqpvalue_to_string_produces_the_whole_string)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("abcdef");
+
+    // act
+    char* result = amqpvalue_to_string(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, "abcdef", result);
+
+    // cleanup
+    free(result);
+    amqpvalue_destroy(value);
+}
+
+/* amqpvalue_to_string_n */
+
+TEST_FUNCTION(amqpvalue_to_string_n_with_NULL_value_fails)
+{
+    // arrange
+
+    // act
+    char* result = amqpvalue_to_string_n(NULL, 10);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+TEST_FUNCTION(amqpvalue_to_string_n_with_max_length_0_fails)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("abcdef");
+
+    // act
+    char* result = amqpvalue_to_string_n(value, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+TEST_FUNCTION(amqpvalue_to_string_n_with_max_length_1_produces_one_dot_of_the_marker)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("abcdef");
+
+    // act
+    char* result = amqpvalue_to_string_n(value, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, ".", result);
+
+    // cleanup
+    free(result);
+    amqpvalue_destroy(value);
+}
+
+TEST_FUNCTION(amqpvalue_to_string_n_with_max_length_2_produces_two_dots_of_the_marker)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("abcdef");
+
+    // act
+    char* result = amqpvalue_to_string_n(value, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, "..", result);
+
+    // cleanup
+    free(result);
+    amqpvalue_destroy(value);
+}
+
+TEST_FUNCTION(amqpvalue_to_string_n_with_max_length_3_produces_only_the_marker)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("abcdef");
+
+    // act
+    char* result = amqpvalue_to_string_n(value, 3);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, "...", result);
+
+    // cleanup
+    free(result);
+    amqpvalue_destroy(value);
+}
+
+TEST_FUNCTION(amqpvalue_to_string_n_ends_a_truncated_string_with_the_marker)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("abcdef");
+
+    // act
+    char* result = amqpvalue_to_string_n(value, 5);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, "ab...", result);
+
+    // cleanup
+    free(result);
+    amqpvalue_destroy(value);
+}
+
+TEST_FUNCTION(amqpvalue_to_string_n_does_not_mark_a_string_that_fits)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("abcdef");
+
+    // act
+    char* result = amqpvalue_to_string_n(value, 6);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, "abcdef", result);
+
+    // cleanup
+    free(result);
+    amqpvalue_destroy(value);
+}
+
+END_TEST_SUITE(amqpvalue_to_string_ut)
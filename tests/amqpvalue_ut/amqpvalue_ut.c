@@ -122,6 +122,23 @@ MOCK_FUNCTION_END();
 
 static void* test_context = (void*)0x4243;
 
+static size_t scanned_value_count;
+static uint64_t scanned_descriptor_codes[4];
+static const unsigned char* scanned_bytes[4];
+static size_t scanned_sizes[4];
+
+static void test_on_described_value_scanned(void* context, uint64_t descriptor_code, const unsigned char* encoded_bytes, size_t encoded_size)
+{
+    (void)context;
+    if (scanned_value_count < sizeof(scanned_sizes) / sizeof(scanned_sizes[0]))
+    {
+        scanned_descriptor_codes[scanned_value_count] = descriptor_code;
+        scanned_bytes[scanned_value_count] = encoded_bytes;
+        scanned_sizes[scanned_value_count] = encoded_size;
+    }
+    scanned_value_count++;
+}
+
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -2673,12 +2690,12 @@ TEST_FUNCTION(amqpvalue_get_binary_on_a_null_amqp_value_fails)
 
 /* Tests_SRS_AMQPVALUE_01_135: [amqpvalue_create_string shall return a handle to an AMQP_VALUE that stores a sequence of Unicode characters.] */
 /* Tests_SRS_AMQPVALUE_01_028: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_456: [ Strings and symbols shorter than 24 characters shall be stored in the AMQP_VALUE itself, without allocating memory for the characters. ]*/
 TEST_FUNCTION(amqpvalue_create_string_with_one_char_succeeds)
 {
     // arrange
     AMQP_VALUE result;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(2));
 
     // act
     result = amqpvalue_create_string("a");
@@ -2693,12 +2710,12 @@ TEST_FUNCTION(amqpvalue_create_string_with_one_char_succeeds)
 
 /* Tests_SRS_AMQPVALUE_01_135: [amqpvalue_create_string shall return a handle to an AMQP_VALUE that stores a sequence of Unicode characters.] */
 /* Tests_SRS_AMQPVALUE_01_028: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_456: [ Strings and symbols shorter than 24 characters shall be stored in the AMQP_VALUE itself, without allocating memory for the characters. ]*/
 TEST_FUNCTION(amqpvalue_create_string_with_0_length_succeeds)
 {
     // arrange
     AMQP_VALUE result;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(1));
 
     // act
     result = amqpvalue_create_string("");
@@ -2733,18 +2750,58 @@ TEST_FUNCTION(when_allocating_the_string_in_the_amqp_value_fails_then_amqpvalue_
     // arrange
     AMQP_VALUE result;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(2))
+    STRICT_EXPECTED_CALL(gballoc_malloc(25))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_create_string("a");
+    result = amqpvalue_create_string("abcdefghijklmnopqrstuvwx");
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_IS_NULL(result);
 }
 
+/* Tests_SRS_AMQPVALUE_01_456: [ Strings and symbols shorter than 24 characters shall be stored in the AMQP_VALUE itself, without allocating memory for the characters. ]*/
+TEST_FUNCTION(amqpvalue_create_string_with_23_chars_does_not_allocate_the_chars)
+{
+    // arrange
+    AMQP_VALUE result;
+    const char* string_value;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = amqpvalue_create_string("abcdefghijklmnopqrstuvw");
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_string(result, &string_value);
+    ASSERT_ARE_EQUAL(char_ptr, "abcdefghijklmnopqrstuvw", string_value);
+
+    ///cleanup
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_135: [amqpvalue_create_string shall return a handle to an AMQP_VALUE that stores a sequence of Unicode characters.] */
+TEST_FUNCTION(amqpvalue_create_string_with_24_chars_allocates_the_chars)
+{
+    // arrange
+    AMQP_VALUE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(25));
+
+    // act
+    result = amqpvalue_create_string("abcdefghijklmnopqrstuvwx");
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    amqpvalue_destroy(result);
+}
+
 /* amqpvalue_get_string */
 
 /* Tests_SRS_AMQPVALUE_01_138: [amqpvalue_get_string shall yield a pointer to the sequence of bytes held by the AMQP_VALUE in string_value.] */
@@ -2843,16 +2900,208 @@ TEST_FUNCTION(amqpvalue_get_string_on_a_null_amqp_value_fails)
     amqpvalue_destroy(value);
 }
 
+/* amqpvalue_create_string_n */
+
+/* Tests_SRS_AMQPVALUE_01_571: [ amqpvalue_create_string_n shall create a string value holding the length characters at value, which need not be zero terminated and may include NUL characters. ]*/
+/* Tests_SRS_AMQPVALUE_01_573: [ amqpvalue_get_string_n shall yield the characters of the string and their number, without measuring them, and return 0. ]*/
+TEST_FUNCTION(amqpvalue_create_string_n_with_an_embedded_NUL_keeps_all_chars)
+{
+    // arrange
+    AMQP_VALUE value;
+    const char* string_value;
+    size_t length;
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    value = amqpvalue_create_string_n("ab\0cdXYZ", 5);
+
+    // assert
+    ASSERT_IS_NOT_NULL(value);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    result = amqpvalue_get_string_n(value, &string_value, &length);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 5, length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(string_value, "ab\0cd", 6));
+
+    ///cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_571: [ amqpvalue_create_string_n shall create a string value holding the length characters at value, which need not be zero terminated and may include NUL characters. ]*/
+TEST_FUNCTION(amqpvalue_create_string_n_with_NULL_and_0_length_creates_an_empty_string)
+{
+    // arrange
+    AMQP_VALUE value;
+    const char* string_value;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    value = amqpvalue_create_string_n(NULL, 0);
+
+    // assert
+    ASSERT_IS_NOT_NULL(value);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_string(value, &string_value);
+    ASSERT_ARE_EQUAL(char_ptr, "", string_value);
+
+    ///cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_572: [ If value is NULL and length is not 0, amqpvalue_create_string_n shall fail and return NULL. ]*/
+TEST_FUNCTION(amqpvalue_create_string_n_with_NULL_and_non_0_length_fails)
+{
+    // arrange
+
+    // act
+    AMQP_VALUE value = amqpvalue_create_string_n(NULL, 1);
+
+    // assert
+    ASSERT_IS_NULL(value);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_571: [ amqpvalue_create_string_n shall create a string value holding the length characters at value, which need not be zero terminated and may include NUL characters. ]*/
+TEST_FUNCTION(amqpvalue_create_string_n_with_24_chars_allocates_the_chars_and_a_terminator)
+{
+    // arrange
+    AMQP_VALUE value;
+    const char* string_value;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(25));
+
+    // act
+    value = amqpvalue_create_string_n("abcdefghijklmnopqrstuvwxyz", 24);
+
+    // assert
+    ASSERT_IS_NOT_NULL(value);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_string(value, &string_value);
+    ASSERT_ARE_EQUAL(char_ptr, "abcdefghijklmnopqrstuvwx", string_value);
+
+    ///cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
+TEST_FUNCTION(strings_that_differ_after_an_embedded_NUL_are_not_equal)
+{
+    // arrange
+    AMQP_VALUE value1 = amqpvalue_create_string_n("a\0b", 3);
+    AMQP_VALUE value2 = amqpvalue_create_string_n("a\0c", 3);
+    bool result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_are_equal(value1, value2);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+}
+
+/* amqpvalue_get_string_n */
+
+/* Tests_SRS_AMQPVALUE_01_573: [ amqpvalue_get_string_n shall yield the characters of the string and their number, without measuring them, and return 0. ]*/
+TEST_FUNCTION(amqpvalue_get_string_n_on_a_string_created_with_amqpvalue_create_string_succeeds)
+{
+    // arrange
+    const char* string_value;
+    size_t length;
+    int result;
+    AMQP_VALUE value = amqpvalue_create_string("abc");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_get_string_n(value, &string_value, &length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "abc", string_value);
+    ASSERT_ARE_EQUAL(size_t, 3, length);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_574: [ If any of the arguments is NULL, or value is not a string, amqpvalue_get_string_n shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_string_n_with_NULL_length_fails)
+{
+    // arrange
+    const char* string_value;
+    int result;
+    AMQP_VALUE value = amqpvalue_create_string("abc");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_get_string_n(value, &string_value, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_574: [ If any of the arguments is NULL, or value is not a string, amqpvalue_get_string_n shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_string_n_on_a_symbol_fails)
+{
+    // arrange
+    const char* string_value;
+    size_t length;
+    int result;
+    AMQP_VALUE value = amqpvalue_create_symbol("abc");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_get_string_n(value, &string_value, &length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_575: [ The encoded size of a string or symbol shall be computed from its stored length, without measuring or encoding its characters. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_size_of_a_string_with_an_embedded_NUL_counts_all_chars)
+{
+    // arrange
+    size_t encoded_size;
+    int result;
+    AMQP_VALUE value = amqpvalue_create_string_n("a\0b", 3);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_get_encoded_size(value, &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 5, encoded_size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
 /* amqpvalue_create_symbol */
 
 /* Tests_SRS_AMQPVALUE_01_142: [amqpvalue_create_symbol shall return a handle to an AMQP_VALUE that stores a symbol (ASCII string) value.] */
 /* Tests_SRS_AMQPVALUE_01_029: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_456: [ Strings and symbols shorter than 24 characters shall be stored in the AMQP_VALUE itself, without allocating memory for the characters. ]*/
 TEST_FUNCTION(amqpvalue_create_symbol_with_an_empty_string_succeeds)
 {
     // arrange
     AMQP_VALUE result;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
     result = amqpvalue_create_symbol("");
@@ -2867,12 +3116,12 @@ TEST_FUNCTION(amqpvalue_create_symbol_with_an_empty_string_succeeds)
 
 /* Tests_SRS_AMQPVALUE_01_142: [amqpvalue_create_symbol shall return a handle to an AMQP_VALUE that stores a symbol (ASCII string) value.] */
 /* Tests_SRS_AMQPVALUE_01_029: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_456: [ Strings and symbols shorter than 24 characters shall be stored in the AMQP_VALUE itself, without allocating memory for the characters. ]*/
 TEST_FUNCTION(amqpvalue_create_symbol_with_one_char_succeeds)
 {
     // arrange
     AMQP_VALUE result;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
     result = amqpvalue_create_symbol("t");
@@ -2963,6 +3212,90 @@ TEST_FUNCTION(amqpvalue_create_symbol_with_NULL_value_fails)
     ASSERT_IS_NULL(result);
 }
 
+/* Tests_SRS_AMQPVALUE_01_457: [ If the value is one of the well-known symbols in the interned symbol table, amqpvalue_create_symbol shall point to the table entry instead of copying the characters. ]*/
+TEST_FUNCTION(amqpvalue_create_symbol_with_a_well_known_symbol_does_not_allocate_the_chars)
+{
+    // arrange
+    AMQP_VALUE result;
+    const char* symbol_value;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = amqpvalue_create_symbol("amqp:link:transfer-limit-exceeded");
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_symbol(result, &symbol_value);
+    ASSERT_ARE_EQUAL(char_ptr, "amqp:link:transfer-limit-exceeded", symbol_value);
+
+    ///cleanup
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_457: [ If the value is one of the well-known symbols in the interned symbol table, amqpvalue_create_symbol shall point to the table entry instead of copying the characters. ]*/
+TEST_FUNCTION(two_well_known_symbols_with_the_same_value_share_the_chars)
+{
+    // arrange
+    const char* symbol_value_1;
+    const char* symbol_value_2;
+    AMQP_VALUE value_1 = amqpvalue_create_symbol("x-opt-sequence-number");
+    AMQP_VALUE value_2 = amqpvalue_create_symbol("x-opt-sequence-number");
+    umock_c_reset_all_calls();
+
+    // act
+    (void)amqpvalue_get_symbol(value_1, &symbol_value_1);
+    (void)amqpvalue_get_symbol(value_2, &symbol_value_2);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, (void*)symbol_value_1, (void*)symbol_value_2);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(value_1, value_2));
+
+    ///cleanup
+    amqpvalue_destroy(value_1);
+    amqpvalue_destroy(value_2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_459: [ Two interned symbols shall be compared by identity, without comparing their characters. ]*/
+TEST_FUNCTION(two_different_well_known_symbols_are_not_equal)
+{
+    // arrange
+    bool result;
+    AMQP_VALUE value_1 = amqpvalue_create_symbol("x-opt-offset");
+    AMQP_VALUE value_2 = amqpvalue_create_symbol("x-opt-enqueued-time");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_are_equal(value_1, value_2);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+
+    ///cleanup
+    amqpvalue_destroy(value_1);
+    amqpvalue_destroy(value_2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_457: [ If the value is one of the well-known symbols in the interned symbol table, amqpvalue_create_symbol shall point to the table entry instead of copying the characters. ]*/
+TEST_FUNCTION(a_well_known_symbol_equals_the_same_symbol_created_borrowed)
+{
+    // arrange
+    bool result;
+    AMQP_VALUE value_1 = amqpvalue_create_symbol("x-opt-offset");
+    AMQP_VALUE value_2 = amqpvalue_create_symbol_borrowed("x-opt-offset");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_are_equal(value_1, value_2);
+
+    // assert
+    ASSERT_IS_TRUE(result);
+
+    ///cleanup
+    amqpvalue_destroy(value_1);
+    amqpvalue_destroy(value_2);
+}
+
 /* This test would allocate 4Gb and some people might not like that */
 #if 0
 /* Tests_SRS_AMQPVALUE_01_401: [ If the string pointed to by value is longer than 2^32-1 then amqpvalue_create_symbol shall return NULL. ]*/
@@ -3174,25 +3507,90 @@ TEST_FUNCTION(when_allocating_memory_fails_then_amqpvalue_create_list_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* amqpvalue_set_list_item_count */
+/* amqpvalue_create_list_with_capacity */
 
-/* Tests_SRS_AMQPVALUE_01_152: [amqpvalue_set_list_item_count shall resize an AMQP list.] */
-/* Tests_SRS_AMQPVALUE_01_153: [On success amqpvalue_set_list_item_count shall return 0.] */
-TEST_FUNCTION(amqpvalue_set_list_item_count_with_1_count_succeeds)
+/* Tests_SRS_AMQPVALUE_01_447: [ `amqpvalue_create_list_with_capacity` shall create an empty list, like amqpvalue_create_list, with storage allocated for `capacity` items. ]*/
+TEST_FUNCTION(amqpvalue_create_list_with_capacity_allocates_the_item_storage)
 {
     // arrange
-    int result;
-    AMQP_VALUE list = amqpvalue_create_list();
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    AMQP_VALUE result;
+    uint32_t item_count;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 4 * sizeof(AMQP_VALUE)));
 
     // act
-    result = amqpvalue_set_list_item_count(list, 1);
+    result = amqpvalue_create_list_with_capacity(4);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_list_item_count(result, &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
+
+    // cleanup
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_447: [ `amqpvalue_create_list_with_capacity` shall create an empty list, like amqpvalue_create_list, with storage allocated for `capacity` items. ]*/
+TEST_FUNCTION(setting_items_within_the_capacity_of_a_list_does_not_reallocate)
+{
+    // arrange
+    AMQP_VALUE list = amqpvalue_create_list_with_capacity(4);
+    AMQP_VALUE item = amqpvalue_create_uint(42);
+    uint32_t i;
+    umock_c_reset_all_calls();
+
+    // act
+    for (i = 0; i < 4; i++)
+    {
+        ASSERT_ARE_EQUAL(int, 0, amqpvalue_set_list_item(list, i, item));
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(list);
+    amqpvalue_destroy(item);
+}
+
+/* Tests_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_item_storage_fails_amqpvalue_create_list_with_capacity_fails)
+{
+    // arrange
+    AMQP_VALUE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 4 * sizeof(AMQP_VALUE)))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_create_list_with_capacity(4);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqpvalue_set_list_item_count */
+
+/* Tests_SRS_AMQPVALUE_01_152: [amqpvalue_set_list_item_count shall resize an AMQP list.] */
+/* Tests_SRS_AMQPVALUE_01_153: [On success amqpvalue_set_list_item_count shall return 0.] */
+TEST_FUNCTION(amqpvalue_set_list_item_count_with_1_count_succeeds)
+{
+    // arrange
+    int result;
+    AMQP_VALUE list = amqpvalue_create_list();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = amqpvalue_set_list_item_count(list, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
@@ -3959,6 +4357,46 @@ TEST_FUNCTION(amqpvalue_create_map_creates_a_map_with_no_pairs)
     amqpvalue_destroy(map);
 }
 
+/* amqpvalue_create_map_with_capacity */
+
+/* Tests_SRS_AMQPVALUE_01_448: [ `amqpvalue_create_map_with_capacity` shall create an empty map, like amqpvalue_create_map, with storage allocated for `capacity` key/value pairs. ]*/
+TEST_FUNCTION(amqpvalue_create_map_with_capacity_allocates_the_pair_storage)
+{
+    // arrange
+    AMQP_VALUE result;
+    uint32_t pair_count;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+
+    // act
+    result = amqpvalue_create_map_with_capacity(2);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_map_pair_count(result, &pair_count);
+    ASSERT_ARE_EQUAL(uint32_t, 0, pair_count);
+
+    // cleanup
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_450: [ If any allocation fails, the `amqpvalue_create_*_with_capacity` functions shall return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_map_value_fails_amqpvalue_create_map_with_capacity_fails)
+{
+    // arrange
+    AMQP_VALUE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = amqpvalue_create_map_with_capacity(2);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /* amqpvalue_set_map_value */
 
 /* Tests_SRS_AMQPVALUE_01_181: [amqpvalue_set_map_value shall set the value in the map identified by the map argument for a key/value pair identified by the key argument.] */
@@ -4116,6 +4554,87 @@ TEST_FUNCTION(amqpvalue_set_map_value_with_an_already_existing_value_replaces_th
     amqpvalue_destroy(key);
 }
 
+/* Tests_SRS_AMQPVALUE_01_181: [amqpvalue_set_map_value shall set the value in the map identified by the map argument for a key/value pair identified by the key argument.] */
+TEST_FUNCTION(amqpvalue_set_map_value_grows_the_pair_storage_geometrically)
+{
+    // arrange
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE key1 = amqpvalue_create_uint(1);
+    AMQP_VALUE key2 = amqpvalue_create_uint(2);
+    AMQP_VALUE key3 = amqpvalue_create_uint(3);
+    AMQP_VALUE key4 = amqpvalue_create_uint(4);
+    (void)amqpvalue_set_map_value(map, key1, key1);
+    (void)amqpvalue_set_map_value(map, key2, key2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 4 * sizeof(AMQP_VALUE) * 2));
+
+    // act
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_set_map_value(map, key3, key3));
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_set_map_value(map, key4, key4));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
+    amqpvalue_destroy(key3);
+    amqpvalue_destroy(key4);
+}
+
+/* Tests_SRS_AMQPVALUE_01_438: [ New key/value pairs shall be appended to the map, so that the pairs keep their insertion order. ]*/
+/* Tests_SRS_AMQPVALUE_01_184: [If the key already exists in the map, its value shall be replaced with the value provided by the value argument.] */
+TEST_FUNCTION(amqpvalue_set_map_value_on_a_map_with_many_pairs_keeps_the_insertion_order)
+{
+    // arrange
+    int result;
+    uint32_t pair_count;
+    uint32_t i;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_symbol("key_10");
+    AMQP_VALUE value = amqpvalue_create_uint(42);
+    for (i = 0; i < 32; i++)
+    {
+        char key_name[16];
+        AMQP_VALUE map_key;
+        (void)sprintf(key_name, "key_%u", (unsigned int)i);
+        map_key = amqpvalue_create_symbol(key_name);
+        (void)amqpvalue_set_map_value(map, map_key, map_key);
+        amqpvalue_destroy(map_key);
+    }
+
+    // act
+    result = amqpvalue_set_map_value(map, key, value);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)amqpvalue_get_map_pair_count(map, &pair_count);
+    ASSERT_ARE_EQUAL(uint32_t, 32, pair_count);
+    for (i = 0; i < 32; i++)
+    {
+        char key_name[16];
+        AMQP_VALUE pair_key;
+        AMQP_VALUE pair_value;
+        const char* pair_key_name;
+        (void)sprintf(key_name, "key_%u", (unsigned int)i);
+        (void)amqpvalue_get_map_key_value_pair(map, i, &pair_key, &pair_value);
+        (void)amqpvalue_get_symbol(pair_key, &pair_key_name);
+        ASSERT_ARE_EQUAL(char_ptr, key_name, pair_key_name);
+        if (i == 10)
+        {
+            ASSERT_IS_TRUE(amqpvalue_are_equal(value, pair_value));
+        }
+        amqpvalue_destroy(pair_key);
+        amqpvalue_destroy(pair_value);
+    }
+
+    // cleanup
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+}
+
 /* Tests_SRS_AMQPVALUE_01_186: [If allocating memory to hold a new key/value pair fails, amqpvalue_set_map_value shall fail and return a non-zero value.] */
 TEST_FUNCTION(when_reallocating_memory_to_hold_the_map_fails_then_amqpvalue_set_map_value_fails)
 {
@@ -4299,264 +4818,310 @@ TEST_FUNCTION(amqpvalue_get_map_value_for_a_non_map_value_fails)
     amqpvalue_destroy(key);
 }
 
-/* amqpvalue_get_map_pair_count */
+/* Tests_SRS_AMQPVALUE_01_189: [amqpvalue_get_map_value shall return the value whose key is identified by the key argument.] */
+TEST_FUNCTION(amqpvalue_get_map_value_finds_all_keys_of_a_map_with_many_pairs)
+{
+    // arrange
+    AMQP_VALUE map = amqpvalue_create_map();
+    uint32_t i;
+    for (i = 0; i < 64; i++)
+    {
+        AMQP_VALUE key = amqpvalue_create_uint(i);
+        AMQP_VALUE value = amqpvalue_create_uint(i + 1000);
+        (void)amqpvalue_set_map_value(map, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
 
-/* Tests_SRS_AMQPVALUE_01_193: [amqpvalue_get_map_pair_count shall fill in the number of key/value pairs in the map in the pair_count argument.] */
-/* Tests_SRS_AMQPVALUE_01_194: [On success amqpvalue_get_map_pair_count shall return 0.] */
-TEST_FUNCTION(amqpvalue_get_map_pair_count_yields_0_on_an_empty_map)
+    for (i = 0; i < 64; i++)
+    {
+        AMQP_VALUE key = amqpvalue_create_uint(i);
+        AMQP_VALUE result;
+        uint32_t result_value;
+
+        // act
+        result = amqpvalue_get_map_value(map, key);
+
+        // assert
+        ASSERT_IS_NOT_NULL(result);
+        (void)amqpvalue_get_uint(result, &result_value);
+        ASSERT_ARE_EQUAL(uint32_t, i + 1000, result_value);
+
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(result);
+    }
+
+    // cleanup
+    amqpvalue_destroy(map);
+}
+
+/* Tests_SRS_AMQPVALUE_01_191: [If the key cannot be found, amqpvalue_get_map_value shall return NULL.] */
+TEST_FUNCTION(amqpvalue_get_map_value_with_a_key_of_another_type_in_a_map_with_many_pairs_fails)
 {
     // arrange
-    int result;
-    uint32_t pair_count;
     AMQP_VALUE map = amqpvalue_create_map();
-    umock_c_reset_all_calls();
+    AMQP_VALUE key = amqpvalue_create_ulong(3);
+    AMQP_VALUE result;
+    uint32_t i;
+    for (i = 0; i < 64; i++)
+    {
+        AMQP_VALUE map_key = amqpvalue_create_uint(i);
+        (void)amqpvalue_set_map_value(map, map_key, map_key);
+        amqpvalue_destroy(map_key);
+    }
 
     // act
-    result = amqpvalue_get_map_pair_count(map, &pair_count);
+    result = amqpvalue_get_map_value(map, key);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(uint32_t, 0, pair_count);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
 
     // cleanup
+    amqpvalue_destroy(key);
     amqpvalue_destroy(map);
 }
 
-/* Tests_SRS_AMQPVALUE_01_193: [amqpvalue_get_map_pair_count shall fill in the number of key/value pairs in the map in the pair_count argument.] */
-/* Tests_SRS_AMQPVALUE_01_194: [On success amqpvalue_get_map_pair_count shall return 0.] */
-TEST_FUNCTION(amqpvalue_get_map_pair_count_yields_1_on_a_map_with_1_pair)
+/* amqpvalue_get_map_value_by_string */
+
+/* Tests_SRS_AMQPVALUE_01_510: [ `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return a clone of the value whose key is the string, respectively symbol, with the characters of `key`, without creating an AMQP value for the key. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_by_string_returns_the_value_for_the_key)
 {
     // arrange
-    int result;
-    uint32_t pair_count;
+    AMQP_VALUE result;
     AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_string("status-code");
     AMQP_VALUE value = amqpvalue_create_uint(42);
-    (void)amqpvalue_set_map_value(map, value, value);
+    (void)amqpvalue_set_map_value(map, key, value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_pair_count(map, &pair_count);
+    result = amqpvalue_get_map_value_by_string(map, "status-code");
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(uint32_t, 1, pair_count);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(value, result));
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(map);
+    amqpvalue_destroy(key);
     amqpvalue_destroy(value);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_193: [amqpvalue_get_map_pair_count shall fill in the number of key/value pairs in the map in the pair_count argument.] */
-/* Tests_SRS_AMQPVALUE_01_194: [On success amqpvalue_get_map_pair_count shall return 0.] */
-TEST_FUNCTION(amqpvalue_get_map_pair_count_yields_2_on_a_map_with_2_pairs)
+/* Tests_SRS_AMQPVALUE_01_510: [ `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return a clone of the value whose key is the string, respectively symbol, with the characters of `key`, without creating an AMQP value for the key. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_by_symbol_finds_all_keys_of_a_map_with_many_pairs)
 {
     // arrange
-    int result;
-    uint32_t pair_count;
     AMQP_VALUE map = amqpvalue_create_map();
-    AMQP_VALUE value1 = amqpvalue_create_uint(42);
-    AMQP_VALUE value2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_map_value(map, value1, value1);
-    (void)amqpvalue_set_map_value(map, value2, value2);
-    umock_c_reset_all_calls();
+    char key_chars[16];
+    uint32_t i;
+    for (i = 0; i < 64; i++)
+    {
+        AMQP_VALUE key;
+        AMQP_VALUE value = amqpvalue_create_uint(i);
+        (void)sprintf(key_chars, "key-%u", (unsigned int)i);
+        key = amqpvalue_create_symbol(key_chars);
+        (void)amqpvalue_set_map_value(map, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
 
-    // act
-    result = amqpvalue_get_map_pair_count(map, &pair_count);
+    for (i = 0; i < 64; i++)
+    {
+        AMQP_VALUE result;
+        uint32_t result_value;
+        (void)sprintf(key_chars, "key-%u", (unsigned int)i);
 
-    // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(uint32_t, 2, pair_count);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        // act
+        result = amqpvalue_get_map_value_by_symbol(map, key_chars);
+
+        // assert
+        ASSERT_IS_NOT_NULL(result);
+        (void)amqpvalue_get_uint(result, &result_value);
+        ASSERT_ARE_EQUAL(uint32_t, i, result_value);
+
+        amqpvalue_destroy(result);
+    }
 
     // cleanup
     amqpvalue_destroy(map);
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_195: [If any of the arguments is NULL, amqpvalue_get_map_pair_count shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_pair_with_NULL_map_fails)
+/* Tests_SRS_AMQPVALUE_01_511: [ If `map` or `key` is NULL, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_by_string_with_NULL_map_fails)
 {
     // arrange
+    AMQP_VALUE result;
 
     // act
-    uint32_t pair_count;
-    int result = amqpvalue_get_map_pair_count(NULL, &pair_count);
+    result = amqpvalue_get_map_value_by_string(NULL, "test");
 
     // assert
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_195: [If any of the arguments is NULL, amqpvalue_get_map_pair_count shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_pair_with_NULL_pair_count_argument_fails)
+/* Tests_SRS_AMQPVALUE_01_511: [ If `map` or `key` is NULL, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_by_symbol_with_NULL_key_fails)
 {
     // arrange
-    int result;
+    AMQP_VALUE result;
     AMQP_VALUE map = amqpvalue_create_map();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_pair_count(map, NULL);
+    result = amqpvalue_get_map_value_by_symbol(map, NULL);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(map);
 }
 
-/* Tests_SRS_AMQPVALUE_01_198: [If the map argument is not an AMQP value created with the amqpvalue_create_map function then amqpvalue_get_map_pair_count shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_pair_count_on_a_non_map_value_fails)
+/* Tests_SRS_AMQPVALUE_01_512: [ If `map` is not a map, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_by_string_for_a_non_map_value_fails)
 {
     // arrange
-    int result;
-    uint32_t pair_count;
+    AMQP_VALUE result;
     AMQP_VALUE null_value = amqpvalue_create_null();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_pair_count(null_value, &pair_count);
+    result = amqpvalue_get_map_value_by_string(null_value, "test");
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(null_value);
 }
 
-/* amqpvalue_get_map_key_value_pair */
-
-/* Tests_SRS_AMQPVALUE_01_199: [amqpvalue_get_map_key_value_pair shall fill in the key and value arguments copies of the key/value pair on the 0 based position index in a map.] */
-/* Tests_SRS_AMQPVALUE_01_200: [On success amqpvalue_get_map_key_value_pair shall return 0.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_1_element_succeeds)
+/* Tests_SRS_AMQPVALUE_01_513: [ If the key cannot be found, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_by_string_with_a_key_that_does_not_exist_fails)
 {
     // arrange
-    int result;
-    AMQP_VALUE key;
-    AMQP_VALUE value;
+    AMQP_VALUE result;
     AMQP_VALUE map = amqpvalue_create_map();
-    AMQP_VALUE no1 = amqpvalue_create_uint(42);
-    (void)amqpvalue_set_map_value(map, no1, no1);
+    AMQP_VALUE key = amqpvalue_create_string("test");
+    (void)amqpvalue_set_map_value(map, key, key);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(map, 0, &key, &value);
+    result = amqpvalue_get_map_value_by_string(map, "other");
 
     // assert
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_IS_NOT_NULL(key);
-    ASSERT_IS_NOT_NULL(value);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(key, no1));
-    ASSERT_IS_TRUE(amqpvalue_are_equal(value, no1));
 
     // cleanup
     amqpvalue_destroy(map);
-    amqpvalue_destroy(no1);
     amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_199: [amqpvalue_get_map_key_value_pair shall fill in the key and value arguments copies of the key/value pair on the 0 based position index in a map.] */
-/* Tests_SRS_AMQPVALUE_01_200: [On success amqpvalue_get_map_key_value_pair shall return 0.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_1_element_different_key_and_value_data_succeeds)
+/* Tests_SRS_AMQPVALUE_01_513: [ If the key cannot be found, `amqpvalue_get_map_value_by_string` and `amqpvalue_get_map_value_by_symbol` shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_by_symbol_does_not_find_a_string_key)
 {
     // arrange
-    int result;
-    AMQP_VALUE key;
-    AMQP_VALUE value;
+    AMQP_VALUE result;
     AMQP_VALUE map = amqpvalue_create_map();
-    AMQP_VALUE no1 = amqpvalue_create_uint(42);
-    AMQP_VALUE no2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_map_value(map, no1, no2);
+    AMQP_VALUE key = amqpvalue_create_string("test");
+    (void)amqpvalue_set_map_value(map, key, key);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(map, 0, &key, &value);
+    result = amqpvalue_get_map_value_by_symbol(map, "test");
 
     // assert
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_IS_NOT_NULL(key);
-    ASSERT_IS_NOT_NULL(value);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(key, no1));
-    ASSERT_IS_TRUE(amqpvalue_are_equal(value, no2));
 
     // cleanup
     amqpvalue_destroy(map);
-    amqpvalue_destroy(no1);
-    amqpvalue_destroy(no2);
     amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_199: [amqpvalue_get_map_key_value_pair shall fill in the key and value arguments copies of the key/value pair on the 0 based position index in a map.] */
-/* Tests_SRS_AMQPVALUE_01_200: [On success amqpvalue_get_map_key_value_pair shall return 0.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_second_element_succeeds)
+/* amqpvalue_set_map_value_by_string */
+
+/* Tests_SRS_AMQPVALUE_01_514: [ When the key is already in the map, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall replace its value with a clone of `value`, without creating an AMQP value for the key. ]*/
+/* Tests_SRS_AMQPVALUE_01_519: [ On success `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_set_map_value_by_string_replaces_the_value_of_an_existing_key)
 {
     // arrange
     int result;
-    AMQP_VALUE key;
-    AMQP_VALUE value;
+    uint32_t pair_count;
+    AMQP_VALUE result_value;
     AMQP_VALUE map = amqpvalue_create_map();
-    AMQP_VALUE no1 = amqpvalue_create_uint(42);
-    AMQP_VALUE no2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_map_value(map, no1, no1);
-    (void)amqpvalue_set_map_value(map, no2, no2);
+    AMQP_VALUE key = amqpvalue_create_string("test");
+    AMQP_VALUE value1 = amqpvalue_create_uint(42);
+    AMQP_VALUE value2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(map, key, value1);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(map, 1, &key, &value);
+    result = amqpvalue_set_map_value_by_string(map, "test", value2);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_IS_NOT_NULL(key);
-    ASSERT_IS_NOT_NULL(value);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(key, no2));
-    ASSERT_IS_TRUE(amqpvalue_are_equal(value, no2));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_map_pair_count(map, &pair_count);
+    ASSERT_ARE_EQUAL(uint32_t, 1, pair_count);
+    result_value = amqpvalue_get_map_value(map, key);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(value2, result_value));
 
     // cleanup
     amqpvalue_destroy(map);
-    amqpvalue_destroy(no1);
-    amqpvalue_destroy(no2);
     amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(result_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_201: [If any of the map, key or value arguments is NULL, amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_map_fails)
+/* Tests_SRS_AMQPVALUE_01_515: [ Otherwise the key shall be created as a string, respectively symbol, AMQP value and the pair added to the map like amqpvalue_set_map_value does. ]*/
+/* Tests_SRS_AMQPVALUE_01_519: [ On success `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_set_map_value_by_symbol_adds_a_new_symbol_key)
 {
     // arrange
-    AMQP_VALUE key;
-    AMQP_VALUE value;
+    int result;
+    uint32_t pair_count;
+    AMQP_VALUE result_value;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_symbol("test");
+    AMQP_VALUE value = amqpvalue_create_uint(42);
+    umock_c_reset_all_calls();
 
     // act
-    int result = amqpvalue_get_map_key_value_pair(NULL, 0, &key, &value);
+    result = amqpvalue_set_map_value_by_symbol(map, "test", value);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)amqpvalue_get_map_pair_count(map, &pair_count);
+    ASSERT_ARE_EQUAL(uint32_t, 1, pair_count);
+    result_value = amqpvalue_get_map_value(map, key);
+    ASSERT_IS_NOT_NULL(result_value);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(value, result_value));
+
+    // cleanup
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+    amqpvalue_destroy(result_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_201: [If any of the map, key or value arguments is NULL, amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_key_fails)
+/* Tests_SRS_AMQPVALUE_01_516: [ If any of the arguments is NULL, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_set_map_value_by_string_with_NULL_key_fails)
 {
     // arrange
     int result;
-    AMQP_VALUE value;
     AMQP_VALUE map = amqpvalue_create_map();
-    AMQP_VALUE no1 = amqpvalue_create_uint(42);
-    (void)amqpvalue_set_map_value(map, no1, no1);
+    AMQP_VALUE value = amqpvalue_create_uint(42);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(map, 0, NULL, &value);
+    result = amqpvalue_set_map_value_by_string(map, NULL, value);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -4564,22 +5129,19 @@ TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_key_fails)
 
     // cleanup
     amqpvalue_destroy(map);
-    amqpvalue_destroy(no1);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_201: [If any of the map, key or value arguments is NULL, amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_value_fails)
+/* Tests_SRS_AMQPVALUE_01_516: [ If any of the arguments is NULL, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_set_map_value_by_symbol_with_NULL_value_fails)
 {
     // arrange
     int result;
-    AMQP_VALUE key;
     AMQP_VALUE map = amqpvalue_create_map();
-    AMQP_VALUE no1 = amqpvalue_create_uint(42);
-    (void)amqpvalue_set_map_value(map, no1, no1);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(map, 0, &key, NULL);
+    result = amqpvalue_set_map_value_by_symbol(map, "test", NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -4587,925 +5149,1032 @@ TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_value_fails)
 
     // cleanup
     amqpvalue_destroy(map);
-    amqpvalue_destroy(no1);
 }
 
-/* Tests_SRS_AMQPVALUE_01_204: [If the index argument is greater or equal to the number of key/value pairs in the map then amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_on_an_empty_map_fails)
+/* Tests_SRS_AMQPVALUE_01_517: [ If `map` is not a map or was allocated from an arena, `amqpvalue_set_map_value_by_string` and `amqpvalue_set_map_value_by_symbol` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_set_map_value_by_string_on_a_non_map_value_fails)
 {
     // arrange
     int result;
-    AMQP_VALUE key;
-    AMQP_VALUE value;
-    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE value = amqpvalue_create_uint(42);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(map, 0, &key, &value);
+    result = amqpvalue_set_map_value_by_string(null_value, "test", value);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(map);
+    amqpvalue_destroy(null_value);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_204: [If the index argument is greater or equal to the number of key/value pairs in the map then amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_index_equal_number_of_pairs_fails)
+/* amqpvalue_get_map_pair_count */
+
+/* Tests_SRS_AMQPVALUE_01_193: [amqpvalue_get_map_pair_count shall fill in the number of key/value pairs in the map in the pair_count argument.] */
+/* Tests_SRS_AMQPVALUE_01_194: [On success amqpvalue_get_map_pair_count shall return 0.] */
+TEST_FUNCTION(amqpvalue_get_map_pair_count_yields_0_on_an_empty_map)
 {
     // arrange
     int result;
-    AMQP_VALUE key;
-    AMQP_VALUE value;
+    uint32_t pair_count;
     AMQP_VALUE map = amqpvalue_create_map();
-    AMQP_VALUE no1 = amqpvalue_create_uint(42);
-    (void)amqpvalue_set_map_value(map, no1, no1);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(map, 1, &key, &value);
+    result = amqpvalue_get_map_pair_count(map, &pair_count);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 0, pair_count);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(map);
-    amqpvalue_destroy(no1);
 }
 
-/* Tests_SRS_AMQPVALUE_01_205: [If the map argument is not an AMQP value created with the amqpvalue_create_map function then amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_map_key_value_pair_on_a_non_map_value_fails)
+/* Tests_SRS_AMQPVALUE_01_193: [amqpvalue_get_map_pair_count shall fill in the number of key/value pairs in the map in the pair_count argument.] */
+/* Tests_SRS_AMQPVALUE_01_194: [On success amqpvalue_get_map_pair_count shall return 0.] */
+TEST_FUNCTION(amqpvalue_get_map_pair_count_yields_1_on_a_map_with_1_pair)
 {
     // arrange
     int result;
-    AMQP_VALUE key;
-    AMQP_VALUE value;
-    AMQP_VALUE null_value = amqpvalue_create_null();
+    uint32_t pair_count;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE value = amqpvalue_create_uint(42);
+    (void)amqpvalue_set_map_value(map, value, value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_get_map_key_value_pair(null_value, 0, &key, &value);
+    result = amqpvalue_get_map_pair_count(map, &pair_count);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 1, pair_count);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(null_value);
-}
-
-/* amqpvalue_are_equal */
-
-/* Tests_SRS_AMQPVALUE_01_207: [If value1 and value2 are NULL, amqpvalue_are_equal shall return true.] */
-TEST_FUNCTION(amqpvalue_are_equal_with_NULL_values_returns_true)
-{
-    // arrange
-    
-    // act
-    bool result = amqpvalue_are_equal(NULL, NULL);
-
-    // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_IS_TRUE(result);
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_208: [If one of the arguments is NULL and the other is not, amqpvalue_are_equal shall return false.] */
-TEST_FUNCTION(when_value2_is_NULL_and_value1_is_not_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_193: [amqpvalue_get_map_pair_count shall fill in the number of key/value pairs in the map in the pair_count argument.] */
+/* Tests_SRS_AMQPVALUE_01_194: [On success amqpvalue_get_map_pair_count shall return 0.] */
+TEST_FUNCTION(amqpvalue_get_map_pair_count_yields_2_on_a_map_with_2_pairs)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_null();
+    int result;
+    uint32_t pair_count;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE value1 = amqpvalue_create_uint(42);
+    AMQP_VALUE value2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(map, value1, value1);
+    (void)amqpvalue_set_map_value(map, value2, value2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, NULL);
+    result = amqpvalue_get_map_pair_count(map, &pair_count);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 2, pair_count);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
+    amqpvalue_destroy(map);
     amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_208: [If one of the arguments is NULL and the other is not, amqpvalue_are_equal shall return false.] */
-TEST_FUNCTION(when_value1_is_NULL_and_value2_is_not_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_195: [If any of the arguments is NULL, amqpvalue_get_map_pair_count shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_pair_with_NULL_map_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value2 = amqpvalue_create_null();
-    umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(NULL, value2);
+    uint32_t pair_count;
+    int result = amqpvalue_get_map_pair_count(NULL, &pair_count);
 
     // assert
-    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(value2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_209: [If the types for value1 and value2 are different amqpvalue_are_equal shall return false.] */
-TEST_FUNCTION(when_value1_is_uint_and_value2_is_ulong_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_195: [If any of the arguments is NULL, amqpvalue_get_map_pair_count shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_pair_with_NULL_pair_count_argument_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_uint(42);
-    AMQP_VALUE value2 = amqpvalue_create_ulong(42);
+    int result;
+    AMQP_VALUE map = amqpvalue_create_map();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_pair_count(map, NULL);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(map);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_210: [- null: always equal.] */
-TEST_FUNCTION(for_2_null_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_198: [If the map argument is not an AMQP value created with the amqpvalue_create_map function then amqpvalue_get_map_pair_count shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_pair_count_on_a_non_map_value_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_null();
-    AMQP_VALUE value2 = amqpvalue_create_null();
+    int result;
+    uint32_t pair_count;
+    AMQP_VALUE null_value = amqpvalue_create_null();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_pair_count(null_value, &pair_count);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_211: [- boolean: compare the bool content.] */
-TEST_FUNCTION(for_2_equal_boolean_values_amqpvalue_are_equal_returns_true)
+/* amqpvalue_get_map_key_value_pair */
+
+/* Tests_SRS_AMQPVALUE_01_199: [amqpvalue_get_map_key_value_pair shall fill in the key and value arguments copies of the key/value pair on the 0 based position index in a map.] */
+/* Tests_SRS_AMQPVALUE_01_200: [On success amqpvalue_get_map_key_value_pair shall return 0.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_1_element_succeeds)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_boolean(false);
-    AMQP_VALUE value2 = amqpvalue_create_boolean(false);
+    int result;
+    AMQP_VALUE key;
+    AMQP_VALUE value;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE no1 = amqpvalue_create_uint(42);
+    (void)amqpvalue_set_map_value(map, no1, no1);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(map, 0, &key, &value);
 
     // assert
-    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(key);
+    ASSERT_IS_NOT_NULL(value);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(key, no1));
+    ASSERT_IS_TRUE(amqpvalue_are_equal(value, no1));
+
+    // cleanup
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(no1);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_211: [- boolean: compare the bool content.] */
-TEST_FUNCTION(for_2_different_boolean_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_199: [amqpvalue_get_map_key_value_pair shall fill in the key and value arguments copies of the key/value pair on the 0 based position index in a map.] */
+/* Tests_SRS_AMQPVALUE_01_200: [On success amqpvalue_get_map_key_value_pair shall return 0.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_1_element_different_key_and_value_data_succeeds)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_boolean(false);
-    AMQP_VALUE value2 = amqpvalue_create_boolean(true);
+    int result;
+    AMQP_VALUE key;
+    AMQP_VALUE value;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE no1 = amqpvalue_create_uint(42);
+    AMQP_VALUE no2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(map, no1, no2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(map, 0, &key, &value);
 
     // assert
-    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(key);
+    ASSERT_IS_NOT_NULL(value);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(key, no1));
+    ASSERT_IS_TRUE(amqpvalue_are_equal(value, no2));
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(no1);
+    amqpvalue_destroy(no2);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_212: [- ubyte: compare the unsigned char content.] */
-TEST_FUNCTION(for_2_equal_ubyte_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_199: [amqpvalue_get_map_key_value_pair shall fill in the key and value arguments copies of the key/value pair on the 0 based position index in a map.] */
+/* Tests_SRS_AMQPVALUE_01_200: [On success amqpvalue_get_map_key_value_pair shall return 0.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_second_element_succeeds)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_ubyte(42);
-    AMQP_VALUE value2 = amqpvalue_create_ubyte(42);
+    int result;
+    AMQP_VALUE key;
+    AMQP_VALUE value;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE no1 = amqpvalue_create_uint(42);
+    AMQP_VALUE no2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(map, no1, no1);
+    (void)amqpvalue_set_map_value(map, no2, no2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(map, 1, &key, &value);
 
     // assert
-    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(key);
+    ASSERT_IS_NOT_NULL(value);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(key, no2));
+    ASSERT_IS_TRUE(amqpvalue_are_equal(value, no2));
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(no1);
+    amqpvalue_destroy(no2);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_212: [- ubyte: compare the unsigned char content.] */
-TEST_FUNCTION(for_2_different_ubyte_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_201: [If any of the map, key or value arguments is NULL, amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_map_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_ubyte(42);
-    AMQP_VALUE value2 = amqpvalue_create_ubyte(43);
-    umock_c_reset_all_calls();
+    AMQP_VALUE key;
+    AMQP_VALUE value;
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    int result = amqpvalue_get_map_key_value_pair(NULL, 0, &key, &value);
 
     // assert
-    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_213: [- ushort: compare the uint16_t content.] */
-TEST_FUNCTION(for_2_equal_ushort_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_201: [If any of the map, key or value arguments is NULL, amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_key_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_ushort(42);
-    AMQP_VALUE value2 = amqpvalue_create_ushort(42);
+    int result;
+    AMQP_VALUE value;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE no1 = amqpvalue_create_uint(42);
+    (void)amqpvalue_set_map_value(map, no1, no1);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(map, 0, NULL, &value);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(no1);
 }
 
-/* Tests_SRS_AMQPVALUE_01_212: [- ushort: compare the unsigned char content.] */
-TEST_FUNCTION(for_2_different_ushort_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_201: [If any of the map, key or value arguments is NULL, amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_NULL_value_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_ushort(42);
-    AMQP_VALUE value2 = amqpvalue_create_ushort(43);
+    int result;
+    AMQP_VALUE key;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE no1 = amqpvalue_create_uint(42);
+    (void)amqpvalue_set_map_value(map, no1, no1);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(map, 0, &key, NULL);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(no1);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_214: [- uint: compare the uint32_t content.] */
-TEST_FUNCTION(for_2_equal_uint_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_204: [If the index argument is greater or equal to the number of key/value pairs in the map then amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_on_an_empty_map_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_uint(42);
-    AMQP_VALUE value2 = amqpvalue_create_uint(42);
+    int result;
+    AMQP_VALUE key;
+    AMQP_VALUE value;
+    AMQP_VALUE map = amqpvalue_create_map();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(map, 0, &key, &value);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(map);
 }
 
-/* Tests_SRS_AMQPVALUE_01_214: [- uint: compare the uint32_t content.] */
-TEST_FUNCTION(for_2_different_uint_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_204: [If the index argument is greater or equal to the number of key/value pairs in the map then amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_with_index_equal_number_of_pairs_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_uint(42);
-    AMQP_VALUE value2 = amqpvalue_create_uint(43);
+    int result;
+    AMQP_VALUE key;
+    AMQP_VALUE value;
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE no1 = amqpvalue_create_uint(42);
+    (void)amqpvalue_set_map_value(map, no1, no1);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(map, 1, &key, &value);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(map);
+    amqpvalue_destroy(no1);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_215: [- ulong: compare the uint64_t content.] */
-TEST_FUNCTION(for_2_equal_ulong_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_205: [If the map argument is not an AMQP value created with the amqpvalue_create_map function then amqpvalue_get_map_key_value_pair shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_map_key_value_pair_on_a_non_map_value_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_ulong(42);
-    AMQP_VALUE value2 = amqpvalue_create_ulong(42);
+    int result;
+    AMQP_VALUE key;
+    AMQP_VALUE value;
+    AMQP_VALUE null_value = amqpvalue_create_null();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_map_key_value_pair(null_value, 0, &key, &value);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_215: [- ulong: compare the uint64_t content.] */
-TEST_FUNCTION(for_2_different_ulong_values_amqpvalue_are_equal_returns_false)
+/* amqpvalue_create_array_with_capacity */
+
+/* Tests_SRS_AMQPVALUE_01_449: [ `amqpvalue_create_array_with_capacity` shall create an empty array, like amqpvalue_create_array, with storage allocated for `capacity` items. ]*/
+TEST_FUNCTION(adding_items_within_the_capacity_of_an_array_does_not_reallocate)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_ulong(42);
-    AMQP_VALUE value2 = amqpvalue_create_ulong(43);
+    AMQP_VALUE array = amqpvalue_create_array_with_capacity(3);
+    AMQP_VALUE item = amqpvalue_create_uint(42);
+    uint32_t item_count;
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_add_array_item(array, item));
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_add_array_item(array, item));
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_add_array_item(array, item));
 
     // assert
-    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_array_item_count(array, &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 3, item_count);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_216: [- byte: compare the char content.] */
-TEST_FUNCTION(for_2_equal_byte_values_amqpvalue_are_equal_returns_true)
+/* amqpvalue_create_array_from_span */
+
+/* Tests_SRS_AMQPVALUE_01_482: [ `amqpvalue_create_array_from_span` shall create a packed array holding a copy of the `count` items of `item_type` in `items`, without creating an AMQP value per item. ]*/
+/* Tests_SRS_AMQPVALUE_01_485: [ `amqpvalue_get_array_span` shall return in `items` a pointer to the items of a packed array of `item_type`, in host byte order, and their number in `count`. ]*/
+TEST_FUNCTION(amqpvalue_create_array_from_span_creates_a_packed_array)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_byte(42);
-    AMQP_VALUE value2 = amqpvalue_create_byte(42);
-    umock_c_reset_all_calls();
+    int64_t items[] = { 1, -2, 0x0102030405060708 };
+    const void* actual_items;
+    uint32_t actual_count;
+    AMQP_VALUE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(items)));
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_create_array_from_span(AMQP_TYPE_LONG, items, 3);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_span(result, AMQP_TYPE_LONG, &actual_items, &actual_count));
+    ASSERT_ARE_EQUAL(uint32_t, 3, actual_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(items, actual_items, sizeof(items)));
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_216: [- byte: compare the char content.] */
-TEST_FUNCTION(for_2_different_byte_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_483: [ If `items` is NULL and `count` is not 0, or `item_type` is not a fixed width primitive type, `amqpvalue_create_array_from_span` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqpvalue_create_array_from_span_with_NULL_items_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_byte(42);
-    AMQP_VALUE value2 = amqpvalue_create_byte(43);
-    umock_c_reset_all_calls();
+    AMQP_VALUE result;
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_create_array_from_span(AMQP_TYPE_LONG, NULL, 3);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_217: [- short: compare the int16_t content.] */
-TEST_FUNCTION(for_2_equal_short_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_483: [ If `items` is NULL and `count` is not 0, or `item_type` is not a fixed width primitive type, `amqpvalue_create_array_from_span` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqpvalue_create_array_from_span_with_a_string_item_type_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_short(42);
-    AMQP_VALUE value2 = amqpvalue_create_short(42);
-    umock_c_reset_all_calls();
+    const char* items[] = { "a", "b" };
+    AMQP_VALUE result;
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_create_array_from_span(AMQP_TYPE_STRING, items, 2);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_217: [- short: compare the int16_t content.] */
-TEST_FUNCTION(for_2_different_short_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_484: [ If any allocation fails, `amqpvalue_create_array_from_span` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_items_fails_amqpvalue_create_array_from_span_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_short(42);
-    AMQP_VALUE value2 = amqpvalue_create_short(43);
-    umock_c_reset_all_calls();
+    int32_t items[] = { 1, 2 };
+    AMQP_VALUE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(items)))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_create_array_from_span(AMQP_TYPE_INT, items, 2);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+/* amqpvalue_get_array_span */
+
+/* Tests_SRS_AMQPVALUE_01_486: [ If `value`, `items` or `count` is NULL, `amqpvalue_get_array_span` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_array_span_with_NULL_value_fails)
+{
+    // arrange
+    const void* items;
+    uint32_t count;
+    int result;
+
+    // act
+    result = amqpvalue_get_array_span(NULL, AMQP_TYPE_INT, &items, &count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_218: [- int: compare the int32_t content.] */
-TEST_FUNCTION(for_2_equal_int_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_486: [ If `value`, `items` or `count` is NULL, `amqpvalue_get_array_span` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_array_span_with_NULL_count_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_int(42);
-    AMQP_VALUE value2 = amqpvalue_create_int(42);
+    const void* items;
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_array_span(array, AMQP_TYPE_INT, &items, NULL);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
 }
 
-/* Tests_SRS_AMQPVALUE_01_218: [- int: compare the int32_t content.] */
-TEST_FUNCTION(for_2_different_int_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_487: [ If `value` is not an array, `amqpvalue_get_array_span` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_array_span_on_a_list_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_int(42);
-    AMQP_VALUE value2 = amqpvalue_create_int(43);
+    const void* items;
+    uint32_t count;
+    int result;
+    AMQP_VALUE list = amqpvalue_create_list();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_array_span(list, AMQP_TYPE_INT, &items, &count);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(list);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_219: [- long: compare the int64_t content.] */
-TEST_FUNCTION(for_2_equal_long_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_488: [ If the items of the array are not of `item_type` or `item_type` is not a fixed width primitive type, `amqpvalue_get_array_span` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_array_span_with_another_item_type_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_long(42);
-    AMQP_VALUE value2 = amqpvalue_create_long(42);
+    int32_t items[] = { 1, 2 };
+    const int64_t* actual_items;
+    uint32_t count;
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array_from_span(AMQP_TYPE_INT, items, 2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_array_long_span(array, &actual_items, &count);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
 }
 
-/* Tests_SRS_AMQPVALUE_01_219: [- long: compare the int64_t content.] */
-TEST_FUNCTION(for_2_different_long_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_489: [ For an empty array `amqpvalue_get_array_span` shall set `items` to NULL and `count` to 0. ]*/
+TEST_FUNCTION(amqpvalue_get_array_span_on_an_empty_array_returns_no_items)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_long(42);
-    AMQP_VALUE value2 = amqpvalue_create_long(43);
+    const double* items = (const double*)0x4242;
+    uint32_t count = 42;
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_array_double_span(array, &items, &count);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(items);
+    ASSERT_ARE_EQUAL(uint32_t, 0, count);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_224: [- float: compare the float content.] */
-TEST_FUNCTION(for_2_equal_float_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_490: [ If the array is not packed, `amqpvalue_get_array_span` shall fail and return a non-zero value, leaving the array untouched. ]*/
+TEST_FUNCTION(amqpvalue_get_array_uint_span_on_an_array_of_uint_values_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_float(42);
-    AMQP_VALUE value2 = amqpvalue_create_float(42);
+    const uint32_t* items;
+    uint32_t count;
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array();
+    AMQP_VALUE item1 = amqpvalue_create_uint(1);
+    AMQP_VALUE item2 = amqpvalue_create_uint(0xFFFFFFFF);
+    AMQP_VALUE array_item;
+    uint32_t array_item_value;
+    (void)amqpvalue_add_array_item(array, item1);
+    (void)amqpvalue_add_array_item(array, item2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_get_array_uint_span(array, &items, &count);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    array_item = amqpvalue_get_array_item(array, 1);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_uint(array_item, &array_item_value));
+    ASSERT_ARE_EQUAL(uint32_t, 0xFFFFFFFF, array_item_value);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array_item);
+    amqpvalue_destroy(array);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_224: [- float: compare the float content.] */
-TEST_FUNCTION(for_2_different_float_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_585: [ `amqpvalue_pack_array` shall replace the items of an array of `item_type` values by a packed copy of them and return 0, an array already packed with items of `item_type` being left untouched. ]*/
+/* Tests_SRS_AMQPVALUE_01_491: [ The typed `amqpvalue_get_array_*_span` functions shall behave like amqpvalue_get_array_span for their item type. ]*/
+TEST_FUNCTION(amqpvalue_pack_array_packs_an_array_of_uint_values)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_float(42);
-    AMQP_VALUE value2 = amqpvalue_create_float(43);
+    const uint32_t* items;
+    uint32_t count;
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array();
+    AMQP_VALUE item1 = amqpvalue_create_uint(1);
+    AMQP_VALUE item2 = amqpvalue_create_uint(0xFFFFFFFF);
+    (void)amqpvalue_add_array_item(array, item1);
+    (void)amqpvalue_add_array_item(array, item2);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(uint32_t)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_pack_array(array, AMQP_TYPE_UINT);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_uint_span(array, &items, &count));
+    ASSERT_ARE_EQUAL(uint32_t, 2, count);
+    ASSERT_ARE_EQUAL(uint32_t, 1, items[0]);
+    ASSERT_ARE_EQUAL(uint32_t, 0xFFFFFFFF, items[1]);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_225: [- double: compare the double content.] */
-TEST_FUNCTION(for_2_equal_double_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_585: [ `amqpvalue_pack_array` shall replace the items of an array of `item_type` values by a packed copy of them and return 0, an array already packed with items of `item_type` being left untouched. ]*/
+TEST_FUNCTION(amqpvalue_pack_array_on_a_packed_array_leaves_it_untouched)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_double(42);
-    AMQP_VALUE value2 = amqpvalue_create_double(42);
+    int32_t items[] = { 1, 2 };
+    const int32_t* actual_items;
+    uint32_t count;
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array_from_span(AMQP_TYPE_INT, items, 2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_pack_array(array, AMQP_TYPE_INT);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_int_span(array, &actual_items, &count));
+    ASSERT_ARE_EQUAL(uint32_t, 2, count);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
 }
 
-/* Tests_SRS_AMQPVALUE_01_225: [- double: compare the double content.] */
-TEST_FUNCTION(for_2_different_double_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_586: [ If `value` is NULL, `amqpvalue_pack_array` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_pack_array_with_NULL_value_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_double(42);
-    AMQP_VALUE value2 = amqpvalue_create_double(43);
-    umock_c_reset_all_calls();
+    int result;
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_pack_array(NULL, AMQP_TYPE_INT);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_226: [- char: compare the UNICODE character.] */
-TEST_FUNCTION(for_2_equal_char_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_587: [ If `value` is not an array, `amqpvalue_pack_array` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_pack_array_on_a_list_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_char(0x42);
-    AMQP_VALUE value2 = amqpvalue_create_char(0x42);
+    int result;
+    AMQP_VALUE list = amqpvalue_create_list();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_pack_array(list, AMQP_TYPE_INT);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(list);
 }
 
-/* Tests_SRS_AMQPVALUE_01_226: [- char: compare the UNICODE character.] */
-TEST_FUNCTION(for_2_different_char_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_588: [ If the array is empty, its items are not of `item_type`, `item_type` is not a fixed width primitive type, the array was allocated from an arena or any allocation fails, `amqpvalue_pack_array` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_pack_array_with_items_of_another_type_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_char(0x42);
-    AMQP_VALUE value2 = amqpvalue_create_char(0x43);
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array();
+    AMQP_VALUE item = amqpvalue_create_uint(1);
+    (void)amqpvalue_add_array_item(array, item);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_pack_array(array, AMQP_TYPE_INT);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_227: [- timestamp: compare the underlying 64 bit integer.] */
-TEST_FUNCTION(for_2_equal_timestamp_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_588: [ If the array is empty, its items are not of `item_type`, `item_type` is not a fixed width primitive type, the array was allocated from an arena or any allocation fails, `amqpvalue_pack_array` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_packed_items_fails_amqpvalue_pack_array_fails)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_timestamp(0x4242424242424242);
-    AMQP_VALUE value2 = amqpvalue_create_timestamp(0x4242424242424242);
+    int result;
+    AMQP_VALUE array = amqpvalue_create_array();
+    AMQP_VALUE item = amqpvalue_create_uint(1);
+    (void)amqpvalue_add_array_item(array, item);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(uint32_t)))
+        .SetReturn(NULL);
+
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_pack_array(array, AMQP_TYPE_UINT);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_227: [- timestamp: compare the underlying 64 bit integer.] */
-TEST_FUNCTION(for_2_different_timestamp_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_589: [ Comparing, checking the equality of or hashing a packed array shall read its items in place, the array stays packed. ]*/
+TEST_FUNCTION(amqpvalue_are_equal_on_packed_double_arrays_keeps_them_packed)
 {
     // arrange
+    double items[] = { 1.5, -2.25 };
+    const double* actual_items;
+    uint32_t count;
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_timestamp(0x4242424242424242);
-    AMQP_VALUE value2 = amqpvalue_create_timestamp(0x4242424242424243);
+    AMQP_VALUE array1 = amqpvalue_create_array_from_span(AMQP_TYPE_DOUBLE, items, 2);
+    AMQP_VALUE array2 = amqpvalue_create_array_from_span(AMQP_TYPE_DOUBLE, items, 2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_are_equal(array1, array2);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_double_span(array1, &actual_items, &count));
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_double_span(array2, &actual_items, &count));
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array1);
+    amqpvalue_destroy(array2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_228: [- uuid: compare all uuid bytes.] */
-TEST_FUNCTION(for_2_equal_uuid_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_589: [ Comparing, checking the equality of or hashing a packed array shall read its items in place, the array stays packed. ]*/
+TEST_FUNCTION(amqpvalue_compare_and_hash_on_a_packed_array_keep_it_packed)
 {
     // arrange
-    bool result;
-    uuid bin1 = { 0x42 };
-    uuid bin2 = { 0x42 };
-    AMQP_VALUE value1 = amqpvalue_create_uuid(bin1);
-    AMQP_VALUE value2 = amqpvalue_create_uuid(bin2);
+    int32_t items1[] = { 1, 2 };
+    int32_t items2[] = { 1, 3 };
+    const int32_t* actual_items;
+    uint32_t count;
+    int result;
+    AMQP_VALUE array1 = amqpvalue_create_array_from_span(AMQP_TYPE_INT, items1, 2);
+    AMQP_VALUE array2 = amqpvalue_create_array_from_span(AMQP_TYPE_INT, items2, 2);
+    AMQP_VALUE array3 = amqpvalue_create_array();
+    AMQP_VALUE item1 = amqpvalue_create_int(1);
+    AMQP_VALUE item2 = amqpvalue_create_int(2);
+    (void)amqpvalue_add_array_item(array3, item1);
+    (void)amqpvalue_add_array_item(array3, item2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_compare(array1, array2);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_IS_TRUE(result < 0);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_compare(array1, array3));
+    ASSERT_ARE_EQUAL(uint32_t, amqpvalue_hash(array3), amqpvalue_hash(array1));
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_int_span(array1, &actual_items, &count));
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(array1);
+    amqpvalue_destroy(array2);
+    amqpvalue_destroy(array3);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_228: [- uuid: compare all uuid bytes.] */
-TEST_FUNCTION(for_2_different_uuid_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_492: [ Getting an item of a packed array shall create a new AMQP value for it, the array stays packed. ]*/
+TEST_FUNCTION(amqpvalue_get_array_item_on_a_packed_array_returns_the_item)
 {
     // arrange
-    bool result;
-    uuid bin1 = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x42 };
-    uuid bin2 = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x43 };
-    AMQP_VALUE value1 = amqpvalue_create_uuid(bin1);
-    AMQP_VALUE value2 = amqpvalue_create_uuid(bin2);
+    double items[] = { 1.5, -2.25 };
+    double item_value;
+    AMQP_VALUE item;
+    AMQP_VALUE array = amqpvalue_create_array_from_span(AMQP_TYPE_DOUBLE, items, 2);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    item = amqpvalue_get_array_item(array, 1);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_NOT_NULL(item);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_double(item, &item_value));
+    ASSERT_ARE_EQUAL(double, -2.25, item_value);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(item);
+    amqpvalue_destroy(array);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_229: [- binary: compare all binary bytes.] */
-TEST_FUNCTION(for_2_equal_binary_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_493: [ Adding an item to a packed array shall first turn its items into AMQP values. ]*/
+TEST_FUNCTION(amqpvalue_add_array_item_on_a_packed_array_appends_the_item)
 {
     // arrange
-    bool result;
-    unsigned char bytes1[] = { 0x42 };
-    unsigned char bytes2[] = { 0x42 };
-    amqp_binary bin1;
-    amqp_binary bin2;
-    AMQP_VALUE value1;
-    AMQP_VALUE value2;
-    bin1.bytes = bytes1;
-    bin1.length = sizeof(bytes1);
-    bin2.bytes = bytes2;
-    bin2.length = sizeof(bytes2);
-    value1 = amqpvalue_create_binary(bin1);
-    value2 = amqpvalue_create_binary(bin2);
+    int32_t items[] = { 1, 2 };
+    int32_t item_value;
+    uint32_t count;
+    int result;
+    AMQP_VALUE item = amqpvalue_create_int(3);
+    AMQP_VALUE actual_item;
+    AMQP_VALUE array = amqpvalue_create_array_from_span(AMQP_TYPE_INT, items, 2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_add_array_item(array, item);
 
     // assert
-    ASSERT_IS_TRUE(result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)amqpvalue_get_array_item_count(array, &count);
+    ASSERT_ARE_EQUAL(uint32_t, 3, count);
+    actual_item = amqpvalue_get_array_item(array, 0);
+    (void)amqpvalue_get_int(actual_item, &item_value);
+    ASSERT_ARE_EQUAL(int32_t, 1, item_value);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(actual_item);
+    amqpvalue_destroy(item);
+    amqpvalue_destroy(array);
 }
 
-/* Tests_SRS_AMQPVALUE_01_229: [- binary: compare all binary bytes.] */
-TEST_FUNCTION(for_2_different_binary_values_with_same_length_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_494: [ An array of a fixed width primitive type shall be encoded as array8 when its count and size fit 1 byte and as array32 otherwise, with all items after a single constructor. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_encodes_a_packed_array_as_array8)
 {
     // arrange
-    bool result;
-    unsigned char bytes1[] = { 0x42 };
-    unsigned char bytes2[] = { 0x43 };
-    amqp_binary bin1;
-    amqp_binary bin2;
-    AMQP_VALUE value1;
-    AMQP_VALUE value2;
-    bin1.bytes = bytes1;
-    bin1.length = sizeof(bytes1);
-    bin2.bytes = bytes2;
-    bin2.length = sizeof(bytes2);
-    value1 = amqpvalue_create_binary(bin1);
-    value2 = amqpvalue_create_binary(bin2);
+    int result;
+    unsigned char buffer[32];
+    unsigned char expected_bytes[] = { 0xE0, 0x0A, 0x02, 0x71, 0x00, 0x00, 0x00, 0x01, 0xFF, 0xFE, 0x79, 0x60 };
+    size_t encoded_size;
+    int32_t items[] = { 1, -100000 };
+    AMQP_VALUE source = amqpvalue_create_array_from_span(AMQP_TYPE_INT, items, 2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_encode_to_buffer(source, buffer, sizeof(buffer), &encoded_size);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), encoded_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(source);
 }
 
-/* Tests_SRS_AMQPVALUE_01_229: [- binary: compare all binary bytes.] */
-TEST_FUNCTION(for_2_different_binary_values_with_different_length_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_494: [ An array of a fixed width primitive type shall be encoded as array8 when its count and size fit 1 byte and as array32 otherwise, with all items after a single constructor. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_encodes_a_large_packed_array_as_array32)
 {
     // arrange
-    bool result;
-    unsigned char bytes1[] = { 0x42 };
-    unsigned char bytes2[] = { 0x42, 0x43 };
-    amqp_binary bin1;
-    amqp_binary bin2;
-    AMQP_VALUE value1;
-    AMQP_VALUE value2;
-    bin1.bytes = bytes1;
-    bin1.length = sizeof(bytes1);
-    bin2.bytes = bytes2;
-    bin2.length = sizeof(bytes2);
-    value1 = amqpvalue_create_binary(bin1);
-    value2 = amqpvalue_create_binary(bin2);
+    int result;
+    unsigned char buffer[520];
+    unsigned char expected_header[] = { 0xF0, 0x00, 0x00, 0x04, 0x05, 0x00, 0x00, 0x01, 0x00, 0x70 };
+    size_t encoded_size;
+    uint32_t items[256];
+    size_t i;
+    AMQP_VALUE source;
+    for (i = 0; i < 256; i++)
+    {
+        items[i] = (uint32_t)i;
+    }
+    source = amqpvalue_create_array_from_span(AMQP_TYPE_UINT, items, 256);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_encode_to_buffer(source, buffer, sizeof(buffer), &encoded_size);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_header) + (256 * 4), encoded_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_header, buffer, sizeof(expected_header)));
+    ASSERT_ARE_EQUAL(int, 0xFF, (int)buffer[encoded_size - 1]);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_destroy(source);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
-TEST_FUNCTION(for_2_equal_string_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_495: [ When all the bytes of an array of fixed width primitives are in the buffer passed to amqpvalue_decode_bytes and no arena is set, the decoder shall decode it as a packed array. ]*/
+TEST_FUNCTION(amqpvalue_decode_array_of_longs_gives_a_packed_array)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_string("a");
-    AMQP_VALUE value2 = amqpvalue_create_string("a");
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xE0, 0x12, 0x02, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    const int64_t* items;
+    uint32_t count;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_long_span(decoded_values[0], &items, &count));
+    ASSERT_ARE_EQUAL(uint32_t, 2, count);
+    ASSERT_ARE_EQUAL(int64_t, 42, items[0]);
+    ASSERT_ARE_EQUAL(int64_t, -1, items[1]);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
-TEST_FUNCTION(for_2_different_string_values_with_same_length_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_495: [ When all the bytes of an array of fixed width primitives are in the buffer passed to amqpvalue_decode_bytes and no arena is set, the decoder shall decode it as a packed array. ]*/
+TEST_FUNCTION(amqpvalue_decode_array_of_smallints_gives_a_packed_array_of_ints)
 {
     // arrange
-    bool result;
-    AMQP_VALUE value1 = amqpvalue_create_string("a");
-    AMQP_VALUE value2 = amqpvalue_create_string("b");
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xE0, 0x05, 0x03, 0x54, 0xFF, 0x01, 0x80 };
+    const int32_t* items;
+    uint32_t count;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_array_int_span(decoded_values[0], &items, &count));
+    ASSERT_ARE_EQUAL(uint32_t, 3, count);
+    ASSERT_ARE_EQUAL(int32_t, -1, items[0]);
+    ASSERT_ARE_EQUAL(int32_t, 1, items[1]);
+    ASSERT_ARE_EQUAL(int32_t, -128, items[2]);
 
     // cleanup
-    amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
-TEST_FUNCTION(for_2_different_string_values_with_different_length_amqpvalue_are_equal_returns_false)
+/* amqpvalue_are_equal */
+
+/* Tests_SRS_AMQPVALUE_01_207: [If value1 and value2 are NULL, amqpvalue_are_equal shall return true.] */
+TEST_FUNCTION(amqpvalue_are_equal_with_NULL_values_returns_true)
+{
+    // arrange
+    
+    // act
+    bool result = amqpvalue_are_equal(NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_208: [If one of the arguments is NULL and the other is not, amqpvalue_are_equal shall return false.] */
+TEST_FUNCTION(when_value2_is_NULL_and_value1_is_not_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_string("a");
-    AMQP_VALUE value2 = amqpvalue_create_string("ab");
+    AMQP_VALUE value1 = amqpvalue_create_null();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_are_equal(value1, NULL);
 
     // assert
     ASSERT_IS_FALSE(result);
@@ -5513,38 +6182,34 @@ TEST_FUNCTION(for_2_different_string_values_with_different_length_amqpvalue_are_
 
     // cleanup
     amqpvalue_destroy(value1);
-    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
-TEST_FUNCTION(for_2_equal_symbol_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_208: [If one of the arguments is NULL and the other is not, amqpvalue_are_equal shall return false.] */
+TEST_FUNCTION(when_value1_is_NULL_and_value2_is_not_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_symbol("a");
-    AMQP_VALUE value2 = amqpvalue_create_symbol("a");
+    AMQP_VALUE value2 = amqpvalue_create_null();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_are_equal(value1, value2);
+    result = amqpvalue_are_equal(NULL, value2);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
-TEST_FUNCTION(for_2_different_symbol_values_with_same_length_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_209: [If the types for value1 and value2 are different amqpvalue_are_equal shall return false.] */
+TEST_FUNCTION(when_value1_is_uint_and_value2_is_ulong_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_symbol("a");
-    AMQP_VALUE value2 = amqpvalue_create_symbol("b");
+    AMQP_VALUE value1 = amqpvalue_create_uint(42);
+    AMQP_VALUE value2 = amqpvalue_create_ulong(42);
     umock_c_reset_all_calls();
 
     // act
@@ -5559,20 +6224,21 @@ TEST_FUNCTION(for_2_different_symbol_values_with_same_length_amqpvalue_are_equal
     amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
-TEST_FUNCTION(for_2_different_symbol_values_with_different_length_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_210: [- null: always equal.] */
+TEST_FUNCTION(for_2_null_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_symbol("a");
-    AMQP_VALUE value2 = amqpvalue_create_symbol("ab");
+    AMQP_VALUE value1 = amqpvalue_create_null();
+    AMQP_VALUE value2 = amqpvalue_create_null();
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
@@ -5581,13 +6247,13 @@ TEST_FUNCTION(for_2_different_symbol_values_with_different_length_amqpvalue_are_
 }
 
 /* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-TEST_FUNCTION(for_2_empty_list_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_211: [- boolean: compare the bool content.] */
+TEST_FUNCTION(for_2_equal_boolean_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE value1 = amqpvalue_create_boolean(false);
+    AMQP_VALUE value2 = amqpvalue_create_boolean(false);
     umock_c_reset_all_calls();
 
     // act
@@ -5602,67 +6268,56 @@ TEST_FUNCTION(for_2_empty_list_values_amqpvalue_are_equal_returns_true)
     amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-TEST_FUNCTION(for_2_lists_with_one_null_item_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_211: [- boolean: compare the bool content.] */
+TEST_FUNCTION(for_2_different_boolean_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(value1, 0, null_value);
-    (void)amqpvalue_set_list_item(value2, 0, null_value);
+    AMQP_VALUE value1 = amqpvalue_create_boolean(false);
+    AMQP_VALUE value2 = amqpvalue_create_boolean(true);
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-TEST_FUNCTION(for_2_lists_with_different_number_of_null_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_212: [- ubyte: compare the unsigned char content.] */
+TEST_FUNCTION(for_2_equal_ubyte_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(value1, 0, null_value);
-    (void)amqpvalue_set_list_item(value2, 0, null_value);
-    (void)amqpvalue_set_list_item(value2, 1, null_value);
+    AMQP_VALUE value1 = amqpvalue_create_ubyte(42);
+    AMQP_VALUE value2 = amqpvalue_create_ubyte(42);
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-TEST_FUNCTION(for_2_lists_one_empty_and_one_with_a_value_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_212: [- ubyte: compare the unsigned char content.] */
+TEST_FUNCTION(for_2_different_ubyte_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(value1, 0, null_value);
+    AMQP_VALUE value1 = amqpvalue_create_ubyte(42);
+    AMQP_VALUE value2 = amqpvalue_create_ubyte(43);
     umock_c_reset_all_calls();
 
     // act
@@ -5675,20 +6330,16 @@ TEST_FUNCTION(for_2_lists_one_empty_and_one_with_a_value_amqpvalue_are_equal_ret
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(null_value);
 }
 
 /* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-TEST_FUNCTION(for_2_lists_with_one_identical_int_value_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_213: [- ushort: compare the uint16_t content.] */
+TEST_FUNCTION(for_2_equal_ushort_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE int_value = amqpvalue_create_int(42);
-    (void)amqpvalue_set_list_item(value1, 0, int_value);
-    (void)amqpvalue_set_list_item(value2, 0, int_value);
+    AMQP_VALUE value1 = amqpvalue_create_ushort(42);
+    AMQP_VALUE value2 = amqpvalue_create_ushort(42);
     umock_c_reset_all_calls();
 
     // act
@@ -5701,20 +6352,15 @@ TEST_FUNCTION(for_2_lists_with_one_identical_int_value_amqpvalue_are_equal_retur
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(int_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-TEST_FUNCTION(for_2_lists_with_2_different_int_values_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_212: [- ushort: compare the unsigned char content.] */
+TEST_FUNCTION(for_2_different_ushort_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE int_value1 = amqpvalue_create_int(42);
-    AMQP_VALUE int_value2 = amqpvalue_create_int(43);
-    (void)amqpvalue_set_list_item(value1, 0, int_value1);
-    (void)amqpvalue_set_list_item(value2, 0, int_value2);
+    AMQP_VALUE value1 = amqpvalue_create_ushort(42);
+    AMQP_VALUE value2 = amqpvalue_create_ushort(43);
     umock_c_reset_all_calls();
 
     // act
@@ -5727,112 +6373,102 @@ TEST_FUNCTION(for_2_lists_with_2_different_int_values_amqpvalue_are_equal_return
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(int_value1);
-    amqpvalue_destroy(int_value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
-TEST_FUNCTION(for_2_lists_with_different_int_values_at_index_1_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_214: [- uint: compare the uint32_t content.] */
+TEST_FUNCTION(for_2_equal_uint_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE int_value1 = amqpvalue_create_int(42);
-    AMQP_VALUE int_value2 = amqpvalue_create_int(43);
-    (void)amqpvalue_set_list_item(value1, 0, int_value1);
-    (void)amqpvalue_set_list_item(value2, 0, int_value1);
-    (void)amqpvalue_set_list_item(value1, 0, int_value1);
-    (void)amqpvalue_set_list_item(value2, 0, int_value2);
+    AMQP_VALUE value1 = amqpvalue_create_uint(42);
+    AMQP_VALUE value2 = amqpvalue_create_uint(42);
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(int_value1);
-    amqpvalue_destroy(int_value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
-TEST_FUNCTION(for_2_lists_each_with_one_empty_list_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_214: [- uint: compare the uint32_t content.] */
+TEST_FUNCTION(for_2_different_uint_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE inner_list1 = amqpvalue_create_list();
-    AMQP_VALUE inner_list2 = amqpvalue_create_list();
-    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
-    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
+    AMQP_VALUE value1 = amqpvalue_create_uint(42);
+    AMQP_VALUE value2 = amqpvalue_create_uint(43);
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(inner_list1);
-    amqpvalue_destroy(inner_list2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
-TEST_FUNCTION(when_inner_lists_have_different_item_count_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_215: [- ulong: compare the uint64_t content.] */
+TEST_FUNCTION(for_2_equal_ulong_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE inner_list1 = amqpvalue_create_list();
-    AMQP_VALUE inner_list2 = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(inner_list1, 0, null_value);
-    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
-    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
+    AMQP_VALUE value1 = amqpvalue_create_ulong(42);
+    AMQP_VALUE value2 = amqpvalue_create_ulong(42);
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_215: [- ulong: compare the uint64_t content.] */
+TEST_FUNCTION(for_2_different_ulong_values_amqpvalue_are_equal_returns_false)
+{
+    // arrange
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_ulong(42);
+    AMQP_VALUE value2 = amqpvalue_create_ulong(43);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_are_equal(value1, value2);
+
+    // assert
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(inner_list1);
-    amqpvalue_destroy(inner_list2);
-    amqpvalue_destroy(null_value);
 }
 
 /* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
-TEST_FUNCTION(when_inner_lists_have_each_1_item_count_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_216: [- byte: compare the char content.] */
+TEST_FUNCTION(for_2_equal_byte_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE inner_list1 = amqpvalue_create_list();
-    AMQP_VALUE inner_list2 = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(inner_list1, 0, null_value);
-    (void)amqpvalue_set_list_item(inner_list2, 0, null_value);
-    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
-    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
+    AMQP_VALUE value1 = amqpvalue_create_byte(42);
+    AMQP_VALUE value2 = amqpvalue_create_byte(42);
     umock_c_reset_all_calls();
 
     // act
@@ -5845,26 +6481,15 @@ TEST_FUNCTION(when_inner_lists_have_each_1_item_count_amqpvalue_are_equal_return
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(inner_list1);
-    amqpvalue_destroy(inner_list2);
-    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
-TEST_FUNCTION(when_inner_lists_have_each_1_item_count_but_items_are_different_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_216: [- byte: compare the char content.] */
+TEST_FUNCTION(for_2_different_byte_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_list();
-    AMQP_VALUE value2 = amqpvalue_create_list();
-    AMQP_VALUE inner_list1 = amqpvalue_create_list();
-    AMQP_VALUE inner_list2 = amqpvalue_create_list();
-    AMQP_VALUE inner_item1 = amqpvalue_create_uint(42);
-    AMQP_VALUE inner_item2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_list_item(inner_list1, 0, inner_item1);
-    (void)amqpvalue_set_list_item(inner_list2, 0, inner_item2);
-    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
-    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
+    AMQP_VALUE value1 = amqpvalue_create_byte(42);
+    AMQP_VALUE value2 = amqpvalue_create_byte(43);
     umock_c_reset_all_calls();
 
     // act
@@ -5877,20 +6502,16 @@ TEST_FUNCTION(when_inner_lists_have_each_1_item_count_but_items_are_different_am
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(inner_list1);
-    amqpvalue_destroy(inner_list2);
-    amqpvalue_destroy(inner_item1);
-    amqpvalue_destroy(inner_item2);
 }
 
 /* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-TEST_FUNCTION(for_2_empty_map_values_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_217: [- short: compare the int16_t content.] */
+TEST_FUNCTION(for_2_equal_short_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE value1 = amqpvalue_create_short(42);
+    AMQP_VALUE value2 = amqpvalue_create_short(42);
     umock_c_reset_all_calls();
 
     // act
@@ -5905,75 +6526,56 @@ TEST_FUNCTION(for_2_empty_map_values_amqpvalue_are_equal_returns_true)
     amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-TEST_FUNCTION(for_2_maps_with_one_null_key_and_null_value_item_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_217: [- short: compare the int16_t content.] */
+TEST_FUNCTION(for_2_different_short_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_map_value(value1, null_value, null_value);
-    (void)amqpvalue_set_map_value(value2, null_value, null_value);
+    AMQP_VALUE value1 = amqpvalue_create_short(42);
+    AMQP_VALUE value2 = amqpvalue_create_short(43);
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_TRUE(result);
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(null_value);
 }
 
 /* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-TEST_FUNCTION(for_2_maps_with_one_pair_each_where_key_is_different_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_218: [- int: compare the int32_t content.] */
+TEST_FUNCTION(for_2_equal_int_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
-    AMQP_VALUE key1 = amqpvalue_create_uint(42);
-    AMQP_VALUE key2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_map_value(value1, key1, pair_value);
-    (void)amqpvalue_set_map_value(value2, key2, pair_value);
+    AMQP_VALUE value1 = amqpvalue_create_int(42);
+    AMQP_VALUE value2 = amqpvalue_create_int(42);
     umock_c_reset_all_calls();
 
     // act
     result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_FALSE(result);
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(pair_value);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-TEST_FUNCTION(for_2_maps_with_one_pair_each_where_value_is_different_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_218: [- int: compare the int32_t content.] */
+TEST_FUNCTION(for_2_different_int_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE pair_value1 = amqpvalue_create_uint(42);
-    AMQP_VALUE pair_value2 = amqpvalue_create_uint(43);
-    AMQP_VALUE key = amqpvalue_create_uint(42);
-    (void)amqpvalue_set_map_value(value1, key, pair_value1);
-    (void)amqpvalue_set_map_value(value2, key, pair_value2);
+    AMQP_VALUE value1 = amqpvalue_create_int(42);
+    AMQP_VALUE value2 = amqpvalue_create_int(43);
     umock_c_reset_all_calls();
 
     // act
@@ -5986,23 +6588,16 @@ TEST_FUNCTION(for_2_maps_with_one_pair_each_where_value_is_different_amqpvalue_a
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(pair_value1);
-    amqpvalue_destroy(pair_value2);
-    amqpvalue_destroy(key);
 }
 
 /* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-TEST_FUNCTION(for_2_maps_with_one_pair_each_where_key_and_value_are_equal_amqpvalue_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_219: [- long: compare the int64_t content.] */
+TEST_FUNCTION(for_2_equal_long_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
-    AMQP_VALUE key = amqpvalue_create_uint(42);
-    (void)amqpvalue_set_map_value(value1, key, pair_value);
-    (void)amqpvalue_set_map_value(value2, key, pair_value);
+    AMQP_VALUE value1 = amqpvalue_create_long(42);
+    AMQP_VALUE value2 = amqpvalue_create_long(42);
     umock_c_reset_all_calls();
 
     // act
@@ -6015,24 +6610,15 @@ TEST_FUNCTION(for_2_maps_with_one_pair_each_where_key_and_value_are_equal_amqpva
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(pair_value);
-    amqpvalue_destroy(key);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-TEST_FUNCTION(for_2_maps_with_different_pair_count_amqpvalue_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_219: [- long: compare the int64_t content.] */
+TEST_FUNCTION(for_2_different_long_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
-    AMQP_VALUE key1 = amqpvalue_create_uint(42);
-    AMQP_VALUE key2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_map_value(value1, key1, pair_value);
-    (void)amqpvalue_set_map_value(value2, key1, pair_value);
-    (void)amqpvalue_set_map_value(value2, key2, pair_value);
+    AMQP_VALUE value1 = amqpvalue_create_long(42);
+    AMQP_VALUE value2 = amqpvalue_create_long(43);
     umock_c_reset_all_calls();
 
     // act
@@ -6045,26 +6631,16 @@ TEST_FUNCTION(for_2_maps_with_different_pair_count_amqpvalue_are_equal_returns_f
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(pair_value);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
 }
 
 /* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-TEST_FUNCTION(for_2_maps_with_2_equal_pairs_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_224: [- float: compare the float content.] */
+TEST_FUNCTION(for_2_equal_float_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
-    AMQP_VALUE key1 = amqpvalue_create_uint(42);
-    AMQP_VALUE key2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_map_value(value1, key1, pair_value);
-    (void)amqpvalue_set_map_value(value1, key2, pair_value);
-    (void)amqpvalue_set_map_value(value2, key1, pair_value);
-    (void)amqpvalue_set_map_value(value2, key2, pair_value);
+    AMQP_VALUE value1 = amqpvalue_create_float(42);
+    AMQP_VALUE value2 = amqpvalue_create_float(42);
     umock_c_reset_all_calls();
 
     // act
@@ -6077,27 +6653,15 @@ TEST_FUNCTION(for_2_maps_with_2_equal_pairs_are_equal_returns_true)
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(pair_value);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
-/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
-/* Tests_SRS_AMQPVALUE_01_126: [Unless known to be otherwise, maps MUST be considered to be ordered, that is, the order of the key-value pairs is semantically important and two maps which are different only in the order in which their key-value pairs are encoded are not equal.] */
-TEST_FUNCTION(for_2_maps_with_2_equal_pairs_out_of_order_are_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_224: [- float: compare the float content.] */
+TEST_FUNCTION(for_2_different_float_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
-    AMQP_VALUE key1 = amqpvalue_create_uint(42);
-    AMQP_VALUE key2 = amqpvalue_create_uint(43);
-    (void)amqpvalue_set_map_value(value1, key1, pair_value);
-    (void)amqpvalue_set_map_value(value1, key2, pair_value);
-    (void)amqpvalue_set_map_value(value2, key2, pair_value);
-    (void)amqpvalue_set_map_value(value2, key1, pair_value);
+    AMQP_VALUE value1 = amqpvalue_create_float(42);
+    AMQP_VALUE value2 = amqpvalue_create_float(43);
     umock_c_reset_all_calls();
 
     // act
@@ -6110,23 +6674,16 @@ TEST_FUNCTION(for_2_maps_with_2_equal_pairs_out_of_order_are_equal_returns_false
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(pair_value);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_234: [Nesting shall be considered in comparison.] */
-TEST_FUNCTION(when_inner_maps_are_equal_are_equal_returns_true)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_225: [- double: compare the double content.] */
+TEST_FUNCTION(for_2_equal_double_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE key = amqpvalue_create_uint(42);
-    AMQP_VALUE inner_map1 = amqpvalue_create_map();
-    AMQP_VALUE inner_map2 = amqpvalue_create_map();
-    (void)amqpvalue_set_map_value(value1, key, inner_map1);
-    (void)amqpvalue_set_map_value(value2, key, inner_map2);
+    AMQP_VALUE value1 = amqpvalue_create_double(42);
+    AMQP_VALUE value2 = amqpvalue_create_double(42);
     umock_c_reset_all_calls();
 
     // act
@@ -6139,25 +6696,15 @@ TEST_FUNCTION(when_inner_maps_are_equal_are_equal_returns_true)
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(inner_map1);
-    amqpvalue_destroy(inner_map2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_234: [Nesting shall be considered in comparison.] */
-TEST_FUNCTION(when_inner_maps_are_equal_not_are_not_equal_returns_false)
+/* Tests_SRS_AMQPVALUE_01_225: [- double: compare the double content.] */
+TEST_FUNCTION(for_2_different_double_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
     bool result;
-    AMQP_VALUE value1 = amqpvalue_create_map();
-    AMQP_VALUE value2 = amqpvalue_create_map();
-    AMQP_VALUE key = amqpvalue_create_uint(42);
-    AMQP_VALUE pair_value = amqpvalue_create_uint(43);
-    AMQP_VALUE inner_map1 = amqpvalue_create_map();
-    AMQP_VALUE inner_map2 = amqpvalue_create_map();
-    (void)amqpvalue_set_map_value(inner_map1, key, pair_value);
-    (void)amqpvalue_set_map_value(value1, key, inner_map1);
-    (void)amqpvalue_set_map_value(value2, key, inner_map2);
+    AMQP_VALUE value1 = amqpvalue_create_double(42);
+    AMQP_VALUE value2 = amqpvalue_create_double(43);
     umock_c_reset_all_calls();
 
     // act
@@ -6170,4365 +6717,9097 @@ TEST_FUNCTION(when_inner_maps_are_equal_not_are_not_equal_returns_false)
     // cleanup
     amqpvalue_destroy(value1);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(pair_value);
-    amqpvalue_destroy(inner_map1);
-    amqpvalue_destroy(inner_map2);
 }
 
-/* amqpvalue_clone */
-
-/* Tests_SRS_AMQPVALUE_01_402: [ If `value` is NULL, `amqpvalue_clone` shall return NULL. ]*/
-TEST_FUNCTION(amqpvalue_clone_with_NULL_returns_NULL)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_226: [- char: compare the UNICODE character.] */
+TEST_FUNCTION(for_2_equal_char_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_char(0x42);
+    AMQP_VALUE value2 = amqpvalue_create_char(0x42);
+    umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(NULL);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NULL(result);
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_237: [null] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_null_succesfully)
+/* Tests_SRS_AMQPVALUE_01_226: [- char: compare the UNICODE character.] */
+TEST_FUNCTION(for_2_different_char_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_null();
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_char(0x42);
+    AMQP_VALUE value2 = amqpvalue_create_char(0x43);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_238: [boolean] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_boolean_succesfully_false_value)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_227: [- timestamp: compare the underlying 64 bit integer.] */
+TEST_FUNCTION(for_2_equal_timestamp_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_boolean(false);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_timestamp(0x4242424242424242);
+    AMQP_VALUE value2 = amqpvalue_create_timestamp(0x4242424242424242);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_238: [boolean] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_boolean_succesfully_true_value)
+/* Tests_SRS_AMQPVALUE_01_227: [- timestamp: compare the underlying 64 bit integer.] */
+TEST_FUNCTION(for_2_different_timestamp_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_boolean(true);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_timestamp(0x4242424242424242);
+    AMQP_VALUE value2 = amqpvalue_create_timestamp(0x4242424242424243);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_239: [ubyte] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_ubyte_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_228: [- uuid: compare all uuid bytes.] */
+TEST_FUNCTION(for_2_equal_uuid_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_ubyte(42);
+    bool result;
+    uuid bin1 = { 0x42 };
+    uuid bin2 = { 0x42 };
+    AMQP_VALUE value1 = amqpvalue_create_uuid(bin1);
+    AMQP_VALUE value2 = amqpvalue_create_uuid(bin2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_239: [ubyte] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_ubyte_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_228: [- uuid: compare all uuid bytes.] */
+TEST_FUNCTION(for_2_different_uuid_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_ubyte(43);
+    bool result;
+    uuid bin1 = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x42 };
+    uuid bin2 = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x43 };
+    AMQP_VALUE value1 = amqpvalue_create_uuid(bin1);
+    AMQP_VALUE value2 = amqpvalue_create_uuid(bin2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_240: [ushort] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_ushort_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_229: [- binary: compare all binary bytes.] */
+TEST_FUNCTION(for_2_equal_binary_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_ushort(42);
+    bool result;
+    unsigned char bytes1[] = { 0x42 };
+    unsigned char bytes2[] = { 0x42 };
+    amqp_binary bin1;
+    amqp_binary bin2;
+    AMQP_VALUE value1;
+    AMQP_VALUE value2;
+    bin1.bytes = bytes1;
+    bin1.length = sizeof(bytes1);
+    bin2.bytes = bytes2;
+    bin2.length = sizeof(bytes2);
+    value1 = amqpvalue_create_binary(bin1);
+    value2 = amqpvalue_create_binary(bin2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_240: [ushort] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_ushort_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_229: [- binary: compare all binary bytes.] */
+TEST_FUNCTION(for_2_different_binary_values_with_same_length_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_ushort(43);
+    bool result;
+    unsigned char bytes1[] = { 0x42 };
+    unsigned char bytes2[] = { 0x43 };
+    amqp_binary bin1;
+    amqp_binary bin2;
+    AMQP_VALUE value1;
+    AMQP_VALUE value2;
+    bin1.bytes = bytes1;
+    bin1.length = sizeof(bytes1);
+    bin2.bytes = bytes2;
+    bin2.length = sizeof(bytes2);
+    value1 = amqpvalue_create_binary(bin1);
+    value2 = amqpvalue_create_binary(bin2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_241: [uint] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_uint_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_229: [- binary: compare all binary bytes.] */
+TEST_FUNCTION(for_2_different_binary_values_with_different_length_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_uint(42);
+    bool result;
+    unsigned char bytes1[] = { 0x42 };
+    unsigned char bytes2[] = { 0x42, 0x43 };
+    amqp_binary bin1;
+    amqp_binary bin2;
+    AMQP_VALUE value1;
+    AMQP_VALUE value2;
+    bin1.bytes = bytes1;
+    bin1.length = sizeof(bytes1);
+    bin2.bytes = bytes2;
+    bin2.length = sizeof(bytes2);
+    value1 = amqpvalue_create_binary(bin1);
+    value2 = amqpvalue_create_binary(bin2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_241: [uint] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_uint_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
+TEST_FUNCTION(for_2_equal_string_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_uint(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_string("a");
+    AMQP_VALUE value2 = amqpvalue_create_string("a");
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_242: [ulong] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_ulong_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
+TEST_FUNCTION(for_2_different_string_values_with_same_length_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_ulong(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_string("a");
+    AMQP_VALUE value2 = amqpvalue_create_string("b");
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_242: [ulong] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_ulong_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
+TEST_FUNCTION(for_2_different_string_values_with_different_length_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_ulong(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_string("a");
+    AMQP_VALUE value2 = amqpvalue_create_string("ab");
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_243: [byte] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_byte_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
+TEST_FUNCTION(for_2_equal_symbol_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_byte(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_symbol("a");
+    AMQP_VALUE value2 = amqpvalue_create_symbol("a");
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_243: [byte] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_byte_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
+TEST_FUNCTION(for_2_different_symbol_values_with_same_length_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_byte(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_symbol("a");
+    AMQP_VALUE value2 = amqpvalue_create_symbol("b");
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_244: [short] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_short_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
+TEST_FUNCTION(for_2_different_symbol_values_with_different_length_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_short(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_symbol("a");
+    AMQP_VALUE value2 = amqpvalue_create_symbol("ab");
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_244: [short] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_short_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
+TEST_FUNCTION(for_2_empty_list_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_short(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_245: [int] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_int_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
+TEST_FUNCTION(for_2_lists_with_one_null_item_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_int(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(value1, 0, null_value);
+    (void)amqpvalue_set_list_item(value2, 0, null_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_245: [int] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_int_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
+TEST_FUNCTION(for_2_lists_with_different_number_of_null_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_int(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(value1, 0, null_value);
+    (void)amqpvalue_set_list_item(value2, 0, null_value);
+    (void)amqpvalue_set_list_item(value2, 1, null_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_246: [long] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_long_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
+TEST_FUNCTION(for_2_lists_one_empty_and_one_with_a_value_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_long(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(value1, 0, null_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_246: [long] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_long_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
+TEST_FUNCTION(for_2_lists_with_one_identical_int_value_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_long(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE int_value = amqpvalue_create_int(42);
+    (void)amqpvalue_set_list_item(value1, 0, int_value);
+    (void)amqpvalue_set_list_item(value2, 0, int_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(int_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_247: [float] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_float_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
+TEST_FUNCTION(for_2_lists_with_2_different_int_values_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_float(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE int_value1 = amqpvalue_create_int(42);
+    AMQP_VALUE int_value2 = amqpvalue_create_int(43);
+    (void)amqpvalue_set_list_item(value1, 0, int_value1);
+    (void)amqpvalue_set_list_item(value2, 0, int_value2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(int_value1);
+    amqpvalue_destroy(int_value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_247: [float] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_float_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_231: [- list: compare list item count and each element.] */
+TEST_FUNCTION(for_2_lists_with_different_int_values_at_index_1_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_float(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE int_value1 = amqpvalue_create_int(42);
+    AMQP_VALUE int_value2 = amqpvalue_create_int(43);
+    (void)amqpvalue_set_list_item(value1, 0, int_value1);
+    (void)amqpvalue_set_list_item(value2, 0, int_value1);
+    (void)amqpvalue_set_list_item(value1, 0, int_value1);
+    (void)amqpvalue_set_list_item(value2, 0, int_value2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(int_value1);
+    amqpvalue_destroy(int_value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_248: [double] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_double_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
+TEST_FUNCTION(for_2_lists_each_with_one_empty_list_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_double(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE inner_list1 = amqpvalue_create_list();
+    AMQP_VALUE inner_list2 = amqpvalue_create_list();
+    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
+    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(inner_list1);
+    amqpvalue_destroy(inner_list2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_248: [double] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_double_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
+TEST_FUNCTION(when_inner_lists_have_different_item_count_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_double(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE inner_list1 = amqpvalue_create_list();
+    AMQP_VALUE inner_list2 = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(inner_list1, 0, null_value);
+    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
+    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(inner_list1);
+    amqpvalue_destroy(inner_list2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_252: [char] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_char_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
+TEST_FUNCTION(when_inner_lists_have_each_1_item_count_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_char(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE inner_list1 = amqpvalue_create_list();
+    AMQP_VALUE inner_list2 = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(inner_list1, 0, null_value);
+    (void)amqpvalue_set_list_item(inner_list2, 0, null_value);
+    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
+    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(inner_list1);
+    amqpvalue_destroy(inner_list2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_252: [char] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_char_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_232: [Nesting shall be considered in comparison.] */
+TEST_FUNCTION(when_inner_lists_have_each_1_item_count_but_items_are_different_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_char(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_list();
+    AMQP_VALUE value2 = amqpvalue_create_list();
+    AMQP_VALUE inner_list1 = amqpvalue_create_list();
+    AMQP_VALUE inner_list2 = amqpvalue_create_list();
+    AMQP_VALUE inner_item1 = amqpvalue_create_uint(42);
+    AMQP_VALUE inner_item2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_list_item(inner_list1, 0, inner_item1);
+    (void)amqpvalue_set_list_item(inner_list2, 0, inner_item2);
+    (void)amqpvalue_set_list_item(value1, 0, inner_list1);
+    (void)amqpvalue_set_list_item(value2, 0, inner_list2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(inner_list1);
+    amqpvalue_destroy(inner_list2);
+    amqpvalue_destroy(inner_item1);
+    amqpvalue_destroy(inner_item2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_253: [timestamp] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_timestamp_succesfully_value_42)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+TEST_FUNCTION(for_2_empty_map_values_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_timestamp(42);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_253: [timestamp] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_timestamp_succesfully_value_43)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+TEST_FUNCTION(for_2_maps_with_one_null_key_and_null_value_item_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_timestamp(43);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_map_value(value1, null_value, null_value);
+    (void)amqpvalue_set_map_value(value2, null_value, null_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(null_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_254: [uuid] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_uuid_succesfully_first_byte_non_zero)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+TEST_FUNCTION(for_2_maps_with_one_pair_each_where_key_is_different_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    uuid uuid_value = { 0x42 };
-    AMQP_VALUE source = amqpvalue_create_uuid(uuid_value);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
+    AMQP_VALUE key1 = amqpvalue_create_uint(42);
+    AMQP_VALUE key2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(value1, key1, pair_value);
+    (void)amqpvalue_set_map_value(value2, key2, pair_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(pair_value);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_254: [uuid] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_uuid_succesfully_2_non_zero_bytes)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+TEST_FUNCTION(for_2_maps_with_one_pair_each_where_value_is_different_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    uuid uuid_value = { 0x42, 0x43 };
-    AMQP_VALUE source = amqpvalue_create_uuid(uuid_value);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE pair_value1 = amqpvalue_create_uint(42);
+    AMQP_VALUE pair_value2 = amqpvalue_create_uint(43);
+    AMQP_VALUE key = amqpvalue_create_uint(42);
+    (void)amqpvalue_set_map_value(value1, key, pair_value1);
+    (void)amqpvalue_set_map_value(value2, key, pair_value2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(pair_value1);
+    amqpvalue_destroy(pair_value2);
+    amqpvalue_destroy(key);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_255: [binary] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_binary_succesfully_1_byte)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+TEST_FUNCTION(for_2_maps_with_one_pair_each_where_key_and_value_are_equal_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    unsigned char buffer[] = { 0x42 };
-    amqp_binary binary_value;
-    AMQP_VALUE source;
-    binary_value.bytes = buffer;
-    binary_value.length = sizeof(buffer);
-    source = amqpvalue_create_binary(binary_value);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
+    AMQP_VALUE key = amqpvalue_create_uint(42);
+    (void)amqpvalue_set_map_value(value1, key, pair_value);
+    (void)amqpvalue_set_map_value(value2, key, pair_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(pair_value);
+    amqpvalue_destroy(key);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_255: [binary] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_binary_succesfully_2_bytes)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+TEST_FUNCTION(for_2_maps_with_different_pair_count_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    unsigned char buffer[] = { 0x42, 0x43 };
-    amqp_binary binary_value;
-    AMQP_VALUE source;
-    binary_value.bytes = buffer;
-    binary_value.length = sizeof(buffer);
-    source = amqpvalue_create_binary(binary_value);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
+    AMQP_VALUE key1 = amqpvalue_create_uint(42);
+    AMQP_VALUE key2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(value1, key1, pair_value);
+    (void)amqpvalue_set_map_value(value2, key1, pair_value);
+    (void)amqpvalue_set_map_value(value2, key2, pair_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(pair_value);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_256: [string] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_string_succesfully_a)
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+TEST_FUNCTION(for_2_maps_with_2_equal_pairs_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_string("a");
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
+    AMQP_VALUE key1 = amqpvalue_create_uint(42);
+    AMQP_VALUE key2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(value1, key1, pair_value);
+    (void)amqpvalue_set_map_value(value1, key2, pair_value);
+    (void)amqpvalue_set_map_value(value2, key1, pair_value);
+    (void)amqpvalue_set_map_value(value2, key2, pair_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
-}
-
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_256: [string] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_string_succesfully_abcd)
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(pair_value);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_206: [amqpvalue_are_equal shall return true if the contents of value1 and value2 are equal.] */
+/* Tests_SRS_AMQPVALUE_01_233: [- map: compare map pair count and each key/value pair.] */
+/* Tests_SRS_AMQPVALUE_01_126: [Unless known to be otherwise, maps MUST be considered to be ordered, that is, the order of the key-value pairs is semantically important and two maps which are different only in the order in which their key-value pairs are encoded are not equal.] */
+TEST_FUNCTION(for_2_maps_with_2_equal_pairs_out_of_order_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_string("abcd");
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE pair_value = amqpvalue_create_uint(42);
+    AMQP_VALUE key1 = amqpvalue_create_uint(42);
+    AMQP_VALUE key2 = amqpvalue_create_uint(43);
+    (void)amqpvalue_set_map_value(value1, key1, pair_value);
+    (void)amqpvalue_set_map_value(value1, key2, pair_value);
+    (void)amqpvalue_set_map_value(value2, key2, pair_value);
+    (void)amqpvalue_set_map_value(value2, key1, pair_value);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(pair_value);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_257: [symbol] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_symbol_succesfully_a)
+/* Tests_SRS_AMQPVALUE_01_234: [Nesting shall be considered in comparison.] */
+TEST_FUNCTION(when_inner_maps_are_equal_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_symbol("a");
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_uint(42);
+    AMQP_VALUE inner_map1 = amqpvalue_create_map();
+    AMQP_VALUE inner_map2 = amqpvalue_create_map();
+    (void)amqpvalue_set_map_value(value1, key, inner_map1);
+    (void)amqpvalue_set_map_value(value2, key, inner_map2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(inner_map1);
+    amqpvalue_destroy(inner_map2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_257: [symbol] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_symbol_succesfully_abcd)
+/* Tests_SRS_AMQPVALUE_01_234: [Nesting shall be considered in comparison.] */
+TEST_FUNCTION(when_inner_maps_are_equal_not_are_not_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_symbol("abcd");
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_map();
+    AMQP_VALUE value2 = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_uint(42);
+    AMQP_VALUE pair_value = amqpvalue_create_uint(43);
+    AMQP_VALUE inner_map1 = amqpvalue_create_map();
+    AMQP_VALUE inner_map2 = amqpvalue_create_map();
+    (void)amqpvalue_set_map_value(inner_map1, key, pair_value);
+    (void)amqpvalue_set_map_value(value1, key, inner_map1);
+    (void)amqpvalue_set_map_value(value2, key, inner_map2);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(pair_value);
+    amqpvalue_destroy(inner_map1);
+    amqpvalue_destroy(inner_map2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_258: [list] */
-TEST_FUNCTION(amqpvalue_clone_clones_an_empty_list)
+/* Tests_SRS_AMQPVALUE_01_439: [- array: compare array item count and each element.] */
+TEST_FUNCTION(when_arrays_have_equal_items_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_list();
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_array();
+    AMQP_VALUE value2 = amqpvalue_create_array();
+    AMQP_VALUE item = amqpvalue_create_uint(42);
+    (void)amqpvalue_add_array_item(value1, item);
+    (void)amqpvalue_add_array_item(value2, item);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_258: [list] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_list_with_one_item)
+/* Tests_SRS_AMQPVALUE_01_440: [- described and composite: compare the descriptor and the described value.] */
+TEST_FUNCTION(when_described_values_are_equal_amqpvalue_are_equal_returns_true)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE item = amqpvalue_create_uint(42);
-    AMQP_VALUE source = amqpvalue_create_list();
-    (void)amqpvalue_set_list_item(source, 0, item);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_described(amqpvalue_create_ulong(0x70), amqpvalue_create_uint(42));
+    AMQP_VALUE value2 = amqpvalue_create_described(amqpvalue_create_ulong(0x70), amqpvalue_create_uint(42));
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_TRUE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(item);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_258: [list] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_list_with_2_items)
+/* Tests_SRS_AMQPVALUE_01_440: [- described and composite: compare the descriptor and the described value.] */
+TEST_FUNCTION(when_described_values_have_different_descriptors_amqpvalue_are_equal_returns_false)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE item1 = amqpvalue_create_uint(42);
-    AMQP_VALUE item2 = amqpvalue_create_uint(43);
-    AMQP_VALUE source = amqpvalue_create_list();
-    (void)amqpvalue_set_list_item(source, 0, item1);
-    (void)amqpvalue_set_list_item(source, 1, item2);
+    bool result;
+    AMQP_VALUE value1 = amqpvalue_create_described(amqpvalue_create_ulong(0x70), amqpvalue_create_uint(42));
+    AMQP_VALUE value2 = amqpvalue_create_described(amqpvalue_create_ulong(0x71), amqpvalue_create_uint(42));
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_are_equal(value1, value2);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_IS_FALSE(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(item1);
-    amqpvalue_destroy(item2);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_259: [map] */
-TEST_FUNCTION(amqpvalue_clone_clones_an_empty_map)
+/* amqpvalue_hash */
+
+/* Tests_SRS_AMQPVALUE_01_442: [ If `value` is NULL, `amqpvalue_hash` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_hash_with_NULL_value_returns_0)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE source = amqpvalue_create_map();
-    umock_c_reset_all_calls();
+    uint32_t result;
 
     // act
-    result = amqpvalue_clone(source);
+    result = amqpvalue_hash(NULL);
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(uint32_t, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_259: [map] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_map_with_one_item)
+/* Tests_SRS_AMQPVALUE_01_441: [ `amqpvalue_hash` shall return a hash of the type and contents of `value`, so that values for which amqpvalue_are_equal returns true have the same hash. ]*/
+TEST_FUNCTION(amqpvalue_hash_for_equal_composite_values_is_the_same)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE key = amqpvalue_create_uint(42);
-    AMQP_VALUE value = amqpvalue_create_uint(43);
-    AMQP_VALUE source = amqpvalue_create_map();
-    (void)amqpvalue_set_map_value(source, key, value);
+    AMQP_VALUE value1 = amqpvalue_create_composite_with_ulong_descriptor(0x73);
+    AMQP_VALUE value2 = amqpvalue_create_composite_with_ulong_descriptor(0x73);
+    AMQP_VALUE item = amqpvalue_create_string("test");
+    (void)amqpvalue_set_composite_item(value1, 0, item);
+    (void)amqpvalue_set_composite_item(value2, 0, item);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
-
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(uint32_t, amqpvalue_hash(value1), amqpvalue_hash(value2));
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
-    amqpvalue_destroy(result);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_259: [map] */
-TEST_FUNCTION(amqpvalue_clone_clones_a_map_with_2_items)
+/* Tests_SRS_AMQPVALUE_01_441: [ `amqpvalue_hash` shall return a hash of the type and contents of `value`, so that values for which amqpvalue_are_equal returns true have the same hash. ]*/
+TEST_FUNCTION(amqpvalue_hash_for_positive_and_negative_zero_is_the_same)
 {
     // arrange
-    AMQP_VALUE result;
-    AMQP_VALUE key1 = amqpvalue_create_uint(42);
-    AMQP_VALUE value1 = amqpvalue_create_uint(43);
-    AMQP_VALUE key2 = amqpvalue_create_uint(44);
-    AMQP_VALUE value2 = amqpvalue_create_uint(45);
-    AMQP_VALUE source = amqpvalue_create_map();
-    (void)amqpvalue_set_map_value(source, key1, value1);
-    (void)amqpvalue_set_map_value(source, key2, value2);
+    AMQP_VALUE value1 = amqpvalue_create_double(0.0);
+    AMQP_VALUE value2 = amqpvalue_create_double(-0.0);
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_clone(source);
-
     // assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint32_t, amqpvalue_hash(value1), amqpvalue_hash(value2));
 
     // cleanup
-    amqpvalue_destroy(source);
-    amqpvalue_destroy(key1);
     amqpvalue_destroy(value1);
-    amqpvalue_destroy(key2);
     amqpvalue_destroy(value2);
-    amqpvalue_destroy(result);
 }
 
-/* amqpvalue_encode */
+/* amqpvalue_compare */
 
-static void test_amqpvalue_encode(AMQP_VALUE source, const char* expected_stringified_bytes)
+/* Tests_SRS_AMQPVALUE_01_444: [ If `value1` and `value2` are the same value (or both NULL), `amqpvalue_compare` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_compare_with_both_NULL_returns_0)
 {
     // arrange
     int result;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
 
     // act
-    result = amqpvalue_encode(source, test_encoder_output, NULL);
+    result = amqpvalue_compare(NULL, NULL);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    stringify_bytes(encoded_bytes, encoded_byte_count, actual_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified_bytes, actual_stringified);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_destroy(source);
 }
 
-static void test_amqpvalue_encode_failure(AMQP_VALUE source)
+/* Tests_SRS_AMQPVALUE_01_445: [ A NULL value shall be ordered before any other value. ]*/
+TEST_FUNCTION(amqpvalue_compare_orders_NULL_first)
 {
-    size_t i;
-    (void)amqpvalue_encode(source, test_encoder_output, NULL);
-
-    for (i = 0; i < 1; i++)
-    {
-        int result;
-        size_t j;
-        umock_c_reset_all_calls();
-
-        encoder_output_call_count = 0;
-        when_shall_encoder_output_fail = i + 1;
-        for (j = 0;  j < i + 1; j++)
-        {
-            STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-        }
-
-        // act
-        result = amqpvalue_encode(source, test_encoder_output, NULL);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_null();
+    umock_c_reset_all_calls();
 
-        // assert
-        ASSERT_ARE_NOT_EQUAL(int, 0, result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    }
+    // act
+    // assert
+    ASSERT_IS_TRUE(amqpvalue_compare(NULL, value) < 0);
+    ASSERT_IS_TRUE(amqpvalue_compare(value, NULL) > 0);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_265: [amqpvalue_encode shall encode the value per the ISO.] */
-/* Tests_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-/* Tests_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
-/* Tests_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
-/* Tests_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
-TEST_FUNCTION(amqpvalue_encode_for_a_null_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_446: [ Values of different types shall be ordered by their AMQP_TYPE. ]*/
+TEST_FUNCTION(amqpvalue_compare_orders_values_of_different_types_by_type)
 {
     // arrange
-    int result;
-    AMQP_VALUE source = amqpvalue_create_null();
+    AMQP_VALUE value1 = amqpvalue_create_uint(100);
+    AMQP_VALUE value2 = amqpvalue_create_ulong(1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(test_encoder_output(test_context, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-
     // act
-    result = amqpvalue_encode(source, test_encoder_output, test_context);
-
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    stringify_bytes(encoded_bytes, encoded_byte_count, actual_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, "[0x40]", actual_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(amqpvalue_compare(value1, value2) < 0);
+    ASSERT_IS_TRUE(amqpvalue_compare(value2, value1) > 0);
 
     // cleanup
-    amqpvalue_destroy(source);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_265: [amqpvalue_encode shall encode the value per the ISO.] */
-/* Tests_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
-/* Tests_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
-/* Tests_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
-/* Tests_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
-TEST_FUNCTION(amqpvalue_encode_with_NULL_context_is_allowed)
+/* Tests_SRS_AMQPVALUE_01_443: [ `amqpvalue_compare` shall return a negative value, 0 or a positive value when `value1` is ordered before, equal to or after `value2`, returning 0 exactly when amqpvalue_are_equal returns true, except for NaN floating point values which compare equal to each other. ]*/
+TEST_FUNCTION(amqpvalue_compare_orders_strings_with_the_shorter_prefix_first)
 {
-    AMQP_VALUE source = amqpvalue_create_null();
-    test_amqpvalue_encode(source, "[0x40]");
+    // arrange
+    AMQP_VALUE value1 = amqpvalue_create_string("ab");
+    AMQP_VALUE value2 = amqpvalue_create_string("abc");
+    AMQP_VALUE value3 = amqpvalue_create_string("abc");
+    umock_c_reset_all_calls();
+
+    // act
+    // assert
+    ASSERT_IS_TRUE(amqpvalue_compare(value1, value2) < 0);
+    ASSERT_IS_TRUE(amqpvalue_compare(value2, value1) > 0);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_compare(value2, value3));
+
+    // cleanup
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(value3);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_fails)
+/* Tests_SRS_AMQPVALUE_01_443: [ `amqpvalue_compare` shall return a negative value, 0 or a positive value when `value1` is ordered before, equal to or after `value2`, returning 0 exactly when amqpvalue_are_equal returns true, except for NaN floating point values which compare equal to each other. ]*/
+TEST_FUNCTION(amqpvalue_compare_orders_described_values_by_descriptor_and_value)
 {
     // arrange
-    int result;
-    AMQP_VALUE source = amqpvalue_create_null();
+    AMQP_VALUE value1 = amqpvalue_create_described(amqpvalue_create_ulong(0x70), amqpvalue_create_uint(2));
+    AMQP_VALUE value2 = amqpvalue_create_described(amqpvalue_create_ulong(0x71), amqpvalue_create_uint(1));
+    AMQP_VALUE value3 = amqpvalue_create_described(amqpvalue_create_ulong(0x71), amqpvalue_create_uint(2));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(1);
-
     // act
-    result = amqpvalue_encode(source, test_encoder_output, NULL);
-
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(amqpvalue_compare(value1, value2) < 0);
+    ASSERT_IS_TRUE(amqpvalue_compare(value2, value3) < 0);
+    ASSERT_IS_TRUE(amqpvalue_compare(value3, value1) > 0);
 
     // cleanup
-    amqpvalue_destroy(source);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(value3);
 }
 
-/* Tests_SRS_AMQPVALUE_01_269: [If value or encoder_output are NULL, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_encode_with_NULL_value_fails)
+/* amqpvalue_clone */
+
+/* Tests_SRS_AMQPVALUE_01_402: [ If `value` is NULL, `amqpvalue_clone` shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_clone_with_NULL_returns_NULL)
 {
     // arrange
+    AMQP_VALUE result;
 
     // act
-    int result = amqpvalue_encode(NULL, test_encoder_output, test_context);
+    result = amqpvalue_clone(NULL);
 
     // assert
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_269: [If value or encoder_output are NULL, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_encode_with_NULL_encoder_output_fails)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_237: [null] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_null_succesfully)
 {
     // arrange
-    int result;
+    AMQP_VALUE result;
     AMQP_VALUE source = amqpvalue_create_null();
     umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_encode(source, NULL, test_context);
+    result = amqpvalue_clone(source);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_272: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
-TEST_FUNCTION(amqpvalue_encode_boolean_true_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_boolean(true);
-    test_amqpvalue_encode(source, "[0x41]");
-}
-
-/* Tests_SRS_AMQPVALUE_01_273: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
-TEST_FUNCTION(amqpvalue_encode_boolean_false_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_238: [boolean] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_boolean_succesfully_false_value)
 {
+    // arrange
+    AMQP_VALUE result;
     AMQP_VALUE source = amqpvalue_create_boolean(false);
-    test_amqpvalue_encode(source, "[0x42]");
-}
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_boolean_false_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_boolean(false);
-    test_amqpvalue_encode_failure(source);
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_boolean_true_fails)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_238: [boolean] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_boolean_succesfully_true_value)
 {
+    // arrange
+    AMQP_VALUE result;
     AMQP_VALUE source = amqpvalue_create_boolean(true);
-    test_amqpvalue_encode_failure(source);
-}
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_ubyte_0x00_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_ubyte(0x0);
-    test_amqpvalue_encode(source, "[0x50,0x00]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_ubyte_0xFF_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_ubyte(0xFF);
-    test_amqpvalue_encode(source, "[0x50,0xFF]");
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ubyte_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_ubyte(0xFF);
-    test_amqpvalue_encode_failure(source);
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_ushort_0x0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_239: [ubyte] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_ubyte_succesfully_value_42)
 {
-    AMQP_VALUE source = amqpvalue_create_ushort(0x0);
-    test_amqpvalue_encode(source, "[0x60,0x00,0x00]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_ubyte(42);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_ushort_0x04243_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_ushort(0x4243);
-    test_amqpvalue_encode(source, "[0x60,0x42,0x43]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ushort_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_ushort(0x4243);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_uint_0xFFFFFFFF_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_uint(0xFFFFFFFF);
-    test_amqpvalue_encode(source, "[0x70,0xFF,0xFF,0xFF,0xFF]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_uint_0x042434445_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_239: [ubyte] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_ubyte_succesfully_value_43)
 {
-    AMQP_VALUE source = amqpvalue_create_uint(0x42434445);
-    test_amqpvalue_encode(source, "[0x70,0x42,0x43,0x44,0x45]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_ubyte(43);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uint_0x42434445_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_uint(0x42434445);
-    test_amqpvalue_encode_failure(source);
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_encode_uint_0x42_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_uint(0x42);
-    test_amqpvalue_encode(source, "[0x52,0x42]");
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_encode_uint_0xFF_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_uint(0xFF);
-    test_amqpvalue_encode(source, "[0x52,0xFF]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uint_0xFF_fails)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_240: [ushort] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_ushort_succesfully_value_42)
 {
-    AMQP_VALUE source = amqpvalue_create_uint(0xFF);
-    test_amqpvalue_encode_failure(source);
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_ushort(42);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_279: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
-TEST_FUNCTION(amqpvalue_encode_uint_0x00_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_uint(0x00);
-    test_amqpvalue_encode(source, "[0x43]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uint_0x00_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_uint(0x00);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_ulong_0x4243444546474849_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_ulong(0x4243444546474849);
-    test_amqpvalue_encode(source, "[0x80,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_ulong_0xFFFFFFFFFFFFFFFF_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_240: [ushort] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_ushort_succesfully_value_43)
 {
-    AMQP_VALUE source = amqpvalue_create_ulong(0xFFFFFFFFFFFFFFFF);
-    test_amqpvalue_encode(source, "[0x80,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_ushort(43);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ulong_0xFFFFFFFFFFFFFFFF_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_ulong(0xFFFFFFFFFFFFFFFF);
-    test_amqpvalue_encode_failure(source);
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_encode_ulong_0x42_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_ulong(0x42);
-    test_amqpvalue_encode(source, "[0x53,0x42]");
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_encode_ulong_0xFF_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_ulong(0xFF);
-    test_amqpvalue_encode(source, "[0x53,0xFF]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ulong_0xFF_fails)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_241: [uint] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_uint_succesfully_value_42)
 {
-    AMQP_VALUE source = amqpvalue_create_ulong(0xFF);
-    test_amqpvalue_encode_failure(source);
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_uint(42);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_282: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
-TEST_FUNCTION(amqpvalue_encode_ulong_0x00_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_ulong(0x00);
-    test_amqpvalue_encode(source, "[0x44]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ulong_0x00_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_ulong(0x00);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_byte_minus128_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_byte(-128);
-    test_amqpvalue_encode(source, "[0x51,0x80]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_byte_0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_241: [uint] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_uint_succesfully_value_43)
 {
-    AMQP_VALUE source = amqpvalue_create_byte(0);
-    test_amqpvalue_encode(source, "[0x51,0x00]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_uint(43);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_byte_127_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_byte(127);
-    test_amqpvalue_encode(source, "[0x51,0x7F]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_byte_127_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_byte(127);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_short_minus32768_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_short(-32768);
-    test_amqpvalue_encode(source, "[0x61,0x80,0x00]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_short_0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_242: [ulong] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_ulong_succesfully_value_42)
 {
-    AMQP_VALUE source = amqpvalue_create_short(0);
-    test_amqpvalue_encode(source, "[0x61,0x00,0x00]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_ulong(42);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_short_32767_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_short(32767);
-    test_amqpvalue_encode(source, "[0x61,0x7F,0xFF]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_short_32767_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_short(32767);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_int_minus2147483648_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_int(-2147483647-1);
-    test_amqpvalue_encode(source, "[0x71,0x80,0x00,0x00,0x00]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_int_0x42434445_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_242: [ulong] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_ulong_succesfully_value_43)
 {
-    AMQP_VALUE source = amqpvalue_create_int(0x42434445);
-    test_amqpvalue_encode(source, "[0x71,0x42,0x43,0x44,0x45]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_ulong(43);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_int_2147483647_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_int(2147483647);
-    test_amqpvalue_encode(source, "[0x71,0x7F,0xFF,0xFF,0xFF]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_int_2147483647_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_int(2147483647);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_int_minus128_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_int(-128);
-    test_amqpvalue_encode(source, "[0x54,0x80]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_int_0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_243: [byte] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_byte_succesfully_value_42)
 {
-    AMQP_VALUE source = amqpvalue_create_int(0);
-    test_amqpvalue_encode(source, "[0x54,0x00]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_byte(42);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_encode_int_127_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_int(127);
-    test_amqpvalue_encode(source, "[0x54,0x7F]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_int_127_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_int(127);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_long_minus9223372036854775808_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_long(-9223372036854775807L - 1);
-    test_amqpvalue_encode(source, "[0x81,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement longeger in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_long_0x4243444546474849_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_243: [byte] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_byte_succesfully_value_43)
 {
-    AMQP_VALUE source = amqpvalue_create_long(0x4243444546474849L);
-    test_amqpvalue_encode(source, "[0x81,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_byte(43);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement longeger in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_encode_long_9223372036854775807_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_long(9223372036854775807L);
-    test_amqpvalue_encode(source, "[0x81,0x7F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_long_9223372036854775807_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_long(9223372036854775807L);
-    test_amqpvalue_encode_failure(source);
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement longeger"/>] */
-TEST_FUNCTION(amqpvalue_encode_long_minus128_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_long(-128);
-    test_amqpvalue_encode(source, "[0x55,0x80]");
-}
-
-/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement longeger"/>] */
-TEST_FUNCTION(amqpvalue_encode_long_0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_244: [short] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_short_succesfully_value_42)
 {
-    AMQP_VALUE source = amqpvalue_create_long(0);
-    test_amqpvalue_encode(source, "[0x55,0x00]");
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_short(42);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement longeger"/>] */
-TEST_FUNCTION(amqpvalue_encode_long_127_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_long(127);
-    test_amqpvalue_encode(source, "[0x55,0x7F]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_long_127_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_long(127);
-    test_amqpvalue_encode_failure(source);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>] */
-TEST_FUNCTION(amqpvalue_encode_float_succeeds)
-{
-    unsigned char expected_bytes[] = { 0x72, 0xBF, 0x80, 0x00, 0x00 };
-    float source_value = -1.0;
-    AMQP_VALUE source = amqpvalue_create_float(source_value);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>] */
-TEST_FUNCTION(amqpvalue_encode_float_42_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_244: [short] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_short_succesfully_value_43)
 {
-    unsigned char expected_bytes[] = { 0x72, 0x42, 0x28, 0x00, 0x00 };
-    float source_value = 42.0;
-    AMQP_VALUE source = amqpvalue_create_float(source_value);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_short(43);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_float_fails)
-{
-    float source_value = 42.0;
-    AMQP_VALUE source = amqpvalue_create_float(source_value);
-    test_amqpvalue_encode_failure(source);
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>] */
-TEST_FUNCTION(amqpvalue_encode_double_succeeds)
-{
-    unsigned char expected_bytes[] = { 0x82, 0xBF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    double source_value = -1.0;
-    AMQP_VALUE source = amqpvalue_create_double(source_value);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>] */
-TEST_FUNCTION(amqpvalue_encode_double_42_succeeds)
-{
-    unsigned char expected_bytes[] = { 0x82, 0x40, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    double source_value = 42.0;
-    AMQP_VALUE source = amqpvalue_create_double(source_value);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_double_fails)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_245: [int] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_int_succesfully_value_42)
 {
-    double source_value = 42.0;
-    AMQP_VALUE source = amqpvalue_create_double(source_value);
-    test_amqpvalue_encode_failure(source);
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_int(42);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_encode_timestamp_minus9223372036854775808_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_timestamp(-9223372036854775807L - 1);
-    test_amqpvalue_encode(source, "[0x83,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_encode_timestamp_0_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_timestamp(0);
-    test_amqpvalue_encode(source, "[0x83,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
-}
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_encode_timestamp_9223372036854775807_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_timestamp(9223372036854775807L);
-    test_amqpvalue_encode(source, "[0x83,0x7F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF]");
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_timestamp_127_fails)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_245: [int] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_int_succesfully_value_43)
 {
-    AMQP_VALUE source = amqpvalue_create_timestamp(127);
-    test_amqpvalue_encode_failure(source);
-}
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_int(43);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
-TEST_FUNCTION(amqpvalue_encode_uuid_all_zeroes_succeeds)
-{
-    uuid uuid = { 0 };
-    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
-    test_amqpvalue_encode(source, "[0x98,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
-}
+    // act
+    result = amqpvalue_clone(source);
 
-/* Tests_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
-TEST_FUNCTION(amqpvalue_encode_uuid_succeeds)
-{
-    uuid uuid = { 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
-        0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F };
-    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
-    test_amqpvalue_encode(source, "[0x98,0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F]");
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uuid_fails)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_246: [long] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_long_succesfully_value_42)
 {
-    uuid uuid = { 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
-        0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F };
-    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_long(42);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_encode_binary_zero_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_246: [long] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_long_succesfully_value_43)
 {
-    unsigned char bytes[] = { 0x00 };
-    amqp_binary binary;
-    AMQP_VALUE source;
-    binary.bytes = &bytes;
-    binary.length = 0;
-    source = amqpvalue_create_binary(binary);
-    test_amqpvalue_encode(source, "[0xA0,0x00]");
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_long(43);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_encode_binary_one_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_247: [float] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_float_succesfully_value_42)
 {
-    unsigned char bytes[] = { 0x42 };
-    amqp_binary binary;
-    AMQP_VALUE source;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    test_amqpvalue_encode(source, "[0xA0,0x01,0x42]");
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_float(42);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_encode_binary_255_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_247: [float] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_float_succesfully_value_43)
 {
-    unsigned char bytes[255];
-    unsigned char expected_bytes[257] = { 0xA0, 0xFF };
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_float(43);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_248: [double] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_double_succesfully_value_42)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_double(42);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_248: [double] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_double_succesfully_value_43)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_double(43);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_252: [char] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_char_succesfully_value_42)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_char(42);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_252: [char] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_char_succesfully_value_43)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_char(43);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_253: [timestamp] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_timestamp_succesfully_value_42)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_timestamp(42);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_253: [timestamp] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_timestamp_succesfully_value_43)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_timestamp(43);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_254: [uuid] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_uuid_succesfully_first_byte_non_zero)
+{
+    // arrange
+    AMQP_VALUE result;
+    uuid uuid_value = { 0x42 };
+    AMQP_VALUE source = amqpvalue_create_uuid(uuid_value);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_254: [uuid] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_uuid_succesfully_2_non_zero_bytes)
+{
+    // arrange
+    AMQP_VALUE result;
+    uuid uuid_value = { 0x42, 0x43 };
+    AMQP_VALUE source = amqpvalue_create_uuid(uuid_value);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_255: [binary] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_binary_succesfully_1_byte)
+{
+    // arrange
+    AMQP_VALUE result;
+    unsigned char buffer[] = { 0x42 };
+    amqp_binary binary_value;
+    AMQP_VALUE source;
+    binary_value.bytes = buffer;
+    binary_value.length = sizeof(buffer);
+    source = amqpvalue_create_binary(binary_value);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_255: [binary] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_binary_succesfully_2_bytes)
+{
+    // arrange
+    AMQP_VALUE result;
+    unsigned char buffer[] = { 0x42, 0x43 };
+    amqp_binary binary_value;
+    AMQP_VALUE source;
+    binary_value.bytes = buffer;
+    binary_value.length = sizeof(buffer);
+    source = amqpvalue_create_binary(binary_value);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_256: [string] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_string_succesfully_a)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_string("a");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_256: [string] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_string_succesfully_abcd)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_string("abcd");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_257: [symbol] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_symbol_succesfully_a)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_symbol("a");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_257: [symbol] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_symbol_succesfully_abcd)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_symbol("abcd");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_258: [list] */
+TEST_FUNCTION(amqpvalue_clone_clones_an_empty_list)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_list();
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_258: [list] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_list_with_one_item)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE item = amqpvalue_create_uint(42);
+    AMQP_VALUE source = amqpvalue_create_list();
+    (void)amqpvalue_set_list_item(source, 0, item);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(item);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_258: [list] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_list_with_2_items)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE item1 = amqpvalue_create_uint(42);
+    AMQP_VALUE item2 = amqpvalue_create_uint(43);
+    AMQP_VALUE source = amqpvalue_create_list();
+    (void)amqpvalue_set_list_item(source, 0, item1);
+    (void)amqpvalue_set_list_item(source, 1, item2);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_259: [map] */
+TEST_FUNCTION(amqpvalue_clone_clones_an_empty_map)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE source = amqpvalue_create_map();
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_259: [map] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_map_with_one_item)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE key = amqpvalue_create_uint(42);
+    AMQP_VALUE value = amqpvalue_create_uint(43);
+    AMQP_VALUE source = amqpvalue_create_map();
+    (void)amqpvalue_set_map_value(source, key, value);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+    amqpvalue_destroy(result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_235: [amqpvalue_clone shall clone the value passed as argument and return a new non-NULL handle to the cloned AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_259: [map] */
+TEST_FUNCTION(amqpvalue_clone_clones_a_map_with_2_items)
+{
+    // arrange
+    AMQP_VALUE result;
+    AMQP_VALUE key1 = amqpvalue_create_uint(42);
+    AMQP_VALUE value1 = amqpvalue_create_uint(43);
+    AMQP_VALUE key2 = amqpvalue_create_uint(44);
+    AMQP_VALUE value2 = amqpvalue_create_uint(45);
+    AMQP_VALUE source = amqpvalue_create_map();
+    (void)amqpvalue_set_map_value(source, key1, value1);
+    (void)amqpvalue_set_map_value(source, key2, value2);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_clone(source);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(amqpvalue_are_equal(result, source));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(value1);
+    amqpvalue_destroy(key2);
+    amqpvalue_destroy(value2);
+    amqpvalue_destroy(result);
+}
+
+/* amqpvalue_encode */
+
+static void test_amqpvalue_encode(AMQP_VALUE source, const char* expected_stringified_bytes)
+{
+    // arrange
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
+    // act
+    result = amqpvalue_encode(source, test_encoder_output, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    stringify_bytes(encoded_bytes, encoded_byte_count, actual_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified_bytes, actual_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+static void test_amqpvalue_encode_failure(AMQP_VALUE source)
+{
+    size_t i;
+    (void)amqpvalue_encode(source, test_encoder_output, NULL);
+
+    for (i = 0; i < 1; i++)
+    {
+        int result;
+        size_t j;
+        umock_c_reset_all_calls();
+
+        encoder_output_call_count = 0;
+        when_shall_encoder_output_fail = i + 1;
+        for (j = 0;  j < i + 1; j++)
+        {
+            STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+        }
+
+        // act
+        result = amqpvalue_encode(source, test_encoder_output, NULL);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_265: [amqpvalue_encode shall encode the value per the ISO.] */
+/* Tests_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+/* Tests_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
+/* Tests_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
+/* Tests_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
+TEST_FUNCTION(amqpvalue_encode_for_a_null_value_succeeds)
+{
+    // arrange
+    int result;
+    AMQP_VALUE source = amqpvalue_create_null();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_encoder_output(test_context, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+    // act
+    result = amqpvalue_encode(source, test_encoder_output, test_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    stringify_bytes(encoded_bytes, encoded_byte_count, actual_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, "[0x40]", actual_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_265: [amqpvalue_encode shall encode the value per the ISO.] */
+/* Tests_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+/* Tests_SRS_AMQPVALUE_01_267: [amqpvalue_encode shall pass the encoded bytes to the encoder_output function.] */
+/* Tests_SRS_AMQPVALUE_01_268: [On each call to the encoder_output function, amqpvalue_encode shall also pass the context argument.] */
+/* Tests_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
+TEST_FUNCTION(amqpvalue_encode_with_NULL_context_is_allowed)
+{
+    AMQP_VALUE source = amqpvalue_create_null();
+    test_amqpvalue_encode(source, "[0x40]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_fails)
+{
+    // arrange
+    int result;
+    AMQP_VALUE source = amqpvalue_create_null();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_encoder_output(NULL, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(1);
+
+    // act
+    result = amqpvalue_encode(source, test_encoder_output, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_269: [If value or encoder_output are NULL, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_encode_with_NULL_value_fails)
+{
+    // arrange
+
+    // act
+    int result = amqpvalue_encode(NULL, test_encoder_output, test_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_269: [If value or encoder_output are NULL, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_encode_with_NULL_encoder_output_fails)
+{
+    // arrange
+    int result;
+    AMQP_VALUE source = amqpvalue_create_null();
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_encode(source, NULL, test_context);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_272: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
+TEST_FUNCTION(amqpvalue_encode_boolean_true_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_boolean(true);
+    test_amqpvalue_encode(source, "[0x41]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_273: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
+TEST_FUNCTION(amqpvalue_encode_boolean_false_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_boolean(false);
+    test_amqpvalue_encode(source, "[0x42]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_boolean_false_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_boolean(false);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_boolean_true_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_boolean(true);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_ubyte_0x00_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ubyte(0x0);
+    test_amqpvalue_encode(source, "[0x50,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_ubyte_0xFF_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ubyte(0xFF);
+    test_amqpvalue_encode(source, "[0x50,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ubyte_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_ubyte(0xFF);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_ushort_0x0_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ushort(0x0);
+    test_amqpvalue_encode(source, "[0x60,0x00,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_ushort_0x04243_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ushort(0x4243);
+    test_amqpvalue_encode(source, "[0x60,0x42,0x43]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ushort_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_ushort(0x4243);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_uint_0xFFFFFFFF_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0xFFFFFFFF);
+    test_amqpvalue_encode(source, "[0x70,0xFF,0xFF,0xFF,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_uint_0x042434445_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0x42434445);
+    test_amqpvalue_encode(source, "[0x70,0x42,0x43,0x44,0x45]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uint_0x42434445_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0x42434445);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_encode_uint_0x42_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0x42);
+    test_amqpvalue_encode(source, "[0x52,0x42]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_encode_uint_0xFF_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0xFF);
+    test_amqpvalue_encode(source, "[0x52,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uint_0xFF_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0xFF);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_279: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
+TEST_FUNCTION(amqpvalue_encode_uint_0x00_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0x00);
+    test_amqpvalue_encode(source, "[0x43]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uint_0x00_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_uint(0x00);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_ulong_0x4243444546474849_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0x4243444546474849);
+    test_amqpvalue_encode(source, "[0x80,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_ulong_0xFFFFFFFFFFFFFFFF_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0xFFFFFFFFFFFFFFFF);
+    test_amqpvalue_encode(source, "[0x80,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ulong_0xFFFFFFFFFFFFFFFF_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0xFFFFFFFFFFFFFFFF);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_encode_ulong_0x42_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0x42);
+    test_amqpvalue_encode(source, "[0x53,0x42]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_encode_ulong_0xFF_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0xFF);
+    test_amqpvalue_encode(source, "[0x53,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ulong_0xFF_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0xFF);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_282: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
+TEST_FUNCTION(amqpvalue_encode_ulong_0x00_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0x00);
+    test_amqpvalue_encode(source, "[0x44]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_ulong_0x00_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_ulong(0x00);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_byte_minus128_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_byte(-128);
+    test_amqpvalue_encode(source, "[0x51,0x80]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_byte_0_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_byte(0);
+    test_amqpvalue_encode(source, "[0x51,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_byte_127_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_byte(127);
+    test_amqpvalue_encode(source, "[0x51,0x7F]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_byte_127_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_byte(127);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_short_minus32768_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_short(-32768);
+    test_amqpvalue_encode(source, "[0x61,0x80,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_short_0_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_short(0);
+    test_amqpvalue_encode(source, "[0x61,0x00,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_short_32767_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_short(32767);
+    test_amqpvalue_encode(source, "[0x61,0x7F,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_short_32767_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_short(32767);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_int_minus2147483648_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_int(-2147483647-1);
+    test_amqpvalue_encode(source, "[0x71,0x80,0x00,0x00,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_int_0x42434445_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_int(0x42434445);
+    test_amqpvalue_encode(source, "[0x71,0x42,0x43,0x44,0x45]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_int_2147483647_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_int(2147483647);
+    test_amqpvalue_encode(source, "[0x71,0x7F,0xFF,0xFF,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_int_2147483647_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_int(2147483647);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_int_minus128_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_int(-128);
+    test_amqpvalue_encode(source, "[0x54,0x80]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_int_0_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_int(0);
+    test_amqpvalue_encode(source, "[0x54,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_encode_int_127_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_int(127);
+    test_amqpvalue_encode(source, "[0x54,0x7F]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_int_127_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_int(127);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_long_minus9223372036854775808_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_long(-9223372036854775807L - 1);
+    test_amqpvalue_encode(source, "[0x81,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement longeger in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_long_0x4243444546474849_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_long(0x4243444546474849L);
+    test_amqpvalue_encode(source, "[0x81,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement longeger in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_encode_long_9223372036854775807_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_long(9223372036854775807L);
+    test_amqpvalue_encode(source, "[0x81,0x7F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_long_9223372036854775807_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_long(9223372036854775807L);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement longeger"/>] */
+TEST_FUNCTION(amqpvalue_encode_long_minus128_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_long(-128);
+    test_amqpvalue_encode(source, "[0x55,0x80]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement longeger"/>] */
+TEST_FUNCTION(amqpvalue_encode_long_0_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_long(0);
+    test_amqpvalue_encode(source, "[0x55,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement longeger"/>] */
+TEST_FUNCTION(amqpvalue_encode_long_127_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_long(127);
+    test_amqpvalue_encode(source, "[0x55,0x7F]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_long_127_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_long(127);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>] */
+TEST_FUNCTION(amqpvalue_encode_float_succeeds)
+{
+    unsigned char expected_bytes[] = { 0x72, 0xBF, 0x80, 0x00, 0x00 };
+    float source_value = -1.0;
+    AMQP_VALUE source = amqpvalue_create_float(source_value);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>] */
+TEST_FUNCTION(amqpvalue_encode_float_42_succeeds)
+{
+    unsigned char expected_bytes[] = { 0x72, 0x42, 0x28, 0x00, 0x00 };
+    float source_value = 42.0;
+    AMQP_VALUE source = amqpvalue_create_float(source_value);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_float_fails)
+{
+    float source_value = 42.0;
+    AMQP_VALUE source = amqpvalue_create_float(source_value);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>] */
+TEST_FUNCTION(amqpvalue_encode_double_succeeds)
+{
+    unsigned char expected_bytes[] = { 0x82, 0xBF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    double source_value = -1.0;
+    AMQP_VALUE source = amqpvalue_create_double(source_value);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>] */
+TEST_FUNCTION(amqpvalue_encode_double_42_succeeds)
+{
+    unsigned char expected_bytes[] = { 0x82, 0x40, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    double source_value = 42.0;
+    AMQP_VALUE source = amqpvalue_create_double(source_value);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_double_fails)
+{
+    double source_value = 42.0;
+    AMQP_VALUE source = amqpvalue_create_double(source_value);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_encode_timestamp_minus9223372036854775808_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_timestamp(-9223372036854775807L - 1);
+    test_amqpvalue_encode(source, "[0x83,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_encode_timestamp_0_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_timestamp(0);
+    test_amqpvalue_encode(source, "[0x83,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_encode_timestamp_9223372036854775807_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_timestamp(9223372036854775807L);
+    test_amqpvalue_encode(source, "[0x83,0x7F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_timestamp_127_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_timestamp(127);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
+TEST_FUNCTION(amqpvalue_encode_uuid_all_zeroes_succeeds)
+{
+    uuid uuid = { 0 };
+    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
+    test_amqpvalue_encode(source, "[0x98,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
+TEST_FUNCTION(amqpvalue_encode_uuid_succeeds)
+{
+    uuid uuid = { 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+        0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F };
+    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
+    test_amqpvalue_encode(source, "[0x98,0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_uuid_fails)
+{
+    uuid uuid = { 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+        0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F };
+    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_encode_binary_zero_bytes_succeeds)
+{
+    unsigned char bytes[] = { 0x00 };
+    amqp_binary binary;
+    AMQP_VALUE source;
+    binary.bytes = &bytes;
+    binary.length = 0;
+    source = amqpvalue_create_binary(binary);
+    test_amqpvalue_encode(source, "[0xA0,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_encode_binary_one_byte_succeeds)
+{
+    unsigned char bytes[] = { 0x42 };
+    amqp_binary binary;
+    AMQP_VALUE source;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    test_amqpvalue_encode(source, "[0xA0,0x01,0x42]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_encode_binary_255_bytes_succeeds)
+{
+    unsigned char bytes[255];
+    unsigned char expected_bytes[257] = { 0xA0, 0xFF };
+    unsigned int i;
+    amqp_binary binary;
+    AMQP_VALUE source;
+    for (i = 0; i < 255; i++)
+    {
+        bytes[i] = (unsigned char)i;
+    }
+    for (i = 0; i < 255; i++)
+    {
+        expected_bytes[i + 2] = (unsigned char)i;
+    }
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_binary_255_bytes_fails)
+{
+    unsigned char bytes[255];
+    unsigned int i;
+    amqp_binary binary;
+    AMQP_VALUE source;
+    for (i = 0; i < 255; i++)
+    {
+        bytes[i] = (unsigned char)i;
+    }
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_298: [<encoding name="vbin32" code="0xb0" category="variable" width="4" label="up to 2^32 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_encode_binary_256_bytes_succeeds)
+{
+    unsigned char bytes[256];
+    unsigned char expected_bytes[261] = { 0xB0, 0x00, 0x00, 0x01, 0x00 };
+    unsigned int i;
+    AMQP_VALUE source;
+    amqp_binary binary;
+    for (i = 0; i < 256; i++)
+    {
+        bytes[i] = (unsigned char)i;
+    }
+    for (i = 0; i < 256; i++)
+    {
+        expected_bytes[i + 5] = (unsigned char)i;
+    }
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_binary_256_bytes_fails)
+{
+    unsigned char bytes[256];
     unsigned int i;
+    AMQP_VALUE source;
+    amqp_binary binary;
+    for (i = 0; i < 256; i++)
+    {
+        bytes[i] = (unsigned char)i;
+    }
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_encode_string_with_empty_string_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_string("");
+    test_amqpvalue_encode(source, "[0xA1,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_encode_string_with_char_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_string("a");
+    test_amqpvalue_encode(source, "[0xA1,0x01,0x61]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_encode_string_with_255_chars_succeeds)
+{
+    char chars[256];
+    unsigned char expected_bytes[257] = { 0xA1, 0xFF };
+    AMQP_VALUE source;
+    int i;
+    for (i = 0; i < 255; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[255] = '\0';
+    for (i = 0; i < 255; i++)
+    {
+        expected_bytes[i + 2] = 'a';
+    }
+    source = amqpvalue_create_string(chars);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_string_with_255_chars_fails)
+{
+    char chars[256];
+    int i;
+    AMQP_VALUE source;
+    for (i = 0; i < 255; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[255] = '\0';
+    source = amqpvalue_create_string(chars);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_300: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_encode_string_with_256_chars_succeeds)
+{
+    char chars[257];
+    int i;
+    AMQP_VALUE source;
+    unsigned char expected_bytes[261] = { 0xB1, 0x00, 0x00, 0x01, 0x00 };
+    for (i = 0; i < 256; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[256] = '\0';
+    for (i = 0; i < 256; i++)
+    {
+        expected_bytes[i + 5] = 'a';
+    }
+    source = amqpvalue_create_string(chars);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_string_with_256_chars_fails)
+{
+    char chars[257];
+    int i;
+    AMQP_VALUE source;
+    for (i = 0; i < 256; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[256] = '\0';
+    source = amqpvalue_create_string(chars);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_encode_symbol_with_empty_symbol_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_symbol("");
+    test_amqpvalue_encode(source, "[0xA3,0x00]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_encode_symbol_with_char_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_symbol("a");
+    test_amqpvalue_encode(source, "[0xA3,0x01,0x61]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_encode_symbol_with_255_chars_succeeds)
+{
+    char chars[256];
+    unsigned char expected_bytes[257] = { 0xA3, 0xFF };
+    int i;
+    AMQP_VALUE source;
+    for (i = 0; i < 255; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[255] = '\0';
+    for (i = 0; i < 255; i++)
+    {
+        expected_bytes[i + 2] = 'a';
+    }
+    source = amqpvalue_create_symbol(chars);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_symbol_with_255_chars_fails)
+{
+    char chars[256];
+    int i;
+    AMQP_VALUE source;
+    for (i = 0; i < 255; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[255] = '\0';
+    source = amqpvalue_create_symbol(chars);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_302: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+/* Tests_SRS_AMQPVALUE_01_122: [Symbols are encoded as ASCII characters [ASCII].] */
+TEST_FUNCTION(amqpvalue_encode_symbol_with_256_chars_succeeds)
+{
+    char chars[257];
+    unsigned char expected_bytes[261] = { 0xB3, 0x00, 0x00, 0x01, 0x00 };
+    int i;
+    AMQP_VALUE source;
+    for (i = 0; i < 256; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[256] = '\0';
+    for (i = 0; i < 256; i++)
+    {
+        expected_bytes[i + 5] = 'a';
+    }
+    source = amqpvalue_create_symbol(chars);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_symbol_with_256_chars_fails)
+{
+    char chars[257];
+    int i;
+    AMQP_VALUE source;
+    for (i = 0; i < 256; i++)
+    {
+        chars[i] = 'a';
+    }
+    chars[256] = '\0';
+    source = amqpvalue_create_symbol(chars);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_303: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_empty_list_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    test_amqpvalue_encode(source, "[0x45]");
+}
+
+/* This test would allocate 4Gb and some people might not like that */
+#if 0
+TEST_FUNCTION(when_encoding_would_result_in_more_than_the_max_size_for_a_list_amqpvalue_encode_fails)
+{
+    int result;
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item1;
+    AMQP_VALUE item2;
+    AMQP_VALUE item3;
+    AMQP_VALUE item4;
+    char* very_big_string = (char*)malloc((UINT32_MAX / 4) + 2);
+    (void)memset(very_big_string, 'x', (UINT32_MAX / 4) + 1);
+    very_big_string[(UINT32_MAX / 4) + 1] = '\0';
+    item1 = amqpvalue_create_symbol(very_big_string);
+    item2 = amqpvalue_create_symbol(very_big_string);
+    item3 = amqpvalue_create_symbol(very_big_string);
+    item4 = amqpvalue_create_symbol(very_big_string);
+    free(very_big_string);
+    (void)amqpvalue_set_list_item(source, 0, item1);
+    (void)amqpvalue_set_list_item(source, 1, item2);
+    (void)amqpvalue_set_list_item(source, 2, item3);
+    (void)amqpvalue_set_list_item(source, 3, item4);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
+    amqpvalue_destroy(item3);
+    amqpvalue_destroy(item4);
+
+    // act
+    result = amqpvalue_encode(source, test_encoder_output, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+#endif
+
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_with_one_null_item_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    test_amqpvalue_encode(source, "[0xC0,0x02,0x01,0x40]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_list_with_one_null_item_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_with_2_null_item_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_set_list_item(source, 1, item);
+    amqpvalue_destroy(item);
+    test_amqpvalue_encode(source, "[0xC0,0x03,0x02,0x40,0x40]");
+}
+
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_with_254_null_items_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    unsigned char expected_bytes[257] = { 0xC0, 0xFF, 0xFE };
+    int i;
+    for (i = 0; i < 254; i++)
+    {
+        amqpvalue_set_list_item(source, i, item);
+    }
+    amqpvalue_destroy(item);
+    for (i = 0; i < 254; i++)
+    {
+        expected_bytes[i + 3] = 0x40;
+    }
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_then_amqpvalue_encode_list_with_255_null_items_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    int i;
+    for (i = 0; i < 255; i++)
+    {
+        amqpvalue_set_list_item(source, i, item);
+    }
+    amqpvalue_destroy(item);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_1_item_with_254_bytes_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    unsigned char bytes[252] = { 0 };
+    unsigned char expected_bytes[257] = { 0xC0, 0xFF, 0x01, 0xA0, 0xFC };
+    int i;
+    amqp_binary binary;
+    AMQP_VALUE item;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    item = amqpvalue_create_binary(binary);
+    amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    for (i = 0; i < 252; i++)
+    {
+        expected_bytes[i + 5] = 0;
+    }
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_1_item_with_255_bytes_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    unsigned char bytes[253] = { 0 };
+    unsigned char expected_bytes[253 + 11] = { 0xD0, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0xA0, 0xFD };
+    int i;
+    amqp_binary binary;
+    AMQP_VALUE item;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    item = amqpvalue_create_binary(binary);
+    amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    for (i = 0; i < 253; i++)
+    {
+        expected_bytes[i + 11] = 0;
+    }
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_list_1_item_with_256_bytes_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    unsigned char bytes[254] = { 0 };
+    amqp_binary binary;
+    AMQP_VALUE item;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    item = amqpvalue_create_binary(binary);
+    amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_255_null_items_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    unsigned char expected_bytes[255 + 9] = { 0xD0, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0xFF };
+    int i;
+    for (i = 0; i < 255; i++)
+    {
+        amqpvalue_set_list_item(source, i, item);
+    }
+    amqpvalue_destroy(item);
+    for (i = 0; i < 255; i++)
+    {
+        expected_bytes[i + 9] = 0x40;
+    }
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_list_256_null_items_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    int i;
+    for (i = 0; i < 256; i++)
+    {
+        amqpvalue_set_list_item(source, i, item);
+    }
+    amqpvalue_destroy(item);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_encode_list_with_2_different_items_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_list();
+    unsigned char bytes[] = { 0x42 };
+    unsigned char expected_bytes[] = { 0xC0, 0x05, 0x02, 0xA0, 0x01, 0x42, 0x40 };
+    amqp_binary binary;
+    AMQP_VALUE item;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    item = amqpvalue_create_binary(binary);
+    amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    item = amqpvalue_create_null();
+    amqpvalue_set_list_item(source, 1, item);
+    amqpvalue_destroy(item);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+TEST_FUNCTION(amqpvalue_encode_empty_map_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    unsigned char expected_bytes[] = { 0xC1, 0x01, 0x00 };
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_empty_map_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
+/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
+TEST_FUNCTION(amqpvalue_encode_a_map_with_a_null_key_and_null_value_succeeds)
+{
+    unsigned char expected_bytes[] = { 0xC1, 0x03, 0x02, 0x40, 0x40 };
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_null();
+    AMQP_VALUE value = amqpvalue_create_null();
+    amqpvalue_set_map_value(source, key, value);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_a_map_with_a_null_key_and_null_value_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_null();
+    AMQP_VALUE value = amqpvalue_create_null();
+    amqpvalue_set_map_value(source, key, value);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
+/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
+TEST_FUNCTION(amqpvalue_encode_a_map_with_a_uint_key_and_uint_value_succeeds)
+{
+    unsigned char expected_bytes[] = { 0xC1, 0x05, 0x02, 0x52, 0x42, 0x52, 0x43 };
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_uint(0x42);
+    AMQP_VALUE value = amqpvalue_create_uint(0x43);
+    amqpvalue_set_map_value(source, key, value);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_a_map_with_a_uint_key_and_uint_value_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE key = amqpvalue_create_uint(0x42);
+    AMQP_VALUE value = amqpvalue_create_uint(0x43);
+    amqpvalue_set_map_value(source, key, value);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
+/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
+TEST_FUNCTION(amqpvalue_encode_85_key_value_pairs_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    unsigned char expected_bytes[3 + 254] = { 0xC1, 0xFF, 0xAA };
+    unsigned char i;
+
+    AMQP_VALUE key = amqpvalue_create_uint(0);
+    AMQP_VALUE value = amqpvalue_create_null();
+    amqpvalue_set_map_value(source, key, value);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+
+    for (i = 0; i < 84; i++)
+    {
+        key = amqpvalue_create_uint(i + 1);
+        value = amqpvalue_create_null();
+        amqpvalue_set_map_value(source, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
+
+    expected_bytes[3] = 0x43;
+    expected_bytes[4] = 0x40;
+
+    for (i = 1; i < 85; i++)
+    {
+        expected_bytes[5 + ((i - 1) * 3)] = 0x52;
+        expected_bytes[5 + ((i - 1) * 3) + 1] = i;
+        expected_bytes[5 + ((i - 1) * 3) + 2] = 0x40;
+    }
+
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_85_key_value_pairs_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    int i;
+    for (i = 0; i < 85; i++)
+    {
+        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
+        AMQP_VALUE value = amqpvalue_create_null();
+        amqpvalue_set_map_value(source, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>]  */
+/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
+/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
+TEST_FUNCTION(amqpvalue_encode_85_key_value_pairs_with_256_size_bytes_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    unsigned char expected_bytes[9 + 255] = { 0xD1, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0xAA };
+    unsigned char i;
+
+    for (i = 0; i < 85; i++)
+    {
+        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
+        AMQP_VALUE value = amqpvalue_create_null();
+        amqpvalue_set_map_value(source, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
+    for (i = 0; i < 85; i++)
+    {
+        expected_bytes[9 + (i * 3)] = 0x52;
+        expected_bytes[9 + (i * 3) + 1] = i + 1;
+        expected_bytes[9 + (i * 3) + 2] = 0x40;
+    }
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_86_key_value_pairs_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    int i;
+
+    AMQP_VALUE key = amqpvalue_create_uint(0xFF);
+    AMQP_VALUE value = amqpvalue_create_uint(0xFF);
+    amqpvalue_set_map_value(source, key, value);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(value);
+
+    for (i = 1; i < 85; i++)
+    {
+        key = amqpvalue_create_uint(i);
+        value = amqpvalue_create_null();
+        amqpvalue_set_map_value(source, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
+    test_amqpvalue_encode_failure(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>]  */
+/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
+/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
+TEST_FUNCTION(amqpvalue_encode_128_key_value_pairs_succeeds)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    unsigned char expected_bytes[9 + 384] = { 0xD1, 0x00, 0x00, 0x01, 0x84, 0x00, 0x00, 0x01, 0x00 };
+    unsigned char i;
+    for (i = 0; i < 128; i++)
+    {
+        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
+        AMQP_VALUE value = amqpvalue_create_null();
+        amqpvalue_set_map_value(source, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
+    for (i = 0; i < 128; i++)
+    {
+        expected_bytes[9 + (i * 3)] = 0x52;
+        expected_bytes[9 + (i * 3) + 1] = i + 1;
+        expected_bytes[9 + (i * 3) + 2] = 0x40;
+    }
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
+    test_amqpvalue_encode(source, expected_stringified);
+}
+
+/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_128_key_value_pairs_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    int i;
+    for (i = 0; i < 128; i++)
+    {
+        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
+        AMQP_VALUE value = amqpvalue_create_null();
+        amqpvalue_set_map_value(source, key, value);
+        amqpvalue_destroy(key);
+        amqpvalue_destroy(value);
+    }
+    test_amqpvalue_encode_failure(source);
+}
+
+/* This test would allocate 4Gb and some people might not like that */
+#if 0
+TEST_FUNCTION(when_encoding_would_result_in_more_than_the_max_size_for_a_map_amqpvalue_encode_fails)
+{
+    AMQP_VALUE source = amqpvalue_create_map();
+    char* very_big_string = (char*)malloc((UINT32_MAX / 4) + 2);
+    AMQP_VALUE some_symbol;
+    AMQP_VALUE key1;
+    AMQP_VALUE key2;
+    AMQP_VALUE key3;
+    AMQP_VALUE key4;
+    int result;
+    (void)memset(very_big_string, 'x', (UINT32_MAX / 4) + 1);
+    very_big_string[(UINT32_MAX / 4) + 1] = '\0';
+    some_symbol = amqpvalue_create_symbol(very_big_string);
+    free(very_big_string);
+    key1 = amqpvalue_create_int(1);
+    key2 = amqpvalue_create_int(2);
+    key3 = amqpvalue_create_int(3);
+    key4 = amqpvalue_create_int(4);
+    (void)amqpvalue_set_map_value(source, key1, some_symbol);
+    (void)amqpvalue_set_map_value(source, key2, some_symbol);
+    (void)amqpvalue_set_map_value(source, key3, some_symbol);
+    (void)amqpvalue_set_map_value(source, key4, some_symbol);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
+    amqpvalue_destroy(key3);
+    amqpvalue_destroy(key4);
+    amqpvalue_destroy(some_symbol);
+
+    // act
+    result = amqpvalue_encode(source, test_encoder_output, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+#endif
+
+/* amqpvalue_get_encoded_size */
+
+/* Tests_SRS_AMQPVALUE_01_309: [If any argument is NULL, amqpvalue_get_encoded_size shall return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_NULL_value_argument_fails)
+{
+    // arrange
+
+    // act
+    size_t encoded_size;
+    int result = amqpvalue_get_encoded_size(NULL, &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_309: [If any argument is NULL, amqpvalue_get_encoded_size shall return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_NULL_encoded_size_argument_fails)
+{
+    // arrange
+    int result;
+    AMQP_VALUE source = amqpvalue_create_null();
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_get_encoded_size(source, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+static void test_amqpvalue_get_encoded_size(AMQP_VALUE source, size_t expected_encoded_size)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_get_encoded_size(source, &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, expected_encoded_size, encoded_size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_null_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_null();
+    test_amqpvalue_get_encoded_size(source, 1);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_272: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_true_bool_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_boolean(true);
+    test_amqpvalue_get_encoded_size(source, 1);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_273: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_false_bool_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_boolean(false);
+    test_amqpvalue_get_encoded_size(source, 1);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_ubyte_0x0_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_ubyte(0x0);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_ubyte_0xFF_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_ubyte(0xFF);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_ushort_0x0_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_ushort(0x0);
+    test_amqpvalue_get_encoded_size(source, 3);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_ushort_0xFFFF_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_ushort(0xFFFF);
+    test_amqpvalue_get_encoded_size(source, 3);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_uint_0xFFFFFFFF_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_uint(0xFFFFFFFF);
+    test_amqpvalue_get_encoded_size(source, 5);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_uint_0xFF_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_uint(0xFF);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_279: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_uint_0x0_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_uint(0x0);
+    test_amqpvalue_get_encoded_size(source, 1);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_ulong_0xFFFFFFFFFFFFFFFF_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_ulong(0xFFFFFFFFFFFFFFFF);
+    test_amqpvalue_get_encoded_size(source, 9);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_ulong_0xFF_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_ulong(0xFF);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_282: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_ulong_0x0_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_ulong(0x0);
+    test_amqpvalue_get_encoded_size(source, 1);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_byte_minus_128_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_byte(-128);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_byte_127_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_byte(127);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_short_minus_32768_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_short(-32768);
+    test_amqpvalue_get_encoded_size(source, 3);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_2147483647_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_int(2147483647);
+    test_amqpvalue_get_encoded_size(source, 5);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_minus_2147483648_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_int(-2147483647-1);
+    test_amqpvalue_get_encoded_size(source, 5);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_127_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_int(127);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_minus_128_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_int(-128);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_9223372036854775807_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_long(9223372036854775807LL);
+    test_amqpvalue_get_encoded_size(source, 9);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_minus_9223372036854775808_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_long(-9223372036854775807LL - 1);
+    test_amqpvalue_get_encoded_size(source, 9);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_127_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_long(127);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_minus_128_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_long(-128);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_timestamp_9223372036854775807_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_timestamp(9223372036854775807LL);
+    test_amqpvalue_get_encoded_size(source, 9);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_timestamp_minus_9223372036854775808_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_timestamp(-9223372036854775807LL - 1);
+    test_amqpvalue_get_encoded_size(source, 9);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_uuid_value_succeeds)
+{
+    // arrange
+    uuid uuid = { 0 };
+    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
+    test_amqpvalue_get_encoded_size(source, 17);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>]  */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_zero_length_value_succeeds)
+{
+    // arrange
+    amqp_binary binary = { NULL, 0 };
+    AMQP_VALUE source = amqpvalue_create_binary(binary);
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_1_length_value_succeeds)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    amqp_binary binary;
+    AMQP_VALUE source;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    test_amqpvalue_get_encoded_size(source, 3);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_255_length_value_succeeds)
+{
+    // arrange
+    unsigned char bytes[255] = { 0x42 };
+    amqp_binary binary;
+    AMQP_VALUE source;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    test_amqpvalue_get_encoded_size(source, 257);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_298: [<encoding name="vbin32" code="0xb0" category="variable" width="4" label="up to 2^32 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_256_length_value_succeeds)
+{
+    // arrange
+    unsigned char bytes[256] = { 0x42 };
+    amqp_binary binary;
+    AMQP_VALUE source;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    source = amqpvalue_create_binary(binary);
+    test_amqpvalue_get_encoded_size(source, 261);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_0_length_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_string("");
+    test_amqpvalue_get_encoded_size(source, 2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_1_length_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_string("a");
+    test_amqpvalue_get_encoded_size(source, 3);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_255_chars_length_value_succeeds)
+{
+    // arrange
+    char string[256];
+    AMQP_VALUE source;
+    memset(string, 'a', 255);
+    string[255] = 0;
+    source = amqpvalue_create_string(string);
+    test_amqpvalue_get_encoded_size(source, 257);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_300: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_256_chars_length_value_succeeds)
+{
+    // arrange
+    char string[257];
+    AMQP_VALUE source;
+    (void)memset(string, 'a', 256);
+    string[256] = 0;
+    source = amqpvalue_create_string(string);
+    test_amqpvalue_get_encoded_size(source, 261);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_303: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_empty_list_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_list();
+    test_amqpvalue_get_encoded_size(source, 1);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_1_item_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 4);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_2_items_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(source, 0, item);
+    (void)amqpvalue_set_list_item(source, 1, item);
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 5);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_1_string_item_with_5_chars_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_string("fluff");
+    (void)amqpvalue_set_list_item(source, 0, item);
+    amqpvalue_destroy(item);
+    /* 1 - list descriptor +
+        1 - list size
+        1 - list item count
+        1 - string descriptor
+        1 - string length
+        5 - string chars */
+    test_amqpvalue_get_encoded_size(source, 10);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_254_null_items_succeeds)
+{
+    // arrange
+    uint32_t i;
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    for (i = 0; i < 254; i++)
+    {
+        (void)amqpvalue_set_list_item(source, i, item);
+    }
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 257);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_255_null_items_succeeds)
+{
+    // arrange
+    uint32_t i;
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    for (i = 0; i < 255; i++)
+    {
+        (void)amqpvalue_set_list_item(source, i, item);
+    }
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 264);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_empty_map_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_map();
+    test_amqpvalue_get_encoded_size(source, 3);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_1_null_key_and_value_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE item = amqpvalue_create_null();
+    amqpvalue_set_map_value(source, item, item);
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 5);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_2_keys_and_values_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE key1 = amqpvalue_create_uint(1);
+    AMQP_VALUE key2 = amqpvalue_create_uint(2);
+    AMQP_VALUE item = amqpvalue_create_null();
+    amqpvalue_set_map_value(source, key1, item);
+    amqpvalue_set_map_value(source, key2, item);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 9);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_1_key_and_value_254_bytes_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE key1 = amqpvalue_create_null();
+    char string[252];
+    AMQP_VALUE item;
+    memset(string, 'a', 251);
+    string[251] = 0;
+    item = amqpvalue_create_string(string);
+    amqpvalue_set_map_value(source, key1, item);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 257);
+}
+
+/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
+/* Tests_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>] */
+TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_1_key_and_value_256_bytes_succeeds)
+{
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_map();
+    AMQP_VALUE key1 = amqpvalue_create_null();
+    char string[254];
+    AMQP_VALUE item;
+    memset(string, 'a', 253);
+    string[253] = 0;
+    item = amqpvalue_create_string(string);
+    amqpvalue_set_map_value(source, key1, item);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(item);
+    test_amqpvalue_get_encoded_size(source, 265);
+}
+
+/* Tests_SRS_AMQPVALUE_01_451: [ The encoded size computed for a value shall be cached in the value and reused until a list, map or array is changed. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_size_after_changing_a_shared_inner_list_returns_the_new_size)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE inner_list = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(source, 0, inner_list);
+    (void)amqpvalue_get_encoded_size(source, &encoded_size);
+    (void)amqpvalue_set_list_item(inner_list, 0, item);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_get_encoded_size(source, &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 7, encoded_size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(inner_list);
+    amqpvalue_destroy(item);
+}
+
+/* amqpvalue_encode_to_buffer */
+
+/* Tests_SRS_AMQPVALUE_01_453: [ If `value`, `buffer` or `encoded_size` is NULL, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_with_NULL_value_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+    size_t encoded_size;
+
+    // act
+    result = amqpvalue_encode_to_buffer(NULL, buffer, sizeof(buffer), &encoded_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_453: [ If `value`, `buffer` or `encoded_size` is NULL, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_with_NULL_buffer_fails)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+    AMQP_VALUE source = amqpvalue_create_null();
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_encode_to_buffer(source, NULL, 16, &encoded_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_453: [ If `value`, `buffer` or `encoded_size` is NULL, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_with_NULL_encoded_size_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+    AMQP_VALUE source = amqpvalue_create_null();
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_encode_to_buffer(source, buffer, sizeof(buffer), NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* Tests_SRS_AMQPVALUE_01_452: [ `amqpvalue_encode_to_buffer` shall encode `value` into `buffer` and fill in `encoded_size` with the number of bytes written. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_encodes_a_list)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+    unsigned char expected_bytes[] = { 0xC0, 0x03, 0x02, 0x40, 0x41 };
+    size_t encoded_size;
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item1 = amqpvalue_create_null();
+    AMQP_VALUE item2 = amqpvalue_create_boolean(true);
+    (void)amqpvalue_set_list_item(source, 0, item1);
+    (void)amqpvalue_set_list_item(source, 1, item2);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_encode_to_buffer(source, buffer, sizeof(buffer), &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), encoded_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_452: [ `amqpvalue_encode_to_buffer` shall encode `value` into `buffer` and fill in `encoded_size` with the number of bytes written. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_encodes_multi_byte_fields_in_network_byte_order)
+{
+    // arrange
+    int result;
+    unsigned char buffer[32];
+    unsigned char expected_bytes[] = { 0xC0, 0x0F, 0x02, 0x80, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x71, 0xFF, 0xFE, 0x79, 0x60 };
+    size_t encoded_size;
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE item1 = amqpvalue_create_ulong(0x0102030405060708);
+    AMQP_VALUE item2 = amqpvalue_create_int(-100000);
+    (void)amqpvalue_set_list_item(source, 0, item1);
+    (void)amqpvalue_set_list_item(source, 1, item2);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_encode_to_buffer(source, buffer, sizeof(buffer), &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), encoded_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
+}
+
+/* Tests_SRS_AMQPVALUE_01_454: [ If the encoded value does not fit in `buffer_size` bytes, `amqpvalue_encode_to_buffer` shall fail and return a non-zero value, filling in `encoded_size` with the needed size. ]*/
+TEST_FUNCTION(amqpvalue_encode_to_buffer_with_a_buffer_too_small_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[4];
+    size_t encoded_size;
+    AMQP_VALUE source = amqpvalue_create_string("test");
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_encode_to_buffer(source, buffer, sizeof(buffer), &encoded_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 6, encoded_size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(source);
+}
+
+/* amqpvalue_destroy */
+
+/* Tests_SRS_AMQPVALUE_01_315: [If the value argument is NULL, amqpvalue_destroy shall do nothing.] */
+TEST_FUNCTION(amqpvalue_decoder_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    amqpvalue_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_null_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_null();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ubyte_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ubyte(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ushort_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ushort(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uint_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_uint(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ulong_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ulong(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_byte_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_byte(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_short_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_short(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_int_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_int(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_long_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_long(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_float_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_float(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_double_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_double(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_char_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_char(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_timestamp_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_timestamp(0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uuid_value)
+{
+    // arrange
+    uuid uuid = { 0 };
+    AMQP_VALUE value = amqpvalue_create_uuid(uuid);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_binary_value)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    amqp_binary binary;
+    AMQP_VALUE value;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    value = amqpvalue_create_binary(binary);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_string_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("a value too long to be stored inline");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_symbol_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_symbol("a value too long to be stored inline");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_list_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_value_with_1_null_item)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(value, 0, null_value);
+    amqpvalue_destroy(null_value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_value_with_2_null_items)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(value, 0, null_value);
+    (void)amqpvalue_set_list_item(value, 1, null_value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(null_value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_map_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_value_with_1_key_value_pair)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_map_value(value, null_value, null_value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(null_value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_value_with_2_key_value_pairs)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE key1 = amqpvalue_create_ubyte(1);
+    AMQP_VALUE key2 = amqpvalue_create_uint(2);
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_map_value(value, key1, null_value);
+    (void)amqpvalue_set_map_value(value, key2, null_value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
+    amqpvalue_destroy(null_value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_null_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_null_cloned_value_when_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ubyte_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ubyte(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ubyte_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ubyte(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ushort_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ushort(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ushort_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ushort(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uint_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_uint(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uint_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_uint(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ulong_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ulong(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ulong_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_ulong(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_byte_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_byte(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_byte_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_byte(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_short_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_short(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_short_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_short(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_int_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_int(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_int_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_int(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_long_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_long(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_long_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_long(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_float_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_float(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_float_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_float(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_double_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_double(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_double_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_double(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_char_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_char(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_char_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_char(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_timestamp_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_timestamp(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_timestamp_cloned_value_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_timestamp(0);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uuid_cloned_value)
+{
+    // arrange
+    uuid uuid = { 0 };
+    AMQP_VALUE value = amqpvalue_create_uuid(uuid);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uuid_cloned_value_last_reference)
+{
+    // arrange
+    uuid uuid = { 0 };
+    AMQP_VALUE value = amqpvalue_create_uuid(uuid);
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_binary_cloned_value)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
     amqp_binary binary;
-    AMQP_VALUE source;
-    for (i = 0; i < 255; i++)
-    {
-        bytes[i] = (unsigned char)i;
-    }
-    for (i = 0; i < 255; i++)
-    {
-        expected_bytes[i + 2] = (unsigned char)i;
-    }
+    AMQP_VALUE value;
+    AMQP_VALUE cloned_value;
     binary.bytes = &bytes;
     binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    value = amqpvalue_create_binary(binary);
+    cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_binary_cloned_value_last_Reference)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    amqp_binary binary;
+    AMQP_VALUE value;
+    AMQP_VALUE cloned_value;
+    binary.bytes = &bytes;
+    binary.length = sizeof(bytes);
+    value = amqpvalue_create_binary(binary);
+    cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_binary_255_bytes_fails)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_string_cloned_value)
 {
-    unsigned char bytes[255];
-    unsigned int i;
-    amqp_binary binary;
-    AMQP_VALUE source;
-    for (i = 0; i < 255; i++)
-    {
-        bytes[i] = (unsigned char)i;
-    }
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("test");
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_298: [<encoding name="vbin32" code="0xb0" category="variable" width="4" label="up to 2^32 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_encode_binary_256_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_string_cloned_value_last_reference)
 {
-    unsigned char bytes[256];
-    unsigned char expected_bytes[261] = { 0xB0, 0x00, 0x00, 0x01, 0x00 };
-    unsigned int i;
-    AMQP_VALUE source;
-    amqp_binary binary;
-    for (i = 0; i < 256; i++)
-    {
-        bytes[i] = (unsigned char)i;
-    }
-    for (i = 0; i < 256; i++)
-    {
-        expected_bytes[i + 5] = (unsigned char)i;
-    }
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_string("a value too long to be stored inline");
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_binary_256_bytes_fails)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_list_cloned_value)
 {
-    unsigned char bytes[256];
-    unsigned int i;
-    AMQP_VALUE source;
-    amqp_binary binary;
-    for (i = 0; i < 256; i++)
-    {
-        bytes[i] = (unsigned char)i;
-    }
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_encode_string_with_empty_string_succeeds)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_list_cloned_value_last_Reference)
 {
-    AMQP_VALUE source = amqpvalue_create_string("");
-    test_amqpvalue_encode(source, "[0xA1,0x00]");
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_encode_string_with_char_succeeds)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_1_null_item)
 {
-    AMQP_VALUE source = amqpvalue_create_string("a");
-    test_amqpvalue_encode(source, "[0xA1,0x01,0x61]");
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_list_item(value, 0, null_value);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_encode_string_with_255_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_1_null_item_last_reference)
 {
-    char chars[256];
-    unsigned char expected_bytes[257] = { 0xA1, 0xFF };
-    AMQP_VALUE source;
-    int i;
-    for (i = 0; i < 255; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[255] = '\0';
-    for (i = 0; i < 255; i++)
-    {
-        expected_bytes[i + 2] = 'a';
-    }
-    source = amqpvalue_create_string(chars);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_list_item(value, 0, null_value);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_2_null_items)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_list_item(value, 0, null_value);
+    (void)amqpvalue_set_list_item(value, 1, null_value);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_2_null_items_last_reference)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_list();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_list_item(value, 0, null_value);
+    (void)amqpvalue_set_list_item(value, 1, null_value);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_map_cloned_value)
+{
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_string_with_255_chars_fails)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_map_cloned_value_last_reference)
 {
-    char chars[256];
-    int i;
-    AMQP_VALUE source;
-    for (i = 0; i < 255; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[255] = '\0';
-    source = amqpvalue_create_string(chars);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_300: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_encode_string_with_256_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_1_key_value_pair)
 {
-    char chars[257];
-    int i;
-    AMQP_VALUE source;
-    unsigned char expected_bytes[261] = { 0xB1, 0x00, 0x00, 0x01, 0x00 };
-    for (i = 0; i < 256; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[256] = '\0';
-    for (i = 0; i < 256; i++)
-    {
-        expected_bytes[i + 5] = 'a';
-    }
-    source = amqpvalue_create_string(chars);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_map_value(value, null_value, null_value);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_string_with_256_chars_fails)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_1_key_value_pair_last_reference)
 {
-    char chars[257];
-    int i;
-    AMQP_VALUE source;
-    for (i = 0; i < 256; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[256] = '\0';
-    source = amqpvalue_create_string(chars);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_map_value(value, null_value, null_value);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_encode_symbol_with_empty_symbol_succeeds)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_2_key_value_pairs)
 {
-    AMQP_VALUE source = amqpvalue_create_symbol("");
-    test_amqpvalue_encode(source, "[0xA3,0x00]");
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE key1 = amqpvalue_create_ubyte(1);
+    AMQP_VALUE key2 = amqpvalue_create_uint(2);
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_map_value(value, key1, null_value);
+    (void)amqpvalue_set_map_value(value, key2, null_value);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_encode_symbol_with_char_succeeds)
+/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
+/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_2_key_value_pairs_last_reference)
 {
-    AMQP_VALUE source = amqpvalue_create_symbol("a");
-    test_amqpvalue_encode(source, "[0xA3,0x01,0x61]");
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_map();
+    AMQP_VALUE key1 = amqpvalue_create_ubyte(1);
+    AMQP_VALUE key2 = amqpvalue_create_uint(2);
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    AMQP_VALUE cloned_value;
+    (void)amqpvalue_set_map_value(value, key1, null_value);
+    (void)amqpvalue_set_map_value(value, key2, null_value);
+    amqpvalue_destroy(key1);
+    amqpvalue_destroy(key2);
+    amqpvalue_destroy(null_value);
+    cloned_value = amqpvalue_clone(value);
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_destroy(cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_301: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_encode_symbol_with_255_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_564: [ amqpvalue_destroy shall free the values nested in lists, maps, arrays and described values without recursing, whatever the nesting depth. ]*/
+TEST_FUNCTION(amqpvalue_destroy_frees_a_deeply_nested_list)
 {
-    char chars[256];
-    unsigned char expected_bytes[257] = { 0xA3, 0xFF };
-    int i;
-    AMQP_VALUE source;
-    for (i = 0; i < 255; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[255] = '\0';
-    for (i = 0; i < 255; i++)
+    // arrange
+    AMQP_VALUE source = amqpvalue_create_list();
+    AMQP_VALUE list = source;
+    size_t i;
+    umock_c_reset_all_calls();
+
+    for (i = 0; i < 100000; i++)
     {
-        expected_bytes[i + 2] = 'a';
+        AMQP_VALUE inner_list = amqpvalue_create_list();
+        (void)amqpvalue_set_list_item(list, 0, inner_list);
+        amqpvalue_destroy(inner_list);
+        list = inner_list;
     }
-    source = amqpvalue_create_symbol(chars);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(source);
+
+    // assert
+    /* no stack overflow, and memory checks report no leak */
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_symbol_with_255_chars_fails)
+/* Tests_SRS_AMQPVALUE_01_590: [ amqpvalue_destroy shall only free a nested value when the reference it drops on it is the last one, so that a value shared with trees still in use, on the calling thread or on other threads, stays valid for the holders of its other references. ]*/
+TEST_FUNCTION(amqpvalue_destroy_leaves_a_nested_value_shared_with_another_tree_valid)
 {
-    char chars[256];
-    int i;
-    AMQP_VALUE source;
-    for (i = 0; i < 255; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[255] = '\0';
-    source = amqpvalue_create_symbol(chars);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    AMQP_VALUE first_list = amqpvalue_create_list();
+    AMQP_VALUE second_list = amqpvalue_create_list();
+    AMQP_VALUE shared_string = amqpvalue_create_string("shared");
+    const char* string_value;
+    int result;
+    (void)amqpvalue_set_list_item(first_list, 0, shared_string);
+    (void)amqpvalue_set_list_item(second_list, 0, shared_string);
+    amqpvalue_destroy(shared_string);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_destroy(first_list);
+
+    // assert
+    shared_string = amqpvalue_get_list_item(second_list, 0);
+    result = amqpvalue_get_string(shared_string, &string_value);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "shared", string_value);
+
+    // cleanup
+    amqpvalue_destroy(shared_string);
+    amqpvalue_destroy(second_list);
 }
 
-/* Tests_SRS_AMQPVALUE_01_302: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-/* Tests_SRS_AMQPVALUE_01_122: [Symbols are encoded as ASCII characters [ASCII].] */
-TEST_FUNCTION(amqpvalue_encode_symbol_with_256_chars_succeeds)
+/* amqpvalue_set_reclaimer */
+
+static AMQP_VALUE reclaimed_value;
+static void* reclaim_context;
+
+static void test_on_reclaim(void* context, AMQP_VALUE value)
 {
-    char chars[257];
-    unsigned char expected_bytes[261] = { 0xB3, 0x00, 0x00, 0x01, 0x00 };
-    int i;
-    AMQP_VALUE source;
-    for (i = 0; i < 256; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[256] = '\0';
-    for (i = 0; i < 256; i++)
-    {
-        expected_bytes[i + 5] = 'a';
-    }
-    source = amqpvalue_create_symbol(chars);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    reclaim_context = context;
+    reclaimed_value = value;
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_symbol_with_256_chars_fails)
+/* Tests_SRS_AMQPVALUE_01_566: [ If on_reclaim is not NULL and min_item_count is 0, amqpvalue_set_reclaimer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_set_reclaimer_with_0_min_item_count_fails)
 {
-    char chars[257];
-    int i;
-    AMQP_VALUE source;
-    for (i = 0; i < 256; i++)
-    {
-        chars[i] = 'a';
-    }
-    chars[256] = '\0';
-    source = amqpvalue_create_symbol(chars);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    int result;
+
+    // act
+    result = amqpvalue_set_reclaimer(0, test_on_reclaim, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_303: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_empty_list_succeeds)
+/* Tests_SRS_AMQPVALUE_01_565: [ amqpvalue_set_reclaimer shall set the callback amqpvalue_destroy passes large values to, a NULL on_reclaim removing it, and return 0. ]*/
+/* Tests_SRS_AMQPVALUE_01_567: [ When a reclaimer is set, amqpvalue_destroy shall not free a list, map or array holding at least min_item_count items when its last reference is dropped, but pass it with one reference to on_reclaim. ]*/
+TEST_FUNCTION(amqpvalue_destroy_of_a_large_list_passes_it_to_the_reclaimer)
 {
+    // arrange
     AMQP_VALUE source = amqpvalue_create_list();
-    test_amqpvalue_encode(source, "[0x45]");
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    int result;
+    (void)amqpvalue_set_list_item(source, 1, null_value);
+    amqpvalue_destroy(null_value);
+    reclaimed_value = NULL;
+    reclaim_context = NULL;
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_set_reclaimer(2, test_on_reclaim, (void*)0x4242);
+    amqpvalue_destroy(source);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, source, reclaimed_value);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4242, reclaim_context);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)amqpvalue_set_reclaimer(0, NULL, NULL);
+    amqpvalue_reclaim(source);
 }
 
-/* This test would allocate 4Gb and some people might not like that */
-#if 0
-TEST_FUNCTION(when_encoding_would_result_in_more_than_the_max_size_for_a_list_amqpvalue_encode_fails)
+/* Tests_SRS_AMQPVALUE_01_565: [ amqpvalue_set_reclaimer shall set the callback amqpvalue_destroy passes large values to, a NULL on_reclaim removing it, and return 0. ]*/
+TEST_FUNCTION(amqpvalue_destroy_of_a_list_smaller_than_min_item_count_frees_it)
 {
-    int result;
+    // arrange
     AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item1;
-    AMQP_VALUE item2;
-    AMQP_VALUE item3;
-    AMQP_VALUE item4;
-    char* very_big_string = (char*)malloc((UINT32_MAX / 4) + 2);
-    (void)memset(very_big_string, 'x', (UINT32_MAX / 4) + 1);
-    very_big_string[(UINT32_MAX / 4) + 1] = '\0';
-    item1 = amqpvalue_create_symbol(very_big_string);
-    item2 = amqpvalue_create_symbol(very_big_string);
-    item3 = amqpvalue_create_symbol(very_big_string);
-    item4 = amqpvalue_create_symbol(very_big_string);
-    free(very_big_string);
-    (void)amqpvalue_set_list_item(source, 0, item1);
-    (void)amqpvalue_set_list_item(source, 1, item2);
-    (void)amqpvalue_set_list_item(source, 2, item3);
-    (void)amqpvalue_set_list_item(source, 3, item4);
-    amqpvalue_destroy(item1);
-    amqpvalue_destroy(item2);
-    amqpvalue_destroy(item3);
-    amqpvalue_destroy(item4);
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(source, 0, null_value);
+    amqpvalue_destroy(null_value);
+    (void)amqpvalue_set_reclaimer(2, test_on_reclaim, NULL);
+    reclaimed_value = NULL;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_encode(source, test_encoder_output, NULL);
+    amqpvalue_destroy(source);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(reclaimed_value);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
+    (void)amqpvalue_set_reclaimer(0, NULL, NULL);
 }
-#endif
 
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_with_one_null_item_succeeds)
+/* amqpvalue_reclaim */
+
+/* Tests_SRS_AMQPVALUE_01_568: [ If value is NULL, amqpvalue_reclaim shall do nothing. ]*/
+TEST_FUNCTION(amqpvalue_reclaim_with_NULL_value_does_nothing)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    test_amqpvalue_encode(source, "[0xC0,0x02,0x01,0x40]");
+    // arrange
+
+    // act
+    amqpvalue_reclaim(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_list_with_one_null_item_fails)
+/* Tests_SRS_AMQPVALUE_01_569: [ amqpvalue_reclaim shall drop a reference to value like amqpvalue_destroy, freeing it when it was the last one without passing it to the reclaimer. ]*/
+TEST_FUNCTION(amqpvalue_reclaim_frees_a_large_list)
 {
+    // arrange
     AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    test_amqpvalue_encode_failure(source);
+    AMQP_VALUE null_value = amqpvalue_create_null();
+    (void)amqpvalue_set_list_item(source, 1, null_value);
+    amqpvalue_destroy(null_value);
+    (void)amqpvalue_set_reclaimer(1, test_on_reclaim, NULL);
+    reclaimed_value = NULL;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    amqpvalue_reclaim(source);
+
+    // assert
+    ASSERT_IS_NULL(reclaimed_value);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)amqpvalue_set_reclaimer(0, NULL, NULL);
 }
 
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_with_2_null_item_succeeds)
+/* amqpvalue_free_thread_node_cache */
+
+/* Tests_SRS_AMQPVALUE_01_563: [ When not built with UAMQP_VALUE_NODE_CACHE, amqpvalue_free_thread_node_cache shall do nothing. ]*/
+TEST_FUNCTION(amqpvalue_free_thread_node_cache_does_not_free_anything)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_set_list_item(source, 1, item);
-    amqpvalue_destroy(item);
-    test_amqpvalue_encode(source, "[0xC0,0x03,0x02,0x40,0x40]");
+    // arrange
+    AMQP_VALUE value = amqpvalue_create_null();
+    amqpvalue_destroy(value);
+    umock_c_reset_all_calls();
+
+    // act
+    amqpvalue_free_thread_node_cache();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_with_254_null_items_succeeds)
+/* amqpvalue_decoder_create */
+
+/* Tests_SRS_AMQPVALUE_01_311: [amqpvalue_decoder_create shall create a new amqp value decoder and return a non-NULL handle to it.] */
+TEST_FUNCTION(amqpvalue_decoder_create_returns_a_non_NULL_handle)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    unsigned char expected_bytes[257] = { 0xC0, 0xFF, 0xFE };
-    int i;
-    for (i = 0; i < 254; i++)
-    {
-        amqpvalue_set_list_item(source, i, item);
-    }
-    amqpvalue_destroy(item);
-    for (i = 0; i < 254; i++)
-    {
-        expected_bytes[i + 3] = 0x40;
-    }
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    AMQPVALUE_DECODER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
+    // act
+    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_then_amqpvalue_encode_list_with_255_null_items_fails)
+/* Tests_SRS_AMQPVALUE_01_312: [If the value_decoded_callback argument is NULL, amqpvalue_decoder_create shall return NULL.] */
+TEST_FUNCTION(amqpvalue_decoder_create_with_NULL_callback_returns_NULL)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    int i;
-    for (i = 0; i < 255; i++)
-    {
-        amqpvalue_set_list_item(source, i, item);
-    }
-    amqpvalue_destroy(item);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+
+    // act
+    AMQPVALUE_DECODER_HANDLE result = amqpvalue_decoder_create(NULL, test_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_1_item_with_254_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
+TEST_FUNCTION(when_allocating_the_decoder_fails_amqpvalue_decoder_create_fails)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    unsigned char bytes[252] = { 0 };
-    unsigned char expected_bytes[257] = { 0xC0, 0xFF, 0x01, 0xA0, 0xFC };
-    int i;
-    amqp_binary binary;
-    AMQP_VALUE item;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    item = amqpvalue_create_binary(binary);
-    amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    for (i = 0; i < 252; i++)
-    {
-        expected_bytes[i + 5] = 0;
-    }
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    AMQPVALUE_DECODER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_1_item_with_255_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
+TEST_FUNCTION(when_allocating_the_initial_decode_value_fails_amqpvalue_decoder_create_fails)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    unsigned char bytes[253] = { 0 };
-    unsigned char expected_bytes[253 + 11] = { 0xD0, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0xA0, 0xFD };
-    int i;
-    amqp_binary binary;
-    AMQP_VALUE item;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    item = amqpvalue_create_binary(binary);
-    amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    for (i = 0; i < 253; i++)
-    {
-        expected_bytes[i + 11] = 0;
-    }
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    AMQPVALUE_DECODER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_list_1_item_with_256_bytes_fails)
+/* Tests_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
+TEST_FUNCTION(when_allocating_memoory_fails_amqpvalue_decoder_create_fails)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    unsigned char bytes[254] = { 0 };
-    amqp_binary binary;
-    AMQP_VALUE item;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    item = amqpvalue_create_binary(binary);
-    amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    test_amqpvalue_encode_failure(source);
-}
+    // arrange
+    AMQPVALUE_DECODER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
-/* Tests_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_255_null_items_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    unsigned char expected_bytes[255 + 9] = { 0xD0, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0xFF };
-    int i;
-    for (i = 0; i < 255; i++)
-    {
-        amqpvalue_set_list_item(source, i, item);
-    }
-    amqpvalue_destroy(item);
-    for (i = 0; i < 255; i++)
-    {
-        expected_bytes[i + 9] = 0x40;
-    }
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // act
+    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_list_256_null_items_fails)
+/* amqpvalue_decoder_destroy */
+
+/* Tests_SRS_AMQPVALUE_01_316: [amqpvalue_decoder_destroy shall free all resources associated with the amqpvalue_decoder.] */
+TEST_FUNCTION(amqpvalue_destroy_frees_underlying_allocated_chunks)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    int i;
-    for (i = 0; i < 256; i++)
-    {
-        amqpvalue_set_list_item(source, i, item);
-    }
-    amqpvalue_destroy(item);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+
+    // act
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_encode_list_with_2_different_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_317: [If handle is NULL, amqpvalue_decoder_destroy shall do nothing.] */
+TEST_FUNCTION(amqpvalue_destroy_with_NULL_handle_does_not_free_anything)
 {
-    AMQP_VALUE source = amqpvalue_create_list();
-    unsigned char bytes[] = { 0x42 };
-    unsigned char expected_bytes[] = { 0xC0, 0x05, 0x02, 0xA0, 0x01, 0x42, 0x40 };
-    amqp_binary binary;
-    AMQP_VALUE item;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    item = amqpvalue_create_binary(binary);
-    amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    item = amqpvalue_create_null();
-    amqpvalue_set_list_item(source, 1, item);
-    amqpvalue_destroy(item);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+
+    // act
+    amqpvalue_decoder_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-TEST_FUNCTION(amqpvalue_encode_empty_map_succeeds)
+/* amqpvalue_decode_bytes */
+
+/* Tests_SRS_AMQPVALUE_01_320: [If handle or buffer are NULL, amqpvalue_decode_bytes shall return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_decode_bytes_with_NULL_handle_fails)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
-    unsigned char expected_bytes[] = { 0xC1, 0x01, 0x00 };
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    unsigned char bytes[] = { 0x40 };
+
+    // act
+    int result = amqpvalue_decode_bytes(NULL, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_empty_map_fails)
+/* Tests_SRS_AMQPVALUE_01_320: [If handle or buffer are NULL, amqpvalue_decode_bytes shall return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_decode_bytes_with_NULL_buffer_fails)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, NULL, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
-/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
-TEST_FUNCTION(amqpvalue_encode_a_map_with_a_null_key_and_null_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_321: [If size is 0, amqpvalue_decode_bytes shall return a non-zero value.] */
+TEST_FUNCTION(amqpvalue_decode_bytes_with_0_size_fails)
 {
-    unsigned char expected_bytes[] = { 0xC1, 0x03, 0x02, 0x40, 0x40 };
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE key = amqpvalue_create_null();
-    AMQP_VALUE value = amqpvalue_create_null();
-    amqpvalue_set_map_value(source, key, value);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x40 };
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_a_map_with_a_null_key_and_null_value_fails)
+/* Tests_SRS_AMQPVALUE_01_318: [amqpvalue_decode_bytes shall decode size bytes that are passed in the buffer argument.] */
+/* Tests_SRS_AMQPVALUE_01_319: [On success, amqpvalue_decode_bytes shall return 0.] */
+/* Tests_SRS_AMQPVALUE_01_322: [amqpvalue_decode_bytes shall process the bytes byte by byte, as a stream.] */
+/* Tests_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the value_decoded_callback passed in amqpvalue_decoder_create shall be called.] */
+/* Tests_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to value_decoded_callback.] */
+/* Tests_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the value_decoded_callback callback.] */
+/* Tests_SRS_AMQPVALUE_01_328: [1.6.1 null Indicates an empty value.] */
+/* Tests_SRS_AMQPVALUE_01_329: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
+TEST_FUNCTION(amqpvalue_decode_1_amqp_null_value_succeeds)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE key = amqpvalue_create_null();
-    AMQP_VALUE value = amqpvalue_create_null();
-    amqpvalue_set_map_value(source, key, value);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x40 };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(decoded_values[0]));
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
-/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
-TEST_FUNCTION(amqpvalue_encode_a_map_with_a_uint_key_and_uint_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_318: [amqpvalue_decode_bytes shall decode size bytes that are passed in the buffer argument.] */
+/* Tests_SRS_AMQPVALUE_01_319: [On success, amqpvalue_decode_bytes shall return 0.] */
+/* Tests_SRS_AMQPVALUE_01_322: [amqpvalue_decode_bytes shall process the bytes byte by byte, as a stream.] */
+/* Tests_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the value_decoded_callback passed in amqpvalue_decoder_create shall be called.] */
+/* Tests_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to value_decoded_callback.] */
+/* Tests_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the value_decoded_callback callback.] */
+/* Tests_SRS_AMQPVALUE_01_328: [1.6.1 null Indicates an empty value.] */
+/* Tests_SRS_AMQPVALUE_01_329: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
+TEST_FUNCTION(amqpvalue_decode_2_amqp_null_values_succeeds)
 {
-    unsigned char expected_bytes[] = { 0xC1, 0x05, 0x02, 0x52, 0x42, 0x52, 0x43 };
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE key = amqpvalue_create_uint(0x42);
-    AMQP_VALUE value = amqpvalue_create_uint(0x43);
-    amqpvalue_set_map_value(source, key, value);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x40, 0x40 };
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(decoded_values[0]));
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(decoded_values[1]));
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_a_map_with_a_uint_key_and_uint_value_fails)
+/* Tests_SRS_AMQPVALUE_01_322: [amqpvalue_decode_bytes shall process the bytes byte by byte, as a stream.] */
+/* Tests_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the value_decoded_callback passed in amqpvalue_decoder_create shall be called.] */
+TEST_FUNCTION(amqpvalue_decode_string_followed_by_uint_in_one_buffer_succeeds)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE key = amqpvalue_create_uint(0x42);
-    AMQP_VALUE value = amqpvalue_create_uint(0x43);
-    amqpvalue_set_map_value(source, key, value);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
-    test_amqpvalue_encode_failure(source);
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0xA1, 0x02, 'a', 'b', 0x70, 0x01, 0x02, 0x03, 0x04 };
+    const char* actual_string;
+    uint32_t actual_uint;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_string(decoded_values[0], &actual_string);
+    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_string);
+    (void)amqpvalue_get_uint(decoded_values[1], &actual_uint);
+    ASSERT_ARE_EQUAL(uint32_t, 0x01020304, actual_uint);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
-/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
-TEST_FUNCTION(amqpvalue_encode_85_key_value_pairs_succeeds)
+/* Tests_SRS_AMQPVALUE_01_322: [amqpvalue_decode_bytes shall process the bytes byte by byte, as a stream.] */
+TEST_FUNCTION(amqpvalue_decode_list_header_and_items_in_separate_buffers_succeeds)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
-    unsigned char expected_bytes[3 + 254] = { 0xC1, 0xFF, 0xAA };
-    unsigned char i;
-
-    AMQP_VALUE key = amqpvalue_create_uint(0);
-    AMQP_VALUE value = amqpvalue_create_null();
-    amqpvalue_set_map_value(source, key, value);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
+    // arrange
+    int result1;
+    int result2;
+    unsigned char bytes[] = { 0xC0, 0x03, 0x01, 0x52, 0x2A };
+    uint32_t item_count;
+    uint32_t actual_uint;
+    AMQP_VALUE item;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
 
-    for (i = 0; i < 84; i++)
-    {
-        key = amqpvalue_create_uint(i + 1);
-        value = amqpvalue_create_null();
-        amqpvalue_set_map_value(source, key, value);
-        amqpvalue_destroy(key);
-        amqpvalue_destroy(value);
-    }
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-    expected_bytes[3] = 0x43;
-    expected_bytes[4] = 0x40;
+    // act
+    result1 = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, 3);
+    result2 = amqpvalue_decode_bytes(amqpvalue_decoder, bytes + 3, sizeof(bytes) - 3);
 
-    for (i = 1; i < 85; i++)
-    {
-        expected_bytes[5 + ((i - 1) * 3)] = 0x52;
-        expected_bytes[5 + ((i - 1) * 3) + 1] = i;
-        expected_bytes[5 + ((i - 1) * 3) + 2] = 0x40;
-    }
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result1);
+    ASSERT_ARE_EQUAL(int, 0, result2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 1, item_count);
+    item = amqpvalue_get_list_item(decoded_values[0], 0);
+    (void)amqpvalue_get_uint(item, &actual_uint);
+    ASSERT_ARE_EQUAL(uint32_t, 42, actual_uint);
 
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // cleanup
+    amqpvalue_destroy(item);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_85_key_value_pairs_fails)
+/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
+/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
+TEST_FUNCTION(amqpvalue_decode_boolean_false_succeeds)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
-    int i;
-    for (i = 0; i < 85; i++)
-    {
-        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
-        AMQP_VALUE value = amqpvalue_create_null();
-        amqpvalue_set_map_value(source, key, value);
-        amqpvalue_destroy(key);
-        amqpvalue_destroy(value);
-    }
-    test_amqpvalue_encode_failure(source);
-}
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x56, 0x00 };
+    bool actual_value = true;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>]  */
-/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
-/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
-TEST_FUNCTION(amqpvalue_encode_85_key_value_pairs_with_256_size_bytes_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_map();
-    unsigned char expected_bytes[9 + 255] = { 0xD1, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0xAA };
-    unsigned char i;
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-    for (i = 0; i < 85; i++)
-    {
-        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
-        AMQP_VALUE value = amqpvalue_create_null();
-        amqpvalue_set_map_value(source, key, value);
-        amqpvalue_destroy(key);
-        amqpvalue_destroy(value);
-    }
-    for (i = 0; i < 85; i++)
-    {
-        expected_bytes[9 + (i * 3)] = 0x52;
-        expected_bytes[9 + (i * 3) + 1] = i + 1;
-        expected_bytes[9 + (i * 3) + 2] = 0x40;
-    }
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_boolean(decoded_values[0], &actual_value);
+    ASSERT_IS_FALSE(actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_86_key_value_pairs_fails)
+/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
+/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
+TEST_FUNCTION(amqpvalue_decode_boolean_true_succeeds)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
-    int i;
+    // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x56, 0x01 };
+    bool actual_value = false;
+    umock_c_reset_all_calls();
 
-    AMQP_VALUE key = amqpvalue_create_uint(0xFF);
-    AMQP_VALUE value = amqpvalue_create_uint(0xFF);
-    amqpvalue_set_map_value(source, key, value);
-    amqpvalue_destroy(key);
-    amqpvalue_destroy(value);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-    for (i = 1; i < 85; i++)
-    {
-        key = amqpvalue_create_uint(i);
-        value = amqpvalue_create_null();
-        amqpvalue_set_map_value(source, key, value);
-        amqpvalue_destroy(key);
-        amqpvalue_destroy(value);
-    }
-    test_amqpvalue_encode_failure(source);
-}
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
-/* Tests_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>]  */
-/* Tests_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
-/* Tests_SRS_AMQPVALUE_01_124: [Map encodings MUST contain an even number of items (i.e. an equal number of keys and values).] */
-TEST_FUNCTION(amqpvalue_encode_128_key_value_pairs_succeeds)
-{
-    AMQP_VALUE source = amqpvalue_create_map();
-    unsigned char expected_bytes[9 + 384] = { 0xD1, 0x00, 0x00, 0x01, 0x84, 0x00, 0x00, 0x01, 0x00 };
-    unsigned char i;
-    for (i = 0; i < 128; i++)
-    {
-        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
-        AMQP_VALUE value = amqpvalue_create_null();
-        amqpvalue_set_map_value(source, key, value);
-        amqpvalue_destroy(key);
-        amqpvalue_destroy(value);
-    }
-    for (i = 0; i < 128; i++)
-    {
-        expected_bytes[9 + (i * 3)] = 0x52;
-        expected_bytes[9 + (i * 3) + 1] = i + 1;
-        expected_bytes[9 + (i * 3) + 2] = 0x40;
-    }
-    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_stringified);
-    test_amqpvalue_encode(source, expected_stringified);
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_boolean(decoded_values[0], &actual_value);
+    ASSERT_IS_TRUE(actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_encoder_output_fails_amqpvalue_encode_128_key_value_pairs_fails)
+/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
+/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
+TEST_FUNCTION(amqpvalue_decode_boolean_true_byte_by_byte_succeeds)
 {
-    AMQP_VALUE source = amqpvalue_create_map();
+    // arrange
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x56, 0x01 };
     int i;
-    for (i = 0; i < 128; i++)
-    {
-        AMQP_VALUE key = amqpvalue_create_uint(i + 1);
-        AMQP_VALUE value = amqpvalue_create_null();
-        amqpvalue_set_map_value(source, key, value);
-        amqpvalue_destroy(key);
-        amqpvalue_destroy(value);
-    }
-    test_amqpvalue_encode_failure(source);
-}
+    bool actual_value = false;
+    umock_c_reset_all_calls();
 
-/* This test would allocate 4Gb and some people might not like that */
-#if 0
-TEST_FUNCTION(when_encoding_would_result_in_more_than_the_max_size_for_a_map_amqpvalue_encode_fails)
-{
-    AMQP_VALUE source = amqpvalue_create_map();
-    char* very_big_string = (char*)malloc((UINT32_MAX / 4) + 2);
-    AMQP_VALUE some_symbol;
-    AMQP_VALUE key1;
-    AMQP_VALUE key2;
-    AMQP_VALUE key3;
-    AMQP_VALUE key4;
-    int result;
-    (void)memset(very_big_string, 'x', (UINT32_MAX / 4) + 1);
-    very_big_string[(UINT32_MAX / 4) + 1] = '\0';
-    some_symbol = amqpvalue_create_symbol(very_big_string);
-    free(very_big_string);
-    key1 = amqpvalue_create_int(1);
-    key2 = amqpvalue_create_int(2);
-    key3 = amqpvalue_create_int(3);
-    key4 = amqpvalue_create_int(4);
-    (void)amqpvalue_set_map_value(source, key1, some_symbol);
-    (void)amqpvalue_set_map_value(source, key2, some_symbol);
-    (void)amqpvalue_set_map_value(source, key3, some_symbol);
-    (void)amqpvalue_set_map_value(source, key4, some_symbol);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
-    amqpvalue_destroy(key3);
-    amqpvalue_destroy(key4);
-    amqpvalue_destroy(some_symbol);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_encode(source, test_encoder_output, NULL);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_boolean(decoded_values[0], &actual_value);
+    ASSERT_IS_TRUE(actual_value);
 
     // cleanup
-    amqpvalue_destroy(source);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
-#endif
-
-/* amqpvalue_get_encoded_size */
 
-/* Tests_SRS_AMQPVALUE_01_309: [If any argument is NULL, amqpvalue_get_encoded_size shall return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_NULL_value_argument_fails)
+/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_boolean_0x56_only_one_byte_succeeds_but_does_not_trigger_callback)
 {
     // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x56 };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    size_t encoded_size;
-    int result = amqpvalue_get_encoded_size(NULL, &encoded_size);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_309: [If any argument is NULL, amqpvalue_get_encoded_size shall return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_NULL_encoded_size_argument_fails)
+/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
+/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
+TEST_FUNCTION(amqpvalue_decode_boolean_with_0x56_payload_greater_than_1_fails)
 {
     // arrange
     int result;
-    AMQP_VALUE source = amqpvalue_create_null();
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x56, 0x02 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
     // act
-    result = amqpvalue_get_encoded_size(source, NULL);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(source);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-static void test_amqpvalue_get_encoded_size(AMQP_VALUE source, size_t expected_encoded_size)
+/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
+/* Tests_SRS_AMQPVALUE_01_332: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
+TEST_FUNCTION(amqpvalue_decode_0x41_true_boolean_succeeds)
 {
     // arrange
     int result;
-    size_t encoded_size;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x41 };
+    bool actual_value = false;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    result = amqpvalue_get_encoded_size(source, &encoded_size);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(size_t, expected_encoded_size, encoded_size);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_boolean(decoded_values[0], &actual_value);
+    ASSERT_IS_TRUE(actual_value);
 
     // cleanup
-    amqpvalue_destroy(source);
-}
-
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_264: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_null_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_null();
-    test_amqpvalue_get_encoded_size(source, 1);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_272: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_true_bool_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
+/* Tests_SRS_AMQPVALUE_01_333: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
+TEST_FUNCTION(amqpvalue_decode_0x42_false_boolean_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_boolean(true);
-    test_amqpvalue_get_encoded_size(source, 1);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x42 };
+    bool actual_value = true;
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_273: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_false_bool_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_boolean(false);
-    test_amqpvalue_get_encoded_size(source, 1);
-}
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_ubyte_0x0_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_ubyte(0x0);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_275: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_ubyte_0xFF_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_ubyte(0xFF);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_boolean(decoded_values[0], &actual_value);
+    ASSERT_IS_FALSE(actual_value);
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_ushort_0x0_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_ushort(0x0);
-    test_amqpvalue_get_encoded_size(source, 3);
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_276: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_ushort_0xFFFF_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_335: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_ubyte_0x00_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_ushort(0xFFFF);
-    test_amqpvalue_get_encoded_size(source, 3);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x50, 0x00 };
+    unsigned char actual_value = 1;
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_277: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_uint_0xFFFFFFFF_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_uint(0xFFFFFFFF);
-    test_amqpvalue_get_encoded_size(source, 5);
-}
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_278: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_uint_0xFF_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_uint(0xFF);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_279: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_uint_0x0_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_uint(0x0);
-    test_amqpvalue_get_encoded_size(source, 1);
-}
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ubyte(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint8_t, 0, actual_value);
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_280: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_ulong_0xFFFFFFFFFFFFFFFF_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_ulong(0xFFFFFFFFFFFFFFFF);
-    test_amqpvalue_get_encoded_size(source, 9);
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_281: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_ulong_0xFF_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_335: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_ubyte_0xFF_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_ulong(0xFF);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x50, 0xFF };
+    unsigned char actual_value = 0;
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_282: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_ulong_0x0_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_ulong(0x0);
-    test_amqpvalue_get_encoded_size(source, 1);
-}
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_byte_minus_128_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_byte(-128);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_283: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_byte_127_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_byte(127);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ubyte(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint8_t, 0xFF, actual_value);
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_284: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_short_minus_32768_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_short(-32768);
-    test_amqpvalue_get_encoded_size(source, 3);
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_2147483647_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_335: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_ubyte_0xFF_given_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_int(2147483647);
-    test_amqpvalue_get_encoded_size(source, 5);
-}
+    unsigned char actual_value = 0;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x50, 0xFF };
+    int i;
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_285: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_minus_2147483648_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_int(-2147483647-1);
-    test_amqpvalue_get_encoded_size(source, 5);
-}
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_127_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_int(127);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // act
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_286: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_int_minus_128_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_int(-128);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ubyte(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint8_t, 0xFF, actual_value);
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_9223372036854775807_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_long(9223372036854775807LL);
-    test_amqpvalue_get_encoded_size(source, 9);
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_287: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_minus_9223372036854775808_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_ubyte_with_only_one_byte_succeds_but_no_callback_triggered)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_long(-9223372036854775807LL - 1);
-    test_amqpvalue_get_encoded_size(source, 9);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x50 };
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_127_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_long(127);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_288: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_long_minus_128_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_long(-128);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_timestamp_9223372036854775807_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_timestamp(9223372036854775807LL);
-    test_amqpvalue_get_encoded_size(source, 9);
-}
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_295: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_timestamp_minus_9223372036854775808_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_timestamp(-9223372036854775807LL - 1);
-    test_amqpvalue_get_encoded_size(source, 9);
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_296: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_uuid_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_336: [1.6.4 ushort Integer in the range 0 to 216 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_337: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_ushort_0x0_succeeds)
 {
     // arrange
-    uuid uuid = { 0 };
-    AMQP_VALUE source = amqpvalue_create_uuid(uuid);
-    test_amqpvalue_get_encoded_size(source, 17);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x60, 0x0, 0x0 };
+    uint16_t actual_value = 1;
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>]  */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_zero_length_value_succeeds)
-{
-    // arrange
-    amqp_binary binary = { NULL, 0 };
-    AMQP_VALUE source = amqpvalue_create_binary(binary);
-    test_amqpvalue_get_encoded_size(source, 2);
-}
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_1_length_value_succeeds)
-{
-    // arrange
-    unsigned char bytes[] = { 0x42 };
-    amqp_binary binary;
-    AMQP_VALUE source;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    test_amqpvalue_get_encoded_size(source, 3);
-}
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_297: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_255_length_value_succeeds)
-{
-    // arrange
-    unsigned char bytes[255] = { 0x42 };
-    amqp_binary binary;
-    AMQP_VALUE source;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    test_amqpvalue_get_encoded_size(source, 257);
-}
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_USHORT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ushort(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0, (uint32_t)actual_value);
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_298: [<encoding name="vbin32" code="0xb0" category="variable" width="4" label="up to 2^32 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_binary_256_length_value_succeeds)
-{
-    // arrange
-    unsigned char bytes[256] = { 0x42 };
-    amqp_binary binary;
-    AMQP_VALUE source;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    source = amqpvalue_create_binary(binary);
-    test_amqpvalue_get_encoded_size(source, 261);
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_0_length_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_336: [1.6.4 ushort Integer in the range 0 to 216 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_337: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_string("");
-    test_amqpvalue_get_encoded_size(source, 2);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x60, 0xFF, 0xFF };
+    uint16_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_USHORT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ushort(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFFFF, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_1_length_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_336: [1.6.4 ushort Integer in the range 0 to 216 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_337: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_string("a");
-    test_amqpvalue_get_encoded_size(source, 3);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x60, 0xFF, 0xFF };
+    int i;
+    uint16_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_USHORT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ushort(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFFFF, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_299: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_255_chars_length_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_insufficient_bytes_does_not_trigger_callback)
 {
     // arrange
-    char string[256];
-    AMQP_VALUE source;
-    memset(string, 'a', 255);
-    string[255] = 0;
-    source = amqpvalue_create_string(string);
-    test_amqpvalue_get_encoded_size(source, 257);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x60, 0xFF };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_300: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_string_256_chars_length_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_339: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x0_succeeds)
 {
     // arrange
-    char string[257];
-    AMQP_VALUE source;
-    (void)memset(string, 'a', 256);
-    string[256] = 0;
-    source = amqpvalue_create_string(string);
-    test_amqpvalue_get_encoded_size(source, 261);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x70, 0x0, 0x0, 0x0, 0x0 };
+    uint32_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_303: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_empty_list_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_339: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_list();
-    test_amqpvalue_get_encoded_size(source, 1);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x70, 0x42, 0x43, 0x44, 0x45 };
+    uint32_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0x42434445, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_1_item_succeeds)
+/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_339: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 4);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x70, 0x42, 0x43, 0x44, 0x45 };
+    int i;
+    uint32_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0x42434445, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_2_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_insufficient_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(source, 0, item);
-    (void)amqpvalue_set_list_item(source, 1, item);
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 5);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x70, 0x42, 0x43, 0x44 };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_1_string_item_with_5_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_340: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0x0_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_string("fluff");
-    (void)amqpvalue_set_list_item(source, 0, item);
-    amqpvalue_destroy(item);
-    /* 1 - list descriptor +
-        1 - list size
-        1 - list item count
-        1 - string descriptor
-        1 - string length
-        5 - string chars */
-    test_amqpvalue_get_encoded_size(source, 10);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x52, 0x0 };
+    uint32_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_304: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_254_null_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_340: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0xFF_succeeds)
 {
     // arrange
-    uint32_t i;
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    for (i = 0; i < 254; i++)
-    {
-        (void)amqpvalue_set_list_item(source, i, item);
-    }
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 257);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x52, 0xFF };
+    uint32_t actual_value = 1;
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_305: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_list_value_with_255_null_items_succeeds)
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFF, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+}
+
+/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_340: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0xFF_byte_by_byte_succeeds)
 {
     // arrange
-    uint32_t i;
-    AMQP_VALUE source = amqpvalue_create_list();
-    AMQP_VALUE item = amqpvalue_create_null();
-    for (i = 0; i < 255; i++)
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x52, 0xFF };
+    int i;
+    uint32_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
+    // act
+    for (i = 0; i < sizeof(bytes); i++)
     {
-        (void)amqpvalue_set_list_item(source, i, item);
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
     }
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 264);
-}
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_empty_map_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_map();
-    test_amqpvalue_get_encoded_size(source, 3);
-}
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFF, (uint32_t)actual_value);
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_1_null_key_and_value_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE item = amqpvalue_create_null();
-    amqpvalue_set_map_value(source, item, item);
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 5);
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_2_keys_and_values_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x52_only_one_byte_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE key1 = amqpvalue_create_uint(1);
-    AMQP_VALUE key2 = amqpvalue_create_uint(2);
-    AMQP_VALUE item = amqpvalue_create_null();
-    amqpvalue_set_map_value(source, key1, item);
-    amqpvalue_set_map_value(source, key2, item);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 9);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x52 };
+    umock_c_reset_all_calls();
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_306: [<encoding name="map8" code="0xc1" category="compound" width="1" label="up to 2^8 - 1 octets of encoded map data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_1_key_and_value_254_bytes_succeeds)
-{
-    // arrange
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE key1 = amqpvalue_create_null();
-    char string[252];
-    AMQP_VALUE item;
-    memset(string, 'a', 251);
-    string[251] = 0;
-    item = amqpvalue_create_string(string);
-    amqpvalue_set_map_value(source, key1, item);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 257);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_308: [amqpvalue_get_encoded_size shall fill in the encoded_size argument the number of bytes required to encode the given AMQP value.] */
-/* Tests_SRS_AMQPVALUE_01_307: [<encoding name="map32" code="0xd1" category="compound" width="4" label="up to 2^32 - 1 octets of encoded map data"/>] */
-TEST_FUNCTION(amqpvalue_get_encoded_size_with_map_value_with_1_key_and_value_256_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_341: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x43_value_0xFF_succeeds)
 {
     // arrange
-    AMQP_VALUE source = amqpvalue_create_map();
-    AMQP_VALUE key1 = amqpvalue_create_null();
-    char string[254];
-    AMQP_VALUE item;
-    memset(string, 'a', 253);
-    string[253] = 0;
-    item = amqpvalue_create_string(string);
-    amqpvalue_set_map_value(source, key1, item);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(item);
-    test_amqpvalue_get_encoded_size(source, 265);
-}
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x43 };
+    uint32_t actual_value = 1;
+    umock_c_reset_all_calls();
 
-/* amqpvalue_destroy */
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-/* Tests_SRS_AMQPVALUE_01_315: [If the value argument is NULL, amqpvalue_destroy shall do nothing.] */
-TEST_FUNCTION(amqpvalue_decoder_destroy_with_NULL_does_nothing)
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0x0, (uint32_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+}
+
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_343: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x0_succeeds)
 {
     // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x80, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
+    uint64_t actual_value = 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(NULL);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ulong(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, 0x0, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_null_value)
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_343: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x4243444546474849_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_null();
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x80, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49 };
+    uint64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ulong(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, 0x4243444546474849, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ubyte_value)
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_343: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x4243444546474849_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ubyte(0);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x80, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49 };
+    int i;
+    uint64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ulong(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, 0x4243444546474849, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ushort_value)
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0x0_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ushort(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x53, 0x0 };
+    uint64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ulong(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, 0, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uint_value)
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0xFF_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_uint(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x53, 0xFF };
+    uint64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ulong(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, 0xFF, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ulong_value)
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0xFF_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ulong(0);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x53, 0xFF };
+    int i;
+    uint64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ulong(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, 0xFF, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_byte_value)
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x53_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_byte(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x53 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_short_value)
+/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_345: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
+TEST_FUNCTION(amqpvalue_decode_uint_0x44_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_short(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x44 };
+    uint64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_ulong(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, 0, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_int_value)
+/* Tests_SRS_AMQPVALUE_01_346: [1.6.7 byte Integer in the range -(27) to 27 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_347: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_byte_minus_128_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_int(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x51, 0x80 };
+    char actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BYTE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_byte(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char, -128, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_long_value)
+/* Tests_SRS_AMQPVALUE_01_346: [1.6.7 byte Integer in the range -(27) to 27 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_347: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_byte_127_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_long(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x51, 0x7F };
+    char actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BYTE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_byte(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char, 127, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_float_value)
+/* Tests_SRS_AMQPVALUE_01_346: [1.6.7 byte Integer in the range -(27) to 27 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_347: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_byte_127_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_float(0);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x51, 0x7F };
+    int i;
+    char actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BYTE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_byte(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char, 127, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_double_value)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_byte_127_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_double(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x51 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_char_value)
+/* Tests_SRS_AMQPVALUE_01_348: [1.6.8 short Integer in the range -(215) to 215 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_349: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_byte_minus_32768_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_char(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x61, 0x80, 0x00 };
+    int16_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SHORT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_short(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int16_t, -32768, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_timestamp_value)
+/* Tests_SRS_AMQPVALUE_01_348: [1.6.8 short Integer in the range -(215) to 215 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_349: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_byte_32767_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_timestamp(0);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x61, 0x7F, 0xFF };
+    int16_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SHORT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_short(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int16_t, 32767, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uuid_value)
+/* Tests_SRS_AMQPVALUE_01_348: [1.6.8 short Integer in the range -(215) to 215 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_349: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_byte_32767_byte_by_byte_succeeds)
 {
     // arrange
-    uuid uuid = { 0 };
-    AMQP_VALUE value = amqpvalue_create_uuid(uuid);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x61, 0x7F, 0xFF };
+    int i;
+    int16_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SHORT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_short(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int16_t, 32767, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_binary_value)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_short_32767_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    unsigned char bytes[] = { 0x42 };
-    amqp_binary binary;
-    AMQP_VALUE value;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    value = amqpvalue_create_binary(binary);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x61, 0x7F };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_string_value)
+/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_351: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_int_minus_2147483648_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_string("test");
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x71, 0x80, 0x00, 0x00, 0x00 };
+    int32_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_int(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int32_t, -2147483647-1, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_symbol_value)
+/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_351: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_int_2147483647_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_symbol("test");
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x71, 0x7F, 0xFF, 0xFF, 0xFF };
+    int32_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_int(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int32_t, 2147483647, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_list_value)
+/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_351: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_int_2147483647_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x71, 0x7F, 0xFF, 0xFF, 0xFF };
+    int i;
+    int32_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_int(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int32_t, 2147483647, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_value_with_1_null_item)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_int_2147483647_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(value, 0, null_value);
-    amqpvalue_destroy(null_value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x71, 0x7F, 0xFF, 0xFF };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_value_with_2_null_items)
+/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_352: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_int_0x54_value_minus_128_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_list_item(value, 0, null_value);
-    (void)amqpvalue_set_list_item(value, 1, null_value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x54, 0x80 };
+    int32_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_int(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int32_t, -128, actual_value);
 
     // cleanup
-    amqpvalue_destroy(null_value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_map_value)
+/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_352: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_int_0x54_value_127_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x54, 0x7F };
+    int32_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_int(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int32_t, 127, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_value_with_1_key_value_pair)
+/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_352: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_int_0x54_value_127_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_map_value(value, null_value, null_value);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x54, 0x7F };
+    int i;
+    int32_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_int(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(int32_t, 127, actual_value);
 
     // cleanup
-    amqpvalue_destroy(null_value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_value_with_2_key_value_pairs)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_int_0x54_value_127_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE key1 = amqpvalue_create_ubyte(1);
-    AMQP_VALUE key2 = amqpvalue_create_uint(2);
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    (void)amqpvalue_set_map_value(value, key1, null_value);
-    (void)amqpvalue_set_map_value(value, key2, null_value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x54 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
-    amqpvalue_destroy(null_value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_null_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_354: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_long_minus_9223372036854775808_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x81, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_long(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(-9223372036854775807LL - 1), (uint64_t)actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_null_cloned_value_when_last_reference)
+/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_354: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_long_9223372036854775807_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x81, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_long(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ubyte_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_354: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
+TEST_FUNCTION(amqpvalue_decode_long_9223372036854775807_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ubyte(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x81, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    int i;
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_long(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ubyte_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_long_9223372036854775807_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ubyte(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x81, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ushort_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_355: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_long_0x55_value_minus_128_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ushort(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x55, 0x80 };
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_long(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(-128), (uint64_t)actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ushort_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_355: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_long_0x55_value_127_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ushort(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x55, 0x7F };
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_long(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)127, (uint64_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uint_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
+/* Tests_SRS_AMQPVALUE_01_355: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
+TEST_FUNCTION(amqpvalue_decode_long_0x55_value_127_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_uint(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x55, 0x7F };
+    int i;
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_long(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)127, (uint64_t)actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uint_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_long_0x55_value_127_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_uint(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x55 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ulong_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_019: [1.6.11 float 32-bit floating point number (IEEE 754-2008 binary32).]*/
+/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>]*/
+TEST_FUNCTION(amqpvalue_decode_float_minus_1_0_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ulong(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x72, 0xBF, 0x80, 0x00, 0x00 };
+    float actual_value = 0.0;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_FLOAT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_float(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(float, (float)-1.0, actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_ulong_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>]*/
+TEST_FUNCTION(amqpvalue_decode_float_42_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_ulong(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x82, 0x40, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    double actual_value = 0.0;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_DOUBLE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_double(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(double, (double)42.0, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_byte_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_double_42_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_byte(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x82, 0x40, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_byte_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_020: [1.6.12 double 64-bit floating point number (IEEE 754-2008 binary64).]*/
+/* Tests_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>]*/
+TEST_FUNCTION(amqpvalue_decode_double_minus_1_0_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_byte(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x82, 0xBF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    double actual_value = 0.0;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_DOUBLE, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_double(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(double, (double)-1.0, actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_short_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>]*/
+TEST_FUNCTION(amqpvalue_decode_double_42_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_short(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x72, 0x42, 0x28, 0x00, 0x00 };
+    float actual_value = 0.0;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_FLOAT, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_float(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(float, (float)42.0, actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_short_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_float_42_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_short(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x72, 0x42, 0x28, 0x00 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_int_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_368: [1.6.17 timestamp An absolute point in time.] */
+/* Tests_SRS_AMQPVALUE_01_369: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_decode_timestamp_value_minus_9223372036854775808_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_int(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x83, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_TIMESTAMP, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_timestamp(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(-9223372036854775807LL-1), (uint64_t)actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_int_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_368: [1.6.17 timestamp An absolute point in time.] */
+/* Tests_SRS_AMQPVALUE_01_369: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_decode_timestamp_value_9223372036854775807_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_int(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    int64_t actual_value = 1;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x83, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_TIMESTAMP, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_timestamp(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_long_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_368: [1.6.17 timestamp An absolute point in time.] */
+/* Tests_SRS_AMQPVALUE_01_369: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
+TEST_FUNCTION(amqpvalue_decode_timestamp_value_9223372036854775807_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_long(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x83, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    int i;
+    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_TIMESTAMP, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_timestamp(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_long_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_timestamp_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_long(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x83, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_float_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_370: [1.6.18 uuid A universally unique identifier as defined by RFC-4122 section 4.1.2 .] */
+/* Tests_SRS_AMQPVALUE_01_371: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
+TEST_FUNCTION(amqpvalue_decode_uuid_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_float(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x98, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
+    uuid expected_uuid = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
+    uuid actual_value = { 0 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UUID, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uuid(decoded_values[0], &actual_value);
+    stringify_bytes(actual_value, sizeof(actual_value), actual_stringified);
+    stringify_bytes(expected_uuid, sizeof(expected_uuid), expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_float_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_370: [1.6.18 uuid A universally unique identifier as defined by RFC-4122 section 4.1.2 .] */
+/* Tests_SRS_AMQPVALUE_01_371: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
+TEST_FUNCTION(amqpvalue_decode_uuid_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_float(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x98, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
+    uuid expected_uuid = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
+    int i;
+    uuid actual_value = { 0 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UUID, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_uuid(decoded_values[0], &actual_value);
+    stringify_bytes(actual_value, sizeof(actual_value), actual_stringified);
+    stringify_bytes(expected_uuid, sizeof(expected_uuid), expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_double_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_uuid_not_enough_bytes_does_not_trigger_a_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_double(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0x98, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_double_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
+/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_decode_binary_zero_size_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_double(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA0, 0x00 };
+    amqp_binary actual_value = { NULL, 0 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_binary(decoded_values[0], &actual_value);
+    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
+    stringify_bytes(bytes, 0, expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_char_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
+/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_decode_binary_one_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_char(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA0, 0x01, 0x42 };
+    amqp_binary actual_value = { NULL, 0 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_binary(decoded_values[0], &actual_value);
+    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
+    stringify_bytes(&bytes[2], sizeof(bytes) - 2, expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_char_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
+/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_decode_binary_255_bytes_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_char(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[255 + 2] = { 0xA0, 0xFF };
+    unsigned int i;
+    amqp_binary actual_value = { NULL, 0 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    for (i = 0; i < 255; i++)
+    {
+        bytes[2 + i] = (unsigned char)i;
+    }
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_binary(decoded_values[0], &actual_value);
+    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
+    stringify_bytes(&bytes[2], sizeof(bytes) - 2, expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_timestamp_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
+/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_decode_binary_255_bytes_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_timestamp(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[255 + 2] = { 0xA0, 0xFF };
+    unsigned int i;
+    amqp_binary actual_value = { NULL, 0 };
     umock_c_reset_all_calls();
 
+    for (i = 0; i < 255; i++)
+    {
+        bytes[2 + i] = (unsigned char)i;
+    }
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_binary(decoded_values[0], &actual_value);
+    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
+    stringify_bytes(&bytes[2], sizeof(bytes) - 2, expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_timestamp_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_binary_zero_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_timestamp(0);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA0 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uuid_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_binary_one_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    uuid uuid = { 0 };
-    AMQP_VALUE value = amqpvalue_create_uuid(uuid);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA0, 0x01 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_uuid_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_allocating_memory_fails_then_amqpvalue_decode_binary_one_byte_fails)
 {
     // arrange
-    uuid uuid = { 0 };
-    AMQP_VALUE value = amqpvalue_create_uuid(uuid);
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA0, 0x01, 0x42 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_binary_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_binary_255_bytes_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    unsigned char bytes[] = { 0x42 };
-    amqp_binary binary;
-    AMQP_VALUE value;
-    AMQP_VALUE cloned_value;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    value = amqpvalue_create_binary(binary);
-    cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[254 + 2] = { 0xA0, 0xFF };
+    unsigned int i;
     umock_c_reset_all_calls();
 
+    for (i = 0; i < 254; i++)
+    {
+        bytes[2 + i] = (unsigned char)i;
+    }
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_binary_cloned_value_last_Reference)
+/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
+/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_zero_bytes_succeeds)
 {
     // arrange
-    unsigned char bytes[] = { 0x42 };
-    amqp_binary binary;
-    AMQP_VALUE value;
-    AMQP_VALUE cloned_value;
-    binary.bytes = &bytes;
-    binary.length = sizeof(bytes);
-    value = amqpvalue_create_binary(binary);
-    cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x00 };
+    amqp_binary actual_value = { NULL, 0 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_binary(decoded_values[0], &actual_value);
+    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
+    stringify_bytes(&bytes[0], 0, expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_string_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
+/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_1_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_string("test");
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x01, 0x42 };
+    amqp_binary actual_value = { NULL, 0 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_binary(decoded_values[0], &actual_value);
+    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
+    stringify_bytes(&bytes[5], sizeof(bytes) - 5, expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_string_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
+/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
+TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_256_bytes_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_string("test");
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[256 + 5] = { 0xB0, 0x00, 0x00, 0x01, 0x00 };
+    int i;
+    amqp_binary actual_value = { NULL, 0 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    for (i = 0; i < 256; i++)
+    {
+        bytes[5 + i] = i & 0xFF;
+    }
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
+    amqpvalue_get_binary(decoded_values[0], &actual_value);
+    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
+    stringify_bytes(&bytes[5], sizeof(bytes) - 5, expected_stringified);
+    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_list_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_binary_0xB0_zero_bytes_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB0 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_list_cloned_value_last_Reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_binary_0xB0_1_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x01 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_1_null_item)
+/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_allocating_fails_then_amqpvalue_decode_binary_0xB0_1_byte_fails)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_list_item(value, 0, null_value);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x01, 0x42 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_1_null_item_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_binary_0xB0_256_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_list_item(value, 0, null_value);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[255 + 5] = { 0xB0, 0x00, 0x00, 0x01, 0x00 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_2_null_items)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_zero_bytes_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_list_item(value, 0, null_value);
-    (void)amqpvalue_set_list_item(value, 1, null_value);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA1, 0x00 };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_list_cloned_value_with_2_null_items_last_reference)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_1_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_list();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_list_item(value, 0, null_value);
-    (void)amqpvalue_set_list_item(value, 1, null_value);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA1, 0x01, 'a' };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_map_cloned_value)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_255_bytes_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[255 + 2] = { 0xA1, 0xFF, 'x' };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
+    (void)memset(bytes + 2, 'x', 255);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_empty_map_cloned_value_last_reference)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_2_bytes_byte_by_byte_succeeds)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA1, 0x02, 'a', 'b' };
+    int i;
+    const char* actual_value;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    amqpvalue_destroy(cloned_value);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_1_key_value_pair)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_string_0xA1_zero_bytes_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_map_value(value, null_value, null_value);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA1 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_1_key_value_pair_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_string_0xA1_one_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_map_value(value, null_value, null_value);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA1, 0x01 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_2_key_value_pairs)
+/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_allocating_memory_fails_amqpvalue_decode_string_0xA1_one_byte_fails)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE key1 = amqpvalue_create_ubyte(1);
-    AMQP_VALUE key2 = amqpvalue_create_uint(2);
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_map_value(value, key1, null_value);
-    (void)amqpvalue_set_map_value(value, key2, null_value);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA1, 0x01, 'a' };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_destroy(value);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
-/* Tests_SRS_AMQPVALUE_01_403: [ Cloning should be done by reference counting. ]*/
-TEST_FUNCTION(amqpvalue_destroy_frees_the_memory_for_map_cloned_value_with_2_key_value_pairs_last_reference)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_string_0xA1_255_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    AMQP_VALUE value = amqpvalue_create_map();
-    AMQP_VALUE key1 = amqpvalue_create_ubyte(1);
-    AMQP_VALUE key2 = amqpvalue_create_uint(2);
-    AMQP_VALUE null_value = amqpvalue_create_null();
-    AMQP_VALUE cloned_value;
-    (void)amqpvalue_set_map_value(value, key1, null_value);
-    (void)amqpvalue_set_map_value(value, key2, null_value);
-    amqpvalue_destroy(key1);
-    amqpvalue_destroy(key2);
-    amqpvalue_destroy(null_value);
-    cloned_value = amqpvalue_clone(value);
-    amqpvalue_destroy(value);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[254 + 2] = { 0xA1, 0xFF, 'x' };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    (void)memset(bytes + 2, 'x', 254);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_destroy(cloned_value);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-}
 
-/* amqpvalue_decoder_create */
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+}
 
-/* Tests_SRS_AMQPVALUE_01_311: [amqpvalue_decoder_create shall create a new amqp value decoder and return a non-NULL handle to it.] */
-TEST_FUNCTION(amqpvalue_decoder_create_returns_a_non_NULL_handle)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_zero_bytes_succeeds)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE result;
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x00 };
+    const char* actual_value;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(result);
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_312: [If the value_decoded_callback argument is NULL, amqpvalue_decoder_create shall return NULL.] */
-TEST_FUNCTION(amqpvalue_decoder_create_with_NULL_callback_returns_NULL)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_1_byte_succeeds)
 {
     // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x01, 'a' };
+    const char* actual_value;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    AMQPVALUE_DECODER_HANDLE result = amqpvalue_decoder_create(NULL, test_context);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
-TEST_FUNCTION(when_allocating_the_decoder_fails_amqpvalue_decoder_create_fails)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_255_bytes_succeeds)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE result;
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[255 + 5] = { 0xB1, 0x00, 0x00, 0x00, 0xFF, 'x' };
+    const char* actual_value;
+    umock_c_reset_all_calls();
+
+    (void)memset(bytes + 5, 'x', 255);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
-TEST_FUNCTION(when_allocating_the_initial_decode_value_fails_amqpvalue_decoder_create_fails)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_256_bytes_succeeds)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE result;
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[256 + 5] = { 0xB1, 0x00, 0x00, 0x01, 0x00, 'x' };
+    const char* actual_value;
+    umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    (void)memset(bytes + 5, 'x', 256);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxx", actual_value);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
-TEST_FUNCTION(when_allocating_memoory_fails_amqpvalue_decoder_create_fails)
+/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
+/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_2_bytes_byte_by_byte_succeeds)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE result;
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x02, 'a', 'b' };
+    int i;
+    const char* actual_value;
+    umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_IS_NULL(result);
-}
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
 
-/* amqpvalue_decoder_destroy */
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+}
 
-/* Tests_SRS_AMQPVALUE_01_316: [amqpvalue_decoder_destroy shall free all resources associated with the amqpvalue_decoder.] */
-TEST_FUNCTION(amqpvalue_destroy_frees_underlying_allocated_chunks)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_zero_bytes_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB1 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_317: [If handle is NULL, amqpvalue_decoder_destroy shall do nothing.] */
-TEST_FUNCTION(amqpvalue_destroy_with_NULL_handle_does_not_free_anything)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_one_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x01 };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    amqpvalue_decoder_destroy(NULL);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-}
 
-/* amqpvalue_decode_bytes */
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+}
 
-/* Tests_SRS_AMQPVALUE_01_320: [If handle or buffer are NULL, amqpvalue_decode_bytes shall return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_decode_bytes_with_NULL_handle_fails)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_string_0xB1_255_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
-    unsigned char bytes[] = { 0x40 };
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[255 + 5] = { 0xB1, 0x00, 0x00, 0x01, 0x00, 'x' };
+    umock_c_reset_all_calls();
+
+    (void)memset(bytes + 5, 'x', 255);
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    
     // act
-    int result = amqpvalue_decode_bytes(NULL, bytes, sizeof(bytes));
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_320: [If handle or buffer are NULL, amqpvalue_decode_bytes shall return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_decode_bytes_with_NULL_buffer_fails)
+/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_gballoc_malloc_fails_then_amqpvalue_decode_string_0xB1_one_byte_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x01, 'a' };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, NULL, 1);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -10538,43 +15817,50 @@ TEST_FUNCTION(amqpvalue_decode_bytes_with_NULL_buffer_fails)
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_321: [If size is 0, amqpvalue_decode_bytes shall return a non-zero value.] */
-TEST_FUNCTION(amqpvalue_decode_bytes_with_0_size_fails)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_zero_chars_succeeds)
 {
     // arrange
     int result;
-    unsigned char bytes[] = { 0x40 };
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA3, 0x00 };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, 0);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_318: [amqpvalue_decode_bytes shall decode size bytes that are passed in the buffer argument.] */
-/* Tests_SRS_AMQPVALUE_01_319: [On success, amqpvalue_decode_bytes shall return 0.] */
-/* Tests_SRS_AMQPVALUE_01_322: [amqpvalue_decode_bytes shall process the bytes byte by byte, as a stream.] */
-/* Tests_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the value_decoded_callback passed in amqpvalue_decoder_create shall be called.] */
-/* Tests_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to value_decoded_callback.] */
-/* Tests_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the value_decoded_callback callback.] */
-/* Tests_SRS_AMQPVALUE_01_328: [1.6.1 null Indicates an empty value.] */
-/* Tests_SRS_AMQPVALUE_01_329: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
-TEST_FUNCTION(amqpvalue_decode_1_amqp_null_value_succeeds)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_1_char_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x40 };
+    unsigned char bytes[] = { 0xA3, 0x01, 'a' };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
@@ -10585,33 +15871,32 @@ TEST_FUNCTION(amqpvalue_decode_1_amqp_null_value_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(decoded_values[0]));
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_318: [amqpvalue_decode_bytes shall decode size bytes that are passed in the buffer argument.] */
-/* Tests_SRS_AMQPVALUE_01_319: [On success, amqpvalue_decode_bytes shall return 0.] */
-/* Tests_SRS_AMQPVALUE_01_322: [amqpvalue_decode_bytes shall process the bytes byte by byte, as a stream.] */
-/* Tests_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the value_decoded_callback passed in amqpvalue_decoder_create shall be called.] */
-/* Tests_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to value_decoded_callback.] */
-/* Tests_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the value_decoded_callback callback.] */
-/* Tests_SRS_AMQPVALUE_01_328: [1.6.1 null Indicates an empty value.] */
-/* Tests_SRS_AMQPVALUE_01_329: [<encoding code="0x40" category="fixed" width="0" label="the null value"/>] */
-TEST_FUNCTION(amqpvalue_decode_2_amqp_null_values_succeeds)
+/* Tests_SRS_AMQPVALUE_01_458: [ A decoded symbol that is one of the well-known symbols in the interned symbol table shall point to the table entry instead of copying the characters. ]*/
+TEST_FUNCTION(amqpvalue_decode_a_well_known_symbol_shares_the_interned_chars)
 {
     // arrange
     int result;
-    unsigned char bytes[] = { 0x40, 0x40 };
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA3, 0x0C, 'x', '-', 'o', 'p', 't', '-', 'o', 'f', 'f', 's', 'e', 't' };
+    AMQP_VALUE expected_value = amqpvalue_create_symbol("x-opt-offset");
+    const char* expected_chars;
+    const char* actual_value;
+    (void)amqpvalue_get_symbol(expected_value, &expected_chars);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -10619,22 +15904,25 @@ TEST_FUNCTION(amqpvalue_decode_2_amqp_null_values_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(decoded_values[0]));
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(decoded_values[1]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)expected_chars, (void*)actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(expected_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
-/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
-TEST_FUNCTION(amqpvalue_decode_boolean_false_succeeds)
+/* Tests_SRS_AMQPVALUE_01_458: [ A decoded symbol that is one of the well-known symbols in the interned symbol table shall point to the table entry instead of copying the characters. ]*/
+TEST_FUNCTION(amqpvalue_decode_a_symbol_with_a_NUL_after_a_well_known_symbol_is_not_interned)
 {
     // arrange
     int result;
-    unsigned char bytes[] = { 0x56, 0x00 };
-    bool actual_value = true;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[] = { 0xA3, 0x0E, 'x', '-', 'o', 'p', 't', '-', 'o', 'f', 'f', 's', 'e', 't', 0x00, 'x' };
+    AMQP_VALUE expected_value = amqpvalue_create_symbol("x-opt-offset");
+    const char* expected_chars;
+    const char* actual_value;
+    (void)amqpvalue_get_symbol(expected_value, &expected_chars);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -10649,25 +15937,27 @@ TEST_FUNCTION(amqpvalue_decode_boolean_false_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_boolean(decoded_values[0], &actual_value);
-    ASSERT_IS_FALSE(actual_value);
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)expected_chars, (void*)actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(expected_value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
-/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
-TEST_FUNCTION(amqpvalue_decode_boolean_true_succeeds)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_255_chars_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x56, 0x01 };
-    bool actual_value = false;
+    unsigned char bytes[255 + 2] = { 0xA3, 0xFF, 'x' };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
+    (void)memset(bytes + 2, 'x', 255);
+
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
@@ -10680,23 +15970,25 @@ TEST_FUNCTION(amqpvalue_decode_boolean_true_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_boolean(decoded_values[0], &actual_value);
-    ASSERT_IS_TRUE(actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
-/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
-TEST_FUNCTION(amqpvalue_decode_boolean_true_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_2_chars_byte_by_byte_succeeds)
 {
     // arrange
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x56, 0x01 };
+    unsigned char bytes[] = { 0xA3, 0x02, 'a', 'b' };
     int i;
-    bool actual_value = false;
+    const char* actual_value;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -10714,22 +16006,21 @@ TEST_FUNCTION(amqpvalue_decode_boolean_true_byte_by_byte_succeeds)
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_boolean(decoded_values[0], &actual_value);
-    ASSERT_IS_TRUE(actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
 /* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_boolean_0x56_only_one_byte_succeeds_but_does_not_trigger_callback)
+TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_zero_bytes_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x56 };
+    unsigned char bytes[] = { 0xA3 };
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -10748,14 +16039,13 @@ TEST_FUNCTION(amqpvalue_decode_boolean_0x56_only_one_byte_succeeds_but_does_not_
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
-/* Tests_SRS_AMQPVALUE_01_331: [<encoding code="0x56" category="fixed" width="1" label="boolean with the octet 0x00 being false and octet 0x01 being true"/>] */
-TEST_FUNCTION(amqpvalue_decode_boolean_with_0x56_payload_greater_than_1_fails)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_one_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x56, 0x02 };
+    unsigned char bytes[] = { 0xA3, 0x01 };
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -10767,58 +16057,53 @@ TEST_FUNCTION(amqpvalue_decode_boolean_with_0x56_payload_greater_than_1_fails)
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
-/* Tests_SRS_AMQPVALUE_01_332: [<encoding name="true" code="0x41" category="fixed" width="0" label="the boolean value true"/>] */
-TEST_FUNCTION(amqpvalue_decode_0x41_true_boolean_succeeds)
+/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_allocating_memory_fails_amqpvalue_decode_symbol_0xA3_one_byte_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x41 };
-    bool actual_value = false;
+    unsigned char bytes[] = { 0xA3, 0x01, 'a' };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_boolean(decoded_values[0], &actual_value);
-    ASSERT_IS_TRUE(actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_330: [1.6.2 boolean Represents a true or false value.] */
-/* Tests_SRS_AMQPVALUE_01_333: [<encoding name="false" code="0x42" category="fixed" width="0" label="the boolean value false"/>] */
-TEST_FUNCTION(amqpvalue_decode_0x42_false_boolean_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_255_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x42 };
-    bool actual_value = true;
+    unsigned char bytes[254 + 2] = { 0xA3, 0xFF, 'x' };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    (void)memset(bytes + 2, 'x', 254);
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -10826,23 +16111,20 @@ TEST_FUNCTION(amqpvalue_decode_0x42_false_boolean_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_boolean(decoded_values[0], &actual_value);
-    ASSERT_IS_FALSE(actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_335: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_ubyte_0x00_succeeds)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_zero_chars_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x50, 0x00 };
-    unsigned char actual_value = 1;
+    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x00 };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -10857,23 +16139,23 @@ TEST_FUNCTION(amqpvalue_decode_ubyte_0x00_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ubyte(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint8_t, 0, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_335: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_ubyte_0xFF_succeeds)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_1_char_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x50, 0xFF };
-    unsigned char actual_value = 0;
+    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x01, 'a' };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -10888,25 +16170,27 @@ TEST_FUNCTION(amqpvalue_decode_ubyte_0xFF_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ubyte(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint8_t, 0xFF, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_335: [<encoding code="0x50" category="fixed" width="1" label="8-bit unsigned integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_ubyte_0xFF_given_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_255_chars_succeeds)
 {
     // arrange
-    unsigned char actual_value = 0;
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x50, 0xFF };
-    int i;
+    unsigned char bytes[255 + 5] = { 0xB3, 0x00, 0x00, 0x00, 0xFF, 'x' };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
+    (void)memset(bytes + 5, 'x', 255);
+
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
@@ -10914,36 +16198,39 @@ TEST_FUNCTION(amqpvalue_decode_ubyte_0xFF_given_byte_by_byte_succeeds)
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ubyte(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint8_t, 0xFF, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_334: [1.6.3 ubyte Integer in the range 0 to 28 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_ubyte_with_only_one_byte_succeds_but_no_callback_triggered)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_256_chars_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x50 };
+    unsigned char bytes[256 + 5] = { 0xB3, 0x00, 0x00, 0x01, 0x00, 'x' };
+    const char* actual_value;
     umock_c_reset_all_calls();
 
+    (void)memset(bytes + 5, 'x', 256);
+
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -10951,20 +16238,25 @@ TEST_FUNCTION(amqpvalue_decode_ubyte_with_only_one_byte_succeds_but_no_callback_
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxx", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_336: [1.6.4 ushort Integer in the range 0 to 216 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_337: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_ushort_0x0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
+/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_2_chars_byte_by_byte_succeeds)
 {
     // arrange
-    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x60, 0x0, 0x0 };
-    uint16_t actual_value = 1;
+    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x02, 'a', 'b' };
+    int i;
+    const char* actual_value;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -10974,35 +16266,35 @@ TEST_FUNCTION(amqpvalue_decode_ushort_0x0_succeeds)
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_USHORT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ushort(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0, (uint32_t)actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_336: [1.6.4 ushort Integer in the range 0 to 216 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_337: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_zero_bytes_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x60, 0xFF, 0xFF };
-    uint16_t actual_value = 1;
+    unsigned char bytes[] = { 0xB3 };
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -11010,57 +16302,47 @@ TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_USHORT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ushort(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFFFF, (uint32_t)actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_336: [1.6.4 ushort Integer in the range 0 to 216 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_337: [<encoding code="0x60" category="fixed" width="2" label="16-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_one_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x60, 0xFF, 0xFF };
-    int i;
-    uint16_t actual_value = 1;
+    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x01 };
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_USHORT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ushort(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFFFF, (uint32_t)actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
 /* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_insufficient_bytes_does_not_trigger_callback)
+TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_255_byte_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x60, 0xFF };
+    unsigned char bytes[255 + 5] = { 0xB3, 0x00, 0x00, 0x01, 0x00, 'x' };
     umock_c_reset_all_calls();
 
+    (void)memset(bytes + 5, 'x', 255);
+
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
@@ -11070,53 +16352,47 @@ TEST_FUNCTION(amqpvalue_decode_ushort_0xFFFF_insufficient_bytes_does_not_trigger
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_339: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_gballoc_malloc_fails_then_amqpvalue_decode_symbol_0xB3_one_byte_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x70, 0x0, 0x0, 0x0, 0x0 };
-    uint32_t actual_value = 1;
+    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x01, 'a' };
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+        .SetReturn(NULL);
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uint(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0, (uint32_t)actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_339: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_384: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_empty_list_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x70, 0x42, 0x43, 0x44, 0x45 };
-    uint32_t actual_value = 1;
+    unsigned char bytes[] = { 0x45 };
+    uint32_t item_count;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -11131,23 +16407,23 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uint(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0x42434445, (uint32_t)actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_339: [<encoding code="0x70" category="fixed" width="4" label="32-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_zero_items_succeeds)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x70, 0x42, 0x43, 0x44, 0x45 };
-    int i;
-    uint32_t actual_value = 1;
+    unsigned char bytes[] = { 0xC0, 0x00, 0x00 };
+    uint32_t item_count;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -11156,63 +16432,72 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_byte_by_byte_succeeds)
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
-    // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uint(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0x42434445, (uint32_t)actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x42434445_insufficient_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_1_null_item_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x70, 0x42, 0x43, 0x44 };
+    unsigned char bytes[] = { 0xC0, 0x01, 0x01, 0x40 };
+    uint32_t item_count;
+    AMQP_VALUE item1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    item1 = amqpvalue_get_list_item(decoded_values[0], 0);
+    ASSERT_ARE_EQUAL(uint32_t, 1, item_count);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item1));
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(item1);
 }
 
-/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_340: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0x0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_2_null_items_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x52, 0x0 };
-    uint32_t actual_value = 1;
+    unsigned char bytes[] = { 0xC0, 0x02, 0x02, 0x40, 0x40 };
+    uint32_t item_count;
+    AMQP_VALUE item1;
+    AMQP_VALUE item2;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
@@ -11221,29 +16506,37 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0x0_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uint(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0, (uint32_t)actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 2, item_count);
+    item1 = amqpvalue_get_list_item(decoded_values[0], 0);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item1));
+    item2 = amqpvalue_get_list_item(decoded_values[0], 1);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item2));
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(item1);
+    amqpvalue_destroy(item2);
 }
 
-/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_340: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0xFF_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_255_null_items_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x52, 0xFF };
-    uint32_t actual_value = 1;
+    unsigned char bytes[3 + 255] = { 0xC0, 0xFF, 0xFF };
+    int i;
+    uint32_t item_count;
     umock_c_reset_all_calls();
+    (void)memset(&bytes[3], 0x40, 255);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
@@ -11252,29 +16545,36 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0xFF_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uint(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFF, (uint32_t)actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 255, item_count);
+    for (i = 0; i < 255; i++)
+    {
+        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], 0);
+        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
+        amqpvalue_destroy(item);
+    }
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_340: [<encoding name="smalluint" code="0x52" category="fixed" width="1" label="unsigned integer value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0xFF_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_255_null_items_byte_by_byte_succeeds)
 {
     // arrange
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x52, 0xFF };
+    unsigned char bytes[3 + 255] = { 0xC0, 0xFF, 0xFF };
     int i;
-    uint32_t actual_value = 1;
+    uint32_t item_count;
     umock_c_reset_all_calls();
+    (void)memset(&bytes[3], 0x40, 255);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
@@ -11286,27 +16586,33 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x52_value_0xFF_byte_by_byte_succeeds)
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uint(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0xFF, (uint32_t)actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 255, item_count);
+    for (i = 0; i < 255; i++)
+    {
+        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
+        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
+        amqpvalue_destroy(item);
+    }
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
 /* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x52_only_one_byte_does_not_trigger_callback)
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_zero_items_not_enough_bytes_does_not_trigger_callback_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x52 };
+    unsigned char bytes[] = { 0xC0, 0x00 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -11319,22 +16625,45 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x52_only_one_byte_does_not_trigger_callback
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_338: [1.6.5 uint Integer in the range 0 to 232 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_341: [<encoding name="uint0" code="0x43" category="fixed" width="0" label="the uint value 0"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x43_value_0xFF_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_1_item_not_enough_bytes_does_not_trigger_callback_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x43 };
-    uint32_t actual_value = 1;
+    unsigned char bytes[] = { 0xC0, 0x01, 0x01 };
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
+
+    // act
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+}
+
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_list_0xC0_255_null_items_not_enough_bytes_does_not_trigger_callback_succeeds)
+{
+    // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    unsigned char bytes[3 + 254] = { 0xC0, 0xFF, 0xFF };
+    umock_c_reset_all_calls();
+    (void)memset(&bytes[3], 0x40, 254);
+
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -11342,23 +16671,20 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x43_value_0xFF_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uint(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint32_t, (uint32_t)0x0, (uint32_t)actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_343: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_zero_items_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x80, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
-    uint64_t actual_value = 1;
+    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    uint32_t item_count;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -11373,29 +16699,30 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x0_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ulong(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, 0x0, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_343: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x4243444546474849_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_1_null_item_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x80, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49 };
-    uint64_t actual_value = 1;
+    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x40 };
+    uint32_t item_count;
+    AMQP_VALUE item;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
@@ -11404,63 +16731,72 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x4243444546474849_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ulong(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, 0x4243444546474849, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 1, item_count);
+    item = amqpvalue_get_list_item(decoded_values[0], 0);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
+    amqpvalue_destroy(item);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_343: [<encoding code="0x80" category="fixed" width="8" label="64-bit unsigned integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x80_value_0x4243444546474849_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_2_null_items_succeeds)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x80, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49 };
+    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x40, 0x40 };
     int i;
-    uint64_t actual_value = 1;
+    uint32_t item_count;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ulong(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, 0x4243444546474849, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 2, item_count);
+    for (i = 0; i < 2; i++)
+    {
+        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
+        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
+        amqpvalue_destroy(item);
+    }
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0x0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_255_null_items_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x53, 0x0 };
-    uint64_t actual_value = 1;
+    unsigned char bytes[9 + 255] = { 0xD0, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF };
+    int i;
+    uint32_t item_count;
     umock_c_reset_all_calls();
+    (void)memset(bytes + 9, 0x40, 255);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
@@ -11469,29 +16805,37 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0x0_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ulong(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, 0, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 255, item_count);
+    for (i = 0; i < 255; i++)
+    {
+        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
+        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
+        amqpvalue_destroy(item);
+    }
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0xFF_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_256_null_items_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x53, 0xFF };
-    uint64_t actual_value = 1;
+    unsigned char bytes[9 + 256] = { 0xD0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00 };
+    int i;
+    uint32_t item_count;
     umock_c_reset_all_calls();
+    (void)memset(bytes + 9, 0x40, 256);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
@@ -11500,29 +16844,36 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0xFF_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ulong(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, 0xFF, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 256, item_count);
+    for (i = 0; i < 256; i++)
+    {
+        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
+        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
+        amqpvalue_destroy(item);
+    }
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0xFF_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
+/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_256_null_items_byte_by_byte_succeeds)
 {
     // arrange
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x53, 0xFF };
+    unsigned char bytes[9 + 256] = { 0xD0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00 };
     int i;
-    uint64_t actual_value = 1;
+    uint32_t item_count;
     umock_c_reset_all_calls();
+    (void)memset(bytes + 9, 0x40, 256);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
@@ -11534,28 +16885,33 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x53_value_0xFF_byte_by_byte_succeeds)
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ulong(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, 0xFF, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
+    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
+    ASSERT_ARE_EQUAL(uint32_t, 256, item_count);
+    for (i = 0; i < 256; i++)
+    {
+        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
+        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
+        amqpvalue_destroy(item);
+    }
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_344: [<encoding name="smallulong" code="0x53" category="fixed" width="1" label="unsigned long value in the range 0 to 255 inclusive"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x53_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_zero_items_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x53 };
+    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -11568,22 +16924,19 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x53_not_enough_bytes_does_not_trigger_callb
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_342: [1.6.6 ulong Integer in the range 0 to 264 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_345: [<encoding name="ulong0" code="0x44" category="fixed" width="0" label="the ulong value 0"/>] */
-TEST_FUNCTION(amqpvalue_decode_uint_0x44_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_1_item_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x44 };
-    uint64_t actual_value = 1;
+    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -11591,30 +16944,25 @@ TEST_FUNCTION(amqpvalue_decode_uint_0x44_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_ulong(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, 0, actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_346: [1.6.7 byte Integer in the range -(27) to 27 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_347: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_byte_minus_128_succeeds)
+/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
+TEST_FUNCTION(amqpvalue_decode_list_0xD0_256_null_items_not_enough_bytes_does_not_trigger_callback)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x51, 0x80 };
-    char actual_value = 1;
+    unsigned char bytes[9 + 255] = { 0xD0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00 };
     umock_c_reset_all_calls();
+    (void)memset(bytes + 9, 0x40, 255);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -11622,579 +16970,518 @@ TEST_FUNCTION(amqpvalue_decode_byte_minus_128_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BYTE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_byte(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char, -128, actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_346: [1.6.7 byte Integer in the range -(27) to 27 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_347: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_byte_127_succeeds)
+/* amqpvalue_arena_create */
+
+/* Tests_SRS_AMQPVALUE_01_405: [ If `block_size` is 0, `amqpvalue_arena_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(amqpvalue_arena_create_with_0_block_size_fails)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x51, 0x7F };
-    char actual_value = 1;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    AMQPVALUE_ARENA_HANDLE arena;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    arena = amqpvalue_arena_create(0);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(arena);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BYTE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_byte(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char, 127, actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_346: [1.6.7 byte Integer in the range -(27) to 27 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_347: [<encoding code="0x51" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_byte_127_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_404: [ `amqpvalue_arena_create` shall create a new arena from which decoded AMQP values can be allocated in blocks of `block_size` bytes and return a non-NULL handle to it. ]*/
+/* Tests_SRS_AMQPVALUE_01_407: [ No block shall be allocated until the first value is allocated from the arena. ]*/
+TEST_FUNCTION(amqpvalue_arena_create_succeeds)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x51, 0x7F };
-    int i;
-    char actual_value = 1;
-    umock_c_reset_all_calls();
+    AMQPVALUE_ARENA_HANDLE arena;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    arena = amqpvalue_arena_create(1024);
 
     // assert
+    ASSERT_IS_NOT_NULL(arena);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BYTE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_byte(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char, 127, actual_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_arena_destroy(arena);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_byte_127_not_enough_bytes_does_not_trigger_a_callback)
+/* Tests_SRS_AMQPVALUE_01_406: [ If allocating memory for the arena fails, `amqpvalue_arena_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_amqpvalue_arena_create_fails)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x51 };
-    umock_c_reset_all_calls();
+    AMQPVALUE_ARENA_HANDLE arena;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+        .SetReturn(NULL);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    arena = amqpvalue_arena_create(1024);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(arena);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* amqpvalue_arena_reset */
+
+/* Tests_SRS_AMQPVALUE_01_409: [ If `arena` is NULL, `amqpvalue_arena_reset` shall do nothing. ]*/
+TEST_FUNCTION(amqpvalue_arena_reset_with_NULL_arena_does_nothing)
+{
+    // arrange
+
+    // act
+    amqpvalue_arena_reset(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_348: [1.6.8 short Integer in the range -(215) to 215 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_349: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_byte_minus_32768_succeeds)
+/* Tests_SRS_AMQPVALUE_01_408: [ `amqpvalue_arena_reset` shall release all values allocated from the arena at once, keeping one block for reuse. ]*/
+TEST_FUNCTION(amqpvalue_arena_reset_keeps_one_block_for_reuse)
 {
     // arrange
     int result;
+    AMQPVALUE_ARENA_HANDLE arena = amqpvalue_arena_create(1024);
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x61, 0x80, 0x00 };
-    int16_t actual_value = 1;
+    unsigned char bytes[] = { 0xA1, 0x02, 'a', 'b' };
+    (void)amqpvalue_decoder_set_arena(amqpvalue_decoder, arena);
+    (void)amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
+    amqpvalue_arena_reset(arena);
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SHORT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_short(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int16_t, -32768, actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_arena_destroy(arena);
 }
 
-/* Tests_SRS_AMQPVALUE_01_348: [1.6.8 short Integer in the range -(215) to 215 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_349: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_byte_32767_succeeds)
+/* amqpvalue_arena_destroy */
+
+/* Tests_SRS_AMQPVALUE_01_411: [ If `arena` is NULL, `amqpvalue_arena_destroy` shall do nothing. ]*/
+TEST_FUNCTION(amqpvalue_arena_destroy_with_NULL_arena_does_nothing)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x61, 0x7F, 0xFF };
-    int16_t actual_value = 1;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    amqpvalue_arena_destroy(NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SHORT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_short(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int16_t, 32767, actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_348: [1.6.8 short Integer in the range -(215) to 215 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_349: [<encoding code="0x61" category="fixed" width="2" label="16-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_byte_32767_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_410: [ `amqpvalue_arena_destroy` shall free all the blocks owned by the arena and the arena itself. ]*/
+TEST_FUNCTION(amqpvalue_arena_destroy_frees_the_blocks_and_the_arena)
 {
     // arrange
+    AMQPVALUE_ARENA_HANDLE arena = amqpvalue_arena_create(1024);
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x61, 0x7F, 0xFF };
-    int i;
-    int16_t actual_value = 1;
+    unsigned char bytes[] = { 0xA1, 0x02, 'a', 'b' };
+    (void)amqpvalue_decoder_set_arena(amqpvalue_decoder, arena);
+    (void)amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(arena));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    amqpvalue_arena_destroy(arena);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SHORT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_short(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int16_t, 32767, actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_short_32767_not_enough_bytes_does_not_trigger_a_callback)
+/* amqpvalue_decoder_set_arena */
+
+/* Tests_SRS_AMQPVALUE_01_413: [ If `handle` is NULL, `amqpvalue_decoder_set_arena` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_arena_with_NULL_handle_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x61, 0x7F };
+    AMQPVALUE_ARENA_HANDLE arena = amqpvalue_arena_create(1024);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_set_arena(NULL, arena);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_arena_destroy(arena);
 }
 
-/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_351: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_int_minus_2147483648_succeeds)
+/* Tests_SRS_AMQPVALUE_01_412: [ `amqpvalue_decoder_set_arena` shall make all subsequently decoded values (and all their inner values and buffers) be allocated from `arena`. ]*/
+/* Tests_SRS_AMQPVALUE_01_416: [ On success `amqpvalue_decoder_set_arena` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_decode_string_with_arena_allocates_one_block)
 {
     // arrange
     int result;
+    AMQPVALUE_ARENA_HANDLE arena = amqpvalue_arena_create(1024);
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x71, 0x80, 0x00, 0x00, 0x00 };
-    int32_t actual_value = 1;
+    unsigned char bytes[] = { 0xA1, 0x02, 'a', 'b' };
+    int set_arena_result = amqpvalue_decoder_set_arena(amqpvalue_decoder, arena);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
+    /* one block for both the value and its characters */
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    /* the test callback clones the value out of the arena */
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, set_arena_result);
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_int(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int32_t, -2147483647-1, actual_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_arena_destroy(arena);
 }
 
-/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_351: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_int_2147483647_succeeds)
+/* Tests_SRS_AMQPVALUE_01_414: [ If the decoder is in the middle of decoding a value, `amqpvalue_decoder_set_arena` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_arena_while_decoding_a_value_fails)
 {
     // arrange
     int result;
+    AMQPVALUE_ARENA_HANDLE arena = amqpvalue_arena_create(1024);
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x71, 0x7F, 0xFF, 0xFF, 0xFF };
-    int32_t actual_value = 1;
+    unsigned char bytes[] = { 0xA1, 0x02, 'a' };
+    (void)amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_set_arena(amqpvalue_decoder, arena);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_int(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int32_t, 2147483647, actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_arena_destroy(arena);
 }
 
-/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_351: [<encoding code="0x71" category="fixed" width="4" label="32-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_int_2147483647_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_418: [ Cloning a value allocated from an arena shall produce a copy that does not reference the arena. ]*/
+TEST_FUNCTION(a_value_cloned_from_an_arena_is_valid_after_the_arena_is_destroyed)
 {
     // arrange
+    AMQPVALUE_ARENA_HANDLE arena = amqpvalue_arena_create(1024);
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x71, 0x7F, 0xFF, 0xFF, 0xFF };
-    int i;
-    int32_t actual_value = 1;
+    unsigned char bytes[] = { 0xC0, 0x07, 0x02, 0xA1, 0x02, 'a', 'b', 0x52, 0x2A };
+    AMQP_VALUE item;
+    const char* actual_string;
+    (void)amqpvalue_decoder_set_arena(amqpvalue_decoder, arena);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    (void)amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_arena_destroy(arena);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_int(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int32_t, 2147483647, actual_value);
+    item = amqpvalue_get_list_item(decoded_values[0], 0);
+    (void)amqpvalue_get_string(item, &actual_string);
+    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_string);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_int_2147483647_not_enough_bytes_does_not_trigger_a_callback)
+/* amqpvalue_create_binary_borrowed */
+
+/* Tests_SRS_AMQPVALUE_01_420: [ amqpvalue_create_binary_borrowed shall return a handle to an AMQP_VALUE that stores a sequence of bytes by pointing to value.bytes, without copying them. ]*/
+TEST_FUNCTION(amqpvalue_create_binary_borrowed_does_not_copy_the_bytes)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x71, 0x7F, 0xFF, 0xFF };
-    umock_c_reset_all_calls();
+    unsigned char input[] = { 0x42, 0x43 };
+    amqp_binary binary_input = { input, sizeof(input) };
+    amqp_binary binary_value;
+    AMQP_VALUE result;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_create_binary_borrowed(binary_input);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_binary(result, &binary_value);
+    ASSERT_ARE_EQUAL(void_ptr, input, binary_value.bytes);
+    ASSERT_ARE_EQUAL(uint32_t, 2, binary_value.length);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_352: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_int_0x54_value_minus_128_succeeds)
+/* Tests_SRS_AMQPVALUE_01_421: [ If value.bytes is NULL and value.length is positive then amqpvalue_create_binary_borrowed shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_create_binary_borrowed_with_NULL_bytes_and_positive_length_fails)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x54, 0x80 };
-    int32_t actual_value = 1;
-    umock_c_reset_all_calls();
+    amqp_binary binary_input = { NULL, 1 };
+    AMQP_VALUE result;
+
+    // act
+    result = amqpvalue_create_binary_borrowed(binary_input);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_422: [ If allocating the AMQP_VALUE fails then amqpvalue_create_binary_borrowed, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_amqpvalue_create_binary_borrowed_fails)
+{
+    // arrange
+    unsigned char input[] = { 0x42 };
+    amqp_binary binary_input = { input, sizeof(input) };
+    AMQP_VALUE result;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+        .SetReturn(NULL);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_create_binary_borrowed(binary_input);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_int(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int32_t, -128, actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_352: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_int_0x54_value_127_succeeds)
+/* Tests_SRS_AMQPVALUE_01_430: [ amqpvalue_destroy shall not free the bytes of borrowed binary, string and symbol values. ]*/
+TEST_FUNCTION(amqpvalue_destroy_of_a_borrowed_binary_does_not_free_the_bytes)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x54, 0x7F };
-    int32_t actual_value = 1;
+    unsigned char input[] = { 0x42 };
+    amqp_binary binary_input = { input, sizeof(input) };
+    AMQP_VALUE value = amqpvalue_create_binary_borrowed(binary_input);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(value));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    amqpvalue_destroy(value);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_int(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int32_t, 127, actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_350: [1.6.9 int Integer in the range -(231) to 231 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_352: [<encoding name="smallint" code="0x54" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_int_0x54_value_127_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_424: [ Cloning a borrowed value (or a value containing borrowed values) shall copy the borrowed bytes. ]*/
+TEST_FUNCTION(amqpvalue_clone_of_a_borrowed_binary_copies_the_bytes)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x54, 0x7F };
-    int i;
-    int32_t actual_value = 1;
+    unsigned char input[] = { 0x42, 0x43 };
+    amqp_binary binary_input = { input, sizeof(input) };
+    amqp_binary binary_value;
+    AMQP_VALUE value = amqpvalue_create_binary_borrowed(binary_input);
+    AMQP_VALUE result;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(input)));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_clone(value);
 
     // assert
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_int(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(int32_t, 127, actual_value);
+    (void)amqpvalue_get_binary(result, &binary_value);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, input, binary_value.bytes);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(input, binary_value.bytes, sizeof(input)));
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(value);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_int_0x54_value_127_not_enough_bytes_does_not_trigger_a_callback)
+/* amqpvalue_create_string_borrowed */
+
+/* Tests_SRS_AMQPVALUE_01_428: [ amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return a handle to an AMQP_VALUE that points to the zero terminated value, without copying it. ]*/
+TEST_FUNCTION(amqpvalue_create_string_borrowed_does_not_copy_the_string)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x54 };
-    umock_c_reset_all_calls();
+    const char* input = "test";
+    const char* string_value;
+    AMQP_VALUE result;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_create_string_borrowed(input);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)amqpvalue_get_string(result, &string_value);
+    ASSERT_ARE_EQUAL(void_ptr, input, string_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_354: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_long_minus_9223372036854775808_succeeds)
+/* Tests_SRS_AMQPVALUE_01_423: [ If value is NULL, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_create_string_borrowed_with_NULL_fails)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x81, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    int64_t actual_value = 1;
-    umock_c_reset_all_calls();
+    AMQP_VALUE result;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    // act
+    result = amqpvalue_create_string_borrowed(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqpvalue_create_symbol_borrowed */
+
+/* Tests_SRS_AMQPVALUE_01_428: [ amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return a handle to an AMQP_VALUE that points to the zero terminated value, without copying it. ]*/
+TEST_FUNCTION(amqpvalue_create_symbol_borrowed_does_not_copy_the_symbol)
+{
+    // arrange
+    const char* input = "test";
+    const char* symbol_value;
+    AMQP_VALUE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_create_symbol_borrowed(input);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_long(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(-9223372036854775807LL - 1), (uint64_t)actual_value);
+    (void)amqpvalue_get_symbol(result, &symbol_value);
+    ASSERT_ARE_EQUAL(void_ptr, input, symbol_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_354: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_long_9223372036854775807_succeeds)
+/* Tests_SRS_AMQPVALUE_01_423: [ If value is NULL, amqpvalue_create_string_borrowed and amqpvalue_create_symbol_borrowed shall return NULL. ]*/
+TEST_FUNCTION(amqpvalue_create_symbol_borrowed_with_NULL_fails)
 {
     // arrange
-    int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x81, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
-    int64_t actual_value = 1;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    AMQP_VALUE result;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_create_symbol_borrowed(NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_long(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* amqpvalue_decoder_set_borrow_binaries */
+
+/* Tests_SRS_AMQPVALUE_01_426: [ If `handle` is NULL, `amqpvalue_decoder_set_borrow_binaries` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_borrow_binaries_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqpvalue_decoder_set_borrow_binaries(NULL, true);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_354: [<encoding code="0x81" category="fixed" width="8" label="64-bit two's-complement integer in network byte order"/>] */
-TEST_FUNCTION(amqpvalue_decode_long_9223372036854775807_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_425: [ `amqpvalue_decoder_set_borrow_binaries` shall enable or disable borrowing the bytes of decoded binary values from the buffer passed to amqpvalue_decode_bytes. ]*/
+/* Tests_SRS_AMQPVALUE_01_427: [ When borrowing binaries is enabled and all the bytes of a binary value are in the buffer passed to amqpvalue_decode_bytes, the decoded binary value shall point to those bytes instead of copying them. ]*/
+/* Tests_SRS_AMQPVALUE_01_429: [ On success `amqpvalue_decoder_set_borrow_binaries` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_decode_binary_with_borrow_binaries_does_not_copy_the_bytes)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x81, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
-    int i;
-    int64_t actual_value = 1;
+    unsigned char bytes[] = { 0xA0, 0x02, 0x42, 0x43 };
+    amqp_binary binary_value;
+    int set_borrow_result = amqpvalue_decoder_set_borrow_binaries(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    /* the test callback clones the value, which copies the bytes */
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(2));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, set_borrow_result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_long(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
+    (void)amqpvalue_get_binary(decoded_values[0], &binary_value);
+    ASSERT_ARE_EQUAL(uint32_t, 2, binary_value.length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(bytes + 2, binary_value.bytes, 2));
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_long_9223372036854775807_not_enough_bytes_does_not_trigger_a_callback)
+/* amqpvalue_decoder_set_lazy_lists */
+
+/* Tests_SRS_AMQPVALUE_01_464: [ If `handle` is NULL, `amqpvalue_decoder_set_lazy_lists` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_lazy_lists_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = amqpvalue_decoder_set_lazy_lists(NULL, true);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_465: [ On success `amqpvalue_decoder_set_lazy_lists` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_lazy_lists_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x81, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_set_lazy_lists(amqpvalue_decoder, true);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -12204,204 +17491,237 @@ TEST_FUNCTION(amqpvalue_decode_long_9223372036854775807_not_enough_bytes_does_no
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_355: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_long_0x55_value_minus_128_succeeds)
+/* Tests_SRS_AMQPVALUE_01_460: [ When lazy lists are enabled, the items of decoded lists shall not be decoded until they are accessed. ]*/
+/* Tests_SRS_AMQPVALUE_01_461: [ The items of a lazily decoded list shall be decoded the first time they are accessed. ]*/
+/* Tests_SRS_AMQPVALUE_01_463: [ Cloning a lazily decoded list shall decode all its items, the clone does not reference the decoded bytes. ]*/
+/* Tests_SRS_AMQPVALUE_01_467: [ A lazily decoded list shall be treated as borrowed, since it points to the bytes passed to amqpvalue_decode_bytes. ]*/
+TEST_FUNCTION(amqpvalue_decode_list8_with_lazy_lists_gives_a_list_that_outlives_the_bytes)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x55, 0x80 };
-    int64_t actual_value = 1;
+    unsigned char bytes[] = { 0xC0, 0x05, 0x02, 0x52, 0x07, 0xC0, 0x01, 0x00 };
+    uint32_t item_count;
+    uint32_t uint_value;
+    AMQP_VALUE item;
+    int set_lazy_result = amqpvalue_decoder_set_lazy_lists(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    (void)memset(bytes, 0, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, set_lazy_result);
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_long(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(-128), (uint64_t)actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_list_item_count(decoded_values[0], &item_count));
+    ASSERT_ARE_EQUAL(uint32_t, 2, item_count);
+    item = amqpvalue_get_list_item_in_place(decoded_values[0], 0);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_uint(item, &uint_value));
+    ASSERT_ARE_EQUAL(uint32_t, 7, uint_value);
+    item = amqpvalue_get_list_item_in_place(decoded_values[0], 1);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_list_item_count(item, &item_count));
+    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
 }
 
-/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_355: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_long_0x55_value_127_succeeds)
+/* Tests_SRS_AMQPVALUE_01_460: [ When lazy lists are enabled, the items of decoded lists shall not be decoded until they are accessed. ]*/
+TEST_FUNCTION(amqpvalue_decode_list8_with_lazy_lists_and_a_size_that_does_not_match_the_items_falls_back_to_the_regular_decoder)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x55, 0x7F };
-    int64_t actual_value = 1;
+    unsigned char bytes[] = { 0xC0, 0x04, 0x02, 0x40, 0x40, 0x40 };
+    uint32_t item_count;
+    (void)amqpvalue_decoder_set_lazy_lists(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    /* the regular decoder stops the list after its 2 items and decodes the last byte as a separate null */
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_long(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)127, (uint64_t)actual_value);
+    ASSERT_ARE_EQUAL(size_t, 2, decoded_value_count);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_list_item_count(decoded_values[0], &item_count));
+    ASSERT_ARE_EQUAL(uint32_t, 2, item_count);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(decoded_values[1]));
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_353: [1.6.10 long Integer in the range -(263) to 263 - 1 inclusive.] */
-/* Tests_SRS_AMQPVALUE_01_355: [<encoding name="smalllong" code="0x55" category="fixed" width="1" label="8-bit two's-complement integer"/>] */
-TEST_FUNCTION(amqpvalue_decode_long_0x55_value_127_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_570: [ When decoding a map of at least 8 pairs, not into an arena, the decoder shall build the hash index of the map as its keys are decoded. ]*/
+TEST_FUNCTION(amqpvalue_decode_map_with_8_pairs_gives_a_map_that_is_looked_up_without_building_an_index)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x55, 0x7F };
-    int i;
-    int64_t actual_value = 1;
+    unsigned char bytes[] = { 0xC1, 0x21, 0x10,
+        0x52, 0x00, 0x52, 0x10, 0x52, 0x01, 0x52, 0x11, 0x52, 0x02, 0x52, 0x12, 0x52, 0x03, 0x52, 0x13,
+        0x52, 0x04, 0x52, 0x14, 0x52, 0x05, 0x52, 0x15, 0x52, 0x06, 0x52, 0x16, 0x52, 0x07, 0x52, 0x17 };
+    AMQP_VALUE key = amqpvalue_create_uint(5);
+    AMQP_VALUE value;
+    uint32_t uint_value;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    umock_c_reset_all_calls();
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    value = amqpvalue_get_map_value(decoded_values[0], key);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_long(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)127, (uint64_t)actual_value);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_uint(value, &uint_value));
+    ASSERT_ARE_EQUAL(uint32_t, 0x15, uint_value);
 
     // cleanup
+    amqpvalue_destroy(value);
+    amqpvalue_destroy(key);
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_long_0x55_value_127_not_enough_bytes_does_not_trigger_a_callback)
+/* Tests_SRS_AMQPVALUE_01_591: [ The map lookups shall not modify the map, a map of at least 8 pairs whose hash index could not be allocated being searched linearly until a pair is added to it, so that a map can be looked up from several threads at once. ]*/
+TEST_FUNCTION(amqpvalue_get_map_value_on_a_map_whose_index_could_not_be_allocated_does_not_modify_the_map)
 {
     // arrange
+    AMQP_VALUE map = amqpvalue_create_map();
+    AMQP_VALUE key;
+    AMQP_VALUE value;
+    uint32_t key_value;
+    uint32_t uint_value;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x55 };
+
+    for (key_value = 0; key_value < 7; key_value++)
+    {
+        key = amqpvalue_create_uint(key_value);
+        value = amqpvalue_create_uint(0x10 + key_value);
+        (void)amqpvalue_set_map_value(map, key, value);
+        amqpvalue_destroy(value);
+        amqpvalue_destroy(key);
+    }
+
+    key = amqpvalue_create_uint(7);
+    value = amqpvalue_create_uint(0x17);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    /* the index the 8th pair builds */
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+        .SetReturn(NULL);
+    result = amqpvalue_set_map_value(map, key, value);
+    amqpvalue_destroy(value);
+    amqpvalue_destroy(key);
+    key = amqpvalue_create_uint(5);
+    umock_c_reset_all_calls();
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    value = amqpvalue_get_map_value(map, key);
 
     // assert
+    /* no index is built by the lookup */
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_uint(value, &uint_value));
+    ASSERT_ARE_EQUAL(uint32_t, 0x15, uint_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(value);
+    amqpvalue_destroy(key);
+    amqpvalue_destroy(map);
 }
 
-/* Tests_SRS_AMQPVALUE_01_019: [1.6.11 float 32-bit floating point number (IEEE 754-2008 binary32).]*/
-/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>]*/
-TEST_FUNCTION(amqpvalue_decode_float_minus_1_0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_570: [ When decoding a map of at least 8 pairs, not into an arena, the decoder shall build the hash index of the map as its keys are decoded. ]*/
+TEST_FUNCTION(amqpvalue_decode_map_with_8_pairs_byte_by_byte_indexes_all_keys)
 {
     // arrange
-    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x72, 0xBF, 0x80, 0x00, 0x00 };
-    float actual_value = 0.0;
+    unsigned char bytes[] = { 0xC1, 0x21, 0x10,
+        0x52, 0x00, 0x52, 0x10, 0x52, 0x01, 0x52, 0x11, 0x52, 0x02, 0x52, 0x12, 0x52, 0x03, 0x52, 0x13,
+        0x52, 0x04, 0x52, 0x14, 0x52, 0x05, 0x52, 0x15, 0x52, 0x06, 0x52, 0x16, 0x52, 0x07, 0x52, 0x17 };
+    size_t i;
+    uint32_t key_value;
+    int result = 0;
+
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        result |= amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+    }
+
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    /* only the keys created by the test are allocated, the map was indexed while it was decoded */
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    for (key_value = 0; key_value < 8; key_value++)
+    {
+        AMQP_VALUE key = amqpvalue_create_uint(key_value);
+        AMQP_VALUE value = amqpvalue_get_map_value(decoded_values[0], key);
+        uint32_t uint_value;
+
+        ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_uint(value, &uint_value));
+        ASSERT_ARE_EQUAL(uint32_t, 0x10 + key_value, uint_value);
+
+        amqpvalue_destroy(value);
+        amqpvalue_destroy(key);
+    }
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_FLOAT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_float(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(float, (float)-1.0, actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>]*/
-TEST_FUNCTION(amqpvalue_decode_float_42_succeeds)
+/* amqpvalue_decoder_reset */
+
+/* Tests_SRS_AMQPVALUE_01_501: [ If `handle` is NULL, `amqpvalue_decoder_reset` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_reset_with_NULL_handle_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x82, 0x40, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    double actual_value = 0.0;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_reset(NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_DOUBLE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_double(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(double, (double)42.0, actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_double_42_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_504: [ On success `amqpvalue_decoder_reset` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_decoder_reset_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x82, 0x40, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_reset(amqpvalue_decoder);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -12411,15 +17731,16 @@ TEST_FUNCTION(amqpvalue_decode_double_42_not_enough_bytes_does_not_trigger_callb
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_020: [1.6.12 double 64-bit floating point number (IEEE 754-2008 binary64).]*/
-/* Tests_SRS_AMQPVALUE_01_290: [\<encoding name="ieee-754" code="0x82" category="fixed" width="8" label="IEEE 754-2008 binary64"/>]*/
-TEST_FUNCTION(amqpvalue_decode_double_minus_1_0_succeeds)
+/* Tests_SRS_AMQPVALUE_01_502: [ `amqpvalue_decoder_reset` shall discard any partially decoded value and the last decoded value, so that the next byte passed to `amqpvalue_decode_bytes` or `amqpvalue_decode_one` is treated as the constructor of a new value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_reset_discards_a_partially_decoded_value)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x82, 0xBF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    double actual_value = 0.0;
+    unsigned char partial_bytes[] = { 0xC0, 0x05, 0x02, 0x70 };
+    unsigned char bytes[] = { 0x70, 0x00, 0x00, 0x00, 0x42 };
+    uint32_t actual_value;
+    (void)amqpvalue_decode_bytes(amqpvalue_decoder, partial_bytes, sizeof(partial_bytes));
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -12429,114 +17750,91 @@ TEST_FUNCTION(amqpvalue_decode_double_minus_1_0_succeeds)
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_reset(amqpvalue_decoder);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_DOUBLE, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_double(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(double, (double)-1.0, actual_value);
+    (void)amqpvalue_get_uint(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(uint32_t, 0x42, actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_289: [\<encoding name="ieee-754" code="0x72" category="fixed" width="4" label="IEEE 754-2008 binary32"/>]*/
-TEST_FUNCTION(amqpvalue_decode_double_42_succeeds)
+/* Tests_SRS_AMQPVALUE_01_503: [ `amqpvalue_decoder_reset` shall keep the arena, borrow binaries, lazy lists and validate strings settings of the decoder. ]*/
+TEST_FUNCTION(amqpvalue_decoder_reset_keeps_validate_strings)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x72, 0x42, 0x28, 0x00, 0x00 };
-    float actual_value = 0.0;
+    unsigned char bytes[] = { 0xA1, 0x02, 0xC0, 0x80 };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
+    (void)amqpvalue_decoder_reset(amqpvalue_decoder);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_FLOAT, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_float(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(float, (float)42.0, actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_float_42_not_enough_bytes_does_not_trigger_callback)
+/* amqpvalue_decoder_set_validate_strings */
+
+/* Tests_SRS_AMQPVALUE_01_479: [ If `handle` is NULL, `amqpvalue_decoder_set_validate_strings` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_validate_strings_with_NULL_handle_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x72, 0x42, 0x28, 0x00 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_set_validate_strings(NULL, true);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_368: [1.6.17 timestamp An absolute point in time.] */
-/* Tests_SRS_AMQPVALUE_01_369: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_decode_timestamp_value_minus_9223372036854775808_succeeds)
+/* Tests_SRS_AMQPVALUE_01_480: [ On success `amqpvalue_decoder_set_validate_strings` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_validate_strings_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x83, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    int64_t actual_value = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_TIMESTAMP, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_timestamp(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(-9223372036854775807LL-1), (uint64_t)actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
-
-/* Tests_SRS_AMQPVALUE_01_368: [1.6.17 timestamp An absolute point in time.] */
-/* Tests_SRS_AMQPVALUE_01_369: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_decode_timestamp_value_9223372036854775807_succeeds)
+
+/* Tests_SRS_AMQPVALUE_01_476: [ `amqpvalue_decoder_set_validate_strings` shall enable or disable validating decoded strings as UTF-8 and decoded symbols as 7-bit ASCII. ]*/
+TEST_FUNCTION(amqpvalue_decode_valid_utf8_string_with_validate_strings_succeeds)
 {
     // arrange
     int result;
-    int64_t actual_value = 1;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x83, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    unsigned char bytes[] = { 0xA1, 0x0A, 'a', 0xC3, 0xA9, 0xE2, 0x82, 0xAC, 0xF0, 0x9F, 0x98, 0x80 };
+    const char* actual_value;
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -12551,23 +17849,23 @@ TEST_FUNCTION(amqpvalue_decode_timestamp_value_9223372036854775807_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_TIMESTAMP, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_timestamp(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_368: [1.6.17 timestamp An absolute point in time.] */
-/* Tests_SRS_AMQPVALUE_01_369: [<encoding name="ms64" code="0x83" category="fixed" width="8" label="64-bit two's-complement integer representing milliseconds since the unix epoch"/>] */
-TEST_FUNCTION(amqpvalue_decode_timestamp_value_9223372036854775807_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_476: [ `amqpvalue_decoder_set_validate_strings` shall enable or disable validating decoded strings as UTF-8 and decoded symbols as 7-bit ASCII. ]*/
+TEST_FUNCTION(amqpvalue_decode_valid_utf8_string_byte_by_byte_with_validate_strings_succeeds)
 {
     // arrange
+    int result;
+    size_t i;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x83, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
-    int i;
-    int64_t actual_value = 1;
+    unsigned char bytes[] = { 0xA1, 0x0A, 'a', 0xC3, 0xA9, 0xE2, 0x82, 0xAC, 0xF0, 0x9F, 0x98, 0x80 };
+    const char* actual_value;
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -12577,29 +17875,30 @@ TEST_FUNCTION(amqpvalue_decode_timestamp_value_9223372036854775807_byte_by_byte_
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
+    result = 0;
+    for (i = 0; (i < sizeof(bytes)) && (result == 0); i++)
     {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
+        result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
     }
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_TIMESTAMP, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_timestamp(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(9223372036854775807LL), (uint64_t)actual_value);
+    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
+    ASSERT_ARE_EQUAL(char_ptr, "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_timestamp_not_enough_bytes_does_not_trigger_a_callback)
+/* Tests_SRS_AMQPVALUE_01_477: [ When string validation is enabled, a decoded string that is not valid UTF-8 shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_string_with_an_overlong_encoding_with_validate_strings_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x83, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    unsigned char bytes[] = { 0xA1, 0x02, 0xC0, 0x80 };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -12611,91 +17910,74 @@ TEST_FUNCTION(amqpvalue_decode_timestamp_not_enough_bytes_does_not_trigger_a_cal
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_370: [1.6.18 uuid A universally unique identifier as defined by RFC-4122 section 4.1.2 .] */
-/* Tests_SRS_AMQPVALUE_01_371: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
-TEST_FUNCTION(amqpvalue_decode_uuid_succeeds)
+/* Tests_SRS_AMQPVALUE_01_477: [ When string validation is enabled, a decoded string that is not valid UTF-8 shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_string_with_a_surrogate_with_validate_strings_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x98, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
-    uuid expected_uuid = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
-    uuid actual_value = { 0 };
+    unsigned char bytes[] = { 0xA1, 0x03, 0xED, 0xA0, 0x80 };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UUID, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uuid(decoded_values[0], &actual_value);
-    stringify_bytes(actual_value, sizeof(actual_value), actual_stringified);
-    stringify_bytes(expected_uuid, sizeof(expected_uuid), expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_370: [1.6.18 uuid A universally unique identifier as defined by RFC-4122 section 4.1.2 .] */
-/* Tests_SRS_AMQPVALUE_01_371: [<encoding code="0x98" category="fixed" width="16" label="UUID as defined in section 4.1.2 of RFC-4122"/>] */
-TEST_FUNCTION(amqpvalue_decode_uuid_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_477: [ When string validation is enabled, a decoded string that is not valid UTF-8 shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_string_with_a_truncated_sequence_with_validate_strings_fails)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x98, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
-    uuid expected_uuid = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
-    int i;
-    uuid actual_value = { 0 };
+    unsigned char bytes[] = { 0xA1, 0x03, 'a', 0xE2, 0x82 };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UUID, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_uuid(decoded_values[0], &actual_value);
-    stringify_bytes(actual_value, sizeof(actual_value), actual_stringified);
-    stringify_bytes(expected_uuid, sizeof(expected_uuid), expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_uuid_not_enough_bytes_does_not_trigger_a_callback)
+/* Tests_SRS_AMQPVALUE_01_477: [ When string validation is enabled, a decoded string that is not valid UTF-8 shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_str32_with_invalid_utf8_byte_by_byte_with_validate_strings_fails)
 {
     // arrange
     int result;
+    size_t i;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x98, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 };
+    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x0A, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 0xFF };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -12704,202 +17986,175 @@ TEST_FUNCTION(amqpvalue_decode_uuid_not_enough_bytes_does_not_trigger_a_callback
         .IgnoreAllCalls();
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = 0;
+    for (i = 0; (i < sizeof(bytes)) && (result == 0); i++)
+    {
+        result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+    }
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
-/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_decode_binary_zero_size_succeeds)
+/* Tests_SRS_AMQPVALUE_01_478: [ When string validation is enabled, a decoded symbol that contains characters that are not 7-bit ASCII shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_symbol_with_non_ascii_chars_with_validate_strings_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA0, 0x00 };
-    amqp_binary actual_value = { NULL, 0 };
+    unsigned char bytes[] = { 0xA3, 0x02, 'a', 0xC3 };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_binary(decoded_values[0], &actual_value);
-    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
-    stringify_bytes(bytes, 0, expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
-/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_decode_binary_one_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_478: [ When string validation is enabled, a decoded symbol that contains characters that are not 7-bit ASCII shall make amqpvalue_decode_bytes fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_sym32_with_non_ascii_chars_byte_by_byte_with_validate_strings_fails)
 {
     // arrange
     int result;
+    size_t i;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA0, 0x01, 0x42 };
-    amqp_binary actual_value = { NULL, 0 };
+    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x02, 'a', 0x80 };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = 0;
+    for (i = 0; (i < sizeof(bytes)) && (result == 0); i++)
+    {
+        result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
+    }
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_binary(decoded_values[0], &actual_value);
-    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
-    stringify_bytes(&bytes[2], sizeof(bytes) - 2, expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
-/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_decode_binary_255_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_481: [ When string validation is enabled, lists shall not be decoded lazily, so that all the strings and symbols are validated when decoded. ]*/
+TEST_FUNCTION(amqpvalue_decode_invalid_utf8_string_in_a_list_with_validate_strings_and_lazy_lists_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 2] = { 0xA0, 0xFF };
-    unsigned int i;
-    amqp_binary actual_value = { NULL, 0 };
+    unsigned char bytes[] = { 0xC0, 0x05, 0x02, 0x40, 0xA1, 0x01, 0x80 };
+    (void)amqpvalue_decoder_set_validate_strings(amqpvalue_decoder, true);
+    (void)amqpvalue_decoder_set_lazy_lists(amqpvalue_decoder, true);
     umock_c_reset_all_calls();
 
-    for (i = 0; i < 255; i++)
-    {
-        bytes[2 + i] = (unsigned char)i;
-    }
-
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_binary(decoded_values[0], &actual_value);
-    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
-    stringify_bytes(&bytes[2], sizeof(bytes) - 2, expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
-/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_decode_binary_255_bytes_byte_by_byte_succeeds)
+/* amqpvalue_decoder_set_limits */
+
+/* Tests_SRS_AMQPVALUE_01_522: [ If `handle` is NULL, `amqpvalue_decoder_set_limits` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_limits_with_NULL_handle_fails)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 2] = { 0xA0, 0xFF };
-    unsigned int i;
-    amqp_binary actual_value = { NULL, 0 };
-    umock_c_reset_all_calls();
+    int result;
 
-    for (i = 0; i < 255; i++)
-    {
-        bytes[2 + i] = (unsigned char)i;
-    }
+    // act
+    result = amqpvalue_decoder_set_limits(NULL, 1, 1, 1);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_524: [ On success `amqpvalue_decoder_set_limits` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_limits_succeeds)
+{
+    // arrange
+    int result;
+    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
+    umock_c_reset_all_calls();
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_decoder_set_limits(amqpvalue_decoder, 1, 1, 1);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_binary(decoded_values[0], &actual_value);
-    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
-    stringify_bytes(&bytes[2], sizeof(bytes) - 2, expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_binary_zero_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_523: [ If the decoder is in the middle of decoding a value, `amqpvalue_decoder_set_limits` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decoder_set_limits_while_decoding_a_value_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA0 };
+    unsigned char partial_bytes[] = { 0xC0, 0x05, 0x02, 0x70 };
+    (void)amqpvalue_decode_bytes(amqpvalue_decoder, partial_bytes, sizeof(partial_bytes));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decoder_set_limits(amqpvalue_decoder, 1, 1, 1);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_binary_one_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_520: [ `amqpvalue_decoder_set_limits` shall limit, for each value decoded, how many values deep its items can be nested (`max_depth`), the total number of items declared by its lists, maps and arrays (`max_element_count`) and the total number of bytes allocated for it (`max_allocated_bytes`). ]*/
+TEST_FUNCTION(amqpvalue_decode_list_at_the_max_depth_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA0, 0x01 };
+    unsigned char bytes[] = { 0xC0, 0x04, 0x01, 0xC0, 0x01, 0x00 };
+    (void)amqpvalue_decoder_set_limits(amqpvalue_decoder, 1, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -12912,19 +18167,21 @@ TEST_FUNCTION(amqpvalue_decode_binary_one_byte_not_enough_bytes_does_not_trigger
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_allocating_memory_fails_then_amqpvalue_decode_binary_one_byte_fails)
+/* Tests_SRS_AMQPVALUE_01_520: [ `amqpvalue_decoder_set_limits` shall limit, for each value decoded, how many values deep its items can be nested (`max_depth`), the total number of items declared by its lists, maps and arrays (`max_element_count`) and the total number of bytes allocated for it (`max_allocated_bytes`). ]*/
+/* Tests_SRS_AMQPVALUE_01_525: [ When decoding a value would exceed any of the limits, the decoder shall fail before allocating memory for the part that exceeds it and `amqpvalue_decode_bytes` and `amqpvalue_decode_one` shall return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_list_nested_deeper_than_the_max_depth_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA0, 0x01, 0x42 };
+    unsigned char bytes[] = { 0xC0, 0x05, 0x01, 0xC0, 0x02, 0x01, 0x40 };
+    (void)amqpvalue_decoder_set_limits(amqpvalue_decoder, 1, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+        .IgnoreAllCalls();
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -12932,26 +18189,22 @@ TEST_FUNCTION(when_allocating_memory_fails_then_amqpvalue_decode_binary_one_byte
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, decoded_value_count);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_binary_255_bytes_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_525: [ When decoding a value would exceed any of the limits, the decoder shall fail before allocating memory for the part that exceeds it and `amqpvalue_decode_bytes` and `amqpvalue_decode_one` shall return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_list_declaring_more_items_than_the_max_element_count_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[254 + 2] = { 0xA0, 0xFF };
-    unsigned int i;
+    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x08, 0xFF, 0xFF, 0xFF, 0xF0 };
+    (void)amqpvalue_decoder_set_limits(amqpvalue_decoder, 0, 1000, 0);
     umock_c_reset_all_calls();
 
-    for (i = 0; i < 254; i++)
-    {
-        bytes[2 + i] = (unsigned char)i;
-    }
-
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
@@ -12961,55 +18214,47 @@ TEST_FUNCTION(amqpvalue_decode_binary_255_bytes_not_enough_bytes_does_not_trigge
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
-/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_zero_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_525: [ When decoding a value would exceed any of the limits, the decoder shall fail before allocating memory for the part that exceeds it and `amqpvalue_decode_bytes` and `amqpvalue_decode_one` shall return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_list_needing_more_than_the_max_allocated_bytes_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x00 };
-    amqp_binary actual_value = { NULL, 0 };
+    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x08, 0xFF, 0xFF, 0xFF, 0xF0 };
+    (void)amqpvalue_decoder_set_limits(amqpvalue_decoder, 0, 0, 4096);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_binary(decoded_values[0], &actual_value);
-    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
-    stringify_bytes(&bytes[0], 0, expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
-/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_1_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_526: [ The element count and the allocated bytes shall be counted separately for each top level value decoded. ]*/
+TEST_FUNCTION(amqpvalue_decode_2_lists_each_at_the_max_element_count_succeeds)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x01, 0x42 };
-    amqp_binary actual_value = { NULL, 0 };
+    unsigned char bytes[] = { 0xC0, 0x04, 0x03, 0x40, 0x40, 0x40, 0xC0, 0x04, 0x03, 0x40, 0x40, 0x40 };
+    (void)amqpvalue_decoder_set_limits(amqpvalue_decoder, 0, 3, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -13017,6 +18262,7 @@ TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_1_byte_succeeds)
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
@@ -13024,121 +18270,108 @@ TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_1_byte_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_binary(decoded_values[0], &actual_value);
-    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
-    stringify_bytes(&bytes[5], sizeof(bytes) - 5, expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_372: [1.6.19 binary A sequence of octets.] */
-/* Tests_SRS_AMQPVALUE_01_373: [<encoding name="vbin8" code="0xa0" category="variable" width="1" label="up to 2^8 - 1 octets of binary data"/>] */
-TEST_FUNCTION(amqpvalue_decode_binary_0xB0_value_256_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_527: [ `amqpvalue_decoder_reset` shall keep the limits set with `amqpvalue_decoder_set_limits`. ]*/
+TEST_FUNCTION(amqpvalue_decoder_reset_keeps_the_limits)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[256 + 5] = { 0xB0, 0x00, 0x00, 0x01, 0x00 };
-    int i;
-    amqp_binary actual_value = { NULL, 0 };
+    unsigned char bytes[] = { 0xC0, 0x04, 0x03, 0x40, 0x40, 0x40 };
+    (void)amqpvalue_decoder_set_limits(amqpvalue_decoder, 0, 2, 0);
+    (void)amqpvalue_decoder_reset(amqpvalue_decoder);
     umock_c_reset_all_calls();
 
-    for (i = 0; i < 256; i++)
-    {
-        bytes[5 + i] = i & 0xFF;
-    }
-
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
     result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BINARY, (int)amqpvalue_get_type(decoded_values[0]));
-    amqpvalue_get_binary(decoded_values[0], &actual_value);
-    stringify_bytes((const unsigned char*)actual_value.bytes, actual_value.length, actual_stringified);
-    stringify_bytes(&bytes[5], sizeof(bytes) - 5, expected_stringified);
-    ASSERT_ARE_EQUAL(char_ptr, expected_stringified, actual_stringified);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_binary_0xB0_zero_bytes_not_enough_bytes_does_not_trigger_callback)
+/* amqpvalue_decode_one */
+
+/* Tests_SRS_AMQPVALUE_01_498: [ If `handle`, `buffer` or `used_bytes` is NULL or `size` is 0, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x40 };
+    size_t used_bytes;
+
+    // act
+    result = amqpvalue_decode_one(NULL, bytes, sizeof(bytes), &used_bytes);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_498: [ If `handle`, `buffer` or `used_bytes` is NULL or `size` is 0, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_with_NULL_buffer_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB0 };
+    size_t used_bytes;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decode_one(amqpvalue_decoder, NULL, 1, &used_bytes);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_binary_0xB0_1_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_498: [ If `handle`, `buffer` or `used_bytes` is NULL or `size` is 0, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_with_0_size_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x01 };
+    unsigned char bytes[] = { 0x40 };
+    size_t used_bytes;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decode_one(amqpvalue_decoder, bytes, 0, &used_bytes);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_allocating_fails_then_amqpvalue_decode_binary_0xB0_1_byte_fails)
+/* Tests_SRS_AMQPVALUE_01_498: [ If `handle`, `buffer` or `used_bytes` is NULL or `size` is 0, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_with_NULL_used_bytes_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB0, 0x00, 0x00, 0x00, 0x01, 0x42 };
+    unsigned char bytes[] = { 0x40 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decode_one(amqpvalue_decoder, bytes, sizeof(bytes), NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -13148,1622 +18381,1562 @@ TEST_FUNCTION(when_allocating_fails_then_amqpvalue_decode_binary_0xB0_1_byte_fai
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_binary_0xB0_256_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_496: [ `amqpvalue_decode_one` shall decode the one complete value at the start of `buffer` in a single pass, calling on_value_decoded with it, and without touching the bytes that follow it. ]*/
+/* Tests_SRS_AMQPVALUE_01_497: [ On success `amqpvalue_decode_one` shall set `used_bytes` to the number of bytes taken by the value and return 0. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_decodes_a_described_list_and_leaves_the_payload)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 5] = { 0xB0, 0x00, 0x00, 0x01, 0x00 };
+    unsigned char bytes[] = { 0x00, 0x53, 0x70, 0xC0, 0x02, 0x01, 0x41, 0x00, 0x53, 0x75, 0xA0, 0x01, 0x42 };
+    size_t used_bytes;
+    uint32_t item_count;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decode_one(amqpvalue_decoder, bytes, sizeof(bytes), &used_bytes);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 7, used_bytes);
+    ASSERT_ARE_EQUAL(size_t, 1, decoded_value_count);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_composite_item_count(decoded_values[0], &item_count));
+    ASSERT_ARE_EQUAL(uint32_t, 1, item_count);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_zero_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_500: [ If the value is not complete in the `size` bytes or its constructor is not supported, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_with_an_incomplete_value_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA1, 0x00 };
-    const char* actual_value;
+    unsigned char bytes[] = { 0x00, 0x53, 0x70, 0xC0, 0x02, 0x01 };
+    size_t used_bytes;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decode_one(amqpvalue_decoder, bytes, sizeof(bytes), &used_bytes);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
+    ASSERT_ARE_EQUAL(size_t, 0, decoded_value_count);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_1_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_582: [ If decoding the declared size of the value does not end exactly with one complete value, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_AMQPVALUE_01_583: [ On failure `amqpvalue_decode_one` shall reset the decoder as `amqpvalue_decoder_reset` does, so that the next value can be decoded. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_with_a_list_size_larger_than_its_items_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA1, 0x01, 'a' };
-    const char* actual_value;
+    /* the list declares 5 bytes but its one item ends after 2, the bytes left look like another value */
+    unsigned char bytes[] = { 0x00, 0x53, 0x14, 0xC0, 0x05, 0x01, 0x40, 0x00, 0x53, 0x14, 0x45 };
+    unsigned char next_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+    size_t used_bytes;
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decode_one(amqpvalue_decoder, bytes, sizeof(bytes), &used_bytes);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
+    ASSERT_ARE_EQUAL(size_t, 1, decoded_value_count);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_decode_one(amqpvalue_decoder, next_bytes, sizeof(next_bytes), &used_bytes));
+    ASSERT_ARE_EQUAL(size_t, sizeof(next_bytes), used_bytes);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_255_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_582: [ If decoding the declared size of the value does not end exactly with one complete value, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_AMQPVALUE_01_583: [ On failure `amqpvalue_decode_one` shall reset the decoder as `amqpvalue_decoder_reset` does, so that the next value can be decoded. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_with_a_list_size_smaller_than_its_items_fails)
 {
     // arrange
     int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 2] = { 0xA1, 0xFF, 'x' };
-    const char* actual_value;
+    /* the list declares 2 bytes but its two items need 3 */
+    unsigned char bytes[] = { 0x00, 0x53, 0x14, 0xC0, 0x02, 0x02, 0x40, 0x40 };
+    unsigned char next_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+    size_t used_bytes;
     umock_c_reset_all_calls();
 
-    (void)memset(bytes + 2, 'x', 255);
-
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreAllCalls();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllCalls();
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_decode_one(amqpvalue_decoder, bytes, sizeof(bytes), &used_bytes);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
+    ASSERT_ARE_EQUAL(size_t, 0, decoded_value_count);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_decode_one(amqpvalue_decoder, next_bytes, sizeof(next_bytes), &used_bytes));
+    ASSERT_ARE_EQUAL(size_t, sizeof(next_bytes), used_bytes);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_376: [<encoding name="str8-utf8" code="0xa1" category="variable" width="1" label="up to 2^8 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xA1_value_2_bytes_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_499: [ If bytes of a previous value given to amqpvalue_decode_bytes are still pending, `amqpvalue_decode_one` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_decode_one_after_a_partial_amqpvalue_decode_bytes_fails)
 {
     // arrange
+    int result;
     AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA1, 0x02, 'a', 'b' };
-    int i;
-    const char* actual_value;
+    unsigned char partial_bytes[] = { 0x70, 0x00 };
+    unsigned char bytes[] = { 0x40 };
+    size_t used_bytes;
+    (void)amqpvalue_decode_bytes(amqpvalue_decoder, partial_bytes, sizeof(partial_bytes));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_decode_one(amqpvalue_decoder, bytes, sizeof(bytes), &used_bytes);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
 
     // cleanup
     amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_string_0xA1_zero_bytes_not_enough_bytes_does_not_trigger_callback)
+/* amqpvalue_get_encoded_value_size */
+
+/* Tests_SRS_AMQPVALUE_01_469: [ If `bytes` or `encoded_value_size` is NULL or `size` is 0, `amqpvalue_get_encoded_value_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_value_size_with_NULL_bytes_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA1 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    size_t encoded_value_size;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_get_encoded_value_size(NULL, 1, &encoded_value_size);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* Tests_SRS_AMQPVALUE_01_469: [ If `bytes` or `encoded_value_size` is NULL or `size` is 0, `amqpvalue_get_encoded_value_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_value_size_with_0_size_fails)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x40 };
+    size_t encoded_value_size;
+
+    // act
+    result = amqpvalue_get_encoded_value_size(bytes, 0, &encoded_value_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_string_0xA1_one_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_469: [ If `bytes` or `encoded_value_size` is NULL or `size` is 0, `amqpvalue_get_encoded_value_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_value_size_with_NULL_encoded_value_size_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA1, 0x01 };
-    umock_c_reset_all_calls();
+    unsigned char bytes[] = { 0x40 };
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    // act
+    result = amqpvalue_get_encoded_value_size(bytes, sizeof(bytes), NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_468: [ `amqpvalue_get_encoded_value_size` shall fill in `encoded_value_size` with the number of bytes taken by the encoded value at the start of `bytes`, without decoding it. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_value_size_for_a_described_list_succeeds)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x00, 0x53, 0x70, 0xC0, 0x02, 0x01, 0x41, 0x40 };
+    size_t encoded_value_size;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_get_encoded_value_size(bytes, sizeof(bytes), &encoded_value_size);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 7, encoded_value_size);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* Tests_SRS_AMQPVALUE_01_470: [ If the value is not complete in the `size` bytes or its constructor is not supported, `amqpvalue_get_encoded_value_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_value_size_for_an_incomplete_value_fails)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0xA0, 0x03, 0x01, 0x02 };
+    size_t encoded_value_size;
+
+    // act
+    result = amqpvalue_get_encoded_value_size(bytes, sizeof(bytes), &encoded_value_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_allocating_memory_fails_amqpvalue_decode_string_0xA1_one_byte_fails)
+/* Tests_SRS_AMQPVALUE_01_470: [ If the value is not complete in the `size` bytes or its constructor is not supported, `amqpvalue_get_encoded_value_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_get_encoded_value_size_for_an_unknown_constructor_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA1, 0x01, 'a' };
-    umock_c_reset_all_calls();
+    unsigned char bytes[] = { 0x01, 0x00 };
+    size_t encoded_value_size;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    // act
+    result = amqpvalue_get_encoded_value_size(bytes, sizeof(bytes), &encoded_value_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* amqpvalue_scan_described_values */
+
+/* Tests_SRS_AMQPVALUE_01_472: [ If `bytes` or `on_described_value_scanned` is NULL or `size` is 0, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_scan_described_values_with_NULL_bytes_fails)
+{
+    // arrange
+    int result;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_scan_described_values(NULL, 1, test_on_described_value_scanned, test_context);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* Tests_SRS_AMQPVALUE_01_472: [ If `bytes` or `on_described_value_scanned` is NULL or `size` is 0, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_scan_described_values_with_0_size_fails)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x00, 0x53, 0x70, 0x45 };
+
+    // act
+    result = amqpvalue_scan_described_values(bytes, 0, test_on_described_value_scanned, test_context);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_string_0xA1_255_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_472: [ If `bytes` or `on_described_value_scanned` is NULL or `size` is 0, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_scan_described_values_with_NULL_callback_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[254 + 2] = { 0xA1, 0xFF, 'x' };
-    umock_c_reset_all_calls();
+    unsigned char bytes[] = { 0x00, 0x53, 0x70, 0x45 };
 
-    (void)memset(bytes + 2, 'x', 254);
+    // act
+    result = amqpvalue_scan_described_values(bytes, sizeof(bytes), NULL, test_context);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_471: [ `amqpvalue_scan_described_values` shall call `on_described_value_scanned` for each described value encoded in `bytes`, in order, passing `callback_context`, the ulong descriptor and the span of the whole encoded value, without decoding the value. ]*/
+/* Tests_SRS_AMQPVALUE_01_475: [ On success `amqpvalue_scan_described_values` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_scan_described_values_reports_each_message_section)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] =
+    {
+        /* header */
+        0x00, 0x53, 0x70, 0xC0, 0x02, 0x01, 0x41,
+        /* application-properties */
+        0x00, 0x53, 0x74, 0xC1, 0x03, 0x02, 0xA1, 0x00,
+        /* data, with a ulong descriptor */
+        0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x75, 0xA0, 0x02, 0x01, 0x02
+    };
+    scanned_value_count = 0;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_scan_described_values(bytes, sizeof(bytes), test_on_described_value_scanned, test_context);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, scanned_value_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0x70, scanned_descriptor_codes[0]);
+    ASSERT_ARE_EQUAL(void_ptr, bytes, scanned_bytes[0]);
+    ASSERT_ARE_EQUAL(size_t, 7, scanned_sizes[0]);
+    ASSERT_ARE_EQUAL(uint64_t, 0x74, scanned_descriptor_codes[1]);
+    ASSERT_ARE_EQUAL(void_ptr, bytes + 7, scanned_bytes[1]);
+    ASSERT_ARE_EQUAL(size_t, 8, scanned_sizes[1]);
+    ASSERT_ARE_EQUAL(uint64_t, 0x75, scanned_descriptor_codes[2]);
+    ASSERT_ARE_EQUAL(void_ptr, bytes + 15, scanned_bytes[2]);
+    ASSERT_ARE_EQUAL(size_t, 14, scanned_sizes[2]);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* Tests_SRS_AMQPVALUE_01_473: [ If a value is not complete in the `size` bytes or its constructor is not supported, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_scan_described_values_with_an_incomplete_section_fails)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x00, 0x53, 0x70, 0xC0, 0x02, 0x01 };
+    scanned_value_count = 0;
+
+    // act
+    result = amqpvalue_scan_described_values(bytes, sizeof(bytes), test_on_described_value_scanned, test_context);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, scanned_value_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_zero_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_474: [ If a value is not a described value with an ulong descriptor, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_scan_described_values_with_a_value_that_is_not_described_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x00 };
-    const char* actual_value;
-    umock_c_reset_all_calls();
+    unsigned char bytes[] = { 0x52, 0x01 };
+    scanned_value_count = 0;
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    // act
+    result = amqpvalue_scan_described_values(bytes, sizeof(bytes), test_on_described_value_scanned, test_context);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, scanned_value_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_AMQPVALUE_01_474: [ If a value is not a described value with an ulong descriptor, `amqpvalue_scan_described_values` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_scan_described_values_with_a_symbol_descriptor_fails)
+{
+    // arrange
+    int result;
+    unsigned char bytes[] = { 0x00, 0xA3, 0x01, 0x61, 0x40 };
+    scanned_value_count = 0;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_scan_described_values(bytes, sizeof(bytes), test_on_described_value_scanned, test_context);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, scanned_value_count);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_1_byte_succeeds)
+/* amqpvalue_make_writable */
+
+/* Tests_SRS_AMQPVALUE_01_433: [ If `value` or `*value` is NULL, `amqpvalue_make_writable` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_make_writable_with_NULL_value_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x01, 'a' };
-    const char* actual_value;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_make_writable(NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_255_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_433: [ If `value` or `*value` is NULL, `amqpvalue_make_writable` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_make_writable_with_NULL_amqp_value_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 5] = { 0xB1, 0x00, 0x00, 0x00, 0xFF, 'x' };
-    const char* actual_value;
-    umock_c_reset_all_calls();
-
-    (void)memset(bytes + 5, 'x', 255);
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    AMQP_VALUE value = NULL;
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_make_writable(&value);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_256_bytes_succeeds)
+/* Tests_SRS_AMQPVALUE_01_434: [ If the caller holds the only reference to `*value`, `amqpvalue_make_writable` shall leave it untouched and return 0. ]*/
+TEST_FUNCTION(amqpvalue_make_writable_on_an_unshared_value_does_not_copy_it)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[256 + 5] = { 0xB1, 0x00, 0x00, 0x01, 0x00, 'x' };
-    const char* actual_value;
+    AMQP_VALUE value = amqpvalue_create_uint(42);
+    AMQP_VALUE original = value;
     umock_c_reset_all_calls();
 
-    (void)memset(bytes + 5, 'x', 256);
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_make_writable(&value);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, original, value);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxx", actual_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(value);
 }
 
-/* Tests_SRS_AMQPVALUE_01_375: [1.6.20 string A sequence of Unicode characters.] */
-/* Tests_SRS_AMQPVALUE_01_377: [<encoding name="str32-utf8" code="0xb1" category="variable" width="4" label="up to 2^32 - 1 octets worth of UTF-8 Unicode (with no byte order mark)"/>] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_value_2_bytes_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_432: [ If `*value` is shared with other holders, `amqpvalue_make_writable` shall replace it with a copy that only the caller references, releasing the caller's reference to the original. ]*/
+TEST_FUNCTION(amqpvalue_make_writable_on_a_shared_list_copies_the_list)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x02, 'a', 'b' };
-    int i;
-    const char* actual_value;
+    int result;
+    AMQP_VALUE item = amqpvalue_create_uint(1);
+    AMQP_VALUE new_item = amqpvalue_create_uint(2);
+    AMQP_VALUE list = amqpvalue_create_list();
+    AMQP_VALUE clone;
+    AMQP_VALUE original_item;
+    uint32_t item_value;
+    (void)amqpvalue_set_list_item(list, 0, item);
+    clone = amqpvalue_clone(list);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqpvalue_make_writable(&clone);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, list, clone);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_string(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
+    (void)amqpvalue_set_list_item(clone, 0, new_item);
+    original_item = amqpvalue_get_list_item(list, 0);
+    (void)amqpvalue_get_uint(original_item, &item_value);
+    ASSERT_ARE_EQUAL(uint32_t, 1, item_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(original_item);
+    amqpvalue_destroy(item);
+    amqpvalue_destroy(new_item);
+    amqpvalue_destroy(list);
+    amqpvalue_destroy(clone);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_zero_bytes_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_436: [ For a described or composite value, the described value shall also be made writable. ]*/
+TEST_FUNCTION(setting_an_item_on_a_writable_composite_does_not_change_the_shared_original)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB1 };
+    AMQP_VALUE composite = amqpvalue_create_composite_with_ulong_descriptor(0x73);
+    AMQP_VALUE item = amqpvalue_create_uint(1);
+    AMQP_VALUE clone = amqpvalue_clone(composite);
+    AMQP_VALUE original_item;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_make_writable(&clone);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(void_ptr, composite, clone);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_set_composite_item(clone, 0, item));
+    original_item = amqpvalue_get_composite_item_in_place(composite, 0);
+    ASSERT_IS_NULL(original_item);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(item);
+    amqpvalue_destroy(composite);
+    amqpvalue_destroy(clone);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_one_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_505: [ If `value` or `item_value` is NULL, `amqpvalue_set_composite_item_move` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_set_composite_item_move_with_NULL_value_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x01 };
+    AMQP_VALUE item = amqpvalue_create_uint(1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_set_composite_item_move(NULL, 0, item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_string_0xB1_255_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_505: [ If `value` or `item_value` is NULL, `amqpvalue_set_composite_item_move` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_set_composite_item_move_with_NULL_item_value_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 5] = { 0xB1, 0x00, 0x00, 0x01, 0x00, 'x' };
+    AMQP_VALUE composite = amqpvalue_create_composite_with_ulong_descriptor(0x14);
     umock_c_reset_all_calls();
 
-    (void)memset(bytes + 5, 'x', 255);
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_set_composite_item_move(composite, 0, NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(composite);
 }
 
-/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_gballoc_malloc_fails_then_amqpvalue_decode_string_0xB1_one_byte_fails)
+/* Tests_SRS_AMQPVALUE_01_506: [ If `value` is not a composite, `amqpvalue_set_composite_item_move` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqpvalue_set_composite_item_move_on_a_list_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB1, 0x00, 0x00, 0x00, 0x01, 'a' };
+    AMQP_VALUE list = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_uint(1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_set_composite_item_move(list, 0, item);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(item);
+    amqpvalue_destroy(list);
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_zero_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_507: [ `amqpvalue_set_composite_item_move` shall store `item_value` itself at the `index`-th position, without cloning it, and the composite shall own it from then on. ]*/
+/* Tests_SRS_AMQPVALUE_01_509: [ On success `amqpvalue_set_composite_item_move` shall return 0. ]*/
+TEST_FUNCTION(amqpvalue_set_composite_item_move_stores_the_item_without_cloning_it)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA3, 0x00 };
-    const char* actual_value;
+    AMQP_VALUE composite = amqpvalue_create_composite_with_ulong_descriptor(0x14);
+    AMQP_VALUE item = amqpvalue_create_uint(42);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_set_composite_item_move(composite, 0, item);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
+    ASSERT_ARE_EQUAL(void_ptr, item, amqpvalue_get_composite_item_in_place(composite, 0));
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(composite);
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_1_char_succeeds)
+/* Tests_SRS_AMQPVALUE_01_508: [ On failure `amqpvalue_set_composite_item_move` shall leave the composite unchanged and `item_value` owned by the caller. ]*/
+TEST_FUNCTION(when_growing_the_list_fails_amqpvalue_set_composite_item_move_leaves_the_item_to_the_caller)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA3, 0x01, 'a' };
-    const char* actual_value;
+    uint32_t item_count;
+    uint32_t item_value;
+    AMQP_VALUE composite = amqpvalue_create_composite_with_ulong_descriptor(0x14);
+    AMQP_VALUE item = amqpvalue_create_uint(42);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqpvalue_set_composite_item_move(composite, 0, item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_composite_item_count(composite, &item_count));
+    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
+    ASSERT_ARE_EQUAL(int, 0, amqpvalue_get_uint(item, &item_value));
+    ASSERT_ARE_EQUAL(uint32_t, 42, item_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(item);
+    amqpvalue_destroy(composite);
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_255_chars_succeeds)
+/* amqp_writer */
+
+/* Tests_SRS_AMQPVALUE_01_529: [ If `writer` or `buffer` is NULL, `amqp_writer_init` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_init_with_NULL_writer_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 2] = { 0xA3, 0xFF, 'x' };
-    const char* actual_value;
-    umock_c_reset_all_calls();
-
-    (void)memset(bytes + 2, 'x', 255);
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    unsigned char buffer[16];
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_init(NULL, buffer, sizeof(buffer));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_379: [<encoding name="sym8" code="0xa3" category="variable" width="1" label="up to 2^8 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_value_2_chars_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_529: [ If `writer` or `buffer` is NULL, `amqp_writer_init` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_init_with_NULL_buffer_fails)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA3, 0x02, 'a', 'b' };
-    int i;
-    const char* actual_value;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    int result;
+    AMQP_WRITER writer;
 
-    // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    // act
+    result = amqp_writer_init(&writer, NULL, 16);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_zero_bytes_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_528: [ `amqp_writer_init` shall set up `writer` to encode values into the `buffer_size` bytes of `buffer`, starting at its first byte, and return 0. ]*/
+/* Tests_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+/* Tests_SRS_AMQPVALUE_01_543: [ `amqp_writer_get_length` shall fill in `length` with the number of bytes written and return 0. ]*/
+TEST_FUNCTION(amqp_writer_puts_values_one_after_the_other)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[64];
+    unsigned char expected_bytes[] = { 0x40, 0x41, 0x50, 0x07, 0x43, 0x52, 0xFF, 0x70, 0x00, 0x00, 0x01, 0x00, 0x44, 0x54, 0xFB, 0x55, 0x02, 0x83, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0xA1, 0x02, 'h', 'i', 0xA3, 0x01, 'x', 0xA0, 0x01, 0x42 };
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA3 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_put_null(&writer);
+    result |= amqp_writer_put_boolean(&writer, true);
+    result |= amqp_writer_put_ubyte(&writer, 7);
+    result |= amqp_writer_put_uint(&writer, 0);
+    result |= amqp_writer_put_uint(&writer, 255);
+    result |= amqp_writer_put_uint(&writer, 256);
+    result |= amqp_writer_put_ulong(&writer, 0);
+    result |= amqp_writer_put_int(&writer, -5);
+    result |= amqp_writer_put_long(&writer, 2);
+    result |= amqp_writer_put_timestamp(&writer, 42);
+    result |= amqp_writer_put_string(&writer, "hi");
+    result |= amqp_writer_put_symbol(&writer, "x");
+    result |= amqp_writer_put_binary(&writer, "\x42", 1);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_one_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_534: [ `amqp_writer_begin_list` shall write the list32 constructor 0xD0 and leave room for the size and the count of the list, which are filled in by `amqp_writer_end`. ]*/
+/* Tests_SRS_AMQPVALUE_01_536: [ Every value, list, map or described value written while a list or map is open shall be counted as one item of the innermost one, keys and values each counting as one item of a map. ]*/
+/* Tests_SRS_AMQPVALUE_01_537: [ `amqp_writer_end` shall end the innermost open list or map by filling in its size, the number of bytes after the size field, and its item count, and return 0. ]*/
+TEST_FUNCTION(amqp_writer_end_fills_in_the_size_and_count_of_a_list)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[64];
+    unsigned char expected_bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x02, 0x40, 0x41 };
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA3, 0x01 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_begin_list(&writer);
+    result |= amqp_writer_put_null(&writer);
+    result |= amqp_writer_put_boolean(&writer, true);
+    result |= amqp_writer_end(&writer);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
 }
 
-/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_allocating_memory_fails_amqpvalue_decode_symbol_0xA3_one_byte_fails)
+/* Tests_SRS_AMQPVALUE_01_535: [ `amqp_writer_begin_map` shall write the map32 constructor 0xD1 and leave room for the size and the count of the map, which are filled in by `amqp_writer_end`. ]*/
+/* Tests_SRS_AMQPVALUE_01_536: [ Every value, list, map or described value written while a list or map is open shall be counted as one item of the innermost one, keys and values each counting as one item of a map. ]*/
+TEST_FUNCTION(amqp_writer_counts_the_keys_and_values_of_a_map_nested_in_a_list)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[64];
+    unsigned char expected_bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x02, 0xD1, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x02, 0xA3, 0x01, 'k', 0x52, 0x01, 0x43 };
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xA3, 0x01, 'a' };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_begin_list(&writer);
+    result |= amqp_writer_begin_map(&writer);
+    result |= amqp_writer_put_symbol(&writer, "k");
+    result |= amqp_writer_put_uint(&writer, 1);
+    result |= amqp_writer_end(&writer);
+    result |= amqp_writer_put_uint(&writer, 0);
+    result |= amqp_writer_end(&writer);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xA3_255_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_541: [ `amqp_writer_begin_described` shall write the descriptor constructor 0x00 followed by `descriptor` encoded as an ulong, the next value, list or map written being the described value. ]*/
+TEST_FUNCTION(amqp_writer_writes_a_described_list_that_decodes_as_a_composite)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[64];
+    unsigned char expected_bytes[] = { 0x00, 0x53, 0x10, 0xD0, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x01, 0xA1, 0x01, 'c' };
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[254 + 2] = { 0xA3, 0xFF, 'x' };
-    umock_c_reset_all_calls();
-
-    (void)memset(bytes + 2, 'x', 254);
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_begin_described(&writer, 0x10);
+    result |= amqp_writer_begin_list(&writer);
+    result |= amqp_writer_put_string(&writer, "c");
+    result |= amqp_writer_end(&writer);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_zero_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_536: [ Every value, list, map or described value written while a list or map is open shall be counted as one item of the innermost one, keys and values each counting as one item of a map. ]*/
+TEST_FUNCTION(amqp_writer_counts_a_described_value_in_a_list_as_one_item)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[64];
+    unsigned char expected_bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x02, 0x00, 0x53, 0x70, 0x40, 0x40 };
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x00 };
-    const char* actual_value;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_begin_list(&writer);
+    result |= amqp_writer_begin_described(&writer, 0x70);
+    result |= amqp_writer_put_null(&writer);
+    result |= amqp_writer_put_null(&writer);
+    result |= amqp_writer_end(&writer);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_1_char_succeeds)
+/* Tests_SRS_AMQPVALUE_01_542: [ `amqp_writer_put_value` shall encode `value` by calling `amqpvalue_encode`. ]*/
+TEST_FUNCTION(amqp_writer_put_value_encodes_an_amqp_value)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[64];
+    unsigned char expected_bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x01, 0xC0, 0x02, 0x01, 0x41 };
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x01, 'a' };
-    const char* actual_value;
+    AMQP_VALUE list = amqpvalue_create_list();
+    AMQP_VALUE item = amqpvalue_create_boolean(true);
+    (void)amqpvalue_set_list_item(list, 0, item);
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
-
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_begin_list(&writer);
+    result |= amqp_writer_put_value(&writer, list);
+    result |= amqp_writer_end(&writer);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "a", actual_value);
 
     // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    amqpvalue_destroy(list);
+    amqpvalue_destroy(item);
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_255_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_531: [ If `value` is NULL for `amqp_writer_put_string`, `amqp_writer_put_symbol` or `amqp_writer_put_value`, or if `bytes` is NULL and `length` is not 0 for `amqp_writer_put_binary`, the function shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_put_string_with_NULL_value_fails)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[16];
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 5] = { 0xB3, 0x00, 0x00, 0x00, 0xFF, 'x' };
-    const char* actual_value;
-    umock_c_reset_all_calls();
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
-    (void)memset(bytes + 5, 'x', 255);
+    // act
+    result = amqp_writer_put_string(&writer, NULL);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_531: [ If `value` is NULL for `amqp_writer_put_string`, `amqp_writer_put_symbol` or `amqp_writer_put_value`, or if `bytes` is NULL and `length` is not 0 for `amqp_writer_put_binary`, the function shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_put_binary_with_NULL_bytes_and_non_zero_length_fails)
+{
+    // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[16];
+    int result;
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_put_binary(&writer, NULL, 1);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxx", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_256_chars_succeeds)
+/* Tests_SRS_AMQPVALUE_01_532: [ If `writer` is NULL, the `amqp_writer` functions shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_put_uint_with_NULL_writer_fails)
 {
     // arrange
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[256 + 5] = { 0xB3, 0x00, 0x00, 0x01, 0x00, 'x' };
-    const char* actual_value;
-    umock_c_reset_all_calls();
 
-    (void)memset(bytes + 5, 'x', 256);
+    // act
+    result = amqp_writer_put_uint(NULL, 1);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_533: [ When an `amqp_writer` function fails on a non-NULL writer, for example because the encoded value does not fit in the rest of the buffer, the writer shall be failed and every later call other than `amqp_writer_init` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_a_value_does_not_fit_the_writer_fails_for_all_later_calls)
+{
+    // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[4];
+    size_t length;
+    int result1;
+    int result2;
+    int result3;
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result1 = amqp_writer_put_string(&writer, "hello");
+    result2 = amqp_writer_put_null(&writer);
+    result3 = amqp_writer_get_length(&writer, &length);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
-        "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" "xxxxxx", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
 }
 
-/* Tests_SRS_AMQPVALUE_01_378: [1.6.21 symbol Symbolic values from a constrained domain.] */
-/* Tests_SRS_AMQPVALUE_01_380: [<encoding name="sym32" code="0xb3" category="variable" width="4" label="up to 2^32 - 1 seven bit ASCII characters representing a symbolic value"/>] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_value_2_chars_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_538: [ If no list or map is open, or if a described value was begun and its value was not written, `amqp_writer_end` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_end_without_an_open_list_fails)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x02, 'a', 'b' };
-    int i;
-    const char* actual_value;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    AMQP_WRITER writer;
+    unsigned char buffer[16];
+    int result;
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqp_writer_end(&writer);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_symbol(decoded_values[0], &actual_value);
-    ASSERT_ARE_EQUAL(char_ptr, "ab", actual_value);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_zero_bytes_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_538: [ If no list or map is open, or if a described value was begun and its value was not written, `amqp_writer_end` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_end_with_a_described_value_pending_fails)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[32];
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB3 };
-    umock_c_reset_all_calls();
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
+    (void)amqp_writer_begin_list(&writer);
+    (void)amqp_writer_begin_described(&writer, 0x70);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    // act
+    result = amqp_writer_end(&writer);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_539: [ If the map being ended has an odd number of items, `amqp_writer_end` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_end_of_a_map_with_a_key_without_value_fails)
+{
+    // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[32];
+    int result;
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
+    (void)amqp_writer_begin_map(&writer);
+    (void)amqp_writer_put_symbol(&writer, "k");
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_end(&writer);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* Tests_SRS_AMQPVALUE_01_540: [ If `AMQP_WRITER_MAX_DEPTH` lists and maps are already open, `amqp_writer_begin_list` and `amqp_writer_begin_map` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_begin_list_beyond_the_max_depth_fails)
+{
+    // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[128];
+    size_t i;
+    int result;
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
+    for (i = 0; i < AMQP_WRITER_MAX_DEPTH; i++)
+    {
+        (void)amqp_writer_begin_list(&writer);
+    }
+
+    // act
+    result = amqp_writer_begin_list(&writer);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_one_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_544: [ If `writer` or `length` is NULL, if the writer failed, or if a list, map or described value is not complete, `amqp_writer_get_length` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_get_length_with_an_open_list_fails)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[32];
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x01 };
-    umock_c_reset_all_calls();
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
+    (void)amqp_writer_begin_list(&writer);
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    // act
+    result = amqp_writer_get_length(&writer, &length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_AMQPVALUE_01_544: [ If `writer` or `length` is NULL, if the writer failed, or if a list, map or described value is not complete, `amqp_writer_get_length` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_get_length_with_NULL_length_fails)
+{
+    // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[32];
+    int result;
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_get_length(&writer, NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_symbol_0xB3_255_byte_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_576: [ `amqp_writer_put_string_n` shall encode the `length` characters at `value`, which need not be NUL terminated, as a string. ]*/
+TEST_FUNCTION(amqp_writer_put_string_n_writes_the_given_characters)
 {
     // arrange
+    static const unsigned char expected_bytes[] = { 0xA1, 0x02, 'a', 'b' };
+    AMQP_WRITER writer;
+    unsigned char buffer[16];
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[255 + 5] = { 0xB3, 0x00, 0x00, 0x01, 0x00, 'x' };
-    umock_c_reset_all_calls();
-
-    (void)memset(bytes + 5, 'x', 255);
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_put_string_n(&writer, "abc", 2);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
 }
 
-/* Tests_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_gballoc_malloc_fails_then_amqpvalue_decode_symbol_0xB3_one_byte_fails)
+/* Tests_SRS_AMQPVALUE_01_577: [ If `value` is NULL and `length` is not 0, `amqp_writer_put_string_n` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_put_string_n_with_NULL_value_and_non_zero_length_fails)
 {
     // arrange
+    AMQP_WRITER writer;
+    unsigned char buffer[16];
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xB3, 0x00, 0x00, 0x00, 0x01, 'a' };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_put_string_n(&writer, NULL, 1);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_384: [<encoding name="list0" code="0x45" category="fixed" width="0" label="the empty list (i.e. the list with no elements)"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_empty_list_succeeds)
+/* Tests_SRS_AMQPVALUE_01_530: [ The `amqp_writer_put` functions shall encode the value at the current position of the writer like `amqpvalue_encode` encodes a value of the same type, and return 0 on success. ]*/
+TEST_FUNCTION(amqp_writer_put_double_writes_a_double)
 {
     // arrange
+    static const unsigned char expected_bytes[] = { 0x82, 0x3F, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    AMQP_WRITER writer;
+    unsigned char buffer[16];
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0x45 };
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_put_double(&writer, 1.5);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_zero_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_579: [ `amqp_writer_put_encoded` shall copy the `length` bytes at `bytes`, holding `count` encoded values, at the current position of the writer, without checking them. ]*/
+/* Tests_SRS_AMQPVALUE_01_581: [ The `count` values shall be counted as `count` items of the innermost open list or map. ]*/
+TEST_FUNCTION(amqp_writer_put_encoded_copies_the_values_and_counts_them_in_the_list)
 {
     // arrange
+    static const unsigned char encoded_values[] = { 0x40, 0x52, 0x05 };
+    static const unsigned char expected_bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x03, 0x41, 0x40, 0x52, 0x05 };
+    AMQP_WRITER writer;
+    unsigned char buffer[32];
+    size_t length;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xC0, 0x00, 0x00 };
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_begin_list(&writer);
+    result |= amqp_writer_put_boolean(&writer, true);
+    result |= amqp_writer_put_encoded(&writer, encoded_values, sizeof(encoded_values), 2);
+    result |= amqp_writer_end(&writer);
+    result |= amqp_writer_get_length(&writer, &length);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, buffer, sizeof(expected_bytes)));
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_1_null_item_succeeds)
+/* Tests_SRS_AMQPVALUE_01_580: [ If `bytes` is NULL, or `length` or `count` is 0, `amqp_writer_put_encoded` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_writer_put_encoded_with_0_count_fails)
 {
     // arrange
+    static const unsigned char encoded_values[] = { 0x40 };
+    AMQP_WRITER writer;
+    unsigned char buffer[16];
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xC0, 0x01, 0x01, 0x40 };
-    uint32_t item_count;
-    AMQP_VALUE item1;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_writer_put_encoded(&writer, encoded_values, sizeof(encoded_values), 0);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    item1 = amqpvalue_get_list_item(decoded_values[0], 0);
-    ASSERT_ARE_EQUAL(uint32_t, 1, item_count);
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item1));
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
-    amqpvalue_destroy(item1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_2_null_items_succeeds)
+/* amqp_reader */
+
+/* Tests_SRS_AMQPVALUE_01_546: [ If `reader` or `buffer` is NULL, `amqp_reader_init` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_init_with_NULL_reader_fails)
 {
     // arrange
+    unsigned char buffer[] = { 0x40 };
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xC0, 0x02, 0x02, 0x40, 0x40 };
-    uint32_t item_count;
-    AMQP_VALUE item1;
-    AMQP_VALUE item2;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_init(NULL, buffer, sizeof(buffer));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 2, item_count);
-    item1 = amqpvalue_get_list_item(decoded_values[0], 0);
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item1));
-    item2 = amqpvalue_get_list_item(decoded_values[0], 1);
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item2));
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
-    amqpvalue_destroy(item1);
-    amqpvalue_destroy(item2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_255_null_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_546: [ If `reader` or `buffer` is NULL, `amqp_reader_init` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_init_with_NULL_buffer_fails)
 {
     // arrange
+    AMQP_READER reader;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[3 + 255] = { 0xC0, 0xFF, 0xFF };
-    int i;
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-    (void)memset(&bytes[3], 0x40, 255);
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_init(&reader, NULL, 1);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 255, item_count);
-    for (i = 0; i < 255; i++)
-    {
-        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], 0);
-        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
-        amqpvalue_destroy(item);
-    }
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_385: [<encoding name="list8" code="0xc0" category="compound" width="1" label="up to 2^8 - 1 list elements with total size less than 2^8 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_255_null_items_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_545: [ `amqp_reader_init` shall set up `reader` to read the values encoded in the `buffer_size` bytes of `buffer`, starting at its first byte, and return 0. ]*/
+/* Tests_SRS_AMQPVALUE_01_547: [ `amqp_reader_has_next` shall return true when the innermost container entered has items left or, when no container is entered, when bytes are left in the buffer. ]*/
+/* Tests_SRS_AMQPVALUE_01_549: [ `amqp_reader_next` shall fill in `item` with the type, constructor and a view of the next value, borrowed from the buffer, move past the value, a list, map, array or described value included, and return 0. ]*/
+TEST_FUNCTION(amqp_reader_next_reads_scalars_one_after_the_other)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[3 + 255] = { 0xC0, 0xFF, 0xFF };
-    int i;
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-    (void)memset(&bytes[3], 0x40, 255);
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    unsigned char buffer[] = { 0x40, 0x41, 0x56, 0x00, 0x52, 0xFF, 0x70, 0x00, 0x00, 0x01, 0x00, 0x44, 0x54, 0xFB, 0x81, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0x83, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A };
+    AMQP_READER reader;
+    AMQP_READER_ITEM items[9];
+    size_t i;
+    int result;
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
+    result = 0;
+    for (i = 0; i < 9; i++)
     {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
+        result |= amqp_reader_next(&reader, &items[i]);
     }
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 255, item_count);
-    for (i = 0; i < 255; i++)
-    {
-        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
-        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
-        amqpvalue_destroy(item);
-    }
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(amqp_reader_has_next(&reader));
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)items[0].type);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)items[1].type);
+    ASSERT_IS_TRUE(items[1].value.bool_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)items[2].type);
+    ASSERT_IS_FALSE(items[2].value.bool_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)items[3].type);
+    ASSERT_ARE_EQUAL(uint64_t, 255, items[3].value.unsigned_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)items[4].type);
+    ASSERT_ARE_EQUAL(uint64_t, 256, items[4].value.unsigned_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)items[5].type);
+    ASSERT_ARE_EQUAL(uint64_t, 0, items[5].value.unsigned_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_INT, (int)items[6].type);
+    ASSERT_ARE_EQUAL(int64_t, -5, items[6].value.signed_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LONG, (int)items[7].type);
+    ASSERT_ARE_EQUAL(int64_t, -2, items[7].value.signed_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_TIMESTAMP, (int)items[8].type);
+    ASSERT_ARE_EQUAL(int64_t, 42, items[8].value.signed_value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_549: [ `amqp_reader_next` shall fill in `item` with the type, constructor and a view of the next value, borrowed from the buffer, move past the value, a list, map, array or described value included, and return 0. ]*/
+TEST_FUNCTION(amqp_reader_next_gives_the_characters_of_a_string_in_place)
+{
+    // arrange
+    unsigned char buffer[] = { 0xA1, 0x02, 'h', 'i', 0xB3, 0x00, 0x00, 0x00, 0x01, 'x' };
+    AMQP_READER reader;
+    AMQP_READER_ITEM string_item;
+    AMQP_READER_ITEM symbol_item;
+    int result;
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    // act
+    result = amqp_reader_next(&reader, &string_item);
+    result |= amqp_reader_next(&reader, &symbol_item);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_STRING, (int)string_item.type);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)(buffer + 2), (void*)string_item.bytes);
+    ASSERT_ARE_EQUAL(uint32_t, 2, string_item.length);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)symbol_item.type);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)(buffer + 9), (void*)symbol_item.bytes);
+    ASSERT_ARE_EQUAL(uint32_t, 1, symbol_item.length);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_zero_items_not_enough_bytes_does_not_trigger_callback_succeeds)
+/* Tests_SRS_AMQPVALUE_01_549: [ `amqp_reader_next` shall fill in `item` with the type, constructor and a view of the next value, borrowed from the buffer, move past the value, a list, map, array or described value included, and return 0. ]*/
+TEST_FUNCTION(amqp_reader_next_skips_a_list_that_is_not_entered)
 {
     // arrange
+    unsigned char buffer[] = { 0xC0, 0x04, 0x02, 0x41, 0x52, 0x07, 0x50, 0x09 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM list_item;
+    AMQP_READER_ITEM next_item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xC0, 0x00 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_next(&reader, &list_item);
+    result |= amqp_reader_next(&reader, &next_item);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)list_item.type);
+    ASSERT_ARE_EQUAL(uint32_t, 2, list_item.count);
+    ASSERT_ARE_EQUAL(uint32_t, 3, list_item.length);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)next_item.type);
+    ASSERT_ARE_EQUAL(uint64_t, 9, next_item.value.unsigned_value);
+}
+
+/* Tests_SRS_AMQPVALUE_01_554: [ `amqp_reader_enter` shall make the items of `item`, which has to be the item just returned by `amqp_reader_next`, the next ones returned by `amqp_reader_next`, and return 0. ]*/
+/* Tests_SRS_AMQPVALUE_01_555: [ `amqp_reader_leave` shall skip the items left in the innermost container entered, continue with the item after it and return 0. ]*/
+TEST_FUNCTION(amqp_reader_enter_and_leave_walk_a_map_nested_in_a_list)
+{
+    // arrange
+    unsigned char buffer[] = { 0xC0, 0x0A, 0x02, 0xC1, 0x06, 0x02, 0xA3, 0x01, 'k', 0x52, 0x05, 0x41, 0x40 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM list_item;
+    AMQP_READER_ITEM map_item;
+    AMQP_READER_ITEM key_item;
+    AMQP_READER_ITEM value_item;
+    AMQP_READER_ITEM last_list_item;
+    AMQP_READER_ITEM after_list_item;
+    int result;
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    // act
+    result = amqp_reader_next(&reader, &list_item);
+    result |= amqp_reader_enter(&reader, &list_item);
+    result |= amqp_reader_next(&reader, &map_item);
+    result |= amqp_reader_enter(&reader, &map_item);
+    result |= amqp_reader_next(&reader, &key_item);
+    result |= amqp_reader_next(&reader, &value_item);
+    result |= amqp_reader_leave(&reader);
+    result |= amqp_reader_next(&reader, &last_list_item);
+    result |= amqp_reader_leave(&reader);
+    result |= amqp_reader_next(&reader, &after_list_item);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_MAP, (int)map_item.type);
+    ASSERT_ARE_EQUAL(uint32_t, 2, map_item.count);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_SYMBOL, (int)key_item.type);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UINT, (int)value_item.type);
+    ASSERT_ARE_EQUAL(uint64_t, 5, value_item.value.unsigned_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_BOOL, (int)last_list_item.type);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)after_list_item.type);
+    ASSERT_IS_FALSE(amqp_reader_has_next(&reader));
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_1_item_not_enough_bytes_does_not_trigger_callback_succeeds)
+/* Tests_SRS_AMQPVALUE_01_555: [ `amqp_reader_leave` shall skip the items left in the innermost container entered, continue with the item after it and return 0. ]*/
+TEST_FUNCTION(amqp_reader_leave_skips_the_items_left_in_a_list)
 {
     // arrange
+    unsigned char buffer[] = { 0xC0, 0x05, 0x03, 0x41, 0x42, 0x52, 0x07, 0x50, 0x09 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM list_item;
+    AMQP_READER_ITEM first_item;
+    AMQP_READER_ITEM after_list_item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xC0, 0x01, 0x01 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &list_item);
+    (void)amqp_reader_enter(&reader, &list_item);
+    (void)amqp_reader_next(&reader, &first_item);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_leave(&reader);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(int, 0, amqp_reader_next(&reader, &after_list_item));
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)after_list_item.type);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_list_0xC0_255_null_items_not_enough_bytes_does_not_trigger_callback_succeeds)
+/* Tests_SRS_AMQPVALUE_01_553: [ The items of an array shall be read with the constructor the array gives once for all of them. ]*/
+TEST_FUNCTION(amqp_reader_reads_the_items_of_an_array_with_the_shared_constructor)
 {
     // arrange
+    unsigned char buffer[] = { 0xE0, 0x04, 0x02, 0x50, 0x01, 0x02 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM array_item;
+    AMQP_READER_ITEM first_item;
+    AMQP_READER_ITEM second_item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[3 + 254] = { 0xC0, 0xFF, 0xFF };
-    umock_c_reset_all_calls();
-    (void)memset(&bytes[3], 0x40, 254);
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &array_item);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_enter(&reader, &array_item);
+    result |= amqp_reader_next(&reader, &first_item);
+    result |= amqp_reader_next(&reader, &second_item);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ARRAY, (int)array_item.type);
+    ASSERT_ARE_EQUAL(uint32_t, 2, array_item.count);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_UBYTE, (int)first_item.type);
+    ASSERT_ARE_EQUAL(uint64_t, 1, first_item.value.unsigned_value);
+    ASSERT_ARE_EQUAL(uint64_t, 2, second_item.value.unsigned_value);
+    ASSERT_IS_FALSE(amqp_reader_has_next(&reader));
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_zero_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_551: [ A described value shall be returned as an item of type `AMQP_TYPE_DESCRIBED` with 2 items, its descriptor and its value. ]*/
+TEST_FUNCTION(amqp_reader_reads_the_descriptor_and_value_of_a_described_value)
 {
     // arrange
+    unsigned char buffer[] = { 0x00, 0x53, 0x10, 0x45 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM described_item;
+    AMQP_READER_ITEM descriptor_item;
+    AMQP_READER_ITEM value_item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    uint32_t item_count;
-    umock_c_reset_all_calls();
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    // act
+    result = amqp_reader_next(&reader, &described_item);
+    result |= amqp_reader_enter(&reader, &described_item);
+    result |= amqp_reader_next(&reader, &descriptor_item);
+    result |= amqp_reader_next(&reader, &value_item);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_DESCRIBED, (int)described_item.type);
+    ASSERT_ARE_EQUAL(uint32_t, 2, described_item.count);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_ULONG, (int)descriptor_item.type);
+    ASSERT_ARE_EQUAL(uint64_t, 0x10, descriptor_item.value.unsigned_value);
+    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)value_item.type);
+    ASSERT_ARE_EQUAL(uint32_t, 0, value_item.count);
+    ASSERT_IS_FALSE(amqp_reader_has_next(&reader));
+}
+
+/* Tests_SRS_AMQPVALUE_01_549: [ `amqp_reader_next` shall fill in `item` with the type, constructor and a view of the next value, borrowed from the buffer, move past the value, a list, map, array or described value included, and return 0. ]*/
+TEST_FUNCTION(amqp_reader_reads_what_amqp_writer_writes)
+{
+    // arrange
+    unsigned char buffer[64];
+    AMQP_WRITER writer;
+    AMQP_READER reader;
+    AMQP_READER_ITEM described_item;
+    AMQP_READER_ITEM descriptor_item;
+    AMQP_READER_ITEM list_item;
+    AMQP_READER_ITEM string_item;
+    AMQP_READER_ITEM uint_item;
+    size_t length;
+    int result;
+    (void)amqp_writer_init(&writer, buffer, sizeof(buffer));
+    (void)amqp_writer_begin_described(&writer, 0x12);
+    (void)amqp_writer_begin_list(&writer);
+    (void)amqp_writer_put_string(&writer, "link");
+    (void)amqp_writer_put_uint(&writer, 3);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_get_length(&writer, &length);
+    (void)amqp_reader_init(&reader, buffer, length);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_next(&reader, &described_item);
+    result |= amqp_reader_enter(&reader, &described_item);
+    result |= amqp_reader_next(&reader, &descriptor_item);
+    result |= amqp_reader_next(&reader, &list_item);
+    result |= amqp_reader_enter(&reader, &list_item);
+    result |= amqp_reader_next(&reader, &string_item);
+    result |= amqp_reader_next(&reader, &uint_item);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 0, item_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0x12, descriptor_item.value.unsigned_value);
+    ASSERT_ARE_EQUAL(uint32_t, 2, list_item.count);
+    ASSERT_ARE_EQUAL(uint32_t, 4, string_item.length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(string_item.bytes, "link", 4));
+    ASSERT_ARE_EQUAL(uint64_t, 3, uint_item.value.unsigned_value);
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* Tests_SRS_AMQPVALUE_01_548: [ If `reader` is NULL, `amqp_reader_has_next` shall return false. ]*/
+TEST_FUNCTION(amqp_reader_has_next_with_NULL_reader_returns_false)
+{
+    // arrange
+
+    // act
+    bool result = amqp_reader_has_next(NULL);
+
+    // assert
+    ASSERT_IS_FALSE(result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_1_null_item_succeeds)
+/* Tests_SRS_AMQPVALUE_01_552: [ If `reader` or `item` is NULL, or if `amqp_reader_has_next` would return false, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_next_past_the_last_item_fails)
 {
     // arrange
+    unsigned char buffer[] = { 0x40 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x40 };
-    uint32_t item_count;
-    AMQP_VALUE item;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &item);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_next(&reader, &item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 1, item_count);
-    item = amqpvalue_get_list_item(decoded_values[0], 0);
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
-    amqpvalue_destroy(item);
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_2_null_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_next_with_a_truncated_string_fails)
 {
     // arrange
+    unsigned char buffer[] = { 0xA1, 0x05, 'h', 'i' };
+    AMQP_READER reader;
+    AMQP_READER_ITEM item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x40, 0x40 };
-    int i;
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_next(&reader, &item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 2, item_count);
-    for (i = 0; i < 2; i++)
-    {
-        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
-        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
-        amqpvalue_destroy(item);
-    }
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_255_null_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_next_with_an_item_crossing_the_end_of_its_list_fails)
 {
     // arrange
+    unsigned char buffer[] = { 0xC0, 0x02, 0x01, 0x52, 0x07 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM list_item;
+    AMQP_READER_ITEM item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[9 + 255] = { 0xD0, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF };
-    int i;
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-    (void)memset(bytes + 9, 0x40, 255);
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &list_item);
+    (void)amqp_reader_enter(&reader, &list_item);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_next(&reader, &item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 255, item_count);
-    for (i = 0; i < 255; i++)
-    {
-        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
-        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
-        amqpvalue_destroy(item);
-    }
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_256_null_items_succeeds)
+/* Tests_SRS_AMQPVALUE_01_550: [ If the bytes left in the buffer or in the innermost container do not hold a complete value, or if the constructor is not valid, `amqp_reader_next` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_next_with_an_invalid_constructor_fails)
 {
     // arrange
+    unsigned char buffer[] = { 0x20 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[9 + 256] = { 0xD0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00 };
-    int i;
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-    (void)memset(bytes + 9, 0x40, 256);
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_next(&reader, &item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 256, item_count);
-    for (i = 0; i < 256; i++)
-    {
-        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
-        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
-        amqpvalue_destroy(item);
-    }
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_383: [1.6.22 list A sequence of polymorphic values.] */
-/* Tests_SRS_AMQPVALUE_01_386: [<encoding name="list32" code="0xd0" category="compound" width="4" label="up to 2^32 - 1 list elements with total size less than 2^32 octets"/>] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_256_null_items_byte_by_byte_succeeds)
+/* Tests_SRS_AMQPVALUE_01_556: [ If `reader` or `item` is NULL, if `item` is not a list, map, array or described value, or if it is not the item the last call to `amqp_reader_next` returned, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_enter_a_scalar_fails)
 {
     // arrange
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[9 + 256] = { 0xD0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00 };
-    int i;
-    uint32_t item_count;
-    umock_c_reset_all_calls();
-    (void)memset(bytes + 9, 0x40, 256);
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(value_decoded_callback(test_context, IGNORED_PTR_ARG));
+    unsigned char buffer[] = { 0x52, 0x07 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM item;
+    int result;
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &item);
 
     // act
-    for (i = 0; i < sizeof(bytes); i++)
-    {
-        int result = amqpvalue_decode_bytes(amqpvalue_decoder, &bytes[i], 1);
-        ASSERT_ARE_EQUAL(int, 0, result);
-    }
+    result = amqp_reader_enter(&reader, &item);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_LIST, (int)amqpvalue_get_type(decoded_values[0]));
-    (void)amqpvalue_get_list_item_count(decoded_values[0], &item_count);
-    ASSERT_ARE_EQUAL(uint32_t, 256, item_count);
-    for (i = 0; i < 256; i++)
-    {
-        AMQP_VALUE item = amqpvalue_get_list_item(decoded_values[0], i);
-        ASSERT_ARE_EQUAL(int, (int)AMQP_TYPE_NULL, (int)amqpvalue_get_type(item));
-        amqpvalue_destroy(item);
-    }
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_zero_items_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_556: [ If `reader` or `item` is NULL, if `item` is not a list, map, array or described value, or if it is not the item the last call to `amqp_reader_next` returned, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_enter_a_list_that_is_not_the_last_item_read_fails)
 {
     // arrange
+    unsigned char buffer[] = { 0x45, 0x40 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM list_item;
+    AMQP_READER_ITEM null_item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &list_item);
+    (void)amqp_reader_next(&reader, &null_item);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_enter(&reader, &list_item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_1_item_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_558: [ If the array has no item constructor, or if its items are described values, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_enter_an_array_of_described_values_fails)
 {
     // arrange
+    unsigned char buffer[] = { 0xE0, 0x06, 0x01, 0x00, 0x53, 0x10, 0x45, 0x45 };
+    AMQP_READER reader;
+    AMQP_READER_ITEM array_item;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[] = { 0xD0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01 };
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &array_item);
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_enter(&reader, &array_item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the value_decoded_callback shall not be called.] */
-TEST_FUNCTION(amqpvalue_decode_list_0xD0_256_null_items_not_enough_bytes_does_not_trigger_callback)
+/* Tests_SRS_AMQPVALUE_01_557: [ If `AMQP_READER_MAX_DEPTH` containers are already entered, `amqp_reader_enter` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_enter_beyond_the_max_depth_fails)
 {
     // arrange
+    unsigned char buffer[(AMQP_READER_MAX_DEPTH + 1) * 2];
+    AMQP_READER reader;
+    AMQP_READER_ITEM item;
+    size_t i;
     int result;
-    AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(value_decoded_callback, test_context);
-    unsigned char bytes[9 + 255] = { 0xD0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00 };
-    umock_c_reset_all_calls();
-    (void)memset(bytes + 9, 0x40, 255);
-
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreAllCalls();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreAllCalls();
+    for (i = 0; i < AMQP_READER_MAX_DEPTH; i++)
+    {
+        buffer[i * 2] = 0x00;
+        buffer[(i * 2) + 1] = 0x40;
+    }
+    buffer[AMQP_READER_MAX_DEPTH * 2] = 0x45;
+    buffer[(AMQP_READER_MAX_DEPTH * 2) + 1] = 0x40;
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+    (void)amqp_reader_next(&reader, &item);
+    for (i = 0; i < AMQP_READER_MAX_DEPTH; i++)
+    {
+        (void)amqp_reader_enter(&reader, &item);
+        (void)amqp_reader_next(&reader, &item);
+        (void)amqp_reader_next(&reader, &item);
+    }
 
     // act
-    result = amqpvalue_decode_bytes(amqpvalue_decoder, bytes, sizeof(bytes));
+    result = amqp_reader_enter(&reader, &item);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
 
-    // cleanup
-    amqpvalue_decoder_destroy(amqpvalue_decoder);
+/* Tests_SRS_AMQPVALUE_01_559: [ If `reader` is NULL or no container is entered, `amqp_reader_leave` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(amqp_reader_leave_without_an_entered_container_fails)
+{
+    // arrange
+    unsigned char buffer[] = { 0x40 };
+    AMQP_READER reader;
+    int result;
+    (void)amqp_reader_init(&reader, buffer, sizeof(buffer));
+
+    // act
+    result = amqp_reader_leave(&reader);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
 END_TEST_SUITE(amqpvalue_ut)
@@ -75,6 +75,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
     REGISTER_UMOCK_ALIAS_TYPE(ASYNC_OPERATION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ASYNC_OPERATION_POOL_HANDLE, void*);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -234,4 +235,236 @@ TEST_FUNCTION(async_operation_cancel_with_NULL_async_operation_fails)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+/* async_operation_pool_create */
+
+/* Tests_SRS_ASYNC_OPERATION_01_010: [ `async_operation_pool_create` shall create a pool of asynchronous operations of `context_size` bytes that keeps up to `max_free_count` of them for reuse, and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(async_operation_pool_create_succeeds)
+{
+    // arrange
+    ASYNC_OPERATION_POOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = async_operation_pool_create(sizeof(uintptr_t), 4);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    async_operation_pool_destroy(result);
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_011: [ If `context_size` is less than the size of the cancel handler, `async_operation_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(async_operation_pool_create_with_not_enough_context_size_fails)
+{
+    // arrange
+    ASYNC_OPERATION_POOL_HANDLE result;
+
+    // act
+    result = async_operation_pool_create(0, 4);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_012: [ If allocating memory for the pool fails, `async_operation_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_async_operation_pool_create_fails)
+{
+    // arrange
+    ASYNC_OPERATION_POOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = async_operation_pool_create(sizeof(uintptr_t), 4);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* async_operation_create_from_pool */
+
+/* Tests_SRS_ASYNC_OPERATION_01_013: [ `async_operation_create_from_pool` shall return a non-NULL handle to an asynchronous operation that is destroyed with `async_operation_destroy` and cancelled with `async_operation_cancel` like any other. ]*/
+/* Tests_SRS_ASYNC_OPERATION_01_016: [ Otherwise `async_operation_create_from_pool` shall allocate memory for a new operation of the context size of the pool. ]*/
+TEST_FUNCTION(async_operation_create_from_pool_with_no_free_block_allocates_the_operation)
+{
+    // arrange
+    ASYNC_OPERATION_HANDLE result;
+    ASYNC_OPERATION_POOL_HANDLE async_operation_pool = async_operation_pool_create(sizeof(uintptr_t), 4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_cancel_handler(IGNORED_PTR_ARG));
+
+    // act
+    result = async_operation_create_from_pool(async_operation_pool, test_cancel_handler);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    (void)async_operation_cancel(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    async_operation_destroy(result);
+    async_operation_pool_destroy(async_operation_pool);
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_014: [ If `async_operation_pool` or `async_operation_cancel_handler` is NULL, `async_operation_create_from_pool` shall fail and return NULL. ]*/
+TEST_FUNCTION(async_operation_create_from_pool_with_NULL_pool_fails)
+{
+    // arrange
+    ASYNC_OPERATION_HANDLE result;
+
+    // act
+    result = async_operation_create_from_pool(NULL, test_cancel_handler);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_014: [ If `async_operation_pool` or `async_operation_cancel_handler` is NULL, `async_operation_create_from_pool` shall fail and return NULL. ]*/
+TEST_FUNCTION(async_operation_create_from_pool_with_NULL_cancel_handler_fails)
+{
+    // arrange
+    ASYNC_OPERATION_HANDLE result;
+    ASYNC_OPERATION_POOL_HANDLE async_operation_pool = async_operation_pool_create(sizeof(uintptr_t), 4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = async_operation_create_from_pool(async_operation_pool, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    async_operation_pool_destroy(async_operation_pool);
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_017: [ If allocating memory for the operation fails, `async_operation_create_from_pool` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_async_operation_create_from_pool_fails)
+{
+    // arrange
+    ASYNC_OPERATION_HANDLE result;
+    ASYNC_OPERATION_POOL_HANDLE async_operation_pool = async_operation_pool_create(sizeof(uintptr_t), 4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = async_operation_create_from_pool(async_operation_pool, test_cancel_handler);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    async_operation_pool_destroy(async_operation_pool);
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_015: [ `async_operation_create_from_pool` shall reuse a free block of the pool when it has one, without allocating memory. ]*/
+/* Tests_SRS_ASYNC_OPERATION_01_018: [ Destroying an operation created from a pool shall keep its memory in the pool for the next `async_operation_create_from_pool`, as long as the pool holds less than `max_free_count` free blocks. ]*/
+TEST_FUNCTION(async_operation_create_from_pool_reuses_the_memory_of_a_destroyed_operation)
+{
+    // arrange
+    ASYNC_OPERATION_HANDLE result;
+    ASYNC_OPERATION_HANDLE destroyed_async_operation;
+    ASYNC_OPERATION_POOL_HANDLE async_operation_pool = async_operation_pool_create(sizeof(uintptr_t), 4);
+    destroyed_async_operation = async_operation_create_from_pool(async_operation_pool, test_cancel_handler);
+    umock_c_reset_all_calls();
+
+    // act
+    async_operation_destroy(destroyed_async_operation);
+    result = async_operation_create_from_pool(async_operation_pool, test_cancel_handler);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, destroyed_async_operation, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    async_operation_destroy(result);
+    async_operation_pool_destroy(async_operation_pool);
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_019: [ When the pool already holds `max_free_count` free blocks, destroying an operation created from it shall free its memory. ]*/
+TEST_FUNCTION(destroying_an_operation_of_a_full_pool_frees_it)
+{
+    // arrange
+    ASYNC_OPERATION_HANDLE async_operation;
+    ASYNC_OPERATION_POOL_HANDLE async_operation_pool = async_operation_pool_create(sizeof(uintptr_t), 0);
+    async_operation = async_operation_create_from_pool(async_operation_pool, test_cancel_handler);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    async_operation_destroy(async_operation);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    async_operation_pool_destroy(async_operation_pool);
+}
+
+/* async_operation_pool_destroy */
+
+/* Tests_SRS_ASYNC_OPERATION_01_021: [ `async_operation_pool_destroy` shall free the free blocks of the pool, and the pool itself once no operation created from it is left. ]*/
+TEST_FUNCTION(async_operation_pool_destroy_frees_the_free_blocks_and_the_pool)
+{
+    // arrange
+    ASYNC_OPERATION_POOL_HANDLE async_operation_pool = async_operation_pool_create(sizeof(uintptr_t), 4);
+    async_operation_destroy(async_operation_create_from_pool(async_operation_pool, test_cancel_handler));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(async_operation_pool));
+
+    // act
+    async_operation_pool_destroy(async_operation_pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_021: [ `async_operation_pool_destroy` shall free the free blocks of the pool, and the pool itself once no operation created from it is left. ]*/
+/* Tests_SRS_ASYNC_OPERATION_01_022: [ When the last operation of a destroyed pool is destroyed, the pool itself shall be freed. ]*/
+TEST_FUNCTION(async_operation_pool_destroy_with_an_operation_left_frees_the_pool_when_the_operation_is_destroyed)
+{
+    // arrange
+    ASYNC_OPERATION_HANDLE async_operation;
+    ASYNC_OPERATION_POOL_HANDLE async_operation_pool = async_operation_pool_create(sizeof(uintptr_t), 4);
+    async_operation = async_operation_create_from_pool(async_operation_pool, test_cancel_handler);
+    umock_c_reset_all_calls();
+
+    async_operation_pool_destroy(async_operation_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(async_operation_pool));
+
+    // act
+    async_operation_destroy(async_operation);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNC_OPERATION_01_020: [ If `async_operation_pool` is NULL, `async_operation_pool_destroy` shall do nothing. ]*/
+TEST_FUNCTION(async_operation_pool_destroy_with_NULL_pool_does_not_free_anything)
+{
+    // arrange
+
+    // act
+    async_operation_pool_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(async_operation_ut)
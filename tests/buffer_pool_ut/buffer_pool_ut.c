@@ -0,0 +1,438 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/buffer_pool.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+/* where there is no mapping API the region is malloc'ed too */
+static void setup_region_allocation(void)
+{
+#if !defined(_WIN32) && !defined(__linux__)
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+#endif
+}
+
+BEGIN_TEST_SUITE(buffer_pool_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* buffer_pool_create */
+
+/* Tests_SRS_BUFFER_POOL_01_001: [ `buffer_pool_create` shall create a pool of `buffer_count` buffers of at least `buffer_size` bytes carved out of one region and on success return a non-NULL handle to it. ]*/
+TEST_FUNCTION(buffer_pool_create_returns_a_valid_handle)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    setup_region_allocation();
+
+    // act
+    buffer_pool = buffer_pool_create(1000, 3, false);
+
+    // assert
+    ASSERT_IS_NOT_NULL(buffer_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(buffer_pool_is_huge_page_backed(buffer_pool));
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* Tests_SRS_BUFFER_POOL_01_004: [ When `use_huge_pages` is true, `buffer_pool_create` shall map the region with huge pages, and map it with normal pages when huge pages cannot be had. ]*/
+TEST_FUNCTION(buffer_pool_create_with_huge_pages_returns_usable_buffers_with_or_without_huge_pages)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool;
+    unsigned char* buffer;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    setup_region_allocation();
+
+    // act
+    buffer_pool = buffer_pool_create(65536, 64, true);
+
+    // assert
+    ASSERT_IS_NOT_NULL(buffer_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    buffer = buffer_pool_get(buffer_pool, 65536);
+    ASSERT_IS_NOT_NULL(buffer);
+    (void)memset(buffer, 0x42, 65536);
+
+    // cleanup
+    buffer_pool_release(buffer_pool, buffer);
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* Tests_SRS_BUFFER_POOL_01_002: [ If `buffer_size` or `buffer_count` is 0, or the size of the region would not fit in a `size_t`, `buffer_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(buffer_pool_create_with_0_buffer_size_fails)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool;
+
+    // act
+    buffer_pool = buffer_pool_create(0, 3, false);
+
+    // assert
+    ASSERT_IS_NULL(buffer_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFER_POOL_01_002: [ If `buffer_size` or `buffer_count` is 0, or the size of the region would not fit in a `size_t`, `buffer_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(buffer_pool_create_with_0_buffer_count_fails)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool;
+
+    // act
+    buffer_pool = buffer_pool_create(1000, 0, false);
+
+    // assert
+    ASSERT_IS_NULL(buffer_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFER_POOL_01_002: [ If `buffer_size` or `buffer_count` is 0, or the size of the region would not fit in a `size_t`, `buffer_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(buffer_pool_create_with_a_region_size_overflowing_fails)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool;
+
+    // act
+    buffer_pool = buffer_pool_create(1000, SIZE_MAX / 512, false);
+
+    // assert
+    ASSERT_IS_NULL(buffer_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFER_POOL_01_003: [ If allocating the pool or its region fails, `buffer_pool_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_buffer_pool_create_fails)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    buffer_pool = buffer_pool_create(1000, 3, false);
+
+    // assert
+    ASSERT_IS_NULL(buffer_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* buffer_pool_destroy */
+
+/* Tests_SRS_BUFFER_POOL_01_006: [ `buffer_pool_destroy` shall unmap or free the region and free the pool. ]*/
+TEST_FUNCTION(buffer_pool_destroy_frees_the_pool)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 3, false);
+    umock_c_reset_all_calls();
+
+#if !defined(_WIN32) && !defined(__linux__)
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+#endif
+    STRICT_EXPECTED_CALL(gballoc_free(buffer_pool));
+
+    // act
+    buffer_pool_destroy(buffer_pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFER_POOL_01_007: [ If `buffer_pool` is NULL, `buffer_pool_destroy` shall do nothing. ]*/
+TEST_FUNCTION(buffer_pool_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    buffer_pool_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* buffer_pool_get */
+
+/* Tests_SRS_BUFFER_POOL_01_008: [ `buffer_pool_get` shall take a free buffer out of the pool and return it. ]*/
+TEST_FUNCTION(buffer_pool_get_returns_distinct_aligned_buffers)
+{
+    // arrange
+    unsigned char* buffers[3];
+    size_t i;
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 3, false);
+    umock_c_reset_all_calls();
+
+    // act
+    for (i = 0; i < 3; i++)
+    {
+        buffers[i] = buffer_pool_get(buffer_pool, 1000);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    for (i = 0; i < 3; i++)
+    {
+        ASSERT_IS_NOT_NULL(buffers[i]);
+        ASSERT_ARE_EQUAL(size_t, 0, (size_t)((uintptr_t)buffers[i] % 64));
+        (void)memset(buffers[i], (int)i, 1000);
+    }
+
+    ASSERT_ARE_NOT_EQUAL(void_ptr, buffers[0], buffers[1]);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, buffers[1], buffers[2]);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, buffers[0], buffers[2]);
+    ASSERT_ARE_EQUAL(int, 0, (int)buffers[0][999]);
+    ASSERT_ARE_EQUAL(int, 1, (int)buffers[1][0]);
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* Tests_SRS_BUFFER_POOL_01_009: [ If `buffer_pool` is NULL, `buffer_pool_get` shall fail and return NULL. ]*/
+TEST_FUNCTION(buffer_pool_get_with_NULL_buffer_pool_fails)
+{
+    // arrange
+
+    // act
+    unsigned char* buffer = buffer_pool_get(NULL, 100);
+
+    // assert
+    ASSERT_IS_NULL(buffer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFER_POOL_01_010: [ If `size` is bigger than the buffer size of the pool or all the buffers are in use, `buffer_pool_get` shall return NULL. ]*/
+TEST_FUNCTION(buffer_pool_get_with_a_size_bigger_than_the_buffers_returns_NULL)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 3, false);
+    umock_c_reset_all_calls();
+
+    // act
+    unsigned char* buffer = buffer_pool_get(buffer_pool, 1001);
+
+    // assert
+    ASSERT_IS_NULL(buffer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* Tests_SRS_BUFFER_POOL_01_010: [ If `size` is bigger than the buffer size of the pool or all the buffers are in use, `buffer_pool_get` shall return NULL. ]*/
+TEST_FUNCTION(buffer_pool_get_when_all_buffers_are_in_use_returns_NULL)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 2, false);
+    (void)buffer_pool_get(buffer_pool, 1000);
+    (void)buffer_pool_get(buffer_pool, 1000);
+    umock_c_reset_all_calls();
+
+    // act
+    unsigned char* buffer = buffer_pool_get(buffer_pool, 1);
+
+    // assert
+    ASSERT_IS_NULL(buffer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* buffer_pool_release */
+
+/* Tests_SRS_BUFFER_POOL_01_011: [ `buffer_pool_release` shall give `buffer` back to the pool, most recently released buffers being handed out first. ]*/
+TEST_FUNCTION(a_released_buffer_is_handed_out_again)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 2, false);
+    unsigned char* buffer_1 = buffer_pool_get(buffer_pool, 1000);
+    unsigned char* buffer_2 = buffer_pool_get(buffer_pool, 1000);
+    umock_c_reset_all_calls();
+
+    // act
+    buffer_pool_release(buffer_pool, buffer_1);
+    buffer_pool_release(buffer_pool, buffer_2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, buffer_2, buffer_pool_get(buffer_pool, 1000));
+    ASSERT_ARE_EQUAL(void_ptr, buffer_1, buffer_pool_get(buffer_pool, 1000));
+    ASSERT_IS_NULL(buffer_pool_get(buffer_pool, 1000));
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* Tests_SRS_BUFFER_POOL_01_012: [ If `buffer_pool` or `buffer` is NULL, `buffer_pool_release` shall do nothing. ]*/
+TEST_FUNCTION(buffer_pool_release_with_NULL_buffer_does_nothing)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 1, false);
+    unsigned char* buffer = buffer_pool_get(buffer_pool, 1000);
+    umock_c_reset_all_calls();
+
+    // act
+    buffer_pool_release(buffer_pool, NULL);
+    buffer_pool_release(NULL, buffer);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(buffer_pool_get(buffer_pool, 1000));
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* Tests_SRS_BUFFER_POOL_01_013: [ If `buffer` was not obtained from `buffer_pool`, `buffer_pool_release` shall do nothing. ]*/
+TEST_FUNCTION(buffer_pool_release_of_a_buffer_not_from_the_pool_does_nothing)
+{
+    // arrange
+    unsigned char other_buffer[1000];
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 1, false);
+    unsigned char* buffer = buffer_pool_get(buffer_pool, 1000);
+    umock_c_reset_all_calls();
+
+    // act
+    buffer_pool_release(buffer_pool, other_buffer);
+    buffer_pool_release(buffer_pool, buffer + 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(buffer_pool_get(buffer_pool, 1000));
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* buffer_pool_get_buffer_size */
+
+/* Tests_SRS_BUFFER_POOL_01_016: [ `buffer_pool_get_buffer_size` shall return the `buffer_size` passed to `buffer_pool_create`. ]*/
+TEST_FUNCTION(buffer_pool_get_buffer_size_returns_the_buffer_size_of_the_pool)
+{
+    // arrange
+    BUFFER_POOL_HANDLE buffer_pool = buffer_pool_create(1000, 3, false);
+    umock_c_reset_all_calls();
+
+    // act
+    size_t result = buffer_pool_get_buffer_size(buffer_pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1000, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    buffer_pool_destroy(buffer_pool);
+}
+
+/* Tests_SRS_BUFFER_POOL_01_017: [ If `buffer_pool` is NULL, `buffer_pool_get_buffer_size` shall return 0. ]*/
+TEST_FUNCTION(buffer_pool_get_buffer_size_with_NULL_returns_0)
+{
+    // arrange
+
+    // act
+    size_t result = buffer_pool_get_buffer_size(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* buffer_pool_is_huge_page_backed */
+
+/* Tests_SRS_BUFFER_POOL_01_015: [ If `buffer_pool` is NULL, `buffer_pool_is_huge_page_backed` shall return false. ]*/
+TEST_FUNCTION(buffer_pool_is_huge_page_backed_with_NULL_returns_false)
+{
+    // arrange
+
+    // act
+    bool result = buffer_pool_is_huge_page_backed(NULL);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(buffer_pool_ut)
@@ -0,0 +1,1329 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+static int my_mallocAndStrcpy_s(char** destination, const char* source)
+{
+    size_t len = strlen(source);
+    *destination = (char*)my_gballoc_malloc(len + 1);
+    (void)strcpy(*destination, source);
+    return 0;
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_uamqp_c/cbs.h"
+#include "azure_uamqp_c/timer_wheel.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/cbs_token_manager.h"
+
+#define MAX_SAVED_CALLBACKS 8
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static CBS_HANDLE test_cbs = (CBS_HANDLE)0x4242;
+static TIMER_WHEEL_HANDLE test_timer_wheel = (TIMER_WHEEL_HANDLE)0x4243;
+static TICK_COUNTER_HANDLE test_tick_counter = (TICK_COUNTER_HANDLE)0x4244;
+static TIMER_WHEEL_TIMER_HANDLE test_batch_timer = (TIMER_WHEEL_TIMER_HANDLE)0x4245;
+static TIMER_WHEEL_TIMER_HANDLE test_refresh_timer = (TIMER_WHEEL_TIMER_HANDLE)0x4246;
+static LOCK_HANDLE test_lock = (LOCK_HANDLE)0x4247;
+static const char test_type[] = "servicebus.windows.net:sastoken";
+static const CBS_TOKEN_MANAGER_CONFIG test_config = { 5000, 0, 2, 100, 1000 };
+
+static ON_TIMER_EXPIRED saved_on_timer_expired[MAX_SAVED_CALLBACKS];
+static void* saved_on_timer_expired_context[MAX_SAVED_CALLBACKS];
+static size_t created_timer_count;
+static ON_CBS_OPERATION_COMPLETE saved_on_cbs_put_token_complete[MAX_SAVED_CALLBACKS];
+static void* saved_on_cbs_put_token_complete_context[MAX_SAVED_CALLBACKS];
+static size_t put_token_count;
+static size_t get_token_count;
+static CBS_TOKEN_MANAGER_TOKEN_REQUEST_HANDLE saved_token_requests[MAX_SAVED_CALLBACKS];
+static size_t token_request_count;
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_put_token_complete, void*, context, CBS_OPERATION_RESULT, put_token_complete_result, unsigned int, status_code, const char*, status_description);
+MOCK_FUNCTION_END();
+
+static const char* test_on_get_token(void* context, const char* audience, uint64_t* expiry_ms)
+{
+    (void)context;
+    (void)audience;
+    get_token_count++;
+    *expiry_ms = 120000;
+    return "refreshed_token";
+}
+
+static void test_on_request_token(void* context, const char* audience, CBS_TOKEN_MANAGER_TOKEN_REQUEST_HANDLE request)
+{
+    (void)context;
+    (void)audience;
+    saved_token_requests[token_request_count++] = request;
+}
+
+static TIMER_WHEEL_TIMER_HANDLE my_timer_wheel_create_timer(TIMER_WHEEL_HANDLE timer_wheel, ON_TIMER_EXPIRED on_timer_expired, void* on_timer_expired_context)
+{
+    (void)timer_wheel;
+    saved_on_timer_expired[created_timer_count] = on_timer_expired;
+    saved_on_timer_expired_context[created_timer_count] = on_timer_expired_context;
+    /* the batch timer is the first one created by cbs_token_manager_create */
+    return (created_timer_count++ == 0) ? test_batch_timer : test_refresh_timer;
+}
+
+static int my_cbs_put_token_async(CBS_HANDLE cbs, const char* type, const char* audience, const char* token, ON_CBS_OPERATION_COMPLETE on_cbs_put_token_complete, void* on_cbs_put_token_complete_context)
+{
+    (void)cbs;
+    (void)type;
+    (void)audience;
+    (void)token;
+    saved_on_cbs_put_token_complete[put_token_count] = on_cbs_put_token_complete;
+    saved_on_cbs_put_token_complete_context[put_token_count] = on_cbs_put_token_complete_context;
+    put_token_count++;
+    return 0;
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = 1000;
+    return 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+TEST_DEFINE_ENUM_TYPE(CBS_OPERATION_RESULT, CBS_OPERATION_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(CBS_OPERATION_RESULT, CBS_OPERATION_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static CBS_TOKEN_MANAGER_HANDLE create_token_manager(void)
+{
+    CBS_TOKEN_MANAGER_HANDLE token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, &test_config, test_on_get_token, (void*)0x4300);
+    ASSERT_IS_NOT_NULL(token_manager);
+    return token_manager;
+}
+
+static void put_and_complete_token(CBS_TOKEN_MANAGER_HANDLE token_manager, const char* audience)
+{
+    size_t put_index = put_token_count;
+    int result = cbs_token_manager_put_token_async(token_manager, test_type, audience, "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    saved_on_cbs_put_token_complete[put_index](saved_on_cbs_put_token_complete_context[put_index], CBS_OPERATION_RESULT_OK, 200, "ok");
+}
+
+/* puts a token with the token provider set and makes its refresh due, the batch timer then requests the new token */
+static CBS_TOKEN_MANAGER_HANDLE create_token_manager_with_a_due_token_request(void)
+{
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    ASSERT_ARE_EQUAL(int, 0, cbs_token_manager_set_token_provider(token_manager, test_on_request_token, (void*)0x4302));
+    put_and_complete_token(token_manager, "sb://audience");
+    saved_on_timer_expired[1](saved_on_timer_expired_context[1]);
+    saved_on_timer_expired[0](saved_on_timer_expired_context[0]);
+    ASSERT_ARE_EQUAL(size_t, 1, token_request_count);
+    return token_manager;
+}
+
+BEGIN_TEST_SUITE(cbs_token_manager_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_HOOK(timer_wheel_create_timer, my_timer_wheel_create_timer);
+    REGISTER_GLOBAL_MOCK_HOOK(cbs_put_token_async, my_cbs_put_token_async);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_RETURN(timer_wheel_start_timer, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, test_lock);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_TYPE(CBS_OPERATION_RESULT, CBS_OPERATION_RESULT);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+
+    REGISTER_UMOCK_ALIAS_TYPE(CBS_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TIMER_WHEEL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TIMER_WHEEL_TIMER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_TIMER_EXPIRED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_CBS_OPERATION_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, uint32_t);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    created_timer_count = 0;
+    put_token_count = 0;
+    get_token_count = 0;
+    token_request_count = 0;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* cbs_token_manager_create */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_001: [ `cbs_token_manager_create` shall create a new token manager putting tokens through `cbs` and on success return a non-NULL handle to it. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_005: [ `cbs_token_manager_create` shall create the timer driving the refresh batches by calling `timer_wheel_create_timer`. ]*/
+TEST_FUNCTION(cbs_token_manager_create_returns_a_valid_handle)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, &test_config, test_on_get_token, (void*)0x4300);
+
+    // assert
+    ASSERT_IS_NOT_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_001: [ `cbs_token_manager_create` shall create a new token manager putting tokens through `cbs` and on success return a non-NULL handle to it. ]*/
+TEST_FUNCTION(cbs_token_manager_create_with_NULL_on_get_token_succeeds)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, &test_config, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_002: [ If `cbs`, `timer_wheel`, `tick_counter` or `config` is NULL, `cbs_token_manager_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_token_manager_create_with_NULL_cbs_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+
+    // act
+    token_manager = cbs_token_manager_create(NULL, test_timer_wheel, test_tick_counter, &test_config, test_on_get_token, NULL);
+
+    // assert
+    ASSERT_IS_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_002: [ If `cbs`, `timer_wheel`, `tick_counter` or `config` is NULL, `cbs_token_manager_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_token_manager_create_with_NULL_timer_wheel_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+
+    // act
+    token_manager = cbs_token_manager_create(test_cbs, NULL, test_tick_counter, &test_config, test_on_get_token, NULL);
+
+    // assert
+    ASSERT_IS_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_002: [ If `cbs`, `timer_wheel`, `tick_counter` or `config` is NULL, `cbs_token_manager_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_token_manager_create_with_NULL_tick_counter_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+
+    // act
+    token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, NULL, &test_config, test_on_get_token, NULL);
+
+    // assert
+    ASSERT_IS_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_002: [ If `cbs`, `timer_wheel`, `tick_counter` or `config` is NULL, `cbs_token_manager_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_token_manager_create_with_NULL_config_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+
+    // act
+    token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, NULL, test_on_get_token, NULL);
+
+    // assert
+    ASSERT_IS_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_003: [ If `max_refreshes_per_batch` or `batch_interval_ms` is 0, `cbs_token_manager_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_token_manager_create_with_0_max_refreshes_per_batch_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+    CBS_TOKEN_MANAGER_CONFIG config = test_config;
+    config.max_refreshes_per_batch = 0;
+
+    // act
+    token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, &config, test_on_get_token, NULL);
+
+    // assert
+    ASSERT_IS_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_003: [ If `max_refreshes_per_batch` or `batch_interval_ms` is 0, `cbs_token_manager_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_token_manager_create_with_0_batch_interval_ms_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager;
+    CBS_TOKEN_MANAGER_CONFIG config = test_config;
+    config.batch_interval_ms = 0;
+
+    // act
+    token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, &config, test_on_get_token, NULL);
+
+    // assert
+    ASSERT_IS_NULL(token_manager);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_004: [ If any error occurs, `cbs_token_manager_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_cbs_token_manager_create_fails_then_cbs_token_manager_create_fails)
+{
+    // arrange
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetFailReturn(1);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(NULL);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        CBS_TOKEN_MANAGER_HANDLE token_manager;
+        char temp_str[128];
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, &test_config, test_on_get_token, NULL);
+
+        // assert
+        (void)sprintf(temp_str, "On failed call %u", (unsigned int)index);
+        ASSERT_IS_NULL_WITH_MSG(token_manager, temp_str);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+/* cbs_token_manager_destroy */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_006: [ `cbs_token_manager_destroy` shall free all the resources of the token manager, destroying its timers by calling `timer_wheel_destroy_timer`. ]*/
+TEST_FUNCTION(cbs_token_manager_destroy_frees_the_resources)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_destroy_timer(test_batch_timer));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    cbs_token_manager_destroy(token_manager);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_007: [ If `token_manager` is NULL, `cbs_token_manager_destroy` shall do nothing. ]*/
+TEST_FUNCTION(cbs_token_manager_destroy_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    cbs_token_manager_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_008: [ Audiences with a put in flight shall be freed when the put completes, without refreshing them. ]*/
+TEST_FUNCTION(cbs_token_manager_destroy_with_a_put_in_flight_frees_the_audience_when_the_put_completes)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    cbs_token_manager_destroy(token_manager);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4301, CBS_OPERATION_RESULT_OK, 200, "ok"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* cbs_token_manager_put_token_async */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_009: [ On success, `cbs_token_manager_put_token_async` shall return 0. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_011: [ The first put for an audience shall create an entry for it holding copies of `audience` and `type`. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_014: [ A token shall be put by calling `cbs_put_token_async` with the type and audience of the audience entry. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_puts_the_token)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "sb://audience"));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, test_type));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "token1"));
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience", "token1", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_010: [ If `token_manager`, `type`, `audience`, `token` or `on_put_token_complete` is NULL, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_with_NULL_token_manager_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = cbs_token_manager_put_token_async(NULL, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_010: [ If `token_manager`, `type`, `audience`, `token` or `on_put_token_complete` is NULL, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_with_NULL_type_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, NULL, "sb://audience", "token1", 60000, test_on_put_token_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_010: [ If `token_manager`, `type`, `audience`, `token` or `on_put_token_complete` is NULL, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_with_NULL_audience_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, NULL, "token1", 60000, test_on_put_token_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_010: [ If `token_manager`, `type`, `audience`, `token` or `on_put_token_complete` is NULL, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_with_NULL_token_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", NULL, 60000, test_on_put_token_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_010: [ If `token_manager`, `type`, `audience`, `token` or `on_put_token_complete` is NULL, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_with_NULL_on_put_token_complete_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_020: [ If any error occurs, `cbs_token_manager_put_token_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_cbs_put_token_async_fails_cbs_token_manager_put_token_async_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "sb://audience"));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, test_type));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "token1"));
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience", "token1", IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_013: [ If the same token is already being put for the audience, no new request shall be sent and the caller shall wait for the put in flight. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_with_the_token_in_flight_does_not_send_a_request)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_015: [ When a put completes successfully, the token and its expiry shall be cached for the audience. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_016: [ All callers waiting for the put shall be called with the result, status code and status description of the put. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_021: [ After a token is put successfully, its refresh shall be scheduled `refresh_ahead_ms` before its expiry, moved earlier by a random amount between 0 and `refresh_jitter_ms`. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_023: [ The refresh timer of an audience shall be created by calling `timer_wheel_create_timer` the first time a refresh is scheduled for it, and started by calling `timer_wheel_start_timer` with the refresh time. ]*/
+TEST_FUNCTION(when_the_put_completes_all_waiting_callers_are_notified_and_the_refresh_is_scheduled)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4302);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_refresh_timer, 55000));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4301, CBS_OPERATION_RESULT_OK, 200, "ok"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4302, CBS_OPERATION_RESULT_OK, 200, "ok"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_022: [ A refresh shall not be scheduled earlier than `retry_interval_ms` from the current time, so that tokens living shorter than the refresh lead are not refreshed in a tight loop. ]*/
+TEST_FUNCTION(the_refresh_of_a_token_expiring_before_the_refresh_lead_is_scheduled_retry_interval_ms_later)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 3000, test_on_put_token_complete, (void*)0x4301);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_refresh_timer, 2000));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4301, CBS_OPERATION_RESULT_OK, 200, "ok"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_024: [ If no `on_get_token` callback was given, tokens shall not be refreshed. ]*/
+TEST_FUNCTION(without_on_get_token_no_refresh_is_scheduled)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = cbs_token_manager_create(test_cbs, test_timer_wheel, test_tick_counter, &test_config, NULL, NULL);
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4301, CBS_OPERATION_RESULT_OK, 200, "ok"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_031: [ If refreshing a token fails, the refresh shall be attempted again `retry_interval_ms` later. ]*/
+TEST_FUNCTION(when_the_put_fails_the_callers_are_notified_and_a_retry_is_scheduled)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_refresh_timer, 2000));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4301, CBS_OPERATION_RESULT_OPERATION_FAILED, 401, "unauthorized"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OPERATION_FAILED, 401, "unauthorized");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_012: [ If the token is the one cached for the audience and has not expired, no request shall be sent and `on_put_token_complete` shall be called with `CBS_OPERATION_RESULT_OK`, status code 0 and a NULL status description. ]*/
+TEST_FUNCTION(cbs_token_manager_put_token_async_with_the_cached_token_completes_without_a_request)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    put_and_complete_token(token_manager, "sb://audience");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4302, CBS_OPERATION_RESULT_OK, 0, NULL));
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_017: [ If another token is being put for the audience, the token shall replace any token waiting to be put after it, the callers waiting for the replaced token waiting for this one. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_018: [ When the put in flight completes and another token was asked for in the meantime, that token shall be put, its callers waiting for the new put. ]*/
+TEST_FUNCTION(a_token_put_while_another_is_in_flight_is_sent_when_the_put_completes)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "token2"));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "token3"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience", "token3", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4301, CBS_OPERATION_RESULT_OK, 200, "ok"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token2", 70000, test_on_put_token_complete, (void*)0x4302);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token3", 80000, test_on_put_token_complete, (void*)0x4303);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[1](saved_on_cbs_put_token_complete_context[1], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_019: [ If putting that token fails, its callers shall be called with `CBS_OPERATION_RESULT_CBS_ERROR`. ]*/
+TEST_FUNCTION(when_putting_the_next_token_fails_its_callers_are_notified_with_CBS_ERROR)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token2", 70000, test_on_put_token_complete, (void*)0x4302);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience", "token2", IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(test_timer_wheel, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_refresh_timer, 2000));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4301, CBS_OPERATION_RESULT_OK, 200, "ok"));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_put_token_complete((void*)0x4302, CBS_OPERATION_RESULT_CBS_ERROR, 0, NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* refresh */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_025: [ When the refresh of a token is due, the audience shall be appended to the queue of due refreshes. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_026: [ If no batch is scheduled, the batch timer shall be started to expire on the next tick. ]*/
+TEST_FUNCTION(when_a_refresh_is_due_the_batch_timer_is_started)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    put_and_complete_token(token_manager, "sb://audience");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_batch_timer, 1000));
+
+    // act
+    saved_on_timer_expired[1](saved_on_timer_expired_context[1]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_027: [ When the batch timer expires, at most `max_refreshes_per_batch` due refreshes shall be started, in the order they became due. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_028: [ A token shall be refreshed by calling `on_get_token` with the audience and putting the returned token with the returned expiry. ]*/
+TEST_FUNCTION(when_the_batch_timer_expires_the_due_token_is_refreshed)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    put_and_complete_token(token_manager, "sb://audience");
+    saved_on_timer_expired[1](saved_on_timer_expired_context[1]);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "refreshed_token"));
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience", "refreshed_token", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    saved_on_timer_expired[0](saved_on_timer_expired_context[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, get_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[1](saved_on_cbs_put_token_complete_context[1], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_027: [ When the batch timer expires, at most `max_refreshes_per_batch` due refreshes shall be started, in the order they became due. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_030: [ If due refreshes remain, the batch timer shall be started again `batch_interval_ms` later. ]*/
+TEST_FUNCTION(when_more_refreshes_are_due_than_fit_in_a_batch_the_rest_go_in_the_next_batch)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    put_and_complete_token(token_manager, "sb://audience1");
+    put_and_complete_token(token_manager, "sb://audience2");
+    put_and_complete_token(token_manager, "sb://audience3");
+    saved_on_timer_expired[1](saved_on_timer_expired_context[1]);
+    saved_on_timer_expired[2](saved_on_timer_expired_context[2]);
+    saved_on_timer_expired[3](saved_on_timer_expired_context[3]);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "refreshed_token"));
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience1", "refreshed_token", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "refreshed_token"));
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience2", "refreshed_token", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_batch_timer, 1100));
+
+    // act
+    saved_on_timer_expired[0](saved_on_timer_expired_context[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, get_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_timer_expired[0](saved_on_timer_expired_context[0]);
+    saved_on_cbs_put_token_complete[3](saved_on_cbs_put_token_complete_context[3], CBS_OPERATION_RESULT_OK, 200, "ok");
+    saved_on_cbs_put_token_complete[4](saved_on_cbs_put_token_complete_context[4], CBS_OPERATION_RESULT_OK, 200, "ok");
+    saved_on_cbs_put_token_complete[5](saved_on_cbs_put_token_complete_context[5], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_029: [ A due refresh for an audience that has a put in flight shall be skipped, the refresh being scheduled again when the put completes. ]*/
+TEST_FUNCTION(a_due_refresh_for_an_audience_with_a_put_in_flight_is_skipped)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    put_and_complete_token(token_manager, "sb://audience");
+    saved_on_timer_expired[1](saved_on_timer_expired_context[1]);
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token2", 70000, test_on_put_token_complete, (void*)0x4302);
+    umock_c_reset_all_calls();
+
+    // act
+    saved_on_timer_expired[0](saved_on_timer_expired_context[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, get_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[1](saved_on_cbs_put_token_complete_context[1], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* cbs_token_manager_remove_audience */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_032: [ `cbs_token_manager_remove_audience` shall forget the cached token of the audience and stop refreshing it, puts already started completing normally. ]*/
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_035: [ On success, `cbs_token_manager_remove_audience` shall return 0. ]*/
+TEST_FUNCTION(cbs_token_manager_remove_audience_frees_the_audience)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    put_and_complete_token(token_manager, "sb://audience");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_destroy_timer(test_refresh_timer));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = cbs_token_manager_remove_audience(token_manager, "sb://audience");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_032: [ `cbs_token_manager_remove_audience` shall forget the cached token of the audience and stop refreshing it, puts already started completing normally. ]*/
+TEST_FUNCTION(cbs_token_manager_remove_audience_with_a_put_in_flight_completes_the_put)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token1", 60000, test_on_put_token_complete, (void*)0x4301);
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_token_manager_remove_audience(token_manager, "sb://audience");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[0](saved_on_cbs_put_token_complete_context[0], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_033: [ If `token_manager` or `audience` is NULL, `cbs_token_manager_remove_audience` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_remove_audience_with_NULL_token_manager_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = cbs_token_manager_remove_audience(NULL, "sb://audience");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_033: [ If `token_manager` or `audience` is NULL, `cbs_token_manager_remove_audience` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_remove_audience_with_NULL_audience_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_token_manager_remove_audience(token_manager, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_034: [ If the audience is not known, `cbs_token_manager_remove_audience` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_remove_audience_with_an_unknown_audience_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_token_manager_remove_audience(token_manager, "sb://audience");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* cbs_token_manager_set_token_provider */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_036: [ `cbs_token_manager_set_token_provider` shall make the refreshes ask `on_request_token` for tokens instead of `on_get_token`, NULL going back to `on_get_token`, and return 0. ]*/
+TEST_FUNCTION(cbs_token_manager_set_token_provider_succeeds)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    // act
+    result = cbs_token_manager_set_token_provider(token_manager, test_on_request_token, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_037: [ If `token_manager` is NULL, `cbs_token_manager_set_token_provider` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_set_token_provider_with_NULL_token_manager_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = cbs_token_manager_set_token_provider(NULL, test_on_request_token, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_038: [ If any error occurs, `cbs_token_manager_set_token_provider` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_creating_the_lock_fails_cbs_token_manager_set_token_provider_fails)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = cbs_token_manager_set_token_provider(token_manager, test_on_request_token, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_039: [ With a token provider, a token shall be refreshed by calling `on_request_token` with a copy of the audience that stays valid until the request is completed and a new request handle, without waiting for the token. ]*/
+TEST_FUNCTION(with_a_token_provider_the_due_refresh_requests_the_token)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager();
+    (void)cbs_token_manager_set_token_provider(token_manager, test_on_request_token, (void*)0x4302);
+    put_and_complete_token(token_manager, "sb://audience");
+    saved_on_timer_expired[1](saved_on_timer_expired_context[1]);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "sb://audience"));
+    STRICT_EXPECTED_CALL(Lock(test_lock));
+    STRICT_EXPECTED_CALL(Unlock(test_lock));
+
+    // act
+    saved_on_timer_expired[0](saved_on_timer_expired_context[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, token_request_count);
+    ASSERT_ARE_EQUAL(size_t, 0, get_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)cbs_token_manager_complete_token_request(saved_token_requests[0], NULL, 0);
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_041: [ A due refresh for an audience whose token is being requested shall be skipped, the refresh being scheduled again when the request completes. ]*/
+TEST_FUNCTION(a_due_refresh_for_an_audience_whose_token_is_being_requested_is_skipped)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager_with_a_due_token_request();
+    saved_on_timer_expired[1](saved_on_timer_expired_context[1]);
+    umock_c_reset_all_calls();
+
+    // act
+    saved_on_timer_expired[0](saved_on_timer_expired_context[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, token_request_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)cbs_token_manager_complete_token_request(saved_token_requests[0], NULL, 0);
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* cbs_token_manager_complete_token_request */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_042: [ `cbs_token_manager_complete_token_request` shall hand `token` and `expiry_ms` back to the token manager, NULL `token` meaning that none could be made, and return 0. It may be called from any thread. ]*/
+TEST_FUNCTION(cbs_token_manager_complete_token_request_queues_the_token)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager_with_a_due_token_request();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "requested_token"));
+    STRICT_EXPECTED_CALL(Lock(test_lock));
+    STRICT_EXPECTED_CALL(Unlock(test_lock));
+
+    // act
+    result = cbs_token_manager_complete_token_request(saved_token_requests[0], "requested_token", 120000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_043: [ If `request` is NULL, `cbs_token_manager_complete_token_request` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_token_manager_complete_token_request_with_NULL_request_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = cbs_token_manager_complete_token_request(NULL, "requested_token", 120000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_048: [ The token of a request made for an audience removed since, or by a token manager destroyed since, shall be discarded. ]*/
+TEST_FUNCTION(a_token_request_completed_after_the_token_manager_is_destroyed_is_freed)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager_with_a_due_token_request();
+    int result;
+    cbs_token_manager_destroy(token_manager);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "requested_token"));
+    STRICT_EXPECTED_CALL(Lock(test_lock));
+    STRICT_EXPECTED_CALL(Unlock(test_lock));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(test_lock));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = cbs_token_manager_complete_token_request(saved_token_requests[0], "requested_token", 120000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* cbs_token_manager_dowork */
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_045: [ `cbs_token_manager_dowork` shall put the tokens of the completed requests with their expiry. ]*/
+TEST_FUNCTION(cbs_token_manager_dowork_puts_the_requested_token)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager_with_a_due_token_request();
+    (void)cbs_token_manager_complete_token_request(saved_token_requests[0], "requested_token", 120000);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(test_lock));
+    STRICT_EXPECTED_CALL(Unlock(test_lock));
+    STRICT_EXPECTED_CALL(cbs_put_token_async(test_cbs, test_type, "sb://audience", "requested_token", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    cbs_token_manager_dowork(token_manager);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[1](saved_on_cbs_put_token_complete_context[1], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_046: [ If a request was completed without a token, the refresh shall be attempted again `retry_interval_ms` later. ]*/
+TEST_FUNCTION(when_a_request_is_completed_without_a_token_cbs_token_manager_dowork_schedules_a_retry)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager_with_a_due_token_request();
+    (void)cbs_token_manager_complete_token_request(saved_token_requests[0], NULL, 0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(test_lock));
+    STRICT_EXPECTED_CALL(Unlock(test_lock));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(test_refresh_timer, 2000));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    cbs_token_manager_dowork(token_manager);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_047: [ If a put was started for the audience while the token was requested, the requested token shall be discarded, the refresh being scheduled again when the put completes. ]*/
+TEST_FUNCTION(a_token_requested_while_a_put_was_started_is_discarded)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager_with_a_due_token_request();
+    (void)cbs_token_manager_put_token_async(token_manager, test_type, "sb://audience", "token2", 70000, test_on_put_token_complete, (void*)0x4301);
+    (void)cbs_token_manager_complete_token_request(saved_token_requests[0], "requested_token", 120000);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(test_lock));
+    STRICT_EXPECTED_CALL(Unlock(test_lock));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    cbs_token_manager_dowork(token_manager);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saved_on_cbs_put_token_complete[1](saved_on_cbs_put_token_complete_context[1], CBS_OPERATION_RESULT_OK, 200, "ok");
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_048: [ The token of a request made for an audience removed since, or by a token manager destroyed since, shall be discarded. ]*/
+TEST_FUNCTION(the_token_requested_for_a_removed_audience_is_discarded)
+{
+    // arrange
+    CBS_TOKEN_MANAGER_HANDLE token_manager = create_token_manager_with_a_due_token_request();
+    (void)cbs_token_manager_remove_audience(token_manager, "sb://audience");
+    (void)cbs_token_manager_complete_token_request(saved_token_requests[0], "requested_token", 120000);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(test_lock));
+    STRICT_EXPECTED_CALL(Unlock(test_lock));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    cbs_token_manager_dowork(token_manager);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, put_token_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_token_manager_destroy(token_manager);
+}
+
+/* Tests_SRS_CBS_TOKEN_MANAGER_01_049: [ If `token_manager` is NULL, `cbs_token_manager_dowork` shall do nothing. ]*/
+TEST_FUNCTION(cbs_token_manager_dowork_with_NULL_token_manager_does_nothing)
+{
+    // arrange
+
+    // act
+    cbs_token_manager_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(cbs_token_manager_ut)
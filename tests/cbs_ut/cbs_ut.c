@@ -37,6 +37,7 @@ static void my_gballoc_free(void* ptr)
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/session.h"
 #include "azure_uamqp_c/amqp_management.h"
+#include "azure_uamqp_c/amqp_management_mux.h"
 
 #undef ENABLE_MOCKS
 
@@ -55,6 +56,9 @@ static AMQP_VALUE test_name_propery_value = (AMQP_VALUE)0x4304;
 static SINGLYLINKEDLIST_HANDLE test_singlylinkedlist = (SINGLYLINKEDLIST_HANDLE)0x4305;
 static AMQP_VALUE test_default_amqp_value = (AMQP_VALUE)0x4306;
 static MESSAGE_HANDLE test_response_message = (MESSAGE_HANDLE)0x4307;
+static AMQP_MANAGEMENT_MUX_HANDLE test_amqp_management_mux = (AMQP_MANAGEMENT_MUX_HANDLE)0x4308;
+static AMQP_MANAGEMENT_MUX_CLIENT_HANDLE test_amqp_management_mux_client = (AMQP_MANAGEMENT_MUX_CLIENT_HANDLE)0x4309;
+static AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE test_prepared_put_token = (AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE)0x430A;
 static ON_AMQP_MANAGEMENT_OPEN_COMPLETE saved_on_amqp_management_open_complete;
 static void* saved_on_amqp_management_open_complete_context;
 static ON_AMQP_MANAGEMENT_ERROR saved_on_amqp_management_error;
@@ -212,6 +216,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_TYPE(CBS_OPEN_COMPLETE_RESULT, CBS_OPEN_COMPLETE_RESULT);
     REGISTER_TYPE(CBS_OPERATION_RESULT, CBS_OPERATION_RESULT);
     REGISTER_GLOBAL_MOCK_RETURN(message_create, test_message);
+    REGISTER_GLOBAL_MOCK_RETURN(amqp_management_mux_client_create, test_amqp_management_mux_client);
+    REGISTER_GLOBAL_MOCK_RETURN(amqp_management_prepare_operation, test_prepared_put_token);
     REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, test_singlylinkedlist);
     REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
     REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
@@ -225,6 +231,9 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(CBS_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_MANAGEMENT_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_MANAGEMENT_MUX_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_MANAGEMENT_MUX_CLIENT_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_AMQP_MANAGEMENT_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_AMQP_MANAGEMENT_ERROR, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MESSAGE_HANDLE, void*);
@@ -346,6 +355,176 @@ TEST_FUNCTION(when_one_of_the_functions_called_by_cbs_create_fails_then_cbs_crea
     umock_c_negative_tests_deinit();
 }
 
+/* cbs_create_with_management_mux */
+
+/* Tests_SRS_CBS_01_119: [ `cbs_create_with_management_mux` shall create a new CBS instance sending its operations over the links shared by `amqp_management_mux` and on success return a non-NULL handle to it. ]*/
+/* Tests_SRS_CBS_01_121: [ `cbs_create_with_management_mux` shall create a client of the mux by calling `amqp_management_mux_client_create`. ]*/
+/* Tests_SRS_CBS_01_122: [ `cbs_create_with_management_mux` shall set the override status code and status description key names on the mux to `status-code` and `status-description` by calling `amqp_management_mux_set_override_status_code_key_name` and `amqp_management_mux_set_override_status_description_key_name`. ]*/
+TEST_FUNCTION(cbs_create_with_management_mux_returns_a_valid_handle)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(amqp_management_mux_set_override_status_code_key_name(test_amqp_management_mux, "status-code"));
+    STRICT_EXPECTED_CALL(amqp_management_mux_set_override_status_description_key_name(test_amqp_management_mux, "status-description"));
+    STRICT_EXPECTED_CALL(amqp_management_mux_client_create(test_amqp_management_mux));
+
+    // act
+    cbs = cbs_create_with_management_mux(test_amqp_management_mux);
+
+    // assert
+    ASSERT_IS_NOT_NULL(cbs);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_destroy(cbs);
+}
+
+/* Tests_SRS_CBS_01_120: [ If `amqp_management_mux` is NULL then `cbs_create_with_management_mux` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_create_with_management_mux_with_NULL_mux_fails)
+{
+    // arrange
+    CBS_HANDLE cbs;
+
+    // act
+    cbs = cbs_create_with_management_mux(NULL);
+
+    // assert
+    ASSERT_IS_NULL(cbs);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_01_123: [ If any error occurs, `cbs_create_with_management_mux` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_cbs_create_with_management_mux_fails_then_cbs_create_with_management_mux_fails)
+{
+    // arrange
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(amqp_management_mux_set_override_status_code_key_name(test_amqp_management_mux, "status-code"))
+        .SetFailReturn(1);
+    STRICT_EXPECTED_CALL(amqp_management_mux_set_override_status_description_key_name(test_amqp_management_mux, "status-description"))
+        .SetFailReturn(1);
+    STRICT_EXPECTED_CALL(amqp_management_mux_client_create(test_amqp_management_mux))
+        .SetFailReturn(NULL);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        char tmp_msg[128];
+        CBS_HANDLE cbs;
+        (void)sprintf(tmp_msg, "Failure in test %u/%u", (unsigned int)(index + 1), (unsigned int)count);
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        cbs = cbs_create_with_management_mux(test_amqp_management_mux);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(cbs, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+/* Tests_SRS_CBS_01_124: [ A CBS instance created with `cbs_create_with_management_mux` shall open, close and execute operations through its mux client by calling `amqp_management_mux_client_open_async`, `amqp_management_mux_client_close` and `amqp_management_mux_client_execute_operation_async` instead of the AMQP management functions. ]*/
+TEST_FUNCTION(cbs_open_async_on_a_cbs_created_with_a_mux_opens_the_mux_client)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    int result;
+    cbs = cbs_create_with_management_mux(test_amqp_management_mux);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_mux_client_open_async(test_amqp_management_mux_client, IGNORED_PTR_ARG, cbs, IGNORED_PTR_ARG, cbs));
+
+    // act
+    result = cbs_open_async(cbs, test_on_cbs_open_complete, (void*)0x4242, test_on_cbs_error, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_destroy(cbs);
+}
+
+/* Tests_SRS_CBS_01_124: [ A CBS instance created with `cbs_create_with_management_mux` shall open, close and execute operations through its mux client by calling `amqp_management_mux_client_open_async`, `amqp_management_mux_client_close` and `amqp_management_mux_client_execute_operation_async` instead of the AMQP management functions. ]*/
+TEST_FUNCTION(cbs_close_on_a_cbs_created_with_a_mux_closes_the_mux_client)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    int result;
+    cbs = cbs_create_with_management_mux(test_amqp_management_mux);
+    (void)cbs_open_async(cbs, test_on_cbs_open_complete, (void*)0x4242, test_on_cbs_error, (void*)0x4243);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_mux_client_close(test_amqp_management_mux_client));
+    STRICT_EXPECTED_CALL(test_on_cbs_open_complete((void*)0x4242, CBS_OPEN_CANCELLED));
+
+    // act
+    result = cbs_close(cbs);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_destroy(cbs);
+}
+
+/* Tests_SRS_CBS_01_125: [ `cbs_destroy` shall free the mux client created in `cbs_create_with_management_mux` by calling `amqp_management_mux_client_destroy`. ]*/
+TEST_FUNCTION(cbs_destroy_on_a_cbs_created_with_a_mux_destroys_the_mux_client)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    cbs = cbs_create_with_management_mux(test_amqp_management_mux);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_mux_client_destroy(test_amqp_management_mux_client));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(test_singlylinkedlist));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(test_singlylinkedlist));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    cbs_destroy(cbs);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CBS_01_126: [ For a CBS instance created with `cbs_create_with_management_mux`, `cbs_set_trace` shall call `amqp_management_mux_set_trace`, which affects all clients of the mux. ]*/
+TEST_FUNCTION(cbs_set_trace_on_a_cbs_created_with_a_mux_sets_the_trace_on_the_mux)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    int result;
+    cbs = cbs_create_with_management_mux(test_amqp_management_mux);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_management_mux_set_trace(test_amqp_management_mux, true));
+
+    // act
+    result = cbs_set_trace(cbs, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    cbs_destroy(cbs);
+}
+
 /* cbs_destroy */
 
 /* Tests_SRS_CBS_01_036: [ `cbs_destroy` shall free all resources associated with the handle `cbs`. ]*/
@@ -2056,4 +2235,176 @@ TEST_FUNCTION(on_amqp_management_operation_complete_with_INSTANCE_CLOSED_for_del
     cbs_destroy(cbs);
 }
 
+/* cbs_prepare_put_token */
+
+/* Tests_SRS_CBS_01_127: [ `cbs_prepare_put_token` shall prepare the `put-token` operation for `type` and `audience` by calling `amqp_management_prepare_operation` with `put-token`, `type`, NULL locales and an application properties map holding the `name` key with the `audience` value. ]*/
+TEST_FUNCTION(cbs_prepare_put_token_prepares_the_put_token_operation_with_the_audience_as_name)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_map())
+        .SetReturn(test_map_value);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("name"))
+        .SetReturn(test_name_propery_key);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("my_audience"))
+        .SetReturn(test_name_propery_value);
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_map_value, test_name_propery_key, test_name_propery_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_name_propery_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_name_propery_key));
+    STRICT_EXPECTED_CALL(amqp_management_prepare_operation("put-token", "some_type", NULL, test_map_value));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_map_value));
+
+    // act
+    result = cbs_prepare_put_token("some_type", "my_audience");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, test_prepared_put_token, result);
+}
+
+/* Tests_SRS_CBS_01_129: [ If any API fails, `cbs_prepare_put_token` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_amqp_management_prepare_operation_fails_cbs_prepare_put_token_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_map())
+        .SetReturn(test_map_value);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("name"));
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("my_audience"));
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_map_value, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_prepare_operation("put-token", "some_type", NULL, test_map_value))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_map_value));
+
+    // act
+    result = cbs_prepare_put_token("some_type", "my_audience");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_CBS_01_128: [ If `type` or `audience` is NULL, `cbs_prepare_put_token` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_prepare_put_token_with_NULL_type_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    // act
+    result = cbs_prepare_put_token(NULL, "my_audience");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_CBS_01_128: [ If `type` or `audience` is NULL, `cbs_prepare_put_token` shall fail and return NULL. ]*/
+TEST_FUNCTION(cbs_prepare_put_token_with_NULL_audience_fails)
+{
+    // arrange
+    AMQP_MANAGEMENT_PREPARED_OPERATION_HANDLE result;
+
+    // act
+    result = cbs_prepare_put_token("some_type", NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
+}
+
+/* cbs_put_token_prepared_async */
+
+/* Tests_SRS_CBS_01_130: [ `cbs_put_token_prepared_async` shall construct a request message with only the token as amqp-value body and start it by calling `amqp_management_execute_prepared_operation_async` with `prepared_put_token`, so that the operation, type and name are not encoded again. ]*/
+/* Tests_SRS_CBS_01_135: [ On success `cbs_put_token_prepared_async` shall return 0. ]*/
+TEST_FUNCTION(cbs_put_token_prepared_async_executes_the_prepared_operation_with_the_token_as_body)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    int result;
+    cbs = cbs_create(test_session_handle);
+    (void)cbs_open_async(cbs, test_on_cbs_open_complete, (void*)0x4242, test_on_cbs_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(message_create());
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("blah_token"))
+        .SetReturn(test_token_value);
+    STRICT_EXPECTED_CALL(message_set_body_amqp_value(test_message, test_token_value));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(test_singlylinkedlist, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_management_execute_prepared_operation_async(test_amqp_management_handle, test_prepared_put_token, test_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_token_value));
+    STRICT_EXPECTED_CALL(message_destroy(test_message));
+
+    // act
+    result = cbs_put_token_prepared_async(cbs, test_prepared_put_token, "blah_token", test_on_cbs_put_token_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    cbs_destroy(cbs);
+}
+
+/* Tests_SRS_CBS_01_131: [ If any of the arguments `cbs`, `prepared_put_token`, `token` or `on_cbs_put_token_complete` is NULL `cbs_put_token_prepared_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_put_token_prepared_async_with_NULL_cbs_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = cbs_put_token_prepared_async(NULL, test_prepared_put_token, "blah_token", test_on_cbs_put_token_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CBS_01_131: [ If any of the arguments `cbs`, `prepared_put_token`, `token` or `on_cbs_put_token_complete` is NULL `cbs_put_token_prepared_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_put_token_prepared_async_with_NULL_prepared_put_token_fails)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    int result;
+    cbs = cbs_create(test_session_handle);
+    (void)cbs_open_async(cbs, test_on_cbs_open_complete, (void*)0x4242, test_on_cbs_error, (void*)0x4243);
+    saved_on_amqp_management_open_complete(saved_on_amqp_management_open_complete_context, AMQP_MANAGEMENT_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_put_token_prepared_async(cbs, NULL, "blah_token", test_on_cbs_put_token_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    cbs_destroy(cbs);
+}
+
+/* Tests_SRS_CBS_01_132: [ If `cbs_put_token_prepared_async` is called when the CBS instance is not yet open or in error, it shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(cbs_put_token_prepared_async_when_not_open_fails)
+{
+    // arrange
+    CBS_HANDLE cbs;
+    int result;
+    cbs = cbs_create(test_session_handle);
+    umock_c_reset_all_calls();
+
+    // act
+    result = cbs_put_token_prepared_async(cbs, test_prepared_put_token, "blah_token", test_on_cbs_put_token_complete, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    cbs_destroy(cbs);
+}
+
 END_TEST_SUITE(cbs_ut)
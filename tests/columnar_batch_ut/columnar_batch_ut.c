@@ -0,0 +1,623 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/columnar_batch.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static unsigned char test_message_bytes[512];
+
+/* message-annotations with a sequence number and an enqueued time, properties with a subject when subject is not NULL,
+   application-properties with a key when key is not NULL and a ratio, and two data sections */
+static size_t encode_test_message(int64_t sequence_number, const char* subject, const char* key, const char* body)
+{
+    AMQP_WRITER writer;
+    size_t length;
+
+    (void)amqp_writer_init(&writer, test_message_bytes, sizeof(test_message_bytes));
+    (void)amqp_writer_begin_described(&writer, 0x72);
+    (void)amqp_writer_begin_map(&writer);
+    (void)amqp_writer_put_symbol(&writer, "x-opt-sequence-number");
+    (void)amqp_writer_put_long(&writer, sequence_number);
+    (void)amqp_writer_put_symbol(&writer, "x-opt-enqueued-time");
+    (void)amqp_writer_put_timestamp(&writer, sequence_number * 1000);
+    (void)amqp_writer_end(&writer);
+    if (subject != NULL)
+    {
+        (void)amqp_writer_begin_described(&writer, 0x73);
+        (void)amqp_writer_begin_list(&writer);
+        (void)amqp_writer_put_null(&writer);
+        (void)amqp_writer_put_null(&writer);
+        (void)amqp_writer_put_null(&writer);
+        (void)amqp_writer_put_string(&writer, subject);
+        (void)amqp_writer_end(&writer);
+    }
+    (void)amqp_writer_begin_described(&writer, 0x74);
+    (void)amqp_writer_begin_map(&writer);
+    if (key != NULL)
+    {
+        (void)amqp_writer_put_string(&writer, "key");
+        (void)amqp_writer_put_string(&writer, key);
+    }
+    (void)amqp_writer_put_string(&writer, "ratio");
+    (void)amqp_writer_put_int(&writer, 3);
+    (void)amqp_writer_end(&writer);
+    (void)amqp_writer_begin_described(&writer, 0x75);
+    (void)amqp_writer_put_binary(&writer, body, (uint32_t)strlen(body));
+    (void)amqp_writer_begin_described(&writer, 0x75);
+    (void)amqp_writer_put_binary(&writer, "!", 1);
+    (void)amqp_writer_get_length(&writer, &length);
+
+    return length;
+}
+
+static size_t encode_amqp_value_message(void)
+{
+    AMQP_WRITER writer;
+    size_t length;
+
+    (void)amqp_writer_init(&writer, test_message_bytes, sizeof(test_message_bytes));
+    (void)amqp_writer_begin_described(&writer, 0x77);
+    (void)amqp_writer_put_string(&writer, "value");
+    (void)amqp_writer_get_length(&writer, &length);
+
+    return length;
+}
+
+static COLUMNAR_BATCH_HANDLE create_batch_with_columns(uint32_t max_rows, size_t* sequence_number_column, size_t* key_column, size_t* ratio_column, size_t* subject_column)
+{
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(max_rows);
+    ASSERT_IS_NOT_NULL(batch);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION, "x-opt-sequence-number", COLUMNAR_BATCH_COLUMN_TYPE_INT64, sequence_number_column));
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_APPLICATION_PROPERTY, "key", COLUMNAR_BATCH_COLUMN_TYPE_STRING, key_column));
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_APPLICATION_PROPERTY, "ratio", COLUMNAR_BATCH_COLUMN_TYPE_DOUBLE, ratio_column));
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_PROPERTY, "subject", COLUMNAR_BATCH_COLUMN_TYPE_STRING, subject_column));
+    umock_c_reset_all_calls();
+    return batch;
+}
+
+BEGIN_TEST_SUITE(columnar_batch_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* columnar_batch_create */
+
+/* Tests_SRS_COLUMNAR_BATCH_01_001: [ `columnar_batch_create` shall create an empty batch of at most `max_rows` rows, with the delivery id and body columns only, and on success return a non-NULL handle to it. ]*/
+TEST_FUNCTION(columnar_batch_create_returns_an_empty_batch)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch;
+    uint32_t row_count;
+    uint32_t max_row_count;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(11, sizeof(size_t)));
+
+    // act
+    batch = columnar_batch_create(10);
+
+    // assert
+    ASSERT_IS_NOT_NULL(batch);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_row_count(batch, &row_count));
+    ASSERT_ARE_EQUAL(uint32_t, 0, row_count);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_max_row_count(batch, &max_row_count));
+    ASSERT_ARE_EQUAL(uint32_t, 10, max_row_count);
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_002: [ If `max_rows` is 0 or too big for its columns to be allocated, `columnar_batch_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(columnar_batch_create_with_0_max_rows_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch;
+
+    // act
+    batch = columnar_batch_create(0);
+
+    // assert
+    ASSERT_IS_NULL(batch);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_003: [ If any allocation fails, `columnar_batch_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_body_offsets_fails_columnar_batch_create_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(11, sizeof(size_t)))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    batch = columnar_batch_create(10);
+
+    // assert
+    ASSERT_IS_NULL(batch);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* columnar_batch_destroy */
+
+/* Tests_SRS_COLUMNAR_BATCH_01_005: [ If `batch` is NULL, `columnar_batch_destroy` shall do nothing. ]*/
+TEST_FUNCTION(columnar_batch_destroy_with_NULL_batch_does_nothing)
+{
+    // arrange
+
+    // act
+    columnar_batch_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* columnar_batch_add_column */
+
+/* Tests_SRS_COLUMNAR_BATCH_01_006: [ `columnar_batch_add_column` shall add a column of type `column_type` for the message annotation, properties field or application property `name`, as given by `source`, set `column_index` to its index and return 0. ]*/
+TEST_FUNCTION(columnar_batch_add_column_gives_the_columns_consecutive_indexes)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    size_t first_column;
+    size_t second_column;
+    int first_result;
+    int second_result;
+
+    // act
+    first_result = columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION, "x-opt-offset", COLUMNAR_BATCH_COLUMN_TYPE_STRING, &first_column);
+    second_result = columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_PROPERTY, "creation-time", COLUMNAR_BATCH_COLUMN_TYPE_INT64, &second_column);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, first_result);
+    ASSERT_ARE_EQUAL(int, 0, second_result);
+    ASSERT_ARE_EQUAL(size_t, 0, first_column);
+    ASSERT_ARE_EQUAL(size_t, 1, second_column);
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_007: [ If `batch`, `name` or `column_index` is NULL, or `source` or `column_type` is not a known value, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(columnar_batch_add_column_with_NULL_name_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    size_t column_index;
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION, NULL, COLUMNAR_BATCH_COLUMN_TYPE_INT64, &column_index);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_009: [ If `source` is `COLUMNAR_BATCH_SOURCE_PROPERTY` and `name` is not the name of a field of the properties section, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(columnar_batch_add_column_for_an_unknown_properties_field_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    size_t column_index;
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_PROPERTY, "creation_time", COLUMNAR_BATCH_COLUMN_TYPE_INT64, &column_index);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_008: [ If the batch has rows, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(columnar_batch_add_column_on_a_batch_with_rows_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    size_t length = encode_test_message(1, NULL, NULL, "body");
+    size_t column_index;
+    int result;
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_append_message(batch, 1, test_message_bytes, length));
+    umock_c_reset_all_calls();
+
+    // act
+    result = columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION, "x-opt-sequence-number", COLUMNAR_BATCH_COLUMN_TYPE_INT64, &column_index);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_010: [ If any allocation fails, `columnar_batch_add_column` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_growing_the_columns_fails_columnar_batch_add_column_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    size_t column_index;
+    int result;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = columnar_batch_add_column(batch, COLUMNAR_BATCH_SOURCE_MESSAGE_ANNOTATION, "x-opt-sequence-number", COLUMNAR_BATCH_COLUMN_TYPE_INT64, &column_index);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* columnar_batch_append_message */
+
+/* Tests_SRS_COLUMNAR_BATCH_01_011: [ `columnar_batch_append_message` shall read the sections encoded in the `length` bytes of `bytes` with the AMQP reader, without decoding them into AMQP values, add a row holding `delivery_id`, the body and the value of every column and return 0. ]*/
+/* Tests_SRS_COLUMNAR_BATCH_01_016: [ A column value missing from the message, or of a type the column cannot hold, shall be marked as not present. ]*/
+TEST_FUNCTION(columnar_batch_append_message_lays_out_the_columns)
+{
+    // arrange
+    size_t sequence_number_column;
+    size_t key_column;
+    size_t ratio_column;
+    size_t subject_column;
+    COLUMNAR_BATCH_HANDLE batch = create_batch_with_columns(10, &sequence_number_column, &key_column, &ratio_column, &subject_column);
+    const delivery_number* delivery_ids;
+    const int64_t* sequence_numbers;
+    const double* ratios;
+    const char* characters;
+    const size_t* offsets;
+    const bool* is_present;
+    uint32_t row_count;
+    size_t length;
+    int first_result;
+    int second_result;
+
+    // act
+    length = encode_test_message(42, "subject", "alpha", "hello");
+    first_result = columnar_batch_append_message(batch, 7, test_message_bytes, length);
+    length = encode_test_message(43, NULL, NULL, "world");
+    second_result = columnar_batch_append_message(batch, 8, test_message_bytes, length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, first_result);
+    ASSERT_ARE_EQUAL(int, 0, second_result);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_row_count(batch, &row_count));
+    ASSERT_ARE_EQUAL(uint32_t, 2, row_count);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_delivery_ids(batch, &delivery_ids));
+    ASSERT_ARE_EQUAL(uint32_t, 7, delivery_ids[0]);
+    ASSERT_ARE_EQUAL(uint32_t, 8, delivery_ids[1]);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_int64_column(batch, sequence_number_column, &sequence_numbers, &is_present));
+    ASSERT_IS_TRUE(is_present[0]);
+    ASSERT_IS_TRUE(is_present[1]);
+    ASSERT_IS_TRUE(sequence_numbers[0] == 42);
+    ASSERT_IS_TRUE(sequence_numbers[1] == 43);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_double_column(batch, ratio_column, &ratios, &is_present));
+    ASSERT_IS_TRUE(is_present[0]);
+    ASSERT_IS_TRUE(ratios[0] == 3.0);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_string_column(batch, key_column, &characters, &offsets, &is_present));
+    ASSERT_IS_TRUE(is_present[0]);
+    ASSERT_IS_FALSE(is_present[1]);
+    ASSERT_ARE_EQUAL(size_t, 0, offsets[0]);
+    ASSERT_ARE_EQUAL(size_t, 5, offsets[1]);
+    ASSERT_ARE_EQUAL(size_t, 5, offsets[2]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(characters, "alpha", 5));
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_string_column(batch, subject_column, &characters, &offsets, &is_present));
+    ASSERT_IS_TRUE(is_present[0]);
+    ASSERT_IS_FALSE(is_present[1]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(characters, "subject", 7));
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_015: [ The body of the row shall be the concatenation of the data sections of the message, or the bytes of its amqp-value section if it holds a binary or a string, and shall be empty otherwise. ]*/
+TEST_FUNCTION(columnar_batch_append_message_puts_the_bodies_in_one_buffer)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    const unsigned char* body_bytes;
+    const size_t* body_offsets;
+    size_t length;
+
+    // act
+    length = encode_test_message(1, NULL, NULL, "hello");
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_append_message(batch, 1, test_message_bytes, length));
+    length = encode_amqp_value_message();
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_append_message(batch, 2, test_message_bytes, length));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_bodies(batch, &body_bytes, &body_offsets));
+    ASSERT_ARE_EQUAL(size_t, 0, body_offsets[0]);
+    ASSERT_ARE_EQUAL(size_t, 6, body_offsets[1]);
+    ASSERT_ARE_EQUAL(size_t, 11, body_offsets[2]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(body_bytes, "hello!value", 11));
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_012: [ If `batch` or `bytes` is NULL, `columnar_batch_append_message` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(columnar_batch_append_message_with_NULL_bytes_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = columnar_batch_append_message(batch, 1, NULL, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_013: [ If the batch holds `max_rows` rows, `columnar_batch_append_message` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(columnar_batch_append_message_on_a_full_batch_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(1);
+    size_t length = encode_test_message(1, NULL, NULL, "body");
+    uint32_t row_count;
+    int result;
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_append_message(batch, 1, test_message_bytes, length));
+
+    // act
+    result = columnar_batch_append_message(batch, 2, test_message_bytes, length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_row_count(batch, &row_count));
+    ASSERT_ARE_EQUAL(uint32_t, 1, row_count);
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_014: [ If the bytes cannot be read as message sections, or growing the bodies or a string column fails, `columnar_batch_append_message` shall fail, not add the row and return a non-zero value. ]*/
+TEST_FUNCTION(columnar_batch_append_message_with_truncated_bytes_fails_and_adds_no_row)
+{
+    // arrange
+    size_t sequence_number_column;
+    size_t key_column;
+    size_t ratio_column;
+    size_t subject_column;
+    COLUMNAR_BATCH_HANDLE batch = create_batch_with_columns(10, &sequence_number_column, &key_column, &ratio_column, &subject_column);
+    size_t length = encode_test_message(1, "subject", "alpha", "body");
+    const char* characters;
+    const size_t* offsets;
+    const bool* is_present;
+    uint32_t row_count;
+    int result;
+
+    // act
+    result = columnar_batch_append_message(batch, 1, test_message_bytes, length - 3);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_row_count(batch, &row_count));
+    ASSERT_ARE_EQUAL(uint32_t, 0, row_count);
+
+    // the next row takes the place of the failed one
+    length = encode_test_message(2, NULL, "beta", "body");
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_append_message(batch, 2, test_message_bytes, length));
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_string_column(batch, key_column, &characters, &offsets, &is_present));
+    ASSERT_IS_TRUE(is_present[0]);
+    ASSERT_ARE_EQUAL(size_t, 4, offsets[1]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(characters, "beta", 4));
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_014: [ If the bytes cannot be read as message sections, or growing the bodies or a string column fails, `columnar_batch_append_message` shall fail, not add the row and return a non-zero value. ]*/
+TEST_FUNCTION(when_growing_the_bodies_fails_columnar_batch_append_message_fails)
+{
+    // arrange
+    COLUMNAR_BATCH_HANDLE batch = columnar_batch_create(10);
+    size_t length = encode_test_message(1, NULL, NULL, "body");
+    int result;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = columnar_batch_append_message(batch, 1, test_message_bytes, length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* columnar_batch_clear */
+
+/* Tests_SRS_COLUMNAR_BATCH_01_017: [ `columnar_batch_clear` shall remove all the rows of the batch, keeping its columns. ]*/
+TEST_FUNCTION(columnar_batch_clear_removes_the_rows)
+{
+    // arrange
+    size_t sequence_number_column;
+    size_t key_column;
+    size_t ratio_column;
+    size_t subject_column;
+    COLUMNAR_BATCH_HANDLE batch = create_batch_with_columns(1, &sequence_number_column, &key_column, &ratio_column, &subject_column);
+    size_t length = encode_test_message(1, NULL, NULL, "body");
+    const int64_t* sequence_numbers;
+    const bool* is_present;
+    uint32_t row_count;
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_append_message(batch, 1, test_message_bytes, length));
+
+    // act
+    columnar_batch_clear(batch);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_row_count(batch, &row_count));
+    ASSERT_ARE_EQUAL(uint32_t, 0, row_count);
+    length = encode_test_message(2, NULL, NULL, "body");
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_append_message(batch, 2, test_message_bytes, length));
+    ASSERT_ARE_EQUAL(int, 0, columnar_batch_get_int64_column(batch, sequence_number_column, &sequence_numbers, &is_present));
+    ASSERT_IS_TRUE(sequence_numbers[0] == 2);
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* column getters */
+
+/* Tests_SRS_COLUMNAR_BATCH_01_029: [ If there is no column `column_index`, or it is not of the type asked for, the column getters shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(getting_a_column_as_another_type_fails)
+{
+    // arrange
+    size_t sequence_number_column;
+    size_t key_column;
+    size_t ratio_column;
+    size_t subject_column;
+    COLUMNAR_BATCH_HANDLE batch = create_batch_with_columns(10, &sequence_number_column, &key_column, &ratio_column, &subject_column);
+    const double* values;
+    const bool* is_present;
+    int wrong_type_result;
+    int no_column_result;
+
+    // act
+    wrong_type_result = columnar_batch_get_double_column(batch, sequence_number_column, &values, &is_present);
+    no_column_result = columnar_batch_get_double_column(batch, 4, &values, &is_present);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, wrong_type_result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_column_result);
+
+    // cleanup
+    columnar_batch_destroy(batch);
+}
+
+/* Tests_SRS_COLUMNAR_BATCH_01_026: [ If `batch`, `body_bytes` or `body_offsets` is NULL, `columnar_batch_get_bodies` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(columnar_batch_get_bodies_with_NULL_batch_fails)
+{
+    // arrange
+    const unsigned char* body_bytes;
+    const size_t* body_offsets;
+    int result;
+
+    // act
+    result = columnar_batch_get_bodies(NULL, &body_bytes, &body_offsets);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+END_TEST_SUITE(columnar_batch_ut)
@@ -38,6 +38,9 @@ static void my_gballoc_free(void* ptr)
 #include "azure_uamqp_c/amqp_frame_codec.h"
 #include "azure_uamqp_c/amqpvalue_to_string.h"
 #include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/frame_trace.h"
+#include "azure_uamqp_c/admission_limiter.h"
+#include "azure_uamqp_c/buffer_pool.h"
 
 #undef ENABLE_MOCKS
 
@@ -58,6 +61,9 @@ static void my_gballoc_free(void* ptr)
 
 #define TEST_IO_HANDLE                    (XIO_HANDLE)0x4242
 #define TEST_FRAME_CODEC_HANDLE            (FRAME_CODEC_HANDLE)0x4243
+#define TEST_FRAME_TRACE_HANDLE            (FRAME_TRACE_HANDLE)0x4250
+#define TEST_ADMISSION_LIMITER_HANDLE      (ADMISSION_LIMITER_HANDLE)0x4251
+#define TEST_BUFFER_POOL_HANDLE            (BUFFER_POOL_HANDLE)0x4252
 #define TEST_AMQP_FRAME_CODEC_HANDLE    (AMQP_FRAME_CODEC_HANDLE)0x4244
 #define TEST_DESCRIPTOR_AMQP_VALUE        (AMQP_VALUE)0x4245
 #define TEST_LIST_ITEM_AMQP_VALUE        (AMQP_VALUE)0x4246
@@ -93,7 +99,12 @@ static AMQP_FRAME_RECEIVED_CALLBACK saved_frame_received_callback;
 static AMQP_EMPTY_FRAME_RECEIVED_CALLBACK saved_empty_frame_received_callback;
 static AMQP_FRAME_CODEC_ERROR_CALLBACK saved_amqp_frame_codec_error_callback;
 static void* saved_amqp_frame_codec_callback_context;
+static ON_AMQP_PERFORMATIVE_BYTES saved_on_performative_bytes;
+static void* saved_on_performative_bytes_context;
 static void* saved_on_connection_state_changed_context;
+static AMQP_READER_ITEM handover_state_items[8];
+static size_t handover_state_item_count;
+static size_t handover_state_item_index;
 static CONNECTION_STATE saved_new_connection_state;
 CONNECTION_STATE saved_previous_connection_state;
 
@@ -120,10 +131,12 @@ static char expected_stringified_io[8192];
 static char actual_stringified_io[8192];
 
 /* frame received callback */
-MOCK_FUNCTION_WITH_CODE(, void, test_on_frame_received, void*, context, AMQP_VALUE, performative, uint32_t, frame_payload_size, const unsigned char*, payload_bytes)
+MOCK_FUNCTION_WITH_CODE(, void, test_on_frame_received, void*, context, AMQP_VALUE, performative, uint64_t, performative_code, uint32_t, frame_payload_size, const unsigned char*, payload_bytes)
 MOCK_FUNCTION_END();
 MOCK_FUNCTION_WITH_CODE(, void, test_on_connection_state_changed, void*, context, CONNECTION_STATE, new_connection_state, CONNECTION_STATE, previous_connection_state)
 MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_endpoint_dowork, void*, context)
+MOCK_FUNCTION_END();
 
 static int my_xio_open(XIO_HANDLE io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
 {
@@ -138,6 +151,43 @@ static int my_xio_open(XIO_HANDLE io, ON_IO_OPEN_COMPLETE on_io_open_complete, v
     return 0;
 }
 
+static int my_amqp_reader_next(AMQP_READER* reader, AMQP_READER_ITEM* item)
+{
+    int result;
+    (void)reader;
+
+    if (handover_state_item_index >= handover_state_item_count)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        *item = handover_state_items[handover_state_item_index++];
+        result = 0;
+    }
+
+    return result;
+}
+
+/* the list an opened connection saves, with a max frame size of 4096 and a remote one of 8192 */
+static void setup_handover_state_items(void)
+{
+    size_t i;
+    const uint32_t values[] = { 1, 4096, 8192, 15, 0, 0 };
+
+    (void)memset(handover_state_items, 0, sizeof(handover_state_items));
+    handover_state_items[0].type = AMQP_TYPE_LIST;
+    handover_state_items[0].count = sizeof(values) / sizeof(values[0]);
+    for (i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        handover_state_items[i + 1].type = AMQP_TYPE_UINT;
+        handover_state_items[i + 1].value.unsigned_value = values[i];
+    }
+
+    handover_state_item_count = 1 + sizeof(values) / sizeof(values[0]);
+    handover_state_item_index = 0;
+}
+
 static int my_frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned char* buffer, size_t size)
 {
     unsigned char* new_frame_codec_bytes = (unsigned char*)my_gballoc_realloc(frame_codec_bytes, frame_codec_byte_count + size);
@@ -151,6 +201,21 @@ static int my_frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const un
     return 0;
 }
 
+static ON_FRAME_CODEC_GET_RECEIVE_BUFFER saved_get_receive_buffer;
+static ON_FRAME_CODEC_GROW_RECEIVE_BUFFER saved_grow_receive_buffer;
+static ON_FRAME_CODEC_RELEASE_RECEIVE_BUFFER saved_release_receive_buffer;
+static void* saved_receive_buffer_pool_context;
+
+static int my_frame_codec_set_receive_buffer_pool(FRAME_CODEC_HANDLE frame_codec, ON_FRAME_CODEC_GET_RECEIVE_BUFFER get_receive_buffer, ON_FRAME_CODEC_GROW_RECEIVE_BUFFER grow_receive_buffer, ON_FRAME_CODEC_RELEASE_RECEIVE_BUFFER release_receive_buffer, void* pool_context)
+{
+    (void)frame_codec;
+    saved_get_receive_buffer = get_receive_buffer;
+    saved_grow_receive_buffer = grow_receive_buffer;
+    saved_release_receive_buffer = release_receive_buffer;
+    saved_receive_buffer_pool_context = pool_context;
+    return 0;
+}
+
 /* amqp_frame_codec */
 static AMQP_FRAME_CODEC_HANDLE my_amqp_frame_codec_create(FRAME_CODEC_HANDLE frame_codec, AMQP_FRAME_RECEIVED_CALLBACK frame_received_callback, AMQP_EMPTY_FRAME_RECEIVED_CALLBACK empty_frame_received_callback, AMQP_FRAME_CODEC_ERROR_CALLBACK amqp_frame_codec_error_callback, void* callback_context)
 {
@@ -162,6 +227,14 @@ static AMQP_FRAME_CODEC_HANDLE my_amqp_frame_codec_create(FRAME_CODEC_HANDLE fra
     return TEST_AMQP_FRAME_CODEC_HANDLE;
 }
 
+static int my_amqp_frame_codec_set_on_performative_bytes(AMQP_FRAME_CODEC_HANDLE amqp_frame_codec, ON_AMQP_PERFORMATIVE_BYTES on_performative_bytes, void* context)
+{
+    (void)amqp_frame_codec;
+    saved_on_performative_bytes = on_performative_bytes;
+    saved_on_performative_bytes_context = context;
+    return 0;
+}
+
 static int my_amqpvalue_get_ulong(AMQP_VALUE value, uint64_t* ulong_value)
 {
     (void)value;
@@ -245,8 +318,11 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(frame_codec_receive_bytes, my_frame_codec_receive_bytes);
     REGISTER_GLOBAL_MOCK_RETURN(frame_codec_create, TEST_FRAME_CODEC_HANDLE);
     REGISTER_GLOBAL_MOCK_RETURN(frame_codec_set_max_frame_size, 0);
+    REGISTER_GLOBAL_MOCK_HOOK(frame_codec_set_receive_buffer_pool, my_frame_codec_set_receive_buffer_pool);
     REGISTER_GLOBAL_MOCK_HOOK(amqp_frame_codec_create, my_amqp_frame_codec_create);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_frame_codec_set_on_performative_bytes, my_amqp_frame_codec_set_on_performative_bytes);
     REGISTER_GLOBAL_MOCK_RETURN(amqp_frame_codec_encode_frame, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(amqp_frame_codec_encode_frame_with_encoded_performative, 0);
     REGISTER_GLOBAL_MOCK_RETURN(amqp_frame_codec_encode_empty_frame, 0);
     REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_get_ulong, my_amqpvalue_get_ulong);
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_inplace_descriptor, TEST_DESCRIPTOR_AMQP_VALUE);
@@ -262,6 +338,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_RETURN(tickcounter_get_current_ms, 0);
     REGISTER_GLOBAL_MOCK_RETURN(fields_clone, TEST_CLONED_PROPERTIES);
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_clone, TEST_CLONED_PROPERTIES);
+    REGISTER_GLOBAL_MOCK_HOOK(amqp_reader_next, my_amqp_reader_next);
+    REGISTER_GLOBAL_MOCK_RETURN(frame_codec_is_at_frame_boundary, true);
 
     REGISTER_UMOCK_ALIAS_TYPE(CONNECTION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_FRAME_CODEC_ERROR, void*);
@@ -269,10 +347,19 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_FRAME_RECEIVED_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_EMPTY_FRAME_RECEIVED_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_FRAME_CODEC_ERROR_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_AMQP_PERFORMATIVE_BYTES, void*);
     REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_FRAME_CODEC_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(AMQP_VALUE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(FRAME_TRACE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ADMISSION_LIMITER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(BUFFER_POOL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_FRAME_CODEC_GET_RECEIVE_BUFFER, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_FRAME_CODEC_GROW_RECEIVE_BUFFER, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_FRAME_CODEC_RELEASE_RECEIVE_BUFFER, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(FRAME_TRACE_DIRECTION, int);
+    REGISTER_UMOCK_ALIAS_TYPE(FRAME_TRACE_FRAME_TYPE, int);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -295,6 +382,8 @@ TEST_FUNCTION_INITIALIZE(method_init)
     frame_codec_bytes = NULL;
     frame_codec_byte_count = 0;
     performative_ulong = 0x10;
+    handover_state_item_count = 0;
+    handover_state_item_index = 0;
 }
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -931,367 +1020,2991 @@ TEST_FUNCTION(connection_get_idle_timeout_default_value_succeeds)
     connection_destroy(connection);
 }
 
-/* connection_dowork */
+/* connection_set_outgoing_batch_size */
 
-/* Tests_SRS_CONNECTION_01_078: [If handle is NULL, connection_dowork shall do nothing.] */
-TEST_FUNCTION(connection_dowork_with_NULL_handle_does_nothing)
+/* Tests_SRS_CONNECTION_01_286: [If connection is NULL, connection_set_outgoing_batch_size shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_outgoing_batch_size_with_NULL_connection_fails)
 {
     // arrange
 
     // act
-    connection_dowork(NULL);
+    int result = connection_set_outgoing_batch_size(NULL, 16384);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_: [If the io has not been opened before, connection_dowork shall attempt to open the io by calling xio_open.] */
-TEST_FUNCTION(when_io_state_is_not_open_connection_dowork_opens_the_io)
+/* Tests_SRS_CONNECTION_01_275: [connection_set_outgoing_batch_size shall set the number of bytes of encoded frames that are accumulated before they are passed to the io in one xio_send call.] */
+/* Tests_SRS_CONNECTION_01_290: [On success, connection_set_outgoing_batch_size shall return 0.] */
+TEST_FUNCTION(connection_set_outgoing_batch_size_with_valid_connection_succeeds)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    uint32_t outgoing_batch_size;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
-
     // act
-    connection_dowork(connection);
+    int result = connection_set_outgoing_batch_size(connection, 16384);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)connection_get_outgoing_batch_size(connection, &outgoing_batch_size);
+    ASSERT_ARE_EQUAL(uint32_t, 16384, outgoing_batch_size);
 
     // cleanup
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_204: [If io_open_fails, no more work shall be done by connection_dowork and the connection shall be considered in the END state.] */
-TEST_FUNCTION(when_io_open_fails_the_connection_state_shall_be_set_to_END)
+/* connection_get_outgoing_batch_size */
+
+/* Tests_SRS_CONNECTION_01_291: [If connection or outgoing_batch_size are NULL, connection_get_outgoing_batch_size shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_outgoing_batch_size_with_NULL_connection_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
-    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_START));
+    uint32_t outgoing_batch_size;
 
     // act
-    connection_dowork(connection);
+    int result = connection_get_outgoing_batch_size(NULL, &outgoing_batch_size);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    connection_destroy_endpoint(endpoint);
-    connection_destroy(connection);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_CONNECTION_01_076: [connection_dowork shall schedule the underlying IO interface to do its work by calling xio_dowork.] */
-/* Tests_SRS_CONNECTION_01_084: [The connection state machine implementing the protocol requirements shall be run as part of connection_dowork.] */
-/* Tests_SRS_CONNECTION_01_086: [Prior to sending any frames on a connection, each peer MUST start by sending a protocol header that indicates the protocol version used on the connection.] */
-/* Tests_SRS_CONNECTION_01_087: [The protocol header consists of the upper case ASCII letters "AMQP" followed by a protocol id of zero, followed by three unsigned bytes representing the major, minor, and revision of the protocol version (currently 1 (MAJOR), 0 (MINOR), 0 (REVISION)). In total this is an 8-octet sequence] */
-/* Tests_SRS_CONNECTION_01_091: [The AMQP peer which acted in the role of the TCP client (i.e. the peer that actively opened the connection) MUST immediately send its outgoing protocol header on establishment of the TCP connection.] */
-/* Tests_SRS_CONNECTION_01_093: [_ When the client opens a new socket connection to a server, it MUST send a protocol header with the client's preferred protocol version.] */
-/* Tests_SRS_CONNECTION_01_104: [Sending the protocol header shall be done by using xio_send.] */
-/* Tests_SRS_CONNECTION_01_041: [HDR SENT In this state the connection header has been sent to the peer but no connection header has been received.] */
-TEST_FUNCTION(connection_dowork_when_state_is_start_sends_the_AMQP_header_and_triggers_io_dowork)
+/* Tests_SRS_CONNECTION_01_291: [If connection or outgoing_batch_size are NULL, connection_get_outgoing_batch_size shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_outgoing_batch_size_with_NULL_outgoing_batch_size_argument_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
     umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
-
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, amqp_header, sizeof(amqp_header), IGNORED_PTR_ARG, NULL))
-        .ValidateArgumentBuffer(2, amqp_header, sizeof(amqp_header));
-    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
-
-    connection_dowork(connection);
 
     // act
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    int result = connection_get_outgoing_batch_size(connection, NULL);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 
     // cleanup
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_202: [If the io notifies the connection instance of an IO_STATE_ERROR state the connection shall be closed and the state set to END.] */
-TEST_FUNCTION(when_io_state_changes_to_ERROR_the_io_is_closed)
+/* Tests_SRS_CONNECTION_01_284: [By default outgoing frames shall not be batched.] */
+/* Tests_SRS_CONNECTION_01_292: [connection_get_outgoing_batch_size shall return in the outgoing_batch_size argument the current outgoing batch size setting.] */
+/* Tests_SRS_CONNECTION_01_293: [On success, connection_get_outgoing_batch_size shall return 0.] */
+TEST_FUNCTION(connection_get_outgoing_batch_size_returns_0_by_default)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
-    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
-    connection_dowork(connection);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    uint32_t outgoing_batch_size = 42;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_START));
-
     // act
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_ERROR, IO_STATE_NOT_OPEN);
+    int result = connection_get_outgoing_batch_size(connection, &outgoing_batch_size);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint32_t, 0, outgoing_batch_size);
 
     // cleanup
-    connection_destroy_endpoint(endpoint);
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_057: [END In this state it is illegal for either endpoint to write anything more onto the connection. The connection can be safely closed and discarded.] */
-/* Tests_SRS_CONNECTION_01_106: [When sending the protocol header fails, the connection shall be immediately closed.] */
-TEST_FUNCTION(when_sending_the_header_fails_the_io_is_closed)
+/* connection_set_outgoing_batch_delay */
+
+/* Tests_SRS_CONNECTION_01_351: [If connection is NULL, connection_set_outgoing_batch_delay shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_outgoing_batch_delay_with_NULL_connection_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
-    connection_dowork(connection);
-    umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
-
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, amqp_header, sizeof(amqp_header), IGNORED_PTR_ARG, NULL))
-        .ValidateArgumentBuffer(2, amqp_header, sizeof(amqp_header))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_START));
 
     // act
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    int result = connection_set_outgoing_batch_delay(NULL, 5);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    connection_destroy_endpoint(endpoint);
-    connection_destroy(connection);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
-TEST_FUNCTION(when_protocol_headers_do_not_match_connection_gets_closed)
+/* Tests_SRS_CONNECTION_01_348: [connection_set_outgoing_batch_delay shall set the number of milliseconds for which connection_dowork holds the bytes in the outgoing batch before flushing them.] */
+/* Tests_SRS_CONNECTION_01_352: [On success, connection_set_outgoing_batch_delay shall return 0.] */
+TEST_FUNCTION(connection_set_outgoing_batch_delay_with_valid_connection_succeeds)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    milliseconds outgoing_batch_delay;
     umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'Q', 0, 1, 0, 0 };
-
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_HDR_SENT));
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_set_outgoing_batch_delay(connection, 5);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)connection_get_outgoing_batch_delay(connection, &outgoing_batch_delay);
+    ASSERT_ARE_EQUAL(uint32_t, 5, (uint32_t)outgoing_batch_delay);
 
     // cleanup
-    connection_destroy_endpoint(endpoint);
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
-TEST_FUNCTION(when_protocol_header_first_byte_does_not_match_connection_gets_closed)
+/* connection_get_outgoing_batch_delay */
+
+/* Tests_SRS_CONNECTION_01_353: [If connection or outgoing_batch_delay are NULL, connection_get_outgoing_batch_delay shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_outgoing_batch_delay_with_NULL_connection_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
-    umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'B' };
-
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_HDR_SENT));
+    milliseconds outgoing_batch_delay;
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_get_outgoing_batch_delay(NULL, &outgoing_batch_delay);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    connection_destroy_endpoint(endpoint);
-    connection_destroy(connection);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
-TEST_FUNCTION(when_protocol_header_last_byte_does_not_match_connection_gets_closed)
+/* Tests_SRS_CONNECTION_01_353: [If connection or outgoing_batch_delay are NULL, connection_get_outgoing_batch_delay shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_outgoing_batch_delay_with_NULL_outgoing_batch_delay_argument_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
     umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 1 };
-
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_HDR_SENT));
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_get_outgoing_batch_delay(connection, NULL);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 
     // cleanup
-    connection_destroy_endpoint(endpoint);
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
-TEST_FUNCTION(when_protocol_header_first_byte_matches_but_only_1st_byte_received_no_io_close_is_done)
+/* Tests_SRS_CONNECTION_01_350: [By default the outgoing batch shall be flushed on every connection_dowork.] */
+/* Tests_SRS_CONNECTION_01_354: [connection_get_outgoing_batch_delay shall return in the outgoing_batch_delay argument the current outgoing batch delay setting.] */
+/* Tests_SRS_CONNECTION_01_355: [On success, connection_get_outgoing_batch_delay shall return 0.] */
+TEST_FUNCTION(connection_get_outgoing_batch_delay_returns_0_by_default)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    milliseconds outgoing_batch_delay = 42;
     umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A' };
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_get_outgoing_batch_delay(connection, &outgoing_batch_delay);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint32_t, 0, (uint32_t)outgoing_batch_delay);
 
     // cleanup
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_134: [The container id field shall be filled with the container id specified in connection_create.] */
-/* Tests_SRS_CONNECTION_01_135: [If hostname has been specified by a call to connection_set_hostname, then that value shall be stamped in the open frame.] */
-/* Tests_SRS_CONNECTION_01_205: [Sending the AMQP OPEN frame shall be done by calling amqp_frame_codec_begin_encode_frame with channel number 0, the actual performative payload and 0 as payload_size.] */
-/* Tests_SRS_CONNECTION_01_151: [The connection max_frame_size setting shall be passed down to the frame_codec when the Open frame is sent.] */
-/* Tests_SRS_CONNECTION_01_137: [The max_frame_size connection setting shall be set in the open frame by using open_set_max_frame_size.] */
-/* Tests_SRS_CONNECTION_01_139: [The channel_max connection setting shall be set in the open frame by using open_set_channel_max.] */
-/* Tests_SRS_CONNECTION_01_004: [After establishing or accepting a TCP connection and sending the protocol header, each peer MUST send an open frame before sending any other frames.] */
-/* Tests_SRS_CONNECTION_01_002: [Each AMQP connection begins with an exchange of capabilities and limitations, including the maximum frame size.] */
-/* Tests_SRS_CONNECTION_01_005: [The open frame describes the capabilities and limits of that peer.] */
-/* Tests_SRS_CONNECTION_01_006: [The open frame can only be sent on channel 0.] */
-TEST_FUNCTION(when_the_header_is_received_an_open_frame_is_sent_out)
+/* connection_set_frame_size_alignment */
+
+/* Tests_SRS_CONNECTION_01_330: [If connection is NULL, connection_set_frame_size_alignment shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_frame_size_alignment_with_NULL_connection_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
-    umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
-
-    STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
-
-    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
-    STRICT_EXPECTED_CALL(open_create("1234"));
-    STRICT_EXPECTED_CALL(open_set_hostname(test_open_handle, "testhost"));
-    STRICT_EXPECTED_CALL(open_set_max_frame_size(test_open_handle, 4294967295));
-    STRICT_EXPECTED_CALL(open_set_channel_max(test_open_handle, 65535));
-    STRICT_EXPECTED_CALL(amqpvalue_create_open(test_open_handle));
-    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame(TEST_AMQP_FRAME_CODEC_HANDLE, 0, test_open_amqp_value, NULL, 0, NULL, NULL));
-    STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_open_amqp_value));
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_set_frame_size_alignment(NULL, 16384);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    connection_destroy(connection);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_CONNECTION_01_207: [If frame_codec_set_max_frame_size fails the connection shall be closed and the state set to END.] */
-TEST_FUNCTION(when_setting_the_max_frame_size_fails_the_connection_is_closed)
+/* Tests_SRS_CONNECTION_01_327: [connection_set_frame_size_alignment shall set the number of bytes that the size of the frames a transfer is split into shall be a multiple of.] */
+/* Tests_SRS_CONNECTION_01_331: [On success, connection_set_frame_size_alignment shall return 0.] */
+/* Tests_SRS_CONNECTION_01_333: [connection_get_split_frame_size shall return in split_frame_size the largest multiple of the frame size alignment that is not bigger than the remote max frame size.] */
+TEST_FUNCTION(connection_set_frame_size_alignment_rounds_the_split_frame_size_down_to_a_multiple_of_the_alignment)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    uint32_t split_frame_size;
     umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
-
-    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_set_frame_size_alignment(connection, 100);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)connection_get_split_frame_size(connection, &split_frame_size);
+    ASSERT_ARE_EQUAL(uint32_t, 500, split_frame_size);
 
     // cleanup
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
-TEST_FUNCTION(when_open_create_fails_the_connection_is_closed)
+/* connection_get_split_frame_size */
+
+/* Tests_SRS_CONNECTION_01_332: [If connection or split_frame_size is NULL, connection_get_split_frame_size shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_split_frame_size_with_NULL_connection_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
-    umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
-
-    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
-    STRICT_EXPECTED_CALL(open_create("1234"))
-        .SetReturn((OPEN_HANDLE)NULL);
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+    uint32_t split_frame_size;
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_get_split_frame_size(NULL, &split_frame_size);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    connection_destroy(connection);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-/* Tests_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
-TEST_FUNCTION(when_open_set_hostname_fails_the_connection_is_closed)
+/* Tests_SRS_CONNECTION_01_332: [If connection or split_frame_size is NULL, connection_get_split_frame_size shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_split_frame_size_with_NULL_split_frame_size_argument_fails)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    connection_dowork(connection);
-    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
     umock_c_reset_all_calls();
-    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
-
-    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
-    STRICT_EXPECTED_CALL(open_create("1234"));
-    STRICT_EXPECTED_CALL(open_set_max_frame_size(test_open_handle, 4294967295));
-    STRICT_EXPECTED_CALL(open_set_channel_max(test_open_handle, 65535));
-    STRICT_EXPECTED_CALL(open_set_hostname(test_open_handle, "testhost"))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    int result = connection_get_split_frame_size(connection, NULL);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 
     // cleanup
     connection_destroy(connection);
 }
 
-/* Tests_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
-TEST_FUNCTION(when_amqpvalue_create_open_fails_the_connection_is_closed)
+/* Tests_SRS_CONNECTION_01_329: [By default frames shall not be aligned.] */
+/* Tests_SRS_CONNECTION_01_334: [If no alignment is set or the alignment is bigger than the remote max frame size, connection_get_split_frame_size shall return the remote max frame size.] */
+/* Tests_SRS_CONNECTION_01_335: [On success, connection_get_split_frame_size shall return 0.] */
+TEST_FUNCTION(connection_get_split_frame_size_returns_the_remote_max_frame_size_by_default)
 {
     // arrange
-    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
-    connection_dowork(connection);
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    uint32_t split_frame_size = 42;
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_split_frame_size(connection, &split_frame_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint32_t, 512, split_frame_size);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_334: [If no alignment is set or the alignment is bigger than the remote max frame size, connection_get_split_frame_size shall return the remote max frame size.] */
+TEST_FUNCTION(connection_get_split_frame_size_with_an_alignment_bigger_than_the_remote_max_frame_size_returns_the_remote_max_frame_size)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    uint32_t split_frame_size;
+    (void)connection_set_frame_size_alignment(connection, 16384);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_split_frame_size(connection, &split_frame_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint32_t, 512, split_frame_size);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_send_queue_limits */
+
+/* Tests_SRS_CONNECTION_01_342: [If connection is NULL or low_water_mark is bigger than high_water_mark, connection_set_send_queue_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_send_queue_limits_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_send_queue_limits(NULL, 65536, 16384);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_342: [If connection is NULL or low_water_mark is bigger than high_water_mark, connection_set_send_queue_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_send_queue_limits_with_low_water_mark_bigger_than_high_water_mark_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_send_queue_limits(connection, 16384, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_336: [connection_set_send_queue_limits shall set the number of bytes handed to the io and not completed yet above which the send queue is full, and the number of bytes it has to drain down to before it stops being full.] */
+/* Tests_SRS_CONNECTION_01_344: [On success, connection_set_send_queue_limits shall return 0.] */
+TEST_FUNCTION(connection_set_send_queue_limits_with_valid_arguments_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    int result = connection_set_send_queue_limits(connection, 65536, 16384);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(connection_is_send_queue_full(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_343: [If allocating the send queue fails, connection_set_send_queue_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_allocating_the_send_queue_fails_connection_set_send_queue_limits_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    int result = connection_set_send_queue_limits(connection, 65536, 16384);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_340: [Setting high_water_mark to 0 shall disable the send queue limit.] */
+TEST_FUNCTION(connection_set_send_queue_limits_with_0_high_water_mark_does_not_allocate_a_send_queue)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_send_queue_limits(connection, 0, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_is_send_queue_full */
+
+/* Tests_SRS_CONNECTION_01_345: [connection_is_send_queue_full shall return true when the send queue of the connection is full and false otherwise, or when connection is NULL.] */
+TEST_FUNCTION(connection_is_send_queue_full_with_NULL_connection_returns_false)
+{
+    // arrange
+
+    // act
+    bool result = connection_is_send_queue_full(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_CONNECTION_01_341: [By default the send queue shall not be limited.] */
+/* Tests_SRS_CONNECTION_01_345: [connection_is_send_queue_full shall return true when the send queue of the connection is full and false otherwise, or when connection is NULL.] */
+TEST_FUNCTION(connection_is_send_queue_full_returns_false_by_default)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    bool result = connection_is_send_queue_full(connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_memory_quota */
+
+/* Tests_SRS_CONNECTION_01_382: [If connection is NULL or low_memory_mark is bigger than memory_quota, connection_set_memory_quota shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_memory_quota_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_memory_quota(NULL, 1048576, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_382: [If connection is NULL or low_memory_mark is bigger than memory_quota, connection_set_memory_quota shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_memory_quota_with_low_memory_mark_bigger_than_memory_quota_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_memory_quota(connection, 65536, 1048576);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_381: [connection_set_memory_quota shall limit to memory_quota bytes, 0 meaning no limit, the memory charged by the connection for the frames it receives and by its links for their buffers, and return 0.] */
+/* Tests_SRS_CONNECTION_01_386: [Under a memory quota, the connection shall receive frames in one buffer that it keeps, charging the memory quota when the buffer has to grow.] */
+TEST_FUNCTION(connection_set_memory_quota_with_valid_arguments_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_receive_buffer_pool(TEST_FRAME_CODEC_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, connection));
+
+    // act
+    int result = connection_set_memory_quota(connection, 1048576, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_384: [If setting the receive buffer pool of the frame codec fails, connection_set_memory_quota shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_setting_the_receive_buffer_pool_fails_connection_set_memory_quota_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_receive_buffer_pool(TEST_FRAME_CODEC_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, connection))
+        .SetReturn(1);
+
+    // act
+    int result = connection_set_memory_quota(connection, 1048576, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_381: [connection_set_memory_quota shall limit to memory_quota bytes, 0 meaning no limit, the memory charged by the connection for the frames it receives and by its links for their buffers, and return 0.] */
+TEST_FUNCTION(connection_set_memory_quota_with_0_memory_quota_does_not_set_a_receive_buffer_pool)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_memory_quota(connection, 0, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_receive_buffer_pool */
+
+/* Tests_SRS_CONNECTION_01_428: [If connection or buffer_pool is NULL, connection_set_receive_buffer_pool shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_receive_buffer_pool_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_receive_buffer_pool(NULL, TEST_BUFFER_POOL_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_428: [If connection or buffer_pool is NULL, connection_set_receive_buffer_pool shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_receive_buffer_pool_with_NULL_buffer_pool_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_receive_buffer_pool(connection, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_427: [connection_set_receive_buffer_pool shall set the receive buffer pool of the frame codec so that the frames are received in buffers obtained with buffer_pool_get and given back with buffer_pool_release, and return 0.] */
+TEST_FUNCTION(connection_set_receive_buffer_pool_with_valid_arguments_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_receive_buffer_pool(TEST_FRAME_CODEC_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, connection));
+
+    // act
+    int result = connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_432: [If setting the receive buffer pool of the frame codec fails, connection_set_receive_buffer_pool shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_setting_the_receive_buffer_pool_fails_connection_set_receive_buffer_pool_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_receive_buffer_pool(TEST_FRAME_CODEC_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, connection))
+        .SetReturn(1);
+
+    // act
+    int result = connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_427: [connection_set_receive_buffer_pool shall set the receive buffer pool of the frame codec so that the frames are received in buffers obtained with buffer_pool_get and given back with buffer_pool_release, and return 0.] */
+TEST_FUNCTION(a_memory_quota_set_after_the_receive_buffer_pool_keeps_the_pool)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_memory_quota(connection, 1048576, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_427: [connection_set_receive_buffer_pool shall set the receive buffer pool of the frame codec so that the frames are received in buffers obtained with buffer_pool_get and given back with buffer_pool_release, and return 0.] */
+/* Tests_SRS_CONNECTION_01_430: [While a pool buffer holds a received frame, the bytes asked for by the frame codec shall be charged to the memory quota.] */
+TEST_FUNCTION(a_frame_received_in_a_pool_buffer_is_charged_until_the_buffer_is_released)
+{
+    // arrange
+    unsigned char pool_buffer[4096];
+    unsigned char* receive_buffer;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_memory_quota(connection, 4096, 1024);
+    (void)connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(buffer_pool_get(TEST_BUFFER_POOL_HANDLE, 3584))
+        .SetReturn(pool_buffer);
+
+    // act
+    receive_buffer = saved_get_receive_buffer(saved_receive_buffer_pool_context, 3584);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, pool_buffer, receive_buffer);
+    ASSERT_IS_TRUE(connection_is_memory_low(connection));
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(buffer_pool_release(TEST_BUFFER_POOL_HANDLE, pool_buffer));
+    saved_release_receive_buffer(saved_receive_buffer_pool_context, receive_buffer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(connection_is_memory_low(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_456: [When the frame codec grows a pool buffer that is big enough, the buffer shall be kept and the memory quota charged for the added bytes.] */
+TEST_FUNCTION(growing_a_pool_buffer_that_is_big_enough_keeps_it_and_charges_the_added_bytes)
+{
+    // arrange
+    unsigned char pool_buffer[8192];
+    unsigned char* receive_buffer;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_memory_quota(connection, 8192, 1024);
+    (void)connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+    STRICT_EXPECTED_CALL(buffer_pool_get(TEST_BUFFER_POOL_HANDLE, 4096))
+        .SetReturn(pool_buffer);
+    receive_buffer = saved_get_receive_buffer(saved_receive_buffer_pool_context, 4096);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(buffer_pool_get_buffer_size(TEST_BUFFER_POOL_HANDLE))
+        .SetReturn(sizeof(pool_buffer));
+
+    // act
+    receive_buffer = saved_grow_receive_buffer(saved_receive_buffer_pool_context, receive_buffer, 7680);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, pool_buffer, receive_buffer);
+    ASSERT_IS_TRUE(connection_is_memory_low(connection));
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(buffer_pool_release(TEST_BUFFER_POOL_HANDLE, pool_buffer));
+    saved_release_receive_buffer(saved_receive_buffer_pool_context, receive_buffer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(connection_is_memory_low(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_456: [When the frame codec grows a pool buffer that is big enough, the buffer shall be kept and the memory quota charged for the added bytes.] */
+TEST_FUNCTION(growing_a_pool_buffer_past_the_memory_quota_fails)
+{
+    // arrange
+    unsigned char pool_buffer[8192];
+    unsigned char* receive_buffer;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_memory_quota(connection, 6144, 1024);
+    (void)connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+    STRICT_EXPECTED_CALL(buffer_pool_get(TEST_BUFFER_POOL_HANDLE, 4096))
+        .SetReturn(pool_buffer);
+    receive_buffer = saved_get_receive_buffer(saved_receive_buffer_pool_context, 4096);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(buffer_pool_get_buffer_size(TEST_BUFFER_POOL_HANDLE))
+        .SetReturn(sizeof(pool_buffer));
+
+    // act
+    unsigned char* grown_buffer = saved_grow_receive_buffer(saved_receive_buffer_pool_context, receive_buffer, 8192);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(grown_buffer);
+
+    // cleanup
+    saved_release_receive_buffer(saved_receive_buffer_pool_context, receive_buffer);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_457: [When the frame codec grows a pool buffer past the buffer size of the pool, the frame bytes shall be moved to the buffer that the connection keeps and the pool buffer released.] */
+TEST_FUNCTION(growing_a_pool_buffer_past_the_pool_buffer_size_moves_the_frame_to_the_buffer_of_the_connection)
+{
+    // arrange
+    unsigned char pool_buffer[4096];
+    unsigned char* receive_buffer;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+    STRICT_EXPECTED_CALL(buffer_pool_get(TEST_BUFFER_POOL_HANDLE, 4096))
+        .SetReturn(pool_buffer);
+    receive_buffer = saved_get_receive_buffer(saved_receive_buffer_pool_context, 4096);
+    (void)memset(pool_buffer, 0x42, sizeof(pool_buffer));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(buffer_pool_get_buffer_size(TEST_BUFFER_POOL_HANDLE))
+        .SetReturn(sizeof(pool_buffer));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 8192));
+    STRICT_EXPECTED_CALL(buffer_pool_release(TEST_BUFFER_POOL_HANDLE, pool_buffer));
+
+    // act
+    receive_buffer = saved_grow_receive_buffer(saved_receive_buffer_pool_context, receive_buffer, 8192);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(receive_buffer);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, pool_buffer, receive_buffer);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(pool_buffer, receive_buffer, sizeof(pool_buffer)));
+
+    /* the buffer of the connection is kept, nothing goes back to the pool */
+    umock_c_reset_all_calls();
+    saved_release_receive_buffer(saved_receive_buffer_pool_context, receive_buffer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_386: [Under a memory quota, the connection shall receive frames in one buffer that it keeps, charging the memory quota when the buffer has to grow.] */
+TEST_FUNCTION(growing_the_buffer_of_the_connection_reallocates_it_keeping_its_bytes)
+{
+    // arrange
+    unsigned char* receive_buffer;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_memory_quota(connection, 16384, 1024);
+    receive_buffer = saved_get_receive_buffer(saved_receive_buffer_pool_context, 4096);
+    (void)memset(receive_buffer, 0x42, 4096);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(receive_buffer, 8192));
+
+    // act
+    receive_buffer = saved_grow_receive_buffer(saved_receive_buffer_pool_context, receive_buffer, 8192);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(receive_buffer);
+    ASSERT_ARE_EQUAL(int, 0x42, (int)receive_buffer[4095]);
+
+    // cleanup
+    saved_release_receive_buffer(saved_receive_buffer_pool_context, receive_buffer);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_431: [If the buffer pool cannot give a buffer for a frame, the frame shall be received in one buffer that the connection keeps, like under a memory quota.] */
+TEST_FUNCTION(when_the_buffer_pool_has_no_buffer_the_frame_is_received_in_a_buffer_of_the_connection)
+{
+    // arrange
+    unsigned char* receive_buffer;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_receive_buffer_pool(connection, TEST_BUFFER_POOL_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(buffer_pool_get(TEST_BUFFER_POOL_HANDLE, 8192))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 8192));
+
+    // act
+    receive_buffer = saved_get_receive_buffer(saved_receive_buffer_pool_context, 8192);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(receive_buffer);
+
+    /* the buffer of the connection is kept, nothing goes back to the pool */
+    umock_c_reset_all_calls();
+    saved_release_receive_buffer(saved_receive_buffer_pool_context, receive_buffer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_charge_memory */
+
+/* Tests_SRS_CONNECTION_01_387: [If connection is NULL, connection_charge_memory shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_charge_memory_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_charge_memory(NULL, 1024);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_385: [By default the memory of a connection shall not be limited.] */
+/* Tests_SRS_CONNECTION_01_388: [connection_charge_memory shall add size to the memory in use of the connection and return 0.] */
+TEST_FUNCTION(connection_charge_memory_without_a_memory_quota_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_charge_memory(connection, 1048576);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(connection_is_memory_low(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_388: [connection_charge_memory shall add size to the memory in use of the connection and return 0.] */
+/* Tests_SRS_CONNECTION_01_392: [connection_is_memory_low shall return true when the connection has a memory quota and less than low_memory_mark bytes of it are left, and false otherwise, or when connection is NULL.] */
+TEST_FUNCTION(connection_charge_memory_within_the_memory_quota_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_memory_quota(connection, 4096, 1024);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_charge_memory(connection, 2048);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(connection_is_memory_low(connection));
+    ASSERT_ARE_EQUAL(int, 0, connection_charge_memory(connection, 1536));
+    ASSERT_IS_TRUE(connection_is_memory_low(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_389: [If the charge does not fit in the memory quota, connection_charge_memory shall fail, return a non-zero value and, the first time, close the connection with the error amqp:resource-limit-exceeded.] */
+TEST_FUNCTION(connection_charge_memory_above_the_memory_quota_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_memory_quota(connection, 4096, 1024);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_charge_memory(connection, 4097);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_release_memory */
+
+/* Tests_SRS_CONNECTION_01_391: [If connection is NULL, connection_release_memory shall do nothing.] */
+TEST_FUNCTION(connection_release_memory_with_NULL_connection_does_nothing)
+{
+    // arrange
+
+    // act
+    connection_release_memory(NULL, 1024);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CONNECTION_01_390: [connection_release_memory shall subtract size from the memory in use of the connection.] */
+TEST_FUNCTION(connection_release_memory_makes_room_in_the_memory_quota)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_memory_quota(connection, 4096, 1024);
+    (void)connection_charge_memory(connection, 3584);
+    umock_c_reset_all_calls();
+
+    // act
+    connection_release_memory(connection, 3584);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(connection_is_memory_low(connection));
+    ASSERT_ARE_EQUAL(int, 0, connection_charge_memory(connection, 4096));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_is_memory_low */
+
+/* Tests_SRS_CONNECTION_01_392: [connection_is_memory_low shall return true when the connection has a memory quota and less than low_memory_mark bytes of it are left, and false otherwise, or when connection is NULL.] */
+TEST_FUNCTION(connection_is_memory_low_with_NULL_connection_returns_false)
+{
+    // arrange
+
+    // act
+    bool result = connection_is_memory_low(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+}
+
+/* connection_set_receive_backlog_limits */
+
+/* Tests_SRS_CONNECTION_01_394: [If connection is NULL or resume_backlog is bigger than pause_backlog, connection_set_receive_backlog_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_receive_backlog_limits_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_receive_backlog_limits(NULL, 1048576, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_394: [If connection is NULL or resume_backlog is bigger than pause_backlog, connection_set_receive_backlog_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_receive_backlog_limits_with_resume_backlog_bigger_than_pause_backlog_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_receive_backlog_limits(connection, 65536, 1048576);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_393: [connection_set_receive_backlog_limits shall set the receive backlog above which the reads from the io are paused, 0 meaning never, and the backlog it has to drain down to before they are resumed, and return 0.] */
+TEST_FUNCTION(connection_set_receive_backlog_limits_with_valid_arguments_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_receive_backlog_limits(connection, 1048576, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(connection_is_receive_paused(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_393: [connection_set_receive_backlog_limits shall set the receive backlog above which the reads from the io are paused, 0 meaning never, and the backlog it has to drain down to before they are resumed, and return 0.] */
+TEST_FUNCTION(connection_set_receive_backlog_limits_with_0_pause_backlog_resumes_the_reads)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_receive_backlog_limits(connection, 4096, 1024);
+    connection_add_receive_backlog(connection, 8192);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_receive_backlog_limits(connection, 0, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(connection_is_receive_paused(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_add_receive_backlog */
+
+/* Tests_SRS_CONNECTION_01_398: [If connection is NULL, connection_add_receive_backlog and connection_remove_receive_backlog shall do nothing.] */
+TEST_FUNCTION(connection_add_receive_backlog_with_NULL_connection_does_nothing)
+{
+    // arrange
+
+    // act
+    connection_add_receive_backlog(NULL, 1024);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CONNECTION_01_395: [By default the reads from the io shall not be paused.] */
+TEST_FUNCTION(connection_add_receive_backlog_without_limits_does_not_pause_the_reads)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    connection_add_receive_backlog(connection, 1048576);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(connection_is_receive_paused(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_396: [connection_add_receive_backlog shall add size to the receive backlog and pause the reads from the io once it is over the pause backlog.] */
+TEST_FUNCTION(connection_add_receive_backlog_over_the_pause_backlog_pauses_the_reads)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_receive_backlog_limits(connection, 4096, 1024);
+    connection_add_receive_backlog(connection, 4096);
+    umock_c_reset_all_calls();
+
+    // act
+    connection_add_receive_backlog(connection, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(connection_is_receive_paused(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_remove_receive_backlog */
+
+/* Tests_SRS_CONNECTION_01_398: [If connection is NULL, connection_add_receive_backlog and connection_remove_receive_backlog shall do nothing.] */
+TEST_FUNCTION(connection_remove_receive_backlog_with_NULL_connection_does_nothing)
+{
+    // arrange
+
+    // act
+    connection_remove_receive_backlog(NULL, 1024);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CONNECTION_01_397: [connection_remove_receive_backlog shall subtract size from the receive backlog and resume the paused reads once it is down to the resume backlog.] */
+TEST_FUNCTION(connection_remove_receive_backlog_resumes_the_reads_at_the_resume_backlog)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_receive_backlog_limits(connection, 4096, 1024);
+    connection_add_receive_backlog(connection, 8192);
+    umock_c_reset_all_calls();
+
+    // act
+    connection_remove_receive_backlog(connection, 4096);
+    ASSERT_IS_TRUE(connection_is_receive_paused(connection));
+    connection_remove_receive_backlog(connection, 3072);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(connection_is_receive_paused(connection));
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_is_receive_paused */
+
+/* Tests_SRS_CONNECTION_01_401: [connection_is_receive_paused shall return true while the reads from the io are paused and false otherwise, or when connection is NULL.] */
+TEST_FUNCTION(connection_is_receive_paused_with_NULL_connection_returns_false)
+{
+    // arrange
+
+    // act
+    bool result = connection_is_receive_paused(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+}
+
+/* connection_get_io_interest */
+
+/* Tests_SRS_CONNECTION_01_405: [If connection or io_interest is NULL, connection_get_io_interest shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_io_interest_with_NULL_connection_fails)
+{
+    // arrange
+    CONNECTION_IO_INTEREST io_interest;
+
+    // act
+    int result = connection_get_io_interest(NULL, &io_interest);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_405: [If connection or io_interest is NULL, connection_get_io_interest shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_io_interest_with_NULL_io_interest_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_io_interest(connection, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_407: [connection_get_io_interest shall indicate an interest in reading unless the reads from the io are paused.] */
+/* Tests_SRS_CONNECTION_01_408: [connection_get_io_interest shall indicate an interest in writing while the io is being opened, when send queue limits are set and the send queue holds bytes, and otherwise when bytes were handed to the io since the previous call.] */
+/* Tests_SRS_CONNECTION_01_409: [connection_get_io_interest shall set timeout_ms to the milliseconds until the next idle timeout or outgoing batch deadline, 0 when an outgoing batch is due to be flushed and (uint64_t)-1 when there is no deadline.] */
+TEST_FUNCTION(connection_get_io_interest_while_the_io_opens_wants_to_read_and_write)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_IO_INTEREST io_interest;
+    connection_dowork(connection);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    int result = connection_get_io_interest(connection, &io_interest);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(io_interest.want_read);
+    ASSERT_IS_TRUE(io_interest.want_write);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)-1, io_interest.timeout_ms);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_408: [connection_get_io_interest shall indicate an interest in writing while the io is being opened, when send queue limits are set and the send queue holds bytes, and otherwise when bytes were handed to the io since the previous call.] */
+TEST_FUNCTION(connection_get_io_interest_only_wants_to_write_once_after_bytes_are_sent)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_IO_INTEREST first_io_interest;
+    CONNECTION_IO_INTEREST second_io_interest;
+    connection_dowork(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    int result1 = connection_get_io_interest(connection, &first_io_interest);
+    int result2 = connection_get_io_interest(connection, &second_io_interest);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result1);
+    ASSERT_ARE_EQUAL(int, 0, result2);
+    ASSERT_IS_TRUE(first_io_interest.want_write);
+    ASSERT_IS_FALSE(second_io_interest.want_write);
+    ASSERT_IS_TRUE(second_io_interest.want_read);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_407: [connection_get_io_interest shall indicate an interest in reading unless the reads from the io are paused.] */
+TEST_FUNCTION(connection_get_io_interest_while_the_reads_are_paused_does_not_want_to_read)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_IO_INTEREST io_interest;
+    (void)connection_set_receive_backlog_limits(connection, 4096, 1024);
+    connection_add_receive_backlog(connection, 8192);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    int result = connection_get_io_interest(connection, &io_interest);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(io_interest.want_read);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_endpoint_set_on_send_queue_drained */
+
+/* Tests_SRS_CONNECTION_01_346: [If endpoint is NULL, connection_endpoint_set_on_send_queue_drained shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_endpoint_set_on_send_queue_drained_with_NULL_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_endpoint_set_on_send_queue_drained(NULL, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* connection_endpoint_set_on_dowork */
+
+/* Tests_SRS_CONNECTION_01_402: [If endpoint is NULL, connection_endpoint_set_on_dowork shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_endpoint_set_on_dowork_with_NULL_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_endpoint_set_on_dowork(NULL, test_on_endpoint_dowork, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_403: [connection_endpoint_set_on_dowork shall set the callback called with context once per connection_dowork, a NULL callback removing it, and return 0.] */
+TEST_FUNCTION(connection_endpoint_set_on_dowork_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_endpoint_set_on_dowork(endpoint, test_on_endpoint_dowork, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_403: [connection_endpoint_set_on_dowork shall set the callback called with context once per connection_dowork, a NULL callback removing it, and return 0.] */
+TEST_FUNCTION(connection_endpoint_set_on_dowork_with_NULL_callback_removes_it)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    (void)connection_endpoint_set_on_dowork(endpoint, test_on_endpoint_dowork, TEST_CONTEXT);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_endpoint_set_on_dowork(endpoint, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* connection_flush */
+
+/* Tests_SRS_CONNECTION_01_294: [If connection is NULL, connection_flush shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_flush_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_flush(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_297: [On success, connection_flush shall return 0.] */
+TEST_FUNCTION(connection_flush_with_an_empty_outgoing_batch_does_not_send_anything)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_outgoing_batch_size(connection, 16384);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_flush(connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_hold_outgoing_batch */
+
+/* Tests_SRS_CONNECTION_01_366: [If connection is NULL, connection_hold_outgoing_batch shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_hold_outgoing_batch_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_hold_outgoing_batch(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_367: [connection_hold_outgoing_batch shall hold the outgoing batch until a matching call to connection_release_outgoing_batch, holds can be nested.] */
+/* Tests_SRS_CONNECTION_01_369: [On success, connection_hold_outgoing_batch shall return 0.] */
+TEST_FUNCTION(connection_hold_outgoing_batch_with_valid_connection_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_hold_outgoing_batch(connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)connection_release_outgoing_batch(connection);
+    connection_destroy(connection);
+}
+
+/* connection_release_outgoing_batch */
+
+/* Tests_SRS_CONNECTION_01_370: [If connection is NULL, connection_release_outgoing_batch shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_release_outgoing_batch_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_release_outgoing_batch(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_371: [If the outgoing batch is not held, connection_release_outgoing_batch shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_release_outgoing_batch_without_a_hold_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_release_outgoing_batch(connection);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_367: [connection_hold_outgoing_batch shall hold the outgoing batch until a matching call to connection_release_outgoing_batch, holds can be nested.] */
+TEST_FUNCTION(connection_release_outgoing_batch_releases_nested_holds_one_at_a_time)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_hold_outgoing_batch(connection);
+    (void)connection_hold_outgoing_batch(connection);
+    umock_c_reset_all_calls();
+
+    // act
+    int result1 = connection_release_outgoing_batch(connection);
+    int result2 = connection_release_outgoing_batch(connection);
+    int result3 = connection_release_outgoing_batch(connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result1);
+    ASSERT_ARE_EQUAL(int, 0, result2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_374: [On success, connection_release_outgoing_batch shall return 0.] */
+TEST_FUNCTION(connection_release_outgoing_batch_with_an_empty_outgoing_batch_does_not_send_anything)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_hold_outgoing_batch(connection);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_release_outgoing_batch(connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_pipelined_open */
+
+/* Tests_SRS_CONNECTION_01_313: [If connection is NULL, connection_set_pipelined_open shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_pipelined_open_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_pipelined_open(NULL, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_315: [connection_set_pipelined_open shall set whether the open frame and the frames of the endpoints are sent without waiting for the peer's protocol header and open frame.] */
+/* Tests_SRS_CONNECTION_01_316: [On success, connection_set_pipelined_open shall return 0.] */
+TEST_FUNCTION(connection_set_pipelined_open_with_valid_connection_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    bool pipelined_open;
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_pipelined_open(connection, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)connection_get_pipelined_open(connection, &pipelined_open);
+    ASSERT_IS_TRUE(pipelined_open);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_314: [If connection_set_pipelined_open is called after the connection was opened, it shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_pipelined_open_after_open_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_open(connection);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_pipelined_open(connection, true);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_get_pipelined_open */
+
+/* Tests_SRS_CONNECTION_01_317: [If connection or pipelined_open are NULL, connection_get_pipelined_open shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_pipelined_open_with_NULL_connection_fails)
+{
+    // arrange
+    bool pipelined_open;
+
+    // act
+    int result = connection_get_pipelined_open(NULL, &pipelined_open);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_317: [If connection or pipelined_open are NULL, connection_get_pipelined_open shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_pipelined_open_with_NULL_pipelined_open_argument_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_pipelined_open(connection, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_312: [By default the open shall not be pipelined.] */
+/* Tests_SRS_CONNECTION_01_318: [connection_get_pipelined_open shall return in the pipelined_open argument the current pipelined open setting.] */
+/* Tests_SRS_CONNECTION_01_319: [On success, connection_get_pipelined_open shall return 0.] */
+TEST_FUNCTION(connection_get_pipelined_open_returns_false_by_default)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    bool pipelined_open = true;
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_pipelined_open(connection, &pipelined_open);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(pipelined_open);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Pipelined open */
+
+/* Tests_SRS_CONNECTION_01_320: [When the open is pipelined, the open frame shall be sent right after the protocol header, without waiting for the peer's protocol header, and the connection shall switch to the OPEN_PIPE state.] */
+/* Tests_SRS_CONNECTION_01_322: [When the open is pipelined, the protocol header, the open frame and the frames encoded until the peer's open frame is received shall be accumulated in the outgoing batch.] */
+/* Tests_SRS_CONNECTION_01_323: [Once the open frame and the frames encoded by the endpoints when notified of the OPEN_PIPE state are batched, the outgoing batch shall be flushed so that they are passed to the io in one xio_send call.] */
+TEST_FUNCTION(when_the_open_is_pipelined_the_header_and_the_open_frame_are_sent_in_one_write)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234", NULL, NULL);
+    (void)connection_set_pipelined_open(connection, true);
+    (void)connection_open(connection);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
+    STRICT_EXPECTED_CALL(open_create("1234"));
+    STRICT_EXPECTED_CALL(open_set_hostname(test_open_handle, "testhost"));
+    STRICT_EXPECTED_CALL(open_set_max_frame_size(test_open_handle, 4294967295));
+    STRICT_EXPECTED_CALL(open_set_channel_max(test_open_handle, 65535));
+    STRICT_EXPECTED_CALL(amqpvalue_create_open(test_open_handle));
+    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame(TEST_AMQP_FRAME_CODEC_HANDLE, 0, test_open_amqp_value, NULL, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_open_amqp_value));
+    STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_325: [If flushing the pipelined frames fails, the connection shall be closed and its state set to END.] */
+TEST_FUNCTION(when_sending_the_pipelined_frames_fails_the_connection_is_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234", NULL, NULL);
+    (void)connection_set_pipelined_open(connection, true);
+    (void)connection_open(connection);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
+    STRICT_EXPECTED_CALL(open_create("1234"));
+    STRICT_EXPECTED_CALL(open_set_hostname(test_open_handle, "testhost"));
+    STRICT_EXPECTED_CALL(open_set_max_frame_size(test_open_handle, 4294967295));
+    STRICT_EXPECTED_CALL(open_set_channel_max(test_open_handle, 65535));
+    STRICT_EXPECTED_CALL(amqpvalue_create_open(test_open_handle));
+    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame(TEST_AMQP_FRAME_CODEC_HANDLE, 0, test_open_amqp_value, NULL, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_open_amqp_value));
+    STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_324: [When the peer's protocol header is received in the OPEN_PIPE state, the connection shall switch to the OPEN_SENT state without sending another open frame.] */
+TEST_FUNCTION(when_the_header_is_received_in_OPEN_PIPE_no_other_open_frame_is_sent)
+{
+    // arrange
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234", NULL, NULL);
+    (void)connection_set_pipelined_open(connection, true);
+    (void)connection_open(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_321: [When the open is pipelined, connection_encode_frame and connection_encode_frame_with_encoded_performative shall also encode frames in the OPEN_PIPE and OPEN_SENT states.] */
+TEST_FUNCTION(when_the_open_is_pipelined_connection_encode_frame_succeeds_in_OPEN_PIPE)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234", NULL, NULL);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    (void)connection_start_endpoint(endpoint, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    (void)connection_set_pipelined_open(connection, true);
+    (void)connection_open(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame(TEST_AMQP_FRAME_CODEC_HANDLE, 0, TEST_TRANSFER_PERFORMATIVE, NULL, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    int result = connection_encode_frame(endpoint, TEST_TRANSFER_PERFORMATIVE, NULL, 0, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* connection_get_stats */
+
+/* Tests_SRS_CONNECTION_01_304: [If connection or stats are NULL, connection_get_stats shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_stats_with_NULL_connection_fails)
+{
+    // arrange
+    CONNECTION_STATS stats;
+
+    // act
+    int result = connection_get_stats(NULL, &stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_304: [If connection or stats are NULL, connection_get_stats shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_stats_with_NULL_stats_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_stats(connection, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_305: [connection_get_stats shall copy the counters kept since the connection was created to stats and return 0.] */
+TEST_FUNCTION(connection_get_stats_on_a_new_connection_returns_zero_counters)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_STATS stats;
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_stats(connection, &stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.frames_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.frames_received);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.bytes_received);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.empty_frames_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.empty_frames_received);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_307: [All bytes received from the io shall be counted as received.] */
+TEST_FUNCTION(connection_get_stats_counts_the_sent_header_and_the_received_bytes)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    const unsigned char amqp_header[] = { 'A', 'M' };
+    CONNECTION_STATS stats;
+    connection_dowork(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_stats(connection, &stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 8, stats.bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 2, stats.bytes_received);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.frames_received);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_session_admission_limiter */
+
+/* Tests_SRS_CONNECTION_01_378: [If connection is NULL, connection_set_session_admission_limiter shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_session_admission_limiter_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_session_admission_limiter(NULL, TEST_ADMISSION_LIMITER_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_377: [connection_set_session_admission_limiter shall make the connection check the remote begins it receives against session_admission_limiter, a NULL session_admission_limiter admitting all of them, and return 0.] */
+TEST_FUNCTION(connection_set_session_admission_limiter_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_set_session_admission_limiter(connection, TEST_ADMISSION_LIMITER_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_frame_trace */
+
+/* Tests_SRS_CONNECTION_01_310: [If connection is NULL, connection_set_frame_trace shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_frame_trace_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_frame_trace(NULL, TEST_FRAME_TRACE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_309: [connection_set_frame_trace shall make the connection record its frames in frame_trace, a NULL frame_trace stopping the recording, and return 0.] */
+TEST_FUNCTION(connection_set_frame_trace_succeeds)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_set_on_performative_bytes(TEST_AMQP_FRAME_CODEC_HANDLE, IGNORED_PTR_ARG, connection));
+
+    // act
+    int result = connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(saved_on_performative_bytes);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_309: [connection_set_frame_trace shall make the connection record its frames in frame_trace, a NULL frame_trace stopping the recording, and return 0.] */
+TEST_FUNCTION(connection_set_frame_trace_with_NULL_frame_trace_stops_the_performative_bytes)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_set_on_performative_bytes(TEST_AMQP_FRAME_CODEC_HANDLE, NULL, connection));
+
+    // act
+    int result = connection_set_frame_trace(connection, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_455: [If amqp_frame_codec_set_on_performative_bytes fails, connection_set_frame_trace shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_amqp_frame_codec_set_on_performative_bytes_fails_connection_set_frame_trace_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_set_on_performative_bytes(TEST_AMQP_FRAME_CODEC_HANDLE, IGNORED_PTR_ARG, connection))
+        .SetReturn(1);
+
+    // act
+    int result = connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_454: [The performatives shall be recorded with the bytes the amqp_frame_codec decoded or encoded, obtained by calling amqp_frame_codec_set_on_performative_bytes.] */
+TEST_FUNCTION(the_bytes_of_a_received_performative_are_recorded_in_the_frame_trace)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    const unsigned char performative_bytes[] = { 0x00, 0x53, 0x10, 0x45 };
+    (void)connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(frame_trace_record_bytes(TEST_FRAME_TRACE_HANDLE, FRAME_TRACE_DIRECTION_INCOMING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, 1, IGNORED_NUM_ARG, IGNORED_PTR_ARG, sizeof(performative_bytes), 42))
+        .ValidateArgumentBuffer(6, performative_bytes, sizeof(performative_bytes));
+
+    // act
+    saved_on_performative_bytes(saved_on_performative_bytes_context, false, 1, performative_bytes, sizeof(performative_bytes), 42);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_454: [The performatives shall be recorded with the bytes the amqp_frame_codec decoded or encoded, obtained by calling amqp_frame_codec_set_on_performative_bytes.] */
+TEST_FUNCTION(the_bytes_of_a_sent_performative_are_recorded_in_the_frame_trace)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    const unsigned char performative_bytes[] = { 0x00, 0x53, 0x18, 0x45 };
+    (void)connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(frame_trace_record_bytes(TEST_FRAME_TRACE_HANDLE, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, 0, IGNORED_NUM_ARG, IGNORED_PTR_ARG, sizeof(performative_bytes), 0))
+        .ValidateArgumentBuffer(6, performative_bytes, sizeof(performative_bytes));
+
+    // act
+    saved_on_performative_bytes(saved_on_performative_bytes_context, true, 0, performative_bytes, sizeof(performative_bytes), 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_decoder_limits */
+
+/* Tests_SRS_CONNECTION_01_451: [If connection is NULL, connection_set_decoder_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_decoder_limits_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_decoder_limits(NULL, 16, 1000, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_450: [connection_set_decoder_limits shall apply max_depth, max_element_count and max_allocated_bytes to the decoding of the received performatives by calling amqp_frame_codec_set_decoder_limits and return 0.] */
+TEST_FUNCTION(connection_set_decoder_limits_sets_the_limits_on_the_amqp_frame_codec)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_set_decoder_limits(TEST_AMQP_FRAME_CODEC_HANDLE, 16, 1000, 65536));
+
+    // act
+    int result = connection_set_decoder_limits(connection, 16, 1000, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_452: [If amqp_frame_codec_set_decoder_limits fails, connection_set_decoder_limits shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_amqp_frame_codec_set_decoder_limits_fails_connection_set_decoder_limits_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_set_decoder_limits(TEST_AMQP_FRAME_CODEC_HANDLE, 16, 1000, 65536))
+        .SetReturn(1);
+
+    // act
+    int result = connection_set_decoder_limits(connection, 16, 1000, 65536);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_453: [When the amqp_frame_codec reports that a frame could not be decoded, a decoder limit breach included, the connection shall be closed with the error condition amqp:decode-error and an implementation defined error description.] */
+TEST_FUNCTION(when_a_decoder_limit_is_breached_the_connection_is_closed_with_decode_error)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_decoder_limits(connection, 16, 1000, 65536);
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
+
+    STRICT_EXPECTED_CALL(error_create("amqp:decode-error"));
+    STRICT_EXPECTED_CALL(error_set_description(test_error_handle, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(close_create());
+    STRICT_EXPECTED_CALL(close_set_error(test_close_handle, test_error_handle));
+    STRICT_EXPECTED_CALL(amqpvalue_create_close(test_close_handle));
+    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame(TEST_AMQP_FRAME_CODEC_HANDLE, 0, test_close_amqp_value, NULL, 0, NULL, NULL));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_close_amqp_value));
+    STRICT_EXPECTED_CALL(close_destroy(test_close_handle));
+    STRICT_EXPECTED_CALL(error_destroy(test_error_handle));
+
+    // act
+    /* the amqp_frame_codec reports the performative that breached the limits as a decode error */
+    saved_amqp_frame_codec_error_callback(saved_amqp_frame_codec_callback_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_311: [When a frame trace is set, every frame received and sent, protocol headers and empty frames included, shall be recorded in it.] */
+TEST_FUNCTION(when_a_frame_trace_is_set_the_sent_header_is_recorded_in_it)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+    (void)connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+    connection_dowork(connection);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, amqp_header, sizeof(amqp_header), IGNORED_PTR_ARG, NULL))
+        .ValidateArgumentBuffer(2, amqp_header, sizeof(amqp_header));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(frame_trace_record_bytes(TEST_FRAME_TRACE_HANDLE, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_HEADER, 0, IGNORED_NUM_ARG, IGNORED_PTR_ARG, sizeof(amqp_header), 0))
+        .ValidateArgumentBuffer(6, amqp_header, sizeof(amqp_header));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_410: [When the frame trace set on the connection is capturing, the bytes received from the io shall be passed to frame_trace_capture_bytes with the current time before being processed.] */
+TEST_FUNCTION(when_the_frame_trace_is_capturing_the_received_bytes_are_captured)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+    (void)connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+    connection_dowork(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_trace_is_capturing(TEST_FRAME_TRACE_HANDLE))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(frame_trace_capture_bytes(TEST_FRAME_TRACE_HANDLE, IGNORED_NUM_ARG, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, amqp_header, 1);
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_410: [When the frame trace set on the connection is capturing, the bytes received from the io shall be passed to frame_trace_capture_bytes with the current time before being processed.] */
+TEST_FUNCTION(when_the_frame_trace_is_not_capturing_the_received_bytes_are_not_captured)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+    (void)connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+    connection_dowork(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_trace_is_capturing(TEST_FRAME_TRACE_HANDLE))
+        .SetReturn(false);
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_411: [If capturing the received bytes fails, the bytes shall still be processed.] */
+TEST_FUNCTION(when_capturing_the_received_bytes_fails_they_are_still_processed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    const unsigned char not_a_header[] = { 'B' };
+    (void)connection_set_frame_trace(connection, TEST_FRAME_TRACE_HANDLE);
+    connection_dowork(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_trace_is_capturing(TEST_FRAME_TRACE_HANDLE))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(frame_trace_capture_bytes(TEST_FRAME_TRACE_HANDLE, IGNORED_NUM_ARG, IGNORED_PTR_ARG, 1))
+        .SetReturn(1);
+    /* the byte still goes to the header check, which fails */
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, not_a_header, sizeof(not_a_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_set_flow_observer */
+
+static size_t test_flow_event_calls;
+static CONNECTION_FLOW_EVENT_INFO test_flow_event_info;
+static void* test_flow_event_context;
+
+static void test_on_flow_event(void* context, const CONNECTION_FLOW_EVENT_INFO* event_info)
+{
+    test_flow_event_calls++;
+    test_flow_event_context = context;
+    test_flow_event_info = *event_info;
+}
+
+/* Tests_SRS_CONNECTION_01_413: [If connection is NULL, connection_set_flow_observer shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_flow_observer_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_flow_observer(NULL, test_on_flow_event, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_412: [connection_set_flow_observer shall make the connection pass the flow events reported to it to on_flow_event with context, a NULL on_flow_event removing the observer, and return 0.] */
+/* Tests_SRS_CONNECTION_01_414: [connection_report_flow_event shall call the flow observer with event, source, link_name, value and the current time of the tick counter of the connection as timestamp_ms (0 if it cannot be read).] */
+TEST_FUNCTION(connection_report_flow_event_calls_the_flow_observer)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    tickcounter_ms_t current_ms = 1234;
+    int result;
+    test_flow_event_calls = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &current_ms, sizeof(current_ms));
+
+    // act
+    result = connection_set_flow_observer(connection, test_on_flow_event, (void*)0x4242);
+    connection_report_flow_event(connection, CONNECTION_FLOW_EVENT_LINK_CREDIT_EXHAUSTED, (void*)0x4243, "test_link", 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, test_flow_event_calls);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4242, test_flow_event_context);
+    ASSERT_ARE_EQUAL(int, (int)CONNECTION_FLOW_EVENT_LINK_CREDIT_EXHAUSTED, (int)test_flow_event_info.event);
+    ASSERT_ARE_EQUAL(uint64_t, 1234, test_flow_event_info.timestamp_ms);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4243, test_flow_event_info.source);
+    ASSERT_ARE_EQUAL(char_ptr, "test_link", test_flow_event_info.link_name);
+    ASSERT_ARE_EQUAL(uint64_t, 0, test_flow_event_info.value);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_414: [connection_report_flow_event shall call the flow observer with event, source, link_name, value and the current time of the tick counter of the connection as timestamp_ms (0 if it cannot be read).] */
+TEST_FUNCTION(when_the_tick_counter_cannot_be_read_connection_report_flow_event_reports_a_0_timestamp)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_flow_observer(connection, test_on_flow_event, NULL);
+    test_flow_event_calls = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    connection_report_flow_event(connection, CONNECTION_FLOW_EVENT_QUEUE_DEPTH_ABOVE, (void*)0x4243, NULL, 42);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, test_flow_event_calls);
+    ASSERT_ARE_EQUAL(uint64_t, 0, test_flow_event_info.timestamp_ms);
+    ASSERT_IS_NULL(test_flow_event_info.link_name);
+    ASSERT_ARE_EQUAL(uint64_t, 42, test_flow_event_info.value);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_412: [connection_set_flow_observer shall make the connection pass the flow events reported to it to on_flow_event with context, a NULL on_flow_event removing the observer, and return 0.] */
+/* Tests_SRS_CONNECTION_01_415: [If connection is NULL or has no flow observer, connection_report_flow_event shall do nothing.] */
+TEST_FUNCTION(connection_report_flow_event_after_the_flow_observer_is_removed_does_nothing)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_set_flow_observer(connection, test_on_flow_event, NULL);
+    (void)connection_set_flow_observer(connection, NULL, NULL);
+    test_flow_event_calls = 0;
+    umock_c_reset_all_calls();
+
+    // act
+    connection_report_flow_event(connection, CONNECTION_FLOW_EVENT_SEND_QUEUE_FULL, connection, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_flow_event_calls);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_415: [If connection is NULL or has no flow observer, connection_report_flow_event shall do nothing.] */
+TEST_FUNCTION(connection_report_flow_event_with_NULL_connection_does_nothing)
+{
+    // arrange
+    test_flow_event_calls = 0;
+
+    // act
+    connection_report_flow_event(NULL, CONNECTION_FLOW_EVENT_SEND_QUEUE_FULL, NULL, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_flow_event_calls);
+}
+
+/* connection_set_callback_budget */
+
+static void time_test_callback(CONNECTION_HANDLE connection, CONNECTION_CALLBACK_TYPE callback_type, const char* link_name, tickcounter_ms_t start_ms, tickcounter_ms_t end_ms)
+{
+    uint64_t start_time;
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &start_ms, sizeof(start_ms));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &end_ms, sizeof(end_ms));
+
+    ASSERT_IS_TRUE(connection_begin_callback(connection, &start_time));
+    connection_end_callback(connection, callback_type, link_name, start_time);
+}
+
+/* Tests_SRS_CONNECTION_01_419: [If connection is NULL, connection_set_callback_budget shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_set_callback_budget_with_NULL_connection_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_set_callback_budget(NULL, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_420: [If connection or start_ms is NULL or the connection has no callback budget, connection_begin_callback shall return false without reading the tick counter.] */
+TEST_FUNCTION(connection_begin_callback_without_a_callback_budget_returns_false)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    uint64_t start_ms;
+    umock_c_reset_all_calls();
+
+    // act
+    bool result = connection_begin_callback(connection, &start_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_420: [If connection or start_ms is NULL or the connection has no callback budget, connection_begin_callback shall return false without reading the tick counter.] */
+TEST_FUNCTION(connection_begin_callback_with_NULL_connection_returns_false)
+{
+    // arrange
+    uint64_t start_ms;
+
+    // act
+    bool result = connection_begin_callback(NULL, &start_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_CONNECTION_01_418: [connection_set_callback_budget shall make the connection time the application callbacks against budget_ms, 0 turning the timing off, clear the callback stats and return 0.] */
+/* Tests_SRS_CONNECTION_01_421: [Otherwise connection_begin_callback shall set start_ms to the current time of the tick counter of the connection and return true, or return false if the tick counter cannot be read.] */
+TEST_FUNCTION(connection_begin_callback_with_a_callback_budget_returns_the_current_time)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    tickcounter_ms_t current_ms = 1000;
+    uint64_t start_ms = 0;
+    int set_result;
+    bool result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &current_ms, sizeof(current_ms));
+
+    // act
+    set_result = connection_set_callback_budget(connection, 10);
+    result = connection_begin_callback(connection, &start_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, set_result);
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(uint64_t, 1000, start_ms);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_421: [Otherwise connection_begin_callback shall set start_ms to the current time of the tick counter of the connection and return true, or return false if the tick counter cannot be read.] */
+TEST_FUNCTION(when_the_tick_counter_cannot_be_read_connection_begin_callback_returns_false)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    uint64_t start_ms;
+    bool result;
+    (void)connection_set_callback_budget(connection, 10);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = connection_begin_callback(connection, &start_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_422: [connection_end_callback shall count the callback as timed, with the time elapsed on the tick counter since start_ms as its duration.] */
+/* Tests_SRS_CONNECTION_01_426: [connection_get_callback_stats shall copy the callback stats kept since the callback budget was set to callback_stats and return 0.] */
+TEST_FUNCTION(a_callback_within_the_budget_is_counted_as_timed_only)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_CALLBACK_STATS callback_stats;
+    int result;
+    (void)connection_set_callback_budget(connection, 10);
+    umock_c_reset_all_calls();
+
+    // act
+    time_test_callback(connection, CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED, "test_link", 1000, 1010);
+    result = connection_get_callback_stats(connection, &callback_stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 1, callback_stats.timed_callbacks);
+    ASSERT_ARE_EQUAL(uint64_t, 0, callback_stats.slow_callbacks[CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED]);
+    ASSERT_ARE_EQUAL(size_t, 0, callback_stats.worst_callback_count);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_423: [A callback whose duration is over the callback budget shall be counted as slow for callback_type and kept with its type, link_name and duration if it is among the CONNECTION_SLOW_CALLBACK_MAX slowest ones.] */
+TEST_FUNCTION(a_callback_over_the_budget_is_counted_as_slow_and_kept)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_CALLBACK_STATS callback_stats;
+    (void)connection_set_callback_budget(connection, 10);
+    umock_c_reset_all_calls();
+
+    // act
+    time_test_callback(connection, CONNECTION_CALLBACK_TYPE_MESSAGE_SEND_COMPLETE, "test_link", 1000, 1025);
+    (void)connection_get_callback_stats(connection, &callback_stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 1, callback_stats.timed_callbacks);
+    ASSERT_ARE_EQUAL(uint64_t, 1, callback_stats.slow_callbacks[CONNECTION_CALLBACK_TYPE_MESSAGE_SEND_COMPLETE]);
+    ASSERT_ARE_EQUAL(size_t, 1, callback_stats.worst_callback_count);
+    ASSERT_ARE_EQUAL(int, (int)CONNECTION_CALLBACK_TYPE_MESSAGE_SEND_COMPLETE, (int)callback_stats.worst_callbacks[0].callback_type);
+    ASSERT_ARE_EQUAL(char_ptr, "test_link", callback_stats.worst_callbacks[0].link_name);
+    ASSERT_ARE_EQUAL(uint64_t, 25, callback_stats.worst_callbacks[0].duration_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 1025, callback_stats.worst_callbacks[0].timestamp_ms);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_423: [A callback whose duration is over the callback budget shall be counted as slow for callback_type and kept with its type, link_name and duration if it is among the CONNECTION_SLOW_CALLBACK_MAX slowest ones.] */
+TEST_FUNCTION(only_the_slowest_callbacks_are_kept_slowest_first)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_CALLBACK_STATS callback_stats;
+    size_t i;
+    (void)connection_set_callback_budget(connection, 10);
+    umock_c_reset_all_calls();
+
+    // act
+    for (i = 0; i < CONNECTION_SLOW_CALLBACK_MAX + 2; i++)
+    {
+        /* durations 11 to 20, in an order that is not sorted */
+        time_test_callback(connection, CONNECTION_CALLBACK_TYPE_LINK_ATTACHED, NULL, 1000, 1011 + ((i * 3) % (CONNECTION_SLOW_CALLBACK_MAX + 2)));
+    }
+    (void)connection_get_callback_stats(connection, &callback_stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, CONNECTION_SLOW_CALLBACK_MAX + 2, callback_stats.slow_callbacks[CONNECTION_CALLBACK_TYPE_LINK_ATTACHED]);
+    ASSERT_ARE_EQUAL(size_t, CONNECTION_SLOW_CALLBACK_MAX, callback_stats.worst_callback_count);
+    for (i = 0; i < CONNECTION_SLOW_CALLBACK_MAX; i++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, 10 + CONNECTION_SLOW_CALLBACK_MAX + 2 - i, callback_stats.worst_callbacks[i].duration_ms);
+        ASSERT_ARE_EQUAL(char_ptr, "", callback_stats.worst_callbacks[i].link_name);
+    }
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_418: [connection_set_callback_budget shall make the connection time the application callbacks against budget_ms, 0 turning the timing off, clear the callback stats and return 0.] */
+TEST_FUNCTION(connection_set_callback_budget_clears_the_callback_stats)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_CALLBACK_STATS callback_stats;
+    (void)connection_set_callback_budget(connection, 10);
+    time_test_callback(connection, CONNECTION_CALLBACK_TYPE_MESSAGE_RECEIVED, "test_link", 1000, 1025);
+    umock_c_reset_all_calls();
+
+    // act
+    (void)connection_set_callback_budget(connection, 0);
+    (void)connection_get_callback_stats(connection, &callback_stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 0, callback_stats.timed_callbacks);
+    ASSERT_ARE_EQUAL(size_t, 0, callback_stats.worst_callback_count);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_424: [If connection is NULL or callback_type is not a callback type, connection_end_callback shall do nothing.] */
+TEST_FUNCTION(connection_end_callback_with_a_bad_callback_type_does_nothing)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    CONNECTION_CALLBACK_STATS callback_stats;
+    (void)connection_set_callback_budget(connection, 10);
+    umock_c_reset_all_calls();
+
+    // act
+    connection_end_callback(connection, CONNECTION_CALLBACK_TYPE_COUNT, "test_link", 0);
+    (void)connection_get_callback_stats(connection, &callback_stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 0, callback_stats.timed_callbacks);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_425: [If connection or callback_stats are NULL, connection_get_callback_stats shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_callback_stats_with_NULL_callback_stats_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_callback_stats(connection, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_create3 */
+
+static size_t test_allocator_malloc_calls;
+static size_t test_allocator_free_calls;
+
+static void* test_allocator_malloc(void* context, size_t size)
+{
+    (void)context;
+    test_allocator_malloc_calls++;
+    return malloc(size);
+}
+
+static void* test_allocator_realloc(void* context, void* ptr, size_t size)
+{
+    (void)context;
+    if (ptr == NULL)
+    {
+        test_allocator_malloc_calls++;
+    }
+    return realloc(ptr, size);
+}
+
+static void test_allocator_free(void* context, void* ptr)
+{
+    (void)context;
+    test_allocator_free_calls++;
+    free(ptr);
+}
+
+/* Tests_SRS_CONNECTION_01_361: [If allocator is not NULL and any of its functions is NULL, connection_create3 shall fail and return NULL.] */
+TEST_FUNCTION(connection_create3_with_an_allocator_without_free_function_fails)
+{
+    // arrange
+    CONNECTION_ALLOCATOR allocator = { test_allocator_malloc, test_allocator_realloc, NULL, NULL };
+
+    // act
+    CONNECTION_HANDLE connection = connection_create3(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL, NULL, NULL, NULL, NULL, &allocator);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_360: [If allocator is NULL, connection_create3 shall behave like connection_create2 and use the malloc family.] */
+TEST_FUNCTION(connection_create3_with_NULL_allocator_allocates_with_malloc)
+{
+    // arrange
+    test_allocator_malloc_calls = 0;
+
+    // act
+    CONNECTION_HANDLE connection = connection_create3(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(connection);
+    ASSERT_ARE_EQUAL(size_t, 0, test_allocator_malloc_calls);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_359: [connection_create3 shall allocate the connection, its host name, container id and endpoints, and the outgoing batch and send bookkeeping of its frames with the functions of allocator, passing them the allocator context.] */
+TEST_FUNCTION(connection_create3_allocates_and_frees_with_the_given_allocator)
+{
+    // arrange
+    CONNECTION_ALLOCATOR allocator = { test_allocator_malloc, test_allocator_realloc, test_allocator_free, NULL };
+    test_allocator_malloc_calls = 0;
+    test_allocator_free_calls = 0;
+
+    // act
+    CONNECTION_HANDLE connection = connection_create3(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL, NULL, NULL, NULL, NULL, &allocator);
+    connection_destroy(connection);
+
+    // assert
+    ASSERT_IS_NOT_NULL(connection);
+    ASSERT_ARE_NOT_EQUAL(size_t, 0, test_allocator_malloc_calls);
+    ASSERT_ARE_EQUAL(size_t, test_allocator_malloc_calls, test_allocator_free_calls);
+}
+
+/* connection_get_allocator */
+
+/* Tests_SRS_CONNECTION_01_362: [If connection or allocator are NULL, connection_get_allocator shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_allocator_with_NULL_connection_fails)
+{
+    // arrange
+    CONNECTION_ALLOCATOR allocator;
+
+    // act
+    int result = connection_get_allocator(NULL, &allocator);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_362: [If connection or allocator are NULL, connection_get_allocator shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_get_allocator_with_NULL_allocator_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_allocator(connection, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_363: [connection_get_allocator shall copy the allocator used by the connection to allocator and return 0, so that the owners of the connection can allocate their memory with it too.] */
+TEST_FUNCTION(connection_get_allocator_returns_the_allocator_given_at_create)
+{
+    // arrange
+    int test_context;
+    CONNECTION_ALLOCATOR allocator = { test_allocator_malloc, test_allocator_realloc, test_allocator_free, &test_context };
+    CONNECTION_ALLOCATOR result_allocator;
+    CONNECTION_HANDLE connection = connection_create3(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL, NULL, NULL, NULL, NULL, &allocator);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_get_allocator(connection, &result_allocator);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(result_allocator.malloc_function == test_allocator_malloc);
+    ASSERT_IS_TRUE(result_allocator.free_function == test_allocator_free);
+    ASSERT_ARE_EQUAL(void_ptr, &test_context, result_allocator.context);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_dowork */
+
+/* Tests_SRS_CONNECTION_01_078: [If handle is NULL, connection_dowork shall do nothing.] */
+TEST_FUNCTION(connection_dowork_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    connection_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_: [If the io has not been opened before, connection_dowork shall attempt to open the io by calling xio_open.] */
+TEST_FUNCTION(when_io_state_is_not_open_connection_dowork_opens_the_io)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    connection_dowork(connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_204: [If io_open_fails, no more work shall be done by connection_dowork and the connection shall be considered in the END state.] */
+TEST_FUNCTION(when_io_open_fails_the_connection_state_shall_be_set_to_END)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_START));
+
+    // act
+    connection_dowork(connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_076: [connection_dowork shall schedule the underlying IO interface to do its work by calling xio_dowork.] */
+/* Tests_SRS_CONNECTION_01_084: [The connection state machine implementing the protocol requirements shall be run as part of connection_dowork.] */
+/* Tests_SRS_CONNECTION_01_086: [Prior to sending any frames on a connection, each peer MUST start by sending a protocol header that indicates the protocol version used on the connection.] */
+/* Tests_SRS_CONNECTION_01_087: [The protocol header consists of the upper case ASCII letters "AMQP" followed by a protocol id of zero, followed by three unsigned bytes representing the major, minor, and revision of the protocol version (currently 1 (MAJOR), 0 (MINOR), 0 (REVISION)). In total this is an 8-octet sequence] */
+/* Tests_SRS_CONNECTION_01_091: [The AMQP peer which acted in the role of the TCP client (i.e. the peer that actively opened the connection) MUST immediately send its outgoing protocol header on establishment of the TCP connection.] */
+/* Tests_SRS_CONNECTION_01_093: [_ When the client opens a new socket connection to a server, it MUST send a protocol header with the client's preferred protocol version.] */
+/* Tests_SRS_CONNECTION_01_104: [Sending the protocol header shall be done by using xio_send.] */
+/* Tests_SRS_CONNECTION_01_041: [HDR SENT In this state the connection header has been sent to the peer but no connection header has been received.] */
+TEST_FUNCTION(connection_dowork_when_state_is_start_sends_the_AMQP_header_and_triggers_io_dowork)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, amqp_header, sizeof(amqp_header), IGNORED_PTR_ARG, NULL))
+        .ValidateArgumentBuffer(2, amqp_header, sizeof(amqp_header));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    connection_dowork(connection);
+
+    // act
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_202: [If the io notifies the connection instance of an IO_STATE_ERROR state the connection shall be closed and the state set to END.] */
+TEST_FUNCTION(when_io_state_changes_to_ERROR_the_io_is_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    connection_dowork(connection);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_START));
+
+    // act
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_ERROR, IO_STATE_NOT_OPEN);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_057: [END In this state it is illegal for either endpoint to write anything more onto the connection. The connection can be safely closed and discarded.] */
+/* Tests_SRS_CONNECTION_01_106: [When sending the protocol header fails, the connection shall be immediately closed.] */
+TEST_FUNCTION(when_sending_the_header_fails_the_io_is_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    connection_dowork(connection);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, amqp_header, sizeof(amqp_header), IGNORED_PTR_ARG, NULL))
+        .ValidateArgumentBuffer(2, amqp_header, sizeof(amqp_header))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_START));
+
+    // act
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
+TEST_FUNCTION(when_protocol_headers_do_not_match_connection_gets_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'Q', 0, 1, 0, 0 };
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_HDR_SENT));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
+TEST_FUNCTION(when_protocol_header_first_byte_does_not_match_connection_gets_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'B' };
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_HDR_SENT));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
+TEST_FUNCTION(when_protocol_header_last_byte_does_not_match_connection_gets_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 1 };
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_connection_state_changed(TEST_CONTEXT, CONNECTION_STATE_END, CONNECTION_STATE_HDR_SENT));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_089: [If the incoming and outgoing protocol headers do not match, both peers MUST close their outgoing stream] */
+TEST_FUNCTION(when_protocol_header_first_byte_matches_but_only_1st_byte_received_no_io_close_is_done)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A' };
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_134: [The container id field shall be filled with the container id specified in connection_create.] */
+/* Tests_SRS_CONNECTION_01_135: [If hostname has been specified by a call to connection_set_hostname, then that value shall be stamped in the open frame.] */
+/* Tests_SRS_CONNECTION_01_205: [Sending the AMQP OPEN frame shall be done by calling amqp_frame_codec_begin_encode_frame with channel number 0, the actual performative payload and 0 as payload_size.] */
+/* Tests_SRS_CONNECTION_01_151: [The connection max_frame_size setting shall be passed down to the frame_codec when the Open frame is sent.] */
+/* Tests_SRS_CONNECTION_01_137: [The max_frame_size connection setting shall be set in the open frame by using open_set_max_frame_size.] */
+/* Tests_SRS_CONNECTION_01_139: [The channel_max connection setting shall be set in the open frame by using open_set_channel_max.] */
+/* Tests_SRS_CONNECTION_01_004: [After establishing or accepting a TCP connection and sending the protocol header, each peer MUST send an open frame before sending any other frames.] */
+/* Tests_SRS_CONNECTION_01_002: [Each AMQP connection begins with an exchange of capabilities and limitations, including the maximum frame size.] */
+/* Tests_SRS_CONNECTION_01_005: [The open frame describes the capabilities and limits of that peer.] */
+/* Tests_SRS_CONNECTION_01_006: [The open frame can only be sent on channel 0.] */
+TEST_FUNCTION(when_the_header_is_received_an_open_frame_is_sent_out)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+    STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
+    STRICT_EXPECTED_CALL(open_create("1234"));
+    STRICT_EXPECTED_CALL(open_set_hostname(test_open_handle, "testhost"));
+    STRICT_EXPECTED_CALL(open_set_max_frame_size(test_open_handle, 4294967295));
+    STRICT_EXPECTED_CALL(open_set_channel_max(test_open_handle, 65535));
+    STRICT_EXPECTED_CALL(amqpvalue_create_open(test_open_handle));
+    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame(TEST_AMQP_FRAME_CODEC_HANDLE, 0, test_open_amqp_value, NULL, 0, NULL, NULL));
+    STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_open_amqp_value));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_207: [If frame_codec_set_max_frame_size fails the connection shall be closed and the state set to END.] */
+TEST_FUNCTION(when_setting_the_max_frame_size_fails_the_connection_is_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
+TEST_FUNCTION(when_open_create_fails_the_connection_is_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
+    STRICT_EXPECTED_CALL(open_create("1234"))
+        .SetReturn((OPEN_HANDLE)NULL);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
+TEST_FUNCTION(when_open_set_hostname_fails_the_connection_is_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    umock_c_reset_all_calls();
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4294967295));
+    STRICT_EXPECTED_CALL(open_create("1234"));
+    STRICT_EXPECTED_CALL(open_set_max_frame_size(test_open_handle, 4294967295));
+    STRICT_EXPECTED_CALL(open_set_channel_max(test_open_handle, 65535));
+    STRICT_EXPECTED_CALL(open_set_hostname(test_open_handle, "testhost"))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_208: [If the open frame cannot be constructed, the connection shall be closed and set to the END state.] */
+TEST_FUNCTION(when_amqpvalue_create_open_fails_the_connection_is_closed)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", "1234");
+    connection_dowork(connection);
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     umock_c_reset_all_calls();
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
@@ -1891,8 +4604,6 @@ TEST_FUNCTION(when_an_open_frame_that_cannot_be_parsed_properly_is_received_the_
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_open(TEST_OPEN_PERFORMATIVE, IGNORED_PTR_ARG))
         .SetReturn(1);
 
@@ -1908,7 +4619,7 @@ TEST_FUNCTION(when_an_open_frame_that_cannot_be_parsed_properly_is_received_the_
     STRICT_EXPECTED_CALL(error_destroy(test_error_handle));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -1931,8 +4642,6 @@ TEST_FUNCTION(when_the_max_frame_size_cannot_be_retrieved_from_the_open_framethe
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_open(TEST_OPEN_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &test_open_handle, sizeof(test_open_handle));
     STRICT_EXPECTED_CALL(open_get_max_frame_size(test_open_handle, IGNORED_PTR_ARG))
@@ -1951,7 +4660,7 @@ TEST_FUNCTION(when_the_max_frame_size_cannot_be_retrieved_from_the_open_framethe
     STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -1975,8 +4684,6 @@ TEST_FUNCTION(when_an_open_frame_with_max_frame_size_511_is_received_the_connect
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_open(TEST_OPEN_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &test_open_handle, sizeof(test_open_handle));
     uint32_t remote_max_frame_size = 511;
@@ -1996,7 +4703,7 @@ TEST_FUNCTION(when_an_open_frame_with_max_frame_size_511_is_received_the_connect
     STRICT_EXPECTED_CALL(open_destroy(test_open_handle));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2019,9 +4726,6 @@ TEST_FUNCTION(when_an_open_frame_is_received_on_channel_1_the_connection_is_clos
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-
     /* we expect to close because of bad OPEN */
     STRICT_EXPECTED_CALL(error_create("amqp:not-allowed"));
     STRICT_EXPECTED_CALL(error_set_description(test_error_handle, IGNORED_PTR_ARG));
@@ -2034,7 +4738,7 @@ TEST_FUNCTION(when_an_open_frame_is_received_on_channel_1_the_connection_is_clos
     STRICT_EXPECTED_CALL(error_destroy(test_error_handle));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2068,7 +4772,7 @@ TEST_FUNCTION(when_the_frame_received_callback_is_called_with_a_NULL_performativ
     STRICT_EXPECTED_CALL(error_destroy(test_error_handle));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, NULL, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, NULL, 0, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2087,7 +4791,7 @@ TEST_FUNCTION(when_an_open_frame_is_indicated_as_received_before_even_opening_th
     unsigned char payload_bytes[] = { 0x42 };
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, payload_bytes, sizeof(payload_bytes));
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, payload_bytes, sizeof(payload_bytes));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2108,7 +4812,7 @@ TEST_FUNCTION(when_an_open_frame_is_indicated_as_received_before_the_header_exch
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2129,7 +4833,7 @@ TEST_FUNCTION(when_a_close_frame_is_received_in_HDR_SENT_the_connection_is_close
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2149,16 +4853,11 @@ TEST_FUNCTION(when_a_close_frame_is_received_in_OPEN_SENT_a_CLOSE_is_sent)
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE))
-        .SetReturn(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE);
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_close(TEST_CLOSE_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &received_test_close_handle, sizeof(received_test_close_handle));
@@ -2173,7 +4872,7 @@ TEST_FUNCTION(when_a_close_frame_is_received_in_OPEN_SENT_a_CLOSE_is_sent)
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2191,16 +4890,11 @@ TEST_FUNCTION(when_a_close_frame_is_sent_as_response_to_a_close_frame_and_creati
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE))
-        .SetReturn(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE);
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_close(TEST_CLOSE_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &received_test_close_handle, sizeof(received_test_close_handle));
@@ -2212,7 +4906,7 @@ TEST_FUNCTION(when_a_close_frame_is_sent_as_response_to_a_close_frame_and_creati
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2230,16 +4924,11 @@ TEST_FUNCTION(when_a_close_frame_is_sent_as_response_to_a_close_frame_and_creati
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE))
-        .SetReturn(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE);
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_close(TEST_CLOSE_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &received_test_close_handle, sizeof(received_test_close_handle));
@@ -2253,7 +4942,7 @@ TEST_FUNCTION(when_a_close_frame_is_sent_as_response_to_a_close_frame_and_creati
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2271,16 +4960,11 @@ TEST_FUNCTION(when_a_close_frame_is_sent_as_response_to_a_close_frame_and_sendin
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE))
-        .SetReturn(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE);
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_close(TEST_CLOSE_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &received_test_close_handle, sizeof(received_test_close_handle));
@@ -2296,7 +4980,7 @@ TEST_FUNCTION(when_a_close_frame_is_sent_as_response_to_a_close_frame_and_sendin
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2314,14 +4998,11 @@ TEST_FUNCTION(when_an_open_frame_is_received_in_open_the_connection_shall_be_clo
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-
     STRICT_EXPECTED_CALL(error_create("amqp:illegal-state"));
     STRICT_EXPECTED_CALL(error_set_description(test_error_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(close_create());
@@ -2333,7 +5014,7 @@ TEST_FUNCTION(when_an_open_frame_is_received_in_open_the_connection_shall_be_clo
     STRICT_EXPECTED_CALL(error_destroy(test_error_handle));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2351,17 +5032,14 @@ TEST_FUNCTION(when_an_open_frame_is_received_in_the_DISCARDING_state_the_connect
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2380,19 +5058,15 @@ TEST_FUNCTION(when_in_discarding_state_the_connection_still_looks_for_the_close_
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2410,15 +5084,11 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_on_channel_1_it_is_still_valid)
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_close(TEST_CLOSE_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &received_test_close_handle, sizeof(received_test_close_handle));
@@ -2432,7 +5102,7 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_on_channel_1_it_is_still_valid)
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2450,15 +5120,11 @@ TEST_FUNCTION(when_a_CLOSE_frame_with_1_byte_payload_is_received_it_is_still_val
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_close(TEST_CLOSE_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &received_test_close_handle, sizeof(received_test_close_handle));
@@ -2474,7 +5140,7 @@ TEST_FUNCTION(when_a_CLOSE_frame_with_1_byte_payload_is_received_it_is_still_val
     unsigned char payload_bytes[] = { 0x42 };
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_CLOSE_PERFORMATIVE, payload_bytes, sizeof(payload_bytes));
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, payload_bytes, sizeof(payload_bytes));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2496,8 +5162,6 @@ TEST_FUNCTION(when_an_OPEN_frame_with_1_byte_payload_is_received_it_is_still_val
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_open(TEST_OPEN_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &test_open_handle, sizeof(test_open_handle));
@@ -2509,7 +5173,7 @@ TEST_FUNCTION(when_an_OPEN_frame_with_1_byte_payload_is_received_it_is_still_val
     unsigned char payload_bytes[] = { 0x42 };
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, payload_bytes, sizeof(payload_bytes));
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, payload_bytes, sizeof(payload_bytes));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2528,16 +5192,11 @@ TEST_FUNCTION(when_a_CLOSE_FRAME_is_received_on_a_channel_higher_than_the_max_ne
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-
     STRICT_EXPECTED_CALL(error_create("amqp:invalid-field"));
     STRICT_EXPECTED_CALL(error_set_description(test_error_handle, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(close_create());
@@ -2549,7 +5208,7 @@ TEST_FUNCTION(when_a_CLOSE_FRAME_is_received_on_a_channel_higher_than_the_max_ne
     STRICT_EXPECTED_CALL(error_destroy(test_error_handle));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 1, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2789,7 +5448,7 @@ TEST_FUNCTION(connection_destroy_endpoint_frees_the_resources_associated_with_th
     ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
@@ -2805,24 +5464,48 @@ TEST_FUNCTION(connection_destroy_endpoint_frees_the_resources_associated_with_th
 /* Tests_SRS_CONNECTION_01_129: [connection_destroy_endpoint shall free all resources associated with an endpoint created by connection_create_endpoint.] */
 /* Tests_SRS_CONNECTION_01_130: [The outgoing channel associated with the endpoint shall be released by removing the endpoint from the endpoint list.] */
 /* Tests_SRS_CONNECTION_01_131: [Any incoming channel number associated with the endpoint shall be released.] */
-TEST_FUNCTION(when_reallocating_the_endpoints_list_fails_connection_destroy_endpoint_shall_still_free_all_resources)
+TEST_FUNCTION(connection_destroy_endpoint_when_other_endpoints_are_there_does_not_reallocate_the_endpoints_list)
 {
     // arrange
     CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
-    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    ENDPOINT_HANDLE endpoint0 = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    ENDPOINT_HANDLE endpoint1 = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn((void*)NULL);
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    connection_destroy_endpoint(endpoint);
+    connection_destroy_endpoint(endpoint0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint1);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_197: [The newly created endpoint shall be added to the endpoints list, so that it can be tracked.] */
+TEST_FUNCTION(connection_create_endpoint_for_a_second_endpoint_does_not_reallocate_the_endpoints_list)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id);
+    ENDPOINT_HANDLE endpoint0 = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
+    ENDPOINT_HANDLE endpoint1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    endpoint1 = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
 
     // assert
+    ASSERT_IS_NOT_NULL(endpoint1);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
+    connection_destroy_endpoint(endpoint0);
+    connection_destroy_endpoint(endpoint1);
     connection_destroy(connection);
 }
 
@@ -2839,7 +5522,6 @@ TEST_FUNCTION(when_an_endpoint_is_released_another_one_can_be_created_in_its_pla
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
     // act
     endpoint1 = connection_create_endpoint(connection, test_on_frame_received, test_on_connection_state_changed, TEST_CONTEXT);
@@ -2896,6 +5578,7 @@ TEST_FUNCTION(connection_encode_frame_with_NULL_performative_fails)
 /* Tests_SRS_CONNECTION_01_251: [The channel number passed to amqp_frame_codec_begin_encode_frame shall be the outgoing channel number associated with the endpoint by connection_create_endpoint.] */
 /* Tests_SRS_CONNECTION_01_252: [The performative passed to amqp_frame_codec_begin_encode_frame shall be the performative argument of connection_encode_frame.] */
 /* Tests_SRS_CONNECTION_01_255: [The payload size shall be computed based on all the payload chunks passed as argument in payloads.] */
+/* Tests_SRS_CONNECTION_01_375: [The time of the last frame received and sent shall be taken from the coarse clock refreshed by connection_handle_deadlines instead of reading the tick counter for every frame.] */
 TEST_FUNCTION(connection_encode_frame_sends_the_frame)
 {
     // arrange
@@ -2905,7 +5588,7 @@ TEST_FUNCTION(connection_encode_frame_sends_the_frame)
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
@@ -2935,7 +5618,7 @@ TEST_FUNCTION(connection_encode_frame_with_1_payload_adds_the_bytes_to_the_frame
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     unsigned char test_payload[] = { 0x42 };
@@ -2968,7 +5651,7 @@ TEST_FUNCTION(connection_encode_frame_with_1_payload_of_2_bytes_adds_the_bytes_t
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     unsigned char test_payload[] = { 0x42, 0x43 };
@@ -3001,7 +5684,7 @@ TEST_FUNCTION(connection_encode_frame_with_2_payloads_of_1_byte_rach_adds_the_by
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     unsigned char test_payload1[] = { 0x42 };
@@ -3034,7 +5717,7 @@ TEST_FUNCTION(when_amqp_frame_codec_begin_encode_frame_fails_then_connection_enc
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     unsigned char test_payload1[] = { 0x42 };
@@ -3088,13 +5771,10 @@ TEST_FUNCTION(connection_encode_frame_after_close_has_been_received_fails)
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
     umock_c_reset_all_calls();
 
     unsigned char test_payload1[] = { 0x42 };
@@ -3127,7 +5807,7 @@ TEST_FUNCTION(connection_encode_frame_with_a_second_endpoint_sends_on_channel_1)
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
@@ -3161,7 +5841,7 @@ TEST_FUNCTION(when_an_endpoint_is_destroyed_and_a_new_one_is_created_the_channel
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
@@ -3270,8 +5950,6 @@ TEST_FUNCTION(when_state_changes_to_OPENED_all_endpoints_are_notified)
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_OPEN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
     STRICT_EXPECTED_CALL(amqpvalue_get_open(TEST_OPEN_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &test_open_handle, sizeof(test_open_handle));
     STRICT_EXPECTED_CALL(open_get_max_frame_size(test_open_handle, IGNORED_PTR_ARG));
@@ -3281,7 +5959,7 @@ TEST_FUNCTION(when_state_changes_to_OPENED_all_endpoints_are_notified)
     STRICT_EXPECTED_CALL(test_on_connection_state_changed(NULL, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3305,16 +5983,11 @@ TEST_FUNCTION(when_state_changes_to_CLOSE_RCVD_and_END_SENT_all_endpoints_are_no
     saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
     const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
     saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(amqpvalue_to_string(IGNORED_PTR_ARG)).IgnoreAllCalls();
 
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_CLOSE_PERFORMATIVE))
-        .SetReturn(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE);
-    STRICT_EXPECTED_CALL(is_open_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE))
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(is_close_type_by_descriptor(TEST_CLOSE_DESCRIPTOR_AMQP_VALUE));
     CLOSE_HANDLE received_test_close_handle = (CLOSE_HANDLE)0x4000;
     STRICT_EXPECTED_CALL(amqpvalue_get_close(TEST_CLOSE_PERFORMATIVE, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(2, &received_test_close_handle, sizeof(received_test_close_handle));
@@ -3334,14 +6007,109 @@ TEST_FUNCTION(when_state_changes_to_CLOSE_RCVD_and_END_SENT_all_endpoints_are_no
     STRICT_EXPECTED_CALL(test_on_connection_state_changed(NULL, CONNECTION_STATE_END, CONNECTION_STATE_CLOSE_RCVD));
 
     // act
-    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, 0, 0);
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_CLOSE_PERFORMATIVE, AMQP_CLOSE, 0, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint0);
+    connection_destroy_endpoint(endpoint1);
+    connection_destroy(connection);
+}
+
+/* connection_encode_frame_with_encoded_performative */
+
+/* Tests_SRS_CONNECTION_01_299: [If endpoint or performative_bytes are NULL or performative_size is 0, connection_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_encode_frame_with_encoded_performative_with_NULL_endpoint_fails)
+{
+    // arrange
+    unsigned char performative_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+
+    // act
+    int result = connection_encode_frame_with_encoded_performative(NULL, performative_bytes, sizeof(performative_bytes), NULL, 0, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_299: [If endpoint or performative_bytes are NULL or performative_size is 0, connection_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_encode_frame_with_encoded_performative_with_NULL_performative_bytes_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_encode_frame_with_encoded_performative(endpoint, NULL, 4, NULL, 0, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_298: [connection_encode_frame_with_encoded_performative shall send a frame for a certain endpoint, using performative_bytes as the already encoded performative.] */
+/* Tests_SRS_CONNECTION_01_301: [The frame shall be encoded by calling amqp_frame_codec_encode_frame_with_encoded_performative with the outgoing channel number of the endpoint, the performative bytes and the payloads.] */
+/* Tests_SRS_CONNECTION_01_303: [On success it shall return 0.] */
+TEST_FUNCTION(connection_encode_frame_with_encoded_performative_sends_the_frame)
+{
+    // arrange
+    unsigned char performative_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame_with_encoded_performative(TEST_AMQP_FRAME_CODEC_HANDLE, 0, performative_bytes, sizeof(performative_bytes), NULL, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    int result = connection_encode_frame_with_encoded_performative(endpoint, performative_bytes, sizeof(performative_bytes), NULL, 0, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy_endpoint(endpoint);
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_302: [If amqp_frame_codec_encode_frame_with_encoded_performative fails, then connection_encode_frame_with_encoded_performative shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_amqp_frame_codec_encode_frame_with_encoded_performative_fails_then_connection_encode_frame_with_encoded_performative_fails)
+{
+    // arrange
+    unsigned char performative_bytes[] = { 0x00, 0x53, 0x14, 0x45 };
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    connection_dowork(connection);
+    saved_io_state_changed(saved_on_io_open_complete_context, IO_STATE_OPEN, IO_STATE_NOT_OPEN);
+    const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+    saved_on_bytes_received(saved_on_bytes_received_context, amqp_header, sizeof(amqp_header));
+    saved_frame_received_callback(saved_amqp_frame_codec_callback_context, 0, TEST_OPEN_PERFORMATIVE, AMQP_OPEN, 0, 0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqp_frame_codec_encode_frame_with_encoded_performative(TEST_AMQP_FRAME_CODEC_HANDLE, 0, performative_bytes, sizeof(performative_bytes), NULL, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    int result = connection_encode_frame_with_encoded_performative(endpoint, performative_bytes, sizeof(performative_bytes), NULL, 0, test_on_send_complete, (void*)0x4242);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    connection_destroy_endpoint(endpoint0);
-    connection_destroy_endpoint(endpoint1);
+    connection_destroy_endpoint(endpoint);
     connection_destroy(connection);
 }
 #endif
@@ -3534,4 +6302,389 @@ TEST_FUNCTION(connection_set_trace_succeeds)
     connection_destroy(connection);
 }
 
+/* connection_save_handover_state */
+
+/* Tests_SRS_CONNECTION_01_434: [If connection, buffer or length is NULL, connection_save_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_save_handover_state_with_NULL_connection_fails)
+{
+    // arrange
+    unsigned char buffer[64];
+    size_t length;
+
+    // act
+    int result = connection_save_handover_state(NULL, buffer, sizeof(buffer), &length);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_434: [If connection, buffer or length is NULL, connection_save_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_save_handover_state_with_NULL_length_fails)
+{
+    // arrange
+    unsigned char buffer[64];
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_save_handover_state(connection, buffer, sizeof(buffer), NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_435: [If the connection is not OPENED, connection_save_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_save_handover_state_before_the_connection_is_opened_fails)
+{
+    // arrange
+    unsigned char buffer[64];
+    size_t length;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_save_handover_state(connection, buffer, sizeof(buffer), &length);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_437: [connection_save_handover_state shall encode in buffer, as an AMQP list, the negotiated max frame sizes, channel max and idle timeouts of the connection, set length to the number of bytes encoded and return 0.] */
+TEST_FUNCTION(connection_save_handover_state_encodes_the_negotiated_values)
+{
+    // arrange
+    unsigned char buffer[64];
+    size_t length;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    setup_handover_state_items();
+    (void)connection_restore_handover_state(connection, buffer, sizeof(buffer));
+    (void)connection_open(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_is_at_frame_boundary(TEST_FRAME_CODEC_HANDLE));
+    STRICT_EXPECTED_CALL(amqp_writer_init(IGNORED_PTR_ARG, buffer, sizeof(buffer)));
+    STRICT_EXPECTED_CALL(amqp_writer_begin_list(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_writer_put_uint(IGNORED_PTR_ARG, 1));
+    STRICT_EXPECTED_CALL(amqp_writer_put_uint(IGNORED_PTR_ARG, 4096));
+    STRICT_EXPECTED_CALL(amqp_writer_put_uint(IGNORED_PTR_ARG, 8192));
+    STRICT_EXPECTED_CALL(amqp_writer_put_uint(IGNORED_PTR_ARG, 15));
+    STRICT_EXPECTED_CALL(amqp_writer_put_uint(IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(amqp_writer_put_uint(IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(amqp_writer_end(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqp_writer_get_length(IGNORED_PTR_ARG, &length));
+
+    // act
+    int result = connection_save_handover_state(connection, buffer, sizeof(buffer), &length);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_436: [If part of a frame has been received, or frames are waiting in the outgoing batch or the send queue, connection_save_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_save_handover_state_with_part_of_a_frame_received_fails)
+{
+    // arrange
+    unsigned char buffer[64];
+    size_t length;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    setup_handover_state_items();
+    (void)connection_restore_handover_state(connection, buffer, sizeof(buffer));
+    (void)connection_open(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_is_at_frame_boundary(TEST_FRAME_CODEC_HANDLE))
+        .SetReturn(false);
+
+    // act
+    int result = connection_save_handover_state(connection, buffer, sizeof(buffer), &length);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_438: [If the state does not fit in buffer_size bytes, connection_save_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_encoding_the_handover_state_fails_connection_save_handover_state_fails)
+{
+    // arrange
+    unsigned char buffer[64];
+    size_t length;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    setup_handover_state_items();
+    (void)connection_restore_handover_state(connection, buffer, sizeof(buffer));
+    (void)connection_open(connection);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_is_at_frame_boundary(TEST_FRAME_CODEC_HANDLE));
+    STRICT_EXPECTED_CALL(amqp_writer_init(IGNORED_PTR_ARG, buffer, sizeof(buffer)));
+    STRICT_EXPECTED_CALL(amqp_writer_begin_list(IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    int result = connection_save_handover_state(connection, buffer, sizeof(buffer), &length);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_restore_handover_state */
+
+/* Tests_SRS_CONNECTION_01_439: [If connection or bytes is NULL, connection_restore_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_restore_handover_state_with_NULL_connection_fails)
+{
+    // arrange
+    unsigned char bytes[1] = { 0 };
+
+    // act
+    int result = connection_restore_handover_state(NULL, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_440: [If the connection has already been opened, connection_restore_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_restore_handover_state_after_connection_open_fails)
+{
+    // arrange
+    unsigned char bytes[1] = { 0 };
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_open(connection);
+    setup_handover_state_items();
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_restore_handover_state(connection, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_441: [If bytes is not a connection handover state of this version, connection_restore_handover_state shall fail and return a non-zero value and leave the connection unchanged.] */
+TEST_FUNCTION(connection_restore_handover_state_with_another_version_fails)
+{
+    // arrange
+    unsigned char bytes[1] = { 0 };
+    uint32_t max_frame_size;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    setup_handover_state_items();
+    handover_state_items[1].value.unsigned_value = 2;
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_restore_handover_state(connection, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    (void)connection_get_max_frame_size(connection, &max_frame_size);
+    ASSERT_ARE_EQUAL(uint32_t, 4294967295, max_frame_size);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_444: [On success, connection_restore_handover_state shall set the negotiated values of the connection from bytes and return 0, and the next connection_open shall resume the connection instead of negotiating it.] */
+TEST_FUNCTION(connection_restore_handover_state_sets_the_negotiated_values)
+{
+    // arrange
+    unsigned char bytes[1] = { 0 };
+    uint32_t max_frame_size;
+    uint32_t remote_max_frame_size;
+    uint16_t channel_max;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    setup_handover_state_items();
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_restore_handover_state(connection, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)connection_get_max_frame_size(connection, &max_frame_size);
+    (void)connection_get_remote_max_frame_size(connection, &remote_max_frame_size);
+    (void)connection_get_channel_max(connection, &channel_max);
+    ASSERT_ARE_EQUAL(uint32_t, 4096, max_frame_size);
+    ASSERT_ARE_EQUAL(uint32_t, 8192, remote_max_frame_size);
+    ASSERT_ARE_EQUAL(uint32_t, 15, (uint32_t)channel_max);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_442: [When the io of a connection restored from a handover state opens, the restored max frame size shall be passed to the frame_codec, the idle timeouts shall start from the current time and the connection shall switch to the OPENED state without sending a protocol header or an open frame.] */
+TEST_FUNCTION(when_the_io_of_a_restored_connection_opens_the_connection_resumes_without_sending_a_header)
+{
+    // arrange
+    unsigned char bytes[1] = { 0 };
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    setup_handover_state_items();
+    (void)connection_restore_handover_state(connection, bytes, sizeof(bytes));
+    (void)connection_open(connection);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4096));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_443: [If resuming the connection fails, the io shall be closed and the state set to END.] */
+TEST_FUNCTION(when_setting_the_max_frame_size_fails_resuming_the_connection_closes_the_io)
+{
+    // arrange
+    unsigned char bytes[1] = { 0 };
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    setup_handover_state_items();
+    (void)connection_restore_handover_state(connection, bytes, sizeof(bytes));
+    (void)connection_open(connection);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(frame_codec_set_max_frame_size(TEST_FRAME_CODEC_HANDLE, 4096))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_endpoint_get_outgoing_channel */
+
+/* Tests_SRS_CONNECTION_01_448: [If endpoint or outgoing_channel is NULL, connection_endpoint_get_outgoing_channel shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_endpoint_get_outgoing_channel_with_NULL_endpoint_fails)
+{
+    // arrange
+    uint16_t outgoing_channel;
+
+    // act
+    int result = connection_endpoint_get_outgoing_channel(NULL, &outgoing_channel);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_449: [connection_endpoint_get_outgoing_channel shall return in outgoing_channel the outgoing channel of the endpoint and return 0.] */
+TEST_FUNCTION(connection_endpoint_get_outgoing_channel_returns_the_outgoing_channel)
+{
+    // arrange
+    uint16_t outgoing_channel;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_create_endpoint(connection);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_endpoint_get_outgoing_channel(endpoint, &outgoing_channel);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 1, (uint32_t)outgoing_channel);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* connection_endpoint_restore_channels */
+
+/* Tests_SRS_CONNECTION_01_445: [If endpoint is NULL, connection_endpoint_restore_channels shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_endpoint_restore_channels_with_NULL_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = connection_endpoint_restore_channels(NULL, 1, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTION_01_446: [If outgoing_channel is used by another endpoint, is over the channel max, or incoming_channel cannot be mapped, connection_endpoint_restore_channels shall fail and return a non-zero value.] */
+TEST_FUNCTION(connection_endpoint_restore_channels_on_a_channel_used_by_another_endpoint_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    (void)connection_create_endpoint(connection);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = connection_endpoint_restore_channels(endpoint, 0, 3);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
+/* Tests_SRS_CONNECTION_01_447: [connection_endpoint_restore_channels shall move the endpoint to outgoing_channel, keeping the endpoints sorted by outgoing channel, map incoming_channel to it and return 0.] */
+TEST_FUNCTION(connection_endpoint_restore_channels_moves_the_endpoint_to_the_outgoing_channel)
+{
+    // arrange
+    uint16_t outgoing_channel;
+    uint16_t incoming_channel;
+    uint16_t new_outgoing_channel;
+    CONNECTION_HANDLE connection = connection_create(TEST_IO_HANDLE, "testhost", test_container_id, NULL, NULL);
+    ENDPOINT_HANDLE endpoint = connection_create_endpoint(connection);
+    (void)connection_create_endpoint(connection);
+
+    // act
+    int result = connection_endpoint_restore_channels(endpoint, 5, 3);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)connection_endpoint_get_outgoing_channel(endpoint, &outgoing_channel);
+    (void)connection_endpoint_get_incoming_channel(endpoint, &incoming_channel);
+    (void)connection_endpoint_get_outgoing_channel(connection_create_endpoint(connection), &new_outgoing_channel);
+    ASSERT_ARE_EQUAL(uint32_t, 5, (uint32_t)outgoing_channel);
+    ASSERT_ARE_EQUAL(uint32_t, 3, (uint32_t)incoming_channel);
+    ASSERT_ARE_EQUAL(uint32_t, 0, (uint32_t)new_outgoing_channel);
+
+    // cleanup
+    connection_destroy(connection);
+}
+
 END_TEST_SUITE(connection_ut)
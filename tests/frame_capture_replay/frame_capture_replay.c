@@ -0,0 +1,1205 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/uamqp.h"
+#include "perf_counters/perf_counters.h"
+
+/* Replays the bytes a connection received, captured with frame_trace_set_capture, through a connection on top of an
+   io that has no network: the captured chunks are given to the connection as they were read, so they go through
+   frame_codec_receive_bytes, amqp_frame_codec, the session, the link and the message receiver, and whatever the
+   connection sends back is dropped. This gives receive path numbers on the payload shapes of a real stream that can
+   be repeated run after run.
+   A capture made on the listening side (the header was consumed by header_detect_io) starts with the OPEN frame and
+   is replayed by a listening connection that accepts every session and link. A capture made on the connecting side
+   starts with the protocol header and is replayed by a connecting connection; for it a first pass decodes the capture
+   to create, before the replay, one session for each BEGIN and one link for each ATTACH with the name of the link
+   the peer attached. The links are given a credit and the sessions a window large enough for the whole capture. */
+
+typedef struct REPLAY_CONFIG_TAG
+{
+    const char* capture_file_name;
+    size_t iteration_count;
+    uint32_t max_frame_size;
+    bool use_counters;
+} REPLAY_CONFIG;
+
+static REPLAY_CONFIG config = { NULL, 10, 0, false };
+
+#define REPLAY_SESSION_WINDOW 0x7FFFFFFF
+#define REPLAY_LINK_CREDIT 0x7FFFFFFF
+
+typedef struct CAPTURE_CHUNK_TAG
+{
+    const unsigned char* bytes;
+    size_t length;
+} CAPTURE_CHUNK;
+
+/* a link attached by the peer, found by the first pass over a capture of the connecting side */
+typedef struct CAPTURED_LINK_TAG
+{
+    uint16_t incoming_channel;
+    char* name;
+    role remote_role;
+    AMQP_VALUE source;
+    AMQP_VALUE target;
+} CAPTURED_LINK;
+
+typedef struct CAPTURED_BEGIN_TAG
+{
+    uint16_t incoming_channel;
+    uint16_t local_channel;
+} CAPTURED_BEGIN;
+
+typedef struct CAPTURE_TAG
+{
+    unsigned char* file_bytes;
+    CAPTURE_CHUNK* chunks;
+    size_t chunk_count;
+    size_t chunk_capacity;
+    uint64_t byte_count;
+    bool is_listening_side;
+    /* first pass */
+    uint64_t frame_count;
+    uint64_t transfer_count;
+    CAPTURED_BEGIN* begins;
+    size_t begin_count;
+    CAPTURED_LINK* links;
+    size_t link_count;
+    uint16_t session_count;
+    bool has_decode_error;
+} CAPTURE;
+
+typedef struct REPLAY_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_RECEIVER_HANDLE message_receiver;
+    MESSAGE_SENDER_HANDLE message_sender;
+} REPLAY_LINK;
+
+typedef struct REPLAY_SESSION_TAG
+{
+    struct REPLAY_TAG* replay;
+    SESSION_HANDLE session;
+} REPLAY_SESSION;
+
+typedef struct REPLAY_TAG
+{
+    CONNECTION_HANDLE connection;
+    XIO_HANDLE io;
+    REPLAY_SESSION** sessions;
+    size_t session_count;
+    REPLAY_LINK* links;
+    size_t link_count;
+    size_t link_capacity;
+    bool has_failed;
+} REPLAY;
+
+/* the io under the replaying connection */
+typedef struct REPLAY_IO_INSTANCE_TAG
+{
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    bool is_open_pending;
+    bool is_open;
+} REPLAY_IO_INSTANCE;
+
+static uint64_t total_messages_received;
+static uint64_t total_bytes_sent;
+/* one replay runs at a time, this is the io its connection is on */
+static REPLAY_IO_INSTANCE* current_replay_io;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static uint64_t get_cpu_time_us(void)
+{
+#ifdef _WIN32
+    FILETIME creation_time;
+    FILETIME exit_time;
+    FILETIME kernel_time;
+    FILETIME user_time;
+    uint64_t result;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        result = 0;
+    }
+    else
+    {
+        /* 100 ns units */
+        result = ((((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime) +
+            (((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime)) / 10;
+    }
+
+    return result;
+#else
+    struct rusage usage;
+    uint64_t result;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = ((uint64_t)usage.ru_utime.tv_sec * 1000000) + (uint64_t)usage.ru_utime.tv_usec +
+            ((uint64_t)usage.ru_stime.tv_sec * 1000000) + (uint64_t)usage.ru_stime.tv_usec;
+    }
+
+    return result;
+#endif
+}
+
+static CONCRETE_IO_HANDLE replay_io_create(void* io_create_parameters)
+{
+    REPLAY_IO_INSTANCE* result = (REPLAY_IO_INSTANCE*)calloc(1, sizeof(REPLAY_IO_INSTANCE));
+    (void)io_create_parameters;
+
+    if (result == NULL)
+    {
+        LogError("Cannot allocate memory for the replay io");
+    }
+    else
+    {
+        current_replay_io = result;
+    }
+
+    return result;
+}
+
+static void replay_io_destroy(CONCRETE_IO_HANDLE replay_io)
+{
+    if (current_replay_io == replay_io)
+    {
+        current_replay_io = NULL;
+    }
+
+    free(replay_io);
+}
+
+static int replay_io_open(CONCRETE_IO_HANDLE replay_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    REPLAY_IO_INSTANCE* replay_io_instance = (REPLAY_IO_INSTANCE*)replay_io;
+
+    (void)on_io_error;
+    (void)on_io_error_context;
+
+    replay_io_instance->on_io_open_complete = on_io_open_complete;
+    replay_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+    replay_io_instance->on_bytes_received = on_bytes_received;
+    replay_io_instance->on_bytes_received_context = on_bytes_received_context;
+
+    /* the connection sets its state after xio_open returns, so the open completes in the next dowork */
+    replay_io_instance->is_open_pending = true;
+
+    return 0;
+}
+
+static int replay_io_close(CONCRETE_IO_HANDLE replay_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    REPLAY_IO_INSTANCE* replay_io_instance = (REPLAY_IO_INSTANCE*)replay_io;
+
+    replay_io_instance->is_open = false;
+    replay_io_instance->is_open_pending = false;
+
+    if (on_io_close_complete != NULL)
+    {
+        on_io_close_complete(callback_context);
+    }
+
+    return 0;
+}
+
+static int replay_io_send(CONCRETE_IO_HANDLE replay_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    (void)replay_io;
+    (void)buffer;
+
+    total_bytes_sent += size;
+
+    if (on_send_complete != NULL)
+    {
+        on_send_complete(callback_context, IO_SEND_OK);
+    }
+
+    return 0;
+}
+
+static void replay_io_dowork(CONCRETE_IO_HANDLE replay_io)
+{
+    REPLAY_IO_INSTANCE* replay_io_instance = (REPLAY_IO_INSTANCE*)replay_io;
+
+    if (replay_io_instance->is_open_pending)
+    {
+        replay_io_instance->is_open_pending = false;
+        replay_io_instance->is_open = true;
+        replay_io_instance->on_io_open_complete(replay_io_instance->on_io_open_complete_context, IO_OPEN_OK);
+    }
+}
+
+static int replay_io_setoption(CONCRETE_IO_HANDLE replay_io, const char* option_name, const void* value)
+{
+    (void)replay_io;
+    (void)value;
+
+    LogError("Option %s is not supported by the replay io", option_name);
+    return __LINE__;
+}
+
+static OPTIONHANDLER_HANDLE replay_io_retrieveoptions(CONCRETE_IO_HANDLE replay_io)
+{
+    (void)replay_io;
+    return NULL;
+}
+
+static const IO_INTERFACE_DESCRIPTION replay_io_interface_description =
+{
+    replay_io_retrieveoptions,
+    replay_io_create,
+    replay_io_destroy,
+    replay_io_open,
+    replay_io_close,
+    replay_io_send,
+    replay_io_dowork,
+    replay_io_setoption
+};
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s --capture <file> [options]\n"
+        "  --capture <file>           capture written with frame_trace_set_capture\n"
+        "  --iterations <count>       replays of the capture (default 10)\n"
+        "  --frame-size <bytes>       max frame size of the replaying connection (default: the connection default)\n"
+        "  --counters <on|off>        hardware counters per frame (default off)\n",
+        program_name);
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned long number = (value == NULL) ? 0 : strtoul(value, NULL, 10);
+
+        if (value == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--capture") == 0)
+        {
+            config.capture_file_name = value;
+        }
+        else if (strcmp(argv[i], "--iterations") == 0)
+        {
+            config.iteration_count = number;
+        }
+        else if (strcmp(argv[i], "--frame-size") == 0)
+        {
+            config.max_frame_size = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--counters") == 0)
+        {
+            if (strcmp(value, "on") == 0)
+            {
+                config.use_counters = true;
+            }
+            else if (strcmp(value, "off") == 0)
+            {
+                config.use_counters = false;
+            }
+            else
+            {
+                result = __LINE__;
+            }
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    if ((result == 0) &&
+        ((config.capture_file_name == NULL) ||
+        (config.iteration_count == 0) ||
+        ((config.max_frame_size != 0) && (config.max_frame_size < 512))))
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+static unsigned char* read_file(const char* file_name, size_t* size)
+{
+    unsigned char* result;
+    FILE* file = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        LogError("Cannot open %s", file_name);
+        result = NULL;
+    }
+    else
+    {
+        size_t capacity = 64 * 1024;
+
+        *size = 0;
+        result = (unsigned char*)malloc(capacity);
+        while (result != NULL)
+        {
+            size_t read_size = fread(result + *size, 1, capacity - *size, file);
+            *size += read_size;
+
+            if (*size < capacity)
+            {
+                break;
+            }
+            else
+            {
+                unsigned char* new_result = (unsigned char*)realloc(result, capacity * 2);
+                if (new_result == NULL)
+                {
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result = new_result;
+                    capacity *= 2;
+                }
+            }
+        }
+
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for reading %s", file_name);
+        }
+        else if (ferror(file))
+        {
+            LogError("Cannot read %s", file_name);
+            free(result);
+            result = NULL;
+        }
+
+        (void)fclose(file);
+    }
+
+    return result;
+}
+
+static void on_capture_chunk(void* context, uint64_t timestamp_ms, const unsigned char* bytes, size_t length)
+{
+    CAPTURE* capture = (CAPTURE*)context;
+
+    (void)timestamp_ms;
+
+    if (capture->chunk_count == capture->chunk_capacity)
+    {
+        size_t new_capacity = (capture->chunk_capacity == 0) ? 1024 : capture->chunk_capacity * 2;
+        CAPTURE_CHUNK* new_chunks = (CAPTURE_CHUNK*)realloc(capture->chunks, sizeof(CAPTURE_CHUNK) * new_capacity);
+        if (new_chunks == NULL)
+        {
+            LogError("Cannot allocate memory for the capture chunks");
+            capture->has_decode_error = true;
+        }
+        else
+        {
+            capture->chunks = new_chunks;
+            capture->chunk_capacity = new_capacity;
+        }
+    }
+
+    if (capture->chunk_count < capture->chunk_capacity)
+    {
+        /* the chunks point in the file bytes, which are kept for the whole run */
+        capture->chunks[capture->chunk_count].bytes = bytes;
+        capture->chunks[capture->chunk_count].length = length;
+        capture->chunk_count++;
+        capture->byte_count += length;
+    }
+}
+
+static void on_first_pass_frame_codec_error(void* context)
+{
+    CAPTURE* capture = (CAPTURE*)context;
+    capture->has_decode_error = true;
+}
+
+static void on_first_pass_empty_frame_received(void* context, uint16_t channel)
+{
+    CAPTURE* capture = (CAPTURE*)context;
+    (void)channel;
+    capture->frame_count++;
+}
+
+static void add_captured_begin(CAPTURE* capture, uint16_t channel, AMQP_VALUE performative)
+{
+    BEGIN_HANDLE begin_handle;
+    uint16_t remote_channel;
+
+    if (amqpvalue_get_begin(performative, &begin_handle) != 0)
+    {
+        LogError("Cannot decode a captured BEGIN");
+        capture->has_decode_error = true;
+    }
+    else
+    {
+        /* a BEGIN without remote channel starts a session of the peer, which only a listening side gets */
+        if (begin_get_remote_channel(begin_handle, &remote_channel) == 0)
+        {
+            CAPTURED_BEGIN* new_begins = (CAPTURED_BEGIN*)realloc(capture->begins, sizeof(CAPTURED_BEGIN) * (capture->begin_count + 1));
+            if (new_begins == NULL)
+            {
+                LogError("Cannot allocate memory for the captured BEGIN");
+                capture->has_decode_error = true;
+            }
+            else
+            {
+                capture->begins = new_begins;
+                capture->begins[capture->begin_count].incoming_channel = channel;
+                capture->begins[capture->begin_count].local_channel = remote_channel;
+                capture->begin_count++;
+
+                if (remote_channel >= capture->session_count)
+                {
+                    capture->session_count = (uint16_t)(remote_channel + 1);
+                }
+            }
+        }
+
+        begin_destroy(begin_handle);
+    }
+}
+
+static void add_captured_link(CAPTURE* capture, uint16_t channel, AMQP_VALUE performative)
+{
+    ATTACH_HANDLE attach_handle;
+
+    if (amqpvalue_get_attach(performative, &attach_handle) != 0)
+    {
+        LogError("Cannot decode a captured ATTACH");
+        capture->has_decode_error = true;
+    }
+    else
+    {
+        const char* name;
+        role remote_role;
+        AMQP_VALUE source = NULL;
+        AMQP_VALUE target = NULL;
+        CAPTURED_LINK* new_links;
+
+        (void)attach_get_source(attach_handle, &source);
+        (void)attach_get_target(attach_handle, &target);
+
+        if ((attach_get_name(attach_handle, &name) != 0) ||
+            (attach_get_role(attach_handle, &remote_role) != 0))
+        {
+            LogError("Cannot get the name and role of a captured ATTACH");
+            capture->has_decode_error = true;
+        }
+        else if ((new_links = (CAPTURED_LINK*)realloc(capture->links, sizeof(CAPTURED_LINK) * (capture->link_count + 1))) == NULL)
+        {
+            LogError("Cannot allocate memory for the captured ATTACH");
+            capture->has_decode_error = true;
+        }
+        else
+        {
+            CAPTURED_LINK* captured_link = &new_links[capture->link_count];
+            size_t name_length = strlen(name);
+
+            capture->links = new_links;
+            captured_link->incoming_channel = channel;
+            captured_link->remote_role = remote_role;
+            captured_link->name = (char*)malloc(name_length + 1);
+            captured_link->source = (source == NULL) ? NULL : amqpvalue_clone(source);
+            captured_link->target = (target == NULL) ? NULL : amqpvalue_clone(target);
+
+            if (captured_link->name != NULL)
+            {
+                (void)memcpy(captured_link->name, name, name_length + 1);
+            }
+
+            if ((captured_link->name == NULL) ||
+                ((source != NULL) && (captured_link->source == NULL)) ||
+                ((target != NULL) && (captured_link->target == NULL)))
+            {
+                LogError("Cannot copy a captured ATTACH");
+                free(captured_link->name);
+                if (captured_link->source != NULL)
+                {
+                    amqpvalue_destroy(captured_link->source);
+                }
+                if (captured_link->target != NULL)
+                {
+                    amqpvalue_destroy(captured_link->target);
+                }
+                capture->has_decode_error = true;
+            }
+            else
+            {
+                capture->link_count++;
+            }
+        }
+
+        attach_destroy(attach_handle);
+    }
+}
+
+static void on_first_pass_frame_received(void* context, uint16_t channel, AMQP_VALUE performative, uint64_t performative_code, const unsigned char* payload_bytes, uint32_t frame_payload_size)
+{
+    CAPTURE* capture = (CAPTURE*)context;
+
+    (void)payload_bytes;
+    (void)frame_payload_size;
+
+    capture->frame_count++;
+
+    if (performative_code == AMQP_TRANSFER)
+    {
+        capture->transfer_count++;
+    }
+    else if (!capture->is_listening_side)
+    {
+        if (performative_code == AMQP_BEGIN)
+        {
+            add_captured_begin(capture, channel, performative);
+        }
+        else if (performative_code == AMQP_ATTACH)
+        {
+            add_captured_link(capture, channel, performative);
+        }
+    }
+}
+
+/* decodes the frames of the capture once, outside of the timed replays */
+static int run_first_pass(CAPTURE* capture)
+{
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(on_first_pass_frame_codec_error, capture);
+
+    if (frame_codec == NULL)
+    {
+        LogError("Cannot create the frame codec");
+        result = __LINE__;
+    }
+    else
+    {
+        AMQP_FRAME_CODEC_HANDLE amqp_frame_codec = amqp_frame_codec_create(frame_codec, on_first_pass_frame_received, on_first_pass_empty_frame_received, on_first_pass_frame_codec_error, capture);
+        if (amqp_frame_codec == NULL)
+        {
+            LogError("Cannot create the AMQP frame codec");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t header_bytes_left = capture->is_listening_side ? 0 : 8;
+            size_t i;
+
+            if (config.max_frame_size != 0)
+            {
+                (void)frame_codec_set_max_frame_size(frame_codec, config.max_frame_size);
+            }
+
+            for (i = 0; (i < capture->chunk_count) && !capture->has_decode_error; i++)
+            {
+                const unsigned char* bytes = capture->chunks[i].bytes;
+                size_t length = capture->chunks[i].length;
+
+                /* the protocol header is not a frame */
+                if (header_bytes_left > 0)
+                {
+                    size_t skipped = (length < header_bytes_left) ? length : header_bytes_left;
+                    header_bytes_left -= skipped;
+                    bytes += skipped;
+                    length -= skipped;
+                }
+
+                if ((length > 0) &&
+                    (frame_codec_receive_bytes(frame_codec, bytes, length) != 0))
+                {
+                    capture->has_decode_error = true;
+                }
+            }
+
+            if (capture->has_decode_error)
+            {
+                LogError("Cannot decode the frames of the capture");
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            amqp_frame_codec_destroy(amqp_frame_codec);
+        }
+
+        frame_codec_destroy(frame_codec);
+    }
+
+    return result;
+}
+
+static int load_capture(CAPTURE* capture, const char* file_name)
+{
+    int result;
+    size_t size;
+
+    (void)memset(capture, 0, sizeof(CAPTURE));
+
+    capture->file_bytes = read_file(file_name, &size);
+    if (capture->file_bytes == NULL)
+    {
+        result = __LINE__;
+    }
+    else if (frame_trace_parse_capture(capture->file_bytes, size, on_capture_chunk, capture) != 0)
+    {
+        LogError("%s is not a valid capture", file_name);
+        result = __LINE__;
+    }
+    else if (capture->has_decode_error)
+    {
+        result = __LINE__;
+    }
+    else if (capture->byte_count == 0)
+    {
+        LogError("%s has no bytes", file_name);
+        result = __LINE__;
+    }
+    else
+    {
+        /* the header only reaches the connection on the connecting side */
+        capture->is_listening_side = (capture->chunks[0].bytes[0] != 'A');
+        result = run_first_pass(capture);
+    }
+
+    return result;
+}
+
+static void free_capture(CAPTURE* capture)
+{
+    size_t i;
+
+    for (i = 0; i < capture->link_count; i++)
+    {
+        free(capture->links[i].name);
+        if (capture->links[i].source != NULL)
+        {
+            amqpvalue_destroy(capture->links[i].source);
+        }
+        if (capture->links[i].target != NULL)
+        {
+            amqpvalue_destroy(capture->links[i].target);
+        }
+    }
+
+    free(capture->links);
+    free(capture->begins);
+    free(capture->chunks);
+    free(capture->file_bytes);
+}
+
+static void on_message_receiver_state_changed(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state)
+{
+    (void)context;
+    (void)new_state;
+    (void)previous_state;
+}
+
+static void on_message_sender_state_changed(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
+{
+    (void)context;
+    (void)new_state;
+    (void)previous_state;
+}
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    (void)context;
+    (void)message;
+
+    total_messages_received++;
+
+    return messaging_delivery_accepted();
+}
+
+/* the link does the role opposite to the one of the peer: a receiver for the links the peer sends on */
+static int open_replay_link(REPLAY* replay, LINK_HANDLE link, role remote_role)
+{
+    int result;
+
+    if (replay->link_count == replay->link_capacity)
+    {
+        size_t new_capacity = (replay->link_capacity == 0) ? 16 : replay->link_capacity * 2;
+        REPLAY_LINK* new_links = (REPLAY_LINK*)realloc(replay->links, sizeof(REPLAY_LINK) * new_capacity);
+        if (new_links != NULL)
+        {
+            replay->links = new_links;
+            replay->link_capacity = new_capacity;
+        }
+    }
+
+    if (replay->link_count == replay->link_capacity)
+    {
+        LogError("Cannot allocate memory for the link");
+        result = __LINE__;
+    }
+    else
+    {
+        REPLAY_LINK* replay_link = &replay->links[replay->link_count];
+
+        replay_link->link = link;
+        replay_link->message_receiver = NULL;
+        replay_link->message_sender = NULL;
+
+        if (remote_role == role_sender)
+        {
+            if ((link_set_rcv_settle_mode(link, receiver_settle_mode_first) != 0) ||
+                (link_set_max_link_credit(link, REPLAY_LINK_CREDIT) != 0))
+            {
+                LogError("Cannot set link properties");
+                result = __LINE__;
+            }
+            else if ((replay_link->message_receiver = messagereceiver_create(link, on_message_receiver_state_changed, NULL)) == NULL)
+            {
+                LogError("Cannot create message receiver");
+                result = __LINE__;
+            }
+            else if (messagereceiver_open(replay_link->message_receiver, on_message_received, NULL) != 0)
+            {
+                messagereceiver_destroy(replay_link->message_receiver);
+                LogError("Cannot open message receiver");
+                result = __LINE__;
+            }
+            else
+            {
+                replay->link_count++;
+                result = 0;
+            }
+        }
+        else
+        {
+            if ((replay_link->message_sender = messagesender_create(link, on_message_sender_state_changed, NULL)) == NULL)
+            {
+                LogError("Cannot create message sender");
+                result = __LINE__;
+            }
+            else if (messagesender_open(replay_link->message_sender) != 0)
+            {
+                messagesender_destroy(replay_link->message_sender);
+                LogError("Cannot open message sender");
+                result = __LINE__;
+            }
+            else
+            {
+                replay->link_count++;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static REPLAY_SESSION* add_replay_session(REPLAY* replay)
+{
+    REPLAY_SESSION* result;
+    REPLAY_SESSION** new_sessions = (REPLAY_SESSION**)realloc(replay->sessions, sizeof(REPLAY_SESSION*) * (replay->session_count + 1));
+
+    if (new_sessions == NULL)
+    {
+        LogError("Cannot allocate memory for the session");
+        result = NULL;
+    }
+    else
+    {
+        replay->sessions = new_sessions;
+
+        result = (REPLAY_SESSION*)malloc(sizeof(REPLAY_SESSION));
+        if (result == NULL)
+        {
+            LogError("Cannot allocate memory for the session");
+        }
+        else
+        {
+            result->replay = replay;
+            result->session = NULL;
+            replay->sessions[replay->session_count] = result;
+            replay->session_count++;
+        }
+    }
+
+    return result;
+}
+
+static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    REPLAY_SESSION* replay_session = (REPLAY_SESSION*)context;
+    bool result;
+    LINK_HANDLE link = link_create_from_endpoint(replay_session->session, new_link_endpoint, name, role, source, target);
+
+    if (link == NULL)
+    {
+        LogError("Cannot create link");
+        replay_session->replay->has_failed = true;
+        result = false;
+    }
+    else if (open_replay_link(replay_session->replay, link, role) != 0)
+    {
+        link_destroy(link);
+        replay_session->replay->has_failed = true;
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+
+    return result;
+}
+
+static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    REPLAY* replay = (REPLAY*)context;
+    bool result;
+    REPLAY_SESSION* replay_session = add_replay_session(replay);
+
+    if (replay_session == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        replay_session->session = session_create_from_endpoint(replay->connection, new_endpoint, on_new_link_attached, replay_session);
+        if (replay_session->session == NULL)
+        {
+            LogError("Cannot create session");
+            result = false;
+        }
+        else if ((session_set_incoming_window(replay_session->session, REPLAY_SESSION_WINDOW) != 0) ||
+            (session_begin(replay_session->session) != 0))
+        {
+            LogError("Cannot begin session");
+            result = false;
+        }
+        else
+        {
+            result = true;
+        }
+    }
+
+    if (!result)
+    {
+        replay->has_failed = true;
+    }
+
+    return result;
+}
+
+/* the sessions and links of a capture of the connecting side, begun and attached before the connection opens */
+static int create_client_endpoints(REPLAY* replay, const CAPTURE* capture)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (result == 0) && (i < capture->session_count); i++)
+    {
+        REPLAY_SESSION* replay_session = add_replay_session(replay);
+
+        if (replay_session == NULL)
+        {
+            result = __LINE__;
+        }
+        else if ((replay_session->session = session_create(replay->connection, NULL, NULL)) == NULL)
+        {
+            LogError("Cannot create session");
+            result = __LINE__;
+        }
+        else if ((session_set_incoming_window(replay_session->session, REPLAY_SESSION_WINDOW) != 0) ||
+            (session_begin(replay_session->session) != 0))
+        {
+            LogError("Cannot begin session");
+            result = __LINE__;
+        }
+    }
+
+    for (i = 0; (result == 0) && (i < capture->link_count); i++)
+    {
+        const CAPTURED_LINK* captured_link = &capture->links[i];
+        size_t j;
+
+        /* the peer sends on its channel, the BEGIN it answered with tells which of the local sessions that is */
+        for (j = 0; j < capture->begin_count; j++)
+        {
+            if (capture->begins[j].incoming_channel == captured_link->incoming_channel)
+            {
+                break;
+            }
+        }
+
+        if (j == capture->begin_count)
+        {
+            LogError("The ATTACH of link %s is on a channel with no BEGIN", captured_link->name);
+            result = __LINE__;
+        }
+        else
+        {
+            LINK_HANDLE link = link_create(replay->sessions[capture->begins[j].local_channel]->session, captured_link->name,
+                (captured_link->remote_role == role_sender) ? role_receiver : role_sender, captured_link->source, captured_link->target);
+            if (link == NULL)
+            {
+                LogError("Cannot create link");
+                result = __LINE__;
+            }
+            else if (open_replay_link(replay, link, captured_link->remote_role) != 0)
+            {
+                link_destroy(link);
+                result = __LINE__;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void destroy_replay(REPLAY* replay)
+{
+    size_t i;
+
+    for (i = 0; i < replay->link_count; i++)
+    {
+        if (replay->links[i].message_receiver != NULL)
+        {
+            messagereceiver_destroy(replay->links[i].message_receiver);
+        }
+        if (replay->links[i].message_sender != NULL)
+        {
+            messagesender_destroy(replay->links[i].message_sender);
+        }
+
+        link_destroy(replay->links[i].link);
+    }
+
+    free(replay->links);
+
+    for (i = 0; i < replay->session_count; i++)
+    {
+        if (replay->sessions[i]->session != NULL)
+        {
+            session_destroy(replay->sessions[i]->session);
+        }
+
+        free(replay->sessions[i]);
+    }
+
+    free(replay->sessions);
+
+    if (replay->connection != NULL)
+    {
+        connection_destroy(replay->connection);
+    }
+
+    if (replay->io != NULL)
+    {
+        xio_destroy(replay->io);
+    }
+}
+
+/* the connection set up (open, sessions, links) is timed with the replay, as it is part of the captured stream */
+static int replay_capture(const CAPTURE* capture, PERF_COUNTERS_HANDLE perf_counters, PERF_PHASE* phase, uint64_t* elapsed_us)
+{
+    int result;
+    REPLAY replay;
+
+    (void)memset(&replay, 0, sizeof(replay));
+
+    replay.io = xio_create(&replay_io_interface_description, NULL);
+    if (replay.io == NULL)
+    {
+        LogError("Cannot create the replay io");
+        result = __LINE__;
+    }
+    else if ((replay.connection = connection_create(replay.io, "replay", "replay", capture->is_listening_side ? on_new_session_endpoint : NULL, &replay)) == NULL)
+    {
+        LogError("Cannot create the connection");
+        result = __LINE__;
+    }
+    else if ((config.max_frame_size != 0) &&
+        (connection_set_max_frame_size(replay.connection, config.max_frame_size) != 0))
+    {
+        LogError("Cannot set the max frame size");
+        result = __LINE__;
+    }
+    else if ((!capture->is_listening_side) &&
+        (create_client_endpoints(&replay, capture) != 0))
+    {
+        result = __LINE__;
+    }
+    else if ((capture->is_listening_side ? connection_listen(replay.connection) : connection_open(replay.connection)) != 0)
+    {
+        LogError("Cannot open the connection");
+        result = __LINE__;
+    }
+    else
+    {
+        uint64_t start_us;
+        size_t i;
+
+        /* completes the open of the replay io, the connection then sends its header or OPEN */
+        connection_dowork(replay.connection);
+
+        perf_counters_phase_begin(perf_counters, phase);
+        start_us = get_time_us();
+
+        for (i = 0; i < capture->chunk_count; i++)
+        {
+            current_replay_io->on_bytes_received(current_replay_io->on_bytes_received_context, capture->chunks[i].bytes, capture->chunks[i].length);
+        }
+
+        *elapsed_us = get_time_us() - start_us;
+        perf_counters_phase_end(perf_counters, phase);
+
+        if (replay.has_failed)
+        {
+            LogError("The replay could not accept a session or link of the capture");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    destroy_replay(&replay);
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        result = -1;
+    }
+    else if (platform_init() != 0)
+    {
+        LogError("platform_init failed");
+        result = -1;
+    }
+    else
+    {
+        CAPTURE capture;
+
+        if (load_capture(&capture, config.capture_file_name) != 0)
+        {
+            result = -1;
+        }
+        else
+        {
+            PERF_COUNTERS_HANDLE perf_counters = NULL;
+            PERF_PHASE phase = { "replay" };
+            uint64_t total_elapsed_us = 0;
+            uint64_t min_elapsed_us = UINT64_MAX;
+            uint64_t start_cpu_us;
+            uint64_t cpu_us;
+            size_t i;
+
+            (void)printf("Capture: %s, %s side, %lu chunks, %llu bytes, %llu frames, %llu transfers\n",
+                config.capture_file_name, capture.is_listening_side ? "listening" : "connecting",
+                (unsigned long)capture.chunk_count, (unsigned long long)capture.byte_count,
+                (unsigned long long)capture.frame_count, (unsigned long long)capture.transfer_count);
+
+            if (config.use_counters)
+            {
+                perf_counters = perf_counters_create();
+                if (perf_counters == NULL)
+                {
+                    (void)printf("Hardware counters are not available, running without them\n");
+                }
+            }
+
+            result = 0;
+            start_cpu_us = get_cpu_time_us();
+
+            for (i = 0; i < config.iteration_count; i++)
+            {
+                uint64_t elapsed_us;
+
+                if (replay_capture(&capture, perf_counters, &phase, &elapsed_us) != 0)
+                {
+                    (void)printf("Replay %lu failed\n", (unsigned long)i);
+                    result = -1;
+                    break;
+                }
+
+                total_elapsed_us += elapsed_us;
+                if (elapsed_us < min_elapsed_us)
+                {
+                    min_elapsed_us = elapsed_us;
+                }
+            }
+
+            cpu_us = get_cpu_time_us() - start_cpu_us;
+
+            if (result == 0)
+            {
+                double elapsed_s = (total_elapsed_us == 0) ? 1e-6 : (double)total_elapsed_us / 1000000.0;
+                uint64_t total_frame_count = capture.frame_count * config.iteration_count;
+
+                (void)printf("Replays: %lu, mean %.1f us, min %llu us, CPU %llu us (set up and tear down included)\n",
+                    (unsigned long)config.iteration_count, (double)total_elapsed_us / (double)config.iteration_count,
+                    (unsigned long long)min_elapsed_us, (unsigned long long)cpu_us);
+                (void)printf("Received: %.1f MB/s, %.0f frames/s, %.0f messages/s (%llu messages per replay)\n",
+                    (double)(capture.byte_count * config.iteration_count) / elapsed_s / (1024.0 * 1024.0),
+                    (double)total_frame_count / elapsed_s,
+                    (double)total_messages_received / elapsed_s,
+                    (unsigned long long)(total_messages_received / config.iteration_count));
+                (void)printf("Sent back and dropped: %llu bytes per replay\n",
+                    (unsigned long long)(total_bytes_sent / config.iteration_count));
+
+                perf_counters_print_phases(perf_counters, "per frame", &phase, 1, total_frame_count);
+            }
+
+            perf_counters_destroy(perf_counters);
+        }
+
+        free_capture(&capture);
+        platform_deinit();
+    }
+
+    return result;
+}
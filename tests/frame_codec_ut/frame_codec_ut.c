@@ -32,7 +32,6 @@ static void my_gballoc_free(void* ptr)
 #define ENABLE_MOCKS
 
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_uamqp_c/amqpvalue.h"
 
 #undef ENABLE_MOCKS
@@ -40,18 +39,8 @@ static void my_gballoc_free(void* ptr)
 #include "azure_uamqp_c/frame_codec.h"
 
 #define TEST_DESCRIPTION_AMQP_VALUE        (AMQP_VALUE)0x4243
-#define TEST_LIST_HANDLE                (SINGLYLINKEDLIST_HANDLE)0x4246
-#define TEST_SUBSCRIPTION_ITEM            (void*)0x4247
 #define TEST_ERROR_CONTEXT                (void*)0x4248
-#define TEST_LIST_ITEM_HANDLE            (LIST_ITEM_HANDLE)0x4249
 
-typedef struct TEST_LIST_ITEM_TAG
-{
-    const void* item_value;
-} TEST_LIST_ITEM;
-
-static TEST_LIST_ITEM** list_items = NULL;
-static size_t list_item_count = 0;
 static unsigned char* sent_io_bytes;
 static size_t sent_io_byte_count;
 static char expected_stringified_io[8192];
@@ -83,6 +72,13 @@ MOCK_FUNCTION_WITH_CODE(, void, on_frame_received_2, void*, context, const unsig
 MOCK_FUNCTION_END();
 MOCK_FUNCTION_WITH_CODE(, void, test_frame_codec_decode_error, void*, context)
 MOCK_FUNCTION_END();
+static unsigned char test_pool_buffer[64];
+MOCK_FUNCTION_WITH_CODE(, unsigned char*, test_get_receive_buffer, void*, context, uint32_t, size)
+MOCK_FUNCTION_END(test_pool_buffer);
+MOCK_FUNCTION_WITH_CODE(, unsigned char*, test_grow_receive_buffer, void*, context, unsigned char*, buffer, uint32_t, size)
+MOCK_FUNCTION_END(buffer);
+MOCK_FUNCTION_WITH_CODE(, void, test_release_receive_buffer, void*, context, unsigned char*, buffer)
+MOCK_FUNCTION_END();
 
 MOCK_FUNCTION_WITH_CODE(, void, test_on_bytes_encoded, void*, context, const unsigned char*, bytes, size_t, length, bool, encode_complete)
     unsigned char* new_bytes = (unsigned char*)my_gballoc_realloc(sent_io_bytes, sent_io_byte_count + length);
@@ -94,73 +90,6 @@ MOCK_FUNCTION_WITH_CODE(, void, test_on_bytes_encoded, void*, context, const uns
     }
 MOCK_FUNCTION_END();
 
-static LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
-{
-    TEST_LIST_ITEM** items = (TEST_LIST_ITEM**)my_gballoc_realloc(list_items, (list_item_count + 1) * sizeof(TEST_LIST_ITEM*));
-    LIST_ITEM_HANDLE to_return = NULL;
-    (void)list;
-    if (items != NULL)
-    {
-        list_items = items;
-        list_items[list_item_count] = (TEST_LIST_ITEM*)my_gballoc_malloc(sizeof(TEST_LIST_ITEM));
-        if (list_items[list_item_count] != NULL)
-        {
-            list_items[list_item_count]->item_value = item;
-            to_return = (LIST_ITEM_HANDLE)list_items[list_item_count];
-            list_item_count++;
-        }
-    }
-    return to_return;
-}
-
-static const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
-{
-    return ((TEST_LIST_ITEM*)item_handle)->item_value;
-}
-
-static LIST_ITEM_HANDLE my_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE handle, LIST_MATCH_FUNCTION match_function, const void* match_context)
-{
-    size_t i;
-    LIST_ITEM_HANDLE found_item = NULL;
-    (void)handle;
-
-    for (i = 0; i < list_item_count; i++)
-    {
-        if (match_function((LIST_ITEM_HANDLE)list_items[i], match_context))
-        {
-            found_item = (LIST_ITEM_HANDLE)list_items[i];
-            break;
-        }
-    }
-    return found_item;
-}
-
-static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE list_item)
-{
-    size_t i;
-    (void)list;
-
-    for (i = 0; i < list_item_count; i++)
-    {
-        if (((LIST_ITEM_HANDLE)list_items[i]) == list_item)
-        {
-            break;
-        }
-    }
-    if (i < list_item_count)
-    {
-        my_gballoc_free(list_items[i]);
-        memmove(&list_items[i], &list_items[i + 1], (list_item_count - i - 1) * sizeof(TEST_LIST_ITEM*));
-        list_item_count--;
-        if (list_item_count == 0)
-        {
-            my_gballoc_free(list_items);
-            list_items = NULL;
-        }
-    }
-    return 0;
-}
-
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -193,15 +122,6 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
-    REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, TEST_LIST_HANDLE);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, my_singlylinkedlist_item_get_value);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, my_singlylinkedlist_find);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
-
-    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(LIST_MATCH_FUNCTION, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -224,19 +144,11 @@ TEST_FUNCTION_INITIALIZE(method_init)
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
 {
-    size_t i;
     if (sent_io_bytes != NULL)
     {
         free(sent_io_bytes);
         sent_io_bytes = NULL;
     }
-    for (i = 0; i < list_item_count; i++)
-    {
-        free(list_items[i]);
-    }
-    free(list_items);
-    list_items = NULL;
-    list_item_count = 0;
 
     sent_io_byte_count = 0;
 
@@ -251,7 +163,6 @@ TEST_FUNCTION(frame_codec_create_with_valid_args_succeeds)
     // arrange
     FRAME_CODEC_HANDLE frame_codec;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
     // act
     frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
@@ -283,7 +194,6 @@ TEST_FUNCTION(frame_codec_create_with_NULL_frame_codec_decode_error_calback_cont
     // arrange
     FRAME_CODEC_HANDLE frame_codec;
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
     // act
     frame_codec = frame_codec_create(test_frame_codec_decode_error, NULL);
@@ -337,7 +247,7 @@ TEST_FUNCTION(sending_a_frame_with_more_than_512_bytes_of_total_frame_size_fails
 
 /* Tests_SRS_FRAME_CODEC_01_082: [The initial max_frame_size_shall be 512.] */
 /* Tests_SRS_FRAME_CODEC_01_075: [frame_codec_set_max_frame_size shall set the maximum frame size for a frame_codec.] */
-/* Tests_SRS_FRAME_CODEC_01_088: [Encoded bytes shall be passed to the `on_bytes_encoded` callback in a single call, while setting the `encode complete` argument to true.] */
+/* Tests_SRS_FRAME_CODEC_01_088: [When no payload segment is passed as is, encoded bytes shall be passed to the `on_bytes_encoded` callback in a single call, while setting the `encode complete` argument to true.] */
 /* Tests_SRS_FRAME_CODEC_01_108: [ Memory shall be allocated to hold the entire frame. ]*/
 TEST_FUNCTION(a_frame_of_exactly_max_frame_size_immediately_after_create_can_be_sent)
 {
@@ -407,15 +317,9 @@ TEST_FUNCTION(receiving_a_frame_with_exactly_512_bytes_of_total_frame_size_immed
     umock_c_reset_all_calls();
     (void)memset(frame + 6, 0, 506);
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 504))
         .ValidateArgumentBuffer(2, &frame[6], 2)
         .ValidateArgumentBuffer(4, &frame[8], 504);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
@@ -438,7 +342,6 @@ TEST_FUNCTION(frame_codec_destroy_frees_the_memory_for_frame_codec)
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_LIST_HANDLE));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
@@ -471,7 +374,29 @@ TEST_FUNCTION(frame_codec_destroy_while_receiving_type_specific_data_frees_the_t
     (void)frame_codec_unsubscribe(frame_codec, 0);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_LIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    frame_codec_destroy(frame_codec);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_FRAME_CODEC_01_023: [frame_codec_destroy shall free all resources associated with a frame_codec instance.] */
+/* Tests_SRS_FRAME_CODEC_01_114: [The memory holding the frame bytes shall be kept by the frame_codec instance and reused for subsequent frames, it shall only be allocated again when a frame needs more bytes than were previously allocated.] */
+TEST_FUNCTION(frame_codec_destroy_after_a_frame_was_received_frees_the_receive_buffer)
+{
+    // arrange
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x00, 0x00 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame) - 1);
+    (void)frame_codec_receive_bytes(frame_codec, frame + sizeof(frame) - 1, 1);
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    umock_c_reset_all_calls();
+
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -591,15 +516,9 @@ TEST_FUNCTION(receiving_a_frame_with_exactly_max_frame_size_bytes_of_total_frame
     umock_c_reset_all_calls();
     (void)memset(frame + 6, 0, 1016);
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1016))
         .ValidateArgumentBuffer(2, &frame[6], 2)
         .ValidateArgumentBuffer(4, &frame[8], 1016);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
@@ -748,6 +667,419 @@ TEST_FUNCTION(setting_a_new_max_frame_while_the_frame_size_is_being_received_mak
     frame_codec_destroy(frame_codec);
 }
 
+/* frame_codec_set_receive_buffer_pool */
+
+/* Tests_SRS_FRAME_CODEC_01_117: [On success, frame_codec_set_receive_buffer_pool shall return 0.] */
+TEST_FUNCTION(frame_codec_set_receive_buffer_pool_with_valid_args_succeeds)
+{
+    // arrange
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_118: [If frame_codec is NULL or some but not all of get_receive_buffer, grow_receive_buffer and release_receive_buffer are NULL, frame_codec_set_receive_buffer_pool shall fail and return a non-zero value.] */
+TEST_FUNCTION(frame_codec_set_receive_buffer_pool_with_NULL_frame_codec_fails)
+{
+    // arrange
+
+    // act
+    int result = frame_codec_set_receive_buffer_pool(NULL, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_FRAME_CODEC_01_118: [If frame_codec is NULL or some but not all of get_receive_buffer, grow_receive_buffer and release_receive_buffer are NULL, frame_codec_set_receive_buffer_pool shall fail and return a non-zero value.] */
+TEST_FUNCTION(frame_codec_set_receive_buffer_pool_with_NULL_release_receive_buffer_fails)
+{
+    // arrange
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, NULL, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_118: [If frame_codec is NULL or some but not all of get_receive_buffer, grow_receive_buffer and release_receive_buffer are NULL, frame_codec_set_receive_buffer_pool shall fail and return a non-zero value.] */
+TEST_FUNCTION(frame_codec_set_receive_buffer_pool_with_NULL_grow_receive_buffer_fails)
+{
+    // arrange
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, NULL, test_release_receive_buffer, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_119: [If a frame is being decoded, frame_codec_set_receive_buffer_pool shall fail and return a non-zero value.] */
+TEST_FUNCTION(frame_codec_set_receive_buffer_pool_while_decoding_a_frame_fails)
+{
+    // arrange
+    int result;
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x00 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_115: [When a receive buffer pool is set, frame_codec_receive_bytes shall obtain the memory for each frame by calling get_receive_buffer with the pool_context and the number of bytes needed.] */
+/* Tests_SRS_FRAME_CODEC_01_116: [After on_frame_received returns, a buffer obtained from the receive buffer pool shall be given back by calling release_receive_buffer.] */
+TEST_FUNCTION(when_a_receive_buffer_pool_is_set_frame_codec_receive_bytes_uses_it_for_the_frame_bytes)
+{
+    // arrange
+    int result;
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x01, 0x02, 0x42 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_get_receive_buffer((void*)0x4242, 3));
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, test_pool_buffer, 2, test_pool_buffer + 2, 1))
+        .ValidateArgumentBuffer(2, &frame[6], 2)
+        .ValidateArgumentBuffer(4, &frame[8], 1);
+    STRICT_EXPECTED_CALL(test_release_receive_buffer((void*)0x4242, test_pool_buffer));
+
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame) - 1);
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame + sizeof(frame) - 1, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_132: [When a receive buffer pool is set, get_receive_buffer shall be asked for at most 4096 bytes, and the buffer shall be grown as the frame bytes arrive by calling grow_receive_buffer, by doubling its size without exceeding the frame size.] */
+TEST_FUNCTION(a_big_frame_header_alone_gets_at_most_4096_bytes_from_the_receive_buffer_pool)
+{
+    // arrange
+    int result;
+    unsigned char frame_header[] = { 0x00, 0x00, 0x27, 0x18, 0x02, 0x00, 0x01, 0x02 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_set_max_frame_size(frame_codec, 16384);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_get_receive_buffer((void*)0x4242, 4096));
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame_header, sizeof(frame_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_132: [When a receive buffer pool is set, get_receive_buffer shall be asked for at most 4096 bytes, and the buffer shall be grown as the frame bytes arrive by calling grow_receive_buffer, by doubling its size without exceeding the frame size.] */
+TEST_FUNCTION(the_receive_buffer_pool_buffer_grows_through_grow_receive_buffer_as_the_frame_body_arrives)
+{
+    // arrange
+    int result;
+    unsigned char frame_header[] = { 0x00, 0x00, 0x27, 0x18, 0x02, 0x00, 0x01, 0x02 };
+    unsigned char* pool_buffer = (unsigned char*)my_gballoc_malloc(10002);
+    unsigned char frame_body[10000];
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)memset(frame_body, 0x42, sizeof(frame_body));
+    (void)frame_codec_set_max_frame_size(frame_codec, 16384);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+    STRICT_EXPECTED_CALL(test_get_receive_buffer((void*)0x4242, 4096))
+        .SetReturn(pool_buffer);
+    (void)frame_codec_receive_bytes(frame_codec, frame_header, sizeof(frame_header));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_grow_receive_buffer((void*)0x4242, pool_buffer, 8192));
+    STRICT_EXPECTED_CALL(test_grow_receive_buffer((void*)0x4242, pool_buffer, 10002));
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, pool_buffer, 2, pool_buffer + 2, sizeof(frame_body)))
+        .ValidateArgumentBuffer(2, &frame_header[6], 2)
+        .ValidateArgumentBuffer(4, frame_body, sizeof(frame_body));
+    STRICT_EXPECTED_CALL(test_release_receive_buffer((void*)0x4242, pool_buffer));
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame_body, 5000);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = frame_codec_receive_bytes(frame_codec, frame_body + 5000, sizeof(frame_body) - 5000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+    my_gballoc_free(pool_buffer);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_129: [If growing the memory for a frame fails, frame_codec_receive_bytes shall fail and return a non-zero value.] */
+/* Tests_SRS_FRAME_CODEC_01_120: [If frame_codec_destroy is called while a buffer obtained from the receive buffer pool is held, the buffer shall be released by calling release_receive_buffer.] */
+TEST_FUNCTION(when_grow_receive_buffer_fails_frame_codec_receive_bytes_fails_and_the_pool_buffer_stays_held)
+{
+    // arrange
+    int result;
+    unsigned char frame_header[] = { 0x00, 0x00, 0x27, 0x18, 0x02, 0x00, 0x01, 0x02 };
+    unsigned char* pool_buffer = (unsigned char*)my_gballoc_malloc(4096);
+    unsigned char frame_body[5000];
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)memset(frame_body, 0x42, sizeof(frame_body));
+    (void)frame_codec_set_max_frame_size(frame_codec, 16384);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+    STRICT_EXPECTED_CALL(test_get_receive_buffer((void*)0x4242, 4096))
+        .SetReturn(pool_buffer);
+    (void)frame_codec_receive_bytes(frame_codec, frame_header, sizeof(frame_header));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_grow_receive_buffer((void*)0x4242, pool_buffer, 8192))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(test_frame_codec_decode_error(TEST_ERROR_CONTEXT));
+    STRICT_EXPECTED_CALL(test_release_receive_buffer((void*)0x4242, pool_buffer));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame_body, sizeof(frame_body));
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    my_gballoc_free(pool_buffer);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_122: [When a complete frame is contained in the bytes passed to frame_codec_receive_bytes, it shall be indicated to the upper layer without copying, by passing to on_frame_received pointers into the buffer argument.] */
+TEST_FUNCTION(a_complete_frame_is_indicated_with_pointers_into_the_received_bytes)
+{
+    // arrange
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x01, 0x02, 0x42 };
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, &frame[6], 2, &frame[8], 1));
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_101: [If the memory for the frame_body bytes cannot be allocated, frame_codec_receive_bytes shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_the_receive_buffer_pool_has_no_buffer_frame_codec_receive_bytes_fails)
+{
+    // arrange
+    int result;
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x01, 0x02, 0x42 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_get_receive_buffer((void*)0x4242, 3))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(test_frame_codec_decode_error(TEST_ERROR_CONTEXT));
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame) - 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_120: [If frame_codec_destroy is called while a buffer obtained from the receive buffer pool is held, the buffer shall be released by calling release_receive_buffer.] */
+TEST_FUNCTION(frame_codec_destroy_while_decoding_a_frame_releases_the_receive_buffer_pool_buffer)
+{
+    // arrange
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x00 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_release_receive_buffer((void*)0x4242, test_pool_buffer));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    frame_codec_destroy(frame_codec);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_FRAME_CODEC_01_121: [Passing NULL for get_receive_buffer, grow_receive_buffer and release_receive_buffer shall revert to the receive buffer kept by the frame_codec instance.] */
+TEST_FUNCTION(frame_codec_set_receive_buffer_pool_with_NULL_callbacks_reverts_to_the_internal_receive_buffer)
+{
+    // arrange
+    int result;
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x01, 0x02 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_set_receive_buffer_pool(frame_codec, test_get_receive_buffer, test_grow_receive_buffer, test_release_receive_buffer, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
+        .ValidateArgumentBuffer(2, &frame[6], 2);
+
+    // act
+    result = frame_codec_set_receive_buffer_pool(frame_codec, NULL, NULL, NULL, NULL);
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame) - 1);
+    (void)frame_codec_receive_bytes(frame_codec, frame + sizeof(frame) - 1, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* frame_codec_is_at_frame_boundary */
+
+/* Tests_SRS_FRAME_CODEC_01_130: [frame_codec_is_at_frame_boundary shall return true when no byte of a frame has been received since the last complete frame, and false otherwise, a frame_codec that had a decode error included.] */
+TEST_FUNCTION(frame_codec_is_at_frame_boundary_after_create_returns_true)
+{
+    // arrange
+    bool result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_codec_is_at_frame_boundary(frame_codec);
+
+    // assert
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_130: [frame_codec_is_at_frame_boundary shall return true when no byte of a frame has been received since the last complete frame, and false otherwise, a frame_codec that had a decode error included.] */
+TEST_FUNCTION(frame_codec_is_at_frame_boundary_with_part_of_a_frame_header_received_returns_false)
+{
+    // arrange
+    bool result;
+    unsigned char frame[] = { 0x00, 0x00 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_codec_is_at_frame_boundary(frame_codec);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_130: [frame_codec_is_at_frame_boundary shall return true when no byte of a frame has been received since the last complete frame, and false otherwise, a frame_codec that had a decode error included.] */
+TEST_FUNCTION(frame_codec_is_at_frame_boundary_after_a_complete_frame_returns_true)
+{
+    // arrange
+    bool result;
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x00, 0x00 };
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_codec_is_at_frame_boundary(frame_codec);
+
+    // assert
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_131: [If frame_codec is NULL, frame_codec_is_at_frame_boundary shall return false.] */
+TEST_FUNCTION(frame_codec_is_at_frame_boundary_with_NULL_frame_codec_returns_false)
+{
+    // arrange
+
+    // act
+    bool result = frame_codec_is_at_frame_boundary(NULL);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /* frame_codec_receive_bytes */
 
 /* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.] */
@@ -776,14 +1108,8 @@ TEST_FUNCTION(frame_codec_receive_bytes_decodes_one_empty_frame)
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
@@ -808,10 +1134,6 @@ TEST_FUNCTION(frame_codec_receive_bytes_with_not_enough_bytes_for_a_frame_does_n
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
@@ -895,14 +1217,9 @@ TEST_FUNCTION(when_frame_codec_receive_1_byte_in_one_call_and_the_rest_of_the_fr
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     (void)frame_codec_receive_bytes(frame_codec, frame, 1);
 
@@ -929,14 +1246,9 @@ TEST_FUNCTION(when_frame_codec_receive_the_frame_bytes_in_1_byte_per_call_a_succ
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     for (i = 0; i < sizeof(frame) - 1; i++)
     {
@@ -965,14 +1277,8 @@ TEST_FUNCTION(a_frame_codec_receive_bytes_call_with_bad_args_before_any_real_fra
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     (void)frame_codec_receive_bytes(frame_codec, NULL, 1);
 
@@ -998,14 +1304,9 @@ TEST_FUNCTION(a_frame_codec_receive_bytes_call_with_bad_args_in_the_middle_of_th
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     (void)frame_codec_receive_bytes(frame_codec, frame, 1);
     (void)frame_codec_receive_bytes(frame_codec, NULL, 1);
@@ -1023,6 +1324,7 @@ TEST_FUNCTION(a_frame_codec_receive_bytes_call_with_bad_args_in_the_middle_of_th
 }
 
 /* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.] */
+/* Tests_SRS_FRAME_CODEC_01_114: [The memory holding the frame bytes shall be kept by the frame_codec instance and reused for subsequent frames, it shall only be allocated again when a frame needs more bytes than were previously allocated.] */
 TEST_FUNCTION(frame_codec_receive_bytes_decodes_2_empty_frames)
 {
     // arrange
@@ -1033,22 +1335,10 @@ TEST_FUNCTION(frame_codec_receive_bytes_decodes_2_empty_frames)
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame1[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame1[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame2[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame2[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     (void)frame_codec_receive_bytes(frame_codec, frame1, sizeof(frame1));
 
@@ -1075,22 +1365,10 @@ TEST_FUNCTION(a_call_to_frame_codec_receive_bytes_with_bad_args_between_2_frames
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame1[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame1[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame2[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
         .ValidateArgumentBuffer(2, &frame2[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     (void)frame_codec_receive_bytes(frame_codec, frame1, sizeof(frame1));
     (void)frame_codec_receive_bytes(frame_codec, NULL, 1);
@@ -1107,33 +1385,6 @@ TEST_FUNCTION(a_call_to_frame_codec_receive_bytes_with_bad_args_between_2_frames
     frame_codec_destroy(frame_codec);
 }
 
-/* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.] */
-TEST_FUNCTION(when_getting_the_list_item_value_fails_no_callback_is_invoked)
-{
-    // arrange
-    int result;
-    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x01, 0x02 };
-    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-        .SetReturn(NULL);
-
-    // act
-    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
-
-    // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    (void)frame_codec_unsubscribe(frame_codec, 0);
-    frame_codec_destroy(frame_codec);
-}
-
 /* Tests_SRS_FRAME_CODEC_01_010: [The frame is malformed if the size is less than the size of the frame header (8 bytes).] */
 /* Tests_SRS_FRAME_CODEC_01_103: [Upon any decode error, if an error callback has been passed to frame_codec_create, then the error callback shall be called with the context argument being the frame_codec_error_callback_context argument passed to frame_codec_create.] */
 TEST_FUNCTION(when_frame_size_is_bad_frame_codec_receive_bytes_fails)
@@ -1237,7 +1488,7 @@ TEST_FUNCTION(after_a_frame_decode_error_occurs_due_to_bad_doff_size_a_subsequen
 /* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.] */
 /* Tests_SRS_FRAME_CODEC_01_031: [When a complete frame is successfully decoded it shall be indicated to the upper layer by invoking the on_frame_received passed to frame_codec_subscribe.] */
 /* Tests_SRS_FRAME_CODEC_01_099: [A pointer to the frame_body bytes shall also be passed to the on_frame_received.] */
-/* Tests_SRS_FRAME_CODEC_01_102: [frame_codec_receive_bytes shall allocate memory to hold the frame_body bytes.] */
+/* Tests_SRS_FRAME_CODEC_01_122: [When a complete frame is contained in the bytes passed to frame_codec_receive_bytes, it shall be indicated to the upper layer without copying, by passing to on_frame_received pointers into the buffer argument.] */
 TEST_FUNCTION(receiving_a_frame_with_1_byte_frame_body_succeeds)
 {
     // arrange
@@ -1247,15 +1498,9 @@ TEST_FUNCTION(receiving_a_frame_with_1_byte_frame_body_succeeds)
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(2, &frame[6], 2)
         .ValidateArgumentBuffer(4, &frame[8], 1);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
@@ -1280,17 +1525,13 @@ TEST_FUNCTION(when_allocating_type_specific_data_fails_frame_codec_receive_bytes
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .SetReturn(NULL);
 
     STRICT_EXPECTED_CALL(test_frame_codec_decode_error(TEST_ERROR_CONTEXT));
 
     // act
-    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame) - 1);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -1315,7 +1556,7 @@ TEST_FUNCTION(when_allocating_type_specific_data_fails_a_subsequent_decode_Call_
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .SetReturn(NULL);
 
-    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    (void)frame_codec_receive_bytes(frame_codec, frame, sizeof(frame) - 1);
     umock_c_reset_all_calls();
 
     // act
@@ -1340,18 +1581,102 @@ TEST_FUNCTION(a_frame_with_2_bytes_received_together_with_the_header_passes_the_
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 2))
         .ValidateArgumentBuffer(2, &frame[6], 2)
         .ValidateArgumentBuffer(4, &frame[sizeof(frame) - 2], 2);
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.]  */
+TEST_FUNCTION(two_empty_frames_received_in_the_same_call_yields_2_callbacks)
+{
+    // arrange
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x01, 0x02,
+        0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x03, 0x04 };
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
+        .ValidateArgumentBuffer(2, &frame[6], 2);
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
+        .ValidateArgumentBuffer(2, &frame[14], 2);
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.]  */
+TEST_FUNCTION(two_frames_with_1_byte_each_received_in_the_same_call_yields_2_callbacks)
+{
+    // arrange
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x01, 0x02, 0x42,
+        0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x03, 0x04, 0x43 };
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(2, &frame[6], 2)
+        .ValidateArgumentBuffer(4, &frame[8], 1);
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(2, &frame[15], 2)
+        .ValidateArgumentBuffer(4, &frame[17], 1);
+
+    // act
+    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0);
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_114: [The memory holding the frame bytes shall be kept by the frame_codec instance and reused for subsequent frames, it shall only be allocated again when a frame needs more bytes than were previously allocated.] */
+TEST_FUNCTION(a_frame_bigger_than_the_previous_ones_reallocates_the_receive_buffer)
+{
+    // arrange
+    int result;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    unsigned char frame1[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x01, 0x02 };
+    unsigned char frame2[] = { 0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x03, 0x04, 0x42 };
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame1, sizeof(frame1) - 1);
+    (void)frame_codec_receive_bytes(frame_codec, frame1 + sizeof(frame1) - 1, 1);
+    umock_c_reset_all_calls();
+
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(3));
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(2, &frame2[6], 2)
+        .ValidateArgumentBuffer(4, &frame2[8], 1);
 
     // act
-    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    (void)frame_codec_receive_bytes(frame_codec, frame2, sizeof(frame2) - 1);
+    result = frame_codec_receive_bytes(frame_codec, frame2 + sizeof(frame2) - 1, 1);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -1362,36 +1687,21 @@ TEST_FUNCTION(a_frame_with_2_bytes_received_together_with_the_header_passes_the_
     frame_codec_destroy(frame_codec);
 }
 
-/* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.]  */
-TEST_FUNCTION(two_empty_frames_received_in_the_same_call_yields_2_callbacks)
+/* Tests_SRS_FRAME_CODEC_01_128: [Memory for a frame shall not be allocated for more than 4096 bytes before the frame bytes are received, it shall be grown as they arrive, by doubling its size without exceeding the frame size.] */
+TEST_FUNCTION(a_big_frame_header_alone_does_not_allocate_the_whole_frame)
 {
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x01, 0x02,
-        0x00, 0x00, 0x00, 0x08, 0x02, 0x00, 0x03, 0x04 };
+    unsigned char frame_header[] = { 0x00, 0x00, 0x27, 0x18, 0x02, 0x00, 0x01, 0x02 };
+    (void)frame_codec_set_max_frame_size(frame_codec, 16384);
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
-        .ValidateArgumentBuffer(2, &frame[6], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 0))
-        .ValidateArgumentBuffer(2, &frame[14], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(4096));
 
     // act
-    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    result = frame_codec_receive_bytes(frame_codec, frame_header, sizeof(frame_header));
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -1402,38 +1712,24 @@ TEST_FUNCTION(two_empty_frames_received_in_the_same_call_yields_2_callbacks)
     frame_codec_destroy(frame_codec);
 }
 
-/* Tests_SRS_FRAME_CODEC_01_025: [frame_codec_receive_bytes decodes a sequence of bytes into frames and on success it shall return zero.]  */
-TEST_FUNCTION(two_frames_with_1_byte_each_received_in_the_same_call_yields_2_callbacks)
+/* Tests_SRS_FRAME_CODEC_01_128: [Memory for a frame shall not be allocated for more than 4096 bytes before the frame bytes are received, it shall be grown as they arrive, by doubling its size without exceeding the frame size.] */
+TEST_FUNCTION(the_receive_buffer_grows_by_doubling_as_the_frame_body_arrives)
 {
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    unsigned char frame[] = { 0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x01, 0x02, 0x42,
-        0x00, 0x00, 0x00, 0x09, 0x02, 0x00, 0x03, 0x04, 0x43 };
+    unsigned char frame_header[] = { 0x00, 0x00, 0x27, 0x18, 0x02, 0x00, 0x01, 0x02 };
+    unsigned char frame_body[10000];
+    (void)memset(frame_body, 0x42, sizeof(frame_body));
+    (void)frame_codec_set_max_frame_size(frame_codec, 16384);
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame_header, sizeof(frame_header));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1))
-        .ValidateArgumentBuffer(2, &frame[6], 2)
-        .ValidateArgumentBuffer(4, &frame[8], 1);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1))
-        .ValidateArgumentBuffer(2, &frame[15], 2)
-        .ValidateArgumentBuffer(4, &frame[17], 1);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 8192));
 
     // act
-    result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
+    result = frame_codec_receive_bytes(frame_codec, frame_body, 5000);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -1444,25 +1740,27 @@ TEST_FUNCTION(two_frames_with_1_byte_each_received_in_the_same_call_yields_2_cal
     frame_codec_destroy(frame_codec);
 }
 
-/* frame_codec_subscribe */
-
-/* Tests_SRS_FRAME_CODEC_01_033: [frame_codec_subscribe subscribes for a certain type of frame received by the frame_codec instance identified by frame_codec.] */
-/* Tests_SRS_FRAME_CODEC_01_087: [On success, frame_codec_subscribe shall return zero.] */
-TEST_FUNCTION(frame_codec_subscribe_with_valid_args_succeeds)
+/* Tests_SRS_FRAME_CODEC_01_128: [Memory for a frame shall not be allocated for more than 4096 bytes before the frame bytes are received, it shall be grown as they arrive, by doubling its size without exceeding the frame size.] */
+TEST_FUNCTION(the_receive_buffer_does_not_grow_past_the_frame_size)
 {
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
+    unsigned char frame_header[] = { 0x00, 0x00, 0x27, 0x18, 0x02, 0x00, 0x01, 0x02 };
+    unsigned char frame_body[10000];
+    (void)memset(frame_body, 0x42, sizeof(frame_body));
+    (void)frame_codec_set_max_frame_size(frame_codec, 16384);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame_header, sizeof(frame_header));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_LIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 10002));
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, sizeof(frame_body)))
+        .ValidateArgumentBuffer(2, &frame_header[6], 2)
+        .ValidateArgumentBuffer(4, frame_body, sizeof(frame_body));
 
     // act
-    result = frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    result = frame_codec_receive_bytes(frame_codec, frame_body, sizeof(frame_body));
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -1473,27 +1771,30 @@ TEST_FUNCTION(frame_codec_subscribe_with_valid_args_succeeds)
     frame_codec_destroy(frame_codec);
 }
 
-/* Tests_SRS_FRAME_CODEC_01_033: [frame_codec_subscribe subscribes for a certain type of frame received by the frame_codec instance identified by frame_codec.] */
-/* Tests_SRS_FRAME_CODEC_01_087: [On success, frame_codec_subscribe shall return zero.] */
-TEST_FUNCTION(when_list_find_returns_NULL_a_new_subscription_is_created)
+/* Tests_SRS_FRAME_CODEC_01_129: [If growing the memory for a frame fails, frame_codec_receive_bytes shall fail and return a non-zero value.] */
+/* Tests_SRS_FRAME_CODEC_01_103: [Upon any decode error, if an error callback has been passed to frame_codec_create, then the error callback shall be called with the context argument being the frame_codec_error_callback_context argument passed to frame_codec_create.] */
+TEST_FUNCTION(when_growing_the_receive_buffer_fails_frame_codec_receive_bytes_fails)
 {
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
+    unsigned char frame_header[] = { 0x00, 0x00, 0x27, 0x18, 0x02, 0x00, 0x01, 0x02 };
+    unsigned char frame_body[5000];
+    (void)memset(frame_body, 0x42, sizeof(frame_body));
+    (void)frame_codec_set_max_frame_size(frame_codec, 16384);
+    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    (void)frame_codec_receive_bytes(frame_codec, frame_header, sizeof(frame_header));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1)
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 8192))
         .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_LIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_frame_codec_decode_error(TEST_ERROR_CONTEXT));
 
     // act
-    result = frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
+    result = frame_codec_receive_bytes(frame_codec, frame_body, sizeof(frame_body));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
@@ -1501,27 +1802,23 @@ TEST_FUNCTION(when_list_find_returns_NULL_a_new_subscription_is_created)
     frame_codec_destroy(frame_codec);
 }
 
-/* Tests_SRS_FRAME_CODEC_01_037: [If any failure occurs while performing the subscribe operation, frame_codec_subscribe shall return a non-zero value.] */
-TEST_FUNCTION(when_list_item_get_value_returns_NULL_subscribe_fails)
+/* frame_codec_subscribe */
+
+/* Tests_SRS_FRAME_CODEC_01_033: [frame_codec_subscribe subscribes for a certain type of frame received by the frame_codec instance identified by frame_codec.] */
+/* Tests_SRS_FRAME_CODEC_01_087: [On success, frame_codec_subscribe shall return zero.] */
+/* Tests_SRS_FRAME_CODEC_01_123: [Subscriptions shall be kept in a table indexed by frame type, so that subscribing, unsubscribing and finding the subscription for a received frame do not depend on the number of subscriptions.] */
+TEST_FUNCTION(frame_codec_subscribe_with_valid_args_succeeds)
 {
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
-    (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
-        .SetReturn(NULL);
-
     // act
     result = frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
@@ -1570,10 +1867,6 @@ TEST_FUNCTION(when_a_frame_type_that_has_no_subscribers_is_received_no_callback_
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
 
@@ -1586,6 +1879,38 @@ TEST_FUNCTION(when_a_frame_type_that_has_no_subscribers_is_received_no_callback_
     frame_codec_destroy(frame_codec);
 }
 
+/* Tests_SRS_FRAME_CODEC_01_029: [The sequence of bytes does not have to be a complete frame, frame_codec shall be responsible for maintaining decoding state between frame_codec_receive_bytes calls.] */
+TEST_FUNCTION(a_frame_without_subscribers_received_1_byte_at_a_time_does_not_affect_decoding_the_next_frame)
+{
+    // arrange
+    int result = 0;
+    size_t i;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    unsigned char frame1[] = { 0x00, 0x00, 0x00, 0x0A, 0x02, 0x01, 0x01, 0x02, 0x42, 0x43 };
+    unsigned char frame2[] = { 0x00, 0x00, 0x00, 0x09, 0x02, 0xFF, 0x01, 0x02, 0x42 };
+    (void)frame_codec_subscribe(frame_codec, 0xFF, on_frame_received_1, frame_codec);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(2, &frame2[6], 2)
+        .ValidateArgumentBuffer(4, &frame2[8], 1);
+
+    // act
+    for (i = 0; i < sizeof(frame1); i++)
+    {
+        result |= frame_codec_receive_bytes(frame_codec, &frame1[i], 1);
+    }
+    result |= frame_codec_receive_bytes(frame_codec, frame2, sizeof(frame2));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    (void)frame_codec_unsubscribe(frame_codec, 0xFF);
+    frame_codec_destroy(frame_codec);
+}
+
 /* Tests_SRS_FRAME_CODEC_01_035: [After successfully registering a callback for a certain frame type, when subsequently that frame type is received the callbacks shall be invoked, passing to it the received frame and the callback_context value.] */
 TEST_FUNCTION(when_no_subscribe_is_done_no_callback_is_called)
 {
@@ -1595,9 +1920,6 @@ TEST_FUNCTION(when_no_subscribe_is_done_no_callback_is_called)
     unsigned char frame[] = { 0x00, 0x00, 0x00, 0x08, 0x02, 0x01, 0x00, 0x00 };
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
 
@@ -1620,15 +1942,9 @@ TEST_FUNCTION(when_2_subscriptions_exist_and_first_one_matches_the_callback_is_i
     (void)frame_codec_subscribe(frame_codec, 1, on_frame_received_2, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_1(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 2))
         .ValidateArgumentBuffer(2, &frame[6], 2)
         .ValidateArgumentBuffer(4, &frame[sizeof(frame) - 2], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
@@ -1654,16 +1970,9 @@ TEST_FUNCTION(when_2_subscriptions_exist_and_second_one_matches_the_callback_is_
     (void)frame_codec_subscribe(frame_codec, 1, on_frame_received_2, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_2(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 2))
         .ValidateArgumentBuffer(2, &frame[6], 2)
         .ValidateArgumentBuffer(4, &frame[sizeof(frame) - 2], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
@@ -1684,15 +1993,9 @@ TEST_FUNCTION(when_frame_codec_subscribe_is_called_twice_for_the_same_frame_type
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-
     // act
     result = frame_codec_subscribe(frame_codec, 0, on_frame_received_2, frame_codec);
 
@@ -1716,15 +2019,9 @@ TEST_FUNCTION(the_callbacks_for_the_2nd_frame_codec_subscribe_for_the_same_frame
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_2, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(on_frame_received_2(frame_codec, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, 2))
         .ValidateArgumentBuffer(2, &frame[6], 2)
         .ValidateArgumentBuffer(4, &frame[sizeof(frame) - 2], 2);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
@@ -1738,58 +2035,6 @@ TEST_FUNCTION(the_callbacks_for_the_2nd_frame_codec_subscribe_for_the_same_frame
     frame_codec_destroy(frame_codec);
 }
 
-/* Tests_SRS_FRAME_CODEC_01_037: [If any failure occurs while performing the subscribe operation, frame_codec_subscribe shall return a non-zero value.] */
-TEST_FUNCTION(when_allocating_memory_for_the_subscription_fails_frame_codec_subscribe_fails)
-{
-    // arrange
-    int result;
-    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-
-    // act
-    result = frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
-
-    // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    frame_codec_destroy(frame_codec);
-}
-
-/* Tests_SRS_FRAME_CODEC_01_037: [If any failure occurs while performing the subscribe operation, frame_codec_subscribe shall return a non-zero value.] */
-TEST_FUNCTION(when_adding_the_subscription_fails_then_frame_codec_subscribe_fails)
-{
-    // arrange
-    int result;
-    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_LIST_HANDLE, IGNORED_PTR_ARG))
-        .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-    // act
-    result = frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
-
-    // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    frame_codec_destroy(frame_codec);
-}
-
 /* frame_codec_unsubscribe */
 
 /* Tests_SRS_FRAME_CODEC_01_038: [frame_codec_unsubscribe removes a previous subscription for frames of type type and on success it shall return 0.] */
@@ -1798,17 +2043,9 @@ TEST_FUNCTION(removing_an_existing_subscription_succeeds)
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_LIST_HANDLE, IGNORED_PTR_ARG));
-
     // act
     result = frame_codec_unsubscribe(frame_codec, 0);
 
@@ -1831,9 +2068,6 @@ TEST_FUNCTION(removing_an_existing_subscription_does_not_trigger_callback_when_a
     (void)frame_codec_unsubscribe(frame_codec, 0);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame[5], 1);
-
     // act
     result = frame_codec_receive_bytes(frame_codec, frame, sizeof(frame));
 
@@ -1864,36 +2098,8 @@ TEST_FUNCTION(frame_codec_unsubscribe_with_no_subscribe_call_has_been_made_fails
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-
-    // act
-    result = frame_codec_unsubscribe(frame_codec, 0);
-
-    // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    frame_codec_destroy(frame_codec);
-}
-
-/* Tests_SRS_FRAME_CODEC_01_041: [If any failure occurs while performing the unsubscribe operation, frame_codec_unsubscribe shall return a non-zero value.] */
-TEST_FUNCTION(when_list_remove_matching_item_fails_then_frame_codec_unsubscribe_fails)
-{
-    // arrange
-    int result;
-    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1)
-        .SetReturn(NULL);
-
     // act
     result = frame_codec_unsubscribe(frame_codec, 0);
 
@@ -1911,18 +2117,10 @@ TEST_FUNCTION(unsubscribe_one_of_2_subscriptions_succeeds)
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     (void)frame_codec_subscribe(frame_codec, 1, on_frame_received_2, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_LIST_HANDLE, IGNORED_PTR_ARG));
-
     // act
     result = frame_codec_unsubscribe(frame_codec, 0);
 
@@ -1941,19 +2139,10 @@ TEST_FUNCTION(unsubscribe_2nd_out_of_2_subscriptions_succeeds)
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 1;
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     (void)frame_codec_subscribe(frame_codec, 1, on_frame_received_2, frame_codec);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_LIST_HANDLE, IGNORED_PTR_ARG));
-
     // act
     result = frame_codec_unsubscribe(frame_codec, 1);
 
@@ -1972,16 +2161,10 @@ TEST_FUNCTION(subscribe_unsubscribe_subscribe_succeeds)
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     (void)frame_codec_unsubscribe(frame_codec, 0);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_LIST_HANDLE, IGNORED_PTR_ARG));
-
     // act
     result = frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
 
@@ -2000,14 +2183,10 @@ TEST_FUNCTION(subscribe_unsubscribe_unsubscribe_fails)
     // arrange
     int result;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
-    uint8_t frame_type = 0;
     (void)frame_codec_subscribe(frame_codec, 0, on_frame_received_1, frame_codec);
     (void)frame_codec_unsubscribe(frame_codec, 0);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_LIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(3, &frame_type, 1);
-
     // act
     result = frame_codec_unsubscribe(frame_codec, 0);
 
@@ -2057,7 +2236,7 @@ TEST_FUNCTION(frame_type_sasl_is_one)
 
 /* Tests_SRS_FRAME_CODEC_01_042: [frame_codec_encode_frame encodes the header, type specific bytes and frame payload of a frame that has frame_payload_size bytes.]*/
 /* Tests_SRS_FRAME_CODEC_01_043: [On success it shall return 0.] */
-/* Tests_SRS_FRAME_CODEC_01_088: [Encoded bytes shall be passed to the `on_bytes_encoded` callback in a single call, while setting the `encode complete` argument to true.] */
+/* Tests_SRS_FRAME_CODEC_01_088: [When no payload segment is passed as is, encoded bytes shall be passed to the `on_bytes_encoded` callback in a single call, while setting the `encode complete` argument to true.] */
 /* Tests_SRS_FRAME_CODEC_01_055: [Frames are divided into three distinct areas: a fixed width frame header, a variable width extended header, and a variable width frame body.] */
 /* Tests_SRS_FRAME_CODEC_01_056: [frame header The frame header is a fixed size (8 byte) structure that precedes each frame.] */
 /* Tests_SRS_FRAME_CODEC_01_057: [The frame header includes mandatory information necessary to parse the rest of the frame including size and type information.] */
@@ -2074,9 +2253,7 @@ TEST_FUNCTION(frame_codec_encode_frame_with_a_zero_frame_body_length_succeeds)
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0, NULL, 0, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
@@ -2215,9 +2392,7 @@ TEST_FUNCTION(one_byte_of_padding_is_added_to_type_specific_data_to_make_the_fra
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0, NULL, 0, &expected_frame[6], 1, test_on_bytes_encoded, (void*)0x4242);
@@ -2246,9 +2421,7 @@ TEST_FUNCTION(no_bytes_of_padding_are_added_to_type_specific_data_when_enough_by
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0, NULL, 0, &expected_frame[6], 2, test_on_bytes_encoded, (void*)0x4242);
@@ -2272,9 +2445,7 @@ TEST_FUNCTION(the_type_is_placed_in_the_underlying_frame)
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0x42, NULL, 0, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
@@ -2303,9 +2474,7 @@ TEST_FUNCTION(frame_codec_encode_frame_bytes_with_1_encoded_byte_succeeds)
     payloads[0].bytes = &byte;
     payloads[0].length = 1;
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0x42, payloads, 1, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
@@ -2333,9 +2502,7 @@ TEST_FUNCTION(frame_codec_encode_frame_bytes_with_2_bytes_succeeds)
     payloads[0].length = sizeof(bytes);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0x42, payloads, 1, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
@@ -2408,9 +2575,7 @@ TEST_FUNCTION(sending_only_1_byte_out_of_2_frame_body_bytes_succeeds)
     payloads[1].length = 1;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0x42, payloads, 2, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
@@ -2439,9 +2604,7 @@ TEST_FUNCTION(a_send_after_send_succeeds)
     (void)frame_codec_encode_frame(frame_codec, 0x42, payloads, 1, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = frame_codec_encode_frame(frame_codec, 0x42, payloads, 1, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
@@ -2456,19 +2619,94 @@ TEST_FUNCTION(a_send_after_send_succeeds)
     frame_codec_destroy(frame_codec);
 }
 
+/* Tests_SRS_FRAME_CODEC_01_112: [ A payload segment of at least 4096 bytes shall not be copied: the bytes encoded before it and the segment itself shall each be passed to `on_bytes_encoded`, in order. ]*/
+/* Tests_SRS_FRAME_CODEC_01_113: [ Only the last call to `on_bytes_encoded` for a frame shall set the `encode complete` argument to true. ]*/
+TEST_FUNCTION(a_payload_segment_of_4096_bytes_is_passed_as_is_to_on_bytes_encoded)
+{
+    // arrange
+    int result;
+    unsigned char small_bytes[] = { 0x42, 0x43 };
+    unsigned char* big_bytes = (unsigned char*)my_gballoc_malloc(4096);
+    unsigned char expected_header[] = { 0x00, 0x00, 0x10, 0x0C, 0x02, 0x42, 0x00, 0x00, 0x42, 0x43 };
+    PAYLOAD payloads[3];
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_set_max_frame_size(frame_codec, 8192);
+    (void)memset(big_bytes, 0x44, 4096);
+    payloads[0].bytes = small_bytes;
+    payloads[0].length = sizeof(small_bytes);
+    payloads[1].bytes = big_bytes;
+    payloads[1].length = 4096;
+    payloads[2].bytes = small_bytes;
+    payloads[2].length = sizeof(small_bytes);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, 10, false));
+    STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, big_bytes, 4096, false));
+    STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, 2, true));
+
+    // act
+    result = frame_codec_encode_frame(frame_codec, 0x42, payloads, 3, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 4108, sent_io_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_io_bytes, expected_header, sizeof(expected_header)));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_io_bytes + sizeof(expected_header), big_bytes, 4096));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_io_bytes + sizeof(expected_header) + 4096, small_bytes, sizeof(small_bytes)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+    my_gballoc_free(big_bytes);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_113: [ Only the last call to `on_bytes_encoded` for a frame shall set the `encode complete` argument to true. ]*/
+TEST_FUNCTION(when_the_last_payload_segment_is_passed_as_is_encode_complete_is_set_on_it)
+{
+    // arrange
+    int result;
+    unsigned char* big_bytes = (unsigned char*)my_gballoc_malloc(4096);
+    PAYLOAD payloads[1];
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    (void)frame_codec_set_max_frame_size(frame_codec, 8192);
+    (void)memset(big_bytes, 0x44, 4096);
+    payloads[0].bytes = big_bytes;
+    payloads[0].length = 4096;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, 8, false));
+    STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, big_bytes, 4096, true));
+
+    // act
+    result = frame_codec_encode_frame(frame_codec, 0x42, payloads, 1, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 4104, sent_io_byte_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+    my_gballoc_free(big_bytes);
+}
+
 /* Tests_SRS_FRAME_CODEC_01_109: [ If allocating memory fails, `frame_codec_encode_frame` shall fail and return a non-zero value. ]*/
 TEST_FUNCTION(when_allocating_memory_for_the_encoded_frame_fails_frame_codec_encode_frame_fails)
 {
     // arrange
     int result;
+    unsigned char bytes[257] = { 0 };
+    PAYLOAD payload;
     FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    payload.bytes = bytes;
+    payload.length = sizeof(bytes);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .SetReturn(NULL);
 
     // act
-    result = frame_codec_encode_frame(frame_codec, 0, NULL, 0, NULL, 0, test_on_bytes_encoded, NULL);
+    result = frame_codec_encode_frame(frame_codec, 0, &payload, 1, NULL, 0, test_on_bytes_encoded, NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -2478,6 +2716,58 @@ TEST_FUNCTION(when_allocating_memory_for_the_encoded_frame_fails_frame_codec_enc
     frame_codec_destroy(frame_codec);
 }
 
+/* Tests_SRS_FRAME_CODEC_01_124: [ When the bytes to be copied for a frame are not more than 256, no memory shall be allocated to encode the frame. ]*/
+TEST_FUNCTION(a_frame_with_256_bytes_to_copy_is_encoded_without_allocating_memory)
+{
+    // arrange
+    int result;
+    unsigned char bytes[248] = { 0 };
+    PAYLOAD payload;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    payload.bytes = bytes;
+    payload.length = sizeof(bytes);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, 256, true));
+
+    // act
+    result = frame_codec_encode_frame(frame_codec, 0, &payload, 1, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+}
+
+/* Tests_SRS_FRAME_CODEC_01_108: [ Memory shall be allocated to hold the frame, except for the payload segments that are passed as they are to `on_bytes_encoded`. ]*/
+TEST_FUNCTION(a_frame_with_257_bytes_to_copy_is_encoded_in_allocated_memory)
+{
+    // arrange
+    int result;
+    unsigned char bytes[249] = { 0 };
+    PAYLOAD payload;
+    FRAME_CODEC_HANDLE frame_codec = frame_codec_create(test_frame_codec_decode_error, TEST_ERROR_CONTEXT);
+    payload.bytes = bytes;
+    payload.length = sizeof(bytes);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(257));
+    STRICT_EXPECTED_CALL(test_on_bytes_encoded((void*)0x4242, IGNORED_PTR_ARG, 257, true));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = frame_codec_encode_frame(frame_codec, 0, &payload, 1, NULL, 0, test_on_bytes_encoded, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_codec_destroy(frame_codec);
+}
+
 /* Tests_SRS_FRAME_CODEC_01_107: [If the argument `payloads` is NULL and `payload_count` is non-zero, `frame_codec_encode_frame` shall return a non-zero value.]*/
 TEST_FUNCTION(frame_codec_encode_frame_with_NULL_payloads_and_non_zero_payload_count_fails)
 {
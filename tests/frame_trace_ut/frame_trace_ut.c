@@ -0,0 +1,927 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_uamqp_c/amqpvalue.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/frame_trace.h"
+
+#define TEST_PERFORMATIVE (AMQP_VALUE)0x4242
+
+static const unsigned char test_performative_bytes[] = { 0x00, 0x53, 0x14, 0xC0, 0x02, 0x01, 0x43 };
+static size_t test_encoded_repeat_count;
+
+static int my_amqpvalue_encode(AMQP_VALUE value, AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context)
+{
+    size_t i;
+    (void)value;
+
+    for (i = 0; i < test_encoded_repeat_count; i++)
+    {
+        (void)encoder_output(context, test_performative_bytes, sizeof(test_performative_bytes));
+    }
+
+    return 0;
+}
+
+/* saved traces are collected in this buffer */
+static unsigned char saved_bytes[4096];
+static size_t saved_size;
+static int output_result;
+
+static int test_output(void* context, const unsigned char* bytes, size_t length)
+{
+    (void)context;
+
+    if ((output_result == 0) &&
+        (saved_size + length <= sizeof(saved_bytes)))
+    {
+        (void)memcpy(saved_bytes + saved_size, bytes, length);
+        saved_size += length;
+    }
+
+    return output_result;
+}
+
+#define MAX_PARSED_RECORDS 8
+
+static FRAME_TRACE_RECORD parsed_records[MAX_PARSED_RECORDS];
+static size_t parsed_record_count;
+
+static void test_on_record(void* context, const FRAME_TRACE_RECORD* record)
+{
+    (void)context;
+
+    if (parsed_record_count < MAX_PARSED_RECORDS)
+    {
+        parsed_records[parsed_record_count] = *record;
+    }
+
+    parsed_record_count++;
+}
+
+#define MAX_PARSED_CHUNKS 8
+
+static size_t parsed_chunk_lengths[MAX_PARSED_CHUNKS];
+static uint64_t parsed_chunk_timestamps[MAX_PARSED_CHUNKS];
+static size_t parsed_chunk_count;
+
+static void test_on_chunk(void* context, uint64_t timestamp_ms, const unsigned char* bytes, size_t length)
+{
+    (void)context;
+    (void)bytes;
+
+    if (parsed_chunk_count < MAX_PARSED_CHUNKS)
+    {
+        parsed_chunk_timestamps[parsed_chunk_count] = timestamp_ms;
+        parsed_chunk_lengths[parsed_chunk_count] = length;
+    }
+
+    parsed_chunk_count++;
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(frame_trace_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_encode, my_amqpvalue_encode);
+
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_VALUE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQPVALUE_ENCODER_OUTPUT, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_function_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    test_encoded_repeat_count = 1;
+    saved_size = 0;
+    output_result = 0;
+    parsed_record_count = 0;
+    parsed_chunk_count = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_function_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* frame_trace_create */
+
+/* Tests_SRS_FRAME_TRACE_01_001: [ `frame_trace_create` shall create an empty frame trace holding at most `record_count` records, allocating all of them at once, and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(frame_trace_create_succeeds)
+{
+    // arrange
+    FRAME_TRACE_HANDLE result;
+    size_t record_count;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = frame_trace_create(4);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_get_record_count(result, &record_count));
+    ASSERT_ARE_EQUAL(size_t, 0, record_count);
+
+    // cleanup
+    frame_trace_destroy(result);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_002: [ If `record_count` is 0, `frame_trace_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(frame_trace_create_with_0_record_count_fails)
+{
+    // arrange
+    FRAME_TRACE_HANDLE result;
+
+    // act
+    result = frame_trace_create(0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_FRAME_TRACE_01_003: [ If allocating memory for the frame trace fails, `frame_trace_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_frame_trace_fails_frame_trace_create_fails)
+{
+    // arrange
+    FRAME_TRACE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = frame_trace_create(4);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_FRAME_TRACE_01_003: [ If allocating memory for the frame trace fails, `frame_trace_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_records_fails_frame_trace_create_fails)
+{
+    // arrange
+    FRAME_TRACE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = frame_trace_create(4);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* frame_trace_destroy */
+
+/* Tests_SRS_FRAME_TRACE_01_004: [ `frame_trace_destroy` shall free all resources associated with the frame trace. ]*/
+TEST_FUNCTION(frame_trace_destroy_frees_the_records_and_the_trace)
+{
+    // arrange
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    frame_trace_destroy(frame_trace);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_FRAME_TRACE_01_005: [ If `frame_trace` is NULL, `frame_trace_destroy` shall do nothing. ]*/
+TEST_FUNCTION(frame_trace_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    frame_trace_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* frame_trace_record_bytes */
+
+/* Tests_SRS_FRAME_TRACE_01_006: [ `frame_trace_record_bytes` shall add a record with `direction`, `frame_type`, `channel`, `timestamp_ms`, `payload_size`, the performative size and a copy of at most FRAME_TRACE_MAX_PERFORMATIVE_SIZE bytes of `performative_bytes`, and return 0. ]*/
+/* Tests_SRS_FRAME_TRACE_01_016: [ `frame_trace_save` shall pass to `output` the trace magic followed by each record, from the oldest to the newest, and return 0. ]*/
+/* Tests_SRS_FRAME_TRACE_01_019: [ `frame_trace_parse` shall call `on_record` with `on_record_context` for each record saved by `frame_trace_save`, in the saved order, and return 0. ]*/
+TEST_FUNCTION(frame_trace_record_bytes_records_the_frame)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, 3, 0x100000002, test_performative_bytes, sizeof(test_performative_bytes), 1000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_save(frame_trace, test_output, NULL));
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_parse(saved_bytes, saved_size, test_on_record, NULL));
+    ASSERT_ARE_EQUAL(size_t, 1, parsed_record_count);
+    ASSERT_IS_TRUE(parsed_records[0].timestamp_ms == 0x100000002);
+    ASSERT_ARE_EQUAL(int, (int)FRAME_TRACE_DIRECTION_OUTGOING, (int)parsed_records[0].direction);
+    ASSERT_ARE_EQUAL(int, (int)FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, (int)parsed_records[0].frame_type);
+    ASSERT_ARE_EQUAL(int, 3, (int)parsed_records[0].channel);
+    ASSERT_ARE_EQUAL(uint32_t, sizeof(test_performative_bytes), parsed_records[0].performative_size);
+    ASSERT_ARE_EQUAL(uint32_t, sizeof(test_performative_bytes), parsed_records[0].captured_size);
+    ASSERT_ARE_EQUAL(uint32_t, 1000, parsed_records[0].payload_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(parsed_records[0].performative_bytes, test_performative_bytes, sizeof(test_performative_bytes)));
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_006: [ `frame_trace_record_bytes` shall add a record with `direction`, `frame_type`, `channel`, `timestamp_ms`, `payload_size`, the performative size and a copy of at most FRAME_TRACE_MAX_PERFORMATIVE_SIZE bytes of `performative_bytes`, and return 0. ]*/
+TEST_FUNCTION(frame_trace_record_bytes_truncates_long_performatives)
+{
+    // arrange
+    int result;
+    unsigned char long_performative[FRAME_TRACE_MAX_PERFORMATIVE_SIZE + 10];
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)memset(long_performative, 0x42, sizeof(long_performative));
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_INCOMING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, 0, 1, long_performative, sizeof(long_performative), 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_save(frame_trace, test_output, NULL));
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_parse(saved_bytes, saved_size, test_on_record, NULL));
+    ASSERT_ARE_EQUAL(size_t, 1, parsed_record_count);
+    ASSERT_ARE_EQUAL(uint32_t, sizeof(long_performative), parsed_records[0].performative_size);
+    ASSERT_ARE_EQUAL(uint32_t, FRAME_TRACE_MAX_PERFORMATIVE_SIZE, parsed_records[0].captured_size);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_006: [ `frame_trace_record_bytes` shall add a record with `direction`, `frame_type`, `channel`, `timestamp_ms`, `payload_size`, the performative size and a copy of at most FRAME_TRACE_MAX_PERFORMATIVE_SIZE bytes of `performative_bytes`, and return 0. ]*/
+TEST_FUNCTION(frame_trace_record_bytes_records_an_empty_frame)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_INCOMING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, 1, NULL, 0, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_save(frame_trace, test_output, NULL));
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_parse(saved_bytes, saved_size, test_on_record, NULL));
+    ASSERT_ARE_EQUAL(size_t, 1, parsed_record_count);
+    ASSERT_ARE_EQUAL(int, (int)FRAME_TRACE_FRAME_TYPE_EMPTY, (int)parsed_records[0].frame_type);
+    ASSERT_ARE_EQUAL(uint32_t, 0, parsed_records[0].captured_size);
+    ASSERT_IS_NULL(parsed_records[0].performative_bytes);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_007: [ If `frame_trace` is NULL, `performative_bytes` is NULL while `performative_size` is not 0, or `direction` or `frame_type` is not a known value, `frame_trace_record_bytes` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_record_bytes_with_NULL_frame_trace_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = frame_trace_record_bytes(NULL, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, 0, 1, test_performative_bytes, sizeof(test_performative_bytes), 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_FRAME_TRACE_01_007: [ If `frame_trace` is NULL, `performative_bytes` is NULL while `performative_size` is not 0, or `direction` or `frame_type` is not a known value, `frame_trace_record_bytes` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_record_bytes_with_NULL_performative_bytes_and_non_zero_size_fails)
+{
+    // arrange
+    int result;
+    size_t record_count;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, 0, 1, NULL, 1, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_get_record_count(frame_trace, &record_count));
+    ASSERT_ARE_EQUAL(size_t, 0, record_count);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_007: [ If `frame_trace` is NULL, `performative_bytes` is NULL while `performative_size` is not 0, or `direction` or `frame_type` is not a known value, `frame_trace_record_bytes` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_record_bytes_with_an_unknown_frame_type_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, (FRAME_TRACE_FRAME_TYPE)42, 0, 1, test_performative_bytes, sizeof(test_performative_bytes), 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_008: [ When the trace already holds `record_count` records, the oldest record shall be overwritten. ]*/
+TEST_FUNCTION(when_the_trace_is_full_the_oldest_record_is_overwritten)
+{
+    // arrange
+    size_t record_count;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(2);
+    umock_c_reset_all_calls();
+
+    // act
+    (void)frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, 1, NULL, 0, 0);
+    (void)frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, 2, NULL, 0, 0);
+    (void)frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, 3, NULL, 0, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_get_record_count(frame_trace, &record_count));
+    ASSERT_ARE_EQUAL(size_t, 2, record_count);
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_save(frame_trace, test_output, NULL));
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_parse(saved_bytes, saved_size, test_on_record, NULL));
+    ASSERT_ARE_EQUAL(size_t, 2, parsed_record_count);
+    ASSERT_IS_TRUE(parsed_records[0].timestamp_ms == 2);
+    ASSERT_IS_TRUE(parsed_records[1].timestamp_ms == 3);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_record_value */
+
+/* Tests_SRS_FRAME_TRACE_01_009: [ `frame_trace_record_value` shall encode `performative` with `amqpvalue_encode` and record it as a FRAME_TRACE_FRAME_TYPE_PERFORMATIVE frame the way `frame_trace_record_bytes` does. ]*/
+TEST_FUNCTION(frame_trace_record_value_records_the_encoded_performative)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_PERFORMATIVE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = frame_trace_record_value(frame_trace, FRAME_TRACE_DIRECTION_INCOMING, 1, 5, TEST_PERFORMATIVE, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_save(frame_trace, test_output, NULL));
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_parse(saved_bytes, saved_size, test_on_record, NULL));
+    ASSERT_ARE_EQUAL(size_t, 1, parsed_record_count);
+    ASSERT_ARE_EQUAL(int, (int)FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, (int)parsed_records[0].frame_type);
+    ASSERT_ARE_EQUAL(uint32_t, sizeof(test_performative_bytes), parsed_records[0].captured_size);
+    ASSERT_ARE_EQUAL(uint32_t, 10, parsed_records[0].payload_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(parsed_records[0].performative_bytes, test_performative_bytes, sizeof(test_performative_bytes)));
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_009: [ `frame_trace_record_value` shall encode `performative` with `amqpvalue_encode` and record it as a FRAME_TRACE_FRAME_TYPE_PERFORMATIVE frame the way `frame_trace_record_bytes` does. ]*/
+TEST_FUNCTION(frame_trace_record_value_keeps_the_full_size_of_a_truncated_performative)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    test_encoded_repeat_count = 50;
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_record_value(frame_trace, FRAME_TRACE_DIRECTION_INCOMING, 1, 5, TEST_PERFORMATIVE, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_save(frame_trace, test_output, NULL));
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_parse(saved_bytes, saved_size, test_on_record, NULL));
+    ASSERT_ARE_EQUAL(size_t, 1, parsed_record_count);
+    ASSERT_ARE_EQUAL(uint32_t, 50 * sizeof(test_performative_bytes), parsed_records[0].performative_size);
+    ASSERT_ARE_EQUAL(uint32_t, FRAME_TRACE_MAX_PERFORMATIVE_SIZE, parsed_records[0].captured_size);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_010: [ If `frame_trace` or `performative` is NULL or `direction` is not a known value, `frame_trace_record_value` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_record_value_with_NULL_performative_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_record_value(frame_trace, FRAME_TRACE_DIRECTION_INCOMING, 1, 5, NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_011: [ If `amqpvalue_encode` fails, `frame_trace_record_value` shall fail, leave the trace unchanged and return a non-zero value. ]*/
+TEST_FUNCTION(when_amqpvalue_encode_fails_frame_trace_record_value_fails)
+{
+    // arrange
+    int result;
+    size_t record_count;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_PERFORMATIVE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = frame_trace_record_value(frame_trace, FRAME_TRACE_DIRECTION_INCOMING, 1, 5, TEST_PERFORMATIVE, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_get_record_count(frame_trace, &record_count));
+    ASSERT_ARE_EQUAL(size_t, 0, record_count);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_get_record_count */
+
+/* Tests_SRS_FRAME_TRACE_01_013: [ If `frame_trace` or `record_count` is NULL, `frame_trace_get_record_count` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_get_record_count_with_NULL_record_count_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_get_record_count(frame_trace, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_clear */
+
+/* Tests_SRS_FRAME_TRACE_01_014: [ `frame_trace_clear` shall remove all records from the trace. ]*/
+TEST_FUNCTION(frame_trace_clear_removes_all_records)
+{
+    // arrange
+    size_t record_count;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, 1, NULL, 0, 0);
+    umock_c_reset_all_calls();
+
+    // act
+    frame_trace_clear(frame_trace);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_get_record_count(frame_trace, &record_count));
+    ASSERT_ARE_EQUAL(size_t, 0, record_count);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_save */
+
+/* Tests_SRS_FRAME_TRACE_01_017: [ If `frame_trace` or `output` is NULL, `frame_trace_save` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_save_with_NULL_output_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_save(frame_trace, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_018: [ If `output` fails, `frame_trace_save` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_output_fails_frame_trace_save_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, 1, NULL, 0, 0);
+    output_result = 1;
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_save(frame_trace, test_output, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_parse */
+
+/* Tests_SRS_FRAME_TRACE_01_020: [ If `bytes` or `on_record` is NULL, `frame_trace_parse` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_parse_with_NULL_bytes_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = frame_trace_parse(NULL, 8, test_on_record, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, parsed_record_count);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_021: [ If `bytes` does not start with the trace magic, `frame_trace_parse` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_parse_without_the_magic_fails)
+{
+    // arrange
+    int result;
+    const unsigned char not_a_trace[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+    // act
+    result = frame_trace_parse(not_a_trace, sizeof(not_a_trace), test_on_record, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, parsed_record_count);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_022: [ If a record is truncated or carries invalid values, `frame_trace_parse` shall fail and return a non-zero value after reporting the records before it. ]*/
+TEST_FUNCTION(frame_trace_parse_of_a_truncated_record_reports_the_previous_records_and_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_EMPTY, 0, 1, NULL, 0, 0);
+    (void)frame_trace_record_bytes(frame_trace, FRAME_TRACE_DIRECTION_OUTGOING, FRAME_TRACE_FRAME_TYPE_PERFORMATIVE, 0, 2, test_performative_bytes, sizeof(test_performative_bytes), 0);
+    (void)frame_trace_save(frame_trace, test_output, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_parse(saved_bytes, saved_size - 1, test_on_record, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, parsed_record_count);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_set_capture */
+
+/* Tests_SRS_FRAME_TRACE_01_023: [ `frame_trace_set_capture` shall pass the capture magic to `output`, make the trace write the bytes given to `frame_trace_capture_bytes` to `output` from then on, and return 0. ]*/
+/* Tests_SRS_FRAME_TRACE_01_027: [ `frame_trace_is_capturing` shall return true when a capture output is set on `frame_trace` and false otherwise, `frame_trace` NULL included. ]*/
+TEST_FUNCTION(frame_trace_set_capture_writes_the_magic_and_starts_capturing)
+{
+    // arrange
+    int result;
+    const unsigned char expected_magic[] = { 'U', 'A', 'M', 'Q', 'P', 'F', 'C', '1' };
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_set_capture(frame_trace, test_output, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(frame_trace_is_capturing(frame_trace));
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_magic), saved_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(saved_bytes, expected_magic, sizeof(expected_magic)));
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_024: [ If `frame_trace` is NULL, `frame_trace_set_capture` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_set_capture_with_NULL_frame_trace_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = frame_trace_set_capture(NULL, test_output, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, saved_size);
+    ASSERT_IS_FALSE(frame_trace_is_capturing(NULL));
+}
+
+/* Tests_SRS_FRAME_TRACE_01_025: [ If `output` fails, `frame_trace_set_capture` shall fail, stop any previous capture and return a non-zero value. ]*/
+TEST_FUNCTION(when_output_fails_frame_trace_set_capture_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    output_result = 1;
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_set_capture(frame_trace, test_output, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(frame_trace_is_capturing(frame_trace));
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_026: [ If `output` is NULL, `frame_trace_set_capture` shall stop the capture and return 0. ]*/
+TEST_FUNCTION(frame_trace_set_capture_with_NULL_output_stops_the_capture)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_set_capture(frame_trace, test_output, NULL);
+    saved_size = 0;
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_set_capture(frame_trace, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(frame_trace_is_capturing(frame_trace));
+    ASSERT_ARE_EQUAL(int, 0, frame_trace_capture_bytes(frame_trace, 1, test_performative_bytes, sizeof(test_performative_bytes)));
+    ASSERT_ARE_EQUAL(size_t, 0, saved_size);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_capture_bytes */
+
+/* Tests_SRS_FRAME_TRACE_01_028: [ `frame_trace_capture_bytes` shall pass to the capture output a chunk made of a 12 byte big endian header (`timestamp_ms` (8), `length` (4)) followed by `bytes`, and return 0. ]*/
+TEST_FUNCTION(frame_trace_capture_bytes_writes_a_chunk)
+{
+    // arrange
+    int result;
+    const unsigned char expected_header[] = { 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, sizeof(test_performative_bytes) };
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_set_capture(frame_trace, test_output, NULL);
+    saved_size = 0;
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_capture_bytes(frame_trace, ((uint64_t)1 << 32) | 2, test_performative_bytes, sizeof(test_performative_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_header) + sizeof(test_performative_bytes), saved_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(saved_bytes, expected_header, sizeof(expected_header)));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(saved_bytes + sizeof(expected_header), test_performative_bytes, sizeof(test_performative_bytes)));
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_029: [ If `frame_trace` is NULL, `bytes` is NULL while `length` is not 0, or `length` does not fit in 32 bits, `frame_trace_capture_bytes` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_capture_bytes_with_NULL_bytes_and_non_zero_length_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_set_capture(frame_trace, test_output, NULL);
+    saved_size = 0;
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_capture_bytes(frame_trace, 1, NULL, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, saved_size);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_030: [ If the trace is not capturing or `length` is 0, `frame_trace_capture_bytes` shall do nothing and return 0. ]*/
+TEST_FUNCTION(frame_trace_capture_bytes_when_not_capturing_does_nothing)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_capture_bytes(frame_trace, 1, test_performative_bytes, sizeof(test_performative_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, saved_size);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_031: [ If the capture output fails, `frame_trace_capture_bytes` shall stop the capture and return a non-zero value. ]*/
+TEST_FUNCTION(when_output_fails_frame_trace_capture_bytes_stops_the_capture)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_set_capture(frame_trace, test_output, NULL);
+    output_result = 1;
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_capture_bytes(frame_trace, 1, test_performative_bytes, sizeof(test_performative_bytes));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(frame_trace_is_capturing(frame_trace));
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* frame_trace_parse_capture */
+
+/* Tests_SRS_FRAME_TRACE_01_032: [ `frame_trace_parse_capture` shall call `on_chunk` with `on_chunk_context` for each chunk written by `frame_trace_capture_bytes`, in the captured order, and return 0. ]*/
+TEST_FUNCTION(frame_trace_parse_capture_reports_the_captured_chunks)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_set_capture(frame_trace, test_output, NULL);
+    (void)frame_trace_capture_bytes(frame_trace, 1, test_performative_bytes, 3);
+    (void)frame_trace_capture_bytes(frame_trace, 2, test_performative_bytes, sizeof(test_performative_bytes));
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_parse_capture(saved_bytes, saved_size, test_on_chunk, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, parsed_chunk_count);
+    ASSERT_ARE_EQUAL(uint64_t, 1, parsed_chunk_timestamps[0]);
+    ASSERT_ARE_EQUAL(size_t, 3, parsed_chunk_lengths[0]);
+    ASSERT_ARE_EQUAL(uint64_t, 2, parsed_chunk_timestamps[1]);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_performative_bytes), parsed_chunk_lengths[1]);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_033: [ If `bytes` or `on_chunk` is NULL, `frame_trace_parse_capture` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_parse_capture_with_NULL_on_chunk_fails)
+{
+    // arrange
+    int result;
+    const unsigned char capture[] = { 'U', 'A', 'M', 'Q', 'P', 'F', 'C', '1' };
+
+    // act
+    result = frame_trace_parse_capture(capture, sizeof(capture), NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_034: [ If `bytes` does not start with the capture magic, `frame_trace_parse_capture` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(frame_trace_parse_capture_of_a_saved_trace_fails)
+{
+    // arrange
+    int result;
+    const unsigned char saved_trace[] = { 'U', 'A', 'M', 'Q', 'P', 'F', 'T', '1' };
+
+    // act
+    result = frame_trace_parse_capture(saved_trace, sizeof(saved_trace), test_on_chunk, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, parsed_chunk_count);
+}
+
+/* Tests_SRS_FRAME_TRACE_01_035: [ If a chunk is truncated, `frame_trace_parse_capture` shall fail and return a non-zero value after reporting the chunks before it. ]*/
+TEST_FUNCTION(frame_trace_parse_capture_of_a_truncated_chunk_reports_the_previous_chunks_and_fails)
+{
+    // arrange
+    int result;
+    FRAME_TRACE_HANDLE frame_trace = frame_trace_create(4);
+    (void)frame_trace_set_capture(frame_trace, test_output, NULL);
+    (void)frame_trace_capture_bytes(frame_trace, 1, test_performative_bytes, 3);
+    (void)frame_trace_capture_bytes(frame_trace, 2, test_performative_bytes, sizeof(test_performative_bytes));
+    umock_c_reset_all_calls();
+
+    // act
+    result = frame_trace_parse_capture(saved_bytes, saved_size - 1, test_on_chunk, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, parsed_chunk_count);
+
+    // cleanup
+    frame_trace_destroy(frame_trace);
+}
+
+END_TEST_SUITE(frame_trace_ut)
@@ -3897,6 +3897,52 @@ TEST_FUNCTION(on_underlying_io_bytes_received_when_opening_a_detected_IO_passes_
     header_detect_io_get_interface_description()->concrete_io_destroy(header_detect_io);
 }
 
+/* Tests_SRS_HEADER_DETECT_IO_01_092: [ When a whole header is matched in one `on_underlying_io_bytes_received` call, the bytes following it shall be passed on in the same call without being copied. ]*/
+TEST_FUNCTION(on_underlying_io_bytes_received_with_a_header_and_payload_passes_the_payload_to_the_detected_IO_in_place)
+{
+    // arrange
+    CONCRETE_IO_HANDLE header_detect_io;
+    HEADER_DETECT_IO_CONFIG header_detect_io_config;
+    unsigned char amqp_header_bytes_1[] = { 0x42, 0x43, 0x44 };
+    unsigned char amqp_header_bytes_2[] = { 0x42, 0x43, 0x45 };
+    unsigned char received_bytes[] = { 0x42, 0x43, 0x44, 0x01, 0x02 };
+    HEADER_DETECT_ENTRY header_detect_entries[2];
+
+    header_detect_entries[0].header.header_bytes = amqp_header_bytes_1;
+    header_detect_entries[0].header.header_size = sizeof(amqp_header_bytes_1);
+    header_detect_entries[0].io_interface_description = test_detected_io_interface_description_1;
+    header_detect_entries[1].header.header_bytes = amqp_header_bytes_2;
+    header_detect_entries[1].header.header_size = sizeof(amqp_header_bytes_2);
+    header_detect_entries[1].io_interface_description = NULL;
+
+    header_detect_io_config.header_detect_entry_count = 2;
+    header_detect_io_config.header_detect_entries = header_detect_entries;
+    header_detect_io_config.underlying_io = test_underlying_amqp_io;
+
+    header_detect_io = header_detect_io_get_interface_description()->concrete_io_create(&header_detect_io_config);
+
+    (void)header_detect_io_get_interface_description()->concrete_io_open(header_detect_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(test_underlying_amqp_io, amqp_header_bytes_1, sizeof(amqp_header_bytes_1), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, amqp_header_bytes_1, sizeof(amqp_header_bytes_1));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_create(test_detected_io_interface_description_1, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(test_singlylinked_list, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_open(test_detected_io_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_detected_io_1_on_bytes_received(test_detected_io_1_on_bytes_received_context, received_bytes + sizeof(amqp_header_bytes_1), sizeof(received_bytes) - sizeof(amqp_header_bytes_1)));
+
+    // act
+    saved_on_bytes_received(saved_on_bytes_received_context, received_bytes, sizeof(received_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    header_detect_io_get_interface_description()->concrete_io_destroy(header_detect_io);
+}
+
 /* Tests_SRS_HEADER_DETECT_IO_01_089: [ If `on_underlying_io_bytes_received` is called while header detect IO is OPEN the bytes shall be given to the user via the `on_bytes_received` callback that was the `on_bytes_received` callback passed to `header_detect_io_open_async`. ]*/
 TEST_FUNCTION(on_underlying_io_bytes_received_when_open_gives_the_bytes_to_the_proper_IO)
 {
@@ -0,0 +1,1124 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_uamqp_c/uamqp.h"
+
+/* Fans thousands of idle clients (sessions and links each) in to one socket_listener server and reports the accept rate,
+   the attach latency, the CPU spent per idle connection and the memory per connection. With --role both (the default)
+   clients and server share the process, so the CPU and memory figures cover both ends of each connection; run
+   --role server and --role client in two processes to get the server's figures alone. */
+
+typedef enum FANIN_ROLE_TAG
+{
+    FANIN_ROLE_BOTH,
+    FANIN_ROLE_SERVER,
+    FANIN_ROLE_CLIENT
+} FANIN_ROLE;
+
+typedef struct FANIN_CONFIG_TAG
+{
+    FANIN_ROLE role;
+    size_t client_count;
+    size_t sessions_per_client;
+    size_t links_per_session;
+    size_t connect_batch;
+    uint64_t attach_timeout_us;
+    uint64_t idle_duration_us;
+    uint64_t server_duration_us;
+    uint64_t sample_interval_us;
+    const char* host;
+    int port;
+} FANIN_CONFIG;
+
+static FANIN_CONFIG config = { FANIN_ROLE_BOTH, 2000, 1, 1, 100, 60000000, 10000000, 300000000, 1000000, "localhost", 5676 };
+
+typedef struct MEMORY_SNAPSHOT_TAG
+{
+    uint64_t rss_bytes;
+    uint64_t heap_bytes;
+    uint64_t live_allocation_count;
+} MEMORY_SNAPSHOT;
+
+typedef struct SERVER_STATS_TAG
+{
+    size_t connection_count;
+    size_t accepted_count;
+    size_t attached_link_count;
+    uint64_t first_accept_us;
+    uint64_t last_accept_us;
+} SERVER_STATS;
+
+static SINGLYLINKEDLIST_HANDLE server_connected_clients;
+static SERVER_STATS server_stats;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+/* user and kernel time of the process */
+static uint64_t get_cpu_time_us(void)
+{
+#ifdef _WIN32
+    FILETIME creation_time;
+    FILETIME exit_time;
+    FILETIME kernel_time;
+    FILETIME user_time;
+    uint64_t result;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        result = 0;
+    }
+    else
+    {
+        /* 100 ns units */
+        result = ((((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime) +
+            (((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime)) / 10;
+    }
+
+    return result;
+#else
+    struct rusage usage;
+    uint64_t result;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = ((uint64_t)usage.ru_utime.tv_sec * 1000000) + (uint64_t)usage.ru_utime.tv_usec +
+            ((uint64_t)usage.ru_stime.tv_sec * 1000000) + (uint64_t)usage.ru_stime.tv_usec;
+    }
+
+    return result;
+#endif
+}
+
+static uint64_t get_rss_bytes(void)
+{
+    uint64_t result;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (uint64_t)counters.WorkingSetSize;
+    }
+#elif defined(__linux__)
+    FILE* statm = fopen("/proc/self/statm", "r");
+    unsigned long total_pages;
+    unsigned long resident_pages;
+
+    if (statm == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        if (fscanf(statm, "%lu %lu", &total_pages, &resident_pages) != 2)
+        {
+            result = 0;
+        }
+        else
+        {
+            result = (uint64_t)resident_pages * (uint64_t)sysconf(_SC_PAGESIZE);
+        }
+
+        (void)fclose(statm);
+    }
+#else
+    result = 0;
+#endif
+
+    return result;
+}
+
+static void take_memory_snapshot(MEMORY_SNAPSHOT* snapshot)
+{
+    ALLOC_COUNTERS counters;
+
+    snapshot->rss_bytes = get_rss_bytes();
+
+    if (alloc_counters_are_enabled() &&
+        (alloc_counters_get_total(&counters) == 0))
+    {
+        snapshot->live_allocation_count = counters.allocation_count - counters.free_count;
+    }
+    else
+    {
+        snapshot->live_allocation_count = 0;
+    }
+
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+    snapshot->heap_bytes = gballoc_getCurrentMemoryUsed();
+#else
+    snapshot->heap_bytes = 0;
+#endif
+}
+
+static void print_memory_per_connection(const MEMORY_SNAPSHOT* baseline, const MEMORY_SNAPSHOT* current, size_t connection_count)
+{
+    if (connection_count > 0)
+    {
+        (void)printf("memory per connection: rss %.0f bytes", ((double)current->rss_bytes - (double)baseline->rss_bytes) / (double)connection_count);
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+        (void)printf(", heap %.0f bytes", ((double)current->heap_bytes - (double)baseline->heap_bytes) / (double)connection_count);
+#endif
+        if (alloc_counters_are_enabled())
+        {
+            (void)printf(", %.1f live allocations", ((double)current->live_allocation_count - (double)baseline->live_allocation_count) / (double)connection_count);
+        }
+
+        (void)printf("\n");
+    }
+}
+
+/* a descriptor per connection, and two per connection when both ends share the process */
+static void raise_open_file_limit(void)
+{
+#ifndef _WIN32
+    struct rlimit limit;
+
+    if ((getrlimit(RLIMIT_NOFILE, &limit) == 0) &&
+        (limit.rlim_cur < limit.rlim_max))
+    {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) != 0)
+        {
+            LogError("Cannot raise the open file limit");
+        }
+    }
+#endif
+}
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s [options]\n"
+        "  --role <both|server|client>    what runs in this process (default both)\n"
+        "  --clients <count>              client connections (default 2000)\n"
+        "  --sessions <count>             sessions per client (default 1)\n"
+        "  --links <count>                sender links per session (default 1)\n"
+        "  --connect-batch <count>        clients started per pass, so that the listen backlog keeps up (default 100)\n"
+        "  --attach-timeout <ms>          time for all the links to attach (default 60000)\n"
+        "  --idle-duration <ms>           time the attached clients are kept idle (default 10000)\n"
+        "  --server-duration <ms>         time a --role server process runs for (default 300000)\n"
+        "  --sample-interval <ms>         interval of the --role server samples (default 1000)\n"
+        "  --host <host>                  server the --role client process connects to (default localhost)\n"
+        "  --port <port>                  server port (default 5676)\n",
+        program_name);
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned long number = (value == NULL) ? 0 : strtoul(value, NULL, 10);
+
+        if (value == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--role") == 0)
+        {
+            if (strcmp(value, "both") == 0)
+            {
+                config.role = FANIN_ROLE_BOTH;
+            }
+            else if (strcmp(value, "server") == 0)
+            {
+                config.role = FANIN_ROLE_SERVER;
+            }
+            else if (strcmp(value, "client") == 0)
+            {
+                config.role = FANIN_ROLE_CLIENT;
+            }
+            else
+            {
+                result = __LINE__;
+            }
+        }
+        else if (strcmp(argv[i], "--clients") == 0)
+        {
+            config.client_count = number;
+        }
+        else if (strcmp(argv[i], "--sessions") == 0)
+        {
+            config.sessions_per_client = number;
+        }
+        else if (strcmp(argv[i], "--links") == 0)
+        {
+            config.links_per_session = number;
+        }
+        else if (strcmp(argv[i], "--connect-batch") == 0)
+        {
+            config.connect_batch = number;
+        }
+        else if (strcmp(argv[i], "--attach-timeout") == 0)
+        {
+            config.attach_timeout_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--idle-duration") == 0)
+        {
+            config.idle_duration_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--server-duration") == 0)
+        {
+            config.server_duration_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--sample-interval") == 0)
+        {
+            config.sample_interval_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--host") == 0)
+        {
+            config.host = value;
+        }
+        else if (strcmp(argv[i], "--port") == 0)
+        {
+            config.port = (int)number;
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    if ((result == 0) &&
+        ((config.client_count == 0) ||
+        (config.sessions_per_client == 0) ||
+        (config.links_per_session == 0) ||
+        (config.connect_batch == 0) ||
+        (config.sample_interval_us == 0)))
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+/* server side */
+
+typedef struct SERVER_CONNECTED_CLIENT_TAG SERVER_CONNECTED_CLIENT;
+
+typedef struct SERVER_SESSION_TAG
+{
+    SESSION_HANDLE session;
+    SERVER_CONNECTED_CLIENT* server_connected_client;
+} SERVER_SESSION;
+
+typedef struct SERVER_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_RECEIVER_HANDLE message_receiver;
+    bool is_attached;
+} SERVER_LINK;
+
+struct SERVER_CONNECTED_CLIENT_TAG
+{
+    XIO_HANDLE io;
+    CONNECTION_HANDLE connection;
+    SINGLYLINKEDLIST_HANDLE sessions;
+    SINGLYLINKEDLIST_HANDLE links;
+    bool is_closed;
+};
+
+static void on_message_receiver_state_changed(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state)
+{
+    SERVER_LINK* server_link = (SERVER_LINK*)context;
+    bool is_attached = (new_state == MESSAGE_RECEIVER_STATE_OPEN);
+
+    (void)previous_state;
+
+    if (is_attached != server_link->is_attached)
+    {
+        server_link->is_attached = is_attached;
+        if (is_attached)
+        {
+            server_stats.attached_link_count++;
+        }
+        else
+        {
+            server_stats.attached_link_count--;
+        }
+    }
+}
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    (void)context;
+    (void)message;
+
+    return messaging_delivery_accepted();
+}
+
+static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    SERVER_SESSION* server_session = (SERVER_SESSION*)context;
+    SERVER_LINK* server_link = (SERVER_LINK*)calloc(1, sizeof(SERVER_LINK));
+    bool result;
+
+    if (server_link == NULL)
+    {
+        LogError("Cannot allocate the server link");
+        result = false;
+    }
+    else if ((server_link->link = link_create_from_endpoint(server_session->session, new_link_endpoint, name, role, source, target)) == NULL)
+    {
+        LogError("Cannot create link");
+        free(server_link);
+        result = false;
+    }
+    else if ((server_link->message_receiver = messagereceiver_create(server_link->link, on_message_receiver_state_changed, server_link)) == NULL)
+    {
+        LogError("Cannot create message receiver");
+        link_destroy(server_link->link);
+        free(server_link);
+        result = false;
+    }
+    else if ((messagereceiver_open(server_link->message_receiver, on_message_received, NULL) != 0) ||
+        (singlylinkedlist_add(server_session->server_connected_client->links, server_link) == NULL))
+    {
+        LogError("Cannot open message receiver");
+        messagereceiver_destroy(server_link->message_receiver);
+        link_destroy(server_link->link);
+        free(server_link);
+        result = false;
+    }
+    else
+    {
+        /* all OK */
+        result = true;
+    }
+
+    return result;
+}
+
+static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    SERVER_SESSION* server_session = (SERVER_SESSION*)malloc(sizeof(SERVER_SESSION));
+    bool result;
+
+    if (server_session == NULL)
+    {
+        LogError("Cannot allocate the server session");
+        result = false;
+    }
+    else
+    {
+        server_session->server_connected_client = server_connected_client;
+        server_session->session = session_create_from_endpoint(server_connected_client->connection, new_endpoint, on_new_link_attached, server_session);
+        if (server_session->session == NULL)
+        {
+            LogError("Cannot create session");
+            free(server_session);
+            result = false;
+        }
+        else if ((session_begin(server_session->session) != 0) ||
+            (singlylinkedlist_add(server_connected_client->sessions, server_session) == NULL))
+        {
+            LogError("Cannot begin session");
+            session_destroy(server_session->session);
+            free(server_session);
+            result = false;
+        }
+        else
+        {
+            /* all OK */
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static void on_server_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
+{
+    (void)previous_connection_state;
+
+    if ((new_connection_state == CONNECTION_STATE_END) ||
+        (new_connection_state == CONNECTION_STATE_ERROR) ||
+        (new_connection_state == CONNECTION_STATE_DISCARDING))
+    {
+        ((SERVER_CONNECTED_CLIENT*)context)->is_closed = true;
+    }
+}
+
+static void on_server_io_error(void* context)
+{
+    ((SERVER_CONNECTED_CLIENT*)context)->is_closed = true;
+}
+
+static void destroy_server_connected_client(SERVER_CONNECTED_CLIENT* server_connected_client)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    if (server_connected_client->links != NULL)
+    {
+        while ((list_item = singlylinkedlist_get_head_item(server_connected_client->links)) != NULL)
+        {
+            SERVER_LINK* server_link = (SERVER_LINK*)singlylinkedlist_item_get_value(list_item);
+
+            if (server_link->is_attached)
+            {
+                server_stats.attached_link_count--;
+            }
+
+            messagereceiver_destroy(server_link->message_receiver);
+            link_destroy(server_link->link);
+            free(server_link);
+            (void)singlylinkedlist_remove(server_connected_client->links, list_item);
+        }
+
+        singlylinkedlist_destroy(server_connected_client->links);
+    }
+
+    if (server_connected_client->sessions != NULL)
+    {
+        while ((list_item = singlylinkedlist_get_head_item(server_connected_client->sessions)) != NULL)
+        {
+            SERVER_SESSION* server_session = (SERVER_SESSION*)singlylinkedlist_item_get_value(list_item);
+
+            session_destroy(server_session->session);
+            free(server_session);
+            (void)singlylinkedlist_remove(server_connected_client->sessions, list_item);
+        }
+
+        singlylinkedlist_destroy(server_connected_client->sessions);
+    }
+
+    if (server_connected_client->connection != NULL)
+    {
+        connection_destroy(server_connected_client->connection);
+    }
+
+    xio_destroy(server_connected_client->io);
+    free(server_connected_client);
+}
+
+static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* interface_description, void* io_parameters)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)calloc(1, sizeof(SERVER_CONNECTED_CLIENT));
+
+    (void)context;
+
+    if (server_connected_client == NULL)
+    {
+        LogError("Cannot allocate the server connected client");
+    }
+    else if ((server_connected_client->io = xio_create(interface_description, io_parameters)) == NULL)
+    {
+        LogError("Cannot create accepted socket IO");
+        free(server_connected_client);
+    }
+    else if (((server_connected_client->sessions = singlylinkedlist_create()) == NULL) ||
+        ((server_connected_client->links = singlylinkedlist_create()) == NULL) ||
+        ((server_connected_client->connection = connection_create2(server_connected_client->io, NULL, "1", on_new_session_endpoint, server_connected_client,
+            on_server_connection_state_changed, server_connected_client, on_server_io_error, server_connected_client)) == NULL) ||
+        (connection_listen(server_connected_client->connection) != 0) ||
+        (singlylinkedlist_add(server_connected_clients, server_connected_client) == NULL))
+    {
+        LogError("Cannot set up the server connection");
+        destroy_server_connected_client(server_connected_client);
+    }
+    else
+    {
+        uint64_t now_us = get_time_us();
+
+        if (server_stats.accepted_count == 0)
+        {
+            server_stats.first_accept_us = now_us;
+        }
+
+        server_stats.last_accept_us = now_us;
+        server_stats.accepted_count++;
+        server_stats.connection_count++;
+    }
+}
+
+static void run_server(SOCKET_LISTENER_HANDLE socket_listener)
+{
+    LIST_ITEM_HANDLE current_item;
+
+    socketlistener_dowork(socket_listener);
+
+    current_item = singlylinkedlist_get_head_item(server_connected_clients);
+    while (current_item != NULL)
+    {
+        SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
+        LIST_ITEM_HANDLE next_item = singlylinkedlist_get_next_item(current_item);
+
+        connection_dowork(server_connected_client->connection);
+
+        if (server_connected_client->is_closed)
+        {
+            (void)singlylinkedlist_remove(server_connected_clients, current_item);
+            destroy_server_connected_client(server_connected_client);
+            server_stats.connection_count--;
+        }
+
+        current_item = next_item;
+    }
+}
+
+static void print_accept_rate(void)
+{
+    if (server_stats.accepted_count > 1)
+    {
+        (void)printf("accepted %u connections at %.0f/s\n", (unsigned int)server_stats.accepted_count,
+            (double)(server_stats.accepted_count - 1) * 1000000.0 / (double)(server_stats.last_accept_us - server_stats.first_accept_us + 1));
+    }
+}
+
+/* client side */
+
+typedef struct CLIENT_TAG CLIENT;
+
+typedef struct CLIENT_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_SENDER_HANDLE message_sender;
+    CLIENT* client;
+    /* 0 until attached */
+    uint64_t attach_latency_us;
+} CLIENT_LINK;
+
+struct CLIENT_TAG
+{
+    XIO_HANDLE socket_io;
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE* sessions;
+    CLIENT_LINK* links;
+    size_t session_count;
+    size_t link_count;
+    uint64_t start_us;
+    bool is_failed;
+};
+
+typedef struct CLIENT_STATS_TAG
+{
+    size_t started_count;
+    size_t attached_link_count;
+    size_t failed_count;
+    uint64_t last_attach_us;
+} CLIENT_STATS;
+
+static CLIENT_STATS client_stats;
+
+static void on_message_sender_state_changed(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
+{
+    CLIENT_LINK* client_link = (CLIENT_LINK*)context;
+
+    (void)previous_state;
+
+    if ((new_state == MESSAGE_SENDER_STATE_OPEN) &&
+        (client_link->attach_latency_us == 0))
+    {
+        uint64_t now_us = get_time_us();
+
+        /* from the start of the client: connect, open, begin and attach */
+        client_link->attach_latency_us = now_us - client_link->client->start_us + 1;
+        client_stats.attached_link_count++;
+        client_stats.last_attach_us = now_us;
+    }
+    else if ((new_state == MESSAGE_SENDER_STATE_ERROR) &&
+        (!client_link->client->is_failed))
+    {
+        client_link->client->is_failed = true;
+        client_stats.failed_count++;
+    }
+}
+
+static void on_client_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
+{
+    CLIENT* client = (CLIENT*)context;
+
+    (void)previous_connection_state;
+
+    if (((new_connection_state == CONNECTION_STATE_END) ||
+        (new_connection_state == CONNECTION_STATE_ERROR)) &&
+        (!client->is_failed))
+    {
+        client->is_failed = true;
+        client_stats.failed_count++;
+    }
+}
+
+static void on_client_io_error(void* context)
+{
+    CLIENT* client = (CLIENT*)context;
+
+    if (!client->is_failed)
+    {
+        client->is_failed = true;
+        client_stats.failed_count++;
+    }
+}
+
+static void destroy_client(CLIENT* client)
+{
+    size_t i;
+
+    for (i = 0; i < client->link_count; i++)
+    {
+        messagesender_destroy(client->links[i].message_sender);
+        link_destroy(client->links[i].link);
+    }
+
+    for (i = 0; i < client->session_count; i++)
+    {
+        session_destroy(client->sessions[i]);
+    }
+
+    if (client->connection != NULL)
+    {
+        connection_destroy(client->connection);
+    }
+
+    if (client->socket_io != NULL)
+    {
+        xio_destroy(client->socket_io);
+    }
+
+    free(client->links);
+    free(client->sessions);
+}
+
+static int create_client_link(CLIENT* client, SESSION_HANDLE session)
+{
+    int result;
+    char link_name[32];
+    AMQP_VALUE source;
+    AMQP_VALUE target;
+    CLIENT_LINK* client_link = &client->links[client->link_count];
+
+    (void)sprintf(link_name, "sender-link-%u", (unsigned int)client->link_count);
+    source = messaging_create_source("ingress");
+    target = messaging_create_target("localhost/ingress");
+
+    client_link->client = client;
+    client_link->attach_latency_us = 0;
+    client_link->link = link_create(session, link_name, role_sender, source, target);
+    if (client_link->link == NULL)
+    {
+        LogError("Cannot create client link");
+        result = __LINE__;
+    }
+    else
+    {
+        client_link->message_sender = messagesender_create(client_link->link, on_message_sender_state_changed, client_link);
+        if (client_link->message_sender == NULL)
+        {
+            LogError("Cannot create client message sender");
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else if (messagesender_open(client_link->message_sender) != 0)
+        {
+            LogError("Cannot open client message sender");
+            messagesender_destroy(client_link->message_sender);
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else
+        {
+            client->link_count++;
+            result = 0;
+        }
+    }
+
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(target);
+
+    return result;
+}
+
+static int create_client(CLIENT* client)
+{
+    int result;
+    SOCKETIO_CONFIG socketio_config = { NULL, 0, NULL };
+
+    socketio_config.hostname = config.host;
+    socketio_config.port = config.port;
+
+    (void)memset(client, 0, sizeof(CLIENT));
+    client->start_us = get_time_us();
+
+    if (((client->sessions = (SESSION_HANDLE*)calloc(config.sessions_per_client, sizeof(SESSION_HANDLE))) == NULL) ||
+        ((client->links = (CLIENT_LINK*)calloc(config.sessions_per_client * config.links_per_session, sizeof(CLIENT_LINK))) == NULL))
+    {
+        LogError("Cannot allocate the client sessions and links");
+        result = __LINE__;
+    }
+    else if ((client->socket_io = xio_create(socketio_get_interface_description(), &socketio_config)) == NULL)
+    {
+        LogError("Cannot create the client socket IO");
+        result = __LINE__;
+    }
+    else if ((client->connection = connection_create2(client->socket_io, config.host, "some", NULL, NULL,
+        on_client_connection_state_changed, client, on_client_io_error, client)) == NULL)
+    {
+        LogError("Cannot create client connection");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+
+        while ((result == 0) && (client->session_count < config.sessions_per_client))
+        {
+            SESSION_HANDLE session = session_create(client->connection, NULL, NULL);
+            size_t i;
+
+            if (session == NULL)
+            {
+                LogError("Cannot create client session");
+                result = __LINE__;
+            }
+            else
+            {
+                client->sessions[client->session_count++] = session;
+
+                for (i = 0; (result == 0) && (i < config.links_per_session); i++)
+                {
+                    result = create_client_link(client, session);
+                }
+            }
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_client(client);
+    }
+
+    return result;
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    uint64_t left_value = *(const uint64_t*)left;
+    uint64_t right_value = *(const uint64_t*)right;
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+static void print_attach_latencies(const CLIENT* clients, size_t client_count)
+{
+    size_t total_link_count = client_count * config.sessions_per_client * config.links_per_session;
+    uint64_t* latencies = (uint64_t*)malloc(sizeof(uint64_t) * total_link_count);
+
+    if (latencies == NULL)
+    {
+        LogError("Cannot allocate the attach latencies");
+    }
+    else
+    {
+        size_t latency_count = 0;
+        size_t i;
+        size_t j;
+
+        for (i = 0; i < client_count; i++)
+        {
+            for (j = 0; j < clients[i].link_count; j++)
+            {
+                if (clients[i].links[j].attach_latency_us != 0)
+                {
+                    latencies[latency_count++] = clients[i].links[j].attach_latency_us;
+                }
+            }
+        }
+
+        if (latency_count > 0)
+        {
+            qsort(latencies, latency_count, sizeof(uint64_t), compare_latencies);
+            (void)printf("attach latency ms: p50 %.2f, p90 %.2f, p99 %.2f, max %.2f (%u links)\n",
+                (double)latencies[latency_count / 2] / 1000.0,
+                (double)latencies[(latency_count * 9) / 10] / 1000.0,
+                (double)latencies[(latency_count * 99) / 100] / 1000.0,
+                (double)latencies[latency_count - 1] / 1000.0,
+                (unsigned int)latency_count);
+        }
+
+        free(latencies);
+    }
+}
+
+static void run_clients(CLIENT* clients, size_t client_count)
+{
+    size_t i;
+
+    for (i = 0; i < client_count; i++)
+    {
+        connection_dowork(clients[i].connection);
+    }
+}
+
+/* the server runs until the duration is over, printing a sample every interval */
+static void run_server_role(SOCKET_LISTENER_HANDLE socket_listener, const MEMORY_SNAPSHOT* baseline)
+{
+    uint64_t start_us = get_time_us();
+    uint64_t current_us = start_us;
+    uint64_t sample_us = start_us;
+    uint64_t sample_cpu_us = get_cpu_time_us();
+
+    (void)printf("%10s %12s %12s %22s %20s\n", "elapsed s", "connections", "links", "rss bytes/connection", "cpu us/s/connection");
+
+    while (current_us - start_us < config.server_duration_us)
+    {
+        run_server(socket_listener);
+        current_us = get_time_us();
+
+        if (current_us - sample_us >= config.sample_interval_us)
+        {
+            uint64_t cpu_us = get_cpu_time_us();
+            MEMORY_SNAPSHOT snapshot;
+
+            take_memory_snapshot(&snapshot);
+
+            if (server_stats.connection_count == 0)
+            {
+                (void)printf("%10.0f %12u %12u %22s %20s\n", (double)(current_us - start_us) / 1000000.0, 0U, 0U, "-", "-");
+            }
+            else
+            {
+                (void)printf("%10.0f %12u %12u %22.0f %20.2f\n", (double)(current_us - start_us) / 1000000.0,
+                    (unsigned int)server_stats.connection_count, (unsigned int)server_stats.attached_link_count,
+                    ((double)snapshot.rss_bytes - (double)baseline->rss_bytes) / (double)server_stats.connection_count,
+                    (double)(cpu_us - sample_cpu_us) * 1000000.0 / (double)(current_us - sample_us) / (double)server_stats.connection_count);
+            }
+
+            sample_us = current_us;
+            sample_cpu_us = cpu_us;
+        }
+    }
+
+    print_accept_rate();
+}
+
+/* starts the clients in batches, waits for every link to attach, keeps them idle, then tears them down */
+static int run_client_role(SOCKET_LISTENER_HANDLE socket_listener, const MEMORY_SNAPSHOT* baseline)
+{
+    int result;
+    CLIENT* clients = (CLIENT*)calloc(config.client_count, sizeof(CLIENT));
+
+    if (clients == NULL)
+    {
+        LogError("Cannot allocate the clients");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t links_per_client = config.sessions_per_client * config.links_per_session;
+        size_t total_link_count = config.client_count * links_per_client;
+        uint64_t start_us = get_time_us();
+        size_t i;
+
+        result = 0;
+
+        /* a failed client is not waited for */
+        while ((result == 0) &&
+            ((client_stats.started_count < config.client_count) || (client_stats.attached_link_count + (client_stats.failed_count * links_per_client) < total_link_count)) &&
+            (get_time_us() - start_us < config.attach_timeout_us))
+        {
+            /* one batch per pass, the accepts and handshakes of the previous batch get a turn in between */
+            for (i = 0; (result == 0) && (i < config.connect_batch) && (client_stats.started_count < config.client_count); i++)
+            {
+                if (create_client(&clients[client_stats.started_count]) != 0)
+                {
+                    result = __LINE__;
+                }
+                else
+                {
+                    client_stats.started_count++;
+                }
+            }
+
+            run_clients(clients, client_stats.started_count);
+
+            if (socket_listener != NULL)
+            {
+                run_server(socket_listener);
+            }
+        }
+
+        if (result == 0)
+        {
+            MEMORY_SNAPSHOT attached_snapshot;
+
+            take_memory_snapshot(&attached_snapshot);
+
+            (void)printf("%u clients x %u sessions x %u links: %u links attached, %u clients failed, in %.2f s\n",
+                (unsigned int)config.client_count, (unsigned int)config.sessions_per_client, (unsigned int)config.links_per_session,
+                (unsigned int)client_stats.attached_link_count, (unsigned int)client_stats.failed_count,
+                (double)(client_stats.last_attach_us - start_us) / 1000000.0);
+            if (socket_listener != NULL)
+            {
+                print_accept_rate();
+            }
+
+            print_attach_latencies(clients, client_stats.started_count);
+            print_memory_per_connection(baseline, &attached_snapshot, client_stats.started_count);
+
+            if (client_stats.attached_link_count < total_link_count)
+            {
+                LogError("Not all the links attached");
+                result = __LINE__;
+            }
+            else
+            {
+                uint64_t idle_start_us = get_time_us();
+                uint64_t idle_start_cpu_us = get_cpu_time_us();
+                uint64_t current_us;
+                uint64_t pass_count = 0;
+
+                /* nothing is sent, what is left is the cost of polling each connection */
+                do
+                {
+                    run_clients(clients, client_stats.started_count);
+
+                    if (socket_listener != NULL)
+                    {
+                        run_server(socket_listener);
+                    }
+
+                    pass_count++;
+                    current_us = get_time_us();
+                } while (current_us - idle_start_us < config.idle_duration_us);
+
+                (void)printf("idle: %.2f cpu us/s per connection, %.2f us per pass over all connections (%.0f passes/s)\n",
+                    (double)(get_cpu_time_us() - idle_start_cpu_us) * 1000000.0 / (double)(current_us - idle_start_us) / (double)config.client_count,
+                    (double)(current_us - idle_start_us) / (double)pass_count,
+                    (double)pass_count * 1000000.0 / (double)(current_us - idle_start_us));
+            }
+        }
+
+        for (i = 0; i < client_stats.started_count; i++)
+        {
+            destroy_client(&clients[i]);
+        }
+
+        free(clients);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        result = -1;
+    }
+    else if (platform_init() != 0)
+    {
+        LogError("platform_init failed");
+        result = -1;
+    }
+    else
+    {
+        SOCKET_LISTENER_HANDLE socket_listener = NULL;
+        MEMORY_SNAPSHOT baseline;
+
+        raise_open_file_limit();
+
+        if ((config.role != FANIN_ROLE_CLIENT) &&
+            (((server_connected_clients = singlylinkedlist_create()) == NULL) ||
+            ((socket_listener = socketlistener_create(config.port)) == NULL) ||
+            (socketlistener_start(socket_listener, on_socket_accepted, NULL) != 0)))
+        {
+            LogError("Cannot start the server");
+            result = -1;
+        }
+        else
+        {
+            take_memory_snapshot(&baseline);
+
+            if (config.role == FANIN_ROLE_SERVER)
+            {
+                run_server_role(socket_listener, &baseline);
+                result = 0;
+            }
+            else
+            {
+                result = (run_client_role(socket_listener, &baseline) == 0) ? 0 : -1;
+
+                if (socket_listener != NULL)
+                {
+                    uint64_t drain_start_us = get_time_us();
+
+                    /* let the server see the connections go */
+                    while ((singlylinkedlist_get_head_item(server_connected_clients) != NULL) &&
+                        (get_time_us() - drain_start_us < config.attach_timeout_us))
+                    {
+                        run_server(socket_listener);
+                    }
+                }
+            }
+        }
+
+        if (socket_listener != NULL)
+        {
+            (void)socketlistener_stop(socket_listener);
+            socketlistener_destroy(socket_listener);
+        }
+
+        if (server_connected_clients != NULL)
+        {
+            LIST_ITEM_HANDLE current_item;
+
+            while ((current_item = singlylinkedlist_get_head_item(server_connected_clients)) != NULL)
+            {
+                destroy_server_connected_client((SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item));
+                (void)singlylinkedlist_remove(server_connected_clients, current_item);
+            }
+
+            singlylinkedlist_destroy(server_connected_clients);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
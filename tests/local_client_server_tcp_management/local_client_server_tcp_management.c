@@ -0,0 +1,1108 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_uamqp_c/uamqp.h"
+
+/* Request/response throughput over one connection: a single amqp_management (or cbs) instance keeps a fixed number of
+   operations outstanding against a local responder built like local_server_sample, which answers every request on a
+   node with status 200 on the reply link of that node. Each concurrency level of the sweep is run in turn and reports
+   the operations per second and the latency percentiles from the start of an operation to its completion callback, so
+   that the cost of the correlation lookup and of the outstanding operations limit shows as the count grows. */
+
+#define MAX_CONCURRENCY_LEVELS 16
+#define MAX_NODES_PER_SESSION 4
+
+typedef enum BENCH_OPERATION_TAG
+{
+    BENCH_OPERATION_MANAGEMENT,
+    BENCH_OPERATION_CBS
+} BENCH_OPERATION;
+
+typedef struct MANAGEMENT_CONFIG_TAG
+{
+    BENCH_OPERATION operation;
+    size_t concurrency_levels[MAX_CONCURRENCY_LEVELS];
+    size_t concurrency_level_count;
+    /* 0 leaves the library without a limit */
+    size_t max_outstanding_operations;
+    uint64_t duration_us;
+    uint64_t warmup_us;
+    uint64_t drain_us;
+    int port;
+} MANAGEMENT_CONFIG;
+
+static MANAGEMENT_CONFIG config = { BENCH_OPERATION_MANAGEMENT, { 1, 4, 16, 64, 256, 1024 }, 6, 0, 5000000, 1000000, 5000000, 5677 };
+
+typedef struct OPERATION_CONTEXT_TAG
+{
+    uint64_t start_us;
+} OPERATION_CONTEXT;
+
+static SINGLYLINKEDLIST_HANDLE server_connected_clients;
+static uint32_t* latency_samples;
+static size_t latency_sample_count;
+static size_t latency_sample_capacity;
+static uint64_t measure_start_us;
+static uint64_t measure_end_us;
+static size_t outstanding_operation_count;
+static uint64_t total_operations_started;
+static uint64_t total_operations_completed;
+static uint64_t total_operations_failed;
+static uint64_t measured_operations_completed;
+static uint64_t total_requests_answered;
+static uint64_t total_instance_errors;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static void record_latency(uint64_t latency_us)
+{
+    if (latency_sample_count == latency_sample_capacity)
+    {
+        size_t new_capacity = (latency_sample_capacity == 0) ? 65536 : latency_sample_capacity * 2;
+        uint32_t* new_samples = (uint32_t*)realloc(latency_samples, sizeof(uint32_t) * new_capacity);
+        if (new_samples != NULL)
+        {
+            latency_samples = new_samples;
+            latency_sample_capacity = new_capacity;
+        }
+    }
+
+    /* a sample that does not fit is dropped, the percentiles are computed over the recorded ones */
+    if (latency_sample_count < latency_sample_capacity)
+    {
+        latency_samples[latency_sample_count++] = (latency_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency_us;
+    }
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    uint32_t left_value = *(const uint32_t*)left;
+    uint32_t right_value = *(const uint32_t*)right;
+    return (left_value > right_value) - (left_value < right_value);
+}
+
+static uint32_t get_percentile(double percentile)
+{
+    uint32_t result;
+
+    if (latency_sample_count == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t index = (size_t)(percentile * (double)(latency_sample_count - 1));
+        result = latency_samples[index];
+    }
+
+    return result;
+}
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s [options]\n"
+        "  --operation <management|cbs>   amqp_management_execute_operation_async or cbs_put_token_async (default management)\n"
+        "  --concurrency <list>           comma separated outstanding operation counts swept in turn (default 1,4,16,64,256,1024)\n"
+        "  --max-outstanding <count>      amqp_management_set_max_outstanding_operations, management only (default: no limit)\n"
+        "  --duration <ms>                time each concurrency level runs for (default 5000)\n"
+        "  --warmup <ms>                  time at the start of each level not recorded (default 1000)\n"
+        "  --drain <ms>                   most time waited for the operations outstanding at the end of a level (default 5000)\n"
+        "  --port <port>                  listening port (default 5677)\n",
+        program_name);
+}
+
+static int parse_concurrency_levels(const char* value)
+{
+    int result = 0;
+    const char* current = value;
+
+    config.concurrency_level_count = 0;
+    while ((result == 0) && (*current != '\0'))
+    {
+        char* end;
+        unsigned long level = strtoul(current, &end, 10);
+
+        if ((end == current) ||
+            (level == 0) ||
+            (config.concurrency_level_count == MAX_CONCURRENCY_LEVELS) ||
+            ((*end != ',') && (*end != '\0')))
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            config.concurrency_levels[config.concurrency_level_count++] = level;
+            current = (*end == ',') ? end + 1 : end;
+        }
+    }
+
+    if (config.concurrency_level_count == 0)
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned long number = (value == NULL) ? 0 : strtoul(value, NULL, 10);
+
+        if (value == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--operation") == 0)
+        {
+            if (strcmp(value, "management") == 0)
+            {
+                config.operation = BENCH_OPERATION_MANAGEMENT;
+            }
+            else if (strcmp(value, "cbs") == 0)
+            {
+                config.operation = BENCH_OPERATION_CBS;
+            }
+            else
+            {
+                result = __LINE__;
+            }
+        }
+        else if (strcmp(argv[i], "--concurrency") == 0)
+        {
+            result = parse_concurrency_levels(value);
+        }
+        else if (strcmp(argv[i], "--max-outstanding") == 0)
+        {
+            config.max_outstanding_operations = number;
+        }
+        else if (strcmp(argv[i], "--duration") == 0)
+        {
+            config.duration_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0)
+        {
+            config.warmup_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--drain") == 0)
+        {
+            config.drain_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--port") == 0)
+        {
+            config.port = (int)number;
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    if ((result == 0) &&
+        ((config.warmup_us >= config.duration_us) ||
+        ((config.operation == BENCH_OPERATION_CBS) && (config.max_outstanding_operations > 0))))
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+/* the request link and the reply link of one node, paired by the -sender and -receiver suffixes amqp_management
+   gives to its link names */
+typedef struct SERVER_NODE_TAG
+{
+    char name[64];
+    LINK_HANDLE request_link;
+    MESSAGE_RECEIVER_HANDLE message_receiver;
+    LINK_HANDLE reply_link;
+    MESSAGE_SENDER_HANDLE message_sender;
+} SERVER_NODE;
+
+typedef struct SERVER_CONNECTED_CLIENT_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    SERVER_NODE nodes[MAX_NODES_PER_SESSION];
+    size_t node_count;
+    XIO_HANDLE io;
+    XIO_HANDLE underlying_io;
+} SERVER_CONNECTED_CLIENT;
+
+static void on_message_receiver_state_changed(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state)
+{
+    (void)context;
+    (void)new_state;
+    (void)previous_state;
+}
+
+static int set_status_property(AMQP_VALUE map, const char* key_name, AMQP_VALUE value)
+{
+    int result;
+    AMQP_VALUE key = amqpvalue_create_string(key_name);
+
+    if ((key == NULL) ||
+        (value == NULL) ||
+        (amqpvalue_set_map_value(map, key, value) != 0))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (key != NULL)
+    {
+        amqpvalue_destroy(key);
+    }
+
+    return result;
+}
+
+/* the status under the keys of both amqp_management (statusCode) and cbs (status-code), so that one responder serves both */
+static MESSAGE_HANDLE create_response(AMQP_VALUE correlation_id)
+{
+    MESSAGE_HANDLE result = message_create();
+    PROPERTIES_HANDLE properties = properties_create();
+    AMQP_VALUE application_properties = amqpvalue_create_map();
+    AMQP_VALUE status_code = amqpvalue_create_int(200);
+    AMQP_VALUE status_description = amqpvalue_create_string("OK");
+
+    if ((result == NULL) ||
+        (properties == NULL) ||
+        (application_properties == NULL) ||
+        (properties_set_correlation_id(properties, correlation_id) != 0) ||
+        (set_status_property(application_properties, "statusCode", status_code) != 0) ||
+        (set_status_property(application_properties, "status-code", status_code) != 0) ||
+        (set_status_property(application_properties, "statusDescription", status_description) != 0) ||
+        (set_status_property(application_properties, "status-description", status_description) != 0) ||
+        (message_set_properties(result, properties) != 0) ||
+        (message_set_application_properties(result, application_properties) != 0))
+    {
+        LogError("Cannot create the response");
+        if (result != NULL)
+        {
+            message_destroy(result);
+            result = NULL;
+        }
+    }
+
+    if (status_description != NULL)
+    {
+        amqpvalue_destroy(status_description);
+    }
+
+    if (status_code != NULL)
+    {
+        amqpvalue_destroy(status_code);
+    }
+
+    if (application_properties != NULL)
+    {
+        amqpvalue_destroy(application_properties);
+    }
+
+    if (properties != NULL)
+    {
+        properties_destroy(properties);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE on_request_received(const void* context, MESSAGE_HANDLE message)
+{
+    SERVER_NODE* server_node = (SERVER_NODE*)context;
+    PROPERTIES_HANDLE properties;
+    AMQP_VALUE message_id;
+    AMQP_VALUE result;
+
+    if (server_node->message_sender == NULL)
+    {
+        LogError("Request received before the reply link of %s is attached", server_node->name);
+        result = messaging_delivery_released();
+    }
+    else if (message_get_properties(message, &properties) != 0)
+    {
+        LogError("Cannot get the request properties");
+        result = messaging_delivery_rejected("amqp:internal-error", "Cannot get the request properties");
+    }
+    else
+    {
+        if (properties_get_message_id(properties, &message_id) != 0)
+        {
+            LogError("Request without a message id");
+            result = messaging_delivery_rejected("amqp:invalid-field", "Request without a message id");
+        }
+        else
+        {
+            MESSAGE_HANDLE response = create_response(message_id);
+            if (response == NULL)
+            {
+                result = messaging_delivery_released();
+            }
+            else
+            {
+                if (messagesender_send_async(server_node->message_sender, response, NULL, NULL, 0) == NULL)
+                {
+                    LogError("Cannot send the response");
+                    result = messaging_delivery_released();
+                }
+                else
+                {
+                    total_requests_answered++;
+                    result = messaging_delivery_accepted();
+                }
+
+                message_destroy(response);
+            }
+        }
+
+        properties_destroy(properties);
+    }
+
+    return result;
+}
+
+static SERVER_NODE* get_server_node(SERVER_CONNECTED_CLIENT* server_connected_client, const char* link_name)
+{
+    SERVER_NODE* result = NULL;
+    const char* suffix = strrchr(link_name, '-');
+    size_t name_length = (suffix == NULL) ? strlen(link_name) : (size_t)(suffix - link_name);
+    size_t i;
+
+    if (name_length >= sizeof(server_connected_client->nodes[0].name))
+    {
+        LogError("Link name %s too long", link_name);
+    }
+    else
+    {
+        for (i = 0; (result == NULL) && (i < server_connected_client->node_count); i++)
+        {
+            if ((strncmp(server_connected_client->nodes[i].name, link_name, name_length) == 0) &&
+                (server_connected_client->nodes[i].name[name_length] == '\0'))
+            {
+                result = &server_connected_client->nodes[i];
+            }
+        }
+
+        if ((result == NULL) &&
+            (server_connected_client->node_count < MAX_NODES_PER_SESSION))
+        {
+            result = &server_connected_client->nodes[server_connected_client->node_count++];
+            (void)memcpy(result->name, link_name, name_length);
+            result->name[name_length] = '\0';
+        }
+    }
+
+    return result;
+}
+
+static bool attach_request_link(SERVER_NODE* server_node, LINK_HANDLE link)
+{
+    bool result;
+
+    /* the credit must not be what holds the operations back */
+    if ((link_set_rcv_settle_mode(link, receiver_settle_mode_first) != 0) ||
+        (link_set_max_link_credit(link, 10000) != 0))
+    {
+        LogError("Cannot set request link properties");
+        result = false;
+    }
+    else if ((server_node->message_receiver = messagereceiver_create(link, on_message_receiver_state_changed, NULL)) == NULL)
+    {
+        LogError("Cannot create message receiver");
+        result = false;
+    }
+    else if (messagereceiver_open(server_node->message_receiver, on_request_received, server_node) != 0)
+    {
+        LogError("Cannot open message receiver");
+        messagereceiver_destroy(server_node->message_receiver);
+        server_node->message_receiver = NULL;
+        result = false;
+    }
+    else
+    {
+        server_node->request_link = link;
+        result = true;
+    }
+
+    return result;
+}
+
+static bool attach_reply_link(SERVER_NODE* server_node, LINK_HANDLE link)
+{
+    bool result;
+
+    /* settled, the client has nothing to report on a response */
+    if (link_set_snd_settle_mode(link, sender_settle_mode_settled) != 0)
+    {
+        LogError("Cannot set reply link properties");
+        result = false;
+    }
+    else if ((server_node->message_sender = messagesender_create(link, NULL, NULL)) == NULL)
+    {
+        LogError("Cannot create message sender");
+        result = false;
+    }
+    else if (messagesender_open(server_node->message_sender) != 0)
+    {
+        LogError("Cannot open message sender");
+        messagesender_destroy(server_node->message_sender);
+        server_node->message_sender = NULL;
+        result = false;
+    }
+    else
+    {
+        server_node->reply_link = link;
+        result = true;
+    }
+
+    return result;
+}
+
+static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    SERVER_NODE* server_node = get_server_node(server_connected_client, name);
+    bool result;
+
+    /* role is the role of the peer, a sending peer attaches the request link of the node */
+    if ((server_node == NULL) ||
+        ((role == role_sender) && (server_node->request_link != NULL)) ||
+        ((role == role_receiver) && (server_node->reply_link != NULL)))
+    {
+        LogError("Unexpected link %s attached", name);
+        result = false;
+    }
+    else
+    {
+        LINK_HANDLE link = link_create_from_endpoint(server_connected_client->session, new_link_endpoint, name, role, source, target);
+        if (link == NULL)
+        {
+            LogError("Cannot create link");
+            result = false;
+        }
+        else
+        {
+            result = (role == role_sender) ? attach_request_link(server_node, link) : attach_reply_link(server_node, link);
+            if (!result)
+            {
+                link_destroy(link);
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    bool result;
+
+    server_connected_client->session = session_create_from_endpoint(server_connected_client->connection, new_endpoint, on_new_link_attached, server_connected_client);
+    if (server_connected_client->session == NULL)
+    {
+        LogError("Cannot create session");
+        result = false;
+    }
+    else if ((session_set_incoming_window(server_connected_client->session, 10000) != 0) ||
+        (session_begin(server_connected_client->session) != 0))
+    {
+        session_destroy(server_connected_client->session);
+        server_connected_client->session = NULL;
+        LogError("Cannot begin session");
+        result = false;
+    }
+    else
+    {
+        /* all OK */
+        result = true;
+    }
+
+    return result;
+}
+
+static void destroy_server_connected_client(SERVER_CONNECTED_CLIENT* server_connected_client)
+{
+    size_t i;
+
+    for (i = 0; i < server_connected_client->node_count; i++)
+    {
+        SERVER_NODE* server_node = &server_connected_client->nodes[i];
+
+        if (server_node->message_receiver != NULL)
+        {
+            messagereceiver_destroy(server_node->message_receiver);
+            link_destroy(server_node->request_link);
+        }
+
+        if (server_node->message_sender != NULL)
+        {
+            messagesender_destroy(server_node->message_sender);
+            link_destroy(server_node->reply_link);
+        }
+    }
+
+    if (server_connected_client->session != NULL)
+    {
+        session_destroy(server_connected_client->session);
+    }
+
+    if (server_connected_client->connection != NULL)
+    {
+        connection_destroy(server_connected_client->connection);
+    }
+
+    xio_destroy(server_connected_client->io);
+    /* the header detect io does not destroy the socket io under it */
+    xio_destroy(server_connected_client->underlying_io);
+    free(server_connected_client);
+}
+
+static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* interface_description, void* io_parameters)
+{
+    HEADER_DETECT_IO_CONFIG header_detect_io_config;
+    HEADER_DETECT_ENTRY header_detect_entries[1];
+    XIO_HANDLE underlying_io;
+    SERVER_CONNECTED_CLIENT* server_connected_client;
+
+    (void)context;
+
+    header_detect_entries[0].header = header_detect_io_get_amqp_header();
+    header_detect_entries[0].io_interface_description = NULL;
+
+    if ((underlying_io = xio_create(interface_description, io_parameters)) == NULL)
+    {
+        LogError("Cannot create accepted socket IO");
+    }
+    else if ((server_connected_client = (SERVER_CONNECTED_CLIENT*)calloc(1, sizeof(SERVER_CONNECTED_CLIENT))) == NULL)
+    {
+        LogError("Cannot allocate the server connected client");
+        xio_destroy(underlying_io);
+    }
+    else
+    {
+        header_detect_io_config.underlying_io = underlying_io;
+        header_detect_io_config.header_detect_entry_count = 1;
+        header_detect_io_config.header_detect_entries = header_detect_entries;
+
+        if ((server_connected_client->io = xio_create(header_detect_io_get_interface_description(), &header_detect_io_config)) == NULL)
+        {
+            LogError("Cannot create header detect IO");
+            free(server_connected_client);
+            xio_destroy(underlying_io);
+        }
+        else
+        {
+            server_connected_client->underlying_io = underlying_io;
+            server_connected_client->connection = connection_create(server_connected_client->io, NULL, "1", on_new_session_endpoint, server_connected_client);
+            if ((server_connected_client->connection == NULL) ||
+                (connection_listen(server_connected_client->connection) != 0) ||
+                (singlylinkedlist_add(server_connected_clients, server_connected_client) == NULL))
+            {
+                LogError("Cannot set up the server connection");
+                destroy_server_connected_client(server_connected_client);
+            }
+        }
+    }
+}
+
+typedef struct CLIENT_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    CBS_HANDLE cbs;
+    /* the body of the management requests, amqp_management clones it for each of them */
+    MESSAGE_HANDLE request;
+    XIO_HANDLE io;
+    bool is_open;
+    bool open_failed;
+} CLIENT;
+
+static void on_operation_complete(OPERATION_CONTEXT* operation_context, bool succeeded)
+{
+    uint64_t completed_us = get_time_us();
+
+    outstanding_operation_count--;
+    total_operations_completed++;
+
+    if (!succeeded)
+    {
+        total_operations_failed++;
+    }
+    else
+    {
+        /* the warm-up is judged on the start, an operation started after it counts however late it completes */
+        if (operation_context->start_us >= measure_start_us)
+        {
+            record_latency(completed_us - operation_context->start_us);
+        }
+
+        if ((completed_us >= measure_start_us) &&
+            (completed_us < measure_end_us))
+        {
+            measured_operations_completed++;
+        }
+    }
+
+    free(operation_context);
+}
+
+static void on_execute_operation_complete(void* context, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result, unsigned int status_code, const char* status_description, MESSAGE_HANDLE message_handle)
+{
+    (void)status_code;
+    (void)status_description;
+    (void)message_handle;
+
+    on_operation_complete((OPERATION_CONTEXT*)context, execute_operation_result == AMQP_MANAGEMENT_EXECUTE_OPERATION_OK);
+}
+
+static void on_put_token_complete(void* context, CBS_OPERATION_RESULT complete_result, unsigned int status_code, const char* status_description)
+{
+    (void)status_code;
+    (void)status_description;
+
+    on_operation_complete((OPERATION_CONTEXT*)context, complete_result == CBS_OPERATION_RESULT_OK);
+}
+
+static void on_amqp_management_open_complete(void* context, AMQP_MANAGEMENT_OPEN_RESULT open_result)
+{
+    CLIENT* client = (CLIENT*)context;
+
+    if (open_result == AMQP_MANAGEMENT_OPEN_OK)
+    {
+        client->is_open = true;
+    }
+    else
+    {
+        client->open_failed = true;
+    }
+}
+
+static void on_cbs_open_complete(void* context, CBS_OPEN_COMPLETE_RESULT open_complete_result)
+{
+    CLIENT* client = (CLIENT*)context;
+
+    if (open_complete_result == CBS_OPEN_OK)
+    {
+        client->is_open = true;
+    }
+    else
+    {
+        client->open_failed = true;
+    }
+}
+
+static void on_instance_error(void* context)
+{
+    (void)context;
+
+    total_instance_errors++;
+}
+
+static void destroy_client(CLIENT* client)
+{
+    /* the operations still outstanding complete as closed and free their contexts */
+    if (client->amqp_management != NULL)
+    {
+        amqp_management_destroy(client->amqp_management);
+    }
+
+    if (client->cbs != NULL)
+    {
+        cbs_destroy(client->cbs);
+    }
+
+    if (client->request != NULL)
+    {
+        message_destroy(client->request);
+    }
+
+    if (client->session != NULL)
+    {
+        session_destroy(client->session);
+    }
+
+    if (client->connection != NULL)
+    {
+        connection_destroy(client->connection);
+    }
+
+    if (client->io != NULL)
+    {
+        xio_destroy(client->io);
+    }
+}
+
+static int create_client(CLIENT* client)
+{
+    int result;
+    SOCKETIO_CONFIG socketio_config = { "localhost", 0, NULL };
+
+    socketio_config.port = config.port;
+
+    (void)memset(client, 0, sizeof(CLIENT));
+    client->io = xio_create(socketio_get_interface_description(), &socketio_config);
+    if (client->io == NULL)
+    {
+        LogError("Cannot create client IO");
+        result = __LINE__;
+    }
+    else if ((client->connection = connection_create(client->io, "localhost", "some", NULL, NULL)) == NULL)
+    {
+        LogError("Cannot create client connection");
+        result = __LINE__;
+    }
+    else if (((client->session = session_create(client->connection, NULL, NULL)) == NULL) ||
+        (session_set_incoming_window(client->session, 10000) != 0) ||
+        (session_set_outgoing_window(client->session, 10000) != 0))
+    {
+        LogError("Cannot create client session");
+        result = __LINE__;
+    }
+    else if (config.operation == BENCH_OPERATION_CBS)
+    {
+        if (((client->cbs = cbs_create(client->session)) == NULL) ||
+            (cbs_open_async(client->cbs, on_cbs_open_complete, client, on_instance_error, client) != 0))
+        {
+            LogError("Cannot open cbs");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else
+    {
+        AMQP_VALUE request_body = amqpvalue_create_null();
+
+        if ((request_body == NULL) ||
+            ((client->request = message_create()) == NULL) ||
+            (message_set_body_amqp_value(client->request, request_body) != 0))
+        {
+            LogError("Cannot create the request message");
+            result = __LINE__;
+        }
+        else if (((client->amqp_management = amqp_management_create(client->session, "$management")) == NULL) ||
+            ((config.max_outstanding_operations > 0) &&
+            (amqp_management_set_max_outstanding_operations(client->amqp_management, config.max_outstanding_operations) != 0)) ||
+            (amqp_management_open_async(client->amqp_management, on_amqp_management_open_complete, client, on_instance_error, client) != 0))
+        {
+            LogError("Cannot open amqp management");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if (request_body != NULL)
+        {
+            amqpvalue_destroy(request_body);
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_client(client);
+    }
+
+    return result;
+}
+
+static int start_operation(CLIENT* client)
+{
+    int result;
+    OPERATION_CONTEXT* operation_context = (OPERATION_CONTEXT*)malloc(sizeof(OPERATION_CONTEXT));
+
+    if (operation_context == NULL)
+    {
+        LogError("Cannot allocate the operation context");
+        result = __LINE__;
+    }
+    else
+    {
+        int start_result;
+
+        operation_context->start_us = get_time_us();
+        outstanding_operation_count++;
+
+        if (config.operation == BENCH_OPERATION_CBS)
+        {
+            start_result = cbs_put_token_async(client->cbs, "servicebus.windows.net:sastoken", "sb://localhost/bench",
+                "SharedAccessSignature sr=sb%3a%2f%2flocalhost%2fbench&sig=bench&se=4102444800&skn=bench",
+                on_put_token_complete, operation_context);
+        }
+        else
+        {
+            start_result = amqp_management_execute_operation_async(client->amqp_management, "READ", "com.microsoft:bench", NULL, client->request,
+                on_execute_operation_complete, operation_context);
+        }
+
+        if (start_result != 0)
+        {
+            LogError("Cannot start the operation");
+            outstanding_operation_count--;
+            free(operation_context);
+            result = __LINE__;
+        }
+        else
+        {
+            total_operations_started++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void run_connections(SOCKET_LISTENER_HANDLE socket_listener, CLIENT* client)
+{
+    LIST_ITEM_HANDLE current_item;
+
+    socketlistener_dowork(socket_listener);
+    connection_dowork(client->connection);
+
+    current_item = singlylinkedlist_get_head_item(server_connected_clients);
+    while (current_item != NULL)
+    {
+        SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
+        connection_dowork(server_connected_client->connection);
+        current_item = singlylinkedlist_get_next_item(current_item);
+    }
+}
+
+static int wait_for_open(SOCKET_LISTENER_HANDLE socket_listener, CLIENT* client)
+{
+    int result;
+    uint64_t start_us = get_time_us();
+
+    while (!client->is_open &&
+        !client->open_failed &&
+        (get_time_us() - start_us < config.drain_us))
+    {
+        run_connections(socket_listener, client);
+    }
+
+    if (!client->is_open)
+    {
+        LogError("The %s links did not attach", (config.operation == BENCH_OPERATION_CBS) ? "cbs" : "management");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* operations are started from the loop, not from the completion callbacks, so that every level keeps exactly its count
+   outstanding without starting operations from inside the library's callbacks */
+static int run_level(SOCKET_LISTENER_HANDLE socket_listener, CLIENT* client, size_t concurrency)
+{
+    int result = 0;
+    uint64_t start_us = get_time_us();
+    uint64_t current_us = start_us;
+    uint64_t drain_end_us;
+
+    latency_sample_count = 0;
+    measured_operations_completed = 0;
+    total_operations_started = 0;
+    total_operations_completed = 0;
+    total_operations_failed = 0;
+    measure_start_us = start_us + config.warmup_us;
+    measure_end_us = start_us + config.duration_us;
+
+    while ((result == 0) && (current_us < measure_end_us))
+    {
+        while ((result == 0) && (outstanding_operation_count < concurrency))
+        {
+            result = start_operation(client);
+        }
+
+        run_connections(socket_listener, client);
+        current_us = get_time_us();
+    }
+
+    /* the operations of this level must not be counted by the next one */
+    drain_end_us = current_us + config.drain_us;
+    while ((result == 0) &&
+        (outstanding_operation_count > 0) &&
+        (current_us < drain_end_us))
+    {
+        run_connections(socket_listener, client);
+        current_us = get_time_us();
+    }
+
+    if ((result == 0) &&
+        (outstanding_operation_count > 0))
+    {
+        LogError("%u operations still outstanding after the drain", (unsigned int)outstanding_operation_count);
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+static void print_level_report(size_t concurrency)
+{
+    double measured_seconds = (double)(config.duration_us - config.warmup_us) / 1000000.0;
+
+    qsort(latency_samples, latency_sample_count, sizeof(uint32_t), compare_latencies);
+    (void)printf("%10u %12.0f %12llu %8llu %10u %10u %10u %10u %10u\n",
+        (unsigned int)concurrency, (double)measured_operations_completed / measured_seconds,
+        (unsigned long long)total_operations_completed, (unsigned long long)total_operations_failed,
+        (unsigned int)get_percentile(0.5), (unsigned int)get_percentile(0.9), (unsigned int)get_percentile(0.99),
+        (unsigned int)get_percentile(0.999), (unsigned int)get_percentile(1.0));
+}
+
+static int run_sweep(SOCKET_LISTENER_HANDLE socket_listener, CLIENT* client)
+{
+    int result = 0;
+    size_t i;
+
+    (void)printf("operation=%s max_outstanding=%u duration=%ums warmup=%ums\n",
+        (config.operation == BENCH_OPERATION_CBS) ? "cbs_put_token_async" : "amqp_management_execute_operation_async",
+        (unsigned int)config.max_outstanding_operations,
+        (unsigned int)(config.duration_us / 1000), (unsigned int)(config.warmup_us / 1000));
+    (void)printf("%10s %12s %12s %8s %10s %10s %10s %10s %10s\n",
+        "concurrent", "ops/s", "completed", "failed", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+
+    for (i = 0; (result == 0) && (i < config.concurrency_level_count); i++)
+    {
+        result = run_level(socket_listener, client, config.concurrency_levels[i]);
+        if (result == 0)
+        {
+            print_level_report(config.concurrency_levels[i]);
+        }
+    }
+
+    (void)printf("requests answered %llu, instance errors %llu\n",
+        (unsigned long long)total_requests_answered, (unsigned long long)total_instance_errors);
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        result = -1;
+    }
+    else if (platform_init() != 0)
+    {
+        LogError("platform_init failed");
+        result = -1;
+    }
+    else
+    {
+        if ((server_connected_clients = singlylinkedlist_create()) == NULL)
+        {
+            LogError("Cannot create server connected clients list");
+            result = -1;
+        }
+        else
+        {
+            LIST_ITEM_HANDLE current_item;
+            SOCKET_LISTENER_HANDLE socket_listener = socketlistener_create(config.port);
+
+            if (socket_listener == NULL)
+            {
+                LogError("Cannot create socket listener");
+                result = -1;
+            }
+            else
+            {
+                if (socketlistener_start(socket_listener, on_socket_accepted, NULL) != 0)
+                {
+                    LogError("socketlistener_start failed");
+                    result = -1;
+                }
+                else
+                {
+                    CLIENT client;
+
+                    if (create_client(&client) != 0)
+                    {
+                        LogError("Cannot create the client");
+                        result = -1;
+                    }
+                    else
+                    {
+                        if ((wait_for_open(socket_listener, &client) != 0) ||
+                            (run_sweep(socket_listener, &client) != 0))
+                        {
+                            result = -1;
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
+
+                        destroy_client(&client);
+                    }
+
+                    (void)socketlistener_stop(socket_listener);
+                }
+
+                socketlistener_destroy(socket_listener);
+            }
+
+            current_item = singlylinkedlist_get_head_item(server_connected_clients);
+            while (current_item != NULL)
+            {
+                destroy_server_connected_client((SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item));
+                (void)singlylinkedlist_remove(server_connected_clients, current_item);
+                current_item = singlylinkedlist_get_head_item(server_connected_clients);
+            }
+
+            singlylinkedlist_destroy(server_connected_clients);
+        }
+
+        free(latency_samples);
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,1112 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_uamqp_c/uamqp.h"
+
+/* Open loop load generator: messages are sent on a fixed schedule whatever the state of the connection, and the latency
+   of each is taken from the time it was due to be sent to the time its settlement is indicated, so that a stall shows in
+   the latency of every message that should have gone out during it (no coordinated omission). The latency from the
+   actual send is kept too, it is what a closed loop generator such as local_client_server_tcp_perf reports. Both are
+   recorded in HDR histograms and can be written in the .hgrm percentile distribution format. */
+
+/* the schedule never sends more than this per pass of the loop, so that the connections keep being worked when behind */
+#define MAX_SENDS_PER_PASS 1000
+
+typedef struct OPENLOOP_CONFIG_TAG
+{
+    size_t client_count;
+    size_t links_per_session;
+    size_t message_size;
+    double rate;
+    uint32_t session_window;
+    uint32_t max_frame_size;
+    /* 0 leaves the defaults */
+    uint32_t outgoing_batch_size;
+    milliseconds outgoing_batch_delay;
+    uint32_t disposition_batch_size;
+    tickcounter_ms_t disposition_batch_delay;
+    uint64_t duration_us;
+    uint64_t warmup_us;
+    uint64_t drain_us;
+    int port;
+    const char* hgrm_path;
+} OPENLOOP_CONFIG;
+
+static OPENLOOP_CONFIG config = { 1, 1, 256, 10000, 100, 65536, 0, 0, 0, 0, 10000000, 1000000, 5000000, 5674, NULL };
+
+/* values in microseconds from 1 us to an hour with 3 significant digits, as an HdrHistogram would keep them */
+#define HDR_SIGNIFICANT_DIGITS 3
+#define HDR_HIGHEST_TRACKABLE_VALUE 3600000000ULL
+
+typedef struct HDR_HISTOGRAM_TAG
+{
+    int sub_bucket_half_count_magnitude;
+    uint64_t sub_bucket_count;
+    uint64_t sub_bucket_half_count;
+    uint64_t sub_bucket_mask;
+    int bucket_count;
+    size_t counts_length;
+    uint64_t* counts;
+    uint64_t total_count;
+    uint64_t max_value;
+} HDR_HISTOGRAM;
+
+typedef struct SEND_CONTEXT_TAG
+{
+    uint64_t intended_send_us;
+    uint64_t actual_send_us;
+} SEND_CONTEXT;
+
+static SINGLYLINKEDLIST_HANDLE server_connected_clients;
+static HDR_HISTOGRAM corrected_histogram;
+static HDR_HISTOGRAM uncorrected_histogram;
+static uint64_t measure_start_us;
+static uint64_t total_messages_sent;
+static uint64_t total_messages_settled;
+static uint64_t total_messages_failed;
+static uint64_t total_messages_received;
+static uint64_t max_schedule_lag_us;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static int get_highest_bit(uint64_t value)
+{
+    int result = -1;
+
+    while (value != 0)
+    {
+        value >>= 1;
+        result++;
+    }
+
+    return result;
+}
+
+static int hdr_histogram_init(HDR_HISTOGRAM* histogram)
+{
+    int result;
+    uint64_t largest_value_with_single_unit_resolution = 2;
+    uint64_t smallest_untrackable_value;
+    int i;
+
+    for (i = 0; i < HDR_SIGNIFICANT_DIGITS; i++)
+    {
+        largest_value_with_single_unit_resolution *= 10;
+    }
+
+    /* sub buckets are a power of 2 big enough to tell apart values that differ in the last significant digit */
+    histogram->sub_bucket_half_count_magnitude = get_highest_bit(largest_value_with_single_unit_resolution - 1);
+    histogram->sub_bucket_count = (uint64_t)1 << (histogram->sub_bucket_half_count_magnitude + 1);
+    histogram->sub_bucket_half_count = histogram->sub_bucket_count / 2;
+    histogram->sub_bucket_mask = histogram->sub_bucket_count - 1;
+
+    histogram->bucket_count = 1;
+    smallest_untrackable_value = histogram->sub_bucket_count;
+    while (smallest_untrackable_value <= HDR_HIGHEST_TRACKABLE_VALUE)
+    {
+        smallest_untrackable_value <<= 1;
+        histogram->bucket_count++;
+    }
+
+    histogram->counts_length = (size_t)((histogram->bucket_count + 1) * histogram->sub_bucket_half_count);
+    histogram->counts = (uint64_t*)calloc(histogram->counts_length, sizeof(uint64_t));
+    histogram->total_count = 0;
+    histogram->max_value = 0;
+
+    if (histogram->counts == NULL)
+    {
+        LogError("Cannot allocate the histogram counts");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static size_t hdr_histogram_get_index(const HDR_HISTOGRAM* histogram, uint64_t value)
+{
+    int bucket_index = get_highest_bit(value | histogram->sub_bucket_mask) - histogram->sub_bucket_half_count_magnitude;
+    uint64_t sub_bucket_index = value >> bucket_index;
+
+    return (size_t)((((uint64_t)bucket_index + 1) << histogram->sub_bucket_half_count_magnitude) + (sub_bucket_index - histogram->sub_bucket_half_count));
+}
+
+/* the lowest value counted at an index, and the number of values counted there */
+static uint64_t hdr_histogram_get_value_at_index(const HDR_HISTOGRAM* histogram, size_t index, uint64_t* range_size)
+{
+    int bucket_index = (int)(index >> histogram->sub_bucket_half_count_magnitude) - 1;
+    uint64_t sub_bucket_index = (index & (histogram->sub_bucket_half_count - 1)) + histogram->sub_bucket_half_count;
+
+    if (bucket_index < 0)
+    {
+        sub_bucket_index -= histogram->sub_bucket_half_count;
+        bucket_index = 0;
+    }
+
+    *range_size = (uint64_t)1 << bucket_index;
+    return sub_bucket_index << bucket_index;
+}
+
+static void hdr_histogram_record(HDR_HISTOGRAM* histogram, uint64_t value)
+{
+    if (value > HDR_HIGHEST_TRACKABLE_VALUE)
+    {
+        value = HDR_HIGHEST_TRACKABLE_VALUE;
+    }
+
+    histogram->counts[hdr_histogram_get_index(histogram, value)]++;
+    histogram->total_count++;
+    if (value > histogram->max_value)
+    {
+        histogram->max_value = value;
+    }
+}
+
+/* the highest value counted with the lowest value at or above the given fraction of the total count */
+static uint64_t hdr_histogram_get_percentile(const HDR_HISTOGRAM* histogram, double percentile)
+{
+    uint64_t result = 0;
+    uint64_t count_at_percentile = (uint64_t)ceil(percentile * (double)histogram->total_count);
+    uint64_t cumulative_count = 0;
+    size_t i;
+
+    if (count_at_percentile == 0)
+    {
+        count_at_percentile = 1;
+    }
+
+    for (i = 0; (i < histogram->counts_length) && (cumulative_count < count_at_percentile); i++)
+    {
+        cumulative_count += histogram->counts[i];
+        if (cumulative_count >= count_at_percentile)
+        {
+            uint64_t range_size;
+            uint64_t value = hdr_histogram_get_value_at_index(histogram, i, &range_size);
+            result = value + range_size - 1;
+        }
+    }
+
+    return (result > histogram->max_value) ? histogram->max_value : result;
+}
+
+/* same layout as HdrHistogram's outputPercentileDistribution with 5 ticks per half distance, so that the files can be
+   fed to the HdrHistogram plotter */
+static void hdr_histogram_write_percentiles(const HDR_HISTOGRAM* histogram, FILE* file)
+{
+    uint64_t cumulative_count = 0;
+    double percentile_to_report = 0;
+    double sum = 0;
+    double sum_of_squares = 0;
+    double mean;
+    bool is_done = (histogram->total_count == 0);
+    size_t i;
+
+    (void)fprintf(file, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+    for (i = 0; i < histogram->counts_length; i++)
+    {
+        if (histogram->counts[i] > 0)
+        {
+            uint64_t range_size;
+            uint64_t value = hdr_histogram_get_value_at_index(histogram, i, &range_size);
+            double middle_value = (double)value + ((double)range_size / 2);
+            uint64_t highest_equivalent_value = (value + range_size - 1 > histogram->max_value) ? histogram->max_value : value + range_size - 1;
+
+            cumulative_count += histogram->counts[i];
+            sum += middle_value * (double)histogram->counts[i];
+
+            while (!is_done &&
+                ((double)cumulative_count >= (percentile_to_report / 100.0) * (double)histogram->total_count))
+            {
+                if (cumulative_count == histogram->total_count)
+                {
+                    (void)fprintf(file, "%12.3f %2.12f %10llu\n", (double)highest_equivalent_value, 1.0, (unsigned long long)cumulative_count);
+                    is_done = true;
+                }
+                else
+                {
+                    double half_distance = pow(2, floor(log(100.0 / (100.0 - percentile_to_report)) / log(2)) + 1);
+
+                    (void)fprintf(file, "%12.3f %2.12f %10llu %14.2f\n", (double)highest_equivalent_value, percentile_to_report / 100.0,
+                        (unsigned long long)cumulative_count, 1.0 / (1.0 - (percentile_to_report / 100.0)));
+                    percentile_to_report += 100.0 / (5 * half_distance);
+                }
+            }
+        }
+    }
+
+    mean = (histogram->total_count == 0) ? 0 : sum / (double)histogram->total_count;
+    for (i = 0; i < histogram->counts_length; i++)
+    {
+        if (histogram->counts[i] > 0)
+        {
+            uint64_t range_size;
+            double deviation = (double)hdr_histogram_get_value_at_index(histogram, i, &range_size) + ((double)range_size / 2) - mean;
+            sum_of_squares += deviation * deviation * (double)histogram->counts[i];
+        }
+    }
+
+    (void)fprintf(file, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean,
+        (histogram->total_count == 0) ? 0 : sqrt(sum_of_squares / (double)histogram->total_count));
+    (void)fprintf(file, "#[Max     = %12.3f, Total count    = %12llu]\n", (double)histogram->max_value, (unsigned long long)histogram->total_count);
+    (void)fprintf(file, "#[Buckets = %12d, SubBuckets     = %12llu]\n", histogram->bucket_count, (unsigned long long)histogram->sub_bucket_count);
+}
+
+static int write_hgrm_file(const HDR_HISTOGRAM* histogram, const char* suffix)
+{
+    int result;
+    size_t path_length = strlen(config.hgrm_path) + strlen(suffix) + 1;
+    char* path = (char*)malloc(path_length);
+
+    if (path == NULL)
+    {
+        LogError("Cannot allocate the histogram file name");
+        result = __LINE__;
+    }
+    else
+    {
+        FILE* file;
+
+        (void)sprintf(path, "%s%s", config.hgrm_path, suffix);
+        file = fopen(path, "w");
+        if (file == NULL)
+        {
+            LogError("Cannot open %s", path);
+            result = __LINE__;
+        }
+        else
+        {
+            hdr_histogram_write_percentiles(histogram, file);
+            (void)fclose(file);
+            result = 0;
+        }
+
+        free(path);
+    }
+
+    return result;
+}
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s [options]\n"
+        "  --clients <count>              client connections (default 1)\n"
+        "  --links <count>                sender links per client session (default 1)\n"
+        "  --message-size <bytes>         body size of each message (default 256)\n"
+        "  --rate <messages/s>            scheduled send rate over all links (default 10000)\n"
+        "  --session-window <count>       session incoming window on the server (default 100)\n"
+        "  --frame-size <bytes>           max frame size on both ends (default 65536)\n"
+        "  --batch-size <frames>          outgoing batch size of both connections (default: library default)\n"
+        "  --batch-delay <ms>             outgoing batch delay of both connections (default: library default)\n"
+        "  --disposition-batch <count>    dispositions batched by the server links (default: none)\n"
+        "  --disposition-delay <ms>       most a batched disposition is held (default 0)\n"
+        "  --duration <ms>                time messages are scheduled for (default 10000)\n"
+        "  --warmup <ms>                  time at the start not recorded (default 1000)\n"
+        "  --drain <ms>                   most time waited for the last settlements (default 5000)\n"
+        "  --port <port>                  listening port (default 5674)\n"
+        "  --hgrm <path prefix>           writes <prefix>.corrected.hgrm and <prefix>.uncorrected.hgrm\n",
+        program_name);
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned long number = (value == NULL) ? 0 : strtoul(value, NULL, 10);
+
+        if (value == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--clients") == 0)
+        {
+            config.client_count = number;
+        }
+        else if (strcmp(argv[i], "--links") == 0)
+        {
+            config.links_per_session = number;
+        }
+        else if (strcmp(argv[i], "--message-size") == 0)
+        {
+            config.message_size = number;
+        }
+        else if (strcmp(argv[i], "--rate") == 0)
+        {
+            config.rate = strtod(value, NULL);
+        }
+        else if (strcmp(argv[i], "--session-window") == 0)
+        {
+            config.session_window = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--frame-size") == 0)
+        {
+            config.max_frame_size = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--batch-size") == 0)
+        {
+            config.outgoing_batch_size = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--batch-delay") == 0)
+        {
+            config.outgoing_batch_delay = (milliseconds)number;
+        }
+        else if (strcmp(argv[i], "--disposition-batch") == 0)
+        {
+            config.disposition_batch_size = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--disposition-delay") == 0)
+        {
+            config.disposition_batch_delay = number;
+        }
+        else if (strcmp(argv[i], "--duration") == 0)
+        {
+            config.duration_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0)
+        {
+            config.warmup_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--drain") == 0)
+        {
+            config.drain_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--port") == 0)
+        {
+            config.port = (int)number;
+        }
+        else if (strcmp(argv[i], "--hgrm") == 0)
+        {
+            config.hgrm_path = value;
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    if ((result == 0) &&
+        ((config.client_count == 0) ||
+        (config.links_per_session == 0) ||
+        (config.message_size == 0) ||
+        (config.rate <= 0) ||
+        (config.session_window == 0) ||
+        (config.max_frame_size < 512) ||
+        (config.warmup_us >= config.duration_us)))
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+typedef struct SERVER_CONNECTED_CLIENT_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    LINK_HANDLE* links;
+    MESSAGE_RECEIVER_HANDLE* message_receivers;
+    size_t link_count;
+    XIO_HANDLE io;
+    XIO_HANDLE underlying_io;
+} SERVER_CONNECTED_CLIENT;
+
+static void on_message_receiver_state_changed(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state)
+{
+    (void)context;
+    (void)new_state;
+    (void)previous_state;
+}
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    (void)context;
+    (void)message;
+
+    total_messages_received++;
+
+    return messaging_delivery_accepted();
+}
+
+static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    bool result;
+
+    if (server_connected_client->link_count == config.links_per_session)
+    {
+        LogError("Too many links attached");
+        result = false;
+    }
+    else
+    {
+        LINK_HANDLE link = link_create_from_endpoint(server_connected_client->session, new_link_endpoint, name, role, source, target);
+        if (link == NULL)
+        {
+            LogError("Cannot create link");
+            result = false;
+        }
+        else if ((link_set_rcv_settle_mode(link, receiver_settle_mode_first) != 0) ||
+            /* the credit must not be what holds the schedule back */
+            (link_set_max_link_credit(link, 10000) != 0) ||
+            ((config.disposition_batch_size > 0) &&
+            (link_set_disposition_batching(link, config.disposition_batch_size, config.disposition_batch_delay) != 0)))
+        {
+            link_destroy(link);
+            LogError("Cannot set link properties");
+            result = false;
+        }
+        else
+        {
+            MESSAGE_RECEIVER_HANDLE message_receiver = messagereceiver_create(link, on_message_receiver_state_changed, NULL);
+            if (message_receiver == NULL)
+            {
+                link_destroy(link);
+                LogError("Cannot create message receiver");
+                result = false;
+            }
+            else if (messagereceiver_open(message_receiver, on_message_received, NULL) != 0)
+            {
+                messagereceiver_destroy(message_receiver);
+                link_destroy(link);
+                LogError("Cannot open message receiver");
+                result = false;
+            }
+            else
+            {
+                /* all OK */
+                server_connected_client->links[server_connected_client->link_count] = link;
+                server_connected_client->message_receivers[server_connected_client->link_count] = message_receiver;
+                server_connected_client->link_count++;
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    bool result;
+
+    server_connected_client->session = session_create_from_endpoint(server_connected_client->connection, new_endpoint, on_new_link_attached, server_connected_client);
+    if (server_connected_client->session == NULL)
+    {
+        LogError("Cannot create session");
+        result = false;
+    }
+    else if ((session_set_incoming_window(server_connected_client->session, config.session_window) != 0) ||
+        (session_begin(server_connected_client->session) != 0))
+    {
+        session_destroy(server_connected_client->session);
+        server_connected_client->session = NULL;
+        LogError("Cannot begin session");
+        result = false;
+    }
+    else
+    {
+        /* all OK */
+        result = true;
+    }
+
+    return result;
+}
+
+static int set_connection_options(CONNECTION_HANDLE connection)
+{
+    int result;
+
+    if ((connection_set_max_frame_size(connection, config.max_frame_size) != 0) ||
+        ((config.outgoing_batch_size > 0) &&
+        (connection_set_outgoing_batch_size(connection, config.outgoing_batch_size) != 0)) ||
+        ((config.outgoing_batch_delay > 0) &&
+        (connection_set_outgoing_batch_delay(connection, config.outgoing_batch_delay) != 0)))
+    {
+        LogError("Cannot set connection options");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void destroy_server_connected_client(SERVER_CONNECTED_CLIENT* server_connected_client)
+{
+    size_t i;
+
+    for (i = 0; i < server_connected_client->link_count; i++)
+    {
+        messagereceiver_destroy(server_connected_client->message_receivers[i]);
+        link_destroy(server_connected_client->links[i]);
+    }
+
+    if (server_connected_client->session != NULL)
+    {
+        session_destroy(server_connected_client->session);
+    }
+
+    if (server_connected_client->connection != NULL)
+    {
+        connection_destroy(server_connected_client->connection);
+    }
+
+    xio_destroy(server_connected_client->io);
+    /* the header detect io does not destroy the socket io under it */
+    xio_destroy(server_connected_client->underlying_io);
+    free(server_connected_client->links);
+    free(server_connected_client->message_receivers);
+    free(server_connected_client);
+}
+
+static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* interface_description, void* io_parameters)
+{
+    HEADER_DETECT_IO_CONFIG header_detect_io_config;
+    HEADER_DETECT_ENTRY header_detect_entries[1];
+    XIO_HANDLE underlying_io;
+    SERVER_CONNECTED_CLIENT* server_connected_client;
+
+    (void)context;
+
+    header_detect_entries[0].header = header_detect_io_get_amqp_header();
+    header_detect_entries[0].io_interface_description = NULL;
+
+    if ((underlying_io = xio_create(interface_description, io_parameters)) == NULL)
+    {
+        LogError("Cannot create accepted socket IO");
+    }
+    else if ((server_connected_client = (SERVER_CONNECTED_CLIENT*)calloc(1, sizeof(SERVER_CONNECTED_CLIENT))) == NULL)
+    {
+        LogError("Cannot allocate the server connected client");
+        xio_destroy(underlying_io);
+    }
+    else
+    {
+        header_detect_io_config.underlying_io = underlying_io;
+        header_detect_io_config.header_detect_entry_count = 1;
+        header_detect_io_config.header_detect_entries = header_detect_entries;
+
+        if ((server_connected_client->io = xio_create(header_detect_io_get_interface_description(), &header_detect_io_config)) == NULL)
+        {
+            LogError("Cannot create header detect IO");
+            free(server_connected_client);
+            xio_destroy(underlying_io);
+        }
+        else
+        {
+            server_connected_client->underlying_io = underlying_io;
+            server_connected_client->links = (LINK_HANDLE*)calloc(config.links_per_session, sizeof(LINK_HANDLE));
+            server_connected_client->message_receivers = (MESSAGE_RECEIVER_HANDLE*)calloc(config.links_per_session, sizeof(MESSAGE_RECEIVER_HANDLE));
+            server_connected_client->connection = connection_create(server_connected_client->io, NULL, "1", on_new_session_endpoint, server_connected_client);
+            if ((server_connected_client->links == NULL) ||
+                (server_connected_client->message_receivers == NULL) ||
+                (server_connected_client->connection == NULL) ||
+                (set_connection_options(server_connected_client->connection) != 0) ||
+                (connection_listen(server_connected_client->connection) != 0) ||
+                (singlylinkedlist_add(server_connected_clients, server_connected_client) == NULL))
+            {
+                LogError("Cannot set up the server connection");
+                destroy_server_connected_client(server_connected_client);
+            }
+        }
+    }
+}
+
+typedef struct CLIENT_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_SENDER_HANDLE message_sender;
+} CLIENT_LINK;
+
+typedef struct CLIENT_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    CLIENT_LINK* links;
+    size_t link_count;
+    XIO_HANDLE io;
+} CLIENT;
+
+static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+{
+    SEND_CONTEXT* send_context = (SEND_CONTEXT*)context;
+
+    if (send_result != MESSAGE_SEND_OK)
+    {
+        total_messages_failed++;
+    }
+    else
+    {
+        uint64_t settled_us = get_time_us();
+
+        total_messages_settled++;
+
+        /* the warm-up is judged on the schedule, a message due after it counts however late it went out */
+        if (send_context->intended_send_us >= measure_start_us)
+        {
+            hdr_histogram_record(&corrected_histogram, settled_us - send_context->intended_send_us);
+            hdr_histogram_record(&uncorrected_histogram, settled_us - send_context->actual_send_us);
+        }
+    }
+
+    free(send_context);
+}
+
+static void destroy_client(CLIENT* client)
+{
+    size_t i;
+
+    for (i = 0; i < client->link_count; i++)
+    {
+        messagesender_destroy(client->links[i].message_sender);
+        link_destroy(client->links[i].link);
+    }
+
+    free(client->links);
+
+    if (client->session != NULL)
+    {
+        session_destroy(client->session);
+    }
+
+    if (client->connection != NULL)
+    {
+        connection_destroy(client->connection);
+    }
+
+    if (client->io != NULL)
+    {
+        xio_destroy(client->io);
+    }
+}
+
+static int create_client_link(CLIENT* client, size_t link_index)
+{
+    int result;
+    char link_name[32];
+    AMQP_VALUE source;
+    AMQP_VALUE target;
+    CLIENT_LINK* client_link = &client->links[link_index];
+
+    (void)sprintf(link_name, "sender-link-%u", (unsigned int)link_index);
+    source = messaging_create_source("ingress");
+    target = messaging_create_target("localhost/ingress");
+
+    client_link->link = link_create(client->session, link_name, role_sender, source, target);
+    if (client_link->link == NULL)
+    {
+        LogError("Cannot create client link");
+        result = __LINE__;
+    }
+    /* unsettled, so that completion is the disposition coming back, not the transfer going out */
+    else if ((link_set_snd_settle_mode(client_link->link, sender_settle_mode_unsettled) != 0) ||
+        (link_set_max_message_size(client_link->link, 65536 + config.message_size) != 0))
+    {
+        LogError("Cannot set link properties");
+        link_destroy(client_link->link);
+        result = __LINE__;
+    }
+    else
+    {
+        client_link->message_sender = messagesender_create(client_link->link, NULL, NULL);
+        if (client_link->message_sender == NULL)
+        {
+            LogError("Cannot create client message sender");
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else if (messagesender_open(client_link->message_sender) != 0)
+        {
+            LogError("Cannot open client message sender");
+            messagesender_destroy(client_link->message_sender);
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(target);
+
+    return result;
+}
+
+static int create_client(CLIENT* client)
+{
+    int result;
+    SOCKETIO_CONFIG socketio_config = { "localhost", 0, NULL };
+
+    socketio_config.port = config.port;
+
+    client->connection = NULL;
+    client->session = NULL;
+    client->link_count = 0;
+    client->links = (CLIENT_LINK*)calloc(config.links_per_session, sizeof(CLIENT_LINK));
+    client->io = xio_create(socketio_get_interface_description(), &socketio_config);
+    if ((client->links == NULL) ||
+        (client->io == NULL))
+    {
+        LogError("Cannot create client IO");
+        result = __LINE__;
+    }
+    else if (((client->connection = connection_create(client->io, "localhost", "some", NULL, NULL)) == NULL) ||
+        (set_connection_options(client->connection) != 0))
+    {
+        LogError("Cannot create client connection");
+        result = __LINE__;
+    }
+    else if (((client->session = session_create(client->connection, NULL, NULL)) == NULL) ||
+        (session_set_outgoing_window(client->session, config.session_window) != 0))
+    {
+        LogError("Cannot create client session");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+
+        while ((result == 0) && (client->link_count < config.links_per_session))
+        {
+            result = create_client_link(client, client->link_count);
+            if (result == 0)
+            {
+                client->link_count++;
+            }
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_client(client);
+    }
+
+    return result;
+}
+
+static int send_message(CLIENT_LINK* client_link, unsigned char* payload, uint64_t intended_send_us)
+{
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    SEND_CONTEXT* send_context = (SEND_CONTEXT*)malloc(sizeof(SEND_CONTEXT));
+    BINARY_DATA binary_data;
+
+    binary_data.bytes = payload;
+    binary_data.length = config.message_size;
+
+    if ((message == NULL) ||
+        (send_context == NULL))
+    {
+        LogError("Error creating message");
+        free(send_context);
+        result = __LINE__;
+    }
+    else if (message_add_body_amqp_data(message, binary_data) != 0)
+    {
+        LogError("Error setting message body");
+        free(send_context);
+        result = __LINE__;
+    }
+    else
+    {
+        send_context->intended_send_us = intended_send_us;
+        send_context->actual_send_us = get_time_us();
+
+        if (send_context->actual_send_us - intended_send_us > max_schedule_lag_us)
+        {
+            max_schedule_lag_us = send_context->actual_send_us - intended_send_us;
+        }
+
+        if (messagesender_send_async(client_link->message_sender, message, on_message_send_complete, send_context, 0) == NULL)
+        {
+            LogError("Error sending message");
+            free(send_context);
+            result = __LINE__;
+        }
+        else
+        {
+            total_messages_sent++;
+            result = 0;
+        }
+    }
+
+    if (message != NULL)
+    {
+        message_destroy(message);
+    }
+
+    return result;
+}
+
+static void run_connections(SOCKET_LISTENER_HANDLE socket_listener, CLIENT* clients)
+{
+    LIST_ITEM_HANDLE current_item;
+    size_t i;
+
+    socketlistener_dowork(socket_listener);
+
+    for (i = 0; i < config.client_count; i++)
+    {
+        connection_dowork(clients[i].connection);
+    }
+
+    current_item = singlylinkedlist_get_head_item(server_connected_clients);
+    while (current_item != NULL)
+    {
+        SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
+        connection_dowork(server_connected_client->connection);
+        current_item = singlylinkedlist_get_next_item(current_item);
+    }
+}
+
+static int run_schedule(SOCKET_LISTENER_HANDLE socket_listener, CLIENT* clients, unsigned char* payload)
+{
+    int result = 0;
+    uint64_t start_us = get_time_us();
+    uint64_t current_us = start_us;
+    uint64_t scheduled_count = 0;
+    uint64_t drain_end_us;
+    size_t link_count = config.client_count * config.links_per_session;
+
+    measure_start_us = start_us + config.warmup_us;
+
+    while ((result == 0) && (current_us - start_us < config.duration_us))
+    {
+        size_t sends_this_pass = 0;
+
+        /* the send times come from the message index, so a late pass does not shift the rest of the schedule */
+        uint64_t intended_send_us = start_us + (uint64_t)((double)scheduled_count * 1000000.0 / config.rate);
+
+        while ((result == 0) &&
+            (intended_send_us <= current_us) &&
+            (sends_this_pass < MAX_SENDS_PER_PASS))
+        {
+            size_t link_index = (size_t)(scheduled_count % link_count);
+
+            result = send_message(&clients[link_index / config.links_per_session].links[link_index % config.links_per_session], payload, intended_send_us);
+            scheduled_count++;
+            sends_this_pass++;
+            intended_send_us = start_us + (uint64_t)((double)scheduled_count * 1000000.0 / config.rate);
+        }
+
+        run_connections(socket_listener, clients);
+        current_us = get_time_us();
+    }
+
+    /* the last messages of the schedule are the ones most likely to be queued, their latency is needed too */
+    drain_end_us = current_us + config.drain_us;
+    while ((result == 0) &&
+        (total_messages_settled + total_messages_failed < total_messages_sent) &&
+        (current_us < drain_end_us))
+    {
+        run_connections(socket_listener, clients);
+        current_us = get_time_us();
+    }
+
+    return result;
+}
+
+static void print_histogram_summary(const char* name, const HDR_HISTOGRAM* histogram)
+{
+    (void)printf("%-12s latency (us) over %llu messages: p50=%llu p90=%llu p99=%llu p99.9=%llu p99.99=%llu max=%llu\n",
+        name, (unsigned long long)histogram->total_count,
+        (unsigned long long)hdr_histogram_get_percentile(histogram, 0.5),
+        (unsigned long long)hdr_histogram_get_percentile(histogram, 0.9),
+        (unsigned long long)hdr_histogram_get_percentile(histogram, 0.99),
+        (unsigned long long)hdr_histogram_get_percentile(histogram, 0.999),
+        (unsigned long long)hdr_histogram_get_percentile(histogram, 0.9999),
+        (unsigned long long)histogram->max_value);
+}
+
+static int print_report(void)
+{
+    int result;
+    double measured_seconds = (double)(config.duration_us - config.warmup_us) / 1000000.0;
+
+    (void)printf("clients=%u links=%u message_size=%u rate=%.0f/s session_window=%u frame_size=%u batch_size=%u batch_delay=%ums disposition_batch=%u disposition_delay=%ums\n",
+        (unsigned int)config.client_count, (unsigned int)config.links_per_session, (unsigned int)config.message_size,
+        config.rate, (unsigned int)config.session_window, (unsigned int)config.max_frame_size,
+        (unsigned int)config.outgoing_batch_size, (unsigned int)config.outgoing_batch_delay,
+        (unsigned int)config.disposition_batch_size, (unsigned int)config.disposition_batch_delay);
+    (void)printf("sent %llu, settled %llu, failed %llu, unsettled at the end %llu, received %llu messages, %.0f messages/s recorded, max schedule lag %llu us\n",
+        (unsigned long long)total_messages_sent, (unsigned long long)total_messages_settled,
+        (unsigned long long)total_messages_failed,
+        (unsigned long long)(total_messages_sent - total_messages_settled - total_messages_failed),
+        (unsigned long long)total_messages_received,
+        (double)corrected_histogram.total_count / measured_seconds, (unsigned long long)max_schedule_lag_us);
+
+    /* from the scheduled send time, and from the actual send time as a closed loop generator would measure */
+    print_histogram_summary("corrected", &corrected_histogram);
+    print_histogram_summary("uncorrected", &uncorrected_histogram);
+
+    if (config.hgrm_path == NULL)
+    {
+        result = 0;
+    }
+    else if ((write_hgrm_file(&corrected_histogram, ".corrected.hgrm") != 0) ||
+        (write_hgrm_file(&uncorrected_histogram, ".uncorrected.hgrm") != 0))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        result = -1;
+    }
+    else if (platform_init() != 0)
+    {
+        LogError("platform_init failed");
+        result = -1;
+    }
+    else
+    {
+        if ((hdr_histogram_init(&corrected_histogram) != 0) ||
+            (hdr_histogram_init(&uncorrected_histogram) != 0))
+        {
+            result = -1;
+        }
+        else if ((server_connected_clients = singlylinkedlist_create()) == NULL)
+        {
+            LogError("Cannot create server connected clients list");
+            result = -1;
+        }
+        else
+        {
+            LIST_ITEM_HANDLE current_item;
+            SOCKET_LISTENER_HANDLE socket_listener = socketlistener_create(config.port);
+
+            if (socket_listener == NULL)
+            {
+                LogError("Cannot create socket listener");
+                result = -1;
+            }
+            else
+            {
+                if (socketlistener_start(socket_listener, on_socket_accepted, NULL) != 0)
+                {
+                    LogError("socketlistener_start failed");
+                    result = -1;
+                }
+                else
+                {
+                    size_t i;
+                    size_t client_count = 0;
+                    CLIENT* clients = (CLIENT*)malloc(sizeof(CLIENT) * config.client_count);
+                    unsigned char* payload = (unsigned char*)calloc(1, config.message_size);
+
+                    if ((clients == NULL) ||
+                        (payload == NULL))
+                    {
+                        LogError("Cannot allocate clients");
+                        result = -1;
+                    }
+                    else
+                    {
+                        while ((client_count < config.client_count) &&
+                            (create_client(&clients[client_count]) == 0))
+                        {
+                            client_count++;
+                        }
+
+                        if (client_count < config.client_count)
+                        {
+                            LogError("Cannot create clients");
+                            result = -1;
+                        }
+                        else if ((run_schedule(socket_listener, clients, payload) != 0) ||
+                            (print_report() != 0))
+                        {
+                            result = -1;
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
+
+                        /* the messages still queued complete as cancelled and free their send contexts */
+                        for (i = 0; i < client_count; i++)
+                        {
+                            destroy_client(&clients[i]);
+                        }
+                    }
+
+                    free(payload);
+                    free(clients);
+
+                    (void)socketlistener_stop(socket_listener);
+                }
+
+                socketlistener_destroy(socket_listener);
+            }
+
+            current_item = singlylinkedlist_get_head_item(server_connected_clients);
+            while (current_item != NULL)
+            {
+                destroy_server_connected_client((SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item));
+                (void)singlylinkedlist_remove(server_connected_clients, current_item);
+                current_item = singlylinkedlist_get_head_item(server_connected_clients);
+            }
+
+            singlylinkedlist_destroy(server_connected_clients);
+        }
+
+        free(corrected_histogram.counts);
+        free(uncorrected_histogram.counts);
+        platform_deinit();
+    }
+
+    return result;
+}
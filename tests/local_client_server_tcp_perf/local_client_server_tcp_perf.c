@@ -3,26 +3,266 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/socketio.h"
 #include "azure_uamqp_c/uamqp.h"
+#include "perf_counters/perf_counters.h"
 
-#define CLIENT_COUNT 1
-#define OUTSTANDING_MESSAGE_COUNT 1
-#define TEST_RUNTIME 5000 // ms
+/* the first bytes of each message body carry the send time used for the end-to-end latency */
+#define TIMESTAMP_SIZE sizeof(uint64_t)
+
+typedef struct PERF_CONFIG_TAG
+{
+    size_t client_count;
+    size_t links_per_session;
+    size_t message_size;
+    size_t outstanding_message_count;
+    bool is_settled;
+    uint32_t session_window;
+    uint32_t max_frame_size;
+    tickcounter_ms_t duration;
+    int port;
+    bool use_counters;
+    const char* capture_file_name;
+} PERF_CONFIG;
+
+static PERF_CONFIG config = { 1, 1, 256, 1, true, 100, 65536, 5000, 5672, false, NULL };
 
 static SINGLYLINKEDLIST_HANDLE server_connected_clients;
-static size_t total_messages_received;
+static uint64_t total_messages_sent;
+static uint64_t total_messages_received;
+static uint64_t total_bytes_received;
+static uint32_t* latency_samples;
+static size_t latency_sample_count;
+static size_t latency_sample_capacity;
+
+/* where the time goes in the run loop: sending (message encoding and framing, socket writes), the server dowork
+   (socket reads, frame and message decoding, dispositions out) and the client dowork (dispositions and flows in) */
+#define PHASE_SEND 0
+#define PHASE_RECEIVE 1
+#define PHASE_SETTLE 2
+#define PHASE_COUNT 3
+
+static PERF_COUNTERS_HANDLE perf_counters;
+static PERF_PHASE phases[PHASE_COUNT] = { { "send" }, { "receive" }, { "settle" } };
+
+/* the bytes received by the first server connection, for frame_capture_replay */
+static FILE* capture_file;
+static FRAME_TRACE_HANDLE capture_frame_trace;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static void record_latency(uint64_t latency_us)
+{
+    if (latency_sample_count == latency_sample_capacity)
+    {
+        size_t new_capacity = (latency_sample_capacity == 0) ? 65536 : latency_sample_capacity * 2;
+        uint32_t* new_samples = (uint32_t*)realloc(latency_samples, sizeof(uint32_t) * new_capacity);
+        if (new_samples != NULL)
+        {
+            latency_samples = new_samples;
+            latency_sample_capacity = new_capacity;
+        }
+    }
+
+    /* a sample that does not fit is dropped, the percentiles are computed over the recorded ones */
+    if (latency_sample_count < latency_sample_capacity)
+    {
+        latency_samples[latency_sample_count++] = (latency_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency_us;
+    }
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    uint32_t left_value = *(const uint32_t*)left;
+    uint32_t right_value = *(const uint32_t*)right;
+    return (left_value > right_value) - (left_value < right_value);
+}
+
+static uint32_t get_percentile(double percentile)
+{
+    uint32_t result;
+
+    if (latency_sample_count == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t index = (size_t)(percentile * (double)(latency_sample_count - 1));
+        result = latency_samples[index];
+    }
+
+    return result;
+}
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s [options]\n"
+        "  --clients <count>          client connections (default 1)\n"
+        "  --links <count>            sender links per client session (default 1)\n"
+        "  --message-size <bytes>     body size of each message, at least %u (default 256)\n"
+        "  --outstanding <count>      messages in flight per link (default 1)\n"
+        "  --settle <settled|unsettled> sender settle mode (default settled)\n"
+        "  --session-window <count>   session incoming window on the server (default 100)\n"
+        "  --frame-size <bytes>       max frame size on both ends (default 65536)\n"
+        "  --duration <ms>            run time (default 5000)\n"
+        "  --port <port>              listening port (default 5672)\n"
+        "  --counters <on|off>        hardware counters per message for each phase (default off)\n"
+        "  --capture <file>           capture the bytes received by the first server connection to file\n",
+        program_name, (unsigned int)TIMESTAMP_SIZE);
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned long number = (value == NULL) ? 0 : strtoul(value, NULL, 10);
+
+        if (value == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--clients") == 0)
+        {
+            config.client_count = number;
+        }
+        else if (strcmp(argv[i], "--links") == 0)
+        {
+            config.links_per_session = number;
+        }
+        else if (strcmp(argv[i], "--message-size") == 0)
+        {
+            config.message_size = number;
+        }
+        else if (strcmp(argv[i], "--outstanding") == 0)
+        {
+            config.outstanding_message_count = number;
+        }
+        else if (strcmp(argv[i], "--settle") == 0)
+        {
+            if (strcmp(value, "settled") == 0)
+            {
+                config.is_settled = true;
+            }
+            else if (strcmp(value, "unsettled") == 0)
+            {
+                config.is_settled = false;
+            }
+            else
+            {
+                result = __LINE__;
+            }
+        }
+        else if (strcmp(argv[i], "--session-window") == 0)
+        {
+            config.session_window = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--frame-size") == 0)
+        {
+            config.max_frame_size = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--duration") == 0)
+        {
+            config.duration = number;
+        }
+        else if (strcmp(argv[i], "--port") == 0)
+        {
+            config.port = (int)number;
+        }
+        else if (strcmp(argv[i], "--capture") == 0)
+        {
+            config.capture_file_name = value;
+        }
+        else if (strcmp(argv[i], "--counters") == 0)
+        {
+            if (strcmp(value, "on") == 0)
+            {
+                config.use_counters = true;
+            }
+            else if (strcmp(value, "off") == 0)
+            {
+                config.use_counters = false;
+            }
+            else
+            {
+                result = __LINE__;
+            }
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    if ((result == 0) &&
+        ((config.client_count == 0) ||
+        (config.links_per_session == 0) ||
+        (config.outstanding_message_count == 0) ||
+        (config.message_size < TIMESTAMP_SIZE) ||
+        (config.session_window == 0) ||
+        (config.max_frame_size < 512)))
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+static int write_capture(void* context, const unsigned char* bytes, size_t length)
+{
+    return (fwrite(bytes, 1, length, (FILE*)context) == length) ? 0 : __LINE__;
+}
+
+static void start_capture(CONNECTION_HANDLE connection)
+{
+    capture_frame_trace = frame_trace_create(16);
+    if (capture_frame_trace == NULL)
+    {
+        LogError("Cannot create the capture frame trace");
+    }
+    else if ((frame_trace_set_capture(capture_frame_trace, write_capture, capture_file) != 0) ||
+        (connection_set_frame_trace(connection, capture_frame_trace) != 0))
+    {
+        LogError("Cannot start the capture");
+    }
+}
 
 typedef struct SERVER_CONNECTED_CLIENT_TAG
 {
     CONNECTION_HANDLE connection;
     SESSION_HANDLE session;
-    LINK_HANDLE link;
-    MESSAGE_RECEIVER_HANDLE message_receiver;
+    LINK_HANDLE* links;
+    MESSAGE_RECEIVER_HANDLE* message_receivers;
+    size_t link_count;
     XIO_HANDLE io;
 } SERVER_CONNECTED_CLIENT;
 
@@ -35,11 +275,22 @@ static void on_message_receiver_state_changed(const void* context, MESSAGE_RECEI
 
 static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
 {
+    BINARY_DATA binary_data;
+
     (void)context;
-    (void)message;
 
     total_messages_received++;
 
+    if ((message_get_body_amqp_data_in_place(message, 0, &binary_data) == 0) &&
+        (binary_data.length >= TIMESTAMP_SIZE))
+    {
+        uint64_t sent_us;
+        (void)memcpy(&sent_us, binary_data.bytes, TIMESTAMP_SIZE);
+
+        total_bytes_received += binary_data.length;
+        record_latency(get_time_us() - sent_us);
+    }
+
     return messaging_delivery_accepted();
 }
 
@@ -50,47 +301,49 @@ static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_en
 
     LogInfo("Link attached");
 
-    server_connected_client->link = link_create_from_endpoint(server_connected_client->session, new_link_endpoint, name, role, source, target);
-    if (server_connected_client->link == NULL)
+    if (server_connected_client->link_count == config.links_per_session)
     {
-        LogError("Cannot create link");
+        LogError("Too many links attached");
         result = false;
     }
     else
     {
-        if (link_set_rcv_settle_mode(server_connected_client->link, receiver_settle_mode_first) != 0)
+        LINK_HANDLE link = link_create_from_endpoint(server_connected_client->session, new_link_endpoint, name, role, source, target);
+        if (link == NULL)
+        {
+            LogError("Cannot create link");
+            result = false;
+        }
+        else if ((link_set_rcv_settle_mode(link, receiver_settle_mode_first) != 0) ||
+            (link_set_max_link_credit(link, (uint32_t)(config.outstanding_message_count * 2)) != 0))
         {
-            link_destroy(server_connected_client->link);
-            server_connected_client->link = NULL;
-            LogError("Cannot set receiver settle mode");
+            link_destroy(link);
+            LogError("Cannot set link properties");
             result = false;
         }
         else
         {
-            server_connected_client->message_receiver = messagereceiver_create(server_connected_client->link, on_message_receiver_state_changed, NULL);
-            if (server_connected_client->message_receiver == NULL)
+            MESSAGE_RECEIVER_HANDLE message_receiver = messagereceiver_create(link, on_message_receiver_state_changed, NULL);
+            if (message_receiver == NULL)
             {
-                link_destroy(server_connected_client->link);
-                server_connected_client->link = NULL;
+                link_destroy(link);
                 LogError("Cannot create message receiver");
                 result = false;
             }
+            else if (messagereceiver_open(message_receiver, on_message_received, NULL) != 0)
+            {
+                messagereceiver_destroy(message_receiver);
+                link_destroy(link);
+                LogError("Cannot open message receiver");
+                result = false;
+            }
             else
             {
-                if (messagereceiver_open(server_connected_client->message_receiver, on_message_received, NULL) != 0)
-                {
-                    messagereceiver_destroy(server_connected_client->message_receiver);
-                    server_connected_client->message_receiver = NULL;
-                    link_destroy(server_connected_client->link);
-                    server_connected_client->link = NULL;
-                    LogError("Cannot create message receiver");
-                    result = false;
-                }
-                else
-                {
-                    /* all OK */
-                    result = true;
-                }
+                /* all OK */
+                server_connected_client->links[server_connected_client->link_count] = link;
+                server_connected_client->message_receivers[server_connected_client->link_count] = message_receiver;
+                server_connected_client->link_count++;
+                result = true;
             }
         }
     }
@@ -113,7 +366,7 @@ static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
     }
     else
     {
-        if (session_set_incoming_window(server_connected_client->session, 100) != 0)
+        if (session_set_incoming_window(server_connected_client->session, config.session_window) != 0)
         {
             session_destroy(server_connected_client->session);
             server_connected_client->session = NULL;
@@ -191,12 +444,23 @@ static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* in
                 }
                 else
                 {
-                    server_connected_client->link = NULL;
-                    server_connected_client->message_receiver = NULL;
+                    server_connected_client->links = (LINK_HANDLE*)calloc(config.links_per_session, sizeof(LINK_HANDLE));
+                    server_connected_client->message_receivers = (MESSAGE_RECEIVER_HANDLE*)calloc(config.links_per_session, sizeof(MESSAGE_RECEIVER_HANDLE));
+                    server_connected_client->link_count = 0;
                     server_connected_client->session = NULL;
                     server_connected_client->connection = connection_create(header_detect_io, NULL, "1", on_new_session_endpoint, server_connected_client);
-                    if (server_connected_client->connection == NULL)
+                    if ((server_connected_client->links == NULL) ||
+                        (server_connected_client->message_receivers == NULL) ||
+                        (server_connected_client->connection == NULL) ||
+                        (connection_set_max_frame_size(server_connected_client->connection, config.max_frame_size) != 0))
                     {
+                        if (server_connected_client->connection != NULL)
+                        {
+                            connection_destroy(server_connected_client->connection);
+                        }
+
+                        free(server_connected_client->links);
+                        free(server_connected_client->message_receivers);
                         free(server_connected_client);
                         xio_destroy(underlying_io);
                         xio_destroy(header_detect_io);
@@ -207,6 +471,8 @@ static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* in
                         if (connection_listen(server_connected_client->connection) != 0)
                         {
                             connection_destroy(server_connected_client->connection);
+                            free(server_connected_client->links);
+                            free(server_connected_client->message_receivers);
                             free(server_connected_client);
                             xio_destroy(underlying_io);
                             xio_destroy(header_detect_io);
@@ -216,6 +482,12 @@ static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* in
                         {
                             /* All OK */
                             server_connected_client->io = header_detect_io;
+
+                            if ((capture_file != NULL) &&
+                                (capture_frame_trace == NULL))
+                            {
+                                start_capture(server_connected_client->connection);
+                            }
                         }
                     }
                 }
@@ -224,28 +496,292 @@ static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* in
     }
 }
 
+typedef struct CLIENT_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_SENDER_HANDLE message_sender;
+    size_t outstanding_message_count;
+} CLIENT_LINK;
+
 typedef struct CLIENT_TAG
 {
     CONNECTION_HANDLE connection;
     SESSION_HANDLE session;
-    LINK_HANDLE link;
-    MESSAGE_SENDER_HANDLE message_sender;
+    CLIENT_LINK* links;
+    size_t link_count;
     XIO_HANDLE io;
-    size_t outstanding_message_count;
 } CLIENT;
 
 static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
 {
-    CLIENT* client = (CLIENT*)context;
-    client->outstanding_message_count--;
+    CLIENT_LINK* client_link = (CLIENT_LINK*)context;
+    client_link->outstanding_message_count--;
     (void)send_result;
-    (void)context;
 }
 
-int main(void)
+static void destroy_client(CLIENT* client)
+{
+    size_t i;
+
+    for (i = 0; i < client->link_count; i++)
+    {
+        messagesender_destroy(client->links[i].message_sender);
+        link_destroy(client->links[i].link);
+    }
+
+    free(client->links);
+
+    if (client->session != NULL)
+    {
+        session_destroy(client->session);
+    }
+
+    if (client->connection != NULL)
+    {
+        connection_destroy(client->connection);
+    }
+
+    if (client->io != NULL)
+    {
+        xio_destroy(client->io);
+    }
+}
+
+static int create_client_link(CLIENT* client, size_t link_index)
 {
     int result;
-    if (platform_init() != 0)
+    char link_name[32];
+    AMQP_VALUE source;
+    AMQP_VALUE target;
+    CLIENT_LINK* client_link = &client->links[link_index];
+
+    (void)sprintf(link_name, "sender-link-%u", (unsigned int)link_index);
+    source = messaging_create_source("ingress");
+    target = messaging_create_target("localhost/ingress");
+
+    client_link->link = link_create(client->session, link_name, role_sender, source, target);
+    if (client_link->link == NULL)
+    {
+        LogError("Cannot create client link");
+        result = __LINE__;
+    }
+    else if ((link_set_snd_settle_mode(client_link->link, config.is_settled ? sender_settle_mode_settled : sender_settle_mode_unsettled) != 0) ||
+        (link_set_max_message_size(client_link->link, 65536 + config.message_size) != 0))
+    {
+        LogError("Cannot set link properties");
+        link_destroy(client_link->link);
+        result = __LINE__;
+    }
+    else
+    {
+        client_link->message_sender = messagesender_create(client_link->link, NULL, NULL);
+        if (client_link->message_sender == NULL)
+        {
+            LogError("Cannot create client message sender");
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else if (messagesender_open(client_link->message_sender) != 0)
+        {
+            LogError("Cannot open client message sender");
+            messagesender_destroy(client_link->message_sender);
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else
+        {
+            client_link->outstanding_message_count = 0;
+            result = 0;
+        }
+    }
+
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(target);
+
+    return result;
+}
+
+static int create_client(CLIENT* client)
+{
+    int result;
+    SOCKETIO_CONFIG socketio_config = { "localhost", 0, NULL };
+
+    socketio_config.port = config.port;
+
+    client->connection = NULL;
+    client->session = NULL;
+    client->link_count = 0;
+    client->links = (CLIENT_LINK*)calloc(config.links_per_session, sizeof(CLIENT_LINK));
+    client->io = xio_create(socketio_get_interface_description(), &socketio_config);
+    if ((client->links == NULL) ||
+        (client->io == NULL))
+    {
+        LogError("Cannot create client IO");
+        result = __LINE__;
+    }
+    else if (((client->connection = connection_create(client->io, "localhost", "some", NULL, NULL)) == NULL) ||
+        (connection_set_max_frame_size(client->connection, config.max_frame_size) != 0))
+    {
+        LogError("Cannot create client connection");
+        result = __LINE__;
+    }
+    else if (((client->session = session_create(client->connection, NULL, NULL)) == NULL) ||
+        (session_set_outgoing_window(client->session, config.session_window) != 0))
+    {
+        LogError("Cannot create client session");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+
+        while ((result == 0) && (client->link_count < config.links_per_session))
+        {
+            result = create_client_link(client, client->link_count);
+            if (result == 0)
+            {
+                client->link_count++;
+            }
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_client(client);
+    }
+
+    return result;
+}
+
+static int send_messages(CLIENT_LINK* client_link, unsigned char* payload)
+{
+    int result = 0;
+
+    while ((result == 0) && (client_link->outstanding_message_count < config.outstanding_message_count))
+    {
+        MESSAGE_HANDLE message = message_create();
+        BINARY_DATA binary_data;
+        uint64_t now_us = get_time_us();
+
+        (void)memcpy(payload, &now_us, TIMESTAMP_SIZE);
+        binary_data.bytes = payload;
+        binary_data.length = config.message_size;
+
+        if (message == NULL)
+        {
+            LogError("Error creating message");
+            result = __LINE__;
+        }
+        else
+        {
+            if (message_add_body_amqp_data(message, binary_data) != 0)
+            {
+                LogError("Error setting message body");
+                result = __LINE__;
+            }
+            else if (messagesender_send_async(client_link->message_sender, message, on_message_send_complete, client_link, 0) == NULL)
+            {
+                LogError("Error sending message");
+                result = __LINE__;
+            }
+            else
+            {
+                client_link->outstanding_message_count++;
+                total_messages_sent++;
+            }
+
+            message_destroy(message);
+        }
+    }
+
+    return result;
+}
+
+static const char* alloc_subsystem_names[ALLOC_SUBSYSTEM_COUNT] =
+{
+    "amqpvalue", "frame_codec", "connection", "session", "link", "message", "message_sender", "message_receiver"
+};
+
+static void print_allocations_per_message(void)
+{
+    ALLOC_COUNTERS total_counters;
+    unsigned int i;
+
+    if (!alloc_counters_are_enabled())
+    {
+        (void)printf("allocations per message: build with alloc_counters to measure\n");
+    }
+    else if ((total_messages_received == 0) ||
+        (alloc_counters_get_total(&total_counters) != 0))
+    {
+        (void)printf("allocations per message: n/a\n");
+    }
+    else
+    {
+        /* client and server run in the same process, so each message accounts for one send and one receive */
+        (void)printf("allocations per message (send + receive): %.2f, %.0f bytes\n",
+            (double)total_counters.allocation_count / (double)total_messages_received,
+            (double)total_counters.allocated_bytes / (double)total_messages_received);
+
+        for (i = 0; i < ALLOC_SUBSYSTEM_COUNT; i++)
+        {
+            ALLOC_COUNTERS counters;
+
+            if (alloc_counters_get((ALLOC_SUBSYSTEM)i, &counters) == 0)
+            {
+                (void)printf("  %-16s %8.2f allocs %10.0f bytes\n", alloc_subsystem_names[i],
+                    (double)counters.allocation_count / (double)total_messages_received,
+                    (double)counters.allocated_bytes / (double)total_messages_received);
+            }
+        }
+    }
+}
+
+static void print_report(tickcounter_ms_t elapsed_ms)
+{
+    double elapsed_seconds = (elapsed_ms == 0) ? 1.0 : (double)elapsed_ms / 1000;
+
+    qsort(latency_samples, latency_sample_count, sizeof(uint32_t), compare_latencies);
+
+    (void)printf("clients=%u links=%u message_size=%u outstanding=%u settle=%s session_window=%u frame_size=%u\n",
+        (unsigned int)config.client_count, (unsigned int)config.links_per_session, (unsigned int)config.message_size,
+        (unsigned int)config.outstanding_message_count, config.is_settled ? "settled" : "unsettled",
+        (unsigned int)config.session_window, (unsigned int)config.max_frame_size);
+    (void)printf("sent %llu, received %llu messages in %.2f seconds: %.0f messages/s, %.2f MB/s\n",
+        (unsigned long long)total_messages_sent, (unsigned long long)total_messages_received, elapsed_seconds,
+        (double)total_messages_received / elapsed_seconds,
+        (double)total_bytes_received / elapsed_seconds / (1024 * 1024));
+    (void)printf("latency (us) over %u samples: p50=%u p99=%u p99.9=%u max=%u\n",
+        (unsigned int)latency_sample_count,
+        (unsigned int)get_percentile(0.5), (unsigned int)get_percentile(0.99),
+        (unsigned int)get_percentile(0.999), (unsigned int)get_percentile(1.0));
+
+    print_allocations_per_message();
+
+    if (config.use_counters)
+    {
+        if (perf_counters == NULL)
+        {
+            (void)printf("hardware counters: not available\n");
+        }
+        else
+        {
+            /* client and server run in the same process, so each message accounts for one send and one receive */
+            perf_counters_print_phases(perf_counters, "counters per message", phases, PHASE_COUNT, total_messages_received);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        result = -1;
+    }
+    else if (platform_init() != 0)
     {
         LogError("platform_init failed");
         result = -1;
@@ -263,7 +799,13 @@ int main(void)
             LIST_ITEM_HANDLE current_item;
             SOCKET_LISTENER_HANDLE socket_listener;
 
-            socket_listener = socketlistener_create(5672);
+            if ((config.capture_file_name != NULL) &&
+                ((capture_file = fopen(config.capture_file_name, "wb")) == NULL))
+            {
+                LogError("Cannot open %s, running without capture", config.capture_file_name);
+            }
+
+            socket_listener = socketlistener_create(config.port);
             if (socket_listener == NULL)
             {
                 LogError("Cannot create socket listener");
@@ -279,198 +821,134 @@ int main(void)
                 else
                 {
                     size_t i;
-                    CLIENT clients[CLIENT_COUNT];
+                    size_t client_count = 0;
+                    CLIENT* clients = (CLIENT*)malloc(sizeof(CLIENT) * config.client_count);
+                    unsigned char* payload = (unsigned char*)calloc(1, config.message_size);
                     TICK_COUNTER_HANDLE tick_counter;
 
-                    for (i = 0; i < CLIENT_COUNT; i++)
+                    if ((clients == NULL) ||
+                        (payload == NULL))
                     {
-                        AMQP_VALUE source;
-                        AMQP_VALUE target;
-
-                        SOCKETIO_CONFIG socketio_config = { "localhost", 5672, NULL };
-
-                        /* create socket IO */
-                        clients[i].io = xio_create(socketio_get_interface_description(), &socketio_config);
-                        if (clients[i].io == NULL)
-                        {
-                            LogError("Cannot create client IO");
-                            break;
-                        }
-
-                        /* create the connection, session and link */
-                        clients[i].connection = connection_create(clients[i].io, "localhost", "some", NULL, NULL);
-                        if (clients[i].connection == NULL)
-                        {
-                            LogError("Cannot create client connection");
-                            xio_destroy(clients[i].io);
-                            clients[i].io = NULL;
-                            break;
-                        }
-
-                        clients[i].session = session_create(clients[i].connection, NULL, NULL);
-                        if (clients[i].session == NULL)
-                        {
-                            LogError("Cannot create client session");
-                            connection_destroy(clients[i].connection);
-                            xio_destroy(clients[i].io);
-                            clients[i].io = NULL;
-                            break;
-                        }
-
-                        source = messaging_create_source("ingress");
-                        target = messaging_create_target("localhost/ingress");
-
-                        clients[i].link = link_create(clients[i].session, "sender-link", role_sender, source, target);
-                        if (clients[i].session == NULL)
-                        {
-                            LogError("Cannot create client link");
-                            session_destroy(clients[i].session);
-                            connection_destroy(clients[i].connection);
-                            xio_destroy(clients[i].io);
-                            clients[i].io = NULL;
-                            break;
-                        }
-
-                        amqpvalue_destroy(source);
-                        amqpvalue_destroy(target);
-
-                        if ((link_set_snd_settle_mode(clients[i].link, sender_settle_mode_settled) != 0) ||
-                            (link_set_max_message_size(clients[i].link, 65536) != 0))
+                        LogError("Cannot allocate clients");
+                        result = -1;
+                    }
+                    else
+                    {
+                        while ((client_count < config.client_count) &&
+                            (create_client(&clients[client_count]) == 0))
                         {
-                            LogError("Cannot set link properties");
-                            link_destroy(clients[i].link);
-                            session_destroy(clients[i].session);
-                            connection_destroy(clients[i].connection);
-                            xio_destroy(clients[i].io);
-                            clients[i].io = NULL;
-                            break;
+                            client_count++;
                         }
 
-                        /* create a message sender */
-                        clients[i].message_sender = messagesender_create(clients[i].link, NULL, NULL);
-                        if (messagesender_open(clients[i].message_sender) != 0)
+                        tick_counter = tickcounter_create();
+                        if (client_count < config.client_count)
                         {
-                            LogError("Cannot create client message sender");
-                            link_destroy(clients[i].link);
-                            session_destroy(clients[i].session);
-                            connection_destroy(clients[i].connection);
-                            xio_destroy(clients[i].io);
-                            clients[i].io = NULL;
-                            break;
+                            LogError("Cannot create clients");
+                            result = -1;
                         }
-
-                        clients[i].outstanding_message_count = 0;
-                    }
-
-                    tick_counter = tickcounter_create();
-                    if (tick_counter == NULL)
-                    {
-                        LogError("Cannot create tick counter");
-                    }
-                    else
-                    {
-                        bool keep_running = true;
-                        tickcounter_ms_t current_ms = 0;
-                        tickcounter_ms_t start_ms = 0;
-
-                        if (tickcounter_get_current_ms(tick_counter, &start_ms) != 0)
+                        else if (tick_counter == NULL)
                         {
-                            LogError("Caanot get tick counter value");
+                            LogError("Cannot create tick counter");
+                            result = -1;
                         }
                         else
                         {
-                            while (keep_running)
+                            tickcounter_ms_t current_ms = 0;
+                            tickcounter_ms_t start_ms = 0;
+
+                            if (tickcounter_get_current_ms(tick_counter, &start_ms) != 0)
+                            {
+                                LogError("Caanot get tick counter value");
+                                result = -1;
+                            }
+                            else
                             {
-                                SERVER_CONNECTED_CLIENT* server_connected_client;
+                                result = 0;
 
-                                socketlistener_dowork(socket_listener);
+                                /* setting up the clients does not count towards the per message allocations */
+                                alloc_counters_reset();
 
-                                // schedule client work
-                                for (i = 0; i < CLIENT_COUNT; i++)
+                                if (config.use_counters)
                                 {
-                                    bool is_error = false;
-                                    connection_dowork(clients[i].connection);
+                                    perf_counters = perf_counters_create();
+                                }
+
+                                while (result == 0)
+                                {
+                                    SERVER_CONNECTED_CLIENT* server_connected_client;
 
-                                    while (clients[i].outstanding_message_count < OUTSTANDING_MESSAGE_COUNT)
+                                    socketlistener_dowork(socket_listener);
+
+                                    // schedule client work
+                                    perf_counters_phase_begin(perf_counters, &phases[PHASE_SETTLE]);
+                                    for (i = 0; i < client_count; i++)
                                     {
-                                        MESSAGE_HANDLE message = message_create();
-                                        unsigned char hello[] = { 'H', 'e', 'l', 'l', 'o' };
-                                        BINARY_DATA binary_data;
+                                        connection_dowork(clients[i].connection);
+                                    }
 
-                                        if (message == NULL)
-                                        {
-                                            LogError("Error creating message");
-                                            is_error = true;
-                                            break;
-                                        }
+                                    perf_counters_phase_end(perf_counters, &phases[PHASE_SETTLE]);
 
-                                        binary_data.bytes = hello;
-                                        binary_data.length = sizeof(hello);
-                                        message_add_body_amqp_data(message, binary_data);
+                                    perf_counters_phase_begin(perf_counters, &phases[PHASE_SEND]);
+                                    for (i = 0; (result == 0) && (i < client_count); i++)
+                                    {
+                                        size_t j;
 
-                                        if (messagesender_send_async(clients[i].message_sender, message, on_message_send_complete, &clients[i], 0) == NULL)
+                                        for (j = 0; (result == 0) && (j < clients[i].link_count); j++)
                                         {
-                                            message_destroy(message);
-                                            LogError("Error sending message");
-                                            is_error = true;
-                                            break;
+                                            result = send_messages(&clients[i].links[j], payload);
                                         }
-
-                                        message_destroy(message);
-
-                                        clients[i].outstanding_message_count++;
                                     }
 
-                                    if (is_error)
+                                    perf_counters_phase_end(perf_counters, &phases[PHASE_SEND]);
+
+                                    if (result != 0)
                                     {
+                                        LogError("Error processing clients");
                                         break;
                                     }
-                                }
 
-                                if (i < CLIENT_COUNT)
-                                {
-                                    LogError("Error processing clients");
-                                    break;
-                                }
+                                    perf_counters_phase_begin(perf_counters, &phases[PHASE_RECEIVE]);
+                                    current_item = singlylinkedlist_get_head_item(server_connected_clients);
+                                    while (current_item != NULL)
+                                    {
+                                        server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
+                                        connection_dowork(server_connected_client->connection);
+                                        current_item = singlylinkedlist_get_next_item(current_item);
+                                    }
 
-                                current_item = singlylinkedlist_get_head_item(server_connected_clients);
-                                while (current_item != NULL)
-                                {
-                                    server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
-                                    connection_dowork(server_connected_client->connection);
-                                    current_item = singlylinkedlist_get_next_item(current_item);
-                                }
+                                    perf_counters_phase_end(perf_counters, &phases[PHASE_RECEIVE]);
 
-                                if (tickcounter_get_current_ms(tick_counter, &current_ms) != 0)
-                                {
-                                    LogError("Caanot get tick counter value");
-                                    break;
+                                    if (tickcounter_get_current_ms(tick_counter, &current_ms) != 0)
+                                    {
+                                        LogError("Caanot get tick counter value");
+                                        result = -1;
+                                    }
+                                    else if (current_ms - start_ms > config.duration)
+                                    {
+                                        break;
+                                    }
                                 }
 
-                                if (current_ms - start_ms > TEST_RUNTIME)
-                                {
-                                    break;
-                                }
+                                print_report(current_ms - start_ms);
                             }
+                        }
 
-                            LogInfo("Received %u messages in %02f seconds, %02f messages/s",
-                                total_messages_received,
-                                ((double)current_ms - start_ms) / 1000,
-                                total_messages_received / (((double)current_ms - start_ms) / 1000));
-
-                            for (i = 0; i < CLIENT_COUNT; i++)
-                            {
-                                messagesender_destroy(clients[i].message_sender);
-                                link_destroy(clients[i].link);
-                                session_destroy(clients[i].session);
-                                connection_destroy(clients[i].connection);
-                                xio_destroy(clients[i].io);
-                            }
+                        if (tick_counter != NULL)
+                        {
+                            tickcounter_destroy(tick_counter);
                         }
 
-                        tickcounter_destroy(tick_counter);
+                        perf_counters_destroy(perf_counters);
+
+                        for (i = 0; i < client_count; i++)
+                        {
+                            destroy_client(&clients[i]);
+                        }
                     }
 
+                    free(payload);
+                    free(clients);
+
                     (void)socketlistener_stop(socket_listener);
                 }
 
@@ -480,21 +958,47 @@ int main(void)
             current_item = singlylinkedlist_get_head_item(server_connected_clients);
             while (current_item != NULL)
             {
+                size_t i;
                 SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
-                messagereceiver_destroy(server_connected_client->message_receiver);
-                link_destroy(server_connected_client->link);
-                session_destroy(server_connected_client->session);
+
+                for (i = 0; i < server_connected_client->link_count; i++)
+                {
+                    messagereceiver_destroy(server_connected_client->message_receivers[i]);
+                    link_destroy(server_connected_client->links[i]);
+                }
+
+                if (server_connected_client->session != NULL)
+                {
+                    session_destroy(server_connected_client->session);
+                }
+
                 connection_destroy(server_connected_client->connection);
                 xio_destroy(server_connected_client->io);
 
                 singlylinkedlist_remove(server_connected_clients, current_item);
                 current_item = singlylinkedlist_get_head_item(server_connected_clients);
+                free(server_connected_client->links);
+                free(server_connected_client->message_receivers);
                 free(server_connected_client);
             }
 
             singlylinkedlist_destroy(server_connected_clients);
+            free(latency_samples);
+
+            /* the connections that could use it are destroyed above */
+            if (capture_frame_trace != NULL)
+            {
+                frame_trace_destroy(capture_frame_trace);
+            }
+
+            if (capture_file != NULL)
+            {
+                (void)fclose(capture_file);
+            }
         }
 
         platform_deinit();
     }
+
+    return result;
 }
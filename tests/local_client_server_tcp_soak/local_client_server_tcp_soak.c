@@ -0,0 +1,1444 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_uamqp_c/uamqp.h"
+
+/* Runs a client and a server in one process for hours with a mixed workload (sends of varied sizes, reconnects, link
+   churn and management operations), samples the RSS, the gballoc and alloc_counters figures and the throughput at a
+   fixed interval, and flags a growth of the memory after the warm-up. With alloc_counters the report also breaks the
+   live objects down per type, so that a growth can be tied to what holds the memory. */
+
+#define MANAGEMENT_NODE "$management"
+
+typedef struct SOAK_CONFIG_TAG
+{
+    size_t client_count;
+    size_t links_per_session;
+    size_t min_message_size;
+    size_t max_message_size;
+    size_t outstanding_message_count;
+    tickcounter_ms_t duration;
+    tickcounter_ms_t sample_interval;
+    tickcounter_ms_t warmup;
+    /* 0 turns the reconnects, link churn or management operations off */
+    tickcounter_ms_t reconnect_interval;
+    tickcounter_ms_t link_churn_interval;
+    tickcounter_ms_t management_interval;
+    double max_growth_kb_per_hour;
+    uint32_t seed;
+    int port;
+    const char* csv_path;
+} SOAK_CONFIG;
+
+static SOAK_CONFIG config = { 4, 2, 16, 65536, 4, 3600000, 10000, 300000, 60000, 5000, 1000, 1024.0, 1, 5673, NULL };
+
+typedef struct SOAK_SAMPLE_TAG
+{
+    tickcounter_ms_t elapsed_ms;
+    uint64_t rss_bytes;
+    /* 0 when the library is not built with memory_trace or alloc_counters */
+    uint64_t heap_bytes;
+    uint64_t live_allocation_count;
+    uint64_t messages_received;
+    uint64_t bytes_received;
+} SOAK_SAMPLE;
+
+static SINGLYLINKEDLIST_HANDLE server_connected_clients;
+static uint32_t random_state;
+static uint64_t total_messages_sent;
+static uint64_t total_messages_received;
+static uint64_t total_bytes_received;
+static uint64_t total_management_operations;
+static uint64_t total_management_failures;
+static uint64_t total_reconnects;
+static uint64_t total_link_churns;
+static SOAK_SAMPLE* samples;
+static size_t sample_count;
+static size_t sample_capacity;
+/* the live objects per type at the first sample after the warm-up and at the last sample */
+static ALLOC_OBJECT_SNAPSHOT warmup_object_snapshot;
+static ALLOC_OBJECT_SNAPSHOT last_object_snapshot;
+static bool has_warmup_object_snapshot;
+static bool has_last_object_snapshot;
+
+/* the workload has to be the same from one run to the next, rand() is not */
+static uint32_t get_random(void)
+{
+    random_state = (random_state * 1103515245) + 12345;
+    return random_state >> 8;
+}
+
+static size_t get_random_message_size(void)
+{
+    return config.min_message_size + (get_random() % (config.max_message_size - config.min_message_size + 1));
+}
+
+static uint64_t get_rss_bytes(void)
+{
+    uint64_t result;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (uint64_t)counters.WorkingSetSize;
+    }
+#elif defined(__linux__)
+    FILE* statm = fopen("/proc/self/statm", "r");
+    unsigned long total_pages;
+    unsigned long resident_pages;
+
+    if (statm == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        if (fscanf(statm, "%lu %lu", &total_pages, &resident_pages) != 2)
+        {
+            result = 0;
+        }
+        else
+        {
+            result = (uint64_t)resident_pages * (uint64_t)sysconf(_SC_PAGESIZE);
+        }
+
+        (void)fclose(statm);
+    }
+#else
+    result = 0;
+#endif
+
+    return result;
+}
+
+static bool has_heap_bytes(void)
+{
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+    return true;
+#else
+    return alloc_counters_are_enabled();
+#endif
+}
+
+static void take_sample(tickcounter_ms_t elapsed_ms)
+{
+    if (sample_count == sample_capacity)
+    {
+        size_t new_capacity = (sample_capacity == 0) ? 1024 : sample_capacity * 2;
+        SOAK_SAMPLE* new_samples = (SOAK_SAMPLE*)realloc(samples, sizeof(SOAK_SAMPLE) * new_capacity);
+        if (new_samples != NULL)
+        {
+            samples = new_samples;
+            sample_capacity = new_capacity;
+        }
+    }
+
+    if (sample_count < sample_capacity)
+    {
+        SOAK_SAMPLE* sample = &samples[sample_count];
+        ALLOC_COUNTERS counters;
+
+        sample->elapsed_ms = elapsed_ms;
+        sample->rss_bytes = get_rss_bytes();
+        sample->messages_received = total_messages_received;
+        sample->bytes_received = total_bytes_received;
+
+        if (alloc_counters_are_enabled() &&
+            (alloc_counters_get_total(&counters) == 0))
+        {
+            sample->live_allocation_count = counters.allocation_count - counters.free_count;
+        }
+        else
+        {
+            sample->live_allocation_count = 0;
+        }
+
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+        sample->heap_bytes = gballoc_getCurrentMemoryUsed();
+#else
+        /* the counters do not know the size freed, the live allocations are the best figure there is */
+        sample->heap_bytes = 0;
+#endif
+
+        sample_count++;
+    }
+
+    if (alloc_counters_get_object_snapshot(&last_object_snapshot) == 0)
+    {
+        has_last_object_snapshot = true;
+        if ((!has_warmup_object_snapshot) &&
+            (elapsed_ms >= config.warmup))
+        {
+            warmup_object_snapshot = last_object_snapshot;
+            has_warmup_object_snapshot = true;
+        }
+    }
+}
+
+static void print_object_usage(void)
+{
+    static const char* object_type_names[ALLOC_OBJECT_TYPE_COUNT] =
+    {
+        "connection", "session", "link", "pending send", "pending delivery", "message", "value node", "frame buffer"
+    };
+
+    if (has_warmup_object_snapshot &&
+        has_last_object_snapshot)
+    {
+        size_t i;
+
+        /* a type that grows is where a process that grows keeps its memory */
+        (void)printf("%-18s %12s %12s %12s %12s\n", "live objects", "after warmup", "KB", "at the end", "KB");
+        for (i = 0; i < ALLOC_OBJECT_TYPE_COUNT; i++)
+        {
+            (void)printf("%-18s %12llu %12llu %12llu %12llu%s\n", object_type_names[i],
+                (unsigned long long)warmup_object_snapshot.usage[i].live_count, (unsigned long long)(warmup_object_snapshot.usage[i].live_bytes / 1024),
+                (unsigned long long)last_object_snapshot.usage[i].live_count, (unsigned long long)(last_object_snapshot.usage[i].live_bytes / 1024),
+                (last_object_snapshot.usage[i].live_bytes > warmup_object_snapshot.usage[i].live_bytes) ? "  <-- grew" : "");
+        }
+    }
+}
+
+static void print_sample(FILE* csv_file, const SOAK_SAMPLE* sample, const SOAK_SAMPLE* previous_sample)
+{
+    tickcounter_ms_t interval_ms = sample->elapsed_ms - ((previous_sample == NULL) ? 0 : previous_sample->elapsed_ms);
+    uint64_t interval_messages = sample->messages_received - ((previous_sample == NULL) ? 0 : previous_sample->messages_received);
+    uint64_t interval_bytes = sample->bytes_received - ((previous_sample == NULL) ? 0 : previous_sample->bytes_received);
+    double interval_seconds = (interval_ms == 0) ? 1.0 : (double)interval_ms / 1000;
+
+    (void)printf("%8.0f s  rss %8llu KB  heap %8llu KB  live allocs %8llu  %8.0f messages/s  %7.2f MB/s  reconnects %llu  link churns %llu  management %llu (%llu failed)\n",
+        (double)sample->elapsed_ms / 1000,
+        (unsigned long long)(sample->rss_bytes / 1024), (unsigned long long)(sample->heap_bytes / 1024),
+        (unsigned long long)sample->live_allocation_count,
+        (double)interval_messages / interval_seconds, (double)interval_bytes / interval_seconds / (1024 * 1024),
+        (unsigned long long)total_reconnects, (unsigned long long)total_link_churns,
+        (unsigned long long)total_management_operations, (unsigned long long)total_management_failures);
+
+    if (csv_file != NULL)
+    {
+        (void)fprintf(csv_file, "%llu,%llu,%llu,%llu,%llu,%llu\n",
+            (unsigned long long)sample->elapsed_ms, (unsigned long long)sample->rss_bytes,
+            (unsigned long long)sample->heap_bytes, (unsigned long long)sample->live_allocation_count,
+            (unsigned long long)sample->messages_received, (unsigned long long)sample->bytes_received);
+        (void)fflush(csv_file);
+    }
+}
+
+typedef uint64_t(*GET_SAMPLE_FIGURE)(const SOAK_SAMPLE* sample);
+
+static uint64_t get_rss_figure(const SOAK_SAMPLE* sample)
+{
+    return sample->rss_bytes;
+}
+
+static uint64_t get_heap_figure(const SOAK_SAMPLE* sample)
+{
+    return sample->heap_bytes;
+}
+
+static uint64_t get_live_allocation_figure(const SOAK_SAMPLE* sample)
+{
+    return sample->live_allocation_count;
+}
+
+/* least squares slope of a figure over the samples taken after the warm-up, per hour; false when there are too few */
+static bool get_growth_per_hour(GET_SAMPLE_FIGURE get_figure, double* growth_per_hour)
+{
+    double sum_x = 0;
+    double sum_y = 0;
+    double sum_xx = 0;
+    double sum_xy = 0;
+    size_t count = 0;
+    size_t i;
+    bool result;
+
+    for (i = 0; i < sample_count; i++)
+    {
+        if (samples[i].elapsed_ms >= config.warmup)
+        {
+            double x = (double)samples[i].elapsed_ms / 3600000.0;
+            double y = (double)get_figure(&samples[i]);
+
+            sum_x += x;
+            sum_y += y;
+            sum_xx += x * x;
+            sum_xy += x * y;
+            count++;
+        }
+    }
+
+    if ((count < 3) ||
+        ((((double)count * sum_xx) - (sum_x * sum_x)) <= 0))
+    {
+        result = false;
+    }
+    else
+    {
+        *growth_per_hour = (((double)count * sum_xy) - (sum_x * sum_y)) / (((double)count * sum_xx) - (sum_x * sum_x));
+        result = true;
+    }
+
+    return result;
+}
+
+static int print_report(void)
+{
+    int result = 0;
+    double rss_growth;
+    double heap_growth;
+    double live_allocation_growth;
+    double max_growth_bytes = config.max_growth_kb_per_hour * 1024;
+
+    (void)printf("clients=%u links=%u message_size=%u..%u outstanding=%u reconnect=%us link_churn=%us management=%ums warmup=%us\n",
+        (unsigned int)config.client_count, (unsigned int)config.links_per_session,
+        (unsigned int)config.min_message_size, (unsigned int)config.max_message_size,
+        (unsigned int)config.outstanding_message_count, (unsigned int)(config.reconnect_interval / 1000),
+        (unsigned int)(config.link_churn_interval / 1000), (unsigned int)config.management_interval,
+        (unsigned int)(config.warmup / 1000));
+    (void)printf("sent %llu, received %llu messages\n",
+        (unsigned long long)total_messages_sent, (unsigned long long)total_messages_received);
+
+    if (!get_growth_per_hour(get_rss_figure, &rss_growth))
+    {
+        (void)printf("growth: not enough samples after the warm-up\n");
+    }
+    else
+    {
+        (void)printf("rss growth: %.0f KB/hour%s\n", rss_growth / 1024,
+            (rss_growth > max_growth_bytes) ? "  <-- GROWTH" : "");
+        if (rss_growth > max_growth_bytes)
+        {
+            result = __LINE__;
+        }
+
+        if (has_heap_bytes() &&
+            get_growth_per_hour(get_heap_figure, &heap_growth) &&
+            (samples[sample_count - 1].heap_bytes > 0))
+        {
+            const SOAK_SAMPLE* last_sample = &samples[sample_count - 1];
+
+            (void)printf("heap growth: %.0f KB/hour%s\n", heap_growth / 1024,
+                (heap_growth > max_growth_bytes) ? "  <-- GROWTH" : "");
+            if (heap_growth > max_growth_bytes)
+            {
+                result = __LINE__;
+            }
+
+            /* the RSS growing while the heap in use does not is the allocator fragmenting */
+            (void)printf("fragmentation: rss is %.2f times the heap in use, %llu KB not in use\n",
+                (double)last_sample->rss_bytes / (double)last_sample->heap_bytes,
+                (unsigned long long)((last_sample->rss_bytes > last_sample->heap_bytes) ? (last_sample->rss_bytes - last_sample->heap_bytes) / 1024 : 0));
+        }
+
+        if (alloc_counters_are_enabled() &&
+            get_growth_per_hour(get_live_allocation_figure, &live_allocation_growth))
+        {
+            (void)printf("live allocation growth: %.0f allocations/hour\n", live_allocation_growth);
+        }
+
+        print_object_usage();
+    }
+
+    return result;
+}
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s [options]\n"
+        "  --clients <count>              client connections (default 4)\n"
+        "  --links <count>                sender links per client session (default 2)\n"
+        "  --min-message-size <bytes>     smallest body (default 16)\n"
+        "  --max-message-size <bytes>     biggest body (default 65536)\n"
+        "  --outstanding <count>          messages in flight per link (default 4)\n"
+        "  --duration <s>                 run time (default 3600)\n"
+        "  --sample-interval <s>          time between two samples (default 10)\n"
+        "  --warmup <s>                   time before the growth is measured (default 300)\n"
+        "  --reconnect-interval <s>       time between two client reconnects, 0 for none (default 60)\n"
+        "  --link-churn-interval <s>      time between two link re-attaches, 0 for none (default 5)\n"
+        "  --management-interval <ms>     time between two management operations per client, 0 for none (default 1000)\n"
+        "  --max-growth <KB/hour>         growth of the rss or heap flagged as a failure (default 1024)\n"
+        "  --seed <number>                seed of the message sizes and churn choices (default 1)\n"
+        "  --port <port>                  listening port (default 5673)\n"
+        "  --csv <path>                   file the samples are also written to\n",
+        program_name);
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned long number = (value == NULL) ? 0 : strtoul(value, NULL, 10);
+
+        if (value == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--clients") == 0)
+        {
+            config.client_count = number;
+        }
+        else if (strcmp(argv[i], "--links") == 0)
+        {
+            config.links_per_session = number;
+        }
+        else if (strcmp(argv[i], "--min-message-size") == 0)
+        {
+            config.min_message_size = number;
+        }
+        else if (strcmp(argv[i], "--max-message-size") == 0)
+        {
+            config.max_message_size = number;
+        }
+        else if (strcmp(argv[i], "--outstanding") == 0)
+        {
+            config.outstanding_message_count = number;
+        }
+        else if (strcmp(argv[i], "--duration") == 0)
+        {
+            config.duration = (tickcounter_ms_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--sample-interval") == 0)
+        {
+            config.sample_interval = (tickcounter_ms_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0)
+        {
+            config.warmup = (tickcounter_ms_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--reconnect-interval") == 0)
+        {
+            config.reconnect_interval = (tickcounter_ms_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--link-churn-interval") == 0)
+        {
+            config.link_churn_interval = (tickcounter_ms_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--management-interval") == 0)
+        {
+            config.management_interval = number;
+        }
+        else if (strcmp(argv[i], "--max-growth") == 0)
+        {
+            config.max_growth_kb_per_hour = strtod(value, NULL);
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            config.seed = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--port") == 0)
+        {
+            config.port = (int)number;
+        }
+        else if (strcmp(argv[i], "--csv") == 0)
+        {
+            config.csv_path = value;
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    if ((result == 0) &&
+        ((config.client_count == 0) ||
+        (config.links_per_session == 0) ||
+        (config.outstanding_message_count == 0) ||
+        (config.min_message_size == 0) ||
+        (config.max_message_size < config.min_message_size) ||
+        (config.sample_interval == 0)))
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+/* server side */
+
+typedef struct SERVER_LINK_TAG
+{
+    LINK_HANDLE link;
+    /* one of them, depending on the role of the client's link */
+    MESSAGE_RECEIVER_HANDLE message_receiver;
+    MESSAGE_SENDER_HANDLE message_sender;
+    struct SERVER_CONNECTED_CLIENT_TAG* server_connected_client;
+    bool is_closed;
+} SERVER_LINK;
+
+typedef struct SERVER_CONNECTED_CLIENT_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    SINGLYLINKEDLIST_HANDLE links;
+    /* the link the management responses go back on */
+    SERVER_LINK* reply_link;
+    XIO_HANDLE io;
+    /* the header detect io does not destroy the socket io under it */
+    XIO_HANDLE underlying_io;
+    bool is_closed;
+} SERVER_CONNECTED_CLIENT;
+
+static void destroy_server_link(SERVER_LINK* server_link)
+{
+    if (server_link->server_connected_client->reply_link == server_link)
+    {
+        server_link->server_connected_client->reply_link = NULL;
+    }
+
+    if (server_link->message_receiver != NULL)
+    {
+        messagereceiver_destroy(server_link->message_receiver);
+    }
+
+    if (server_link->message_sender != NULL)
+    {
+        messagesender_destroy(server_link->message_sender);
+    }
+
+    link_destroy(server_link->link);
+    free(server_link);
+}
+
+static void on_server_receiver_state_changed(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state)
+{
+    (void)previous_state;
+
+    /* the client detached its link, the server link is destroyed once the current dowork is done */
+    if ((new_state == MESSAGE_RECEIVER_STATE_IDLE) ||
+        (new_state == MESSAGE_RECEIVER_STATE_ERROR))
+    {
+        ((SERVER_LINK*)context)->is_closed = true;
+    }
+}
+
+static void on_server_sender_state_changed(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
+{
+    (void)previous_state;
+
+    if ((new_state == MESSAGE_SENDER_STATE_IDLE) ||
+        (new_state == MESSAGE_SENDER_STATE_ERROR))
+    {
+        ((SERVER_LINK*)context)->is_closed = true;
+    }
+}
+
+static void on_management_response_sent(void* context, MESSAGE_SEND_RESULT send_result)
+{
+    (void)context;
+    (void)send_result;
+}
+
+/* answers like a management node would: correlation-id set to the request's message-id, statusCode 200 */
+static int send_management_response(SERVER_LINK* reply_link, AMQP_VALUE request_message_id)
+{
+    int result;
+    MESSAGE_HANDLE response = message_create();
+    PROPERTIES_HANDLE properties = properties_create();
+    AMQP_VALUE application_properties = amqpvalue_create_map();
+    AMQP_VALUE status_code_key = amqpvalue_create_string("statusCode");
+    AMQP_VALUE status_code = amqpvalue_create_int(200);
+
+    if ((response == NULL) ||
+        (properties == NULL) ||
+        (application_properties == NULL) ||
+        (status_code_key == NULL) ||
+        (status_code == NULL) ||
+        (properties_set_correlation_id(properties, request_message_id) != 0) ||
+        (message_set_properties(response, properties) != 0) ||
+        (amqpvalue_set_map_value(application_properties, status_code_key, status_code) != 0) ||
+        (message_set_application_properties(response, application_properties) != 0))
+    {
+        LogError("Cannot create the management response");
+        result = __LINE__;
+    }
+    else if (messagesender_send_async(reply_link->message_sender, response, on_management_response_sent, NULL, 0) == NULL)
+    {
+        LogError("Cannot send the management response");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (status_code != NULL)
+    {
+        amqpvalue_destroy(status_code);
+    }
+
+    if (status_code_key != NULL)
+    {
+        amqpvalue_destroy(status_code_key);
+    }
+
+    if (application_properties != NULL)
+    {
+        amqpvalue_destroy(application_properties);
+    }
+
+    if (properties != NULL)
+    {
+        properties_destroy(properties);
+    }
+
+    if (response != NULL)
+    {
+        message_destroy(response);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE on_server_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    SERVER_LINK* server_link = (SERVER_LINK*)context;
+    PROPERTIES_HANDLE properties;
+    AMQP_VALUE message_id;
+    AMQP_VALUE result;
+
+    /* only the management requests carry properties */
+    if ((message_get_properties(message, &properties) == 0) &&
+        (properties != NULL))
+    {
+        if ((properties_get_message_id(properties, &message_id) != 0) ||
+            (server_link->server_connected_client->reply_link == NULL) ||
+            (send_management_response(server_link->server_connected_client->reply_link, message_id) != 0))
+        {
+            result = messaging_delivery_rejected("amqp:internal-error", "Cannot answer the management request");
+        }
+        else
+        {
+            result = messaging_delivery_accepted();
+        }
+
+        properties_destroy(properties);
+    }
+    else
+    {
+        BINARY_DATA binary_data;
+
+        total_messages_received++;
+        if (message_get_body_amqp_data_in_place(message, 0, &binary_data) == 0)
+        {
+            total_bytes_received += binary_data.length;
+        }
+
+        result = messaging_delivery_accepted();
+    }
+
+    return result;
+}
+
+static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    SERVER_LINK* server_link = (SERVER_LINK*)calloc(1, sizeof(SERVER_LINK));
+    bool result;
+
+    if (server_link == NULL)
+    {
+        LogError("Cannot allocate the server link");
+        result = false;
+    }
+    else if ((server_link->link = link_create_from_endpoint(server_connected_client->session, new_link_endpoint, name, role, source, target)) == NULL)
+    {
+        LogError("Cannot create link");
+        free(server_link);
+        result = false;
+    }
+    else
+    {
+        server_link->server_connected_client = server_connected_client;
+
+        if (role == role_sender)
+        {
+            /* the client sends, be it messages or management requests */
+            if ((link_set_rcv_settle_mode(server_link->link, receiver_settle_mode_first) != 0) ||
+                (link_set_max_link_credit(server_link->link, (uint32_t)(config.outstanding_message_count * 2)) != 0) ||
+                ((server_link->message_receiver = messagereceiver_create(server_link->link, on_server_receiver_state_changed, server_link)) == NULL) ||
+                (messagereceiver_open(server_link->message_receiver, on_server_message_received, server_link) != 0))
+            {
+                LogError("Cannot open the server message receiver");
+                result = false;
+            }
+            else
+            {
+                result = true;
+            }
+        }
+        else
+        {
+            /* the client's management receiver, where the responses go */
+            if (((server_link->message_sender = messagesender_create(server_link->link, on_server_sender_state_changed, server_link)) == NULL) ||
+                (messagesender_open(server_link->message_sender) != 0))
+            {
+                LogError("Cannot open the server message sender");
+                result = false;
+            }
+            else
+            {
+                server_connected_client->reply_link = server_link;
+                result = true;
+            }
+        }
+
+        if (result && (singlylinkedlist_add(server_connected_client->links, server_link) == NULL))
+        {
+            LogError("Cannot add the server link");
+            result = false;
+        }
+
+        if (!result)
+        {
+            destroy_server_link(server_link);
+        }
+    }
+
+    return result;
+}
+
+static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    bool result;
+
+    if (server_connected_client->session != NULL)
+    {
+        LogError("Only one session per connection");
+        result = false;
+    }
+    else if ((server_connected_client->session = session_create_from_endpoint(server_connected_client->connection, new_endpoint, on_new_link_attached, server_connected_client)) == NULL)
+    {
+        LogError("Cannot create session");
+        result = false;
+    }
+    else if (session_begin(server_connected_client->session) != 0)
+    {
+        session_destroy(server_connected_client->session);
+        server_connected_client->session = NULL;
+        LogError("Cannot begin session");
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+
+    return result;
+}
+
+static void on_server_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
+{
+    (void)previous_connection_state;
+
+    if ((new_connection_state == CONNECTION_STATE_END) ||
+        (new_connection_state == CONNECTION_STATE_ERROR) ||
+        (new_connection_state == CONNECTION_STATE_DISCARDING))
+    {
+        ((SERVER_CONNECTED_CLIENT*)context)->is_closed = true;
+    }
+}
+
+static void on_server_io_error(void* context)
+{
+    ((SERVER_CONNECTED_CLIENT*)context)->is_closed = true;
+}
+
+static void destroy_server_connected_client(SERVER_CONNECTED_CLIENT* server_connected_client)
+{
+    LIST_ITEM_HANDLE link_item = singlylinkedlist_get_head_item(server_connected_client->links);
+
+    while (link_item != NULL)
+    {
+        destroy_server_link((SERVER_LINK*)singlylinkedlist_item_get_value(link_item));
+        (void)singlylinkedlist_remove(server_connected_client->links, link_item);
+        link_item = singlylinkedlist_get_head_item(server_connected_client->links);
+    }
+
+    singlylinkedlist_destroy(server_connected_client->links);
+
+    if (server_connected_client->session != NULL)
+    {
+        session_destroy(server_connected_client->session);
+    }
+
+    connection_destroy(server_connected_client->connection);
+    xio_destroy(server_connected_client->io);
+    xio_destroy(server_connected_client->underlying_io);
+    free(server_connected_client);
+}
+
+static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* interface_description, void* io_parameters)
+{
+    HEADER_DETECT_IO_CONFIG header_detect_io_config;
+    HEADER_DETECT_ENTRY header_detect_entries[1];
+    XIO_HANDLE underlying_io;
+    SERVER_CONNECTED_CLIENT* server_connected_client;
+
+    (void)context;
+
+    header_detect_entries[0].header = header_detect_io_get_amqp_header();
+    header_detect_entries[0].io_interface_description = NULL;
+
+    if ((underlying_io = xio_create(interface_description, io_parameters)) == NULL)
+    {
+        LogError("Cannot create accepted socket IO");
+    }
+    else if ((server_connected_client = (SERVER_CONNECTED_CLIENT*)calloc(1, sizeof(SERVER_CONNECTED_CLIENT))) == NULL)
+    {
+        LogError("Cannot allocate the server connected client");
+        xio_destroy(underlying_io);
+    }
+    else
+    {
+        header_detect_io_config.underlying_io = underlying_io;
+        header_detect_io_config.header_detect_entry_count = 1;
+        header_detect_io_config.header_detect_entries = header_detect_entries;
+
+        if ((server_connected_client->io = xio_create(header_detect_io_get_interface_description(), &header_detect_io_config)) == NULL)
+        {
+            LogError("Cannot create header detect IO");
+            free(server_connected_client);
+            xio_destroy(underlying_io);
+        }
+        else if ((server_connected_client->links = singlylinkedlist_create()) == NULL)
+        {
+            LogError("Cannot create the server links list");
+            xio_destroy(server_connected_client->io);
+            free(server_connected_client);
+            xio_destroy(underlying_io);
+        }
+        else if ((server_connected_client->connection = connection_create2(server_connected_client->io, NULL, "soak-server", on_new_session_endpoint, server_connected_client,
+            on_server_connection_state_changed, server_connected_client, on_server_io_error, server_connected_client)) == NULL)
+        {
+            LogError("Cannot create the server connection");
+            singlylinkedlist_destroy(server_connected_client->links);
+            xio_destroy(server_connected_client->io);
+            free(server_connected_client);
+            xio_destroy(underlying_io);
+        }
+        else
+        {
+            server_connected_client->underlying_io = underlying_io;
+
+            if ((connection_listen(server_connected_client->connection) != 0) ||
+                (singlylinkedlist_add(server_connected_clients, server_connected_client) == NULL))
+            {
+                LogError("Cannot listen on the server connection");
+                destroy_server_connected_client(server_connected_client);
+            }
+        }
+    }
+}
+
+static bool is_server_link_closed(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    (void)match_context;
+    return ((const SERVER_LINK*)singlylinkedlist_item_get_value(list_item))->is_closed;
+}
+
+/* frees what the clients left behind, otherwise the server's own leftovers would look like growth */
+static void reap_server_side(void)
+{
+    LIST_ITEM_HANDLE current_item = singlylinkedlist_get_head_item(server_connected_clients);
+
+    while (current_item != NULL)
+    {
+        SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
+        LIST_ITEM_HANDLE next_item = singlylinkedlist_get_next_item(current_item);
+
+        connection_dowork(server_connected_client->connection);
+
+        if (server_connected_client->is_closed)
+        {
+            (void)singlylinkedlist_remove(server_connected_clients, current_item);
+            destroy_server_connected_client(server_connected_client);
+        }
+        else
+        {
+            LIST_ITEM_HANDLE link_item;
+
+            while ((link_item = singlylinkedlist_find(server_connected_client->links, is_server_link_closed, NULL)) != NULL)
+            {
+                destroy_server_link((SERVER_LINK*)singlylinkedlist_item_get_value(link_item));
+                (void)singlylinkedlist_remove(server_connected_client->links, link_item);
+            }
+        }
+
+        current_item = next_item;
+    }
+}
+
+/* client side */
+
+typedef struct CLIENT_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_SENDER_HANDLE message_sender;
+    size_t outstanding_message_count;
+} CLIENT_LINK;
+
+typedef struct CLIENT_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    CLIENT_LINK* links;
+    size_t link_count;
+    AMQP_MANAGEMENT_HANDLE amqp_management;
+    bool is_management_open;
+    bool is_management_operation_pending;
+    tickcounter_ms_t last_management_operation_ms;
+    XIO_HANDLE io;
+} CLIENT;
+
+static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+{
+    CLIENT_LINK* client_link = (CLIENT_LINK*)context;
+    client_link->outstanding_message_count--;
+    (void)send_result;
+}
+
+static void on_management_open_complete(void* context, AMQP_MANAGEMENT_OPEN_RESULT open_result)
+{
+    ((CLIENT*)context)->is_management_open = (open_result == AMQP_MANAGEMENT_OPEN_OK);
+}
+
+static void on_management_error(void* context)
+{
+    ((CLIENT*)context)->is_management_open = false;
+}
+
+static void on_management_operation_complete(void* context, AMQP_MANAGEMENT_EXECUTE_OPERATION_RESULT execute_operation_result, unsigned int status_code, const char* status_description, MESSAGE_HANDLE message_handle)
+{
+    (void)status_description;
+    (void)message_handle;
+
+    ((CLIENT*)context)->is_management_operation_pending = false;
+    total_management_operations++;
+    if ((execute_operation_result != AMQP_MANAGEMENT_EXECUTE_OPERATION_OK) ||
+        (status_code != 200))
+    {
+        total_management_failures++;
+    }
+}
+
+static void destroy_client_link(CLIENT_LINK* client_link)
+{
+    messagesender_destroy(client_link->message_sender);
+    link_destroy(client_link->link);
+}
+
+static void destroy_client(CLIENT* client)
+{
+    size_t i;
+
+    for (i = 0; i < client->link_count; i++)
+    {
+        destroy_client_link(&client->links[i]);
+    }
+
+    free(client->links);
+
+    if (client->amqp_management != NULL)
+    {
+        amqp_management_destroy(client->amqp_management);
+    }
+
+    if (client->session != NULL)
+    {
+        session_destroy(client->session);
+    }
+
+    if (client->connection != NULL)
+    {
+        connection_destroy(client->connection);
+    }
+
+    if (client->io != NULL)
+    {
+        xio_destroy(client->io);
+    }
+}
+
+static int create_client_link(CLIENT* client, size_t link_index)
+{
+    int result;
+    char link_name[32];
+    AMQP_VALUE source;
+    AMQP_VALUE target;
+    CLIENT_LINK* client_link = &client->links[link_index];
+
+    (void)sprintf(link_name, "sender-link-%u", (unsigned int)link_index);
+    source = messaging_create_source("ingress");
+    target = messaging_create_target("localhost/ingress");
+
+    client_link->link = link_create(client->session, link_name, role_sender, source, target);
+    if (client_link->link == NULL)
+    {
+        LogError("Cannot create client link");
+        result = __LINE__;
+    }
+    else if ((link_set_snd_settle_mode(client_link->link, sender_settle_mode_unsettled) != 0) ||
+        (link_set_max_message_size(client_link->link, 65536 + config.max_message_size) != 0))
+    {
+        LogError("Cannot set link properties");
+        link_destroy(client_link->link);
+        result = __LINE__;
+    }
+    else
+    {
+        client_link->message_sender = messagesender_create(client_link->link, NULL, NULL);
+        if (client_link->message_sender == NULL)
+        {
+            LogError("Cannot create client message sender");
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else if (messagesender_open(client_link->message_sender) != 0)
+        {
+            LogError("Cannot open client message sender");
+            messagesender_destroy(client_link->message_sender);
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else
+        {
+            client_link->outstanding_message_count = 0;
+            result = 0;
+        }
+    }
+
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(target);
+
+    return result;
+}
+
+static int create_client(CLIENT* client)
+{
+    int result;
+    SOCKETIO_CONFIG socketio_config = { "localhost", 0, NULL };
+
+    socketio_config.port = config.port;
+
+    client->connection = NULL;
+    client->session = NULL;
+    client->link_count = 0;
+    client->amqp_management = NULL;
+    client->is_management_open = false;
+    client->is_management_operation_pending = false;
+    client->last_management_operation_ms = 0;
+    client->links = (CLIENT_LINK*)calloc(config.links_per_session, sizeof(CLIENT_LINK));
+    client->io = xio_create(socketio_get_interface_description(), &socketio_config);
+    if ((client->links == NULL) ||
+        (client->io == NULL))
+    {
+        LogError("Cannot create client IO");
+        result = __LINE__;
+    }
+    else if ((client->connection = connection_create(client->io, "localhost", "soak-client", NULL, NULL)) == NULL)
+    {
+        LogError("Cannot create client connection");
+        result = __LINE__;
+    }
+    else if ((client->session = session_create(client->connection, NULL, NULL)) == NULL)
+    {
+        LogError("Cannot create client session");
+        result = __LINE__;
+    }
+    else if ((config.management_interval > 0) &&
+        (((client->amqp_management = amqp_management_create(client->session, MANAGEMENT_NODE)) == NULL) ||
+        (amqp_management_open_async(client->amqp_management, on_management_open_complete, client, on_management_error, client) != 0)))
+    {
+        LogError("Cannot open the client management");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+
+        while ((result == 0) && (client->link_count < config.links_per_session))
+        {
+            result = create_client_link(client, client->link_count);
+            if (result == 0)
+            {
+                client->link_count++;
+            }
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_client(client);
+    }
+
+    return result;
+}
+
+static int send_messages(CLIENT_LINK* client_link, unsigned char* payload)
+{
+    int result = 0;
+
+    while ((result == 0) && (client_link->outstanding_message_count < config.outstanding_message_count))
+    {
+        MESSAGE_HANDLE message = message_create();
+        BINARY_DATA binary_data;
+
+        binary_data.bytes = payload;
+        binary_data.length = get_random_message_size();
+
+        if (message == NULL)
+        {
+            LogError("Error creating message");
+            result = __LINE__;
+        }
+        else
+        {
+            if (message_add_body_amqp_data(message, binary_data) != 0)
+            {
+                LogError("Error setting message body");
+                result = __LINE__;
+            }
+            else if (messagesender_send_async(client_link->message_sender, message, on_message_send_complete, client_link, 0) == NULL)
+            {
+                LogError("Error sending message");
+                result = __LINE__;
+            }
+            else
+            {
+                client_link->outstanding_message_count++;
+                total_messages_sent++;
+            }
+
+            message_destroy(message);
+        }
+    }
+
+    return result;
+}
+
+static int execute_management_operation(CLIENT* client, tickcounter_ms_t current_ms)
+{
+    int result;
+
+    if ((client->amqp_management == NULL) ||
+        !client->is_management_open ||
+        client->is_management_operation_pending ||
+        (current_ms - client->last_management_operation_ms < config.management_interval))
+    {
+        result = 0;
+    }
+    else
+    {
+        MESSAGE_HANDLE request = message_create();
+        if (request == NULL)
+        {
+            LogError("Cannot create the management request");
+            result = __LINE__;
+        }
+        else
+        {
+            if (amqp_management_execute_operation_async(client->amqp_management, "READ", "soak", NULL, request, on_management_operation_complete, client) != 0)
+            {
+                LogError("Cannot execute the management operation");
+                result = __LINE__;
+            }
+            else
+            {
+                client->is_management_operation_pending = true;
+                client->last_management_operation_ms = current_ms;
+                result = 0;
+            }
+
+            message_destroy(request);
+        }
+    }
+
+    return result;
+}
+
+static int run_client(CLIENT* client, unsigned char* payload, tickcounter_ms_t current_ms)
+{
+    int result = 0;
+    size_t i;
+
+    connection_dowork(client->connection);
+
+    for (i = 0; (result == 0) && (i < client->link_count); i++)
+    {
+        result = send_messages(&client->links[i], payload);
+    }
+
+    if (result == 0)
+    {
+        result = execute_management_operation(client, current_ms);
+    }
+
+    return result;
+}
+
+static int reconnect_client(CLIENT* client)
+{
+    destroy_client(client);
+    total_reconnects++;
+    return create_client(client);
+}
+
+static int churn_link(CLIENT* client)
+{
+    size_t link_index = get_random() % client->link_count;
+
+    destroy_client_link(&client->links[link_index]);
+    total_link_churns++;
+    return create_client_link(client, link_index);
+}
+
+static int run_soak(CLIENT* clients, SOCKET_LISTENER_HANDLE socket_listener, unsigned char* payload, TICK_COUNTER_HANDLE tick_counter, FILE* csv_file)
+{
+    int result;
+    tickcounter_ms_t start_ms;
+    tickcounter_ms_t current_ms;
+    tickcounter_ms_t next_sample_ms;
+    tickcounter_ms_t next_reconnect_ms;
+    tickcounter_ms_t next_link_churn_ms;
+
+    if (tickcounter_get_current_ms(tick_counter, &start_ms) != 0)
+    {
+        LogError("Cannot get tick counter value");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t next_reconnect_client = 0;
+
+        result = 0;
+        current_ms = start_ms;
+        next_sample_ms = start_ms + config.sample_interval;
+        next_reconnect_ms = start_ms + config.reconnect_interval;
+        next_link_churn_ms = start_ms + config.link_churn_interval;
+
+        take_sample(0);
+        print_sample(csv_file, &samples[0], NULL);
+
+        while ((result == 0) && (current_ms - start_ms < config.duration))
+        {
+            size_t i;
+
+            socketlistener_dowork(socket_listener);
+
+            for (i = 0; (result == 0) && (i < config.client_count); i++)
+            {
+                result = run_client(&clients[i], payload, current_ms);
+            }
+
+            reap_server_side();
+
+            if (result != 0)
+            {
+                LogError("Error processing clients");
+            }
+            else if (tickcounter_get_current_ms(tick_counter, &current_ms) != 0)
+            {
+                LogError("Cannot get tick counter value");
+                result = __LINE__;
+            }
+            else
+            {
+                if ((config.reconnect_interval > 0) &&
+                    (current_ms >= next_reconnect_ms))
+                {
+                    result = reconnect_client(&clients[next_reconnect_client]);
+                    next_reconnect_client = (next_reconnect_client + 1) % config.client_count;
+                    next_reconnect_ms += config.reconnect_interval;
+                }
+
+                if ((result == 0) &&
+                    (config.link_churn_interval > 0) &&
+                    (current_ms >= next_link_churn_ms))
+                {
+                    result = churn_link(&clients[get_random() % config.client_count]);
+                    next_link_churn_ms += config.link_churn_interval;
+                }
+
+                if (current_ms >= next_sample_ms)
+                {
+                    take_sample(current_ms - start_ms);
+                    if (sample_count > 1)
+                    {
+                        print_sample(csv_file, &samples[sample_count - 1], &samples[sample_count - 2]);
+                    }
+
+                    next_sample_ms += config.sample_interval;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        result = -1;
+    }
+    else if (platform_init() != 0)
+    {
+        LogError("platform_init failed");
+        result = -1;
+    }
+    else
+    {
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+        (void)gballoc_init();
+#endif
+        random_state = config.seed;
+
+        server_connected_clients = singlylinkedlist_create();
+        if (server_connected_clients == NULL)
+        {
+            LogError("Cannot create server connected clients list");
+            result = -1;
+        }
+        else
+        {
+            SOCKET_LISTENER_HANDLE socket_listener = socketlistener_create(config.port);
+            if (socket_listener == NULL)
+            {
+                LogError("Cannot create socket listener");
+                result = -1;
+            }
+            else
+            {
+                if (socketlistener_start(socket_listener, on_socket_accepted, NULL) != 0)
+                {
+                    LogError("socketlistener_start failed");
+                    result = -1;
+                }
+                else
+                {
+                    size_t i;
+                    size_t client_count = 0;
+                    CLIENT* clients = (CLIENT*)malloc(sizeof(CLIENT) * config.client_count);
+                    unsigned char* payload = (unsigned char*)calloc(1, config.max_message_size);
+                    TICK_COUNTER_HANDLE tick_counter = tickcounter_create();
+                    FILE* csv_file = (config.csv_path == NULL) ? NULL : fopen(config.csv_path, "w");
+
+                    if ((clients == NULL) ||
+                        (payload == NULL) ||
+                        (tick_counter == NULL) ||
+                        ((config.csv_path != NULL) && (csv_file == NULL)))
+                    {
+                        LogError("Cannot set up the soak");
+                        result = -1;
+                    }
+                    else
+                    {
+                        while ((client_count < config.client_count) &&
+                            (create_client(&clients[client_count]) == 0))
+                        {
+                            client_count++;
+                        }
+
+                        if (client_count < config.client_count)
+                        {
+                            LogError("Cannot create clients");
+                            result = -1;
+                        }
+                        else
+                        {
+                            if (csv_file != NULL)
+                            {
+                                (void)fprintf(csv_file, "elapsed_ms,rss_bytes,heap_bytes,live_allocations,messages_received,bytes_received\n");
+                            }
+
+                            if (run_soak(clients, socket_listener, payload, tick_counter, csv_file) != 0)
+                            {
+                                result = -1;
+                            }
+                            else
+                            {
+                                /* a growth after the warm-up fails the run, so that it can gate a nightly job */
+                                result = (print_report() == 0) ? 0 : 1;
+                            }
+                        }
+
+                        for (i = 0; i < client_count; i++)
+                        {
+                            destroy_client(&clients[i]);
+                        }
+                    }
+
+                    if (csv_file != NULL)
+                    {
+                        (void)fclose(csv_file);
+                    }
+
+                    if (tick_counter != NULL)
+                    {
+                        tickcounter_destroy(tick_counter);
+                    }
+
+                    free(payload);
+                    free(clients);
+
+                    (void)socketlistener_stop(socket_listener);
+                }
+
+                socketlistener_destroy(socket_listener);
+            }
+
+            {
+                LIST_ITEM_HANDLE current_item = singlylinkedlist_get_head_item(server_connected_clients);
+
+                while (current_item != NULL)
+                {
+                    destroy_server_connected_client((SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item));
+                    (void)singlylinkedlist_remove(server_connected_clients, current_item);
+                    current_item = singlylinkedlist_get_head_item(server_connected_clients);
+                }
+            }
+
+            singlylinkedlist_destroy(server_connected_clients);
+            free(samples);
+        }
+
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+        gballoc_deinit();
+#endif
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,1285 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/wsio.h"
+#include "azure_uamqp_c/uamqp.h"
+#include "azure_uamqp_c/sasl_server_mechanism.h"
+#include "test_sasl_server_io.h"
+
+/* Runs the same workload (connection setups, then unsettled sends for a fixed time) over each transport stack and
+   reports the setup time, the throughput and the CPU time per message, so that the cost of each layer shows against
+   the plain TCP stack. The local stacks run against an in-process server, so their CPU time covers both ends; the
+   TLS and WebSocket stacks need a broker given with --remote-host (this tree has no TLS or WebSocket server IO) and
+   their CPU time is the client's only. */
+
+typedef enum TRANSPORT_TAG
+{
+    TRANSPORT_TCP_DIRECT,
+    TRANSPORT_TCP,
+    TRANSPORT_SASL_ANONYMOUS,
+    TRANSPORT_SASL_PLAIN,
+    TRANSPORT_SASL_MSSBCBS,
+    TRANSPORT_TLS_SASL_PLAIN,
+    TRANSPORT_WSS_SASL_PLAIN,
+    TRANSPORT_COUNT
+} TRANSPORT;
+
+/* in the order of TRANSPORT */
+static const char* transport_names[TRANSPORT_COUNT] =
+{
+    "tcp-direct", "tcp", "sasl-anonymous", "sasl-plain", "sasl-mssbcbs", "tls-sasl-plain", "wss-sasl-plain"
+};
+
+typedef struct TRANSPORT_PERF_CONFIG_TAG
+{
+    bool transports[TRANSPORT_COUNT];
+    size_t links_per_session;
+    size_t message_size;
+    size_t outstanding_message_count;
+    size_t setup_iterations;
+    uint64_t duration_us;
+    int port;
+    const char* user;
+    const char* password;
+    const char* remote_host;
+    int remote_tls_port;
+    int remote_wss_port;
+    const char* remote_wss_path;
+    const char* remote_address;
+} TRANSPORT_PERF_CONFIG;
+
+static TRANSPORT_PERF_CONFIG config = { { true, true, true, true, true, false, false }, 1, 256, 100, 20, 5000000, 5675, "user", "password", NULL, 5671, 443, "/$servicebus/websocket", "ingress" };
+
+/* a setup taking longer than this fails the transport */
+#define SETUP_TIMEOUT_US 10000000
+
+typedef struct SETUP_RESULT_TAG
+{
+    double mean_ms;
+    double p50_ms;
+    double max_ms;
+} SETUP_RESULT;
+
+typedef struct THROUGHPUT_RESULT_TAG
+{
+    uint64_t messages;
+    double seconds;
+    double cpu_us_per_message;
+    double cpu_percent;
+} THROUGHPUT_RESULT;
+
+static SINGLYLINKEDLIST_HANDLE server_connected_clients;
+/* the server stack of the connections accepted while a transport runs */
+static TRANSPORT server_transport;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+/* user and kernel time of the process */
+static uint64_t get_cpu_time_us(void)
+{
+#ifdef _WIN32
+    FILETIME creation_time;
+    FILETIME exit_time;
+    FILETIME kernel_time;
+    FILETIME user_time;
+    uint64_t result;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        result = 0;
+    }
+    else
+    {
+        /* 100 ns units */
+        result = ((((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime) +
+            (((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime)) / 10;
+    }
+
+    return result;
+#else
+    struct rusage usage;
+    uint64_t result;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = ((uint64_t)usage.ru_utime.tv_sec * 1000000) + (uint64_t)usage.ru_utime.tv_usec +
+            ((uint64_t)usage.ru_stime.tv_sec * 1000000) + (uint64_t)usage.ru_stime.tv_usec;
+    }
+
+    return result;
+#endif
+}
+
+static bool is_remote_transport(TRANSPORT transport)
+{
+    return (transport == TRANSPORT_TLS_SASL_PLAIN) || (transport == TRANSPORT_WSS_SASL_PLAIN);
+}
+
+static void print_usage(const char* program_name)
+{
+    (void)printf("Usage: %s [options]\n"
+        "  --transports <list>            comma separated, among tcp-direct, tcp, sasl-anonymous, sasl-plain,\n"
+        "                                 sasl-mssbcbs (local) and tls-sasl-plain, wss-sasl-plain (with --remote-host)\n"
+        "                                 (default: all the local ones)\n"
+        "  --links <count>                sender links (default 1)\n"
+        "  --message-size <bytes>         body size of each message (default 256)\n"
+        "  --outstanding <count>          messages in flight per link (default 100)\n"
+        "  --setup-iterations <count>     connections set up and torn down to time the setup (default 20)\n"
+        "  --duration <ms>                time messages are sent for on each transport (default 5000)\n"
+        "  --port <port>                  local listening port (default 5675)\n"
+        "  --user <name>                  SASL PLAIN user (default user)\n"
+        "  --password <password>          SASL PLAIN password (default password)\n"
+        "  --remote-host <host>           broker for the TLS and WebSocket transports\n"
+        "  --remote-tls-port <port>       (default 5671)\n"
+        "  --remote-wss-port <port>       (default 443)\n"
+        "  --remote-wss-path <path>       WebSocket resource (default /$servicebus/websocket)\n"
+        "  --remote-address <address>     target of the sends on the broker (default ingress)\n",
+        program_name);
+}
+
+static int parse_transports(const char* value)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; i < TRANSPORT_COUNT; i++)
+    {
+        config.transports[i] = false;
+    }
+
+    while ((result == 0) && (*value != '\0'))
+    {
+        const char* end = strchr(value, ',');
+        size_t length = (end == NULL) ? strlen(value) : (size_t)(end - value);
+        bool is_found = false;
+
+        for (i = 0; i < TRANSPORT_COUNT; i++)
+        {
+            if ((strlen(transport_names[i]) == length) &&
+                (strncmp(transport_names[i], value, length) == 0))
+            {
+                config.transports[i] = true;
+                is_found = true;
+            }
+        }
+
+        if (!is_found)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            value += length + ((end == NULL) ? 0 : 1);
+        }
+    }
+
+    return result;
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned long number = (value == NULL) ? 0 : strtoul(value, NULL, 10);
+
+        if (value == NULL)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--transports") == 0)
+        {
+            result = parse_transports(value);
+        }
+        else if (strcmp(argv[i], "--links") == 0)
+        {
+            config.links_per_session = number;
+        }
+        else if (strcmp(argv[i], "--message-size") == 0)
+        {
+            config.message_size = number;
+        }
+        else if (strcmp(argv[i], "--outstanding") == 0)
+        {
+            config.outstanding_message_count = number;
+        }
+        else if (strcmp(argv[i], "--setup-iterations") == 0)
+        {
+            config.setup_iterations = number;
+        }
+        else if (strcmp(argv[i], "--duration") == 0)
+        {
+            config.duration_us = (uint64_t)number * 1000;
+        }
+        else if (strcmp(argv[i], "--port") == 0)
+        {
+            config.port = (int)number;
+        }
+        else if (strcmp(argv[i], "--user") == 0)
+        {
+            config.user = value;
+        }
+        else if (strcmp(argv[i], "--password") == 0)
+        {
+            config.password = value;
+        }
+        else if (strcmp(argv[i], "--remote-host") == 0)
+        {
+            config.remote_host = value;
+        }
+        else if (strcmp(argv[i], "--remote-tls-port") == 0)
+        {
+            config.remote_tls_port = (int)number;
+        }
+        else if (strcmp(argv[i], "--remote-wss-port") == 0)
+        {
+            config.remote_wss_port = (int)number;
+        }
+        else if (strcmp(argv[i], "--remote-wss-path") == 0)
+        {
+            config.remote_wss_path = value;
+        }
+        else if (strcmp(argv[i], "--remote-address") == 0)
+        {
+            config.remote_address = value;
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    if ((result == 0) &&
+        ((config.links_per_session == 0) ||
+        (config.message_size == 0) ||
+        (config.outstanding_message_count == 0) ||
+        (config.setup_iterations == 0) ||
+        (((config.transports[TRANSPORT_TLS_SASL_PLAIN]) || (config.transports[TRANSPORT_WSS_SASL_PLAIN])) && (config.remote_host == NULL))))
+    {
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+/* server side */
+
+static CONCRETE_SASL_SERVER_MECHANISM_HANDLE test_sasl_server_mechanism_create(void* config_parameters)
+{
+    /* the handle only has to be non-NULL, the PLAIN check uses the configuration */
+    (void)config_parameters;
+    return (CONCRETE_SASL_SERVER_MECHANISM_HANDLE)&config;
+}
+
+static void test_sasl_server_mechanism_destroy(CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism)
+{
+    (void)concrete_sasl_server_mechanism;
+}
+
+static int accept_initial_response(CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, const char* hostname, bool* send_challenge, SASL_SERVER_MECHANISM_BYTES* challenge_bytes)
+{
+    (void)concrete_sasl_server_mechanism;
+    (void)initial_response_bytes;
+    (void)hostname;
+    (void)challenge_bytes;
+    *send_challenge = false;
+    return 0;
+}
+
+/* [authzid] NUL authcid NUL passwd */
+static int check_plain_initial_response(CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* initial_response_bytes, const char* hostname, bool* send_challenge, SASL_SERVER_MECHANISM_BYTES* challenge_bytes)
+{
+    const unsigned char* bytes = (const unsigned char*)initial_response_bytes->bytes;
+    size_t user_length = strlen(config.user);
+    size_t password_length = strlen(config.password);
+    const unsigned char* authcid = (initial_response_bytes->length == 0) ? NULL : (const unsigned char*)memchr(bytes, 0, initial_response_bytes->length);
+    int result;
+
+    (void)concrete_sasl_server_mechanism;
+    (void)hostname;
+    (void)challenge_bytes;
+    *send_challenge = false;
+
+    if ((authcid == NULL) ||
+        ((size_t)(bytes + initial_response_bytes->length - (authcid + 1)) != user_length + 1 + password_length) ||
+        (memcmp(authcid + 1, config.user, user_length) != 0) ||
+        (authcid[1 + user_length] != 0) ||
+        (memcmp(authcid + 2 + user_length, config.password, password_length) != 0))
+    {
+        LogError("Bad credentials");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int refuse_response(CONCRETE_SASL_SERVER_MECHANISM_HANDLE concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES* response_bytes, bool* send_next_challenge, SASL_SERVER_MECHANISM_BYTES* next_challenge_bytes)
+{
+    (void)concrete_sasl_server_mechanism;
+    (void)response_bytes;
+    (void)send_next_challenge;
+    (void)next_challenge_bytes;
+    return __LINE__;
+}
+
+static const char* get_anonymous_name(void)
+{
+    return "ANONYMOUS";
+}
+
+static const char* get_plain_name(void)
+{
+    return "PLAIN";
+}
+
+/* the token comes later with a CBS put-token, the mechanism itself accepts anything */
+static const char* get_mssbcbs_name(void)
+{
+    return "MSSBCBS";
+}
+
+static const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION anonymous_server_mechanism_interface =
+{
+    test_sasl_server_mechanism_create, test_sasl_server_mechanism_destroy, accept_initial_response, refuse_response, get_anonymous_name, NULL, NULL
+};
+
+static const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION plain_server_mechanism_interface =
+{
+    test_sasl_server_mechanism_create, test_sasl_server_mechanism_destroy, check_plain_initial_response, refuse_response, get_plain_name, NULL, NULL
+};
+
+static const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION mssbcbs_server_mechanism_interface =
+{
+    test_sasl_server_mechanism_create, test_sasl_server_mechanism_destroy, accept_initial_response, refuse_response, get_mssbcbs_name, NULL, NULL
+};
+
+typedef struct SERVER_CONNECTED_CLIENT_TAG
+{
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    SINGLYLINKEDLIST_HANDLE links;
+    XIO_HANDLE io;
+    /* NULL when the connection runs straight on the socket io */
+    XIO_HANDLE underlying_io;
+    bool is_closed;
+} SERVER_CONNECTED_CLIENT;
+
+typedef struct SERVER_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_RECEIVER_HANDLE message_receiver;
+} SERVER_LINK;
+
+static void on_message_receiver_state_changed(const void* context, MESSAGE_RECEIVER_STATE new_state, MESSAGE_RECEIVER_STATE previous_state)
+{
+    (void)context;
+    (void)new_state;
+    (void)previous_state;
+}
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    (void)context;
+    (void)message;
+
+    return messaging_delivery_accepted();
+}
+
+static bool on_new_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    SERVER_LINK* server_link = (SERVER_LINK*)calloc(1, sizeof(SERVER_LINK));
+    bool result;
+
+    if (server_link == NULL)
+    {
+        LogError("Cannot allocate the server link");
+        result = false;
+    }
+    else if ((server_link->link = link_create_from_endpoint(server_connected_client->session, new_link_endpoint, name, role, source, target)) == NULL)
+    {
+        LogError("Cannot create link");
+        free(server_link);
+        result = false;
+    }
+    else if ((link_set_rcv_settle_mode(server_link->link, receiver_settle_mode_first) != 0) ||
+        (link_set_max_link_credit(server_link->link, (uint32_t)(config.outstanding_message_count * 2)) != 0) ||
+        ((server_link->message_receiver = messagereceiver_create(server_link->link, on_message_receiver_state_changed, NULL)) == NULL))
+    {
+        LogError("Cannot create message receiver");
+        link_destroy(server_link->link);
+        free(server_link);
+        result = false;
+    }
+    else if ((messagereceiver_open(server_link->message_receiver, on_message_received, NULL) != 0) ||
+        (singlylinkedlist_add(server_connected_client->links, server_link) == NULL))
+    {
+        LogError("Cannot open message receiver");
+        messagereceiver_destroy(server_link->message_receiver);
+        link_destroy(server_link->link);
+        free(server_link);
+        result = false;
+    }
+    else
+    {
+        /* all OK */
+        result = true;
+    }
+
+    return result;
+}
+
+static bool on_new_session_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)context;
+    bool result;
+
+    if (server_connected_client->session != NULL)
+    {
+        LogError("Only one session per connection");
+        result = false;
+    }
+    else if ((server_connected_client->session = session_create_from_endpoint(server_connected_client->connection, new_endpoint, on_new_link_attached, server_connected_client)) == NULL)
+    {
+        LogError("Cannot create session");
+        result = false;
+    }
+    else if (session_begin(server_connected_client->session) != 0)
+    {
+        session_destroy(server_connected_client->session);
+        server_connected_client->session = NULL;
+        LogError("Cannot begin session");
+        result = false;
+    }
+    else
+    {
+        /* all OK */
+        result = true;
+    }
+
+    return result;
+}
+
+static void on_server_connection_state_changed(void* context, CONNECTION_STATE new_connection_state, CONNECTION_STATE previous_connection_state)
+{
+    (void)previous_connection_state;
+
+    if ((new_connection_state == CONNECTION_STATE_END) ||
+        (new_connection_state == CONNECTION_STATE_ERROR) ||
+        (new_connection_state == CONNECTION_STATE_DISCARDING))
+    {
+        ((SERVER_CONNECTED_CLIENT*)context)->is_closed = true;
+    }
+}
+
+static void on_server_io_error(void* context)
+{
+    ((SERVER_CONNECTED_CLIENT*)context)->is_closed = true;
+}
+
+static void destroy_server_connected_client(SERVER_CONNECTED_CLIENT* server_connected_client)
+{
+    if (server_connected_client->links != NULL)
+    {
+        LIST_ITEM_HANDLE link_item = singlylinkedlist_get_head_item(server_connected_client->links);
+
+        while (link_item != NULL)
+        {
+            SERVER_LINK* server_link = (SERVER_LINK*)singlylinkedlist_item_get_value(link_item);
+
+            messagereceiver_destroy(server_link->message_receiver);
+            link_destroy(server_link->link);
+            free(server_link);
+            (void)singlylinkedlist_remove(server_connected_client->links, link_item);
+            link_item = singlylinkedlist_get_head_item(server_connected_client->links);
+        }
+
+        singlylinkedlist_destroy(server_connected_client->links);
+    }
+
+    if (server_connected_client->session != NULL)
+    {
+        session_destroy(server_connected_client->session);
+    }
+
+    if (server_connected_client->connection != NULL)
+    {
+        connection_destroy(server_connected_client->connection);
+    }
+
+    xio_destroy(server_connected_client->io);
+
+    /* the header detect io does not destroy the socket io under it */
+    if (server_connected_client->underlying_io != NULL)
+    {
+        xio_destroy(server_connected_client->underlying_io);
+    }
+
+    free(server_connected_client);
+}
+
+static void on_socket_accepted(void* context, const IO_INTERFACE_DESCRIPTION* interface_description, void* io_parameters)
+{
+    XIO_HANDLE socket_io;
+    SERVER_CONNECTED_CLIENT* server_connected_client;
+
+    (void)context;
+
+    if ((socket_io = xio_create(interface_description, io_parameters)) == NULL)
+    {
+        LogError("Cannot create accepted socket IO");
+    }
+    else if ((server_connected_client = (SERVER_CONNECTED_CLIENT*)calloc(1, sizeof(SERVER_CONNECTED_CLIENT))) == NULL)
+    {
+        LogError("Cannot allocate the server connected client");
+        xio_destroy(socket_io);
+    }
+    else
+    {
+        if (server_transport == TRANSPORT_TCP_DIRECT)
+        {
+            /* the connection answers the AMQP header itself */
+            server_connected_client->io = socket_io;
+        }
+        else
+        {
+            HEADER_DETECT_IO_CONFIG header_detect_io_config;
+            HEADER_DETECT_ENTRY header_detect_entries[2];
+
+            header_detect_entries[0].header = header_detect_io_get_sasl_amqp_header();
+            header_detect_entries[0].io_interface_description = test_sasl_server_io_get_interface_description();
+            header_detect_entries[1].header = header_detect_io_get_amqp_header();
+            header_detect_entries[1].io_interface_description = NULL;
+
+            header_detect_io_config.underlying_io = socket_io;
+            /* the plain TCP stack only detects the AMQP header */
+            header_detect_io_config.header_detect_entry_count = (server_transport == TRANSPORT_TCP) ? 1 : 2;
+            header_detect_io_config.header_detect_entries = (server_transport == TRANSPORT_TCP) ? &header_detect_entries[1] : header_detect_entries;
+
+            server_connected_client->underlying_io = socket_io;
+            server_connected_client->io = xio_create(header_detect_io_get_interface_description(), &header_detect_io_config);
+        }
+
+        if (server_connected_client->io == NULL)
+        {
+            LogError("Cannot create header detect IO");
+            xio_destroy(socket_io);
+            free(server_connected_client);
+        }
+        else if (((server_connected_client->links = singlylinkedlist_create()) == NULL) ||
+            ((server_connected_client->connection = connection_create2(server_connected_client->io, NULL, "1", on_new_session_endpoint, server_connected_client,
+                on_server_connection_state_changed, server_connected_client, on_server_io_error, server_connected_client)) == NULL) ||
+            (connection_listen(server_connected_client->connection) != 0) ||
+            (singlylinkedlist_add(server_connected_clients, server_connected_client) == NULL))
+        {
+            LogError("Cannot set up the server connection");
+            destroy_server_connected_client(server_connected_client);
+        }
+    }
+}
+
+static void run_server(SOCKET_LISTENER_HANDLE socket_listener)
+{
+    LIST_ITEM_HANDLE current_item;
+
+    socketlistener_dowork(socket_listener);
+
+    current_item = singlylinkedlist_get_head_item(server_connected_clients);
+    while (current_item != NULL)
+    {
+        SERVER_CONNECTED_CLIENT* server_connected_client = (SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item);
+        LIST_ITEM_HANDLE next_item = singlylinkedlist_get_next_item(current_item);
+
+        connection_dowork(server_connected_client->connection);
+
+        /* the setups leave a closed connection each */
+        if (server_connected_client->is_closed)
+        {
+            (void)singlylinkedlist_remove(server_connected_clients, current_item);
+            destroy_server_connected_client(server_connected_client);
+        }
+
+        current_item = next_item;
+    }
+}
+
+/* client side */
+
+typedef struct CLIENT_LINK_TAG
+{
+    LINK_HANDLE link;
+    MESSAGE_SENDER_HANDLE message_sender;
+    size_t outstanding_message_count;
+    bool is_open;
+} CLIENT_LINK;
+
+typedef struct CLIENT_TAG
+{
+    /* from the bottom of the stack up, any of them can be NULL */
+    XIO_HANDLE socket_io;
+    XIO_HANDLE ws_io;
+    XIO_HANDLE sasl_io;
+    SASL_MECHANISM_HANDLE sasl_mechanism;
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session;
+    CLIENT_LINK* links;
+    size_t link_count;
+    uint64_t messages_settled;
+    bool is_failed;
+} CLIENT;
+
+static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_result)
+{
+    CLIENT_LINK* client_link = (CLIENT_LINK*)context;
+
+    client_link->outstanding_message_count--;
+    (void)send_result;
+}
+
+static void on_message_sender_state_changed(void* context, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
+{
+    CLIENT_LINK* client_link = (CLIENT_LINK*)context;
+
+    (void)previous_state;
+    client_link->is_open = (new_state == MESSAGE_SENDER_STATE_OPEN);
+}
+
+static void destroy_client(CLIENT* client)
+{
+    size_t i;
+
+    for (i = 0; i < client->link_count; i++)
+    {
+        messagesender_destroy(client->links[i].message_sender);
+        link_destroy(client->links[i].link);
+    }
+
+    free(client->links);
+
+    if (client->session != NULL)
+    {
+        session_destroy(client->session);
+    }
+
+    if (client->connection != NULL)
+    {
+        connection_destroy(client->connection);
+    }
+
+    if (client->sasl_io != NULL)
+    {
+        xio_destroy(client->sasl_io);
+    }
+
+    if (client->ws_io != NULL)
+    {
+        xio_destroy(client->ws_io);
+    }
+
+    if (client->socket_io != NULL)
+    {
+        xio_destroy(client->socket_io);
+    }
+
+    if (client->sasl_mechanism != NULL)
+    {
+        saslmechanism_destroy(client->sasl_mechanism);
+    }
+}
+
+static int create_client_link(CLIENT* client, size_t link_index, const char* target_address)
+{
+    int result;
+    char link_name[32];
+    AMQP_VALUE source;
+    AMQP_VALUE target;
+    CLIENT_LINK* client_link = &client->links[link_index];
+
+    (void)sprintf(link_name, "sender-link-%u", (unsigned int)link_index);
+    source = messaging_create_source("ingress");
+    target = messaging_create_target(target_address);
+
+    client_link->is_open = false;
+    client_link->outstanding_message_count = 0;
+    client_link->link = link_create(client->session, link_name, role_sender, source, target);
+    if (client_link->link == NULL)
+    {
+        LogError("Cannot create client link");
+        result = __LINE__;
+    }
+    else if ((link_set_snd_settle_mode(client_link->link, sender_settle_mode_unsettled) != 0) ||
+        (link_set_max_message_size(client_link->link, 65536 + config.message_size) != 0))
+    {
+        LogError("Cannot set link properties");
+        link_destroy(client_link->link);
+        result = __LINE__;
+    }
+    else
+    {
+        client_link->message_sender = messagesender_create(client_link->link, on_message_sender_state_changed, client_link);
+        if (client_link->message_sender == NULL)
+        {
+            LogError("Cannot create client message sender");
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else if (messagesender_open(client_link->message_sender) != 0)
+        {
+            LogError("Cannot open client message sender");
+            messagesender_destroy(client_link->message_sender);
+            link_destroy(client_link->link);
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    amqpvalue_destroy(source);
+    amqpvalue_destroy(target);
+
+    return result;
+}
+
+static int create_client_io(CLIENT* client, TRANSPORT transport, const char** hostname)
+{
+    int result;
+    SOCKETIO_CONFIG socketio_config = { "localhost", 0, NULL };
+    TLSIO_CONFIG tlsio_config;
+    WSIO_CONFIG wsio_config;
+    SASL_PLAIN_CONFIG sasl_plain_config;
+
+    socketio_config.port = config.port;
+    *hostname = "localhost";
+
+    switch (transport)
+    {
+    default:
+        client->socket_io = xio_create(socketio_get_interface_description(), &socketio_config);
+        break;
+
+    case TRANSPORT_TLS_SASL_PLAIN:
+        tlsio_config.hostname = config.remote_host;
+        tlsio_config.port = config.remote_tls_port;
+        tlsio_config.underlying_io_interface = NULL;
+        tlsio_config.underlying_io_parameters = NULL;
+        *hostname = config.remote_host;
+        client->socket_io = xio_create(platform_get_default_tlsio(), &tlsio_config);
+        break;
+
+    case TRANSPORT_WSS_SASL_PLAIN:
+        /* the WebSocket io creates the TLS io under it */
+        tlsio_config.hostname = config.remote_host;
+        tlsio_config.port = config.remote_wss_port;
+        tlsio_config.underlying_io_interface = NULL;
+        tlsio_config.underlying_io_parameters = NULL;
+        wsio_config.hostname = config.remote_host;
+        wsio_config.port = config.remote_wss_port;
+        wsio_config.protocol = "AMQPWSB10";
+        wsio_config.resource_name = config.remote_wss_path;
+        wsio_config.underlying_io_interface = platform_get_default_tlsio();
+        wsio_config.underlying_io_parameters = &tlsio_config;
+        *hostname = config.remote_host;
+        client->ws_io = xio_create(wsio_get_interface_description(), &wsio_config);
+        break;
+    }
+
+    sasl_plain_config.authcid = config.user;
+    sasl_plain_config.passwd = config.password;
+    sasl_plain_config.authzid = NULL;
+
+    switch (transport)
+    {
+    default:
+        break;
+
+    case TRANSPORT_SASL_ANONYMOUS:
+        client->sasl_mechanism = saslmechanism_create(saslanonymous_get_interface(), NULL);
+        break;
+
+    case TRANSPORT_SASL_PLAIN:
+    case TRANSPORT_TLS_SASL_PLAIN:
+    case TRANSPORT_WSS_SASL_PLAIN:
+        client->sasl_mechanism = saslmechanism_create(saslplain_get_interface(), &sasl_plain_config);
+        break;
+
+    case TRANSPORT_SASL_MSSBCBS:
+        client->sasl_mechanism = saslmechanism_create(saslmssbcbs_get_interface(), NULL);
+        break;
+    }
+
+    if ((client->socket_io == NULL) &&
+        (client->ws_io == NULL))
+    {
+        LogError("Cannot create the client IO");
+        result = __LINE__;
+    }
+    else if ((transport == TRANSPORT_TCP_DIRECT) ||
+        (transport == TRANSPORT_TCP))
+    {
+        result = 0;
+    }
+    else if (client->sasl_mechanism == NULL)
+    {
+        LogError("Cannot create the SASL mechanism");
+        result = __LINE__;
+    }
+    else
+    {
+        SASLCLIENTIO_CONFIG saslclientio_config;
+
+        saslclientio_config.underlying_io = (client->ws_io != NULL) ? client->ws_io : client->socket_io;
+        saslclientio_config.sasl_mechanism = client->sasl_mechanism;
+        client->sasl_io = xio_create(saslclientio_get_interface_description(), &saslclientio_config);
+        if (client->sasl_io == NULL)
+        {
+            LogError("Cannot create the SASL client IO");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int create_client(CLIENT* client, TRANSPORT transport)
+{
+    int result;
+    const char* hostname;
+
+    (void)memset(client, 0, sizeof(CLIENT));
+    client->links = (CLIENT_LINK*)calloc(config.links_per_session, sizeof(CLIENT_LINK));
+
+    if (client->links == NULL)
+    {
+        LogError("Cannot allocate the client links");
+        result = __LINE__;
+    }
+    else if (create_client_io(client, transport, &hostname) != 0)
+    {
+        result = __LINE__;
+    }
+    else if ((client->connection = connection_create((client->sasl_io != NULL) ? client->sasl_io : ((client->ws_io != NULL) ? client->ws_io : client->socket_io), hostname, "some", NULL, NULL)) == NULL)
+    {
+        LogError("Cannot create client connection");
+        result = __LINE__;
+    }
+    else if ((client->session = session_create(client->connection, NULL, NULL)) == NULL)
+    {
+        LogError("Cannot create client session");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+
+        while ((result == 0) && (client->link_count < config.links_per_session))
+        {
+            result = create_client_link(client, client->link_count, is_remote_transport(transport) ? config.remote_address : "localhost/ingress");
+            if (result == 0)
+            {
+                client->link_count++;
+            }
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_client(client);
+    }
+
+    return result;
+}
+
+static bool are_client_links_open(const CLIENT* client)
+{
+    bool result = true;
+    size_t i;
+
+    for (i = 0; i < client->link_count; i++)
+    {
+        result = result && client->links[i].is_open;
+    }
+
+    return result;
+}
+
+static int send_messages(CLIENT* client, unsigned char* payload)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (result == 0) && (i < client->link_count); i++)
+    {
+        CLIENT_LINK* client_link = &client->links[i];
+
+        while ((result == 0) && (client_link->outstanding_message_count < config.outstanding_message_count))
+        {
+            MESSAGE_HANDLE message = message_create();
+            BINARY_DATA binary_data;
+
+            binary_data.bytes = payload;
+            binary_data.length = config.message_size;
+
+            if (message == NULL)
+            {
+                LogError("Error creating message");
+                result = __LINE__;
+            }
+            else
+            {
+                if (message_add_body_amqp_data(message, binary_data) != 0)
+                {
+                    LogError("Error setting message body");
+                    result = __LINE__;
+                }
+                else if (messagesender_send_async(client_link->message_sender, message, on_message_send_complete, client_link, 0) == NULL)
+                {
+                    LogError("Error sending message");
+                    result = __LINE__;
+                }
+                else
+                {
+                    client_link->outstanding_message_count++;
+                }
+
+                message_destroy(message);
+            }
+        }
+    }
+
+    return result;
+}
+
+static int wait_for_client_open(CLIENT* client, SOCKET_LISTENER_HANDLE socket_listener)
+{
+    int result;
+    uint64_t start_us = get_time_us();
+
+    while (!are_client_links_open(client) &&
+        (get_time_us() - start_us < SETUP_TIMEOUT_US))
+    {
+        connection_dowork(client->connection);
+        run_server(socket_listener);
+    }
+
+    if (!are_client_links_open(client))
+    {
+        LogError("The links did not open");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double left_value = *(const double*)left;
+    double right_value = *(const double*)right;
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+/* from creating the io stack to all links attached: TCP connect, TLS and WebSocket handshakes, SASL, open, begin, attach */
+static int run_setups(TRANSPORT transport, SOCKET_LISTENER_HANDLE socket_listener, SETUP_RESULT* setup_result)
+{
+    int result = 0;
+    double* setup_ms = (double*)malloc(sizeof(double) * config.setup_iterations);
+    size_t i;
+
+    if (setup_ms == NULL)
+    {
+        LogError("Cannot allocate the setup times");
+        result = __LINE__;
+    }
+    else
+    {
+        double sum_ms = 0;
+
+        for (i = 0; (result == 0) && (i < config.setup_iterations); i++)
+        {
+            CLIENT client;
+            uint64_t start_us = get_time_us();
+
+            if (create_client(&client, transport) != 0)
+            {
+                result = __LINE__;
+            }
+            else
+            {
+                result = wait_for_client_open(&client, socket_listener);
+                setup_ms[i] = (double)(get_time_us() - start_us) / 1000.0;
+                sum_ms += setup_ms[i];
+                destroy_client(&client);
+            }
+        }
+
+        if (result == 0)
+        {
+            qsort(setup_ms, config.setup_iterations, sizeof(double), compare_doubles);
+            setup_result->mean_ms = sum_ms / (double)config.setup_iterations;
+            setup_result->p50_ms = setup_ms[config.setup_iterations / 2];
+            setup_result->max_ms = setup_ms[config.setup_iterations - 1];
+        }
+
+        free(setup_ms);
+    }
+
+    return result;
+}
+
+static size_t get_outstanding_message_count(const CLIENT* client)
+{
+    size_t result = 0;
+    size_t i;
+
+    for (i = 0; i < client->link_count; i++)
+    {
+        result += client->links[i].outstanding_message_count;
+    }
+
+    return result;
+}
+
+static int run_throughput(TRANSPORT transport, SOCKET_LISTENER_HANDLE socket_listener, unsigned char* payload, THROUGHPUT_RESULT* throughput_result)
+{
+    int result;
+    CLIENT client;
+
+    if (create_client(&client, transport) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        if (wait_for_client_open(&client, socket_listener) != 0)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            uint64_t start_us = get_time_us();
+            uint64_t start_cpu_us = get_cpu_time_us();
+            uint64_t current_us = start_us;
+            uint64_t settled_count = 0;
+
+            result = 0;
+
+            while ((result == 0) && (current_us - start_us < config.duration_us))
+            {
+                size_t outstanding_before = get_outstanding_message_count(&client);
+
+                connection_dowork(client.connection);
+                run_server(socket_listener);
+
+                /* the settlements happen in the doworks, the sends only after them */
+                settled_count += outstanding_before - get_outstanding_message_count(&client);
+                result = send_messages(&client, payload);
+                current_us = get_time_us();
+            }
+
+            throughput_result->messages = settled_count;
+            throughput_result->seconds = (double)(current_us - start_us) / 1000000.0;
+            throughput_result->cpu_us_per_message = (settled_count == 0) ? 0 : (double)(get_cpu_time_us() - start_cpu_us) / (double)settled_count;
+            throughput_result->cpu_percent = (double)(get_cpu_time_us() - start_cpu_us) / (double)(current_us - start_us) * 100.0;
+        }
+
+        destroy_client(&client);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        result = -1;
+    }
+    else if (platform_init() != 0)
+    {
+        LogError("platform_init failed");
+        result = -1;
+    }
+    else
+    {
+        SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanisms[3];
+
+        sasl_server_mechanisms[0] = sasl_server_mechanism_create(&anonymous_server_mechanism_interface, NULL);
+        sasl_server_mechanisms[1] = sasl_server_mechanism_create(&plain_server_mechanism_interface, NULL);
+        sasl_server_mechanisms[2] = sasl_server_mechanism_create(&mssbcbs_server_mechanism_interface, NULL);
+
+        if ((sasl_server_mechanisms[0] == NULL) ||
+            (sasl_server_mechanisms[1] == NULL) ||
+            (sasl_server_mechanisms[2] == NULL) ||
+            ((server_connected_clients = singlylinkedlist_create()) == NULL))
+        {
+            LogError("Cannot set up the server");
+            result = -1;
+        }
+        else
+        {
+            SOCKET_LISTENER_HANDLE socket_listener = socketlistener_create(config.port);
+
+            test_sasl_server_io_set_mechanisms(sasl_server_mechanisms, 3);
+
+            if (socket_listener == NULL)
+            {
+                LogError("Cannot create socket listener");
+                result = -1;
+            }
+            else
+            {
+                if (socketlistener_start(socket_listener, on_socket_accepted, NULL) != 0)
+                {
+                    LogError("socketlistener_start failed");
+                    result = -1;
+                }
+                else
+                {
+                    unsigned char* payload = (unsigned char*)calloc(1, config.message_size);
+
+                    if (payload == NULL)
+                    {
+                        LogError("Cannot allocate the payload");
+                        result = -1;
+                    }
+                    else
+                    {
+                        size_t i;
+
+                        result = 0;
+
+                        (void)printf("links=%u message_size=%u outstanding=%u setup_iterations=%u duration=%ums\n",
+                            (unsigned int)config.links_per_session, (unsigned int)config.message_size,
+                            (unsigned int)config.outstanding_message_count, (unsigned int)config.setup_iterations,
+                            (unsigned int)(config.duration_us / 1000));
+                        (void)printf("%-16s %28s %12s %8s %16s %6s\n", "transport", "setup ms (mean/p50/max)", "messages/s", "MB/s", "cpu us/message", "cpu %");
+
+                        for (i = 0; i < TRANSPORT_COUNT; i++)
+                        {
+                            if (config.transports[i])
+                            {
+                                SETUP_RESULT setup_result;
+                                THROUGHPUT_RESULT throughput_result;
+
+                                server_transport = (TRANSPORT)i;
+
+                                if ((run_setups((TRANSPORT)i, socket_listener, &setup_result) != 0) ||
+                                    (run_throughput((TRANSPORT)i, socket_listener, payload, &throughput_result) != 0))
+                                {
+                                    (void)printf("%-16s failed\n", transport_names[i]);
+                                    result = -1;
+                                }
+                                else
+                                {
+                                    (void)printf("%-16s %8.2f /%8.2f /%8.2f %12.0f %8.2f %16.2f %6.0f%s\n", transport_names[i],
+                                        setup_result.mean_ms, setup_result.p50_ms, setup_result.max_ms,
+                                        (double)throughput_result.messages / throughput_result.seconds,
+                                        (double)throughput_result.messages * (double)config.message_size / throughput_result.seconds / (1024 * 1024),
+                                        throughput_result.cpu_us_per_message, throughput_result.cpu_percent,
+                                        is_remote_transport((TRANSPORT)i) ? "  (client only)" : "");
+                                }
+
+                                /* let the server see the last connection go */
+                                while (singlylinkedlist_get_head_item(server_connected_clients) != NULL)
+                                {
+                                    run_server(socket_listener);
+                                }
+                            }
+                        }
+
+                        free(payload);
+                    }
+
+                    (void)socketlistener_stop(socket_listener);
+                }
+
+                socketlistener_destroy(socket_listener);
+            }
+        }
+
+        if (server_connected_clients != NULL)
+        {
+            LIST_ITEM_HANDLE current_item = singlylinkedlist_get_head_item(server_connected_clients);
+
+            while (current_item != NULL)
+            {
+                destroy_server_connected_client((SERVER_CONNECTED_CLIENT*)singlylinkedlist_item_get_value(current_item));
+                (void)singlylinkedlist_remove(server_connected_clients, current_item);
+                current_item = singlylinkedlist_get_head_item(server_connected_clients);
+            }
+
+            singlylinkedlist_destroy(server_connected_clients);
+        }
+
+        if (sasl_server_mechanisms[0] != NULL)
+        {
+            sasl_server_mechanism_destroy(sasl_server_mechanisms[0]);
+        }
+
+        if (sasl_server_mechanisms[1] != NULL)
+        {
+            sasl_server_mechanism_destroy(sasl_server_mechanisms[1]);
+        }
+
+        if (sasl_server_mechanisms[2] != NULL)
+        {
+            sasl_server_mechanism_destroy(sasl_server_mechanisms[2]);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
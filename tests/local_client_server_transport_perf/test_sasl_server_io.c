@@ -0,0 +1,486 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/frame_codec.h"
+#include "azure_uamqp_c/sasl_frame_codec.h"
+#include "azure_uamqp_c/server_protocol_io.h"
+#include "test_sasl_server_io.h"
+
+typedef enum TEST_SASL_SERVER_IO_STATE_TAG
+{
+    TEST_SASL_SERVER_IO_STATE_NOT_OPEN,
+    TEST_SASL_SERVER_IO_STATE_WAITING_FOR_INIT,
+    TEST_SASL_SERVER_IO_STATE_OPEN,
+    TEST_SASL_SERVER_IO_STATE_ERROR
+} TEST_SASL_SERVER_IO_STATE;
+
+typedef struct TEST_SASL_SERVER_IO_INSTANCE_TAG
+{
+    XIO_HANDLE underlying_io;
+    FRAME_CODEC_HANDLE frame_codec;
+    SASL_FRAME_CODEC_HANDLE sasl_frame_codec;
+    TEST_SASL_SERVER_IO_STATE state;
+    bool is_open_result_pending;
+    IO_OPEN_RESULT pending_open_result;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    ON_IO_CLOSE_COMPLETE on_io_close_complete;
+    void* on_io_close_complete_context;
+} TEST_SASL_SERVER_IO_INSTANCE;
+
+static const SASL_SERVER_MECHANISM_HANDLE* offered_sasl_server_mechanisms;
+static size_t offered_sasl_server_mechanism_count;
+
+void test_sasl_server_io_set_mechanisms(const SASL_SERVER_MECHANISM_HANDLE* sasl_server_mechanisms, size_t sasl_server_mechanism_count)
+{
+    offered_sasl_server_mechanisms = sasl_server_mechanisms;
+    offered_sasl_server_mechanism_count = sasl_server_mechanism_count;
+}
+
+static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    (void)send_result;
+}
+
+/* the result is only indicated once the frame codec is done with the bytes, header_detect_io destroys the IO on an error */
+static void set_open_result(TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io, IO_OPEN_RESULT open_result)
+{
+    if (!sasl_server_io->is_open_result_pending)
+    {
+        sasl_server_io->is_open_result_pending = true;
+        sasl_server_io->pending_open_result = open_result;
+    }
+}
+
+static void on_bytes_encoded(void* context, const unsigned char* bytes, size_t length, bool encode_complete)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)context;
+
+    (void)encode_complete;
+
+    if (xio_send(sasl_server_io->underlying_io, bytes, length, unchecked_on_send_complete, NULL) != 0)
+    {
+        LogError("xio_send failed");
+        sasl_server_io->state = TEST_SASL_SERVER_IO_STATE_ERROR;
+    }
+}
+
+static int send_sasl_outcome(TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io, sasl_code code)
+{
+    int result;
+    SASL_OUTCOME_HANDLE sasl_outcome = sasl_outcome_create(code);
+
+    if (sasl_outcome == NULL)
+    {
+        LogError("Cannot create sasl-outcome");
+        result = __LINE__;
+    }
+    else
+    {
+        AMQP_VALUE sasl_outcome_value = amqpvalue_create_sasl_outcome(sasl_outcome);
+        if (sasl_outcome_value == NULL)
+        {
+            LogError("Cannot create sasl-outcome value");
+            result = __LINE__;
+        }
+        else
+        {
+            if (sasl_frame_codec_encode_frame(sasl_server_io->sasl_frame_codec, sasl_outcome_value, on_bytes_encoded, sasl_server_io) != 0)
+            {
+                LogError("Cannot encode sasl-outcome");
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            amqpvalue_destroy(sasl_outcome_value);
+        }
+
+        sasl_outcome_destroy(sasl_outcome);
+    }
+
+    return result;
+}
+
+static SASL_SERVER_MECHANISM_HANDLE find_mechanism(const char* mechanism_name)
+{
+    SASL_SERVER_MECHANISM_HANDLE result = NULL;
+    size_t i;
+
+    for (i = 0; (result == NULL) && (i < offered_sasl_server_mechanism_count); i++)
+    {
+        if (strcmp(sasl_server_mechanism_get_mechanism_name(offered_sasl_server_mechanisms[i]), mechanism_name) == 0)
+        {
+            result = offered_sasl_server_mechanisms[i];
+        }
+    }
+
+    return result;
+}
+
+static void handle_sasl_init(TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io, AMQP_VALUE sasl_frame)
+{
+    SASL_INIT_HANDLE sasl_init;
+
+    if (amqpvalue_get_sasl_init(sasl_frame, &sasl_init) != 0)
+    {
+        LogError("Cannot decode sasl-init");
+        set_open_result(sasl_server_io, IO_OPEN_ERROR);
+    }
+    else
+    {
+        const char* mechanism_name;
+        const char* hostname;
+        amqp_binary initial_response;
+        SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+        SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+        SASL_SERVER_MECHANISM_BYTES challenge_bytes;
+        bool send_challenge = false;
+        sasl_code code;
+
+        /* both are optional */
+        if (sasl_init_get_initial_response(sasl_init, &initial_response) != 0)
+        {
+            initial_response.bytes = NULL;
+            initial_response.length = 0;
+        }
+
+        if (sasl_init_get_hostname(sasl_init, &hostname) != 0)
+        {
+            hostname = NULL;
+        }
+
+        initial_response_bytes.bytes = initial_response.bytes;
+        initial_response_bytes.length = initial_response.length;
+
+        if ((sasl_init_get_mechanism(sasl_init, &mechanism_name) != 0) ||
+            ((sasl_server_mechanism = find_mechanism(mechanism_name)) == NULL))
+        {
+            LogError("Mechanism not offered");
+            code = sasl_code_auth;
+        }
+        else if ((sasl_server_mechanism_handle_initial_response(sasl_server_mechanism, &initial_response_bytes, hostname, &send_challenge, &challenge_bytes) != 0) ||
+            send_challenge)
+        {
+            LogError("Initial response refused");
+            code = sasl_code_auth;
+        }
+        else
+        {
+            code = sasl_code_ok;
+        }
+
+        if (send_sasl_outcome(sasl_server_io, code) != 0)
+        {
+            set_open_result(sasl_server_io, IO_OPEN_ERROR);
+        }
+        else
+        {
+            set_open_result(sasl_server_io, (code == sasl_code_ok) ? IO_OPEN_OK : IO_OPEN_ERROR);
+        }
+
+        sasl_init_destroy(sasl_init);
+    }
+}
+
+static void on_sasl_frame_received(void* context, AMQP_VALUE sasl_frame)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)context;
+
+    if (sasl_server_io->state != TEST_SASL_SERVER_IO_STATE_WAITING_FOR_INIT)
+    {
+        LogError("SASL frame received in state %d", (int)sasl_server_io->state);
+    }
+    else if (!is_sasl_init_type_by_descriptor(amqpvalue_get_inplace_descriptor(sasl_frame)))
+    {
+        LogError("Only sasl-init is expected");
+        set_open_result(sasl_server_io, IO_OPEN_ERROR);
+    }
+    else
+    {
+        handle_sasl_init(sasl_server_io, sasl_frame);
+    }
+}
+
+static void on_sasl_frame_codec_error(void* context)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)context;
+
+    LogError("SASL frame codec error");
+    if (sasl_server_io->state == TEST_SASL_SERVER_IO_STATE_WAITING_FOR_INIT)
+    {
+        set_open_result(sasl_server_io, IO_OPEN_ERROR);
+    }
+}
+
+static void on_frame_codec_error(void* context)
+{
+    on_sasl_frame_codec_error(context);
+}
+
+/* header_detect_io hands over the bytes read while the IO is opening, the client only sends its AMQP header once it has
+   the outcome so none of them belong to the next protocol */
+static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)context;
+
+    if (sasl_server_io->state == TEST_SASL_SERVER_IO_STATE_WAITING_FOR_INIT)
+    {
+        if (frame_codec_receive_bytes(sasl_server_io->frame_codec, buffer, size) != 0)
+        {
+            LogError("Cannot decode the SASL frames");
+            set_open_result(sasl_server_io, IO_OPEN_ERROR);
+        }
+
+        if (sasl_server_io->is_open_result_pending)
+        {
+            sasl_server_io->is_open_result_pending = false;
+            sasl_server_io->state = (sasl_server_io->pending_open_result == IO_OPEN_OK) ? TEST_SASL_SERVER_IO_STATE_OPEN : TEST_SASL_SERVER_IO_STATE_ERROR;
+
+            /* last use of the instance */
+            sasl_server_io->on_io_open_complete(sasl_server_io->on_io_open_complete_context, sasl_server_io->pending_open_result);
+        }
+    }
+}
+
+static CONCRETE_IO_HANDLE test_sasl_server_io_create(void* io_create_parameters)
+{
+    SERVER_PROTOCOL_IO_CONFIG* server_protocol_io_config = (SERVER_PROTOCOL_IO_CONFIG*)io_create_parameters;
+    TEST_SASL_SERVER_IO_INSTANCE* result;
+
+    if (server_protocol_io_config == NULL)
+    {
+        LogError("NULL io_create_parameters");
+        result = NULL;
+    }
+    else if ((result = (TEST_SASL_SERVER_IO_INSTANCE*)calloc(1, sizeof(TEST_SASL_SERVER_IO_INSTANCE))) == NULL)
+    {
+        LogError("Cannot allocate the SASL server IO");
+    }
+    else if ((result->frame_codec = frame_codec_create(on_frame_codec_error, result)) == NULL)
+    {
+        LogError("Cannot create the frame codec");
+        free(result);
+        result = NULL;
+    }
+    else if ((result->sasl_frame_codec = sasl_frame_codec_create(result->frame_codec, on_sasl_frame_received, on_sasl_frame_codec_error, result)) == NULL)
+    {
+        LogError("Cannot create the SASL frame codec");
+        frame_codec_destroy(result->frame_codec);
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->underlying_io = server_protocol_io_config->underlying_io;
+        result->state = TEST_SASL_SERVER_IO_STATE_NOT_OPEN;
+        *server_protocol_io_config->on_bytes_received = on_underlying_io_bytes_received;
+        *server_protocol_io_config->on_bytes_received_context = result;
+    }
+
+    return result;
+}
+
+static void test_sasl_server_io_destroy(CONCRETE_IO_HANDLE concrete_io)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)concrete_io;
+
+    if (sasl_server_io != NULL)
+    {
+        sasl_frame_codec_destroy(sasl_server_io->sasl_frame_codec);
+        frame_codec_destroy(sasl_server_io->frame_codec);
+        free(sasl_server_io);
+    }
+}
+
+static int test_sasl_server_io_open(CONCRETE_IO_HANDLE concrete_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)concrete_io;
+    int result;
+
+    /* the bytes after the outcome are read by header_detect_io from the underlying IO */
+    (void)on_bytes_received;
+    (void)on_bytes_received_context;
+
+    if ((sasl_server_io == NULL) ||
+        (on_io_open_complete == NULL) ||
+        (sasl_server_io->state != TEST_SASL_SERVER_IO_STATE_NOT_OPEN))
+    {
+        LogError("Bad arguments: concrete_io = %p, on_io_open_complete = %p", concrete_io, on_io_open_complete);
+        result = __LINE__;
+    }
+    else
+    {
+        AMQP_VALUE mechanism_names = amqpvalue_create_array();
+        size_t i;
+
+        result = (mechanism_names == NULL) ? __LINE__ : 0;
+
+        for (i = 0; (result == 0) && (i < offered_sasl_server_mechanism_count); i++)
+        {
+            AMQP_VALUE mechanism_name = amqpvalue_create_symbol(sasl_server_mechanism_get_mechanism_name(offered_sasl_server_mechanisms[i]));
+            if ((mechanism_name == NULL) ||
+                (amqpvalue_add_array_item(mechanism_names, mechanism_name) != 0))
+            {
+                result = __LINE__;
+            }
+
+            if (mechanism_name != NULL)
+            {
+                amqpvalue_destroy(mechanism_name);
+            }
+        }
+
+        if (result != 0)
+        {
+            LogError("Cannot create the mechanism names");
+        }
+        else
+        {
+            SASL_MECHANISMS_HANDLE sasl_mechanisms = sasl_mechanisms_create(mechanism_names);
+            AMQP_VALUE sasl_mechanisms_value = (sasl_mechanisms == NULL) ? NULL : amqpvalue_create_sasl_mechanisms(sasl_mechanisms);
+
+            sasl_server_io->on_io_open_complete = on_io_open_complete;
+            sasl_server_io->on_io_open_complete_context = on_io_open_complete_context;
+            sasl_server_io->on_io_error = on_io_error;
+            sasl_server_io->on_io_error_context = on_io_error_context;
+            sasl_server_io->state = TEST_SASL_SERVER_IO_STATE_WAITING_FOR_INIT;
+
+            if ((sasl_mechanisms_value == NULL) ||
+                (sasl_frame_codec_encode_frame(sasl_server_io->sasl_frame_codec, sasl_mechanisms_value, on_bytes_encoded, sasl_server_io) != 0) ||
+                (sasl_server_io->state == TEST_SASL_SERVER_IO_STATE_ERROR))
+            {
+                LogError("Cannot send sasl-mechanisms");
+                sasl_server_io->state = TEST_SASL_SERVER_IO_STATE_NOT_OPEN;
+                result = __LINE__;
+            }
+
+            if (sasl_mechanisms_value != NULL)
+            {
+                amqpvalue_destroy(sasl_mechanisms_value);
+            }
+
+            if (sasl_mechanisms != NULL)
+            {
+                sasl_mechanisms_destroy(sasl_mechanisms);
+            }
+        }
+
+        if (mechanism_names != NULL)
+        {
+            amqpvalue_destroy(mechanism_names);
+        }
+    }
+
+    return result;
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)context;
+
+    if (sasl_server_io->on_io_close_complete != NULL)
+    {
+        sasl_server_io->on_io_close_complete(sasl_server_io->on_io_close_complete_context);
+    }
+}
+
+static int test_sasl_server_io_close(CONCRETE_IO_HANDLE concrete_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)concrete_io;
+    int result;
+
+    if (sasl_server_io == NULL)
+    {
+        LogError("NULL concrete_io");
+        result = __LINE__;
+    }
+    else
+    {
+        /* header_detect_io only closes the last IO of its chain, which owns closing the socket under it */
+        sasl_server_io->state = TEST_SASL_SERVER_IO_STATE_NOT_OPEN;
+        sasl_server_io->on_io_close_complete = on_io_close_complete;
+        sasl_server_io->on_io_close_complete_context = callback_context;
+        result = xio_close(sasl_server_io->underlying_io, on_underlying_io_close_complete, sasl_server_io);
+    }
+
+    return result;
+}
+
+static int test_sasl_server_io_send(CONCRETE_IO_HANDLE concrete_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)concrete_io;
+    int result;
+
+    if ((sasl_server_io == NULL) ||
+        (sasl_server_io->state != TEST_SASL_SERVER_IO_STATE_OPEN))
+    {
+        LogError("Send on an IO that is not open");
+        result = __LINE__;
+    }
+    else
+    {
+        result = xio_send(sasl_server_io->underlying_io, buffer, size, on_send_complete, callback_context);
+    }
+
+    return result;
+}
+
+static void test_sasl_server_io_dowork(CONCRETE_IO_HANDLE concrete_io)
+{
+    /* header_detect_io works the underlying IO itself */
+    (void)concrete_io;
+}
+
+static int test_sasl_server_io_setoption(CONCRETE_IO_HANDLE concrete_io, const char* option_name, const void* value)
+{
+    TEST_SASL_SERVER_IO_INSTANCE* sasl_server_io = (TEST_SASL_SERVER_IO_INSTANCE*)concrete_io;
+    int result;
+
+    if (sasl_server_io == NULL)
+    {
+        LogError("NULL concrete_io");
+        result = __LINE__;
+    }
+    else
+    {
+        result = xio_setoption(sasl_server_io->underlying_io, option_name, value);
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE test_sasl_server_io_retrieveoptions(CONCRETE_IO_HANDLE concrete_io)
+{
+    (void)concrete_io;
+    LogError("Retrieving options is not supported");
+    return NULL;
+}
+
+static const IO_INTERFACE_DESCRIPTION test_sasl_server_io_interface_description =
+{
+    test_sasl_server_io_retrieveoptions,
+    test_sasl_server_io_create,
+    test_sasl_server_io_destroy,
+    test_sasl_server_io_open,
+    test_sasl_server_io_close,
+    test_sasl_server_io_send,
+    test_sasl_server_io_dowork,
+    test_sasl_server_io_setoption
+};
+
+const IO_INTERFACE_DESCRIPTION* test_sasl_server_io_get_interface_description(void)
+{
+    return &test_sasl_server_io_interface_description;
+}
@@ -0,0 +1,21 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef TEST_SASL_SERVER_IO_H
+#define TEST_SASL_SERVER_IO_H
+
+#include <stddef.h>
+#include "azure_c_shared_utility/xio.h"
+#include "azure_uamqp_c/sasl_server_mechanism.h"
+
+/* Server side of the SASL exchange for the benchmark: created by header_detect_io when the SASL header is detected (so
+   with a SERVER_PROTOCOL_IO_CONFIG), it sends sasl-mechanisms, hands the sasl-init initial response to the matching
+   mechanism and answers with sasl-outcome. Challenges are not supported. Once open it passes the bytes sent through to
+   the underlying IO, the bytes received after the outcome go straight from the underlying IO to header_detect_io. */
+
+/* header_detect_io has no way of passing a configuration to the IO it creates, so the mechanisms offered are set once
+   for all the instances; the handles have to outlive them */
+void test_sasl_server_io_set_mechanisms(const SASL_SERVER_MECHANISM_HANDLE* sasl_server_mechanisms, size_t sasl_server_mechanism_count);
+const IO_INTERFACE_DESCRIPTION* test_sasl_server_io_get_interface_description(void);
+
+#endif /* TEST_SASL_SERVER_IO_H */
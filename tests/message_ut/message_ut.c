@@ -980,6 +980,82 @@ TEST_FUNCTION(when_all_message_sections_are_set_and_seuqnces_are_used_then_they_
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+/* message_reset */
+
+/* Tests_SRS_MESSAGE_01_175: [ `message_reset` shall free all sections and the body of the message identified by `message` and set its message format to 0, leaving it as if it had just been created. ]*/
+/* Tests_SRS_MESSAGE_01_176: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_reset_frees_all_sections)
+{
+    // arrange
+    int result;
+    uint32_t message_format;
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_header(message, test_header);
+    (void)message_take_properties(message, test_message_properties);
+    (void)message_set_message_format(message, 0x4242);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(header_destroy(test_header));
+    STRICT_EXPECTED_CALL(properties_destroy(test_message_properties));
+
+    // act
+    result = message_reset(message);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)message_get_message_format(message, &message_format);
+    ASSERT_ARE_EQUAL(uint32_t, 0, message_format);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_177: [ If `message` is NULL, `message_reset` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_reset_with_NULL_message_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = message_reset(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_178: [ The memory holding the list of body AMQP data items shall be kept for reuse. ]*/
+TEST_FUNCTION(message_reset_keeps_the_body_amqp_data_items_memory)
+{
+    // arrange
+    int result;
+    MESSAGE_BODY_TYPE body_type;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    MESSAGE_HANDLE message = message_create();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+    (void)message_add_body_amqp_data(message, amqp_data);
+    (void)message_reset(message);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)message_get_body_type(message, &body_type);
+    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_DATA, body_type);
+
+    // cleanup
+    message_destroy(message);
+}
+
 /* message_set_header */
 
 /* Tests_SRS_MESSAGE_01_022: [ `message_set_header` shall copy the contents of `message_header` as the header for the message instance identified by message. ]*/
@@ -1142,6 +1218,83 @@ TEST_FUNCTION(when_setting_a_NULL_header_twice_does_not_crash)
     message_destroy(message);
 }
 
+/* message_take_header */
+
+/* Tests_SRS_MESSAGE_01_161: [ `message_take_header` shall store `message_header` as the header for the message instance identified by `message` without cloning it, the message owning it from then on. ]*/
+/* Tests_SRS_MESSAGE_01_162: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_take_header_stores_the_header_without_cloning)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_take_header(message, test_header);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_163: [ If `message` or `message_header` is NULL, `message_take_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_take_header_with_NULL_message_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = message_take_header(NULL, test_header);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_163: [ If `message` or `message_header` is NULL, `message_take_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_take_header_with_NULL_header_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_take_header(message, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_164: [ The previously stored header shall be freed by calling `header_destroy`. ]*/
+TEST_FUNCTION(message_take_header_frees_the_previous_header)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_header(message, test_header);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(header_destroy(test_header));
+
+    // act
+    result = message_take_header(message, another_test_header);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
 /* message_get_header */
 
 /* Tests_SRS_MESSAGE_01_027: [ `message_get_header` shall copy the contents of header for the message instance identified by `message` into the argument `message_header`. ]*/
@@ -1817,6 +1970,175 @@ TEST_FUNCTION(when_no_message_annotations_have_been_set_message_get_message_anno
     message_destroy(message);
 }
 
+/* message_get_broker_annotations */
+
+/* Tests_SRS_MESSAGE_01_210: [ If `message` or `broker_annotations` is NULL, `message_get_broker_annotations` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_get_broker_annotations_with_NULL_message_fails)
+{
+    // arrange
+    MESSAGE_BROKER_ANNOTATIONS broker_annotations;
+    int result;
+
+    // act
+    result = message_get_broker_annotations(NULL, &broker_annotations);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_210: [ If `message` or `broker_annotations` is NULL, `message_get_broker_annotations` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_get_broker_annotations_with_NULL_broker_annotations_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_broker_annotations(message, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_208: [ `message_get_broker_annotations` shall fill `broker_annotations` with the `x-opt-sequence-number` (long), `x-opt-enqueued-time` (timestamp), `x-opt-offset` (string) and `x-opt-partition-key` (string) message annotations, marking those absent or of another type as absent, without cloning the message annotations. ]*/
+/* Tests_SRS_MESSAGE_01_212: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_get_broker_annotations_without_message_annotations_yields_absent_annotations)
+{
+    // arrange
+    MESSAGE_BROKER_ANNOTATIONS broker_annotations;
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_broker_annotations(message, &broker_annotations);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(broker_annotations.has_sequence_number);
+    ASSERT_IS_FALSE(broker_annotations.has_enqueued_time);
+    ASSERT_IS_NULL(broker_annotations.offset);
+    ASSERT_IS_NULL(broker_annotations.partition_key);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_208: [ `message_get_broker_annotations` shall fill `broker_annotations` with the `x-opt-sequence-number` (long), `x-opt-enqueued-time` (timestamp), `x-opt-offset` (string) and `x-opt-partition-key` (string) message annotations, marking those absent or of another type as absent, without cloning the message annotations. ]*/
+/* Tests_SRS_MESSAGE_01_212: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_get_broker_annotations_looks_up_the_broker_annotations)
+{
+    // arrange
+    MESSAGE_BROKER_ANNOTATIONS broker_annotations;
+    int result;
+    int64_t sequence_number = 42;
+    timestamp enqueued_time = 1500000000000;
+    const char* offset = "4096";
+    MESSAGE_HANDLE message = message_create();
+    STRICT_EXPECTED_CALL(annotations_clone(test_message_annotations))
+        .SetReturn(cloned_message_annotations);
+    (void)message_set_message_annotations(message, test_message_annotations);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-sequence-number"))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_get_long(test_amqp_value_1, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_long_value(&sequence_number, sizeof(sequence_number));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-enqueued-time"))
+        .SetReturn(test_amqp_value_2);
+    STRICT_EXPECTED_CALL(amqpvalue_get_timestamp(test_amqp_value_2, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_timestamp_value(&enqueued_time, sizeof(enqueued_time));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_2));
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-offset"))
+        .SetReturn(cloned_amqp_value);
+    STRICT_EXPECTED_CALL(amqpvalue_get_string(cloned_amqp_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_string_value(&offset, sizeof(offset));
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-partition-key"));
+
+    // act
+    result = message_get_broker_annotations(message, &broker_annotations);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(broker_annotations.has_sequence_number);
+    ASSERT_IS_TRUE(sequence_number == broker_annotations.sequence_number);
+    ASSERT_IS_TRUE(broker_annotations.has_enqueued_time);
+    ASSERT_IS_TRUE(enqueued_time == broker_annotations.enqueued_time);
+    ASSERT_ARE_EQUAL(char_ptr, "4096", broker_annotations.offset);
+    ASSERT_IS_NULL(broker_annotations.partition_key);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_209: [ The broker annotations shall be looked up on the first call and returned by later calls until the message annotations change. ]*/
+TEST_FUNCTION(message_get_broker_annotations_a_second_time_does_not_look_them_up_again)
+{
+    // arrange
+    MESSAGE_BROKER_ANNOTATIONS broker_annotations;
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    STRICT_EXPECTED_CALL(annotations_clone(test_message_annotations))
+        .SetReturn(cloned_message_annotations);
+    (void)message_set_message_annotations(message, test_message_annotations);
+    (void)message_get_broker_annotations(message, &broker_annotations);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_broker_annotations(message, &broker_annotations);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_211: [ Setting or clearing the message annotations shall drop the broker annotations looked up by `message_get_broker_annotations`. ]*/
+TEST_FUNCTION(message_set_message_annotations_frees_the_held_broker_annotations)
+{
+    // arrange
+    MESSAGE_BROKER_ANNOTATIONS broker_annotations;
+    int result;
+    const char* offset = "4096";
+    MESSAGE_HANDLE message = message_create();
+    STRICT_EXPECTED_CALL(annotations_clone(test_message_annotations))
+        .SetReturn(cloned_message_annotations);
+    (void)message_set_message_annotations(message, test_message_annotations);
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-sequence-number"));
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-enqueued-time"));
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-offset"))
+        .SetReturn(cloned_amqp_value);
+    STRICT_EXPECTED_CALL(amqpvalue_get_string(cloned_amqp_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_string_value(&offset, sizeof(offset));
+    STRICT_EXPECTED_CALL(amqpvalue_get_map_value_by_symbol(cloned_message_annotations, "x-opt-partition-key"));
+    (void)message_get_broker_annotations(message, &broker_annotations);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(cloned_message_annotations));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(cloned_amqp_value));
+
+    // act
+    result = message_set_message_annotations(message, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
 /* message_set_properties */
 
 /* Tests_SRS_MESSAGE_01_052: [ `message_set_properties` shall copy the contents of `properties` as the message properties for the message instance identified by `message`. ]*/
@@ -1963,64 +2285,141 @@ TEST_FUNCTION(message_set_properties_with_NULL_twice_message_properties_does_not
     message_destroy(message);
 }
 
-/* message_get_properties */
+/* message_take_properties */
 
-/* Tests_SRS_MESSAGE_01_057: [ `message_get_properties` shall copy the contents of message properties for the message instance identified by `message` into the argument `properties`. ]*/
-/* Tests_SRS_MESSAGE_01_058: [ On success, `message_get_properties` shall return 0. ]*/
-/* Tests_SRS_MESSAGE_01_060: [ Cloning the message properties shall be done by calling `properties_clone`. ]*/
-TEST_FUNCTION(message_get_properties_clones_the_stored_properties)
+/* Tests_SRS_MESSAGE_01_165: [ `message_take_properties` shall store `properties` as the message properties for the message instance identified by `message` without cloning them, the message owning them from then on. ]*/
+/* Tests_SRS_MESSAGE_01_166: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_take_properties_stores_the_properties_without_cloning)
 {
     // arrange
-    PROPERTIES_HANDLE stored_message_properties;
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(properties_clone(test_message_properties))
-        .SetReturn(cloned_message_properties);
-    (void)message_set_properties(message, test_message_properties);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(properties_clone(cloned_message_properties))
-        .SetReturn(other_cloned_message_properties);
-
     // act
-    result = message_get_properties(message, &stored_message_properties);
+    result = message_take_properties(message, test_message_properties);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(void_ptr, (void*)other_cloned_message_properties, (void*)stored_message_properties);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_059: [ If `message` or `properties` is NULL, `message_get_properties` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_get_properties_with_NULL_properties_fails)
+/* Tests_SRS_MESSAGE_01_167: [ If `message` or `properties` is NULL, `message_take_properties` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_take_properties_with_NULL_message_fails)
 {
     // arrange
     int result;
-    MESSAGE_HANDLE message = message_create();
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(properties_clone(test_message_properties))
-        .SetReturn(cloned_message_properties);
-    (void)message_set_properties(message, test_message_properties);
-    umock_c_reset_all_calls();
 
     // act
-    result = message_get_properties(message, NULL);
+    result = message_take_properties(NULL, test_message_properties);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_059: [ If `message` or `properties` is NULL, `message_get_properties` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_MESSAGE_01_167: [ If `message` or `properties` is NULL, `message_take_properties` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_take_properties_with_NULL_properties_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_take_properties(message, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_168: [ The previously stored message properties shall be freed by calling `properties_destroy`. ]*/
+TEST_FUNCTION(message_take_properties_frees_the_previous_properties)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_properties(message, test_message_properties);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(properties_destroy(test_message_properties));
+
+    // act
+    result = message_take_properties(message, cloned_message_properties);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* message_get_properties */
+
+/* Tests_SRS_MESSAGE_01_057: [ `message_get_properties` shall copy the contents of message properties for the message instance identified by `message` into the argument `properties`. ]*/
+/* Tests_SRS_MESSAGE_01_058: [ On success, `message_get_properties` shall return 0. ]*/
+/* Tests_SRS_MESSAGE_01_060: [ Cloning the message properties shall be done by calling `properties_clone`. ]*/
+TEST_FUNCTION(message_get_properties_clones_the_stored_properties)
+{
+    // arrange
+    PROPERTIES_HANDLE stored_message_properties;
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(properties_clone(test_message_properties))
+        .SetReturn(cloned_message_properties);
+    (void)message_set_properties(message, test_message_properties);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(properties_clone(cloned_message_properties))
+        .SetReturn(other_cloned_message_properties);
+
+    // act
+    result = message_get_properties(message, &stored_message_properties);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)other_cloned_message_properties, (void*)stored_message_properties);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_059: [ If `message` or `properties` is NULL, `message_get_properties` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_get_properties_with_NULL_properties_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(properties_clone(test_message_properties))
+        .SetReturn(cloned_message_properties);
+    (void)message_set_properties(message, test_message_properties);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_properties(message, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_059: [ If `message` or `properties` is NULL, `message_get_properties` shall fail and return a non-zero value. ]*/
 TEST_FUNCTION(message_get_properties_with_NULL_message_fails)
 {
     // arrange
@@ -2356,23 +2755,27 @@ TEST_FUNCTION(message_get_application_properties_when_no_application_properties_
     message_destroy(message);
 }
 
-/* message_set_footer */
+/* message_set_message_id_string */
 
-/* Tests_SRS_MESSAGE_01_075: [ `message_set_footer` shall copy the contents of `footer` as the footer contents for the message instance identified by `message`. ]*/
-/* Tests_SRS_MESSAGE_01_076: [ On success it shall return 0. ]*/
-/* Tests_SRS_MESSAGE_01_078: [ Cloning the footer shall be done by calling `annotations_clone`. ]*/
-TEST_FUNCTION(message_set_footer_copies_the_footer)
+/* Tests_SRS_MESSAGE_01_179: [ `message_set_message_id_string` shall set the message id in the properties of `message` to a string value created by calling `amqpvalue_create_message_id_string`, without any intermediate properties handle. ]*/
+/* Tests_SRS_MESSAGE_01_180: [ If the message has no properties, they shall be created by calling `properties_create`. ]*/
+/* Tests_SRS_MESSAGE_01_183: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_set_message_id_string_sets_the_message_id_in_place)
 {
     // arrange
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(cloned_footer);
+    STRICT_EXPECTED_CALL(properties_create())
+        .SetReturn(test_message_properties);
+    STRICT_EXPECTED_CALL(amqpvalue_create_message_id_string("id"))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(properties_set_message_id(test_message_properties, test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
 
     // act
-    result = message_set_footer(message, test_footer);
+    result = message_set_message_id_string(message, "id");
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -2382,33 +2785,58 @@ TEST_FUNCTION(message_set_footer_copies_the_footer)
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_077: [ If `message` is NULL, `message_set_footer` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_set_footer_with_NULL_message_fails)
+/* Tests_SRS_MESSAGE_01_180: [ If the message has no properties, they shall be created by calling `properties_create`. ]*/
+TEST_FUNCTION(message_set_message_id_string_reuses_existing_properties)
 {
     // arrange
     int result;
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_properties(message, test_message_properties);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_message_id_string("id"))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(properties_set_message_id(test_message_properties, test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
 
     // act
-    result = message_set_footer(NULL, test_footer);
+    result = message_set_message_id_string(message, "id");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_181: [ If `message` or `message_id` is NULL, `message_set_message_id_string` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_set_message_id_string_with_NULL_message_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = message_set_message_id_string(NULL, "id");
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_MESSAGE_01_079: [ If `annotations_clone` fails, `message_set_footer` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_annotations_clone_fails_message_set_footer_fails)
+/* Tests_SRS_MESSAGE_01_182: [ If any of the calls made by `message_set_message_id_string` or `message_set_correlation_id_string` fails, they shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_properties_create_fails_message_set_message_id_string_fails)
 {
     // arrange
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+    STRICT_EXPECTED_CALL(properties_create())
         .SetReturn(NULL);
 
     // act
-    result = message_set_footer(message, test_footer);
+    result = message_set_message_id_string(message, "id");
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -2418,57 +2846,69 @@ TEST_FUNCTION(when_annotations_clone_fails_message_set_footer_fails)
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_080: [ If setting the footer fails, the previous value shall be preserved. ]*/
-TEST_FUNCTION(when_annotations_clone_fails_the_footer_on_the_message_is_preserved)
+/* message_set_correlation_id_string */
+
+/* Tests_SRS_MESSAGE_01_184: [ `message_set_correlation_id_string` shall set the correlation id in the properties of `message` to a string value created by calling `amqpvalue_create_message_id_string`, without any intermediate properties handle. ]*/
+TEST_FUNCTION(message_set_correlation_id_string_sets_the_correlation_id_in_place)
 {
     // arrange
-    annotations stored_footer;
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(cloned_footer);
-    (void)message_set_footer(message, test_footer);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(NULL);
-    (void)message_set_footer(message, test_footer);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(annotations_clone(cloned_footer))
-        .SetReturn(other_cloned_footer);
+    STRICT_EXPECTED_CALL(properties_create())
+        .SetReturn(test_message_properties);
+    STRICT_EXPECTED_CALL(amqpvalue_create_message_id_string("corr"))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(properties_set_correlation_id(test_message_properties, test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
 
     // act
-    result = message_get_footer(message, &stored_footer);
+    result = message_set_correlation_id_string(message, "corr");
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(void_ptr, (void*)other_cloned_footer, stored_footer);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_151: [ If `footer` is NULL, the previously stored footer associated with `message` shall be freed. ]*/
-TEST_FUNCTION(message_set_footer_with_NULL_footer_frees_the_previous_value)
+/* Tests_SRS_MESSAGE_01_185: [ If `message` or `correlation_id` is NULL, `message_set_correlation_id_string` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_set_correlation_id_string_with_NULL_correlation_id_fails)
 {
     // arrange
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(cloned_footer);
-    (void)message_set_footer(message, test_footer);
+    // act
+    result = message_set_correlation_id_string(message, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* message_set_subject */
+
+/* Tests_SRS_MESSAGE_01_186: [ `message_set_subject` shall set the subject in the properties of `message` by calling `properties_set_subject`, creating the properties with `properties_create` if the message has none. ]*/
+TEST_FUNCTION(message_set_subject_sets_the_subject_in_place)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_destroy(cloned_footer));
+    STRICT_EXPECTED_CALL(properties_create())
+        .SetReturn(test_message_properties);
+    STRICT_EXPECTED_CALL(properties_set_subject(test_message_properties, "subject"));
 
     // act
-    result = message_set_footer(message, NULL);
+    result = message_set_subject(message, "subject");
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -2478,79 +2918,79 @@ TEST_FUNCTION(message_set_footer_with_NULL_footer_frees_the_previous_value)
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_151: [ If `footer` is NULL, the previously stored footer associated with `message` shall be freed. ]*/
-TEST_FUNCTION(message_set_footer_with_NULL_footer_twice_does_not_crash)
+/* Tests_SRS_MESSAGE_01_187: [ If `message` or `subject` is NULL, `message_set_subject` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_set_subject_with_NULL_message_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = message_set_subject(NULL, "subject");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_188: [ If creating the properties or setting the subject fails, `message_set_subject` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_properties_set_subject_fails_message_set_subject_fails)
 {
     // arrange
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(cloned_footer);
-    (void)message_set_footer(message, test_footer);
-    (void)message_set_footer(message, NULL);
-    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(properties_create())
+        .SetReturn(test_message_properties);
+    STRICT_EXPECTED_CALL(properties_set_subject(test_message_properties, "subject"))
+        .SetReturn(1);
 
     // act
-    result = message_set_footer(message, NULL);
+    result = message_set_subject(message, "subject");
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     message_destroy(message);
 }
 
-/* message_get_footer */
+/* message_set_content_type */
 
-/* Tests_SRS_MESSAGE_01_081: [ `message_get_footer` shall copy the contents of footer for the message instance identified by `message` into the argument `footer`. ]*/
-/* Tests_SRS_MESSAGE_01_082: [ On success, `message_get_footer` shall return 0. ]*/
-/* Tests_SRS_MESSAGE_01_084: [ Cloning the footer shall be done by calling `annotations_clone`. ]*/
-TEST_FUNCTION(message_get_footer_clones_the_footer)
+/* Tests_SRS_MESSAGE_01_189: [ `message_set_content_type` shall set the content type in the properties of `message` by calling `properties_set_content_type`, creating the properties with `properties_create` if the message has none. ]*/
+TEST_FUNCTION(message_set_content_type_sets_the_content_type_in_place)
 {
     // arrange
-    annotations stored_footer;
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(cloned_footer);
-    (void)message_set_footer(message, test_footer);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(annotations_clone(cloned_footer))
-        .SetReturn(other_cloned_footer);
+    STRICT_EXPECTED_CALL(properties_create())
+        .SetReturn(test_message_properties);
+    STRICT_EXPECTED_CALL(properties_set_content_type(test_message_properties, "text/plain"));
 
     // act
-    result = message_get_footer(message, &stored_footer);
+    result = message_set_content_type(message, "text/plain");
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(void_ptr, (void*)other_cloned_footer, (void*)stored_footer);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_083: [ If `message` or `footer` is NULL, `message_get_footer` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_get_footer_with_NULL_footer_fails)
+/* Tests_SRS_MESSAGE_01_190: [ If `message` or `content_type` is NULL, `message_set_content_type` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_set_content_type_with_NULL_content_type_fails)
 {
     // arrange
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(cloned_footer);
-    (void)message_set_footer(message, test_footer);
-    umock_c_reset_all_calls();
-
     // act
-    result = message_get_footer(message, NULL);
+    result = message_set_content_type(message, NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -2560,40 +3000,83 @@ TEST_FUNCTION(message_get_footer_with_NULL_footer_fails)
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_083: [ If `message` or `footer` is NULL, `message_get_footer` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_get_footer_with_NULL_message_fails)
+/* message_set_application_property_string */
+
+/* Tests_SRS_MESSAGE_01_192: [ `message_set_application_property_string` and `message_set_application_property_long` shall set the property `name` in the application properties map of `message` by calling `amqpvalue_set_map_value`, without any intermediate map handle. ]*/
+/* Tests_SRS_MESSAGE_01_193: [ If the message has no application properties, they shall be created as an empty map by calling `amqpvalue_create_map`. ]*/
+/* Tests_SRS_MESSAGE_01_196: [ On success they shall return 0. ]*/
+TEST_FUNCTION(message_set_application_property_string_sets_the_property_in_place)
 {
     // arrange
-    annotations stored_footer;
     int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("value"))
+        .SetReturn(test_amqp_value_2);
+    STRICT_EXPECTED_CALL(amqpvalue_create_map())
+        .SetReturn(test_application_properties);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("name"))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_make_writable(IGNORED_PTR_ARG))
+        .IgnoreArgument_value();
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_application_properties, test_amqp_value_1, test_amqp_value_2));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_2));
 
     // act
-    result = message_get_footer(NULL, &stored_footer);
+    result = message_set_application_property_string(message, "name", "value");
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_085: [ If `annotations_clone` fails, `message_get_footer` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_cloning_the_footer_fails_message_get_footer_fails)
+/* Tests_SRS_MESSAGE_01_194: [ If `message`, `name` or the value is NULL, the application property setters shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_set_application_property_string_with_NULL_name_fails)
 {
     // arrange
-    annotations stored_footer;
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
-        .SetReturn(cloned_footer);
-    (void)message_set_footer(message, test_footer);
+    // act
+    result = message_set_application_property_string(message, NULL, "value");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_195: [ If any of the calls made fails, the application property setters shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_amqpvalue_set_map_value_fails_message_set_application_property_string_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(annotations_clone(cloned_footer))
-        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("value"))
+        .SetReturn(test_amqp_value_2);
+    STRICT_EXPECTED_CALL(amqpvalue_create_map())
+        .SetReturn(test_application_properties);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("name"))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_make_writable(IGNORED_PTR_ARG))
+        .IgnoreArgument_value();
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_application_properties, test_amqp_value_1, test_amqp_value_2))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_2));
 
     // act
-    result = message_get_footer(message, &stored_footer);
+    result = message_set_application_property_string(message, "name", "value");
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -2603,36 +3086,642 @@ TEST_FUNCTION(when_cloning_the_footer_fails_message_get_footer_fails)
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_152: [ If no footer has been set, `message_get_footer` shall set `footer` to NULL. ]*/
-TEST_FUNCTION(message_get_footer_when_no_footer_has_been_set_yields_NULL)
+/* message_set_application_property_long */
+
+/* Tests_SRS_MESSAGE_01_192: [ `message_set_application_property_string` and `message_set_application_property_long` shall set the property `name` in the application properties map of `message` by calling `amqpvalue_set_map_value`, without any intermediate map handle. ]*/
+TEST_FUNCTION(message_set_application_property_long_sets_the_property_in_place)
 {
     // arrange
-    annotations stored_footer;
     int result;
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(amqpvalue_create_long(42))
+        .SetReturn(test_amqp_value_2);
+    STRICT_EXPECTED_CALL(amqpvalue_create_map())
+        .SetReturn(test_application_properties);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string("name"))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_make_writable(IGNORED_PTR_ARG))
+        .IgnoreArgument_value();
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(test_application_properties, test_amqp_value_1, test_amqp_value_2));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_2));
+
     // act
-    result = message_get_footer(message, &stored_footer);
+    result = message_set_application_property_long(message, "name", 42);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(void_ptr, NULL, (void*)stored_footer);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     message_destroy(message);
 }
 
-/* message_add_body_amqp_data */
+/* message_set_footer */
 
-/* Tests_SRS_MESSAGE_01_086: [ `message_add_body_amqp_data` shall add the contents of `amqp_data` to the list of AMQP data values for the body of the message identified by `message`. ]*/
-/* Tests_SRS_MESSAGE_01_087: [ On success it shall return 0. ]*/
-TEST_FUNCTION(message_add_body_amqp_data_adds_one_amqp_data_item)
+/* Tests_SRS_MESSAGE_01_075: [ `message_set_footer` shall copy the contents of `footer` as the footer contents for the message instance identified by `message`. ]*/
+/* Tests_SRS_MESSAGE_01_076: [ On success it shall return 0. ]*/
+/* Tests_SRS_MESSAGE_01_078: [ Cloning the footer shall be done by calling `annotations_clone`. ]*/
+TEST_FUNCTION(message_set_footer_copies_the_footer)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(cloned_footer);
+
+    // act
+    result = message_set_footer(message, test_footer);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_077: [ If `message` is NULL, `message_set_footer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_set_footer_with_NULL_message_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = message_set_footer(NULL, test_footer);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_079: [ If `annotations_clone` fails, `message_set_footer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_annotations_clone_fails_message_set_footer_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(NULL);
+
+    // act
+    result = message_set_footer(message, test_footer);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_080: [ If setting the footer fails, the previous value shall be preserved. ]*/
+TEST_FUNCTION(when_annotations_clone_fails_the_footer_on_the_message_is_preserved)
+{
+    // arrange
+    annotations stored_footer;
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(cloned_footer);
+    (void)message_set_footer(message, test_footer);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(NULL);
+    (void)message_set_footer(message, test_footer);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(cloned_footer))
+        .SetReturn(other_cloned_footer);
+
+    // act
+    result = message_get_footer(message, &stored_footer);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)other_cloned_footer, stored_footer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_151: [ If `footer` is NULL, the previously stored footer associated with `message` shall be freed. ]*/
+TEST_FUNCTION(message_set_footer_with_NULL_footer_frees_the_previous_value)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(cloned_footer);
+    (void)message_set_footer(message, test_footer);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_destroy(cloned_footer));
+
+    // act
+    result = message_set_footer(message, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_151: [ If `footer` is NULL, the previously stored footer associated with `message` shall be freed. ]*/
+TEST_FUNCTION(message_set_footer_with_NULL_footer_twice_does_not_crash)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(cloned_footer);
+    (void)message_set_footer(message, test_footer);
+    (void)message_set_footer(message, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_set_footer(message, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* message_get_footer */
+
+/* Tests_SRS_MESSAGE_01_081: [ `message_get_footer` shall copy the contents of footer for the message instance identified by `message` into the argument `footer`. ]*/
+/* Tests_SRS_MESSAGE_01_082: [ On success, `message_get_footer` shall return 0. ]*/
+/* Tests_SRS_MESSAGE_01_084: [ Cloning the footer shall be done by calling `annotations_clone`. ]*/
+TEST_FUNCTION(message_get_footer_clones_the_footer)
+{
+    // arrange
+    annotations stored_footer;
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(cloned_footer);
+    (void)message_set_footer(message, test_footer);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(cloned_footer))
+        .SetReturn(other_cloned_footer);
+
+    // act
+    result = message_get_footer(message, &stored_footer);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)other_cloned_footer, (void*)stored_footer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_083: [ If `message` or `footer` is NULL, `message_get_footer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_get_footer_with_NULL_footer_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(cloned_footer);
+    (void)message_set_footer(message, test_footer);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_footer(message, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_083: [ If `message` or `footer` is NULL, `message_get_footer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_get_footer_with_NULL_message_fails)
+{
+    // arrange
+    annotations stored_footer;
+    int result;
+
+    // act
+    result = message_get_footer(NULL, &stored_footer);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_085: [ If `annotations_clone` fails, `message_get_footer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_cloning_the_footer_fails_message_get_footer_fails)
+{
+    // arrange
+    annotations stored_footer;
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(test_footer))
+        .SetReturn(cloned_footer);
+    (void)message_set_footer(message, test_footer);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(annotations_clone(cloned_footer))
+        .SetReturn(NULL);
+
+    // act
+    result = message_get_footer(message, &stored_footer);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_152: [ If no footer has been set, `message_get_footer` shall set `footer` to NULL. ]*/
+TEST_FUNCTION(message_get_footer_when_no_footer_has_been_set_yields_NULL)
+{
+    // arrange
+    annotations stored_footer;
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_footer(message, &stored_footer);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, NULL, (void*)stored_footer);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* message_add_body_amqp_data */
+
+/* Tests_SRS_MESSAGE_01_086: [ `message_add_body_amqp_data` shall add the contents of `amqp_data` to the list of AMQP data values for the body of the message identified by `message`. ]*/
+/* Tests_SRS_MESSAGE_01_087: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_adds_one_amqp_data_item)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_088: [ If `message` is NULL, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_with_NULL_message_fails)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+
+    // act
+    result = message_add_body_amqp_data(NULL, amqp_data);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_089: [ If the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_with_NULL_buffer_and_non_zero_size_fails)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = NULL;
+    amqp_data.length = 1;
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_089: [ If the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_with_NULL_buffer_and_zero_size_succeeds)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = NULL;
+    amqp_data.length = 0;
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_089: [ If the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_with_non_NULL_buffer_and_zero_size_succeeds)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = 0;
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_153: [ If allocating memory to store the added AMQP data fails, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_fails)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = 0;
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_153: [ If allocating memory to store the added AMQP data fails, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_memory_for_the_AMQP_data_item_fails_message_add_body_amqp_data_fails)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_090: [ If adding the body AMQP data fails, the previous body content shall be preserved. ]*/
+TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_preserves_the_previous_empty_body_value)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    size_t body_amqp_data_count;
+    MESSAGE_HANDLE message = message_create();
+    MESSAGE_BODY_TYPE body_type;
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    (void)message_add_body_amqp_data(message, amqp_data);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_body_amqp_data_count(message, &body_amqp_data_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    (void)message_get_body_type(message, &body_type);
+    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_NONE, body_type);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_090: [ If adding the body AMQP data fails, the previous body content shall be preserved. ]*/
+TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_preserves_the_previous_body_value_with_1_amqp_data)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    BINARY_DATA read_amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    size_t body_amqp_data_count;
+    MESSAGE_HANDLE message = message_create();
+    MESSAGE_BODY_TYPE body_type;
+    char expected_bytes[128];
+    char actual_bytes[128];
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    (void)message_add_body_amqp_data(message, amqp_data);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    message_add_body_amqp_data(message, amqp_data);
+
+    // act
+    result = message_get_body_amqp_data_count(message, &body_amqp_data_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, body_amqp_data_count);
+    (void)message_get_body_type(message, &body_type);
+    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_DATA, body_type);
+    (void)message_get_body_amqp_data_in_place(message, 0, &read_amqp_data);
+    stringify_bytes(read_amqp_data.bytes, read_amqp_data.length, actual_bytes);
+    stringify_bytes(amqp_data_bytes, sizeof(amqp_data_bytes), expected_bytes);
+    ASSERT_ARE_EQUAL(char_ptr, expected_bytes, actual_bytes);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_091: [ If the body was already set to an AMQP value or a list of AMQP sequences, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_when_body_is_a_list_of_sequences_fails)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    size_t body_amqp_sequence_count;
+    MESSAGE_HANDLE message = message_create();
+    MESSAGE_BODY_TYPE body_type;
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+    (void)message_add_body_amqp_sequence(message, test_sequence_1);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    message_get_body_amqp_sequence_count(message, &body_amqp_sequence_count);
+    ASSERT_ARE_EQUAL(size_t, 1, body_amqp_sequence_count);
+    (void)message_get_body_type(message, &body_type);
+    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_SEQUENCE, body_type);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_091: [ If the body was already set to an AMQP value or a list of AMQP sequences, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_preserves_the_previous_body_value_with_amqp_value)
+{
+    // arrange
+    int result;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    MESSAGE_HANDLE message = message_create();
+    MESSAGE_BODY_TYPE body_type;
+    umock_c_reset_all_calls();
+
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+
+    STRICT_EXPECTED_CALL(amqpvalue_clone(test_amqp_value_1));
+
+    (void)message_set_body_amqp_value(message, test_amqp_value_1);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_add_body_amqp_data(message, amqp_data);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    message_get_body_type(message, &body_type);
+    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_VALUE, body_type);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* message_add_body_amqp_data_borrowed */
+
+/* Tests_SRS_MESSAGE_01_169: [ `message_add_body_amqp_data_borrowed` shall add `amqp_data` to the list of AMQP data values for the body of the message identified by `message` without copying the bytes, which shall stay valid for as long as the message exists. ]*/
+/* Tests_SRS_MESSAGE_01_170: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_borrowed_references_the_bytes)
 {
     // arrange
     int result;
     BINARY_DATA amqp_data;
+    BINARY_DATA stored_data;
     unsigned char amqp_data_bytes[] = { 0x42 };
     MESSAGE_HANDLE message = message_create();
     umock_c_reset_all_calls();
@@ -2641,21 +3730,22 @@ TEST_FUNCTION(message_add_body_amqp_data_adds_one_amqp_data_item)
     amqp_data.length = sizeof(amqp_data_bytes);
 
     STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    result = message_add_body_amqp_data_borrowed(message, amqp_data);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)message_get_body_amqp_data_in_place(message, 0, &stored_data);
+    ASSERT_ARE_EQUAL(void_ptr, amqp_data_bytes, stored_data.bytes);
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_088: [ If `message` is NULL, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_add_body_amqp_data_with_NULL_message_fails)
+/* Tests_SRS_MESSAGE_01_171: [ If `message` is NULL or the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data_borrowed` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_borrowed_with_NULL_message_fails)
 {
     // arrange
     int result;
@@ -2666,27 +3756,29 @@ TEST_FUNCTION(message_add_body_amqp_data_with_NULL_message_fails)
     amqp_data.length = sizeof(amqp_data_bytes);
 
     // act
-    result = message_add_body_amqp_data(NULL, amqp_data);
+    result = message_add_body_amqp_data_borrowed(NULL, amqp_data);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_MESSAGE_01_089: [ If the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_add_body_amqp_data_with_NULL_buffer_and_non_zero_size_fails)
+/* Tests_SRS_MESSAGE_01_172: [ If the body was already set to an AMQP value or a list of AMQP sequences, `message_add_body_amqp_data_borrowed` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_borrowed_when_AMQP_value_is_set_fails)
 {
     // arrange
     int result;
     BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
     MESSAGE_HANDLE message = message_create();
+    (void)message_set_body_amqp_value(message, test_amqp_value_1);
     umock_c_reset_all_calls();
 
-    amqp_data.bytes = NULL;
-    amqp_data.length = 1;
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    result = message_add_body_amqp_data_borrowed(message, amqp_data);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -2696,257 +3788,243 @@ TEST_FUNCTION(message_add_body_amqp_data_with_NULL_buffer_and_non_zero_size_fail
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_089: [ If the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_add_body_amqp_data_with_NULL_buffer_and_zero_size_succeeds)
+/* Tests_SRS_MESSAGE_01_173: [ `message_clone` shall copy body AMQP data added with `message_add_body_amqp_data_borrowed`, so that the cloned message does not reference the borrowed bytes. ]*/
+/* Tests_SRS_MESSAGE_01_174: [ Body AMQP data added with `message_add_body_amqp_data_borrowed` shall not be freed when the message is destroyed. ]*/
+TEST_FUNCTION(message_clone_copies_borrowed_body_amqp_data)
 {
     // arrange
-    int result;
+    MESSAGE_HANDLE cloned_message;
     BINARY_DATA amqp_data;
+    BINARY_DATA cloned_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
     MESSAGE_HANDLE message = message_create();
-    umock_c_reset_all_calls();
-
-    amqp_data.bytes = NULL;
-    amqp_data.length = 0;
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+    (void)message_add_body_amqp_data_borrowed(message, amqp_data);
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    cloned_message = message_clone(message);
+    message_destroy(message);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(cloned_message);
+    (void)message_get_body_amqp_data_in_place(cloned_message, 0, &cloned_data);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, amqp_data_bytes, cloned_data.bytes);
+    ASSERT_ARE_EQUAL(int, 0x42, (int)cloned_data.bytes[0]);
 
     // cleanup
-    message_destroy(message);
+    message_destroy(cloned_message);
 }
 
-/* Tests_SRS_MESSAGE_01_089: [ If the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_add_body_amqp_data_with_non_NULL_buffer_and_zero_size_succeeds)
+/* message_own_body_amqp_data */
+
+/* Tests_SRS_MESSAGE_01_213: [ If `message` is NULL, `message_own_body_amqp_data` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_own_body_amqp_data_with_NULL_message_fails)
 {
     // arrange
-    int result;
-    BINARY_DATA amqp_data;
-    unsigned char amqp_data_bytes[] = { 0x42 };
-    MESSAGE_HANDLE message = message_create();
-    umock_c_reset_all_calls();
-
-    amqp_data.bytes = amqp_data_bytes;
-    amqp_data.length = 0;
-
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    int result = message_own_body_amqp_data(NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_153: [ If allocating memory to store the added AMQP data fails, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_fails)
+/* Tests_SRS_MESSAGE_01_214: [ `message_own_body_amqp_data` shall copy the bytes of each body AMQP data added with `message_add_body_amqp_data_borrowed`, so that the message does not reference the borrowed bytes anymore, and return 0. ]*/
+TEST_FUNCTION(message_own_body_amqp_data_copies_the_borrowed_bytes)
 {
     // arrange
     int result;
     BINARY_DATA amqp_data;
+    BINARY_DATA stored_data;
     unsigned char amqp_data_bytes[] = { 0x42 };
+    unsigned char owned_bytes[] = { 0x43 };
     MESSAGE_HANDLE message = message_create();
-    umock_c_reset_all_calls();
 
+    amqp_data.bytes = owned_bytes;
+    amqp_data.length = sizeof(owned_bytes);
+    (void)message_add_body_amqp_data(message, amqp_data);
     amqp_data.bytes = amqp_data_bytes;
-    amqp_data.length = 0;
+    amqp_data.length = sizeof(amqp_data_bytes);
+    (void)message_add_body_amqp_data_borrowed(message, amqp_data);
+    umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(amqp_data_bytes)));
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    result = message_own_body_amqp_data(message);
+    amqp_data_bytes[0] = 0x00;
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)message_get_body_amqp_data_in_place(message, 1, &stored_data);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, amqp_data_bytes, stored_data.bytes);
+    ASSERT_ARE_EQUAL(int, 0x42, (int)stored_data.bytes[0]);
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_153: [ If allocating memory to store the added AMQP data fails, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_allocating_memory_for_the_AMQP_data_item_fails_message_add_body_amqp_data_fails)
+/* Tests_SRS_MESSAGE_01_215: [ If allocating memory for the copies fails, `message_own_body_amqp_data` shall fail and return a non-zero value, the body AMQP data not copied yet staying borrowed. ]*/
+TEST_FUNCTION(when_allocating_the_copy_fails_message_own_body_amqp_data_fails)
 {
     // arrange
     int result;
     BINARY_DATA amqp_data;
+    BINARY_DATA stored_data;
     unsigned char amqp_data_bytes[] = { 0x42 };
     MESSAGE_HANDLE message = message_create();
-    umock_c_reset_all_calls();
 
     amqp_data.bytes = amqp_data_bytes;
     amqp_data.length = sizeof(amqp_data_bytes);
+    (void)message_add_body_amqp_data_borrowed(message, amqp_data);
+    umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(amqp_data_bytes)))
         .SetReturn(NULL);
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    result = message_own_body_amqp_data(message);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)message_get_body_amqp_data_in_place(message, 0, &stored_data);
+    ASSERT_ARE_EQUAL(void_ptr, amqp_data_bytes, stored_data.bytes);
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_090: [ If adding the body AMQP data fails, the previous body content shall be preserved. ]*/
-TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_preserves_the_previous_empty_body_value)
+/* message_add_body_amqp_data_external */
+
+static size_t test_on_body_amqp_data_released_call_count;
+static void* test_on_body_amqp_data_released_context;
+
+static void test_on_body_amqp_data_released(void* context)
+{
+    test_on_body_amqp_data_released_call_count++;
+    test_on_body_amqp_data_released_context = context;
+}
+
+/* Tests_SRS_MESSAGE_01_202: [ `message_add_body_amqp_data_external` shall add `amqp_data` to the list of AMQP data values for the body of the message identified by `message` without copying the bytes, which shall stay valid until `on_released` is called. ]*/
+/* Tests_SRS_MESSAGE_01_207: [ On success it shall return 0. ]*/
+/* Tests_SRS_MESSAGE_01_206: [ When the last message referencing body AMQP data added with `message_add_body_amqp_data_external` is destroyed or reset, `on_released` shall be called with `on_released_context`. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_external_references_the_bytes_until_the_message_is_destroyed)
 {
     // arrange
     int result;
     BINARY_DATA amqp_data;
+    BINARY_DATA stored_data;
     unsigned char amqp_data_bytes[] = { 0x42 };
-    size_t body_amqp_data_count;
     MESSAGE_HANDLE message = message_create();
-    MESSAGE_BODY_TYPE body_type;
     umock_c_reset_all_calls();
+    test_on_body_amqp_data_released_call_count = 0;
 
     amqp_data.bytes = amqp_data_bytes;
     amqp_data.length = sizeof(amqp_data_bytes);
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-    (void)message_add_body_amqp_data(message, amqp_data);
-    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
     // act
-    result = message_get_body_amqp_data_count(message, &body_amqp_data_count);
+    result = message_add_body_amqp_data_external(message, amqp_data, test_on_body_amqp_data_released, (void*)0x4242);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    (void)message_get_body_type(message, &body_type);
-    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_NONE, body_type);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
+    (void)message_get_body_amqp_data_in_place(message, 0, &stored_data);
+    ASSERT_ARE_EQUAL(void_ptr, amqp_data_bytes, stored_data.bytes);
+    ASSERT_ARE_EQUAL(size_t, 0, test_on_body_amqp_data_released_call_count);
     message_destroy(message);
+    ASSERT_ARE_EQUAL(size_t, 1, test_on_body_amqp_data_released_call_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4242, test_on_body_amqp_data_released_context);
 }
 
-/* Tests_SRS_MESSAGE_01_090: [ If adding the body AMQP data fails, the previous body content shall be preserved. ]*/
-TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_preserves_the_previous_body_value_with_1_amqp_data)
+/* Tests_SRS_MESSAGE_01_203: [ If `message` or `on_released` is NULL, or the `bytes` member of `amqp_data` is NULL and the `size` member is non-zero, `message_add_body_amqp_data_external` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_external_with_NULL_on_released_fails)
 {
     // arrange
     int result;
     BINARY_DATA amqp_data;
-    BINARY_DATA read_amqp_data;
     unsigned char amqp_data_bytes[] = { 0x42 };
-    size_t body_amqp_data_count;
     MESSAGE_HANDLE message = message_create();
-    MESSAGE_BODY_TYPE body_type;
-    char expected_bytes[128];
-    char actual_bytes[128];
     umock_c_reset_all_calls();
 
     amqp_data.bytes = amqp_data_bytes;
     amqp_data.length = sizeof(amqp_data_bytes);
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-
-    (void)message_add_body_amqp_data(message, amqp_data);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-
-    message_add_body_amqp_data(message, amqp_data);
-
     // act
-    result = message_get_body_amqp_data_count(message, &body_amqp_data_count);
+    result = message_add_body_amqp_data_external(message, amqp_data, NULL, NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(size_t, 1, body_amqp_data_count);
-    (void)message_get_body_type(message, &body_type);
-    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_DATA, body_type);
-    (void)message_get_body_amqp_data_in_place(message, 0, &read_amqp_data);
-    stringify_bytes(read_amqp_data.bytes, read_amqp_data.length, actual_bytes);
-    stringify_bytes(amqp_data_bytes, sizeof(amqp_data_bytes), expected_bytes);
-    ASSERT_ARE_EQUAL(char_ptr, expected_bytes, actual_bytes);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_091: [ If the body was already set to an AMQP value or a list of AMQP sequences, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(message_add_body_amqp_data_when_body_is_a_list_of_sequences_fails)
+/* Tests_SRS_MESSAGE_01_204: [ If the body was already set to an AMQP value or a list of AMQP sequences, or any other error occurs, `message_add_body_amqp_data_external` shall fail, return a non-zero value and not call `on_released`. ]*/
+TEST_FUNCTION(message_add_body_amqp_data_external_when_AMQP_value_is_set_fails)
 {
     // arrange
     int result;
     BINARY_DATA amqp_data;
     unsigned char amqp_data_bytes[] = { 0x42 };
-    size_t body_amqp_sequence_count;
     MESSAGE_HANDLE message = message_create();
-    MESSAGE_BODY_TYPE body_type;
+    (void)message_set_body_amqp_value(message, test_amqp_value_1);
     umock_c_reset_all_calls();
+    test_on_body_amqp_data_released_call_count = 0;
 
     amqp_data.bytes = amqp_data_bytes;
     amqp_data.length = sizeof(amqp_data_bytes);
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-
-    (void)message_add_body_amqp_sequence(message, test_sequence_1);
-    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    result = message_add_body_amqp_data_external(message, amqp_data, test_on_body_amqp_data_released, NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    message_get_body_amqp_sequence_count(message, &body_amqp_sequence_count);
-    ASSERT_ARE_EQUAL(size_t, 1, body_amqp_sequence_count);
-    (void)message_get_body_type(message, &body_type);
-    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_SEQUENCE, body_type);
+    ASSERT_ARE_EQUAL(size_t, 0, test_on_body_amqp_data_released_call_count);
 
     // cleanup
     message_destroy(message);
 }
 
-/* Tests_SRS_MESSAGE_01_091: [ If the body was already set to an AMQP value or a list of AMQP sequences, `message_add_body_amqp_data` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_reallocating_memory_for_the_data_array_fails_message_add_body_amqp_data_preserves_the_previous_body_value_with_amqp_value)
+/* Tests_SRS_MESSAGE_01_205: [ `message_clone` shall not copy body AMQP data added with `message_add_body_amqp_data_external`, the cloned message shall reference the same bytes. ]*/
+/* Tests_SRS_MESSAGE_01_206: [ When the last message referencing body AMQP data added with `message_add_body_amqp_data_external` is destroyed or reset, `on_released` shall be called with `on_released_context`. ]*/
+TEST_FUNCTION(message_clone_shares_external_body_amqp_data)
 {
     // arrange
-    int result;
+    MESSAGE_HANDLE cloned_message;
     BINARY_DATA amqp_data;
+    BINARY_DATA cloned_data;
     unsigned char amqp_data_bytes[] = { 0x42 };
     MESSAGE_HANDLE message = message_create();
-    MESSAGE_BODY_TYPE body_type;
-    umock_c_reset_all_calls();
+    test_on_body_amqp_data_released_call_count = 0;
 
     amqp_data.bytes = amqp_data_bytes;
     amqp_data.length = sizeof(amqp_data_bytes);
-
-    STRICT_EXPECTED_CALL(amqpvalue_clone(test_amqp_value_1));
-
-    (void)message_set_body_amqp_value(message, test_amqp_value_1);
-    umock_c_reset_all_calls();
+    (void)message_add_body_amqp_data_external(message, amqp_data, test_on_body_amqp_data_released, NULL);
 
     // act
-    result = message_add_body_amqp_data(message, amqp_data);
+    cloned_message = message_clone(message);
+    message_destroy(message);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    message_get_body_type(message, &body_type);
-    ASSERT_ARE_EQUAL(MESSAGE_BODY_TYPE, MESSAGE_BODY_TYPE_VALUE, body_type);
-
-    // cleanup
-    message_destroy(message);
+    ASSERT_IS_NOT_NULL(cloned_message);
+    ASSERT_ARE_EQUAL(size_t, 0, test_on_body_amqp_data_released_call_count);
+    (void)message_get_body_amqp_data_in_place(cloned_message, 0, &cloned_data);
+    ASSERT_ARE_EQUAL(void_ptr, amqp_data_bytes, cloned_data.bytes);
+    message_destroy(cloned_message);
+    ASSERT_ARE_EQUAL(size_t, 1, test_on_body_amqp_data_released_call_count);
 }
 
 /* message_get_body_amqp_data_in_place */
@@ -4521,4 +5599,168 @@ TEST_FUNCTION(message_get_message_format_without_any_Set_shall_return_the_defaul
     message_destroy(message);
 }
 
+/* message_get_encoded_size */
+
+/* Tests_SRS_MESSAGE_01_197: [ `message_get_encoded_size` shall compute the total AMQP encoded size of the header, message annotations, properties, application properties and body sections of `message`, as transferred by the message sender. ]*/
+/* Tests_SRS_MESSAGE_01_201: [ On success it shall return 0. ]*/
+TEST_FUNCTION(message_get_encoded_size_adds_up_the_sections)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+    size_t header_encoded_size = 10;
+    BINARY_DATA amqp_data;
+    unsigned char amqp_data_bytes[] = { 0x42 };
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_header(message, test_header);
+    amqp_data.bytes = amqp_data_bytes;
+    amqp_data.length = sizeof(amqp_data_bytes);
+    (void)message_add_body_amqp_data(message, amqp_data);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_header(test_header))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(test_amqp_value_1, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&header_encoded_size, sizeof(header_encoded_size));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
+
+    // act
+    result = message_get_encoded_size(message, &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 10 + 5 + 1, encoded_size);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_198: [ The computed size shall be cached and returned by later calls until one of the setters changes the message. ]*/
+TEST_FUNCTION(message_get_encoded_size_returns_the_cached_size)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+    size_t header_encoded_size = 10;
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_header(message, test_header);
+    STRICT_EXPECTED_CALL(amqpvalue_create_header(test_header))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(test_amqp_value_1, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&header_encoded_size, sizeof(header_encoded_size));
+    (void)message_get_encoded_size(message, &encoded_size);
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_encoded_size(message, &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 10, encoded_size);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_198: [ The computed size shall be cached and returned by later calls until one of the setters changes the message. ]*/
+TEST_FUNCTION(message_get_encoded_size_recomputes_the_size_after_a_change)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+    size_t header_encoded_size = 10;
+    size_t properties_encoded_size = 20;
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_header(message, test_header);
+    STRICT_EXPECTED_CALL(amqpvalue_create_header(test_header))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(test_amqp_value_1, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&header_encoded_size, sizeof(header_encoded_size));
+    (void)message_get_encoded_size(message, &encoded_size);
+    (void)message_take_properties(message, test_message_properties);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_header(test_header))
+        .SetReturn(test_amqp_value_1);
+    STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(test_amqp_value_1, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&header_encoded_size, sizeof(header_encoded_size));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_1));
+    STRICT_EXPECTED_CALL(amqpvalue_create_properties(test_message_properties))
+        .SetReturn(test_amqp_value_2);
+    STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(test_amqp_value_2, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_encoded_size(&properties_encoded_size, sizeof(properties_encoded_size));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_amqp_value_2));
+
+    // act
+    result = message_get_encoded_size(message, &encoded_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 30, encoded_size);
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_199: [ If `message` or `encoded_size` is NULL, `message_get_encoded_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_get_encoded_size_with_NULL_message_fails)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+
+    // act
+    result = message_get_encoded_size(NULL, &encoded_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MESSAGE_01_199: [ If `message` or `encoded_size` is NULL, `message_get_encoded_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(message_get_encoded_size_with_NULL_encoded_size_fails)
+{
+    // arrange
+    int result;
+    MESSAGE_HANDLE message = message_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = message_get_encoded_size(message, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
+/* Tests_SRS_MESSAGE_01_200: [ If computing the encoded size of any section fails, `message_get_encoded_size` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_creating_the_header_value_fails_message_get_encoded_size_fails)
+{
+    // arrange
+    int result;
+    size_t encoded_size;
+    MESSAGE_HANDLE message = message_create();
+    (void)message_take_header(message, test_header);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_create_header(test_header))
+        .SetReturn(NULL);
+
+    // act
+    result = message_get_encoded_size(message, &encoded_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    message_destroy(message);
+}
+
 END_TEST_SUITE(message_ut)
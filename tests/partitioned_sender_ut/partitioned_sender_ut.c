@@ -0,0 +1,1099 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/message.h"
+#include "azure_uamqp_c/message_sender.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/partitioned_sender.h"
+
+#define TEST_MAX_PARTITIONS 4
+#define TEST_MAX_SENDS 8
+
+#define TEST_LINK(index) ((LINK_HANDLE)(0x5000 + (index) + 1))
+#define TEST_MESSAGE_SENDER(index) ((MESSAGE_SENDER_HANDLE)(0x6000 + (index) + 1))
+
+static SESSION_HANDLE test_session = (SESSION_HANDLE)0x4242;
+static AMQP_VALUE test_source = (AMQP_VALUE)0x4243;
+static AMQP_VALUE test_targets[TEST_MAX_PARTITIONS] = { (AMQP_VALUE)0x4301, (AMQP_VALUE)0x4302, (AMQP_VALUE)0x4303, (AMQP_VALUE)0x4304 };
+static MESSAGE_HANDLE test_message = (MESSAGE_HANDLE)0x4244;
+static MESSAGE_HANDLE test_cloned_message = (MESSAGE_HANDLE)0x4245;
+static ASYNC_OPERATION_HANDLE test_send_operation = (ASYNC_OPERATION_HANDLE)0x4246;
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static size_t created_link_count;
+static ON_MESSAGE_SENDER_STATE_CHANGED saved_on_message_sender_state_changed[TEST_MAX_PARTITIONS];
+static void* saved_on_message_sender_state_changed_context[TEST_MAX_PARTITIONS];
+static size_t started_send_count;
+static MESSAGE_SENDER_HANDLE saved_send_message_sender[TEST_MAX_SENDS];
+static ON_MESSAGE_SEND_COMPLETE saved_on_message_send_complete[TEST_MAX_SENDS];
+static void* saved_on_message_send_complete_context[TEST_MAX_SENDS];
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_message_send_complete, void*, context, MESSAGE_SEND_RESULT, send_result)
+MOCK_FUNCTION_END();
+
+static LINK_HANDLE my_link_create(SESSION_HANDLE session, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    LINK_HANDLE result;
+    (void)session;
+    (void)name;
+    (void)role;
+    (void)source;
+    (void)target;
+    result = TEST_LINK(created_link_count);
+    created_link_count++;
+    return result;
+}
+
+static MESSAGE_SENDER_HANDLE my_messagesender_create(LINK_HANDLE link, ON_MESSAGE_SENDER_STATE_CHANGED on_message_sender_state_changed, void* context)
+{
+    size_t index = (size_t)link - 0x5001;
+    saved_on_message_sender_state_changed[index] = on_message_sender_state_changed;
+    saved_on_message_sender_state_changed_context[index] = context;
+    return TEST_MESSAGE_SENDER(index);
+}
+
+static ASYNC_OPERATION_HANDLE my_messagesender_send_async(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context, tickcounter_ms_t timeout)
+{
+    (void)message;
+    (void)timeout;
+    saved_send_message_sender[started_send_count] = message_sender;
+    saved_on_message_send_complete[started_send_count] = on_message_send_complete;
+    saved_on_message_send_complete_context[started_send_count] = callback_context;
+    started_send_count++;
+    return test_send_operation;
+}
+
+#define role_VALUES \
+    role_sender,    \
+    role_receiver
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+#ifndef __cplusplus
+TEST_DEFINE_ENUM_TYPE(role, role_VALUES);
+#endif
+IMPLEMENT_UMOCK_C_ENUM_TYPE(role, role_VALUES);
+
+TEST_DEFINE_ENUM_TYPE(MESSAGE_SEND_RESULT, MESSAGE_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(MESSAGE_SEND_RESULT, MESSAGE_SEND_RESULT_VALUES);
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static PARTITIONED_SENDER_HANDLE create_partitioned_sender(size_t partition_count, size_t max_in_flight_per_partition)
+{
+    PARTITIONED_SENDER_CONFIG config;
+    config.link_name = "test_link";
+    config.source = test_source;
+    config.targets = test_targets;
+    config.partition_count = partition_count;
+    config.max_in_flight_per_partition = max_in_flight_per_partition;
+    config.sessions = NULL;
+    return partitioned_sender_create(test_session, &config);
+}
+
+static void set_partition_state(size_t partition_index, MESSAGE_SENDER_STATE new_state, MESSAGE_SENDER_STATE previous_state)
+{
+    saved_on_message_sender_state_changed[partition_index](saved_on_message_sender_state_changed_context[partition_index], new_state, previous_state);
+}
+
+static void open_partitions(size_t partition_count)
+{
+    size_t i;
+    for (i = 0; i < partition_count; i++)
+    {
+        set_partition_state(i, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    }
+}
+
+BEGIN_TEST_SUITE(partitioned_sender_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_TYPE(role, role);
+    REGISTER_TYPE(MESSAGE_SEND_RESULT, MESSAGE_SEND_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(link_create, my_link_create);
+    REGISTER_GLOBAL_MOCK_HOOK(messagesender_create, my_messagesender_create);
+    REGISTER_GLOBAL_MOCK_HOOK(messagesender_send_async, my_messagesender_send_async);
+    REGISTER_GLOBAL_MOCK_RETURN(message_clone, test_cloned_message);
+    REGISTER_GLOBAL_MOCK_RETURN(messagesender_open, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(messagesender_close, 0);
+
+    REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LINK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_VALUE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MESSAGE_SENDER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_MESSAGE_SENDER_STATE_CHANGED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_MESSAGE_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ASYNC_OPERATION_HANDLE, void*);
+
+    /* boo, we need uint_fast32_t in umock */
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, uint32_t);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    created_link_count = 0;
+    started_send_count = 0;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* partitioned_sender_create */
+
+/* Tests_SRS_PARTITIONED_SENDER_01_001: [ On success `partitioned_sender_create` shall return a non-NULL handle to a new partitioned sender. ]*/
+/* Tests_SRS_PARTITIONED_SENDER_01_003: [ For each partition `partitioned_sender_create` shall create a sender link by calling `link_create` with the session of the partition, a name made of `link_name`, a dash and the partition index, `role_sender`, `source` and the target of the partition. ]*/
+/* Tests_SRS_PARTITIONED_SENDER_01_004: [ For each partition `partitioned_sender_create` shall create a message sender on its link by calling `messagesender_create`. ]*/
+TEST_FUNCTION(partitioned_sender_create_creates_a_link_and_a_message_sender_per_partition)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_create(test_session, "test_link-0", role_sender, test_source, test_targets[0]));
+    STRICT_EXPECTED_CALL(messagesender_create(TEST_LINK(0), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_create(test_session, "test_link-1", role_sender, test_source, test_targets[1]));
+    STRICT_EXPECTED_CALL(messagesender_create(TEST_LINK(1), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    partitioned_sender = create_partitioned_sender(2, 1);
+
+    // assert
+    ASSERT_IS_NOT_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_027: [ If `sessions` in `config` is not NULL, the session of a partition shall be the item of `sessions` at the index of the partition, otherwise it shall be `session`. ]*/
+TEST_FUNCTION(partitioned_sender_create_with_sessions_creates_each_link_on_the_session_of_its_partition)
+{
+    // arrange
+    SESSION_HANDLE sessions[2] = { (SESSION_HANDLE)0x4401, (SESSION_HANDLE)0x4402 };
+    PARTITIONED_SENDER_CONFIG config;
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+    config.link_name = "test_link";
+    config.source = test_source;
+    config.targets = test_targets;
+    config.partition_count = 2;
+    config.max_in_flight_per_partition = 1;
+    config.sessions = sessions;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_create(sessions[0], "test_link-0", role_sender, test_source, test_targets[0]));
+    STRICT_EXPECTED_CALL(messagesender_create(TEST_LINK(0), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_create(sessions[1], "test_link-1", role_sender, test_source, test_targets[1]));
+    STRICT_EXPECTED_CALL(messagesender_create(TEST_LINK(1), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    partitioned_sender = partitioned_sender_create(NULL, &config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_002: [ If `config` is NULL, `session` and `sessions` in `config` are both NULL, `link_name` or `targets` in `config` is NULL, or `partition_count` or `max_in_flight_per_partition` is 0, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_create_with_NULL_session_and_NULL_sessions_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_CONFIG config;
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+    config.link_name = "test_link";
+    config.source = test_source;
+    config.targets = test_targets;
+    config.partition_count = 2;
+    config.max_in_flight_per_partition = 1;
+    config.sessions = NULL;
+
+    // act
+    partitioned_sender = partitioned_sender_create(NULL, &config);
+
+    // assert
+    ASSERT_IS_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_002: [ If `config` is NULL, `session` and `sessions` in `config` are both NULL, `link_name` or `targets` in `config` is NULL, or `partition_count` or `max_in_flight_per_partition` is 0, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_create_with_NULL_config_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+
+    // act
+    partitioned_sender = partitioned_sender_create(test_session, NULL);
+
+    // assert
+    ASSERT_IS_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_002: [ If `config` is NULL, `session` and `sessions` in `config` are both NULL, `link_name` or `targets` in `config` is NULL, or `partition_count` or `max_in_flight_per_partition` is 0, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_create_with_NULL_link_name_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_CONFIG config;
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+    config.link_name = NULL;
+    config.source = test_source;
+    config.targets = test_targets;
+    config.partition_count = 2;
+    config.max_in_flight_per_partition = 1;
+    config.sessions = NULL;
+
+    // act
+    partitioned_sender = partitioned_sender_create(test_session, &config);
+
+    // assert
+    ASSERT_IS_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_002: [ If `config` is NULL, `session` and `sessions` in `config` are both NULL, `link_name` or `targets` in `config` is NULL, or `partition_count` or `max_in_flight_per_partition` is 0, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_create_with_NULL_targets_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_CONFIG config;
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+    config.link_name = "test_link";
+    config.source = test_source;
+    config.targets = NULL;
+    config.partition_count = 2;
+    config.max_in_flight_per_partition = 1;
+    config.sessions = NULL;
+
+    // act
+    partitioned_sender = partitioned_sender_create(test_session, &config);
+
+    // assert
+    ASSERT_IS_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_002: [ If `config` is NULL, `session` and `sessions` in `config` are both NULL, `link_name` or `targets` in `config` is NULL, or `partition_count` or `max_in_flight_per_partition` is 0, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_create_with_0_partitions_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+
+    // act
+    partitioned_sender = create_partitioned_sender(0, 1);
+
+    // assert
+    ASSERT_IS_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_002: [ If `config` is NULL, `session` and `sessions` in `config` are both NULL, `link_name` or `targets` in `config` is NULL, or `partition_count` or `max_in_flight_per_partition` is 0, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_create_with_0_max_in_flight_per_partition_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+
+    // act
+    partitioned_sender = create_partitioned_sender(2, 0);
+
+    // assert
+    ASSERT_IS_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_005: [ If any error occurs, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_partitioned_sender_create_fails_then_partitioned_sender_create_fails)
+{
+    // arrange
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(link_create(test_session, "test_link-0", role_sender, test_source, test_targets[0]))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(messagesender_create(TEST_LINK(0), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(NULL);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        char tmp_msg[128];
+        PARTITIONED_SENDER_HANDLE partitioned_sender;
+        (void)sprintf(tmp_msg, "Failure in test %u/%u", (unsigned int)(index + 1), (unsigned int)count);
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+        created_link_count = 0;
+
+        // act
+        partitioned_sender = create_partitioned_sender(1, 1);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(partitioned_sender, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_005: [ If any error occurs, `partitioned_sender_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_creating_the_second_partition_fails_the_first_partition_is_destroyed)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_create(test_session, "test_link-0", role_sender, test_source, test_targets[0]));
+    STRICT_EXPECTED_CALL(messagesender_create(TEST_LINK(0), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_create(test_session, "test_link-1", role_sender, test_source, test_targets[1]))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(messagesender_destroy(TEST_MESSAGE_SENDER(0)));
+    STRICT_EXPECTED_CALL(link_destroy(TEST_LINK(0)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    partitioned_sender = create_partitioned_sender(2, 1);
+
+    // assert
+    ASSERT_IS_NULL(partitioned_sender);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* partitioned_sender_destroy */
+
+/* Tests_SRS_PARTITIONED_SENDER_01_006: [ `partitioned_sender_destroy` shall destroy the message sender and the link of each partition by calling `messagesender_destroy` and `link_destroy`, and complete the sends still waiting with `MESSAGE_SEND_CANCELLED`. ]*/
+TEST_FUNCTION(partitioned_sender_destroy_destroys_the_partitions)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_destroy(TEST_MESSAGE_SENDER(0)));
+    STRICT_EXPECTED_CALL(link_destroy(TEST_LINK(0)));
+    STRICT_EXPECTED_CALL(messagesender_destroy(TEST_MESSAGE_SENDER(1)));
+    STRICT_EXPECTED_CALL(link_destroy(TEST_LINK(1)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    partitioned_sender_destroy(partitioned_sender);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_006: [ `partitioned_sender_destroy` shall destroy the message sender and the link of each partition by calling `messagesender_destroy` and `link_destroy`, and complete the sends still waiting with `MESSAGE_SEND_CANCELLED`. ]*/
+TEST_FUNCTION(partitioned_sender_destroy_cancels_the_waiting_sends)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(1, 1);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, "key", test_on_message_send_complete, (void*)0x4247);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_destroy(TEST_MESSAGE_SENDER(0)));
+    STRICT_EXPECTED_CALL(link_destroy(TEST_LINK(0)));
+    STRICT_EXPECTED_CALL(test_on_message_send_complete((void*)0x4247, MESSAGE_SEND_CANCELLED));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_message_send_complete((void*)0x4248, MESSAGE_SEND_CANCELLED));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    partitioned_sender_destroy(partitioned_sender);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_007: [ If `partitioned_sender` is NULL, `partitioned_sender_destroy` shall do nothing. ]*/
+TEST_FUNCTION(partitioned_sender_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    partitioned_sender_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* partitioned_sender_open */
+
+/* Tests_SRS_PARTITIONED_SENDER_01_008: [ `partitioned_sender_open` shall open the message sender of each partition by calling `messagesender_open` and on success return 0. ]*/
+TEST_FUNCTION(partitioned_sender_open_opens_each_message_sender)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_open(TEST_MESSAGE_SENDER(0)));
+    STRICT_EXPECTED_CALL(messagesender_open(TEST_MESSAGE_SENDER(1)));
+
+    // act
+    result = partitioned_sender_open(partitioned_sender);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_009: [ If `partitioned_sender` is NULL, `partitioned_sender_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(partitioned_sender_open_with_NULL_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = partitioned_sender_open(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_010: [ If `messagesender_open` fails, `partitioned_sender_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_messagesender_open_fails_partitioned_sender_open_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_open(TEST_MESSAGE_SENDER(0)))
+        .SetReturn(1);
+
+    // act
+    result = partitioned_sender_open(partitioned_sender);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* partitioned_sender_close */
+
+/* Tests_SRS_PARTITIONED_SENDER_01_011: [ `partitioned_sender_close` shall close the message sender of each partition by calling `messagesender_close` and on success return 0. ]*/
+TEST_FUNCTION(partitioned_sender_close_closes_each_message_sender)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_close(TEST_MESSAGE_SENDER(0)));
+    STRICT_EXPECTED_CALL(messagesender_close(TEST_MESSAGE_SENDER(1)));
+
+    // act
+    result = partitioned_sender_close(partitioned_sender);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_012: [ If `partitioned_sender` is NULL, `partitioned_sender_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(partitioned_sender_close_with_NULL_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = partitioned_sender_close(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_013: [ If `messagesender_close` fails for a partition, `partitioned_sender_close` shall still close the other partitions and then fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_messagesender_close_fails_the_other_partitions_are_still_closed)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_close(TEST_MESSAGE_SENDER(0)))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(messagesender_close(TEST_MESSAGE_SENDER(1)));
+
+    // act
+    result = partitioned_sender_close(partitioned_sender);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* partitioned_sender_send_async */
+
+/* Tests_SRS_PARTITIONED_SENDER_01_014: [ `partitioned_sender_send_async` shall queue a clone of `message` obtained by calling `message_clone` and on success return 0. ]*/
+TEST_FUNCTION(partitioned_sender_send_async_before_the_partitions_are_open_queues_the_send)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(message_clone(test_message));
+
+    // act
+    result = partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_015: [ If `partitioned_sender` or `message` is NULL, `partitioned_sender_send_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(partitioned_sender_send_async_with_NULL_partitioned_sender_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = partitioned_sender_send_async(NULL, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_015: [ If `partitioned_sender` or `message` is NULL, `partitioned_sender_send_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(partitioned_sender_send_async_with_NULL_message_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = partitioned_sender_send_async(partitioned_sender, NULL, NULL, test_on_message_send_complete, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_021: [ If any error occurs, `partitioned_sender_send_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_one_of_the_functions_called_by_partitioned_sender_send_async_fails_then_partitioned_sender_send_async_fails)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    size_t count;
+    size_t index;
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(message_clone(test_message))
+        .SetFailReturn(NULL);
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (index = 0; index < count; index++)
+    {
+        char tmp_msg[128];
+        int result;
+        (void)sprintf(tmp_msg, "Failure in test %u/%u", (unsigned int)(index + 1), (unsigned int)count);
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        result = partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_018: [ A waiting send shall be handed to the message sender of its partition by calling `messagesender_send_async` when that message sender is open and has fewer than `max_in_flight_per_partition` sends that have not completed, after which the clone of the message shall be destroyed. ]*/
+TEST_FUNCTION(partitioned_sender_send_async_on_an_open_partition_hands_the_send_to_its_message_sender)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(1, 1);
+    int result;
+    open_partitions(1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(message_clone(test_message));
+    STRICT_EXPECTED_CALL(messagesender_send_async(TEST_MESSAGE_SENDER(0), test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    result = partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_018: [ A waiting send shall be handed to the message sender of its partition by calling `messagesender_send_async` when that message sender is open and has fewer than `max_in_flight_per_partition` sends that have not completed, after which the clone of the message shall be destroyed. ]*/
+TEST_FUNCTION(when_a_partition_opens_the_waiting_sends_are_handed_to_it)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(1, 2);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_send_async(TEST_MESSAGE_SENDER(0), test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+    STRICT_EXPECTED_CALL(messagesender_send_async(TEST_MESSAGE_SENDER(0), test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    open_partitions(1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_018: [ A waiting send shall be handed to the message sender of its partition by calling `messagesender_send_async` when that message sender is open and has fewer than `max_in_flight_per_partition` sends that have not completed, after which the clone of the message shall be destroyed. ]*/
+TEST_FUNCTION(a_partition_with_max_in_flight_per_partition_sends_gets_no_more_sends)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(1, 1);
+    int result;
+    open_partitions(1);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(message_clone(test_message));
+
+    // act
+    result = partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_017: [ If `partition_key` is NULL, the send shall wait in a queue shared by all the partitions and be handed to the next open partition with room, going round robin over the partitions. ]*/
+TEST_FUNCTION(sends_without_a_key_are_spread_over_the_open_partitions)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(3, 1);
+    open_partitions(3);
+    umock_c_reset_all_calls();
+
+    // act
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4248);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 3, started_send_count);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, saved_send_message_sender[0], saved_send_message_sender[1]);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, saved_send_message_sender[0], saved_send_message_sender[2]);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, saved_send_message_sender[1], saved_send_message_sender[2]);
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_017: [ If `partition_key` is NULL, the send shall wait in a queue shared by all the partitions and be handed to the next open partition with room, going round robin over the partitions. ]*/
+TEST_FUNCTION(a_send_without_a_key_goes_to_the_open_partition_when_another_is_not_open)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    set_partition_state(1, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_OPENING);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(message_clone(test_message));
+    STRICT_EXPECTED_CALL(messagesender_send_async(TEST_MESSAGE_SENDER(1), test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_016: [ If `partition_key` is not NULL, the send shall wait for the partition whose index is the FNV-1a hash of the characters of `partition_key` modulo the partition count. ]*/
+TEST_FUNCTION(sends_with_the_same_key_go_to_the_same_partition)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    open_partitions(2);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, "device-1", test_on_message_send_complete, (void*)0x4247);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(message_clone(test_message));
+
+    // act
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, "device-1", test_on_message_send_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, started_send_count);
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_016: [ If `partition_key` is not NULL, the send shall wait for the partition whose index is the FNV-1a hash of the characters of `partition_key` modulo the partition count. ]*/
+TEST_FUNCTION(a_key_is_routed_by_its_FNV_1a_hash)
+{
+    // arrange
+    /* FNV-1a of "a" is 0xE40C292C, which is 0 modulo 4 */
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(4, 1);
+    open_partitions(4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(message_clone(test_message));
+    STRICT_EXPECTED_CALL(messagesender_send_async(TEST_MESSAGE_SENDER(0), test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, "a", test_on_message_send_complete, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_019: [ If `messagesender_send_async` fails, `on_message_send_complete` shall be called with `callback_context` and `MESSAGE_SEND_ERROR`. ]*/
+TEST_FUNCTION(when_messagesender_send_async_fails_the_send_completes_with_error)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(1, 1);
+    int result;
+    open_partitions(1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(message_clone(test_message));
+    STRICT_EXPECTED_CALL(messagesender_send_async(TEST_MESSAGE_SENDER(0), test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(test_on_message_send_complete((void*)0x4247, MESSAGE_SEND_ERROR));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    result = partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_020: [ When a send handed to a message sender completes, `on_message_send_complete` shall be called with `callback_context` and the send result, and the sends waiting for room shall be handed out again. ]*/
+TEST_FUNCTION(when_a_send_completes_the_callback_is_called_and_the_next_send_is_handed_out)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(1, 1);
+    open_partitions(1);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_message_send_complete((void*)0x4247, MESSAGE_SEND_OK));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(messagesender_send_async(TEST_MESSAGE_SENDER(0), test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    saved_on_message_send_complete[0](saved_on_message_send_complete_context[0], MESSAGE_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, started_send_count);
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_020: [ When a send handed to a message sender completes, `on_message_send_complete` shall be called with `callback_context` and the send result, and the sends waiting for room shall be handed out again. ]*/
+TEST_FUNCTION(room_freed_on_one_partition_is_used_by_a_send_without_a_key)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    open_partitions(2);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4247);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4248);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_message_send_complete((void*)0x4248, MESSAGE_SEND_OK));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(messagesender_send_async(saved_send_message_sender[1], test_cloned_message, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+
+    // act
+    saved_on_message_send_complete[1](saved_on_message_send_complete_context[1], MESSAGE_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_022: [ When the message sender of a partition goes to `MESSAGE_SENDER_STATE_ERROR`, the sends waiting for that partition because of their key shall be completed with `MESSAGE_SEND_ERROR`. ]*/
+TEST_FUNCTION(when_a_partition_fails_the_sends_waiting_for_it_complete_with_error)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(1, 1);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, "key", test_on_message_send_complete, (void*)0x4247);
+    (void)partitioned_sender_send_async(partitioned_sender, test_message, NULL, test_on_message_send_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_message_send_complete((void*)0x4247, MESSAGE_SEND_ERROR));
+    STRICT_EXPECTED_CALL(message_destroy(test_cloned_message));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    set_partition_state(0, MESSAGE_SENDER_STATE_ERROR, MESSAGE_SENDER_STATE_OPENING);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* partitioned_sender_get_link */
+
+/* Tests_SRS_PARTITIONED_SENDER_01_023: [ `partitioned_sender_get_link` shall return the link of the partition at `partition_index`. ]*/
+TEST_FUNCTION(partitioned_sender_get_link_returns_the_link_of_the_partition)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    LINK_HANDLE result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = partitioned_sender_get_link(partitioned_sender, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_LINK(1), result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_024: [ If `partitioned_sender` is NULL or `partition_index` is not less than the partition count, `partitioned_sender_get_link` shall return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_get_link_with_NULL_partitioned_sender_returns_NULL)
+{
+    // arrange
+    LINK_HANDLE result;
+
+    // act
+    result = partitioned_sender_get_link(NULL, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_024: [ If `partitioned_sender` is NULL or `partition_index` is not less than the partition count, `partitioned_sender_get_link` shall return NULL. ]*/
+TEST_FUNCTION(partitioned_sender_get_link_with_an_index_out_of_range_returns_NULL)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    LINK_HANDLE result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = partitioned_sender_get_link(partitioned_sender, 2);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* partitioned_sender_dowork */
+
+/* Tests_SRS_PARTITIONED_SENDER_01_025: [ `partitioned_sender_dowork` shall call `messagesender_dowork` for the message sender of each partition. ]*/
+TEST_FUNCTION(partitioned_sender_dowork_calls_messagesender_dowork_for_each_partition)
+{
+    // arrange
+    PARTITIONED_SENDER_HANDLE partitioned_sender = create_partitioned_sender(2, 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(messagesender_dowork(TEST_MESSAGE_SENDER(0)));
+    STRICT_EXPECTED_CALL(messagesender_dowork(TEST_MESSAGE_SENDER(1)));
+
+    // act
+    partitioned_sender_dowork(partitioned_sender);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    partitioned_sender_destroy(partitioned_sender);
+}
+
+/* Tests_SRS_PARTITIONED_SENDER_01_026: [ If `partitioned_sender` is NULL, `partitioned_sender_dowork` shall do nothing. ]*/
+TEST_FUNCTION(partitioned_sender_dowork_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    partitioned_sender_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(partitioned_sender_ut)
@@ -0,0 +1,329 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "azure_c_shared_utility/xlogging.h"
+#include "perf_counters.h"
+
+static const char* counter_names[PERF_COUNTER_COUNT] = { "cycles", "instructions", "cache-misses", "branch-misses" };
+
+typedef struct PERF_COUNTERS_INSTANCE_TAG
+{
+    bool is_available[PERF_COUNTER_COUNT];
+#if defined(__linux__)
+    /* the first one opened leads the group, the others follow in the order of member_counters */
+    int fds[PERF_COUNTER_COUNT];
+    PERF_COUNTER member_counters[PERF_COUNTER_COUNT];
+    size_t member_count;
+#endif
+} PERF_COUNTERS_INSTANCE;
+
+#if defined(__linux__)
+
+static const uint64_t hardware_event_configs[PERF_COUNTER_COUNT] =
+{
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int open_hardware_event(uint64_t event_config, int group_fd, bool exclude_kernel)
+{
+    struct perf_event_attr attr;
+
+    (void)memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = event_config;
+    /* the leader starts disabled and enables the whole group once it is complete */
+    attr.disabled = (group_fd == -1) ? 1 : 0;
+    attr.exclude_kernel = exclude_kernel ? 1 : 0;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    /* this thread, on any CPU */
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static void close_events(PERF_COUNTERS_INSTANCE* perf_counters)
+{
+    size_t i;
+
+    for (i = 0; i < perf_counters->member_count; i++)
+    {
+        (void)close(perf_counters->fds[i]);
+        perf_counters->is_available[perf_counters->member_counters[i]] = false;
+    }
+
+    perf_counters->member_count = 0;
+}
+
+static void open_events(PERF_COUNTERS_INSTANCE* perf_counters, bool exclude_kernel)
+{
+    size_t i;
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        int fd = open_hardware_event(hardware_event_configs[i], (perf_counters->member_count == 0) ? -1 : perf_counters->fds[0], exclude_kernel);
+
+        /* a counter the CPU does not have (often the case in virtual machines) is left out */
+        if (fd >= 0)
+        {
+            perf_counters->fds[perf_counters->member_count] = fd;
+            perf_counters->member_counters[perf_counters->member_count] = (PERF_COUNTER)i;
+            perf_counters->member_count++;
+            perf_counters->is_available[i] = true;
+        }
+    }
+}
+
+#endif
+
+PERF_COUNTERS_HANDLE perf_counters_create(void)
+{
+    PERF_COUNTERS_INSTANCE* result = (PERF_COUNTERS_INSTANCE*)calloc(1, sizeof(PERF_COUNTERS_INSTANCE));
+
+    if (result == NULL)
+    {
+        LogError("Cannot allocate memory for the perf counters");
+    }
+    else
+    {
+#ifdef _WIN32
+        result->is_available[PERF_COUNTER_CYCLES] = true;
+#elif defined(__linux__)
+        open_events(result, false);
+        if (result->member_count == 0)
+        {
+            /* perf_event_paranoid 2 only allows counting user space */
+            open_events(result, true);
+        }
+
+        if (result->member_count == 0)
+        {
+            LogError("perf_event_open failed, check /proc/sys/kernel/perf_event_paranoid");
+            free(result);
+            result = NULL;
+        }
+        else if ((ioctl(result->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) != 0) ||
+            (ioctl(result->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0))
+        {
+            LogError("Cannot enable the perf events");
+            close_events(result);
+            free(result);
+            result = NULL;
+        }
+#else
+        LogError("Hardware counters are not supported on this platform");
+        free(result);
+        result = NULL;
+#endif
+    }
+
+    return result;
+}
+
+void perf_counters_destroy(PERF_COUNTERS_HANDLE perf_counters)
+{
+    if (perf_counters != NULL)
+    {
+#if defined(__linux__)
+        close_events(perf_counters);
+#endif
+        free(perf_counters);
+    }
+}
+
+bool perf_counters_is_available(PERF_COUNTERS_HANDLE perf_counters, PERF_COUNTER counter)
+{
+    return (perf_counters != NULL) &&
+        (counter < PERF_COUNTER_COUNT) &&
+        perf_counters->is_available[counter];
+}
+
+int perf_counters_read(PERF_COUNTERS_HANDLE perf_counters, PERF_COUNTER_VALUES* values)
+{
+    int result;
+
+    if ((perf_counters == NULL) ||
+        (values == NULL))
+    {
+        LogError("Bad arguments: perf_counters = %p, values = %p", perf_counters, values);
+        result = __LINE__;
+    }
+    else
+    {
+#ifdef _WIN32
+        ULONG64 cycle_time;
+
+        (void)memset(values, 0, sizeof(PERF_COUNTER_VALUES));
+        if (!QueryThreadCycleTime(GetCurrentThread(), &cycle_time))
+        {
+            LogError("QueryThreadCycleTime failed");
+            result = __LINE__;
+        }
+        else
+        {
+            values->values[PERF_COUNTER_CYCLES] = (uint64_t)cycle_time;
+            result = 0;
+        }
+#elif defined(__linux__)
+        /* PERF_FORMAT_GROUP with both times: nr, time_enabled, time_running, then one value per member */
+        uint64_t read_values[3 + PERF_COUNTER_COUNT];
+        ssize_t read_size = read(perf_counters->fds[0], read_values, sizeof(uint64_t) * (3 + perf_counters->member_count));
+
+        (void)memset(values, 0, sizeof(PERF_COUNTER_VALUES));
+        if ((read_size != (ssize_t)(sizeof(uint64_t) * (3 + perf_counters->member_count))) ||
+            (read_values[0] != perf_counters->member_count))
+        {
+            LogError("Cannot read the perf events");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < perf_counters->member_count; i++)
+            {
+                uint64_t value = read_values[3 + i];
+
+                /* the group was multiplexed with other events, scale to the time it was enabled */
+                if ((read_values[2] != 0) &&
+                    (read_values[2] < read_values[1]))
+                {
+                    value = (uint64_t)((double)value * (double)read_values[1] / (double)read_values[2]);
+                }
+
+                values->values[perf_counters->member_counters[i]] = value;
+            }
+
+            result = 0;
+        }
+#else
+        (void)memset(values, 0, sizeof(PERF_COUNTER_VALUES));
+        result = __LINE__;
+#endif
+    }
+
+    return result;
+}
+
+void perf_counters_subtract(PERF_COUNTER_VALUES* values, const PERF_COUNTER_VALUES* start_values)
+{
+    size_t i;
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        /* a scaled value can come out slightly smaller than the one before */
+        values->values[i] = (values->values[i] > start_values->values[i]) ? values->values[i] - start_values->values[i] : 0;
+    }
+}
+
+void perf_counters_phase_begin(PERF_COUNTERS_HANDLE perf_counters, PERF_PHASE* phase)
+{
+    if (perf_counters != NULL)
+    {
+        if (perf_counters_read(perf_counters, &phase->start) != 0)
+        {
+            (void)memset(&phase->start, 0, sizeof(PERF_COUNTER_VALUES));
+        }
+    }
+}
+
+void perf_counters_phase_end(PERF_COUNTERS_HANDLE perf_counters, PERF_PHASE* phase)
+{
+    PERF_COUNTER_VALUES values;
+
+    if ((perf_counters != NULL) &&
+        (perf_counters_read(perf_counters, &values) == 0))
+    {
+        size_t i;
+
+        perf_counters_subtract(&values, &phase->start);
+        for (i = 0; i < PERF_COUNTER_COUNT; i++)
+        {
+            phase->total.values[i] += values.values[i];
+        }
+    }
+}
+
+void perf_counters_print_header(PERF_COUNTERS_HANDLE perf_counters, const char* title)
+{
+    size_t i;
+
+    (void)perf_counters;
+    (void)printf("%-20s", title);
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        (void)printf(" %14s", counter_names[i]);
+    }
+
+    (void)printf(" %6s\n", "IPC");
+}
+
+void perf_counters_print_values(PERF_COUNTERS_HANDLE perf_counters, const char* name, const PERF_COUNTER_VALUES* values, uint64_t operation_count)
+{
+    size_t i;
+    double count = (operation_count == 0) ? 1.0 : (double)operation_count;
+
+    (void)printf("%-20s", name);
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        if (perf_counters_is_available(perf_counters, (PERF_COUNTER)i))
+        {
+            (void)printf(" %14.2f", (double)values->values[i] / count);
+        }
+        else
+        {
+            (void)printf(" %14s", "-");
+        }
+    }
+
+    if (perf_counters_is_available(perf_counters, PERF_COUNTER_CYCLES) &&
+        perf_counters_is_available(perf_counters, PERF_COUNTER_INSTRUCTIONS) &&
+        (values->values[PERF_COUNTER_CYCLES] > 0))
+    {
+        (void)printf(" %6.2f\n", (double)values->values[PERF_COUNTER_INSTRUCTIONS] / (double)values->values[PERF_COUNTER_CYCLES]);
+    }
+    else
+    {
+        (void)printf(" %6s\n", "-");
+    }
+}
+
+void perf_counters_print_phases(PERF_COUNTERS_HANDLE perf_counters, const char* title, const PERF_PHASE* phases, size_t phase_count, uint64_t operation_count)
+{
+    if (perf_counters != NULL)
+    {
+        PERF_COUNTER_VALUES total_values;
+        size_t i;
+        size_t j;
+
+        (void)memset(&total_values, 0, sizeof(total_values));
+        perf_counters_print_header(perf_counters, title);
+
+        for (i = 0; i < phase_count; i++)
+        {
+            perf_counters_print_values(perf_counters, phases[i].name, &phases[i].total, operation_count);
+
+            for (j = 0; j < PERF_COUNTER_COUNT; j++)
+            {
+                total_values.values[j] += phases[i].total.values[j];
+            }
+        }
+
+        perf_counters_print_values(perf_counters, "total", &total_values, operation_count);
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hardware counters of the calling thread for the benchmarks, so that a change can be checked for what it does to
+   cycles, instructions, cache misses and branch misses rather than only to the elapsed time.
+   On Linux they come from perf_event_open, as one group read with a single read() (kernel time is included when
+   perf_event_paranoid allows it, user time only otherwise). On Windows only the cycles are available, from
+   QueryThreadCycleTime, the other counters need a kernel driver. Elsewhere perf_counters_create returns NULL.
+   A phase is a named accumulator: the counters read at perf_counters_phase_begin are subtracted from the ones read at
+   perf_counters_phase_end and added to its total. Each read costs a system call on Linux, so a phase should cover
+   a batch of operations rather than a single one. */
+
+typedef enum PERF_COUNTER_TAG
+{
+    PERF_COUNTER_CYCLES,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_CACHE_MISSES,
+    PERF_COUNTER_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+} PERF_COUNTER;
+
+typedef struct PERF_COUNTER_VALUES_TAG
+{
+    uint64_t values[PERF_COUNTER_COUNT];
+} PERF_COUNTER_VALUES;
+
+typedef struct PERF_PHASE_TAG
+{
+    const char* name;
+    PERF_COUNTER_VALUES start;
+    PERF_COUNTER_VALUES total;
+} PERF_PHASE;
+
+typedef struct PERF_COUNTERS_INSTANCE_TAG* PERF_COUNTERS_HANDLE;
+
+PERF_COUNTERS_HANDLE perf_counters_create(void);
+void perf_counters_destroy(PERF_COUNTERS_HANDLE perf_counters);
+bool perf_counters_is_available(PERF_COUNTERS_HANDLE perf_counters, PERF_COUNTER counter);
+/* the values of the counters not available are 0 */
+int perf_counters_read(PERF_COUNTERS_HANDLE perf_counters, PERF_COUNTER_VALUES* values);
+void perf_counters_subtract(PERF_COUNTER_VALUES* values, const PERF_COUNTER_VALUES* start_values);
+
+/* the phase functions do nothing when perf_counters is NULL, so that the benchmarks can call them unconditionally */
+void perf_counters_phase_begin(PERF_COUNTERS_HANDLE perf_counters, PERF_PHASE* phase);
+void perf_counters_phase_end(PERF_COUNTERS_HANDLE perf_counters, PERF_PHASE* phase);
+
+/* prints the counters divided by operation_count, the counters not available as - */
+void perf_counters_print_header(PERF_COUNTERS_HANDLE perf_counters, const char* title);
+void perf_counters_print_values(PERF_COUNTERS_HANDLE perf_counters, const char* name, const PERF_COUNTER_VALUES* values, uint64_t operation_count);
+void perf_counters_print_phases(PERF_COUNTERS_HANDLE perf_counters, const char* title, const PERF_PHASE* phases, size_t phase_count, uint64_t operation_count);
+
+#endif /* PERF_COUNTERS_H */
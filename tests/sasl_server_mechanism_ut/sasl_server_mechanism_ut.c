@@ -11,6 +11,7 @@
 #include "testrunnerswitcher.h"
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
 
 static void* my_gballoc_malloc(size_t size)
 {
@@ -22,16 +23,21 @@ static void my_gballoc_free(void* ptr)
     free(ptr);
 }
 
+#include "azure_uamqp_c/sasl_server_mechanism.h"
+
 #define ENABLE_MOCKS
 
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_uamqp_c/sasl_server_verdict_cache.h"
 
 #undef ENABLE_MOCKS
 
-#include "azure_uamqp_c/sasl_server_mechanism.h"
-
 static const CONCRETE_SASL_SERVER_MECHANISM_HANDLE test_concrete_sasl_server_mechanism_handle = (CONCRETE_SASL_SERVER_MECHANISM_HANDLE)0x4242;
 static const char* test_mechanism_name = "test_mechanism_name";
+static const SASL_SERVER_VERDICT_CACHE_HANDLE test_verdict_cache = (SASL_SERVER_VERDICT_CACHE_HANDLE)0x4343;
+static const unsigned char test_initial_response[] = { 0x00, 'u', 0x00, 'p' };
+static ON_SASL_SERVER_MECHANISM_COMPLETE saved_on_complete;
+static void* saved_on_complete_context;
 
 /* sasl mechanism concrete implementation mocks */
 MOCK_FUNCTION_WITH_CODE(, CONCRETE_SASL_SERVER_MECHANISM_HANDLE, test_sasl_server_mechanism_create, void*, create_parameters)
@@ -44,10 +50,25 @@ MOCK_FUNCTION_WITH_CODE(, int, test_sasl_server_mechanism_handle_response, CONCR
 MOCK_FUNCTION_END(0);
 MOCK_FUNCTION_WITH_CODE(, const char*, test_sasl_server_mechanism_get_mechanism_name)
 MOCK_FUNCTION_END(test_mechanism_name);
+MOCK_FUNCTION_WITH_CODE(, int, test_sasl_server_mechanism_handle_initial_response_async, CONCRETE_SASL_SERVER_MECHANISM_HANDLE, concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES*, initial_response_bytes, const char*, hostname, ON_SASL_SERVER_MECHANISM_COMPLETE, on_complete, void*, on_complete_context)
+    saved_on_complete = on_complete;
+    saved_on_complete_context = on_complete_context;
+MOCK_FUNCTION_END(0);
+MOCK_FUNCTION_WITH_CODE(, int, test_sasl_server_mechanism_handle_response_async, CONCRETE_SASL_SERVER_MECHANISM_HANDLE, concrete_sasl_server_mechanism, const SASL_SERVER_MECHANISM_BYTES*, response_bytes, ON_SASL_SERVER_MECHANISM_COMPLETE, on_complete, void*, on_complete_context)
+    saved_on_complete = on_complete;
+    saved_on_complete_context = on_complete_context;
+MOCK_FUNCTION_END(0);
+
+/* consumer callback mocks */
+MOCK_FUNCTION_WITH_CODE(, void, test_on_complete, void*, context, SASL_SERVER_MECHANISM_OUTCOME, outcome, const SASL_SERVER_MECHANISM_BYTES*, challenge_bytes)
+MOCK_FUNCTION_END();
 
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
+TEST_DEFINE_ENUM_TYPE(SASL_SERVER_MECHANISM_OUTCOME, SASL_SERVER_MECHANISM_OUTCOME_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(SASL_SERVER_MECHANISM_OUTCOME, SASL_SERVER_MECHANISM_OUTCOME_VALUES);
+
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
@@ -63,7 +84,20 @@ static const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION test_sasl_server_mechan
     test_sasl_server_mechanism_destroy,
     test_sasl_server_mechanism_handle_initial_response,
     test_sasl_server_mechanism_handle_response,
-    test_sasl_server_mechanism_get_mechanism_name
+    test_sasl_server_mechanism_get_mechanism_name,
+    NULL,
+    NULL
+};
+
+static const SASL_SERVER_MECHANISM_INTERFACE_DESCRIPTION test_async_sasl_server_mechanism_interface_description =
+{
+    test_sasl_server_mechanism_create,
+    test_sasl_server_mechanism_destroy,
+    test_sasl_server_mechanism_handle_initial_response,
+    test_sasl_server_mechanism_handle_response,
+    test_sasl_server_mechanism_get_mechanism_name,
+    test_sasl_server_mechanism_handle_initial_response_async,
+    test_sasl_server_mechanism_handle_response_async
 };
 
 BEGIN_TEST_SUITE(sasl_server_mechanism_ut)
@@ -80,11 +114,19 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     result = umocktypes_charptr_register_types();
     ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
+    REGISTER_GLOBAL_MOCK_RETURN(sasl_server_verdict_cache_lookup, false);
+    REGISTER_GLOBAL_MOCK_RETURN(sasl_server_verdict_cache_store, 0);
+
     REGISTER_UMOCK_ALIAS_TYPE(CONCRETE_SASL_SERVER_MECHANISM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SASL_SERVER_VERDICT_CACHE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SASL_SERVER_MECHANISM_COMPLETE, void*);
+    REGISTER_TYPE(SASL_SERVER_MECHANISM_OUTCOME, SASL_SERVER_MECHANISM_OUTCOME);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -103,6 +145,8 @@ TEST_FUNCTION_INITIALIZE(method_init)
     }
 
     umock_c_reset_all_calls();
+    saved_on_complete = NULL;
+    saved_on_complete_context = NULL;
 }
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -570,4 +614,625 @@ TEST_FUNCTION(when_the_underlying_get_mechanism_name_fails_then_sasl_server_mech
     sasl_server_mechanism_destroy(sasl_server_mechanism);
 }
 
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_023: [ The `handle_initial_response_async` and `handle_response_async` members are optional and may be NULL. ]*/
+TEST_FUNCTION(sasl_server_mechanism_create_with_async_handlers_succeeds)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_create((void*)0x4242));
+
+    // act
+    result = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sasl_server_mechanism_destroy(result);
+}
+
+/* sasl_server_mechanism_handle_initial_response_async */
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_024: [ If the argument `sasl_server_mechanism` or `on_complete` is NULL, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_initial_response_async_with_NULL_handle_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(NULL, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_024: [ If the argument `sasl_server_mechanism` or `on_complete` is NULL, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_initial_response_async_with_NULL_on_complete_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", NULL, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_028: [ Otherwise `sasl_server_mechanism_handle_initial_response_async` shall call `handle_initial_response` and complete right away, with `SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE` and the challenge bytes when a challenge is to be sent and with `SASL_SERVER_MECHANISM_OUTCOME_OK` otherwise. ]*/
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_034: [ On success, `sasl_server_mechanism_handle_initial_response_async` shall return 0. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_initial_response_async_without_async_handler_completes_with_OK)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    bool send_challenge = false;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_send_challenge(&send_challenge, sizeof(send_challenge));
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_OK, NULL));
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_028: [ Otherwise `sasl_server_mechanism_handle_initial_response_async` shall call `handle_initial_response` and complete right away, with `SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE` and the challenge bytes when a challenge is to be sent and with `SASL_SERVER_MECHANISM_OUTCOME_OK` otherwise. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_initial_response_async_without_async_handler_completes_with_CHALLENGE)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    bool send_challenge = true;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_send_challenge(&send_challenge, sizeof(send_challenge));
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_029: [ If the underlying call fails, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value, without calling `on_complete`. ]*/
+TEST_FUNCTION(when_the_underlying_handle_initial_response_fails_sasl_server_mechanism_handle_initial_response_async_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_027: [ If the concrete mechanism has a `handle_initial_response_async`, `sasl_server_mechanism_handle_initial_response_async` shall call it, passing `initial_response_bytes`, `hostname` and a completion callback of its own. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_initial_response_async_calls_the_async_handler)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response_async(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(saved_on_complete);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_031: [ When the concrete mechanism completes, the `on_complete` callback shall be called with `on_complete_context`, the outcome and the challenge bytes, after the mechanism stopped being busy so that the callback can hand in the next response. ]*/
+TEST_FUNCTION(when_the_async_handler_completes_on_complete_is_called)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    SASL_SERVER_MECHANISM_BYTES challenge_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    challenge_bytes.bytes = test_initial_response;
+    challenge_bytes.length = 1;
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, &challenge_bytes));
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_response_async(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    saved_on_complete(saved_on_complete_context, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, &challenge_bytes);
+    result = sasl_server_mechanism_handle_response_async(sasl_server_mechanism, &initial_response_bytes, test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_025: [ If a response is still being handled, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_initial_response_async_while_pending_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_029: [ If the underlying call fails, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value, without calling `on_complete`. ]*/
+TEST_FUNCTION(when_the_async_handler_fails_sasl_server_mechanism_handle_initial_response_async_fails_and_is_not_pending)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response_async(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response_async(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_026: [ If a verdict cache is set, `sasl_server_mechanism_handle_initial_response_async` shall look the initial response up by calling `sasl_server_verdict_cache_lookup` with the mechanism name, `hostname` and `initial_response_bytes`; when a verdict is found `on_complete` shall be called with it and 0 returned, without calling the concrete mechanism. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_initial_response_async_completes_with_a_cached_verdict)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    SASL_SERVER_MECHANISM_OUTCOME cached_outcome = SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, test_verdict_cache);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_get_mechanism_name());
+    STRICT_EXPECTED_CALL(sasl_server_verdict_cache_lookup(test_verdict_cache, test_mechanism_name, "test_host", &initial_response_bytes, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_outcome(&cached_outcome, sizeof(cached_outcome))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED, NULL));
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_032: [ When a verdict cache is set and the outcome of an initial response is `SASL_SERVER_MECHANISM_OUTCOME_OK` or `SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED`, the outcome shall be stored by calling `sasl_server_verdict_cache_store` with the mechanism name, the hostname and the initial response bytes. ]*/
+TEST_FUNCTION(when_the_async_handler_completes_the_verdict_is_stored_in_the_cache)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, test_verdict_cache);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_get_mechanism_name());
+    STRICT_EXPECTED_CALL(sasl_server_verdict_cache_lookup(test_verdict_cache, test_mechanism_name, "test_host", &initial_response_bytes, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response_async(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_get_mechanism_name());
+    STRICT_EXPECTED_CALL(sasl_server_verdict_cache_store(test_verdict_cache, test_mechanism_name, "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_OK, NULL));
+
+    // act
+    (void)sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+    saved_on_complete(saved_on_complete_context, SASL_SERVER_MECHANISM_OUTCOME_OK, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_032: [ When a verdict cache is set and the outcome of an initial response is `SASL_SERVER_MECHANISM_OUTCOME_OK` or `SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED`, the outcome shall be stored by calling `sasl_server_verdict_cache_store` with the mechanism name, the hostname and the initial response bytes. ]*/
+TEST_FUNCTION(when_the_async_handler_asks_for_a_challenge_nothing_is_stored_in_the_cache)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, test_verdict_cache);
+    (void)sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, &initial_response_bytes));
+
+    // act
+    saved_on_complete(saved_on_complete_context, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, &initial_response_bytes);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_033: [ If `sasl_server_verdict_cache_store` fails, the outcome shall still be indicated. ]*/
+TEST_FUNCTION(when_storing_the_verdict_fails_on_complete_is_still_called)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, test_verdict_cache);
+    (void)sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, NULL, test_on_complete, (void*)0x4444);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_get_mechanism_name());
+    STRICT_EXPECTED_CALL(sasl_server_verdict_cache_store(test_verdict_cache, test_mechanism_name, NULL, &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED, NULL));
+
+    // act
+    saved_on_complete(saved_on_complete_context, SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_030: [ If copying the initial response to cache its verdict fails, `sasl_server_mechanism_handle_initial_response_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_copying_the_initial_response_fails_sasl_server_mechanism_handle_initial_response_async_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, test_verdict_cache);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_get_mechanism_name());
+    STRICT_EXPECTED_CALL(sasl_server_verdict_cache_lookup(test_verdict_cache, test_mechanism_name, "test_host", &initial_response_bytes, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_007: [ `sasl_server_mechanism_destroy` shall free all resources associated with the SASL mechanism handle. ]*/
+TEST_FUNCTION(sasl_server_mechanism_destroy_with_a_pending_initial_response_frees_its_copy)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, test_verdict_cache);
+    (void)sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_destroy(test_concrete_sasl_server_mechanism_handle));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* sasl_server_mechanism_handle_response_async */
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_035: [ If the argument `sasl_server_mechanism` or `on_complete` is NULL, `sasl_server_mechanism_handle_response_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_response_async_with_NULL_handle_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_BYTES response_bytes;
+    int result;
+
+    response_bytes.bytes = test_initial_response;
+    response_bytes.length = sizeof(test_initial_response);
+
+    // act
+    result = sasl_server_mechanism_handle_response_async(NULL, &response_bytes, test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_035: [ If the argument `sasl_server_mechanism` or `on_complete` is NULL, `sasl_server_mechanism_handle_response_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_response_async_with_NULL_on_complete_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES response_bytes;
+    int result;
+
+    response_bytes.bytes = test_initial_response;
+    response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_mechanism_handle_response_async(sasl_server_mechanism, &response_bytes, NULL, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_036: [ If a response is still being handled, `sasl_server_mechanism_handle_response_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_response_async_while_pending_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES response_bytes;
+    int result;
+
+    response_bytes.bytes = test_initial_response;
+    response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_handle_response_async(sasl_server_mechanism, &response_bytes, test_on_complete, (void*)0x4444);
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_mechanism_handle_response_async(sasl_server_mechanism, &response_bytes, test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_037: [ If the concrete mechanism has a `handle_response_async`, `sasl_server_mechanism_handle_response_async` shall call it, passing `response_bytes` and a completion callback of its own. ]*/
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_040: [ On success, `sasl_server_mechanism_handle_response_async` shall return 0. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_response_async_calls_the_async_handler)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES response_bytes;
+    int result;
+
+    response_bytes.bytes = test_initial_response;
+    response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_response_async(test_concrete_sasl_server_mechanism_handle, &response_bytes, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_OK, NULL));
+
+    // act
+    result = sasl_server_mechanism_handle_response_async(sasl_server_mechanism, &response_bytes, test_on_complete, (void*)0x4444);
+    saved_on_complete(saved_on_complete_context, SASL_SERVER_MECHANISM_OUTCOME_OK, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_038: [ Otherwise `sasl_server_mechanism_handle_response_async` shall call `handle_response` and complete right away, with `SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE` and the challenge bytes when a challenge is to be sent and with `SASL_SERVER_MECHANISM_OUTCOME_OK` otherwise. ]*/
+TEST_FUNCTION(sasl_server_mechanism_handle_response_async_without_async_handler_completes_with_CHALLENGE)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES response_bytes;
+    bool send_next_challenge = true;
+    int result;
+
+    response_bytes.bytes = test_initial_response;
+    response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_response(test_concrete_sasl_server_mechanism_handle, &response_bytes, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_send_next_challenge(&send_next_challenge, sizeof(send_next_challenge));
+    STRICT_EXPECTED_CALL(test_on_complete((void*)0x4444, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_mechanism_handle_response_async(sasl_server_mechanism, &response_bytes, test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_039: [ If the underlying call fails, `sasl_server_mechanism_handle_response_async` shall fail and return a non-zero value, without calling `on_complete`. ]*/
+TEST_FUNCTION(when_the_underlying_handle_response_fails_sasl_server_mechanism_handle_response_async_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES response_bytes;
+    int result;
+
+    response_bytes.bytes = test_initial_response;
+    response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_sasl_server_mechanism_interface_description, (void*)0x4242);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_response(test_concrete_sasl_server_mechanism_handle, &response_bytes, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = sasl_server_mechanism_handle_response_async(sasl_server_mechanism, &response_bytes, test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* sasl_server_mechanism_set_verdict_cache */
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_041: [ `sasl_server_mechanism_set_verdict_cache` shall make the following initial responses use `verdict_cache` (none when NULL) and return 0. ]*/
+TEST_FUNCTION(sasl_server_mechanism_set_verdict_cache_with_NULL_cache_stops_caching)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_HANDLE sasl_server_mechanism;
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes;
+    int result;
+
+    initial_response_bytes.bytes = test_initial_response;
+    initial_response_bytes.length = sizeof(test_initial_response);
+    sasl_server_mechanism = sasl_server_mechanism_create(&test_async_sasl_server_mechanism_interface_description, (void*)0x4242);
+    (void)sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, test_verdict_cache);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_sasl_server_mechanism_handle_initial_response_async(test_concrete_sasl_server_mechanism_handle, &initial_response_bytes, "test_host", IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_mechanism_set_verdict_cache(sasl_server_mechanism, NULL);
+    (void)sasl_server_mechanism_handle_initial_response_async(sasl_server_mechanism, &initial_response_bytes, "test_host", test_on_complete, (void*)0x4444);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_mechanism_destroy(sasl_server_mechanism);
+}
+
+/* Tests_SRS_SASL_SERVER_MECHANISM_01_042: [ If the argument `sasl_server_mechanism` is NULL, `sasl_server_mechanism_set_verdict_cache` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_mechanism_set_verdict_cache_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = sasl_server_mechanism_set_verdict_cache(NULL, test_verdict_cache);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
 END_TEST_SUITE(sasl_server_mechanism_ut)
@@ -0,0 +1,632 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "azure_uamqp_c/sasl_server_mechanism.h"
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/sasl_server_verdict_cache.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static TICK_COUNTER_HANDLE test_tick_counter = (TICK_COUNTER_HANDLE)0x4200;
+static const unsigned char test_initial_response[] = { 0x00, 'u', 0x00, 'p' };
+static const unsigned char test_other_initial_response[] = { 0x00, 'u', 0x00, 'q' };
+static tickcounter_ms_t test_current_ms;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = test_current_ms;
+    return 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static SASL_SERVER_MECHANISM_BYTES make_bytes(const unsigned char* bytes, uint32_t length)
+{
+    SASL_SERVER_MECHANISM_BYTES result;
+    result.bytes = bytes;
+    result.length = length;
+    return result;
+}
+
+BEGIN_TEST_SUITE(sasl_server_verdict_cache_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, test_tick_counter);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    test_current_ms = 1000;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* sasl_server_verdict_cache_create */
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_001: [ `sasl_server_verdict_cache_create` shall create an empty cache with room for `max_entries` verdicts and a tick counter obtained by calling `tickcounter_create`, and on success return a non-NULL handle to it. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_create_returns_a_valid_handle)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    // act
+    sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+
+    // assert
+    ASSERT_IS_NOT_NULL(sasl_server_verdict_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_002: [ If `max_entries` or `time_to_live_ms` is 0, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_create_with_0_max_entries_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache;
+
+    // act
+    sasl_server_verdict_cache = sasl_server_verdict_cache_create(0, 60000);
+
+    // assert
+    ASSERT_IS_NULL(sasl_server_verdict_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_002: [ If `max_entries` or `time_to_live_ms` is 0, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_create_with_0_time_to_live_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache;
+
+    // act
+    sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 0);
+
+    // assert
+    ASSERT_IS_NULL(sasl_server_verdict_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_003: [ If allocating memory or `tickcounter_create` fails, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_cache_fails_sasl_server_verdict_cache_create_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+
+    // assert
+    ASSERT_IS_NULL(sasl_server_verdict_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_003: [ If allocating memory or `tickcounter_create` fails, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_entries_fails_sasl_server_verdict_cache_create_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+
+    // assert
+    ASSERT_IS_NULL(sasl_server_verdict_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_003: [ If allocating memory or `tickcounter_create` fails, `sasl_server_verdict_cache_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_tickcounter_create_fails_sasl_server_verdict_cache_create_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+
+    // assert
+    ASSERT_IS_NULL(sasl_server_verdict_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* sasl_server_verdict_cache_destroy */
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_004: [ `sasl_server_verdict_cache_destroy` shall free all cached verdicts, destroy the tick counter by calling `tickcounter_destroy` and free the cache. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_destroy_frees_the_cached_verdicts)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(test_tick_counter));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_005: [ If `sasl_server_verdict_cache` is NULL, `sasl_server_verdict_cache_destroy` shall do nothing. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    sasl_server_verdict_cache_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* sasl_server_verdict_cache_store */
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_011: [ On success, `sasl_server_verdict_cache_store` shall return 0. ]*/
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_014: [ `sasl_server_verdict_cache_store` shall get the current time by calling `tickcounter_get_current_ms`; if that fails it shall fail and return a non-zero value. ]*/
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_016: [ Otherwise the verdict shall be kept with a copy of the key in a free or expired entry, or when all entries are in use in place of the entry that expires first. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_store_keeps_a_copy_of_the_key)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("PLAIN") + sizeof("test_host") + sizeof(test_initial_response)));
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_012: [ If `sasl_server_verdict_cache`, `mechanism_name` or `initial_response_bytes` is NULL, or `initial_response_bytes` has a NULL `bytes` and a non-zero `length`, `sasl_server_verdict_cache_store` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_store_with_NULL_cache_fails)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    int result;
+
+    // act
+    result = sasl_server_verdict_cache_store(NULL, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_012: [ If `sasl_server_verdict_cache`, `mechanism_name` or `initial_response_bytes` is NULL, or `initial_response_bytes` has a NULL `bytes` and a non-zero `length`, `sasl_server_verdict_cache_store` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_store_with_NULL_mechanism_name_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, NULL, "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_012: [ If `sasl_server_verdict_cache`, `mechanism_name` or `initial_response_bytes` is NULL, or `initial_response_bytes` has a NULL `bytes` and a non-zero `length`, `sasl_server_verdict_cache_store` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_store_with_NULL_bytes_and_non_zero_length_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(NULL, 4);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_013: [ If `outcome` is neither `SASL_SERVER_MECHANISM_OUTCOME_OK` nor `SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED`, `sasl_server_verdict_cache_store` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_store_with_a_challenge_outcome_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_CHALLENGE);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_014: [ `sasl_server_verdict_cache_store` shall get the current time by calling `tickcounter_get_current_ms`; if that fails it shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_getting_the_current_time_fails_sasl_server_verdict_cache_store_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_015: [ If a verdict is already kept for the same key, its outcome shall be replaced and its time to live restarted. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_store_for_a_kept_key_replaces_the_verdict)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    int result;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    test_current_ms += 50000;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    test_current_ms += 50000;
+    ASSERT_IS_TRUE(sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, &outcome));
+    ASSERT_ARE_EQUAL(int, (int)SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED, (int)outcome);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_016: [ Otherwise the verdict shall be kept with a copy of the key in a free or expired entry, or when all entries are in use in place of the entry that expires first. ]*/
+TEST_FUNCTION(when_the_cache_is_full_the_verdict_expiring_first_is_replaced)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(2, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_BYTES other_initial_response_bytes = make_bytes(test_other_initial_response, sizeof(test_other_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    int result;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "host_1", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    test_current_ms += 10;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "host_2", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "host_2", &other_initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "host_1", &initial_response_bytes, &outcome));
+    ASSERT_IS_TRUE(sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "host_2", &initial_response_bytes, &outcome));
+    ASSERT_IS_TRUE(sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "host_2", &other_initial_response_bytes, &outcome));
+    ASSERT_ARE_EQUAL(int, (int)SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED, (int)outcome);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_017: [ If allocating memory fails, `sasl_server_verdict_cache_store` shall fail, return a non-zero value and leave the cache unchanged. ]*/
+TEST_FUNCTION(when_allocating_the_key_fails_sasl_server_verdict_cache_store_fails)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, &outcome));
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* sasl_server_verdict_cache_lookup */
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_007: [ `sasl_server_verdict_cache_lookup` shall get the current time by calling `tickcounter_get_current_ms`; if that fails it shall return false. ]*/
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_008: [ If a verdict is kept for the same `mechanism_name`, `hostname` (NULL being the same as an empty hostname) and `initial_response_bytes`, `sasl_server_verdict_cache_lookup` shall fill `outcome` with it and return true. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_lookup_finds_a_kept_verdict)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    bool result;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", NULL, &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "", &initial_response_bytes, &outcome);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(int, (int)SASL_SERVER_MECHANISM_OUTCOME_AUTH_FAILED, (int)outcome);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_010: [ If no verdict is kept for the same `mechanism_name`, `hostname` and `initial_response_bytes`, `sasl_server_verdict_cache_lookup` shall return false. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_lookup_for_other_response_bytes_returns_false)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_BYTES other_initial_response_bytes = make_bytes(test_other_initial_response, sizeof(test_other_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    bool result;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "test_host", &other_initial_response_bytes, &outcome);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_010: [ If no verdict is kept for the same `mechanism_name`, `hostname` and `initial_response_bytes`, `sasl_server_verdict_cache_lookup` shall return false. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_lookup_for_another_mechanism_returns_false)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    bool result;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAINX", "test_host", &initial_response_bytes, &outcome);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_009: [ A verdict whose time to live has passed shall be dropped and `sasl_server_verdict_cache_lookup` shall return false. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_lookup_drops_an_expired_verdict)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    bool result;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    test_current_ms += 60000;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, &outcome);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_006: [ If `sasl_server_verdict_cache`, `mechanism_name`, `initial_response_bytes` or `outcome` is NULL, or `initial_response_bytes` has a NULL `bytes` and a non-zero `length`, `sasl_server_verdict_cache_lookup` shall return false. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_lookup_with_NULL_cache_returns_false)
+{
+    // arrange
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    bool result;
+
+    // act
+    result = sasl_server_verdict_cache_lookup(NULL, "PLAIN", "test_host", &initial_response_bytes, &outcome);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_006: [ If `sasl_server_verdict_cache`, `mechanism_name`, `initial_response_bytes` or `outcome` is NULL, or `initial_response_bytes` has a NULL `bytes` and a non-zero `length`, `sasl_server_verdict_cache_lookup` shall return false. ]*/
+TEST_FUNCTION(sasl_server_verdict_cache_lookup_with_NULL_outcome_returns_false)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    bool result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+/* Tests_SRS_SASL_SERVER_VERDICT_CACHE_01_007: [ `sasl_server_verdict_cache_lookup` shall get the current time by calling `tickcounter_get_current_ms`; if that fails it shall return false. ]*/
+TEST_FUNCTION(when_getting_the_current_time_fails_sasl_server_verdict_cache_lookup_returns_false)
+{
+    // arrange
+    SASL_SERVER_VERDICT_CACHE_HANDLE sasl_server_verdict_cache = sasl_server_verdict_cache_create(4, 60000);
+    SASL_SERVER_MECHANISM_BYTES initial_response_bytes = make_bytes(test_initial_response, sizeof(test_initial_response));
+    SASL_SERVER_MECHANISM_OUTCOME outcome;
+    bool result;
+    (void)sasl_server_verdict_cache_store(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, SASL_SERVER_MECHANISM_OUTCOME_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(test_tick_counter, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = sasl_server_verdict_cache_lookup(sasl_server_verdict_cache, "PLAIN", "test_host", &initial_response_bytes, &outcome);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(result);
+
+    // cleanup
+    sasl_server_verdict_cache_destroy(sasl_server_verdict_cache);
+}
+
+END_TEST_SUITE(sasl_server_verdict_cache_ut)
@@ -1767,6 +1767,7 @@ TEST_FUNCTION(saslclientio_setoption_with_logtrace_false_succeeds)
 /* saslclientio_retrieveoptions */
 
 /* Tests_SRS_SASLCLIENTIO_01_133: [ `saslclientio_retrieveoptions` shall create an option handler by calling `OptionHandler_Create`. ]*/
+/* Tests_SRS_SASLCLIENTIO_01_155: [ If `xio_retrieveoptions` returns NULL, no underlying IO options shall be added. ]*/
 TEST_FUNCTION(saslclientio_retrieveoptions_creates_an_option_handler)
 {
     // arrange
@@ -1782,6 +1783,7 @@ TEST_FUNCTION(saslclientio_retrieveoptions_creates_an_option_handler)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_underlying_io));
 
     // act
     result = saslclientio_get_interface_description()->concrete_io_retrieveoptions(sasl_client_io);
@@ -1859,6 +1861,7 @@ TEST_FUNCTION(when_logtrace_was_set_to_true_saslclientio_retrieveoptions_adds_it
     STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(OptionHandler_AddOption(test_optionhandler_handle, "logtrace", &log_trace))
         .ValidateArgumentValue_value_AsType(UMOCK_TYPE(bool*));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_underlying_io));
 
     // act
     result = saslclientio_get_interface_description()->concrete_io_retrieveoptions(sasl_client_io);
@@ -1893,6 +1896,7 @@ TEST_FUNCTION(when_logtrace_was_set_to_false_saslclientio_retrieveoptions_adds_i
     STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(OptionHandler_AddOption(test_optionhandler_handle, "logtrace", &log_trace))
         .ValidateArgumentValue_value_AsType(UMOCK_TYPE(bool*));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_underlying_io));
 
     // act
     result = saslclientio_get_interface_description()->concrete_io_retrieveoptions(sasl_client_io);
@@ -1939,6 +1943,124 @@ TEST_FUNCTION(when_OptionHandler_AddOption_fails_saslclientio_retrieveoptions_al
     saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
 }
 
+/* Tests_SRS_SASLCLIENTIO_01_154: [ `saslclientio_retrieveoptions` shall get the options of the underlying IO by calling `xio_retrieveoptions` and add them as - underlying_io_options - OPTIONHANDLER_HANDLE. ]*/
+/* Tests_SRS_SASLCLIENTIO_01_156: [ The options retrieved from the underlying IO shall be destroyed by calling `OptionHandler_Destroy` once added. ]*/
+TEST_FUNCTION(saslclientio_retrieveoptions_adds_the_options_of_the_underlying_io)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    OPTIONHANDLER_HANDLE result;
+    OPTIONHANDLER_HANDLE underlying_io_options = (OPTIONHANDLER_HANDLE)0x4247;
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_underlying_io))
+        .SetReturn(underlying_io_options);
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(test_optionhandler_handle, "underlying_io_options", underlying_io_options));
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(underlying_io_options));
+
+    // act
+    result = saslclientio_get_interface_description()->concrete_io_retrieveoptions(sasl_client_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(result);
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_138: [ If `OptionHandler_AddOption` or `OptionHandler_Create` fails then `saslclientio_retrieveoptions` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_adding_the_underlying_io_options_fails_saslclientio_retrieveoptions_also_fails)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    OPTIONHANDLER_HANDLE result;
+    OPTIONHANDLER_HANDLE underlying_io_options = (OPTIONHANDLER_HANDLE)0x4247;
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_underlying_io))
+        .SetReturn(underlying_io_options);
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(test_optionhandler_handle, "underlying_io_options", underlying_io_options))
+        .SetReturn(OPTIONHANDLER_ERROR);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(test_optionhandler_handle));
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(underlying_io_options));
+
+    // act
+    result = saslclientio_get_interface_description()->concrete_io_retrieveoptions(sasl_client_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_152: [ - underlying_io_options - OPTIONHANDLER_HANDLE, the options of the underlying IO, which shall be set on the underlying IO by calling `OptionHandler_FeedOptions`. ]*/
+/* Tests_SRS_SASLCLIENTIO_01_128: [ On success, `saslclientio_setoption` shall return 0. ]*/
+TEST_FUNCTION(saslclientio_setoption_with_underlying_io_options_feeds_them_to_the_underlying_io)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    int result;
+    OPTIONHANDLER_HANDLE underlying_io_options = (OPTIONHANDLER_HANDLE)0x4247;
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(underlying_io_options, test_underlying_io))
+        .SetReturn(OPTIONHANDLER_OK);
+
+    // act
+    result = saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "underlying_io_options", underlying_io_options);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_153: [ If `OptionHandler_FeedOptions` fails, `saslclientio_setoption` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_OptionHandler_FeedOptions_fails_saslclientio_setoption_also_fails)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    int result;
+    OPTIONHANDLER_HANDLE underlying_io_options = (OPTIONHANDLER_HANDLE)0x4247;
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(underlying_io_options, test_underlying_io))
+        .SetReturn(OPTIONHANDLER_ERROR);
+
+    // act
+    result = saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "underlying_io_options", underlying_io_options);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
 /* on_underlying_io_bytes_received */
 
 /* Tests_SRS_SASLCLIENTIO_01_027: [When the `on_underlying_io_bytes_received` callback passed to the underlying IO is called and the SASL client IO state is `IO_STATE_OPEN`, the bytes shall be indicated to the user of SASL client IO by calling the `on_bytes_received` callback that was passed in `saslclientio_open`.]*/
@@ -4256,4 +4378,399 @@ TEST_FUNCTION(when_the_sasl_frame_codec_triggers_an_error_in_the_ERROR_state_not
     saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
 }
 
+/* optimistic SASL init */
+
+/* Tests_SRS_SASLCLIENTIO_01_145: [ - sasl_optimistic_init - bool. ]*/
+TEST_FUNCTION(saslclientio_setoption_with_sasl_optimistic_init_succeeds)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    int result;
+    bool optimistic_init = true;
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_151: [ - sasl_optimistic_init - bool. ]*/
+/* Tests_SRS_SASLCLIENTIO_01_137: [ The options shall be added by calling `OptionHandler_AddOption`. ]*/
+TEST_FUNCTION(when_sasl_optimistic_init_was_set_saslclientio_retrieveoptions_adds_it_to_the_OptionHandler)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    OPTIONHANDLER_HANDLE result;
+    bool optimistic_init = true;
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(test_optionhandler_handle, "sasl_optimistic_init", &optimistic_init))
+        .ValidateArgumentValue_value_AsType(UMOCK_TYPE(bool*));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_underlying_io));
+
+    // act
+    result = saslclientio_get_interface_description()->concrete_io_retrieveoptions(sasl_client_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(result);
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_147: [ When the `sasl_optimistic_init` option is set to true, SASL client IO shall send the SASL init frame for the configured mechanism right after sending the SASL header, without waiting for the SASL header and the sasl-mechanisms frame from the server. ]*/
+TEST_FUNCTION(when_sasl_optimistic_init_is_set_the_sasl_init_is_sent_right_after_the_SASL_header)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    bool optimistic_init = true;
+    SASL_MECHANISM_BYTES init_bytes;
+
+    init_bytes.bytes = NULL;
+    init_bytes.length = 0;
+
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    (void)saslclientio_get_interface_description()->concrete_io_open(sasl_client_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(test_underlying_io, IGNORED_PTR_ARG, sizeof(sasl_header), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(saslmechanism_get_mechanism_name(test_sasl_mechanism));
+    STRICT_EXPECTED_CALL(sasl_init_create(test_mechanism));
+    STRICT_EXPECTED_CALL(saslmechanism_get_init_bytes(test_sasl_mechanism, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &init_bytes, sizeof(init_bytes));
+    STRICT_EXPECTED_CALL(amqpvalue_create_sasl_init(test_sasl_init));
+    STRICT_EXPECTED_CALL(sasl_frame_codec_encode_frame(test_sasl_frame_codec, test_sasl_init_value, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_sasl_init_value));
+    STRICT_EXPECTED_CALL(sasl_init_destroy(test_sasl_init));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_148: [ If getting the mechanism name or sending the SASL init fails, the `on_io_open_complete` callback shall be triggered with `IO_OPEN_ERROR`. ]*/
+TEST_FUNCTION(when_getting_the_mechanism_name_for_the_optimistic_sasl_init_fails_the_IO_is_closed_pending_open_complete_with_error)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    bool optimistic_init = true;
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    (void)saslclientio_get_interface_description()->concrete_io_open(sasl_client_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(test_underlying_io, IGNORED_PTR_ARG, sizeof(sasl_header), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(saslmechanism_get_mechanism_name(test_sasl_mechanism))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_close(test_underlying_io, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    saved_on_io_close_complete(saved_on_io_close_complete_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_148: [ If getting the mechanism name or sending the SASL init fails, the `on_io_open_complete` callback shall be triggered with `IO_OPEN_ERROR`. ]*/
+TEST_FUNCTION(when_encoding_the_optimistic_sasl_init_fails_the_IO_is_closed_pending_open_complete_with_error)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    bool optimistic_init = true;
+    SASL_MECHANISM_BYTES init_bytes;
+
+    init_bytes.bytes = NULL;
+    init_bytes.length = 0;
+
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    (void)saslclientio_get_interface_description()->concrete_io_open(sasl_client_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(test_underlying_io, IGNORED_PTR_ARG, sizeof(sasl_header), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(saslmechanism_get_mechanism_name(test_sasl_mechanism));
+    STRICT_EXPECTED_CALL(sasl_init_create(test_mechanism));
+    STRICT_EXPECTED_CALL(saslmechanism_get_init_bytes(test_sasl_mechanism, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &init_bytes, sizeof(init_bytes));
+    STRICT_EXPECTED_CALL(amqpvalue_create_sasl_init(test_sasl_init));
+    STRICT_EXPECTED_CALL(sasl_frame_codec_encode_frame(test_sasl_frame_codec, test_sasl_init_value, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_sasl_init_value));
+    STRICT_EXPECTED_CALL(sasl_init_destroy(test_sasl_init));
+    STRICT_EXPECTED_CALL(xio_close(test_underlying_io, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
+
+    // act
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    saved_on_io_close_complete(saved_on_io_close_complete_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_149: [ When the sasl-mechanisms frame is received after an optimistic SASL init was sent, SASL client IO shall check that the configured mechanism is in the list presented by the server and shall not send another SASL init. ]*/
+TEST_FUNCTION(when_the_SASL_mechanisms_are_received_after_an_optimistic_sasl_init_no_other_sasl_init_is_sent)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    bool optimistic_init = true;
+    uint32_t mechanisms_count = 1;
+    SASL_MECHANISM_BYTES init_bytes;
+
+    init_bytes.bytes = NULL;
+    init_bytes.length = 0;
+
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    (void)saslclientio_get_interface_description()->concrete_io_open(sasl_client_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(saslmechanism_get_init_bytes(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &init_bytes, sizeof(init_bytes));
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    saved_on_bytes_received(saved_on_bytes_received_context, sasl_header, sizeof(sasl_header));
+    saved_on_bytes_received(saved_on_bytes_received_context, test_sasl_mechanisms_frame, sizeof(test_sasl_mechanisms_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_sasl_value));
+    STRICT_EXPECTED_CALL(is_sasl_mechanisms_type_by_descriptor(test_descriptor_value))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(amqpvalue_get_sasl_mechanisms(test_sasl_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &test_sasl_mechanisms_handle, sizeof(test_sasl_mechanisms_handle));
+    STRICT_EXPECTED_CALL(sasl_mechanisms_get_sasl_server_mechanisms(test_sasl_mechanisms_handle, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_sasl_server_mechanisms_value(&test_sasl_server_mechanisms_value, sizeof(test_sasl_server_mechanisms_value));
+    STRICT_EXPECTED_CALL(amqpvalue_get_array_item_count(test_sasl_server_mechanisms_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_count(&mechanisms_count, sizeof(mechanisms_count));
+    STRICT_EXPECTED_CALL(saslmechanism_get_mechanism_name(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_get_array_item(test_sasl_server_mechanisms_value, 0))
+        .SetReturn(test_sasl_server_mechanism);
+    STRICT_EXPECTED_CALL(amqpvalue_get_symbol(test_sasl_server_mechanism, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &test_mechanism, sizeof(test_mechanism));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sasl_mechanisms_destroy(test_sasl_mechanisms_handle));
+
+    // act
+    saved_on_sasl_frame_received(saved_sasl_frame_codec_callback_context, test_sasl_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_149: [ When the sasl-mechanisms frame is received after an optimistic SASL init was sent, SASL client IO shall check that the configured mechanism is in the list presented by the server and shall not send another SASL init. ]*/
+TEST_FUNCTION(when_the_SASL_mechanisms_received_after_an_optimistic_sasl_init_do_not_contain_the_mechanism_the_IO_is_closed_pending_open_complete_with_error)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    bool optimistic_init = true;
+    uint32_t mechanisms_count = 1;
+    const char* other_mechanism = "other_mechanism";
+    SASL_MECHANISM_BYTES init_bytes;
+
+    init_bytes.bytes = NULL;
+    init_bytes.length = 0;
+
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    (void)saslclientio_get_interface_description()->concrete_io_open(sasl_client_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(saslmechanism_get_init_bytes(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &init_bytes, sizeof(init_bytes));
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    saved_on_bytes_received(saved_on_bytes_received_context, sasl_header, sizeof(sasl_header));
+    saved_on_bytes_received(saved_on_bytes_received_context, test_sasl_mechanisms_frame, sizeof(test_sasl_mechanisms_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_sasl_value));
+    STRICT_EXPECTED_CALL(is_sasl_mechanisms_type_by_descriptor(test_descriptor_value))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(amqpvalue_get_sasl_mechanisms(test_sasl_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &test_sasl_mechanisms_handle, sizeof(test_sasl_mechanisms_handle));
+    STRICT_EXPECTED_CALL(sasl_mechanisms_get_sasl_server_mechanisms(test_sasl_mechanisms_handle, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_sasl_server_mechanisms_value(&test_sasl_server_mechanisms_value, sizeof(test_sasl_server_mechanisms_value));
+    STRICT_EXPECTED_CALL(amqpvalue_get_array_item_count(test_sasl_server_mechanisms_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_count(&mechanisms_count, sizeof(mechanisms_count));
+    STRICT_EXPECTED_CALL(saslmechanism_get_mechanism_name(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_get_array_item(test_sasl_server_mechanisms_value, 0))
+        .SetReturn(test_sasl_server_mechanism);
+    STRICT_EXPECTED_CALL(amqpvalue_get_symbol(test_sasl_server_mechanism, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &other_mechanism, sizeof(other_mechanism));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(test_underlying_io, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sasl_mechanisms_destroy(test_sasl_mechanisms_handle));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
+
+    // act
+    saved_on_sasl_frame_received(saved_sasl_frame_codec_callback_context, test_sasl_value);
+    saved_on_io_close_complete(saved_on_io_close_complete_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_150: [ If a sasl-challenge or sasl-outcome frame is received after an optimistic SASL init was sent but before the sasl-mechanisms frame, the `on_io_open_complete` callback shall be triggered with `IO_OPEN_ERROR`. ]*/
+TEST_FUNCTION(when_a_SASL_outcome_is_received_after_an_optimistic_sasl_init_but_before_the_mechanisms_the_IO_is_closed_pending_open_complete_with_error)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    bool optimistic_init = true;
+    SASL_MECHANISM_BYTES init_bytes;
+
+    init_bytes.bytes = NULL;
+    init_bytes.length = 0;
+
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    (void)saslclientio_get_interface_description()->concrete_io_open(sasl_client_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(saslmechanism_get_init_bytes(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &init_bytes, sizeof(init_bytes));
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    saved_on_bytes_received(saved_on_bytes_received_context, sasl_header, sizeof(sasl_header));
+    saved_on_bytes_received(saved_on_bytes_received_context, test_sasl_outcome, sizeof(test_sasl_outcome));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_sasl_value));
+    STRICT_EXPECTED_CALL(is_sasl_mechanisms_type_by_descriptor(test_descriptor_value))
+        .SetReturn(false);
+    STRICT_EXPECTED_CALL(is_sasl_challenge_type_by_descriptor(test_descriptor_value))
+        .SetReturn(false);
+    STRICT_EXPECTED_CALL(is_sasl_outcome_type_by_descriptor(test_descriptor_value))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(xio_close(test_underlying_io, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
+
+    // act
+    saved_on_sasl_frame_received(saved_sasl_frame_codec_callback_context, test_sasl_value);
+    saved_on_io_close_complete(saved_on_io_close_complete_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
+/* Tests_SRS_SASLCLIENTIO_01_072: [When the SASL handshake is complete, if the handshake is successful, the SASL client IO state shall be switched to `IO_STATE_OPEN` and the `on_io_open_complete` callback shall be called with `IO_OPEN_OK`.]*/
+TEST_FUNCTION(when_a_SASL_outcome_ok_is_received_after_the_mechanisms_for_an_optimistic_sasl_init_open_complete_is_indicated)
+{
+    // arrange
+    SASLCLIENTIO_CONFIG sasl_client_io_config;
+    CONCRETE_IO_HANDLE sasl_client_io;
+    bool optimistic_init = true;
+    uint32_t mechanisms_count = 1;
+    sasl_code sasl_outcome_code = sasl_code_ok;
+    SASL_MECHANISM_BYTES init_bytes;
+
+    init_bytes.bytes = NULL;
+    init_bytes.length = 0;
+
+    sasl_client_io_config.underlying_io = test_underlying_io;
+    sasl_client_io_config.sasl_mechanism = test_sasl_mechanism;
+    sasl_client_io = saslclientio_get_interface_description()->concrete_io_create(&sasl_client_io_config);
+    (void)saslclientio_get_interface_description()->concrete_io_setoption(sasl_client_io, "sasl_optimistic_init", &optimistic_init);
+    (void)saslclientio_get_interface_description()->concrete_io_open(sasl_client_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(saslmechanism_get_init_bytes(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &init_bytes, sizeof(init_bytes));
+    saved_on_io_open_complete(saved_on_io_open_complete_context, IO_OPEN_OK);
+    saved_on_bytes_received(saved_on_bytes_received_context, sasl_header, sizeof(sasl_header));
+    saved_on_bytes_received(saved_on_bytes_received_context, test_sasl_mechanisms_frame, sizeof(test_sasl_mechanisms_frame));
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_sasl_value));
+    STRICT_EXPECTED_CALL(is_sasl_mechanisms_type_by_descriptor(test_descriptor_value))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(amqpvalue_get_sasl_mechanisms(test_sasl_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &test_sasl_mechanisms_handle, sizeof(test_sasl_mechanisms_handle));
+    STRICT_EXPECTED_CALL(sasl_mechanisms_get_sasl_server_mechanisms(test_sasl_mechanisms_handle, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_sasl_server_mechanisms_value(&test_sasl_server_mechanisms_value, sizeof(test_sasl_server_mechanisms_value));
+    STRICT_EXPECTED_CALL(amqpvalue_get_array_item_count(test_sasl_server_mechanisms_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_count(&mechanisms_count, sizeof(mechanisms_count));
+    STRICT_EXPECTED_CALL(saslmechanism_get_mechanism_name(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_get_array_item(test_sasl_server_mechanisms_value, 0))
+        .SetReturn(test_sasl_server_mechanism);
+    STRICT_EXPECTED_CALL(amqpvalue_get_symbol(test_sasl_server_mechanism, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &test_mechanism, sizeof(test_mechanism));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    saved_on_sasl_frame_received(saved_sasl_frame_codec_callback_context, test_sasl_value);
+    saved_on_bytes_received(saved_on_bytes_received_context, test_sasl_outcome, sizeof(test_sasl_outcome));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_sasl_value));
+    STRICT_EXPECTED_CALL(is_sasl_mechanisms_type_by_descriptor(test_descriptor_value))
+        .SetReturn(false);
+    STRICT_EXPECTED_CALL(is_sasl_challenge_type_by_descriptor(test_descriptor_value))
+        .SetReturn(false);
+    STRICT_EXPECTED_CALL(is_sasl_outcome_type_by_descriptor(test_descriptor_value))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(amqpvalue_get_sasl_outcome(test_sasl_value, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &test_sasl_outcome_handle, sizeof(test_sasl_outcome_handle));
+    STRICT_EXPECTED_CALL(sasl_outcome_get_code(test_sasl_outcome_handle, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &sasl_outcome_code, sizeof(sasl_outcome_code));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
+    STRICT_EXPECTED_CALL(sasl_outcome_destroy(test_sasl_outcome_handle));
+
+    // act
+    saved_on_sasl_frame_received(saved_sasl_frame_codec_callback_context, test_sasl_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    saslclientio_get_interface_description()->concrete_io_destroy(sasl_client_io);
+}
+
 END_TEST_SUITE(saslclientio_ut)
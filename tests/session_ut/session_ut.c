@@ -31,7 +31,9 @@ static void my_gballoc_free(void* ptr)
 
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/amqp_performative_fields.h"
 #include "azure_uamqp_c/connection.h"
 
 #undef ENABLE_MOCKS
@@ -42,11 +44,14 @@ static void my_gballoc_free(void* ptr)
 #define TEST_DESCRIBED_AMQP_VALUE        (AMQP_VALUE)0x4247
 #define TEST_LIST_ITEM_AMQP_VALUE        (AMQP_VALUE)0x4246
 #define TEST_DESCRIPTOR_AMQP_VALUE        (AMQP_VALUE)0x4245
+#define TEST_DELIVERY_STATE_AMQP_VALUE    (AMQP_VALUE)0x4250
 #define TEST_CONNECTION_HANDLE            (CONNECTION_HANDLE)0x4248
 #define TEST_DELIVERY_QUEUE_HANDLE        (DELIVERY_QUEUE_HANDLE)0x4249
 #define TEST_CONTEXT                    (void*)0x4444
+#define TEST_ADMISSION_LIMITER_HANDLE    (ADMISSION_LIMITER_HANDLE)0x4251
 #define TEST_ATTACH_PERFORMATIVE        (AMQP_VALUE)0x5000
 #define TEST_BEGIN_PERFORMATIVE            (AMQP_VALUE)0x5001
+#define TEST_TICK_COUNTER_HANDLE        (TICK_COUNTER_HANDLE)0x5002
 
 static TRANSFER_HANDLE test_transfer_handle = (TRANSFER_HANDLE)0x6001;
 static ON_ENDPOINT_FRAME_RECEIVED saved_frame_received_callback;
@@ -56,7 +61,7 @@ static uint32_t some_remote_max_frame_size = 512;
 
 static uint64_t performative_ulong;
 
-MOCK_FUNCTION_WITH_CODE(, void, test_frame_received_callback, void*, context, AMQP_VALUE, performative, uint32_t, frame_payload_size, const unsigned char*, payload_bytes)
+MOCK_FUNCTION_WITH_CODE(, void, test_frame_received_callback, void*, context, AMQP_VALUE, performative, uint64_t, performative_code, uint32_t, frame_payload_size, const unsigned char*, payload_bytes)
 MOCK_FUNCTION_END();
 MOCK_FUNCTION_WITH_CODE(, void, test_on_session_state_changed, void*, context, SESSION_STATE, new_session_state, SESSION_STATE, previous_session_state)
 MOCK_FUNCTION_END();
@@ -81,6 +86,17 @@ static int my_connection_start_endpoint(ENDPOINT_HANDLE endpoint, ON_ENDPOINT_FR
     return 0;
 }
 
+static ON_ENDPOINT_DOWORK saved_on_dowork;
+static void* saved_on_dowork_context;
+
+static int my_connection_endpoint_set_on_dowork(ENDPOINT_HANDLE endpoint, ON_ENDPOINT_DOWORK on_dowork, void* context)
+{
+    (void)endpoint;
+    saved_on_dowork = on_dowork;
+    saved_on_dowork_context = context;
+    return 0;
+}
+
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -123,12 +139,21 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_RETURN(connection_create_endpoint, TEST_ENDPOINT_HANDLE);
     REGISTER_GLOBAL_MOCK_RETURN(connection_endpoint_get_incoming_channel, 0);
     REGISTER_GLOBAL_MOCK_RETURN(connection_encode_frame, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(connection_encode_frame_with_encoded_performative, 0);
     REGISTER_GLOBAL_MOCK_RETURN(connection_get_remote_max_frame_size, 0);
     REGISTER_GLOBAL_MOCK_HOOK(connection_start_endpoint, my_connection_start_endpoint);
+    REGISTER_GLOBAL_MOCK_HOOK(connection_endpoint_set_on_dowork, my_connection_endpoint_set_on_dowork);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_get_current_ms, 0);
 
     REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(CONNECTION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONNECTION_FLOW_EVENT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(CONNECTION_CALLBACK_TYPE, int);
     REGISTER_UMOCK_ALIAS_TYPE(ENDPOINT_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ADMISSION_LIMITER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_ENDPOINT_DOWORK, void*);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -147,6 +172,7 @@ TEST_FUNCTION_INITIALIZE(method_init)
     }
 
     umock_c_reset_all_calls();
+    saved_on_dowork = NULL;
 }
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -286,6 +312,7 @@ TEST_FUNCTION(session_destroy_with_NULL_session_does_nothing)
 
 /* Tests_SRS_SESSION_01_043: [session_create_link_endpoint shall create a link endpoint associated with a given session and return a non-NULL handle to it.] */
 /* Tests_SRS_SESSION_01_046: [An unused handle shall be assigned to the link endpoint.] */
+/* Tests_SRS_SESSION_01_121: [The name of the link endpoint shall be copied in the same allocation as the link endpoint.] */
 TEST_FUNCTION(session_create_link_endpoint_creates_a_link_endpoint)
 {
     // arrange
@@ -293,7 +320,6 @@ TEST_FUNCTION(session_create_link_endpoint_creates_a_link_endpoint)
     SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
@@ -309,6 +335,31 @@ TEST_FUNCTION(session_create_link_endpoint_creates_a_link_endpoint)
     session_destroy(session);
 }
 
+/* Tests_SRS_SESSION_01_043: [session_create_link_endpoint shall create a link endpoint associated with a given session and return a non-NULL handle to it.] */
+TEST_FUNCTION(session_create_link_endpoint_for_a_second_link_endpoint_does_not_reallocate)
+{
+    // arrange
+    LINK_ENDPOINT_HANDLE link_endpoint1;
+    LINK_ENDPOINT_HANDLE link_endpoint2;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    link_endpoint1 = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    link_endpoint2 = session_create_link_endpoint(session, "2");
+
+    // assert
+    ASSERT_IS_NOT_NULL(link_endpoint2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint1);
+    session_destroy_link_endpoint(link_endpoint2);
+    session_destroy(session);
+}
+
 /* Tests_SRS_SESSION_01_044: [If session, name or frame_received_callback is NULL, session_create_link_endpoint shall fail and return NULL.] */
 TEST_FUNCTION(session_create_with_NULL_session_fails)
 {
@@ -363,27 +414,29 @@ TEST_FUNCTION(when_allocating_memory_for_the_link_endpoint_fails_then_session_cr
     session_destroy(session);
 }
 
-/* Tests_SRS_SESSION_01_045: [If allocating memory for the link endpoint fails, session_create_link_endpoint shall fail and return NULL.] */
-TEST_FUNCTION(when_allocating_the_link_name_fails_then_session_create_link_endpoint_fails)
+/* Tests_SRS_SESSION_01_121: [The name of the link endpoint shall be copied in the same allocation as the link endpoint.] */
+TEST_FUNCTION(session_create_link_endpoint_copies_the_link_name)
 {
     // arrange
     LINK_ENDPOINT_HANDLE link_endpoint;
+    const char* name;
+    char link_name[] = "link_name";
+    int result;
     SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    link_endpoint = session_create_link_endpoint(session, link_name);
+    link_name[0] = 'x';
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
     // act
-    link_endpoint = session_create_link_endpoint(session, "1");
+    result = session_get_link_endpoint_name(link_endpoint, &name);
 
     // assert
-    ASSERT_IS_NULL(link_endpoint);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "link_name", name);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
+    session_destroy_link_endpoint(link_endpoint);
     session_destroy(session);
 }
 
@@ -395,12 +448,10 @@ TEST_FUNCTION(when_reallocating_the_endpoint_array_for_the_link_endpoint_fails_t
     SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     link_endpoint = session_create_link_endpoint(session, "1");
@@ -435,7 +486,6 @@ TEST_FUNCTION(session_destroy_link_endpoint_frees_the_resources)
     LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -458,8 +508,6 @@ TEST_FUNCTION(session_destroy_link_endpoint_when_2_endpoints_are_there_frees_the
     LINK_ENDPOINT_HANDLE link_endpoint2 = session_create_link_endpoint(session, "1");
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
@@ -488,9 +536,7 @@ TEST_FUNCTION(session_transfer_sends_the_frame_to_the_connection)
     SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE);
     LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
     saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_BEGIN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(definition_mocks, is_begin_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, 0, NULL);
+    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, AMQP_BEGIN, 0, NULL);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0));
@@ -548,26 +594,66 @@ TEST_FUNCTION(session_transfer_with_NULL_link_endpoint_fails)
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-#if 0
-/* Tests_SRS_SESSION_01_058: [When any other error occurs, session_send_transfer shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_transfer_set_delivery_id_fails_then_session_transfer_fails)
+/* session_set_link_scheduler */
+
+/* Tests_SRS_SESSION_01_092: [If session is NULL or link_scheduler is not a known scheduler, session_set_link_scheduler shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_link_scheduler_with_NULL_session_fails)
+{
+    // arrange
+
+    // act
+    int result = session_set_link_scheduler(NULL, SESSION_LINK_SCHEDULER_WEIGHTED);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_093: [On success, session_set_link_scheduler shall return 0.] */
+TEST_FUNCTION(session_set_link_scheduler_succeeds)
 {
     // arrange
     int result;
-    delivery_number delivery_id;
-    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE);
-    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
-    saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_BEGIN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(definition_mocks, is_begin_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, 0, NULL);
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0))
-        .SetReturn(1);
+    // act
+    result = session_set_link_scheduler(session, SESSION_LINK_SCHEDULER_WEIGHTED);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_set_link_endpoint_weight */
+
+/* Tests_SRS_SESSION_01_094: [If link_endpoint is NULL or weight is 0, session_set_link_endpoint_weight shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_link_endpoint_weight_with_NULL_link_endpoint_fails)
+{
+    // arrange
 
     // act
-    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+    int result = session_set_link_endpoint_weight(NULL, 4);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_094: [If link_endpoint is NULL or weight is 0, session_set_link_endpoint_weight shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_link_endpoint_weight_with_0_weight_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_set_link_endpoint_weight(link_endpoint, 0);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -578,28 +664,54 @@ TEST_FUNCTION(when_transfer_set_delivery_id_fails_then_session_transfer_fails)
     session_destroy(session);
 }
 
-/* Tests_SRS_SESSION_01_058: [When any other error occurs, session_send_transfer shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_amqpvalue_create_transfer_fails_then_session_transfer_fails)
+/* Tests_SRS_SESSION_01_095: [On success, session_set_link_endpoint_weight shall return 0.] */
+TEST_FUNCTION(session_set_link_endpoint_weight_succeeds)
 {
     // arrange
     int result;
-    delivery_number delivery_id;
-    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE);
-    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
-    saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_BEGIN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(definition_mocks, is_begin_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, 0, NULL);
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0));
-    STRICT_EXPECTED_CALL(connection_get_remote_max_frame_size(TEST_CONNECTION_HANDLE, IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(2, &some_remote_max_frame_size, sizeof(some_remote_max_frame_size));
-    STRICT_EXPECTED_CALL(definition_mocks, amqpvalue_create_transfer(test_transfer_handle))
-        .SetReturn(NULL);
+    // act
+    result = session_set_link_endpoint_weight(link_endpoint, 4);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_get_link_endpoint_name */
+
+/* Tests_SRS_SESSION_01_123: [If link_endpoint or name is NULL, session_get_link_endpoint_name shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_link_endpoint_name_with_NULL_link_endpoint_fails)
+{
+    // arrange
+    const char* name;
 
     // act
-    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+    int result = session_get_link_endpoint_name(NULL, &name);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_123: [If link_endpoint or name is NULL, session_get_link_endpoint_name shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_link_endpoint_name_with_NULL_name_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_link_endpoint_name(link_endpoint, NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -610,64 +722,1397 @@ TEST_FUNCTION(when_amqpvalue_create_transfer_fails_then_session_transfer_fails)
     session_destroy(session);
 }
 
-/* Tests_SRS_SESSION_01_056: [If connection_encode_frame fails then session_send_transfer shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_connection_encode_frame_fails_then_session_transfer_fails)
+/* Tests_SRS_SESSION_01_124: [On success, session_get_link_endpoint_name shall return in name the name of the link endpoint, valid until the link endpoint is destroyed, and return 0.] */
+TEST_FUNCTION(session_get_link_endpoint_name_returns_the_name)
 {
     // arrange
     int result;
-    delivery_number delivery_id;
-    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE);
-    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
-    saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_BEGIN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(definition_mocks, is_begin_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, 0, NULL);
+    const char* name;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "test_link");
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0));
-    STRICT_EXPECTED_CALL(connection_get_remote_max_frame_size(TEST_CONNECTION_HANDLE, IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(2, &some_remote_max_frame_size, sizeof(some_remote_max_frame_size));
-    STRICT_EXPECTED_CALL(definition_mocks, amqpvalue_create_transfer(test_transfer_handle));
-    STRICT_EXPECTED_CALL(connection_encode_frame(TEST_ENDPOINT_HANDLE, test_transfer_amqp_value, NULL, 0, test_on_send_complete, (void*)0x4242))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_transfer_amqp_value));
+    // act
+    result = session_get_link_endpoint_name(link_endpoint, &name);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "test_link", name);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_set_window_policy */
+
+/* Tests_SRS_SESSION_01_085: [If session is NULL, window_policy is not a known policy or max_window is 0, session_set_window_policy shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_window_policy_with_NULL_session_fails)
+{
+    // arrange
 
     // act
-    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+    int result = session_set_window_policy(NULL, SESSION_WINDOW_POLICY_ADAPTIVE, 10000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_085: [If session is NULL, window_policy is not a known policy or max_window is 0, session_set_window_policy shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_window_policy_with_0_max_window_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_set_window_policy(session, SESSION_WINDOW_POLICY_ADAPTIVE, 0);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    session_destroy_link_endpoint(link_endpoint);
     session_destroy(session);
 }
-#endif
 
-/* Tests_SRS_SESSION_01_059: [When session_send_transfer is called while the session is not in the MAPPED state, session_send_transfer shall fail and return a non-zero value.] */
-TEST_FUNCTION(when_session_is_not_MAPPED_the_transfer_fails)
+/* Tests_SRS_SESSION_01_086: [For SESSION_WINDOW_POLICY_ADAPTIVE, session_set_window_policy shall create a tick counter by calling tickcounter_create if the session does not have one yet.] */
+/* Tests_SRS_SESSION_01_088: [On success, session_set_window_policy shall return 0.] */
+/* Tests_SRS_SESSION_01_091: [For SESSION_WINDOW_POLICY_ADAPTIVE the incoming window shall start at 256 transfers or max_window if smaller.] */
+TEST_FUNCTION(session_set_window_policy_adaptive_creates_a_tick_counter)
 {
     // arrange
     int result;
-    delivery_number delivery_id;
+    uint32_t incoming_window;
     SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
-    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
     // act
-    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+    result = session_set_window_policy(session, SESSION_WINDOW_POLICY_ADAPTIVE, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)session_get_incoming_window(session, &incoming_window);
+    ASSERT_ARE_EQUAL(uint32_t, 100, incoming_window);
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_087: [If tickcounter_create fails, session_set_window_policy shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_tickcounter_create_fails_then_session_set_window_policy_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+
+    // act
+    result = session_set_window_policy(session, SESSION_WINDOW_POLICY_ADAPTIVE, 10000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_088: [On success, session_set_window_policy shall return 0.] */
+TEST_FUNCTION(session_set_window_policy_fixed_does_not_create_a_tick_counter)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_set_window_policy(session, SESSION_WINDOW_POLICY_FIXED, 10000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_send_link_flow */
+
+/* Tests_SRS_SESSION_01_075: [If link_endpoint is NULL, session_send_link_flow shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_send_link_flow_with_NULL_link_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = session_send_link_flow(NULL, 0, 100);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_074: [session_send_link_flow shall send a flow frame carrying the session flow state, the handle of the link endpoint, delivery_count and link_credit.] */
+/* Tests_SRS_SESSION_01_076: [The flow performative shall be encoded directly to bytes, without creating a flow performative AMQP value.] */
+/* Tests_SRS_SESSION_01_078: [On success, session_send_link_flow shall return 0.] */
+TEST_FUNCTION(session_send_link_flow_sends_the_encoded_flow_to_the_connection)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, 0, NULL, NULL));
+
+    // act
+    result = session_send_link_flow(link_endpoint, 0, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     session_destroy_link_endpoint(link_endpoint);
     session_destroy(session);
 }
 
-/* on_connection_state_changed */
+/* Tests_SRS_SESSION_01_077: [If sending the frame fails, session_send_link_flow shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_sending_the_encoded_flow_fails_then_session_send_link_flow_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, 0, NULL, NULL))
+        .SetReturn(1);
+
+    // act
+    result = session_send_link_flow(link_endpoint, 0, 100);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_send_encoded_attach */
+
+/* Tests_SRS_SESSION_01_149: [If link_endpoint or encoded_fields is NULL, or encoded_fields_size or field_count is 0, session_send_encoded_attach shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_send_encoded_attach_with_NULL_link_endpoint_fails)
+{
+    // arrange
+    static const unsigned char encoded_fields[] = { 0x41 };
+
+    // act
+    int result = session_send_encoded_attach(NULL, encoded_fields, sizeof(encoded_fields), 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_148: [session_send_encoded_attach shall send an attach frame made of the name and output handle of the link endpoint followed by the field_count fields in encoded_fields, copied as they are, and return 0.] */
+TEST_FUNCTION(session_send_encoded_attach_sends_the_name_handle_and_fields_to_the_connection)
+{
+    // arrange
+    static const unsigned char encoded_fields[] = { 0x41 };
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    /* descriptor (3), list32 header (9), str8 name (3), uint handle (5) and the field */
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, 21, NULL, 0, NULL, NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = session_send_encoded_attach(link_endpoint, encoded_fields, sizeof(encoded_fields), 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_150: [If allocating the attach or sending the frame fails, session_send_encoded_attach shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_sending_the_encoded_attach_fails_then_session_send_encoded_attach_fails)
+{
+    // arrange
+    static const unsigned char encoded_fields[] = { 0x41 };
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, 21, NULL, 0, NULL, NULL))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = session_send_encoded_attach(link_endpoint, encoded_fields, sizeof(encoded_fields), 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_send_link_drain_flow */
+
+/* Tests_SRS_SESSION_01_126: [If link_endpoint is NULL, session_send_link_drain_flow shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_send_link_drain_flow_with_NULL_link_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = session_send_link_drain_flow(NULL, 0, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_125: [session_send_link_drain_flow shall send a flow frame like session_send_link_flow, with the drain field set to true.] */
+/* Tests_SRS_SESSION_01_128: [On success, session_send_link_drain_flow shall return 0.] */
+TEST_FUNCTION(session_send_link_drain_flow_sends_the_encoded_flow_to_the_connection)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, 0, NULL, NULL));
+
+    // act
+    result = session_send_link_drain_flow(link_endpoint, 0, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_127: [If sending the frame fails, session_send_link_drain_flow shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_sending_the_encoded_flow_fails_then_session_send_link_drain_flow_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, 0, NULL, NULL))
+        .SetReturn(1);
+
+    // act
+    result = session_send_link_drain_flow(link_endpoint, 0, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_send_delivery_disposition */
+
+/* Tests_SRS_SESSION_01_080: [If link_endpoint is NULL, session_send_delivery_disposition shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_send_delivery_disposition_with_NULL_link_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = session_send_delivery_disposition(NULL, role_receiver, 0, 0, true, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_079: [session_send_delivery_disposition shall send a disposition frame with the role, first, last, settled and delivery_state values given as arguments.] */
+/* Tests_SRS_SESSION_01_081: [The disposition performative shall be encoded directly to bytes, without creating a disposition performative AMQP value.] */
+/* Tests_SRS_SESSION_01_084: [On success, session_send_delivery_disposition shall return 0.] */
+TEST_FUNCTION(session_send_delivery_disposition_without_a_state_sends_the_encoded_disposition_to_the_connection)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, 0, NULL, NULL));
+
+    // act
+    result = session_send_delivery_disposition(link_endpoint, role_receiver, 1, 1, true, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_119: [An accepted or released delivery_state without fields shall be written as its encoded bytes without encoding the AMQP value.] */
+TEST_FUNCTION(session_send_delivery_disposition_with_an_accepted_state_writes_the_state_bytes_without_encoding_it)
+{
+    // arrange
+    int result;
+    uint32_t item_count = 0;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    performative_ulong = 0x24;
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_DELIVERY_STATE_AMQP_VALUE));
+    STRICT_EXPECTED_CALL(is_accepted_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(amqpvalue_get_ulong(TEST_DESCRIPTOR_AMQP_VALUE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_described_value(TEST_DELIVERY_STATE_AMQP_VALUE));
+    STRICT_EXPECTED_CALL(amqpvalue_get_list_item_count(TEST_DESCRIBED_AMQP_VALUE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_count(&item_count, sizeof(item_count));
+    STRICT_EXPECTED_CALL(connection_encode_frame_with_encoded_performative(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, 0, NULL, NULL));
+
+    // act
+    result = session_send_delivery_disposition(link_endpoint, role_receiver, 1, 1, true, TEST_DELIVERY_STATE_AMQP_VALUE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_get_connection */
+
+/* Tests_SRS_SESSION_01_135: [If session or connection is NULL, session_get_connection shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_connection_with_NULL_session_fails)
+{
+    // arrange
+    CONNECTION_HANDLE connection;
+
+    // act
+    int result = session_get_connection(NULL, &connection);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_135: [If session or connection is NULL, session_get_connection shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_connection_with_NULL_connection_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_connection(session, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_134: [session_get_connection shall return in connection the connection the session was created on and return 0.] */
+TEST_FUNCTION(session_get_connection_returns_the_connection_of_the_session)
+{
+    // arrange
+    int result;
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_connection(session, &connection);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONNECTION_HANDLE, connection);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_set_link_admission_limiter */
+
+/* Tests_SRS_SESSION_01_130: [If session is NULL, session_set_link_admission_limiter shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_link_admission_limiter_with_NULL_session_fails)
+{
+    // arrange
+
+    // act
+    int result = session_set_link_admission_limiter(NULL, TEST_ADMISSION_LIMITER_HANDLE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_129: [session_set_link_admission_limiter shall make the session check the new link attaches it receives against link_admission_limiter, a NULL link_admission_limiter admitting all of them, and return 0.] */
+TEST_FUNCTION(session_set_link_admission_limiter_succeeds)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_set_link_admission_limiter(session, TEST_ADMISSION_LIMITER_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_set_deferred_link_flows */
+
+/* Tests_SRS_SESSION_01_136: [If session is NULL, session_set_deferred_link_flows shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_deferred_link_flows_with_NULL_session_fails)
+{
+    // arrange
+
+    // act
+    int result = session_set_deferred_link_flows(NULL, true);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_137: [When deferred_link_flows is true, session_set_deferred_link_flows shall register a callback with connection_endpoint_set_on_dowork that sends the pending link flows, and return 0.] */
+TEST_FUNCTION(session_set_deferred_link_flows_registers_a_dowork_callback)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_endpoint_set_on_dowork(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, session))
+        .IgnoreArgument_on_dowork();
+
+    // act
+    result = session_set_deferred_link_flows(session, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(saved_on_dowork);
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_138: [If connection_endpoint_set_on_dowork fails, session_set_deferred_link_flows shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_setting_the_dowork_callback_fails_then_session_set_deferred_link_flows_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_endpoint_set_on_dowork(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, session))
+        .IgnoreArgument_on_dowork()
+        .SetReturn(1);
+
+    // act
+    result = session_set_deferred_link_flows(session, true);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_139: [While the session defers link flows, session_send_link_flow shall only record delivery_count and link_credit on the link endpoint, replacing the ones of a flow still pending for it, and return 0.] */
+TEST_FUNCTION(session_send_link_flow_on_a_deferring_session_sends_nothing)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    (void)session_set_deferred_link_flows(session, true);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_send_link_flow(link_endpoint, 0, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_141: [Pending link flows shall only be sent while the session is mapped or its BEGIN is pipelined, otherwise they shall be dropped.] */
+TEST_FUNCTION(the_pending_flows_of_an_unmapped_session_are_dropped_on_dowork)
+{
+    // arrange
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    (void)session_set_deferred_link_flows(session, true);
+    (void)session_send_link_flow(link_endpoint, 0, 100);
+    umock_c_reset_all_calls();
+
+    // act
+    saved_on_dowork(saved_on_dowork_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_143: [The flow pending for a link endpoint shall be dropped when a detach is sent for it or it is destroyed.] */
+TEST_FUNCTION(destroying_a_link_endpoint_with_a_pending_flow_removes_the_flow)
+{
+    // arrange
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint_1 = session_create_link_endpoint(session, "1");
+    LINK_ENDPOINT_HANDLE link_endpoint_2 = session_create_link_endpoint(session, "2");
+    (void)session_set_deferred_link_flows(session, true);
+    (void)session_send_link_flow(link_endpoint_1, 0, 100);
+    (void)session_send_link_flow(link_endpoint_2, 0, 100);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(link_endpoint_1));
+
+    // act
+    session_destroy_link_endpoint(link_endpoint_1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    saved_on_dowork(saved_on_dowork_context);
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint_2);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_144: [When deferred_link_flows is false, session_set_deferred_link_flows shall send the pending link flows right away, remove the callback with connection_endpoint_set_on_dowork and return 0.] */
+TEST_FUNCTION(session_set_deferred_link_flows_false_removes_the_dowork_callback)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    (void)session_set_deferred_link_flows(session, true);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_endpoint_set_on_dowork(TEST_ENDPOINT_HANDLE, NULL, NULL));
+
+    // act
+    result = session_set_deferred_link_flows(session, false);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_set_link_endpoint_on_dowork */
+
+static size_t test_on_link_endpoint_dowork_call_count;
+static void* test_on_link_endpoint_dowork_context;
+
+static void test_on_link_endpoint_dowork(void* context)
+{
+    test_on_link_endpoint_dowork_call_count++;
+    test_on_link_endpoint_dowork_context = context;
+}
+
+/* Tests_SRS_SESSION_01_168: [If link_endpoint is NULL, session_set_link_endpoint_on_dowork shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_set_link_endpoint_on_dowork_with_NULL_link_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = session_set_link_endpoint_on_dowork(NULL, test_on_link_endpoint_dowork, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_169: [session_set_link_endpoint_on_dowork shall set the callback called with context on every connection_dowork, a NULL callback removing it, registering the dowork callback of the session with connection_endpoint_set_on_dowork while any link endpoint has one, and return 0.] */
+/* Tests_SRS_SESSION_01_170: [On every connection_dowork, the session shall call the on_dowork callback of each link endpoint that has one.] */
+TEST_FUNCTION(session_set_link_endpoint_on_dowork_registers_a_dowork_callback_calling_the_link_endpoint)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+    test_on_link_endpoint_dowork_call_count = 0;
+
+    STRICT_EXPECTED_CALL(connection_endpoint_set_on_dowork(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, session))
+        .IgnoreArgument_on_dowork();
+
+    // act
+    result = session_set_link_endpoint_on_dowork(link_endpoint, test_on_link_endpoint_dowork, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    saved_on_dowork(saved_on_dowork_context);
+    ASSERT_ARE_EQUAL(size_t, 1, test_on_link_endpoint_dowork_call_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4242, test_on_link_endpoint_dowork_context);
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_169: [session_set_link_endpoint_on_dowork shall set the callback called with context on every connection_dowork, a NULL callback removing it, registering the dowork callback of the session with connection_endpoint_set_on_dowork while any link endpoint has one, and return 0.] */
+TEST_FUNCTION(session_set_link_endpoint_on_dowork_with_NULL_removes_the_dowork_callback)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    (void)session_set_link_endpoint_on_dowork(link_endpoint, test_on_link_endpoint_dowork, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_endpoint_set_on_dowork(TEST_ENDPOINT_HANDLE, NULL, NULL));
+
+    // act
+    result = session_set_link_endpoint_on_dowork(link_endpoint, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_171: [If connection_endpoint_set_on_dowork fails, session_set_link_endpoint_on_dowork shall fail, keep the previous callback and return a non-zero value.] */
+TEST_FUNCTION(when_setting_the_dowork_callback_fails_then_session_set_link_endpoint_on_dowork_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(connection_endpoint_set_on_dowork(TEST_ENDPOINT_HANDLE, IGNORED_PTR_ARG, session))
+        .IgnoreArgument_on_dowork()
+        .SetReturn(1);
+
+    // act
+    result = session_set_link_endpoint_on_dowork(link_endpoint, test_on_link_endpoint_dowork, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_get_stats */
+
+/* Tests_SRS_SESSION_01_099: [If session or stats is NULL, session_get_stats shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_stats_with_NULL_session_fails)
+{
+    // arrange
+    SESSION_STATS stats;
+
+    // act
+    int result = session_get_stats(NULL, &stats);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_099: [If session or stats is NULL, session_get_stats shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_stats_with_NULL_stats_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_stats(session, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_100: [session_get_stats shall copy the session statistics counted since the session was created into stats and return 0.] */
+TEST_FUNCTION(session_get_stats_for_a_new_session_returns_zero_counters)
+{
+    // arrange
+    int result;
+    SESSION_STATS stats;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+    (void)memset(&stats, 0xFF, sizeof(stats));
+
+    // act
+    result = session_get_stats(session, &stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.transfers_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.flows_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.dispositions_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.window_stalls);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_100: [session_get_stats shall copy the session statistics counted since the session was created into stats and return 0.] */
+TEST_FUNCTION(session_get_stats_counts_the_sent_flows_and_dispositions)
+{
+    // arrange
+    int result;
+    SESSION_STATS stats;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    (void)session_send_link_flow(link_endpoint, 0, 100);
+    (void)session_send_delivery_disposition(link_endpoint, role_receiver, 1, 1, true, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_stats(session, &stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 1, stats.flows_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 1, stats.dispositions_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, stats.transfers_sent);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_get_pipelined_begin */
+
+/* Tests_SRS_SESSION_01_104: [If session or pipelined_begin is NULL, session_get_pipelined_begin shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_pipelined_begin_with_NULL_session_fails)
+{
+    // arrange
+    bool pipelined_begin;
+
+    // act
+    int result = session_get_pipelined_begin(NULL, &pipelined_begin);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_104: [If session or pipelined_begin is NULL, session_get_pipelined_begin shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_pipelined_begin_with_NULL_pipelined_begin_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_pipelined_begin(session, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_105: [session_get_pipelined_begin shall return in pipelined_begin whether the BEGIN frame was pipelined behind the OPEN frame of the connection, and return 0.] */
+TEST_FUNCTION(session_get_pipelined_begin_for_a_new_session_returns_false)
+{
+    // arrange
+    int result;
+    bool pipelined_begin = true;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_pipelined_begin(session, &pipelined_begin);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(pipelined_begin);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_send_templated_transfer */
+
+/* Tests_SRS_SESSION_01_065: [If link_endpoint or delivery_id is NULL, session_send_templated_transfer shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+TEST_FUNCTION(session_send_templated_transfer_with_NULL_link_endpoint_fails)
+{
+    // arrange
+    unsigned char delivery_tag_bytes[] = { 1, 0, 0, 0 };
+    delivery_tag test_delivery_tag = { delivery_tag_bytes, sizeof(delivery_tag_bytes) };
+    delivery_number delivery_id;
+
+    // act
+    SESSION_SEND_TRANSFER_RESULT result = session_send_templated_transfer(NULL, test_delivery_tag, 0, false, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)SESSION_SEND_TRANSFER_ERROR, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_065: [If link_endpoint or delivery_id is NULL, session_send_templated_transfer shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+TEST_FUNCTION(session_send_templated_transfer_with_NULL_delivery_id_fails)
+{
+    // arrange
+    unsigned char delivery_tag_bytes[] = { 1, 0, 0, 0 };
+    delivery_tag test_delivery_tag = { delivery_tag_bytes, sizeof(delivery_tag_bytes) };
+    SESSION_SEND_TRANSFER_RESULT result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_send_templated_transfer(link_endpoint, test_delivery_tag, 0, false, NULL, 0, NULL, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)SESSION_SEND_TRANSFER_ERROR, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_066: [When session_send_templated_transfer is called while the session is not in the MAPPED state, session_send_templated_transfer shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+TEST_FUNCTION(session_send_templated_transfer_when_the_session_is_not_mapped_fails)
+{
+    // arrange
+    unsigned char delivery_tag_bytes[] = { 1, 0, 0, 0 };
+    delivery_tag test_delivery_tag = { delivery_tag_bytes, sizeof(delivery_tag_bytes) };
+    delivery_number delivery_id;
+    SESSION_SEND_TRANSFER_RESULT result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_send_templated_transfer(link_endpoint, test_delivery_tag, 0, false, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)SESSION_SEND_TRANSFER_ERROR, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_send_transfer_part */
+
+/* Tests_SRS_SESSION_01_108: [If link_endpoint, transfer or delivery_id is NULL, or payloads is NULL while payload_count is not 0, session_send_transfer_part shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+TEST_FUNCTION(session_send_transfer_part_with_NULL_link_endpoint_fails)
+{
+    // arrange
+    delivery_number delivery_id;
+
+    // act
+    SESSION_SEND_TRANSFER_RESULT result = session_send_transfer_part(NULL, test_transfer_handle, true, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)SESSION_SEND_TRANSFER_ERROR, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_108: [If link_endpoint, transfer or delivery_id is NULL, or payloads is NULL while payload_count is not 0, session_send_transfer_part shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+TEST_FUNCTION(session_send_transfer_part_with_NULL_transfer_fails)
+{
+    // arrange
+    delivery_number delivery_id;
+    SESSION_SEND_TRANSFER_RESULT result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_send_transfer_part(link_endpoint, NULL, true, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)SESSION_SEND_TRANSFER_ERROR, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_108: [If link_endpoint, transfer or delivery_id is NULL, or payloads is NULL while payload_count is not 0, session_send_transfer_part shall fail and return SESSION_SEND_TRANSFER_ERROR.] */
+TEST_FUNCTION(session_send_transfer_part_with_NULL_payloads_and_non_zero_payload_count_fails)
+{
+    // arrange
+    delivery_number delivery_id;
+    SESSION_SEND_TRANSFER_RESULT result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_send_transfer_part(link_endpoint, test_transfer_handle, true, NULL, 1, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)SESSION_SEND_TRANSFER_ERROR, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+#if 0
+/* Tests_SRS_SESSION_01_058: [When any other error occurs, session_send_transfer shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_transfer_set_delivery_id_fails_then_session_transfer_fails)
+{
+    // arrange
+    int result;
+    delivery_number delivery_id;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
+    saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
+    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, AMQP_BEGIN, 0, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0))
+        .SetReturn(1);
+
+    // act
+    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_058: [When any other error occurs, session_send_transfer shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_amqpvalue_create_transfer_fails_then_session_transfer_fails)
+{
+    // arrange
+    int result;
+    delivery_number delivery_id;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
+    saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
+    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, AMQP_BEGIN, 0, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0));
+    STRICT_EXPECTED_CALL(connection_get_remote_max_frame_size(TEST_CONNECTION_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &some_remote_max_frame_size, sizeof(some_remote_max_frame_size));
+    STRICT_EXPECTED_CALL(definition_mocks, amqpvalue_create_transfer(test_transfer_handle))
+        .SetReturn(NULL);
+
+    // act
+    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_056: [If connection_encode_frame fails then session_send_transfer shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_connection_encode_frame_fails_then_session_transfer_fails)
+{
+    // arrange
+    int result;
+    delivery_number delivery_id;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
+    saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
+    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, AMQP_BEGIN, 0, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0));
+    STRICT_EXPECTED_CALL(connection_get_remote_max_frame_size(TEST_CONNECTION_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer(2, &some_remote_max_frame_size, sizeof(some_remote_max_frame_size));
+    STRICT_EXPECTED_CALL(definition_mocks, amqpvalue_create_transfer(test_transfer_handle));
+    STRICT_EXPECTED_CALL(connection_encode_frame(TEST_ENDPOINT_HANDLE, test_transfer_amqp_value, NULL, 0, test_on_send_complete, (void*)0x4242))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_transfer_amqp_value));
+
+    // act
+    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+#endif
+
+/* Tests_SRS_SESSION_01_059: [When session_send_transfer is called while the session is not in the MAPPED state, session_send_transfer shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_session_is_not_MAPPED_the_transfer_fails)
+{
+    // arrange
+    int result;
+    delivery_number delivery_id;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_send_transfer(link_endpoint, test_transfer_handle, NULL, 0, &delivery_id, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* on_connection_state_changed */
+
+/* session_save_handover_state */
+
+/* Tests_SRS_SESSION_01_151: [If session, buffer or length is NULL, session_save_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_save_handover_state_with_NULL_session_fails)
+{
+    // arrange
+    unsigned char buffer[64];
+    size_t length;
+
+    // act
+    int result = session_save_handover_state(NULL, buffer, sizeof(buffer), &length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_152: [If the session is not MAPPED, session_save_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_save_handover_state_when_the_session_is_not_mapped_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[64];
+    size_t length;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_save_handover_state(session, buffer, sizeof(buffer), &length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_restore_handover_state */
+
+/* Tests_SRS_SESSION_01_156: [If session or bytes is NULL, session_restore_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_restore_handover_state_with_NULL_session_fails)
+{
+    // arrange
+    unsigned char bytes[1] = { 0 };
+
+    // act
+    int result = session_restore_handover_state(NULL, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_156: [If session or bytes is NULL, session_restore_handover_state shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_restore_handover_state_with_NULL_bytes_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_restore_handover_state(session, NULL, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy(session);
+}
+
+/* session_get_link_endpoint_handles */
+
+/* Tests_SRS_SESSION_01_161: [If link_endpoint, output_handle or input_handle is NULL, session_get_link_endpoint_handles shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_link_endpoint_handles_with_NULL_link_endpoint_fails)
+{
+    // arrange
+    handle output_handle;
+    handle input_handle;
+
+    // act
+    int result = session_get_link_endpoint_handles(NULL, &output_handle, &input_handle);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_162: [session_get_link_endpoint_handles shall return in output_handle and input_handle the handles of the link endpoint and return 0.] */
+TEST_FUNCTION(session_get_link_endpoint_handles_returns_the_output_handle)
+{
+    // arrange
+    int result;
+    handle output_handle;
+    handle input_handle;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint0 = session_create_link_endpoint(session, "1");
+    LINK_ENDPOINT_HANDLE link_endpoint1 = session_create_link_endpoint(session, "2");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_link_endpoint_handles(link_endpoint1, &output_handle, &input_handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 1, output_handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint0);
+    session_destroy_link_endpoint(link_endpoint1);
+    session_destroy(session);
+}
+
+/* session_get_next_delivery_id */
+
+/* Tests_SRS_SESSION_01_166: [If link_endpoint or delivery_id is NULL, session_get_next_delivery_id shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_next_delivery_id_with_NULL_link_endpoint_fails)
+{
+    // arrange
+    delivery_number delivery_id;
+
+    // act
+    int result = session_get_next_delivery_id(NULL, &delivery_id);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_166: [If link_endpoint or delivery_id is NULL, session_get_next_delivery_id shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_get_next_delivery_id_with_NULL_delivery_id_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_next_delivery_id(link_endpoint, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_167: [session_get_next_delivery_id shall return in delivery_id the delivery id that the next transfer starting a delivery on the session will be given and return 0.] */
+TEST_FUNCTION(session_get_next_delivery_id_returns_the_next_outgoing_id)
+{
+    // arrange
+    int result;
+    delivery_number delivery_id = 42;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_get_next_delivery_id(link_endpoint, &delivery_id);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 0, delivery_id);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint);
+    session_destroy(session);
+}
+
+/* session_restore_link_endpoint_handles */
+
+/* Tests_SRS_SESSION_01_163: [If link_endpoint is NULL, session_restore_link_endpoint_handles shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_restore_link_endpoint_handles_with_NULL_link_endpoint_fails)
+{
+    // arrange
+
+    // act
+    int result = session_restore_link_endpoint_handles(NULL, 1, 2);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SESSION_01_164: [If output_handle is used by another link endpoint, is above the handle max, or input_handle cannot be mapped, session_restore_link_endpoint_handles shall fail and return a non-zero value.] */
+TEST_FUNCTION(session_restore_link_endpoint_handles_on_a_handle_used_by_another_link_endpoint_fails)
+{
+    // arrange
+    int result;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint0 = session_create_link_endpoint(session, "1");
+    LINK_ENDPOINT_HANDLE link_endpoint1 = session_create_link_endpoint(session, "2");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_restore_link_endpoint_handles(link_endpoint1, 0, 3);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint0);
+    session_destroy_link_endpoint(link_endpoint1);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_165: [session_restore_link_endpoint_handles shall move the link endpoint to output_handle, keeping the link endpoints sorted by output handle, map input_handle to it and return 0.] */
+TEST_FUNCTION(session_restore_link_endpoint_handles_moves_the_link_endpoint_to_the_output_handle)
+{
+    // arrange
+    int result;
+    handle output_handle;
+    handle input_handle;
+    handle new_output_handle;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint0 = session_create_link_endpoint(session, "1");
+    LINK_ENDPOINT_HANDLE link_endpoint1 = session_create_link_endpoint(session, "2");
+    LINK_ENDPOINT_HANDLE link_endpoint2;
+
+    // act
+    result = session_restore_link_endpoint_handles(link_endpoint0, 5, 3);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    link_endpoint2 = session_create_link_endpoint(session, "3");
+    (void)session_get_link_endpoint_handles(link_endpoint0, &output_handle, &input_handle);
+    ASSERT_ARE_EQUAL(uint32_t, 5, output_handle);
+    ASSERT_ARE_EQUAL(uint32_t, 3, input_handle);
+    (void)session_get_link_endpoint_handles(link_endpoint2, &new_output_handle, &input_handle);
+    ASSERT_ARE_EQUAL(uint32_t, 0, new_output_handle);
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint0);
+    session_destroy_link_endpoint(link_endpoint1);
+    session_destroy_link_endpoint(link_endpoint2);
+    session_destroy(session);
+}
+
+/* Tests_SRS_SESSION_01_165: [session_restore_link_endpoint_handles shall move the link endpoint to output_handle, keeping the link endpoints sorted by output handle, map input_handle to it and return 0.] */
+TEST_FUNCTION(session_restore_link_endpoint_handles_with_the_biggest_input_handle_does_not_allocate_a_table_for_it)
+{
+    // arrange
+    int result;
+    handle output_handle;
+    handle input_handle;
+    SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
+    LINK_ENDPOINT_HANDLE link_endpoint0 = session_create_link_endpoint(session, "1");
+    umock_c_reset_all_calls();
+
+    // act
+    result = session_restore_link_endpoint_handles(link_endpoint0, 0, 4294967295u);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)session_get_link_endpoint_handles(link_endpoint0, &output_handle, &input_handle);
+    ASSERT_ARE_EQUAL(uint32_t, 4294967295u, input_handle);
+
+    // cleanup
+    session_destroy_link_endpoint(link_endpoint0);
+    session_destroy(session);
+}
 
 #if 0
 /* Tests_SRS_SESSION_01_060: [If the previous connection state is not OPENED and the new connection state is OPENED, the BEGIN frame shall be sent out and the state shall be switched to BEGIN_SENT.] */
@@ -806,9 +2251,7 @@ TEST_FUNCTION(connection_state_changed_callback_to_different_than_OPENED_when_in
     SESSION_HANDLE session = session_create(TEST_CONNECTION_HANDLE, NULL, NULL);
     LINK_ENDPOINT_HANDLE link_endpoint = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
     saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_BEGIN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(definition_mocks, is_begin_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, 0, NULL);
+    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, AMQP_BEGIN, 0, NULL);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(test_on_session_state_changed(NULL, SESSION_STATE_DISCARDING, SESSION_STATE_MAPPED));
@@ -840,9 +2283,7 @@ TEST_FUNCTION(when_2_transfers_happen_on_2_different_endpoints_2_different_deliv
     LINK_ENDPOINT_HANDLE link_endpoint0 = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
     LINK_ENDPOINT_HANDLE link_endpoint1 = session_create_link_endpoint(session, "2", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
     saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_BEGIN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(definition_mocks, is_begin_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, 0, NULL);
+    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, AMQP_BEGIN, 0, NULL);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0));
@@ -883,9 +2324,7 @@ TEST_FUNCTION(when_if_sending_the_frame_to_the_connection_fails_the_next_outgoin
     LINK_ENDPOINT_HANDLE link_endpoint0 = session_create_link_endpoint(session, "1", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
     LINK_ENDPOINT_HANDLE link_endpoint1 = session_create_link_endpoint(session, "2", test_frame_received_callback, test_on_session_state_changed, test_on_flow_on, NULL);
     saved_connection_state_changed_callback(saved_callback_context, CONNECTION_STATE_OPENED, CONNECTION_STATE_OPEN_SENT);
-    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(TEST_BEGIN_PERFORMATIVE));
-    STRICT_EXPECTED_CALL(definition_mocks, is_begin_type_by_descriptor(TEST_DESCRIPTOR_AMQP_VALUE));
-    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, 0, NULL);
+    saved_frame_received_callback(saved_callback_context, TEST_BEGIN_PERFORMATIVE, AMQP_BEGIN, 0, NULL);
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(definition_mocks, transfer_set_delivery_id(test_transfer_handle, 0));
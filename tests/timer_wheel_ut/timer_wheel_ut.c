@@ -0,0 +1,758 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/timer_wheel.h"
+
+static TIMER_WHEEL_TIMER_HANDLE timer_to_stop;
+static TIMER_WHEEL_TIMER_HANDLE timer_to_restart;
+static TIMER_WHEEL_HANDLE timer_wheel_to_advance;
+static int advance_result;
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_timer_expired, void*, context)
+    if (timer_to_stop != NULL)
+    {
+        (void)timer_wheel_stop_timer(timer_to_stop);
+    }
+    if (timer_to_restart != NULL)
+    {
+        (void)timer_wheel_start_timer(timer_to_restart, 0);
+    }
+    if (timer_wheel_to_advance != NULL)
+    {
+        advance_result = timer_wheel_advance(timer_wheel_to_advance, 100000);
+    }
+MOCK_FUNCTION_END()
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(timer_wheel_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_function_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    timer_to_stop = NULL;
+    timer_to_restart = NULL;
+    timer_wheel_to_advance = NULL;
+    advance_result = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_function_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* timer_wheel_create */
+
+/* Tests_SRS_TIMER_WHEEL_01_001: [ `timer_wheel_create` shall create a timer wheel with `slot_count` slots of `tick_ms` milliseconds each, whose time starts at `current_ms`, and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(timer_wheel_create_succeeds)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = timer_wheel_create(10, 8, 1000);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(result);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_002: [ If `tick_ms` or `slot_count` is 0, `timer_wheel_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(timer_wheel_create_with_0_tick_ms_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+
+    // act
+    result = timer_wheel_create(0, 8, 1000);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_002: [ If `tick_ms` or `slot_count` is 0, `timer_wheel_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(timer_wheel_create_with_0_slot_count_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+
+    // act
+    result = timer_wheel_create(10, 0, 1000);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_003: [ If allocating memory for the timer wheel fails, `timer_wheel_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_timer_wheel_fails_timer_wheel_create_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = timer_wheel_create(10, 8, 1000);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_003: [ If allocating memory for the timer wheel fails, `timer_wheel_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_slots_fails_timer_wheel_create_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = timer_wheel_create(10, 8, 1000);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* timer_wheel_destroy */
+
+/* Tests_SRS_TIMER_WHEEL_01_004: [ `timer_wheel_destroy` shall stop all started timers and free all resources associated with the timer wheel. ]*/
+TEST_FUNCTION(timer_wheel_destroy_frees_the_resources)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    (void)timer_wheel_start_timer(timer, 1050);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    timer_wheel_destroy(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_005: [ If `timer_wheel` is NULL, `timer_wheel_destroy` shall do nothing. ]*/
+TEST_FUNCTION(timer_wheel_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    timer_wheel_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* timer_wheel_create_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_006: [ `timer_wheel_create_timer` shall create a stopped timer that calls `on_timer_expired` with `on_timer_expired_context` when it expires and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(timer_wheel_create_timer_succeeds)
+{
+    // arrange
+    TIMER_WHEEL_TIMER_HANDLE result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(result);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_007: [ If `timer_wheel` or `on_timer_expired` is NULL, `timer_wheel_create_timer` shall fail and return NULL. ]*/
+TEST_FUNCTION(timer_wheel_create_timer_with_NULL_timer_wheel_fails)
+{
+    // arrange
+    TIMER_WHEEL_TIMER_HANDLE result;
+
+    // act
+    result = timer_wheel_create_timer(NULL, test_on_timer_expired, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_007: [ If `timer_wheel` or `on_timer_expired` is NULL, `timer_wheel_create_timer` shall fail and return NULL. ]*/
+TEST_FUNCTION(timer_wheel_create_timer_with_NULL_on_timer_expired_fails)
+{
+    // arrange
+    TIMER_WHEEL_TIMER_HANDLE result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_create_timer(timer_wheel, NULL, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_008: [ If allocating memory for the timer fails, `timer_wheel_create_timer` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_timer_fails_timer_wheel_create_timer_fails)
+{
+    // arrange
+    TIMER_WHEEL_TIMER_HANDLE result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* timer_wheel_destroy_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_009: [ `timer_wheel_destroy_timer` shall stop the timer and free it. ]*/
+TEST_FUNCTION(timer_wheel_destroy_timer_stops_and_frees_the_timer)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    (void)timer_wheel_start_timer(timer, 1020);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    timer_wheel_destroy_timer(timer);
+
+    // assert
+    (void)timer_wheel_advance(timer_wheel, 2000);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_010: [ If `timer` is NULL, `timer_wheel_destroy_timer` shall do nothing. ]*/
+TEST_FUNCTION(timer_wheel_destroy_timer_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    timer_wheel_destroy_timer(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* timer_wheel_start_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_011: [ `timer_wheel_start_timer` shall arm the timer to expire at `deadline_ms` rounded up to the next tick, rescheduling it if it was already started. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_013: [ On success, `timer_wheel_start_timer` shall return 0. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_arms_the_timer_at_the_next_tick)
+{
+    // arrange
+    int result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_start_timer(timer, 1015);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)timer_wheel_advance(timer_wheel, 1019);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+    (void)timer_wheel_advance(timer_wheel, 1020);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_011: [ `timer_wheel_start_timer` shall arm the timer to expire at `deadline_ms` rounded up to the next tick, rescheduling it if it was already started. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_reschedules_a_started_timer)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    (void)timer_wheel_start_timer(timer, 1020);
+    umock_c_reset_all_calls();
+
+    // act
+    (void)timer_wheel_start_timer(timer, 1040);
+
+    // assert
+    (void)timer_wheel_advance(timer_wheel, 1030);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+    (void)timer_wheel_advance(timer_wheel, 1040);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_011: [ `timer_wheel_start_timer` shall arm the timer to expire at `deadline_ms` rounded up to the next tick, rescheduling it if it was already started. ]*/
+TEST_FUNCTION(a_timer_more_than_one_rotation_away_does_not_expire_early)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    // act
+    (void)timer_wheel_start_timer(timer, 1500);
+
+    // assert
+    (void)timer_wheel_advance(timer_wheel, 1100);
+    (void)timer_wheel_advance(timer_wheel, 1499);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+    (void)timer_wheel_advance(timer_wheel, 1500);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_012: [ If the deadline tick has already been processed, the timer shall expire on the next tick. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_with_a_past_deadline_expires_on_the_next_tick)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    // act
+    (void)timer_wheel_start_timer(timer, 500);
+
+    // assert
+    (void)timer_wheel_advance(timer_wheel, 1009);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+    (void)timer_wheel_advance(timer_wheel, 1010);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_014: [ If `timer` is NULL, `timer_wheel_start_timer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_with_NULL_timer_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = timer_wheel_start_timer(NULL, 1000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* timer_wheel_stop_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_015: [ `timer_wheel_stop_timer` shall stop the timer so that it does not expire. Stopping a timer that is not started shall not be an error. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_016: [ On success, `timer_wheel_stop_timer` shall return 0. ]*/
+TEST_FUNCTION(timer_wheel_stop_timer_stops_the_timer)
+{
+    // arrange
+    int result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    (void)timer_wheel_start_timer(timer, 1020);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_stop_timer(timer);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)timer_wheel_advance(timer_wheel, 2000);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_015: [ `timer_wheel_stop_timer` shall stop the timer so that it does not expire. Stopping a timer that is not started shall not be an error. ]*/
+TEST_FUNCTION(timer_wheel_stop_timer_on_a_stopped_timer_succeeds)
+{
+    // arrange
+    int result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_stop_timer(timer);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_017: [ If `timer` is NULL, `timer_wheel_stop_timer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_stop_timer_with_NULL_timer_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = timer_wheel_stop_timer(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* timer_wheel_advance */
+
+/* Tests_SRS_TIMER_WHEEL_01_018: [ `timer_wheel_advance` shall expire all timers whose expiry tick is not after `current_ms`, only visiting the slots of the ticks elapsed since the previous call. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_021: [ On success, `timer_wheel_advance` shall return 0. ]*/
+TEST_FUNCTION(timer_wheel_advance_expires_the_due_timers)
+{
+    // arrange
+    int result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer_1 = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    TIMER_WHEEL_TIMER_HANDLE timer_2 = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4243);
+    TIMER_WHEEL_TIMER_HANDLE timer_3 = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4244);
+    (void)timer_wheel_start_timer(timer_1, 1010);
+    (void)timer_wheel_start_timer(timer_2, 1030);
+    (void)timer_wheel_start_timer(timer_3, 1050);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4243));
+
+    // act
+    result = timer_wheel_advance(timer_wheel, 1040);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer_1);
+    timer_wheel_destroy_timer(timer_2);
+    timer_wheel_destroy_timer(timer_3);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_019: [ Timers started from an `on_timer_expired` callback shall not expire in the same `timer_wheel_advance` call. ]*/
+TEST_FUNCTION(a_timer_restarted_from_its_callback_expires_on_a_later_advance)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    (void)timer_wheel_start_timer(timer, 1010);
+    timer_to_restart = timer;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+
+    // act
+    (void)timer_wheel_advance(timer_wheel, 1010);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    timer_to_restart = NULL;
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+    (void)timer_wheel_advance(timer_wheel, 1020);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_020: [ A timer stopped or destroyed from an `on_timer_expired` callback before it expires shall not expire. ]*/
+TEST_FUNCTION(a_timer_stopped_from_a_callback_does_not_expire)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer_1 = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    TIMER_WHEEL_TIMER_HANDLE timer_2 = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4243);
+    (void)timer_wheel_start_timer(timer_1, 1010);
+    (void)timer_wheel_start_timer(timer_2, 1010);
+    timer_to_stop = timer_2;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+
+    // act
+    (void)timer_wheel_advance(timer_wheel, 1010);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer_1);
+    timer_wheel_destroy_timer(timer_2);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_022: [ If `timer_wheel` is NULL, `timer_wheel_advance` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_advance_with_NULL_timer_wheel_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = timer_wheel_advance(NULL, 1000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_023: [ If `timer_wheel_advance` is called from an `on_timer_expired` callback, it shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_advance_from_a_callback_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    (void)timer_wheel_start_timer(timer, 1010);
+    timer_wheel_to_advance = timer_wheel;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_timer_expired((void*)0x4242));
+
+    // act
+    (void)timer_wheel_advance(timer_wheel, 1010);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, advance_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* timer_wheel_get_next_expiry */
+
+/* Tests_SRS_TIMER_WHEEL_01_024: [ `timer_wheel_get_next_expiry` shall return in `expiry_ms` the time of the earliest tick in the next rotation at which a started timer expires. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_027: [ On success, `timer_wheel_get_next_expiry` shall return 0. ]*/
+TEST_FUNCTION(timer_wheel_get_next_expiry_returns_the_earliest_expiry_tick)
+{
+    // arrange
+    int result;
+    uint64_t expiry_ms;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer_1 = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    TIMER_WHEEL_TIMER_HANDLE timer_2 = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4243);
+    (void)timer_wheel_start_timer(timer_1, 1045);
+    (void)timer_wheel_start_timer(timer_2, 1021);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_get_next_expiry(timer_wheel, &expiry_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 1030, expiry_ms);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer_1);
+    timer_wheel_destroy_timer(timer_2);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_025: [ If no started timer expires within the next rotation, `timer_wheel_get_next_expiry` shall return the time one rotation after the last processed tick. ]*/
+TEST_FUNCTION(timer_wheel_get_next_expiry_with_only_far_timers_returns_one_rotation)
+{
+    // arrange
+    int result;
+    uint64_t expiry_ms;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    TIMER_WHEEL_TIMER_HANDLE timer = timer_wheel_create_timer(timer_wheel, test_on_timer_expired, (void*)0x4242);
+    (void)timer_wheel_start_timer(timer, 5000);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_get_next_expiry(timer_wheel, &expiry_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 1080, expiry_ms);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_026: [ If no timer is started, `timer_wheel_get_next_expiry` shall return UINT64_MAX in `expiry_ms`. ]*/
+TEST_FUNCTION(timer_wheel_get_next_expiry_with_no_started_timers_returns_UINT64_MAX)
+{
+    // arrange
+    int result;
+    uint64_t expiry_ms;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_get_next_expiry(timer_wheel, &expiry_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, UINT64_MAX, expiry_ms);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_028: [ If `timer_wheel` or `expiry_ms` is NULL, `timer_wheel_get_next_expiry` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_get_next_expiry_with_NULL_timer_wheel_fails)
+{
+    // arrange
+    int result;
+    uint64_t expiry_ms;
+
+    // act
+    result = timer_wheel_get_next_expiry(NULL, &expiry_ms);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_028: [ If `timer_wheel` or `expiry_ms` is NULL, `timer_wheel_get_next_expiry` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_get_next_expiry_with_NULL_expiry_ms_fails)
+{
+    // arrange
+    int result;
+    TIMER_WHEEL_HANDLE timer_wheel = timer_wheel_create(10, 8, 1000);
+    umock_c_reset_all_calls();
+
+    // act
+    result = timer_wheel_get_next_expiry(timer_wheel, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+END_TEST_SUITE(timer_wheel_ut)
@@ -0,0 +1,579 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+static int my_mallocAndStrcpy_s(char** destination, const char* source)
+{
+    size_t len = strlen(source);
+    *destination = (char*)my_gballoc_malloc(len + 1);
+    (void)strcpy(*destination, source);
+    return 0;
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/tls_session_cache.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static XIO_HANDLE test_xio = (XIO_HANDLE)0x4200;
+static XIO_HANDLE test_new_xio = (XIO_HANDLE)0x4201;
+static OPTIONHANDLER_HANDLE test_io_options = (OPTIONHANDLER_HANDLE)0x4300;
+static OPTIONHANDLER_HANDLE test_other_io_options = (OPTIONHANDLER_HANDLE)0x4301;
+
+TEST_DEFINE_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(tls_session_cache_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, test_io_options);
+    REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_FeedOptions, OPTIONHANDLER_OK);
+
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* tls_session_cache_create */
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_001: [ `tls_session_cache_create` shall create a new empty TLS session cache and on success return a non-NULL handle to it. ]*/
+TEST_FUNCTION(tls_session_cache_create_returns_a_valid_handle)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    tls_session_cache = tls_session_cache_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(tls_session_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_002: [ If allocating memory fails, `tls_session_cache_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_tls_session_cache_create_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    tls_session_cache = tls_session_cache_create();
+
+    // assert
+    ASSERT_IS_NULL(tls_session_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tls_session_cache_destroy */
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_003: [ `tls_session_cache_destroy` shall destroy the options kept for every host by calling `OptionHandler_Destroy` and free the cache. ]*/
+TEST_FUNCTION(tls_session_cache_destroy_destroys_the_kept_options)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    (void)tls_session_cache_save(tls_session_cache, "host1", test_xio);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(test_io_options));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    tls_session_cache_destroy(tls_session_cache);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_004: [ If `tls_session_cache` is NULL, `tls_session_cache_destroy` shall do nothing. ]*/
+TEST_FUNCTION(tls_session_cache_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    tls_session_cache_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tls_session_cache_save */
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_005: [ On success, `tls_session_cache_save` shall return 0. ]*/
+/* Tests_SRS_TLS_SESSION_CACHE_01_007: [ `tls_session_cache_save` shall get the options of `xio` by calling `xio_retrieveoptions`. ]*/
+/* Tests_SRS_TLS_SESSION_CACHE_01_009: [ Otherwise an entry for `hostname` shall be added, with a copy of `hostname`. ]*/
+TEST_FUNCTION(tls_session_cache_save_adds_an_entry_for_a_new_host)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_xio));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "host1"));
+
+    // act
+    result = tls_session_cache_save(tls_session_cache, "host1", test_xio);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_008: [ If options are already kept for `hostname`, they shall be destroyed by calling `OptionHandler_Destroy` and replaced. ]*/
+TEST_FUNCTION(tls_session_cache_save_replaces_the_options_of_a_known_host)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    (void)tls_session_cache_save(tls_session_cache, "host1", test_xio);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_new_xio))
+        .SetReturn(test_other_io_options);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(test_io_options));
+
+    // act
+    result = tls_session_cache_save(tls_session_cache, "host1", test_new_xio);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(test_other_io_options));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    tls_session_cache_destroy(tls_session_cache);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_006: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_save` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_save_with_NULL_tls_session_cache_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = tls_session_cache_save(NULL, "host1", test_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_006: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_save` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_save_with_NULL_hostname_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = tls_session_cache_save(tls_session_cache, NULL, test_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_006: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_save` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_save_with_NULL_xio_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = tls_session_cache_save(tls_session_cache, "host1", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_010: [ If any error occurs, `tls_session_cache_save` shall fail, return a non-zero value and keep the options saved before for `hostname`. ]*/
+TEST_FUNCTION(when_xio_retrieveoptions_fails_tls_session_cache_save_keeps_the_previous_options)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    (void)tls_session_cache_save(tls_session_cache, "host1", test_xio);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_new_xio))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(test_io_options, test_new_xio));
+
+    // act
+    result = tls_session_cache_save(tls_session_cache, "host1", test_new_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    (void)tls_session_cache_apply(tls_session_cache, "host1", test_new_xio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_010: [ If any error occurs, `tls_session_cache_save` shall fail, return a non-zero value and keep the options saved before for `hostname`. ]*/
+TEST_FUNCTION(when_growing_the_cache_fails_tls_session_cache_save_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_xio));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(test_io_options));
+
+    // act
+    result = tls_session_cache_save(tls_session_cache, "host1", test_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_010: [ If any error occurs, `tls_session_cache_save` shall fail, return a non-zero value and keep the options saved before for `hostname`. ]*/
+TEST_FUNCTION(when_copying_the_hostname_fails_tls_session_cache_save_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_xio));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "host1"))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(test_io_options));
+
+    // act
+    result = tls_session_cache_save(tls_session_cache, "host1", test_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* tls_session_cache_apply */
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_011: [ On success, `tls_session_cache_apply` shall return 0. ]*/
+/* Tests_SRS_TLS_SESSION_CACHE_01_013: [ `tls_session_cache_apply` shall set the options kept for `hostname` on `xio` by calling `OptionHandler_FeedOptions`. ]*/
+TEST_FUNCTION(tls_session_cache_apply_feeds_the_options_of_the_host)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    (void)tls_session_cache_save(tls_session_cache, "host1", test_xio);
+    (void)tls_session_cache_save(tls_session_cache, "host2", test_xio);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(test_io_options, test_new_xio));
+
+    // act
+    result = tls_session_cache_apply(tls_session_cache, "host2", test_new_xio);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_014: [ If no options are kept for `hostname`, `tls_session_cache_apply` shall set nothing and return 0. ]*/
+TEST_FUNCTION(tls_session_cache_apply_for_an_unknown_host_sets_nothing)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    (void)tls_session_cache_save(tls_session_cache, "host1", test_xio);
+    umock_c_reset_all_calls();
+
+    // act
+    result = tls_session_cache_apply(tls_session_cache, "host2", test_new_xio);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_012: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_apply` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_apply_with_NULL_tls_session_cache_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = tls_session_cache_apply(NULL, "host1", test_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_012: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_apply` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_apply_with_NULL_hostname_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = tls_session_cache_apply(tls_session_cache, NULL, test_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_012: [ If `tls_session_cache`, `hostname` or `xio` is NULL, `tls_session_cache_apply` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_apply_with_NULL_xio_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = tls_session_cache_apply(tls_session_cache, "host1", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_015: [ If `OptionHandler_FeedOptions` fails, `tls_session_cache_apply` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_OptionHandler_FeedOptions_fails_tls_session_cache_apply_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    (void)tls_session_cache_save(tls_session_cache, "host1", test_xio);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(test_io_options, test_new_xio))
+        .SetReturn(OPTIONHANDLER_ERROR);
+
+    // act
+    result = tls_session_cache_apply(tls_session_cache, "host1", test_new_xio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* tls_session_cache_remove */
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_016: [ On success, `tls_session_cache_remove` shall return 0, also when no options are kept for `hostname`. ]*/
+/* Tests_SRS_TLS_SESSION_CACHE_01_018: [ `tls_session_cache_remove` shall destroy the options kept for `hostname` by calling `OptionHandler_Destroy` and drop its entry. ]*/
+TEST_FUNCTION(tls_session_cache_remove_drops_the_entry_of_the_host)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    (void)tls_session_cache_save(tls_session_cache, "host1", test_xio);
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(test_xio))
+        .SetReturn(test_other_io_options);
+    (void)tls_session_cache_save(tls_session_cache, "host2", test_xio);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(test_io_options));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions(test_other_io_options, test_new_xio));
+
+    // act
+    result = tls_session_cache_remove(tls_session_cache, "host1");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    (void)tls_session_cache_apply(tls_session_cache, "host1", test_new_xio);
+    (void)tls_session_cache_apply(tls_session_cache, "host2", test_new_xio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_016: [ On success, `tls_session_cache_remove` shall return 0, also when no options are kept for `hostname`. ]*/
+TEST_FUNCTION(tls_session_cache_remove_for_an_unknown_host_succeeds)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = tls_session_cache_remove(tls_session_cache, "host1");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_017: [ If `tls_session_cache` or `hostname` is NULL, `tls_session_cache_remove` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_remove_with_NULL_tls_session_cache_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = tls_session_cache_remove(NULL, "host1");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TLS_SESSION_CACHE_01_017: [ If `tls_session_cache` or `hostname` is NULL, `tls_session_cache_remove` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tls_session_cache_remove_with_NULL_hostname_fails)
+{
+    // arrange
+    TLS_SESSION_CACHE_HANDLE tls_session_cache = tls_session_cache_create();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = tls_session_cache_remove(tls_session_cache, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tls_session_cache_destroy(tls_session_cache);
+}
+
+END_TEST_SUITE(tls_session_cache_ut)
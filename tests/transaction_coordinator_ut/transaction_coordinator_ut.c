@@ -0,0 +1,747 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/messaging.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_uamqp_c/transaction_coordinator.h"
+
+static SESSION_HANDLE test_session = (SESSION_HANDLE)0x4242;
+static LINK_HANDLE test_link = (LINK_HANDLE)0x4243;
+static AMQP_VALUE test_source = (AMQP_VALUE)0x4244;
+static AMQP_VALUE test_target = (AMQP_VALUE)0x4245;
+static ASYNC_OPERATION_HANDLE test_transfer_operation = (ASYNC_OPERATION_HANDLE)0x4246;
+static AMQP_VALUE test_delivery_state = (AMQP_VALUE)0x4247;
+static AMQP_VALUE test_descriptor = (AMQP_VALUE)0x4248;
+static AMQP_VALUE test_described_value = (AMQP_VALUE)0x4249;
+static AMQP_VALUE test_txn_id_value = (AMQP_VALUE)0x424A;
+static const unsigned char test_txn_id[] = { 0x01, 0x02, 0x03, 0x04 };
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static ON_LINK_STATE_CHANGED saved_on_link_state_changed;
+static void* saved_on_link_state_changed_context;
+static ON_DELIVERY_SETTLED saved_on_delivery_settled;
+static void* saved_on_delivery_settled_context;
+static unsigned char sent_bytes[64];
+static size_t sent_byte_count;
+static uint64_t test_descriptor_code;
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_open_complete, void*, context, TRANSACTION_COORDINATOR_RESULT, open_result)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_declared, void*, context, TRANSACTION_COORDINATOR_RESULT, declare_result, const unsigned char*, txn_id, uint32_t, txn_id_length)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_discharged, void*, context, TRANSACTION_COORDINATOR_RESULT, discharge_result)
+MOCK_FUNCTION_END();
+
+static int my_link_attach(LINK_HANDLE link, ON_TRANSFER_RECEIVED on_transfer_received, ON_LINK_STATE_CHANGED on_link_state_changed, ON_LINK_FLOW_ON on_link_flow_on, void* callback_context)
+{
+    (void)link;
+    (void)on_transfer_received;
+    (void)on_link_flow_on;
+    saved_on_link_state_changed = on_link_state_changed;
+    saved_on_link_state_changed_context = callback_context;
+    return 0;
+}
+
+static ASYNC_OPERATION_HANDLE my_link_transfer_async(LINK_HANDLE link, message_format message_format, PAYLOAD* payloads, size_t payload_count, ON_DELIVERY_SETTLED on_delivery_settled, void* callback_context, LINK_TRANSFER_RESULT* link_transfer_result, tickcounter_ms_t timeout)
+{
+    (void)link;
+    (void)message_format;
+    (void)payload_count;
+    (void)link_transfer_result;
+    (void)timeout;
+    (void)memcpy(sent_bytes, payloads[0].bytes, payloads[0].length);
+    sent_byte_count = payloads[0].length;
+    saved_on_delivery_settled = on_delivery_settled;
+    saved_on_delivery_settled_context = callback_context;
+    return test_transfer_operation;
+}
+
+static int my_amqpvalue_get_ulong(AMQP_VALUE value, uint64_t* ulong_value)
+{
+    (void)value;
+    *ulong_value = test_descriptor_code;
+    return 0;
+}
+
+static int my_amqpvalue_get_binary(AMQP_VALUE value, amqp_binary* binary_value)
+{
+    (void)value;
+    binary_value->bytes = test_txn_id;
+    binary_value->length = sizeof(test_txn_id);
+    return 0;
+}
+
+#define role_VALUES \
+    role_sender,    \
+    role_receiver
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+#ifndef __cplusplus
+TEST_DEFINE_ENUM_TYPE(role, role_VALUES);
+#endif
+IMPLEMENT_UMOCK_C_ENUM_TYPE(role, role_VALUES);
+
+TEST_DEFINE_ENUM_TYPE(TRANSACTION_COORDINATOR_RESULT, TRANSACTION_COORDINATOR_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(TRANSACTION_COORDINATOR_RESULT, TRANSACTION_COORDINATOR_RESULT_VALUES);
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TRANSACTION_COORDINATOR_HANDLE create_open_transaction_coordinator(void)
+{
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+    (void)transaction_coordinator_open_async(transaction_coordinator, test_on_open_complete, (void*)0x4301);
+    saved_on_link_state_changed(saved_on_link_state_changed_context, LINK_STATE_ATTACHED, LINK_STATE_HALF_ATTACHED_ATTACH_SENT);
+    umock_c_reset_all_calls();
+    return transaction_coordinator;
+}
+
+BEGIN_TEST_SUITE(transaction_coordinator_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_TYPE(role, role);
+    REGISTER_TYPE(TRANSACTION_COORDINATOR_RESULT, TRANSACTION_COORDINATOR_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(link_attach, my_link_attach);
+    REGISTER_GLOBAL_MOCK_HOOK(link_transfer_async, my_link_transfer_async);
+    REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_get_ulong, my_amqpvalue_get_ulong);
+    REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_get_binary, my_amqpvalue_get_binary);
+    REGISTER_GLOBAL_MOCK_RETURN(messaging_create_source, test_source);
+    REGISTER_GLOBAL_MOCK_RETURN(messaging_create_coordinator_target, test_target);
+    REGISTER_GLOBAL_MOCK_RETURN(link_create, test_link);
+    REGISTER_GLOBAL_MOCK_RETURN(link_detach, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_inplace_descriptor, test_descriptor);
+    REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_inplace_described_value, test_described_value);
+    REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_list_item_in_place, test_txn_id_value);
+    REGISTER_GLOBAL_MOCK_RETURN(is_accepted_type_by_descriptor, false);
+    REGISTER_GLOBAL_MOCK_RETURN(is_rejected_type_by_descriptor, false);
+
+    REGISTER_UMOCK_ALIAS_TYPE(SESSION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LINK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(AMQP_VALUE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ASYNC_OPERATION_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_TRANSFER_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_LINK_STATE_CHANGED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_LINK_FLOW_ON, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_DELIVERY_SETTLED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(message_format, uint32_t);
+    REGISTER_UMOCK_ALIAS_TYPE(LINK_TRANSFER_RESULT, int);
+
+    /* boo, we need uint_fast32_t in umock */
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, uint32_t);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(test_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    saved_on_link_state_changed = NULL;
+    saved_on_delivery_settled = NULL;
+    sent_byte_count = 0;
+    test_descriptor_code = 0;
+}
+
+TEST_FUNCTION_CLEANUP(test_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* transaction_coordinator_create */
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_001: [ transaction_coordinator_create shall create a sender link named link_name on session, with a source whose address is link_name and the coordinator target created by messaging_create_coordinator_target. ]*/
+TEST_FUNCTION(transaction_coordinator_create_creates_a_sender_link_to_the_coordinator)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(messaging_create_source("txn_link"));
+    STRICT_EXPECTED_CALL(messaging_create_coordinator_target());
+    STRICT_EXPECTED_CALL(link_create(test_session, "txn_link", role_sender, test_source, test_target));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_source));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_target));
+
+    // act
+    transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+
+    // assert
+    ASSERT_IS_NOT_NULL(transaction_coordinator);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_002: [ If session or link_name is NULL, transaction_coordinator_create shall fail and return NULL. ]*/
+TEST_FUNCTION(transaction_coordinator_create_with_NULL_session_fails)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator;
+
+    // act
+    transaction_coordinator = transaction_coordinator_create(NULL, "txn_link");
+
+    // assert
+    ASSERT_IS_NULL(transaction_coordinator);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_002: [ If session or link_name is NULL, transaction_coordinator_create shall fail and return NULL. ]*/
+TEST_FUNCTION(transaction_coordinator_create_with_NULL_link_name_fails)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator;
+
+    // act
+    transaction_coordinator = transaction_coordinator_create(test_session, NULL);
+
+    // assert
+    ASSERT_IS_NULL(transaction_coordinator);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_003: [ If any resource cannot be created, transaction_coordinator_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_link_create_fails_transaction_coordinator_create_fails)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(messaging_create_source("txn_link"));
+    STRICT_EXPECTED_CALL(messaging_create_coordinator_target());
+    STRICT_EXPECTED_CALL(link_create(test_session, "txn_link", role_sender, test_source, test_target))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_source));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(test_target));
+
+    // act
+    transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+
+    // assert
+    ASSERT_IS_NULL(transaction_coordinator);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* transaction_coordinator_destroy */
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_004: [ transaction_coordinator_destroy shall destroy the link and free the declares and discharges still pending, without calling their callbacks. ]*/
+TEST_FUNCTION(transaction_coordinator_destroy_destroys_the_link_and_the_pending_operations)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    (void)transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(link_destroy(test_link));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    transaction_coordinator_destroy(transaction_coordinator);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_005: [ If transaction_coordinator is NULL, transaction_coordinator_destroy shall do nothing. ]*/
+TEST_FUNCTION(transaction_coordinator_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    transaction_coordinator_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* transaction_coordinator_open_async */
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_006: [ transaction_coordinator_open_async shall attach the link by calling link_attach. ]*/
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_010: [ When the link is attached, on_open_complete shall be called with TRANSACTION_COORDINATOR_OK. ]*/
+TEST_FUNCTION(transaction_coordinator_open_async_completes_when_the_link_is_attached)
+{
+    // arrange
+    int result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(link_attach(test_link, NULL, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_open_complete((void*)0x4301, TRANSACTION_COORDINATOR_OK));
+
+    // act
+    result = transaction_coordinator_open_async(transaction_coordinator, test_on_open_complete, (void*)0x4301);
+    saved_on_link_state_changed(saved_on_link_state_changed_context, LINK_STATE_ATTACHED, LINK_STATE_HALF_ATTACHED_ATTACH_SENT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_011: [ If the link detaches or fails before being attached, on_open_complete shall be called with TRANSACTION_COORDINATOR_ERROR. ]*/
+TEST_FUNCTION(when_the_link_detaches_before_being_attached_the_open_completes_with_error)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+    (void)transaction_coordinator_open_async(transaction_coordinator, test_on_open_complete, (void*)0x4301);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_open_complete((void*)0x4301, TRANSACTION_COORDINATOR_ERROR));
+
+    // act
+    saved_on_link_state_changed(saved_on_link_state_changed_context, LINK_STATE_DETACHED, LINK_STATE_HALF_ATTACHED_ATTACH_SENT);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_007: [ If transaction_coordinator or on_open_complete is NULL, transaction_coordinator_open_async shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(transaction_coordinator_open_async_with_NULL_on_open_complete_fails)
+{
+    // arrange
+    int result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+    umock_c_reset_all_calls();
+
+    // act
+    result = transaction_coordinator_open_async(transaction_coordinator, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_009: [ If link_attach fails, transaction_coordinator_open_async shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_link_attach_fails_transaction_coordinator_open_async_fails)
+{
+    // arrange
+    int result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(link_attach(test_link, NULL, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = transaction_coordinator_open_async(transaction_coordinator, test_on_open_complete, (void*)0x4301);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* transaction_coordinator_declare_async */
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_018: [ transaction_coordinator_declare_async shall send, with link_transfer_async, a message whose amqp-value body is a declare without global-id. ]*/
+TEST_FUNCTION(transaction_coordinator_declare_async_sends_a_declare)
+{
+    // arrange
+    int result;
+    unsigned char expected_bytes[] = { 0x00, 0x53, 0x77, 0x00, 0x53, 0x31, 0x45 };
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_transfer_async(test_link, 0, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+
+    // act
+    result = transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, sent_bytes, sizeof(expected_bytes)));
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_024: [ If the transaction coordinator is not open, transaction_coordinator_declare_async shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(transaction_coordinator_declare_async_before_open_fails)
+{
+    // arrange
+    int result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+    umock_c_reset_all_calls();
+
+    // act
+    result = transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_025: [ If allocating memory or sending fails, transaction_coordinator_declare_async shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_link_transfer_async_fails_transaction_coordinator_declare_async_fails)
+{
+    // arrange
+    int result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_transfer_async(test_link, 0, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_019: [ When the declare is settled with a declared outcome, on_declared shall be called with TRANSACTION_COORDINATOR_OK and the bytes of its txn-id. ]*/
+TEST_FUNCTION(a_declared_outcome_completes_the_declare_with_the_txn_id)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    (void)transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+    umock_c_reset_all_calls();
+    test_descriptor_code = 0x33;
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_delivery_state));
+    STRICT_EXPECTED_CALL(is_rejected_type_by_descriptor(test_descriptor));
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_delivery_state));
+    STRICT_EXPECTED_CALL(amqpvalue_get_ulong(test_descriptor, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_described_value(test_delivery_state));
+    STRICT_EXPECTED_CALL(amqpvalue_get_list_item_in_place(test_described_value, 0));
+    STRICT_EXPECTED_CALL(amqpvalue_get_binary(test_txn_id_value, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_declared((void*)0x4302, TRANSACTION_COORDINATOR_OK, IGNORED_PTR_ARG, sizeof(test_txn_id)))
+        .ValidateArgumentBuffer(3, test_txn_id, sizeof(test_txn_id));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_delivery_settled(saved_on_delivery_settled_context, 0, LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED, test_delivery_state);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_020: [ If the outcome is rejected, on_declared shall be called with TRANSACTION_COORDINATOR_REJECTED, NULL and 0. ]*/
+TEST_FUNCTION(a_rejected_outcome_completes_the_declare_with_rejected)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    (void)transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_delivery_state));
+    STRICT_EXPECTED_CALL(is_rejected_type_by_descriptor(test_descriptor))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(test_on_declared((void*)0x4302, TRANSACTION_COORDINATOR_REJECTED, NULL, 0));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_delivery_settled(saved_on_delivery_settled_context, 0, LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED, test_delivery_state);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_021: [ If the outcome is neither a declared outcome with a binary txn-id nor rejected, on_declared shall be called with TRANSACTION_COORDINATOR_ERROR, NULL and 0. ]*/
+TEST_FUNCTION(an_accepted_outcome_completes_the_declare_with_error)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    (void)transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+    umock_c_reset_all_calls();
+    test_descriptor_code = 0x24;
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_delivery_state));
+    STRICT_EXPECTED_CALL(is_rejected_type_by_descriptor(test_descriptor));
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_delivery_state));
+    STRICT_EXPECTED_CALL(amqpvalue_get_ulong(test_descriptor, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_declared((void*)0x4302, TRANSACTION_COORDINATOR_ERROR, NULL, 0));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_delivery_settled(saved_on_delivery_settled_context, 0, LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED, test_delivery_state);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_022: [ If the declare is settled without a disposition (e.g. the link detached), on_declared shall be called with TRANSACTION_COORDINATOR_ERROR, NULL and 0. ]*/
+TEST_FUNCTION(a_declare_not_delivered_completes_with_error)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    (void)transaction_coordinator_declare_async(transaction_coordinator, test_on_declared, (void*)0x4302);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_declared((void*)0x4302, TRANSACTION_COORDINATOR_ERROR, NULL, 0));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_delivery_settled(saved_on_delivery_settled_context, 0, LINK_DELIVERY_SETTLE_REASON_NOT_DELIVERED, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* transaction_coordinator_discharge_async */
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_026: [ transaction_coordinator_discharge_async shall send, with link_transfer_async, a message whose amqp-value body is a discharge of txn_id with fail. ]*/
+TEST_FUNCTION(transaction_coordinator_discharge_async_sends_a_discharge)
+{
+    // arrange
+    int result;
+    unsigned char expected_bytes[] = { 0x00, 0x53, 0x77, 0x00, 0x53, 0x32, 0xC0, 0x08, 0x02, 0xA0, 0x04, 0x01, 0x02, 0x03, 0x04, 0x41 };
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(link_transfer_async(test_link, 0, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+
+    // act
+    result = transaction_coordinator_discharge_async(transaction_coordinator, test_txn_id, sizeof(test_txn_id), true, test_on_discharged, (void*)0x4303);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, sent_bytes, sizeof(expected_bytes)));
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_030: [ If transaction_coordinator, txn_id or on_discharged is NULL, or txn_id_length is 0 or more than 32, transaction_coordinator_discharge_async shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(transaction_coordinator_discharge_async_with_a_txn_id_longer_than_32_bytes_fails)
+{
+    // arrange
+    int result;
+    unsigned char long_txn_id[33] = { 0 };
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+
+    // act
+    result = transaction_coordinator_discharge_async(transaction_coordinator, long_txn_id, sizeof(long_txn_id), false, test_on_discharged, (void*)0x4303);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_031: [ If the transaction coordinator is not open, transaction_coordinator_discharge_async shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(transaction_coordinator_discharge_async_after_the_link_detached_fails)
+{
+    // arrange
+    int result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    saved_on_link_state_changed(saved_on_link_state_changed_context, LINK_STATE_DETACHED, LINK_STATE_ATTACHED);
+    umock_c_reset_all_calls();
+
+    // act
+    result = transaction_coordinator_discharge_async(transaction_coordinator, test_txn_id, sizeof(test_txn_id), false, test_on_discharged, (void*)0x4303);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_027: [ When the discharge is settled with the accepted outcome, on_discharged shall be called with TRANSACTION_COORDINATOR_OK. ]*/
+TEST_FUNCTION(an_accepted_outcome_completes_the_discharge)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    (void)transaction_coordinator_discharge_async(transaction_coordinator, test_txn_id, sizeof(test_txn_id), false, test_on_discharged, (void*)0x4303);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_delivery_state));
+    STRICT_EXPECTED_CALL(is_accepted_type_by_descriptor(test_descriptor))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(test_on_discharged((void*)0x4303, TRANSACTION_COORDINATOR_OK));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_delivery_settled(saved_on_delivery_settled_context, 0, LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED, test_delivery_state);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_028: [ When the discharge is settled with the rejected outcome, on_discharged shall be called with TRANSACTION_COORDINATOR_REJECTED. ]*/
+TEST_FUNCTION(a_rejected_outcome_completes_the_discharge_with_rejected)
+{
+    // arrange
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+    (void)transaction_coordinator_discharge_async(transaction_coordinator, test_txn_id, sizeof(test_txn_id), false, test_on_discharged, (void*)0x4303);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(amqpvalue_get_inplace_descriptor(test_delivery_state));
+    STRICT_EXPECTED_CALL(is_accepted_type_by_descriptor(test_descriptor));
+    STRICT_EXPECTED_CALL(is_rejected_type_by_descriptor(test_descriptor))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(test_on_discharged((void*)0x4303, TRANSACTION_COORDINATOR_REJECTED));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    saved_on_delivery_settled(saved_on_delivery_settled_context, 0, LINK_DELIVERY_SETTLE_REASON_DISPOSITION_RECEIVED, test_delivery_state);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* transaction_coordinator_close */
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_013: [ transaction_coordinator_close shall close the link by calling link_detach with close set to true. ]*/
+TEST_FUNCTION(transaction_coordinator_close_detaches_the_link)
+{
+    // arrange
+    int result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = create_open_transaction_coordinator();
+
+    STRICT_EXPECTED_CALL(link_detach(test_link, true));
+
+    // act
+    result = transaction_coordinator_close(transaction_coordinator);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+/* transaction_coordinator_get_link */
+
+/* Tests_SRS_TRANSACTION_COORDINATOR_01_033: [ transaction_coordinator_get_link shall return the link to the coordinator. ]*/
+TEST_FUNCTION(transaction_coordinator_get_link_returns_the_link)
+{
+    // arrange
+    LINK_HANDLE result;
+    TRANSACTION_COORDINATOR_HANDLE transaction_coordinator = transaction_coordinator_create(test_session, "txn_link");
+    umock_c_reset_all_calls();
+
+    // act
+    result = transaction_coordinator_get_link(transaction_coordinator);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, test_link, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    transaction_coordinator_destroy(transaction_coordinator);
+}
+
+END_TEST_SUITE(transaction_coordinator_ut)
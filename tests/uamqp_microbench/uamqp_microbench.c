@@ -0,0 +1,848 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "azure_uamqp_c/amqp_definitions.h"
+#include "azure_uamqp_c/amqp_frame_codec.h"
+#include "azure_uamqp_c/amqp_performative_fields.h"
+#include "azure_uamqp_c/messaging.h"
+#include "azure_uamqp_c/alloc_counters.h"
+#include "perf_counters/perf_counters.h"
+
+#define ARENA_BLOCK_SIZE 4096
+
+typedef AMQP_VALUE(*CREATE_VALUE)(void);
+typedef int(*PARSE_VALUE)(AMQP_VALUE value);
+
+typedef struct BENCHMARK_VALUE_TAG
+{
+    const char* name;
+    CREATE_VALUE create_value;
+    PARSE_VALUE parse_value;
+} BENCHMARK_VALUE;
+
+typedef struct BENCHMARK_CONTEXT_TAG
+{
+    const BENCHMARK_VALUE* benchmark_value;
+    AMQP_VALUE value;
+    unsigned char* encoded_bytes;
+    size_t encoded_size;
+    AMQPVALUE_DECODER_HANDLE decoder;
+    AMQPVALUE_ARENA_HANDLE arena;
+    FRAME_CODEC_HANDLE frame_codec;
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec;
+    size_t decoded_count;
+    bool is_error;
+} BENCHMARK_CONTEXT;
+
+typedef int(*BENCHMARK_OPERATION)(BENCHMARK_CONTEXT* context);
+
+static uint64_t min_run_time_ns = 500 * 1000 * 1000;
+static const char* name_filter;
+static bool has_allocation_count;
+static bool is_counters_requested;
+/* NULL unless --counters on and the platform has them */
+static PERF_COUNTERS_HANDLE perf_counters;
+
+static uint64_t get_time_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000) + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/* allocations are counted when the library is built with alloc_counters, or with memory_trace which routes malloc through gballoc */
+static size_t get_allocation_count(void)
+{
+    size_t result;
+    ALLOC_COUNTERS counters;
+
+    if (alloc_counters_are_enabled() &&
+        (alloc_counters_get_total(&counters) == 0))
+    {
+        result = (size_t)counters.allocation_count;
+    }
+    else
+    {
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+        result = gballoc_getAllocationCount();
+#else
+        result = 0;
+#endif
+    }
+
+    return result;
+}
+
+/* values */
+
+static const unsigned char delivery_tag_bytes[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+
+static AMQP_VALUE create_transfer(void)
+{
+    AMQP_VALUE result;
+    TRANSFER_HANDLE transfer = transfer_create(0);
+    delivery_tag tag;
+
+    tag.bytes = delivery_tag_bytes;
+    tag.length = sizeof(delivery_tag_bytes);
+
+    if (transfer == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        if ((transfer_set_delivery_id(transfer, 42) != 0) ||
+            (transfer_set_delivery_tag(transfer, tag) != 0) ||
+            (transfer_set_message_format(transfer, 0) != 0) ||
+            (transfer_set_settled(transfer, false) != 0))
+        {
+            result = NULL;
+        }
+        else
+        {
+            result = amqpvalue_create_transfer(transfer);
+        }
+
+        transfer_destroy(transfer);
+    }
+
+    return result;
+}
+
+static int parse_transfer(AMQP_VALUE value)
+{
+    int result;
+    TRANSFER_HANDLE transfer;
+    delivery_number delivery_id;
+    delivery_tag tag;
+
+    if (amqpvalue_get_transfer(value, &transfer) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        if ((transfer_get_delivery_id(transfer, &delivery_id) != 0) ||
+            (transfer_get_delivery_tag(transfer, &tag) != 0))
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        transfer_destroy(transfer);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE create_flow(void)
+{
+    AMQP_VALUE result;
+    FLOW_HANDLE flow = flow_create(100, 1, 100);
+
+    if (flow == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        if ((flow_set_next_incoming_id(flow, 1) != 0) ||
+            (flow_set_handle(flow, 0) != 0) ||
+            (flow_set_delivery_count(flow, 10) != 0) ||
+            (flow_set_link_credit(flow, 100) != 0))
+        {
+            result = NULL;
+        }
+        else
+        {
+            result = amqpvalue_create_flow(flow);
+        }
+
+        flow_destroy(flow);
+    }
+
+    return result;
+}
+
+static int parse_flow(AMQP_VALUE value)
+{
+    int result;
+    FLOW_HANDLE flow;
+    uint32_t link_credit;
+
+    if (amqpvalue_get_flow(value, &flow) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = (flow_get_link_credit(flow, &link_credit) != 0) ? __LINE__ : 0;
+        flow_destroy(flow);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE create_disposition(void)
+{
+    AMQP_VALUE result;
+    DISPOSITION_HANDLE disposition = disposition_create(role_receiver, 42);
+    AMQP_VALUE delivery_state = messaging_delivery_accepted();
+
+    if ((disposition == NULL) ||
+        (delivery_state == NULL) ||
+        (disposition_set_last(disposition, 50) != 0) ||
+        (disposition_set_settled(disposition, true) != 0) ||
+        (disposition_set_state(disposition, delivery_state) != 0))
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = amqpvalue_create_disposition(disposition);
+    }
+
+    if (delivery_state != NULL)
+    {
+        amqpvalue_destroy(delivery_state);
+    }
+
+    if (disposition != NULL)
+    {
+        disposition_destroy(disposition);
+    }
+
+    return result;
+}
+
+static int parse_disposition(AMQP_VALUE value)
+{
+    int result;
+    DISPOSITION_HANDLE disposition;
+    delivery_number first;
+
+    if (amqpvalue_get_disposition(value, &disposition) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = (disposition_get_first(disposition, &first) != 0) ? __LINE__ : 0;
+        disposition_destroy(disposition);
+    }
+
+    return result;
+}
+
+/* the same fields read through the in place views, for comparison with the handle based getters */
+static int parse_transfer_fields(AMQP_VALUE value)
+{
+    TRANSFER_FIELDS transfer_fields;
+    return ((amqpvalue_get_transfer_fields(value, &transfer_fields) != 0) ||
+        !transfer_fields.has_delivery_id ||
+        !transfer_fields.has_delivery_tag) ? __LINE__ : 0;
+}
+
+static int parse_flow_fields(AMQP_VALUE value)
+{
+    FLOW_FIELDS flow_fields;
+    return ((amqpvalue_get_flow_fields(value, &flow_fields) != 0) ||
+        !flow_fields.has_link_credit) ? __LINE__ : 0;
+}
+
+static int parse_disposition_fields(AMQP_VALUE value)
+{
+    DISPOSITION_FIELDS disposition_fields;
+    return (amqpvalue_get_disposition_fields(value, &disposition_fields) != 0) ? __LINE__ : 0;
+}
+
+static AMQP_VALUE create_annotations(uint32_t entry_count)
+{
+    AMQP_VALUE result = amqpvalue_create_map_with_capacity(entry_count);
+    uint32_t i;
+
+    for (i = 0; (result != NULL) && (i < entry_count); i++)
+    {
+        char key_string[32];
+        AMQP_VALUE key;
+        AMQP_VALUE value;
+
+        (void)sprintf(key_string, "x-opt-annotation-%u", (unsigned int)i);
+        key = amqpvalue_create_symbol(key_string);
+        switch (i % 3)
+        {
+        default:
+            value = amqpvalue_create_string("some annotation value");
+            break;
+        case 1:
+            value = amqpvalue_create_ulong(i);
+            break;
+        case 2:
+            value = amqpvalue_create_timestamp(1500000000000 + i);
+            break;
+        }
+
+        if ((key == NULL) ||
+            (value == NULL) ||
+            (amqpvalue_set_map_value(result, key, value) != 0))
+        {
+            amqpvalue_destroy(result);
+            result = NULL;
+        }
+
+        if (key != NULL)
+        {
+            amqpvalue_destroy(key);
+        }
+
+        if (value != NULL)
+        {
+            amqpvalue_destroy(value);
+        }
+    }
+
+    return result;
+}
+
+static AMQP_VALUE create_annotations_4(void)
+{
+    return create_annotations(4);
+}
+
+static AMQP_VALUE create_annotations_16(void)
+{
+    return create_annotations(16);
+}
+
+static AMQP_VALUE create_annotations_64(void)
+{
+    return create_annotations(64);
+}
+
+static AMQP_VALUE create_binary(uint32_t length)
+{
+    AMQP_VALUE result;
+    unsigned char* bytes = (unsigned char*)calloc(1, length);
+
+    if (bytes == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        amqp_binary binary_value;
+        binary_value.bytes = bytes;
+        binary_value.length = length;
+        result = amqpvalue_create_binary(binary_value);
+        free(bytes);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE create_binary_64k(void)
+{
+    return create_binary(64 * 1024);
+}
+
+static AMQP_VALUE create_binary_1m(void)
+{
+    return create_binary(1024 * 1024);
+}
+
+/* a list of 4 items, each item being a nested list until depth reaches 0 where items are ints and strings */
+static AMQP_VALUE create_nested_list(uint32_t depth)
+{
+    AMQP_VALUE result = amqpvalue_create_list_with_capacity(4);
+    uint32_t i;
+
+    if ((result != NULL) &&
+        (amqpvalue_set_list_item_count(result, 4) != 0))
+    {
+        amqpvalue_destroy(result);
+        result = NULL;
+    }
+
+    for (i = 0; (result != NULL) && (i < 4); i++)
+    {
+        AMQP_VALUE item;
+
+        if (depth > 0)
+        {
+            item = create_nested_list(depth - 1);
+        }
+        else if ((i % 2) == 0)
+        {
+            item = amqpvalue_create_int((int32_t)i);
+        }
+        else
+        {
+            item = amqpvalue_create_string("list item");
+        }
+
+        if ((item == NULL) ||
+            (amqpvalue_set_list_item(result, i, item) != 0))
+        {
+            amqpvalue_destroy(result);
+            result = NULL;
+        }
+
+        if (item != NULL)
+        {
+            amqpvalue_destroy(item);
+        }
+    }
+
+    return result;
+}
+
+static AMQP_VALUE create_nested_list_depth_4(void)
+{
+    return create_nested_list(4);
+}
+
+static const BENCHMARK_VALUE benchmark_values[] =
+{
+    { "transfer", create_transfer, parse_transfer },
+    { "flow", create_flow, parse_flow },
+    { "disposition", create_disposition, parse_disposition },
+    { "transfer_fields", create_transfer, parse_transfer_fields },
+    { "flow_fields", create_flow, parse_flow_fields },
+    { "disposition_fields", create_disposition, parse_disposition_fields },
+    { "annotations_4", create_annotations_4, NULL },
+    { "annotations_16", create_annotations_16, NULL },
+    { "annotations_64", create_annotations_64, NULL },
+    { "binary_64k", create_binary_64k, NULL },
+    { "binary_1m", create_binary_1m, NULL },
+    { "nested_list_4", create_nested_list_depth_4, NULL }
+};
+
+/* operations */
+
+static void on_value_decoded(void* context, AMQP_VALUE decoded_value)
+{
+    BENCHMARK_CONTEXT* benchmark_context = (BENCHMARK_CONTEXT*)context;
+
+    benchmark_context->decoded_count++;
+
+    /* performatives are also turned into their generated handles, as the connection and session do */
+    if ((benchmark_context->benchmark_value->parse_value != NULL) &&
+        (benchmark_context->benchmark_value->parse_value(decoded_value) != 0))
+    {
+        benchmark_context->is_error = true;
+    }
+}
+
+static int create_operation(BENCHMARK_CONTEXT* context)
+{
+    int result;
+    AMQP_VALUE value = context->benchmark_value->create_value();
+
+    if (value == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        amqpvalue_destroy(value);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int encode_operation(BENCHMARK_CONTEXT* context)
+{
+    size_t encoded_size;
+    return amqpvalue_encode_to_buffer(context->value, context->encoded_bytes, context->encoded_size, &encoded_size);
+}
+
+static void on_frame_bytes_encoded(void* context, const unsigned char* bytes, size_t length, bool encode_complete)
+{
+    (void)context;
+    (void)bytes;
+    (void)length;
+    (void)encode_complete;
+}
+
+static int frame_operation(BENCHMARK_CONTEXT* context)
+{
+    return amqp_frame_codec_encode_frame(context->amqp_frame_codec, 0, context->value, NULL, 0, on_frame_bytes_encoded, context);
+}
+
+static int decode_operation(BENCHMARK_CONTEXT* context)
+{
+    int result;
+    size_t decoded_count = context->decoded_count;
+
+    if (context->arena != NULL)
+    {
+        amqpvalue_arena_reset(context->arena);
+    }
+
+    if ((amqpvalue_decode_bytes(context->decoder, context->encoded_bytes, context->encoded_size) != 0) ||
+        (context->decoded_count != decoded_count + 1) ||
+        (context->is_error))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int run_operation(BENCHMARK_CONTEXT* context, const char* operation_name, BENCHMARK_OPERATION operation)
+{
+    int result = 0;
+    uint64_t iteration_count = 1;
+    uint64_t elapsed_ns = 0;
+    size_t allocation_count = 0;
+    PERF_COUNTER_VALUES start_counter_values;
+    PERF_COUNTER_VALUES counter_values;
+    uint64_t i;
+
+    (void)memset(&start_counter_values, 0, sizeof(start_counter_values));
+    (void)memset(&counter_values, 0, sizeof(counter_values));
+
+    /* warm up caches and lazily allocated state before measuring */
+    if (operation(context) != 0)
+    {
+        result = __LINE__;
+    }
+
+    while ((result == 0) && (elapsed_ns < min_run_time_ns))
+    {
+        uint64_t start_ns;
+        size_t start_allocation_count;
+
+        if (elapsed_ns > 0)
+        {
+            /* aim for the minimum run time directly rather than doubling many times */
+            uint64_t estimated_count = (min_run_time_ns * iteration_count) / elapsed_ns;
+            iteration_count = (estimated_count > iteration_count * 100) ? iteration_count * 100 : estimated_count + 1;
+        }
+
+        start_allocation_count = get_allocation_count();
+        if (perf_counters != NULL)
+        {
+            (void)perf_counters_read(perf_counters, &start_counter_values);
+        }
+
+        start_ns = get_time_ns();
+
+        for (i = 0; i < iteration_count; i++)
+        {
+            if (operation(context) != 0)
+            {
+                result = __LINE__;
+                break;
+            }
+        }
+
+        elapsed_ns = get_time_ns() - start_ns;
+        if ((perf_counters != NULL) &&
+            (perf_counters_read(perf_counters, &counter_values) == 0))
+        {
+            perf_counters_subtract(&counter_values, &start_counter_values);
+        }
+
+        allocation_count = get_allocation_count() - start_allocation_count;
+        if (elapsed_ns == 0)
+        {
+            elapsed_ns = 1;
+        }
+    }
+
+    if (result != 0)
+    {
+        (void)printf("%-16s %-16s failed\n", context->benchmark_value->name, operation_name);
+    }
+    else if (has_allocation_count)
+    {
+        (void)printf("%-16s %-16s %12.1f ns/op %10.2f allocs/op %10u bytes\n",
+            context->benchmark_value->name, operation_name,
+            (double)elapsed_ns / (double)iteration_count,
+            (double)allocation_count / (double)iteration_count,
+            (unsigned int)context->encoded_size);
+    }
+    else
+    {
+        (void)printf("%-16s %-16s %12.1f ns/op %10s allocs/op %10u bytes\n",
+            context->benchmark_value->name, operation_name,
+            (double)elapsed_ns / (double)iteration_count,
+            "-",
+            (unsigned int)context->encoded_size);
+    }
+
+    if ((result == 0) &&
+        (perf_counters != NULL))
+    {
+        perf_counters_print_values(perf_counters, "  per op", &counter_values, iteration_count);
+    }
+
+    return result;
+}
+
+static void on_frame_codec_error(void* context)
+{
+    (void)context;
+}
+
+static void on_amqp_frame_received(void* context, uint16_t channel, AMQP_VALUE performative, uint64_t performative_code, const unsigned char* payload_bytes, uint32_t frame_payload_size)
+{
+    (void)context;
+    (void)channel;
+    (void)performative;
+    (void)performative_code;
+    (void)payload_bytes;
+    (void)frame_payload_size;
+}
+
+static void on_amqp_empty_frame_received(void* context, uint16_t channel)
+{
+    (void)context;
+    (void)channel;
+}
+
+/* the performative encoded into a whole AMQP frame, as the session sends it */
+static int run_frame_operation(BENCHMARK_CONTEXT* context)
+{
+    int result;
+
+    context->frame_codec = frame_codec_create(on_frame_codec_error, context);
+    context->amqp_frame_codec = (context->frame_codec == NULL) ? NULL : amqp_frame_codec_create(context->frame_codec, on_amqp_frame_received, on_amqp_empty_frame_received, on_frame_codec_error, context);
+    if (context->amqp_frame_codec == NULL)
+    {
+        LogError("Cannot create frame codec");
+        result = __LINE__;
+    }
+    else
+    {
+        result = run_operation(context, "frame", frame_operation);
+        amqp_frame_codec_destroy(context->amqp_frame_codec);
+        context->amqp_frame_codec = NULL;
+    }
+
+    if (context->frame_codec != NULL)
+    {
+        frame_codec_destroy(context->frame_codec);
+        context->frame_codec = NULL;
+    }
+
+    return result;
+}
+
+static int run_decode_operation(BENCHMARK_CONTEXT* context, const char* operation_name, bool borrow, bool use_arena)
+{
+    int result;
+
+    context->decoded_count = 0;
+    context->is_error = false;
+    context->arena = use_arena ? amqpvalue_arena_create(ARENA_BLOCK_SIZE) : NULL;
+    context->decoder = amqpvalue_decoder_create(on_value_decoded, context);
+    if ((context->decoder == NULL) ||
+        (use_arena && (context->arena == NULL)))
+    {
+        LogError("Cannot create decoder");
+        result = __LINE__;
+    }
+    else if ((borrow && ((amqpvalue_decoder_set_borrow_binaries(context->decoder, true) != 0) || (amqpvalue_decoder_set_lazy_lists(context->decoder, true) != 0))) ||
+        (use_arena && (amqpvalue_decoder_set_arena(context->decoder, context->arena) != 0)))
+    {
+        LogError("Cannot set decoder options");
+        result = __LINE__;
+    }
+    else
+    {
+        result = run_operation(context, operation_name, decode_operation);
+    }
+
+    if (context->decoder != NULL)
+    {
+        amqpvalue_decoder_destroy(context->decoder);
+        context->decoder = NULL;
+    }
+
+    if (context->arena != NULL)
+    {
+        amqpvalue_arena_destroy(context->arena);
+        context->arena = NULL;
+    }
+
+    return result;
+}
+
+static int run_benchmark_value(const BENCHMARK_VALUE* benchmark_value)
+{
+    int result;
+    BENCHMARK_CONTEXT context;
+
+    (void)memset(&context, 0, sizeof(context));
+    context.benchmark_value = benchmark_value;
+    context.value = benchmark_value->create_value();
+    if (context.value == NULL)
+    {
+        LogError("Cannot create value %s", benchmark_value->name);
+        result = __LINE__;
+    }
+    else
+    {
+        if (amqpvalue_get_encoded_size(context.value, &context.encoded_size) != 0)
+        {
+            LogError("Cannot get encoded size for %s", benchmark_value->name);
+            result = __LINE__;
+        }
+        else if ((context.encoded_bytes = (unsigned char*)malloc(context.encoded_size)) == NULL)
+        {
+            LogError("Cannot allocate encode buffer");
+            result = __LINE__;
+        }
+        else
+        {
+            if ((run_operation(&context, "create", create_operation) != 0) ||
+                (run_operation(&context, "encode", encode_operation) != 0) ||
+                /* only the values with a parse function are performatives */
+                ((benchmark_value->parse_value != NULL) && (run_frame_operation(&context) != 0)) ||
+                (run_decode_operation(&context, "decode", false, false) != 0) ||
+                (run_decode_operation(&context, "decode_lazy", true, false) != 0) ||
+                (run_decode_operation(&context, "decode_arena", false, true) != 0))
+            {
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            free(context.encoded_bytes);
+        }
+
+        amqpvalue_destroy(context.value);
+    }
+
+    return result;
+}
+
+static int parse_arguments(int argc, char** argv)
+{
+    int result = 0;
+    int i;
+
+    for (i = 1; (result == 0) && (i < argc); i += 2)
+    {
+        if (i + 1 >= argc)
+        {
+            result = __LINE__;
+        }
+        else if (strcmp(argv[i], "--min-time") == 0)
+        {
+            min_run_time_ns = (uint64_t)strtoul(argv[i + 1], NULL, 10) * 1000 * 1000;
+        }
+        else if (strcmp(argv[i], "--filter") == 0)
+        {
+            name_filter = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--counters") == 0)
+        {
+            if (strcmp(argv[i + 1], "on") == 0)
+            {
+                is_counters_requested = true;
+            }
+            else if (strcmp(argv[i + 1], "off") != 0)
+            {
+                result = __LINE__;
+            }
+        }
+        else
+        {
+            result = __LINE__;
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (parse_arguments(argc, argv) != 0)
+    {
+        (void)printf("Usage: %s [--min-time <ms per operation, default 500>] [--filter <value name substring>] [--counters <on|off, hardware counters per operation, default off>]\n", argv[0]);
+        result = -1;
+    }
+    else if (gballoc_init() != 0)
+    {
+        LogError("gballoc_init failed");
+        result = -1;
+    }
+    else
+    {
+        size_t i;
+
+#ifdef GB_MEASURE_MEMORY_FOR_THIS
+        has_allocation_count = true;
+#else
+        has_allocation_count = alloc_counters_are_enabled();
+#endif
+        result = 0;
+
+        if (is_counters_requested)
+        {
+            perf_counters = perf_counters_create();
+            if (perf_counters == NULL)
+            {
+                (void)printf("hardware counters are not available\n");
+            }
+            else
+            {
+                perf_counters_print_header(perf_counters, "counters");
+            }
+        }
+
+        for (i = 0; i < sizeof(benchmark_values) / sizeof(benchmark_values[0]); i++)
+        {
+            if ((name_filter == NULL) ||
+                (strstr(benchmark_values[i].name, name_filter) != NULL))
+            {
+                if (run_benchmark_value(&benchmark_values[i]) != 0)
+                {
+                    result = -1;
+                }
+            }
+        }
+
+        perf_counters_destroy(perf_counters);
+        gballoc_deinit();
+    }
+
+    return result;
+}
@@ -2319,162 +2319,169 @@ namespace amqplib_generator
             #line default
             #line hidden
             this.Write("_amqp_value == NULL)\r\n        {\r\n            result = __FAILURE__;\r\n        }\r\n  " +
-                    "      else\r\n        {\r\n            if (amqpvalue_set_composite_item(");
+                    "      else\r\n        {\r\n            if ((amqpvalue_make_writable(&");
             
             #line 526 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name));
             
+            #line default
+            #line hidden
+            this.Write("_instance->composite_value) != 0) ||\r\n                (amqpvalue_set_composite_item(");
+            
+            #line 527 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            this.Write(this.ToStringHelper.ToStringWithCulture(type_name));
+            
             #line default
             #line hidden
             this.Write("_instance->composite_value, ");
             
-            #line 526 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 527 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(j));
             
             #line default
             #line hidden
             this.Write(", ");
             
-            #line 526 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 527 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(field_name));
             
             #line default
             #line hidden
-            this.Write("_amqp_value) != 0)\r\n            {\r\n                result = __FAILURE__;\r\n       " +
+            this.Write("_amqp_value) != 0))\r\n            {\r\n                result = __FAILURE__;\r\n       " +
                     "     }\r\n            else\r\n            {\r\n                result = 0;\r\n          " +
                     "  }\r\n\r\n            amqpvalue_destroy(");
             
-            #line 535 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 536 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(field_name));
             
             #line default
             #line hidden
             this.Write("_amqp_value);\r\n        }\r\n    }\r\n\r\n    return result;\r\n}\r\n\r\n");
             
-            #line 542 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 543 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   j++; 
             
             #line default
             #line hidden
             
-            #line 543 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 544 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               } 
             
             #line default
             #line hidden
             this.Write("\r\n");
             
-            #line 545 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 546 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
           } 
             
             #line default
             #line hidden
             
-            #line 546 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 547 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
           else if (type.@class == typeClass.restricted) 
             
             #line default
             #line hidden
             
-            #line 547 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 548 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
           { 
             
             #line default
             #line hidden
             
-            #line 548 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 549 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               string c_type = Program.GetCType(type.source, false).Replace('-', '_').Replace(':', '_'); 
             
             #line default
             #line hidden
             
-            #line 549 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 550 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               bool hasDescriptor = (type.Items != null) && (type.Items.Where(item => item is descriptor).Count() > 0); 
             
             #line default
             #line hidden
             this.Write("/* ");
             
-            #line 550 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 551 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type.name));
             
             #line default
             #line hidden
             this.Write(" */\r\n\r\n");
             
-            #line 552 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 553 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               if (c_type != "AMQP_VALUE") 
             
             #line default
             #line hidden
             
-            #line 553 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 554 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               { 
             
             #line default
             #line hidden
             
-            #line 554 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 555 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   if (!hasDescriptor) 
             
             #line default
             #line hidden
             
-            #line 555 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 556 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   { 
             
             #line default
             #line hidden
             this.Write("AMQP_VALUE amqpvalue_create_");
             
-            #line 556 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 557 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
             #line hidden
             this.Write("(");
             
-            #line 556 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 557 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
             #line hidden
             this.Write(" value)\r\n{\r\n    return amqpvalue_create_");
             
-            #line 558 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 559 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type.source.ToLower().Replace('-', '_').Replace(':', '_')));
             
             #line default
             #line hidden
             this.Write("(value);\r\n}\r\n");
             
-            #line 560 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 561 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   } 
             
             #line default
             #line hidden
             
-            #line 561 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 562 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   else 
             
             #line default
             #line hidden
             
-            #line 562 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 563 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   { 
             
             #line default
             #line hidden
             this.Write("AMQP_VALUE amqpvalue_create_");
             
-            #line 563 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 564 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
             #line hidden
             this.Write("(");
             
-            #line 563 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 564 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
@@ -2482,7 +2489,7 @@ namespace amqplib_generator
             this.Write(" value)\r\n{\r\n    AMQP_VALUE result;\r\n    AMQP_VALUE described_value = amqpvalue_cr" +
                     "eate_");
             
-            #line 566 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 567 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type.source.ToLower().Replace('-', '_').Replace(':', '_')));
             
             #line default
@@ -2490,7 +2497,7 @@ namespace amqplib_generator
             this.Write("(value);\r\n    if (described_value == NULL)\r\n    {\r\n        result = NULL;\r\n    }\r" +
                     "\n    else\r\n    {\r\n        AMQP_VALUE descriptor = amqpvalue_create_ulong(");
             
-            #line 573 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 574 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(Program.GetDescriptorCode(Program.GetDescriptor(type))));
             
             #line default
@@ -2515,7 +2522,7 @@ namespace amqplib_generator
 
 bool is_");
             
-            #line 591 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 592 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
@@ -2524,7 +2531,7 @@ bool is_");
                     "escriptor_ulong;\r\n    if ((amqpvalue_get_ulong(descriptor, &descriptor_ulong) ==" +
                     " 0) &&\r\n        (descriptor_ulong == ");
             
-            #line 597 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 598 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(Program.GetDescriptorCode(Program.GetDescriptor(type)).ToString()));
             
             #line default
@@ -2532,70 +2539,70 @@ bool is_");
             this.Write("))\r\n    {\r\n        result = true;\r\n    }\r\n    else\r\n    {\r\n        result = false" +
                     ";\r\n    }\r\n\r\n    return result;\r\n}\r\n");
             
-            #line 608 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 609 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   } 
             
             #line default
             #line hidden
             
-            #line 609 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 610 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               } 
             
             #line default
             #line hidden
             
-            #line 610 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 611 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               else 
             
             #line default
             #line hidden
             
-            #line 611 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 612 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               { 
             
             #line default
             #line hidden
             
-            #line 612 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 613 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   if (!hasDescriptor) 
             
             #line default
             #line hidden
             
-            #line 613 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 614 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   { 
             
             #line default
             #line hidden
             this.Write("AMQP_VALUE amqpvalue_create_");
             
-            #line 614 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 615 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
             #line hidden
             this.Write("(AMQP_VALUE value)\r\n{\r\n    return amqpvalue_clone(value);\r\n}\r\n");
             
-            #line 618 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 619 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   } 
             
             #line default
             #line hidden
             
-            #line 619 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 620 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   else 
             
             #line default
             #line hidden
             
-            #line 620 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 621 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   { 
             
             #line default
             #line hidden
             this.Write("AMQP_VALUE amqpvalue_create_");
             
-            #line 621 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 622 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
@@ -2605,7 +2612,7 @@ bool is_");
                     "= NULL;\r\n    }\r\n    else\r\n    {\r\n        AMQP_VALUE descriptor = amqpvalue_creat" +
                     "e_ulong(");
             
-            #line 631 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 632 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(Program.GetDescriptorCode(Program.GetDescriptor(type))));
             
             #line default
@@ -2630,7 +2637,7 @@ bool is_");
 
 bool is_");
             
-            #line 649 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 650 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(type_name.ToLower()));
             
             #line default
@@ -2639,7 +2646,7 @@ bool is_");
                     "escriptor_ulong;\r\n    if ((amqpvalue_get_ulong(descriptor, &descriptor_ulong) ==" +
                     " 0) &&\r\n        (descriptor_ulong == ");
             
-            #line 655 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 656 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
             this.Write(this.ToStringHelper.ToStringWithCulture(Program.GetDescriptorCode(Program.GetDescriptor(type)).ToString()));
             
             #line default
@@ -2647,32 +2654,32 @@ bool is_");
             this.Write("))\r\n    {\r\n        result = true;\r\n    }\r\n    else\r\n    {\r\n        result = false" +
                     ";\r\n    }\r\n\r\n    return result;\r\n}\r\n");
             
-            #line 666 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 667 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
                   } 
             
             #line default
             #line hidden
             
-            #line 667 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 668 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
               } 
             
             #line default
             #line hidden
             this.Write("\r\n");
             
-            #line 669 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 670 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
           } 
             
             #line default
             #line hidden
             
-            #line 670 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 671 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
       } 
             
             #line default
             #line hidden
             
-            #line 671 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
+            #line 672 "G:\repos\azure-uamqp-c\uamqp_generator\amqp_definitions_c.tt"
   } 
             
             #line default